@@ -18,6 +18,7 @@ final class AppDependencies: ObservableObject {
     let openAIAgentService: any AIAgentServicing
     let llmAPIKeyStore: KeychainLLMAPIKeyStore
     let llmProviderRegistry: LLMProviderRegistry
+    let launchScheduler = LaunchScheduler()
 
     static var isScreenshotMode: Bool {
         ProcessInfo.processInfo.arguments.contains("--screenshot-mode")
@@ -41,6 +42,22 @@ final class AppDependencies: ObservableObject {
 
         self.navigationCoordinator = AppNavigationCoordinator()
 
+        // Compile terminal pipelines off the main thread before the first pane needs them.
+        if !runningTests {
+            TerminalPipelineCache.shared.warmDefaultDevice()
+        }
+
+        TraceRecorder.shared.setEnabled(TraceRecorder.isEnabledByDefaults)
+        if !runningTests, TraceRecorder.isEnabledByDefaults {
+            HitchDetector.shared.start()
+        }
+
+        #if DEBUG
+        if UserDefaults.standard.bool(forKey: AllocationTracker.enabledDefaultsKey) {
+            AllocationTracker.enable()
+        }
+        #endif
+
         let auditLogManager = AuditLogManager(store: FileAuditLogStore())
         self.auditLogManager = auditLogManager
 
@@ -52,7 +69,8 @@ final class AppDependencies: ObservableObject {
         let portForwardingManager = PortForwardingManager(transport: transport, auditLogManager: auditLogManager)
         self.portForwardingManager = portForwardingManager
 
-        let biometricPasswordStore = BiometricPasswordStore()
+        let biometricGate = BiometricAuthenticationGate()
+        let biometricPasswordStore = BiometricPasswordStore(authenticationGate: biometricGate)
         let totpStore = TOTPStore(store: biometricPasswordStore)
 
         let sessionManager = SessionManager(
@@ -60,7 +78,9 @@ final class AppDependencies: ObservableObject {
             knownHostsStore: FileKnownHostsStore(),
             auditLogManager: auditLogManager,
             portForwardingManager: portForwardingManager,
-            totpStore: totpStore
+            totpStore: totpStore,
+            commandHistoryStore: runningTests || screenshotMode ? nil : CommandHistoryStore.makeDefault(),
+            workspaceSnapshotStore: runningTests || screenshotMode ? nil : WorkspaceSnapshotStore.makeDefault()
         )
         self.sessionManager = sessionManager
 
@@ -75,12 +95,23 @@ final class AppDependencies: ObservableObject {
                 sessionManager: sessionManager,
                 auditLogManager: auditLogManager,
                 searchIndexer: HostSpotlightIndexer(),
+                hostListCache: runningTests ? nil : HostListCache.makeDefault(),
                 biometricPasswordStore: biometricPasswordStore,
-                biometricPassphraseStore: BiometricPasswordStore(service: "nl.budgetsoft.ProSSHV2.key-passphrases"),
+                biometricPassphraseStore: BiometricPasswordStore(service: "nl.budgetsoft.ProSSHV2.key-passphrases", authenticationGate: biometricGate),
                 totpStore: totpStore
             )
         }
 
+        let hostListViewModel = self.hostListViewModel
+        sessionManager.workspaceCoordinator.resolveHost = { [weak hostListViewModel] hostID in
+            await hostListViewModel?.loadHostsIfNeeded()
+            return hostListViewModel?.host(withID: hostID)
+        }
+        sessionManager.prewarmCoordinator.resolveHost = { [weak hostListViewModel] hostID in
+            await hostListViewModel?.loadHostsIfNeeded()
+            return hostListViewModel?.host(withID: hostID)
+        }
+
         let transferManager = TransferManager()
         transferManager.configure(sessionManager: sessionManager)
         self.transferManager = transferManager
@@ -112,12 +143,20 @@ final class AppDependencies: ObservableObject {
         self.llmAPIKeyStore = llmAPIKeyStore
         let llmAPIKeyProvider = DefaultLLMAPIKeyProvider(store: llmAPIKeyStore)
 
-        let openAIResponsesService = OpenAIResponsesService(apiKeyProvider: llmAPIKeyProvider)
+        let openAISession = LLMProviderSession(
+            providerID: .openai,
+            endpoint: URL(string: "https://api.openai.com/v1/responses")!
+        )
+        let openAIResponsesService = OpenAIResponsesService(
+            apiKeyProvider: llmAPIKeyProvider,
+            session: openAISession.session
+        )
         self.openAIResponsesService = openAIResponsesService
 
         // Provider registry
         let llmProviderRegistry = LLMProviderRegistry()
         self.llmProviderRegistry = llmProviderRegistry
+        llmProviderRegistry.registerSession(openAISession)
 
         // Register Mistral provider
         let mistralProvider = MistralProvider(apiKeyProvider: llmAPIKeyProvider)
@@ -161,6 +200,8 @@ final class AppDependencies: ObservableObject {
             return
         }
 
+        scheduleLaunchWork(restoresWorkspace: !screenshotMode)
+
         if screenshotMode {
             Task { @MainActor [weak self] in
                 try? await Task.sleep(for: .milliseconds(300))
@@ -171,6 +212,47 @@ final class AppDependencies: ObservableObject {
         }
     }
 
+    /// Queue launch loads by the tier that first needs them (see
+    /// LaunchScheduler) and start running them.
+    private func scheduleLaunchWork(restoresWorkspace: Bool) {
+        let hostListViewModel = hostListViewModel
+        let keyForgeViewModel = keyForgeViewModel
+        let certificatesViewModel = certificatesViewModel
+        let sessionManager = sessionManager
+
+        launchScheduler.schedule(.firstFrame, "hosts") {
+            await hostListViewModel.loadHostsIfNeeded()
+        }
+
+        launchScheduler.schedule(.firstConnection, "keys") {
+            await keyForgeViewModel.loadKeysIfNeeded()
+        }
+        launchScheduler.schedule(.firstConnection, "knownHosts") {
+            await sessionManager.preloadKnownHosts()
+        }
+        if restoresWorkspace {
+            launchScheduler.schedule(.firstConnection, "workspace") {
+                await sessionManager.workspaceCoordinator.restoreIfNeeded()
+                await sessionManager.prewarmCoordinator.prewarmRestoredTabs()
+            }
+        }
+
+        launchScheduler.schedule(.background, "spotlight") {
+            await hostListViewModel.reindexForSearchIfNeeded()
+        }
+        launchScheduler.schedule(.background, "knownHostsList") {
+            await sessionManager.refreshKnownHosts()
+        }
+        launchScheduler.schedule(.background, "certificates") {
+            await certificatesViewModel.loadAuthoritiesIfNeeded()
+        }
+
+        let launchScheduler = launchScheduler
+        Task { @MainActor in
+            await launchScheduler.run()
+        }
+    }
+
     private func injectScreenshotData() async {
         await sessionManager.injectScreenshotSessions()
 
@@ -0,0 +1,54 @@
+// BenchmarkAllocationCounter.swift
+// ProSSHV2
+//
+// Counts heap allocations during a benchmark run through libmalloc's
+// `malloc_logger` hook, the one malloc stack logging uses. Every malloc,
+// calloc and realloc in the process is counted, from any thread, so runs
+// should be made on an otherwise idle app. If another logger is already
+// installed (MallocStackLogging, Instruments) counting is unavailable.
+
+import Darwin
+import Synchronization
+
+nonisolated struct BenchmarkAllocationCounter {
+
+    private typealias MallocLogger = @convention(c) (UInt32, UInt, UInt, UInt, UInt, UInt32) -> Void
+
+    /// `MALLOC_LOG_TYPE_ALLOCATE` from libmalloc.
+    private static let allocateFlag: UInt32 = 2
+
+    private static let count = Atomic<UInt64>(0)
+
+    nonisolated(unsafe) private static let loggerSlot: UnsafeMutablePointer<MallocLogger?>? = {
+        let defaultHandle = UnsafeMutableRawPointer(bitPattern: -2)  // RTLD_DEFAULT
+        return dlsym(defaultHandle, "malloc_logger")?.assumingMemoryBound(to: MallocLogger?.self)
+    }()
+
+    private static let logger: MallocLogger = { type, _, _, _, _, _ in
+        if type & BenchmarkAllocationCounter.allocateFlag != 0 {
+            BenchmarkAllocationCounter.count.add(1, ordering: .relaxed)
+        }
+    }
+
+    private let slot: UnsafeMutablePointer<MallocLogger?>
+    private let startCount: UInt64
+
+    /// Start counting, or nil when the hook is unavailable. Counting runs
+    /// until `stop()`.
+    static func start() -> BenchmarkAllocationCounter? {
+        // Touch the statics first so their lazy initialisation is not
+        // counted and never runs inside the hook.
+        _ = allocateFlag
+        let hook = logger
+        let startCount = count.load(ordering: .relaxed)
+        guard let slot = loggerSlot, slot.pointee == nil else { return nil }
+        slot.pointee = hook
+        return BenchmarkAllocationCounter(slot: slot, startCount: startCount)
+    }
+
+    /// Remove the hook and return the allocations counted since `start()`.
+    func stop() -> UInt64 {
+        slot.pointee = nil
+        return Self.count.load(ordering: .relaxed) &- startCount
+    }
+}
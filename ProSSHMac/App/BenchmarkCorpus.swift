@@ -0,0 +1,363 @@
+// BenchmarkCorpus.swift
+// ProSSHV2
+//
+// VT byte streams for the throughput benchmark. The built-in workloads are
+// deterministic stand-ins for traffic we see in practice: full-screen
+// monitor redraws, `ls --color`, compiler diagnostics, vim scrolling in a
+// scroll region, CJK logs, emoji and truecolor gradients. Each is sized to
+// the grid it runs on. Recorded sessions can be added from a directory:
+// SessionRecorder `.psshrec` files, asciinema `.cast` files, or raw byte
+// captures (any other extension).
+
+import Foundation
+
+nonisolated struct BenchmarkWorkload: Sendable {
+    let name: String
+    let payload: Data
+}
+
+nonisolated enum BenchmarkCorpus {
+
+    /// Names of the built-in workloads, in run order.
+    static let builtInNames = [
+        "base64", "htop", "ls-color", "compiler", "vim-scroll", "cjk-log", "emoji", "truecolor",
+    ]
+
+    /// A built-in workload of about `targetBytes` for a `columns` x `rows`
+    /// grid, or nil for an unknown name.
+    static func builtIn(_ name: String, columns: Int, rows: Int, targetBytes: Int) -> BenchmarkWorkload? {
+        var stream = VTStream(targetBytes: targetBytes)
+        switch name {
+        case "base64":
+            stream.base64(lineLength: 76)
+        case "htop":
+            stream.monitorRedraws(columns: columns, rows: rows)
+        case "ls-color":
+            stream.colorListing(columns: columns)
+        case "compiler":
+            stream.compilerDiagnostics()
+        case "vim-scroll":
+            stream.editorScroll(columns: columns, rows: rows)
+        case "cjk-log":
+            stream.cjkLog()
+        case "emoji":
+            stream.emoji(columns: columns)
+        case "truecolor":
+            stream.truecolorGradient(columns: columns, rows: rows)
+        default:
+            return nil
+        }
+        return BenchmarkWorkload(name: name, payload: stream.bytes)
+    }
+
+    /// The original `--benchmark-base64` payload.
+    static func base64Payload(targetBytes: Int, lineLength: Int) -> Data {
+        var stream = VTStream(targetBytes: targetBytes)
+        stream.base64(lineLength: lineLength)
+        return stream.bytes
+    }
+
+    /// Output streams of the recordings in `directory`, sorted by file name.
+    /// Unreadable files are reported through `warn` and skipped.
+    @MainActor
+    static func recorded(in directory: URL, warn: (String) -> Void) -> [BenchmarkWorkload] {
+        let files = (try? FileManager.default.contentsOfDirectory(
+            at: directory,
+            includingPropertiesForKeys: [.isRegularFileKey],
+            options: [.skipsHiddenFiles]
+        )) ?? []
+
+        var workloads: [BenchmarkWorkload] = []
+        for file in files.sorted(by: { $0.lastPathComponent < $1.lastPathComponent }) {
+            do {
+                let payload: Data
+                switch file.pathExtension.lowercased() {
+                case "psshrec":
+                    let recording = try SessionRecorder().loadRecording(from: file)
+                    payload = recording.chunks
+                        .filter { $0.stream == .output }
+                        .reduce(into: Data()) { $0.append($1.payload) }
+                case "cast":
+                    payload = try castOutput(Data(contentsOf: file))
+                default:
+                    payload = try Data(contentsOf: file)
+                }
+                guard !payload.isEmpty else {
+                    warn("\(file.lastPathComponent): no output bytes")
+                    continue
+                }
+                workloads.append(BenchmarkWorkload(
+                    name: "rec:" + file.deletingPathExtension().lastPathComponent,
+                    payload: payload
+                ))
+            } catch {
+                warn("\(file.lastPathComponent): \(error.localizedDescription)")
+            }
+        }
+        return workloads
+    }
+
+    /// Output events of an asciinema v2 file: a header line, then
+    /// `[time, "o", "data"]` lines.
+    static func castOutput(_ file: Data) throws -> Data {
+        var output = Data()
+        for line in file.split(separator: 0x0A).dropFirst() {
+            guard let event = try JSONSerialization.jsonObject(with: Data(line)) as? [Any],
+                  event.count >= 3,
+                  event[1] as? String == "o",
+                  let text = event[2] as? String else { continue }
+            output.append(contentsOf: text.utf8)
+        }
+        return output
+    }
+}
+
+// MARK: - Generators
+
+/// Appends generated traffic until the target size is reached. A small
+/// LCG keeps every run byte-identical.
+private nonisolated struct VTStream {
+    private(set) var bytes = Data()
+    private let targetBytes: Int
+    private var seed: UInt64 = 0x1234_5678_9ABC_DEF0
+
+    init(targetBytes: Int) {
+        self.targetBytes = max(targetBytes, 1)
+        bytes.reserveCapacity(self.targetBytes + 4096)
+    }
+
+    private var isFull: Bool { bytes.count >= targetBytes }
+
+    private mutating func random(_ bound: Int) -> Int {
+        seed = seed &* 6364136223846793005 &+ 1442695040888963407
+        return Int((seed >> 33) % UInt64(max(bound, 1)))
+    }
+
+    private mutating func write(_ text: String) {
+        bytes.append(contentsOf: text.utf8)
+    }
+
+    private mutating func csi(_ body: String) {
+        write("\u{1B}[" + body)
+    }
+
+    private mutating func pick<T>(_ values: [T]) -> T {
+        values[random(values.count)]
+    }
+
+    /// The original synthetic payload: base64-like lines.
+    mutating func base64(lineLength: Int) {
+        let alphabet = Array("ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/".utf8)
+        while !isFull {
+            for _ in 0..<lineLength {
+                bytes.append(alphabet[random(alphabet.count)])
+            }
+            bytes.append(contentsOf: [0x0D, 0x0A])
+        }
+    }
+
+    /// htop/btop style: meters and a process table repainted in place with
+    /// absolute positioning, SGR colours and erase-to-end-of-line.
+    mutating func monitorRedraws(columns: Int, rows: Int) {
+        let commands = ["postgres: writer", "node server.js", "kworker/3:1", "swift-frontend", "nginx: worker", "redis-server"]
+        let users = ["root", "www", "postgres", "deploy"]
+        let meterWidth = max(columns / 2 - 12, 4)
+        csi("?1049h")
+        csi("?25l")
+        while !isFull {
+            csi("H")
+            for cpu in 0..<min(4, rows) {
+                let load = random(101)
+                let filled = meterWidth * load / 100
+                csi("\(cpu + 1);1H")
+                write("  \(cpu)")
+                csi("1;34m")
+                write("[")
+                csi("32m")
+                write(String(repeating: "|", count: filled * 2 / 3))
+                csi("31m")
+                write(String(repeating: "|", count: filled - filled * 2 / 3))
+                csi("0m")
+                write(String(repeating: " ", count: meterWidth - filled))
+                write(String(format: "%5.1f%%", Double(load)))
+                csi("1;34m")
+                write("]")
+                csi("0m")
+                csi("K")
+            }
+            let header = min(5, rows)
+            if header < rows {
+                csi("\(header + 1);1H")
+                csi("30;42m")
+                write("  PID USER      PRI  NI  VIRT   RES  S CPU% MEM%   TIME+  Command".padding(toLength: columns, withPad: " ", startingAt: 0))
+                csi("0m")
+            }
+            for row in (header + 2)...max(header + 2, rows) where row <= rows {
+                csi("\(row);1H")
+                let cpu = random(1000)
+                write(String(format: "%5d ", 100 + random(60000)))
+                write(pick(users).padding(toLength: 9, withPad: " ", startingAt: 0))
+                write(String(format: " 20   0 %5dM %5dM ", random(4000), random(900)))
+                csi(cpu > 500 ? "1;32m" : "0m")
+                write("R")
+                csi("0m")
+                write(String(format: " %4.1f %4.1f %2d:%02d.%02d ", Double(cpu) / 10, Double(random(200)) / 10, random(60), random(60), random(100)))
+                csi(row % 3 == 0 ? "1;36m" : "0m")
+                write(pick(commands))
+                csi("0m")
+                csi("K")
+            }
+        }
+        csi("?25h")
+        csi("?1049l")
+    }
+
+    /// `ls --color` across a large directory, packed into columns.
+    mutating func colorListing(columns: Int) {
+        let kinds: [(sgr: String, suffix: String)] = [
+            ("01;34", ""), ("01;32", ".sh"), ("00", ".txt"), ("01;31", ".tar.gz"),
+            ("01;35", ".png"), ("01;36", ""), ("00", ".swift"), ("40;33;01", ""),
+        ]
+        let words = ["build", "cache", "module", "report", "asset", "fixture", "snapshot", "vendor", "index", "migration"]
+        let width = 24
+        let perLine = max(columns / width, 1)
+        while !isFull {
+            for _ in 0..<perLine {
+                let kind = pick(kinds)
+                let name = "\(pick(words))_\(random(100_000))\(kind.suffix)"
+                write("\u{1B}[\(kind.sgr)m\(name)\u{1B}[0m")
+                write(String(repeating: " ", count: max(width - name.count, 1)))
+            }
+            write("\r\n")
+        }
+    }
+
+    /// clang/swiftc diagnostics: bold locations, coloured severities,
+    /// source excerpts and caret lines.
+    mutating func compilerDiagnostics() {
+        let files = ["Sources/App/TerminalRenderer.swift", "src/parser/vt_state.c", "lib/net/session.cpp"]
+        let messages = [
+            ("1;31", "error", "cannot convert value of type 'Int' to expected argument type 'UInt16'"),
+            ("1;35", "warning", "variable 'offset' was never mutated; consider changing to 'let' constant"),
+            ("1;30", "note", "did you mean to use 'withUnsafeBytes'?"),
+        ]
+        while !isFull {
+            let (sgr, severity, message) = pick(messages)
+            let column = 5 + random(40)
+            write("\u{1B}[1m\(pick(files)):\(1 + random(2000)):\(column): \u{1B}[0;\(sgr)m\(severity): \u{1B}[0m\u{1B}[1m\(message)\u{1B}[0m\r\n")
+            write("        let value = buffer.withContiguousStorageIfAvailable { $0[index] } ?? 0\r\n")
+            write(String(repeating: " ", count: column + 3) + "\u{1B}[0;1;32m^~~~~~~~~~\u{1B}[0m\r\n")
+            if random(4) == 0 {
+                write("[\(random(900))/\(900)] Compiling \u{1B}[1m\(pick(files))\u{1B}[0m\r\n")
+            }
+        }
+    }
+
+    /// vim scrolling a highlighted buffer: a scroll region above a status
+    /// line, scrolling down with LF at the bottom or up with reverse index.
+    mutating func editorScroll(columns: Int, rows: Int) {
+        let textRows = max(rows - 1, 2)
+        let keywords = ["func", "let", "var", "guard", "return", "switch", "case", "struct"]
+        csi("?1049h")
+        csi("1;\(textRows)r")
+        var line = 1
+        while !isFull {
+            let up = random(5) == 0
+            csi("?25l")
+            if up {
+                csi("1;1H")
+                write("\u{1B}M")
+            } else {
+                csi("\(textRows);1H")
+                write("\n")
+            }
+            csi("33m")
+            write(String(format: "%4d ", line))
+            csi("0m")
+            write("    ")
+            csi("38;5;\(170 + random(6))m")
+            write(pick(keywords))
+            csi("0m")
+            write(" value\(random(1000)) = ")
+            csi("38;5;114m")
+            write("\"string literal \(random(10_000))\"")
+            csi("0m")
+            csi("38;5;244m")
+            write(" // comment")
+            csi("0m")
+            csi("K")
+            csi("\(rows);1H")
+            csi("7m")
+            write(" main.swift [+]  \(line),5  \(line * 100 / 5000)%".padding(toLength: columns, withPad: " ", startingAt: 0))
+            csi("0m")
+            csi("?25h")
+            line += up ? -1 : 1
+            line = min(max(line, 1), 5000)
+        }
+        csi("r")
+        csi("?1049l")
+    }
+
+    /// Application logs mixing ASCII with CJK ideographs, kana and hangul.
+    mutating func cjkLog() {
+        let ranges: [ClosedRange<UInt32>] = [0x4E00...0x9FA5, 0x3041...0x3096, 0x30A1...0x30FA, 0xAC00...0xD7A3]
+        let levels = [("32", "INFO"), ("33", "WARN"), ("31", "ERROR")]
+        while !isFull {
+            let (color, level) = pick(levels)
+            write(String(format: "2026-10-14 %02d:%02d:%02d.%03d ", random(24), random(60), random(60), random(1000)))
+            write("\u{1B}[\(color)m[\(level)]\u{1B}[0m ")
+            let range = pick(ranges)
+            var text = String.UnicodeScalarView()
+            for _ in 0..<(8 + random(30)) {
+                let value = range.lowerBound + UInt32(random(Int(range.upperBound - range.lowerBound)))
+                if let scalar = Unicode.Scalar(value) {
+                    text.append(scalar)
+                }
+            }
+            write(String(text))
+            write(" id=\(random(1_000_000))\r\n")
+        }
+    }
+
+    /// Emoji with modifiers, ZWJ sequences, flags and variation selectors.
+    mutating func emoji(columns: Int) {
+        let glyphs = [
+            "😀", "🚀", "✅", "❤️", "👍🏽", "👩‍💻", "👨‍👩‍👧‍👦", "🏳️‍🌈", "🇳🇱", "🇯🇵", "⚠️", "🔥", "🧑🏾‍🚀", "☕️",
+        ]
+        while !isFull {
+            var width = 0
+            while width + 3 < columns {
+                write(pick(glyphs))
+                if random(3) == 0 {
+                    write(" ok")
+                    width += 3
+                }
+                write(" ")
+                width += 3
+            }
+            write("\r\n")
+        }
+    }
+
+    /// Full-screen truecolor gradients: a 24-bit background per cell.
+    mutating func truecolorGradient(columns: Int, rows: Int) {
+        var frame = 0
+        while !isFull {
+            csi("H")
+            for row in 0..<rows {
+                for column in 0..<columns {
+                    let r = (column * 255 / max(columns - 1, 1) + frame) & 0xFF
+                    let g = row * 255 / max(rows - 1, 1)
+                    let b = (255 - r + frame * 3) & 0xFF
+                    csi("48;2;\(r);\(g);\(b)m")
+                    write(column % 8 == 0 ? "░" : " ")
+                }
+                csi("0m")
+                if row < rows - 1 {
+                    write("\r\n")
+                }
+            }
+            frame += 7
+        }
+    }
+}
@@ -0,0 +1,101 @@
+// LaunchScheduler.swift
+// ProSSHV2
+//
+// Launch work in three tiers, by when it is first needed:
+// - firstFrame: what the first window shows, i.e. the host list (cached
+//   copy first, then the store).
+// - firstConnection: what the first connect would otherwise wait for:
+//   keys, the decrypted known-hosts log and the workspace restore.
+// - background: everything else, such as the Spotlight reindex, the
+//   known-hosts list for Settings and certificate authorities.
+// Each tier starts once the one before it has finished. Jobs within a tier
+// start together, so their loads overlap on their stores' actors. The
+// background tier runs at utility priority.
+//
+// Every job and tier is a signpost interval in the "Launch" category, and
+// each tier's duration since launch is logged.
+
+import Foundation
+import os.log
+import os.signpost
+
+nonisolated enum LaunchTier: Int, CaseIterable, Sendable {
+    case firstFrame
+    case firstConnection
+    case background
+
+    var name: String {
+        switch self {
+        case .firstFrame: return "firstFrame"
+        case .firstConnection: return "firstConnection"
+        case .background: return "background"
+        }
+    }
+}
+
+@MainActor
+final class LaunchScheduler {
+
+    private struct Job {
+        let name: String
+        let work: @MainActor () async -> Void
+    }
+
+    private static let signpostLog = OSLog(subsystem: "com.prossh", category: "Launch")
+    private static let logger = Logger(subsystem: "com.prossh", category: "Launch")
+
+    private var jobs: [LaunchTier: [Job]] = [:]
+    private var startedAt: ContinuousClock.Instant?
+    private(set) var completedTiers: [LaunchTier] = []
+
+    /// Add `work` to `tier`. Jobs added after `start()` are ignored.
+    func schedule(_ tier: LaunchTier, _ name: String, work: @escaping @MainActor () async -> Void) {
+        guard startedAt == nil else { return }
+        jobs[tier, default: []].append(Job(name: name, work: work))
+    }
+
+    /// Run every tier in order. Returns once the background tier is done.
+    func run() async {
+        guard startedAt == nil else { return }
+        let start = ContinuousClock.now
+        startedAt = start
+        for tier in LaunchTier.allCases {
+            if tier == .background {
+                await Task(priority: .utility) { @MainActor in
+                    await self.runTier(tier)
+                }.value
+            } else {
+                await runTier(tier)
+            }
+            completedTiers.append(tier)
+            let elapsed = ContinuousClock.now - start
+            Self.logger.notice("launch_tier tier=\(tier.name, privacy: .public) ms=\(elapsed.milliseconds)")
+        }
+        jobs.removeAll()
+    }
+
+    private func runTier(_ tier: LaunchTier) async {
+        let tierID = OSSignpostID(log: Self.signpostLog)
+        os_signpost(.begin, log: Self.signpostLog, name: "LaunchTier", signpostID: tierID, "%{public}s", tier.name)
+        defer {
+            os_signpost(.end, log: Self.signpostLog, name: "LaunchTier", signpostID: tierID, "%{public}s", tier.name)
+        }
+        await withTaskGroup(of: Void.self) { group in
+            for job in jobs[tier] ?? [] {
+                group.addTask { @MainActor in
+                    let jobID = OSSignpostID(log: Self.signpostLog)
+                    os_signpost(.begin, log: Self.signpostLog, name: "LaunchJob", signpostID: jobID, "%{public}s", job.name)
+                    await job.work()
+                    os_signpost(.end, log: Self.signpostLog, name: "LaunchJob", signpostID: jobID, "%{public}s", job.name)
+                }
+            }
+        }
+    }
+}
+
+private extension Duration {
+    nonisolated var milliseconds: Int64 {
+        let (seconds, attoseconds) = components
+        return seconds * 1_000 + attoseconds / 1_000_000_000_000_000
+    }
+}
@@ -0,0 +1,553 @@
+// ThroughputBenchmarkRunner+SSH.swift
+// ProSSHV2
+//
+// `--benchmark-ssh`: end-to-end benchmark against a saved host over
+// LibSSHTransport. Each payload is measured twice:
+//
+// - transport: `cat` on an exec channel, counting bytes and parsing nothing.
+// - pipeline: the same `cat` in an interactive shell, read in place from the
+//   channel's output ring and fed to a TerminalEngine as the app does.
+//
+// Once per host it also measures the keystroke echo round trip through the
+// remote tty and SFTP upload and download throughput.
+//
+// Payloads are BenchmarkCorpus workloads uploaded once to temporary files,
+// so the server only runs `cat` and every run replays the same bytes. Unless
+// `--benchmark-no-openssh` is given, the transport and SFTP measurements are
+// repeated with /usr/bin/ssh and /usr/bin/sftp as a baseline column. OpenSSH
+// runs in batch mode, so it needs key or agent authentication.
+//
+// The host is looked up by label, then hostname, in the saved hosts, and its
+// key must already be trusted. Passwords and key passphrases are read from
+// PROSSH_BENCHMARK_PASSWORD and PROSSH_BENCHMARK_PASSPHRASE rather than argv.
+
+import Foundation
+
+extension ThroughputBenchmarkRunner {
+
+    static func runSSHIfRequested() async -> Bool {
+        let config = sshConfigurationFromArgs()
+
+        print("==> ProSSHMac SSH End-to-End Benchmark")
+        print("    host=\(config.hostQuery) bytes=\(config.bytes) runs=\(config.runs) size=\(config.columns)x\(config.rows)")
+        print("    workloads=\(config.workloads.joined(separator: ",")) echoSamples=\(config.echoSamples) sftpBytes=\(config.sftpBytes) openssh=\(config.comparesOpenSSH)")
+        print("")
+
+        if config.hostQuery.isEmpty {
+            print("  ERROR: --benchmark-host <label or hostname> is required")
+        } else {
+            do {
+                let report = try await runSSHBenchmark(config)
+                print("")
+                print("summary:")
+                for line in report.lines {
+                    print("  \(line)")
+                }
+            } catch {
+                print("  ERROR: \(error.localizedDescription)")
+            }
+        }
+        print("")
+
+        runState = .completed
+        fflush(stdout)
+        fflush(stderr)
+        exit(0)
+    }
+
+    private static func runSSHBenchmark(_ config: SSHBenchmarkConfig) async throws -> SSHBenchmarkReport {
+        let (host, jumpHostConfig) = try await resolveBenchmarkHost(config.hostQuery)
+        let transport = LibSSHTransport()
+        let sessionID = UUID()
+        let environment = ProcessInfo.processInfo.environment
+
+        let details = try await transport.connect(sessionID: sessionID, to: host, jumpHostConfig: jumpHostConfig)
+        let verification = try await FileKnownHostsStore().evaluate(
+            hostname: host.hostname,
+            port: host.port,
+            hostKeyType: details.negotiatedHostKeyType,
+            presentedFingerprint: details.negotiatedHostFingerprint
+        )
+        guard case .trusted = verification else {
+            await transport.disconnect(sessionID: sessionID)
+            throw SSHBenchmarkError.untrustedHost(host.label)
+        }
+        try await transport.authenticate(
+            sessionID: sessionID,
+            to: host,
+            passwordOverride: environment["PROSSH_BENCHMARK_PASSWORD"],
+            keyPassphraseOverride: environment["PROSSH_BENCHMARK_PASSPHRASE"]
+        )
+        print("    connected: \(host.username)@\(host.hostname):\(host.port) kex=\(details.negotiatedKEX) cipher=\(details.negotiatedCipher)")
+        print("")
+
+        let prefix = "/tmp/prossh-bench-\(sessionID.uuidString.prefix(8).lowercased())"
+        let scratch = FileManager.default.temporaryDirectory
+            .appendingPathComponent("prossh-bench-\(sessionID.uuidString)", isDirectory: true)
+        try FileManager.default.createDirectory(at: scratch, withIntermediateDirectories: true)
+
+        var report = SSHBenchmarkReport()
+        do {
+            let openSSH = config.comparesOpenSSH ? OpenSSHBaseline(host: host, jumpHost: jumpHostConfig?.host) : nil
+
+            for name in config.workloads {
+                guard let workload = BenchmarkCorpus.builtIn(name, columns: config.columns, rows: config.rows, targetBytes: config.bytes) else {
+                    continue
+                }
+                let localPath = scratch.appendingPathComponent(name).path
+                let remotePath = "\(prefix)-\(name)"
+                try workload.payload.write(to: URL(fileURLWithPath: localPath))
+                _ = try await transport.uploadFile(sessionID: sessionID, localPath: localPath, remotePath: remotePath)
+
+                var transportRates: [Double] = []
+                var pipelineRates: [Double] = []
+                var openSSHRates: [Double] = []
+                for run in 1...config.runs {
+                    let transportRate = try await runSSHTransportScenario(transport: transport, sessionID: sessionID, remotePath: remotePath)
+                    let pipelineRate = try await runSSHPipelineScenario(transport: transport, sessionID: sessionID, remotePath: remotePath, config: config)
+                    transportRates.append(transportRate)
+                    pipelineRates.append(pipelineRate)
+                    var line = "run \(run)/\(config.runs) [\(name)] transport \(format(transportRate)) MB/s  pipeline \(format(pipelineRate)) MB/s"
+                    if let openSSH, let rate = await openSSH.catRate(remotePath: remotePath, bytes: workload.payload.count) {
+                        openSSHRates.append(rate)
+                        line += "  openssh \(format(rate)) MB/s"
+                    }
+                    print(line)
+                }
+                report.rows.append(.init(metric: "transport \(name)", unit: .megabytesPerSecond,
+                                         prossh: median(transportRates), openssh: openSSHRates.isEmpty ? nil : median(openSSHRates)))
+                report.rows.append(.init(metric: "pipeline \(name)", unit: .megabytesPerSecond,
+                                         prossh: median(pipelineRates), openssh: nil))
+            }
+
+            let echo = try await runSSHEchoScenario(transport: transport, sessionID: sessionID, config: config)
+            print("echo: \(echo.count) samples, median \(format(median(echo))) ms, p95 \(format(percentile95(echo))) ms")
+            report.rows.append(.init(metric: "echo rtt median", unit: .milliseconds, prossh: median(echo), openssh: nil))
+            report.rows.append(.init(metric: "echo rtt p95", unit: .milliseconds, prossh: percentile95(echo), openssh: nil))
+
+            let sftp = try await runSFTPScenario(
+                transport: transport,
+                sessionID: sessionID,
+                scratch: scratch,
+                remotePath: "\(prefix)-sftp",
+                config: config,
+                openSSH: openSSH
+            )
+            report.rows.append(contentsOf: sftp)
+        } catch {
+            await removeBenchmarkFiles(transport: transport, sessionID: sessionID, prefix: prefix, scratch: scratch)
+            throw error
+        }
+        await removeBenchmarkFiles(transport: transport, sessionID: sessionID, prefix: prefix, scratch: scratch)
+        return report
+    }
+
+    // MARK: - Scenarios
+
+    /// `cat` on an exec channel; output is counted and dropped.
+    private static func runSSHTransportScenario(transport: LibSSHTransport, sessionID: UUID, remotePath: String) async throws -> Double {
+        let start = CFAbsoluteTimeGetCurrent()
+        var bytes = 0
+        for try await event in try await transport.runCommand(sessionID: sessionID, command: "cat \(remotePath)") {
+            switch event {
+            case .stdout(let data):
+                bytes += data.count
+            case .stderr:
+                break
+            case .exit(let code):
+                if let code, code != 0 {
+                    throw SSHBenchmarkError.commandFailed("cat \(remotePath)", code)
+                }
+            }
+        }
+        return rate(bytes: bytes, seconds: CFAbsoluteTimeGetCurrent() - start)
+    }
+
+    /// `cat` in an interactive shell, parsed as a session would parse it. The
+    /// shell is brought up first so its startup is not timed.
+    private static func runSSHPipelineScenario(
+        transport: LibSSHTransport,
+        sessionID: UUID,
+        remotePath: String,
+        config: SSHBenchmarkConfig
+    ) async throws -> Double {
+        let engine = TerminalEngine(columns: config.columns, rows: config.rows)
+        let channel = try await transport.openShell(
+            sessionID: sessionID,
+            pty: PTYConfiguration(columns: config.columns, rows: config.rows, terminalType: "xterm-256color")
+        )
+        guard let ring = channel.outputRing else {
+            await channel.close()
+            throw SSHBenchmarkError.noOutputRing
+        }
+        let watchdog = Task {
+            try? await Task.sleep(for: .seconds(300))
+            await channel.close()
+        }
+        defer { watchdog.cancel() }
+
+        try await channel.send("stty -echo; \(printMarker("READY"))\n")
+        guard await drain(ring, until: marker("READY"), feeding: nil) != nil else {
+            await channel.close()
+            throw SSHBenchmarkError.timedOut("shell startup")
+        }
+
+        let start = CFAbsoluteTimeGetCurrent()
+        try await channel.send("cat \(remotePath); \(printMarker("DONE"))\n")
+        let bytes = await drain(ring, until: marker("DONE"), feeding: engine)
+        let elapsed = CFAbsoluteTimeGetCurrent() - start
+        _ = await engine.snapshot()
+        await channel.close()
+
+        guard let bytes else {
+            throw SSHBenchmarkError.timedOut("pipeline run")
+        }
+        return rate(bytes: bytes, seconds: elapsed)
+    }
+
+    /// One keystroke at a time into `cat` with the tty echoing, timing each
+    /// byte until its echo is readable. The line is ended every 100 samples so
+    /// it stays under the tty's canonical line limit.
+    private static func runSSHEchoScenario(
+        transport: LibSSHTransport,
+        sessionID: UUID,
+        config: SSHBenchmarkConfig
+    ) async throws -> [Double] {
+        let channel = try await transport.openShell(
+            sessionID: sessionID,
+            pty: PTYConfiguration(columns: config.columns, rows: config.rows, terminalType: "xterm-256color")
+        )
+        guard let ring = channel.outputRing else {
+            await channel.close()
+            throw SSHBenchmarkError.noOutputRing
+        }
+        let watchdog = Task {
+            try? await Task.sleep(for: .seconds(120))
+            await channel.close()
+        }
+        defer { watchdog.cancel() }
+
+        try await channel.send("\(printMarker("READY")); cat > /dev/null\n")
+        guard await drain(ring, until: marker("READY"), feeding: nil) != nil else {
+            await channel.close()
+            throw SSHBenchmarkError.timedOut("shell startup")
+        }
+        try? await Task.sleep(for: .milliseconds(200))
+        ring.consume(ring.readableCount)
+
+        var samples: [Double] = []
+        for sample in 1...config.echoSamples {
+            let sent = CFAbsoluteTimeGetCurrent()
+            try await channel.send(bytes: [0x78], priority: .interactive)
+            guard await ring.waitForReadable() else {
+                throw SSHBenchmarkError.timedOut("keystroke echo")
+            }
+            samples.append((CFAbsoluteTimeGetCurrent() - sent) * 1000)
+            try? await Task.sleep(for: .milliseconds(10))
+            ring.consume(ring.readableCount)
+
+            if sample.isMultiple(of: 100) {
+                try await channel.send(bytes: [0x0D], priority: .interactive)
+                try? await Task.sleep(for: .milliseconds(100))
+                ring.consume(ring.readableCount)
+            }
+        }
+
+        try? await channel.send(bytes: [0x03], priority: .interactive)
+        await channel.close()
+        return samples
+    }
+
+    /// Uploads then downloads one random file, through LibSSHTransport and
+    /// then OpenSSH's sftp when comparing.
+    private static func runSFTPScenario(
+        transport: LibSSHTransport,
+        sessionID: UUID,
+        scratch: URL,
+        remotePath: String,
+        config: SSHBenchmarkConfig,
+        openSSH: OpenSSHBaseline?
+    ) async throws -> [SSHBenchmarkReport.Row] {
+        var payload = Data(count: config.sftpBytes)
+        payload.withUnsafeMutableBytes { arc4random_buf($0.baseAddress!, $0.count) }
+        let uploadPath = scratch.appendingPathComponent("sftp-upload").path
+        let downloadPath = scratch.appendingPathComponent("sftp-download").path
+        try payload.write(to: URL(fileURLWithPath: uploadPath))
+
+        var uploads: [Double] = []
+        var downloads: [Double] = []
+        var openSSHUploads: [Double] = []
+        var openSSHDownloads: [Double] = []
+        for run in 1...config.runs {
+            var start = CFAbsoluteTimeGetCurrent()
+            let uploaded = try await transport.uploadFile(sessionID: sessionID, localPath: uploadPath, remotePath: remotePath)
+            uploads.append(rate(bytes: Int(uploaded.bytesTransferred), seconds: CFAbsoluteTimeGetCurrent() - start))
+
+            try? FileManager.default.removeItem(atPath: downloadPath)
+            start = CFAbsoluteTimeGetCurrent()
+            let downloaded = try await transport.downloadFile(sessionID: sessionID, remotePath: remotePath, localPath: downloadPath)
+            downloads.append(rate(bytes: Int(downloaded.bytesTransferred), seconds: CFAbsoluteTimeGetCurrent() - start))
+            if downloaded.bytesTransferred != Int64(config.sftpBytes) {
+                print("  WARNING: downloaded \(downloaded.bytesTransferred) of \(config.sftpBytes) bytes")
+            }
+
+            var line = "run \(run)/\(config.runs) [sftp] upload \(format(uploads[run - 1])) MB/s  download \(format(downloads[run - 1])) MB/s"
+            if let openSSH,
+               let up = await openSSH.sftpRate(command: "put \(uploadPath) \(remotePath)", bytes: config.sftpBytes),
+               let down = await openSSH.sftpRate(command: "get \(remotePath) \(downloadPath)", bytes: config.sftpBytes) {
+                openSSHUploads.append(up)
+                openSSHDownloads.append(down)
+                line += "  openssh \(format(up)) / \(format(down)) MB/s"
+            }
+            print(line)
+        }
+
+        return [
+            .init(metric: "sftp upload", unit: .megabytesPerSecond,
+                  prossh: median(uploads), openssh: openSSHUploads.isEmpty ? nil : median(openSSHUploads)),
+            .init(metric: "sftp download", unit: .megabytesPerSecond,
+                  prossh: median(downloads), openssh: openSSHDownloads.isEmpty ? nil : median(openSSHDownloads)),
+        ]
+    }
+
+    // MARK: - Helpers
+
+    private static func resolveBenchmarkHost(_ query: String) async throws -> (Host, JumpHostConfig?) {
+        let hosts = try await PersistentStore<Host>(filename: "hosts.json").loadHosts()
+        guard let host = hosts.first(where: { $0.label == query }) ?? hosts.first(where: { $0.hostname == query }) else {
+            throw SSHBenchmarkError.hostNotFound(query)
+        }
+        guard let jumpHostID = host.jumpHost else {
+            return (host, nil)
+        }
+        guard let jumpHost = hosts.first(where: { $0.id == jumpHostID }) else {
+            throw SSHBenchmarkError.hostNotFound("jump host of \(host.label)")
+        }
+        // The app probes and asks before trusting a new bastion; the benchmark
+        // only uses one that is already trusted.
+        guard let fingerprint = try await FileKnownHostsStore().fingerprint(hostname: jumpHost.hostname, port: jumpHost.port) else {
+            throw SSHBenchmarkError.untrustedHost(jumpHost.label)
+        }
+        return (host, JumpHostConfig(host: jumpHost, expectedFingerprint: fingerprint))
+    }
+
+    /// Reads `ring` until `marker` has been seen, feeding each span to
+    /// `engine` when given. Returns the bytes read, or nil if the channel
+    /// closed first.
+    static func drain(_ ring: ShellOutputRing, until marker: Data, feeding engine: TerminalEngine?) async -> Int? {
+        var total = 0
+        var tail = Data()
+        while await ring.waitForReadable() {
+            let region = ring.readableRegion
+            guard let baseAddress = region.baseAddress, !region.isEmpty else { continue }
+            let span = Data(
+                bytesNoCopy: UnsafeMutableRawPointer(mutating: baseAddress),
+                count: region.count,
+                deallocator: .none
+            )
+            if let engine {
+                _ = await engine.feed(borrowing: span)
+            }
+            // The marker may straddle two spans.
+            let found = span.range(of: marker) != nil
+                || (tail + span.prefix(marker.count - 1)).range(of: marker) != nil
+            tail = Data(span.suffix(marker.count - 1))
+            total += region.count
+            ring.consume(region.count)
+            if found {
+                return total
+            }
+        }
+        return nil
+    }
+
+    static func marker(_ name: String) -> Data {
+        Data("---PROSSH_BENCH_\(name)---".utf8)
+    }
+
+    /// Prints `marker(name)` without the command line containing it, so the
+    /// tty echo of the command is not mistaken for its output.
+    static func printMarker(_ name: String) -> String {
+        "printf '%s\\n' '---PROSSH_BENCH''_\(name)---'"
+    }
+
+    private static func removeBenchmarkFiles(transport: LibSSHTransport, sessionID: UUID, prefix: String, scratch: URL) async {
+        _ = try? await transport.executeCommand(sessionID: sessionID, command: "rm -f \(prefix)-*", timeout: .seconds(10))
+        await transport.disconnect(sessionID: sessionID)
+        try? FileManager.default.removeItem(at: scratch)
+    }
+
+    private static func rate(bytes: Int, seconds: Double) -> Double {
+        seconds > 0 ? Double(bytes) / seconds / 1_048_576.0 : 0
+    }
+
+    private static func percentile95(_ values: [Double]) -> Double {
+        guard !values.isEmpty else { return 0 }
+        let sorted = values.sorted()
+        return sorted[min(sorted.count - 1, Int((Double(sorted.count) * 0.95).rounded(.up)) - 1)]
+    }
+
+    private static func sshConfigurationFromArgs() -> SSHBenchmarkConfig {
+        let args = ProcessInfo.processInfo.arguments
+        let size = stringArg("--benchmark-size", args: args)?
+            .lowercased()
+            .split(separator: "x")
+            .compactMap { Int($0) }
+        let workloads = stringArg("--benchmark-workloads", args: args)?
+            .split(separator: ",")
+            .map(String.init)
+            .filter { BenchmarkCorpus.builtInNames.contains($0) }
+        let hasSize = size?.count == 2 && size!.allSatisfy { $0 > 0 }
+        return SSHBenchmarkConfig(
+            hostQuery: stringArg("--benchmark-host", args: args) ?? "",
+            bytes: max(intArg("--benchmark-bytes", args: args, defaultValue: 16 * 1_048_576), 1024),
+            runs: max(intArg("--benchmark-runs", args: args, defaultValue: 3), 1),
+            columns: hasSize ? size![0] : PTYConfiguration.default.columns,
+            rows: hasSize ? size![1] : PTYConfiguration.default.rows,
+            workloads: workloads?.isEmpty == false ? workloads! : ["base64", "truecolor", "cjk-log"],
+            echoSamples: min(max(intArg("--benchmark-echo-samples", args: args, defaultValue: 200), 1), 1_000),
+            sftpBytes: max(intArg("--benchmark-sftp-bytes", args: args, defaultValue: 64 * 1_048_576), 1024),
+            comparesOpenSSH: !args.contains("--benchmark-no-openssh")
+        )
+    }
+}
+
+private struct SSHBenchmarkConfig {
+    /// Saved host label or hostname.
+    let hostQuery: String
+    /// Bytes per corpus payload.
+    let bytes: Int
+    let runs: Int
+    let columns: Int
+    let rows: Int
+    let workloads: [String]
+    let echoSamples: Int
+    let sftpBytes: Int
+    let comparesOpenSSH: Bool
+}
+
+private enum SSHBenchmarkError: LocalizedError {
+    case hostNotFound(String)
+    case untrustedHost(String)
+    case commandFailed(String, Int)
+    case noOutputRing
+    case timedOut(String)
+
+    var errorDescription: String? {
+        switch self {
+        case let .hostNotFound(query):
+            return "No saved host matches '\(query)'."
+        case let .untrustedHost(label):
+            return "The host key of '\(label)' is not trusted yet. Connect once from the app to verify it."
+        case let .commandFailed(command, code):
+            return "'\(command)' exited with status \(code)."
+        case .noOutputRing:
+            return "The shell channel has no output ring."
+        case let .timedOut(phase):
+            return "Timed out during \(phase)."
+        }
+    }
+}
+
+/// The same transfers through the system OpenSSH client, non-interactively.
+/// A failed run (no key or agent, missing binary) yields nil.
+private struct OpenSSHBaseline {
+    let options: [String]
+    let destination: String
+
+    init(host: Host, jumpHost: Host?) {
+        var options = ["-q", "-o", "BatchMode=yes", "-o", "Port=\(host.port)"]
+        if let jumpHost {
+            options += ["-o", "ProxyJump=\(jumpHost.username)@\(jumpHost.hostname):\(jumpHost.port)"]
+        }
+        self.options = options
+        self.destination = "\(host.username)@\(host.hostname)"
+    }
+
+    func catRate(remotePath: String, bytes: Int) async -> Double? {
+        await timedRate(executable: "/usr/bin/ssh", arguments: options + [destination, "cat \(remotePath)"], input: nil, bytes: bytes)
+    }
+
+    func sftpRate(command: String, bytes: Int) async -> Double? {
+        await timedRate(executable: "/usr/bin/sftp", arguments: options + ["-b", "-", destination], input: Data("\(command)\n".utf8), bytes: bytes)
+    }
+
+    private func timedRate(executable: String, arguments: [String], input: Data?, bytes: Int) async -> Double? {
+        let process = Process()
+        process.executableURL = URL(fileURLWithPath: executable)
+        process.arguments = arguments
+        process.standardOutput = FileHandle.nullDevice
+        process.standardError = FileHandle.nullDevice
+        let stdin = Pipe()
+        process.standardInput = input == nil ? FileHandle.nullDevice : stdin
+
+        let start = CFAbsoluteTimeGetCurrent()
+        let status: Int32 = await withCheckedContinuation { continuation in
+            process.terminationHandler = { continuation.resume(returning: $0.terminationStatus) }
+            do {
+                try process.run()
+            } catch {
+                process.terminationHandler = nil
+                continuation.resume(returning: -1)
+                return
+            }
+            if let input {
+                stdin.fileHandleForWriting.write(input)
+                try? stdin.fileHandleForWriting.close()
+            }
+        }
+        let elapsed = CFAbsoluteTimeGetCurrent() - start
+        guard status == 0, elapsed > 0 else { return nil }
+        return Double(bytes) / elapsed / 1_048_576.0
+    }
+}
+
+// MARK: - SSHBenchmarkReport
+
+/// Median results, with the OpenSSH figure where one was measured.
+struct SSHBenchmarkReport {
+
+    enum Unit {
+        case megabytesPerSecond
+        case milliseconds
+    }
+
+    struct Row: Equatable {
+        var metric: String
+        var unit: Unit
+        var prossh: Double
+        var openssh: Double?
+
+        /// ProSSH against OpenSSH, oriented so above 1 is better: the rate
+        /// ratio, or the inverse ratio for times.
+        var relative: Double? {
+            guard let openssh, openssh > 0, prossh > 0 else { return nil }
+            switch unit {
+            case .megabytesPerSecond: return prossh / openssh
+            case .milliseconds: return openssh / prossh
+            }
+        }
+    }
+
+    var rows: [Row] = []
+
+    var lines: [String] {
+        let header = "metric".padding(toLength: 24, withPad: " ", startingAt: 0)
+            + "prossh".leftPadded(to: 14)
+            + "openssh".leftPadded(to: 14)
+            + "relative".leftPadded(to: 10)
+        return [header] + rows.map { row in
+            row.metric.padding(toLength: 24, withPad: " ", startingAt: 0)
+                + Self.format(row.prossh, row.unit).leftPadded(to: 14)
+                + (row.openssh.map { Self.format($0, row.unit) } ?? "-").leftPadded(to: 14)
+                + (row.relative.map { String(format: "%.2fx", $0) } ?? "-").leftPadded(to: 10)
+        }
+    }
+
+    private static func format(_ value: Double, _ unit: Unit) -> String {
+        switch unit {
+        case .megabytesPerSecond: return String(format: "%.2f MB/s", value)
+        case .milliseconds: return String(format: "%.2f ms", value)
+        }
+    }
+}
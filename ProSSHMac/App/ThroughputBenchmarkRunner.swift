@@ -5,19 +5,30 @@ import Foundation
 enum ThroughputBenchmarkRunner {
     static var isEnabled: Bool {
         let args = ProcessInfo.processInfo.arguments
-        return args.contains("--benchmark-base64") || args.contains("--benchmark-pty-local")
+        return args.contains("--benchmark-base64")
+            || args.contains("--benchmark-pty-local")
+            || args.contains("--benchmark-corpus")
+            || args.contains("--benchmark-ssh")
     }
 
     static var isPTYLocalEnabled: Bool {
         ProcessInfo.processInfo.arguments.contains("--benchmark-pty-local")
     }
 
-    private enum RunState {
+    static var isCorpusEnabled: Bool {
+        ProcessInfo.processInfo.arguments.contains("--benchmark-corpus")
+    }
+
+    static var isSSHEnabled: Bool {
+        ProcessInfo.processInfo.arguments.contains("--benchmark-ssh")
+    }
+
+    enum RunState {
         case idle
         case running
         case completed
     }
-    private static var runState: RunState = .idle
+    static var runState: RunState = .idle
 
     static func runIfRequested() async -> Bool {
         guard isEnabled else { return false }
@@ -31,9 +42,15 @@ enum ThroughputBenchmarkRunner {
         if isPTYLocalEnabled {
             return await runPTYLocalIfRequested()
         }
+        if isCorpusEnabled {
+            return await runCorpusIfRequested()
+        }
+        if isSSHEnabled {
+            return await runSSHIfRequested()
+        }
 
         let config = configurationFromArgs()
-        let payload = makeBase64LikePayload(targetBytes: config.bytes, lineLength: config.lineLength)
+        let payload = BenchmarkCorpus.base64Payload(targetBytes: config.bytes, lineLength: config.lineLength)
 
         print("==> ProSSHMac Throughput Benchmark")
         print("    bytes=\(config.bytes) chunk=\(config.chunkSize) runs=\(config.runs) lineLength=\(config.lineLength)")
@@ -79,6 +96,70 @@ enum ThroughputBenchmarkRunner {
         exit(0)
     }
 
+    // MARK: - Workload Corpus Benchmark
+
+    /// Every corpus workload at every grid size. Reports the median of the
+    /// runs for MB/s, ns/byte and heap allocations per MB fed.
+    static func runCorpusIfRequested() async -> Bool {
+        let config = corpusConfigurationFromArgs()
+
+        print("==> ProSSHMac Workload Corpus Benchmark")
+        print("    bytes=\(config.bytes) chunk=\(config.chunkSize) runs=\(config.runs) sizes=\(config.sizes.map { "\($0.columns)x\($0.rows)" }.joined(separator: ","))")
+        if BenchmarkAllocationCounter.start()?.stop() == nil {
+            print("    allocations: unavailable (another malloc logger is installed)")
+        }
+        print("")
+
+        var recorded: [BenchmarkWorkload] = []
+        if let directory = config.corpusDirectory {
+            recorded = BenchmarkCorpus.recorded(in: directory) { print("  WARNING: skipped \($0)") }
+            print("    recorded workloads: \(recorded.count) from \(directory.path)")
+            print("")
+        }
+
+        print("workload".padding(toLength: 22, withPad: " ", startingAt: 0)
+            + "size".padding(toLength: 10, withPad: " ", startingAt: 0)
+            + "MB/s".leftPadded(to: 10)
+            + "ns/byte".leftPadded(to: 10)
+            + "allocs/MB".leftPadded(to: 12))
+
+        for size in config.sizes {
+            var workloads = config.workloads.compactMap {
+                BenchmarkCorpus.builtIn($0, columns: size.columns, rows: size.rows, targetBytes: config.bytes)
+            }
+            workloads.append(contentsOf: recorded)
+
+            for workload in workloads {
+                var results: [BenchmarkResult] = []
+                for _ in 0..<config.runs {
+                    results.append(await runScenario(
+                        name: workload.name,
+                        payload: workload.payload,
+                        chunkSize: config.chunkSize,
+                        scrollRegion: nil,
+                        columns: size.columns,
+                        rows: size.rows,
+                        countAllocations: true
+                    ))
+                }
+                let mbps = median(results.map(\.mbps))
+                let nsPerByte = median(results.map(\.nanosecondsPerByte))
+                let allocations = results.compactMap(\.allocationsPerMB)
+                print(workload.name.padding(toLength: 22, withPad: " ", startingAt: 0)
+                    + "\(size.columns)x\(size.rows)".padding(toLength: 10, withPad: " ", startingAt: 0)
+                    + format(mbps).leftPadded(to: 10)
+                    + format(nsPerByte).leftPadded(to: 10)
+                    + (allocations.isEmpty ? "-" : String(format: "%.0f", median(allocations))).leftPadded(to: 12))
+            }
+        }
+        print("")
+
+        runState = .completed
+        fflush(stdout)
+        fflush(stderr)
+        exit(0)
+    }
+
     // MARK: - PTY Local Benchmark
 
     static func runPTYLocalIfRequested() async -> Bool {
@@ -120,30 +201,20 @@ enum ThroughputBenchmarkRunner {
                 shellPath: "/bin/sh"
             )
 
-            // Wire PTY output → engine.feed (mimicking SessionManager's startParserReader)
-            let sentinel = "---BENCH_DONE---"
-            let command = "dd if=/dev/urandom bs=1024 count=\(kilobytes) 2>/dev/null | base64; echo '\(sentinel)'\n"
+            // Read the PTY's output ring in place, as SessionManager's parser reader does.
+            guard let ring = channel.outputRing else {
+                await channel.close()
+                return 0
+            }
+            let command = "dd if=/dev/urandom bs=1024 count=\(kilobytes) 2>/dev/null | base64; \(printMarker("DONE"))\n"
 
             let start = CFAbsoluteTimeGetCurrent()
 
             try await channel.send(command)
 
-            var totalBytes = 0
-            var foundSentinel = false
-
-            for await chunk in channel.rawOutput {
-                if Task.isCancelled { break }
-
-                await engine.feed(chunk)
-                totalBytes += chunk.count
-
-                // Check for sentinel in the raw data
-                if let text = String(data: chunk, encoding: .utf8),
-                   text.contains(sentinel) {
-                    foundSentinel = true
-                    break
-                }
-            }
+            let drained = await drain(ring, until: marker("DONE"), feeding: engine)
+            let totalBytes = drained ?? 0
+            let foundSentinel = drained != nil
 
             let elapsed = CFAbsoluteTimeGetCurrent() - start
 
@@ -168,23 +239,29 @@ enum ThroughputBenchmarkRunner {
         name: String,
         payload: Data,
         chunkSize: Int,
-        scrollRegion: (top: Int, bottom: Int)?
+        scrollRegion: (top: Int, bottom: Int)?,
+        columns: Int = 80,
+        rows: Int = 24,
+        countAllocations: Bool = false
     ) async -> BenchmarkResult {
-        let engine = TerminalEngine(columns: 80, rows: 24)
+        let engine = TerminalEngine(columns: columns, rows: rows)
 
         if let region = scrollRegion {
             await engine.setScrollRegion(top: region.top, bottom: region.bottom)
         }
 
+        // Cut the chunks up front so slicing is not measured.
+        let chunks = stride(from: 0, to: payload.count, by: chunkSize).map {
+            payload.subdata(in: $0..<min($0 + chunkSize, payload.count))
+        }
+
+        let counter = countAllocations ? BenchmarkAllocationCounter.start() : nil
         let start = CFAbsoluteTimeGetCurrent()
-        var offset = 0
-        while offset < payload.count {
-            let end = min(offset + chunkSize, payload.count)
-            let chunk = payload.subdata(in: offset..<end)
+        for chunk in chunks {
             _ = await engine.feed(chunk)
-            offset = end
         }
         let elapsed = CFAbsoluteTimeGetCurrent() - start
+        let allocations = counter?.stop()
 
         let state = await engine.state
         _ = await engine.snapshot()
@@ -193,40 +270,24 @@ enum ThroughputBenchmarkRunner {
             name: name,
             bytes: payload.count,
             elapsedSeconds: elapsed,
-            parserState: state
+            parserState: state,
+            allocations: allocations
         )
     }
 
-    private static func makeBase64LikePayload(targetBytes: Int, lineLength: Int) -> Data {
-        let alphabet = Array("ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/".utf8)
-        var out = Data()
-        out.reserveCapacity(max(targetBytes, 0))
-
-        var seed: UInt64 = 0x1234_5678_9ABC_DEF0
-        var col = 0
-        while out.count < targetBytes {
-            if lineLength > 0, col >= lineLength {
-                if out.count < targetBytes { out.append(0x0D) }
-                if out.count < targetBytes { out.append(0x0A) }
-                col = 0
-                continue
-            }
-
-            seed = seed &* 6364136223846793005 &+ 1442695040888963407
-            let idx = Int((seed >> 33) % UInt64(alphabet.count))
-            out.append(alphabet[idx])
-            col += 1
-        }
-
-        return out
+    static func average(of values: [Double]) -> Double {
+        guard !values.isEmpty else { return 0 }
+        return values.reduce(0, +) / Double(values.count)
     }
 
-    private static func average(of values: [Double]) -> Double {
+    static func median(_ values: [Double]) -> Double {
         guard !values.isEmpty else { return 0 }
-        return values.reduce(0, +) / Double(values.count)
+        let sorted = values.sorted()
+        let middle = sorted.count / 2
+        return sorted.count % 2 == 0 ? (sorted[middle - 1] + sorted[middle]) / 2 : sorted[middle]
     }
 
-    private static func format(_ value: Double) -> String {
+    static func format(_ value: Double) -> String {
         String(format: "%.2f", value)
     }
 
@@ -245,7 +306,38 @@ enum ThroughputBenchmarkRunner {
         )
     }
 
-    private static func intArg(_ flag: String, args: [String], defaultValue: Int) -> Int {
+    private static func corpusConfigurationFromArgs() -> CorpusBenchmarkConfig {
+        let args = ProcessInfo.processInfo.arguments
+        let sizes = stringArg("--benchmark-sizes", args: args)?
+            .split(separator: ",")
+            .compactMap { spec -> (columns: Int, rows: Int)? in
+                let parts = spec.lowercased().split(separator: "x").compactMap { Int($0) }
+                guard parts.count == 2, parts[0] > 0, parts[1] > 0 else { return nil }
+                return (parts[0], parts[1])
+            }
+        let workloads = stringArg("--benchmark-workloads", args: args)?
+            .split(separator: ",")
+            .map(String.init)
+            .filter { BenchmarkCorpus.builtInNames.contains($0) }
+        return CorpusBenchmarkConfig(
+            bytes: max(intArg("--benchmark-bytes", args: args, defaultValue: 4 * 1_048_576), 1024),
+            chunkSize: max(intArg("--benchmark-chunk", args: args, defaultValue: 4096), 64),
+            runs: max(intArg("--benchmark-runs", args: args, defaultValue: 3), 1),
+            sizes: sizes?.isEmpty == false ? sizes! : [(80, 24), (240, 70), (400, 120)],
+            workloads: workloads ?? BenchmarkCorpus.builtInNames,
+            corpusDirectory: stringArg("--benchmark-corpus-dir", args: args)
+                .map { URL(fileURLWithPath: ($0 as NSString).expandingTildeInPath, isDirectory: true) }
+        )
+    }
+
+    static func stringArg(_ flag: String, args: [String]) -> String? {
+        guard let idx = args.firstIndex(of: flag), idx + 1 < args.count else {
+            return nil
+        }
+        return args[idx + 1]
+    }
+
+    static func intArg(_ flag: String, args: [String], defaultValue: Int) -> Int {
         guard let idx = args.firstIndex(of: flag), idx + 1 < args.count else {
             return defaultValue
         }
@@ -262,19 +354,47 @@ private struct BenchmarkConfig {
     let partialBottom: Int
 }
 
+private struct CorpusBenchmarkConfig {
+    let bytes: Int
+    let chunkSize: Int
+    let runs: Int
+    let sizes: [(columns: Int, rows: Int)]
+    /// Built-in workloads to run; recorded ones always run.
+    let workloads: [String]
+    let corpusDirectory: URL?
+}
+
 private struct BenchmarkResult {
     let name: String
     let bytes: Int
     let elapsedSeconds: Double
     let parserState: ParserState
+    /// Heap allocations during the feed, when counted.
+    var allocations: UInt64? = nil
 
     var mbps: Double {
         guard elapsedSeconds > 0 else { return 0 }
         return Double(bytes) / elapsedSeconds / 1_048_576.0
     }
 
+    var nanosecondsPerByte: Double {
+        guard bytes > 0 else { return 0 }
+        return elapsedSeconds * 1_000_000_000 / Double(bytes)
+    }
+
+    var allocationsPerMB: Double? {
+        guard let allocations, bytes > 0 else { return nil }
+        return Double(allocations) / (Double(bytes) / 1_048_576.0)
+    }
+
     var summary: String {
         let stateLabel = parserState == .ground ? "ground" : "\(parserState)"
         return "\(String(format: "%.2f", mbps)) MB/s in \(String(format: "%.3f", elapsedSeconds))s (state=\(stateLabel))"
     }
 }
+
+extension String {
+    func leftPadded(to width: Int) -> String {
+        count >= width ? self : String(repeating: " ", count: width - count) + self
+    }
+}
@@ -6,25 +6,149 @@
 #include <openssl/evp.h>
 #include <openssl/pem.h>
 #include <openssl/err.h>
+#include <openssl/params.h>
 
 #include <fcntl.h>
+#include <limits.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <sys/time.h>
 #include <stdint.h>
 #include <pthread.h>
+#include <stdatomic.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/event.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/ip.h>
+#include <netinet/tcp.h>
+#include <netdb.h>
+#include <poll.h>
+#include <time.h>
+
+// State shared by every handle multiplexed over one SSH connection
+// (ControlMaster-style). A handle created by prossh_libssh_create owns a fresh
+// connection; prossh_libssh_create_shared attaches another handle to it, which
+// then opens its own shell and forward channels on the same ssh_session.
+typedef struct ProSSHJumpTunnel ProSSHJumpTunnel;
+typedef struct ProSSHPendingRemoteChannel ProSSHPendingRemoteChannel;
+
+typedef struct ProSSHConnection {
+    pthread_mutex_t session_mutex;
+    // Bulk (SFTP) work takes session_mutex one request at a time; interactive
+    // callers count themselves here first so a bulk loop yields to them.
+    pthread_cond_t bulk_cond;
+    atomic_int interactive_waiters;
+    int bulk_active;
+    // Cached SFTP subsystem, reused across listings and transfers.
+    sftp_session sftp;
+    // libssh raw packet counters. A change across a call means inbound packets
+    // were consumed, possibly on behalf of another channel of this session.
+    struct ssh_counter_struct raw_counter;
+    // Socket byte counters and the inbound link-rate estimate derived from
+    // them (see prossh_track_link_rate_locked). Guarded by session_mutex.
+    struct ssh_counter_struct socket_counter;
+    uint64_t burst_start_ns;
+    uint64_t burst_start_bytes;
+    uint64_t burst_last_ns;
+    uint64_t burst_last_bytes;
+    int64_t link_rate_bps;
+    // Packet counts at the last keepalive and the TCP drop time applied to the
+    // socket (see prossh_libssh_send_keepalive). Guarded by session_mutex.
+    uint64_t keepalive_in_packets;
+    uint64_t keepalive_out_packets;
+    int keepalive_drop_s;
+    // Handles attached to this connection (freed with the last one) and those
+    // currently using its session (the session is torn down with the last one).
+    // Guarded by session_mutex.
+    int handle_count;
+    int session_users;
+    // Shared I/O loop registration; guarded by prossh_io_registry_mutex.
+    ProSSHLibSSHHandle *io_handles;
+    socket_t io_fd;
+    int io_watched;
+    // Direct-tcpip channel on a shared bastion carrying this session, if any.
+    ProSSHJumpTunnel *jump_tunnel;
+    // Server-side (-R) listeners of every handle on this connection, and the
+    // session callbacks that route forwarded-tcpip opens to them. Guarded by
+    // session_mutex.
+    ProSSHRemoteForward *remote_forwards;
+    struct ssh_callbacks_struct callbacks;
+    int callbacks_installed;
+} ProSSHConnection;
+
+// Pending outbound shell bytes; [head, head + len) of data is unsent.
+typedef struct ProSSHWriteQueue {
+    char *data;
+    size_t head;
+    size_t len;
+    size_t capacity;
+    // Bumped by prossh_libssh_channel_discard_bulk, so a flush whose slice
+    // was discarded mid-write does not consume bytes queued after it.
+    uint64_t discards;
+} ProSSHWriteQueue;
+
+enum { PROSSH_WRITE_INTERACTIVE = 0, PROSSH_WRITE_BULK = 1 };
 
 struct ProSSHLibSSHHandle {
     ssh_session session;
     ssh_channel channel;
-    pthread_mutex_t session_mutex;
-    int session_mutex_initialized;
+    ProSSHConnection *connection;
+    // This handle's bulk operations; disconnect waits only for its own.
+    int bulk_active;
+    int closing;
+    // Shared I/O loop registration; guarded by prossh_io_registry_mutex.
+    ProSSHIOReadyCallback io_callback;
+    void *io_context;
+    int io_registered;
+    ProSSHLibSSHHandle *io_next;
+    ProSSHForwardChannel *forwards;
+    // Shell input queued by prossh_libssh_channel_enqueue, written by
+    // prossh_libssh_channel_flush. write_mutex nests inside session_mutex and
+    // is never held across a libssh call, so enqueueing never waits on the wire.
+    pthread_mutex_t write_mutex;
+    ProSSHWriteQueue write_queues[2];
+};
+
+// A forwarded-tcpip channel the server opened to a remote listener, waiting
+// for prossh_remote_forward_accept.
+struct ProSSHPendingRemoteChannel {
+    ssh_channel channel;
+    ProSSHPendingRemoteChannel *next;
+};
+
+struct ProSSHRemoteForward {
+    ProSSHLibSSHHandle *owner;
+    ProSSHRemoteForward *next;
+    char *address;
+    uint16_t bound_port;
+    ProSSHPendingRemoteChannel *pending_head;
+    ProSSHPendingRemoteChannel *pending_tail;
 };
 
 struct ProSSHForwardChannel {
     ssh_channel channel;
+    ProSSHLibSSHHandle *owner;
+    ProSSHForwardChannel *next;
+    // Set while the direct-tcpip open awaits the server's reply; libssh needs
+    // the same arguments on each retry (see prossh_forward_channel_open_poll).
+    int opening;
+    char *open_remote_host;
+    char *open_source_host;
+    uint16_t open_remote_port;
+    uint16_t open_source_port;
+    // Exec channels (prossh_exec_channel_open_start): the command, which step
+    // of session-open / exec-request is pending, and the exit status reported
+    // by the channel callback.
+    char *open_command;
+    int exec_requested;
+    struct ssh_channel_callbacks_struct exec_callbacks;
+    int exit_received;
+    int exit_code;
 };
 
 int ssh_pki_export_pubkey_blob(const ssh_key key, ssh_string *pblob);
@@ -46,6 +170,7 @@ static int prossh_parse_public_key_tokens(
     char **base64_token
 );
 static void prossh_libssh_channel_close_unlocked(ProSSHLibSSHHandle *handle);
+static void prossh_track_link_rate_locked(ProSSHConnection *connection);
 
 static void prossh_copy_string(char *dst, size_t dst_len, const char *src) {
     if (dst == NULL || dst_len == 0) {
@@ -132,17 +257,375 @@ static void prossh_set_error(
 }
 
 static void prossh_lock_handle(ProSSHLibSSHHandle *handle) {
-    if (handle == NULL || handle->session_mutex_initialized == 0) {
+    if (handle == NULL || handle->connection == NULL) {
         return;
     }
-    pthread_mutex_lock(&handle->session_mutex);
+    ProSSHConnection *connection = handle->connection;
+    atomic_fetch_add_explicit(&connection->interactive_waiters, 1, memory_order_relaxed);
+    pthread_mutex_lock(&connection->session_mutex);
+    if (atomic_fetch_sub_explicit(&connection->interactive_waiters, 1, memory_order_relaxed) == 1 &&
+        connection->bulk_active > 0) {
+        pthread_cond_broadcast(&connection->bulk_cond);
+    }
 }
 
 static void prossh_unlock_handle(ProSSHLibSSHHandle *handle) {
-    if (handle == NULL || handle->session_mutex_initialized == 0) {
+    if (handle == NULL || handle->connection == NULL) {
+        return;
+    }
+    prossh_track_link_rate_locked(handle->connection);
+    pthread_mutex_unlock(&handle->connection->session_mutex);
+}
+
+// Bulk locking
+//
+// SFTP transfers used to hold session_mutex for the whole transfer, freezing the
+// shell and forwards on the same connection. A bulk operation now holds the lock
+// for one SFTP request at a time and steps aside whenever an interactive caller
+// (prossh_lock_handle) is queued. Disconnect sets the handle's `closing` and
+// waits for its bulk operations to unwind before releasing the session they
+// reference; other handles on the same connection keep going.
+
+static void prossh_bulk_wait_turn_locked(ProSSHLibSSHHandle *handle) {
+    ProSSHConnection *connection = handle->connection;
+    while (atomic_load_explicit(&connection->interactive_waiters, memory_order_relaxed) > 0 &&
+           handle->closing == 0) {
+        pthread_cond_wait(&connection->bulk_cond, &connection->session_mutex);
+    }
+}
+
+// Returns with the lock held. Fails (lock released) if the session is gone.
+static int prossh_bulk_begin(ProSSHLibSSHHandle *handle) {
+    pthread_mutex_lock(&handle->connection->session_mutex);
+    prossh_bulk_wait_turn_locked(handle);
+    if (handle->closing != 0 || handle->session == NULL) {
+        pthread_mutex_unlock(&handle->connection->session_mutex);
+        return -1;
+    }
+    handle->bulk_active += 1;
+    handle->connection->bulk_active += 1;
+    return 0;
+}
+
+// Releases the lock between bulk requests so queued shell / forward I/O runs.
+static void prossh_bulk_pause(ProSSHLibSSHHandle *handle) {
+    prossh_track_link_rate_locked(handle->connection);
+    pthread_mutex_unlock(&handle->connection->session_mutex);
+}
+
+// Re-acquires the lock after interactive callers have had their turn. Returns
+// -1 (lock held) if the session started closing; the caller must unwind.
+static int prossh_bulk_resume(ProSSHLibSSHHandle *handle) {
+    pthread_mutex_lock(&handle->connection->session_mutex);
+    prossh_bulk_wait_turn_locked(handle);
+    return handle->closing != 0 ? -1 : 0;
+}
+
+static void prossh_io_notify(ProSSHLibSSHHandle *handle);
+
+// Called with the lock held; releases it. Nothing may touch the handle after
+// this returns, since a waiting disconnect may go on to destroy it.
+static void prossh_bulk_end(ProSSHLibSSHHandle *handle) {
+    ProSSHConnection *connection = handle->connection;
+    handle->bulk_active -= 1;
+    connection->bulk_active -= 1;
+    // SFTP requests consume packets for every channel on the session.
+    prossh_io_notify(handle);
+    prossh_track_link_rate_locked(connection);
+    if (handle->bulk_active == 0 && handle->closing != 0) {
+        pthread_cond_broadcast(&connection->bulk_cond);
+    }
+    pthread_mutex_unlock(&connection->session_mutex);
+}
+
+// Shared I/O loop
+//
+// One kqueue thread watches the socket of every registered connection.
+// Readiness is delivered through each attached handle's callback so Swift
+// readers (shell, forwards) can await it instead of sleep-polling. Every handle
+// multiplexed over a connection is woken, since any of their channels may have
+// data. Reads are level-triggered with EV_DISPATCH: after firing, a socket stays
+// disabled until a reader re-arms it, so a session nobody is reading from
+// cannot spin the loop.
+
+static pthread_once_t prossh_io_loop_once = PTHREAD_ONCE_INIT;
+static pthread_mutex_t prossh_io_registry_mutex = PTHREAD_MUTEX_INITIALIZER;
+static int prossh_io_kqueue = -1;
+static ProSSHConnection **prossh_io_registry = NULL;
+static size_t prossh_io_registry_count = 0;
+static size_t prossh_io_registry_capacity = 0;
+
+static int prossh_io_registry_index_unlocked(const ProSSHConnection *connection) {
+    for (size_t i = 0; i < prossh_io_registry_count; i++) {
+        if (prossh_io_registry[i] == connection) {
+            return (int)i;
+        }
+    }
+    return -1;
+}
+
+static void prossh_io_dispatch_unlocked(ProSSHConnection *connection) {
+    for (ProSSHLibSSHHandle *handle = connection->io_handles; handle != NULL; handle = handle->io_next) {
+        if (handle->io_callback != NULL) {
+            handle->io_callback(handle->io_context);
+        }
+    }
+}
+
+static void *prossh_io_loop_main(void *unused) {
+    (void)unused;
+    struct kevent events[64];
+
+    while (1) {
+        int count = kevent(prossh_io_kqueue, NULL, 0, events, 64, NULL);
+        if (count < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+
+        pthread_mutex_lock(&prossh_io_registry_mutex);
+        for (int i = 0; i < count; i++) {
+            ProSSHConnection *connection = (ProSSHConnection *)events[i].udata;
+            // The connection may have been unregistered between kevent()
+            // returning and taking the registry lock; only dispatch to live ones.
+            if (connection == NULL || prossh_io_registry_index_unlocked(connection) < 0) {
+                continue;
+            }
+            prossh_io_dispatch_unlocked(connection);
+        }
+        pthread_mutex_unlock(&prossh_io_registry_mutex);
+    }
+
+    return NULL;
+}
+
+static void prossh_io_loop_start(void) {
+    prossh_io_kqueue = kqueue();
+    if (prossh_io_kqueue < 0) {
+        return;
+    }
+
+    pthread_attr_t attributes;
+    pthread_attr_init(&attributes);
+    pthread_attr_setdetachstate(&attributes, PTHREAD_CREATE_DETACHED);
+    pthread_t thread;
+    if (pthread_create(&thread, &attributes, prossh_io_loop_main, NULL) != 0) {
+        close(prossh_io_kqueue);
+        prossh_io_kqueue = -1;
+    }
+    pthread_attr_destroy(&attributes);
+}
+
+static void prossh_io_change_unlocked(ProSSHConnection *connection, uint16_t flags) {
+    if (prossh_io_kqueue < 0 || connection->io_fd == SSH_INVALID_SOCKET) {
+        return;
+    }
+    struct kevent change;
+    EV_SET(&change, (uintptr_t)connection->io_fd, EVFILT_READ, flags, 0, 0, connection);
+    kevent(prossh_io_kqueue, &change, 1, NULL, 0, NULL);
+}
+
+static void prossh_io_unwatch_unlocked(ProSSHConnection *connection) {
+    int index = prossh_io_registry_index_unlocked(connection);
+    if (index >= 0) {
+        prossh_io_change_unlocked(connection, EV_DELETE);
+        prossh_io_registry[index] = prossh_io_registry[prossh_io_registry_count - 1];
+        prossh_io_registry_count--;
+    }
+    connection->io_watched = 0;
+    connection->io_fd = SSH_INVALID_SOCKET;
+}
+
+// Stops watching the socket but keeps the callbacks so waiters can still be
+// woken. Must run before the socket is closed so a recycled descriptor is never
+// touched.
+static void prossh_io_detach_fd(ProSSHConnection *connection) {
+    pthread_mutex_lock(&prossh_io_registry_mutex);
+    if (connection->io_watched != 0) {
+        prossh_io_change_unlocked(connection, EV_DELETE);
+        connection->io_fd = SSH_INVALID_SOCKET;
+    }
+    pthread_mutex_unlock(&prossh_io_registry_mutex);
+}
+
+static void prossh_io_notify(ProSSHLibSSHHandle *handle) {
+    if (handle == NULL || handle->connection == NULL) {
+        return;
+    }
+    pthread_mutex_lock(&prossh_io_registry_mutex);
+    prossh_io_dispatch_unlocked(handle->connection);
+    pthread_mutex_unlock(&prossh_io_registry_mutex);
+}
+
+static uint64_t prossh_inbound_packets(const ProSSHLibSSHHandle *handle) {
+    return handle != NULL && handle->connection != NULL ? handle->connection->raw_counter.in_packets : 0;
+}
+
+static void prossh_note_inbound_progress(ProSSHLibSSHHandle *handle, uint64_t packets_before) {
+    if (prossh_inbound_packets(handle) != packets_before) {
+        prossh_io_notify(handle);
+    }
+}
+
+static void prossh_attach_counters(ProSSHLibSSHHandle *handle) {
+    ProSSHConnection *connection = handle->connection;
+    memset(&connection->raw_counter, 0, sizeof(connection->raw_counter));
+    memset(&connection->socket_counter, 0, sizeof(connection->socket_counter));
+    connection->burst_start_ns = 0;
+    connection->burst_start_bytes = 0;
+    connection->burst_last_ns = 0;
+    connection->burst_last_bytes = 0;
+    connection->link_rate_bps = 0;
+    connection->keepalive_in_packets = 0;
+    connection->keepalive_out_packets = 0;
+    connection->keepalive_drop_s = 0;
+    ssh_set_counters(handle->session, &connection->socket_counter, &connection->raw_counter);
+}
+
+int prossh_io_loop_register(ProSSHLibSSHHandle *handle, ProSSHIOReadyCallback callback, void *context) {
+    if (handle == NULL || callback == NULL) {
+        return -1;
+    }
+
+    pthread_once(&prossh_io_loop_once, prossh_io_loop_start);
+    if (prossh_io_kqueue < 0) {
+        return -2;
+    }
+
+    prossh_lock_handle(handle);
+    socket_t fd = handle->session != NULL ? ssh_get_fd(handle->session) : SSH_INVALID_SOCKET;
+    prossh_unlock_handle(handle);
+    if (fd == SSH_INVALID_SOCKET) {
+        return -3;
+    }
+
+    ProSSHConnection *connection = handle->connection;
+    int status = 0;
+    pthread_mutex_lock(&prossh_io_registry_mutex);
+    if (connection->io_watched == 0 || connection->io_fd != fd) {
+        if (connection->io_watched != 0) {
+            prossh_io_change_unlocked(connection, EV_DELETE);
+        } else {
+            if (prossh_io_registry_count == prossh_io_registry_capacity) {
+                size_t capacity = prossh_io_registry_capacity == 0 ? 16 : prossh_io_registry_capacity * 2;
+                ProSSHConnection **grown = (ProSSHConnection **)realloc(
+                    prossh_io_registry,
+                    capacity * sizeof(ProSSHConnection *)
+                );
+                if (grown == NULL) {
+                    status = -4;
+                    goto cleanup;
+                }
+                prossh_io_registry = grown;
+                prossh_io_registry_capacity = capacity;
+            }
+            prossh_io_registry[prossh_io_registry_count++] = connection;
+        }
+        connection->io_fd = fd;
+        connection->io_watched = 1;
+    }
+
+    if (handle->io_registered == 0) {
+        handle->io_next = connection->io_handles;
+        connection->io_handles = handle;
+    }
+    handle->io_callback = callback;
+    handle->io_context = context;
+    handle->io_registered = 1;
+    prossh_io_change_unlocked(connection, EV_ADD | EV_DISPATCH);
+
+cleanup:
+    pthread_mutex_unlock(&prossh_io_registry_mutex);
+    return status;
+}
+
+void prossh_io_loop_arm(ProSSHLibSSHHandle *handle) {
+    if (handle == NULL || handle->connection == NULL) {
+        return;
+    }
+    pthread_mutex_lock(&prossh_io_registry_mutex);
+    if (handle->connection->io_watched != 0) {
+        prossh_io_change_unlocked(handle->connection, EV_ENABLE | EV_DISPATCH);
+    }
+    pthread_mutex_unlock(&prossh_io_registry_mutex);
+}
+
+void prossh_io_loop_unregister(ProSSHLibSSHHandle *handle) {
+    if (handle == NULL || handle->connection == NULL) {
         return;
     }
-    pthread_mutex_unlock(&handle->session_mutex);
+    ProSSHConnection *connection = handle->connection;
+    pthread_mutex_lock(&prossh_io_registry_mutex);
+    if (handle->io_registered != 0) {
+        ProSSHLibSSHHandle **link = &connection->io_handles;
+        while (*link != NULL && *link != handle) {
+            link = &(*link)->io_next;
+        }
+        if (*link == handle) {
+            *link = handle->io_next;
+        }
+    }
+    handle->io_registered = 0;
+    handle->io_callback = NULL;
+    handle->io_context = NULL;
+    handle->io_next = NULL;
+    if (connection->io_handles == NULL) {
+        prossh_io_unwatch_unlocked(connection);
+    }
+    pthread_mutex_unlock(&prossh_io_registry_mutex);
+}
+
+// Cached SFTP subsystem
+//
+// The first SFTP call opens the subsystem under the bulk lock; later calls reuse
+// it, skipping a channel open and the version handshake on every sidebar listing
+// and transfer. Concurrent bulk operations share it (libssh matches replies by
+// request id), so a dead subsystem is only replaced when no one else holds it.
+
+static void prossh_sftp_release_locked(ProSSHLibSSHHandle *handle) {
+    if (handle->connection->sftp != NULL) {
+        sftp_free(handle->connection->sftp);
+        handle->connection->sftp = NULL;
+    }
+}
+
+static int prossh_sftp_is_usable(sftp_session sftp) {
+    return sftp != NULL && sftp->channel != NULL &&
+        ssh_channel_is_open(sftp->channel) != 0 && ssh_channel_is_eof(sftp->channel) == 0;
+}
+
+// Called between prossh_bulk_begin and prossh_bulk_end.
+static sftp_session prossh_sftp_acquire_locked(
+    ProSSHLibSSHHandle *handle,
+    char *error_buffer,
+    size_t error_buffer_len
+) {
+    ProSSHConnection *connection = handle->connection;
+    if (prossh_sftp_is_usable(connection->sftp)) {
+        return connection->sftp;
+    }
+    if (connection->sftp != NULL) {
+        if (connection->bulk_active > 1) {
+            prossh_copy_string(error_buffer, error_buffer_len, "SFTP channel closed.");
+            return NULL;
+        }
+        prossh_sftp_release_locked(handle);
+    }
+
+    sftp_session sftp = sftp_new(handle->session);
+    if (sftp == NULL) {
+        prossh_set_error(handle, "Failed to create SFTP session.", error_buffer, error_buffer_len);
+        return NULL;
+    }
+    if (sftp_init(sftp) != SSH_OK) {
+        prossh_set_error(handle, "Failed to initialize SFTP session.", error_buffer, error_buffer_len);
+        sftp_free(sftp);
+        return NULL;
+    }
+    connection->sftp = sftp;
+    return sftp;
 }
 
 static int prossh_prepare_blocking_session_for_sftp(ProSSHLibSSHHandle *handle) {
@@ -171,126 +654,594 @@ static void prossh_restore_session_mode_after_sftp(ProSSHLibSSHHandle *handle, i
     }
 }
 
-static int prossh_apply_options(
-    ProSSHLibSSHHandle *handle,
-    const char *hostname,
-    uint16_t port,
-    const char *username,
-    const char *kex,
-    const char *ciphers,
-    const char *hostkeys,
-    const char *macs,
-    int timeout_seconds,
-    char *error_buffer,
-    size_t error_buffer_len
-) {
-    if (ssh_options_set(handle->session, SSH_OPTIONS_HOST, hostname) != SSH_OK) {
-        prossh_set_error(handle, "Failed to set host option", error_buffer, error_buffer_len);
+static uint64_t prossh_monotonic_ns(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000ull + (uint64_t)now.tv_nsec;
+}
+
+// Link-rate estimate (adaptive compression)
+//
+// Inbound socket bytes are sampled each time the session lock is released.
+// Samples less than a gap apart form a burst; only bursts large and long enough
+// to be bandwidth-bound (a transfer or a flood of output, not a prompt or a
+// keystroke echo) feed the estimate, an even-weighted moving average.
+
+#define PROSSH_LINK_BURST_GAP_NS 100000000ull
+#define PROSSH_LINK_BURST_MIN_BYTES (256ull * 1024ull)
+#define PROSSH_LINK_BURST_MIN_NS 200000000ull
+
+// Bytes per second of the current burst, or -1 if it does not qualify yet.
+static int64_t prossh_burst_rate_locked(const ProSSHConnection *connection) {
+    uint64_t bytes = connection->burst_last_bytes - connection->burst_start_bytes;
+    uint64_t elapsed_ns = connection->burst_last_ns - connection->burst_start_ns;
+    if (connection->burst_start_ns == 0 ||
+        bytes < PROSSH_LINK_BURST_MIN_BYTES ||
+        elapsed_ns < PROSSH_LINK_BURST_MIN_NS) {
         return -1;
     }
+    return (int64_t)((double)bytes * 1e9 / (double)elapsed_ns);
+}
 
-    int numeric_port = (int)port;
-    if (ssh_options_set(handle->session, SSH_OPTIONS_PORT, &numeric_port) != SSH_OK) {
-        prossh_set_error(handle, "Failed to set port option", error_buffer, error_buffer_len);
+static int64_t prossh_blend_link_rate(int64_t estimate, int64_t sample) {
+    return estimate > 0 ? (estimate + sample) / 2 : sample;
+}
+
+static void prossh_track_link_rate_locked(ProSSHConnection *connection) {
+    uint64_t bytes = connection->socket_counter.in_bytes;
+    if (bytes == connection->burst_last_bytes) {
+        return;
+    }
+    uint64_t now = prossh_monotonic_ns();
+    if (connection->burst_start_ns == 0 || now - connection->burst_last_ns > PROSSH_LINK_BURST_GAP_NS) {
+        int64_t rate = prossh_burst_rate_locked(connection);
+        if (rate > 0) {
+            connection->link_rate_bps = prossh_blend_link_rate(connection->link_rate_bps, rate);
+        }
+        // What just arrived accumulated over the idle gap; time the burst from here.
+        connection->burst_start_ns = now;
+        connection->burst_start_bytes = bytes;
+    }
+    connection->burst_last_ns = now;
+    connection->burst_last_bytes = bytes;
+}
+
+int64_t prossh_libssh_link_rate(ProSSHLibSSHHandle *handle) {
+    if (handle == NULL || handle->connection == NULL) {
+        return 0;
+    }
+    ProSSHConnection *connection = handle->connection;
+    pthread_mutex_lock(&connection->session_mutex);
+    int64_t estimate = connection->link_rate_bps;
+    int64_t current = prossh_burst_rate_locked(connection);
+    if (current > 0) {
+        estimate = prossh_blend_link_rate(estimate, current);
+    }
+    pthread_mutex_unlock(&connection->session_mutex);
+    return estimate;
+}
+
+#define PROSSH_DSCP_AF21 0x48
+#define PROSSH_DSCP_CS1 0x20
+
+int prossh_libssh_set_traffic_class(ProSSHLibSSHHandle *handle, ProSSHTrafficClass traffic_class) {
+    if (handle == NULL || handle->connection == NULL || handle->session == NULL) {
+        return -1;
+    }
+    ProSSHConnection *connection = handle->connection;
+    pthread_mutex_lock(&connection->session_mutex);
+    socket_t fd = ssh_get_fd(handle->session);
+    pthread_mutex_unlock(&connection->session_mutex);
+    if (fd == SSH_INVALID_SOCKET) {
         return -1;
     }
 
-    if (ssh_options_set(handle->session, SSH_OPTIONS_USER, username) != SSH_OK) {
-        prossh_set_error(handle, "Failed to set username option", error_buffer, error_buffer_len);
+    struct sockaddr_storage local;
+    socklen_t local_length = sizeof(local);
+    if (getsockname(fd, (struct sockaddr *)&local, &local_length) != 0) {
         return -1;
     }
 
-    int strict_host_key_check = 0;
-    if (ssh_options_set(handle->session, SSH_OPTIONS_STRICTHOSTKEYCHECK, &strict_host_key_check) != SSH_OK) {
-        prossh_set_error(handle, "Failed to configure host key verification mode", error_buffer, error_buffer_len);
+    int bulk = traffic_class == PROSSH_TRAFFIC_BULK;
+    int tos = bulk ? PROSSH_DSCP_CS1 : PROSSH_DSCP_AF21;
+    int result = -1;
+    if (local.ss_family == AF_INET) {
+        result = setsockopt(fd, IPPROTO_IP, IP_TOS, &tos, sizeof(tos));
+    } else if (local.ss_family == AF_INET6) {
+        result = setsockopt(fd, IPPROTO_IPV6, IPV6_TCLASS, &tos, sizeof(tos));
+    }
+    if (result != 0) {
         return -1;
     }
+#ifdef SO_NET_SERVICE_TYPE
+    int service_type = bulk ? NET_SERVICE_TYPE_BK : NET_SERVICE_TYPE_RD;
+    (void)setsockopt(fd, SOL_SOCKET, SO_NET_SERVICE_TYPE, &service_type, sizeof(service_type));
+#endif
+    return 0;
+}
 
-    if (timeout_seconds > 0) {
-        long timeout = (long)timeout_seconds;
-        if (ssh_options_set(handle->session, SSH_OPTIONS_TIMEOUT, &timeout) != SSH_OK) {
-            prossh_set_error(handle, "Failed to set timeout option", error_buffer, error_buffer_len);
-            return -1;
+// Parallel TCP connect (RFC 8305 "Happy Eyeballs")
+//
+// All resolved addresses are raced instead of tried one after another: the next
+// attempt starts 250 ms after the previous one (or as soon as it fails), address
+// families interleaved, and the first socket to connect is handed to libssh via
+// SSH_OPTIONS_FD. A dead IPv6 route therefore costs one attempt delay instead of
+// the full connect timeout. getaddrinfo() does not expose record TTLs, so
+// results are cached for a fixed PROSSH_DNS_CACHE_TTL_SECONDS and dropped as soon
+// as every address fails; the address that won moves to the front for the next
+// connect.
+
+#define PROSSH_CONNECT_ATTEMPT_DELAY_MS 250
+#define PROSSH_CONNECT_MAX_ADDRESSES 16
+#define PROSSH_DNS_CACHE_CAPACITY 32
+#define PROSSH_DNS_CACHE_TTL_SECONDS 60
+
+typedef struct {
+    struct sockaddr_storage address;
+    socklen_t length;
+    int family;
+} ProSSHResolvedAddress;
+
+typedef struct {
+    char hostname[256];
+    uint16_t port;
+    uint64_t expires_at_ns;
+    size_t count;
+    ProSSHResolvedAddress addresses[PROSSH_CONNECT_MAX_ADDRESSES];
+} ProSSHDNSCacheEntry;
+
+static pthread_mutex_t prossh_dns_cache_mutex = PTHREAD_MUTEX_INITIALIZER;
+static ProSSHDNSCacheEntry prossh_dns_cache[PROSSH_DNS_CACHE_CAPACITY];
+
+static ProSSHDNSCacheEntry *prossh_dns_cache_find_unlocked(const char *hostname, uint16_t port) {
+    for (size_t i = 0; i < PROSSH_DNS_CACHE_CAPACITY; i++) {
+        ProSSHDNSCacheEntry *entry = &prossh_dns_cache[i];
+        if (entry->count > 0 && entry->port == port && strcmp(entry->hostname, hostname) == 0) {
+            return entry;
         }
     }
+    return NULL;
+}
 
-    if (kex != NULL && kex[0] != '\0') {
-        if (ssh_options_set(handle->session, SSH_OPTIONS_KEY_EXCHANGE, kex) != SSH_OK) {
-            prossh_set_error(handle, "Failed to set key-exchange algorithms", error_buffer, error_buffer_len);
-            return -1;
-        }
+static void prossh_dns_cache_store(const char *hostname, uint16_t port, const ProSSHResolvedAddress *addresses, size_t count) {
+    if (strlen(hostname) >= sizeof(prossh_dns_cache[0].hostname)) {
+        return;
     }
 
-    if (ciphers != NULL && ciphers[0] != '\0') {
-        if (ssh_options_set(handle->session, SSH_OPTIONS_CIPHERS_C_S, ciphers) != SSH_OK ||
-            ssh_options_set(handle->session, SSH_OPTIONS_CIPHERS_S_C, ciphers) != SSH_OK) {
-            prossh_set_error(handle, "Failed to set ciphers", error_buffer, error_buffer_len);
-            return -1;
+    pthread_mutex_lock(&prossh_dns_cache_mutex);
+    ProSSHDNSCacheEntry *entry = prossh_dns_cache_find_unlocked(hostname, port);
+    if (entry == NULL) {
+        // Reuse the slot that expires first (empty slots expire at 0).
+        entry = &prossh_dns_cache[0];
+        for (size_t i = 1; i < PROSSH_DNS_CACHE_CAPACITY; i++) {
+            if (prossh_dns_cache[i].expires_at_ns < entry->expires_at_ns) {
+                entry = &prossh_dns_cache[i];
+            }
         }
     }
+    prossh_copy_string(entry->hostname, sizeof(entry->hostname), hostname);
+    entry->port = port;
+    entry->expires_at_ns = prossh_monotonic_ns() + (uint64_t)PROSSH_DNS_CACHE_TTL_SECONDS * 1000000000ull;
+    entry->count = count;
+    memcpy(entry->addresses, addresses, count * sizeof(ProSSHResolvedAddress));
+    pthread_mutex_unlock(&prossh_dns_cache_mutex);
+}
 
-    if (hostkeys != NULL && hostkeys[0] != '\0') {
-        if (ssh_options_set(handle->session, SSH_OPTIONS_HOSTKEYS, hostkeys) != SSH_OK) {
-            prossh_set_error(handle, "Failed to set host key algorithms", error_buffer, error_buffer_len);
-            return -1;
+static size_t prossh_dns_cache_lookup(const char *hostname, uint16_t port, ProSSHResolvedAddress *addresses) {
+    size_t count = 0;
+    pthread_mutex_lock(&prossh_dns_cache_mutex);
+    ProSSHDNSCacheEntry *entry = prossh_dns_cache_find_unlocked(hostname, port);
+    if (entry != NULL) {
+        if (entry->expires_at_ns > prossh_monotonic_ns()) {
+            count = entry->count;
+            memcpy(addresses, entry->addresses, count * sizeof(ProSSHResolvedAddress));
+        } else {
+            entry->count = 0;
         }
     }
+    pthread_mutex_unlock(&prossh_dns_cache_mutex);
+    return count;
+}
 
-    if (macs != NULL && macs[0] != '\0') {
-        if (ssh_options_set(handle->session, SSH_OPTIONS_HMAC_C_S, macs) != SSH_OK ||
-            ssh_options_set(handle->session, SSH_OPTIONS_HMAC_S_C, macs) != SSH_OK) {
-            prossh_set_error(handle, "Failed to set MAC algorithms", error_buffer, error_buffer_len);
-            return -1;
-        }
+static void prossh_dns_cache_forget(const char *hostname, uint16_t port) {
+    pthread_mutex_lock(&prossh_dns_cache_mutex);
+    ProSSHDNSCacheEntry *entry = prossh_dns_cache_find_unlocked(hostname, port);
+    if (entry != NULL) {
+        entry->count = 0;
+        entry->expires_at_ns = 0;
     }
+    pthread_mutex_unlock(&prossh_dns_cache_mutex);
+}
 
-    return 0;
+static void prossh_dns_cache_prefer(const char *hostname, uint16_t port, const ProSSHResolvedAddress *winner) {
+    pthread_mutex_lock(&prossh_dns_cache_mutex);
+    ProSSHDNSCacheEntry *entry = prossh_dns_cache_find_unlocked(hostname, port);
+    if (entry != NULL) {
+        for (size_t i = 1; i < entry->count; i++) {
+            if (entry->addresses[i].length == winner->length &&
+                memcmp(&entry->addresses[i].address, &winner->address, winner->length) == 0) {
+                ProSSHResolvedAddress promoted = entry->addresses[i];
+                memmove(&entry->addresses[1], &entry->addresses[0], i * sizeof(ProSSHResolvedAddress));
+                entry->addresses[0] = promoted;
+                break;
+            }
+        }
+    }
+    pthread_mutex_unlock(&prossh_dns_cache_mutex);
 }
 
-static int prossh_authenticate(
-    ProSSHLibSSHHandle *handle,
-    ProSSHAuthMethod auth_method,
-    const char *password,
-    const char *private_key_text,
-    const char *certificate_text,
-    const char *key_passphrase,
+// Resolves through the cache. Orders addresses per RFC 8305 section 4: the
+// system's preferred family first, then alternating families.
+static size_t prossh_resolve_addresses(
+    const char *hostname,
+    uint16_t port,
+    ProSSHResolvedAddress *addresses,
     char *error_buffer,
     size_t error_buffer_len
 ) {
-    int auth_result = SSH_AUTH_ERROR;
-
-    if (auth_method == PROSSH_AUTH_PASSWORD) {
-        if (password == NULL || password[0] == '\0') {
-            prossh_copy_string(error_buffer, error_buffer_len, "Password authentication selected but no password was provided.");
-            return -1;
+    size_t count = prossh_dns_cache_lookup(hostname, port, addresses);
+    if (count > 0) {
+        return count;
+    }
+
+    struct addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_protocol = IPPROTO_TCP;
+
+    char port_string[8];
+    snprintf(port_string, sizeof(port_string), "%u", (unsigned int)port);
+
+    struct addrinfo *result = NULL;
+    int status = getaddrinfo(hostname, port_string, &hints, &result);
+    if (status != 0 || result == NULL) {
+        char message[512];
+        snprintf(message, sizeof(message), "Failed to resolve hostname %s (%s)", hostname, gai_strerror(status));
+        prossh_copy_string(error_buffer, error_buffer_len, message);
+        if (result != NULL) {
+            freeaddrinfo(result);
         }
+        return 0;
+    }
 
-        auth_result = ssh_userauth_password(handle->session, NULL, password);
-        if (auth_result == SSH_AUTH_SUCCESS) {
-            return 0;
+    ProSSHResolvedAddress preferred[PROSSH_CONNECT_MAX_ADDRESSES];
+    ProSSHResolvedAddress other[PROSSH_CONNECT_MAX_ADDRESSES];
+    size_t preferred_count = 0;
+    size_t other_count = 0;
+    int preferred_family = result->ai_family;
+    for (struct addrinfo *info = result; info != NULL; info = info->ai_next) {
+        if ((info->ai_family != AF_INET && info->ai_family != AF_INET6) ||
+            info->ai_addrlen > sizeof(struct sockaddr_storage)) {
+            continue;
+        }
+        ProSSHResolvedAddress *slot = NULL;
+        if (info->ai_family == preferred_family && preferred_count < PROSSH_CONNECT_MAX_ADDRESSES) {
+            slot = &preferred[preferred_count++];
+        } else if (info->ai_family != preferred_family && other_count < PROSSH_CONNECT_MAX_ADDRESSES) {
+            slot = &other[other_count++];
+        }
+        if (slot != NULL) {
+            memset(slot, 0, sizeof(*slot));
+            memcpy(&slot->address, info->ai_addr, info->ai_addrlen);
+            slot->length = (socklen_t)info->ai_addrlen;
+            slot->family = info->ai_family;
         }
-
-        prossh_set_error(handle, "Password authentication failed", error_buffer, error_buffer_len);
-        return -1;
     }
+    freeaddrinfo(result);
 
-    if (auth_method == PROSSH_AUTH_KEYBOARD_INTERACTIVE) {
-        auth_result = ssh_userauth_kbdint(handle->session, NULL, NULL);
-        while (auth_result == SSH_AUTH_INFO) {
-            int prompts = ssh_userauth_kbdint_getnprompts(handle->session);
-            for (int i = 0; i < prompts; i++) {
-                const char *answer = (i == 0 && password != NULL && password[0] != '\0') ? password : "";
-                ssh_userauth_kbdint_setanswer(handle->session, i, answer);
-            }
-            auth_result = ssh_userauth_kbdint(handle->session, NULL, NULL);
+    for (size_t i = 0; count < PROSSH_CONNECT_MAX_ADDRESSES && (i < preferred_count || i < other_count); i++) {
+        if (i < preferred_count) {
+            addresses[count++] = preferred[i];
         }
-
-        if (auth_result == SSH_AUTH_SUCCESS) {
-            return 0;
+        if (i < other_count && count < PROSSH_CONNECT_MAX_ADDRESSES) {
+            addresses[count++] = other[i];
         }
-
-        prossh_set_error(handle, "Keyboard-interactive authentication failed", error_buffer, error_buffer_len);
-        return -1;
+    }
+
+    if (count == 0) {
+        char message[512];
+        snprintf(message, sizeof(message), "Failed to resolve hostname %s (no address associated with hostname)", hostname);
+        prossh_copy_string(error_buffer, error_buffer_len, message);
+        return 0;
+    }
+
+    prossh_dns_cache_store(hostname, port, addresses, count);
+    return count;
+}
+
+// Starts a non-blocking connect. Returns the socket (with *connected set when it
+// completed immediately) or -1 with *error_code set.
+static int prossh_tcp_start_connect(const ProSSHResolvedAddress *address, int *connected, int *error_code) {
+    *connected = 0;
+    int fd = socket(address->family, SOCK_STREAM, IPPROTO_TCP);
+    if (fd < 0) {
+        *error_code = errno;
+        return -1;
+    }
+
+    int flags = fcntl(fd, F_GETFL, 0);
+    if (flags < 0 || fcntl(fd, F_SETFL, flags | O_NONBLOCK) < 0) {
+        *error_code = errno;
+        close(fd);
+        return -1;
+    }
+#ifdef SO_NOSIGPIPE
+    int no_sigpipe = 1;
+    setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &no_sigpipe, sizeof(no_sigpipe));
+#endif
+
+    if (connect(fd, (const struct sockaddr *)&address->address, address->length) == 0) {
+        *connected = 1;
+        return fd;
+    }
+    if (errno != EINPROGRESS) {
+        *error_code = errno;
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// Returns a connected, blocking socket or -1 with error_buffer set.
+static int prossh_tcp_connect_racing(
+    const char *hostname,
+    uint16_t port,
+    int timeout_seconds,
+    char *error_buffer,
+    size_t error_buffer_len
+) {
+    ProSSHResolvedAddress addresses[PROSSH_CONNECT_MAX_ADDRESSES];
+    size_t count = prossh_resolve_addresses(hostname, port, addresses, error_buffer, error_buffer_len);
+    if (count == 0) {
+        return -1;
+    }
+
+    int fds[PROSSH_CONNECT_MAX_ADDRESSES];
+    for (size_t i = 0; i < count; i++) {
+        fds[i] = -1;
+    }
+
+    uint64_t now = prossh_monotonic_ns();
+    uint64_t deadline = now + (uint64_t)(timeout_seconds > 0 ? timeout_seconds : 30) * 1000000000ull;
+    uint64_t next_start_at = now;
+    size_t next = 0;
+    size_t active = 0;
+    int winner = -1;
+    int last_error = ETIMEDOUT;
+
+    while (winner < 0) {
+        now = prossh_monotonic_ns();
+        if (now >= deadline) {
+            last_error = ETIMEDOUT;
+            break;
+        }
+
+        if (next < count && (active == 0 || now >= next_start_at)) {
+            int connected = 0;
+            size_t attempt = next++;
+            fds[attempt] = prossh_tcp_start_connect(&addresses[attempt], &connected, &last_error);
+            if (fds[attempt] >= 0) {
+                active += 1;
+                next_start_at = now + (uint64_t)PROSSH_CONNECT_ATTEMPT_DELAY_MS * 1000000ull;
+                if (connected) {
+                    winner = (int)attempt;
+                }
+            }
+            continue;
+        }
+        if (active == 0) {
+            break;
+        }
+
+        struct pollfd poll_fds[PROSSH_CONNECT_MAX_ADDRESSES];
+        size_t poll_index[PROSSH_CONNECT_MAX_ADDRESSES];
+        nfds_t poll_count = 0;
+        for (size_t i = 0; i < next; i++) {
+            if (fds[i] >= 0) {
+                poll_fds[poll_count].fd = fds[i];
+                poll_fds[poll_count].events = POLLOUT;
+                poll_fds[poll_count].revents = 0;
+                poll_index[poll_count] = i;
+                poll_count++;
+            }
+        }
+
+        uint64_t wake_at = deadline;
+        if (next < count && next_start_at < wake_at) {
+            wake_at = next_start_at;
+        }
+        int wait_ms = (int)((wake_at - now + 999999ull) / 1000000ull);
+        int ready = poll(poll_fds, poll_count, wait_ms);
+        if (ready < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            last_error = errno;
+            break;
+        }
+
+        for (nfds_t j = 0; j < poll_count && winner < 0; j++) {
+            if (poll_fds[j].revents == 0) {
+                continue;
+            }
+            size_t i = poll_index[j];
+            int socket_error = 0;
+            socklen_t socket_error_len = sizeof(socket_error);
+            if (getsockopt(fds[i], SOL_SOCKET, SO_ERROR, &socket_error, &socket_error_len) != 0) {
+                socket_error = errno;
+            }
+            if (socket_error == 0 && (poll_fds[j].revents & POLLOUT) != 0) {
+                winner = (int)i;
+                break;
+            }
+            // Failed attempt: the next address starts right away.
+            last_error = socket_error != 0 ? socket_error : ECONNREFUSED;
+            close(fds[i]);
+            fds[i] = -1;
+            active -= 1;
+            next_start_at = now;
+        }
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        if (fds[i] >= 0 && (int)i != winner) {
+            close(fds[i]);
+        }
+    }
+
+    if (winner < 0) {
+        prossh_dns_cache_forget(hostname, port);
+        char message[512];
+        snprintf(message, sizeof(message), "Failed to connect to %s:%u: %s",
+                 hostname, (unsigned int)port, strerror(last_error));
+        prossh_copy_string(error_buffer, error_buffer_len, message);
+        return -1;
+    }
+
+    int fd = fds[winner];
+    int flags = fcntl(fd, F_GETFL, 0);
+    if (flags >= 0) {
+        fcntl(fd, F_SETFL, flags & ~O_NONBLOCK);
+    }
+    prossh_dns_cache_prefer(hostname, port, &addresses[winner]);
+    return fd;
+}
+
+static int prossh_apply_options(
+    ProSSHLibSSHHandle *handle,
+    const char *hostname,
+    uint16_t port,
+    const char *username,
+    const char *kex,
+    const char *ciphers,
+    const char *hostkeys,
+    const char *macs,
+    const char *compression,
+    int timeout_seconds,
+    char *error_buffer,
+    size_t error_buffer_len
+) {
+    if (ssh_options_set(handle->session, SSH_OPTIONS_HOST, hostname) != SSH_OK) {
+        prossh_set_error(handle, "Failed to set host option", error_buffer, error_buffer_len);
+        return -1;
+    }
+
+    int numeric_port = (int)port;
+    if (ssh_options_set(handle->session, SSH_OPTIONS_PORT, &numeric_port) != SSH_OK) {
+        prossh_set_error(handle, "Failed to set port option", error_buffer, error_buffer_len);
+        return -1;
+    }
+
+    if (ssh_options_set(handle->session, SSH_OPTIONS_USER, username) != SSH_OK) {
+        prossh_set_error(handle, "Failed to set username option", error_buffer, error_buffer_len);
+        return -1;
+    }
+
+    int strict_host_key_check = 0;
+    if (ssh_options_set(handle->session, SSH_OPTIONS_STRICTHOSTKEYCHECK, &strict_host_key_check) != SSH_OK) {
+        prossh_set_error(handle, "Failed to configure host key verification mode", error_buffer, error_buffer_len);
+        return -1;
+    }
+
+    if (timeout_seconds > 0) {
+        long timeout = (long)timeout_seconds;
+        if (ssh_options_set(handle->session, SSH_OPTIONS_TIMEOUT, &timeout) != SSH_OK) {
+            prossh_set_error(handle, "Failed to set timeout option", error_buffer, error_buffer_len);
+            return -1;
+        }
+    }
+
+    if (kex != NULL && kex[0] != '\0') {
+        if (ssh_options_set(handle->session, SSH_OPTIONS_KEY_EXCHANGE, kex) != SSH_OK) {
+            prossh_set_error(handle, "Failed to set key-exchange algorithms", error_buffer, error_buffer_len);
+            return -1;
+        }
+    }
+
+    if (ciphers != NULL && ciphers[0] != '\0') {
+        if (ssh_options_set(handle->session, SSH_OPTIONS_CIPHERS_C_S, ciphers) != SSH_OK ||
+            ssh_options_set(handle->session, SSH_OPTIONS_CIPHERS_S_C, ciphers) != SSH_OK) {
+            prossh_set_error(handle, "Failed to set ciphers", error_buffer, error_buffer_len);
+            return -1;
+        }
+    }
+
+    if (hostkeys != NULL && hostkeys[0] != '\0') {
+        if (ssh_options_set(handle->session, SSH_OPTIONS_HOSTKEYS, hostkeys) != SSH_OK) {
+            prossh_set_error(handle, "Failed to set host key algorithms", error_buffer, error_buffer_len);
+            return -1;
+        }
+    }
+
+    if (macs != NULL && macs[0] != '\0') {
+        if (ssh_options_set(handle->session, SSH_OPTIONS_HMAC_C_S, macs) != SSH_OK ||
+            ssh_options_set(handle->session, SSH_OPTIONS_HMAC_S_C, macs) != SSH_OK) {
+            prossh_set_error(handle, "Failed to set MAC algorithms", error_buffer, error_buffer_len);
+            return -1;
+        }
+    }
+
+    if (compression != NULL && compression[0] != '\0') {
+        if (ssh_options_set(handle->session, SSH_OPTIONS_COMPRESSION_C_S, compression) != SSH_OK ||
+            ssh_options_set(handle->session, SSH_OPTIONS_COMPRESSION_S_C, compression) != SSH_OK) {
+            // libssh built without zlib rejects every zlib name; compression is
+            // an optimization, so connect uncompressed rather than fail.
+            if (ssh_options_set(handle->session, SSH_OPTIONS_COMPRESSION_C_S, "none") != SSH_OK ||
+                ssh_options_set(handle->session, SSH_OPTIONS_COMPRESSION_S_C, "none") != SSH_OK) {
+                prossh_set_error(handle, "Failed to set compression algorithms", error_buffer, error_buffer_len);
+                return -1;
+            }
+        }
+    }
+
+    return 0;
+}
+
+static int prossh_authenticate(
+    ProSSHLibSSHHandle *handle,
+    ProSSHAuthMethod auth_method,
+    const char *password,
+    const char *private_key_text,
+    const char *certificate_text,
+    const char *key_passphrase,
+    char *error_buffer,
+    size_t error_buffer_len
+) {
+    int auth_result = SSH_AUTH_ERROR;
+
+    if (auth_method == PROSSH_AUTH_PASSWORD) {
+        if (password == NULL || password[0] == '\0') {
+            prossh_copy_string(error_buffer, error_buffer_len, "Password authentication selected but no password was provided.");
+            return -1;
+        }
+
+        auth_result = ssh_userauth_password(handle->session, NULL, password);
+        if (auth_result == SSH_AUTH_SUCCESS) {
+            return 0;
+        }
+
+        prossh_set_error(handle, "Password authentication failed", error_buffer, error_buffer_len);
+        return -1;
+    }
+
+    if (auth_method == PROSSH_AUTH_KEYBOARD_INTERACTIVE) {
+        auth_result = ssh_userauth_kbdint(handle->session, NULL, NULL);
+        while (auth_result == SSH_AUTH_INFO) {
+            int prompts = ssh_userauth_kbdint_getnprompts(handle->session);
+            for (int i = 0; i < prompts; i++) {
+                const char *answer = (i == 0 && password != NULL && password[0] != '\0') ? password : "";
+                ssh_userauth_kbdint_setanswer(handle->session, i, answer);
+            }
+            auth_result = ssh_userauth_kbdint(handle->session, NULL, NULL);
+        }
+
+        if (auth_result == SSH_AUTH_SUCCESS) {
+            return 0;
+        }
+
+        prossh_set_error(handle, "Keyboard-interactive authentication failed", error_buffer, error_buffer_len);
+        return -1;
     }
 
     const char *effective_key_passphrase = key_passphrase;
@@ -1480,19 +2431,101 @@ static int prossh_convert_pem_to_pkcs8(
     return 0;
 }
 
-ProSSHLibSSHHandle *prossh_libssh_create(void) {
+static void prossh_jump_tunnel_release(ProSSHJumpTunnel *tunnel);
+
+static ProSSHConnection *prossh_connection_create(void) {
+    ProSSHConnection *connection = (ProSSHConnection *)calloc(1, sizeof(ProSSHConnection));
+    if (connection == NULL) {
+        return NULL;
+    }
+
+    connection->io_fd = SSH_INVALID_SOCKET;
+
+    if (pthread_mutex_init(&connection->session_mutex, NULL) == 0) {
+        if (pthread_cond_init(&connection->bulk_cond, NULL) == 0) {
+            atomic_init(&connection->interactive_waiters, 0);
+            return connection;
+        }
+        pthread_mutex_destroy(&connection->session_mutex);
+    }
+
+    free(connection);
+    return NULL;
+}
+
+static void prossh_connection_free(ProSSHConnection *connection) {
+    pthread_cond_destroy(&connection->bulk_cond);
+    pthread_mutex_destroy(&connection->session_mutex);
+    free(connection);
+}
+
+static ProSSHLibSSHHandle *prossh_handle_alloc(void) {
     ProSSHLibSSHHandle *handle = (ProSSHLibSSHHandle *)calloc(1, sizeof(ProSSHLibSSHHandle));
     if (handle == NULL) {
         return NULL;
     }
-
-    if (pthread_mutex_init(&handle->session_mutex, NULL) == 0) {
-        handle->session_mutex_initialized = 1;
-        return handle;
+    if (pthread_mutex_init(&handle->write_mutex, NULL) != 0) {
+        free(handle);
+        return NULL;
     }
+    return handle;
+}
 
+static void prossh_handle_free(ProSSHLibSSHHandle *handle) {
+    free(handle->write_queues[PROSSH_WRITE_INTERACTIVE].data);
+    free(handle->write_queues[PROSSH_WRITE_BULK].data);
+    pthread_mutex_destroy(&handle->write_mutex);
     free(handle);
-    return NULL;
+}
+
+ProSSHLibSSHHandle *prossh_libssh_create(void) {
+    ProSSHLibSSHHandle *handle = prossh_handle_alloc();
+    if (handle == NULL) {
+        return NULL;
+    }
+
+    handle->connection = prossh_connection_create();
+    if (handle->connection == NULL) {
+        prossh_handle_free(handle);
+        return NULL;
+    }
+    handle->connection->handle_count = 1;
+    return handle;
+}
+
+ProSSHLibSSHHandle *prossh_libssh_create_shared(ProSSHLibSSHHandle *existing) {
+    if (existing == NULL || existing->connection == NULL) {
+        return NULL;
+    }
+
+    ProSSHLibSSHHandle *handle = prossh_handle_alloc();
+    if (handle == NULL) {
+        return NULL;
+    }
+
+    prossh_lock_handle(existing);
+    if (existing->session == NULL || existing->closing != 0 || ssh_is_connected(existing->session) == 0) {
+        prossh_unlock_handle(existing);
+        prossh_handle_free(handle);
+        return NULL;
+    }
+    handle->connection = existing->connection;
+    handle->session = existing->session;
+    handle->connection->handle_count += 1;
+    handle->connection->session_users += 1;
+    prossh_unlock_handle(existing);
+    return handle;
+}
+
+int prossh_libssh_is_connected(ProSSHLibSSHHandle *handle) {
+    if (handle == NULL || handle->session == NULL) {
+        return 0;
+    }
+
+    prossh_lock_handle(handle);
+    int connected = handle->session != NULL && handle->closing == 0 && ssh_is_connected(handle->session) != 0;
+    prossh_unlock_handle(handle);
+    return connected;
 }
 
 static void prossh_libssh_channel_close_unlocked(ProSSHLibSSHHandle *handle) {
@@ -1503,9 +2536,42 @@ static void prossh_libssh_channel_close_unlocked(ProSSHLibSSHHandle *handle) {
     ssh_channel_close(handle->channel);
     ssh_channel_free(handle->channel);
     handle->channel = NULL;
+
+    // Input queued for this channel must not leak into a reopened shell.
+    pthread_mutex_lock(&handle->write_mutex);
+    handle->write_queues[PROSSH_WRITE_INTERACTIVE].head = 0;
+    handle->write_queues[PROSSH_WRITE_INTERACTIVE].len = 0;
+    handle->write_queues[PROSSH_WRITE_BULK].head = 0;
+    handle->write_queues[PROSSH_WRITE_BULK].len = 0;
+    pthread_mutex_unlock(&handle->write_mutex);
+}
+
+// Keepalive probes
+//
+// Any packet in either direction since the last call already proves the path
+// and refreshes NAT state, so only a silent connection gets a probe. The probe
+// is SSH_MSG_IGNORE, which the server never answers; liveness comes from TCP
+// instead. TCP_RXT_CONNDROPTIME makes the kernel drop the connection once the
+// probe has gone unacknowledged for dead_peer_timeout_s, and the I/O loop then
+// wakes every reader with the error, so a dead peer surfaces without polling.
+static void prossh_apply_keepalive_drop_time_locked(ProSSHConnection *connection, ssh_session session, int seconds) {
+    if (seconds <= 0 || connection->keepalive_drop_s == seconds) {
+        return;
+    }
+#ifdef TCP_RXT_CONNDROPTIME
+    socket_t fd = ssh_get_fd(session);
+    // Jump targets ride a local socket pair, where this fails harmlessly; the
+    // bastion's own socket carries the real path.
+    if (fd != SSH_INVALID_SOCKET) {
+        (void)setsockopt(fd, IPPROTO_TCP, TCP_RXT_CONNDROPTIME, &seconds, sizeof(seconds));
+    }
+#else
+    (void)session;
+#endif
+    connection->keepalive_drop_s = seconds;
 }
 
-int prossh_libssh_send_keepalive(ProSSHLibSSHHandle *handle) {
+int prossh_libssh_send_keepalive(ProSSHLibSSHHandle *handle, int dead_peer_timeout_s) {
     if (handle == NULL || handle->session == NULL) {
         return -1;
     }
@@ -1521,7 +2587,17 @@ int prossh_libssh_send_keepalive(ProSSHLibSSHHandle *handle) {
         return -2;
     }
 
-    int result = ssh_send_ignore(handle->session, "") == SSH_OK ? 0 : -2;
+    ProSSHConnection *connection = handle->connection;
+    prossh_apply_keepalive_drop_time_locked(connection, handle->session, dead_peer_timeout_s);
+
+    int result = 1;
+    if (connection->raw_counter.in_packets == connection->keepalive_in_packets &&
+        connection->raw_counter.out_packets == connection->keepalive_out_packets) {
+        result = ssh_send_ignore(handle->session, "") == SSH_OK ? 0 : -2;
+    }
+    // Taken after the probe so it does not count as traffic next time.
+    connection->keepalive_in_packets = connection->raw_counter.in_packets;
+    connection->keepalive_out_packets = connection->raw_counter.out_packets;
     prossh_unlock_handle(handle);
     return result;
 }
@@ -1534,35 +2610,342 @@ void prossh_libssh_channel_close(ProSSHLibSSHHandle *handle) {
     prossh_lock_handle(handle);
     prossh_libssh_channel_close_unlocked(handle);
     prossh_unlock_handle(handle);
+    prossh_io_notify(handle);
 }
 
-void prossh_libssh_disconnect(ProSSHLibSSHHandle *handle) {
-    if (handle == NULL) {
-        return;
+// Remote (-R) forwarding
+//
+// tcpip-forward asks the server to listen; each connection it accepts arrives
+// as a forwarded-tcpip channel open while some reader of the session is
+// processing packets. The session callback below takes it (session_mutex is
+// already held there), queues it on the matching listener, and the caller's
+// prossh_note_inbound_progress wakes the readiness signal. Accepting is a
+// dequeue driven by that signal, so no task polls the session on a timer.
+static void prossh_pending_remote_free_locked(ProSSHRemoteForward *forward, int session_alive) {
+    ProSSHPendingRemoteChannel *pending = forward->pending_head;
+    while (pending != NULL) {
+        ProSSHPendingRemoteChannel *next = pending->next;
+        if (session_alive && pending->channel != NULL) {
+            ssh_channel_close(pending->channel);
+            ssh_channel_free(pending->channel);
+        }
+        free(pending);
+        pending = next;
     }
+    forward->pending_head = NULL;
+    forward->pending_tail = NULL;
+}
 
-    prossh_lock_handle(handle);
-    prossh_libssh_channel_close_unlocked(handle);
+static void prossh_remote_forward_unlink_locked(ProSSHConnection *connection, ProSSHRemoteForward *forward) {
+    ProSSHRemoteForward **link = &connection->remote_forwards;
+    while (*link != NULL && *link != forward) {
+        link = &(*link)->next;
+    }
+    if (*link == forward) {
+        *link = forward->next;
+    }
+    forward->next = NULL;
+}
 
-    if (handle->session != NULL) {
-        ssh_disconnect(handle->session);
-        ssh_free(handle->session);
-        handle->session = NULL;
+// Called on disconnect. Like forward channels, the wrappers stay allocated for
+// their Swift owners; only the link to the handle is cut.
+static void prossh_remote_forwards_detach_locked(ProSSHLibSSHHandle *handle, int last_user) {
+    ProSSHConnection *connection = handle->connection;
+    ProSSHRemoteForward *forward = connection->remote_forwards;
+    while (forward != NULL) {
+        ProSSHRemoteForward *next = forward->next;
+        if (forward->owner == handle) {
+            // ssh_free releases the queued channels along with the session.
+            prossh_pending_remote_free_locked(forward, !last_user);
+            prossh_remote_forward_unlink_locked(connection, forward);
+            forward->owner = NULL;
+        }
+        forward = next;
     }
-    prossh_unlock_handle(handle);
 }
 
-void prossh_libssh_destroy(ProSSHLibSSHHandle *handle) {
+static ssh_channel prossh_remote_forward_open_cb(
+    ssh_session session,
+    const char *destination_address,
+    int destination_port,
+    const char *originator_address,
+    int originator_port,
+    void *userdata
+) {
+    (void)destination_address;
+    (void)originator_address;
+    (void)originator_port;
+    ProSSHConnection *connection = (ProSSHConnection *)userdata;
+    ProSSHRemoteForward *forward = connection->remote_forwards;
+    while (forward != NULL && (forward->owner == NULL || (int)forward->bound_port != destination_port)) {
+        forward = forward->next;
+    }
+    if (forward == NULL) {
+        return NULL;
+    }
+
+    ProSSHPendingRemoteChannel *pending = (ProSSHPendingRemoteChannel *)calloc(1, sizeof(ProSSHPendingRemoteChannel));
+    if (pending == NULL) {
+        return NULL;
+    }
+    pending->channel = ssh_channel_new(session);
+    if (pending->channel == NULL) {
+        free(pending);
+        return NULL;
+    }
+    if (forward->pending_tail != NULL) {
+        forward->pending_tail->next = pending;
+    } else {
+        forward->pending_head = pending;
+    }
+    forward->pending_tail = pending;
+    return pending->channel;
+}
+
+ProSSHRemoteForward *prossh_remote_forward_listen(
+    ProSSHLibSSHHandle *handle,
+    const char *address,
+    uint16_t port,
+    char *error_buffer,
+    size_t error_buffer_len
+) {
+    if (handle == NULL || handle->session == NULL) {
+        prossh_copy_string(error_buffer, error_buffer_len, "SSH session is not connected.");
+        return NULL;
+    }
+
+    ProSSHRemoteForward *forward = (ProSSHRemoteForward *)calloc(1, sizeof(ProSSHRemoteForward));
+    if (forward == NULL) {
+        prossh_copy_string(error_buffer, error_buffer_len, "Failed to allocate remote forward.");
+        return NULL;
+    }
+    const char *bind_address = (address != NULL && address[0] != '\0') ? address : "localhost";
+    forward->address = strdup(bind_address);
+    if (forward->address == NULL) {
+        free(forward);
+        prossh_copy_string(error_buffer, error_buffer_len, "Failed to allocate remote forward.");
+        return NULL;
+    }
+
+    prossh_lock_handle(handle);
+    if (handle->session == NULL) {
+        prossh_unlock_handle(handle);
+        free(forward->address);
+        free(forward);
+        prossh_copy_string(error_buffer, error_buffer_len, "SSH session is not connected.");
+        return NULL;
+    }
+
+    ProSSHConnection *connection = handle->connection;
+    if (connection->callbacks_installed == 0) {
+        memset(&connection->callbacks, 0, sizeof(connection->callbacks));
+        ssh_callbacks_init(&connection->callbacks);
+        connection->callbacks.userdata = connection;
+        connection->callbacks.channel_open_request_forwarded_tcpip_function = prossh_remote_forward_open_cb;
+        if (ssh_set_callbacks(handle->session, &connection->callbacks) != SSH_OK) {
+            prossh_unlock_handle(handle);
+            free(forward->address);
+            free(forward);
+            prossh_copy_string(error_buffer, error_buffer_len, "Failed to install remote forward callbacks.");
+            return NULL;
+        }
+        connection->callbacks_installed = 1;
+    }
+
+    // Blocks one round trip for the server's tcpip-forward reply.
+    int bound_port = 0;
+    if (ssh_channel_listen_forward(handle->session, bind_address, (int)port, &bound_port) != SSH_OK) {
+        prossh_set_error(handle, "Server refused the remote forward.", error_buffer, error_buffer_len);
+        prossh_unlock_handle(handle);
+        free(forward->address);
+        free(forward);
+        return NULL;
+    }
+
+    // The reply only carries a port when the server picked one.
+    forward->bound_port = port != 0 ? port : (uint16_t)bound_port;
+    forward->owner = handle;
+    forward->next = connection->remote_forwards;
+    connection->remote_forwards = forward;
+    prossh_unlock_handle(handle);
+    return forward;
+}
+
+uint16_t prossh_remote_forward_bound_port(ProSSHRemoteForward *forward) {
+    return forward != NULL ? forward->bound_port : 0;
+}
+
+int prossh_remote_forward_accept(ProSSHRemoteForward *forward, ProSSHForwardChannel **accepted) {
+    if (accepted != NULL) {
+        *accepted = NULL;
+    }
+    if (forward == NULL || accepted == NULL) {
+        return -1;
+    }
+
+    ProSSHLibSSHHandle *owner = forward->owner;
+    prossh_lock_handle(owner);
+    if (owner == NULL || forward->owner == NULL || owner->session == NULL) {
+        prossh_unlock_handle(owner);
+        return -1;
+    }
+
+    ProSSHPendingRemoteChannel *pending = forward->pending_head;
+    uint64_t packets_before = prossh_inbound_packets(owner);
+    if (pending == NULL && owner->channel != NULL) {
+        // Channel readers normally process the open for us; with no shell or
+        // forward reading, polling the shell channel does it without blocking.
+        ssh_channel_poll(owner->channel, 0);
+        pending = forward->pending_head;
+    }
+    if (pending == NULL) {
+        prossh_unlock_handle(owner);
+        prossh_note_inbound_progress(owner, packets_before);
+        return 0;
+    }
+
+    ProSSHForwardChannel *fwd = (ProSSHForwardChannel *)calloc(1, sizeof(ProSSHForwardChannel));
+    if (fwd == NULL) {
+        // Leave it queued; the next accept retries.
+        prossh_unlock_handle(owner);
+        return 0;
+    }
+
+    forward->pending_head = pending->next;
+    if (forward->pending_head == NULL) {
+        forward->pending_tail = NULL;
+    }
+    fwd->channel = pending->channel;
+    fwd->owner = owner;
+    fwd->next = owner->forwards;
+    owner->forwards = fwd;
+    ssh_channel_set_blocking(fwd->channel, 0);
+    free(pending);
+    prossh_unlock_handle(owner);
+    prossh_note_inbound_progress(owner, packets_before);
+
+    *accepted = fwd;
+    return 1;
+}
+
+void prossh_remote_forward_close(ProSSHRemoteForward *forward) {
+    if (forward == NULL) {
+        return;
+    }
+
+    ProSSHLibSSHHandle *owner = forward->owner;
+    prossh_lock_handle(owner);
+    if (owner != NULL && forward->owner != NULL && owner->session != NULL) {
+        prossh_remote_forward_unlink_locked(owner->connection, forward);
+        prossh_pending_remote_free_locked(forward, 1);
+        ssh_channel_cancel_forward(owner->session, forward->address, (int)forward->bound_port);
+    }
+    prossh_unlock_handle(owner);
+
+    free(forward->address);
+    free(forward);
+}
+
+void prossh_libssh_disconnect(ProSSHLibSSHHandle *handle) {
+    if (handle == NULL) {
+        return;
+    }
+
+    ProSSHConnection *connection = handle->connection;
+    prossh_lock_handle(handle);
+    if (handle->session == NULL) {
+        prossh_unlock_handle(handle);
+        return;
+    }
+
+    // Let in-flight SFTP transfers unwind while the session they use still exists.
+    handle->closing = 1;
+    pthread_cond_broadcast(&connection->bulk_cond);
+    while (handle->bulk_active > 0) {
+        pthread_cond_wait(&connection->bulk_cond, &connection->session_mutex);
+    }
+    handle->closing = 0;
+
+    prossh_libssh_channel_close_unlocked(handle);
+
+    // Only the last handle on the connection tears the session down; the others
+    // just give back their own channels.
+    int last_user = connection->session_users <= 1;
+    ProSSHForwardChannel *fwd = handle->forwards;
+    while (fwd != NULL) {
+        ProSSHForwardChannel *next = fwd->next;
+        // ssh_free releases every channel of the session. Either way, detach the
+        // wrapper so later reads fail cleanly instead of touching a freed channel.
+        if (!last_user && fwd->channel != NULL) {
+            ssh_channel_close(fwd->channel);
+            ssh_channel_free(fwd->channel);
+        }
+        fwd->channel = NULL;
+        fwd->owner = NULL;
+        fwd->next = NULL;
+        fwd = next;
+    }
+    handle->forwards = NULL;
+    prossh_remote_forwards_detach_locked(handle, last_user);
+
+    if (last_user) {
+        prossh_io_detach_fd(connection);
+        prossh_sftp_release_locked(handle);
+        ssh_disconnect(handle->session);
+        ssh_free(handle->session);
+        if (connection->jump_tunnel != NULL) {
+            prossh_jump_tunnel_release(connection->jump_tunnel);
+            connection->jump_tunnel = NULL;
+        }
+    }
+    connection->session_users -= 1;
+    handle->session = NULL;
+    prossh_unlock_handle(handle);
+    prossh_io_notify(handle);
+}
+
+void prossh_libssh_destroy(ProSSHLibSSHHandle *handle) {
     if (handle == NULL) {
         return;
     }
 
     prossh_libssh_disconnect(handle);
-    if (handle->session_mutex_initialized != 0) {
-        pthread_mutex_destroy(&handle->session_mutex);
-        handle->session_mutex_initialized = 0;
+    prossh_io_loop_unregister(handle);
+
+    ProSSHConnection *connection = handle->connection;
+    if (connection != NULL) {
+        pthread_mutex_lock(&connection->session_mutex);
+        connection->handle_count -= 1;
+        int last_handle = connection->handle_count == 0;
+        pthread_mutex_unlock(&connection->session_mutex);
+        handle->connection = NULL;
+        if (last_handle) {
+            prossh_connection_free(connection);
+        }
     }
-    free(handle);
+    prossh_handle_free(handle);
+}
+
+// A shared handle rides on another handle's session; it cannot dial its own.
+static int prossh_begin_fresh_session(ProSSHLibSSHHandle *handle, char *error_buffer, size_t error_buffer_len) {
+    prossh_libssh_disconnect(handle);
+
+    pthread_mutex_lock(&handle->connection->session_mutex);
+    int shared = handle->connection->handle_count > 1;
+    pthread_mutex_unlock(&handle->connection->session_mutex);
+    if (shared) {
+        prossh_copy_string(error_buffer, error_buffer_len, "Handle is attached to a shared connection.");
+        return -1;
+    }
+
+    handle->session = ssh_new();
+    if (handle->session == NULL) {
+        prossh_copy_string(error_buffer, error_buffer_len, "Failed to allocate libssh session.");
+        return -1;
+    }
+    handle->connection->session_users = 1;
+    prossh_attach_counters(handle);
+    return 0;
 }
 
 int prossh_libssh_connect(
@@ -1574,6 +2957,7 @@ int prossh_libssh_connect(
     const char *ciphers,
     const char *hostkeys,
     const char *macs,
+    const char *compression,
     int timeout_seconds,
     char *error_buffer,
     size_t error_buffer_len
@@ -1583,11 +2967,7 @@ int prossh_libssh_connect(
         return -1;
     }
 
-    prossh_libssh_disconnect(handle);
-
-    handle->session = ssh_new();
-    if (handle->session == NULL) {
-        prossh_copy_string(error_buffer, error_buffer_len, "Failed to allocate libssh session.");
+    if (prossh_begin_fresh_session(handle, error_buffer, error_buffer_len) != 0) {
         return -1;
     }
 
@@ -1600,6 +2980,7 @@ int prossh_libssh_connect(
             ciphers,
             hostkeys,
             macs,
+            compression,
             timeout_seconds,
             error_buffer,
             error_buffer_len
@@ -1607,6 +2988,18 @@ int prossh_libssh_connect(
         return -1;
     }
 
+    int fd = prossh_tcp_connect_racing(hostname, port, timeout_seconds, error_buffer, error_buffer_len);
+    if (fd < 0) {
+        return -2;
+    }
+    // libssh owns the socket from here and closes it with the session.
+    socket_t session_fd = (socket_t)fd;
+    if (ssh_options_set(handle->session, SSH_OPTIONS_FD, &session_fd) != SSH_OK) {
+        close(fd);
+        prossh_set_error(handle, "Failed to hand connected socket to libssh", error_buffer, error_buffer_len);
+        return -1;
+    }
+
     if (ssh_connect(handle->session) != SSH_OK) {
         prossh_set_error(handle, "SSH connection failed", error_buffer, error_buffer_len);
         return -2;
@@ -1741,8 +3134,8 @@ static int prossh_jump_authenticate(ssh_session session, void *userdata) {
     }
 
     struct ProSSHLibSSHHandle jump_handle;
+    memset(&jump_handle, 0, sizeof(jump_handle));
     jump_handle.session = session;
-    jump_handle.channel = NULL;
 
     char auth_error[512];
     memset(auth_error, 0, sizeof(auth_error));
@@ -1773,155 +3166,706 @@ static int prossh_jump_authenticate(ssh_session session, void *userdata) {
     return 0;
 }
 
-int prossh_libssh_connect_with_jump(
-    ProSSHLibSSHHandle *handle,
-    const char *hostname,
-    uint16_t port,
-    const char *username,
-    const char *kex,
-    const char *ciphers,
-    const char *hostkeys,
-    const char *macs,
-    int timeout_seconds,
-    ProSSHJumpHostConfig *jump_config,
-    char *error_buffer,
-    size_t error_buffer_len
-) {
-    if (handle == NULL || hostname == NULL || username == NULL || jump_config == NULL) {
-        prossh_copy_string(error_buffer, error_buffer_len, "Invalid connection parameters.");
-        return -1;
-    }
+// Shared jump host (bastion) sessions
+//
+// libssh's ProxyJump builds a fresh bastion session inside every ssh_connect,
+// so each host behind a bastion paid its handshake again. A ProSSHJumpSession
+// keeps one verified, authenticated bastion connection and opens a direct-tcpip
+// channel on it per target. Each channel is bridged to a socketpair with libssh
+// connectors; the target session gets the other end through SSH_OPTIONS_FD and
+// runs its own KEX and auth end-to-end as before. One pump thread per bastion
+// drives ssh_event_dopoll for all of its tunnels; other threads take a turn on
+// the bastion lock the same way interactive callers preempt bulk SFTP work.
+// The bastion lives while the Swift cache or any tunnel holds a reference.
+
+struct ProSSHJumpTunnel {
+    ProSSHJumpSession *jump;
+    ssh_channel channel;
+    socket_t fd;
+    ssh_connector to_channel;
+    ssh_connector from_channel;
+    int eof_forwarded;
+    int released;
+    ProSSHJumpTunnel *next;
+};
 
-    if (jump_config->jump_hostname == NULL || jump_config->jump_username == NULL) {
-        prossh_copy_string(error_buffer, error_buffer_len, "Invalid jump host parameters.");
-        return -1;
-    }
+struct ProSSHJumpSession {
+    pthread_mutex_t mutex;
+    pthread_cond_t turn_cond;
+    atomic_int waiters;
+    atomic_int refs;
+    atomic_int alive;
+    int stopping;
+    ssh_session session;
+    ssh_event event;
+    int wake_pipe[2];
+    ProSSHJumpTunnel *tunnels;
+};
 
-    prossh_libssh_disconnect(handle);
+static void prossh_jump_wake(ProSSHJumpSession *jump) {
+    char byte = 1;
+    ssize_t ignored = write(jump->wake_pipe[1], &byte, 1);
+    (void)ignored;
+}
 
-    handle->session = ssh_new();
-    if (handle->session == NULL) {
-        prossh_copy_string(error_buffer, error_buffer_len, "Failed to allocate libssh session.");
-        return -1;
+static int prossh_jump_wake_drain(socket_t fd, int revents, void *userdata) {
+    (void)revents;
+    (void)userdata;
+    char buffer[64];
+    while (read(fd, buffer, sizeof(buffer)) > 0) {
     }
+    return 0;
+}
 
-    if (prossh_apply_options(
-            handle, hostname, port, username,
-            kex, ciphers, hostkeys, macs,
-            timeout_seconds, error_buffer, error_buffer_len
-        ) != 0) {
-        return -1;
-    }
+// Interrupts the pump's poll and waits for it to hand over the bastion.
+static void prossh_jump_lock(ProSSHJumpSession *jump) {
+    atomic_fetch_add_explicit(&jump->waiters, 1, memory_order_relaxed);
+    prossh_jump_wake(jump);
+    pthread_mutex_lock(&jump->mutex);
+    atomic_fetch_sub_explicit(&jump->waiters, 1, memory_order_relaxed);
+}
 
-    char proxy_jump_str[512];
-    snprintf(proxy_jump_str, sizeof(proxy_jump_str), "%s@%s:%u",
-            jump_config->jump_username,
-            jump_config->jump_hostname,
-            (unsigned int)jump_config->jump_port);
+static void prossh_jump_unlock(ProSSHJumpSession *jump) {
+    pthread_cond_broadcast(&jump->turn_cond);
+    pthread_mutex_unlock(&jump->mutex);
+}
 
-    if (ssh_options_set(handle->session, SSH_OPTIONS_PROXYJUMP, proxy_jump_str) != SSH_OK) {
-        prossh_set_error(handle, "Failed to set ProxyJump option", error_buffer, error_buffer_len);
-        return -1;
+static void prossh_jump_tunnel_stop_io_locked(ProSSHJumpTunnel *tunnel) {
+    ProSSHJumpSession *jump = tunnel->jump;
+    if (tunnel->to_channel != NULL) {
+        ssh_event_remove_connector(jump->event, tunnel->to_channel);
+        ssh_connector_free(tunnel->to_channel);
+        tunnel->to_channel = NULL;
     }
+    if (tunnel->from_channel != NULL) {
+        ssh_event_remove_connector(jump->event, tunnel->from_channel);
+        ssh_connector_free(tunnel->from_channel);
+        tunnel->from_channel = NULL;
+    }
+    // Removing a channel connector takes the session out of the event; keep it
+    // polled for the remaining tunnels and for the server's keepalives.
+    if (atomic_load_explicit(&jump->alive, memory_order_relaxed) != 0) {
+        ssh_event_add_session(jump->event, jump->session);
+    }
+    if (tunnel->channel != NULL) {
+        ssh_channel_close(tunnel->channel);
+        ssh_channel_free(tunnel->channel);
+        tunnel->channel = NULL;
+    }
+    if (tunnel->fd != SSH_INVALID_SOCKET) {
+        close(tunnel->fd);
+        tunnel->fd = SSH_INVALID_SOCKET;
+    }
+}
 
-    memset(jump_config->actual_fingerprint, 0, sizeof(jump_config->actual_fingerprint));
-    memset(jump_config->callback_error, 0, sizeof(jump_config->callback_error));
-    jump_config->verify_result = 0;
-    jump_config->auth_result = 0;
-
-    struct ssh_jump_callbacks_struct jump_cb;
-    memset(&jump_cb, 0, sizeof(jump_cb));
-    jump_cb.userdata = jump_config;
-    jump_cb.before_connection = prossh_jump_before_connection;
-    jump_cb.verify_knownhost = prossh_jump_verify_knownhost;
-    jump_cb.authenticate = prossh_jump_authenticate;
+// Frees tunnels whose target session is gone and forwards channel EOF to the
+// target side. Returns with the lock held.
+static void prossh_jump_reap_locked(ProSSHJumpSession *jump) {
+    ProSSHJumpTunnel **link = &jump->tunnels;
+    while (*link != NULL) {
+        ProSSHJumpTunnel *tunnel = *link;
+        if (tunnel->released != 0) {
+            *link = tunnel->next;
+            prossh_jump_tunnel_stop_io_locked(tunnel);
+            free(tunnel);
+            if (atomic_fetch_sub_explicit(&jump->refs, 1, memory_order_acq_rel) == 1) {
+                jump->stopping = 1;
+            }
+            continue;
+        }
+        if (tunnel->eof_forwarded == 0 && tunnel->channel != NULL &&
+            (ssh_channel_is_eof(tunnel->channel) != 0 || ssh_channel_is_closed(tunnel->channel) != 0)) {
+            shutdown(tunnel->fd, SHUT_WR);
+            tunnel->eof_forwarded = 1;
+        }
+        link = &tunnel->next;
+    }
+}
 
-    if (ssh_options_set(handle->session, SSH_OPTIONS_PROXYJUMP_CB_LIST_APPEND, &jump_cb) != SSH_OK) {
-        prossh_set_error(handle, "Failed to set ProxyJump callbacks", error_buffer, error_buffer_len);
-        return -1;
+static void prossh_jump_free(ProSSHJumpSession *jump) {
+    if (jump->event != NULL) {
+        ssh_event_remove_fd(jump->event, jump->wake_pipe[0]);
+        ssh_event_free(jump->event);
     }
+    if (jump->session != NULL) {
+        ssh_disconnect(jump->session);
+        ssh_free(jump->session);
+    }
+    close(jump->wake_pipe[0]);
+    close(jump->wake_pipe[1]);
+    pthread_cond_destroy(&jump->turn_cond);
+    pthread_mutex_destroy(&jump->mutex);
+    free(jump);
+}
 
-    if (ssh_connect(handle->session) != SSH_OK) {
-        if (jump_config->callback_error[0] != '\0') {
-            prossh_copy_string(error_buffer, error_buffer_len, jump_config->callback_error);
-        } else {
-            prossh_set_error(handle, "SSH connection via jump host failed", error_buffer, error_buffer_len);
-        }
+static void *prossh_jump_pump_main(void *argument) {
+    ProSSHJumpSession *jump = (ProSSHJumpSession *)argument;
 
-        if (jump_config->verify_result == -2) {
-            return -10;
+    pthread_mutex_lock(&jump->mutex);
+    while (1) {
+        while (atomic_load_explicit(&jump->waiters, memory_order_relaxed) > 0) {
+            pthread_cond_wait(&jump->turn_cond, &jump->mutex);
         }
-        if (jump_config->verify_result == -3) {
-            return -11;
+        prossh_jump_reap_locked(jump);
+        if (jump->stopping != 0 && jump->tunnels == NULL) {
+            break;
         }
-        if (jump_config->auth_result != 0) {
-            return -12;
+
+        if (atomic_load_explicit(&jump->alive, memory_order_relaxed) == 0) {
+            // Nothing left to pump; wait for targets to release their tunnels.
+            pthread_cond_wait(&jump->turn_cond, &jump->mutex);
+            continue;
         }
 
-        return -2;
+        if (ssh_event_dopoll(jump->event, 1000) == SSH_ERROR || ssh_is_connected(jump->session) == 0) {
+            atomic_store_explicit(&jump->alive, 0, memory_order_relaxed);
+            // Close the target ends so their sessions fail now instead of at
+            // their next timeout.
+            for (ProSSHJumpTunnel *tunnel = jump->tunnels; tunnel != NULL; tunnel = tunnel->next) {
+                prossh_jump_tunnel_stop_io_locked(tunnel);
+            }
+        }
     }
+    pthread_mutex_unlock(&jump->mutex);
 
-    return 0;
+    prossh_jump_free(jump);
+    return NULL;
 }
 
-int prossh_libssh_authenticate(
-    ProSSHLibSSHHandle *handle,
-    ProSSHAuthMethod auth_method,
-    const char *password,
-    const char *private_key,
-    const char *certificate,
-    const char *key_passphrase,
+ProSSHJumpSession *prossh_jump_session_open(
+    ProSSHJumpHostConfig *config,
+    int *status,
     char *error_buffer,
     size_t error_buffer_len
 ) {
-    if (handle == NULL || handle->session == NULL) {
-        prossh_copy_string(error_buffer, error_buffer_len, "SSH session is not connected.");
-        return -1;
+    int ignored_status = 0;
+    if (status == NULL) {
+        status = &ignored_status;
     }
+    *status = -1;
 
-    if (prossh_authenticate(
-            handle,
-            auth_method,
-            password,
-            private_key,
-            certificate,
-            key_passphrase,
-            error_buffer,
-            error_buffer_len
-        ) != 0) {
-        return -3;
+    if (config == NULL || config->jump_hostname == NULL || config->jump_username == NULL) {
+        prossh_copy_string(error_buffer, error_buffer_len, "Invalid jump host parameters.");
+        return NULL;
     }
 
-    return 0;
-}
+    memset(config->actual_fingerprint, 0, sizeof(config->actual_fingerprint));
+    memset(config->callback_error, 0, sizeof(config->callback_error));
+    config->verify_result = 0;
+    config->auth_result = 0;
 
-int prossh_libssh_get_negotiated(
-    ProSSHLibSSHHandle *handle,
-    char *kex_buffer,
-    size_t kex_buffer_len,
-    char *cipher_buffer,
-    size_t cipher_buffer_len,
-    char *hostkey_buffer,
-    size_t hostkey_buffer_len,
-    char *fingerprint_buffer,
-    size_t fingerprint_buffer_len
-) {
-    if (handle == NULL || handle->session == NULL) {
-        return -1;
+    ssh_session session = ssh_new();
+    if (session == NULL) {
+        prossh_copy_string(error_buffer, error_buffer_len, "Failed to allocate libssh session.");
+        return NULL;
     }
 
-    prossh_copy_string(kex_buffer, kex_buffer_len, ssh_get_kex_algo(handle->session));
-    prossh_copy_string(cipher_buffer, cipher_buffer_len, ssh_get_cipher_in(handle->session));
+    int numeric_port = (int)config->jump_port;
+    if (ssh_options_set(session, SSH_OPTIONS_HOST, config->jump_hostname) != SSH_OK ||
+        ssh_options_set(session, SSH_OPTIONS_PORT, &numeric_port) != SSH_OK ||
+        ssh_options_set(session, SSH_OPTIONS_USER, config->jump_username) != SSH_OK) {
+        prossh_copy_string(error_buffer, error_buffer_len, "Jump host: failed to set connection options");
+        ssh_free(session);
+        return NULL;
+    }
+    if (prossh_jump_before_connection(session, config) != 0) {
+        prossh_copy_string(error_buffer, error_buffer_len, config->callback_error);
+        ssh_free(session);
+        return NULL;
+    }
 
-    ssh_key server_key = NULL;
-    if (ssh_get_server_publickey(handle->session, &server_key) == SSH_OK && server_key != NULL) {
-        enum ssh_keytypes_e key_type = ssh_key_type(server_key);
-        const char *key_name = ssh_key_type_to_char(key_type);
-        prossh_copy_string(hostkey_buffer, hostkey_buffer_len, key_name);
+    int fd = prossh_tcp_connect_racing(
+        config->jump_hostname,
+        config->jump_port,
+        config->timeout_seconds,
+        error_buffer,
+        error_buffer_len
+    );
+    if (fd < 0) {
+        *status = -2;
+        ssh_free(session);
+        return NULL;
+    }
+    socket_t session_fd = (socket_t)fd;
+    if (ssh_options_set(session, SSH_OPTIONS_FD, &session_fd) != SSH_OK) {
+        close(fd);
+        prossh_copy_string(error_buffer, error_buffer_len, "Jump host: failed to hand connected socket to libssh");
+        ssh_free(session);
+        return NULL;
+    }
 
-        unsigned char *hash = NULL;
-        size_t hash_len = 0;
-        if (ssh_get_publickey_hash(server_key, SSH_PUBLICKEY_HASH_SHA256, &hash, &hash_len) == SSH_OK &&
+    if (ssh_connect(session) != SSH_OK) {
+        char message[512];
+        snprintf(message, sizeof(message), "Jump host connection failed: %s", ssh_get_error(session));
+        prossh_copy_string(error_buffer, error_buffer_len, message);
+        *status = -2;
+        ssh_free(session);
+        return NULL;
+    }
+
+    if (prossh_jump_verify_knownhost(session, config) != 0) {
+        prossh_copy_string(error_buffer, error_buffer_len, config->callback_error);
+        *status = config->verify_result == -3 ? -11 : -10;
+        ssh_disconnect(session);
+        ssh_free(session);
+        return NULL;
+    }
+
+    if (prossh_jump_authenticate(session, config) != 0) {
+        prossh_copy_string(error_buffer, error_buffer_len, config->callback_error);
+        *status = -12;
+        ssh_disconnect(session);
+        ssh_free(session);
+        return NULL;
+    }
+
+    ProSSHJumpSession *jump = (ProSSHJumpSession *)calloc(1, sizeof(ProSSHJumpSession));
+    if (jump == NULL) {
+        ssh_disconnect(session);
+        ssh_free(session);
+        prossh_copy_string(error_buffer, error_buffer_len, "Failed to allocate jump host session.");
+        return NULL;
+    }
+    jump->session = session;
+    jump->wake_pipe[0] = -1;
+    jump->wake_pipe[1] = -1;
+    atomic_init(&jump->waiters, 0);
+    atomic_init(&jump->refs, 1);
+    atomic_init(&jump->alive, 1);
+
+    int ready = pthread_mutex_init(&jump->mutex, NULL) == 0;
+    if (ready && pthread_cond_init(&jump->turn_cond, NULL) != 0) {
+        pthread_mutex_destroy(&jump->mutex);
+        ready = 0;
+    }
+    if (!ready) {
+        ssh_disconnect(session);
+        ssh_free(session);
+        free(jump);
+        prossh_copy_string(error_buffer, error_buffer_len, "Failed to initialize jump host session.");
+        return NULL;
+    }
+
+    jump->event = ssh_event_new();
+    if (pipe(jump->wake_pipe) != 0 || jump->event == NULL) {
+        prossh_jump_free(jump);
+        prossh_copy_string(error_buffer, error_buffer_len, "Failed to initialize jump host event loop.");
+        return NULL;
+    }
+    for (int i = 0; i < 2; i++) {
+        int flags = fcntl(jump->wake_pipe[i], F_GETFL, 0);
+        fcntl(jump->wake_pipe[i], F_SETFL, flags | O_NONBLOCK);
+    }
+    if (ssh_event_add_fd(jump->event, jump->wake_pipe[0], POLLIN, prossh_jump_wake_drain, NULL) != SSH_OK ||
+        ssh_event_add_session(jump->event, session) != SSH_OK) {
+        prossh_jump_free(jump);
+        prossh_copy_string(error_buffer, error_buffer_len, "Failed to initialize jump host event loop.");
+        return NULL;
+    }
+
+    pthread_attr_t attributes;
+    pthread_attr_init(&attributes);
+    pthread_attr_setdetachstate(&attributes, PTHREAD_CREATE_DETACHED);
+    pthread_t thread;
+    int started = pthread_create(&thread, &attributes, prossh_jump_pump_main, jump) == 0;
+    pthread_attr_destroy(&attributes);
+    if (!started) {
+        prossh_jump_free(jump);
+        prossh_copy_string(error_buffer, error_buffer_len, "Failed to start jump host I/O thread.");
+        return NULL;
+    }
+
+    *status = 0;
+    return jump;
+}
+
+void prossh_jump_session_retain(ProSSHJumpSession *jump) {
+    if (jump != NULL) {
+        atomic_fetch_add_explicit(&jump->refs, 1, memory_order_relaxed);
+    }
+}
+
+int prossh_jump_session_is_alive(ProSSHJumpSession *jump) {
+    return jump != NULL && atomic_load_explicit(&jump->alive, memory_order_relaxed) != 0;
+}
+
+void prossh_jump_session_release(ProSSHJumpSession *jump) {
+    if (jump == NULL) {
+        return;
+    }
+    if (atomic_fetch_sub_explicit(&jump->refs, 1, memory_order_acq_rel) != 1) {
+        return;
+    }
+    // Last reference: the pump frees the bastion once it sees `stopping`. The
+    // pump may free it as soon as the lock is dropped, so nothing touches
+    // `jump` after unlocking.
+    prossh_jump_lock(jump);
+    jump->stopping = 1;
+    prossh_jump_unlock(jump);
+}
+
+// Called by the target session's teardown after its socket end is closed.
+static void prossh_jump_tunnel_release(ProSSHJumpTunnel *tunnel) {
+    ProSSHJumpSession *jump = tunnel->jump;
+    prossh_jump_lock(jump);
+    tunnel->released = 1;
+    prossh_jump_unlock(jump);
+}
+
+static ProSSHJumpTunnel *prossh_jump_open_tunnel(
+    ProSSHJumpSession *jump,
+    const char *hostname,
+    uint16_t port,
+    socket_t *target_fd,
+    char *error_buffer,
+    size_t error_buffer_len
+) {
+    int pair[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, pair) != 0) {
+        prossh_copy_string(error_buffer, error_buffer_len, "Failed to create jump tunnel socket pair.");
+        return NULL;
+    }
+#ifdef SO_NOSIGPIPE
+    int no_sigpipe = 1;
+    setsockopt(pair[0], SOL_SOCKET, SO_NOSIGPIPE, &no_sigpipe, sizeof(no_sigpipe));
+    setsockopt(pair[1], SOL_SOCKET, SO_NOSIGPIPE, &no_sigpipe, sizeof(no_sigpipe));
+#endif
+    int flags = fcntl(pair[0], F_GETFL, 0);
+    fcntl(pair[0], F_SETFL, flags | O_NONBLOCK);
+
+    ProSSHJumpTunnel *tunnel = (ProSSHJumpTunnel *)calloc(1, sizeof(ProSSHJumpTunnel));
+    if (tunnel == NULL) {
+        close(pair[0]);
+        close(pair[1]);
+        prossh_copy_string(error_buffer, error_buffer_len, "Failed to allocate jump tunnel.");
+        return NULL;
+    }
+    tunnel->jump = jump;
+    tunnel->fd = pair[0];
+
+    prossh_jump_lock(jump);
+    if (atomic_load_explicit(&jump->alive, memory_order_relaxed) == 0 || jump->stopping != 0) {
+        prossh_jump_unlock(jump);
+        prossh_copy_string(error_buffer, error_buffer_len, "Jump host connection lost.");
+        goto fail;
+    }
+
+    tunnel->channel = ssh_channel_new(jump->session);
+    if (tunnel->channel == NULL ||
+        ssh_channel_open_forward(tunnel->channel, hostname, (int)port, "127.0.0.1", 22) != SSH_OK) {
+        char message[512];
+        snprintf(message, sizeof(message), "Jump host could not open a channel to %s:%u: %s",
+                 hostname, (unsigned int)port, ssh_get_error(jump->session));
+        prossh_copy_string(error_buffer, error_buffer_len, message);
+        if (tunnel->channel != NULL) {
+            ssh_channel_free(tunnel->channel);
+            tunnel->channel = NULL;
+        }
+        prossh_jump_unlock(jump);
+        goto fail;
+    }
+
+    tunnel->to_channel = ssh_connector_new(jump->session);
+    tunnel->from_channel = ssh_connector_new(jump->session);
+    if (tunnel->to_channel == NULL || tunnel->from_channel == NULL) {
+        prossh_jump_tunnel_stop_io_locked(tunnel);
+        prossh_jump_unlock(jump);
+        close(pair[1]);
+        free(tunnel);
+        prossh_copy_string(error_buffer, error_buffer_len, "Failed to bridge jump tunnel.");
+        return NULL;
+    }
+    ssh_connector_set_in_fd(tunnel->to_channel, tunnel->fd);
+    ssh_connector_set_out_channel(tunnel->to_channel, tunnel->channel, SSH_CONNECTOR_STDINOUT);
+    ssh_connector_set_in_channel(tunnel->from_channel, tunnel->channel, SSH_CONNECTOR_STDINOUT);
+    ssh_connector_set_out_fd(tunnel->from_channel, tunnel->fd);
+    ssh_event_add_connector(jump->event, tunnel->to_channel);
+    ssh_event_add_connector(jump->event, tunnel->from_channel);
+
+    atomic_fetch_add_explicit(&jump->refs, 1, memory_order_relaxed);
+    tunnel->next = jump->tunnels;
+    jump->tunnels = tunnel;
+    prossh_jump_unlock(jump);
+
+    *target_fd = pair[1];
+    return tunnel;
+
+fail:
+    close(pair[0]);
+    close(pair[1]);
+    free(tunnel);
+    return NULL;
+}
+
+int prossh_libssh_connect_through_jump(
+    ProSSHLibSSHHandle *handle,
+    const char *hostname,
+    uint16_t port,
+    const char *username,
+    const char *kex,
+    const char *ciphers,
+    const char *hostkeys,
+    const char *macs,
+    const char *compression,
+    int timeout_seconds,
+    ProSSHJumpSession *jump,
+    char *error_buffer,
+    size_t error_buffer_len
+) {
+    if (handle == NULL || hostname == NULL || username == NULL || jump == NULL) {
+        prossh_copy_string(error_buffer, error_buffer_len, "Invalid connection parameters.");
+        return -1;
+    }
+
+    if (prossh_begin_fresh_session(handle, error_buffer, error_buffer_len) != 0) {
+        return -1;
+    }
+
+    if (prossh_apply_options(
+            handle, hostname, port, username,
+            kex, ciphers, hostkeys, macs, compression,
+            timeout_seconds, error_buffer, error_buffer_len
+        ) != 0) {
+        return -1;
+    }
+
+    socket_t fd = SSH_INVALID_SOCKET;
+    ProSSHJumpTunnel *tunnel = prossh_jump_open_tunnel(jump, hostname, port, &fd, error_buffer, error_buffer_len);
+    if (tunnel == NULL) {
+        return -2;
+    }
+    // Released by disconnect once the target session (and its socket end) is gone.
+    handle->connection->jump_tunnel = tunnel;
+
+    if (ssh_options_set(handle->session, SSH_OPTIONS_FD, &fd) != SSH_OK) {
+        close(fd);
+        prossh_set_error(handle, "Failed to hand jump tunnel to libssh", error_buffer, error_buffer_len);
+        return -1;
+    }
+
+    if (ssh_connect(handle->session) != SSH_OK) {
+        prossh_set_error(handle, "SSH connection via jump host failed", error_buffer, error_buffer_len);
+        return -2;
+    }
+
+    return 0;
+}
+
+int prossh_libssh_authenticate(
+    ProSSHLibSSHHandle *handle,
+    ProSSHAuthMethod auth_method,
+    const char *password,
+    const char *private_key,
+    const char *certificate,
+    const char *key_passphrase,
+    char *error_buffer,
+    size_t error_buffer_len
+) {
+    if (handle == NULL || handle->session == NULL) {
+        prossh_copy_string(error_buffer, error_buffer_len, "SSH session is not connected.");
+        return -1;
+    }
+
+    if (prossh_authenticate(
+            handle,
+            auth_method,
+            password,
+            private_key,
+            certificate,
+            key_passphrase,
+            error_buffer,
+            error_buffer_len
+        ) != 0) {
+        return -3;
+    }
+
+    return 0;
+}
+
+// Local crypto benchmark
+//
+// Times packet-sized seals with the bundled OpenSSL so the transport can order
+// its allowed ciphers and MACs by what this CPU runs fastest (AES-GCM with
+// AES-NI / ARMv8 crypto extensions, chacha20 without). Each packet gets a fresh
+// IV and, for AEADs, a length AAD and tag, as on the wire.
+// chacha20-poly1305@openssh.com is timed as the IETF AEAD, which uses the same
+// primitives.
+
+#define PROSSH_BENCH_PACKET_LEN 32768
+
+static const EVP_CIPHER *prossh_bench_cipher(const char *name, int *is_aead) {
+    *is_aead = 1;
+    if (strcmp(name, "chacha20-poly1305@openssh.com") == 0) {
+        return EVP_chacha20_poly1305();
+    }
+    if (strcmp(name, "aes256-gcm@openssh.com") == 0) {
+        return EVP_aes_256_gcm();
+    }
+    if (strcmp(name, "aes128-gcm@openssh.com") == 0) {
+        return EVP_aes_128_gcm();
+    }
+    *is_aead = 0;
+    if (strcmp(name, "aes256-ctr") == 0) {
+        return EVP_aes_256_ctr();
+    }
+    if (strcmp(name, "aes192-ctr") == 0) {
+        return EVP_aes_192_ctr();
+    }
+    if (strcmp(name, "aes128-ctr") == 0) {
+        return EVP_aes_128_ctr();
+    }
+    return NULL;
+}
+
+static const char *prossh_bench_digest(const char *name) {
+    if (strncmp(name, "hmac-sha2-256", 13) == 0) {
+        return "SHA256";
+    }
+    if (strncmp(name, "hmac-sha2-512", 13) == 0) {
+        return "SHA512";
+    }
+    if (strncmp(name, "hmac-sha1", 9) == 0) {
+        return "SHA1";
+    }
+    return NULL;
+}
+
+static int prossh_bench_seal(
+    EVP_CIPHER_CTX *context,
+    int is_aead,
+    const unsigned char *iv,
+    const unsigned char *input,
+    unsigned char *output
+) {
+    static const unsigned char aad[4] = {0, 0, 0x80, 0};
+    unsigned char tag[16];
+    int len = 0;
+    if (!is_aead) {
+        return EVP_EncryptUpdate(context, output, &len, input, PROSSH_BENCH_PACKET_LEN) == 1 ? 0 : -1;
+    }
+    return EVP_EncryptInit_ex(context, NULL, NULL, NULL, iv) == 1 &&
+           EVP_EncryptUpdate(context, NULL, &len, aad, (int)sizeof(aad)) == 1 &&
+           EVP_EncryptUpdate(context, output, &len, input, PROSSH_BENCH_PACKET_LEN) == 1 &&
+           EVP_EncryptFinal_ex(context, output + len, &len) == 1 &&
+           EVP_CIPHER_CTX_ctrl(context, EVP_CTRL_AEAD_GET_TAG, (int)sizeof(tag), tag) == 1
+        ? 0 : -1;
+}
+
+static int prossh_bench_mac(EVP_MAC_CTX *context, const unsigned char *key, const unsigned char *input) {
+    unsigned char digest[64];
+    size_t digest_len = 0;
+    return EVP_MAC_init(context, key, 32, NULL) == 1 &&
+           EVP_MAC_update(context, input, PROSSH_BENCH_PACKET_LEN) == 1 &&
+           EVP_MAC_final(context, digest, &digest_len, sizeof(digest)) == 1
+        ? 0 : -1;
+}
+
+int64_t prossh_crypto_benchmark(const char *algorithm, int duration_ms) {
+    if (algorithm == NULL || duration_ms <= 0) {
+        return -1;
+    }
+
+    int is_aead = 0;
+    const EVP_CIPHER *cipher = prossh_bench_cipher(algorithm, &is_aead);
+    const char *digest = cipher == NULL ? prossh_bench_digest(algorithm) : NULL;
+    if (cipher == NULL && digest == NULL) {
+        return -1;
+    }
+
+    unsigned char key[32];
+    unsigned char iv[16];
+    memset(key, 0x5a, sizeof(key));
+    memset(iv, 0, sizeof(iv));
+    unsigned char *input = (unsigned char *)malloc(PROSSH_BENCH_PACKET_LEN);
+    unsigned char *output = (unsigned char *)malloc(PROSSH_BENCH_PACKET_LEN + 64);
+    EVP_CIPHER_CTX *cipher_context = NULL;
+    EVP_MAC *mac = NULL;
+    EVP_MAC_CTX *mac_context = NULL;
+    int64_t rate = -1;
+
+    if (input == NULL || output == NULL) {
+        goto cleanup;
+    }
+    for (size_t i = 0; i < PROSSH_BENCH_PACKET_LEN; i++) {
+        input[i] = (unsigned char)(i * 31u);
+    }
+
+    if (cipher != NULL) {
+        cipher_context = EVP_CIPHER_CTX_new();
+        if (cipher_context == NULL || EVP_EncryptInit_ex(cipher_context, cipher, NULL, key, iv) != 1) {
+            goto cleanup;
+        }
+    } else {
+        OSSL_PARAM params[2];
+        params[0] = OSSL_PARAM_construct_utf8_string("digest", (char *)digest, 0);
+        params[1] = OSSL_PARAM_construct_end();
+        mac = EVP_MAC_fetch(NULL, "HMAC", NULL);
+        mac_context = mac != NULL ? EVP_MAC_CTX_new(mac) : NULL;
+        if (mac_context == NULL || EVP_MAC_CTX_set_params(mac_context, params) != 1) {
+            goto cleanup;
+        }
+    }
+
+    uint64_t start_ns = prossh_monotonic_ns();
+    uint64_t budget_ns = (uint64_t)duration_ms * 1000000ull;
+    uint64_t elapsed_ns = 0;
+    uint64_t bytes = 0;
+    uint32_t sequence = 0;
+    do {
+        memcpy(iv + 8, &sequence, sizeof(sequence));
+        sequence += 1;
+        int status = cipher_context != NULL
+            ? prossh_bench_seal(cipher_context, is_aead, iv, input, output)
+            : prossh_bench_mac(mac_context, key, input);
+        if (status != 0) {
+            goto cleanup;
+        }
+        bytes += PROSSH_BENCH_PACKET_LEN;
+        elapsed_ns = prossh_monotonic_ns() - start_ns;
+    } while (elapsed_ns < budget_ns);
+
+    rate = (int64_t)((double)bytes * 1e9 / (double)elapsed_ns);
+
+cleanup:
+    EVP_CIPHER_CTX_free(cipher_context);
+    EVP_MAC_CTX_free(mac_context);
+    EVP_MAC_free(mac);
+    free(output);
+    free(input);
+    return rate;
+}
+
+int prossh_libssh_get_negotiated(
+    ProSSHLibSSHHandle *handle,
+    char *kex_buffer,
+    size_t kex_buffer_len,
+    char *cipher_buffer,
+    size_t cipher_buffer_len,
+    char *mac_buffer,
+    size_t mac_buffer_len,
+    char *hostkey_buffer,
+    size_t hostkey_buffer_len,
+    char *fingerprint_buffer,
+    size_t fingerprint_buffer_len
+) {
+    if (handle == NULL || handle->session == NULL) {
+        return -1;
+    }
+
+    prossh_copy_string(kex_buffer, kex_buffer_len, ssh_get_kex_algo(handle->session));
+    prossh_copy_string(cipher_buffer, cipher_buffer_len, ssh_get_cipher_in(handle->session));
+    // AEAD ciphers authenticate themselves; libssh reports an "aead-*" MAC.
+    prossh_copy_string(mac_buffer, mac_buffer_len, ssh_get_hmac_in(handle->session));
+
+    ssh_key server_key = NULL;
+    if (ssh_get_server_publickey(handle->session, &server_key) == SSH_OK && server_key != NULL) {
+        enum ssh_keytypes_e key_type = ssh_key_type(server_key);
+        const char *key_name = ssh_key_type_to_char(key_type);
+        prossh_copy_string(hostkey_buffer, hostkey_buffer_len, key_name);
+
+        unsigned char *hash = NULL;
+        size_t hash_len = 0;
+        if (ssh_get_publickey_hash(server_key, SSH_PUBLICKEY_HASH_SHA256, &hash, &hash_len) == SSH_OK &&
             hash != NULL && hash_len > 0) {
             char *hex = ssh_get_hexa(hash, hash_len);
             if (hex != NULL) {
@@ -2090,83 +4034,248 @@ cleanup:
     return status;
 }
 
-int prossh_libssh_channel_write(
+// Queued shell writes
+//
+// A synchronous ssh_channel_write blocks with the session lock held until the
+// server's channel window takes the whole buffer, so a large paste used to
+// stall every reader on the connection. Input is now queued and written
+// by prossh_libssh_channel_flush: back-to-back keystrokes coalesce into one
+// packet, nothing is sent past the current window (the rest stays queued until
+// a window adjust arrives), and interactive bytes always go before queued bulk
+// bytes, which are written in slices so typing can cut in mid-paste.
+
+#define PROSSH_WRITE_SLICE 8192
+#define PROSSH_WRITE_QUEUE_LIMIT (16u * 1024u * 1024u)
+
+static int prossh_write_queue_append(ProSSHWriteQueue *queue, const char *input, size_t input_len) {
+    if (queue->head + queue->len + input_len > queue->capacity) {
+        if (queue->head > 0) {
+            memmove(queue->data, queue->data + queue->head, queue->len);
+            queue->head = 0;
+        }
+        if (queue->len + input_len > queue->capacity) {
+            size_t capacity = queue->capacity > 0 ? queue->capacity : 4096;
+            while (capacity < queue->len + input_len) {
+                capacity *= 2;
+            }
+            char *data = (char *)realloc(queue->data, capacity);
+            if (data == NULL) {
+                return -1;
+            }
+            queue->data = data;
+            queue->capacity = capacity;
+        }
+    }
+    memcpy(queue->data + queue->head + queue->len, input, input_len);
+    queue->len += input_len;
+    return 0;
+}
+
+static void prossh_write_queue_consume(ProSSHWriteQueue *queue, size_t count) {
+    queue->head += count;
+    queue->len -= count;
+    if (queue->len == 0) {
+        queue->head = 0;
+    }
+}
+
+int prossh_libssh_channel_enqueue(
     ProSSHLibSSHHandle *handle,
     const char *input,
     size_t input_len,
+    bool is_bulk,
     char *error_buffer,
     size_t error_buffer_len
 ) {
-    int status = 0;
-
     if (handle == NULL || handle->channel == NULL || input == NULL || input_len == 0) {
         return -1;
     }
 
-    prossh_lock_handle(handle);
-    if (handle->channel == NULL || handle->session == NULL) {
-        status = -1;
-        goto cleanup;
-    }
-
-    int written = ssh_channel_write(handle->channel, input, (uint32_t)input_len);
-    if (written == SSH_ERROR) {
-        prossh_set_error(handle, "Failed to write to shell channel.", error_buffer, error_buffer_len);
+    pthread_mutex_lock(&handle->write_mutex);
+    size_t queued = handle->write_queues[PROSSH_WRITE_INTERACTIVE].len + handle->write_queues[PROSSH_WRITE_BULK].len;
+    int status = 0;
+    if (queued + input_len > PROSSH_WRITE_QUEUE_LIMIT) {
+        prossh_copy_string(error_buffer, error_buffer_len, "Shell input queue is full.");
         status = -2;
-        goto cleanup;
+    } else if (prossh_write_queue_append(
+                   &handle->write_queues[is_bulk ? PROSSH_WRITE_BULK : PROSSH_WRITE_INTERACTIVE],
+                   input,
+                   input_len
+               ) != 0) {
+        prossh_copy_string(error_buffer, error_buffer_len, "Failed to queue shell input.");
+        status = -3;
     }
-
-    status = 0;
-
-cleanup:
-    prossh_unlock_handle(handle);
+    pthread_mutex_unlock(&handle->write_mutex);
     return status;
 }
 
-int prossh_libssh_channel_read(
+int prossh_libssh_channel_flush(
     ProSSHLibSSHHandle *handle,
-    char *output_buffer,
-    size_t output_buffer_len,
-    int *bytes_read,
-    bool *is_eof,
+    size_t *pending,
     char *error_buffer,
     size_t error_buffer_len
 ) {
     int status = 0;
+    char chunk[PROSSH_WRITE_SLICE];
 
-    if (bytes_read != NULL) {
-        *bytes_read = 0;
-    }
-    if (is_eof != NULL) {
-        *is_eof = false;
+    if (pending != NULL) {
+        *pending = 0;
     }
-
-    if (handle == NULL || handle->channel == NULL || output_buffer == NULL || output_buffer_len < 2) {
+    if (handle == NULL || handle->connection == NULL) {
         return -1;
     }
 
     prossh_lock_handle(handle);
+    uint64_t packets_before = prossh_inbound_packets(handle);
     if (handle->channel == NULL || handle->session == NULL) {
         status = -1;
         goto cleanup;
     }
 
-    int total_read = 0;
+    for (;;) {
+        uint32_t window = ssh_channel_window_size(handle->channel);
+        if (window == 0) {
+            // A window adjust may already be sitting in the socket; process
+            // inbound packets once (non-blocking) before giving up.
+            if (ssh_channel_poll(handle->channel, 0) == SSH_ERROR) {
+                prossh_set_error(handle, "Failed to write to shell channel.", error_buffer, error_buffer_len);
+                status = -2;
+                break;
+            }
+            window = ssh_channel_window_size(handle->channel);
+            if (window == 0) {
+                break;
+            }
+        }
 
-    int stdout_read = ssh_channel_read_nonblocking(
-        handle->channel,
-        output_buffer,
-        (uint32_t)(output_buffer_len - 1),
-        0
-    );
+        pthread_mutex_lock(&handle->write_mutex);
+        ProSSHWriteQueue *queue = &handle->write_queues[PROSSH_WRITE_INTERACTIVE];
+        if (queue->len == 0) {
+            queue = &handle->write_queues[PROSSH_WRITE_BULK];
+        }
+        uint64_t discards = queue->discards;
+        size_t count = queue->len;
+        if (count > sizeof(chunk)) {
+            count = sizeof(chunk);
+        }
+        if (count > window) {
+            count = window;
+        }
+        if (count > 0) {
+            memcpy(chunk, queue->data + queue->head, count);
+        }
+        pthread_mutex_unlock(&handle->write_mutex);
+        if (count == 0) {
+            break;
+        }
 
-    if (stdout_read == SSH_ERROR) {
-        prossh_set_error(handle, "Failed reading shell output.", error_buffer, error_buffer_len);
-        status = -2;
-        goto cleanup;
+        int written = ssh_channel_write(handle->channel, chunk, (uint32_t)count);
+        if (written == SSH_ERROR) {
+            prossh_set_error(handle, "Failed to write to shell channel.", error_buffer, error_buffer_len);
+            status = -2;
+            break;
+        }
+        if (written <= 0) {
+            break;
+        }
+
+        // Appends may have compacted the queue meanwhile, but its first bytes
+        // are still the ones just sent, unless a discard emptied it.
+        pthread_mutex_lock(&handle->write_mutex);
+        if (queue->discards == discards) {
+            prossh_write_queue_consume(queue, (size_t)written);
+        }
+        pthread_mutex_unlock(&handle->write_mutex);
+    }
+
+    if (pending != NULL) {
+        pthread_mutex_lock(&handle->write_mutex);
+        *pending = handle->write_queues[PROSSH_WRITE_INTERACTIVE].len + handle->write_queues[PROSSH_WRITE_BULK].len;
+        pthread_mutex_unlock(&handle->write_mutex);
+    }
+
+cleanup:
+    prossh_unlock_handle(handle);
+    prossh_note_inbound_progress(handle, packets_before);
+    return status;
+}
+
+size_t prossh_libssh_channel_queued_bulk(ProSSHLibSSHHandle *handle) {
+    if (handle == NULL) {
+        return 0;
+    }
+    pthread_mutex_lock(&handle->write_mutex);
+    size_t queued = handle->write_queues[PROSSH_WRITE_BULK].len;
+    pthread_mutex_unlock(&handle->write_mutex);
+    return queued;
+}
+
+size_t prossh_libssh_channel_discard_bulk(ProSSHLibSSHHandle *handle) {
+    if (handle == NULL) {
+        return 0;
+    }
+    pthread_mutex_lock(&handle->write_mutex);
+    ProSSHWriteQueue *queue = &handle->write_queues[PROSSH_WRITE_BULK];
+    size_t discarded = queue->len;
+    queue->head = 0;
+    queue->len = 0;
+    queue->discards += 1;
+    pthread_mutex_unlock(&handle->write_mutex);
+    return discarded;
+}
+
+int prossh_libssh_channel_read(
+    ProSSHLibSSHHandle *handle,
+    char *output_buffer,
+    size_t output_buffer_len,
+    int *bytes_read,
+    bool *is_eof,
+    char *error_buffer,
+    size_t error_buffer_len
+) {
+    int status = 0;
+
+    if (bytes_read != NULL) {
+        *bytes_read = 0;
+    }
+    if (is_eof != NULL) {
+        *is_eof = false;
+    }
+
+    if (handle == NULL || handle->channel == NULL || output_buffer == NULL || output_buffer_len < 2) {
+        return -1;
     }
 
-    if (stdout_read > 0) {
+    prossh_lock_handle(handle);
+    uint64_t packets_before = prossh_inbound_packets(handle);
+    if (handle->channel == NULL || handle->session == NULL) {
+        status = -1;
+        goto cleanup;
+    }
+
+    int total_read = 0;
+
+    // libssh re-grants the channel window itself, topping it up to a fixed
+    // 2 MiB that counts bytes still buffered unread, so output left in
+    // libssh is window the server cannot use. Keep reading while packets keep
+    // arriving so one pass empties the buffer rather than one packet's worth.
+    while ((size_t)total_read < output_buffer_len - 1) {
+        int stdout_read = ssh_channel_read_nonblocking(
+            handle->channel,
+            output_buffer + total_read,
+            (uint32_t)(output_buffer_len - 1 - (size_t)total_read),
+            0
+        );
+
+        if (stdout_read == SSH_ERROR) {
+            prossh_set_error(handle, "Failed reading shell output.", error_buffer, error_buffer_len);
+            status = -2;
+            goto cleanup;
+        }
+
+        if (stdout_read <= 0) {
+            break;
+        }
         total_read += stdout_read;
     }
 
@@ -2204,6 +4313,7 @@ int prossh_libssh_channel_read(
 
 cleanup:
     prossh_unlock_handle(handle);
+    prossh_note_inbound_progress(handle, packets_before);
     return status;
 }
 
@@ -3151,6 +5261,7 @@ int prossh_libssh_copy_public_key_to_host(
         ciphers,
         hostkeys,
         macs,
+        NULL,
         timeout_seconds,
         error_buffer,
         error_buffer_len
@@ -3235,6 +5346,7 @@ int prossh_libssh_copy_public_key_to_host(
         ciphers,
         hostkeys,
         macs,
+        NULL,
         timeout_seconds,
         error_buffer,
         error_buffer_len
@@ -3283,105 +5395,566 @@ int prossh_libssh_copy_public_key_to_host(
     return 0;
 }
 
-int prossh_libssh_sftp_list_directory(
+// Tree walk
+//
+// Breadth-first over `root_path`. Entries are handed to the callback in
+// batches with the session lock released, so a caller can start transfers for
+// one directory while the next is still being read. Symlinks are reported
+// (flagged as not regular) but never followed. libssh has
+// no asynchronous readdir; each READDIR reply already carries a server-sized
+// batch of names with their attributes, so no per-file stat is needed.
+
+#define PROSSH_SFTP_WALK_BATCH 128
+
+typedef struct {
+    char **items;
+    size_t head;
+    size_t count;
+    size_t capacity;
+} ProSSHPathQueue;
+
+static int prossh_path_queue_push(ProSSHPathQueue *queue, char *path) {
+    if (queue->head + queue->count == queue->capacity) {
+        if (queue->head > 0) {
+            memmove(queue->items, queue->items + queue->head, queue->count * sizeof(char *));
+            queue->head = 0;
+        } else {
+            size_t capacity = queue->capacity == 0 ? 16 : queue->capacity * 2;
+            char **items = (char **)realloc(queue->items, capacity * sizeof(char *));
+            if (items == NULL) {
+                return -1;
+            }
+            queue->items = items;
+            queue->capacity = capacity;
+        }
+    }
+    queue->items[queue->head + queue->count] = path;
+    queue->count += 1;
+    return 0;
+}
+
+static char *prossh_path_queue_pop(ProSSHPathQueue *queue) {
+    if (queue->count == 0) {
+        return NULL;
+    }
+    char *path = queue->items[queue->head];
+    queue->head += 1;
+    queue->count -= 1;
+    return path;
+}
+
+static void prossh_path_queue_free(ProSSHPathQueue *queue) {
+    for (size_t i = 0; i < queue->count; i++) {
+        free(queue->items[queue->head + i]);
+    }
+    free(queue->items);
+    memset(queue, 0, sizeof(*queue));
+}
+
+static char *prossh_join_remote_path(const char *directory, const char *name) {
+    size_t directory_len = strlen(directory);
+    size_t name_len = strlen(name);
+    int needs_slash = directory_len == 0 || directory[directory_len - 1] != '/';
+    char *path = (char *)malloc(directory_len + (size_t)needs_slash + name_len + 1);
+    if (path == NULL) {
+        return NULL;
+    }
+    memcpy(path, directory, directory_len);
+    if (needs_slash) {
+        path[directory_len] = '/';
+    }
+    memcpy(path + directory_len + (size_t)needs_slash, name, name_len + 1);
+    return path;
+}
+
+typedef struct {
+    ProSSHSFTPEntry entries[PROSSH_SFTP_WALK_BATCH];
+    char *paths[PROSSH_SFTP_WALK_BATCH];
+    size_t count;
+} ProSSHEntryBatch;
+
+static void prossh_entry_batch_clear(ProSSHEntryBatch *batch) {
+    for (size_t i = 0; i < batch->count; i++) {
+        free(batch->paths[i]);
+        batch->paths[i] = NULL;
+    }
+    batch->count = 0;
+}
+
+// Hands the batch to the callback with the session lock released. Returns 0 to
+// keep walking, -2 if the callback or cancel flag stopped the walk, -8 if the
+// session started disconnecting meanwhile (lock still held in every case).
+static int prossh_entry_batch_flush(
     ProSSHLibSSHHandle *handle,
-    const char *remote_path,
-    char *output_buffer,
-    size_t output_buffer_len,
-    char *error_buffer,
-    size_t error_buffer_len
+    int *previous_blocking_mode,
+    ProSSHEntryBatch *batch,
+    ProSSHSFTPEntryCallback callback,
+    void *context,
+    volatile int32_t *cancel_flag
 ) {
-    if (output_buffer != NULL && output_buffer_len > 0) {
-        output_buffer[0] = '\0';
+    int stop = 0;
+    prossh_restore_session_mode_after_sftp(handle, *previous_blocking_mode);
+    prossh_bulk_pause(handle);
+    if (batch->count > 0) {
+        stop = callback(batch->entries, batch->count, context);
     }
+    int resumed = prossh_bulk_resume(handle);
+    *previous_blocking_mode = prossh_prepare_blocking_session_for_sftp(handle);
+    prossh_entry_batch_clear(batch);
 
-    int status = 0;
-    int previous_blocking_mode = 1;
-    sftp_session sftp = NULL;
-    sftp_dir dir = NULL;
+    if (resumed != 0) {
+        return -8;
+    }
+    if (stop != 0 || (cancel_flag != NULL && *cancel_flag != 0)) {
+        return -2;
+    }
+    return 0;
+}
 
-    if (handle == NULL || handle->session == NULL || remote_path == NULL ||
-        output_buffer == NULL || output_buffer_len < 2) {
-        prossh_copy_string(error_buffer, error_buffer_len, "Invalid SFTP list parameters.");
+int prossh_libssh_sftp_walk(
+    ProSSHLibSSHHandle *handle,
+    const char *root_path,
+    bool recursive,
+    ProSSHSFTPEntryCallback callback,
+    void *context,
+    volatile int32_t *cancel_flag,
+    char *error_buffer,
+    size_t error_buffer_len
+) {
+    if (handle == NULL || handle->session == NULL || root_path == NULL || callback == NULL) {
+        prossh_copy_string(error_buffer, error_buffer_len, "Invalid SFTP walk parameters.");
         return -1;
     }
 
-    prossh_lock_handle(handle);
-    previous_blocking_mode = prossh_prepare_blocking_session_for_sftp(handle);
-    sftp = sftp_new(handle->session);
-    if (sftp == NULL) {
-        prossh_set_error(handle, "Failed to create SFTP session.", error_buffer, error_buffer_len);
-        status = -2;
-        goto cleanup;
+    ProSSHPathQueue queue;
+    memset(&queue, 0, sizeof(queue));
+    ProSSHEntryBatch *batch = (ProSSHEntryBatch *)calloc(1, sizeof(ProSSHEntryBatch));
+    char *root = strdup(root_path);
+    if (batch == NULL || root == NULL || prossh_path_queue_push(&queue, root) != 0) {
+        free(batch);
+        free(root);
+        prossh_copy_string(error_buffer, error_buffer_len, "Out of memory for SFTP walk.");
+        return -1;
     }
 
-    if (sftp_init(sftp) != SSH_OK) {
-        prossh_set_error(handle, "Failed to initialize SFTP session.", error_buffer, error_buffer_len);
-        status = -3;
-        goto cleanup;
+    if (prossh_bulk_begin(handle) != 0) {
+        prossh_path_queue_free(&queue);
+        free(batch);
+        prossh_copy_string(error_buffer, error_buffer_len, "SSH session is disconnecting.");
+        return -1;
     }
 
-    dir = sftp_opendir(sftp, remote_path);
-    if (dir == NULL) {
-        prossh_set_error(handle, "Failed to open remote directory.", error_buffer, error_buffer_len);
-        status = -4;
+    int status = 0;
+    int previous_blocking_mode = prossh_prepare_blocking_session_for_sftp(handle);
+    sftp_dir dir = NULL;
+    char *directory = NULL;
+    int is_root = 1;
+    sftp_session sftp = prossh_sftp_acquire_locked(handle, error_buffer, error_buffer_len);
+    if (sftp == NULL) {
+        status = -3;
         goto cleanup;
     }
 
-    size_t cursor = 0;
-    while (1) {
-        sftp_attributes attributes = sftp_readdir(sftp, dir);
-        if (attributes == NULL) {
-            break;
+    while ((directory = prossh_path_queue_pop(&queue)) != NULL) {
+        dir = sftp_opendir(sftp, directory);
+        if (dir == NULL) {
+            if (is_root) {
+                prossh_set_error(handle, "Failed to open remote directory.", error_buffer, error_buffer_len);
+                status = -4;
+                goto cleanup;
+            }
+            // Unreadable subdirectories (permissions) are skipped, not fatal.
+            free(directory);
+            directory = NULL;
+            continue;
         }
+        is_root = 0;
 
-        const char *name = attributes->name != NULL ? attributes->name : "";
-        if (strcmp(name, ".") != 0 && strcmp(name, "..") != 0) {
-            const int is_directory = attributes->type == SSH_FILEXFER_TYPE_DIRECTORY ? 1 : 0;
-            const unsigned long long file_size = (unsigned long long)attributes->size;
-            const unsigned int permissions = attributes->permissions;
-            const unsigned long long modified_time = (unsigned long long)attributes->mtime;
-
-            int written = snprintf(
-                output_buffer + cursor,
-                output_buffer_len - cursor,
-                "%s\t%d\t%llu\t%u\t%llu\n",
-                name,
-                is_directory,
-                file_size,
-                permissions,
-                modified_time
-            );
+        sftp_attributes attributes;
+        while ((attributes = sftp_readdir(sftp, dir)) != NULL) {
+            const char *name = attributes->name != NULL ? attributes->name : "";
+            int is_directory = attributes->type == SSH_FILEXFER_TYPE_DIRECTORY;
+            if (strcmp(name, ".") == 0 || strcmp(name, "..") == 0) {
+                sftp_attributes_free(attributes);
+                continue;
+            }
 
-            if (written < 0 || (size_t)written >= (output_buffer_len - cursor)) {
+            char *path = prossh_join_remote_path(directory, name);
+            if (path == NULL) {
                 sftp_attributes_free(attributes);
-                prossh_copy_string(error_buffer, error_buffer_len, "SFTP listing output exceeded buffer size.");
+                prossh_copy_string(error_buffer, error_buffer_len, "Out of memory for SFTP walk.");
                 status = -5;
                 goto cleanup;
             }
+            if (recursive && is_directory) {
+                char *child = strdup(path);
+                if (child == NULL || prossh_path_queue_push(&queue, child) != 0) {
+                    free(child);
+                    free(path);
+                    sftp_attributes_free(attributes);
+                    prossh_copy_string(error_buffer, error_buffer_len, "Out of memory for SFTP walk.");
+                    status = -5;
+                    goto cleanup;
+                }
+            }
 
-            cursor += (size_t)written;
+            ProSSHSFTPEntry *entry = &batch->entries[batch->count];
+            entry->path = path;
+            entry->name = path + strlen(path) - strlen(name);
+            entry->size = attributes->size;
+            entry->modified_time = (int64_t)attributes->mtime;
+            entry->permissions = attributes->permissions;
+            entry->is_directory = is_directory != 0;
+            entry->is_regular_file = attributes->type == SSH_FILEXFER_TYPE_REGULAR;
+            batch->paths[batch->count] = path;
+            batch->count += 1;
+            sftp_attributes_free(attributes);
+
+            if (batch->count == PROSSH_SFTP_WALK_BATCH) {
+                status = prossh_entry_batch_flush(
+                    handle, &previous_blocking_mode, batch, callback, context, cancel_flag);
+                if (status != 0) {
+                    goto cleanup;
+                }
+            }
         }
 
-        sftp_attributes_free(attributes);
+        sftp_closedir(dir);
+        dir = NULL;
+        free(directory);
+        directory = NULL;
+
+        // Flush at every directory boundary so callers see each directory's
+        // files as soon as it has been read.
+        status = prossh_entry_batch_flush(handle, &previous_blocking_mode, batch, callback, context, cancel_flag);
+        if (status != 0) {
+            goto cleanup;
+        }
     }
 
 cleanup:
-    if (dir != NULL) {
+    if (status == -2) {
+        prossh_copy_string(error_buffer, error_buffer_len, "SFTP walk cancelled.");
+    } else if (status == -8) {
+        prossh_copy_string(error_buffer, error_buffer_len, "SFTP walk interrupted by disconnect.");
+    }
+    if (dir != NULL && handle->closing == 0) {
         sftp_closedir(dir);
     }
-    if (sftp != NULL) {
-        sftp_free(sftp);
+    free(directory);
+    prossh_entry_batch_clear(batch);
+    free(batch);
+    prossh_path_queue_free(&queue);
+    prossh_restore_session_mode_after_sftp(handle, previous_blocking_mode);
+    prossh_bulk_end(handle);
+    return status;
+}
+
+int prossh_libssh_sftp_mkdir(
+    ProSSHLibSSHHandle *handle,
+    const char *remote_path,
+    uint32_t permissions,
+    char *error_buffer,
+    size_t error_buffer_len
+) {
+    if (handle == NULL || handle->session == NULL || remote_path == NULL) {
+        prossh_copy_string(error_buffer, error_buffer_len, "Invalid SFTP mkdir parameters.");
+        return -1;
     }
+
+    if (prossh_bulk_begin(handle) != 0) {
+        prossh_copy_string(error_buffer, error_buffer_len, "SSH session is disconnecting.");
+        return -1;
+    }
+
+    int status = 0;
+    int previous_blocking_mode = prossh_prepare_blocking_session_for_sftp(handle);
+    sftp_session sftp = prossh_sftp_acquire_locked(handle, error_buffer, error_buffer_len);
+    if (sftp == NULL) {
+        status = -2;
+    } else if (sftp_mkdir(sftp, remote_path, (mode_t)permissions) != 0) {
+        // SFTP v3 servers report an existing path as a generic failure, so
+        // check what is there instead of trusting the status code.
+        sftp_attributes existing = sftp_stat(sftp, remote_path);
+        if (existing != NULL && existing->type == SSH_FILEXFER_TYPE_DIRECTORY) {
+            status = 0;
+        } else {
+            prossh_set_error(handle, "Failed to create remote directory.", error_buffer, error_buffer_len);
+            status = -3;
+        }
+        if (existing != NULL) {
+            sftp_attributes_free(existing);
+        }
+    }
+
     prossh_restore_session_mode_after_sftp(handle, previous_blocking_mode);
-    prossh_unlock_handle(handle);
+    prossh_bulk_end(handle);
     return status;
 }
 
+int prossh_libssh_sftp_set_mtime(
+    ProSSHLibSSHHandle *handle,
+    const char *remote_path,
+    int64_t modified_time,
+    char *error_buffer,
+    size_t error_buffer_len
+) {
+    if (handle == NULL || handle->session == NULL || remote_path == NULL) {
+        prossh_copy_string(error_buffer, error_buffer_len, "Invalid SFTP utimes parameters.");
+        return -1;
+    }
+
+    if (prossh_bulk_begin(handle) != 0) {
+        prossh_copy_string(error_buffer, error_buffer_len, "SSH session is disconnecting.");
+        return -1;
+    }
+
+    int status = 0;
+    int previous_blocking_mode = prossh_prepare_blocking_session_for_sftp(handle);
+    sftp_session sftp = prossh_sftp_acquire_locked(handle, error_buffer, error_buffer_len);
+    if (sftp == NULL) {
+        status = -2;
+    } else {
+        struct timeval times[2];
+        times[0].tv_sec = (time_t)modified_time;
+        times[0].tv_usec = 0;
+        times[1] = times[0];
+        if (sftp_utimes(sftp, remote_path, times) != 0) {
+            prossh_set_error(handle, "Failed to set remote modification time.", error_buffer, error_buffer_len);
+            status = -3;
+        }
+    }
+
+    prossh_restore_session_mode_after_sftp(handle, previous_blocking_mode);
+    prossh_bulk_end(handle);
+    return status;
+}
+
+// Pipelined download
+//
+// Keeps up to `max_in_flight` SSH_FXP_READ requests outstanding (OpenSSH's
+// `sftp -R`) so throughput is bounded by the link, not chunk size / RTT.
+// Replies are consumed strictly in request order, so the local file is still
+// written sequentially. A short reply leaves a hole before the next request's
+// offset; it is filled synchronously before moving on.
+
+#define PROSSH_SFTP_DOWNLOAD_CHUNK (256 * 1024)
+#define PROSSH_SFTP_DOWNLOAD_DEFAULT_IN_FLIGHT 64
+#define PROSSH_SFTP_RESUME_VERIFY_BYTES (64 * 1024)
+
+typedef struct {
+    sftp_aio aio;
+    uint64_t offset;
+    size_t length;
+} ProSSHPendingRead;
+
+typedef struct {
+    ProSSHPendingRead *pending;
+    size_t capacity;
+    size_t head;
+    size_t count;
+    char *buffer;
+} ProSSHReadPipeline;
+
+static int prossh_read_pipeline_init(ProSSHReadPipeline *pipeline, int32_t max_in_flight) {
+    memset(pipeline, 0, sizeof(*pipeline));
+    pipeline->capacity = max_in_flight > 0 ? (size_t)max_in_flight : PROSSH_SFTP_DOWNLOAD_DEFAULT_IN_FLIGHT;
+    pipeline->buffer = (char *)malloc(PROSSH_SFTP_DOWNLOAD_CHUNK);
+    pipeline->pending = (ProSSHPendingRead *)calloc(pipeline->capacity, sizeof(ProSSHPendingRead));
+    if (pipeline->buffer == NULL || pipeline->pending == NULL) {
+        free(pipeline->buffer);
+        free(pipeline->pending);
+        memset(pipeline, 0, sizeof(*pipeline));
+        return -1;
+    }
+    return 0;
+}
+
+// Collects every outstanding reply so none stay queued on the cached SFTP
+// session. On disconnect the session is about to be freed and takes them with it.
+static void prossh_read_pipeline_drain(ProSSHLibSSHHandle *handle, ProSSHReadPipeline *pipeline) {
+    while (pipeline->count > 0) {
+        ProSSHPendingRead *slot = &pipeline->pending[pipeline->head];
+        if (handle->closing != 0 ||
+            sftp_aio_wait_read(&slot->aio, pipeline->buffer, PROSSH_SFTP_DOWNLOAD_CHUNK) == SSH_ERROR) {
+            SFTP_AIO_FREE(slot->aio);
+        }
+        pipeline->head = (pipeline->head + 1) % pipeline->capacity;
+        pipeline->count -= 1;
+    }
+}
+
+static void prossh_read_pipeline_free(ProSSHReadPipeline *pipeline) {
+    free(pipeline->pending);
+    free(pipeline->buffer);
+    memset(pipeline, 0, sizeof(*pipeline));
+}
+
+static int prossh_fill_short_read(
+    sftp_file remote,
+    uint64_t offset,
+    size_t length,
+    uint64_t resume_offset,
+    char *buffer,
+    FILE *local,
+    size_t *filled
+) {
+    *filled = 0;
+    if (sftp_seek64(remote, offset) != 0) {
+        return -1;
+    }
+    while (*filled < length) {
+        ssize_t read_count = sftp_read(remote, buffer, length - *filled);
+        if (read_count < 0) {
+            return -1;
+        }
+        if (read_count == 0) {
+            break;
+        }
+        if (fwrite(buffer, 1, (size_t)read_count, local) != (size_t)read_count) {
+            return -2;
+        }
+        *filled += (size_t)read_count;
+    }
+    // Later requests carry their own offsets; only new ones use the file position.
+    return sftp_seek64(remote, resume_offset) == 0 ? 0 : -1;
+}
+
+// Streams [start, end) of `remote` into `local`, which must already be
+// positioned at `start`. end == 0 reads until the server reports EOF. Called
+// with the bulk lock held; returns with it held. Returns 0, -2 (cancelled), or
+// a download status code with error_buffer set.
+static int prossh_sftp_pipeline_read(
+    ProSSHLibSSHHandle *handle,
+    int *previous_blocking_mode,
+    ProSSHReadPipeline *pipeline,
+    sftp_file remote,
+    FILE *local,
+    uint64_t start,
+    uint64_t end,
+    int64_t *transferred,
+    int64_t *bytes_transferred,
+    volatile int32_t *cancel_flag,
+    char *error_buffer,
+    size_t error_buffer_len
+) {
+    if (sftp_seek64(remote, start) != 0) {
+        prossh_set_error(handle, "Failed to seek remote file.", error_buffer, error_buffer_len);
+        return -6;
+    }
+
+    uint64_t next_offset = start;
+    int requesting = 1;
+    int reached_eof = 0;
+    while (1) {
+        if (cancel_flag != NULL && *cancel_flag != 0) {
+            return -2;
+        }
+
+        // Keep the window full. With a known end, stop there instead of paying
+        // for a round of empty replies; unknown sizes (e.g. /proc) read to EOF.
+        while (requesting && pipeline->count < pipeline->capacity) {
+            if (end > 0 && next_offset >= end) {
+                requesting = 0;
+                break;
+            }
+            size_t want = PROSSH_SFTP_DOWNLOAD_CHUNK;
+            if (end > 0 && end - next_offset < want) {
+                want = (size_t)(end - next_offset);
+            }
+            ProSSHPendingRead *slot = &pipeline->pending[(pipeline->head + pipeline->count) % pipeline->capacity];
+            ssize_t requested = sftp_aio_begin_read(remote, want, &slot->aio);
+            if (requested == SSH_ERROR) {
+                prossh_set_error(handle, "Failed while reading remote file.", error_buffer, error_buffer_len);
+                return -6;
+            }
+            slot->offset = next_offset;
+            slot->length = (size_t)requested;
+            next_offset += (uint64_t)requested;
+            pipeline->count += 1;
+        }
+
+        if (pipeline->count == 0) {
+            return 0;
+        }
+
+        ProSSHPendingRead *slot = &pipeline->pending[pipeline->head];
+        uint64_t slot_offset = slot->offset;
+        size_t slot_length = slot->length;
+        ssize_t read_count = sftp_aio_wait_read(&slot->aio, pipeline->buffer, PROSSH_SFTP_DOWNLOAD_CHUNK);
+        pipeline->head = (pipeline->head + 1) % pipeline->capacity;
+        pipeline->count -= 1;
+        if (read_count < 0) {
+            SFTP_AIO_FREE(slot->aio);
+            prossh_set_error(handle, "Failed while reading remote file.", error_buffer, error_buffer_len);
+            return -6;
+        }
+
+        if (read_count == 0 || reached_eof) {
+            // Remaining requests are past EOF; just collect their replies.
+            reached_eof = 1;
+            requesting = 0;
+            continue;
+        }
+
+        // Local disk I/O runs unlocked; shell and forward traffic queued behind
+        // this request get the session before the next one is issued.
+        prossh_restore_session_mode_after_sftp(handle, *previous_blocking_mode);
+        prossh_bulk_pause(handle);
+        size_t written = fwrite(pipeline->buffer, 1, (size_t)read_count, local);
+        int resumed = prossh_bulk_resume(handle);
+        *previous_blocking_mode = prossh_prepare_blocking_session_for_sftp(handle);
+
+        if (written != (size_t)read_count) {
+            prossh_copy_string(error_buffer, error_buffer_len, "Failed while writing local file.");
+            return -7;
+        }
+
+        *transferred += (int64_t)read_count;
+
+        uint64_t reply_end = slot_offset + (uint64_t)read_count;
+        if ((size_t)read_count < slot_length && (end == 0 || reply_end < end)) {
+            size_t filled = 0;
+            int fill_status = prossh_fill_short_read(
+                remote,
+                reply_end,
+                slot_length - (size_t)read_count,
+                next_offset,
+                pipeline->buffer,
+                local,
+                &filled
+            );
+            *transferred += (int64_t)filled;
+            if (fill_status == -2) {
+                prossh_copy_string(error_buffer, error_buffer_len, "Failed while writing local file.");
+                return -7;
+            }
+            if (fill_status != 0) {
+                prossh_set_error(handle, "Failed while reading remote file.", error_buffer, error_buffer_len);
+                return -6;
+            }
+            if (filled < slot_length - (size_t)read_count) {
+                reached_eof = 1;
+                requesting = 0;
+            }
+        }
+
+        if (bytes_transferred != NULL) {
+            *bytes_transferred = *transferred;
+        }
+
+        if (resumed != 0) {
+            prossh_copy_string(error_buffer, error_buffer_len, "SFTP download interrupted by disconnect.");
+            return -8;
+        }
+    }
+}
+
 int prossh_libssh_sftp_download_file(
     ProSSHLibSSHHandle *handle,
     const char *remote_path,
     const char *local_path,
+    int32_t max_in_flight,
     int64_t *bytes_transferred,
     int64_t *total_bytes,
     volatile int32_t *cancel_flag,
@@ -3400,27 +5973,30 @@ int prossh_libssh_sftp_download_file(
     sftp_session sftp = NULL;
     sftp_file remote = NULL;
     FILE *local = NULL;
+    ProSSHReadPipeline pipeline;
 
     if (handle == NULL || handle->session == NULL || remote_path == NULL || local_path == NULL) {
         prossh_copy_string(error_buffer, error_buffer_len, "Invalid SFTP download parameters.");
         return -1;
     }
 
-    prossh_lock_handle(handle);
+    if (prossh_read_pipeline_init(&pipeline, max_in_flight) != 0) {
+        prossh_copy_string(error_buffer, error_buffer_len, "Out of memory for SFTP download.");
+        return -1;
+    }
+
+    if (prossh_bulk_begin(handle) != 0) {
+        prossh_read_pipeline_free(&pipeline);
+        prossh_copy_string(error_buffer, error_buffer_len, "SSH session is disconnecting.");
+        return -1;
+    }
     previous_blocking_mode = prossh_prepare_blocking_session_for_sftp(handle);
-    sftp = sftp_new(handle->session);
+    sftp = prossh_sftp_acquire_locked(handle, error_buffer, error_buffer_len);
     if (sftp == NULL) {
-        prossh_set_error(handle, "Failed to create SFTP session.", error_buffer, error_buffer_len);
         status = -2;
         goto cleanup;
     }
 
-    if (sftp_init(sftp) != SSH_OK) {
-        prossh_set_error(handle, "Failed to initialize SFTP session.", error_buffer, error_buffer_len);
-        status = -3;
-        goto cleanup;
-    }
-
     remote = sftp_open(sftp, remote_path, O_RDONLY, 0);
     if (remote == NULL) {
         prossh_set_error(handle, "Failed to open remote file for download.", error_buffer, error_buffer_len);
@@ -3428,11 +6004,13 @@ int prossh_libssh_sftp_download_file(
         goto cleanup;
     }
 
+    uint64_t known_size = 0;
     sftp_attributes attributes = sftp_fstat(remote);
-    if (attributes != NULL && total_bytes != NULL) {
-        *total_bytes = (int64_t)attributes->size;
-    }
     if (attributes != NULL) {
+        known_size = attributes->size;
+        if (total_bytes != NULL) {
+            *total_bytes = (int64_t)attributes->size;
+        }
         sftp_attributes_free(attributes);
     }
 
@@ -3443,58 +6021,277 @@ int prossh_libssh_sftp_download_file(
         goto cleanup;
     }
 
-    char buffer[32768];
     int64_t transferred = 0;
-    while (1) {
-        if (cancel_flag != NULL && *cancel_flag != 0) {
-            if (local != NULL) {
-                fclose(local);
-                local = NULL;
-                remove(local_path);
-            }
-            status = -2;
-            goto cleanup;
-        }
+    status = prossh_sftp_pipeline_read(
+        handle,
+        &previous_blocking_mode,
+        &pipeline,
+        remote,
+        local,
+        0,
+        known_size,
+        &transferred,
+        bytes_transferred,
+        cancel_flag,
+        error_buffer,
+        error_buffer_len
+    );
+    if (status == -2) {
+        fclose(local);
+        local = NULL;
+        remove(local_path);
+    }
 
-        ssize_t read_count = sftp_read(remote, buffer, sizeof(buffer));
-        if (read_count < 0) {
-            prossh_set_error(handle, "Failed while reading remote file.", error_buffer, error_buffer_len);
-            status = -6;
-            goto cleanup;
+cleanup:
+    prossh_read_pipeline_drain(handle, &pipeline);
+    if (local != NULL) {
+        fclose(local);
+    }
+    if (remote != NULL) {
+        sftp_close(remote);
+    }
+    prossh_restore_session_mode_after_sftp(handle, previous_blocking_mode);
+    prossh_bulk_end(handle);
+    prossh_read_pipeline_free(&pipeline);
+    return status;
+}
+
+// Compares the local bytes in [from, to) with the remote file. Used before
+// resuming so a partial file that no longer matches the remote restarts.
+static int prossh_sftp_ranges_match(
+    sftp_file remote,
+    FILE *local,
+    uint64_t from,
+    uint64_t to,
+    char *scratch,
+    size_t scratch_len
+) {
+    size_t length = (size_t)(to - from);
+    if (length == 0) {
+        return 1;
+    }
+    if (length * 2 > scratch_len) {
+        return 0;
+    }
+
+    char *local_bytes = scratch;
+    char *remote_bytes = scratch + length;
+    if (fseeko(local, (off_t)from, SEEK_SET) != 0 || fread(local_bytes, 1, length, local) != length) {
+        return 0;
+    }
+    if (sftp_seek64(remote, from) != 0) {
+        return 0;
+    }
+    size_t received = 0;
+    while (received < length) {
+        ssize_t read_count = sftp_read(remote, remote_bytes + received, length - received);
+        if (read_count <= 0) {
+            return 0;
         }
+        received += (size_t)read_count;
+    }
+    return memcmp(local_bytes, remote_bytes, length) == 0;
+}
+
+int prossh_libssh_sftp_download_range(
+    ProSSHLibSSHHandle *handle,
+    const char *remote_path,
+    const char *local_path,
+    uint64_t offset,
+    uint64_t length,
+    int32_t max_in_flight,
+    int64_t *bytes_transferred,
+    volatile int32_t *cancel_flag,
+    char *error_buffer,
+    size_t error_buffer_len
+) {
+    int status = 0;
+    int previous_blocking_mode = 1;
+    sftp_session sftp = NULL;
+    sftp_file remote = NULL;
+    FILE *local = NULL;
+    ProSSHReadPipeline pipeline;
+
+    if (handle == NULL || handle->session == NULL || remote_path == NULL || local_path == NULL ||
+        length == 0 || bytes_transferred == NULL) {
+        prossh_copy_string(error_buffer, error_buffer_len, "Invalid SFTP range download parameters.");
+        return -1;
+    }
+
+    int64_t transferred = *bytes_transferred;
+    if (transferred < 0 || (uint64_t)transferred > length) {
+        transferred = 0;
+    }
+
+    if (prossh_read_pipeline_init(&pipeline, max_in_flight) != 0) {
+        prossh_copy_string(error_buffer, error_buffer_len, "Out of memory for SFTP download.");
+        return -1;
+    }
+
+    // The caller creates and sizes the file; ranges write into it in place.
+    local = fopen(local_path, "r+b");
+    if (local == NULL) {
+        prossh_read_pipeline_free(&pipeline);
+        prossh_copy_string(error_buffer, error_buffer_len, "Failed to open local file for download.");
+        return -5;
+    }
+
+    if (prossh_bulk_begin(handle) != 0) {
+        fclose(local);
+        prossh_read_pipeline_free(&pipeline);
+        prossh_copy_string(error_buffer, error_buffer_len, "SSH session is disconnecting.");
+        return -1;
+    }
+    previous_blocking_mode = prossh_prepare_blocking_session_for_sftp(handle);
+    sftp = prossh_sftp_acquire_locked(handle, error_buffer, error_buffer_len);
+    if (sftp == NULL) {
+        status = -2;
+        goto cleanup;
+    }
+
+    remote = sftp_open(sftp, remote_path, O_RDONLY, 0);
+    if (remote == NULL) {
+        prossh_set_error(handle, "Failed to open remote file for download.", error_buffer, error_buffer_len);
+        status = -4;
+        goto cleanup;
+    }
 
-        if (read_count == 0) {
-            break;
+    if (transferred > 0) {
+        uint64_t resume_at = offset + (uint64_t)transferred;
+        uint64_t verify_from = (uint64_t)transferred > PROSSH_SFTP_RESUME_VERIFY_BYTES
+            ? resume_at - PROSSH_SFTP_RESUME_VERIFY_BYTES
+            : offset;
+        if (!prossh_sftp_ranges_match(
+                remote, local, verify_from, resume_at, pipeline.buffer, PROSSH_SFTP_DOWNLOAD_CHUNK)) {
+            transferred = 0;
         }
+    }
+    *bytes_transferred = transferred;
 
-        size_t written = fwrite(buffer, 1, (size_t)read_count, local);
-        if (written != (size_t)read_count) {
-            prossh_copy_string(error_buffer, error_buffer_len, "Failed while writing local file.");
-            status = -7;
-            goto cleanup;
-        }
+    if (fseeko(local, (off_t)(offset + (uint64_t)transferred), SEEK_SET) != 0) {
+        prossh_copy_string(error_buffer, error_buffer_len, "Failed to seek local file.");
+        status = -5;
+        goto cleanup;
+    }
 
-        transferred += (int64_t)read_count;
-        if (bytes_transferred != NULL) {
-            *bytes_transferred = transferred;
-        }
+    status = prossh_sftp_pipeline_read(
+        handle,
+        &previous_blocking_mode,
+        &pipeline,
+        remote,
+        local,
+        offset + (uint64_t)transferred,
+        offset + length,
+        &transferred,
+        bytes_transferred,
+        cancel_flag,
+        error_buffer,
+        error_buffer_len
+    );
+    if (status == 0 && (uint64_t)transferred < length) {
+        prossh_copy_string(error_buffer, error_buffer_len, "Remote file ended before the requested range.");
+        status = -9;
     }
 
 cleanup:
+    prossh_read_pipeline_drain(handle, &pipeline);
     if (local != NULL) {
         fclose(local);
     }
     if (remote != NULL) {
         sftp_close(remote);
     }
-    if (sftp != NULL) {
-        sftp_free(sftp);
+    prossh_restore_session_mode_after_sftp(handle, previous_blocking_mode);
+    prossh_bulk_end(handle);
+    prossh_read_pipeline_free(&pipeline);
+    return status;
+}
+
+int prossh_libssh_sftp_stat(
+    ProSSHLibSSHHandle *handle,
+    const char *remote_path,
+    int64_t *size,
+    int64_t *modified_time,
+    bool *is_directory,
+    char *error_buffer,
+    size_t error_buffer_len
+) {
+    if (handle == NULL || handle->session == NULL || remote_path == NULL) {
+        prossh_copy_string(error_buffer, error_buffer_len, "Invalid SFTP stat parameters.");
+        return -1;
+    }
+
+    if (prossh_bulk_begin(handle) != 0) {
+        prossh_copy_string(error_buffer, error_buffer_len, "SSH session is disconnecting.");
+        return -1;
+    }
+
+    int status = 0;
+    int previous_blocking_mode = prossh_prepare_blocking_session_for_sftp(handle);
+    sftp_session sftp = prossh_sftp_acquire_locked(handle, error_buffer, error_buffer_len);
+    if (sftp == NULL) {
+        status = -2;
+    } else {
+        sftp_attributes attributes = sftp_stat(sftp, remote_path);
+        if (attributes == NULL) {
+            prossh_set_error(handle, "Failed to stat remote path.", error_buffer, error_buffer_len);
+            status = -3;
+        } else {
+            if (size != NULL) {
+                *size = (int64_t)attributes->size;
+            }
+            if (modified_time != NULL) {
+                *modified_time = (int64_t)attributes->mtime;
+            }
+            if (is_directory != NULL) {
+                *is_directory = attributes->type == SSH_FILEXFER_TYPE_DIRECTORY;
+            }
+            sftp_attributes_free(attributes);
+        }
     }
+
     prossh_restore_session_mode_after_sftp(handle, previous_blocking_mode);
-    prossh_unlock_handle(handle);
+    prossh_bulk_end(handle);
     return status;
 }
 
+// Pipelined upload
+//
+// Write-behind counterpart of the download pipeline: SSH_FXP_WRITE requests are
+// issued from a local read-ahead buffer without waiting for each status reply.
+// The window adapts to the measured RTT, Vegas-style: it grows while replies
+// come back close to the best RTT seen (the path is not queueing) and backs off
+// when RTT inflates, so uploads fill the link without bloating its buffers.
+
+#define PROSSH_SFTP_UPLOAD_CHUNK (256 * 1024)
+#define PROSSH_SFTP_UPLOAD_READ_AHEAD (4 * 1024 * 1024)
+#define PROSSH_SFTP_UPLOAD_MIN_WINDOW 4
+#define PROSSH_SFTP_UPLOAD_INITIAL_WINDOW 16
+#define PROSSH_SFTP_UPLOAD_MAX_WINDOW 128
+
+typedef struct {
+    sftp_aio aio;
+    size_t length;
+    uint64_t sent_at_ns;
+} ProSSHPendingWrite;
+
+static size_t prossh_adapt_upload_window(size_t window, uint64_t rtt_ns, uint64_t *min_rtt_ns) {
+    if (*min_rtt_ns == 0 || rtt_ns < *min_rtt_ns) {
+        *min_rtt_ns = rtt_ns;
+    }
+    if (rtt_ns * 2 <= *min_rtt_ns * 3) {
+        if (window < PROSSH_SFTP_UPLOAD_MAX_WINDOW) {
+            window += 1;
+        }
+    } else if (rtt_ns >= *min_rtt_ns * 3) {
+        window -= window / 4;
+        if (window < PROSSH_SFTP_UPLOAD_MIN_WINDOW) {
+            window = PROSSH_SFTP_UPLOAD_MIN_WINDOW;
+        }
+    }
+    return window;
+}
+
 int prossh_libssh_sftp_upload_file(
     ProSSHLibSSHHandle *handle,
     const char *local_path,
@@ -3517,6 +6314,11 @@ int prossh_libssh_sftp_upload_file(
     FILE *local = NULL;
     sftp_session sftp = NULL;
     sftp_file remote = NULL;
+    char *read_ahead = NULL;
+    ProSSHPendingWrite *pending = NULL;
+    const size_t capacity = PROSSH_SFTP_UPLOAD_MAX_WINDOW;
+    size_t head = 0;
+    size_t count = 0;
 
     if (handle == NULL || handle->session == NULL || remote_path == NULL || local_path == NULL) {
         prossh_copy_string(error_buffer, error_buffer_len, "Invalid SFTP upload parameters.");
@@ -3534,21 +6336,30 @@ int prossh_libssh_sftp_upload_file(
         return -2;
     }
 
-    prossh_lock_handle(handle);
+    read_ahead = (char *)malloc(PROSSH_SFTP_UPLOAD_READ_AHEAD);
+    pending = (ProSSHPendingWrite *)calloc(capacity, sizeof(ProSSHPendingWrite));
+    if (read_ahead == NULL || pending == NULL) {
+        free(read_ahead);
+        free(pending);
+        fclose(local);
+        prossh_copy_string(error_buffer, error_buffer_len, "Out of memory for SFTP upload.");
+        return -1;
+    }
+
+    if (prossh_bulk_begin(handle) != 0) {
+        free(read_ahead);
+        free(pending);
+        fclose(local);
+        prossh_copy_string(error_buffer, error_buffer_len, "SSH session is disconnecting.");
+        return -1;
+    }
     previous_blocking_mode = prossh_prepare_blocking_session_for_sftp(handle);
-    sftp = sftp_new(handle->session);
+    sftp = prossh_sftp_acquire_locked(handle, error_buffer, error_buffer_len);
     if (sftp == NULL) {
-        prossh_set_error(handle, "Failed to create SFTP session.", error_buffer, error_buffer_len);
         status = -3;
         goto cleanup;
     }
 
-    if (sftp_init(sftp) != SSH_OK) {
-        prossh_set_error(handle, "Failed to initialize SFTP session.", error_buffer, error_buffer_len);
-        status = -4;
-        goto cleanup;
-    }
-
     remote = sftp_open(
         sftp,
         remote_path,
@@ -3561,53 +6372,179 @@ int prossh_libssh_sftp_upload_file(
         goto cleanup;
     }
 
-    char buffer[32768];
     int64_t transferred = 0;
+    size_t buffered = 0;
+    size_t buffer_cursor = 0;
+    int local_eof = 0;
+    size_t window = PROSSH_SFTP_UPLOAD_INITIAL_WINDOW;
+    uint64_t min_rtt_ns = 0;
     while (1) {
         if (cancel_flag != NULL && *cancel_flag != 0) {
             status = -2;
             goto cleanup;
         }
 
-        size_t read_count = fread(buffer, 1, sizeof(buffer), local);
-        if (read_count == 0) {
-            if (ferror(local)) {
+        // Refill the read-ahead buffer with the session unlocked. begin_write
+        // copies the payload into the outgoing packet, so the buffer can be
+        // reused while earlier requests are still unacknowledged.
+        if (buffer_cursor == buffered && !local_eof) {
+            prossh_restore_session_mode_after_sftp(handle, previous_blocking_mode);
+            prossh_bulk_pause(handle);
+            buffered = fread(read_ahead, 1, PROSSH_SFTP_UPLOAD_READ_AHEAD, local);
+            int read_failed = ferror(local);
+            int resumed = prossh_bulk_resume(handle);
+            previous_blocking_mode = prossh_prepare_blocking_session_for_sftp(handle);
+            buffer_cursor = 0;
+            if (resumed != 0) {
+                prossh_copy_string(error_buffer, error_buffer_len, "SFTP upload interrupted by disconnect.");
+                status = -8;
+                goto cleanup;
+            }
+            if (read_failed) {
                 prossh_copy_string(error_buffer, error_buffer_len, "Failed while reading local file.");
                 status = -6;
                 goto cleanup;
             }
-            break;
+            if (buffered < PROSSH_SFTP_UPLOAD_READ_AHEAD) {
+                local_eof = 1;
+            }
+        }
+
+        while (count < window && buffer_cursor < buffered) {
+            size_t remaining = buffered - buffer_cursor;
+            size_t length = remaining < PROSSH_SFTP_UPLOAD_CHUNK ? remaining : PROSSH_SFTP_UPLOAD_CHUNK;
+            ProSSHPendingWrite *slot = &pending[(head + count) % capacity];
+            ssize_t accepted = sftp_aio_begin_write(remote, read_ahead + buffer_cursor, length, &slot->aio);
+            if (accepted == SSH_ERROR || accepted <= 0) {
+                prossh_set_error(handle, "Failed while writing remote file.", error_buffer, error_buffer_len);
+                status = -7;
+                goto cleanup;
+            }
+            slot->length = (size_t)accepted;
+            slot->sent_at_ns = prossh_monotonic_ns();
+            buffer_cursor += (size_t)accepted;
+            count += 1;
+        }
+
+        if (count == 0) {
+            if (local_eof && buffer_cursor == buffered) {
+                break;
+            }
+            continue;
+        }
+
+        // Only block on a reply when the window is full or the file is fully
+        // sent; otherwise refill the read-ahead while requests are in flight.
+        if (count < window && !local_eof) {
+            continue;
         }
 
-        ssize_t written = sftp_write(remote, buffer, read_count);
-        if (written < 0 || (size_t)written != read_count) {
+        ProSSHPendingWrite *slot = &pending[head];
+        size_t slot_length = slot->length;
+        uint64_t sent_at_ns = slot->sent_at_ns;
+        ssize_t written = sftp_aio_wait_write(&slot->aio);
+        head = (head + 1) % capacity;
+        count -= 1;
+        if (written < 0 || (size_t)written != slot_length) {
+            SFTP_AIO_FREE(slot->aio);
             prossh_set_error(handle, "Failed while writing remote file.", error_buffer, error_buffer_len);
             status = -7;
             goto cleanup;
         }
 
+        window = prossh_adapt_upload_window(window, prossh_monotonic_ns() - sent_at_ns, &min_rtt_ns);
         transferred += (int64_t)written;
         if (bytes_transferred != NULL) {
             *bytes_transferred = transferred;
         }
+
+        // Give queued shell / forward I/O a turn between replies.
+        prossh_restore_session_mode_after_sftp(handle, previous_blocking_mode);
+        prossh_bulk_pause(handle);
+        int resumed = prossh_bulk_resume(handle);
+        previous_blocking_mode = prossh_prepare_blocking_session_for_sftp(handle);
+        if (resumed != 0) {
+            prossh_copy_string(error_buffer, error_buffer_len, "SFTP upload interrupted by disconnect.");
+            status = -8;
+            goto cleanup;
+        }
     }
 
 cleanup:
+    while (count > 0) {
+        // Collect outstanding status replies so none stay queued on the cached
+        // SFTP session; on disconnect the session takes them with it.
+        if (handle->closing != 0 || sftp_aio_wait_write(&pending[head].aio) == SSH_ERROR) {
+            SFTP_AIO_FREE(pending[head].aio);
+        }
+        head = (head + 1) % capacity;
+        count -= 1;
+    }
     if (local != NULL) {
         fclose(local);
     }
     if (remote != NULL) {
         sftp_close(remote);
     }
-    if (sftp != NULL) {
-        sftp_free(sftp);
-    }
     prossh_restore_session_mode_after_sftp(handle, previous_blocking_mode);
-    prossh_unlock_handle(handle);
+    prossh_bulk_end(handle);
+    free(pending);
+    free(read_ahead);
     return status;
 }
 
-ProSSHForwardChannel *prossh_forward_channel_open(
+// Pipelined forward-channel opens
+//
+// ssh_channel_open_forward on a blocking session waits a full round trip for
+// the server's reply while holding the session lock, so a burst of opens (a
+// browser behind a SOCKS listener) queued one RTT apiece. Instead the open is
+// sent with the session briefly non-blocking, and the reply is collected later
+// by prossh_forward_channel_open_poll. Every open in a burst then shares the
+// same round trip.
+static void prossh_forward_open_finished(ProSSHForwardChannel *fwd) {
+    fwd->opening = 0;
+    free(fwd->open_remote_host);
+    free(fwd->open_source_host);
+    free(fwd->open_command);
+    fwd->open_remote_host = NULL;
+    fwd->open_source_host = NULL;
+    fwd->open_command = NULL;
+}
+
+// Sends (or re-checks) the open. Returns SSH_OK, SSH_AGAIN or SSH_ERROR.
+// Caller holds the session lock.
+static int prossh_forward_open_step_locked(ProSSHLibSSHHandle *handle, ProSSHForwardChannel *fwd) {
+    int was_blocking = ssh_is_blocking(handle->session);
+    ssh_set_blocking(handle->session, 0);
+    int rc;
+    if (fwd->open_command != NULL) {
+        // Session open, then the exec request; each re-entered until answered.
+        rc = SSH_OK;
+        if (fwd->exec_requested == 0) {
+            rc = ssh_channel_open_session(fwd->channel);
+            if (rc == SSH_OK) {
+                fwd->exec_requested = 1;
+            }
+        }
+        if (rc == SSH_OK) {
+            rc = ssh_channel_request_exec(fwd->channel, fwd->open_command);
+        }
+    } else {
+        rc = ssh_channel_open_forward(
+            fwd->channel,
+            fwd->open_remote_host,
+            (int)fwd->open_remote_port,
+            fwd->open_source_host,
+            (int)fwd->open_source_port
+        );
+    }
+    if (was_blocking != 0) {
+        ssh_set_blocking(handle->session, 1);
+    }
+    return rc;
+}
+
+ProSSHForwardChannel *prossh_forward_channel_open_start(
     ProSSHLibSSHHandle *handle,
     const char *remote_host,
     uint16_t remote_port,
@@ -3616,44 +6553,294 @@ ProSSHForwardChannel *prossh_forward_channel_open(
     char *error_buffer,
     size_t error_buffer_len
 ) {
-    if (handle == NULL || handle->session == NULL) {
+    if (handle == NULL || handle->session == NULL || remote_host == NULL || source_host == NULL) {
+        prossh_copy_string(error_buffer, error_buffer_len, "SSH session is not connected.");
+        return NULL;
+    }
+
+    ProSSHForwardChannel *fwd = (ProSSHForwardChannel *)calloc(1, sizeof(ProSSHForwardChannel));
+    if (fwd == NULL) {
+        prossh_copy_string(error_buffer, error_buffer_len, "Failed to allocate forward channel struct.");
+        return NULL;
+    }
+    fwd->open_remote_host = strdup(remote_host);
+    fwd->open_source_host = strdup(source_host);
+    fwd->open_remote_port = remote_port;
+    fwd->open_source_port = source_port;
+    if (fwd->open_remote_host == NULL || fwd->open_source_host == NULL) {
+        prossh_forward_open_finished(fwd);
+        free(fwd);
+        prossh_copy_string(error_buffer, error_buffer_len, "Failed to allocate forward channel struct.");
+        return NULL;
+    }
+
+    prossh_lock_handle(handle);
+    uint64_t packets_before = prossh_inbound_packets(handle);
+    if (handle->session == NULL) {
+        prossh_unlock_handle(handle);
         prossh_copy_string(error_buffer, error_buffer_len, "SSH session is not connected.");
+        prossh_forward_open_finished(fwd);
+        free(fwd);
         return NULL;
     }
 
     ssh_channel channel = ssh_channel_new(handle->session);
     if (channel == NULL) {
+        prossh_unlock_handle(handle);
         prossh_copy_string(error_buffer, error_buffer_len, "Failed to create forward channel.");
+        prossh_forward_open_finished(fwd);
+        free(fwd);
         return NULL;
     }
+    fwd->channel = channel;
 
-    int rc = ssh_channel_open_forward(
-        channel,
-        remote_host,
-        (int)remote_port,
-        source_host,
-        (int)source_port
-    );
-
-    if (rc != SSH_OK) {
+    int rc = prossh_forward_open_step_locked(handle, fwd);
+    if (rc == SSH_ERROR) {
         prossh_set_error(handle, "Failed to open forward channel.", error_buffer, error_buffer_len);
         ssh_channel_free(channel);
+        prossh_unlock_handle(handle);
+        prossh_forward_open_finished(fwd);
+        free(fwd);
+        return NULL;
+    }
+
+    if (rc == SSH_OK) {
+        prossh_forward_open_finished(fwd);
+    } else {
+        fwd->opening = 1;
+    }
+    fwd->owner = handle;
+    fwd->next = handle->forwards;
+    handle->forwards = fwd;
+    ssh_channel_set_blocking(channel, 0);
+    prossh_unlock_handle(handle);
+    prossh_note_inbound_progress(handle, packets_before);
+    return fwd;
+}
+
+int prossh_forward_channel_open_poll(
+    ProSSHForwardChannel *fwd,
+    char *error_buffer,
+    size_t error_buffer_len
+) {
+    if (fwd == NULL) {
+        prossh_copy_string(error_buffer, error_buffer_len, "Invalid forward channel.");
+        return -1;
+    }
+
+    ProSSHLibSSHHandle *owner = fwd->owner;
+    prossh_lock_handle(owner);
+    if (fwd->channel == NULL || owner == NULL || owner->session == NULL) {
+        prossh_unlock_handle(owner);
+        prossh_copy_string(error_buffer, error_buffer_len, "SSH session is not connected.");
+        return -1;
+    }
+    if (fwd->opening == 0) {
+        prossh_unlock_handle(owner);
+        return 0;
+    }
+
+    uint64_t packets_before = prossh_inbound_packets(owner);
+    int rc = prossh_forward_open_step_locked(owner, fwd);
+    int status = 1;
+    if (rc == SSH_OK) {
+        prossh_forward_open_finished(fwd);
+        status = 0;
+    } else if (rc == SSH_ERROR) {
+        prossh_set_error(owner, "Failed to open forward channel.", error_buffer, error_buffer_len);
+        prossh_forward_open_finished(fwd);
+        status = -1;
+    }
+    prossh_unlock_handle(owner);
+    prossh_note_inbound_progress(owner, packets_before);
+    return status;
+}
+
+// Exec channels
+//
+// A session channel running one command, for tool commands that must not go
+// through the user's PTY. It reuses the forward-channel wrapper, so opening
+// is pipelined the same way (prossh_forward_channel_open_poll), stdout is
+// prossh_forward_channel_read and disconnect cleans it up with the forwards.
+// The exit status arrives as a channel request, recorded by a callback while
+// packets are processed instead of a blocking ssh_channel_get_exit_state.
+static void prossh_exec_exit_status_cb(ssh_session session, ssh_channel channel, int exit_status, void *userdata) {
+    (void)session;
+    (void)channel;
+    ProSSHForwardChannel *fwd = (ProSSHForwardChannel *)userdata;
+    fwd->exit_received = 1;
+    fwd->exit_code = exit_status;
+}
+
+static void prossh_exec_exit_signal_cb(
+    ssh_session session,
+    ssh_channel channel,
+    const char *signal,
+    int core,
+    const char *errmsg,
+    const char *lang,
+    void *userdata
+) {
+    (void)session;
+    (void)channel;
+    (void)signal;
+    (void)core;
+    (void)errmsg;
+    (void)lang;
+    ProSSHForwardChannel *fwd = (ProSSHForwardChannel *)userdata;
+    fwd->exit_received = 1;
+    fwd->exit_code = -1;
+}
+
+ProSSHForwardChannel *prossh_exec_channel_open_start(
+    ProSSHLibSSHHandle *handle,
+    const char *command,
+    char *error_buffer,
+    size_t error_buffer_len
+) {
+    if (handle == NULL || handle->session == NULL || command == NULL || command[0] == '\0') {
+        prossh_copy_string(error_buffer, error_buffer_len, "Invalid remote command execution parameters.");
         return NULL;
     }
 
     ProSSHForwardChannel *fwd = (ProSSHForwardChannel *)calloc(1, sizeof(ProSSHForwardChannel));
     if (fwd == NULL) {
-        prossh_copy_string(error_buffer, error_buffer_len, "Failed to allocate forward channel struct.");
-        ssh_channel_close(channel);
-        ssh_channel_free(channel);
+        prossh_copy_string(error_buffer, error_buffer_len, "Failed to allocate exec channel struct.");
+        return NULL;
+    }
+    fwd->open_command = strdup(command);
+    if (fwd->open_command == NULL) {
+        free(fwd);
+        prossh_copy_string(error_buffer, error_buffer_len, "Failed to allocate exec channel struct.");
         return NULL;
     }
 
+    prossh_lock_handle(handle);
+    uint64_t packets_before = prossh_inbound_packets(handle);
+    ssh_channel channel = handle->session != NULL ? ssh_channel_new(handle->session) : NULL;
+    if (channel == NULL) {
+        prossh_unlock_handle(handle);
+        prossh_copy_string(error_buffer, error_buffer_len, "Failed to allocate SSH channel.");
+        prossh_forward_open_finished(fwd);
+        free(fwd);
+        return NULL;
+    }
     fwd->channel = channel;
+
+    ssh_callbacks_init(&fwd->exec_callbacks);
+    fwd->exec_callbacks.userdata = fwd;
+    fwd->exec_callbacks.channel_exit_status_function = prossh_exec_exit_status_cb;
+    fwd->exec_callbacks.channel_exit_signal_function = prossh_exec_exit_signal_cb;
+    ssh_set_channel_callbacks(channel, &fwd->exec_callbacks);
+
+    int rc = prossh_forward_open_step_locked(handle, fwd);
+    if (rc == SSH_ERROR) {
+        prossh_set_error(handle, "Failed to execute remote SSH command.", error_buffer, error_buffer_len);
+        ssh_channel_free(channel);
+        prossh_unlock_handle(handle);
+        prossh_forward_open_finished(fwd);
+        free(fwd);
+        return NULL;
+    }
+
+    if (rc == SSH_OK) {
+        prossh_forward_open_finished(fwd);
+    } else {
+        fwd->opening = 1;
+    }
+    fwd->owner = handle;
+    fwd->next = handle->forwards;
+    handle->forwards = fwd;
     ssh_channel_set_blocking(channel, 0);
+    prossh_unlock_handle(handle);
+    prossh_note_inbound_progress(handle, packets_before);
     return fwd;
 }
 
+int prossh_exec_channel_read_stderr(
+    ProSSHForwardChannel *fwd,
+    char *buffer,
+    size_t buffer_len,
+    char *error_buffer,
+    size_t error_buffer_len
+) {
+    if (fwd == NULL || buffer == NULL || buffer_len == 0) {
+        prossh_copy_string(error_buffer, error_buffer_len, "Invalid exec channel read parameters.");
+        return -1;
+    }
+
+    ProSSHLibSSHHandle *owner = fwd->owner;
+    prossh_lock_handle(owner);
+    if (fwd->channel == NULL) {
+        prossh_unlock_handle(owner);
+        prossh_copy_string(error_buffer, error_buffer_len, "Exec channel is closed.");
+        return -1;
+    }
+
+    uint64_t packets_before = prossh_inbound_packets(owner);
+    int nbytes = 0;
+    while ((size_t)nbytes < buffer_len) {
+        int chunk = ssh_channel_read_nonblocking(
+            fwd->channel,
+            buffer + nbytes,
+            (uint32_t)(buffer_len - (size_t)nbytes),
+            1
+        );
+        if (chunk == SSH_ERROR) {
+            prossh_unlock_handle(owner);
+            prossh_copy_string(error_buffer, error_buffer_len, "Failed while reading remote stderr output.");
+            return -1;
+        }
+        if (chunk <= 0) {
+            break;
+        }
+        nbytes += chunk;
+    }
+    prossh_unlock_handle(owner);
+    prossh_note_inbound_progress(owner, packets_before);
+    return nbytes;
+}
+
+int prossh_exec_channel_exit_status(ProSSHForwardChannel *fwd, int *exit_code) {
+    if (fwd == NULL) {
+        return -1;
+    }
+
+    ProSSHLibSSHHandle *owner = fwd->owner;
+    prossh_lock_handle(owner);
+    uint64_t packets_before = prossh_inbound_packets(owner);
+    if (!fwd->exit_received && fwd->channel != NULL && owner != NULL && owner->session != NULL) {
+        // After EOF no channel read processes packets any more. With the
+        // session non-blocking this takes what has arrived and returns; the
+        // callbacks above record the result.
+        uint32_t code = 0;
+        char *signal = NULL;
+        int core = 0;
+        int was_blocking = ssh_is_blocking(owner->session);
+        ssh_set_blocking(owner->session, 0);
+        ssh_channel_get_exit_state(fwd->channel, &code, &signal, &core);
+        if (was_blocking != 0) {
+            ssh_set_blocking(owner->session, 1);
+        }
+        ssh_string_free_char(signal);
+    }
+    int status;
+    if (fwd->exit_received) {
+        if (exit_code != NULL) {
+            *exit_code = fwd->exit_code;
+        }
+        status = 1;
+    } else if (fwd->channel == NULL || ssh_channel_is_closed(fwd->channel) != 0) {
+        // Closed without reporting a status.
+        status = -1;
+    } else {
+        status = 0;
+    }
+    prossh_unlock_handle(owner);
+    prossh_note_inbound_progress(owner, packets_before);
+    return status;
+}
+
 int prossh_forward_channel_read(
     ProSSHForwardChannel *fwd,
     char *buffer,
@@ -3666,23 +6853,47 @@ int prossh_forward_channel_read(
         *is_eof = false;
     }
 
-    if (fwd == NULL || fwd->channel == NULL || buffer == NULL || buffer_len == 0) {
+    if (fwd == NULL || buffer == NULL || buffer_len == 0) {
         prossh_copy_string(error_buffer, error_buffer_len, "Invalid forward channel read parameters.");
         return -1;
     }
 
-    int nbytes = ssh_channel_read_nonblocking(fwd->channel, buffer, (uint32_t)buffer_len, 0);
-
-    if (nbytes == SSH_ERROR) {
-        prossh_copy_string(error_buffer, error_buffer_len, "Failed reading from forward channel.");
+    ProSSHLibSSHHandle *owner = fwd->owner;
+    prossh_lock_handle(owner);
+    if (fwd->channel == NULL) {
+        prossh_unlock_handle(owner);
+        prossh_copy_string(error_buffer, error_buffer_len, "Forward channel is closed.");
         return -1;
     }
 
+    uint64_t packets_before = prossh_inbound_packets(owner);
+    // Drain like the shell reader so unread bytes don't hold the window shut.
+    int nbytes = 0;
+    while ((size_t)nbytes < buffer_len) {
+        int chunk = ssh_channel_read_nonblocking(
+            fwd->channel,
+            buffer + nbytes,
+            (uint32_t)(buffer_len - (size_t)nbytes),
+            0
+        );
+        if (chunk == SSH_ERROR) {
+            prossh_unlock_handle(owner);
+            prossh_copy_string(error_buffer, error_buffer_len, "Failed reading from forward channel.");
+            return -1;
+        }
+        if (chunk <= 0) {
+            break;
+        }
+        nbytes += chunk;
+    }
+
     if (is_eof != NULL) {
         *is_eof = ssh_channel_is_eof(fwd->channel) != 0;
     }
+    prossh_unlock_handle(owner);
+    prossh_note_inbound_progress(owner, packets_before);
 
-    return nbytes < 0 ? 0 : nbytes;
+    return nbytes;
 }
 
 int prossh_forward_channel_write(
@@ -3692,31 +6903,77 @@ int prossh_forward_channel_write(
     char *error_buffer,
     size_t error_buffer_len
 ) {
-    if (fwd == NULL || fwd->channel == NULL || data == NULL || data_len == 0) {
+    if (fwd == NULL || data == NULL || data_len == 0 || data_len > INT_MAX) {
         prossh_copy_string(error_buffer, error_buffer_len, "Invalid forward channel write parameters.");
         return -1;
     }
 
-    int written = ssh_channel_write(fwd->channel, data, (uint32_t)data_len);
-    if (written == SSH_ERROR) {
+    ProSSHLibSSHHandle *owner = fwd->owner;
+    prossh_lock_handle(owner);
+    if (fwd->channel == NULL) {
+        prossh_unlock_handle(owner);
+        prossh_copy_string(error_buffer, error_buffer_len, "Forward channel is closed.");
+        return -1;
+    }
+
+    // Only what the peer's window admits goes out, as in the shell flush: on
+    // the blocking session a write past the window would wait for the adjust
+    // with the session lock held. The caller waits on readiness for the rest.
+    uint64_t packets_before = prossh_inbound_packets(owner);
+    size_t total = 0;
+    int failed = 0;
+    while (total < data_len) {
+        uint32_t window = ssh_channel_window_size(fwd->channel);
+        if (window == 0) {
+            if (ssh_channel_poll(fwd->channel, 0) == SSH_ERROR) {
+                failed = 1;
+                break;
+            }
+            window = ssh_channel_window_size(fwd->channel);
+            if (window == 0) {
+                break;
+            }
+        }
+        size_t count = data_len - total;
+        if (count > window) {
+            count = window;
+        }
+        int written = ssh_channel_write(fwd->channel, data + total, (uint32_t)count);
+        if (written == SSH_ERROR) {
+            failed = 1;
+            break;
+        }
+        if (written <= 0) {
+            break;
+        }
+        total += (size_t)written;
+    }
+    prossh_unlock_handle(owner);
+    prossh_note_inbound_progress(owner, packets_before);
+
+    if (failed) {
         prossh_copy_string(error_buffer, error_buffer_len, "Failed writing to forward channel.");
         return -1;
     }
 
-    return 0;
+    return (int)total;
 }
 
 int prossh_forward_channel_is_open(ProSSHForwardChannel *fwd) {
-    if (fwd == NULL || fwd->channel == NULL) {
-        return 0;
-    }
-    if (ssh_channel_is_eof(fwd->channel) != 0) {
+    if (fwd == NULL) {
         return 0;
     }
-    if (ssh_channel_is_open(fwd->channel) == 0) {
-        return 0;
+
+    ProSSHLibSSHHandle *owner = fwd->owner;
+    prossh_lock_handle(owner);
+    int is_open = 1;
+    if (fwd->channel == NULL ||
+        ssh_channel_is_eof(fwd->channel) != 0 ||
+        ssh_channel_is_open(fwd->channel) == 0) {
+        is_open = 0;
     }
-    return 1;
+    prossh_unlock_handle(owner);
+    return is_open;
 }
 
 void prossh_forward_channel_close(ProSSHForwardChannel *fwd) {
@@ -3724,12 +6981,26 @@ void prossh_forward_channel_close(ProSSHForwardChannel *fwd) {
         return;
     }
 
+    ProSSHLibSSHHandle *owner = fwd->owner;
+    prossh_lock_handle(owner);
+    if (owner != NULL) {
+        ProSSHForwardChannel **link = &owner->forwards;
+        while (*link != NULL && *link != fwd) {
+            link = &(*link)->next;
+        }
+        if (*link == fwd) {
+            *link = fwd->next;
+        }
+    }
+
     if (fwd->channel != NULL) {
         ssh_channel_send_eof(fwd->channel);
         ssh_channel_close(fwd->channel);
         ssh_channel_free(fwd->channel);
         fwd->channel = NULL;
     }
+    prossh_unlock_handle(owner);
 
+    prossh_forward_open_finished(fwd);
     free(fwd);
 }
@@ -6,6 +6,10 @@
 #include <stdint.h>
 
 typedef struct ProSSHLibSSHHandle ProSSHLibSSHHandle;
+typedef struct ProSSHForwardChannel ProSSHForwardChannel;
+typedef struct ProSSHRemoteForward ProSSHRemoteForward;
+
+typedef void (*ProSSHIOReadyCallback)(void *context);
 
 typedef enum ProSSHAuthMethod {
     PROSSH_AUTH_PASSWORD = 0,
@@ -29,6 +33,11 @@ typedef enum ProSSHPrivateKeyFormat {
     PROSSH_PRIVATE_KEY_PKCS8 = 2
 } ProSSHPrivateKeyFormat;
 
+typedef enum ProSSHTrafficClass {
+    PROSSH_TRAFFIC_INTERACTIVE = 0,
+    PROSSH_TRAFFIC_BULK = 1
+} ProSSHTrafficClass;
+
 typedef enum ProSSHPrivateKeyCipher {
     PROSSH_PRIVATE_KEY_CIPHER_NONE = 0,
     PROSSH_PRIVATE_KEY_CIPHER_AES256CTR = 1,
@@ -36,7 +45,15 @@ typedef enum ProSSHPrivateKeyCipher {
 } ProSSHPrivateKeyCipher;
 
 ProSSHLibSSHHandle *prossh_libssh_create(void);
+// Attaches a new handle to `existing`'s connected, authenticated session
+// (ControlMaster-style). The new handle opens its own shell and forward
+// channels and shares the cached SFTP subsystem; the session is disconnected
+// when the last handle using it disconnects. Returns NULL when `existing` has no live session.
+ProSSHLibSSHHandle *prossh_libssh_create_shared(ProSSHLibSSHHandle *existing);
 void prossh_libssh_destroy(ProSSHLibSSHHandle *handle);
+// Nonzero while the handle's session is connected and not closing. Only as
+// fresh as the last packet libssh read.
+int prossh_libssh_is_connected(ProSSHLibSSHHandle *handle);
 
 int prossh_libssh_connect(
     ProSSHLibSSHHandle *handle,
@@ -47,6 +64,8 @@ int prossh_libssh_connect(
     const char *ciphers,
     const char *hostkeys,
     const char *macs,
+    // Comma-separated list for both directions; NULL or "" keeps the libssh default.
+    const char *compression,
     int timeout_seconds,
     char *error_buffer,
     size_t error_buffer_len
@@ -69,12 +88,29 @@ int prossh_libssh_get_negotiated(
     size_t kex_buffer_len,
     char *cipher_buffer,
     size_t cipher_buffer_len,
+    char *mac_buffer,
+    size_t mac_buffer_len,
     char *hostkey_buffer,
     size_t hostkey_buffer_len,
     char *fingerprint_buffer,
     size_t fingerprint_buffer_len
 );
 
+// Local encrypt (cipher) or authenticate (MAC) throughput in bytes/second for
+// an SSH algorithm name, timed for about `duration_ms` against the bundled
+// OpenSSL. -1 for names it cannot time.
+int64_t prossh_crypto_benchmark(const char *algorithm, int duration_ms);
+
+// Inbound link rate in bytes/second, estimated from sustained bursts (bulk
+// transfers, heavy output) on this handle's connection. 0 until one is seen.
+int64_t prossh_libssh_link_rate(ProSSHLibSSHHandle *handle);
+
+// Marks the connection's socket for `traffic_class`, as OpenSSH's IPQoS does:
+// DSCP AF21 for interactive and CS1 for bulk, plus the matching Darwin network
+// service type so Wi-Fi and the local queue schedule it accordingly. Returns 0
+// when the socket took it, -1 otherwise (jump targets ride a local socket pair).
+int prossh_libssh_set_traffic_class(ProSSHLibSSHHandle *handle, ProSSHTrafficClass traffic_class);
+
 int prossh_libssh_open_shell(
     ProSSHLibSSHHandle *handle,
     int columns,
@@ -85,14 +121,35 @@ int prossh_libssh_open_shell(
     size_t error_buffer_len
 );
 
-int prossh_libssh_channel_write(
+// Queues shell input without touching the session; returns immediately.
+// Interactive bytes (keystrokes) are written ahead of bulk bytes (pastes).
+int prossh_libssh_channel_enqueue(
     ProSSHLibSSHHandle *handle,
     const char *input,
     size_t input_len,
+    bool is_bulk,
     char *error_buffer,
     size_t error_buffer_len
 );
 
+// Writes as much queued input as the channel window allows without blocking.
+// `pending` receives the bytes still queued; when non-zero, call again once
+// the session reports readiness (the window adjust arrives as inbound data).
+int prossh_libssh_channel_flush(
+    ProSSHLibSSHHandle *handle,
+    size_t *pending,
+    char *error_buffer,
+    size_t error_buffer_len
+);
+
+// Bulk input still queued for the channel. A streaming paste feeds the queue
+// only while this is low, so it advances at the rate the window drains.
+size_t prossh_libssh_channel_queued_bulk(ProSSHLibSSHHandle *handle);
+
+// Drops the bulk input not yet written and returns its size. Bytes already
+// on the wire are not recalled; queued interactive input is kept.
+size_t prossh_libssh_channel_discard_bulk(ProSSHLibSSHHandle *handle);
+
 int prossh_libssh_channel_read(
     ProSSHLibSSHHandle *handle,
     char *output_buffer,
@@ -183,26 +240,91 @@ int prossh_libssh_copy_public_key_to_host(
     size_t error_buffer_len
 );
 
-int prossh_libssh_sftp_list_directory(
+typedef struct ProSSHSFTPEntry {
+    const char *path;
+    const char *name;
+    uint64_t size;
+    int64_t modified_time;
+    uint32_t permissions;
+    bool is_directory;
+    bool is_regular_file;
+} ProSSHSFTPEntry;
+
+// Strings in `entries` are valid only for the duration of the call. Return
+// nonzero to stop the walk.
+typedef int (*ProSSHSFTPEntryCallback)(const ProSSHSFTPEntry *entries, size_t count, void *context);
+
+// max_in_flight <= 0 selects the default read-ahead depth.
+int prossh_libssh_sftp_download_file(
     ProSSHLibSSHHandle *handle,
     const char *remote_path,
-    char *output_buffer,
-    size_t output_buffer_len,
+    const char *local_path,
+    int32_t max_in_flight,
+    int64_t *bytes_transferred,
+    int64_t *total_bytes,
+    volatile int32_t *cancel_flag,
     char *error_buffer,
     size_t error_buffer_len
 );
 
-int prossh_libssh_sftp_download_file(
+// Fills [offset, offset + length) of an existing local file. *bytes_transferred
+// holds the bytes of the range already present on entry; they are kept only if
+// they still match the remote tail.
+int prossh_libssh_sftp_download_range(
     ProSSHLibSSHHandle *handle,
     const char *remote_path,
     const char *local_path,
+    uint64_t offset,
+    uint64_t length,
+    int32_t max_in_flight,
     int64_t *bytes_transferred,
-    int64_t *total_bytes,
     volatile int32_t *cancel_flag,
     char *error_buffer,
     size_t error_buffer_len
 );
 
+int prossh_libssh_sftp_stat(
+    ProSSHLibSSHHandle *handle,
+    const char *remote_path,
+    int64_t *size,
+    int64_t *modified_time,
+    bool *is_directory,
+    char *error_buffer,
+    size_t error_buffer_len
+);
+
+// Breadth-first walk of `root_path` (only its direct children unless
+// `recursive`), delivering every entry except . and .. in pages of up to
+// 128 entries as READDIR replies arrive. Non-recursive walks are the
+// directory listing API.
+int prossh_libssh_sftp_walk(
+    ProSSHLibSSHHandle *handle,
+    const char *root_path,
+    bool recursive,
+    ProSSHSFTPEntryCallback callback,
+    void *context,
+    volatile int32_t *cancel_flag,
+    char *error_buffer,
+    size_t error_buffer_len
+);
+
+// Succeeds if the directory already exists.
+int prossh_libssh_sftp_mkdir(
+    ProSSHLibSSHHandle *handle,
+    const char *remote_path,
+    uint32_t permissions,
+    char *error_buffer,
+    size_t error_buffer_len
+);
+
+int prossh_libssh_sftp_set_mtime(
+    ProSSHLibSSHHandle *handle,
+    const char *remote_path,
+    int64_t modified_time,
+    char *error_buffer,
+    size_t error_buffer_len
+);
+
 int prossh_libssh_sftp_upload_file(
     ProSSHLibSSHHandle *handle,
     const char *local_path,
@@ -235,7 +357,25 @@ typedef struct ProSSHJumpHostConfig {
     char callback_error[512];
 } ProSSHJumpHostConfig;
 
-int prossh_libssh_connect_with_jump(
+// Shared, authenticated bastion connection. Open it once per jump host (see
+// ProSSHJumpHostConfig; `status` is 0, -2 connect, -10/-11 host key, -12 auth)
+// and connect any number of targets through it; each target rides its own
+// direct-tcpip channel. Release drops the caller's reference; the bastion closes
+// when no target tunnels remain.
+typedef struct ProSSHJumpSession ProSSHJumpSession;
+
+ProSSHJumpSession *prossh_jump_session_open(
+    ProSSHJumpHostConfig *config,
+    int *status,
+    char *error_buffer,
+    size_t error_buffer_len
+);
+// Only valid while the caller already holds a reference.
+void prossh_jump_session_retain(ProSSHJumpSession *jump);
+int prossh_jump_session_is_alive(ProSSHJumpSession *jump);
+void prossh_jump_session_release(ProSSHJumpSession *jump);
+
+int prossh_libssh_connect_through_jump(
     ProSSHLibSSHHandle *handle,
     const char *hostname,
     uint16_t port,
@@ -244,8 +384,9 @@ int prossh_libssh_connect_with_jump(
     const char *ciphers,
     const char *hostkeys,
     const char *macs,
+    const char *compression,
     int timeout_seconds,
-    ProSSHJumpHostConfig *jump_config,
+    ProSSHJumpSession *jump,
     char *error_buffer,
     size_t error_buffer_len
 );
@@ -258,14 +399,27 @@ int prossh_libssh_channel_resize_pty(
     size_t error_buffer_len
 );
 
-int prossh_libssh_send_keepalive(ProSSHLibSSHHandle *handle);
+// Keepalive probe. Returns 1 when packets moved since the previous call (no probe
+// needed), 0 when a probe was sent, -1 for an invalid handle, -2 when the
+// connection is gone. `dead_peer_timeout_s` > 0 bounds how long the kernel keeps
+// retransmitting an unacknowledged probe before dropping the connection.
+int prossh_libssh_send_keepalive(ProSSHLibSSHHandle *handle, int dead_peer_timeout_s);
 
 void prossh_libssh_channel_close(ProSSHLibSSHHandle *handle);
 void prossh_libssh_disconnect(ProSSHLibSSHHandle *handle);
 
-typedef struct ProSSHForwardChannel ProSSHForwardChannel;
-
-ProSSHForwardChannel *prossh_forward_channel_open(
+// Shared kqueue loop: `callback` fires on the loop thread when the session socket
+// turns readable (after `prossh_io_loop_arm`) or when a call consumed inbound packets.
+int prossh_io_loop_register(ProSSHLibSSHHandle *handle, ProSSHIOReadyCallback callback, void *context);
+void prossh_io_loop_arm(ProSSHLibSSHHandle *handle);
+void prossh_io_loop_unregister(ProSSHLibSSHHandle *handle);
+
+// Sends a direct-tcpip open without waiting for the reply, so concurrent opens
+// share one round trip. Returns NULL on immediate failure. Otherwise poll with
+// prossh_forward_channel_open_poll (0 open, 1 still waiting, -1 refused) on each
+// readiness signal. The channel must be closed with prossh_forward_channel_close
+// whatever the outcome.
+ProSSHForwardChannel *prossh_forward_channel_open_start(
     ProSSHLibSSHHandle *handle,
     const char *remote_host,
     uint16_t remote_port,
@@ -275,6 +429,12 @@ ProSSHForwardChannel *prossh_forward_channel_open(
     size_t error_buffer_len
 );
 
+int prossh_forward_channel_open_poll(
+    ProSSHForwardChannel *fwd,
+    char *error_buffer,
+    size_t error_buffer_len
+);
+
 int prossh_forward_channel_read(
     ProSSHForwardChannel *fwd,
     char *buffer,
@@ -284,6 +444,9 @@ int prossh_forward_channel_read(
     size_t error_buffer_len
 );
 
+// Writes as much of `data` as the channel window admits and returns the byte
+// count (0 while the window is shut), or -1 on error. Never waits for a window
+// adjust; retry the remainder after the next readiness signal.
 int prossh_forward_channel_write(
     ProSSHForwardChannel *fwd,
     const char *data,
@@ -296,4 +459,45 @@ int prossh_forward_channel_is_open(ProSSHForwardChannel *fwd);
 
 void prossh_forward_channel_close(ProSSHForwardChannel *fwd);
 
+// Exec channels: runs `command` on a new session channel without touching the
+// shell. Opening is pipelined like a forward channel: poll with
+// prossh_forward_channel_open_poll, read stdout with prossh_forward_channel_read
+// (its EOF covers both streams), close with prossh_forward_channel_close.
+ProSSHForwardChannel *prossh_exec_channel_open_start(
+    ProSSHLibSSHHandle *handle,
+    const char *command,
+    char *error_buffer,
+    size_t error_buffer_len
+);
+
+int prossh_exec_channel_read_stderr(
+    ProSSHForwardChannel *fwd,
+    char *buffer,
+    size_t buffer_len,
+    char *error_buffer,
+    size_t error_buffer_len
+);
+
+// 1 with `exit_code` set (-1 when killed by a signal), 0 while still running,
+// -1 if the channel closed without reporting one.
+int prossh_exec_channel_exit_status(ProSSHForwardChannel *fwd, int *exit_code);
+
+// Remote (-R) forwarding. Listen asks the server to accept connections on
+// address:port (empty address = the server's loopback; port 0 lets the server
+// pick, see prossh_remote_forward_bound_port). Connections the server forwards
+// are queued on the listener; accept dequeues one (1), reports none pending (0)
+// or a closed session (-1) and never blocks, so wait on the session's readiness
+// signal between calls. Accepted channels behave like prossh_forward_channel_*
+// channels. Close cancels the listener on the server and frees it.
+ProSSHRemoteForward *prossh_remote_forward_listen(
+    ProSSHLibSSHHandle *handle,
+    const char *address,
+    uint16_t port,
+    char *error_buffer,
+    size_t error_buffer_len
+);
+uint16_t prossh_remote_forward_bound_port(ProSSHRemoteForward *forward);
+int prossh_remote_forward_accept(ProSSHRemoteForward *forward, ProSSHForwardChannel **accepted);
+void prossh_remote_forward_close(ProSSHRemoteForward *forward);
+
 #endif /* ProSSHLibSSHWrapper_h */
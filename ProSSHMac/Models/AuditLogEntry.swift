@@ -1,6 +1,6 @@
 import Foundation
 
-enum AuditLogCategory: String, Codable, CaseIterable, Sendable {
+nonisolated enum AuditLogCategory: String, Codable, CaseIterable, Sendable {
     case connection
     case authentication
     case hostVerification
@@ -26,14 +26,14 @@ enum AuditLogCategory: String, Codable, CaseIterable, Sendable {
     }
 }
 
-enum AuditLogOutcome: String, Codable, Sendable {
+nonisolated enum AuditLogOutcome: String, Codable, Sendable {
     case info
     case success
     case warning
     case failure
 }
 
-struct AuditLogEntry: Identifiable, Codable, Hashable, Sendable {
+nonisolated struct AuditLogEntry: Identifiable, Codable, Hashable, Sendable {
     var id: UUID
     var timestamp: Date
     var category: AuditLogCategory
@@ -25,22 +25,125 @@ struct AlgorithmPreferences: Codable, Hashable, Sendable {
     var macs: [String] = []
 }
 
+/// Transport compression (zlib@openssh.com). `.auto` enables it for a host
+/// whose last measured link rate was below the transport's threshold, so slow
+/// links (tethering, satellite) get the win without paying the CPU cost on LAN.
+enum SSHCompressionMode: String, Codable, CaseIterable, Identifiable, Sendable {
+    case off
+    case on
+    case auto
+
+    var id: String { rawValue }
+
+    var title: String {
+        switch self {
+        case .off: return "Off"
+        case .on: return "On"
+        case .auto: return "Automatic"
+        }
+    }
+
+    /// `measuredBytesPerSecond` is nil until a bulk transfer on this route has
+    /// been measured; `.auto` stays off until then.
+    nonisolated func shouldCompress(measuredBytesPerSecond: Int64?, threshold: Int64) -> Bool {
+        switch self {
+        case .off: return false
+        case .on: return true
+        case .auto:
+            guard let rate = measuredBytesPerSecond, rate > 0 else { return false }
+            return rate < threshold
+        }
+    }
+}
+
+/// How a forwarding rule routes traffic. `.local` is `ssh -L` to one fixed
+/// destination; `.dynamic` is `ssh -D`, a SOCKS5 listener that picks the
+/// destination per connection (remoteHost/remotePort are unused).
+enum PortForwardingKind: String, Codable, CaseIterable, Identifiable, Sendable {
+    case local
+    case dynamic
+    case remote
+
+    var id: String { rawValue }
+
+    var title: String {
+        switch self {
+        case .local: return "Local"
+        case .dynamic: return "Dynamic (SOCKS5)"
+        case .remote: return "Remote"
+        }
+    }
+}
+
 struct PortForwardingRule: Identifiable, Codable, Hashable, Sendable {
     var id: UUID
+    var kind: PortForwardingKind
     var localPort: UInt16
     var remoteHost: String
     var remotePort: UInt16
     var label: String
     var isEnabled: Bool
 
-    init(id: UUID = UUID(), localPort: UInt16, remoteHost: String, remotePort: UInt16, label: String = "", isEnabled: Bool = true) {
+    init(
+        id: UUID = UUID(),
+        kind: PortForwardingKind = .local,
+        localPort: UInt16,
+        remoteHost: String,
+        remotePort: UInt16,
+        label: String = "",
+        isEnabled: Bool = true
+    ) {
         self.id = id
+        self.kind = kind
         self.localPort = localPort
         self.remoteHost = remoteHost
         self.remotePort = remotePort
-        self.label = label.isEmpty ? "\(localPort) → \(remoteHost):\(remotePort)" : label
+        self.label = label.isEmpty ? Self.defaultLabel(kind: kind, localPort: localPort, remoteHost: remoteHost, remotePort: remotePort) : label
         self.isEnabled = isEnabled
     }
+
+    /// A SOCKS5 listener on `localPort`; the destination comes from each client.
+    static func dynamic(localPort: UInt16, label: String = "", isEnabled: Bool = true) -> PortForwardingRule {
+        PortForwardingRule(kind: .dynamic, localPort: localPort, remoteHost: "", remotePort: 0, label: label, isEnabled: isEnabled)
+    }
+
+    /// A server-side listener on `remoteHost:remotePort` (empty host = the
+    /// server's loopback) whose connections go to localhost:`localPort`.
+    static func remote(bindAddress: String = "", remotePort: UInt16, localPort: UInt16, label: String = "", isEnabled: Bool = true) -> PortForwardingRule {
+        PortForwardingRule(kind: .remote, localPort: localPort, remoteHost: bindAddress, remotePort: remotePort, label: label, isEnabled: isEnabled)
+    }
+
+    /// One-line route description, e.g. "localhost:8080 → db:5432".
+    var routeDescription: String {
+        switch kind {
+        case .local: return "localhost:\(localPort) \u{2192} \(remoteHost):\(remotePort)"
+        case .dynamic: return "SOCKS5 on localhost:\(localPort)"
+        case .remote: return "remote \(remoteHost.isEmpty ? "localhost" : remoteHost):\(remotePort) \u{2192} localhost:\(localPort)"
+        }
+    }
+
+    private static func defaultLabel(kind: PortForwardingKind, localPort: UInt16, remoteHost: String, remotePort: UInt16) -> String {
+        switch kind {
+        case .local: return "\(localPort) → \(remoteHost):\(remotePort)"
+        case .dynamic: return "SOCKS \(localPort)"
+        case .remote: return "R \(remotePort) → localhost:\(localPort)"
+        }
+    }
+
+    private enum CodingKeys: String, CodingKey {
+        case id, kind, localPort, remoteHost, remotePort, label, isEnabled
+    }
+
+    init(from decoder: Decoder) throws {
+        let container = try decoder.container(keyedBy: CodingKeys.self)
+        id = try container.decode(UUID.self, forKey: .id)
+        kind = try container.decodeIfPresent(PortForwardingKind.self, forKey: .kind) ?? .local
+        localPort = try container.decode(UInt16.self, forKey: .localPort)
+        remoteHost = try container.decode(String.self, forKey: .remoteHost)
+        remotePort = try container.decode(UInt16.self, forKey: .remotePort)
+        label = try container.decode(String.self, forKey: .label)
+        isEnabled = try container.decode(Bool.self, forKey: .isEnabled)
+    }
 }
 
 enum ShellIntegrationType: String, Codable, CaseIterable, Sendable {
@@ -77,6 +180,7 @@ struct Host: Identifiable, Codable, Hashable, Sendable {
     var agentForwardingEnabled: Bool
     var portForwardingRules: [PortForwardingRule]
     var legacyModeEnabled: Bool
+    var compression: SSHCompressionMode
     var shellIntegration: ShellIntegrationConfig
     var tags: [String]
     var notes: String?
@@ -102,6 +206,7 @@ struct Host: Identifiable, Codable, Hashable, Sendable {
         agentForwardingEnabled: Bool = false,
         portForwardingRules: [PortForwardingRule] = [],
         legacyModeEnabled: Bool,
+        compression: SSHCompressionMode = .auto,
         shellIntegration: ShellIntegrationConfig = .init(),
         tags: [String],
         notes: String?,
@@ -126,6 +231,7 @@ struct Host: Identifiable, Codable, Hashable, Sendable {
         self.agentForwardingEnabled = agentForwardingEnabled
         self.portForwardingRules = portForwardingRules
         self.legacyModeEnabled = legacyModeEnabled
+        self.compression = compression
         self.shellIntegration = shellIntegration
         self.tags = tags
         self.notes = notes
@@ -152,6 +258,7 @@ struct Host: Identifiable, Codable, Hashable, Sendable {
         case agentForwardingEnabled
         case portForwardingRules
         case legacyModeEnabled
+        case compression
         case shellIntegration
         case tags
         case notes
@@ -179,6 +286,7 @@ struct Host: Identifiable, Codable, Hashable, Sendable {
         agentForwardingEnabled = try container.decodeIfPresent(Bool.self, forKey: .agentForwardingEnabled) ?? false
         portForwardingRules = try container.decodeIfPresent([PortForwardingRule].self, forKey: .portForwardingRules) ?? []
         legacyModeEnabled = try container.decodeIfPresent(Bool.self, forKey: .legacyModeEnabled) ?? false
+        compression = try container.decodeIfPresent(SSHCompressionMode.self, forKey: .compression) ?? .auto
         shellIntegration = (try? container.decodeIfPresent(ShellIntegrationConfig.self, forKey: .shellIntegration)) ?? .init()
         tags = try container.decodeIfPresent([String].self, forKey: .tags) ?? []
         notes = try container.decodeIfPresent(String.self, forKey: .notes)
@@ -206,6 +314,7 @@ struct Host: Identifiable, Codable, Hashable, Sendable {
         try container.encode(agentForwardingEnabled, forKey: .agentForwardingEnabled)
         try container.encode(portForwardingRules, forKey: .portForwardingRules)
         try container.encode(legacyModeEnabled, forKey: .legacyModeEnabled)
+        try container.encode(compression, forKey: .compression)
         try container.encode(shellIntegration, forKey: .shellIntegration)
         try container.encode(tags, forKey: .tags)
         try container.encodeIfPresent(notes, forKey: .notes)
@@ -269,6 +378,7 @@ struct HostDraft: Equatable {
     var username: String = ""
     var authMethod: AuthMethod = .publicKey
     var legacyModeEnabled: Bool = false
+    var compression: SSHCompressionMode = .auto
     var shellIntegrationType: ShellIntegrationType = .none
     var customPromptRegex: String = ""
     var pinnedHostKeyAlgorithms: String = ""
@@ -336,6 +446,7 @@ struct HostDraft: Equatable {
             agentForwardingEnabled: agentForwardingEnabled,
             portForwardingRules: portForwardingRules,
             legacyModeEnabled: legacyModeEnabled,
+            compression: compression,
             shellIntegration: ShellIntegrationConfig(type: shellIntegrationType, customPromptRegex: customPromptRegex),
             tags: parsedTags,
             notes: notes.trimmingCharacters(in: .whitespacesAndNewlines).isEmpty ? nil : notes.trimmingCharacters(in: .whitespacesAndNewlines),
@@ -373,6 +484,7 @@ extension HostDraft {
         self.username = host.username
         self.authMethod = host.authMethod
         self.legacyModeEnabled = host.legacyModeEnabled
+        self.compression = host.compression
         self.shellIntegrationType = host.shellIntegration.type
         self.customPromptRegex = host.shellIntegration.customPromptRegex
         self.pinnedHostKeyAlgorithms = host.pinnedHostKeyAlgorithms.joined(separator: ", ")
@@ -25,6 +25,9 @@ struct Transfer: Identifiable, Codable, Hashable {
     var state: TransferState
     var createdAt: Date
     var updatedAt: Date
+    /// Set for files discovered by a folder transfer; copied onto the
+    /// destination on completion so a later sync can skip it.
+    var sourceModifiedAt: Date? = nil
 
     /// Fractional progress (0.0–1.0). Returns 0 when `totalBytes` is zero.
     var progress: Double {
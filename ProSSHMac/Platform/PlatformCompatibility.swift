@@ -1,17 +1,60 @@
 import Foundation
 import SwiftUI
 import AppKit
+import UniformTypeIdentifiers
 
 enum PlatformClipboard {
     static func readString() -> String? {
         return NSPasteboard.general.string(forType: .string)
     }
 
+    /// The pasteboard text as UTF-8 bytes, without bridging it to a String.
+    static func readData() -> Data? {
+        NSPasteboard.general.data(forType: .string)
+    }
+
     @discardableResult
     static func writeString(_ value: String) -> Bool {
         NSPasteboard.general.clearContents()
         return NSPasteboard.general.setString(value, forType: .string)
     }
+
+    /// Put a string on the pasteboard that `makeData` produces as UTF-8
+    /// only when it is pasted.
+    @MainActor
+    @discardableResult
+    static func writeLazily(_ makeData: @escaping @Sendable () -> Data) -> Bool {
+        let provider = LazyPasteboardProvider(makeData: makeData)
+        let item = NSPasteboardItem()
+        guard item.setDataProvider(provider, forTypes: [.string]) else { return false }
+        NSPasteboard.general.clearContents()
+        guard NSPasteboard.general.writeObjects([item]) else { return false }
+        // Keep the provider alive until the pasteboard is done with it.
+        LazyPasteboardProvider.current = provider
+        return true
+    }
+}
+
+private final class LazyPasteboardProvider: NSObject, NSPasteboardItemDataProvider, @unchecked Sendable {
+    @MainActor static var current: LazyPasteboardProvider?
+
+    private let makeData: @Sendable () -> Data
+
+    init(makeData: @escaping @Sendable () -> Data) {
+        self.makeData = makeData
+    }
+
+    nonisolated func pasteboard(_ pasteboard: NSPasteboard?, item: NSPasteboardItem, provideDataForType type: NSPasteboard.PasteboardType) {
+        item.setData(makeData(), forType: type)
+    }
+
+    nonisolated func pasteboardFinishedWithDataProvider(_ pasteboard: NSPasteboard) {
+        Task { @MainActor in
+            if LazyPasteboardProvider.current === self {
+                LazyPasteboardProvider.current = nil
+            }
+        }
+    }
 }
 
 enum PlatformDevice {
@@ -25,6 +68,19 @@ enum PlatformURL {
     static func openInBrowser(_ url: URL) {
         NSWorkspace.shared.open(url)
     }
+
+    /// Opens a local file in the app registered for it, or in the default
+    /// text editor when nothing is (config files often have no extension).
+    @MainActor
+    static func openInEditor(_ url: URL) {
+        let workspace = NSWorkspace.shared
+        guard let editor = workspace.urlForApplication(toOpen: url)
+                ?? workspace.urlForApplication(toOpen: .plainText) else {
+            workspace.open(url)
+            return
+        }
+        workspace.open([url], withApplicationAt: editor, configuration: NSWorkspace.OpenConfiguration())
+    }
 }
 
 extension View {
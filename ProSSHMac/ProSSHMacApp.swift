@@ -5,6 +5,7 @@ import Foundation
 @main
 struct ProSSHMacApp: App {
     static let externalTerminalWindowID = "external-terminal-window"
+    static let sessionMirrorWindowID = "session-mirror-window"
 
     @Environment(\.scenePhase) private var scenePhase
     @AppStorage("app.appearance") private var appAppearanceRawValue = AppAppearance.system.rawValue
@@ -52,11 +53,21 @@ struct ProSSHMacApp: App {
                 }
         }
         .defaultSize(width: 1100, height: 750)
+        .commands {
+            CommandGroup(after: .newItem) {
+                WatchMirroredSessionCommand()
+            }
+        }
 
         WindowGroup("Terminal", id: Self.externalTerminalWindowID, for: UUID.self) { $sessionID in
             configuredRoot(content: ExternalTerminalWindowView(sessionID: sessionID))
         }
         .defaultSize(width: 900, height: 600)
+
+        WindowGroup("Watch Session", id: Self.sessionMirrorWindowID) {
+            configuredRoot(content: SessionMirrorWindowView())
+        }
+        .defaultSize(width: 900, height: 600)
     }
 
     private var currentAppearance: AppAppearance {
@@ -9,6 +9,9 @@ import os.log
     init() {}
     nonisolated deinit {}
 
+    /// Past commands offered with each prompt, at most.
+    static let relatedCommandLimit = 3
+
     // MARK: - Agent Loop
 
     func run(
@@ -64,6 +67,13 @@ import os.log
 
         let screenLines = service.sessionProvider.shellBuffers[sessionID] ?? []
         let screenSnapshot = screenLines.suffix(20).joined(separator: "\n")
+        // A few past commands related to the prompt, from any session,
+        // instead of scrollback the model would have to dig through.
+        let relatedBlocks = await service.sessionProvider.relevantCommandBlocks(
+            query: trimmedPrompt,
+            limit: Self.relatedCommandLimit
+        )
+        let relatedCommands = Self.relatedCommandsContext(relatedBlocks, currentSessionID: sessionID)
 
         // Build session map context for broadcast mode
         var broadcastPreamble = ""
@@ -78,9 +88,9 @@ import os.log
 
         let userMessageText: String
         if !screenSnapshot.isEmpty {
-            userMessageText = broadcastPreamble + "[Current terminal screen — use this to identify the environment, OS, device type, and current path/mode before acting]\n```\n\(screenSnapshot)\n```\n\n\(trimmedPrompt)"
+            userMessageText = broadcastPreamble + "[Current terminal screen — use this to identify the environment, OS, device type, and current path/mode before acting]\n```\n\(screenSnapshot)\n```\n\n\(relatedCommands)\(trimmedPrompt)"
         } else {
-            userMessageText = broadcastPreamble + trimmedPrompt
+            userMessageText = broadcastPreamble + relatedCommands + trimmedPrompt
         }
 
         var pendingMessages: [LLMMessage] = [
@@ -90,8 +100,25 @@ import os.log
         var pendingToolOutputs: [LLMToolOutput] = []
         var totalToolCalls = 0
 
+        let toolHandler = service.toolHandler
         for iteration in 1...iterationLimit {
             let iterationStart = DispatchTime.now().uptimeNanoseconds
+            // Read-only calls start as soon as their arguments finish
+            // streaming; whatever the final response does not keep is
+            // cancelled when the iteration ends.
+            let speculativeCalls = AISpeculativeToolCalls(
+                readOnlyToolNames: AIToolDefinitions.concurrentToolNames
+            ) { toolCall in
+                Task { @MainActor in
+                    await toolHandler.executeReadOnlyToolCall(
+                        sessionID: sessionID,
+                        broadcastContext: broadcastContext,
+                        toolCall: toolCall,
+                        traceID: traceID
+                    )
+                }
+            }
+            defer { speculativeCalls.finish() }
             let request = LLMRequest(
                 messages: pendingMessages,
                 tools: activeToolDefinitions,
@@ -106,6 +133,7 @@ import os.log
                 request: request,
                 conversationState: &conversationState,
                 traceID: traceID,
+                speculativeCalls: speculativeCalls,
                 streamHandler: streamHandler
             )
             let responseMs = AIToolDefinitions.elapsedMillis(since: iterationStart)
@@ -117,6 +145,13 @@ import os.log
                 service.conversationContext.clear(sessionID: sessionID)
             }
 
+            if let usage = response.usage {
+                let total = service.conversationContext.record(usage: usage, for: sessionID)
+                Self.logger.debug(
+                    "[\(traceID, privacy: .public)] iteration_usage i=\(iteration) input_tokens=\(usage.inputTokens) cached_tokens=\(usage.cachedInputTokens) cache_write_tokens=\(usage.cacheWriteInputTokens) output_tokens=\(usage.outputTokens) conversation_cached=\(total.cachedInputTokens)/\(total.inputTokens)"
+                )
+            }
+
             let toolCalls = response.toolCalls
             let responseIDString = response.updatedConversationState.stringValue ?? ""
             Self.logger.debug(
@@ -140,7 +175,8 @@ import os.log
                 sessionID: sessionID,
                 broadcastContext: broadcastContext,
                 toolCalls: toolCalls,
-                traceID: traceID
+                traceID: traceID,
+                speculativeCalls: speculativeCalls
             )
             let toolMs = AIToolDefinitions.elapsedMillis(since: toolStart)
             Self.logger.debug(
@@ -162,6 +198,7 @@ import os.log
         request: LLMRequest,
         conversationState: inout LLMConversationState?,
         traceID: String,
+        speculativeCalls: AISpeculativeToolCalls,
         streamHandler: (@Sendable (AIAgentStreamEvent) -> Void)?
     ) async throws -> LLMResponse {
         guard let service else {
@@ -171,7 +208,7 @@ import os.log
         do {
             return try await runWithTimeout(timeoutSeconds: timeoutSeconds) {
                 try await service.sendProviderRequest(request) { streamEvent in
-                    Self.forward(streamEvent: streamEvent, to: streamHandler)
+                    Self.forward(streamEvent: streamEvent, to: streamHandler, speculativeCalls: speculativeCalls)
                 }
             }
         } catch let error as LLMProviderError {
@@ -197,7 +234,7 @@ import os.log
             )
             return try await runWithTimeout(timeoutSeconds: timeoutSeconds) {
                 try await service.sendProviderRequest(retryRequest) { streamEvent in
-                    Self.forward(streamEvent: streamEvent, to: streamHandler)
+                    Self.forward(streamEvent: streamEvent, to: streamHandler, speculativeCalls: speculativeCalls)
                 }
             }
         }
@@ -205,8 +242,13 @@ import os.log
 
     nonisolated private static func forward(
         streamEvent: LLMStreamEvent,
-        to streamHandler: (@Sendable (AIAgentStreamEvent) -> Void)?
+        to streamHandler: (@Sendable (AIAgentStreamEvent) -> Void)?,
+        speculativeCalls: AISpeculativeToolCalls
     ) {
+        if case let .toolCallReady(toolCall) = streamEvent {
+            speculativeCalls.offer(toolCall)
+            return
+        }
         guard let streamHandler else { return }
         switch streamEvent {
         case let .textDelta(delta):
@@ -221,6 +263,8 @@ import os.log
             streamHandler(.reasoningSummaryDelta(delta))
         case let .reasoningSummaryDone(text):
             streamHandler(.reasoningSummaryDone(text))
+        case .toolCallReady:
+            break
         }
     }
 
@@ -246,4 +290,40 @@ import os.log
             return result
         }
     }
+
+    // MARK: - Related Commands
+
+    /// A section naming past commands related to the prompt, with how they
+    /// exited and the last lines of their output; empty without any. Block
+    /// ids, and the session for blocks from another one, let the model
+    /// fetch full output with get_command_output.
+    static func relatedCommandsContext(
+        _ blocks: [CommandBlock],
+        currentSessionID: UUID,
+        now: Date = .now
+    ) -> String {
+        guard !blocks.isEmpty else { return "" }
+        let formatter = RelativeDateTimeFormatter()
+        formatter.unitsStyle = .full
+        let entries = blocks.map { block -> String in
+            let status = block.exitCode.map { "exit \($0)" } ?? "exit unknown"
+            let age = formatter.localizedString(for: block.completedAt, relativeTo: now)
+            var reference = "block \(block.id.uuidString.lowercased())"
+            if block.sessionID != currentSessionID {
+                reference += ", session \(block.sessionID.uuidString)"
+            }
+            var entry = "- `\(block.command)` (\(status), \(age), \(reference))"
+            let tail = block.output
+                .split(whereSeparator: \.isNewline)
+                .map { $0.trimmingCharacters(in: .whitespaces) }
+                .filter { !$0.isEmpty }
+                .suffix(3)
+                .map { String($0.prefix(160)) }
+            if !tail.isEmpty {
+                entry += "\n  " + tail.joined(separator: "\n  ")
+            }
+            return entry
+        }
+        return "[Earlier commands related to this request]\n" + entries.joined(separator: "\n") + "\n\n"
+    }
 }
@@ -3,6 +3,9 @@ import Foundation
 
 @MainActor final class AIConversationContext {
     private(set) var stateBySessionID: [UUID: LLMConversationState] = [:]
+    /// Token usage summed over every request of the session's conversation,
+    /// so prompt-cache hits can be compared turn over turn.
+    private(set) var usageBySessionID: [UUID: LLMTokenUsage] = [:]
 
     init() {}
     nonisolated deinit {}
@@ -15,7 +18,20 @@ import Foundation
         stateBySessionID[sessionID] = state
     }
 
+    func usage(for sessionID: UUID) -> LLMTokenUsage? {
+        usageBySessionID[sessionID]
+    }
+
+    /// Adds one request's usage and returns the conversation total.
+    @discardableResult
+    func record(usage: LLMTokenUsage, for sessionID: UUID) -> LLMTokenUsage {
+        let total = usageBySessionID[sessionID].map { $0 + usage } ?? usage
+        usageBySessionID[sessionID] = total
+        return total
+    }
+
     func clear(sessionID: UUID) {
         stateBySessionID.removeValue(forKey: sessionID)
+        usageBySessionID.removeValue(forKey: sessionID)
     }
 }
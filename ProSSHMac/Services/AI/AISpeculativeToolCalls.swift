@@ -0,0 +1,56 @@
+import Foundation
+
+/// Read-only tool calls started while the response that asks for them is
+/// still streaming, so their latency overlaps generation instead of
+/// following it. Calls are offered from the provider's stream callback on
+/// any thread; the agent runner later adopts each one in place of running
+/// it again. The first call that may change something stops speculation:
+/// calls after it could depend on its effect, and it still waits for the
+/// normal dispatch (and any approval it needs).
+nonisolated final class AISpeculativeToolCalls: @unchecked Sendable {
+    typealias Start = @Sendable (LLMToolCall) -> Task<LLMToolOutput, Never>
+
+    private let readOnlyToolNames: Set<String>
+    private let start: Start
+    private let lock = NSLock()
+    private var started: [String: (name: String, task: Task<LLMToolOutput, Never>)] = [:]
+    private var isClosed = false
+
+    init(readOnlyToolNames: Set<String>, start: @escaping Start) {
+        self.readOnlyToolNames = readOnlyToolNames
+        self.start = start
+    }
+
+    /// Starts `call` if it is read-only and nothing mutating came before it.
+    /// Calls offered again, as after a retried request, are ignored.
+    func offer(_ call: LLMToolCall) {
+        lock.withLock {
+            guard !isClosed, !call.id.isEmpty, started[call.id] == nil else { return }
+            guard readOnlyToolNames.contains(call.name) else {
+                isClosed = true
+                return
+            }
+            started[call.id] = (call.name, start(call))
+        }
+    }
+
+    /// The task already running `call`, handed over once; nil when it was
+    /// never started.
+    func take(_ call: LLMToolCall) -> Task<LLMToolOutput, Never>? {
+        lock.withLock {
+            guard let entry = started[call.id], entry.name == call.name else { return nil }
+            started[call.id] = nil
+            return entry.task
+        }
+    }
+
+    /// Stops speculating and cancels calls the final response did not keep.
+    func finish() {
+        let abandoned = lock.withLock {
+            isClosed = true
+            defer { started = [:] }
+            return started.values.map(\.task)
+        }
+        abandoned.forEach { $0.cancel() }
+    }
+}
@@ -20,6 +20,7 @@ enum AIToolDefinitions {
         - For interactive or long-running commands (vim, nano, top, tail -f, ssh), use execute_command (fire-and-forget), then get_current_screen to see the result.
         - To interact with a running process (answer prompts, send Ctrl+C, Tab-complete), use send_input. After send_input, call get_current_screen to see the response.
         - Always check exit_code after execute_and_wait: 0 = success, non-zero = failure. Investigate failures by reading the output.
+        - For commands with large output (builds, logs, find), pass execute_and_wait a filter so only relevant lines come back; unfiltered long output keeps only its beginning and end.
         - Chain multiple commands as needed. Do not stop after one if the task requires more.
 
         CONTEXT:
@@ -237,7 +238,7 @@ enum AIToolDefinitions {
             ),
             LLMToolDefinition(
                 name: "execute_and_wait",
-                description: "Execute a shell command and wait for it to complete, returning the output and exit code directly. Use this for one-shot commands (ls, grep, git, make, curl, etc.). Do NOT use for interactive or long-running programs (vim, nano, top, tail -f, ssh) — use execute_command instead. Returns: output text, exit_code (integer), timed_out (bool), truncated (bool).",
+                description: "Execute a shell command and wait for it to complete, returning the output and exit code directly. Use this for one-shot commands (ls, grep, git, make, curl, etc.). Do NOT use for interactive or long-running programs (vim, nano, top, tail -f, ssh) — use execute_command instead. Long output keeps its first 12 KB and last 4 KB with a line saying how much was omitted. Returns: output text, exit_code (integer), truncated (bool), total_bytes and total_lines of the full output.",
                 parameters: .object([
                     "type": .string("object"),
                     "properties": .object([
@@ -249,9 +250,13 @@ enum AIToolDefinitions {
                             "type": .string("integer"),
                             "description": .string("Max seconds to wait for completion (5-60, default 30)."),
                         ]),
+                        "filter": .object([
+                            "type": .array([.string("string"), .string("null")]),
+                            "description": .string("Extended regular expression applied on the host to stdout and stderr; only matching lines are returned. Null returns everything."),
+                        ]),
                         "target_session": targetSessionProperty,
                     ]),
-                    "required": .array([.string("command"), .string("timeout_seconds"), .string("target_session")]),
+                    "required": .array([.string("command"), .string("timeout_seconds"), .string("filter"), .string("target_session")]),
                     "additionalProperties": commonNoExtraProperties,
                 ]),
                 strict: true
@@ -260,6 +265,21 @@ enum AIToolDefinitions {
           + [SendInputToolDefinition.definition()]
     }
 
+    // MARK: - Concurrency
+
+    /// Tools that only read state, so calls from one model turn may run side
+    /// by side. Everything else (`execute_command`, `execute_and_wait`,
+    /// `apply_patch`, `send_input`) runs alone, in call order.
+    static let concurrentToolNames: Set<String> = [
+        "get_command_output", "get_current_screen", "get_recent_commands",
+        "search_terminal_history", "search_filesystem", "search_file_contents",
+        "read_file_chunk", "read_files", "get_session_info",
+    ]
+
+    /// Read-only calls in flight per session. Each remote call may hold an
+    /// exec channel, and sshd's default `MaxSessions` is 10.
+    static let maxConcurrentToolCallsPerSession = 4
+
     // MARK: - Direct Action Tool Filtering
 
     static func directActionToolDefinitions(
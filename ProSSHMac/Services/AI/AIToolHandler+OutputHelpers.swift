@@ -15,6 +15,50 @@ extension AIToolHandler {
         ])
     }
 
+    /// A host metrics sample for `get_current_screen` and `get_session_info`,
+    /// with fractions rounded to what a model needs.
+    static func hostMetricsValue(_ metrics: RemoteHostMetrics) -> LLMJSONValue {
+        func rounded(_ value: Double) -> LLMJSONValue {
+            .number((value * 100).rounded() / 100)
+        }
+        return .object([
+            "os": .string(metrics.operatingSystem),
+            "cpus": .number(Double(metrics.processorCount)),
+            "load": .array(metrics.load.map(rounded)),
+            "memory_total_bytes": .number(Double(metrics.memoryTotalBytes)),
+            "memory_used_fraction": metrics.memoryUsedFraction.map(rounded) ?? .null,
+            "disk_total_bytes": .number(Double(metrics.diskTotalBytes)),
+            "disk_used_fraction": metrics.diskUsedFraction.map(rounded) ?? .null,
+            "uptime_seconds": .number(metrics.uptimeSeconds.rounded()),
+            "sampled_at": .string(ISO8601DateFormatter().string(from: Date(timeIntervalSince1970: metrics.timestamp))),
+        ])
+    }
+
+    /// `execute_and_wait` fields for one command: the head and tail of its
+    /// output that `ToolOutputRing` keeps, and counts for the whole of it.
+    /// Filtered output ends with the command's status on a marker line,
+    /// which stands in for the exit code of the filter itself.
+    static func boundedCommandOutputFields(
+        _ result: CommandExecutionResult,
+        filtered: Bool
+    ) -> [String: LLMJSONValue] {
+        var output = result.output
+        var exitCode = result.exitCode
+        if filtered {
+            let parsed = parseRemoteWrappedCommandOutput(output, marker: remoteFilterStatusMarker)
+            output = parsed.output
+            exitCode = parsed.exitCode
+        }
+        let ring = ToolOutputRing(text: output)
+        return [
+            "output": .string(ring.text),
+            "exit_code": exitCode.map { .number(Double($0)) } ?? .null,
+            "truncated": .bool(ring.isTruncated),
+            "total_bytes": .number(Double(ring.byteCount)),
+            "total_lines": .number(Double(ring.lineCount)),
+        ]
+    }
+
     static func parseReadFileChunkOutput(
         _ output: String,
         path: String,
@@ -56,6 +100,118 @@ extension AIToolHandler {
         ])
     }
 
+    /// Parses `buildRemoteReadRangeCommand` output. `byteOffset` is the
+    /// offset the read was seeded with; the trailer's next-line offset is
+    /// relative to the byte before it.
+    static func parseRemoteReadRangeOutput(
+        _ output: String,
+        path: String,
+        startLine: Int,
+        byteOffset: Int?
+    ) -> RemoteReadRangeOutcome {
+        let normalized = output
+            .replacingOccurrences(of: "\r\n", with: "\n")
+            .replacingOccurrences(of: "\r", with: "\n")
+        let lines = normalized.split(separator: "\n", omittingEmptySubsequences: false).map(String.init)
+
+        if lines.contains(remotePathNotFoundToken) {
+            return .range(.object([
+                "ok": .bool(false),
+                "error": .string("Path does not exist: \(path)"),
+            ]), nextLine: nil, nextOffset: nil)
+        }
+        if lines.contains(remoteNotRegularFileToken) {
+            return .range(.object([
+                "ok": .bool(false),
+                "error": .string("Path is not a regular file: \(path)"),
+            ]), nextLine: nil, nextOffset: nil)
+        }
+
+        if RemotePatchCommandBuilder.outputIndicatesCacheHit(output) {
+            return .cacheHit
+        }
+
+        let trailerPrefix = "\(remoteReadRangeMarker):"
+        guard let headerIndex = lines.firstIndex(of: remoteReadRangeMarker),
+              let trailerIndex = lines.lastIndex(where: { $0.hasPrefix(trailerPrefix) }),
+              trailerIndex > headerIndex else {
+            return .unparsed
+        }
+        let fields = lines[trailerIndex].dropFirst(trailerPrefix.count)
+            .split(separator: ":")
+            .compactMap { Int($0) }
+        guard fields.count == 4 else { return .unparsed }
+        let (returned, relativeOffset, hasMore, stale) = (fields[0], fields[1], fields[2] == 1, fields[3] == 1)
+        if stale {
+            return .staleOffset
+        }
+
+        let content = lines[(headerIndex + 1)..<trailerIndex].joined(separator: "\n")
+        let nextLine = hasMore ? startLine + returned : nil
+        let nextOffset = hasMore
+            ? relativeOffset + (byteOffset.map { $0 - 1 } ?? 0)
+            : nil
+        return .range(.object([
+            "ok": .bool(true),
+            "content": .string(content),
+            "lines_returned": .number(Double(returned)),
+            "has_more": .bool(hasMore),
+            "next_start_line": nextLine.map { .number(Double($0)) } ?? .null,
+        ]), nextLine: nextLine, nextOffset: nextOffset)
+    }
+
+    /// `read_file_chunk` result sliced from contents held in `RemoteFileCache`,
+    /// with the same line semantics as the remote awk read.
+    static func fileChunkResult(content: String, startLine: Int, lineCount: Int) -> LLMJSONValue {
+        var lines = content.split(separator: "\n", omittingEmptySubsequences: false)
+        if content.hasSuffix("\n") {
+            lines.removeLast()
+        }
+        let startIndex = min(lines.count, max(1, startLine) - 1)
+        let endExclusive = min(lines.count, startIndex + max(1, lineCount))
+        let slice = lines[startIndex..<endExclusive]
+        let hasMore = endExclusive < lines.count
+
+        return .object([
+            "ok": .bool(true),
+            "content": .string(slice.joined(separator: "\n")),
+            "lines_returned": .number(Double(slice.count)),
+            "has_more": .bool(hasMore),
+            "next_start_line": hasMore ? .number(Double(endExclusive + 1)) : .null,
+        ])
+    }
+
+    /// `search_file_contents` over one cached file. Case-insensitive substring
+    /// match, like the local search; rg/grep would treat the pattern as a regex.
+    static func cachedContentSearchResult(
+        content: String,
+        path: String,
+        textPattern: String,
+        maxResults: Int
+    ) -> LLMJSONValue {
+        let pattern = textPattern.trimmingCharacters(in: .whitespacesAndNewlines)
+        var matches: [LLMJSONValue] = []
+        for (index, line) in content.split(separator: "\n", omittingEmptySubsequences: false).enumerated() {
+            if matches.count >= maxResults { break }
+            guard !pattern.isEmpty,
+                  line.range(of: pattern, options: [.caseInsensitive, .diacriticInsensitive]) != nil else {
+                continue
+            }
+            matches.append(.object([
+                "path": .string(path),
+                "line_number": .number(Double(index + 1)),
+                "line": .string(String(line)),
+            ]))
+        }
+
+        return .object([
+            "ok": .bool(true),
+            "truncated": .bool(matches.count >= maxResults),
+            "matches": .array(groupMatchesByFile(matches)),
+            "source": .string("remote_cache"),
+        ])
+    }
+
     static func readBoundViolationMessage(for command: String) -> String? {
         let trimmed = command.trimmingCharacters(in: .whitespacesAndNewlines)
         let lowered = trimmed.lowercased()
@@ -12,6 +12,18 @@ extension AIToolHandler {
         var timedOut: Bool
     }
 
+    enum RemoteReadRangeOutcome {
+        /// `nextLine`/`nextOffset` are set when more lines follow the range.
+        case range(LLMJSONValue, nextLine: Int?, nextOffset: Int?)
+        /// The cached offset no longer lands on a line start.
+        case staleOffset
+        /// The file is unchanged since it was cached.
+        case cacheHit
+        /// No range trailer in the output.
+        case unparsed
+        case timedOut
+    }
+
     func searchFilesystemEntriesRemote(
         provider: any AIAgentSessionProviding,
         sessionID: UUID,
@@ -57,10 +69,12 @@ extension AIToolHandler {
         textPattern: String,
         maxResults: Int
     ) async -> LLMJSONValue {
+        let cachedEntry = remoteFileCache.entry(sessionID: sessionID, path: path)
         let command = Self.buildRemoteFileContentSearchCommand(
             path: path,
             textPattern: textPattern,
-            maxResults: maxResults
+            maxResults: maxResults,
+            cachedFingerprint: cachedEntry?.fingerprint
         )
         let execution = await executeRemoteToolCommand(
             provider: provider,
@@ -68,6 +82,18 @@ extension AIToolHandler {
             commandBody: command
         )
 
+        if let cachedEntry {
+            if !execution.timedOut, RemotePatchCommandBuilder.outputIndicatesCacheHit(execution.output) {
+                return Self.cachedContentSearchResult(
+                    content: cachedEntry.content,
+                    path: path,
+                    textPattern: textPattern,
+                    maxResults: maxResults
+                )
+            }
+            remoteFileCache.invalidate(sessionID: sessionID, path: path)
+        }
+
         if execution.timedOut {
             return .object([
                 "ok": .bool(false),
@@ -95,61 +121,148 @@ extension AIToolHandler {
         startLine: Int,
         lineCount: Int
     ) async -> LLMJSONValue {
-        // Use the same base64 read that apply_patch uses — immune to prompt contamination.
-        let readCmd = RemotePatchCommandBuilder.buildReadCommand(path: path)
-        let execution = await provider.executeCommandAndWait(
-            sessionID: sessionID, command: readCmd, timeoutSeconds: 15
+        // Only the requested range crosses the wire: awk slices it remotely
+        // and reports where the next line starts, so the following page can
+        // seek there with `tail -c` instead of rescanning from line 1.
+        // Contents already cached (e.g. by apply_patch) are sliced locally
+        // when the host's stat still matches.
+        let cachedEntry = remoteFileCache.entry(sessionID: sessionID, path: path)
+        let cachedOffset = remoteLineIndex.offset(sessionID: sessionID, path: path, line: startLine)
+        var attempt = await runRemoteReadRange(
+            provider: provider, sessionID: sessionID, path: path,
+            startLine: startLine, lineCount: lineCount, byteOffset: cachedOffset,
+            cachedFingerprint: cachedEntry?.fingerprint
         )
+        if case .staleOffset = attempt {
+            remoteLineIndex.forget(sessionID: sessionID, path: path)
+            attempt = await runRemoteReadRange(
+                provider: provider, sessionID: sessionID, path: path,
+                startLine: startLine, lineCount: lineCount, byteOffset: nil,
+                cachedFingerprint: cachedEntry?.fingerprint
+            )
+        }
 
-        if execution.timedOut {
+        switch attempt {
+        case .cacheHit:
+            if let cachedEntry {
+                return Self.fileChunkResult(
+                    content: cachedEntry.content, startLine: startLine, lineCount: lineCount
+                )
+            }
+        case .timedOut:
             return .object([
                 "ok": .bool(false),
                 "error": .string("Remote file read timed out."),
             ])
+        case let .range(result, nextLine, nextOffset):
+            if cachedEntry != nil {
+                remoteFileCache.invalidate(sessionID: sessionID, path: path)
+            }
+            if let nextLine, let nextOffset {
+                remoteLineIndex.record(sessionID: sessionID, path: path, line: nextLine, offset: nextOffset)
+            }
+            return result
+        case .staleOffset, .unparsed:
+            break
+        }
+        if cachedEntry != nil {
+            remoteFileCache.invalidate(sessionID: sessionID, path: path)
         }
 
-        guard let fullContent = RemotePatchCommandBuilder.decodeBase64FileOutput(
-            execution.output
-        ) else {
-            // Base64 decode failed — file might not exist or is binary.
-            // Fall back to sed-based read which handles not-found/not-regular tokens.
-            let endLine = startLine + lineCount - 1
-            let command = Self.buildRemoteReadFileChunkCommand(
-                path: path, startLine: startLine, endLine: endLine
-            )
-            let fallback = await executeRemoteToolCommand(
-                provider: provider, sessionID: sessionID, commandBody: command
-            )
-            if fallback.timedOut {
-                return .object([
-                    "ok": .bool(false),
-                    "error": .string("Remote file read timed out."),
-                ])
-            }
-            return Self.parseReadFileChunkOutput(
-                fallback.output, path: path, startLine: startLine,
-                lineCount: lineCount, source: "remote_command"
-            )
+        // No range trailer (e.g. awk missing on the host): plain sed read.
+        let endLine = startLine + lineCount - 1
+        let command = Self.buildRemoteReadFileChunkCommand(
+            path: path, startLine: startLine, endLine: endLine
+        )
+        let fallback = await executeRemoteToolCommand(
+            provider: provider, sessionID: sessionID, commandBody: command
+        )
+        if fallback.timedOut {
+            return .object([
+                "ok": .bool(false),
+                "error": .string("Remote file read timed out."),
+            ])
         }
+        return Self.parseReadFileChunkOutput(
+            fallback.output, path: path, startLine: startLine,
+            lineCount: lineCount, source: "remote_command"
+        )
+    }
 
-        // Extract the requested line range from the decoded content.
-        let allLines = fullContent.components(separatedBy: "\n")
-        let zeroStart = max(0, startLine - 1)   // startLine is 1-based
-        let zeroEnd = min(allLines.count, zeroStart + lineCount)
-        let slicedLines = zeroStart < allLines.count
-            ? Array(allLines[zeroStart..<zeroEnd]) : []
-        let content = slicedLines.joined(separator: "\n")
-        let hasMore = zeroEnd < allLines.count
-        let nextStart: LLMJSONValue = hasMore
-            ? .number(Double(zeroEnd + 1)) : .null
-
-        return .object([
-            "ok": .bool(true),
-            "content": .string(content),
-            "lines_returned": .number(Double(slicedLines.count)),
-            "has_more": .bool(hasMore),
-            "next_start_line": nextStart,
-        ])
+    private func runRemoteReadRange(
+        provider: any AIAgentSessionProviding,
+        sessionID: UUID,
+        path: String,
+        startLine: Int,
+        lineCount: Int,
+        byteOffset: Int?,
+        cachedFingerprint: String?
+    ) async -> RemoteReadRangeOutcome {
+        let command = Self.buildRemoteReadRangeCommand(
+            path: path, startLine: startLine, lineCount: lineCount,
+            byteOffset: byteOffset, cachedFingerprint: cachedFingerprint
+        )
+        let execution = await executeRemoteToolCommand(
+            provider: provider, sessionID: sessionID, commandBody: command, timeoutSeconds: 15
+        )
+        if execution.timedOut {
+            return .timedOut
+        }
+        return Self.parseRemoteReadRangeOutput(
+            execution.output, path: path, startLine: startLine, byteOffset: byteOffset
+        )
+    }
+
+    /// Keeps the caches coherent after apply_patch touched `path`: entries are
+    /// dropped, and after a successful write the new contents are cached under
+    /// a fresh fingerprint so the usual verification read costs one `stat`.
+    func refreshRemoteFileCache(
+        provider: any AIAgentSessionProviding,
+        sessionID: UUID,
+        path: String,
+        writtenContent: String?
+    ) async {
+        remoteFileCache.invalidate(sessionID: sessionID, path: path)
+        remoteLineIndex.forget(sessionID: sessionID, path: path)
+        guard let writtenContent else { return }
+
+        let execution = await executeRemoteToolCommand(
+            provider: provider,
+            sessionID: sessionID,
+            commandBody: RemotePatchCommandBuilder.buildStatCommand(path: path),
+            timeoutSeconds: 5
+        )
+        guard !execution.timedOut,
+              let fingerprint = RemotePatchCommandBuilder.parseStatFingerprint(execution.output) else {
+            return
+        }
+        remoteFileCache.store(
+            sessionID: sessionID, path: path, fingerprint: fingerprint, content: writtenContent
+        )
+    }
+
+    /// Write a patched remote file. Over SFTP with an atomic rename when the
+    /// session allows it, so the content never passes through the user's
+    /// shell; otherwise as a base64 heredoc typed into it.
+    func writeRemotePatchFile(
+        provider: any AIAgentSessionProviding,
+        sessionID: UUID,
+        path: String,
+        content: String
+    ) async -> CommandExecutionResult {
+        if let result = await provider.writeFileOutOfBand(
+            sessionID: sessionID,
+            path: path,
+            content: content,
+            timeoutSeconds: 20
+        ) {
+            return result
+        }
+        return await provider.executeCommandAndWait(
+            sessionID: sessionID,
+            command: RemotePatchCommandBuilder.buildWriteCommand(path: path, content: content),
+            timeoutSeconds: 20
+        )
     }
 
     func executeRemoteToolCommand(
@@ -158,6 +271,24 @@ extension AIToolHandler {
         commandBody: String,
         timeoutSeconds: TimeInterval = 20
     ) async -> RemoteToolExecutionResult {
+        // Preferred: an exec channel, which stays out of the user's scrollback
+        // and returns as soon as the command exits.
+        if let result = await provider.executeCommandOutOfBand(
+            sessionID: sessionID,
+            command: commandBody,
+            timeoutSeconds: timeoutSeconds
+        ) {
+            return RemoteToolExecutionResult(
+                output: result.output,
+                exitCode: result.exitCode,
+                timedOut: result.timedOut
+            )
+        }
+
+        // Concurrent read-only calls take turns at the shell.
+        await shellToolLane.acquire(sessionID)
+        defer { shellToolLane.release(sessionID) }
+
         let marker = "__PROSSH_AI_TOOL_EXIT_\(UUID().uuidString.replacingOccurrences(of: "-", with: ""))__"
         let wrappedCommand =
             "{ \(commandBody); __prossh_ai_tool_status=$?; printf '\\n\(marker):%s\\n' \"$__prossh_ai_tool_status\"; }"
@@ -170,12 +301,8 @@ extension AIToolHandler {
 
         let deadline = Date().addingTimeInterval(timeoutSeconds)
         while Date() < deadline {
-            let blocks = await provider.searchCommandHistory(
-                sessionID: sessionID,
-                query: marker,
-                limit: 8
-            )
-            if let block = blocks.first(where: { $0.command.contains(marker) }) {
+            if let block = await provider.commandBlock(sessionID: sessionID, marker: marker),
+               block.command.contains(marker) {
                 let parsed = Self.parseRemoteWrappedCommandOutput(
                     block.output,
                     marker: marker
@@ -404,7 +531,8 @@ extension AIToolHandler {
     static func buildRemoteFileContentSearchCommand(
         path: String,
         textPattern: String,
-        maxResults: Int
+        maxResults: Int,
+        cachedFingerprint: String? = nil
     ) -> String {
         let escapedPath = shellSingleQuoted(path)
         let escapedPattern = shellSingleQuoted(textPattern)
@@ -414,6 +542,7 @@ extension AIToolHandler {
         __prossh_root=\(escapedPath); \
         case "$__prossh_root" in "~") __prossh_root="$HOME" ;; "~/"*) __prossh_root="$HOME/${__prossh_root#~/}" ;; esac; \
         if [ ! -e "$__prossh_root" ]; then printf '\(remotePathNotFoundToken)\\n'; \
+        \(cacheHitBranch(shellWord: "\"$__prossh_root\"", cachedFingerprint: cachedFingerprint))\
         else __prossh_pattern=\(escapedPattern); \
         if command -v rg >/dev/null 2>&1; then \
         rg --line-number --with-filename --ignore-case --color never --no-messages -- "$__prossh_pattern" "$__prossh_root" | head -n \(limit); \
@@ -438,6 +567,71 @@ extension AIToolHandler {
         """
     }
 
+    static let remoteFilterStatusMarker = "__PROSSH_FILTER_STATUS__"
+
+    /// Runs `command` with its stdout and stderr piped through `filter`, an
+    /// awk extended regular expression, so only matching lines leave the
+    /// host. The command's exit status follows on a marker line that always
+    /// passes the filter, since the pipeline's own status is awk's.
+    static func buildFilteredCommand(_ command: String, filter: String) -> String {
+        let program = #"index($0, "\#(remoteFilterStatusMarker):") == 1 || $0 ~ ENVIRON["__prossh_filter"]"#
+        return "{ { \(command); } 2>&1; printf '\\n\(remoteFilterStatusMarker):%s\\n' \"$?\"; } "
+            + "| __prossh_filter=\(shellSingleQuoted(filter)) awk '\(program)'"
+    }
+
+    static let remoteReadRangeMarker = "__PROSSH_RANGE__"
+
+    /// Prints lines `startLine ..< startLine + lineCount` between a
+    /// `__PROSSH_RANGE__` line and a `__PROSSH_RANGE__:<lines>:<next line
+    /// offset>:<has more>:<stale>` trailer; the bracketing keeps leading
+    /// whitespace and blank lines intact through output trimming. With a known
+    /// `byteOffset` for `startLine` the read starts one byte early, at the
+    /// previous line's newline: record 1 must then be empty, otherwise the file
+    /// changed under the cached offset and the trailer reports it stale.
+    /// `LC_ALL=C` makes awk's `length` count bytes. A `cachedFingerprint`
+    /// still matching the file short-circuits to the cache-hit token.
+    static func buildRemoteReadRangeCommand(
+        path: String,
+        startLine: Int,
+        lineCount: Int,
+        byteOffset: Int?,
+        cachedFingerprint: String? = nil
+    ) -> String {
+        let escapedPath = shellSingleQuoted(path)
+        let program = [
+            #"BEGIN { print "\#(remoteReadRangeMarker)" }"#,
+            #"NR == 1 && chk && $0 != "" { stale = 1; exit }"#,
+            #"NR < s { off += length($0) + 1; next }"#,
+            #"NR <= e { print; n++; off += length($0) + 1; next }"#,
+            #"{ more = 1; exit }"#,
+            #"END { printf "\#(remoteReadRangeMarker):%d:%.0f:%d:%d\n", n, off, more, stale }"#,
+        ].joined(separator: " ")
+        let quotedProgram = "'\(program)'"
+        let read: String
+        if let byteOffset, byteOffset > 0 {
+            read = "tail -c +\(byteOffset) \"$__prossh_file\" | LC_ALL=C awk -v s=2 -v e=\(lineCount + 1) -v chk=1 \(quotedProgram)"
+        } else {
+            read = "LC_ALL=C awk -v s=\(startLine) -v e=\(startLine + lineCount - 1) -v chk=0 \(quotedProgram) \"$__prossh_file\""
+        }
+        return """
+        __prossh_file=\(escapedPath); \
+        case "$__prossh_file" in "~") __prossh_file="$HOME" ;; "~/"*) __prossh_file="$HOME/${__prossh_file#~/}" ;; esac; \
+        if [ ! -e "$__prossh_file" ]; then printf '\(remotePathNotFoundToken)\\n'; \
+        elif [ ! -f "$__prossh_file" ]; then printf '\(remoteNotRegularFileToken)\\n'; \
+        \(cacheHitBranch(shellWord: "\"$__prossh_file\"", cachedFingerprint: cachedFingerprint))\
+        else \(read); fi
+        """
+    }
+
+    /// `elif` arm printing the cache-hit token when `shellWord` is a regular
+    /// file whose fingerprint is still `cachedFingerprint`; empty without one.
+    static func cacheHitBranch(shellWord: String, cachedFingerprint: String?) -> String {
+        guard let cachedFingerprint else { return "" }
+        let fingerprint = RemotePatchCommandBuilder.statFingerprintExpression(for: shellWord)
+        return "elif [ -f \(shellWord) ] && [ \"\(fingerprint)\" = \(shellSingleQuoted(cachedFingerprint)) ]; then "
+            + "printf '\(RemotePatchCommandBuilder.cacheHitToken)\\n'; "
+    }
+
     static func shellSingleQuoted(_ value: String) -> String {
         let escaped = value.replacingOccurrences(of: "'", with: #"'\"'\"'"#)
         return "'\(escaped)'"
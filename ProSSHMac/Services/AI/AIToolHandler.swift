@@ -14,45 +14,153 @@ struct BroadcastContext: Sendable {
     private static let logger = Logger(subsystem: "com.prossh", category: "AICopilot.ToolHandler")
     weak var service: OpenAIAgentService?
     private let iso8601Formatter = ISO8601DateFormatter()
+    var remoteLineIndex = RemoteFileLineIndex()
+    var remoteFileCache = RemoteFileCache()
+    let toolCallLimiter = AIToolSessionLimiter(limit: AIToolDefinitions.maxConcurrentToolCallsPerSession)
+    /// Serializes tool commands typed into a session's shell when no exec
+    /// channel is available; concurrent reads would interleave in the PTY.
+    let shellToolLane = AIToolSessionLimiter(limit: 1)
 
     init() {}
     nonisolated deinit {}
 
     // MARK: - Tool Dispatch
 
+    /// Runs one turn's tool calls. Consecutive read-only calls run
+    /// concurrently, at most `maxConcurrentToolCallsPerSession` per target
+    /// session; a mutating call waits for everything before it and runs alone.
+    /// Calls already started in `speculativeCalls` are awaited, not rerun.
+    /// Outputs come back in call order.
     func executeToolCalls(
         sessionID: UUID,
         broadcastContext: BroadcastContext?,
         toolCalls: [LLMToolCall],
-        traceID: String
+        traceID: String,
+        speculativeCalls: AISpeculativeToolCalls? = nil
     ) async -> [LLMToolOutput] {
-        var outputs: [LLMToolOutput] = []
-        outputs.reserveCapacity(toolCalls.count)
-
-        for toolCall in toolCalls {
-            let toolStart = DispatchTime.now().uptimeNanoseconds
-            do {
-                let output = try await executeSingleToolCall(
-                    sessionID: sessionID,
-                    broadcastContext: broadcastContext,
-                    toolCall: toolCall
-                )
-                outputs.append(.init(callID: toolCall.id, output: output))
-                let toolMs = AIToolDefinitions.elapsedMillis(since: toolStart)
-                Self.logger.debug(
-                    "[\(traceID, privacy: .public)] tool_ok name=\(toolCall.name, privacy: .public) call_id=\(toolCall.id, privacy: .public) ms=\(toolMs) output_chars=\(output.count)"
-                )
-            } catch {
-                let fallback = AIToolDefinitions.errorResult(error.localizedDescription)
-                outputs.append(.init(callID: toolCall.id, output: fallback))
-                let toolMs = AIToolDefinitions.elapsedMillis(since: toolStart)
-                Self.logger.error(
-                    "[\(traceID, privacy: .public)] tool_failed name=\(toolCall.name, privacy: .public) call_id=\(toolCall.id, privacy: .public) ms=\(toolMs) error=\(error.localizedDescription, privacy: .public)"
-                )
+        var outputs = [LLMToolOutput?](repeating: nil, count: toolCalls.count)
+        var index = 0
+
+        while index < toolCalls.count {
+            var end = index + 1
+            if AIToolDefinitions.concurrentToolNames.contains(toolCalls[index].name) {
+                while end < toolCalls.count,
+                      AIToolDefinitions.concurrentToolNames.contains(toolCalls[end].name) {
+                    end += 1
+                }
             }
+
+            if end - index == 1 {
+                if let task = speculativeCalls?.take(toolCalls[index]) {
+                    outputs[index] = await adoptSpeculativeToolCall(task, toolCall: toolCalls[index], traceID: traceID)
+                } else {
+                    outputs[index] = await executeLoggedToolCall(
+                        sessionID: sessionID,
+                        broadcastContext: broadcastContext,
+                        toolCall: toolCalls[index],
+                        traceID: traceID
+                    )
+                }
+            } else {
+                await withTaskGroup(of: (Int, LLMToolOutput).self) { group in
+                    for callIndex in index..<end {
+                        let toolCall = toolCalls[callIndex]
+                        let speculative = speculativeCalls?.take(toolCall)
+                        group.addTask { @MainActor in
+                            if let speculative {
+                                return (callIndex, await self.adoptSpeculativeToolCall(speculative, toolCall: toolCall, traceID: traceID))
+                            }
+                            let output = await self.executeReadOnlyToolCall(
+                                sessionID: sessionID,
+                                broadcastContext: broadcastContext,
+                                toolCall: toolCall,
+                                traceID: traceID
+                            )
+                            return (callIndex, output)
+                        }
+                    }
+                    for await (callIndex, output) in group {
+                        outputs[callIndex] = output
+                    }
+                }
+            }
+            index = end
         }
 
-        return outputs
+        return outputs.compactMap { $0 }
+    }
+
+    /// Runs a read-only call holding a slot of its target session's limiter.
+    /// Used for concurrent batches and for calls started while the response
+    /// is still streaming.
+    func executeReadOnlyToolCall(
+        sessionID: UUID,
+        broadcastContext: BroadcastContext?,
+        toolCall: LLMToolCall,
+        traceID: String
+    ) async -> LLMToolOutput {
+        let limiterKey = limiterSessionID(for: toolCall, primarySessionID: sessionID)
+        return await toolCallLimiter.withSlot(for: limiterKey) {
+            await executeLoggedToolCall(
+                sessionID: sessionID,
+                broadcastContext: broadcastContext,
+                toolCall: toolCall,
+                traceID: traceID
+            )
+        }
+    }
+
+    private func adoptSpeculativeToolCall(
+        _ task: Task<LLMToolOutput, Never>,
+        toolCall: LLMToolCall,
+        traceID: String
+    ) async -> LLMToolOutput {
+        Self.logger.debug(
+            "[\(traceID, privacy: .public)] tool_speculative_adopted name=\(toolCall.name, privacy: .public) call_id=\(toolCall.id, privacy: .public)"
+        )
+        return await task.value
+    }
+
+    private func executeLoggedToolCall(
+        sessionID: UUID,
+        broadcastContext: BroadcastContext?,
+        toolCall: LLMToolCall,
+        traceID: String
+    ) async -> LLMToolOutput {
+        let toolStart = DispatchTime.now().uptimeNanoseconds
+        let traceStart = TraceRecorder.shared.begin()
+        defer { TraceRecorder.shared.end(.aiTool, since: traceStart, label: toolCall.name) }
+        do {
+            let output = try await executeSingleToolCall(
+                sessionID: sessionID,
+                broadcastContext: broadcastContext,
+                toolCall: toolCall
+            )
+            let toolMs = AIToolDefinitions.elapsedMillis(since: toolStart)
+            Self.logger.debug(
+                "[\(traceID, privacy: .public)] tool_ok name=\(toolCall.name, privacy: .public) call_id=\(toolCall.id, privacy: .public) ms=\(toolMs) output_chars=\(output.count)"
+            )
+            return .init(callID: toolCall.id, output: output)
+        } catch {
+            let fallback = AIToolDefinitions.errorResult(error.localizedDescription)
+            let toolMs = AIToolDefinitions.elapsedMillis(since: toolStart)
+            Self.logger.error(
+                "[\(traceID, privacy: .public)] tool_failed name=\(toolCall.name, privacy: .public) call_id=\(toolCall.id, privacy: .public) ms=\(toolMs) error=\(error.localizedDescription, privacy: .public)"
+            )
+            return .init(callID: toolCall.id, output: fallback)
+        }
+    }
+
+    /// The session a call is throttled against: its explicit `target_session`,
+    /// else the turn's primary session.
+    private func limiterSessionID(for toolCall: LLMToolCall, primarySessionID: UUID) -> UUID {
+        guard let arguments = try? Self.decodeArguments(
+            toolName: toolCall.name,
+            rawArguments: toolCall.arguments
+        ), let target = Self.optionalString(key: "target_session", in: arguments) else {
+            return primarySessionID
+        }
+        return UUID(uuidString: target) ?? primarySessionID
     }
 
     private func executeSingleToolCall(
@@ -123,11 +231,15 @@ struct BroadcastContext: Sendable {
                     "lines": .array(lines.map(LLMJSONValue.string)),
                 ]
                 if let session = provider.sessions.first(where: { $0.id == target }) {
-                    payload["session_info"] = .object([
+                    var info: [String: LLMJSONValue] = [
                         "host_label": .string(session.hostLabel),
                         "is_local": .bool(session.isLocal),
                         "state": .string(session.state.rawValue),
-                    ])
+                    ]
+                    if let metrics = provider.hostMetrics(sessionID: target) {
+                        info["host_metrics"] = Self.hostMetricsValue(metrics)
+                    }
+                    payload["session_info"] = .object(info)
                 }
                 return AIToolDefinitions.jsonString(from: .object(payload))
             } else if let ctx = broadcastContext {
@@ -464,6 +576,8 @@ struct BroadcastContext: Sendable {
                 min: 5,
                 max: 60
             ))
+            let filter = Self.optionalString(key: "filter", in: arguments)
+                .flatMap { $0.isEmpty ? nil : $0 }
 
             if let message = Self.readBoundViolationMessage(for: command) {
                 return AIToolDefinitions.errorResult(
@@ -471,6 +585,8 @@ struct BroadcastContext: Sendable {
                     hint: "Use read_files with line_count <= 500."
                 )
             }
+            // Filtering happens on the host, so dropped lines never cross the wire.
+            let remoteCommand = filter.map { Self.buildFilteredCommand(command, filter: $0) } ?? command
 
             let targets = resolveTargetSessions(
                 arguments: arguments,
@@ -482,7 +598,7 @@ struct BroadcastContext: Sendable {
                 let target = targets.first ?? sessionID
                 let result = await provider.executeCommandAndWait(
                     sessionID: target,
-                    command: command,
+                    command: remoteCommand,
                     timeoutSeconds: timeout
                 )
 
@@ -493,24 +609,16 @@ struct BroadcastContext: Sendable {
                     )
                 }
 
-                let maxOutputChars = 16000
-                let truncated = result.output.count > maxOutputChars
-                let output = truncated ? String(result.output.prefix(maxOutputChars)) : result.output
-
-                return AIToolDefinitions.jsonString(from: .object([
-                    "ok": .bool(true),
-                    "output": .string(output),
-                    "exit_code": result.exitCode.map { .number(Double($0)) } ?? .null,
-                    "truncated": .bool(truncated),
-                    "total_chars": .number(Double(result.output.count)),
-                ]))
+                var payload = Self.boundedCommandOutputFields(result, filtered: filter != nil)
+                payload["ok"] = .bool(true)
+                return AIToolDefinitions.jsonString(from: .object(payload))
             } else {
                 // Sequential execution across broadcast sessions (MainActor-safe)
                 var collected: [(UUID, CommandExecutionResult)] = []
                 for target in targets {
                     let r = await provider.executeCommandAndWait(
                         sessionID: target,
-                        command: command,
+                        command: remoteCommand,
                         timeoutSeconds: timeout
                     )
                     collected.append((target, r))
@@ -524,23 +632,15 @@ struct BroadcastContext: Sendable {
                     ]))
                 }
 
-                let maxOutputChars = 16000
                 var sessionResults: [LLMJSONValue] = []
                 for (sid, result) in collected {
                     let label = ctx.sessionLabels[sid]
                         ?? String(sid.uuidString.prefix(8))
-                    let truncated = result.output.count > maxOutputChars
-                    let output = truncated
-                        ? String(result.output.prefix(maxOutputChars))
-                        : result.output
-                    sessionResults.append(.object([
-                        "session": .string(label),
-                        "session_id": .string(sid.uuidString),
-                        "output": .string(output),
-                        "exit_code": result.exitCode.map { .number(Double($0)) } ?? .null,
-                        "timed_out": .bool(result.timedOut),
-                        "truncated": .bool(truncated),
-                    ]))
+                    var entry = Self.boundedCommandOutputFields(result, filtered: filter != nil)
+                    entry["session"] = .string(label)
+                    entry["session_id"] = .string(sid.uuidString)
+                    entry["timed_out"] = .bool(result.timedOut)
+                    sessionResults.append(.object(entry))
                 }
 
                 return AIToolDefinitions.jsonString(from: .object([
@@ -571,6 +671,7 @@ struct BroadcastContext: Sendable {
                 "is_local": .bool(session.isLocal),
                 "started_at": .string(iso8601Formatter.string(from: session.startedAt)),
                 "working_directory": provider.workingDirectoryBySessionID[resolvedID].map(LLMJSONValue.string) ?? .null,
+                "host_metrics": provider.hostMetrics(sessionID: resolvedID).map(Self.hostMetricsValue) ?? .null,
             ]))
 
         case "apply_patch":
@@ -620,6 +721,7 @@ struct BroadcastContext: Sendable {
 
             // Execute
             var patchStatus: String?
+            var writtenContent: String?
             var result = PatchResult(
                 success: false,
                 output: "Patch failed.",
@@ -638,11 +740,26 @@ struct BroadcastContext: Sendable {
                     var originalContent: String?
                     var readUsedSudo = false
 
-                    let readCmd = RemotePatchCommandBuilder.buildReadCommand(path: path)
+                    let cachedEntry = remoteFileCache.entry(sessionID: resolvedID, path: path)
+                    let readCmd = RemotePatchCommandBuilder.buildCachedReadCommand(
+                        path: path, cachedFingerprint: cachedEntry?.fingerprint
+                    )
                     let readResult = await provider.executeCommandAndWait(
                         sessionID: resolvedID, command: readCmd, timeoutSeconds: 10
                     )
-                    originalContent = RemotePatchCommandBuilder.decodeBase64FileOutput(readResult.output)
+                    let fingerprint = RemotePatchCommandBuilder.parseStatFingerprint(readResult.output)
+                    if let cachedEntry, fingerprint == cachedEntry.fingerprint,
+                       RemotePatchCommandBuilder.outputIndicatesCacheHit(readResult.output) {
+                        originalContent = cachedEntry.content
+                    } else {
+                        originalContent = RemotePatchCommandBuilder.decodeBase64FileOutput(readResult.output)
+                        if let originalContent, let fingerprint {
+                            remoteFileCache.store(
+                                sessionID: resolvedID, path: path,
+                                fingerprint: fingerprint, content: originalContent
+                            )
+                        }
+                    }
 
                     if originalContent == nil {
                         let readOutput = Self.trimmedPatchOutput(readResult.output)
@@ -713,17 +830,28 @@ struct BroadcastContext: Sendable {
                             let warnings = patched == originalContent
                                 ? ["Patch applied but file content is unchanged"] : []
 
-                            let initialWriteCmd = RemotePatchCommandBuilder.buildWriteCommand(
-                                path: path,
-                                content: patched,
-                                useSudo: readUsedSudo,
-                                nonInteractiveSudo: readUsedSudo
-                            )
-                            let initialWriteResult = await provider.executeCommandAndWait(
-                                sessionID: resolvedID,
-                                command: initialWriteCmd,
-                                timeoutSeconds: 20
-                            )
+                            writtenContent = patched
+                            let initialWriteResult: CommandExecutionResult
+                            if readUsedSudo {
+                                let initialWriteCmd = RemotePatchCommandBuilder.buildWriteCommand(
+                                    path: path,
+                                    content: patched,
+                                    useSudo: true,
+                                    nonInteractiveSudo: true
+                                )
+                                initialWriteResult = await provider.executeCommandAndWait(
+                                    sessionID: resolvedID,
+                                    command: initialWriteCmd,
+                                    timeoutSeconds: 20
+                                )
+                            } else {
+                                initialWriteResult = await writeRemotePatchFile(
+                                    provider: provider,
+                                    sessionID: resolvedID,
+                                    path: path,
+                                    content: patched
+                                )
+                            }
 
                             if initialWriteResult.exitCode == 0 {
                                 result = PatchResult(
@@ -840,11 +968,12 @@ struct BroadcastContext: Sendable {
                     do {
                         let content = try applyDiff(input: "", diff: diff, mode: .create)
                         let lineCount = content.components(separatedBy: "\n").count
-                        let writeCmd = RemotePatchCommandBuilder.buildWriteCommand(
-                            path: path, content: content
-                        )
-                        let writeResult = await provider.executeCommandAndWait(
-                            sessionID: resolvedID, command: writeCmd, timeoutSeconds: 20
+                        writtenContent = content
+                        let writeResult = await writeRemotePatchFile(
+                            provider: provider,
+                            sessionID: resolvedID,
+                            path: path,
+                            content: content
                         )
 
                         if writeResult.exitCode == 0 {
@@ -1012,6 +1141,13 @@ struct BroadcastContext: Sendable {
                             : parsed
                     }
                 }
+
+                await refreshRemoteFileCache(
+                    provider: provider,
+                    sessionID: resolvedID,
+                    path: path,
+                    writtenContent: result.success ? writtenContent : nil
+                )
             }
 
             Self.logger.info(
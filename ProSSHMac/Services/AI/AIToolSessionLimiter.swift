@@ -0,0 +1,44 @@
+import Foundation
+
+/// Caps how many tool calls touch one session at a time. Waiters are resumed
+/// in FIFO order, and a released slot passes straight to the next waiter.
+/// MainActor-confined like `AIToolHandler`, so the bookkeeping needs no lock.
+@MainActor final class AIToolSessionLimiter {
+    private let limit: Int
+    private var running: [UUID: Int] = [:]
+    private var waiters: [UUID: [CheckedContinuation<Void, Never>]] = [:]
+
+    init(limit: Int) {
+        self.limit = max(1, limit)
+    }
+
+    nonisolated deinit {}
+
+    func acquire(_ sessionID: UUID) async {
+        let current = running[sessionID, default: 0]
+        if current < limit {
+            running[sessionID] = current + 1
+            return
+        }
+        await withCheckedContinuation { continuation in
+            waiters[sessionID, default: []].append(continuation)
+        }
+    }
+
+    func release(_ sessionID: UUID) {
+        if var queue = waiters[sessionID], !queue.isEmpty {
+            let next = queue.removeFirst()
+            waiters[sessionID] = queue.isEmpty ? nil : queue
+            next.resume()
+            return
+        }
+        let remaining = running[sessionID, default: 1] - 1
+        running[sessionID] = remaining > 0 ? remaining : nil
+    }
+
+    func withSlot<T>(for sessionID: UUID, _ operation: () async throws -> T) async rethrows -> T {
+        await acquire(sessionID)
+        defer { release(sessionID) }
+        return try await operation()
+    }
+}
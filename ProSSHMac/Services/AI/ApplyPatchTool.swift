@@ -241,7 +241,9 @@ struct LocalWorkspacePatcher: Sendable {
 /// Applies patch operations on remote hosts via SSH shell commands.
 ///
 /// Uses cat heredoc for creates and rm for deletes. Updates go through the
-/// read-apply-write path in AIToolHandler (base64 read → applyDiff → base64 write).
+/// read-apply-write path in AIToolHandler (base64 read → applyDiff → write),
+/// which writes over SFTP (the Upload commands) when the session allows it
+/// and as a base64 heredoc otherwise.
 struct RemotePatchCommandBuilder: Sendable {
 
     /// Build a shell command to apply a patch operation on a remote host.
@@ -357,6 +359,67 @@ struct RemotePatchCommandBuilder: Sendable {
         """
     }
 
+    // MARK: - Upload (SFTP write path)
+
+    static let uploadMarker = "__PROSSH_UPLOAD__"
+
+    /// Build a command that prepares an SFTP upload of `path`. It creates the
+    /// parent directory and fails with "Permission denied" when the file or
+    /// its directory is not writable. Otherwise it prints
+    /// `__PROSSH_UPLOAD__:<absolute path>`, since SFTP does not share the
+    /// shell's working directory. A symlink prints nothing, so the write
+    /// goes through the shell and the link is kept. Run out of band (it may
+    /// `exit`).
+    static func buildUploadPrepareCommand(path: String) -> String {
+        let escapedPath = shellEscaped(path)
+        return """
+        [ -L \(escapedPath) ] && exit 0; \
+        __prossh_dir="$(dirname \(escapedPath))"; mkdir -p "$__prossh_dir" 2>/dev/null; \
+        if [ ! -w "$__prossh_dir" ] || { [ -e \(escapedPath) ] && [ ! -w \(escapedPath) ]; }; then \
+        printf 'Permission denied: %s\\n' \(escapedPath); exit 1; fi; \
+        printf '\(uploadMarker):%s/%s\\n' "$(cd "$__prossh_dir" && pwd -P)" "$(basename \(escapedPath))"
+        """
+    }
+
+    /// The absolute path from a `__PROSSH_UPLOAD__:` line in `output`.
+    static func parseUploadTarget(_ output: String) -> String? {
+        let prefix = "\(uploadMarker):"
+        for line in output.components(separatedBy: "\n").reversed() {
+            let trimmed = line.trimmingCharacters(in: .whitespacesAndNewlines)
+            guard trimmed.hasPrefix(prefix) else { continue }
+            let value = String(trimmed.dropFirst(prefix.count))
+            return value.hasPrefix("/") ? value : nil
+        }
+        return nil
+    }
+
+    /// Hidden sibling of `path` the upload is written to before the rename,
+    /// so readers never see a partial file.
+    static func temporaryUploadPath(for path: String) -> String {
+        let name = path.split(separator: "/").last.map(String.init) ?? "file"
+        let suffix = UUID().uuidString.prefix(8).lowercased()
+        return RemotePath.join(RemotePath.parent(of: path) ?? "/", ".\(name).prossh-\(suffix)")
+    }
+
+    /// Build a command that gives the uploaded file the target's mode (or
+    /// the umask default for a new file) and renames it over the target.
+    static func buildUploadCommitCommand(temporaryPath: String, path: String) -> String {
+        let escapedTemporary = shellEscaped(temporaryPath)
+        let escapedPath = shellEscaped(path)
+        let mode = "$( { stat -c '%a' -- \(escapedPath) || stat -f '%Lp' -- \(escapedPath); } 2>/dev/null )"
+        return """
+        if [ -e \(escapedPath) ]; then __prossh_mode="\(mode)"; \
+        [ -n "$__prossh_mode" ] && chmod "$__prossh_mode" \(escapedTemporary); \
+        else chmod "$(printf '%o' $(( 0666 & ~0$(umask) )))" \(escapedTemporary); fi; \
+        mv -f \(escapedTemporary) \(escapedPath) || { rm -f \(escapedTemporary); exit 1; }
+        """
+    }
+
+    /// Build a command that removes an abandoned upload.
+    static func buildUploadCleanupCommand(temporaryPath: String) -> String {
+        "rm -f \(shellEscaped(temporaryPath))"
+    }
+
     // MARK: - Read (base64, contamination-safe)
 
     /// Build a shell command to read a remote file using base64 encoding.
@@ -378,6 +441,58 @@ struct RemotePatchCommandBuilder: Sendable {
         return "base64 \(escapedPath)"
     }
 
+    // MARK: - Fingerprint (RemoteFileCache validation)
+
+    static let statMarker = "__PROSSH_STAT__"
+    static let cacheHitToken = "__PROSSH_CACHE_HIT__"
+
+    /// Shell expression expanding to `<size>:<mtime>:<inode>` of `shellWord`
+    /// (a quoted path or a quoted variable reference). GNU/BusyBox `stat -c`
+    /// first, then BSD `stat -f`; empty when the file cannot be stat'ed.
+    static func statFingerprintExpression(for shellWord: String) -> String {
+        "$( { stat -c '%s:%y:%i' -- \(shellWord) || stat -f '%z:%m:%i' -- \(shellWord); } 2>/dev/null )"
+    }
+
+    /// Prints `__PROSSH_STAT__:<fingerprint>` for `path`.
+    static func buildStatCommand(path: String) -> String {
+        "printf '\(statMarker):%s\\n' \"\(statFingerprintExpression(for: shellEscaped(path)))\""
+    }
+
+    /// `buildReadCommand` preceded by the file's fingerprint. When that equals
+    /// `cachedFingerprint` the host prints `cacheHitToken` instead of the
+    /// contents, so an unchanged file costs one `stat`.
+    static func buildCachedReadCommand(path: String, cachedFingerprint: String?) -> String {
+        let escapedPath = shellEscaped(path)
+        let fingerprint =
+            "__prossh_fp=\"\(statFingerprintExpression(for: escapedPath))\"; printf '\(statMarker):%s\\n' \"$__prossh_fp\""
+        guard let cachedFingerprint else {
+            return "\(fingerprint); base64 \(escapedPath)"
+        }
+        return """
+        \(fingerprint); if [ "$__prossh_fp" = \(shellEscaped(cachedFingerprint)) ]; then \
+        printf '\(cacheHitToken)\\n'; else base64 \(escapedPath); fi
+        """
+    }
+
+    /// The fingerprint from a `__PROSSH_STAT__:` line in `output`, or nil when
+    /// the stat failed. Matches whole lines only, so an echoed command is ignored.
+    static func parseStatFingerprint(_ output: String) -> String? {
+        let prefix = "\(statMarker):"
+        for line in output.components(separatedBy: "\n").reversed() {
+            let trimmed = line.trimmingCharacters(in: .whitespacesAndNewlines)
+            guard trimmed.hasPrefix(prefix) else { continue }
+            let value = String(trimmed.dropFirst(prefix.count))
+            return value.isEmpty ? nil : value
+        }
+        return nil
+    }
+
+    static func outputIndicatesCacheHit(_ output: String) -> Bool {
+        output.components(separatedBy: "\n").contains {
+            $0.trimmingCharacters(in: .whitespacesAndNewlines) == cacheHitToken
+        }
+    }
+
     /// Build a command that prompts for sudo credentials and refreshes the sudo timestamp.
     /// Use when an operation needs elevation but non-interactive sudo is not yet available.
     static func buildSudoPrimingCommand() -> String {
@@ -0,0 +1,67 @@
+import Foundation
+
+/// Remote file contents the AI tools already transferred, keyed by session and
+/// path and tagged with the `stat` fingerprint (size, mtime, inode) they were
+/// read under. Callers send the cached fingerprint along with the next read;
+/// the host answers with a cache-hit token instead of the bytes when the file
+/// is unchanged. Bounded LRU so a long run over large files cannot grow it
+/// without limit.
+nonisolated struct RemoteFileCache: Sendable {
+    struct Entry: Sendable {
+        let fingerprint: String
+        let content: String
+    }
+
+    private struct Key: Hashable, Sendable {
+        let sessionID: UUID
+        let path: String
+    }
+
+    private let maxTotalBytes: Int
+    private let maxFileBytes: Int
+    private var entries: [Key: Entry] = [:]
+    /// Least recently used first.
+    private var order: [Key] = []
+    private var totalBytes = 0
+
+    init(maxTotalBytes: Int = 16 * 1024 * 1024, maxFileBytes: Int = 4 * 1024 * 1024) {
+        self.maxTotalBytes = maxTotalBytes
+        self.maxFileBytes = maxFileBytes
+    }
+
+    mutating func entry(sessionID: UUID, path: String) -> Entry? {
+        let key = Key(sessionID: sessionID, path: path)
+        guard let entry = entries[key] else { return nil }
+        touch(key)
+        return entry
+    }
+
+    mutating func store(sessionID: UUID, path: String, fingerprint: String, content: String) {
+        let key = Key(sessionID: sessionID, path: path)
+        invalidate(key)
+        let size = content.utf8.count
+        guard !fingerprint.isEmpty, size <= maxFileBytes else { return }
+
+        entries[key] = Entry(fingerprint: fingerprint, content: content)
+        order.append(key)
+        totalBytes += size
+        while totalBytes > maxTotalBytes, !order.isEmpty {
+            invalidate(order[0])
+        }
+    }
+
+    mutating func invalidate(sessionID: UUID, path: String) {
+        invalidate(Key(sessionID: sessionID, path: path))
+    }
+
+    private mutating func invalidate(_ key: Key) {
+        guard let removed = entries.removeValue(forKey: key) else { return }
+        totalBytes -= removed.content.utf8.count
+        order.removeAll { $0 == key }
+    }
+
+    private mutating func touch(_ key: Key) {
+        order.removeAll { $0 == key }
+        order.append(key)
+    }
+}
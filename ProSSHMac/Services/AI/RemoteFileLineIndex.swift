@@ -0,0 +1,54 @@
+import Foundation
+
+/// Byte offsets of line starts learned from earlier ranged reads, so paging
+/// through a remote file with `next_start_line` seeks straight to the next
+/// chunk instead of rescanning from the top. Entries are hints only: the read
+/// command checks that the byte before an offset is still a newline and the
+/// caller drops the file's entries when it is not.
+nonisolated struct RemoteFileLineIndex: Sendable {
+    private struct Key: Hashable, Sendable {
+        let sessionID: UUID
+        let path: String
+    }
+
+    private let maxFiles: Int
+    private let maxOffsetsPerFile: Int
+    private var offsetsByFile: [Key: [Int: Int]] = [:]
+    /// Least recently used first.
+    private var order: [Key] = []
+
+    init(maxFiles: Int = 32, maxOffsetsPerFile: Int = 256) {
+        self.maxFiles = maxFiles
+        self.maxOffsetsPerFile = maxOffsetsPerFile
+    }
+
+    /// Byte offset at which 1-based `line` starts, if a previous read ended there.
+    func offset(sessionID: UUID, path: String, line: Int) -> Int? {
+        guard line > 1 else { return nil }
+        return offsetsByFile[Key(sessionID: sessionID, path: path)]?[line]
+    }
+
+    mutating func record(sessionID: UUID, path: String, line: Int, offset: Int) {
+        guard line > 1, offset > 0 else { return }
+        let key = Key(sessionID: sessionID, path: path)
+        var offsets = offsetsByFile[key] ?? [:]
+        if offsets.count >= maxOffsetsPerFile, offsets[line] == nil,
+           let nearest = offsets.keys.min() {
+            offsets.removeValue(forKey: nearest)
+        }
+        offsets[line] = offset
+        offsetsByFile[key] = offsets
+
+        order.removeAll { $0 == key }
+        order.append(key)
+        if order.count > maxFiles {
+            offsetsByFile.removeValue(forKey: order.removeFirst())
+        }
+    }
+
+    mutating func forget(sessionID: UUID, path: String) {
+        let key = Key(sessionID: sessionID, path: path)
+        offsetsByFile.removeValue(forKey: key)
+        order.removeAll { $0 == key }
+    }
+}
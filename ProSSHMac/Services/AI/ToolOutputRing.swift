@@ -0,0 +1,136 @@
+import Foundation
+
+/// Bounded capture of a tool command's output: the first `headLimit` bytes,
+/// the last `tailLimit` bytes in a ring, and byte and line counts for all of
+/// it. Memory stays constant however much a command prints, so a `find /`
+/// or a verbose build costs the model a fixed number of tokens. It still sees
+/// how the output starts and, usually more useful, how it ends.
+nonisolated struct ToolOutputRing: Sendable {
+    /// What `execute_and_wait` hands the model per session.
+    static let modelHeadBytes = 12 * 1024
+    static let modelTailBytes = 4 * 1024
+
+    let headLimit: Int
+    let tailLimit: Int
+    private var head: [UInt8] = []
+    /// Ring storage; `tailStart` is the oldest byte once it is full.
+    private var tail: [UInt8] = []
+    private var tailStart = 0
+    private var newlineCount = 0
+    private var lastByte: UInt8?
+
+    /// Bytes appended so far.
+    private(set) var byteCount = 0
+
+    init(headLimit: Int = ToolOutputRing.modelHeadBytes, tailLimit: Int = ToolOutputRing.modelTailBytes) {
+        self.headLimit = max(0, headLimit)
+        self.tailLimit = max(0, tailLimit)
+    }
+
+    /// A ring holding `text`, for output that arrived in one piece.
+    init(
+        text: String,
+        headLimit: Int = ToolOutputRing.modelHeadBytes,
+        tailLimit: Int = ToolOutputRing.modelTailBytes
+    ) {
+        self.init(headLimit: headLimit, tailLimit: tailLimit)
+        append(Array(text.utf8))
+    }
+
+    /// Lines appended so far; a final line without a newline counts.
+    var lineCount: Int {
+        newlineCount + (lastByte.map { $0 == 0x0A ? 0 : 1 } ?? 0)
+    }
+
+    /// Whether bytes between the head and the tail were dropped.
+    var isTruncated: Bool {
+        byteCount > head.count + tail.count
+    }
+
+    mutating func append(_ data: Data) {
+        append(Array(data))
+    }
+
+    mutating func append(_ bytes: [UInt8]) {
+        guard !bytes.isEmpty else { return }
+        byteCount += bytes.count
+        newlineCount += bytes.reduce(0) { $1 == 0x0A ? $0 + 1 : $0 }
+        lastByte = bytes.last
+
+        let headRoom = headLimit - head.count
+        if headRoom > 0 {
+            head.append(contentsOf: bytes.prefix(headRoom))
+        }
+        appendToTail(bytes.dropFirst(max(0, headRoom)))
+    }
+
+    /// The kept output. When bytes were dropped, the head is cut back to its
+    /// last full line and the tail starts at its first, with a line between
+    /// them saying how much is missing.
+    var text: String {
+        let tailBytes = orderedTail
+        guard isTruncated else {
+            return String(decoding: head + tailBytes, as: UTF8.self)
+        }
+        let keptHead = head[..<Self.headCut(head)]
+        let keptTail = tailBytes[Self.tailCut(tailBytes)...]
+        let omittedBytes = byteCount - keptHead.count - keptTail.count
+        let keptNewlines = keptHead.reduce(0) { $1 == 0x0A ? $0 + 1 : $0 }
+            + keptTail.reduce(0) { $1 == 0x0A ? $0 + 1 : $0 }
+        let omittedLines = max(0, newlineCount - keptNewlines)
+        return String(decoding: keptHead, as: UTF8.self)
+            + "\n[... \(omittedLines) lines (\(omittedBytes) bytes) omitted ...]\n"
+            + String(decoding: keptTail, as: UTF8.self)
+    }
+
+    // MARK: - Private
+
+    private var orderedTail: [UInt8] {
+        guard tail.count == tailLimit, tailStart > 0 else { return tail }
+        return Array(tail[tailStart...] + tail[..<tailStart])
+    }
+
+    private mutating func appendToTail(_ bytes: ArraySlice<UInt8>) {
+        guard tailLimit > 0, !bytes.isEmpty else { return }
+        if bytes.count >= tailLimit {
+            tail = Array(bytes.suffix(tailLimit))
+            tailStart = 0
+            return
+        }
+        let room = tailLimit - tail.count
+        if room > 0 {
+            tail.append(contentsOf: bytes.prefix(room))
+        }
+        var index = tailStart
+        for byte in bytes.dropFirst(room) {
+            tail[index] = byte
+            index += 1
+            if index == tailLimit { index = 0 }
+        }
+        tailStart = index
+    }
+
+    /// End of the head after its last newline, or at a UTF-8 boundary when
+    /// it holds a single line.
+    private static func headCut(_ bytes: [UInt8]) -> Int {
+        if let newline = bytes.lastIndex(of: 0x0A) {
+            return newline
+        }
+        var lead = bytes.count
+        while lead > 0, bytes[lead - 1] & 0xC0 == 0x80 { lead -= 1 }
+        guard lead > 0, bytes[lead - 1] >= 0xC0 else { return bytes.count }
+        let width = bytes[lead - 1] >= 0xF0 ? 4 : bytes[lead - 1] >= 0xE0 ? 3 : 2
+        return bytes.count - (lead - 1) >= width ? bytes.count : lead - 1
+    }
+
+    /// Start of the tail after its first newline, or at a UTF-8 boundary
+    /// when it holds a single line.
+    private static func tailCut(_ bytes: [UInt8]) -> Int {
+        if let newline = bytes.firstIndex(of: 0x0A), newline + 1 < bytes.count {
+            return newline + 1
+        }
+        var start = 0
+        while start < bytes.count, bytes[start] & 0xC0 == 0x80 { start += 1 }
+        return start
+    }
+}
@@ -77,6 +77,8 @@ enum HunkLine: Sendable, Equatable {
 /// - Context lines for verification
 /// - Pure additions (creating content where none existed)
 /// - Fuzzy line matching with configurable tolerance
+/// - Hunks whose line numbers drifted further, located through a hash index
+///   of the file's lines (`applyReportingPlacements` reports the drift)
 ///
 /// Usage:
 /// ```swift
@@ -171,10 +173,16 @@ struct UnifiedDiffPatcher: Sendable {
         case .create:
             return applyCreate(hunks: hunks)
         case .patch:
-            return try applyPatch(hunks: hunks, to: original)
+            return try applyPatch(hunks: hunks, to: original).content
         }
     }
 
+    /// Apply a unified diff in patch mode and report where each hunk landed
+    /// relative to its header.
+    func applyReportingPlacements(diff: String, to original: String) throws -> PatchApplication {
+        try applyPatch(hunks: parse(diff: diff), to: original)
+    }
+
     // MARK: - Hunk Parsing
 
     /// Regex for unified diff hunk headers: @@ -start[,count] +start[,count] @@
@@ -285,8 +293,9 @@ struct UnifiedDiffPatcher: Sendable {
 
     // MARK: - Apply: Patch Mode
 
-    /// Normal patch mode: verify context, apply removals and additions.
-    private func applyPatch(hunks: [DiffHunk], to original: String) throws -> String {
+    /// Normal patch mode: locate every hunk in the original, then apply
+    /// removals and additions from the bottom up.
+    private func applyPatch(hunks: [DiffHunk], to original: String) throws -> PatchApplication {
         // Empty string splits to [""] — use [] instead so pure additions work correctly.
         var sourceLines = original.isEmpty ? [] : original.components(separatedBy: "\n")
 
@@ -297,27 +306,44 @@ struct UnifiedDiffPatcher: Sendable {
             sourceLines.removeLast()
         }
 
-        // Apply hunks in reverse order so line numbers stay valid.
-        let sortedHunks = hunks.sorted { $0.originalStart > $1.originalStart }
-
-        // Verify no overlaps.
-        for i in 0..<sortedHunks.count - 1 {
-            let current = sortedHunks[i]
-            let next = sortedHunks[i + 1]
+        // Verify the headers do not overlap.
+        let byHeader = hunks.sorted { $0.originalStart > $1.originalStart }
+        for i in 0..<byHeader.count - 1 {
+            let current = byHeader[i]
+            let next = byHeader[i + 1]
             if next.originalStart + next.originalCount > current.originalStart {
                 throw DiffError.overlappingHunks(hunkIndex: hunks.firstIndex(of: current)!)
             }
         }
 
-        for (reverseIdx, hunk) in sortedHunks.enumerated() {
-            let hunkIndex = hunks.count - 1 - reverseIdx
-
-            // Find the best matching position (exact or fuzzy).
-            let matchStart = try findHunkPosition(
-                hunk: hunk,
+        // Locate every hunk against the unmodified source, whose lines are
+        // hashed once.
+        let index = SourceLineIndex(sourceLines)
+        var placements: [HunkPlacement] = []
+        placements.reserveCapacity(hunks.count)
+        for (hunkIndex, hunk) in hunks.enumerated() {
+            let matchStart = try findHunkPosition(hunk: hunk, hunkIndex: hunkIndex, in: sourceLines, index: index)
+            placements.append(HunkPlacement(
                 hunkIndex: hunkIndex,
-                in: sourceLines
-            )
+                expectedLine: max(hunk.originalStart - 1, 0) + 1,
+                appliedLine: matchStart + 1
+            ))
+        }
+
+        // Relocated hunks must still not overlap. Apply bottom-up so the
+        // located line numbers stay valid.
+        let order = placements.sorted { $0.appliedLine > $1.appliedLine }
+        for i in 0..<order.count - 1 {
+            let next = order[i + 1]
+            if next.appliedLine - 1 + hunks[next.hunkIndex].oldSideLineCount > order[i].appliedLine - 1 {
+                throw DiffError.overlappingHunks(hunkIndex: order[i].hunkIndex)
+            }
+        }
+
+        for placement in order {
+            let hunk = hunks[placement.hunkIndex]
+            let hunkIndex = placement.hunkIndex
+            let matchStart = placement.appliedLine - 1
 
             // Build replacement lines.
             var replacement: [String] = []
@@ -372,76 +398,74 @@ struct UnifiedDiffPatcher: Sendable {
         if endsWithNewline {
             result += "\n"
         }
-        return result
+        return PatchApplication(content: result, placements: placements)
     }
 
-    // MARK: - Fuzzy Position Finding
+    // MARK: - Position Finding
 
-    /// Find where a hunk should be applied, with fuzzy matching if exact position fails.
+    /// Find where a hunk should be applied.
+    ///
+    /// Tries the header's position, then up to `fuzzLines` either side, then
+    /// every occurrence of the hunk's rarest line anywhere in the file,
+    /// taking the match nearest the header. All comparisons are on the
+    /// index's integer line keys.
     private func findHunkPosition(
         hunk: DiffHunk,
         hunkIndex: Int,
-        in sourceLines: [String]
+        in sourceLines: [String],
+        index: SourceLineIndex
     ) throws -> Int {
         // Unified diffs use 1-based line numbers.
         let exactStart = hunk.originalStart - 1
+        let oldLines = hunk.oldSideLines
+        let pattern = oldLines.map { index.key(for: $0) ?? SourceLineIndex.missingKey }
 
-        // Try exact position first.
-        if exactStart >= 0 && exactStart <= sourceLines.count {
-            if verifyHunkContext(hunk: hunk, in: sourceLines, at: exactStart) {
-                return exactStart
-            }
+        // Exact position first, then the fuzz window: below, then above.
+        if index.matches(pattern, at: exactStart) {
+            return exactStart
         }
-
-        // Fuzzy search: try positions near the expected start.
-        for offset in 1...fuzzLines {
-            // Try below.
-            let below = exactStart + offset
-            if below >= 0 && below <= sourceLines.count {
-                if verifyHunkContext(hunk: hunk, in: sourceLines, at: below) {
-                    return below
-                }
+        for offset in stride(from: 1, through: fuzzLines, by: 1) {
+            if index.matches(pattern, at: exactStart + offset) {
+                return exactStart + offset
             }
-            // Try above.
-            let above = exactStart - offset
-            if above >= 0 && above <= sourceLines.count {
-                if verifyHunkContext(hunk: hunk, in: sourceLines, at: above) {
-                    return above
-                }
+            if index.matches(pattern, at: exactStart - offset) {
+                return exactStart - offset
             }
         }
 
         // Last resort: if the hunk is pure additions (no context or removals to verify),
         // use the exact position even if it's at the end of the file.
-        let hasVerifiableLines = hunk.lines.contains { line in
-            switch line {
-            case .context, .removal: return true
-            case .addition: return false
-            }
+        if pattern.isEmpty {
+            return min(exactStart, sourceLines.count)
         }
 
-        if !hasVerifiableLines {
-            return min(exactStart, sourceLines.count)
+        // Relocated hunk: anchor on the rarest line.
+        if let relocated = index.nearestMatch(of: pattern, to: exactStart) {
+            return relocated
         }
 
-        // Hunk has verifiable lines but no position matched.
-        // If the exact position was within bounds, throw a contextMismatch so
-        // callers get a diagnostic pointing at the mismatched line rather than
-        // a misleading "out of bounds" error.
-        if exactStart >= 0 && exactStart < sourceLines.count {
-            // Find first verifiable line to build a helpful error.
-            for line in hunk.lines {
-                switch line {
-                case .context(let expected), .removal(let expected):
-                    let actual = exactStart < sourceLines.count ? sourceLines[exactStart] : ""
+        // No exact match anywhere. Align the hunk with the source on the
+        // lines unique to both, patience-diff style, so the error points at
+        // the first line that actually differs where the hunk belongs.
+        let alignedStart = index.alignedStart(of: pattern, near: exactStart) ?? exactStart
+        if alignedStart >= 0 && alignedStart < sourceLines.count {
+            for (offset, expected) in oldLines.enumerated() {
+                let position = alignedStart + offset
+                guard position < sourceLines.count else {
                     throw DiffError.contextMismatch(
                         hunkIndex: hunkIndex,
-                        expectedLine: exactStart + 1,
+                        expectedLine: position + 1,
                         expected: expected,
-                        actual: actual
+                        actual: ""
+                    )
+                }
+                if index.keys[position] != pattern[offset] {
+                    throw DiffError.contextMismatch(
+                        hunkIndex: hunkIndex,
+                        expectedLine: position + 1,
+                        expected: expected,
+                        actual: sourceLines[position]
                     )
-                case .addition:
-                    continue
                 }
             }
         }
@@ -453,39 +477,170 @@ struct UnifiedDiffPatcher: Sendable {
         )
     }
 
-    /// Check if a hunk's context/removal lines match the source at a given position.
-    private func verifyHunkContext(
-        hunk: DiffHunk,
-        in sourceLines: [String],
-        at position: Int
-    ) -> Bool {
-        var sourceOffset = position
+    /// Compare two lines with whitespace tolerance.
+    ///
+    /// Tolerates trailing whitespace differences, which are common when
+    /// AI models generate diffs (they often strip or add trailing spaces).
+    private func linesMatch(_ a: String, _ b: String) -> Bool {
+        a == b || SourceLineIndex.normalized(a) == SourceLineIndex.normalized(b)
+    }
+}
+
+// MARK: - Placements
+
+/// Where a hunk was applied, as 1-based lines in the original file.
+struct HunkPlacement: Sendable, Equatable {
+    let hunkIndex: Int
+    /// The line the hunk header named.
+    let expectedLine: Int
+    /// The line the hunk's first context or removal line matched.
+    let appliedLine: Int
 
-        for line in hunk.lines {
+    /// Lines between the header's position and where the hunk matched;
+    /// positive when the hunk moved down the file.
+    var drift: Int { appliedLine - expectedLine }
+}
+
+/// Patched content plus where each hunk landed.
+struct PatchApplication: Sendable, Equatable {
+    let content: String
+    /// One per hunk, in diff order.
+    let placements: [HunkPlacement]
+}
+
+private extension DiffHunk {
+    /// Context and removal lines: the text the hunk expects in the original.
+    var oldSideLines: [String] {
+        lines.compactMap { line in
             switch line {
-            case .context(let expected), .removal(let expected):
-                guard sourceOffset < sourceLines.count else { return false }
-                if !linesMatch(sourceLines[sourceOffset], expected) {
-                    return false
-                }
-                sourceOffset += 1
-            case .addition:
-                continue
+            case .context(let text), .removal(let text): return text
+            case .addition: return nil
             }
         }
+    }
+
+    var oldSideLineCount: Int {
+        lines.reduce(0) { count, line in
+            if case .addition = line { return count }
+            return count + 1
+        }
+    }
+}
+
+// MARK: - Source Line Index
+
+/// The source's lines hashed once into integer keys. Lines that
+/// `linesMatch` treats as equal (trailing whitespace aside) share a key,
+/// and each key lists the positions it occurs at.
+private struct SourceLineIndex {
+
+    /// Key for hunk lines that occur nowhere in the source.
+    static let missingKey = -1
+
+    /// Key of each source line.
+    private(set) var keys: [Int] = []
+    private var keyByLine: [Substring: Int] = [:]
+    /// Ascending positions of each key.
+    private var positions: [[Int]] = []
+
+    init(_ lines: [String]) {
+        keys.reserveCapacity(lines.count)
+        for (position, line) in lines.enumerated() {
+            let normalized = Self.normalized(line)
+            let key: Int
+            if let existing = keyByLine[normalized] {
+                key = existing
+            } else {
+                key = positions.count
+                keyByLine[normalized] = key
+                positions.append([])
+            }
+            keys.append(key)
+            positions[key].append(position)
+        }
+    }
+
+    /// `line` without trailing whitespace.
+    static func normalized(_ line: String) -> Substring {
+        var end = line.endIndex
+        while end > line.startIndex {
+            let previous = line.index(before: end)
+            guard line[previous].isWhitespace else { break }
+            end = previous
+        }
+        return line[..<end]
+    }
 
+    func key(for line: String) -> Int? {
+        keyByLine[Self.normalized(line)]
+    }
+
+    /// Whether `pattern` matches the source starting at `start`. An empty
+    /// pattern matches anywhere from the first line to the end.
+    func matches(_ pattern: [Int], at start: Int) -> Bool {
+        guard start >= 0, start + pattern.count <= keys.count else { return false }
+        for offset in pattern.indices where keys[start + offset] != pattern[offset] {
+            return false
+        }
         return true
     }
 
-    /// Compare two lines with whitespace tolerance.
-    ///
-    /// Tolerates trailing whitespace differences, which are common when
-    /// AI models generate diffs (they often strip or add trailing spaces).
-    private func linesMatch(_ a: String, _ b: String) -> Bool {
-        if a == b { return true }
-        // Trim trailing whitespace for fuzzy match.
-        let trimA = a.replacingOccurrences(of: "\\s+$", with: "", options: .regularExpression)
-        let trimB = b.replacingOccurrences(of: "\\s+$", with: "", options: .regularExpression)
-        return trimA == trimB
+    /// The match of `pattern` nearest `target`, found through the
+    /// occurrences of its rarest line.
+    func nearestMatch(of pattern: [Int], to target: Int) -> Int? {
+        guard !pattern.contains(Self.missingKey) else { return nil }
+        guard let anchor = pattern.indices.min(by: { positions[pattern[$0]].count < positions[pattern[$1]].count }) else {
+            return nil
+        }
+        var best: Int?
+        for position in positions[pattern[anchor]] {
+            let start = position - anchor
+            guard matches(pattern, at: start) else { continue }
+            if best.map({ abs(start - target) < abs($0 - target) }) ?? true {
+                best = start
+            }
+        }
+        return best
+    }
+
+    /// The start implied by the longest increasing run of lines that occur
+    /// once in `pattern` and once in the source, taking the most common
+    /// start among them (nearest `target` on a tie). Nil when no line is
+    /// unique to both.
+    func alignedStart(of pattern: [Int], near target: Int) -> Int? {
+        var patternCounts: [Int: Int] = [:]
+        for key in pattern where key != Self.missingKey {
+            patternCounts[key, default: 0] += 1
+        }
+        let anchors: [(offset: Int, position: Int)] = pattern.indices.compactMap { offset in
+            let key = pattern[offset]
+            guard key != Self.missingKey, patternCounts[key] == 1, positions[key].count == 1 else { return nil }
+            return (offset, positions[key][0])
+        }
+        guard !anchors.isEmpty else { return nil }
+
+        // Longest increasing subsequence of source positions (patience sort).
+        var pileTops: [Int] = []      // anchor index on top of each pile
+        var previous = [Int](repeating: -1, count: anchors.count)
+        for (i, anchor) in anchors.enumerated() {
+            var lo = 0
+            var hi = pileTops.count
+            while lo < hi {
+                let mid = (lo + hi) / 2
+                if anchors[pileTops[mid]].position < anchor.position { lo = mid + 1 } else { hi = mid }
+            }
+            if lo > 0 { previous[i] = pileTops[lo - 1] }
+            if lo == pileTops.count { pileTops.append(i) } else { pileTops[lo] = i }
+        }
+
+        var startCounts: [Int: Int] = [:]
+        var cursor = pileTops.last ?? -1
+        while cursor >= 0 {
+            startCounts[anchors[cursor].position - anchors[cursor].offset, default: 0] += 1
+            cursor = previous[cursor]
+        }
+        return startCounts.max { a, b in
+            a.value != b.value ? a.value < b.value : abs(a.key - target) > abs(b.key - target)
+        }?.key
     }
 }
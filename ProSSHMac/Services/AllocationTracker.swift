@@ -0,0 +1,226 @@
+// AllocationTracker.swift
+// ProSSHV2
+//
+// Debug instrumentation counting heap allocations on the hot paths:
+// TerminalEngine's chunk parse, grid snapshot builds, CellBuffer uploads
+// and the renderer's frame. Like BenchmarkAllocationCounter it hooks
+// libmalloc's `malloc_logger`, but a thread's allocations are only counted
+// while that thread is inside an `AllocationScope`, so work on other
+// threads is not charged to the path being measured. Scopes nest, and an
+// inner scope's allocations also count towards the one around it. The
+// frame scope therefore includes the cell upload, and Metal's own command
+// buffer and encoder allocations too.
+//
+// A scope does not follow a task across a suspension. Code that awaits
+// inside one suspends it first and resumes it afterwards, on whatever
+// thread it then runs.
+//
+// While disabled, `begin` costs one relaxed atomic load. Tests call
+// `enable()` directly. In Debug builds it can also be turned on at launch.
+// It cannot be enabled while another logger holds the hook
+// (MallocStackLogging, Instruments, a running BenchmarkAllocationCounter).
+// While it is on, BenchmarkAllocationCounter reports itself unavailable.
+//
+// Toggle via: `defaults write com.prossh terminal.allocationTracking.enabled -bool true`
+
+import Darwin
+import Synchronization
+
+// MARK: - AllocationSite
+
+nonisolated enum AllocationSite: String, CaseIterable, Sendable {
+    /// One chunk through `TerminalEngine`'s parser loop.
+    case parse
+    /// One `GridSnapshot` build.
+    case snapshot
+    /// One `CellBuffer.update(from:)`.
+    case cellBufferUpdate
+    /// One `MetalTerminalRenderer.draw(in:)` that renders.
+    case frame
+}
+
+// MARK: - AllocationCounts
+
+nonisolated struct AllocationCounts: Sendable, Equatable {
+    var calls: UInt64 = 0
+    var allocations: UInt64 = 0
+    /// Input bytes covered by the calls; parse scopes report chunk sizes.
+    var bytes: UInt64 = 0
+
+    var allocationsPerCall: Double {
+        calls > 0 ? Double(allocations) / Double(calls) : 0
+    }
+
+    var allocationsPerMB: Double? {
+        bytes > 0 ? Double(allocations) / (Double(bytes) / 1_048_576.0) : nil
+    }
+}
+
+// MARK: - AllocationTracker
+
+nonisolated enum AllocationTracker {
+
+    static let enabledDefaultsKey = "terminal.allocationTracking.enabled"
+
+    private typealias MallocLogger = @convention(c) (UInt32, UInt, UInt, UInt, UInt, UInt32) -> Void
+
+    /// `MALLOC_LOG_TYPE_ALLOCATE` from libmalloc.
+    private static let allocateFlag: UInt32 = 2
+
+    private static let enabled = Atomic<Bool>(false)
+
+    /// The innermost open scope's counter on this thread, if any.
+    fileprivate static let scopeKey: pthread_key_t = {
+        var key = pthread_key_t()
+        pthread_key_create(&key, nil)
+        return key
+    }()
+
+    /// Fixed up front so recording a scope never allocates.
+    private static let totals: [AllocationSite: SiteTotals] = Dictionary(
+        uniqueKeysWithValues: AllocationSite.allCases.map { ($0, SiteTotals()) }
+    )
+
+    nonisolated(unsafe) private static let loggerSlot: UnsafeMutablePointer<MallocLogger?>? = {
+        let defaultHandle = UnsafeMutableRawPointer(bitPattern: -2)  // RTLD_DEFAULT
+        return dlsym(defaultHandle, "malloc_logger")?.assumingMemoryBound(to: MallocLogger?.self)
+    }()
+
+    /// Runs inside malloc: only a thread-specific read and an increment of a
+    /// counter no other thread writes.
+    private static let logger: MallocLogger = { type, _, _, _, _, _ in
+        guard type & AllocationTracker.allocateFlag != 0,
+              let counter = pthread_getspecific(AllocationTracker.scopeKey) else { return }
+        counter.assumingMemoryBound(to: UInt64.self).pointee &+= 1
+    }
+
+    static var isEnabled: Bool {
+        enabled.load(ordering: .relaxed)
+    }
+
+    /// Installs the hook. Returns false when another logger holds it.
+    @discardableResult
+    static func enable() -> Bool {
+        guard !isEnabled else { return true }
+        // Touch the statics first so their lazy initialisation never runs
+        // inside the hook.
+        _ = allocateFlag
+        _ = scopeKey
+        _ = totals
+        let hook = logger
+        guard let slot = loggerSlot, slot.pointee == nil else { return false }
+        slot.pointee = hook
+        enabled.store(true, ordering: .relaxed)
+        return true
+    }
+
+    /// Removes the hook. Totals are kept until `reset()`.
+    static func disable() {
+        guard enabled.exchange(false, ordering: .relaxed) else { return }
+        loggerSlot?.pointee = nil
+    }
+
+    /// Opens a scope on the current thread, or nil while disabled.
+    static func begin(_ site: AllocationSite) -> AllocationScope? {
+        guard enabled.load(ordering: .relaxed) else { return nil }
+        return AllocationScope(site: site)
+    }
+
+    static func counts(for site: AllocationSite) -> AllocationCounts {
+        totals[site]?.counts ?? AllocationCounts()
+    }
+
+    static func reset() {
+        for site in totals.values {
+            site.reset()
+        }
+    }
+
+    /// One line per site that was measured.
+    static var report: String {
+        let lines = AllocationSite.allCases.compactMap { site -> String? in
+            let counts = counts(for: site)
+            guard counts.calls > 0 else { return nil }
+            var line = "\(site.rawValue): \(counts.calls) calls, \(counts.allocations) allocations, "
+                + String(format: "%.2f/call", counts.allocationsPerCall)
+            if let perMB = counts.allocationsPerMB {
+                line += String(format: ", %.1f/MB", perMB)
+            }
+            return line
+        }
+        return lines.isEmpty ? "No allocations recorded." : lines.joined(separator: "\n")
+    }
+
+    fileprivate static func record(_ site: AllocationSite, allocations: UInt64, bytes: Int) {
+        totals[site]?.add(allocations: allocations, bytes: bytes)
+    }
+
+    private final class SiteTotals: Sendable {
+        private let calls = Atomic<UInt64>(0)
+        private let allocations = Atomic<UInt64>(0)
+        private let bytes = Atomic<UInt64>(0)
+
+        var counts: AllocationCounts {
+            AllocationCounts(
+                calls: calls.load(ordering: .relaxed),
+                allocations: allocations.load(ordering: .relaxed),
+                bytes: bytes.load(ordering: .relaxed)
+            )
+        }
+
+        func add(allocations count: UInt64, bytes byteCount: Int) {
+            calls.add(1, ordering: .relaxed)
+            allocations.add(count, ordering: .relaxed)
+            bytes.add(UInt64(max(byteCount, 0)), ordering: .relaxed)
+        }
+
+        func reset() {
+            calls.store(0, ordering: .relaxed)
+            allocations.store(0, ordering: .relaxed)
+            bytes.store(0, ordering: .relaxed)
+        }
+    }
+}
+
+// MARK: - AllocationScope
+
+/// Counts the current thread's allocations until `end(bytes:)`.
+nonisolated struct AllocationScope {
+    let site: AllocationSite
+    private let counter: UnsafeMutablePointer<UInt64>
+    private var enclosing: UnsafeMutableRawPointer?
+
+    fileprivate init(site: AllocationSite) {
+        self.site = site
+        let key = AllocationTracker.scopeKey
+        enclosing = pthread_getspecific(key)
+        // Allocate the counter uncounted, so a nested scope costs its
+        // enclosing one nothing.
+        pthread_setspecific(key, nil)
+        counter = .allocate(capacity: 1)
+        counter.initialize(to: 0)
+        pthread_setspecific(key, counter)
+    }
+
+    /// Stop counting on this thread, before an `await`.
+    func suspend() {
+        pthread_setspecific(AllocationTracker.scopeKey, enclosing)
+    }
+
+    /// Count again on the current thread, after an `await`.
+    mutating func resume() {
+        let key = AllocationTracker.scopeKey
+        enclosing = pthread_getspecific(key)
+        pthread_setspecific(key, counter)
+    }
+
+    /// Close the scope and charge its allocations to `site` and to the
+    /// enclosing scope. `bytes` is the input the call covered, if any.
+    func end(bytes: Int = 0) {
+        pthread_setspecific(AllocationTracker.scopeKey, enclosing)
+        let allocations = counter.pointee
+        counter.deallocate()
+        enclosing?.assumingMemoryBound(to: UInt64.self).pointee &+= allocations
+        AllocationTracker.record(site, allocations: allocations, bytes: bytes)
+    }
+}
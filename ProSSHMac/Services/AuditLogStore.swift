@@ -1,4 +1,34 @@
+// AuditLogStore.swift
+// ProSSHV2
+//
+// Persistent audit trail. Entries used to live in one encrypted JSON array
+// that was loaded, decrypted, re-encoded and re-encrypted on every append.
+// Now they go to an append-only log split into segments.
+//
+// Layout, in Application Support/ProSSHV2/AuditLog:
+//   00000001.log, 00000002.log, ...
+//     magic "PSSHAUD1", 32-byte key salt, then records:
+//     UInt32 length (little-endian) + AES-GCM sealed JSON of one entry
+//
+// Appending seals one record and writes it at the end of the newest
+// segment. A segment holds `segmentCapacity` records; then a new one is
+// started. Trimming to `maxEntries` deletes whole old segments, so up to
+// one segment's worth of extra entries stays on disk until the next one
+// can go. Reads skip those extras.
+//
+// On launch only the length prefixes are scanned to index the records.
+// `loadEntries(limit:)` decrypts just the newest records it returns. A torn
+// record at the end of the newest segment (from a crash mid-write) is cut
+// off. The store is an actor, so callers never wait on disk or crypto work
+// while holding a lock.
+//
+// Each segment's key is derived from the EncryptedStorage master key with
+// the salt stored in its header. The old audit_log.json array is imported
+// once and then removed.
+
+import CryptoKit
 import Foundation
+import os.log
 
 protocol AuditLogStoreProtocol: Sendable {
     func loadEntries(limit: Int?) async throws -> [AuditLogEntry]
@@ -6,87 +36,249 @@ protocol AuditLogStoreProtocol: Sendable {
     func clearAll() async throws
 }
 
-final class FileAuditLogStore: AuditLogStoreProtocol, @unchecked Sendable {
+actor FileAuditLogStore: AuditLogStoreProtocol {
+
+    /// Upper bound on records per segment.
+    static let maxSegmentCapacity = 1_024
+
+    private static let magic = Data("PSSHAUD1".utf8)
+    private static let saltSize = 32
+    private static var headerSize: Int { magic.count + saltSize }
+    private static let logger = Logger(subsystem: "com.prossh", category: "AuditLog")
+
+    private nonisolated struct Segment {
+        let url: URL
+        let number: Int
+        let key: SymmetricKey
+        /// File offset and sealed length of each record.
+        var records: [(offset: Int, length: Int)]
+        var length: Int
+    }
+
     private let fileManager: FileManager
-    private let fileURL: URL
+    private let directory: URL
+    private let legacyFileURL: URL
     private let maxEntries: Int
-    private let lock = NSLock()
+    private let segmentCapacity: Int
+    private let makeKey: @Sendable (Data) throws -> SymmetricKey
 
+    private var segments: [Segment] = []
+    private var handle: FileHandle?
+    private var isLoaded = false
+
+    /// A store in `baseDirectory` (Application Support/ProSSHV2 by default).
+    /// `makeKey` derives a segment's key from the salt in its header.
     init(
         fileManager: FileManager = .default,
-        maxEntries: Int = 5_000
+        maxEntries: Int = 5_000,
+        baseDirectory: URL? = nil,
+        makeKey: @escaping @Sendable (Data) throws -> SymmetricKey = { salt in
+            try EncryptedStorage.derivedKey(purpose: "audit-log-v1", salt: salt)
+        }
     ) {
+        let baseDirectory = baseDirectory ?? Self.defaultBaseDirectory(fileManager: fileManager)
         self.fileManager = fileManager
-        self.fileURL = Self.defaultFileURL(fileManager: fileManager)
-        self.maxEntries = maxEntries
+        self.directory = baseDirectory.appendingPathComponent("AuditLog", isDirectory: true)
+        self.legacyFileURL = baseDirectory.appendingPathComponent("audit_log.json")
+        self.maxEntries = max(1, maxEntries)
+        self.segmentCapacity = max(1, min(Self.maxSegmentCapacity, maxEntries / 4))
+        self.makeKey = makeKey
     }
 
+    /// Newest entries first.
     func loadEntries(limit: Int?) async throws -> [AuditLogEntry] {
-        try withLock {
-            let sorted = try loadEntriesLocked().sorted { $0.timestamp > $1.timestamp }
-            guard let limit, limit > 0 else {
-                return sorted
+        try loadIfNeeded()
+        var remaining = min(limit.flatMap { $0 > 0 ? $0 : nil } ?? maxEntries, maxEntries)
+        var entries: [AuditLogEntry] = []
+        let decoder = Self.makeDecoder()
+        for segment in segments.reversed() where remaining > 0 {
+            let reader = try FileHandle(forReadingFrom: segment.url)
+            defer { try? reader.close() }
+            for record in segment.records.reversed() {
+                guard remaining > 0 else { break }
+                let entry = try Self.readEntry(record, from: reader, key: segment.key, decoder: decoder)
+                entries.append(entry)
+                remaining -= 1
             }
-            return Array(sorted.prefix(limit))
         }
+        // Appends are in time order unless the clock stepped back.
+        return entries.sorted { $0.timestamp > $1.timestamp }
     }
 
     func append(_ entry: AuditLogEntry) async throws {
-        try withLock {
-            var entries = try loadEntriesLocked()
-            entries.append(entry)
-            if entries.count > maxEntries {
-                entries.removeFirst(entries.count - maxEntries)
-            }
-            try persistLocked(entries)
-        }
+        try loadIfNeeded()
+        try appendLocked(entry, encoder: Self.makeEncoder())
     }
 
     func clearAll() async throws {
-        try withLock {
-            try persistLocked([])
+        try loadIfNeeded()
+        try? handle?.close()
+        handle = nil
+        for segment in segments {
+            try fileManager.removeItem(at: segment.url)
         }
+        segments = []
     }
 
-    private func loadEntriesLocked() throws -> [AuditLogEntry] {
-        guard fileManager.fileExists(atPath: fileURL.path(percentEncoded: false)) else {
-            return []
+    // MARK: - Appending
+
+    private func appendLocked(_ entry: AuditLogEntry, encoder: JSONEncoder) throws {
+        if segments.last.map({ $0.records.count >= segmentCapacity }) ?? true {
+            try startSegment()
         }
+        guard let handle, var segment = segments.last else { return }
 
-        let decoder = JSONDecoder()
-        decoder.dateDecodingStrategy = .iso8601
-        return try EncryptedStorage.loadJSON(
+        let sealed = try AES.GCM.seal(try encoder.encode(entry), using: segment.key).combined
+        guard let sealed else { throw CocoaError(.fileWriteUnknown) }
+        var frame = Data()
+        withUnsafeBytes(of: UInt32(sealed.count).littleEndian) { frame.append(contentsOf: $0) }
+        frame.append(sealed)
+        try handle.seek(toOffset: UInt64(segment.length))
+        try handle.write(contentsOf: frame)
+        segment.records.append((offset: segment.length + 4, length: sealed.count))
+        segment.length += frame.count
+        segments[segments.count - 1] = segment
+    }
+
+    /// Start a new segment and drop old ones that only hold entries past
+    /// `maxEntries`.
+    private func startSegment() throws {
+        try? handle?.close()
+        handle = nil
+
+        let number = (segments.last?.number ?? 0) + 1
+        let url = directory.appendingPathComponent(String(format: "%08d.log", number))
+        var header = Self.magic
+        let salt = SymmetricKey(size: .bits256).withUnsafeBytes { Data($0) }
+        header.append(salt)
+        guard fileManager.createFile(
+            atPath: url.path(percentEncoded: false),
+            contents: header,
+            attributes: [.posixPermissions: 0o600, .protectionKey: FileProtectionType.complete]
+        ) else {
+            throw CocoaError(.fileWriteUnknown)
+        }
+        segments.append(Segment(url: url, number: number, key: try makeKey(salt), records: [], length: Self.headerSize))
+        handle = try FileHandle(forUpdating: url)
+
+        var total = segments.reduce(0) { $0 + $1.records.count }
+        while segments.count > 1, total - segments[0].records.count >= maxEntries {
+            total -= segments[0].records.count
+            try? fileManager.removeItem(at: segments[0].url)
+            segments.removeFirst()
+        }
+    }
+
+    // MARK: - Loading
+
+    private func loadIfNeeded() throws {
+        guard !isLoaded else { return }
+        try fileManager.createDirectory(at: directory, withIntermediateDirectories: true)
+        let numbered = try fileManager.contentsOfDirectory(at: directory, includingPropertiesForKeys: nil)
+            .compactMap { url -> (Int, URL)? in
+                guard url.pathExtension == "log", let number = Int(url.deletingPathExtension().lastPathComponent) else {
+                    return nil
+                }
+                return (number, url)
+            }
+            .sorted { $0.0 < $1.0 }
+
+        for (index, (number, url)) in numbered.enumerated() {
+            do {
+                segments.append(try Self.scanSegment(url, number: number, isNewest: index == numbered.count - 1, makeKey: makeKey))
+            } catch {
+                Self.logger.error("Audit log segment \(number) unreadable: \(error.localizedDescription, privacy: .public)")
+            }
+        }
+        if let newest = segments.last {
+            handle = try FileHandle(forUpdating: newest.url)
+        }
+        isLoaded = true
+        try importLegacyLogIfNeeded()
+    }
+
+    /// Index a segment's records from their length prefixes.
+    private static func scanSegment(
+        _ url: URL,
+        number: Int,
+        isNewest: Bool,
+        makeKey: (Data) throws -> SymmetricKey
+    ) throws -> Segment {
+        let handle = try FileHandle(forUpdating: url)
+        defer { try? handle.close() }
+        let header = try handle.read(upToCount: headerSize) ?? Data()
+        guard header.count == headerSize, header.prefix(magic.count) == magic else {
+            throw CocoaError(.fileReadCorruptFile)
+        }
+        let key = try makeKey(Data(header.suffix(saltSize)))
+        let fileLength = Int(try handle.seekToEnd())
+
+        var records: [(offset: Int, length: Int)] = []
+        var offset = headerSize
+        while offset + 4 <= fileLength {
+            try handle.seek(toOffset: UInt64(offset))
+            guard let lengthBytes = try handle.read(upToCount: 4), lengthBytes.count == 4 else { break }
+            let length = Int(lengthBytes.withUnsafeBytes { UInt32(littleEndian: $0.loadUnaligned(as: UInt32.self)) })
+            guard offset + 4 + length <= fileLength else { break }
+            records.append((offset: offset + 4, length: length))
+            offset += 4 + length
+        }
+        if offset < fileLength {
+            if isNewest {
+                logger.error("Audit log had a torn tail; truncating")
+                try handle.truncate(atOffset: UInt64(offset))
+            }
+        }
+        return Segment(url: url, number: number, key: key, records: records, length: offset)
+    }
+
+    /// Move entries from the single-file format into the log.
+    private func importLegacyLogIfNeeded() throws {
+        guard fileManager.fileExists(atPath: legacyFileURL.path(percentEncoded: false)) else { return }
+        let legacy = try EncryptedStorage.loadJSON(
             [AuditLogEntry].self,
-            from: fileURL,
+            from: legacyFileURL,
             fileManager: fileManager,
-            decoder: decoder
+            decoder: Self.makeDecoder()
         ) ?? []
+        let encoder = Self.makeEncoder()
+        for entry in legacy.sorted(by: { $0.timestamp < $1.timestamp }).suffix(maxEntries) {
+            try appendLocked(entry, encoder: encoder)
+        }
+        try fileManager.removeItem(at: legacyFileURL)
+    }
+
+    // MARK: - Records
+
+    private static func readEntry(
+        _ record: (offset: Int, length: Int),
+        from handle: FileHandle,
+        key: SymmetricKey,
+        decoder: JSONDecoder
+    ) throws -> AuditLogEntry {
+        try handle.seek(toOffset: UInt64(record.offset))
+        guard let sealed = try handle.read(upToCount: record.length), sealed.count == record.length else {
+            throw CocoaError(.fileReadCorruptFile)
+        }
+        let plaintext = try AES.GCM.open(try AES.GCM.SealedBox(combined: sealed), using: key)
+        return try decoder.decode(AuditLogEntry.self, from: plaintext)
     }
 
-    private func persistLocked(_ entries: [AuditLogEntry]) throws {
+    private static func makeEncoder() -> JSONEncoder {
         let encoder = JSONEncoder()
-        encoder.outputFormatting = [.prettyPrinted, .sortedKeys]
         encoder.dateEncodingStrategy = .iso8601
-        try EncryptedStorage.saveJSON(
-            entries,
-            to: fileURL,
-            fileManager: fileManager,
-            encoder: encoder
-        )
+        return encoder
     }
 
-    private static func defaultFileURL(fileManager: FileManager) -> URL {
-        let baseDirectory = fileManager.urls(for: .applicationSupportDirectory, in: .userDomainMask).first
-            ?? fileManager.temporaryDirectory
-
-        return baseDirectory
-            .appendingPathComponent("ProSSHV2", isDirectory: true)
-            .appendingPathComponent("audit_log.json")
+    private static func makeDecoder() -> JSONDecoder {
+        let decoder = JSONDecoder()
+        decoder.dateDecodingStrategy = .iso8601
+        return decoder
     }
 
-    private func withLock<T>(_ operation: () throws -> T) rethrows -> T {
-        lock.lock()
-        defer { lock.unlock() }
-        return try operation()
+    private static func defaultBaseDirectory(fileManager: FileManager) -> URL {
+        (fileManager.urls(for: .applicationSupportDirectory, in: .userDomainMask).first
+            ?? fileManager.temporaryDirectory)
+            .appendingPathComponent("ProSSHV2", isDirectory: true)
     }
 }
@@ -0,0 +1,145 @@
+import Foundation
+import LocalAuthentication
+
+/// One biometric approval shared by every keychain read that needs one.
+/// Without it each saved password or key passphrase builds its own
+/// `LAContext`, so connecting several hosts in a row prompts once per host
+/// and concurrent connects queue behind each other's prompts. Here the
+/// first caller evaluates the policy; callers arriving meanwhile wait for
+/// that same evaluation, and the approved context is handed to everyone
+/// until `graceWindow` runs out. A failed or cancelled evaluation fails
+/// all its waiters and is not cached.
+nonisolated final class BiometricAuthenticationGate: @unchecked Sendable {
+
+    static let graceWindowDefaultsKey = "security.biometric.graceWindowSeconds"
+    static let defaultGraceWindow: TimeInterval = 30
+
+    /// The configured grace window, clamped to five minutes.
+    /// Set via: `defaults write com.prossh security.biometric.graceWindowSeconds -int 60`
+    static var configuredGraceWindow: TimeInterval {
+        guard let stored = UserDefaults.standard.object(forKey: graceWindowDefaultsKey) as? NSNumber else {
+            return defaultGraceWindow
+        }
+        return min(max(stored.doubleValue, 0), 300)
+    }
+
+    /// An evaluated context. `LAContext` may be passed to the keychain
+    /// from any thread.
+    struct Approval: @unchecked Sendable {
+        let context: LAContext
+    }
+
+    typealias Evaluator = @Sendable (LAContext, String) async throws -> Void
+
+    /// Seconds an approval is reused. Zero still coalesces concurrent
+    /// callers but never reuses an approval afterwards.
+    let graceWindow: TimeInterval
+    private let evaluate: Evaluator
+    private let lock = NSLock()
+    private var approved: (approval: Approval, expiry: ContinuousClock.Instant)?
+    /// Callers waiting on the evaluation in flight; nil when there is none.
+    private var waiters: [CheckedContinuation<Approval?, Error>]?
+
+    init(graceWindow: TimeInterval = BiometricAuthenticationGate.configuredGraceWindow, evaluate: Evaluator? = nil) {
+        self.graceWindow = max(graceWindow, 0)
+        self.evaluate = evaluate ?? Self.evaluateBiometrics
+    }
+
+    /// An approved context, prompting only when no approval is current and
+    /// none is in progress. `reason` is shown by the prompt that runs.
+    func approval(reason: String) async throws -> Approval {
+        while true {
+            switch lock.withLock({ nextRole() }) {
+            case .cached(let approval):
+                return approval
+            case .evaluating:
+                return try await evaluateForAll(reason: reason)
+            case .waiting:
+                let outcome = try await withCheckedThrowingContinuation { (continuation: CheckedContinuation<Approval?, Error>) in
+                    let joined = lock.withLock { () -> Bool in
+                        guard waiters != nil else { return false }
+                        waiters?.append(continuation)
+                        return true
+                    }
+                    // The evaluation finished between the two critical
+                    // sections; look again.
+                    if !joined {
+                        continuation.resume(returning: nil)
+                    }
+                }
+                if let outcome {
+                    return outcome
+                }
+            }
+        }
+    }
+
+    /// Forgets the current approval, so the next read prompts again.
+    func invalidate() {
+        let stale = lock.withLock { () -> Approval? in
+            defer { approved = nil }
+            return approved?.approval
+        }
+        stale?.context.invalidate()
+    }
+
+    private enum Role {
+        case cached(Approval)
+        case waiting
+        case evaluating
+    }
+
+    /// Called with the lock held.
+    private func nextRole() -> Role {
+        if let approved, approved.expiry > .now {
+            return .cached(approved.approval)
+        }
+        approved = nil
+        if waiters != nil {
+            return .waiting
+        }
+        waiters = []
+        return .evaluating
+    }
+
+    private func evaluateForAll(reason: String) async throws -> Approval {
+        let context = LAContext()
+        do {
+            try await evaluate(context, reason)
+        } catch {
+            for waiter in finish(with: nil) {
+                waiter.resume(throwing: error)
+            }
+            throw error
+        }
+        let approval = Approval(context: context)
+        for waiter in finish(with: approval) {
+            waiter.resume(returning: approval)
+        }
+        return approval
+    }
+
+    /// Ends the evaluation in flight, caching `approval` when it succeeded,
+    /// and returns its waiters.
+    private func finish(with approval: Approval?) -> [CheckedContinuation<Approval?, Error>] {
+        lock.withLock {
+            if let approval, graceWindow > 0 {
+                approved = (approval, .now + .milliseconds(Int(graceWindow * 1000)))
+            }
+            defer { waiters = nil }
+            return waiters ?? []
+        }
+    }
+
+    private static let evaluateBiometrics: Evaluator = { context, reason in
+        do {
+            try await context.evaluatePolicy(.deviceOwnerAuthenticationWithBiometrics, localizedReason: reason)
+        } catch let error as LAError where error.code == .userCancel || error.code == .appCancel || error.code == .systemCancel {
+            throw BiometricPasswordError.userCancelled
+        } catch let error as LAError where error.code == .biometryNotAvailable || error.code == .biometryNotEnrolled {
+            throw BiometricPasswordError.biometricsUnavailable
+        } catch {
+            throw BiometricPasswordError.authenticationFailed
+        }
+    }
+}
@@ -44,9 +44,13 @@ enum BiometricPasswordError: LocalizedError {
 
 final class BiometricPasswordStore: BiometricPasswordStoring {
     private let service: String
+    /// Shared with the other biometric stores, so one approval covers a
+    /// burst of connects whatever each of them reads.
+    private let authenticationGate: BiometricAuthenticationGate?
 
-    init(service: String = "nl.budgetsoft.ProSSHV2.host-passwords") {
+    init(service: String = "nl.budgetsoft.ProSSHV2.host-passwords", authenticationGate: BiometricAuthenticationGate? = nil) {
         self.service = service
+        self.authenticationGate = authenticationGate
     }
 
     func isBiometricsAvailable() -> Bool {
@@ -94,10 +98,14 @@ final class BiometricPasswordStore: BiometricPasswordStoring {
     func retrieve(forHostID hostID: UUID, reason: String) async throws -> String {
         let service = self.service
         let account = hostID.uuidString
+        // An evaluated context satisfies the item's biometry ACL without
+        // another prompt.
+        let approval = try await authenticationGate?.approval(reason: reason)
+        let authenticationGate = self.authenticationGate
 
         return try await withCheckedThrowingContinuation { continuation in
             DispatchQueue.global(qos: .userInitiated).async {
-                let context = LAContext()
+                let context = approval?.context ?? LAContext()
                 context.localizedReason = reason
 
                 let query: [String: Any] = [
@@ -119,6 +127,8 @@ final class BiometricPasswordStore: BiometricPasswordStoring {
                     case errSecItemNotFound:
                         continuation.resume(throwing: BiometricPasswordError.noPasswordStored)
                     case errSecAuthFailed:
+                        // E.g. the enrolled fingers changed; the shared approval no longer opens items.
+                        authenticationGate?.invalidate()
                         continuation.resume(throwing: BiometricPasswordError.authenticationFailed)
                     case errSecUserCanceled:
                         continuation.resume(throwing: BiometricPasswordError.userCancelled)
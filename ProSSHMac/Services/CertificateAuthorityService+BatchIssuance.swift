@@ -0,0 +1,327 @@
+// CertificateAuthorityService+BatchIssuance.swift
+// ProSSHV2
+//
+// Fleet provisioning: one CA signs certificates for a whole inventory.
+// Issuing one at a time through `signCertificate` means a keychain lookup
+// per certificate and a save of the whole store after each. In a batch:
+// - Payloads are encoded on the caller, and serials are assigned
+//   consecutively from the CA's counter.
+// - The Secure Enclave key is looked up once, and signing runs across
+//   cores (`SecureEnclaveKeyManager.signSSHCertificatePayloads`).
+// - The certificate store and the CA counter are saved once at the end.
+// Rows that cannot be encoded, such as unparseable keys, are reported as
+// failures and do not use up a serial. A signing or store failure aborts
+// the batch before anything is persisted.
+
+import Foundation
+
+struct BatchCertificateSubject: Equatable {
+    var keyID: String
+    var principals: [String]
+    var subjectPublicKeyAuthorized: String
+    var associatedKeyID: UUID?
+}
+
+struct BatchCertificateIssuanceRequest {
+    var authorityID: UUID
+    var role: CertificateRole
+    var subjects: [BatchCertificateSubject]
+    var validAfter: Date
+    var validBefore: Date
+    var criticalOptions: [String: String] = [:]
+    var extensions: [String: String] = [:]
+}
+
+struct BatchCertificateIssuanceFailure: Equatable {
+    /// Index into the request's subjects.
+    var subjectIndex: Int
+    var keyID: String
+    var message: String
+}
+
+struct BatchCertificateIssuanceResult {
+    var authorities: [CertificateAuthorityModel]
+    var certificates: [SSHCertificate]
+    var issued: [SSHCertificate]
+    var failures: [BatchCertificateIssuanceFailure]
+    var encodingDuration: TimeInterval
+    var signingDuration: TimeInterval
+    var persistenceDuration: TimeInterval
+
+    var totalDuration: TimeInterval {
+        encodingDuration + signingDuration + persistenceDuration
+    }
+
+    var certificatesPerSecond: Double {
+        totalDuration > 0 ? Double(issued.count) / totalDuration : 0
+    }
+
+    var throughputSummary: String {
+        let rate = certificatesPerSecond.formatted(.number.precision(.fractionLength(0)))
+        let phases = [
+            "encode \(Self.milliseconds(encodingDuration))",
+            "sign \(Self.milliseconds(signingDuration))",
+            "save \(Self.milliseconds(persistenceDuration))"
+        ].joined(separator: ", ")
+        return "Issued \(issued.count) certificate(s) in \(Self.milliseconds(totalDuration)) (\(rate)/s; \(phases))."
+    }
+
+    private static func milliseconds(_ duration: TimeInterval) -> String {
+        "\(Int((duration * 1_000).rounded())) ms"
+    }
+}
+
+extension CertificateAuthorityService {
+
+    func issueCertificates(
+        request: BatchCertificateIssuanceRequest,
+        existingAuthorities: [CertificateAuthorityModel],
+        existingCertificates: [SSHCertificate]
+    ) async throws -> BatchCertificateIssuanceResult {
+        let clock = ContinuousClock()
+        let encodingStart = clock.now
+
+        guard request.validBefore > request.validAfter else {
+            throw CertificateAuthorityError.signingFailed(message: "Certificate validity end must be after start.")
+        }
+        guard !request.subjects.isEmpty else {
+            throw CertificateAuthorityError.signingFailed(message: "The inventory has no certificates to issue.")
+        }
+        guard let authorityIndex = existingAuthorities.firstIndex(where: { $0.id == request.authorityID }) else {
+            throw CertificateAuthorityError.signingFailed(message: "Selected certificate authority was not found.")
+        }
+
+        var updatedAuthorities = existingAuthorities
+        var authority = updatedAuthorities[authorityIndex]
+        if authority.keyType != .ecdsa {
+            throw CertificateAuthorityError.signingFailed(message: "Unsupported CA key type.")
+        }
+        if authority.certificateType == request.role.unsupportedAuthorityType {
+            throw CertificateAuthorityError.signingFailed(message: request.role.unsupportedAuthorityMessage)
+        }
+        let authorityPublic = authority.publicKeyAuthorizedFormat?.trimmingCharacters(in: .whitespacesAndNewlines) ?? ""
+        if authorityPublic.isEmpty {
+            throw CertificateAuthorityError.signingFailed(message: "CA public key is unavailable.")
+        }
+        let caPublicKey = try parseAuthorizedPublicKey(authorityPublic)
+
+        struct Pending {
+            var subject: BatchCertificateSubject
+            var keyID: String
+            var serialNumber: UInt64
+            var certificateKeyType: String
+            var subjectKey: ParsedPublicKey
+            var payload: Data
+        }
+
+        var pending: [Pending] = []
+        var failures: [BatchCertificateIssuanceFailure] = []
+        var nextSerial = authority.nextSerialNumber
+        pending.reserveCapacity(request.subjects.count)
+
+        for (index, subject) in request.subjects.enumerated() {
+            let keyID = subject.keyID.trimmingCharacters(in: .whitespacesAndNewlines)
+            do {
+                if keyID.isEmpty {
+                    throw CertificateAuthorityError.signingFailed(message: "Certificate key ID is required.")
+                }
+                guard nextSerial < UInt64.max else {
+                    throw CertificateAuthorityError.signingFailed(
+                        message: "Serial number has reached the maximum allowed value."
+                    )
+                }
+                let subjectKey = try parseAuthorizedPublicKey(subject.subjectPublicKeyAuthorized)
+                let certKeyType = try certificateKeyType(for: subjectKey.keyType)
+                let payload = try certificatePayload(
+                    certificateKeyType: certKeyType,
+                    subjectKey: subjectKey,
+                    serialNumber: nextSerial,
+                    role: request.role,
+                    keyID: keyID,
+                    principals: subject.principals,
+                    validAfter: request.validAfter,
+                    validBefore: request.validBefore,
+                    criticalOptions: request.criticalOptions,
+                    extensions: request.extensions,
+                    caPublicKeyBlob: caPublicKey.rawBlob
+                )
+                pending.append(Pending(
+                    subject: subject,
+                    keyID: keyID,
+                    serialNumber: nextSerial,
+                    certificateKeyType: certKeyType,
+                    subjectKey: subjectKey,
+                    payload: payload
+                ))
+                nextSerial += 1
+            } catch {
+                failures.append(BatchCertificateIssuanceFailure(
+                    subjectIndex: index,
+                    keyID: keyID,
+                    message: error.localizedDescription
+                ))
+            }
+        }
+
+        guard !pending.isEmpty else {
+            throw CertificateAuthorityError.signingFailed(
+                message: "None of the \(request.subjects.count) inventory rows could be signed: \(failures.first?.message ?? "unknown error")"
+            )
+        }
+        guard UInt64.max - authority.issuedCertificateCount >= UInt64(pending.count) else {
+            throw CertificateAuthorityError.signingFailed(
+                message: "Certificate authority has reached the maximum issued certificate count."
+            )
+        }
+
+        let signingStart = clock.now
+        let signatures: [Data]
+        do {
+            signatures = try await secureEnclaveKeyManager.signSSHCertificatePayloads(
+                pending.map(\.payload),
+                tag: authority.secureEnclaveReference
+            )
+        } catch {
+            throw CertificateAuthorityError.signingFailed(
+                message: "Failed to sign \(request.role.displayName) certificates: \(error.localizedDescription)"
+            )
+        }
+        let persistenceStart = clock.now
+
+        let createdAt = Date.now
+        let sortedExtensions = request.extensions.keys.sorted()
+        let issued = zip(pending, signatures).map { entry, signatureBlob in
+            var certificateBlob = entry.payload
+            certificateBlob.append(sshString(from: signatureBlob))
+            return SSHCertificate(
+                id: UUID(),
+                type: request.role.modelCertificateType,
+                serialNumber: entry.serialNumber,
+                keyId: entry.keyID,
+                principals: entry.subject.principals,
+                validAfter: request.validAfter,
+                validBefore: request.validBefore,
+                criticalOptions: request.criticalOptions,
+                extensions: sortedExtensions,
+                signingCAFingerprint: authority.publicKeyFingerprint,
+                signedKeyFingerprint: fingerprintSHA256(for: entry.subjectKey.rawBlob),
+                signatureAlgorithm: (try? readFirstSSHString(from: signatureBlob).text) ?? "ecdsa-sha2-nistp256",
+                associatedKeyId: entry.subject.associatedKeyID,
+                rawCertificateData: certificateBlob,
+                authorizedRepresentation: "\(entry.certificateKeyType) \(certificateBlob.base64EncodedString()) \(entry.keyID)",
+                importedFrom: "Signed by \(authority.label)",
+                createdAt: createdAt
+            )
+        }
+
+        var updatedCertificates = existingCertificates
+        updatedCertificates.append(contentsOf: issued)
+        updatedCertificates.sort { $0.createdAt > $1.createdAt }
+
+        authority.issuedCertificateCount += UInt64(issued.count)
+        authority.nextSerialNumber = max(authority.nextSerialNumber, nextSerial)
+        updatedAuthorities[authorityIndex] = authority
+        updatedAuthorities.sort { $0.createdAt > $1.createdAt }
+
+        do {
+            // Same order as single issuance: certificates first, so a failed
+            // authority save leaves a stale counter rather than lost certificates.
+            try await certificateStore.saveCertificates(updatedCertificates)
+            try await authorityStore.saveAuthorities(updatedAuthorities)
+        } catch {
+            throw CertificateAuthorityError.persistenceFailed(
+                message: "Failed to persist issued certificates: \(error.localizedDescription)"
+            )
+        }
+        let end = clock.now
+
+        return BatchCertificateIssuanceResult(
+            authorities: updatedAuthorities,
+            certificates: updatedCertificates,
+            issued: issued,
+            failures: failures,
+            encodingDuration: Self.seconds(signingStart - encodingStart),
+            signingDuration: Self.seconds(persistenceStart - signingStart),
+            persistenceDuration: Self.seconds(end - persistenceStart)
+        )
+    }
+
+    // MARK: - Export
+
+    /// Write `certificates` into a new directory under `parent`: one
+    /// `<key-id>-<serial>-cert.pub` per certificate plus `manifest.csv`.
+    /// With `asArchive`, the directory is zipped to `<name>.zip` and
+    /// removed. Returns the directory or archive URL.
+    func exportIssuedCertificates(
+        _ certificates: [SSHCertificate],
+        to parent: URL,
+        name: String,
+        asArchive: Bool,
+        fileManager: FileManager = .default
+    ) throws -> URL {
+        let directory = parent.appendingPathComponent(name, isDirectory: true)
+        do {
+            try fileManager.createDirectory(at: directory, withIntermediateDirectories: true)
+
+            var manifestLines = ["file,serial,key_id,type,principals,signed_key_fingerprint,valid_before"]
+            let iso8601 = ISO8601DateFormatter()
+            for certificate in certificates {
+                guard let line = authorizedRepresentation(for: certificate) else { continue }
+                let fileName = "\(sanitizeFileComponent(certificate.keyId))-\(certificate.serialNumber)-cert.pub"
+                try Data((line + "\n").utf8).write(to: directory.appendingPathComponent(fileName), options: .atomic)
+                manifestLines.append([
+                    csvSafe(fileName),
+                    String(certificate.serialNumber),
+                    csvSafe(certificate.keyId),
+                    csvSafe(certificate.type.rawValue),
+                    csvSafe(certificate.principals.joined(separator: ";")),
+                    csvSafe(certificate.signedKeyFingerprint),
+                    iso8601.string(from: certificate.validBefore)
+                ].joined(separator: ","))
+            }
+            try Data((manifestLines.joined(separator: "\n") + "\n").utf8)
+                .write(to: directory.appendingPathComponent("manifest.csv"), options: .atomic)
+
+            guard asArchive else { return directory }
+            let archive = parent.appendingPathComponent("\(name).zip")
+            try zipDirectory(directory, to: archive, fileManager: fileManager)
+            try fileManager.removeItem(at: directory)
+            return archive
+        } catch let error as CertificateAuthorityError {
+            throw error
+        } catch {
+            throw CertificateAuthorityError.persistenceFailed(
+                message: "Failed to export issued certificates: \(error.localizedDescription)"
+            )
+        }
+    }
+
+    /// Zip through file coordination, which archives a directory read
+    /// "for uploading" into a temporary file.
+    private func zipDirectory(_ directory: URL, to archive: URL, fileManager: FileManager) throws {
+        var coordinationError: NSError?
+        var copyError: Error?
+        NSFileCoordinator().coordinate(
+            readingItemAt: directory,
+            options: .forUploading,
+            error: &coordinationError
+        ) { zippedURL in
+            do {
+                if fileManager.fileExists(atPath: archive.path(percentEncoded: false)) {
+                    try fileManager.removeItem(at: archive)
+                }
+                try fileManager.copyItem(at: zippedURL, to: archive)
+            } catch {
+                copyError = error
+            }
+        }
+        if let error = coordinationError ?? copyError {
+            throw error
+        }
+    }
+
+    private static func seconds(_ duration: Duration) -> TimeInterval {
+        let components = duration.components
+        return TimeInterval(components.seconds) + TimeInterval(components.attoseconds) / 1e18
+    }
+}
@@ -91,6 +91,24 @@ extension CertificateAuthorityService {
         )
     }
 
+    /// The CA key blob a certificate was signed with.
+    func signatureKeyBlob(ofCertificate certificateBlob: Data) throws -> Data {
+        var reader = SSHBinaryReader(data: certificateBlob)
+        let certificateKeyType = try reader.readStringText(context: "certificate key type")
+        _ = try reader.readStringData(context: "nonce")
+        try skipCertificateSubjectKeyData(certificateKeyType: certificateKeyType, reader: &reader)
+        _ = try reader.readUInt64(context: "serial number")
+        _ = try reader.readUInt32(context: "certificate type")
+        _ = try reader.readStringData(context: "key ID")
+        _ = try reader.readStringData(context: "valid principals")
+        _ = try reader.readUInt64(context: "valid after")
+        _ = try reader.readUInt64(context: "valid before")
+        _ = try reader.readStringData(context: "critical options")
+        _ = try reader.readStringData(context: "extensions")
+        _ = try reader.readStringData(context: "reserved")
+        return try reader.readStringData(context: "signature key")
+    }
+
     func parseAuthorizedPublicKey(_ authorized: String) throws -> ParsedPublicKey {
         let tokens = authorized
             .trimmingCharacters(in: .whitespacesAndNewlines)
@@ -7,6 +7,18 @@ extension CertificateAuthorityService {
         request: KRLGenerationRequest,
         authorities: [CertificateAuthorityModel],
         certificates: [SSHCertificate]
+    ) throws -> GeneratedKRLBundle {
+        try generateKRL(
+            request: request,
+            authorities: authorities,
+            index: CertificateRevocationIndex(certificates: certificates)
+        )
+    }
+
+    func generateKRL(
+        request: KRLGenerationRequest,
+        authorities: [CertificateAuthorityModel],
+        index: CertificateRevocationIndex
     ) throws -> GeneratedKRLBundle {
         let now = Date()
         let iso8601 = ISO8601DateFormatter()
@@ -20,37 +32,50 @@ extension CertificateAuthorityService {
         } else {
             selectedAuthority = nil
         }
+        let scopeFingerprint = selectedAuthority?.publicKeyFingerprint
 
-        let filteredCertificates: [SSHCertificate]
-        if let selectedAuthority {
-            filteredCertificates = certificates.filter {
-                $0.signingCAFingerprint == selectedAuthority.publicKeyFingerprint
+        var revokedByID: [UUID: SSHCertificate] = [:]
+        var revokedKeyIDsByCA: [String: Set<String>] = [:]
+
+        for serial in Set(request.revokedSerials).sorted() {
+            let matches = index.certificates(serial: serial, caFingerprint: scopeFingerprint)
+            if matches.isEmpty {
+                throw CertificateAuthorityError.signingFailed(
+                    message: "No certificate found for serial \(serial) in the selected scope."
+                )
+            }
+            for certificate in matches {
+                revokedByID[certificate.id] = certificate
             }
-        } else {
-            filteredCertificates = certificates
         }
 
-        var revoked: [SSHCertificate] = []
-        let requestedSerials = Set(request.revokedSerials)
-
-        for serial in requestedSerials.sorted() {
-            let matches = filteredCertificates.filter { $0.serialNumber == serial }
+        let requestedKeyIDs = Set(
+            request.revokedKeyIDs
+                .map { $0.trimmingCharacters(in: .whitespacesAndNewlines) }
+                .filter { !$0.isEmpty }
+        )
+        for keyID in requestedKeyIDs.sorted() {
+            let matches = index.certificates(keyID: keyID, caFingerprint: scopeFingerprint)
             if matches.isEmpty {
                 throw CertificateAuthorityError.signingFailed(
-                    message: "No certificate found for serial \(serial) in the selected scope."
+                    message: "No certificate found for key ID '\(keyID)' in the selected scope."
                 )
             }
-            revoked.append(contentsOf: matches)
+            for certificate in matches {
+                revokedByID[certificate.id] = certificate
+                revokedKeyIDsByCA[certificate.signingCAFingerprint, default: []].insert(keyID)
+            }
         }
 
         if request.includeExpiredCertificates {
-            revoked.append(contentsOf: filteredCertificates.filter { $0.validBefore <= now })
+            for certificate in index.certificates where certificate.validBefore <= now {
+                if let scopeFingerprint, certificate.signingCAFingerprint != scopeFingerprint {
+                    continue
+                }
+                revokedByID[certificate.id] = certificate
+            }
         }
 
-        var revokedByID: [UUID: SSHCertificate] = [:]
-        for certificate in revoked {
-            revokedByID[certificate.id] = certificate
-        }
         let finalRevoked = revokedByID.values.sorted { lhs, rhs in
             if lhs.serialNumber == rhs.serialNumber {
                 return lhs.createdAt > rhs.createdAt
@@ -71,24 +96,49 @@ extension CertificateAuthorityService {
             )
         }
 
+        let scopeLabel = selectedAuthority?.label ?? "All CAs"
+        let binary = try buildBinaryKRL(
+            revoked: finalRevoked,
+            revokedKeyIDsByCA: revokedKeyIDsByCA,
+            authorities: authorities,
+            base: request.baseKRL,
+            generatedAt: now,
+            scopeLabel: scopeLabel
+        )
+
         let timestamp = iso8601.string(from: now)
             .replacingOccurrences(of: "-", with: "")
             .replacingOccurrences(of: ":", with: "")
         let authorityComponent = sanitizeFileComponent(selectedAuthority?.label ?? "all-ca")
         let fileStem = "prossh-krl-\(authorityComponent)-\(timestamp)"
         let keyFileName = "\(fileStem)-revoked_keys.pub"
-        let command = "ssh-keygen -k -f \(fileStem).krl \(keyFileName)"
+        let command = request.baseKRL == nil
+            ? "ssh-keygen -k -f \(fileStem).krl \(keyFileName)"
+            : "ssh-keygen -k -u -f \(fileStem).krl \(keyFileName)"
 
         let revokedKeysContent = revokedLines.joined(separator: "\n") + "\n"
 
         var manifestLines: [String] = [
             "# ProSSH v2 KRL manifest",
             "# Generated: \(iso8601.string(from: now))",
-            "# Scope: \(selectedAuthority?.label ?? "All CAs")",
+            "# Scope: \(scopeLabel)",
             "# Revoked certificates: \(finalRevoked.count)",
+            "# KRL version: \(binary.krl.version)"
+        ]
+        if request.baseKRL != nil {
+            manifestLines.append(
+                "# Appended to existing KRL: \(binary.appendedCount) certificate(s) not already revoked"
+            )
+        }
+        if binary.unrepresentableCount > 0 {
+            manifestLines.append(
+                "# \(binary.unrepresentableCount) certificate(s) with serial 0 and no key ID are only in the revoked keys file"
+            )
+        }
+        manifestLines += [
             "#",
-            "# 1) Save revoked keys as: \(keyFileName)",
-            "# 2) Run: \(command)",
+            "# 1) Save the binary KRL as \(fileStem).krl, or save revoked keys as: \(keyFileName)",
+            "# 2) Or run: \(command)",
             "# 3) Distribute \(fileStem).krl to SSH servers/clients",
             "",
             "serial,key_id,type,ca_fingerprint,signed_key_fingerprint,valid_after,valid_before"
@@ -114,7 +164,104 @@ extension CertificateAuthorityService {
             revokedCertificateCount: finalRevoked.count,
             revokedKeysContent: revokedKeysContent,
             manifestContent: manifestLines.joined(separator: "\n") + "\n",
-            openSSHCommand: command
+            openSSHCommand: command,
+            krlData: binary.krl.serialized(),
+            krlVersion: binary.krl.version,
+            appendedCertificateCount: binary.appendedCount,
+            isIncremental: request.baseKRL != nil
+        )
+    }
+
+    /// Certificate sections for `revoked`, one per CA, written to a new KRL
+    /// or appended to `base`. Certificates `base` already revokes, by
+    /// serial or key ID under their CA or the wildcard CA, are left out.
+    private func buildBinaryKRL(
+        revoked: [SSHCertificate],
+        revokedKeyIDsByCA: [String: Set<String>],
+        authorities: [CertificateAuthorityModel],
+        base: Data?,
+        generatedAt: Date,
+        scopeLabel: String
+    ) throws -> (krl: OpenSSHKRL, appendedCount: Int, unrepresentableCount: Int) {
+        let generatedDate = UInt64(max(0, generatedAt.timeIntervalSince1970))
+        var krl: OpenSSHKRL
+        var existing: [Data: OpenSSHKRL.RevokedCertificates] = [:]
+        if let base {
+            krl = try OpenSSHKRL(parsing: base)
+            existing = try krl.revokedCertificates()
+            krl.version += 1
+            krl.generatedDate = generatedDate
+        } else {
+            krl = OpenSSHKRL(version: 1, generatedDate: generatedDate, comment: "ProSSH v2 KRL (\(scopeLabel))")
+        }
+
+        var sections: [OpenSSHKRL.Section] = []
+        var appendedCount = 0
+        var unrepresentableCount = 0
+        let revokedByCA = Dictionary(grouping: revoked, by: \.signingCAFingerprint)
+
+        for fingerprint in revokedByCA.keys.sorted() {
+            let group = revokedByCA[fingerprint] ?? []
+            let caKey = try signingKeyBlob(fingerprint: fingerprint, certificates: group, authorities: authorities)
+            let prior = [existing[caKey], existing[Data()]].compactMap { $0 }
+            let newKeyIDs = revokedKeyIDsByCA[fingerprint] ?? []
+
+            func isAlreadyRevoked(_ certificate: SSHCertificate) -> Bool {
+                prior.contains { entry in
+                    entry.keyIDs.contains(certificate.keyId)
+                        || (certificate.serialNumber != 0 && entry.containsSerial(certificate.serialNumber))
+                }
+            }
+
+            var serials: [UInt64] = []
+            var keyIDs = newKeyIDs.filter { keyID in !prior.contains { $0.keyIDs.contains(keyID) } }
+            for certificate in group where !isAlreadyRevoked(certificate) {
+                if newKeyIDs.contains(certificate.keyId) {
+                    appendedCount += 1
+                } else if certificate.serialNumber != 0 {
+                    serials.append(certificate.serialNumber)
+                    appendedCount += 1
+                } else if !certificate.keyId.isEmpty {
+                    // Serial 0 cannot be revoked by serial; fall back to its key ID.
+                    keyIDs.insert(certificate.keyId)
+                    appendedCount += 1
+                } else {
+                    unrepresentableCount += 1
+                }
+            }
+
+            guard !serials.isEmpty || !keyIDs.isEmpty else { continue }
+            sections.append(OpenSSHKRL.certificateSection(caKey: caKey, serials: serials, keyIDs: Array(keyIDs)))
+        }
+
+        if base != nil, sections.isEmpty {
+            throw CertificateAuthorityError.signingFailed(
+                message: "Every matched certificate is already revoked by the existing KRL."
+            )
+        }
+        krl.appendCertificateSections(sections)
+        return (krl, appendedCount, unrepresentableCount)
+    }
+
+    /// The CA public key blob for certificates signed by `fingerprint`,
+    /// read from a certificate's signature key or the matching authority.
+    private func signingKeyBlob(
+        fingerprint: String,
+        certificates: [SSHCertificate],
+        authorities: [CertificateAuthorityModel]
+    ) throws -> Data {
+        for certificate in certificates {
+            if let blob = try? signatureKeyBlob(ofCertificate: certificate.rawCertificateData),
+               fingerprintSHA256(for: blob) == fingerprint {
+                return blob
+            }
+        }
+        if let authorized = authorities.first(where: { $0.publicKeyFingerprint == fingerprint })?.publicKeyAuthorizedFormat,
+           let parsed = try? parseAuthorizedPublicKey(authorized) {
+            return parsed.rawBlob
+        }
+        throw CertificateAuthorityError.signingFailed(
+            message: "Unable to read the CA public key for \(fingerprint) to build the binary KRL."
         )
     }
 
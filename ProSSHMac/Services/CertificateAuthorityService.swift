@@ -39,7 +39,10 @@ struct HostCertificateSigningRequest {
 struct KRLGenerationRequest {
     var authorityID: UUID?
     var revokedSerials: [UInt64]
+    var revokedKeyIDs: [String] = []
     var includeExpiredCertificates: Bool
+    /// Existing binary KRL to append to; nil writes a new one.
+    var baseKRL: Data?
 }
 
 struct GeneratedKRLBundle {
@@ -50,6 +53,13 @@ struct GeneratedKRLBundle {
     var revokedKeysContent: String
     var manifestContent: String
     var openSSHCommand: String
+    /// OpenSSH binary KRL, ready for `RevokedKeys` / `RevokedHostKeys`.
+    var krlData: Data
+    var krlVersion: UInt64
+    /// Certificates written to new KRL sections; in incremental mode,
+    /// those not already revoked by the base KRL.
+    var appendedCertificateCount: Int
+    var isIncremental: Bool
 }
 
 enum CertificateAuthorityError: LocalizedError {
@@ -71,9 +81,9 @@ enum CertificateAuthorityError: LocalizedError {
 
 @MainActor
 final class CertificateAuthorityService {
-    private let authorityStore: any CertificateAuthorityStoreProtocol
-    private let certificateStore: any CertificateStoreProtocol
-    private let secureEnclaveKeyManager: SecureEnclaveKeyManager
+    let authorityStore: any CertificateAuthorityStoreProtocol
+    let certificateStore: any CertificateStoreProtocol
+    let secureEnclaveKeyManager: SecureEnclaveKeyManager
 
     init(
         authorityStore: any CertificateAuthorityStoreProtocol,
@@ -300,25 +310,19 @@ final class CertificateAuthorityService {
         let certKeyType = try certificateKeyType(for: subjectKey.keyType)
         let caPublicKey = try parseAuthorizedPublicKey(authorityPublic)
 
-        let nonce = try randomBytes(count: 32)
-        let principalsBlob = encodeStringList(principals)
-        let criticalOptionsBlob = encodeNameValueMap(criticalOptions)
-        let extensionsBlob = encodeNameValueMap(extensions)
-
-        var toBeSigned = Data()
-        toBeSigned.append(sshString(from: certKeyType))
-        toBeSigned.append(sshString(from: nonce))
-        toBeSigned.append(subjectKey.keySpecificData)
-        toBeSigned.append(u64(serialNumber))
-        toBeSigned.append(u32(role.sshCertificateType))
-        toBeSigned.append(sshString(from: normalizedKeyID))
-        toBeSigned.append(sshString(from: principalsBlob))
-        toBeSigned.append(u64(UInt64(validAfter.timeIntervalSince1970)))
-        toBeSigned.append(u64(UInt64(validBefore.timeIntervalSince1970)))
-        toBeSigned.append(sshString(from: criticalOptionsBlob))
-        toBeSigned.append(sshString(from: extensionsBlob))
-        toBeSigned.append(sshString(from: Data())) // reserved
-        toBeSigned.append(sshString(from: caPublicKey.rawBlob))
+        let toBeSigned = try certificatePayload(
+            certificateKeyType: certKeyType,
+            subjectKey: subjectKey,
+            serialNumber: serialNumber,
+            role: role,
+            keyID: normalizedKeyID,
+            principals: principals,
+            validAfter: validAfter,
+            validBefore: validBefore,
+            criticalOptions: criticalOptions,
+            extensions: extensions,
+            caPublicKeyBlob: caPublicKey.rawBlob
+        )
 
         let signatureBlob: Data
         do {
@@ -393,6 +397,42 @@ final class CertificateAuthorityService {
         return (updatedAuthorities, updatedCertificates)
     }
 
+    /// The to-be-signed certificate body: everything but the signature.
+    func certificatePayload(
+        certificateKeyType: String,
+        subjectKey: ParsedPublicKey,
+        serialNumber: UInt64,
+        role: CertificateRole,
+        keyID: String,
+        principals: [String],
+        validAfter: Date,
+        validBefore: Date,
+        criticalOptions: [String: String],
+        extensions: [String: String],
+        caPublicKeyBlob: Data
+    ) throws -> Data {
+        let nonce = try randomBytes(count: 32)
+        let principalsBlob = encodeStringList(principals)
+        let criticalOptionsBlob = encodeNameValueMap(criticalOptions)
+        let extensionsBlob = encodeNameValueMap(extensions)
+
+        var toBeSigned = Data()
+        toBeSigned.append(sshString(from: certificateKeyType))
+        toBeSigned.append(sshString(from: nonce))
+        toBeSigned.append(subjectKey.keySpecificData)
+        toBeSigned.append(u64(serialNumber))
+        toBeSigned.append(u32(role.sshCertificateType))
+        toBeSigned.append(sshString(from: keyID))
+        toBeSigned.append(sshString(from: principalsBlob))
+        toBeSigned.append(u64(UInt64(validAfter.timeIntervalSince1970)))
+        toBeSigned.append(u64(UInt64(validBefore.timeIntervalSince1970)))
+        toBeSigned.append(sshString(from: criticalOptionsBlob))
+        toBeSigned.append(sshString(from: extensionsBlob))
+        toBeSigned.append(sshString(from: Data())) // reserved
+        toBeSigned.append(sshString(from: caPublicKeyBlob))
+        return toBeSigned
+    }
+
     func deleteAuthorities(
         ids: [UUID],
         existingAuthorities: [CertificateAuthorityModel]
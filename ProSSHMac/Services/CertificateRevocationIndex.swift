@@ -0,0 +1,47 @@
+// CertificateRevocationIndex.swift
+// ProSSHV2
+//
+// Serial and key ID lookups over the certificate store for KRL generation.
+// Revoking thousands of serials against a CA with hundreds of thousands of
+// issued certificates used to scan the whole store once per serial; the
+// index answers each lookup from the handful of certificates sharing it.
+
+import Foundation
+
+struct CertificateRevocationIndex {
+
+    let certificates: [SSHCertificate]
+    private var indicesBySerial: [UInt64: [Int]] = [:]
+    private var indicesByKeyID: [String: [Int]] = [:]
+
+    init(certificates: [SSHCertificate]) {
+        self.certificates = certificates
+        for (index, certificate) in certificates.enumerated() {
+            indicesBySerial[certificate.serialNumber, default: []].append(index)
+            indicesByKeyID[certificate.keyId, default: []].append(index)
+        }
+    }
+
+    /// Certificates with `serial`, limited to one CA when `caFingerprint`
+    /// is set.
+    func certificates(serial: UInt64, caFingerprint: String?) -> [SSHCertificate] {
+        matches(indicesBySerial[serial], caFingerprint: caFingerprint)
+    }
+
+    /// Certificates with `keyID`, limited to one CA when `caFingerprint`
+    /// is set.
+    func certificates(keyID: String, caFingerprint: String?) -> [SSHCertificate] {
+        matches(indicesByKeyID[keyID], caFingerprint: caFingerprint)
+    }
+
+    private func matches(_ indices: [Int]?, caFingerprint: String?) -> [SSHCertificate] {
+        guard let indices else { return [] }
+        return indices.compactMap { index in
+            let certificate = certificates[index]
+            if let caFingerprint, certificate.signingCAFingerprint != caFingerprint {
+                return nil
+            }
+            return certificate
+        }
+    }
+}
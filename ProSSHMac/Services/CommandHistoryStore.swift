@@ -0,0 +1,368 @@
+// CommandHistoryStore.swift
+// ProSSHV2
+//
+// Persistent command history across sessions and hosts. TerminalHistoryIndex
+// only keeps the blocks of open sessions in memory. This store keeps every
+// completed CommandBlock in an append-only, encrypted log on disk.
+//
+// Layout, in Application Support/ProSSHV2/CommandHistory:
+//   history.log         magic "PSSHHIS1", 32-byte key salt, then records:
+//                       UInt32 length (little-endian) + AES-GCM sealed JSON
+//                       of the entry and its output
+//   history.checkpoint  AES-GCM sealed JSON of every entry's metadata and
+//                       log extent, and the log length it covers
+//
+// Appending seals one record and writes it at the end of the log, so the
+// cost does not grow with the history. Every `checkpointInterval` appends
+// the in-memory index is written to the checkpoint. On launch the
+// checkpoint is loaded and only the log records after it are replayed.
+// A torn record at the end of the log (from a crash mid-write) is cut off.
+//
+// Only metadata and command text are held in memory. Outputs stay on disk
+// until `output(of:)` reads one back. Queries by host, time range, exit
+// code and command text use in-memory postings: host lists, binary search
+// over completion time, and CommandHistorySearchIndex trigrams.
+//
+// The key is derived from the EncryptedStorage master key with the salt
+// stored in the log header.
+
+import CryptoKit
+import Foundation
+import os.log
+
+// MARK: - CommandHistoryEntry
+
+/// A persisted command block, without its output.
+nonisolated struct CommandHistoryEntry: Identifiable, Codable, Hashable, Sendable {
+    let id: UUID
+    let sessionID: UUID
+    /// `user@host:port`, or "local" for local shells.
+    let host: String
+    let command: String
+    let startedAt: Date
+    let completedAt: Date
+    let exitCode: Int?
+}
+
+// MARK: - CommandHistoryQuery
+
+nonisolated struct CommandHistoryQuery: Sendable {
+    /// Case-insensitive substring of the command.
+    var text: String?
+    var host: String?
+    /// Completion time range, inclusive.
+    var since: Date?
+    var until: Date?
+    var exitCode: Int?
+    /// Only commands that exited non-zero.
+    var failedOnly = false
+    var limit = 50
+}
+
+// MARK: - CommandHistoryStore
+
+actor CommandHistoryStore {
+
+    /// Appends between checkpoints.
+    static let checkpointInterval = 256
+
+    private static let magic = Data("PSSHHIS1".utf8)
+    private static let saltSize = 32
+    private static var headerSize: Int { magic.count + saltSize }
+    private static let logger = Logger(subsystem: "com.prossh", category: "CommandHistory")
+
+    private nonisolated struct Record: Codable {
+        let entry: CommandHistoryEntry
+        let offset: Int
+        let length: Int
+    }
+
+    private nonisolated struct LoggedBlock: Codable {
+        let entry: CommandHistoryEntry
+        let output: String
+    }
+
+    private nonisolated struct Checkpoint: Codable {
+        let logLength: Int
+        let records: [Record]
+    }
+
+    private let logURL: URL
+    private let checkpointURL: URL
+    private let makeKey: @Sendable (Data) throws -> SymmetricKey
+
+    private var key: SymmetricKey?
+    private var handle: FileHandle?
+    private var logLength = 0
+    private var isLoaded = false
+
+    private var records: [Record] = []
+    private var positionsByID: [UUID: Int] = [:]
+    private var positionsByHost: [String: [Int]] = [:]
+    private var textIndex = CommandHistorySearchIndex()
+    /// Whether `records` are in completion order, so time ranges can use
+    /// binary search. Cleared if the clock steps backwards.
+    private var isChronological = true
+    private var appendsSinceCheckpoint = 0
+
+    /// A store in `directory`. `makeKey` derives the encryption key from
+    /// the salt in the log header.
+    init(directory: URL, makeKey: @escaping @Sendable (Data) throws -> SymmetricKey) {
+        logURL = directory.appendingPathComponent("history.log")
+        checkpointURL = directory.appendingPathComponent("history.checkpoint")
+        self.makeKey = makeKey
+    }
+
+    /// The app's store, keyed from the EncryptedStorage master key.
+    static func makeDefault(fileManager: FileManager = .default) -> CommandHistoryStore {
+        let directory = (fileManager.urls(for: .applicationSupportDirectory, in: .userDomainMask).first
+            ?? fileManager.temporaryDirectory)
+            .appendingPathComponent("ProSSHV2", isDirectory: true)
+            .appendingPathComponent("CommandHistory", isDirectory: true)
+        return CommandHistoryStore(directory: directory) { salt in
+            try EncryptedStorage.derivedKey(purpose: "command-history-v1", salt: salt)
+        }
+    }
+
+    /// Number of stored commands.
+    var count: Int {
+        loadIfNeeded()
+        return records.count
+    }
+
+    // MARK: - Ingest
+
+    /// Persist `block`, run on `host`.
+    func append(_ block: CommandBlock, host: String) {
+        loadIfNeeded()
+        guard let key, let handle, positionsByID[block.id] == nil else { return }
+
+        let entry = CommandHistoryEntry(
+            id: block.id,
+            sessionID: block.sessionID,
+            host: host,
+            command: block.command,
+            startedAt: block.startedAt,
+            completedAt: block.completedAt,
+            exitCode: block.exitCode
+        )
+        do {
+            let plaintext = try JSONEncoder().encode(LoggedBlock(entry: entry, output: block.output))
+            guard let sealed = try AES.GCM.seal(plaintext, using: key).combined else { return }
+            var frame = Data()
+            Self.appendLength(UInt32(sealed.count), to: &frame)
+            frame.append(sealed)
+            try handle.seek(toOffset: UInt64(logLength))
+            try handle.write(contentsOf: frame)
+            index(Record(entry: entry, offset: logLength + 4, length: sealed.count))
+            logLength += frame.count
+        } catch {
+            Self.logger.error("Command history append failed: \(error.localizedDescription, privacy: .public)")
+            return
+        }
+
+        appendsSinceCheckpoint += 1
+        if appendsSinceCheckpoint >= Self.checkpointInterval {
+            checkpoint()
+        }
+    }
+
+    /// Write the checkpoint now, e.g. before the app terminates.
+    func checkpoint() {
+        guard isLoaded, let key else { return }
+        let traceStart = TraceRecorder.shared.begin()
+        defer { TraceRecorder.shared.end(.storeWrite, since: traceStart) }
+        do {
+            try handle?.synchronize()
+            let plaintext = try JSONEncoder().encode(Checkpoint(logLength: logLength, records: records))
+            guard let sealed = try AES.GCM.seal(plaintext, using: key).combined else { return }
+            try sealed.write(to: checkpointURL, options: .atomic)
+            appendsSinceCheckpoint = 0
+        } catch {
+            Self.logger.error("Command history checkpoint failed: \(error.localizedDescription, privacy: .public)")
+        }
+    }
+
+    // MARK: - Queries
+
+    /// Entries matching `query`, newest first.
+    func entries(matching query: CommandHistoryQuery) -> [CommandHistoryEntry] {
+        loadIfNeeded()
+        let text = query.text?.trimmingCharacters(in: .whitespacesAndNewlines).lowercased() ?? ""
+
+        var candidates: [Int]?
+        if !text.isEmpty {
+            candidates = textIndex.candidates(forLowercased: text)
+        }
+        if let host = query.host {
+            let hostPositions = positionsByHost[host] ?? []
+            if hostPositions.count < candidates?.count ?? .max {
+                candidates = hostPositions
+            }
+        }
+        let positions = candidates.map { $0[...] } ?? timeRange(since: query.since, until: query.until)
+
+        var results: [CommandHistoryEntry] = []
+        let limit = max(1, query.limit)
+        for position in positions.reversed() {
+            let entry = records[position].entry
+            if let host = query.host, entry.host != host { continue }
+            if let since = query.since, entry.completedAt < since { continue }
+            if let until = query.until, entry.completedAt > until { continue }
+            if let exitCode = query.exitCode, entry.exitCode != exitCode { continue }
+            if query.failedOnly, entry.exitCode == nil || entry.exitCode == 0 { continue }
+            if !text.isEmpty, !entry.command.lowercased().contains(text) { continue }
+            results.append(entry)
+            if results.count == limit { break }
+        }
+        return results
+    }
+
+    /// Hosts with stored commands, most recently used first.
+    func hosts() -> [String] {
+        loadIfNeeded()
+        return positionsByHost
+            .sorted { ($0.value.last ?? 0) > ($1.value.last ?? 0) }
+            .map(\.key)
+    }
+
+    /// The output recorded for entry `id`, read back from the log.
+    func output(of id: UUID) -> String? {
+        loadIfNeeded()
+        guard let position = positionsByID[id], let key, let handle else { return nil }
+        let record = records[position]
+        guard let block = try? Self.readBlock(at: record.offset, length: record.length, from: handle, key: key),
+              block.entry.id == id else { return nil }
+        return block.output
+    }
+
+    /// Positions with completion time within the range, when it can be
+    /// found by binary search; every position otherwise.
+    private func timeRange(since: Date?, until: Date?) -> ArraySlice<Int> {
+        let all = Array(records.indices)
+        guard isChronological, since != nil || until != nil else { return all[...] }
+        let lower = since.map { date in partition { records[$0].entry.completedAt >= date } } ?? 0
+        let upper = until.map { date in partition { records[$0].entry.completedAt > date } } ?? records.count
+        return all[lower..<max(lower, upper)]
+    }
+
+    /// First position where `predicate` holds; it must be monotonic.
+    private func partition(_ predicate: (Int) -> Bool) -> Int {
+        var low = 0
+        var high = records.count
+        while low < high {
+            let mid = (low + high) / 2
+            if predicate(mid) {
+                high = mid
+            } else {
+                low = mid + 1
+            }
+        }
+        return low
+    }
+
+    // MARK: - Loading
+
+    private func index(_ record: Record) {
+        let position = records.count
+        if let last = records.last, record.entry.completedAt < last.entry.completedAt {
+            isChronological = false
+        }
+        records.append(record)
+        positionsByID[record.entry.id] = position
+        positionsByHost[record.entry.host, default: []].append(position)
+        textIndex.append(texts: [record.entry.command])
+    }
+
+    private func loadIfNeeded() {
+        guard !isLoaded else { return }
+        isLoaded = true
+        do {
+            try load()
+        } catch {
+            Self.logger.error("Command history unavailable: \(error.localizedDescription, privacy: .public)")
+            try? handle?.close()
+            handle = nil
+            key = nil
+        }
+    }
+
+    private func load() throws {
+        let fileManager = FileManager.default
+        try fileManager.createDirectory(at: logURL.deletingLastPathComponent(), withIntermediateDirectories: true)
+        let path = logURL.path(percentEncoded: false)
+        if !fileManager.fileExists(atPath: path) {
+            var header = Self.magic
+            header.append(SymmetricKey(size: .bits256).withUnsafeBytes { Data($0) })
+            guard fileManager.createFile(
+                atPath: path,
+                contents: header,
+                attributes: [.posixPermissions: 0o600, .protectionKey: FileProtectionType.complete]
+            ) else {
+                throw CocoaError(.fileWriteUnknown)
+            }
+            try? fileManager.removeItem(at: checkpointURL)
+        }
+
+        let handle = try FileHandle(forUpdating: logURL)
+        self.handle = handle
+        let header = try handle.read(upToCount: Self.headerSize) ?? Data()
+        guard header.count == Self.headerSize, header.prefix(Self.magic.count) == Self.magic else {
+            throw CocoaError(.fileReadCorruptFile)
+        }
+        let key = try makeKey(Data(header.suffix(Self.saltSize)))
+        self.key = key
+        let fileLength = Int(try handle.seekToEnd())
+
+        var offset = Self.headerSize
+        if let sealed = try? Data(contentsOf: checkpointURL),
+           let box = try? AES.GCM.SealedBox(combined: sealed),
+           let plaintext = try? AES.GCM.open(box, using: key),
+           let checkpoint = try? JSONDecoder().decode(Checkpoint.self, from: plaintext),
+           checkpoint.logLength <= fileLength {
+            for record in checkpoint.records {
+                index(record)
+            }
+            offset = max(checkpoint.logLength, offset)
+        }
+
+        // Replay records written after the checkpoint.
+        while offset + 4 <= fileLength {
+            try handle.seek(toOffset: UInt64(offset))
+            guard let lengthBytes = try handle.read(upToCount: 4), lengthBytes.count == 4 else { break }
+            let length = Int(Self.readLength(lengthBytes))
+            guard offset + 4 + length <= fileLength,
+                  let block = try? Self.readBlock(at: offset + 4, length: length, from: handle, key: key) else {
+                break
+            }
+            if positionsByID[block.entry.id] == nil {
+                index(Record(entry: block.entry, offset: offset + 4, length: length))
+            }
+            offset += 4 + length
+        }
+        if offset < fileLength {
+            Self.logger.error("Command history log had a torn tail; truncating")
+            try handle.truncate(atOffset: UInt64(offset))
+        }
+        logLength = offset
+    }
+
+    // MARK: - Records
+
+    private static func readBlock(at offset: Int, length: Int, from handle: FileHandle, key: SymmetricKey) throws -> LoggedBlock {
+        try handle.seek(toOffset: UInt64(offset))
+        guard let sealed = try handle.read(upToCount: length), sealed.count == length else {
+            throw CocoaError(.fileReadCorruptFile)
+        }
+        let plaintext = try AES.GCM.open(try AES.GCM.SealedBox(combined: sealed), using: key)
+        return try JSONDecoder().decode(LoggedBlock.self, from: plaintext)
+    }
+
+    private static func appendLength(_ value: UInt32, to data: inout Data) {
+        withUnsafeBytes(of: value.littleEndian) { data.append(contentsOf: $0) }
+    }
+
+    private static func readLength(_ data: Data) -> UInt32 {
+        data.withUnsafeBytes { UInt32(littleEndian: $0.loadUnaligned(as: UInt32.self)) }
+    }
+}
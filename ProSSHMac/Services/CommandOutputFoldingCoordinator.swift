@@ -0,0 +1,109 @@
+// CommandOutputFoldingCoordinator.swift
+// ProSSHV2
+//
+// Folds long command output out of scrollback (see
+// TerminalGrid+CommandFolding). With folding on, a command that finishes
+// under shell integration with at least `autoFoldLineThreshold` lines in
+// history collapses to its summary row as soon as its block completes.
+// Folding and expanding by hand work either way. Folded output is still
+// found by `foldedMatchCount` and copied with the rest of the history.
+//
+// Toggle via: `defaults write com.prossh terminal.commandFolding.enabled -bool true`
+
+import Foundation
+
+@MainActor final class CommandOutputFoldingCoordinator {
+    weak var manager: SessionManager?
+
+    static let enabledDefaultsKey = "terminal.commandFolding.enabled"
+
+    static var isEnabled: Bool {
+        UserDefaults.standard.bool(forKey: enabledDefaultsKey)
+    }
+
+    /// Scrollback lines a finished command needs before it folds itself.
+    static let autoFoldLineThreshold = 2_000
+
+    init() {}
+
+    nonisolated deinit {}
+
+    /// Fold `block`'s output if it is long enough. Called when a block
+    /// completes at an OSC 133 boundary.
+    func commandCompleted(_ block: CommandBlock) async {
+        guard Self.isEnabled, block.boundarySource == .osc133,
+              let engine = manager?.engines[block.sessionID] else { return }
+        let folded = await engine.foldCommandOutput(
+            summary: Self.summary(of: block),
+            minimumLines: Self.autoFoldLineThreshold,
+            newestOnly: true
+        )
+        guard folded != nil else { return }
+        await manager?.renderingCoordinator.republishScrollback(sessionID: block.sessionID, engine: engine)
+    }
+
+    /// Fold the newest finished output, or expand it when it is already
+    /// folded. Returns false when there was nothing to do.
+    @discardableResult
+    func toggleLastOutput(sessionID: UUID) async -> Bool {
+        guard let manager, let engine = manager.engines[sessionID] else { return false }
+        let changed: Bool
+        if let foldID = await engine.lastCommandOutputFoldID {
+            changed = await engine.expandCommandOutput(foldID)
+        } else {
+            // The newest block is the output being folded when both came
+            // from the same OSC 133 marks.
+            let block = await manager.recentCommandBlocks(sessionID: sessionID, limit: 1).first
+            let summary = block.flatMap { $0.boundarySource == .osc133 ? Self.summary(of: $0) : nil }
+                ?? CommandOutputFold.Summary()
+            changed = await engine.foldCommandOutput(summary: summary, minimumLines: 2, newestOnly: false) != nil
+        }
+        if changed {
+            await manager.renderingCoordinator.republishScrollback(sessionID: sessionID, engine: engine)
+        }
+        return changed
+    }
+
+    /// Expand every folded output in the session. Returns how many were.
+    @discardableResult
+    func expandAll(sessionID: UUID) async -> Int {
+        guard let manager, let engine = manager.engines[sessionID] else { return 0 }
+        let expanded = await engine.expandAllCommandOutput()
+        if expanded > 0 {
+            await manager.renderingCoordinator.republishScrollback(sessionID: sessionID, engine: engine)
+        }
+        return expanded
+    }
+
+    // MARK: - Search
+
+    /// Matches for `query` in the session's folded output, which the
+    /// scrollback search no longer sees. Each fold is searched on its own
+    /// ScrollbackSearchEngine, off the main actor.
+    func foldedMatchCount(sessionID: UUID, query: ScrollbackSearchQuery) async -> Int {
+        guard let engine = manager?.engines[sessionID] else { return 0 }
+        let folds = await engine.visibleCommandOutputFolds()
+        guard !folds.isEmpty else { return 0 }
+        let (matchCounts, continuation) = AsyncStream.makeStream(of: Int.self)
+        for fold in folds where !Task.isCancelled {
+            // Regex errors are already reported by the screen search.
+            try? await ScrollbackSearchEngine().search(fold.lines, query: query) { update in
+                continuation.yield(update.matches.count)
+            }
+        }
+        continuation.finish()
+        var count = 0
+        for await matchCount in matchCounts {
+            count += matchCount
+        }
+        return count
+    }
+
+    private static func summary(of block: CommandBlock) -> CommandOutputFold.Summary {
+        CommandOutputFold.Summary(
+            command: block.command,
+            exitCode: block.exitCode,
+            duration: block.completedAt.timeIntervalSince(block.startedAt)
+        )
+    }
+}
@@ -0,0 +1,150 @@
+// ConnectionPrewarmCoordinator.swift
+// ProSSHV2
+//
+// Opens connections to hosts the user is likely to open next, so the
+// click finds DNS, TCP and key exchange done (`SSHTransporting.prewarm`).
+// The signals are a pointer resting on a host row, the most recently used
+// hosts when the host list appears, and the hosts of tabs a workspace
+// restore brought back dormant.
+//
+// A connection is authenticated ahead only for a public key or
+// certificate host whose key needs no passphrase prompt, and only when the
+// server presents the host key already trusted for it; anything else
+// stops after key exchange and authenticates on the click as before. The
+// adopted connection still goes through host key verification in
+// `SessionManager.connect`. A host behind a jump host is warmed only once
+// the jump host's key is trusted, since resolving it would otherwise
+// prompt.
+
+import Foundation
+import os.log
+
+@MainActor final class ConnectionPrewarmCoordinator {
+    weak var manager: SessionManager?
+    /// Looks up a saved host (jump hosts). Set by the app once the host
+    /// list exists.
+    var resolveHost: ((UUID) async -> Host?)?
+
+    /// How long the pointer rests on a row before its host is warmed.
+    static let hoverDwell: Duration = .milliseconds(250)
+    /// Warm-ups allowed in flight at once.
+    static let maximumConcurrent = 4
+    /// Recently used hosts warmed when the host list appears.
+    static let recentCount = 2
+    /// A host warmed this recently is not asked again; the transport keeps
+    /// its connection at least this long.
+    static let rewarmInterval: Duration = .seconds(45)
+
+    private static let logger = Logger(subsystem: "com.prossh", category: "ConnectionPrewarm")
+
+    private var hoverTask: Task<Void, Never>?
+    private var hoveredHostID: UUID?
+    private var inFlightHostIDs: Set<UUID> = []
+    private var lastWarmedAt: [UUID: ContinuousClock.Instant] = [:]
+
+    init() {}
+
+    nonisolated deinit {}
+
+    // MARK: - Signals
+
+    /// The pointer entered or left the row of `host`.
+    func hover(_ host: Host, isHovering: Bool) {
+        guard isHovering else {
+            // The next row's enter may arrive before this one's exit.
+            if hoveredHostID == host.id {
+                hoverTask?.cancel()
+                hoverTask = nil
+                hoveredHostID = nil
+            }
+            return
+        }
+        guard host.id != hoveredHostID else { return }
+        hoverTask?.cancel()
+        hoveredHostID = host.id
+        hoverTask = Task { [weak self] in
+            try? await Task.sleep(for: Self.hoverDwell)
+            guard !Task.isCancelled else { return }
+            self?.prewarm(host)
+        }
+    }
+
+    /// Warms the most recently connected of `hosts`.
+    func prewarmRecent(_ hosts: [Host]) {
+        for host in Self.recentCandidates(hosts, limit: Self.recentCount) {
+            prewarm(host)
+        }
+    }
+
+    /// Warms the hosts of tabs restored dormant, which connect when their
+    /// pane first appears.
+    func prewarmRestoredTabs() async {
+        guard let manager else { return }
+        var seen: Set<UUID> = []
+        for session in manager.sessions where manager.workspaceCoordinator.isDormant(session.id) {
+            guard case let .ssh(hostID) = session.kind, seen.insert(hostID).inserted,
+                  let host = await resolveHost?(hostID) else { continue }
+            prewarm(host)
+        }
+    }
+
+    // MARK: - Warm-up
+
+    func prewarm(_ host: Host) {
+        guard let manager, manager.connectionPrewarmEnabled,
+              manager.activeSession(for: host.id) == nil,
+              inFlightHostIDs.count < Self.maximumConcurrent,
+              !inFlightHostIDs.contains(host.id) else { return }
+        if let last = lastWarmedAt[host.id], ContinuousClock.now - last < Self.rewarmInterval {
+            return
+        }
+
+        inFlightHostIDs.insert(host.id)
+        Task { [weak self] in
+            let isReady = await self?.warm(host) ?? false
+            guard let self else { return }
+            self.inFlightHostIDs.remove(host.id)
+            if isReady {
+                self.lastWarmedAt[host.id] = .now
+            }
+        }
+    }
+
+    private func warm(_ host: Host) async -> Bool {
+        guard let manager else { return false }
+        var jumpHostConfig: JumpHostConfig?
+        if let jumpHostID = host.jumpHost {
+            guard let jumpHost = await resolveHost?(jumpHostID),
+                  let fingerprint = await manager.knownHostFingerprint(for: jumpHost) else { return false }
+            jumpHostConfig = JumpHostConfig(host: jumpHost, expectedFingerprint: fingerprint)
+        }
+        let trustedFingerprint = Self.authenticatesAhead(host)
+            ? await manager.knownHostFingerprint(for: host)
+            : nil
+
+        let isReady = await manager.transport.prewarm(
+            host: host,
+            jumpHostConfig: jumpHostConfig,
+            trustedFingerprint: trustedFingerprint
+        )
+        Self.logger.debug("Pre-warm \(host.label, privacy: .public): \(isReady ? "ready" : "not ready", privacy: .public)")
+        return isReady
+    }
+
+    // MARK: - Eligibility
+
+    /// Hosts whose key authenticates without a prompt. A saved passphrase
+    /// is behind Touch ID, which must not appear on hover.
+    nonisolated static func authenticatesAhead(_ host: Host) -> Bool {
+        host.authMethod.authenticatesWithKey && host.passphraseReference == nil
+    }
+
+    /// The `limit` most recently connected hosts, newest first.
+    nonisolated static func recentCandidates(_ hosts: [Host], limit: Int) -> [Host] {
+        hosts
+            .compactMap { host in host.lastConnected.map { (host, $0) } }
+            .sorted { $0.1 > $1.1 }
+            .prefix(limit)
+            .map(\.0)
+    }
+}
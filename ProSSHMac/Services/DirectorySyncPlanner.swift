@@ -0,0 +1,35 @@
+import Foundation
+
+/// Decisions shared by recursive upload and download in `TransferManager`.
+///
+/// The skip test is rsync's quick check: a destination file with the same size
+/// and modification time is assumed identical. SFTP v3 carries whole-second
+/// mtimes, so times are compared at that resolution. Completed tree transfers
+/// copy the source mtime onto the destination so the next sync can skip them.
+nonisolated enum DirectorySyncPlanner {
+
+    static func isUnchanged(
+        sourceSize: Int64,
+        sourceModified: Date?,
+        destinationSize: Int64?,
+        destinationModified: Date?
+    ) -> Bool {
+        guard let destinationSize, let sourceModified, let destinationModified else {
+            return false
+        }
+        return sourceSize == destinationSize
+            && Int64(sourceModified.timeIntervalSince1970) == Int64(destinationModified.timeIntervalSince1970)
+    }
+
+    /// `path` relative to the remote directory `root`, or nil if it is not
+    /// strictly inside it.
+    static func relativePath(of path: String, under root: String) -> String? {
+        let normalizedRoot = RemotePath.normalize(root)
+        let normalizedPath = RemotePath.normalize(path)
+        let prefix = normalizedRoot == "/" ? "/" : normalizedRoot + "/"
+        guard normalizedPath.hasPrefix(prefix), normalizedPath.count > prefix.count else {
+            return nil
+        }
+        return String(normalizedPath.dropFirst(prefix.count))
+    }
+}
@@ -0,0 +1,362 @@
+// EncryptedRecordFile.swift
+// ProSSHV2
+//
+// A list of encrypted records addressed by UUID, updated one record at a
+// time. PersistentStore keeps hosts, keys and certificates here, so an edit
+// to one item seals and writes only that item instead of re-encrypting the
+// whole array.
+//
+// Layout, next to the store's old JSON file (hosts.json -> hosts.*):
+//   <name>.index       magic "PSSHIDX1", 32-byte key salt, then an AES-GCM
+//                      sealed index: UInt64 generation, UInt64 records
+//                      length, UInt32 count, then per record (in list order)
+//                      16-byte UUID, UInt64 offset, UInt32 length and the
+//                      first 16 bytes of SHA-256 over the plaintext
+//   <name>.<gen>.records
+//                      magic "PSSHKVS1", then frames of UInt32 length
+//                      (little-endian) + AES-GCM sealed record
+//
+// A commit compares each record's digest with the index and appends only
+// the records that changed, then replaces the index atomically. Bytes past
+// the index's records length (from a crash before the index was written)
+// are cut off by the next commit. Superseded records stay in the file
+// until they outweigh the live ones; then the live frames are copied into
+// the next generation's file, the index is switched to it, and the old
+// file is deleted.
+//
+// Reads are lazy: the index is small, and a record is decrypted only when
+// it is read. The file is not thread-safe; PersistentStore confines each
+// one to its own serial queue so disk and crypto work stay off the main
+// actor.
+
+import CryptoKit
+import Foundation
+
+nonisolated final class EncryptedRecordFile: @unchecked Sendable {
+
+    nonisolated struct IndexEntry: Equatable {
+        let id: UUID
+        let offset: Int
+        let length: Int
+        let digest: Data
+    }
+
+    /// Superseded bytes tolerated before compacting, at least.
+    static let compactionThreshold = 64 << 10
+
+    private static let indexMagic = Data("PSSHIDX1".utf8)
+    private static let recordsMagic = Data("PSSHKVS1".utf8)
+    private static let saltSize = 32
+    private static let digestSize = 16
+
+    private let fileManager: FileManager
+    private let directory: URL
+    private let name: String
+    private let makeKey: @Sendable (Data) throws -> SymmetricKey
+
+    private var key: SymmetricKey?
+    private var salt = Data()
+    private var generation: UInt64 = 0
+    private var recordsLength = 0
+    private(set) var index: [IndexEntry] = []
+    private var positionsByID: [UUID: Int] = [:]
+
+    /// Whether an index was found on disk when the file was opened.
+    private(set) var exists = false
+
+    init(
+        directory: URL,
+        name: String,
+        fileManager: FileManager = .default,
+        makeKey: @escaping @Sendable (Data) throws -> SymmetricKey
+    ) {
+        self.directory = directory
+        self.name = name
+        self.fileManager = fileManager
+        self.makeKey = makeKey
+    }
+
+    private var indexURL: URL {
+        directory.appendingPathComponent("\(name).index")
+    }
+
+    private func recordsURL(generation: UInt64) -> URL {
+        directory.appendingPathComponent("\(name).\(generation).records")
+    }
+
+    // MARK: - Opening
+
+    /// Read the index. An index that cannot be decrypted (the master key
+    /// is gone) is moved aside and the file starts empty, as
+    /// EncryptedStorage does for whole-file stores.
+    func open() throws {
+        guard fileManager.fileExists(atPath: indexURL.path(percentEncoded: false)) else {
+            exists = false
+            return
+        }
+        let data = try Data(contentsOf: indexURL)
+        let headerSize = Self.indexMagic.count + Self.saltSize
+        guard data.count > headerSize, data.prefix(Self.indexMagic.count) == Self.indexMagic else {
+            throw EncryptedStorageError.malformedPayload
+        }
+        let salt = Data(data[Self.indexMagic.count..<headerSize])
+        let key = try makeKey(salt)
+        let body: Data
+        do {
+            body = try AES.GCM.open(try AES.GCM.SealedBox(combined: data.dropFirst(headerSize)), using: key)
+        } catch {
+            let backupURL = indexURL.appendingPathExtension("unreadable-\(Int(Date().timeIntervalSince1970))")
+            try? fileManager.moveItem(at: indexURL, to: backupURL)
+            exists = false
+            return
+        }
+
+        var reader = ByteReader(body)
+        let generation = try reader.uint64()
+        let recordsLength = Int(try reader.uint64())
+        let count = Int(try reader.uint32())
+        var index: [IndexEntry] = []
+        index.reserveCapacity(count)
+        for _ in 0..<count {
+            let id = try reader.uuid()
+            let offset = Int(try reader.uint64())
+            let length = Int(try reader.uint32())
+            let digest = try reader.bytes(Self.digestSize)
+            index.append(IndexEntry(id: id, offset: offset, length: length, digest: digest))
+        }
+
+        self.salt = salt
+        self.key = key
+        self.generation = generation
+        self.recordsLength = recordsLength
+        setIndex(index)
+        exists = true
+    }
+
+    // MARK: - Reading
+
+    /// Plaintext of every record, in list order.
+    func readAll() throws -> [Data] {
+        guard let key, !index.isEmpty else { return [] }
+        let handle = try FileHandle(forReadingFrom: recordsURL(generation: generation))
+        defer { try? handle.close() }
+        return try index.map { try Self.read($0, from: handle, key: key) }
+    }
+
+    /// Plaintext of record `id`, decrypting only that record.
+    func read(id: UUID) throws -> Data? {
+        guard let key, let position = positionsByID[id] else { return nil }
+        let handle = try FileHandle(forReadingFrom: recordsURL(generation: generation))
+        defer { try? handle.close() }
+        return try Self.read(index[position], from: handle, key: key)
+    }
+
+    private static func read(_ entry: IndexEntry, from handle: FileHandle, key: SymmetricKey) throws -> Data {
+        try handle.seek(toOffset: UInt64(entry.offset))
+        guard let sealed = try handle.read(upToCount: entry.length), sealed.count == entry.length else {
+            throw EncryptedStorageError.malformedPayload
+        }
+        return try AES.GCM.open(try AES.GCM.SealedBox(combined: sealed), using: key)
+    }
+
+    // MARK: - Writing
+
+    /// Make the list exactly `records`, in order, writing only records
+    /// whose contents changed. Returns the number of records written.
+    @discardableResult
+    func commit(_ records: [(id: UUID, plaintext: Data)]) throws -> Int {
+        let traceStart = TraceRecorder.shared.begin()
+        defer { TraceRecorder.shared.end(.storeWrite, since: traceStart) }
+        try prepareForWriting()
+        guard let key else { throw EncryptedStorageError.encryptionFailed }
+
+        let url = recordsURL(generation: generation)
+        let handle = try FileHandle(forUpdating: url)
+        defer { try? handle.close() }
+        try handle.truncate(atOffset: UInt64(recordsLength))
+        try handle.seek(toOffset: UInt64(recordsLength))
+
+        var newIndex: [IndexEntry] = []
+        newIndex.reserveCapacity(records.count)
+        var frames = Data()
+        var written = 0
+        for record in records {
+            let digest = Data(SHA256.hash(data: record.plaintext).prefix(Self.digestSize))
+            if let position = positionsByID[record.id], index[position].digest == digest {
+                newIndex.append(index[position])
+                continue
+            }
+            guard let sealed = try AES.GCM.seal(record.plaintext, using: key).combined else {
+                throw EncryptedStorageError.encryptionFailed
+            }
+            Self.appendUInt32(UInt32(sealed.count), to: &frames)
+            let offset = recordsLength + frames.count
+            frames.append(sealed)
+            newIndex.append(IndexEntry(id: record.id, offset: offset, length: sealed.count, digest: digest))
+            written += 1
+        }
+
+        guard written > 0 || newIndex != index else { return 0 }
+        if !frames.isEmpty {
+            try handle.write(contentsOf: frames)
+            try handle.synchronize()
+        }
+        recordsLength += frames.count
+        try writeIndex(newIndex)
+
+        let liveBytes = newIndex.reduce(0) { $0 + 4 + $1.length }
+        let garbage = recordsLength - Self.recordsMagic.count - liveBytes
+        if garbage > max(Self.compactionThreshold, liveBytes) {
+            try compact()
+        }
+        return written
+    }
+
+    /// Create the key, index and records file on first write.
+    private func prepareForWriting() throws {
+        try fileManager.createDirectory(at: directory, withIntermediateDirectories: true)
+        if key == nil {
+            salt = SymmetricKey(size: .bits256).withUnsafeBytes { Data($0) }
+            key = try makeKey(salt)
+            generation += 1
+            recordsLength = 0
+            setIndex([])
+        }
+        let path = recordsURL(generation: generation).path(percentEncoded: false)
+        if recordsLength == 0 || !fileManager.fileExists(atPath: path) {
+            try createRecordsFile(generation: generation)
+            recordsLength = Self.recordsMagic.count
+            setIndex([])
+        }
+    }
+
+    private func createRecordsFile(generation: UInt64) throws {
+        guard fileManager.createFile(
+            atPath: recordsURL(generation: generation).path(percentEncoded: false),
+            contents: Self.recordsMagic,
+            attributes: [.posixPermissions: 0o600, .protectionKey: FileProtectionType.complete]
+        ) else {
+            throw CocoaError(.fileWriteUnknown)
+        }
+    }
+
+    /// Copy the live frames into the next generation's file.
+    private func compact() throws {
+        let oldURL = recordsURL(generation: generation)
+        let nextGeneration = generation + 1
+        try createRecordsFile(generation: nextGeneration)
+        let source = try FileHandle(forReadingFrom: oldURL)
+        defer { try? source.close() }
+        let destination = try FileHandle(forWritingTo: recordsURL(generation: nextGeneration))
+        defer { try? destination.close() }
+        try destination.seekToEnd()
+
+        var offset = Self.recordsMagic.count
+        var compacted: [IndexEntry] = []
+        compacted.reserveCapacity(index.count)
+        for entry in index {
+            try source.seek(toOffset: UInt64(entry.offset - 4))
+            guard let frame = try source.read(upToCount: entry.length + 4), frame.count == entry.length + 4 else {
+                throw EncryptedStorageError.malformedPayload
+            }
+            try destination.write(contentsOf: frame)
+            compacted.append(IndexEntry(id: entry.id, offset: offset + 4, length: entry.length, digest: entry.digest))
+            offset += frame.count
+        }
+        try destination.synchronize()
+
+        generation = nextGeneration
+        recordsLength = offset
+        try writeIndex(compacted)
+        try? fileManager.removeItem(at: oldURL)
+    }
+
+    private func writeIndex(_ newIndex: [IndexEntry]) throws {
+        guard let key else { throw EncryptedStorageError.encryptionFailed }
+        var body = Data()
+        body.reserveCapacity(20 + newIndex.count * 44)
+        Self.appendUInt64(generation, to: &body)
+        Self.appendUInt64(UInt64(recordsLength), to: &body)
+        Self.appendUInt32(UInt32(newIndex.count), to: &body)
+        for entry in newIndex {
+            withUnsafeBytes(of: entry.id.uuid) { body.append(contentsOf: $0) }
+            Self.appendUInt64(UInt64(entry.offset), to: &body)
+            Self.appendUInt32(UInt32(entry.length), to: &body)
+            body.append(entry.digest)
+        }
+        guard let sealed = try AES.GCM.seal(body, using: key).combined else {
+            throw EncryptedStorageError.encryptionFailed
+        }
+        var file = Self.indexMagic
+        file.append(salt)
+        file.append(sealed)
+        try file.write(to: indexURL, options: .atomic)
+        try? fileManager.setAttributes(
+            [.protectionKey: FileProtectionType.complete],
+            ofItemAtPath: indexURL.path(percentEncoded: false)
+        )
+        setIndex(newIndex)
+        exists = true
+    }
+
+    /// Remove the index and every generation's records file.
+    func removeAll() throws {
+        let prefix = "\(name)."
+        for url in (try? fileManager.contentsOfDirectory(at: directory, includingPropertiesForKeys: nil)) ?? []
+        where url.lastPathComponent.hasPrefix(prefix)
+            && (url.pathExtension == "records" || url.lastPathComponent == indexURL.lastPathComponent) {
+            try fileManager.removeItem(at: url)
+        }
+        key = nil
+        recordsLength = 0
+        setIndex([])
+        exists = false
+    }
+
+    private func setIndex(_ newIndex: [IndexEntry]) {
+        index = newIndex
+        positionsByID.removeAll(keepingCapacity: true)
+        for (position, entry) in newIndex.enumerated() {
+            positionsByID[entry.id] = position
+        }
+    }
+
+    private static func appendUInt64(_ value: UInt64, to data: inout Data) {
+        withUnsafeBytes(of: value.littleEndian) { data.append(contentsOf: $0) }
+    }
+
+    private static func appendUInt32(_ value: UInt32, to data: inout Data) {
+        withUnsafeBytes(of: value.littleEndian) { data.append(contentsOf: $0) }
+    }
+}
+
+// MARK: - ByteReader
+
+private nonisolated struct ByteReader {
+    private let data: Data
+    private var position: Int
+
+    init(_ data: Data) {
+        self.data = data
+        self.position = data.startIndex
+    }
+
+    mutating func bytes(_ count: Int) throws -> Data {
+        guard position + count <= data.endIndex else { throw EncryptedStorageError.malformedPayload }
+        defer { position += count }
+        return Data(data[position..<(position + count)])
+    }
+
+    mutating func uint64() throws -> UInt64 {
+        UInt64(littleEndian: try bytes(8).withUnsafeBytes { $0.loadUnaligned(as: UInt64.self) })
+    }
+
+    mutating func uint32() throws -> UInt32 {
+        UInt32(littleEndian: try bytes(4).withUnsafeBytes { $0.loadUnaligned(as: UInt32.self) })
+    }
+
+    mutating func uuid() throws -> UUID {
+        let raw = try bytes(16)
+        return UUID(uuid: raw.withUnsafeBytes { $0.loadUnaligned(as: uuid_t.self) })
+    }
+}
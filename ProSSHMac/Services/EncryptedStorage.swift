@@ -74,11 +74,27 @@ enum EncryptedStorage {
         try writeEncryptedData(plaintext, to: fileURL, fileManager: fileManager)
     }
 
+    /// A key for encrypting transient local data (caches, spill files),
+    /// derived from the master key so nothing new is stored in the keychain.
+    /// `salt` should be random per file; `purpose` separates uses.
+    nonisolated static func derivedKey(purpose: String, salt: Data) throws -> SymmetricKey {
+        var keyData = try loadOrCreateMasterKey()
+        defer { scrub(&keyData) }
+        return HKDF<SHA256>.deriveKey(
+            inputKeyMaterial: SymmetricKey(data: keyData),
+            salt: salt,
+            info: Data(purpose.utf8),
+            outputByteCount: 32
+        )
+    }
+
     nonisolated private static func writeEncryptedData(
         _ plaintext: Data,
         to fileURL: URL,
         fileManager: FileManager
     ) throws {
+        let traceStart = TraceRecorder.shared.begin()
+        defer { TraceRecorder.shared.end(.storeWrite, since: traceStart, value: Int64(plaintext.count)) }
         let directory = fileURL.deletingLastPathComponent()
         try fileManager.createDirectory(at: directory, withIntermediateDirectories: true)
 
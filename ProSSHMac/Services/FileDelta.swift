@@ -0,0 +1,122 @@
+// FileDelta.swift
+// ProSSHV2
+//
+// rsync-style delta between two versions of a file: the old version cut
+// into fixed blocks, the new one scanned with a rolling checksum for
+// those blocks at any offset. The result is a list of copies from the old
+// version and literal runs of the new one, so an edit that inserts a line
+// near the top of a large file costs the line, not everything after it.
+//
+// Unlike rsync, both versions are local here (RemoteEditCoordinator keeps
+// the version last synced with the host), so a weak checksum match is
+// confirmed by comparing the bytes instead of a strong hash.
+
+import Foundation
+
+nonisolated enum FileDelta {
+
+    enum Operation: Equatable, Sendable {
+        /// `length` bytes of the old version starting at `offset`.
+        case copy(offset: Int, length: Int)
+        /// These bytes of the new version.
+        case literal(Range<Int>)
+    }
+
+    /// Block size for an old version of `count` bytes: about its square
+    /// root, as rsync picks, between 512 bytes and 64 KiB.
+    static func blockSize(forCount count: Int) -> Int {
+        let root = Int(Double(count).squareRoot())
+        return min(max(root, 512), 64 * 1024) & ~7
+    }
+
+    /// The operations that build `new` from `old`, in output order, with
+    /// adjacent copies and literals merged.
+    static func operations(from old: [UInt8], to new: [UInt8], blockSize: Int? = nil) -> [Operation] {
+        let size = blockSize ?? self.blockSize(forCount: old.count)
+        guard size > 0, old.count >= size, new.count >= size else {
+            return new.isEmpty ? [] : [.literal(0..<new.count)]
+        }
+
+        var blocksByChecksum: [UInt32: [Int]] = [:]
+        for start in stride(from: 0, through: old.count - size, by: size) {
+            blocksByChecksum[RollingChecksum(old[start..<(start + size)]).value, default: []].append(start)
+        }
+
+        var builder = Builder()
+        var literalStart = 0
+        var index = 0
+        var checksum = RollingChecksum(new[0..<size])
+        while index + size <= new.count {
+            if let match = blocksByChecksum[checksum.value]?.first(where: { start in
+                old[start..<(start + size)].elementsEqual(new[index..<(index + size)])
+            }) {
+                if literalStart < index { builder.append(.literal(literalStart..<index)) }
+                builder.append(.copy(offset: match, length: size))
+                index += size
+                literalStart = index
+                if index + size <= new.count {
+                    checksum = RollingChecksum(new[index..<(index + size)])
+                }
+                continue
+            }
+            if index + size < new.count {
+                checksum.roll(out: new[index], in: new[index + size], blockSize: size)
+            }
+            index += 1
+        }
+        if literalStart < new.count { builder.append(.literal(literalStart..<new.count)) }
+        return builder.operations
+    }
+
+    /// Bytes of the new version the operations carry themselves.
+    static func literalByteCount(_ operations: [Operation]) -> Int {
+        operations.reduce(0) { total, operation in
+            if case .literal(let range) = operation { return total + range.count }
+            return total
+        }
+    }
+
+    private struct Builder {
+        var operations: [Operation] = []
+
+        mutating func append(_ operation: Operation) {
+            switch (operations.last, operation) {
+            case let (.copy(offset, length)?, .copy(next, nextLength)) where offset + length == next:
+                operations[operations.count - 1] = .copy(offset: offset, length: length + nextLength)
+            case let (.literal(range)?, .literal(next)) where range.upperBound == next.lowerBound:
+                operations[operations.count - 1] = .literal(range.lowerBound..<next.upperBound)
+            default:
+                operations.append(operation)
+            }
+        }
+    }
+}
+
+// MARK: - RollingChecksum
+
+/// rsync's weak checksum: two 16-bit sums over a window, updated in
+/// constant time as the window slides one byte.
+nonisolated struct RollingChecksum: Equatable {
+    private var a: UInt32 = 0
+    private var b: UInt32 = 0
+
+    init(_ window: ArraySlice<UInt8>) {
+        let count = UInt32(window.count)
+        for (offset, byte) in window.enumerated() {
+            a &+= UInt32(byte)
+            b &+= (count - UInt32(offset)) &* UInt32(byte)
+        }
+        a &= 0xFFFF
+        b &= 0xFFFF
+    }
+
+    var value: UInt32 {
+        a | (b << 16)
+    }
+
+    /// Slides the window: `out` leaves at the front, `in` enters at the back.
+    mutating func roll(out: UInt8, in next: UInt8, blockSize: Int) {
+        a = (a &- UInt32(out) &+ UInt32(next)) & 0xFFFF
+        b = (b &- UInt32(blockSize) &* UInt32(out) &+ a) & 0xFFFF
+    }
+}
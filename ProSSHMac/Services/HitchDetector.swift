@@ -0,0 +1,325 @@
+// HitchDetector.swift
+// ProSSHV2
+//
+// Explains the frames RendererPerformanceMonitor only counts as dropped.
+// A hitch is either a frame whose CPU time overran the display interval,
+// or a main-thread stall, found by a watchdog that pings the main queue
+// every 50 ms and times the reply. For each hitch the detector copies
+// the TraceRecorder events around it and names the stage that held it up:
+// a glyph raster batch, a synchronous store write, a reflow, an
+// `updateNSView` cascade, a snapshot publish or a parser chunk. The stage
+// is the one whose spans overlapped the hitch for longest. Only spans on
+// the hitched thread count, apart from glyph batches. Their workers take
+// the cores and atlas uploads the frame needs, so they count from any
+// thread.
+//
+// The most recent reports keep their trace window for export. Per-stage
+// totals cover every hitch since launch and rank what to fix first.
+// Settings → Diagnostics copies the ranking and saves the last hitch's
+// trace.
+//
+// Started and stopped with the trace recorder, whose spans it needs.
+
+import Foundation
+import QuartzCore
+import Synchronization
+import os.log
+
+// MARK: - HitchKind
+
+nonisolated enum HitchKind: String, Sendable {
+    case frameOverBudget
+    case mainThreadStall
+
+    var label: String {
+        switch self {
+        case .frameOverBudget: "Frame over budget"
+        case .mainThreadStall: "Main thread stall"
+        }
+    }
+}
+
+// MARK: - HitchStage
+
+nonisolated enum HitchStage: String, CaseIterable, Sendable {
+    case glyphRaster
+    case storeWrite
+    case reflow
+    case viewUpdate
+    case snapshotPublish
+    case parser
+    case unknown
+
+    /// The stage a trace event belongs to, or nil when the event cannot
+    /// be blamed for a hitch. A frame's own encode span is what overran, so
+    /// there is nothing to learn from it.
+    init?(_ name: TraceEventName) {
+        switch name {
+        case .glyphRasterBatch: self = .glyphRaster
+        case .storeWrite: self = .storeWrite
+        case .reflow: self = .reflow
+        case .viewUpdate: self = .viewUpdate
+        case .publish: self = .snapshotPublish
+        case .parserChunk: self = .parser
+        case .frameEncode, .gpuFrame, .present, .sftpUpload, .sftpDownload, .sftpRange, .aiTool, .hitch:
+            return nil
+        }
+    }
+
+    var label: String {
+        switch self {
+        case .glyphRaster: "Glyph rasterization"
+        case .storeWrite: "Store write"
+        case .reflow: "Reflow"
+        case .viewUpdate: "updateNSView"
+        case .snapshotPublish: "Snapshot publish"
+        case .parser: "Parser"
+        case .unknown: "Unattributed"
+        }
+    }
+}
+
+// MARK: - HitchReport
+
+nonisolated struct HitchReport: Sendable, Identifiable {
+    let id: Int
+    let kind: HitchKind
+    /// `CACurrentMediaTime()` seconds.
+    let start: CFTimeInterval
+    let duration: CFTimeInterval
+    let threadID: UInt64
+    let stage: HitchStage
+    /// How long the stage's spans overlapped the hitch.
+    let stageSeconds: CFTimeInterval
+    /// Trace events from shortly before the hitch to its end.
+    let events: [TraceEvent]
+}
+
+nonisolated struct HitchStageSummary: Sendable, Equatable {
+    let stage: HitchStage
+    var count: Int = 0
+    var totalSeconds: CFTimeInterval = 0
+    var worstSeconds: CFTimeInterval = 0
+}
+
+// MARK: - HitchDetector
+
+nonisolated final class HitchDetector: @unchecked Sendable {
+
+    static let shared = HitchDetector()
+
+    /// A main-queue ping answered later than this is a stall.
+    let stallThreshold: CFTimeInterval
+    let watchdogInterval: CFTimeInterval
+    /// Reports kept with their trace window; totals are kept for all.
+    let reportCapacity: Int
+    /// Trace kept before a hitch's start, for context in exports.
+    static let contextSeconds: CFTimeInterval = 0.5
+
+    private static let logger = Logger(subsystem: "com.prossh", category: "HitchDetector")
+
+    private let trace: TraceRecorder
+    private let running = Atomic<Bool>(false)
+    private let queue = DispatchQueue(label: "com.prossh.hitch-detector", qos: .utility)
+
+    // Confined to `queue`.
+    private var watchdog: DispatchSourceTimer?
+    private var pingSentAt: CFTimeInterval?
+    private var mainThreadID: UInt64 = 0
+
+    private let lock = NSLock()
+    private var reports: [HitchReport] = []
+    private var summaries: [HitchStage: HitchStageSummary] = [:]
+    private var nextID = 1
+
+    init(
+        trace: TraceRecorder = .shared,
+        stallThreshold: CFTimeInterval = 0.1,
+        watchdogInterval: CFTimeInterval = 0.05,
+        reportCapacity: Int = 32
+    ) {
+        self.trace = trace
+        self.stallThreshold = stallThreshold
+        self.watchdogInterval = watchdogInterval
+        self.reportCapacity = max(reportCapacity, 1)
+    }
+
+    var isRunning: Bool {
+        running.load(ordering: .relaxed)
+    }
+
+    /// Starts the main-thread watchdog and frame checks.
+    @MainActor
+    func start() {
+        guard !running.exchange(true, ordering: .relaxed) else { return }
+        let mainThread = trace.currentThreadID()
+        queue.async { [self] in
+            mainThreadID = mainThread
+            let timer = DispatchSource.makeTimerSource(queue: queue)
+            timer.schedule(
+                deadline: .now() + watchdogInterval,
+                repeating: watchdogInterval,
+                leeway: .milliseconds(10)
+            )
+            timer.setEventHandler { [weak self] in self?.ping() }
+            timer.resume()
+            watchdog = timer
+        }
+    }
+
+    func stop() {
+        guard running.exchange(false, ordering: .relaxed) else { return }
+        queue.async { [self] in
+            watchdog?.cancel()
+            watchdog = nil
+            pingSentAt = nil
+        }
+    }
+
+    // MARK: Detection
+
+    /// Called by the draw loop after each rendered frame. Costs a compare
+    /// unless the frame overran `budget`.
+    func frameFinished(start: CFTimeInterval, end: CFTimeInterval, budget: CFTimeInterval) {
+        guard end - start > budget, isRunning else { return }
+        let threadID = trace.currentThreadID()
+        queue.async { [self] in
+            capture(.frameOverBudget, start: start, end: end, threadID: threadID)
+        }
+    }
+
+    /// One ping in flight at a time. While the main queue is stuck, ticks
+    /// find the ping unanswered and wait for it.
+    private func ping() {
+        guard pingSentAt == nil else { return }
+        pingSentAt = CACurrentMediaTime()
+        DispatchQueue.main.async { [self] in
+            let answeredAt = CACurrentMediaTime()
+            queue.async { self.pong(at: answeredAt) }
+        }
+    }
+
+    private func pong(at answeredAt: CFTimeInterval) {
+        guard let sentAt = pingSentAt else { return }
+        pingSentAt = nil
+        guard answeredAt - sentAt >= stallThreshold else { return }
+        // The stall may have begun up to one tick before the ping.
+        capture(.mainThreadStall, start: sentAt - watchdogInterval, end: answeredAt, threadID: mainThreadID)
+    }
+
+    /// Attribute and store one hitch. Internal so tests can feed hitches
+    /// without timing real frames.
+    func capture(_ kind: HitchKind, start: CFTimeInterval, end: CFTimeInterval, threadID: UInt64) {
+        let events = trace.events(overlapping: start - Self.contextSeconds, end)
+        let attribution = Self.attribute(events, start: start, end: end, threadID: threadID)
+        trace.record(.hitch, start: start, end: end, threadID: threadID)
+
+        lock.lock()
+        let report = HitchReport(
+            id: nextID,
+            kind: kind,
+            start: start,
+            duration: end - start,
+            threadID: threadID,
+            stage: attribution.stage,
+            stageSeconds: attribution.seconds,
+            events: events
+        )
+        nextID += 1
+        reports.append(report)
+        if reports.count > reportCapacity {
+            reports.removeFirst(reports.count - reportCapacity)
+        }
+        var summary = summaries[report.stage] ?? HitchStageSummary(stage: report.stage)
+        summary.count += 1
+        summary.totalSeconds += report.duration
+        summary.worstSeconds = max(summary.worstSeconds, report.duration)
+        summaries[report.stage] = summary
+        lock.unlock()
+
+        Self.logger.debug(
+            "\(kind.label, privacy: .public) \(report.duration * 1000, format: .fixed(precision: 1)) ms: \(report.stage.label, privacy: .public)"
+        )
+    }
+
+    /// The stage whose spans overlapped `start...end` for longest on
+    /// `threadID`, counting glyph raster batches from any thread.
+    static func attribute(
+        _ events: [TraceEvent],
+        start: CFTimeInterval,
+        end: CFTimeInterval,
+        threadID: UInt64
+    ) -> (stage: HitchStage, seconds: CFTimeInterval) {
+        var overlap: [HitchStage: CFTimeInterval] = [:]
+        for event in events {
+            guard let stage = HitchStage(event.name),
+                  event.threadID == threadID || stage == .glyphRaster else { continue }
+            let seconds = min(end, event.start + event.duration) - max(start, event.start)
+            if seconds > 0 {
+                overlap[stage, default: 0] += seconds
+            }
+        }
+        guard let longest = overlap.max(by: { $0.value < $1.value }) else {
+            return (.unknown, 0)
+        }
+        return (longest.key, longest.value)
+    }
+
+    // MARK: Reports
+
+    /// Most recent first.
+    var recentReports: [HitchReport] {
+        lock.lock()
+        defer { lock.unlock() }
+        return reports.reversed()
+    }
+
+    /// Stages by total hitch time since launch, worst first.
+    var ranking: [HitchStageSummary] {
+        lock.lock()
+        defer { lock.unlock() }
+        return summaries.values.sorted {
+            $0.totalSeconds != $1.totalSeconds ? $0.totalSeconds > $1.totalSeconds : $0.count > $1.count
+        }
+    }
+
+    func reset() {
+        lock.lock()
+        reports.removeAll()
+        summaries.removeAll()
+        lock.unlock()
+    }
+
+    /// The ranking, then the recent hitches, as plain text.
+    var report: String {
+        let ranking = ranking
+        guard !ranking.isEmpty else { return "No hitches recorded." }
+        var lines = ["Hitches by stage:"]
+        for summary in ranking {
+            lines.append(String(
+                format: "  %@: %d, %.0f ms total, worst %.1f ms",
+                summary.stage.label, summary.count, summary.totalSeconds * 1000, summary.worstSeconds * 1000
+            ))
+        }
+        lines.append("Recent:")
+        for hitch in recentReports {
+            lines.append(String(
+                format: "  #%d %@ %.1f ms — %@ %.1f ms",
+                hitch.id, hitch.kind.label, hitch.duration * 1000, hitch.stage.label, hitch.stageSeconds * 1000
+            ))
+        }
+        return lines.joined(separator: "\n")
+    }
+
+    /// Writes the newest hitch's trace window to `~/Downloads`, or returns
+    /// nil when none was recorded.
+    func saveLatestTrace() throws -> URL? {
+        guard let latest = recentReports.first else { return nil }
+        let data = try TraceRecorder.chromeTrace(events: latest.events, mainThreadID: trace.mainThreadIdentifier)
+        let directory = FileManager.default.urls(for: .downloadsDirectory, in: .userDomainMask).first
+            ?? FileManager.default.temporaryDirectory
+        let url = directory.appendingPathComponent("ProSSHMac-hitch-\(latest.id).json")
+        try data.write(to: url, options: .atomic)
+        return url
+    }
+}
@@ -0,0 +1,128 @@
+// HostListCache.swift
+// ProSSHV2
+//
+// A sealed copy of the host list in display order, read at launch so the
+// Hosts screen can show every host before the record store has been
+// opened, decrypted record by record and sorted. The store stays the
+// source of truth: HostListViewModel replaces the cached list with what
+// the store returns and rewrites the cache after every save.
+//
+// Layout, in Application Support/ProSSHV2/hosts.list:
+//   magic "PSSHHLC1", 32-byte key salt, then the AES-GCM sealed JSON array
+//
+// Each write uses a fresh salt; the key is derived from the EncryptedStorage
+// master key. Reads and writes run on one serial queue, so a load issued
+// after a save sees it. A missing or unreadable cache loads as nil.
+
+import CryptoKit
+import Foundation
+import os.log
+
+final class HostListCache {
+
+    nonisolated private static let magic = Data("PSSHHLC1".utf8)
+    nonisolated private static let saltSize = 32
+    nonisolated private static let logger = Logger(subsystem: "com.prossh", category: "HostListCache")
+
+    private let fileURL: URL
+    private let makeKey: @Sendable (Data) throws -> SymmetricKey
+    private let queue = DispatchQueue(label: "com.prossh.host-list-cache", qos: .userInitiated)
+
+    init(
+        fileURL: URL,
+        makeKey: @escaping @Sendable (Data) throws -> SymmetricKey = { salt in
+            try EncryptedStorage.derivedKey(purpose: "host-list-cache-v1", salt: salt)
+        }
+    ) {
+        self.fileURL = fileURL
+        self.makeKey = makeKey
+    }
+
+    static func makeDefault(fileManager: FileManager = .default) -> HostListCache {
+        let base = fileManager.urls(for: .applicationSupportDirectory, in: .userDomainMask).first
+            ?? fileManager.temporaryDirectory
+        return HostListCache(
+            fileURL: base
+                .appendingPathComponent("ProSSHV2", isDirectory: true)
+                .appendingPathComponent("hosts.list")
+        )
+    }
+
+    /// The cached hosts in the order they were saved, or nil.
+    func load() async -> [Host]? {
+        let fileURL = fileURL
+        let makeKey = makeKey
+        let plaintext: Data? = await withCheckedContinuation { continuation in
+            queue.async {
+                continuation.resume(returning: Self.unseal(fileURL, makeKey: makeKey))
+            }
+        }
+        guard let plaintext else { return nil }
+        return try? Self.makeDecoder().decode([Host].self, from: plaintext)
+    }
+
+    /// Replace the cache. Encoding happens here; sealing and the write run
+    /// in the background.
+    func save(_ hosts: [Host]) {
+        guard let plaintext = try? Self.makeEncoder().encode(hosts) else { return }
+        let fileURL = fileURL
+        let makeKey = makeKey
+        queue.async {
+            Self.seal(plaintext, to: fileURL, makeKey: makeKey)
+        }
+    }
+
+    // MARK: - File
+
+    nonisolated private static func unseal(
+        _ url: URL,
+        makeKey: (Data) throws -> SymmetricKey
+    ) -> Data? {
+        guard let file = try? Data(contentsOf: url) else { return nil }
+        let headerSize = magic.count + saltSize
+        guard file.count > headerSize, file.prefix(magic.count) == magic else { return nil }
+        do {
+            let key = try makeKey(Data(file[magic.count..<headerSize]))
+            let box = try AES.GCM.SealedBox(combined: file.suffix(from: file.startIndex + headerSize))
+            return try AES.GCM.open(box, using: key)
+        } catch {
+            logger.error("Host list cache unreadable: \(error.localizedDescription, privacy: .public)")
+            return nil
+        }
+    }
+
+    nonisolated private static func seal(
+        _ plaintext: Data,
+        to url: URL,
+        makeKey: (Data) throws -> SymmetricKey
+    ) {
+        do {
+            let salt = SymmetricKey(size: .bits256).withUnsafeBytes { Data($0) }
+            guard let sealed = try AES.GCM.seal(plaintext, using: try makeKey(salt)).combined else {
+                throw CocoaError(.fileWriteUnknown)
+            }
+            var file = magic
+            file.append(salt)
+            file.append(sealed)
+            try FileManager.default.createDirectory(
+                at: url.deletingLastPathComponent(),
+                withIntermediateDirectories: true
+            )
+            try file.write(to: url, options: .atomic)
+        } catch {
+            logger.error("Host list cache not written: \(error.localizedDescription, privacy: .public)")
+        }
+    }
+
+    private static func makeEncoder() -> JSONEncoder {
+        let encoder = JSONEncoder()
+        encoder.dateEncodingStrategy = .iso8601
+        return encoder
+    }
+
+    private static func makeDecoder() -> JSONDecoder {
+        let decoder = JSONDecoder()
+        decoder.dateDecodingStrategy = .iso8601
+        return decoder
+    }
+}
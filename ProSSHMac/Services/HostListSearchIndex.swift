@@ -0,0 +1,321 @@
+// HostListSearchIndex.swift
+// ProSSHV2
+//
+// Search index behind the Hosts list filter. Every word of a host's label,
+// hostname, username, folder and tags is indexed together with the rest of
+// its field, in a byte-level prefix trie, so typing "prod" finds
+// "web-prod-01" and "web-pr" finds it as well. Tags and folders are also
+// kept as exact-match facets for `tag:` and `folder:` terms.
+//
+// The index is a value type. HostListViewModel updates it in place when
+// hosts change (only documents whose fields differ are re-indexed) and
+// hands a copy to a background task for each query.
+
+import Foundation
+
+/// The searchable fields of a host, copied off the main-actor `Host`.
+nonisolated struct HostSearchDocument: Hashable, Sendable {
+    var id: UUID
+    var label: String
+    var hostname: String
+    var username: String
+    /// Trimmed; empty for ungrouped hosts.
+    var folder: String
+    var tags: [String]
+}
+
+extension HostSearchDocument {
+    @MainActor
+    init(_ host: Host) {
+        self.init(
+            id: host.id,
+            label: host.label,
+            hostname: host.hostname,
+            username: host.username,
+            folder: host.folder?.trimmingCharacters(in: .whitespacesAndNewlines) ?? "",
+            tags: host.tags
+        )
+    }
+}
+
+/// A folder section of the filtered host list.
+nonisolated struct HostListGroup: Identifiable, Hashable, Sendable {
+    static let ungroupedTitle = "Ungrouped"
+
+    var folder: String
+    var hostIDs: [UUID]
+
+    var id: String { folder }
+}
+
+nonisolated struct HostListSearchIndex: Sendable {
+
+    /// Indexed suffixes are cut to this many bytes. Longer query terms are
+    /// looked up by their first bytes and checked against the document.
+    static let maxTokenLength = 24
+
+    private var documents: [HostSearchDocument?] = []
+    private var slotsByID: [UUID: Int32] = [:]
+    private var freeSlots: [Int32] = []
+    private var tokensBySlot: [Int32: Set<[UInt8]>] = [:]
+    private var tagSlots: [String: Set<Int32>] = [:]
+    private var folderSlots: [String: Set<Int32>] = [:]
+
+    // Trie in first-child / next-sibling form; node 0 is the root.
+    private var nodeByte: [UInt8] = [0]
+    private var firstChild: [Int32] = [-1]
+    private var nextSibling: [Int32] = [-1]
+    private var postings: [Int32: [Int32]] = [:]
+
+    init() {}
+
+    init(_ documents: [HostSearchDocument]) {
+        _ = update(documents)
+    }
+
+    var count: Int { slotsByID.count }
+
+    /// Host counts per tag, keyed by lowercased tag.
+    var tagCounts: [String: Int] { tagSlots.mapValues(\.count) }
+
+    /// Host counts per folder, keyed by lowercased folder; "" is ungrouped.
+    var folderCounts: [String: Int] { folderSlots.mapValues(\.count) }
+
+    // MARK: - Updates
+
+    /// Make the index hold exactly `documents`. Returns how many were added,
+    /// changed or removed.
+    @discardableResult
+    mutating func update(_ documents: [HostSearchDocument]) -> Int {
+        var changed = 0
+        var seen = Set<UUID>()
+        seen.reserveCapacity(documents.count)
+        for document in documents where seen.insert(document.id).inserted {
+            if let slot = slotsByID[document.id], self.documents[Int(slot)] == document {
+                continue
+            }
+            upsert(document)
+            changed += 1
+        }
+        for id in slotsByID.keys where !seen.contains(id) {
+            remove(id: id)
+            changed += 1
+        }
+        return changed
+    }
+
+    mutating func upsert(_ document: HostSearchDocument) {
+        remove(id: document.id)
+
+        let slot: Int32
+        if let free = freeSlots.popLast() {
+            slot = free
+            documents[Int(slot)] = document
+        } else {
+            slot = Int32(documents.count)
+            documents.append(document)
+        }
+        slotsByID[document.id] = slot
+
+        let tokens = Self.tokens(of: document)
+        for token in tokens {
+            postings[insertNode(for: token), default: []].append(slot)
+        }
+        tokensBySlot[slot] = tokens
+        for tag in Set(document.tags.map { $0.lowercased() }) {
+            tagSlots[tag, default: []].insert(slot)
+        }
+        folderSlots[document.folder.lowercased(), default: []].insert(slot)
+    }
+
+    mutating func remove(id: UUID) {
+        guard let slot = slotsByID.removeValue(forKey: id),
+              let document = documents[Int(slot)] else { return }
+
+        for token in tokensBySlot.removeValue(forKey: slot) ?? [] {
+            guard let node = findNode(for: token[...]) else { continue }
+            postings[node]?.removeAll { $0 == slot }
+            if postings[node]?.isEmpty == true {
+                postings[node] = nil
+            }
+        }
+        for tag in Set(document.tags.map { $0.lowercased() }) {
+            tagSlots[tag]?.remove(slot)
+            if tagSlots[tag]?.isEmpty == true {
+                tagSlots[tag] = nil
+            }
+        }
+        let folder = document.folder.lowercased()
+        folderSlots[folder]?.remove(slot)
+        if folderSlots[folder]?.isEmpty == true {
+            folderSlots[folder] = nil
+        }
+        documents[Int(slot)] = nil
+        freeSlots.append(slot)
+    }
+
+    // MARK: - Queries
+
+    /// IDs of the hosts matching every term of `query`, or nil when the
+    /// query has no terms and everything matches.
+    ///
+    /// Terms are separated by whitespace. `tag:name` and `folder:name`
+    /// (or `group:name`) match exactly, ignoring case; `folder:ungrouped`
+    /// matches hosts without a folder. Any other term matches hosts where
+    /// some field, from the start of one of its words, begins with it.
+    func matchingIDs(_ query: String) throws -> Set<UUID>? {
+        guard let slots = try matchingSlots(query) else { return nil }
+        return Set(slots.compactMap { documents[Int($0)]?.id })
+    }
+
+    /// The matching hosts in `order`, split into folder sections sorted by
+    /// title. IDs the index doesn't hold are skipped.
+    func groups(order: [UUID], query: String) throws -> [HostListGroup] {
+        let slots = try matchingSlots(query)
+        var groups: [HostListGroup] = []
+        var groupByFolder: [String: Int] = [:]
+        for (offset, id) in order.enumerated() {
+            if offset & 0xFFF == 0 {
+                try Task.checkCancellation()
+            }
+            guard let slot = slotsByID[id],
+                  slots?.contains(slot) ?? true,
+                  let document = documents[Int(slot)] else { continue }
+            let title = document.folder.isEmpty ? HostListGroup.ungroupedTitle : document.folder
+            if let position = groupByFolder[title] {
+                groups[position].hostIDs.append(id)
+            } else {
+                groupByFolder[title] = groups.count
+                groups.append(HostListGroup(folder: title, hostIDs: [id]))
+            }
+        }
+        return groups.sorted { $0.folder.localizedCaseInsensitiveCompare($1.folder) == .orderedAscending }
+    }
+
+    private func matchingSlots(_ query: String) throws -> Set<Int32>? {
+        let terms = query.lowercased().split(whereSeparator: \.isWhitespace)
+        guard !terms.isEmpty else { return nil }
+
+        var result: Set<Int32>?
+        for term in terms {
+            try Task.checkCancellation()
+            let slots: Set<Int32>
+            if let tag = Self.value(of: term, prefixes: ["tag:"]) {
+                slots = tagSlots[tag] ?? []
+            } else if let folder = Self.value(of: term, prefixes: ["folder:", "group:"]) {
+                let key = folder == HostListGroup.ungroupedTitle.lowercased() ? "" : folder
+                slots = folderSlots[key] ?? folderSlots[folder] ?? []
+            } else {
+                slots = try prefixSlots(Array(term.utf8))
+            }
+            result = result.map { $0.intersection(slots) } ?? slots
+            if result?.isEmpty == true { break }
+        }
+        return result
+    }
+
+    /// Slots with an indexed suffix starting with `term`.
+    private func prefixSlots(_ term: [UInt8]) throws -> Set<Int32> {
+        let key = term.prefix(Self.maxTokenLength)
+        guard let start = findNode(for: key) else { return [] }
+
+        var slots = Set<Int32>()
+        var stack: [Int32] = [start]
+        var visited = 0
+        while let node = stack.popLast() {
+            visited += 1
+            if visited & 0xFFF == 0 {
+                try Task.checkCancellation()
+            }
+            if let found = postings[node] {
+                slots.formUnion(found)
+            }
+            var child = firstChild[Int(node)]
+            while child >= 0 {
+                stack.append(child)
+                child = nextSibling[Int(child)]
+            }
+        }
+
+        if term.count > Self.maxTokenLength {
+            let needle = String(decoding: term, as: UTF8.self)
+            slots = slots.filter { slot in
+                documents[Int(slot)].map { Self.fields(of: $0).contains { $0.contains(needle) } } ?? false
+            }
+        }
+        return slots
+    }
+
+    private static func value(of term: Substring, prefixes: [String]) -> String? {
+        for prefix in prefixes where term.hasPrefix(prefix) && term.count > prefix.count {
+            return String(term.dropFirst(prefix.count))
+        }
+        return nil
+    }
+
+    // MARK: - Trie
+
+    private func findNode(for key: ArraySlice<UInt8>) -> Int32? {
+        var node: Int32 = 0
+        for byte in key {
+            var child = firstChild[Int(node)]
+            while child >= 0, nodeByte[Int(child)] != byte {
+                child = nextSibling[Int(child)]
+            }
+            guard child >= 0 else { return nil }
+            node = child
+        }
+        return node
+    }
+
+    private mutating func insertNode(for key: [UInt8]) -> Int32 {
+        var node: Int32 = 0
+        for byte in key {
+            var child = firstChild[Int(node)]
+            while child >= 0, nodeByte[Int(child)] != byte {
+                child = nextSibling[Int(child)]
+            }
+            if child < 0 {
+                child = Int32(nodeByte.count)
+                nodeByte.append(byte)
+                firstChild.append(-1)
+                nextSibling.append(firstChild[Int(node)])
+                firstChild[Int(node)] = child
+            }
+            node = child
+        }
+        return node
+    }
+
+    // MARK: - Tokens
+
+    private static func fields(of document: HostSearchDocument) -> [String] {
+        var fields = [document.label, document.hostname, document.username, document.folder]
+        fields.append("\(document.username)@\(document.hostname)")
+        fields.append(contentsOf: document.tags)
+        return fields.map { $0.lowercased() }
+    }
+
+    /// Each field from the start of each of its words, cut to
+    /// `maxTokenLength` bytes.
+    private static func tokens(of document: HostSearchDocument) -> Set<[UInt8]> {
+        var tokens = Set<[UInt8]>()
+        for field in fields(of: document) {
+            let bytes = Array(field.utf8)
+            for start in bytes.indices where isWordByte(bytes[start]) && (start == 0 || !isWordByte(bytes[start - 1])) {
+                tokens.insert(Array(bytes[start..<min(bytes.count, start + maxTokenLength)]))
+            }
+        }
+        return tokens
+    }
+
+    /// ASCII letters and digits, and every byte of a non-ASCII character.
+    private static func isWordByte(_ byte: UInt8) -> Bool {
+        switch byte {
+        case UInt8(ascii: "a")...UInt8(ascii: "z"), UInt8(ascii: "0")...UInt8(ascii: "9"), 0x80...:
+            return true
+        default:
+            return false
+        }
+    }
+}
@@ -1,26 +1,149 @@
 import Foundation
 import CoreSpotlight
+import CryptoKit
 import UniformTypeIdentifiers
 
 protocol HostSearchIndexing {
     func reindex(hosts: [Host]) async
 }
 
+/// Spotlight changes that bring the index in line with a host list.
+struct HostSpotlightIndexPlan: Equatable {
+    /// Drop the whole host domain before indexing.
+    var rebuildsDomain: Bool
+    var hostIDsToIndex: [UUID]
+    var hostIDsToDelete: [UUID]
+    /// Fingerprints to remember once the plan has been applied.
+    var fingerprints: [UUID: String]
+}
+
+/// Indexes hosts for Spotlight. A fingerprint of each host's searchable
+/// fields is kept in Application Support/ProSSHV2/spotlight_hosts.json, so a
+/// reindex only submits hosts that were added or changed and deletes the
+/// ones that are gone. The domain is rebuilt from scratch when there are no
+/// fingerprints, after an indexing error, and once a week in case the
+/// system index was reset behind the app's back.
 final class HostSpotlightIndexer: HostSearchIndexing {
     static let hostDomainIdentifier = "prossh.hosts"
+    static let rebuildInterval: TimeInterval = 7 * 24 * 60 * 60
     private static let hostIdentifierPrefix = "prossh.host."
 
+    private struct IndexState: Codable {
+        var rebuiltAt: Date
+        var fingerprints: [UUID: String]
+    }
+
+    private let stateURL: URL
+    private var state: IndexState?
+    private var stateLoaded = false
+    private var running: Task<Void, Never>?
+
+    init(fileManager: FileManager = .default) {
+        let base = fileManager.urls(for: .applicationSupportDirectory, in: .userDomainMask).first
+            ?? fileManager.temporaryDirectory
+        self.stateURL = base
+            .appendingPathComponent("ProSSHV2", isDirectory: true)
+            .appendingPathComponent("spotlight_hosts.json")
+    }
+
     func reindex(hosts: [Host]) async {
+        // Saves can reindex back to back; apply them one at a time.
+        let previous = running
+        let task = Task {
+            await previous?.value
+            await self.apply(hosts: hosts)
+        }
+        running = task
+        await task.value
+    }
+
+    /// What to submit given the fingerprints indexed last time; nil
+    /// `indexed` means the domain's contents are unknown.
+    static func plan(hosts: [Host], indexed: [UUID: String]?) -> HostSpotlightIndexPlan {
+        var fingerprints: [UUID: String] = [:]
+        fingerprints.reserveCapacity(hosts.count)
+        var toIndex: [UUID] = []
+        for host in hosts {
+            let fingerprint = Self.fingerprint(for: host)
+            fingerprints[host.id] = fingerprint
+            if indexed?[host.id] != fingerprint {
+                toIndex.append(host.id)
+            }
+        }
+        let toDelete = indexed.map { indexed in
+            indexed.keys.filter { fingerprints[$0] == nil }.sorted { $0.uuidString < $1.uuidString }
+        } ?? []
+        return HostSpotlightIndexPlan(
+            rebuildsDomain: indexed == nil,
+            hostIDsToIndex: toIndex,
+            hostIDsToDelete: toDelete,
+            fingerprints: fingerprints
+        )
+    }
+
+    /// Digest of everything `searchableItem(for:)` puts in the index.
+    static func fingerprint(for host: Host) -> String {
+        var fields: [String] = [
+            host.id.uuidString,
+            host.label,
+            host.username,
+            host.hostname,
+            String(host.port),
+            host.folder ?? "",
+            host.lastConnected.map { String($0.timeIntervalSinceReferenceDate) } ?? ""
+        ]
+        fields.append(contentsOf: host.tags)
+        let digest = SHA256.hash(data: Data(fields.joined(separator: "\u{0}").utf8))
+        return digest.prefix(16).map { String(format: "%02x", $0) }.joined()
+    }
+
+    private func apply(hosts: [Host]) async {
+        loadStateIfNeeded()
+        let isStale = state.map { Date().timeIntervalSince($0.rebuiltAt) > Self.rebuildInterval } ?? true
+        let plan = Self.plan(hosts: hosts, indexed: isStale ? nil : state?.fingerprints)
         let index = CSSearchableIndex.default()
-        let items = hosts.map(searchableItem(for:))
+        let hostsByID = Dictionary(hosts.map { ($0.id, $0) }, uniquingKeysWith: { first, _ in first })
+        let items = plan.hostIDsToIndex.compactMap { hostsByID[$0] }.map(searchableItem(for:))
 
         do {
-            try await index.deleteSearchableItems(withDomainIdentifiers: [Self.hostDomainIdentifier])
-            guard !items.isEmpty else { return }
-            try await index.indexSearchableItems(items)
+            if plan.rebuildsDomain {
+                try await index.deleteSearchableItems(withDomainIdentifiers: [Self.hostDomainIdentifier])
+            } else if !plan.hostIDsToDelete.isEmpty {
+                try await index.deleteSearchableItems(
+                    withIdentifiers: plan.hostIDsToDelete.map { Self.hostIdentifierPrefix + $0.uuidString }
+                )
+            }
+            if !items.isEmpty {
+                try await index.indexSearchableItems(items)
+            }
+            let rebuiltAt = plan.rebuildsDomain ? Date() : (state?.rebuiltAt ?? Date())
+            state = IndexState(rebuiltAt: rebuiltAt, fingerprints: plan.fingerprints)
         } catch {
             // Spotlight indexing should not interrupt host management.
+            // Forget what was indexed so the next pass rebuilds.
+            state = nil
         }
+        saveState()
+    }
+
+    private func loadStateIfNeeded() {
+        guard !stateLoaded else { return }
+        stateLoaded = true
+        guard let data = try? Data(contentsOf: stateURL) else { return }
+        state = try? JSONDecoder().decode(IndexState.self, from: data)
+    }
+
+    private func saveState() {
+        guard let state else {
+            try? FileManager.default.removeItem(at: stateURL)
+            return
+        }
+        guard let data = try? JSONEncoder().encode(state) else { return }
+        try? FileManager.default.createDirectory(
+            at: stateURL.deletingLastPathComponent(),
+            withIntermediateDirectories: true
+        )
+        try? data.write(to: stateURL, options: .atomic)
     }
 
     static func hostID(from userActivity: NSUserActivity) -> UUID? {
@@ -65,6 +188,18 @@ final class HostSpotlightIndexer: HostSearchIndexing {
 }
 
 private extension CSSearchableIndex {
+    func deleteSearchableItems(withIdentifiers identifiers: [String]) async throws {
+        try await withCheckedThrowingContinuation { (continuation: CheckedContinuation<Void, Error>) in
+            deleteSearchableItems(withIdentifiers: identifiers) { error in
+                if let error {
+                    continuation.resume(throwing: error)
+                } else {
+                    continuation.resume()
+                }
+            }
+        }
+    }
+
     func deleteSearchableItems(withDomainIdentifiers domainIdentifiers: [String]) async throws {
         try await withCheckedThrowingContinuation { (continuation: CheckedContinuation<Void, Error>) in
             deleteSearchableItems(withDomainIdentifiers: domainIdentifiers) { error in
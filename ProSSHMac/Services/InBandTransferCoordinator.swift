@@ -0,0 +1,859 @@
+// InBandTransferCoordinator.swift
+// ProSSHV2
+//
+// ZMODEM transfers through a session's terminal, for hosts without SFTP
+// (restricted bastions, serial consoles, a shell reached through
+// `sudo su`). The parser reader hands each output span to an
+// InBandTransferDemultiplexer before the engine. When `sz` or `rz` starts,
+// the stream goes to the transfer instead, so none of the file reaches the
+// grid or the scrollback; once the transfer ends, output goes back to the
+// terminal.
+//
+// Downloads from `sz` are written to the Downloads folder as they arrive.
+// `rz` asks for files (SessionManager.inBandUploadRequests), then they are
+// streamed in 8 KiB subpackets without stopping: every 32nd subpacket asks
+// for an acknowledgement, and the sender only waits with 1 MiB
+// unacknowledged. An error costs one ZRPOS and a resend from the position
+// the receiver has. Each file is a TransferManager row with the usual
+// progress and cancel button.
+//
+// Off unless `SessionManager.inBandTransfersEnabled` is set.
+
+import Foundation
+import os.log
+
+// MARK: - Events
+
+/// One file of an in-band transfer, as a TransferManager row.
+nonisolated struct InBandTransferItem: Sendable {
+    let id: UUID
+    let direction: TransferDirection
+    let sourcePath: String
+    let destinationPath: String
+    let totalBytes: Int64
+    let meter: TransferProgressMeter
+}
+
+nonisolated enum InBandTransferEvent: Sendable {
+    /// `rz` started and is waiting for files.
+    case filesRequested
+    case fileStarted(InBandTransferItem)
+    /// A nil `failure` is a complete file.
+    case fileFinished(UUID, bytesTransferred: Int64, failure: String?)
+    /// Output goes to the terminal again.
+    case ended
+}
+
+// MARK: - ZModemReplyMailbox
+
+/// The receiver's answers during an upload, posted by the parser reader
+/// and taken by the sender task.
+nonisolated final class ZModemReplyMailbox: @unchecked Sendable {
+    private let lock = NSLock()
+    private var replies: [ZModemDecoder.Event] = []
+    private var waiter: CheckedContinuation<ZModemDecoder.Event?, Never>?
+    private var closed = false
+
+    func post(_ reply: ZModemDecoder.Event) {
+        let waiter = lock.withLock { () -> CheckedContinuation<ZModemDecoder.Event?, Never>? in
+            guard !closed else { return nil }
+            guard let waiter = self.waiter else {
+                replies.append(reply)
+                return nil
+            }
+            self.waiter = nil
+            return waiter
+        }
+        waiter?.resume(returning: reply)
+    }
+
+    /// Ends the upload. Answers already posted can still be taken.
+    func close() {
+        let waiter = lock.withLock { () -> CheckedContinuation<ZModemDecoder.Event?, Never>? in
+            closed = true
+            defer { self.waiter = nil }
+            return self.waiter
+        }
+        waiter?.resume(returning: nil)
+    }
+
+    var isClosed: Bool {
+        lock.withLock { closed && replies.isEmpty }
+    }
+
+    /// The next answer if one is waiting.
+    func poll() -> ZModemDecoder.Event? {
+        lock.withLock { replies.isEmpty ? nil : replies.removeFirst() }
+    }
+
+    /// The next answer, or nil once the upload is over.
+    func next() async -> ZModemDecoder.Event? {
+        await withCheckedContinuation { continuation in
+            let ready = lock.withLock { () -> ZModemDecoder.Event?? in
+                if !replies.isEmpty { return .some(replies.removeFirst()) }
+                if closed { return .some(nil) }
+                waiter = continuation
+                return .none
+            }
+            if let ready {
+                continuation.resume(returning: ready)
+            }
+        }
+    }
+}
+
+// MARK: - ZModemSender
+
+/// Streams files to `rz` from its own task.
+nonisolated struct ZModemSender: Sendable {
+    static let subpacketLength = 8 * 1024
+    /// Every this many subpackets asks for a ZACK.
+    static let subpacketsPerAck = 32
+    /// Unacknowledged bytes in flight to a receiver with no buffer limit.
+    static let window: Int64 = 1 << 20
+    /// Encoded bytes gathered for each channel write.
+    static let writeSize = 64 * 1024
+
+    private enum Outcome {
+        case sent
+        case skipped
+        case failed(String)
+        /// Cancelled, or the receiver went away.
+        case over
+    }
+
+    let channel: any SSHShellChannel
+    let receiverInit: ZModemHeader
+    let replies: ZModemReplyMailbox
+    let events: AsyncStream<InBandTransferEvent>.Continuation
+    private var encoder = ZModemEncoder()
+
+    init(
+        channel: any SSHShellChannel,
+        receiverInit: ZModemHeader,
+        replies: ZModemReplyMailbox,
+        events: AsyncStream<InBandTransferEvent>.Continuation
+    ) {
+        self.channel = channel
+        self.receiverInit = receiverInit
+        self.replies = replies
+        self.events = events
+        encoder.usesCRC32 = receiverInit.flags & ZModem.canCRC32 != 0
+        encoder.escapesControls = receiverInit.flags & ZModem.escapesControls != 0
+    }
+
+    /// Sends `files` and ends the session; false when it had to stop
+    /// early and `rz` still needs cancelling.
+    mutating func send(_ files: [URL]) async -> Bool {
+        for url in files {
+            guard await send(url) else { return false }
+        }
+        guard (try? await write(ZModemEncoder.hexHeader(ZModemHeader(.fin)))) != nil else { return false }
+        while let reply = await replies.next() {
+            if case .header(let header) = reply, header.type == .fin {
+                try? await write(ZModem.overAndOut)
+                return true
+            }
+        }
+        return true
+    }
+
+    /// Reports `url` as a transfer row; false when the session is over.
+    private mutating func send(_ url: URL) async -> Bool {
+        let handle: FileHandle
+        let size: Int64
+        let modifiedAt: Date?
+        do {
+            let attributes = try FileManager.default.attributesOfItem(atPath: url.path)
+            size = (attributes[.size] as? NSNumber)?.int64Value ?? 0
+            modifiedAt = attributes[.modificationDate] as? Date
+            handle = try FileHandle(forReadingFrom: url)
+        } catch {
+            let item = Self.item(for: url, size: 0)
+            events.yield(.fileStarted(item))
+            events.yield(.fileFinished(item.id, bytesTransferred: 0, failure: error.localizedDescription))
+            return true
+        }
+        defer { try? handle.close() }
+
+        let item = Self.item(for: url, size: size)
+        events.yield(.fileStarted(item))
+        let outcome = await transmit(handle, item: item, modifiedAt: modifiedAt)
+        let failure: String?
+        switch outcome {
+        case .sent: failure = nil
+        case .skipped: failure = "The receiver skipped the file; it may already exist there."
+        case .failed(let message): failure = message
+        case .over: failure = "The transfer was cancelled."
+        }
+        events.yield(.fileFinished(item.id, bytesTransferred: item.meter.bytesTransferred, failure: failure))
+        switch outcome {
+        case .sent, .skipped: return true
+        case .failed, .over: return false
+        }
+    }
+
+    private static func item(for url: URL, size: Int64) -> InBandTransferItem {
+        InBandTransferItem(
+            id: UUID(),
+            direction: .upload,
+            sourcePath: url.path,
+            destinationPath: url.lastPathComponent,
+            totalBytes: size,
+            meter: TransferProgressMeter(initialTotal: size)
+        )
+    }
+
+    private mutating func transmit(_ handle: FileHandle, item: InBandTransferItem, modifiedAt: Date?) async -> Outcome {
+        // ZFILE: the name, then length, mtime and mode in octal.
+        let mtime = String(Int64(modifiedAt?.timeIntervalSince1970 ?? 0), radix: 8)
+        let info = Array(item.destinationPath.utf8) + [0] + Array("\(item.totalBytes) \(mtime) 100644".utf8) + [0]
+        var offer: [UInt8] = []
+        encoder.binaryHeader(ZModemHeader(.file, argument: UInt32(ZModem.binaryConversion) << 24), into: &offer)
+        encoder.subpacket(info, end: .crcW, into: &offer)
+
+        var position: Int64 = 0
+        negotiation: while true {
+            guard (try? await write(offer)) != nil else { return .over }
+            while true {
+                guard let reply = await replies.next() else { return .over }
+                guard case .header(let header) = reply else {
+                    if reply == .aborted { return .over }
+                    continue
+                }
+                switch header.type {
+                case .rpos:
+                    position = Int64(header.argument)
+                    break negotiation
+                case .skip:
+                    return .skipped
+                case .rinit, .nak:
+                    // The offer was lost.
+                    continue negotiation
+                default:
+                    continue
+                }
+            }
+        }
+
+        var acked = position
+        var out: [UInt8] = []
+        frame: while true {
+            // Each start, and each restart after ZRPOS, is a new ZDATA frame.
+            do {
+                try handle.seek(toOffset: UInt64(position))
+            } catch {
+                return .failed(error.localizedDescription)
+            }
+            encoder.binaryHeader(ZModemHeader(.data, position: position), into: &out)
+            var subpackets = 0
+            while true {
+                let chunk: Data
+                do {
+                    chunk = try handle.read(upToCount: Self.subpacketLength) ?? Data()
+                } catch {
+                    return .failed(error.localizedDescription)
+                }
+                position += Int64(chunk.count)
+                subpackets += 1
+                let atEnd = chunk.count < Self.subpacketLength
+                let end: ZModem.FrameEnd
+                if atEnd {
+                    end = .crcE
+                } else if receiverInit.bufferSize > 0,
+                          position - acked + Int64(Self.subpacketLength) > Int64(receiverInit.bufferSize) {
+                    // A receiver with a buffer limit is answered frame by frame.
+                    end = .crcW
+                } else {
+                    end = subpackets % Self.subpacketsPerAck == 0 ? .crcQ : .crcG
+                }
+                encoder.subpacket(chunk, end: end, into: &out)
+                if atEnd {
+                    encoder.binaryHeader(ZModemHeader(.eof, position: position), into: &out)
+                }
+                if out.count >= Self.writeSize || atEnd || end == .crcW {
+                    guard (try? await write(out)) != nil else { return .over }
+                    out.removeAll(keepingCapacity: true)
+                    item.meter.record(bytesTransferred: position, totalBytes: 0)
+                }
+
+                // Take the answers so far; wait only at the end of a frame
+                // or with the window full.
+                while true {
+                    let waits = atEnd || end == .crcW || position - acked >= Self.window
+                    let reply: ZModemDecoder.Event
+                    if waits {
+                        guard let next = await replies.next() else { return .over }
+                        reply = next
+                    } else {
+                        guard !replies.isClosed else { return .over }
+                        guard let next = replies.poll() else { break }
+                        reply = next
+                    }
+                    guard case .header(let header) = reply else {
+                        if reply == .aborted { return .over }
+                        continue
+                    }
+                    switch header.type {
+                    case .ack:
+                        acked = max(acked, header.position(near: position))
+                        if end == .crcW, !atEnd {
+                            continue frame
+                        }
+                    case .rpos:
+                        // The receiver lost data: drop what is still queued
+                        // and resend from where it is.
+                        _ = await channel.discardQueuedBulk()
+                        position = header.position(near: acked)
+                        acked = position
+                        out.removeAll(keepingCapacity: true)
+                        continue frame
+                    case .rinit where atEnd:
+                        item.meter.record(bytesTransferred: position, totalBytes: 0)
+                        return .sent
+                    case .skip:
+                        return .skipped
+                    default:
+                        break
+                    }
+                }
+            }
+        }
+    }
+
+    private func write(_ bytes: [UInt8]) async throws {
+        try await channel.send(bytes: bytes, priority: .bulk)
+    }
+}
+
+// MARK: - InBandTransferDemultiplexer
+
+/// Runs in a session's parser reader, in front of its engine. Terminal
+/// output goes to the engine; from a ZMODEM start until the transfer
+/// ends, the bytes go to the transfer instead.
+nonisolated final class InBandTransferDemultiplexer: @unchecked Sendable {
+    private static let logger = Logger(subsystem: "com.prossh", category: "InBandTransfer")
+
+    /// What `rz` is told this side can do: full duplex streaming with
+    /// CRC-32 and no buffer limit.
+    private static let receiverCapabilities = ZModem.canFullDuplex | ZModem.canOverlapIO | ZModem.canCRC32
+    /// Download bytes gathered for each file write.
+    private static let writeSize = 256 * 1024
+
+    private enum Mode {
+        case terminal
+        case receiving
+        case sending
+        /// Cancelled; output still full of transfer data is dropped.
+        case draining
+    }
+
+    private struct Download {
+        let item: InBandTransferItem
+        let handle: FileHandle
+        let modifiedAt: Date?
+        var offset: Int64 = 0
+        var pending: [UInt8] = []
+    }
+
+    let events: AsyncStream<InBandTransferEvent>
+    private let eventSink: AsyncStream<InBandTransferEvent>.Continuation
+    private let channel: any SSHShellChannel
+
+    /// Touched only by the parser reader task.
+    private var mode = Mode.terminal
+    private var detector = ZModemStartDetector()
+    private var decoder = ZModemDecoder()
+    private var download: Download?
+    /// The header whose subpackets are arriving.
+    private var dataFrame: ZModem.FrameType?
+    /// After an error, subpackets are dropped until ZDATA resumes at the
+    /// position asked for.
+    private var discardsData = false
+    /// Set when a session ends with ZFIN: the rest of its hex line, and
+    /// after a download the sender's "OO", are not terminal output.
+    private var skipsSessionTrailer = false
+    private var pendingOverAndOut = 0
+
+    private let lock = NSLock()
+    /// Set while a transfer runs; cancelling outside one sends nothing.
+    private var isActive = false
+    private var cancelRequested = false
+    /// The latest ZRINIT of the `rz` waiting for files.
+    private var receiverInit: ZModemHeader?
+    private var replies: ZModemReplyMailbox?
+
+    init(channel: any SSHShellChannel) {
+        self.channel = channel
+        (events, eventSink) = AsyncStream.makeStream(bufferingPolicy: .unbounded)
+    }
+
+    deinit {
+        eventSink.finish()
+    }
+
+    // MARK: Parser Reader
+
+    /// The ranges of `region` for the engine, or nil when all of it is
+    /// terminal output. Transfer bytes are handled before it returns.
+    func terminalRanges(of region: UnsafeRawBufferPointer) async -> [Range<Int>]? {
+        var match: ZModemStartDetector.Match?
+        if mode == .terminal, !skipsSessionTrailer {
+            match = detector.scan(region)
+            guard match != nil else { return nil }
+        }
+        if mode == .receiving || mode == .sending, takeCancelRequest() {
+            end(failure: "The transfer was cancelled.")
+            mode = .draining
+        }
+
+        var ranges: [Range<Int>] = []
+        var reply: [UInt8] = []
+        var offset = 0
+        while offset < region.count {
+            switch mode {
+            case .terminal:
+                offset = skipSessionTrailer(in: region, from: offset)
+                guard let start = match ?? detector.scan(UnsafeRawBufferPointer(rebasing: region[offset...])) else {
+                    if offset < region.count {
+                        ranges.append(offset..<region.count)
+                    }
+                    offset = region.count
+                    continue
+                }
+                match = nil
+                let startOffset = offset + start.offset
+                if startOffset > offset {
+                    ranges.append(offset..<startOffset)
+                }
+                begin(start.role)
+                if !start.carried.isEmpty {
+                    _ = start.carried.withUnsafeBytes { carried in
+                        process(carried, from: 0, reply: &reply)
+                    }
+                }
+                offset = startOffset
+            case .draining:
+                // Transfer data still in flight has ZDLEs all through it;
+                // the first output without one is the shell again.
+                let rest = UnsafeRawBufferPointer(rebasing: region[offset...])
+                if let base = rest.baseAddress, memchr(base, Int32(ZModem.escape), rest.count) != nil {
+                    offset = region.count
+                } else {
+                    mode = .terminal
+                }
+            case .receiving, .sending:
+                offset = process(region, from: offset, reply: &reply)
+            }
+        }
+        if !reply.isEmpty {
+            try? await channel.send(bytes: reply, priority: .bulk)
+        }
+        return ranges
+    }
+
+    private func takeCancelRequest() -> Bool {
+        lock.withLock {
+            defer { cancelRequested = false }
+            return cancelRequested
+        }
+    }
+
+    private func skipSessionTrailer(in region: UnsafeRawBufferPointer, from start: Int) -> Int {
+        var offset = start
+        while skipsSessionTrailer, offset < region.count {
+            switch region[offset] {
+            case 0x0D, 0x0A, 0x8A, 0x11:
+                offset += 1
+            case 0x4F where pendingOverAndOut > 0:
+                offset += 1
+                pendingOverAndOut -= 1
+                skipsSessionTrailer = pendingOverAndOut > 0
+            default:
+                skipsSessionTrailer = false
+                pendingOverAndOut = 0
+            }
+        }
+        return offset
+    }
+
+    private func begin(_ role: ZModemStartDetector.Role) {
+        mode = role == .receive ? .receiving : .sending
+        decoder = ZModemDecoder()
+        detector.reset()
+        dataFrame = nil
+        discardsData = false
+        lock.withLock {
+            isActive = true
+            cancelRequested = false
+            receiverInit = nil
+        }
+        let direction = role == .receive ? "download" : "upload"
+        Self.logger.info("ZMODEM \(direction, privacy: .public) started")
+    }
+
+    /// Leaves transfer mode. A download still open is reported with
+    /// `failure`; an upload learns from its mailbox closing.
+    private func end(failure: String? = nil) {
+        finishDownload(failure: failure ?? "The transfer ended before the file was complete.")
+        let replies = lock.withLock { () -> ZModemReplyMailbox? in
+            defer { self.replies = nil }
+            isActive = false
+            receiverInit = nil
+            return self.replies
+        }
+        replies?.close()
+        mode = .terminal
+        decoder = ZModemDecoder()
+        detector.reset()
+        dataFrame = nil
+        eventSink.yield(.ended)
+    }
+
+    /// Decodes transfer bytes from `start`; returns where terminal output
+    /// starts again, or the end of `bytes`.
+    private func process(_ bytes: UnsafeRawBufferPointer, from start: Int, reply: inout [UInt8]) -> Int {
+        var offset = start
+        var lastEvent = start
+        while mode == .receiving || mode == .sending,
+              let event = decoder.next(in: bytes, at: &offset) {
+            lastEvent = offset
+            if mode == .receiving {
+                receive(event, reply: &reply)
+            } else {
+                relay(event)
+            }
+        }
+        // Frames stopped coming, so the program exited without ending the
+        // session; what followed the last frame is shell output. A download
+        // allows for the data in flight after asking for a resend.
+        let limit = download == nil ? 1024 : 8 << 20
+        if mode == .receiving || mode == .sending, decoder.bytesSinceFrame > limit {
+            end(failure: "The transfer stopped before the file was complete.")
+            return lastEvent
+        }
+        return offset
+    }
+
+    // MARK: Receiving
+
+    private func receive(_ event: ZModemDecoder.Event, reply: inout [UInt8]) {
+        switch event {
+        case .header(let header):
+            dataFrame = header.type.carriesData ? header.type : nil
+            switch header.type {
+            case .rqinit:
+                reply += ZModemEncoder.hexHeader(.receiverInit(capabilities: Self.receiverCapabilities))
+            case .data:
+                guard let download else {
+                    discardsData = true
+                    return
+                }
+                discardsData = header.position(near: download.offset) != download.offset
+                if discardsData {
+                    reply += ZModemEncoder.hexHeader(ZModemHeader(.rpos, position: download.offset))
+                }
+            case .eof:
+                // A ZEOF short of what arrived is stale; the resend follows.
+                guard let download, header.position(near: download.offset) == download.offset else { return }
+                finishDownload(failure: nil)
+                reply += ZModemEncoder.hexHeader(.receiverInit(capabilities: Self.receiverCapabilities))
+            case .fin:
+                reply += ZModemEncoder.hexHeader(ZModemHeader(.fin))
+                end(failure: "The sender finished before the file was complete.")
+                skipsSessionTrailer = true
+                pendingOverAndOut = ZModem.overAndOut.count
+            default:
+                break
+            }
+        case .subpacket(let frameEnd):
+            switch dataFrame {
+            case .file:
+                if openDownload(decoder.payload) {
+                    reply += ZModemEncoder.hexHeader(ZModemHeader(.rpos, position: 0))
+                } else {
+                    reply += ZModemEncoder.hexHeader(ZModemHeader(.skip))
+                }
+            case .data:
+                guard !discardsData, download != nil else { break }
+                guard append(decoder.payload) else {
+                    reply += ZModem.abortSequence
+                    mode = .draining
+                    return
+                }
+                if frameEnd.wantsAck, let download {
+                    reply += ZModemEncoder.hexHeader(ZModemHeader(.ack, position: download.offset))
+                }
+            case .sinit:
+                reply += ZModemEncoder.hexHeader(ZModemHeader(.ack))
+            case .command:
+                // Remote commands are never run here; report a failure.
+                reply += ZModemEncoder.hexHeader(ZModemHeader(.compl, argument: 1))
+            default:
+                break
+            }
+            if !frameEnd.continuesFrame {
+                dataFrame = nil
+            }
+        case .corrupt:
+            if let download {
+                discardsData = true
+                reply += ZModemEncoder.hexHeader(ZModemHeader(.rpos, position: download.offset))
+            } else {
+                reply += ZModemEncoder.hexHeader(ZModemHeader(.nak))
+            }
+        case .aborted:
+            end(failure: "The sender cancelled the transfer.")
+        }
+    }
+
+    /// Opens the file a ZFILE subpacket offers: its name, then length and
+    /// mtime (octal). False skips it.
+    private func openDownload(_ info: [UInt8]) -> Bool {
+        finishDownload(failure: "The sender moved on before the file was complete.")
+        let fields = info.split(separator: 0, maxSplits: 1, omittingEmptySubsequences: false)
+        let remoteName = String(decoding: fields[0], as: UTF8.self)
+        let attributes = fields.count > 1
+            ? String(decoding: fields[1].prefix { $0 != 0 }, as: UTF8.self).split(separator: " ")
+            : []
+        let size = attributes.first.flatMap { Int64($0) } ?? 0
+        let modifiedAt = attributes.count > 1
+            ? Int64(attributes[1], radix: 8).flatMap { $0 > 0 ? Date(timeIntervalSince1970: TimeInterval($0)) : nil }
+            : nil
+        do {
+            let url = Self.unusedURL(for: Self.localName(remoteName), in: try TransferManager.defaultDownloadDirectory())
+            guard FileManager.default.createFile(atPath: url.path, contents: nil) else {
+                throw CocoaError(.fileWriteUnknown)
+            }
+            let item = InBandTransferItem(
+                id: UUID(),
+                direction: .download,
+                sourcePath: remoteName,
+                destinationPath: url.path,
+                totalBytes: size,
+                meter: TransferProgressMeter(initialTotal: size)
+            )
+            download = Download(item: item, handle: try FileHandle(forWritingTo: url), modifiedAt: modifiedAt)
+            eventSink.yield(.fileStarted(item))
+            return true
+        } catch {
+            Self.logger.error("ZMODEM download not opened: \(error.localizedDescription, privacy: .public)")
+            return false
+        }
+    }
+
+    /// False when the file could not be written; the download is over.
+    private func append(_ bytes: [UInt8]) -> Bool {
+        guard var current = download else { return false }
+        current.pending += bytes
+        current.offset += Int64(bytes.count)
+        if current.pending.count >= Self.writeSize {
+            do {
+                try current.handle.write(contentsOf: current.pending)
+                current.pending.removeAll(keepingCapacity: true)
+            } catch {
+                download = current
+                end(failure: error.localizedDescription)
+                return false
+            }
+        }
+        current.item.meter.record(bytesTransferred: current.offset, totalBytes: 0)
+        download = current
+        return true
+    }
+
+    private func finishDownload(failure: String?) {
+        guard let finished = download else { return }
+        download = nil
+        var failure = failure
+        do {
+            if !finished.pending.isEmpty {
+                try finished.handle.write(contentsOf: finished.pending)
+            }
+            try finished.handle.close()
+        } catch {
+            failure = failure ?? error.localizedDescription
+        }
+        if failure == nil, let modifiedAt = finished.modifiedAt {
+            try? FileManager.default.setAttributes([.modificationDate: modifiedAt], ofItemAtPath: finished.item.destinationPath)
+        }
+        finished.item.meter.record(bytesTransferred: finished.offset, totalBytes: 0)
+        eventSink.yield(.fileFinished(finished.item.id, bytesTransferred: finished.offset, failure: failure))
+    }
+
+    /// The last path component of what the sender calls the file, so it
+    /// cannot write outside the Downloads folder.
+    static func localName(_ remoteName: String) -> String {
+        let name = (remoteName as NSString).lastPathComponent
+        return name.isEmpty || name == "." || name == ".." || name == "/" ? "download" : name
+    }
+
+    /// `name` in `directory`, numbered like Finder's copies if taken.
+    private static func unusedURL(for name: String, in directory: URL) -> URL {
+        let stem = (name as NSString).deletingPathExtension
+        let pathExtension = (name as NSString).pathExtension
+        var url = directory.appendingPathComponent(name)
+        var copy = 2
+        while FileManager.default.fileExists(atPath: url.path) {
+            let numbered = pathExtension.isEmpty ? "\(stem) \(copy)" : "\(stem) \(copy).\(pathExtension)"
+            url = directory.appendingPathComponent(numbered)
+            copy += 1
+        }
+        return url
+    }
+
+    // MARK: Sending
+
+    /// Hands the receiver's answers to the sender, once files are chosen.
+    private func relay(_ event: ZModemDecoder.Event) {
+        let (replies, firstRequest) = lock.withLock { () -> (ZModemReplyMailbox?, Bool) in
+            var firstRequest = false
+            if case .header(let header) = event, header.type == .rinit {
+                firstRequest = receiverInit == nil && self.replies == nil
+                receiverInit = header
+            }
+            return (self.replies, firstRequest)
+        }
+        if firstRequest {
+            eventSink.yield(.filesRequested)
+        }
+        replies?.post(event)
+        switch event {
+        case .header(let header) where header.type == .fin:
+            // The sender answers with "OO"; nothing more comes from `rz`.
+            end()
+            skipsSessionTrailer = true
+        case .aborted:
+            end()
+        default:
+            break
+        }
+    }
+
+    /// Starts sending `files` to the `rz` waiting for them. Does nothing
+    /// once it has gone.
+    func offer(_ files: [URL]) {
+        let replies = ZModemReplyMailbox()
+        let receiverInit = lock.withLock { () -> ZModemHeader? in
+            guard let receiverInit, isActive, self.replies == nil else { return nil }
+            self.replies = replies
+            return receiverInit
+        }
+        guard let receiverInit else { return }
+        let sender = ZModemSender(channel: channel, receiverInit: receiverInit, replies: replies, events: eventSink)
+        Task.detached(priority: .userInitiated) { [weak self] in
+            var sender = sender
+            let finished = await sender.send(files)
+            if !finished {
+                self?.cancel()
+            }
+        }
+    }
+
+    /// Cancels the transfer running, if any: the remote program gets the
+    /// abort sequence, and output still carrying transfer data is dropped.
+    func cancel() {
+        let (cancels, replies) = lock.withLock { () -> (Bool, ZModemReplyMailbox?) in
+            guard isActive, !cancelRequested else { return (false, nil) }
+            cancelRequested = true
+            receiverInit = nil
+            defer { self.replies = nil }
+            return (true, self.replies)
+        }
+        guard cancels else { return }
+        replies?.close()
+        Task { [channel] in
+            _ = await channel.discardQueuedBulk()
+            try? await channel.send(bytes: ZModem.abortSequence, priority: .interactive)
+        }
+    }
+}
+
+// MARK: - InBandTransferCoordinator
+
+@MainActor final class InBandTransferCoordinator {
+    private static let logger = Logger(subsystem: "com.prossh", category: "InBandTransfer")
+
+    weak var manager: SessionManager?
+    /// Shows each file as a row; set by TransferManager.configure.
+    weak var transferManager: TransferManager?
+
+    private var demultiplexersBySessionID: [UUID: InBandTransferDemultiplexer] = [:]
+    private var eventTasksBySessionID: [UUID: Task<Void, Never>] = [:]
+
+    init() {}
+
+    nonisolated deinit {}
+
+    /// The demultiplexer for `sessionID`'s parser reader, when in-band
+    /// transfers are enabled. tmux pane sessions are left out, their input
+    /// goes through `send-keys`, and so is mosh, which keeps only the
+    /// screen state.
+    func demultiplexer(for sessionID: UUID) -> InBandTransferDemultiplexer? {
+        guard let manager, manager.inBandTransfersEnabled,
+              !manager.tmuxCoordinator.isPaneSession(sessionID),
+              let channel = manager.shellChannels[sessionID],
+              !(channel is MoshShellChannel) else { return nil }
+        sessionEnded(sessionID)
+        let demultiplexer = InBandTransferDemultiplexer(channel: channel)
+        demultiplexersBySessionID[sessionID] = demultiplexer
+        eventTasksBySessionID[sessionID] = Task { [weak self, events = demultiplexer.events] in
+            for await event in events {
+                await self?.handle(event, sessionID: sessionID)
+            }
+        }
+        return demultiplexer
+    }
+
+    /// Sends `files` to the `rz` in `sessionID`; an empty list cancels it.
+    func answerUploadRequest(sessionID: UUID, files: [URL]) {
+        manager?.setInBandUploadRequests(manager?.inBandUploadRequests.filter { $0 != sessionID } ?? [])
+        guard let demultiplexer = demultiplexersBySessionID[sessionID] else { return }
+        if files.isEmpty {
+            demultiplexer.cancel()
+        } else {
+            demultiplexer.offer(files)
+        }
+    }
+
+    func cancel(sessionID: UUID) {
+        demultiplexersBySessionID[sessionID]?.cancel()
+    }
+
+    func sessionEnded(_ sessionID: UUID) {
+        demultiplexersBySessionID.removeValue(forKey: sessionID)?.cancel()
+        eventTasksBySessionID.removeValue(forKey: sessionID)?.cancel()
+        if let manager, manager.inBandUploadRequests.contains(sessionID) {
+            manager.setInBandUploadRequests(manager.inBandUploadRequests.filter { $0 != sessionID })
+        }
+    }
+
+    private func handle(_ event: InBandTransferEvent, sessionID: UUID) async {
+        guard let manager else { return }
+        switch event {
+        case .filesRequested:
+            guard !manager.inBandUploadRequests.contains(sessionID) else { return }
+            manager.setInBandUploadRequests(manager.inBandUploadRequests + [sessionID])
+        case .fileStarted(let item):
+            transferManager?.beginInBandTransfer(item, sessionID: sessionID) { [weak self] in
+                self?.cancel(sessionID: sessionID)
+            }
+            let isDownload = item.direction == .download
+            await manager.recordSessionAudit(
+                isDownload ? "ZMODEM download" : "ZMODEM upload",
+                sessionID: sessionID,
+                details: isDownload ? item.sourcePath : item.destinationPath
+            )
+        case .fileFinished(let id, let bytesTransferred, let failure):
+            if let failure {
+                Self.logger.error("ZMODEM transfer failed: \(failure, privacy: .public)")
+            }
+            transferManager?.finishInBandTransfer(id, bytesTransferred: bytesTransferred, failure: failure)
+        case .ended:
+            // `rz` gave up before files were chosen.
+            if manager.inBandUploadRequests.contains(sessionID) {
+                manager.setInBandUploadRequests(manager.inBandUploadRequests.filter { $0 != sessionID })
+            }
+        }
+    }
+}
@@ -0,0 +1,59 @@
+// InputEchoTracker.swift
+// ProSSHV2
+//
+// Low-latency input mode. A typed key used to pass through
+// `sendRawShellInputBytes`, the remote echo, the parser's 4 ms batching
+// window, the 8 ms publish interval and then the next vsync, so a LAN echo
+// landed several frames after the keystroke.
+//
+// With the mode on, each keystroke is stamped here. Output that arrives
+// within `echoWindow` of a keystroke and is no larger than `maxEchoBytes`
+// is treated as its echo. The parser skips the batching sleep, the
+// coordinator publishes at once instead of waiting out the interval, and
+// the stamp travels with the snapshot through the pane's GridSnapshotFeed.
+// The renderer samples keystroke-to-present latency into
+// RendererPerformanceMonitor.
+//
+// Toggle via: `defaults write com.prossh terminal.input.lowLatency.enabled -bool true`
+
+import Foundation
+import QuartzCore
+import Synchronization
+
+// MARK: - InputEchoTracker
+
+/// Last unanswered keystroke of one session, shared by the MainActor input
+/// path and the parser task.
+nonisolated final class InputEchoTracker: Sendable {
+
+    /// How long after a keystroke arriving output counts as its echo.
+    static let echoWindow: CFTimeInterval = 0.050
+
+    /// Largest pending output that still counts as an echo. Anything bigger
+    /// is bulk output and keeps the batching window.
+    static let maxEchoBytes = 512
+
+    /// Bit pattern of the keystroke's `CACurrentMediaTime()`; 0 when none.
+    private let keystrokeBits = Atomic<UInt64>(0)
+
+    /// Stamp a keystroke sent at `time`.
+    func noteKeystroke(at time: CFTimeInterval = CACurrentMediaTime()) {
+        keystrokeBits.store(time.bitPattern, ordering: .releasing)
+    }
+
+    /// Whether `byteCount` bytes of output arriving at `now` answer the
+    /// pending keystroke.
+    func expectsEcho(byteCount: Int, now: CFTimeInterval = CACurrentMediaTime()) -> Bool {
+        guard byteCount <= Self.maxEchoBytes else { return false }
+        let bits = keystrokeBits.load(ordering: .acquiring)
+        guard bits != 0 else { return false }
+        return now - CFTimeInterval(bitPattern: bits) <= Self.echoWindow
+    }
+
+    /// The pending keystroke's time, clearing it so later output is not
+    /// attributed to the same key.
+    func consumeKeystroke() -> CFTimeInterval? {
+        let bits = keystrokeBits.exchange(0, ordering: .acquiringAndReleasing)
+        return bits == 0 ? nil : CFTimeInterval(bitPattern: bits)
+    }
+}
@@ -0,0 +1,87 @@
+import Foundation
+
+/// Hashed timer wheel of per-session keepalive deadlines. Pure value type so the
+/// scheduling is testable without a clock: `SessionKeepaliveScheduler` owns the
+/// wheel and the one task that sleeps until `nextDeadline`.
+///
+/// - Time is in whole ticks (seconds). `slotCount` slots cover one rotation;
+///   a deadline further out waits in its slot until the matching rotation.
+/// - Each session has at most one deadline; scheduling again replaces it.
+/// - Deadlines at or before the current tick are pushed to the next tick, so
+///   `advance(to:)` never misses one.
+nonisolated struct KeepaliveTimerWheel: Sendable {
+
+    let slotCount: Int
+    private(set) var currentTick: Int
+    private var slots: [[UUID]]
+    private var deadlines: [UUID: Int] = [:]
+
+    init(slotCount: Int = 64, startTick: Int = 0) {
+        self.slotCount = max(1, slotCount)
+        self.currentTick = startTick
+        self.slots = Array(repeating: [], count: self.slotCount)
+    }
+
+    var isEmpty: Bool { deadlines.isEmpty }
+
+    var count: Int { deadlines.count }
+
+    func deadline(for id: UUID) -> Int? {
+        deadlines[id]
+    }
+
+    mutating func schedule(_ id: UUID, at tick: Int) {
+        remove(id)
+        let tick = max(tick, currentTick + 1)
+        deadlines[id] = tick
+        slots[slot(for: tick)].append(id)
+    }
+
+    mutating func remove(_ id: UUID) {
+        guard let tick = deadlines.removeValue(forKey: id) else { return }
+        slots[slot(for: tick)].removeAll { $0 == id }
+    }
+
+    /// Moves the wheel to `tick` and returns the sessions whose deadlines were
+    /// passed, earliest first. Their deadlines are removed; reschedule them
+    /// once their keepalive completes.
+    mutating func advance(to tick: Int) -> [UUID] {
+        guard tick > currentTick else { return [] }
+        var due: [(id: UUID, tick: Int)] = []
+        // A jump longer than one rotation still visits every slot only once.
+        for step in 1...min(tick - currentTick, slotCount) {
+            let index = slot(for: currentTick + step)
+            guard !slots[index].isEmpty else { continue }
+            var kept: [UUID] = []
+            for id in slots[index] {
+                guard let deadline = deadlines[id] else { continue }
+                if deadline <= tick {
+                    due.append((id, deadline))
+                    deadlines.removeValue(forKey: id)
+                } else {
+                    kept.append(id)
+                }
+            }
+            slots[index] = kept
+        }
+        currentTick = tick
+        return due.sorted { $0.tick < $1.tick }.map(\.id)
+    }
+
+    /// Earliest pending deadline. Scans at most one rotation of slots; only a
+    /// wheel whose deadlines all lie beyond that falls back to a full search.
+    var nextDeadline: Int? {
+        guard !deadlines.isEmpty else { return nil }
+        for step in 1...slotCount {
+            let tick = currentTick + step
+            if slots[slot(for: tick)].contains(where: { deadlines[$0] == tick }) {
+                return tick
+            }
+        }
+        return deadlines.values.min()
+    }
+
+    private func slot(for tick: Int) -> Int {
+        ((tick % slotCount) + slotCount) % slotCount
+    }
+}
@@ -1,3 +1,17 @@
+// KeyForgeService.swift
+// ProSSHV2
+//
+// Key generation, import, format conversion and ssh-copy-id through the
+// libssh wrapper. The libssh calls are CPU-heavy (RSA-4096 generation,
+// bcrypt_pbkdf when encrypting OpenSSH keys) or block on the network, so
+// they run on `KeyForgeExecutor` and never on the caller's actor. They take
+// and return plain values; `SSHKey` and `StoredSSHKey` are built on the
+// main actor from what they return.
+//
+// The batch APIs run many of these at once, up to a fixed limit, and report
+// progress after each item. Cancelling the calling task stops items that
+// have not started; a libssh call already running is left to finish.
+
 import Foundation
 
 enum ECDSACurve: String, CaseIterable, Identifiable {
@@ -61,7 +75,7 @@ struct KeyConversionResult {
     var passphraseCipher: PrivateKeyCipher?
 }
 
-enum KeyForgeError: LocalizedError {
+nonisolated enum KeyForgeError: LocalizedError {
     case generationFailed(message: String)
     case importFailed(message: String)
     case conversionFailed(message: String)
@@ -81,6 +95,47 @@ enum KeyForgeError: LocalizedError {
     }
 }
 
+/// Completion counts for a KeyForge batch.
+nonisolated struct KeyForgeBatchProgress: Equatable, Sendable {
+    let total: Int
+    var succeeded = 0
+    var failed = 0
+
+    var completed: Int { succeeded + failed }
+
+    var fractionCompleted: Double {
+        total > 0 ? Double(completed) / Double(total) : 1
+    }
+}
+
+/// Runs libssh key work on a concurrent queue of its own.
+nonisolated enum KeyForgeExecutor {
+    private static let queue = DispatchQueue(
+        label: "com.prossh.keyforge",
+        qos: .userInitiated,
+        attributes: .concurrent
+    )
+
+    /// Batch limit for CPU-bound work such as key generation.
+    static var maxConcurrentOperations: Int {
+        max(2, ProcessInfo.processInfo.activeProcessorCount)
+    }
+
+    /// Batch limit for work that holds an SSH connection open.
+    static let maxConcurrentConnections = 8
+
+    /// Run `work` on the KeyForge queue. Throws `CancellationError` without
+    /// running it if the task is already cancelled.
+    static func run<T: Sendable>(_ work: @escaping @Sendable () throws -> T) async throws -> T {
+        try Task.checkCancellation()
+        return try await withCheckedThrowingContinuation { continuation in
+            queue.async {
+                continuation.resume(with: Result { try work() })
+            }
+        }
+    }
+}
+
 @MainActor
 final class KeyForgeService {
     private let secureEnclaveKeyManager: SecureEnclaveKeyManager
@@ -89,21 +144,93 @@ final class KeyForgeService {
         self.secureEnclaveKeyManager = secureEnclaveKeyManager
     }
 
-    func generateKey(request: KeyGenerationRequest) throws -> StoredSSHKey {
+    func generateKey(request: KeyGenerationRequest) async throws -> StoredSSHKey {
         if request.storeInSecureEnclave {
             return try generateSecureEnclaveP256Key(request: request)
         }
 
         let mapping = mapRequest(request)
+        let passphrase = request.normalizedPassphrase
+        let comment = request.comment
+        let material = try await KeyForgeExecutor.run {
+            try Self.nativeGenerateKeypair(mapping, passphrase: passphrase, comment: comment)
+        }
+
+        let metadata = SSHKey(
+            id: UUID(),
+            label: request.label,
+            type: request.keyType,
+            bitLength: mapping.bitLength,
+            fingerprint: material.sha256,
+            fingerprintMD5: material.md5,
+            publicKeyAuthorizedFormat: material.publicKey,
+            storageLocation: .encryptedStorage,
+            format: request.format,
+            isPassphraseProtected: passphrase != nil,
+            passphraseCipher: passphrase != nil ? request.passphraseCipher : nil,
+            comment: request.comment.isEmpty ? nil : request.comment,
+            associatedCertificates: [],
+            createdAt: .now,
+            importedFrom: "Generated on device"
+        )
+
+        return StoredSSHKey(
+            metadata: metadata,
+            privateKey: material.privateKey,
+            publicKey: material.publicKey,
+            secureEnclaveTag: nil
+        )
+    }
+
+    /// Generate several keys at once. Results are in request order.
+    func generateKeys(
+        _ requests: [KeyGenerationRequest],
+        progress: ((KeyForgeBatchProgress) -> Void)? = nil
+    ) async -> [Result<StoredSSHKey, Error>] {
+        await runBatch(requests, limit: KeyForgeExecutor.maxConcurrentOperations, progress: progress) { request in
+            try await self.generateKey(request: request)
+        }
+    }
 
+    /// Replace the key of each host: generate a key from `template`, install
+    /// it with ssh-copy-id and verify key login. Keys are labelled after
+    /// their host. Results are in host order; a failed host gets no key.
+    func rotateKeys(
+        for hosts: [Host],
+        template: KeyGenerationRequest,
+        hostPassword: String,
+        progress: ((KeyForgeBatchProgress) -> Void)? = nil
+    ) async -> [Result<StoredSSHKey, Error>] {
+        await runBatch(hosts, limit: KeyForgeExecutor.maxConcurrentConnections, progress: progress) { host in
+            var request = template
+            request.label = "\(template.label) (\(host.label))"
+            if request.comment.isEmpty || request.comment == template.label {
+                request.comment = "\(host.username)@\(host.hostname)"
+            }
+            let key = try await self.generateKey(request: request)
+            try await self.copyPublicKeyToHost(
+                host: host,
+                storedKey: key,
+                hostPassword: hostPassword,
+                privateKeyPassphrase: request.passphrase
+            )
+            return key
+        }
+    }
+
+    nonisolated private static func nativeGenerateKeypair(
+        _ mapping: KeyParameters,
+        passphrase: String?,
+        comment: String
+    ) throws -> KeyMaterial {
         var privateKeyBuffer = [CChar](repeating: 0, count: 64 * 1024)
         var publicKeyBuffer = [CChar](repeating: 0, count: 8 * 1024)
         var sha256Buffer = [CChar](repeating: 0, count: 256)
         var md5Buffer = [CChar](repeating: 0, count: 256)
         var errorBuffer = [CChar](repeating: 0, count: 512)
 
-        let result = request.comment.withCString { commentPtr in
-            if let passphrase = request.normalizedPassphrase {
+        let result = comment.withCString { commentPtr in
+            if let passphrase {
                 return passphrase.withCString { passphrasePtr in
                     prossh_libssh_generate_keypair(
                         mapping.algorithm,
@@ -153,45 +280,79 @@ final class KeyForgeService {
             )
         }
 
-        let keyID = UUID()
-        let generatedAt = Date.now
-        let publicKey = publicKeyBuffer.asString
-        let privateKey = privateKeyBuffer.asString
-        let sha256 = sha256Buffer.asString
-        let md5 = md5Buffer.asString
+        return KeyMaterial(
+            privateKey: privateKeyBuffer.asString,
+            publicKey: publicKeyBuffer.asString,
+            sha256: sha256Buffer.asString,
+            md5: md5Buffer.asString
+        )
+    }
+
+    func importKey(request: KeyImportRequest) async throws -> StoredSSHKey {
+        let normalizedKeyText = request.keyText.trimmingCharacters(in: .whitespacesAndNewlines)
+        guard !normalizedKeyText.isEmpty else {
+            throw KeyForgeError.importFailed(message: "No key text was provided for import.")
+        }
+
+        let normalizedLabel = request.label?.trimmingCharacters(in: .whitespacesAndNewlines)
+        let normalizedPassphrase = request.passphrase?.trimmingCharacters(in: .whitespacesAndNewlines)
+        let comment = normalizedLabel?.isEmpty == false ? normalizedLabel! : ""
+        let imported = try await KeyForgeExecutor.run {
+            try Self.nativeImportKey(normalizedKeyText, passphrase: normalizedPassphrase, comment: comment)
+        }
+
+        let importedKeyType = try mapImportedKeyType(rawValue: imported.keyType)
+        let importedFormat = mapImportedFormat(rawValue: imported.format)
+        let importedCipher = mapImportedCipher(rawValue: imported.cipher)
+        let resolvedBitLength: Int? = imported.bitLength > 0 ? Int(imported.bitLength) : nil
+
+        let displayLabel: String = {
+            if let normalizedLabel, !normalizedLabel.isEmpty {
+                return normalizedLabel
+            }
+            switch importedKeyType {
+            case .rsa:
+                return resolvedBitLength != nil ? "Imported RSA-\(resolvedBitLength!) Key" : "Imported RSA Key"
+            case .ed25519:
+                return "Imported Ed25519 Key"
+            case .ecdsa:
+                return resolvedBitLength != nil ? "Imported ECDSA P-\(resolvedBitLength!) Key" : "Imported ECDSA Key"
+            case .dsa:
+                return resolvedBitLength != nil ? "Imported DSA-\(resolvedBitLength!) Key" : "Imported DSA Key"
+            }
+        }()
 
         let metadata = SSHKey(
-            id: keyID,
-            label: request.label,
-            type: request.keyType,
-            bitLength: mapping.bitLength,
-            fingerprint: sha256,
-            fingerprintMD5: md5,
-            publicKeyAuthorizedFormat: publicKey,
+            id: UUID(),
+            label: displayLabel,
+            type: importedKeyType,
+            bitLength: resolvedBitLength,
+            fingerprint: imported.material.sha256,
+            fingerprintMD5: imported.material.md5,
+            publicKeyAuthorizedFormat: imported.material.publicKey,
             storageLocation: .encryptedStorage,
-            format: request.format,
-            isPassphraseProtected: request.normalizedPassphrase != nil,
-            passphraseCipher: request.normalizedPassphrase != nil ? request.passphraseCipher : nil,
-            comment: request.comment.isEmpty ? nil : request.comment,
+            format: importedFormat,
+            isPassphraseProtected: imported.isPassphraseProtected,
+            passphraseCipher: imported.isPassphraseProtected ? importedCipher : nil,
+            comment: nil,
             associatedCertificates: [],
-            createdAt: generatedAt,
-            importedFrom: "Generated on device"
+            createdAt: .now,
+            importedFrom: request.source
         )
 
         return StoredSSHKey(
             metadata: metadata,
-            privateKey: privateKey,
-            publicKey: publicKey,
+            privateKey: imported.isPrivateKey ? imported.material.privateKey : "",
+            publicKey: imported.material.publicKey,
             secureEnclaveTag: nil
         )
     }
 
-    func importKey(request: KeyImportRequest) throws -> StoredSSHKey {
-        let normalizedKeyText = request.keyText.trimmingCharacters(in: .whitespacesAndNewlines)
-        guard !normalizedKeyText.isEmpty else {
-            throw KeyForgeError.importFailed(message: "No key text was provided for import.")
-        }
-
+    nonisolated private static func nativeImportKey(
+        _ normalizedKeyText: String,
+        passphrase normalizedPassphrase: String?,
+        comment: String
+    ) throws -> ImportedKeyMaterial {
         var privateKeyBuffer = [CChar](repeating: 0, count: 64 * 1024)
         var publicKeyBuffer = [CChar](repeating: 0, count: 8 * 1024)
         var keyTypeBuffer = [CChar](repeating: 0, count: 64)
@@ -205,11 +366,8 @@ final class KeyForgeService {
         var detectedFormat: Int32 = Int32(PROSSH_PRIVATE_KEY_OPENSSH.rawValue)
         var detectedCipher: Int32 = Int32(PROSSH_PRIVATE_KEY_CIPHER_NONE.rawValue)
 
-        let normalizedLabel = request.label?.trimmingCharacters(in: .whitespacesAndNewlines)
-        let normalizedPassphrase = request.passphrase?.trimmingCharacters(in: .whitespacesAndNewlines)
-
         let result = normalizedKeyText.withCString { keyTextPtr in
-            let commentCString = (normalizedLabel?.isEmpty == false ? normalizedLabel! : "").withCString { commentPtr in
+            let commentCString = comment.withCString { commentPtr in
                 if let passphrase = normalizedPassphrase, !passphrase.isEmpty {
                     return passphrase.withCString { passphrasePtr in
                         prossh_libssh_import_key(
@@ -270,61 +428,23 @@ final class KeyForgeService {
             )
         }
 
-        let importedKeyType = try mapImportedKeyType(rawValue: keyTypeBuffer.asString)
-        let importedFormat = mapImportedFormat(rawValue: detectedFormat)
-        let importedCipher = mapImportedCipher(rawValue: detectedCipher)
-        let resolvedBitLength: Int? = bitLength > 0 ? Int(bitLength) : nil
-
-        let displayLabel: String = {
-            if let normalizedLabel, !normalizedLabel.isEmpty {
-                return normalizedLabel
-            }
-            switch importedKeyType {
-            case .rsa:
-                return resolvedBitLength != nil ? "Imported RSA-\(resolvedBitLength!) Key" : "Imported RSA Key"
-            case .ed25519:
-                return "Imported Ed25519 Key"
-            case .ecdsa:
-                return resolvedBitLength != nil ? "Imported ECDSA P-\(resolvedBitLength!) Key" : "Imported ECDSA Key"
-            case .dsa:
-                return resolvedBitLength != nil ? "Imported DSA-\(resolvedBitLength!) Key" : "Imported DSA Key"
-            }
-        }()
-
-        let publicKey = publicKeyBuffer.asString
-        let privateKey = privateKeyBuffer.asString
-        let sha256 = sha256Buffer.asString
-        let md5 = md5Buffer.asString
-        let keyID = UUID()
-        let importedAt = Date.now
-
-        let metadata = SSHKey(
-            id: keyID,
-            label: displayLabel,
-            type: importedKeyType,
-            bitLength: resolvedBitLength,
-            fingerprint: sha256,
-            fingerprintMD5: md5,
-            publicKeyAuthorizedFormat: publicKey,
-            storageLocation: .encryptedStorage,
-            format: importedFormat,
+        return ImportedKeyMaterial(
+            material: KeyMaterial(
+                privateKey: privateKeyBuffer.asString,
+                publicKey: publicKeyBuffer.asString,
+                sha256: sha256Buffer.asString,
+                md5: md5Buffer.asString
+            ),
+            keyType: keyTypeBuffer.asString,
+            bitLength: bitLength,
+            isPrivateKey: isPrivateKey != 0,
             isPassphraseProtected: isPassphraseProtected != 0,
-            passphraseCipher: isPassphraseProtected != 0 ? importedCipher : nil,
-            comment: nil,
-            associatedCertificates: [],
-            createdAt: importedAt,
-            importedFrom: request.source
-        )
-
-        return StoredSSHKey(
-            metadata: metadata,
-            privateKey: isPrivateKey != 0 ? privateKey : "",
-            publicKey: publicKey,
-            secureEnclaveTag: nil
+            format: detectedFormat,
+            cipher: detectedCipher
         )
     }
 
-    func convertPrivateKey(request: KeyConversionRequest) throws -> KeyConversionResult {
+    func convertPrivateKey(request: KeyConversionRequest) async throws -> KeyConversionResult {
         let normalizedPrivateKey = request.privateKeyText.trimmingCharacters(in: .whitespacesAndNewlines)
         guard !normalizedPrivateKey.isEmpty else {
             throw KeyForgeError.conversionFailed(message: "No private key material is available for conversion.")
@@ -335,7 +455,42 @@ final class KeyForgeService {
         let normalizedOutputPassphrase = request.outputPassphrase?
             .trimmingCharacters(in: .whitespacesAndNewlines)
         let normalizedComment = request.comment.trimmingCharacters(in: .whitespacesAndNewlines)
+        let outputFormat = mapPrivateKeyFormat(request.targetFormat)
+        let outputCipher = mapPrivateKeyCipher(request.outputPassphraseCipher)
+
+        let converted = try await KeyForgeExecutor.run {
+            try Self.nativeConvertPrivateKey(
+                normalizedPrivateKey,
+                inputPassphrase: normalizedInputPassphrase,
+                outputFormat: outputFormat,
+                outputPassphrase: normalizedOutputPassphrase,
+                outputCipher: outputCipher,
+                comment: normalizedComment
+            )
+        }
+
+        let resolvedCipher = converted.isPassphraseProtected
+            ? mapImportedCipher(rawValue: converted.cipher)
+            : nil
+
+        return KeyConversionResult(
+            privateKey: converted.material.privateKey,
+            publicKey: converted.material.publicKey,
+            fingerprintSHA256: converted.material.sha256,
+            fingerprintMD5: converted.material.md5,
+            isPassphraseProtected: converted.isPassphraseProtected,
+            passphraseCipher: resolvedCipher
+        )
+    }
 
+    nonisolated private static func nativeConvertPrivateKey(
+        _ normalizedPrivateKey: String,
+        inputPassphrase normalizedInputPassphrase: String?,
+        outputFormat: ProSSHPrivateKeyFormat,
+        outputPassphrase normalizedOutputPassphrase: String?,
+        outputCipher: ProSSHPrivateKeyCipher,
+        comment normalizedComment: String
+    ) throws -> ConvertedKeyMaterial {
         var privateKeyBuffer = [CChar](repeating: 0, count: 64 * 1024)
         var publicKeyBuffer = [CChar](repeating: 0, count: 8 * 1024)
         var sha256Buffer = [CChar](repeating: 0, count: 256)
@@ -345,9 +500,6 @@ final class KeyForgeService {
         var outputIsPassphraseProtected: Int32 = 0
         var outputCipherRaw: Int32 = Int32(PROSSH_PRIVATE_KEY_CIPHER_NONE.rawValue)
 
-        let outputFormat = mapPrivateKeyFormat(request.targetFormat)
-        let outputCipher = mapPrivateKeyCipher(request.outputPassphraseCipher)
-
         let result = normalizedPrivateKey.withCString { privateKeyPtr in
             normalizedComment.withCString { commentPtr in
                 if let inputPassphrase = normalizedInputPassphrase, !inputPassphrase.isEmpty {
@@ -455,17 +607,15 @@ final class KeyForgeService {
             )
         }
 
-        let resolvedCipher = outputIsPassphraseProtected != 0
-            ? mapImportedCipher(rawValue: outputCipherRaw)
-            : nil
-
-        return KeyConversionResult(
-            privateKey: privateKeyBuffer.asString,
-            publicKey: publicKeyBuffer.asString,
-            fingerprintSHA256: sha256Buffer.asString,
-            fingerprintMD5: md5Buffer.asString,
+        return ConvertedKeyMaterial(
+            material: KeyMaterial(
+                privateKey: privateKeyBuffer.asString,
+                publicKey: publicKeyBuffer.asString,
+                sha256: sha256Buffer.asString,
+                md5: md5Buffer.asString
+            ),
             isPassphraseProtected: outputIsPassphraseProtected != 0,
-            passphraseCipher: resolvedCipher
+            cipher: outputCipherRaw
         )
     }
 
@@ -474,7 +624,7 @@ final class KeyForgeService {
         storedKey: StoredSSHKey,
         hostPassword: String,
         privateKeyPassphrase: String?
-    ) throws {
+    ) async throws {
         let normalizedPublicKey = storedKey.publicKey.trimmingCharacters(in: .whitespacesAndNewlines)
         guard !normalizedPublicKey.isEmpty else {
             throw KeyForgeError.copyIDFailed(message: "No public key is available for ssh-copy-id.")
@@ -498,20 +648,69 @@ final class KeyForgeService {
         let policies: [SSHAlgorithmPolicy] = host.legacyModeEnabled
             ? [.modern, .legacy]
             : [.modern]
+        let pinnedHostKeys = host.pinnedHostKeyAlgorithms
+        let algorithms = policies.map { policy in
+            CopyIDAlgorithms(
+                keyExchange: policy.keyExchange.joined(separator: ","),
+                ciphers: policy.ciphers.joined(separator: ","),
+                hostKeys: (pinnedHostKeys.isEmpty ? policy.hostKeys : pinnedHostKeys).joined(separator: ","),
+                macs: policy.macs.joined(separator: ",")
+            )
+        }
+        let target = CopyIDTarget(hostname: host.hostname, port: host.port, username: host.username)
+
+        try await KeyForgeExecutor.run {
+            try Self.nativeCopyPublicKey(
+                to: target,
+                algorithms: algorithms,
+                password: normalizedHostPassword,
+                publicKey: normalizedPublicKey,
+                privateKey: normalizedPrivateKey,
+                privateKeyPassphrase: normalizedPrivateKeyPassphrase
+            )
+        }
+    }
 
+    /// Install `storedKey` on every host in `hosts`, several at a time.
+    /// Results are in host order.
+    func copyPublicKey(
+        _ storedKey: StoredSSHKey,
+        toHosts hosts: [Host],
+        hostPassword: String,
+        privateKeyPassphrase: String?,
+        progress: ((KeyForgeBatchProgress) -> Void)? = nil
+    ) async -> [Result<Void, Error>] {
+        await runBatch(hosts, limit: KeyForgeExecutor.maxConcurrentConnections, progress: progress) { host in
+            try await self.copyPublicKeyToHost(
+                host: host,
+                storedKey: storedKey,
+                hostPassword: hostPassword,
+                privateKeyPassphrase: privateKeyPassphrase
+            )
+        }
+    }
+
+    /// Try each algorithm set in turn until one installs and verifies the key.
+    nonisolated private static func nativeCopyPublicKey(
+        to target: CopyIDTarget,
+        algorithms: [CopyIDAlgorithms],
+        password normalizedHostPassword: String,
+        publicKey normalizedPublicKey: String,
+        privateKey normalizedPrivateKey: String,
+        privateKeyPassphrase normalizedPrivateKeyPassphrase: String?
+    ) throws {
         var lastErrorMessage = "ssh-copy-id failed."
 
-        for policy in policies {
-            let keyExchange = policy.keyExchange.joined(separator: ",")
-            let ciphers = policy.ciphers.joined(separator: ",")
-            let selectedHostKeys = host.pinnedHostKeyAlgorithms.isEmpty ? policy.hostKeys : host.pinnedHostKeyAlgorithms
-            let hostKeys = selectedHostKeys.joined(separator: ",")
-            let macs = policy.macs.joined(separator: ",")
+        for algorithm in algorithms {
+            let keyExchange = algorithm.keyExchange
+            let ciphers = algorithm.ciphers
+            let hostKeys = algorithm.hostKeys
+            let macs = algorithm.macs
 
             var errorBuffer = [CChar](repeating: 0, count: 512)
 
-            let result = host.hostname.withCString { hostnamePtr in
-                host.username.withCString { usernamePtr in
+            let result = target.hostname.withCString { hostnamePtr in
+                target.username.withCString { usernamePtr in
                     normalizedHostPassword.withCString { passwordPtr in
                         normalizedPublicKey.withCString { publicKeyPtr in
                             normalizedPrivateKey.withCString { privateKeyPtr in
@@ -524,7 +723,7 @@ final class KeyForgeService {
                                                     return normalizedPrivateKeyPassphrase.withCString { privateKeyPassphrasePtr in
                                                         prossh_libssh_copy_public_key_to_host(
                                                             hostnamePtr,
-                                                            host.port,
+                                                            target.port,
                                                             usernamePtr,
                                                             passwordPtr,
                                                             publicKeyPtr,
@@ -543,7 +742,7 @@ final class KeyForgeService {
 
                                                 return prossh_libssh_copy_public_key_to_host(
                                                     hostnamePtr,
-                                                    host.port,
+                                                    target.port,
                                                     usernamePtr,
                                                     passwordPtr,
                                                     publicKeyPtr,
@@ -589,19 +788,64 @@ final class KeyForgeService {
         secureEnclaveKeyManager.deleteP256Key(tag: secureEnclaveTag)
     }
 
-    private func mapRequest(_ request: KeyGenerationRequest) -> (
-        algorithm: ProSSHKeyAlgorithm,
-        parameter: Int32,
-        format: ProSSHPrivateKeyFormat,
-        privateKeyCipher: ProSSHPrivateKeyCipher,
-        bitLength: Int
-    ) {
+    // MARK: - Batches
+
+    /// Run `work` for each input, at most `limit` at a time, reporting
+    /// progress after each one. Inputs that never ran because the task was
+    /// cancelled fail with `CancellationError`.
+    private func runBatch<Input: Sendable, Output: Sendable>(
+        _ inputs: [Input],
+        limit: Int,
+        progress: ((KeyForgeBatchProgress) -> Void)?,
+        work: @escaping @MainActor (Input) async throws -> Output
+    ) async -> [Result<Output, Error>] {
+        var results = [Result<Output, Error>?](repeating: nil, count: inputs.count)
+        var status = KeyForgeBatchProgress(total: inputs.count)
+
+        await withTaskGroup(of: (Int, Result<Output, Error>).self) { group in
+            var next = 0
+            func addNext() {
+                let index = next
+                let input = inputs[index]
+                next += 1
+                group.addTask { @MainActor in
+                    do {
+                        return (index, .success(try await work(input)))
+                    } catch {
+                        return (index, .failure(error))
+                    }
+                }
+            }
+
+            while next < min(max(1, limit), inputs.count) {
+                addNext()
+            }
+            while let (index, result) = await group.next() {
+                results[index] = result
+                if case .success = result {
+                    status.succeeded += 1
+                } else {
+                    status.failed += 1
+                }
+                progress?(status)
+                if next < inputs.count, !Task.isCancelled {
+                    addNext()
+                }
+            }
+        }
+
+        return results.map { $0 ?? .failure(CancellationError()) }
+    }
+
+    // MARK: - Mapping
+
+    private func mapRequest(_ request: KeyGenerationRequest) -> KeyParameters {
         let format = mapPrivateKeyFormat(request.format)
         let cipher = mapPrivateKeyCipher(request.passphraseCipher)
 
         switch request.keyType {
         case .rsa:
-            return (
+            return KeyParameters(
                 algorithm: PROSSH_KEY_RSA,
                 parameter: Int32(request.rsaBits),
                 format: format,
@@ -609,7 +853,7 @@ final class KeyForgeService {
                 bitLength: request.rsaBits
             )
         case .ed25519:
-            return (
+            return KeyParameters(
                 algorithm: PROSSH_KEY_ED25519,
                 parameter: 0,
                 format: format,
@@ -619,7 +863,7 @@ final class KeyForgeService {
         case .ecdsa:
             switch request.ecdsaCurve {
             case .p256:
-                return (
+                return KeyParameters(
                     algorithm: PROSSH_KEY_ECDSA_P256,
                     parameter: 0,
                     format: format,
@@ -627,7 +871,7 @@ final class KeyForgeService {
                     bitLength: request.ecdsaCurve.bitLength
                 )
             case .p384:
-                return (
+                return KeyParameters(
                     algorithm: PROSSH_KEY_ECDSA_P384,
                     parameter: 0,
                     format: format,
@@ -635,7 +879,7 @@ final class KeyForgeService {
                     bitLength: request.ecdsaCurve.bitLength
                 )
             case .p521:
-                return (
+                return KeyParameters(
                     algorithm: PROSSH_KEY_ECDSA_P521,
                     parameter: 0,
                     format: format,
@@ -644,7 +888,7 @@ final class KeyForgeService {
                 )
             }
         case .dsa:
-            return (
+            return KeyParameters(
                 algorithm: PROSSH_KEY_DSA,
                 parameter: 1024,
                 format: format,
@@ -764,6 +1008,54 @@ final class KeyForgeService {
     }
 }
 
+// MARK: - libssh Values
+
+/// Plain inputs and outputs of the libssh calls, so they can cross to the
+/// KeyForge executor.
+nonisolated private struct KeyParameters: Sendable {
+    var algorithm: ProSSHKeyAlgorithm
+    var parameter: Int32
+    var format: ProSSHPrivateKeyFormat
+    var privateKeyCipher: ProSSHPrivateKeyCipher
+    var bitLength: Int
+}
+
+nonisolated private struct KeyMaterial: Sendable {
+    var privateKey: String
+    var publicKey: String
+    var sha256: String
+    var md5: String
+}
+
+nonisolated private struct ImportedKeyMaterial: Sendable {
+    var material: KeyMaterial
+    var keyType: String
+    var bitLength: Int32
+    var isPrivateKey: Bool
+    var isPassphraseProtected: Bool
+    var format: Int32
+    var cipher: Int32
+}
+
+nonisolated private struct ConvertedKeyMaterial: Sendable {
+    var material: KeyMaterial
+    var isPassphraseProtected: Bool
+    var cipher: Int32
+}
+
+nonisolated private struct CopyIDTarget: Sendable {
+    var hostname: String
+    var port: UInt16
+    var username: String
+}
+
+nonisolated private struct CopyIDAlgorithms: Sendable {
+    var keyExchange: String
+    var ciphers: String
+    var hostKeys: String
+    var macs: String
+}
+
 private extension KeyGenerationRequest {
     var normalizedPassphrase: String? {
         guard let passphrase else { return nil }
@@ -1,6 +1,30 @@
+// KnownHostsStore.swift
+// ProSSHV2
+//
+// Trusted host keys. Entries are kept in memory, indexed by host, port and
+// key type, so verifying a connection is a dictionary lookup instead of
+// decrypting and scanning the whole file. Changes are appended to an
+// encrypted log rather than rewriting every entry.
+//
+// Layout, in Application Support/ProSSHV2/known_hosts.log:
+//   magic "PSSHKHS1", 32-byte key salt, then records:
+//   UInt32 length (little-endian) + AES-GCM sealed JSON of one change
+//
+// A change either trusts an entry (replacing one with the same host, port
+// and key type), adds a hashed OpenSSH entry, or marks a hashed entry as
+// resolved to a plain one. The log is read once per launch. Once it holds
+// more than twice as many records as live entries it is rewritten with
+// just the live ones. A torn record at the end (from a crash mid-write) is
+// cut off. The old known_hosts.json array is imported once and removed.
+//
+// Hashed OpenSSH entries are checked only for hosts with no plain entry;
+// a match is stored as a plain entry so later lookups hit the index.
+
+import CryptoKit
 import Foundation
+import os.log
 
-struct KnownHostEntry: Identifiable, Codable, Hashable, Sendable {
+nonisolated struct KnownHostEntry: Identifiable, Codable, Hashable, Sendable {
     var hostname: String
     var port: UInt16
     var hostKeyType: String
@@ -13,7 +37,7 @@ struct KnownHostEntry: Identifiable, Codable, Hashable, Sendable {
     }
 }
 
-struct KnownHostVerificationChallenge: Identifiable, Equatable, Sendable {
+nonisolated struct KnownHostVerificationChallenge: Identifiable, Equatable, Sendable {
     var hostname: String
     var port: UInt16
     var hostKeyType: String
@@ -30,7 +54,7 @@ struct KnownHostVerificationChallenge: Identifiable, Equatable, Sendable {
     }
 }
 
-enum KnownHostVerificationResult: Sendable {
+nonisolated enum KnownHostVerificationResult: Sendable {
     case trusted
     case requiresUserApproval(KnownHostVerificationChallenge)
 }
@@ -45,20 +69,110 @@ protocol KnownHostsStoreProtocol: Sendable {
     ) async throws -> KnownHostVerificationResult
     func trust(challenge: KnownHostVerificationChallenge) async throws
     func clearAll() async throws
+    /// Read whatever `evaluate` would read first, ahead of the first
+    /// connection.
+    func preload() async throws
+    /// The trusted fingerprint for a host, from its most recently verified
+    /// key type.
+    func fingerprint(hostname: String, port: UInt16) async throws -> String?
+    func importOpenSSHKnownHosts(_ contents: String) async throws -> KnownHostsImportResult
+}
+
+nonisolated struct KnownHostsImportResult: Equatable, Sendable {
+    var imported = 0
+    var hashed = 0
+    /// Unusable lines and entries that conflict with or repeat trusted ones.
+    var skipped = 0
+}
+
+extension KnownHostsStoreProtocol {
+    func preload() async throws {}
+
+    func fingerprint(hostname: String, port: UInt16) async throws -> String? {
+        let normalizedHostname = hostname.lowercased()
+        return try await allEntries()
+            .filter { $0.hostname.lowercased() == normalizedHostname && $0.port == port }
+            .max { $0.lastVerifiedAt < $1.lastVerifiedAt }?
+            .fingerprint
+    }
+
+    /// Trusts each plain entry; stores without hashed-entry support skip
+    /// those.
+    func importOpenSSHKnownHosts(_ contents: String) async throws -> KnownHostsImportResult {
+        let parsed = OpenSSHKnownHostsParser().parse(contents)
+        for entry in parsed.entries {
+            try await trust(challenge: KnownHostVerificationChallenge(
+                hostname: entry.hostname,
+                port: entry.port,
+                hostKeyType: entry.hostKeyType,
+                presentedFingerprint: entry.fingerprint,
+                expectedFingerprint: nil
+            ))
+        }
+        return KnownHostsImportResult(
+            imported: parsed.entries.count,
+            hashed: 0,
+            skipped: parsed.skippedLines + parsed.hashedEntries.count
+        )
+    }
 }
 
 actor FileKnownHostsStore: KnownHostsStoreProtocol {
+
+    /// Minimum time between persisted `lastVerifiedAt` updates of an entry,
+    /// so routine connections do not append a record each.
+    static let verificationWriteInterval: TimeInterval = 60 * 60
+    /// Records tolerated before compaction is considered.
+    static let compactionMinimumRecords = 1_024
+
+    private nonisolated enum LogRecord: Codable {
+        case trusted(KnownHostEntry)
+        case hashed(HashedKnownHostEntry)
+        case resolved(hashedID: String)
+    }
+
+    private static let magic = Data("PSSHKHS1".utf8)
+    private static let saltSize = 32
+    private static var headerSize: Int { magic.count + saltSize }
+    private static let logger = Logger(subsystem: "com.prossh", category: "KnownHosts")
+
     nonisolated(unsafe) private let fileManager: FileManager
     private let fileURL: URL
+    private let legacyFileURL: URL
+    private let makeKey: @Sendable (Data) throws -> SymmetricKey
+
+    /// "hostname:port" (lowercased) -> key type -> entry.
+    private var entries: [String: [String: KnownHostEntry]] = [:]
+    private var hashedEntries: [String: HashedKnownHostEntry] = [:]
+    private var key: SymmetricKey?
+    private var handle: FileHandle?
+    private var fileLength = 0
+    private var recordCount = 0
+    private var isLoaded = false
 
-    init(fileManager: FileManager = .default) {
+    /// A store in `baseDirectory` (Application Support/ProSSHV2 by default).
+    /// `makeKey` derives the log's key from the salt in its header.
+    init(
+        fileManager: FileManager = .default,
+        baseDirectory: URL? = nil,
+        makeKey: @escaping @Sendable (Data) throws -> SymmetricKey = { salt in
+            try EncryptedStorage.derivedKey(purpose: "known-hosts-v1", salt: salt)
+        }
+    ) {
+        let baseDirectory = baseDirectory ?? Self.defaultBaseDirectory(fileManager: fileManager)
         self.fileManager = fileManager
-        self.fileURL = Self.defaultFileURL(fileManager: fileManager)
+        self.fileURL = baseDirectory.appendingPathComponent("known_hosts.log")
+        self.legacyFileURL = baseDirectory.appendingPathComponent("known_hosts.json")
+        self.makeKey = makeKey
     }
 
     func allEntries() throws -> [KnownHostEntry] {
-        try loadEntries().sorted {
-            $0.hostname.localizedCaseInsensitiveCompare($1.hostname) == .orderedAscending
+        try loadIfNeeded()
+        return entries.values.flatMap(\.values).sorted {
+            let order = $0.hostname.localizedCaseInsensitiveCompare($1.hostname)
+            if order != .orderedSame { return order == .orderedAscending }
+            if $0.port != $1.port { return $0.port < $1.port }
+            return $0.hostKeyType < $1.hostKeyType
         }
     }
 
@@ -68,12 +182,13 @@ actor FileKnownHostsStore: KnownHostsStoreProtocol {
         hostKeyType: String,
         presentedFingerprint: String
     ) throws -> KnownHostVerificationResult {
-        let normalizedHostname = hostname.lowercased()
-        var entries = try loadEntries()
+        try loadIfNeeded()
+        let address = Self.address(hostname, port)
+        if entries[address] == nil {
+            try resolveHashedEntries(hostname: hostname, port: port)
+        }
 
-        guard let index = entries.firstIndex(where: {
-            $0.hostname.lowercased() == normalizedHostname && $0.port == port
-        }) else {
+        guard let known = entries[address], !known.isEmpty else {
             return .requiresUserApproval(
                 KnownHostVerificationChallenge(
                     hostname: hostname,
@@ -85,89 +200,300 @@ actor FileKnownHostsStore: KnownHostsStoreProtocol {
             )
         }
 
-        let existing = entries[index]
-        guard existing.fingerprint == presentedFingerprint else {
+        // A key type the host was never trusted with is treated like a
+        // changed key, against the most recently verified one.
+        guard var existing = known[hostKeyType], existing.fingerprint == presentedFingerprint else {
+            let expected = known[hostKeyType]
+                ?? known.values.max { $0.lastVerifiedAt < $1.lastVerifiedAt }
             return .requiresUserApproval(
                 KnownHostVerificationChallenge(
                     hostname: hostname,
                     port: port,
                     hostKeyType: hostKeyType,
                     presentedFingerprint: presentedFingerprint,
-                    expectedFingerprint: existing.fingerprint
+                    expectedFingerprint: expected?.fingerprint
                 )
             )
         }
 
-        entries[index].hostKeyType = hostKeyType
-        entries[index].lastVerifiedAt = .now
-        try persist(entries)
+        let now = Date.now
+        if now.timeIntervalSince(existing.lastVerifiedAt) >= Self.verificationWriteInterval {
+            existing.lastVerifiedAt = now
+            try record([.trusted(existing)])
+        }
         return .trusted
     }
 
     func trust(challenge: KnownHostVerificationChallenge) throws {
-        var entries = try loadEntries()
-        let normalizedHostname = challenge.hostname.lowercased()
+        try loadIfNeeded()
         let now = Date.now
+        let existing = entries[Self.address(challenge.hostname, challenge.port)]?[challenge.hostKeyType]
+        let entry = KnownHostEntry(
+            hostname: existing?.hostname ?? challenge.hostname,
+            port: challenge.port,
+            hostKeyType: challenge.hostKeyType,
+            fingerprint: challenge.presentedFingerprint,
+            firstTrustedAt: existing?.firstTrustedAt ?? now,
+            lastVerifiedAt: now
+        )
+        try record([.trusted(entry)])
+    }
 
-        if let index = entries.firstIndex(where: {
-            $0.hostname.lowercased() == normalizedHostname && $0.port == challenge.port
-        }) {
-            entries[index].hostKeyType = challenge.hostKeyType
-            entries[index].fingerprint = challenge.presentedFingerprint
-            entries[index].lastVerifiedAt = now
-        } else {
-            entries.append(
-                KnownHostEntry(
-                    hostname: challenge.hostname,
-                    port: challenge.port,
-                    hostKeyType: challenge.hostKeyType,
-                    fingerprint: challenge.presentedFingerprint,
-                    firstTrustedAt: now,
-                    lastVerifiedAt: now
-                )
-            )
+    /// Decrypts and indexes the log, so the first `evaluate` is a lookup.
+    func preload() throws {
+        try loadIfNeeded()
+    }
+
+    func clearAll() throws {
+        try loadIfNeeded()
+        try? handle?.close()
+        handle = nil
+        key = nil
+        if fileManager.fileExists(atPath: fileURL.path(percentEncoded: false)) {
+            try fileManager.removeItem(at: fileURL)
+        }
+        entries = [:]
+        hashedEntries = [:]
+        fileLength = 0
+        recordCount = 0
+    }
+
+    func fingerprint(hostname: String, port: UInt16) throws -> String? {
+        try loadIfNeeded()
+        let address = Self.address(hostname, port)
+        if entries[address] == nil {
+            try resolveHashedEntries(hostname: hostname, port: port)
         }
+        return entries[address]?.values.max { $0.lastVerifiedAt < $1.lastVerifiedAt }?.fingerprint
+    }
 
-        try persist(entries)
+    /// Import an OpenSSH known_hosts file. Entries already trusted here win
+    /// over imported ones with a different key.
+    func importOpenSSHKnownHosts(_ contents: String) throws -> KnownHostsImportResult {
+        try loadIfNeeded()
+        let parsed = OpenSSHKnownHostsParser().parse(contents)
+        var result = KnownHostsImportResult(skipped: parsed.skippedLines)
+        var records: [LogRecord] = []
+        var added = Set<String>()
+
+        for entry in parsed.entries {
+            let address = Self.address(entry.hostname, entry.port)
+            guard entries[address]?[entry.hostKeyType] == nil, added.insert(entry.id).inserted else {
+                result.skipped += 1
+                continue
+            }
+            records.append(.trusted(entry))
+            result.imported += 1
+        }
+        for hashed in parsed.hashedEntries {
+            guard hashedEntries[hashed.id] == nil, added.insert(hashed.id).inserted else {
+                result.skipped += 1
+                continue
+            }
+            records.append(.hashed(hashed))
+            result.hashed += 1
+        }
+        try record(records)
+        return result
     }
 
-    func clearAll() throws {
-        try persist([])
+    // MARK: - Index
+
+    private static func address(_ hostname: String, _ port: UInt16) -> String {
+        "\(hostname.lowercased()):\(port)"
     }
 
-    private func loadEntries() throws -> [KnownHostEntry] {
-        if !fileManager.fileExists(atPath: fileURL.path(percentEncoded: false)) {
-            return []
+    private func apply(_ record: LogRecord) {
+        switch record {
+        case let .trusted(entry):
+            entries[Self.address(entry.hostname, entry.port), default: [:]][entry.hostKeyType] = entry
+        case let .hashed(hashed):
+            hashedEntries[hashed.id] = hashed
+        case let .resolved(hashedID):
+            hashedEntries[hashedID] = nil
         }
+    }
 
-        let decoder = JSONDecoder()
-        decoder.dateDecodingStrategy = .iso8601
-        return try EncryptedStorage.loadJSON(
+    /// Turn hashed entries made from this host into plain ones.
+    private func resolveHashedEntries(hostname: String, port: UInt16) throws {
+        guard !hashedEntries.isEmpty else { return }
+        let matches = hashedEntries.values.filter { $0.matches(hostname: hostname, port: port) }
+        guard !matches.isEmpty else { return }
+        let now = Date.now
+        var records: [LogRecord] = []
+        for hashed in matches where entries[Self.address(hostname, port)]?[hashed.hostKeyType] == nil {
+            records.append(.trusted(KnownHostEntry(
+                hostname: hostname,
+                port: port,
+                hostKeyType: hashed.hostKeyType,
+                fingerprint: hashed.fingerprint,
+                firstTrustedAt: now,
+                lastVerifiedAt: now
+            )))
+        }
+        records.append(contentsOf: matches.map { .resolved(hashedID: $0.id) })
+        try record(records)
+    }
+
+    // MARK: - Log
+
+    /// Apply changes and append them to the log in one write.
+    private func record(_ records: [LogRecord]) throws {
+        guard !records.isEmpty else { return }
+        if handle == nil {
+            try startLog()
+        }
+        guard let handle, let key else { return }
+
+        let encoder = Self.makeEncoder()
+        var frames = Data()
+        for record in records {
+            try Self.appendFrame(for: record, to: &frames, key: key, encoder: encoder)
+        }
+        try handle.seek(toOffset: UInt64(fileLength))
+        try handle.write(contentsOf: frames)
+        for record in records {
+            apply(record)
+        }
+        fileLength += frames.count
+        recordCount += records.count
+        try compactIfNeeded()
+    }
+
+    private func startLog() throws {
+        try fileManager.createDirectory(at: fileURL.deletingLastPathComponent(), withIntermediateDirectories: true)
+        let salt = SymmetricKey(size: .bits256).withUnsafeBytes { Data($0) }
+        var header = Self.magic
+        header.append(salt)
+        guard fileManager.createFile(
+            atPath: fileURL.path(percentEncoded: false),
+            contents: header,
+            attributes: [.posixPermissions: 0o600, .protectionKey: FileProtectionType.complete]
+        ) else {
+            throw CocoaError(.fileWriteUnknown)
+        }
+        key = try makeKey(salt)
+        handle = try FileHandle(forUpdating: fileURL)
+        fileLength = header.count
+        recordCount = 0
+    }
+
+    /// Rewrite the log with only live entries once superseded records
+    /// outnumber them.
+    private func compactIfNeeded() throws {
+        guard recordCount > Self.compactionMinimumRecords else { return }
+        let live = entries.values.reduce(hashedEntries.count) { $0 + $1.count }
+        guard recordCount > 2 * live else { return }
+
+        let salt = SymmetricKey(size: .bits256).withUnsafeBytes { Data($0) }
+        let newKey = try makeKey(salt)
+        let encoder = Self.makeEncoder()
+        var file = Self.magic
+        file.append(salt)
+        for entry in entries.values.flatMap(\.values) {
+            try Self.appendFrame(for: .trusted(entry), to: &file, key: newKey, encoder: encoder)
+        }
+        for hashed in hashedEntries.values {
+            try Self.appendFrame(for: .hashed(hashed), to: &file, key: newKey, encoder: encoder)
+        }
+
+        try? handle?.close()
+        handle = nil
+        let traceStart = TraceRecorder.shared.begin()
+        defer { TraceRecorder.shared.end(.storeWrite, since: traceStart, value: Int64(file.count)) }
+        try file.write(to: fileURL, options: .atomic)
+        try fileManager.setAttributes([.posixPermissions: 0o600], ofItemAtPath: fileURL.path(percentEncoded: false))
+        key = newKey
+        handle = try FileHandle(forUpdating: fileURL)
+        fileLength = file.count
+        recordCount = live
+    }
+
+    private static func appendFrame(
+        for record: LogRecord,
+        to data: inout Data,
+        key: SymmetricKey,
+        encoder: JSONEncoder
+    ) throws {
+        guard let sealed = try AES.GCM.seal(try encoder.encode(record), using: key).combined else {
+            throw CocoaError(.fileWriteUnknown)
+        }
+        withUnsafeBytes(of: UInt32(sealed.count).littleEndian) { data.append(contentsOf: $0) }
+        data.append(sealed)
+    }
+
+    // MARK: - Loading
+
+    private func loadIfNeeded() throws {
+        guard !isLoaded else { return }
+        if fileManager.fileExists(atPath: fileURL.path(percentEncoded: false)) {
+            try loadLog()
+        }
+        isLoaded = true
+        try importLegacyEntriesIfNeeded()
+    }
+
+    private func loadLog() throws {
+        let data = try Data(contentsOf: fileURL)
+        guard data.count >= Self.headerSize, data.prefix(Self.magic.count) == Self.magic else {
+            throw CocoaError(.fileReadCorruptFile)
+        }
+        let key = try makeKey(Data(data[Self.magic.count..<Self.headerSize]))
+        let decoder = Self.makeDecoder()
+
+        var offset = Self.headerSize
+        var count = 0
+        while offset + 4 <= data.count {
+            let length = Int(data[offset..<offset + 4].withUnsafeBytes {
+                UInt32(littleEndian: $0.loadUnaligned(as: UInt32.self))
+            })
+            guard offset + 4 + length <= data.count else { break }
+            let sealed = data[offset + 4..<offset + 4 + length]
+            let plaintext = try AES.GCM.open(try AES.GCM.SealedBox(combined: sealed), using: key)
+            apply(try decoder.decode(LogRecord.self, from: plaintext))
+            count += 1
+            offset += 4 + length
+        }
+
+        let handle = try FileHandle(forUpdating: fileURL)
+        if offset < data.count {
+            Self.logger.error("Known hosts log had a torn tail; truncating")
+            try handle.truncate(atOffset: UInt64(offset))
+        }
+        self.key = key
+        self.handle = handle
+        fileLength = offset
+        recordCount = count
+    }
+
+    /// Move entries from the single-file format into the log.
+    private func importLegacyEntriesIfNeeded() throws {
+        guard fileManager.fileExists(atPath: legacyFileURL.path(percentEncoded: false)) else { return }
+        let legacy = try EncryptedStorage.loadJSON(
             [KnownHostEntry].self,
-            from: fileURL,
+            from: legacyFileURL,
             fileManager: fileManager,
-            decoder: decoder
+            decoder: Self.makeDecoder()
         ) ?? []
+        try record(legacy.map { .trusted($0) })
+        try fileManager.removeItem(at: legacyFileURL)
     }
 
-    private func persist(_ entries: [KnownHostEntry]) throws {
+    private static func makeEncoder() -> JSONEncoder {
         let encoder = JSONEncoder()
-        encoder.outputFormatting = [.prettyPrinted, .sortedKeys]
         encoder.dateEncodingStrategy = .iso8601
-        try EncryptedStorage.saveJSON(
-            entries,
-            to: fileURL,
-            fileManager: fileManager,
-            encoder: encoder
-        )
+        return encoder
     }
 
-    private static func defaultFileURL(fileManager: FileManager) -> URL {
-        let baseDirectory = fileManager.urls(for: .applicationSupportDirectory, in: .userDomainMask).first
-            ?? fileManager.temporaryDirectory
+    private static func makeDecoder() -> JSONDecoder {
+        let decoder = JSONDecoder()
+        decoder.dateDecodingStrategy = .iso8601
+        return decoder
+    }
 
-        return baseDirectory
+    private static func defaultBaseDirectory(fileManager: FileManager) -> URL {
+        (fileManager.urls(for: .applicationSupportDirectory, in: .userDomainMask).first
+            ?? fileManager.temporaryDirectory)
             .appendingPathComponent("ProSSHV2", isDirectory: true)
-            .appendingPathComponent("known_hosts.json")
     }
 }
@@ -0,0 +1,116 @@
+// LLMContextCompactor.swift
+// ProSSHMac
+//
+// Keeps client-side conversation history (Chat Completions and Anthropic
+// providers, which re-send everything each iteration) inside a token budget.
+
+import Foundation
+
+/// A provider wire message the compactor can measure and slim down.
+protocol LLMCompactableMessage {
+    /// Rough prompt cost of this message, see `LLMContextCompactor.estimatedTokens(for:)`.
+    var estimatedTokens: Int { get }
+    /// True when history may start at this message without orphaning a tool
+    /// result from the call that produced it.
+    var startsTurn: Bool { get }
+    /// A copy with bulky tool output replaced by `LLMContextCompactor.elisionStub`,
+    /// or nil when there is nothing worth eliding.
+    func elidingToolOutput() -> Self?
+}
+
+/// Token-budgeted compaction with hysteresis. Nothing changes until history
+/// exceeds `maxHistoryTokens`; then old tool outputs are elided, and if that
+/// is not enough whole turns are evicted from the front, until history is
+/// back under `targetHistoryTokens`. The compacted history is what providers
+/// persist, so the work is done once and the prefix stays byte-identical
+/// (and cacheable server-side) until the next time the budget is hit.
+struct LLMContextCompactor {
+    struct Compaction<Message> {
+        var messages: [Message]
+        var estimatedTokens: Int
+        var elidedToolOutputs = 0
+        var evictedMessages = 0
+
+        var didChange: Bool { elidedToolOutputs > 0 || evictedMessages > 0 }
+    }
+
+    var maxHistoryTokens: Int
+    var targetHistoryTokens: Int
+    /// The newest messages are never touched, so the model always sees the
+    /// tool results it is currently reasoning about.
+    var preservedRecentMessages: Int
+
+    init(maxHistoryTokens: Int = 64_000, preservedRecentMessages: Int = 8) {
+        self.maxHistoryTokens = maxHistoryTokens
+        self.targetHistoryTokens = maxHistoryTokens * 3 / 4
+        self.preservedRecentMessages = preservedRecentMessages
+    }
+
+    /// Tool outputs shorter than this are left alone; the stub would not save much.
+    static let minimumElidedOutputCharacters = 1_024
+    private static let stubPreviewCharacters = 240
+    private static let perMessageOverheadTokens = 4
+
+    /// About four UTF-8 bytes per token — close enough for budgeting across
+    /// tokenizers, and O(1) for native strings.
+    static func estimatedTokens(for text: String) -> Int {
+        (text.utf8.count + 3) / 4
+    }
+
+    static func estimatedTokens(forMessageParts parts: [String?]) -> Int {
+        parts.reduce(perMessageOverheadTokens) { total, part in
+            total + (part.map(estimatedTokens(for:)) ?? 0)
+        }
+    }
+
+    static func elisionStub(for output: String) -> String {
+        let preview = output.prefix(stubPreviewCharacters)
+        return "[Earlier tool output elided to stay within the context budget; it was \(output.count) characters and began:]\n\(preview)"
+    }
+
+    static func shouldElide(_ output: String?) -> Bool {
+        guard let output, output.count >= minimumElidedOutputCharacters else { return false }
+        return !output.hasPrefix("[Earlier tool output elided")
+    }
+
+    func compact<Message: LLMCompactableMessage>(_ history: [Message]) -> Compaction<Message> {
+        var messages = history
+        var tokens = messages.map(\.estimatedTokens)
+        var total = tokens.reduce(0, +)
+        guard total > maxHistoryTokens else {
+            return Compaction(messages: messages, estimatedTokens: total)
+        }
+
+        let protectedStart = max(0, messages.count - preservedRecentMessages)
+        var compaction = Compaction<Message>(messages: [], estimatedTokens: 0)
+
+        var index = 0
+        while total > targetHistoryTokens, index < protectedStart {
+            if let slim = messages[index].elidingToolOutput() {
+                let slimTokens = slim.estimatedTokens
+                total -= tokens[index] - slimTokens
+                tokens[index] = slimTokens
+                messages[index] = slim
+                compaction.elidedToolOutputs += 1
+            }
+            index += 1
+        }
+
+        var evictEnd = 0
+        while total > targetHistoryTokens {
+            var next = evictEnd + 1
+            while next <= protectedStart, next < messages.count, !messages[next].startsTurn {
+                next += 1
+            }
+            guard next <= protectedStart, next < messages.count else { break }
+            total -= tokens[evictEnd..<next].reduce(0, +)
+            evictEnd = next
+        }
+        messages.removeFirst(evictEnd)
+
+        compaction.messages = messages
+        compaction.estimatedTokens = total
+        compaction.evictedMessages = evictEnd
+        return compaction
+    }
+}
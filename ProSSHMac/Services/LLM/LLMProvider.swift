@@ -58,11 +58,17 @@ protocol LLMProvider: Sendable {
 
     /// Reset any cached conversation state (e.g. on provider switch or session clear).
     func resetConversationState()
+
+    /// The provider's dedicated HTTP session, used for prewarming and
+    /// time-to-first-token diagnostics. Defaults to `nil`.
+    var providerSession: LLMProviderSession? { get }
 }
 
 // MARK: - Default Streaming Implementation
 
 extension LLMProvider {
+    var providerSession: LLMProviderSession? { nil }
+
     func sendRequestStreaming(
         _ request: LLMRequest,
         model: String,
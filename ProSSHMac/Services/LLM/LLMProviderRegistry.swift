@@ -14,10 +14,13 @@ final class LLMProviderRegistry: ObservableObject {
 
     @Published private(set) var activeProviderID: LLMProviderID
     @Published private(set) var activeModelID: String
+    /// Per-provider connection and time-to-first-token stats for Settings > Diagnostics.
+    @Published private(set) var sessionDiagnostics: [LLMSessionDiagnostics] = []
 
     // MARK: - Storage
 
     private var providers: [LLMProviderID: any LLMProvider] = [:]
+    private var sessions: [LLMProviderID: LLMProviderSession] = [:]
 
     private static let providerDefaultsKey = "ai.provider.active"
     private static let modelDefaultsKey = "ai.model.active"
@@ -40,6 +43,20 @@ final class LLMProviderRegistry: ObservableObject {
 
     func register(_ provider: any LLMProvider) {
         providers[provider.providerID] = provider
+        if let session = provider.providerSession {
+            registerSession(session)
+        }
+    }
+
+    /// Register a session for a provider served outside `LLMProvider`
+    /// (the OpenAI Responses path).
+    func registerSession(_ session: LLMProviderSession) {
+        sessions[session.providerID] = session
+    }
+
+    /// The dedicated HTTP session for `id`, if one is registered.
+    func session(for id: LLMProviderID) -> LLMProviderSession? {
+        sessions[id]
     }
 
     // MARK: - Access
@@ -72,6 +89,7 @@ final class LLMProviderRegistry: ObservableObject {
         activeModelID = model
         UserDefaults.standard.set(providerID.rawValue, forKey: Self.providerDefaultsKey)
         UserDefaults.standard.set(model, forKey: Self.modelDefaultsKey)
+        prewarmActiveProvider()
     }
 
     /// Switch only the model within the current provider.
@@ -98,4 +116,22 @@ final class LLMProviderRegistry: ObservableObject {
             setActiveModel(firstModel.id)
         }
     }
+
+    // MARK: - Sessions
+
+    /// Open a connection to the active provider ahead of the first request.
+    /// Cheap to call often: the session skips the prewarm while warm.
+    func prewarmActiveProvider() {
+        sessions[activeProviderID]?.prewarm()
+    }
+
+    /// Record the time from sending a request to its first streamed token.
+    func recordTimeToFirstToken(_ duration: Duration, for id: LLMProviderID) {
+        sessions[id]?.recordTimeToFirstToken(duration)
+        refreshSessionDiagnostics()
+    }
+
+    func refreshSessionDiagnostics() {
+        sessionDiagnostics = LLMProviderID.allCases.compactMap { sessions[$0]?.diagnostics }
+    }
 }
@@ -0,0 +1,238 @@
+// LLMProviderSession.swift
+// ProSSHMac
+//
+// One URLSession per LLM provider, tuned for long streaming requests and
+// pre-warmed so the first prompt does not pay DNS + TCP + TLS.
+//
+// Requests used to share `URLSession.shared` with everything else in the
+// app, and nothing connected until the first prompt was sent. Each
+// provider now owns a session with its own connection pool, and HTTPS
+// origins negotiate HTTP/2 through ALPN, so every request of a
+// conversation reuses one multiplexed connection. `prewarm()` sends a
+// HEAD to the provider's origin when the assistant pane appears or the
+// user starts typing, opening the connection while the prompt is written.
+// Servers close idle HTTP/2 connections after a minute or two, so a
+// prewarm within `warmInterval` of the last request or prewarm is skipped
+// and a later one reconnects.
+//
+// Task metrics record the negotiated protocol, whether the connection was
+// reused and how long connecting took. Time to first token is reported by
+// the agent service (`recordTimeToFirstToken`) and exposed as
+// `LLMSessionDiagnostics` in Settings > Diagnostics.
+
+import Foundation
+import os.log
+
+nonisolated struct LLMSessionDiagnostics: Identifiable, Sendable {
+    var providerID: LLMProviderID
+    var lastTimeToFirstTokenMilliseconds: Int?
+    var medianTimeToFirstTokenMilliseconds: Int?
+    var timeToFirstTokenSamples: Int
+    /// ALPN protocol of the last completed request, e.g. "h2".
+    var lastProtocol: String?
+    var lastConnectionReused: Bool?
+    /// DNS + TCP + TLS time of the last request that opened a connection.
+    var lastConnectMilliseconds: Int?
+    var lastPrewarmAt: Date?
+
+    var id: String { providerID.id }
+}
+
+nonisolated final class LLMProviderSession: @unchecked Sendable {
+
+    private static let logger = Logger(subsystem: "com.prossh", category: "LLM.Session")
+
+    /// Connections idle longer than this are assumed closed by the server.
+    static let warmInterval: Duration = .seconds(60)
+    /// Time-to-first-token samples kept for the median.
+    static let sampleLimit = 20
+
+    let providerID: LLMProviderID
+    /// Scheme, host and port of the provider's API; prewarm requests go here.
+    let origin: URL
+    let session: URLSession
+
+    private let state: State
+
+    init(providerID: LLMProviderID, endpoint: URL) {
+        self.providerID = providerID
+        var components = URLComponents()
+        components.scheme = endpoint.scheme
+        components.host = endpoint.host
+        components.port = endpoint.port
+        components.path = "/"
+        self.origin = components.url ?? endpoint
+        let state = State()
+        self.state = state
+        self.session = URLSession(
+            configuration: Self.makeConfiguration(),
+            delegate: MetricsDelegate(state: state),
+            delegateQueue: nil
+        )
+    }
+
+    deinit {
+        session.finishTasksAndInvalidate()
+    }
+
+    static func makeConfiguration() -> URLSessionConfiguration {
+        let configuration = URLSessionConfiguration.default
+        configuration.httpMaximumConnectionsPerHost = 8
+        configuration.timeoutIntervalForRequest = 600
+        configuration.timeoutIntervalForResource = 3_600
+        configuration.waitsForConnectivity = false
+        configuration.networkServiceType = .responsiveData
+        configuration.requestCachePolicy = .reloadIgnoringLocalCacheData
+        configuration.urlCache = nil
+        configuration.httpShouldSetCookies = false
+        configuration.httpCookieAcceptPolicy = .never
+        return configuration
+    }
+
+    // MARK: - Prewarm
+
+    /// Open a connection to the provider unless one was opened or used
+    /// within `warmInterval`. Returns immediately; the HEAD runs in the
+    /// background and its response is ignored.
+    func prewarm() {
+        guard state.beginPrewarm(now: .now, interval: Self.warmInterval) else { return }
+        var request = URLRequest(url: origin)
+        request.httpMethod = "HEAD"
+        request.timeoutInterval = 10
+        let task = session.dataTask(with: request) { [state, providerID] _, _, error in
+            state.endPrewarm()
+            if let error {
+                Self.logger.debug("prewarm_failed provider=\(providerID.id, privacy: .public) error=\(error.localizedDescription, privacy: .public)")
+            }
+        }
+        task.priority = URLSessionTask.lowPriority
+        task.resume()
+    }
+
+    /// Note that a request is starting, so a prewarm right after it is skipped.
+    func noteRequestStarted() {
+        state.noteUse(now: .now)
+    }
+
+    // MARK: - Time to First Token
+
+    func recordTimeToFirstToken(_ duration: Duration) {
+        let milliseconds = Int(duration.components.seconds * 1_000)
+            + Int(duration.components.attoseconds / 1_000_000_000_000_000)
+        state.recordTimeToFirstToken(milliseconds)
+        Self.logger.info("first_token provider=\(self.providerID.id, privacy: .public) ms=\(milliseconds)")
+    }
+
+    var diagnostics: LLMSessionDiagnostics {
+        state.diagnostics(providerID: providerID)
+    }
+
+    // MARK: - State
+
+    private nonisolated final class State: @unchecked Sendable {
+        private let lock = NSLock()
+        private var lastWarmAt: ContinuousClock.Instant?
+        private var prewarmInFlight = false
+        private var lastPrewarmDate: Date?
+        private var samples: [Int] = []
+        private var lastProtocol: String?
+        private var lastConnectionReused: Bool?
+        private var lastConnectMilliseconds: Int?
+
+        func beginPrewarm(now: ContinuousClock.Instant, interval: Duration) -> Bool {
+            lock.lock()
+            defer { lock.unlock() }
+            if prewarmInFlight {
+                return false
+            }
+            if let lastWarmAt, now - lastWarmAt < interval {
+                return false
+            }
+            prewarmInFlight = true
+            lastWarmAt = now
+            lastPrewarmDate = Date()
+            return true
+        }
+
+        func endPrewarm() {
+            lock.lock()
+            prewarmInFlight = false
+            lock.unlock()
+        }
+
+        func noteUse(now: ContinuousClock.Instant) {
+            lock.lock()
+            lastWarmAt = now
+            lock.unlock()
+        }
+
+        func recordTimeToFirstToken(_ milliseconds: Int) {
+            lock.lock()
+            samples.append(milliseconds)
+            if samples.count > LLMProviderSession.sampleLimit {
+                samples.removeFirst(samples.count - LLMProviderSession.sampleLimit)
+            }
+            lock.unlock()
+        }
+
+        func recordMetrics(_ metrics: URLSessionTaskMetrics) {
+            guard let transaction = metrics.transactionMetrics.last else { return }
+            lock.lock()
+            defer { lock.unlock() }
+            lastProtocol = transaction.networkProtocolName
+            lastConnectionReused = transaction.isReusedConnection
+            if !transaction.isReusedConnection,
+               let start = transaction.domainLookupStartDate ?? transaction.connectStartDate,
+               let end = transaction.secureConnectionEndDate ?? transaction.connectEndDate {
+                lastConnectMilliseconds = Int((end.timeIntervalSince(start) * 1_000).rounded())
+            }
+        }
+
+        func diagnostics(providerID: LLMProviderID) -> LLMSessionDiagnostics {
+            lock.lock()
+            defer { lock.unlock() }
+            let sorted = samples.sorted()
+            return LLMSessionDiagnostics(
+                providerID: providerID,
+                lastTimeToFirstTokenMilliseconds: samples.last,
+                medianTimeToFirstTokenMilliseconds: sorted.isEmpty ? nil : sorted[sorted.count / 2],
+                timeToFirstTokenSamples: samples.count,
+                lastProtocol: lastProtocol,
+                lastConnectionReused: lastConnectionReused,
+                lastConnectMilliseconds: lastConnectMilliseconds,
+                lastPrewarmAt: lastPrewarmDate
+            )
+        }
+    }
+
+    private nonisolated final class MetricsDelegate: NSObject, URLSessionTaskDelegate, @unchecked Sendable {
+        private let state: State
+
+        init(state: State) {
+            self.state = state
+        }
+
+        func urlSession(_ session: URLSession, task: URLSessionTask, didFinishCollecting metrics: URLSessionTaskMetrics) {
+            state.recordMetrics(metrics)
+        }
+    }
+}
+
+// MARK: - First Token Timer
+
+/// Measures from a request's start to its first streamed token. Safe to
+/// call from the stream callback on any thread; only the first call to
+/// `markFirstToken` returns a duration.
+nonisolated final class LLMFirstTokenTimer: @unchecked Sendable {
+    private let start = ContinuousClock.now
+    private let lock = NSLock()
+    private var fired = false
+
+    func markFirstToken() -> Duration? {
+        lock.lock()
+        defer { lock.unlock() }
+        guard !fired else { return nil }
+        fired = true
+        return ContinuousClock.now - start
+    }
+}
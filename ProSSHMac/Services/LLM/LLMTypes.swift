@@ -171,6 +171,57 @@ struct LLMResponse: Sendable {
     var toolCalls: [LLMToolCall]
     /// Updated conversation state to pass into the next request.
     var updatedConversationState: LLMConversationState
+    /// Token accounting reported by the provider, when it sends any.
+    var usage: LLMTokenUsage? = nil
+}
+
+// MARK: - Token Usage
+
+/// Prompt and completion tokens for one request, including how much of the
+/// prompt was served from the provider's prompt-prefix cache.
+///
+/// Providers report cache hits under different names: Anthropic
+/// `cache_read_input_tokens`, OpenAI `cached_tokens`, DeepSeek
+/// `prompt_cache_hit_tokens`. All map to `cachedInputTokens`, which is
+/// included in `inputTokens`.
+struct LLMTokenUsage: Sendable, Equatable {
+    var inputTokens = 0
+    var outputTokens = 0
+    /// Prompt tokens read from the cache.
+    var cachedInputTokens = 0
+    /// Prompt tokens written to the cache (Anthropic bills these separately).
+    var cacheWriteInputTokens = 0
+    var requests = 1
+
+    /// Share of prompt tokens served from the cache, or nil before any prompt.
+    var cacheHitRatio: Double? {
+        inputTokens > 0 ? Double(cachedInputTokens) / Double(inputTokens) : nil
+    }
+
+    static func + (lhs: LLMTokenUsage, rhs: LLMTokenUsage) -> LLMTokenUsage {
+        LLMTokenUsage(
+            inputTokens: lhs.inputTokens + rhs.inputTokens,
+            outputTokens: lhs.outputTokens + rhs.outputTokens,
+            cachedInputTokens: lhs.cachedInputTokens + rhs.cachedInputTokens,
+            cacheWriteInputTokens: lhs.cacheWriteInputTokens + rhs.cacheWriteInputTokens,
+            requests: lhs.requests + rhs.requests
+        )
+    }
+}
+
+// MARK: - Request Encoding
+
+extension JSONEncoder {
+    /// Encoder for provider request bodies. Tool schemas are
+    /// `[String: LLMJSONValue]` dictionaries whose iteration order changes
+    /// between launches and between equal dictionaries built differently;
+    /// sorted keys keep the system prompt, tools and history byte-identical
+    /// from turn to turn, which provider prompt caches match on.
+    static func llmRequestBody() -> JSONEncoder {
+        let encoder = JSONEncoder()
+        encoder.outputFormatting = .sortedKeys
+        return encoder
+    }
 }
 
 // MARK: - Streaming Events
@@ -182,6 +233,10 @@ enum LLMStreamEvent: Sendable, Equatable {
     case reasoningDone(String)
     case reasoningSummaryDelta(String)
     case reasoningSummaryDone(String)
+    /// A tool call whose arguments have finished streaming, sent before the
+    /// rest of the response so read-only tools can start early. The call is
+    /// still part of the final `LLMResponse.toolCalls`.
+    case toolCallReady(LLMToolCall)
 }
 
 // MARK: - Errors
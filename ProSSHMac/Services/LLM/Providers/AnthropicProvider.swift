@@ -13,7 +13,7 @@ import os.log
 private struct AnthropicWireRequest: Encodable {
     var model: String
     var maxTokens: Int
-    var system: String?
+    var system: [AnthropicSystemBlock]?
     var messages: [AnthropicWireMessage]
     var tools: [AnthropicWireTool]?
     var stream: Bool?
@@ -35,6 +35,23 @@ private struct AnthropicThinkingConfig: Encodable {
     }
 }
 
+/// Marks the end of a prompt prefix Anthropic should cache. Reads of a cached
+/// prefix are billed at a fraction of input cost and skip re-processing.
+struct AnthropicCacheControl: Codable, Equatable {
+    var type = "ephemeral"
+}
+
+private struct AnthropicSystemBlock: Encodable {
+    var type = "text"
+    var text: String
+    var cacheControl: AnthropicCacheControl?
+
+    enum CodingKeys: String, CodingKey {
+        case type, text
+        case cacheControl = "cache_control"
+    }
+}
+
 struct AnthropicWireMessage: Codable {
     var role: String
     var content: AnthropicContent
@@ -80,10 +97,51 @@ struct AnthropicContentBlock: Codable {
     var input: LLMJSONValue?
     var toolUseId: String?
     var content: String?
+    /// Only set on the copy sent over the wire, never on persisted history.
+    var cacheControl: AnthropicCacheControl?
 
     enum CodingKeys: String, CodingKey {
         case type, text, id, name, input, content
         case toolUseId = "tool_use_id"
+        case cacheControl = "cache_control"
+    }
+}
+
+extension AnthropicWireMessage: LLMCompactableMessage {
+    var estimatedTokens: Int {
+        switch content {
+        case .text(let text):
+            return LLMContextCompactor.estimatedTokens(forMessageParts: [text])
+        case .blocks(let blocks):
+            var parts: [String?] = []
+            for block in blocks {
+                parts.append(block.text)
+                parts.append(block.content)
+                if let input = block.input {
+                    parts.append(AIToolDefinitions.jsonString(from: input))
+                }
+            }
+            return LLMContextCompactor.estimatedTokens(forMessageParts: parts)
+        }
+    }
+
+    /// A plain user message; `tool_result` messages must follow their `tool_use`.
+    var startsTurn: Bool {
+        guard role == "user", case .text = content else { return false }
+        return true
+    }
+
+    func elidingToolOutput() -> AnthropicWireMessage? {
+        guard case .blocks(var blocks) = content else { return nil }
+        var changed = false
+        for index in blocks.indices where blocks[index].type == "tool_result" {
+            guard LLMContextCompactor.shouldElide(blocks[index].content),
+                  let output = blocks[index].content else { continue }
+            blocks[index].content = LLMContextCompactor.elisionStub(for: output)
+            changed = true
+        }
+        guard changed else { return nil }
+        return AnthropicWireMessage(role: role, content: .blocks(blocks))
     }
 }
 
@@ -91,10 +149,12 @@ private struct AnthropicWireTool: Encodable {
     var name: String
     var description: String
     var inputSchema: LLMJSONValue
+    var cacheControl: AnthropicCacheControl?
 
     enum CodingKeys: String, CodingKey {
         case name, description
         case inputSchema = "input_schema"
+        case cacheControl = "cache_control"
     }
 }
 
@@ -127,10 +187,27 @@ private struct AnthropicResponseContentBlock: Decodable {
 private struct AnthropicUsage: Decodable {
     var inputTokens: Int?
     var outputTokens: Int?
+    var cacheCreationInputTokens: Int?
+    var cacheReadInputTokens: Int?
 
     enum CodingKeys: String, CodingKey {
         case inputTokens = "input_tokens"
         case outputTokens = "output_tokens"
+        case cacheCreationInputTokens = "cache_creation_input_tokens"
+        case cacheReadInputTokens = "cache_read_input_tokens"
+    }
+
+    /// `input_tokens` counts only the uncached tail of the prompt; cache
+    /// reads and writes are reported beside it.
+    var llmUsage: LLMTokenUsage {
+        let cacheRead = cacheReadInputTokens ?? 0
+        let cacheWrite = cacheCreationInputTokens ?? 0
+        return LLMTokenUsage(
+            inputTokens: (inputTokens ?? 0) + cacheRead + cacheWrite,
+            outputTokens: outputTokens ?? 0,
+            cachedInputTokens: cacheRead,
+            cacheWriteInputTokens: cacheWrite
+        )
     }
 }
 
@@ -193,6 +270,8 @@ private struct AnthropicStreamContentBlockStop: Decodable {
 private struct AnthropicStreamMessageDelta: Decodable {
     var type: String
     var delta: AnthropicMessageDeltaPayload
+    /// Cumulative output tokens for the message.
+    var usage: AnthropicUsage?
 }
 
 private struct AnthropicMessageDeltaPayload: Decodable {
@@ -240,7 +319,9 @@ final class AnthropicProvider: LLMProvider {
     ]
 
     private let apiKeyProvider: any LLMAPIKeyProviding
+    private let contextCompactor = LLMContextCompactor(maxHistoryTokens: 120_000)
     private let session: URLSession
+    let providerSession: LLMProviderSession?
     private static let endpoint = URL(string: "https://api.anthropic.com/v1/messages")!
     private static let apiVersion = "2023-06-01"
     private static let defaultMaxTokens = 16384
@@ -252,9 +333,17 @@ final class AnthropicProvider: LLMProvider {
         true
     }
 
-    init(apiKeyProvider: any LLMAPIKeyProviding, session: URLSession = .shared) {
+    /// Pass `session` to override the dedicated provider session (tests).
+    init(apiKeyProvider: any LLMAPIKeyProviding, session: URLSession? = nil) {
         self.apiKeyProvider = apiKeyProvider
-        self.session = session
+        if let session {
+            self.session = session
+            self.providerSession = nil
+        } else {
+            let providerSession = LLMProviderSession(providerID: .anthropic, endpoint: Self.endpoint)
+            self.session = providerSession.session
+            self.providerSession = providerSession
+        }
     }
 
     // MARK: - LLMProvider
@@ -270,7 +359,7 @@ final class AnthropicProvider: LLMProvider {
 
         let wireRequest = buildWireRequest(from: request, model: model, priorMessages: priorMessages, stream: false)
 
-        let bodyData = try JSONEncoder().encode(wireRequest)
+        let bodyData = try JSONEncoder.llmRequestBody().encode(wireRequest)
         var urlRequest = URLRequest(url: Self.endpoint)
         urlRequest.httpMethod = "POST"
         urlRequest.httpBody = bodyData
@@ -319,7 +408,7 @@ final class AnthropicProvider: LLMProvider {
 
         let wireRequest = buildWireRequest(from: request, model: model, priorMessages: priorMessages, stream: true)
 
-        let bodyData = try JSONEncoder().encode(wireRequest)
+        let bodyData = try JSONEncoder.llmRequestBody().encode(wireRequest)
         var urlRequest = URLRequest(url: Self.endpoint)
         urlRequest.httpMethod = "POST"
         urlRequest.httpBody = bodyData
@@ -344,6 +433,7 @@ final class AnthropicProvider: LLMProvider {
         var accumulatedThinking = ""
         var accumulatedToolInputs: [Int: String] = [:]
         var stopReason: String?
+        var usage: AnthropicUsage?
 
         for try await line in bytes.lines {
             guard line.hasPrefix("data: ") else { continue }
@@ -359,6 +449,7 @@ final class AnthropicProvider: LLMProvider {
             case "message_start":
                 if let parsed = try? JSONDecoder().decode(AnthropicStreamMessageStart.self, from: jsonData) {
                     responseID = parsed.message.id
+                    usage = parsed.message.usage
                 }
 
             case "content_block_start":
@@ -399,11 +490,21 @@ final class AnthropicProvider: LLMProvider {
                     if blockTypes[parsed.index] == "thinking" && !accumulatedThinking.isEmpty {
                         onEvent(.reasoningDone(accumulatedThinking))
                     }
+                    if blockTypes[parsed.index] == "tool_use",
+                       let id = blockIDs[parsed.index],
+                       let name = blockNames[parsed.index] {
+                        let arguments = accumulatedToolInputs[parsed.index] ?? ""
+                        onEvent(.toolCallReady(LLMToolCall(id: id, name: name, arguments: arguments.isEmpty ? "{}" : arguments)))
+                    }
                 }
 
             case "message_delta":
                 if let parsed = try? JSONDecoder().decode(AnthropicStreamMessageDelta.self, from: jsonData) {
                     stopReason = parsed.delta.stopReason
+                    if let outputTokens = parsed.usage?.outputTokens {
+                        usage = usage ?? AnthropicUsage()
+                        usage?.outputTokens = outputTokens
+                    }
                 }
 
             case "message_stop":
@@ -443,7 +544,8 @@ final class AnthropicProvider: LLMProvider {
             role: "assistant",
             content: contentBlocks,
             model: model,
-            stopReason: stopReason
+            stopReason: stopReason,
+            usage: usage
         )
 
         Self.logger.debug("stream_ok response_id=\(responseID, privacy: .public)")
@@ -501,7 +603,7 @@ final class AnthropicProvider: LLMProvider {
         }
 
         // 4. Map tool definitions
-        let wireTools: [AnthropicWireTool]? = request.tools.isEmpty ? nil : request.tools.map { tool in
+        var wireTools: [AnthropicWireTool]? = request.tools.isEmpty ? nil : request.tools.map { tool in
             AnthropicWireTool(
                 name: tool.name,
                 description: tool.description,
@@ -509,7 +611,16 @@ final class AnthropicProvider: LLMProvider {
             )
         }
 
-        // 5. Determine if extended thinking should be enabled
+        // 5. Prompt-cache breakpoints: tools, system, and the newest message.
+        //    Each iteration only appends, so the next request finds everything
+        //    up to this one's last message already cached.
+        if var tools = wireTools, !tools.isEmpty {
+            tools[tools.count - 1].cacheControl = AnthropicCacheControl()
+            wireTools = tools
+        }
+        Self.markCacheBreakpoint(in: &wireMessages)
+
+        // 6. Determine if extended thinking should be enabled
         let modelInfo = availableModels.first { $0.id == model }
         let supportsReasoning = modelInfo?.supportsReasoning ?? false
 
@@ -523,7 +634,7 @@ final class AnthropicProvider: LLMProvider {
         return AnthropicWireRequest(
             model: model,
             maxTokens: Self.defaultMaxTokens,
-            system: systemText.isEmpty ? nil : systemText,
+            system: systemText.isEmpty ? nil : [AnthropicSystemBlock(text: systemText, cacheControl: AnthropicCacheControl())],
             messages: wireMessages,
             tools: wireTools,
             stream: stream ? true : nil,
@@ -568,7 +679,8 @@ final class AnthropicProvider: LLMProvider {
         return LLMResponse(
             text: text,
             toolCalls: toolCalls,
-            updatedConversationState: state
+            updatedConversationState: state,
+            usage: wireResponse.usage?.llmUsage
         )
     }
 
@@ -583,7 +695,12 @@ final class AnthropicProvider: LLMProvider {
                 expected: providerID, got: state.providerID
             )
         }
-        return (try? state.decoded(as: [AnthropicWireMessage].self)) ?? []
+        let history = (try? state.decoded(as: [AnthropicWireMessage].self)) ?? []
+        let compaction = contextCompactor.compact(history)
+        if compaction.didChange {
+            Self.logger.info("history_compacted messages=\(history.count)->\(compaction.messages.count) elided_tool_outputs=\(compaction.elidedToolOutputs) est_tokens=\(compaction.estimatedTokens)")
+        }
+        return compaction.messages
     }
 
     private func buildUpdatedHistory(
@@ -663,6 +780,20 @@ final class AnthropicProvider: LLMProvider {
         return String(data: data, encoding: .utf8) ?? ""
     }
 
+    private static func markCacheBreakpoint(in messages: inout [AnthropicWireMessage]) {
+        guard let last = messages.indices.last else { return }
+        var blocks: [AnthropicContentBlock]
+        switch messages[last].content {
+        case .text(let text):
+            blocks = [AnthropicContentBlock(type: "text", text: text)]
+        case .blocks(let existing):
+            blocks = existing
+        }
+        guard !blocks.isEmpty else { return }
+        blocks[blocks.count - 1].cacheControl = AnthropicCacheControl()
+        messages[last].content = .blocks(blocks)
+    }
+
     private static func parseJSONValue(_ jsonString: String) -> LLMJSONValue {
         guard let data = jsonString.data(using: .utf8),
               let value = try? JSONDecoder().decode(LLMJSONValue.self, from: data) else {
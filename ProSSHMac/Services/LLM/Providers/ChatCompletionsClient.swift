@@ -20,11 +20,22 @@ struct ChatCompletionsWireRequest: Encodable {
     var maxTokens: Int?
     /// DeepSeek thinking mode: `{"type": "enabled"}` activates chain-of-thought on deepseek-chat.
     var thinking: ChatCompletionsThinkingConfig?
+    /// `{"include_usage": true}` asks for a final usage chunk on streams.
+    var streamOptions: ChatCompletionsStreamOptions?
 
     enum CodingKeys: String, CodingKey {
         case model, messages, tools, stream, temperature, thinking
         case toolChoice = "tool_choice"
         case maxTokens = "max_tokens"
+        case streamOptions = "stream_options"
+    }
+}
+
+struct ChatCompletionsStreamOptions: Encodable {
+    var includeUsage: Bool
+
+    enum CodingKeys: String, CodingKey {
+        case includeUsage = "include_usage"
     }
 }
 
@@ -48,6 +59,31 @@ struct ChatCompletionsWireMessage: Codable {
     }
 }
 
+extension ChatCompletionsWireMessage: LLMCompactableMessage {
+    var estimatedTokens: Int {
+        var parts: [String?] = [content, reasoningContent]
+        for call in toolCalls ?? [] {
+            parts.append(call.function.name)
+            parts.append(call.function.arguments)
+        }
+        return LLMContextCompactor.estimatedTokens(forMessageParts: parts)
+    }
+
+    /// Turns begin with the developer prompt or the user's message; `tool`
+    /// messages must stay behind the assistant message whose `tool_calls`
+    /// they answer.
+    var startsTurn: Bool {
+        role == "system" || role == "user"
+    }
+
+    func elidingToolOutput() -> ChatCompletionsWireMessage? {
+        guard role == "tool", LLMContextCompactor.shouldElide(content), let content else { return nil }
+        var slim = self
+        slim.content = LLMContextCompactor.elisionStub(for: content)
+        return slim
+    }
+}
+
 struct ChatCompletionsWireToolCallRef: Codable {
     var id: String
     var type: String = "function"
@@ -75,6 +111,7 @@ struct ChatCompletionsWireFunction: Encodable {
 struct ChatCompletionsWireResponse: Decodable {
     var id: String
     var choices: [ChatCompletionsWireChoice]
+    var usage: ChatCompletionsWireUsage?
 
     struct ChatCompletionsWireChoice: Decodable {
         var message: ChatCompletionsWireResponseMessage
@@ -111,10 +148,45 @@ struct ChatCompletionsWireResponse: Decodable {
     }
 }
 
+/// Token accounting. Cache hits arrive as OpenAI-style
+/// `prompt_tokens_details.cached_tokens` or DeepSeek's
+/// `prompt_cache_hit_tokens`; Mistral and Ollama report neither.
+struct ChatCompletionsWireUsage: Decodable {
+    var promptTokens: Int?
+    var completionTokens: Int?
+    var promptTokensDetails: PromptTokensDetails?
+    var promptCacheHitTokens: Int?
+
+    struct PromptTokensDetails: Decodable {
+        var cachedTokens: Int?
+
+        enum CodingKeys: String, CodingKey {
+            case cachedTokens = "cached_tokens"
+        }
+    }
+
+    enum CodingKeys: String, CodingKey {
+        case promptTokens = "prompt_tokens"
+        case completionTokens = "completion_tokens"
+        case promptTokensDetails = "prompt_tokens_details"
+        case promptCacheHitTokens = "prompt_cache_hit_tokens"
+    }
+
+    var llmUsage: LLMTokenUsage {
+        LLMTokenUsage(
+            inputTokens: promptTokens ?? 0,
+            outputTokens: completionTokens ?? 0,
+            cachedInputTokens: promptCacheHitTokens ?? promptTokensDetails?.cachedTokens ?? 0
+        )
+    }
+}
+
 // MARK: - Streaming Wire Types
 
 struct ChatCompletionsStreamChunk: Decodable {
     var choices: [StreamChoice]
+    /// Present on the final chunk when usage was requested (or always, for Mistral).
+    var usage: ChatCompletionsWireUsage? = nil
 
     struct StreamChoice: Decodable {
         var delta: StreamDelta
@@ -141,6 +213,13 @@ struct ChatCompletionsStreamChunk: Decodable {
             case toolCalls = "tool_calls"
         }
 
+        init(content: String? = nil, reasoning: String? = nil, thinkingContent: String? = nil, toolCalls: [StreamToolCall]? = nil) {
+            self.content = content
+            self.reasoning = reasoning
+            self.thinkingContent = thinkingContent
+            self.toolCalls = toolCalls
+        }
+
         init(from decoder: Decoder) throws {
             let container = try decoder.container(keyedBy: CodingKeys.self)
             toolCalls = try container.decodeIfPresent([StreamToolCall].self, forKey: .toolCalls)
@@ -198,6 +277,134 @@ struct ChatCompletionsStreamChunk: Decodable {
     }
 }
 
+extension ChatCompletionsStreamChunk {
+
+    /// Reads a chunk with `StreamingJSONScanner` instead of `JSONDecoder`.
+    /// Returns nil when the chunk needs the full decoder: malformed JSON, a
+    /// choice without `delta`, a tool call without `index`, Mistral's
+    /// structured `content` blocks, or a non-null `usage` (once per stream).
+    static func scan(_ bytes: [UInt8]) -> ChatCompletionsStreamChunk? {
+        var choices: [ScannedChoice] = []
+        var needsDecoder = false
+
+        let isValid = StreamingJSONScanner.scan(bytes) { path, scalar in
+            if path.first == Component.key("usage") {
+                if scalar != .null { needsDecoder = true }
+                return
+            }
+            guard path.count >= 3,
+                  path[0] == Component.key("choices"),
+                  case .index(let choiceIndex) = path[1] else {
+                return
+            }
+            while choices.count <= choiceIndex {
+                choices.append(ScannedChoice())
+            }
+            let field = path[2...]
+            if field.elementsEqual(Self.finishReasonPath) {
+                if case .string(let value) = scalar { choices[choiceIndex].finishReason = value }
+                return
+            }
+            guard field.first == Component.key("delta") else { return }
+            choices[choiceIndex].hasDelta = true
+            guard field.count >= 2, case .key(let key) = field[field.startIndex + 1] else { return }
+
+            switch key {
+            case "content":
+                if field.count > 2 {
+                    needsDecoder = true
+                } else if case .string(let value) = scalar {
+                    choices[choiceIndex].content = value
+                }
+            case "reasoning":
+                if case .string(let value) = scalar { choices[choiceIndex].reasoning = value }
+            case "reasoning_content":
+                if case .string(let value) = scalar { choices[choiceIndex].reasoningContent = value }
+            case "tool_calls":
+                guard field.count >= 4, case .index(let callIndex) = field[field.startIndex + 2] else { return }
+                choices[choiceIndex].toolCalls.hasEntries = true
+                while choices[choiceIndex].toolCalls.entries.count <= callIndex {
+                    choices[choiceIndex].toolCalls.entries.append(ScannedToolCall())
+                }
+                let callField = field[(field.startIndex + 3)...]
+                guard case .string(let value) = scalar else {
+                    if callField.elementsEqual(Self.toolCallIndexPath), case .number(let number) = scalar {
+                        choices[choiceIndex].toolCalls.entries[callIndex].index = Int(exactly: number)
+                    }
+                    return
+                }
+                if callField.elementsEqual(Self.toolCallIDPath) {
+                    choices[choiceIndex].toolCalls.entries[callIndex].id = value
+                } else if callField.elementsEqual(Self.functionNamePath) {
+                    choices[choiceIndex].toolCalls.entries[callIndex].name = value
+                } else if callField.elementsEqual(Self.functionArgumentsPath) {
+                    choices[choiceIndex].toolCalls.entries[callIndex].arguments = value
+                }
+            default:
+                break
+            }
+        }
+
+        guard isValid, !needsDecoder else { return nil }
+
+        var result: [StreamChoice] = []
+        result.reserveCapacity(choices.count)
+        for choice in choices {
+            guard choice.hasDelta else { return nil }
+            var toolCalls: [StreamToolCall]?
+            if choice.toolCalls.hasEntries {
+                var calls: [StreamToolCall] = []
+                for entry in choice.toolCalls.entries {
+                    guard let index = entry.index else { return nil }
+                    let function = entry.name == nil && entry.arguments == nil
+                        ? nil
+                        : StreamFunction(name: entry.name, arguments: entry.arguments)
+                    calls.append(StreamToolCall(index: index, id: entry.id, function: function))
+                }
+                toolCalls = calls
+            }
+            result.append(StreamChoice(
+                delta: StreamDelta(
+                    content: choice.content,
+                    reasoning: choice.reasoning ?? choice.reasoningContent,
+                    toolCalls: toolCalls
+                ),
+                finishReason: choice.finishReason
+            ))
+        }
+        return ChatCompletionsStreamChunk(choices: result)
+    }
+
+    private typealias Component = StreamingJSONScanner.PathComponent
+
+    private static let finishReasonPath: [Component] = [.key("finish_reason")]
+    private static let toolCallIndexPath: [Component] = [.key("index")]
+    private static let toolCallIDPath: [Component] = [.key("id")]
+    private static let functionNamePath: [Component] = [.key("function"), .key("name")]
+    private static let functionArgumentsPath: [Component] = [.key("function"), .key("arguments")]
+
+    private struct ScannedChoice {
+        var hasDelta = false
+        var content: String?
+        var reasoning: String?
+        var reasoningContent: String?
+        var finishReason: String?
+        var toolCalls = ScannedToolCalls()
+    }
+
+    private struct ScannedToolCalls {
+        var hasEntries = false
+        var entries: [ScannedToolCall] = []
+    }
+
+    private struct ScannedToolCall {
+        var index: Int?
+        var id: String?
+        var name: String?
+        var arguments: String?
+    }
+}
+
 // MARK: - Error Wire Type
 
 struct ChatCompletionsWireError: Decodable {
@@ -218,10 +425,14 @@ final class ChatCompletionsClient: Sendable {
 
     let endpointURL: URL
     let session: URLSession
+    /// Send `stream_options.include_usage` so streams end with a usage chunk.
+    /// Off for servers that reject unknown fields (Mistral reports usage anyway).
+    let requestsStreamUsage: Bool
 
-    init(endpointURL: URL, session: URLSession = .shared) {
+    init(endpointURL: URL, session: URLSession = .shared, requestsStreamUsage: Bool = false) {
         self.endpointURL = endpointURL
         self.session = session
+        self.requestsStreamUsage = requestsStreamUsage
     }
 
     private func logRequestPayload(_ data: Data, endpoint: URL, streaming: Bool) {
@@ -269,7 +480,7 @@ final class ChatCompletionsClient: Sendable {
         var wireRequest = request
         wireRequest.stream = false
 
-        let data = try JSONEncoder().encode(wireRequest)
+        let data = try JSONEncoder.llmRequestBody().encode(wireRequest)
         logRequestPayload(data, endpoint: endpointURL, streaming: false)
         var urlRequest = URLRequest(url: endpointURL)
         urlRequest.httpMethod = "POST"
@@ -307,8 +518,11 @@ final class ChatCompletionsClient: Sendable {
     ) async throws -> ChatCompletionsWireResponse {
         var wireRequest = request
         wireRequest.stream = true
+        if requestsStreamUsage {
+            wireRequest.streamOptions = ChatCompletionsStreamOptions(includeUsage: true)
+        }
 
-        let data = try JSONEncoder().encode(wireRequest)
+        let data = try JSONEncoder.llmRequestBody().encode(wireRequest)
         logRequestPayload(data, endpoint: endpointURL, streaming: true)
         var urlRequest = URLRequest(url: endpointURL)
         urlRequest.httpMethod = "POST"
@@ -334,16 +548,18 @@ final class ChatCompletionsClient: Sendable {
         var accumulatedText = ""
         var accumulatedReasoning = ""
         var accumulatedToolCalls: [String: (id: String, name: String, arguments: String)] = [:]
+        // Each call is announced once, as soon as its arguments close.
+        var argumentTrackers: [String: StreamingJSONScanner.ClosureTracker] = [:]
+        var readyToolCallKeys: Set<String> = []
         var extractor = ThinkTagExtractor()
+        var usage: ChatCompletionsWireUsage?
 
-        for try await line in bytes.lines {
-            guard line.hasPrefix("data: ") else { continue }
-            let payload = String(line.dropFirst(6))
-            guard payload != "[DONE]" else { break }
-            guard let chunkData = payload.data(using: .utf8),
-                  let chunk = try? JSONDecoder().decode(ChatCompletionsStreamChunk.self, from: chunkData)
-            else { continue }
+        var parser = SSEEventParser(dispatchesEachDataLine: true)
 
+        func handle(_ chunk: ChatCompletionsStreamChunk) {
+            if let chunkUsage = chunk.usage {
+                usage = chunkUsage
+            }
             for choice in chunk.choices {
                 // Native reasoning field (Ollama "reasoning" / DeepSeek "reasoning_content")
                 if let reasoning = choice.delta.reasoning, !reasoning.isEmpty {
@@ -379,13 +595,32 @@ final class ChatCompletionsClient: Sendable {
                         var existing = accumulatedToolCalls[key] ?? (id: "", name: "", arguments: "")
                         if let id = tc.id { existing.id = id }
                         if let name = tc.function?.name { existing.name += name }
-                        if let args = tc.function?.arguments { existing.arguments += args }
+                        if let args = tc.function?.arguments {
+                            existing.arguments += args
+                            argumentTrackers[key, default: .init()].feed(args)
+                        }
                         accumulatedToolCalls[key] = existing
+                        if argumentTrackers[key]?.isClosed == true,
+                           !existing.id.isEmpty, !existing.name.isEmpty,
+                           readyToolCallKeys.insert(key).inserted {
+                            onEvent(.toolCallReady(LLMToolCall(id: existing.id, name: existing.name, arguments: existing.arguments)))
+                        }
                     }
                 }
             }
         }
 
+        streamLoop: for try await byte in bytes {
+            guard let event = parser.feed(byte) else { continue }
+            guard !event.isDone else { break streamLoop }
+            if let chunk = Self.decodeStreamChunk(event.data) {
+                handle(chunk)
+            }
+        }
+        if let event = parser.finish(), !event.isDone, let chunk = Self.decodeStreamChunk(event.data) {
+            handle(chunk)
+        }
+
         // Flush native reasoning_content accumulated across chunks
         if !accumulatedReasoning.isEmpty {
             onEvent(.reasoningDone(accumulatedReasoning))
@@ -429,7 +664,8 @@ final class ChatCompletionsClient: Sendable {
                     ),
                     finishReason: toolCallRefs.isEmpty ? "stop" : "tool_calls"
                 )
-            ]
+            ],
+            usage: usage
         )
     }
 
@@ -536,6 +772,14 @@ extension ChatCompletionsClient {
 
     // MARK: - Helpers
 
+    /// Scanner first; `JSONDecoder` only for chunk shapes the scanner defers.
+    private static func decodeStreamChunk(_ payload: [UInt8]) -> ChatCompletionsStreamChunk? {
+        if let chunk = ChatCompletionsStreamChunk.scan(payload) {
+            return chunk
+        }
+        return try? JSONDecoder().decode(ChatCompletionsStreamChunk.self, from: Data(payload))
+    }
+
     private func extractErrorMessage(from data: Data) -> String {
         if let decoded = try? JSONDecoder().decode(ChatCompletionsWireError.self, from: data) {
             return decoded.error.message
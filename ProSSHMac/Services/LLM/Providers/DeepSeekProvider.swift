@@ -35,6 +35,8 @@ final class DeepSeekProvider: LLMProvider {
     ]
 
     private let client: ChatCompletionsClient
+    let providerSession: LLMProviderSession?
+    private let contextCompactor = LLMContextCompactor()
     private let apiKeyProvider: any LLMAPIKeyProviding
 
     var isConfigured: Bool {
@@ -43,8 +45,13 @@ final class DeepSeekProvider: LLMProvider {
 
     init(apiKeyProvider: any LLMAPIKeyProviding) {
         self.apiKeyProvider = apiKeyProvider
+        let endpointURL = URL(string: "https://api.deepseek.com/chat/completions")!
+        let providerSession = LLMProviderSession(providerID: .deepseek, endpoint: endpointURL)
+        self.providerSession = providerSession
         self.client = ChatCompletionsClient(
-            endpointURL: URL(string: "https://api.deepseek.com/chat/completions")!
+            endpointURL: endpointURL,
+            session: providerSession.session,
+            requestsStreamUsage: true
         )
     }
 
@@ -114,7 +121,12 @@ final class DeepSeekProvider: LLMProvider {
                 expected: providerID, got: state.providerID
             )
         }
-        return (try? state.decoded(as: [ChatCompletionsWireMessage].self)) ?? []
+        let history = (try? state.decoded(as: [ChatCompletionsWireMessage].self)) ?? []
+        let compaction = contextCompactor.compact(history)
+        if compaction.didChange {
+            Self.logger.info("history_compacted messages=\(history.count)->\(compaction.messages.count) elided_tool_outputs=\(compaction.elidedToolOutputs) est_tokens=\(compaction.estimatedTokens)")
+        }
+        return compaction.messages
     }
 
     private func buildUpdatedHistory(
@@ -161,7 +173,8 @@ final class DeepSeekProvider: LLMProvider {
         return LLMResponse(
             text: text,
             toolCalls: toolCalls,
-            updatedConversationState: state
+            updatedConversationState: state,
+            usage: wireResponse.usage?.llmUsage
         )
     }
 
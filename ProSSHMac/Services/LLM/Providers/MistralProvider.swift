@@ -50,6 +50,8 @@ final class MistralProvider: LLMProvider {
     ]
 
     private let client: ChatCompletionsClient
+    let providerSession: LLMProviderSession?
+    private let contextCompactor = LLMContextCompactor()
     private let apiKeyProvider: any LLMAPIKeyProviding
 
     var isConfigured: Bool {
@@ -60,9 +62,10 @@ final class MistralProvider: LLMProvider {
 
     init(apiKeyProvider: any LLMAPIKeyProviding) {
         self.apiKeyProvider = apiKeyProvider
-        self.client = ChatCompletionsClient(
-            endpointURL: URL(string: "https://api.mistral.ai/v1/chat/completions")!
-        )
+        let endpointURL = URL(string: "https://api.mistral.ai/v1/chat/completions")!
+        let providerSession = LLMProviderSession(providerID: .mistral, endpoint: endpointURL)
+        self.providerSession = providerSession
+        self.client = ChatCompletionsClient(endpointURL: endpointURL, session: providerSession.session)
     }
 
     func sendRequest(
@@ -129,7 +132,12 @@ final class MistralProvider: LLMProvider {
                 expected: providerID, got: state.providerID
             )
         }
-        return (try? state.decoded(as: [ChatCompletionsWireMessage].self)) ?? []
+        let history = (try? state.decoded(as: [ChatCompletionsWireMessage].self)) ?? []
+        let compaction = contextCompactor.compact(history)
+        if compaction.didChange {
+            Self.logger.info("history_compacted messages=\(history.count)->\(compaction.messages.count) elided_tool_outputs=\(compaction.elidedToolOutputs) est_tokens=\(compaction.estimatedTokens)")
+        }
+        return compaction.messages
     }
 
     private func buildUpdatedHistory(
@@ -175,7 +183,8 @@ final class MistralProvider: LLMProvider {
         return LLMResponse(
             text: text,
             toolCalls: toolCalls,
-            updatedConversationState: state
+            updatedConversationState: state,
+            usage: wireResponse.usage?.llmUsage
         )
     }
 
@@ -31,12 +31,19 @@ final class OllamaProvider: LLMProvider {
     }
 
     private let client: ChatCompletionsClient
+    let providerSession: LLMProviderSession?
+    /// Local models usually run with a small context window (`num_ctx`).
+    private let contextCompactor = LLMContextCompactor(maxHistoryTokens: 16_000)
     private let baseURL: URL
 
     init(baseURL: URL = URL(string: "http://localhost:11434")!) {
         self.baseURL = baseURL
+        let providerSession = LLMProviderSession(providerID: .ollama, endpoint: baseURL)
+        self.providerSession = providerSession
         self.client = ChatCompletionsClient(
-            endpointURL: baseURL.appendingPathComponent("v1/chat/completions")
+            endpointURL: baseURL.appendingPathComponent("v1/chat/completions"),
+            session: providerSession.session,
+            requestsStreamUsage: true
         )
     }
 
@@ -47,7 +54,7 @@ final class OllamaProvider: LLMProvider {
     func refreshModels() async {
         let tagsURL = baseURL.appendingPathComponent("api/tags")
         do {
-            let (data, response) = try await URLSession.shared.data(from: tagsURL)
+            let (data, response) = try await client.session.data(from: tagsURL)
             guard let http = response as? HTTPURLResponse, http.statusCode == 200 else {
                 Self.logger.warning("model_refresh_failed: non-200 response")
                 return
@@ -135,7 +142,12 @@ final class OllamaProvider: LLMProvider {
                 expected: providerID, got: state.providerID
             )
         }
-        return (try? state.decoded(as: [ChatCompletionsWireMessage].self)) ?? []
+        let history = (try? state.decoded(as: [ChatCompletionsWireMessage].self)) ?? []
+        let compaction = contextCompactor.compact(history)
+        if compaction.didChange {
+            Self.logger.info("history_compacted messages=\(history.count)->\(compaction.messages.count) elided_tool_outputs=\(compaction.elidedToolOutputs) est_tokens=\(compaction.estimatedTokens)")
+        }
+        return compaction.messages
     }
 
     private func buildUpdatedHistory(
@@ -181,7 +193,8 @@ final class OllamaProvider: LLMProvider {
         return LLMResponse(
             text: text,
             toolCalls: toolCalls,
-            updatedConversationState: state
+            updatedConversationState: state,
+            usage: wireResponse.usage?.llmUsage
         )
     }
 
@@ -0,0 +1,117 @@
+import Foundation
+
+/// Byte-level server-sent-events framer shared by the streaming providers.
+/// Bytes are fed one at a time straight from `URLSession.AsyncBytes`; data
+/// payloads come back as raw UTF-8 so they can go to `StreamingJSONScanner`
+/// without a `String` round trip per line.
+nonisolated struct SSEEventParser {
+    struct Event: Equatable {
+        var name: String?
+        var data: [UInt8]
+
+        /// True for the `[DONE]` sentinel that OpenAI-compatible APIs send last.
+        var isDone: Bool {
+            var lower = data.startIndex
+            var upper = data.endIndex
+            while lower < upper, Self.isWhitespace(data[lower]) { lower += 1 }
+            while upper > lower, Self.isWhitespace(data[upper - 1]) { upper -= 1 }
+            return data[lower..<upper].elementsEqual("[DONE]".utf8)
+        }
+
+        private static func isWhitespace(_ byte: UInt8) -> Bool {
+            byte == 0x20 || byte == 0x09 || byte == 0x0A || byte == 0x0D
+        }
+    }
+
+    /// Emit every `data:` line as its own event instead of joining lines until
+    /// a blank line. Chat Completions servers put one JSON chunk per line and
+    /// some never send the blank separator.
+    var dispatchesEachDataLine: Bool
+
+    /// Lines that were not SSE fields, kept so a plain JSON body can still be
+    /// decoded when a server ignores `stream: true`.
+    private(set) var nonSSELines: [String] = []
+
+    private var line: [UInt8] = []
+    private var eventName: String?
+    private var data: [UInt8] = []
+    private var hasData = false
+
+    init(dispatchesEachDataLine: Bool = false) {
+        self.dispatchesEachDataLine = dispatchesEachDataLine
+        line.reserveCapacity(1024)
+    }
+
+    mutating func feed(_ byte: UInt8) -> Event? {
+        guard byte == 0x0A else { // LF
+            line.append(byte)
+            return nil
+        }
+        defer { line.removeAll(keepingCapacity: true) }
+        return consumeLine()
+    }
+
+    /// Flushes a trailing line without a newline and any pending event.
+    mutating func finish() -> Event? {
+        if !line.isEmpty {
+            let event = consumeLine()
+            line.removeAll(keepingCapacity: true)
+            if event != nil { return event }
+        }
+        return dispatch()
+    }
+
+    private mutating func consumeLine() -> Event? {
+        if line.last == 0x0D { // CR
+            line.removeLast()
+        }
+        if line.isEmpty {
+            return dispatch()
+        }
+        if line.first == UInt8(ascii: ":") {
+            return nil
+        }
+        if let value = fieldValue(prefix: "event:") {
+            eventName = String(decoding: value, as: UTF8.self)
+            return nil
+        }
+        if let value = fieldValue(prefix: "data:") {
+            if hasData {
+                data.append(0x0A)
+            }
+            data.append(contentsOf: value)
+            hasData = true
+            return dispatchesEachDataLine ? dispatch() : nil
+        }
+        nonSSELines.append(String(decoding: line, as: UTF8.self))
+        return nil
+    }
+
+    private mutating func dispatch() -> Event? {
+        guard hasData else {
+            eventName = nil
+            return nil
+        }
+        let event = Event(name: eventName, data: data)
+        data.removeAll(keepingCapacity: true)
+        hasData = false
+        eventName = nil
+        return event
+    }
+
+    /// Mirrors `OpenAIResponsesService.sseFieldValue`: one space after the
+    /// colon belongs to the framing, not the value.
+    private func fieldValue(prefix: StaticString) -> ArraySlice<UInt8>? {
+        let count = prefix.utf8CodeUnitCount
+        guard line.count >= count else { return nil }
+        let matches = prefix.withUTF8Buffer { expected in
+            line.prefix(count).elementsEqual(expected)
+        }
+        guard matches else { return nil }
+        var value = line[count...]
+        if value.first == 0x20 {
+            value = value.dropFirst()
+        }
+        return value
+    }
+}
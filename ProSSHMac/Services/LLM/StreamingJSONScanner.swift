@@ -0,0 +1,307 @@
+import Foundation
+
+/// Single-pass JSON tokenizer over UTF-8 bytes for the streaming providers'
+/// per-delta hot path. Every scalar is reported with its key path instead of
+/// being built into a Foundation object graph, so a text delta costs one walk
+/// and a few small strings. Structural events (whole output items, completed
+/// responses) still go through `JSONSerialization`/`JSONDecoder`.
+nonisolated enum StreamingJSONScanner {
+    enum PathComponent: Equatable, Sendable {
+        case key(String)
+        case index(Int)
+    }
+
+    enum Scalar: Equatable, Sendable {
+        case string(String)
+        case number(Double)
+        case bool(Bool)
+        case null
+    }
+
+    /// Calls `visit` for each scalar in document order. Returns false when
+    /// `bytes` is not exactly one well-formed JSON value.
+    @discardableResult
+    static func scan(_ bytes: [UInt8], visit: ([PathComponent], Scalar) -> Void) -> Bool {
+        bytes.withUnsafeBufferPointer { buffer in
+            var tokenizer = Tokenizer(bytes: buffer)
+            var path: [PathComponent] = []
+            path.reserveCapacity(8)
+            guard tokenizer.value(path: &path, visit: visit) else { return false }
+            tokenizer.skipWhitespace()
+            return tokenizer.position == buffer.count
+        }
+    }
+
+    /// Follows a JSON object or array arriving in fragments, such as streamed
+    /// tool-call arguments, and notes when it closes without reparsing what
+    /// already arrived. Only nesting and strings are tracked; the value is
+    /// not validated.
+    struct ClosureTracker: Sendable {
+        private var depth = 0
+        private var isInString = false
+        private var isEscaped = false
+        private(set) var isClosed = false
+
+        init() {}
+
+        mutating func feed(_ fragment: String) {
+            for byte in fragment.utf8 where !isClosed {
+                if isInString {
+                    if isEscaped {
+                        isEscaped = false
+                    } else if byte == UInt8(ascii: "\\") {
+                        isEscaped = true
+                    } else if byte == UInt8(ascii: "\"") {
+                        isInString = false
+                    }
+                    continue
+                }
+                switch byte {
+                case UInt8(ascii: "\""):
+                    isInString = true
+                case UInt8(ascii: "{"), UInt8(ascii: "["):
+                    depth += 1
+                case UInt8(ascii: "}"), UInt8(ascii: "]"):
+                    depth -= 1
+                    isClosed = depth == 0
+                default:
+                    break
+                }
+            }
+        }
+    }
+
+    private struct Tokenizer {
+        let bytes: UnsafeBufferPointer<UInt8>
+        var position = 0
+
+        init(bytes: UnsafeBufferPointer<UInt8>) {
+            self.bytes = bytes
+        }
+
+        mutating func skipWhitespace() {
+            while position < bytes.count {
+                switch bytes[position] {
+                case 0x20, 0x09, 0x0A, 0x0D: position += 1
+                default: return
+                }
+            }
+        }
+
+        mutating func value(
+            path: inout [PathComponent],
+            visit: ([PathComponent], Scalar) -> Void
+        ) -> Bool {
+            skipWhitespace()
+            guard position < bytes.count else { return false }
+            switch bytes[position] {
+            case UInt8(ascii: "{"):
+                return object(path: &path, visit: visit)
+            case UInt8(ascii: "["):
+                return array(path: &path, visit: visit)
+            case UInt8(ascii: "\""):
+                guard let string = string() else { return false }
+                visit(path, .string(string))
+            case UInt8(ascii: "t"):
+                guard literal("true") else { return false }
+                visit(path, .bool(true))
+            case UInt8(ascii: "f"):
+                guard literal("false") else { return false }
+                visit(path, .bool(false))
+            case UInt8(ascii: "n"):
+                guard literal("null") else { return false }
+                visit(path, .null)
+            default:
+                guard let number = number() else { return false }
+                visit(path, .number(number))
+            }
+            return true
+        }
+
+        private mutating func object(
+            path: inout [PathComponent],
+            visit: ([PathComponent], Scalar) -> Void
+        ) -> Bool {
+            position += 1
+            skipWhitespace()
+            if position < bytes.count, bytes[position] == UInt8(ascii: "}") {
+                position += 1
+                return true
+            }
+            while true {
+                skipWhitespace()
+                guard position < bytes.count, bytes[position] == UInt8(ascii: "\""),
+                      let key = string() else {
+                    return false
+                }
+                skipWhitespace()
+                guard position < bytes.count, bytes[position] == UInt8(ascii: ":") else { return false }
+                position += 1
+
+                path.append(.key(key))
+                let parsed = value(path: &path, visit: visit)
+                path.removeLast()
+                guard parsed else { return false }
+
+                skipWhitespace()
+                guard position < bytes.count else { return false }
+                switch bytes[position] {
+                case UInt8(ascii: ","):
+                    position += 1
+                case UInt8(ascii: "}"):
+                    position += 1
+                    return true
+                default:
+                    return false
+                }
+            }
+        }
+
+        private mutating func array(
+            path: inout [PathComponent],
+            visit: ([PathComponent], Scalar) -> Void
+        ) -> Bool {
+            position += 1
+            skipWhitespace()
+            if position < bytes.count, bytes[position] == UInt8(ascii: "]") {
+                position += 1
+                return true
+            }
+            var index = 0
+            while true {
+                path.append(.index(index))
+                let parsed = value(path: &path, visit: visit)
+                path.removeLast()
+                guard parsed else { return false }
+                index += 1
+
+                skipWhitespace()
+                guard position < bytes.count else { return false }
+                switch bytes[position] {
+                case UInt8(ascii: ","):
+                    position += 1
+                case UInt8(ascii: "]"):
+                    position += 1
+                    return true
+                default:
+                    return false
+                }
+            }
+        }
+
+        /// Reads a string starting at its opening quote. Unescaped strings,
+        /// the common case for deltas, are decoded straight from the buffer.
+        private mutating func string() -> String? {
+            position += 1
+            let start = position
+            while position < bytes.count {
+                let byte = bytes[position]
+                if byte == UInt8(ascii: "\"") {
+                    let result = String(decoding: UnsafeBufferPointer(rebasing: bytes[start..<position]), as: UTF8.self)
+                    position += 1
+                    return result
+                }
+                if byte == UInt8(ascii: "\\") {
+                    return escapedString(from: start)
+                }
+                position += 1
+            }
+            return nil
+        }
+
+        private mutating func escapedString(from start: Int) -> String? {
+            var decoded: [UInt8] = Array(bytes[start..<position])
+            decoded.reserveCapacity(decoded.count + 32)
+            while position < bytes.count {
+                let byte = bytes[position]
+                position += 1
+                if byte == UInt8(ascii: "\"") {
+                    return String(decoding: decoded, as: UTF8.self)
+                }
+                guard byte == UInt8(ascii: "\\") else {
+                    decoded.append(byte)
+                    continue
+                }
+                guard position < bytes.count else { return nil }
+                let escape = bytes[position]
+                position += 1
+                switch escape {
+                case UInt8(ascii: "\""): decoded.append(UInt8(ascii: "\""))
+                case UInt8(ascii: "\\"): decoded.append(UInt8(ascii: "\\"))
+                case UInt8(ascii: "/"): decoded.append(UInt8(ascii: "/"))
+                case UInt8(ascii: "b"): decoded.append(0x08)
+                case UInt8(ascii: "f"): decoded.append(0x0C)
+                case UInt8(ascii: "n"): decoded.append(0x0A)
+                case UInt8(ascii: "r"): decoded.append(0x0D)
+                case UInt8(ascii: "t"): decoded.append(0x09)
+                case UInt8(ascii: "u"):
+                    guard let codeUnit = hexCodeUnit() else { return nil }
+                    var scalarValue = UInt32(codeUnit)
+                    if (0xD800...0xDBFF).contains(codeUnit),
+                       position + 1 < bytes.count,
+                       bytes[position] == UInt8(ascii: "\\"),
+                       bytes[position + 1] == UInt8(ascii: "u") {
+                        let resume = position
+                        position += 2
+                        if let low = hexCodeUnit(), (0xDC00...0xDFFF).contains(low) {
+                            scalarValue = 0x10000 + ((UInt32(codeUnit) - 0xD800) << 10) + (UInt32(low) - 0xDC00)
+                        } else {
+                            position = resume
+                        }
+                    }
+                    let scalar = Unicode.Scalar(scalarValue) ?? "\u{FFFD}"
+                    decoded.append(contentsOf: String(Character(scalar)).utf8)
+                default:
+                    return nil
+                }
+            }
+            return nil
+        }
+
+        private mutating func hexCodeUnit() -> UInt16? {
+            guard position + 4 <= bytes.count else { return nil }
+            var result: UInt16 = 0
+            for _ in 0..<4 {
+                let byte = bytes[position]
+                let digit: UInt8
+                switch byte {
+                case UInt8(ascii: "0")...UInt8(ascii: "9"): digit = byte - UInt8(ascii: "0")
+                case UInt8(ascii: "a")...UInt8(ascii: "f"): digit = byte - UInt8(ascii: "a") + 10
+                case UInt8(ascii: "A")...UInt8(ascii: "F"): digit = byte - UInt8(ascii: "A") + 10
+                default: return nil
+                }
+                result = result << 4 | UInt16(digit)
+                position += 1
+            }
+            return result
+        }
+
+        private mutating func number() -> Double? {
+            let start = position
+            while position < bytes.count {
+                switch bytes[position] {
+                case UInt8(ascii: "0")...UInt8(ascii: "9"),
+                     UInt8(ascii: "-"), UInt8(ascii: "+"),
+                     UInt8(ascii: "."), UInt8(ascii: "e"), UInt8(ascii: "E"):
+                    position += 1
+                default:
+                    guard position > start else { return nil }
+                    return Double(String(decoding: UnsafeBufferPointer(rebasing: bytes[start..<position]), as: UTF8.self))
+                }
+            }
+            guard position > start else { return nil }
+            return Double(String(decoding: UnsafeBufferPointer(rebasing: bytes[start..<position]), as: UTF8.self))
+        }
+
+        private mutating func literal(_ word: StaticString) -> Bool {
+            let count = word.utf8CodeUnitCount
+            guard position + count <= bytes.count else { return false }
+            let matches = word.withUTF8Buffer { expected in
+                (0..<count).allSatisfy { bytes[position + $0] == expected[$0] }
+            }
+            guard matches else { return false }
+            position += count
+            return true
+        }
+    }
+}
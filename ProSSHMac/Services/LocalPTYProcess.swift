@@ -2,20 +2,37 @@
 // ProSSHMac
 //
 // Minimal PTY process: forkpty, read loop, write, resize, close.
+//
+// The master FD is non-blocking and driven by dispatch sources instead of
+// polling. The reader reads straight into a `ShellOutputRing`, the same
+// zero-copy ring SSH channels fill, so the parser consumes local output in
+// place. It parks on read readiness when the FD is drained, and the ring
+// parks it when the parser falls behind. Writes are queued, interactive
+// ahead of bulk, and flushed whenever the FD reports writability, not
+// retried on a 1 ms sleep.
 
 import Foundation
 import Darwin
 
 actor LocalPTYProcess {
-    nonisolated let rawOutput: AsyncStream<Data>
+    /// Shell output, written by the reader and consumed in place by the
+    /// parser. Consume either this ring or `rawOutput`, never both.
+    nonisolated let outputRing: ShellOutputRing
 
     private let masterFD: Int32
     private let childPID: pid_t
-    private let continuation: AsyncStream<Data>.Continuation
+    private let readReadiness: FileDescriptorReadiness
+    private let writeReadiness: FileDescriptorReadiness
     private var readerTask: Task<Void, Never>?
+    private var writerTask: Task<Void, Never>?
+    private var interactiveQueue = PTYWriteQueue()
+    private var bulkQueue = PTYWriteQueue()
+    private var writeFailure: Int32?
     private var isClosed = false
-    private var didSuppressZshTTYPgrpWarning = false
-    private var zshWarningPrefixCarry = ""
+
+    /// Largest single write; a bulk slice this size lets queued keystrokes
+    /// cut in between slices.
+    private static let writeSlice = 64 * 1024
 
     // MARK: - Spawn
 
@@ -103,53 +120,113 @@ actor LocalPTYProcess {
             _ = fcntl(master, F_SETFL, flags | O_NONBLOCK)
         }
 
-        var capturedContinuation: AsyncStream<Data>.Continuation?
-        let stream = AsyncStream<Data> { cont in capturedContinuation = cont }
-        guard let cont = capturedContinuation else {
-            Darwin.close(master)
-            kill(pid, SIGHUP)
-            throw LocalShellError.ptyAllocationFailed
-        }
-
-        let process = LocalPTYProcess(masterFD: master, childPID: pid, continuation: cont, rawOutput: stream)
+        let process = LocalPTYProcess(masterFD: master, childPID: pid)
         await process.startReader()
         return process
     }
 
-    private init(
-        masterFD: Int32,
-        childPID: pid_t,
-        continuation: AsyncStream<Data>.Continuation,
-        rawOutput: AsyncStream<Data>
-    ) {
+    private init(masterFD: Int32, childPID: pid_t) {
         self.masterFD = masterFD
         self.childPID = childPID
-        self.continuation = continuation
-        self.rawOutput = rawOutput
+        self.outputRing = ShellOutputRing()
+        let queue = DispatchQueue(label: "com.prossh.local-pty", qos: .userInitiated)
+        self.readReadiness = FileDescriptorReadiness(readingFrom: masterFD, queue: queue)
+        self.writeReadiness = FileDescriptorReadiness(writingTo: masterFD, queue: queue)
+    }
+
+    /// Copying bridge for consumers that want discrete chunks rather than ring spans.
+    nonisolated var rawOutput: AsyncStream<Data> {
+        let ring = outputRing
+        return AsyncStream<Data> { continuation in
+            let task = Task.detached {
+                while await ring.waitForReadable() {
+                    let region = ring.readableRegion
+                    continuation.yield(Data(region))
+                    ring.consume(region.count)
+                }
+                continuation.finish()
+            }
+            continuation.onTermination = { _ in task.cancel() }
+        }
     }
 
     // MARK: - Write
 
-    func send(bytes: [UInt8]) async throws {
+    /// Queues `bytes` and writes as much as the PTY takes now. The rest is
+    /// written as the FD becomes writable. A write that failed earlier is
+    /// reported here.
+    func send(bytes: [UInt8], priority: SSHShellWritePriority = .interactive) async throws {
         guard !isClosed, !bytes.isEmpty else { return }
-        var offset = 0
-        while offset < bytes.count {
-            let n = bytes.withUnsafeBufferPointer { buf -> Int in
-                guard let base = buf.baseAddress else { return -1 }
-                return Darwin.write(masterFD, base + offset, bytes.count - offset)
+        if let writeFailure {
+            throw LocalShellError.writeFailed(writeFailure)
+        }
+        switch priority {
+        case .interactive: interactiveQueue.append(bytes)
+        case .bulk: bulkQueue.append(bytes)
+        }
+        guard writerTask == nil else { return }
+        if !flushQueued().drained {
+            startWriter()
+        }
+    }
+
+    /// Bulk bytes not yet written to the PTY.
+    var queuedBulkByteCount: Int {
+        bulkQueue.count
+    }
+
+    /// Drops bulk bytes not yet written to the PTY.
+    func discardQueuedBulk() -> Int {
+        defer { bulkQueue.removeAll() }
+        return bulkQueue.count
+    }
+
+    /// Writes queued bytes, interactive first, until the FD would block.
+    /// The token is taken before writing, so writability that races the
+    /// last write is not lost.
+    private func flushQueued() -> (drained: Bool, token: UInt64) {
+        let token = writeReadiness.generation
+        while !isClosed {
+            let isInteractive = !interactiveQueue.isEmpty
+            guard isInteractive || !bulkQueue.isEmpty else {
+                return (true, token)
             }
-            if n > 0 { offset += n; continue }
-            if n == 0 { continue }
+            let written = isInteractive
+                ? interactiveQueue.write(to: masterFD, maxBytes: Self.writeSlice)
+                : bulkQueue.write(to: masterFD, maxBytes: Self.writeSlice)
+            if written > 0 { continue }
             let err = errno
-            if err == EINTR { continue }
-            if err == EAGAIN || err == EWOULDBLOCK {
-                try await Task.sleep(for: .milliseconds(1))
-                continue
+            if written < 0, err == EINTR { continue }
+            if written == 0 || err == EAGAIN || err == EWOULDBLOCK {
+                return (false, token)
+            }
+            writeFailure = err
+            interactiveQueue.removeAll()
+            bulkQueue.removeAll()
+            return (true, token)
+        }
+        return (true, token)
+    }
+
+    private func startWriter() {
+        let readiness = writeReadiness
+        writerTask = Task { [weak self] in
+            while let self {
+                let (drained, token) = await self.flushWhenWritable()
+                if drained { break }
+                await readiness.wait(after: token)
             }
-            throw LocalShellError.writeFailed(err)
         }
     }
 
+    private func flushWhenWritable() -> (drained: Bool, token: UInt64) {
+        let result = flushQueued()
+        if result.drained {
+            writerTask = nil
+        }
+        return result
+    }
+
     // MARK: - Resize
 
     func resizePTY(columns: Int, rows: Int) async throws {
@@ -170,8 +247,8 @@ actor LocalPTYProcess {
     func close() async {
         guard !isClosed else { return }
         isClosed = true
-        readerTask?.cancel()
-        readerTask = nil
+        writerTask?.cancel()
+        writerTask = nil
         kill(childPID, SIGHUP)
         let pid = childPID
         await withCheckedContinuation { cont in
@@ -181,8 +258,18 @@ actor LocalPTYProcess {
                 cont.resume()
             }
         }
+        // Release a reader parked on readiness or a full ring, and let it
+        // leave the FD before it is closed underneath it.
+        readReadiness.finish()
+        writeReadiness.finish()
+        outputRing.finish()
+        if let readerTask {
+            self.readerTask = nil
+            await readerTask.value
+        }
+        await readReadiness.waitUntilCancelled()
+        await writeReadiness.waitUntilCancelled()
         Darwin.close(masterFD)
-        continuation.finish()
     }
 
     // MARK: - Reader
@@ -190,87 +277,287 @@ actor LocalPTYProcess {
     private func startReader() {
         let fd = masterFD
         let pid = childPID
+        let ring = outputRing
+        let readiness = readReadiness
 
-        readerTask = Task.detached { [weak self] in
-            let bufSize = 65536
-            var buf = [UInt8](repeating: 0, count: bufSize)
+        readerTask = Task.detached(priority: .userInitiated) {
+            await Self.readLoop(fd: fd, ring: ring, readiness: readiness)
 
-            outer: while !Task.isCancelled {
-                // Wait up to 100 ms for data
-                var pfd = pollfd(fd: fd, events: Int16(POLLIN), revents: 0)
-                let pollRet = withUnsafeMutablePointer(to: &pfd) { Darwin.poll($0, 1, 100) }
+            var status: Int32 = 0
+            let exitCode: Int32
+            if waitpid(pid, &status, WNOHANG) > 0, status & 0x7F == 0 {
+                exitCode = (status >> 8) & 0xFF
+            } else {
+                exitCode = 0
+            }
+            let msg = "\r\n[Process completed with exit code \(exitCode)]\r\n"
+            await ring.append(Array(msg.utf8))
+            ring.finish()
+            readiness.finish()
+        }
+    }
 
-                if pollRet == 0 { continue }   // timeout
-                if pollRet < 0 {
-                    if errno == EINTR { continue }
-                    break
+    /// Reads the FD into the ring until EOF or error. Startup output goes
+    /// through `ZshTTYPgrpWarningFilter` via a scratch buffer first; after
+    /// that, reads land directly in ring storage.
+    private nonisolated static func readLoop(
+        fd: Int32,
+        ring: ShellOutputRing,
+        readiness: FileDescriptorReadiness
+    ) async {
+        var filter = ZshTTYPgrpWarningFilter()
+        var scratch = [UInt8](repeating: 0, count: 16 * 1024)
+
+        while true {
+            let token = readiness.generation
+            var result = 0
+            var readErrno: Int32 = 0
+
+            if filter.isActive {
+                result = scratch.withUnsafeMutableBytes { buffer in
+                    Darwin.read(fd, buffer.baseAddress, buffer.count)
                 }
-
-                // Drain all available data in one pass
-                var chunk = Data()
-                inner: while true {
-                    let n = buf.withUnsafeMutableBufferPointer { ptr -> Int in
-                        guard let base = ptr.baseAddress else { return -1 }
-                        return Darwin.read(fd, base, ptr.count)
+                readErrno = errno
+                if result > 0 {
+                    let output = filter.filter(scratch[..<result])
+                    if !output.isEmpty {
+                        await ring.append(output)
                     }
-                    if n > 0 { chunk.append(contentsOf: buf.prefix(n)); continue }
-                    if n == 0 { break outer }
-                    let err = errno
-                    if err == EINTR { continue }
-                    if err == EAGAIN || err == EWOULDBLOCK { break inner }
-                    if err == EIO { break outer }
-                    break outer
+                    if !filter.isActive {
+                        await ring.append(filter.flush())
+                    }
+                    continue
+                }
+            } else {
+                let accepted = await ring.write { region in
+                    guard let base = region.baseAddress else { return 0 }
+                    result = Darwin.read(fd, base, region.count)
+                    readErrno = errno
+                    return max(result, 0)
                 }
+                guard accepted else { return }
+                if result > 0 { continue }
+            }
 
-                if !chunk.isEmpty {
-                    await self?.yieldSanitized(chunk)
+            if result == 0 { break }  // EOF
+            if readErrno == EINTR { continue }
+            if readErrno == EAGAIN || readErrno == EWOULDBLOCK {
+                await readiness.wait(after: token)
+                if readiness.isFinished { break }
+                continue
+            }
+            break  // EIO once the child has exited, or a real error
+        }
+        if filter.isActive {
+            await ring.append(filter.flush())
+        }
+    }
+}
+
+// MARK: - PTYWriteQueue
+
+/// Pending PTY input; bytes from `head` on are unsent.
+private nonisolated struct PTYWriteQueue {
+    private var bytes: [UInt8] = []
+    private var head = 0
+
+    var count: Int { bytes.count - head }
+    var isEmpty: Bool { head == bytes.count }
+
+    mutating func append(_ input: [UInt8]) {
+        if head > 0, head == bytes.count {
+            bytes.removeAll(keepingCapacity: true)
+            head = 0
+        }
+        bytes.append(contentsOf: input)
+    }
+
+    /// One non-blocking write of up to `maxBytes`; returns `write(2)`'s result.
+    mutating func write(to fd: Int32, maxBytes: Int) -> Int {
+        let length = min(count, maxBytes)
+        let written = bytes.withUnsafeBytes { buffer in
+            Darwin.write(fd, buffer.baseAddress! + head, length)
+        }
+        if written > 0 {
+            head += written
+            if head == bytes.count {
+                bytes.removeAll(keepingCapacity: true)
+                head = 0
+            } else if head > 1 << 20, head > bytes.count / 2 {
+                bytes.removeFirst(head)
+                head = 0
+            }
+        }
+        return written
+    }
+
+    mutating func removeAll() {
+        bytes.removeAll()
+        head = 0
+    }
+}
+
+// MARK: - FileDescriptorReadiness
+
+/// Read or write readiness of one FD, from a dispatch source. Same protocol as
+/// `LibSSHReadinessSignal`: take `generation` before a non-blocking call and,
+/// if it would block, `await wait(after:)` with that token. The source is
+/// resumed only while someone waits, so an FD nobody is reading does not
+/// keep firing its level-triggered source.
+nonisolated final class FileDescriptorReadiness: @unchecked Sendable {
+    private let source: DispatchSourceProtocol
+    private let lock = NSLock()
+    private var _generation: UInt64 = 0
+    private var _isFinished = false
+    /// The source is resumed; it starts suspended.
+    private var isArmed = false
+    private var waiters: [CheckedContinuation<Void, Never>] = []
+    private var isCancelled = false
+    private var cancellationWaiters: [CheckedContinuation<Void, Never>] = []
+
+    convenience init(readingFrom fd: Int32, queue: DispatchQueue) {
+        self.init(source: DispatchSource.makeReadSource(fileDescriptor: fd, queue: queue))
+    }
+
+    convenience init(writingTo fd: Int32, queue: DispatchQueue) {
+        self.init(source: DispatchSource.makeWriteSource(fileDescriptor: fd, queue: queue))
+    }
+
+    private init(source: DispatchSourceProtocol) {
+        self.source = source
+        source.setEventHandler { [weak self] in self?.signal() }
+        source.setCancelHandler { [weak self] in self?.didCancel() }
+    }
+
+    var generation: UInt64 {
+        lock.withLock { _generation }
+    }
+
+    var isFinished: Bool {
+        lock.withLock { _isFinished }
+    }
+
+    /// Suspends until the FD is ready after `token`, or the signal finishes.
+    func wait(after token: UInt64) async {
+        await withCheckedContinuation { (continuation: CheckedContinuation<Void, Never>) in
+            let resumeNow: Bool = lock.withLock {
+                if _isFinished || _generation != token {
+                    return true
+                }
+                waiters.append(continuation)
+                if !isArmed {
+                    isArmed = true
+                    source.resume()
                 }
+                return false
+            }
+            if resumeNow {
+                continuation.resume()
             }
+        }
+    }
 
-            var status: Int32 = 0
-            let exitCode: Int32
-            if waitpid(pid, &status, WNOHANG) > 0, status & 0x7F == 0 {
-                exitCode = (status >> 8) & 0xFF
-            } else {
-                exitCode = 0
+    /// Wakes every waiter for good and cancels the source.
+    func finish() {
+        let woken: [CheckedContinuation<Void, Never>] = lock.withLock {
+            guard !_isFinished else { return [] }
+            _isFinished = true
+            source.cancel()
+            // A suspended source never delivers its cancellation and must
+            // not be released suspended.
+            if !isArmed {
+                isArmed = true
+                source.resume()
+            }
+            defer { waiters.removeAll() }
+            return waiters
+        }
+        woken.forEach { $0.resume() }
+    }
+
+    /// Suspends until the source has stopped watching the FD, so the FD can
+    /// be closed. Call after `finish()`.
+    func waitUntilCancelled() async {
+        await withCheckedContinuation { (continuation: CheckedContinuation<Void, Never>) in
+            let resumeNow: Bool = lock.withLock {
+                guard !isCancelled else { return true }
+                cancellationWaiters.append(continuation)
+                return false
+            }
+            if resumeNow {
+                continuation.resume()
             }
-            let msg = "\r\n[Process completed with exit code \(exitCode)]\r\n"
-            await self?.yield(Data(msg.utf8))
-            await self?.finish()
         }
     }
 
-    private func yield(_ data: Data) { continuation.yield(data) }
-    private func yieldSanitized(_ data: Data) {
-        guard !didSuppressZshTTYPgrpWarning,
-              let chunk = String(data: data, encoding: .utf8) else {
-            continuation.yield(data)
-            return
+    private func didCancel() {
+        let woken: [CheckedContinuation<Void, Never>] = lock.withLock {
+            isCancelled = true
+            defer { cancellationWaiters.removeAll() }
+            return cancellationWaiters
         }
+        woken.forEach { $0.resume() }
+    }
 
-        let warningMarker = "zsh: can't set tty pgrp:"
-        var text = zshWarningPrefixCarry + chunk
-        zshWarningPrefixCarry.removeAll(keepingCapacity: false)
+    private func signal() {
+        let woken: [CheckedContinuation<Void, Never>] = lock.withLock {
+            guard !_isFinished else { return [] }
+            _generation &+= 1
+            if isArmed {
+                isArmed = false
+                source.suspend()
+            }
+            defer { waiters.removeAll() }
+            return waiters
+        }
+        woken.forEach { $0.resume() }
+    }
+}
 
-        if let markerRange = text.range(of: warningMarker, options: [.caseInsensitive]) {
+// MARK: - ZshTTYPgrpWarningFilter
+
+/// Drops zsh's "can't set tty pgrp" line, which a GUI-spawned login shell
+/// can print once at startup. Only the first `startupWindow` bytes are
+/// checked, so steady-state output never pays for the String conversion.
+nonisolated struct ZshTTYPgrpWarningFilter {
+    static let startupWindow = 16 * 1024
+    private static let marker = "zsh: can't set tty pgrp:"
+
+    private(set) var isActive = true
+    private var inspectedBytes = 0
+    private var carry = ""
+
+    /// The output to pass on for `chunk`. Holds back a tail that could be
+    /// the start of the warning until the next chunk.
+    mutating func filter(_ chunk: ArraySlice<UInt8>) -> [UInt8] {
+        guard isActive else { return Array(chunk) }
+        inspectedBytes += chunk.count
+        if inspectedBytes >= Self.startupWindow {
+            isActive = false
+        }
+        guard let decoded = String(bytes: chunk, encoding: .utf8) else {
+            return flush() + chunk
+        }
+
+        var text = carry + decoded
+        carry.removeAll(keepingCapacity: false)
+
+        if let markerRange = text.range(of: Self.marker, options: [.caseInsensitive]) {
             let lineStart = text[..<markerRange.lowerBound].lastIndex(of: "\n")
                 .map { text.index(after: $0) } ?? text.startIndex
             let lineEnd = text[markerRange.upperBound...].firstIndex(of: "\n")
                 .map { text.index(after: $0) } ?? text.endIndex
-
             text.removeSubrange(lineStart..<lineEnd)
-            didSuppressZshTTYPgrpWarning = true
-            if !text.isEmpty {
-                continuation.yield(Data(text.utf8))
-            }
-            return
+            isActive = false
+            return Array(text.utf8)
         }
 
+        guard isActive else { return Array(text.utf8) }
+
         let lowercaseText = text.lowercased()
-        let markerLowercase = warningMarker.lowercased()
+        let markerLowercase = Self.marker.lowercased()
         let maxSuffixLength = min(lowercaseText.count, markerLowercase.count - 1)
         var carryLength = 0
-
         if maxSuffixLength > 0 {
             for length in stride(from: maxSuffixLength, through: 1, by: -1) {
                 if lowercaseText.suffix(length) == markerLowercase.prefix(length) {
@@ -279,23 +566,14 @@ actor LocalPTYProcess {
                 }
             }
         }
-
-        if carryLength == 0 {
-            continuation.yield(Data(text.utf8))
-            return
-        }
-
-        let emitCount = text.count - carryLength
-        if emitCount > 0 {
-            continuation.yield(Data(text.prefix(emitCount).utf8))
-        }
-        zshWarningPrefixCarry = String(text.suffix(carryLength))
+        guard carryLength > 0 else { return Array(text.utf8) }
+        carry = String(text.suffix(carryLength))
+        return Array(text.prefix(text.count - carryLength).utf8)
     }
-    private func finish() {
-        if !zshWarningPrefixCarry.isEmpty {
-            continuation.yield(Data(zshWarningPrefixCarry.utf8))
-            zshWarningPrefixCarry.removeAll(keepingCapacity: false)
-        }
-        continuation.finish()
+
+    /// Output held back so far, once the filter is done or the stream ends.
+    mutating func flush() -> [UInt8] {
+        defer { carry.removeAll(keepingCapacity: false) }
+        return Array(carry.utf8)
     }
 }
@@ -7,10 +7,12 @@ import Foundation
 import Darwin
 
 actor LocalShellChannel: SSHShellChannel {
-    nonisolated let rawOutput: AsyncStream<Data>
-
     private let process: LocalPTYProcess
 
+    nonisolated var outputRing: ShellOutputRing? { process.outputRing }
+
+    nonisolated var rawOutput: AsyncStream<Data> { process.rawOutput }
+
     // MARK: - Spawn
 
     static func spawn(
@@ -38,12 +40,11 @@ actor LocalShellChannel: SSHShellChannel {
             workingDirectory: cwd
         )
 
-        return LocalShellChannel(process: process, rawOutput: process.rawOutput)
+        return LocalShellChannel(process: process)
     }
 
-    private init(process: LocalPTYProcess, rawOutput: AsyncStream<Data>) {
+    private init(process: LocalPTYProcess) {
         self.process = process
-        self.rawOutput = rawOutput
     }
 
     // MARK: - SSHShellChannel
@@ -56,6 +57,18 @@ actor LocalShellChannel: SSHShellChannel {
         try await process.send(bytes: bytes)
     }
 
+    func send(bytes: [UInt8], priority: SSHShellWritePriority) async throws {
+        try await process.send(bytes: bytes, priority: priority)
+    }
+
+    func queuedBulkByteCount() async -> Int {
+        await process.queuedBulkByteCount
+    }
+
+    func discardQueuedBulk() async -> Int {
+        await process.discardQueuedBulk()
+    }
+
     func resizePTY(columns: Int, rows: Int) async throws {
         try await process.resizePTY(columns: columns, rows: rows)
     }
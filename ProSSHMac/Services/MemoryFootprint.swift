@@ -0,0 +1,102 @@
+// MemoryFootprint.swift
+// ProSSHV2
+//
+// Per-session memory accounting. Each component that holds memory for a
+// session reports it through `MemoryFootprintReporting`:
+//
+// - TerminalEngine: grid buffers, scrollback and the grapheme side table.
+// - TerminalRenderingCoordinator: stored and fed snapshots, and the cell
+//   buffers of every renderer pulling from a feed.
+// - TerminalHistoryIndex: command blocks and raw output of the running
+//   command.
+// - SessionRecordingCoordinator: recorder output waiting to be written.
+//
+// SessionManager adds the reports up (see SessionManager+MemoryFootprint).
+// The glyph atlas is shared by every pane with the same font, so it is
+// reported once per process rather than per session. Figures are estimates
+// of the memory held, not of allocator overhead.
+
+import Foundation
+
+// MARK: - MemorySubsystem
+
+nonisolated enum MemorySubsystem: String, CaseIterable, Sendable {
+    case grid
+    case scrollback
+    case graphemes
+    case snapshots
+    case historyIndex
+    case recorder
+    case glyphAtlas
+    case cellBuffers
+
+    var label: String {
+        switch self {
+        case .grid: "Grid"
+        case .scrollback: "Scrollback"
+        case .graphemes: "Graphemes"
+        case .snapshots: "Snapshots"
+        case .historyIndex: "History index"
+        case .recorder: "Recorder"
+        case .glyphAtlas: "Glyph atlas"
+        case .cellBuffers: "Cell buffers"
+        }
+    }
+}
+
+// MARK: - MemoryFootprint
+
+/// Bytes held, by subsystem.
+nonisolated struct MemoryFootprint: Sendable, Equatable {
+
+    private(set) var bytesBySubsystem: [MemorySubsystem: Int] = [:]
+
+    init() {}
+
+    init(_ subsystem: MemorySubsystem, bytes: Int) {
+        self[subsystem] = bytes
+    }
+
+    subscript(subsystem: MemorySubsystem) -> Int {
+        get { bytesBySubsystem[subsystem] ?? 0 }
+        set { bytesBySubsystem[subsystem] = max(newValue, 0) }
+    }
+
+    var totalBytes: Int {
+        bytesBySubsystem.values.reduce(0, +)
+    }
+
+    static func + (lhs: MemoryFootprint, rhs: MemoryFootprint) -> MemoryFootprint {
+        var sum = lhs
+        sum += rhs
+        return sum
+    }
+
+    static func += (lhs: inout MemoryFootprint, rhs: MemoryFootprint) {
+        for (subsystem, bytes) in rhs.bytesBySubsystem {
+            lhs[subsystem] += bytes
+        }
+    }
+
+    /// One line per non-empty subsystem, largest first, then the total.
+    var summary: String {
+        let lines = bytesBySubsystem
+            .filter { $0.value > 0 }
+            .sorted { $0.value != $1.value ? $0.value > $1.value : $0.key.rawValue < $1.key.rawValue }
+            .map { "\($0.key.label): \(Self.format($0.value))" }
+        return (lines + ["Total: \(Self.format(totalBytes))"]).joined(separator: "\n")
+    }
+
+    static func format(_ bytes: Int) -> String {
+        ByteCountFormatter.string(fromByteCount: Int64(bytes), countStyle: .memory)
+    }
+}
+
+// MARK: - MemoryFootprintReporting
+
+/// A component holding memory on behalf of sessions.
+protocol MemoryFootprintReporting: Sendable {
+    /// Bytes this component holds for `sessionID`. Components that belong
+    /// to a single session (a TerminalEngine) report everything they hold.
+    func memoryFootprint(for sessionID: UUID) async -> MemoryFootprint
+}
@@ -0,0 +1,41 @@
+// MemoryPressureMonitor.swift
+// ProSSHV2
+//
+// Delivers the system's memory pressure notifications on the main actor.
+// SessionManager answers them by giving memory back (see
+// SessionManager+MemoryFootprint).
+
+import Foundation
+
+final class MemoryPressureMonitor {
+
+    enum Level: Sendable {
+        case warning
+        case critical
+    }
+
+    /// Marked `nonisolated(unsafe)` so deinit can cancel it.
+    nonisolated(unsafe) private let source: DispatchSourceMemoryPressure
+
+    /// Start listening. `handler` runs on the main actor for each warning
+    /// or critical event; a return to normal is not reported.
+    init(handler: @escaping (Level) -> Void) {
+        let source = DispatchSource.makeMemoryPressureSource(eventMask: [.warning, .critical], queue: .main)
+        source.setEventHandler { [weak source] in
+            guard let event = source?.data else { return }
+            MainActor.assumeIsolated {
+                if event.contains(.critical) {
+                    handler(.critical)
+                } else if event.contains(.warning) {
+                    handler(.warning)
+                }
+            }
+        }
+        source.activate()
+        self.source = source
+    }
+
+    deinit {
+        source.cancel()
+    }
+}
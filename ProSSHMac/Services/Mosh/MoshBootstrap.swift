@@ -0,0 +1,71 @@
+// MoshBootstrap.swift
+// ProSSHV2
+//
+// Starts mosh-server over an authenticated SSH session, the way the mosh
+// client's wrapper script does. `mosh-server new` forks a detached server
+// bound to a UDP port and prints one line before exiting:
+//
+//     MOSH CONNECT <port> <22-character base64 key>
+//
+// The SSH session stays up afterwards for SFTP, forwards and exec; only
+// the interactive terminal moves to UDP.
+
+import Foundation
+
+nonisolated enum MoshBootstrap {
+
+    /// `-s` binds to the address the SSH connection arrived on, `-c 256`
+    /// advertises 256 colours, and `-l` sets the locale mosh-server insists
+    /// on being UTF-8.
+    static let serverCommand = "mosh-server new -s -c 256 -l LANG=en_US.UTF-8"
+
+    static let startTimeout: Duration = .seconds(15)
+
+    struct Endpoint: Sendable, Equatable {
+        var port: UInt16
+        var key: String
+    }
+
+    /// Finds the `MOSH CONNECT` line in mosh-server's startup output.
+    static func parseConnectLine(_ output: String) throws -> Endpoint {
+        for line in output.split(whereSeparator: \.isNewline) {
+            let fields = line.split(separator: " ", omittingEmptySubsequences: true)
+            guard fields.count >= 2, fields[0] == "MOSH", fields[1] == "CONNECT" else { continue }
+            guard fields.count == 4, let port = UInt16(fields[2]), port != 0 else {
+                throw MoshError.malformedConnectLine(String(line))
+            }
+            return Endpoint(port: port, key: String(fields[3]))
+        }
+        throw MoshError.serverNotFound(details: "")
+    }
+
+    /// Starts mosh-server on the session's host and connects to it.
+    static func start(
+        sessionID: UUID,
+        transport: any SSHTransporting,
+        hostname: String,
+        pty: PTYConfiguration
+    ) async throws -> MoshShellChannel {
+        let result = try await transport.executeCommand(
+            sessionID: sessionID,
+            command: serverCommand,
+            timeout: startTimeout,
+            maxOutputBytes: 64 * 1024
+        )
+        let stdout = String(decoding: result.stdout, as: UTF8.self)
+        let endpoint: Endpoint
+        do {
+            endpoint = try parseConnectLine(stdout)
+        } catch MoshError.serverNotFound {
+            let stderr = String(decoding: result.stderr, as: UTF8.self)
+                .trimmingCharacters(in: .whitespacesAndNewlines)
+            throw MoshError.serverNotFound(details: result.timedOut ? "timed out" : stderr)
+        }
+        return try await MoshShellChannel.open(
+            hostname: hostname,
+            endpoint: endpoint,
+            columns: pty.columns,
+            rows: pty.rows
+        )
+    }
+}
@@ -0,0 +1,317 @@
+// MoshCrypto.swift
+// ProSSHV2
+//
+// Datagram sealing for the mosh transport. Every packet is AES-128-OCB
+// (RFC 7253, 128-bit tag, no associated data) under the key mosh-server
+// prints at startup. The 96-bit nonce is four zero bytes and a 64-bit
+// sequence number whose top bit gives the direction, and the sequence
+// number travels in the clear in front of the ciphertext:
+//
+//     seq (8, big-endian) | OCB(timestamp (2) | timestamp reply (2) | payload) | tag (16)
+//
+// CommonCrypto has no OCB mode, so the mode is built here on its AES-ECB
+// block primitive. Packets are a few hundred bytes, so the per-block
+// `CCCryptorUpdate` call is not worth avoiding.
+
+import Foundation
+import CommonCrypto
+
+// MARK: - MoshError
+
+nonisolated enum MoshError: LocalizedError, Sendable {
+    case serverNotFound(details: String)
+    case malformedConnectLine(String)
+    case invalidKey
+    case cipherUnavailable
+    case malformedPacket
+    case authenticationFailed
+    case unsupportedProtocolVersion(UInt32)
+    case decompressionFailed
+
+    var errorDescription: String? {
+        switch self {
+        case .serverNotFound(let details):
+            return details.isEmpty
+                ? "mosh-server did not start on the remote host."
+                : "mosh-server did not start on the remote host: \(details)"
+        case .malformedConnectLine(let line):
+            return "Unexpected reply from mosh-server: \(line)"
+        case .invalidKey:
+            return "mosh-server printed a session key that is not 22 base64 characters."
+        case .cipherUnavailable:
+            return "AES is unavailable."
+        case .malformedPacket:
+            return "Malformed mosh datagram."
+        case .authenticationFailed:
+            return "A mosh datagram failed authentication."
+        case .unsupportedProtocolVersion(let version):
+            return "mosh-server speaks protocol version \(version); version \(MoshTransportInstruction.protocolVersion) is supported."
+        case .decompressionFailed:
+            return "A mosh instruction could not be decompressed."
+        }
+    }
+}
+
+// MARK: - MoshPacket
+
+/// One datagram's plaintext: the sender's clock, an echo of the receiver's
+/// last clock (for round-trip estimates), and a transport fragment.
+nonisolated struct MoshPacket: Sendable, Equatable {
+    /// `timestampReply` of a packet with nothing to echo.
+    static let noTimestamp: UInt16 = 0xFFFF
+
+    /// Direction bit of a sequence number, set on server-to-client packets.
+    static let toClientBit: UInt64 = 1 << 63
+
+    var sequence: UInt64
+    var timestamp: UInt16
+    var timestampReply: UInt16
+    var payload: [UInt8]
+}
+
+// MARK: - MoshCryptoSession
+
+nonisolated final class MoshCryptoSession: @unchecked Sendable {
+    // @unchecked: the cryptors are immutable after init, and ECB updates
+    // carry no state between calls.
+
+    private let cipher: AES128OCB
+
+    /// `key` is the 22-character unpadded base64 key from `MOSH CONNECT`.
+    init(base64Key key: String) throws {
+        guard key.count == 22, let raw = Data(base64Encoded: key + "=="), raw.count == 16 else {
+            throw MoshError.invalidKey
+        }
+        self.cipher = try AES128OCB(key: [UInt8](raw))
+    }
+
+    /// Seals a client-to-server packet.
+    func seal(_ packet: MoshPacket) -> [UInt8] {
+        var plaintext: [UInt8] = []
+        plaintext.reserveCapacity(4 + packet.payload.count)
+        plaintext.append(UInt8(packet.timestamp >> 8))
+        plaintext.append(UInt8(packet.timestamp & 0xFF))
+        plaintext.append(UInt8(packet.timestampReply >> 8))
+        plaintext.append(UInt8(packet.timestampReply & 0xFF))
+        plaintext.append(contentsOf: packet.payload)
+
+        let sequence = Self.bigEndianBytes(packet.sequence)
+        var datagram = sequence
+        datagram.append(contentsOf: cipher.seal(plaintext, nonce: [0, 0, 0, 0] + sequence))
+        return datagram
+    }
+
+    /// Opens a server-to-client packet. Packets sealed for the other
+    /// direction are rejected, so a reflected datagram is never accepted.
+    func open(_ datagram: [UInt8]) throws -> MoshPacket {
+        guard datagram.count >= 8 + 4 + AES128OCB.tagLength else { throw MoshError.malformedPacket }
+        let sequenceBytes = Array(datagram[0..<8])
+        let sequence = sequenceBytes.reduce(UInt64(0)) { $0 << 8 | UInt64($1) }
+        guard sequence & MoshPacket.toClientBit != 0 else { throw MoshError.malformedPacket }
+        let plaintext = try cipher.open(datagram[8...], nonce: [0, 0, 0, 0] + sequenceBytes)
+        return MoshPacket(
+            sequence: sequence & ~MoshPacket.toClientBit,
+            timestamp: UInt16(plaintext[0]) << 8 | UInt16(plaintext[1]),
+            timestampReply: UInt16(plaintext[2]) << 8 | UInt16(plaintext[3]),
+            payload: Array(plaintext[4...])
+        )
+    }
+
+    private static func bigEndianBytes(_ value: UInt64) -> [UInt8] {
+        (0..<8).map { UInt8(truncatingIfNeeded: value >> (56 - 8 * $0)) }
+    }
+}
+
+// MARK: - AES128OCB
+
+/// AES-128-OCB with a 128-bit tag and no associated data, which is all
+/// mosh uses.
+nonisolated final class AES128OCB: @unchecked Sendable {
+    // @unchecked: see MoshCryptoSession.
+
+    static let tagLength = 16
+
+    private let encryptor: CCCryptorRef
+    private let decryptor: CCCryptorRef
+    private let lStar: Block
+    private let lDollar: Block
+    /// L_i for i = ntz(block index); 32 levels cover any datagram.
+    private let lTable: [Block]
+
+    init(key: [UInt8]) throws {
+        guard key.count == kCCKeySizeAES128 else { throw MoshError.invalidKey }
+        var encryptor: CCCryptorRef?
+        var decryptor: CCCryptorRef?
+        let encryptStatus = CCCryptorCreate(
+            CCOperation(kCCEncrypt), CCAlgorithm(kCCAlgorithmAES), CCOptions(kCCOptionECBMode),
+            key, key.count, nil, &encryptor
+        )
+        let decryptStatus = CCCryptorCreate(
+            CCOperation(kCCDecrypt), CCAlgorithm(kCCAlgorithmAES), CCOptions(kCCOptionECBMode),
+            key, key.count, nil, &decryptor
+        )
+        guard encryptStatus == kCCSuccess, decryptStatus == kCCSuccess,
+              let encryptor, let decryptor else {
+            if let encryptor { CCCryptorRelease(encryptor) }
+            if let decryptor { CCCryptorRelease(decryptor) }
+            throw MoshError.cipherUnavailable
+        }
+        self.encryptor = encryptor
+        self.decryptor = decryptor
+
+        let lStar = Self.apply(encryptor, to: .zero)
+        let lDollar = lStar.doubled
+        self.lStar = lStar
+        self.lDollar = lDollar
+        var table = [lDollar.doubled]
+        for _ in 1..<32 {
+            table.append(table[table.count - 1].doubled)
+        }
+        self.lTable = table
+    }
+
+    deinit {
+        CCCryptorRelease(encryptor)
+        CCCryptorRelease(decryptor)
+    }
+
+    /// Returns ciphertext followed by the tag.
+    func seal(_ plaintext: [UInt8], nonce: [UInt8]) -> [UInt8] {
+        var output: [UInt8] = []
+        output.reserveCapacity(plaintext.count + Self.tagLength)
+        var offset = initialOffset(nonce: nonce)
+        var checksum = Block.zero
+
+        let fullBlocks = plaintext.count / 16
+        for index in 0..<fullBlocks {
+            let block = Block(plaintext[(index * 16)..<(index * 16 + 16)])
+            offset = offset ^ lTable[(index + 1).trailingZeroBitCount]
+            checksum = checksum ^ block
+            output.append(contentsOf: (Self.apply(encryptor, to: block ^ offset) ^ offset).bytes)
+        }
+        let remainder = plaintext[(fullBlocks * 16)...]
+        if !remainder.isEmpty {
+            offset = offset ^ lStar
+            let pad = Self.apply(encryptor, to: offset).bytes
+            for (index, byte) in remainder.enumerated() {
+                output.append(byte ^ pad[index])
+            }
+            checksum = checksum ^ Block(paddingPartial: remainder)
+        }
+        output.append(contentsOf: Self.apply(encryptor, to: checksum ^ offset ^ lDollar).bytes)
+        return output
+    }
+
+    /// Verifies the trailing tag and returns the plaintext.
+    func open(_ sealed: ArraySlice<UInt8>, nonce: [UInt8]) throws -> [UInt8] {
+        guard sealed.count >= Self.tagLength else { throw MoshError.malformedPacket }
+        let ciphertext = sealed.dropLast(Self.tagLength)
+        let tag = sealed.suffix(Self.tagLength)
+        var plaintext: [UInt8] = []
+        plaintext.reserveCapacity(ciphertext.count)
+        var offset = initialOffset(nonce: nonce)
+        var checksum = Block.zero
+
+        let start = ciphertext.startIndex
+        let fullBlocks = ciphertext.count / 16
+        for index in 0..<fullBlocks {
+            let block = Block(ciphertext[(start + index * 16)..<(start + index * 16 + 16)])
+            offset = offset ^ lTable[(index + 1).trailingZeroBitCount]
+            let decrypted = Self.apply(decryptor, to: block ^ offset) ^ offset
+            checksum = checksum ^ decrypted
+            plaintext.append(contentsOf: decrypted.bytes)
+        }
+        let remainder = ciphertext[(start + fullBlocks * 16)...]
+        if !remainder.isEmpty {
+            offset = offset ^ lStar
+            let pad = Self.apply(encryptor, to: offset).bytes
+            let tail = remainder.enumerated().map { $0.element ^ pad[$0.offset] }
+            checksum = checksum ^ Block(paddingPartial: tail[...])
+            plaintext.append(contentsOf: tail)
+        }
+        let expected = Self.apply(encryptor, to: checksum ^ offset ^ lDollar).bytes
+        var difference: UInt8 = 0
+        for (lhs, rhs) in zip(expected, tag) {
+            difference |= lhs ^ rhs
+        }
+        guard difference == 0 else { throw MoshError.authenticationFailed }
+        return plaintext
+    }
+
+    // MARK: Private
+
+    /// Offset_0 for a 96-bit nonce (RFC 7253 section 4.2).
+    private func initialOffset(nonce: [UInt8]) -> Block {
+        var nonceBlock: [UInt8] = [0, 0, 0, 1] + nonce
+        let bottom = Int(nonceBlock[15] & 0x3F)
+        nonceBlock[15] &= 0xC0
+        let ktop = Self.apply(encryptor, to: Block(nonceBlock[...])).bytes
+        let stretch = ktop + (0..<8).map { ktop[$0] ^ ktop[$0 + 1] }
+        let byteShift = bottom / 8
+        let bitShift = bottom % 8
+        var offset = [UInt8](repeating: 0, count: 16)
+        for index in 0..<16 {
+            let high = stretch[index + byteShift] << bitShift
+            let low = bitShift == 0 ? 0 : stretch[index + byteShift + 1] >> (8 - bitShift)
+            offset[index] = high | low
+        }
+        return Block(offset[...])
+    }
+
+    private static func apply(_ cryptor: CCCryptorRef, to block: Block) -> Block {
+        let input = block.bytes
+        var output = [UInt8](repeating: 0, count: 16)
+        var moved = 0
+        _ = CCCryptorUpdate(cryptor, input, 16, &output, 16, &moved)
+        return Block(output[...])
+    }
+
+    /// A 128-bit block as two big-endian halves.
+    nonisolated struct Block: Equatable, Sendable {
+        var high: UInt64
+        var low: UInt64
+
+        static let zero = Block(high: 0, low: 0)
+
+        init(high: UInt64, low: UInt64) {
+            self.high = high
+            self.low = low
+        }
+
+        init(_ bytes: ArraySlice<UInt8>) {
+            var high: UInt64 = 0
+            var low: UInt64 = 0
+            for (index, byte) in bytes.enumerated() {
+                if index < 8 {
+                    high = high << 8 | UInt64(byte)
+                } else {
+                    low = low << 8 | UInt64(byte)
+                }
+            }
+            self.init(high: high, low: low)
+        }
+
+        /// A final partial block followed by a 1 bit and zeros.
+        init(paddingPartial bytes: ArraySlice<UInt8>) {
+            var padded = Array(bytes)
+            padded.append(0x80)
+            padded.append(contentsOf: repeatElement(0, count: 16 - padded.count))
+            self.init(padded[...])
+        }
+
+        var bytes: [UInt8] {
+            (0..<8).map { UInt8(truncatingIfNeeded: high >> (56 - 8 * $0)) }
+                + (0..<8).map { UInt8(truncatingIfNeeded: low >> (56 - 8 * $0)) }
+        }
+
+        /// Multiplication by x in GF(2^128).
+        var doubled: Block {
+            let carry = high >> 63
+            return Block(high: high << 1 | low >> 63, low: low << 1 ^ (carry * 0x87))
+        }
+
+        static func ^ (lhs: Block, rhs: Block) -> Block {
+            Block(high: lhs.high ^ rhs.high, low: lhs.low ^ rhs.low)
+        }
+    }
+}
@@ -0,0 +1,413 @@
+// MoshShellChannel.swift
+// ProSSHV2
+//
+// The interactive terminal over mosh's state-synchronization protocol
+// instead of an SSH channel. Nothing here is a byte stream that can stall:
+// keystrokes are resent until the server acknowledges them, and the
+// server sends the difference between the screen the client last
+// acknowledged and the current one. A lost datagram costs one round trip,
+// and a long outage is followed by a single diff to the present screen,
+// not a replay of everything printed meanwhile.
+//
+// The server's diffs are terminal output that moves a screen from one
+// state to the next. They are what `rawOutput` yields, so they reach the
+// session's `TerminalEngine` like any other output and the grid becomes
+// the client-side copy of the server's screen. The engine holds only the
+// newest state, so a diff is applied only when it starts from that state.
+// Any other diff is dropped and acknowledged, and the server resends one
+// from the state the client has.
+//
+// Roaming: the server follows whichever address authenticated packets
+// arrive from. When the OS reports a better path, when the connection
+// fails, or after `portHopInterval` without hearing from the server, the
+// channel reconnects from a fresh local port.
+
+import Foundation
+import Network
+import os.log
+
+nonisolated actor MoshShellChannel: SSHShellChannel {
+
+    private static let logger = Logger(subsystem: "com.prossh", category: "Mosh")
+
+    /// Fastest rate of new client states, as in mosh.
+    static let sendInterval: Duration = .milliseconds(20)
+    /// Longest quiet spell before a packet is sent anyway.
+    static let heartbeatInterval: Duration = .seconds(3)
+    /// How long an acknowledgement may wait to ride on other traffic.
+    static let ackDelay: Duration = .milliseconds(100)
+    static let minimumRetransmitTimeout: Duration = .milliseconds(50)
+    static let maximumRetransmitTimeout: Duration = .seconds(1)
+    /// Silence after which the channel assumes its path has gone.
+    static let portHopInterval: Duration = .seconds(10)
+    static let reconnectBackoff: Duration = .seconds(1)
+
+    nonisolated let rawOutput: AsyncStream<Data>
+    private nonisolated let outputContinuation: AsyncStream<Data>.Continuation
+    private nonisolated let datagrams: AsyncStream<[UInt8]>
+    private nonisolated let datagramContinuation: AsyncStream<[UInt8]>.Continuation
+
+    private let crypto: MoshCryptoSession
+    private let endpoint: NWEndpoint
+    private let queue = DispatchQueue(label: "com.prossh.mosh")
+    private let clock = ContinuousClock()
+    private let startedAt: ContinuousClock.Instant
+    private var connection: NWConnection?
+    private var readerTask: Task<Void, Never>?
+    private var tickTask: Task<Void, Never>?
+    private var isClosed = false
+
+    // Datagram layer
+    private var nextSequence: UInt64 = 0
+    private var savedTimestamp: (value: UInt16, receivedAt: ContinuousClock.Instant)?
+    /// Smoothed round trip and its variance, in milliseconds.
+    private var smoothedRTT: Double = 1_000
+    private var rttVariance: Double = 500
+    private var hasRTTSample = false
+    private var lastHeardAt: ContinuousClock.Instant
+    private var lastConnectedAt: ContinuousClock.Instant
+
+    // Client states: each send or resize is a new state, kept until the
+    // server acknowledges it.
+    private var unackedStates: [(num: UInt64, event: MoshUserEvent)] = []
+    private var latestStateNum: UInt64 = 0
+    private var serverAckedNum: UInt64 = 0
+    private var hasUnsentState = false
+    private var lastSentAt: ContinuousClock.Instant
+    private var nextInstructionID: UInt64 = 0
+
+    // Server states
+    private var screenStateNum: UInt64 = 0
+    private var ackDueAt: ContinuousClock.Instant?
+    private var assembly = MoshFragmentAssembly()
+
+    private init(endpoint: NWEndpoint, crypto: MoshCryptoSession) {
+        self.endpoint = endpoint
+        self.crypto = crypto
+        let now = ContinuousClock.now
+        self.startedAt = now
+        self.lastHeardAt = now
+        self.lastConnectedAt = now
+        self.lastSentAt = now
+        let (output, outputContinuation) = AsyncStream<Data>.makeStream()
+        self.rawOutput = output
+        self.outputContinuation = outputContinuation
+        let (datagrams, datagramContinuation) = AsyncStream<[UInt8]>.makeStream()
+        self.datagrams = datagrams
+        self.datagramContinuation = datagramContinuation
+    }
+
+    static func open(
+        hostname: String,
+        endpoint: MoshBootstrap.Endpoint,
+        columns: Int,
+        rows: Int
+    ) async throws -> MoshShellChannel {
+        let crypto = try MoshCryptoSession(base64Key: endpoint.key)
+        let channel = MoshShellChannel(
+            endpoint: .hostPort(host: NWEndpoint.Host(hostname), port: NWEndpoint.Port(rawValue: endpoint.port)!),
+            crypto: crypto
+        )
+        await channel.start(columns: columns, rows: rows)
+        return channel
+    }
+
+    private func start(columns: Int, rows: Int) {
+        let datagrams = self.datagrams
+        readerTask = Task { [weak self] in
+            for await datagram in datagrams {
+                guard let self else { return }
+                await self.receive(datagram)
+            }
+        }
+        connect()
+        // The server's screen starts at 80x24 until told otherwise.
+        append(.resize(columns: columns, rows: rows))
+    }
+
+    // MARK: SSHShellChannel
+
+    func send(_ input: String) async throws {
+        try await send(bytes: Array(input.utf8))
+    }
+
+    func send(bytes: [UInt8]) async throws {
+        guard !isClosed else {
+            throw SSHTransportError.transportFailure(message: "The mosh session has ended.")
+        }
+        guard !bytes.isEmpty else { return }
+        append(.keystroke(bytes))
+    }
+
+    /// Keystrokes the server has not acknowledged, so a streaming paste
+    /// waits for the link instead of piling into every retransmission.
+    func queuedBulkByteCount() -> Int {
+        unackedStates.reduce(0) { total, state in
+            if case .keystroke(let keys) = state.event { return total + keys.count }
+            return total
+        }
+    }
+
+    func resizePTY(columns: Int, rows: Int) async throws {
+        guard !isClosed else { return }
+        append(.resize(columns: columns, rows: rows))
+    }
+
+    func close() async {
+        guard !isClosed else { return }
+        // Announcing the shutdown state lets mosh-server exit instead of
+        // waiting for a client that will never return.
+        for _ in 0..<3 {
+            transmit(newNum: MoshTransportInstruction.shutdownStateNum)
+            try? await Task.sleep(for: Self.sendInterval)
+        }
+        finish()
+    }
+
+    // MARK: Sending
+
+    private func append(_ event: MoshUserEvent) {
+        latestStateNum += 1
+        unackedStates.append((latestStateNum, event))
+        hasUnsentState = true
+        if clock.now - lastSentAt >= Self.sendInterval {
+            transmit()
+        }
+        scheduleTick()
+    }
+
+    /// Sends the diff from the newest state the server has acknowledged to
+    /// the newest state, along with an acknowledgement of the screen.
+    private func transmit(newNum: UInt64? = nil) {
+        let instruction = MoshTransportInstruction(
+            oldNum: serverAckedNum,
+            newNum: newNum ?? latestStateNum,
+            ackNum: screenStateNum,
+            throwawayNum: serverAckedNum,
+            diff: unackedStates.isEmpty ? [] : MoshUserEvent.encodedDiff(unackedStates.lazy.map { $0.event })
+        )
+        let id = nextInstructionID
+        nextInstructionID += 1
+        for fragment in MoshFragment.fragments(of: instruction, id: id) {
+            sendDatagram(fragment.encoded())
+        }
+        lastSentAt = clock.now
+        hasUnsentState = false
+        ackDueAt = nil
+    }
+
+    private func sendDatagram(_ payload: [UInt8]) {
+        guard let connection else { return }
+        let now = clock.now
+        var reply = MoshPacket.noTimestamp
+        if let saved = savedTimestamp, now - saved.receivedAt < .seconds(1) {
+            // Echo the server's clock advanced by how long we held it, so
+            // its round-trip estimate excludes our delay.
+            reply = saved.value &+ UInt16(truncatingIfNeeded: Self.milliseconds(now - saved.receivedAt))
+            savedTimestamp = nil
+        }
+        let packet = MoshPacket(
+            sequence: nextSequence,
+            timestamp: timestamp(at: now),
+            timestampReply: reply,
+            payload: payload
+        )
+        nextSequence += 1
+        connection.send(content: Data(crypto.seal(packet)), completion: .idempotent)
+    }
+
+    // MARK: Receiving
+
+    private func receive(_ datagram: [UInt8]) {
+        guard !isClosed, let packet = try? crypto.open(datagram) else {
+            // Forged, corrupted or stale: drop silently, as mosh does.
+            return
+        }
+        let now = clock.now
+        lastHeardAt = now
+        if packet.timestamp != MoshPacket.noTimestamp {
+            savedTimestamp = (packet.timestamp, now)
+        }
+        if packet.timestampReply != MoshPacket.noTimestamp {
+            noteRoundTrip(Double(timestamp(at: now) &- packet.timestampReply))
+        }
+        do {
+            guard let instruction = try assembly.add(MoshFragment(decoding: packet.payload)) else { return }
+            try process(instruction, at: now)
+        } catch MoshError.unsupportedProtocolVersion(let version) {
+            Self.logger.error("mosh-server protocol version \(version) is not supported")
+            finish()
+        } catch {
+            Self.logger.debug("Dropped mosh instruction: \(error.localizedDescription)")
+        }
+    }
+
+    private func process(_ instruction: MoshTransportInstruction, at now: ContinuousClock.Instant) throws {
+        guard instruction.protocolVersion == MoshTransportInstruction.protocolVersion else {
+            throw MoshError.unsupportedProtocolVersion(instruction.protocolVersion)
+        }
+        if instruction.ackNum > serverAckedNum, instruction.ackNum <= latestStateNum {
+            serverAckedNum = instruction.ackNum
+            unackedStates.removeAll { $0.num <= instruction.ackNum }
+        }
+
+        if instruction.newNum == MoshTransportInstruction.shutdownStateNum {
+            // The remote shell exited. Acknowledge so the server can go.
+            screenStateNum = instruction.newNum
+            transmit()
+            finish()
+            return
+        }
+        let isNewState = instruction.newNum > screenStateNum
+        if isNewState, instruction.oldNum == screenStateNum {
+            var output = Data()
+            if screenStateNum == 0 {
+                // Diffs from state 0 assume a blank screen at the origin.
+                output.append(contentsOf: Array("\u{1B}[0m\u{1B}[H\u{1B}[2J".utf8))
+            }
+            for event in try MoshHostEvent.decodeDiff(instruction.diff) {
+                if case .hostBytes(let bytes) = event {
+                    output.append(contentsOf: bytes)
+                }
+            }
+            screenStateNum = instruction.newNum
+            if !output.isEmpty {
+                outputContinuation.yield(output)
+            }
+        }
+        // Applied or unusable, the server learns where we are. Duplicates
+        // (the server's heartbeats) need no answer.
+        if isNewState, ackDueAt == nil {
+            ackDueAt = now + Self.ackDelay
+        }
+        scheduleTick()
+    }
+
+    private func noteRoundTrip(_ sample: Double) {
+        guard sample < 5_000 else { return }
+        if hasRTTSample {
+            rttVariance += (abs(smoothedRTT - sample) - rttVariance) / 4
+            smoothedRTT += (sample - smoothedRTT) / 8
+        } else {
+            smoothedRTT = sample
+            rttVariance = sample / 2
+            hasRTTSample = true
+        }
+    }
+
+    // MARK: Timers
+
+    private var retransmitTimeout: Duration {
+        let milliseconds = (smoothedRTT + 4 * rttVariance).rounded(.up)
+        return min(max(.milliseconds(Int(milliseconds)), Self.minimumRetransmitTimeout), Self.maximumRetransmitTimeout)
+    }
+
+    private var nextDeadline: ContinuousClock.Instant {
+        var deadline = lastSentAt + Self.heartbeatInterval
+        if hasUnsentState {
+            deadline = min(deadline, lastSentAt + Self.sendInterval)
+        } else if !unackedStates.isEmpty {
+            deadline = min(deadline, lastSentAt + retransmitTimeout)
+        }
+        if let ackDueAt {
+            deadline = min(deadline, ackDueAt)
+        }
+        return deadline
+    }
+
+    private func scheduleTick() {
+        guard !isClosed else { return }
+        tickTask?.cancel()
+        let deadline = nextDeadline
+        tickTask = Task { [weak self, clock] in
+            try? await Task.sleep(until: deadline, clock: clock)
+            guard !Task.isCancelled else { return }
+            await self?.tick()
+        }
+    }
+
+    private func tick() {
+        guard !isClosed else { return }
+        let now = clock.now
+        let shouldReconnect = connection == nil
+            ? now - lastConnectedAt >= Self.reconnectBackoff
+            : now - lastHeardAt >= Self.portHopInterval && now - lastConnectedAt >= Self.portHopInterval
+        if shouldReconnect {
+            connect()
+        }
+        if now >= nextDeadline {
+            transmit()
+        }
+        scheduleTick()
+    }
+
+    // MARK: Connection
+
+    private func connect() {
+        connection?.cancel()
+        let connection = NWConnection(to: endpoint, using: .udp)
+        let datagrams = datagramContinuation
+        connection.stateUpdateHandler = { [weak self, weak connection] state in
+            guard case .failed(let error) = state, let connection else { return }
+            Task { await self?.connectionFailed(connection, error: error) }
+        }
+        connection.betterPathUpdateHandler = { [weak self] hasBetterPath in
+            guard hasBetterPath else { return }
+            Task { await self?.roam() }
+        }
+        connection.start(queue: queue)
+        Self.receive(on: connection, into: datagrams)
+        self.connection = connection
+        lastConnectedAt = clock.now
+    }
+
+    private nonisolated static func receive(on connection: NWConnection, into datagrams: AsyncStream<[UInt8]>.Continuation) {
+        connection.receiveMessage { content, _, _, error in
+            if let content, !content.isEmpty {
+                datagrams.yield([UInt8](content))
+            }
+            guard error == nil else { return }
+            MoshShellChannel.receive(on: connection, into: datagrams)
+        }
+    }
+
+    private func connectionFailed(_ failed: NWConnection, error: NWError) {
+        guard failed === connection else { return }
+        Self.logger.info("mosh UDP path failed: \(error.localizedDescription); reconnecting")
+        failed.cancel()
+        connection = nil
+        scheduleTick()
+    }
+
+    private func roam() {
+        guard !isClosed else { return }
+        connect()
+        transmit()
+        scheduleTick()
+    }
+
+    private func finish() {
+        guard !isClosed else { return }
+        isClosed = true
+        tickTask?.cancel()
+        readerTask?.cancel()
+        connection?.cancel()
+        connection = nil
+        datagramContinuation.finish()
+        outputContinuation.finish()
+    }
+
+    // MARK: Clock
+
+    /// The 16-bit millisecond clock packets carry. 0xFFFF is reserved for
+    /// "no timestamp".
+    private func timestamp(at instant: ContinuousClock.Instant) -> UInt16 {
+        let value = UInt16(truncatingIfNeeded: Self.milliseconds(instant - startedAt))
+        return value == MoshPacket.noTimestamp ? 0 : value
+    }
+
+    private static func milliseconds(_ duration: Duration) -> Int64 {
+        let (seconds, attoseconds) = duration.components
+        return seconds * 1_000 + attoseconds / 1_000_000_000_000_000
+    }
+}
@@ -0,0 +1,369 @@
+// MoshWireFormat.swift
+// ProSSHV2
+//
+// The state-synchronization protocol above the datagram layer. Each side
+// numbers successive states of what it sends: the client's keystrokes and
+// resizes, the server's screen. A transport instruction carries the diff
+// from a state the receiver is known to have (`oldNum`) to a newer one
+// (`newNum`), acknowledges the newest state received from the peer
+// (`ackNum`), and lets the receiver drop states older than
+// `throwawayNum`. The instruction is a protobuf message, zlib-compressed,
+// and split into fragments that each fit one datagram:
+//
+//     instruction id (8) | fragment number (2, top bit = last) | compressed bytes
+//
+// Only the handful of protobuf fields mosh defines are encoded, so the
+// codec is written out here instead of pulling in a protobuf runtime.
+
+import Foundation
+
+// MARK: - MoshTransportInstruction
+
+nonisolated struct MoshTransportInstruction: Sendable, Equatable {
+    /// The protocol version mosh-server 1.x speaks.
+    static let protocolVersion: UInt32 = 2
+
+    /// `newNum` of the instruction that announces a shutdown.
+    static let shutdownStateNum = UInt64.max
+
+    var protocolVersion: UInt32 = Self.protocolVersion
+    var oldNum: UInt64 = 0
+    var newNum: UInt64 = 0
+    var ackNum: UInt64 = 0
+    var throwawayNum: UInt64 = 0
+    var diff: [UInt8] = []
+
+    func encoded() -> [UInt8] {
+        var writer = ProtobufWriter()
+        writer.writeVarint(field: 1, UInt64(protocolVersion))
+        writer.writeVarint(field: 2, oldNum)
+        writer.writeVarint(field: 3, newNum)
+        writer.writeVarint(field: 4, ackNum)
+        writer.writeVarint(field: 5, throwawayNum)
+        if !diff.isEmpty {
+            writer.writeBytes(field: 6, diff)
+        }
+        return writer.bytes
+    }
+
+    init(oldNum: UInt64 = 0, newNum: UInt64 = 0, ackNum: UInt64 = 0, throwawayNum: UInt64 = 0, diff: [UInt8] = []) {
+        self.oldNum = oldNum
+        self.newNum = newNum
+        self.ackNum = ackNum
+        self.throwawayNum = throwawayNum
+        self.diff = diff
+    }
+
+    init(decoding bytes: [UInt8]) throws {
+        var reader = ProtobufReader(bytes[...])
+        while let field = try reader.next() {
+            switch (field.number, field.value) {
+            case (1, .varint(let value)): protocolVersion = UInt32(truncatingIfNeeded: value)
+            case (2, .varint(let value)): oldNum = value
+            case (3, .varint(let value)): newNum = value
+            case (4, .varint(let value)): ackNum = value
+            case (5, .varint(let value)): throwawayNum = value
+            case (6, .bytes(let value)): diff = Array(value)
+            default: break // chaff and unknown fields
+            }
+        }
+    }
+}
+
+// MARK: - User and host messages
+
+/// One event in the client's state: keystrokes or a window size.
+nonisolated enum MoshUserEvent: Sendable, Equatable {
+    case keystroke([UInt8])
+    case resize(columns: Int, rows: Int)
+
+    /// A `UserMessage` diff carrying `events` in order.
+    static func encodedDiff(_ events: some Sequence<MoshUserEvent>) -> [UInt8] {
+        var message = ProtobufWriter()
+        for event in events {
+            var payload = ProtobufWriter()
+            var instruction = ProtobufWriter()
+            switch event {
+            case .keystroke(let keys):
+                payload.writeBytes(field: 4, keys)
+                instruction.writeBytes(field: 2, payload.bytes)
+            case .resize(let columns, let rows):
+                payload.writeVarint(field: 5, UInt64(columns))
+                payload.writeVarint(field: 6, UInt64(rows))
+                instruction.writeBytes(field: 3, payload.bytes)
+            }
+            message.writeBytes(field: 1, instruction.bytes)
+        }
+        return message.bytes
+    }
+}
+
+/// One instruction of a server diff.
+nonisolated enum MoshHostEvent: Sendable, Equatable {
+    /// Terminal output that takes the client's screen from the diff's old
+    /// state to its new one.
+    case hostBytes([UInt8])
+    case resize(columns: Int, rows: Int)
+    /// The newest client state whose keystrokes the server has echoed.
+    case echoAck(UInt64)
+
+    static func decodeDiff(_ bytes: [UInt8]) throws -> [MoshHostEvent] {
+        var events: [MoshHostEvent] = []
+        var message = ProtobufReader(bytes[...])
+        while let field = try message.next() {
+            guard field.number == 1, case .bytes(let instructionBytes) = field.value else { continue }
+            var instruction = ProtobufReader(instructionBytes)
+            while let extensionField = try instruction.next() {
+                guard case .bytes(let payloadBytes) = extensionField.value else { continue }
+                var payload = ProtobufReader(payloadBytes)
+                switch extensionField.number {
+                case 2:
+                    while let item = try payload.next() {
+                        if item.number == 4, case .bytes(let text) = item.value {
+                            events.append(.hostBytes(Array(text)))
+                        }
+                    }
+                case 3:
+                    var columns = 0
+                    var rows = 0
+                    while let item = try payload.next() {
+                        guard case .varint(let value) = item.value else { continue }
+                        if item.number == 5 { columns = Int(Int32(truncatingIfNeeded: value)) }
+                        if item.number == 6 { rows = Int(Int32(truncatingIfNeeded: value)) }
+                    }
+                    events.append(.resize(columns: columns, rows: rows))
+                case 7:
+                    while let item = try payload.next() {
+                        if item.number == 8, case .varint(let value) = item.value {
+                            events.append(.echoAck(value))
+                        }
+                    }
+                default:
+                    break
+                }
+            }
+        }
+        return events
+    }
+}
+
+// MARK: - Fragments
+
+nonisolated struct MoshFragment: Sendable, Equatable {
+    /// Compressed bytes per fragment, so a sealed datagram stays well under
+    /// a 1280-byte IPv6 minimum MTU.
+    static let maxContentsSize = 1_000
+
+    var instructionID: UInt64
+    var number: UInt16
+    var isFinal: Bool
+    var contents: [UInt8]
+
+    func encoded() -> [UInt8] {
+        var bytes = (0..<8).map { UInt8(truncatingIfNeeded: instructionID >> (56 - 8 * $0)) }
+        let combined = number | (isFinal ? 0x8000 : 0)
+        bytes.append(UInt8(combined >> 8))
+        bytes.append(UInt8(combined & 0xFF))
+        bytes.append(contentsOf: contents)
+        return bytes
+    }
+
+    init(instructionID: UInt64, number: UInt16, isFinal: Bool, contents: [UInt8]) {
+        self.instructionID = instructionID
+        self.number = number
+        self.isFinal = isFinal
+        self.contents = contents
+    }
+
+    init(decoding bytes: [UInt8]) throws {
+        guard bytes.count >= 10 else { throw MoshError.malformedPacket }
+        instructionID = bytes[0..<8].reduce(UInt64(0)) { $0 << 8 | UInt64($1) }
+        let combined = UInt16(bytes[8]) << 8 | UInt16(bytes[9])
+        isFinal = combined & 0x8000 != 0
+        number = combined & 0x7FFF
+        contents = Array(bytes[10...])
+    }
+
+    /// Compresses `instruction` and splits it into fragments.
+    static func fragments(of instruction: MoshTransportInstruction, id: UInt64) -> [MoshFragment] {
+        let compressed = MoshZlib.compress(instruction.encoded())
+        var fragments: [MoshFragment] = []
+        var start = 0
+        repeat {
+            let end = min(start + maxContentsSize, compressed.count)
+            fragments.append(MoshFragment(
+                instructionID: id,
+                number: UInt16(fragments.count),
+                isFinal: end == compressed.count,
+                contents: Array(compressed[start..<end])
+            ))
+            start = end
+        } while start < compressed.count
+        return fragments
+    }
+}
+
+/// Reassembles the fragments of one instruction at a time. A fragment of a
+/// newer instruction discards a partial older one; the sender repeats
+/// anything still unacknowledged, so nothing is lost for good.
+nonisolated struct MoshFragmentAssembly: Sendable {
+    private var instructionID: UInt64?
+    private var parts: [UInt16: [UInt8]] = [:]
+    private var finalNumber: UInt16?
+
+    /// Returns the decoded instruction once its last fragment is in.
+    mutating func add(_ fragment: MoshFragment) throws -> MoshTransportInstruction? {
+        if instructionID != fragment.instructionID {
+            instructionID = fragment.instructionID
+            parts.removeAll(keepingCapacity: true)
+            finalNumber = nil
+        }
+        parts[fragment.number] = fragment.contents
+        if fragment.isFinal {
+            finalNumber = fragment.number
+        }
+        guard let finalNumber, parts.count == Int(finalNumber) + 1 else { return nil }
+
+        var compressed: [UInt8] = []
+        for number in 0...finalNumber {
+            guard let part = parts[number] else { return nil }
+            compressed.append(contentsOf: part)
+        }
+        parts.removeAll(keepingCapacity: true)
+        self.finalNumber = nil
+        return try MoshTransportInstruction(decoding: MoshZlib.decompress(compressed))
+    }
+}
+
+// MARK: - MoshZlib
+
+/// zlib (RFC 1950) framing around Foundation's raw DEFLATE, which is what
+/// mosh's `compress()`/`uncompress()` produce and expect.
+nonisolated enum MoshZlib {
+    static func compress(_ bytes: [UInt8]) -> [UInt8] {
+        let deflated = (try? (Data(bytes) as NSData).compressed(using: .zlib) as Data) ?? Data()
+        var output: [UInt8] = [0x78, 0x9C]
+        output.append(contentsOf: deflated)
+        let checksum = adler32(bytes)
+        output.append(contentsOf: (0..<4).map { UInt8(truncatingIfNeeded: checksum >> (24 - 8 * $0)) })
+        return output
+    }
+
+    static func decompress(_ bytes: [UInt8]) throws -> [UInt8] {
+        guard bytes.count >= 6, bytes[0] & 0x0F == 8, (UInt16(bytes[0]) << 8 | UInt16(bytes[1])) % 31 == 0,
+              bytes[1] & 0x20 == 0 else {
+            throw MoshError.decompressionFailed
+        }
+        let deflated = Data(bytes[2..<(bytes.count - 4)])
+        guard let inflated = try? (deflated as NSData).decompressed(using: .zlib) as Data else {
+            throw MoshError.decompressionFailed
+        }
+        let output = [UInt8](inflated)
+        let stored = bytes.suffix(4).reduce(UInt32(0)) { $0 << 8 | UInt32($1) }
+        guard stored == adler32(output) else { throw MoshError.decompressionFailed }
+        return output
+    }
+
+    static func adler32(_ bytes: [UInt8]) -> UInt32 {
+        var a: UInt32 = 1
+        var b: UInt32 = 0
+        // 5552 is the longest run before `b` can overflow 32 bits.
+        var index = 0
+        while index < bytes.count {
+            let end = min(index + 5552, bytes.count)
+            for byte in bytes[index..<end] {
+                a += UInt32(byte)
+                b += a
+            }
+            a %= 65521
+            b %= 65521
+            index = end
+        }
+        return b << 16 | a
+    }
+}
+
+// MARK: - Protobuf
+
+nonisolated struct ProtobufWriter {
+    private(set) var bytes: [UInt8] = []
+
+    mutating func writeVarint(field: Int, _ value: UInt64) {
+        appendVarint(UInt64(field << 3))
+        appendVarint(value)
+    }
+
+    mutating func writeBytes(field: Int, _ value: [UInt8]) {
+        appendVarint(UInt64(field << 3 | 2))
+        appendVarint(UInt64(value.count))
+        bytes.append(contentsOf: value)
+    }
+
+    private mutating func appendVarint(_ value: UInt64) {
+        var remaining = value
+        while remaining >= 0x80 {
+            bytes.append(UInt8(truncatingIfNeeded: remaining) | 0x80)
+            remaining >>= 7
+        }
+        bytes.append(UInt8(remaining))
+    }
+}
+
+nonisolated struct ProtobufReader {
+    enum Value {
+        case varint(UInt64)
+        case bytes(ArraySlice<UInt8>)
+        case fixed
+    }
+
+    private let bytes: ArraySlice<UInt8>
+    private var position: Int
+
+    init(_ bytes: ArraySlice<UInt8>) {
+        self.bytes = bytes
+        self.position = bytes.startIndex
+    }
+
+    /// The next field, or nil at the end of the message.
+    mutating func next() throws -> (number: Int, value: Value)? {
+        guard position < bytes.endIndex else { return nil }
+        let key = try readVarint()
+        let number = Int(key >> 3)
+        switch key & 7 {
+        case 0:
+            return (number, .varint(try readVarint()))
+        case 1:
+            try skip(8)
+            return (number, .fixed)
+        case 2:
+            let length = try readVarint()
+            guard length <= UInt64(bytes.endIndex - position) else { throw MoshError.malformedPacket }
+            let start = position
+            position += Int(length)
+            return (number, .bytes(bytes[start..<position]))
+        case 5:
+            try skip(4)
+            return (number, .fixed)
+        default:
+            throw MoshError.malformedPacket
+        }
+    }
+
+    private mutating func readVarint() throws -> UInt64 {
+        var value: UInt64 = 0
+        var shift: UInt64 = 0
+        while position < bytes.endIndex, shift < 64 {
+            let byte = bytes[position]
+            position += 1
+            value |= UInt64(byte & 0x7F) << shift
+            if byte & 0x80 == 0 { return value }
+            shift += 7
+        }
+        throw MoshError.malformedPacket
+    }
+
+    private mutating func skip(_ count: Int) throws {
+        guard bytes.endIndex - position >= count else { throw MoshError.malformedPacket }
+        position += count
+    }
+}
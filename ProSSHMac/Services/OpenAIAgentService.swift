@@ -77,10 +77,47 @@ protocol AIAgentSessionProviding: AnyObject {
 
     func recentCommandBlocks(sessionID: UUID, limit: Int) async -> [CommandBlock]
     func searchCommandHistory(sessionID: UUID, query: String, limit: Int) async -> [CommandBlock]
+    /// Past blocks from any session related in meaning to `query`, best
+    /// first; empty when none is close enough.
+    func relevantCommandBlocks(query: String, limit: Int) async -> [CommandBlock]
+    /// The command block carrying an AI tool completion marker.
+    func commandBlock(sessionID: UUID, marker: String) async -> CommandBlock?
     func commandOutput(sessionID: UUID, blockID: UUID) async -> String?
     func sendShellInput(sessionID: UUID, input: String, suppressEcho: Bool) async
     func sendRawShellInput(sessionID: UUID, input: String) async
     func executeCommandAndWait(sessionID: UUID, command: String, timeoutSeconds: TimeInterval) async -> CommandExecutionResult
+    /// Runs a tool command outside the user's shell; nil when the session
+    /// cannot, and the caller should fall back to the shell.
+    func executeCommandOutOfBand(sessionID: UUID, command: String, timeoutSeconds: TimeInterval) async -> CommandExecutionResult?
+    /// Writes a tool's file over SFTP, outside the user's shell; nil when the
+    /// session cannot, and the caller should write through the shell.
+    func writeFileOutOfBand(sessionID: UUID, path: String, content: String, timeoutSeconds: TimeInterval) async -> CommandExecutionResult?
+    /// The host's latest load, memory and disk sample; nil for local
+    /// sessions and until the sampler's first line arrives.
+    func hostMetrics(sessionID: UUID) -> RemoteHostMetrics?
+}
+
+extension AIAgentSessionProviding {
+    func relevantCommandBlocks(query: String, limit: Int) async -> [CommandBlock] {
+        []
+    }
+
+    func commandBlock(sessionID: UUID, marker: String) async -> CommandBlock? {
+        await searchCommandHistory(sessionID: sessionID, query: marker, limit: 8)
+            .first { $0.command.contains(marker) || $0.output.contains(marker) }
+    }
+
+    func executeCommandOutOfBand(sessionID: UUID, command: String, timeoutSeconds: TimeInterval) async -> CommandExecutionResult? {
+        nil
+    }
+
+    func writeFileOutOfBand(sessionID: UUID, path: String, content: String, timeoutSeconds: TimeInterval) async -> CommandExecutionResult? {
+        nil
+    }
+
+    func hostMetrics(sessionID: UUID) -> RemoteHostMetrics? {
+        nil
+    }
 }
 
 struct CommandExecutionResult: Sendable {
@@ -153,6 +190,12 @@ final class OpenAIAgentService: AIAgentServicing {
         conversationContext.clear(sessionID: sessionID)
     }
 
+    /// Prompt, completion and prompt-cache tokens for the session's current
+    /// conversation, or nil before the provider has reported any.
+    func conversationUsage(sessionID: UUID) -> LLMTokenUsage? {
+        conversationContext.usage(for: sessionID)
+    }
+
     func generateReply(
         sessionID: UUID,
         prompt: String,
@@ -206,12 +249,35 @@ final class OpenAIAgentService: AIAgentServicing {
 
     // MARK: - Provider Translation
 
+    /// Wrap `handler` so the first streamed event reports time to first
+    /// token for `providerID` to the registry.
+    private func timingFirstToken(
+        _ handler: @escaping @Sendable (LLMStreamEvent) -> Void,
+        providerID: LLMProviderID
+    ) -> @Sendable (LLMStreamEvent) -> Void {
+        let timer = LLMFirstTokenTimer()
+        let registry = providerRegistry
+        return { event in
+            if let elapsed = timer.markFirstToken() {
+                Task { @MainActor in
+                    registry.recordTimeToFirstToken(elapsed, for: providerID)
+                }
+            }
+            handler(event)
+        }
+    }
+
     func sendProviderRequest(
         _ request: LLMRequest,
         streamHandler: (@Sendable (LLMStreamEvent) -> Void)?
     ) async throws -> LLMResponse {
+        let providerID = providerRegistry.activeProviderID
+        providerRegistry.session(for: providerID)?.noteRequestStarted()
+        defer { providerRegistry.refreshSessionDiagnostics() }
+        let streamHandler = streamHandler.map { timingFirstToken($0, providerID: providerID) }
+
         // Non-OpenAI providers go through LLMProvider protocol
-        if providerRegistry.activeProviderID != .openai {
+        if providerID != .openai {
             guard let provider = providerRegistry.activeProvider else {
                 throw LLMProviderError.providerNotConfigured(providerRegistry.activeProviderID)
             }
@@ -280,6 +346,8 @@ final class OpenAIAgentService: AIAgentServicing {
                         streamHandler(.reasoningSummaryDelta(delta))
                     case let .reasoningSummaryTextDone(text):
                         streamHandler(.reasoningSummaryDone(text))
+                    case let .functionCallReady(call):
+                        streamHandler(.toolCallReady(LLMToolCall(id: call.id, name: call.name, arguments: call.arguments)))
                     }
                 }
             } else {
@@ -294,7 +362,14 @@ final class OpenAIAgentService: AIAgentServicing {
             return LLMResponse(
                 text: response.text,
                 toolCalls: llmToolCalls,
-                updatedConversationState: .string(response.id, provider: .openai)
+                updatedConversationState: .string(response.id, provider: .openai),
+                usage: response.usage.map { usage in
+                    LLMTokenUsage(
+                        inputTokens: usage.inputTokens ?? 0,
+                        outputTokens: usage.outputTokens ?? 0,
+                        cachedInputTokens: usage.inputTokensDetails?.cachedTokens ?? 0
+                    )
+                }
             )
         } catch let error as OpenAIResponsesServiceError {
             // Re-throw as LLMProviderError
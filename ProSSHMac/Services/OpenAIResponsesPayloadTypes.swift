@@ -12,6 +12,10 @@ struct CreateRequestPayload: Encodable {
     var previousResponseID: String?
     var stream: Bool?
     var reasoning: Reasoning?
+    /// "auto" lets the server drop the oldest items of a long
+    /// `previous_response_id` chain instead of failing once the chain
+    /// outgrows the model's context window.
+    var truncation: String?
 
     enum CodingKeys: String, CodingKey {
         case model
@@ -20,6 +24,7 @@ struct CreateRequestPayload: Encodable {
         case previousResponseID = "previous_response_id"
         case stream
         case reasoning
+        case truncation
     }
 }
 
@@ -92,7 +92,7 @@ extension OpenAIResponsesService {
         let payload = createPayload(request: request, stream: true)
         let encodedPayload: Data
         do {
-            encodedPayload = try JSONEncoder().encode(payload)
+            encodedPayload = try JSONEncoder.llmRequestBody().encode(payload)
         } catch {
             throw OpenAIResponsesServiceError.encodingFailure(error.localizedDescription)
         }
@@ -178,33 +178,22 @@ extension OpenAIResponsesService {
             }
         }
 
-        var eventName: String?
-        var dataLines: [String] = []
         var completedResponse: OpenAIResponsesResponse?
         var accumulator = StreamingResponseAccumulator()
-        var nonSSELines: [String] = []
+        var parser = SSEEventParser()
 
-        func flushEvent() throws {
-            guard !dataLines.isEmpty else {
-                eventName = nil
-                return
-            }
-            let payloadText = dataLines.joined(separator: "\n")
-            let currentEventName = eventName
-            dataLines.removeAll(keepingCapacity: true)
-            eventName = nil
-            if payloadText.trimmingCharacters(in: .whitespacesAndNewlines) == "[DONE]" {
-                return
-            }
+        func handle(_ event: SSEEventParser.Event) throws {
+            guard !event.isDone else { return }
             if Self.shouldLogResponsePayloads() {
-                let eventForLog = currentEventName ?? "n/a"
+                let eventForLog = event.name ?? "n/a"
+                let payloadText = String(decoding: event.data, as: UTF8.self)
                 Self.logger.debug(
                     "[\(traceID, privacy: .public)] stream_event event=\(eventForLog, privacy: .public) payload_preview=\(Self.logPreview(from: payloadText), privacy: .public)"
                 )
             }
             if let parsedResponse = try Self.consumeStreamPayload(
-                payloadText,
-                eventName: currentEventName,
+                event.data,
+                eventName: event.name,
                 onEvent: onEvent,
                 accumulator: &accumulator
             ) {
@@ -213,44 +202,14 @@ extension OpenAIResponsesService {
         }
 
         do {
-            var lineBuffer = Data()
-            func consumeLine(_ rawLine: String) throws {
-                var line = rawLine
-                if line.hasSuffix("\r") {
-                    line.removeLast()
-                }
-                if line.isEmpty {
-                    try flushEvent()
-                    return
-                }
-                if line.hasPrefix(":") {
-                    return
-                }
-                if let value = Self.sseFieldValue(prefix: "event:", line: line) {
-                    eventName = value
-                    return
-                }
-                if let value = Self.sseFieldValue(prefix: "data:", line: line) {
-                    dataLines.append(value)
-                    return
-                }
-                nonSSELines.append(line)
-            }
-
             for try await byte in bytes {
-                if byte == 0x0A { // LF
-                    let line = String(decoding: lineBuffer, as: UTF8.self)
-                    try consumeLine(line)
-                    lineBuffer.removeAll(keepingCapacity: true)
-                } else {
-                    lineBuffer.append(byte)
+                if let event = parser.feed(byte) {
+                    try handle(event)
                 }
             }
-            if !lineBuffer.isEmpty {
-                let line = String(decoding: lineBuffer, as: UTF8.self)
-                try consumeLine(line)
+            if let event = parser.finish() {
+                try handle(event)
             }
-            try flushEvent()
         } catch let serviceError as OpenAIResponsesServiceError {
             throw serviceError
         } catch {
@@ -263,8 +222,8 @@ extension OpenAIResponsesService {
         if let assembled = accumulator.assembledResponse {
             return assembled
         }
-        if !nonSSELines.isEmpty {
-            let body = nonSSELines.joined(separator: "\n")
+        if !parser.nonSSELines.isEmpty {
+            let body = parser.nonSSELines.joined(separator: "\n")
             if Self.shouldLogResponsePayloads() {
                 Self.logger.warning(
                     "[\(traceID, privacy: .public)] stream_non_sse_body_preview=\(Self.logPreview(from: body), privacy: .public)"
@@ -288,13 +247,27 @@ extension OpenAIResponsesService {
     }
 
     private static func consumeStreamPayload(
-        _ payloadText: String,
+        _ payload: [UInt8],
         eventName: String?,
         onEvent: @escaping @Sendable (OpenAIResponsesStreamEvent) -> Void,
         accumulator: inout StreamingResponseAccumulator
     ) throws -> OpenAIResponsesResponse? {
-        guard let data = payloadText.data(using: .utf8),
-              let object = try? JSONSerialization.jsonObject(with: data),
+        // Deltas dominate the stream and only carry top-level scalars, so they
+        // are read in one scanner pass without a Foundation object graph.
+        if let fields = StreamingEventFields.scan(payload) {
+            let type = fields.type ?? eventName ?? ""
+            if StreamingEventFields.flatEventTypes.contains(type) {
+                accumulator.ingest(type: type, fields: fields)
+                emitFlatEvent(type: type, fields: fields, onEvent: onEvent)
+                if type == "response.function_call_arguments.done",
+                   let call = accumulator.takeReadyFunctionCall(itemID: fields.itemID) {
+                    onEvent(.functionCallReady(call))
+                }
+                return nil
+            }
+        }
+
+        guard let object = try? JSONSerialization.jsonObject(with: Data(payload)),
               let dictionary = object as? [String: Any] else {
             return nil
         }
@@ -304,71 +277,80 @@ extension OpenAIResponsesService {
         accumulator.ingest(type: type, payload: dictionary)
 
         switch type {
-        case "response.text.delta":
-            if let delta = stringField(in: dictionary, key: "delta"), !delta.isEmpty {
-                onEvent(.outputTextDelta(delta))
+        case "response.reasoning_summary_part.added":
+            if let text = reasoningSummaryText(from: dictionary), !text.isEmpty {
+                onEvent(.reasoningSummaryTextDelta(text))
             }
-        case "response.text.done":
-            if let text = stringField(in: dictionary, key: "text"), !text.isEmpty {
-                onEvent(.outputTextDone(text))
+        case "response.reasoning_summary_part.done":
+            if let text = reasoningSummaryText(from: dictionary), !text.isEmpty {
+                onEvent(.reasoningSummaryTextDone(text))
+            }
+        case "error":
+            let message = streamErrorMessage(from: dictionary)
+            throw OpenAIResponsesServiceError.httpError(statusCode: 500, message: message)
+        case "response.failed":
+            let message = streamErrorMessage(from: dictionary)
+            throw OpenAIResponsesServiceError.httpError(statusCode: 500, message: message)
+        case "response.completed":
+            if let response = completedResponse(from: dictionary) {
+                return response
+            }
+        case "response.output_item.done",
+             "response.function_call_arguments.done":
+            // A call's arguments are final at whichever of these comes first;
+            // its name and call ID arrived with `output_item.added`.
+            let itemID = (dictionary["item"] as? [String: Any])?["id"] as? String
+                ?? dictionary["item_id"] as? String
+            if let call = accumulator.takeReadyFunctionCall(itemID: itemID) {
+                onEvent(.functionCallReady(call))
             }
-        case "response.output_text.delta":
-            if let delta = stringField(in: dictionary, key: "delta"), !delta.isEmpty {
+        default:
+            emitFlatEvent(type: type, fields: StreamingEventFields(dictionary: dictionary), onEvent: onEvent)
+        }
+
+        return nil
+    }
+
+    private static func emitFlatEvent(
+        type: String,
+        fields: StreamingEventFields,
+        onEvent: @escaping @Sendable (OpenAIResponsesStreamEvent) -> Void
+    ) {
+        switch type {
+        case "response.text.delta",
+             "response.output_text.delta",
+             "response.refusal.delta":
+            if let delta = fields.delta, !delta.isEmpty {
                 onEvent(.outputTextDelta(delta))
             }
-        case "response.output_text.done":
-            if let text = stringField(in: dictionary, key: "text"), !text.isEmpty {
+        case "response.text.done",
+             "response.output_text.done":
+            if let text = fields.text, !text.isEmpty {
                 onEvent(.outputTextDone(text))
             }
         case "response.reasoning_text.delta":
-            if let delta = stringField(in: dictionary, key: "delta"), !delta.isEmpty {
+            if let delta = fields.delta, !delta.isEmpty {
                 onEvent(.reasoningTextDelta(delta))
             }
         case "response.reasoning_text.done":
-            if let text = stringField(in: dictionary, key: "text"), !text.isEmpty {
+            if let text = fields.text, !text.isEmpty {
                 onEvent(.reasoningTextDone(text))
             }
         case "response.reasoning_summary_text.delta":
-            if let delta = stringField(in: dictionary, key: "delta"), !delta.isEmpty {
+            if let delta = fields.delta, !delta.isEmpty {
                 onEvent(.reasoningSummaryTextDelta(delta))
             }
         case "response.reasoning_summary_text.done":
-            if let text = stringField(in: dictionary, key: "text"), !text.isEmpty {
-                onEvent(.reasoningSummaryTextDone(text))
-            }
-        case "response.reasoning_summary_part.added":
-            if let text = reasoningSummaryText(from: dictionary), !text.isEmpty {
-                onEvent(.reasoningSummaryTextDelta(text))
-            }
-        case "response.reasoning_summary_part.done":
-            if let text = reasoningSummaryText(from: dictionary), !text.isEmpty {
+            if let text = fields.text, !text.isEmpty {
                 onEvent(.reasoningSummaryTextDone(text))
             }
-        case "response.refusal.delta":
-            if let delta = stringField(in: dictionary, key: "delta"), !delta.isEmpty {
-                onEvent(.outputTextDelta(delta))
-            }
         case "response.refusal.done":
-            if let text = stringField(in: dictionary, key: "refusal")
-                ?? stringField(in: dictionary, key: "text"),
-               !text.isEmpty {
+            if let text = fields.refusal ?? fields.text, !text.isEmpty {
                 onEvent(.outputTextDone(text))
             }
-        case "error":
-            let message = streamErrorMessage(from: dictionary)
-            throw OpenAIResponsesServiceError.httpError(statusCode: 500, message: message)
-        case "response.failed":
-            let message = streamErrorMessage(from: dictionary)
-            throw OpenAIResponsesServiceError.httpError(statusCode: 500, message: message)
-        case "response.completed":
-            if let response = completedResponse(from: dictionary) {
-                return response
-            }
         default:
             break
         }
-
-        return nil
     }
 
     private static func completedResponse(from payload: [String: Any]) -> OpenAIResponsesResponse? {
@@ -398,10 +380,6 @@ extension OpenAIResponsesService {
         return "OpenAI streaming request failed."
     }
 
-    private static func stringField(in payload: [String: Any], key: String) -> String? {
-        payload[key] as? String
-    }
-
     private static func reasoningSummaryText(from payload: [String: Any]) -> String? {
         guard let part = payload["part"] as? [String: Any] else {
             return nil
@@ -82,7 +82,7 @@ final class OpenAIResponsesService: OpenAIResponsesServicing {
 
         let encodedPayload: Data
         do {
-            encodedPayload = try JSONEncoder().encode(payload)
+            encodedPayload = try JSONEncoder.llmRequestBody().encode(payload)
         } catch {
             throw OpenAIResponsesServiceError.encodingFailure(error.localizedDescription)
         }
@@ -141,7 +141,8 @@ final class OpenAIResponsesService: OpenAIResponsesServicing {
             tools: request.tools.isEmpty ? nil : request.tools,
             previousResponseID: request.previousResponseID,
             stream: stream ? true : nil,
-            reasoning: .init(summary: "auto")
+            reasoning: .init(summary: "auto"),
+            truncation: "auto"
         )
     }
 
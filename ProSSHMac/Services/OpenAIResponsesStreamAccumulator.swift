@@ -1,6 +1,77 @@
 // Extracted from OpenAIResponsesService.swift
 import Foundation
 
+/// Top-level scalar fields of one Responses stream event. Delta and done
+/// events carry nothing else, so this is all the accumulator and the event
+/// callback need from them.
+struct StreamingEventFields: Equatable {
+    var type: String?
+    var responseID: String?
+    var id: String?
+    var itemID: String?
+    var outputIndex: Int?
+    var delta: String?
+    var text: String?
+    var refusal: String?
+    var arguments: String?
+
+    /// Event types fully described by `StreamingEventFields`. Anything else
+    /// (output items, content parts, completed responses, errors) still needs
+    /// the nested payload.
+    static let flatEventTypes: Set<String> = [
+        "response.text.delta", "response.text.done",
+        "response.output_text.delta", "response.output_text.done",
+        "response.reasoning_text.delta", "response.reasoning_text.done",
+        "response.reasoning_summary_text.delta", "response.reasoning_summary_text.done",
+        "response.refusal.delta", "response.refusal.done",
+        "response.function_call_arguments.delta", "response.function_call_arguments.done",
+    ]
+
+    init() {}
+
+    init(dictionary: [String: Any]) {
+        type = dictionary["type"] as? String
+        responseID = dictionary["response_id"] as? String
+        id = dictionary["id"] as? String
+        itemID = dictionary["item_id"] as? String
+        outputIndex = dictionary["output_index"] as? Int
+        delta = dictionary["delta"] as? String
+        text = dictionary["text"] as? String
+        refusal = dictionary["refusal"] as? String
+        arguments = dictionary["arguments"] as? String
+    }
+
+    /// Reads the fields straight from a UTF-8 payload. Nested values are
+    /// walked but ignored. Returns nil for malformed JSON.
+    static func scan(_ bytes: [UInt8]) -> StreamingEventFields? {
+        var fields = StreamingEventFields()
+        let isValid = StreamingJSONScanner.scan(bytes) { path, scalar in
+            guard path.count == 1, case .key(let key) = path[0] else { return }
+            switch scalar {
+            case .string(let value):
+                switch key {
+                case "type": fields.type = value
+                case "response_id": fields.responseID = value
+                case "id": fields.id = value
+                case "item_id": fields.itemID = value
+                case "delta": fields.delta = value
+                case "text": fields.text = value
+                case "refusal": fields.refusal = value
+                case "arguments": fields.arguments = value
+                default: break
+                }
+            case .number(let value):
+                if key == "output_index" {
+                    fields.outputIndex = Int(exactly: value)
+                }
+            case .bool, .null:
+                break
+            }
+        }
+        return isValid ? fields : nil
+    }
+}
+
 struct StreamingResponseAccumulator {
     var responseID: String?
     var status: String?
@@ -10,6 +81,10 @@ struct StreamingResponseAccumulator {
     private var fallbackText = ""
     private var fallbackTextFinal: String?
     private var functionCallArgumentsByItemID: [String: String] = [:]
+    /// Function calls whose arguments are final, and those already handed
+    /// out by `takeReadyFunctionCall`.
+    private var completedFunctionCallItemIDs: Set<String> = []
+    private var readyFunctionCallItemIDs: Set<String> = []
 
     var assembledResponse: OpenAIResponsesResponse? {
         guard let responseID else { return nil }
@@ -22,16 +97,8 @@ struct StreamingResponseAccumulator {
     }
 
     mutating func ingest(type: String, payload: [String: Any]) {
-        if responseID == nil {
-            responseID = payload["response_id"] as? String
-        }
-        if responseID == nil {
-            responseID = payload["id"] as? String
-        }
-        if let outputIndex = payload["output_index"] as? Int,
-           let itemID = payload["item_id"] as? String {
-            outputOrderByItemID[itemID] = outputIndex
-        }
+        let fields = StreamingEventFields(dictionary: payload)
+        ingestIdentity(fields)
 
         if let responseObject = payload["response"] as? [String: Any] {
             ingestResponseObject(responseObject)
@@ -49,31 +116,83 @@ struct StreamingResponseAccumulator {
         case "response.output_item.added",
              "response.output_item.done":
             if let itemObject = payload["item"] {
-                ingestOutputItem(itemObject, outputIndex: payload["output_index"] as? Int)
+                ingestOutputItem(itemObject, outputIndex: fields.outputIndex)
+                if type == "response.output_item.done",
+                   let item = itemObject as? [String: Any],
+                   item["type"] as? String == "function_call",
+                   let itemID = item["id"] as? String {
+                    completedFunctionCallItemIDs.insert(itemID)
+                }
             }
+        case "response.content_part.added":
+            ingestContentPart(payload, isDone: false)
+        case "response.content_part.done":
+            ingestContentPart(payload, isDone: true)
+        default:
+            ingestFlatEvent(type: type, fields: fields)
+        }
+    }
+
+    /// Fast-path entry for events whose payload is only top-level scalars
+    /// (see `StreamingEventFields.flatEventTypes`), so callers can skip
+    /// building a dictionary for every delta.
+    mutating func ingest(type: String, fields: StreamingEventFields) {
+        ingestIdentity(fields)
+        ingestFlatEvent(type: type, fields: fields)
+    }
+
+    private mutating func ingestIdentity(_ fields: StreamingEventFields) {
+        if responseID == nil {
+            responseID = fields.responseID
+        }
+        if responseID == nil {
+            responseID = fields.id
+        }
+        if let outputIndex = fields.outputIndex,
+           let itemID = fields.itemID {
+            outputOrderByItemID[itemID] = outputIndex
+        }
+    }
+
+    private mutating func ingestFlatEvent(type: String, fields: StreamingEventFields) {
+        switch type {
         case "response.function_call_arguments.delta":
-            ingestFunctionCallArgumentsDelta(payload)
+            ingestFunctionCallArgumentsDelta(fields)
         case "response.function_call_arguments.done":
-            ingestFunctionCallArgumentsDone(payload)
+            ingestFunctionCallArgumentsDone(fields)
         case "response.text.delta",
-             "response.output_text.delta":
-            ingestTextDelta(payload)
+             "response.output_text.delta",
+             "response.refusal.delta":
+            ingestTextDelta(fields)
         case "response.text.done",
              "response.output_text.done":
-            ingestTextDone(payload)
-        case "response.refusal.delta":
-            ingestRefusalDelta(payload)
+            ingestTextDone(fields.text, itemID: fields.itemID)
         case "response.refusal.done":
-            ingestRefusalDone(payload)
-        case "response.content_part.added":
-            ingestContentPart(payload, isDone: false)
-        case "response.content_part.done":
-            ingestContentPart(payload, isDone: true)
+            ingestTextDone(fields.refusal ?? fields.text, itemID: fields.itemID)
         default:
             break
         }
     }
 
+    /// The function call `itemID` names once its arguments are final and its
+    /// name and call ID are known; each call is handed out once.
+    mutating func takeReadyFunctionCall(itemID: String?) -> OpenAIResponsesResponse.ToolCall? {
+        guard let itemID,
+              completedFunctionCallItemIDs.contains(itemID),
+              !readyFunctionCallItemIDs.contains(itemID),
+              let item = outputItemsByID[itemID],
+              let callID = item.callID,
+              let name = item.name else {
+            return nil
+        }
+        readyFunctionCallItemIDs.insert(itemID)
+        return OpenAIResponsesResponse.ToolCall(
+            id: callID,
+            name: name,
+            arguments: functionCallArgumentsByItemID[itemID] ?? item.arguments ?? ""
+        )
+    }
+
     private mutating func ingestResponseObject(_ responseObject: [String: Any]) {
         if let id = responseObject["id"] as? String, !id.isEmpty {
             responseID = id
@@ -100,54 +219,35 @@ struct StreamingResponseAccumulator {
         }
     }
 
-    private mutating func ingestFunctionCallArgumentsDelta(_ payload: [String: Any]) {
-        guard let itemID = payload["item_id"] as? String else { return }
-        let delta = payload["delta"] as? String ?? ""
+    private mutating func ingestFunctionCallArgumentsDelta(_ fields: StreamingEventFields) {
+        guard let itemID = fields.itemID else { return }
+        let delta = fields.delta ?? ""
         guard !delta.isEmpty else { return }
         functionCallArgumentsByItemID[itemID, default: ""] += delta
     }
 
-    private mutating func ingestFunctionCallArgumentsDone(_ payload: [String: Any]) {
-        guard let itemID = payload["item_id"] as? String else { return }
-        let doneArgs = payload["arguments"] as? String
-        if let doneArgs {
+    private mutating func ingestFunctionCallArgumentsDone(_ fields: StreamingEventFields) {
+        guard let itemID = fields.itemID else { return }
+        completedFunctionCallItemIDs.insert(itemID)
+        if let doneArgs = fields.arguments {
             functionCallArgumentsByItemID[itemID] = doneArgs
         } else if functionCallArgumentsByItemID[itemID] == nil {
             functionCallArgumentsByItemID[itemID] = ""
         }
     }
 
-    private mutating func ingestTextDelta(_ payload: [String: Any]) {
-        guard let delta = payload["delta"] as? String, !delta.isEmpty else { return }
-        if let itemID = payload["item_id"] as? String {
+    private mutating func ingestTextDelta(_ fields: StreamingEventFields) {
+        guard let delta = fields.delta, !delta.isEmpty else { return }
+        if let itemID = fields.itemID {
             appendText(delta, toMessageItemID: itemID)
         } else {
             fallbackText += delta
         }
     }
 
-    private mutating func ingestTextDone(_ payload: [String: Any]) {
-        guard let text = payload["text"] as? String, !text.isEmpty else { return }
-        if let itemID = payload["item_id"] as? String {
-            setText(text, toMessageItemID: itemID)
-        } else {
-            fallbackTextFinal = text
-        }
-    }
-
-    private mutating func ingestRefusalDelta(_ payload: [String: Any]) {
-        guard let delta = payload["delta"] as? String, !delta.isEmpty else { return }
-        if let itemID = payload["item_id"] as? String {
-            appendText(delta, toMessageItemID: itemID)
-        } else {
-            fallbackText += delta
-        }
-    }
-
-    private mutating func ingestRefusalDone(_ payload: [String: Any]) {
-        let text = (payload["refusal"] as? String) ?? (payload["text"] as? String) ?? ""
-        guard !text.isEmpty else { return }
-        if let itemID = payload["item_id"] as? String {
+    private mutating func ingestTextDone(_ text: String?, itemID: String?) {
+        guard let text, !text.isEmpty else { return }
+        if let itemID {
             setText(text, toMessageItemID: itemID)
         } else {
             fallbackTextFinal = text
@@ -153,16 +153,38 @@ struct OpenAIResponsesResponse: Decodable, Sendable, Equatable {
         var arguments: String
     }
 
+    struct Usage: Decodable, Sendable, Equatable {
+        struct InputTokensDetails: Decodable, Sendable, Equatable {
+            var cachedTokens: Int?
+
+            enum CodingKeys: String, CodingKey {
+                case cachedTokens = "cached_tokens"
+            }
+        }
+
+        var inputTokens: Int?
+        var outputTokens: Int?
+        var inputTokensDetails: InputTokensDetails?
+
+        enum CodingKeys: String, CodingKey {
+            case inputTokens = "input_tokens"
+            case outputTokens = "output_tokens"
+            case inputTokensDetails = "input_tokens_details"
+        }
+    }
+
     var id: String
     var status: String?
     var outputText: String?
     var output: [OutputItem]
+    var usage: Usage?
 
     enum CodingKeys: String, CodingKey {
         case id
         case status
         case outputText = "output_text"
         case output
+        case usage
     }
 
     var text: String {
@@ -200,4 +222,6 @@ enum OpenAIResponsesStreamEvent: Sendable, Equatable {
     case reasoningTextDone(String)
     case reasoningSummaryTextDelta(String)
     case reasoningSummaryTextDone(String)
+    /// A function call whose arguments are complete, ahead of `response.completed`.
+    case functionCallReady(OpenAIResponsesResponse.ToolCall)
 }
@@ -0,0 +1,344 @@
+// OpenSSHKRL.swift
+// ProSSHV2
+//
+// OpenSSH binary key revocation lists (PROTOCOL.krl). The writer encodes
+// revoked certificate serials per CA in whichever of the three serial
+// subsections is smallest for each cluster: explicit lists, ranges, or
+// bitmaps. The reader decodes the certificate sections of an existing KRL
+// so new revocations can be appended to it instead of regenerating it.
+// Other section types are carried through unchanged; signature sections
+// are dropped because appending invalidates them.
+
+import Foundation
+
+struct OpenSSHKRL {
+
+    static let magic: UInt64 = 0x5353_484B_524C_0A00
+    static let formatVersion: UInt32 = 1
+
+    enum SectionType: UInt8 {
+        case certificates = 1
+        case explicitKey = 2
+        case fingerprintSHA1 = 3
+        case signature = 4
+        case fingerprintSHA256 = 5
+    }
+
+    enum CertificateSectionType: UInt8 {
+        case serialList = 0x20
+        case serialRange = 0x21
+        case serialBitmap = 0x22
+        case keyID = 0x23
+    }
+
+    struct Section: Equatable {
+        var type: UInt8
+        var data: Data
+    }
+
+    /// Certificates revoked under one CA key. An empty `caKey` is the
+    /// wildcard CA and applies to certificates from any CA.
+    struct RevokedCertificates: Equatable {
+        var caKey: Data
+        /// Merged, sorted serial ranges.
+        var serialRanges: [ClosedRange<UInt64>] = []
+        var keyIDs: Set<String> = []
+
+        func containsSerial(_ serial: UInt64) -> Bool {
+            var low = 0
+            var high = serialRanges.count
+            while low < high {
+                let mid = (low + high) / 2
+                if serialRanges[mid].upperBound < serial {
+                    low = mid + 1
+                } else {
+                    high = mid
+                }
+            }
+            return low < serialRanges.count && serialRanges[low].contains(serial)
+        }
+    }
+
+    var version: UInt64
+    /// Seconds since the epoch.
+    var generatedDate: UInt64
+    var flags: UInt64 = 0
+    var comment: String
+    var sections: [Section]
+
+    init(version: UInt64, generatedDate: UInt64, comment: String, sections: [Section] = []) {
+        self.version = version
+        self.generatedDate = generatedDate
+        self.comment = comment
+        self.sections = sections
+    }
+
+    // MARK: - Reading
+
+    init(parsing data: Data) throws {
+        var reader = SSHBinaryReader(data: data)
+        guard try reader.readUInt64(context: "KRL header") == Self.magic else {
+            throw CertificateAuthorityError.signingFailed(message: "File is not an OpenSSH KRL.")
+        }
+        let format = try reader.readUInt32(context: "KRL header")
+        guard format == Self.formatVersion else {
+            throw CertificateAuthorityError.signingFailed(message: "Unsupported KRL format version \(format).")
+        }
+        version = try reader.readUInt64(context: "KRL version")
+        generatedDate = try reader.readUInt64(context: "KRL generated date")
+        flags = try reader.readUInt64(context: "KRL flags")
+        _ = try reader.readStringData(context: "KRL reserved")
+        comment = (try? reader.readStringText(context: "KRL comment")) ?? ""
+
+        sections = []
+        while !reader.isAtEnd {
+            let type = try reader.readUInt8(context: "KRL section type")
+            let payload = try reader.readStringData(context: "KRL section")
+            sections.append(Section(type: type, data: payload))
+        }
+    }
+
+    /// Revocations from every certificate section, merged per CA key.
+    func revokedCertificates() throws -> [Data: RevokedCertificates] {
+        var result: [Data: RevokedCertificates] = [:]
+        for section in sections where section.type == SectionType.certificates.rawValue {
+            let decoded = try Self.decodeCertificateSection(section.data)
+            var merged = result[decoded.caKey] ?? RevokedCertificates(caKey: decoded.caKey)
+            merged.serialRanges = Self.mergeRanges(merged.serialRanges + decoded.serialRanges)
+            merged.keyIDs.formUnion(decoded.keyIDs)
+            result[decoded.caKey] = merged
+        }
+        return result
+    }
+
+    private static func decodeCertificateSection(_ data: Data) throws -> RevokedCertificates {
+        var reader = SSHBinaryReader(data: data)
+        var revoked = RevokedCertificates(caKey: try reader.readStringData(context: "KRL CA key"))
+        _ = try reader.readStringData(context: "KRL certificate reserved")
+
+        var ranges: [ClosedRange<UInt64>] = []
+        while !reader.isAtEnd {
+            let type = try reader.readUInt8(context: "KRL certificate section type")
+            var payload = SSHBinaryReader(data: try reader.readStringData(context: "KRL certificate section"))
+            switch CertificateSectionType(rawValue: type) {
+            case .serialList:
+                while !payload.isAtEnd {
+                    let serial = try payload.readUInt64(context: "KRL serial list")
+                    ranges.append(serial...serial)
+                }
+            case .serialRange:
+                let low = try payload.readUInt64(context: "KRL serial range")
+                let high = try payload.readUInt64(context: "KRL serial range")
+                guard low <= high else {
+                    throw CertificateAuthorityError.signingFailed(message: "Malformed KRL serial range.")
+                }
+                ranges.append(low...high)
+            case .serialBitmap:
+                let offset = try payload.readUInt64(context: "KRL serial bitmap")
+                let bitmap = try payload.readStringData(context: "KRL serial bitmap")
+                ranges.append(contentsOf: try bitmapRanges(bitmap, offset: offset))
+            case .keyID:
+                while !payload.isAtEnd {
+                    revoked.keyIDs.insert(try payload.readStringText(context: "KRL key ID"))
+                }
+            case nil:
+                // Unknown subsections are skipped, as ssh-keygen does.
+                continue
+            }
+        }
+        revoked.serialRanges = mergeRanges(ranges)
+        return revoked
+    }
+
+    /// Runs of set bits in a big-endian mpint bitmap; bit `i` is serial
+    /// `offset + i`.
+    private static func bitmapRanges(_ bitmap: Data, offset: UInt64) throws -> [ClosedRange<UInt64>] {
+        let bytes = [UInt8](bitmap)
+        var ranges: [ClosedRange<UInt64>] = []
+        var runStart: UInt64?
+        let bitCount = UInt64(bytes.count) * 8
+        for bit in 0..<bitCount {
+            let byte = bytes[bytes.count - 1 - Int(bit / 8)]
+            let isSet = byte & (1 << UInt8(bit % 8)) != 0
+            if isSet, runStart == nil {
+                runStart = bit
+            } else if !isSet, let start = runStart {
+                ranges.append(try serialRange(offset: offset, start, bit - 1))
+                runStart = nil
+            }
+        }
+        if let start = runStart {
+            ranges.append(try serialRange(offset: offset, start, bitCount - 1))
+        }
+        return ranges
+    }
+
+    private static func serialRange(offset: UInt64, _ start: UInt64, _ end: UInt64) throws -> ClosedRange<UInt64> {
+        let (low, lowOverflow) = offset.addingReportingOverflow(start)
+        let (high, highOverflow) = offset.addingReportingOverflow(end)
+        guard !lowOverflow, !highOverflow else {
+            throw CertificateAuthorityError.signingFailed(message: "Malformed KRL serial bitmap.")
+        }
+        return low...high
+    }
+
+    static func mergeRanges(_ ranges: [ClosedRange<UInt64>]) -> [ClosedRange<UInt64>] {
+        var merged: [ClosedRange<UInt64>] = []
+        for range in ranges.sorted(by: { $0.lowerBound < $1.lowerBound }) {
+            if let last = merged.last, last.upperBound == .max || range.lowerBound <= last.upperBound + 1 {
+                merged[merged.count - 1] = last.lowerBound...max(last.upperBound, range.upperBound)
+            } else {
+                merged.append(range)
+            }
+        }
+        return merged
+    }
+
+    // MARK: - Writing
+
+    func serialized() -> Data {
+        var data = Data()
+        data.appendKRL(Self.magic)
+        data.appendKRL(Self.formatVersion)
+        data.appendKRL(version)
+        data.appendKRL(generatedDate)
+        data.appendKRL(flags)
+        data.appendKRLString(Data())
+        data.appendKRLString(Data(comment.utf8))
+        for section in sections {
+            data.append(section.type)
+            data.appendKRLString(section.data)
+        }
+        return data
+    }
+
+    /// Append certificate sections after the existing ones, keeping the
+    /// section order ssh-keygen writes. Signature sections are removed.
+    mutating func appendCertificateSections(_ newSections: [Section]) {
+        sections.removeAll { $0.type == SectionType.signature.rawValue }
+        let insertion = (sections.lastIndex { $0.type == SectionType.certificates.rawValue }).map { $0 + 1 } ?? 0
+        sections.insert(contentsOf: newSections, at: insertion)
+    }
+
+    /// A certificate section revoking `serials` and `keyIDs` under `caKey`.
+    /// Serial 0 is not revocable by serial and is ignored.
+    static func certificateSection(caKey: Data, serials: [UInt64], keyIDs: [String]) -> Section {
+        var data = Data()
+        data.appendKRLString(caKey)
+        data.appendKRLString(Data())
+        for subsection in serialSubsections(Set(serials).subtracting([0]).sorted()) {
+            data.append(subsection.type.rawValue)
+            data.appendKRLString(subsection.data)
+        }
+        let sortedKeyIDs = Set(keyIDs).sorted()
+        if !sortedKeyIDs.isEmpty {
+            var payload = Data()
+            for keyID in sortedKeyIDs {
+                payload.appendKRLString(Data(keyID.utf8))
+            }
+            data.append(CertificateSectionType.keyID.rawValue)
+            data.appendKRLString(payload)
+        }
+        return Section(type: SectionType.certificates.rawValue, data: data)
+    }
+
+    /// Runs separated by at most this many unrevoked serials may share a
+    /// bitmap; a wider gap costs more bitmap bytes than a list entry.
+    private static let bitmapGapLimit: UInt64 = 64
+
+    /// Encode sorted, unique serials. Consecutive serials form runs, and
+    /// runs close enough to share a bitmap form clusters. Each cluster is
+    /// written as ranges, one bitmap, or list entries, whichever is
+    /// smallest; list entries from every cluster share one subsection.
+    static func serialSubsections(_ serials: [UInt64]) -> [(type: CertificateSectionType, data: Data)] {
+        var runs: [ClosedRange<UInt64>] = []
+        for serial in serials {
+            if let last = runs.last, last.upperBound &+ 1 == serial, last.upperBound != .max {
+                runs[runs.count - 1] = last.lowerBound...serial
+            } else {
+                runs.append(serial...serial)
+            }
+        }
+
+        // Each subsection costs a type byte and a length before its payload.
+        let header = 5.0
+        var subsections: [(type: CertificateSectionType, data: Data)] = []
+        var listed: [UInt64] = []
+        var start = 0
+        while start < runs.count {
+            var end = start
+            while end + 1 < runs.count, runs[end + 1].lowerBound - runs[end].upperBound <= bitmapGapLimit {
+                end += 1
+            }
+            let cluster = runs[start...end]
+            let count = cluster.reduce(0.0) { $0 + Double($1.upperBound - $1.lowerBound) + 1 }
+            let span = Double(cluster[end].upperBound - cluster[start].lowerBound) + 1
+            let listCost = 8 * count
+            let rangeCost = Double(cluster.count) * (header + 16)
+            let bitmapCost = header + 8 + 4 + (span / 8).rounded(.up) + 1
+
+            if rangeCost <= listCost, rangeCost <= bitmapCost {
+                for run in cluster {
+                    var data = Data()
+                    data.appendKRL(run.lowerBound)
+                    data.appendKRL(run.upperBound)
+                    subsections.append((.serialRange, data))
+                }
+            } else if bitmapCost < listCost {
+                subsections.append((.serialBitmap, bitmapSubsection(cluster)))
+            } else {
+                for run in cluster {
+                    listed.append(contentsOf: run)
+                }
+            }
+            start = end + 1
+        }
+
+        if !listed.isEmpty {
+            var data = Data()
+            for serial in listed {
+                data.appendKRL(serial)
+            }
+            subsections.insert((.serialList, data), at: 0)
+        }
+        return subsections
+    }
+
+    private static func bitmapSubsection(_ runs: ArraySlice<ClosedRange<UInt64>>) -> Data {
+        let offset = runs[runs.startIndex].lowerBound
+        let span = Int(runs[runs.endIndex - 1].upperBound - offset) + 1
+        var bytes = [UInt8](repeating: 0, count: (span + 7) / 8)
+        for run in runs {
+            for serial in run {
+                let bit = Int(serial - offset)
+                bytes[bytes.count - 1 - bit / 8] |= 1 << UInt8(bit % 8)
+            }
+        }
+        // mpint: no leading zero bytes, plus one if the top bit is set.
+        if let first = bytes.firstIndex(where: { $0 != 0 }), first > 0 {
+            bytes.removeFirst(first)
+        }
+        if let top = bytes.first, top & 0x80 != 0 {
+            bytes.insert(0, at: 0)
+        }
+        var data = Data()
+        data.appendKRL(offset)
+        data.appendKRLString(Data(bytes))
+        return data
+    }
+}
+
+// MARK: - Encoding
+
+private extension Data {
+
+    mutating func appendKRL<T: FixedWidthInteger>(_ value: T) {
+        var bigEndian = value.bigEndian
+        Swift.withUnsafeBytes(of: &bigEndian) { append(contentsOf: $0) }
+    }
+
+    mutating func appendKRLString(_ payload: Data) {
+        appendKRL(UInt32(payload.count))
+        append(payload)
+    }
+}
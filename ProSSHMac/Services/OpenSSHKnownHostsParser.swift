@@ -0,0 +1,117 @@
+// OpenSSHKnownHostsParser.swift
+// ProSSHV2
+//
+// Reads OpenSSH known_hosts files for import. Each line holds
+// comma-separated host patterns, a key type and a base64 key blob. The
+// blob's SHA-256 is formatted the way libssh reports fingerprints at
+// connect time (lowercase hex, colon-separated), so imported entries
+// verify without a prompt.
+//
+// Hashed names (`|1|salt|hash`, written with HashKnownHosts) cannot be
+// turned back into hostnames. They are returned as salt and HMAC-SHA1, and
+// matched when a host is connected to. Marker lines (`@cert-authority`,
+// `@revoked`) and wildcard or negated patterns are skipped.
+
+import CryptoKit
+import Foundation
+
+/// A known_hosts line whose hostname was hashed.
+nonisolated struct HashedKnownHostEntry: Codable, Hashable, Sendable {
+    var salt: Data
+    var hash: Data
+    var hostKeyType: String
+    var fingerprint: String
+
+    var id: String {
+        "\(salt.base64EncodedString())|\(hash.base64EncodedString())|\(hostKeyType)"
+    }
+
+    /// Whether the hash was made from this host, using OpenSSH's name
+    /// form: the hostname, or `[hostname]:port` off port 22.
+    func matches(hostname: String, port: UInt16) -> Bool {
+        let name = hostname.lowercased()
+        let hashedName = port == 22 ? name : "[\(name)]:\(port)"
+        let code = HMAC<Insecure.SHA1>.authenticationCode(
+            for: Data(hashedName.utf8),
+            using: SymmetricKey(data: salt)
+        )
+        return Data(code) == hash
+    }
+}
+
+nonisolated struct OpenSSHKnownHostsParseResult: Sendable {
+    var entries: [KnownHostEntry] = []
+    var hashedEntries: [HashedKnownHostEntry] = []
+    /// Lines that had no usable host pattern or key.
+    var skippedLines = 0
+}
+
+nonisolated struct OpenSSHKnownHostsParser: Sendable {
+
+    /// Parse a known_hosts file. Plain entries are stamped as trusted at
+    /// `importedAt`.
+    func parse(_ contents: String, importedAt: Date = .now) -> OpenSSHKnownHostsParseResult {
+        var result = OpenSSHKnownHostsParseResult()
+        for rawLine in contents.split(whereSeparator: \.isNewline) {
+            let line = rawLine.trimmingCharacters(in: .whitespaces)
+            if line.isEmpty || line.hasPrefix("#") { continue }
+
+            let fields = line.split(whereSeparator: { $0 == " " || $0 == "\t" }).map(String.init)
+            guard fields.count >= 3, !fields[0].hasPrefix("@"), let blob = Data(base64Encoded: fields[2]) else {
+                result.skippedLines += 1
+                continue
+            }
+            let hostKeyType = fields[1]
+            let fingerprint = Self.fingerprint(ofKeyBlob: blob)
+
+            var usedPattern = false
+            for pattern in fields[0].split(separator: ",").map(String.init) {
+                if pattern.hasPrefix("|1|") {
+                    let parts = pattern.split(separator: "|")
+                    guard parts.count == 3,
+                          let salt = Data(base64Encoded: String(parts[1])),
+                          let hash = Data(base64Encoded: String(parts[2])) else {
+                        continue
+                    }
+                    result.hashedEntries.append(HashedKnownHostEntry(
+                        salt: salt,
+                        hash: hash,
+                        hostKeyType: hostKeyType,
+                        fingerprint: fingerprint
+                    ))
+                    usedPattern = true
+                } else if let (hostname, port) = Self.address(fromPattern: pattern) {
+                    result.entries.append(KnownHostEntry(
+                        hostname: hostname,
+                        port: port,
+                        hostKeyType: hostKeyType,
+                        fingerprint: fingerprint,
+                        firstTrustedAt: importedAt,
+                        lastVerifiedAt: importedAt
+                    ))
+                    usedPattern = true
+                }
+            }
+            if !usedPattern {
+                result.skippedLines += 1
+            }
+        }
+        return result
+    }
+
+    /// `host` or `[host]:port`; nil for wildcard and negated patterns.
+    static func address(fromPattern pattern: String) -> (String, UInt16)? {
+        guard !pattern.isEmpty, !pattern.contains(where: { "*?!".contains($0) }) else { return nil }
+        guard pattern.hasPrefix("[") else { return (pattern, 22) }
+        guard let close = pattern.firstIndex(of: "]") else { return nil }
+        let hostname = String(pattern[pattern.index(after: pattern.startIndex)..<close])
+        let rest = pattern[pattern.index(after: close)...]
+        guard !hostname.isEmpty, rest.hasPrefix(":"), let port = UInt16(rest.dropFirst()) else { return nil }
+        return (hostname, port)
+    }
+
+    /// libssh's form: SHA-256 of the key blob as colon-separated lowercase hex.
+    static func fingerprint(ofKeyBlob blob: Data) -> String {
+        SHA256.hash(data: blob).map { String(format: "%02x", $0) }.joined(separator: ":")
+    }
+}
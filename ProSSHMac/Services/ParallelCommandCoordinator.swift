@@ -0,0 +1,265 @@
+// ParallelCommandCoordinator.swift
+// ProSSHV2
+//
+// Runs one command on many hosts without opening terminal sessions. Each
+// host gets an exec channel (`SSHTransporting.executeCommand`) on a
+// connection opened by `SessionManager.openExecConnection`, so no
+// `TerminalEngine`, renderer, PTY or broadcast routing is involved and a
+// host with a session already open rides its shared connection. A bounded
+// number of hosts run at once; output is capped per stream, so memory
+// stays proportional to the host count times the cap. The table of
+// results is published to `SessionManager.parallelCommandRun` at most
+// every `publishInterval`, so hundreds of hosts changing status do not
+// redraw the app once per change.
+
+import Foundation
+import os.log
+
+/// One command run across hosts, as the results table shows it.
+struct ParallelCommandRun: Identifiable, Equatable, Sendable {
+    let id: UUID
+    let command: String
+    let startedAt: Date
+    var results: [ParallelCommandHostResult]
+    var isFinished = false
+
+    /// Hosts still queued, connecting or running.
+    var pendingCount: Int {
+        results.filter { !$0.status.isFinal }.count
+    }
+
+    var succeededCount: Int {
+        results.filter { $0.status == .exited(0) }.count
+    }
+}
+
+/// One host's row in a `ParallelCommandRun`.
+struct ParallelCommandHostResult: Identifiable, Equatable, Sendable {
+    enum Status: Equatable, Sendable {
+        case queued
+        case connecting
+        case running
+        /// The command ended; nil when the server sent no exit status.
+        case exited(Int?)
+        case timedOut
+        case failed(String)
+        case cancelled
+
+        var isFinal: Bool {
+            switch self {
+            case .queued, .connecting, .running: false
+            case .exited, .timedOut, .failed, .cancelled: true
+            }
+        }
+    }
+
+    /// The host's ID.
+    let id: UUID
+    let label: String
+    let address: String
+    var status: Status = .queued
+    var stdout = ""
+    var stderr = ""
+    /// Output past the per-stream cap was dropped.
+    var truncated = false
+    var duration: Duration?
+}
+
+@MainActor final class ParallelCommandCoordinator {
+    weak var manager: SessionManager?
+
+    /// Hosts connecting or running at once.
+    static let defaultMaximumConcurrent = 16
+    /// Output kept per host and stream.
+    static let defaultOutputLimit = 64 * 1024
+    static let defaultTimeout: Duration = .seconds(60)
+    /// Longest a status change waits before the table is republished.
+    static let publishInterval: Duration = .milliseconds(100)
+
+    private static let logger = Logger(subsystem: "com.prossh", category: "ParallelCommand")
+
+    private var run: ParallelCommandRun?
+    /// Row index per host ID in `run`.
+    private var rowIndex: [UUID: Int] = [:]
+    private var runTask: Task<Void, Never>?
+    /// Exec connections open now, so cancelling can close them.
+    private var openSessionIDs: Set<UUID> = []
+    private var publishTask: Task<Void, Never>?
+
+    init() {}
+
+    nonisolated deinit {}
+
+    // MARK: - Running
+
+    /// Runs `command` on `hosts`, replacing any run in progress.
+    /// `resolveHost` finds jump hosts.
+    func run(
+        _ command: String,
+        on hosts: [Host],
+        resolveHost: @escaping (UUID) -> Host?,
+        maximumConcurrent: Int = ParallelCommandCoordinator.defaultMaximumConcurrent,
+        timeout: Duration = ParallelCommandCoordinator.defaultTimeout,
+        outputLimit: Int = ParallelCommandCoordinator.defaultOutputLimit
+    ) {
+        cancel()
+        var seen: Set<UUID> = []
+        let targets = hosts.filter { seen.insert($0.id).inserted }
+        let results = targets.map {
+            ParallelCommandHostResult(id: $0.id, label: $0.label, address: "\($0.username)@\($0.hostname):\($0.port)")
+        }
+        let runID = UUID()
+        run = ParallelCommandRun(id: runID, command: command, startedAt: .now, results: results)
+        rowIndex = Dictionary(uniqueKeysWithValues: targets.enumerated().map { ($1.id, $0) })
+        publishNow()
+        Self.logger.info("Running command on \(targets.count) hosts")
+
+        let width = max(1, maximumConcurrent)
+        runTask = Task { [weak self] in
+            await withTaskGroup(of: Void.self) { group in
+                // A sliding window: once `width` hosts are running, the next
+                // starts as one ends.
+                for (started, host) in targets.enumerated() {
+                    if started >= width {
+                        await group.next()
+                    }
+                    guard !Task.isCancelled else { break }
+                    let jumpHost = host.jumpHost.flatMap(resolveHost)
+                    group.addTask { [weak self] in
+                        await self?.runOne(
+                            command,
+                            on: host,
+                            jumpHost: jumpHost,
+                            runID: runID,
+                            timeout: timeout,
+                            outputLimit: outputLimit
+                        )
+                    }
+                }
+                await group.waitForAll()
+            }
+            self?.finish(runID: runID)
+        }
+    }
+
+    /// Stops the run in progress. Hosts not finished are marked cancelled
+    /// and their connections closed.
+    func cancel() {
+        guard let runTask else { return }
+        runTask.cancel()
+        self.runTask = nil
+        if var current = run {
+            for index in current.results.indices where !current.results[index].status.isFinal {
+                current.results[index].status = .cancelled
+            }
+            current.isFinished = true
+            run = current
+        }
+        publishNow()
+        let sessionIDs = openSessionIDs
+        openSessionIDs.removeAll()
+        Task { [weak manager] in
+            for sessionID in sessionIDs {
+                await manager?.transport.disconnect(sessionID: sessionID)
+            }
+        }
+    }
+
+    /// Waits for the run in progress, if any.
+    func waitUntilFinished() async {
+        await runTask?.value
+    }
+
+    private func runOne(
+        _ command: String,
+        on host: Host,
+        jumpHost: Host?,
+        runID: UUID,
+        timeout: Duration,
+        outputLimit: Int
+    ) async {
+        guard let manager, !Task.isCancelled else { return }
+        let clock = ContinuousClock()
+        let start = clock.now
+        let sessionID = UUID()
+        openSessionIDs.insert(sessionID)
+        defer { openSessionIDs.remove(sessionID) }
+
+        update(host.id, in: runID) { $0.status = .connecting }
+        do {
+            try await manager.openExecConnection(sessionID: sessionID, to: host, jumpHost: jumpHost)
+        } catch {
+            update(host.id, in: runID) {
+                $0.status = .failed(error.localizedDescription)
+                $0.duration = clock.now - start
+            }
+            return
+        }
+        guard !Task.isCancelled else {
+            await manager.transport.disconnect(sessionID: sessionID)
+            return
+        }
+
+        update(host.id, in: runID) { $0.status = .running }
+        let outcome: Result<SSHExecResult, Error>
+        do {
+            outcome = .success(try await manager.transport.executeCommand(
+                sessionID: sessionID,
+                command: command,
+                timeout: timeout,
+                maxOutputBytes: outputLimit
+            ))
+        } catch {
+            outcome = .failure(error)
+        }
+        await manager.transport.disconnect(sessionID: sessionID)
+
+        update(host.id, in: runID) { row in
+            row.duration = clock.now - start
+            switch outcome {
+            case .success(let result):
+                row.stdout = String(decoding: result.stdout, as: UTF8.self)
+                row.stderr = String(decoding: result.stderr, as: UTF8.self)
+                row.truncated = result.truncated
+                row.status = result.timedOut ? .timedOut : .exited(result.exitCode)
+            case .failure(let error):
+                row.status = .failed(error.localizedDescription)
+            }
+        }
+    }
+
+    private func finish(runID: UUID) {
+        guard run?.id == runID else { return }
+        runTask = nil
+        run?.isFinished = true
+        publishNow()
+        if let run {
+            Self.logger.info("Command finished: \(run.succeededCount) of \(run.results.count) hosts exited 0")
+        }
+    }
+
+    // MARK: - Publishing
+
+    /// Applies `change` to the row of `hostID` while `runID` is the current
+    /// run, unless the row is already final (cancelled).
+    private func update(_ hostID: UUID, in runID: UUID, _ change: (inout ParallelCommandHostResult) -> Void) {
+        guard run?.id == runID, let index = rowIndex[hostID],
+              var row = run?.results[index], !row.status.isFinal else { return }
+        change(&row)
+        run?.results[index] = row
+        schedulePublish()
+    }
+
+    private func schedulePublish() {
+        guard publishTask == nil else { return }
+        publishTask = Task { [weak self] in
+            try? await Task.sleep(for: Self.publishInterval)
+            self?.publishTask = nil
+            self?.publishNow()
+        }
+    }
+
+    private func publishNow() {
+        manager?.setParallelCommandRun(run)
+    }
+}
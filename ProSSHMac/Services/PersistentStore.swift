@@ -1,44 +1,129 @@
 // Extracted from HostStore.swift, KeyStore.swift, CertificateStore.swift, CertificateAuthorityStore.swift
+//
+// Items are stored one encrypted record each in an EncryptedRecordFile, so
+// saving after one host, key or certificate changed seals and writes only
+// that item and a small index. Items are still encoded on every save to
+// find the ones that changed, which costs far less than encrypting and
+// writing them. A store saved by older builds as one encrypted JSON array
+// is imported on first load, and the old file is removed.
+//
+// File reads, writes and AES-GCM run on a serial queue per store, so
+// loading at launch does not hold the main actor while records are read
+// and decrypted. Only JSON coding of the items happens on the caller.
+// Operations reach the queue in call order.
+import CryptoKit
 import Foundation
 
 @MainActor
-final class PersistentStore<T: Codable> {
+final class PersistentStore<T: Codable & Identifiable> where T.ID == UUID {
     private let fileManager: FileManager
     private let fileURL: URL
+    private let records: EncryptedRecordFile
+    private let queue: DispatchQueue
+    private var opening: Task<Void, Error>?
 
-    init(filename: String, fileManager: FileManager = .default) {
+    init(
+        filename: String,
+        fileManager: FileManager = .default,
+        makeKey: @escaping @Sendable (Data) throws -> SymmetricKey = { salt in
+            try EncryptedStorage.derivedKey(purpose: "persistent-store-v1", salt: salt)
+        }
+    ) {
         self.fileManager = fileManager
         let base = fileManager.urls(for: .applicationSupportDirectory, in: .userDomainMask).first
             ?? fileManager.temporaryDirectory
-        self.fileURL = base
-            .appendingPathComponent("ProSSHV2", isDirectory: true)
-            .appendingPathComponent(filename)
+        let directory = base.appendingPathComponent("ProSSHV2", isDirectory: true)
+        let name = (filename as NSString).deletingPathExtension
+        self.fileURL = directory.appendingPathComponent(filename)
+        self.records = EncryptedRecordFile(
+            directory: directory,
+            name: name,
+            fileManager: fileManager,
+            makeKey: makeKey
+        )
+        self.queue = DispatchQueue(label: "com.prossh.persistent-store.\(name)", qos: .userInitiated)
     }
 
     func load() async throws -> [T] {
-        guard fileManager.fileExists(atPath: fileURL.path(percentEncoded: false)) else {
-            return []
+        try await openIfNeeded()
+        let payloads = try await perform { try $0.readAll() }
+        let decoder = Self.makeDecoder()
+        return try payloads.map { try decoder.decode(T.self, from: $0) }
+    }
+
+    /// One item, decrypting only its record.
+    func load(id: UUID) async throws -> T? {
+        try await openIfNeeded()
+        let payload = try await perform { try $0.read(id: id) }
+        return try payload.map { try Self.makeDecoder().decode(T.self, from: $0) }
+    }
+
+    func save(_ items: [T]) async throws {
+        try await openIfNeeded()
+        let encoder = Self.makeEncoder()
+        let batch = try items.map { (id: $0.id, plaintext: try encoder.encode($0)) }
+        _ = try await perform { try $0.commit(batch) }
+    }
+
+    /// Run `work` against the record file on the store's queue.
+    private func perform<R: Sendable>(
+        _ work: @escaping @Sendable (EncryptedRecordFile) throws -> R
+    ) async throws -> R {
+        let records = records
+        return try await withCheckedThrowingContinuation { continuation in
+            queue.async {
+                continuation.resume(with: Result { try work(records) })
+            }
         }
-        let decoder = JSONDecoder()
-        decoder.dateDecodingStrategy = .iso8601
-        return try EncryptedStorage.loadJSON(
+    }
+
+    /// Open once, even when loads and saves start together; a failed open
+    /// is retried by the next call.
+    private func openIfNeeded() async throws {
+        if let opening {
+            return try await opening.value
+        }
+        let task = Task { try await self.openAndImportLegacy() }
+        opening = task
+        do {
+            try await task.value
+        } catch {
+            opening = nil
+            throw error
+        }
+    }
+
+    private func openAndImportLegacy() async throws {
+        let exists = try await perform { records in
+            try records.open()
+            return records.exists
+        }
+        guard !exists, fileManager.fileExists(atPath: fileURL.path(percentEncoded: false)) else {
+            return
+        }
+        let legacy = try EncryptedStorage.loadJSON(
             [T].self,
             from: fileURL,
             fileManager: fileManager,
-            decoder: decoder
+            decoder: Self.makeDecoder()
         ) ?? []
+        let encoder = Self.makeEncoder()
+        let batch = try legacy.map { (id: $0.id, plaintext: try encoder.encode($0)) }
+        _ = try await perform { try $0.commit(batch) }
+        try fileManager.removeItem(at: fileURL)
     }
 
-    func save(_ items: [T]) async throws {
+    private static func makeEncoder() -> JSONEncoder {
         let encoder = JSONEncoder()
-        encoder.outputFormatting = [.prettyPrinted, .sortedKeys]
+        encoder.outputFormatting = [.sortedKeys]
         encoder.dateEncodingStrategy = .iso8601
-        try EncryptedStorage.saveJSON(
-            items,
-            to: fileURL,
-            fileManager: fileManager,
-            encoder: encoder
-        )
+        return encoder
+    }
+
+    private static func makeDecoder() -> JSONDecoder {
+        let decoder = JSONDecoder()
+        decoder.dateDecodingStrategy = .iso8601
+        return decoder
     }
 }
 
@@ -0,0 +1,254 @@
+// PipelineLatencyTracer.swift
+// ProSSHV2
+//
+// Read-to-GPU latency tracing for shell output. The TerminalPerf signposts
+// time each stage on its own and only in DEBUG builds; nothing tied the
+// arrival of a byte to the frame that showed it.
+//
+// With tracing on, the output ring stamps a sampled channel read when it
+// returns. The parser picks the stamp up with the span that holds those
+// bytes and opens a trace. The trace then travels the same path as an echo
+// keystroke time (see InputEchoTracker). It goes from the parser to the
+// coordinator's next publish, into the pane's GridSnapshotFeed, and on to
+// the renderer's cell upload. The completion handler of the command buffer
+// that drew it closes the trace. Each interval lands in a per-session
+// log-bucket histogram.
+//
+// At most one trace per session is in flight, and a new one starts no
+// sooner than `sampleInterval` after the last. A read costs one relaxed
+// atomic load, and a sample a handful of timestamps. Traces that never
+// reach a frame (no pane showing the session, publishing suspended) are
+// dropped after `abandonInterval`.
+//
+// Toggle via: `defaults write com.prossh terminal.latencyTrace.enabled -bool true`
+
+import Foundation
+import os.log
+import QuartzCore
+
+// MARK: - PipelineTrace
+
+/// One sampled read on its way to the screen. Times are
+/// `CACurrentMediaTime()` seconds; 0 until the stage is reached.
+nonisolated struct PipelineTrace: Sendable {
+    let tracer: PipelineLatencyTracer
+    let sequence: UInt64
+    /// When the channel read returned.
+    let readAt: CFTimeInterval
+    /// When `TerminalEngine` finished parsing the span.
+    var parsedAt: CFTimeInterval = 0
+    /// When a snapshot containing the bytes was handed to the pane feeds.
+    var publishedAt: CFTimeInterval = 0
+    /// When the renderer uploaded that snapshot into its cell buffer.
+    var uploadedAt: CFTimeInterval = 0
+
+    /// The older of two traces. Merged batches and skipped snapshots carry
+    /// the oldest bytes they cover.
+    static func earliest(_ lhs: PipelineTrace?, _ rhs: PipelineTrace?) -> PipelineTrace? {
+        guard let lhs else { return rhs }
+        guard let rhs else { return lhs }
+        return rhs.readAt < lhs.readAt ? rhs : lhs
+    }
+
+    /// Close the trace at `completedAt`, when the GPU finished the frame.
+    func complete(at completedAt: CFTimeInterval = CACurrentMediaTime()) {
+        tracer.record(self, completedAt: completedAt)
+    }
+}
+
+// MARK: - Stages
+
+nonisolated enum PipelineLatencyStage: Int, CaseIterable, Sendable {
+    /// Channel read to parse finished.
+    case parse
+    /// Parse finished to snapshot published.
+    case publish
+    /// Snapshot published to cell buffer upload.
+    case upload
+    /// Cell buffer upload to command buffer completed.
+    case gpu
+    /// Channel read to command buffer completed.
+    case total
+
+    var label: String {
+        switch self {
+        case .parse: "read→parse"
+        case .publish: "parse→publish"
+        case .upload: "publish→upload"
+        case .gpu: "upload→gpu"
+        case .total: "read→gpu"
+        }
+    }
+}
+
+// MARK: - LatencyHistogram
+
+/// Fixed log-bucket histogram: four buckets per octave from 10 µs, so a
+/// percentile is exact to within 19%.
+nonisolated struct LatencyHistogram: Sendable, Equatable {
+    static let bucketCount = 96
+    static let baseSeconds: Double = 0.000_01
+    static let bucketsPerOctave: Double = 4
+
+    private(set) var counts = [UInt32](repeating: 0, count: bucketCount)
+    private(set) var sampleCount = 0
+
+    mutating func record(seconds: Double) {
+        let bucket: Int
+        if seconds <= Self.baseSeconds {
+            bucket = 0
+        } else {
+            bucket = min(Int(log2(seconds / Self.baseSeconds) * Self.bucketsPerOctave) + 1, Self.bucketCount - 1)
+        }
+        counts[bucket] &+= 1
+        sampleCount += 1
+    }
+
+    /// Upper bound, in seconds, of the bucket holding the `p` quantile
+    /// (0...1); nil when empty.
+    func percentile(_ p: Double) -> Double? {
+        guard sampleCount > 0 else { return nil }
+        let rank = max(1, Int((Double(sampleCount) * p).rounded(.up)))
+        var seen = 0
+        for (bucket, count) in counts.enumerated() {
+            seen += Int(count)
+            if seen >= rank {
+                return Self.upperBound(of: bucket)
+            }
+        }
+        return Self.upperBound(of: Self.bucketCount - 1)
+    }
+
+    static func upperBound(of bucket: Int) -> Double {
+        baseSeconds * pow(2, Double(bucket) / bucketsPerOctave)
+    }
+}
+
+// MARK: - PipelineLatencyReport
+
+nonisolated struct PipelineLatencyReport: Sendable {
+    var completedSamples: Int
+    var abandonedSamples: Int
+    var histograms: [PipelineLatencyStage: LatencyHistogram]
+
+    /// p50, p95 and p99 of `stage` in milliseconds; nil without samples.
+    func percentiles(for stage: PipelineLatencyStage) -> (p50: Double, p95: Double, p99: Double)? {
+        guard let histogram = histograms[stage],
+              let p50 = histogram.percentile(0.50),
+              let p95 = histogram.percentile(0.95),
+              let p99 = histogram.percentile(0.99) else { return nil }
+        return (p50 * 1000, p95 * 1000, p99 * 1000)
+    }
+
+    /// One line per stage: `read→gpu p50=4.8 p95=9.5 p99=16.0 ms`.
+    var summary: String {
+        var lines = ["samples=\(completedSamples) abandoned=\(abandonedSamples)"]
+        for stage in PipelineLatencyStage.allCases {
+            guard let values = percentiles(for: stage) else { continue }
+            lines.append(String(format: "%@ p50=%.2f p95=%.2f p99=%.2f ms", stage.label, values.p50, values.p95, values.p99))
+        }
+        return lines.joined(separator: "\n")
+    }
+}
+
+// MARK: - PipelineLatencyTracer
+
+/// Sampling and histograms for one session. Traces are opened by the
+/// parser task and closed on the renderer's completion queue.
+nonisolated final class PipelineLatencyTracer: @unchecked Sendable {
+
+    static let enabledDefaultsKey = "terminal.latencyTrace.enabled"
+
+    static var isEnabled: Bool {
+        UserDefaults.standard.bool(forKey: enabledDefaultsKey)
+    }
+
+    /// Shortest gap between two sampled reads.
+    static let sampleInterval: CFTimeInterval = 0.050
+
+    /// A trace still open after this long is dropped so sampling resumes.
+    static let abandonInterval: CFTimeInterval = 2.0
+
+    /// Completed samples between two summaries in the log.
+    static let logInterval = 500
+
+    private static let logger = Logger(subsystem: "com.prossh", category: "PipelineLatency")
+
+    let sessionID: UUID
+
+    private let lock = NSLock()
+    private var nextSequence: UInt64 = 1
+    private var inFlight: (sequence: UInt64, readAt: CFTimeInterval)?
+    private var lastSampleAt: CFTimeInterval = -.infinity
+    private var histograms: [PipelineLatencyStage: LatencyHistogram] = [:]
+    private var completedSamples = 0
+    private var abandonedSamples = 0
+
+    init(sessionID: UUID) {
+        self.sessionID = sessionID
+    }
+
+    /// Open a trace for bytes read at `readAt`, or nil when one is in
+    /// flight or the last sample was too recent.
+    func begin(readAt: CFTimeInterval, now: CFTimeInterval = CACurrentMediaTime()) -> PipelineTrace? {
+        lock.lock()
+        defer { lock.unlock() }
+        if let open = inFlight {
+            guard now - open.readAt > Self.abandonInterval else { return nil }
+            inFlight = nil
+            abandonedSamples += 1
+        }
+        guard readAt - lastSampleAt >= Self.sampleInterval else { return nil }
+        let sequence = nextSequence
+        nextSequence += 1
+        inFlight = (sequence, readAt)
+        lastSampleAt = readAt
+        return PipelineTrace(tracer: self, sequence: sequence, readAt: readAt)
+    }
+
+    /// Record a completed trace. Only the first completion of the open trace
+    /// counts; a second pane drawing the same snapshot is ignored.
+    func record(_ trace: PipelineTrace, completedAt: CFTimeInterval) {
+        lock.lock()
+        guard inFlight?.sequence == trace.sequence else {
+            lock.unlock()
+            return
+        }
+        inFlight = nil
+        let intervals: [(PipelineLatencyStage, CFTimeInterval, CFTimeInterval)] = [
+            (.parse, trace.readAt, trace.parsedAt),
+            (.publish, trace.parsedAt, trace.publishedAt),
+            (.upload, trace.publishedAt, trace.uploadedAt),
+            (.gpu, trace.uploadedAt, completedAt),
+            (.total, trace.readAt, completedAt),
+        ]
+        for (stage, start, end) in intervals where start > 0 && end >= start {
+            histograms[stage, default: LatencyHistogram()].record(seconds: end - start)
+        }
+        completedSamples += 1
+        let shouldLog = completedSamples % Self.logInterval == 0
+        lock.unlock()
+
+        if shouldLog {
+            logSummary()
+        }
+    }
+
+    func report() -> PipelineLatencyReport {
+        lock.lock()
+        defer { lock.unlock() }
+        return PipelineLatencyReport(
+            completedSamples: completedSamples,
+            abandonedSamples: abandonedSamples,
+            histograms: histograms
+        )
+    }
+
+    /// Write the current percentiles to the unified log.
+    func logSummary() {
+        let report = report()
+        guard report.completedSamples > 0 else { return }
+        let session = String(sessionID.uuidString.prefix(8)).lowercased()
+        Self.logger.info("pipeline_latency session=\(session, privacy: .public) \(report.summary.replacingOccurrences(of: "\n", with: " | "), privacy: .public)")
+    }
+}
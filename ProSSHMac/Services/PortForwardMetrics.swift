@@ -0,0 +1,127 @@
+import Foundation
+
+/// Point-in-time counters of one proxied connection.
+nonisolated struct ForwardConnectionStats: Identifiable, Equatable, Sendable {
+    let id: UUID
+    var bytesToRemote: Int64 = 0
+    var bytesToLocal: Int64 = 0
+    /// Time from the client's connect to the forward channel being usable;
+    /// nil for remote (`-R`) connections, which arrive already open.
+    var openLatency: Duration?
+    /// Time spent in `channel.write`, which is dominated by waiting for the
+    /// peer's window.
+    var remoteWriteWait: Duration = .zero
+    /// Time remote reads were paused because the local socket was not draining.
+    var localBackpressureWait: Duration = .zero
+    var age: Duration = .zero
+}
+
+/// Aggregate of one rule's connections, live and finished, with transfer rates
+/// over the last sampling interval.
+nonisolated struct PortForwardStats: Equatable, Sendable {
+    var bytesToRemote: Int64 = 0
+    var bytesToLocal: Int64 = 0
+    /// Bytes per second over the last sample.
+    var rateToRemote: Double = 0
+    var rateToLocal: Double = 0
+    var connectionsServed = 0
+    var averageOpenLatency: Duration?
+    var lastOpenLatency: Duration?
+    var remoteWriteWait: Duration = .zero
+    var localBackpressureWait: Duration = .zero
+    var connections: [ForwardConnectionStats] = []
+}
+
+/// Counters one `ForwardConnectionProxy` updates as bytes move. Lock-protected
+/// so the manager can sample without hopping onto each proxy's actor.
+nonisolated final class ForwardConnectionMetrics: @unchecked Sendable {
+    let id: UUID
+    private let lock = NSLock()
+    private let startedAt = ContinuousClock.now
+    private var stats: ForwardConnectionStats
+
+    init(openLatency: Duration? = nil) {
+        let id = UUID()
+        self.id = id
+        stats = ForwardConnectionStats(id: id, openLatency: openLatency)
+    }
+
+    func recordToRemote(_ count: Int, waited: Duration) {
+        lock.withLock {
+            stats.bytesToRemote += Int64(count)
+            stats.remoteWriteWait += waited
+        }
+    }
+
+    func recordToLocal(_ count: Int) {
+        lock.withLock {
+            stats.bytesToLocal += Int64(count)
+        }
+    }
+
+    func recordLocalBackpressure(_ waited: Duration) {
+        lock.withLock {
+            stats.localBackpressureWait += waited
+        }
+    }
+
+    func snapshot() -> ForwardConnectionStats {
+        lock.withLock {
+            var snapshot = stats
+            snapshot.age = ContinuousClock.now - startedAt
+            return snapshot
+        }
+    }
+}
+
+/// Folds per-connection snapshots into a rule's `PortForwardStats`. Pure value
+/// type: finished connections are retired into running totals and each
+/// `sample` derives rates from the change since the previous one.
+nonisolated struct PortForwardStatsAccumulator: Sendable {
+    private var retired = ForwardConnectionStats(id: UUID())
+    private var retiredCount = 0
+    private var openLatencyTotal: Duration = .zero
+    private var openLatencyCount = 0
+    private var lastOpenLatency: Duration?
+    private var previous: (toRemote: Int64, toLocal: Int64, at: ContinuousClock.Instant)?
+
+    init() {}
+
+    mutating func recordOpen(latency: Duration) {
+        openLatencyTotal += latency
+        openLatencyCount += 1
+        lastOpenLatency = latency
+    }
+
+    mutating func retire(_ connection: ForwardConnectionStats) {
+        retired.bytesToRemote += connection.bytesToRemote
+        retired.bytesToLocal += connection.bytesToLocal
+        retired.remoteWriteWait += connection.remoteWriteWait
+        retired.localBackpressureWait += connection.localBackpressureWait
+        retiredCount += 1
+    }
+
+    mutating func sample(live: [ForwardConnectionStats], at now: ContinuousClock.Instant) -> PortForwardStats {
+        var stats = PortForwardStats()
+        stats.bytesToRemote = retired.bytesToRemote + live.reduce(0) { $0 + $1.bytesToRemote }
+        stats.bytesToLocal = retired.bytesToLocal + live.reduce(0) { $0 + $1.bytesToLocal }
+        stats.remoteWriteWait = live.reduce(retired.remoteWriteWait) { $0 + $1.remoteWriteWait }
+        stats.localBackpressureWait = live.reduce(retired.localBackpressureWait) { $0 + $1.localBackpressureWait }
+        stats.connectionsServed = retiredCount + live.count
+        stats.lastOpenLatency = lastOpenLatency
+        if openLatencyCount > 0 {
+            stats.averageOpenLatency = openLatencyTotal / openLatencyCount
+        }
+        stats.connections = live
+
+        if let previous {
+            let seconds = Double((now - previous.at) / .milliseconds(1)) / 1000
+            if seconds > 0 {
+                stats.rateToRemote = max(0, Double(stats.bytesToRemote - previous.toRemote) / seconds)
+                stats.rateToLocal = max(0, Double(stats.bytesToLocal - previous.toLocal) / seconds)
+            }
+        }
+        previous = (stats.bytesToRemote, stats.bytesToLocal, now)
+        return stats
+    }
+}
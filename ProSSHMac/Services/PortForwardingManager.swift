@@ -1,6 +1,7 @@
 import Foundation
 import Combine
 import Network
+import os.log
 
 enum PortForwardState: String {
     case listening
@@ -15,6 +16,7 @@ struct ActivePortForward: Identifiable {
     var state: PortForwardState
     var activeConnections: Int
     var errorMessage: String?
+    var stats = PortForwardStats()
 }
 
 @MainActor
@@ -24,8 +26,16 @@ final class PortForwardingManager: ObservableObject {
     private let transport: any SSHTransporting
     private let auditLogManager: AuditLogManager?
     private var listeners: [UUID: NWListener] = [:]
+    private var remoteListeners: [UUID: any SSHRemoteForwardListener] = [:]
+    private var acceptTasks: [UUID: Task<Void, Never>] = [:]
     private var connectionProxies: [UUID: [ForwardConnectionProxy]] = [:]
+    private var statsAccumulators: [UUID: PortForwardStatsAccumulator] = [:]
+    private var statsTask: Task<Void, Never>?
+    private static let statsInterval: Duration = .seconds(1)
+    private static let logger = Logger(subsystem: "com.prossh", category: "PortForwarding")
     private let maxConnectionsPerRule = 32
+    /// A browser behind a SOCKS listener opens dozens of connections per page.
+    private let maxConnectionsPerDynamicRule = 256
 
     init(transport: any SSHTransporting, auditLogManager: AuditLogManager? = nil) {
         self.transport = transport
@@ -43,6 +53,11 @@ final class PortForwardingManager: ObservableObject {
                 activeConnections: 0
             )
 
+            if rule.kind == .remote {
+                await activateRemoteRule(rule, forward: forward, sessionID: sessionID)
+                continue
+            }
+
             do {
                 let params = NWParameters.tcp
                 guard let nwPort = NWEndpoint.Port(rawValue: rule.localPort) else {
@@ -60,7 +75,7 @@ final class PortForwardingManager: ObservableObject {
                 let capturedSessionID = sessionID
                 let capturedRule = rule
                 let capturedTransport = transport
-                let capturedMaxConnections = maxConnectionsPerRule
+                let capturedMaxConnections = rule.kind == .dynamic ? maxConnectionsPerDynamicRule : maxConnectionsPerRule
 
                 listener.newConnectionHandler = { [weak self] connection in
                     Task { @MainActor [weak self] in
@@ -92,6 +107,7 @@ final class PortForwardingManager: ObservableObject {
 
                 listener.start(queue: DispatchQueue(label: "prosshv2.portforward.\(forwardID.uuidString)"))
                 activeForwards.append(forward)
+                startStatsSamplingIfNeeded()
 
             } catch {
                 forward.state = .error
@@ -114,13 +130,23 @@ final class PortForwardingManager: ObservableObject {
             listener.cancel()
         }
 
+        acceptTasks.removeValue(forKey: id)?.cancel()
+        if let listener = remoteListeners.removeValue(forKey: id) {
+            await listener.close()
+        }
+
         if let proxies = connectionProxies.removeValue(forKey: id) {
             for proxy in proxies {
                 await proxy.stop()
             }
         }
 
+        statsAccumulators.removeValue(forKey: id)
         activeForwards.removeAll(where: { $0.id == id })
+        if activeForwards.isEmpty {
+            statsTask?.cancel()
+            statsTask = nil
+        }
     }
 
     private func handleNewConnection(
@@ -137,6 +163,12 @@ final class PortForwardingManager: ObservableObject {
             return
         }
 
+        if rule.kind == .dynamic {
+            await handleSOCKSConnection(connection, forwardID: forwardID, sessionID: sessionID, rule: rule, transport: transport)
+            return
+        }
+
+        let openStarted = ContinuousClock.now
         do {
             let channel = try await transport.openForwardChannel(
                 sessionID: sessionID,
@@ -146,7 +178,11 @@ final class PortForwardingManager: ObservableObject {
                 sourcePort: rule.localPort
             )
 
-            let proxy = ForwardConnectionProxy(connection: connection, channel: channel)
+            let proxy = ForwardConnectionProxy(
+                connection: connection,
+                channel: channel,
+                metrics: recordOpen(forwardID: forwardID, since: openStarted)
+            )
             connectionProxies[forwardID, default: []].append(proxy)
             updateConnectionCount(forwardID: forwardID)
 
@@ -167,8 +203,233 @@ final class PortForwardingManager: ObservableObject {
         }
     }
 
+    /// Dynamic (`-D`) rule: negotiate SOCKS5 with the client, then open a
+    /// forward channel to the destination it named. Each connection runs in its
+    /// own task and channel opens are pipelined by the transport, so parallel
+    /// requests do not wait on each other's round trips.
+    private func handleSOCKSConnection(
+        _ connection: NWConnection,
+        forwardID: UUID,
+        sessionID: UUID,
+        rule: PortForwardingRule,
+        transport: any SSHTransporting
+    ) async {
+        connection.start(queue: DispatchQueue(label: "prosshv2.socks.\(forwardID.uuidString)"))
+
+        var negotiator = SOCKS5Negotiator()
+        var request: (target: SOCKS5Negotiator.Target, leftover: Data)?
+        do {
+            while request == nil {
+                guard let data = try await connection.receiveChunk(), !data.isEmpty else {
+                    connection.cancel()
+                    return
+                }
+                let outcome = negotiator.receive(data)
+                if !outcome.response.isEmpty {
+                    try await connection.sendChunk(outcome.response)
+                }
+                switch outcome.state {
+                case .pending:
+                    continue
+                case .failed:
+                    connection.cancel()
+                    return
+                case .connect(let target, let leftover):
+                    request = (target, leftover)
+                }
+            }
+        } catch {
+            connection.cancel()
+            return
+        }
+        guard let request else { return }
+
+        let openStarted = ContinuousClock.now
+        let channel: any SSHForwardChannel
+        do {
+            channel = try await transport.openForwardChannel(
+                sessionID: sessionID,
+                remoteHost: request.target.host,
+                remotePort: request.target.port,
+                sourceHost: "127.0.0.1",
+                sourcePort: rule.localPort
+            )
+        } catch {
+            try? await connection.sendChunk(SOCKS5Negotiator.reply(.hostUnreachable))
+            connection.cancel()
+            await auditLogManager?.record(
+                category: .portForwarding,
+                action: "Forward channel open failed",
+                outcome: .failure,
+                sessionID: sessionID,
+                details: "SOCKS \(rule.localPort) -> \(request.target.host):\(request.target.port): \(error.localizedDescription)"
+            )
+            return
+        }
+
+        // The rule may have been stopped while the channel was opening.
+        guard listeners[forwardID] != nil,
+              (try? await connection.sendChunk(SOCKS5Negotiator.reply(.succeeded))) != nil else {
+            await channel.close()
+            connection.cancel()
+            return
+        }
+
+        let proxy = ForwardConnectionProxy(
+            connection: connection,
+            channel: channel,
+            initialData: request.leftover,
+            metrics: recordOpen(forwardID: forwardID, since: openStarted)
+        )
+        connectionProxies[forwardID, default: []].append(proxy)
+        updateConnectionCount(forwardID: forwardID)
+
+        await proxy.start { [weak self] in
+            Task { @MainActor [weak self] in
+                self?.removeProxy(proxy, forwardID: forwardID)
+            }
+        }
+    }
+
+    /// Remote (`-R`) rule: the server listens and hands each connection back as
+    /// a channel, which is bridged to localhost:`localPort` with the same proxy
+    /// as a local forward. Accepting waits on the session's I/O readiness, so
+    /// an idle listener costs no polling.
+    private func activateRemoteRule(_ rule: PortForwardingRule, forward: ActivePortForward, sessionID: UUID) async {
+        var forward = forward
+        guard NWEndpoint.Port(rawValue: rule.localPort) != nil, rule.localPort > 0 else {
+            forward.state = .error
+            forward.errorMessage = "Invalid local port \(rule.localPort)."
+            activeForwards.append(forward)
+            return
+        }
+
+        let listener: any SSHRemoteForwardListener
+        do {
+            listener = try await transport.listenRemoteForward(
+                sessionID: sessionID,
+                bindAddress: rule.remoteHost,
+                port: rule.remotePort
+            )
+        } catch {
+            forward.state = .error
+            forward.errorMessage = error.localizedDescription
+            activeForwards.append(forward)
+            await auditLogManager?.record(
+                category: .portForwarding,
+                action: "Remote forward listen failed",
+                outcome: .failure,
+                sessionID: sessionID,
+                details: "Rule \(rule.routeDescription): \(error.localizedDescription)"
+            )
+            return
+        }
+
+        let forwardID = forward.id
+        remoteListeners[forwardID] = listener
+        connectionProxies[forwardID] = []
+        activeForwards.append(forward)
+        startStatsSamplingIfNeeded()
+
+        acceptTasks[forwardID] = Task { [weak self] in
+            while !Task.isCancelled {
+                guard let channel = try? await listener.accept() else { break }
+                guard let self else {
+                    await channel.close()
+                    break
+                }
+                await self.handleRemoteChannel(channel, forwardID: forwardID, rule: rule)
+            }
+            guard !Task.isCancelled else { return }
+            // The session went away under the listener.
+            self?.updateForwardState(id: forwardID, state: .stopped)
+        }
+    }
+
+    private func handleRemoteChannel(_ channel: any SSHForwardChannel, forwardID: UUID, rule: PortForwardingRule) async {
+        let currentCount = connectionProxies[forwardID]?.count ?? 0
+        guard remoteListeners[forwardID] != nil, currentCount < maxConnectionsPerRule,
+              let port = NWEndpoint.Port(rawValue: rule.localPort) else {
+            await channel.close()
+            return
+        }
+
+        let connection = NWConnection(host: "127.0.0.1", port: port, using: .tcp)
+        let proxy = ForwardConnectionProxy(connection: connection, channel: channel, metrics: ForwardConnectionMetrics())
+        connectionProxies[forwardID, default: []].append(proxy)
+        updateConnectionCount(forwardID: forwardID)
+
+        await proxy.start { [weak self] in
+            Task { @MainActor [weak self] in
+                self?.removeProxy(proxy, forwardID: forwardID)
+            }
+        }
+    }
+
+    // MARK: - Metrics
+
+    /// Text summary of a session's forwards, for bug reports and the session
+    /// info panel.
+    func diagnosticsReport(for sessionID: UUID) -> String {
+        activeForwards.filter { $0.sessionID == sessionID }.map { forward in
+            let stats = forward.stats
+            var lines = ["\(forward.rule.routeDescription) [\(forward.state.rawValue)]"]
+            lines.append("  connections: \(forward.activeConnections) open, \(stats.connectionsServed) served")
+            lines.append("  bytes: \(stats.bytesToRemote) out, \(stats.bytesToLocal) in")
+            lines.append("  rate: \(Int(stats.rateToRemote)) B/s out, \(Int(stats.rateToLocal)) B/s in")
+            if let average = stats.averageOpenLatency, let last = stats.lastOpenLatency {
+                lines.append("  channel open: avg \(average), last \(last)")
+            }
+            lines.append("  waiting: \(stats.remoteWriteWait) on SSH window, \(stats.localBackpressureWait) on local socket")
+            for connection in stats.connections {
+                lines.append("    conn \(connection.id.uuidString.prefix(8)): \(connection.bytesToRemote) out, \(connection.bytesToLocal) in, age \(connection.age)")
+            }
+            if let error = forward.errorMessage {
+                lines.append("  error: \(error)")
+            }
+            return lines.joined(separator: "\n")
+        }.joined(separator: "\n")
+    }
+
+    private func recordOpen(forwardID: UUID, since start: ContinuousClock.Instant) -> ForwardConnectionMetrics {
+        let latency = ContinuousClock.now - start
+        statsAccumulators[forwardID, default: PortForwardStatsAccumulator()].recordOpen(latency: latency)
+        return ForwardConnectionMetrics(openLatency: latency)
+    }
+
+    /// Samples every rule once per `statsInterval` while any forward exists. The
+    /// counters are lock-protected, so this never waits on a proxy's actor.
+    private func startStatsSamplingIfNeeded() {
+        guard statsTask == nil else { return }
+        statsTask = Task { [weak self] in
+            while !Task.isCancelled {
+                try? await Task.sleep(for: Self.statsInterval)
+                guard let self, !Task.isCancelled else { return }
+                self.sampleStats()
+            }
+        }
+    }
+
+    private func sampleStats() {
+        let now = ContinuousClock.now
+        for index in activeForwards.indices {
+            let id = activeForwards[index].id
+            let live = (connectionProxies[id] ?? []).map { $0.metrics.snapshot() }
+            var accumulator = statsAccumulators[id] ?? PortForwardStatsAccumulator()
+            let stats = accumulator.sample(live: live, at: now)
+            statsAccumulators[id] = accumulator
+            if activeForwards[index].stats != stats {
+                activeForwards[index].stats = stats
+            }
+        }
+    }
+
     private func removeProxy(_ proxy: ForwardConnectionProxy, forwardID: UUID) {
+        guard connectionProxies[forwardID]?.contains(where: { $0 === proxy }) == true else { return }
         connectionProxies[forwardID]?.removeAll(where: { $0 === proxy })
+        let final = proxy.metrics.snapshot()
+        statsAccumulators[forwardID]?.retire(final)
+        Self.logger.debug("Forward connection closed: \(final.bytesToRemote) B out, \(final.bytesToLocal) B in, \(final.age, privacy: .public) open, window wait \(final.remoteWriteWait, privacy: .public), local wait \(final.localBackpressureWait, privacy: .public)")
         updateConnectionCount(forwardID: forwardID)
     }
 
@@ -184,20 +445,51 @@ final class PortForwardingManager: ObservableObject {
     }
 }
 
+/// Pumps bytes between a local `NWConnection` and an SSH forward channel.
+///
+/// - Remote → local keeps up to `sendHighWater` bytes queued in the connection
+///   instead of waiting out each send, so reading the next chunk (which lets
+///   libssh re-grant the channel window) overlaps the socket write. Reads stop
+///   at the mark until send completions bring it back down.
+/// - Local → remote takes large receives and hands each to `channel.write`,
+///   which returns only once the peer's window has admitted it. The next
+///   receive is not issued before that, so TCP flow control pushes back on the
+///   local client.
 actor ForwardConnectionProxy {
+    /// Bytes in flight to the local socket before remote reads pause.
+    static let sendHighWater = 1 << 20
+    static let receiveChunkSize = 256 * 1024
+
+    nonisolated let metrics: ForwardConnectionMetrics
     private let connection: NWConnection
     private let channel: any SSHForwardChannel
+    /// Client bytes already read before the proxy took over (pipelined after
+    /// a SOCKS request); sent ahead of everything else.
+    private let initialData: Data
     private var localToRemoteTask: Task<Void, Never>?
     private var remoteToLocalTask: Task<Void, Never>?
     private var isStopped = false
-
-    init(connection: NWConnection, channel: any SSHForwardChannel) {
+    private var unsentBytes = 0
+    private var sendFailed = false
+    private var sendCreditWaiter: CheckedContinuation<Void, Never>?
+
+    init(
+        connection: NWConnection,
+        channel: any SSHForwardChannel,
+        initialData: Data = Data(),
+        metrics: ForwardConnectionMetrics = ForwardConnectionMetrics()
+    ) {
         self.connection = connection
         self.channel = channel
+        self.initialData = initialData
+        self.metrics = metrics
     }
 
     func start(onComplete: @escaping @Sendable () -> Void) {
-        connection.start(queue: DispatchQueue(label: "prosshv2.fwdproxy.\(ObjectIdentifier(self))"))
+        // A SOCKS connection was already started for the handshake.
+        if connection.state == .setup {
+            connection.start(queue: DispatchQueue(label: "prosshv2.fwdproxy.\(ObjectIdentifier(self))"))
+        }
 
         localToRemoteTask = Task { [weak self] in
             guard let self else { return }
@@ -222,40 +514,97 @@ actor ForwardConnectionProxy {
         remoteToLocalTask?.cancel()
         localToRemoteTask = nil
         remoteToLocalTask = nil
+        resumeSendCreditWaiter()
 
         connection.cancel()
         await channel.close()
     }
 
     private func runLocalToRemote() async {
+        if !initialData.isEmpty {
+            do {
+                try await writeToChannel(initialData)
+            } catch {
+                return
+            }
+        }
         while !Task.isCancelled && !isStopped {
             do {
-                let data = try await receiveFromConnection()
+                let data = try await connection.receiveChunk(maximumLength: Self.receiveChunkSize)
                 guard let data, !data.isEmpty else { break }
-                try await channel.write(data)
+                try await writeToChannel(data)
             } catch {
                 break
             }
         }
     }
 
+    private func writeToChannel(_ data: Data) async throws {
+        let started = ContinuousClock.now
+        try await channel.write(data)
+        metrics.recordToRemote(data.count, waited: ContinuousClock.now - started)
+    }
+
     private func runRemoteToLocal() async {
-        while !Task.isCancelled && !isStopped {
+        while !Task.isCancelled && !isStopped && !sendFailed {
+            if unsentBytes >= Self.sendHighWater {
+                let started = ContinuousClock.now
+                await waitForSendCredit()
+                metrics.recordLocalBackpressure(ContinuousClock.now - started)
+                continue
+            }
             do {
-                guard await channel.isOpen else { break }
-                let data = try await channel.read()
-                guard let data else { break }
+                // nil is EOF or close; reads park on the session's readiness.
+                guard let data = try await channel.read() else { break }
                 if data.isEmpty { continue }
-                try await sendToConnection(data)
+                enqueueSend(data)
             } catch {
                 break
             }
         }
+        // Let already-queued bytes reach the client before the connection is
+        // cancelled.
+        while unsentBytes > 0 && !isStopped && !sendFailed {
+            await waitForSendCredit()
+        }
+    }
+
+    private func enqueueSend(_ data: Data) {
+        let count = data.count
+        unsentBytes += count
+        metrics.recordToLocal(count)
+        connection.send(content: data, completion: .contentProcessed { [weak self] error in
+            Task { await self?.sendCompleted(count, failed: error != nil) }
+        })
     }
 
-    private nonisolated func receiveFromConnection() async throws -> Data? {
+    private func sendCompleted(_ count: Int, failed: Bool) {
+        unsentBytes -= count
+        if failed {
+            sendFailed = true
+        }
+        if failed || unsentBytes < Self.sendHighWater / 2 || unsentBytes == 0 {
+            resumeSendCreditWaiter()
+        }
+    }
+
+    private func waitForSendCredit() async {
+        guard !isStopped, !sendFailed, sendCreditWaiter == nil else { return }
+        await withCheckedContinuation { continuation in
+            sendCreditWaiter = continuation
+        }
+    }
+
+    private func resumeSendCreditWaiter() {
+        sendCreditWaiter?.resume()
+        sendCreditWaiter = nil
+    }
+}
+
+private extension NWConnection {
+    nonisolated func receiveChunk(maximumLength: Int = 32768) async throws -> Data? {
         try await withCheckedThrowingContinuation { continuation in
-            connection.receive(minimumIncompleteLength: 1, maximumLength: 32768) { content, _, isComplete, error in
+            receive(minimumIncompleteLength: 1, maximumLength: maximumLength) { content, _, isComplete, error in
                 if let error {
                     continuation.resume(throwing: error)
                     return
@@ -269,9 +618,9 @@ actor ForwardConnectionProxy {
         }
     }
 
-    private nonisolated func sendToConnection(_ data: Data) async throws {
+    nonisolated func sendChunk(_ data: Data) async throws {
         try await withCheckedThrowingContinuation { (continuation: CheckedContinuation<Void, Error>) in
-            connection.send(content: data, completion: .contentProcessed { error in
+            send(content: data, completion: .contentProcessed { error in
                 if let error {
                     continuation.resume(throwing: error)
                 } else {
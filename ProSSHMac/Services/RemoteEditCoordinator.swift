@@ -0,0 +1,385 @@
+// RemoteEditCoordinator.swift
+// ProSSHV2
+//
+// "Open in Local Editor" for remote files. The file is downloaded into a
+// private mirror directory and watched with FSEvents; each save sends
+// only what changed. FileDelta compares the saved file with the version
+// last synced, the literal bytes go up over SFTP as one small file, and a
+// short sh script on an exec channel assembles the new version next to the
+// original from copies of the original and those bytes. It then renames
+// it over the original, so readers never see a half-written file. A one
+// line change to a 20 MB log costs about a block, not 20 MB.
+//
+// The host's copy is checked before each sync: if its modification time
+// or size moved since the last sync, nothing is written and the edit shows
+// a conflict until the user overwrites or stops editing. Hosts that refuse
+// exec channels get the whole file over SFTP instead.
+
+import Foundation
+import os.log
+
+/// One remote file open in a local editor, as the file browser shows it.
+struct RemoteEdit: Identifiable, Equatable, Sendable {
+    enum Status: Equatable, Sendable {
+        case downloading
+        case watching
+        case syncing
+        /// The last save reached the host; `bytesSent` went over the link.
+        case synced(bytesSent: Int, at: Date)
+        /// The host's copy changed since the last sync.
+        case conflict
+        case failed(String)
+    }
+
+    let id: UUID
+    let sessionID: UUID
+    let remotePath: String
+    let localURL: URL
+    var status: Status
+}
+
+@MainActor final class RemoteEditCoordinator {
+    weak var manager: SessionManager?
+
+    /// More operations than this and the delta is sent as the whole file.
+    static let maximumOperations = 512
+    /// Deltas above this share of the file are sent as the whole file.
+    static let maximumDeltaFraction = 0.75
+
+    private static let logger = Logger(subsystem: "com.prossh", category: "RemoteEdit")
+
+    private final class Mirror {
+        var edit: RemoteEdit
+        /// The version the host has, as of the last sync.
+        let baseURL: URL
+        var remoteModified: Date?
+        var watcher: TerminalLocalDirectoryWatcher?
+        var syncTask: Task<Void, Never>?
+        var syncAgain = false
+
+        init(edit: RemoteEdit, baseURL: URL) {
+            self.edit = edit
+            self.baseURL = baseURL
+        }
+    }
+
+    private var mirrors: [UUID: Mirror] = [:]
+    /// Sessions whose server refused an exec channel; their saves go up whole.
+    private var execUnavailableSessionIDs: Set<UUID> = []
+
+    private static var rootDirectory: URL {
+        FileManager.default.temporaryDirectory.appendingPathComponent("ProSSH-RemoteEdit", isDirectory: true)
+    }
+
+    init() {}
+
+    nonisolated deinit {}
+
+    // MARK: - Editing
+
+    /// Downloads `remotePath` into a watched mirror and returns the local
+    /// file to open. A file already open from this session reuses its mirror.
+    func open(sessionID: UUID, remotePath: String) async throws -> URL {
+        if let mirror = mirrors.values.first(where: { $0.edit.sessionID == sessionID && $0.edit.remotePath == remotePath }) {
+            return mirror.edit.localURL
+        }
+        guard let manager else { throw SSHTransportError.sessionNotFound }
+
+        let id = UUID()
+        let directory = Self.rootDirectory.appendingPathComponent(id.uuidString, isDirectory: true)
+        try FileManager.default.createDirectory(at: directory, withIntermediateDirectories: true)
+        let name = (remotePath as NSString).lastPathComponent
+        let localURL = directory.appendingPathComponent(name.isEmpty ? "untitled" : name)
+        let mirror = Mirror(
+            edit: RemoteEdit(id: id, sessionID: sessionID, remotePath: remotePath, localURL: localURL, status: .downloading),
+            baseURL: Self.rootDirectory.appendingPathComponent(id.uuidString + ".base")
+        )
+        mirrors[id] = mirror
+        publish()
+
+        do {
+            _ = try await manager.transport.downloadFile(sessionID: sessionID, remotePath: remotePath, localPath: localURL.path)
+            try FileManager.default.copyItem(at: localURL, to: mirror.baseURL)
+            mirror.remoteModified = try? await manager.transport.modificationTime(sessionID: sessionID, path: remotePath)
+        } catch {
+            close(id)
+            throw error
+        }
+
+        mirror.watcher = TerminalLocalDirectoryWatcher(rootPath: directory.path) { [weak self] _ in
+            Task { @MainActor [weak self] in
+                self?.scheduleSync(id)
+            }
+        }
+        mirror.edit.status = .watching
+        publish()
+        return localURL
+    }
+
+    /// Sends the local copy even though the host's copy changed.
+    func overwrite(_ id: UUID) {
+        guard let mirror = mirrors[id], mirror.watcher != nil else { return }
+        mirror.remoteModified = nil
+        scheduleSync(id, force: true)
+    }
+
+    /// Stops watching and deletes the mirror, unless it holds a save the
+    /// host never got; that copy stays where the editor has it open.
+    func close(_ id: UUID) {
+        guard let mirror = mirrors.removeValue(forKey: id) else { return }
+        mirror.watcher?.stop()
+        mirror.syncTask?.cancel()
+        let local = try? Data(contentsOf: mirror.edit.localURL)
+        if local == nil || local == (try? Data(contentsOf: mirror.baseURL)) {
+            try? FileManager.default.removeItem(at: mirror.edit.localURL.deletingLastPathComponent())
+        } else {
+            Self.logger.info("Kept unsynced remote edit at \(mirror.edit.localURL.path, privacy: .public)")
+        }
+        try? FileManager.default.removeItem(at: mirror.baseURL)
+        publish()
+    }
+
+    /// A closed session's edits stop syncing but stay listed, so a save
+    /// made after the drop is not thrown away with the mirror.
+    func sessionEnded(_ sessionID: UUID) {
+        for mirror in mirrors.values where mirror.edit.sessionID == sessionID {
+            mirror.watcher?.stop()
+            mirror.watcher = nil
+            mirror.syncTask?.cancel()
+            mirror.syncTask = nil
+            mirror.edit.status = .failed("The session ended.")
+        }
+        execUnavailableSessionIDs.remove(sessionID)
+        publish()
+    }
+
+    // MARK: - Sync
+
+    /// Syncs shortly after a save, once; saves during a sync queue one more.
+    private func scheduleSync(_ id: UUID, force: Bool = false) {
+        guard let mirror = mirrors[id] else { return }
+        guard mirror.syncTask == nil else {
+            mirror.syncAgain = true
+            return
+        }
+        mirror.syncTask = Task { [weak self] in
+            // Editors save through a temporary file and a rename; let it land.
+            try? await Task.sleep(for: .milliseconds(300))
+            await self?.runSyncs(id, force: force)
+        }
+    }
+
+    private func runSyncs(_ id: UUID, force: Bool) async {
+        var force = force
+        while let mirror = mirrors[id], !Task.isCancelled {
+            mirror.syncAgain = false
+            await sync(mirror, force: force)
+            force = false
+            guard mirror.syncAgain else { break }
+        }
+        mirrors[id]?.syncTask = nil
+    }
+
+    private func sync(_ mirror: Mirror, force: Bool) async {
+        guard let manager,
+              let new = try? Data(contentsOf: mirror.edit.localURL),
+              let base = try? Data(contentsOf: mirror.baseURL) else { return }
+        guard new != base || force else { return }
+        if mirror.edit.status == .conflict, !force { return }
+
+        let sessionID = mirror.edit.sessionID
+        let target = mirror.edit.remotePath
+        let transport = manager.transport
+        mirror.edit.status = .syncing
+        publish()
+
+        let current = try? await transport.modificationTime(sessionID: sessionID, path: target)
+        if let known = mirror.remoteModified, let current, current != known {
+            mirror.edit.status = .conflict
+            publish()
+            return
+        }
+
+        do {
+            let bytesSent: Int
+            if execUnavailableSessionIDs.contains(sessionID) {
+                bytesSent = try await uploadWhole(mirror, transport: transport)
+            } else {
+                bytesSent = try await uploadDelta(mirror, base: [UInt8](base), new: [UInt8](new), force: force, transport: transport)
+            }
+            try new.write(to: mirror.baseURL)
+            mirror.remoteModified = try? await transport.modificationTime(sessionID: sessionID, path: target)
+            mirror.edit.status = .synced(bytesSent: bytesSent, at: .now)
+            manager.sftpCoordinator.invalidateRemoteDirectory(sessionID: sessionID, path: RemotePath.parent(of: target) ?? "/")
+        } catch RemoteEditError.remoteChanged {
+            mirror.edit.status = .conflict
+        } catch {
+            Self.logger.error("Remote edit sync failed: \(error.localizedDescription, privacy: .public)")
+            mirror.edit.status = .failed(error.localizedDescription)
+        }
+        publish()
+    }
+
+    /// Sends the literal bytes over SFTP and assembles the new version on
+    /// the host. Returns the bytes sent.
+    private func uploadDelta(
+        _ mirror: Mirror,
+        base: [UInt8],
+        new: [UInt8],
+        force: Bool,
+        transport: any SSHTransporting
+    ) async throws -> Int {
+        let sessionID = mirror.edit.sessionID
+        var operations = FileDelta.operations(from: base, to: new)
+        if operations.count > Self.maximumOperations
+            || Double(FileDelta.literalByteCount(operations)) > Double(new.count) * Self.maximumDeltaFraction {
+            operations = new.isEmpty ? [] : [.literal(0..<new.count)]
+        }
+
+        let paths = RemoteEditScript.Paths(target: mirror.edit.remotePath)
+        // Checks the host's copy and creates the delta file private, before
+        // any bytes go up; SFTP creates files with the server's umask.
+        let prepared: SSHExecResult
+        do {
+            prepared = try await transport.executeCommand(
+                sessionID: sessionID,
+                command: RemoteEditScript.command(RemoteEditScript.prepare(paths: paths, baseSize: force ? nil : base.count)),
+                timeout: .seconds(30)
+            )
+        } catch {
+            execUnavailableSessionIDs.insert(sessionID)
+            return try await uploadWhole(mirror, transport: transport)
+        }
+        try Self.check(prepared)
+
+        var literals = Data()
+        for case .literal(let range) in operations {
+            literals.append(contentsOf: new[range])
+        }
+        let localDelta = mirror.baseURL.deletingPathExtension().appendingPathExtension("delta")
+        defer { try? FileManager.default.removeItem(at: localDelta) }
+        try literals.write(to: localDelta)
+        _ = try await transport.uploadFile(sessionID: sessionID, localPath: localDelta.path, remotePath: paths.delta)
+
+        let script = RemoteEditScript.apply(operations, paths: paths, newSize: new.count)
+        try Self.check(try await transport.executeCommand(
+            sessionID: sessionID,
+            command: RemoteEditScript.command(script),
+            timeout: .seconds(120)
+        ))
+        return literals.count + script.utf8.count
+    }
+
+    private static func check(_ result: SSHExecResult) throws {
+        switch result.exitCode {
+        case 0:
+            return
+        case RemoteEditScript.remoteChangedStatus:
+            throw RemoteEditError.remoteChanged
+        default:
+            let stderr = String(decoding: result.stderr, as: UTF8.self).trimmingCharacters(in: .whitespacesAndNewlines)
+            throw RemoteEditError.applyFailed(result.timedOut ? "Timed out." : stderr)
+        }
+    }
+
+    /// The whole file over SFTP, written in place.
+    private func uploadWhole(_ mirror: Mirror, transport: any SSHTransporting) async throws -> Int {
+        let result = try await transport.uploadFile(
+            sessionID: mirror.edit.sessionID,
+            localPath: mirror.edit.localURL.path,
+            remotePath: mirror.edit.remotePath
+        )
+        return Int(result.bytesTransferred)
+    }
+
+    private func publish() {
+        manager?.setRemoteEdits(mirrors.values.map(\.edit).sorted { $0.remotePath < $1.remotePath })
+    }
+}
+
+enum RemoteEditError: LocalizedError {
+    case remoteChanged
+    case applyFailed(String)
+
+    var errorDescription: String? {
+        switch self {
+        case .remoteChanged:
+            return "The file changed on the server since it was opened."
+        case .applyFailed(let message):
+            return message.isEmpty ? "The server could not apply the changes." : message
+        }
+    }
+}
+
+// MARK: - RemoteEditScript
+
+/// The sh script that builds the new version of a file on the host.
+nonisolated enum RemoteEditScript {
+
+    /// Exit status when the host's copy is not the size it was synced at.
+    static let remoteChangedStatus = 3
+
+    struct Paths: Equatable {
+        let target: String
+        /// The literal bytes, uploaded over SFTP.
+        let delta: String
+        /// The new version, renamed over `target` when complete.
+        let staging: String
+
+        init(target: String) {
+            self.target = target
+            let directory = RemotePath.parent(of: target) ?? "/"
+            let name = (target as NSString).lastPathComponent
+            delta = RemotePath.join(directory, ".\(name).prossh-delta")
+            staging = RemotePath.join(directory, ".\(name).prossh-edit")
+        }
+    }
+
+    /// Fails with `remoteChangedStatus` unless the target still has
+    /// `baseSize` bytes (nil skips the check), then creates an empty delta
+    /// file readable only by the user.
+    static func prepare(paths: Paths, baseSize: Int?) -> String {
+        var lines = ["t=\(quoted(paths.target)); d=\(quoted(paths.delta))"]
+        if let baseSize {
+            lines.append("[ \"$(wc -c < \"$t\" | tr -d ' ')\" -eq \(baseSize) ] || exit \(remoteChangedStatus)")
+        }
+        lines.append("umask 077 && : > \"$d\"")
+        return lines.joined(separator: "\n")
+    }
+
+    /// Copies come from `target` with `tail -c +N | head -c N`, literals
+    /// from `delta` in order. The staging file starts as a `cp -p` of the
+    /// target so the rename keeps its mode.
+    static func apply(_ operations: [FileDelta.Operation], paths: Paths, newSize: Int) -> String {
+        var lines = [
+            "set -e",
+            "t=\(quoted(paths.target)); d=\(quoted(paths.delta)); n=\(quoted(paths.staging))",
+            "cp -p \"$t\" \"$n\"",
+            "{",
+            ":",
+        ]
+        var literalOffset = 0
+        for operation in operations {
+            switch operation {
+            case let .copy(offset, length):
+                lines.append("tail -c +\(offset + 1) \"$t\" | head -c \(length)")
+            case .literal(let range):
+                lines.append("tail -c +\(literalOffset + 1) \"$d\" | head -c \(range.count)")
+                literalOffset += range.count
+            }
+        }
+        lines.append("} > \"$n\"")
+        lines.append("[ \"$(wc -c < \"$n\" | tr -d ' ')\" -eq \(newSize) ] || { rm -f \"$n\" \"$d\"; echo 'Assembled file has the wrong size.' >&2; exit 4; }")
+        lines.append("mv -f \"$n\" \"$t\"")
+        lines.append("rm -f \"$d\"")
+        return lines.joined(separator: "\n")
+    }
+
+    static func command(_ script: String) -> String {
+        "sh -c " + quoted(script)
+    }
+
+    private static func quoted(_ value: String) -> String {
+        "'" + value.replacingOccurrences(of: "'", with: #"'"'"'"#) + "'"
+    }
+}
@@ -0,0 +1,152 @@
+// RemoteHostMetrics.swift
+// ProSSHV2
+//
+// Live host facts for an SSH session: OS, load, memory, root disk and
+// uptime. They used to be reachable only by running commands in the
+// user's shell, which pollutes the PTY, or by opening an exec request per
+// question. A small POSIX sh sampler now runs on one long-lived exec
+// channel per session and prints a JSON line every interval; a sample
+// costs about 200 bytes and no process spawns on the local side.
+//
+// The sampler reads /proc on Linux and falls back to sysctl, vm_stat and
+// df elsewhere (macOS, BSD). Fields it cannot read are 0.
+
+import Foundation
+
+// MARK: - RemoteHostMetrics
+
+/// One sample from the sampler.
+nonisolated struct RemoteHostMetrics: Codable, Equatable, Sendable {
+    /// Host clock, seconds since 1970.
+    var timestamp: TimeInterval
+    /// `uname -sr`.
+    var operatingSystem: String
+    var processorCount: Int
+    /// 1, 5 and 15 minute load averages.
+    var load: [Double]
+    var memoryTotalBytes: Int64
+    var memoryAvailableBytes: Int64
+    /// The filesystem holding `/`.
+    var diskTotalBytes: Int64
+    var diskUsedBytes: Int64
+    var uptimeSeconds: TimeInterval
+
+    enum CodingKeys: String, CodingKey {
+        case timestamp = "t"
+        case operatingSystem = "os"
+        case processorCount = "cpus"
+        case load
+        case memoryTotalBytes = "mem_total"
+        case memoryAvailableBytes = "mem_available"
+        case diskTotalBytes = "disk_total"
+        case diskUsedBytes = "disk_used"
+        case uptimeSeconds = "uptime"
+    }
+
+    var memoryUsedFraction: Double? {
+        guard memoryTotalBytes > 0 else { return nil }
+        return 1 - Double(memoryAvailableBytes) / Double(memoryTotalBytes)
+    }
+
+    var diskUsedFraction: Double? {
+        guard diskTotalBytes > 0 else { return nil }
+        return Double(diskUsedBytes) / Double(diskTotalBytes)
+    }
+
+    /// A one-line summary for the metadata panel.
+    var summary: String {
+        var parts: [String] = []
+        if load.count == 3 {
+            parts.append(String(format: "Load %.2f %.2f %.2f", load[0], load[1], load[2]))
+        }
+        if let memory = memoryUsedFraction {
+            parts.append("Mem \(Int((memory * 100).rounded()))% of \(Self.bytes(memoryTotalBytes))")
+        }
+        if let disk = diskUsedFraction {
+            parts.append("Disk / \(Int((disk * 100).rounded()))%")
+        }
+        return parts.joined(separator: "  |  ")
+    }
+
+    private static func bytes(_ count: Int64) -> String {
+        ByteCountFormatter.string(fromByteCount: count, countStyle: .memory)
+    }
+}
+
+// MARK: - RemoteMetricsSampler
+
+nonisolated enum RemoteMetricsSampler {
+
+    /// The sampler, printing one `RemoteHostMetrics` JSON line every
+    /// `interval` seconds until the channel closes. Uses only sh, awk, df
+    /// and uname; the OS and CPU count are read once.
+    static func script(interval: Int) -> String {
+        """
+        os=$(uname -sr 2>/dev/null)
+        cpus=$(getconf _NPROCESSORS_ONLN 2>/dev/null || sysctl -n hw.ncpu 2>/dev/null || echo 0)
+        while :; do
+          now=$(date +%s)
+          if [ -r /proc/loadavg ]; then
+            read l1 l5 l15 rest < /proc/loadavg
+          else
+            set -- $(sysctl -n vm.loadavg 2>/dev/null | tr -d '{}')
+            l1=${1:-0}; l5=${2:-0}; l15=${3:-0}
+          fi
+          if [ -r /proc/meminfo ]; then
+            mem=$(awk '/^MemTotal:/{t=$2} /^MemAvailable:/{a=$2} END{printf "%.0f %.0f", t*1024, a*1024}' /proc/meminfo)
+          else
+            mem="$(sysctl -n hw.memsize hw.physmem 2>/dev/null | head -n 1) $(vm_stat 2>/dev/null | awk '/page size of/{p=$8} /Pages free/{f=$3} /Pages inactive/{i=$3} END{printf "%.0f", (f+i)*p}')"
+          fi
+          disk=$(df -Pk / 2>/dev/null | awk 'NR==2{printf "%.0f %.0f", $2*1024, $3*1024}')
+          if [ -r /proc/uptime ]; then
+            read up rest < /proc/uptime
+          else
+            boot=$(sysctl -n kern.boottime 2>/dev/null | awk '{gsub(",", ""); print $4}')
+            up=$((now - ${boot:-$now}))
+          fi
+          set -- $mem 0 0; mt=$1; ma=$2
+          set -- $disk 0 0; dt=$1; du=$2
+          printf '{"t":%s,"os":"%s","cpus":%s,"load":[%s,%s,%s],"mem_total":%s,"mem_available":%s,"disk_total":%s,"disk_used":%s,"uptime":%s}\\n' \\
+            "$now" "$os" "${cpus:-0}" "${l1:-0}" "${l5:-0}" "${l15:-0}" "${mt:-0}" "${ma:-0}" "${dt:-0}" "${du:-0}" "${up:-0}"
+          sleep \(max(interval, 1))
+        done
+        """
+    }
+
+    /// The exec command running `script(interval:)` under sh, whatever the
+    /// user's login shell is.
+    static func command(interval: Int) -> String {
+        let escaped = script(interval: interval).replacingOccurrences(of: "'", with: #"'"'"'"#)
+        return "sh -c '\(escaped)'"
+    }
+}
+
+// MARK: - RemoteMetricsLineDecoder
+
+/// Splits sampler output into lines and decodes each. Lines that are not
+/// samples (a login banner, a shell warning) are skipped.
+nonisolated struct RemoteMetricsLineDecoder {
+    /// A partial line longer than this is dropped.
+    static let maximumLineLength = 16 * 1024
+
+    private var partial = Data()
+    private let decoder = JSONDecoder()
+
+    init() {}
+
+    mutating func decode(_ chunk: Data) -> [RemoteHostMetrics] {
+        partial.append(chunk)
+        var samples: [RemoteHostMetrics] = []
+        while let newline = partial.firstIndex(of: 0x0A) {
+            let line = partial[partial.startIndex..<newline]
+            if let sample = try? decoder.decode(RemoteHostMetrics.self, from: line) {
+                samples.append(sample)
+            }
+            partial = Data(partial[partial.index(after: newline)...])
+        }
+        if partial.count > Self.maximumLineLength {
+            partial.removeAll()
+        }
+        return samples
+    }
+}
@@ -0,0 +1,170 @@
+// SFTPDirectoryCache.swift
+// ProSSHV2
+//
+// Remote directory listings of one session, keyed by normalized path, so
+// collapsing and re-expanding a directory in the file browser, or going
+// back to one, does not pay a full SFTP listing every time.
+//
+// A listing stays valid while its directory's modification time does:
+// adding, removing or renaming an entry bumps the directory mtime. A
+// listing checked within `freshnessInterval` is used as is. After that it
+// is revalidated with one stat, which costs one round trip however large
+// the directory is. Listing a parent revalidates its cached children for
+// free, because every child entry carries that child's current mtime.
+//
+// Limits: a file rewritten in place does not touch its directory, so its
+// cached size can lag until the listing is dropped. SFTP mtimes have
+// one-second resolution, so a change in the same second as the listing can
+// go unnoticed. An explicit refresh in the browser drops the cache, and
+// OSC 7 working-directory reports invalidate the directories involved.
+//
+// Least-recently-used listings are evicted beyond `capacity`.
+
+import Foundation
+
+struct SFTPDirectoryCache {
+
+    struct Listing: Equatable {
+        var entries: [SFTPDirectoryEntry]
+        /// The directory's mtime when it was listed; nil if unknown, in
+        /// which case the listing is only used while fresh.
+        var directoryModifiedAt: Date?
+        var validatedAt: Date
+    }
+
+    static let defaultCapacity = 256
+    static let defaultFreshnessInterval: TimeInterval = 3
+
+    let capacity: Int
+    let freshnessInterval: TimeInterval
+
+    private var listings: [String: Listing] = [:]
+    private var lastUse: [String: UInt64] = [:]
+    private var useCounter: UInt64 = 0
+
+    init(capacity: Int = defaultCapacity, freshnessInterval: TimeInterval = defaultFreshnessInterval) {
+        self.capacity = max(1, capacity)
+        self.freshnessInterval = freshnessInterval
+    }
+
+    var count: Int { listings.count }
+
+    // MARK: - Lookup
+
+    mutating func listing(for path: String) -> Listing? {
+        let key = RemotePath.normalize(path)
+        guard let listing = listings[key] else { return nil }
+        touch(key)
+        return listing
+    }
+
+    /// True when `path` was listed or revalidated within `freshnessInterval`.
+    func isFresh(_ path: String, now: Date = Date()) -> Bool {
+        guard let listing = listings[RemotePath.normalize(path)] else { return false }
+        return now.timeIntervalSince(listing.validatedAt) < freshnessInterval
+    }
+
+    /// The mtime of `path` according to its cached parent listing, if any.
+    func knownModificationTime(of path: String) -> Date? {
+        let key = RemotePath.normalize(path)
+        guard let parent = RemotePath.parent(of: key),
+              let entry = listings[parent]?.entries.first(where: { $0.path == key }) else {
+            return nil
+        }
+        return entry.modifiedAt
+    }
+
+    // MARK: - Updates
+
+    /// Stores the listing of `path` and reconciles cached listings of its
+    /// subdirectories against the mtimes the new listing reports. Changed
+    /// or vanished children are dropped and unchanged ones are revalidated.
+    mutating func store(
+        _ entries: [SFTPDirectoryEntry],
+        for path: String,
+        directoryModifiedAt: Date?,
+        now: Date = Date()
+    ) {
+        let key = RemotePath.normalize(path)
+        listings[key] = Listing(entries: entries, directoryModifiedAt: directoryModifiedAt, validatedAt: now)
+        touch(key)
+
+        let reported = Dictionary(
+            entries.lazy.filter(\.isDirectory).map { ($0.path, $0.modifiedAt) },
+            uniquingKeysWith: { first, _ in first }
+        )
+        for childPath in listings.keys where RemotePath.parent(of: childPath) == key {
+            guard let modifiedAt = reported[childPath] else {
+                invalidateSubtree(childPath)
+                continue
+            }
+            if let modifiedAt, modifiedAt == listings[childPath]?.directoryModifiedAt {
+                listings[childPath]?.validatedAt = now
+            } else {
+                listings.removeValue(forKey: childPath)
+                lastUse.removeValue(forKey: childPath)
+            }
+        }
+        evictIfNeeded()
+    }
+
+    /// Marks `path`'s listing current after a stat returned the same mtime.
+    mutating func revalidate(_ path: String, now: Date = Date()) {
+        let key = RemotePath.normalize(path)
+        listings[key]?.validatedAt = now
+    }
+
+    mutating func invalidate(_ path: String) {
+        let key = RemotePath.normalize(path)
+        listings.removeValue(forKey: key)
+        lastUse.removeValue(forKey: key)
+    }
+
+    /// Drops `path` and every cached listing below it.
+    mutating func invalidateSubtree(_ path: String) {
+        let key = RemotePath.normalize(path)
+        let prefix = key == "/" ? "/" : key + "/"
+        for cached in Array(listings.keys) where cached == key || cached.hasPrefix(prefix) {
+            listings.removeValue(forKey: cached)
+            lastUse.removeValue(forKey: cached)
+        }
+    }
+
+    mutating func removeAll() {
+        listings.removeAll()
+        lastUse.removeAll()
+    }
+
+    // MARK: - Prefetch
+
+    /// Subdirectories of `path` worth listing before the user expands them:
+    /// uncached, not hidden, in listing order.
+    func prefetchCandidates(in path: String, limit: Int) -> [String] {
+        guard limit > 0, let listing = listings[RemotePath.normalize(path)] else { return [] }
+        var candidates: [String] = []
+        for entry in listing.entries where entry.isDirectory && !entry.name.hasPrefix(".") {
+            guard listings[entry.path] == nil else { continue }
+            candidates.append(entry.path)
+            if candidates.count == limit {
+                break
+            }
+        }
+        return candidates
+    }
+
+    // MARK: - Eviction
+
+    private mutating func touch(_ key: String) {
+        useCounter &+= 1
+        lastUse[key] = useCounter
+    }
+
+    private mutating func evictIfNeeded() {
+        guard listings.count > capacity else { return }
+        let victims = lastUse.sorted { $0.value < $1.value }.prefix(listings.count - capacity)
+        for (key, _) in victims {
+            listings.removeValue(forKey: key)
+            lastUse.removeValue(forKey: key)
+        }
+    }
+}
@@ -0,0 +1,139 @@
+import Foundation
+
+/// Server side of the SOCKS5 handshake (RFC 1928) for dynamic forwarding:
+/// no-auth method, CONNECT command only. Pure value type so the protocol is
+/// testable without sockets: `PortForwardingManager` feeds it client bytes,
+/// sends back `response`, and once it yields a target opens the forward
+/// channel and answers with `reply(_:)`.
+///
+/// Clients may pipeline: the greeting, the request, and the first payload
+/// bytes can all arrive in one read. Bytes after the request come back as
+/// `leftover` and belong to the tunnelled stream.
+nonisolated struct SOCKS5Negotiator: Sendable {
+
+    enum ReplyCode: UInt8, Sendable {
+        case succeeded = 0x00
+        case generalFailure = 0x01
+        case hostUnreachable = 0x04
+        case connectionRefused = 0x05
+        case commandNotSupported = 0x07
+        case addressTypeNotSupported = 0x08
+    }
+
+    struct Target: Equatable, Sendable {
+        let host: String
+        let port: UInt16
+    }
+
+    enum State: Equatable, Sendable {
+        case pending
+        case connect(Target, leftover: Data)
+        case failed
+    }
+
+    struct Outcome: Equatable, Sendable {
+        /// Bytes to send to the client before acting on `state`.
+        var response = Data()
+        var state: State = .pending
+    }
+
+    private enum Phase {
+        case greeting
+        case request
+        case finished
+    }
+
+    private static let version: UInt8 = 0x05
+    private static let noAuthentication: UInt8 = 0x00
+    private static let noAcceptableMethods: UInt8 = 0xFF
+    private static let connectCommand: UInt8 = 0x01
+
+    private var phase = Phase.greeting
+    private var buffer: [UInt8] = []
+
+    init() {}
+
+    mutating func receive(_ data: Data) -> Outcome {
+        var outcome = Outcome()
+        guard phase != .finished else {
+            outcome.state = .failed
+            return outcome
+        }
+        buffer.append(contentsOf: data)
+
+        if phase == .greeting {
+            guard buffer.count >= 2 else { return outcome }
+            guard buffer[0] == Self.version else {
+                return finish(outcome, state: .failed)
+            }
+            let methodCount = Int(buffer[1])
+            guard buffer.count >= 2 + methodCount else { return outcome }
+            let methods = buffer[2..<(2 + methodCount)]
+            buffer.removeFirst(2 + methodCount)
+            guard methods.contains(Self.noAuthentication) else {
+                outcome.response.append(contentsOf: [Self.version, Self.noAcceptableMethods])
+                return finish(outcome, state: .failed)
+            }
+            outcome.response.append(contentsOf: [Self.version, Self.noAuthentication])
+            phase = .request
+        }
+
+        // VER CMD RSV ATYP DST.ADDR DST.PORT
+        guard buffer.count >= 5 else { return outcome }
+        guard buffer[0] == Self.version else {
+            return finish(outcome, state: .failed)
+        }
+        guard buffer[1] == Self.connectCommand else {
+            outcome.response.append(Self.reply(.commandNotSupported))
+            return finish(outcome, state: .failed)
+        }
+
+        let addressLength: Int
+        switch buffer[3] {
+        case 0x01: addressLength = 4
+        case 0x03: addressLength = 1 + Int(buffer[4])
+        case 0x04: addressLength = 16
+        default:
+            outcome.response.append(Self.reply(.addressTypeNotSupported))
+            return finish(outcome, state: .failed)
+        }
+        let requestLength = 4 + addressLength + 2
+        guard buffer.count >= requestLength else { return outcome }
+
+        let address = buffer[4..<(4 + addressLength)]
+        let host: String
+        switch buffer[3] {
+        case 0x01:
+            host = address.map(String.init).joined(separator: ".")
+        case 0x03:
+            host = String(decoding: address.dropFirst(), as: UTF8.self)
+        default:
+            host = stride(from: address.startIndex, to: address.endIndex, by: 2)
+                .map { String(UInt16(address[$0]) << 8 | UInt16(address[$0 + 1]), radix: 16) }
+                .joined(separator: ":")
+        }
+        let port = UInt16(buffer[requestLength - 2]) << 8 | UInt16(buffer[requestLength - 1])
+        guard !host.isEmpty, port > 0 else {
+            outcome.response.append(Self.reply(.generalFailure))
+            return finish(outcome, state: .failed)
+        }
+
+        let leftover = Data(buffer[requestLength...])
+        buffer.removeAll()
+        return finish(outcome, state: .connect(Target(host: host, port: port), leftover: leftover))
+    }
+
+    /// Reply to the CONNECT request. The bound address is not meaningful for a
+    /// tunnelled stream, so it is always 0.0.0.0:0.
+    static func reply(_ code: ReplyCode) -> Data {
+        Data([version, code.rawValue, 0x00, 0x01, 0, 0, 0, 0, 0, 0])
+    }
+
+    private mutating func finish(_ outcome: Outcome, state: State) -> Outcome {
+        var outcome = outcome
+        outcome.state = state
+        phase = .finished
+        buffer.removeAll()
+        return outcome
+    }
+}
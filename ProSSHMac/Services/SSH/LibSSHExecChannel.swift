@@ -0,0 +1,108 @@
+import Foundation
+
+/// One command running on its own libssh session channel. Reads both streams
+/// each pass and parks on the session's readiness signal in between, like the
+/// forward channels; after EOF it waits the same way for the exit status.
+nonisolated actor LibSSHExecChannel {
+    private nonisolated(unsafe) var pointer: OpaquePointer?
+    private let readiness: LibSSHReadinessSignal?
+    private var buffer = [UInt8](repeating: 0, count: 64 * 1024)
+    private var pending: [SSHExecEvent] = []
+    private var reachedEOF = false
+    private var finished = false
+
+    init(pointer: UncheckedOpaquePointer, readiness: LibSSHReadinessSignal?) {
+        self.pointer = pointer.raw
+        self.readiness = readiness
+    }
+
+    /// The next output chunk or the final `.exit`; nil afterwards or once closed.
+    func next() async throws -> SSHExecEvent? {
+        while !Task.isCancelled {
+            if !pending.isEmpty {
+                return pending.removeFirst()
+            }
+            guard !finished, let ptr = pointer else { return nil }
+            let token = readiness?.generation ?? 0
+
+            if !reachedEOF {
+                try readAvailable(ptr)
+            }
+            if reachedEOF {
+                var exitCode: Int32 = 0
+                let status = prossh_exec_channel_exit_status(ptr, &exitCode)
+                if status != 0 {
+                    finished = true
+                    pending.append(.exit(status > 0 && exitCode >= 0 ? Int(exitCode) : nil))
+                }
+            }
+            if !pending.isEmpty {
+                continue
+            }
+
+            if let readiness {
+                await readiness.wait(after: token)
+            } else {
+                try await Task.sleep(for: .milliseconds(10))
+            }
+        }
+        return nil
+    }
+
+    private func readAvailable(_ ptr: OpaquePointer) throws {
+        let bufferSize = buffer.count
+        var errorBuffer = [CChar](repeating: 0, count: 512)
+
+        // stderr first: EOF is only reported once both streams are drained.
+        let stderrCount = buffer.withUnsafeMutableBytes { rawBuffer -> Int32 in
+            guard let baseAddress = rawBuffer.baseAddress else { return -1 }
+            return prossh_exec_channel_read_stderr(
+                ptr,
+                baseAddress.assumingMemoryBound(to: CChar.self),
+                bufferSize,
+                &errorBuffer,
+                errorBuffer.count
+            )
+        }
+        if stderrCount < 0 {
+            throw SSHTransportError.transportFailure(message: errorBuffer.asString)
+        }
+        if stderrCount > 0 {
+            pending.append(.stderr(Data(buffer[0..<Int(stderrCount)])))
+        }
+
+        var isEOF = false
+        let stdoutCount = buffer.withUnsafeMutableBytes { rawBuffer -> Int32 in
+            guard let baseAddress = rawBuffer.baseAddress else { return -1 }
+            return prossh_forward_channel_read(
+                ptr,
+                baseAddress.assumingMemoryBound(to: CChar.self),
+                bufferSize,
+                &isEOF,
+                &errorBuffer,
+                errorBuffer.count
+            )
+        }
+        if stdoutCount < 0 {
+            throw SSHTransportError.transportFailure(message: errorBuffer.asString)
+        }
+        if stdoutCount > 0 {
+            pending.append(.stdout(Data(buffer[0..<Int(stdoutCount)])))
+        }
+        reachedEOF = isEOF
+    }
+
+    func close() {
+        guard let ptr = pointer else { return }
+        prossh_forward_channel_close(ptr)
+        pointer = nil
+        // Release a `next()` suspended on the shared readiness signal.
+        readiness?.signal()
+    }
+}
+
+private extension Array where Element == CChar {
+    nonisolated var asString: String {
+        String(decoding: prefix(while: { $0 != 0 }).map { UInt8(bitPattern: $0) }, as: UTF8.self)
+    }
+}
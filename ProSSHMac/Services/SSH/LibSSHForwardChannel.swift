@@ -3,16 +3,42 @@ import Foundation
 
 nonisolated actor LibSSHForwardChannel: SSHForwardChannel {
     private nonisolated(unsafe) var pointer: OpaquePointer?
+    private let readiness: LibSSHReadinessSignal?
+    /// Reused across reads. Sized well past one packet so a read can take
+    /// everything libssh has buffered and let it re-grant the window.
+    private var buffer = [UInt8](repeating: 0, count: 256 * 1024)
 
-    init(pointer: UncheckedOpaquePointer) {
+    init(pointer: UncheckedOpaquePointer, readiness: LibSSHReadinessSignal?) {
         self.pointer = pointer.raw
+        self.readiness = readiness
     }
 
+    /// Returns the next chunk of remote data, or nil at EOF/close. Parks on the
+    /// session's readiness signal between chunks instead of sleep-polling.
     func read() async throws -> Data? {
-        guard let ptr = pointer else { return nil }
+        while !Task.isCancelled {
+            // `close()` may run while we are suspended, so re-check every pass.
+            guard let ptr = pointer else { return nil }
+            let token = readiness?.generation ?? 0
 
-        let bufferSize = 32768
-        var buffer = [UInt8](repeating: 0, count: bufferSize)
+            guard let data = try readAvailable(ptr, into: &buffer) else {
+                return nil
+            }
+            if !data.isEmpty {
+                return data
+            }
+
+            if let readiness {
+                await readiness.wait(after: token)
+            } else {
+                try await Task.sleep(for: .milliseconds(10))
+            }
+        }
+        return Data()
+    }
+
+    private func readAvailable(_ ptr: OpaquePointer, into buffer: inout [UInt8]) throws -> Data? {
+        let bufferSize = buffer.count
         var isEOF = false
         var errorBuffer = [CChar](repeating: 0, count: 512)
 
@@ -34,38 +60,51 @@ nonisolated actor LibSSHForwardChannel: SSHForwardChannel {
             throw SSHTransportError.transportFailure(message: message)
         }
 
-        if isEOF {
-            return nil
+        if bytesRead > 0 {
+            return Data(buffer[0..<Int(bytesRead)])
         }
 
-        if bytesRead == 0 {
-            try await Task.sleep(for: .milliseconds(10))
-            return Data()
-        }
-
-        return Data(buffer[0..<Int(bytesRead)])
+        return isEOF ? nil : Data()
     }
 
+    /// Returns once all of `data` is in the channel. Whatever the peer's window
+    /// does not admit waits for the next readiness signal (a window adjust is
+    /// inbound traffic), so a slow consumer pushes back on the caller instead
+    /// of stalling the session.
     func write(_ data: Data) async throws {
-        guard let ptr = pointer else {
-            throw SSHTransportError.transportFailure(message: "Forward channel is closed.")
-        }
+        var offset = 0
+        while offset < data.count {
+            guard let ptr = pointer else {
+                throw SSHTransportError.transportFailure(message: "Forward channel is closed.")
+            }
+            try Task.checkCancellation()
+            let token = readiness?.generation ?? 0
 
-        var errorBuffer = [CChar](repeating: 0, count: 512)
-        let result = data.withUnsafeBytes { bytes -> Int32 in
-            let basePtr = bytes.baseAddress?.assumingMemoryBound(to: CChar.self)
-            return prossh_forward_channel_write(
-                ptr,
-                basePtr,
-                bytes.count,
-                &errorBuffer,
-                errorBuffer.count
-            )
-        }
+            var errorBuffer = [CChar](repeating: 0, count: 512)
+            let written = data.withUnsafeBytes { bytes -> Int32 in
+                let basePtr = bytes.baseAddress?.assumingMemoryBound(to: CChar.self)
+                return prossh_forward_channel_write(
+                    ptr,
+                    basePtr.map { $0 + offset },
+                    bytes.count - offset,
+                    &errorBuffer,
+                    errorBuffer.count
+                )
+            }
 
-        if result != 0 {
-            let message = errorBuffer.asString
-            throw SSHTransportError.transportFailure(message: message)
+            if written < 0 {
+                let message = errorBuffer.asString
+                throw SSHTransportError.transportFailure(message: message)
+            }
+            offset += Int(written)
+
+            if written == 0 {
+                if let readiness {
+                    await readiness.wait(after: token)
+                } else {
+                    try await Task.sleep(for: .milliseconds(10))
+                }
+            }
         }
     }
 
@@ -78,6 +117,8 @@ nonisolated actor LibSSHForwardChannel: SSHForwardChannel {
         guard let ptr = pointer else { return }
         prossh_forward_channel_close(ptr)
         pointer = nil
+        // Release a `read()` suspended on the shared readiness signal.
+        readiness?.signal()
     }
 }
 
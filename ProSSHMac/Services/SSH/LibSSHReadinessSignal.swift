@@ -0,0 +1,107 @@
+// LibSSHReadinessSignal.swift
+// ProSSHMac
+//
+// Bridges the C wrapper's shared kqueue loop (`prossh_io_loop_*`) to async readers.
+
+import Foundation
+
+/// Per-session readiness signal fed by the process-wide libssh I/O loop.
+///
+/// Every channel reader on a session (shell, forwards) shares one signal. Readers
+/// capture `generation` *before* a non-blocking read and, if the read came back
+/// empty, `await wait(after:)` with that token. Any readiness that happened after
+/// the token was taken — socket readable, or another channel's call consuming
+/// packets on our behalf — advances the generation, so wakeups cannot be lost.
+nonisolated final class LibSSHReadinessSignal: @unchecked Sendable {
+
+    private let handle: OpaquePointer
+    private let lock = NSLock()
+    private var _generation: UInt64 = 0
+    private var isFinished = false
+    private var nextWaiterID: UInt64 = 0
+    private var waiters: [UInt64: CheckedContinuation<Void, Never>] = [:]
+
+    private init(handle: OpaquePointer) {
+        self.handle = handle
+    }
+
+    /// Registers `handle` with the shared I/O loop. Returns nil if the loop could
+    /// not watch the session socket (e.g. not connected yet).
+    static func register(handle: OpaquePointer) -> LibSSHReadinessSignal? {
+        let signal = LibSSHReadinessSignal(handle: handle)
+        // The transport keeps the signal alive until `unregister()`, which the C
+        // side guarantees is not racing an in-flight callback.
+        let context = Unmanaged.passUnretained(signal).toOpaque()
+        let result = prossh_io_loop_register(handle, { context in
+            guard let context else { return }
+            Unmanaged<LibSSHReadinessSignal>.fromOpaque(context).takeUnretainedValue().signal()
+        }, context)
+        return result == 0 ? signal : nil
+    }
+
+    var generation: UInt64 {
+        lock.lock()
+        defer { lock.unlock() }
+        return _generation
+    }
+
+    /// Suspends until readiness is reported after `token`, the signal is finished,
+    /// or the calling task is cancelled.
+    func wait(after token: UInt64) async {
+        let waiterID: UInt64? = lock.withLock {
+            guard !isFinished, _generation == token else { return nil }
+            nextWaiterID &+= 1
+            return nextWaiterID
+        }
+        guard let waiterID else { return }
+
+        await withTaskCancellationHandler {
+            await withCheckedContinuation { (continuation: CheckedContinuation<Void, Never>) in
+                let shouldResume: Bool = lock.withLock {
+                    if isFinished || _generation != token || Task.isCancelled {
+                        return true
+                    }
+                    waiters[waiterID] = continuation
+                    return false
+                }
+                if shouldResume {
+                    continuation.resume()
+                } else {
+                    prossh_io_loop_arm(handle)
+                }
+            }
+        } onCancel: {
+            let continuation = lock.withLock { waiters.removeValue(forKey: waiterID) }
+            continuation?.resume()
+        }
+    }
+
+    /// Advances the generation and wakes every waiter. Called from the I/O loop
+    /// thread and from channel close paths.
+    func signal() {
+        let resumed: [CheckedContinuation<Void, Never>] = lock.withLock {
+            _generation &+= 1
+            let pending = Array(waiters.values)
+            waiters.removeAll(keepingCapacity: true)
+            return pending
+        }
+        for continuation in resumed {
+            continuation.resume()
+        }
+    }
+
+    /// Detaches from the I/O loop and releases all current and future waiters.
+    func unregister() {
+        prossh_io_loop_unregister(handle)
+        let resumed: [CheckedContinuation<Void, Never>] = lock.withLock {
+            isFinished = true
+            _generation &+= 1
+            let pending = Array(waiters.values)
+            waiters.removeAll()
+            return pending
+        }
+        for continuation in resumed {
+            continuation.resume()
+        }
+    }
+}
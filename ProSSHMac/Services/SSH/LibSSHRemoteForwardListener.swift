@@ -0,0 +1,52 @@
+import Foundation
+
+/// Remote (`-R`) listener on a libssh session. The C side queues each
+/// forwarded-tcpip channel the server opens while packets are processed, so
+/// `accept()` only dequeues, parking on the session's readiness signal between
+/// connections like the channel readers do.
+nonisolated actor LibSSHRemoteForwardListener: SSHRemoteForwardListener {
+    private nonisolated(unsafe) var pointer: OpaquePointer?
+    private let readiness: LibSSHReadinessSignal?
+    nonisolated let boundPort: UInt16
+
+    init(pointer: UncheckedOpaquePointer, readiness: LibSSHReadinessSignal?) {
+        self.pointer = pointer.raw
+        self.readiness = readiness
+        self.boundPort = prossh_remote_forward_bound_port(pointer.raw)
+    }
+
+    func accept() async throws -> (any SSHForwardChannel)? {
+        while !Task.isCancelled {
+            // `close()` may run while we are suspended, so re-check every pass.
+            guard let ptr = pointer else { return nil }
+            let token = readiness?.generation ?? 0
+
+            var accepted: OpaquePointer?
+            let status = prossh_remote_forward_accept(ptr, &accepted)
+            if status < 0 {
+                return nil
+            }
+            if status > 0, let accepted {
+                return LibSSHForwardChannel(
+                    pointer: UncheckedOpaquePointer(raw: accepted),
+                    readiness: readiness
+                )
+            }
+
+            if let readiness {
+                await readiness.wait(after: token)
+            } else {
+                try await Task.sleep(for: .milliseconds(50))
+            }
+        }
+        return nil
+    }
+
+    func close() async {
+        guard let ptr = pointer else { return }
+        pointer = nil
+        prossh_remote_forward_close(ptr)
+        // Release an `accept()` suspended on the shared readiness signal.
+        readiness?.signal()
+    }
+}
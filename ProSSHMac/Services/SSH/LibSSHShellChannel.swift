@@ -2,36 +2,62 @@
 import Foundation
 
 nonisolated actor LibSSHShellChannel: SSHShellChannel {
-    nonisolated let rawOutput: AsyncStream<Data>
+    /// Channel output lands here straight from `prossh_libssh_channel_read`.
+    /// Consume either this ring or `rawOutput`, never both.
+    nonisolated var outputRing: ShellOutputRing? { ring }
+
+    private nonisolated let ring: ShellOutputRing
+
+    /// Largest single read into the ring. libssh only re-grants window for
+    /// bytes it has handed over, so on high-BDP links a bigger slice keeps the
+    /// 2 MiB channel window open instead of draining it a packet at a time.
+    private nonisolated static let readSlice = 256 * 1024
 
     private nonisolated(unsafe) let handle: OpaquePointer
-    private nonisolated(unsafe) var rawContinuation: AsyncStream<Data>.Continuation
+    private let readiness: LibSSHReadinessSignal?
     private var readerTask: Task<Void, Never>?
+    /// Drains the C-side outbound queue; `send` only enqueues and rings this.
+    private var writerTask: Task<Void, Never>?
+    private nonisolated let writeRequests: AsyncStream<Void>
+    private nonisolated let writeDoorbell: AsyncStream<Void>.Continuation
+    private var writeFailure: String?
     private var isClosed = false
 
     private init(
         handle: OpaquePointer,
-        rawContinuation: AsyncStream<Data>.Continuation,
-        rawOutput: AsyncStream<Data>
+        readiness: LibSSHReadinessSignal?,
+        ring: ShellOutputRing
     ) {
         self.handle = handle
-        self.rawContinuation = rawContinuation
-        self.rawOutput = rawOutput
+        self.readiness = readiness
+        self.ring = ring
+        let (requests, doorbell) = AsyncStream<Void>.makeStream(bufferingPolicy: .bufferingNewest(1))
+        self.writeRequests = requests
+        self.writeDoorbell = doorbell
+    }
+
+    /// Copying bridge for consumers that want discrete chunks rather than ring spans.
+    nonisolated var rawOutput: AsyncStream<Data> {
+        let ring = self.ring
+        return AsyncStream<Data> { continuation in
+            let task = Task.detached {
+                while await ring.waitForReadable() {
+                    let region = ring.readableRegion
+                    continuation.yield(Data(region))
+                    ring.consume(region.count)
+                }
+                continuation.finish()
+            }
+            continuation.onTermination = { _ in task.cancel() }
+        }
     }
 
     nonisolated static func create(
         handle: UncheckedOpaquePointer,
+        readiness: LibSSHReadinessSignal?,
         pty: PTYConfiguration,
         enableAgentForwarding: Bool
     ) async throws -> LibSSHShellChannel {
-        var capturedRawContinuation: AsyncStream<Data>.Continuation?
-        let rawOutput = AsyncStream<Data> { continuation in
-            capturedRawContinuation = continuation
-        }
-        guard let rawContinuation = capturedRawContinuation else {
-            throw SSHTransportError.transportFailure(message: "Failed to initialize shell raw output stream.")
-        }
-
         var errorBuffer = [CChar](repeating: 0, count: 512)
         let openResult = pty.terminalType.withCString { termPtr in
             prossh_libssh_open_shell(
@@ -51,16 +77,47 @@ nonisolated actor LibSSHShellChannel: SSHShellChannel {
 
         let channel = LibSSHShellChannel(
             handle: handle.raw,
-            rawContinuation: rawContinuation,
-            rawOutput: rawOutput
+            readiness: readiness,
+            ring: ShellOutputRing()
         )
         await channel.startReaderTask()
+        await channel.startWriterTask()
         return channel
     }
 
     private func startReaderTask() {
-        readerTask = Task { [weak self] in
-            await self?.readLoop()
+        let handle = UncheckedOpaquePointer(raw: self.handle)
+        let readiness = self.readiness
+        let ring = self.ring
+        readerTask = Task.detached { [weak self] in
+            await Self.readLoop(handle: handle.raw, readiness: readiness, ring: ring)
+            await self?.readerDidFinish()
+        }
+    }
+
+    private func startWriterTask() {
+        let handle = UncheckedOpaquePointer(raw: self.handle)
+        let readiness = self.readiness
+        let requests = self.writeRequests
+        writerTask = Task.detached { [weak self] in
+            let failure = await Self.writeLoop(handle: handle.raw, readiness: readiness, requests: requests)
+            await self?.writerDidFinish(failure: failure)
+        }
+    }
+
+    private func readerDidFinish() {
+        readerTask = nil
+        guard !isClosed else { return }
+        isClosed = true
+        writeDoorbell.finish()
+        prossh_libssh_channel_close(handle)
+        ring.finish()
+    }
+
+    private func writerDidFinish(failure: String?) {
+        writerTask = nil
+        if let failure {
+            writeFailure = failure
         }
     }
 
@@ -69,29 +126,51 @@ nonisolated actor LibSSHShellChannel: SSHShellChannel {
     }
 
     func send(bytes: [UInt8]) async throws {
+        try await send(bytes: bytes, priority: .interactive)
+    }
+
+    /// Queues `bytes` and returns without waiting for the channel window; the
+    /// writer task sends them. A write that failed earlier is reported here.
+    func send(bytes: [UInt8], priority: SSHShellWritePriority) async throws {
         if isClosed {
             return
         }
 
+        if let writeFailure {
+            throw SSHTransportError.transportFailure(message: writeFailure)
+        }
+
         if bytes.isEmpty {
             return
         }
 
         var errorBuffer = [CChar](repeating: 0, count: 512)
-        let writeResult = bytes.withUnsafeBytes { payload in
+        let enqueueResult = bytes.withUnsafeBytes { payload in
             let ptr = payload.baseAddress?.assumingMemoryBound(to: CChar.self)
-            return prossh_libssh_channel_write(
+            return prossh_libssh_channel_enqueue(
                 handle,
                 ptr,
                 payload.count,
+                priority == .bulk,
                 &errorBuffer,
                 errorBuffer.count
             )
         }
 
-        if writeResult != 0 {
+        if enqueueResult != 0 {
             throw SSHTransportError.transportFailure(message: errorBuffer.asString)
         }
+        writeDoorbell.yield()
+    }
+
+    func queuedBulkByteCount() -> Int {
+        guard !isClosed else { return 0 }
+        return prossh_libssh_channel_queued_bulk(handle)
+    }
+
+    func discardQueuedBulk() -> Int {
+        guard !isClosed else { return 0 }
+        return prossh_libssh_channel_discard_bulk(handle)
     }
 
     func resizePTY(columns: Int, rows: Int) async throws {
@@ -115,56 +194,112 @@ nonisolated actor LibSSHShellChannel: SSHShellChannel {
         guard !isClosed else { return }
         isClosed = true
         readerTask?.cancel()
-        readerTask = nil
+        writeDoorbell.finish()
+        writerTask?.cancel()
         prossh_libssh_channel_close(handle)
-        rawContinuation.finish()
+        // Finishing the ring releases a reader parked on a full ring; then wait
+        // for it to observe the closed channel before the transport is allowed
+        // to destroy the handle underneath it.
+        ring.finish()
+        if let readerTask {
+            self.readerTask = nil
+            await readerTask.value
+        }
+        if let writerTask {
+            self.writerTask = nil
+            await writerTask.value
+        }
+    }
+
+    /// Flushes queued input whenever `send` rings, until the queue is empty.
+    /// While the channel window is full it parks on the readiness signal, since
+    /// the server's window adjust arrives as inbound data. Returns the error
+    /// that ended it, if any.
+    private nonisolated static func writeLoop(
+        handle: OpaquePointer,
+        readiness: LibSSHReadinessSignal?,
+        requests: AsyncStream<Void>
+    ) async -> String? {
+        var errorBuffer = [CChar](repeating: 0, count: 512)
+
+        for await _ in requests {
+            while !Task.isCancelled {
+                let token = readiness?.generation ?? 0
+                var pending = 0
+                guard prossh_libssh_channel_flush(handle, &pending, &errorBuffer, errorBuffer.count) == 0 else {
+                    let message = errorBuffer.asString
+                    return message.isEmpty ? "Shell channel is closed." : message
+                }
+                if pending == 0 {
+                    break
+                }
+                if let readiness {
+                    await readiness.wait(after: token)
+                } else {
+                    try? await Task.sleep(for: .milliseconds(10))
+                }
+            }
+        }
+        return nil
     }
 
-    private func readLoop() async {
-        let bufferSize = 32768
-        var buffer = [UInt8](repeating: 0, count: bufferSize)
+    /// Drains the channel into the output ring, then parks on the session's
+    /// readiness signal from the shared I/O loop instead of sleep-polling, so echo
+    /// latency tracks network RTT and idle sessions cost nothing. A full ring
+    /// suspends the reader, leaving data in the SSH window. Runs off the actor on
+    /// a detached task.
+    private nonisolated static func readLoop(
+        handle: OpaquePointer,
+        readiness: LibSSHReadinessSignal?,
+        ring: ShellOutputRing
+    ) async {
         var errorBuffer = [CChar](repeating: 0, count: 512)
 
-        while !Task.isCancelled && !isClosed {
+        while !Task.isCancelled {
+            // Taken before the read so readiness that races the read is not lost.
+            let token = readiness?.generation ?? 0
             var bytesRead = Int32(0)
             var isEOF = false
+            var readResult = Int32(0)
 
-            let readResult = buffer.withUnsafeMutableBytes { rawBuffer in
-                guard let baseAddress = rawBuffer.baseAddress else { return Int32(-1) }
+            let accepted = await ring.write { region in
+                guard let baseAddress = region.baseAddress else { return 0 }
                 let cBuffer = baseAddress.assumingMemoryBound(to: CChar.self)
-                return prossh_libssh_channel_read(
+                readResult = prossh_libssh_channel_read(
                     handle,
                     cBuffer,
-                    bufferSize,
+                    min(region.count, readSlice),
                     &bytesRead,
                     &isEOF,
                     &errorBuffer,
                     errorBuffer.count
                 )
+                return readResult == 0 ? Int(bytesRead) : 0
             }
+            guard accepted else { break }
 
             if readResult != 0 {
                 let message = errorBuffer.asString
                 if !message.isEmpty {
-                    rawContinuation.yield(Data("I/O error: \(message)".utf8))
+                    await ring.append(Array("I/O error: \(message)".utf8))
                 }
                 break
             }
 
-            if bytesRead > 0 {
-                rawContinuation.yield(Data(buffer[0..<Int(bytesRead)]))
-            }
-
             if isEOF {
                 break
             }
 
             if bytesRead == 0 {
-                try? await Task.sleep(for: .milliseconds(40))
+                if let readiness {
+                    await readiness.wait(after: token)
+                } else {
+                    // The I/O loop could not watch this socket; fall back to polling.
+                    try? await Task.sleep(for: .milliseconds(40))
+                }
             }
         }
-
-        await close()
+        ring.finish()
     }
 }
 
@@ -24,6 +24,49 @@ nonisolated private enum LibSSHConnectFailure: LocalizedError, Sendable {
     }
 }
 
+/// Bridges `prossh_libssh_sftp_walk` batches into an `AsyncThrowingStream`.
+/// Lives until the walk returns; the cancel flag is polled by the C side.
+nonisolated private final class LibSSHWalkContext: @unchecked Sendable {
+    let continuation: AsyncThrowingStream<[SFTPDirectoryEntry], Error>.Continuation
+    let cancelFlag: UnsafeMutablePointer<Int32>
+
+    init(continuation: AsyncThrowingStream<[SFTPDirectoryEntry], Error>.Continuation) {
+        self.continuation = continuation
+        cancelFlag = UnsafeMutablePointer<Int32>.allocate(capacity: 1)
+        cancelFlag.initialize(to: 0)
+    }
+
+    deinit {
+        cancelFlag.deinitialize(count: 1)
+        cancelFlag.deallocate()
+    }
+
+    var isCancelled: Bool { cancelFlag.pointee != 0 }
+
+    func cancel() {
+        cancelFlag.pointee = 1
+    }
+
+    /// Returns false once the consumer has gone away.
+    func deliver(_ batch: UnsafeBufferPointer<ProSSHSFTPEntry>) -> Bool {
+        let entries = batch.map { entry in
+            SFTPDirectoryEntry(
+                path: String(cString: entry.path),
+                name: String(cString: entry.name),
+                isDirectory: entry.is_directory,
+                size: Int64(entry.size),
+                permissions: entry.permissions,
+                modifiedAt: entry.modified_time > 0 ? Date(timeIntervalSince1970: TimeInterval(entry.modified_time)) : nil,
+                isRegularFile: entry.is_regular_file
+            )
+        }
+        if case .terminated = continuation.yield(entries) {
+            cancel()
+        }
+        return !isCancelled
+    }
+}
+
 nonisolated struct LibSSHAuthenticationMaterial: Sendable {
     var password: String? = nil
     var privateKey: String? = nil
@@ -85,9 +128,11 @@ struct LibSSHJumpCallParams: Sendable {
         jumpKeyPassphrase = material.keyPassphrase
     }
 
-    nonisolated func invoke(handle: OpaquePointer, target: LibSSHTargetParams,
-                            config: inout ProSSHJumpHostConfig,
-                            errorBuffer: inout [CChar]) -> Int32 {
+    /// Opens a shared bastion session (`prossh_jump_session_open`). The C side
+    /// only reads the string fields during the call.
+    nonisolated func openSession(config: inout ProSSHJumpHostConfig,
+                                 status: inout Int32,
+                                 errorBuffer: inout [CChar]) -> OpaquePointer? {
         return jumpHostname.withCString { jumpHostnamePtr in
             jumpUsername.withCString { jumpUsernamePtr in
                 jumpKex.withCString { jumpKexPtr in
@@ -99,46 +144,26 @@ struct LibSSHJumpCallParams: Sendable {
                                         LibSSHTransport.withOptionalCString(jumpPrivateKey) { pkPtr in
                                             LibSSHTransport.withOptionalCString(jumpCertificate) { certPtr in
                                                 LibSSHTransport.withOptionalCString(jumpKeyPassphrase) { ppPtr in
-                                                    target.hostname.withCString { hostnamePtr in
-                                                        target.username.withCString { usernamePtr in
-                                                            target.kex.withCString { kexPtr in
-                                                                target.ciphers.withCString { ciphersPtr in
-                                                                    target.hostKeys.withCString { hostKeysPtr in
-                                                                        target.macs.withCString { macsPtr in
-                                                                            config.jump_hostname = jumpHostnamePtr
-                                                                            config.jump_username = jumpUsernamePtr
-                                                                            config.jump_port = jumpPort
-                                                                            config.kex = jumpKexPtr
-                                                                            config.ciphers = jumpCiphersPtr
-                                                                            config.hostkeys = jumpHostKeysPtr
-                                                                            config.macs = jumpMacsPtr
-                                                                            config.timeout_seconds = 10
-                                                                            config.expected_fingerprint = fpPtr
-                                                                            config.auth_method = jumpAuthMethod
-                                                                            config.password = pwPtr
-                                                                            config.private_key = pkPtr
-                                                                            config.certificate = certPtr
-                                                                            config.key_passphrase = ppPtr
-                                                                            return prossh_libssh_connect_with_jump(
-                                                                                handle,
-                                                                                hostnamePtr,
-                                                                                target.port,
-                                                                                usernamePtr,
-                                                                                kexPtr,
-                                                                                ciphersPtr,
-                                                                                hostKeysPtr,
-                                                                                macsPtr,
-                                                                                10,
-                                                                                &config,
-                                                                                &errorBuffer,
-                                                                                errorBuffer.count
-                                                                            )
-                                                                        }
-                                                                    }
-                                                                }
-                                                            }
-                                                        }
-                                                    }
+                                                    config.jump_hostname = jumpHostnamePtr
+                                                    config.jump_username = jumpUsernamePtr
+                                                    config.jump_port = jumpPort
+                                                    config.kex = jumpKexPtr
+                                                    config.ciphers = jumpCiphersPtr
+                                                    config.hostkeys = jumpHostKeysPtr
+                                                    config.macs = jumpMacsPtr
+                                                    config.timeout_seconds = 10
+                                                    config.expected_fingerprint = fpPtr
+                                                    config.auth_method = jumpAuthMethod
+                                                    config.password = pwPtr
+                                                    config.private_key = pkPtr
+                                                    config.certificate = certPtr
+                                                    config.key_passphrase = ppPtr
+                                                    return prossh_jump_session_open(
+                                                        &config,
+                                                        &status,
+                                                        &errorBuffer,
+                                                        errorBuffer.count
+                                                    )
                                                 }
                                             }
                                         }
@@ -155,29 +180,431 @@ struct LibSSHJumpCallParams: Sendable {
 
 actor LibSSHTransport: SSHTransporting {
     private var handles: [UUID: OpaquePointer] = [:]
+    /// Shared-I/O-loop readiness per session, fanned out to shell and forward readers.
+    private var readinessSignals: [UUID: LibSSHReadinessSignal] = [:]
+    /// Blocking libssh calls running off the actor, per handle. The handle is only
+    /// destroyed once its count drains.
+    private var offActorCallCounts: [OpaquePointer: Int] = [:]
+    private var offActorDrainWaiters: [OpaquePointer: [CheckedContinuation<Void, Never>]] = [:]
     private let credentialResolver: any SSHCredentialResolving
+    /// Outstanding SFTP read requests per download (OpenSSH `sftp -R`).
+    private let sftpDownloadRequestsInFlight: Int32
+    /// Files at least this large are fetched as `sftpDownloadRangeCount`
+    /// concurrent byte ranges over the session's SFTP channel.
+    private let sftpRangeSplitThreshold: Int64
+    private let sftpDownloadRangeCount: Int
+    /// When set, a session to an already-connected `user@host:port` (same jump
+    /// route) is multiplexed over the existing authenticated connection.
+    private let sharesConnections: Bool
+    /// Bounds concurrent handshakes (connect + auth) when many sessions launch
+    /// at once, e.g. a restored layout or a broadcast group.
+    private let handshakePool: SSHHandshakePool
+    private var connectionShares: [UUID: ConnectionShare] = [:]
+    /// Bastion connections shared by every session behind them, keyed by
+    /// `SSHConnectionShareKey.jumpRoute`. Each target rides its own direct-tcpip
+    /// channel, so only the first session behind a bastion pays its handshake.
+    private var jumpSessions: [String: UncheckedOpaquePointer] = [:]
+    private var jumpSessionOpens: [String: Task<UncheckedOpaquePointer, Error>] = [:]
+    private var jumpRouteBySession: [UUID: String] = [:]
+    /// `.auto` compression is enabled for a route whose last measured inbound
+    /// rate was below this. Measurements live for the app's lifetime only.
+    private let compressionAutoThreshold: Int64
+    /// Orders the modern cipher and MAC preference by measured local crypto
+    /// throughput, so bulk SFTP gets AES-GCM where the CPU accelerates it.
+    private let ordersCiphersByThroughput: Bool
+    private var linkRates: [SSHConnectionShareKey: Int64] = [:]
+    /// Connections opened by `prewarm` that no session has taken yet, and
+    /// the warm-ups still handshaking. `connect` adopts a matching one.
+    private var warmConnections: [SSHConnectionShareKey: WarmConnection] = [:]
+    private var warmingTasks: [SSHConnectionShareKey: Task<Void, Never>] = [:]
+    private var warmReaper: Task<Void, Never>?
+    /// When set, SFTP transfers of at least `bulkTransferThreshold` bytes run
+    /// on a second connection per session, marked for bulk service, so they
+    /// do not queue keystrokes behind file data in one TCP stream and one
+    /// libssh session. The shell's connection is marked for low latency.
+    private let separatesBulkTransfers: Bool
+    private let bulkTransferThreshold: Int64
+    /// What a session's bulk connection is opened with: its host, jump route
+    /// and the credentials its own authentication used.
+    private var bulkRoutes: [UUID: BulkRoute] = [:]
+    private var bulkHandles: [UUID: OpaquePointer] = [:]
+    private var bulkOpens: [UUID: Task<Void, Never>] = [:]
+    /// Sessions whose bulk connection could not be opened; their transfers
+    /// stay on the session's own connection.
+    private var bulkUnavailable: Set<UUID> = []
+
+    private struct ConnectionShare {
+        let key: SSHConnectionShareKey
+        let details: SSHConnectionDetails
+        /// Authenticated itself, or attached to a connection that already was.
+        var isAuthenticated: Bool
+    }
+
+    private struct WarmConnection {
+        /// Adopted only by a connect that would open the same connection, so
+        /// an edit made after the warm-up (key, algorithms) is never bypassed.
+        let host: Host
+        let handle: OpaquePointer
+        let details: SSHConnectionDetails
+        let isAuthenticated: Bool
+        let expiry: ContinuousClock.Instant
+    }
+
+    private struct BulkRoute {
+        let host: Host
+        let jumpHostConfig: JumpHostConfig?
+        /// The material that authenticated the session, or nil to resolve it
+        /// again without overrides (shared and pre-warmed connections).
+        var material: LibSSHAuthenticationMaterial?
+    }
 
-    init(credentialResolver: any SSHCredentialResolving = DefaultSSHCredentialResolver()) {
+    /// Unauthenticated warm connections are dropped well inside sshd's
+    /// default 120 s LoginGraceTime; authenticated ones idle a little longer.
+    static let warmHandshakeLifetime: Duration = .seconds(60)
+    static let warmAuthenticatedLifetime: Duration = .seconds(120)
+
+    init(
+        credentialResolver: any SSHCredentialResolving = DefaultSSHCredentialResolver(),
+        sftpDownloadRequestsInFlight: Int32 = 64,
+        sftpRangeSplitThreshold: Int64 = 64 << 20,
+        sftpDownloadRangeCount: Int = 4,
+        sharesConnections: Bool = true,
+        maxConcurrentHandshakes: Int = 8,
+        compressionAutoThreshold: Int64 = 2 << 20,
+        ordersCiphersByThroughput: Bool = true,
+        separatesBulkTransfers: Bool = false,
+        bulkTransferThreshold: Int64 = 8 << 20
+    ) {
         self.credentialResolver = credentialResolver
+        self.sftpDownloadRequestsInFlight = sftpDownloadRequestsInFlight
+        self.sftpRangeSplitThreshold = sftpRangeSplitThreshold
+        self.sftpDownloadRangeCount = max(1, sftpDownloadRangeCount)
+        self.sharesConnections = sharesConnections
+        self.handshakePool = SSHHandshakePool(limit: maxConcurrentHandshakes)
+        self.compressionAutoThreshold = compressionAutoThreshold
+        self.ordersCiphersByThroughput = ordersCiphersByThroughput
+        self.separatesBulkTransfers = separatesBulkTransfers
+        self.bulkTransferThreshold = bulkTransferThreshold
+    }
+
+    /// Transfers share their session's transport, and SSH negotiates ciphers
+    /// per connection, so the throughput order applies to every modern connect.
+    /// Shell traffic is too small for the choice to matter to it.
+    nonisolated private var modernPolicy: SSHAlgorithmPolicy {
+        ordersCiphersByThroughput
+            ? SSHAlgorithmPolicy.modern.orderedByThroughput(SSHCipherBenchmark.throughput)
+            : .modern
     }
 
     func connect(sessionID: UUID, to host: Host, jumpHostConfig: JumpHostConfig?) async throws -> SSHConnectionDetails {
         if let existing = handles.removeValue(forKey: sessionID) {
-            prossh_libssh_destroy(existing)
+            await destroy(handle: existing, for: sessionID)
+        }
+
+        let key = SSHConnectionShareKey(host: host, jumpHostConfig: jumpHostConfig)
+        if sharesConnections, let details = attachToSharedConnection(sessionID: sessionID, key: key) {
+            return details
         }
 
-        if let jumpConfig = jumpHostConfig {
-            return try connectViaJumpHost(sessionID: sessionID, host: host, jumpConfig: jumpConfig)
+        let result: LibSSHConnectResult
+        var isAuthenticated = false
+        if let warm = await takeWarmConnection(key: key, host: host) {
+            result = LibSSHConnectResult(handle: warm.handle, details: warm.details)
+            isAuthenticated = warm.isAuthenticated
+        } else {
+            result = try await openConnection(host: host, jumpHostConfig: jumpHostConfig, key: key)
         }
 
-        return try connectDirect(sessionID: sessionID, host: host)
+        if let superseded = handles.removeValue(forKey: sessionID) {
+            await destroy(handle: superseded, for: sessionID)
+        }
+        install(handle: result.handle, for: sessionID)
+        connectionShares[sessionID] = ConnectionShare(key: key, details: result.details, isAuthenticated: isAuthenticated)
+        jumpRouteBySession[sessionID] = key.jumpRoute
+        if separatesBulkTransfers {
+            _ = prossh_libssh_set_traffic_class(result.handle, PROSSH_TRAFFIC_INTERACTIVE)
+            // Keyboard-interactive answers (one-time codes) cannot be replayed.
+            if host.authMethod.libsshAuthMethod != PROSSH_AUTH_KEYBOARD_INTERACTIVE {
+                bulkRoutes[sessionID] = BulkRoute(host: host, jumpHostConfig: jumpHostConfig)
+            }
+        }
+        return result.details
+    }
+
+    private func openConnection(host: Host, jumpHostConfig: JumpHostConfig?, key: SSHConnectionShareKey) async throws -> LibSSHConnectResult {
+        // libssh cannot renegotiate compression mid-session, so `.auto` is
+        // decided here from what earlier sessions on this route measured.
+        let compression = SSHAlgorithmPolicy.compressionAlgorithms(
+            enabled: host.compression.shouldCompress(
+                measuredBytesPerSecond: linkRates[key],
+                threshold: compressionAutoThreshold
+            )
+        )
+
+        // The handshake blocks for a full round-trip sequence; run it off the
+        // actor so concurrent session launches overlap instead of queueing.
+        if let jumpConfig = jumpHostConfig, let route = key.jumpRoute {
+            return try await connectViaJumpHost(host: host, jumpConfig: jumpConfig, route: route, compression: compression)
+        }
+        return try await handshakePool.run { [self] in
+            try connectDirect(host: host, compression: compression)
+        }
     }
 
-    private func connectDirect(sessionID: UUID, host: Host) throws -> SSHConnectionDetails {
+    // MARK: - Pre-warming
+
+    func prewarm(host: Host, jumpHostConfig: JumpHostConfig?, trustedFingerprint: String?) async -> Bool {
+        let key = SSHConnectionShareKey(host: host, jumpHostConfig: jumpHostConfig)
+        if let pending = warmingTasks[key] {
+            await pending.value
+            return warmConnections[key] != nil
+        }
+        if sharesConnections, connectionShares.values.contains(where: { $0.key == key && $0.isAuthenticated }) {
+            return true
+        }
+        if let warm = warmConnections[key] {
+            if warm.host.opensSameConnection(as: host), prossh_libssh_is_connected(warm.handle) != 0 {
+                return true
+            }
+            warmConnections.removeValue(forKey: key)
+            discard(warm)
+        }
+
+        let task = Task {
+            await warmUp(host: host, jumpHostConfig: jumpHostConfig, key: key, trustedFingerprint: trustedFingerprint)
+        }
+        warmingTasks[key] = task
+        await task.value
+        return warmConnections[key] != nil
+    }
+
+    /// Connects through KEX, then authenticates too when the presented host
+    /// key is the one the caller already trusts and the key material needs
+    /// no prompt. Failures are dropped; the real connect reports its own.
+    private func warmUp(host: Host, jumpHostConfig: JumpHostConfig?, key: SSHConnectionShareKey, trustedFingerprint: String?) async {
+        defer { warmingTasks.removeValue(forKey: key) }
+        guard let result = try? await openConnection(host: host, jumpHostConfig: jumpHostConfig, key: key) else {
+            return
+        }
+
+        var isAuthenticated = false
+        let presented = result.details.negotiatedHostFingerprint.trimmingCharacters(in: .whitespacesAndNewlines)
+        if let trustedFingerprint, !presented.isEmpty, presented == trustedFingerprint,
+           host.authMethod.authenticatesWithKey {
+            do {
+                try await authenticate(handle: result.handle, to: host, passwordOverride: nil, keyPassphraseOverride: nil)
+                isAuthenticated = true
+            } catch {
+                // A failed attempt may count against MaxAuthTries; the session
+                // starts over on a fresh connection instead.
+                prossh_libssh_disconnect(result.handle)
+                prossh_libssh_destroy(result.handle)
+                return
+            }
+        }
+
+        let lifetime = isAuthenticated ? Self.warmAuthenticatedLifetime : Self.warmHandshakeLifetime
+        if let replaced = warmConnections.removeValue(forKey: key) {
+            discard(replaced)
+        }
+        warmConnections[key] = WarmConnection(
+            host: host,
+            handle: result.handle,
+            details: result.details,
+            isAuthenticated: isAuthenticated,
+            expiry: .now + lifetime
+        )
+        scheduleWarmReaper()
+    }
+
+    /// Hands a live, unexpired warm connection for `host` to `connect`,
+    /// waiting for one still handshaking so a click during the warm-up
+    /// continues from wherever it got to.
+    private func takeWarmConnection(key: SSHConnectionShareKey, host: Host) async -> WarmConnection? {
+        if let pending = warmingTasks[key] {
+            await pending.value
+        }
+        guard let warm = warmConnections.removeValue(forKey: key) else {
+            return nil
+        }
+        guard warm.host.opensSameConnection(as: host), warm.expiry > .now, prossh_libssh_is_connected(warm.handle) != 0 else {
+            discard(warm)
+            return nil
+        }
+        return warm
+    }
+
+    private func scheduleWarmReaper() {
+        guard warmReaper == nil, let next = warmConnections.values.map(\.expiry).min() else {
+            return
+        }
+        warmReaper = Task {
+            try? await Task.sleep(until: next, clock: .continuous)
+            reapWarmConnections()
+        }
+    }
+
+    private func reapWarmConnections() {
+        warmReaper = nil
+        let now = ContinuousClock.now
+        for (key, warm) in warmConnections where warm.expiry <= now || prossh_libssh_is_connected(warm.handle) == 0 {
+            warmConnections.removeValue(forKey: key)
+            discard(warm)
+        }
+        scheduleWarmReaper()
+    }
+
+    /// Warm handles never take off-actor calls once stored, so they can be
+    /// torn down directly.
+    private func discard(_ warm: WarmConnection) {
+        prossh_libssh_disconnect(warm.handle)
+        prossh_libssh_destroy(warm.handle)
+    }
+
+    // MARK: - Bulk Transfer Connections
+
+    /// The handle a transfer of `size` bytes runs on: the session's bulk
+    /// connection, opened on first use, or the session's own when transfers
+    /// are not separated, the file is small, or the bulk connection failed.
+    private func transferHandle(for sessionID: UUID, size: Int64) async -> OpaquePointer? {
+        guard separatesBulkTransfers, size >= bulkTransferThreshold,
+              bulkRoutes[sessionID] != nil, !bulkUnavailable.contains(sessionID) else {
+            return handles[sessionID]
+        }
+        if let bulk = bulkHandles[sessionID] {
+            if prossh_libssh_is_connected(bulk) != 0 {
+                return bulk
+            }
+            bulkHandles.removeValue(forKey: sessionID)
+            await close(bulk)
+        }
+        if bulkOpens[sessionID] == nil {
+            bulkOpens[sessionID] = Task { await openBulkConnection(for: sessionID) }
+        }
+        await bulkOpens[sessionID]?.value
+        return bulkHandles[sessionID] ?? handles[sessionID]
+    }
+
+    /// Opens a fresh (never shared) connection along the session's route and
+    /// authenticates it the way the session was. The server must present the
+    /// host key the session already verified.
+    private func openBulkConnection(for sessionID: UUID) async {
+        defer { bulkOpens.removeValue(forKey: sessionID) }
+        guard let route = bulkRoutes[sessionID],
+              let verified = connectionShares[sessionID]?.details.negotiatedHostFingerprint else { return }
+
+        let key = SSHConnectionShareKey(host: route.host, jumpHostConfig: route.jumpHostConfig)
+        var opened: OpaquePointer?
         do {
-            let modern = try connectWithPolicy(host: host, policy: .modern, marksLegacy: false)
-            handles[sessionID] = modern.handle
-            return modern.details
+            let result = try await openConnection(host: route.host, jumpHostConfig: route.jumpHostConfig, key: key)
+            opened = result.handle
+            guard result.details.negotiatedHostFingerprint == verified else {
+                throw SSHTransportError.transportFailure(message: "Bulk connection presented a different host key.")
+            }
+            let material = try route.material ?? resolveAuthenticationMaterial(for: route.host, passwordOverride: nil)
+            try await authenticate(handle: result.handle, authMethod: route.host.authMethod.libsshAuthMethod, material: material)
+        } catch {
+            bulkUnavailable.insert(sessionID)
+            if let opened {
+                await close(opened)
+            }
+            return
+        }
+
+        guard let handle = opened else { return }
+        // The session may have disconnected while this handshake ran.
+        guard handles[sessionID] != nil else {
+            await close(handle)
+            return
+        }
+        _ = prossh_libssh_set_traffic_class(handle, PROSSH_TRAFFIC_BULK)
+        bulkHandles[sessionID] = handle
+    }
+
+    private func connectViaJumpHost(
+        host: Host,
+        jumpConfig: JumpHostConfig,
+        route: String,
+        compression: String
+    ) async throws -> LibSSHConnectResult {
+        let jump = try await jumpSession(for: jumpConfig, route: route)
+        do {
+            return try await tunnel(host: host, through: jump, jumpHostname: jumpConfig.host.hostname, compression: compression)
+        } catch {
+            // The cached bastion may have dropped since it was opened; retry once
+            // on a fresh one. Errors from a live bastion are the target's own.
+            guard prossh_jump_session_is_alive(jump.raw) == 0 else { throw error }
+            dropJumpSession(route: route)
+            let fresh = try await jumpSession(for: jumpConfig, route: route)
+            return try await tunnel(host: host, through: fresh, jumpHostname: jumpConfig.host.hostname, compression: compression)
+        }
+    }
+
+    private func tunnel(
+        host: Host,
+        through jump: UncheckedOpaquePointer,
+        jumpHostname: String,
+        compression: String
+    ) async throws -> LibSSHConnectResult {
+        // Keep the bastion alive while the off-actor connect uses it, even if its
+        // last session disconnects meanwhile.
+        prossh_jump_session_retain(jump.raw)
+        defer { prossh_jump_session_release(jump.raw) }
+        return try await handshakePool.run { [self] in
+            try connectThroughJump(host: host, jump: jump, jumpHostname: jumpHostname, compression: compression)
+        }
+    }
+
+    /// Returns the live bastion for `route`, opening it once even when many
+    /// sessions behind it launch together.
+    private func jumpSession(for jumpConfig: JumpHostConfig, route: String) async throws -> UncheckedOpaquePointer {
+        if let cached = jumpSessions[route] {
+            if prossh_jump_session_is_alive(cached.raw) != 0 {
+                return cached
+            }
+            dropJumpSession(route: route)
+        }
+        if let pending = jumpSessionOpens[route] {
+            return try await pending.value
+        }
+
+        let open = Task { [handshakePool] in
+            try await handshakePool.run { [self] in
+                try openJumpSession(jumpConfig: jumpConfig)
+            }
+        }
+        jumpSessionOpens[route] = open
+        defer { jumpSessionOpens.removeValue(forKey: route) }
+        let jump = try await open.value
+        jumpSessions[route] = jump
+        return jump
+    }
+
+    private func dropJumpSession(route: String) {
+        if let jump = jumpSessions.removeValue(forKey: route) {
+            prossh_jump_session_release(jump.raw)
+        }
+    }
+
+    /// Opens `sessionID` as another handle on a live, authenticated connection
+    /// with the same key. Returns nil when there is none (or it just dropped).
+    private func attachToSharedConnection(sessionID: UUID, key: SSHConnectionShareKey) -> SSHConnectionDetails? {
+        for (ownerID, share) in connectionShares where share.key == key && share.isAuthenticated {
+            guard let ownerHandle = handles[ownerID],
+                  let handle = prossh_libssh_create_shared(ownerHandle) else {
+                continue
+            }
+            install(handle: handle, for: sessionID)
+            connectionShares[sessionID] = share
+            bulkRoutes[sessionID] = bulkRoutes[ownerID]
+            return share.details
+        }
+        return nil
+    }
+
+    nonisolated private func connectDirect(host: Host, compression: String) throws -> LibSSHConnectResult {
+        do {
+            return try connectWithPolicy(host: host, policy: modernPolicy, marksLegacy: false, compression: compression)
         } catch let modernError as LibSSHConnectFailure {
             // If the error is a network-level failure (no route, timeout, refused, DNS),
             // skip legacy probing — no algorithm set will help with a network issue.
@@ -187,15 +614,13 @@ actor LibSSHTransport: SSHTransporting {
 
             if host.legacyModeEnabled {
                 do {
-                    let legacy = try connectWithPolicy(host: host, policy: .legacy, marksLegacy: true)
-                    handles[sessionID] = legacy.handle
-                    return legacy.details
+                    return try connectWithPolicy(host: host, policy: .legacy, marksLegacy: true, compression: compression)
                 } catch let legacyError as LibSSHConnectFailure {
                     throw mapLibSSHFailure(legacyError)
                 }
             }
 
-            if let probe = try? connectWithPolicy(host: host, policy: .legacy, marksLegacy: true) {
+            if let probe = try? connectWithPolicy(host: host, policy: .legacy, marksLegacy: true, compression: compression) {
                 prossh_libssh_destroy(probe.handle)
                 throw SSHTransportError.legacyAlgorithmsRequired(host: host.label, required: [.keyExchange, .cipher, .hostKey])
             }
@@ -204,9 +629,14 @@ actor LibSSHTransport: SSHTransporting {
         }
     }
 
+    private func install(handle: OpaquePointer, for sessionID: UUID) {
+        handles[sessionID] = handle
+        readinessSignals[sessionID] = LibSSHReadinessSignal.register(handle: handle)
+    }
+
     /// Returns true if the connection failure is a network-level error where retrying
     /// with different algorithms would not help (e.g., host unreachable, DNS failure, timeout).
-    private func isNetworkLevelError(_ failure: LibSSHConnectFailure) -> Bool {
+    nonisolated private func isNetworkLevelError(_ failure: LibSSHConnectFailure) -> Bool {
         switch failure {
         case let .failed(_, message):
             let lower = message.lowercased()
@@ -222,38 +652,26 @@ actor LibSSHTransport: SSHTransporting {
         }
     }
 
-    private func connectViaJumpHost(sessionID: UUID, host: Host, jumpConfig: JumpHostConfig) throws -> SSHConnectionDetails {
-        guard let handle = prossh_libssh_create() else {
-            throw SSHTransportError.transportFailure(message: "Failed to allocate libssh session handle.")
-        }
-
+    /// Opens the bastion for `jumpConfig`; runs off the actor. Each target behind
+    /// it then needs only its own channel open, KEX and auth.
+    nonisolated private func openJumpSession(jumpConfig: JumpHostConfig) throws -> UncheckedOpaquePointer {
         let jumpHost = jumpConfig.host
         let jumpMaterial = try resolveAuthenticationMaterial(for: jumpHost, passwordOverride: nil)
-        let jumpPolicy: SSHAlgorithmPolicy = jumpHost.legacyModeEnabled ? .legacy : .modern
-        let targetPolicy: SSHAlgorithmPolicy = host.legacyModeEnabled ? .legacy : .modern
-
+        let jumpPolicy: SSHAlgorithmPolicy = jumpHost.legacyModeEnabled ? .legacy : modernPolicy
         let jumpParams = LibSSHJumpCallParams(
             jumpHost: jumpHost,
             policy: jumpPolicy,
             material: jumpMaterial,
             expectedFingerprint: jumpConfig.expectedFingerprint
         )
-        let targetParams = LibSSHTargetParams(host: host, policy: targetPolicy)
 
         var errorBuffer = [CChar](repeating: 0, count: 512)
         var jumpCConfig = ProSSHJumpHostConfig()
-        let connectResult = jumpParams.invoke(
-            handle: handle,
-            target: targetParams,
-            config: &jumpCConfig,
-            errorBuffer: &errorBuffer
-        )
-
-        if connectResult != 0 {
+        var status: Int32 = 0
+        guard let jump = jumpParams.openSession(config: &jumpCConfig, status: &status, errorBuffer: &errorBuffer) else {
             let errorMessage = errorBuffer.asString
             let actualFP = Self.extractCTupleString(&jumpCConfig.actual_fingerprint, capacity: 256)
-            prossh_libssh_destroy(handle)
-            switch connectResult {
+            switch status {
             case -10, -11:
                 throw SSHTransportError.jumpHostVerificationFailed(
                     jumpHostname: jumpHost.hostname,
@@ -268,64 +686,138 @@ actor LibSSHTransport: SSHTransporting {
                 )
             }
         }
+        return UncheckedOpaquePointer(raw: jump)
+    }
 
-        handles[sessionID] = handle
+    nonisolated private func connectThroughJump(
+        host: Host,
+        jump: UncheckedOpaquePointer,
+        jumpHostname: String,
+        compression: String
+    ) throws -> LibSSHConnectResult {
+        guard let handle = prossh_libssh_create() else {
+            throw SSHTransportError.transportFailure(message: "Failed to allocate libssh session handle.")
+        }
+
+        let targetPolicy: SSHAlgorithmPolicy = host.legacyModeEnabled ? .legacy : modernPolicy
+        let target = LibSSHTargetParams(host: host, policy: targetPolicy)
+        var errorBuffer = [CChar](repeating: 0, count: 512)
+        let connectResult = target.hostname.withCString { hostnamePtr in
+            target.username.withCString { usernamePtr in
+                target.kex.withCString { kexPtr in
+                    target.ciphers.withCString { ciphersPtr in
+                        target.hostKeys.withCString { hostKeysPtr in
+                            target.macs.withCString { macsPtr in
+                                compression.withCString { compressionPtr in
+                                    prossh_libssh_connect_through_jump(
+                                        handle,
+                                        hostnamePtr,
+                                        target.port,
+                                        usernamePtr,
+                                        kexPtr,
+                                        ciphersPtr,
+                                        hostKeysPtr,
+                                        macsPtr,
+                                        compressionPtr,
+                                        10,
+                                        jump.raw,
+                                        &errorBuffer,
+                                        errorBuffer.count
+                                    )
+                                }
+                            }
+                        }
+                    }
+                }
+            }
+        }
+
+        if connectResult != 0 {
+            let errorMessage = errorBuffer.asString
+            prossh_libssh_destroy(handle)
+            throw SSHTransportError.jumpHostConnectionFailed(
+                jumpHostname: jumpHostname,
+                message: errorMessage.isEmpty ? "Connection via jump host failed." : errorMessage
+            )
+        }
 
         var kexBuffer = [CChar](repeating: 0, count: 128)
         var cipherBuffer = [CChar](repeating: 0, count: 128)
+        var macBuffer = [CChar](repeating: 0, count: 128)
         var hostKeyBuffer = [CChar](repeating: 0, count: 128)
         var fingerprintBuffer = [CChar](repeating: 0, count: 256)
         _ = prossh_libssh_get_negotiated(
             handle,
             &kexBuffer, kexBuffer.count,
             &cipherBuffer, cipherBuffer.count,
+            &macBuffer, macBuffer.count,
             &hostKeyBuffer, hostKeyBuffer.count,
             &fingerprintBuffer, fingerprintBuffer.count
         )
 
         let usedLegacy = host.legacyModeEnabled
-        return SSHConnectionDetails(
+        let details = SSHConnectionDetails(
             negotiatedKEX: kexBuffer.asString,
             negotiatedCipher: cipherBuffer.asString,
+            negotiatedMAC: macBuffer.asString,
             negotiatedHostKeyType: hostKeyBuffer.asString,
             negotiatedHostFingerprint: fingerprintBuffer.asString,
             usedLegacyAlgorithms: usedLegacy,
             securityAdvisory: usedLegacy ? "This session uses legacy cryptography for compatibility with older infrastructure." : nil,
             backend: .libssh
         )
+        return LibSSHConnectResult(handle: handle, details: details)
     }
 
     func authenticate(sessionID: UUID, to host: Host, passwordOverride: String?, keyPassphraseOverride: String?) async throws {
         guard let handle = handles[sessionID] else {
             throw SSHTransportError.sessionNotFound
         }
+        if connectionShares[sessionID]?.isAuthenticated == true {
+            return
+        }
+        let material = try await authenticate(handle: handle, to: host, passwordOverride: passwordOverride, keyPassphraseOverride: keyPassphraseOverride)
+        connectionShares[sessionID]?.isAuthenticated = true
+        bulkRoutes[sessionID]?.material = material
+    }
 
+    @discardableResult
+    private func authenticate(handle: OpaquePointer, to host: Host, passwordOverride: String?, keyPassphraseOverride: String?) async throws -> LibSSHAuthenticationMaterial {
         let material = try resolveAuthenticationMaterial(for: host, passwordOverride: passwordOverride, keyPassphraseOverride: keyPassphraseOverride)
-        var errorBuffer = [CChar](repeating: 0, count: 512)
-        let authResult = Self.withOptionalCString(material.password) { passwordPtr in
-            Self.withOptionalCString(material.privateKey) { privateKeyPtr in
-                Self.withOptionalCString(material.certificate) { certificatePtr in
-                    Self.withOptionalCString(material.keyPassphrase) { keyPassphrasePtr in
-                        prossh_libssh_authenticate(
-                            handle,
-                            host.authMethod.libsshAuthMethod,
-                            passwordPtr,
-                            privateKeyPtr,
-                            certificatePtr,
-                            keyPassphrasePtr,
-                            &errorBuffer,
-                            errorBuffer.count
-                        )
+        try await authenticate(handle: handle, authMethod: host.authMethod.libsshAuthMethod, material: material)
+        return material
+    }
+
+    private func authenticate(handle: OpaquePointer, authMethod: ProSSHAuthMethod, material: LibSSHAuthenticationMaterial) async throws {
+        await handshakePool.acquire()
+        let (authResult, message) = await runOffActor(handle: handle) { handle in
+            var errorBuffer = [CChar](repeating: 0, count: 512)
+            let result = Self.withOptionalCString(material.password) { passwordPtr in
+                Self.withOptionalCString(material.privateKey) { privateKeyPtr in
+                    Self.withOptionalCString(material.certificate) { certificatePtr in
+                        Self.withOptionalCString(material.keyPassphrase) { keyPassphrasePtr in
+                            prossh_libssh_authenticate(
+                                handle,
+                                authMethod,
+                                passwordPtr,
+                                privateKeyPtr,
+                                certificatePtr,
+                                keyPassphrasePtr,
+                                &errorBuffer,
+                                errorBuffer.count
+                            )
+                        }
                     }
                 }
             }
+            return (result, errorBuffer.asString)
         }
+        handshakePool.release()
 
         if authResult != 0 {
             if authResult == -3 {
                 throw SSHTransportError.authenticationFailed
             }
-            let message = errorBuffer.asString
             throw SSHTransportError.transportFailure(message: message.isEmpty ? "SSH authentication failed." : message)
         }
     }
@@ -337,38 +829,103 @@ actor LibSSHTransport: SSHTransporting {
 
         return try await LibSSHShellChannel.create(
             handle: UncheckedOpaquePointer(raw: handle),
+            readiness: readinessSignals[sessionID],
             pty: pty,
             enableAgentForwarding: enableAgentForwarding
         )
     }
 
+    /// Collects the paged walk into one sorted listing. Callers that render
+    /// incrementally use `walkDirectory(sessionID:path:recursive: false)` directly.
     func listDirectory(sessionID: UUID, path: String) async throws -> [SFTPDirectoryEntry] {
+        var entries: [SFTPDirectoryEntry] = []
+        for try await page in try await walkDirectory(sessionID: sessionID, path: path, recursive: false) {
+            entries.append(contentsOf: page)
+        }
+        return entries.sorted(by: SFTPDirectoryEntry.listingOrder)
+    }
+
+    func walkDirectory(sessionID: UUID, path: String, recursive: Bool) async throws -> AsyncThrowingStream<[SFTPDirectoryEntry], Error> {
+        guard let handle = handles[sessionID] else {
+            throw SSHTransportError.sessionNotFound
+        }
+
+        let rootPath = RemotePath.normalize(path)
+        let (stream, continuation) = AsyncThrowingStream<[SFTPDirectoryEntry], Error>.makeStream()
+        let context = LibSSHWalkContext(continuation: continuation)
+        continuation.onTermination = { _ in context.cancel() }
+
+        Task {
+            let (result, message) = await runOffActor(handle: handle) { handle in
+                var errorBuffer = [CChar](repeating: 0, count: 512)
+                let opaqueContext = Unmanaged.passUnretained(context).toOpaque()
+                let result = rootPath.withCString { rootPtr in
+                    prossh_libssh_sftp_walk(handle, rootPtr, recursive, { entries, count, opaque in
+                        guard let opaque else { return 1 }
+                        let context = Unmanaged<LibSSHWalkContext>.fromOpaque(opaque).takeUnretainedValue()
+                        return context.deliver(UnsafeBufferPointer(start: entries, count: count)) ? 0 : 1
+                    }, opaqueContext, context.cancelFlag, &errorBuffer, errorBuffer.count)
+                }
+                // Keeps the context alive across the C call.
+                withExtendedLifetime(context) {}
+                return (result, errorBuffer.asString)
+            }
+            if result == 0 || context.isCancelled {
+                continuation.finish()
+            } else {
+                continuation.finish(throwing: SSHTransportError.transportFailure(
+                    message: message.isEmpty ? "Failed to walk remote directory." : message
+                ))
+            }
+        }
+        return stream
+    }
+
+    func createDirectory(sessionID: UUID, path: String) async throws {
         guard let handle = handles[sessionID] else {
             throw SSHTransportError.sessionNotFound
         }
 
-        var outputBuffer = [CChar](repeating: 0, count: 128 * 1024)
-        var errorBuffer = [CChar](repeating: 0, count: 512)
         let targetPath = RemotePath.normalize(path)
+        let (result, message) = await runOffActor(handle: handle) { handle in
+            var errorBuffer = [CChar](repeating: 0, count: 512)
+            let result = targetPath.withCString { pathPtr in
+                prossh_libssh_sftp_mkdir(handle, pathPtr, 0o755, &errorBuffer, errorBuffer.count)
+            }
+            return (result, errorBuffer.asString)
+        }
+        if result != 0 {
+            throw SSHTransportError.transportFailure(message: message.isEmpty ? "Failed to create remote directory." : message)
+        }
+    }
 
-        let result = targetPath.withCString { pathPtr in
-            prossh_libssh_sftp_list_directory(
-                handle,
-                pathPtr,
-                &outputBuffer,
-                outputBuffer.count,
-                &errorBuffer,
-                errorBuffer.count
-            )
+    func setModificationTime(sessionID: UUID, path: String, date: Date) async throws {
+        guard let handle = handles[sessionID] else {
+            throw SSHTransportError.sessionNotFound
         }
 
+        let targetPath = RemotePath.normalize(path)
+        let seconds = Int64(date.timeIntervalSince1970)
+        let (result, message) = await runOffActor(handle: handle) { handle in
+            var errorBuffer = [CChar](repeating: 0, count: 512)
+            let result = targetPath.withCString { pathPtr in
+                prossh_libssh_sftp_set_mtime(handle, pathPtr, seconds, &errorBuffer, errorBuffer.count)
+            }
+            return (result, errorBuffer.asString)
+        }
         if result != 0 {
-            let message = errorBuffer.asString
-            throw SSHTransportError.transportFailure(message: message.isEmpty ? "Failed to list remote directory." : message)
+            throw SSHTransportError.transportFailure(message: message.isEmpty ? "Failed to set remote modification time." : message)
         }
+    }
 
-        let listing = outputBuffer.asString
-        return Self.parseSFTPListing(listing, basePath: targetPath)
+    func modificationTime(sessionID: UUID, path: String) async throws -> Date? {
+        guard let handle = handles[sessionID] else {
+            throw SSHTransportError.sessionNotFound
+        }
+        guard let attributes = await statRemoteFile(handle: handle, path: RemotePath.normalize(path)) else {
+            throw SSHTransportError.transportFailure(message: "Failed to stat remote path.")
+        }
+        return Date(timeIntervalSince1970: TimeInterval(attributes.modified))
     }
 
     func uploadFile(sessionID: UUID, localPath: String, remotePath: String) async throws -> SFTPTransferResult {
@@ -387,7 +944,11 @@ actor LibSSHTransport: SSHTransporting {
     }
 
     func uploadFile(sessionID: UUID, localPath: String, remotePath: String, progressHandler: (@Sendable (Int64, Int64) -> Void)?) async throws -> SFTPTransferResult {
-        guard let handle = handles[sessionID] else {
+        guard handles[sessionID] != nil else {
+            throw SSHTransportError.sessionNotFound
+        }
+        let localSize = ((try? FileManager.default.attributesOfItem(atPath: localPath))?[.size] as? NSNumber)?.int64Value ?? 0
+        guard let handle = await transferHandle(for: sessionID, size: localSize) else {
             throw SSHTransportError.sessionNotFound
         }
 
@@ -415,29 +976,33 @@ actor LibSSHTransport: SSHTransporting {
             }
         }
 
-        var errorBuffer = [CChar](repeating: 0, count: 512)
         let targetPath = RemotePath.normalize(remotePath)
 
         return try await withTaskCancellationHandler {
-            let cResult = localPath.withCString { localPtr in
-                targetPath.withCString { remotePtr in
-                    prossh_libssh_sftp_upload_file(
-                        handle,
-                        localPtr,
-                        remotePtr,
-                        bytesPtr,
-                        totalPtr,
-                        cancelFlagPtr,
-                        &errorBuffer,
-                        errorBuffer.count
-                    )
+            let (cResult, message) = await runOffActor(handle: handle) { handle in
+                var errorBuffer = [CChar](repeating: 0, count: 512)
+                let traceStart = TraceRecorder.shared.begin()
+                defer { TraceRecorder.shared.end(.sftpUpload, since: traceStart, value: ptrs.bytes.pointee) }
+                let cResult = localPath.withCString { localPtr in
+                    targetPath.withCString { remotePtr in
+                        prossh_libssh_sftp_upload_file(
+                            handle,
+                            localPtr,
+                            remotePtr,
+                            ptrs.bytes,
+                            ptrs.total,
+                            cancelBox.flag,
+                            &errorBuffer,
+                            errorBuffer.count
+                        )
+                    }
                 }
+                return (cResult, errorBuffer.asString)
             }
             pollingTask?.cancel()
             progressHandler?(bytesPtr.pointee, totalPtr.pointee)
             if cancelFlagPtr.pointee != 0 { throw CancellationError() }
             if cResult != 0 {
-                let message = errorBuffer.asString
                 throw SSHTransportError.transportFailure(message: message.isEmpty ? "Failed to upload file via SFTP." : message)
             }
             return SFTPTransferResult(bytesTransferred: bytesPtr.pointee, totalBytes: totalPtr.pointee)
@@ -455,6 +1020,170 @@ actor LibSSHTransport: SSHTransporting {
             throw SSHTransportError.sessionNotFound
         }
 
+        let sourcePath = RemotePath.normalize(remotePath)
+        if let attributes = await statRemoteFile(handle: handle, path: sourcePath),
+           !attributes.isDirectory, attributes.size > 0 {
+            guard let transferHandle = await transferHandle(for: sessionID, size: attributes.size) else {
+                throw SSHTransportError.sessionNotFound
+            }
+            return try await downloadFileRanges(
+                handle: transferHandle,
+                sourcePath: sourcePath,
+                localPath: localPath,
+                attributes: attributes,
+                progressHandler: progressHandler
+            )
+        }
+        return try await downloadWholeFile(
+            handle: handle,
+            sourcePath: sourcePath,
+            localPath: localPath,
+            progressHandler: progressHandler
+        )
+    }
+
+    private struct RemoteFileAttributes: Sendable {
+        let size: Int64
+        let modified: Int64
+        let isDirectory: Bool
+    }
+
+    private func statRemoteFile(handle: OpaquePointer, path: String) async -> RemoteFileAttributes? {
+        await runOffActor(handle: handle) { handle in
+            var size: Int64 = 0
+            var modified: Int64 = 0
+            var isDirectory = false
+            var errorBuffer = [CChar](repeating: 0, count: 512)
+            let result = path.withCString { pathPtr in
+                prossh_libssh_sftp_stat(handle, pathPtr, &size, &modified, &isDirectory, &errorBuffer, errorBuffer.count)
+            }
+            guard result == 0 else { return nil }
+            return RemoteFileAttributes(size: size, modified: modified, isDirectory: isDirectory)
+        }
+    }
+
+    /// Sendable box for the per-range progress counters of a split download.
+    private struct RangeProgressPointers: @unchecked Sendable {
+        let done: UnsafeMutablePointer<Int64>
+        let count: Int
+
+        var total: Int64 {
+            (0..<count).reduce(0) { $0 + done[$1] }
+        }
+    }
+
+    /// Fetches the file as concurrent byte ranges into a preallocated local
+    /// file, resuming from `<local>.prossh-partial` when it matches the remote.
+    /// On failure the manifest keeps each range's progress for the next attempt;
+    /// on cancellation both the partial file and the manifest are removed.
+    private func downloadFileRanges(
+        handle: OpaquePointer,
+        sourcePath: String,
+        localPath: String,
+        attributes: RemoteFileAttributes,
+        progressHandler: (@Sendable (Int64, Int64) -> Void)?
+    ) async throws -> SFTPTransferResult {
+        let rangeCount = attributes.size >= sftpRangeSplitThreshold ? sftpDownloadRangeCount : 1
+        var partial = try SFTPPartialDownload.prepare(
+            localPath: localPath,
+            remoteSize: attributes.size,
+            remoteModified: attributes.modified,
+            rangeCount: rangeCount
+        )
+
+        let donePtr = UnsafeMutablePointer<Int64>.allocate(capacity: partial.ranges.count)
+        donePtr.initialize(from: partial.ranges.map(\.done), count: partial.ranges.count)
+        defer {
+            donePtr.deinitialize(count: partial.ranges.count); donePtr.deallocate()
+        }
+        let progress = RangeProgressPointers(done: donePtr, count: partial.ranges.count)
+
+        let cancelFlagPtr = UnsafeMutablePointer<Int32>.allocate(capacity: 1)
+        cancelFlagPtr.initialize(to: 0)
+        defer { cancelFlagPtr.deinitialize(count: 1); cancelFlagPtr.deallocate() }
+        let cancelBox = CancelFlagPointer(flag: cancelFlagPtr)
+
+        let totalBytes = attributes.size
+        let pollingTask: Task<Void, Never>? = progressHandler.map { handler in
+            Task.detached {
+                while !Task.isCancelled {
+                    try? await Task.sleep(nanoseconds: 250_000_000)
+                    handler(progress.total, totalBytes)
+                }
+            }
+        }
+
+        let requestsInFlight = sftpDownloadRequestsInFlight
+        let ranges = partial.ranges
+
+        return try await withTaskCancellationHandler {
+            let failures = await withTaskGroup(of: (Int32, String)?.self) { group in
+                for (index, range) in ranges.enumerated() where !range.isComplete {
+                    group.addTask {
+                        await self.runOffActor(handle: handle) { handle in
+                            var errorBuffer = [CChar](repeating: 0, count: 512)
+                            let traceStart = TraceRecorder.shared.begin()
+                            defer {
+                                TraceRecorder.shared.end(.sftpRange, since: traceStart, value: progress.done[index] - range.done)
+                            }
+                            let cResult = sourcePath.withCString { remotePtr in
+                                localPath.withCString { localPtr in
+                                    prossh_libssh_sftp_download_range(
+                                        handle,
+                                        remotePtr,
+                                        localPtr,
+                                        UInt64(range.offset),
+                                        UInt64(range.length),
+                                        requestsInFlight,
+                                        progress.done + index,
+                                        cancelBox.flag,
+                                        &errorBuffer,
+                                        errorBuffer.count
+                                    )
+                                }
+                            }
+                            return cResult == 0 ? nil : (cResult, errorBuffer.asString)
+                        }
+                    }
+                }
+                var failures: [(Int32, String)] = []
+                for await failure in group {
+                    if let failure { failures.append(failure) }
+                }
+                return failures
+            }
+            pollingTask?.cancel()
+            progressHandler?(progress.total, totalBytes)
+
+            if cancelFlagPtr.pointee != 0 {
+                SFTPPartialDownload.remove(for: localPath)
+                try? FileManager.default.removeItem(atPath: localPath)
+                throw CancellationError()
+            }
+            if let failure = failures.first {
+                for index in partial.ranges.indices {
+                    partial.ranges[index].done = progress.done[index]
+                }
+                try? partial.save(for: localPath)
+                let message = failure.1
+                throw SSHTransportError.transportFailure(message: message.isEmpty ? "Failed to download file via SFTP." : message)
+            }
+
+            SFTPPartialDownload.remove(for: localPath)
+            return SFTPTransferResult(bytesTransferred: progress.total, totalBytes: totalBytes)
+        } onCancel: {
+            cancelBox.flag.pointee = 1
+        }
+    }
+
+    /// Single-stream download for files whose size is unknown or zero; these
+    /// cannot be range-split or resumed.
+    private func downloadWholeFile(
+        handle: OpaquePointer,
+        sourcePath: String,
+        localPath: String,
+        progressHandler: (@Sendable (Int64, Int64) -> Void)?
+    ) async throws -> SFTPTransferResult {
         let bytesPtr = UnsafeMutablePointer<Int64>.allocate(capacity: 1)
         let totalPtr = UnsafeMutablePointer<Int64>.allocate(capacity: 1)
         bytesPtr.initialize(to: 0)
@@ -479,29 +1208,34 @@ actor LibSSHTransport: SSHTransporting {
             }
         }
 
-        var errorBuffer = [CChar](repeating: 0, count: 512)
-        let sourcePath = RemotePath.normalize(remotePath)
+        let requestsInFlight = sftpDownloadRequestsInFlight
 
         return try await withTaskCancellationHandler {
-            let cResult = sourcePath.withCString { remotePtr in
-                localPath.withCString { localPtr in
-                    prossh_libssh_sftp_download_file(
-                        handle,
-                        remotePtr,
-                        localPtr,
-                        bytesPtr,
-                        totalPtr,
-                        cancelFlagPtr,
-                        &errorBuffer,
-                        errorBuffer.count
-                    )
+            let (cResult, message) = await runOffActor(handle: handle) { handle in
+                var errorBuffer = [CChar](repeating: 0, count: 512)
+                let traceStart = TraceRecorder.shared.begin()
+                defer { TraceRecorder.shared.end(.sftpDownload, since: traceStart, value: ptrs.bytes.pointee) }
+                let cResult = sourcePath.withCString { remotePtr in
+                    localPath.withCString { localPtr in
+                        prossh_libssh_sftp_download_file(
+                            handle,
+                            remotePtr,
+                            localPtr,
+                            requestsInFlight,
+                            ptrs.bytes,
+                            ptrs.total,
+                            cancelBox.flag,
+                            &errorBuffer,
+                            errorBuffer.count
+                        )
+                    }
                 }
+                return (cResult, errorBuffer.asString)
             }
             pollingTask?.cancel()
             progressHandler?(bytesPtr.pointee, totalPtr.pointee)
             if cancelFlagPtr.pointee != 0 { throw CancellationError() }
             if cResult != 0 {
-                let message = errorBuffer.asString
                 throw SSHTransportError.transportFailure(message: message.isEmpty ? "Failed to download file via SFTP." : message)
             }
             return SFTPTransferResult(bytesTransferred: bytesPtr.pointee, totalBytes: totalPtr.pointee)
@@ -510,6 +1244,10 @@ actor LibSSHTransport: SSHTransporting {
         }
     }
 
+    /// The open is pipelined: the request goes out at once and the server's
+    /// reply is awaited on the session's readiness signal with the actor free,
+    /// so a burst of opens (SOCKS clients, parallel page loads) shares one
+    /// round trip instead of queueing behind each other.
     func openForwardChannel(sessionID: UUID, remoteHost: String, remotePort: UInt16, sourceHost: String, sourcePort: UInt16) async throws -> any SSHForwardChannel {
         guard let handle = handles[sessionID] else {
             throw SSHTransportError.sessionNotFound
@@ -518,7 +1256,7 @@ actor LibSSHTransport: SSHTransporting {
         var errorBuffer = [CChar](repeating: 0, count: 512)
         let fwdPtr: OpaquePointer? = remoteHost.withCString { remoteHostPtr in
             sourceHost.withCString { sourceHostPtr in
-                prossh_forward_channel_open(
+                prossh_forward_channel_open_start(
                     handle,
                     remoteHostPtr,
                     remotePort,
@@ -535,24 +1273,202 @@ actor LibSSHTransport: SSHTransporting {
             throw SSHTransportError.transportFailure(message: message.isEmpty ? "Failed to open forward channel." : message)
         }
 
-        return LibSSHForwardChannel(pointer: UncheckedOpaquePointer(raw: fwdPtr))
+        let readiness = readinessSignals[sessionID]
+        while true {
+            let token = readiness?.generation ?? 0
+            let status = prossh_forward_channel_open_poll(fwdPtr, &errorBuffer, errorBuffer.count)
+            if status == 0 {
+                break
+            }
+            if status < 0 || Task.isCancelled {
+                prossh_forward_channel_close(fwdPtr)
+                let message = errorBuffer.asString
+                throw SSHTransportError.transportFailure(message: message.isEmpty ? "Failed to open forward channel." : message)
+            }
+            if let readiness {
+                await readiness.wait(after: token)
+            } else {
+                try? await Task.sleep(for: .milliseconds(10))
+            }
+        }
+
+        return LibSSHForwardChannel(
+            pointer: UncheckedOpaquePointer(raw: fwdPtr),
+            readiness: readiness
+        )
     }
 
-    func sendKeepalive(sessionID: UUID) async -> Bool {
+    /// Opened like a forward channel: the session-open and exec requests are
+    /// pipelined and their replies awaited on the readiness signal, so the
+    /// shell sharing this session keeps flowing meanwhile.
+    func runCommand(sessionID: UUID, command: String) async throws -> AsyncThrowingStream<SSHExecEvent, Error> {
         guard let handle = handles[sessionID] else {
-            return false
+            throw SSHTransportError.sessionNotFound
+        }
+
+        var errorBuffer = [CChar](repeating: 0, count: 512)
+        let execPtr = command.withCString { commandPtr in
+            prossh_exec_channel_open_start(handle, commandPtr, &errorBuffer, errorBuffer.count)
+        }
+        guard let execPtr else {
+            let message = errorBuffer.asString
+            throw SSHTransportError.transportFailure(message: message.isEmpty ? "Failed to execute remote SSH command." : message)
+        }
+
+        let readiness = readinessSignals[sessionID]
+        while true {
+            let token = readiness?.generation ?? 0
+            let status = prossh_forward_channel_open_poll(execPtr, &errorBuffer, errorBuffer.count)
+            if status == 0 {
+                break
+            }
+            if status < 0 || Task.isCancelled {
+                prossh_forward_channel_close(execPtr)
+                let message = errorBuffer.asString
+                throw SSHTransportError.transportFailure(message: message.isEmpty ? "Failed to execute remote SSH command." : message)
+            }
+            if let readiness {
+                await readiness.wait(after: token)
+            } else {
+                try? await Task.sleep(for: .milliseconds(10))
+            }
+        }
+
+        let channel = LibSSHExecChannel(pointer: UncheckedOpaquePointer(raw: execPtr), readiness: readiness)
+        return AsyncThrowingStream { continuation in
+            let task = Task {
+                do {
+                    while let event = try await channel.next() {
+                        continuation.yield(event)
+                    }
+                    continuation.finish()
+                } catch {
+                    continuation.finish(throwing: error)
+                }
+                await channel.close()
+            }
+            continuation.onTermination = { _ in
+                task.cancel()
+                Task { await channel.close() }
+            }
+        }
+    }
+
+    /// The tcpip-forward request blocks for one round trip, so it runs off the
+    /// actor. Accepting then rides the session's readiness signal.
+    func listenRemoteForward(sessionID: UUID, bindAddress: String, port: UInt16) async throws -> any SSHRemoteForwardListener {
+        guard let handle = handles[sessionID] else {
+            throw SSHTransportError.sessionNotFound
+        }
+
+        let (forwardPtr, message) = await runOffActor(handle: handle) { handle -> (UncheckedOpaquePointer?, String) in
+            var errorBuffer = [CChar](repeating: 0, count: 512)
+            let forward = bindAddress.withCString { addressPtr in
+                prossh_remote_forward_listen(handle, addressPtr, port, &errorBuffer, errorBuffer.count)
+            }
+            return (forward.map { UncheckedOpaquePointer(raw: $0) }, errorBuffer.asString)
+        }
+
+        guard let forwardPtr else {
+            throw SSHTransportError.transportFailure(message: message.isEmpty ? "Failed to start remote forward." : message)
+        }
+
+        return LibSSHRemoteForwardListener(
+            pointer: forwardPtr,
+            readiness: readinessSignals[sessionID]
+        )
+    }
+
+    /// Runs off the actor: the probe waits for the session lock, which a bulk
+    /// transfer or a stalled peer may hold, and must not hold up other sessions.
+    func sendKeepalive(sessionID: UUID, deadPeerTimeout: Int) async -> SSHKeepaliveResult {
+        guard let handle = handles[sessionID] else {
+            return .dead
+        }
+        let timeout = Int32(clamping: deadPeerTimeout)
+        let result = await runOffActor(handle: handle) { handle in
+            prossh_libssh_send_keepalive(handle, timeout)
+        }
+        switch result {
+        case 1: return .active
+        case 0: return .probed
+        default: return .dead
         }
-        let result = prossh_libssh_send_keepalive(handle)
-        return result == 0
     }
 
     func disconnect(sessionID: UUID) async {
         guard let handle = handles.removeValue(forKey: sessionID) else {
             return
         }
+        await destroy(handle: handle, for: sessionID)
+    }
+
+    private func destroy(handle: OpaquePointer, for sessionID: UUID) async {
+        readinessSignals.removeValue(forKey: sessionID)?.unregister()
+        // Other sessions on the same connection keep it open; the C side only
+        // tears down the transport with its last handle.
+        let share = connectionShares.removeValue(forKey: sessionID)
+        if let share {
+            let rate = prossh_libssh_link_rate(handle)
+            if rate > 0 {
+                linkRates[share.key] = rate
+            }
+        }
+        bulkRoutes.removeValue(forKey: sessionID)
+        bulkUnavailable.remove(sessionID)
+        if let bulk = bulkHandles.removeValue(forKey: sessionID) {
+            // Bulk transfers, when separated, measured the route here.
+            let rate = prossh_libssh_link_rate(bulk)
+            if let share, rate > 0 {
+                linkRates[share.key] = rate
+            }
+            await close(bulk)
+        }
+        if let route = jumpRouteBySession.removeValue(forKey: sessionID),
+           !jumpRouteBySession.values.contains(route) {
+            // Open tunnels hold their own references; this only drops the cache's.
+            dropJumpSession(route: route)
+        }
+        await close(handle)
+    }
+
+    private func close(_ handle: OpaquePointer) async {
+        // Disconnecting first makes in-flight SFTP calls unwind at their next
+        // request boundary; the handle itself must outlive them.
+        prossh_libssh_disconnect(handle)
+        if offActorCallCounts[handle, default: 0] > 0 {
+            await withCheckedContinuation { continuation in
+                offActorDrainWaiters[handle, default: []].append(continuation)
+            }
+        }
         prossh_libssh_destroy(handle)
     }
 
+    /// Runs a long blocking libssh call (SFTP) on a detached task so the actor stays
+    /// free for keepalives, channel opens, and other sessions meanwhile. The C
+    /// wrapper interleaves shell and forward I/O with the transfer.
+    private func runOffActor<T: Sendable>(
+        handle: OpaquePointer,
+        _ body: @escaping @Sendable (OpaquePointer) -> T
+    ) async -> T {
+        offActorCallCounts[handle, default: 0] += 1
+        let unchecked = UncheckedOpaquePointer(raw: handle)
+        let result = await Task.detached(priority: .userInitiated) {
+            body(unchecked.raw)
+        }.value
+
+        let remaining = offActorCallCounts[handle, default: 1] - 1
+        if remaining > 0 {
+            offActorCallCounts[handle] = remaining
+        } else {
+            offActorCallCounts.removeValue(forKey: handle)
+            for waiter in offActorDrainWaiters.removeValue(forKey: handle) ?? [] {
+                waiter.resume()
+            }
+        }
+        return result
+    }
+
     /// Forces the kernel to re-evaluate the route to a hostname by performing a throwaway
     /// UDP `connect()` + immediate close. This clears the kernel's negative route cache
     /// (EHOSTUNREACH memoization) that can persist within a process even after the network
@@ -592,15 +1508,41 @@ actor LibSSHTransport: SSHTransporting {
         }
     }
 
-    private func connectWithPolicy(
+    nonisolated private func connectWithPolicy(
         host: Host,
         policy: SSHAlgorithmPolicy,
-        marksLegacy: Bool
+        marksLegacy: Bool,
+        compression: String
     ) throws -> LibSSHConnectResult {
-        // Flush the kernel's negative route cache before every TCP connection attempt.
-        // This prevents stale EHOSTUNREACH from blocking reconnections.
-        flushRouteCache(hostname: host.hostname, port: host.port)
+        do {
+            return try connectOnce(host: host, policy: policy, marksLegacy: marksLegacy, compression: compression)
+        } catch let failure as LibSSHConnectFailure where isStaleRouteError(failure) {
+            // A stale negative route cache entry can keep failing reconnections
+            // with EHOSTUNREACH after the network comes back. Flush it and try
+            // once more; healthy connects no longer pay for the probe.
+            flushRouteCache(hostname: host.hostname, port: host.port)
+            return try connectOnce(host: host, policy: policy, marksLegacy: marksLegacy, compression: compression)
+        }
+    }
 
+    nonisolated private func isStaleRouteError(_ failure: LibSSHConnectFailure) -> Bool {
+        switch failure {
+        case let .failed(_, message):
+            let lower = message.lowercased()
+            return lower.contains("no route to host")
+                || lower.contains("network is unreachable")
+                || lower.contains("host is unreachable")
+        }
+    }
+
+    /// The C wrapper races all resolved addresses (RFC 8305) and caches DNS
+    /// results, so a broken IPv6 path costs one attempt delay, not the timeout.
+    nonisolated private func connectOnce(
+        host: Host,
+        policy: SSHAlgorithmPolicy,
+        marksLegacy: Bool,
+        compression: String
+    ) throws -> LibSSHConnectResult {
         guard let handle = prossh_libssh_create() else {
             throw LibSSHConnectFailure.failed(code: -100, message: "Failed to allocate libssh session handle.")
         }
@@ -618,19 +1560,22 @@ actor LibSSHTransport: SSHTransporting {
                     ciphers.withCString { ciphersPtr in
                         hostKeys.withCString { hostKeysPtr in
                             macs.withCString { macsPtr in
-                                prossh_libssh_connect(
-                                    handle,
-                                    hostnamePtr,
-                                    host.port,
-                                    usernamePtr,
-                                    kexPtr,
-                                    ciphersPtr,
-                                    hostKeysPtr,
-                                    macsPtr,
-                                    10,
-                                    &errorBuffer,
-                                    errorBuffer.count
-                                )
+                                compression.withCString { compressionPtr in
+                                    prossh_libssh_connect(
+                                        handle,
+                                        hostnamePtr,
+                                        host.port,
+                                        usernamePtr,
+                                        kexPtr,
+                                        ciphersPtr,
+                                        hostKeysPtr,
+                                        macsPtr,
+                                        compressionPtr,
+                                        10,
+                                        &errorBuffer,
+                                        errorBuffer.count
+                                    )
+                                }
                             }
                         }
                     }
@@ -646,6 +1591,7 @@ actor LibSSHTransport: SSHTransporting {
 
         var kexBuffer = [CChar](repeating: 0, count: 128)
         var cipherBuffer = [CChar](repeating: 0, count: 128)
+        var macBuffer = [CChar](repeating: 0, count: 128)
         var hostKeyBuffer = [CChar](repeating: 0, count: 128)
         var fingerprintBuffer = [CChar](repeating: 0, count: 256)
 
@@ -655,6 +1601,8 @@ actor LibSSHTransport: SSHTransporting {
             kexBuffer.count,
             &cipherBuffer,
             cipherBuffer.count,
+            &macBuffer,
+            macBuffer.count,
             &hostKeyBuffer,
             hostKeyBuffer.count,
             &fingerprintBuffer,
@@ -664,6 +1612,7 @@ actor LibSSHTransport: SSHTransporting {
         let details = SSHConnectionDetails(
             negotiatedKEX: kexBuffer.asString,
             negotiatedCipher: cipherBuffer.asString,
+            negotiatedMAC: macBuffer.asString,
             negotiatedHostKeyType: hostKeyBuffer.asString,
             negotiatedHostFingerprint: fingerprintBuffer.asString,
             usedLegacyAlgorithms: marksLegacy,
@@ -674,7 +1623,7 @@ actor LibSSHTransport: SSHTransporting {
         return LibSSHConnectResult(handle: handle, details: details)
     }
 
-    private func mapLibSSHFailure(_ failure: LibSSHConnectFailure) -> SSHTransportError {
+    nonisolated private func mapLibSSHFailure(_ failure: LibSSHConnectFailure) -> SSHTransportError {
         switch failure {
         case let .failed(code, message):
             let trimmedMessage = message.trimmingCharacters(in: .whitespacesAndNewlines)
@@ -696,7 +1645,7 @@ actor LibSSHTransport: SSHTransporting {
         }
     }
 
-    private func resolveAuthenticationMaterial(for host: Host, passwordOverride: String?, keyPassphraseOverride: String? = nil) throws -> LibSSHAuthenticationMaterial {
+    nonisolated private func resolveAuthenticationMaterial(for host: Host, passwordOverride: String?, keyPassphraseOverride: String? = nil) throws -> LibSSHAuthenticationMaterial {
         switch host.authMethod {
         case .password:
             let normalizedPassword = passwordOverride?.trimmingCharacters(in: .whitespacesAndNewlines) ?? ""
@@ -753,49 +1702,6 @@ actor LibSSHTransport: SSHTransporting {
             }
         }
     }
-
-    nonisolated private static func parseSFTPListing(_ listing: String, basePath: String) -> [SFTPDirectoryEntry] {
-        let normalizedBase = RemotePath.normalize(basePath)
-        var entries: [SFTPDirectoryEntry] = []
-
-        for line in listing.split(separator: "\n", omittingEmptySubsequences: true) {
-            let columns = line.split(separator: "\t", omittingEmptySubsequences: false)
-            guard columns.count >= 5 else {
-                continue
-            }
-
-            let name = String(columns[0])
-            let isDirectory = columns[1] == "1"
-            let size = Int64(columns[2]) ?? 0
-            let permissions = UInt32(columns[3]) ?? 0
-            let mtime = TimeInterval(columns[4]) ?? 0
-
-            let fullPath: String
-            if normalizedBase == "/" {
-                fullPath = "/\(name)"
-            } else {
-                fullPath = "\(normalizedBase)/\(name)"
-            }
-
-            entries.append(
-                SFTPDirectoryEntry(
-                    path: fullPath,
-                    name: name,
-                    isDirectory: isDirectory,
-                    size: size,
-                    permissions: permissions,
-                    modifiedAt: mtime > 0 ? Date(timeIntervalSince1970: mtime) : nil
-                )
-            )
-        }
-
-        return entries.sorted { lhs, rhs in
-            if lhs.isDirectory != rhs.isDirectory {
-                return lhs.isDirectory && !rhs.isDirectory
-            }
-            return lhs.name.localizedCaseInsensitiveCompare(rhs.name) == .orderedAscending
-        }
-    }
 }
 
 
@@ -813,6 +1719,32 @@ extension AuthMethod {
             return PROSSH_AUTH_KEYBOARD_INTERACTIVE
         }
     }
+
+    /// Public key and certificate: material the app holds, no typed secret.
+    nonisolated var authenticatesWithKey: Bool {
+        switch self {
+        case .publicKey, .certificate:
+            return true
+        case .password, .keyboardInteractive:
+            return false
+        }
+    }
+}
+
+extension Host {
+    /// Whether a connection opened for `self` is the one `other` would open:
+    /// same saved host, address, user, credentials and algorithm choices.
+    nonisolated func opensSameConnection(as other: Host) -> Bool {
+        id == other.id
+            && hostname == other.hostname
+            && port == other.port
+            && username == other.username
+            && authMethod.libsshAuthMethod == other.authMethod.libsshAuthMethod
+            && keyReference == other.keyReference
+            && certificateReference == other.certificateReference
+            && legacyModeEnabled == other.legacyModeEnabled
+            && pinnedHostKeyAlgorithms == other.pinnedHostKeyAlgorithms
+    }
 }
 
 private extension Array where Element == CChar {
@@ -209,6 +209,36 @@ actor MockSSHTransport: SSHTransporting {
         )
     }
 
+    func createDirectory(sessionID: UUID, path: String) async throws {
+        guard var session = activeSessions[sessionID], session.isAuthenticated else {
+            throw SSHTransportError.sessionNotFound
+        }
+
+        let directoryPath = RemotePath.normalize(path)
+        if let existing = session.remoteNodes[directoryPath] {
+            guard existing.isDirectory else {
+                throw SSHTransportError.transportFailure(message: "Remote path exists and is not a directory: \(directoryPath)")
+            }
+            return
+        }
+        ensureParentDirectoriesExist(for: directoryPath, in: &session.remoteNodes)
+        session.remoteNodes[directoryPath] = MockRemoteNode(isDirectory: true, data: Data(), modifiedAt: .now)
+        activeSessions[sessionID] = session
+    }
+
+    func setModificationTime(sessionID: UUID, path: String, date: Date) async throws {
+        guard var session = activeSessions[sessionID], session.isAuthenticated else {
+            throw SSHTransportError.sessionNotFound
+        }
+
+        let normalizedPath = RemotePath.normalize(path)
+        guard session.remoteNodes[normalizedPath] != nil else {
+            throw SSHTransportError.transportFailure(message: "Remote path does not exist: \(normalizedPath)")
+        }
+        session.remoteNodes[normalizedPath]?.modifiedAt = date
+        activeSessions[sessionID] = session
+    }
+
     func openForwardChannel(sessionID: UUID, remoteHost: String, remotePort: UInt16, sourceHost: String, sourcePort: UInt16) async throws -> any SSHForwardChannel {
         guard let session = activeSessions[sessionID], session.isAuthenticated else {
             throw SSHTransportError.sessionNotFound
@@ -216,8 +246,27 @@ actor MockSSHTransport: SSHTransporting {
         return await MockSSHForwardChannel()
     }
 
-    func sendKeepalive(sessionID: UUID) async -> Bool {
-        return activeSessions[sessionID] != nil
+    /// Echoes `command` with the host's address and exits 0; `exit N`
+    /// exits N with the command on stderr.
+    func runCommand(sessionID: UUID, command: String) async throws -> AsyncThrowingStream<SSHExecEvent, Error> {
+        guard let session = activeSessions[sessionID], session.isAuthenticated else {
+            throw SSHTransportError.sessionNotFound
+        }
+        let address = "\(session.host.username)@\(session.host.hostname)"
+        let exitCode = command.hasPrefix("exit ") ? Int(command.dropFirst(5)) ?? 1 : 0
+        return AsyncThrowingStream { continuation in
+            if exitCode == 0 {
+                continuation.yield(.stdout(Data("\(address): \(command)\n".utf8)))
+            } else {
+                continuation.yield(.stderr(Data("\(address): \(command)\n".utf8)))
+            }
+            continuation.yield(.exit(exitCode))
+            continuation.finish()
+        }
+    }
+
+    func sendKeepalive(sessionID: UUID, deadPeerTimeout: Int) async -> SSHKeepaliveResult {
+        activeSessions[sessionID] != nil ? .probed : .dead
     }
 
     func disconnect(sessionID: UUID) async {
@@ -0,0 +1,164 @@
+import Foundation
+
+/// Resume state for a range-split SFTP download, persisted next to the target
+/// as `<local>.prossh-partial`. The local file is sized up front and each range
+/// fills its own span in place, so a retry only re-fetches what is missing.
+///
+/// Manifest format (text, one record per line):
+///
+///     prossh-partial v1 <remote size> <remote mtime>
+///     <offset> <length> <done>
+///     ...
+///
+/// The manifest is only trusted while the remote size and mtime still match;
+/// the C side additionally re-checks the bytes just before each resume point.
+nonisolated struct SFTPPartialDownload: Equatable, Sendable {
+
+    struct Range: Equatable, Sendable {
+        let offset: Int64
+        let length: Int64
+        var done: Int64
+
+        var isComplete: Bool { done >= length }
+    }
+
+    static let manifestSuffix = ".prossh-partial"
+    private static let header = "prossh-partial v1"
+
+    let remoteSize: Int64
+    let remoteModified: Int64
+    var ranges: [Range]
+
+    var bytesDone: Int64 {
+        ranges.reduce(0) { $0 + min($1.done, $1.length) }
+    }
+
+    var isComplete: Bool {
+        ranges.allSatisfy(\.isComplete)
+    }
+
+    init(remoteSize: Int64, remoteModified: Int64, ranges: [Range]) {
+        self.remoteSize = remoteSize
+        self.remoteModified = remoteModified
+        self.ranges = ranges
+    }
+
+    /// Splits `remoteSize` into `rangeCount` contiguous ranges; the last one
+    /// absorbs the remainder.
+    init(remoteSize: Int64, remoteModified: Int64, rangeCount: Int) {
+        let count = Int64(max(1, min(rangeCount, Int(max(1, remoteSize)))))
+        let span = remoteSize / count
+        var ranges: [Range] = []
+        for index in 0..<count {
+            let offset = index * span
+            let length = index == count - 1 ? remoteSize - offset : span
+            ranges.append(Range(offset: offset, length: length, done: 0))
+        }
+        self.init(remoteSize: remoteSize, remoteModified: remoteModified, ranges: ranges)
+    }
+
+    // MARK: - Serialization
+
+    init?(manifest: String) {
+        var lines = manifest.split(separator: "\n", omittingEmptySubsequences: true)
+        guard !lines.isEmpty else { return nil }
+
+        let headerFields = lines.removeFirst().split(separator: " ")
+        guard headerFields.count == 4,
+              "\(headerFields[0]) \(headerFields[1])" == Self.header,
+              let size = Int64(headerFields[2]),
+              let modified = Int64(headerFields[3]),
+              size > 0 else {
+            return nil
+        }
+
+        var ranges: [Range] = []
+        var expectedOffset: Int64 = 0
+        for line in lines {
+            let fields = line.split(separator: " ")
+            guard fields.count == 3,
+                  let offset = Int64(fields[0]),
+                  let length = Int64(fields[1]),
+                  let done = Int64(fields[2]),
+                  offset == expectedOffset,
+                  length > 0,
+                  (0...length).contains(done) else {
+                return nil
+            }
+            ranges.append(Range(offset: offset, length: length, done: done))
+            expectedOffset += length
+        }
+        guard !ranges.isEmpty, expectedOffset == size else { return nil }
+
+        self.init(remoteSize: size, remoteModified: modified, ranges: ranges)
+    }
+
+    var manifest: String {
+        var lines = ["\(Self.header) \(remoteSize) \(remoteModified)"]
+        lines += ranges.map { "\($0.offset) \($0.length) \($0.done)" }
+        return lines.joined(separator: "\n") + "\n"
+    }
+
+    // MARK: - Persistence
+
+    static func manifestPath(for localPath: String) -> String {
+        localPath + manifestSuffix
+    }
+
+    /// Returns the resume state for `localPath` and makes sure the local file
+    /// exists at its full size. Prefers a matching manifest; otherwise adopts an
+    /// existing shorter file as an already-downloaded prefix (a plain download
+    /// that was interrupted); otherwise starts empty.
+    static func prepare(
+        localPath: String,
+        remoteSize: Int64,
+        remoteModified: Int64,
+        rangeCount: Int
+    ) throws -> SFTPPartialDownload {
+        let fileManager = FileManager.default
+        let localSize = (try? fileManager.attributesOfItem(atPath: localPath)[.size] as? NSNumber)?.int64Value
+
+        if let localSize, localSize == remoteSize,
+           let text = try? String(contentsOfFile: manifestPath(for: localPath), encoding: .utf8),
+           let existing = SFTPPartialDownload(manifest: text),
+           existing.remoteSize == remoteSize,
+           existing.remoteModified == remoteModified {
+            return existing
+        }
+
+        var fresh = SFTPPartialDownload(remoteSize: remoteSize, remoteModified: remoteModified, rangeCount: rangeCount)
+        let hasManifest = fileManager.fileExists(atPath: manifestPath(for: localPath))
+        let prefix: Int64
+        if !hasManifest, let localSize, localSize > 0, localSize < remoteSize {
+            prefix = localSize
+        } else {
+            prefix = 0
+        }
+        for index in fresh.ranges.indices {
+            let range = fresh.ranges[index]
+            fresh.ranges[index].done = min(max(prefix - range.offset, 0), range.length)
+        }
+
+        if !fileManager.fileExists(atPath: localPath) {
+            guard fileManager.createFile(atPath: localPath, contents: nil) else {
+                throw SSHTransportError.transportFailure(message: "Failed to create local file for download.")
+            }
+        }
+        let file = try FileHandle(forWritingTo: URL(fileURLWithPath: localPath))
+        defer { try? file.close() }
+        // Drop anything past the adopted prefix, then extend (sparse) to full size.
+        try file.truncate(atOffset: UInt64(prefix))
+        try file.truncate(atOffset: UInt64(remoteSize))
+
+        try fresh.save(for: localPath)
+        return fresh
+    }
+
+    func save(for localPath: String) throws {
+        try manifest.write(toFile: Self.manifestPath(for: localPath), atomically: true, encoding: .utf8)
+    }
+
+    static func remove(for localPath: String) {
+        try? FileManager.default.removeItem(atPath: manifestPath(for: localPath))
+    }
+}
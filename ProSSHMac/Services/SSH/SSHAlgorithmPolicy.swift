@@ -20,4 +20,44 @@ struct SSHAlgorithmPolicy: Sendable {
         ciphers: ["aes128-cbc", "3des-cbc"],
         macs: ["hmac-sha1", "hmac-sha1-96"]
     )
+
+    /// The same algorithms with ciphers and MACs reordered fastest-first by
+    /// local `throughput` (bytes/s, see `SSHCipherBenchmark`). The set is
+    /// unchanged, so only the client's preference moves. A non-AEAD cipher is
+    /// charged for the fastest MAC it would be paired with; unmeasured names
+    /// keep their relative order after the measured ones.
+    nonisolated func orderedByThroughput(_ throughput: [String: Int64]) -> SSHAlgorithmPolicy {
+        let orderedMACs = Self.fastestFirst(macs) { throughput[$0] }
+        let bestMAC = orderedMACs.first.flatMap { throughput[$0] }
+        let orderedCiphers = Self.fastestFirst(ciphers) { name in
+            guard let rate = throughput[name] else { return nil }
+            guard !Self.isAEAD(name), let bestMAC else { return rate }
+            // Encrypt and MAC are separate passes over every packet.
+            return Int64(1 / (1 / Double(rate) + 1 / Double(bestMAC)))
+        }
+        return SSHAlgorithmPolicy(
+            keyExchange: keyExchange,
+            hostKeys: hostKeys,
+            ciphers: orderedCiphers,
+            macs: orderedMACs
+        )
+    }
+
+    nonisolated static func isAEAD(_ cipher: String) -> Bool {
+        cipher.contains("-gcm@") || cipher.hasPrefix("chacha20-poly1305")
+    }
+
+    nonisolated private static func fastestFirst(_ names: [String], rate: (String) -> Int64?) -> [String] {
+        let measured = names.enumerated()
+            .compactMap { index, name in rate(name).map { (index: index, name: name, rate: $0) } }
+            .sorted { $0.rate != $1.rate ? $0.rate > $1.rate : $0.index < $1.index }
+            .map(\.name)
+        return measured + names.filter { rate($0) == nil }
+    }
+
+    /// Compression list for both directions. Delayed zlib (post-auth) is
+    /// preferred; `none` stays last so servers without zlib still negotiate.
+    nonisolated static func compressionAlgorithms(enabled: Bool) -> String {
+        enabled ? "zlib@openssh.com,zlib,none" : "none"
+    }
 }
@@ -0,0 +1,27 @@
+import Foundation
+
+/// One-time local crypto microbenchmark feeding
+/// `SSHAlgorithmPolicy.orderedByThroughput(_:)`. Which cipher is fastest depends
+/// on the CPU (AES-GCM is hardware accelerated on Apple Silicon and AES-NI Macs),
+/// so it is measured against the bundled OpenSSL rather than hard-coded.
+nonisolated enum SSHCipherBenchmark {
+
+    /// Bytes/second for every cipher and MAC in `SSHAlgorithmPolicy.modern`.
+    /// Measured on first use (about 25 ms per algorithm, off the main actor in
+    /// practice since the first reader is a handshake) and kept for the process.
+    static let throughput: [String: Int64] = measure(
+        SSHAlgorithmPolicy.modern.ciphers + SSHAlgorithmPolicy.modern.macs
+    )
+
+    /// Names the wrapper cannot time are left out.
+    static func measure(_ algorithms: [String], durationMilliseconds: Int32 = 25) -> [String: Int64] {
+        var result: [String: Int64] = [:]
+        for name in algorithms {
+            let rate = name.withCString { prossh_crypto_benchmark($0, durationMilliseconds) }
+            if rate > 0 {
+                result[name] = rate
+            }
+        }
+        return result
+    }
+}
@@ -0,0 +1,70 @@
+import Foundation
+
+/// Counting gate for blocking SSH handshakes. `LibSSHTransport` is one actor
+/// for every session, so a synchronous `prossh_libssh_connect` on it would make
+/// N launches cost the sum of their handshakes; running each on a detached task
+/// through this pool makes them overlap, while `limit` keeps a large broadcast
+/// group from opening dozens of sockets and KEX computations at once.
+nonisolated final class SSHHandshakePool: @unchecked Sendable {
+
+    let limit: Int
+    private let lock = NSLock()
+    private var running = 0
+    private var waiters: [CheckedContinuation<Void, Never>] = []
+
+    init(limit: Int) {
+        self.limit = max(1, limit)
+    }
+
+    /// Number of slots currently held.
+    var activeCount: Int {
+        lock.withLock { running }
+    }
+
+    /// Waits for a free slot. Every `acquire` must be paired with `release`.
+    func acquire() async {
+        let acquired = lock.withLock { () -> Bool in
+            guard running < limit else { return false }
+            running += 1
+            return true
+        }
+        if acquired {
+            return
+        }
+        await withCheckedContinuation { continuation in
+            let granted = lock.withLock { () -> Bool in
+                // A slot may have freed up between the two critical sections.
+                if running < limit {
+                    running += 1
+                    return true
+                }
+                waiters.append(continuation)
+                return false
+            }
+            if granted {
+                continuation.resume()
+            }
+        }
+    }
+
+    /// Frees a slot, handing it straight to the oldest waiter if there is one.
+    func release() {
+        let next = lock.withLock { () -> CheckedContinuation<Void, Never>? in
+            if waiters.isEmpty {
+                running -= 1
+                return nil
+            }
+            return waiters.removeFirst()
+        }
+        next?.resume()
+    }
+
+    /// Runs blocking `body` on a detached task while holding a slot.
+    func run<T: Sendable>(_ body: @escaping @Sendable () throws -> T) async throws -> T {
+        await acquire()
+        defer { release() }
+        return try await Task.detached(priority: .userInitiated) {
+            try body()
+        }.value
+    }
+}
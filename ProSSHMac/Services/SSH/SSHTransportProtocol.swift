@@ -3,12 +3,39 @@ import Foundation
 
 protocol SSHShellChannel: AnyObject, Sendable {
     var rawOutput: AsyncStream<Data> { get }
+    var outputRing: ShellOutputRing? { get }
     func send(_ input: String) async throws
     func send(bytes: [UInt8]) async throws
+    func send(bytes: [UInt8], priority: SSHShellWritePriority) async throws
+    /// Bulk bytes accepted by `send` but not yet written to the wire.
+    func queuedBulkByteCount() async -> Int
+    /// Drops bulk bytes not yet written, returning how many; an interrupt
+    /// uses it so the rest of a paste does not follow the Ctrl-C.
+    func discardQueuedBulk() async -> Int
     func resizePTY(columns: Int, rows: Int) async throws
     func close() async
 }
 
+extension SSHShellChannel {
+    /// Zero-copy output path; channels without one deliver through `rawOutput`.
+    var outputRing: ShellOutputRing? { nil }
+
+    /// Channels without an outbound queue write everything in order.
+    func send(bytes: [UInt8], priority: SSHShellWritePriority) async throws {
+        try await send(bytes: bytes)
+    }
+
+    /// Channels without an outbound queue have written everything by the
+    /// time `send` returns.
+    func queuedBulkByteCount() async -> Int {
+        0
+    }
+
+    func discardQueuedBulk() async -> Int {
+        0
+    }
+}
+
 protocol SSHForwardChannel: AnyObject, Sendable {
     func read() async throws -> Data?
     func write(_ data: Data) async throws
@@ -16,18 +43,50 @@ protocol SSHForwardChannel: AnyObject, Sendable {
     func close() async
 }
 
+/// Server-side listener of a remote (`-R`) forward. `accept()` returns the
+/// next connection the server forwarded, or nil once the listener or its
+/// session is closed.
+protocol SSHRemoteForwardListener: AnyObject, Sendable {
+    var boundPort: UInt16 { get }
+    func accept() async throws -> (any SSHForwardChannel)?
+    func close() async
+}
+
 protocol SSHTransporting: Sendable {
     func connect(sessionID: UUID, to host: Host, jumpHostConfig: JumpHostConfig?) async throws -> SSHConnectionDetails
     func authenticate(sessionID: UUID, to host: Host, passwordOverride: String?, keyPassphraseOverride: String?) async throws
     func openShell(sessionID: UUID, pty: PTYConfiguration, enableAgentForwarding: Bool) async throws -> any SSHShellChannel
     func listDirectory(sessionID: UUID, path: String) async throws -> [SFTPDirectoryEntry]
+    /// Streams the entries under `path` (breadth-first, one or more batches per
+    /// directory) as they are read. Root-directory errors finish the stream.
+    func walkDirectory(sessionID: UUID, path: String, recursive: Bool) async throws -> AsyncThrowingStream<[SFTPDirectoryEntry], Error>
+    /// Creates `path` if it does not already exist as a directory.
+    func createDirectory(sessionID: UUID, path: String) async throws
+    func setModificationTime(sessionID: UUID, path: String, date: Date) async throws
+    /// The modification time of `path`, or nil when the transport cannot
+    /// stat remote paths. Directory listing caches revalidate with it.
+    func modificationTime(sessionID: UUID, path: String) async throws -> Date?
     func uploadFile(sessionID: UUID, localPath: String, remotePath: String) async throws -> SFTPTransferResult
     func uploadFile(sessionID: UUID, localPath: String, remotePath: String, progressHandler: (@Sendable (Int64, Int64) -> Void)?) async throws -> SFTPTransferResult
     func downloadFile(sessionID: UUID, remotePath: String, localPath: String) async throws -> SFTPTransferResult
     func downloadFile(sessionID: UUID, remotePath: String, localPath: String, progressHandler: (@Sendable (Int64, Int64) -> Void)?) async throws -> SFTPTransferResult
     func openForwardChannel(sessionID: UUID, remoteHost: String, remotePort: UInt16, sourceHost: String, sourcePort: UInt16) async throws -> any SSHForwardChannel
-    func sendKeepalive(sessionID: UUID) async -> Bool
+    /// Runs `command` on its own exec channel, outside the interactive shell,
+    /// and streams its output as it arrives.
+    func runCommand(sessionID: UUID, command: String) async throws -> AsyncThrowingStream<SSHExecEvent, Error>
+    /// Asks the server to listen on `bindAddress:port` (empty address = the
+    /// server's loopback, port 0 = server-chosen) and forward connections back.
+    func listenRemoteForward(sessionID: UUID, bindAddress: String, port: UInt16) async throws -> any SSHRemoteForwardListener
+    /// `deadPeerTimeout` (seconds) bounds how long an unacknowledged probe may
+    /// go unanswered at the TCP level before the connection is dropped.
+    func sendKeepalive(sessionID: UUID, deadPeerTimeout: Int) async -> SSHKeepaliveResult
     func disconnect(sessionID: UUID) async
+    /// Opens a connection to `host` before any session asks for it, for the
+    /// next `connect` with the same host and route to adopt. It also
+    /// authenticates when the server presents `trustedFingerprint` and the
+    /// host's key needs no prompt. Unused connections close after a timeout.
+    /// Returns whether a connection is ready.
+    func prewarm(host: Host, jumpHostConfig: JumpHostConfig?, trustedFingerprint: String?) async -> Bool
 }
 
 extension SSHTransporting {
@@ -43,6 +102,91 @@ extension SSHTransporting {
         try await openShell(sessionID: sessionID, pty: pty, enableAgentForwarding: false)
     }
 
+    /// Fallback walk built on `listDirectory`, one batch per directory.
+    func walkDirectory(sessionID: UUID, path: String, recursive: Bool) async throws -> AsyncThrowingStream<[SFTPDirectoryEntry], Error> {
+        let root = try await listDirectory(sessionID: sessionID, path: path)
+        return AsyncThrowingStream { continuation in
+            let task = Task {
+                var pending = [root]
+                while !pending.isEmpty, !Task.isCancelled {
+                    let entries = pending.removeFirst()
+                    continuation.yield(entries)
+                    guard recursive else { break }
+                    for directory in entries where directory.isDirectory {
+                        if let children = try? await listDirectory(sessionID: sessionID, path: directory.path) {
+                            pending.append(children)
+                        }
+                    }
+                }
+                continuation.finish()
+            }
+            continuation.onTermination = { _ in task.cancel() }
+        }
+    }
+
+    func createDirectory(sessionID: UUID, path: String) async throws {
+        throw SSHTransportError.transportFailure(message: "Creating remote directories is not supported by this transport.")
+    }
+
+    func setModificationTime(sessionID: UUID, path: String, date: Date) async throws {}
+
+    func modificationTime(sessionID: UUID, path: String) async throws -> Date? {
+        nil
+    }
+
+    func listenRemoteForward(sessionID: UUID, bindAddress: String, port: UInt16) async throws -> any SSHRemoteForwardListener {
+        throw SSHTransportError.transportFailure(message: "Remote port forwarding is not supported by this transport.")
+    }
+
+    func runCommand(sessionID: UUID, command: String) async throws -> AsyncThrowingStream<SSHExecEvent, Error> {
+        throw SSHTransportError.transportFailure(message: "Exec channels are not supported by this transport.")
+    }
+
+    func prewarm(host: Host, jumpHostConfig: JumpHostConfig?, trustedFingerprint: String?) async -> Bool {
+        false
+    }
+
+    /// Runs `command` via `runCommand` and collects its output. Gives up (and
+    /// closes the channel) after `timeout`; output beyond `maxOutputBytes` per
+    /// stream is dropped.
+    func executeCommand(
+        sessionID: UUID,
+        command: String,
+        timeout: Duration,
+        maxOutputBytes: Int = 4 * 1024 * 1024
+    ) async throws -> SSHExecResult {
+        let events = try await runCommand(sessionID: sessionID, command: command)
+        return await withTaskGroup(of: SSHExecResult?.self) { group in
+            group.addTask {
+                var result = SSHExecResult()
+                do {
+                    for try await event in events {
+                        switch event {
+                        case .stdout(let data):
+                            result.truncated = result.stdout.append(data, limit: maxOutputBytes) || result.truncated
+                        case .stderr(let data):
+                            result.truncated = result.stderr.append(data, limit: maxOutputBytes) || result.truncated
+                        case .exit(let code):
+                            result.exitCode = code
+                        }
+                    }
+                } catch {
+                    if result.stderr.isEmpty {
+                        result.stderr = Data(error.localizedDescription.utf8)
+                    }
+                }
+                return result
+            }
+            group.addTask {
+                try? await Task.sleep(for: timeout)
+                return nil
+            }
+            let first = await group.next() ?? nil
+            group.cancelAll()
+            return first ?? SSHExecResult(timedOut: true)
+        }
+    }
+
     func uploadFile(sessionID: UUID, localPath: String, remotePath: String, progressHandler: (@Sendable (Int64, Int64) -> Void)?) async throws -> SFTPTransferResult {
         try await uploadFile(sessionID: sessionID, localPath: localPath, remotePath: remotePath)
     }
@@ -51,3 +195,12 @@ extension SSHTransporting {
         try await downloadFile(sessionID: sessionID, remotePath: remotePath, localPath: localPath)
     }
 }
+
+private extension Data {
+    /// Appends up to `limit` total bytes; returns true if anything was dropped.
+    nonisolated mutating func append(_ data: Data, limit: Int) -> Bool {
+        let room = Swift.max(0, limit - count)
+        append(data.prefix(room))
+        return data.count > room
+    }
+}
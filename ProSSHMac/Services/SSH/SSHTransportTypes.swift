@@ -21,9 +21,46 @@ struct PTYConfiguration: Sendable, Equatable {
     static let `default` = PTYConfiguration(columns: 120, rows: 40, terminalType: "xterm-256color")
 }
 
+/// Outbound shell input class. Queued interactive input (keystrokes, control
+/// sequences) is written ahead of queued bulk input (pastes), so typing and
+/// Ctrl-C stay responsive during a large paste.
+enum SSHShellWritePriority: Sendable {
+    case interactive
+    case bulk
+}
+
+/// Outcome of one keepalive check. `.active` means the connection moved
+/// packets since the previous check, so no probe was needed.
+enum SSHKeepaliveResult: Sendable {
+    case active
+    case probed
+    case dead
+}
+
+/// One piece of an exec channel's output, in arrival order per stream.
+/// `.exit` comes last; its code is nil when the command was killed by a
+/// signal or the channel closed without reporting one.
+enum SSHExecEvent: Sendable {
+    case stdout(Data)
+    case stderr(Data)
+    case exit(Int?)
+}
+
+/// Collected result of `SSHTransporting.executeCommand`.
+struct SSHExecResult: Sendable {
+    var stdout = Data()
+    var stderr = Data()
+    var exitCode: Int?
+    var timedOut = false
+    /// Output past `maxOutputBytes` was dropped.
+    var truncated = false
+}
+
 struct SSHConnectionDetails: Sendable {
     var negotiatedKEX: String
     var negotiatedCipher: String
+    /// "aead-*" when the cipher authenticates itself.
+    var negotiatedMAC: String = ""
     var negotiatedHostKeyType: String
     var negotiatedHostFingerprint: String
     var usedLegacyAlgorithms: Bool
@@ -38,10 +75,20 @@ struct SFTPDirectoryEntry: Identifiable, Sendable, Hashable {
     var size: Int64
     var permissions: UInt32
     var modifiedAt: Date?
+    /// False for symlinks and special files; folder transfers skip those.
+    var isRegularFile: Bool = true
 
     var id: String {
         path
     }
+
+    /// Directories first, then case-insensitive by name.
+    nonisolated static func listingOrder(_ lhs: SFTPDirectoryEntry, _ rhs: SFTPDirectoryEntry) -> Bool {
+        if lhs.isDirectory != rhs.isDirectory {
+            return lhs.isDirectory && !rhs.isDirectory
+        }
+        return lhs.name.localizedCaseInsensitiveCompare(rhs.name) == .orderedAscending
+    }
 }
 
 struct SFTPTransferResult: Sendable, Hashable {
@@ -54,6 +101,27 @@ struct JumpHostConfig: Sendable {
     let expectedFingerprint: String
 }
 
+/// Identifies an SSH connection that sessions may share (OpenSSH ControlMaster's
+/// `%r@%h:%p`, plus the jump route). Sessions with equal keys reach the same
+/// server as the same user, so a second tab can ride on the first one's
+/// authenticated transport instead of paying TCP, KEX and auth again.
+nonisolated struct SSHConnectionShareKey: Hashable, Sendable {
+    let hostname: String
+    let port: UInt16
+    let username: String
+    let jumpRoute: String?
+
+    init(host: Host, jumpHostConfig: JumpHostConfig?) {
+        hostname = host.hostname.lowercased()
+        port = host.port
+        username = host.username
+        jumpRoute = jumpHostConfig.map { config in
+            let jump = config.host
+            return "\(jump.username)@\(jump.hostname.lowercased()):\(jump.port) \(config.expectedFingerprint)"
+        }
+    }
+}
+
 enum SSHTransportError: LocalizedError, Sendable {
     case connectionRefused
     case authenticationFailed
@@ -92,12 +160,19 @@ nonisolated struct UncheckedOpaquePointer: @unchecked Sendable {
 }
 
 enum SSHTransportFactory {
+    /// Large SFTP transfers on a second connection per session, so they do
+    /// not hold up shell echo on the first.
+    /// Toggle via: `defaults write com.prossh transfers.dedicatedConnection.enabled -bool true`
+    static let dedicatedTransferConnectionDefaultsKey = "transfers.dedicatedConnection.enabled"
+
     static func makePreferredTransport() -> any SSHTransporting {
         #if DEBUG
         if ProcessInfo.processInfo.environment["PROSSH_FORCE_MOCK"] == "1" {
             return MockSSHTransport()
         }
         #endif
-        return LibSSHTransport()
+        return LibSSHTransport(
+            separatesBulkTransfers: UserDefaults.standard.bool(forKey: dedicatedTransferConnectionDefaultsKey)
+        )
     }
 }
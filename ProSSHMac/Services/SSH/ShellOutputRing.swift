@@ -0,0 +1,229 @@
+// ShellOutputRing.swift
+// ProSSHMac
+//
+// Preallocated single-producer/single-consumer byte ring between the libssh
+// shell reader and the terminal parser.
+
+import Foundation
+import QuartzCore
+import Synchronization
+
+/// Lock-free SPSC byte ring. The shell reader writes channel output straight into
+/// ring storage (no scratch buffer, no per-read `Data`), and the parser consumes
+/// contiguous spans in place before releasing them.
+///
+/// Positions are monotonically increasing byte counters; `capacity` is a power of
+/// two so the storage index is `position & mask`. Only the parking slow path
+/// (ring empty / ring full) takes a lock.
+nonisolated final class ShellOutputRing: @unchecked Sendable {
+
+    let capacity: Int
+    private let mask: Int
+    private let storage: UnsafeMutableRawPointer
+
+    /// Total bytes ever committed by the producer.
+    private let writePosition = Atomic<Int>(0)
+    /// Total bytes ever released by the consumer.
+    private let readPosition = Atomic<Int>(0)
+    private let finished = Atomic<Bool>(false)
+
+    /// Arrival stamp for PipelineLatencyTracer: when a sampled write
+    /// committed (bit pattern, 0 when none) and the position it ended at.
+    private let samplesArrivals = Atomic<Bool>(false)
+    private let sampledArrivalBits = Atomic<UInt64>(0)
+    private let sampledArrivalEnd = Atomic<Int>(0)
+
+    private let parkLock = NSLock()
+    private var parkedConsumer: CheckedContinuation<Void, Never>?
+    private var parkedProducer: CheckedContinuation<Void, Never>?
+
+    init(capacity requestedCapacity: Int = 1 << 20) {
+        var capacity = 4096
+        while capacity < requestedCapacity {
+            capacity <<= 1
+        }
+        self.capacity = capacity
+        self.mask = capacity - 1
+        self.storage = UnsafeMutableRawPointer.allocate(byteCount: capacity, alignment: 64)
+    }
+
+    deinit {
+        storage.deallocate()
+    }
+
+    var isFinished: Bool {
+        finished.load(ordering: .acquiring)
+    }
+
+    var readableCount: Int {
+        writePosition.load(ordering: .acquiring) - readPosition.load(ordering: .acquiring)
+    }
+
+    // MARK: - Producer
+
+    /// Hands `body` the largest contiguous free region and commits the byte count
+    /// it returns. Suspends while the ring is full, which stops the reader from
+    /// draining libssh and lets the SSH window apply backpressure upstream.
+    /// Returns false once the ring is finished.
+    @discardableResult
+    func write(_ body: (UnsafeMutableRawBufferPointer) -> Int) async -> Bool {
+        while true {
+            if isFinished { return false }
+            let write = writePosition.load(ordering: .relaxed)
+            let free = capacity - (write - readPosition.load(ordering: .acquiring))
+            if free == 0 {
+                await park(producer: true)
+                continue
+            }
+
+            let start = write & mask
+            let contiguous = min(free, capacity - start)
+            let region = UnsafeMutableRawBufferPointer(start: storage + start, count: contiguous)
+            let written = max(0, min(body(region), contiguous))
+            if written > 0 {
+                writePosition.store(write + written, ordering: .releasing)
+                stampArrivalIfSampling(endingAt: write + written)
+                unpark(consumer: true)
+            }
+            return true
+        }
+    }
+
+    /// Copies `bytes` into the ring, waiting for space as needed. Used for the
+    /// occasional out-of-band message (e.g. I/O errors), not the hot path.
+    func append(_ bytes: [UInt8]) async {
+        var offset = 0
+        while offset < bytes.count {
+            let accepted = await write { region in
+                let count = min(region.count, bytes.count - offset)
+                bytes.withUnsafeBytes { source in
+                    region.copyMemory(from: UnsafeRawBufferPointer(rebasing: source[offset..<(offset + count)]))
+                }
+                offset += count
+                return count
+            }
+            guard accepted else { return }
+        }
+    }
+
+    /// Copies `data` into the ring, waiting for space as needed. Used to pump
+    /// `AsyncStream<Data>` output into a ring for channels that lack one.
+    func append(contentsOf data: Data) async {
+        var offset = 0
+        while offset < data.count {
+            let accepted = await write { region in
+                let count = min(region.count, data.count - offset)
+                data.withUnsafeBytes { source in
+                    region.copyMemory(from: UnsafeRawBufferPointer(rebasing: source[offset..<(offset + count)]))
+                }
+                offset += count
+                return count
+            }
+            guard accepted else { return }
+        }
+    }
+
+    /// Marks end of stream. The consumer still drains anything already written.
+    func finish() {
+        finished.store(true, ordering: .releasing)
+        unpark(consumer: true)
+        unpark(consumer: false)
+    }
+
+    /// Stamps this write's arrival when sampling is on and the consumer has
+    /// taken the previous stamp.
+    private func stampArrivalIfSampling(endingAt end: Int) {
+        guard samplesArrivals.load(ordering: .relaxed),
+              sampledArrivalBits.load(ordering: .acquiring) == 0 else { return }
+        sampledArrivalEnd.store(end, ordering: .relaxed)
+        sampledArrivalBits.store(CACurrentMediaTime().bitPattern, ordering: .releasing)
+    }
+
+    // MARK: - Consumer
+
+    /// Start stamping writes for `takeSampledArrival(consuming:)`.
+    func enableArrivalSampling() {
+        samplesArrivals.store(true, ordering: .relaxed)
+    }
+
+    /// Arrival time of the stamped write if its bytes end within the next
+    /// `count` unread bytes, clearing the stamp. Call before `consume(_:)`.
+    func takeSampledArrival(consuming count: Int) -> CFTimeInterval? {
+        let bits = sampledArrivalBits.load(ordering: .acquiring)
+        guard bits != 0,
+              sampledArrivalEnd.load(ordering: .relaxed) <= readPosition.load(ordering: .relaxed) + count else {
+            return nil
+        }
+        sampledArrivalBits.store(0, ordering: .releasing)
+        return CFTimeInterval(bitPattern: bits)
+    }
+
+    /// Suspends until bytes are readable. Returns false when the ring is finished
+    /// and fully drained.
+    func waitForReadable() async -> Bool {
+        while true {
+            if readableCount > 0 { return true }
+            if isFinished { return readableCount > 0 }
+            await park(producer: false)
+        }
+    }
+
+    /// The oldest contiguous run of unread bytes, valid until `consume(_:)`.
+    var readableRegion: UnsafeRawBufferPointer {
+        let read = readPosition.load(ordering: .relaxed)
+        let available = writePosition.load(ordering: .acquiring) - read
+        let start = read & mask
+        return UnsafeRawBufferPointer(start: storage + start, count: min(available, capacity - start))
+    }
+
+    /// Releases `count` bytes back to the producer.
+    func consume(_ count: Int) {
+        guard count > 0 else { return }
+        let read = readPosition.load(ordering: .relaxed)
+        readPosition.store(read + count, ordering: .releasing)
+        unpark(consumer: false)
+    }
+
+    // MARK: - Parking
+
+    private func park(producer: Bool) async {
+        await withCheckedContinuation { (continuation: CheckedContinuation<Void, Never>) in
+            parkLock.lock()
+            // Re-check under the lock: the other side publishes its position
+            // before taking this lock to unpark, so a wakeup cannot slip between.
+            let ready: Bool
+            if isFinished {
+                ready = true
+            } else if producer {
+                ready = readableCount < capacity
+            } else {
+                ready = readableCount > 0
+            }
+            if ready {
+                parkLock.unlock()
+                continuation.resume()
+                return
+            }
+            if producer {
+                parkedProducer = continuation
+            } else {
+                parkedConsumer = continuation
+            }
+            parkLock.unlock()
+        }
+    }
+
+    private func unpark(consumer: Bool) {
+        parkLock.lock()
+        let continuation: CheckedContinuation<Void, Never>?
+        if consumer {
+            continuation = parkedConsumer
+            parkedConsumer = nil
+        } else {
+            continuation = parkedProducer
+            parkedProducer = nil
+        }
+        parkLock.unlock()
+        continuation?.resume()
+    }
+}
@@ -32,6 +32,10 @@ struct SSHBinaryReader {
         offset == data.count
     }
 
+    mutating func readUInt8(context: String) throws -> UInt8 {
+        try readBytes(count: 1, context: context)[0]
+    }
+
     mutating func readUInt32(context: String) throws -> UInt32 {
         let bytes = try readBytes(count: 4, context: context)
         return bytes.reduce(UInt32(0)) { ($0 << 8) | UInt32($1) }
@@ -76,6 +76,11 @@ struct SSHConfigExporter: Sendable {
             lines.append("    ForwardAgent yes")
         }
 
+        // --- Compression (automatic mode has no OpenSSH equivalent) ---
+        if host.compression == .on {
+            lines.append("    Compression yes")
+        }
+
         // --- Jump host ---
         if let jumpID = host.jumpHost,
            let jumpHost = options.allHosts.first(where: { $0.id == jumpID }) {
@@ -84,7 +89,15 @@ struct SSHConfigExporter: Sendable {
 
         // --- Port forwarding ---
         for rule in host.portForwardingRules {
-            lines.append("    LocalForward \(rule.localPort) \(rule.remoteHost):\(rule.remotePort)")
+            switch rule.kind {
+            case .local:
+                lines.append("    LocalForward \(rule.localPort) \(rule.remoteHost):\(rule.remotePort)")
+            case .dynamic:
+                lines.append("    DynamicForward \(rule.localPort)")
+            case .remote:
+                let listen = rule.remoteHost.isEmpty ? "\(rule.remotePort)" : "\(rule.remoteHost):\(rule.remotePort)"
+                lines.append("    RemoteForward \(listen) localhost:\(rule.localPort)")
+            }
         }
 
         // --- Algorithm preferences ---
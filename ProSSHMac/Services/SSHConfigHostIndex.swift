@@ -0,0 +1,131 @@
+// SSHConfigHostIndex.swift
+// Host-pattern index over parsed SSH config entries
+//
+// Finds the Host blocks that apply to a host name without walking every
+// entry. Blocks whose patterns are all literal names are kept in a
+// dictionary. Only blocks with wildcard (`*`, `?`) or negated (`!`)
+// patterns are matched one by one, and generated configs have few of
+// them. Match blocks are not indexed because their conditions are not
+// evaluated.
+
+import Foundation
+
+nonisolated struct SSHConfigHostIndex: Sendable {
+
+    let entries: [SSHConfigEntry]
+    private var literalBlocks: [String: [Int]] = [:]
+    private var patternBlocks: [Int] = []
+
+    init(entries: [SSHConfigEntry]) {
+        self.entries = entries
+        for (position, entry) in entries.enumerated() where !entry.isMatchBlock {
+            if entry.patterns.contains(where: Self.isPattern) {
+                patternBlocks.append(position)
+            } else {
+                for name in Set(entry.patterns.map { $0.lowercased() }) {
+                    literalBlocks[name, default: []].append(position)
+                }
+            }
+        }
+    }
+
+    init(_ parseResult: SSHConfigParseResult) {
+        self.init(entries: parseResult.entries)
+    }
+
+    /// Positions in `entries` of the blocks that apply to `host`, in file order.
+    func positions(matching host: String) -> [Int] {
+        let name = host.lowercased()
+        let literal = literalBlocks[name] ?? []
+        let patterned = patternBlocks.filter { Self.matches(entries[$0].patterns, name: name) }
+        guard !patterned.isEmpty else { return literal }
+        guard !literal.isEmpty else { return patterned }
+
+        var merged: [Int] = []
+        merged.reserveCapacity(literal.count + patterned.count)
+        var l = 0, p = 0
+        while l < literal.count || p < patterned.count {
+            if p == patterned.count || (l < literal.count && literal[l] < patterned[p]) {
+                merged.append(literal[l])
+                l += 1
+            } else {
+                merged.append(patterned[p])
+                p += 1
+            }
+        }
+        return merged
+    }
+
+    /// The blocks that apply to `host`, in file order.
+    func entries(matching host: String) -> [SSHConfigEntry] {
+        positions(matching: host).map { entries[$0] }
+    }
+
+    /// The effective value of a single-valued option: the first block that
+    /// sets it wins, as in ssh.
+    func firstValue(for keyword: String, host: String) -> String? {
+        for position in positions(matching: host) {
+            if let value = entries[position].firstValue(for: keyword) {
+                return value
+            }
+        }
+        return nil
+    }
+
+    /// Every value of a multi-valued option (IdentityFile, LocalForward, ...)
+    /// across the blocks that apply, in file order.
+    func allValues(for keyword: String, host: String) -> [String] {
+        positions(matching: host).flatMap { entries[$0].allValues(for: keyword) }
+    }
+
+    // MARK: - Pattern Matching
+
+    private static func isPattern(_ pattern: String) -> Bool {
+        pattern.contains { $0 == "*" || $0 == "?" || $0 == "!" }
+    }
+
+    /// ssh's rule: some positive pattern matches and no negated one does.
+    /// `name` must already be lowercased.
+    static func matches(_ patterns: [String], name: String) -> Bool {
+        let nameBytes = Array(name.utf8)
+        var matched = false
+        for pattern in patterns {
+            if pattern.hasPrefix("!") {
+                if wildcardMatch(Array(pattern.dropFirst().lowercased().utf8), nameBytes) {
+                    return false
+                }
+            } else if !matched, wildcardMatch(Array(pattern.lowercased().utf8), nameBytes) {
+                matched = true
+            }
+        }
+        return matched
+    }
+
+    /// `*` matches any run of bytes, `?` any single byte.
+    static func wildcardMatch(_ pattern: [UInt8], _ name: [UInt8]) -> Bool {
+        let star = UInt8(ascii: "*")
+        let question = UInt8(ascii: "?")
+        var p = 0, n = 0
+        var starAt = -1, resumeAt = 0
+        while n < name.count {
+            if p < pattern.count, pattern[p] == star {
+                starAt = p
+                resumeAt = n
+                p += 1
+            } else if p < pattern.count, pattern[p] == question || pattern[p] == name[n] {
+                p += 1
+                n += 1
+            } else if starAt >= 0 {
+                p = starAt + 1
+                resumeAt += 1
+                n = resumeAt
+            } else {
+                return false
+            }
+        }
+        while p < pattern.count, pattern[p] == star {
+            p += 1
+        }
+        return p == pattern.count
+    }
+}
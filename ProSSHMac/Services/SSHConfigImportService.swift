@@ -53,25 +53,63 @@ struct SSHConfigImportService: Sendable {
         existingHosts: [Host] = [],
         existingKeys: [StoredSSHKey] = []
     ) -> ImportPreview {
-        let parseResult = parser.parse(configText)
-
-        let totalEntries = parseResult.entries.count
-        let concreteCount = parseResult.concreteHosts.count
-        let skipped = totalEntries - concreteCount
-
-        let results = mapper.importAll(
-            from: parseResult,
+        preview(
+            parseResult: parser.parse(configText),
             existingHosts: existingHosts,
             existingKeys: existingKeys
         )
+    }
+
+    /// Parse a config file from disk, with its includes, and produce an
+    /// import preview.
+    ///
+    /// Reading and parsing run on a background task; mapping to hosts runs
+    /// on the caller. `progress` is called from the background task after
+    /// each chunk. Cancelling the calling task stops the parse.
+    func preview(
+        configFileAt url: URL,
+        includes: SSHConfigParser.IncludeOptions = .user,
+        existingHosts: [Host] = [],
+        existingKeys: [StoredSSHKey] = [],
+        progress: (@Sendable (SSHConfigParseProgress) -> Void)? = nil
+    ) async throws -> ImportPreview {
+        let parser = parser
+        let parse = Task.detached(priority: .userInitiated) {
+            try parser.parse(fileAt: url, includes: includes, progress: progress)
+        }
+        let parseResult = try await withTaskCancellationHandler {
+            try await parse.value
+        } onCancel: {
+            parse.cancel()
+        }
+        return preview(parseResult: parseResult, existingHosts: existingHosts, existingKeys: existingKeys)
+    }
+
+    private func preview(
+        parseResult: SSHConfigParseResult,
+        existingHosts: [Host],
+        existingKeys: [StoredSSHKey]
+    ) -> ImportPreview {
+        let totalEntries = parseResult.entries.count
+        let concreteCount = parseResult.concreteHosts.count
 
         return ImportPreview(
-            results: results,
+            results: mapper.importAll(
+                from: parseResult,
+                existingHosts: existingHosts,
+                existingKeys: existingKeys
+            ),
             parserWarnings: parseResult.warnings,
-            skippedEntries: skipped
+            skippedEntries: totalEntries - concreteCount
         )
     }
 
+    /// The current user's `~/.ssh/config`.
+    static var defaultConfigURL: URL {
+        URL(fileURLWithPath: NSHomeDirectory(), isDirectory: true)
+            .appendingPathComponent(".ssh/config")
+    }
+
     /// Read the default SSH config file from disk.
     ///
     /// - Returns: The file contents, or `nil` if the file doesn't exist.
@@ -9,7 +9,7 @@ import Foundation
 /// The mapper handles:
 /// - Directive → Host field mapping
 /// - Token expansion in paths and hostnames
-/// - LocalForward parsing → PortForwardingRule
+/// - LocalForward / DynamicForward / RemoteForward parsing → PortForwardingRule
 /// - ProxyJump → jumpHost resolution (by label or hostname)
 /// - IdentityFile → keyReference resolution (by path suffix matching)
 /// - Algorithm preferences mapping
@@ -26,12 +26,39 @@ struct SSHConfigMapper: Sendable {
 
         /// Hosts being imported in this batch (for ProxyJump referencing other imported hosts).
         /// Populated incrementally during multi-entry import.
-        var importedHosts: [Host]
+        private(set) var importedHosts: [Host] = []
+
+        // Lowercased label / hostname -> first host with it, so jump host
+        // lookups don't scan every host.
+        private var importedByLabel: [String: UUID] = [:]
+        private var importedByHostname: [String: UUID] = [:]
+        private var existingByLabel: [String: UUID] = [:]
+        private var existingByHostname: [String: UUID] = [:]
 
         init(existingHosts: [Host] = [], existingKeys: [StoredSSHKey] = [], importedHosts: [Host] = []) {
             self.existingHosts = existingHosts
             self.existingKeys = existingKeys
-            self.importedHosts = importedHosts
+            for host in existingHosts {
+                existingByLabel[host.label.lowercased()] = existingByLabel[host.label.lowercased()] ?? host.id
+                existingByHostname[host.hostname.lowercased()] = existingByHostname[host.hostname.lowercased()] ?? host.id
+            }
+            for host in importedHosts {
+                addImported(host)
+            }
+        }
+
+        mutating func addImported(_ host: Host) {
+            importedHosts.append(host)
+            importedByLabel[host.label.lowercased()] = importedByLabel[host.label.lowercased()] ?? host.id
+            importedByHostname[host.hostname.lowercased()] = importedByHostname[host.hostname.lowercased()] ?? host.id
+        }
+
+        /// Imported hosts before existing ones, by label, then by hostname.
+        func hostID(label: String, hostname: String) -> UUID? {
+            let label = label.lowercased()
+            let hostname = hostname.lowercased()
+            return importedByLabel[label] ?? existingByLabel[label]
+                ?? importedByHostname[hostname] ?? existingByHostname[hostname]
         }
     }
 
@@ -54,19 +81,44 @@ struct SSHConfigMapper: Sendable {
         _ entry: SSHConfigEntry,
         globalDefaults: SSHConfigEntry?,
         context: ResolutionContext
+    ) -> MappingResult {
+        mapEntry(entry, inherited: globalDefaults.map { [$0] } ?? [], context: context)
+    }
+
+    /// Map an entry, falling back to `inherited` blocks (the other Host
+    /// blocks that match it, in file order) for directives it doesn't set.
+    func mapEntry(
+        _ entry: SSHConfigEntry,
+        inherited: [SSHConfigEntry],
+        context: ResolutionContext
     ) -> MappingResult {
         var notes: [String] = []
 
-        // Helper: resolve a directive with fallback to global defaults.
+        // Helper: resolve a directive with fallback to the matching blocks.
         func resolve(_ keyword: String) -> String? {
-            entry.firstValue(for: keyword) ?? globalDefaults?.firstValue(for: keyword)
+            if let local = entry.firstValue(for: keyword) {
+                return local
+            }
+            for block in inherited {
+                if let value = block.firstValue(for: keyword) {
+                    return value
+                }
+            }
+            return nil
         }
 
         func resolveAll(_ keyword: String) -> [String] {
             let local = entry.allValues(for: keyword)
-            return local.isEmpty
-                ? (globalDefaults?.allValues(for: keyword) ?? [])
-                : local
+            if !local.isEmpty {
+                return local
+            }
+            for block in inherited {
+                let values = block.allValues(for: keyword)
+                if !values.isEmpty {
+                    return values
+                }
+            }
+            return []
         }
 
         // --- Core fields ---
@@ -121,14 +173,24 @@ struct SSHConfigMapper: Sendable {
             .map { $0.lowercased() == "yes" }
             ?? false
 
+        // --- Compression (unset keeps the automatic default) ---
+
+        let compression: SSHCompressionMode = resolve("compression")
+            .map { $0.lowercased() == "yes" ? .on : .off }
+            ?? .auto
+
         // --- Port forwarding rules ---
 
         let localForwards = resolveAll("localforward")
+        let dynamicForwards = resolveAll("dynamicforward")
+        let remoteForwards = resolveAll("remoteforward")
+        let remoteRules = remoteForwards.compactMap { parseRemoteForward($0) }
         let portForwardingRules = localForwards.compactMap { parseLocalForward($0) }
+            + dynamicForwards.compactMap { parseDynamicForward($0) }
+            + remoteRules
 
-        let remoteForwards = resolveAll("remoteforward")
-        if !remoteForwards.isEmpty {
-            notes.append("RemoteForward rules found (\(remoteForwards.count)) — ProSSHMac currently supports local forwards only. Remote forwards were skipped.")
+        if remoteRules.count < remoteForwards.count {
+            notes.append("RemoteForward rules skipped (\(remoteForwards.count - remoteRules.count)) — ProSSHMac forwards remote connections to ports on this Mac only.")
         }
 
         // --- Jump host (ProxyJump) ---
@@ -218,7 +280,7 @@ struct SSHConfigMapper: Sendable {
             "addkeystoagent", "identitiesonly", "userknownhostsfile",
             "globalknownhostsfile", "stricthostkeychecking",
             "updatehostkeys", "canonicalizehostname",
-            "dynamicforward", "gatewayports", "compression",
+            "gatewayports",
             "serveralivecountmax", "serveraliveinterval",
             "connectionattempts", "connecttimeout",
             "controlmaster", "controlpath", "controlpersist"
@@ -251,6 +313,7 @@ struct SSHConfigMapper: Sendable {
             agentForwardingEnabled: agentForwarding,
             portForwardingRules: portForwardingRules,
             legacyModeEnabled: legacyMode,
+            compression: compression,
             tags: tags,
             notes: notes.isEmpty ? nil : notes.joined(separator: "\n"),
             lastConnected: nil,
@@ -263,7 +326,9 @@ struct SSHConfigMapper: Sendable {
     /// Import all concrete entries from a parse result into Host models.
     ///
     /// Processes entries in order, building up the resolution context incrementally
-    /// so that later entries can reference earlier ones as jump hosts.
+    /// so that later entries can reference earlier ones as jump hosts. Each
+    /// entry inherits from the wildcard blocks (and other blocks of the same
+    /// name) that match its label, found through `SSHConfigHostIndex`.
     func importAll(
         from parseResult: SSHConfigParseResult,
         existingHosts: [Host] = [],
@@ -274,13 +339,16 @@ struct SSHConfigMapper: Sendable {
             existingKeys: existingKeys
         )
 
-        let globalDefaults = parseResult.globalDefaults
+        let index = SSHConfigHostIndex(parseResult)
 
         var results: [MappingResult] = []
 
-        for entry in parseResult.concreteHosts {
-            let result = mapEntry(entry, globalDefaults: globalDefaults, context: context)
-            context.importedHosts.append(result.host)
+        for (position, entry) in parseResult.entries.enumerated() where entry.isConcreteHost {
+            let inherited = index.positions(matching: entry.patterns.first ?? "")
+                .filter { $0 != position }
+                .map { parseResult.entries[$0] }
+            let result = mapEntry(entry, inherited: inherited, context: context)
+            context.addImported(result.host)
             results.append(result)
         }
 
@@ -340,19 +408,7 @@ struct SSHConfigMapper: Sendable {
         }
         let cleanHost = hostPart.split(separator: ":").first.map(String.init) ?? hostPart
 
-        let allHosts = context.importedHosts + context.existingHosts
-
-        // 1. Label match.
-        if let match = allHosts.first(where: { $0.label.lowercased() == ref.lowercased() }) {
-            return match.id
-        }
-
-        // 2. Hostname match.
-        if let match = allHosts.first(where: { $0.hostname.lowercased() == cleanHost.lowercased() }) {
-            return match.id
-        }
-
-        return nil
+        return context.hostID(label: ref, hostname: cleanHost)
     }
 
     /// Parse a `LocalForward` value into a `PortForwardingRule`.
@@ -393,6 +449,58 @@ struct SSHConfigMapper: Sendable {
         )
     }
 
+    /// Parse a `DynamicForward` value into a SOCKS5 `PortForwardingRule`.
+    ///
+    /// Formats: `1080`, `127.0.0.1:1080`, `[::1]:1080`
+    private func parseDynamicForward(_ value: String) -> PortForwardingRule? {
+        let trimmed = value.trimmingCharacters(in: .whitespaces)
+        let portStr = trimmed.split(separator: ":").last.map(String.init) ?? trimmed
+        guard let port = UInt16(portStr), port > 0 else { return nil }
+        return .dynamic(localPort: port, label: "Imported: SOCKS \(port)")
+    }
+
+    /// Parse a `RemoteForward` value into a remote `PortForwardingRule`.
+    ///
+    /// Formats:
+    /// - `9090 localhost:80`
+    /// - `0.0.0.0:9090 127.0.0.1:80`
+    ///
+    /// Destinations other than this machine, socket paths, and the SOCKS form
+    /// (no destination) are not representable and return nil.
+    private func parseRemoteForward(_ value: String) -> PortForwardingRule? {
+        let parts = value.split(separator: " ", maxSplits: 1)
+            .map { $0.trimmingCharacters(in: .whitespaces) }
+        guard parts.count == 2 else { return nil }
+
+        // Server side: `port`, `addr:port` or `[addr]:port`.
+        let bindAddress: String
+        let remotePort: UInt16
+        let listenPart = parts[0]
+        if let port = UInt16(listenPart) {
+            bindAddress = ""
+            remotePort = port
+        } else {
+            guard let separator = listenPart.lastIndex(of: ":"),
+                  let port = UInt16(listenPart[listenPart.index(after: separator)...]) else { return nil }
+            bindAddress = listenPart[..<separator].trimmingCharacters(in: CharacterSet(charactersIn: "[]"))
+            remotePort = port
+        }
+        guard remotePort > 0 else { return nil }
+
+        // Local side: `host:port`, where the host must be this machine.
+        guard let separator = parts[1].lastIndex(of: ":"),
+              let localPort = UInt16(parts[1][parts[1].index(after: separator)...]), localPort > 0 else { return nil }
+        let destination = parts[1][..<separator].trimmingCharacters(in: CharacterSet(charactersIn: "[]")).lowercased()
+        guard ["localhost", "127.0.0.1", "::1"].contains(destination) else { return nil }
+
+        return .remote(
+            bindAddress: bindAddress,
+            remotePort: remotePort,
+            localPort: localPort,
+            label: "Imported: R \(remotePort) → localhost:\(localPort)"
+        )
+    }
+
     /// Try to parse a `ProxyCommand` as a jump host reference.
     ///
     /// Matches the common pattern: `ssh -W %h:%p jumphost`
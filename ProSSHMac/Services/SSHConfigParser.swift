@@ -4,13 +4,18 @@
 // Parses ~/.ssh/config into intermediate SSHConfigEntry values,
 // maps them to ProSSHMac Host models, and exports Hosts back to
 // SSH config format. Pure value types — no side effects, fully testable.
+//
+// Lines are split and tokenized as UTF-8 bytes; only keywords and
+// arguments become Strings. Files are streamed in chunks, so generated
+// configs with tens of thousands of Host blocks are never held in memory
+// as one String, and `Include` directives are expanded in place.
 
 import Foundation
 
 // MARK: - Parsed Intermediate Representation
 
 /// A single directive from an SSH config file (e.g., `HostName 10.0.0.1`).
-struct SSHConfigDirective: Equatable, Sendable {
+nonisolated struct SSHConfigDirective: Equatable, Sendable {
     let keyword: String          // Lowercased canonical form
     let originalKeyword: String  // Preserves original casing for export
     let arguments: String        // Raw argument string (not split)
@@ -19,7 +24,7 @@ struct SSHConfigDirective: Equatable, Sendable {
 
 /// One `Host` or `Match` block from an SSH config file, plus all its directives.
 /// Wildcard-only blocks (e.g., `Host *`) are captured as global defaults.
-struct SSHConfigEntry: Equatable, Sendable {
+nonisolated struct SSHConfigEntry: Equatable, Sendable {
     /// The pattern(s) from the `Host` line, e.g., ["web-*", "db-*"] or ["*"].
     let patterns: [String]
 
@@ -37,6 +42,13 @@ struct SSHConfigEntry: Equatable, Sendable {
         !isMatchBlock && patterns == ["*"]
     }
 
+    /// True for a Host block that names hosts rather than patterns.
+    var isConcreteHost: Bool {
+        !isMatchBlock
+            && !isGlobalDefaults
+            && patterns.allSatisfy { !$0.contains("*") && !$0.contains("?") }
+    }
+
     /// Look up the first directive matching a keyword (case-insensitive).
     /// SSH config uses first-match semantics — the first value wins.
     func firstValue(for keyword: String) -> String? {
@@ -52,7 +64,7 @@ struct SSHConfigEntry: Equatable, Sendable {
 }
 
 /// Result of parsing an entire SSH config file.
-struct SSHConfigParseResult: Sendable {
+nonisolated struct SSHConfigParseResult: Sendable {
     /// All Host/Match blocks, in file order.
     let entries: [SSHConfigEntry]
 
@@ -66,18 +78,29 @@ struct SSHConfigParseResult: Sendable {
 
     /// Concrete host entries (excludes wildcards and Match blocks).
     var concreteHosts: [SSHConfigEntry] {
-        entries.filter { entry in
-            !entry.isMatchBlock
-            && !entry.isGlobalDefaults
-            && entry.patterns.allSatisfy { !$0.contains("*") && !$0.contains("?") }
-        }
+        entries.filter(\.isConcreteHost)
     }
 }
 
-struct SSHConfigWarning: Sendable {
+nonisolated struct SSHConfigWarning: Sendable {
     let lineNumber: Int
     let line: String
     let reason: String
+    /// Path of the file the line came from, when parsing files.
+    var file: String? = nil
+}
+
+/// Parsing progress for file imports. `totalBytes` grows as included
+/// files are found.
+nonisolated struct SSHConfigParseProgress: Equatable, Sendable {
+    var bytesRead: Int64 = 0
+    var totalBytes: Int64 = 0
+    var filesRead = 0
+    var entries = 0
+
+    var fractionCompleted: Double {
+        totalBytes > 0 ? min(1, Double(bytesRead) / Double(totalBytes)) : 0
+    }
 }
 
 // MARK: - Parser
@@ -91,185 +114,391 @@ struct SSHConfigWarning: Sendable {
 /// - Inline comments (`# ...`)
 /// - Continuation of global scope before any Host/Match block
 /// - Case-insensitive keyword matching (SSH config is case-insensitive for keywords)
+/// - `Include` expansion when parsing files (globs, `~`, paths relative to
+///   `~/.ssh`, nested up to `IncludeOptions.maxDepth`, cycles skipped)
 ///
 /// Does NOT handle:
-/// - `Include` directive expansion (returns a warning; caller should expand before parsing)
+/// - `Include` in `parse(_:)` — string input has no file context; a warning is returned
 /// - Token expansion (`%h`, `%u`, `%p`, etc.) — done at mapping stage
 /// - `Match` condition evaluation — blocks are captured verbatim
-struct SSHConfigParser: Sendable {
+nonisolated struct SSHConfigParser: Sendable {
+
+    /// Where `Include` paths are resolved when parsing files.
+    struct IncludeOptions: Sendable {
+        /// Directory relative include paths are resolved against.
+        var baseDirectory: URL
+        /// Replaces a leading `~`.
+        var homeDirectory: URL
+        /// Nesting limit, as in OpenSSH.
+        var maxDepth = 16
+
+        /// The current user's `~/.ssh`.
+        static var user: IncludeOptions {
+            let home = URL(fileURLWithPath: NSHomeDirectory(), isDirectory: true)
+            return IncludeOptions(
+                baseDirectory: home.appendingPathComponent(".ssh", isDirectory: true),
+                homeDirectory: home
+            )
+        }
+    }
+
+    /// Bytes read from a file per step.
+    static let chunkSize = 256 << 10
 
     /// Parse the contents of an SSH config file.
     ///
     /// - Parameter contents: The full text of `~/.ssh/config`.
     /// - Returns: A `SSHConfigParseResult` with all parsed entries and any warnings.
     func parse(_ contents: String) -> SSHConfigParseResult {
-        let lines = contents.components(separatedBy: .newlines)
-        var entries: [SSHConfigEntry] = []
-        var warnings: [SSHConfigWarning] = []
-
-        // Directives before the first Host/Match line are implicitly `Host *`.
-        var currentPatterns: [String] = ["*"]
-        var currentIsMatch = false
-        var currentStartLine = 1
-        var currentDirectives: [SSHConfigDirective] = []
-        var hasExplicitBlock = false
-
-        for (index, rawLine) in lines.enumerated() {
-            let lineNumber = index + 1
-            let line = stripComment(rawLine)
-            let trimmed = line.trimmingCharacters(in: .whitespaces)
-
-            // Skip blank lines.
-            if trimmed.isEmpty { continue }
-
-            // Split into keyword + arguments.
-            guard let (keyword, arguments) = splitDirective(trimmed) else {
-                warnings.append(SSHConfigWarning(
-                    lineNumber: lineNumber,
-                    line: rawLine,
-                    reason: "Could not parse directive"
-                ))
-                continue
-            }
+        var state = ParseState(includes: nil, progress: nil)
+        var bytes = Array(contents.utf8)
+        if bytes.last != 0x0A {
+            bytes.append(0x0A)
+        }
+        var lineNumber = 0
+        // String input has no includes, so lines never throw.
+        _ = try? state.consumeLines(in: &bytes, lineNumber: &lineNumber, file: nil, depth: 0)
+        return state.finish()
+    }
 
-            let keyLower = keyword.lowercased()
-
-            // Handle block-starting keywords.
-            if keyLower == "host" || keyLower == "match" {
-                // Flush the previous block.
-                if hasExplicitBlock || !currentDirectives.isEmpty {
-                    entries.append(SSHConfigEntry(
-                        patterns: currentPatterns,
-                        isMatchBlock: currentIsMatch,
-                        directives: currentDirectives,
-                        startLine: currentStartLine
-                    ))
-                }
+    /// Stream a config file from disk, expanding `Include` directives.
+    ///
+    /// Checks for task cancellation between chunks. `progress` is called
+    /// after each chunk.
+    func parse(
+        fileAt url: URL,
+        includes: IncludeOptions = .user,
+        progress: (@Sendable (SSHConfigParseProgress) -> Void)? = nil
+    ) throws -> SSHConfigParseResult {
+        var state = ParseState(includes: includes, progress: progress)
+        state.activeFiles.insert(url.standardizedFileURL.path)
+        try state.parseFile(url, depth: 0)
+        return state.finish()
+    }
+}
 
-                currentPatterns = keyLower == "host"
-                    ? splitHostPatterns(arguments)
-                    : [arguments]  // Match keeps the full condition string
-                currentIsMatch = (keyLower == "match")
-                currentStartLine = lineNumber
-                currentDirectives = []
-                hasExplicitBlock = true
-
-                if keyLower == "match" {
-                    warnings.append(SSHConfigWarning(
-                        lineNumber: lineNumber,
-                        line: rawLine,
-                        reason: "Match blocks are captured but conditions are not evaluated"
-                    ))
-                }
-                continue
+// MARK: - Parse State
+
+private nonisolated struct ParseState {
+    let includes: SSHConfigParser.IncludeOptions?
+    let progress: (@Sendable (SSHConfigParseProgress) -> Void)?
+
+    var entries: [SSHConfigEntry] = []
+    var warnings: [SSHConfigWarning] = []
+    var activeFiles: Set<String> = []
+    var status = SSHConfigParseProgress()
+
+    // Directives before the first Host/Match line are implicitly `Host *`.
+    private var patterns: [String] = ["*"]
+    private var isMatch = false
+    private var startLine = 1
+    private var directives: [SSHConfigDirective] = []
+    private var hasExplicitBlock = false
+    /// Set for the block resumed after an Include that opened its own
+    /// blocks; it is only kept if it gets directives.
+    private var isResumedBlock = false
+    private var blocksStarted = 0
+
+    init(
+        includes: SSHConfigParser.IncludeOptions?,
+        progress: (@Sendable (SSHConfigParseProgress) -> Void)?
+    ) {
+        self.includes = includes
+        self.progress = progress
+    }
+
+    mutating func finish() -> SSHConfigParseResult {
+        flushBlock()
+        return SSHConfigParseResult(entries: entries, warnings: warnings)
+    }
+
+    // MARK: Files
+
+    mutating func parseFile(_ url: URL, depth: Int) throws {
+        let handle = try FileHandle(forReadingFrom: url)
+        defer { try? handle.close() }
+        let size = (try? url.resourceValues(forKeys: [.fileSizeKey]).fileSize) ?? 0
+        status.totalBytes += Int64(size)
+        status.filesRead += 1
+
+        let path = url.path
+        var buffer: [UInt8] = []
+        var lineNumber = 0
+        while true {
+            try Task.checkCancellation()
+            guard let chunk = try handle.read(upToCount: SSHConfigParser.chunkSize), !chunk.isEmpty else { break }
+            status.bytesRead += Int64(chunk.count)
+            buffer.append(contentsOf: chunk)
+            try consumeLines(in: &buffer, lineNumber: &lineNumber, file: path, depth: depth)
+            status.entries = entries.count
+            progress?(status)
+        }
+        if !buffer.isEmpty {
+            buffer.append(0x0A)
+            try consumeLines(in: &buffer, lineNumber: &lineNumber, file: path, depth: depth)
+        }
+    }
+
+    /// Handle every complete line in `buffer` and keep the unfinished tail.
+    mutating func consumeLines(
+        in buffer: inout [UInt8],
+        lineNumber: inout Int,
+        file: String?,
+        depth: Int
+    ) throws {
+        var lineStart = 0
+        while let newline = buffer[lineStart...].firstIndex(of: 0x0A) {
+            lineNumber += 1
+            try handleLine(buffer[lineStart..<newline], number: lineNumber, file: file, depth: depth)
+            lineStart = newline + 1
+        }
+        buffer.removeFirst(lineStart)
+    }
+
+    // MARK: Lines
+
+    private mutating func handleLine(_ raw: ArraySlice<UInt8>, number: Int, file: String?, depth: Int) throws {
+        var line = raw
+        if line.last == 0x0D {
+            line = line.dropLast()
+        }
+        line = ParseState.trimmed(ParseState.strippingComment(line))
+        if line.isEmpty { return }
+
+        // Split into keyword + arguments.
+        guard let (keyword, arguments) = ParseState.splitDirective(line) else {
+            warnings.append(SSHConfigWarning(
+                lineNumber: number,
+                line: String(decoding: raw, as: UTF8.self),
+                reason: "Could not parse directive",
+                file: file
+            ))
+            return
+        }
+
+        let keyLower = keyword.lowercased()
+
+        // Handle block-starting keywords.
+        if keyLower == "host" || keyLower == "match" {
+            flushBlock()
+            patterns = keyLower == "host"
+                ? ParseState.splitWords(arguments)
+                : [arguments]  // Match keeps the full condition string
+            if patterns.isEmpty { patterns = ["*"] }
+            isMatch = (keyLower == "match")
+            startLine = number
+            directives = []
+            hasExplicitBlock = true
+            isResumedBlock = false
+            blocksStarted += 1
+
+            if keyLower == "match" {
+                warnings.append(SSHConfigWarning(
+                    lineNumber: number,
+                    line: String(decoding: raw, as: UTF8.self),
+                    reason: "Match blocks are captured but conditions are not evaluated",
+                    file: file
+                ))
             }
+            return
+        }
 
-            // Handle Include — warn but don't expand.
-            if keyLower == "include" {
+        if keyLower == "include" {
+            guard let includes else {
                 warnings.append(SSHConfigWarning(
-                    lineNumber: lineNumber,
-                    line: rawLine,
-                    reason: "Include directive not expanded; resolve includes before parsing"
+                    lineNumber: number,
+                    line: String(decoding: raw, as: UTF8.self),
+                    reason: "Include directive not expanded; resolve includes before parsing",
+                    file: file
                 ))
-                continue
+                return
             }
+            try include(arguments, options: includes, line: raw, number: number, file: file, depth: depth)
+            return
+        }
+
+        // Regular directive — add to current block.
+        directives.append(SSHConfigDirective(
+            keyword: keyLower,
+            originalKeyword: keyword,
+            arguments: arguments,
+            lineNumber: number
+        ))
+    }
 
-            // Regular directive — add to current block.
-            currentDirectives.append(SSHConfigDirective(
-                keyword: keyLower,
-                originalKeyword: keyword,
-                arguments: arguments,
-                lineNumber: lineNumber
+    private mutating func flushBlock() {
+        let keep = !directives.isEmpty || (hasExplicitBlock && !isResumedBlock)
+        if keep {
+            entries.append(SSHConfigEntry(
+                patterns: patterns,
+                isMatchBlock: isMatch,
+                directives: directives,
+                startLine: startLine
             ))
         }
+        directives = []
+    }
 
-        // Flush the last block.
-        if hasExplicitBlock || !currentDirectives.isEmpty {
-            entries.append(SSHConfigEntry(
-                patterns: currentPatterns,
-                isMatchBlock: currentIsMatch,
-                directives: currentDirectives,
-                startLine: currentStartLine
+    // MARK: Include
+
+    /// Parse each file the Include names, in glob order, at this point.
+    /// Lines after the Include go back to the block it appeared in, as in
+    /// OpenSSH.
+    private mutating func include(
+        _ arguments: String,
+        options: SSHConfigParser.IncludeOptions,
+        line: ArraySlice<UInt8>,
+        number: Int,
+        file: String?,
+        depth: Int
+    ) throws {
+        func warn(_ reason: String) {
+            warnings.append(SSHConfigWarning(
+                lineNumber: number,
+                line: String(decoding: line, as: UTF8.self),
+                reason: reason,
+                file: file
             ))
         }
 
-        return SSHConfigParseResult(entries: entries, warnings: warnings)
+        let savedPatterns = patterns
+        let savedIsMatch = isMatch
+        let savedBlocksStarted = blocksStarted
+
+        for pattern in ParseState.splitWords(arguments) {
+            let paths = ParseState.glob(ParseState.includePath(pattern, options: options))
+            if paths.isEmpty {
+                warn("Include matched no files: \(pattern)")
+            }
+            for path in paths {
+                let url = URL(fileURLWithPath: path).standardizedFileURL
+                guard depth + 1 <= options.maxDepth else {
+                    warn("Include nested too deeply; skipped \(path)")
+                    continue
+                }
+                guard activeFiles.insert(url.path).inserted else {
+                    warn("Include cycle skipped: \(path)")
+                    continue
+                }
+                defer { activeFiles.remove(url.path) }
+                do {
+                    try parseFile(url, depth: depth + 1)
+                } catch is CancellationError {
+                    throw CancellationError()
+                } catch {
+                    warn("Include could not be read: \(path) (\(error.localizedDescription))")
+                }
+            }
+        }
+
+        if blocksStarted != savedBlocksStarted {
+            flushBlock()
+            patterns = savedPatterns
+            isMatch = savedIsMatch
+            startLine = number
+            isResumedBlock = true
+        }
+    }
+
+    private static func includePath(_ pattern: String, options: SSHConfigParser.IncludeOptions) -> String {
+        if pattern == "~" {
+            return options.homeDirectory.path
+        }
+        if pattern.hasPrefix("~/") {
+            return options.homeDirectory.appendingPathComponent(String(pattern.dropFirst(2))).path
+        }
+        if pattern.hasPrefix("/") {
+            return pattern
+        }
+        return options.baseDirectory.appendingPathComponent(pattern).path
+    }
+
+    /// Sorted paths matching a shell glob; a plain path matches itself if
+    /// it exists.
+    private static func glob(_ pattern: String) -> [String] {
+        var matches = glob_t()
+        defer { globfree(&matches) }
+        guard Darwin.glob(pattern, 0, nil, &matches) == 0 else { return [] }
+        return (0..<Int(matches.gl_pathc)).compactMap { index in
+            matches.gl_pathv[index].map { String(cString: $0) }
+        }
     }
 
-    // MARK: - Private Helpers
+    // MARK: Tokenizing
 
-    /// Strip inline comments. Respects quoted strings — `#` inside quotes is literal.
-    private func stripComment(_ line: String) -> String {
-        var inQuote = false
-        var result: [Character] = []
+    private static let space: UInt8 = 0x20
+    private static let tab: UInt8 = 0x09
+    private static let quote: UInt8 = 0x22
+    private static let hash: UInt8 = 0x23
+    private static let equals: UInt8 = 0x3D
+
+    private static func isBlank(_ byte: UInt8) -> Bool {
+        byte == space || byte == tab || byte == 0x0D || byte == 0x0B || byte == 0x0C
+    }
 
-        for char in line {
-            if char == "\"" { inQuote.toggle() }
-            if char == "#" && !inQuote { break }
-            result.append(char)
+    /// Cut an inline comment. `#` inside quotes is literal.
+    private static func strippingComment(_ line: ArraySlice<UInt8>) -> ArraySlice<UInt8> {
+        var inQuote = false
+        for index in line.indices {
+            let byte = line[index]
+            if byte == quote {
+                inQuote.toggle()
+            } else if byte == hash && !inQuote {
+                return line[line.startIndex..<index]
+            }
         }
+        return line
+    }
 
-        return String(result)
+    private static func trimmed(_ bytes: ArraySlice<UInt8>) -> ArraySlice<UInt8> {
+        var slice = bytes
+        while let first = slice.first, isBlank(first) { slice = slice.dropFirst() }
+        while let last = slice.last, isBlank(last) { slice = slice.dropLast() }
+        return slice
     }
 
     /// Split a trimmed line into (keyword, arguments).
     /// SSH config allows both `Keyword value` (space) and `Keyword=value` (equals).
-    private func splitDirective(_ trimmed: String) -> (String, String)? {
-        // Try equals-separated first: `Keyword=value`
-        if let eqIndex = trimmed.firstIndex(of: "=") {
-            let keyword = String(trimmed[trimmed.startIndex..<eqIndex])
-                .trimmingCharacters(in: .whitespaces)
-            let arguments = String(trimmed[trimmed.index(after: eqIndex)...])
-                .trimmingCharacters(in: .whitespaces)
-            guard !keyword.isEmpty else { return nil }
-            return (keyword, stripQuotes(arguments))
-        }
-
-        // Space-separated: `Keyword value`
-        guard let spaceIndex = trimmed.firstIndex(where: { $0.isWhitespace }) else {
-            // Keyword with no arguments (e.g., bare `Host` — malformed but don't crash).
-            return (trimmed, "")
+    private static func splitDirective(_ line: ArraySlice<UInt8>) -> (String, String)? {
+        let keywordEnd = line.firstIndex { isBlank($0) || $0 == equals } ?? line.endIndex
+        guard keywordEnd > line.startIndex else { return nil }
+        let keyword = String(decoding: line[line.startIndex..<keywordEnd], as: UTF8.self)
+
+        var rest = trimmed(line[keywordEnd...])
+        if rest.first == equals {
+            rest = trimmed(rest.dropFirst())
         }
-
-        let keyword = String(trimmed[trimmed.startIndex..<spaceIndex])
-        let arguments = String(trimmed[trimmed.index(after: spaceIndex)...])
-            .trimmingCharacters(in: .whitespaces)
-        return (keyword, stripQuotes(arguments))
+        return (keyword, stripQuotes(String(decoding: rest, as: UTF8.self)))
     }
 
     /// Remove surrounding quotes from a value if present.
-    private func stripQuotes(_ value: String) -> String {
+    private static func stripQuotes(_ value: String) -> String {
         if value.hasPrefix("\"") && value.hasSuffix("\"") && value.count >= 2 {
             return String(value.dropFirst().dropLast())
         }
         return value
     }
 
-    /// Split `Host` patterns — multiple patterns on one `Host` line are space-separated.
-    /// Handles quoted patterns: `Host "my server" other-server`
-    private func splitHostPatterns(_ arguments: String) -> [String] {
-        var patterns: [String] = []
-        var current = ""
+    /// Split whitespace-separated patterns or paths, honouring quotes:
+    /// `Host "my server" other-server`
+    private static func splitWords(_ arguments: String) -> [String] {
+        var words: [String] = []
+        var current: [UInt8] = []
         var inQuote = false
 
-        for char in arguments {
-            if char == "\"" {
+        for byte in arguments.utf8 {
+            if byte == quote {
                 inQuote.toggle()
                 continue
             }
-            if char.isWhitespace && !inQuote {
-                let trimmed = current.trimmingCharacters(in: .whitespaces)
-                if !trimmed.isEmpty { patterns.append(trimmed) }
-                current = ""
+            if isBlank(byte) && !inQuote {
+                if !current.isEmpty { words.append(String(decoding: current, as: UTF8.self)) }
+                current.removeAll(keepingCapacity: true)
                 continue
             }
-            current.append(char)
+            current.append(byte)
         }
-
-        let trimmed = current.trimmingCharacters(in: .whitespaces)
-        if !trimmed.isEmpty { patterns.append(trimmed) }
-
-        return patterns.isEmpty ? ["*"] : patterns
+        if !current.isEmpty { words.append(String(decoding: current, as: UTF8.self)) }
+        return words
     }
 }
-
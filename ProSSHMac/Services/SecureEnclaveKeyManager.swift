@@ -44,7 +44,7 @@ enum SecureEnclaveKeyManagerError: LocalizedError {
     }
 }
 
-nonisolated final class SecureEnclaveKeyManager {
+nonisolated final class SecureEnclaveKeyManager: Sendable {
     func generateP256Key(tag: String, comment: String) throws -> SecureEnclaveGeneratedKey {
 #if targetEnvironment(simulator)
         throw SecureEnclaveKeyManagerError.unavailableOnSimulator
@@ -137,8 +137,50 @@ nonisolated final class SecureEnclaveKeyManager {
 #if targetEnvironment(simulator)
         throw SecureEnclaveKeyManagerError.unavailableOnSimulator
 #else
-        let privateKey = try findPrivateKey(tag: tag)
+        return try sshSignature(for: payload, privateKey: findPrivateKey(tag: tag))
+#endif
+    }
+
+    /// Sign many certificate payloads with one CA key, returning signatures
+    /// in payload order. The key is looked up once for the whole batch, and
+    /// the payloads are split round-robin across `workerCount` tasks. The
+    /// first failure cancels the rest and is thrown.
+    func signSSHCertificatePayloads(
+        _ payloads: [Data],
+        tag: String,
+        workerCount: Int = max(ProcessInfo.processInfo.activeProcessorCount - 1, 1)
+    ) async throws -> [Data] {
+#if targetEnvironment(simulator)
+        throw SecureEnclaveKeyManagerError.unavailableOnSimulator
+#else
+        guard !payloads.isEmpty else { return [] }
+        let key = SigningKey(privateKey: try findPrivateKey(tag: tag))
+        let shardCount = max(min(workerCount, payloads.count), 1)
+
+        return try await withThrowingTaskGroup(of: [(index: Int, signature: Data)].self) { group in
+            for shard in 0..<shardCount {
+                group.addTask {
+                    var signed: [(index: Int, signature: Data)] = []
+                    for index in stride(from: shard, to: payloads.count, by: shardCount) {
+                        try Task.checkCancellation()
+                        signed.append((index, try self.sshSignature(for: payloads[index], privateKey: key.privateKey)))
+                    }
+                    return signed
+                }
+            }
 
+            var signatures = [Data](repeating: Data(), count: payloads.count)
+            for try await shard in group {
+                for entry in shard {
+                    signatures[entry.index] = entry.signature
+                }
+            }
+            return signatures
+        }
+#endif
+    }
+
+    private func sshSignature(for payload: Data, privateKey: SecKey) throws -> Data {
         var signingError: Unmanaged<CFError>?
         guard let derSignature = SecKeyCreateSignature(
             privateKey,
@@ -158,7 +200,6 @@ nonisolated final class SecureEnclaveKeyManager {
         sshSignature.append(sshString(Data("ecdsa-sha2-nistp256".utf8)))
         sshSignature.append(sshString(inner))
         return sshSignature
-#endif
     }
 
     private func sshString(_ data: Data) -> Data {
@@ -273,3 +314,9 @@ nonisolated final class SecureEnclaveKeyManager {
             .map { ($0 as Error).localizedDescription }
     }
 }
+
+/// A Secure Enclave key reference shared by the batch signing workers;
+/// SecKey operations are thread-safe.
+private nonisolated struct SigningKey: @unchecked Sendable {
+    let privateKey: SecKey
+}
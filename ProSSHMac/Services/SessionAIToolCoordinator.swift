@@ -3,6 +3,9 @@ import Foundation
 
 @MainActor final class SessionAIToolCoordinator {
     weak var manager: SessionManager?
+    /// Sessions whose server refused an exec channel (e.g. `MaxSessions 1`);
+    /// their tool commands go through the shell without retrying.
+    private var execUnavailableSessionIDs: Set<UUID> = []
 
     init() {}
 
@@ -33,7 +36,7 @@ import Foundation
             let payload = wrappedCommand + "\n"
             try await shell.send(payload)
             manager.lastActivityBySessionID[sessionID] = .now
-            manager.bytesSentBySessionID[sessionID, default: 0] += Int64(payload.utf8.count)
+            manager.liveState(for: sessionID).addSentBytes(payload.utf8.count)
             manager.recordingCoordinator.recordInput(sessionID: sessionID, text: payload)
             await manager.terminalHistoryIndex.recordCommandInput(
                 sessionID: sessionID,
@@ -47,7 +50,7 @@ import Foundation
 
         let deadline = Date().addingTimeInterval(timeoutSeconds)
         while Date() < deadline {
-            if let visibleLines = manager.shellBuffers[sessionID], !visibleLines.isEmpty {
+            if let visibleLines = manager.liveStates[sessionID]?.shellBuffer, !visibleLines.isEmpty {
                 let screenText = visibleLines.joined(separator: "\n")
                 if screenText.contains(marker) {
                     let parsed = parseWrappedCommandOutput(screenText, marker: marker)
@@ -75,12 +78,8 @@ import Foundation
                 }
             }
 
-            let blocks = await manager.terminalHistoryIndex.searchCommands(
-                sessionID: sessionID,
-                query: marker,
-                limit: 8
-            )
-            if let block = blocks.first(where: { $0.output.contains(marker) }) {
+            if let block = await manager.terminalHistoryIndex.commandBlock(sessionID: sessionID, marker: marker),
+               block.output.contains(marker) {
                 let parsed = parseWrappedCommandOutput(block.output, marker: marker)
                 if parsed.exitCode != nil {
                     return CommandExecutionResult(
@@ -103,6 +102,185 @@ import Foundation
         return CommandExecutionResult(output: "", exitCode: nil, timedOut: true, blockID: nil)
     }
 
+    /// Runs a tool command on its own exec channel: nothing is typed into the
+    /// user's shell, and output and exit status come straight from the channel
+    /// instead of being scraped from the terminal. The command runs under
+    /// `sh -c` in the shell's last known working directory. Returns nil for
+    /// local sessions and when the server will not open an exec channel, so
+    /// the caller can fall back to the shell.
+    func executeOutOfBand(
+        sessionID: UUID,
+        command: String,
+        timeoutSeconds: TimeInterval
+    ) async -> CommandExecutionResult? {
+        guard let manager, !execUnavailableSessionIDs.contains(sessionID),
+              let session = manager.sessions.first(where: { $0.id == sessionID && $0.state == .connected }),
+              !session.isLocal else {
+            return nil
+        }
+
+        var script = command
+        if let directory = manager.liveStates[sessionID]?.workingDirectory, !directory.isEmpty {
+            script = "cd \(Self.shellPath(directory)) 2>/dev/null; " + script
+        }
+
+        let events: AsyncThrowingStream<SSHExecEvent, Error>
+        do {
+            events = try await manager.transport.runCommand(
+                sessionID: sessionID,
+                command: "sh -c " + AIToolHandler.shellSingleQuoted(script)
+            )
+        } catch {
+            execUnavailableSessionIDs.insert(sessionID)
+            return nil
+        }
+        let capture = await Self.capture(events, timeout: .milliseconds(Int(timeoutSeconds * 1000)))
+
+        // The terminal path saw both streams interleaved; keep stderr after
+        // stdout so parsers get the same text.
+        var output = capture.stdout.text
+        if capture.stderr.byteCount > 0 {
+            if !output.isEmpty, !output.hasSuffix("\n") {
+                output += "\n"
+            }
+            output += capture.stderr.text
+        }
+        manager.lastActivityBySessionID[sessionID] = .now
+        return CommandExecutionResult(
+            output: output.trimmingCharacters(in: .whitespacesAndNewlines),
+            exitCode: capture.exitCode,
+            timedOut: capture.timedOut,
+            blockID: nil
+        )
+    }
+
+    nonisolated struct OutOfBandCapture: Sendable {
+        var stdout = ToolOutputRing(headLimit: 1024 * 1024, tailLimit: 64 * 1024)
+        var stderr = ToolOutputRing(headLimit: 32 * 1024, tailLimit: 32 * 1024)
+        var exitCode: Int?
+        var timedOut = false
+    }
+
+    /// Reads an exec channel's output into bounded rings as it arrives, so a
+    /// command that prints megabytes costs the same memory as one that
+    /// prints a page. The tail is kept, since read and search commands put
+    /// their trailers last. On timeout the channel is closed and whatever
+    /// arrived so far is returned with `timedOut` set.
+    nonisolated static func capture(
+        _ events: AsyncThrowingStream<SSHExecEvent, Error>,
+        timeout: Duration
+    ) async -> OutOfBandCapture {
+        await withTaskGroup(of: OutOfBandCapture?.self) { group in
+            group.addTask {
+                var capture = OutOfBandCapture()
+                do {
+                    for try await event in events {
+                        switch event {
+                        case .stdout(let data):
+                            capture.stdout.append(data)
+                        case .stderr(let data):
+                            capture.stderr.append(data)
+                        case .exit(let code):
+                            capture.exitCode = code
+                        }
+                    }
+                } catch {
+                    if capture.stderr.byteCount == 0 {
+                        capture.stderr.append(Data(error.localizedDescription.utf8))
+                    }
+                }
+                return capture
+            }
+            group.addTask {
+                try? await Task.sleep(for: timeout)
+                return nil
+            }
+            let first = await group.next() ?? nil
+            group.cancelAll()
+            if let first {
+                return first
+            }
+            // The deadline won. Cancelling ends the stream, and the reader
+            // returns what it had.
+            var partial = (await group.next() ?? nil) ?? OutOfBandCapture()
+            partial.timedOut = true
+            return partial
+        }
+    }
+
+    /// Writes a tool's file through SFTP instead of a shell command carrying
+    /// the whole content. An exec command checks that the file is writable
+    /// and resolves its absolute path; the content is uploaded in chunks to a
+    /// temporary file beside it, which a second exec command gives the
+    /// file's mode and renames over it. SFTP needs no shell quoting, so the
+    /// upload is the file's size rather than its base64 encoding. Returns
+    /// nil when exec or SFTP is unavailable or the path is a symlink, so the
+    /// caller can write through the shell; a file that is not writable comes
+    /// back as a failed write.
+    func writeFileOutOfBand(
+        sessionID: UUID,
+        path: String,
+        content: String,
+        timeoutSeconds: TimeInterval
+    ) async -> CommandExecutionResult? {
+        guard let prepared = await executeOutOfBand(
+            sessionID: sessionID,
+            command: RemotePatchCommandBuilder.buildUploadPrepareCommand(path: path),
+            timeoutSeconds: timeoutSeconds
+        ) else {
+            return nil
+        }
+        guard prepared.exitCode == 0 else {
+            return prepared
+        }
+        guard let target = RemotePatchCommandBuilder.parseUploadTarget(prepared.output),
+              let manager else {
+            return nil
+        }
+
+        let temporary = RemotePatchCommandBuilder.temporaryUploadPath(for: target)
+        let localURL = FileManager.default.temporaryDirectory
+            .appendingPathComponent("prossh-upload-\(UUID().uuidString)")
+        defer { try? FileManager.default.removeItem(at: localURL) }
+        do {
+            try Data(content.utf8).write(to: localURL)
+            _ = try await manager.transport.uploadFile(
+                sessionID: sessionID,
+                localPath: localURL.path,
+                remotePath: temporary,
+                progressHandler: nil
+            )
+        } catch {
+            _ = await executeOutOfBand(
+                sessionID: sessionID,
+                command: RemotePatchCommandBuilder.buildUploadCleanupCommand(temporaryPath: temporary),
+                timeoutSeconds: 5
+            )
+            return nil
+        }
+
+        return await executeOutOfBand(
+            sessionID: sessionID,
+            command: RemotePatchCommandBuilder.buildUploadCommitCommand(temporaryPath: temporary, path: target),
+            timeoutSeconds: timeoutSeconds
+        )
+    }
+
+    func forgetExecAvailability(sessionID: UUID) {
+        execUnavailableSessionIDs.remove(sessionID)
+    }
+
+    /// Quotes a directory for `cd`, keeping a leading `~` expandable.
+    static func shellPath(_ directory: String) -> String {
+        if directory == "~" {
+            return "\"$HOME\""
+        }
+        if directory.hasPrefix("~/") {
+            return "\"$HOME\"/" + AIToolHandler.shellSingleQuoted(String(directory.dropFirst(2)))
+        }
+        return AIToolHandler.shellSingleQuoted(directory)
+    }
+
     private func parseWrappedCommandOutput(_ output: String, marker: String) -> (output: String, exitCode: Int?) {
         let normalized = output
             .replacingOccurrences(of: "\r\n", with: "\n")
@@ -127,7 +305,8 @@ import Foundation
             return
         }
         manager.latestPublishedCommandBlockIDBySessionID[sessionID] = block.id
-        manager.latestCompletedCommandBlockBySessionID[sessionID] = block
-        manager.commandCompletionNonceBySessionID[sessionID, default: 0] += 1
+        let live = manager.liveState(for: sessionID)
+        live.latestCompletedCommandBlock = block
+        live.commandCompletionNonce = (live.commandCompletionNonce ?? 0) + 1
     }
 }
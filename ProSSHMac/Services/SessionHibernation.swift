@@ -0,0 +1,39 @@
+// SessionHibernation.swift
+// ProSSHV2
+//
+// Hibernation of idle background sessions. A tab nobody has looked at for
+// a while still held everything needed to draw it: two snapshot buffers,
+// decoded scrollback rows and an uncompressed scrollback tail of up to
+// 1,280 lines. Twenty such tabs add up. Renderers are not the problem:
+// a hidden tab's surface is already torn down and glyph atlases are shared
+// through GlyphAtlasStore.
+//
+// Once a session has been hidden with no output for `idleInterval`,
+// TerminalRenderingCoordinator hibernates it:
+// - `TerminalEngine.hibernate()` drops the snapshot buffers and row cache
+//   and compacts the scrollback into compressed pages;
+// - publishes skip the snapshot and keep only housekeeping (bells, title,
+//   working directory, command completion), so the parser consumes output
+//   as usual without rebuilding buffers nobody reads.
+// Showing the session again wakes it: the last stored snapshot seeds the
+// pane immediately and a full snapshot is published right after.
+// Memory pressure hibernates every hidden session without waiting.
+
+import Foundation
+
+nonisolated struct SessionHibernationPolicy: Sendable {
+
+    static let defaultIdleInterval: TimeInterval = 10 * 60
+
+    /// How often hidden sessions are checked.
+    static let sweepInterval: Duration = .seconds(60)
+
+    /// Time hidden and without output before a session hibernates.
+    var idleInterval: TimeInterval = defaultIdleInterval
+
+    /// Whether a session at `tier`, whose last output or hiding was at
+    /// `lastActivityAt`, should hibernate at `now`.
+    func shouldHibernate(tier: SessionRenderTier, lastActivityAt: Date, now: Date) -> Bool {
+        tier == .hidden && now.timeIntervalSince(lastActivityAt) >= idleInterval
+    }
+}
@@ -1,60 +1,52 @@
 // Extracted from SessionManager.swift
 import Foundation
 
+/// Main-actor front for `SessionKeepaliveScheduler`. Sessions are registered
+/// when their shell opens and dropped when they end; the deadlines, probes,
+/// and interval adaptation all run off the main actor. Only a dead peer hops
+/// back here, to end the session through the manager.
 @MainActor final class SessionKeepaliveCoordinator {
     weak var manager: SessionManager?
-    var keepaliveTask: Task<Void, Never>?
+    private(set) var scheduler: SessionKeepaliveScheduler?
 
     private var keepaliveEnabled: Bool {
         UserDefaults.standard.bool(forKey: "ssh.keepalive.enabled")
     }
 
-    private var keepaliveInterval: TimeInterval {
+    private nonisolated static func configuredInterval() -> Int {
         let stored = UserDefaults.standard.integer(forKey: "ssh.keepalive.interval")
-        return stored > 0 ? TimeInterval(stored) : 30
+        return stored > 0 ? stored : 30
     }
 
     init() {}
 
     nonisolated deinit {}
 
-    func startIfNeeded() {
-        guard keepaliveEnabled, keepaliveTask == nil else { return }
-        keepaliveTask = Task { @MainActor [weak self] in
-            while !Task.isCancelled {
-                try? await Task.sleep(for: .seconds(self?.keepaliveInterval ?? 30))
-                guard !Task.isCancelled else { break }
-                await self?.sendKeepalives()
-            }
+    func startIfNeeded(sessionID: UUID, hostKey: String) {
+        guard keepaliveEnabled, let manager else { return }
+        let scheduler = self.scheduler ?? makeScheduler(transport: manager.transport)
+        self.scheduler = scheduler
+        Task {
+            await scheduler.track(sessionID, hostKey: hostKey)
         }
     }
 
-    func stopIfIdle() {
-        guard let manager else {
-            keepaliveTask?.cancel()
-            keepaliveTask = nil
-            return
-        }
-        let hasConnectedSSHSession = manager.sessions.contains { $0.state == .connected && !$0.isLocal }
-        if !hasConnectedSSHSession {
-            keepaliveTask?.cancel()
-            keepaliveTask = nil
+    func stopTracking(sessionID: UUID) {
+        guard let scheduler else { return }
+        Task {
+            await scheduler.untrack(sessionID)
         }
     }
 
-    private func sendKeepalives() async {
-        guard let manager else { return }
-        let connectedSSHSessions = manager.sessions.filter { $0.state == .connected && !$0.isLocal }
-        for session in connectedSSHSessions {
-            let lastActivity = manager.lastActivityBySessionID[session.id] ?? .distantPast
-            if Date.now.timeIntervalSince(lastActivity) < keepaliveInterval * 0.8 {
-                continue
+    private func makeScheduler(transport: any SSHTransporting) -> SessionKeepaliveScheduler {
+        SessionKeepaliveScheduler(
+            configuredInterval: { Self.configuredInterval() },
+            probe: { sessionID, deadPeerTimeout in
+                await transport.sendKeepalive(sessionID: sessionID, deadPeerTimeout: deadPeerTimeout)
+            },
+            onDeadPeer: { @MainActor [weak self] sessionID in
+                await self?.manager?.handleShellStreamEndedInternal(sessionID: sessionID)
             }
-
-            let alive = await manager.transport.sendKeepalive(sessionID: session.id)
-            if !alive {
-                await manager.handleShellStreamEndedInternal(sessionID: session.id)
-            }
-        }
+        )
     }
 }
@@ -0,0 +1,157 @@
+import Foundation
+
+/// Per-session keepalive deadlines on one `KeepaliveTimerWheel`, run off the
+/// main actor.
+///
+/// - A single task sleeps until the earliest deadline, so there are no wakeups
+///   between keepalives beyond the ones that send something.
+/// - Due probes run concurrently and report back independently. A peer stuck in
+///   a long TCP timeout delays only its own next deadline.
+/// - A connection that moved packets since its last check is rescheduled
+///   without a probe (`SSHKeepaliveResult.active`).
+/// - The interval adapts per host. When a probe finds a connection dead, the
+///   time since its last good check is taken as the path's NAT/firewall idle
+///   timeout, and sessions to that host then probe at half of it. The
+///   configured interval stays the ceiling.
+nonisolated actor SessionKeepaliveScheduler {
+    typealias Probe = @Sendable (_ sessionID: UUID, _ deadPeerTimeout: Int) async -> SSHKeepaliveResult
+    typealias DeadPeerHandler = @Sendable (_ sessionID: UUID) async -> Void
+
+    /// Floor for adapted intervals, in seconds.
+    static let minimumInterval = 10
+
+    private struct Tracked {
+        let hostKey: String
+        /// Tick of the last check that found the connection alive.
+        var lastAliveTick: Int
+    }
+
+    private let configuredInterval: @Sendable () -> Int
+    private let probe: Probe
+    private let onDeadPeer: DeadPeerHandler
+    private let clock = ContinuousClock()
+    private let origin: ContinuousClock.Instant
+
+    private var wheel = KeepaliveTimerWheel()
+    private var tracked: [UUID: Tracked] = [:]
+    private var inFlight: Set<UUID> = []
+    /// Shortest idle gap after which a connection to the host was found dead.
+    private var observedIdleTimeouts: [String: Int] = [:]
+    private var runner: Task<Void, Never>?
+    private var runnerWakeTick: Int?
+
+    init(
+        configuredInterval: @escaping @Sendable () -> Int,
+        probe: @escaping Probe,
+        onDeadPeer: @escaping DeadPeerHandler
+    ) {
+        self.configuredInterval = configuredInterval
+        self.probe = probe
+        self.onDeadPeer = onDeadPeer
+        self.origin = clock.now
+    }
+
+    var trackedSessionIDs: Set<UUID> { Set(tracked.keys) }
+
+    var isRunning: Bool { runner != nil }
+
+    func track(_ sessionID: UUID, hostKey: String) {
+        let now = currentTick
+        tracked[sessionID] = Tracked(hostKey: hostKey, lastAliveTick: now)
+        wheel.schedule(sessionID, at: now + interval(forHost: hostKey))
+        rearm()
+    }
+
+    func untrack(_ sessionID: UUID) {
+        tracked.removeValue(forKey: sessionID)
+        wheel.remove(sessionID)
+        rearm()
+    }
+
+    func untrackAll() {
+        tracked.removeAll()
+        wheel = KeepaliveTimerWheel(startTick: currentTick)
+        rearm()
+    }
+
+    func interval(forHost hostKey: String) -> Int {
+        Self.adaptedInterval(
+            configured: configuredInterval(),
+            observedIdleTimeout: observedIdleTimeouts[hostKey]
+        )
+    }
+
+    static func adaptedInterval(configured: Int, observedIdleTimeout: Int?) -> Int {
+        let configured = max(minimumInterval, configured)
+        guard let observedIdleTimeout else { return configured }
+        return min(configured, max(minimumInterval, observedIdleTimeout / 2))
+    }
+
+    // MARK: - Wheel driving
+
+    private var currentTick: Int {
+        Int(((clock.now - origin) / .seconds(1)).rounded(.down))
+    }
+
+    /// Keeps exactly one sleeper aimed at the earliest deadline.
+    private func rearm() {
+        guard let next = wheel.nextDeadline else {
+            runner?.cancel()
+            runner = nil
+            runnerWakeTick = nil
+            return
+        }
+        if runner != nil, let wake = runnerWakeTick, wake <= next {
+            return
+        }
+        runner?.cancel()
+        runnerWakeTick = next
+        let deadline = origin + .seconds(next)
+        runner = Task { [weak self] in
+            try? await Task.sleep(until: deadline, clock: .continuous)
+            guard !Task.isCancelled else { return }
+            await self?.fireDueProbes(through: next)
+        }
+    }
+
+    private func fireDueProbes(through tick: Int) {
+        runner = nil
+        runnerWakeTick = nil
+        // The sleep may end a hair early; the deadline it aimed at is due.
+        for sessionID in wheel.advance(to: max(currentTick, tick)) {
+            guard let session = tracked[sessionID], !inFlight.contains(sessionID) else { continue }
+            inFlight.insert(sessionID)
+            // An unacknowledged probe may hang for one interval before the
+            // kernel gives up on the connection.
+            let deadPeerTimeout = interval(forHost: session.hostKey)
+            let probe = self.probe
+            Task { [weak self] in
+                let result = await probe(sessionID, deadPeerTimeout)
+                await self?.complete(sessionID, result: result)
+            }
+        }
+        rearm()
+    }
+
+    private func complete(_ sessionID: UUID, result: SSHKeepaliveResult) async {
+        inFlight.remove(sessionID)
+        guard var session = tracked[sessionID] else { return }
+        let now = currentTick
+
+        guard result != .dead else {
+            let idle = now - session.lastAliveTick
+            if idle > 0 {
+                observedIdleTimeouts[session.hostKey] = min(observedIdleTimeouts[session.hostKey] ?? idle, idle)
+            }
+            tracked.removeValue(forKey: sessionID)
+            rearm()
+            await onDeadPeer(sessionID)
+            return
+        }
+
+        session.lastAliveTick = now
+        tracked[sessionID] = session
+        wheel.schedule(sessionID, at: now + interval(forHost: session.hostKey))
+        rearm()
+    }
+}
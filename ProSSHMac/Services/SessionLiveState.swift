@@ -0,0 +1,116 @@
+// SessionLiveState.swift
+// ProSSHV2
+//
+// The per-session values that change while a session streams: visible
+// text, links, snapshot and bell nonces, input modes, title, working
+// directory, scroll position, playback progress, a large paste's progress,
+// host metrics, the last finished command and traffic. They used to be `@Published` dictionaries on SessionManager.
+// Every parsed chunk and snapshot publish then fired the manager's
+// `objectWillChange`, so one busy session re-evaluated every pane, tab,
+// sidebar and the host list.
+//
+// Each session now has one `@Observable` object. A view that reads a
+// property of a session's state is invalidated only when that property of
+// that session changes. SessionManager's dictionaries remain as computed
+// views over these objects for code that is not a view. Views should read
+// `SessionManager.liveState(for:)` instead, because a dictionary read
+// touches every session.
+//
+// Traffic is counted exactly on every chunk, outside observation. Views
+// see `sampledTraffic`, republished at most every `trafficSampleInterval`.
+
+import Foundation
+import Observation
+
+/// Bytes received and sent by one session.
+struct SessionTraffic: Equatable, Sendable {
+    var received: Int64 = 0
+    var sent: Int64 = 0
+}
+
+/// How far a streaming paste has got, in pasteboard bytes.
+struct PasteProgress: Equatable, Sendable {
+    var sentBytes: Int
+    var totalBytes: Int
+
+    var fraction: Double {
+        totalBytes > 0 ? Double(sentBytes) / Double(totalBytes) : 1
+    }
+}
+
+@Observable
+final class SessionLiveState {
+
+    /// How often traffic counters reach views while a session streams.
+    static let trafficSampleInterval: Duration = .milliseconds(250)
+
+    var shellBuffer: [String]?
+    /// Links found in `shellBuffer`, updated in the background.
+    var detectedLinks: TerminalLinkRows?
+    var bellEventNonce: Int?
+    var inputModeSnapshot: InputModeSnapshot?
+    var gridSnapshotNonce: Int?
+    var windowTitle: String?
+    var workingDirectory: String?
+    var playbackProgress: SessionPlaybackProgress?
+    var latestCompletedCommandBlock: CommandBlock?
+    var commandCompletionNonce: Int?
+    var scrollState: TerminalScrollState?
+    /// Set while a paste too large to send at once is streaming.
+    var pasteProgress: PasteProgress?
+    /// The latest host sample, while SessionMetricsCoordinator samples.
+    var hostMetrics: RemoteHostMetrics?
+
+    /// Traffic as of the last sample.
+    private(set) var sampledTraffic = SessionTraffic()
+
+    @ObservationIgnored var bytesReceived: Int64? {
+        didSet { scheduleTrafficSample() }
+    }
+
+    @ObservationIgnored var bytesSent: Int64? {
+        didSet { scheduleTrafficSample() }
+    }
+
+    @ObservationIgnored private var isTrafficSampleScheduled = false
+
+    /// Exact traffic, for callers that are not views.
+    var traffic: SessionTraffic {
+        SessionTraffic(received: bytesReceived ?? 0, sent: bytesSent ?? 0)
+    }
+
+    /// Assign `value` only if it differs, since every assignment to an
+    /// observed property invalidates the views reading it.
+    func update<Value: Equatable>(_ keyPath: ReferenceWritableKeyPath<SessionLiveState, Value?>, to value: Value?) {
+        if self[keyPath: keyPath] != value {
+            self[keyPath: keyPath] = value
+        }
+    }
+
+    func addReceivedBytes(_ count: Int) {
+        bytesReceived = (bytesReceived ?? 0) + Int64(count)
+    }
+
+    func addSentBytes(_ count: Int) {
+        bytesSent = (bytesSent ?? 0) + Int64(count)
+    }
+
+    /// Publish the current traffic now instead of at the next sample.
+    func sampleTraffic() {
+        let current = traffic
+        if sampledTraffic != current {
+            sampledTraffic = current
+        }
+    }
+
+    private func scheduleTrafficSample() {
+        guard !isTrafficSampleScheduled else { return }
+        isTrafficSampleScheduled = true
+        Task { @MainActor [weak self] in
+            try? await Task.sleep(for: Self.trafficSampleInterval)
+            guard let self else { return }
+            self.isTrafficSampleScheduled = false
+            self.sampleTraffic()
+        }
+    }
+}
@@ -0,0 +1,85 @@
+// SessionLogCoordinator.swift
+// ProSSHV2
+//
+// Opens a continuous log (see SessionLog) for each session whose parser
+// reader starts while logging is on, and closes it when the session ends.
+// A reconnect starts a new reader and so a new log directory under the new
+// session ID. Reads go through `archive` off the main actor.
+//
+// Toggle via: `defaults write com.prossh terminal.sessionLog.enabled -bool true`
+
+import Foundation
+
+@MainActor final class SessionLogCoordinator {
+    weak var manager: SessionManager?
+
+    static let enabledDefaultsKey = "terminal.sessionLog.enabled"
+
+    static var isEnabled: Bool {
+        UserDefaults.standard.bool(forKey: enabledDefaultsKey)
+    }
+
+    let archive: SessionLogArchive
+    private var sinksBySessionID: [UUID: SessionLogSink] = [:]
+
+    init(archive: SessionLogArchive = SessionLogArchive()) {
+        self.archive = archive
+    }
+
+    nonisolated deinit {}
+
+    /// The log the session's output goes to, opened on first use; nil
+    /// while logging is off.
+    func sink(for sessionID: UUID) -> SessionLogSink? {
+        if let sink = sinksBySessionID[sessionID] {
+            return sink
+        }
+        guard Self.isEnabled,
+              let session = manager?.sessions.first(where: { $0.id == sessionID }) else { return nil }
+        let sink = archive.open(SessionLogSink.Origin(
+            sessionID: sessionID,
+            hostLabel: session.hostLabel,
+            username: session.username,
+            hostname: session.hostname,
+            port: session.port
+        ))
+        sinksBySessionID[sessionID] = sink
+        return sink
+    }
+
+    func sessionEnded(_ sessionID: UUID) {
+        sinksBySessionID.removeValue(forKey: sessionID)?.finish()
+    }
+
+    // MARK: - Queries
+
+    /// The output logged for a persisted command, as text.
+    func transcript(of entry: CommandHistoryEntry) async -> String? {
+        let archive = archive
+        return await Task.detached(priority: .userInitiated) {
+            guard let data = try? archive.transcript(
+                sessionID: entry.sessionID,
+                from: entry.startedAt,
+                to: entry.completedAt
+            ), !data.isEmpty else { return nil }
+            return String(decoding: data, as: UTF8.self)
+        }.value
+    }
+
+    /// Logged lines containing `text`, newest first.
+    func search(_ text: String, sessionID: UUID? = nil, limit: Int = 50) async -> [SessionLogMatch] {
+        let archive = archive
+        return await Task.detached(priority: .userInitiated) {
+            archive.search(text, sessionID: sessionID, limit: limit)
+        }.value
+    }
+}
+
+// MARK: - MemoryFootprintReporting
+
+extension SessionLogCoordinator: MemoryFootprintReporting {
+    /// Output queued for the log and not yet written.
+    func memoryFootprint(for sessionID: UUID) -> MemoryFootprint {
+        MemoryFootprint(.recorder, bytes: sinksBySessionID[sessionID]?.queuedByteCount ?? 0)
+    }
+}
@@ -0,0 +1,103 @@
+// Extracted from SessionManager.swift
+//
+// Dictionary views over each session's SessionLiveState, for code that is
+// not a view: coordinators, the AI tools and tests. Reading one touches
+// every session's state, so views use `liveState(for:)` and read only the
+// session they show. Setting one writes only the values that changed.
+import Foundation
+
+extension SessionManager {
+
+    /// The session's observable state, created on first use and dropped
+    /// when the session is removed.
+    func liveState(for sessionID: UUID) -> SessionLiveState {
+        if let state = liveStates[sessionID] {
+            return state
+        }
+        let state = SessionLiveState()
+        liveStates[sessionID] = state
+        return state
+    }
+
+    var shellBuffers: [UUID: [String]] {
+        get { liveValues(\.shellBuffer) }
+        set { setLiveValues(newValue, \.shellBuffer) }
+    }
+
+    /// Links found in `shellBuffers`, updated in the background.
+    var detectedLinksBySessionID: [UUID: TerminalLinkRows] {
+        liveValues(\.detectedLinks)
+    }
+
+    var bellEventNonceBySessionID: [UUID: Int] {
+        get { liveValues(\.bellEventNonce) }
+        set { setLiveValues(newValue, \.bellEventNonce) }
+    }
+
+    var inputModeSnapshotsBySessionID: [UUID: InputModeSnapshot] {
+        get { liveValues(\.inputModeSnapshot) }
+        set { setLiveValues(newValue, \.inputModeSnapshot) }
+    }
+
+    var gridSnapshotNonceBySessionID: [UUID: Int] {
+        get { liveValues(\.gridSnapshotNonce) }
+        set { setLiveValues(newValue, \.gridSnapshotNonce) }
+    }
+
+    var windowTitleBySessionID: [UUID: String] {
+        get { liveValues(\.windowTitle) }
+        set { setLiveValues(newValue, \.windowTitle) }
+    }
+
+    var workingDirectoryBySessionID: [UUID: String] {
+        get { liveValues(\.workingDirectory) }
+        set { setLiveValues(newValue, \.workingDirectory) }
+    }
+
+    var playbackProgressBySessionID: [UUID: SessionPlaybackProgress] {
+        get { liveValues(\.playbackProgress) }
+        set { setLiveValues(newValue, \.playbackProgress) }
+    }
+
+    var latestCompletedCommandBlockBySessionID: [UUID: CommandBlock] {
+        get { liveValues(\.latestCompletedCommandBlock) }
+        set { setLiveValues(newValue, \.latestCompletedCommandBlock) }
+    }
+
+    var commandCompletionNonceBySessionID: [UUID: Int] {
+        get { liveValues(\.commandCompletionNonce) }
+        set { setLiveValues(newValue, \.commandCompletionNonce) }
+    }
+
+    var scrollStateBySessionID: [UUID: TerminalScrollState] {
+        get { liveValues(\.scrollState) }
+        set { setLiveValues(newValue, \.scrollState) }
+    }
+
+    /// Exact counts; views read `SessionLiveState.sampledTraffic`.
+    var bytesReceivedBySessionID: [UUID: Int64] {
+        get { liveValues(\.bytesReceived) }
+        set { setLiveValues(newValue, \.bytesReceived) }
+    }
+
+    var bytesSentBySessionID: [UUID: Int64] {
+        get { liveValues(\.bytesSent) }
+        set { setLiveValues(newValue, \.bytesSent) }
+    }
+
+    private func liveValues<Value>(_ keyPath: KeyPath<SessionLiveState, Value?>) -> [UUID: Value] {
+        liveStates.compactMapValues { $0[keyPath: keyPath] }
+    }
+
+    private func setLiveValues<Value: Equatable>(
+        _ values: [UUID: Value],
+        _ keyPath: ReferenceWritableKeyPath<SessionLiveState, Value?>
+    ) {
+        for (sessionID, state) in liveStates where values[sessionID] == nil && state[keyPath: keyPath] != nil {
+            state[keyPath: keyPath] = nil
+        }
+        for (sessionID, value) in values {
+            liveState(for: sessionID).update(keyPath, to: value)
+        }
+    }
+}
@@ -0,0 +1,72 @@
+// SessionManager+MemoryFootprint.swift
+// ProSSHV2
+//
+// Adds up what each subsystem reports through MemoryFootprintReporting,
+// and gives memory back when the system reports memory pressure.
+
+import Foundation
+import os.log
+
+extension SessionManager {
+
+    /// Scrollback lines each session keeps after critical memory pressure.
+    static let memoryPressureScrollbackLines = 2_000
+
+    private static let memoryLogger = Logger(subsystem: "com.prossh", category: "Memory")
+
+    /// Everything holding memory on behalf of `sessionID`.
+    private func memoryFootprintReporters(for sessionID: UUID) -> [any MemoryFootprintReporting] {
+        var reporters: [any MemoryFootprintReporting] = [renderingCoordinator, terminalHistoryIndex, recordingCoordinator, sessionLogCoordinator]
+        if let engine = engines[sessionID] {
+            reporters.insert(engine, at: 0)
+        }
+        return reporters
+    }
+
+    /// Bytes held for one session, by subsystem.
+    func memoryFootprint(for sessionID: UUID) async -> MemoryFootprint {
+        var footprint = MemoryFootprint()
+        for reporter in memoryFootprintReporters(for: sessionID) {
+            footprint += await reporter.memoryFootprint(for: sessionID)
+        }
+        return footprint
+    }
+
+    /// Memory shared by every session rather than charged to one: the
+    /// glyph atlases.
+    var sharedMemoryFootprint: MemoryFootprint {
+        GlyphAtlasStore.shared.memoryFootprint
+    }
+
+    /// The session's breakdown followed by the shared figures, as text for
+    /// the diagnostics menu.
+    func memoryDiagnosticsReport(for sessionID: UUID) async -> String {
+        let session = await memoryFootprint(for: sessionID)
+        return """
+        Session
+        \(session.summary)
+
+        Shared
+        \(sharedMemoryFootprint.summary)
+        """
+    }
+
+    /// Give memory back. Every level writes out recorder buffers, frees the
+    /// glyph atlases of font sizes no pane uses and compacts the rest, drops
+    /// decoded inline images (they decode again from their payloads when
+    /// next drawn) and hibernates every hidden session; critical pressure
+    /// also trims each session's scrollback to `memoryPressureScrollbackLines`.
+    func handleMemoryPressure(_ level: MemoryPressureMonitor.Level) async {
+        Self.memoryLogger.notice("memory_pressure level=\(level == .critical ? "critical" : "warning", privacy: .public) sessions=\(self.engines.count)")
+        recordingCoordinator.flushBuffers()
+        GlyphAtlasStore.shared.releaseResident()
+        GlyphAtlasStore.shared.compactAll()
+        InlineImageStore.shared.removeAllBitmaps()
+        InlineImageTextureCache.shared.removeAll()
+        await renderingCoordinator.hibernateIdleSessions(force: true)
+        guard level == .critical else { return }
+        for sessionID in engines.keys {
+            await renderingCoordinator.trimScrollback(sessionID: sessionID, toLines: Self.memoryPressureScrollbackLines)
+        }
+    }
+}
@@ -18,12 +18,31 @@ extension SessionManager {
                 .first
     }
 
-    /// Total bytes received + sent for a session.
+    /// The tmux control mode layout that `sessionID` is the control mode
+    /// session of, or one of the panes of.
+    func tmuxLayout(showing sessionID: UUID) -> SplitNode? {
+        if let layout = tmuxLayoutsBySessionID[sessionID] { return layout }
+        return tmuxLayoutsBySessionID.values.first { layout in
+            layout.allPanes.contains { $0.sessionID == sessionID }
+        }
+    }
+
+    /// Total bytes received + sent for a session, as last sampled for
+    /// views (see SessionLiveState).
     func totalTraffic(for sessionID: UUID) -> (received: Int64, sent: Int64) {
-        (
-            received: bytesReceivedBySessionID[sessionID] ?? 0,
-            sent: bytesSentBySessionID[sessionID] ?? 0
-        )
+        let traffic = liveStates[sessionID]?.sampledTraffic ?? SessionTraffic()
+        return (received: traffic.received, sent: traffic.sent)
+    }
+
+    /// Read-to-GPU latency percentiles for a session, when latency tracing
+    /// is on (see PipelineLatencyTracer).
+    func pipelineLatencyReport(for sessionID: UUID) -> PipelineLatencyReport? {
+        shellIOCoordinator.latencyTracers[sessionID]?.report()
+    }
+
+    /// Output pipeline totals for a pane's performance HUD.
+    func performanceHUDStats(for sessionID: UUID) -> PerformanceHUDSessionStats {
+        renderingCoordinator.performanceHUDStats(for: sessionID)
     }
 
     func recentCommandBlocks(sessionID: UUID, limit: Int = 20) async -> [CommandBlock] {
@@ -34,7 +53,75 @@ extension SessionManager {
         await terminalHistoryIndex.searchCommands(sessionID: sessionID, query: query, limit: limit)
     }
 
+    /// Ranked command history matches across every session.
+    func searchAllCommandHistory(query: String, limit: Int = 20) async -> [CommandBlock] {
+        await terminalHistoryIndex.searchAllCommands(query: query, limit: limit)
+    }
+
+    /// Command blocks across sessions related in meaning to `query`.
+    func relevantCommandBlocks(query: String, limit: Int = 5) async -> [CommandBlock] {
+        await terminalHistoryIndex.relevantCommands(query: query, limit: limit)
+    }
+
+    func commandBlock(sessionID: UUID, marker: String) async -> CommandBlock? {
+        await terminalHistoryIndex.commandBlock(sessionID: sessionID, marker: marker)
+    }
+
+    /// Persisted command history across sessions, newest first.
+    func persistedCommandHistory(matching query: CommandHistoryQuery) async -> [CommandHistoryEntry] {
+        await commandHistoryStore?.entries(matching: query) ?? []
+    }
+
+    /// Everything a persisted command printed, read back from the session
+    /// log; nil when the session was not logged or the log was pruned.
+    func loggedOutput(of entry: CommandHistoryEntry) async -> String? {
+        await sessionLogCoordinator.transcript(of: entry)
+    }
+
+    /// Lines across the session logs containing `text`, newest first.
+    func searchSessionLogs(_ text: String, limit: Int = 50) async -> [SessionLogMatch] {
+        await sessionLogCoordinator.search(text, limit: limit)
+    }
+
     func commandOutput(sessionID: UUID, blockID: UUID) async -> String? {
         await terminalHistoryIndex.commandOutput(sessionID: sessionID, blockID: blockID)
     }
+
+    /// Copy the output of the last command that finished under shell
+    /// integration, and scroll to its first line.
+    @discardableResult
+    func copyLastCommandOutput(sessionID: UUID) async -> Bool {
+        guard let engine = engines[sessionID],
+              let output = await engine.lastCommandOutput(maxCharacters: terminalHistoryIndex.maxOutputCharacters)
+        else { return false }
+        scrollToRow(sessionID: sessionID, row: output.scrollOffset)
+        return PlatformClipboard.writeString(output.text)
+    }
+
+    /// Fold the output of the last finished command into its summary row,
+    /// or expand it again when it is folded.
+    @discardableResult
+    func toggleLastCommandOutputFold(sessionID: UUID) async -> Bool {
+        await commandFoldingCoordinator.toggleLastOutput(sessionID: sessionID)
+    }
+
+    /// Expand every folded command output in the session.
+    @discardableResult
+    func expandFoldedCommandOutput(sessionID: UUID) async -> Int {
+        await commandFoldingCoordinator.expandAll(sessionID: sessionID)
+    }
+
+    /// Matches for `query` in the session's folded command output.
+    func foldedOutputMatchCount(sessionID: UUID, query: ScrollbackSearchQuery) async -> Int {
+        await commandFoldingCoordinator.foldedMatchCount(sessionID: sessionID, query: query)
+    }
+
+    /// Copy the session's scrollback and screen, folded output included.
+    /// The text is only written out when it is pasted.
+    @discardableResult
+    func copyEntireHistory(sessionID: UUID) async -> Bool {
+        guard let engine = engines[sessionID] else { return false }
+        let export = await engine.historyTextExport()
+        return PlatformClipboard.writeLazily { export.utf8Data() }
+    }
 }
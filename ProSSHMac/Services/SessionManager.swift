@@ -2,6 +2,7 @@
 import Foundation
 import Combine
 import Network
+import os.log
 
 /// Reactive scroll position state for the terminal scrollbar overlay.
 struct TerminalScrollState: Equatable {
@@ -26,23 +27,31 @@ enum SessionConnectionError: LocalizedError {
 
 @MainActor
 final class SessionManager: ObservableObject {
-    @Published private(set) var sessions: [Session] = []
-    @Published var shellBuffers: [UUID: [String]] = [:]
-    @Published var bellEventNonceBySessionID: [UUID: Int] = [:]
-    @Published var inputModeSnapshotsBySessionID: [UUID: InputModeSnapshot] = [:]
-    @Published var gridSnapshotNonceBySessionID: [UUID: Int] = [:]
-    @Published var windowTitleBySessionID: [UUID: String] = [:]
+    private static let logger = Logger(subsystem: "com.prossh", category: "SessionManager")
+
+    @Published private(set) var sessions: [Session] = [] {
+        didSet { workspaceCoordinator.scheduleSave() }
+    }
     @Published private(set) var knownHosts: [KnownHostEntry] = []
     @Published var isRecordingBySessionID: [UUID: Bool] = [:]
     @Published var hasRecordingBySessionID: [UUID: Bool] = [:]
     @Published var isPlaybackRunningBySessionID: [UUID: Bool] = [:]
     @Published var latestRecordingURLBySessionID: [UUID: URL] = [:]
-    @Published var workingDirectoryBySessionID: [UUID: String] = [:]
-    @Published var bytesReceivedBySessionID: [UUID: Int64] = [:]
-    @Published var bytesSentBySessionID: [UUID: Int64] = [:]
-    @Published var latestCompletedCommandBlockBySessionID: [UUID: CommandBlock] = [:]
-    @Published var commandCompletionNonceBySessionID: [UUID: Int] = [:]
-    @Published var scrollStateBySessionID: [UUID: TerminalScrollState] = [:]
+    /// The active window of each session in tmux control mode, as panes
+    /// showing its tmux pane sessions (see TmuxControlCoordinator).
+    @Published private(set) var tmuxLayoutsBySessionID: [UUID: SplitNode] = [:]
+    /// Remote files open in a local editor (see RemoteEditCoordinator).
+    @Published private(set) var remoteEdits: [RemoteEdit] = []
+    /// The latest command run across hosts (see ParallelCommandCoordinator).
+    @Published private(set) var parallelCommandRun: ParallelCommandRun?
+    /// Sessions mirrored read-only to viewers (see SessionMirrorCoordinator).
+    @Published private(set) var mirrorShares: [UUID: SessionMirrorShare] = [:]
+    /// Sessions whose `rz` is waiting for files, oldest first (see
+    /// InBandTransferCoordinator).
+    @Published private(set) var inBandUploadRequests: [UUID] = []
+    /// Everything that changes while a session streams, one observable
+    /// object per session (see SessionLiveState).
+    var liveStates: [UUID: SessionLiveState] = [:]
 
     let transport: any SSHTransporting
     private let knownHostsStore: any KnownHostsStoreProtocol
@@ -50,6 +59,10 @@ final class SessionManager: ObservableObject {
     private let portForwardingManager: PortForwardingManager?
     private let totpStore: TOTPStore?
     let terminalHistoryIndex = TerminalHistoryIndex()
+    /// Tab and overview thumbnails, by session.
+    let thumbnailStore = SessionThumbnailStore()
+    /// Every completed command across sessions, on disk; nil in tests.
+    let commandHistoryStore: CommandHistoryStore?
     var shellChannels: [UUID: any SSHShellChannel] = [:]
     var engines: [UUID: TerminalEngine] = [:]
     var hostBySessionID: [UUID: Host] = [:]
@@ -61,9 +74,25 @@ final class SessionManager: ObservableObject {
     let renderingCoordinator: TerminalRenderingCoordinator
     let recordingCoordinator: SessionRecordingCoordinator
     let sftpCoordinator: SessionSFTPCoordinator
+    let resumeCoordinator: SessionResumeCoordinator
+    let workspaceCoordinator: WorkspaceRestoreCoordinator
+    let tmuxCoordinator: TmuxControlCoordinator
+    let metricsCoordinator: SessionMetricsCoordinator
+    let remoteEditCoordinator: RemoteEditCoordinator
+    let prewarmCoordinator: ConnectionPrewarmCoordinator
+    let parallelCommandCoordinator: ParallelCommandCoordinator
+    let mirrorCoordinator: SessionMirrorCoordinator
+    let inBandTransferCoordinator: InBandTransferCoordinator
+    let sessionLogCoordinator: SessionLogCoordinator
+    let commandFoldingCoordinator: CommandOutputFoldingCoordinator
+    /// Dropped sessions and the reconnects that replaced them, old to new,
+    /// so the UI can hand the old pane and tab to the new session.
+    private(set) var sessionReplacements: [UUID: UUID] = [:]
     let aiToolCoordinator: SessionAIToolCoordinator
     let shellIOCoordinator: SessionShellIOCoordinator
     var latestPublishedCommandBlockIDBySessionID: [UUID: UUID] = [:]
+    /// Memory pressure events, answered by `handleMemoryPressure`.
+    private var memoryPressureMonitor: MemoryPressureMonitor?
 
     /// Runtime throughput policy. When enabled, expensive non-render work is throttled:
     /// - Snapshot publish interval relaxed from 8ms to 16ms (~60fps → ~30fps)
@@ -75,19 +104,112 @@ final class SessionManager: ObservableObject {
         UserDefaults.standard.bool(forKey: "terminal.throughput.mode.enabled")
     }
 
+    /// GPU cell expansion: live grid snapshots carry the raw 20-byte cells
+    /// and the Metal renderer expands them in a compute pass.
+    /// Toggle via: `defaults write com.prossh terminal.renderer.gpuCellExpansion -bool true`
+    var gpuCellExpansionEnabled: Bool {
+        UserDefaults.standard.bool(forKey: "terminal.renderer.gpuCellExpansion")
+    }
+
+    /// Low-latency input: output echoing a keystroke skips parser batching
+    /// and the publish interval (see InputEchoTracker).
+    /// Toggle via: `defaults write com.prossh terminal.input.lowLatency.enabled -bool true`
+    var lowLatencyInputEnabled: Bool {
+        UserDefaults.standard.bool(forKey: "terminal.input.lowLatency.enabled")
+    }
+
+    /// Predictive local echo: typed characters are drawn as tentative cells
+    /// before the remote echoes them, on links slow enough to need it (see
+    /// TerminalGrid+PredictiveEcho). SSH sessions only.
+    /// Toggle via: `defaults write com.prossh terminal.input.predictiveEcho.enabled -bool true`
+    var predictiveEchoEnabled: Bool {
+        UserDefaults.standard.bool(forKey: "terminal.input.predictiveEcho.enabled")
+    }
+
+    /// Mosh transport: the interactive terminal of an SSH session runs over
+    /// mosh-server's UDP state-sync protocol (see MoshShellChannel), which
+    /// survives roaming and packet loss. Falls back to the SSH shell when
+    /// mosh-server is missing or the session goes through a jump host.
+    /// Toggle via: `defaults write com.prossh terminal.transport.mosh.enabled -bool true`
+    var moshTransportEnabled: Bool {
+        UserDefaults.standard.bool(forKey: "terminal.transport.mosh.enabled")
+    }
+
+    /// After a reconnect restores a dropped session's screen, reattach a
+    /// detached tmux or screen session on the host (see
+    /// SessionResumeCoordinator).
+    /// Toggle via: `defaults write com.prossh terminal.reconnect.reattachMultiplexer -bool true`
+    var reattachMultiplexerOnResume: Bool {
+        UserDefaults.standard.bool(forKey: "terminal.reconnect.reattachMultiplexer")
+    }
+
+    /// tmux control mode: `tmux -CC` in an SSH session opens each tmux pane
+    /// as its own session, with the window's layout as native splits (see
+    /// TmuxControlCoordinator).
+    /// Toggle via: `defaults write com.prossh terminal.tmux.controlMode.enabled -bool true`
+    var tmuxControlModeEnabled: Bool {
+        UserDefaults.standard.bool(forKey: "terminal.tmux.controlMode.enabled")
+    }
+
+    /// In-band transfers: `sz` and `rz` run in a session's shell transfer
+    /// files over ZMODEM instead of printing them to the terminal (see
+    /// InBandTransferCoordinator).
+    /// Toggle via: `defaults write com.prossh terminal.transfer.zmodem.enabled -bool true`
+    var inBandTransfersEnabled: Bool {
+        UserDefaults.standard.bool(forKey: "terminal.transfer.zmodem.enabled")
+    }
+
+    /// Host metrics: a sampler on one exec channel per SSH session feeds
+    /// the metadata panel and the AI tools (see SessionMetricsCoordinator).
+    /// Toggle via: `defaults write com.prossh terminal.hostMetrics.enabled -bool true`
+    var hostMetricsEnabled: Bool {
+        UserDefaults.standard.bool(forKey: "terminal.hostMetrics.enabled")
+    }
+
+    /// Seconds between host metrics samples.
+    var hostMetricsIntervalSeconds: Int {
+        let stored = UserDefaults.standard.integer(forKey: "terminal.hostMetrics.intervalSeconds")
+        return stored > 0 ? stored : 5
+    }
+
+    /// Connection pre-warming: hosts the user is likely to open next are
+    /// connected ahead of the click (see ConnectionPrewarmCoordinator).
+    /// Toggle via: `defaults write com.prossh terminal.connection.prewarm.enabled -bool true`
+    var connectionPrewarmEnabled: Bool {
+        UserDefaults.standard.bool(forKey: "terminal.connection.prewarm.enabled")
+    }
+
+    /// Lazy workspace restore: SSH tabs come back at launch as dormant
+    /// sessions showing their saved screens, and connect when their pane
+    /// first appears (see WorkspaceRestoreCoordinator).
+    /// Toggle via: `defaults write com.prossh terminal.workspace.lazyRestore.enabled -bool true`
+    var lazyWorkspaceRestoreEnabled: Bool {
+        UserDefaults.standard.bool(forKey: "terminal.workspace.lazyRestore.enabled")
+    }
+
     var configuredScrollbackLines: Int {
         let stored = UserDefaults.standard.integer(forKey: "terminal.scrollback.maxLines")
         return stored > 0 ? stored : TerminalDefaults.maxScrollbackLines
     }
 
+    /// Trigram index over scrollback pages, for fast full-history search
+    /// (see ScrollbackTrigramFilter). Costs 2 KiB per 256 lines.
+    /// Toggle via: `defaults write com.prossh terminal.scrollback.trigramIndex -bool true`
+    var scrollbackIndexEnabled: Bool {
+        UserDefaults.standard.bool(forKey: ScrollbackTrigramFilter.enabledDefaultsKey)
+    }
+
     init(
         transport: any SSHTransporting,
         knownHostsStore: any KnownHostsStoreProtocol,
         auditLogManager: AuditLogManager? = nil,
         portForwardingManager: PortForwardingManager? = nil,
-        totpStore: TOTPStore? = nil
+        totpStore: TOTPStore? = nil,
+        commandHistoryStore: CommandHistoryStore? = nil,
+        workspaceSnapshotStore: WorkspaceSnapshotStore? = nil
     ) {
         self.transport = transport
+        self.commandHistoryStore = commandHistoryStore
         self.knownHostsStore = knownHostsStore
         self.auditLogManager = auditLogManager
         self.portForwardingManager = portForwardingManager
@@ -101,23 +223,58 @@ final class SessionManager: ObservableObject {
         self.recordingCoordinator = recordCoord
         let sftpCoord = SessionSFTPCoordinator()
         self.sftpCoordinator = sftpCoord
+        let resumeCoord = SessionResumeCoordinator()
+        self.resumeCoordinator = resumeCoord
+        let workspaceCoord = WorkspaceRestoreCoordinator(store: workspaceSnapshotStore)
+        self.workspaceCoordinator = workspaceCoord
+        let tmuxCoord = TmuxControlCoordinator()
+        self.tmuxCoordinator = tmuxCoord
+        let metricsCoord = SessionMetricsCoordinator()
+        self.metricsCoordinator = metricsCoord
+        let remoteEditCoord = RemoteEditCoordinator()
+        self.remoteEditCoordinator = remoteEditCoord
+        let prewarmCoord = ConnectionPrewarmCoordinator()
+        self.prewarmCoordinator = prewarmCoord
+        let parallelCommandCoord = ParallelCommandCoordinator()
+        self.parallelCommandCoordinator = parallelCommandCoord
+        let mirrorCoord = SessionMirrorCoordinator()
+        self.mirrorCoordinator = mirrorCoord
+        let inBandTransferCoord = InBandTransferCoordinator()
+        self.inBandTransferCoordinator = inBandTransferCoord
+        let sessionLogCoord = SessionLogCoordinator()
+        self.sessionLogCoordinator = sessionLogCoord
+        let commandFoldingCoord = CommandOutputFoldingCoordinator()
+        self.commandFoldingCoordinator = commandFoldingCoord
         let aiToolCoord = SessionAIToolCoordinator()
         self.aiToolCoordinator = aiToolCoord
         let shellIOCoord = SessionShellIOCoordinator()
         self.shellIOCoordinator = shellIOCoord
 
-        Task { @MainActor [weak self] in
-            await self?.refreshKnownHosts()
-        }
-
         coord.manager = self
         coord.start()
         keepaliveCoordinator.manager = self
         renderCoord.manager = self
         recordCoord.manager = self
         sftpCoord.manager = self
+        resumeCoord.manager = self
+        workspaceCoord.manager = self
+        tmuxCoord.manager = self
+        metricsCoord.manager = self
+        remoteEditCoord.manager = self
+        prewarmCoord.manager = self
+        parallelCommandCoord.manager = self
+        mirrorCoord.manager = self
+        inBandTransferCoord.manager = self
+        sessionLogCoord.manager = self
+        commandFoldingCoord.manager = self
         aiToolCoord.manager = self
         shellIOCoord.manager = self
+
+        memoryPressureMonitor = MemoryPressureMonitor { [weak self] level in
+            Task { @MainActor [weak self] in
+                await self?.handleMemoryPressure(level)
+            }
+        }
     }
 
     nonisolated deinit {}
@@ -130,6 +287,30 @@ final class SessionManager: ObservableObject {
         try await connect(to: host, jumpHost: jumpHost, automaticReconnect: true, passwordOverride: nil)
     }
 
+    /// Adds sessions restored without a connection (see
+    /// WorkspaceRestoreCoordinator), after any already in the list.
+    func insertDormantSessions(_ dormant: [Session]) {
+        sessions.append(contentsOf: dormant)
+    }
+
+    /// Connects `host` for the dormant session `dormantSessionID`, which the
+    /// new session replaces, with `screen` restored in its engine.
+    func resumeDormantSession(
+        _ dormantSessionID: UUID,
+        host: Host,
+        jumpHost: Host?,
+        screen: SessionResumeState
+    ) async throws -> Session {
+        try await connect(
+            to: host,
+            jumpHost: jumpHost,
+            automaticReconnect: false,
+            replacing: dormantSessionID,
+            screen: screen,
+            passwordOverride: nil
+        )
+    }
+
     func closeSession(sessionID: UUID) async {
         guard let session = sessions.first(where: { $0.id == sessionID }) else {
             return
@@ -163,22 +344,30 @@ final class SessionManager: ObservableObject {
         )
 
         sessions.insert(session, at: 0)
-        let engine = TerminalEngine(columns: PTYConfiguration.default.columns, rows: PTYConfiguration.default.rows, maxScrollbackLines: configuredScrollbackLines)
+        let engine = TerminalEngine(
+            columns: PTYConfiguration.default.columns,
+            rows: PTYConfiguration.default.rows,
+            maxScrollbackLines: configuredScrollbackLines,
+            indexesScrollback: scrollbackIndexEnabled
+        )
         await engine.setLineFeedMode(true)
+        await engine.setBackgroundResizeEnabled(true)
+        await engine.setCompactSnapshotsEnabled(gpuCellExpansionEnabled)
         await configureHistoryTracking(for: session, engine: engine)
         engines[sessionID] = engine
         renderingCoordinator.initializePTY(for: sessionID)
 
         renderingCoordinator.gridSnapshotsBySessionID[sessionID] = await engine.snapshot()
-        gridSnapshotNonceBySessionID[sessionID] = 0
-        shellBuffers[sessionID] = []
-        bellEventNonceBySessionID[sessionID] = 0
-        inputModeSnapshotsBySessionID[sessionID] = await engine.inputModeSnapshot()
+        let live = liveState(for: sessionID)
+        live.gridSnapshotNonce = 0
+        live.shellBuffer = []
+        live.bellEventNonce = 0
+        live.inputModeSnapshot = await engine.inputModeSnapshot()
+        live.bytesReceived = 0
+        live.bytesSent = 0
         isRecordingBySessionID[sessionID] = false
         hasRecordingBySessionID[sessionID] = false
         isPlaybackRunningBySessionID[sessionID] = false
-        bytesReceivedBySessionID[sessionID] = 0
-        bytesSentBySessionID[sessionID] = 0
 
         do {
             let desiredPTY = renderingCoordinator.sanitizedPTY(for: sessionID)
@@ -204,10 +393,10 @@ final class SessionManager: ObservableObject {
             session.state = .connected
             replaceSession(session)
 
-            shellIOCoordinator.startParserReader(for: sessionID, rawOutput: channel.rawOutput)
+            shellIOCoordinator.startParserReader(for: sessionID, channel: channel)
 
             if let cwd = workingDirectory ?? ProcessInfo.processInfo.environment["HOME"] {
-                workingDirectoryBySessionID[sessionID] = cwd
+                liveState(for: sessionID).workingDirectory = cwd
             }
 
             return session
@@ -220,6 +409,101 @@ final class SessionManager: ObservableObject {
         }
     }
 
+    /// Adds a connected session for one pane of `parentID`'s tmux control
+    /// mode client, reading from and writing to `channel`. Returns its ID,
+    /// or nil when the parent session is gone.
+    func openTmuxPaneSession(
+        parentID: UUID,
+        title: String,
+        channel: TmuxPaneChannel,
+        columns: Int,
+        rows: Int
+    ) async -> UUID? {
+        guard let parent = sessions.first(where: { $0.id == parentID }) else { return nil }
+        let sessionID = UUID()
+        var session = parent
+        session.id = sessionID
+        session.hostLabel = "\(parent.hostLabel) · \(title)"
+        session.state = .connected
+        session.startedAt = .now
+        session.endedAt = nil
+        session.errorMessage = nil
+
+        let engine = TerminalEngine(
+            columns: columns,
+            rows: rows,
+            maxScrollbackLines: configuredScrollbackLines,
+            indexesScrollback: scrollbackIndexEnabled
+        )
+        await engine.setLineFeedMode(true)
+        await engine.setBackgroundResizeEnabled(true)
+        await engine.setCompactSnapshotsEnabled(gpuCellExpansionEnabled)
+        await configureHistoryTracking(for: session, engine: engine)
+        await engine.setResponseHandler { @Sendable bytes in
+            try? await channel.send(bytes: bytes)
+        }
+        engines[sessionID] = engine
+        renderingCoordinator.initializePTY(for: sessionID)
+        renderingCoordinator.gridSnapshotsBySessionID[sessionID] = await engine.snapshot()
+        let live = liveState(for: sessionID)
+        live.inputModeSnapshot = await engine.inputModeSnapshot()
+        isRecordingBySessionID[sessionID] = false
+        hasRecordingBySessionID[sessionID] = false
+        isPlaybackRunningBySessionID[sessionID] = false
+        shellChannels[sessionID] = channel
+
+        // After the parent, so host lookups keep finding the SSH session.
+        sessions.append(session)
+        shellIOCoordinator.startParserReader(for: sessionID, channel: channel)
+        return sessionID
+    }
+
+    /// Removes a tmux pane session whose pane closed.
+    func closeTmuxPaneSession(_ sessionID: UUID) async {
+        await shellChannels[sessionID]?.close()
+        removeSession(sessionID: sessionID)
+    }
+
+    /// Publishes (or, with nil, clears) the tmux layout shown for
+    /// `sessionID`.
+    func setTmuxLayout(_ node: SplitNode?, for sessionID: UUID) {
+        guard tmuxLayoutsBySessionID[sessionID] != node else { return }
+        tmuxLayoutsBySessionID[sessionID] = node
+    }
+
+    func setRemoteEdits(_ edits: [RemoteEdit]) {
+        guard remoteEdits != edits else { return }
+        remoteEdits = edits
+    }
+
+    func setParallelCommandRun(_ run: ParallelCommandRun?) {
+        guard parallelCommandRun != run else { return }
+        parallelCommandRun = run
+    }
+
+    func setMirrorShares(_ shares: [UUID: SessionMirrorShare]) {
+        guard mirrorShares != shares else { return }
+        mirrorShares = shares
+    }
+
+    func setInBandUploadRequests(_ requests: [UUID]) {
+        guard inBandUploadRequests != requests else { return }
+        inBandUploadRequests = requests
+    }
+
+    /// Audit entry for an action taken on `sessionID`, attributed to its
+    /// host.
+    func recordSessionAudit(_ action: String, sessionID: UUID, details: String? = nil) async {
+        await auditLogManager?.record(
+            category: .session,
+            action: action,
+            outcome: .info,
+            host: hostBySessionID[sessionID],
+            sessionID: sessionID,
+            details: details
+        )
+    }
+
     func restartLocalSession(sessionID: UUID) async throws -> Session {
         guard let oldSession = sessions.first(where: { $0.id == sessionID }),
               oldSession.isLocal else {
@@ -227,7 +511,7 @@ final class SessionManager: ObservableObject {
         }
 
         // Capture the tracked working directory before cleanup removes it.
-        let trackedWorkingDirectory = workingDirectoryBySessionID[sessionID]
+        let trackedWorkingDirectory = liveStates[sessionID]?.workingDirectory
 
         // Clean up old session artifacts
         if let shell = shellChannels[sessionID] {
@@ -245,6 +529,7 @@ final class SessionManager: ObservableObject {
     func applicationDidEnterBackground() {
         renderingCoordinator.applicationDidBecomeInactive()
         reconnectCoordinator.applicationDidEnterBackground()
+        Task { await workspaceCoordinator.saveNow() }
     }
 
     func applicationDidBecomeActive() {
@@ -256,12 +541,15 @@ final class SessionManager: ObservableObject {
 
     func applicationDidBecomeInactive() {
         renderingCoordinator.applicationDidBecomeInactive()
+        Task { await workspaceCoordinator.saveNow() }
     }
 
     private func connect(
         to host: Host,
         jumpHost: Host? = nil,
         automaticReconnect: Bool,
+        replacing replacedSessionID: UUID? = nil,
+        screen: SessionResumeState? = nil,
         passwordOverride: String?,
         keyPassphraseOverride: String? = nil
     ) async throws -> Session {
@@ -284,16 +572,21 @@ final class SessionManager: ObservableObject {
 
         // Clean up stale failed/disconnected sessions for this host before creating
         // a new one. This prevents accumulation of dead sessions in the list and ensures
-        // transport-level resources are properly released.
-        let staleSessionIDs = sessions
+        // transport-level resources are properly released. Dormant restored
+        // tabs are left alone; only their own activation replaces them.
+        let staleSessionIDs = replacedSessionID.map { [$0] } ?? sessions
             .filter { $0.hostID == host.id && ($0.state == .failed || $0.state == .disconnected) }
             .map(\.id)
+            .filter { !workspaceCoordinator.isDormant($0) }
+        let sessionID = UUID()
         for staleID in staleSessionIDs {
             await transport.disconnect(sessionID: staleID)
+            if automaticReconnect || replacedSessionID != nil {
+                sessionReplacements[staleID] = sessionID
+            }
             removeSession(sessionID: staleID)
         }
 
-        let sessionID = UUID()
         var session = Session(
             id: sessionID,
             kind: .ssh(hostID: host.id),
@@ -307,22 +600,38 @@ final class SessionManager: ObservableObject {
         )
 
         sessions.insert(session, at: 0)
-        let engine = TerminalEngine(columns: PTYConfiguration.default.columns, rows: PTYConfiguration.default.rows, maxScrollbackLines: configuredScrollbackLines)
+        let engine = TerminalEngine(
+            columns: PTYConfiguration.default.columns,
+            rows: PTYConfiguration.default.rows,
+            maxScrollbackLines: configuredScrollbackLines,
+            indexesScrollback: scrollbackIndexEnabled
+        )
         await engine.setLineFeedMode(true)
+        await engine.setBackgroundResizeEnabled(true)
+        await engine.setCompactSnapshotsEnabled(gpuCellExpansionEnabled)
         await configureHistoryTracking(for: session, engine: engine, shellIntegration: host.shellIntegration)
         engines[sessionID] = engine
         renderingCoordinator.initializePTY(for: sessionID)
+        let isResuming: Bool
+        if let screen {
+            isResuming = await resumeCoordinator.restore(screen, into: engine)
+        } else if automaticReconnect {
+            isResuming = await resumeCoordinator.restore(hostID: host.id, into: engine)
+        } else {
+            isResuming = false
+        }
 
         renderingCoordinator.gridSnapshotsBySessionID[sessionID] = await engine.snapshot()
-        gridSnapshotNonceBySessionID[sessionID] = 0
-        shellBuffers[sessionID] = []
-        bellEventNonceBySessionID[sessionID] = 0
-        inputModeSnapshotsBySessionID[sessionID] = await engine.inputModeSnapshot()
+        let live = liveState(for: sessionID)
+        live.gridSnapshotNonce = 0
+        live.shellBuffer = []
+        live.bellEventNonce = 0
+        live.inputModeSnapshot = await engine.inputModeSnapshot()
+        live.bytesReceived = 0
+        live.bytesSent = 0
         isRecordingBySessionID[sessionID] = false
         hasRecordingBySessionID[sessionID] = false
         isPlaybackRunningBySessionID[sessionID] = false
-        bytesReceivedBySessionID[sessionID] = 0
-        bytesSentBySessionID[sessionID] = 0
 
         do {
             var jumpHostConfig: JumpHostConfig? = nil
@@ -350,22 +659,7 @@ final class SessionManager: ObservableObject {
                 throw SessionConnectionError.hostVerificationRequired(challenge)
             }
 
-            var effectivePasswordOverride = passwordOverride
-            if host.authMethod == .keyboardInteractive,
-               let config = host.totpConfiguration,
-               let secret = try? await totpStore?.retrieveSecret(forHostID: host.id) {
-                let result = TOTPGenerator().generateSmartCode(secret: secret, configuration: config)
-                effectivePasswordOverride = result.code
-                await auditLogManager?.record(
-                    category: .authentication,
-                    action: "TOTP 2FA auto-fill",
-                    outcome: .info,
-                    host: host,
-                    sessionID: sessionID,
-                    details: "Code valid for \(result.secondsRemaining)s, issuer: \(config.issuer ?? "unknown")"
-                )
-            }
-
+            let effectivePasswordOverride = await totpCode(for: host, sessionID: sessionID) ?? passwordOverride
             try await transport.authenticate(sessionID: sessionID, to: host, passwordOverride: effectivePasswordOverride, keyPassphraseOverride: keyPassphraseOverride)
 
             session.state = .connected
@@ -421,7 +715,7 @@ final class SessionManager: ObservableObject {
             }
 
             try await openShell(for: session)
-            keepaliveCoordinator.startIfNeeded()
+            keepaliveCoordinator.startIfNeeded(sessionID: sessionID, hostKey: "\(host.hostname):\(host.port)")
 
             // Inject shell integration script for SSH sessions (Unix shell types only).
             // Uses compact single-line version to minimize terminal echo noise.
@@ -454,11 +748,17 @@ final class SessionManager: ObservableObject {
                 outcome: .success,
                 host: host,
                 sessionID: sessionID,
-                details: "Backend=\(details.backend.rawValue); KEX=\(details.negotiatedKEX); cipher=\(details.negotiatedCipher)."
+                details: "Backend=\(details.backend.rawValue); KEX=\(details.negotiatedKEX); cipher=\(details.negotiatedCipher); mac=\(details.negotiatedMAC)."
             )
 
             if automaticReconnect {
                 removeOlderDisconnectedSessions(for: host.id, keepSessionID: sessionID)
+                resumeCoordinator.discard(hostID: host.id)
+                if isResuming, reattachMultiplexerOnResume {
+                    Task { [resumeCoordinator] in
+                        await resumeCoordinator.reattachMultiplexer(sessionID: sessionID)
+                    }
+                }
             }
 
             await refreshKnownHosts()
@@ -506,6 +806,7 @@ final class SessionManager: ObservableObject {
         defer { manuallyDisconnectingSessions.remove(sessionID) }
 
         reconnectCoordinator.cancelPending(sessionID: sessionID)
+        aiToolCoordinator.forgetExecAvailability(sessionID: sessionID)
         hostBySessionID.removeValue(forKey: sessionID)
         jumpHostBySessionID.removeValue(forKey: sessionID)
 
@@ -529,7 +830,7 @@ final class SessionManager: ObservableObject {
         session.state = .disconnected
         session.endedAt = .now
         replaceSession(session)
-        keepaliveCoordinator.stopIfIdle()
+        keepaliveCoordinator.stopTracking(sessionID: sessionID)
 
         await auditLogManager?.record(
             category: .session,
@@ -556,7 +857,7 @@ final class SessionManager: ObservableObject {
         guard let session = sessions.first(where: { $0.id == sessionID }) else { return nil }
 
         if session.isLocal {
-            let cwd = workingDirectoryBySessionID[sessionID]
+            let cwd = liveStates[sessionID]?.workingDirectory
             return try await openLocalSession(
                 shellPath: session.shellPath,
                 workingDirectory: cwd
@@ -576,6 +877,10 @@ final class SessionManager: ObservableObject {
         await shellIOCoordinator.sendRawShellInput(sessionID: sessionID, input: input)
     }
 
+    func sendRawShellInput(sessionID: UUID, input: String, priority: SSHShellWritePriority) async {
+        await shellIOCoordinator.sendRawShellInput(sessionID: sessionID, input: input, priority: priority)
+    }
+
     func sendRawShellInputBytes(
         sessionID: UUID,
         bytes: [UInt8],
@@ -590,12 +895,40 @@ final class SessionManager: ObservableObject {
         )
     }
 
+    /// Streams the clipboard to the session. Returns false when it holds
+    /// no text.
+    @discardableResult
+    func pasteClipboard(sessionID: UUID, bracketedPasteEnabled: Bool) -> Bool {
+        guard let stream = PasteHandler.readClipboardStream(bracketedPasteEnabled: bracketedPasteEnabled) else {
+            return false
+        }
+        shellIOCoordinator.startPaste(stream, sessionID: sessionID)
+        return true
+    }
+
+    func cancelPaste(sessionID: UUID) {
+        shellIOCoordinator.cancelPaste(sessionID: sessionID)
+    }
+
+    @discardableResult
+    func broadcastShellInput(
+        _ input: BroadcastKeyInput,
+        to sessionIDs: [UUID],
+        source: RawShellInputSource = .hardwareKeyCapture
+    ) async -> [BroadcastInputFailure] {
+        await shellIOCoordinator.broadcastShellInput(input, to: sessionIDs, source: source)
+    }
+
     // MARK: - F.6 PTY Resize (delegates to renderingCoordinator)
 
     func resizeTerminal(sessionID: UUID, columns: Int, rows: Int) async {
         await renderingCoordinator.resizeTerminal(sessionID: sessionID, columns: columns, rows: rows)
     }
 
+    func setCellPixelSize(sessionID: UUID, width: Int, height: Int) async {
+        await renderingCoordinator.setCellPixelSize(sessionID: sessionID, width: width, height: height)
+    }
+
     func clearShellBuffer(sessionID: UUID) {
         renderingCoordinator.clearShellBuffer(sessionID: sessionID)
     }
@@ -618,6 +951,14 @@ final class SessionManager: ObservableObject {
         renderingCoordinator.scrollToRow(sessionID: sessionID, row: row)
     }
 
+    func jumpToPrompt(sessionID: UUID, direction: Int) {
+        renderingCoordinator.jumpToPrompt(sessionID: sessionID, direction: direction)
+    }
+
+    func scrollbackRingRows(sessionID: UUID, positions: Range<Int>) async -> ScrollbackRingRows? {
+        await renderingCoordinator.scrollbackRingRows(sessionID: sessionID, positions: positions)
+    }
+
     func cachedScrollbackCount(for sessionID: UUID) -> Int {
         renderingCoordinator.cachedScrollbackCountBySessionID[sessionID] ?? 0
     }
@@ -626,6 +967,29 @@ final class SessionManager: ObservableObject {
         renderingCoordinator.gridSnapshot(for: sessionID)
     }
 
+    /// A copy of `sessionID`'s scrollback for full-history search.
+    func searchableScrollback(sessionID: UUID) async -> ScrollbackBuffer? {
+        guard let engine = engines[sessionID] else { return nil }
+        return await engine.searchableScrollback()
+    }
+
+    /// Report how visible the pane `surfaceID` showing `sessionID` is, so
+    /// snapshot publishing follows where the user is looking.
+    func setRenderTier(_ tier: SessionRenderTier, for sessionID: UUID, surfaceID: UUID) {
+        renderingCoordinator.setRenderTier(tier, for: sessionID, surfaceID: surfaceID)
+    }
+
+    /// Display-link snapshot feed for the pane `surfaceID` showing
+    /// `sessionID`; while attached, publishes reach the pane without the
+    /// snapshot nonce.
+    func attachSnapshotFeed(for sessionID: UUID, surfaceID: UUID) -> GridSnapshotFeed {
+        renderingCoordinator.attachSnapshotFeed(for: sessionID, surfaceID: surfaceID)
+    }
+
+    func detachSnapshotFeed(for sessionID: UUID, surfaceID: UUID) {
+        renderingCoordinator.detachSnapshotFeed(for: sessionID, surfaceID: surfaceID)
+    }
+
     // MARK: - Recording (delegates to recordingCoordinator)
 
     func toggleRecording(sessionID: UUID) async {
@@ -644,14 +1008,46 @@ final class SessionManager: ObservableObject {
         await recordingCoordinator.playLastRecording(sessionID: sessionID, speed: speed)
     }
 
-    func exportLastRecordingAsCast(sessionID: UUID, columns: Int = 80, rows: Int = 24) async {
-        await recordingCoordinator.exportLastRecordingAsCast(sessionID: sessionID, columns: columns, rows: rows)
+    func seekPlayback(sessionID: UUID, toSeconds seconds: Double) {
+        recordingCoordinator.seekPlayback(sessionID: sessionID, toSeconds: seconds)
+    }
+
+    func exportLastRecordingAsCast(sessionID: UUID, columns: Int? = nil, rows: Int? = nil, gzip: Bool = false) async {
+        await recordingCoordinator.exportLastRecordingAsCast(sessionID: sessionID, columns: columns, rows: rows, gzip: gzip)
     }
 
     func listRemoteDirectory(sessionID: UUID, path: String) async throws -> [SFTPDirectoryEntry] {
         try await sftpCoordinator.listRemoteDirectory(sessionID: sessionID, path: path)
     }
 
+    func walkRemoteDirectory(sessionID: UUID, path: String, recursive: Bool) async throws -> AsyncThrowingStream<[SFTPDirectoryEntry], Error> {
+        try await sftpCoordinator.walkRemoteDirectory(sessionID: sessionID, path: path, recursive: recursive)
+    }
+
+    func cachedRemoteDirectory(sessionID: UUID, path: String) -> [SFTPDirectoryEntry]? {
+        sftpCoordinator.cachedRemoteDirectory(sessionID: sessionID, path: path)
+    }
+
+    func remoteDirectoryPages(sessionID: UUID, path: String) async throws -> AsyncThrowingStream<[SFTPDirectoryEntry], Error> {
+        try await sftpCoordinator.remoteDirectoryPages(sessionID: sessionID, path: path)
+    }
+
+    func prefetchRemoteSubdirectories(sessionID: UUID, of path: String) {
+        sftpCoordinator.prefetchRemoteSubdirectories(sessionID: sessionID, of: path)
+    }
+
+    func invalidateRemoteDirectoryCache(sessionID: UUID) {
+        sftpCoordinator.invalidateRemoteDirectoryCache(sessionID: sessionID)
+    }
+
+    func createRemoteDirectory(sessionID: UUID, path: String) async throws {
+        try await sftpCoordinator.createRemoteDirectory(sessionID: sessionID, path: path)
+    }
+
+    func setRemoteModificationTime(sessionID: UUID, path: String, date: Date) async throws {
+        try await sftpCoordinator.setRemoteModificationTime(sessionID: sessionID, path: path, date: date)
+    }
+
     func uploadFile(sessionID: UUID, localPath: String, remotePath: String) async throws -> SFTPTransferResult {
         try await sftpCoordinator.uploadFile(sessionID: sessionID, localPath: localPath, remotePath: remotePath)
     }
@@ -676,6 +1072,72 @@ final class SessionManager: ObservableObject {
         await aiToolCoordinator.executeCommandAndWait(sessionID: sessionID, command: command, timeoutSeconds: timeoutSeconds)
     }
 
+    func executeCommandOutOfBand(
+        sessionID: UUID,
+        command: String,
+        timeoutSeconds: TimeInterval
+    ) async -> CommandExecutionResult? {
+        await aiToolCoordinator.executeOutOfBand(sessionID: sessionID, command: command, timeoutSeconds: timeoutSeconds)
+    }
+
+    func writeFileOutOfBand(
+        sessionID: UUID,
+        path: String,
+        content: String,
+        timeoutSeconds: TimeInterval
+    ) async -> CommandExecutionResult? {
+        await aiToolCoordinator.writeFileOutOfBand(sessionID: sessionID, path: path, content: content, timeoutSeconds: timeoutSeconds)
+    }
+
+    func hostMetrics(sessionID: UUID) -> RemoteHostMetrics? {
+        metricsCoordinator.latestSample(sessionID: sessionID)
+    }
+
+    /// Connects and authenticates `host` under `sessionID` for exec
+    /// channels only: no session, engine or PTY is created. Nothing is
+    /// asked of the user, so an untrusted host key (or jump host key)
+    /// fails the connection. The caller disconnects `sessionID`.
+    func openExecConnection(sessionID: UUID, to host: Host, jumpHost: Host?) async throws {
+        do {
+            var jumpHostConfig: JumpHostConfig? = nil
+            if let jumpHost {
+                let jumpFingerprint = try await resolveJumpHostFingerprint(for: jumpHost)
+                jumpHostConfig = JumpHostConfig(host: jumpHost, expectedFingerprint: jumpFingerprint)
+            }
+            let details = try await transport.connect(sessionID: sessionID, to: host, jumpHostConfig: jumpHostConfig)
+            try enforcePinnedHostKeyAlgorithm(for: host, details: details)
+            if let challenge = try await evaluateKnownHost(for: host, details: details) {
+                throw SessionConnectionError.hostVerificationRequired(challenge)
+            }
+            let passwordOverride = await totpCode(for: host, sessionID: sessionID)
+            try await transport.authenticate(sessionID: sessionID, to: host, passwordOverride: passwordOverride, keyPassphraseOverride: nil)
+            await auditLogManager?.record(
+                category: .authentication,
+                action: "Authentication succeeded",
+                outcome: .success,
+                host: host,
+                sessionID: sessionID,
+                details: "Exec-only connection; no shell opened."
+            )
+        } catch {
+            await transport.disconnect(sessionID: sessionID)
+            await auditLogManager?.record(
+                category: .connection,
+                action: "Exec connection failed",
+                outcome: .failure,
+                host: host,
+                sessionID: sessionID,
+                details: error.localizedDescription
+            )
+            throw error
+        }
+    }
+
+    /// The fingerprint trusted for `host`, without prompting or probing.
+    func knownHostFingerprint(for host: Host) async -> String? {
+        try? await knownHostsStore.fingerprint(hostname: host.hostname, port: host.port)
+    }
+
     func trustKnownHost(challenge: KnownHostVerificationChallenge) async throws {
         do {
             try await knownHostsStore.trust(challenge: challenge)
@@ -701,6 +1163,28 @@ final class SessionManager: ObservableObject {
         }
     }
 
+    func importOpenSSHKnownHosts(contents: String) async throws -> KnownHostsImportResult {
+        do {
+            let result = try await knownHostsStore.importOpenSSHKnownHosts(contents)
+            await refreshKnownHosts()
+            await auditLogManager?.record(
+                category: .hostVerification,
+                action: "Known hosts imported",
+                outcome: .success,
+                details: "Imported=\(result.imported), hashed=\(result.hashed), skipped=\(result.skipped)."
+            )
+            return result
+        } catch {
+            await auditLogManager?.record(
+                category: .hostVerification,
+                action: "Known hosts import failed",
+                outcome: .failure,
+                details: error.localizedDescription
+            )
+            throw error
+        }
+    }
+
     func clearKnownHosts() async {
         do {
             try await knownHostsStore.clearAll()
@@ -721,6 +1205,12 @@ final class SessionManager: ObservableObject {
         }
     }
 
+    /// Load the known-hosts store ahead of the first connection; failures
+    /// surface again when a connection evaluates a host key.
+    func preloadKnownHosts() async {
+        try? await knownHostsStore.preload()
+    }
+
     func refreshKnownHosts() async {
         do {
             knownHosts = try await knownHostsStore.allEntries()
@@ -732,11 +1222,7 @@ final class SessionManager: ObservableObject {
 
     private func openShell(for session: Session) async throws {
         let desiredPTY = renderingCoordinator.sanitizedPTY(for: session.id)
-        let channel = try await transport.openShell(
-            sessionID: session.id,
-            pty: desiredPTY,
-            enableAgentForwarding: session.usesAgentForwarding
-        )
+        let channel = try await openShellChannel(for: session, pty: desiredPTY)
         shellChannels[session.id] = channel
 
         // Wire response handler so the parser can send CPR/DA responses
@@ -758,7 +1244,29 @@ final class SessionManager: ObservableObject {
             // Non-fatal: subsequent resize events will retry synchronization.
         }
 
-        shellIOCoordinator.startParserReader(for: session.id, rawOutput: channel.rawOutput)
+        shellIOCoordinator.startParserReader(for: session.id, channel: channel)
+    }
+
+    /// A mosh channel when enabled and the host is reached directly,
+    /// otherwise (or if mosh-server cannot be started) the SSH shell.
+    private func openShellChannel(for session: Session, pty: PTYConfiguration) async throws -> any SSHShellChannel {
+        if moshTransportEnabled, jumpHostBySessionID[session.id] == nil {
+            do {
+                return try await MoshBootstrap.start(
+                    sessionID: session.id,
+                    transport: transport,
+                    hostname: session.hostname,
+                    pty: pty
+                )
+            } catch {
+                Self.logger.info("Mosh unavailable for \(session.hostname), using SSH shell: \(error.localizedDescription, privacy: .public)")
+            }
+        }
+        return try await transport.openShell(
+            sessionID: session.id,
+            pty: pty,
+            enableAgentForwarding: session.usesAgentForwarding
+        )
     }
 
     private func configureHistoryTracking(for session: Session, engine: TerminalEngine,
@@ -770,14 +1278,26 @@ final class SessionManager: ObservableObject {
             hostname: session.hostname,
             shellIntegration: shellIntegration
         )
-        await engine.setSemanticPromptEventHandler { [weak self] event in
+        let maxOutputCharacters = historyIndex.maxOutputCharacters
+        await engine.setSemanticPromptEventHandler { [weak self, weak engine] event in
             await self?.renderingCoordinator.noteSemanticPromptEvent(sessionID: session.id, event: event)
+            // Output is read from the lines between the OSC 133;C mark and
+            // the cursor, instead of diffing screen text.
+            var capturedOutput: String?
+            switch event {
+            case .promptStart, .commandEnd:
+                capturedOutput = await engine?.takeSemanticCommandOutput(maxCharacters: maxOutputCharacters)
+            case .promptEnd, .commandStart:
+                break
+            }
             let completedBlock = await historyIndex.recordSemanticEvent(
                 sessionID: session.id,
-                event: event
+                event: event,
+                capturedOutput: capturedOutput
             )
             if let completedBlock {
                 await self?.publishCommandCompletion(completedBlock)
+                await self?.commandFoldingCoordinator.commandCompleted(completedBlock)
             }
         }
     }
@@ -813,7 +1333,7 @@ final class SessionManager: ObservableObject {
         session.endedAt = .now
         session.errorMessage = "Connection lost. Reconnecting when network is available."
         replaceSession(session)
-        keepaliveCoordinator.stopIfIdle()
+        keepaliveCoordinator.stopTracking(sessionID: sessionID)
 
         let host = hostBySessionID[sessionID]
         let jumpHost = jumpHostBySessionID[sessionID]
@@ -834,12 +1354,21 @@ final class SessionManager: ObservableObject {
         if let completedBlock = await terminalHistoryIndex.flushActiveCommand(sessionID: sessionID, at: .now) {
             publishCommandCompletion(completedBlock)
         }
+        if case .ssh(let hostID) = session.kind, let engine = engines[sessionID] {
+            await resumeCoordinator.capture(hostID: hostID, engine: engine)
+        }
         recordingCoordinator.finalizeIfNeeded(sessionID: sessionID)
         removeSessionArtifacts(sessionID: sessionID)
         await transport.disconnect(sessionID: sessionID)
         reconnectCoordinator.scheduleReconnect(for: sessionID, host: host, jumpHost: jumpHost)
     }
 
+    /// Returns and forgets the recorded session replacements.
+    func takeSessionReplacements() -> [UUID: UUID] {
+        defer { sessionReplacements.removeAll() }
+        return sessionReplacements
+    }
+
     private func replaceSession(_ updatedSession: Session) {
         guard let index = sessions.firstIndex(where: { $0.id == updatedSession.id }) else {
             return
@@ -859,9 +1388,11 @@ final class SessionManager: ObservableObject {
         hostBySessionID.removeValue(forKey: sessionID)
         jumpHostBySessionID.removeValue(forKey: sessionID)
         sessions.removeAll(where: { $0.id == sessionID })
+        workspaceCoordinator.forget(sessionID: sessionID)
         recordingCoordinator.finalizeIfNeeded(sessionID: sessionID)
         hasRecordingBySessionID.removeValue(forKey: sessionID)
         latestRecordingURLBySessionID.removeValue(forKey: sessionID)
+        thumbnailStore.remove(sessionID: sessionID)
         removeSessionArtifacts(sessionID: sessionID)
         Task { [terminalHistoryIndex] in
             await terminalHistoryIndex.removeSession(sessionID: sessionID)
@@ -869,27 +1400,32 @@ final class SessionManager: ObservableObject {
     }
 
     private func removeSessionArtifacts(sessionID: UUID) {
+        metricsCoordinator.sessionEnded(sessionID)
+        remoteEditCoordinator.sessionEnded(sessionID)
+        tmuxCoordinator.sessionEnded(sessionID)
+        mirrorCoordinator.sessionEnded(sessionID)
+        inBandTransferCoordinator.sessionEnded(sessionID)
         shellIOCoordinator.cancelParserTask(for: sessionID)
+        sessionLogCoordinator.sessionEnded(sessionID)
         renderingCoordinator.cleanupSession(sessionID)
+        sftpCoordinator.forget(sessionID: sessionID)
         shellChannels.removeValue(forKey: sessionID)
         engines.removeValue(forKey: sessionID)
-        shellBuffers.removeValue(forKey: sessionID)
-        bellEventNonceBySessionID.removeValue(forKey: sessionID)
-        inputModeSnapshotsBySessionID.removeValue(forKey: sessionID)
-        gridSnapshotNonceBySessionID.removeValue(forKey: sessionID)
         isRecordingBySessionID[sessionID] = false
         isPlaybackRunningBySessionID[sessionID] = false
-        workingDirectoryBySessionID.removeValue(forKey: sessionID)
-        bytesReceivedBySessionID.removeValue(forKey: sessionID)
-        bytesSentBySessionID.removeValue(forKey: sessionID)
-        latestCompletedCommandBlockBySessionID.removeValue(forKey: sessionID)
-        commandCompletionNonceBySessionID.removeValue(forKey: sessionID)
+        recordingCoordinator.cancelPlayback(sessionID: sessionID)
+        liveStates.removeValue(forKey: sessionID)
         latestPublishedCommandBlockIDBySessionID.removeValue(forKey: sessionID)
-        scrollStateBySessionID.removeValue(forKey: sessionID)
     }
 
     func publishCommandCompletion(_ block: CommandBlock) {
         aiToolCoordinator.publishCommandCompletion(block)
+        if let commandHistoryStore, let session = sessions.first(where: { $0.id == block.sessionID }) {
+            let host = session.isLocal ? "local" : "\(session.username)@\(session.hostname):\(session.port)"
+            Task {
+                await commandHistoryStore.append(block, host: host)
+            }
+        }
     }
 
     private func evaluateKnownHost(
@@ -916,12 +1452,29 @@ final class SessionManager: ObservableObject {
         }
     }
 
+    /// The current TOTP code for a keyboard-interactive host with a saved
+    /// TOTP secret.
+    private func totpCode(for host: Host, sessionID: UUID) async -> String? {
+        guard host.authMethod == .keyboardInteractive,
+              let config = host.totpConfiguration,
+              let secret = try? await totpStore?.retrieveSecret(forHostID: host.id) else {
+            return nil
+        }
+        let result = TOTPGenerator().generateSmartCode(secret: secret, configuration: config)
+        await auditLogManager?.record(
+            category: .authentication,
+            action: "TOTP 2FA auto-fill",
+            outcome: .info,
+            host: host,
+            sessionID: sessionID,
+            details: "Code valid for \(result.secondsRemaining)s, issuer: \(config.issuer ?? "unknown")"
+        )
+        return result.code
+    }
+
     private func resolveJumpHostFingerprint(for jumpHost: Host) async throws -> String {
-        let entries = try await knownHostsStore.allEntries()
-        if let entry = entries.first(where: {
-            $0.hostname == jumpHost.hostname && $0.port == jumpHost.port
-        }) {
-            return entry.fingerprint
+        if let fingerprint = try await knownHostsStore.fingerprint(hostname: jumpHost.hostname, port: jumpHost.port) {
+            return fingerprint
         }
 
         let probeSessionID = UUID()
@@ -968,6 +1521,7 @@ final class SessionManager: ObservableObject {
         let obsolete = sessions
             .filter { $0.hostID == hostID && $0.id != keepSessionID && $0.state != .connected }
             .map(\.id)
+            .filter { !workspaceCoordinator.isDormant($0) }
 
         for sessionID in obsolete {
             removeSession(sessionID: sessionID)
@@ -990,15 +1544,17 @@ final class SessionManager: ObservableObject {
             engines[session.id] = engine
 
             renderingCoordinator.initializePTY(for: session.id)
-            shellBuffers[session.id] = []
-            bellEventNonceBySessionID[session.id] = 0
+            let live = liveState(for: session.id)
+            live.shellBuffer = []
+            live.bellEventNonce = 0
             isRecordingBySessionID[session.id] = false
             hasRecordingBySessionID[session.id] = false
             isPlaybackRunningBySessionID[session.id] = false
 
             // Inject realistic traffic counters
-            bytesReceivedBySessionID[session.id] = Int64.random(in: 8_000...250_000)
-            bytesSentBySessionID[session.id] = Int64.random(in: 1_000...50_000)
+            live.bytesReceived = Int64.random(in: 8_000...250_000)
+            live.bytesSent = Int64.random(in: 1_000...50_000)
+            live.sampleTraffic()
 
             // Feed realistic terminal output for the first (primary) session
             if session.id == sampleSessions.first?.id {
@@ -1009,9 +1565,9 @@ final class SessionManager: ObservableObject {
 
             let snapshot = await engine.snapshot()
             renderingCoordinator.gridSnapshotsBySessionID[session.id] = snapshot
-            gridSnapshotNonceBySessionID[session.id] = 1
-            inputModeSnapshotsBySessionID[session.id] = await engine.inputModeSnapshot()
-            shellBuffers[session.id] = await engine.visibleText()
+            live.gridSnapshotNonce = 1
+            live.inputModeSnapshot = await engine.inputModeSnapshot()
+            live.shellBuffer = await engine.visibleText()
         }
     }
 }
@@ -0,0 +1,132 @@
+// SessionMetricsCoordinator.swift
+// ProSSHV2
+//
+// Runs RemoteMetricsSampler on one exec channel per SSH session while
+// something wants its samples, and publishes each sample as the session's
+// `SessionLiveState.hostMetrics`. The metadata panel holds the channel
+// open while it is shown (`retain`/`release`); the AI tools lease it for
+// `aiLease` on each read, so a conversation asking about the host every
+// few turns keeps one channel instead of opening one per question.
+//
+// tmux pane sessions sample through the SSH session running control mode.
+// A server that refuses the exec channel, or a sampler that exits, leaves
+// the session without metrics until it reconnects; nothing is retried.
+
+import Foundation
+import os.log
+
+@MainActor final class SessionMetricsCoordinator {
+    weak var manager: SessionManager?
+
+    /// How long an AI read keeps the sampler running with no panel shown.
+    static let aiLease: Duration = .seconds(120)
+
+    private static let logger = Logger(subsystem: "com.prossh", category: "HostMetrics")
+
+    private final class Stream {
+        var task: Task<Void, Never>?
+        var panelCount = 0
+        var leaseExpiry: ContinuousClock.Instant?
+    }
+
+    private var streamsBySessionID: [UUID: Stream] = [:]
+    /// Sessions whose server refused the channel or whose sampler exited.
+    private var unavailableSessionIDs: Set<UUID> = []
+
+    init() {}
+
+    nonisolated deinit {}
+
+    /// The session whose exec channel samples for `sessionID`: itself, or
+    /// the control mode session of a tmux pane.
+    func samplingSessionID(for sessionID: UUID) -> UUID {
+        manager?.tmuxCoordinator.controlSessionID(ofPane: sessionID) ?? sessionID
+    }
+
+    // MARK: - Subscribers
+
+    /// The metadata panel for `sessionID` appeared.
+    func retain(sessionID: UUID) {
+        let id = samplingSessionID(for: sessionID)
+        guard let stream = startIfNeeded(sessionID: id) else { return }
+        stream.panelCount += 1
+    }
+
+    /// The metadata panel for `sessionID` went away.
+    func release(sessionID: UUID) {
+        let id = samplingSessionID(for: sessionID)
+        guard let stream = streamsBySessionID[id] else { return }
+        stream.panelCount = max(stream.panelCount - 1, 0)
+        stopIfUnused(sessionID: id)
+    }
+
+    /// The newest sample for the AI tools, starting the sampler if needed.
+    /// The first call after a start returns nil; the sample follows within
+    /// a second.
+    func latestSample(sessionID: UUID) -> RemoteHostMetrics? {
+        let id = samplingSessionID(for: sessionID)
+        guard let stream = startIfNeeded(sessionID: id) else { return nil }
+        stream.leaseExpiry = .now + Self.aiLease
+        return manager?.liveStates[id]?.hostMetrics
+    }
+
+    /// Stops the sampler of a removed session and forgets its availability.
+    func sessionEnded(_ sessionID: UUID) {
+        streamsBySessionID.removeValue(forKey: sessionID)?.task?.cancel()
+        unavailableSessionIDs.remove(sessionID)
+    }
+
+    // MARK: - Channel
+
+    private func startIfNeeded(sessionID: UUID) -> Stream? {
+        if let stream = streamsBySessionID[sessionID] {
+            return stream
+        }
+        guard let manager, manager.hostMetricsEnabled,
+              !unavailableSessionIDs.contains(sessionID),
+              let session = manager.sessions.first(where: { $0.id == sessionID && $0.state == .connected }),
+              !session.isLocal else { return nil }
+
+        let stream = Stream()
+        streamsBySessionID[sessionID] = stream
+        let command = RemoteMetricsSampler.command(interval: manager.hostMetricsIntervalSeconds)
+        stream.task = Task { [weak self, transport = manager.transport] in
+            do {
+                let events = try await transport.runCommand(sessionID: sessionID, command: command)
+                var decoder = RemoteMetricsLineDecoder()
+                for try await event in events {
+                    guard case .stdout(let data) = event else { continue }
+                    for sample in decoder.decode(data) {
+                        self?.publish(sample, sessionID: sessionID)
+                    }
+                }
+            } catch is CancellationError {
+                return
+            } catch {
+                Self.logger.debug("Host metrics channel failed: \(error.localizedDescription, privacy: .public)")
+            }
+            guard !Task.isCancelled else { return }
+            self?.channelEnded(sessionID: sessionID)
+        }
+        return stream
+    }
+
+    private func publish(_ sample: RemoteHostMetrics, sessionID: UUID) {
+        guard let manager, let stream = streamsBySessionID[sessionID] else { return }
+        manager.liveState(for: sessionID).update(\.hostMetrics, to: sample)
+        stopIfUnused(sessionID: sessionID, stream: stream)
+    }
+
+    private func channelEnded(sessionID: UUID) {
+        streamsBySessionID.removeValue(forKey: sessionID)
+        unavailableSessionIDs.insert(sessionID)
+    }
+
+    /// Closes the channel once no panel shows it and the AI lease ran out.
+    private func stopIfUnused(sessionID: UUID, stream: Stream? = nil) {
+        guard let stream = stream ?? streamsBySessionID[sessionID], stream.panelCount == 0 else { return }
+        if let expiry = stream.leaseExpiry, expiry > .now { return }
+        stream.task?.cancel()
+        streamsBySessionID.removeValue(forKey: sessionID)
+    }
+}
@@ -0,0 +1,378 @@
+// SessionMirrorCoordinator.swift
+// ProSSHV2
+//
+// Read-only mirroring of a session to viewers on other Macs (see
+// SessionMirrorViewer). A mirrored session gets a snapshot feed of its own
+// from TerminalRenderingCoordinator and a WebSocket listener advertised
+// over Bonjour. At most every `frameInterval` the newest snapshot is
+// encoded once by GridMirrorEncoder and the frame is sent to every viewer,
+// so bandwidth follows what changes on screen rather than the viewer count
+// or a video bitrate. While nobody watches, snapshots are left in the
+// feed, whose merged damage brings the encoder up to date when a viewer
+// joins.
+//
+// Viewers never write to the session: what they send is read and dropped.
+// The connection is TLS keyed by the share's access code (a pre-shared
+// key), so only someone given the code can watch and the code itself never
+// crosses the network. A viewer whose backlog grows past
+// `viewerBacklogLimit` skips frames and catches up with a keyframe.
+
+import Foundation
+import Network
+import CryptoKit
+import Security
+import SystemConfiguration
+import os.log
+
+/// A session being mirrored, as the tab bar shows it.
+struct SessionMirrorShare: Equatable, Sendable {
+    let sessionID: UUID
+    /// Bonjour name viewers see.
+    let serviceName: String
+    /// Code a viewer enters to watch.
+    let accessCode: String
+    /// Listening port, once the listener is up.
+    var port: UInt16?
+    var viewerCount = 0
+    var errorMessage: String?
+}
+
+enum SessionMirrorError: LocalizedError {
+    case sessionNotFound
+
+    var errorDescription: String? {
+        switch self {
+        case .sessionNotFound:
+            return "The session is no longer open."
+        }
+    }
+}
+
+@MainActor final class SessionMirrorCoordinator {
+    weak var manager: SessionManager?
+
+    /// Shortest time between two frames.
+    static let frameInterval: Duration = .milliseconds(33)
+    /// Bytes queued to one viewer before it skips frames.
+    static let viewerBacklogLimit = 1 << 20
+    static let maximumViewers = 16
+
+    private static let logger = Logger(subsystem: "com.prossh", category: "SessionMirror")
+
+    private final class Viewer {
+        let connection: NWConnection
+        var isReady = false
+        /// Bytes handed to the connection and not yet sent.
+        var pendingBytes = 0
+        /// Joined or fell behind; gets a keyframe once its backlog drains.
+        var needsKeyframe = true
+
+        init(connection: NWConnection) {
+            self.connection = connection
+        }
+    }
+
+    private final class Broadcast {
+        let listener: NWListener
+        let feed: GridSnapshotFeed
+        var share: SessionMirrorShare
+        var encoder = GridMirrorEncoder()
+        var viewers: [UUID: Viewer] = [:]
+        var frameTask: Task<Void, Never>?
+        var lastFrameAt: ContinuousClock.Instant?
+
+        init(listener: NWListener, feed: GridSnapshotFeed, share: SessionMirrorShare) {
+            self.listener = listener
+            self.feed = feed
+            self.share = share
+        }
+    }
+
+    private var broadcasts: [UUID: Broadcast] = [:]
+
+    init() {}
+
+    nonisolated deinit {}
+
+    // MARK: - Sharing
+
+    /// Starts mirroring `sessionID`, or returns the share already running.
+    @discardableResult
+    func startSharing(sessionID: UUID) throws -> SessionMirrorShare {
+        if let existing = broadcasts[sessionID] {
+            return existing.share
+        }
+        guard let manager, let session = manager.sessions.first(where: { $0.id == sessionID }) else {
+            throw SessionMirrorError.sessionNotFound
+        }
+
+        let accessCode = SessionMirrorConnection.makeAccessCode()
+        let listener = try NWListener(using: SessionMirrorConnection.parameters(accessCode: accessCode, isListener: true))
+        let label = session.isLocal ? "Local Terminal" : session.hostLabel
+        let computerName = SCDynamicStoreCopyComputerName(nil, nil) as String? ?? "Mac"
+        let serviceName = "\(label) on \(computerName)"
+        listener.service = NWListener.Service(name: serviceName, type: SessionMirrorConnection.serviceType)
+
+        let broadcast = Broadcast(
+            listener: listener,
+            feed: manager.renderingCoordinator.attachMirrorFeed(for: sessionID),
+            share: SessionMirrorShare(sessionID: sessionID, serviceName: serviceName, accessCode: accessCode)
+        )
+        broadcasts[sessionID] = broadcast
+        broadcast.feed.onPublish = { [weak self] in
+            self?.scheduleFrame(for: sessionID)
+        }
+
+        listener.newConnectionHandler = { @Sendable [weak self] connection in
+            Task { @MainActor [weak self] in
+                self?.accept(connection, sessionID: sessionID)
+            }
+        }
+        listener.stateUpdateHandler = { @Sendable [weak self] state in
+            Task { @MainActor [weak self] in
+                self?.listenerStateChanged(state, sessionID: sessionID)
+            }
+        }
+        listener.start(queue: DispatchQueue(label: "prosshv2.mirror.\(sessionID.uuidString)"))
+
+        Self.logger.info("Mirroring session \(sessionID.uuidString, privacy: .public)")
+        Task { [weak manager] in
+            await manager?.recordSessionAudit("Read-only mirroring started", sessionID: sessionID)
+        }
+        publish()
+        return broadcast.share
+    }
+
+    /// Stops mirroring `sessionID` and disconnects its viewers.
+    func stopSharing(sessionID: UUID) {
+        guard let broadcast = broadcasts.removeValue(forKey: sessionID) else { return }
+        broadcast.frameTask?.cancel()
+        broadcast.feed.onPublish = nil
+        broadcast.listener.cancel()
+        for viewer in broadcast.viewers.values {
+            viewer.connection.cancel()
+        }
+        manager?.renderingCoordinator.detachMirrorFeed(for: sessionID)
+        Self.logger.info("Stopped mirroring session \(sessionID.uuidString, privacy: .public)")
+        Task { [weak manager] in
+            await manager?.recordSessionAudit("Read-only mirroring stopped", sessionID: sessionID)
+        }
+        publish()
+    }
+
+    func sessionEnded(_ sessionID: UUID) {
+        stopSharing(sessionID: sessionID)
+    }
+
+    private func listenerStateChanged(_ state: NWListener.State, sessionID: UUID) {
+        guard let broadcast = broadcasts[sessionID] else { return }
+        switch state {
+        case .ready:
+            broadcast.share.port = broadcast.listener.port?.rawValue
+            broadcast.share.errorMessage = nil
+        case .failed(let error):
+            Self.logger.error("Mirror listener failed: \(error.localizedDescription, privacy: .public)")
+            broadcast.share.errorMessage = error.localizedDescription
+        default:
+            return
+        }
+        publish()
+    }
+
+    // MARK: - Viewers
+
+    private func accept(_ connection: NWConnection, sessionID: UUID) {
+        guard let broadcast = broadcasts[sessionID], broadcast.viewers.count < Self.maximumViewers else {
+            connection.cancel()
+            return
+        }
+        let viewerID = UUID()
+        broadcast.viewers[viewerID] = Viewer(connection: connection)
+        connection.stateUpdateHandler = { @Sendable [weak self] state in
+            Task { @MainActor [weak self] in
+                self?.viewerStateChanged(state, viewerID: viewerID, sessionID: sessionID)
+            }
+        }
+        Self.discardIncoming(on: connection)
+        connection.start(queue: DispatchQueue(label: "prosshv2.mirror.viewer.\(viewerID.uuidString)"))
+    }
+
+    private func viewerStateChanged(_ state: NWConnection.State, viewerID: UUID, sessionID: UUID) {
+        guard let broadcast = broadcasts[sessionID], let viewer = broadcast.viewers[viewerID] else { return }
+        switch state {
+        case .ready:
+            viewer.isReady = true
+            Self.logger.info("Mirror viewer joined")
+            pump(broadcast)
+        case .failed, .cancelled:
+            viewer.connection.cancel()
+            broadcast.viewers.removeValue(forKey: viewerID)
+        default:
+            return
+        }
+        publish()
+    }
+
+    /// Reads and drops whatever a viewer sends; the mirror is read-only.
+    /// A close frame or an error ends the connection.
+    nonisolated private static func discardIncoming(on connection: NWConnection) {
+        connection.receiveMessage { content, context, _, error in
+            let metadata = context?.protocolMetadata(definition: NWProtocolWebSocket.definition) as? NWProtocolWebSocket.Metadata
+            guard error == nil, metadata?.opcode != .close, content != nil || metadata != nil else {
+                connection.cancel()
+                return
+            }
+            discardIncoming(on: connection)
+        }
+    }
+
+    // MARK: - Frames
+
+    private func scheduleFrame(for sessionID: UUID) {
+        guard let broadcast = broadcasts[sessionID], broadcast.frameTask == nil,
+              broadcast.viewers.values.contains(where: \.isReady) else { return }
+        let elapsed = broadcast.lastFrameAt.map { ContinuousClock.now - $0 } ?? Self.frameInterval
+        guard elapsed < Self.frameInterval else {
+            pump(broadcast)
+            return
+        }
+        broadcast.frameTask = Task { [weak self] in
+            try? await Task.sleep(for: Self.frameInterval - elapsed)
+            guard let self, let broadcast = self.broadcasts[sessionID], !Task.isCancelled else { return }
+            broadcast.frameTask = nil
+            self.pump(broadcast)
+        }
+    }
+
+    /// Encodes the newest snapshot once and sends the frame to every viewer
+    /// keeping up; viewers waiting to catch up get a keyframe instead.
+    private func pump(_ broadcast: Broadcast) {
+        broadcast.lastFrameAt = .now
+        let frame = broadcast.feed.takeLatest().flatMap { broadcast.encoder.encode($0) }
+        var keyframe: Data?
+        for (viewerID, viewer) in broadcast.viewers where viewer.isReady {
+            if !viewer.needsKeyframe {
+                guard let frame else { continue }
+                if viewer.pendingBytes + frame.count > Self.viewerBacklogLimit {
+                    viewer.needsKeyframe = true
+                } else {
+                    send(frame, to: viewer, viewerID: viewerID, sessionID: broadcast.share.sessionID)
+                }
+            } else if viewer.pendingBytes == 0 {
+                if keyframe == nil {
+                    keyframe = broadcast.encoder.keyframe()
+                }
+                guard let keyframe else { continue }
+                viewer.needsKeyframe = false
+                send(keyframe, to: viewer, viewerID: viewerID, sessionID: broadcast.share.sessionID)
+            }
+        }
+    }
+
+    private func send(_ frame: Data, to viewer: Viewer, viewerID: UUID, sessionID: UUID) {
+        let size = frame.count
+        viewer.pendingBytes += size
+        viewer.connection.send(
+            content: frame,
+            contentContext: SessionMirrorConnection.binaryMessage,
+            isComplete: true,
+            completion: .contentProcessed { @Sendable [weak self] error in
+                let failed = error != nil
+                Task { @MainActor [weak self] in
+                    self?.frameSent(size, failed: failed, viewerID: viewerID, sessionID: sessionID)
+                }
+            }
+        )
+    }
+
+    private func frameSent(_ size: Int, failed: Bool, viewerID: UUID, sessionID: UUID) {
+        guard let broadcast = broadcasts[sessionID], let viewer = broadcast.viewers[viewerID] else { return }
+        viewer.pendingBytes -= size
+        if failed {
+            viewer.connection.cancel()
+        } else if viewer.needsKeyframe, viewer.pendingBytes == 0 {
+            pump(broadcast)
+        }
+    }
+
+    // MARK: - Publishing
+
+    private func publish() {
+        var shares: [UUID: SessionMirrorShare] = [:]
+        for (sessionID, broadcast) in broadcasts {
+            var share = broadcast.share
+            share.viewerCount = broadcast.viewers.values.filter(\.isReady).count
+            shares[sessionID] = share
+        }
+        manager?.setMirrorShares(shares)
+    }
+}
+
+// MARK: - SessionMirrorConnection
+
+/// What the sharing and the watching side agree on.
+nonisolated enum SessionMirrorConnection {
+    static let serviceType = "_prossh-mirror._tcp"
+    /// WebSocket subprotocol; a new frame version gets a new name.
+    static let subprotocol = "prossh-mirror.v\(GridMirrorFrame.version)"
+    /// PSK identity and the label the access code is stretched under.
+    private static let pskIdentity = "com.prossh.mirror"
+    /// Access codes leave out characters that read alike.
+    private static let codeAlphabet = Array("ABCDEFGHJKMNPQRSTUVWXYZ23456789")
+    private static let codeLength = 10
+
+    static var binaryMessage: NWConnection.ContentContext {
+        NWConnection.ContentContext(
+            identifier: "mirror-frame",
+            metadata: [NWProtocolWebSocket.Metadata(opcode: .binary)]
+        )
+    }
+
+    /// A fresh code, shown as two groups of five.
+    static func makeAccessCode() -> String {
+        var generator = SystemRandomNumberGenerator()
+        let characters = (0..<codeLength).map { _ in codeAlphabet.randomElement(using: &generator)! }
+        return String(characters.prefix(codeLength / 2)) + "-" + String(characters.suffix(codeLength / 2))
+    }
+
+    /// `code` as typed, without separators and in upper case.
+    static func normalizedAccessCode(_ code: String) -> String {
+        String(code.uppercased().filter { $0.isLetter || $0.isNumber })
+    }
+
+    /// TLS with a key derived from `accessCode`, under a WebSocket that
+    /// speaks `subprotocol`. A peer with another code fails the handshake.
+    static func parameters(accessCode: String, isListener: Bool) -> NWParameters {
+        let tls = NWProtocolTLS.Options()
+        let key = SymmetricKey(data: Data(normalizedAccessCode(accessCode).utf8))
+        let psk = HMAC<SHA256>.authenticationCode(for: Data(pskIdentity.utf8), using: key)
+        let pskData = psk.withUnsafeBytes { DispatchData(bytes: $0) }
+        let identityData = Data(pskIdentity.utf8).withUnsafeBytes { DispatchData(bytes: $0) }
+        sec_protocol_options_add_pre_shared_key(
+            tls.securityProtocolOptions,
+            pskData as __DispatchData,
+            identityData as __DispatchData
+        )
+        if let suite = tls_ciphersuite_t(rawValue: UInt16(TLS_PSK_WITH_AES_128_GCM_SHA256)) {
+            sec_protocol_options_append_tls_ciphersuite(tls.securityProtocolOptions, suite)
+        }
+
+        let parameters = NWParameters(tls: tls)
+        parameters.includePeerToPeer = true
+        let webSocket = NWProtocolWebSocket.Options()
+        webSocket.autoReplyPing = true
+        webSocket.maximumMessageSize = 16 * 1024 * 1024
+        if isListener {
+            webSocket.setClientRequestHandler(DispatchQueue(label: "prosshv2.mirror.handshake")) { subprotocols, _ in
+                guard subprotocols.contains(subprotocol) else {
+                    return NWProtocolWebSocket.Response(status: .reject, subprotocol: nil)
+                }
+                return NWProtocolWebSocket.Response(status: .accept, subprotocol: subprotocol)
+            }
+        } else {
+            webSocket.setSubprotocols([subprotocol])
+        }
+        parameters.defaultProtocolStack.applicationProtocols.insert(webSocket, at: 0)
+        return parameters
+    }
+}
@@ -0,0 +1,160 @@
+// SessionMirrorViewer.swift
+// ProSSHV2
+//
+// The watching side of session mirroring (see SessionMirrorCoordinator).
+// Browses Bonjour for mirrored sessions, connects to one with its access
+// code, and decodes the frames into grid snapshots on a GridSnapshotFeed,
+// so the session renders locally through the same Metal surface as a pane.
+// Nothing typed in the viewer is sent.
+
+import Foundation
+import Network
+import os.log
+
+/// A mirrored session offered on the local network.
+struct SessionMirrorService: Identifiable, Hashable, Sendable {
+    let name: String
+    let endpoint: NWEndpoint
+
+    var id: String { name }
+}
+
+@MainActor
+final class SessionMirrorViewer: ObservableObject {
+    enum State: Equatable {
+        case idle
+        case connecting(String)
+        case watching(String)
+        case failed(String)
+    }
+
+    @Published private(set) var state: State = .idle
+    @Published private(set) var services: [SessionMirrorService] = []
+
+    /// Feed the viewer's terminal surface pulls from.
+    let feed = GridSnapshotFeed()
+    /// Stands in for a session ID on the terminal surface.
+    let surfaceID = UUID()
+    private(set) var latestSnapshot: GridSnapshot?
+
+    private var decoder = GridMirrorDecoder()
+    private var connection: NWConnection?
+    private var browser: NWBrowser?
+
+    private static let logger = Logger(subsystem: "com.prossh", category: "SessionMirror")
+
+    init() {}
+
+    nonisolated deinit {}
+
+    // MARK: - Browsing
+
+    func startBrowsing() {
+        guard browser == nil else { return }
+        let parameters = NWParameters()
+        parameters.includePeerToPeer = true
+        let browser = NWBrowser(for: .bonjour(type: SessionMirrorConnection.serviceType, domain: nil), using: parameters)
+        browser.browseResultsChangedHandler = { @Sendable [weak self] results, _ in
+            let services = results.compactMap { result -> SessionMirrorService? in
+                guard case .service(let name, _, _, _) = result.endpoint else { return nil }
+                return SessionMirrorService(name: name, endpoint: result.endpoint)
+            }
+            Task { @MainActor [weak self] in
+                self?.services = services.sorted { $0.name.localizedStandardCompare($1.name) == .orderedAscending }
+            }
+        }
+        browser.start(queue: DispatchQueue(label: "prosshv2.mirror.browser"))
+        self.browser = browser
+    }
+
+    func stopBrowsing() {
+        browser?.cancel()
+        browser = nil
+        services = []
+    }
+
+    // MARK: - Watching
+
+    /// Connects to the mirror at `endpoint`, replacing any mirror watched.
+    func watch(_ endpoint: NWEndpoint, named name: String, accessCode: String) {
+        stopWatching()
+        decoder = GridMirrorDecoder()
+        latestSnapshot = nil
+        state = .connecting(name)
+
+        let connection = NWConnection(
+            to: endpoint,
+            using: SessionMirrorConnection.parameters(accessCode: accessCode, isListener: false)
+        )
+        self.connection = connection
+        connection.stateUpdateHandler = { @Sendable [weak self] state in
+            Task { @MainActor [weak self] in
+                self?.connectionStateChanged(state, connection: connection)
+            }
+        }
+        receiveNext(on: connection)
+        connection.start(queue: DispatchQueue(label: "prosshv2.mirror.watch"))
+    }
+
+    func stopWatching() {
+        connection?.cancel()
+        connection = nil
+        state = .idle
+    }
+
+    private func connectionStateChanged(_ state: NWConnection.State, connection: NWConnection) {
+        guard self.connection === connection else { return }
+        switch state {
+        case .waiting(let error), .failed(let error):
+            // A wrong access code fails the TLS handshake.
+            Self.logger.error("Mirror connection failed: \(error.localizedDescription, privacy: .public)")
+            fail("Could not connect. Check the access code and that the session is still mirrored.")
+        case .cancelled:
+            if case .watching = self.state {
+                fail("The session stopped mirroring.")
+            }
+        default:
+            break
+        }
+    }
+
+    private func receiveNext(on connection: NWConnection) {
+        connection.receiveMessage { @Sendable [weak self] content, context, _, error in
+            let metadata = context?.protocolMetadata(definition: NWProtocolWebSocket.definition) as? NWProtocolWebSocket.Metadata
+            let closed = error != nil || metadata?.opcode == .close || (content == nil && metadata == nil)
+            Task { @MainActor [weak self] in
+                guard let self, self.connection === connection else { return }
+                if closed {
+                    self.fail("The session stopped mirroring.")
+                    return
+                }
+                if let content, metadata?.opcode == .binary {
+                    self.handle(content)
+                }
+                if self.connection === connection {
+                    self.receiveNext(on: connection)
+                }
+            }
+        }
+    }
+
+    private func handle(_ frame: Data) {
+        do {
+            let snapshot = try decoder.apply(frame)
+            latestSnapshot = snapshot
+            feed.publish(snapshot)
+            if case .connecting(let name) = state {
+                state = .watching(name)
+            }
+        } catch {
+            Self.logger.error("Undecodable mirror frame: \(String(describing: error), privacy: .public)")
+            fail("The mirror sent a frame this version cannot show.")
+        }
+    }
+
+    private func fail(_ message: String) {
+        connection?.cancel()
+        connection = nil
+        state = .failed(message)
+    }
+}
@@ -0,0 +1,50 @@
+// SessionPipelineCounters.swift
+// ProSSHV2
+//
+// Running totals of one session's output pipeline, for the performance HUD
+// (see PerformanceHUDOverlay). The parser task adds the bytes it feeds and
+// the time spent in `TerminalEngine`. TerminalRenderingCoordinator adds
+// every snapshot handed to the panes and every publish it pushes back to
+// coalesce more output. The counters are monotonic; readers derive rates
+// from the difference between two reads.
+
+import Foundation
+import Synchronization
+
+nonisolated final class SessionPipelineCounters: Sendable {
+
+    private let parsedBytes = Atomic<UInt64>(0)
+    private let parseNanoseconds = Atomic<UInt64>(0)
+    private let snapshotsPublished = Atomic<UInt64>(0)
+    private let publishDeferrals = Atomic<UInt64>(0)
+
+    /// A parsed span of `byteCount` bytes that took `seconds` to feed.
+    func recordParse(byteCount: Int, seconds: Double) {
+        parsedBytes.add(UInt64(max(byteCount, 0)), ordering: .relaxed)
+        parseNanoseconds.add(UInt64(max(seconds, 0) * 1_000_000_000), ordering: .relaxed)
+    }
+
+    func recordSnapshotPublished() {
+        snapshotsPublished.add(1, ordering: .relaxed)
+    }
+
+    func recordPublishDeferral() {
+        publishDeferrals.add(1, ordering: .relaxed)
+    }
+
+    var totals: Totals {
+        Totals(
+            parsedBytes: parsedBytes.load(ordering: .relaxed),
+            parseSeconds: Double(parseNanoseconds.load(ordering: .relaxed)) / 1_000_000_000,
+            snapshotsPublished: snapshotsPublished.load(ordering: .relaxed),
+            publishDeferrals: publishDeferrals.load(ordering: .relaxed)
+        )
+    }
+
+    struct Totals: Sendable, Equatable {
+        var parsedBytes: UInt64 = 0
+        var parseSeconds: Double = 0
+        var snapshotsPublished: UInt64 = 0
+        var publishDeferrals: UInt64 = 0
+    }
+}
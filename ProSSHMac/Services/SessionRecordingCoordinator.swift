@@ -4,6 +4,12 @@ import Foundation
 @MainActor final class SessionRecordingCoordinator {
     weak var manager: SessionManager?
     private let sessionRecorder: SessionRecorder
+    /// Writes buffered chunks to disk while any recording is active.
+    private var flushTask: Task<Void, Never>?
+    /// The running playback segment per session. A seek cancels it and the
+    /// playback loop starts a new one at `seekTargets`.
+    private var playbackTasks: [UUID: Task<Bool, Never>] = [:]
+    private var seekTargets: [UUID: UInt64] = [:]
 
     init(sessionRecorder: SessionRecorder = SessionRecorder()) {
         self.sessionRecorder = sessionRecorder
@@ -25,9 +31,13 @@ import Foundation
     func startRecording(sessionID: UUID) async {
         guard let manager else { return }
         guard let session = manager.sessions.first(where: { $0.id == sessionID }) else { return }
+        let engine = manager.engines[sessionID]
+        let columns = await engine?.columns ?? 80
+        let rows = await engine?.rows ?? 24
         do {
-            try sessionRecorder.startRecording(for: session)
+            try sessionRecorder.startRecording(for: session, columns: columns, rows: rows)
             manager.isRecordingBySessionID[sessionID] = true
+            startFlushTimerIfNeeded()
             await manager.renderingCoordinator.appendShellLine("[Recorder] Started session capture.", to: sessionID)
         } catch {
             await manager.renderingCoordinator.appendShellLine("[Recorder] \(error.localizedDescription)", to: sessionID)
@@ -37,7 +47,7 @@ import Foundation
     func stopRecording(sessionID: UUID) async {
         guard let manager else { return }
         do {
-            let recordingURL = try sessionRecorder.stopRecording(sessionID: sessionID)
+            let recordingURL = try await sessionRecorder.stopRecording(sessionID: sessionID)
             manager.isRecordingBySessionID[sessionID] = false
             manager.hasRecordingBySessionID[sessionID] = true
             manager.latestRecordingURLBySessionID[sessionID] = recordingURL
@@ -52,27 +62,86 @@ import Foundation
         guard !manager.isPlaybackRunningBySessionID[sessionID, default: false] else { return }
 
         manager.isPlaybackRunningBySessionID[sessionID] = true
-        defer { manager.isPlaybackRunningBySessionID[sessionID] = false }
+        if let duration = sessionRecorder.latestRecordingDuration(sessionID: sessionID) {
+            manager.liveState(for: sessionID).playbackProgress = SessionPlaybackProgress(positionSeconds: 0, durationSeconds: duration)
+        }
+        defer {
+            manager.isPlaybackRunningBySessionID[sessionID] = false
+            manager.liveStates[sessionID]?.playbackProgress = nil
+            playbackTasks.removeValue(forKey: sessionID)
+            seekTargets.removeValue(forKey: sessionID)
+        }
 
-        do {
-            manager.renderingCoordinator.clearShellBuffer(sessionID: sessionID)
-            await manager.renderingCoordinator.appendShellLine("[Recorder] Playback started (\(String(format: "%.1fx", speed))).", to: sessionID)
-            try await sessionRecorder.playLatestRecording(sessionID: sessionID, speed: speed) { [weak self] step in
-                await self?.manager?.renderingCoordinator.applyPlaybackStep(step, to: sessionID)
+        manager.renderingCoordinator.clearShellBuffer(sessionID: sessionID)
+        let speedLabel = speed.isFinite ? String(format: "%.1fx", speed) : "max speed"
+        await manager.renderingCoordinator.appendShellLine("[Recorder] Playback started (\(speedLabel)).", to: sessionID)
+
+        var start: UInt64 = 0
+        while true {
+            let task = startPlaybackSegment(sessionID: sessionID, speed: speed, from: start)
+            playbackTasks[sessionID] = task
+            let finished = await task.value
+            await manager.renderingCoordinator.finishPlayback(sessionID: sessionID)
+            guard let target = seekTargets.removeValue(forKey: sessionID) else {
+                if finished {
+                    await manager.renderingCoordinator.appendShellLine("[Recorder] Playback finished.", to: sessionID)
+                }
+                return
+            }
+            start = target
+        }
+    }
+
+    /// Move a running playback to `seconds` into the recording.
+    func seekPlayback(sessionID: UUID, toSeconds seconds: Double) {
+        guard let task = playbackTasks[sessionID] else { return }
+        seekTargets[sessionID] = UInt64(max(0, seconds) * 1_000_000_000)
+        manager?.liveStates[sessionID]?.playbackProgress?.positionSeconds = max(0, seconds)
+        task.cancel()
+    }
+
+    func cancelPlayback(sessionID: UUID) {
+        seekTargets.removeValue(forKey: sessionID)
+        playbackTasks[sessionID]?.cancel()
+    }
+
+    /// Play from `start`; returns whether the recording played to its end.
+    private func startPlaybackSegment(sessionID: UUID, speed: Double, from start: UInt64) -> Task<Bool, Never> {
+        Task { @MainActor [weak self] in
+            guard let self else { return false }
+            do {
+                try await self.sessionRecorder.playLatestRecording(sessionID: sessionID, speed: speed, from: start) { [weak self] step in
+                    await self?.applyPlaybackStep(step, to: sessionID)
+                }
+                return !Task.isCancelled
+            } catch is CancellationError {
+                return false
+            } catch {
+                await self.manager?.renderingCoordinator.appendShellLine("[Recorder] Playback failed: \(error.localizedDescription)", to: sessionID)
+                return false
             }
-            await manager.renderingCoordinator.appendShellLine("[Recorder] Playback finished.", to: sessionID)
-        } catch {
-            await manager.renderingCoordinator.appendShellLine("[Recorder] Playback failed: \(error.localizedDescription)", to: sessionID)
         }
     }
 
-    func exportLastRecordingAsCast(sessionID: UUID, columns: Int = 80, rows: Int = 24) async {
+    private func applyPlaybackStep(_ step: SessionPlaybackStep, to sessionID: UUID) async {
+        guard let manager, !Task.isCancelled else { return }
+        await manager.renderingCoordinator.applyPlaybackStep(step, to: sessionID)
+        // Publish the position in quarter-second steps.
+        if let live = manager.liveStates[sessionID], var progress = live.playbackProgress,
+           abs(step.relativeSeconds - progress.positionSeconds) >= 0.25 {
+            progress.positionSeconds = min(step.relativeSeconds, progress.durationSeconds)
+            live.playbackProgress = progress
+        }
+    }
+
+    func exportLastRecordingAsCast(sessionID: UUID, columns: Int? = nil, rows: Int? = nil, gzip: Bool = false) async {
         guard let manager else { return }
         do {
-            let castURL = try sessionRecorder.exportLatestRecordingAsCast(
+            let castURL = try await sessionRecorder.exportLatestRecordingAsCast(
                 sessionID: sessionID,
                 columns: columns,
-                rows: rows
+                rows: rows,
+                gzip: gzip
             )
             await manager.renderingCoordinator.appendShellLine("[Recorder] Exported .cast: \(castURL.path(percentEncoded: false))", to: sessionID)
         } catch {
@@ -80,6 +149,27 @@ import Foundation
         }
     }
 
+    private func startFlushTimerIfNeeded() {
+        guard flushTask == nil else { return }
+        flushTask = Task { @MainActor [weak self] in
+            while !Task.isCancelled {
+                try? await Task.sleep(nanoseconds: SessionRecorder.flushIntervalNanoseconds)
+                guard let self, self.sessionRecorder.hasActiveRecordings else {
+                    self?.flushTask = nil
+                    return
+                }
+                self.sessionRecorder.flushActiveRecordings()
+            }
+        }
+    }
+
+    // MARK: - Memory
+
+    /// Write every recording's buffered output to disk.
+    func flushBuffers() {
+        sessionRecorder.flushAllRecordings()
+    }
+
     // MARK: - Input recording
 
     func recordInput(sessionID: UUID, text: String) {
@@ -103,7 +193,7 @@ import Foundation
         Task { @MainActor [weak self] in
             guard let self, let manager = self.manager else { return }
             do {
-                let recordingURL = try self.sessionRecorder.stopRecording(sessionID: sessionID)
+                let recordingURL = try await self.sessionRecorder.stopRecording(sessionID: sessionID)
                 manager.hasRecordingBySessionID[sessionID] = true
                 manager.latestRecordingURLBySessionID[sessionID] = recordingURL
             } catch {
@@ -112,3 +202,11 @@ import Foundation
         }
     }
 }
+
+// MARK: - MemoryFootprintReporting
+
+extension SessionRecordingCoordinator: MemoryFootprintReporting {
+    func memoryFootprint(for sessionID: UUID) -> MemoryFootprint {
+        MemoryFootprint(.recorder, bytes: sessionRecorder.bufferedByteCount(sessionID: sessionID))
+    }
+}
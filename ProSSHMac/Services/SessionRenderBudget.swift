@@ -0,0 +1,94 @@
+// SessionRenderBudget.swift
+// ProSSHV2
+//
+// Per-session render and publish budget. Every session used to publish
+// snapshots on the same 8/16 ms cadence, whether it was focused, visible in
+// a split or in a background tab. Now each session gets a tier from its
+// pane:
+//
+// - focused: the full rate; 8 ms publishes and the display's native refresh.
+// - visible: unfocused panes that are still on screen; 30 Hz.
+// - hidden: no pane draws it. Snapshots publish once a second, which keeps
+//   bells, titles and command completion current, and immediately when the
+//   pane is revealed.
+//
+// Under thermal pressure every interval stretches. At `.serious` they
+// double and at `.critical` they quadruple, and the focused pane drops from
+// native refresh to 60 or 30 fps.
+
+import Foundation
+
+// MARK: - SessionRenderTier
+
+/// How much of the render budget a session's pane gets, ordered from least
+/// to most. A session shown in several panes gets the highest tier.
+nonisolated enum SessionRenderTier: Int, Sendable, Comparable {
+    case hidden
+    case visible
+    case focused
+
+    static func < (lhs: SessionRenderTier, rhs: SessionRenderTier) -> Bool {
+        lhs.rawValue < rhs.rawValue
+    }
+}
+
+// MARK: - SessionRenderBudget
+
+nonisolated enum SessionRenderBudget {
+
+    /// Publish interval floor for visible, unfocused panes (30 Hz).
+    static let visiblePublishInterval: Duration = .milliseconds(33)
+
+    /// Publish interval for sessions no pane is drawing.
+    static let hiddenPublishInterval: Duration = .seconds(1)
+
+    /// Interval before publishing a session whose full-rate interval is
+    /// `base`; `base` already covers throughput and debounce modes.
+    static func publishInterval(
+        base: Duration,
+        tier: SessionRenderTier,
+        thermalState: ProcessInfo.ThermalState
+    ) -> Duration {
+        let interval: Duration
+        switch tier {
+        case .focused:
+            interval = base
+        case .visible:
+            interval = max(base, visiblePublishInterval)
+        case .hidden:
+            interval = max(base, hiddenPublishInterval)
+        }
+        return interval * thermalScale(thermalState)
+    }
+
+    /// Preferred frames per second for a pane's renderer; 0 follows the
+    /// display's native refresh rate (up to 120 Hz on ProMotion).
+    static func preferredFPS(tier: SessionRenderTier, thermalState: ProcessInfo.ThermalState) -> Int {
+        switch (tier, thermalState) {
+        case (.focused, .critical):
+            return 30
+        case (.focused, .serious):
+            return 60
+        case (.focused, _):
+            return 0
+        case (_, .critical):
+            return 15
+        case (_, .serious):
+            return 20
+        default:
+            return 30
+        }
+    }
+
+    /// Interval multiplier for `state`.
+    static func thermalScale(_ state: ProcessInfo.ThermalState) -> Int {
+        switch state {
+        case .serious:
+            return 2
+        case .critical:
+            return 4
+        default:
+            return 1
+        }
+    }
+}
@@ -0,0 +1,217 @@
+// SessionResumeCoordinator.swift
+// ProSSHV2
+//
+// Fast session resume. When a connection drops, the session's engine used
+// to be thrown away with it, and the automatic reconnect opened onto a
+// blank terminal. The screen, scrollback, cursor and modes are now saved,
+// while the engine is still alive, as the grid's keyframe
+// (`TerminalGrid.keyframeSequence`), LZ4-compressed. The reconnect feeds
+// that keyframe into the new session's engine before its first snapshot.
+// The previous screen is therefore back in the same pane while the
+// connection is still being made, and the new shell's prompt appears
+// below it.
+//
+// The program that drew the screen died with the connection, so after the
+// keyframe the restored terminal leaves the alternate screen and drops the
+// input modes it had asked for. If the program ran under tmux or screen,
+// it is still alive on the host. With
+// `SessionManager.reattachMultiplexerOnResume` set, the first detached
+// session found is reattached as soon as the new shell is up.
+
+import Foundation
+import Compression
+
+// MARK: - SessionResumeState
+
+/// A dropped session's terminal, kept until its host reconnects.
+nonisolated struct SessionResumeState: Sendable {
+    /// The keyframe bytes, LZ4-compressed when that made them smaller.
+    let storedKeyframe: [UInt8]
+    let isCompressed: Bool
+    let keyframeByteCount: Int
+    let columns: Int
+    let rows: Int
+    let wasAlternateScreen: Bool
+    let capturedAt: Date
+
+    init(keyframe: [UInt8], columns: Int, rows: Int, wasAlternateScreen: Bool, capturedAt: Date = .now) {
+        var compressed = [UInt8](repeating: 0, count: keyframe.count)
+        let size = keyframe.isEmpty ? 0 : keyframe.withUnsafeBufferPointer { source in
+            compressed.withUnsafeMutableBufferPointer { destination in
+                compression_encode_buffer(
+                    destination.baseAddress!, destination.count,
+                    source.baseAddress!, source.count,
+                    nil, COMPRESSION_LZ4
+                )
+            }
+        }
+        // Zero: it did not fit, so it is kept as is.
+        if size > 0 {
+            compressed.removeSubrange(size...)
+            self.storedKeyframe = compressed
+        } else {
+            self.storedKeyframe = keyframe
+        }
+        self.isCompressed = size > 0
+        self.keyframeByteCount = keyframe.count
+        self.columns = columns
+        self.rows = rows
+        self.wasAlternateScreen = wasAlternateScreen
+        self.capturedAt = capturedAt
+    }
+
+    /// The keyframe bytes, or nil if they cannot be decoded.
+    var keyframe: [UInt8]? {
+        guard isCompressed else { return storedKeyframe }
+        var output = [UInt8](repeating: 0, count: keyframeByteCount)
+        let size = storedKeyframe.withUnsafeBufferPointer { source in
+            output.withUnsafeMutableBufferPointer { destination in
+                compression_decode_buffer(
+                    destination.baseAddress!, destination.count,
+                    source.baseAddress!, source.count,
+                    nil, COMPRESSION_LZ4
+                )
+            }
+        }
+        return size == keyframeByteCount ? output : nil
+    }
+}
+
+/// Stored by the workspace snapshot; the keyframe is written as one blob.
+nonisolated extension SessionResumeState: Codable {
+    private enum CodingKeys: String, CodingKey {
+        case storedKeyframe, isCompressed, keyframeByteCount, columns, rows, wasAlternateScreen, capturedAt
+    }
+
+    init(from decoder: Decoder) throws {
+        let container = try decoder.container(keyedBy: CodingKeys.self)
+        storedKeyframe = [UInt8](try container.decode(Data.self, forKey: .storedKeyframe))
+        isCompressed = try container.decode(Bool.self, forKey: .isCompressed)
+        keyframeByteCount = try container.decode(Int.self, forKey: .keyframeByteCount)
+        columns = try container.decode(Int.self, forKey: .columns)
+        rows = try container.decode(Int.self, forKey: .rows)
+        wasAlternateScreen = try container.decode(Bool.self, forKey: .wasAlternateScreen)
+        capturedAt = try container.decode(Date.self, forKey: .capturedAt)
+    }
+
+    func encode(to encoder: Encoder) throws {
+        var container = encoder.container(keyedBy: CodingKeys.self)
+        try container.encode(Data(storedKeyframe), forKey: .storedKeyframe)
+        try container.encode(isCompressed, forKey: .isCompressed)
+        try container.encode(keyframeByteCount, forKey: .keyframeByteCount)
+        try container.encode(columns, forKey: .columns)
+        try container.encode(rows, forKey: .rows)
+        try container.encode(wasAlternateScreen, forKey: .wasAlternateScreen)
+        try container.encode(capturedAt, forKey: .capturedAt)
+    }
+}
+
+// MARK: - SessionResumeCoordinator
+
+@MainActor final class SessionResumeCoordinator {
+    weak var manager: SessionManager?
+
+    /// A screen older than this is not restored.
+    static let maximumAge: TimeInterval = 24 * 60 * 60
+
+    /// Lists detached tmux sessions, then screen's sessions, after a `--`.
+    static let multiplexerProbeCommand =
+        "tmux list-sessions -F '#{session_attached} #{session_activity} #{session_name}' 2>/dev/null; echo --; screen -ls 2>/dev/null"
+
+    /// Returns the terminal to a plain shell's state after a keyframe:
+    /// primary screen, full scroll region, no mouse, paste or keypad modes.
+    private static let detachedProgramReset =
+        "\u{1B}7\u{1B}[r\u{1B}8\u{1B}[?1000l\u{1B}[?1002l\u{1B}[?1003l\u{1B}[?1005l\u{1B}[?1006l"
+        + "\u{1B}[?1004l\u{1B}[?2004l\u{1B}[?1l\u{1B}>\u{1B}[4l\u{1B}[?7h\u{1B}[?25h\u{1B}[0m\r\n"
+
+    private(set) var statesByHostID: [UUID: SessionResumeState] = [:]
+
+    /// Saves `engine`'s terminal for the next reconnect to `hostID`.
+    func capture(hostID: UUID, engine: TerminalEngine) async {
+        let scrollbackLines = manager?.configuredScrollbackLines ?? TerminalDefaults.maxScrollbackLines
+        statesByHostID[hostID] = await Self.state(of: engine, scrollbackLines: scrollbackLines)
+    }
+
+    /// `engine`'s terminal with up to `scrollbackLines` of history.
+    static func state(of engine: TerminalEngine, scrollbackLines: Int) async -> SessionResumeState {
+        SessionResumeState(
+            keyframe: await engine.keyframeSequence(scrollbackLines: scrollbackLines),
+            columns: await engine.columns,
+            rows: await engine.rows,
+            wasAlternateScreen: await engine.usingAlternateBuffer
+        )
+    }
+
+    /// Rebuilds the saved terminal of `hostID` in a new session's `engine`.
+    /// Returns false when there is nothing recent to restore. The state is
+    /// kept until `discard(hostID:)`, so a failed attempt can retry.
+    func restore(hostID: UUID, into engine: TerminalEngine) async -> Bool {
+        guard let state = statesByHostID[hostID] else { return false }
+        guard Date.now.timeIntervalSince(state.capturedAt) < Self.maximumAge,
+              await restore(state, into: engine) else {
+            statesByHostID.removeValue(forKey: hostID)
+            return false
+        }
+        return true
+    }
+
+    /// Rebuilds `state` in `engine`. Returns false if it cannot be decoded.
+    func restore(_ state: SessionResumeState, into engine: TerminalEngine) async -> Bool {
+        guard let keyframe = state.keyframe else { return false }
+        // The keyframe is only faithful at the size it was taken at; the
+        // pane's next layout reflows it from there.
+        await engine.resize(newColumns: state.columns, newRows: state.rows)
+        await engine.feed(keyframe)
+        var reset = Self.detachedProgramReset
+        if state.wasAlternateScreen {
+            reset = "\u{1B}[?\(DECPrivateMode.altScreen)l" + reset
+        }
+        await engine.feed(Array(reset.utf8))
+        return true
+    }
+
+    func discard(hostID: UUID) {
+        statesByHostID.removeValue(forKey: hostID)
+    }
+
+    /// Attaches the new shell of `sessionID` to a detached tmux or screen
+    /// session, if the host has one.
+    func reattachMultiplexer(sessionID: UUID) async {
+        guard let manager,
+              let result = try? await manager.transport.executeCommand(
+                  sessionID: sessionID,
+                  command: Self.multiplexerProbeCommand,
+                  timeout: .seconds(5)
+              ),
+              let command = Self.attachCommand(forProbeOutput: String(decoding: result.stdout, as: UTF8.self)) else {
+            return
+        }
+        await manager.sendRawShellInputBytes(sessionID: sessionID, bytes: Array((command + "\r").utf8))
+    }
+
+    /// The command that attaches the most recently active detached tmux
+    /// session, else the first detached screen session.
+    static func attachCommand(forProbeOutput output: String) -> String? {
+        var lines = output.split(whereSeparator: \.isNewline)[...]
+        var tmuxCandidate: (activity: Int, name: String)?
+        while let line = lines.popFirst(), line != "--" {
+            let fields = line.split(separator: " ", maxSplits: 2)
+            guard fields.count == 3, fields[0] == "0", let activity = Int(fields[1]) else { continue }
+            if activity >= tmuxCandidate?.activity ?? Int.min {
+                tmuxCandidate = (activity, String(fields[2]))
+            }
+        }
+        if let tmuxCandidate {
+            return "tmux attach-session -t \(shellQuoted(tmuxCandidate.name))"
+        }
+        for line in lines where line.contains("(Detached)") {
+            guard let id = line.split(whereSeparator: \.isWhitespace).first else { continue }
+            return "screen -r \(shellQuoted(String(id)))"
+        }
+        return nil
+    }
+
+    private static func shellQuoted(_ value: String) -> String {
+        "'" + value.replacingOccurrences(of: "'", with: #"'\''"#) + "'"
+    }
+}
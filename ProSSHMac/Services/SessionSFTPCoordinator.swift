@@ -1,9 +1,30 @@
 // Extracted from SessionManager.swift
+//
+// Remote listings are kept per session in an SFTPDirectoryCache. The file
+// browser reads through `remoteDirectoryPages`, which serves a cached
+// listing after at most one stat and prefetches subdirectories the user is
+// likely to open next. Plain `listRemoteDirectory` always lists, and it
+// refreshes the cache on the way.
 import Foundation
 
 @MainActor final class SessionSFTPCoordinator {
     weak var manager: SessionManager?
 
+    /// Subdirectories listed ahead of an expand, per prefetch request.
+    static let prefetchLimit = 4
+
+    /// How long a listing is served without a stat; see SFTPDirectoryCache.
+    var directoryCacheFreshness = SFTPDirectoryCache.defaultFreshnessInterval
+
+    private struct ListingKey: Hashable {
+        let sessionID: UUID
+        let path: String
+    }
+
+    private var directoryCaches: [UUID: SFTPDirectoryCache] = [:]
+    private var inFlightListings: [ListingKey: Task<[SFTPDirectoryEntry], Error>] = [:]
+    private var prefetchTasks: [UUID: Task<Void, Never>] = [:]
+
     init() {}
 
     nonisolated deinit {}
@@ -13,7 +34,194 @@ import Foundation
         guard manager.sessions.contains(where: { $0.id == sessionID && $0.state == .connected }) else {
             throw SSHTransportError.sessionNotFound
         }
-        return try await manager.transport.listDirectory(sessionID: sessionID, path: path)
+        let directoryModifiedAt = directoryCaches[sessionID]?.knownModificationTime(of: path)
+        let entries = try await manager.transport.listDirectory(sessionID: sessionID, path: path)
+        storeListing(entries, for: path, sessionID: sessionID, directoryModifiedAt: directoryModifiedAt)
+        return entries
+    }
+
+    // MARK: - Directory Cache
+
+    /// The cached listing of `path`, however old; for showing something
+    /// immediately while `remoteDirectoryPages` revalidates it.
+    func cachedRemoteDirectory(sessionID: UUID, path: String) -> [SFTPDirectoryEntry]? {
+        directoryCaches[sessionID]?.listing(for: path)?.entries
+    }
+
+    /// Pages of `path`'s listing. A cached listing that is fresh, or whose
+    /// directory mtime is unchanged, arrives as one page with no listing
+    /// round trips; otherwise the directory is walked and the result cached.
+    func remoteDirectoryPages(sessionID: UUID, path: String) async throws -> AsyncThrowingStream<[SFTPDirectoryEntry], Error> {
+        guard let manager else { throw SSHTransportError.sessionNotFound }
+        guard manager.sessions.contains(where: { $0.id == sessionID && $0.state == .connected }) else {
+            throw SSHTransportError.sessionNotFound
+        }
+        let path = RemotePath.normalize(path)
+        let key = ListingKey(sessionID: sessionID, path: path)
+
+        var directoryModifiedAt: Date?
+        if let cached = directoryCaches[sessionID]?.listing(for: path) {
+            if directoryCaches[sessionID]?.isFresh(path) == true {
+                return Self.singlePage(cached.entries)
+            }
+            directoryModifiedAt = try? await manager.transport.modificationTime(sessionID: sessionID, path: path)
+            if let directoryModifiedAt, directoryModifiedAt == cached.directoryModifiedAt,
+               directoryCaches[sessionID]?.listing(for: path) != nil {
+                directoryCaches[sessionID]?.revalidate(path)
+                return Self.singlePage(cached.entries)
+            }
+        }
+        if let inFlight = inFlightListings[key] {
+            return Self.singlePage(try await inFlight.value)
+        }
+        if directoryModifiedAt == nil {
+            directoryModifiedAt = directoryCaches[sessionID]?.knownModificationTime(of: path)
+        }
+        if directoryModifiedAt == nil {
+            directoryModifiedAt = try? await manager.transport.modificationTime(sessionID: sessionID, path: path)
+        }
+
+        let pages = try await manager.transport.walkDirectory(sessionID: sessionID, path: path, recursive: false)
+        let modifiedAt = directoryModifiedAt
+        return AsyncThrowingStream { continuation in
+            let task = Task { @MainActor [weak self] in
+                do {
+                    var entries: [SFTPDirectoryEntry] = []
+                    for try await page in pages {
+                        entries.append(contentsOf: page)
+                        continuation.yield(page)
+                    }
+                    if !Task.isCancelled {
+                        self?.storeListing(
+                            entries.sorted(by: SFTPDirectoryEntry.listingOrder),
+                            for: path,
+                            sessionID: sessionID,
+                            directoryModifiedAt: modifiedAt
+                        )
+                    }
+                    continuation.finish()
+                } catch {
+                    continuation.finish(throwing: error)
+                }
+            }
+            continuation.onTermination = { _ in task.cancel() }
+        }
+    }
+
+    /// Lists up to `limit` uncached, non-hidden subdirectories of `path` in
+    /// the background, one at a time, so expanding them is instant. A new
+    /// request for the session replaces the previous one.
+    func prefetchRemoteSubdirectories(sessionID: UUID, of path: String, limit: Int = prefetchLimit) {
+        prefetchTasks[sessionID]?.cancel()
+        guard let candidates = directoryCaches[sessionID]?.prefetchCandidates(in: path, limit: limit),
+              !candidates.isEmpty else {
+            prefetchTasks[sessionID] = nil
+            return
+        }
+        prefetchTasks[sessionID] = Task { [weak self] in
+            for candidate in candidates {
+                guard !Task.isCancelled, let self else { return }
+                guard self.directoryCaches[sessionID]?.listing(for: candidate) == nil else { continue }
+                _ = try? await self.prefetchListing(sessionID: sessionID, path: candidate)
+            }
+        }
+    }
+
+    func invalidateRemoteDirectory(sessionID: UUID, path: String) {
+        directoryCaches[sessionID]?.invalidate(path)
+    }
+
+    func invalidateRemoteDirectoryCache(sessionID: UUID) {
+        directoryCaches[sessionID]?.removeAll()
+    }
+
+    /// Drops the session's cache and stops its prefetch.
+    func forget(sessionID: UUID) {
+        prefetchTasks.removeValue(forKey: sessionID)?.cancel()
+        directoryCaches.removeValue(forKey: sessionID)
+        for key in inFlightListings.keys where key.sessionID == sessionID {
+            inFlightListings.removeValue(forKey: key)?.cancel()
+        }
+    }
+
+    /// One listing per path at a time; an expand that lands while the
+    /// prefetch of the same directory is running waits for it.
+    private func prefetchListing(sessionID: UUID, path: String) async throws -> [SFTPDirectoryEntry] {
+        guard let manager else { throw SSHTransportError.sessionNotFound }
+        let key = ListingKey(sessionID: sessionID, path: path)
+        if let inFlight = inFlightListings[key] {
+            return try await inFlight.value
+        }
+        let transport = manager.transport
+        let directoryModifiedAt = directoryCaches[sessionID]?.knownModificationTime(of: path)
+        let task = Task {
+            try await transport.listDirectory(sessionID: sessionID, path: path)
+        }
+        inFlightListings[key] = task
+        defer {
+            if inFlightListings[key] == task {
+                inFlightListings[key] = nil
+            }
+        }
+        let entries = try await withTaskCancellationHandler {
+            try await task.value
+        } onCancel: {
+            task.cancel()
+        }
+        storeListing(entries, for: path, sessionID: sessionID, directoryModifiedAt: directoryModifiedAt)
+        return entries
+    }
+
+    /// Skipped once the session is gone, so a late listing does not
+    /// recreate a forgotten cache.
+    private func storeListing(
+        _ entries: [SFTPDirectoryEntry],
+        for path: String,
+        sessionID: UUID,
+        directoryModifiedAt: Date?
+    ) {
+        guard manager?.sessions.contains(where: { $0.id == sessionID && $0.state == .connected }) == true else { return }
+        directoryCaches[sessionID, default: SFTPDirectoryCache(freshnessInterval: directoryCacheFreshness)]
+            .store(entries, for: path, directoryModifiedAt: directoryModifiedAt)
+    }
+
+    /// A write changes the listing of the directory holding `path`.
+    private func invalidateParentListing(sessionID: UUID, of path: String) {
+        guard let parent = RemotePath.parent(of: path) else { return }
+        directoryCaches[sessionID]?.invalidate(parent)
+    }
+
+    private static func singlePage(_ entries: [SFTPDirectoryEntry]) -> AsyncThrowingStream<[SFTPDirectoryEntry], Error> {
+        AsyncThrowingStream { continuation in
+            continuation.yield(entries)
+            continuation.finish()
+        }
+    }
+
+    func walkRemoteDirectory(sessionID: UUID, path: String, recursive: Bool) async throws -> AsyncThrowingStream<[SFTPDirectoryEntry], Error> {
+        guard let manager else { throw SSHTransportError.sessionNotFound }
+        guard manager.sessions.contains(where: { $0.id == sessionID && $0.state == .connected }) else {
+            throw SSHTransportError.sessionNotFound
+        }
+        return try await manager.transport.walkDirectory(sessionID: sessionID, path: path, recursive: recursive)
+    }
+
+    func createRemoteDirectory(sessionID: UUID, path: String) async throws {
+        guard let manager else { throw SSHTransportError.sessionNotFound }
+        guard manager.sessions.contains(where: { $0.id == sessionID && $0.state == .connected }) else {
+            throw SSHTransportError.sessionNotFound
+        }
+        try await manager.transport.createDirectory(sessionID: sessionID, path: path)
+        invalidateParentListing(sessionID: sessionID, of: path)
+    }
+
+    func setRemoteModificationTime(sessionID: UUID, path: String, date: Date) async throws {
+        guard let manager else { throw SSHTransportError.sessionNotFound }
+        guard manager.sessions.contains(where: { $0.id == sessionID && $0.state == .connected }) else {
+            throw SSHTransportError.sessionNotFound
+        }
+        try await manager.transport.setModificationTime(sessionID: sessionID, path: path, date: date)
+        invalidateParentListing(sessionID: sessionID, of: path)
     }
 
     func uploadFile(sessionID: UUID, localPath: String, remotePath: String) async throws -> SFTPTransferResult {
@@ -25,6 +233,7 @@ import Foundation
         guard manager.sessions.contains(where: { $0.id == sessionID && $0.state == .connected }) else {
             throw SSHTransportError.sessionNotFound
         }
+        defer { invalidateParentListing(sessionID: sessionID, of: remotePath) }
         return try await manager.transport.uploadFile(sessionID: sessionID, localPath: localPath, remotePath: remotePath, progressHandler: progressHandler)
     }
 
@@ -1,6 +1,7 @@
 // Extracted from SessionManager.swift
 import Foundation
 import os.log
+import QuartzCore
 
 enum RawShellInputSource: String {
     case hardwareKeyCapture = "hardware_key_capture"
@@ -13,8 +14,18 @@ enum RawShellInputSource: String {
 
     weak var manager: SessionManager?
     var parserReaderTasks: [UUID: Task<Void, Never>] = [:]
+    /// Keystroke stamps read by each session's parser task (see InputEchoTracker).
+    private var inputEchoTrackers: [UUID: InputEchoTracker] = [:]
+    /// Read-to-GPU latency sampling per session, when enabled (see
+    /// PipelineLatencyTracer).
+    private(set) var latencyTracers: [UUID: PipelineLatencyTracer] = [:]
     private var localInputFailureLogByKey: [String: Date] = [:]
     private let localInputFailureDedupWindow: TimeInterval = 1.5
+    /// The streaming paste per session, if any (see startPaste).
+    private var activePastes: [UUID: (id: UUID, task: Task<Void, Never>)] = [:]
+    /// Interrupt bytes typed during a paste, keyed by paste ID; the paste
+    /// sends them once it has stopped (see interruptPaste).
+    private var pasteInterrupts: [UUID: [UInt8]] = [:]
 
     init() {}
 
@@ -23,6 +34,9 @@ enum RawShellInputSource: String {
     func cancelParserTask(for sessionID: UUID) {
         parserReaderTasks[sessionID]?.cancel()
         parserReaderTasks.removeValue(forKey: sessionID)
+        cancelPaste(sessionID: sessionID)
+        inputEchoTrackers.removeValue(forKey: sessionID)
+        latencyTracers.removeValue(forKey: sessionID)?.logSummary()
     }
 
     func sendShellInput(sessionID: UUID, input: String, suppressEcho: Bool = false) async {
@@ -44,9 +58,16 @@ enum RawShellInputSource: String {
 
         do {
             let payload = trimmed + "\n"
-            try await shell.send(payload)
+            // A long command (an AI heredoc) goes at bulk priority so Ctrl-C
+            // can overtake it, and so does one queued after it, to keep
+            // commands in order.
+            var isBulk = payload.utf8.count >= Self.bulkCommandThreshold
+            if !isBulk {
+                isBulk = await shell.queuedBulkByteCount() > 0
+            }
+            try await shell.send(bytes: Array(payload.utf8), priority: isBulk ? .bulk : .interactive)
             manager.lastActivityBySessionID[sessionID] = .now
-            manager.bytesSentBySessionID[sessionID, default: 0] += Int64(payload.utf8.count)
+            manager.liveState(for: sessionID).addSentBytes(payload.utf8.count)
             manager.recordingCoordinator.recordInput(sessionID: sessionID, text: payload)
             await manager.terminalHistoryIndex.recordCommandInput(
                 sessionID: sessionID,
@@ -59,24 +80,28 @@ enum RawShellInputSource: String {
         }
     }
 
-    func sendRawShellInput(sessionID: UUID, input: String) async {
+    func sendRawShellInput(sessionID: UUID, input: String, priority: SSHShellWritePriority = .interactive) async {
         await sendRawShellInputBytes(
             sessionID: sessionID,
             bytes: Array(input.utf8),
             recordingText: input,
             source: .stringBridge,
-            eventType: "string_payload"
+            eventType: "string_payload",
+            priority: priority
         )
     }
 
+    /// Returns whether the bytes were handed to the channel.
+    @discardableResult
     func sendRawShellInputBytes(
         sessionID: UUID,
         bytes: [UInt8],
         recordingText: String? = nil,
         source: RawShellInputSource = .programmatic,
-        eventType: String = "unknown"
-    ) async {
-        guard let manager else { return }
+        eventType: String = "unknown",
+        priority: SSHShellWritePriority = .interactive
+    ) async -> Bool {
+        guard let manager else { return false }
         let session = manager.sessions.first(where: { $0.id == sessionID })
         let isLocalSession = session?.isLocal ?? false
 
@@ -91,7 +116,7 @@ enum RawShellInputSource: String {
                 errorCode: LocalInputSendFailure.disconnected.rawValue,
                 reason: "session_not_connected"
             )
-            return
+            return false
         }
 
         guard let shell = manager.shellChannels[sessionID] else {
@@ -105,12 +130,26 @@ enum RawShellInputSource: String {
                 errorCode: LocalInputSendFailure.missingShellChannel.rawValue,
                 reason: "shell_channel_unavailable"
             )
-            return
+            return false
+        }
+
+        if source != .programmatic, manager.lowLatencyInputEnabled {
+            inputEchoTrackers[sessionID]?.noteKeystroke()
+        }
+        if source == .hardwareKeyCapture, !isLocalSession, manager.predictiveEchoEnabled {
+            predictEcho(of: bytes, sessionID: sessionID)
+        }
+
+        if priority == .interactive, Self.containsInterrupt(bytes) {
+            if interruptPaste(sessionID: sessionID, with: bytes) {
+                return true
+            }
+            _ = await shell.discardQueuedBulk()
         }
 
         do {
-            try await shell.send(bytes: bytes)
-            manager.bytesSentBySessionID[sessionID, default: 0] += Int64(bytes.count)
+            try await shell.send(bytes: bytes, priority: priority)
+            manager.liveState(for: sessionID).addSentBytes(bytes.count)
             let rawText = recordingText ?? String(decoding: bytes, as: UTF8.self)
             manager.recordingCoordinator.recordInput(sessionID: sessionID, text: rawText)
             await manager.terminalHistoryIndex.recordRawInput(
@@ -118,6 +157,7 @@ enum RawShellInputSource: String {
                 input: rawText,
                 at: .now
             )
+            return true
         } catch {
             let nsError = error as NSError
             logLocalInputFailureIfNeeded(
@@ -130,9 +170,281 @@ enum RawShellInputSource: String {
                 reason: nsError.domain
             )
             await manager.renderingCoordinator.appendShellLine("Error: \(error.localizedDescription)", to: sessionID)
+            return false
         }
     }
 
+    /// Hands a keystroke to the engine's predictive echo without holding up
+    /// the send, and publishes if the tentative cells changed.
+    private func predictEcho(of bytes: [UInt8], sessionID: UUID) {
+        guard let engine = manager?.engines[sessionID] else { return }
+        Task { [weak manager] in
+            guard await engine.predictEcho(of: bytes), let manager else { return }
+            await manager.renderingCoordinator.scheduleParsedChunkPublish(sessionID: sessionID, engine: engine)
+        }
+    }
+
+    // MARK: - Interrupts
+
+    /// Commands at least this long are sent at bulk priority.
+    static let bulkCommandThreshold = 4096
+
+    /// Whether `bytes` carries Ctrl-C, Ctrl-Z or Ctrl-\. Queued bulk input
+    /// is dropped ahead of these: otherwise the rest of a paste or long
+    /// command reaches the shell after the interrupt and runs anyway.
+    nonisolated static func containsInterrupt(_ bytes: [UInt8]) -> Bool {
+        bytes.contains { $0 == 0x03 || $0 == 0x1A || $0 == 0x1C }
+    }
+
+    /// Stops the paste running in `sessionID`, if any, and has it send
+    /// `bytes` after closing its bracket, so the interrupt is not read as
+    /// pasted text. Returns false when no paste is running.
+    private func interruptPaste(sessionID: UUID, with bytes: [UInt8]) -> Bool {
+        guard let paste = activePastes[sessionID] else { return false }
+        pasteInterrupts[paste.id, default: []].append(contentsOf: bytes)
+        paste.task.cancel()
+        return true
+    }
+
+    // MARK: - Streaming Paste
+
+    /// The paste refills the channel's bulk queue only below this, so it
+    /// advances as fast as the window drains and a keystroke typed mid-paste
+    /// never waits behind more than this much of it.
+    static let pasteQueueHighWater = 256 * 1024
+    /// Bytes sent before the paste waits for sign of the remote consuming
+    /// them, so its echo keeps up instead of arriving seconds late.
+    static let pasteEchoWindow = 512 * 1024
+    /// Longest wait for that sign. A remote that echoes nothing still gets
+    /// the paste, one echo window per timeout.
+    static let pasteEchoTimeout: Duration = .milliseconds(50)
+    /// Pastes smaller than this finish too quickly to show progress for.
+    static let pasteProgressThreshold = 256 * 1024
+    private static let pastePollInterval: Duration = .milliseconds(5)
+
+    /// Streams `stream` to the session in the background, replacing any
+    /// paste already running there. Chunks go out at bulk priority, behind
+    /// keystrokes.
+    func startPaste(_ stream: PasteStream, sessionID: UUID) {
+        cancelPaste(sessionID: sessionID)
+        let pasteID = UUID()
+        let task = Task { [weak self] in
+            await self?.runPaste(stream, sessionID: sessionID, pasteID: pasteID)
+        }
+        activePastes[sessionID] = (pasteID, task)
+    }
+
+    func cancelPaste(sessionID: UUID) {
+        guard let paste = activePastes.removeValue(forKey: sessionID) else { return }
+        pasteInterrupts.removeValue(forKey: paste.id)
+        paste.task.cancel()
+        manager?.liveStates[sessionID]?.pasteProgress = nil
+    }
+
+    private func runPaste(_ stream: PasteStream, sessionID: UUID, pasteID: UUID) async {
+        guard let manager else { return }
+        var stream = stream
+        let live = manager.liveState(for: sessionID)
+        let showsProgress = stream.totalBytes >= Self.pasteProgressThreshold
+        if showsProgress {
+            live.pasteProgress = PasteProgress(sentBytes: 0, totalBytes: stream.totalBytes)
+        }
+        var sentSinceEcho = 0
+        var receivedAtMark = live.traffic.received
+        var failed = false
+
+        while !stream.isFinished {
+            guard let shell = manager.shellChannels[sessionID] else {
+                failed = true
+                break
+            }
+            while !Task.isCancelled, await shell.queuedBulkByteCount() > Self.pasteQueueHighWater {
+                try? await Task.sleep(for: Self.pastePollInterval)
+            }
+            if sentSinceEcho >= Self.pasteEchoWindow {
+                let deadline = ContinuousClock.now + Self.pasteEchoTimeout
+                while !Task.isCancelled, live.traffic.received == receivedAtMark, ContinuousClock.now < deadline {
+                    try? await Task.sleep(for: Self.pastePollInterval)
+                }
+                sentSinceEcho = 0
+                receivedAtMark = live.traffic.received
+            }
+            guard !Task.isCancelled, let chunk = stream.nextChunk() else { break }
+            guard !chunk.isEmpty else { continue }
+            guard await sendRawShellInputBytes(
+                sessionID: sessionID,
+                bytes: chunk,
+                eventType: "paste",
+                priority: .bulk
+            ) else {
+                failed = true
+                break
+            }
+            sentSinceEcho += chunk.count
+            if showsProgress {
+                live.update(\.pasteProgress, to: PasteProgress(sentBytes: stream.consumedBytes, totalBytes: stream.totalBytes))
+            }
+        }
+
+        // An interrupt drops the paste still queued, so it takes effect once
+        // the bytes already on the wire are through.
+        let interrupt = pasteInterrupts.removeValue(forKey: pasteID)
+        if !failed, interrupt != nil, let shell = manager.shellChannels[sessionID] {
+            _ = await shell.discardQueuedBulk()
+        }
+
+        // Close a bracketed paste that was cut short; it queues behind the
+        // bulk bytes already sent, so it still arrives last.
+        if !failed, let terminator = stream.cancel() {
+            await sendRawShellInputBytes(sessionID: sessionID, bytes: terminator, eventType: "paste", priority: .bulk)
+        }
+        if !failed, let interrupt {
+            await sendRawShellInputBytes(sessionID: sessionID, bytes: interrupt, eventType: "paste_interrupt", priority: .bulk)
+        }
+        if activePastes[sessionID]?.id == pasteID {
+            activePastes.removeValue(forKey: sessionID)
+            live.pasteProgress = nil
+        }
+    }
+
+    // MARK: - Broadcast Input
+
+    /// Sends one press to every target in broadcast or group routing. Targets
+    /// sharing the focused session's encoder options reuse its bytes, so a
+    /// press is usually encoded once. The writes run concurrently, so a group
+    /// of 32 costs about one write rather than 32 in a row, and a slow or
+    /// failing session neither delays nor stops the others. Returns the
+    /// targets that did not get the input.
+    @discardableResult
+    func broadcastShellInput(
+        _ input: BroadcastKeyInput,
+        to sessionIDs: [UUID],
+        source: RawShellInputSource = .hardwareKeyCapture,
+        priority: SSHShellWritePriority = .interactive
+    ) async -> [BroadcastInputFailure] {
+        guard let manager else { return [] }
+        var failures: [BroadcastInputFailure] = []
+        var writes: [(sessionID: UUID, shell: any SSHShellChannel, bytes: [UInt8])] = []
+        var encodedByOptions: [KeyEncoderOptions: [UInt8]?] = [input.options: input.bytes]
+        let interrupts = priority == .interactive && Self.containsInterrupt(input.bytes)
+
+        for sessionID in sessionIDs {
+            guard manager.sessions.contains(where: { $0.id == sessionID && $0.state == .connected }) else {
+                failures.append(BroadcastInputFailure(sessionID: sessionID, reason: .disconnected))
+                continue
+            }
+            guard let shell = manager.shellChannels[sessionID] else {
+                failures.append(BroadcastInputFailure(sessionID: sessionID, reason: .missingShellChannel))
+                continue
+            }
+            let options = keyEncoderOptions(for: sessionID)
+            let bytes: [UInt8]?
+            if let encoded = encodedByOptions[options] {
+                bytes = encoded
+            } else {
+                bytes = input.bytes(for: options)
+                encodedByOptions[options] = bytes
+            }
+            // A press with no encoding in this session's modes sends nothing.
+            guard let bytes, !bytes.isEmpty else { continue }
+            if source != .programmatic, manager.lowLatencyInputEnabled {
+                inputEchoTrackers[sessionID]?.noteKeystroke()
+            }
+            if interrupts, interruptPaste(sessionID: sessionID, with: bytes) {
+                continue
+            }
+            writes.append((sessionID, shell, bytes))
+        }
+
+        let errors = await withTaskGroup(of: (UUID, (any Error)?).self) { group in
+            for write in writes {
+                group.addTask {
+                    do {
+                        if interrupts {
+                            _ = await write.shell.discardQueuedBulk()
+                        }
+                        try await write.shell.send(bytes: write.bytes, priority: priority)
+                        return (write.sessionID, nil)
+                    } catch {
+                        return (write.sessionID, error)
+                    }
+                }
+            }
+            var errors: [UUID: any Error] = [:]
+            for await (sessionID, error) in group {
+                if let error {
+                    errors[sessionID] = error
+                }
+            }
+            return errors
+        }
+
+        for write in writes {
+            if let error = errors[write.sessionID] {
+                failures.append(BroadcastInputFailure(
+                    sessionID: write.sessionID,
+                    reason: .sendFailed(error.localizedDescription)
+                ))
+                continue
+            }
+            manager.liveState(for: write.sessionID).addSentBytes(write.bytes.count)
+            let rawText = String(decoding: write.bytes, as: UTF8.self)
+            manager.recordingCoordinator.recordInput(sessionID: write.sessionID, text: rawText)
+            await manager.terminalHistoryIndex.recordRawInput(
+                sessionID: write.sessionID,
+                input: rawText,
+                at: .now
+            )
+        }
+
+        for failure in failures {
+            await reportBroadcastFailure(failure, input: input, source: source)
+        }
+        return failures
+    }
+
+    /// The options the capture view would use were `sessionID` focused.
+    private func keyEncoderOptions(for sessionID: UUID) -> KeyEncoderOptions {
+        let modes = manager?.liveState(for: sessionID).inputModeSnapshot ?? .default
+        return KeyEncoderOptions(applicationCursorKeys: modes.applicationCursorKeys)
+    }
+
+    private func reportBroadcastFailure(
+        _ failure: BroadcastInputFailure,
+        input: BroadcastKeyInput,
+        source: RawShellInputSource
+    ) async {
+        guard let manager else { return }
+        let isLocalSession = manager.sessions.first(where: { $0.id == failure.sessionID })?.isLocal ?? false
+        let line: String
+        let errorCode: Int
+        let reason: String
+        switch failure.reason {
+        case .disconnected:
+            line = "Session is not connected."
+            errorCode = LocalInputSendFailure.disconnected.rawValue
+            reason = "session_not_connected"
+        case .missingShellChannel:
+            line = "Shell channel is not available."
+            errorCode = LocalInputSendFailure.missingShellChannel.rawValue
+            reason = "shell_channel_unavailable"
+        case let .sendFailed(description):
+            line = "Error: \(description)"
+            errorCode = LocalInputSendFailure.sendFailed.rawValue
+            reason = "broadcast_send_failed"
+        }
+        logLocalInputFailureIfNeeded(
+            sessionID: failure.sessionID,
+            isLocalSession: isLocalSession,
+            source: source,
+            eventType: input.eventType,
+            byteCount: input.bytes.count,
+            errorCode: errorCode,
+            reason: reason
+        )
+        await manager.renderingCoordinator.appendShellLine(line, to: failure.sessionID)
+    }
+
     private func logLocalInputFailureIfNeeded(
         sessionID: UUID,
         isLocalSession: Bool,
@@ -167,88 +479,321 @@ enum RawShellInputSource: String {
         String(sessionID.uuidString.prefix(8)).lowercased()
     }
 
+    /// Starts the parser reader on the channel's zero-copy output ring when it has
+    /// one, otherwise on its `rawOutput` stream. Only one of the two is touched:
+    /// reading `rawOutput` on a ring-backed channel starts draining the ring.
+    func startParserReader(for sessionID: UUID, channel: any SSHShellChannel) {
+        if let ring = channel.outputRing {
+            startParserReader(for: sessionID, outputRing: ring)
+        } else {
+            startParserReader(for: sessionID, rawOutput: channel.rawOutput)
+        }
+    }
+
+    /// Stream-backed variant for channels without an output ring (local PTY,
+    /// tests). A pump task copies each chunk into a private `ShellOutputRing`
+    /// and the ring reader batches and parses it exactly as for SSH channels.
+    /// History and recording get the original chunks, with their arrival
+    /// times, through the recorder stream instead of inline.
     func startParserReader(for sessionID: UUID, rawOutput: AsyncStream<Data>) {
         parserReaderTasks[sessionID]?.cancel()
-        guard let manager, let engine = manager.engines[sessionID] else {
+        guard let manager, manager.engines[sessionID] != nil else {
             return
         }
 
-        let (batchedStream, batchContinuation) = AsyncStream<Data>.makeStream(bufferingPolicy: .unbounded)
-        let accumulator = ChunkBatchAccumulator(continuation: batchContinuation)
-
-        // Accumulator task: record each raw chunk (preserving per-chunk timestamps/byte counts),
-        // then batch into 4ms windows to reduce actor-hop frequency on engine.feed().
-        let accTask = Task.detached(priority: .userInitiated) { [weak self] in
+        let ring = ShellOutputRing(capacity: 1 << 18)
+        let recorder = startOutputRecorder(for: sessionID)
+        let log = manager.sessionLogCoordinator.sink(for: sessionID)
+        let pumpTask = Task.detached(priority: .userInitiated) {
             for await chunk in rawOutput {
                 if Task.isCancelled { break }
-                await self?.recordParsedChunk(sessionID: sessionID, chunk: chunk)
-                await accumulator.push(chunk)
+                recorder.yield(RecordedOutputChunk(data: chunk, receivedAt: .now))
+                log?.append(chunk)
+                await ring.append(contentsOf: chunk)
             }
-            await accumulator.finish()
+            ring.finish()
+        }
+
+        startRingParser(for: sessionID, ring: ring, recorder: recorder, log: nil, recordsRegions: false) {
+            pumpTask.cancel()
+            ring.finish()
+        }
+    }
+
+    /// Ring-backed variant: the parser reads channel output in place from the
+    /// ring storage the libssh reader wrote into, releasing each span after
+    /// `feed(borrowing:)` returns. History and recording still get their own copy
+    /// because they retain chunks.
+    func startParserReader(for sessionID: UUID, outputRing ring: ShellOutputRing) {
+        parserReaderTasks[sessionID]?.cancel()
+        guard let manager, manager.engines[sessionID] != nil else {
+            return
         }
+        let recorder = startOutputRecorder(for: sessionID)
+        let log = manager.sessionLogCoordinator.sink(for: sessionID)
+        startRingParser(for: sessionID, ring: ring, recorder: recorder, log: log, recordsRegions: true) {}
+    }
 
-        // Parser task: feed batched data to engine, schedule publishes.
+    /// Parser task shared by both reader variants. Batches in a 4ms / 4KB
+    /// window, feeds the engine in place and hands results to the MainActor
+    /// without waiting on it. Output that answers a recent keystroke skips
+    /// the window and is marked for an immediate publish. With latency
+    /// tracing on, a sampled read opens a trace once its span is parsed.
+    /// Each feed adds its bytes and time to the pipeline counters. In tmux
+    /// control mode the demultiplexer splits each span first and feeds the
+    /// engine only its terminal output (see TmuxControlCoordinator). Ahead
+    /// of both, a ZMODEM transfer takes the bytes it covers out of the
+    /// span (see InBandTransferCoordinator); they are neither parsed nor
+    /// recorded.
+    /// `recordsRegions` copies each parsed span to the
+    /// recorder and `log` (see SessionLog) when no upstream pump does; both
+    /// share the one copy. `stop` runs when the task ends or
+    /// is cancelled, so a private ring can be finished to wake a parked read.
+    private func startRingParser(
+        for sessionID: UUID,
+        ring: ShellOutputRing,
+        recorder: AsyncStream<RecordedOutputChunk>.Continuation,
+        log: SessionLogSink?,
+        recordsRegions: Bool,
+        stop: @escaping @Sendable () -> Void
+    ) {
+        guard let engine = manager?.engines[sessionID] else {
+            recorder.finish()
+            stop()
+            return
+        }
+
+        let pending = PendingFeedResult()
+        let echoTracker = InputEchoTracker()
+        inputEchoTrackers[sessionID] = echoTracker
+        let tracer = PipelineLatencyTracer.isEnabled ? PipelineLatencyTracer(sessionID: sessionID) : nil
+        if tracer != nil {
+            ring.enableArrivalSampling()
+        }
+        latencyTracers[sessionID] = tracer
+        let counters = manager?.renderingCoordinator.pipelineCounters(for: sessionID)
+        let tmux = manager?.tmuxCoordinator.demultiplexer(for: sessionID)
+        let inBand = manager?.inBandTransferCoordinator.demultiplexer(for: sessionID)
         parserReaderTasks[sessionID] = Task.detached(priority: .userInitiated) { [weak self] in
-            defer { accTask.cancel() }
+            defer {
+                recorder.finish()
+                stop()
+            }
 
-            for await batch in batchedStream {
-                if Task.isCancelled { break }
-                await engine.feed(batch)
-                await self?.manager?.renderingCoordinator.refreshInputModeSnapshot(
-                    sessionID: sessionID,
-                    engine: engine
-                )
-
-                let syncExitSnapshots = await engine.consumeSyncExitSnapshots()
-                if !syncExitSnapshots.isEmpty {
-                    await self?.manager?.renderingCoordinator.publishSyncExitSnapshots(
-                        sessionID: sessionID,
-                        engine: engine,
-                        snapshotOverrides: syncExitSnapshots
+            await withTaskCancellationHandler {
+                while await ring.waitForReadable() {
+                    if Task.isCancelled { break }
+
+                    let backlog = ring.readableCount
+                    if backlog < 4096, !ring.isFinished, !echoTracker.expectsEcho(byteCount: backlog) {
+                        try? await Task.sleep(for: .milliseconds(4))
+                    }
+
+                    let region = ring.readableRegion
+                    guard let baseAddress = region.baseAddress, !region.isEmpty else { continue }
+                    let span = Data(
+                        bytesNoCopy: UnsafeMutableRawPointer(mutating: baseAddress),
+                        count: region.count,
+                        deallocator: .none
                     )
-                }
 
-                let inSyncMode = await engine.synchronizedOutput
-                if inSyncMode {
-                    let liveSyncSnapshot = await engine.liveSnapshot()
-                    await self?.manager?.renderingCoordinator.scheduleSynchronizedOutputFallbackPublish(
+                    // Nil when the whole span is terminal output.
+                    let terminalRanges = await inBand?.terminalRanges(of: region)
+                    if recordsRegions {
+                        if let terminalRanges {
+                            for range in terminalRanges {
+                                let chunk = Data(region[range])
+                                recorder.yield(RecordedOutputChunk(data: chunk, receivedAt: .now))
+                                log?.append(chunk)
+                            }
+                        } else {
+                            let chunk = Data(region)
+                            recorder.yield(RecordedOutputChunk(data: chunk, receivedAt: .now))
+                            log?.append(chunk)
+                        }
+                    }
+                    let echoKeystroke = echoTracker.expectsEcho(byteCount: region.count)
+                        ? echoTracker.consumeKeystroke()
+                        : nil
+                    let arrival = tracer == nil ? nil : ring.takeSampledArrival(consuming: region.count)
+                    let feedStartedAt = CACurrentMediaTime()
+                    var result: FeedResult?
+                    if let terminalRanges {
+                        for range in terminalRanges {
+                            let part = UnsafeRawBufferPointer(rebasing: region[range])
+                            guard let later = await Self.feed(part, tmux: tmux, engine: engine) else { continue }
+                            if result == nil { result = later } else { result?.merge(later) }
+                        }
+                    } else if let tmux, let segments = tmux.segments(of: region) {
+                        result = await tmux.dispatch(segments, in: region, engine: engine)
+                    } else {
+                        result = await engine.feedCollecting(borrowing: span)
+                    }
+                    counters?.recordParse(byteCount: region.count, seconds: CACurrentMediaTime() - feedStartedAt)
+                    ring.consume(region.count)
+                    var trace = arrival.flatMap { tracer?.begin(readAt: $0) }
+                    trace?.parsedAt = CACurrentMediaTime()
+
+                    guard let result else { continue }
+                    self?.enqueueParsedOutput(
                         sessionID: sessionID,
                         engine: engine,
-                        snapshotOverride: liveSyncSnapshot
+                        result: result,
+                        echoKeystroke: echoKeystroke,
+                        trace: trace,
+                        pending: pending
                     )
-                    continue
                 }
+            } onCancel: {
+                stop()
+            }
+
+            await self?.finishParserReader(sessionID: sessionID, engine: engine, pending: pending)
+        }
+    }
+
+    /// Feeds part of a span the way a whole one is fed, through tmux when in
+    /// control mode.
+    private nonisolated static func feed(
+        _ part: UnsafeRawBufferPointer,
+        tmux: TmuxControlDemultiplexer?,
+        engine: TerminalEngine
+    ) async -> FeedResult? {
+        if let tmux, let segments = tmux.segments(of: part) {
+            return await tmux.dispatch(segments, in: part, engine: engine)
+        }
+        guard let baseAddress = part.baseAddress, !part.isEmpty else { return nil }
+        let span = Data(
+            bytesNoCopy: UnsafeMutableRawPointer(mutating: baseAddress),
+            count: part.count,
+            deallocator: .none
+        )
+        return await engine.feedCollecting(borrowing: span)
+    }
 
-                await self?.manager?.renderingCoordinator.scheduleParsedChunkPublish(
-                    sessionID: sessionID,
-                    engine: engine
-                )
+    /// Starts the MainActor task that feeds raw output to the history index and
+    /// the session recorder. It runs beside the parser rather than in front of
+    /// it, and ends when the returned continuation is finished.
+    private func startOutputRecorder(for sessionID: UUID) -> AsyncStream<RecordedOutputChunk>.Continuation {
+        let (chunks, continuation) = AsyncStream<RecordedOutputChunk>.makeStream(bufferingPolicy: .unbounded)
+        Task { [weak self] in
+            for await chunk in chunks {
+                await self?.recordParsedChunk(sessionID: sessionID, chunk: chunk.data, at: chunk.receivedAt)
             }
+        }
+        return continuation
+    }
+
+    /// Merge a batch's `FeedResult` into the reader's pending slot and, if no
+    /// drain is already queued, schedule one on the MainActor. Batches parsed
+    /// while the MainActor is busy fold into that drain, so the parser never
+    /// waits on the UI and the MainActor sees one update per turn rather than
+    /// one per 4ms batch. `echoKeystroke` is the time of the keystroke the
+    /// batch echoes, if any, and `trace` the latency sample it carries.
+    private nonisolated func enqueueParsedOutput(
+        sessionID: UUID,
+        engine: TerminalEngine,
+        result: FeedResult,
+        echoKeystroke: CFTimeInterval?,
+        trace: PipelineTrace?,
+        pending: PendingFeedResult
+    ) {
+        guard pending.merge(result, echoKeystroke: echoKeystroke, trace: trace) else { return }
+        Task { @MainActor [weak self] in
+            await self?.drainParsedOutput(sessionID: sessionID, engine: engine, pending: pending)
+        }
+    }
+
+    private func drainParsedOutput(
+        sessionID: UUID,
+        engine: TerminalEngine,
+        pending: PendingFeedResult
+    ) async {
+        while case let (result, echoKeystroke, trace)? = pending.take() {
+            await publishParsedOutput(
+                sessionID: sessionID,
+                engine: engine,
+                result: result,
+                echoKeystroke: echoKeystroke,
+                trace: trace
+            )
+        }
+    }
+
+    private func publishParsedOutput(
+        sessionID: UUID,
+        engine: TerminalEngine,
+        result: FeedResult,
+        echoKeystroke: CFTimeInterval? = nil,
+        trace: PipelineTrace? = nil
+    ) async {
+        guard let manager else { return }
+        let renderingCoordinator = manager.renderingCoordinator
+        renderingCoordinator.applyInputModeSnapshot(result.inputModeSnapshot, sessionID: sessionID)
+        if let trace {
+            renderingCoordinator.noteLatencyTrace(trace, sessionID: sessionID)
+        }
 
-            await self?.manager?.renderingCoordinator.flushPendingSnapshotPublishIfNeeded(
-                for: sessionID,
-                engine: engine
+        if !result.syncExitSnapshots.isEmpty {
+            await renderingCoordinator.publishSyncExitSnapshots(
+                sessionID: sessionID,
+                engine: engine,
+                snapshotOverrides: result.syncExitSnapshots
             )
+        }
 
-            if await engine.usingAlternateBuffer {
-                await engine.disableAlternateBuffer()
-                await self?.manager?.renderingCoordinator.publishGridState(for: sessionID, engine: engine)
-            }
+        if result.synchronizedOutput, let liveSyncSnapshot = result.liveSyncSnapshot {
+            renderingCoordinator.scheduleSynchronizedOutputFallbackPublish(
+                sessionID: sessionID,
+                engine: engine,
+                snapshotOverride: liveSyncSnapshot
+            )
+            return
+        }
 
-            if !Task.isCancelled {
-                await self?.manager?.handleShellStreamEndedInternal(sessionID: sessionID)
-            }
+        renderingCoordinator.scheduleParsedChunkPublish(
+            sessionID: sessionID,
+            engine: engine,
+            usingAlternateBuffer: result.usingAlternateBuffer
+        )
+
+        // A keystroke echo publishes now rather than after the interval.
+        if let echoKeystroke {
+            renderingCoordinator.noteInputEcho(sessionID: sessionID, keystrokeAt: echoKeystroke)
+            await renderingCoordinator.flushPendingSnapshotPublishIfNeeded(for: sessionID, engine: engine)
         }
     }
 
-    private func recordParsedChunk(sessionID: UUID, chunk: Data) async {
+    private func finishParserReader(
+        sessionID: UUID,
+        engine: TerminalEngine,
+        pending: PendingFeedResult
+    ) async {
+        await drainParsedOutput(sessionID: sessionID, engine: engine, pending: pending)
+
+        await manager?.renderingCoordinator.flushPendingSnapshotPublishIfNeeded(
+            for: sessionID,
+            engine: engine
+        )
+
+        if engine.mailbox.status.usingAlternateBuffer {
+            await engine.disableAlternateBuffer()
+            await manager?.renderingCoordinator.publishGridState(for: sessionID, engine: engine)
+        }
+
+        if !Task.isCancelled {
+            await manager?.handleShellStreamEndedInternal(sessionID: sessionID)
+        }
+    }
+
+    private func recordParsedChunk(sessionID: UUID, chunk: Data, at receivedAt: Date) async {
         guard let manager else { return }
-        manager.lastActivityBySessionID[sessionID] = .now
-        manager.bytesReceivedBySessionID[sessionID, default: 0] += Int64(chunk.count)
+        manager.lastActivityBySessionID[sessionID] = receivedAt
+        manager.liveState(for: sessionID).addReceivedBytes(chunk.count)
         await manager.terminalHistoryIndex.recordOutputChunk(
             sessionID: sessionID,
             data: chunk,
-            at: .now
+            at: receivedAt
         )
         manager.recordingCoordinator.recordIfActive(sessionID: sessionID, chunk: chunk, throughputModeEnabled: manager.throughputModeEnabled)
     }
@@ -257,46 +802,73 @@ enum RawShellInputSource: String {
 private enum LocalInputSendFailure: Int {
     case disconnected = -1001
     case missingShellChannel = -1002
+    case sendFailed = -1003
 }
 
-/// Accumulates incoming SSH data chunks and yields them in 4ms batches
-/// (or immediately when the buffer exceeds 4 KB) to reduce actor-hop frequency
-/// on TerminalEngine.feed() during output bursts.
-private actor ChunkBatchAccumulator {
-    private var buffer = Data()
-    private var generation = 0
-    private let continuation: AsyncStream<Data>.Continuation
-
-    init(continuation: AsyncStream<Data>.Continuation) {
-        self.continuation = continuation
+/// A broadcast target that did not get the input.
+struct BroadcastInputFailure: Sendable, Equatable {
+    enum Reason: Sendable, Equatable {
+        case disconnected
+        case missingShellChannel
+        case sendFailed(String)
     }
 
-    func push(_ chunk: Data) {
-        let wasEmpty = buffer.isEmpty
-        buffer.append(contentsOf: chunk)
-        if buffer.count >= 4096 {
-            flush()                          // size threshold: flush immediately
-        } else if wasEmpty {
-            let gen = generation             // start 4ms timer for first chunk in window
-            Task { await self.scheduledFlush(generation: gen) }
-        }
-    }
+    let sessionID: UUID
+    let reason: Reason
+}
 
-    func finish() {
-        flush()
-        continuation.finish()
-    }
+/// Raw output chunk queued for the history index and session recorder.
+private nonisolated struct RecordedOutputChunk: Sendable {
+    let data: Data
+    let receivedAt: Date
+}
 
-    private func flush() {
-        guard !buffer.isEmpty else { return }
-        generation &+= 1                     // invalidate any pending timer
-        continuation.yield(buffer)
-        buffer = Data()
+/// Single pending `FeedResult` per parser reader. The parser merges into it
+/// after every batch; the MainActor drains it. A drain counts as scheduled
+/// from the first merge into an empty slot until `take` finds nothing left,
+/// so at most one drain is queued or running at a time.
+private nonisolated final class PendingFeedResult: @unchecked Sendable {
+    private let lock = NSLock()
+    private var result: FeedResult?
+    /// Earliest keystroke echoed by the merged batches.
+    private var echoKeystroke: CFTimeInterval?
+    /// Oldest latency sample carried by the merged batches.
+    private var trace: PipelineTrace?
+    private var drainScheduled = false
+
+    /// Returns true when the caller must schedule a drain.
+    func merge(_ later: FeedResult, echoKeystroke keystroke: CFTimeInterval? = nil, trace laterTrace: PipelineTrace? = nil) -> Bool {
+        guard later.didProcess else { return false }
+        lock.lock()
+        defer { lock.unlock() }
+        if result == nil {
+            result = later
+        } else {
+            result?.merge(later)
+        }
+        if let keystroke {
+            echoKeystroke = min(echoKeystroke ?? keystroke, keystroke)
+        }
+        trace = PipelineTrace.earliest(trace, laterTrace)
+        guard !drainScheduled else { return false }
+        drainScheduled = true
+        return true
     }
 
-    private func scheduledFlush(generation: Int) async {
-        try? await Task.sleep(for: .milliseconds(4))
-        guard self.generation == generation else { return }  // stale timer guard
-        flush()
+    /// Removes the merged result, its echoed keystroke and latency sample,
+    /// or ends the drain when there is none.
+    func take() -> (FeedResult, CFTimeInterval?, PipelineTrace?)? {
+        lock.lock()
+        defer { lock.unlock() }
+        guard let taken = result else {
+            drainScheduled = false
+            return nil
+        }
+        let keystroke = echoKeystroke
+        let takenTrace = trace
+        result = nil
+        echoKeystroke = nil
+        trace = nil
+        return (taken, keystroke, takenTrace)
     }
 }
@@ -0,0 +1,29 @@
+// SessionThumbnailStore.swift
+// ProSSHV2
+//
+// The latest thumbnail of each session, as its renderer captured it (see
+// SessionThumbnailAtlas). Kept apart from SessionManager so a new image
+// redraws only the tab preview and overview tiles that show it. Sessions
+// whose pane is hidden or hibernated keep their last image until the
+// session is removed.
+
+import Combine
+import CoreGraphics
+import Foundation
+
+@MainActor
+final class SessionThumbnailStore: ObservableObject {
+    @Published private(set) var images: [UUID: CGImage] = [:]
+
+    init() {}
+
+    nonisolated deinit {}
+
+    func update(_ image: CGImage, for sessionID: UUID) {
+        images[sessionID] = image
+    }
+
+    func remove(sessionID: UUID) {
+        images.removeValue(forKey: sessionID)
+    }
+}
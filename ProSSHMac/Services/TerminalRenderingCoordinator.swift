@@ -1,5 +1,6 @@
 // Extracted from SessionManager.swift
 import Foundation
+import QuartzCore
 #if DEBUG
 import os.signpost
 #endif
@@ -65,6 +66,51 @@ import os.signpost
     private var forceFullSnapshotNextPublishBySessionID: Set<UUID> = []
     /// Sessions currently redrawing a shell prompt after OSC 133 prompt/command-end markers.
     private var promptRedrawPendingSessionIDs: Set<UUID> = []
+    /// Sessions that have sent an OSC 133 marker. Their command boundaries
+    /// come from semantic events, so screen heuristics are skipped.
+    private var semanticPromptSessionIDs: Set<UUID> = []
+    /// Background link detection over published shell lines: the lines
+    /// last handed to it, and lines waiting for the running pass.
+    private var linkDetectionLinesBySessionID: [UUID: [String]] = [:]
+    private var linkDetectionTasksBySessionID: [UUID: Task<Void, Never>] = [:]
+    private var pendingLinkDetectionLinesBySessionID: [UUID: [String]] = [:]
+    /// Render tier reported by each pane showing a session, keyed by pane
+    /// surface. Untracked sessions publish at the full rate (see
+    /// SessionRenderBudget).
+    private var renderTiersBySessionID: [UUID: [UUID: SessionRenderTier]] = [:]
+    /// Display-link feeds of the panes showing each session, keyed by pane
+    /// surface (see GridSnapshotFeed).
+    private var snapshotFeedsBySessionID: [UUID: [UUID: GridSnapshotFeed]] = [:]
+    /// Feeds of sessions being mirrored (see SessionMirrorCoordinator).
+    /// Unlike pane feeds they do not replace the snapshot nonce.
+    private var mirrorFeedsBySessionID: [UUID: GridSnapshotFeed] = [:]
+    /// Keystroke time of an echo waiting for its publish, handed to the
+    /// session's feeds with the next stored snapshot (see InputEchoTracker).
+    private var pendingInputEchoBySessionID: [UUID: CFTimeInterval] = [:]
+    /// Latency sample waiting for the next stored snapshot, handed to the
+    /// session's feeds with it (see PipelineLatencyTracer).
+    private var pendingLatencyTraceBySessionID: [UUID: PipelineTrace] = [:]
+    /// Output pipeline totals for the performance HUD, shared with the
+    /// session's parser task.
+    private var pipelineCountersBySessionID: [UUID: SessionPipelineCounters] = [:]
+    /// Last measured scrollback memory per session, for the performance HUD.
+    private var scrollbackMemoryBytesBySessionID: [UUID: Int] = [:]
+    /// Grid text version of each session's shell buffer, so housekeeping
+    /// re-sends lines only when a row's text changed since.
+    private var shellTextVersionBySessionID: [UUID: UInt64] = [:]
+    /// Sessions with a scrollback measurement in flight.
+    private var scrollbackMemoryRefreshSessionIDs: Set<UUID> = []
+    /// Current thermal state; replaced in tests.
+    var thermalStateProvider: () -> ProcessInfo.ThermalState = { ProcessInfo.processInfo.thermalState }
+    /// When hidden sessions hibernate (see SessionHibernation.swift).
+    var hibernationPolicy = SessionHibernationPolicy()
+    /// Sessions compacted while hidden; they publish housekeeping only.
+    private(set) var hibernatedSessionIDs: Set<UUID> = []
+    /// Last output, or the moment the session was hidden if later.
+    private var lastActivityAtBySessionID: [UUID: Date] = [:]
+    /// Checks hidden sessions every `SessionHibernationPolicy.sweepInterval`
+    /// while any could still hibernate.
+    private var hibernationSweepTask: Task<Void, Never>?
     #if DEBUG
     /// Deterministic test hook: queue one follow-up snapshot immediately after the
     /// next publish iteration for the given session.
@@ -137,6 +183,22 @@ import os.signpost
         pendingScheduledSnapshotOverridesBySessionID.removeValue(forKey: sessionID)
         forceFullSnapshotNextPublishBySessionID.remove(sessionID)
         promptRedrawPendingSessionIDs.remove(sessionID)
+        semanticPromptSessionIDs.remove(sessionID)
+        linkDetectionLinesBySessionID.removeValue(forKey: sessionID)
+        linkDetectionTasksBySessionID[sessionID]?.cancel()
+        linkDetectionTasksBySessionID.removeValue(forKey: sessionID)
+        pendingLinkDetectionLinesBySessionID.removeValue(forKey: sessionID)
+        renderTiersBySessionID.removeValue(forKey: sessionID)
+        snapshotFeedsBySessionID.removeValue(forKey: sessionID)
+        mirrorFeedsBySessionID.removeValue(forKey: sessionID)
+        pendingInputEchoBySessionID.removeValue(forKey: sessionID)
+        pendingLatencyTraceBySessionID.removeValue(forKey: sessionID)
+        pipelineCountersBySessionID.removeValue(forKey: sessionID)
+        scrollbackMemoryBytesBySessionID.removeValue(forKey: sessionID)
+        scrollbackMemoryRefreshSessionIDs.remove(sessionID)
+        hibernatedSessionIDs.remove(sessionID)
+        lastActivityAtBySessionID.removeValue(forKey: sessionID)
+        shellTextVersionBySessionID.removeValue(forKey: sessionID)
     }
 
     // MARK: - App lifecycle
@@ -172,6 +234,186 @@ import os.signpost
         }
     }
 
+    // MARK: - Render tiers
+
+    /// Record the tier of the pane `surfaceID` showing `sessionID`. The
+    /// engine's parsing is scheduled by the same tier. A session revealed
+    /// while its output waits on the hidden cadence publishes immediately;
+    /// a hibernated one always does.
+    func setRenderTier(_ tier: SessionRenderTier, for sessionID: UUID, surfaceID: UUID) {
+        guard let manager, let engine = manager.engines[sessionID] else { return }
+        let previous = renderTier(for: sessionID)
+        renderTiersBySessionID[sessionID, default: [:]][surfaceID] = tier
+        let current = renderTier(for: sessionID)
+        engine.setSchedulingTier(current)
+        if previous != .hidden, current == .hidden {
+            lastActivityAtBySessionID[sessionID] = .now
+            startHibernationSweepIfNeeded()
+        }
+        guard previous == .hidden, current != .hidden else { return }
+        if hibernatedSessionIDs.remove(sessionID) != nil {
+            forceFullSnapshotNextPublishBySessionID.insert(sessionID)
+            Task { @MainActor [weak self] in
+                guard let self else { return }
+                self.cancelPendingSnapshotPublish(for: sessionID)
+                await self.publishLatestGridState(for: sessionID, engine: engine)
+            }
+            return
+        }
+        Task { @MainActor [weak self] in
+            await self?.flushPendingSnapshotPublishIfNeeded(for: sessionID, engine: engine)
+        }
+    }
+
+    /// The highest tier among the session's panes.
+    func renderTier(for sessionID: UUID) -> SessionRenderTier {
+        renderTiersBySessionID[sessionID]?.values.max() ?? .focused
+    }
+
+    // MARK: - Hibernation
+
+    /// Hibernate hidden sessions idle for `hibernationPolicy.idleInterval`,
+    /// or every hidden session when `force` is set (memory pressure).
+    func hibernateIdleSessions(now: Date = .now, force: Bool = false) async {
+        guard let manager else { return }
+        for (sessionID, engine) in manager.engines where !hibernatedSessionIDs.contains(sessionID) {
+            let tier = renderTier(for: sessionID)
+            let lastActivityAt = lastActivityAtBySessionID[sessionID] ?? now
+            guard tier == .hidden,
+                  force || hibernationPolicy.shouldHibernate(tier: tier, lastActivityAt: lastActivityAt, now: now) else {
+                continue
+            }
+            // Marked first, so publishes that start during the hop
+            // already skip the snapshot.
+            hibernatedSessionIDs.insert(sessionID)
+            linkDetectionLinesBySessionID.removeValue(forKey: sessionID)
+            await engine.hibernate()
+        }
+    }
+
+    private func startHibernationSweepIfNeeded() {
+        guard hibernationSweepTask == nil else { return }
+        hibernationSweepTask = Task { @MainActor [weak self] in
+            while !Task.isCancelled {
+                try? await Task.sleep(for: SessionHibernationPolicy.sweepInterval)
+                guard let self, !Task.isCancelled else { return }
+                await self.hibernateIdleSessions()
+                let waiting = self.renderTiersBySessionID.keys.contains { sessionID in
+                    self.renderTier(for: sessionID) == .hidden && !self.hibernatedSessionIDs.contains(sessionID)
+                }
+                guard waiting else {
+                    self.hibernationSweepTask = nil
+                    return
+                }
+            }
+        }
+    }
+
+    // MARK: - Snapshot feeds
+
+    /// Create the display-link feed for the pane `surfaceID` showing
+    /// `sessionID`, seeded with the current snapshot.
+    func attachSnapshotFeed(for sessionID: UUID, surfaceID: UUID) -> GridSnapshotFeed {
+        let feed = GridSnapshotFeed()
+        if let snapshot = gridSnapshotsBySessionID[sessionID] {
+            feed.write(snapshot)
+        }
+        snapshotFeedsBySessionID[sessionID, default: [:]][surfaceID] = feed
+        return feed
+    }
+
+    func detachSnapshotFeed(for sessionID: UUID, surfaceID: UUID) {
+        snapshotFeedsBySessionID[sessionID]?.removeValue(forKey: surfaceID)
+        if snapshotFeedsBySessionID[sessionID]?.isEmpty == true {
+            snapshotFeedsBySessionID.removeValue(forKey: sessionID)
+        }
+    }
+
+    /// Create the feed a mirror of `sessionID` encodes from, seeded with the
+    /// current snapshot.
+    func attachMirrorFeed(for sessionID: UUID) -> GridSnapshotFeed {
+        let feed = GridSnapshotFeed()
+        if let snapshot = gridSnapshotsBySessionID[sessionID] {
+            feed.write(snapshot)
+        }
+        mirrorFeedsBySessionID[sessionID] = feed
+        return feed
+    }
+
+    func detachMirrorFeed(for sessionID: UUID) {
+        mirrorFeedsBySessionID.removeValue(forKey: sessionID)
+    }
+
+    /// Store `snapshot` as the session's current grid and hand it to the
+    /// session's feeds.
+    func storeGridSnapshot(_ snapshot: GridSnapshot, for sessionID: UUID) {
+        gridSnapshotsBySessionID[sessionID] = snapshot
+        let inputTimestamp = pendingInputEchoBySessionID.removeValue(forKey: sessionID)
+        var trace = pendingLatencyTraceBySessionID.removeValue(forKey: sessionID)
+        trace?.publishedAt = CACurrentMediaTime()
+        pipelineCountersBySessionID[sessionID]?.recordSnapshotPublished()
+        mirrorFeedsBySessionID[sessionID]?.publish(snapshot)
+        guard let feeds = snapshotFeedsBySessionID[sessionID] else { return }
+        for feed in feeds.values {
+            feed.publish(snapshot, inputTimestamp: inputTimestamp, trace: trace)
+        }
+    }
+
+    /// Record that parsed output echoed a keystroke typed at `keystrokeAt`,
+    /// so the snapshot showing it carries the time to the renderer.
+    func noteInputEcho(sessionID: UUID, keystrokeAt: CFTimeInterval) {
+        pendingInputEchoBySessionID[sessionID] = min(pendingInputEchoBySessionID[sessionID] ?? keystrokeAt, keystrokeAt)
+    }
+
+    /// Hold a latency sample for the next snapshot stored for the session.
+    /// A sample already waiting is older and wins.
+    func noteLatencyTrace(_ trace: PipelineTrace, sessionID: UUID) {
+        pendingLatencyTraceBySessionID[sessionID] = PipelineTrace.earliest(pendingLatencyTraceBySessionID[sessionID], trace)
+    }
+
+    /// The session's pipeline counters, created on first use.
+    func pipelineCounters(for sessionID: UUID) -> SessionPipelineCounters {
+        if let counters = pipelineCountersBySessionID[sessionID] {
+            return counters
+        }
+        let counters = SessionPipelineCounters()
+        pipelineCountersBySessionID[sessionID] = counters
+        return counters
+    }
+
+    /// Totals for the session's performance HUD. Scrollback memory is the
+    /// last measurement; each call starts a new one unless one is running.
+    func performanceHUDStats(for sessionID: UUID) -> PerformanceHUDSessionStats {
+        if let engine = manager?.engines[sessionID], scrollbackMemoryRefreshSessionIDs.insert(sessionID).inserted {
+            Task { @MainActor [weak self] in
+                let bytes = await engine.scrollbackMemoryBytes
+                guard let self else { return }
+                self.scrollbackMemoryRefreshSessionIDs.remove(sessionID)
+                guard self.manager?.engines[sessionID] != nil else { return }
+                self.scrollbackMemoryBytesBySessionID[sessionID] = bytes
+            }
+        }
+        return PerformanceHUDSessionStats(
+            receivedBytes: manager?.liveStates[sessionID]?.bytesReceived ?? 0,
+            pipeline: pipelineCounters(for: sessionID).totals,
+            scrollbackBytes: scrollbackMemoryBytesBySessionID[sessionID]
+        )
+    }
+
+    /// Bump the session's snapshot nonce for panes that apply snapshots
+    /// through SwiftUI. Skipped while every pane showing the session pulls
+    /// from a feed, so publishes do not invalidate the views showing it.
+    func noteGridSnapshotChanged(for sessionID: UUID) {
+        guard snapshotFeedsBySessionID[sessionID] == nil, let live = manager?.liveState(for: sessionID) else { return }
+        live.gridSnapshotNonce = (live.gridSnapshotNonce ?? 0) + 1
+    }
+
+    /// `storeGridSnapshot` followed by `noteGridSnapshotChanged`.
+    private func publishGridSnapshot(_ snapshot: GridSnapshot, for sessionID: UUID) {
+        storeGridSnapshot(snapshot, for: sessionID)
+        noteGridSnapshotChanged(for: sessionID)
+    }
+
     // MARK: - Resize
 
     func resizeTerminal(sessionID: UUID, columns: Int, rows: Int) async {
@@ -210,8 +452,7 @@ import os.signpost
             if !deferGridResize {
                 await engine.resize(newColumns: columns, newRows: rows)
                 let snapshot = await engine.snapshot()
-                gridSnapshotsBySessionID[sessionID] = snapshot
-                manager.gridSnapshotNonceBySessionID[sessionID, default: 0] += 1
+                publishGridSnapshot(snapshot, for: sessionID)
                 cachedScrollbackCountBySessionID[sessionID] = await engine.scrollbackCount
             }
         } else {
@@ -232,8 +473,7 @@ import os.signpost
                 let finalRows = finalPTY?.rows ?? rows
                 await engine.resize(newColumns: finalColumns, newRows: finalRows)
                 let snapshot = await engine.snapshot()
-                self.gridSnapshotsBySessionID[sessionID] = snapshot
-                manager.gridSnapshotNonceBySessionID[sessionID, default: 0] += 1
+                self.publishGridSnapshot(snapshot, for: sessionID)
                 self.cachedScrollbackCountBySessionID[sessionID] = await engine.scrollbackCount
                 self.scrollOffsetBySessionID[sessionID] = 0
                 self.preserveScrollAnchorBySessionID[sessionID] = false
@@ -258,6 +498,15 @@ import os.signpost
         }
     }
 
+    // MARK: - Cell Pixel Size
+
+    /// The pane's cell size in device pixels, for inline images and
+    /// CSI 14 t / 16 t replies.
+    func setCellPixelSize(sessionID: UUID, width: Int, height: Int) async {
+        guard let engine = manager?.engines[sessionID] else { return }
+        await engine.setCellPixelSize(width: width, height: height)
+    }
+
     // MARK: - Shell buffer
 
     func clearShellBuffer(sessionID: UUID) {
@@ -267,9 +516,8 @@ import os.signpost
             await engine.eraseInDisplay(mode: 3)
             await engine.moveCursorTo(row: 0, col: 0)
             let snapshot = await engine.snapshot()
-            self.gridSnapshotsBySessionID[sessionID] = snapshot
-            manager.gridSnapshotNonceBySessionID[sessionID, default: 0] += 1
-            manager.shellBuffers[sessionID] = await engine.visibleText()
+            self.publishGridSnapshot(snapshot, for: sessionID)
+            manager.liveState(for: sessionID).update(\.shellBuffer, to: await engine.visibleText())
         }
     }
 
@@ -288,7 +536,7 @@ import os.signpost
         }
 
         Task { @MainActor [weak self] in
-            guard let self, let manager = self.manager else { return }
+            guard let self, self.manager != nil else { return }
             let current = self.scrollOffsetBySessionID[sessionID, default: 0]
             let maxOffset = await engine.scrollbackCount
             self.cachedScrollbackCountBySessionID[sessionID] = maxOffset
@@ -304,8 +552,7 @@ import os.signpost
                 self.preserveScrollAnchorBySessionID[sessionID] = false
             }
             let snapshot = await engine.snapshot(scrollOffset: newOffset)
-            self.gridSnapshotsBySessionID[sessionID] = snapshot
-            manager.gridSnapshotNonceBySessionID[sessionID, default: 0] += 1
+            self.publishGridSnapshot(snapshot, for: sessionID)
             self.publishScrollState(sessionID: sessionID, scrollOffset: newOffset, scrollbackCount: maxOffset)
         }
     }
@@ -319,7 +566,7 @@ import os.signpost
         }
 
         Task { @MainActor [weak self] in
-            guard let self, let manager = self.manager else { return }
+            guard let self, self.manager != nil else { return }
             let maxOffset = await engine.scrollbackCount
             self.cachedScrollbackCountBySessionID[sessionID] = maxOffset
             let clampedRow = max(0, min(row, maxOffset))
@@ -333,27 +580,67 @@ import os.signpost
                 self.preserveScrollAnchorBySessionID[sessionID] = false
             }
             let snapshot = await engine.snapshot(scrollOffset: clampedRow)
-            self.gridSnapshotsBySessionID[sessionID] = snapshot
-            manager.gridSnapshotNonceBySessionID[sessionID, default: 0] += 1
+            self.publishGridSnapshot(snapshot, for: sessionID)
             self.publishScrollState(sessionID: sessionID, scrollOffset: clampedRow, scrollbackCount: maxOffset)
         }
     }
 
+    /// History rows for the renderer's scrollback row ring, which moves
+    /// through them during a fling without a viewport snapshot per row.
+    func scrollbackRingRows(sessionID: UUID, positions: Range<Int>) async -> ScrollbackRingRows? {
+        guard let engine = manager?.engines[sessionID],
+              gridSnapshotsBySessionID[sessionID]?.usingAlternateBuffer != true else { return nil }
+        return await engine.scrollbackRingRows(positions: positions)
+    }
+
+    /// Scroll to the OSC 133 prompt above (`direction` < 0) or below the
+    /// top of the viewport.
+    func jumpToPrompt(sessionID: UUID, direction: Int) {
+        guard let manager, let engine = manager.engines[sessionID] else { return }
+        Task { @MainActor [weak self] in
+            guard let self else { return }
+            let current = self.scrollOffsetBySessionID[sessionID, default: 0]
+            guard let offset = await engine.promptScrollOffset(from: current, direction: direction) else { return }
+            self.scrollToRow(sessionID: sessionID, row: offset)
+        }
+    }
+
     func scrollToBottom(sessionID: UUID) {
         guard let manager, let engine = manager.engines[sessionID] else { return }
         scrollOffsetBySessionID[sessionID] = 0
         preserveScrollAnchorBySessionID[sessionID] = false
         Task { @MainActor [weak self] in
-            guard let self, let manager = self.manager else { return }
+            guard let self, self.manager != nil else { return }
             let snapshot = await engine.snapshot()
-            self.gridSnapshotsBySessionID[sessionID] = snapshot
-            manager.gridSnapshotNonceBySessionID[sessionID, default: 0] += 1
+            self.publishGridSnapshot(snapshot, for: sessionID)
             let scrollbackCount = await engine.scrollbackCount
             self.cachedScrollbackCountBySessionID[sessionID] = scrollbackCount
             self.publishScrollState(sessionID: sessionID, scrollOffset: 0, scrollbackCount: scrollbackCount)
         }
     }
 
+    /// Trim the session's scrollback to `lines` and republish with the
+    /// scroll offset clamped to what is left.
+    func trimScrollback(sessionID: UUID, toLines lines: Int) async {
+        guard let engine = manager?.engines[sessionID] else { return }
+        await engine.trimScrollback(toLines: lines)
+        await republishScrollback(sessionID: sessionID, engine: engine)
+    }
+
+    /// Republish after the session's scrollback changed outside the parser
+    /// (trimmed, or command output folded), with the scroll offset clamped
+    /// to what is there now.
+    func republishScrollback(sessionID: UUID, engine: TerminalEngine) async {
+        let scrollbackCount = await engine.scrollbackCount
+        let offset = min(scrollOffsetBySessionID[sessionID, default: 0], scrollbackCount)
+        scrollOffsetBySessionID[sessionID] = offset
+        cachedScrollbackCountBySessionID[sessionID] = scrollbackCount
+        scrollbackMemoryBytesBySessionID.removeValue(forKey: sessionID)
+        let snapshot = await engine.snapshot(scrollOffset: offset)
+        publishGridSnapshot(snapshot, for: sessionID)
+        publishScrollState(sessionID: sessionID, scrollOffset: offset, scrollbackCount: scrollbackCount)
+    }
+
     func isScrolledBack(sessionID: UUID) -> Bool {
         (scrollOffsetBySessionID[sessionID] ?? 0) > 0
     }
@@ -372,28 +659,31 @@ import os.signpost
         let didProcess = await engine.feed(data)
         if didProcess {
             let snapshot = await engine.snapshot()
-            gridSnapshotsBySessionID[sessionID] = snapshot
-            manager.gridSnapshotNonceBySessionID[sessionID, default: 0] += 1
-            manager.shellBuffers[sessionID] = await engine.visibleText()
+            publishGridSnapshot(snapshot, for: sessionID)
+            manager.liveState(for: sessionID).update(\.shellBuffer, to: await engine.visibleText())
         }
     }
 
     // MARK: - Playback
 
+    /// Feed a playback step and publish through the coalesced live-output
+    /// path, so fast playback publishes at most once per frame interval.
     func applyPlaybackStep(_ step: SessionPlaybackStep, to sessionID: UUID) async {
         guard let manager else { return }
         guard step.stream == .output else { return }
         guard let engine = manager.engines[sessionID] else { return }
-        let data = Data(step.text.utf8)
-        let didProcess = await engine.feed(data)
+        let didProcess = await engine.feed(step.payload)
         if didProcess {
-            let snapshot = await engine.snapshot()
-            gridSnapshotsBySessionID[sessionID] = snapshot
-            manager.gridSnapshotNonceBySessionID[sessionID, default: 0] += 1
-            manager.shellBuffers[sessionID] = await engine.visibleText()
+            await scheduleParsedChunkPublish(sessionID: sessionID, engine: engine)
         }
     }
 
+    /// Publish whatever playback fed since the last publish.
+    func finishPlayback(sessionID: UUID) async {
+        guard let engine = manager?.engines[sessionID] else { return }
+        await flushPendingSnapshotPublishIfNeeded(for: sessionID, engine: engine)
+    }
+
     // MARK: - Snapshot publishing pipeline
 
     func publishSyncExitSnapshot(
@@ -430,15 +720,32 @@ import os.signpost
         engine: TerminalEngine
     ) async {
         guard let manager else { return }
-        manager.inputModeSnapshotsBySessionID[sessionID] = await engine.inputModeSnapshot()
+        manager.liveState(for: sessionID).update(\.inputModeSnapshot, to: await engine.inputModeSnapshot())
+    }
+
+    /// Store an input mode snapshot the caller already captured (e.g. in a `FeedResult`).
+    func applyInputModeSnapshot(_ snapshot: InputModeSnapshot, sessionID: UUID) {
+        manager?.liveState(for: sessionID).update(\.inputModeSnapshot, to: snapshot)
     }
 
     func scheduleParsedChunkPublish(
         sessionID: UUID,
         engine: TerminalEngine
     ) async {
+        scheduleParsedChunkPublish(
+            sessionID: sessionID,
+            engine: engine,
+            usingAlternateBuffer: engine.mailbox.status.usingAlternateBuffer
+        )
+    }
+
+    func scheduleParsedChunkPublish(
+        sessionID: UUID,
+        engine: TerminalEngine,
+        usingAlternateBuffer: Bool
+    ) {
         let debounceMode: PublishDebounceMode
-        if await engine.usingAlternateBuffer {
+        if usingAlternateBuffer {
             debounceMode = .alternateBuffer
         } else if promptRedrawPendingSessionIDs.contains(sessionID) {
             debounceMode = .promptRedraw
@@ -466,6 +773,7 @@ import os.signpost
     }
 
     func noteSemanticPromptEvent(sessionID: UUID, event: SemanticPromptEvent) {
+        semanticPromptSessionIDs.insert(sessionID)
         switch event {
         case .promptStart, .commandEnd:
             promptRedrawPendingSessionIDs.insert(sessionID)
@@ -518,6 +826,8 @@ import os.signpost
     ) async {
         guard let manager else { return }
         guard manager.engines[sessionID] != nil else { return }
+        let traceStart = TraceRecorder.shared.begin()
+        defer { TraceRecorder.shared.end(.publish, since: traceStart) }
         #if DEBUG
         let signpostID = OSSignpostID(log: perfSignpostLog)
         os_signpost(.begin, log: perfSignpostLog, name: "PublishGridState", signpostID: signpostID)
@@ -534,85 +844,83 @@ import os.signpost
         }
         #endif
 
-        let previousScrollbackCount = cachedScrollbackCountBySessionID[sessionID] ?? 0
-        let scrollbackCount = await engine.scrollbackCount
-        let usingAlternateBuffer = await engine.usingAlternateBuffer
-        var currentOffset = scrollOffsetBySessionID[sessionID] ?? 0
-        if usingAlternateBuffer {
-            // Alternate buffer (TUI apps) should always show the live
-            // alternate-buffer content. Any residual scroll offset from
-            // an earlier user scroll must be cleared on every publish so
-            // rapid TUI redraws always display the latest frame.
-            currentOffset = 0
-            preserveScrollAnchorBySessionID[sessionID] = false
-        }
-        let shouldPreserveAnchor = preserveScrollAnchorBySessionID[sessionID, default: currentOffset > 0]
-        if !usingAlternateBuffer,
-           shouldPreserveAnchor,
-           currentOffset > 0,
-           scrollbackCount > previousScrollbackCount {
-            // Keep the same visible viewport while new lines append below.
-            currentOffset += (scrollbackCount - previousScrollbackCount)
-        }
-        currentOffset = max(0, min(currentOffset, scrollbackCount))
-        scrollOffsetBySessionID[sessionID] = currentOffset
-        if currentOffset == 0 {
-            preserveScrollAnchorBySessionID[sessionID] = false
+        // One hop gathers the snapshot, scroll state and housekeeping (see
+        // TerminalPublishUpdate); only the results are applied here.
+        let update = await engine.publishUpdate(TerminalPublishRequest(
+            scrollOffset: scrollOffsetBySessionID[sessionID] ?? 0,
+            previousScrollbackCount: cachedScrollbackCountBySessionID[sessionID] ?? 0,
+            preserveScrollAnchor: preserveScrollAnchorBySessionID[sessionID],
+            takesSnapshot: snapshotOverride == nil && !hibernatedSessionIDs.contains(sessionID),
+            housekeeping: skipHousekeeping ? nil : housekeepingRequest(for: sessionID, engine: engine)
+        ))
+        scrollOffsetBySessionID[sessionID] = update.scrollOffset
+        if let preserveScrollAnchor = update.preserveScrollAnchor {
+            preserveScrollAnchorBySessionID[sessionID] = preserveScrollAnchor
         }
-        cachedScrollbackCountBySessionID[sessionID] = scrollbackCount
-
-        let snapshot: GridSnapshot
-        if let snapshotOverride {
-            snapshot = snapshotOverride
-        } else if currentOffset > 0 {
-            snapshot = await engine.snapshot(scrollOffset: currentOffset)
-        } else {
-            snapshot = await engine.snapshot()
-        }
-        let shouldForceFullSnapshot = forceFullSnapshotNextPublishBySessionID.contains(sessionID)
-        let publishedSnapshot: GridSnapshot
-        if shouldForceFullSnapshot {
-            publishedSnapshot = GridSnapshot(
-                cells: snapshot.cells,
-                dirtyRange: nil,
-                cursorRow: snapshot.cursorRow,
-                cursorCol: snapshot.cursorCol,
-                cursorVisible: snapshot.cursorVisible,
-                cursorStyle: snapshot.cursorStyle,
-                columns: snapshot.columns,
-                rows: snapshot.rows,
-                usingAlternateBuffer: snapshot.usingAlternateBuffer,
-                graphemeOverrides: snapshot.graphemeOverrides
-            )
-            if snapshotOverride == nil {
-                forceFullSnapshotNextPublishBySessionID.remove(sessionID)
+        cachedScrollbackCountBySessionID[sessionID] = update.scrollbackCount
+
+        // Hibernated sessions take no snapshot and publish housekeeping only.
+        if let snapshot = snapshotOverride ?? update.snapshot {
+            let shouldForceFullSnapshot = forceFullSnapshotNextPublishBySessionID.contains(sessionID)
+            let publishedSnapshot: GridSnapshot
+            if shouldForceFullSnapshot {
+                publishedSnapshot = GridSnapshot(
+                    cells: snapshot.cells,
+                    dirtyRange: nil,
+                    cursorRow: snapshot.cursorRow,
+                    cursorCol: snapshot.cursorCol,
+                    cursorVisible: snapshot.cursorVisible,
+                    cursorStyle: snapshot.cursorStyle,
+                    columns: snapshot.columns,
+                    rows: snapshot.rows,
+                    usingAlternateBuffer: snapshot.usingAlternateBuffer,
+                    graphemeOverrides: snapshot.graphemeOverrides,
+                    compactCells: snapshot.compactCells,
+                    inlineImages: snapshot.inlineImages
+                )
+                if snapshotOverride == nil {
+                    forceFullSnapshotNextPublishBySessionID.remove(sessionID)
+                }
+            } else {
+                publishedSnapshot = snapshot
             }
-        } else {
-            publishedSnapshot = snapshot
+            storeGridSnapshot(publishedSnapshot, for: sessionID)
         }
-        gridSnapshotsBySessionID[sessionID] = publishedSnapshot
 
-        guard !skipHousekeeping else { return }
+        guard let housekeeping = update.housekeeping else { return }
 
-        await publishHousekeeping(
+        await applyHousekeeping(
+            housekeeping,
             for: sessionID,
-            engine: engine,
-            scrollOffset: currentOffset,
-            scrollbackCount: scrollbackCount,
-            usingAlternateBuffer: usingAlternateBuffer
+            scrollOffset: update.scrollOffset,
+            scrollbackCount: update.scrollbackCount
         )
     }
 
-    private func publishHousekeeping(
+    /// What housekeeping should read. Decided before the hop, from the
+    /// engine's mailbox, so the shell-buffer interval only starts when
+    /// text will actually be read.
+    private func housekeepingRequest(for sessionID: UUID, engine: TerminalEngine) -> TerminalHousekeepingRequest {
+        let wantsShellText = !engine.mailbox.status.usingAlternateBuffer && shouldPublishShellBuffer(for: sessionID)
+        let hasPublishedShellText = !(manager?.liveStates[sessionID]?.shellBuffer?.isEmpty ?? true)
+        return TerminalHousekeepingRequest(
+            wantsShellText: wantsShellText,
+            publishedTextVersion: hasPublishedShellText ? shellTextVersionBySessionID[sessionID] : nil
+        )
+    }
+
+    /// Apply the housekeeping gathered on the engine: nonce bump, scroll
+    /// state, shell buffer, links and command completion, bells, input
+    /// modes, title and working directory.
+    private func applyHousekeeping(
+        _ housekeeping: TerminalHousekeeping,
         for sessionID: UUID,
-        engine: TerminalEngine,
         scrollOffset: Int,
-        scrollbackCount: Int,
-        usingAlternateBuffer: Bool
+        scrollbackCount: Int
     ) async {
         guard let manager else { return }
 
-        manager.gridSnapshotNonceBySessionID[sessionID, default: 0] += 1
+        noteGridSnapshotChanged(for: sessionID)
 
         publishScrollState(
             sessionID: sessionID,
@@ -620,42 +928,89 @@ import os.signpost
             scrollbackCount: scrollbackCount
         )
 
-        if !usingAlternateBuffer && shouldPublishShellBuffer(for: sessionID) {
-            let visibleLines = await engine.visibleText()
-            manager.shellBuffers[sessionID] = visibleLines
-            if let completedBlock = await manager.terminalHistoryIndex.observeVisibleLines(
-                sessionID: sessionID,
-                lines: visibleLines,
-                at: .now
-            ) {
-                manager.publishCommandCompletion(completedBlock)
-            }
+        let live = manager.liveState(for: sessionID)
+        let visibleLines: [String]?
+        switch housekeeping.shellText {
+        case .notPublished:
+            visibleLines = nil
+        case .unchanged:
+            visibleLines = live.shellBuffer
+        case let .lines(lines):
+            live.shellBuffer = lines
+            shellTextVersionBySessionID[sessionID] = housekeeping.textVersion
+            visibleLines = lines
+        }
+        if let visibleLines {
+            scheduleLinkDetection(for: sessionID, lines: visibleLines)
         }
 
-        let bellCount = await engine.consumeBellCount()
+        let bellCount = housekeeping.bellCount
         if bellCount > 0 {
             if isInBurstMode(for: sessionID) {
                 let now = Date()
                 let lastBell = lastBellTimeBySessionID[sessionID] ?? .distantPast
                 if now.timeIntervalSince(lastBell) >= 1.0 {
-                    manager.bellEventNonceBySessionID[sessionID, default: 0] += 1
+                    live.bellEventNonce = (live.bellEventNonce ?? 0) + 1
                     lastBellTimeBySessionID[sessionID] = now
                 }
             } else {
-                manager.bellEventNonceBySessionID[sessionID, default: 0] += bellCount
+                live.bellEventNonce = (live.bellEventNonce ?? 0) + bellCount
+            }
+        }
+
+        live.update(\.inputModeSnapshot, to: housekeeping.inputModes)
+        if !housekeeping.windowTitle.isEmpty {
+            live.update(\.windowTitle, to: housekeeping.windowTitle)
+        }
+        if !housekeeping.workingDirectory.isEmpty, live.workingDirectory != housekeeping.workingDirectory {
+            // OSC 7: the shell changed directory, usually after a command that
+            // may have written to the old one. Drop both cached listings.
+            if let previous = live.workingDirectory {
+                manager.sftpCoordinator.invalidateRemoteDirectory(sessionID: sessionID, path: previous)
             }
+            manager.sftpCoordinator.invalidateRemoteDirectory(sessionID: sessionID, path: housekeeping.workingDirectory)
+            live.workingDirectory = housekeeping.workingDirectory
+        }
+
+        // Last, since it awaits the history index.
+        if let visibleLines, !semanticPromptSessionIDs.contains(sessionID),
+           let completedBlock = await manager.terminalHistoryIndex.observeVisibleLines(
+            sessionID: sessionID,
+            lines: visibleLines,
+            at: .now
+        ) {
+            manager.publishCommandCompletion(completedBlock)
         }
+    }
 
-        manager.inputModeSnapshotsBySessionID[sessionID] = await engine.inputModeSnapshot()
+    // MARK: - Link detection
 
-        let title = await engine.windowTitle
-        if !title.isEmpty {
-            manager.windowTitleBySessionID[sessionID] = title
+    /// Detect links in rows of `lines` that changed, off the main actor.
+    /// One pass runs per session; lines arriving meanwhile wait for it.
+    private func scheduleLinkDetection(for sessionID: UUID, lines: [String]) {
+        guard linkDetectionLinesBySessionID[sessionID] != lines else { return }
+        linkDetectionLinesBySessionID[sessionID] = lines
+        guard linkDetectionTasksBySessionID[sessionID] == nil else {
+            pendingLinkDetectionLinesBySessionID[sessionID] = lines
+            return
         }
 
-        let cwd = await engine.workingDirectory
-        if !cwd.isEmpty {
-            manager.workingDirectoryBySessionID[sessionID] = cwd
+        let rows = manager?.liveStates[sessionID]?.detectedLinks ?? TerminalLinkRows()
+        linkDetectionTasksBySessionID[sessionID] = Task { @MainActor [weak self] in
+            let (updated, scanned) = await Task.detached(priority: .utility) {
+                var rows = rows
+                let scanned = rows.update(lines: lines)
+                return (rows, scanned)
+            }.value
+            guard !Task.isCancelled, let self else { return }
+            if scanned > 0 {
+                manager?.liveState(for: sessionID).detectedLinks = updated
+            }
+            linkDetectionTasksBySessionID.removeValue(forKey: sessionID)
+            if let pending = pendingLinkDetectionLinesBySessionID.removeValue(forKey: sessionID) {
+                linkDetectionLinesBySessionID.removeValue(forKey: sessionID)
+                scheduleLinkDetection(for: sessionID, lines: pending)
+            }
         }
     }
 
@@ -664,11 +1019,11 @@ import os.signpost
     private func publishScrollState(sessionID: UUID, scrollOffset: Int, scrollbackCount: Int) {
         guard let manager else { return }
         let visibleRows = desiredPTYBySessionID[sessionID]?.rows ?? PTYConfiguration.default.rows
-        manager.scrollStateBySessionID[sessionID] = TerminalScrollState(
+        manager.liveState(for: sessionID).update(\.scrollState, to: TerminalScrollState(
             scrollOffset: scrollOffset,
             scrollbackCount: scrollbackCount,
             visibleRows: visibleRows
-        )
+        ))
     }
 
     // MARK: - Private helpers
@@ -737,6 +1092,7 @@ import os.signpost
         debounceMode: PublishDebounceMode,
         snapshotOverride: GridSnapshot? = nil
     ) {
+        lastActivityAtBySessionID[sessionID] = .now
         if isPublishingSuspended {
             suspendedDirtySessionIDs.insert(sessionID)
             return
@@ -768,20 +1124,26 @@ import os.signpost
 
             existingTask.cancel()
             pendingSnapshotPublishTasksBySessionID.removeValue(forKey: sessionID)
+            pipelineCountersBySessionID[sessionID]?.recordPublishDeferral()
         }
 
         pendingSnapshotPublishStartedAtBySessionID[sessionID] = firstScheduledAt
 
         pendingSnapshotPublishTasksBySessionID[sessionID] = Task { @MainActor [weak self] in
             guard let self else { return }
-            let interval: Duration
+            let base: Duration
             if debounceMode.requiresDebounce {
-                interval = self.publishInterval(for: debounceMode)
+                base = self.publishInterval(for: debounceMode)
             } else {
-                interval = self.isInBurstMode(for: sessionID)
+                base = self.isInBurstMode(for: sessionID)
                     ? self.throughputSnapshotPublishInterval
                     : self.snapshotPublishInterval
             }
+            let interval = SessionRenderBudget.publishInterval(
+                base: base,
+                tier: self.renderTier(for: sessionID),
+                thermalState: self.thermalStateProvider()
+            )
             try? await Task.sleep(for: interval)
             guard !Task.isCancelled else { return }
             self.pendingSnapshotPublishTasksBySessionID.removeValue(forKey: sessionID)
@@ -876,15 +1238,12 @@ import os.signpost
             }
             #endif
 
-            let scrollOffset = scrollOffsetBySessionID[sessionID] ?? 0
-            let scrollbackCount = cachedScrollbackCountBySessionID[sessionID] ?? 0
-            let usingAlt = await engine.usingAlternateBuffer
-            await publishHousekeeping(
+            let housekeeping = await engine.housekeeping(housekeepingRequest(for: sessionID, engine: engine))
+            await applyHousekeeping(
+                housekeeping,
                 for: sessionID,
-                engine: engine,
-                scrollOffset: scrollOffset,
-                scrollbackCount: scrollbackCount,
-                usingAlternateBuffer: usingAlt
+                scrollOffset: scrollOffsetBySessionID[sessionID] ?? 0,
+                scrollbackCount: cachedScrollbackCountBySessionID[sessionID] ?? 0
             )
 
             // Check for orphaned follow-ups that arrived during housekeeping awaits.
@@ -976,3 +1335,36 @@ import os.signpost
     }
 #endif
 }
+
+// MARK: - MemoryFootprintReporting
+
+extension TerminalRenderingCoordinator: MemoryFootprintReporting {
+    /// Snapshots held for the session, each cell array counted once, and
+    /// the buffers of every renderer pulling from one of its feeds. Panes
+    /// on the SwiftUI snapshot path have no feed and are not counted.
+    func memoryFootprint(for sessionID: UUID) -> MemoryFootprint {
+        var footprint = MemoryFootprint()
+        var seen = Set<UnsafeRawPointer>()
+        func count(_ snapshot: GridSnapshot) {
+            if let address = snapshot.cellStorageAddress, !seen.insert(address).inserted { return }
+            footprint[.snapshots] += snapshot.estimatedByteCount
+        }
+
+        let held = [
+            gridSnapshotsBySessionID[sessionID],
+            pendingSnapshotOverridesBySessionID[sessionID],
+            pendingScheduledSnapshotOverridesBySessionID[sessionID],
+        ]
+        for case let snapshot? in held {
+            count(snapshot)
+        }
+        mirrorFeedsBySessionID[sessionID]?.forEachRetainedSnapshot(count)
+        for feed in (snapshotFeedsBySessionID[sessionID] ?? [:]).values {
+            feed.forEachRetainedSnapshot(count)
+            if let renderer = feed.memoryFootprintProvider {
+                footprint += renderer()
+            }
+        }
+        return footprint
+    }
+}
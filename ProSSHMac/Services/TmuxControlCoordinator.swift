@@ -0,0 +1,469 @@
+// TmuxControlCoordinator.swift
+// ProSSHV2
+//
+// tmux control mode with native panes. An SSH session running `tmux -CC`
+// stops drawing tmux's screen: its parser reader hands the stream to a
+// TmuxControlDemultiplexer, which feeds each `%output` line straight into
+// the output ring of that pane's own session. Every tmux pane becomes a
+// session with its own TerminalEngine, tab, scrollback and search, and
+// the window's layout is published as a SplitNode for PaneManager.
+//
+// Keys typed into a pane go back as `send-keys -H`, and resizing a pane
+// view asks tmux to resize the pane; tmux answers with `%layout-change`,
+// which resizes the engines. A pane's screen and history are fetched with
+// `capture-pane` when it first appears. Status-line ticks and redraws for
+// pane switches never cross the link, since tmux sends only pane output.
+//
+// Off unless `SessionManager.tmuxControlModeEnabled` is set; without it
+// `tmux -CC` output reaches the engine unchanged.
+
+import Foundation
+import os.log
+
+// MARK: - TmuxCommand
+
+/// Control mode commands, one line each.
+nonisolated enum TmuxCommand {
+    /// Keys per `send-keys` command; long pastes are split.
+    static let maximumKeysPerCommand = 512
+
+    /// `bytes` as literal keys for `%pane`, in hex so any byte survives the
+    /// command parser.
+    static func sendKeys(_ bytes: [UInt8], pane: Int) -> [String] {
+        stride(from: 0, to: bytes.count, by: maximumKeysPerCommand).map { start in
+            let chunk = bytes[start..<min(start + maximumKeysPerCommand, bytes.count)]
+            let hex = chunk.map { String(format: "%02x", $0) }.joined(separator: " ")
+            return "send-keys -t %\(pane) -H \(hex)"
+        }
+    }
+
+    static func resizePane(_ pane: Int, columns: Int, rows: Int) -> String {
+        "resize-pane -t %\(pane) -x \(columns) -y \(rows)"
+    }
+
+    /// Sets the size tmux lays the client's windows out in.
+    static func setClientSize(columns: Int, rows: Int) -> String {
+        "refresh-client -C \(columns),\(rows)"
+    }
+
+    /// One line per window: `@<id> <active 0|1> <layout>`.
+    static let listWindows = "list-windows -F '#{window_id} #{window_active} #{window_layout}'"
+
+    /// The pane's history and screen with attributes, wrapped lines joined.
+    static func capturePane(_ pane: Int, historyLines: Int) -> String {
+        "capture-pane -p -e -J -t %\(pane) -S -\(historyLines)"
+    }
+
+    /// `<cursor_y> <cursor_x>`, zero-based.
+    static func cursorPosition(_ pane: Int) -> String {
+        "display-message -p -t %\(pane) '#{cursor_y} #{cursor_x}'"
+    }
+}
+
+// MARK: - TmuxCommandQueue
+
+/// Writes commands to the control mode channel and pairs the replies
+/// tmux sends back, in order, with the commands that asked for them.
+actor TmuxCommandQueue {
+    typealias ReplyHandler = @MainActor @Sendable (TmuxCommandReply) -> Void
+
+    private let channel: any SSHShellChannel
+    /// One entry per command sent, nil when its reply is not wanted.
+    private var pendingReplies: [ReplyHandler?] = []
+
+    init(channel: any SSHShellChannel) {
+        self.channel = channel
+    }
+
+    func send(
+        _ command: String,
+        priority: SSHShellWritePriority = .interactive,
+        reply: ReplyHandler? = nil
+    ) async {
+        // Queued before the write so a fast reply finds its handler. A
+        // failed write means the channel is gone along with control mode.
+        pendingReplies.append(reply)
+        try? await channel.send(bytes: Array((command + "\n").utf8), priority: priority)
+    }
+
+    func queuedBulkByteCount() async -> Int {
+        await channel.queuedBulkByteCount()
+    }
+
+    /// The handler for the oldest command without a reply yet.
+    func takeReplyHandler() -> ReplyHandler? {
+        guard !pendingReplies.isEmpty else { return nil }
+        return pendingReplies.removeFirst()
+    }
+}
+
+// MARK: - TmuxPaneChannel
+
+/// The shell channel of one tmux pane's session. Output arrives from the
+/// control mode session's demultiplexer; input and resizes become tmux
+/// commands on its channel.
+nonisolated final class TmuxPaneChannel: SSHShellChannel {
+    let paneID: Int
+    let outputRing: ShellOutputRing?
+    let rawOutput = AsyncStream<Data> { $0.finish() }
+    private let commands: TmuxCommandQueue
+
+    init(paneID: Int, commands: TmuxCommandQueue) {
+        self.paneID = paneID
+        self.outputRing = ShellOutputRing(capacity: 1 << 18)
+        self.commands = commands
+    }
+
+    /// Queues pane output for the pane session's parser.
+    func deliver(_ bytes: [UInt8]) async {
+        await outputRing?.append(bytes)
+    }
+
+    func send(_ input: String) async throws {
+        try await send(bytes: Array(input.utf8))
+    }
+
+    func send(bytes: [UInt8]) async throws {
+        try await send(bytes: bytes, priority: .interactive)
+    }
+
+    func send(bytes: [UInt8], priority: SSHShellWritePriority) async throws {
+        for command in TmuxCommand.sendKeys(bytes, pane: paneID) {
+            await commands.send(command, priority: priority)
+        }
+    }
+
+    func queuedBulkByteCount() async -> Int {
+        await commands.queuedBulkByteCount()
+    }
+
+    func resizePTY(columns: Int, rows: Int) async throws {
+        await commands.send(TmuxCommand.resizePane(paneID, columns: columns, rows: rows))
+    }
+
+    /// Ends the pane session's output; the tmux pane itself stays.
+    func close() async {
+        outputRing?.finish()
+    }
+}
+
+// MARK: - TmuxControlDemultiplexer
+
+/// Runs in a session's parser reader, in front of its engine. Terminal
+/// output goes to the engine in place, pane output to the pane channels,
+/// and every other control mode event to `events` for the coordinator.
+nonisolated final class TmuxControlDemultiplexer: @unchecked Sendable {
+    let events: AsyncStream<TmuxControlParser.Segment>
+    private let eventSink: AsyncStream<TmuxControlParser.Segment>.Continuation
+    /// Touched only by the parser reader task.
+    private var parser = TmuxControlParser()
+    private let lock = NSLock()
+    private var paneChannels: [Int: TmuxPaneChannel] = [:]
+
+    init() {
+        (events, eventSink) = AsyncStream.makeStream(bufferingPolicy: .unbounded)
+    }
+
+    deinit {
+        eventSink.finish()
+    }
+
+    func register(_ channel: TmuxPaneChannel) {
+        lock.withLock { paneChannels[channel.paneID] = channel }
+    }
+
+    func unregister(pane: Int) {
+        lock.withLock { _ = paneChannels.removeValue(forKey: pane) }
+    }
+
+    private func channel(for pane: Int) -> TmuxPaneChannel? {
+        lock.withLock { paneChannels[pane] }
+    }
+
+    /// The segments of `region`, or nil when all of it is terminal output
+    /// for the engine to parse as usual.
+    func segments(of region: UnsafeRawBufferPointer) -> [TmuxControlParser.Segment]? {
+        let segments = parser.parse(region)
+        if segments.count == 1, segments[0] == .terminal(0..<region.count) {
+            return nil
+        }
+        return segments
+    }
+
+    /// Feeds terminal segments of `region` to `engine` and routes the rest.
+    /// Returns the merged feed result, nil when no terminal output was fed.
+    func dispatch(
+        _ segments: [TmuxControlParser.Segment],
+        in region: UnsafeRawBufferPointer,
+        engine: TerminalEngine
+    ) async -> FeedResult? {
+        var result: FeedResult?
+        func merge(_ later: FeedResult) {
+            if result == nil { result = later } else { result?.merge(later) }
+        }
+        for segment in segments {
+            switch segment {
+            case .terminal(let range):
+                guard let base = region.baseAddress else { continue }
+                let span = Data(
+                    bytesNoCopy: UnsafeMutableRawPointer(mutating: base + range.lowerBound),
+                    count: range.count,
+                    deallocator: .none
+                )
+                merge(await engine.feedCollecting(borrowing: span))
+            case .terminalBytes(let bytes):
+                merge(await engine.feedCollecting(Data(bytes)))
+            case .notification(.output(let pane, let data)):
+                // Output of a pane without a session yet is dropped; its
+                // capture-pane fetches the screen once the session exists.
+                await channel(for: pane)?.deliver(data)
+            case .controlModeStarted, .controlModeEnded, .notification:
+                eventSink.yield(segment)
+            }
+        }
+        return result
+    }
+}
+
+// MARK: - TmuxControlCoordinator
+
+@MainActor final class TmuxControlCoordinator {
+    private static let logger = Logger(subsystem: "com.prossh", category: "TmuxControl")
+
+    weak var manager: SessionManager?
+
+    /// A session's control mode state, from DCS 1000p to `%exit`.
+    private final class Client {
+        let demultiplexer = TmuxControlDemultiplexer()
+        var commands: TmuxCommandQueue?
+        var eventTask: Task<Void, Never>?
+        /// The first reply answers the command that started control mode.
+        var receivedInitialReply = false
+        var layoutsByWindow: [Int: TmuxLayout] = [:]
+        var activeWindow: Int?
+        var sessionIDsByPane: [Int: UUID] = [:]
+        /// Stable SplitNode pane IDs, so views survive layout changes.
+        var viewIDsByPane: [Int: UUID] = [:]
+    }
+
+    private var clientsBySessionID: [UUID: Client] = [:]
+    /// The control mode session each pane session belongs to.
+    private var parentByPaneSessionID: [UUID: UUID] = [:]
+
+    init() {}
+
+    nonisolated deinit {}
+
+    /// The demultiplexer for `sessionID`'s parser reader, when control
+    /// mode is enabled and the session is not itself a tmux pane.
+    func demultiplexer(for sessionID: UUID) -> TmuxControlDemultiplexer? {
+        guard let manager, manager.tmuxControlModeEnabled,
+              parentByPaneSessionID[sessionID] == nil,
+              let session = manager.sessions.first(where: { $0.id == sessionID }),
+              !session.isLocal else { return nil }
+        endControlMode(sessionID: sessionID)
+        let client = Client()
+        client.eventTask = Task { [weak self, events = client.demultiplexer.events] in
+            for await event in events {
+                await self?.handle(event, sessionID: sessionID)
+            }
+        }
+        clientsBySessionID[sessionID] = client
+        return client.demultiplexer
+    }
+
+    func isPaneSession(_ sessionID: UUID) -> Bool {
+        parentByPaneSessionID[sessionID] != nil
+    }
+
+    /// The SSH session running control mode for pane session `sessionID`.
+    func controlSessionID(ofPane sessionID: UUID) -> UUID? {
+        parentByPaneSessionID[sessionID]
+    }
+
+    /// Forgets a removed session: a control mode session takes its pane
+    /// sessions with it, a closed pane session just leaves the layout.
+    func sessionEnded(_ sessionID: UUID) {
+        if let parentID = parentByPaneSessionID.removeValue(forKey: sessionID),
+           let client = clientsBySessionID[parentID],
+           let pane = client.sessionIDsByPane.first(where: { $0.value == sessionID })?.key {
+            client.demultiplexer.unregister(pane: pane)
+            client.sessionIDsByPane.removeValue(forKey: pane)
+            return
+        }
+        endControlMode(sessionID: sessionID)
+    }
+
+    // MARK: - Events
+
+    private func handle(_ event: TmuxControlParser.Segment, sessionID: UUID) async {
+        guard let client = clientsBySessionID[sessionID] else { return }
+        switch event {
+        case .controlModeStarted:
+            guard let channel = manager?.shellChannels[sessionID] else { return }
+            client.commands = TmuxCommandQueue(channel: channel)
+            client.receivedInitialReply = false
+            Self.logger.info("tmux control mode started")
+        case .controlModeEnded, .notification(.exit):
+            closePanes(of: client, sessionID: sessionID)
+            client.commands = nil
+        case .notification(.reply(let reply)):
+            guard client.receivedInitialReply else {
+                client.receivedInitialReply = true
+                await attach(client, sessionID: sessionID)
+                return
+            }
+            guard reply.fromClient, let handler = await client.commands?.takeReplyHandler() else { return }
+            handler(reply)
+        case .notification(.layoutChange(let window, let layout)):
+            guard let parsed = TmuxLayout(parsing: layout) else {
+                Self.logger.error("Unparsed tmux layout: \(layout, privacy: .public)")
+                return
+            }
+            client.layoutsByWindow[window] = parsed
+            await syncPanes(of: client, sessionID: sessionID)
+        case .notification(.windowAdd), .notification(.sessionChanged):
+            await listWindows(of: client, sessionID: sessionID)
+        case .notification(.windowClose(let window)):
+            client.layoutsByWindow.removeValue(forKey: window)
+            if client.activeWindow == window {
+                client.activeWindow = client.layoutsByWindow.keys.min()
+            }
+            await syncPanes(of: client, sessionID: sessionID)
+        case .notification(.sessionWindowChanged(_, let window)):
+            client.activeWindow = window
+            publishLayout(of: client, sessionID: sessionID)
+        case .notification(.output), .notification(.windowRenamed), .notification(.windowPaneChanged),
+             .terminal, .terminalBytes:
+            break
+        }
+    }
+
+    /// Sizes the client like the session's terminal and loads its windows.
+    private func attach(_ client: Client, sessionID: UUID) async {
+        guard let manager, let commands = client.commands else { return }
+        let pty = manager.renderingCoordinator.sanitizedPTY(for: sessionID)
+        await commands.send(TmuxCommand.setClientSize(columns: pty.columns, rows: pty.rows))
+        await listWindows(of: client, sessionID: sessionID)
+    }
+
+    private func listWindows(of client: Client, sessionID: UUID) async {
+        await client.commands?.send(TmuxCommand.listWindows) { [weak self, weak client] reply in
+            guard let self, let client, reply.succeeded else { return }
+            var layouts: [Int: TmuxLayout] = [:]
+            for line in reply.lines {
+                let fields = line.split(separator: " ", maxSplits: 2).map(String.init)
+                guard fields.count == 3,
+                      let window = TmuxControlParser.identifier(fields[0], sigil: "@"),
+                      let layout = TmuxLayout(parsing: fields[2]) else { continue }
+                layouts[window] = layout
+                if fields[1] == "1" { client.activeWindow = window }
+            }
+            client.layoutsByWindow = layouts
+            Task { await self.syncPanes(of: client, sessionID: sessionID) }
+        }
+    }
+
+    // MARK: - Panes
+
+    /// Opens sessions for new panes, closes those of panes that are gone,
+    /// sizes the rest as tmux laid them out, then publishes the layout.
+    private func syncPanes(of client: Client, sessionID: UUID) async {
+        guard let manager, let commands = client.commands else { return }
+        var sizes: [Int: (columns: Int, rows: Int)] = [:]
+        for layout in client.layoutsByWindow.values {
+            for pane in layout.panes {
+                sizes[pane.id] = (pane.columns, pane.rows)
+            }
+        }
+
+        for (pane, paneSessionID) in client.sessionIDsByPane where sizes[pane] == nil {
+            client.demultiplexer.unregister(pane: pane)
+            client.sessionIDsByPane.removeValue(forKey: pane)
+            client.viewIDsByPane.removeValue(forKey: pane)
+            parentByPaneSessionID.removeValue(forKey: paneSessionID)
+            await manager.closeTmuxPaneSession(paneSessionID)
+        }
+
+        for (pane, size) in sizes.sorted(by: { $0.key < $1.key }) {
+            if let paneSessionID = client.sessionIDsByPane[pane] {
+                await manager.renderingCoordinator.resizeTerminal(
+                    sessionID: paneSessionID,
+                    columns: size.columns,
+                    rows: size.rows
+                )
+                continue
+            }
+            let channel = TmuxPaneChannel(paneID: pane, commands: commands)
+            guard let paneSessionID = await manager.openTmuxPaneSession(
+                parentID: sessionID,
+                title: "tmux %\(pane)",
+                channel: channel,
+                columns: size.columns,
+                rows: size.rows
+            ) else { continue }
+            client.sessionIDsByPane[pane] = paneSessionID
+            parentByPaneSessionID[paneSessionID] = sessionID
+            client.demultiplexer.register(channel)
+            await loadScreen(of: pane, into: channel, commands: commands)
+        }
+
+        publishLayout(of: client, sessionID: sessionID)
+    }
+
+    /// Fetches a new pane's history and screen, then moves the cursor to
+    /// where tmux has it.
+    private func loadScreen(of pane: Int, into channel: TmuxPaneChannel, commands: TmuxCommandQueue) async {
+        let historyLines = manager?.configuredScrollbackLines ?? TerminalDefaults.maxScrollbackLines
+        await commands.send(TmuxCommand.capturePane(pane, historyLines: historyLines)) { reply in
+            guard reply.succeeded else { return }
+            let screen = Array(reply.lines.joined(separator: "\r\n").utf8)
+            Task { await channel.deliver(Array("\u{1B}[H\u{1B}[2J".utf8) + screen) }
+        }
+        await commands.send(TmuxCommand.cursorPosition(pane)) { reply in
+            let fields = reply.lines.first?.split(separator: " ").compactMap { Int($0) } ?? []
+            guard reply.succeeded, fields.count == 2 else { return }
+            Task { await channel.deliver(Array("\u{1B}[\(fields[0] + 1);\(fields[1] + 1)H".utf8)) }
+        }
+    }
+
+    private func publishLayout(of client: Client, sessionID: UUID) {
+        guard let manager else { return }
+        guard let window = client.activeWindow ?? client.layoutsByWindow.keys.min(),
+              let layout = client.layoutsByWindow[window],
+              let session = manager.sessions.first(where: { $0.id == sessionID }) else {
+            manager.setTmuxLayout(nil, for: sessionID)
+            return
+        }
+        let node = layout.splitNode { pane in
+            let viewID = client.viewIDsByPane[pane] ?? UUID()
+            client.viewIDsByPane[pane] = viewID
+            return TerminalPane(
+                id: viewID,
+                sessionID: client.sessionIDsByPane[pane],
+                sessionType: .ssh(hostID: session.hostID, hostLabel: session.hostLabel),
+                title: "tmux %\(pane)"
+            )
+        }
+        manager.setTmuxLayout(node, for: sessionID)
+    }
+
+    private func closePanes(of client: Client, sessionID: UUID) {
+        for (pane, paneSessionID) in client.sessionIDsByPane {
+            client.demultiplexer.unregister(pane: pane)
+            parentByPaneSessionID.removeValue(forKey: paneSessionID)
+            Task { [weak self] in await self?.manager?.closeTmuxPaneSession(paneSessionID) }
+        }
+        client.sessionIDsByPane.removeAll()
+        client.viewIDsByPane.removeAll()
+        client.layoutsByWindow.removeAll()
+        client.activeWindow = nil
+        manager?.setTmuxLayout(nil, for: sessionID)
+    }
+
+    private func endControlMode(sessionID: UUID) {
+        guard let client = clientsBySessionID.removeValue(forKey: sessionID) else { return }
+        client.eventTask?.cancel()
+        closePanes(of: client, sessionID: sessionID)
+    }
+}
@@ -0,0 +1,320 @@
+// TraceRecorder.swift
+// ProSSHV2
+//
+// Always-on flight recorder for the app's own trace events. The pipeline
+// stages write spans into a fixed ring: parser chunks, publish cycles,
+// frame encode, GPU execution and present, glyph raster batches, SFTP
+// transfers, AI tool calls, store writes, reflows, terminal view updates
+// and the hitches HitchDetector found. "Save Last 30 Seconds of Trace" in Settings
+// exports them as a Chrome trace-event JSON file, which opens in Perfetto
+// (ui.perfetto.dev) or chrome://tracing. Users can send a trace after a
+// hitch instead of being asked to reproduce it with Instruments.
+//
+// Events are fixed-size and the ring is allocated once, so recording a span
+// costs two timestamps, a thread id and a short locked store. Only AI tool
+// spans carry a string label. When the ring wraps, the oldest events are
+// overwritten. At 64K events that is well over 30 seconds of a busy
+// session.
+//
+// SFTP spans cover one file or one byte range, not single requests. The
+// request loop runs in C with many reads pipelined, so a single request has
+// no meaningful span of its own at this level.
+//
+// On by default. Toggle via: `defaults write com.prossh diagnostics.traceRecorder.enabled -bool false`
+
+import Foundation
+import QuartzCore
+import Synchronization
+
+// MARK: - TraceEventName
+
+nonisolated enum TraceEventName: UInt8, CaseIterable, Sendable {
+    case parserChunk
+    case publish
+    case frameEncode
+    case gpuFrame
+    case present
+    case glyphRasterBatch
+    case sftpUpload
+    case sftpDownload
+    case sftpRange
+    case aiTool
+    case storeWrite
+    case reflow
+    case viewUpdate
+    case hitch
+
+    var label: String {
+        switch self {
+        case .parserChunk: "ParserChunk"
+        case .publish: "PublishGridState"
+        case .frameEncode: "FrameEncode"
+        case .gpuFrame: "GPUFrame"
+        case .present: "Present"
+        case .glyphRasterBatch: "GlyphRasterBatch"
+        case .sftpUpload: "SFTPUpload"
+        case .sftpDownload: "SFTPDownload"
+        case .sftpRange: "SFTPRange"
+        case .aiTool: "AITool"
+        case .storeWrite: "StoreWrite"
+        case .reflow: "Reflow"
+        case .viewUpdate: "UpdateNSView"
+        case .hitch: "Hitch"
+        }
+    }
+
+    var category: String {
+        switch self {
+        case .parserChunk: "parser"
+        case .publish: "publish"
+        case .frameEncode, .present: "frame"
+        case .gpuFrame: "gpu"
+        case .glyphRasterBatch: "glyphs"
+        case .sftpUpload, .sftpDownload, .sftpRange: "sftp"
+        case .aiTool: "ai"
+        case .storeWrite: "store"
+        case .reflow: "grid"
+        case .viewUpdate: "ui"
+        case .hitch: "hitch"
+        }
+    }
+
+    /// What `TraceEvent.value` counts, as the exported argument name.
+    var valueName: String? {
+        switch self {
+        case .parserChunk, .sftpUpload, .sftpDownload, .sftpRange: "bytes"
+        case .glyphRasterBatch: "glyphs"
+        case .publish, .frameEncode, .gpuFrame, .present, .aiTool, .storeWrite, .reflow, .viewUpdate, .hitch: nil
+        }
+    }
+}
+
+// MARK: - TraceEvent
+
+nonisolated struct TraceEvent: Sendable {
+    var name: TraceEventName
+    /// `CACurrentMediaTime()` seconds.
+    var start: CFTimeInterval
+    /// 0 for instant events.
+    var duration: CFTimeInterval
+    var threadID: UInt64
+    var value: Int64
+    var label: String?
+}
+
+// MARK: - TraceRecorder
+
+nonisolated final class TraceRecorder: @unchecked Sendable {
+
+    static let shared = TraceRecorder()
+
+    static let enabledDefaultsKey = "diagnostics.traceRecorder.enabled"
+
+    static var isEnabledByDefaults: Bool {
+        UserDefaults.standard.object(forKey: enabledDefaultsKey) as? Bool ?? true
+    }
+
+    /// Track id for GPU spans, which run on no CPU thread.
+    static let gpuTrackID: UInt64 = 1
+
+    /// How far an event may be recorded after one that ended later. GPU
+    /// spans arrive on completion, a frame or two after they ended.
+    static let recordingSlack: CFTimeInterval = 1
+
+    let capacity: Int
+
+    private let enabled = Atomic<Bool>(false)
+    private let mainThreadID = Atomic<UInt64>(0)
+    private let lock = NSLock()
+    private var events: [TraceEvent] = []
+    /// Slot the next event is written to.
+    private var head = 0
+
+    init(capacity: Int = 1 << 16) {
+        self.capacity = max(capacity, 1)
+    }
+
+    var isEnabled: Bool {
+        enabled.load(ordering: .relaxed)
+    }
+
+    /// The main thread's id, once an event was recorded on it.
+    var mainThreadIdentifier: UInt64 {
+        mainThreadID.load(ordering: .relaxed)
+    }
+
+    /// The ring is allocated on first enable and kept, so toggling does not
+    /// lose what was recorded.
+    func setEnabled(_ isEnabled: Bool) {
+        if isEnabled {
+            lock.lock()
+            if events.isEmpty {
+                events.reserveCapacity(capacity)
+            }
+            lock.unlock()
+        }
+        enabled.store(isEnabled, ordering: .relaxed)
+    }
+
+    // MARK: Recording
+
+    /// Start time for a span, or nil while disabled.
+    func begin() -> CFTimeInterval? {
+        isEnabled ? CACurrentMediaTime() : nil
+    }
+
+    /// Close the span opened by `begin()` on the current thread.
+    func end(_ name: TraceEventName, since start: CFTimeInterval?, value: Int64 = 0, label: String? = nil) {
+        guard let start else { return }
+        record(name, start: start, end: CACurrentMediaTime(), value: value, label: label)
+    }
+
+    /// Record a span measured elsewhere, e.g. from command buffer GPU times.
+    func record(
+        _ name: TraceEventName,
+        start: CFTimeInterval,
+        end: CFTimeInterval,
+        threadID: UInt64? = nil,
+        value: Int64 = 0,
+        label: String? = nil
+    ) {
+        guard isEnabled, start > 0, end >= start else { return }
+        let event = TraceEvent(
+            name: name,
+            start: start,
+            duration: end - start,
+            threadID: threadID ?? currentThreadID(),
+            value: value,
+            label: label
+        )
+        lock.lock()
+        if events.count < capacity {
+            events.append(event)
+        } else {
+            events[head] = event
+        }
+        head = (head + 1) % capacity
+        lock.unlock()
+    }
+
+    func instant(_ name: TraceEventName, at time: CFTimeInterval, threadID: UInt64? = nil) {
+        record(name, start: time, end: time, threadID: threadID)
+    }
+
+    func reset() {
+        lock.lock()
+        events.removeAll(keepingCapacity: true)
+        head = 0
+        lock.unlock()
+    }
+
+    func currentThreadID() -> UInt64 {
+        var threadID: UInt64 = 0
+        pthread_threadid_np(nil, &threadID)
+        if pthread_main_np() != 0 {
+            mainThreadID.store(threadID, ordering: .relaxed)
+        }
+        return threadID
+    }
+
+    // MARK: Export
+
+    /// Events that ended within `seconds` of `now`, oldest first.
+    func recentEvents(lastSeconds seconds: CFTimeInterval, now: CFTimeInterval = CACurrentMediaTime()) -> [TraceEvent] {
+        lock.lock()
+        let ordered = events.count < capacity
+            ? events
+            : Array(events[head...] + events[..<head])
+        lock.unlock()
+        let cutoff = now - seconds
+        return ordered.filter { $0.start + $0.duration >= cutoff }
+    }
+
+    /// Events that overlap `start...end`, oldest first. Walks back from the
+    /// newest event, so a recent window costs only the events after it.
+    func events(overlapping start: CFTimeInterval, _ end: CFTimeInterval) -> [TraceEvent] {
+        var matches: [TraceEvent] = []
+        lock.lock()
+        let count = events.count
+        var index = head
+        for _ in 0..<count {
+            index = (index - 1 + count) % count
+            let event = events[index]
+            let eventEnd = event.start + event.duration
+            if eventEnd < start - Self.recordingSlack { break }
+            if event.start <= end, eventEnd >= start {
+                matches.append(event)
+            }
+        }
+        lock.unlock()
+        return matches.reversed()
+    }
+
+    /// Chrome trace-event JSON for the last `seconds`, as Perfetto and
+    /// chrome://tracing load it.
+    func chromeTrace(lastSeconds seconds: CFTimeInterval = 30, now: CFTimeInterval = CACurrentMediaTime()) throws -> Data {
+        try Self.chromeTrace(
+            events: recentEvents(lastSeconds: seconds, now: now),
+            mainThreadID: mainThreadID.load(ordering: .relaxed)
+        )
+    }
+
+    static func chromeTrace(events: [TraceEvent], mainThreadID: UInt64) throws -> Data {
+        let pid = Int(ProcessInfo.processInfo.processIdentifier)
+        var traceEvents: [[String: Any]] = []
+        traceEvents.reserveCapacity(events.count + 4)
+
+        var threadIDs = Set(events.map(\.threadID))
+        threadIDs.insert(mainThreadID)
+        for threadID in threadIDs.sorted() where threadID != 0 {
+            let name: String
+            switch threadID {
+            case mainThreadID: name = "Main"
+            case gpuTrackID: name = "GPU"
+            default: name = "Thread \(threadID)"
+            }
+            traceEvents.append([
+                "ph": "M", "name": "thread_name", "pid": pid, "tid": threadID,
+                "args": ["name": name],
+            ])
+        }
+
+        for event in events {
+            var entry: [String: Any] = [
+                "name": event.label.map { "\(event.name.label) \($0)" } ?? event.name.label,
+                "cat": event.name.category,
+                "pid": pid,
+                "tid": event.threadID,
+                "ts": event.start * 1_000_000,
+            ]
+            if event.duration > 0 {
+                entry["ph"] = "X"
+                entry["dur"] = event.duration * 1_000_000
+            } else {
+                entry["ph"] = "i"
+                entry["s"] = "t"
+            }
+            if let valueName = event.name.valueName {
+                entry["args"] = [valueName: event.value]
+            }
+            traceEvents.append(entry)
+        }
+
+        return try JSONSerialization.data(
+            withJSONObject: ["traceEvents": traceEvents, "displayTimeUnit": "ms"],
+            options: [.sortedKeys]
+        )
+    }
+
+    /// Writes the last `seconds` to `~/Downloads/ProSSHMac-trace-<time>.json`.
+    func saveRecentTrace(lastSeconds seconds: CFTimeInterval = 30) throws -> URL {
+        let data = try chromeTrace(lastSeconds: seconds)
+        let directory = FileManager.default.urls(for: .downloadsDirectory, in: .userDomainMask).first
+            ?? FileManager.default.temporaryDirectory
+        let formatter = DateFormatter()
+        formatter.dateFormat = "yyyyMMdd-HHmmss"
+        let url = directory.appendingPathComponent("ProSSHMac-trace-\(formatter.string(from: .now)).json")
+        try data.write(to: url, options: .atomic)
+        return url
+    }
+}
@@ -14,13 +14,34 @@ final class TransferManager: ObservableObject {
     private var queuedTransferIDs: [UUID] = []
     private var pausedTransferIDs: Set<UUID> = []
     private var cancelRequestedIDs: Set<UUID> = []
-    private var workerTask: Task<Void, Never>?
-    private var activeTransferTask: Task<SFTPTransferResult, Error>?
-    private var activeTransferID: UUID?
+    private var scheduler: TransferScheduler
+    private var runningTransferSessions: [UUID: UUID] = [:]
+    private var activeTransferTasks: [UUID: Task<SFTPTransferResult, Error>] = [:]
+
+    /// How often running transfers' meters are copied into their live progress.
+    static let progressSampleInterval: Duration = .milliseconds(100)
+
+    private var progressMeters: [UUID: TransferProgressMeter] = [:]
+    private var liveProgressByTransferID: [UUID: TransferLiveProgress] = [:]
+    private var progressSamplerTask: Task<Void, Never>?
+    /// Cancels each running in-band transfer (see InBandTransferCoordinator).
+    private var inBandCancelHandlers: [UUID: () -> Void] = [:]
+
+    init(scheduler: TransferScheduler = TransferScheduler()) {
+        self.scheduler = scheduler
+    }
+
+    /// Concurrency limits for the scheduler; raising them starts queued work immediately.
+    func setConcurrencyLimits(perSession: Int, total: Int) {
+        scheduler.maxConcurrentPerSession = max(1, perSession)
+        scheduler.maxConcurrentTotal = max(1, total)
+        scheduleQueuedTransfers()
+    }
 
     func configure(sessionManager: SessionManager) {
         if self.sessionManager == nil {
             self.sessionManager = sessionManager
+            sessionManager.inBandTransferCoordinator.transferManager = self
         }
     }
 
@@ -70,11 +91,14 @@ final class TransferManager: ObservableObject {
     }
 
     func enqueueDownload(entry: SFTPDirectoryEntry) {
-        guard !entry.isDirectory else { return }
         guard let sessionID = activeSessionID else {
             errorMessage = "Select an active SSH session before downloading files."
             return
         }
+        if entry.isDirectory {
+            enqueueDirectoryDownload(entry: entry, sessionID: sessionID)
+            return
+        }
 
         do {
             let destinationDirectory = try Self.defaultDownloadDirectory()
@@ -105,6 +129,12 @@ final class TransferManager: ObservableObject {
             return
         }
 
+        var isDirectory: ObjCBool = false
+        if FileManager.default.fileExists(atPath: localFileURL.path, isDirectory: &isDirectory), isDirectory.boolValue {
+            enqueueDirectoryUpload(localDirectoryURL: localFileURL, sessionID: sessionID)
+            return
+        }
+
         do {
             let attributes = try FileManager.default.attributesOfItem(atPath: localFileURL.path)
             let fileSize = (attributes[.size] as? NSNumber)?.int64Value ?? 0
@@ -129,6 +159,157 @@ final class TransferManager: ObservableObject {
         }
     }
 
+    // MARK: - Folder Transfers
+
+    /// Downloads `entry` recursively into the Downloads folder. Files are queued
+    /// as each remote directory is read, so transfers start while the walk is
+    /// still running; files whose local copy matches by size and mtime are skipped.
+    private func enqueueDirectoryDownload(entry: SFTPDirectoryEntry, sessionID: UUID) {
+        guard let sessionManager else { return }
+
+        let localRoot: URL
+        do {
+            localRoot = try Self.defaultDownloadDirectory().appendingPathComponent(entry.name, isDirectory: true)
+            try FileManager.default.createDirectory(at: localRoot, withIntermediateDirectories: true, attributes: nil)
+        } catch {
+            errorMessage = "Failed to prepare folder download: \(error.localizedDescription)"
+            return
+        }
+
+        let remoteRoot = normalizeRemotePath(entry.path)
+        Task { @MainActor [weak self] in
+            do {
+                let batches = try await sessionManager.walkRemoteDirectory(sessionID: sessionID, path: remoteRoot, recursive: true)
+                for try await batch in batches {
+                    guard let self else { return }
+                    self.enqueueDownloads(batch, remoteRoot: remoteRoot, localRoot: localRoot, sessionID: sessionID)
+                }
+            } catch {
+                self?.errorMessage = "Failed to download folder (\(entry.name)): \(error.localizedDescription)"
+            }
+        }
+    }
+
+    private func enqueueDownloads(_ batch: [SFTPDirectoryEntry], remoteRoot: String, localRoot: URL, sessionID: UUID) {
+        var downloads: [Transfer] = []
+        for entry in batch {
+            guard let relativePath = DirectorySyncPlanner.relativePath(of: entry.path, under: remoteRoot) else { continue }
+            let localURL = localRoot.appendingPathComponent(relativePath, isDirectory: entry.isDirectory)
+
+            // The walk is breadth-first, so a directory is always seen before its files.
+            if entry.isDirectory {
+                try? FileManager.default.createDirectory(at: localURL, withIntermediateDirectories: true, attributes: nil)
+                continue
+            }
+            // Symlinks and special files are skipped, as rsync does without -l.
+            guard entry.isRegularFile else { continue }
+
+            let attributes = try? FileManager.default.attributesOfItem(atPath: localURL.path)
+            if DirectorySyncPlanner.isUnchanged(
+                sourceSize: entry.size,
+                sourceModified: entry.modifiedAt,
+                destinationSize: (attributes?[.size] as? NSNumber)?.int64Value,
+                destinationModified: attributes?[.modificationDate] as? Date
+            ) {
+                continue
+            }
+
+            downloads.append(
+                Transfer(
+                    id: UUID(),
+                    sessionID: sessionID,
+                    sourcePath: entry.path,
+                    destinationPath: localURL.path,
+                    direction: .download,
+                    bytesTransferred: 0,
+                    totalBytes: entry.size,
+                    state: .queued,
+                    createdAt: .now,
+                    updatedAt: .now,
+                    sourceModifiedAt: entry.modifiedAt
+                )
+            )
+        }
+        enqueueTransfers(downloads)
+    }
+
+    /// Uploads a local folder recursively under the current remote path. Each
+    /// remote directory is created, then read once for the size and mtime of
+    /// everything already there; only changed files are queued.
+    private func enqueueDirectoryUpload(localDirectoryURL: URL, sessionID: UUID) {
+        guard let sessionManager else { return }
+
+        let remoteRoot = joinRemotePath(currentRemotePath, localDirectoryURL.lastPathComponent)
+        let resourceKeys: Set<URLResourceKey> = [.isDirectoryKey, .isRegularFileKey, .fileSizeKey, .contentModificationDateKey]
+
+        Task { @MainActor [weak self] in
+            var pending: [(local: URL, remote: String)] = [(localDirectoryURL, remoteRoot)]
+            do {
+                while !pending.isEmpty {
+                    let (localDirectory, remoteDirectory) = pending.removeFirst()
+                    try await sessionManager.createRemoteDirectory(sessionID: sessionID, path: remoteDirectory)
+
+                    var existing: [String: SFTPDirectoryEntry] = [:]
+                    let batches = try await sessionManager.walkRemoteDirectory(sessionID: sessionID, path: remoteDirectory, recursive: false)
+                    for try await batch in batches {
+                        for entry in batch {
+                            existing[entry.name] = entry
+                        }
+                    }
+
+                    let children = try FileManager.default.contentsOfDirectory(
+                        at: localDirectory,
+                        includingPropertiesForKeys: Array(resourceKeys)
+                    ).sorted { $0.lastPathComponent < $1.lastPathComponent }
+
+                    var uploads: [Transfer] = []
+                    for child in children {
+                        let values = try child.resourceValues(forKeys: resourceKeys)
+                        let remotePath = RemotePath.join(remoteDirectory, child.lastPathComponent)
+                        if values.isDirectory == true {
+                            pending.append((child, remotePath))
+                            continue
+                        }
+                        // Symlinks and special files are skipped, as rsync does without -l.
+                        guard values.isRegularFile == true else { continue }
+
+                        let size = Int64(values.fileSize ?? 0)
+                        if let remote = existing[child.lastPathComponent], !remote.isDirectory,
+                           DirectorySyncPlanner.isUnchanged(
+                               sourceSize: size,
+                               sourceModified: values.contentModificationDate,
+                               destinationSize: remote.size,
+                               destinationModified: remote.modifiedAt
+                           ) {
+                            continue
+                        }
+
+                        uploads.append(
+                            Transfer(
+                                id: UUID(),
+                                sessionID: sessionID,
+                                sourcePath: child.path,
+                                destinationPath: remotePath,
+                                direction: .upload,
+                                bytesTransferred: 0,
+                                totalBytes: size,
+                                state: .queued,
+                                createdAt: .now,
+                                updatedAt: .now,
+                                sourceModifiedAt: values.contentModificationDate
+                            )
+                        )
+                    }
+
+                    guard let self else { return }
+                    self.enqueueTransfers(uploads)
+                }
+            } catch {
+                self?.errorMessage = "Failed to upload folder (\(localDirectoryURL.lastPathComponent)): \(error.localizedDescription)"
+            }
+        }
+    }
+
     func pauseTransfer(_ transferID: UUID) {
         guard let index = transfers.firstIndex(where: { $0.id == transferID }) else { return }
         guard transfers[index].state == .queued else { return }
@@ -148,7 +329,7 @@ final class TransferManager: ObservableObject {
         if queuedTransferIDs.contains(transferID) == false {
             queuedTransferIDs.append(transferID)
         }
-        startQueueWorkerIfNeeded()
+        scheduleQueuedTransfers()
     }
 
     func cancelTransfer(_ transferID: UUID) {
@@ -163,9 +344,8 @@ final class TransferManager: ObservableObject {
         }
 
         // Cancel in-flight network I/O if this transfer is currently running.
-        if activeTransferID == transferID {
-            activeTransferTask?.cancel()
-        }
+        activeTransferTasks[transferID]?.cancel()
+        inBandCancelHandlers[transferID]?()
     }
 
     func clearFinishedTransfers() {
@@ -179,127 +359,259 @@ final class TransferManager: ObservableObject {
     }
 
     private func enqueueTransfer(_ transfer: Transfer) {
-        transfers.insert(transfer, at: 0)
-        queuedTransferIDs.append(transfer.id)
-        startQueueWorkerIfNeeded()
+        enqueueTransfers([transfer])
     }
 
-    private func startQueueWorkerIfNeeded() {
-        guard workerTask == nil else { return }
+    /// Queues a batch with a single scheduling pass.
+    private func enqueueTransfers(_ batch: [Transfer]) {
+        guard !batch.isEmpty else { return }
+        transfers.insert(contentsOf: batch.reversed(), at: 0)
+        queuedTransferIDs.append(contentsOf: batch.map(\.id))
+        scheduleQueuedTransfers()
+    }
 
-        workerTask = Task { @MainActor [weak self] in
-            guard let self else { return }
-            await self.processQueue()
-            self.workerTask = nil
+    /// Starts as many queued transfers as the scheduler's limits allow. Called on
+    /// enqueue, resume, limit changes, and whenever a running transfer finishes.
+    private func scheduleQueuedTransfers() {
+        guard sessionManager != nil else { return }
 
-            if self.queuedTransferIDs.contains(where: { self.pausedTransferIDs.contains($0) == false }) {
-                self.startQueueWorkerIfNeeded()
+        // Drop entries that were cancelled or removed while waiting.
+        queuedTransferIDs.removeAll { transferID in
+            guard let index = transfers.firstIndex(where: { $0.id == transferID }) else { return true }
+            if cancelRequestedIDs.contains(transferID) {
+                transfers[index].state = .cancelled
+                transfers[index].updatedAt = .now
+                return true
             }
+            return false
+        }
+
+        let candidates: [TransferScheduler.Candidate] = queuedTransferIDs.compactMap { transferID in
+            guard pausedTransferIDs.contains(transferID) == false,
+                  let transfer = transfers.first(where: { $0.id == transferID }) else { return nil }
+            return TransferScheduler.Candidate(
+                id: transfer.id,
+                sessionID: transfer.sessionID,
+                totalBytes: transfer.totalBytes
+            )
+        }
+
+        var runningBySession: [UUID: Int] = [:]
+        for sessionID in runningTransferSessions.values {
+            runningBySession[sessionID, default: 0] += 1
+        }
+
+        for candidate in scheduler.nextTransfers(queued: candidates, runningBySession: runningBySession) {
+            queuedTransferIDs.removeAll { $0 == candidate.id }
+            startTransfer(candidate.id)
         }
     }
 
-    private func processQueue() async {
-        guard let sessionManager else {
+    private func startTransfer(_ transferID: UUID) {
+        guard let sessionManager,
+              let index = transfers.firstIndex(where: { $0.id == transferID }) else {
             return
         }
 
-        while let nextTransferID = queuedTransferIDs.first(where: { pausedTransferIDs.contains($0) == false }) {
-            queuedTransferIDs.removeAll { $0 == nextTransferID }
+        transfers[index].state = .running
+        transfers[index].updatedAt = .now
 
-            guard let index = transfers.firstIndex(where: { $0.id == nextTransferID }) else {
-                continue
-            }
+        let transfer = transfers[index]
+        // Called per chunk off the main actor; the sampler picks values up.
+        let meter = TransferProgressMeter(initialTotal: transfer.totalBytes)
+        progressMeters[transferID] = meter
+        liveProgressByTransferID[transferID] = TransferLiveProgress(
+            bytesTransferred: transfer.bytesTransferred,
+            totalBytes: transfer.totalBytes
+        )
+        startProgressSamplerIfNeeded()
+        let progressHandler: @Sendable (Int64, Int64) -> Void = { bytes, total in
+            meter.record(bytesTransferred: bytes, totalBytes: total)
+        }
 
-            if cancelRequestedIDs.contains(nextTransferID) {
-                transfers[index].state = .cancelled
-                transfers[index].updatedAt = .now
-                continue
+        let transferTask: Task<SFTPTransferResult, Error>
+        switch transfer.direction {
+        case .download:
+            transferTask = Task<SFTPTransferResult, Error> {
+                try await sessionManager.downloadFile(
+                    sessionID: transfer.sessionID,
+                    remotePath: transfer.sourcePath,
+                    localPath: transfer.destinationPath,
+                    progressHandler: progressHandler
+                )
             }
+        case .upload:
+            transferTask = Task<SFTPTransferResult, Error> {
+                try await sessionManager.uploadFile(
+                    sessionID: transfer.sessionID,
+                    localPath: transfer.sourcePath,
+                    remotePath: transfer.destinationPath,
+                    progressHandler: progressHandler
+                )
+            }
+        }
 
-            transfers[index].state = .running
-            transfers[index].updatedAt = .now
+        runningTransferSessions[transferID] = transfer.sessionID
+        activeTransferTasks[transferID] = transferTask
 
-            let transfer = transfers[index]
-            activeTransferID = transfer.id
-            do {
-                let transferID = transfer.id
-                let progressHandler: @Sendable (Int64, Int64) -> Void = { [weak self] bytes, total in
-                    Task { @MainActor [weak self] in
-                        guard let self,
-                              let idx = self.transfers.firstIndex(where: { $0.id == transferID }) else { return }
-                        self.transfers[idx].bytesTransferred = bytes
-                        if total > 0 {
-                            self.transfers[idx].totalBytes = total
-                        }
-                        self.transfers[idx].updatedAt = .now
-                    }
-                }
-                let transferTask: Task<SFTPTransferResult, Error>
-                switch transfer.direction {
-                case .download:
-                    transferTask = Task<SFTPTransferResult, Error> {
-                        try await sessionManager.downloadFile(
-                            sessionID: transfer.sessionID,
-                            remotePath: transfer.sourcePath,
-                            localPath: transfer.destinationPath,
-                            progressHandler: progressHandler
-                        )
-                    }
-                case .upload:
-                    transferTask = Task<SFTPTransferResult, Error> {
-                        try await sessionManager.uploadFile(
-                            sessionID: transfer.sessionID,
-                            localPath: transfer.sourcePath,
-                            remotePath: transfer.destinationPath,
-                            progressHandler: progressHandler
-                        )
-                    }
-                }
-                activeTransferTask = transferTask
-                let result = try await transferTask.value
-                activeTransferTask = nil
-                activeTransferID = nil
+        Task { @MainActor [weak self] in
+            let result = await transferTask.result
+            guard let self else { return }
+            self.runningTransferSessions.removeValue(forKey: transferID)
+            self.activeTransferTasks.removeValue(forKey: transferID)
+            self.endProgressTracking(transferID)
+            await self.finishTransfer(transfer, result: result)
+            self.scheduleQueuedTransfers()
+        }
+    }
 
-                guard let updatedIndex = transfers.firstIndex(where: { $0.id == transfer.id }) else {
-                    continue
-                }
+    // MARK: - In-Band Transfers
+
+    /// Adds a row for a ZMODEM file sent through a session's terminal. It
+    /// bypasses the queue, since the remote `sz` or `rz` decides when it
+    /// runs, and reports progress through `item.meter` like SFTP transfers.
+    func beginInBandTransfer(_ item: InBandTransferItem, sessionID: UUID, cancel: @escaping () -> Void) {
+        let transfer = Transfer(
+            id: item.id,
+            sessionID: sessionID,
+            sourcePath: item.sourcePath,
+            destinationPath: item.destinationPath,
+            direction: item.direction,
+            bytesTransferred: 0,
+            totalBytes: item.totalBytes,
+            state: .running,
+            createdAt: .now,
+            updatedAt: .now
+        )
+        transfers.insert(transfer, at: 0)
+        inBandCancelHandlers[item.id] = cancel
+        progressMeters[item.id] = item.meter
+        liveProgressByTransferID[item.id] = TransferLiveProgress(bytesTransferred: 0, totalBytes: item.totalBytes)
+        startProgressSamplerIfNeeded()
+    }
 
-                if cancelRequestedIDs.contains(transfer.id) {
-                    transfers[updatedIndex].state = .cancelled
-                    transfers[updatedIndex].updatedAt = .now
-                    continue
-                }
+    func finishInBandTransfer(_ transferID: UUID, bytesTransferred: Int64, failure: String?) {
+        inBandCancelHandlers.removeValue(forKey: transferID)
+        endProgressTracking(transferID)
+        guard let index = transfers.firstIndex(where: { $0.id == transferID }) else { return }
+        transfers[index].bytesTransferred = bytesTransferred
+        if cancelRequestedIDs.contains(transferID) {
+            transfers[index].state = .cancelled
+        } else if let failure {
+            transfers[index].state = .failed
+            errorMessage = "Transfer failed (\(URL(fileURLWithPath: transfers[index].sourcePath).lastPathComponent)): \(failure)"
+        } else {
+            transfers[index].totalBytes = max(transfers[index].totalBytes, bytesTransferred)
+            transfers[index].state = .completed
+        }
+        transfers[index].updatedAt = .now
+    }
 
-                transfers[updatedIndex].bytesTransferred = result.bytesTransferred
-                transfers[updatedIndex].totalBytes = max(result.totalBytes, result.bytesTransferred)
-                transfers[updatedIndex].state = .completed
-                transfers[updatedIndex].updatedAt = .now
+    // MARK: - Progress Sampling
 
-                if transfer.direction == .upload,
-                   transfer.sessionID == activeSessionID,
-                   normalizeRemotePath(transfer.destinationPath).hasPrefix(normalizeRemotePath(currentRemotePath)) {
-                    await refreshDirectory(path: currentRemotePath)
-                }
-            } catch {
-                activeTransferTask = nil
-                activeTransferID = nil
+    /// Progress of a running transfer, sampled at `progressSampleInterval`;
+    /// nil once it has finished and `transfers` holds the final values.
+    func liveProgress(for transferID: UUID) -> TransferLiveProgress? {
+        liveProgressByTransferID[transferID]
+    }
 
-                guard let updatedIndex = transfers.firstIndex(where: { $0.id == transfer.id }) else {
-                    continue
-                }
+    private func startProgressSamplerIfNeeded() {
+        guard progressSamplerTask == nil else { return }
+        progressSamplerTask = Task { @MainActor [weak self] in
+            while !Task.isCancelled {
+                try? await Task.sleep(for: Self.progressSampleInterval)
+                guard let self, !self.progressMeters.isEmpty else { break }
+                self.sampleProgress()
+            }
+            self?.progressSamplerTask = nil
+        }
+    }
 
-                if cancelRequestedIDs.contains(transfer.id) {
-                    transfers[updatedIndex].state = .cancelled
-                } else {
-                    transfers[updatedIndex].state = .failed
-                    errorMessage = "Transfer failed (\(URL(fileURLWithPath: transfer.sourcePath).lastPathComponent)): \(error.localizedDescription)"
-                }
+    private func sampleProgress() {
+        let now = ProcessInfo.processInfo.systemUptime
+        for (transferID, meter) in progressMeters {
+            liveProgressByTransferID[transferID]?.apply(
+                bytesTransferred: meter.bytesTransferred,
+                totalBytes: meter.totalBytes,
+                at: now
+            )
+        }
+    }
+
+    /// Copies the last sample into `transfers` (what failed and cancelled
+    /// rows keep showing) and stops tracking the transfer.
+    private func endProgressTracking(_ transferID: UUID) {
+        guard let meter = progressMeters.removeValue(forKey: transferID) else { return }
+        liveProgressByTransferID.removeValue(forKey: transferID)
+        guard let index = transfers.firstIndex(where: { $0.id == transferID }) else { return }
+        transfers[index].bytesTransferred = meter.bytesTransferred
+        if meter.totalBytes > 0 {
+            transfers[index].totalBytes = meter.totalBytes
+        }
+    }
+
+    private func finishTransfer(_ transfer: Transfer, result: Result<SFTPTransferResult, Error>) async {
+        guard let updatedIndex = transfers.firstIndex(where: { $0.id == transfer.id }) else {
+            return
+        }
+
+        switch result {
+        case .success(let result):
+            if cancelRequestedIDs.contains(transfer.id) {
+                transfers[updatedIndex].state = .cancelled
                 transfers[updatedIndex].updatedAt = .now
+                return
+            }
+
+            transfers[updatedIndex].bytesTransferred = result.bytesTransferred
+            transfers[updatedIndex].totalBytes = max(result.totalBytes, result.bytesTransferred)
+            transfers[updatedIndex].state = .completed
+            transfers[updatedIndex].updatedAt = .now
+
+            if let modifiedAt = transfer.sourceModifiedAt {
+                await preserveModificationTime(modifiedAt, for: transfer)
+            }
+
+            // A folder upload finishes many files; refresh once its last one lands.
+            if transfer.direction == .upload,
+               transfer.sessionID == activeSessionID,
+               hasPendingUploads(sessionID: transfer.sessionID) == false,
+               normalizeRemotePath(transfer.destinationPath).hasPrefix(normalizeRemotePath(currentRemotePath)) {
+                await refreshDirectory(path: currentRemotePath)
+            }
+        case .failure(let error):
+            if cancelRequestedIDs.contains(transfer.id) {
+                transfers[updatedIndex].state = .cancelled
+            } else {
+                transfers[updatedIndex].state = .failed
+                errorMessage = "Transfer failed (\(URL(fileURLWithPath: transfer.sourcePath).lastPathComponent)): \(error.localizedDescription)"
             }
+            transfers[updatedIndex].updatedAt = .now
+        }
+    }
+
+    private func preserveModificationTime(_ date: Date, for transfer: Transfer) async {
+        switch transfer.direction {
+        case .download:
+            try? FileManager.default.setAttributes([.modificationDate: date], ofItemAtPath: transfer.destinationPath)
+        case .upload:
+            try? await sessionManager?.setRemoteModificationTime(
+                sessionID: transfer.sessionID,
+                path: transfer.destinationPath,
+                date: date
+            )
+        }
+    }
+
+    private func hasPendingUploads(sessionID: UUID) -> Bool {
+        transfers.contains { transfer in
+            transfer.sessionID == sessionID
+                && transfer.direction == .upload
+                && (transfer.state == .queued || transfer.state == .running)
         }
     }
 
-    private static func defaultDownloadDirectory() throws -> URL {
+    nonisolated static func defaultDownloadDirectory() throws -> URL {
         let downloadsURL =
             FileManager.default.urls(for: .downloadsDirectory, in: .userDomainMask).first
             ?? FileManager.default.homeDirectoryForCurrentUser.appendingPathComponent("Downloads", isDirectory: true)
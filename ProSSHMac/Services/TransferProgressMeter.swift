@@ -0,0 +1,119 @@
+// TransferProgressMeter.swift
+// ProSSHV2
+//
+// Transfer progress without a main-actor hop per chunk. The SFTP loop
+// reports progress every 32 KB, which used to spawn one `Task { @MainActor }`
+// and one `@Published` mutation per callback: hundreds of thousands for a
+// 10 GB file. Now the callback only stores into a TransferProgressMeter
+// (two relaxed atomic stores). TransferManager samples every running
+// meter at `TransferManager.progressSampleInterval` into one
+// TransferLiveProgress per transfer. That is an `@Observable` object, so
+// only the row showing the transfer re-renders, and main-actor work stays
+// the same whatever the transfer speed or chunk size.
+//
+// Rate and time remaining come from TransferRateWindow, the byte delta
+// over the last `span` of samples. Over a window of a few seconds, the
+// bursts of pipelined reads average out.
+
+import Foundation
+import Observation
+import Synchronization
+
+/// Written from the transfer's progress callback, read by the sampler.
+nonisolated final class TransferProgressMeter: Sendable {
+
+    private let bytes = Atomic<Int64>(0)
+    private let total = Atomic<Int64>(0)
+
+    init(initialTotal: Int64 = 0) {
+        total.store(max(initialTotal, 0), ordering: .relaxed)
+    }
+
+    /// Safe from any thread. A `totalBytes` of 0 leaves the known total alone.
+    func record(bytesTransferred: Int64, totalBytes: Int64) {
+        bytes.store(bytesTransferred, ordering: .relaxed)
+        if totalBytes > 0 {
+            total.store(totalBytes, ordering: .relaxed)
+        }
+    }
+
+    var bytesTransferred: Int64 { bytes.load(ordering: .relaxed) }
+    var totalBytes: Int64 { total.load(ordering: .relaxed) }
+}
+
+/// Bytes per second over the samples of the last `span`.
+struct TransferRateWindow {
+
+    static let defaultSpan: TimeInterval = 5
+
+    let span: TimeInterval
+    private var samples: [(time: TimeInterval, bytes: Int64)] = []
+
+    init(span: TimeInterval = defaultSpan) {
+        self.span = span
+    }
+
+    mutating func add(bytes: Int64, at time: TimeInterval) {
+        if let last = samples.last, bytes < last.bytes {
+            // A restarted or resumed transfer; the old samples are meaningless.
+            samples.removeAll()
+        }
+        samples.append((time, bytes))
+        // Keep one sample at or beyond the span so the window stays full.
+        while samples.count > 2, time - samples[1].time >= span {
+            samples.removeFirst()
+        }
+    }
+
+    /// Nil until two samples at least a tenth of a second apart exist.
+    var bytesPerSecond: Double? {
+        guard let first = samples.first, let last = samples.last else { return nil }
+        let elapsed = last.time - first.time
+        guard elapsed >= 0.1 else { return nil }
+        return Double(last.bytes - first.bytes) / elapsed
+    }
+
+    /// Seconds until `totalBytes` at the current rate; nil while the rate is
+    /// unknown, zero or the total is not.
+    func secondsRemaining(totalBytes: Int64) -> Double? {
+        guard totalBytes > 0, let last = samples.last,
+              let rate = bytesPerSecond, rate > 0 else { return nil }
+        return Double(max(totalBytes - last.bytes, 0)) / rate
+    }
+}
+
+/// What a transfer row shows while the transfer runs.
+@Observable
+final class TransferLiveProgress {
+    var bytesTransferred: Int64
+    var totalBytes: Int64
+    var bytesPerSecond: Double?
+    var secondsRemaining: Double?
+
+    @ObservationIgnored var rateWindow = TransferRateWindow()
+
+    init(bytesTransferred: Int64 = 0, totalBytes: Int64 = 0) {
+        self.bytesTransferred = bytesTransferred
+        self.totalBytes = totalBytes
+    }
+
+    /// Applies one sample; properties are written only when they change so
+    /// an idle transfer does not invalidate its row.
+    func apply(bytesTransferred bytes: Int64, totalBytes total: Int64, at time: TimeInterval) {
+        rateWindow.add(bytes: bytes, at: time)
+        if bytesTransferred != bytes {
+            bytesTransferred = bytes
+        }
+        if totalBytes != total {
+            totalBytes = total
+        }
+        let rate = rateWindow.bytesPerSecond?.rounded()
+        if bytesPerSecond != rate {
+            bytesPerSecond = rate
+        }
+        let remaining = rateWindow.secondsRemaining(totalBytes: total)?.rounded(.up)
+        if secondsRemaining != remaining {
+            secondsRemaining = remaining
+        }
+    }
+}
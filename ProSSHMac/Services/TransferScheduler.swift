@@ -0,0 +1,98 @@
+import Foundation
+
+/// Decides which queued transfers start next. Pure value type so the policy is
+/// testable without a session: `TransferManager` owns the queue and the running
+/// set, and asks `nextTransfers` whenever a slot frees up.
+///
+/// - Concurrency is capped per session and globally.
+/// - Sessions are served round-robin, least-busy first, so one session's batch
+///   cannot monopolise the global slots.
+/// - Within a session, files at or below `smallFileThreshold` go first (FIFO
+///   among themselves), then the rest in FIFO order. A batch of small files
+///   spends most of its time in open/close round trips, so starting them early
+///   keeps all slots busy while large transfers stream.
+nonisolated struct TransferScheduler: Sendable {
+
+    struct Candidate: Equatable, Sendable {
+        let id: UUID
+        let sessionID: UUID
+        let totalBytes: Int64
+    }
+
+    var maxConcurrentPerSession: Int
+    var maxConcurrentTotal: Int
+    var smallFileThreshold: Int64
+
+    /// Session served most recently; the round-robin resumes after it.
+    private(set) var lastServedSessionID: UUID?
+
+    init(
+        maxConcurrentPerSession: Int = 4,
+        maxConcurrentTotal: Int = 8,
+        smallFileThreshold: Int64 = 1 << 20
+    ) {
+        self.maxConcurrentPerSession = max(1, maxConcurrentPerSession)
+        self.maxConcurrentTotal = max(1, maxConcurrentTotal)
+        self.smallFileThreshold = smallFileThreshold
+    }
+
+    /// Returns the transfers to start now, in start order. `queued` must be in
+    /// enqueue order and contain only runnable (not paused) transfers.
+    mutating func nextTransfers(
+        queued: [Candidate],
+        runningBySession: [UUID: Int]
+    ) -> [Candidate] {
+        var running = runningBySession
+        var totalRunning = running.values.reduce(0, +)
+        guard totalRunning < maxConcurrentTotal, !queued.isEmpty else { return [] }
+
+        // Per-session queues, small files first, stable within each class.
+        var sessionOrder: [UUID] = []
+        var bySession: [UUID: [Candidate]] = [:]
+        for candidate in queued {
+            if bySession[candidate.sessionID] == nil {
+                sessionOrder.append(candidate.sessionID)
+            }
+            bySession[candidate.sessionID, default: []].append(candidate)
+        }
+        for (sessionID, candidates) in bySession {
+            let small = candidates.filter { $0.totalBytes <= smallFileThreshold }
+            let large = candidates.filter { $0.totalBytes > smallFileThreshold }
+            bySession[sessionID] = small + large
+        }
+
+        // Rotate so the round-robin resumes after the last served session.
+        if let last = lastServedSessionID, let index = sessionOrder.firstIndex(of: last) {
+            let next = sessionOrder.index(after: index)
+            sessionOrder = Array(sessionOrder[next...] + sessionOrder[..<next])
+        }
+
+        var started: [Candidate] = []
+        while totalRunning < maxConcurrentTotal {
+            // Least-busy eligible session wins; ties keep round-robin order.
+            var chosen: UUID?
+            for sessionID in sessionOrder {
+                guard let pending = bySession[sessionID], !pending.isEmpty,
+                      running[sessionID, default: 0] < maxConcurrentPerSession else { continue }
+                if let current = chosen, running[current, default: 0] <= running[sessionID, default: 0] {
+                    continue
+                }
+                chosen = sessionID
+            }
+            guard let sessionID = chosen, var pending = bySession[sessionID] else { break }
+
+            let candidate = pending.removeFirst()
+            bySession[sessionID] = pending
+            running[sessionID, default: 0] += 1
+            totalRunning += 1
+            started.append(candidate)
+            lastServedSessionID = sessionID
+
+            if let index = sessionOrder.firstIndex(of: sessionID) {
+                sessionOrder.remove(at: index)
+                sessionOrder.append(sessionID)
+            }
+        }
+        return started
+    }
+}
@@ -0,0 +1,158 @@
+// WorkspaceRestoreCoordinator.swift
+// ProSSHV2
+//
+// Lazy workspace restore. The SSH tabs open when the app last went
+// inactive are saved with their screens (WorkspaceSnapshotStore). At the
+// next launch each comes back as a dormant session: a `.disconnected`
+// session with the saved session ID and no engine, channel or renderer,
+// so the persisted tab order and pane layout find it again.
+//
+// A dormant tab's pane draws the saved rows as plain text. When the pane
+// first appears it is activated: its host is connected and its saved
+// screen is fed into the new engine before the first snapshot, the way a
+// reconnect after a dropped connection does (SessionResumeCoordinator).
+// The new session then takes over the dormant session's pane and tab
+// through `SessionManager.sessionReplacements`. Every pane visible at
+// launch activates at once, each on its own task, so those connections
+// run in parallel; tabs that are never shown cost a session record and
+// their saved rows.
+
+import Foundation
+import os.log
+
+@MainActor final class WorkspaceRestoreCoordinator {
+    private static let logger = Logger(subsystem: "com.prossh", category: "WorkspaceRestore")
+
+    weak var manager: SessionManager?
+    /// Looks up a saved host, loading the host list if needed. Set by the
+    /// app once the host list exists.
+    var resolveHost: ((UUID) async -> Host?)?
+
+    /// History kept per tab. A dormant tab restores this much scrollback.
+    static let savedScrollbackLines = 1_000
+    /// Session changes are saved once they have settled for this long.
+    static let saveDelay: Duration = .seconds(2)
+
+    private let store: WorkspaceSnapshotStore?
+    private(set) var dormantTabs: [UUID: WorkspaceSnapshot.Tab] = [:]
+    private var activatingSessionIDs: Set<UUID> = []
+    private var didRestore = false
+    private var pendingSave: Task<Void, Never>?
+    /// True until the launch restore has run. The saved pane layout refers
+    /// to the dormant sessions, so it must not be pruned before then.
+    private(set) var isRestorePending: Bool
+
+    init(store: WorkspaceSnapshotStore?) {
+        self.store = store
+        self.isRestorePending = store != nil
+    }
+
+    func isDormant(_ sessionID: UUID) -> Bool {
+        dormantTabs[sessionID] != nil
+    }
+
+    func dormantTab(for sessionID: UUID) -> WorkspaceSnapshot.Tab? {
+        dormantTabs[sessionID]
+    }
+
+    // MARK: - Restore
+
+    /// Brings back the saved tabs as dormant sessions, once per launch and
+    /// only into an empty session list.
+    func restoreIfNeeded() async {
+        guard !didRestore else { return }
+        didRestore = true
+        defer { isRestorePending = false }
+        guard let manager, manager.lazyWorkspaceRestoreEnabled, let store, manager.sessions.isEmpty,
+              let snapshot = await store.load(), manager.sessions.isEmpty else { return }
+
+        let live = snapshot.tabs.filter {
+            Date.now.timeIntervalSince($0.screen.capturedAt) < SessionResumeCoordinator.maximumAge
+        }
+        for tab in live {
+            dormantTabs[tab.id] = tab
+        }
+        manager.insertDormantSessions(live.map { tab in
+            Session(
+                id: tab.id,
+                kind: .ssh(hostID: tab.hostID),
+                hostLabel: tab.hostLabel,
+                username: tab.username,
+                hostname: tab.hostname,
+                port: tab.port,
+                state: .disconnected,
+                jumpHostLabel: tab.jumpHostLabel,
+                startedAt: tab.screen.capturedAt
+            )
+        })
+        Self.logger.info("Restored \(live.count, privacy: .public) dormant tab(s)")
+    }
+
+    /// Connects a dormant tab's host and hands its pane to the new session.
+    func activate(sessionID: UUID) async {
+        guard let manager, let tab = dormantTabs[sessionID],
+              activatingSessionIDs.insert(sessionID).inserted else { return }
+        defer { activatingSessionIDs.remove(sessionID) }
+
+        guard let host = await resolveHost?(tab.hostID) else {
+            Self.logger.error("Dormant tab \(tab.hostLabel, privacy: .public) has no saved host; closing it")
+            await manager.closeSession(sessionID: sessionID)
+            return
+        }
+        var jumpHost: Host?
+        if let jumpHostID = host.jumpHost {
+            jumpHost = await resolveHost?(jumpHostID)
+        }
+        do {
+            _ = try await manager.resumeDormantSession(sessionID, host: host, jumpHost: jumpHost, screen: tab.screen)
+        } catch {
+            Self.logger.error("Dormant tab \(tab.hostLabel, privacy: .public) did not reconnect: \(error.localizedDescription, privacy: .public)")
+        }
+    }
+
+    /// Called when a session leaves the list, dormant or not.
+    func forget(sessionID: UUID) {
+        dormantTabs.removeValue(forKey: sessionID)
+    }
+
+    // MARK: - Save
+
+    func scheduleSave() {
+        guard store != nil, manager?.lazyWorkspaceRestoreEnabled == true else { return }
+        pendingSave?.cancel()
+        pendingSave = Task { @MainActor [weak self] in
+            try? await Task.sleep(for: Self.saveDelay)
+            guard !Task.isCancelled else { return }
+            await self?.saveNow()
+        }
+    }
+
+    /// Saves every connected and dormant SSH tab in session order.
+    func saveNow() async {
+        guard let store, let manager, manager.lazyWorkspaceRestoreEnabled else { return }
+        pendingSave?.cancel()
+        pendingSave = nil
+
+        var tabs: [WorkspaceSnapshot.Tab] = []
+        for session in manager.sessions {
+            guard case .ssh(let hostID) = session.kind else { continue }
+            if let dormant = dormantTabs[session.id] {
+                tabs.append(dormant)
+                continue
+            }
+            guard session.state == .connected, let engine = manager.engines[session.id] else { continue }
+            tabs.append(WorkspaceSnapshot.Tab(
+                id: session.id,
+                hostID: hostID,
+                hostLabel: session.hostLabel,
+                username: session.username,
+                hostname: session.hostname,
+                port: session.port,
+                jumpHostLabel: session.jumpHostLabel,
+                previewLines: await engine.visibleText(),
+                screen: await SessionResumeCoordinator.state(of: engine, scrollbackLines: Self.savedScrollbackLines)
+            ))
+        }
+        store.save(WorkspaceSnapshot(tabs: tabs))
+    }
+}
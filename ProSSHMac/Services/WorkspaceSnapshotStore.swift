@@ -0,0 +1,155 @@
+// WorkspaceSnapshotStore.swift
+// ProSSHV2
+//
+// The SSH tabs open at the last save, each with its screen, read at launch
+// so the workspace can come back before any of its hosts are reconnected
+// (see WorkspaceRestoreCoordinator). A tab keeps its session ID, so the
+// persisted tab order and pane layout, which refer to sessions by ID,
+// still match it.
+//
+// Layout, in Application Support/ProSSHV2/workspace.snapshot:
+//   magic "PSSHWKS1", 32-byte key salt, then the AES-GCM sealed JSON
+//
+// Screens hold whatever the sessions printed, so the file is sealed like
+// the host list cache: a fresh salt per write and a key derived from the
+// EncryptedStorage master key. Reads and writes run on one serial queue.
+// A missing or unreadable snapshot loads as nil.
+
+import CryptoKit
+import Foundation
+import os.log
+
+nonisolated struct WorkspaceSnapshot: Codable, Sendable {
+    nonisolated struct Tab: Codable, Sendable, Identifiable {
+        /// The session the tab showed when it was saved.
+        var id: UUID
+        var hostID: UUID
+        var hostLabel: String
+        var username: String
+        var hostname: String
+        var port: UInt16
+        var jumpHostLabel: String?
+        /// The visible rows as text, drawn in place of the terminal until
+        /// the tab is reconnected.
+        var previewLines: [String]
+        var screen: SessionResumeState
+    }
+
+    var tabs: [Tab]
+    var savedAt: Date = .now
+}
+
+final class WorkspaceSnapshotStore {
+
+    nonisolated private static let magic = Data("PSSHWKS1".utf8)
+    nonisolated private static let saltSize = 32
+    nonisolated private static let logger = Logger(subsystem: "com.prossh", category: "WorkspaceSnapshotStore")
+
+    private let fileURL: URL
+    private let makeKey: @Sendable (Data) throws -> SymmetricKey
+    private let queue = DispatchQueue(label: "com.prossh.workspace-snapshot", qos: .userInitiated)
+
+    init(
+        fileURL: URL,
+        makeKey: @escaping @Sendable (Data) throws -> SymmetricKey = { salt in
+            try EncryptedStorage.derivedKey(purpose: "workspace-snapshot-v1", salt: salt)
+        }
+    ) {
+        self.fileURL = fileURL
+        self.makeKey = makeKey
+    }
+
+    static func makeDefault(fileManager: FileManager = .default) -> WorkspaceSnapshotStore {
+        let base = fileManager.urls(for: .applicationSupportDirectory, in: .userDomainMask).first
+            ?? fileManager.temporaryDirectory
+        return WorkspaceSnapshotStore(
+            fileURL: base
+                .appendingPathComponent("ProSSHV2", isDirectory: true)
+                .appendingPathComponent("workspace.snapshot")
+        )
+    }
+
+    func load() async -> WorkspaceSnapshot? {
+        let fileURL = fileURL
+        let makeKey = makeKey
+        let plaintext: Data? = await withCheckedContinuation { continuation in
+            queue.async {
+                continuation.resume(returning: Self.unseal(fileURL, makeKey: makeKey))
+            }
+        }
+        guard let plaintext else { return nil }
+        return try? Self.makeDecoder().decode(WorkspaceSnapshot.self, from: plaintext)
+    }
+
+    /// Replace the snapshot. Encoding happens here; sealing and the write
+    /// run in the background.
+    func save(_ snapshot: WorkspaceSnapshot) {
+        guard let plaintext = try? Self.makeEncoder().encode(snapshot) else { return }
+        let fileURL = fileURL
+        let makeKey = makeKey
+        queue.async {
+            Self.seal(plaintext, to: fileURL, makeKey: makeKey)
+        }
+    }
+
+    func clear() {
+        let fileURL = fileURL
+        queue.async {
+            try? FileManager.default.removeItem(at: fileURL)
+        }
+    }
+
+    // MARK: - File
+
+    nonisolated private static func unseal(
+        _ url: URL,
+        makeKey: (Data) throws -> SymmetricKey
+    ) -> Data? {
+        guard let file = try? Data(contentsOf: url) else { return nil }
+        let headerSize = magic.count + saltSize
+        guard file.count > headerSize, file.prefix(magic.count) == magic else { return nil }
+        do {
+            let key = try makeKey(Data(file[magic.count..<headerSize]))
+            let box = try AES.GCM.SealedBox(combined: file.suffix(from: file.startIndex + headerSize))
+            return try AES.GCM.open(box, using: key)
+        } catch {
+            logger.error("Workspace snapshot unreadable: \(error.localizedDescription, privacy: .public)")
+            return nil
+        }
+    }
+
+    nonisolated private static func seal(
+        _ plaintext: Data,
+        to url: URL,
+        makeKey: (Data) throws -> SymmetricKey
+    ) {
+        do {
+            let salt = SymmetricKey(size: .bits256).withUnsafeBytes { Data($0) }
+            guard let sealed = try AES.GCM.seal(plaintext, using: try makeKey(salt)).combined else {
+                throw CocoaError(.fileWriteUnknown)
+            }
+            var file = magic
+            file.append(salt)
+            file.append(sealed)
+            try FileManager.default.createDirectory(
+                at: url.deletingLastPathComponent(),
+                withIntermediateDirectories: true
+            )
+            try file.write(to: url, options: .atomic)
+        } catch {
+            logger.error("Workspace snapshot not written: \(error.localizedDescription, privacy: .public)")
+        }
+    }
+
+    private static func makeEncoder() -> JSONEncoder {
+        let encoder = JSONEncoder()
+        encoder.dateEncodingStrategy = .iso8601
+        return encoder
+    }
+
+    private static func makeDecoder() -> JSONDecoder {
+        let decoder = JSONDecoder()
+        decoder.dateDecodingStrategy = .iso8601
+        return decoder
+    }
+}
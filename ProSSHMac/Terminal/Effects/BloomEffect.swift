@@ -3,7 +3,8 @@
 //
 // Bloom (text glow) effect configuration.
 // Applies a GPU bloom post-process that extracts bright terminal pixels,
-// blurs them at half resolution, and additively composites the halo back.
+// blurs them down a half-resolution mip chain, and additively composites
+// the halo back.
 
 import Foundation
 
@@ -1,24 +1,25 @@
 // CursorEffects.swift
 // ProSSHV2
 //
-// Cursor effect primitives: smooth blink, glow pulse, and lerp helpers.
+// Cursor effect primitives: blink, glow pulse, and lerp helpers.
 
 import Foundation
 
 enum CursorEffects {
 
-    /// Smooth sinusoidal blink phase in [0, 1].
+    /// Blink phase, 1 for the first half period of each cycle and 0 for
+    /// the second. `time` is shared media time, so every pane agrees on the
+    /// phase and it only changes at half-period edges (see CursorBlinkClock).
     static func blinkPhase(
-        time: Float,
-        halfPeriod: Float,
+        time: CFTimeInterval,
+        halfPeriod: CFTimeInterval,
         visible: Bool,
         blinkEnabled: Bool
     ) -> Float {
         guard visible else { return 0 }
         guard blinkEnabled else { return 1 }
-        let omega = Float.pi / max(0.001, halfPeriod)
-        let value = (sinf(time * omega) + 1) * 0.5
-        return min(1, max(0, value))
+        let halfPeriods = (time / max(0.001, halfPeriod)).rounded(.down)
+        return halfPeriods.truncatingRemainder(dividingBy: 2) == 0 ? 1 : 0
     }
 
     /// Glow pulse, slightly phase-shifted from blink.
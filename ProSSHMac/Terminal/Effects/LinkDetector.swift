@@ -1,12 +1,16 @@
 // LinkDetector.swift
 // ProSSHV2
 //
-// URL/path/IP detection for terminal output.
+// URL/path/IP detection for terminal output. One hand-written scan per line
+// finds all three kinds (LinkScanner), instead of three regular expressions
+// each bridging the line and scanning it in full. TerminalLinkRows caches
+// the links of each visible row by its text, so only rows that changed are
+// scanned again; the rendering coordinator runs that pass in the background.
 
 import Foundation
 import SwiftUI
 
-struct DetectedLink: Identifiable, Sendable {
+nonisolated struct DetectedLink: Identifiable, Sendable {
     enum Kind: String, Sendable {
         case url
         case filePath
@@ -31,43 +35,35 @@ struct DetectedLink: Identifiable, Sendable {
     }
 }
 
-struct LinkDetector {
-    private static let urlRegex = try! NSRegularExpression(
-        pattern: #"(?i)\b((?:https?://|www\.)[^\s<>'"`]*(?:\([^\s<>'"`]*\)[^\s<>'"`]*)*)"#
-    )
-    private static let filePathRegex = try! NSRegularExpression(
-        pattern: #"(?<!\w)(~\/[^\s:;,]+|\.\/[^\s:;,]+|\/(?:[\w\-.]+\/)+[\w\-.]+)"#
-    )
-    private static let ipv4Regex = try! NSRegularExpression(
-        pattern: #"\b(?:(?:25[0-5]|2[0-4]\d|1?\d?\d)\.){3}(?:25[0-5]|2[0-4]\d|1?\d?\d)\b"#
-    )
-
+nonisolated struct LinkDetector {
     func detectLinks(in line: String) -> [DetectedLink] {
-        guard !line.isEmpty else { return [] }
-        let fullRange = NSRange(line.startIndex..<line.endIndex, in: line)
+        // Every link needs a "." or a "/".
+        guard line.utf8.contains(where: { $0 == UInt8(ascii: ".") || $0 == UInt8(ascii: "/") }) else { return [] }
+        let units = Array(line.utf16)
         var detected: [DetectedLink] = []
 
-        collectMatches(
-            regex: Self.urlRegex,
-            kind: .url,
-            in: line,
-            fullRange: fullRange,
-            into: &detected
-        )
-        collectMatches(
-            regex: Self.filePathRegex,
-            kind: .filePath,
-            in: line,
-            fullRange: fullRange,
-            into: &detected
-        )
-        collectMatches(
-            regex: Self.ipv4Regex,
-            kind: .ipAddress,
-            in: line,
-            fullRange: fullRange,
-            into: &detected
-        )
+        // One pass recognizes all three kinds. Matches of one kind never
+        // overlap each other, as with a separate scan per kind; overlaps
+        // between kinds are resolved below.
+        var urlFrom = 0
+        var pathFrom = 0
+        var ipFrom = 0
+        for index in units.indices {
+            let unit = units[index]
+            guard LinkScanner.mayStartLink(unit), !LinkScanner.isWord(before: index, in: units) else { continue }
+            if index >= urlFrom, let end = LinkScanner.urlEnd(at: index, in: units) {
+                append(.url, units: units, range: index..<end, into: &detected)
+                urlFrom = end
+            }
+            if index >= pathFrom, let end = LinkScanner.pathEnd(at: index, in: units) {
+                append(.filePath, units: units, range: index..<end, into: &detected)
+                pathFrom = end
+            }
+            if index >= ipFrom, let end = LinkScanner.ipv4End(at: index, in: units) {
+                append(.ipAddress, units: units, range: index..<end, into: &detected)
+                ipFrom = end
+            }
+        }
 
         // Remove overlaps, preferring earlier ranges and then longer matches.
         let ordered = detected.sorted {
@@ -89,7 +85,11 @@ struct LinkDetector {
     }
 
     func attributedLine(_ line: String) -> AttributedString {
-        let links = detectLinks(in: line)
+        attributedLine(line, links: detectLinks(in: line))
+    }
+
+    /// `line` with `links`, as detected in it, underlined.
+    func attributedLine(_ line: String, links: [DetectedLink]) -> AttributedString {
         guard !links.isEmpty else {
             return AttributedString(line)
         }
@@ -107,41 +107,22 @@ struct LinkDetector {
         return attributed
     }
 
-    private func collectMatches(
-        regex: NSRegularExpression,
-        kind: DetectedLink.Kind,
-        in line: String,
-        fullRange: NSRange,
+    private func append(
+        _ kind: DetectedLink.Kind,
+        units: [UInt16],
+        range: Range<Int>,
         into results: inout [DetectedLink]
     ) {
-        let matches = regex.matches(in: line, options: [], range: fullRange)
-        for match in matches {
-            // Use the full match range to avoid capture-group index assumptions.
-            let range = match.range
-            guard range.location != NSNotFound,
-                  let textRange = Range(range, in: line) else {
-                continue
-            }
-
-            var value = String(line[textRange])
-            value = trimTrailingPunctuation(value)
-            guard !value.isEmpty else { continue }
-
-            let adjustedLength = (value as NSString).length
-            let adjustedRange = NSRange(location: range.location, length: adjustedLength)
-            guard let destination = destinationURL(kind: kind, value: value) else {
-                continue
-            }
-
-            results.append(
-                DetectedLink(
-                    kind: kind,
-                    text: value,
-                    range: adjustedRange,
-                    destinationURL: destination
-                )
+        let value = trimTrailingPunctuation(String(decoding: units[range], as: UTF16.self))
+        guard !value.isEmpty, let destination = destinationURL(kind: kind, value: value) else { return }
+        results.append(
+            DetectedLink(
+                kind: kind,
+                text: value,
+                range: NSRange(location: range.lowerBound, length: value.utf16.count),
+                destinationURL: destination
             )
-        }
+        )
     }
 
     private func trimTrailingPunctuation(_ text: String) -> String {
@@ -182,3 +163,198 @@ struct LinkDetector {
         }
     }
 }
+
+// MARK: - LinkScanner
+
+/// The recognizers behind `LinkDetector`, over a line's UTF-16 code units
+/// (the units its `NSRange`s count). Each returns the end of the longest
+/// link of its kind starting at an index, matching what these patterns
+/// would:
+///
+/// - URL: `(?i)\b(https?://|www\.)[^\s<>'"`]*`
+/// - path: `(?<!\w)(~/[^\s:;,]+|\./[^\s:;,]+|/([\w\-.]+/)+[\w\-.]+)`
+/// - IPv4: `\b(octet\.){3}octet\b`, an octet being 0-255 without a
+///   leading zero on three digits
+private nonisolated enum LinkScanner {
+    private static let slash = UInt16(ascii: "/")
+    private static let dot = UInt16(ascii: ".")
+    private static let https = Array("https://".utf16)
+    private static let http = Array("http://".utf16)
+    private static let www = Array("www.".utf16)
+
+    /// Units a link can start with: h, w, ~, ., / and digits.
+    static func mayStartLink(_ unit: UInt16) -> Bool {
+        switch unit {
+        case UInt16(ascii: "h"), UInt16(ascii: "H"), UInt16(ascii: "w"), UInt16(ascii: "W"),
+             UInt16(ascii: "~"), dot, slash, UInt16(ascii: "0")...UInt16(ascii: "9"):
+            return true
+        default:
+            return false
+        }
+    }
+
+    static func urlEnd(at start: Int, in units: [UInt16]) -> Int? {
+        guard var index = end(of: https, at: start, in: units)
+            ?? end(of: http, at: start, in: units)
+            ?? end(of: www, at: start, in: units) else { return nil }
+        while index < units.count {
+            let (scalar, width) = decode(at: index, in: units)
+            switch scalar {
+            case "<", ">", "'", "\"", "`":
+                return index
+            default:
+                if scalar.properties.isWhitespace { return index }
+            }
+            index += width
+        }
+        return index
+    }
+
+    static func pathEnd(at start: Int, in units: [UInt16]) -> Int? {
+        switch units[start] {
+        case UInt16(ascii: "~"), dot:
+            guard start + 1 < units.count, units[start + 1] == slash else { return nil }
+            var index = start + 2
+            while index < units.count {
+                let (scalar, width) = decode(at: index, in: units)
+                if scalar == ":" || scalar == ";" || scalar == "," || scalar.properties.isWhitespace { break }
+                index += width
+            }
+            return index > start + 2 ? index : nil
+
+        case slash:
+            // Two or more segments; a trailing "/" is left out.
+            var index = start + 1
+            var slashedSegments = 0
+            var lastEnd: Int?
+            while true {
+                let segmentStart = index
+                while index < units.count {
+                    let (scalar, width) = decode(at: index, in: units)
+                    guard scalar == "-" || scalar == "." || isWord(scalar) else { break }
+                    index += width
+                }
+                guard index > segmentStart else { break }
+                if slashedSegments > 0 {
+                    lastEnd = index
+                }
+                guard index < units.count, units[index] == slash else { break }
+                slashedSegments += 1
+                index += 1
+            }
+            return lastEnd
+
+        default:
+            return nil
+        }
+    }
+
+    static func ipv4End(at start: Int, in units: [UInt16]) -> Int? {
+        var index = start
+        for octet in 0..<4 {
+            let digitsStart = index
+            var value = 0
+            while index < units.count, let digit = asciiDigit(units[index]) {
+                value = value * 10 + digit
+                index += 1
+                if index - digitsStart > 3 { return nil }
+            }
+            let length = index - digitsStart
+            guard length > 0, value <= 255, length < 3 || value >= 100 else { return nil }
+            if octet < 3 {
+                guard index < units.count, units[index] == dot else { return nil }
+                index += 1
+            }
+        }
+        guard index == units.count || !isWord(decode(at: index, in: units).0) else { return nil }
+        return index
+    }
+
+    /// Whether the character before `index` is a word character (`\w`).
+    static func isWord(before index: Int, in units: [UInt16]) -> Bool {
+        guard index > 0 else { return false }
+        let last = units[index - 1]
+        if UTF16.isTrailSurrogate(last), index >= 2, UTF16.isLeadSurrogate(units[index - 2]) {
+            return isWord(decode(at: index - 2, in: units).0)
+        }
+        return isWord(Unicode.Scalar(last) ?? "\u{FFFD}")
+    }
+
+    private static func isWord(_ scalar: Unicode.Scalar) -> Bool {
+        if scalar.isASCII {
+            let value = scalar.value
+            return (0x30...0x39).contains(value) || (0x41...0x5A).contains(value)
+                || (0x61...0x7A).contains(value) || value == 0x5F
+        }
+        switch scalar.properties.generalCategory {
+        case .decimalNumber, .nonspacingMark, .spacingMark, .enclosingMark, .connectorPunctuation:
+            return true
+        default:
+            return scalar.properties.isAlphabetic || scalar == "\u{200C}" || scalar == "\u{200D}"
+        }
+    }
+
+    private static func decode(at index: Int, in units: [UInt16]) -> (Unicode.Scalar, Int) {
+        let unit = units[index]
+        if UTF16.isLeadSurrogate(unit), index + 1 < units.count, UTF16.isTrailSurrogate(units[index + 1]) {
+            let value = 0x10000 + ((UInt32(unit) - 0xD800) << 10) + (UInt32(units[index + 1]) - 0xDC00)
+            return (Unicode.Scalar(value) ?? "\u{FFFD}", 2)
+        }
+        return (Unicode.Scalar(unit) ?? "\u{FFFD}", 1)
+    }
+
+    private static func asciiDigit(_ unit: UInt16) -> Int? {
+        (UInt16(ascii: "0")...UInt16(ascii: "9")).contains(unit) ? Int(unit - UInt16(ascii: "0")) : nil
+    }
+
+    /// The index after `prefix` (lowercase ASCII) when `units` has it at
+    /// `start`, ignoring case.
+    private static func end(of prefix: [UInt16], at start: Int, in units: [UInt16]) -> Int? {
+        guard start + prefix.count <= units.count else { return nil }
+        for (offset, expected) in prefix.enumerated() {
+            var unit = units[start + offset]
+            if (UInt16(ascii: "A")...UInt16(ascii: "Z")).contains(unit) {
+                unit += 0x20
+            }
+            guard unit == expected else { return nil }
+        }
+        return start + prefix.count
+    }
+}
+
+// MARK: - TerminalLinkRows
+
+/// Links of each visible row, keyed by the row's text.
+nonisolated struct TerminalLinkRows: Sendable {
+    private var texts: [String] = []
+    private var links: [[DetectedLink]] = []
+
+    /// Detect links in rows of `lines` whose text changed since the last
+    /// update. Returns the number of rows scanned.
+    @discardableResult
+    mutating func update(lines: [String], detector: LinkDetector = LinkDetector()) -> Int {
+        if texts.count > lines.count {
+            texts.removeLast(texts.count - lines.count)
+            links.removeLast(links.count - lines.count)
+        }
+        var scanned = 0
+        for (row, line) in lines.enumerated() {
+            if row < texts.count {
+                guard texts[row] != line else { continue }
+                texts[row] = line
+                links[row] = detector.detectLinks(in: line)
+            } else {
+                texts.append(line)
+                links.append(detector.detectLinks(in: line))
+            }
+            scanned += 1
+        }
+        return scanned
+    }
+
+    /// Links in `row`, or nil when its links were detected for other text.
+    func links(forRow row: Int, text: String) -> [DetectedLink]? {
+        guard row < texts.count, texts[row] == text else { return nil }
+        return links[row]
+    }
+}
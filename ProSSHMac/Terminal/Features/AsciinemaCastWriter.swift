@@ -0,0 +1,336 @@
+// AsciinemaCastWriter.swift
+// ProSSHV2
+//
+// Writes an asciinema v2 file one event at a time. Event lines are built
+// straight into a byte buffer: the timestamp is formatted with integer
+// arithmetic and the payload goes through a byte-level JSON string
+// escaper, so no JSONSerialization or String is created per event. The
+// buffer is written once it reaches `bufferSize`, which keeps memory use
+// constant for recordings of any length.
+//
+// A UTF-8 sequence split across two chunks of one stream is carried over
+// and written with the next chunk, because players join the event strings.
+// Invalid bytes become U+FFFD, as String(decoding:as:) would do.
+//
+// With `gzip`, the file is a gzip member. It holds raw DEFLATE from the
+// Compression framework, framed by a gzip header and a CRC-32/size trailer.
+
+import Compression
+import Foundation
+
+nonisolated final class AsciinemaCastWriter {
+
+    static let bufferSize = 256 << 10
+
+    private let handle: FileHandle
+    private let deflater: GzipDeflater?
+    private var buffer: [UInt8] = []
+    /// Trailing bytes of an incomplete UTF-8 sequence, per stream.
+    private var carry: [SessionRecordingStream: [UInt8]] = [:]
+    private var lastOffsetNanoseconds: UInt64 = 0
+
+    /// Create `url` and write the cast header.
+    init(
+        url: URL,
+        columns: Int,
+        rows: Int,
+        startedAt: Date,
+        gzip: Bool = false,
+        fileManager: FileManager = .default
+    ) throws {
+        try fileManager.createDirectory(at: url.deletingLastPathComponent(), withIntermediateDirectories: true)
+        guard fileManager.createFile(atPath: url.path(percentEncoded: false), contents: nil) else {
+            throw CocoaError(.fileWriteUnknown)
+        }
+        self.handle = try FileHandle(forWritingTo: url)
+        self.deflater = gzip ? try GzipDeflater(modificationTime: startedAt) : nil
+        buffer.reserveCapacity(Self.bufferSize + 4_096)
+
+        let header: [String: Any] = [
+            "version": 2,
+            "width": max(1, columns),
+            "height": max(1, rows),
+            "timestamp": Int(startedAt.timeIntervalSince1970),
+            "env": ["TERM": "xterm-256color", "SHELL": "ssh"]
+        ]
+        buffer.append(contentsOf: try JSONSerialization.data(withJSONObject: header, options: [.sortedKeys]))
+        buffer.append(UInt8(ascii: "\n"))
+    }
+
+    deinit {
+        try? handle.close()
+    }
+
+    /// Append one `[time, code, data]` event line.
+    func append(offsetNanoseconds: UInt64, stream: SessionRecordingStream, payload: Data) throws {
+        var bytes = carry.removeValue(forKey: stream) ?? []
+        bytes.append(contentsOf: payload)
+        let complete = Self.completePrefixLength(bytes)
+        if complete < bytes.count {
+            carry[stream] = Array(bytes[complete...])
+        }
+        lastOffsetNanoseconds = offsetNanoseconds
+        guard complete > 0 else { return }
+        appendEvent(offsetNanoseconds: offsetNanoseconds, stream: stream, bytes: bytes[..<complete])
+        if buffer.count >= Self.bufferSize {
+            try writeBuffer()
+        }
+    }
+
+    /// Write what is buffered and, for gzip, the trailer. The writer must
+    /// not be used afterwards.
+    func finish() throws {
+        // A sequence still incomplete at the end is invalid; it is written
+        // as replacement characters.
+        for stream in [SessionRecordingStream.input, .output] {
+            if let bytes = carry[stream], !bytes.isEmpty {
+                appendEvent(offsetNanoseconds: lastOffsetNanoseconds, stream: stream, bytes: bytes[...])
+            }
+        }
+        carry.removeAll()
+        try writeBuffer()
+        if let deflater {
+            try handle.write(contentsOf: try deflater.finish())
+        }
+        try handle.close()
+    }
+
+    private func writeBuffer() throws {
+        guard !buffer.isEmpty else { return }
+        if let deflater {
+            try handle.write(contentsOf: try deflater.compress(buffer))
+        } else {
+            try handle.write(contentsOf: buffer)
+        }
+        buffer.removeAll(keepingCapacity: true)
+    }
+
+    private static let outputCode = Array(",\"o\",\"".utf8)
+    private static let inputCode = Array(",\"i\",\"".utf8)
+    private static let eventEnd = Array("\"]\n".utf8)
+
+    private func appendEvent(offsetNanoseconds: UInt64, stream: SessionRecordingStream, bytes: ArraySlice<UInt8>) {
+        buffer.append(UInt8(ascii: "["))
+        appendSeconds(offsetNanoseconds)
+        buffer.append(contentsOf: stream == .output ? Self.outputCode : Self.inputCode)
+        Self.appendEscaped(bytes, to: &buffer)
+        buffer.append(contentsOf: Self.eventEnd)
+    }
+
+    /// `seconds.micros`, the precision asciinema itself writes.
+    private func appendSeconds(_ nanoseconds: UInt64) {
+        appendDecimal(nanoseconds / 1_000_000_000, minimumDigits: 1)
+        buffer.append(UInt8(ascii: "."))
+        appendDecimal((nanoseconds % 1_000_000_000) / 1_000, minimumDigits: 6)
+    }
+
+    private func appendDecimal(_ value: UInt64, minimumDigits: Int) {
+        var digits: [UInt8] = []
+        var remaining = value
+        repeat {
+            digits.append(UInt8(ascii: "0") + UInt8(remaining % 10))
+            remaining /= 10
+        } while remaining > 0
+        while digits.count < minimumDigits {
+            digits.append(UInt8(ascii: "0"))
+        }
+        buffer.append(contentsOf: digits.reversed())
+    }
+
+    // MARK: - JSON escaping
+
+    private static let hexDigits = Array("0123456789abcdef".utf8)
+    private static let replacementCharacter: [UInt8] = [0xEF, 0xBF, 0xBD]
+
+    /// Append `bytes` as the inside of a JSON string. Valid UTF-8 is copied
+    /// through; quotes, backslashes and control characters are escaped.
+    static func appendEscaped(_ bytes: ArraySlice<UInt8>, to out: inout [UInt8]) {
+        var index = bytes.startIndex
+        let end = bytes.endIndex
+        while index < end {
+            let byte = bytes[index]
+            if byte >= 0x20, byte < 0x80 {
+                if byte == UInt8(ascii: "\"") || byte == UInt8(ascii: "\\") {
+                    out.append(UInt8(ascii: "\\"))
+                }
+                out.append(byte)
+                index += 1
+                continue
+            }
+            if byte < 0x20 {
+                out.append(UInt8(ascii: "\\"))
+                switch byte {
+                case 0x0A: out.append(UInt8(ascii: "n"))
+                case 0x0D: out.append(UInt8(ascii: "r"))
+                case 0x09: out.append(UInt8(ascii: "t"))
+                case 0x08: out.append(UInt8(ascii: "b"))
+                case 0x0C: out.append(UInt8(ascii: "f"))
+                default:
+                    out.append(contentsOf: [UInt8(ascii: "u"), UInt8(ascii: "0"), UInt8(ascii: "0")])
+                    out.append(hexDigits[Int(byte >> 4)])
+                    out.append(hexDigits[Int(byte & 0x0F)])
+                }
+                index += 1
+                continue
+            }
+            let length = validSequenceLength(bytes, at: index)
+            if length > 0 {
+                out.append(contentsOf: bytes[index..<(index + length)])
+                index += length
+            } else {
+                out.append(contentsOf: replacementCharacter)
+                index += 1
+            }
+        }
+    }
+
+    /// Length of the valid multi-byte UTF-8 sequence at `index`, or 0.
+    private static func validSequenceLength(_ bytes: ArraySlice<UInt8>, at index: Int) -> Int {
+        let lead = bytes[index]
+        let length: Int
+        var low: UInt8 = 0x80
+        var high: UInt8 = 0xBF
+        switch lead {
+        case 0xC2...0xDF: length = 2
+        case 0xE0: length = 3; low = 0xA0
+        case 0xE1...0xEC, 0xEE...0xEF: length = 3
+        case 0xED: length = 3; high = 0x9F
+        case 0xF0: length = 4; low = 0x90
+        case 0xF1...0xF3: length = 4
+        case 0xF4: length = 4; high = 0x8F
+        default: return 0
+        }
+        guard index + length <= bytes.endIndex else { return 0 }
+        for offset in 1..<length {
+            let byte = bytes[index + offset]
+            let range: ClosedRange<UInt8> = offset == 1 ? low...high : 0x80...0xBF
+            guard range.contains(byte) else { return 0 }
+        }
+        return length
+    }
+
+    /// Number of leading bytes that do not end in a truncated but so far
+    /// valid UTF-8 sequence.
+    static func completePrefixLength(_ bytes: [UInt8]) -> Int {
+        // Look back at most three bytes for a lead byte.
+        var start = bytes.count - 1
+        let lowest = max(0, bytes.count - 3)
+        while start >= lowest, bytes[start] & 0xC0 == 0x80 {
+            start -= 1
+        }
+        guard start >= lowest, start >= 0 else { return bytes.count }
+        let needed: Int
+        switch bytes[start] {
+        case 0xC2...0xDF: needed = 2
+        case 0xE0...0xEF: needed = 3
+        case 0xF0...0xF4: needed = 4
+        default: return bytes.count
+        }
+        let available = bytes.count - start
+        guard available < needed else { return bytes.count }
+        // Only carry a prefix that could still become valid.
+        if available >= 2 {
+            let second = bytes[start + 1]
+            switch bytes[start] {
+            case 0xE0: if second < 0xA0 { return bytes.count }
+            case 0xED: if second > 0x9F { return bytes.count }
+            case 0xF0: if second < 0x90 { return bytes.count }
+            case 0xF4: if second > 0x8F { return bytes.count }
+            default: break
+            }
+        }
+        return start
+    }
+}
+
+// MARK: - GzipDeflater
+
+/// Raw DEFLATE from the Compression framework, framed as one gzip member.
+private nonisolated final class GzipDeflater {
+    private let stream = UnsafeMutablePointer<compression_stream>.allocate(capacity: 1)
+    private var pendingHeader: [UInt8] = []
+    private var crc = CRC32()
+    private var inputSize: UInt32 = 0
+    private var scratch = [UInt8](repeating: 0, count: 64 << 10)
+
+    init(modificationTime: Date) throws {
+        guard compression_stream_init(stream, COMPRESSION_STREAM_ENCODE, COMPRESSION_ZLIB) == COMPRESSION_STATUS_OK else {
+            stream.deallocate()
+            throw CocoaError(.fileWriteUnknown)
+        }
+        let mtime = UInt32(clamping: Int(modificationTime.timeIntervalSince1970))
+        // ID1 ID2, CM = deflate, no flags, MTIME, XFL, OS = unknown.
+        pendingHeader = [0x1F, 0x8B, 0x08, 0x00]
+            + withUnsafeBytes(of: mtime.littleEndian, Array.init)
+            + [0x00, 0xFF]
+    }
+
+    deinit {
+        compression_stream_destroy(stream)
+        stream.deallocate()
+    }
+
+    func compress(_ bytes: [UInt8]) throws -> Data {
+        crc.update(bytes)
+        inputSize &+= UInt32(truncatingIfNeeded: bytes.count)
+        return try process(bytes, flags: 0)
+    }
+
+    /// The remaining DEFLATE output and the gzip trailer.
+    func finish() throws -> Data {
+        var out = try process([], flags: Int32(COMPRESSION_STREAM_FINALIZE.rawValue))
+        out.append(contentsOf: withUnsafeBytes(of: crc.value.littleEndian, Array.init))
+        out.append(contentsOf: withUnsafeBytes(of: inputSize.littleEndian, Array.init))
+        return out
+    }
+
+    private func process(_ bytes: [UInt8], flags: Int32) throws -> Data {
+        var out = Data(pendingHeader)
+        pendingHeader = []
+        // src_ptr must be a valid pointer even when there is no input.
+        let input = bytes.isEmpty ? [0] : bytes
+        try input.withUnsafeBufferPointer { source in
+            stream.pointee.src_ptr = source.baseAddress!
+            stream.pointee.src_size = bytes.count
+            while true {
+                let status: compression_status = scratch.withUnsafeMutableBufferPointer { destination in
+                    stream.pointee.dst_ptr = destination.baseAddress!
+                    stream.pointee.dst_size = destination.count
+                    return compression_stream_process(stream, flags)
+                }
+                out.append(contentsOf: scratch[0..<(scratch.count - stream.pointee.dst_size)])
+                switch status {
+                case COMPRESSION_STATUS_OK:
+                    if stream.pointee.src_size == 0, stream.pointee.dst_size > 0, flags == 0 { return }
+                case COMPRESSION_STATUS_END:
+                    return
+                default:
+                    throw CocoaError(.fileWriteUnknown)
+                }
+            }
+        }
+        return out
+    }
+}
+
+/// CRC-32 (IEEE 802.3), as the gzip trailer requires.
+private nonisolated struct CRC32 {
+    private static let table: [UInt32] = (0..<256).map { index -> UInt32 in
+        var value = UInt32(index)
+        for _ in 0..<8 {
+            value = value & 1 == 1 ? 0xEDB8_8320 ^ (value >> 1) : value >> 1
+        }
+        return value
+    }
+
+    private var state: UInt32 = 0xFFFF_FFFF
+
+    var value: UInt32 { state ^ 0xFFFF_FFFF }
+
+    mutating func update(_ bytes: [UInt8]) {
+        let table = Self.table
+        for byte in bytes {
+            state = table[Int((state ^ UInt32(byte)) & 0xFF)] ^ (state >> 8)
+        }
+    }
+}
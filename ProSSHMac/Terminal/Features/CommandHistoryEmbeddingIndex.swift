@@ -0,0 +1,185 @@
+// CommandHistoryEmbeddingIndex.swift
+// ProSSHV2
+//
+// Vectors for one session's command blocks, so the AI assistant can find
+// them by meaning. The trigram index (CommandHistorySearchIndex) only finds
+// literal text. "The error from that deploy two hours ago" never matches
+// the `kubectl rollout` block that failed. With vectors, the assistant
+// gets the few relevant past commands with a prompt, not screens of
+// scrollback.
+//
+// TerminalHistoryIndex embeds each block once, when it finalizes it. The
+// text embedded is compact: the command, how it exited, and the first and
+// last lines of its output. Vectors are unit length, so relevance is a dot
+// product. Positions follow the block serials of the trigram index, and
+// eviction drops the oldest in step with it. AI tool commands get no vector,
+// since their completion markers would only add noise.
+//
+// HistoryTextEmbedder uses the on-device NaturalLanguage sentence embedding.
+// When that model is not available, it hashes words into a fixed-size
+// vector, which still ranks blocks by shared vocabulary.
+
+import Foundation
+import NaturalLanguage
+
+// MARK: - HistoryTextEmbedder
+
+/// Text to unit-length vectors. NLEmbedding is not safe to share between
+/// threads; each TerminalHistoryIndex owns one embedder and calls it from
+/// its actor only.
+nonisolated final class HistoryTextEmbedder: @unchecked Sendable {
+
+    enum Model: Sendable, Equatable {
+        /// NaturalLanguage's English sentence embedding.
+        case sentence
+        /// Hashed words, for when the sentence model is not installed.
+        case hashedWords(dimension: Int)
+    }
+
+    let model: Model
+    private var sentenceEmbedding: NLEmbedding?
+    private var loadedSentenceEmbedding = false
+
+    init(model: Model = .sentence) {
+        self.model = model
+    }
+
+    /// Smallest dot product that counts as related. Sentence vectors of
+    /// unrelated text still score around 0.2; hashed vectors only share
+    /// weight through shared words.
+    var relevanceThreshold: Float {
+        switch model {
+        case .sentence: return 0.4
+        case .hashedWords: return 0.2
+        }
+    }
+
+    /// A unit-length vector for `text`, or nil when it has no words.
+    func vector(for text: String) -> [Float]? {
+        if case .sentence = model, let embedding = loadSentenceEmbedding(),
+           let values = embedding.vector(for: text) {
+            return Self.normalized(values.map { Float($0) })
+        }
+        return Self.hashedVector(for: text, dimension: hashedDimension)
+    }
+
+    // MARK: - Private
+
+    private var hashedDimension: Int {
+        if case let .hashedWords(dimension) = model {
+            return dimension
+        }
+        return 256
+    }
+
+    /// Loads the sentence model on first use; the asset is several MB.
+    private func loadSentenceEmbedding() -> NLEmbedding? {
+        if !loadedSentenceEmbedding {
+            loadedSentenceEmbedding = true
+            sentenceEmbedding = NLEmbedding.sentenceEmbedding(for: .english)
+        }
+        return sentenceEmbedding
+    }
+
+    /// Signed feature hashing of lowercased words (FNV-1a), so `deploy`
+    /// in a prompt and in a command land in the same bucket.
+    static func hashedVector(for text: String, dimension: Int) -> [Float]? {
+        guard dimension > 0 else { return nil }
+        var values = [Float](repeating: 0, count: dimension)
+        var words = 0
+        for word in text.lowercased().split(whereSeparator: { !$0.isLetter && !$0.isNumber }) where word.count > 1 {
+            var hash: UInt64 = 0xcbf29ce484222325
+            for byte in word.utf8 {
+                hash = (hash ^ UInt64(byte)) &* 0x100000001b3
+            }
+            let bucket = Int(hash % UInt64(dimension))
+            values[bucket] += hash & (1 << 63) == 0 ? 1 : -1
+            words += 1
+        }
+        guard words > 0 else { return nil }
+        return normalized(values)
+    }
+
+    static func normalized(_ values: [Float]) -> [Float]? {
+        let length = values.reduce(0) { $0 + $1 * $1 }.squareRoot()
+        guard length > 0 else { return nil }
+        return values.map { $0 / length }
+    }
+}
+
+// MARK: - CommandHistoryEmbeddingIndex
+
+nonisolated struct CommandHistoryEmbeddingIndex: Sendable {
+
+    /// Output lines from the start and the end of a block that go into
+    /// its embedding text.
+    static let headLines = 4
+    static let tailLines = 8
+    static let maxTextCharacters = 1_500
+
+    /// Serial of the oldest block; matches CommandHistorySearchIndex.
+    private(set) var firstSerial = 0
+    /// `vectors[i]` belongs to serial `firstSerial + i`; nil for blocks
+    /// that were not embedded.
+    private var vectors: [[Float]?] = []
+
+    var estimatedByteCount: Int {
+        vectors.reduce(vectors.capacity * MemoryLayout<[Float]?>.stride) {
+            $0 + ($1?.capacity ?? 0) * MemoryLayout<Float>.stride
+        }
+    }
+
+    /// Add the vector of the newest block.
+    mutating func append(_ vector: [Float]?) {
+        vectors.append(vector)
+    }
+
+    /// Forget the oldest `count` blocks.
+    mutating func removeOldest(_ count: Int) {
+        let removed = min(max(0, count), vectors.count)
+        vectors.removeFirst(removed)
+        firstSerial += removed
+    }
+
+    /// Serials of the `limit` blocks closest to `query` that score at least
+    /// `threshold`, best first. Newer blocks win ties.
+    func nearest(to query: [Float], limit: Int, threshold: Float) -> [(serial: Int, score: Float)] {
+        var scored: [(serial: Int, score: Float)] = []
+        for (offset, vector) in vectors.enumerated() {
+            guard let vector, vector.count == query.count else { continue }
+            var score: Float = 0
+            for index in vector.indices {
+                score += vector[index] * query[index]
+            }
+            if score >= threshold {
+                scored.append((firstSerial + offset, score))
+            }
+        }
+        return Array(scored.sorted { ($0.score, $0.serial) > ($1.score, $1.serial) }.prefix(max(0, limit)))
+    }
+
+    /// The text a block is embedded as: the command, how it exited, and the
+    /// first and last lines of its output. Nil for AI tool commands.
+    static func embeddingText(for block: CommandBlock) -> String? {
+        let command = block.command.trimmingCharacters(in: .whitespacesAndNewlines)
+        guard !command.isEmpty,
+              CommandHistorySearchIndex.markers(in: command).isEmpty else { return nil }
+
+        var parts = [command]
+        switch block.exitCode {
+        case .some(0): parts.append("succeeded")
+        case let .some(code): parts.append("failed with exit status \(code)")
+        case .none: break
+        }
+        let lines = block.output
+            .split(whereSeparator: \.isNewline)
+            .map { $0.trimmingCharacters(in: .whitespaces) }
+            .filter { !$0.isEmpty }
+        if lines.count > headLines + tailLines {
+            parts += lines.prefix(headLines) + lines.suffix(tailLines)
+        } else {
+            parts += lines
+        }
+        return String(parts.joined(separator: "\n").prefix(maxTextCharacters))
+    }
+}
@@ -0,0 +1,178 @@
+// CommandHistorySearchIndex.swift
+// ProSSHV2
+//
+// Inverted index over one session's command blocks. TerminalHistoryIndex
+// used to lowercase every block's command and output on every search, and
+// the AI tool runner searches for its completion marker every 150 ms.
+//
+// Blocks are indexed once, when TerminalHistoryIndex finalizes them. Each
+// block gets a serial number, and every byte trigram of its lowercased
+// command and output gets a posting list of serials. A query of three or
+// more ASCII bytes only checks blocks in every posting list of its
+// trigrams. Matches are confirmed the old way, so results match a linear
+// scan. Shorter and non-ASCII queries still scan block by block: a
+// non-ASCII query can match text whose bytes differ under canonical
+// equivalence. Completion markers (`__PSW_…__`, `__PROSSH_AI_TOOL_EXIT_…__`)
+// also go into a dictionary, so waiting on a marker is one lookup.
+//
+// Evicted blocks leave stale serials in posting lists. These are dropped
+// in batches so that eviction stays cheap.
+
+import Foundation
+
+nonisolated struct CommandHistorySearchIndex: Sendable {
+
+    /// Evictions between posting-list compactions.
+    static let compactionInterval = 64
+
+    /// Serial of the oldest indexed block; equal to `nextSerial` when empty.
+    private(set) var firstSerial = 0
+    private(set) var nextSerial = 0
+
+    private var postings: [UInt32: [Int]] = [:]
+    private var markers: [String: Int] = [:]
+    private var evictedSinceCompaction = 0
+
+    /// Approximate bytes held by the postings and marker tables.
+    var estimatedByteCount: Int {
+        var bytes = markers.count * (MemoryLayout<String>.stride + MemoryLayout<Int>.stride)
+        for (_, serials) in postings {
+            bytes += MemoryLayout<UInt32>.stride + serials.capacity * MemoryLayout<Int>.stride
+        }
+        return bytes
+    }
+
+    // MARK: - Maintenance
+
+    /// Index `block` as the newest block.
+    mutating func append(_ block: CommandBlock) {
+        let serial = append(texts: [block.command, block.output])
+        for marker in Self.markers(in: block.command) + Self.markers(in: block.output) {
+            markers[marker] = serial
+        }
+    }
+
+    /// Index `texts` as one new entry and return its serial. Used directly
+    /// by CommandHistoryStore, which indexes commands only.
+    @discardableResult
+    mutating func append(texts: [String]) -> Int {
+        let serial = nextSerial
+        nextSerial += 1
+
+        var keys = Set<UInt32>()
+        for text in texts {
+            Self.insertTrigrams(of: text.lowercased(), into: &keys)
+        }
+        for key in keys {
+            postings[key, default: []].append(serial)
+        }
+        return serial
+    }
+
+    /// Forget the oldest `count` blocks.
+    mutating func removeOldest(_ count: Int) {
+        guard count > 0 else { return }
+        firstSerial = min(firstSerial + count, nextSerial)
+        evictedSinceCompaction += count
+        if evictedSinceCompaction >= Self.compactionInterval {
+            compact()
+        }
+    }
+
+    /// Drop serials of evicted blocks from every posting list and marker.
+    mutating func compact() {
+        let first = firstSerial
+        for (key, serials) in postings {
+            guard let oldest = serials.first, oldest < first else { continue }
+            let live = serials.drop { $0 < first }
+            if live.isEmpty {
+                postings.removeValue(forKey: key)
+            } else {
+                postings[key] = Array(live)
+            }
+        }
+        markers = markers.filter { $0.value >= first }
+        evictedSinceCompaction = 0
+    }
+
+    // MARK: - Lookup
+
+    /// Serial of the live block whose command or output contains `marker`.
+    func serial(ofMarker marker: String) -> Int? {
+        guard let serial = markers[marker], serial >= firstSerial else { return nil }
+        return serial
+    }
+
+    /// Serials of live blocks that may contain `query` (lowercased), oldest
+    /// first. Nil when the index cannot narrow the query and every block
+    /// has to be checked.
+    func candidates(forLowercased query: String) -> [Int]? {
+        let bytes = Array(query.utf8)
+        guard bytes.count >= 3, bytes.allSatisfy({ $0 < 0x80 }) else { return nil }
+
+        var lists: [[Int]] = []
+        var seen = Set<UInt32>()
+        for index in 0...(bytes.count - 3) {
+            let key = Self.key(bytes[index], bytes[index + 1], bytes[index + 2])
+            guard seen.insert(key).inserted else { continue }
+            guard let list = postings[key] else { return [] }
+            lists.append(list)
+        }
+        lists.sort { $0.count < $1.count }
+
+        var result = lists[0].filter { $0 >= firstSerial }
+        for list in lists.dropFirst() where !result.isEmpty {
+            result = Self.intersect(result, list)
+        }
+        return result
+    }
+
+    // MARK: - Trigrams
+
+    @inline(__always)
+    private static func key(_ a: UInt8, _ b: UInt8, _ c: UInt8) -> UInt32 {
+        UInt32(a) << 16 | UInt32(b) << 8 | UInt32(c)
+    }
+
+    private static func insertTrigrams(of text: String, into keys: inout Set<UInt32>) {
+        var utf8 = text.utf8.makeIterator()
+        guard var a = utf8.next(), var b = utf8.next() else { return }
+        while let c = utf8.next() {
+            keys.insert(key(a, b, c))
+            a = b
+            b = c
+        }
+    }
+
+    /// Intersection of two ascending lists.
+    private static func intersect(_ lhs: [Int], _ rhs: [Int]) -> [Int] {
+        var result: [Int] = []
+        var i = 0
+        var j = 0
+        while i < lhs.count, j < rhs.count {
+            if lhs[i] == rhs[j] {
+                result.append(lhs[i])
+                i += 1
+                j += 1
+            } else if lhs[i] < rhs[j] {
+                i += 1
+            } else {
+                j += 1
+            }
+        }
+        return result
+    }
+
+    // MARK: - Markers
+
+    private static let markerRegex = try? NSRegularExpression(pattern: "__(?:PSW|PROSSH_AI_TOOL_EXIT)_[0-9A-Fa-f]+__")
+
+    /// Completion markers written by the AI tool command wrappers.
+    static func markers(in text: String) -> [String] {
+        guard text.contains("__"), let markerRegex else { return [] }
+        let range = NSRange(text.startIndex..., in: text)
+        return markerRegex.matches(in: text, range: range).compactMap { match in
+            Range(match.range, in: text).map { String(text[$0]) }
+        }
+    }
+}
@@ -355,6 +355,14 @@ final class PaneManager: ObservableObject {
         }
     }
 
+    /// Moves every pane showing `oldID` to `newID`, the session that
+    /// replaced it on reconnect.
+    func replaceSession(_ oldID: UUID, with newID: UUID) {
+        for pane in rootNode.allPanes where pane.sessionID == oldID {
+            rootNode = rootNode.updatePane(pane.id) { $0.sessionID = newID }
+        }
+    }
+
     /// Removes panes whose sessions are no longer active.
     /// Keeps panes that have no session assigned (e.g., newly split panes awaiting assignment).
     func syncSessions(activeSessionIDs: Set<UUID>) {
@@ -0,0 +1,364 @@
+// ScrollbackSearch.swift
+// ProSSHV2
+//
+// Full-history search. TerminalSearch only scanned the `visibleText()`
+// strings of the screen, and it did so on the main actor, so it could not
+// reach scrollback without blocking the UI.
+//
+// ScrollbackSearchEngine is an actor that searches a copy of the session's
+// ScrollbackBuffer. Copies are cheap: pages are shared and immutable, and
+// only the hot tail is copied on the engine's next write. Lines are read
+// as codepoints, one page decode at a time. Matches are reported in
+// batches as the scan goes, so results stream in over long histories.
+//
+// The engine keeps its position between calls. When the query and the
+// buffer's rewrite epoch are unchanged, a call only searches the lines
+// appended since the last one and reports which old lines were evicted.
+// When a literal query refines the previous one (for example "err" ->
+// "error" while typing), only lines that matched before are rechecked.
+//
+// Lines are named by `ScrollbackBuffer.firstLineID + index`, which stays
+// the same while a line remains in the buffer. Buffers built with
+// `indexesText` let the scan skip pages whose trigram filter rules out a
+// match (see ScrollbackTrigramFilter).
+
+import Foundation
+
+// MARK: - ScrollbackSearchQuery
+
+nonisolated struct ScrollbackSearchQuery: Sendable, Equatable {
+    var text: String
+    var isRegex: Bool
+    var isCaseSensitive: Bool
+}
+
+// MARK: - ScrollbackSearchMatch
+
+/// A match in scrollback, in cells.
+nonisolated struct ScrollbackSearchMatch: Identifiable, Hashable, Sendable {
+    /// `ScrollbackBuffer.firstLineID` plus the line's index when searched.
+    let lineID: Int
+    let column: Int
+    let length: Int
+
+    var id: String { "\(lineID):\(column):\(length)" }
+}
+
+// MARK: - ScrollbackLineText
+
+/// One line's searchable scalars and the cells they came from. Reused
+/// across lines to avoid per-line allocation.
+nonisolated struct ScrollbackLineText {
+    /// Scalars in column order; blank cells read as spaces and wide-char
+    /// continuation cells are skipped.
+    private(set) var scalars: [UInt32] = []
+    /// Column of each scalar.
+    private(set) var columns: [Int32] = []
+    /// Column just past the cell of each scalar.
+    private(set) var columnEnds: [Int32] = []
+
+    /// Load `line`, lowercasing scalars when `folding`.
+    mutating func load(_ line: ScrollbackLine, folding: Bool) {
+        scalars.removeAll(keepingCapacity: true)
+        columns.removeAll(keepingCapacity: true)
+        columnEnds.removeAll(keepingCapacity: true)
+        let row = line.row
+        for col in 0..<row.count {
+            let width = row.width(at: col)
+            guard width > 0 else { continue }
+            let end = Int32(col + Int(width))
+            let codepoint = row.codepoints[col]
+            if codepoint & GraphemeSideTable.sentinel != 0 {
+                let cluster = line.graphemeOverrides?[col] ?? "\u{FFFD}"
+                for scalar in cluster.unicodeScalars {
+                    append(folding ? Self.fold(scalar.value) : scalar.value, col: col, end: end)
+                }
+            } else {
+                let value = codepoint == 0 ? 0x20 : codepoint
+                append(folding ? Self.fold(value) : value, col: col, end: end)
+            }
+        }
+    }
+
+    private mutating func append(_ scalar: UInt32, col: Int, end: Int32) {
+        scalars.append(scalar)
+        columns.append(Int32(col))
+        columnEnds.append(end)
+    }
+
+    /// Simple lowercase mapping: ASCII directly, other scalars when their
+    /// lowercase form is a single scalar.
+    @inline(__always)
+    static func fold(_ value: UInt32) -> UInt32 {
+        if value < 0x80 {
+            return (0x41...0x5A).contains(value) ? value | 0x20 : value
+        }
+        guard let scalar = Unicode.Scalar(value) else { return value }
+        let lower = scalar.properties.lowercaseMapping.unicodeScalars
+        return lower.count == 1 ? lower.first!.value : value
+    }
+
+    static func fold(_ text: String) -> [UInt32] {
+        text.unicodeScalars.map { fold($0.value) }
+    }
+
+    /// The cell range covered by scalars `range`.
+    func cells(for range: Range<Int>) -> (column: Int, length: Int) {
+        let column = Int(columns[range.lowerBound])
+        return (column, Int(columnEnds[range.upperBound - 1]) - column)
+    }
+}
+
+// MARK: - ScrollbackLineMatcher
+
+/// A compiled query.
+nonisolated struct ScrollbackLineMatcher {
+
+    enum Pattern {
+        /// Scalars to find, lowercased when the query is case-insensitive.
+        case literal([UInt32])
+        case regex(NSRegularExpression)
+    }
+
+    let query: ScrollbackSearchQuery
+    let pattern: Pattern
+    /// Trigrams a matching line must contain; see ScrollbackTrigramFilter.
+    let trigramKeys: [Int]
+
+    /// Throws when a regex query does not compile.
+    init(_ query: ScrollbackSearchQuery) throws {
+        self.query = query
+        trigramKeys = ScrollbackTrigramFilter.requiredKeys(for: query)
+        if query.isRegex {
+            let options: NSRegularExpression.Options = query.isCaseSensitive ? [] : [.caseInsensitive]
+            pattern = .regex(try NSRegularExpression(pattern: query.text, options: options))
+        } else if query.isCaseSensitive {
+            pattern = .literal(query.text.unicodeScalars.map(\.value))
+        } else {
+            pattern = .literal(ScrollbackLineText.fold(query.text))
+        }
+    }
+
+    /// Whether every line matching `self` also matched `previous`: both
+    /// literal with the same case handling, and this needle contains the
+    /// previous one.
+    func refines(_ previous: ScrollbackLineMatcher) -> Bool {
+        guard case .literal(let needle) = pattern,
+              case .literal(let old) = previous.pattern,
+              query.isCaseSensitive == previous.query.isCaseSensitive,
+              !old.isEmpty, needle.count > old.count else {
+            return false
+        }
+        return Self.firstMatch(of: old, in: needle[...]) != nil
+    }
+
+    /// Append the matches in `line` to `matches`. Non-overlapping, left to
+    /// right; empty regex matches are skipped.
+    func appendMatches(
+        in line: ScrollbackLine,
+        lineID: Int,
+        text: inout ScrollbackLineText,
+        to matches: inout [ScrollbackSearchMatch]
+    ) {
+        switch pattern {
+        case .literal(let needle):
+            guard !needle.isEmpty, line.count >= needle.count else { return }
+            text.load(line, folding: !query.isCaseSensitive)
+            var start = 0
+            while let found = Self.firstMatch(of: needle, in: text.scalars[start...]) {
+                let cells = text.cells(for: found..<(found + needle.count))
+                matches.append(ScrollbackSearchMatch(lineID: lineID, column: cells.column, length: cells.length))
+                start = found + needle.count
+            }
+        case .regex(let regex):
+            text.load(line, folding: false)
+            var string = String.UnicodeScalarView()
+            var scalarIndexByUTF16: [Int] = []
+            scalarIndexByUTF16.reserveCapacity(text.scalars.count)
+            for (index, value) in text.scalars.enumerated() {
+                let scalar = Unicode.Scalar(value) ?? "\u{FFFD}"
+                string.append(scalar)
+                for _ in 0..<scalar.utf16.count {
+                    scalarIndexByUTF16.append(index)
+                }
+            }
+            let line = String(string)
+            let range = NSRange(location: 0, length: scalarIndexByUTF16.count)
+            for result in regex.matches(in: line, options: [], range: range) where result.range.length > 0 {
+                let first = scalarIndexByUTF16[result.range.location]
+                let last = scalarIndexByUTF16[result.range.location + result.range.length - 1]
+                let cells = text.cells(for: first..<(last + 1))
+                matches.append(ScrollbackSearchMatch(lineID: lineID, column: cells.column, length: cells.length))
+            }
+        }
+    }
+
+    /// Index of the first occurrence of `needle` in `haystack`.
+    private static func firstMatch(of needle: [UInt32], in haystack: ArraySlice<UInt32>) -> Int? {
+        guard let head = needle.first, haystack.count >= needle.count else { return nil }
+        var index = haystack.startIndex
+        let last = haystack.endIndex - needle.count
+        while index <= last {
+            if haystack[index] == head {
+                var offset = 1
+                while offset < needle.count, haystack[index + offset] == needle[offset] {
+                    offset += 1
+                }
+                if offset == needle.count {
+                    return index
+                }
+            }
+            index += 1
+        }
+        return nil
+    }
+}
+
+// MARK: - ScrollbackSearchEngine
+
+actor ScrollbackSearchEngine {
+
+    /// One step of a search, in the order reported.
+    nonisolated struct Update: Sendable {
+        /// Matches reported before this update are void.
+        var reset: Bool
+        /// Matches on lines older than this were evicted.
+        var firstLineID: Int
+        /// Lines in the buffer being searched.
+        var lineCount: Int
+        /// Matches found since the previous update, oldest line first.
+        var matches: [ScrollbackSearchMatch]
+        /// Every line in the buffer has been searched.
+        var isComplete: Bool
+    }
+
+    /// Lines scanned between updates and cancellation checks.
+    static let batchLineCount = 4096
+
+    private var matcher: ScrollbackLineMatcher?
+    private var epoch: Int?
+    /// Lines with an ID below this have been searched.
+    private var nextLineID = 0
+    /// IDs of searched lines with at least one match, ascending.
+    private var matchedLineIDs: [Int] = []
+    private var text = ScrollbackLineText()
+
+    /// Search `scrollback` for `query`, passing progress to `report`.
+    ///
+    /// Repeating a query over a newer copy of the same buffer searches only
+    /// the appended lines. A cancelled call stops at a batch boundary and
+    /// the next call resumes from there. Throws when a regex query does not
+    /// compile.
+    func search(
+        _ scrollback: ScrollbackBuffer,
+        query: ScrollbackSearchQuery,
+        report: @Sendable (Update) -> Void
+    ) throws {
+        let firstLineID = scrollback.firstLineID
+        let lineCount = scrollback.count
+        guard !query.text.isEmpty else {
+            reset()
+            report(Update(reset: true, firstLineID: firstLineID, lineCount: lineCount, matches: [], isComplete: true))
+            return
+        }
+
+        var isReset = false
+        if matcher?.query != query || epoch != scrollback.rewriteEpoch {
+            let next = try ScrollbackLineMatcher(query)
+            let previous = matcher
+            let canRefine = epoch == scrollback.rewriteEpoch && previous.map(next.refines) == true
+            matcher = next
+            epoch = scrollback.rewriteEpoch
+            isReset = true
+            if canRefine {
+                dropEvicted(before: firstLineID)
+                guard refine(scrollback, with: next, report: report) else { return }
+                isReset = false
+            } else {
+                nextLineID = firstLineID
+                matchedLineIDs.removeAll()
+            }
+        }
+        guard let matcher else { return }
+
+        dropEvicted(before: firstLineID)
+        var matches: [ScrollbackSearchMatch] = []
+        var scanned = 0
+        var cancelled = false
+        scrollback.forEachLine(from: nextLineID - firstLineID, trigrams: matcher.trigramKeys) { index, line in
+            let lineID = firstLineID + index
+            let before = matches.count
+            matcher.appendMatches(in: line, lineID: lineID, text: &text, to: &matches)
+            if matches.count > before {
+                matchedLineIDs.append(lineID)
+            }
+            nextLineID = lineID + 1
+            scanned += 1
+            if scanned % Self.batchLineCount == 0 {
+                report(Update(reset: isReset, firstLineID: firstLineID, lineCount: lineCount, matches: matches, isComplete: false))
+                isReset = false
+                matches.removeAll(keepingCapacity: true)
+                if Task.isCancelled {
+                    cancelled = true
+                    return false
+                }
+            }
+            return true
+        }
+        guard !cancelled else { return }
+        // Pages skipped by the trigram filter are searched too.
+        nextLineID = firstLineID + lineCount
+        report(Update(reset: isReset, firstLineID: firstLineID, lineCount: lineCount, matches: matches, isComplete: true))
+    }
+
+    /// Recheck only `matchedLineIDs` against `next`. False if cancelled,
+    /// after which the next call starts over.
+    private func refine(
+        _ scrollback: ScrollbackBuffer,
+        with next: ScrollbackLineMatcher,
+        report: @Sendable (Update) -> Void
+    ) -> Bool {
+        let firstLineID = scrollback.firstLineID
+        let lineCount = scrollback.count
+        var kept: [Int] = []
+        var matches: [ScrollbackSearchMatch] = []
+        var isReset = true
+        for (checked, lineID) in matchedLineIDs.enumerated() {
+            guard let line = scrollback.line(at: lineID - firstLineID) else { continue }
+            let before = matches.count
+            next.appendMatches(in: line, lineID: lineID, text: &text, to: &matches)
+            if matches.count > before {
+                kept.append(lineID)
+            }
+            if (checked + 1) % Self.batchLineCount == 0 {
+                report(Update(reset: isReset, firstLineID: firstLineID, lineCount: lineCount, matches: matches, isComplete: false))
+                isReset = false
+                matches.removeAll(keepingCapacity: true)
+                if Task.isCancelled {
+                    reset()
+                    return false
+                }
+            }
+        }
+        matchedLineIDs = kept
+        report(Update(reset: isReset, firstLineID: firstLineID, lineCount: lineCount, matches: matches, isComplete: false))
+        return true
+    }
+
+    private func dropEvicted(before firstLineID: Int) {
+        if let keep = matchedLineIDs.firstIndex(where: { $0 >= firstLineID }) {
+            matchedLineIDs.removeFirst(keep)
+        } else {
+            matchedLineIDs.removeAll()
+        }
+        nextLineID = max(nextLineID, firstLineID)
+    }
+
+    /// Forget the current query; the next call searches from scratch.
+    func reset() {
+        matcher = nil
+        epoch = nil
+        nextLineID = 0
+        matchedLineIDs.removeAll()
+    }
+}
@@ -0,0 +1,410 @@
+// SessionLog.swift
+// ProSSHV2
+//
+// Continuous transcripts of every session's output, for users who need a
+// complete audit record rather than recordings they start by hand. Off by
+// default (SessionLogCoordinator.isEnabled).
+//
+// The parser reader hands each output chunk it has already copied out of
+// the shell ring to the session's SessionLogSink. The sink queues the chunk
+// with its arrival time in a bounded in-memory buffer; that is the only
+// work on the parser's side, a short uncontended lock around an array
+// append. When the buffer is full, chunks are dropped and counted, and the
+// log says how many bytes are missing at that point, so the parser never
+// waits on the disk.
+//
+// One background task drains every sink each `flushInterval`, writes the
+// chunks through SessionRecordingFileWriter, and flushes. Segments are
+// ordinary streaming recordings (see SessionRecordingFile): LZ4 event
+// frames, AES-GCM sealed, each chunk timestamped. A crash loses at most the
+// last interval. A segment is closed and a new one started every
+// `segmentBytes` of output or `segmentDuration`. The oldest segments are
+// deleted once all logs exceed `retainedBytes`.
+//
+// Layout, in Application Support/ProSSHV2/SessionLogs:
+//   <session id>/<start, ms since 1970>.psshrec
+//
+// `transcript(sessionID:from:to:)` reads the output a session logged in a
+// time range, such as a CommandHistoryStore entry's. `search` scans the
+// logs for a line of text.
+
+import CryptoKit
+import Foundation
+import os.log
+
+// MARK: - SessionLogSink
+
+/// One session's log: a bounded queue the parser reader appends to, and
+/// the segment the background writer fills from it. `append` and `finish`
+/// may be called from any thread; the segment is only used by the writer.
+nonisolated final class SessionLogSink: @unchecked Sendable {
+
+    /// Bytes queued before further chunks are dropped.
+    static let capacityBytes = 8 << 20
+
+    /// The fields a segment's header copies from the session.
+    nonisolated struct Origin: Sendable {
+        let sessionID: UUID
+        let hostLabel: String
+        let username: String
+        let hostname: String
+        let port: UInt16
+    }
+
+    nonisolated struct Chunk: Sendable {
+        let uptimeNanoseconds: UInt64
+        let data: Data
+    }
+
+    let origin: Origin
+
+    private let lock = NSLock()
+    private var queued: [Chunk] = []
+    private var queuedBytes = 0
+    private var droppedBytes = 0
+    private var isFinished = false
+
+    // Writer-side state, used only by SessionLogArchive's drain task.
+    fileprivate var writer: SessionRecordingFileWriter?
+    fileprivate var segmentStartUptime: UInt64 = 0
+    fileprivate var segmentBytes = 0
+
+    init(origin: Origin) {
+        self.origin = origin
+    }
+
+    /// Queues one output chunk. Drops it when the queue is full.
+    func append(_ data: Data) {
+        guard !data.isEmpty else { return }
+        let now = DispatchTime.now().uptimeNanoseconds
+        lock.withLock {
+            guard !isFinished else { return }
+            guard queuedBytes + data.count <= Self.capacityBytes else {
+                droppedBytes += data.count
+                return
+            }
+            queued.append(Chunk(uptimeNanoseconds: now, data: data))
+            queuedBytes += data.count
+        }
+    }
+
+    /// Stops accepting chunks; the writer closes the log after writing
+    /// what is queued.
+    func finish() {
+        lock.withLock { isFinished = true }
+    }
+
+    /// Bytes queued and not yet written.
+    var queuedByteCount: Int {
+        lock.withLock { queuedBytes }
+    }
+
+    /// The queued chunks, bytes dropped since the last take, and whether
+    /// the session has ended.
+    fileprivate func take() -> (chunks: [Chunk], droppedBytes: Int, isFinished: Bool) {
+        lock.withLock {
+            defer {
+                queued = []
+                queuedBytes = 0
+                droppedBytes = 0
+            }
+            return (queued, droppedBytes, isFinished)
+        }
+    }
+}
+
+// MARK: - SessionLogMatch
+
+/// A logged line containing searched-for text.
+nonisolated struct SessionLogMatch: Sendable, Hashable {
+    let sessionID: UUID
+    let hostLabel: String
+    /// When the chunk that ended the line arrived.
+    let date: Date
+    /// The line with escape sequences removed.
+    let line: String
+}
+
+// MARK: - SessionLogArchive
+
+/// The log directory and the task writing every open sink into it.
+nonisolated final class SessionLogArchive: @unchecked Sendable {
+
+    /// How often queued chunks are written, which bounds what a crash can
+    /// lose.
+    static let flushInterval: Duration = .milliseconds(500)
+    /// Output per segment before a new one starts.
+    static let segmentBytes = 32 << 20
+    /// Age at which a segment is closed even if it is small.
+    static let segmentDuration: UInt64 = 3_600_000_000_000
+    /// Total size of all logs before the oldest segments are deleted.
+    static let retainedBytes: Int64 = 2 << 30
+
+    private static let logger = Logger(subsystem: "com.prossh", category: "SessionLog")
+
+    let directoryURL: URL
+    private let fileManager: FileManager
+    private let makeKey: @Sendable (Data) throws -> SymmetricKey
+
+    private let lock = NSLock()
+    private var sinks: [ObjectIdentifier: SessionLogSink] = [:]
+    private var drainTask: Task<Void, Never>?
+    /// Held for a whole drain, so sinks' writer state has one user.
+    private let drainLock = NSLock()
+
+    init(
+        directoryURL: URL? = nil,
+        fileManager: FileManager = .default,
+        makeKey: @escaping @Sendable (Data) throws -> SymmetricKey = SessionRecordingFormat.key(forSalt:)
+    ) {
+        self.directoryURL = directoryURL ?? Self.defaultDirectory(fileManager: fileManager)
+        self.fileManager = fileManager
+        self.makeKey = makeKey
+    }
+
+    // MARK: - Writing
+
+    /// Opens a log for a session; its first segment is created with its
+    /// first output.
+    func open(_ origin: SessionLogSink.Origin) -> SessionLogSink {
+        let sink = SessionLogSink(origin: origin)
+        lock.withLock {
+            sinks[ObjectIdentifier(sink)] = sink
+            if drainTask == nil {
+                drainTask = Task.detached(priority: .utility) { [weak self] in
+                    while !Task.isCancelled {
+                        try? await Task.sleep(for: Self.flushInterval)
+                        guard let self, self.drainAll() else { return }
+                    }
+                }
+            }
+        }
+        return sink
+    }
+
+    /// Writes every sink's queued chunks and closes finished logs. False
+    /// once no sink is left, which ends the drain task.
+    @discardableResult
+    func drainAll() -> Bool {
+        drainLock.withLock {
+            let open = lock.withLock { Array(sinks.values) }
+            var rotated = false
+            for sink in open {
+                let (chunks, droppedBytes, isFinished) = sink.take()
+                rotated = write(chunks, droppedBytes: droppedBytes, to: sink) || rotated
+                if isFinished {
+                    sink.writer?.close(endedAt: Date())
+                    sink.writer = nil
+                    lock.withLock { sinks[ObjectIdentifier(sink)] = nil }
+                } else {
+                    sink.writer?.flush()
+                }
+            }
+            if rotated {
+                pruneToRetainedSize()
+            }
+            return lock.withLock {
+                guard sinks.isEmpty else { return true }
+                drainTask = nil
+                return false
+            }
+        }
+    }
+
+    /// Appends chunks to the sink's segment, starting a new one when it is
+    /// full or old. True if a segment was started.
+    private func write(_ chunks: [SessionLogSink.Chunk], droppedBytes: Int, to sink: SessionLogSink) -> Bool {
+        guard !chunks.isEmpty || droppedBytes > 0 else { return false }
+        let firstUptime = chunks.first?.uptimeNanoseconds ?? DispatchTime.now().uptimeNanoseconds
+        var started = false
+        if sink.writer != nil,
+           sink.segmentBytes >= Self.segmentBytes
+            || firstUptime &- sink.segmentStartUptime >= Self.segmentDuration {
+            sink.writer?.close(endedAt: Date())
+            sink.writer = nil
+        }
+        if sink.writer == nil {
+            sink.writer = startSegment(for: sink.origin, firstUptime: firstUptime)
+            sink.segmentStartUptime = firstUptime
+            sink.segmentBytes = 0
+            started = sink.writer != nil
+        }
+        guard let writer = sink.writer else { return started }
+
+        if droppedBytes > 0 {
+            Self.logger.warning("Session log fell behind; dropped \(droppedBytes) bytes")
+            writer.append(
+                offsetNanoseconds: firstUptime &- sink.segmentStartUptime,
+                stream: .output,
+                payload: Data("\r\n[ProSSH: \(droppedBytes) bytes of output missing from this log]\r\n".utf8)
+            )
+        }
+        for chunk in chunks {
+            writer.append(
+                offsetNanoseconds: chunk.uptimeNanoseconds &- sink.segmentStartUptime,
+                stream: .output,
+                payload: chunk.data
+            )
+            sink.segmentBytes += chunk.data.count
+        }
+        return started
+    }
+
+    /// A new segment whose offsets count from `firstUptime`, the arrival
+    /// of its first chunk.
+    private func startSegment(for origin: SessionLogSink.Origin, firstUptime: UInt64) -> SessionRecordingFileWriter? {
+        let waited = DispatchTime.now().uptimeNanoseconds &- firstUptime
+        let startedAt = Date().addingTimeInterval(-Double(waited) / 1_000_000_000)
+        let header = SessionRecordingHeader(
+            id: UUID(),
+            sessionID: origin.sessionID,
+            hostLabel: origin.hostLabel,
+            username: origin.username,
+            hostname: origin.hostname,
+            port: origin.port,
+            startedAt: startedAt
+        )
+        let url = directoryURL
+            .appendingPathComponent(origin.sessionID.uuidString, isDirectory: true)
+            .appendingPathComponent(String(Int64(startedAt.timeIntervalSince1970 * 1_000)))
+            .appendingPathExtension("psshrec")
+        do {
+            return try SessionRecordingFileWriter(url: url, header: header, fileManager: fileManager, makeKey: makeKey)
+        } catch {
+            Self.logger.error("Could not start session log: \(error.localizedDescription, privacy: .public)")
+            return nil
+        }
+    }
+
+    /// Deletes the oldest segments, across sessions, until the logs fit in
+    /// `retainedBytes`. Segments still being written are kept.
+    private func pruneToRetainedSize() {
+        let writing = Set(lock.withLock { sinks.values.compactMap { $0.writer?.url.standardizedFileURL } })
+        var segments: [(url: URL, start: Int64, size: Int64)] = []
+        for session in (try? fileManager.contentsOfDirectory(at: directoryURL, includingPropertiesForKeys: nil)) ?? [] {
+            for url in segmentURLs(in: session) {
+                let size = (try? url.resourceValues(forKeys: [.fileSizeKey]).fileSize).map(Int64.init) ?? 0
+                segments.append((url, Int64(url.deletingPathExtension().lastPathComponent) ?? 0, size))
+            }
+        }
+        var total = segments.reduce(0) { $0 + $1.size }
+        for segment in segments.sorted(by: { $0.start < $1.start }) where total > Self.retainedBytes {
+            guard !writing.contains(segment.url.standardizedFileURL) else { continue }
+            try? fileManager.removeItem(at: segment.url)
+            total -= segment.size
+        }
+    }
+
+    // MARK: - Reading
+
+    /// The session's segments, oldest first.
+    func segments(sessionID: UUID) -> [URL] {
+        segmentURLs(in: directoryURL.appendingPathComponent(sessionID.uuidString, isDirectory: true))
+    }
+
+    private func segmentURLs(in sessionDirectory: URL) -> [URL] {
+        ((try? fileManager.contentsOfDirectory(at: sessionDirectory, includingPropertiesForKeys: nil)) ?? [])
+            .filter { $0.pathExtension == "psshrec" }
+            .sorted { (Int64($0.deletingPathExtension().lastPathComponent) ?? 0) < (Int64($1.deletingPathExtension().lastPathComponent) ?? 0) }
+    }
+
+    /// Output the session logged between `start` and `end`, as received.
+    func transcript(sessionID: UUID, from start: Date, to end: Date) throws -> Data {
+        var output = Data()
+        let urls = segments(sessionID: sessionID)
+        for (index, url) in urls.enumerated() {
+            // A segment ends where the next one starts.
+            if index + 1 < urls.count, let nextStart = Self.startDate(of: urls[index + 1]), nextStart < start {
+                continue
+            }
+            if let segmentStart = Self.startDate(of: url), segmentStart > end { break }
+            let reader = try SessionRecordingFileReader(url: url, makeKey: makeKey)
+            while let chunk = try reader.next() {
+                let date = reader.header.startedAt.addingTimeInterval(Double(chunk.offsetNanoseconds) / 1_000_000_000)
+                if date < start { continue }
+                if date > end { break }
+                output.append(chunk.payload)
+            }
+        }
+        return output
+    }
+
+    /// Logged lines containing `text`, case-insensitively, newest segments
+    /// first. Searches every session unless `sessionID` is given.
+    func search(_ text: String, sessionID: UUID? = nil, limit: Int = 50) -> [SessionLogMatch] {
+        let needle = text.trimmingCharacters(in: .whitespacesAndNewlines)
+        guard !needle.isEmpty else { return [] }
+        let sessionDirectories = sessionID.map { [directoryURL.appendingPathComponent($0.uuidString, isDirectory: true)] }
+            ?? ((try? fileManager.contentsOfDirectory(at: directoryURL, includingPropertiesForKeys: nil)) ?? [])
+        let urls = sessionDirectories
+            .flatMap(segmentURLs(in:))
+            .sorted { (Int64($0.deletingPathExtension().lastPathComponent) ?? 0) > (Int64($1.deletingPathExtension().lastPathComponent) ?? 0) }
+
+        var matches: [SessionLogMatch] = []
+        for url in urls {
+            guard let reader = try? SessionRecordingFileReader(url: url, makeKey: makeKey) else { continue }
+            var line: [UInt8] = []
+            while let chunk = try? reader.next() {
+                for byte in chunk.payload {
+                    guard byte == 0x0A else {
+                        line.append(byte)
+                        continue
+                    }
+                    let plain = Self.plainText(line)
+                    line.removeAll(keepingCapacity: true)
+                    guard plain.range(of: needle, options: .caseInsensitive) != nil else { continue }
+                    matches.append(SessionLogMatch(
+                        sessionID: reader.header.sessionID,
+                        hostLabel: reader.header.hostLabel,
+                        date: reader.header.startedAt.addingTimeInterval(Double(chunk.offsetNanoseconds) / 1_000_000_000),
+                        line: plain
+                    ))
+                    if matches.count >= limit { return matches }
+                }
+            }
+        }
+        return matches
+    }
+
+    /// A line's text without CSI, OSC and other escape sequences or
+    /// control characters.
+    static func plainText(_ bytes: [UInt8]) -> String {
+        var text: [UInt8] = []
+        text.reserveCapacity(bytes.count)
+        var index = 0
+        while index < bytes.count {
+            let byte = bytes[index]
+            index += 1
+            if byte == 0x1B, index < bytes.count {
+                let kind = bytes[index]
+                index += 1
+                if kind == 0x5B {
+                    // CSI: parameters up to a final byte in 0x40...0x7E.
+                    while index < bytes.count, !(0x40...0x7E).contains(bytes[index]) { index += 1 }
+                    index += 1
+                } else if kind == 0x5D || kind == 0x50 || kind == 0x5F {
+                    // OSC, DCS, APC: up to BEL or ST.
+                    while index < bytes.count, bytes[index] != 0x07, bytes[index] != 0x1B { index += 1 }
+                    index += index < bytes.count && bytes[index] == 0x1B ? 2 : 1
+                }
+                continue
+            }
+            if byte < 0x20 && byte != 0x09 || byte == 0x7F { continue }
+            text.append(byte)
+        }
+        return String(decoding: text, as: UTF8.self)
+    }
+
+    private static func startDate(of segment: URL) -> Date? {
+        Int64(segment.deletingPathExtension().lastPathComponent).map {
+            Date(timeIntervalSince1970: Double($0) / 1_000)
+        }
+    }
+
+    private static func defaultDirectory(fileManager: FileManager) -> URL {
+        (fileManager.urls(for: .applicationSupportDirectory, in: .userDomainMask).first
+            ?? fileManager.temporaryDirectory)
+            .appendingPathComponent("ProSSHV2", isDirectory: true)
+            .appendingPathComponent("SessionLogs", isDirectory: true)
+    }
+}
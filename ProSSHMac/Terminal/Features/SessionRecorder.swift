@@ -3,10 +3,16 @@
 //
 // E.3 — Captures session byte streams with encrypted persistence,
 // playback scheduling, and asciinema-compatible export.
+//
+// Chunks are streamed to disk while recording (see SessionRecordingFile),
+// so memory use does not grow with the recording's length. Periodic
+// keyframes let playback start from any point without replaying the
+// output before it.
 
+import CryptoKit
 import Foundation
 
-enum SessionRecorderError: LocalizedError {
+nonisolated enum SessionRecorderError: LocalizedError {
     case alreadyRecording
     case notRecording
     case recordingNotFound
@@ -26,7 +32,7 @@ enum SessionRecorderError: LocalizedError {
     }
 }
 
-enum SessionRecordingStream: String, Codable, Sendable {
+nonisolated enum SessionRecordingStream: String, Codable, Sendable {
     case input
     case output
 
@@ -38,7 +44,7 @@ enum SessionRecordingStream: String, Codable, Sendable {
     }
 }
 
-struct SessionRecordingChunk: Codable, Hashable, Sendable {
+nonisolated struct SessionRecordingChunk: Codable, Hashable, Sendable {
     let offsetNanoseconds: UInt64
     let stream: SessionRecordingStream
     let payloadBase64: String
@@ -58,7 +64,7 @@ struct SessionRecordingChunk: Codable, Hashable, Sendable {
     }
 }
 
-struct SessionRecording: Codable, Identifiable, Hashable, Sendable {
+nonisolated struct SessionRecording: Codable, Identifiable, Hashable, Sendable {
     let id: UUID
     let sessionID: UUID
     let hostLabel: String
@@ -70,22 +76,44 @@ struct SessionRecording: Codable, Identifiable, Hashable, Sendable {
     var chunks: [SessionRecordingChunk]
 }
 
-struct SessionPlaybackStep: Sendable {
+nonisolated struct SessionPlaybackStep: Sendable {
     let stream: SessionRecordingStream
     let delayNanoseconds: UInt64
     let relativeSeconds: Double
-    let text: String
+    /// Recorded bytes, fed to the engine as they are.
+    let payload: Data
+
+    var text: String {
+        String(decoding: payload, as: UTF8.self)
+    }
+}
+
+/// Where a running playback is, for the scrubber.
+nonisolated struct SessionPlaybackProgress: Equatable, Sendable {
+    var positionSeconds: Double
+    let durationSeconds: Double
 }
 
 @MainActor
 final class SessionRecorder {
     private struct ActiveRecording {
-        var recording: SessionRecording
+        let pipeline: SessionRecordingPipeline
         let startUptimeNanoseconds: UInt64
     }
 
+    /// How often the recording coordinator writes buffered chunks, which
+    /// bounds what a crash can lose.
+    static let flushIntervalNanoseconds: UInt64 = 2_000_000_000
+    /// Playback speed that ignores recorded timing.
+    static let maxPlaybackSpeed = Double.infinity
+    /// Playback merges chunks that fall within one 120 Hz frame of
+    /// playback time, up to this many bytes per step.
+    private static let playbackBatchWindowNanoseconds: Double = 8_333_333
+    private static let playbackBatchBytes = 256 << 10
+
     private let fileManager: FileManager
     private let recordingsDirectoryURL: URL
+    private let makeKey: @Sendable (Data) throws -> SymmetricKey
     private var activeRecordingsBySessionID: [UUID: ActiveRecording] = [:]
     private var latestRecordingURLBySessionID: [UUID: URL] = [:]
 
@@ -98,15 +126,24 @@ final class SessionRecorder {
     private static let coalesceFlushThreshold = 65_536
     private static let coalesceFlushIntervalNanos: UInt64 = 100_000_000  // 100ms
 
-    init(fileManager: FileManager = .default, recordingsDirectoryURL: URL? = nil) {
+    init(
+        fileManager: FileManager = .default,
+        recordingsDirectoryURL: URL? = nil,
+        makeKey: @escaping @Sendable (Data) throws -> SymmetricKey = SessionRecordingFormat.key(forSalt:)
+    ) {
         self.fileManager = fileManager
         self.recordingsDirectoryURL = recordingsDirectoryURL ?? Self.defaultRecordingsDirectory(fileManager: fileManager)
+        self.makeKey = makeKey
     }
 
     func isRecording(sessionID: UUID) -> Bool {
         activeRecordingsBySessionID[sessionID] != nil
     }
 
+    var hasActiveRecordings: Bool {
+        !activeRecordingsBySessionID.isEmpty
+    }
+
     func hasSavedRecording(sessionID: UUID) -> Bool {
         latestRecordingURLBySessionID[sessionID] != nil
     }
@@ -115,44 +152,77 @@ final class SessionRecorder {
         latestRecordingURLBySessionID[sessionID]
     }
 
-    func startRecording(for session: Session) throws {
+    /// Start recording `session`. Keyframes are taken at `columns` by
+    /// `rows`, the terminal's current size.
+    func startRecording(for session: Session, columns: Int = 80, rows: Int = 24) throws {
         guard activeRecordingsBySessionID[session.id] == nil else {
             throw SessionRecorderError.alreadyRecording
         }
 
-        let startDate = Date()
-        let recording = SessionRecording(
+        let header = SessionRecordingHeader(
             id: UUID(),
             sessionID: session.id,
             hostLabel: session.hostLabel,
             username: session.username,
             hostname: session.hostname,
             port: session.port,
-            startedAt: startDate,
-            endedAt: startDate,
-            chunks: []
+            startedAt: Date(),
+            columns: columns,
+            rows: rows
+        )
+        let writer = try SessionRecordingFileWriter(
+            url: recordingFileURL(recordingID: header.id),
+            header: header,
+            fileManager: fileManager,
+            makeKey: makeKey
         )
         activeRecordingsBySessionID[session.id] = ActiveRecording(
-            recording: recording,
+            pipeline: SessionRecordingPipeline(writer: writer, columns: columns, rows: rows),
             startUptimeNanoseconds: DispatchTime.now().uptimeNanoseconds
         )
     }
 
     @discardableResult
-    func stopRecording(sessionID: UUID) throws -> URL {
+    func stopRecording(sessionID: UUID) async throws -> URL {
         // Flush any pending coalesced data before finalizing.
         flushPendingChunks(sessionID: sessionID)
         lastCoalesceFlush.removeValue(forKey: sessionID)
 
-        guard var active = activeRecordingsBySessionID.removeValue(forKey: sessionID) else {
+        guard let active = activeRecordingsBySessionID.removeValue(forKey: sessionID) else {
             throw SessionRecorderError.notRecording
         }
 
-        active.recording.endedAt = Date()
-        let fileURL = recordingFileURL(recordingID: active.recording.id)
-        try persistRecording(active.recording, to: fileURL)
-        latestRecordingURLBySessionID[sessionID] = fileURL
-        return fileURL
+        await active.pipeline.close(endedAt: Date())
+        latestRecordingURLBySessionID[sessionID] = active.pipeline.url
+        return active.pipeline.url
+    }
+
+    /// Write buffered chunks of every active recording to disk, including
+    /// coalesced output that has waited longer than the coalescing interval.
+    func flushActiveRecordings() {
+        let now = DispatchTime.now().uptimeNanoseconds
+        for (sessionID, active) in activeRecordingsBySessionID {
+            if pendingCoalesceData[sessionID] != nil,
+               now &- (lastCoalesceFlush[sessionID] ?? 0) >= Self.coalesceFlushIntervalNanos {
+                flushPendingChunks(sessionID: sessionID)
+            }
+            active.pipeline.flush()
+        }
+    }
+
+    /// Write every buffered chunk now, coalesced output included.
+    func flushAllRecordings() {
+        for (sessionID, active) in activeRecordingsBySessionID {
+            flushPendingChunks(sessionID: sessionID)
+            active.pipeline.flush()
+        }
+    }
+
+    /// Output held in memory for the session's recording: coalesced chunks
+    /// and chunks queued for the file writer.
+    func bufferedByteCount(sessionID: UUID) -> Int {
+        guard let active = activeRecordingsBySessionID[sessionID] else { return 0 }
+        return (pendingCoalesceData[sessionID]?.count ?? 0) + active.pipeline.queuedByteCount
     }
 
     func recordInput(sessionID: UUID, text: String) {
@@ -168,6 +238,19 @@ final class SessionRecorder {
         appendChunk(sessionID: sessionID, payload: data, stream: .output)
     }
 
+    /// Length of the latest recording, in seconds.
+    func latestRecordingDuration(sessionID: UUID) -> TimeInterval? {
+        guard let fileURL = latestRecordingURLBySessionID[sessionID] else { return nil }
+        if SessionRecordingFormat.isStreamingRecording(at: fileURL) {
+            guard let reader = try? SessionRecordingFileReader(url: fileURL, makeKey: makeKey),
+                  let duration = try? reader.durationNanoseconds() else { return nil }
+            return Double(duration) / 1_000_000_000
+        }
+        guard let recording = try? loadRecording(from: fileURL) else { return nil }
+        let last = recording.chunks.map(\.offsetNanoseconds).max() ?? 0
+        return Double(last) / 1_000_000_000
+    }
+
     func loadLatestRecording(sessionID: UUID) throws -> SessionRecording {
         guard let fileURL = latestRecordingURLBySessionID[sessionID] else {
             throw SessionRecorderError.recordingNotFound
@@ -176,6 +259,11 @@ final class SessionRecorder {
     }
 
     func loadRecording(from fileURL: URL) throws -> SessionRecording {
+        if SessionRecordingFormat.isStreamingRecording(at: fileURL) {
+            return try SessionRecordingFileReader(url: fileURL, makeKey: makeKey).readAll()
+        }
+
+        // Recordings saved before the streaming format.
         let decoder = JSONDecoder()
         decoder.dateDecodingStrategy = .iso8601
 
@@ -190,53 +278,73 @@ final class SessionRecorder {
         return recording
     }
 
+    /// Export the latest recording as asciinema v2, optionally gzipped.
+    /// Streaming recordings are read frame by frame off the main actor, so
+    /// memory use does not grow with the recording. The size defaults to
+    /// the one stored in the recording, then 80x24.
     func exportLatestRecordingAsCast(
         sessionID: UUID,
-        columns: Int = 80,
-        rows: Int = 24,
+        columns: Int? = nil,
+        rows: Int? = nil,
+        gzip: Bool = false,
         destinationURL: URL? = nil
-    ) throws -> URL {
-        let recording = try loadLatestRecording(sessionID: sessionID)
-        return try exportAsciinemaCast(
-            recording: recording,
-            columns: columns,
-            rows: rows,
-            destinationURL: destinationURL
-        )
+    ) async throws -> URL {
+        guard let fileURL = latestRecordingURLBySessionID[sessionID] else {
+            throw SessionRecorderError.recordingNotFound
+        }
+        guard SessionRecordingFormat.isStreamingRecording(at: fileURL) else {
+            return try exportAsciinemaCast(
+                recording: try loadRecording(from: fileURL),
+                columns: columns ?? 80,
+                rows: rows ?? 24,
+                gzip: gzip,
+                destinationURL: destinationURL
+            )
+        }
+
+        let makeKey = makeKey
+        let directoryURL = recordingsDirectoryURL
+        return try await Task.detached(priority: .utility) {
+            let reader = try SessionRecordingFileReader(url: fileURL, makeKey: makeKey)
+            let outputURL = destinationURL
+                ?? Self.castFileURL(recordingID: reader.header.id, in: directoryURL, gzip: gzip)
+            let writer = try AsciinemaCastWriter(
+                url: outputURL,
+                columns: columns ?? reader.header.columns ?? 80,
+                rows: rows ?? reader.header.rows ?? 24,
+                startedAt: reader.header.startedAt,
+                gzip: gzip
+            )
+            while let chunk = try reader.next() {
+                try Task.checkCancellation()
+                try writer.append(offsetNanoseconds: chunk.offsetNanoseconds, stream: chunk.stream, payload: chunk.payload)
+            }
+            try writer.finish()
+            return outputURL
+        }.value
     }
 
     func exportAsciinemaCast(
         recording: SessionRecording,
         columns: Int = 80,
         rows: Int = 24,
+        gzip: Bool = false,
         destinationURL: URL? = nil
     ) throws -> URL {
-        let outputURL = destinationURL ?? recordingsDirectoryURL
-            .appendingPathComponent(recording.id.uuidString)
-            .appendingPathExtension("cast")
-
-        var lines: [String] = []
-        let header: [String: Any] = [
-            "version": 2,
-            "width": max(1, columns),
-            "height": max(1, rows),
-            "timestamp": Int(recording.startedAt.timeIntervalSince1970),
-            "env": ["TERM": "xterm-256color", "SHELL": "ssh"]
-        ]
-        lines.append(try serializeJSONLine(header))
-
+        let outputURL = destinationURL
+            ?? Self.castFileURL(recordingID: recording.id, in: recordingsDirectoryURL, gzip: gzip)
+        let writer = try AsciinemaCastWriter(
+            url: outputURL,
+            columns: columns,
+            rows: rows,
+            startedAt: recording.startedAt,
+            gzip: gzip,
+            fileManager: fileManager
+        )
         for chunk in recording.chunks.sorted(by: { $0.offsetNanoseconds < $1.offsetNanoseconds }) {
-            let event: [Any] = [
-                Double(chunk.offsetNanoseconds) / 1_000_000_000,
-                chunk.stream.asciinemaCode,
-                chunk.text
-            ]
-            lines.append(try serializeJSONLine(event))
+            try writer.append(offsetNanoseconds: chunk.offsetNanoseconds, stream: chunk.stream, payload: chunk.payload)
         }
-
-        let output = lines.joined(separator: "\n") + "\n"
-        try fileManager.createDirectory(at: outputURL.deletingLastPathComponent(), withIntermediateDirectories: true)
-        try output.write(to: outputURL, atomically: true, encoding: .utf8)
+        try writer.finish()
         return outputURL
     }
 
@@ -251,21 +359,27 @@ final class SessionRecorder {
         steps.reserveCapacity(sorted.count)
 
         for chunk in sorted {
-            let delta = chunk.offsetNanoseconds &- previousOffset
-            let delay = UInt64(Double(delta) / speed)
-            let step = SessionPlaybackStep(
-                stream: chunk.stream,
-                delayNanoseconds: delay,
-                relativeSeconds: Double(chunk.offsetNanoseconds) / 1_000_000_000,
-                text: chunk.text
-            )
-            steps.append(step)
+            steps.append(Self.playbackStep(for: chunk, after: previousOffset, speed: speed))
             previousOffset = chunk.offsetNanoseconds
         }
 
         return steps
     }
 
+    private static func playbackStep(
+        for chunk: SessionRecordingChunk,
+        after previousOffset: UInt64,
+        speed: Double
+    ) -> SessionPlaybackStep {
+        let delta = chunk.offsetNanoseconds &- previousOffset
+        return SessionPlaybackStep(
+            stream: chunk.stream,
+            delayNanoseconds: UInt64(Double(delta) / speed),
+            relativeSeconds: Double(chunk.offsetNanoseconds) / 1_000_000_000,
+            payload: chunk.payload
+        )
+    }
+
     func play(
         recording: SessionRecording,
         speed: Double = 1.0,
@@ -274,20 +388,124 @@ final class SessionRecorder {
         let steps = try playbackSchedule(recording: recording, speed: speed)
         for step in steps {
             guard !Task.isCancelled else { break }
-            if step.delayNanoseconds > 0 {
-                try await Task.sleep(nanoseconds: step.delayNanoseconds)
-            }
-            await onStep(step)
+            try await perform(step, onStep: onStep)
         }
     }
 
+    private func perform(
+        _ step: SessionPlaybackStep,
+        onStep: @escaping @Sendable (SessionPlaybackStep) async -> Void
+    ) async throws {
+        if step.delayNanoseconds > 0 {
+            try await Task.sleep(nanoseconds: step.delayNanoseconds)
+        }
+        await onStep(step)
+    }
+
+    /// Play the latest recording from `startNanoseconds`. When starting
+    /// later than zero, the first step resets the terminal and restores the
+    /// state at that point: the nearest keyframe before it plus the output
+    /// in between, applied without delays.
     func playLatestRecording(
         sessionID: UUID,
         speed: Double = 1.0,
+        from startNanoseconds: UInt64 = 0,
         onStep: @escaping @Sendable (SessionPlaybackStep) async -> Void
     ) async throws {
-        let recording = try loadLatestRecording(sessionID: sessionID)
-        try await play(recording: recording, speed: speed, onStep: onStep)
+        guard let fileURL = latestRecordingURLBySessionID[sessionID] else {
+            throw SessionRecorderError.recordingNotFound
+        }
+        guard speed > 0 else {
+            throw SessionRecorderError.invalidPlaybackSpeed
+        }
+
+        // Streaming recordings are written in time order; play them as
+        // they are read. Older recordings have no keyframes.
+        var restore = Data()
+        let nextChunk: () throws -> SessionRecordingChunk?
+        if SessionRecordingFormat.isStreamingRecording(at: fileURL) {
+            let reader = try SessionRecordingFileReader(url: fileURL, makeKey: makeKey)
+            if startNanoseconds > 0, let keyframe = try reader.seek(toKeyframeAtOrBefore: startNanoseconds) {
+                restore = keyframe.sequence
+            }
+            nextChunk = reader.next
+        } else {
+            var chunks = try loadRecording(from: fileURL).chunks
+                .sorted(by: { $0.offsetNanoseconds < $1.offsetNanoseconds })
+                .makeIterator()
+            nextChunk = { chunks.next() }
+        }
+
+        var upcoming = try nextChunk()
+        if startNanoseconds > 0 {
+            if restore.isEmpty {
+                restore = Data("\u{1B}c".utf8)
+            }
+            while let chunk = upcoming, chunk.offsetNanoseconds < startNanoseconds {
+                if chunk.stream == .output {
+                    restore.append(chunk.payload)
+                }
+                upcoming = try nextChunk()
+            }
+            await onStep(SessionPlaybackStep(
+                stream: .output,
+                delayNanoseconds: 0,
+                relativeSeconds: Double(startNanoseconds) / 1_000_000_000,
+                payload: restore
+            ))
+        }
+
+        // Chunks of one stream that play within the same display frame are
+        // merged into one step, so fast playback feeds the engine in large
+        // batches instead of one small chunk at a time.
+        var previousOffset = startNanoseconds
+        while !Task.isCancelled, let first = upcoming {
+            var payload = first.payload
+            upcoming = try nextChunk()
+            while let chunk = upcoming,
+                  chunk.stream == first.stream,
+                  payload.count < Self.playbackBatchBytes,
+                  Double(chunk.offsetNanoseconds &- first.offsetNanoseconds) / speed < Self.playbackBatchWindowNanoseconds {
+                payload.append(chunk.payload)
+                upcoming = try nextChunk()
+            }
+            try await perform(SessionPlaybackStep(
+                stream: first.stream,
+                delayNanoseconds: UInt64(Double(first.offsetNanoseconds &- previousOffset) / speed),
+                relativeSeconds: Double(first.offsetNanoseconds) / 1_000_000_000,
+                payload: payload
+            ), onStep: onStep)
+            previousOffset = first.offsetNanoseconds
+        }
+    }
+
+    /// Replay the latest recording into a new terminal with no renderer,
+    /// for indexing or export. Timing and input are ignored.
+    func replayLatestRecording(
+        sessionID: UUID,
+        maxScrollbackLines: Int = 10_000,
+        indexesScrollback: Bool = false
+    ) async throws -> TerminalEngine {
+        guard let fileURL = latestRecordingURLBySessionID[sessionID] else {
+            throw SessionRecorderError.recordingNotFound
+        }
+        if SessionRecordingFormat.isStreamingRecording(at: fileURL) {
+            return try await SessionRecordingReplay.replay(
+                fileURL: fileURL,
+                maxScrollbackLines: maxScrollbackLines,
+                indexesScrollback: indexesScrollback,
+                makeKey: makeKey
+            )
+        }
+        let chunks = try loadRecording(from: fileURL).chunks
+            .sorted(by: { $0.offsetNanoseconds < $1.offsetNanoseconds })
+        let engine = TerminalEngine(maxScrollbackLines: maxScrollbackLines, indexesScrollback: indexesScrollback)
+        var output = Data()
+        for chunk in chunks where chunk.stream == .output {
+            output.append(chunk.payload)
+        }
+        _ = await engine.feed(output)
+        return engine
     }
 
     private func appendChunk(sessionID: UUID, payload: Data, stream: SessionRecordingStream) {
@@ -316,16 +534,10 @@ final class SessionRecorder {
     }
 
     private func commitChunk(sessionID: UUID, payload: Data, stream: SessionRecordingStream) {
-        guard var active = activeRecordingsBySessionID[sessionID] else { return }
+        guard let active = activeRecordingsBySessionID[sessionID] else { return }
 
         let offset = DispatchTime.now().uptimeNanoseconds &- active.startUptimeNanoseconds
-        let chunk = SessionRecordingChunk(
-            offsetNanoseconds: offset,
-            stream: stream,
-            payload: payload
-        )
-        active.recording.chunks.append(chunk)
-        activeRecordingsBySessionID[sessionID] = active
+        active.pipeline.append(offsetNanoseconds: offset, stream: stream, payload: payload)
     }
 
     /// Flush any pending coalesced data for a session into a single recording chunk.
@@ -338,28 +550,17 @@ final class SessionRecorder {
         commitChunk(sessionID: sessionID, payload: data, stream: .output)
     }
 
-    private func persistRecording(_ recording: SessionRecording, to fileURL: URL) throws {
-        let encoder = JSONEncoder()
-        encoder.outputFormatting = [.prettyPrinted, .sortedKeys]
-        encoder.dateEncodingStrategy = .iso8601
-
-        try EncryptedStorage.saveJSON(
-            recording,
-            to: fileURL,
-            fileManager: fileManager,
-            encoder: encoder
-        )
-    }
-
     private func recordingFileURL(recordingID: UUID) -> URL {
         recordingsDirectoryURL
             .appendingPathComponent(recordingID.uuidString)
             .appendingPathExtension("psshrec")
     }
 
-    private func serializeJSONLine(_ value: Any) throws -> String {
-        let data = try JSONSerialization.data(withJSONObject: value, options: [.sortedKeys])
-        return String(decoding: data, as: UTF8.self)
+    nonisolated private static func castFileURL(recordingID: UUID, in directoryURL: URL, gzip: Bool) -> URL {
+        let url = directoryURL
+            .appendingPathComponent(recordingID.uuidString)
+            .appendingPathExtension("cast")
+        return gzip ? url.appendingPathExtension("gz") : url
     }
 
     nonisolated private static func defaultRecordingsDirectory(fileManager: FileManager) -> URL {
@@ -0,0 +1,523 @@
+// SessionRecordingFile.swift
+// ProSSHV2
+//
+// Streaming on-disk format for session recordings. Recordings used to be
+// held in memory as one SessionRecording and sealed as a single JSON blob
+// at stop time, so an all-day capture grew without bound and took seconds
+// to serialize. Now chunks are written as they arrive, in batches.
+//
+// Layout (.psshrec):
+//   magic "PSSHREC2", 32-byte key salt, then frames of
+//   UInt32 sealed length, UInt8 kind, UInt64 offset ns (little-endian),
+//   then the AES-GCM sealed body, authenticated together with the kind and
+//   offset. Kinds and their bodies:
+//     header       JSON SessionRecordingHeader (always the first frame)
+//     events       packed events: UInt64 offset ns, UInt8 stream,
+//                  UInt32 length, payload bytes; frame offset = first event
+//     keyframe     TerminalGrid.keyframeSequence bytes: the terminal state
+//                  after every event before this frame
+//     lz4Events,   UInt32 raw size + LZ4 of an events or keyframe body
+//     lz4Keyframe
+//     trailer      Float64 end time (seconds since 1970); frame offset =
+//                  last event
+//
+// The kind and offset are readable without the key, so seeking scans frame
+// headers and decrypts only the keyframe it lands on and the frames after.
+//
+// A batch is sealed and written when it reaches `flushThreshold` bytes or
+// when the recording coordinator's timer flushes it, so a crash loses at
+// most the last tick. A recording without a trailer ends at its last
+// chunk. A torn or unreadable frame ends the recording there.
+//
+// The key is derived from the EncryptedStorage master key with the salt
+// stored in the file. Recordings saved by older builds (a PSSHENC1 JSON
+// envelope) are still read through EncryptedStorage.
+
+import Compression
+import CryptoKit
+import Foundation
+import os.log
+
+// MARK: - SessionRecordingHeader
+
+/// Recording metadata, written once at the start of the file.
+nonisolated struct SessionRecordingHeader: Codable, Sendable {
+    let id: UUID
+    let sessionID: UUID
+    let hostLabel: String
+    let username: String
+    let hostname: String
+    let port: UInt16
+    let startedAt: Date
+    /// Terminal size when recording started; absent in older recordings.
+    var columns: Int? = nil
+    var rows: Int? = nil
+}
+
+// MARK: - SessionRecordingFormat
+
+nonisolated enum SessionRecordingFormat {
+
+    nonisolated enum FrameKind: UInt8 {
+        case header = 1
+        case events = 2
+        case lz4Events = 3
+        case trailer = 4
+        case keyframe = 5
+        case lz4Keyframe = 6
+
+        /// The kind of the body once LZ4 is undone.
+        var decompressed: FrameKind {
+            switch self {
+            case .lz4Events: return .events
+            case .lz4Keyframe: return .keyframe
+            default: return self
+            }
+        }
+
+        /// The LZ4 form of this kind, if it has one.
+        var compressed: FrameKind? {
+            switch self {
+            case .events: return .lz4Events
+            case .keyframe: return .lz4Keyframe
+            default: return nil
+            }
+        }
+    }
+
+    /// A frame's cleartext header.
+    nonisolated struct FrameHeader {
+        static let size = 13
+
+        let sealedLength: Int
+        let kind: FrameKind
+        let offsetNanoseconds: UInt64
+    }
+
+    static let magic = Data("PSSHREC2".utf8)
+    static let saltSize = 32
+    static var prefixSize: Int { magic.count + saltSize }
+    /// Larger frames are treated as corrupt rather than allocated.
+    static let maxFrameSize = 64 << 20
+    /// Event batches smaller than this are not worth compressing.
+    static let compressionMinimum = 1_024
+
+    /// Whether the file at `url` uses this format.
+    static func isStreamingRecording(at url: URL) -> Bool {
+        guard let handle = try? FileHandle(forReadingFrom: url) else { return false }
+        defer { try? handle.close() }
+        return (try? handle.read(upToCount: magic.count)) == magic
+    }
+
+    static func key(forSalt salt: Data) throws -> SymmetricKey {
+        try EncryptedStorage.derivedKey(purpose: "session-recording-v2", salt: salt)
+    }
+
+    /// Append one event to a packed events body.
+    static func appendEvent(
+        offsetNanoseconds: UInt64,
+        stream: SessionRecordingStream,
+        payload: Data,
+        to body: inout Data
+    ) {
+        withUnsafeBytes(of: offsetNanoseconds.littleEndian) { body.append(contentsOf: $0) }
+        body.append(stream == .input ? 0 : 1)
+        withUnsafeBytes(of: UInt32(payload.count).littleEndian) { body.append(contentsOf: $0) }
+        body.append(payload)
+    }
+
+    /// The chunks in a packed events body.
+    static func decodeEvents(_ body: Data) throws -> [SessionRecordingChunk] {
+        let bytes = [UInt8](body)
+        var chunks: [SessionRecordingChunk] = []
+        var position = 0
+        while position < bytes.count {
+            guard position + 13 <= bytes.count else { throw CocoaError(.fileReadCorruptFile) }
+            let offset = readInteger(UInt64.self, bytes, at: position)
+            let stream: SessionRecordingStream = bytes[position + 8] == 0 ? .input : .output
+            let length = Int(readInteger(UInt32.self, bytes, at: position + 9))
+            position += 13
+            guard position + length <= bytes.count else { throw CocoaError(.fileReadCorruptFile) }
+            chunks.append(SessionRecordingChunk(
+                offsetNanoseconds: offset,
+                stream: stream,
+                payload: Data(bytes[position..<(position + length)])
+            ))
+            position += length
+        }
+        return chunks
+    }
+
+    /// A sealed frame with its header. Event and keyframe bodies are
+    /// stored as LZ4 when that is smaller.
+    static func sealedFrame(kind: FrameKind, offsetNanoseconds: UInt64 = 0, body: Data, key: SymmetricKey) throws -> Data {
+        var frameKind = kind
+        var plaintext = body
+        if let compressedKind = kind.compressed, body.count >= compressionMinimum, let compressed = lz4(body) {
+            frameKind = compressedKind
+            plaintext = Data()
+            withUnsafeBytes(of: UInt32(body.count).littleEndian) { plaintext.append(contentsOf: $0) }
+            plaintext.append(compressed)
+        }
+        let authenticated = authenticatedHeader(kind: frameKind, offsetNanoseconds: offsetNanoseconds)
+        guard let sealed = try AES.GCM.seal(plaintext, using: key, authenticating: authenticated).combined else {
+            throw EncryptedStorageError.encryptionFailed
+        }
+        var frame = Data()
+        withUnsafeBytes(of: UInt32(sealed.count).littleEndian) { frame.append(contentsOf: $0) }
+        frame.append(authenticated)
+        frame.append(sealed)
+        return frame
+    }
+
+    /// Parse a frame header, or nil if the bytes are not one.
+    static func frameHeader(_ bytes: Data) -> FrameHeader? {
+        guard bytes.count == FrameHeader.size else { return nil }
+        let raw = [UInt8](bytes)
+        let length = Int(readInteger(UInt32.self, raw, at: 0))
+        guard length <= maxFrameSize, let kind = FrameKind(rawValue: raw[4]) else { return nil }
+        return FrameHeader(sealedLength: length, kind: kind, offsetNanoseconds: readInteger(UInt64.self, raw, at: 5))
+    }
+
+    /// Open a sealed frame's body, with LZ4 undone.
+    static func openFrame(_ sealed: Data, header: FrameHeader, key: SymmetricKey) throws -> Data {
+        let plaintext = try AES.GCM.open(
+            try AES.GCM.SealedBox(combined: sealed),
+            using: key,
+            authenticating: authenticatedHeader(kind: header.kind, offsetNanoseconds: header.offsetNanoseconds)
+        )
+        guard header.kind.decompressed != header.kind else { return plaintext }
+        guard plaintext.count >= 4 else { throw CocoaError(.fileReadCorruptFile) }
+        let rawSize = Int(readInteger(UInt32.self, [UInt8](plaintext.prefix(4)), at: 0))
+        guard rawSize <= maxFrameSize,
+              let raw = unlz4(Data(plaintext.dropFirst(4)), rawSize: rawSize) else {
+            throw CocoaError(.fileReadCorruptFile)
+        }
+        return raw
+    }
+
+    private static func authenticatedHeader(kind: FrameKind, offsetNanoseconds: UInt64) -> Data {
+        var data = Data([kind.rawValue])
+        withUnsafeBytes(of: offsetNanoseconds.littleEndian) { data.append(contentsOf: $0) }
+        return data
+    }
+
+    private static func lz4(_ data: Data) -> Data? {
+        let source = [UInt8](data)
+        var destination = [UInt8](repeating: 0, count: source.count)
+        let size = source.withUnsafeBufferPointer { source in
+            destination.withUnsafeMutableBufferPointer { destination in
+                compression_encode_buffer(
+                    destination.baseAddress!, destination.count,
+                    source.baseAddress!, source.count,
+                    nil, COMPRESSION_LZ4
+                )
+            }
+        }
+        guard size > 0, size < source.count else { return nil }
+        return Data(destination[..<size])
+    }
+
+    private static func unlz4(_ data: Data, rawSize: Int) -> Data? {
+        let source = [UInt8](data)
+        guard !source.isEmpty, rawSize > 0 else { return nil }
+        var destination = [UInt8](repeating: 0, count: rawSize)
+        let size = source.withUnsafeBufferPointer { source in
+            destination.withUnsafeMutableBufferPointer { destination in
+                compression_decode_buffer(
+                    destination.baseAddress!, destination.count,
+                    source.baseAddress!, source.count,
+                    nil, COMPRESSION_LZ4
+                )
+            }
+        }
+        return size == rawSize ? Data(destination) : nil
+    }
+
+    private static func readInteger<T: FixedWidthInteger>(_ type: T.Type, _ bytes: [UInt8], at position: Int) -> T {
+        var value: T = 0
+        for index in 0..<MemoryLayout<T>.size {
+            value |= T(bytes[position + index]) << (index * 8)
+        }
+        return value
+    }
+}
+
+// MARK: - SessionRecordingFileWriter
+
+/// Appends a recording to disk as it is captured. `append`, `flush`,
+/// `appendKeyframe` and `close` are called by one caller at a time (the
+/// recording pipeline); sealing and file writes run on a private serial
+/// queue. At most one batch of up to `flushThreshold` bytes is held in
+/// memory, plus batches still queued.
+nonisolated final class SessionRecordingFileWriter: @unchecked Sendable {
+
+    static let flushThreshold = 65_536
+
+    private static let logger = Logger(subsystem: "com.prossh", category: "SessionRecording")
+
+    let url: URL
+    private let handle: FileHandle
+    private let key: SymmetricKey
+    private let queue = DispatchQueue(label: "com.prossh.session-recording-writer", qos: .utility)
+    private var pending = Data()
+    private var pendingFirstOffset: UInt64 = 0
+    private var lastOffset: UInt64 = 0
+    /// Set on the queue after a failed write; later frames are dropped so
+    /// the file never has a gap.
+    private var failed = false
+
+    init(
+        url: URL,
+        header: SessionRecordingHeader,
+        fileManager: FileManager = .default,
+        makeKey: (Data) throws -> SymmetricKey = SessionRecordingFormat.key(forSalt:)
+    ) throws {
+        try fileManager.createDirectory(at: url.deletingLastPathComponent(), withIntermediateDirectories: true)
+        let salt = SymmetricKey(size: .bits256).withUnsafeBytes { Data($0) }
+        let key = try makeKey(salt)
+        var prefix = SessionRecordingFormat.magic
+        prefix.append(salt)
+        prefix.append(try SessionRecordingFormat.sealedFrame(
+            kind: .header,
+            body: try JSONEncoder().encode(header),
+            key: key
+        ))
+        guard fileManager.createFile(
+            atPath: url.path(percentEncoded: false),
+            contents: prefix,
+            attributes: [.posixPermissions: 0o600, .protectionKey: FileProtectionType.complete]
+        ) else {
+            throw CocoaError(.fileWriteUnknown)
+        }
+        let handle = try FileHandle(forWritingTo: url)
+        try handle.seekToEnd()
+        self.url = url
+        self.handle = handle
+        self.key = key
+    }
+
+    /// Add one chunk to the current batch, writing the batch once it
+    /// reaches `flushThreshold`.
+    func append(offsetNanoseconds: UInt64, stream: SessionRecordingStream, payload: Data) {
+        if pending.isEmpty {
+            pendingFirstOffset = offsetNanoseconds
+        }
+        lastOffset = offsetNanoseconds
+        SessionRecordingFormat.appendEvent(
+            offsetNanoseconds: offsetNanoseconds,
+            stream: stream,
+            payload: payload,
+            to: &pending
+        )
+        if pending.count >= Self.flushThreshold {
+            flush()
+        }
+    }
+
+    /// Seal and write the current batch in the background.
+    func flush() {
+        guard !pending.isEmpty else { return }
+        let batch = pending
+        let offset = pendingFirstOffset
+        pending = Data()
+        queue.async { [self] in
+            write(kind: .events, offsetNanoseconds: offset, body: batch)
+        }
+    }
+
+    /// Write the current batch, then a keyframe of the terminal state after
+    /// it, taken at `offsetNanoseconds`.
+    func appendKeyframe(offsetNanoseconds: UInt64, sequence: [UInt8]) {
+        flush()
+        let body = Data(sequence)
+        queue.async { [self] in
+            write(kind: .keyframe, offsetNanoseconds: offsetNanoseconds, body: body)
+        }
+    }
+
+    /// Write the remaining batch and the end time, and close the file.
+    /// Returns once everything is on disk.
+    func close(endedAt: Date) {
+        flush()
+        var body = Data()
+        withUnsafeBytes(of: endedAt.timeIntervalSince1970.bitPattern.littleEndian) { body.append(contentsOf: $0) }
+        let offset = lastOffset
+        queue.sync {
+            write(kind: .trailer, offsetNanoseconds: offset, body: body)
+            try? handle.synchronize()
+            try? handle.close()
+        }
+    }
+
+    private func write(kind: SessionRecordingFormat.FrameKind, offsetNanoseconds: UInt64, body: Data) {
+        guard !failed else { return }
+        do {
+            try handle.write(contentsOf: try SessionRecordingFormat.sealedFrame(
+                kind: kind,
+                offsetNanoseconds: offsetNanoseconds,
+                body: body,
+                key: key
+            ))
+        } catch {
+            failed = true
+            Self.logger.error("Recording write failed: \(error.localizedDescription, privacy: .public)")
+        }
+    }
+}
+
+// MARK: - SessionRecordingFileReader
+
+/// Reads a recording back one chunk at a time, a frame in memory at once.
+nonisolated final class SessionRecordingFileReader {
+
+    let header: SessionRecordingHeader
+    /// The trailer's end time, once it has been read.
+    private(set) var endedAt: Date?
+    /// Offset of the last chunk returned by `next()`.
+    private(set) var lastOffsetNanoseconds: UInt64 = 0
+
+    private let handle: FileHandle
+    private let key: SymmetricKey
+    /// File position of the frame after the header.
+    private let firstFramePosition: UInt64
+    private var buffered: [SessionRecordingChunk] = []
+    private var bufferedIndex = 0
+    private var isFinished = false
+
+    init(url: URL, makeKey: (Data) throws -> SymmetricKey = SessionRecordingFormat.key(forSalt:)) throws {
+        let handle = try FileHandle(forReadingFrom: url)
+        let prefix = try handle.read(upToCount: SessionRecordingFormat.prefixSize) ?? Data()
+        guard prefix.count == SessionRecordingFormat.prefixSize,
+              prefix.prefix(SessionRecordingFormat.magic.count) == SessionRecordingFormat.magic else {
+            throw SessionRecorderError.recordingNotFound
+        }
+        let key = try makeKey(Data(prefix.suffix(SessionRecordingFormat.saltSize)))
+        guard let frame = try Self.readFrame(from: handle, key: key), frame.kind == .header else {
+            throw SessionRecorderError.recordingNotFound
+        }
+        self.header = try JSONDecoder().decode(SessionRecordingHeader.self, from: frame.body)
+        self.firstFramePosition = try handle.offset()
+        self.handle = handle
+        self.key = key
+    }
+
+    deinit {
+        try? handle.close()
+    }
+
+    /// The next chunk, or nil at the end of the recording. Keyframes are
+    /// skipped.
+    func next() throws -> SessionRecordingChunk? {
+        while bufferedIndex == buffered.count {
+            guard !isFinished, let frame = try Self.readFrame(from: handle, key: key) else {
+                isFinished = true
+                return nil
+            }
+            switch frame.kind {
+            case .events:
+                buffered = try SessionRecordingFormat.decodeEvents(frame.body)
+                bufferedIndex = 0
+            case .trailer:
+                if frame.body.count == 8 {
+                    let bits = frame.body.withUnsafeBytes { UInt64(littleEndian: $0.loadUnaligned(as: UInt64.self)) }
+                    endedAt = Date(timeIntervalSince1970: Double(bitPattern: bits))
+                }
+                isFinished = true
+                return nil
+            default:
+                continue
+            }
+        }
+        let chunk = buffered[bufferedIndex]
+        bufferedIndex += 1
+        lastOffsetNanoseconds = chunk.offsetNanoseconds
+        return chunk
+    }
+
+    /// Move to the newest keyframe taken at or before `offsetNanoseconds`
+    /// and return its offset and sequence; `next()` then continues with the
+    /// chunks written after it. Without such a keyframe, moves to the first
+    /// chunk and returns nil. Only frame headers are read on the way.
+    func seek(toKeyframeAtOrBefore offsetNanoseconds: UInt64) throws -> (offsetNanoseconds: UInt64, sequence: Data)? {
+        var position = firstFramePosition
+        var keyframe: (position: UInt64, header: SessionRecordingFormat.FrameHeader)?
+        try handle.seek(toOffset: position)
+        while let bytes = try handle.read(upToCount: SessionRecordingFormat.FrameHeader.size),
+              let frameHeader = SessionRecordingFormat.frameHeader(bytes) {
+            if frameHeader.kind.decompressed == .keyframe {
+                guard frameHeader.offsetNanoseconds <= offsetNanoseconds else { break }
+                keyframe = (position, frameHeader)
+            }
+            position += UInt64(SessionRecordingFormat.FrameHeader.size + frameHeader.sealedLength)
+            try handle.seek(toOffset: position)
+        }
+
+        buffered = []
+        bufferedIndex = 0
+        isFinished = false
+        guard let keyframe else {
+            try handle.seek(toOffset: firstFramePosition)
+            return nil
+        }
+        try handle.seek(toOffset: keyframe.position)
+        guard let frame = try Self.readFrame(from: handle, key: key) else {
+            try handle.seek(toOffset: firstFramePosition)
+            return nil
+        }
+        lastOffsetNanoseconds = keyframe.header.offsetNanoseconds
+        return (keyframe.header.offsetNanoseconds, frame.body)
+    }
+
+    /// Length of the recording, from frame headers: the trailer's last-event
+    /// offset, or the offset of the last frame if there is no trailer.
+    func durationNanoseconds() throws -> UInt64 {
+        let resume = try handle.offset()
+        defer { try? handle.seek(toOffset: resume) }
+        var position = firstFramePosition
+        var duration: UInt64 = 0
+        try handle.seek(toOffset: position)
+        while let bytes = try handle.read(upToCount: SessionRecordingFormat.FrameHeader.size),
+              let frameHeader = SessionRecordingFormat.frameHeader(bytes) {
+            duration = max(duration, frameHeader.offsetNanoseconds)
+            position += UInt64(SessionRecordingFormat.FrameHeader.size + frameHeader.sealedLength)
+            try handle.seek(toOffset: position)
+        }
+        return duration
+    }
+
+    /// The whole recording in memory.
+    func readAll() throws -> SessionRecording {
+        var chunks: [SessionRecordingChunk] = []
+        while let chunk = try next() {
+            chunks.append(chunk)
+        }
+        return SessionRecording(
+            id: header.id,
+            sessionID: header.sessionID,
+            hostLabel: header.hostLabel,
+            username: header.username,
+            hostname: header.hostname,
+            port: header.port,
+            startedAt: header.startedAt,
+            endedAt: endedAt ?? header.startedAt.addingTimeInterval(Double(lastOffsetNanoseconds) / 1_000_000_000),
+            chunks: chunks
+        )
+    }
+
+    /// The next frame, of its decompressed kind; nil at end of file or at a
+    /// torn or unreadable frame.
+    private static func readFrame(
+        from handle: FileHandle,
+        key: SymmetricKey
+    ) throws -> (kind: SessionRecordingFormat.FrameKind, body: Data)? {
+        guard let bytes = try handle.read(upToCount: SessionRecordingFormat.FrameHeader.size),
+              let header = SessionRecordingFormat.frameHeader(bytes),
+              let sealed = try handle.read(upToCount: header.sealedLength),
+              sealed.count == header.sealedLength,
+              let body = try? SessionRecordingFormat.openFrame(sealed, header: header, key: key) else {
+            return nil
+        }
+        return (header.kind.decompressed, body)
+    }
+}
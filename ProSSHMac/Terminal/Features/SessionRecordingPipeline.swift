@@ -0,0 +1,104 @@
+// SessionRecordingPipeline.swift
+// ProSSHV2
+//
+// Writes one active recording in the background. Recorded chunks go to the
+// file writer in order. Output is also fed to a private shadow terminal,
+// and every `keyframeIntervalNanoseconds` or `keyframeIntervalBytes` of
+// output its state is written as a keyframe. Because the shadow sees
+// exactly the recorded bytes, a keyframe matches the chunks before it in
+// the file, and seeking replays only the chunks after it.
+//
+// The recorder calls in from the main actor. One detached task consumes
+// the events, so the writer is only ever used from one place at a time.
+
+import Foundation
+import Synchronization
+
+nonisolated final class SessionRecordingPipeline: Sendable {
+
+    static let keyframeIntervalNanoseconds: UInt64 = 30_000_000_000
+    static let keyframeIntervalBytes = 4 << 20
+    /// History carried in each keyframe, which is also the shadow
+    /// terminal's scrollback limit.
+    static let keyframeScrollbackLines = 1_000
+
+    private nonisolated enum Event: Sendable {
+        case chunk(offsetNanoseconds: UInt64, stream: SessionRecordingStream, payload: Data)
+        case flush
+        case close(endedAt: Date)
+    }
+
+    /// Payload bytes queued and not yet handed to the writer.
+    private nonisolated final class Backlog: Sendable {
+        let bytes = Atomic<Int>(0)
+    }
+
+    let url: URL
+    private let continuation: AsyncStream<Event>.Continuation
+    private let task: Task<Void, Never>
+    private let backlog: Backlog
+
+    /// Start writing through `writer`. The shadow terminal is `columns` by
+    /// `rows`, the session's size when recording started.
+    init(writer: SessionRecordingFileWriter, columns: Int, rows: Int) {
+        let (events, continuation) = AsyncStream<Event>.makeStream(bufferingPolicy: .unbounded)
+        self.url = writer.url
+        self.continuation = continuation
+        let backlog = Backlog()
+        self.backlog = backlog
+        self.task = Task.detached(priority: .utility) {
+            let shadow = TerminalEngine(
+                columns: max(1, columns),
+                rows: max(1, rows),
+                maxScrollbackLines: Self.keyframeScrollbackLines
+            )
+            var lastKeyframeOffset: UInt64 = 0
+            var bytesSinceKeyframe = 0
+            for await event in events {
+                switch event {
+                case let .chunk(offset, stream, payload):
+                    writer.append(offsetNanoseconds: offset, stream: stream, payload: payload)
+                    backlog.bytes.subtract(payload.count, ordering: .relaxed)
+                    guard stream == .output else { continue }
+                    _ = await shadow.feed(payload)
+                    bytesSinceKeyframe += payload.count
+                    if bytesSinceKeyframe >= Self.keyframeIntervalBytes
+                        || offset &- lastKeyframeOffset >= Self.keyframeIntervalNanoseconds {
+                        let sequence = await shadow.keyframeSequence(scrollbackLines: Self.keyframeScrollbackLines)
+                        writer.appendKeyframe(offsetNanoseconds: offset, sequence: sequence)
+                        lastKeyframeOffset = offset
+                        bytesSinceKeyframe = 0
+                    }
+                case .flush:
+                    writer.flush()
+                case let .close(endedAt):
+                    writer.close(endedAt: endedAt)
+                    return
+                }
+            }
+        }
+    }
+
+    func append(offsetNanoseconds: UInt64, stream: SessionRecordingStream, payload: Data) {
+        backlog.bytes.add(payload.count, ordering: .relaxed)
+        continuation.yield(.chunk(offsetNanoseconds: offsetNanoseconds, stream: stream, payload: payload))
+    }
+
+    /// Payload bytes queued for the writer. The writer buffers up to
+    /// `SessionRecordingFileWriter.flushThreshold` more before writing.
+    var queuedByteCount: Int {
+        backlog.bytes.load(ordering: .relaxed)
+    }
+
+    /// Write buffered chunks once the events queued before this are done.
+    func flush() {
+        continuation.yield(.flush)
+    }
+
+    /// Finish writing and close the file. Returns once it is complete.
+    func close(endedAt: Date) async {
+        continuation.yield(.close(endedAt: endedAt))
+        continuation.finish()
+        await task.value
+    }
+}
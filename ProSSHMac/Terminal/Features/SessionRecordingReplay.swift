@@ -0,0 +1,51 @@
+// SessionRecordingReplay.swift
+// ProSSHV2
+//
+// Replays a recording into a terminal that has no renderer, for indexing,
+// search or export. Output is read from the file and fed to the engine in
+// large batches. Timing and input chunks are ignored, and no snapshots are
+// taken. The terminal starts at the size stored in the recording header,
+// or 80x24 for recordings that did not store one.
+
+import CryptoKit
+import Foundation
+
+nonisolated enum SessionRecordingReplay {
+
+    /// Output bytes handed to the engine per feed.
+    static let batchBytes = 1 << 20
+
+    /// Replay the streaming recording at `fileURL` into a new terminal.
+    static func replay(
+        fileURL: URL,
+        maxScrollbackLines: Int = 10_000,
+        indexesScrollback: Bool = false,
+        makeKey: @escaping @Sendable (Data) throws -> SymmetricKey = SessionRecordingFormat.key(forSalt:)
+    ) async throws -> TerminalEngine {
+        // The reader does blocking file I/O, so replay off the caller's actor.
+        try await Task.detached(priority: .utility) {
+            let reader = try SessionRecordingFileReader(url: fileURL, makeKey: makeKey)
+            let engine = TerminalEngine(
+                columns: max(1, reader.header.columns ?? 80),
+                rows: max(1, reader.header.rows ?? 24),
+                maxScrollbackLines: maxScrollbackLines,
+                indexesScrollback: indexesScrollback
+            )
+            var batch = Data()
+            batch.reserveCapacity(batchBytes)
+            while let chunk = try reader.next() {
+                try Task.checkCancellation()
+                guard chunk.stream == .output else { continue }
+                batch.append(chunk.payload)
+                if batch.count >= batchBytes {
+                    _ = await engine.feed(batch)
+                    batch.removeAll(keepingCapacity: true)
+                }
+            }
+            if !batch.isEmpty {
+                _ = await engine.feed(batch)
+            }
+            return engine
+        }.value
+    }
+}
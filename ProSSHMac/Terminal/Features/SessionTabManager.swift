@@ -87,6 +87,25 @@ final class SessionTabManager: ObservableObject {
         persistState()
     }
 
+    /// Gives `newID` the tab position, pin and selection of `oldID`, the
+    /// session it replaced on reconnect. Takes effect at the next `sync`.
+    func replaceSession(_ oldID: UUID, with newID: UUID) {
+        var orderedIDs = loadOrderedSessionIDs().filter { $0 != newID }
+        if let index = orderedIDs.firstIndex(of: oldID) {
+            orderedIDs[index] = newID
+            defaults.set(orderedIDs.map(\.uuidString), forKey: orderedSessionIDsKey)
+        }
+        var pinnedIDs = loadPinnedSessionIDs()
+        if pinnedIDs.remove(oldID) != nil {
+            pinnedIDs.insert(newID)
+            defaults.set(pinnedIDs.map(\.uuidString), forKey: pinnedSessionIDsKey)
+        }
+        if selectedSessionID == oldID {
+            selectedSessionID = newID
+            defaults.set(newID.uuidString, forKey: selectedSessionIDKey)
+        }
+    }
+
     func tab(atOneBasedIndex index: Int) -> SessionTab? {
         let zeroBased = index - 1
         guard zeroBased >= 0, zeroBased < tabs.count else { return nil }
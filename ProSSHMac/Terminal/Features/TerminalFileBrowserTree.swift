@@ -99,6 +99,47 @@ enum TerminalFileBrowserTree {
         path: String,
         fileManager: FileManager = .default
     ) throws -> [TerminalFileBrowserEntry] {
+        var entries: [TerminalFileBrowserEntry] = []
+        try enumerateLocalEntries(path: path, pageSize: 1_024, fileManager: fileManager) { page in
+            entries.append(contentsOf: page)
+            return true
+        }
+        return entries.sorted(by: listingOrder)
+    }
+
+    /// Streams a local directory in unsorted pages from a background task, so
+    /// the sidebar can show the first page of a 100k-entry directory while the
+    /// rest is still being read. Merge pages with `mergeListingPage`.
+    nonisolated static func localEntryPages(
+        path: String,
+        pageSize: Int = 512
+    ) -> AsyncThrowingStream<[TerminalFileBrowserEntry], Error> {
+        AsyncThrowingStream { continuation in
+            let task = Task.detached(priority: .userInitiated) {
+                do {
+                    try enumerateLocalEntries(path: path, pageSize: pageSize) { page in
+                        continuation.yield(page)
+                        return !Task.isCancelled
+                    }
+                    continuation.finish()
+                } catch {
+                    continuation.finish(throwing: error)
+                }
+            }
+            continuation.onTermination = { _ in task.cancel() }
+        }
+    }
+
+    /// Calls `onPage` with up to `pageSize` entries at a time until the
+    /// directory is exhausted or `onPage` returns false. The enumerator
+    /// prefetches the directory flag and size through bulk attribute reads,
+    /// so sizing costs no extra `stat` per entry.
+    nonisolated static func enumerateLocalEntries(
+        path: String,
+        pageSize: Int,
+        fileManager: FileManager = .default,
+        onPage: ([TerminalFileBrowserEntry]) -> Bool
+    ) throws {
         let directoryURL = URL(fileURLWithPath: path, isDirectory: true)
         var isDirectoryFlag: ObjCBool = false
         guard fileManager.fileExists(atPath: directoryURL.path, isDirectory: &isDirectoryFlag),
@@ -111,27 +152,135 @@ enum TerminalFileBrowserTree {
         }
 
         let keys: Set<URLResourceKey> = [.isDirectoryKey, .fileSizeKey]
-        let urls = try fileManager.contentsOfDirectory(
+        var enumerationError: Error?
+        guard let enumerator = fileManager.enumerator(
             at: directoryURL,
             includingPropertiesForKeys: Array(keys),
-            options: []
-        )
+            options: [.skipsSubdirectoryDescendants],
+            errorHandler: { url, error in
+                // An unreadable child is skipped; an unreadable directory fails the listing.
+                if url.standardizedFileURL.path == directoryURL.standardizedFileURL.path {
+                    enumerationError = error
+                    return false
+                }
+                return true
+            }
+        ) else {
+            throw NSError(
+                domain: "TerminalFileBrowser",
+                code: 2,
+                userInfo: [NSLocalizedDescriptionKey: "Cannot read local directory: \(path)"]
+            )
+        }
 
-        return urls.compactMap { url in
-            guard let values = try? url.resourceValues(forKeys: keys) else { return nil }
-            return TerminalFileBrowserEntry(
+        let batchSize = max(1, pageSize)
+        var page: [TerminalFileBrowserEntry] = []
+        page.reserveCapacity(batchSize)
+        while let url = enumerator.nextObject() as? URL {
+            guard let values = try? url.resourceValues(forKeys: keys) else { continue }
+            page.append(TerminalFileBrowserEntry(
                 path: url.path,
                 name: url.lastPathComponent,
                 isDirectory: values.isDirectory ?? false,
                 size: Int64(values.fileSize ?? 0)
-            )
+            ))
+            if page.count == batchSize {
+                guard onPage(page) else { return }
+                page.removeAll(keepingCapacity: true)
+            }
+        }
+        if let enumerationError {
+            throw enumerationError
         }
-        .sorted { lhs, rhs in
-            if lhs.isDirectory != rhs.isDirectory {
-                return lhs.isDirectory && !rhs.isDirectory
+        if !page.isEmpty {
+            _ = onPage(page)
+        }
+    }
+
+    /// Directories first, then case-insensitive by name.
+    nonisolated static func listingOrder(_ lhs: TerminalFileBrowserEntry, _ rhs: TerminalFileBrowserEntry) -> Bool {
+        if lhs.isDirectory != rhs.isDirectory {
+            return lhs.isDirectory && !rhs.isDirectory
+        }
+        return lhs.name.localizedCaseInsensitiveCompare(rhs.name) == .orderedAscending
+    }
+
+    /// Merges an unsorted page into an already sorted listing. Linear in the
+    /// listing size, so a directory arriving in many pages is not re-sorted
+    /// from scratch each time.
+    nonisolated static func mergeListingPage(
+        _ page: [TerminalFileBrowserEntry],
+        into sorted: [TerminalFileBrowserEntry]
+    ) -> [TerminalFileBrowserEntry] {
+        let incoming = page.sorted(by: listingOrder)
+        var merged: [TerminalFileBrowserEntry] = []
+        merged.reserveCapacity(sorted.count + incoming.count)
+        var lhs = sorted.startIndex
+        var rhs = incoming.startIndex
+        while lhs < sorted.endIndex, rhs < incoming.endIndex {
+            if listingOrder(incoming[rhs], sorted[lhs]) {
+                merged.append(incoming[rhs])
+                rhs += 1
+            } else {
+                merged.append(sorted[lhs])
+                lhs += 1
             }
-            return lhs.name.localizedCaseInsensitiveCompare(rhs.name) == .orderedAscending
         }
+        merged.append(contentsOf: sorted[lhs...])
+        merged.append(contentsOf: incoming[rhs...])
+        return merged
+    }
+
+    /// Replaces only the visible rows under `directoryPath` after its
+    /// listing or expansion changed: the directory's subtree slice is
+    /// regenerated and every other row is left in place. Does nothing when
+    /// the directory is not visible. For the root, the slice is the whole list.
+    nonisolated static func updateRows(
+        _ rows: inout [TerminalFileBrowserRow],
+        under directoryPath: String,
+        rootPath: String,
+        childrenByPath: [String: [TerminalFileBrowserEntry]],
+        expandedPaths: Set<String>
+    ) {
+        let range: Range<Int>
+        let depth: Int
+        if directoryPath == rootPath {
+            range = rows.startIndex..<rows.endIndex
+            depth = 0
+        } else {
+            guard let index = rows.firstIndex(where: { $0.entry.path == directoryPath }) else { return }
+            let parentDepth = rows[index].depth
+            let end = rows[(index + 1)...].firstIndex(where: { $0.depth <= parentDepth }) ?? rows.endIndex
+            range = (index + 1)..<end
+            depth = parentDepth + 1
+        }
+
+        var subtree: [TerminalFileBrowserRow] = []
+        if directoryPath == rootPath || expandedPaths.contains(directoryPath),
+           let children = childrenByPath[directoryPath] {
+            appendRows(
+                from: children,
+                depth: depth,
+                into: &subtree,
+                childrenByPath: childrenByPath,
+                expandedPaths: expandedPaths
+            )
+        }
+        rows.replaceSubrange(range, with: subtree)
+    }
+
+    /// Entries present in only one of two listings of the same directory. A
+    /// file whose size changed appears in both lists.
+    nonisolated static func listingDiff(
+        from old: [TerminalFileBrowserEntry],
+        to new: [TerminalFileBrowserEntry]
+    ) -> (inserted: [TerminalFileBrowserEntry], removed: [TerminalFileBrowserEntry]) {
+        let oldSet = Set(old)
+        let newSet = Set(new)
+        return (
+            new.filter { !oldSet.contains($0) },
+            old.filter { !newSet.contains($0) }
+        )
     }
 
     nonisolated private static func appendRows(
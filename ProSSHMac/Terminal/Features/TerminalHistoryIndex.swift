@@ -1,6 +1,6 @@
 import Foundation
 
-actor TerminalHistoryIndex {
+actor TerminalHistoryIndex: MemoryFootprintReporting {
     private struct PromptHints: Sendable {
         let username: String
         let hostname: String
@@ -13,16 +13,43 @@ actor TerminalHistoryIndex {
         let startedAt: Date
         var boundarySource: CommandBoundarySource
         let startVisibleLines: [String]
-        var rawOutput: String = ""
+        /// Output bytes as received. Holds at most `2 * limit` bytes and is
+        /// decoded only when read, so a chunk costs one append.
+        var rawOutput: [UInt8] = []
         var hasOutput = false
         var sawNonPromptScreenAfterStart = false
+
+        mutating func appendOutput(_ data: Data, limit: Int) {
+            if !hasOutput {
+                // Any byte other than ASCII whitespace and control counts.
+                hasOutput = data.contains { $0 > 0x20 && $0 != 0x7F }
+            }
+            rawOutput.append(contentsOf: data)
+            if rawOutput.count > 2 * limit {
+                rawOutput.removeFirst(rawOutput.count - limit)
+            }
+        }
+
+        /// The last `limit` bytes of output as text, NULs dropped.
+        func decodedOutput(limit: Int) -> String {
+            // Skip UTF-8 continuation bytes cut off by trimming.
+            let tail = rawOutput.suffix(limit).drop { (0x80..<0xC0).contains($0) }
+            return String(decoding: tail.lazy.filter { $0 != 0 }, as: UTF8.self)
+        }
     }
 
     private struct SessionHistoryState: Sendable {
         var blocks: [CommandBlock] = []
+        /// Indexes `blocks`; `blocks[i]` has serial `searchIndex.firstSerial + i`.
+        var searchIndex = CommandHistorySearchIndex()
+        /// Block vectors, in step with `searchIndex` serials.
+        var embeddingIndex = CommandHistoryEmbeddingIndex()
         var activeCommand: ActiveCommandContext?
         var lastVisibleLines: [String] = []
         var semanticPromptSeen = false
+        /// Whether the last OSC 133 completion came with output read from
+        /// the terminal's lines. Raw output is not kept while it does.
+        var readsOutputFromLines = false
         var promptHints: PromptHints?
         var rawInputBuffer = ""
         var escapeSequenceInProgress = false
@@ -30,11 +57,17 @@ actor TerminalHistoryIndex {
 
     private var sessionStates: [UUID: SessionHistoryState] = [:]
     private let maxBlocksPerSession: Int
-    private let maxOutputCharacters: Int
+    nonisolated let maxOutputCharacters: Int
+    private let embedder: HistoryTextEmbedder
 
-    init(maxBlocksPerSession: Int = 500, maxOutputCharacters: Int = 120_000) {
+    init(
+        maxBlocksPerSession: Int = 500,
+        maxOutputCharacters: Int = 120_000,
+        embedder: HistoryTextEmbedder = HistoryTextEmbedder()
+    ) {
         self.maxBlocksPerSession = max(10, maxBlocksPerSession)
         self.maxOutputCharacters = max(2_000, maxOutputCharacters)
+        self.embedder = embedder
     }
 
     func registerSession(sessionID: UUID, username: String, hostname: String,
@@ -116,33 +149,23 @@ actor TerminalHistoryIndex {
     }
 
     func recordOutputChunk(sessionID: UUID, data: Data, at: Date = .now) {
-        guard !data.isEmpty else { return }
-        var state = sessionStates[sessionID] ?? SessionHistoryState()
-        guard var active = state.activeCommand else {
-            sessionStates[sessionID] = state
-            return
-        }
-
-        let chunk = String(decoding: data, as: UTF8.self)
-        let sanitizedChunk = chunk.replacingOccurrences(of: "\u{0000}", with: "")
-        if sanitizedChunk.contains(where: { !$0.isWhitespace }) {
-            active.hasOutput = true
-        }
-
-        if !sanitizedChunk.isEmpty {
-            active.rawOutput.append(sanitizedChunk)
-            if active.rawOutput.count > maxOutputCharacters {
-                let overflow = active.rawOutput.count - maxOutputCharacters
-                active.rawOutput.removeFirst(overflow)
-            }
-        }
-
-        state.activeCommand = active
-        sessionStates[sessionID] = state
+        guard !data.isEmpty,
+              sessionStates[sessionID]?.activeCommand != nil,
+              sessionStates[sessionID]?.readsOutputFromLines == false else { return }
+        // Mutate in place; a copy of the context would copy the buffer.
+        sessionStates[sessionID]?.activeCommand?.appendOutput(data, limit: maxOutputCharacters)
         _ = at
     }
 
-    func recordSemanticEvent(sessionID: UUID, event: SemanticPromptEvent, at: Date = .now) -> CommandBlock? {
+    /// Apply an OSC 133 event. `capturedOutput` is the text the command
+    /// printed, read from the terminal's lines since OSC 133;C; without it
+    /// the output is derived from screen text as for heuristic boundaries.
+    func recordSemanticEvent(
+        sessionID: UUID,
+        event: SemanticPromptEvent,
+        capturedOutput: String? = nil,
+        at: Date = .now
+    ) -> CommandBlock? {
         var state = sessionStates[sessionID] ?? SessionHistoryState()
         state.semanticPromptSeen = true
         var completedBlock: CommandBlock?
@@ -150,11 +173,13 @@ actor TerminalHistoryIndex {
         switch event {
         case .promptStart:
             if state.activeCommand != nil {
+                state.readsOutputFromLines = capturedOutput != nil
                 completedBlock = finalizeActiveCommand(
                     for: sessionID,
                     at: at,
                     explicitExitCode: nil,
                     completionSource: .osc133,
+                    capturedOutput: capturedOutput,
                     state: &state
                 )
             }
@@ -169,11 +194,15 @@ actor TerminalHistoryIndex {
             }
 
         case let .commandEnd(exitCode):
+            if state.activeCommand != nil {
+                state.readsOutputFromLines = capturedOutput != nil
+            }
             completedBlock = finalizeActiveCommand(
                 for: sessionID,
                 at: at,
                 explicitExitCode: exitCode,
                 completionSource: .osc133,
+                capturedOutput: capturedOutput,
                 state: &state
             )
         }
@@ -241,18 +270,62 @@ actor TerminalHistoryIndex {
         return Array(state.blocks.suffix(count).reversed())
     }
 
+    /// Blocks whose command or output contains `query`, ignoring case, best
+    /// first: an exact command, then a command match, then output only;
+    /// newer blocks first within each rank.
     func searchCommands(sessionID: UUID, query: String, limit: Int = 20) -> [CommandBlock] {
         let trimmed = query.trimmingCharacters(in: .whitespacesAndNewlines).lowercased()
         guard !trimmed.isEmpty, let state = sessionStates[sessionID], !state.blocks.isEmpty else { return [] }
 
-        let count = max(1, limit)
-        return state.blocks
-            .filter { block in
-                block.command.lowercased().contains(trimmed) ||
-                block.output.lowercased().contains(trimmed)
+        let ranked = rankedMatches(in: state, query: trimmed)
+        return ranked.prefix(max(1, limit)).map(\.block)
+    }
+
+    /// `searchCommands` over every session, merged by rank and then recency.
+    func searchAllCommands(query: String, limit: Int = 20) -> [CommandBlock] {
+        let trimmed = query.trimmingCharacters(in: .whitespacesAndNewlines).lowercased()
+        guard !trimmed.isEmpty else { return [] }
+
+        let ranked = sessionStates.values.flatMap { rankedMatches(in: $0, query: trimmed) }
+        return ranked
+            .sorted { ($0.rank, $0.block.completedAt) > ($1.rank, $1.block.completedAt) }
+            .prefix(max(1, limit))
+            .map(\.block)
+    }
+
+    /// Blocks from any session (or only `sessionIDs`) closest in meaning to
+    /// `query`, best first. Only blocks above the embedder's relevance
+    /// threshold are returned, so an unrelated prompt gets none.
+    func relevantCommands(query: String, sessionIDs: Set<UUID>? = nil, limit: Int = 5) -> [CommandBlock] {
+        let trimmed = query.trimmingCharacters(in: .whitespacesAndNewlines)
+        guard !trimmed.isEmpty, limit > 0, let queryVector = embedder.vector(for: trimmed) else { return [] }
+
+        var scored: [(score: Float, block: CommandBlock)] = []
+        for (sessionID, state) in sessionStates where sessionIDs?.contains(sessionID) ?? true {
+            let nearest = state.embeddingIndex.nearest(
+                to: queryVector,
+                limit: limit,
+                threshold: embedder.relevanceThreshold
+            )
+            for match in nearest {
+                let position = match.serial - state.embeddingIndex.firstSerial
+                guard state.blocks.indices.contains(position) else { continue }
+                scored.append((match.score, state.blocks[position]))
             }
-            .suffix(count)
-            .reversed()
+        }
+        return scored
+            .sorted { ($0.score, $0.block.completedAt) > ($1.score, $1.block.completedAt) }
+            .prefix(limit)
+            .map(\.block)
+    }
+
+    /// The block whose command or output carries the AI tool completion
+    /// `marker`, found without a search.
+    func commandBlock(sessionID: UUID, marker: String) -> CommandBlock? {
+        guard let state = sessionStates[sessionID],
+              let serial = state.searchIndex.serial(ofMarker: marker) else { return nil }
+        let position = serial - state.searchIndex.firstSerial
+        return state.blocks.indices.contains(position) ? state.blocks[position] : nil
     }
 
     func commandOutput(sessionID: UUID, blockID: UUID) -> String? {
@@ -262,11 +335,59 @@ actor TerminalHistoryIndex {
 
     func activeCommandRawOutput(sessionID: UUID) -> String? {
         guard let active = sessionStates[sessionID]?.activeCommand else { return nil }
-        return active.rawOutput
+        return active.decodedOutput(limit: maxOutputCharacters)
+    }
+
+    /// Bytes held for the session: command text and output of its blocks,
+    /// the search and embedding indexes, the running command's raw output and the last
+    /// visible lines.
+    func memoryFootprint(for sessionID: UUID) -> MemoryFootprint {
+        guard let state = sessionStates[sessionID] else { return MemoryFootprint() }
+        var bytes = state.searchIndex.estimatedByteCount + state.embeddingIndex.estimatedByteCount
+        for block in state.blocks {
+            bytes += MemoryLayout<CommandBlock>.stride + block.command.utf8.count + block.output.utf8.count
+        }
+        if let active = state.activeCommand {
+            bytes += active.rawOutput.capacity + active.command.utf8.count
+            bytes += active.startVisibleLines.reduce(0) { $0 + $1.utf8.count }
+        }
+        bytes += state.lastVisibleLines.reduce(0) { $0 + $1.utf8.count }
+        return MemoryFootprint(.historyIndex, bytes: bytes)
     }
 
     // MARK: - Internals
 
+    /// Blocks of `state` containing `query` (lowercased), best first.
+    private func rankedMatches(in state: SessionHistoryState, query: String) -> [(rank: Int, block: CommandBlock)] {
+        let positions: [Int]
+        if let serials = state.searchIndex.candidates(forLowercased: query) {
+            positions = serials.map { $0 - state.searchIndex.firstSerial }
+        } else {
+            positions = Array(state.blocks.indices)
+        }
+
+        var ranked: [(rank: Int, block: CommandBlock)] = []
+        for position in positions.reversed() where state.blocks.indices.contains(position) {
+            let block = state.blocks[position]
+            let command = block.command.lowercased()
+            let rank: Int
+            if command == query {
+                rank = 2
+            } else if command.contains(query) {
+                rank = 1
+            } else if block.output.lowercased().contains(query) {
+                rank = 0
+            } else {
+                continue
+            }
+            ranked.append((rank, block))
+        }
+        // Stable, so newer blocks stay first within a rank.
+        return ranked.enumerated()
+            .sorted { ($0.element.rank, -$0.offset) > ($1.element.rank, -$1.offset) }
+            .map(\.element)
+    }
+
     private func startCommand(
         command: String,
         for sessionID: UUID,
@@ -301,16 +422,17 @@ actor TerminalHistoryIndex {
         at: Date,
         explicitExitCode: Int?,
         completionSource: CommandBoundarySource,
+        capturedOutput: String? = nil,
         state: inout SessionHistoryState
     ) -> CommandBlock? {
         guard let active = state.activeCommand else { return nil }
         state.activeCommand = nil
 
-        var output = deriveOutput(
+        var output = capturedOutput ?? deriveOutput(
             command: active.command,
             startLines: active.startVisibleLines,
             endLines: state.lastVisibleLines,
-            rawOutputFallback: active.rawOutput,
+            rawOutputFallback: active.decodedOutput(limit: maxOutputCharacters),
             hints: state.promptHints
         )
 
@@ -330,8 +452,15 @@ actor TerminalHistoryIndex {
         )
 
         state.blocks.append(block)
+        state.searchIndex.append(block)
+        state.embeddingIndex.append(
+            CommandHistoryEmbeddingIndex.embeddingText(for: block).flatMap(embedder.vector(for:))
+        )
         if state.blocks.count > maxBlocksPerSession {
-            state.blocks.removeFirst(state.blocks.count - maxBlocksPerSession)
+            let overflow = state.blocks.count - maxBlocksPerSession
+            state.blocks.removeFirst(overflow)
+            state.searchIndex.removeOldest(overflow)
+            state.embeddingIndex.removeOldest(overflow)
         }
         return block
     }
@@ -0,0 +1,139 @@
+import CoreServices
+import Foundation
+
+/// FSEvents stream over the local file browser's root. Reports the
+/// directories whose contents changed so the sidebar re-reads just those
+/// listings and patches the tree, instead of re-reading everything on refresh
+/// or going stale until the user notices.
+///
+/// FSEvents is recursive, so one stream on the root covers every expanded
+/// subdirectory. Events arrive coalesced per directory (no per-file flag),
+/// batched by `latency`. Paths are reported in the root's canonical form
+/// (`/private/var/...` for `/var/...`) and mapped back to the browser's
+/// spelling before delivery.
+nonisolated final class TerminalLocalDirectoryWatcher: @unchecked Sendable {
+
+    nonisolated struct Change: Sendable, Equatable {
+        /// Directory whose entries changed, spelled like the watched root.
+        var directoryPath: String
+        /// FSEvents dropped events below this directory; every loaded
+        /// listing under it must be re-read.
+        var rescanSubtree: Bool
+    }
+
+    let rootPath: String
+    private var stream: FSEventStreamRef?
+    private let queue = DispatchQueue(label: "com.prossh.filebrowser.fsevents", qos: .utility)
+
+    /// Owned by the stream (released through the context's release
+    /// callback), so a callback already queued never sees a freed watcher.
+    private nonisolated final class Handler {
+        let rootPath: String
+        let canonicalRootPath: String
+        let onChange: @Sendable ([Change]) -> Void
+
+        init(rootPath: String, canonicalRootPath: String, onChange: @escaping @Sendable ([Change]) -> Void) {
+            self.rootPath = rootPath
+            self.canonicalRootPath = canonicalRootPath
+            self.onChange = onChange
+        }
+
+        func deliver(paths: [String], flags: [FSEventStreamEventFlags]) {
+            var changes: [Change] = []
+            var seen: [String: Int] = [:]
+            for (path, flag) in zip(paths, flags) {
+                let rootChanged = flag & FSEventStreamEventFlags(kFSEventStreamEventFlagRootChanged) != 0
+                let mustScan = flag & FSEventStreamEventFlags(kFSEventStreamEventFlagMustScanSubDirs) != 0
+                let directory = rootChanged ? rootPath : browserPath(for: path)
+                if let index = seen[directory] {
+                    changes[index].rescanSubtree = changes[index].rescanSubtree || mustScan || rootChanged
+                } else {
+                    seen[directory] = changes.count
+                    changes.append(Change(directoryPath: directory, rescanSubtree: mustScan || rootChanged))
+                }
+            }
+            if !changes.isEmpty {
+                onChange(changes)
+            }
+        }
+
+        private func browserPath(for eventPath: String) -> String {
+            var path = eventPath
+            while path.count > 1, path.hasSuffix("/") {
+                path.removeLast()
+            }
+            for root in [canonicalRootPath, rootPath] {
+                if path == root {
+                    return rootPath
+                }
+                let prefix = root == "/" ? "/" : root + "/"
+                if path.hasPrefix(prefix) {
+                    let relative = path.dropFirst(prefix.count)
+                    return rootPath == "/" ? "/" + relative : rootPath + "/" + relative
+                }
+            }
+            return path
+        }
+    }
+
+    /// Starts watching `rootPath`; nil if the stream cannot be created.
+    init?(
+        rootPath: String,
+        latency: TimeInterval = 0.25,
+        onChange: @escaping @Sendable ([Change]) -> Void
+    ) {
+        self.rootPath = rootPath
+        let canonicalRootPath = URL(fileURLWithPath: rootPath, isDirectory: true)
+            .resolvingSymlinksInPath().path
+        let handler = Handler(rootPath: rootPath, canonicalRootPath: canonicalRootPath, onChange: onChange)
+
+        var context = FSEventStreamContext(
+            version: 0,
+            info: Unmanaged.passRetained(handler).toOpaque(),
+            retain: nil,
+            release: { info in
+                guard let info else { return }
+                Unmanaged<Handler>.fromOpaque(info).release()
+            },
+            copyDescription: nil
+        )
+        let callback: FSEventStreamCallback = { _, info, count, eventPaths, eventFlags, _ in
+            guard let info else { return }
+            let handler = Unmanaged<Handler>.fromOpaque(info).takeUnretainedValue()
+            let paths = Unmanaged<CFArray>.fromOpaque(eventPaths).takeUnretainedValue() as? [String] ?? []
+            let flags = Array(UnsafeBufferPointer(start: eventFlags, count: count))
+            handler.deliver(paths: paths, flags: flags)
+        }
+
+        guard let stream = FSEventStreamCreate(
+            kCFAllocatorDefault,
+            callback,
+            &context,
+            [rootPath] as CFArray,
+            FSEventStreamEventId(kFSEventStreamEventIdSinceNow),
+            latency,
+            FSEventStreamCreateFlags(kFSEventStreamCreateFlagUseCFTypes | kFSEventStreamCreateFlagWatchRoot)
+        ) else {
+            Unmanaged.passUnretained(handler).release()
+            return nil
+        }
+        self.stream = stream
+        FSEventStreamSetDispatchQueue(stream, queue)
+        guard FSEventStreamStart(stream) else {
+            stop()
+            return nil
+        }
+    }
+
+    deinit {
+        stop()
+    }
+
+    func stop() {
+        guard let stream else { return }
+        self.stream = nil
+        FSEventStreamStop(stream)
+        FSEventStreamInvalidate(stream)
+        FSEventStreamRelease(stream)
+    }
+}
@@ -2,6 +2,14 @@
 // ProSSHV2
 //
 // E.2 — terminal search model with regex and case-sensitivity options.
+//
+// Screen lines are searched here on the main actor. With a history source
+// attached, scrollback is searched too, by ScrollbackSearchEngine off the
+// main actor; its matches stream into `historyMatches`. Navigation walks
+// history matches (oldest first) and then screen matches as one list.
+// Folded command output is no longer in scrollback; its matches are only
+// counted (`foldedMatchCount`), and expanding the folds brings them into
+// history.
 
 import Foundation
 import Combine
@@ -26,19 +34,27 @@ struct TerminalSearchMatch: Identifiable, Hashable, Sendable {
 final class TerminalSearch: ObservableObject {
     @Published var isPresented = false
     @Published var query = "" {
-        didSet { refreshMatches() }
+        didSet { refreshAll() }
     }
     @Published var isRegexEnabled = false {
-        didSet { refreshMatches() }
+        didSet { refreshAll() }
     }
     @Published var isCaseSensitive = false {
-        didSet { refreshMatches() }
+        didSet { refreshAll() }
     }
 
     @Published private(set) var matches: [TerminalSearchMatch] = []
     @Published private(set) var selectedMatchIndex: Int?
     @Published private(set) var validationError: String?
 
+    /// Scrollback matches, oldest line first.
+    @Published private(set) var historyMatches: [ScrollbackSearchMatch] = []
+    @Published private(set) var selectedHistoryMatchIndex: Int?
+    /// A history search is running; more matches may arrive.
+    @Published private(set) var isSearchingHistory = false
+    /// Matches in folded command output, counted when the query changes.
+    @Published private(set) var foldedMatchCount = 0
+
     var selectedMatch: TerminalSearchMatch? {
         guard let selectedMatchIndex,
               matches.indices.contains(selectedMatchIndex) else {
@@ -47,15 +63,50 @@ final class TerminalSearch: ObservableObject {
         return matches[selectedMatchIndex]
     }
 
+    var selectedHistoryMatch: ScrollbackSearchMatch? {
+        guard let selectedHistoryMatchIndex,
+              historyMatches.indices.contains(selectedHistoryMatchIndex) else {
+            return nil
+        }
+        return historyMatches[selectedHistoryMatchIndex]
+    }
+
+    var hasMatches: Bool {
+        !matches.isEmpty || !historyMatches.isEmpty
+    }
+
     var resultSummary: String {
-        guard !matches.isEmpty else { return "0" }
-        let current = (selectedMatchIndex ?? 0) + 1
-        return "\(current)/\(matches.count)"
+        guard hasMatches else { return isSearchingHistory ? "0+" : "0" }
+        let total = historyMatches.count + matches.count
+        let current: Int
+        if let selectedHistoryMatchIndex {
+            current = selectedHistoryMatchIndex + 1
+        } else if let selectedMatchIndex {
+            current = historyMatches.count + selectedMatchIndex + 1
+        } else {
+            current = 0
+        }
+        return "\(current)/\(total)" + (isSearchingHistory ? "+" : "")
     }
 
     private var lines: [String] = []
     private var matchesByLineIndex: [Int: [TerminalSearchMatch]] = [:]
 
+    private var historySessionID: UUID?
+    private var historySource: (@MainActor () async -> ScrollbackBuffer?)?
+    private var historyEngine = ScrollbackSearchEngine()
+    private var historyTask: Task<Void, Never>?
+    private var historyGeneration = 0
+    /// New output arrived while a history search was running.
+    private var historyRefreshPending = false
+    /// `ScrollbackBuffer.firstLineID` and line count of the copy that
+    /// produced `historyMatches`.
+    private var historyFirstLineID = 0
+    private var historyLineCount = 0
+
+    private var foldedSource: (@MainActor (ScrollbackSearchQuery) async -> Int)?
+    private var foldedTask: Task<Void, Never>?
+
     func present() {
         isPresented = true
     }
@@ -67,18 +118,92 @@ final class TerminalSearch: ObservableObject {
     func updateLines(_ lines: [String]) {
         self.lines = lines
         refreshMatches()
+        scheduleHistorySearch(restart: false)
+    }
+
+    /// Search `sessionID`'s scrollback through `source`, or stop searching
+    /// history when `sessionID` is nil. Re-attaching the same session keeps
+    /// the current results.
+    func attachHistory(sessionID: UUID?, source: @escaping @MainActor () async -> ScrollbackBuffer?) {
+        guard sessionID != historySessionID else { return }
+        historySessionID = sessionID
+        historySource = sessionID == nil ? nil : source
+        historyEngine = ScrollbackSearchEngine()
+        scheduleHistorySearch(restart: true)
+        refreshFoldedMatches()
+    }
+
+    /// Count matches in folded output through `source`, or stop when nil.
+    /// Call before `attachHistory`, which starts the count for a new session.
+    func attachFoldedOutput(source: (@MainActor (ScrollbackSearchQuery) async -> Int)?) {
+        foldedSource = source
+    }
+
+    /// Count folded matches again, as after folds were expanded.
+    func refreshFoldedMatches() {
+        foldedTask?.cancel()
+        guard let foldedSource, !query.isEmpty, validationError == nil else {
+            foldedTask = nil
+            foldedMatchCount = 0
+            return
+        }
+        let searchQuery = ScrollbackSearchQuery(
+            text: query,
+            isRegex: isRegexEnabled,
+            isCaseSensitive: isCaseSensitive
+        )
+        foldedTask = Task { [weak self] in
+            let count = await foldedSource(searchQuery)
+            guard !Task.isCancelled, let self else { return }
+            self.foldedMatchCount = count
+            self.foldedTask = nil
+        }
     }
 
     func selectNextMatch() {
-        guard !matches.isEmpty else { return }
-        let next = ((selectedMatchIndex ?? -1) + 1) % matches.count
-        selectedMatchIndex = next
+        guard !historyMatches.isEmpty else {
+            guard !matches.isEmpty else { return }
+            let next = ((selectedMatchIndex ?? -1) + 1) % matches.count
+            selectedMatchIndex = next
+            return
+        }
+        let total = historyMatches.count + matches.count
+        select(position: ((selectedPosition ?? -1) + 1) % total)
     }
 
     func selectPreviousMatch() {
-        guard !matches.isEmpty else { return }
-        let previous = ((selectedMatchIndex ?? matches.count) - 1 + matches.count) % matches.count
-        selectedMatchIndex = previous
+        guard !historyMatches.isEmpty else {
+            guard !matches.isEmpty else { return }
+            let previous = ((selectedMatchIndex ?? matches.count) - 1 + matches.count) % matches.count
+            selectedMatchIndex = previous
+            return
+        }
+        let total = historyMatches.count + matches.count
+        select(position: ((selectedPosition ?? total) - 1 + total) % total)
+    }
+
+    /// The scroll offset (lines above the bottom) that puts `match`'s line
+    /// at the top of the viewport.
+    func scrollOffset(for match: ScrollbackSearchMatch) -> Int {
+        max(historyLineCount - (match.lineID - historyFirstLineID), 0)
+    }
+
+    /// Index into history matches followed by screen matches.
+    private var selectedPosition: Int? {
+        if let selectedHistoryMatchIndex {
+            return selectedHistoryMatchIndex
+        }
+        return selectedMatchIndex.map { historyMatches.count + $0 }
+    }
+
+    private func select(position: Int) {
+        if position < historyMatches.count {
+            selectedHistoryMatchIndex = position
+            selectedMatchIndex = nil
+        } else {
+            selectedHistoryMatchIndex = nil
+            selectedMatchIndex = position - historyMatches.count
+        }
     }
 
     func matches(forLineIndex lineIndex: Int) -> [TerminalSearchMatch] {
@@ -106,6 +231,12 @@ final class TerminalSearch: ObservableObject {
         matches.filter { isMatchValid($0, in: currentLines) }
     }
 
+    private func refreshAll() {
+        refreshMatches()
+        scheduleHistorySearch(restart: true)
+        refreshFoldedMatches()
+    }
+
     private func refreshMatches() {
         let previousSelection = selectedMatch
         matches.removeAll(keepingCapacity: true)
@@ -164,7 +295,7 @@ final class TerminalSearch: ObservableObject {
         if let previousSelection,
            let restoredIndex = matches.firstIndex(of: previousSelection) {
             selectedMatchIndex = restoredIndex
-        } else {
+        } else if selectedHistoryMatchIndex == nil {
             selectedMatchIndex = 0
         }
     }
@@ -173,4 +304,89 @@ final class TerminalSearch: ObservableObject {
         matches.append(match)
         matchesByLineIndex[match.lineIndex, default: []].append(match)
     }
+
+    // MARK: - History
+
+    /// Search scrollback for the current query. With `restart`, a running
+    /// search is abandoned; otherwise new output is picked up incrementally
+    /// once the running pass finishes.
+    private func scheduleHistorySearch(restart: Bool) {
+        if restart {
+            historyTask?.cancel()
+            historyTask = nil
+            historyRefreshPending = false
+        } else if historyTask != nil {
+            historyRefreshPending = true
+            return
+        }
+
+        guard let historySource, !query.isEmpty, validationError == nil else {
+            historyTask?.cancel()
+            historyTask = nil
+            isSearchingHistory = false
+            if !historyMatches.isEmpty {
+                historyMatches.removeAll()
+            }
+            selectedHistoryMatchIndex = nil
+            return
+        }
+
+        let searchQuery = ScrollbackSearchQuery(
+            text: query,
+            isRegex: isRegexEnabled,
+            isCaseSensitive: isCaseSensitive
+        )
+        let engine = historyEngine
+        historyGeneration &+= 1
+        let generation = historyGeneration
+        isSearchingHistory = true
+        historyTask = Task { [weak self] in
+            repeat {
+                self?.historyRefreshPending = false
+                guard let scrollback = await historySource(), !Task.isCancelled else { break }
+                let (updates, continuation) = AsyncStream.makeStream(of: ScrollbackSearchEngine.Update.self)
+                await withTaskGroup(of: Void.self) { group in
+                    group.addTask {
+                        defer { continuation.finish() }
+                        // Regex errors are already reported by the screen search.
+                        try? await engine.search(scrollback, query: searchQuery) { update in
+                            continuation.yield(update)
+                        }
+                    }
+                    for await update in updates where !Task.isCancelled {
+                        self?.applyHistory(update)
+                    }
+                }
+            } while !Task.isCancelled && self?.historyRefreshPending == true
+
+            guard let self, self.historyGeneration == generation else { return }
+            self.historyTask = nil
+            self.isSearchingHistory = false
+        }
+    }
+
+    private func applyHistory(_ update: ScrollbackSearchEngine.Update) {
+        let selected = selectedHistoryMatch
+        if update.reset {
+            historyMatches.removeAll(keepingCapacity: true)
+        }
+        let evicted = historyMatches.prefix { $0.lineID < update.firstLineID }.count
+        if evicted > 0 {
+            historyMatches.removeFirst(evicted)
+        }
+        if !update.matches.isEmpty {
+            historyMatches.append(contentsOf: update.matches)
+        }
+        historyFirstLineID = update.firstLineID
+        historyLineCount = update.lineCount
+
+        guard let selected else { return }
+        if update.reset {
+            selectedHistoryMatchIndex = historyMatches.firstIndex(of: selected)
+        } else if selected.lineID < update.firstLineID {
+            selectedHistoryMatchIndex = nil
+        } else if let index = selectedHistoryMatchIndex {
+            selectedHistoryMatchIndex = index - evicted
+        }
+    }
 }
@@ -0,0 +1,143 @@
+// TmuxLayout.swift
+// ProSSHV2
+//
+// tmux window layouts, as control mode reports them in `%layout-change`
+// and `#{window_layout}`: a checksum, then a tree of cells. Each cell is
+// `WxH,X,Y` followed by `,<pane id>` for a pane, `{...}` for children
+// side by side or `[...]` for children stacked top to bottom, e.g.
+// `b25f,80x24,0,0{40x24,0,0,1,39x24,41,0,2}`.
+//
+// The tree maps onto SplitNode so a control mode window shows as native
+// splits, one pane per tmux pane, with split ratios from the cell sizes.
+
+import Foundation
+
+// MARK: - TmuxLayout
+
+nonisolated indirect enum TmuxLayout: Equatable, Sendable {
+    case pane(id: Int, columns: Int, rows: Int)
+    /// Children left to right.
+    case sideBySide(columns: Int, rows: Int, [TmuxLayout])
+    /// Children top to bottom.
+    case stacked(columns: Int, rows: Int, [TmuxLayout])
+
+    var columns: Int {
+        switch self {
+        case .pane(_, let columns, _), .sideBySide(let columns, _, _), .stacked(let columns, _, _):
+            return columns
+        }
+    }
+
+    var rows: Int {
+        switch self {
+        case .pane(_, _, let rows), .sideBySide(_, let rows, _), .stacked(_, let rows, _):
+            return rows
+        }
+    }
+
+    /// Pane IDs with their sizes, in layout order.
+    var panes: [(id: Int, columns: Int, rows: Int)] {
+        switch self {
+        case let .pane(id, columns, rows):
+            return [(id, columns, rows)]
+        case .sideBySide(_, _, let children), .stacked(_, _, let children):
+            return children.flatMap(\.panes)
+        }
+    }
+
+    /// The tree as splits; `pane` supplies the native pane for a tmux pane ID.
+    func splitNode(pane: (Int) -> TerminalPane) -> SplitNode {
+        switch self {
+        case let .pane(id, _, _):
+            return .terminal(pane(id))
+        case .sideBySide(_, _, let children):
+            return Self.splitNode(children[...], direction: .vertical, size: \.columns, pane: pane)
+        case .stacked(_, _, let children):
+            return Self.splitNode(children[...], direction: .horizontal, size: \.rows, pane: pane)
+        }
+    }
+
+    /// Nests n children as binary splits: the first against the rest.
+    private static func splitNode(
+        _ children: ArraySlice<TmuxLayout>,
+        direction: SplitDirection,
+        size: KeyPath<TmuxLayout, Int>,
+        pane: (Int) -> TerminalPane
+    ) -> SplitNode {
+        guard let first = children.first else { return .terminal(pane(-1)) }
+        let rest = children.dropFirst()
+        guard !rest.isEmpty else { return first.splitNode(pane: pane) }
+        let total = children.reduce(0) { $0 + $1[keyPath: size] }
+        let ratio = total > 0 ? CGFloat(first[keyPath: size]) / CGFloat(total) : 0.5
+        return .split(SplitContainer(
+            direction: direction,
+            ratio: min(max(ratio, 0.1), 0.9),
+            first: first.splitNode(pane: pane),
+            second: splitNode(rest, direction: direction, size: size, pane: pane)
+        ))
+    }
+}
+
+// MARK: - Parsing
+
+nonisolated extension TmuxLayout {
+
+    /// Parses a layout string, with or without its checksum.
+    init?(parsing text: String) {
+        var bytes = Array(text.utf8)[...]
+        // The checksum is four hex digits and a comma before the first cell.
+        if let comma = bytes.firstIndex(of: 0x2C), let x = bytes.firstIndex(of: 0x78), comma < x {
+            bytes = bytes[(comma + 1)...]
+        }
+        guard let layout = Self.parseCell(&bytes), bytes.isEmpty else { return nil }
+        self = layout
+    }
+
+    private static func parseCell(_ bytes: inout ArraySlice<UInt8>) -> TmuxLayout? {
+        guard let columns = parseNumber(&bytes), consume(0x78, from: &bytes), // 'x'
+              let rows = parseNumber(&bytes), consume(0x2C, from: &bytes),
+              parseNumber(&bytes) != nil, consume(0x2C, from: &bytes),
+              parseNumber(&bytes) != nil else { return nil }
+
+        switch bytes.first {
+        case 0x2C: // ',' pane ID, unless another cell follows in a list
+            var lookahead = bytes.dropFirst()
+            if let id = parseNumber(&lookahead), lookahead.first != 0x78 {
+                bytes = lookahead
+                return .pane(id: id, columns: columns, rows: rows)
+            }
+            return nil
+        case 0x7B, 0x5B: // '{' or '['
+            let opener = bytes.removeFirst()
+            let closer: UInt8 = opener == 0x7B ? 0x7D : 0x5D
+            var children: [TmuxLayout] = []
+            repeat {
+                guard let child = parseCell(&bytes) else { return nil }
+                children.append(child)
+            } while consume(0x2C, from: &bytes)
+            guard consume(closer, from: &bytes), !children.isEmpty else { return nil }
+            return opener == 0x7B
+                ? .sideBySide(columns: columns, rows: rows, children)
+                : .stacked(columns: columns, rows: rows, children)
+        default:
+            return nil
+        }
+    }
+
+    private static func parseNumber(_ bytes: inout ArraySlice<UInt8>) -> Int? {
+        var value = 0
+        var digits = 0
+        while let byte = bytes.first, (0x30...0x39).contains(byte) {
+            value = value &* 10 &+ Int(byte - 0x30)
+            digits += 1
+            bytes.removeFirst()
+        }
+        return digits > 0 ? value : nil
+    }
+
+    private static func consume(_ byte: UInt8, from bytes: inout ArraySlice<UInt8>) -> Bool {
+        guard bytes.first == byte else { return false }
+        bytes.removeFirst()
+        return true
+    }
+}
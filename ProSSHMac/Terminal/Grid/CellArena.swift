@@ -0,0 +1,185 @@
+// CellArena.swift
+// ProSSHV2
+//
+// Flat storage for one screen buffer: rows × columns cells in a single
+// contiguous allocation, addressed by physical row. The grid's ring base
+// and row map still decide which physical row holds which logical line, so
+// scrolling stays an index rotation; row copies and character shifts are
+// plain memmoves.
+//
+// Replaces `[[TerminalCell]]`, where every row was its own heap object with
+// its own refcount and copy-on-write check, and every read went through two
+// bounds-checked subscripts.
+//
+// Value semantics are kept by hand. Copies share storage (background resize,
+// snapshot locals) until one of them writes, which duplicates the cells.
+
+import Foundation
+
+// MARK: - CellArena
+
+nonisolated struct CellArena: @unchecked Sendable {
+
+    fileprivate final class Storage {
+        let cells: UnsafeMutablePointer<TerminalCell>
+        let count: Int
+
+        init(count: Int, repeating cell: TerminalCell) {
+            cells = .allocate(capacity: max(count, 1))
+            cells.initialize(repeating: cell, count: count)
+            self.count = count
+        }
+
+        init(copying other: Storage) {
+            cells = .allocate(capacity: max(other.count, 1))
+            cells.initialize(from: other.cells, count: other.count)
+            count = other.count
+        }
+
+        deinit {
+            cells.deinitialize(count: count)
+            cells.deallocate()
+        }
+    }
+
+    /// Number of rows.
+    let count: Int
+    let columns: Int
+    private var storage: Storage
+
+    init(rows: Int, columns: Int, repeating cell: TerminalCell = .blank) {
+        self.count = max(rows, 0)
+        self.columns = max(columns, 0)
+        self.storage = Storage(count: self.count * self.columns, repeating: cell)
+    }
+
+    /// Build from row arrays, padding or trimming each to `columns`.
+    init(_ rowCells: [[TerminalCell]], columns: Int) {
+        self.init(rows: rowCells.count, columns: columns)
+        for (row, cells) in rowCells.enumerated() {
+            copyIn(cells, row: row)
+        }
+    }
+
+    // MARK: - Reading
+
+    /// Read-only view of one physical row.
+    @inline(__always)
+    subscript(row: Int) -> CellRow {
+        assert(row >= 0 && row < count, "row out of range")
+        return CellRow(owner: storage, base: storage.cells + row * columns, count: columns)
+    }
+
+    /// Every row as an array, in physical order.
+    var rowArrays: [[TerminalCell]] {
+        (0..<count).map { Array(self[$0]) }
+    }
+
+    // MARK: - Writing
+
+    @inline(__always)
+    subscript(row: Int, col: Int) -> TerminalCell {
+        get {
+            assert(row >= 0 && row < count && col >= 0 && col < columns, "cell out of range")
+            return storage.cells[row * columns + col]
+        }
+        set {
+            assert(row >= 0 && row < count && col >= 0 && col < columns, "cell out of range")
+            makeUnique()
+            storage.cells[row * columns + col] = newValue
+        }
+    }
+
+    /// Overwrite a row, padding with blanks or trimming to `columns`.
+    mutating func replaceRow(_ row: Int, with cells: [TerminalCell]) {
+        makeUnique()
+        copyIn(cells, row: row)
+    }
+
+    /// Set every cell of a row to `cell`.
+    mutating func fillRow(_ row: Int, with cell: TerminalCell) {
+        makeUnique()
+        (storage.cells + row * columns).update(repeating: cell, count: columns)
+    }
+
+    /// Copy one physical row over another.
+    mutating func copyRow(_ source: Int, to destination: Int) {
+        guard source != destination else { return }
+        makeUnique()
+        (storage.cells + destination * columns).update(from: storage.cells + source * columns, count: columns)
+    }
+
+    /// Move `length` cells within a row; the ranges may overlap.
+    mutating func moveCells(inRow row: Int, from source: Int, to destination: Int, count length: Int) {
+        guard length > 0, source != destination else { return }
+        makeUnique()
+        let rowStart = UnsafeMutableRawPointer(storage.cells + row * columns)
+        let stride = MemoryLayout<TerminalCell>.stride
+        (rowStart + destination * stride).copyMemory(from: rowStart + source * stride, byteCount: length * stride)
+    }
+
+    /// Direct access to every cell, row-major, for loops that touch many
+    /// cells at once.
+    mutating func withUnsafeMutableCells<R>(_ body: (UnsafeMutableBufferPointer<TerminalCell>) throws -> R) rethrows -> R {
+        makeUnique()
+        return try body(UnsafeMutableBufferPointer(start: storage.cells, count: storage.count))
+    }
+
+    // MARK: - Private
+
+    @inline(__always)
+    private mutating func makeUnique() {
+        if !isKnownUniquelyReferenced(&storage) {
+            storage = Storage(copying: storage)
+        }
+    }
+
+    private func copyIn(_ cells: [TerminalCell], row: Int) {
+        let start = storage.cells + row * columns
+        let copied = min(cells.count, columns)
+        cells.withUnsafeBufferPointer { source in
+            if let base = source.baseAddress {
+                start.update(from: base, count: copied)
+            }
+        }
+        if copied < columns {
+            (start + copied).update(repeating: .blank, count: columns - copied)
+        }
+    }
+}
+
+// MARK: - CellRow
+
+/// A row of a `CellArena`. Keeps the arena's storage alive, so it stays
+/// valid, but holding one across a write to the arena forces that write
+/// to copy the whole buffer.
+nonisolated struct CellRow: RandomAccessCollection, @unchecked Sendable {
+    private let owner: AnyObject
+    private let base: UnsafePointer<TerminalCell>
+    let count: Int
+
+    fileprivate init(owner: AnyObject, base: UnsafeMutablePointer<TerminalCell>, count: Int) {
+        self.owner = owner
+        self.base = UnsafePointer(base)
+        self.count = count
+    }
+
+    var startIndex: Int { 0 }
+    var endIndex: Int { count }
+
+    @inline(__always)
+    subscript(col: Int) -> TerminalCell {
+        assert(col >= 0 && col < count, "column out of range")
+        return base[col]
+    }
+
+    /// The row is one contiguous span of the arena, so bulk copies (compact
+    /// snapshots) can move it with a single memcpy.
+    func withContiguousStorageIfAvailable<R>(
+        _ body: (UnsafeBufferPointer<TerminalCell>) throws -> R
+    ) rethrows -> R? {
+        try withExtendedLifetime(owner) {
+            try body(UnsafeBufferPointer(start: base, count: count))
+        }
+    }
+}
@@ -7,13 +7,25 @@
 //
 // Classification rules (matching standard terminal behavior — xterm, iTerm2, VTE):
 // - East Asian Width "W" (Wide) or "F" (Fullwidth) → 2 cells
-// - East Asian Width "A" (Ambiguous) → 1 cell (narrow by default)
+// - East Asian Width "A" (Ambiguous) → 1 cell (narrow by default, see
+//   `Configuration.ambiguousWidth`)
 // - Only emoji/symbol codepoints widely treated as width=2 in modern
 //   terminal wcwidth implementations are marked wide
 // - Everything else → 1 cell
 //
 // This is the single source of truth for width determination. Both
 // Character.isWideCharacter (TerminalGrid) and GlyphRasterizer delegate here.
+//
+// `cellWidth(_:)` adds zero-width classification (combining marks, variation
+// selectors, ZWJ, emoji modifiers) for the bulk print path.
+//
+// Both answer from a two-stage table (`Table`) in two memory loads: a block
+// index with one entry per 256 codepoints, then a deduplicated 64-byte page
+// of 2-bit width classes. Most blocks share a handful of pages (all narrow,
+// all wide, unassigned), so the whole range up to U+10FFFF takes tens of
+// KiB rather than a byte per codepoint. The table is generated once, on first use, from the range
+// classifier below, for a `Configuration`: the ambiguous-width policy and
+// optionally the Unicode version the remote side's wcwidth knows.
 
 import Foundation
 
@@ -26,6 +38,149 @@ nonisolated enum CharacterWidth {
     /// Returns true if the given Unicode scalar should occupy 2 terminal cells.
     @inline(__always)
     static func isWide(_ scalar: UnicodeScalar) -> Bool {
+        table.width(scalar.value) == 2
+    }
+
+    /// Cell width of a printable codepoint: 0 for scalars that attach to the
+    /// previous cell's grapheme, 2 for wide, otherwise 1.
+    @inline(__always)
+    static func cellWidth(_ value: UInt32) -> UInt8 {
+        table.width(value)
+    }
+
+    /// The table `isWide` and `cellWidth` read, built for
+    /// `Configuration.current` on first use.
+    static let table = Table(configuration: .current)
+
+    // MARK: - Configuration
+
+    struct Configuration: Sendable {
+        enum AmbiguousWidth: Sendable {
+            /// East Asian Width "A" codepoints take one cell (xterm default).
+            case narrow
+            /// Two cells, as CJK locales with `wcwidth_cjk` expect.
+            case wide
+        }
+
+        var ambiguousWidth: AmbiguousWidth = .narrow
+        /// Scalars assigned after this version are narrow, as an older
+        /// wcwidth on the remote side counts them. Nil uses the runtime's
+        /// Unicode data.
+        var unicodeVersion: Unicode.Version?
+
+        static let standard = Configuration()
+
+        /// The standard configuration, with ambiguous-width codepoints wide
+        /// when the user asked for it.
+        /// Toggle via: `defaults write com.prossh terminal.width.ambiguousWide -bool true`
+        static var current: Configuration {
+            var configuration = Configuration.standard
+            if UserDefaults.standard.bool(forKey: "terminal.width.ambiguousWide") {
+                configuration.ambiguousWidth = .wide
+            }
+            return configuration
+        }
+    }
+
+    // MARK: - Table
+
+    /// Two-stage width table over U+0000...U+10FFFF.
+    struct Table: Sendable {
+        static let blockShift: UInt32 = 8
+        /// Bytes per page: 256 codepoints at 2 bits each.
+        static let pageBytes = 64
+        private static let codepointLimit: UInt32 = 0x110000
+
+        /// Page number for each 256-codepoint block.
+        private let blocks: [UInt16]
+        /// Pages back to back; codepoint `c` of a page is bits
+        /// `2 * (c % 4)` of byte `c / 4`.
+        private let pages: [UInt8]
+
+        var pageCount: Int { pages.count / Self.pageBytes }
+
+        init(configuration: Configuration = .standard) {
+            let blockCount = Int(Self.codepointLimit >> Self.blockShift)
+            var blocks: [UInt16] = []
+            blocks.reserveCapacity(blockCount)
+            var pages: [UInt8] = []
+            var pageNumbers: [[UInt8]: UInt16] = [:]
+            var page = [UInt8](repeating: 0, count: Self.pageBytes)
+
+            for block in 0..<UInt32(blockCount) {
+                let base = block << Self.blockShift
+                if let uniform = CharacterWidth.uniformWidth(ofBlockAt: base, configuration) {
+                    let byte = uniform | uniform << 2 | uniform << 4 | uniform << 6
+                    page = [UInt8](repeating: byte, count: Self.pageBytes)
+                } else {
+                    for index in 0..<Self.pageBytes {
+                        var byte: UInt8 = 0
+                        for slot in 0..<4 {
+                            let value = base + UInt32(index * 4 + slot)
+                            byte |= CharacterWidth.classify(value, configuration) << (slot * 2)
+                        }
+                        page[index] = byte
+                    }
+                }
+                if let number = pageNumbers[page] {
+                    blocks.append(number)
+                } else {
+                    let number = UInt16(pageNumbers.count)
+                    pageNumbers[page] = number
+                    pages.append(contentsOf: page)
+                    blocks.append(number)
+                }
+            }
+            self.blocks = blocks
+            self.pages = pages
+        }
+
+        /// Cell width (0, 1 or 2) of `value`; 1 past U+10FFFF.
+        @inline(__always)
+        func width(_ value: UInt32) -> UInt8 {
+            guard value < Self.codepointLimit else { return 1 }
+            let page = Int(blocks[Int(value >> Self.blockShift)])
+            let byte = pages[page &* Self.pageBytes &+ Int((value & 0xFF) >> 2)]
+            return (byte >> ((value & 3) << 1)) & 3
+        }
+    }
+
+    // MARK: - Classification
+
+    /// The width every codepoint of the block at `base` has, for blocks
+    /// that need no per-codepoint classification: planes 4–13 and the
+    /// unassigned rest of plane 14 are narrow, and the private-use planes
+    /// follow the ambiguous policy.
+    private static func uniformWidth(ofBlockAt base: UInt32, _ configuration: Configuration) -> UInt8? {
+        switch base {
+        case 0x40000..<0xE0000, 0xE1000..<0xF0000:
+            return 1
+        case 0xF0000..<0x110000:
+            return configuration.ambiguousWidth == .wide ? 2 : 1
+        default:
+            return nil
+        }
+    }
+
+    /// Width of one codepoint under `configuration`. Zero-width wins over
+    /// the ambiguous policy, which applies only to otherwise narrow
+    /// codepoints.
+    private static func classify(_ value: UInt32, _ configuration: Configuration) -> UInt8 {
+        // Nothing below U+00A1 is wide, ambiguous or combining.
+        if value < 0x00A1 { return 1 }
+        if let version = configuration.unicodeVersion, let scalar = UnicodeScalar(value) {
+            guard let age = scalar.properties.age,
+                  (age.major, age.minor) <= (version.major, version.minor) else { return 1 }
+        }
+        let width = computeCellWidth(value)
+        if width == 1, configuration.ambiguousWidth == .wide, isAmbiguous(value) {
+            return 2
+        }
+        return width
+    }
+
+    /// Range classifier the table is generated from.
+    private static func rangeIsWide(_ scalar: UnicodeScalar) -> Bool {
         let v = scalar.value
 
         // Fast path: ASCII, Latin-1, and most BMP characters below CJK are narrow.
@@ -123,6 +278,18 @@ nonisolated enum CharacterWidth {
         return false
     }
 
+    private static func computeCellWidth(_ value: UInt32) -> UInt8 {
+        guard let scalar = UnicodeScalar(value) else { return 1 }
+        // ZWJ and Fitzpatrick skin-tone modifiers join the preceding emoji.
+        if value == 0x200D || (0x1F3FB...0x1F3FF).contains(value) { return 0 }
+        switch scalar.properties.generalCategory {
+        case .nonspacingMark, .enclosingMark:
+            return 0
+        default:
+            return rangeIsWide(scalar) ? 2 : 1
+        }
+    }
+
     // MARK: - wcwidth-Wide in Misc Symbols & Dingbats (U+2600–U+27BF)
 
     /// Sorted array of codepoints in U+2600..U+27BF that are width=2 in
@@ -157,6 +324,86 @@ nonisolated enum CharacterWidth {
         0x27BF,                                  // ➿
     ]
 
+    // MARK: - East Asian Ambiguous Width
+
+    /// East Asian Width "A" codepoints outside the private-use planes, as
+    /// sorted inclusive (lower, upper) pairs. Combining marks in the "A"
+    /// class are left out; they stay zero-width under either policy.
+    private static let ambiguousRanges: [UInt32] = [
+        // Latin-1 symbols and letters
+        0x00A1, 0x00A1, 0x00A4, 0x00A4, 0x00A7, 0x00A8, 0x00AA, 0x00AA,
+        0x00AD, 0x00AE, 0x00B0, 0x00B4, 0x00B6, 0x00BA, 0x00BC, 0x00BF,
+        0x00C6, 0x00C6, 0x00D0, 0x00D0, 0x00D7, 0x00D8, 0x00DE, 0x00E1,
+        0x00E6, 0x00E6, 0x00E8, 0x00EA, 0x00EC, 0x00ED, 0x00F0, 0x00F0,
+        0x00F2, 0x00F3, 0x00F7, 0x00FA, 0x00FC, 0x00FC, 0x00FE, 0x00FE,
+        // Latin Extended-A/B
+        0x0101, 0x0101, 0x0111, 0x0111, 0x0113, 0x0113, 0x011B, 0x011B,
+        0x0126, 0x0127, 0x012B, 0x012B, 0x0131, 0x0133, 0x0138, 0x0138,
+        0x013F, 0x0142, 0x0144, 0x0144, 0x0148, 0x014B, 0x014D, 0x014D,
+        0x0152, 0x0153, 0x0166, 0x0167, 0x016B, 0x016B, 0x01CE, 0x01CE,
+        0x01D0, 0x01D0, 0x01D2, 0x01D2, 0x01D4, 0x01D4, 0x01D6, 0x01D6,
+        0x01D8, 0x01D8, 0x01DA, 0x01DA, 0x01DC, 0x01DC,
+        // IPA and spacing modifiers
+        0x0251, 0x0251, 0x0261, 0x0261, 0x02C4, 0x02C4, 0x02C7, 0x02C7,
+        0x02C9, 0x02CB, 0x02CD, 0x02CD, 0x02D0, 0x02D0, 0x02D8, 0x02DB,
+        0x02DD, 0x02DD, 0x02DF, 0x02DF,
+        // Greek and Cyrillic
+        0x0391, 0x03A1, 0x03A3, 0x03A9, 0x03B1, 0x03C1, 0x03C3, 0x03C9,
+        0x0401, 0x0401, 0x0410, 0x044F, 0x0451, 0x0451,
+        // General Punctuation, super/subscripts, euro
+        0x2010, 0x2010, 0x2013, 0x2016, 0x2018, 0x2019, 0x201C, 0x201D,
+        0x2020, 0x2022, 0x2024, 0x2027, 0x2030, 0x2030, 0x2032, 0x2033,
+        0x2035, 0x2035, 0x203B, 0x203B, 0x203E, 0x203E, 0x2074, 0x2074,
+        0x207F, 0x207F, 0x2081, 0x2084, 0x20AC, 0x20AC,
+        // Letterlike symbols, number forms
+        0x2103, 0x2103, 0x2105, 0x2105, 0x2109, 0x2109, 0x2113, 0x2113,
+        0x2116, 0x2116, 0x2121, 0x2122, 0x2126, 0x2126, 0x212B, 0x212B,
+        0x2153, 0x2154, 0x215B, 0x215E, 0x2160, 0x216B, 0x2170, 0x2179,
+        0x2189, 0x2189,
+        // Arrows
+        0x2190, 0x2199, 0x21B8, 0x21B9, 0x21D2, 0x21D2, 0x21D4, 0x21D4,
+        0x21E7, 0x21E7,
+        // Mathematical operators
+        0x2200, 0x2200, 0x2202, 0x2203, 0x2207, 0x2208, 0x220B, 0x220B,
+        0x220F, 0x220F, 0x2211, 0x2211, 0x2215, 0x2215, 0x221A, 0x221A,
+        0x221D, 0x2220, 0x2223, 0x2223, 0x2225, 0x2225, 0x2227, 0x222C,
+        0x222E, 0x222E, 0x2234, 0x2237, 0x223C, 0x223D, 0x2248, 0x2248,
+        0x224C, 0x224C, 0x2252, 0x2252, 0x2260, 0x2261, 0x2264, 0x2267,
+        0x226A, 0x226B, 0x226E, 0x226F, 0x2282, 0x2283, 0x2286, 0x2287,
+        0x2295, 0x2295, 0x2299, 0x2299, 0x22A5, 0x22A5, 0x22BF, 0x22BF,
+        0x2312, 0x2312,
+        // Enclosed alphanumerics, box drawing, blocks, geometric shapes
+        0x2460, 0x24E9, 0x24EB, 0x254B, 0x2550, 0x2573, 0x2580, 0x258F,
+        0x2592, 0x2595, 0x25A0, 0x25A1, 0x25A3, 0x25A9, 0x25B2, 0x25B3,
+        0x25B6, 0x25B7, 0x25BC, 0x25BD, 0x25C0, 0x25C1, 0x25C6, 0x25C8,
+        0x25CB, 0x25CB, 0x25CE, 0x25D1, 0x25E2, 0x25E5, 0x25EF, 0x25EF,
+        // Misc Symbols
+        0x2605, 0x2606, 0x2609, 0x2609, 0x260E, 0x260F, 0x261C, 0x261C,
+        0x261E, 0x261E, 0x2640, 0x2640, 0x2642, 0x2642, 0x2660, 0x2661,
+        0x2663, 0x2665, 0x2667, 0x266A, 0x266C, 0x266D, 0x266F, 0x266F,
+        0x269E, 0x269F, 0x26BF, 0x26BF, 0x26C6, 0x26CD, 0x26CF, 0x26D3,
+        0x26D5, 0x26E1, 0x26E3, 0x26E3, 0x26E8, 0x26E9, 0x26EB, 0x26F1,
+        0x26F4, 0x26F4, 0x26F6, 0x26F9, 0x26FB, 0x26FC, 0x26FE, 0x26FF,
+        // Dingbats, Misc Symbols and Arrows, circled numbers, private use, replacement
+        0x273D, 0x273D, 0x2776, 0x277F, 0x2B56, 0x2B59, 0x3248, 0x324F,
+        0xE000, 0xF8FF, 0xFFFD, 0xFFFD,
+        // Enclosed Alphanumeric Supplement
+        0x1F100, 0x1F10A, 0x1F110, 0x1F12D, 0x1F130, 0x1F169, 0x1F170, 0x1F18D,
+        0x1F18F, 0x1F190, 0x1F19B, 0x1F1AC,
+    ]
+
+    private static func isAmbiguous(_ value: UInt32) -> Bool {
+        var lo = 0
+        var hi = ambiguousRanges.count / 2 - 1
+        while lo <= hi {
+            let mid = (lo + hi) >> 1
+            if value < ambiguousRanges[mid * 2] { hi = mid - 1 }
+            else if value > ambiguousRanges[mid * 2 + 1] { lo = mid + 1 }
+            else { return true }
+        }
+        return false
+    }
+
     // MARK: - Binary Search
 
     /// Binary search a sorted UInt32 array. Returns true if value is found.
@@ -0,0 +1,188 @@
+// CommandOutputFoldStore.swift
+// ProSSHV2
+//
+// Output of finished commands taken out of scrollback. A folded output
+// leaves a one-line summary row in its place (line count, exit status,
+// duration), and its lines move into a ScrollbackBuffer of their own that
+// is compacted right away, so they are compressed and, past the resident
+// page limit, spilled to disk. Snapshots, reflow, viewport scrolling and
+// scrollback search then only see the summary row; expanding puts the
+// lines back (see TerminalGrid+CommandFolding).
+//
+// Summary rows are found by their text: the row starts with
+// `CommandOutputFoldStore.marker` and the fold's ID, so a fold survives
+// reflow and the line renumbering that follows every scrollback rewrite.
+// Folded lines stay searchable and copyable through the store. Folds past
+// `maxBytes` of resident storage are dropped oldest first; their summary
+// row stays behind and no longer expands.
+
+import Foundation
+
+// MARK: - CommandOutputFold
+
+nonisolated struct CommandOutputFold: Identifiable, Sendable {
+
+    /// What the summary row says about the command.
+    nonisolated struct Summary: Sendable, Equatable {
+        var command: String
+        var exitCode: Int?
+        var duration: TimeInterval?
+
+        init(command: String = "", exitCode: Int? = nil, duration: TimeInterval? = nil) {
+            self.command = command
+            self.exitCode = exitCode
+            self.duration = duration
+        }
+    }
+
+    let id: Int
+    let summary: Summary
+    /// The folded lines, oldest first, compacted.
+    let lines: ScrollbackBuffer
+    /// Width the lines were wrapped for when folded.
+    let columns: Int
+
+    var lineCount: Int { lines.count }
+
+    /// Text of the summary row.
+    var summaryText: String {
+        var text = "\(CommandOutputFoldStore.marker) #\(id) \u{00B7} \(lineCount) \(lineCount == 1 ? "line" : "lines") folded"
+        if let exitCode = summary.exitCode {
+            text += " \u{00B7} exit \(exitCode)"
+        }
+        if let duration = summary.duration {
+            text += " \u{00B7} \(Self.format(duration))"
+        }
+        let command = summary.command.trimmingCharacters(in: .whitespacesAndNewlines)
+        if !command.isEmpty {
+            text += " \u{00B7} \(command.replacingOccurrences(of: "\n", with: " "))"
+        }
+        return text
+    }
+
+    /// The folded lines as text, one per logical line.
+    var text: String {
+        let data = TerminalTextExport(scrollback: lines, screenRows: []).utf8Data()
+        return String(decoding: data, as: UTF8.self).trimmingCharacters(in: .newlines)
+    }
+
+    private static func format(_ duration: TimeInterval) -> String {
+        guard duration >= 60 else {
+            return String(format: "%.1fs", max(duration, 0))
+        }
+        let seconds = Int(duration.rounded())
+        guard seconds >= 3600 else {
+            return String(format: "%dm %02ds", seconds / 60, seconds % 60)
+        }
+        return String(format: "%dh %02dm", seconds / 3600, seconds % 3600 / 60)
+    }
+}
+
+// MARK: - CommandOutputFoldStore
+
+nonisolated struct CommandOutputFoldStore: Sendable {
+
+    /// First character of every summary row.
+    static let marker: Character = "\u{25B8}"
+    static let markerScalar: UInt32 = 0x25B8
+
+    /// Resident bytes kept across folds before the oldest are dropped.
+    static let defaultMaxBytes = 64 << 20
+
+    let maxBytes: Int
+
+    /// Folds by ID; IDs only grow, so the smallest is the oldest.
+    private(set) var folds: [Int: CommandOutputFold] = [:]
+    private var nextID = 1
+
+    init(maxBytes: Int = CommandOutputFoldStore.defaultMaxBytes) {
+        self.maxBytes = max(maxBytes, 0)
+    }
+
+    var isEmpty: Bool { folds.isEmpty }
+
+    /// Resident bytes held by the folded lines.
+    var estimatedMemoryBytes: Int {
+        folds.values.reduce(0) { $0 + $1.lines.estimatedMemoryBytes }
+    }
+
+    // MARK: - Storing
+
+    /// Store `lines` as a new fold and return it.
+    mutating func insert(
+        _ lines: [ScrollbackLine],
+        columns: Int,
+        summary: CommandOutputFold.Summary
+    ) -> CommandOutputFold {
+        var buffer = ScrollbackBuffer(maxLines: .max, maxBytes: .max, indexesText: true)
+        for line in lines {
+            buffer.push(line)
+        }
+        buffer.compact()
+        let fold = CommandOutputFold(id: nextID, summary: summary, lines: buffer, columns: columns)
+        nextID += 1
+        folds[fold.id] = fold
+        evictOverBudget()
+        return fold
+    }
+
+    /// Take fold `id` out of the store.
+    mutating func remove(_ id: Int) -> CommandOutputFold? {
+        folds.removeValue(forKey: id)
+    }
+
+    mutating func removeAll() {
+        folds.removeAll()
+    }
+
+    private mutating func evictOverBudget() {
+        var bytes = estimatedMemoryBytes
+        for id in folds.keys.sorted() where bytes > maxBytes && folds.count > 1 {
+            bytes -= folds.removeValue(forKey: id)?.lines.estimatedMemoryBytes ?? 0
+        }
+    }
+
+    // MARK: - Summary Rows
+
+    /// The fold whose summary row `line` is, if it is still stored.
+    func fold(summarizedBy line: ScrollbackLine) -> CommandOutputFold? {
+        Self.foldID(summarizedBy: line).flatMap { folds[$0] }
+    }
+
+    /// The ID in a summary row, read from its leading `marker #<id> `.
+    static func foldID(summarizedBy line: ScrollbackLine) -> Int? {
+        let codepoints = line.row.codepoints
+        guard codepoints.count >= 4, codepoints[0] == markerScalar,
+              codepoints[1] == 0x20, codepoints[2] == 0x23 else { return nil }
+        var id = 0
+        var col = 3
+        while col < codepoints.count, (0x30...0x39).contains(codepoints[col]), id < Int.max / 10 {
+            id = id * 10 + Int(codepoints[col] - 0x30)
+            col += 1
+        }
+        guard col > 3, col < codepoints.count, codepoints[col] == 0x20 else { return nil }
+        return id
+    }
+
+    /// Cells of the summary row for `fold`, cut to `columns`.
+    static func summaryCells(for fold: CommandOutputFold, columns: Int) -> [TerminalCell] {
+        var cells: [TerminalCell] = []
+        cells.reserveCapacity(columns)
+        for scalar in fold.summaryText.unicodeScalars {
+            let width = Int(CharacterWidth.cellWidth(scalar.value))
+            guard width > 0 else { continue }
+            guard cells.count + width <= columns else { break }
+            cells.append(TerminalCell(
+                codepoint: scalar.value, fgPacked: 0, bgPacked: 0, ulPacked: 0,
+                attributes: .dim, underlineStyle: .none, width: UInt8(width)
+            ))
+            if width == 2 {
+                cells.append(TerminalCell(
+                    codepoint: 0, fgPacked: 0, bgPacked: 0, ulPacked: 0,
+                    attributes: .dim, underlineStyle: .none, width: 0
+                ))
+            }
+        }
+        return cells
+    }
+}
@@ -0,0 +1,88 @@
+// DirtyRowSet.swift
+// ProSSHV2
+//
+// Per-row damage tracking for TerminalGrid. A single min...max range turns
+// a cursor blink on row 1 plus a status-line update on row 50 into a full
+// redraw; a bitmap keeps the two apart, and `runs` hands the snapshot one
+// range per contiguous block of changed rows.
+
+import Foundation
+
+nonisolated struct DirtyRowSet: Sendable {
+
+    private var words: [UInt64] = []
+
+    /// Lowest and highest dirty row (Int.max / -1 when empty).
+    private(set) var lowerBound = Int.max
+    private(set) var upperBound = -1
+
+    var isEmpty: Bool { upperBound < 0 }
+
+    @inline(__always)
+    mutating func insert(_ row: Int) {
+        guard row >= 0 else { return }
+        let word = row >> 6
+        if word >= words.count {
+            words.append(contentsOf: repeatElement(0, count: word - words.count + 1))
+        }
+        words[word] |= 1 << UInt64(row & 63)
+        lowerBound = min(lowerBound, row)
+        upperBound = max(upperBound, row)
+    }
+
+    mutating func insert(_ range: ClosedRange<Int>) {
+        let lower = max(range.lowerBound, 0)
+        guard lower <= range.upperBound else { return }
+        for row in lower...range.upperBound {
+            insert(row)
+        }
+    }
+
+    @inline(__always)
+    func contains(_ row: Int) -> Bool {
+        guard row >= lowerBound, row <= upperBound else { return false }
+        return words[row >> 6] & (1 << UInt64(row & 63)) != 0
+    }
+
+    mutating func formUnion(_ other: DirtyRowSet) {
+        guard !other.isEmpty else { return }
+        if other.words.count > words.count {
+            words.append(contentsOf: repeatElement(0, count: other.words.count - words.count))
+        }
+        for index in (other.lowerBound >> 6)...(other.upperBound >> 6) {
+            words[index] |= other.words[index]
+        }
+        lowerBound = min(lowerBound, other.lowerBound)
+        upperBound = max(upperBound, other.upperBound)
+    }
+
+    mutating func removeAll() {
+        guard !isEmpty else { return }
+        for index in (lowerBound >> 6)...(upperBound >> 6) {
+            words[index] = 0
+        }
+        lowerBound = Int.max
+        upperBound = -1
+    }
+
+    /// Contiguous blocks of dirty rows below `rowLimit`, in order.
+    func runs(below rowLimit: Int) -> [ClosedRange<Int>] {
+        guard !isEmpty else { return [] }
+        var result: [ClosedRange<Int>] = []
+        var start: Int?
+        let last = min(upperBound, rowLimit - 1)
+        guard lowerBound <= last else { return [] }
+        for row in lowerBound...last {
+            if contains(row) {
+                if start == nil { start = row }
+            } else if let runStart = start {
+                result.append(runStart...(row - 1))
+                start = nil
+            }
+        }
+        if let runStart = start {
+            result.append(runStart...last)
+        }
+        return result
+    }
+}
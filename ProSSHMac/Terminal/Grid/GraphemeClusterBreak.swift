@@ -0,0 +1,66 @@
+// GraphemeClusterBreak.swift
+// ProSSHV2
+//
+// Scalar-level grapheme cluster boundaries for `TerminalGrid.printCodepoints`.
+//
+// The bulk print path sees the scalars `UTF8TextDecoder` decoded from the
+// engine's input and has to decide, one at a time, whether each starts a
+// new cell or extends the cluster in the previous one. This is the subset
+// of UAX #29 that a wcwidth-driven terminal can apply without moving the
+// cursor differently from the remote application:
+// - GB9: Extend and ZWJ (every zero-width scalar in `CharacterWidth`:
+//   combining marks, variation selectors, emoji modifiers) join.
+// - GB11: an Extended_Pictographic scalar joins after a ZWJ that follows
+//   an Extended_Pictographic base, so `👨‍👩‍👧` is one cluster while a ZWJ
+//   between letters does not swallow the next letter.
+// - Everything else breaks.
+// Regional indicator pairs (GB12/13) and spacing marks (GB9a) are left
+// alone: wcwidth counts them as cells of their own, and joining them here
+// would desynchronize the cursor from full-screen applications.
+
+import Foundation
+
+// MARK: - GraphemeClusterBreak
+
+nonisolated struct GraphemeClusterBreak {
+
+    static let zeroWidthJoiner: UInt32 = 0x200D
+
+    /// First scalar of the current cluster. Nil at the start of a run,
+    /// where the cluster began in an earlier call.
+    private var base: UInt32?
+    /// Whether the previous scalar was a ZWJ eligible for GB11.
+    private var afterPictographicJoiner = false
+
+    /// Whether `value`, of cell width `width`, extends the cluster in the
+    /// previous cell rather than starting a new one.
+    @inline(__always)
+    mutating func extendsCluster(_ value: UInt32, width: UInt8) -> Bool {
+        if width == 0 {
+            if value == Self.zeroWidthJoiner {
+                // A run that starts mid-cluster keeps joining, as the split
+                // sequence would have without the chunk boundary.
+                afterPictographicJoiner = base.map(Self.isExtendedPictographic) ?? true
+            } else {
+                afterPictographicJoiner = false
+            }
+            return true
+        }
+        if afterPictographicJoiner {
+            afterPictographicJoiner = false
+            if Self.isExtendedPictographic(value) {
+                return true
+            }
+        }
+        base = value
+        return false
+    }
+
+    /// Approximation of Extended_Pictographic, which the standard library
+    /// does not expose: emoji scalars outside ASCII (digits, `#` and `*`
+    /// are emoji only as keycap bases).
+    static func isExtendedPictographic(_ value: UInt32) -> Bool {
+        guard value >= 0x00A9, let scalar = Unicode.Scalar(value) else { return false }
+        return scalar.properties.isEmoji
+    }
+}
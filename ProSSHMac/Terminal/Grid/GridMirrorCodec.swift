@@ -0,0 +1,536 @@
+// GridMirrorCodec.swift
+// ProSSHV2
+//
+// Wire format for read-only session mirroring (see SessionMirrorCoordinator).
+// The encoder keeps the screen as its viewers have it and turns each grid
+// snapshot into a frame carrying only what changed: the cursor, the scroll
+// the snapshot recorded (GridSnapshotScroll), and the rows that differ. The
+// snapshot's damage picks the rows to compare, so a frame costs in
+// proportion to the damage and its size in proportion to what a viewer
+// would see change; one encoding serves every viewer. A viewer joining, or
+// one that fell behind, gets a keyframe of the whole screen instead.
+//
+// Frames are little-endian:
+//
+//   version u8, kind u8 (0 keyframe, 1 delta), columns u16, rows u16,
+//   flags u8 (alternate buffer, cursor visible, scroll), cursor row u16,
+//   cursor column u16, cursor style u8
+//   [scroll: region first row u16, region last row u16, lines i16]
+//   row run count u16, each: first row u16, row count u16, then the run's
+//     cells run-length encoded as (repeat u16, cell) until the rows are full
+//   grapheme count u32, each: row u16, column u16, length u16, UTF-8 bytes
+//
+// A cell is glyph u32, foreground u32, background u32, underline colour
+// u32, attributes u16, underline style u8. A delta moves the scroll region
+// first, then rewrites its row runs, which replace those rows' graphemes.
+// Inline images are not mirrored.
+
+import Foundation
+
+// MARK: - GridMirrorCell
+
+/// What a viewer needs of one cell: a `CellInstance` without its position
+/// and renderer flags.
+nonisolated struct GridMirrorCell: Equatable, Sendable {
+    var glyph: UInt32
+    var fgColor: UInt32
+    var bgColor: UInt32
+    var underlineColor: UInt32
+    var attributes: UInt16
+    var underlineStyle: UInt8
+
+    static let blank = GridMirrorCell(glyph: 0, fgColor: 0, bgColor: 0, underlineColor: 0, attributes: 0, underlineStyle: 0)
+}
+
+nonisolated extension GridMirrorCell {
+    init(_ instance: CellInstance) {
+        self.init(
+            glyph: instance.glyphIndex,
+            fgColor: instance.fgColor,
+            bgColor: instance.bgColor,
+            underlineColor: instance.underlineColor,
+            attributes: instance.attributes,
+            underlineStyle: instance.underlineStyle
+        )
+    }
+}
+
+nonisolated extension GridSnapshot {
+
+    /// The cell at `index` as the mirror sends it, whichever form the
+    /// snapshot carries.
+    func mirrorCell(at index: Int) -> GridMirrorCell {
+        if let compactCells {
+            return GridMirrorCell(CellInstance(expanding: compactCells[index], row: 0, col: 0, isCursor: false))
+        }
+        return GridMirrorCell(cells[index])
+    }
+}
+
+// MARK: - GridMirrorScreen
+
+/// The screen as a mirror viewer holds it.
+nonisolated struct GridMirrorScreen: Sendable {
+    var columns = 0
+    var rows = 0
+    var usingAlternateBuffer = false
+    var cursorRow = 0
+    var cursorCol = 0
+    var cursorVisible = false
+    var cursorStyle: CursorStyle = .block
+    /// Row-major, `columns * rows` long.
+    var cells = ContiguousArray<GridMirrorCell>()
+    /// Grapheme overrides by row, then column.
+    var graphemes: [Int: [Int: String]] = [:]
+
+    /// Whether nothing was received or encoded yet.
+    var isEmpty: Bool {
+        cells.isEmpty
+    }
+
+    init() {}
+
+    init(columns: Int, rows: Int, usingAlternateBuffer: Bool) {
+        self.columns = columns
+        self.rows = rows
+        self.usingAlternateBuffer = usingAlternateBuffer
+        cells = ContiguousArray(repeating: .blank, count: columns * rows)
+    }
+
+    /// The screen `snapshot` shows.
+    init(_ snapshot: GridSnapshot) {
+        self.init(columns: snapshot.columns, rows: snapshot.rows, usingAlternateBuffer: snapshot.usingAlternateBuffer)
+        for index in cells.indices {
+            cells[index] = snapshot.mirrorCell(at: index)
+        }
+        graphemes = Self.graphemesByRow(snapshot.graphemeOverrides, columns: columns)
+        takeCursor(of: snapshot)
+    }
+
+    mutating func takeCursor(of snapshot: GridSnapshot) {
+        cursorRow = snapshot.cursorRow
+        cursorCol = snapshot.cursorCol
+        cursorVisible = snapshot.cursorVisible
+        cursorStyle = snapshot.cursorStyle
+    }
+
+    /// Move rows, and their graphemes, as the grid scrolled them. Exposed
+    /// rows keep stale cells until a row run rewrites them.
+    mutating func apply(_ delta: GridScrollDelta) {
+        delta.move(&cells, columns: columns)
+        var moved: [Int: [Int: String]] = [:]
+        for (row, rowGraphemes) in graphemes {
+            if let destination = delta.destination(ofRow: row) {
+                moved[destination] = rowGraphemes
+            }
+        }
+        graphemes = moved
+    }
+
+    /// A renderable snapshot of the screen with the given damage; nil
+    /// `damagedRanges` redraws everything.
+    func snapshot(damagedRanges: [Range<Int>]?) -> GridSnapshot {
+        let cursorIndex = cursorVisible ? cursorRow * columns + cursorCol : -1
+        var instances = ContiguousArray<CellInstance>()
+        instances.reserveCapacity(cells.count)
+        for (index, cell) in cells.enumerated() {
+            instances.append(CellInstance(
+                row: UInt16(truncatingIfNeeded: index / columns),
+                col: UInt16(truncatingIfNeeded: index % columns),
+                glyphIndex: cell.glyph,
+                fgColor: cell.fgColor,
+                bgColor: cell.bgColor,
+                underlineColor: cell.underlineColor,
+                attributes: cell.attributes,
+                flags: index == cursorIndex ? CellInstance.flagCursor : 0,
+                underlineStyle: cell.underlineStyle
+            ))
+        }
+        var overrides: [Int: String] = [:]
+        for (row, rowGraphemes) in graphemes {
+            for (col, grapheme) in rowGraphemes {
+                overrides[row * columns + col] = grapheme
+            }
+        }
+        var snapshot = GridSnapshot(
+            cells: instances,
+            dirtyRange: damagedRanges.map { ranges in
+                (ranges.first?.lowerBound ?? 0)..<(ranges.last?.upperBound ?? 0)
+            },
+            cursorRow: cursorRow,
+            cursorCol: cursorCol,
+            cursorVisible: cursorVisible,
+            cursorStyle: cursorStyle,
+            columns: columns,
+            rows: rows,
+            usingAlternateBuffer: usingAlternateBuffer,
+            graphemeOverrides: overrides.isEmpty ? nil : overrides
+        )
+        snapshot.damagedRanges = damagedRanges
+        return snapshot
+    }
+
+    static func graphemesByRow(_ overrides: [Int: String]?, columns: Int) -> [Int: [Int: String]] {
+        guard let overrides, columns > 0 else { return [:] }
+        var byRow: [Int: [Int: String]] = [:]
+        for (index, grapheme) in overrides {
+            byRow[index / columns, default: [:]][index % columns] = grapheme
+        }
+        return byRow
+    }
+}
+
+// MARK: - GridMirrorFrame
+
+nonisolated enum GridMirrorFrame {
+    static let version: UInt8 = 1
+
+    enum Kind: UInt8 {
+        case keyframe = 0
+        case delta = 1
+    }
+
+    static let flagAlternateBuffer: UInt8 = 1 << 0
+    static let flagCursorVisible: UInt8 = 1 << 1
+    static let flagScroll: UInt8 = 1 << 2
+
+    /// Largest grid a decoder accepts, so a bad header cannot allocate
+    /// without bound.
+    static let maximumCells = 1 << 22
+}
+
+nonisolated enum GridMirrorCodecError: Error, Equatable {
+    case truncated
+    case unsupportedVersion(UInt8)
+    case malformed
+    /// A delta arrived before any keyframe, or for another geometry.
+    case missingKeyframe
+}
+
+// MARK: - GridMirrorEncoder
+
+/// Turns the snapshots of one session into mirror frames.
+nonisolated struct GridMirrorEncoder: Sendable {
+    /// The screen as a viewer that applied every frame so far holds it.
+    private(set) var screen = GridMirrorScreen()
+    /// Sequence of the last snapshot encoded, which a snapshot's scroll
+    /// must start from to be sent as a move.
+    private var lastSequence: UInt64 = 0
+
+    init() {}
+
+    /// The frame bringing viewers from the last snapshot encoded to
+    /// `snapshot`: a keyframe on the first call or after a geometry or
+    /// screen switch, else a delta; nil when nothing a viewer shows changed.
+    /// `snapshot`'s damage must cover every change since the last call.
+    mutating func encode(_ snapshot: GridSnapshot) -> Data? {
+        let columns = snapshot.columns
+        let rows = snapshot.rows
+        guard columns > 0, rows > 0, columns * rows <= GridMirrorFrame.maximumCells,
+              snapshot.cellCount == columns * rows else { return nil }
+        defer { lastSequence = snapshot.sequence }
+
+        if screen.isEmpty || screen.columns != columns || screen.rows != rows
+            || screen.usingAlternateBuffer != snapshot.usingAlternateBuffer {
+            screen = GridMirrorScreen(snapshot)
+            return keyframe()
+        }
+
+        let cellCount = columns * rows
+        var damage = snapshot.damagedRanges ?? snapshot.dirtyRange.map { [$0] } ?? [0..<cellCount]
+        var scroll: GridScrollDelta?
+        if let moved = snapshot.scroll, lastSequence != 0, moved.baseSequence == lastSequence,
+           moved.delta.movesRows, moved.delta.region.lowerBound >= 0, moved.delta.region.upperBound < rows {
+            // Move the rows as viewers will, then compare only the rows the
+            // move does not account for.
+            scroll = moved.delta
+            screen.apply(moved.delta)
+            let region = (moved.delta.region.lowerBound * columns)..<((moved.delta.region.upperBound + 1) * columns)
+            var outside = moved.rewrittenRanges
+            for range in damage {
+                outside.append(range.lowerBound..<max(range.lowerBound, min(range.upperBound, region.lowerBound)))
+                outside.append(max(range.lowerBound, region.upperBound)..<max(range.upperBound, region.upperBound))
+            }
+            damage = outside
+        }
+
+        let graphemes = GridMirrorScreen.graphemesByRow(snapshot.graphemeOverrides, columns: columns)
+        var changedRows: [Int] = []
+        for row in Self.rows(covering: damage, columns: columns, rows: rows) {
+            let start = row * columns
+            var differs = screen.graphemes[row] != graphemes[row]
+            for index in start..<(start + columns) {
+                let cell = snapshot.mirrorCell(at: index)
+                if cell != screen.cells[index] {
+                    screen.cells[index] = cell
+                    differs = true
+                }
+            }
+            if differs {
+                screen.graphemes[row] = graphemes[row]
+                changedRows.append(row)
+            }
+        }
+
+        let cursorChanged = screen.cursorRow != snapshot.cursorRow
+            || screen.cursorCol != snapshot.cursorCol
+            || screen.cursorVisible != snapshot.cursorVisible
+            || screen.cursorStyle != snapshot.cursorStyle
+        screen.takeCursor(of: snapshot)
+        guard scroll != nil || !changedRows.isEmpty || cursorChanged else { return nil }
+        return frame(.delta, scroll: scroll, rowRuns: Self.runs(of: changedRows))
+    }
+
+    /// The whole screen as one keyframe, for a viewer joining or catching
+    /// up; nil before the first snapshot.
+    func keyframe() -> Data? {
+        guard !screen.isEmpty else { return nil }
+        return frame(.keyframe, scroll: nil, rowRuns: [0..<screen.rows])
+    }
+
+    private func frame(_ kind: GridMirrorFrame.Kind, scroll: GridScrollDelta?, rowRuns: [Range<Int>]) -> Data {
+        let columns = screen.columns
+        var writer = GridMirrorWriter()
+        writer.append(GridMirrorFrame.version)
+        writer.append(kind.rawValue)
+        writer.append(UInt16(columns))
+        writer.append(UInt16(screen.rows))
+        var flags: UInt8 = 0
+        if screen.usingAlternateBuffer { flags |= GridMirrorFrame.flagAlternateBuffer }
+        if screen.cursorVisible { flags |= GridMirrorFrame.flagCursorVisible }
+        if scroll != nil { flags |= GridMirrorFrame.flagScroll }
+        writer.append(flags)
+        writer.append(UInt16(clamping: screen.cursorRow))
+        writer.append(UInt16(clamping: screen.cursorCol))
+        writer.append(screen.cursorStyle.rawValue)
+        if let scroll {
+            writer.append(UInt16(scroll.region.lowerBound))
+            writer.append(UInt16(scroll.region.upperBound))
+            writer.append(UInt16(bitPattern: Int16(clamping: scroll.lines)))
+        }
+
+        writer.append(UInt16(rowRuns.count))
+        var graphemeCount = 0
+        for run in rowRuns {
+            writer.append(UInt16(run.lowerBound))
+            writer.append(UInt16(run.count))
+            var index = run.lowerBound * columns
+            let end = run.upperBound * columns
+            while index < end {
+                let cell = screen.cells[index]
+                var next = index + 1
+                while next < end, next - index < Int(UInt16.max), screen.cells[next] == cell {
+                    next += 1
+                }
+                writer.append(UInt16(next - index))
+                writer.append(cell)
+                index = next
+            }
+            for row in run {
+                graphemeCount += screen.graphemes[row]?.count ?? 0
+            }
+        }
+
+        writer.append(UInt32(graphemeCount))
+        for run in rowRuns {
+            for row in run {
+                for (col, grapheme) in screen.graphemes[row] ?? [:] {
+                    writer.append(UInt16(row))
+                    writer.append(UInt16(col))
+                    writer.append(grapheme)
+                }
+            }
+        }
+        return writer.data
+    }
+
+    /// The rows `ranges` of cells touch, ascending.
+    private static func rows(covering ranges: [Range<Int>], columns: Int, rows: Int) -> [Int] {
+        var marked = [Bool](repeating: false, count: rows)
+        for range in ranges where !range.isEmpty {
+            let first = max(range.lowerBound / columns, 0)
+            let last = min((range.upperBound - 1) / columns, rows - 1)
+            guard first <= last else { continue }
+            for row in first...last {
+                marked[row] = true
+            }
+        }
+        return marked.indices.filter { marked[$0] }
+    }
+
+    /// Ascending `rows` as runs of consecutive rows.
+    private static func runs(of rows: [Int]) -> [Range<Int>] {
+        var runs: [Range<Int>] = []
+        for row in rows {
+            if let last = runs.last, last.upperBound == row {
+                runs[runs.count - 1] = last.lowerBound..<(row + 1)
+            } else {
+                runs.append(row..<(row + 1))
+            }
+        }
+        return runs
+    }
+}
+
+// MARK: - GridMirrorDecoder
+
+/// Rebuilds a mirrored screen from frames, for rendering on the viewer.
+nonisolated struct GridMirrorDecoder: Sendable {
+    private(set) var screen = GridMirrorScreen()
+
+    init() {}
+
+    /// Apply `frame` and return the screen as a snapshot whose damage is
+    /// what the frame changed. A frame that fails to decode leaves the
+    /// screen as it was.
+    mutating func apply(_ frame: Data) throws -> GridSnapshot {
+        var reader = GridMirrorReader(frame)
+        let version = try reader.read(UInt8.self)
+        guard version == GridMirrorFrame.version else {
+            throw GridMirrorCodecError.unsupportedVersion(version)
+        }
+        guard let kind = GridMirrorFrame.Kind(rawValue: try reader.read(UInt8.self)) else {
+            throw GridMirrorCodecError.malformed
+        }
+        let columns = Int(try reader.read(UInt16.self))
+        let rows = Int(try reader.read(UInt16.self))
+        let flags = try reader.read(UInt8.self)
+        let cursorRow = Int(try reader.read(UInt16.self))
+        let cursorCol = Int(try reader.read(UInt16.self))
+        let cursorStyle = CursorStyle(rawValue: try reader.read(UInt8.self)) ?? .block
+        let usingAlternateBuffer = flags & GridMirrorFrame.flagAlternateBuffer != 0
+        guard columns > 0, rows > 0, columns * rows <= GridMirrorFrame.maximumCells else {
+            throw GridMirrorCodecError.malformed
+        }
+
+        var next: GridMirrorScreen
+        var damage: [Range<Int>] = []
+        switch kind {
+        case .keyframe:
+            next = GridMirrorScreen(columns: columns, rows: rows, usingAlternateBuffer: usingAlternateBuffer)
+        case .delta:
+            guard !screen.isEmpty, screen.columns == columns, screen.rows == rows,
+                  screen.usingAlternateBuffer == usingAlternateBuffer else {
+                throw GridMirrorCodecError.missingKeyframe
+            }
+            next = screen
+            for row in [screen.cursorRow, cursorRow] where row < rows {
+                damage.append((row * columns)..<((row + 1) * columns))
+            }
+        }
+
+        if flags & GridMirrorFrame.flagScroll != 0 {
+            let first = Int(try reader.read(UInt16.self))
+            let last = Int(try reader.read(UInt16.self))
+            let lines = Int(Int16(bitPattern: try reader.read(UInt16.self)))
+            guard first <= last, last < rows else { throw GridMirrorCodecError.malformed }
+            next.apply(GridScrollDelta(region: first...last, lines: lines))
+            damage.append((first * columns)..<((last + 1) * columns))
+        }
+
+        let runCount = Int(try reader.read(UInt16.self))
+        for _ in 0..<runCount {
+            let firstRow = Int(try reader.read(UInt16.self))
+            let rowCount = Int(try reader.read(UInt16.self))
+            guard rowCount > 0, firstRow + rowCount <= rows else { throw GridMirrorCodecError.malformed }
+            var index = firstRow * columns
+            let end = (firstRow + rowCount) * columns
+            while index < end {
+                let count = Int(try reader.read(UInt16.self))
+                let cell = try reader.readCell()
+                guard count > 0, index + count <= end else { throw GridMirrorCodecError.malformed }
+                for target in index..<(index + count) {
+                    next.cells[target] = cell
+                }
+                index += count
+            }
+            for row in firstRow..<(firstRow + rowCount) {
+                next.graphemes.removeValue(forKey: row)
+            }
+            damage.append((firstRow * columns)..<end)
+        }
+
+        let graphemeCount = Int(try reader.read(UInt32.self))
+        for _ in 0..<graphemeCount {
+            let row = Int(try reader.read(UInt16.self))
+            let col = Int(try reader.read(UInt16.self))
+            let grapheme = try reader.readString()
+            guard row < rows, col < columns else { throw GridMirrorCodecError.malformed }
+            next.graphemes[row, default: [:]][col] = grapheme
+        }
+
+        next.cursorRow = min(cursorRow, rows - 1)
+        next.cursorCol = min(cursorCol, columns - 1)
+        next.cursorVisible = flags & GridMirrorFrame.flagCursorVisible != 0
+        next.cursorStyle = cursorStyle
+        screen = next
+        return next.snapshot(damagedRanges: kind == .keyframe ? nil : GridSnapshot.union(damage, []))
+    }
+}
+
+// MARK: - Byte Buffers
+
+nonisolated private struct GridMirrorWriter {
+    private var bytes: [UInt8] = []
+
+    var data: Data {
+        Data(bytes)
+    }
+
+    mutating func append<T: FixedWidthInteger & UnsignedInteger>(_ value: T) {
+        withUnsafeBytes(of: value.littleEndian) { bytes.append(contentsOf: $0) }
+    }
+
+    mutating func append(_ cell: GridMirrorCell) {
+        append(cell.glyph)
+        append(cell.fgColor)
+        append(cell.bgColor)
+        append(cell.underlineColor)
+        append(cell.attributes)
+        append(cell.underlineStyle)
+    }
+
+    mutating func append(_ string: String) {
+        let utf8 = Array(string.utf8.prefix(Int(UInt16.max)))
+        append(UInt16(utf8.count))
+        bytes.append(contentsOf: utf8)
+    }
+}
+
+nonisolated private struct GridMirrorReader {
+    private let bytes: [UInt8]
+    private var offset = 0
+
+    init(_ data: Data) {
+        bytes = [UInt8](data)
+    }
+
+    mutating func read<T: FixedWidthInteger & UnsignedInteger>(_: T.Type) throws -> T {
+        let size = MemoryLayout<T>.size
+        guard offset + size <= bytes.count else { throw GridMirrorCodecError.truncated }
+        var value: T = 0
+        for index in 0..<size {
+            value |= T(bytes[offset + index]) << (8 * index)
+        }
+        offset += size
+        return value
+    }
+
+    mutating func readCell() throws -> GridMirrorCell {
+        GridMirrorCell(
+            glyph: try read(UInt32.self),
+            fgColor: try read(UInt32.self),
+            bgColor: try read(UInt32.self),
+            underlineColor: try read(UInt32.self),
+            attributes: try read(UInt16.self),
+            underlineStyle: try read(UInt8.self)
+        )
+    }
+
+    mutating func readString() throws -> String {
+        let count = Int(try read(UInt16.self))
+        guard offset + count <= bytes.count else { throw GridMirrorCodecError.truncated }
+        defer { offset += count }
+        return String(decoding: bytes[offset..<(offset + count)], as: UTF8.self)
+    }
+}
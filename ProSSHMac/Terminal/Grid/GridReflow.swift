@@ -13,6 +13,11 @@ import Foundation
 /// Stateless reflow engine. All methods are static and operate on cell data.
 nonisolated enum GridReflow {
 
+    /// Scrollback lines above the screen that a resize rewraps immediately.
+    /// Older history keeps its width until `TerminalGrid.settleDeferredReflow`
+    /// runs, so resize cost does not grow with history size.
+    static let liveReflowMargin = 200
+
     // MARK: - Logical Line
 
     /// A logical line is one or more physical rows that form a single
@@ -160,6 +165,44 @@ nonisolated enum GridReflow {
         )
     }
 
+    /// Rewrap scrollback lines laid out for `oldColumns` to `newColumns`.
+    /// `lines` must start at a logical line boundary (or the oldest line).
+    static func rewrapScrollback(
+        _ lines: [ScrollbackLine],
+        oldColumns: Int,
+        newColumns: Int
+    ) -> [ScrollbackLine] {
+        guard oldColumns != newColumns, !lines.isEmpty else { return lines }
+
+        var result = [ScrollbackLine]()
+        result.reserveCapacity(lines.count)
+        var currentCells = [TerminalCell]()
+        var startsWrapped = false
+        var hasLine = false
+
+        func flush() {
+            guard hasLine else { return }
+            let wrapped = wrapLogicalLine(trimTrailingBlanks(currentCells), toWidth: newColumns)
+            for (index, row) in wrapped.enumerated() {
+                result.append(ScrollbackLine(cells: row, isWrapped: index == 0 ? startsWrapped : true))
+            }
+        }
+
+        for line in lines {
+            let rowCells = padOrTrim(line.cells, toWidth: oldColumns)
+            if hasLine && line.isWrapped {
+                currentCells.append(contentsOf: rowCells)
+            } else {
+                flush()
+                currentCells = rowCells
+                startsWrapped = line.isWrapped
+                hasLine = true
+            }
+        }
+        flush()
+        return result
+    }
+
     // MARK: - Result Type
 
     /// The result of a reflow operation.
@@ -0,0 +1,120 @@
+// GridScrollDelta.swift
+// ProSSHV2
+//
+// Scrolls as moves. A line feed at the bottom of the screen rotates the
+// grid's row base in O(1), but every row of the scroll region then holds
+// different content, so as damage it reads as a full-screen change: the
+// snapshot re-encodes the region and CellBuffer copies all of it.
+//
+// The grid records the scroll instead: the region and how many lines it
+// moved since the last snapshot, plus the rows the move does not account
+// for (rows it exposed, rows written since). A consumer holding the
+// previous cells moves them by the delta and rewrites only those rows, so
+// steady-state output costs a row per new line. `damagedRanges` still
+// covers the whole region for consumers that redraw by damage.
+
+import Foundation
+
+// MARK: - GridScrollDelta
+
+/// Rows of `region` moved up by `lines`; negative `lines` moved them down.
+/// Rows moved past the region's edge are gone.
+nonisolated struct GridScrollDelta: Sendable, Equatable {
+    var region: ClosedRange<Int>
+    var lines: Int
+
+    /// Whether any row survives the move in the region.
+    var movesRows: Bool {
+        lines != 0 && abs(lines) < region.count
+    }
+
+    /// Rows the move leaves without content: at the bottom of the region
+    /// when scrolling up, at the top when scrolling down.
+    var exposedRows: ClosedRange<Int> {
+        let count = min(abs(lines), region.count)
+        if lines > 0 {
+            return (region.upperBound - count + 1)...region.upperBound
+        }
+        return region.lowerBound...(region.lowerBound + max(count, 1) - 1)
+    }
+
+    /// Where `row` is after the move; nil when it was moved out.
+    func destination(ofRow row: Int) -> Int? {
+        guard region.contains(row) else { return row }
+        let moved = row - lines
+        return region.contains(moved) ? moved : nil
+    }
+
+    /// The move made by this one followed by `later`, or nil when the two
+    /// scroll different regions.
+    func followed(by later: GridScrollDelta) -> GridScrollDelta? {
+        guard later.region == region else { return nil }
+        return GridScrollDelta(region: region, lines: lines + later.lines)
+    }
+
+    /// `rows` as rows after the move.
+    func moving(_ rows: DirtyRowSet) -> DirtyRowSet {
+        guard !rows.isEmpty, lines != 0 else { return rows }
+        var moved = DirtyRowSet()
+        for run in rows.runs(below: rows.upperBound + 1) {
+            for row in run {
+                if let destination = destination(ofRow: row) {
+                    moved.insert(destination)
+                }
+            }
+        }
+        return moved
+    }
+
+    /// Cell ranges, in a grid `columns` wide, as the cells they cover after
+    /// the move. Moved parts widen to whole rows.
+    func moving(_ ranges: [Range<Int>], columns: Int) -> [Range<Int>] {
+        guard lines != 0, columns > 0 else { return ranges }
+        let regionCells = (region.lowerBound * columns)..<((region.upperBound + 1) * columns)
+        var moved: [Range<Int>] = []
+        moved.reserveCapacity(ranges.count + 2)
+        for range in ranges where !range.isEmpty {
+            if range.lowerBound < regionCells.lowerBound {
+                moved.append(range.lowerBound..<min(range.upperBound, regionCells.lowerBound))
+            }
+            if range.upperBound > regionCells.upperBound {
+                moved.append(max(range.lowerBound, regionCells.upperBound)..<range.upperBound)
+            }
+            let inside = range.clamped(to: regionCells)
+            guard !inside.isEmpty else { continue }
+            let first = max(inside.lowerBound / columns - lines, region.lowerBound)
+            let last = min((inside.upperBound - 1) / columns - lines, region.upperBound)
+            if first <= last {
+                moved.append((first * columns)..<((last + 1) * columns))
+            }
+        }
+        return GridSnapshot.union(moved, [])
+    }
+
+    /// Move the rows of `cells`, a row-major grid `columns` wide, in place.
+    /// Exposed rows keep stale cells for the caller to rewrite.
+    func move<Cell>(_ cells: inout ContiguousArray<Cell>, columns: Int) {
+        guard movesRows, (region.upperBound + 1) * columns <= cells.count else { return }
+        let count = (region.count - abs(lines)) * columns
+        let from = (lines > 0 ? region.lowerBound + lines : region.lowerBound) * columns
+        let to = (lines > 0 ? region.lowerBound : region.lowerBound - lines) * columns
+        cells.withUnsafeMutableBufferPointer { buffer in
+            guard let base = buffer.baseAddress else { return }
+            // Overlapping update(from:count:) copies as memmove does.
+            (base + to).update(from: base + from, count: count)
+        }
+    }
+}
+
+// MARK: - GridSnapshotScroll
+
+/// The scroll a snapshot carries: how to bring the cells of snapshot
+/// `baseSequence` up to this one by moving rows.
+nonisolated struct GridSnapshotScroll: Sendable, Equatable {
+    /// `GridSnapshot.sequence` of the snapshot the move applies to.
+    var baseSequence: UInt64
+    var delta: GridScrollDelta
+    /// Cells to copy after the move: rows it exposed and rows written
+    /// since, as whole rows.
+    var rewrittenRanges: [Range<Int>]
+}
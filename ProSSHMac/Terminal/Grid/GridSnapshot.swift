@@ -16,8 +16,8 @@ nonisolated struct CellInstance: Sendable {
     var row: UInt16
     var col: UInt16
 
-    /// Initially holds the Unicode codepoint (set by grid snapshot).
-    /// The renderer replaces this with the packed atlas position after glyph lookup.
+    /// The Unicode codepoint (set by grid snapshot). Uploaded as is; the
+    /// vertex shader resolves it to a packed atlas position via GPUGlyphTable.
     var glyphIndex: UInt32
 
     /// Foreground color as packed RGBA UInt32.
@@ -52,12 +52,17 @@ nonisolated struct CellInstance: Sendable {
 nonisolated struct GridSnapshot: Sendable {
     /// Flattened cell data ready for GPU upload. Row-major order.
     /// Uses ContiguousArray for cache-friendly iteration and zero NSArray bridging.
+    /// Empty when the snapshot carries `compactCells` instead.
     let cells: ContiguousArray<CellInstance>
 
     /// If non-nil, only this range of cells changed since the last snapshot.
     /// The renderer can do a partial MTLBuffer update for efficiency.
     let dirtyRange: Range<Int>?
 
+    /// The changed cells as disjoint ranges, one per block of dirty rows,
+    /// all inside `dirtyRange`. Nil when only `dirtyRange` is known.
+    var damagedRanges: [Range<Int>]? = nil
+
     /// Current cursor row.
     let cursorRow: Int
 
@@ -82,4 +87,137 @@ nonisolated struct GridSnapshot: Sendable {
     /// Original grapheme clusters for cells whose visible text cannot be
     /// reconstructed from `glyphIndex` alone.
     let graphemeOverrides: [Int: String]?
+
+    /// Grid cells as stored (20 bytes each), row-major, when the grid runs in
+    /// compact snapshot mode. The renderer uploads them as-is and a compute
+    /// kernel expands them to `CellInstance`s; `cells` is then empty.
+    var compactCells: ContiguousArray<TerminalCell>? = nil
+
+    /// Inline images overlapping the viewport, drawn over the cells.
+    var inlineImages: [InlineImageQuad] = []
+
+    /// Increases with every live snapshot the grid produces; 0 for other
+    /// snapshots (scrollback, or rebuilt by the renderer).
+    var sequence: UInt64 = 0
+
+    /// Set when rows moved by scrolling since snapshot
+    /// `scroll.baseSequence`. `damagedRanges` still covers the moved rows;
+    /// a consumer holding that snapshot's cells may move them and copy
+    /// only `scroll.rewrittenRanges` instead (see GridScrollDelta).
+    var scroll: GridSnapshotScroll? = nil
+}
+
+// MARK: - Compact Cells
+
+nonisolated extension GridSnapshot {
+
+    /// Number of cells in the snapshot, whichever form it carries.
+    var cellCount: Int {
+        compactCells?.count ?? cells.count
+    }
+
+    /// Approximate bytes held by the cell arrays and grapheme overrides.
+    var estimatedByteCount: Int {
+        var bytes = cells.capacity * MemoryLayout<CellInstance>.stride
+            + (compactCells?.capacity ?? 0) * MemoryLayout<TerminalCell>.stride
+            + (damagedRanges?.count ?? 0) * MemoryLayout<Range<Int>>.stride
+        for (_, grapheme) in graphemeOverrides ?? [:] {
+            bytes += MemoryLayout<Int>.stride + grapheme.utf8.count
+        }
+        return bytes
+    }
+
+    /// Address of the cell storage; copies of one snapshot share it.
+    var cellStorageAddress: UnsafeRawPointer? {
+        if let compactCells {
+            return compactCells.withUnsafeBufferPointer { $0.baseAddress.map(UnsafeRawPointer.init) }
+        }
+        return cells.withUnsafeBufferPointer { $0.baseAddress.map(UnsafeRawPointer.init) }
+    }
+
+    /// `CellAttributes` raw value of the cell at `index`.
+    func cellAttributes(at index: Int) -> UInt16 {
+        if let compactCells {
+            return compactCells[index].attributes.rawValue
+        }
+        return cells[index].attributes
+    }
+
+    /// This snapshot with `compactCells` expanded on the CPU, for consumers
+    /// that need `CellInstance`s (selection projection, text extraction).
+    /// Returns `self` when it already carries `cells`.
+    func expandingCompactCells() -> GridSnapshot {
+        guard let compactCells, columns > 0 else { return self }
+        var expanded = ContiguousArray<CellInstance>()
+        expanded.reserveCapacity(compactCells.count)
+        for (index, cell) in compactCells.enumerated() {
+            expanded.append(CellInstance(
+                expanding: cell,
+                row: index / columns,
+                col: index % columns,
+                isCursor: cursorVisible && index == cursorRow * columns + cursorCol
+            ))
+        }
+        var snapshot = GridSnapshot(
+            cells: expanded,
+            dirtyRange: dirtyRange,
+            cursorRow: cursorRow,
+            cursorCol: cursorCol,
+            cursorVisible: cursorVisible,
+            cursorStyle: cursorStyle,
+            columns: columns,
+            rows: rows,
+            usingAlternateBuffer: usingAlternateBuffer,
+            graphemeOverrides: graphemeOverrides
+        )
+        snapshot.damagedRanges = damagedRanges
+        snapshot.inlineImages = inlineImages
+        snapshot.sequence = sequence
+        snapshot.scroll = scroll
+        return snapshot
+    }
+}
+
+nonisolated extension CellInstance {
+
+    /// The instance the grid snapshot encodes for `cell`; mirrors
+    /// `expand_terminal_cells` in TerminalShaders.metal.
+    init(expanding cell: TerminalCell, row: Int, col: Int, isCursor: Bool) {
+        var attributes = cell.attributes.rawValue
+        if cell.width == 0 {
+            attributes |= CellAttributes.wideContinuation.rawValue
+        }
+        self.init(
+            row: UInt16(truncatingIfNeeded: row),
+            col: UInt16(truncatingIfNeeded: col),
+            glyphIndex: cell.primaryCodepoint,
+            fgColor: cell.fgPackedRGBA,
+            bgColor: cell.bgPackedRGBA,
+            underlineColor: cell.underlinePackedRGBA,
+            attributes: attributes,
+            flags: isCursor ? CellInstance.flagCursor : 0,
+            underlineStyle: cell.underlineStyle.rawValue
+        )
+    }
+}
+
+// MARK: - ScrollbackRingRows
+
+/// Rows for the renderer's scrollback row ring (ScrollbackRowRing), by
+/// line position. Positions number the scrollback and then the live grid
+/// rows from the buffer's stable line IDs, so a line keeps its position
+/// while the viewport moves; `liveTop` is the top grid row's position.
+/// Each row's cells carry the position, truncated to 16 bits, in `row`.
+nonisolated struct ScrollbackRingRows: Sendable {
+    struct Row: Sendable {
+        let position: Int
+        let cells: ContiguousArray<CellInstance>
+    }
+
+    let columns: Int
+    /// Position of the oldest kept scrollback line.
+    let firstPosition: Int
+    let liveTop: Int
+    /// The requested positions that exist, ascending.
+    let rows: [Row]
 }
@@ -0,0 +1,225 @@
+// GridSnapshotFeed.swift
+// ProSSHV2
+//
+// Lock-free snapshot hand-off from TerminalRenderingCoordinator to one
+// renderer. The pane used to receive snapshots through SwiftUI:
+// every publish bumped `gridSnapshotNonceBySessionID`, which fired
+// SessionManager's `objectWillChange`, re-evaluated every view observing
+// the manager, and reached the renderer through `onChange(of:)`.
+//
+// With a feed attached the coordinator writes each snapshot into a triple
+// buffer and wakes the pane's view. The renderer takes the newest one at
+// the top of its draw callback, so however many publishes land between two
+// vsyncs it applies exactly one, right before encoding. Publishing to a
+// session whose panes are all fed no longer bumps the nonce.
+//
+// Triple buffer: the writer fills its back slot and swaps it with the
+// middle slot; the reader swaps its front slot with the middle one when the
+// fresh bit is set. One atomic byte holds the middle index and the fresh
+// bit, so neither side ever waits on the other. Writes that replace an
+// unread snapshot carry its damage forward, so the renderer can still do a
+// partial upload after skipping snapshots. A write may also carry the time
+// of the keystroke its snapshot echoes (see InputEchoTracker) and a latency
+// sample (see PipelineLatencyTracer).
+
+import Foundation
+import Synchronization
+
+// MARK: - GridSnapshotFeed
+
+/// Single-writer, single-reader triple buffer of grid snapshots.
+nonisolated final class GridSnapshotFeed: @unchecked Sendable {
+
+    /// Bits 0–1: index of the middle slot. Bit 2: the middle slot holds a
+    /// snapshot the reader has not taken.
+    private let state = Atomic<UInt8>(1)
+    private static let freshBit: UInt8 = 0b100
+    private static let indexMask: UInt8 = 0b011
+
+    private let slots: UnsafeMutablePointer<GridSnapshot?>
+    /// Keystroke time per slot, in `CACurrentMediaTime()` seconds; 0 when none.
+    private let inputTimestamps: UnsafeMutablePointer<CFTimeInterval>
+    /// Latency sample per slot.
+    private let traces: UnsafeMutablePointer<PipelineTrace?>
+
+    /// Slot the writer fills next. Only touched by the writer.
+    private var backIndex = 0
+    /// Slot the reader last took. Only touched by the reader.
+    private var frontIndex = 2
+    /// Damage-carrying copy of the last snapshot written; writer only.
+    private var lastWritten: GridSnapshot?
+    private var lastWrittenInputTimestamp: CFTimeInterval = 0
+    private var lastWrittenTrace: PipelineTrace?
+
+    /// Keystroke time carried by the last snapshot `takeLatest` returned.
+    /// Only touched by the reader.
+    private(set) var takenInputTimestamp: CFTimeInterval?
+
+    /// Latency sample carried by the last snapshot `takeLatest` returned.
+    /// Only touched by the reader.
+    private(set) var takenTrace: PipelineTrace?
+
+    private let writtenCount = Atomic<UInt64>(0)
+
+    /// Called on the main actor after `publish`; set by the consuming renderer.
+    @MainActor var onPublish: (() -> Void)?
+
+    /// Memory held by the consuming renderer; set by the renderer.
+    @MainActor var memoryFootprintProvider: (() -> MemoryFootprint)?
+
+    init() {
+        slots = .allocate(capacity: 3)
+        slots.initialize(repeating: nil, count: 3)
+        inputTimestamps = .allocate(capacity: 3)
+        inputTimestamps.initialize(repeating: 0, count: 3)
+        traces = .allocate(capacity: 3)
+        traces.initialize(repeating: nil, count: 3)
+    }
+
+    deinit {
+        slots.deinitialize(count: 3)
+        slots.deallocate()
+        inputTimestamps.deinitialize(count: 3)
+        inputTimestamps.deallocate()
+        traces.deinitialize(count: 3)
+        traces.deallocate()
+    }
+
+    // MARK: - Writer
+
+    /// Number of snapshots written so far.
+    var generation: UInt64 {
+        writtenCount.load(ordering: .acquiring)
+    }
+
+    /// Whether a written snapshot is waiting for the reader.
+    var hasUnreadSnapshot: Bool {
+        state.load(ordering: .acquiring) & Self.freshBit != 0
+    }
+
+    /// Store `snapshot` as the newest one. If the previous snapshot was not
+    /// taken yet, its damage, keystroke time and latency sample are merged
+    /// in. Call from one writer only.
+    func write(_ snapshot: GridSnapshot, inputTimestamp: CFTimeInterval? = nil, trace: PipelineTrace? = nil) {
+        var stored = snapshot
+        var timestamp = inputTimestamp ?? 0
+        var storedTrace = trace
+        // A take racing with this check only makes the damage a superset.
+        if hasUnreadSnapshot, let lastWritten {
+            stored = snapshot.mergingDamage(of: lastWritten)
+            if lastWrittenInputTimestamp > 0 {
+                timestamp = timestamp > 0 ? min(timestamp, lastWrittenInputTimestamp) : lastWrittenInputTimestamp
+            }
+            storedTrace = PipelineTrace.earliest(storedTrace, lastWrittenTrace)
+        }
+        slots[backIndex] = stored
+        inputTimestamps[backIndex] = timestamp
+        traces[backIndex] = storedTrace
+        lastWritten = stored
+        lastWrittenInputTimestamp = timestamp
+        lastWrittenTrace = storedTrace
+        let previous = state.exchange(UInt8(backIndex) | Self.freshBit, ordering: .acquiringAndReleasing)
+        backIndex = Int(previous & Self.indexMask)
+        writtenCount.add(1, ordering: .releasing)
+    }
+
+    /// `write` and wake the consumer.
+    @MainActor func publish(_ snapshot: GridSnapshot, inputTimestamp: CFTimeInterval? = nil, trace: PipelineTrace? = nil) {
+        write(snapshot, inputTimestamp: inputTimestamp, trace: trace)
+        onPublish?()
+    }
+
+    /// Every snapshot the feed still holds, for memory accounting.
+    /// Main actor only, where both the coordinator and the renderer run.
+    @MainActor func forEachRetainedSnapshot(_ body: (GridSnapshot) -> Void) {
+        for index in 0..<3 {
+            if let snapshot = slots[index] {
+                body(snapshot)
+            }
+        }
+        if let lastWritten {
+            body(lastWritten)
+        }
+    }
+
+    // MARK: - Reader
+
+    /// The newest snapshot if one was written since the last take, else nil.
+    /// Call from one reader only.
+    func takeLatest() -> GridSnapshot? {
+        guard hasUnreadSnapshot else { return nil }
+        let previous = state.exchange(UInt8(frontIndex), ordering: .acquiringAndReleasing)
+        frontIndex = Int(previous & Self.indexMask)
+        let timestamp = inputTimestamps[frontIndex]
+        takenInputTimestamp = timestamp > 0 ? timestamp : nil
+        takenTrace = traces[frontIndex]
+        return slots[frontIndex]
+    }
+}
+
+// MARK: - Damage Merging
+
+nonisolated extension GridSnapshot {
+
+    /// This snapshot with its damage widened to cover `earlier`'s too, for
+    /// a consumer that never saw `earlier`. Without a partial range on both
+    /// sides, or across a geometry or screen change, the result is a full
+    /// update (nil `dirtyRange`). Scrolls of the same region on both sides
+    /// combine into one move; otherwise the move is dropped and the
+    /// widened damage stands.
+    func mergingDamage(of earlier: GridSnapshot) -> GridSnapshot {
+        let compatible = earlier.columns == columns
+            && earlier.rows == rows
+            && earlier.usingAlternateBuffer == usingAlternateBuffer
+        var mergedRange: Range<Int>?
+        var mergedRuns: [Range<Int>]?
+        if compatible, let current = dirtyRange, let previous = earlier.dirtyRange {
+            mergedRange = min(current.lowerBound, previous.lowerBound)..<max(current.upperBound, previous.upperBound)
+            if let currentRuns = damagedRanges, let previousRuns = earlier.damagedRanges {
+                mergedRuns = Self.union(currentRuns, previousRuns)
+            }
+        }
+        var merged = GridSnapshot(
+            cells: cells,
+            dirtyRange: mergedRange,
+            cursorRow: cursorRow,
+            cursorCol: cursorCol,
+            cursorVisible: cursorVisible,
+            cursorStyle: cursorStyle,
+            columns: columns,
+            rows: rows,
+            usingAlternateBuffer: usingAlternateBuffer,
+            graphemeOverrides: graphemeOverrides,
+            compactCells: compactCells,
+            inlineImages: inlineImages
+        )
+        merged.damagedRanges = mergedRuns
+        merged.sequence = sequence
+        if mergedRange != nil, let later = scroll, let previous = earlier.scroll,
+           let delta = previous.delta.followed(by: later.delta), delta.movesRows {
+            merged.scroll = GridSnapshotScroll(
+                baseSequence: previous.baseSequence,
+                delta: delta,
+                rewrittenRanges: Self.union(
+                    later.rewrittenRanges,
+                    later.delta.moving(previous.rewrittenRanges, columns: columns)
+                )
+            )
+        }
+        return merged
+    }
+
+    /// Sorted, disjoint union of two range lists; touching ranges coalesce.
+    static func union(_ lhs: [Range<Int>], _ rhs: [Range<Int>]) -> [Range<Int>] {
+        let sorted = (lhs + rhs).sorted { $0.lowerBound < $1.lowerBound }
+        var result: [Range<Int>] = []
+        for range in sorted where !range.isEmpty {
+            if let last = result.last, range.lowerBound <= last.upperBound {
+                result[result.count - 1] = last.lowerBound..<max(last.upperBound, range.upperBound)
+            } else {
+                result.append(range)
+            }
+        }
+        return result
+    }
+}
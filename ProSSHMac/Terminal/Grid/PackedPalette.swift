@@ -0,0 +1,60 @@
+// PackedPalette.swift
+// ProSSHV2
+//
+// The 256-colour palette as GPU-ready packed RGBA, with OSC 4 overrides
+// applied. SGR colour changes resolve indexed colours with one table load
+// instead of going through ColorPalette and re-packing, and an OSC 4/104
+// update rewrites a single entry.
+
+import Foundation
+
+nonisolated struct PackedPalette: Sendable {
+
+    private var entries: ContiguousArray<UInt32>
+
+    init() {
+        entries = ContiguousArray((0...255).map { Self.pack(ColorPalette.rgb(forIndex: UInt8($0))) })
+    }
+
+    subscript(index: UInt8) -> UInt32 {
+        entries[Int(index)]
+    }
+
+    /// Override one entry (OSC 4).
+    mutating func set(index: UInt8, r: UInt8, g: UInt8, b: UInt8) {
+        entries[Int(index)] = Self.pack((r, g, b))
+    }
+
+    /// Restore one entry to the built-in palette (OSC 104).
+    mutating func reset(index: UInt8) {
+        entries[Int(index)] = Self.pack(ColorPalette.rgb(forIndex: index))
+    }
+
+    /// Packed RGBA for `color`; 0 for `.default`, like `TerminalColor.packedRGBA()`.
+    @inline(__always)
+    func packed(_ color: TerminalColor) -> UInt32 {
+        switch color {
+        case .default:
+            return 0
+        case .indexed(let index):
+            return entries[Int(index)]
+        case .rgb(let r, let g, let b):
+            return Self.pack((r, g, b))
+        }
+    }
+
+    /// Packed foreground for bold text under bold-is-bright: standard
+    /// colours 0–7 map to their bright variants.
+    @inline(__always)
+    func packedBold(_ color: TerminalColor) -> UInt32 {
+        if case .indexed(let index) = color, index < 8 {
+            return entries[Int(index) + 8]
+        }
+        return packed(color)
+    }
+
+    @inline(__always)
+    private static func pack(_ rgb: (r: UInt8, g: UInt8, b: UInt8)) -> UInt32 {
+        (UInt32(rgb.r) << 24) | (UInt32(rgb.g) << 16) | (UInt32(rgb.b) << 8) | 0xFF
+    }
+}
@@ -1,7 +1,7 @@
 // ScrollbackBuffer.swift
 // ProSSHV2
 //
-// Ring buffer for terminal scrollback history.
+// Paged buffer for terminal scrollback history.
 // Stores lines that have scrolled off the top of the visible terminal grid.
 
 import Foundation
@@ -10,9 +10,17 @@ import Foundation
 
 /// A single line stored in the scrollback buffer.
 /// Preserves the original cells and whether the line was auto-wrapped.
+/// Cells are held as a `StyledRow` (codepoints plus style spans).
 nonisolated struct ScrollbackLine: Sendable {
-    /// The cells that make up this line.
-    var cells: [TerminalCell]
+    /// The line's codepoints and style spans.
+    var row: StyledRow
+
+    /// The cells that make up this line, expanded from `row` on each access.
+    /// Hot loops should read `row` instead.
+    var cells: [TerminalCell] {
+        get { row.cells }
+        set { row = StyledRow(cells: newValue) }
+    }
 
     /// Whether this line was auto-wrapped (continued from the line above).
     var isWrapped: Bool
@@ -27,44 +35,43 @@ nonisolated struct ScrollbackLine: Sendable {
 
     /// Create a scrollback line from a row of cells.
     init(cells: [TerminalCell], isWrapped: Bool = false, graphemeOverrides: [Int: String]? = nil) {
-        self.cells = cells
+        self.init(row: StyledRow(cells: cells), isWrapped: isWrapped, graphemeOverrides: graphemeOverrides)
+    }
+
+    init(row: StyledRow, isWrapped: Bool = false, graphemeOverrides: [Int: String]? = nil) {
+        self.row = row
         self.isWrapped = isWrapped
         self.graphemeOverrides = graphemeOverrides
     }
 
     /// The number of cells in this line.
-    var count: Int { cells.count }
+    var count: Int { row.count }
 
     /// Get the grapheme cluster for a cell at the given column, checking overrides first.
     func grapheme(at col: Int) -> String {
         if let overrides = graphemeOverrides, let str = overrides[col] {
             return str
         }
-        return cells[col].graphemeCluster
+        let codepoint = row.codepoints[col]
+        if codepoint == 0 { return "" }
+        if codepoint & GraphemeSideTable.sentinel != 0 { return "\u{FFFD}" }
+        return UnicodeScalar(codepoint).map { String($0) } ?? "\u{FFFD}"
     }
 
     /// Trim trailing blank cells to save memory.
     mutating func trimTrailingBlanks() {
-        guard !cells.isEmpty else { return }
-
-        if let lastNonBlank = cells.lastIndex(where: { !$0.isBlank }) {
-            let trimStart = cells.index(after: lastNonBlank)
-            if trimStart < cells.endIndex {
-                // Remove grapheme overrides for trimmed columns
-                if graphemeOverrides != nil {
-                    for col in trimStart..<cells.endIndex {
-                        graphemeOverrides?.removeValue(forKey: col)
-                    }
-                    if graphemeOverrides?.isEmpty == true {
-                        graphemeOverrides = nil
-                    }
-                }
-                cells.removeSubrange(trimStart..<cells.endIndex)
+        guard !row.isEmpty else { return }
+
+        let trimStart = row.contentEnd
+        guard trimStart < row.count else { return }
+        // Remove grapheme overrides for trimmed columns
+        if graphemeOverrides != nil {
+            graphemeOverrides = graphemeOverrides?.filter { $0.key < trimStart }
+            if graphemeOverrides?.isEmpty == true {
+                graphemeOverrides = nil
             }
-        } else {
-            cells.removeAll(keepingCapacity: true)
-            graphemeOverrides = nil
         }
+        row.truncate(to: trimStart)
     }
 
     /// Trim trailing blanks only if the line hasn't been trimmed yet.
@@ -75,34 +82,127 @@ nonisolated struct ScrollbackLine: Sendable {
     }
 }
 
+// MARK: - DeferredReflowSegment
+
+/// A run of consecutive scrollback lines still wrapped for an earlier width.
+nonisolated struct DeferredReflowSegment: Sendable, Equatable {
+    var lineCount: Int
+    let columns: Int
+}
+
 // MARK: - ScrollbackBuffer
 
-/// A fixed-capacity ring buffer that stores scrollback history lines.
+/// Bounded scrollback history with O(1) push and random access by line.
 ///
-/// When the buffer reaches its maximum capacity, the oldest lines are
-/// discarded as new lines are added. This provides O(1) push and O(1)
-/// indexed access.
+/// The newest lines live uncompressed in a hot tail. Once the tail holds a
+/// full page beyond `hotLineLimit`, its oldest `ScrollbackPage.lineCapacity`
+/// lines are trimmed and encoded into a `ScrollbackPage`; pages older than
+/// the newest two are compressed, and pages beyond the newest
+/// `residentPageLimit` are sealed into an encrypted, memory-mapped
+/// `ScrollbackSpillFile` and read back on demand. The oldest lines are
+/// discarded once either `maxLines` or the `maxBytes` budget for in-memory
+/// pages is exceeded, so memory stays bounded however long the history is.
 nonisolated struct ScrollbackBuffer: Sendable {
 
+    /// Lines kept uncompressed at the newest end of the buffer.
+    static let hotLineLimit = 1024
+
+    /// Pages at the newest end of the paged region left uncompressed.
+    private static let uncompressedPageCount = 2
+
     /// The maximum number of lines this buffer can hold.
     let maxLines: Int
 
-    /// Internal storage array (ring buffer).
-    private var storage: [ScrollbackLine]
+    /// Budget for in-memory page storage, in bytes. Whole pages are dropped
+    /// from the oldest end when it is exceeded.
+    let maxBytes: Int
+
+    /// Pages kept in memory before older ones are spilled to disk.
+    let residentPageLimit: Int
+
+    /// Whether pages carry a trigram filter for search.
+    let indexesText: Bool
+
+    /// Older lines, oldest page first. Every page is full.
+    private var pages: [ScrollbackPage] = []
 
-    /// Index of the oldest element in the ring buffer.
-    private var head: Int = 0
+    /// Lines already discarded from the front of `pages[0]`.
+    private var firstPageSkip = 0
+
+    /// Bytes held in memory by `pages`.
+    private(set) var pagedByteCount = 0
+
+    /// Where pages beyond `residentPageLimit` go; opened on first use.
+    private let spillSlot: ScrollbackSpillSlot
+
+    /// Newest lines, oldest first from `hotHead`.
+    private var hot: [ScrollbackLine] = []
+    private var hotHead = 0
+
+    /// Rows of hot lines that left the tail, kept for their storage so
+    /// pushes refill them instead of allocating.
+    private var recycledRows: [StyledRow] = []
+
+    /// Most rows `recycledRows` keeps.
+    static let recycledRowLimit = ScrollbackPage.lineCapacity
+
+    /// Decoded pages, shared between copies since pages never change.
+    private let pageCache = ScrollbackPageCache()
 
     /// The current number of lines stored.
     private(set) var count: Int = 0
 
+    /// The oldest lines, grouped by the width they are still wrapped for.
+    /// Resize rewraps only recent history and leaves the rest to
+    /// `TerminalGrid.settleDeferredReflow()`.
+    private(set) var deferredReflow: [DeferredReflowSegment] = []
+
+    /// Total lines covered by `deferredReflow`.
+    private(set) var deferredReflowLineCount = 0
+
+    /// Lines discarded from the oldest end so far. `firstLineID + index`
+    /// names a line for as long as it stays in the buffer.
+    private(set) var firstLineID = 0
+
+    /// Bumped whenever lines leave the newest end or the buffer is cleared,
+    /// since the IDs at that end are then reused for different content.
+    private(set) var rewriteEpoch = 0
+
     // MARK: - Initialization
 
-    /// Create a scrollback buffer with the given maximum line capacity.
-    init(maxLines: Int = TerminalDefaults.maxScrollbackLines) {
+    /// Create a scrollback buffer with the given line and byte budget.
+    /// Pass a nil-returning `spillFile` to keep all history in memory, and
+    /// `indexesText` to build a `ScrollbackTrigramFilter` for each page.
+    init(
+        maxLines: Int = TerminalDefaults.maxScrollbackLines,
+        maxBytes: Int = TerminalDefaults.maxScrollbackBytes,
+        residentPageLimit: Int = TerminalDefaults.scrollbackResidentPages,
+        indexesText: Bool = false,
+        spillFile: @escaping @Sendable () -> ScrollbackSpillFile? = ScrollbackSpillFile.makeDefault
+    ) {
         self.maxLines = max(maxLines, 0)
-        self.storage = []
-        self.storage.reserveCapacity(min(maxLines, 1024))
+        self.maxBytes = max(maxBytes, 0)
+        self.residentPageLimit = max(residentPageLimit, Self.uncompressedPageCount)
+        self.indexesText = indexesText
+        self.spillSlot = ScrollbackSpillSlot(makeFile: spillFile)
+        self.hot.reserveCapacity(min(self.maxLines, Self.hotLineLimit + ScrollbackPage.lineCapacity))
+    }
+
+    private var pagedCount: Int {
+        pages.count * ScrollbackPage.lineCapacity - firstPageSkip
+    }
+
+    /// Approximate bytes held in memory: resident pages, the uncompressed
+    /// hot lines and recycled rows. Spilled pages are not counted.
+    var estimatedMemoryBytes: Int {
+        var bytes = pagedByteCount
+        for index in hotHead..<hot.count {
+            bytes += hot[index].row.estimatedByteCount + MemoryLayout<ScrollbackLine>.stride
+        }
+        for row in recycledRows {
+            bytes += row.estimatedByteCount
+        }
+        return bytes
     }
 
     // MARK: - Adding Lines
@@ -112,41 +212,153 @@ nonisolated struct ScrollbackBuffer: Sendable {
     mutating func push(_ line: ScrollbackLine) {
         guard maxLines > 0 else { return }
 
-        if storage.count < maxLines {
-            // Still filling up — just append
-            storage.append(line)
-            count = storage.count
-        } else {
-            // Buffer is full — overwrite the oldest entry
-            storage[head] = line
-            head = (head + 1) % maxLines
-            // count stays at maxLines
+        hot.append(line)
+        count += 1
+        if hot.count - hotHead >= Self.hotLineLimit + ScrollbackPage.lineCapacity {
+            spillPage()
+        }
+        if count > maxLines {
+            dropFirstLine()
         }
     }
 
-    /// Push a row of cells as a new scrollback line.
-    mutating func push(cells: [TerminalCell], isWrapped: Bool = false, graphemeOverrides: [Int: String]? = nil) {
-        var line = ScrollbackLine(cells: cells, isWrapped: isWrapped, graphemeOverrides: graphemeOverrides)
+    /// Push a row of cells as a new scrollback line. The cells are packed
+    /// into a recycled row when one is free, so a grid row (a `CellRow`)
+    /// moves into scrollback without an intermediate array or allocation.
+    mutating func push<Cells: Collection>(
+        cells: Cells,
+        isWrapped: Bool = false,
+        graphemeOverrides: [Int: String]? = nil
+    ) where Cells.Element == TerminalCell {
+        guard maxLines > 0 else { return }
+        var row = recycledRows.popLast() ?? StyledRow()
+        row.assign(cells)
+        var line = ScrollbackLine(row: row, isWrapped: isWrapped, graphemeOverrides: graphemeOverrides)
         line.needsTrim = true
         push(line)
     }
 
+    /// Keep the storage of `hot[range]` for later pushes. The lines are
+    /// about to be removed.
+    private mutating func recycleHotRows(_ range: Range<Int>) {
+        for index in range {
+            guard recycledRows.count < Self.recycledRowLimit else { return }
+            recycledRows.append(hot[index].row)
+            hot[index].row = StyledRow()
+        }
+    }
+
+    /// Move the oldest page worth of hot lines into a new page.
+    private mutating func spillPage() {
+        let end = hotHead + ScrollbackPage.lineCapacity
+        for i in hotHead..<end {
+            hot[i].trimIfNeeded()
+        }
+        let page = ScrollbackPage(lines: hot[hotHead..<end], indexed: indexesText)
+        pages.append(page)
+        pagedByteCount += page.byteCount
+        recycleHotRows(0..<end)
+        hot.removeSubrange(0..<end)
+        hotHead = 0
+
+        let coldIndex = pages.count - 1 - Self.uncompressedPageCount
+        if coldIndex >= 0 {
+            pagedByteCount += pages[coldIndex].compress()
+        }
+        let spillIndex = pages.count - 1 - residentPageLimit
+        if spillIndex >= 0, let file = spillSlot.spillFile() {
+            pagedByteCount += pages[spillIndex].spill(to: file)
+        }
+        while pagedByteCount > maxBytes, pages.count > 1 {
+            dropFirstPage()
+        }
+    }
+
+    private mutating func dropFirstLine() {
+        if pagedCount > 0 {
+            if firstPageSkip + 1 == ScrollbackPage.lineCapacity {
+                dropFirstPage()
+                return
+            }
+            firstPageSkip += 1
+        } else {
+            hotHead += 1
+            if hotHead >= Self.hotLineLimit {
+                recycleHotRows(0..<hotHead)
+                hot.removeSubrange(0..<hotHead)
+                hotHead = 0
+            }
+        }
+        count -= 1
+        firstLineID += 1
+        dropDeferredReflowPrefix(1)
+    }
+
+    private mutating func dropFirstPage() {
+        let page = pages.removeFirst()
+        pagedByteCount -= page.byteCount
+        let dropped = ScrollbackPage.lineCapacity - firstPageSkip
+        count -= dropped
+        firstLineID += dropped
+        firstPageSkip = 0
+        dropDeferredReflowPrefix(dropped)
+    }
+
+    /// Discard the oldest lines until at most `limit` remain, whole
+    /// pages first.
+    mutating func trim(toLines limit: Int) {
+        let limit = max(limit, 0)
+        while pagedCount > 0, count - (ScrollbackPage.lineCapacity - firstPageSkip) >= limit {
+            dropFirstPage()
+        }
+        while count > limit {
+            dropFirstLine()
+        }
+    }
+
+    /// Shrink the buffer for a session nobody is looking at: every full
+    /// page of hot lines moves into a page, every resident page is
+    /// compressed and decoded pages are dropped. At most one page of
+    /// lines stays uncompressed. Reads keep working and decode on demand.
+    /// Returns the change in `estimatedMemoryBytes` (zero or negative).
+    @discardableResult
+    mutating func compact() -> Int {
+        let before = estimatedMemoryBytes
+        while hot.count - hotHead >= ScrollbackPage.lineCapacity {
+            spillPage()
+        }
+        // Drop the capacity reserved for a full hot tail as well.
+        hot = Array(hot[hotHead...])
+        recycledRows = []
+        hotHead = 0
+        for page in pages {
+            pagedByteCount += page.compress()
+        }
+        pageCache.removeAll()
+        return estimatedMemoryBytes - before
+    }
+
     // MARK: - Accessing Lines
 
     /// Access a line by logical index (0 = oldest line in buffer).
     /// Returns nil if index is out of range.
     func line(at index: Int) -> ScrollbackLine? {
         guard index >= 0 && index < count else { return nil }
-        let storageIndex = (head + index) % storage.count
-        return storage[storageIndex]
+        let paged = pagedCount
+        if index >= paged {
+            return hot[hotHead + index - paged]
+        }
+        let position = index + firstPageSkip
+        let lines = pageCache.lines(for: pages[position / ScrollbackPage.lineCapacity])
+        let offset = position % ScrollbackPage.lineCapacity
+        return offset < lines.count ? lines[offset] : nil
     }
 
     /// Access a line by logical index (0 = oldest).
     subscript(index: Int) -> ScrollbackLine {
-        precondition(index >= 0 && index < count && !storage.isEmpty,
+        precondition(index >= 0 && index < count,
                      "ScrollbackBuffer index \(index) out of range (count: \(count))")
-        let storageIndex = (head + index) % storage.count
-        return storage[storageIndex]
+        return line(at: index) ?? ScrollbackLine(cells: [])
     }
 
     /// The most recently added line (bottom of scrollback, just above visible area).
@@ -176,15 +388,34 @@ nonisolated struct ScrollbackBuffer: Sendable {
     mutating func popLast() -> ScrollbackLine? {
         guard count > 0 else { return nil }
 
-        let lastIndex = (head + count - 1) % storage.count
-        storage[lastIndex].trimIfNeeded()
-        let line = storage[lastIndex]
+        if hot.count == hotHead, let page = pages.popLast() {
+            // Hot tail is empty: bring the newest page back as plain lines.
+            var lines = page.decodeLines()
+            if pages.isEmpty {
+                lines.removeFirst(min(firstPageSkip, lines.count))
+                firstPageSkip = 0
+            }
+            pagedByteCount -= page.byteCount
+            hot = lines
+            hotHead = 0
+        }
+        guard hot.count > hotHead else { return nil }
+
+        var line = hot.removeLast()
+        line.trimIfNeeded()
         count -= 1
+        rewriteEpoch += 1
+        if let last = deferredReflow.indices.last, deferredReflowLineCount > count {
+            deferredReflow[last].lineCount -= 1
+            if deferredReflow[last].lineCount == 0 {
+                deferredReflow.removeLast()
+            }
+            deferredReflowLineCount -= 1
+        }
 
         // If we've emptied the buffer, reset state
         if count == 0 {
-            head = 0
-            storage.removeAll(keepingCapacity: true)
+            clear()
         }
 
         return line
@@ -192,35 +423,84 @@ nonisolated struct ScrollbackBuffer: Sendable {
 
     /// Clear all lines from the buffer.
     mutating func clear() {
-        storage.removeAll(keepingCapacity: true)
-        head = 0
+        pages.removeAll()
+        firstPageSkip = 0
+        pagedByteCount = 0
+        hot.removeAll(keepingCapacity: true)
+        hotHead = 0
         count = 0
+        pageCache.removeAll()
+        deferredReflow.removeAll()
+        deferredReflowLineCount = 0
+        rewriteEpoch += 1
+    }
+
+    /// Remove the newest `n` lines and return them, oldest first.
+    mutating func removeLast(_ n: Int) -> [ScrollbackLine] {
+        var lines: [ScrollbackLine] = []
+        lines.reserveCapacity(min(max(n, 0), count))
+        for _ in 0..<min(max(n, 0), count) {
+            guard let line = popLast() else { break }
+            lines.append(line)
+        }
+        lines.reverse()
+        return lines
+    }
+
+    // MARK: - Deferred Reflow
+
+    /// Index from which a resize should rewrap history immediately: at most
+    /// `recent` lines from the end, moved back to the start of a logical
+    /// line, and never inside the deferred prefix.
+    func reflowBoundary(keeping recent: Int) -> Int {
+        var boundary = max(count - max(recent, 0), deferredReflowLineCount)
+        while boundary > deferredReflowLineCount, line(at: boundary)?.isWrapped == true {
+            boundary -= 1
+        }
+        return boundary
+    }
+
+    /// Record that lines up to `lineCount` (those not already deferred) are
+    /// still laid out for `columns` and were not rewrapped by a resize.
+    mutating func deferReflow(throughLine lineCount: Int, columns: Int) {
+        let added = min(lineCount, count) - deferredReflowLineCount
+        guard added > 0 else { return }
+        if let last = deferredReflow.indices.last, deferredReflow[last].columns == columns {
+            deferredReflow[last].lineCount += added
+        } else {
+            deferredReflow.append(DeferredReflowSegment(lineCount: added, columns: columns))
+        }
+        deferredReflowLineCount += added
+    }
+
+    private mutating func dropDeferredReflowPrefix(_ n: Int) {
+        var remaining = min(n, deferredReflowLineCount)
+        deferredReflowLineCount -= remaining
+        while remaining > 0, !deferredReflow.isEmpty {
+            let take = min(remaining, deferredReflow[0].lineCount)
+            deferredReflow[0].lineCount -= take
+            remaining -= take
+            if deferredReflow[0].lineCount == 0 {
+                deferredReflow.removeFirst()
+            }
+        }
     }
 
     // MARK: - Bulk Operations
 
     /// Return all lines as an array, ordered from oldest to newest.
     mutating func allLines() -> [ScrollbackLine] {
-        guard count > 0, !storage.isEmpty else { return [] }
+        guard count > 0 else { return [] }
 
         // Trim in-place before returning
-        for i in 0..<storage.count {
-            storage[i].trimIfNeeded()
+        for i in hotHead..<hot.count {
+            hot[i].trimIfNeeded()
         }
 
         var result: [ScrollbackLine] = []
         result.reserveCapacity(count)
-
-        let firstChunkCount = min(count, storage.count - head)
-        if firstChunkCount > 0 {
-            result.append(contentsOf: storage[head..<(head + firstChunkCount)])
-        }
-
-        let remaining = count - firstChunkCount
-        if remaining > 0 {
-            result.append(contentsOf: storage[0..<remaining])
-        }
-
+        forEachPagedLine { _, line in result.append(line) }
+        result.append(contentsOf: hot[hotHead...])
         return result
     }
 
@@ -230,11 +510,15 @@ nonisolated struct ScrollbackBuffer: Sendable {
         guard take > 0 else { return [] }
         var result = [ScrollbackLine]()
         result.reserveCapacity(take)
-        let start = count - take
-        for i in start..<count {
-            let storageIndex = (head + i) % storage.count
-            storage[storageIndex].trimIfNeeded()
-            result.append(storage[storageIndex])
+        let paged = pagedCount
+        for i in (count - take)..<count {
+            if i >= paged {
+                let hotIndex = hotHead + i - paged
+                hot[hotIndex].trimIfNeeded()
+                result.append(hot[hotIndex])
+            } else if let line = line(at: i) {
+                result.append(line)
+            }
         }
         return result
     }
@@ -245,14 +529,61 @@ nonisolated struct ScrollbackBuffer: Sendable {
         var matches = [Int]()
         let searchText = caseSensitive ? query : query.lowercased()
 
-        for i in 0..<count {
-            let line = self[i]
+        func check(_ index: Int, _ line: ScrollbackLine) {
             let lineText = (0..<line.count).map { line.grapheme(at: $0) }.joined()
             let compareText = caseSensitive ? lineText : lineText.lowercased()
             if compareText.contains(searchText) {
-                matches.append(i)
+                matches.append(index)
             }
         }
+
+        forEachPagedLine(check)
+        let paged = pagedCount
+        for i in hotHead..<hot.count {
+            check(paged + i - hotHead, hot[i])
+        }
         return matches
     }
+
+    /// Visit lines from logical index `start` to the newest, oldest first,
+    /// decoding each page once without disturbing the page cache. Stops
+    /// early when `body` returns false. Pages whose trigram filter lacks
+    /// any of `trigrams` are skipped without decoding. Used by
+    /// ScrollbackSearchEngine on a copy of the buffer, off the engine actor.
+    func forEachLine(from start: Int, trigrams: [Int] = [], _ body: (Int, ScrollbackLine) -> Bool) {
+        var index = max(start, 0)
+        let paged = pagedCount
+        while index < paged {
+            let position = index + firstPageSkip
+            let page = pages[position / ScrollbackPage.lineCapacity]
+            let lines = page.mayContainTrigrams(trigrams) ? page.decodeLines() : []
+            var offset = position % ScrollbackPage.lineCapacity
+            while offset < lines.count, index < paged {
+                guard body(index, lines[offset]) else { return }
+                offset += 1
+                index += 1
+            }
+            // A page that was filtered out or failed to decode is skipped
+            // as a whole.
+            index = max(index, (position / ScrollbackPage.lineCapacity + 1) * ScrollbackPage.lineCapacity - firstPageSkip)
+        }
+        while index < count {
+            guard body(index, hot[hotHead + index - paged]) else { return }
+            index += 1
+        }
+    }
+
+    /// Visit every paged line in order, decoding one page at a time without
+    /// disturbing the page cache.
+    private func forEachPagedLine(_ body: (Int, ScrollbackLine) -> Void) {
+        var index = 0
+        for (pageIndex, page) in pages.enumerated() {
+            let lines = page.decodeLines()
+            let start = pageIndex == 0 ? min(firstPageSkip, lines.count) : 0
+            for line in lines[start...] {
+                body(index, line)
+                index += 1
+            }
+        }
+    }
 }
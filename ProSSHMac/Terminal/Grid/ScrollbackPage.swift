@@ -0,0 +1,338 @@
+// ScrollbackPage.swift
+// ProSSHV2
+//
+// Compact, optionally compressed storage for a fixed-size page of
+// scrollback lines. ScrollbackBuffer keeps only its most recent lines as
+// `ScrollbackLine` values and moves older ones into pages.
+//
+// Encoding (little-endian, one byte buffer per page) serializes each
+// line's `StyledRow`:
+//   header    lineCount, cellCount, spanCount, widthCount   4 × UInt32
+//   lines     cell count, span count                        lineCount × 2 × UInt32
+//   flags     bit 0 = wrapped, bit 1 = has widths           lineCount × UInt8
+//   text      one codepoint per cell                        cellCount × UInt32
+//   spans     length, fg, bg, underline colour,             spanCount × 19 bytes
+//             attributes, underline style
+//   widths    per-cell widths of flagged lines only          widthCount × UInt8
+// Multi-codepoint graphemes are rare and kept beside the buffer, keyed by
+// line. Cold pages are LZ4-compressed in place and decoded on demand; the
+// coldest can move out of memory entirely into a `ScrollbackSpillFile`.
+// An indexed page also keeps a `ScrollbackTrigramFilter` in memory, so
+// search can skip it without decoding.
+
+import Compression
+import Foundation
+
+// MARK: - ScrollbackPage
+
+nonisolated final class ScrollbackPage: @unchecked Sendable {
+
+    /// Lines per page. ScrollbackBuffer always fills pages completely.
+    static let lineCapacity = 256
+
+    private static let headerSize = 16
+    private static let spanSize = 19
+
+    let lineCount: Int
+
+    private let lock = NSLock()
+    /// Encoded bytes, or their LZ4 form once `compress()` has run. Empty
+    /// once the page has been spilled.
+    private var bytes: [UInt8]
+    private var isCompressedStorage = false
+    private var spilled: (file: ScrollbackSpillFile, extent: ScrollbackSpillFile.Extent)?
+    private let rawByteCount: Int
+    private let graphemeOverrides: [Int: [Int: String]]?
+
+    /// Trigrams of the page's text, when built with `indexed`.
+    let trigrams: ScrollbackTrigramFilter?
+
+    /// Encode `lines`, which must already be trimmed. With `indexed`, also
+    /// build the page's trigram filter.
+    init(lines: ArraySlice<ScrollbackLine>, indexed: Bool = false) {
+        lineCount = lines.count
+        var overrides: [Int: [Int: String]]?
+        let encoded = Self.encode(lines, graphemeOverrides: &overrides)
+        bytes = encoded
+        rawByteCount = encoded.count
+        graphemeOverrides = overrides
+        trigrams = indexed ? ScrollbackTrigramFilter(lines: lines) : nil
+    }
+
+    deinit {
+        if let spilled {
+            spilled.file.release(spilled.extent)
+        }
+    }
+
+    /// Bytes this page currently holds in memory, including its filter.
+    var byteCount: Int {
+        lock.lock()
+        defer { lock.unlock() }
+        return bytes.count + (trigrams?.byteCount ?? 0)
+    }
+
+    /// Whether the page may hold every trigram in `keys`. True for pages
+    /// without a filter.
+    func mayContainTrigrams(_ keys: [Int]) -> Bool {
+        trigrams?.mayContainAll(keys) ?? true
+    }
+
+    var isCompressed: Bool {
+        lock.lock()
+        defer { lock.unlock() }
+        return isCompressedStorage
+    }
+
+    var isSpilled: Bool {
+        lock.lock()
+        defer { lock.unlock() }
+        return spilled != nil
+    }
+
+    /// Replace the encoding with its LZ4 form when that is smaller.
+    /// Returns the change in `byteCount` (zero or negative).
+    @discardableResult
+    func compress() -> Int {
+        lock.lock()
+        defer { lock.unlock() }
+        guard !isCompressedStorage, spilled == nil, !bytes.isEmpty else { return 0 }
+
+        var compressed = [UInt8](repeating: 0, count: bytes.count)
+        let size = bytes.withUnsafeBufferPointer { source in
+            compressed.withUnsafeMutableBufferPointer { destination in
+                compression_encode_buffer(
+                    destination.baseAddress!, destination.count,
+                    source.baseAddress!, source.count,
+                    nil, COMPRESSION_LZ4
+                )
+            }
+        }
+        guard size > 0, size < bytes.count else { return 0 }
+        compressed.removeSubrange(size...)
+        let delta = size - bytes.count
+        bytes = compressed
+        isCompressedStorage = true
+        return delta
+    }
+
+    /// Move the stored bytes into `file` and release them. Returns the
+    /// change in `byteCount`; zero if the page stays in memory.
+    @discardableResult
+    func spill(to file: ScrollbackSpillFile) -> Int {
+        lock.lock()
+        defer { lock.unlock() }
+        guard spilled == nil, !bytes.isEmpty,
+              let extent = file.write(bytes) else { return 0 }
+        spilled = (file, extent)
+        let delta = -bytes.count
+        bytes = []
+        return delta
+    }
+
+    /// Decode every line of the page, oldest first.
+    func decodeLines() -> [ScrollbackLine] {
+        let raw: [UInt8]
+        lock.lock()
+        let stored: [UInt8]
+        if let spilled {
+            guard let loaded = spilled.file.read(spilled.extent) else {
+                lock.unlock()
+                return []
+            }
+            stored = loaded
+        } else {
+            stored = bytes
+        }
+        if isCompressedStorage {
+            var decompressed = [UInt8](repeating: 0, count: rawByteCount)
+            let size = stored.withUnsafeBufferPointer { source in
+                decompressed.withUnsafeMutableBufferPointer { destination in
+                    compression_decode_buffer(
+                        destination.baseAddress!, destination.count,
+                        source.baseAddress!, source.count,
+                        nil, COMPRESSION_LZ4
+                    )
+                }
+            }
+            lock.unlock()
+            guard size == rawByteCount else { return [] }
+            raw = decompressed
+        } else {
+            raw = stored
+            lock.unlock()
+        }
+        return Self.decode(raw, graphemeOverrides: graphemeOverrides)
+    }
+
+    // MARK: - Encoding
+
+    private static func encode(
+        _ lines: ArraySlice<ScrollbackLine>,
+        graphemeOverrides: inout [Int: [Int: String]]?
+    ) -> [UInt8] {
+        var cellCount = 0
+        var spanCount = 0
+        var widthCount = 0
+        for line in lines {
+            cellCount += line.row.count
+            spanCount += line.row.spans.count
+            if line.row.widths != nil { widthCount += line.row.count }
+        }
+
+        var bytes: [UInt8] = []
+        bytes.reserveCapacity(headerSize + lines.count * 9 + cellCount * 4 + spanCount * spanSize + widthCount)
+        appendInteger(&bytes, UInt32(lines.count))
+        appendInteger(&bytes, UInt32(cellCount))
+        appendInteger(&bytes, UInt32(spanCount))
+        appendInteger(&bytes, UInt32(widthCount))
+
+        for line in lines {
+            appendInteger(&bytes, UInt32(line.row.count))
+            appendInteger(&bytes, UInt32(line.row.spans.count))
+        }
+        for (offset, line) in lines.enumerated() {
+            bytes.append((line.isWrapped ? 1 : 0) | (line.row.widths != nil ? 2 : 0))
+            if let overrides = line.graphemeOverrides {
+                graphemeOverrides = graphemeOverrides ?? [:]
+                graphemeOverrides?[offset] = overrides
+            }
+        }
+        for line in lines {
+            for codepoint in line.row.codepoints { appendInteger(&bytes, codepoint) }
+        }
+        for line in lines {
+            for span in line.row.spans {
+                appendInteger(&bytes, UInt32(span.length))
+                appendInteger(&bytes, span.fgPackedRGBA)
+                appendInteger(&bytes, span.bgPackedRGBA)
+                appendInteger(&bytes, span.underlinePackedRGBA)
+                appendInteger(&bytes, span.attributes.rawValue)
+                bytes.append(span.underlineStyle.rawValue)
+            }
+        }
+        for line in lines {
+            if let widths = line.row.widths { bytes.append(contentsOf: widths) }
+        }
+        return bytes
+    }
+
+    @inline(__always)
+    private static func appendInteger<T: FixedWidthInteger>(_ bytes: inout [UInt8], _ value: T) {
+        withUnsafeBytes(of: value.littleEndian) { bytes.append(contentsOf: $0) }
+    }
+
+    // MARK: - Decoding
+
+    private static func decode(
+        _ bytes: [UInt8],
+        graphemeOverrides: [Int: [Int: String]]?
+    ) -> [ScrollbackLine] {
+        bytes.withUnsafeBytes { raw -> [ScrollbackLine] in
+            guard raw.count >= headerSize else { return [] }
+            func integer<T: FixedWidthInteger>(_ offset: Int, as type: T.Type) -> T {
+                T(littleEndian: raw.loadUnaligned(fromByteOffset: offset, as: T.self))
+            }
+
+            let lineCount = Int(integer(0, as: UInt32.self))
+            let cellCount = Int(integer(4, as: UInt32.self))
+            let spanCount = Int(integer(8, as: UInt32.self))
+            let widthCount = Int(integer(12, as: UInt32.self))
+            let linesOffset = headerSize
+            let flagsOffset = linesOffset + lineCount * 8
+            let textOffset = flagsOffset + lineCount
+            let spansOffset = textOffset + cellCount * 4
+            let widthsOffset = spansOffset + spanCount * spanSize
+            guard raw.count == widthsOffset + widthCount else { return [] }
+
+            var lines: [ScrollbackLine] = []
+            lines.reserveCapacity(lineCount)
+            var cellIndex = 0
+            var spanIndex = 0
+            var widthIndex = 0
+
+            for lineIndex in 0..<lineCount {
+                let length = Int(integer(linesOffset + lineIndex * 8, as: UInt32.self))
+                let lineSpans = Int(integer(linesOffset + lineIndex * 8 + 4, as: UInt32.self))
+                let flags = raw[flagsOffset + lineIndex]
+                guard cellIndex + length <= cellCount,
+                      spanIndex + lineSpans <= spanCount else { return [] }
+
+                var codepoints: [UInt32] = []
+                codepoints.reserveCapacity(length)
+                for cell in cellIndex..<(cellIndex + length) {
+                    codepoints.append(integer(textOffset + cell * 4, as: UInt32.self))
+                }
+                cellIndex += length
+
+                var spans: [StyleSpan] = []
+                spans.reserveCapacity(lineSpans)
+                for span in spanIndex..<(spanIndex + lineSpans) {
+                    let base = spansOffset + span * spanSize
+                    spans.append(StyleSpan(
+                        length: Int(integer(base, as: UInt32.self)),
+                        fgPacked: integer(base + 4, as: UInt32.self),
+                        bgPacked: integer(base + 8, as: UInt32.self),
+                        ulPacked: integer(base + 12, as: UInt32.self),
+                        attributes: CellAttributes(rawValue: integer(base + 16, as: UInt16.self)),
+                        underlineStyle: UnderlineStyle(rawValue: raw[base + 18]) ?? .none
+                    ))
+                }
+                spanIndex += lineSpans
+
+                var widths: [UInt8]?
+                if flags & 2 != 0 {
+                    guard widthIndex + length <= widthCount else { return [] }
+                    let start = widthsOffset + widthIndex
+                    widths = Array(raw[start..<(start + length)])
+                    widthIndex += length
+                }
+
+                lines.append(ScrollbackLine(
+                    row: StyledRow(codepoints: codepoints, spans: spans, widths: widths),
+                    isWrapped: flags & 1 != 0,
+                    graphemeOverrides: graphemeOverrides?[lineIndex]
+                ))
+            }
+            return lines
+        }
+    }
+}
+
+// MARK: - ScrollbackPageCache
+
+/// Most recently decoded pages, shared by copies of a ScrollbackBuffer.
+/// Scrolling back through history touches the same few pages repeatedly.
+nonisolated final class ScrollbackPageCache: @unchecked Sendable {
+
+    private static let capacity = 4
+
+    private let lock = NSLock()
+    private var entries: [(page: ScrollbackPage, lines: [ScrollbackLine])] = []
+
+    func lines(for page: ScrollbackPage) -> [ScrollbackLine] {
+        lock.lock()
+        if let index = entries.firstIndex(where: { $0.page === page }) {
+            let entry = entries.remove(at: index)
+            entries.append(entry)
+            lock.unlock()
+            return entry.lines
+        }
+        lock.unlock()
+
+        let lines = page.decodeLines()
+        lock.lock()
+        entries.append((page, lines))
+        if entries.count > Self.capacity {
+            entries.removeFirst()
+        }
+        lock.unlock()
+        return lines
+    }
+
+    func removeAll() {
+        lock.lock()
+        entries.removeAll()
+        lock.unlock()
+    }
+}
@@ -0,0 +1,51 @@
+// ScrollbackRowCache.swift
+// ProSSHV2
+//
+// Encoded CellInstance rows for scrollback lines, keyed by the line's
+// stable ID in ScrollbackBuffer. While the user scrolls through history,
+// moving the viewport by one row re-encodes only the newly exposed line;
+// the rest are copied out of the cache with their display row patched in.
+
+import Foundation
+
+nonisolated struct ScrollbackRowCache: Sendable {
+
+    /// One scrollback line encoded at the cache's column count. `cells.row`
+    /// is left at 0; the snapshot sets it per display row.
+    struct Row: Sendable {
+        var cells: ContiguousArray<CellInstance>
+        /// Grapheme clusters by column.
+        var graphemes: [Int: String]?
+    }
+
+    private var rows: [Int: Row] = [:]
+    private var columns = 0
+    private var epoch = -1
+
+    var count: Int { rows.count }
+
+    /// Drop everything if the width or the buffer's rewrite epoch changed
+    /// since the cached rows were encoded.
+    mutating func validate(columns: Int, epoch: Int) {
+        guard columns != self.columns || epoch != self.epoch else { return }
+        rows.removeAll(keepingCapacity: true)
+        self.columns = columns
+        self.epoch = epoch
+    }
+
+    subscript(lineID: Int) -> Row? {
+        get { rows[lineID] }
+        set { rows[lineID] = newValue }
+    }
+
+    /// Keep only lines in `window` once the cache holds more than `limit`.
+    mutating func trim(keeping window: Range<Int>, limit: Int) {
+        guard rows.count > limit else { return }
+        rows = rows.filter { window.contains($0.key) }
+    }
+
+    mutating func removeAll() {
+        rows.removeAll()
+        epoch = -1
+    }
+}
@@ -0,0 +1,193 @@
+// ScrollbackSpillFile.swift
+// ProSSHV2
+//
+// On-disk home for cold scrollback pages. Once a ScrollbackBuffer holds
+// more than its resident window of pages, older pages are sealed with
+// AES-GCM and appended here, and their in-memory bytes are released.
+//
+// The file is created in Caches and unlinked immediately, so it vanishes
+// when the last page referencing it is freed or the app exits, crash
+// included. It grows in sparse `segmentSize` steps; each segment is mapped
+// read-only once, so reading an old page back is a copy out of the
+// mapping plus decryption. Pages freed by eviction punch holes in the file
+// so disk use follows live history rather than total output.
+//
+// The key is derived per file from the EncryptedStorage master key with a
+// random salt; plaintext history never reaches the disk.
+
+import CryptoKit
+import Foundation
+import os.log
+
+// MARK: - ScrollbackSpillFile
+
+nonisolated final class ScrollbackSpillFile: @unchecked Sendable {
+
+    /// Location of a sealed page within the file.
+    struct Extent: Sendable {
+        let offset: Int
+        let length: Int
+    }
+
+    static let segmentSize = 64 * 1024 * 1024
+    private static let holeGranularity = 4096
+    private static let logger = Logger(subsystem: "com.prossh", category: "ScrollbackSpill")
+
+    private let lock = NSLock()
+    private let descriptor: Int32
+    private let key: SymmetricKey
+    private var segments: [UnsafeRawPointer] = []
+    private var writeOffset = 0
+
+    /// Bytes of sealed pages still referenced.
+    private(set) var liveByteCount = 0
+
+    /// Create (and immediately unlink) a spill file in `directory`.
+    init(directory: URL, key: SymmetricKey) throws {
+        try FileManager.default.createDirectory(at: directory, withIntermediateDirectories: true)
+        let path = directory.appendingPathComponent("\(UUID().uuidString).spill").path(percentEncoded: false)
+        let fd = open(path, O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0o600)
+        guard fd >= 0 else {
+            throw POSIXError(POSIXErrorCode(rawValue: errno) ?? .EIO)
+        }
+        unlink(path)
+        self.descriptor = fd
+        self.key = key
+    }
+
+    deinit {
+        for segment in segments {
+            munmap(UnsafeMutableRawPointer(mutating: segment), Self.segmentSize)
+        }
+        close(descriptor)
+    }
+
+    /// Spill file for ScrollbackBuffer: Caches/ProSSHV2/ScrollbackSpill,
+    /// keyed from the master key. Nil (history stays in memory) when the
+    /// key or the file is unavailable.
+    static func makeDefault() -> ScrollbackSpillFile? {
+        let fileManager = FileManager.default
+        let directory = (fileManager.urls(for: .cachesDirectory, in: .userDomainMask).first
+            ?? fileManager.temporaryDirectory)
+            .appendingPathComponent("ProSSHV2", isDirectory: true)
+            .appendingPathComponent("ScrollbackSpill", isDirectory: true)
+        do {
+            let salt = SymmetricKey(size: .bits256).withUnsafeBytes { Data($0) }
+            let key = try EncryptedStorage.derivedKey(purpose: "scrollback-spill-v1", salt: salt)
+            return try ScrollbackSpillFile(directory: directory, key: key)
+        } catch {
+            logger.error("Scrollback spill unavailable: \(error.localizedDescription, privacy: .public)")
+            return nil
+        }
+    }
+
+    // MARK: - Writing
+
+    /// Seal `bytes` and append them. Returns nil if encryption or the write
+    /// fails; the caller keeps the bytes in memory.
+    func write(_ bytes: [UInt8]) -> Extent? {
+        guard let sealed = try? AES.GCM.seal(Data(bytes), using: key).combined,
+              sealed.count <= Self.segmentSize else { return nil }
+
+        lock.lock()
+        defer { lock.unlock() }
+
+        // Keep every extent inside one segment so reads never straddle maps.
+        var offset = writeOffset
+        let segmentEnd = (offset / Self.segmentSize + 1) * Self.segmentSize
+        if offset + sealed.count > segmentEnd {
+            offset = segmentEnd
+        }
+        guard mapSegments(through: offset + sealed.count) else { return nil }
+
+        let written = sealed.withUnsafeBytes { buffer in
+            pwrite(descriptor, buffer.baseAddress, buffer.count, off_t(offset))
+        }
+        guard written == sealed.count else {
+            Self.logger.error("Scrollback spill write failed (errno \(errno))")
+            return nil
+        }
+        writeOffset = offset + sealed.count
+        liveByteCount += sealed.count
+        return Extent(offset: offset, length: sealed.count)
+    }
+
+    /// Grow the file and map new segments so `end` is readable.
+    private func mapSegments(through end: Int) -> Bool {
+        while segments.count * Self.segmentSize < end {
+            let fileLength = (segments.count + 1) * Self.segmentSize
+            guard ftruncate(descriptor, off_t(fileLength)) == 0 else { return false }
+            let mapped = mmap(
+                nil, Self.segmentSize, PROT_READ, MAP_SHARED,
+                descriptor, off_t(segments.count * Self.segmentSize)
+            )
+            guard let mapped, mapped != UnsafeMutableRawPointer(bitPattern: -1) else { return false }
+            segments.append(UnsafeRawPointer(mapped))
+        }
+        return true
+    }
+
+    // MARK: - Reading
+
+    /// The plaintext of a sealed page, or nil if it fails to authenticate.
+    func read(_ extent: Extent) -> [UInt8]? {
+        lock.lock()
+        let segmentIndex = extent.offset / Self.segmentSize
+        guard segmentIndex < segments.count else {
+            lock.unlock()
+            return nil
+        }
+        let sealed = Data(
+            bytes: segments[segmentIndex] + extent.offset % Self.segmentSize,
+            count: extent.length
+        )
+        lock.unlock()
+
+        guard let box = try? AES.GCM.SealedBox(combined: sealed),
+              let plaintext = try? AES.GCM.open(box, using: key) else { return nil }
+        return [UInt8](plaintext)
+    }
+
+    // MARK: - Releasing
+
+    /// Forget a page and return the disk blocks it covered.
+    func release(_ extent: Extent) {
+        lock.lock()
+        defer { lock.unlock() }
+        liveByteCount -= extent.length
+
+        let granularity = Self.holeGranularity
+        let start = (extent.offset + granularity - 1) / granularity * granularity
+        let end = (extent.offset + extent.length) / granularity * granularity
+        guard end > start else { return }
+        var hole = fpunchhole_t(fp_flags: 0, reserved: 0, fp_offset: off_t(start), fp_length: off_t(end - start))
+        _ = fcntl(descriptor, F_PUNCHHOLE, &hole)
+    }
+}
+
+// MARK: - ScrollbackSpillSlot
+
+/// Lazily opened spill file shared by copies of a ScrollbackBuffer. The
+/// file is only created when history first outgrows its resident window,
+/// and a failure is remembered so it is not retried for every page.
+nonisolated final class ScrollbackSpillSlot: @unchecked Sendable {
+
+    private let lock = NSLock()
+    private let makeFile: @Sendable () -> ScrollbackSpillFile?
+    private var file: ScrollbackSpillFile?
+    private var attempted = false
+
+    init(makeFile: @escaping @Sendable () -> ScrollbackSpillFile? = ScrollbackSpillFile.makeDefault) {
+        self.makeFile = makeFile
+    }
+
+    func spillFile() -> ScrollbackSpillFile? {
+        lock.lock()
+        defer { lock.unlock() }
+        if !attempted {
+            attempted = true
+            file = makeFile()
+        }
+        return file
+    }
+}
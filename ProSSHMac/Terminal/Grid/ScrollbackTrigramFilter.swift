@@ -0,0 +1,177 @@
+// ScrollbackTrigramFilter.swift
+// ProSSHV2
+//
+// Optional per-page trigram index for scrollback search. Without it, every
+// search pass over a long history decodes every page, and cold pages have
+// to be decompressed or read back from the spill file first.
+//
+// When a session enables the index, each ScrollbackPage builds a filter as
+// it is sealed, with one bit for each trigram in its lines. Trigrams are
+// taken from case-folded scalars, so one filter serves both case-sensitive
+// and case-insensitive queries. Those bits are the page's posting list: a
+// page is only decoded and verified when it has every trigram the query
+// needs. Bits are hashed, so a page may pass when it has no match, but a
+// page with a match always passes. The matcher still checks each line.
+//
+// Each filter is a fixed 2 KiB and stays in memory when its page is
+// compressed or spilled. Hot lines are not indexed; they are always
+// scanned.
+//
+// Toggle via: `defaults write com.prossh terminal.scrollback.trigramIndex -bool true`
+
+import Foundation
+
+// MARK: - ScrollbackTrigramFilter
+
+nonisolated struct ScrollbackTrigramFilter: Sendable {
+
+    static let enabledDefaultsKey = "terminal.scrollback.trigramIndex"
+
+    /// Bits per filter; a power of two.
+    static let bitCount = 16_384
+
+    private var words: [UInt64]
+
+    init() {
+        words = [UInt64](repeating: 0, count: Self.bitCount / 64)
+    }
+
+    /// A filter over `lines`.
+    init<Lines: Sequence>(lines: Lines) where Lines.Element == ScrollbackLine {
+        self.init()
+        var text = ScrollbackLineText()
+        for line in lines {
+            text.load(line, folding: true)
+            let scalars = text.scalars
+            guard scalars.count >= 3 else { continue }
+            for index in 0...(scalars.count - 3) {
+                insert(Self.key(scalars[index], scalars[index + 1], scalars[index + 2]))
+            }
+        }
+    }
+
+    /// Memory held by the filter.
+    var byteCount: Int { words.count * 8 }
+
+    /// Whether every key in `keys` may be present.
+    func mayContainAll(_ keys: [Int]) -> Bool {
+        for key in keys where words[key >> 6] & (1 << UInt64(key & 63)) == 0 {
+            return false
+        }
+        return true
+    }
+
+    private mutating func insert(_ key: Int) {
+        words[key >> 6] |= 1 << UInt64(key & 63)
+    }
+
+    // MARK: - Keys
+
+    /// Bit position of the trigram `a b c` (folded scalars).
+    @inline(__always)
+    static func key(_ a: UInt32, _ b: UInt32, _ c: UInt32) -> Int {
+        var hash = a &* 0x9E37_79B1
+        hash = (hash ^ (hash >> 15) ^ b) &* 0x85EB_CA77
+        hash = (hash ^ (hash >> 13) ^ c) &* 0xC2B2_AE3D
+        hash ^= hash >> 16
+        return Int(hash) & (bitCount - 1)
+    }
+
+    /// Keys a line must contain for `query` to match it, deduplicated.
+    /// Empty when the query gives nothing to narrow by, in which case every
+    /// page has to be searched.
+    static func requiredKeys(for query: ScrollbackSearchQuery) -> [Int] {
+        let runs = query.isRegex ? requiredLiterals(inRegex: query.text) : [query.text]
+        var keys = Set<Int>()
+        for run in runs {
+            let scalars = ScrollbackLineText.fold(run)
+            guard scalars.count >= 3 else { continue }
+            for index in 0...(scalars.count - 3) {
+                keys.insert(key(scalars[index], scalars[index + 1], scalars[index + 2]))
+            }
+        }
+        return Array(keys)
+    }
+
+    /// Literal runs every match of `pattern` must contain. Conservative: a
+    /// pattern with alternation yields none, and text inside groups,
+    /// bracket expressions and before an optional quantifier is ignored.
+    static func requiredLiterals(inRegex pattern: String) -> [String] {
+        let scalars = Array(pattern.unicodeScalars)
+        guard !scalars.contains("|"), !enablesFreeSpacing(pattern) else { return [] }
+
+        var runs: [String] = []
+        var run = String.UnicodeScalarView()
+        func finishRun() {
+            if run.count >= 3 { runs.append(String(run)) }
+            run = String.UnicodeScalarView()
+        }
+
+        var depth = 0
+        var index = 0
+        while index < scalars.count {
+            let scalar = scalars[index]
+            index += 1
+            switch scalar {
+            case "\\":
+                guard index < scalars.count else { break }
+                let escaped = scalars[index]
+                index += 1
+                if depth == 0, !escaped.properties.isAlphabetic, !("0"..."9").contains(escaped) {
+                    run.append(escaped)
+                } else {
+                    // \d, \w, \b, \Q... name classes or assertions.
+                    finishRun()
+                }
+            case "[":
+                finishRun()
+                // Skip the bracket expression, honouring escapes and a
+                // leading "]" or "^]".
+                if index < scalars.count, scalars[index] == "^" { index += 1 }
+                if index < scalars.count, scalars[index] == "]" { index += 1 }
+                while index < scalars.count, scalars[index] != "]" {
+                    index += scalars[index] == "\\" ? 2 : 1
+                }
+                index += 1
+            case "(":
+                finishRun()
+                depth += 1
+            case ")":
+                finishRun()
+                depth = max(depth - 1, 0)
+            case "?", "*", "{":
+                // The preceding atom may be absent.
+                if !run.isEmpty { run.removeLast() }
+                finishRun()
+                if scalar == "{" {
+                    while index < scalars.count, scalars[index] != "}" { index += 1 }
+                    index += 1
+                }
+            case "+":
+                finishRun()
+            case ".", "^", "$":
+                finishRun()
+            default:
+                if depth == 0 {
+                    run.append(scalar)
+                }
+            }
+        }
+        finishRun()
+        return runs
+    }
+
+    /// Whether `pattern` turns on `(?x)`, under which literal whitespace is
+    /// ignored.
+    private static func enablesFreeSpacing(_ pattern: String) -> Bool {
+        var rest = pattern[...]
+        while let open = rest.range(of: "(?") {
+            let flags = rest[open.upperBound...].prefix { $0.isLetter || $0 == "-" }
+            if flags.prefix { $0 != "-" }.contains("x") {
+                return true
+            }
+            rest = rest[open.upperBound...]
+        }
+        return false
+    }
+}
@@ -0,0 +1,164 @@
+// SemanticZoneIndex.swift
+// ProSSHV2
+//
+// Positions of OSC 133 prompts and command output, so that "previous
+// prompt" and "last command output" are binary searches rather than a
+// manual scroll through history.
+//
+// Lines use the numbering of TerminalGrid.semanticOutputStart: scrollback
+// line IDs, continued down the screen. IDs only grow, so zones are appended
+// in order. Zones whose prompt has left the scrollback are skipped by a
+// moving head and compacted away in batches. The index belongs to one
+// scrollback `rewriteEpoch`; a rewrite or reflow renumbers lines, and
+// then the index starts over. Folding command output renumbers it in
+// place instead (`replaceLines`).
+
+import Foundation
+
+nonisolated struct SemanticZoneIndex: Sendable {
+
+    nonisolated struct Zone: Sendable, Equatable {
+        /// Line of the prompt (OSC 133;A).
+        let promptLine: Int
+        /// First output line (OSC 133;C).
+        var outputStart: Int?
+        /// Line after the last output line (OSC 133;D).
+        var outputEnd: Int?
+    }
+
+    private var zones: [Zone] = []
+    /// Zones before `head` have been evicted with their lines.
+    private var head = 0
+    private(set) var epoch = 0
+
+    var count: Int { zones.count - head }
+
+    /// Live zones, oldest first.
+    var liveZones: ArraySlice<Zone> { zones[head...] }
+
+    // MARK: - Recording
+
+    mutating func notePrompt(line: Int, epoch: Int) {
+        prepare(epoch: epoch)
+        // A prompt redrawn on or above a recorded one (Ctrl-C, clear,
+        // SIGWINCH) replaces the zones from there on.
+        let keep = firstZone(atOrAfter: line)
+        zones.removeSubrange(keep...)
+        zones.append(Zone(promptLine: line))
+    }
+
+    mutating func noteOutputStart(line: Int, epoch: Int) {
+        prepare(epoch: epoch)
+        if let last = zones.indices.last, last >= head, zones[last].outputStart == nil, zones[last].promptLine <= line {
+            zones[last].outputStart = line
+        } else {
+            // Output without a prompt marker of its own.
+            zones.removeSubrange(firstZone(atOrAfter: line)...)
+            zones.append(Zone(promptLine: line, outputStart: line))
+        }
+    }
+
+    mutating func noteOutputEnd(line: Int, epoch: Int) {
+        prepare(epoch: epoch)
+        guard let last = zones.indices.last, last >= head,
+              let start = zones[last].outputStart, zones[last].outputEnd == nil else { return }
+        zones[last].outputEnd = max(start, line)
+    }
+
+    /// Forget zones whose prompt line is below `firstLine`.
+    mutating func dropLines(before firstLine: Int) {
+        head = firstZone(atOrAfter: firstLine)
+        if head > 64, head * 2 > zones.count {
+            zones.removeFirst(head)
+            head = 0
+        }
+    }
+
+    mutating func removeAll() {
+        zones.removeAll()
+        head = 0
+    }
+
+    /// Renumber for `range` having been replaced by `count` lines (command
+    /// output folded or expanded; see TerminalGrid+CommandFolding) in the
+    /// scrollback's new `epoch`. Positions inside `range` move to its first
+    /// line; positions after it shift by the difference.
+    mutating func replaceLines(_ range: Range<Int>, withCount count: Int, epoch: Int) {
+        let delta = count - range.count
+        func map(_ line: Int) -> Int {
+            if line < range.lowerBound { return line }
+            return line >= range.upperBound ? line + delta : range.lowerBound
+        }
+        zones = zones[head...].map { zone in
+            Zone(
+                promptLine: map(zone.promptLine),
+                outputStart: zone.outputStart.map(map),
+                outputEnd: zone.outputEnd.map(map)
+            )
+        }
+        head = 0
+        self.epoch = epoch
+    }
+
+    private mutating func prepare(epoch: Int) {
+        if epoch != self.epoch {
+            removeAll()
+            self.epoch = epoch
+        }
+    }
+
+    // MARK: - Lookup
+
+    /// The last prompt line before `line`.
+    func previousPrompt(before line: Int) -> Int? {
+        let index = firstZone(atOrAfter: line) - 1
+        return index >= head ? zones[index].promptLine : nil
+    }
+
+    /// The first prompt line after `line`.
+    func nextPrompt(after line: Int) -> Int? {
+        let index = firstZone(atOrAfter: line + 1)
+        return index < zones.count ? zones[index].promptLine : nil
+    }
+
+    /// Lines of the newest command output that has finished, as
+    /// `outputStart..<outputEnd`.
+    var lastCompletedOutput: Range<Int>? {
+        for zone in zones[head...].reversed() {
+            if let start = zone.outputStart, let end = zone.outputEnd {
+                return start..<end
+            }
+        }
+        return nil
+    }
+
+    /// Lines of the newest zone's output if it has finished, or of the zone
+    /// before it while the newest is still a bare prompt. Unlike
+    /// `lastCompletedOutput`, never reaches further back than the command
+    /// that just ended.
+    var justCompletedOutput: Range<Int>? {
+        guard let last = zones.indices.last, last >= head else { return nil }
+        var index = last
+        if zones[index].outputStart == nil {
+            index -= 1
+            guard index >= head else { return nil }
+        }
+        guard let start = zones[index].outputStart, let end = zones[index].outputEnd else { return nil }
+        return start..<end
+    }
+
+    /// Index of the first live zone whose prompt is at or after `line`.
+    private func firstZone(atOrAfter line: Int) -> Int {
+        var low = head
+        var high = zones.count
+        while low < high {
+            let mid = (low + high) / 2
+            if zones[mid].promptLine < line {
+                low = mid + 1
+            } else {
+                high = mid
+            }
+        }
+        return low
+    }
+}
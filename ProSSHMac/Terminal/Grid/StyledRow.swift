@@ -0,0 +1,204 @@
+// StyledRow.swift
+// ProSSHV2
+//
+// Compact row representation: the codepoint stream held separately from a
+// run-length list of style spans. A `TerminalCell` spends 16 of its 20
+// bytes on colours and attributes that are identical across long runs, so
+// a typical line of output costs 4 bytes per cell plus one or two spans
+// instead of 20 bytes per cell.
+//
+// The live grid keeps `[TerminalCell]` rows for in-place editing; rows are
+// converted when they scroll into history. `ScrollbackLine` stores a
+// StyledRow and expands cells only on request, and the snapshot and search
+// loops walk codepoints and spans directly.
+
+import Foundation
+
+// MARK: - StyleSpan
+
+/// Styling shared by `length` consecutive cells.
+nonisolated struct StyleSpan: Sendable, Equatable {
+    var length: Int
+    var fgPackedRGBA: UInt32
+    var bgPackedRGBA: UInt32
+    var underlinePackedRGBA: UInt32
+    var attributes: CellAttributes
+    var underlineStyle: UnderlineStyle
+
+    init(length: Int, fgPacked: UInt32, bgPacked: UInt32, ulPacked: UInt32,
+         attributes: CellAttributes, underlineStyle: UnderlineStyle) {
+        self.length = length
+        self.fgPackedRGBA = fgPacked
+        self.bgPackedRGBA = bgPacked
+        self.underlinePackedRGBA = ulPacked
+        self.attributes = attributes
+        self.underlineStyle = underlineStyle
+    }
+
+    init(length: Int, style cell: TerminalCell) {
+        self.init(
+            length: length,
+            fgPacked: cell.fgPackedRGBA,
+            bgPacked: cell.bgPackedRGBA,
+            ulPacked: cell.underlinePackedRGBA,
+            attributes: cell.attributes,
+            underlineStyle: cell.underlineStyle
+        )
+    }
+
+    @inline(__always)
+    func matches(_ cell: TerminalCell) -> Bool {
+        fgPackedRGBA == cell.fgPackedRGBA
+            && bgPackedRGBA == cell.bgPackedRGBA
+            && underlinePackedRGBA == cell.underlinePackedRGBA
+            && attributes == cell.attributes
+            && underlineStyle == cell.underlineStyle
+    }
+
+    /// Whether a space or empty cell with this style is blank per
+    /// `TerminalCell.isBlank`.
+    var isBlankStyle: Bool {
+        fgPackedRGBA == 0 && bgPackedRGBA == 0 && underlinePackedRGBA == 0 && attributes.isEmpty
+    }
+}
+
+// MARK: - StyledRow
+
+nonisolated struct StyledRow: Sendable {
+
+    /// One codepoint per cell.
+    private(set) var codepoints: [UInt32]
+
+    /// Style runs covering `codepoints` exactly, in order.
+    private(set) var spans: [StyleSpan]
+
+    /// Per-cell widths, or nil when every cell is width 1 (the usual case).
+    private(set) var widths: [UInt8]?
+
+    init() {
+        codepoints = []
+        spans = []
+        widths = nil
+    }
+
+    init<Cells: Collection>(cells: Cells) where Cells.Element == TerminalCell {
+        self.init()
+        assign(cells)
+    }
+
+    /// Refill the row with `cells`, reusing the storage it already has.
+    /// Rows recycled this way (see ScrollbackBuffer) make no allocations
+    /// once their arrays have grown to the grid width.
+    mutating func assign<Cells: Collection>(_ cells: Cells) where Cells.Element == TerminalCell {
+        codepoints.removeAll(keepingCapacity: true)
+        spans.removeAll(keepingCapacity: true)
+        widths = nil
+        codepoints.reserveCapacity(cells.count)
+
+        for (col, cell) in cells.enumerated() {
+            codepoints.append(cell.codepoint)
+            if let last = spans.indices.last, spans[last].matches(cell) {
+                spans[last].length += 1
+            } else {
+                spans.append(StyleSpan(length: 1, style: cell))
+            }
+            if cell.width != 1, widths == nil {
+                widths = [UInt8](repeating: 1, count: cells.count)
+            }
+            widths?[col] = cell.width
+        }
+    }
+
+    /// Assemble a row from already-separated parts (page decoding).
+    init(codepoints: [UInt32], spans: [StyleSpan], widths: [UInt8]?) {
+        self.codepoints = codepoints
+        self.spans = spans
+        self.widths = widths
+    }
+
+    var count: Int { codepoints.count }
+
+    var isEmpty: Bool { codepoints.isEmpty }
+
+    /// Approximate heap bytes held by the row's storage.
+    var estimatedByteCount: Int {
+        codepoints.count * MemoryLayout<UInt32>.stride
+            + spans.count * MemoryLayout<StyleSpan>.stride
+            + (widths?.count ?? 0)
+    }
+
+    @inline(__always)
+    func width(at col: Int) -> UInt8 {
+        widths?[col] ?? 1
+    }
+
+    /// Expand to one `TerminalCell` per column.
+    var cells: [TerminalCell] {
+        var cells: [TerminalCell] = []
+        cells.reserveCapacity(codepoints.count)
+        forEachSpan { span, range in
+            for col in range {
+                cells.append(TerminalCell(
+                    codepoint: codepoints[col],
+                    fgPacked: span.fgPackedRGBA,
+                    bgPacked: span.bgPackedRGBA,
+                    ulPacked: span.underlinePackedRGBA,
+                    attributes: span.attributes,
+                    underlineStyle: span.underlineStyle,
+                    width: width(at: col)
+                ))
+            }
+        }
+        return cells
+    }
+
+    /// Visit each span with the columns it covers.
+    @inline(__always)
+    func forEachSpan(_ body: (StyleSpan, Range<Int>) -> Void) {
+        var start = 0
+        for span in spans {
+            body(span, start..<(start + span.length))
+            start += span.length
+        }
+    }
+
+    /// Index just past the last non-blank cell (0 if the row is all blank).
+    var contentEnd: Int {
+        var end = codepoints.count
+        for span in spans.reversed() {
+            let start = end - span.length
+            guard span.isBlankStyle else { break }
+            var col = end
+            while col > start {
+                let codepoint = codepoints[col - 1]
+                guard codepoint == 0 || codepoint == 0x20, width(at: col - 1) == 1 else { return col }
+                col -= 1
+            }
+            end = start
+        }
+        return end
+    }
+
+    /// Drop every cell from `newCount` onwards.
+    mutating func truncate(to newCount: Int) {
+        guard newCount < codepoints.count else { return }
+        codepoints.removeSubrange(newCount...)
+        widths?.removeSubrange(newCount...)
+        if widths?.contains(where: { $0 != 1 }) == false {
+            widths = nil
+        }
+
+        var remaining = newCount
+        var keep = 0
+        while keep < spans.count, remaining > 0 {
+            if spans[keep].length >= remaining {
+                spans[keep].length = remaining
+                remaining = 0
+            } else {
+                remaining -= spans[keep].length
+            }
+            keep += 1
+        }
+        spans.removeSubrange(keep...)
+    }
+}
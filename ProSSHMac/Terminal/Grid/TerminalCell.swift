@@ -302,34 +302,99 @@ nonisolated struct TerminalCell: Sendable {
 /// Storage for multi-codepoint grapheme clusters (emoji combining sequences, etc.).
 /// 99%+ of terminal cells are single-codepoint (ASCII, BMP). For the rare
 /// multi-codepoint grapheme clusters, cells store `0x80000000 | sideTableIndex`
-/// and the full string lives here. Uses a free-list to recycle slots.
+/// and the full string lives here.
+///
+/// Clusters are interned by their scalars: every cell showing the same
+/// cluster shares one reference-counted slot, and `intern` finds an existing
+/// slot from a scalar buffer without building a String. Each cell holding
+/// a side-table codepoint owns one reference; freed slots are recycled
+/// through a free-list.
 nonisolated struct GraphemeSideTable: Sendable {
 
     /// Bit 31 sentinel marking a codepoint as a side-table reference.
     static let sentinel: UInt32 = 0x80000000
 
-    /// String storage. nil entries are free slots.
-    private var storage: [String?] = []
+    private struct Entry: Sendable {
+        var string: String
+        var scalars: [UInt32]
+        var hash: UInt64
+        var references: Int
+    }
+
+    /// Entry storage. nil entries are free slots.
+    private var storage: [Entry?] = []
 
     /// Free slot indices for reuse.
     private var freeIndices: [Int] = []
 
+    /// Slot holding each interned cluster, by scalar hash. A hash collision
+    /// leaves the second cluster in a slot of its own, outside the index.
+    private var slotsByHash: [UInt64: Int] = [:]
+
     /// Number of active (non-free) entries.
     private(set) var activeCount: Int = 0
 
     /// Whether there are any active entries.
     var isEmpty: Bool { activeCount == 0 }
 
-    /// Allocate a slot for the given grapheme cluster string.
+    /// Approximate bytes held by the table: slots, free list, hash index and
+    /// the UTF-8 and scalars of every active cluster.
+    var estimatedByteCount: Int {
+        var bytes = storage.capacity * MemoryLayout<Entry?>.stride
+            + freeIndices.capacity * MemoryLayout<Int>.stride
+            + slotsByHash.capacity * (MemoryLayout<UInt64>.stride + MemoryLayout<Int>.stride)
+        for case let entry? in storage {
+            bytes += entry.string.utf8.count + entry.scalars.capacity * MemoryLayout<UInt32>.stride
+        }
+        return bytes
+    }
+
+    /// Allocate a slot for the given grapheme cluster string, or take a
+    /// reference to the slot already holding it.
     /// Returns a codepoint with the sentinel bit set.
     mutating func allocate(_ string: String) -> UInt32 {
+        let scalars = string.unicodeScalars.map(\.value)
+        return scalars.withUnsafeBufferPointer { buffer in
+            intern(buffer, string: string)
+        }
+    }
+
+    /// Take a reference to the slot holding the cluster `scalars`, creating
+    /// it if none does. Only a cluster new to the table builds a String.
+    /// Returns a codepoint with the sentinel bit set.
+    mutating func intern(_ scalars: UnsafeBufferPointer<UInt32>) -> UInt32 {
+        intern(scalars, string: nil)
+    }
+
+    private mutating func intern(_ scalars: UnsafeBufferPointer<UInt32>, string: String?) -> UInt32 {
+        let hash = Self.hash(scalars)
+        if let index = slotsByHash[hash], storage[index]?.scalars.elementsEqual(scalars) == true {
+            storage[index]!.references += 1
+            return Self.sentinel | UInt32(index)
+        }
+
+        var view = String.UnicodeScalarView()
+        if string == nil {
+            for value in scalars {
+                view.append(Unicode.Scalar(value) ?? "\u{FFFD}")
+            }
+        }
+        let entry = Entry(
+            string: string ?? String(view),
+            scalars: Array(scalars),
+            hash: hash,
+            references: 1
+        )
         let index: Int
         if let recycled = freeIndices.popLast() {
             index = recycled
-            storage[index] = string
+            storage[index] = entry
         } else {
             index = storage.count
-            storage.append(string)
+            storage.append(entry)
+        }
+        if slotsByHash[hash] == nil {
+            slotsByHash[hash] = index
         }
         activeCount += 1
         return Self.sentinel | UInt32(index)
@@ -338,19 +403,29 @@ nonisolated struct GraphemeSideTable: Sendable {
     /// Resolve a side-table codepoint to its grapheme cluster string.
     /// Returns nil if the codepoint is not a side-table reference or the slot is empty.
     func resolve(_ codepoint: UInt32) -> String? {
-        guard codepoint & Self.sentinel != 0 else { return nil }
-        let index = Int(codepoint & ~Self.sentinel)
-        guard index >= 0 && index < storage.count else { return nil }
-        return storage[index]
+        guard let index = slotIndex(codepoint) else { return nil }
+        return storage[index]?.string
+    }
+
+    /// The scalar values of a side-table codepoint's cluster, without
+    /// building a String. Returns nil like `resolve`.
+    func scalars(of codepoint: UInt32) -> [UInt32]? {
+        guard let index = slotIndex(codepoint) else { return nil }
+        return storage[index]?.scalars
     }
 
-    /// Release a side-table slot back to the free list.
+    /// Drop one reference to a side-table slot, returning the slot to the
+    /// free list when no cell holds it any more.
     mutating func release(_ codepoint: UInt32) {
-        guard codepoint & Self.sentinel != 0 else { return }
-        let index = Int(codepoint & ~Self.sentinel)
-        guard index >= 0 && index < storage.count else { return }
-        guard storage[index] != nil else { return }
+        guard let index = slotIndex(codepoint), let entry = storage[index] else { return }
+        guard entry.references <= 1 else {
+            storage[index]!.references -= 1
+            return
+        }
         storage[index] = nil
+        if slotsByHash[entry.hash] == index {
+            slotsByHash[entry.hash] = nil
+        }
         freeIndices.append(index)
         activeCount -= 1
     }
@@ -365,6 +440,24 @@ nonisolated struct GraphemeSideTable: Sendable {
     mutating func clear() {
         storage.removeAll(keepingCapacity: true)
         freeIndices.removeAll(keepingCapacity: true)
+        slotsByHash.removeAll(keepingCapacity: true)
         activeCount = 0
     }
+
+    private func slotIndex(_ codepoint: UInt32) -> Int? {
+        guard codepoint & Self.sentinel != 0 else { return nil }
+        let index = Int(codepoint & ~Self.sentinel)
+        guard index < storage.count else { return nil }
+        return index
+    }
+
+    /// FNV-1a over the scalar values.
+    @inline(__always)
+    private static func hash(_ scalars: UnsafeBufferPointer<UInt32>) -> UInt64 {
+        var hash: UInt64 = 0xCBF2_9CE4_8422_2325
+        for value in scalars {
+            hash = (hash ^ UInt64(value)) &* 0x0000_0100_0000_01B3
+        }
+        return hash
+    }
 }
@@ -0,0 +1,169 @@
+// TerminalGrid+CommandFolding.swift
+// ProSSHV2
+//
+// Folds finished command output out of scrollback into
+// CommandOutputFoldStore and back. The part of an OSC 133 output zone
+// that has scrolled into history is replaced by one summary row; lines
+// still on the screen stay where they are. Only the primary screen's
+// history is folded, and only past any history still waiting for a
+// deferred reflow, so the zone index can be renumbered in place.
+//
+// Expanding never evicts history: when scrollback cannot take every
+// folded line, the newest ones that fit come back and the rest stay folded
+// under a new summary row.
+
+import Foundation
+
+extension TerminalGrid {
+
+    /// Fold the output of a finished command when at least `minimumLines`
+    /// of it are in scrollback. With `newestOnly`, only the command that
+    /// just ended qualifies (for folding on completion); otherwise the
+    /// newest finished output does. Returns the new fold's ID.
+    @discardableResult
+    nonisolated func foldCommandOutput(
+        summary: CommandOutputFold.Summary,
+        minimumLines: Int,
+        newestOnly: Bool
+    ) -> Int? {
+        guard !usingAlternateBuffer, semanticZones.epoch == scrollback.rewriteEpoch else { return nil }
+        semanticZones.dropLines(before: scrollback.firstLineID)
+        guard let output = newestOnly ? semanticZones.justCompletedOutput : semanticZones.lastCompletedOutput
+        else { return nil }
+
+        let firstLineID = scrollback.firstLineID
+        let screenStart = firstLineID + scrollback.count
+        let start = output.lowerBound
+        let end = min(output.upperBound, screenStart)
+        guard start - firstLineID >= scrollback.deferredReflowLineCount,
+              end - start >= max(minimumLines, 1),
+              let first = scrollback.line(at: start - firstLineID),
+              CommandOutputFoldStore.foldID(summarizedBy: first) == nil else { return nil }
+
+        let epoch = scrollback.rewriteEpoch
+        let tail = scrollback.removeLast(screenStart - end)
+        let folded = scrollback.removeLast(end - start)
+        let fold = commandOutputFolds.insert(folded, columns: columns, summary: summary)
+        scrollback.push(ScrollbackLine(cells: CommandOutputFoldStore.summaryCells(for: fold, columns: columns)))
+        for line in tail {
+            scrollback.push(line)
+        }
+        renumberFoldedLines(start..<end, withCount: 1, previousEpoch: epoch)
+        return fold.id
+    }
+
+    /// Put fold `id` back in place of its summary row. Returns false when
+    /// the row or the fold is gone, or no line fits.
+    @discardableResult
+    nonisolated func expandCommandOutput(_ id: Int) -> Bool {
+        guard !usingAlternateBuffer, let fold = commandOutputFolds.folds[id],
+              var index = summaryRowIndex(of: id) else { return false }
+        if index < scrollback.deferredReflowLineCount {
+            settleDeferredReflow()
+            guard let settled = summaryRowIndex(of: id) else { return false }
+            index = settled
+        }
+        // A summary row wider than the screen was rewrapped onto several.
+        var rowCount = 1
+        while index + rowCount < scrollback.count, scrollback.line(at: index + rowCount - 1)?.isWrapped == true {
+            rowCount += 1
+        }
+
+        var foldedLines = fold.lines
+        var lines = GridReflow.rewrapScrollback(foldedLines.allLines(), oldColumns: fold.columns, newColumns: columns)
+        let room = scrollback.maxLines - (scrollback.count - rowCount)
+        var remainder: [ScrollbackLine] = []
+        if lines.count > room {
+            guard room > 1 else { return false }
+            remainder = Array(lines[..<(lines.count - room + 1)])
+            lines.removeFirst(remainder.count)
+        }
+
+        let lineID = scrollback.firstLineID + index
+        let epoch = scrollback.rewriteEpoch
+        _ = commandOutputFolds.remove(id)
+        let tail = scrollback.removeLast(scrollback.count - index).dropFirst(rowCount)
+        var insertedCount = lines.count
+        if !remainder.isEmpty {
+            let rest = commandOutputFolds.insert(remainder, columns: columns, summary: fold.summary)
+            scrollback.push(ScrollbackLine(cells: CommandOutputFoldStore.summaryCells(for: rest, columns: columns)))
+            insertedCount += 1
+        }
+        for line in lines {
+            scrollback.push(line)
+        }
+        for line in tail {
+            scrollback.push(line)
+        }
+        renumberFoldedLines(lineID..<(lineID + rowCount), withCount: insertedCount, previousEpoch: epoch)
+        return true
+    }
+
+    /// Expand every fold whose summary row is still in scrollback, newest
+    /// first. Returns how many were expanded.
+    @discardableResult
+    nonisolated func expandAllCommandOutput() -> Int {
+        var expanded = 0
+        for id in commandOutputFolds.folds.keys.sorted(by: >) {
+            if expandCommandOutput(id) {
+                expanded += 1
+            }
+        }
+        return expanded
+    }
+
+    /// The fold summarized at the newest finished output, if it is one.
+    nonisolated var lastCommandOutputFoldID: Int? {
+        guard !usingAlternateBuffer, semanticZones.epoch == scrollback.rewriteEpoch,
+              let output = semanticZones.lastCompletedOutput,
+              let line = scrollback.line(at: output.lowerBound - scrollback.firstLineID) else { return nil }
+        return commandOutputFolds.fold(summarizedBy: line)?.id
+    }
+
+    /// Folds whose summary row is still in scrollback, oldest first. Each
+    /// shares its pages with the store, so copies are cheap to search.
+    nonisolated func visibleCommandOutputFolds() -> [CommandOutputFold] {
+        guard !commandOutputFolds.isEmpty else { return [] }
+        var folds: [CommandOutputFold] = []
+        scrollback.forEachLine(from: 0) { _, line in
+            if let fold = commandOutputFolds.fold(summarizedBy: line) {
+                folds.append(fold)
+            }
+            return true
+        }
+        return folds
+    }
+
+    // MARK: - Private
+
+    /// Index in scrollback of fold `id`'s summary row.
+    private nonisolated func summaryRowIndex(of id: Int) -> Int? {
+        var found: Int?
+        scrollback.forEachLine(from: 0) { index, line in
+            guard CommandOutputFoldStore.foldID(summarizedBy: line) == id else { return true }
+            found = index
+            return false
+        }
+        return found
+    }
+
+    /// Carry OSC 133 marks over to the numbering after `range` was
+    /// replaced by `count` lines, and drop rows encoded for the old one.
+    private nonisolated func renumberFoldedLines(_ range: Range<Int>, withCount count: Int, previousEpoch: Int) {
+        let epoch = scrollback.rewriteEpoch
+        if semanticZones.epoch == previousEpoch {
+            semanticZones.replaceLines(range, withCount: count, epoch: epoch)
+            semanticZones.dropLines(before: scrollback.firstLineID)
+        }
+        if let start = semanticOutputStart, start.epoch == previousEpoch {
+            let line: Int
+            if start.line < range.lowerBound {
+                line = start.line
+            } else {
+                line = start.line >= range.upperBound ? start.line + count - range.count : range.lowerBound
+            }
+            semanticOutputStart = (line, epoch)
+        }
+        scrollbackRowCache.removeAll()
+    }
+}
@@ -10,7 +10,7 @@ extension TerminalGrid {
     nonisolated func cellAt(row: Int, col: Int) -> TerminalCell? {
         guard row >= 0 && row < rows && col >= 0 && col < columns else { return nil }
         let base = activeRowBase
-        return cells[physicalRow(row, base: base)][col]
+        return cells[physicalRow(row, base: base), col]
     }
 
     /// Write a cell at the given position and mark it dirty.
@@ -18,8 +18,8 @@ extension TerminalGrid {
         guard row >= 0 && row < rows && col >= 0 && col < columns else { return }
         withActiveBuffer { buffer, base in
             let physical = physicalRow(row, base: base)
-            releaseCellGrapheme(buffer[physical][col].codepoint)
-            buffer[physical][col] = cell
+            releaseCellGrapheme(buffer[physical, col].codepoint)
+            buffer[physical, col] = cell
         }
         markDirty(row: row)
     }
@@ -19,18 +19,18 @@ extension TerminalGrid {
             switch mode {
             case 0: // Cursor to end
                 for col in cursor.col..<columns {
-                    releaseCellGrapheme(buf[row][col].codepoint)
-                    buf[row][col] = erasedCell
+                    releaseCellGrapheme(buf[row, col].codepoint)
+                    buf[row, col] = erasedCell
                 }
             case 1: // Beginning to cursor
                 for col in 0...cursor.col {
-                    releaseCellGrapheme(buf[row][col].codepoint)
-                    buf[row][col] = erasedCell
+                    releaseCellGrapheme(buf[row, col].codepoint)
+                    buf[row, col] = erasedCell
                 }
             case 2: // Entire line
                 for col in 0..<columns {
-                    releaseCellGrapheme(buf[row][col].codepoint)
-                    buf[row][col] = erasedCell
+                    releaseCellGrapheme(buf[row, col].codepoint)
+                    buf[row, col] = erasedCell
                 }
             default:
                 break
@@ -49,22 +49,34 @@ extension TerminalGrid {
     nonisolated func eraseInDisplay(mode: Int) {
         let erasedCell = TerminalCell.erased(bgColor: currentBgColor, bgPacked: currentBgPacked)
 
+        // Images go with the rows they cover.
+        switch mode {
+        case 0:
+            removeInlineImages(overlappingRows: (cursor.col == 0 ? cursor.row : cursor.row + 1)..<rows)
+        case 1:
+            removeInlineImages(overlappingRows: 0..<cursor.row)
+        case 2, 3:
+            removeInlineImages(overlappingRows: 0..<rows)
+        default:
+            break
+        }
+
         withActiveBuffer { buf, base in
             switch mode {
             case 0: // Cursor to end
                 // Rest of current line
                 let cursorPhysical = physicalRow(cursor.row, base: base)
                 for col in cursor.col..<columns {
-                    releaseCellGrapheme(buf[cursorPhysical][col].codepoint)
-                    buf[cursorPhysical][col] = erasedCell
+                    releaseCellGrapheme(buf[cursorPhysical, col].codepoint)
+                    buf[cursorPhysical, col] = erasedCell
                 }
                 markDirty(row: cursor.row)
                 // All lines below
                 for row in (cursor.row + 1)..<rows {
                     let physical = physicalRow(row, base: base)
                     for col in 0..<columns {
-                        releaseCellGrapheme(buf[physical][col].codepoint)
-                        buf[physical][col] = erasedCell
+                        releaseCellGrapheme(buf[physical, col].codepoint)
+                        buf[physical, col] = erasedCell
                     }
                     markDirty(row: row)
                 }
@@ -74,16 +86,16 @@ extension TerminalGrid {
                 for row in 0..<cursor.row {
                     let physical = physicalRow(row, base: base)
                     for col in 0..<columns {
-                        releaseCellGrapheme(buf[physical][col].codepoint)
-                        buf[physical][col] = erasedCell
+                        releaseCellGrapheme(buf[physical, col].codepoint)
+                        buf[physical, col] = erasedCell
                     }
                     markDirty(row: row)
                 }
                 // Start of current line to cursor
                 let cursorPhysical = physicalRow(cursor.row, base: base)
                 for col in 0...cursor.col {
-                    releaseCellGrapheme(buf[cursorPhysical][col].codepoint)
-                    buf[cursorPhysical][col] = erasedCell
+                    releaseCellGrapheme(buf[cursorPhysical, col].codepoint)
+                    buf[cursorPhysical, col] = erasedCell
                 }
                 markDirty(row: cursor.row)
 
@@ -91,8 +103,8 @@ extension TerminalGrid {
                 for row in 0..<rows {
                     let physical = physicalRow(row, base: base)
                     for col in 0..<columns {
-                        releaseCellGrapheme(buf[physical][col].codepoint)
-                        buf[physical][col] = erasedCell
+                        releaseCellGrapheme(buf[physical, col].codepoint)
+                        buf[physical, col] = erasedCell
                     }
                     markDirty(row: row)
                 }
@@ -101,12 +113,13 @@ extension TerminalGrid {
                 for row in 0..<rows {
                     let physical = physicalRow(row, base: base)
                     for col in 0..<columns {
-                        releaseCellGrapheme(buf[physical][col].codepoint)
-                        buf[physical][col] = erasedCell
+                        releaseCellGrapheme(buf[physical, col].codepoint)
+                        buf[physical, col] = erasedCell
                     }
                     markDirty(row: row)
                 }
                 scrollback.clear()
+                commandOutputFolds.removeAll()
 
             default:
                 break
@@ -123,8 +136,8 @@ extension TerminalGrid {
         withActiveBuffer { buf, base in
             let row = physicalRow(logicalRow, base: base)
             for col in cursor.col..<min(cursor.col + count, columns) {
-                releaseCellGrapheme(buf[row][col].codepoint)
-                buf[row][col] = erasedCell
+                releaseCellGrapheme(buf[row, col].codepoint)
+                buf[row, col] = erasedCell
             }
         }
         markDirty(row: logicalRow)
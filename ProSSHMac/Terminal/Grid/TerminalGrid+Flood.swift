@@ -0,0 +1,186 @@
+// TerminalGrid+Flood.swift
+// ProSSHV2
+//
+// Output-flood fast path. When TerminalEngine sees a chunk above
+// `floodWatermark` (output arriving far faster than anyone can read it),
+// it sets `floodMode` and ground-state text runs that scroll the whole
+// screen more than once are laid out line by line off-grid. Lines that
+// scroll off go straight into the scrollback buffer, already trimmed.
+// Only the rows left on screen at the end of the run are written back into
+// the active buffer. The result is identical to printing through
+// `printASCIIBytesBulk`/`lineFeed`, minus the per-line ring rotation,
+// blank-row allocation and dirty tracking for rows nobody will see.
+
+import Foundation
+
+extension TerminalGrid {
+
+    /// Chunk size at which TerminalEngine switches the grid into flood mode.
+    nonisolated static let floodWatermark = 64 * 1024
+
+    /// Where `processGroundTextBytes` may switch to the flood path within
+    /// `range`, or nil to print it all normally. Requires the primary screen,
+    /// a full-screen scroll region and a plain ASCII charset without insert
+    /// or LNM. The returned index is just past the line feed that brings the
+    /// cursor to the bottom row, and at least a screenful of line feeds
+    /// follows it.
+    nonisolated func floodTextStart(_ bytes: Data, range: Range<Int>) -> Int? {
+        guard floodMode,
+              !usingAlternateBuffer,
+              !insertMode,
+              !lineFeedMode,
+              scrollTop == 0,
+              scrollBottom == rows - 1 else { return nil }
+        let charset: Charset = (activeCharset == 1) ? g1Charset : g0Charset
+        guard charset == .ascii else { return nil }
+
+        var lineFeedsToBottom = rows - 1 - cursor.row
+        var start: Int? = lineFeedsToBottom == 0 ? range.lowerBound : nil
+        var lineFeeds = 0
+        for idx in range where bytes[idx] == 0x0A {
+            if start == nil {
+                lineFeedsToBottom -= 1
+                if lineFeedsToBottom == 0 { start = idx + 1 }
+                continue
+            }
+            lineFeeds += 1
+            if lineFeeds >= rows { return start }
+        }
+        return nil
+    }
+
+    /// Lay out a ground-text run (printable ASCII, CR, LF) without touching
+    /// the active buffer until the end. The cursor must be on the bottom row;
+    /// see `floodTextStart`.
+    nonisolated func processFloodText(_ bytes: Data, range: Range<Int>) {
+        let attrs = currentAttributes
+        let fgPacked: UInt32
+        if TerminalDefaults.boldIsBright && attrs.contains(.bold) {
+            fgPacked = currentFgBoldPacked
+        } else {
+            fgPacked = currentFgPacked
+        }
+        let bgPacked = currentBgPacked
+        let ulPacked = currentUnderlinePacked
+        let ulStyle = currentUnderlineStyle
+        let blank = TerminalCell.erased(bgColor: currentBgColor, bgPacked: bgPacked)
+        // Rows headed for scrollback can skip their blank tail only when the
+        // lazy trim would drop it anyway.
+        let trimsBlankTail = blank.isBlank
+        let lastCol = columns - 1
+
+        // Rows above the cursor, oldest first; `windowHead` marks the first
+        // row still on screen. Rows pushed out go straight to scrollback.
+        var window: [[TerminalCell]] = []
+        var windowHead = 0
+        var current: [TerminalCell] = []
+        withActiveBufferState { buf, base, rowMap in
+            window.reserveCapacity(rows * 2)
+            for row in 0..<(rows - 1) {
+                window.append(Array(buf[physicalRow(row, base: base, map: rowMap)]))
+            }
+            current = Array(buf[physicalRow(rows - 1, base: base, map: rowMap)])
+        }
+
+        var col = cursor.col
+        var pendingWrap = cursor.pendingWrap
+        var lastByte: UInt8?
+
+        func pushToScrollback(_ row: [TerminalCell]) {
+            var row = row
+            if !trimsBlankTail, row.count < columns {
+                row.append(contentsOf: repeatElement(blank, count: columns - row.count))
+            }
+            let graphemeOverrides = resolveSideTableEntries(in: &row)
+            let isWrapped = row.count == columns && row[lastCol].attributes.contains(.wrapped)
+            scrollback.push(cells: row, isWrapped: isWrapped, graphemeOverrides: graphemeOverrides)
+        }
+
+        // LF on the bottom row: the cursor row moves into the window, the
+        // window's oldest row scrolls off, and a blank row takes its place.
+        func scrollCurrentRow() {
+            window.append(current)
+            if window.count - windowHead > rows - 1 {
+                pushToScrollback(window[windowHead])
+                windowHead += 1
+                if windowHead >= rows * 2 {
+                    window.removeFirst(windowHead)
+                    windowHead = 0
+                }
+            }
+            current = []
+            current.reserveCapacity(columns)
+        }
+
+        for idx in range {
+            let byte = bytes[idx]
+            switch byte {
+            case 0x0A:
+                scrollCurrentRow()
+            case 0x0D:
+                col = 0
+                pendingWrap = false
+            case 0x20...0x7E:
+                if pendingWrap {
+                    if current.count < columns {
+                        current.append(contentsOf: repeatElement(blank, count: columns - current.count))
+                    }
+                    current[lastCol].attributes.insert(.wrapped)
+                    current[lastCol].isDirty = true
+                    scrollCurrentRow()
+                    col = 0
+                    pendingWrap = false
+                }
+
+                let cell = TerminalCell(
+                    codepoint: UInt32(byte),
+                    fgPacked: fgPacked,
+                    bgPacked: bgPacked,
+                    ulPacked: ulPacked,
+                    attributes: attrs,
+                    underlineStyle: ulStyle,
+                    width: 1
+                )
+                if col < current.count {
+                    current[col] = cell
+                } else {
+                    current.append(contentsOf: repeatElement(blank, count: col - current.count))
+                    current.append(cell)
+                }
+                lastByte = byte
+
+                if col >= lastCol {
+                    if autoWrapMode {
+                        pendingWrap = true
+                    }
+                } else {
+                    col += 1
+                }
+            default:
+                break
+            }
+        }
+
+        // Materialize the final screen.
+        withActiveBufferState { buf, base, rowMap in
+            for row in 0..<(rows - 1) {
+                var cells = window[windowHead + row]
+                if cells.count < columns {
+                    cells.append(contentsOf: repeatElement(blank, count: columns - cells.count))
+                }
+                buf.replaceRow(physicalRow(row, base: base, map: rowMap), with: cells)
+            }
+            if current.count < columns {
+                current.append(contentsOf: repeatElement(blank, count: columns - current.count))
+            }
+            buf.replaceRow(physicalRow(rows - 1, base: base, map: rowMap), with: current)
+        }
+
+        cursor.col = col
+        cursor.pendingWrap = pendingWrap
+        if let lastByte {
+            lastPrintedChar = Self.asciiCharacterCache[Int(lastByte)]
+        }
+        markAllDirty()
+    }
+}
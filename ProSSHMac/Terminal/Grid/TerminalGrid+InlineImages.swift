@@ -0,0 +1,290 @@
+// TerminalGrid+InlineImages.swift
+// ProSSHV2
+//
+// Inline image placements (see InlineImage.swift). On the primary screen a
+// placement's line is a scrollback line ID continued down the screen, like
+// semantic zones. The line ID stays fixed as the text scrolls, so an image
+// moves into scrollback with the lines around it. A placement is dropped when
+// its last line is evicted, or when a rewrite or reflow renumbers the lines
+// (the scrollback `rewriteEpoch` changes). Alternate-screen placements use
+// screen rows. They are cleared with the screen when the app exits.
+//
+// The grid blanks the cells an image covers, so the text under it is gone
+// as it would be in other terminals. When nothing references a decoded image
+// any more, the grid releases it from InlineImageStore.
+
+import Foundation
+
+// MARK: - InlineImageState
+
+nonisolated struct InlineImageState: Sendable {
+
+    /// Placements per screen above which the oldest are dropped.
+    static let maxPlacements = 1024
+
+    /// A kitty image transmitted with an ID and kept until deleted.
+    struct KittyImage: Sendable {
+        let imageID: InlineImageID
+        let pixelWidth: Int
+        let pixelHeight: Int
+    }
+
+    /// A kitty transmission still arriving in m=1 chunks. The first
+    /// chunk's keys apply to the whole image.
+    struct KittyTransmission: Sendable {
+        var keys: [UInt8: String]
+        var payload: [UInt8]
+    }
+
+    var primary: [InlineImagePlacement] = []
+    /// `scrollback.rewriteEpoch` the primary lines belong to.
+    var epoch = 0
+    var alternate: [InlineImagePlacement] = []
+    var kittyImages: [UInt32: KittyImage] = [:]
+    var kittyTransmission: KittyTransmission?
+    var cellSize = InlineImageCellSize.fallback
+
+    /// Images a placement or kitty ID still refers to.
+    var referencedImageIDs: Set<InlineImageID> {
+        var ids = Set(primary.map(\.imageID))
+        ids.formUnion(alternate.map(\.imageID))
+        ids.formUnion(kittyImages.values.map(\.imageID))
+        return ids
+    }
+}
+
+// MARK: - Placement
+
+/// Where the cursor goes once an image is placed.
+nonisolated enum InlineImageCursorMovement: Sendable {
+    /// After the image's last cell on its last row (iTerm2, kitty).
+    case afterImage
+    /// The start column of the line below the image (sixel).
+    case belowImage
+    /// Unchanged (kitty C=1).
+    case none
+}
+
+extension TerminalGrid {
+
+    nonisolated func setInlineImageCellSize(_ size: InlineImageCellSize) {
+        guard size.width > 0, size.height > 0 else { return }
+        inlineImages.cellSize = size
+    }
+
+    /// Anchor `imageID` at the cursor, covering `columns` × `rows` cells.
+    /// Lines are added below as needed, scrolling the screen like the
+    /// same number of line feeds would.
+    nonisolated func placeInlineImage(
+        _ imageID: InlineImageID,
+        columns requestedColumns: Int,
+        rows requestedRows: Int,
+        widthFraction: Float = 1,
+        heightFraction: Float = 1,
+        cursorMovement: InlineImageCursorMovement,
+        kittyPlacementID: UInt32 = 0
+    ) {
+        let startColumn = cursor.col
+        let columnCount = max(1, min(requestedColumns, columns - startColumn))
+        let rowCount = max(1, requestedRows)
+        let topLine = inlineImageLine(forRow: cursor.row)
+
+        if cursorMovement == .none {
+            let startRow = cursor.row
+            for row in startRow..<min(startRow + rowCount, rows) {
+                cursor.row = row
+                blankInlineImageCells(from: startColumn, count: columnCount)
+            }
+            cursor.row = startRow
+            setCursorColumn(startColumn)
+        } else {
+            for row in 0..<rowCount {
+                if row > 0 { index() }
+                blankInlineImageCells(from: startColumn, count: columnCount)
+            }
+            switch cursorMovement {
+            case .afterImage:
+                setCursorColumn(startColumn + columnCount)
+            case .belowImage:
+                index()
+                setCursorColumn(startColumn)
+            case .none:
+                break
+            }
+        }
+
+        let placement = InlineImagePlacement(
+            imageID: imageID,
+            line: topLine,
+            column: startColumn,
+            columns: columnCount,
+            rows: rowCount,
+            widthFraction: min(max(widthFraction, 0.01), 1),
+            heightFraction: min(max(heightFraction, 0.01), 1),
+            kittyPlacementID: kittyPlacementID
+        )
+        pruneInlineImages()
+        var released: [InlineImagePlacement] = []
+        if usingAlternateBuffer {
+            if kittyPlacementID != 0 {
+                released += inlineImages.alternate.removeAll(matchingImage: imageID, placement: kittyPlacementID)
+            }
+            inlineImages.alternate.append(placement)
+            released += inlineImages.alternate.dropOldest(over: InlineImageState.maxPlacements)
+        } else {
+            if kittyPlacementID != 0 {
+                released += inlineImages.primary.removeAll(matchingImage: imageID, placement: kittyPlacementID)
+            }
+            inlineImages.primary.append(placement)
+            released += inlineImages.primary.dropOldest(over: InlineImageState.maxPlacements)
+        }
+        releaseUnreferencedImages(released.map(\.imageID))
+    }
+
+    /// Line number of screen row `row` for the active screen's placements.
+    nonisolated func inlineImageLine(forRow row: Int) -> Int {
+        usingAlternateBuffer ? row : scrollback.firstLineID + scrollback.count + row
+    }
+
+    private nonisolated func blankInlineImageCells(from column: Int, count: Int) {
+        let savedColumn = cursor.col
+        setCursorColumn(column)
+        eraseCharacters(count)
+        setCursorColumn(savedColumn)
+    }
+
+    // MARK: - Removal
+
+    /// Drop placements whose lines have left scrollback or were renumbered.
+    nonisolated func pruneInlineImages() {
+        guard !inlineImages.primary.isEmpty else {
+            inlineImages.epoch = scrollback.rewriteEpoch
+            return
+        }
+        var released: [InlineImagePlacement] = []
+        if inlineImages.epoch != scrollback.rewriteEpoch {
+            released = inlineImages.primary
+            inlineImages.primary.removeAll()
+            inlineImages.epoch = scrollback.rewriteEpoch
+        } else {
+            let firstLine = scrollback.firstLineID
+            released = inlineImages.primary.filter { $0.line + $0.rows <= firstLine }
+            if !released.isEmpty {
+                inlineImages.primary.removeAll { $0.line + $0.rows <= firstLine }
+            }
+        }
+        releaseUnreferencedImages(released.map(\.imageID))
+    }
+
+    /// Drop the active screen's placements that overlap screen rows `rows`
+    /// (ED, kitty delete).
+    nonisolated func removeInlineImages(overlappingRows screenRows: Range<Int>) {
+        let lines = inlineImageLine(forRow: screenRows.lowerBound)..<inlineImageLine(forRow: screenRows.upperBound)
+        removeInlineImages { $0.overlaps(lines: lines) }
+    }
+
+    /// Drop the active screen's placements matching `predicate`.
+    nonisolated func removeInlineImages(where predicate: (InlineImagePlacement) -> Bool) {
+        var released: [InlineImagePlacement] = []
+        if usingAlternateBuffer {
+            released = inlineImages.alternate.filter(predicate)
+            inlineImages.alternate.removeAll(where: predicate)
+        } else {
+            released = inlineImages.primary.filter(predicate)
+            inlineImages.primary.removeAll(where: predicate)
+        }
+        guard !released.isEmpty else { return }
+        markAllDirty()
+        releaseUnreferencedImages(released.map(\.imageID))
+    }
+
+    /// Drop every placement on both screens; kitty images stay transmitted.
+    /// Used when the lines they anchor to are renumbered (resize) or reset.
+    nonisolated func removeAllInlineImagePlacements() {
+        let released = inlineImages.primary + inlineImages.alternate
+        inlineImages.primary.removeAll()
+        inlineImages.alternate.removeAll()
+        releaseUnreferencedImages(released.map(\.imageID))
+    }
+
+    /// RIS: forget placements and kitty images alike.
+    nonisolated func resetInlineImages() {
+        let released = inlineImages.referencedImageIDs
+        inlineImages = InlineImageState(cellSize: inlineImages.cellSize)
+        releaseUnreferencedImages(Array(released))
+    }
+
+    /// Leaving the alternate screen takes its images with it.
+    nonisolated func removeAlternateInlineImages() {
+        let released = inlineImages.alternate
+        inlineImages.alternate.removeAll()
+        releaseUnreferencedImages(released.map(\.imageID))
+    }
+
+    /// Release images from the store once nothing here refers to them.
+    nonisolated func releaseUnreferencedImages(_ candidates: [InlineImageID]) {
+        guard !candidates.isEmpty else { return }
+        let referenced = inlineImages.referencedImageIDs
+        for id in Set(candidates) where !referenced.contains(id) {
+            InlineImageStore.shared.remove(id)
+        }
+    }
+
+    // MARK: - Snapshot
+
+    /// Placements overlapping the viewport whose top line is
+    /// `firstVisibleLine`, relative to that line.
+    nonisolated func visibleInlineImageQuads(firstVisibleLine: Int) -> [InlineImageQuad] {
+        let placements: [InlineImagePlacement]
+        let top: Int
+        if usingAlternateBuffer {
+            placements = inlineImages.alternate
+            top = 0
+        } else {
+            pruneInlineImages()
+            placements = inlineImages.primary
+            top = firstVisibleLine
+        }
+        guard !placements.isEmpty else { return [] }
+        let lines = top..<(top + rows)
+        return placements.compactMap { placement in
+            guard placement.overlaps(lines: lines) else { return nil }
+            return InlineImageQuad(
+                imageID: placement.imageID,
+                row: placement.line - top,
+                column: placement.column,
+                columns: placement.columns,
+                rows: placement.rows,
+                widthFraction: placement.widthFraction,
+                heightFraction: placement.heightFraction
+            )
+        }
+    }
+
+    /// Quads for the live viewport.
+    nonisolated func liveInlineImageQuads() -> [InlineImageQuad] {
+        visibleInlineImageQuads(firstVisibleLine: scrollback.firstLineID + scrollback.count)
+    }
+}
+
+// MARK: - Placement Lists
+
+private extension Array where Element == InlineImagePlacement {
+
+    /// Remove placements of kitty image `imageID` with placement ID
+    /// `placement`, which a new placement with the same IDs replaces.
+    mutating func removeAll(matchingImage imageID: InlineImageID, placement: UInt32) -> [InlineImagePlacement] {
+        let matching = filter { $0.imageID == imageID && $0.kittyPlacementID == placement }
+        if !matching.isEmpty {
+            removeAll { $0.imageID == imageID && $0.kittyPlacementID == placement }
+        }
+        return matching
+    }
+
+    mutating func dropOldest(over limit: Int) -> [InlineImagePlacement] {
+        guard count > limit else { return [] }
+        let dropped = Array(prefix(count - limit))
+        removeFirst(count - limit)
+        return dropped
+    }
+}
@@ -0,0 +1,216 @@
+// TerminalGrid+Keyframe.swift
+// ProSSHV2
+//
+// The grid's state as a byte sequence. Fed to a terminal of the same size, it
+// rebuilds the screen, the newest scrollback lines, the cursor and the
+// modes. Session recordings store one every so often, so playback can seek
+// by restoring the nearest keyframe and replaying only the output after it.
+//
+// The sequence is written in the terminal's own language: RIS, then each row
+// with SGR runs. Rows that wrapped are padded to full width so autowrap
+// joins them again. Next comes the alternate screen, if it is active, and
+// finally the scroll region, modes, title, pen and cursor. Charsets, tab
+// stops, palette changes and the saved DECSC cursor are not carried over.
+
+import Foundation
+
+extension TerminalGrid {
+
+    /// A byte sequence that restores this grid with at most
+    /// `scrollbackLines` lines of history.
+    nonisolated func keyframeSequence(scrollbackLines: Int) -> [UInt8] {
+        settleDeferredReflow()
+        var out = ""
+        out.reserveCapacity(columns * (rows + min(scrollbackLines, scrollback.count)) + 256)
+        out += "\u{1B}c"
+
+        var style = KeyframeStyle.reset
+        var continuesRow = false
+        func writeRow(_ cells: [TerminalCell], isWrapped: Bool, grapheme: (Int, TerminalCell) -> String) {
+            var end = cells.count
+            if isWrapped {
+                end = min(end, columns)
+            } else {
+                while end > 0, cells[end - 1].isBlank { end -= 1 }
+            }
+            for col in 0..<end {
+                let cell = cells[col]
+                if cell.width == 0 { continue }
+                let cellStyle = KeyframeStyle(cell)
+                if cellStyle != style {
+                    out += cellStyle.sgr
+                    style = cellStyle
+                }
+                let text = grapheme(col, cell)
+                out += text.isEmpty ? " " : text
+            }
+            if isWrapped, end < columns {
+                if style != .reset {
+                    out += KeyframeStyle.reset.sgr
+                    style = .reset
+                }
+                out += String(repeating: " ", count: columns - end)
+            }
+        }
+        func startRow() {
+            if !continuesRow {
+                out += "\r\n"
+            }
+        }
+
+        // Primary history and screen, top to bottom; the screen scrolls
+        // older rows into scrollback as they are written.
+        let tail = min(max(0, scrollbackLines), scrollback.count)
+        var isFirstRow = true
+        scrollback.forEachLine(from: scrollback.count - tail) { _, line in
+            if !isFirstRow { startRow() }
+            isFirstRow = false
+            writeRow(line.cells, isWrapped: line.isWrapped) { col, _ in line.grapheme(at: col) }
+            continuesRow = line.isWrapped
+            return true
+        }
+        for row in 0..<rows {
+            let rowCells = Array(primaryCells[physicalRow(row, base: primaryRowBase, map: primaryRowMap)])
+            let isWrapped = rowCells.last?.attributes.contains(.wrapped) ?? false
+            if !isFirstRow { startRow() }
+            isFirstRow = false
+            writeRow(rowCells, isWrapped: isWrapped && row < rows - 1) { _, cell in resolveGrapheme(for: cell) }
+            continuesRow = isWrapped
+        }
+
+        if usingAlternateBuffer {
+            // 1049 saves the primary cursor and clears the alternate screen.
+            let saved = cursor.savedPrimary
+            out += "\u{1B}[\((saved?.row ?? 0) + 1);\((saved?.col ?? 0) + 1)H"
+            out += "\u{1B}[?\(DECPrivateMode.altScreen)h"
+            for row in 0..<rows {
+                let rowCells = Array(alternateCells[physicalRow(row, base: alternateRowBase, map: alternateRowMap)])
+                out += "\u{1B}[\(row + 1);1H"
+                writeRow(rowCells, isWrapped: false) { _, cell in resolveGrapheme(for: cell) }
+            }
+        }
+
+        // Modes, then the pen and the cursor.
+        out += KeyframeStyle.reset.sgr
+        if scrollTop != 0 || scrollBottom != rows - 1 {
+            out += "\u{1B}[\(scrollTop + 1);\(scrollBottom + 1)r"
+        }
+        var privateModes: [Int] = []
+        if applicationCursorKeys { privateModes.append(DECPrivateMode.DECCKM) }
+        if reverseVideo { privateModes.append(DECPrivateMode.DECSCNM) }
+        if originMode { privateModes.append(DECPrivateMode.DECOM) }
+        if bracketedPasteMode { privateModes.append(DECPrivateMode.bracketedPaste) }
+        if focusReporting { privateModes.append(DECPrivateMode.focusEvent) }
+        switch mouseTracking {
+        case .none: break
+        case .x10: privateModes.append(DECPrivateMode.mouseX10)
+        case .buttonEvent: privateModes.append(DECPrivateMode.mouseButton)
+        case .anyEvent: privateModes.append(DECPrivateMode.mouseAny)
+        }
+        switch mouseEncoding {
+        case .x10: break
+        case .utf8: privateModes.append(DECPrivateMode.mouseUTF8)
+        case .sgr: privateModes.append(DECPrivateMode.mouseSGR)
+        }
+        for mode in privateModes {
+            out += "\u{1B}[?\(mode)h"
+        }
+        if !autoWrapMode { out += "\u{1B}[?\(DECPrivateMode.DECAWM)l" }
+        if !cursor.visible { out += "\u{1B}[?\(DECPrivateMode.DECTCEM)l" }
+        if insertMode { out += "\u{1B}[\(ANSIMode.IRM)h" }
+        if lineFeedMode { out += "\u{1B}[\(ANSIMode.LNM)h" }
+        if applicationKeypad { out += "\u{1B}=" }
+        out += "\u{1B}[\(Int(cursor.style.rawValue) * 2 + (cursor.blinkEnabled ? 1 : 2)) q"
+        if !iconName.isEmpty { out += "\u{1B}]1;\(iconName)\u{07}" }
+        if !windowTitle.isEmpty { out += "\u{1B}]2;\(windowTitle)\u{07}" }
+
+        let state = sgrState()
+        out += KeyframeStyle(
+            attributes: state.attributes,
+            fg: state.fg,
+            bg: state.bg,
+            underlineColor: state.underlineColor,
+            underlineStyle: state.underlineStyle
+        ).sgr
+        let cursorRow = originMode ? cursor.row - scrollTop : cursor.row
+        out += "\u{1B}[\(cursorRow + 1);\(cursor.col + 1)H"
+        return Array(out.utf8)
+    }
+}
+
+// MARK: - KeyframeStyle
+
+/// One SGR state, compared per cell while writing a keyframe.
+private nonisolated struct KeyframeStyle: Equatable {
+    /// Attributes SGR can set; markers such as `.wrapped` are left out.
+    private static let sgrAttributes: CellAttributes = [
+        .bold, .dim, .italic, .underline, .blink, .reverse, .hidden, .strikethrough, .doubleUnder, .overline
+    ]
+
+    static let reset = KeyframeStyle(attributes: [], fg: .default, bg: .default, underlineColor: .default, underlineStyle: .none)
+
+    let attributes: CellAttributes
+    let fg: TerminalColor
+    let bg: TerminalColor
+    let underlineColor: TerminalColor
+    let underlineStyle: UnderlineStyle
+
+    init(attributes: CellAttributes, fg: TerminalColor, bg: TerminalColor, underlineColor: TerminalColor, underlineStyle: UnderlineStyle) {
+        self.attributes = attributes.intersection(Self.sgrAttributes)
+        self.fg = fg
+        self.bg = bg
+        self.underlineColor = underlineColor
+        self.underlineStyle = underlineStyle
+    }
+
+    init(_ cell: TerminalCell) {
+        self.init(
+            attributes: cell.attributes,
+            fg: cell.fgColor,
+            bg: cell.bgColor,
+            underlineColor: cell.underlineColor,
+            underlineStyle: cell.underlineStyle
+        )
+    }
+
+    /// `CSI 0;… m` setting exactly this state.
+    var sgr: String {
+        var codes = [String(SGRCode.reset)]
+        if attributes.contains(.bold) { codes.append(String(SGRCode.bold)) }
+        if attributes.contains(.dim) { codes.append(String(SGRCode.dim)) }
+        if attributes.contains(.italic) { codes.append(String(SGRCode.italic)) }
+        if underlineStyle != .none {
+            codes.append("\(SGRCode.underline):\(underlineStyle.rawValue)")
+        } else if attributes.contains(.underline) {
+            codes.append(String(SGRCode.underline))
+        } else if attributes.contains(.doubleUnder) {
+            codes.append(String(SGRCode.doubleUnderline))
+        }
+        if attributes.contains(.blink) { codes.append(String(SGRCode.slowBlink)) }
+        if attributes.contains(.reverse) { codes.append(String(SGRCode.reverse)) }
+        if attributes.contains(.hidden) { codes.append(String(SGRCode.hidden)) }
+        if attributes.contains(.strikethrough) { codes.append(String(SGRCode.strikethrough)) }
+        if attributes.contains(.overline) { codes.append(String(SGRCode.overline)) }
+        Self.appendColor(fg, base: 30, bright: 90, extended: 38, to: &codes)
+        Self.appendColor(bg, base: 40, bright: 100, extended: 48, to: &codes)
+        Self.appendColor(underlineColor, base: nil, bright: nil, extended: 58, to: &codes)
+        return "\u{1B}[" + codes.joined(separator: ";") + "m"
+    }
+
+    private static func appendColor(_ color: TerminalColor, base: Int?, bright: Int?, extended: Int, to codes: inout [String]) {
+        switch color {
+        case .default:
+            break
+        case .indexed(let index):
+            if let base, index < 8 {
+                codes.append(String(base + Int(index)))
+            } else if let bright, index < 16 {
+                codes.append(String(bright + Int(index) - 8))
+            } else {
+                codes.append("\(extended);5;\(index)")
+            }
+        case .rgb(let r, let g, let b):
+            codes.append("\(extended);2;\(r);\(g);\(b)")
+        }
+    }
+}
@@ -9,9 +9,9 @@ extension TerminalGrid {
     /// Perform a full terminal reset.
     nonisolated func fullReset() {
         // Reset buffers
-        let blankRow = makeBlankRow()
-        primaryCells = [[TerminalCell]](repeating: blankRow, count: rows)
-        alternateCells = [[TerminalCell]](repeating: blankRow, count: rows)
+        let blankCell = makeBlankCell()
+        primaryCells = CellArena(rows: rows, columns: columns, repeating: blankCell)
+        alternateCells = CellArena(rows: rows, columns: columns, repeating: blankCell)
         primaryRowBase = 0
         alternateRowBase = 0
         primaryRowMap = Array(0..<rows)
@@ -59,7 +59,9 @@ extension TerminalGrid {
 
         // Reset scrollback and side table
         scrollback.clear()
+        commandOutputFolds.removeAll()
         graphemeSideTable.clear()
+        resetInlineImages()
 
         lastPrintedChar = nil
 
@@ -110,8 +112,8 @@ extension TerminalGrid {
             for row in 0..<rows {
                 let physical = physicalRow(row, base: base)
                 for col in 0..<columns {
-                    releaseCellGrapheme(buf[physical][col].codepoint)
-                    buf[physical][col] = eCell
+                    releaseCellGrapheme(buf[physical, col].codepoint)
+                    buf[physical, col] = eCell
                 }
             }
         }
@@ -127,6 +129,13 @@ extension TerminalGrid {
     nonisolated func resize(newColumns: Int, newRows: Int) {
         guard newColumns > 0 && newRows > 0 else { return }
         guard newColumns != columns || newRows != rows else { return }
+        let traceStart = TraceRecorder.shared.begin()
+        defer { TraceRecorder.shared.end(.reflow, since: traceStart) }
+        // Reflow renumbers lines, so output marks no longer apply.
+        semanticOutputStart = nil
+        semanticZones.removeAll()
+        removeAllInlineImagePlacements()
+        predictiveEcho.predictions.removeAll()
 
         let oldColumns = columns
 
@@ -146,10 +155,23 @@ extension TerminalGrid {
 
         let primaryForReflow = linearizedRows(primaryCells, base: primaryRowBase, map: primaryRowMap)
 
+        // Only the screen and the most recent scrollback are rewrapped now.
+        // Older lines keep their layout and are marked for deferred reflow,
+        // which runs when they are scrolled into view or searched.
+        let margin = max(GridReflow.liveReflowMargin, rows, newRows)
+        let boundary = scrollback.reflowBoundary(keeping: margin)
+        var recentScrollback = ScrollbackBuffer(maxLines: Int.max, spillFile: { nil })
+        for line in scrollback.removeLast(scrollback.count - boundary) {
+            recentScrollback.push(line)
+        }
+        if oldColumns != newColumns {
+            scrollback.deferReflow(throughLine: boundary, columns: oldColumns)
+        }
+
         // Reflow primary buffer (the one with scrollback that needs proper reflow)
         let reflowResult = GridReflow.reflow(
             screenRows: primaryForReflow,
-            scrollback: scrollback,
+            scrollback: recentScrollback,
             cursorRow: primaryCursorRow,
             cursorCol: primaryCursorCol,
             oldColumns: oldColumns,
@@ -157,19 +179,19 @@ extension TerminalGrid {
             newRows: newRows
         )
 
-        primaryCells = reflowResult.screenRows
+        primaryCells = CellArena(reflowResult.screenRows, columns: newColumns)
         primaryRowBase = 0
 
-        // Rebuild scrollback from reflow result
-        scrollback = ScrollbackBuffer(maxLines: maxScrollbackLines)
+        // Append the reflowed recent history after the deferred prefix
         for line in reflowResult.scrollbackLines {
             scrollback.push(line)
         }
 
         // Simple resize for alternate buffer (TUI apps redraw on SIGWINCH)
         let alternateForResize = linearizedRows(alternateCells, base: alternateRowBase, map: alternateRowMap)
-        alternateCells = simpleResizeBuffer(
-            alternateForResize, newRows: newRows, newColumns: newColumns
+        alternateCells = CellArena(
+            simpleResizeBuffer(alternateForResize, newRows: newRows, newColumns: newColumns),
+            columns: newColumns
         )
         alternateRowBase = 0
 
@@ -204,6 +226,141 @@ extension TerminalGrid {
         markAllDirty()
     }
 
+    // MARK: - Deferred Reflow
+
+    /// Rewrap scrollback that earlier resizes left at its old width. Called
+    /// before that history is shown or searched; a no-op otherwise.
+    nonisolated func settleDeferredReflow() {
+        let segments = scrollback.deferredReflow
+        guard !segments.isEmpty else { return }
+
+        let lines = scrollback.allLines()
+        scrollback.clear()
+        var index = 0
+        for segment in segments {
+            let end = min(index + segment.lineCount, lines.count)
+            let rewrapped = GridReflow.rewrapScrollback(
+                Array(lines[index..<end]),
+                oldColumns: segment.columns,
+                newColumns: columns
+            )
+            for line in rewrapped {
+                scrollback.push(line)
+            }
+            index = end
+        }
+        for line in lines[index...] {
+            scrollback.push(line)
+        }
+    }
+
+    // MARK: - Background Resize
+
+    /// An independent copy of `other` that can be resized off the engine
+    /// actor. Buffers are copy-on-write and scrollback pages are shared, so
+    /// the copy itself is cheap; the cost lands on whichever side mutates.
+    nonisolated convenience init(copying other: TerminalGrid) {
+        self.init(
+            columns: other.columns,
+            rows: other.rows,
+            maxScrollbackLines: other.maxScrollbackLines,
+            indexesScrollback: other.scrollback.indexesText
+        )
+        adoptState(from: other)
+    }
+
+    /// Take over every piece of terminal state from `other`, keeping this
+    /// grid's identity (the engine holds it by `let`). Snapshot scratch
+    /// buffers are kept but marked stale, so the next frames encode in full.
+    nonisolated func adoptState(from other: TerminalGrid) {
+        columns = other.columns
+        rows = other.rows
+        primaryCells = other.primaryCells
+        primaryRowBase = other.primaryRowBase
+        primaryRowMap = other.primaryRowMap
+        alternateCells = other.alternateCells
+        alternateRowBase = other.alternateRowBase
+        alternateRowMap = other.alternateRowMap
+        usingAlternateBuffer = other.usingAlternateBuffer
+        scrollback = other.scrollback
+        commandOutputFolds = other.commandOutputFolds
+        graphemeSideTable = other.graphemeSideTable
+        cursor = other.cursor
+        lastPrintedChar = other.lastPrintedChar
+        scrollTop = other.scrollTop
+        scrollBottom = other.scrollBottom
+
+        originMode = other.originMode
+        autoWrapMode = other.autoWrapMode
+        insertMode = other.insertMode
+        applicationCursorKeys = other.applicationCursorKeys
+        applicationKeypad = other.applicationKeypad
+        bracketedPasteMode = other.bracketedPasteMode
+        synchronizedOutput = other.synchronizedOutput
+        syncExitSnapshots = other.syncExitSnapshots
+        reverseVideo = other.reverseVideo
+        mouseTracking = other.mouseTracking
+        mouseEncoding = other.mouseEncoding
+        focusReporting = other.focusReporting
+        lineFeedMode = other.lineFeedMode
+        floodMode = other.floodMode
+
+        activeCharset = other.activeCharset
+        g0Charset = other.g0Charset
+        g1Charset = other.g1Charset
+        tabStopMask = other.tabStopMask
+
+        windowTitle = other.windowTitle
+        iconName = other.iconName
+        pendingBellCount = other.pendingBellCount
+        workingDirectory = other.workingDirectory
+        currentHyperlink = other.currentHyperlink
+
+        customPalette = other.customPalette
+        packedPalette = other.packedPalette
+        cursorColor = other.cursorColor
+        defaultForegroundColor = other.defaultForegroundColor
+        defaultBackgroundColor = other.defaultBackgroundColor
+
+        currentAttributes = other.currentAttributes
+        currentFgColor = other.currentFgColor
+        currentBgColor = other.currentBgColor
+        currentUnderlineColor = other.currentUnderlineColor
+        currentUnderlineStyle = other.currentUnderlineStyle
+        currentFgPacked = other.currentFgPacked
+        currentBgPacked = other.currentBgPacked
+        currentUnderlinePacked = other.currentUnderlinePacked
+        currentFgBoldPacked = other.currentFgBoldPacked
+
+        dirtyRows = other.dirtyRows
+        rewrittenRows = other.rewrittenRows
+        pendingScroll = other.pendingScroll
+        hasDirtyCells = other.hasDirtyCells
+        semanticOutputStart = nil
+        semanticZones.removeAll()
+        let previousImages = inlineImages.referencedImageIDs
+        inlineImages = other.inlineImages
+        releaseUnreferencedImages(Array(previousImages))
+        lastSnapshot = other.lastSnapshot
+        compactSnapshots = other.compactSnapshots
+        invalidateSnapshotBuffers()
+        scrollbackRowCache.removeAll()
+    }
+
+    /// Search scrollback, rewrapping any deferred history first so indices
+    /// match what `snapshot(scrollOffset:)` shows.
+    nonisolated func searchScrollback(_ query: String, caseSensitive: Bool = false) -> [Int] {
+        settleDeferredReflow()
+        return scrollback.search(query, caseSensitive: caseSensitive)
+    }
+
+    /// A copy of scrollback for searching off the engine actor, rewrapped
+    /// like `searchScrollback`. Pages are shared, so the copy is cheap.
+    nonisolated func searchableScrollback() -> ScrollbackBuffer {
+        settleDeferredReflow()
+        return scrollback
+    }
+
     /// Simple buffer resize without reflow (for alternate screen buffer).
     nonisolated func simpleResizeBuffer(
         _ buffer: [[TerminalCell]],
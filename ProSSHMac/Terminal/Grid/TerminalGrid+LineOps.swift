@@ -24,16 +24,13 @@ extension TerminalGrid {
             let row = physicalRow(logicalRow, base: base)
             // Release side-table entries for cells being deleted
             for col in cursor.col..<min(cursor.col + count, columns) {
-                releaseCellGrapheme(buf[row][col].codepoint)
+                releaseCellGrapheme(buf[row, col].codepoint)
             }
             // Shift left
-            for col in cursor.col..<columns {
-                let srcCol = col + count
-                if srcCol < columns {
-                    buf[row][col] = buf[row][srcCol]
-                } else {
-                    buf[row][col] = erasedCell
-                }
+            let kept = max(columns - cursor.col - count, 0)
+            buf.moveCells(inRow: row, from: cursor.col + count, to: cursor.col, count: kept)
+            for col in (cursor.col + kept)..<columns {
+                buf[row, col] = erasedCell
             }
         }
         markDirty(row: logicalRow)
@@ -48,16 +45,14 @@ extension TerminalGrid {
             // Release side-table entries for cells pushed off right edge
             let discardStart = max(columns - count, col)
             for c in discardStart..<columns {
-                releaseCellGrapheme(buf[physical][c].codepoint)
+                releaseCellGrapheme(buf[physical, c].codepoint)
             }
             // Shift right
-            for c in stride(from: columns - 1, through: col + count, by: -1) {
-                buf[physical][c] = buf[physical][c - count]
-            }
+            buf.moveCells(inRow: physical, from: col, to: col + count, count: max(columns - col - count, 0))
 
             // Fill blanks
             for c in col..<min(col + count, columns) {
-                buf[physical][c] = erasedCell
+                buf[physical, c] = erasedCell
             }
         }
         markDirty(row: row)
@@ -79,11 +74,11 @@ extension TerminalGrid {
                 for row in stride(from: scrollBottom, through: top + 1, by: -1) {
                     let dst = physicalRow(row, base: base)
                     let src = physicalRow(row - 1, base: base)
-                    buf[dst] = buf[src]
+                    buf.copyRow(src, to: dst)
                     markDirty(row: row)
                 }
                 let topPhysical = physicalRow(top, base: base)
-                buf[topPhysical] = makeBlankRow()
+                buf.fillRow(topPhysical, with: makeBlankCell())
                 markDirty(row: top)
             }
         }
@@ -104,11 +99,11 @@ extension TerminalGrid {
                 for row in top..<scrollBottom {
                     let dst = physicalRow(row, base: base)
                     let src = physicalRow(row + 1, base: base)
-                    buf[dst] = buf[src]
+                    buf.copyRow(src, to: dst)
                     markDirty(row: row)
                 }
                 let bottomPhysical = physicalRow(scrollBottom, base: base)
-                buf[bottomPhysical] = makeBlankRow()
+                buf.fillRow(bottomPhysical, with: makeBlankCell())
                 markDirty(row: scrollBottom)
             }
         }
@@ -182,19 +182,20 @@ extension TerminalGrid {
     /// Set SGR foreground color.
     nonisolated func setCurrentFgColor(_ color: TerminalColor) {
         currentFgColor = color
-        currentFgPacked = color.packedRGBA()
+        currentFgPacked = packedPalette.packed(color)
+        currentFgBoldPacked = packedPalette.packedBold(color)
     }
 
     /// Set SGR background color.
     nonisolated func setCurrentBgColor(_ color: TerminalColor) {
         currentBgColor = color
-        currentBgPacked = color.packedRGBA()
+        currentBgPacked = packedPalette.packed(color)
     }
 
     /// Set SGR underline color (SGR 58/59).
     nonisolated func setCurrentUnderlineColor(_ color: TerminalColor) {
         currentUnderlineColor = color
-        currentUnderlinePacked = color.packedRGBA()
+        currentUnderlinePacked = packedPalette.packed(color)
     }
 
     /// Set SGR underline style (from SGR 4 subparameters).
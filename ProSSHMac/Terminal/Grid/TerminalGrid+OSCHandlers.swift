@@ -32,6 +32,8 @@ extension TerminalGrid {
     /// Set a custom palette color at a given index (OSC 4).
     nonisolated func setPaletteColor(index: UInt8, r: UInt8, g: UInt8, b: UInt8) {
         customPalette[index] = (r, g, b)
+        packedPalette.set(index: index, r: r, g: g, b: b)
+        invalidatePackedColors()
         markAllDirty()
     }
 
@@ -47,6 +49,8 @@ extension TerminalGrid {
     /// Reset a palette color to its default (OSC 104).
     nonisolated func resetPaletteColor(index: UInt8) {
         customPalette.removeValue(forKey: index)
+        packedPalette.reset(index: index)
+        invalidatePackedColors()
         markAllDirty()
     }
 
@@ -0,0 +1,259 @@
+// TerminalGrid+PredictiveEcho.swift
+// ProSSHV2
+//
+// Speculative local echo, after mosh. Over a 200 ms link every typed
+// character used to appear a full round trip after the key. With the mode
+// on, printable keystrokes are drawn at once as tentative cells with a
+// dotted underline. They are an overlay on the live snapshot and never
+// written to the grid. When server output arrives, each prediction the
+// cursor has moved past is checked against the real cell. A match retires
+// the prediction and the echo's timing feeds the latency estimate. A
+// mismatch drops every prediction.
+//
+// Predictions are only made where a wrong guess is cheap, and only drawn
+// once the link has shown it needs them:
+// - The primary buffer with a visible cursor, typing at the end of the
+//   line. The rest of the row must be blank, so insert-mode editing never
+//   shows a guess over existing text.
+// - Not after a password prompt on the cursor's row.
+// - Drawn only while the smoothed keystroke-to-echo time of confirmed
+//   predictions is at least `displayLatencyThreshold`. A LAN session never
+//   sees them.
+// - After a misprediction or a prediction that is never echoed (echo off),
+//   nothing is drawn until a prediction is confirmed again.
+
+import Foundation
+import QuartzCore
+
+// MARK: - EchoPrediction
+
+nonisolated struct EchoPrediction: Sendable, Equatable {
+    var row: Int
+    var column: Int
+    var codepoint: UInt32
+    var predictedAt: CFTimeInterval
+}
+
+// MARK: - PredictiveEchoState
+
+nonisolated struct PredictiveEchoState: Sendable {
+
+    /// Smoothed echo time at or above which predictions are drawn.
+    static let displayLatencyThreshold: CFTimeInterval = 0.030
+
+    /// A prediction not echoed within this long counts as a misprediction.
+    static let confirmationTimeout: CFTimeInterval = 1.0
+
+    /// Weight of each new sample in the smoothed echo time.
+    static let latencySmoothing: CFTimeInterval = 0.125
+
+    /// Pending predictions, left to right on one row.
+    var predictions: [EchoPrediction] = []
+
+    /// Smoothed keystroke-to-echo time of confirmed predictions.
+    var echoLatency: CFTimeInterval?
+
+    /// Cleared by a misprediction; set again by the next confirmation.
+    var isTrusted = true
+
+    /// The predictions the snapshot overlays.
+    var displayed: [EchoPrediction] {
+        guard isTrusted, let echoLatency, echoLatency >= Self.displayLatencyThreshold else { return [] }
+        return predictions
+    }
+
+    mutating func noteConfirmed(_ prediction: EchoPrediction, at now: CFTimeInterval) {
+        let sample = max(0, now - prediction.predictedAt)
+        echoLatency = echoLatency.map { $0 + (sample - $0) * Self.latencySmoothing } ?? sample
+        isTrusted = true
+    }
+
+    mutating func noteMispredicted() {
+        predictions.removeAll()
+        isTrusted = false
+    }
+}
+
+// MARK: - TerminalGrid
+
+extension TerminalGrid {
+
+    private static let passwordPromptPatterns = ["password:", "password for", "passphrase:", "passphrase for", "enter pin"]
+
+    /// Predicts the echo of keystroke `bytes`. Returns true when the drawn
+    /// overlay changed and the session should publish.
+    nonisolated func predictEcho(of bytes: [UInt8], at now: CFTimeInterval = CACurrentMediaTime()) -> Bool {
+        updatingEchoOverlay {
+            expireEchoPredictions(at: now)
+            if bytes == [0x7F] || bytes == [0x08] {
+                // Erase: the newest guess is retracted, not checked.
+                _ = predictiveEcho.predictions.popLast()
+                return
+            }
+            let scalars = String(decoding: bytes, as: UTF8.self).unicodeScalars
+            guard !scalars.isEmpty,
+                  scalars.allSatisfy({ $0.value >= 0x20 && $0.value != 0x7F && CharacterWidth.cellWidth($0.value) == 1 }),
+                  canPredictEcho else {
+                // Cursor keys, Enter, control characters: the cursor goes
+                // somewhere we cannot guess.
+                predictiveEcho.predictions.removeAll()
+                return
+            }
+            for scalar in scalars {
+                let column = predictiveEcho.predictions.last.map { $0.column + 1 } ?? cursor.col
+                guard column < columns - 1 else { break }
+                predictiveEcho.predictions.append(EchoPrediction(
+                    row: cursor.row,
+                    column: column,
+                    codepoint: scalar.value,
+                    predictedAt: now
+                ))
+            }
+        }
+    }
+
+    /// Checks pending predictions against output the grid has just
+    /// received. Returns true when the drawn overlay changed.
+    @discardableResult
+    nonisolated func settleEchoPredictions(at now: CFTimeInterval = CACurrentMediaTime()) -> Bool {
+        guard !predictiveEcho.predictions.isEmpty else { return false }
+        return updatingEchoOverlay {
+            guard let row = predictiveEcho.predictions.first?.row,
+                  row == cursor.row, !usingAlternateBuffer else {
+                // A newline or full-screen redraw moved the line; the guesses
+                // are neither right nor wrong.
+                predictiveEcho.predictions.removeAll()
+                return
+            }
+            while let prediction = predictiveEcho.predictions.first, cursor.col > prediction.column {
+                guard cellAt(row: row, col: prediction.column)?.codepoint == prediction.codepoint else {
+                    predictiveEcho.noteMispredicted()
+                    return
+                }
+                predictiveEcho.predictions.removeFirst()
+                predictiveEcho.noteConfirmed(prediction, at: now)
+            }
+            expireEchoPredictions(at: now)
+        }
+    }
+
+    /// Rows that carry drawn predictions. The snapshot marks them dirty so
+    /// they are encoded, and therefore overlaid, on every publish.
+    nonisolated func markEchoOverlayRowsDirty() {
+        for prediction in predictiveEcho.displayed {
+            hasDirtyCells = true
+            dirtyRows.insert(prediction.row)
+            rewrittenRows.insert(prediction.row)
+        }
+    }
+
+    /// Where the snapshot draws the cursor: after the last drawn
+    /// prediction, or nil for the grid's own cursor.
+    nonisolated var echoOverlayCursorColumn: Int? {
+        predictiveEcho.displayed.last.map { $0.column + 1 }
+    }
+
+    /// Writes the drawn predictions over a live snapshot's cells and moves
+    /// the cursor flag past them.
+    nonisolated func applyEchoOverlay(to buffer: inout ContiguousArray<CellInstance>) {
+        let displayed = predictiveEcho.displayed
+        guard let last = displayed.last else { return }
+        let realCursor = cursor.row * columns + cursor.col
+        let shownCursor = last.row * columns + last.column + 1
+        if cursor.visible, realCursor < buffer.count, shownCursor < buffer.count {
+            buffer[realCursor].flags &= ~CellInstance.flagCursor
+            buffer[shownCursor].flags |= CellInstance.flagCursor
+        }
+        for prediction in displayed {
+            let index = prediction.row * columns + prediction.column
+            guard index < buffer.count else { continue }
+            let cell = predictedCell(for: prediction)
+            buffer[index] = CellInstance(
+                row: UInt16(prediction.row),
+                col: UInt16(prediction.column),
+                glyphIndex: cell.codepoint,
+                fgColor: cell.fgPackedRGBA,
+                bgColor: cell.bgPackedRGBA,
+                underlineColor: cell.underlinePackedRGBA,
+                attributes: cell.attributes.rawValue,
+                flags: buffer[index].flags & ~CellInstance.flagCursor,
+                underlineStyle: cell.underlineStyle.rawValue
+            )
+        }
+    }
+
+    /// Compact-snapshot variant of `applyEchoOverlay(to:)`.
+    nonisolated func applyEchoOverlay(to buffer: inout ContiguousArray<TerminalCell>) {
+        for prediction in predictiveEcho.displayed {
+            let index = prediction.row * columns + prediction.column
+            guard index < buffer.count else { continue }
+            buffer[index] = predictedCell(for: prediction)
+        }
+    }
+
+    // MARK: Private
+
+    private nonisolated func predictedCell(for prediction: EchoPrediction) -> TerminalCell {
+        let underlying = cellAt(row: prediction.row, col: prediction.column) ?? .blank
+        return TerminalCell(
+            codepoint: prediction.codepoint,
+            fgPacked: currentFgPacked,
+            bgPacked: underlying.bgPackedRGBA,
+            ulPacked: 0,
+            attributes: [],
+            underlineStyle: .dotted,
+            width: 1
+        )
+    }
+
+    /// Whether the next keystroke can be guessed: primary buffer, cursor
+    /// visible, nothing to the right of where it would land, no password
+    /// prompt before it.
+    private nonisolated var canPredictEcho: Bool {
+        guard !usingAlternateBuffer, cursor.visible, !insertMode else { return false }
+        let row = cursor.row
+        let column = predictiveEcho.predictions.last.map { $0.column + 1 } ?? cursor.col
+        if let first = predictiveEcho.predictions.first, first.row != row {
+            return false
+        }
+        guard column < columns - 1 else { return false }
+        for col in column..<columns {
+            let codepoint = cellAt(row: row, col: col)?.codepoint ?? 0
+            if codepoint != 0 && codepoint != 0x20 { return false }
+        }
+        return !rowPrefixLooksLikePasswordPrompt(row: row, before: cursor.col)
+    }
+
+    private nonisolated func rowPrefixLooksLikePasswordPrompt(row: Int, before column: Int) -> Bool {
+        var scalars = String.UnicodeScalarView()
+        for col in 0..<min(column, columns) {
+            let codepoint = cellAt(row: row, col: col)?.codepoint ?? 0
+            guard codepoint < 0x80 else { continue }
+            scalars.append(Unicode.Scalar(UInt8(codepoint == 0 ? 0x20 : codepoint)))
+        }
+        let text = String(scalars).lowercased()
+        return Self.passwordPromptPatterns.contains { text.contains($0) }
+    }
+
+    private nonisolated func expireEchoPredictions(at now: CFTimeInterval) {
+        guard let oldest = predictiveEcho.predictions.first,
+              now - oldest.predictedAt > PredictiveEchoState.confirmationTimeout else { return }
+        // Never echoed: most likely echo is off.
+        predictiveEcho.noteMispredicted()
+    }
+
+    /// Runs `body` and marks the rows of predictions it stopped drawing
+    /// dirty, so the next snapshot shows the grid's own cells there.
+    private nonisolated func updatingEchoOverlay(_ body: () -> Void) -> Bool {
+        let before = predictiveEcho.displayed
+        body()
+        let after = predictiveEcho.displayed
+        guard before != after else { return false }
+        for prediction in before {
+            hasDirtyCells = true
+            dirtyRows.insert(prediction.row)
+            rewrittenRows.insert(prediction.row)
+        }
+        return true
+    }
+}
@@ -48,7 +48,7 @@ extension TerminalGrid {
         // Pre-apply boldIsBright at write-time
         let fgPacked: UInt32
         if TerminalDefaults.boldIsBright && attributes.contains(.bold) {
-            fgPacked = currentFgColor.packedRGBA(bold: true, boldIsBright: true)
+            fgPacked = currentFgBoldPacked
         } else {
             fgPacked = currentFgPacked
         }
@@ -58,8 +58,8 @@ extension TerminalGrid {
         // Write the cell(s) in place.
         withActiveBuffer { buffer, base in
             let physical = physicalRow(row, base: base)
-            releaseCellGrapheme(buffer[physical][col].codepoint)
-            buffer[physical][col] = TerminalCell(
+            releaseCellGrapheme(buffer[physical, col].codepoint)
+            buffer[physical, col] = TerminalCell(
                 codepoint: cp,
                 fgPacked: fgPacked,
                 bgPacked: currentBgPacked,
@@ -71,8 +71,8 @@ extension TerminalGrid {
 
             // For wide characters, write a continuation cell.
             if isWide && col + 1 < columns {
-                releaseCellGrapheme(buffer[physical][col + 1].codepoint)
-                buffer[physical][col + 1] = TerminalCell(
+                releaseCellGrapheme(buffer[physical, col + 1].codepoint)
+                buffer[physical, col + 1] = TerminalCell(
                     codepoint: 0,
                     fgPacked: fgPacked,
                     bgPacked: currentBgPacked,
@@ -158,7 +158,7 @@ extension TerminalGrid {
         let attrs = currentAttributes
         let fgPacked: UInt32
         if TerminalDefaults.boldIsBright && attrs.contains(.bold) {
-            fgPacked = currentFgColor.packedRGBA(bold: true, boldIsBright: true)
+            fgPacked = currentFgBoldPacked
         } else {
             fgPacked = currentFgPacked
         }
@@ -176,54 +176,7 @@ extension TerminalGrid {
 
                 // Handle pending wrap
                 if cursor.pendingWrap {
-                    // Mark the current line as wrapped
-                    let lastCol = columns - 1
-                    let wrappedPhysical = physicalRow(cursor.row, base: base, map: rowMap)
-                    var lastCell = buf[wrappedPhysical][lastCol]
-                    lastCell.attributes.insert(.wrapped)
-                    lastCell.isDirty = true
-                    buf[wrappedPhysical][lastCol] = lastCell
-
-                    dirtyRowLo = min(dirtyRowLo, cursor.row)
-                    dirtyRowHi = max(dirtyRowHi, cursor.row)
-
-                    cursor.col = 0
-                    cursor.pendingWrap = false
-
-                    if cursor.row == scrollBottom {
-                        // Inline scrollUp(lines: 1), using O(1) ring rotation
-                        // for the common full-screen scroll region.
-                        if !usingAlternateBuffer {
-                            let topPhysical = physicalRow(scrollTop, base: base, map: rowMap)
-                            var topRow = buf[topPhysical]
-                            let graphemeOverrides = resolveSideTableEntries(in: &topRow)
-                            let isWrapped = topRow.last.map { $0.attributes.contains(.wrapped) } ?? false
-                            scrollback.push(cells: topRow, isWrapped: isWrapped, graphemeOverrides: graphemeOverrides)
-                        }
-
-                        if scrollTop == 0 && scrollBottom == rows - 1 {
-                            base += 1
-                            if base == rows { base = 0 }
-                        } else {
-                            let regionCount = scrollBottom - scrollTop + 1
-                            var regionKeys = [Int]()
-                            regionKeys.reserveCapacity(regionCount)
-                            for row in scrollTop...scrollBottom {
-                                regionKeys.append(logicalRowIndex(row, base: base))
-                            }
-                            let regionPhysicalRows = regionKeys.map { rowMap[$0] }
-                            for i in 0..<regionCount {
-                                rowMap[regionKeys[i]] = regionPhysicalRows[(i + 1) % regionCount]
-                            }
-                        }
-
-                        let bottomPhysical = physicalRow(scrollBottom, base: base, map: rowMap)
-                        buf[bottomPhysical] = makeBlankRow()
-                        dirtyRowLo = min(dirtyRowLo, scrollTop)
-                        dirtyRowHi = max(dirtyRowHi, scrollBottom)
-                    } else if cursor.row < rows - 1 {
-                        cursor.row += 1
-                    }
+                    wrapInPlace(buf: &buf, base: &base, rowMap: &rowMap, dirtyRowLo: &dirtyRowLo, dirtyRowHi: &dirtyRowHi)
                 }
 
                 // Resolve character string and codepoint — ASCII is never wide
@@ -261,7 +214,7 @@ extension TerminalGrid {
                 let col = cursor.col
                 let physical = physicalRow(row, base: base, map: rowMap)
 
-                buf[physical][col] = TerminalCell(
+                buf[physical, col] = TerminalCell(
                     codepoint: codepoint,
                     fgPacked: fgPacked,
                     bgPacked: bgPacked,
@@ -297,12 +250,248 @@ extension TerminalGrid {
         }
     }
 
+    /// Print a run of Unicode scalar values (see `UTF8TextDecoder`).
+    /// Widths come from the `CharacterWidth.cellWidth` table, the whole run
+    /// (wraps and scrolls included) is written inside one
+    /// `withActiveBufferState` call, and dirty rows are marked once at the
+    /// end. Scalars are stored as cell codepoints directly; the grapheme side
+    /// table is only touched when `GraphemeClusterBreak` joins a combining
+    /// mark, variation selector or ZWJ sequence to the previous cell, and
+    /// then by scalars, so a cluster already on screen builds no String.
+    nonisolated func printCodepoints(_ codepoints: UnsafeBufferPointer<UInt32>) {
+        guard !codepoints.isEmpty else { return }
+
+        // Insert mode and non-ASCII charsets are rare; use the per-character
+        // path so insertBlanks() and charset mapping apply unchanged.
+        let charset: Charset = (activeCharset == 1) ? g1Charset : g0Charset
+        if insertMode || charset != .ascii {
+            let cs = charsetState()
+            for value in codepoints {
+                if value < 0x80 {
+                    printCharacter(CharsetHandler.mapCharacter(UInt8(value), charsetState: cs))
+                } else {
+                    printCharacter(Character(Unicode.Scalar(value) ?? "\u{FFFD}"))
+                }
+            }
+            return
+        }
+
+        let attrs = currentAttributes
+        let wideAttrs = attrs.union(.wideChar)
+        let fgPacked: UInt32
+        if TerminalDefaults.boldIsBright && attrs.contains(.bold) {
+            fgPacked = currentFgBoldPacked
+        } else {
+            fgPacked = currentFgPacked
+        }
+        let bgPacked = currentBgPacked
+        let ulPacked = currentUnderlinePacked
+        let ulStyle = currentUnderlineStyle
+
+        var lastBaseValue: UInt32?
+
+        withActiveBufferState { buf, base, rowMap in
+            var dirtyRowLo = Int.max
+            var dirtyRowHi = -1
+            var clusterBreak = GraphemeClusterBreak()
+
+            for value in codepoints {
+                let width = CharacterWidth.cellWidth(value)
+
+                // Zero-width scalars, and pictographs joined by a ZWJ, extend
+                // the grapheme in the previous cell instead of taking a new one.
+                if clusterBreak.extendsCluster(value, width: width) {
+                    if appendToPreviousCell(value, buf: &buf, base: base, rowMap: rowMap) {
+                        dirtyRowLo = min(dirtyRowLo, cursor.row)
+                        dirtyRowHi = max(dirtyRowHi, cursor.row)
+                    }
+                    continue
+                }
+
+                let isWide = width == 2
+                if cursor.pendingWrap {
+                    wrapInPlace(buf: &buf, base: &base, rowMap: &rowMap, dirtyRowLo: &dirtyRowLo, dirtyRowHi: &dirtyRowHi)
+                }
+                // Wide character at the last column wraps first (see printCharacter).
+                if isWide && cursor.col >= columns - 1 && autoWrapMode {
+                    wrapInPlace(buf: &buf, base: &base, rowMap: &rowMap, dirtyRowLo: &dirtyRowLo, dirtyRowHi: &dirtyRowHi)
+                }
+
+                let row = cursor.row
+                let col = cursor.col
+                let physical = physicalRow(row, base: base, map: rowMap)
+
+                releaseCellGrapheme(buf[physical, col].codepoint)
+                buf[physical, col] = TerminalCell(
+                    codepoint: value,
+                    fgPacked: fgPacked,
+                    bgPacked: bgPacked,
+                    ulPacked: ulPacked,
+                    attributes: isWide ? wideAttrs : attrs,
+                    underlineStyle: ulStyle,
+                    width: width
+                )
+                if isWide && col + 1 < columns {
+                    releaseCellGrapheme(buf[physical, col + 1].codepoint)
+                    buf[physical, col + 1] = TerminalCell(
+                        codepoint: 0,
+                        fgPacked: fgPacked,
+                        bgPacked: bgPacked,
+                        ulPacked: ulPacked,
+                        attributes: attrs,
+                        underlineStyle: ulStyle,
+                        width: 0  // continuation
+                    )
+                }
+
+                dirtyRowLo = min(dirtyRowLo, row)
+                dirtyRowHi = max(dirtyRowHi, row)
+                lastBaseValue = value
+
+                if isWide {
+                    if cursor.col + 1 < columns - 1 {
+                        cursor.col += 2
+                    } else {
+                        cursor.col = columns - 1
+                        if autoWrapMode {
+                            cursor.pendingWrap = true
+                        }
+                    }
+                } else {
+                    cursor.advanceAfterPrint(gridCols: columns, autoWrap: autoWrapMode)
+                }
+            }
+
+            if dirtyRowLo <= dirtyRowHi {
+                markDirty(rows: dirtyRowLo...dirtyRowHi)
+            }
+        }
+
+        if let lastBaseValue {
+            lastPrintedChar = Character(Unicode.Scalar(lastBaseValue) ?? "\u{FFFD}")
+        }
+    }
+
+    /// Append a scalar to the grapheme in the cell just before the cursor,
+    /// interning the grown cluster in the grapheme side table. Returns false
+    /// when there is no printed cell to attach to; the scalar is then
+    /// dropped, as xterm does.
+    nonisolated private func appendToPreviousCell(
+        _ value: UInt32,
+        buf: inout CellArena,
+        base: Int,
+        rowMap: [Int]
+    ) -> Bool {
+        guard Unicode.Scalar(value) != nil else { return false }
+        var col = cursor.pendingWrap ? cursor.col : cursor.col - 1
+        guard col >= 0 else { return false }
+        let physical = physicalRow(cursor.row, base: base, map: rowMap)
+        if col > 0 && buf[physical, col].width == 0 {
+            col -= 1  // continuation half of a wide character
+        }
+
+        let previous = buf[physical, col].codepoint
+        guard previous != 0 else { return false }
+        let codepoint: UInt32
+        if GraphemeSideTable.isSideTable(previous) {
+            guard let existing = graphemeSideTable.scalars(of: previous) else { return false }
+            codepoint = withUnsafeTemporaryAllocation(of: UInt32.self, capacity: existing.count + 1) { cluster in
+                _ = cluster.initialize(fromContentsOf: existing)
+                cluster[existing.count] = value
+                return graphemeSideTable.intern(UnsafeBufferPointer(cluster))
+            }
+        } else {
+            guard Unicode.Scalar(previous) != nil else { return false }
+            codepoint = withUnsafeTemporaryAllocation(of: UInt32.self, capacity: 2) { cluster in
+                cluster[0] = previous
+                cluster[1] = value
+                return graphemeSideTable.intern(UnsafeBufferPointer(cluster))
+            }
+        }
+
+        releaseCellGrapheme(previous)
+        buf[physical, col].codepoint = codepoint
+        return true
+    }
+
+    /// Perform a pending wrap inside `withActiveBufferState`: mark the row as
+    /// wrapped, move to column 0 of the next row and scroll the region in
+    /// place when the cursor is on its bottom margin. Bulk print paths use
+    /// this instead of `performWrap()`, which re-enters the active buffer.
+    nonisolated private func wrapInPlace(
+        buf: inout CellArena,
+        base: inout Int,
+        rowMap: inout [Int],
+        dirtyRowLo: inout Int,
+        dirtyRowHi: inout Int
+    ) {
+        // Mark the current line as wrapped
+        let lastCol = columns - 1
+        let wrappedPhysical = physicalRow(cursor.row, base: base, map: rowMap)
+        var lastCell = buf[wrappedPhysical, lastCol]
+        lastCell.attributes.insert(.wrapped)
+        lastCell.isDirty = true
+        buf[wrappedPhysical, lastCol] = lastCell
+
+        dirtyRowLo = min(dirtyRowLo, cursor.row)
+        dirtyRowHi = max(dirtyRowHi, cursor.row)
+
+        cursor.col = 0
+        cursor.pendingWrap = false
+
+        if cursor.row == scrollBottom {
+            // Inline scrollUp(lines: 1), using O(1) ring rotation
+            // for the common full-screen scroll region.
+            if !usingAlternateBuffer {
+                let topPhysical = physicalRow(scrollTop, base: base, map: rowMap)
+                var topRow = Array(buf[topPhysical])
+                let graphemeOverrides = resolveSideTableEntries(in: &topRow)
+                let isWrapped = topRow.last.map { $0.attributes.contains(.wrapped) } ?? false
+                scrollback.push(cells: topRow, isWrapped: isWrapped, graphemeOverrides: graphemeOverrides)
+            }
+
+            if scrollTop == 0 && scrollBottom == rows - 1 {
+                base += 1
+                if base == rows { base = 0 }
+            } else {
+                let regionCount = scrollBottom - scrollTop + 1
+                var regionKeys = [Int]()
+                regionKeys.reserveCapacity(regionCount)
+                for row in scrollTop...scrollBottom {
+                    regionKeys.append(logicalRowIndex(row, base: base))
+                }
+                let regionPhysicalRows = regionKeys.map { rowMap[$0] }
+                for i in 0..<regionCount {
+                    rowMap[regionKeys[i]] = regionPhysicalRows[(i + 1) % regionCount]
+                }
+            }
+
+            let bottomPhysical = physicalRow(scrollBottom, base: base, map: rowMap)
+            buf.fillRow(bottomPhysical, with: makeBlankCell())
+            dirtyRowLo = min(dirtyRowLo, scrollTop)
+            dirtyRowHi = max(dirtyRowHi, scrollBottom)
+        } else if cursor.row < rows - 1 {
+            cursor.row += 1
+        }
+    }
+
     /// Process plain ground-state text bytes in bulk.
     /// Supports printable ASCII plus CR/LF controls.
     /// Accepts Data + range to avoid extra copies from VTParser.
     nonisolated func processGroundTextBytes(_ bytes: Data, range: Range<Int>) {
         guard !range.isEmpty else { return }
 
+        if floodMode, let floodStart = floodTextStart(bytes, range: range) {
+            printGroundTextRun(bytes, range: range.lowerBound..<floodStart)
+            processFloodText(bytes, range: floodStart..<range.upperBound)
+            return
+        }
+        printGroundTextRun(bytes, range: range)
+    }
+
+    nonisolated private func printGroundTextRun(_ bytes: Data, range: Range<Int>) {
+        guard !range.isEmpty else { return }
+
         var runStart: Int = -1
 
         for idx in range {
@@ -344,10 +533,10 @@ extension TerminalGrid {
             let lastCol = columns - 1
             withActiveBuffer { buffer, base in
                 let physical = physicalRow(row, base: base)
-                var lastCell = buffer[physical][lastCol]
+                var lastCell = buffer[physical, lastCol]
                 lastCell.attributes.insert(.wrapped)
                 lastCell.isDirty = true
-                buffer[physical][lastCol] = lastCell
+                buffer[physical, lastCol] = lastCell
             }
         }
 
@@ -28,8 +28,7 @@ extension TerminalGrid {
         usingAlternateBuffer = true
 
         // Clear the alternate buffer
-        let blankRow = makeBlankRow()
-        alternateCells = [[TerminalCell]](repeating: blankRow, count: rows)
+        alternateCells = CellArena(rows: rows, columns: columns, repeating: makeBlankCell())
         alternateRowBase = 0
         alternateRowMap = Array(0..<rows)
 
@@ -45,6 +44,7 @@ extension TerminalGrid {
         guard usingAlternateBuffer else { return }
 
         usingAlternateBuffer = false
+        removeAlternateInlineImages()
 
         // The TUI app that enabled synchronized output is leaving the
         // alternate buffer — disable sync mode so snapshot() returns
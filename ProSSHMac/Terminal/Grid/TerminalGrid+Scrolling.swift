@@ -16,13 +16,20 @@ extension TerminalGrid {
 
         withActiveBufferState { buf, base, rowMap in
             // Save top lines to scrollback (primary buffer only), preserving order.
+            // Rows go straight from the arena into recycled scrollback rows;
+            // only rows with side-table graphemes are copied out to resolve them.
             if !usingAlternateBuffer {
                 for i in 0..<lines {
                     let topPhysical = physicalRow(scrollTop + i, base: base, map: rowMap)
-                    var topRow = buf[topPhysical]
-                    let graphemeOverrides = resolveSideTableEntries(in: &topRow)
+                    let topRow = buf[topPhysical]
                     let isWrapped = topRow.last.map { $0.attributes.contains(.wrapped) } ?? false
-                    scrollback.push(cells: topRow, isWrapped: isWrapped, graphemeOverrides: graphemeOverrides)
+                    if graphemeSideTable.activeCount == 0 {
+                        scrollback.push(cells: topRow, isWrapped: isWrapped)
+                    } else {
+                        var cells = Array(topRow)
+                        let graphemeOverrides = resolveSideTableEntries(in: &cells)
+                        scrollback.push(cells: cells, isWrapped: isWrapped, graphemeOverrides: graphemeOverrides)
+                    }
                 }
             }
 
@@ -47,13 +54,11 @@ extension TerminalGrid {
             // Clear newly exposed bottom lines.
             for row in (scrollBottom - lines + 1)...scrollBottom {
                 let physical = physicalRow(row, base: base, map: rowMap)
-                buf[physical] = makeBlankRow()
+                buf.fillRow(physical, with: makeBlankCell())
             }
         }
 
-        if lines > 0 {
-            markDirty(rows: scrollTop...scrollBottom)
-        }
+        markScrolled(region: scrollTop...scrollBottom, lines: lines)
     }
 
     /// Scroll content down within the scroll region by `n` lines.
@@ -86,13 +91,11 @@ extension TerminalGrid {
             // Clear newly exposed top lines.
             for row in scrollTop..<(scrollTop + lines) {
                 let physical = physicalRow(row, base: base, map: rowMap)
-                buf[physical] = makeBlankRow()
+                buf.fillRow(physical, with: makeBlankCell())
             }
         }
 
-        if lines > 0 {
-            markDirty(rows: scrollTop...scrollBottom)
-        }
+        markScrolled(region: scrollTop...scrollBottom, lines: -lines)
     }
 
     /// Index (IND / ESC D): move cursor down, scroll if at bottom of scroll region.
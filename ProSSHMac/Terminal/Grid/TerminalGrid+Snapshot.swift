@@ -5,6 +5,41 @@ import Foundation
 import os.signpost
 #endif
 
+// MARK: - SnapshotBufferState
+
+/// What one of the double-buffered snapshot arrays holds. Because the two
+/// buffers alternate, the one being written was last filled two snapshots
+/// ago; only rows that changed since then, or whose dirty/cursor flags
+/// differ, need encoding again.
+nonisolated struct SnapshotBufferState: Sendable {
+    var columns = 0
+    var rows = 0
+    var cursorRow = -1
+    /// Rows encoded with the dirty flag set: those rewritten from the grid,
+    /// not moved by `scroll`.
+    var flaggedRows = DirtyRowSet()
+    var graphemeOverrides: [Int: String]?
+    /// The scroll that snapshot moved rows by, since the one before it.
+    var scroll: GridScrollDelta?
+}
+
+// MARK: - VisibleTextChanges
+
+/// The screen as text, and which rows changed since a caller's version.
+nonisolated struct VisibleTextChanges: Sendable, Equatable {
+    /// Pass back as `since` to get only later changes.
+    let version: UInt64
+    /// Every visible row, trailing whitespace trimmed.
+    let lines: [String]
+    /// Rows whose text changed, ascending; every row when `isComplete`.
+    let changedRows: [Int]
+    /// The rows were rebuilt (resize, buffer switch) since the caller's
+    /// version, so `lines` replaces what the caller had.
+    let isComplete: Bool
+
+    var hasChanges: Bool { !changedRows.isEmpty }
+}
+
 extension TerminalGrid {
 
     // MARK: - A.6.14 Grid Snapshot Generation
@@ -13,6 +48,8 @@ extension TerminalGrid {
         if respectingSynchronizedOutput, synchronizedOutput, let cached = lastSnapshot {
             return cached
         }
+        let allocationScope = AllocationTracker.begin(.snapshot)
+        defer { allocationScope?.end() }
         #if DEBUG
         let signpostID = OSSignpostID(log: Self.perfSignpostLog)
         os_signpost(
@@ -31,13 +68,19 @@ extension TerminalGrid {
         }
         #endif
 
+        markEchoOverlayRowsDirty()
+        if compactSnapshots {
+            return makeCompactSnapshot()
+        }
+
         let activeCells = usingAlternateBuffer ? alternateCells : primaryCells
         let rowBase = activeRowBase
-        let hasDirtyRange = hasDirtyCells && dirtyRowMin <= dirtyRowMax
-        let dirtyMin = dirtyRowMin
-        let dirtyMax = dirtyRowMax
+        let dirtyRuns = hasDirtyCells ? dirtyRows.runs(below: rows) : []
+        let hasDirtyRange = !dirtyRuns.isEmpty
         let totalCells = rows * columns
         let wideContinuationBit = CellAttributes.wideContinuation.rawValue
+        let scroll = publishableScroll
+        let rewritten = scroll == nil ? dirtyRows : rewrittenRows
 
         var buffer = ContiguousArray<CellInstance>()
         if useSnapshotBufferA {
@@ -46,20 +89,56 @@ extension TerminalGrid {
             swap(&buffer, &snapshotBufferB)
         }
 
-        if buffer.count != totalCells {
+        let bufferMatchesSize = buffer.count == totalCells
+        if !bufferMatchesSize {
             buffer = ContiguousArray(repeating: CellInstance(
                 row: 0, col: 0, glyphIndex: 0, fgColor: 0, bgColor: 0,
                 underlineColor: 0, attributes: 0, flags: 0, underlineStyle: 0
             ), count: totalCells)
         }
 
-        var idx = 0
+        // Rows to encode, once this buffer's rows are moved by the scrolls
+        // since it was written: everything rewritten now or in the previous
+        // snapshot (which went to the other buffer), rows this buffer
+        // flagged dirty last time, and the old and new cursor rows. The
+        // rest still hold what they would encode to, apart from the `row`
+        // of moved cells.
+        let state = useSnapshotBufferA ? snapshotStateA : snapshotStateB
+        let otherState = useSnapshotBufferA ? snapshotStateB : snapshotStateA
+        let carriesRows = bufferMatchesSize
+            && state.columns == columns && state.rows == rows
+            && otherState.columns == columns && otherState.rows == rows
+        var rowsToEncode = rewritten
         var graphemeOverrides: [Int: String]?
+        var moves: [GridScrollDelta] = []
+        if carriesRows {
+            moves = [otherState.scroll, scroll].compactMap { $0 }
+            for move in moves {
+                move.move(&buffer, columns: columns)
+            }
+            rowsToEncode.formUnion(scroll?.moving(otherState.flaggedRows) ?? otherState.flaggedRows)
+            rowsToEncode.formUnion(moves.reduce(state.flaggedRows) { $1.moving($0) })
+            rowsToEncode.insert(moves.reduce(state.cursorRow) { $1.destination(ofRow: $0) ?? -1 })
+            rowsToEncode.insert(cursor.row)
+            graphemeOverrides = carriedGraphemeOverrides(state.graphemeOverrides, moves: moves, skipping: rowsToEncode)
+        }
+
+        for move in moves {
+            for row in move.region where !rowsToEncode.contains(row) {
+                for idx in (row * columns)..<((row + 1) * columns) {
+                    buffer[idx].row = UInt16(row)
+                }
+            }
+        }
+
         for row in 0..<rows {
+            guard !carriesRows || rowsToEncode.contains(row) else { continue }
+            var idx = row * columns
             let physicalRowIndex = physicalRow(row, base: rowBase)
-            let rowIsDirty = hasDirtyRange && row >= dirtyMin && row <= dirtyMax
+            let rowCells = activeCells[physicalRowIndex]
+            let rowIsDirty = hasDirtyRange && rewritten.contains(row)
             for col in 0..<columns {
-                let cell = activeCells[physicalRowIndex][col]
+                let cell = rowCells[col]
                 let isCursor = (row == cursor.row && col == cursor.col && cursor.visible)
                 let hasGraphemeOverride = (cell.codepoint & GraphemeSideTable.sentinel) != 0
 
@@ -92,30 +171,44 @@ extension TerminalGrid {
                 idx += 1
             }
         }
+        applyEchoOverlay(to: &buffer)
 
         var dirtyRange: Range<Int>?
-        if hasDirtyRange {
-            let startIdx = dirtyMin * columns
-            let endIdx = (dirtyMax + 1) * columns
-            dirtyRange = startIdx..<endIdx
+        var damagedRanges: [Range<Int>]?
+        if let first = dirtyRuns.first, let last = dirtyRuns.last {
+            dirtyRange = (first.lowerBound * columns)..<((last.upperBound + 1) * columns)
+            damagedRanges = dirtyRuns.map { ($0.lowerBound * columns)..<(($0.upperBound + 1) * columns) }
         }
 
-        let snap = GridSnapshot(
+        var snap = GridSnapshot(
             cells: buffer,
             dirtyRange: dirtyRange,
+            damagedRanges: damagedRanges,
             cursorRow: cursor.row,
-            cursorCol: cursor.col,
+            cursorCol: echoOverlayCursorColumn ?? cursor.col,
             cursorVisible: cursor.visible,
             cursorStyle: cursor.style,
             columns: columns,
             rows: rows,
             usingAlternateBuffer: usingAlternateBuffer,
-            graphemeOverrides: graphemeOverrides
+            graphemeOverrides: graphemeOverrides,
+            inlineImages: liveInlineImageQuads()
+        )
+        stampSequence(on: &snap, scroll: scroll, rewritten: rewritten)
+        let newState = SnapshotBufferState(
+            columns: columns,
+            rows: rows,
+            cursorRow: cursor.row,
+            flaggedRows: hasDirtyRange ? rewritten : DirtyRowSet(),
+            graphemeOverrides: graphemeOverrides,
+            scroll: scroll
         )
         if useSnapshotBufferA {
             snapshotBufferA = buffer
+            snapshotStateA = newState
         } else {
             snapshotBufferB = buffer
+            snapshotStateB = newState
         }
 
         useSnapshotBufferA.toggle()
@@ -126,6 +219,172 @@ extension TerminalGrid {
         return snap
     }
 
+    /// Compact variant of `makeSnapshot`: rows are copied as stored, with no
+    /// per-cell encoding. Compact cells carry no dirty or cursor flags, so
+    /// once the buffer's rows are moved by the scrolls since it was last
+    /// written, only rows rewritten since (now, or in the previous
+    /// snapshot) are copied.
+    nonisolated private func makeCompactSnapshot() -> GridSnapshot {
+        let activeCells = usingAlternateBuffer ? alternateCells : primaryCells
+        let rowBase = activeRowBase
+        let dirtyRuns = hasDirtyCells ? dirtyRows.runs(below: rows) : []
+        let hasDirtyRange = !dirtyRuns.isEmpty
+        let totalCells = rows * columns
+        let scroll = publishableScroll
+        let rewritten = scroll == nil ? dirtyRows : rewrittenRows
+
+        var buffer = ContiguousArray<TerminalCell>()
+        if useSnapshotBufferA {
+            swap(&buffer, &compactSnapshotBufferA)
+        } else {
+            swap(&buffer, &compactSnapshotBufferB)
+        }
+
+        let bufferMatchesSize = buffer.count == totalCells
+        if !bufferMatchesSize {
+            buffer = ContiguousArray(repeating: .blank, count: totalCells)
+        }
+
+        let state = useSnapshotBufferA ? snapshotStateA : snapshotStateB
+        let otherState = useSnapshotBufferA ? snapshotStateB : snapshotStateA
+        let carriesRows = bufferMatchesSize
+            && state.columns == columns && state.rows == rows
+            && otherState.columns == columns && otherState.rows == rows
+        var rowsToCopy = rewritten
+        var graphemeOverrides: [Int: String]?
+        if carriesRows {
+            let moves = [otherState.scroll, scroll].compactMap { $0 }
+            for move in moves {
+                move.move(&buffer, columns: columns)
+            }
+            rowsToCopy.formUnion(scroll?.moving(otherState.flaggedRows) ?? otherState.flaggedRows)
+            graphemeOverrides = carriedGraphemeOverrides(state.graphemeOverrides, moves: moves, skipping: rowsToCopy)
+        }
+
+        buffer.withUnsafeMutableBufferPointer { dst in
+            guard let dstBase = dst.baseAddress else { return }
+            for row in 0..<rows {
+                guard !carriesRows || rowsToCopy.contains(row) else { continue }
+                let rowStart = row * columns
+                let rowCells = activeCells[physicalRow(row, base: rowBase)]
+                _ = rowCells.withContiguousStorageIfAvailable { src in
+                    guard let srcBase = src.baseAddress else { return }
+                    (dstBase + rowStart).update(from: srcBase, count: min(columns, src.count))
+                }
+                for col in 0..<columns where (dstBase[rowStart + col].codepoint & GraphemeSideTable.sentinel) != 0 {
+                    guard let grapheme = graphemeSideTable.resolve(dstBase[rowStart + col].codepoint) else { continue }
+                    if graphemeOverrides == nil {
+                        graphemeOverrides = [:]
+                    }
+                    graphemeOverrides?[rowStart + col] = grapheme
+                }
+            }
+        }
+        applyEchoOverlay(to: &buffer)
+
+        var dirtyRange: Range<Int>?
+        var damagedRanges: [Range<Int>]?
+        if let first = dirtyRuns.first, let last = dirtyRuns.last {
+            dirtyRange = (first.lowerBound * columns)..<((last.upperBound + 1) * columns)
+            damagedRanges = dirtyRuns.map { ($0.lowerBound * columns)..<(($0.upperBound + 1) * columns) }
+        }
+
+        var snap = GridSnapshot(
+            cells: [],
+            dirtyRange: dirtyRange,
+            damagedRanges: damagedRanges,
+            cursorRow: cursor.row,
+            cursorCol: echoOverlayCursorColumn ?? cursor.col,
+            cursorVisible: cursor.visible,
+            cursorStyle: cursor.style,
+            columns: columns,
+            rows: rows,
+            usingAlternateBuffer: usingAlternateBuffer,
+            graphemeOverrides: graphemeOverrides,
+            compactCells: buffer,
+            inlineImages: liveInlineImageQuads()
+        )
+        stampSequence(on: &snap, scroll: scroll, rewritten: rewritten)
+        let newState = SnapshotBufferState(
+            columns: columns,
+            rows: rows,
+            cursorRow: cursor.row,
+            flaggedRows: hasDirtyRange ? rewritten : DirtyRowSet(),
+            graphemeOverrides: graphemeOverrides,
+            scroll: scroll
+        )
+        if useSnapshotBufferA {
+            compactSnapshotBufferA = buffer
+            snapshotStateA = newState
+        } else {
+            compactSnapshotBufferB = buffer
+            snapshotStateB = newState
+        }
+
+        useSnapshotBufferA.toggle()
+
+        clearDirtyState()
+
+        lastSnapshot = snap
+        return snap
+    }
+
+    /// `pendingScroll`, if snapshots can replay it as a move.
+    nonisolated private var publishableScroll: GridScrollDelta? {
+        guard let pendingScroll, pendingScroll.movesRows,
+              pendingScroll.region.lowerBound >= 0, pendingScroll.region.upperBound < rows else { return nil }
+        return pendingScroll
+    }
+
+    /// Number `snapshot` as the next live snapshot and attach `scroll`,
+    /// relative to the previous one, with the rows it rewrote.
+    nonisolated private func stampSequence(on snapshot: inout GridSnapshot, scroll: GridScrollDelta?, rewritten: DirtyRowSet) {
+        let base = snapshotSequence
+        snapshotSequence &+= 1
+        snapshot.sequence = snapshotSequence
+        guard let scroll, base != 0 else { return }
+        snapshot.scroll = GridSnapshotScroll(
+            baseSequence: base,
+            delta: scroll,
+            rewrittenRanges: rewritten.runs(below: rows).map { ($0.lowerBound * columns)..<(($0.upperBound + 1) * columns) }
+        )
+    }
+
+    /// Grapheme overrides a buffer carries over: `overrides` moved with
+    /// their rows, minus moved-out rows and rows about to be rewritten.
+    nonisolated private func carriedGraphemeOverrides(
+        _ overrides: [Int: String]?,
+        moves: [GridScrollDelta],
+        skipping rewrittenRows: DirtyRowSet
+    ) -> [Int: String]? {
+        guard let overrides, columns > 0 else { return nil }
+        var carried: [Int: String] = [:]
+        for (index, grapheme) in overrides {
+            var row: Int? = index / columns
+            for move in moves {
+                row = row.flatMap { move.destination(ofRow: $0) }
+            }
+            guard let row, !rewrittenRows.contains(row) else { continue }
+            carried[row * columns + index % columns] = grapheme
+        }
+        return carried.isEmpty ? nil : carried
+    }
+
+    /// Switch live snapshots between `CellInstance`s and compact cells. Both
+    /// buffers are marked stale so the next snapshots are written in full.
+    nonisolated func setCompactSnapshots(_ enabled: Bool) {
+        guard compactSnapshots != enabled else { return }
+        compactSnapshots = enabled
+        invalidateSnapshotBuffers()
+        if enabled {
+            snapshotBufferA = []
+            snapshotBufferB = []
+        } else {
+            compactSnapshotBufferA = []
+            compactSnapshotBufferB = []
+        }
+    }
+
     /// Produce an immutable snapshot of the current grid state for the renderer.
     /// Clears dirty tracking after snapshot is taken.
     ///
@@ -151,6 +410,10 @@ extension TerminalGrid {
         guard scrollOffset > 0, scrollback.count > 0 else {
             return snapshot()
         }
+        // History scrolled into view must be at the current width.
+        if scrollback.count - scrollOffset < scrollback.deferredReflowLineCount {
+            settleDeferredReflow()
+        }
         #if DEBUG
         let signpostID = OSSignpostID(log: Self.perfSignpostLog)
         os_signpost(
@@ -177,7 +440,6 @@ extension TerminalGrid {
         // Clamp offset to available scrollback
         let clampedOffset = min(scrollOffset, scrollback.count)
         let totalCells = rows * columns
-        let wideContinuationBit = CellAttributes.wideContinuation.rawValue
 
         // Scrollback snapshots are less frequent (only during scroll-back viewing),
         // so we use a simple ContiguousArray without the double-buffer optimization.
@@ -185,6 +447,13 @@ extension TerminalGrid {
         cellInstances.reserveCapacity(totalCells)
         var graphemeOverrides: [Int: String]?
 
+        let firstVisibleLine = scrollback.firstLineID + scrollback.count - clampedOffset
+        scrollbackRowCache.validate(columns: columns, epoch: scrollback.rewriteEpoch)
+        scrollbackRowCache.trim(
+            keeping: (firstVisibleLine - rows)..<(firstVisibleLine + 2 * rows),
+            limit: 4 * rows
+        )
+
         for displayRow in 0..<rows {
             // Which logical row does this display row map to?
             // displayRow 0 is the topmost visible row.
@@ -192,96 +461,40 @@ extension TerminalGrid {
             let scrollbackIndex = scrollback.count - clampedOffset + displayRow
 
             if scrollbackIndex < scrollback.count {
-                // This row comes from scrollback
-                let scrollLine = scrollback[scrollbackIndex]
-                for col in 0..<columns {
-                    let codepoint: UInt32
-                    let fgPacked: UInt32
-                    let bgPacked: UInt32
-                    let attrs: UInt16
-
-                    let ulColorPacked: UInt32
-                    let ulStyle: UInt8
-
-                    if col < scrollLine.cells.count {
-                        let cell = scrollLine.cells[col]
-                        codepoint = cell.primaryCodepoint
-                        // boldIsBright was pre-applied at write-time
-                        fgPacked = cell.fgPackedRGBA
-                        bgPacked = cell.bgPackedRGBA
-                        var resolvedAttrs = cell.attributes.rawValue
-                        if cell.width == 0 {
-                            resolvedAttrs |= wideContinuationBit
-                        }
-                        attrs = resolvedAttrs
-                        ulColorPacked = cell.underlinePackedRGBA
-                        ulStyle = cell.underlineStyle.rawValue
-                        if let grapheme = scrollLine.graphemeOverrides?[col] {
-                            if graphemeOverrides == nil {
-                                graphemeOverrides = [:]
-                            }
-                            graphemeOverrides?[displayRow * columns + col] = grapheme
-                        }
-                    } else {
-                        codepoint = 0
-                        fgPacked = 0
-                        bgPacked = 0
-                        attrs = 0
-                        ulColorPacked = 0
-                        ulStyle = 0
-                    }
-
-                    cellInstances.append(CellInstance(
-                        row: UInt16(displayRow),
-                        col: UInt16(col),
-                        glyphIndex: codepoint,
-                        fgColor: fgPacked,
-                        bgColor: bgPacked,
-                        underlineColor: ulColorPacked,
-                        attributes: attrs,
-                        flags: CellInstance.flagDirty,
-                        underlineStyle: ulStyle
-                    ))
+                // This row comes from scrollback, encoded once per line
+                let lineID = scrollback.firstLineID + scrollbackIndex
+                let encoded: ScrollbackRowCache.Row
+                if let cached = scrollbackRowCache[lineID] {
+                    encoded = cached
+                } else {
+                    encoded = encodeScrollbackRow(scrollback[scrollbackIndex])
+                    scrollbackRowCache[lineID] = encoded
                 }
-            } else {
-                // This row comes from the live grid
-                let gridRow = scrollbackIndex - scrollback.count
-                let physicalRowIndex = physicalRow(gridRow, base: rowBase)
-                for col in 0..<columns {
-                    let cell = activeCells[physicalRowIndex][col]
-                    let isCursor = (gridRow == cursor.row && col == cursor.col && cursor.visible && clampedOffset == 0)
-
-                    var flags: UInt8 = CellInstance.flagDirty
-                    if isCursor { flags |= CellInstance.flagCursor }
-
-                    let codepoint = cell.primaryCodepoint
-
-                    // boldIsBright was pre-applied at write-time
-                    let fgPacked = cell.fgPackedRGBA
-                    var attributes = cell.attributes.rawValue
-                    if cell.width == 0 {
-                        attributes |= wideContinuationBit
+                let displayRowIndex = UInt16(displayRow)
+                for var instance in encoded.cells {
+                    instance.row = displayRowIndex
+                    cellInstances.append(instance)
+                }
+                if let graphemes = encoded.graphemes {
+                    if graphemeOverrides == nil {
+                        graphemeOverrides = [:]
                     }
-                    if (cell.codepoint & GraphemeSideTable.sentinel) != 0,
-                       let grapheme = graphemeSideTable.resolve(cell.codepoint) {
-                        if graphemeOverrides == nil {
-                            graphemeOverrides = [:]
-                        }
+                    for (col, grapheme) in graphemes {
                         graphemeOverrides?[displayRow * columns + col] = grapheme
                     }
-
-                    cellInstances.append(CellInstance(
-                        row: UInt16(displayRow),
-                        col: UInt16(col),
-                        glyphIndex: codepoint,
-                        fgColor: fgPacked,
-                        bgColor: cell.bgPackedRGBA,
-                        underlineColor: cell.underlinePackedRGBA,
-                        attributes: attributes,
-                        flags: flags,
-                        underlineStyle: cell.underlineStyle.rawValue
-                    ))
                 }
+            } else {
+                // This row comes from the live grid
+                appendLiveRow(
+                    scrollbackIndex - scrollback.count,
+                    from: activeCells,
+                    rowBase: rowBase,
+                    as: UInt16(displayRow),
+                    showingCursor: clampedOffset == 0,
+                    to: &cellInstances,
+                    graphemeOverrides: &graphemeOverrides,
+                    graphemeBase: displayRow * columns
+                )
             }
         }
 
@@ -295,46 +508,431 @@ extension TerminalGrid {
             columns: columns,
             rows: rows,
             usingAlternateBuffer: usingAlternateBuffer,
-            graphemeOverrides: graphemeOverrides
+            graphemeOverrides: graphemeOverrides,
+            inlineImages: visibleInlineImageQuads(firstVisibleLine: firstVisibleLine)
         )
     }
 
+    /// Encode live grid row `gridRow` as display row `row`, appending its
+    /// grapheme clusters to `graphemeOverrides` at `graphemeBase + col`.
+    nonisolated private func appendLiveRow(
+        _ gridRow: Int,
+        from activeCells: CellArena,
+        rowBase: Int,
+        as row: UInt16,
+        showingCursor: Bool,
+        to cellInstances: inout ContiguousArray<CellInstance>,
+        graphemeOverrides: inout [Int: String]?,
+        graphemeBase: Int
+    ) {
+        let wideContinuationBit = CellAttributes.wideContinuation.rawValue
+        let rowCells = activeCells[physicalRow(gridRow, base: rowBase)]
+        for col in 0..<columns {
+            let cell = rowCells[col]
+            let isCursor = (showingCursor && gridRow == cursor.row && col == cursor.col && cursor.visible)
+
+            var flags: UInt8 = CellInstance.flagDirty
+            if isCursor { flags |= CellInstance.flagCursor }
+
+            let codepoint = cell.primaryCodepoint
+
+            // boldIsBright was pre-applied at write-time
+            let fgPacked = cell.fgPackedRGBA
+            var attributes = cell.attributes.rawValue
+            if cell.width == 0 {
+                attributes |= wideContinuationBit
+            }
+            if (cell.codepoint & GraphemeSideTable.sentinel) != 0,
+               let grapheme = graphemeSideTable.resolve(cell.codepoint) {
+                if graphemeOverrides == nil {
+                    graphemeOverrides = [:]
+                }
+                graphemeOverrides?[graphemeBase + col] = grapheme
+            }
+
+            cellInstances.append(CellInstance(
+                row: row,
+                col: UInt16(col),
+                glyphIndex: codepoint,
+                fgColor: fgPacked,
+                bgColor: cell.bgPackedRGBA,
+                underlineColor: cell.underlinePackedRGBA,
+                attributes: attributes,
+                flags: flags,
+                underlineStyle: cell.underlineStyle.rawValue
+            ))
+        }
+    }
+
+    /// Rows at `positions` for the renderer's scrollback row ring (see
+    /// ScrollbackRingRows). Positions before the oldest kept line or past
+    /// the bottom grid row are skipped. Scrollback rows come from the row
+    /// cache when present but are not added to it: the ring holds them on
+    /// the GPU and the cache stays sized for the viewport snapshot. Live
+    /// rows never carry the cursor, and grapheme clusters draw as their
+    /// first scalar.
+    nonisolated func scrollbackRingRows(positions: Range<Int>) -> ScrollbackRingRows {
+        let firstLineID = scrollback.firstLineID
+        let liveTop = firstLineID + scrollback.count
+        let available = positions.clamped(to: firstLineID..<(liveTop + rows))
+        guard !usingAlternateBuffer, !available.isEmpty else {
+            return ScrollbackRingRows(columns: columns, firstPosition: firstLineID, liveTop: liveTop, rows: [])
+        }
+        if available.lowerBound < liveTop,
+           available.lowerBound - firstLineID < scrollback.deferredReflowLineCount {
+            settleDeferredReflow()
+        }
+        scrollbackRowCache.validate(columns: columns, epoch: scrollback.rewriteEpoch)
+
+        let activeCells = primaryCells
+        let rowBase = activeRowBase
+        var discardedGraphemes: [Int: String]?
+        var result: [ScrollbackRingRows.Row] = []
+        result.reserveCapacity(available.count)
+        for position in available {
+            let ringRow = UInt16(truncatingIfNeeded: position)
+            var cells: ContiguousArray<CellInstance>
+            if position < liveTop {
+                cells = (scrollbackRowCache[position] ?? encodeScrollbackRow(scrollback[position - firstLineID])).cells
+                for index in cells.indices {
+                    cells[index].row = ringRow
+                }
+            } else {
+                cells = ContiguousArray()
+                cells.reserveCapacity(columns)
+                appendLiveRow(
+                    position - liveTop,
+                    from: activeCells,
+                    rowBase: rowBase,
+                    as: ringRow,
+                    showingCursor: false,
+                    to: &cells,
+                    graphemeOverrides: &discardedGraphemes,
+                    graphemeBase: 0
+                )
+            }
+            result.append(ScrollbackRingRows.Row(position: position, cells: cells))
+        }
+        return ScrollbackRingRows(columns: columns, firstPosition: firstLineID, liveTop: liveTop, rows: result)
+    }
+
+    /// Encode one scrollback line at the current width for the row cache.
+    nonisolated private func encodeScrollbackRow(_ scrollLine: ScrollbackLine) -> ScrollbackRowCache.Row {
+        let wideContinuationBit = CellAttributes.wideContinuation.rawValue
+        let styledRow = scrollLine.row
+        let lineEnd = min(styledRow.count, columns)
+        var cells = ContiguousArray<CellInstance>()
+        cells.reserveCapacity(columns)
+        var graphemes: [Int: String]?
+
+        // Walk the line's style spans; codepoints come from the
+        // separate stream, so no TerminalCell is materialized.
+        styledRow.forEachSpan { span, range in
+            guard range.lowerBound < lineEnd else { return }
+            let baseAttrs = span.attributes.rawValue
+            for col in range.lowerBound..<min(range.upperBound, lineEnd) {
+                let rawCodepoint = styledRow.codepoints[col]
+                var resolvedAttrs = baseAttrs
+                if styledRow.width(at: col) == 0 {
+                    resolvedAttrs |= wideContinuationBit
+                }
+                if let grapheme = scrollLine.graphemeOverrides?[col] {
+                    if graphemes == nil {
+                        graphemes = [:]
+                    }
+                    graphemes?[col] = grapheme
+                }
+                cells.append(CellInstance(
+                    row: 0,
+                    col: UInt16(col),
+                    glyphIndex: rawCodepoint & GraphemeSideTable.sentinel != 0 ? 0 : rawCodepoint,
+                    // boldIsBright was pre-applied at write-time
+                    fgColor: span.fgPackedRGBA,
+                    bgColor: span.bgPackedRGBA,
+                    underlineColor: span.underlinePackedRGBA,
+                    attributes: resolvedAttrs,
+                    flags: CellInstance.flagDirty,
+                    underlineStyle: span.underlineStyle.rawValue
+                ))
+            }
+        }
+        for col in lineEnd..<columns {
+            cells.append(CellInstance(
+                row: 0,
+                col: UInt16(col),
+                glyphIndex: 0,
+                fgColor: 0,
+                bgColor: 0,
+                underlineColor: 0,
+                attributes: 0,
+                flags: CellInstance.flagDirty,
+                underlineStyle: 0
+            ))
+        }
+        return ScrollbackRowCache.Row(cells: cells, graphemes: graphemes)
+    }
+
     /// The number of scrollback lines available.
     nonisolated var scrollbackCount: Int {
         scrollback.count
     }
 
+    /// Approximate memory held by the scrollback, in bytes.
+    nonisolated var scrollbackMemoryBytes: Int {
+        scrollback.estimatedMemoryBytes
+    }
+
+    /// Approximate memory held by the screen buffers, scrollback, grapheme
+    /// side table and snapshot double buffers. Published snapshots may
+    /// still share storage with the double buffers.
+    nonisolated var memoryFootprint: MemoryFootprint {
+        var footprint = MemoryFootprint()
+        footprint[.grid] = (primaryCells.count + alternateCells.count) * columns * MemoryLayout<TerminalCell>.stride
+            + (primaryRowMap.count + alternateRowMap.count) * MemoryLayout<Int>.stride
+        footprint[.scrollback] = scrollback.estimatedMemoryBytes + commandOutputFolds.estimatedMemoryBytes
+        footprint[.graphemes] = graphemeSideTable.estimatedByteCount
+        footprint[.snapshots] = (snapshotBufferA.capacity + snapshotBufferB.capacity) * MemoryLayout<CellInstance>.stride
+            + (compactSnapshotBufferA.capacity + compactSnapshotBufferB.capacity) * MemoryLayout<TerminalCell>.stride
+        return footprint
+    }
+
+    /// Drop the oldest scrollback until at most `lines` remain, and the
+    /// decoded-row cache with it. Used to give memory back under pressure.
+    nonisolated func trimScrollback(toLines lines: Int) {
+        settleDeferredReflow()
+        scrollback.trim(toLines: lines)
+        scrollbackRowCache.removeAll()
+        semanticZones.dropLines(before: scrollback.firstLineID)
+    }
+
+    /// Release what only drawing needs while no pane shows the grid:
+    /// the snapshot double buffers, decoded scrollback rows and the
+    /// visible-text cache. Scrollback is compacted as well. Screen cells
+    /// stay, so the parser keeps writing to them as usual. The next
+    /// snapshot re-encodes every row into fresh buffers.
+    nonisolated func hibernate() {
+        invalidateSnapshotBuffers()
+        snapshotBufferA = []
+        snapshotBufferB = []
+        compactSnapshotBufferA = []
+        compactSnapshotBufferB = []
+        scrollbackRowCache.removeAll()
+        scrollback.compact()
+    }
+
     // MARK: - A.6.15 Text Extraction
 
     /// Extract visible rows as an array of strings (trailing whitespace trimmed).
     /// Used by the text-based fallback view, password detection, and search.
+    /// Served from the row text cache; only rows dirtied since are re-read.
     nonisolated func visibleText() -> [String] {
+        refreshVisibleTextCache()
+        return visibleTextCache
+    }
+
+    /// The visible text with the rows whose text changed after `version`,
+    /// a `VisibleTextChanges.version` from an earlier call (0 for none).
+    /// Any number of callers can track their own version.
+    nonisolated func visibleTextChanges(since version: UInt64) -> VisibleTextChanges {
+        refreshVisibleTextCache()
+        let isComplete = version < textLayoutVersion
+        let changedRows = isComplete
+            ? Array(0..<visibleTextCache.count)
+            : rowTextVersions.indices.filter { rowTextVersions[$0] > version }
+        return VisibleTextChanges(
+            version: textVersion,
+            lines: visibleTextCache,
+            changedRows: changedRows,
+            isComplete: isComplete
+        )
+    }
+
+    /// Re-read rows dirtied since the last refresh, or every row after a
+    /// resize or buffer switch. Rows whose text comes out the same keep
+    /// their version.
+    private nonisolated func refreshVisibleTextCache() {
         let activeCells = usingAlternateBuffer ? alternateCells : primaryCells
         let rowBase = activeRowBase
+        guard visibleTextCache.count == rows, visibleTextCacheIsAlternate == usingAlternateBuffer else {
+            textVersion &+= 1
+            var lines = [String]()
+            lines.reserveCapacity(rows)
+            for row in 0..<rows {
+                lines.append(rowText(activeCells[physicalRow(row, base: rowBase)]))
+            }
+            visibleTextCache = lines
+            visibleTextCacheIsAlternate = usingAlternateBuffer
+            rowTextVersions = Array(repeating: textVersion, count: rows)
+            textLayoutVersion = textVersion
+            textDirtyRows.removeAll()
+            return
+        }
+        guard !textDirtyRows.isEmpty else { return }
+
+        textVersion &+= 1
+        for run in textDirtyRows.runs(below: rows) {
+            for row in run {
+                let text = rowText(activeCells[physicalRow(row, base: rowBase)])
+                if text != visibleTextCache[row] {
+                    visibleTextCache[row] = text
+                    rowTextVersions[row] = textVersion
+                }
+            }
+        }
+        textDirtyRows.removeAll()
+    }
 
-        var lines = [String]()
-        lines.reserveCapacity(rows)
+    /// Scrollback and the primary screen as a TerminalTextExport.
+    nonisolated func textExport() -> TerminalTextExport {
+        var screenRows: [TerminalTextExport.ScreenRow] = []
+        screenRows.reserveCapacity(rows)
         for row in 0..<rows {
-            let physicalRowIndex = physicalRow(row, base: rowBase)
-            var line = ""
-            for col in 0..<columns {
-                let cell = activeCells[physicalRowIndex][col]
-                if cell.width == 0 { continue } // skip wide-char continuation
-                let grapheme = resolveGrapheme(for: cell)
-                if grapheme.isEmpty {
-                    line.append(" ")
+            let rowCells = primaryCells[physicalRow(row, base: primaryRowBase, map: primaryRowMap)]
+            screenRows.append(TerminalTextExport.ScreenRow(
+                text: rowText(rowCells),
+                isWrapped: rowCells.last?.attributes.contains(.wrapped) ?? false
+            ))
+        }
+        return TerminalTextExport(scrollback: scrollback, screenRows: screenRows, folds: commandOutputFolds)
+    }
+
+    /// Text of one screen row, trailing whitespace trimmed.
+    private nonisolated func rowText(_ rowCells: CellRow) -> String {
+        var line = ""
+        for col in 0..<columns {
+            let cell = rowCells[col]
+            if cell.width == 0 { continue } // skip wide-char continuation
+            let grapheme = resolveGrapheme(for: cell)
+            if grapheme.isEmpty {
+                line.append(" ")
+            } else {
+                line.append(grapheme)
+            }
+        }
+        // Trim trailing spaces with a single pass.
+        if let lastNonSpace = line.lastIndex(where: { $0 != " " }) {
+            return String(line[...lastNonSpace])
+        }
+        return ""
+    }
+
+    // MARK: - Semantic Prompt Output
+
+    /// Record the cursor line of an OSC 133 marker: where command output
+    /// starts, and the prompt and output zones used for navigation.
+    nonisolated func noteSemanticPrompt(_ event: SemanticPromptEvent) {
+        guard !usingAlternateBuffer else {
+            if case .commandStart = event { semanticOutputStart = nil }
+            return
+        }
+        let line = scrollback.firstLineID + scrollback.count + cursor.row
+        let epoch = scrollback.rewriteEpoch
+        semanticZones.dropLines(before: scrollback.firstLineID)
+        switch event {
+        case .promptStart:
+            semanticZones.notePrompt(line: line, epoch: epoch)
+        case .promptEnd:
+            break
+        case .commandStart:
+            semanticOutputStart = (line, epoch)
+            semanticZones.noteOutputStart(line: line, epoch: epoch)
+        case .commandEnd:
+            // Output that ends without a newline leaves the cursor on its
+            // last line.
+            semanticZones.noteOutputEnd(line: cursor.col > 0 ? line + 1 : line, epoch: epoch)
+        }
+    }
+
+    /// The scroll offset that puts the prompt before (`direction` < 0) or
+    /// after the viewport's top line at the top. Scrolling past the last
+    /// prompt returns to the bottom. Nil when there is no such prompt.
+    nonisolated func promptScrollOffset(from scrollOffset: Int, direction: Int) -> Int? {
+        guard !usingAlternateBuffer, semanticZones.epoch == scrollback.rewriteEpoch else { return nil }
+        semanticZones.dropLines(before: scrollback.firstLineID)
+        let screenStart = scrollback.firstLineID + scrollback.count
+        let top = screenStart - scrollOffset
+        if direction < 0 {
+            guard let prompt = semanticZones.previousPrompt(before: top) else { return nil }
+            return min(screenStart - prompt, scrollback.count)
+        }
+        guard scrollOffset > 0 else { return nil }
+        guard let prompt = semanticZones.nextPrompt(after: top) else { return 0 }
+        return max(screenStart - prompt, 0)
+    }
+
+    /// The newest finished command output: its text (at most about
+    /// `maxCharacters` from the end) and the scroll offset that brings its
+    /// first line to the top.
+    nonisolated func lastCommandOutput(maxCharacters: Int) -> (text: String, scrollOffset: Int)? {
+        guard !usingAlternateBuffer, semanticZones.epoch == scrollback.rewriteEpoch else { return nil }
+        semanticZones.dropLines(before: scrollback.firstLineID)
+        guard let output = semanticZones.lastCompletedOutput, !output.isEmpty,
+              let text = text(fromLine: output.lowerBound, through: output.upperBound - 1, maxCharacters: maxCharacters)
+        else { return nil }
+        let screenStart = scrollback.firstLineID + scrollback.count
+        return (text, max(0, min(screenStart - output.lowerBound, scrollback.count)))
+    }
+
+    /// Lines from the OSC 133;C mark through the cursor row, read from
+    /// scrollback and the primary screen, at most about `maxCharacters`
+    /// from the end. Clears the mark. Nil without a mark, or when its lines
+    /// were evicted or rewritten since.
+    nonisolated func takeSemanticCommandOutput(maxCharacters: Int) -> String? {
+        guard let start = semanticOutputStart else { return nil }
+        semanticOutputStart = nil
+        guard !usingAlternateBuffer,
+              start.epoch == scrollback.rewriteEpoch,
+              start.line >= scrollback.firstLineID else { return nil }
+
+        return text(
+            fromLine: start.line,
+            through: scrollback.firstLineID + scrollback.count + cursor.row,
+            maxCharacters: maxCharacters
+        )
+    }
+
+    /// Lines `start...end` of scrollback and the primary screen, at most
+    /// about `maxCharacters` from the end, blank lines at either end
+    /// trimmed. A folded output's summary row reads as its folded lines.
+    /// Nil when `start` is no longer in the buffer.
+    private nonisolated func text(fromLine start: Int, through end: Int, maxCharacters: Int) -> String? {
+        guard start >= scrollback.firstLineID, start <= end else { return nil }
+        let screenStart = scrollback.firstLineID + scrollback.count
+        let last = min(end, screenStart + rows - 1)
+
+        var lines: [String] = []
+        var characterCount = 0
+        var decoded = ScrollbackLineText()
+        func scrollbackText(_ line: ScrollbackLine) -> String {
+            decoded.load(line, folding: false)
+            var scalars = String.UnicodeScalarView()
+            scalars.append(contentsOf: decoded.scalars.compactMap(Unicode.Scalar.init))
+            let string = String(scalars)
+            return string.lastIndex { $0 != " " }.map { String(string[...$0]) } ?? ""
+        }
+        func appendLine(_ lineText: String) -> Bool {
+            lines.append(lineText)
+            characterCount += lineText.count + 1
+            return characterCount < maxCharacters
+        }
+
+        lineLoop: for line in stride(from: last, through: start, by: -1) {
+            if line >= screenStart {
+                guard appendLine(rowText(primaryCells[physicalRow(line - screenStart, base: primaryRowBase)])) else { break }
+            } else if let scrollbackLine = scrollback.line(at: line - scrollback.firstLineID) {
+                if !commandOutputFolds.isEmpty, let fold = commandOutputFolds.fold(summarizedBy: scrollbackLine) {
+                    for index in stride(from: fold.lineCount - 1, through: 0, by: -1) {
+                        guard let foldedLine = fold.lines.line(at: index) else { continue }
+                        guard appendLine(scrollbackText(foldedLine)) else { break lineLoop }
+                    }
                 } else {
-                    line.append(grapheme)
+                    guard appendLine(scrollbackText(scrollbackLine)) else { break }
                 }
-            }
-            // Trim trailing spaces with a single pass.
-            if let lastNonSpace = line.lastIndex(where: { $0 != " " }) {
-                lines.append(String(line[...lastNonSpace]))
             } else {
-                lines.append("")
+                break
             }
         }
-        return lines
+        return lines.reversed().joined(separator: "\n").trimmingCharacters(in: .whitespacesAndNewlines)
     }
 
 }
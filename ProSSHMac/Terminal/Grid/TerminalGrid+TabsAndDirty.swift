@@ -52,30 +52,65 @@ extension TerminalGrid {
     /// Mark a specific row as dirty.
     nonisolated func markDirty(row: Int) {
         hasDirtyCells = true
-        dirtyRowMin = min(dirtyRowMin, row)
-        dirtyRowMax = max(dirtyRowMax, row)
+        dirtyRows.insert(row)
+        rewrittenRows.insert(row)
+        textDirtyRows.insert(row)
     }
 
     /// Mark a contiguous row range as dirty.
     nonisolated func markDirty(rows range: ClosedRange<Int>) {
         guard !range.isEmpty else { return }
         hasDirtyCells = true
-        dirtyRowMin = min(dirtyRowMin, range.lowerBound)
-        dirtyRowMax = max(dirtyRowMax, range.upperBound)
+        dirtyRows.insert(range)
+        rewrittenRows.insert(range)
+        textDirtyRows.insert(range)
+    }
+
+    /// Mark the rows of `region` dirty after scrolling them up by `lines`
+    /// (down when negative). The move is recorded in `pendingScroll` so
+    /// snapshots move rows instead of re-encoding them; a scroll of a
+    /// different region than the pending one just rewrites its rows.
+    nonisolated func markScrolled(region: ClosedRange<Int>, lines: Int) {
+        guard lines != 0 else { return }
+        hasDirtyCells = true
+        dirtyRows.insert(region)
+        textDirtyRows.insert(region)
+        let move = GridScrollDelta(region: region, lines: lines)
+        if let pending = pendingScroll {
+            guard let combined = pending.followed(by: move) else {
+                rewrittenRows.insert(region)
+                return
+            }
+            pendingScroll = combined
+        } else {
+            pendingScroll = move
+        }
+        rewrittenRows = move.moving(rewrittenRows)
+        rewrittenRows.insert(move.exposedRows)
     }
 
     /// Mark all rows as dirty (used after buffer switch, full reset, resize).
     nonisolated func markAllDirty() {
         hasDirtyCells = true
-        dirtyRowMin = 0
-        dirtyRowMax = rows - 1
+        dirtyRows.insert(0...(rows - 1))
+        textDirtyRows.insert(0...(rows - 1))
+        pendingScroll = nil
+        rewrittenRows = dirtyRows
     }
 
     /// Clear the dirty state after producing a snapshot.
     nonisolated func clearDirtyState() {
         hasDirtyCells = false
-        dirtyRowMin = Int.max
-        dirtyRowMax = -1
+        dirtyRows.removeAll()
+        rewrittenRows.removeAll()
+        pendingScroll = nil
+    }
+
+    /// Force the next snapshots to re-encode every row.
+    nonisolated func invalidateSnapshotBuffers() {
+        snapshotStateA = SnapshotBufferState()
+        snapshotStateB = SnapshotBufferState()
+        visibleTextCache.removeAll()
     }
 
 }
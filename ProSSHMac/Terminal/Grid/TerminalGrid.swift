@@ -38,14 +38,14 @@ nonisolated final class TerminalGrid: @unchecked Sendable {
     // MARK: - Screen Buffers
 
     /// Primary screen buffer (normal shell output).
-    var primaryCells: [[TerminalCell]]
+    var primaryCells: CellArena
     /// Ring-buffer base offset for primaryCells (logical row 0 -> physical row base).
     var primaryRowBase: Int = 0
     /// Logical-to-physical row indirection for primary buffer.
     var primaryRowMap: [Int]
 
     /// Alternate screen buffer (for full-screen TUI apps: htop, vim, etc.).
-    var alternateCells: [[TerminalCell]]
+    var alternateCells: CellArena
     /// Ring-buffer base offset for alternateCells.
     var alternateRowBase: Int = 0
     /// Logical-to-physical row indirection for alternate buffer.
@@ -101,6 +101,9 @@ nonisolated final class TerminalGrid: @unchecked Sendable {
     var mouseEncoding: MouseEncoding = .x10
     var focusReporting: Bool = false
     var lineFeedMode: Bool = false            // LNM — LF acts as CR+LF
+    /// Set by TerminalEngine per chunk while output floods in; enables the
+    /// off-grid text layout in TerminalGrid+Flood.swift.
+    var floodMode: Bool = false
 
     // MARK: - Character Set State
 
@@ -166,6 +169,9 @@ nonisolated final class TerminalGrid: @unchecked Sendable {
     /// If an index is not in this dictionary, the default from ColorPalette is used.
     var customPalette: [UInt8: (UInt8, UInt8, UInt8)] = [:]
 
+    /// Packed RGBA for every palette index, `customPalette` applied.
+    var packedPalette = PackedPalette()
+
     /// The cursor color set by OSC 12 (nil = use default).
     var cursorColor: (UInt8, UInt8, UInt8)?
 
@@ -191,28 +197,82 @@ nonisolated final class TerminalGrid: @unchecked Sendable {
     var currentBgPacked: UInt32 = 0
     /// Pre-computed packed RGBA for currentUnderlineColor, updated on color mutation.
     var currentUnderlinePacked: UInt32 = 0
+    /// Foreground packed for bold text with boldIsBright applied; used only
+    /// while `TerminalDefaults.boldIsBright` is on.
+    var currentFgBoldPacked: UInt32 = 0
 
     /// Recompute cached packed RGBA values from the current colors.
     /// Must be called after any mutation of currentFgColor/currentBgColor/currentUnderlineColor.
     @inline(__always)
     func invalidatePackedColors() {
-        currentFgPacked = currentFgColor.packedRGBA()
-        currentBgPacked = currentBgColor.packedRGBA()
-        currentUnderlinePacked = currentUnderlineColor.packedRGBA()
+        currentFgPacked = packedPalette.packed(currentFgColor)
+        currentFgBoldPacked = packedPalette.packedBold(currentFgColor)
+        currentBgPacked = packedPalette.packed(currentBgColor)
+        currentUnderlinePacked = packedPalette.packed(currentUnderlineColor)
     }
 
     // MARK: - Dirty Tracking
 
-    /// Range of rows that have been modified since last snapshot.
-    var dirtyRowMin: Int = Int.max
-    var dirtyRowMax: Int = -1
+    /// Rows that have been modified since last snapshot.
+    var dirtyRows = DirtyRowSet()
+
+    /// Bounds of `dirtyRows` (Int.max / -1 when clean).
+    var dirtyRowMin: Int { dirtyRows.lowerBound }
+    var dirtyRowMax: Int { dirtyRows.upperBound }
 
     /// Whether any cell has changed since the last snapshot.
     var hasDirtyCells: Bool = false
 
+    /// Scrolling since the last snapshot, as a move snapshots can replay
+    /// (see GridScrollDelta). Nil when nothing scrolled, or after a full
+    /// invalidation.
+    var pendingScroll: GridScrollDelta?
+
+    /// The dirty rows that `pendingScroll`'s move does not account for:
+    /// rows it exposed and rows written since. Equals `dirtyRows` while
+    /// `pendingScroll` is nil.
+    var rewrittenRows = DirtyRowSet()
+
+    /// `GridSnapshot.sequence` of the last live snapshot.
+    var snapshotSequence: UInt64 = 0
+
+    /// Rows modified since `visibleTextCache` was last refreshed. Tracked
+    /// apart from `dirtyRows`, which every snapshot clears.
+    var textDirtyRows = DirtyRowSet()
+
+    /// Visible row text as of the last refresh; empty when it has to be
+    /// rebuilt.
+    var visibleTextCache: [String] = []
+    var visibleTextCacheIsAlternate = false
+
+    /// Bumped by every refresh that re-read a row. `rowTextVersions[row]`
+    /// is the version at which that row's text last changed, and
+    /// `textLayoutVersion` the version of the last full rebuild (resize,
+    /// buffer switch), before which row indexes meant different rows.
+    var textVersion: UInt64 = 0
+    var rowTextVersions: [UInt64] = []
+    var textLayoutVersion: UInt64 = 0
+
+    /// Line where the running command's output starts, recorded at
+    /// OSC 133;C with the scrollback `rewriteEpoch` it belongs to. Lines are
+    /// numbered as scrollback line IDs continued down the screen.
+    var semanticOutputStart: (line: Int, epoch: Int)?
+
+    /// OSC 133 prompt and output positions, in the same numbering.
+    var semanticZones = SemanticZoneIndex()
+
+    /// Command output folded out of scrollback (see TerminalGrid+CommandFolding).
+    var commandOutputFolds = CommandOutputFoldStore()
+
     /// Cached snapshot returned during synchronized output (mode 2026).
     var lastSnapshot: GridSnapshot?
 
+    /// Tentative local echo drawn over live snapshots (see TerminalGrid+PredictiveEcho).
+    var predictiveEcho = PredictiveEchoState()
+
+    /// Sixel, iTerm2 and kitty image placements (see TerminalGrid+InlineImages).
+    var inlineImages = InlineImageState()
+
     // MARK: - Pre-allocated Snapshot Buffers
 
     /// Double-buffered CellInstance storage for snapshot generation.
@@ -223,22 +283,38 @@ nonisolated final class TerminalGrid: @unchecked Sendable {
     var snapshotBufferA = ContiguousArray<CellInstance>()
     var snapshotBufferB = ContiguousArray<CellInstance>()
     var useSnapshotBufferA = true
+    /// What each buffer last encoded, so rows unchanged since then are
+    /// carried over instead of re-encoded.
+    var snapshotStateA = SnapshotBufferState()
+    var snapshotStateB = SnapshotBufferState()
+
+    /// When true, live snapshots carry the grid's `TerminalCell`s as-is
+    /// (`GridSnapshot.compactCells`) and the renderer expands them on the
+    /// GPU. Scrollback snapshots are always expanded here.
+    var compactSnapshots = false
+    /// Double-buffered storage for compact snapshots, managed like
+    /// `snapshotBufferA` / `snapshotBufferB`.
+    var compactSnapshotBufferA = ContiguousArray<TerminalCell>()
+    var compactSnapshotBufferB = ContiguousArray<TerminalCell>()
+
+    /// Encoded scrollback rows reused across `snapshot(scrollOffset:)` calls.
+    var scrollbackRowCache = ScrollbackRowCache()
 
     // MARK: - Initialization
 
     init(columns: Int = TerminalDefaults.columns,
          rows: Int = TerminalDefaults.rows,
-         maxScrollbackLines: Int = TerminalDefaults.maxScrollbackLines) {
+         maxScrollbackLines: Int = TerminalDefaults.maxScrollbackLines,
+         indexesScrollback: Bool = false) {
         self.columns = columns
         self.rows = rows
         self.maxScrollbackLines = maxScrollbackLines
         self.scrollBottom = rows - 1
         self.tabStopMask = TerminalDefaults.defaultTabStopMask(columns: columns)
-        self.scrollback = ScrollbackBuffer(maxLines: maxScrollbackLines)
+        self.scrollback = ScrollbackBuffer(maxLines: maxScrollbackLines, indexesText: indexesScrollback)
 
-        let blankRow = [TerminalCell](repeating: .blank, count: columns)
-        self.primaryCells = [[TerminalCell]](repeating: blankRow, count: rows)
-        self.alternateCells = [[TerminalCell]](repeating: blankRow, count: rows)
+        self.primaryCells = CellArena(rows: rows, columns: columns)
+        self.alternateCells = CellArena(rows: rows, columns: columns)
         self.primaryRowMap = Array(0..<rows)
         self.alternateRowMap = Array(0..<rows)
     }
@@ -246,7 +322,7 @@ nonisolated final class TerminalGrid: @unchecked Sendable {
     // MARK: - Active Buffer Access
 
     /// The currently active cell buffer.
-    var cells: [[TerminalCell]] {
+    var cells: CellArena {
         get { usingAlternateBuffer ? alternateCells : primaryCells }
         set {
             if usingAlternateBuffer {
@@ -270,7 +346,7 @@ nonisolated final class TerminalGrid: @unchecked Sendable {
     }
 
     /// Mutate the active buffer and its ring base together.
-    func withActiveBuffer(_ body: (inout [[TerminalCell]], inout Int) -> Void) {
+    func withActiveBuffer(_ body: (inout CellArena, inout Int) -> Void) {
         if usingAlternateBuffer {
             body(&alternateCells, &alternateRowBase)
         } else {
@@ -279,7 +355,7 @@ nonisolated final class TerminalGrid: @unchecked Sendable {
     }
 
     /// Mutate the active buffer, ring base, and logical row map together.
-    func withActiveBufferState(_ body: (inout [[TerminalCell]], inout Int, inout [Int]) -> Void) {
+    func withActiveBufferState(_ body: (inout CellArena, inout Int, inout [Int]) -> Void) {
         if usingAlternateBuffer {
             body(&alternateCells, &alternateRowBase, &alternateRowMap)
         } else {
@@ -320,18 +396,12 @@ nonisolated final class TerminalGrid: @unchecked Sendable {
     }
 
     /// Return a logically ordered copy of a ring-backed screen buffer.
-    func linearizedRows(_ buffer: [[TerminalCell]], base: Int, map: [Int]) -> [[TerminalCell]] {
-        guard rows > 0 else { return buffer }
-        let isIdentityMap = map.count == rows && map.enumerated().allSatisfy { index, value in
-            index == value
-        }
-        if base == 0 && isIdentityMap {
-            return buffer
-        }
+    func linearizedRows(_ buffer: CellArena, base: Int, map: [Int]) -> [[TerminalCell]] {
+        guard rows > 0 else { return buffer.rowArrays }
         var ordered = [[TerminalCell]]()
         ordered.reserveCapacity(rows)
         for logicalRow in 0..<rows {
-            ordered.append(buffer[physicalRow(logicalRow, base: base, map: map)])
+            ordered.append(Array(buffer[physicalRow(logicalRow, base: base, map: map)]))
         }
         return ordered
     }
@@ -401,30 +471,20 @@ nonisolated final class TerminalGrid: @unchecked Sendable {
     /// to ensure no stale side-table indices survive.
     func resolveAllSideTableEntries() {
         guard graphemeSideTable.activeCount > 0 else { return }
-        for physical in 0..<primaryCells.count {
-            for col in 0..<primaryCells[physical].count {
-                let cp = primaryCells[physical][col].codepoint
+        let resolve = { (cells: UnsafeMutableBufferPointer<TerminalCell>) in
+            for index in cells.indices {
+                let cp = cells[index].codepoint
                 if GraphemeSideTable.isSideTable(cp) {
-                    if let str = graphemeSideTable.resolve(cp) {
-                        primaryCells[physical][col].codepoint = TerminalCell.extractPrimaryCodepoint(from: str)
+                    if let str = self.graphemeSideTable.resolve(cp) {
+                        cells[index].codepoint = TerminalCell.extractPrimaryCodepoint(from: str)
                     } else {
-                        primaryCells[physical][col].codepoint = 0
-                    }
-                }
-            }
-        }
-        for physical in 0..<alternateCells.count {
-            for col in 0..<alternateCells[physical].count {
-                let cp = alternateCells[physical][col].codepoint
-                if GraphemeSideTable.isSideTable(cp) {
-                    if let str = graphemeSideTable.resolve(cp) {
-                        alternateCells[physical][col].codepoint = TerminalCell.extractPrimaryCodepoint(from: str)
-                    } else {
-                        alternateCells[physical][col].codepoint = 0
+                        cells[index].codepoint = 0
                     }
                 }
             }
         }
+        primaryCells.withUnsafeMutableCells(resolve)
+        alternateCells.withUnsafeMutableCells(resolve)
         graphemeSideTable.clear()
     }
 
@@ -437,10 +497,14 @@ nonisolated final class TerminalGrid: @unchecked Sendable {
 
     // MARK: - Helpers
 
+    /// A blank cell with the current background color.
+    func makeBlankCell() -> TerminalCell {
+        TerminalCell.erased(bgColor: currentBgColor, bgPacked: currentBgPacked)
+    }
+
     /// Create a blank row with the current background color.
     func makeBlankRow() -> [TerminalCell] {
-        let cell = TerminalCell.erased(bgColor: currentBgColor, bgPacked: currentBgPacked)
-        return [TerminalCell](repeating: cell, count: columns)
+        [TerminalCell](repeating: makeBlankCell(), count: columns)
     }
 }
 
@@ -0,0 +1,129 @@
+// TerminalTextExport.swift
+// ProSSHV2
+//
+// Plain-text copy of a session's whole history: scrollback followed by the
+// primary screen. The selection extractor works from a GridSnapshot, which
+// only covers the viewport; copying 100k lines that way would build every
+// string on the main actor.
+//
+// An export holds a copy of the ScrollbackBuffer. That copy is cheap,
+// because sealed pages are immutable and shared. UTF-8 is written page by
+// page into fixed-size chunks only when `write` runs, which for the
+// clipboard is when the text is pasted. Wrapped rows are joined into their
+// logical line, and trailing blanks are trimmed at line ends. The summary
+// row of a folded command output is written as the folded lines it stands
+// for (see CommandOutputFoldStore).
+
+import Foundation
+
+nonisolated struct TerminalTextExport: Sendable {
+
+    /// A screen row: its text and whether it continues on the next row.
+    nonisolated struct ScreenRow: Sendable {
+        let text: String
+        let isWrapped: Bool
+    }
+
+    /// Bytes handed to the sink at a time.
+    static let chunkSize = 1 << 16
+
+    let scrollback: ScrollbackBuffer
+    let screenRows: [ScreenRow]
+    /// Folded output, written in place of its summary rows.
+    var folds = CommandOutputFoldStore()
+
+    /// Rows covered, counting wrapped rows separately.
+    var rowCount: Int { scrollback.count + screenRows.count }
+
+    /// Write the export as UTF-8, in chunks of about `chunkSize` bytes.
+    func write(_ sink: (Data) -> Void) {
+        var buffer: [UInt8] = []
+        buffer.reserveCapacity(Self.chunkSize + 1024)
+        // Blank cells at the end of the current row, written only if more
+        // text follows on the same logical line.
+        var pendingSpaces = 0
+        var pendingNewlines = 0
+
+        func flushIfFull() {
+            if buffer.count >= Self.chunkSize {
+                sink(Data(buffer))
+                buffer.removeAll(keepingCapacity: true)
+            }
+        }
+
+        func append(scalar value: UInt32) {
+            if value == 0x20 {
+                pendingSpaces += 1
+                return
+            }
+            if pendingNewlines > 0 {
+                buffer.append(contentsOf: repeatElement(0x0A, count: pendingNewlines))
+                pendingNewlines = 0
+            }
+            if pendingSpaces > 0 {
+                buffer.append(contentsOf: repeatElement(0x20, count: pendingSpaces))
+                pendingSpaces = 0
+            }
+            let scalar = Unicode.Scalar(value) ?? "\u{FFFD}"
+            UTF8.encode(scalar) { buffer.append($0) }
+        }
+
+        func endRow(isWrapped: Bool) {
+            guard !isWrapped else { return }
+            pendingSpaces = 0
+            pendingNewlines += 1
+            flushIfFull()
+        }
+
+        var text = ScrollbackLineText()
+        func writeLine(_ line: ScrollbackLine) {
+            text.load(line, folding: false)
+            for value in text.scalars {
+                append(scalar: value)
+            }
+            endRow(isWrapped: line.isWrapped)
+        }
+
+        // Set after a fold's summary row while its wrapped remainder, if
+        // any, is skipped.
+        var skipsSummaryRemainder = false
+        scrollback.forEachLine(from: 0) { _, line in
+            if skipsSummaryRemainder {
+                skipsSummaryRemainder = line.isWrapped
+                return true
+            }
+            if !folds.isEmpty, let fold = folds.fold(summarizedBy: line) {
+                var endsWrapped = false
+                fold.lines.forEachLine(from: 0) { _, foldedLine in
+                    writeLine(foldedLine)
+                    endsWrapped = foldedLine.isWrapped
+                    return true
+                }
+                if endsWrapped {
+                    endRow(isWrapped: false)
+                }
+                skipsSummaryRemainder = line.isWrapped
+                return true
+            }
+            writeLine(line)
+            return true
+        }
+        for row in screenRows {
+            for scalar in row.text.unicodeScalars {
+                append(scalar: scalar.value)
+            }
+            endRow(isWrapped: row.isWrapped)
+        }
+
+        if !buffer.isEmpty {
+            sink(Data(buffer))
+        }
+    }
+
+    /// The whole export as UTF-8.
+    func utf8Data() -> Data {
+        var data = Data()
+        write { data.append($0) }
+        return data
+    }
+}
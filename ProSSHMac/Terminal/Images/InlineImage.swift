@@ -0,0 +1,119 @@
+// InlineImage.swift
+// ProSSHV2
+//
+// Inline images: Sixel (DCS q), iTerm2 (OSC 1337 File=) and the kitty
+// graphics protocol (APC G). Tools such as imgcat, timg, kitty icat and
+// matplotlib's terminal backends used to print garbage or nothing.
+//
+// The parser only reads what it needs to reserve cells: the protocol's
+// arguments and the image's pixel size. The size comes from the sixel
+// raster attributes, the kitty header, or the first few kilobytes of the
+// file (see InlineImageHeader). The payload itself goes to
+// InlineImageStore, which decodes it on its own queue while the parser moves
+// on to the text after it. The grid anchors each placement to a line,
+// numbered as scrollback line IDs continued down the screen (as semantic
+// zones are), so images scroll into and out of scrollback with the text
+// around them. Snapshots carry the placements that overlap the viewport.
+// MetalTerminalRenderer draws each one as a textured quad from
+// InlineImageTextureCache.
+
+import Foundation
+import Synchronization
+
+// MARK: - InlineImageID
+
+/// One transmitted image, unique within the process. Identical payloads
+/// share a bitmap and a texture through `InlineImageStore.ContentKey`.
+nonisolated struct InlineImageID: Hashable, Sendable {
+    let rawValue: UInt64
+
+    private static let nextRawValue = Atomic<UInt64>(1)
+
+    static func next() -> InlineImageID {
+        InlineImageID(rawValue: nextRawValue.add(1, ordering: .relaxed).oldValue)
+    }
+}
+
+// MARK: - InlineImagePayload
+
+/// An image as it arrived, still encoded. Decoded by InlineImageStore.
+nonisolated struct InlineImagePayload: Sendable {
+    enum Encoding: Sendable, Equatable {
+        /// A file ImageIO reads: PNG, JPEG, GIF, TIFF, HEIC and so on.
+        case file
+        /// DECSIXEL data; P2 = 1 leaves unset pixels transparent.
+        case sixel(transparentBackground: Bool)
+        /// kitty f=24 or f=32: straight RGB or RGBA, row-major.
+        case rawPixels(width: Int, height: Int, bytesPerPixel: Int)
+    }
+
+    var encoding: Encoding
+    /// Base64 text when `isBase64`, raw bytes otherwise.
+    var bytes: [UInt8]
+    var isBase64: Bool
+    /// kitty o=z: zlib-compressed once base64 is decoded.
+    var isZlibCompressed = false
+}
+
+// MARK: - InlineImageBitmap
+
+/// Decoded pixels, ready for texture upload.
+nonisolated struct InlineImageBitmap: Sendable {
+    let width: Int
+    let height: Int
+    /// Premultiplied BGRA, `width * 4` bytes per row.
+    let pixels: [UInt8]
+
+    var bytesPerRow: Int { width * 4 }
+    var byteCount: Int { pixels.count }
+}
+
+// MARK: - InlineImageCellSize
+
+/// Pixel size of one cell, reported by the renderer. Decides how many
+/// cells an image given in pixels covers.
+nonisolated struct InlineImageCellSize: Sendable, Equatable {
+    var width: Int
+    var height: Int
+
+    /// Used until a renderer reports the real size.
+    static let fallback = InlineImageCellSize(width: 10, height: 20)
+}
+
+// MARK: - InlineImagePlacement
+
+/// An image anchored to the grid.
+nonisolated struct InlineImagePlacement: Sendable, Equatable {
+    let imageID: InlineImageID
+    /// Top row. On the primary screen this is a scrollback line ID
+    /// continued down the screen; on the alternate screen, a screen row.
+    var line: Int
+    let column: Int
+    let columns: Int
+    let rows: Int
+    /// Share of the cell box the image fills from its top-left corner.
+    /// Below 1 when an image shown at its own pixel size does not end on
+    /// a cell boundary.
+    var widthFraction: Float = 1
+    var heightFraction: Float = 1
+    /// kitty placement ID (p=); 0 when none was given.
+    var kittyPlacementID: UInt32 = 0
+
+    func overlaps(lines: Range<Int>) -> Bool {
+        line < lines.upperBound && line + rows > lines.lowerBound
+    }
+}
+
+// MARK: - InlineImageQuad
+
+/// A placement as a snapshot carries it. `row` is relative to the top of
+/// the viewport and is negative when the image starts above it.
+nonisolated struct InlineImageQuad: Sendable, Equatable {
+    let imageID: InlineImageID
+    let row: Int
+    let column: Int
+    let columns: Int
+    let rows: Int
+    var widthFraction: Float = 1
+    var heightFraction: Float = 1
+}
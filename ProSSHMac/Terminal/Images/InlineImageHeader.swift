@@ -0,0 +1,118 @@
+// InlineImageHeader.swift
+// ProSSHV2
+//
+// Pixel size of an image file, read from its header without decoding it.
+// The parser needs the size to reserve cells and move the cursor, but it
+// must not decode a multi-megabyte PNG, or base64-decode all of it, while
+// text waits behind it. PNG, GIF, BMP and JPEG keep their dimensions within
+// the first few kilobytes, so only a prefix of the base64 text is decoded.
+// Other formats, or a JPEG whose frame header sits behind a large EXIF
+// block, fall back to ImageIO's properties on the whole file.
+
+import Foundation
+import ImageIO
+
+nonisolated enum InlineImageHeader {
+
+    /// Base64 characters decoded to find the header.
+    static let base64PrefixLength = 64 * 1024
+
+    /// Pixel size of the file whose base64 text is `text`.
+    static func pixelSize(ofBase64 text: [UInt8]) -> (width: Int, height: Int)? {
+        if let prefix = decodeBase64Prefix(text, maxCharacters: base64PrefixLength),
+           let size = pixelSize(of: prefix) {
+            return size
+        }
+        guard let data = Data(base64Encoded: Data(text), options: .ignoreUnknownCharacters) else { return nil }
+        return pixelSize(of: [UInt8](data)) ?? imageIOPixelSize(of: data)
+    }
+
+    /// Pixel size from a PNG, GIF, BMP or JPEG header; nil for anything else.
+    static func pixelSize(of bytes: [UInt8]) -> (width: Int, height: Int)? {
+        if bytes.count >= 24, bytes.starts(with: [0x89, 0x50, 0x4E, 0x47, 0x0D, 0x0A, 0x1A, 0x0A]) {
+            return positive(bigEndian(bytes, at: 16, count: 4), bigEndian(bytes, at: 20, count: 4))
+        }
+        if bytes.count >= 10, bytes.starts(with: [0x47, 0x49, 0x46, 0x38]) { // "GIF8"
+            return positive(littleEndian(bytes, at: 6, count: 2), littleEndian(bytes, at: 8, count: 2))
+        }
+        if bytes.count >= 26, bytes[0] == 0x42, bytes[1] == 0x4D { // "BM"
+            let height = Int32(truncatingIfNeeded: littleEndian(bytes, at: 22, count: 4))
+            return positive(littleEndian(bytes, at: 18, count: 4), Int(height.magnitude))
+        }
+        if bytes.count >= 4, bytes[0] == 0xFF, bytes[1] == 0xD8 {
+            return jpegPixelSize(bytes)
+        }
+        return nil
+    }
+
+    // MARK: - Private
+
+    /// Walk JPEG segments to the first start-of-frame marker.
+    private static func jpegPixelSize(_ bytes: [UInt8]) -> (width: Int, height: Int)? {
+        var index = 2
+        while index + 3 < bytes.count {
+            guard bytes[index] == 0xFF else { return nil }
+            let marker = bytes[index + 1]
+            if marker == 0xFF { // fill byte
+                index += 1
+                continue
+            }
+            if marker == 0x01 || (0xD0...0xD8).contains(marker) { // no length
+                index += 2
+                continue
+            }
+            let length = bigEndian(bytes, at: index + 2, count: 2)
+            let isFrameHeader = (0xC0...0xCF).contains(marker) && marker != 0xC4 && marker != 0xC8 && marker != 0xCC
+            if isFrameHeader {
+                guard index + 8 < bytes.count else { return nil }
+                return positive(bigEndian(bytes, at: index + 7, count: 2), bigEndian(bytes, at: index + 5, count: 2))
+            }
+            guard length >= 2 else { return nil }
+            index += 2 + length
+        }
+        return nil
+    }
+
+    private static func imageIOPixelSize(of data: Data) -> (width: Int, height: Int)? {
+        guard let source = CGImageSourceCreateWithData(data as CFData, nil),
+              let properties = CGImageSourceCopyPropertiesAtIndex(source, 0, nil) as? [CFString: Any],
+              let width = properties[kCGImagePropertyPixelWidth] as? Int,
+              let height = properties[kCGImagePropertyPixelHeight] as? Int else { return nil }
+        return positive(width, height)
+    }
+
+    /// Decode up to `maxCharacters` base64 characters, skipping line
+    /// breaks, cut to whole four-character groups.
+    private static func decodeBase64Prefix(_ text: [UInt8], maxCharacters: Int) -> [UInt8]? {
+        var prefix: [UInt8] = []
+        prefix.reserveCapacity(min(text.count, maxCharacters))
+        for byte in text {
+            guard prefix.count < maxCharacters else { break }
+            if byte == 0x0A || byte == 0x0D || byte == 0x20 { continue }
+            prefix.append(byte)
+        }
+        prefix.removeLast(prefix.count % 4)
+        guard let data = Data(base64Encoded: Data(prefix)) else { return nil }
+        return [UInt8](data)
+    }
+
+    private static func bigEndian(_ bytes: [UInt8], at offset: Int, count: Int) -> Int {
+        var value = 0
+        for index in offset..<(offset + count) {
+            value = value << 8 | Int(bytes[index])
+        }
+        return value
+    }
+
+    private static func littleEndian(_ bytes: [UInt8], at offset: Int, count: Int) -> Int {
+        var value = 0
+        for index in (offset..<(offset + count)).reversed() {
+            value = value << 8 | Int(bytes[index])
+        }
+        return value
+    }
+
+    private static func positive(_ width: Int, _ height: Int) -> (width: Int, height: Int)? {
+        width > 0 && height > 0 ? (width, height) : nil
+    }
+}
@@ -0,0 +1,367 @@
+// InlineImageStore.swift
+// ProSSHV2
+//
+// Decoded inline images, shared by every session. The parser submits a
+// payload and moves on; decoding (base64, zlib, ImageIO or sixel) runs on
+// a concurrent utility queue so a large image never holds up the text
+// after it. Bitmaps are keyed by content as well as by image ID: a prompt
+// that prints the same logo on every command decodes, and uploads, it
+// once.
+//
+// Bitmaps and the payloads they came from are kept under separate LRU
+// budgets. An evicted bitmap is decoded again from its payload the next
+// time a texture is needed; only an image whose payload has been evicted
+// too stops drawing.
+
+import Compression
+import Foundation
+import ImageIO
+import os.log
+
+// MARK: - InlineImageStore
+
+nonisolated final class InlineImageStore: @unchecked Sendable {
+
+    /// Identifies decoded pixels by the payload they came from.
+    struct ContentKey: Hashable, Sendable {
+        let digest: Int
+        let byteCount: Int
+
+        init(_ payload: InlineImagePayload) {
+            var hasher = Hasher()
+            hasher.combine(payload.isBase64)
+            hasher.combine(payload.isZlibCompressed)
+            switch payload.encoding {
+            case .file:
+                hasher.combine(0)
+            case .sixel(let transparent):
+                hasher.combine(1)
+                hasher.combine(transparent)
+            case .rawPixels(let width, let height, let bytesPerPixel):
+                hasher.combine(2)
+                hasher.combine(width)
+                hasher.combine(height)
+                hasher.combine(bytesPerPixel)
+            }
+            payload.bytes.withUnsafeBytes { hasher.combine(bytes: $0) }
+            digest = hasher.finalize()
+            byteCount = payload.bytes.count
+        }
+    }
+
+    struct Decoded: Sendable {
+        let key: ContentKey
+        let bitmap: InlineImageBitmap
+    }
+
+    typealias Completion = @Sendable (Decoded?) -> Void
+
+    static let shared = InlineImageStore()
+
+    /// Longest side of a decoded file image; larger files are downsampled.
+    static let maxFilePixelSize = 4096
+
+    let bitmapBudget: Int
+    let payloadBudget: Int
+
+    private enum State {
+        case pending
+        case decoded
+        case failed
+    }
+
+    private struct Entry {
+        var payload: InlineImagePayload?
+        var key: ContentKey?
+        var state: State = .pending
+        var waiters: [Completion] = []
+    }
+
+    private let lock = NSLock()
+    private let queue = DispatchQueue(label: "com.prossh.inline-image-decode", qos: .utility, attributes: .concurrent)
+    private var entries: [InlineImageID: Entry] = [:]
+    private var bitmaps: [ContentKey: (bitmap: InlineImageBitmap, lastUse: UInt64)] = [:]
+    private var payloadLastUse: [InlineImageID: UInt64] = [:]
+    private var bitmapBytes = 0
+    private var payloadBytes = 0
+    private var useClock: UInt64 = 0
+
+    private static let logger = Logger(subsystem: "com.prossh", category: "InlineImages")
+
+    init(bitmapBudget: Int = 256 * 1024 * 1024, payloadBudget: Int = 256 * 1024 * 1024) {
+        self.bitmapBudget = bitmapBudget
+        self.payloadBudget = payloadBudget
+    }
+
+    // MARK: - Submitting
+
+    /// Queue `payload` for decoding as `id`. Returns immediately.
+    func submit(_ payload: InlineImagePayload, for id: InlineImageID) {
+        lock.lock()
+        if let previous = entries[id]?.payload {
+            payloadBytes -= previous.bytes.count
+        }
+        entries[id] = Entry(payload: payload)
+        payloadBytes += payload.bytes.count
+        touchPayload(id)
+        evictPayloadsOverBudget()
+        lock.unlock()
+        scheduleDecode(of: payload, for: id)
+    }
+
+    /// Forget `id`. Its bitmap stays cached for other images with the same
+    /// content until the budget evicts it.
+    func remove(_ id: InlineImageID) {
+        lock.lock()
+        defer { lock.unlock() }
+        guard let entry = entries.removeValue(forKey: id) else { return }
+        if let payload = entry.payload {
+            payloadBytes -= payload.bytes.count
+        }
+        payloadLastUse[id] = nil
+    }
+
+    /// Drop every decoded bitmap; payloads stay, so images decode again as
+    /// they come back into view. Used under memory pressure.
+    func removeAllBitmaps() {
+        lock.lock()
+        defer { lock.unlock() }
+        bitmaps.removeAll()
+        bitmapBytes = 0
+    }
+
+    // MARK: - Reading
+
+    /// Bytes held in bitmaps and payloads.
+    var byteCount: Int {
+        lock.lock()
+        defer { lock.unlock() }
+        return bitmapBytes + payloadBytes
+    }
+
+    /// The decoded image if it is ready. An image whose bitmap was evicted
+    /// is decoded again; use `whenDecoded` to hear when it is back.
+    func decoded(_ id: InlineImageID) -> Decoded? {
+        lock.lock()
+        guard let entry = entries[id] else {
+            lock.unlock()
+            return nil
+        }
+        if let key = entry.key, let cached = bitmaps[key] {
+            useClock += 1
+            bitmaps[key]?.lastUse = useClock
+            lock.unlock()
+            return Decoded(key: key, bitmap: cached.bitmap)
+        }
+        let payload = takeForRedecode(id)
+        lock.unlock()
+        if let payload {
+            scheduleDecode(of: payload, for: id)
+        }
+        return nil
+    }
+
+    /// Call `completion` with the decoded image, from the decode queue
+    /// once decoding finishes, or right away if it already has. Receives
+    /// nil when the image failed to decode or is unknown.
+    func whenDecoded(_ id: InlineImageID, perform completion: @escaping Completion) {
+        if let ready = decoded(id) {
+            completion(ready)
+            return
+        }
+        lock.lock()
+        guard entries[id]?.state == .pending else {
+            let ready = entries[id].flatMap { entry in
+                entry.key.flatMap { key in bitmaps[key].map { Decoded(key: key, bitmap: $0.bitmap) } }
+            }
+            lock.unlock()
+            completion(ready)
+            return
+        }
+        entries[id]?.waiters.append(completion)
+        lock.unlock()
+    }
+
+    // MARK: - Decoding
+
+    private func scheduleDecode(of payload: InlineImagePayload, for id: InlineImageID) {
+        queue.async { [self] in
+            let key = ContentKey(payload)
+            lock.lock()
+            let shared = bitmaps[key]?.bitmap
+            lock.unlock()
+            let bitmap = shared ?? Self.decode(payload)
+            if bitmap == nil {
+                Self.logger.debug("Inline image \(id.rawValue, privacy: .public) failed to decode")
+            }
+            finish(id, key: key, bitmap: bitmap)
+        }
+    }
+
+    private func finish(_ id: InlineImageID, key: ContentKey, bitmap: InlineImageBitmap?) {
+        lock.lock()
+        if let bitmap, bitmaps[key] == nil {
+            bitmaps[key] = (bitmap, 0)
+            bitmapBytes += bitmap.byteCount
+        }
+        useClock += 1
+        bitmaps[key]?.lastUse = useClock
+        let waiters = entries[id]?.waiters ?? []
+        if let entry = entries[id] {
+            entries[id]?.key = key
+            entries[id]?.state = bitmap == nil ? .failed : .decoded
+            entries[id]?.waiters = []
+            if bitmap == nil, let payload = entry.payload {
+                // Decoding it again would fail again.
+                entries[id]?.payload = nil
+                payloadBytes -= payload.bytes.count
+                payloadLastUse[id] = nil
+            }
+        }
+        evictBitmapsOverBudget(keeping: key)
+        let result = bitmap.map { Decoded(key: key, bitmap: $0) }
+        lock.unlock()
+        for waiter in waiters {
+            waiter(result)
+        }
+    }
+
+    /// Mark an evicted image pending again and hand back its payload to
+    /// decode. Nil when it is already decoding, failed, or cannot be
+    /// recovered.
+    /// Caller holds the lock.
+    private func takeForRedecode(_ id: InlineImageID) -> InlineImagePayload? {
+        guard let entry = entries[id], entry.state == .decoded, let payload = entry.payload else { return nil }
+        entries[id]?.state = .pending
+        entries[id]?.key = nil
+        touchPayload(id)
+        return payload
+    }
+
+    // MARK: - Eviction
+
+    private func touchPayload(_ id: InlineImageID) {
+        useClock += 1
+        payloadLastUse[id] = useClock
+    }
+
+    private func evictBitmapsOverBudget(keeping kept: ContentKey) {
+        guard bitmapBytes > bitmapBudget else { return }
+        let oldestFirst = bitmaps.sorted { $0.value.lastUse < $1.value.lastUse }
+        for (key, cached) in oldestFirst where bitmapBytes > bitmapBudget && key != kept {
+            bitmaps[key] = nil
+            bitmapBytes -= cached.bitmap.byteCount
+        }
+    }
+
+    private func evictPayloadsOverBudget() {
+        guard payloadBytes > payloadBudget else { return }
+        let oldestFirst = payloadLastUse.sorted { $0.value < $1.value }
+        for (id, _) in oldestFirst.dropLast() where payloadBytes > payloadBudget {
+            guard let payload = entries[id]?.payload else { continue }
+            entries[id]?.payload = nil
+            payloadBytes -= payload.bytes.count
+            payloadLastUse[id] = nil
+        }
+    }
+
+    // MARK: - Formats
+
+    static func decode(_ payload: InlineImagePayload) -> InlineImageBitmap? {
+        var bytes = payload.bytes
+        if payload.isBase64 {
+            guard let data = Data(base64Encoded: Data(bytes), options: .ignoreUnknownCharacters) else { return nil }
+            bytes = [UInt8](data)
+        }
+        if payload.isZlibCompressed {
+            guard let inflated = inflate(bytes) else { return nil }
+            bytes = inflated
+        }
+        switch payload.encoding {
+        case .file:
+            return decodeFile(bytes)
+        case .sixel(let transparentBackground):
+            return SixelDecoder.decode(bytes, transparentBackground: transparentBackground)
+        case .rawPixels(let width, let height, let bytesPerPixel):
+            return convertRawPixels(bytes, width: width, height: height, bytesPerPixel: bytesPerPixel)
+        }
+    }
+
+    private static func decodeFile(_ bytes: [UInt8]) -> InlineImageBitmap? {
+        let options: [CFString: Any] = [
+            kCGImageSourceCreateThumbnailFromImageAlways: true,
+            kCGImageSourceCreateThumbnailWithTransform: true,
+            kCGImageSourceThumbnailMaxPixelSize: maxFilePixelSize,
+        ]
+        guard let source = CGImageSourceCreateWithData(Data(bytes) as CFData, nil),
+              let image = CGImageSourceCreateThumbnailAtIndex(source, 0, options as CFDictionary) else { return nil }
+        let width = image.width
+        let height = image.height
+        guard width > 0, height > 0, let colorSpace = CGColorSpace(name: CGColorSpace.sRGB) else { return nil }
+        var pixels = [UInt8](repeating: 0, count: width * height * 4)
+        let drawn = pixels.withUnsafeMutableBytes { buffer -> Bool in
+            guard let context = CGContext(
+                data: buffer.baseAddress,
+                width: width,
+                height: height,
+                bitsPerComponent: 8,
+                bytesPerRow: width * 4,
+                space: colorSpace,
+                bitmapInfo: CGImageAlphaInfo.premultipliedFirst.rawValue | CGBitmapInfo.byteOrder32Little.rawValue
+            ) else { return false }
+            context.draw(image, in: CGRect(x: 0, y: 0, width: width, height: height))
+            return true
+        }
+        return drawn ? InlineImageBitmap(width: width, height: height, pixels: pixels) : nil
+    }
+
+    /// Straight RGB or RGBA to premultiplied BGRA.
+    private static func convertRawPixels(_ bytes: [UInt8], width: Int, height: Int, bytesPerPixel: Int) -> InlineImageBitmap? {
+        guard width > 0, height > 0, bytesPerPixel == 3 || bytesPerPixel == 4,
+              bytes.count >= width * height * bytesPerPixel else { return nil }
+        let count = width * height
+        var pixels = [UInt8](repeating: 0, count: count * 4)
+        bytes.withUnsafeBufferPointer { source in
+            pixels.withUnsafeMutableBufferPointer { destination in
+                for index in 0..<count {
+                    let from = index * bytesPerPixel
+                    let to = index * 4
+                    let alpha = bytesPerPixel == 4 ? UInt16(source[from + 3]) : 255
+                    destination[to] = UInt8((UInt16(source[from + 2]) * alpha + 127) / 255)
+                    destination[to + 1] = UInt8((UInt16(source[from + 1]) * alpha + 127) / 255)
+                    destination[to + 2] = UInt8((UInt16(source[from]) * alpha + 127) / 255)
+                    destination[to + 3] = UInt8(alpha)
+                }
+            }
+        }
+        return InlineImageBitmap(width: width, height: height, pixels: pixels)
+    }
+
+    /// Inflate a zlib stream (RFC 1950). Compression's ZLIB codec reads raw
+    /// deflate, so the two-byte header is skipped; the output buffer grows
+    /// until the stream fits.
+    static func inflate(_ bytes: [UInt8]) -> [UInt8]? {
+        guard bytes.count > 2 else { return nil }
+        let limit = 256 * 1024 * 1024
+        var capacity = max(bytes.count * 4, 64 * 1024)
+        while capacity <= limit {
+            var output = [UInt8](repeating: 0, count: capacity)
+            let written = bytes.withUnsafeBufferPointer { source in
+                output.withUnsafeMutableBufferPointer { destination in
+                    compression_decode_buffer(
+                        destination.baseAddress!, destination.count,
+                        source.baseAddress! + 2, source.count - 2,
+                        nil, COMPRESSION_ZLIB
+                    )
+                }
+            }
+            if written == 0 { return nil }
+            if written < capacity {
+                output.removeLast(capacity - written)
+                return output
+            }
+            capacity *= 2
+        }
+        return nil
+    }
+}
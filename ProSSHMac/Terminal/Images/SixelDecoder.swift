@@ -0,0 +1,256 @@
+// SixelDecoder.swift
+// ProSSHV2
+//
+// DECSIXEL data (the bytes between DCS <P1;P2;P3> q and ST) to pixels.
+// Each data byte 0x3F–0x7E paints a column of six pixels in the current
+// colour; `!n` repeats the next byte, `$` returns to the left edge and `-`
+// moves down one six-pixel band. `#n` selects a colour register and
+// `#n;u;x;y;z` defines it in HLS (u = 1) or RGB (u = 2), both in percent.
+// `"a;b;w;h` raster attributes give the canvas size.
+//
+// `measure` runs on the parser's queue, so it reads the raster attributes
+// when the encoder wrote them, as libsixel and most tools do, and only
+// otherwise scans the data for its extent. `decode` runs on
+// InlineImageStore's queue.
+
+import Foundation
+
+nonisolated enum SixelDecoder {
+
+    /// Canvas dimensions are capped so a malformed repeat count cannot
+    /// allocate gigabytes.
+    static let maxDimension = 10_000
+
+    /// Canvas size: the raster attributes if present, otherwise the extent
+    /// the data paints.
+    static func measure(_ data: [UInt8]) -> (width: Int, height: Int)? {
+        if let raster = rasterAttributes(data) {
+            return raster
+        }
+        let extent = scanExtent(data)
+        return extent.width > 0 && extent.height > 0 ? extent : nil
+    }
+
+    /// Decode into premultiplied BGRA. Pixels no byte paints are
+    /// transparent when `transparentBackground`, otherwise colour 0.
+    static func decode(_ data: [UInt8], transparentBackground: Bool) -> InlineImageBitmap? {
+        guard let size = measure(data) else { return nil }
+        let width = min(size.width, maxDimension)
+        let height = min(size.height, maxDimension)
+        var palette = defaultPalette
+        let background: UInt32 = transparentBackground ? 0 : palette[0]
+        var pixels = [UInt32](repeating: background, count: width * height)
+
+        pixels.withUnsafeMutableBufferPointer { canvas in
+            var x = 0
+            var bandTop = 0
+            var color = palette[0]
+            var repeatCount = 1
+            var index = 0
+            while index < data.count {
+                let byte = data[index]
+                switch byte {
+                case 0x3F...0x7E:
+                    let bits = byte - 0x3F
+                    if bits != 0, x < width {
+                        let run = min(repeatCount, width - x)
+                        for bit in 0..<6 where bits & (1 << bit) != 0 {
+                            let y = bandTop + bit
+                            guard y < height else { break }
+                            let rowStart = y * width + x
+                            for offset in 0..<run {
+                                canvas[rowStart + offset] = color
+                            }
+                        }
+                    }
+                    x += repeatCount
+                    repeatCount = 1
+                    index += 1
+                case 0x21: // '!' repeat
+                    let (count, next) = readNumber(data, from: index + 1)
+                    repeatCount = max(1, min(count ?? 1, maxDimension))
+                    index = next
+                case 0x23: // '#' colour
+                    let (values, next) = readParameters(data, from: index + 1)
+                    index = next
+                    guard let register = values.first else { break }
+                    let slot = register % palette.count
+                    if values.count >= 5 {
+                        palette[slot] = defineColor(space: values[1], values[2], values[3], values[4])
+                    }
+                    color = palette[slot]
+                case 0x24: // '$' carriage return
+                    x = 0
+                    index += 1
+                case 0x2D: // '-' next band
+                    x = 0
+                    bandTop += 6
+                    index += 1
+                case 0x22: // '"' raster attributes, already measured
+                    index = readParameters(data, from: index + 1).next
+                default:
+                    index += 1
+                }
+            }
+        }
+
+        let bytes = pixels.withUnsafeBytes { [UInt8]($0) }
+        return InlineImageBitmap(width: width, height: height, pixels: bytes)
+    }
+
+    // MARK: - Measuring
+
+    /// Width and height from `"a;b;w;h`, if it comes before any pixel data.
+    private static func rasterAttributes(_ data: [UInt8]) -> (width: Int, height: Int)? {
+        var index = 0
+        while index < data.count {
+            let byte = data[index]
+            if byte == 0x22 {
+                let values = readParameters(data, from: index + 1).values
+                guard values.count >= 4, values[2] > 0, values[3] > 0 else { return nil }
+                return (min(values[2], maxDimension), min(values[3], maxDimension))
+            }
+            if (0x3F...0x7E).contains(byte) || byte == 0x21 || byte == 0x2D {
+                return nil
+            }
+            if byte == 0x23 {
+                index = readParameters(data, from: index + 1).next
+            } else {
+                index += 1
+            }
+        }
+        return nil
+    }
+
+    /// The rightmost column and lowest row any byte paints.
+    private static func scanExtent(_ data: [UInt8]) -> (width: Int, height: Int) {
+        var x = 0
+        var bandTop = 0
+        var width = 0
+        var height = 0
+        var repeatCount = 1
+        var index = 0
+        while index < data.count {
+            let byte = data[index]
+            switch byte {
+            case 0x3F...0x7E:
+                let bits = byte - 0x3F
+                x += repeatCount
+                repeatCount = 1
+                if bits != 0 {
+                    width = max(width, x)
+                    let lowest = 6 - bits.leadingZeroBitCount + 2
+                    height = max(height, bandTop + lowest)
+                }
+                index += 1
+            case 0x21:
+                let (count, next) = readNumber(data, from: index + 1)
+                repeatCount = max(1, min(count ?? 1, maxDimension))
+                index = next
+            case 0x23, 0x22:
+                index = readParameters(data, from: index + 1).next
+            case 0x24:
+                x = 0
+                index += 1
+            case 0x2D:
+                x = 0
+                bandTop += 6
+                index += 1
+            default:
+                index += 1
+            }
+            if width >= maxDimension, height >= maxDimension { break }
+        }
+        return (min(width, maxDimension), min(height, maxDimension))
+    }
+
+    // MARK: - Parameters
+
+    private static func readNumber(_ data: [UInt8], from start: Int) -> (value: Int?, next: Int) {
+        var index = start
+        var value: Int?
+        while index < data.count, (0x30...0x39).contains(data[index]) {
+            value = min((value ?? 0) * 10 + Int(data[index] - 0x30), 1 << 24)
+            index += 1
+        }
+        return (value, index)
+    }
+
+    /// Semicolon-separated numbers; an empty parameter reads as 0.
+    private static func readParameters(_ data: [UInt8], from start: Int) -> (values: [Int], next: Int) {
+        var values: [Int] = []
+        var index = start
+        while true {
+            let (value, next) = readNumber(data, from: index)
+            values.append(value ?? 0)
+            index = next
+            guard index < data.count, data[index] == 0x3B else { break }
+            index += 1
+        }
+        return (values, index)
+    }
+
+    // MARK: - Colour
+
+    /// Packed BGRA (in memory order) with full alpha.
+    private static func pack(red: Int, green: Int, blue: Int) -> UInt32 {
+        let r = UInt32(max(0, min(255, red)))
+        let g = UInt32(max(0, min(255, green)))
+        let b = UInt32(max(0, min(255, blue)))
+        return (0xFF << 24 | r << 16 | g << 8 | b).littleEndian
+    }
+
+    private static func percent(_ value: Int) -> Int {
+        (min(max(value, 0), 100) * 255 + 50) / 100
+    }
+
+    private static func defineColor(space: Int, _ a: Int, _ b: Int, _ c: Int) -> UInt32 {
+        if space == 1 {
+            return hlsColor(hue: a, lightness: b, saturation: c)
+        }
+        return pack(red: percent(a), green: percent(b), blue: percent(c))
+    }
+
+    /// DEC HLS puts blue at 0°, red at 120° and green at 240°.
+    private static func hlsColor(hue: Int, lightness: Int, saturation: Int) -> UInt32 {
+        let h = Double((hue + 240) % 360) / 360
+        let l = Double(min(max(lightness, 0), 100)) / 100
+        let s = Double(min(max(saturation, 0), 100)) / 100
+        guard s > 0 else {
+            let gray = Int(l * 255 + 0.5)
+            return pack(red: gray, green: gray, blue: gray)
+        }
+        let q = l < 0.5 ? l * (1 + s) : l + s - l * s
+        let p = 2 * l - q
+        func channel(_ t: Double) -> Int {
+            var t = t
+            if t < 0 { t += 1 }
+            if t > 1 { t -= 1 }
+            let value: Double
+            if t < 1.0 / 6 {
+                value = p + (q - p) * 6 * t
+            } else if t < 0.5 {
+                value = q
+            } else if t < 2.0 / 3 {
+                value = p + (q - p) * (2.0 / 3 - t) * 6
+            } else {
+                value = p
+            }
+            return Int(value * 255 + 0.5)
+        }
+        return pack(red: channel(h + 1.0 / 3), green: channel(h), blue: channel(h - 1.0 / 3))
+    }
+
+    /// VT340 start-up colours in registers 0–15; the rest start black.
+    private static let defaultPalette: [UInt32] = {
+        let vt340: [(Int, Int, Int)] = [
+            (0, 0, 0), (20, 20, 80), (80, 13, 13), (20, 80, 20),
+            (80, 20, 80), (20, 80, 80), (80, 80, 20), (53, 53, 53),
+            (26, 26, 26), (33, 33, 60), (60, 26, 26), (33, 60, 33),
+            (60, 33, 60), (33, 60, 60), (60, 60, 33), (80, 80, 80),
+        ]
+        var palette = vt340.map { pack(red: percent($0.0), green: percent($0.1), blue: percent($0.2)) }
+        palette += Array(repeating: pack(red: 0, green: 0, blue: 0), count: 256 - palette.count)
+        return palette
+    }()
+}
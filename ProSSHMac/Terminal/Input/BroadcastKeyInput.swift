@@ -0,0 +1,45 @@
+// BroadcastKeyInput.swift
+// ProSSHV2
+//
+// One key press in broadcast or group input, kept encodable for every target.
+// The targets can disagree on input modes. A session in application cursor
+// mode (DECCKM) expects SS3 arrows, so the bytes for the focused pane are
+// not always right for the others. The capture view encodes the press once
+// for the focused session; `SessionShellIOCoordinator.broadcastShellInput`
+// reuses those bytes for every target with the same options, and re-encodes
+// only for targets whose options differ.
+
+import Foundation
+
+struct BroadcastKeyInput {
+    /// Options `bytes` were encoded with.
+    let options: KeyEncoderOptions
+    let bytes: [UInt8]
+    let eventType: String
+    /// Re-encodes the press for other options. Nil when the bytes are the
+    /// same in every mode (text, control sequences).
+    let encode: ((KeyEncoderOptions) -> [UInt8]?)?
+
+    init(
+        options: KeyEncoderOptions,
+        bytes: [UInt8],
+        eventType: String,
+        encode: ((KeyEncoderOptions) -> [UInt8]?)? = nil
+    ) {
+        self.options = options
+        self.bytes = bytes
+        self.eventType = eventType
+        self.encode = encode
+    }
+
+    /// Input that does not depend on the target's modes.
+    init(bytes: [UInt8], eventType: String) {
+        self.init(options: .default, bytes: bytes, eventType: eventType)
+    }
+
+    /// Bytes for a target, nil when the press has no encoding there.
+    func bytes(for targetOptions: KeyEncoderOptions) -> [UInt8]? {
+        guard let encode, targetOptions != options else { return bytes }
+        return encode(targetOptions)
+    }
+}
@@ -50,7 +50,7 @@ struct KeyEvent: Sendable {
     }
 }
 
-struct KeyEncoderOptions: Sendable {
+struct KeyEncoderOptions: Sendable, Hashable {
     var applicationCursorKeys: Bool = false
     var backspaceSendsDelete: Bool = true // DEL (0x7F). If false, sends BS (0x08).
     var enterSendsCRLF: Bool = false
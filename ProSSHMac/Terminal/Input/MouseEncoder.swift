@@ -2,11 +2,18 @@
 // ProSSHV2
 //
 // Encodes terminal mouse events and maps platform pointer input.
+//
+// Motion is the hot path. With any-event tracking (mode 1003) every
+// `mouseMoved` used to build an SGR String and start a shell send, so a
+// 120 Hz trackpad queued hundreds of stale reports on a slow link. Motion
+// is now coalesced to the latest cell once per display frame, motion that
+// stays in the last reported cell is dropped, and reports are encoded as
+// bytes into a buffer the capture view reuses.
 
 import Foundation
 import CoreGraphics
 
-enum MouseButton: Sendable {
+enum MouseButton: Sendable, Equatable {
     case left
     case middle
     case right
@@ -21,7 +28,7 @@ struct MouseEventModifiers: OptionSet, Sendable, Hashable {
     static let ctrl = MouseEventModifiers(rawValue: 1 << 2)
 }
 
-enum MouseEventKind: Sendable {
+enum MouseEventKind: Sendable, Equatable {
     case press
     case release
     case move
@@ -29,7 +36,7 @@ enum MouseEventKind: Sendable {
     case scrollDown
 }
 
-struct MouseEvent: Sendable {
+struct MouseEvent: Sendable, Equatable {
     var kind: MouseEventKind
     var button: MouseButton
     var row: Int
@@ -65,19 +72,38 @@ struct MouseEncoder: Sendable {
     }
 
     func encode(_ event: MouseEvent) -> String? {
-        guard shouldSend(event) else { return nil }
-        guard let buttonCode = encodedButtonCode(for: event) else { return nil }
+        var bytes: [UInt8] = []
+        guard encode(event, into: &bytes) else { return nil }
+
+        switch encoding {
+        case .sgr:
+            return String(decoding: bytes, as: UTF8.self)
+        case .x10, .utf8:
+            // Use .isoLatin1 instead of .utf8 because X10 mouse encoding
+            // produces raw bytes 0x20-0xFF which may include invalid UTF-8
+            // continuation bytes (0x80-0xBF), causing String(encoding: .utf8)
+            // to return nil.
+            return String(bytes: bytes, encoding: .isoLatin1)
+        }
+    }
+
+    /// Appends the report for `event` to `buffer`. Returns false, leaving
+    /// the buffer alone, when the tracking mode does not report the event.
+    func encode(_ event: MouseEvent, into buffer: inout [UInt8]) -> Bool {
+        guard shouldSend(event) else { return false }
+        guard let buttonCode = encodedButtonCode(for: event) else { return false }
 
         switch encoding {
         case .sgr:
-            return encodeSGR(buttonCode: buttonCode, event: event)
+            encodeSGR(buttonCode: buttonCode, event: event, into: &buffer)
         case .x10, .utf8:
             // UTF-8 mouse encoding (1005) is not implemented yet; use X10-compatible bytes.
-            return encodeX10(buttonCode: buttonCode, event: event)
+            encodeX10(buttonCode: buttonCode, event: event, into: &buffer)
         }
+        return true
     }
 
-    private func shouldSend(_ event: MouseEvent) -> Bool {
+    func shouldSend(_ event: MouseEvent) -> Bool {
         switch trackingMode {
         case .none:
             return false
@@ -132,42 +158,115 @@ struct MouseEncoder: Sendable {
         return code
     }
 
-    private func encodeX10(buttonCode: Int, event: MouseEvent) -> String? {
+    private func encodeX10(buttonCode: Int, event: MouseEvent, into buffer: inout [UInt8]) {
         let col = max(1, min(223, event.column))
         let row = max(1, min(223, event.row))
 
-        let bytes: [UInt8] = [
+        buffer.append(contentsOf: [
             0x1B,
             0x5B,
             0x4D,
             UInt8(clamping: buttonCode + 32),
             UInt8(clamping: col + 32),
             UInt8(clamping: row + 32)
-        ]
-        // Use .isoLatin1 instead of .utf8 because X10 mouse encoding
-        // produces raw bytes 0x20-0xFF which may include invalid UTF-8
-        // continuation bytes (0x80-0xBF), causing String(encoding: .utf8)
-        // to return nil.
-        return String(bytes: bytes, encoding: .isoLatin1)
+        ])
     }
 
-    private func encodeSGR(buttonCode: Int, event: MouseEvent) -> String {
+    private func encodeSGR(buttonCode: Int, event: MouseEvent, into buffer: inout [UInt8]) {
         // SGR mouse encoding uses 1-based coordinates; grid coordinates are 0-based.
         let col = max(1, event.column + 1)
         let row = max(1, event.row + 1)
-        let suffix = event.kind == .release ? "m" : "M"
-        return "\u{1B}[<\(buttonCode);\(col);\(row)\(suffix)"
+        buffer.append(contentsOf: [0x1B, 0x5B, 0x3C])  // ESC [ <
+        Self.appendDecimal(buttonCode, to: &buffer)
+        buffer.append(0x3B)
+        Self.appendDecimal(col, to: &buffer)
+        buffer.append(0x3B)
+        Self.appendDecimal(row, to: &buffer)
+        buffer.append(event.kind == .release ? 0x6D : 0x4D)  // m / M
+    }
+
+    private static func appendDecimal(_ value: Int, to buffer: inout [UInt8]) {
+        var divisor = 1
+        while divisor <= value / 10 {
+            divisor *= 10
+        }
+        var remainder = value
+        while divisor > 0 {
+            buffer.append(UInt8(ascii: "0") + UInt8(remainder / divisor))
+            remainder %= divisor
+            divisor /= 10
+        }
+    }
+}
+
+// MARK: - MouseMotionCoalescer
+
+/// Collapses pointer motion between flushes to the latest event, and drops
+/// motion that would report the position the application already has.
+/// Discrete events (press, release, scroll) are never held; callers flush
+/// pending motion before sending one, so reports stay in order.
+struct MouseMotionCoalescer: Sendable {
+    private struct Reported: Equatable {
+        var row: Int
+        var column: Int
+        var button: MouseButton
+        var modifiers: MouseEventModifiers
+
+        init(_ event: MouseEvent) {
+            row = event.row
+            column = event.column
+            button = event.button
+            modifiers = event.modifiers
+        }
+    }
+
+    private(set) var pending: MouseEvent?
+    private var lastReported: Reported?
+
+    /// Holds `motion` for the next flush. Returns true when nothing was
+    /// pending before, meaning a flush needs scheduling.
+    mutating func submit(_ motion: MouseEvent) -> Bool {
+        guard Reported(motion) != lastReported else {
+            // Back in the reported cell before the flush: nothing to send.
+            pending = nil
+            return false
+        }
+        let needsFlush = pending == nil
+        pending = motion
+        return needsFlush
+    }
+
+    /// The motion to send now, if any.
+    mutating func take() -> MouseEvent? {
+        defer { pending = nil }
+        return pending
+    }
+
+    /// Records a report the application received, so motion that stays there
+    /// is dropped. A release leaves no button held.
+    mutating func noteReported(_ event: MouseEvent) {
+        var reported = Reported(event)
+        if event.kind == .release {
+            reported.button = .none
+        }
+        lastReported = reported
+    }
+
+    mutating func reset() {
+        pending = nil
+        lastReported = nil
     }
 }
 
 import SwiftUI
 import AppKit
+import QuartzCore
 
 struct MouseInputHandler: NSViewRepresentable {
     var isEnabled: Bool
     var modeSnapshot: () -> InputModeSnapshot
     var locationToCell: (CGPoint) -> (row: Int, col: Int)?
-    var onSendSequence: (String) -> Void
+    var onSendBytes: ([UInt8]) -> Void
     var shouldRouteWheelToViewport: (CGFloat) -> Bool = { _ in false }
     var onViewportScroll: ((Int) -> Void)? = nil
 
@@ -179,7 +278,7 @@ struct MouseInputHandler: NSViewRepresentable {
         nsView.isEnabled = isEnabled
         nsView.modeSnapshot = modeSnapshot
         nsView.locationToCell = locationToCell
-        nsView.onSendSequence = onSendSequence
+        nsView.onSendBytes = onSendBytes
         nsView.shouldRouteWheelToViewport = shouldRouteWheelToViewport
         nsView.onViewportScroll = onViewportScroll
     }
@@ -194,6 +293,8 @@ final class MouseInputCaptureView: NSView {
                 activeButton = .none
                 scrollAccumulator = 0
                 viewportScrollAccumulator = 0
+                motionCoalescer.reset()
+                motionDisplayLink?.isPaused = true
             }
         }
     }
@@ -201,7 +302,7 @@ final class MouseInputCaptureView: NSView {
         .default
     }
     var locationToCell: (CGPoint) -> (row: Int, col: Int)? = { _ in nil }
-    var onSendSequence: (String) -> Void = { _ in }
+    var onSendBytes: ([UInt8]) -> Void = { _ in }
     var shouldRouteWheelToViewport: (CGFloat) -> Bool = { _ in false }
     var onViewportScroll: ((Int) -> Void)?
 
@@ -209,6 +310,15 @@ final class MouseInputCaptureView: NSView {
     private var activeButton: MouseButton = .none
     private var scrollAccumulator: CGFloat = 0
     private var viewportScrollAccumulator: CGFloat = 0
+    private var motionCoalescer = MouseMotionCoalescer()
+    /// Fires once per frame while motion is pending; paused otherwise.
+    private var motionDisplayLink: CADisplayLink?
+    /// Reused for every report; the longest SGR report is well under this.
+    private var encodeBuffer: [UInt8] = {
+        var buffer: [UInt8] = []
+        buffer.reserveCapacity(32)
+        return buffer
+    }()
 
     override var isFlipped: Bool { true }
     override var acceptsFirstResponder: Bool { true }
@@ -217,6 +327,16 @@ final class MouseInputCaptureView: NSView {
         isEnabled ? self : nil
     }
 
+    override func viewDidMoveToWindow() {
+        super.viewDidMoveToWindow()
+        // The link is tied to the window's display; make a new one on the next motion.
+        motionDisplayLink?.invalidate()
+        motionDisplayLink = nil
+        if window == nil {
+            motionCoalescer.reset()
+        }
+    }
+
     override func updateTrackingAreas() {
         super.updateTrackingAreas()
 
@@ -264,20 +384,20 @@ final class MouseInputCaptureView: NSView {
     }
 
     override func mouseDragged(with event: NSEvent) {
-        send(kind: .move, button: .left, event: event)
+        coalesceMotion(button: .left, event: event)
     }
 
     override func rightMouseDragged(with event: NSEvent) {
-        send(kind: .move, button: .right, event: event)
+        coalesceMotion(button: .right, event: event)
     }
 
     override func otherMouseDragged(with event: NSEvent) {
-        send(kind: .move, button: .middle, event: event)
+        coalesceMotion(button: .middle, event: event)
     }
 
     override func mouseMoved(with event: NSEvent) {
         let button = activeButton == .none ? MouseButton.none : activeButton
-        send(kind: .move, button: button, event: event)
+        coalesceMotion(button: button, event: event)
     }
 
     override func scrollWheel(with event: NSEvent) {
@@ -344,24 +464,61 @@ final class MouseInputCaptureView: NSView {
         return lines
     }
 
+    /// Sends a press, release or scroll at once, after any pending motion.
     private func send(kind: MouseEventKind, button: MouseButton, event: NSEvent) {
-        guard isEnabled else { return }
+        guard isEnabled, let mouseEvent = mouseEvent(kind: kind, button: button, event: event) else { return }
+        flushPendingMotion()
+        report(mouseEvent, encoder: MouseEncoder(modeSnapshot: modeSnapshot()))
+    }
 
-        let location = convert(event.locationInWindow, from: nil)
-        guard let cell = locationToCell(location) else { return }
+    /// Holds motion for the next frame. Motion the tracking mode would not
+    /// report is dropped here, before it can schedule a frame.
+    private func coalesceMotion(button: MouseButton, event: NSEvent) {
+        guard isEnabled, let motion = mouseEvent(kind: .move, button: button, event: event) else { return }
+        guard MouseEncoder(modeSnapshot: modeSnapshot()).shouldSend(motion) else { return }
+        guard motionCoalescer.submit(motion) else { return }
+
+        if motionDisplayLink == nil, window != nil {
+            let link = displayLink(target: self, selector: #selector(motionFrameDidFire(_:)))
+            link.add(to: .main, forMode: .common)
+            motionDisplayLink = link
+        }
+        if let motionDisplayLink {
+            motionDisplayLink.isPaused = false
+        } else {
+            flushPendingMotion()
+        }
+    }
 
-        let snapshot = modeSnapshot()
-        let encoder = MouseEncoder(modeSnapshot: snapshot)
-        let mouseEvent = MouseEvent(
+    @objc private func motionFrameDidFire(_ link: CADisplayLink) {
+        link.isPaused = true
+        flushPendingMotion()
+    }
+
+    private func flushPendingMotion() {
+        guard let motion = motionCoalescer.take() else { return }
+        // Encoded with the current modes, which may have changed since the
+        // motion was queued.
+        report(motion, encoder: MouseEncoder(modeSnapshot: modeSnapshot()))
+    }
+
+    private func report(_ mouseEvent: MouseEvent, encoder: MouseEncoder) {
+        encodeBuffer.removeAll(keepingCapacity: true)
+        guard encoder.encode(mouseEvent, into: &encodeBuffer) else { return }
+        motionCoalescer.noteReported(mouseEvent)
+        onSendBytes(encodeBuffer)
+    }
+
+    private func mouseEvent(kind: MouseEventKind, button: MouseButton, event: NSEvent) -> MouseEvent? {
+        let location = convert(event.locationInWindow, from: nil)
+        guard let cell = locationToCell(location) else { return nil }
+        return MouseEvent(
             kind: kind,
             button: button,
             row: cell.row,
             column: cell.col,
             modifiers: mapModifiers(event.modifierFlags)
         )
-        guard let sequence = encoder.encode(mouseEvent) else { return }
-
-        onSendSequence(sequence)
     }
 
     private func mapModifiers(_ flags: NSEvent.ModifierFlags) -> MouseEventModifiers {
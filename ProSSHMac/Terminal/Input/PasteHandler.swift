@@ -2,7 +2,9 @@
 // ProSSHV2
 //
 // Clipboard paste handling with newline normalization, optional bracketed
-// paste wrapping, and payload chunking for large pastes.
+// paste wrapping, and payload chunking for large pastes. `PasteStream` cuts
+// the chunks lazily from the pasteboard's bytes, for pastes too large to
+// build as strings up front.
 
 import Foundation
 
@@ -13,18 +15,13 @@ struct PasteHandlerOptions: Sendable, Equatable {
 }
 
 enum PasteHandler {
-    private static let bracketedPasteStart = "\u{1B}[200~"
-    private static let bracketedPasteEnd = "\u{1B}[201~"
+    fileprivate nonisolated static let bracketedPasteStart = "\u{1B}[200~"
+    fileprivate nonisolated static let bracketedPasteEnd = "\u{1B}[201~"
 
-    static func readClipboardSequences(
-        bracketedPasteEnabled: Bool,
-        options: PasteHandlerOptions = .default
-    ) -> [String] {
-        sequences(
-            forClipboardText: PlatformClipboard.readString(),
-            bracketedPasteEnabled: bracketedPasteEnabled,
-            options: options
-        )
+    /// The clipboard as a stream, or nil when it holds no text.
+    static func readClipboardStream(bracketedPasteEnabled: Bool) -> PasteStream? {
+        guard let data = PlatformClipboard.readData(), !data.isEmpty else { return nil }
+        return PasteStream(utf8: data, bracketedPasteEnabled: bracketedPasteEnabled)
     }
 
     static func sequences(
@@ -108,3 +105,88 @@ enum PasteHandler {
         return chunks
     }
 }
+
+// MARK: - PasteStream
+
+/// A paste cut into chunks as it is sent. Newline normalization and the
+/// bracketed-paste markers are applied per chunk, so a 50 MB paste costs the
+/// pasteboard's bytes plus one chunk instead of several full copies as
+/// strings. Chunks end on UTF-8 character boundaries, so recordings and the
+/// history index decode each one cleanly.
+nonisolated struct PasteStream: Sendable {
+    static let defaultChunkByteLimit = 64 * 1024
+
+    let source: Data
+    let bracketedPasteEnabled: Bool
+    let chunkByteLimit: Int
+    /// Source bytes already cut into chunks.
+    private(set) var consumedBytes = 0
+    private(set) var isFinished = false
+    private var hasStarted = false
+    /// The previous chunk ended in CR, so a leading LF completes a CRLF.
+    private var dropsLeadingLineFeed = false
+
+    init(utf8 source: Data, bracketedPasteEnabled: Bool, chunkByteLimit: Int = Self.defaultChunkByteLimit) {
+        self.source = source
+        self.bracketedPasteEnabled = bracketedPasteEnabled
+        self.chunkByteLimit = max(4, chunkByteLimit)
+        self.isFinished = source.isEmpty
+    }
+
+    var totalBytes: Int { source.count }
+
+    mutating func nextChunk() -> [UInt8]? {
+        guard !isFinished else { return nil }
+        var chunk: [UInt8] = []
+        chunk.reserveCapacity(chunkByteLimit + 12)
+        if !hasStarted {
+            hasStarted = true
+            if bracketedPasteEnabled {
+                chunk.append(contentsOf: PasteHandler.bracketedPasteStart.utf8)
+            }
+        }
+
+        source.withUnsafeBytes { (raw: UnsafeRawBufferPointer) in
+            let bytes = raw.bindMemory(to: UInt8.self)
+            var end = min(consumedBytes + chunkByteLimit, bytes.count)
+            // Back off to the start of a character; a lone oversized
+            // sequence is sent whole.
+            if end < bytes.count {
+                var boundary = end
+                while boundary > consumedBytes, bytes[boundary] & 0xC0 == 0x80 {
+                    boundary -= 1
+                }
+                if boundary > consumedBytes {
+                    end = boundary
+                }
+            }
+            for index in consumedBytes..<end {
+                let byte = bytes[index]
+                if dropsLeadingLineFeed {
+                    dropsLeadingLineFeed = false
+                    if byte == 0x0A { continue }
+                }
+                chunk.append(byte)
+                dropsLeadingLineFeed = byte == 0x0D
+            }
+            consumedBytes = end
+        }
+
+        if consumedBytes == source.count {
+            isFinished = true
+            if bracketedPasteEnabled {
+                chunk.append(contentsOf: PasteHandler.bracketedPasteEnd.utf8)
+            }
+        }
+        return chunk
+    }
+
+    /// Ends a paste cut short, so a bracketed paste is not left open on the
+    /// remote side. Nil when nothing needs sending.
+    mutating func cancel() -> [UInt8]? {
+        guard !isFinished else { return nil }
+        isFinished = true
+        guard bracketedPasteEnabled, hasStarted else { return nil }
+        return Array(PasteHandler.bracketedPasteEnd.utf8)
+    }
+}
@@ -0,0 +1,82 @@
+// CSIFastPath.swift
+// ProSSHV2
+//
+// Whole-sequence recognizer for the short CSI sequences that dominate TUI
+// traffic between text runs: ESC[m, ESC[0m, ESC[1;31m, ESC[38;5;Nm,
+// ESC[H, ESC[row;colH, ESC[K, ESC[2J and relative cursor moves.
+//
+// TerminalEngine.feed calls `scan` when it meets ESC in ground state. A
+// sequence made only of digits and semicolons, complete within the chunk
+// and ending in one of `fastFinalBytes`, is parsed straight from the byte
+// span and dispatched through CSIHandler without walking the state
+// machine byte by byte. Anything else — private markers, intermediates,
+// colon subparameters, embedded controls, a sequence split across chunks —
+// returns nil and the full parser handles it unchanged.
+
+import Foundation
+
+// MARK: - CSIFastPath
+
+nonisolated enum CSIFastPath {
+
+    /// Final bytes whose CSIHandler dispatch is synchronous and common.
+    /// m (SGR), H/f (CUP/HVP), K (EL), J (ED), A–D (cursor moves),
+    /// G (CHA), d (VPA).
+    @inline(__always)
+    static func isFastFinalByte(_ byte: UInt8) -> Bool {
+        switch byte {
+        case 0x6D, 0x48, 0x66, 0x4B, 0x4A, 0x41, 0x42, 0x43, 0x44, 0x47, 0x64:
+            return true
+        default:
+            return false
+        }
+    }
+
+    /// Longest sequence considered, ESC and final byte included. Covers
+    /// `ESC[0;1;38;2;255;255;255;48;2;255;255;255m` with room to spare.
+    static let maxSequenceLength = 64
+
+    /// Recognize a simple CSI sequence starting with ESC at `start`.
+    /// On success, fills `params` exactly as the state machine would
+    /// (omitted parameters become `ParserLimits.defaultParam`) and returns
+    /// the final byte and the index just past it.
+    static func scan(
+        _ bytes: UnsafeRawBufferPointer,
+        at start: Int,
+        into params: inout CSIParams
+    ) -> (finalByte: UInt8, end: Int)? {
+        let count = bytes.count
+        guard start + 2 < count, bytes[start] == 0x1B, bytes[start + 1] == 0x5B else {
+            return nil
+        }
+
+        params.removeAll()
+        var value = 0
+        var hasValue = false
+        var index = start + 2
+        let limit = min(count, start + maxSequenceLength)
+
+        while index < limit {
+            let byte = bytes[index]
+            switch byte {
+            case 0x30...0x39:
+                value = min(value * 10 + Int(byte - 0x30), ParserLimits.maxParamValue)
+                hasValue = true
+            case 0x3B:
+                guard params.count < ParserLimits.maxParams else { return nil }
+                params.appendParam(hasValue ? value : ParserLimits.defaultParam)
+                value = 0
+                hasValue = false
+            default:
+                guard isFastFinalByte(byte) else { return nil }
+                if hasValue || !params.isEmpty {
+                    guard params.count < ParserLimits.maxParams else { return nil }
+                    params.appendParam(hasValue ? value : ParserLimits.defaultParam)
+                }
+                return (byte, index + 1)
+            }
+            index += 1
+        }
+        return nil
+    }
+}
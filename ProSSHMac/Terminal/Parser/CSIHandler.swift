@@ -8,6 +8,9 @@
 // The final byte (0x40–0x7E) determines the action.
 // Parameters are semicolon-separated integers; missing = 0.
 // Private marker '?' prefixes DEC private modes.
+//
+// Dispatch is synchronous. Sequences that need to suspend (replies to the
+// host, InputModeState sync) return a ParserEffect for TerminalEngine.
 
 import Foundation
 
@@ -15,6 +18,7 @@ import Foundation
 
 /// Namespace for CSI sequence dispatch.
 /// All methods are static and take the grid + parsed parameters.
+/// Returns the follow-up effect, if any, for TerminalEngine to await.
 nonisolated enum CSIHandler {
 
     // MARK: - Main Dispatch
@@ -23,13 +27,11 @@ nonisolated enum CSIHandler {
     /// Called from VTParser when a CSI sequence is complete.
     static func dispatch(
         byte: UInt8,
-        params: [[Int]],
+        params: CSIParams,
         privateMarker: UInt8,
         intermediates: [UInt8],
-        grid: TerminalGrid,
-        responseHandler: (([UInt8]) async -> Void)?,
-        inputModeState: InputModeState? = nil
-    ) async {
+        grid: TerminalGrid
+    ) -> ParserEffect? {
         let isPrivate = privateMarker == ByteRange.questionMark
 
         // DECRQM: CSI ? Ps $ p — Request Mode (DEC private).
@@ -39,25 +41,15 @@ nonisolated enum CSIHandler {
         // support; without a response it may fall back to un-synced output.
         if isPrivate && !intermediates.isEmpty {
             if intermediates.first == 0x24 && byte == 0x70 {
-                await handleDECRQM(
-                    params: params,
-                    grid: grid,
-                    responseHandler: responseHandler
-                )
+                return handleDECRQM(params: params, grid: grid)
             }
             // Any other CSI ? ... <intermediate> <final> — silently ignore.
-            return
+            return nil
         }
 
         // DEC private modes: CSI ? Ps h / CSI ? Ps l
         if isPrivate {
-            await dispatchPrivateMode(
-                byte: byte,
-                params: params,
-                grid: grid,
-                inputModeState: inputModeState
-            )
-            return
+            return dispatchPrivateMode(byte: byte, params: params, grid: grid)
         }
 
         // Secondary DA: CSI > c — respond with terminal identification.
@@ -65,10 +57,7 @@ nonisolated enum CSIHandler {
         // terminal capabilities.
         if privateMarker == ByteRange.greaterThan && byte == 0x63 {
             let p0 = param(params, 0, default: 0, raw: true)
-            if p0 == 0 {
-                await responseHandler?(DeviceAttributes.secondaryResponse)
-            }
-            return
+            return p0 == 0 ? .reply(DeviceAttributes.secondaryResponse) : nil
         }
 
         // Other private markers (>, <, =) from Kitty keyboard protocol,
@@ -77,40 +66,34 @@ nonisolated enum CSIHandler {
         // would be misinterpreted as CSI u (restore cursor), and
         // CSI > 4;1 m (xterm modifier) would corrupt SGR attributes.
         if privateMarker != 0 {
-            return
+            return nil
         }
 
         // CSI with intermediate bytes (e.g., CSI ! p = DECSTR, CSI Ps SP q = DECSCUSR)
         if !intermediates.isEmpty {
-            await dispatchWithIntermediate(
+            return dispatchWithIntermediate(
                 byte: byte,
                 params: params,
                 intermediates: intermediates,
-                grid: grid,
-                inputModeState: inputModeState
+                grid: grid
             )
-            return
         }
 
         // Standard CSI sequences (SGR gets full params for subparameter support)
         if byte == 0x6D { // CSI m — SGR
             SGRHandler.handle(params: params, grid: grid)
-        } else {
-            await dispatchStandard(
-                byte: byte, params: params, grid: grid,
-                responseHandler: responseHandler
-            )
+            return nil
         }
+        return dispatchStandard(byte: byte, params: params, grid: grid)
     }
 
     // MARK: - A.10.1–A.10.20 Standard CSI Sequences
 
     private static func dispatchStandard(
         byte: UInt8,
-        params: [[Int]],
-        grid: TerminalGrid,
-        responseHandler: (([UInt8]) async -> Void)?
-    ) async {
+        params: CSIParams,
+        grid: TerminalGrid
+    ) -> ParserEffect? {
         let p0 = param(params, 0, default: 1)
         let p0raw = param(params, 0, default: 0, raw: true)
 
@@ -204,11 +187,11 @@ nonisolated enum CSIHandler {
 
         // A.10.16 — DSR (Device Status Report)
         case 0x6E: // CSI n
-            await handleDSR(params: params, grid: grid, responseHandler: responseHandler)
+            return handleDSR(params: params, grid: grid)
 
         // A.10.17 — DA (Device Attributes)
         case 0x63: // CSI c
-            await handleDA(params: params, responseHandler: responseHandler)
+            return handleDA(params: params)
 
         // A.10.18 — SM/RM (Set/Reset Mode)
         case 0x68: // CSI h — SM
@@ -222,9 +205,14 @@ nonisolated enum CSIHandler {
         case 0x75: // CSI u — RCP
             grid.restoreCursor()
 
+        // XTWINOPS size reports (image tools size their output from these)
+        case 0x74: // CSI t
+            return handleWindowReport(params: params, grid: grid)
+
         default:
             break // Unknown CSI — ignore
         }
+        return nil
     }
 
     // MARK: - A.10.19 DEC Private Modes (DECSET/DECRST)
@@ -232,64 +220,23 @@ nonisolated enum CSIHandler {
     /// Dispatch CSI ? sequences (DECSET/DECRST).
     private static func dispatchPrivateMode(
         byte: UInt8,
-        params: [[Int]],
-        grid: TerminalGrid,
-        inputModeState: InputModeState?
-    ) async {
+        params: CSIParams,
+        grid: TerminalGrid
+    ) -> ParserEffect? {
+        let enabled: Bool
         switch byte {
         case 0x68: // CSI ? h — DECSET
-            if params.count == 1 {
-                await setPrivateMode(
-                    params[0].first ?? 0,
-                    enabled: true,
-                    grid: grid,
-                    inputModeState: inputModeState
-                )
-                return
-            }
-            for group in params {
-                await setPrivateMode(
-                    group.first ?? 0,
-                    enabled: true,
-                    grid: grid,
-                    inputModeState: inputModeState
-                )
-            }
+            enabled = true
         case 0x6C: // CSI ? l — DECRST
-            if params.count == 1 {
-                await setPrivateMode(
-                    params[0].first ?? 0,
-                    enabled: false,
-                    grid: grid,
-                    inputModeState: inputModeState
-                )
-                return
-            }
-            for group in params {
-                await setPrivateMode(
-                    group.first ?? 0,
-                    enabled: false,
-                    grid: grid,
-                    inputModeState: inputModeState
-                )
-            }
+            enabled = false
         default:
-            break
+            return nil
         }
-    }
-
-    /// Set or reset a single DEC private mode.
-    private static func setPrivateMode(
-        _ mode: Int,
-        enabled: Bool,
-        grid: TerminalGrid,
-        inputModeState: InputModeState?
-    ) async {
-        grid.applyDECPrivateMode(mode, enabled: enabled)
-        if let inputModeState {
-            let snap = grid.inputModeSnapshot()
-            await inputModeState.syncFromSnapshot(snap)
+        guard !params.isEmpty else { return nil }
+        for group in 0..<params.count {
+            grid.applyDECPrivateMode(params[group], enabled: enabled)
         }
+        return .syncInputModes
     }
 
     // MARK: - A.10.21 DECSTR (Soft Reset)
@@ -297,19 +244,15 @@ nonisolated enum CSIHandler {
     /// Dispatch CSI with intermediate bytes.
     private static func dispatchWithIntermediate(
         byte: UInt8,
-        params: [[Int]],
+        params: CSIParams,
         intermediates: [UInt8],
-        grid: TerminalGrid,
-        inputModeState: InputModeState?
-    ) async {
-        guard let intermediate = intermediates.first else { return }
+        grid: TerminalGrid
+    ) -> ParserEffect? {
+        guard let intermediate = intermediates.first else { return nil }
 
         if intermediate == 0x21 && byte == 0x70 { // CSI ! p — DECSTR
             grid.softReset()
-            if let inputModeState {
-                let snap = grid.inputModeSnapshot()
-                await inputModeState.syncFromSnapshot(snap)
-            }
+            return .syncInputModes
         } else if intermediate == 0x20 && byte == 0x71 { // CSI Ps SP q — DECSCUSR (cursor style)
             let p = param(params, 0, default: 0, raw: true)
             // 0/1 = blinking block, 2 = steady block,
@@ -329,17 +272,14 @@ nonisolated enum CSIHandler {
                 break
             }
         }
+        return nil
     }
 
     // MARK: - DECRQM (Request Mode — DEC Private)
 
     /// Handle CSI ? Ps $ p — respond with CSI ? Ps ; Pm $ y
     /// where Pm indicates: 0=not recognized, 1=set, 2=reset.
-    private static func handleDECRQM(
-        params: [[Int]],
-        grid: TerminalGrid,
-        responseHandler: (([UInt8]) async -> Void)?
-    ) async {
+    private static func handleDECRQM(params: CSIParams, grid: TerminalGrid) -> ParserEffect {
         let mode = param(params, 0, default: 0, raw: true)
         let pm: Int
 
@@ -382,46 +322,65 @@ nonisolated enum CSIHandler {
         response.append(0x3B) // ;
         appendDecimal(pm, to: &response)
         response.append(contentsOf: [0x24, 0x79]) // $y
-        await responseHandler?(response)
+        return .reply(response)
     }
 
     // MARK: - A.10.16 DSR Handler
 
-    private static func handleDSR(
-        params: [[Int]],
-        grid: TerminalGrid,
-        responseHandler: (([UInt8]) async -> Void)?
-    ) async {
+    private static func handleDSR(params: CSIParams, grid: TerminalGrid) -> ParserEffect? {
         let code = param(params, 0, default: 0, raw: true)
-        if code == 6 {
-            // Cursor Position Report: CSI row ; col R (1-based)
-            let pos = grid.cursorPosition()
-            var response: [UInt8] = [0x1B, 0x5B] // ESC [
-            appendDecimal(pos.row + 1, to: &response)
-            response.append(0x3B) // ;
-            appendDecimal(pos.col + 1, to: &response)
-            response.append(0x52) // R
-            await responseHandler?(response)
+        guard code == 6 else { return nil }
+
+        // Cursor Position Report: CSI row ; col R (1-based)
+        let pos = grid.cursorPosition()
+        var response: [UInt8] = [0x1B, 0x5B] // ESC [
+        appendDecimal(pos.row + 1, to: &response)
+        response.append(0x3B) // ;
+        appendDecimal(pos.col + 1, to: &response)
+        response.append(0x52) // R
+        return .reply(response)
+    }
+
+    // MARK: - XTWINOPS Size Reports
+
+    /// CSI 14 t (text area in pixels), CSI 16 t (cell in pixels) and
+    /// CSI 18 t (text area in cells). Window manipulation is not supported.
+    private static func handleWindowReport(params: CSIParams, grid: TerminalGrid) -> ParserEffect? {
+        let cell = grid.inlineImages.cellSize
+        let report: (Int, Int, Int)
+        switch param(params, 0, default: 0, raw: true) {
+        case 14:
+            report = (4, grid.rows * cell.height, grid.columns * cell.width)
+        case 16:
+            report = (6, cell.height, cell.width)
+        case 18:
+            report = (8, grid.rows, grid.columns)
+        default:
+            return nil
         }
+        // Response: CSI code ; height ; width t
+        var response: [UInt8] = [0x1B, 0x5B] // ESC [
+        appendDecimal(report.0, to: &response)
+        response.append(0x3B) // ;
+        appendDecimal(report.1, to: &response)
+        response.append(0x3B) // ;
+        appendDecimal(report.2, to: &response)
+        response.append(0x74) // t
+        return .reply(response)
     }
 
     // MARK: - A.10.17 DA Handler
 
-    private static func handleDA(
-        params: [[Int]],
-        responseHandler: (([UInt8]) async -> Void)?
-    ) async {
+    private static func handleDA(params: CSIParams) -> ParserEffect? {
         let p0 = param(params, 0, default: 0, raw: true)
-        if p0 == 0 {
-            await responseHandler?(DeviceAttributes.primaryResponse)
-        }
+        return p0 == 0 ? .reply(DeviceAttributes.primaryResponse) : nil
     }
 
     // MARK: - A.10.18 SM/RM (ANSI Modes)
 
-    private static func handleSetMode(params: [[Int]], grid: TerminalGrid) {
-        for group in params {
-            switch group.first ?? 0 {
+    private static func handleSetMode(params: CSIParams, grid: TerminalGrid) {
+        for group in 0..<params.count {
+            switch params[group] {
             case ANSIMode.IRM:
                 grid.setInsertMode(true)
             case ANSIMode.LNM:
@@ -432,9 +391,9 @@ nonisolated enum CSIHandler {
         }
     }
 
-    private static func handleResetMode(params: [[Int]], grid: TerminalGrid) {
-        for group in params {
-            switch group.first ?? 0 {
+    private static func handleResetMode(params: CSIParams, grid: TerminalGrid) {
+        for group in 0..<params.count {
+            switch params[group] {
             case ANSIMode.IRM:
                 grid.setInsertMode(false)
             case ANSIMode.LNM:
@@ -448,14 +407,15 @@ nonisolated enum CSIHandler {
     // MARK: - Parameter Helpers
 
     /// Get parameter at index with a default value.
-    /// Extracts the first element of each subparameter group (inline flatParams).
+    /// Reads the first value of the subparameter group.
     /// When raw is false (default), 0 is treated as "not specified" and replaced by defaultValue.
     /// When raw is true, 0 is kept as 0.
+    @inline(__always)
     private static func param(
-        _ params: [[Int]], _ index: Int, default defaultValue: Int, raw: Bool = false
+        _ params: CSIParams, _ index: Int, default defaultValue: Int, raw: Bool = false
     ) -> Int {
         guard index < params.count else { return defaultValue }
-        let v = params[index].first ?? 0
+        let v = params[index]
         if raw { return v }
         return v == 0 ? defaultValue : v
     }
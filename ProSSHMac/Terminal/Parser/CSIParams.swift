@@ -0,0 +1,104 @@
+// CSIParams.swift
+// ProSSHV2
+//
+// Fixed-capacity, inline storage for CSI/DCS parameters.
+//
+// Parameters used to be collected into `[[Int]]`, one heap array per
+// top-level parameter, re-copied on every colon subparameter. Colour-heavy
+// output (`ls --color`, `bat`, compiler diagnostics) is mostly SGR, so the
+// parser now keeps every value in one flat `InlineArray<32, UInt16>` with a
+// parallel table of group start offsets. Nothing is allocated per sequence,
+// and the struct is copied by value into handlers and DCS hook state.
+//
+// Layout: "38:2::255:0:0;1" → values [38, 2, 0, 255, 0, 0, 1],
+// groupStarts [0, 6], count 2.
+
+import Foundation
+
+// MARK: - CSIParams
+
+nonisolated struct CSIParams: Sendable {
+
+    /// Maximum number of values across all groups, subparameters included.
+    static let capacity = 32
+
+    private var values = InlineArray<32, UInt16>(repeating: 0)
+    private var groupStarts = InlineArray<16, UInt8>(repeating: 0)
+
+    /// Number of values stored, subparameters included.
+    private(set) var valueCount = 0
+
+    /// Number of top-level (semicolon-separated) parameters.
+    private(set) var count = 0
+
+    var isEmpty: Bool { count == 0 }
+
+    init() {}
+
+    /// Build from nested groups, e.g. `[[38, 2, 0, 255, 0, 0], [1]]` (tests, debugging).
+    init(_ groups: [[Int]]) {
+        for group in groups {
+            guard let first = group.first else { continue }
+            appendParam(first)
+            for value in group.dropFirst() {
+                appendSubparam(value)
+            }
+        }
+    }
+
+    // MARK: - Collection
+
+    /// Start a new top-level parameter. Dropped once `ParserLimits.maxParams`
+    /// groups or `capacity` values are stored.
+    @inline(__always)
+    mutating func appendParam(_ value: Int) {
+        guard count < ParserLimits.maxParams, valueCount < Self.capacity else { return }
+        groupStarts[count] = UInt8(valueCount)
+        values[valueCount] = UInt16(clamping: value)
+        valueCount += 1
+        count += 1
+    }
+
+    /// Append a colon subparameter to the last top-level parameter.
+    @inline(__always)
+    mutating func appendSubparam(_ value: Int) {
+        guard count > 0, valueCount < Self.capacity else { return }
+        values[valueCount] = UInt16(clamping: value)
+        valueCount += 1
+    }
+
+    @inline(__always)
+    mutating func removeAll() {
+        valueCount = 0
+        count = 0
+    }
+
+    // MARK: - Access
+
+    /// Value `sub` of top-level parameter `group` (0 is the parameter itself).
+    /// Callers bounds-check with `count` and `groupLength(_:)`.
+    @inline(__always)
+    subscript(group: Int, sub: Int = 0) -> Int {
+        Int(values[Int(groupStarts[group]) + sub])
+    }
+
+    /// Number of values in `group`: 1 plus its subparameter count.
+    @inline(__always)
+    func groupLength(_ group: Int) -> Int {
+        let start = Int(groupStarts[group])
+        let end = group + 1 < count ? Int(groupStarts[group + 1]) : valueCount
+        return end - start
+    }
+
+    /// First value of each group, for sequences without subparameters.
+    var firstValues: [Int] {
+        (0..<count).map { self[$0] }
+    }
+
+    /// Nested representation, matching the old `[[Int]]` layout.
+    var groups: [[Int]] {
+        (0..<count).map { group in
+            (0..<groupLength(group)).map { self[group, $0] }
+        }
+    }
+}
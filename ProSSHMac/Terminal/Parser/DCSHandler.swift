@@ -12,6 +12,7 @@
 // Supports:
 // - A.14.1 Passthrough mode (hook/put/unhook lifecycle)
 // - A.14.2 DECRQSS (Request Status String — DCS $ q <selector> ST)
+// - DECSIXEL (DCS <P1;P2;P3> q <sixel data> ST), see InlineImageHandler
 
 import Foundation
 
@@ -27,15 +28,15 @@ nonisolated enum DCSHandler {
     /// Flatten subparameter groups into a simple [Int] array.
     /// DCS sequences don't use subparameters, so we just take
     /// the first element of each group.
-    private static func flatParams(_ params: [[Int]]) -> [Int] {
-        params.map { $0.first ?? 0 }
+    private static func flatParams(_ params: CSIParams) -> [Int] {
+        params.firstValues
     }
 
     /// Hook: called when DCS sequence begins.
     /// Stores the parameters and intermediates for later use during unhook.
     /// Currently a no-op — actual hook handling can be added for specific DCS types.
     static func hook(
-        params: [[Int]],
+        params: CSIParams,
         intermediates: [UInt8],
         finalByte: UInt8,
         grid: TerminalGrid
@@ -50,14 +51,16 @@ nonisolated enum DCSHandler {
     ///
     /// - Parameters:
     ///   - data: Raw bytes collected during DCS passthrough
-    ///   - params: Parameters from the DCS entry (nested subparam groups)
+    ///   - params: Parameters from the DCS entry
     ///   - intermediates: Intermediate bytes from the DCS entry
+    ///   - finalByte: Final byte from the DCS entry
     ///   - grid: The terminal grid
     ///   - responseHandler: Closure for sending responses back to the host
     static func unhook(
         data: [UInt8],
-        params: [[Int]],
+        params: CSIParams,
         intermediates: [UInt8],
+        finalByte: UInt8,
         grid: TerminalGrid,
         responseHandler: (([UInt8]) async -> Void)?
     ) async {
@@ -70,10 +73,17 @@ nonisolated enum DCSHandler {
             return
         }
 
+        // DCS <params> q ... ST = DECSIXEL
+        if intermediates.isEmpty && finalByte == 0x71 { // 'q'
+            InlineImageHandler.handleSixel(data, params: flatParams(params), grid: grid)
+            return
+        }
+
         // Other DCS types can be added here:
-        // - DECSIXEL (DCS <params> q <sixel data> ST) — sixel graphics
         // - DECUDK (DCS <params> | <key definitions> ST) — user-defined keys
-        // - DECTMUX (DCS 1000p ... ST) — tmux control mode
+        //
+        // tmux control mode (DCS 1000p) never reaches here when enabled:
+        // TmuxControlParser takes the stream before the engine.
         //
         // For now, unknown DCS sequences are silently ignored.
     }
@@ -34,19 +34,19 @@ nonisolated enum ESCHandler {
     ///   - byte: The final byte of the ESC sequence
     ///   - intermediates: Collected intermediate bytes (0x20–0x2F)
     ///   - grid: The terminal grid to drive
+    /// - Returns: The InputModeState follow-up for RIS / DECKPAM / DECKPNM.
     static func dispatch(
         byte: UInt8,
         intermediates: [UInt8],
-        grid: TerminalGrid,
-        inputModeState: InputModeState? = nil
-    ) async {
+        grid: TerminalGrid
+    ) -> ParserEffect? {
         if let intermediate = intermediates.first {
             dispatchWithIntermediate(
                 intermediate: intermediate, final: byte, grid: grid
             )
-        } else {
-            await dispatchFinal(byte, grid: grid, inputModeState: inputModeState)
+            return nil
         }
+        return dispatchFinal(byte, grid: grid)
     }
 
     // MARK: - ESC Without Intermediates
@@ -54,9 +54,8 @@ nonisolated enum ESCHandler {
     /// Handle ESC sequences with no intermediate bytes.
     private static func dispatchFinal(
         _ byte: UInt8,
-        grid: TerminalGrid,
-        inputModeState: InputModeState?
-    ) async {
+        grid: TerminalGrid
+    ) -> ParserEffect? {
         switch byte {
 
         // A.15.1 — DECSC / DECRC (Save / Restore Cursor)
@@ -80,7 +79,7 @@ nonisolated enum ESCHandler {
         // A.15.3 — RIS (Full Reset)
         case 0x63: // ESC c — RIS
             grid.fullReset()
-            await inputModeState?.applyFullReset()
+            return .resetInputModes
 
         // A.15.4 — HTS (Set Tab Stop)
         case 0x48: // ESC H — HTS
@@ -89,15 +88,16 @@ nonisolated enum ESCHandler {
         // A.15.5 — DECKPAM / DECKPNM (Keypad Modes)
         case 0x3D: // ESC = — DECKPAM (Application Keypad Mode)
             grid.setApplicationKeypad(true)
-            await inputModeState?.setApplicationKeypad(true)
+            return .setApplicationKeypad(true)
 
         case 0x3E: // ESC > — DECKPNM (Normal Keypad Mode)
             grid.setApplicationKeypad(false)
-            await inputModeState?.setApplicationKeypad(false)
+            return .setApplicationKeypad(false)
 
         default:
             break // Unknown ESC sequence — ignore
         }
+        return nil
     }
 
     // MARK: - ESC With Intermediate Bytes
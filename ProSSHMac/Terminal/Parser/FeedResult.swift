@@ -0,0 +1,68 @@
+// FeedResult.swift
+// ProSSHV2
+//
+// Everything the publish path needs after a parser-reader batch, captured
+// by TerminalEngine in the same actor turn as the feed itself.
+//
+// SessionShellIOCoordinator used to follow each `feed` with separate awaits
+// for the input mode snapshot, sync-exit snapshots, the sync flag and a
+// live snapshot. `feedCollecting` returns all of it at once, and results
+// from batches parsed while the MainActor is busy are merged so the
+// rendering side sees one combined update instead of one per batch.
+
+import Foundation
+
+// MARK: - FeedResult
+
+nonisolated struct FeedResult: Sendable {
+    /// False when the bytes were queued behind an in-progress feed; that
+    /// feeder publishes once it has drained the queue.
+    var didProcess = false
+    var inputModeSnapshot: InputModeSnapshot
+    /// Synchronized-output frames consumed from the grid, oldest first.
+    var syncExitSnapshots: [GridSnapshot] = []
+    var synchronizedOutput = false
+    var usingAlternateBuffer = false
+    /// Live frame captured while synchronized output is active; nil otherwise.
+    var liveSyncSnapshot: GridSnapshot?
+    /// Rows touched since the last snapshot, or nil when nothing is dirty.
+    var dirtyRows: ClosedRange<Int>?
+
+    init(
+        didProcess: Bool,
+        inputModeSnapshot: InputModeSnapshot,
+        syncExitSnapshots: [GridSnapshot] = [],
+        synchronizedOutput: Bool = false,
+        usingAlternateBuffer: Bool = false,
+        liveSyncSnapshot: GridSnapshot? = nil,
+        dirtyRows: ClosedRange<Int>? = nil
+    ) {
+        self.didProcess = didProcess
+        self.inputModeSnapshot = inputModeSnapshot
+        self.syncExitSnapshots = syncExitSnapshots
+        self.synchronizedOutput = synchronizedOutput
+        self.usingAlternateBuffer = usingAlternateBuffer
+        self.liveSyncSnapshot = liveSyncSnapshot
+        self.dirtyRows = dirtyRows
+    }
+
+    /// Fold a later result into this one. Sync-exit frames accumulate in
+    /// order and dirty rows are unioned; mode flags and snapshots take the
+    /// later value. Queued (`didProcess == false`) results carry no state.
+    mutating func merge(_ later: FeedResult) {
+        guard later.didProcess else { return }
+        didProcess = true
+        inputModeSnapshot = later.inputModeSnapshot
+        syncExitSnapshots.append(contentsOf: later.syncExitSnapshots)
+        synchronizedOutput = later.synchronizedOutput
+        usingAlternateBuffer = later.usingAlternateBuffer
+        liveSyncSnapshot = later.liveSyncSnapshot
+        if let rows = later.dirtyRows {
+            if let current = dirtyRows {
+                dirtyRows = min(current.lowerBound, rows.lowerBound)...max(current.upperBound, rows.upperBound)
+            } else {
+                dirtyRows = rows
+            }
+        }
+    }
+}
@@ -0,0 +1,387 @@
+// InlineImageHandler.swift
+// ProSSHV2
+//
+// Handles the three inline image protocols (see InlineImage.swift).
+// Parsing stays on the parser's queue, but it only reads arguments and the
+// image's pixel size. The payload goes to InlineImageStore to be decoded,
+// and the grid reserves cells for the image at once.
+//
+// Supports:
+// - Sixel: DCS P1 ; P2 ; P3 q <data> ST, with P2 = 1 for a transparent
+//   background
+// - iTerm2: OSC 1337 ; File=<args> : <base64> ST with inline=1, where
+//   width/height are N (cells), Npx, N% or auto, plus preserveAspectRatio
+// - kitty graphics: APC G <keys> ; <payload> ST, direct transmission only
+//   (t=d), in formats f=24, 32 and 100. Covers chunking (m=1), zlib (o=z),
+//   the transmit, put, query and delete actions (a=t/T/p/q/d), placement
+//   size (c, r), C=1 and the OK/error replies q= controls. File and
+//   shared-memory transmission name paths on the remote host, so they get
+//   an error reply.
+
+import Foundation
+
+// MARK: - InlineImageHandler
+
+nonisolated enum InlineImageHandler {
+
+    /// OSC payload prefix of an iTerm2 image.
+    static let iTermFilePrefix: [UInt8] = Array("1337;File=".utf8)
+
+    // MARK: - Sixel
+
+    /// Place a sixel image (DCS ... q). `params` are the DCS parameters.
+    static func handleSixel(_ data: [UInt8], params: [Int], grid: TerminalGrid) {
+        guard let size = SixelDecoder.measure(data) else { return }
+        let transparent = params.count > 1 && params[1] == 1
+        let id = InlineImageID.next()
+        InlineImageStore.shared.submit(
+            InlineImagePayload(encoding: .sixel(transparentBackground: transparent), bytes: data, isBase64: false),
+            for: id
+        )
+        place(id, pixelWidth: size.width, pixelHeight: size.height, cursorMovement: .belowImage, grid: grid)
+    }
+
+    // MARK: - iTerm2 (OSC 1337 File=)
+
+    /// Place an iTerm2 inline image. `oscString` is the whole OSC payload,
+    /// starting with `iTermFilePrefix`.
+    static func handleITermFile(_ oscString: [UInt8], grid: TerminalGrid) {
+        guard let colon = oscString[iTermFilePrefix.count...].firstIndex(of: 0x3A) else { return } // ':'
+        let argumentText = String(decoding: oscString[iTermFilePrefix.count..<colon], as: UTF8.self)
+        var arguments: [String: String] = [:]
+        for pair in argumentText.split(separator: ";") {
+            let parts = pair.split(separator: "=", maxSplits: 1)
+            if parts.count == 2 {
+                arguments[String(parts[0])] = String(parts[1])
+            }
+        }
+        // Downloads (inline=0, the default) are not supported.
+        guard arguments["inline"] == "1" else { return }
+
+        let base64 = Array(oscString[(colon + 1)...])
+        guard let size = InlineImageHeader.pixelSize(ofBase64: base64) else { return }
+        let id = InlineImageID.next()
+        InlineImageStore.shared.submit(InlineImagePayload(encoding: .file, bytes: base64, isBase64: true), for: id)
+
+        let cell = grid.inlineImages.cellSize
+        let available = grid.columns - grid.cursor.col
+        var width = iTermLength(arguments["width"], cellPixels: cell.width, totalCells: grid.columns)
+        var height = iTermLength(arguments["height"], cellPixels: cell.height, totalCells: grid.rows)
+        let preservesAspect = arguments["preserveAspectRatio"] != "0"
+        let aspect = Double(size.width) / Double(size.height)
+        switch (width, height) {
+        case (nil, nil):
+            width = Double(size.width)
+            height = Double(size.height)
+        case (let w?, nil):
+            height = preservesAspect ? w / aspect : Double(size.height)
+        case (nil, let h?):
+            width = preservesAspect ? h * aspect : Double(size.width)
+        case (let w?, let h?):
+            if preservesAspect {
+                let scale = min(w / Double(size.width), h / Double(size.height))
+                width = Double(size.width) * scale
+                height = Double(size.height) * scale
+            }
+        }
+        guard var pixelWidth = width, var pixelHeight = height else { return }
+        // Wider than the rest of the line: shrink to fit, as iTerm2 does.
+        let maxWidth = Double(max(available, 1) * cell.width)
+        if pixelWidth > maxWidth {
+            if preservesAspect {
+                pixelHeight *= maxWidth / pixelWidth
+            }
+            pixelWidth = maxWidth
+        }
+        place(
+            id,
+            pixelWidth: max(Int(pixelWidth.rounded()), 1),
+            pixelHeight: max(Int(pixelHeight.rounded()), 1),
+            cursorMovement: .afterImage,
+            grid: grid
+        )
+    }
+
+    /// An iTerm2 width or height in pixels: N cells, Npx, N% of the
+    /// terminal, or nil for auto.
+    private static func iTermLength(_ value: String?, cellPixels: Int, totalCells: Int) -> Double? {
+        guard let value, value != "auto" else { return nil }
+        if value.hasSuffix("px") {
+            return Double(value.dropLast(2)).map { max($0, 1) }
+        }
+        if value.hasSuffix("%") {
+            return Double(value.dropLast()).map { max($0, 1) / 100 * Double(totalCells * cellPixels) }
+        }
+        return Double(value).map { max($0, 1) * Double(cellPixels) }
+    }
+
+    // MARK: - kitty Graphics (APC G)
+
+    /// Handle one kitty graphics command, replying through
+    /// `responseHandler` unless the command's q= silences it.
+    static func handleKittyCommand(
+        _ apcData: [UInt8],
+        grid: TerminalGrid,
+        responseHandler: (([UInt8]) async -> Void)?
+    ) async {
+        guard apcData.first == 0x47 else { return } // 'G'
+        let separator = apcData.firstIndex(of: 0x3B) ?? apcData.endIndex // ';'
+        var keys = parseKittyKeys(apcData[1..<separator])
+        let chunk = separator < apcData.endIndex ? apcData[(separator + 1)...] : []
+        var payload = Array(chunk)
+
+        // Chunks after the first carry only m= (and q=); the first chunk's
+        // keys describe the image.
+        if var transmission = grid.inlineImages.kittyTransmission {
+            grid.inlineImages.kittyTransmission = nil
+            guard transmission.payload.count + payload.count <= ParserLimits.maxImagePayloadLength else {
+                await kittyReply(transmission.keys, error: "EFBIG:image too large", responseHandler: responseHandler)
+                return
+            }
+            transmission.payload += payload
+            if keys["m"] == "1" {
+                grid.inlineImages.kittyTransmission = transmission
+                return
+            }
+            keys = transmission.keys
+            payload = transmission.payload
+        } else if keys["m"] == "1" {
+            grid.inlineImages.kittyTransmission = InlineImageState.KittyTransmission(keys: keys, payload: payload)
+            return
+        }
+
+        switch keys["a"] ?? "t" {
+        case "t", "T", "q":
+            await kittyTransmit(keys, payload: payload, grid: grid, responseHandler: responseHandler)
+        case "p":
+            await kittyPut(keys, grid: grid, responseHandler: responseHandler)
+        case "d":
+            kittyDelete(keys, grid: grid)
+        default:
+            break // Animation (a=f/a/c) is not supported.
+        }
+    }
+
+    /// a=t (transmit), a=T (transmit and display) and a=q (query: validate
+    /// without keeping anything).
+    private static func kittyTransmit(
+        _ keys: [UInt8: String],
+        payload: [UInt8],
+        grid: TerminalGrid,
+        responseHandler: (([UInt8]) async -> Void)?
+    ) async {
+        let action = keys["a"] ?? "t"
+        guard (keys["t"] ?? "d") == "d" else {
+            await kittyReply(keys, error: "EINVAL:only direct transmission is supported", responseHandler: responseHandler)
+            return
+        }
+        let compressed = keys["o"] == "z"
+        let encoding: InlineImagePayload.Encoding
+        let size: (width: Int, height: Int)?
+        switch keys["f"] ?? "32" {
+        case "24", "32":
+            let bytesPerPixel = keys["f"] == "24" ? 3 : 4
+            let width = Int(keys["s"] ?? "") ?? 0
+            let height = Int(keys["v"] ?? "") ?? 0
+            encoding = .rawPixels(width: width, height: height, bytesPerPixel: bytesPerPixel)
+            size = width > 0 && height > 0 ? (width, height) : nil
+        case "100":
+            encoding = .file
+            size = compressed ? compressedFileSize(payload) : InlineImageHeader.pixelSize(ofBase64: payload)
+        default:
+            await kittyReply(keys, error: "EINVAL:unsupported format", responseHandler: responseHandler)
+            return
+        }
+        guard let size else {
+            await kittyReply(keys, error: "EINVAL:image size unknown", responseHandler: responseHandler)
+            return
+        }
+        if action == "q" {
+            await kittyReply(keys, error: nil, responseHandler: responseHandler)
+            return
+        }
+
+        let kittyID = UInt32(keys["i"] ?? "") ?? 0
+        guard kittyID != 0 || action == "T" else {
+            return // Nothing could ever refer to it.
+        }
+        let id = InlineImageID.next()
+        InlineImageStore.shared.submit(
+            InlineImagePayload(encoding: encoding, bytes: payload, isBase64: true, isZlibCompressed: compressed),
+            for: id
+        )
+        if kittyID != 0 {
+            // A new image under an existing ID replaces it and its placements.
+            if let previous = grid.inlineImages.kittyImages[kittyID] {
+                grid.inlineImages.kittyImages[kittyID] = nil
+                grid.removeInlineImages { $0.imageID == previous.imageID }
+                grid.releaseUnreferencedImages([previous.imageID])
+            }
+            grid.inlineImages.kittyImages[kittyID] = InlineImageState.KittyImage(
+                imageID: id, pixelWidth: size.width, pixelHeight: size.height
+            )
+        }
+        if action == "T" {
+            kittyPlace(id, pixelWidth: size.width, pixelHeight: size.height, keys: keys, grid: grid)
+        }
+        await kittyReply(keys, error: nil, responseHandler: responseHandler)
+    }
+
+    /// a=p: display an image transmitted earlier.
+    private static func kittyPut(
+        _ keys: [UInt8: String],
+        grid: TerminalGrid,
+        responseHandler: (([UInt8]) async -> Void)?
+    ) async {
+        guard let kittyID = UInt32(keys["i"] ?? ""), let image = grid.inlineImages.kittyImages[kittyID] else {
+            await kittyReply(keys, error: "ENOENT:no such image", responseHandler: responseHandler)
+            return
+        }
+        kittyPlace(image.imageID, pixelWidth: image.pixelWidth, pixelHeight: image.pixelHeight, keys: keys, grid: grid)
+        await kittyReply(keys, error: nil, responseHandler: responseHandler)
+    }
+
+    private static func kittyPlace(
+        _ id: InlineImageID,
+        pixelWidth: Int,
+        pixelHeight: Int,
+        keys: [UInt8: String],
+        grid: TerminalGrid
+    ) {
+        let movement: InlineImageCursorMovement = keys["C"] == "1" ? .none : .afterImage
+        let placementID = UInt32(keys["p"] ?? "") ?? 0
+        let columns = Int(keys["c"] ?? "") ?? 0
+        let rows = Int(keys["r"] ?? "") ?? 0
+        guard columns > 0 || rows > 0 else {
+            place(id, pixelWidth: pixelWidth, pixelHeight: pixelHeight, cursorMovement: movement,
+                  kittyPlacementID: placementID, grid: grid)
+            return
+        }
+        // With c= or r=, the image is scaled to the cell box; a missing
+        // side follows the aspect ratio.
+        let cell = grid.inlineImages.cellSize
+        let aspect = Double(pixelWidth) / Double(pixelHeight)
+        let boxColumns = columns > 0
+            ? columns
+            : max(1, Int((Double(rows * cell.height) * aspect / Double(cell.width)).rounded(.up)))
+        let boxRows = rows > 0
+            ? rows
+            : max(1, Int((Double(columns * cell.width) / aspect / Double(cell.height)).rounded(.up)))
+        grid.placeInlineImage(
+            id,
+            columns: boxColumns,
+            rows: boxRows,
+            cursorMovement: movement,
+            kittyPlacementID: placementID
+        )
+    }
+
+    /// a=d. Lowercase deletes placements; uppercase frees the images too.
+    private static func kittyDelete(_ keys: [UInt8: String], grid: TerminalGrid) {
+        let target = keys["d"] ?? "a"
+        switch target {
+        case "a", "A":
+            grid.removeInlineImages { _ in true }
+            if target == "A" {
+                freeKittyImages(grid) { _ in true }
+            }
+        case "i", "I":
+            guard let kittyID = UInt32(keys["i"] ?? ""), let image = grid.inlineImages.kittyImages[kittyID] else { return }
+            let placementID = UInt32(keys["p"] ?? "") ?? 0
+            grid.removeInlineImages { placement in
+                placement.imageID == image.imageID && (placementID == 0 || placement.kittyPlacementID == placementID)
+            }
+            if target == "I" {
+                freeKittyImages(grid) { $0 == kittyID }
+            }
+        case "c", "C":
+            let column = grid.cursor.col
+            let line = grid.inlineImageLine(forRow: grid.cursor.row)
+            grid.removeInlineImages { placement in
+                placement.overlaps(lines: line..<(line + 1))
+                    && (placement.column..<(placement.column + placement.columns)).contains(column)
+            }
+            if target == "C" {
+                freeUnplacedKittyImages(grid)
+            }
+        default:
+            break
+        }
+    }
+
+    private static func freeKittyImages(_ grid: TerminalGrid, where predicate: (UInt32) -> Bool) {
+        let freed = grid.inlineImages.kittyImages.filter { predicate($0.key) }
+        for kittyID in freed.keys {
+            grid.inlineImages.kittyImages[kittyID] = nil
+        }
+        grid.releaseUnreferencedImages(freed.values.map(\.imageID))
+    }
+
+    private static func freeUnplacedKittyImages(_ grid: TerminalGrid) {
+        let placed = Set((grid.inlineImages.primary + grid.inlineImages.alternate).map(\.imageID))
+        let images = grid.inlineImages.kittyImages
+        freeKittyImages(grid) { images[$0].map { !placed.contains($0.imageID) } ?? false }
+    }
+
+    /// Keys are single characters; values are numbers or single characters.
+    private static func parseKittyKeys(_ bytes: ArraySlice<UInt8>) -> [UInt8: String] {
+        var keys: [UInt8: String] = [:]
+        for pair in bytes.split(separator: 0x2C) { // ','
+            guard pair.count >= 2, pair[pair.startIndex + 1] == 0x3D else { continue } // '='
+            keys[pair[pair.startIndex]] = String(decoding: pair[(pair.startIndex + 2)...], as: UTF8.self)
+        }
+        return keys
+    }
+
+    /// Pixel size of a zlib-compressed PNG (f=100, o=z). Rare enough that
+    /// inflating it here is acceptable.
+    private static func compressedFileSize(_ base64: [UInt8]) -> (width: Int, height: Int)? {
+        guard let data = Data(base64Encoded: Data(base64), options: .ignoreUnknownCharacters),
+              let inflated = InlineImageStore.inflate([UInt8](data)) else { return nil }
+        return InlineImageHeader.pixelSize(of: inflated)
+    }
+
+    /// ESC _ G i=<id>[,p=<placement>] ; OK|<error> ESC \. Sent only for
+    /// commands with an image ID; q=1 silences OK and q=2 everything.
+    private static func kittyReply(
+        _ keys: [UInt8: String],
+        error: String?,
+        responseHandler: (([UInt8]) async -> Void)?
+    ) async {
+        guard let responseHandler, let kittyID = keys["i"], kittyID != "0" else { return }
+        let quiet = Int(keys["q"] ?? "") ?? 0
+        if error == nil ? quiet >= 1 : quiet >= 2 { return }
+        var reply = "\u{1B}_Gi=\(kittyID)"
+        if let placementID = keys["p"] {
+            reply += ",p=\(placementID)"
+        }
+        reply += ";\(error ?? "OK")\u{1B}\\"
+        await responseHandler(Array(reply.utf8))
+    }
+
+    // MARK: - Placement
+
+    /// Cover the cells an image of this pixel size needs at the current
+    /// cell size, without scaling it.
+    private static func place(
+        _ id: InlineImageID,
+        pixelWidth: Int,
+        pixelHeight: Int,
+        cursorMovement: InlineImageCursorMovement,
+        kittyPlacementID: UInt32 = 0,
+        grid: TerminalGrid
+    ) {
+        let cell = grid.inlineImages.cellSize
+        let columns = max(1, (pixelWidth + cell.width - 1) / cell.width)
+        let rows = max(1, (pixelHeight + cell.height - 1) / cell.height)
+        grid.placeInlineImage(
+            id,
+            columns: columns,
+            rows: rows,
+            widthFraction: Float(pixelWidth) / Float(columns * cell.width),
+            heightFraction: Float(pixelHeight) / Float(rows * cell.height),
+            cursorMovement: cursorMovement,
+            kittyPlacementID: kittyPlacementID
+        )
+    }
+}
@@ -10,6 +10,7 @@
 // - A.13.3 Color palette query/set (OSC 4/10/11/12)
 // - A.13.4 Cursor color (OSC 12/112)
 // - A.13.5 Clipboard (OSC 52) — with security restrictions
+// - iTerm2 inline images (OSC 1337 File=), see InlineImageHandler
 
 import Foundation
 
@@ -33,6 +34,13 @@ nonisolated enum OSCHandler {
         responseHandler: (([UInt8]) async -> Void)?,
         semanticPromptHandler: ((SemanticPromptEvent) async -> Void)? = nil
     ) async {
+        // OSC 1337 File= carries a whole base64 image; keep it out of the
+        // String conversion below.
+        if oscString.starts(with: InlineImageHandler.iTermFilePrefix) {
+            InlineImageHandler.handleITermFile(oscString, grid: grid)
+            return
+        }
+
         // Parse: <number> ; <string>
         // Some OSC commands have no semicolon (e.g., OSC 112 for cursor color reset)
         let separatorIndex = oscString.firstIndex(of: 0x3B) // ';'
@@ -108,6 +116,7 @@ nonisolated enum OSCHandler {
         // OSC 133 — Semantic prompt (placeholder for future shell integration)
         case OSCCommand.semanticPrompt:
             if let event = parseSemanticPromptEvent(text) {
+                grid.noteSemanticPrompt(event)
                 await semanticPromptHandler?(event)
             }
 
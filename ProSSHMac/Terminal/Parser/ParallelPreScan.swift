@@ -0,0 +1,120 @@
+// ParallelPreScan.swift
+// ProSSHV2
+//
+// Parallel byte classification for very large feed batches (e.g. `cat` of
+// a multi-megabyte log). Parsing itself stays sequential — every later
+// byte depends on the state left by earlier ones — but deciding where each
+// ground-state text run ends does not. Before walking a big chunk,
+// TerminalEngine.feed splits it into segments, classifies them
+// concurrently, and then jumps from one non-text byte to the next instead
+// of testing every byte of every run.
+//
+// A segment dense with non-text bytes (UTF-8 text, binary) is left
+// unscanned; the engine handles it with the per-byte path as before.
+
+import Foundation
+
+// MARK: - ParallelPreScan
+
+nonisolated enum ParallelPreScan {
+
+    /// Batches smaller than this are parsed without a pre-scan; the fork/join
+    /// cost would outweigh the classification it saves.
+    static let minimumBatchSize = 128 * 1024
+
+    /// Smallest segment handed to one worker.
+    static let minimumSegmentSize = 32 * 1024
+
+    /// A segment with more than one non-text byte per `densityLimit` bytes
+    /// is not worth indexing.
+    static let densityLimit = 8
+
+    /// Bytes the ground-state ASCII fast path consumes: printable ASCII, LF, CR.
+    @inline(__always)
+    static func isGroundTextByte(_ byte: UInt8) -> Bool {
+        (byte >= 0x20 && byte <= 0x7E) || byte == 0x0A || byte == 0x0D
+    }
+
+    /// Classify `data` across worker threads. Returns nil when the batch is
+    /// too small to split.
+    static func scan(_ data: Data) -> PreScanCursor? {
+        let count = data.count
+        guard count >= minimumBatchSize else { return nil }
+        let workers = min(ProcessInfo.processInfo.activeProcessorCount, count / minimumSegmentSize)
+        guard workers > 1 else { return nil }
+
+        let segmentLength = (count + workers - 1) / workers
+        var specials = [[Int32]?](repeating: nil, count: workers)
+        data.withUnsafeBytes { raw in
+            specials.withUnsafeMutableBufferPointer { out in
+                DispatchQueue.concurrentPerform(iterations: workers) { segment in
+                    let lower = segment * segmentLength
+                    let upper = min(count, lower + segmentLength)
+                    out[segment] = nonTextOffsets(raw, in: lower..<upper)
+                }
+            }
+        }
+
+        var segments: [PreScanSegment] = []
+        segments.reserveCapacity(workers)
+        for segment in 0..<workers {
+            let lower = segment * segmentLength
+            segments.append(PreScanSegment(
+                end: min(count, lower + segmentLength),
+                nonTextOffsets: specials[segment]
+            ))
+        }
+        return PreScanCursor(segments: segments)
+    }
+
+    /// Offsets of every non-text byte in `range`, or nil when the segment is
+    /// too dense to index.
+    static func nonTextOffsets(_ bytes: UnsafeRawBufferPointer, in range: Range<Int>) -> [Int32]? {
+        let limit = range.count / densityLimit
+        var offsets: [Int32] = []
+        for index in range where !isGroundTextByte(bytes[index]) {
+            guard offsets.count < limit else { return nil }
+            offsets.append(Int32(index))
+        }
+        return offsets
+    }
+}
+
+// MARK: - PreScanSegment
+
+nonisolated struct PreScanSegment: Sendable {
+    /// Exclusive upper bound of the segment within the batch.
+    let end: Int
+    /// Sorted non-text byte offsets, or nil when the segment was not indexed.
+    let nonTextOffsets: [Int32]?
+}
+
+// MARK: - PreScanCursor
+
+/// Forward-only view over a pre-scanned batch. Queries must be made with
+/// non-decreasing indices, which is how the feed loop walks a chunk.
+nonisolated struct PreScanCursor: Sendable {
+    private let segments: [PreScanSegment]
+    private var segment = 0
+    private var position = 0
+
+    init(segments: [PreScanSegment]) {
+        self.segments = segments
+    }
+
+    /// End of the text run that starts at `index`: the next non-text byte,
+    /// or the end of the segment, whichever comes first. Nil when `index`
+    /// lies in a segment that was not indexed.
+    mutating func textRunEnd(from index: Int) -> Int? {
+        while segment < segments.count, segments[segment].end <= index {
+            segment += 1
+            position = 0
+        }
+        guard segment < segments.count,
+              let offsets = segments[segment].nonTextOffsets else { return nil }
+        while position < offsets.count, Int(offsets[position]) < index {
+            position += 1
+        }
+        return position < offsets.count ? Int(offsets[position]) : segments[segment].end
+    }
+}
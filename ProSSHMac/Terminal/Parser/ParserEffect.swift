@@ -0,0 +1,30 @@
+// ParserEffect.swift
+// ProSSHV2
+//
+// Follow-up work that a synchronous dispatch hands back to TerminalEngine.
+//
+// CSI, SGR and ESC sequences are applied to the grid synchronously. The few
+// that have to suspend — replies to the host (DSR, DA, DECRQM) and updates
+// to the cross-actor InputModeState — return an effect instead, and only
+// those bytes pay for an `await` in the feed loop.
+
+import Foundation
+
+// MARK: - ParserEffect
+
+nonisolated enum ParserEffect: Sendable {
+    /// Send bytes back to the host through the response handler.
+    case reply([UInt8])
+    /// Re-sync InputModeState from the grid after a mode change.
+    case syncInputModes
+    /// RIS: reset InputModeState.
+    case resetInputModes
+    /// DECKPAM / DECKPNM: mirror the keypad mode into InputModeState.
+    case setApplicationKeypad(Bool)
+    /// Dispatch the collected OSC string (OSCHandler is async).
+    case dispatchOSC
+    /// Dispatch the collected DCS data (DCSHandler is async).
+    case dispatchDCS
+    /// Dispatch the collected APC string (kitty graphics may reply).
+    case dispatchAPC
+}
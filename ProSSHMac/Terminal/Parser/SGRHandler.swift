@@ -38,10 +38,10 @@ nonisolated enum SGRHandler {
     // MARK: - A.11 Main Handler
 
     /// Handle a complete SGR sequence with subparameter support.
-    /// `params` is [[Int]] where each element is a group of subparameters.
-    /// A semicolon-separated sequence like "1;31" produces [[1],[31]].
-    /// A colon-separated sequence like "4:3" produces [[4,3]].
-    static func handle(params: [[Int]], grid: TerminalGrid) {
+    /// `params` holds one group per top-level parameter; colon subparameters
+    /// extend their group. "1;31" is two groups [1],[31]; "4:3" is one
+    /// group [4,3].
+    static func handle(params: CSIParams, grid: TerminalGrid) {
         var sgr = grid.sgrState()
 
         // A.11.1 — No parameters means reset
@@ -57,8 +57,8 @@ nonisolated enum SGRHandler {
 
         var i = 0
         while i < params.count {
-            let group = params[i]
-            let code = group[0]
+            let code = params[i]
+            let groupLength = params.groupLength(i)
 
             switch code {
 
@@ -79,8 +79,8 @@ nonisolated enum SGRHandler {
                 sgr.attributes.insert(.italic)
             case SGRCode.underline:
                 // Check for subparameters: 4:0=none, 4:1=single, 4:2=double, 4:3=curly, 4:4=dotted, 4:5=dashed
-                if group.count > 1 {
-                    let style = UnderlineStyle(rawValue: UInt8(clamping: group[1])) ?? .single
+                if groupLength > 1 {
+                    let style = UnderlineStyle(rawValue: UInt8(clamping: params[i, 1])) ?? .single
                     applyUnderlineStyle(style, sgr: &sgr)
                 } else {
                     applyUnderlineStyle(.single, sgr: &sgr)
@@ -123,9 +123,9 @@ nonisolated enum SGRHandler {
 
             // A.11.5 — 256-color / Truecolor foreground (38;5;N or 38;2;R;G;B or 38:5:N or 38:2::R:G:B)
             case SGRCode.fgColorExtended:
-                if group.count > 1 {
+                if groupLength > 1 {
                     // Colon form: subparams contain all color data
-                    parseExtendedColorFromSubparams(group: group, isForeground: true, sgr: &sgr)
+                    parseExtendedColorFromSubparams(params: params, group: i, isForeground: true, sgr: &sgr)
                 } else {
                     // Semicolon form: consume subsequent top-level params
                     i = parseExtendedColor(params: params, from: i, isForeground: true, sgr: &sgr)
@@ -141,8 +141,8 @@ nonisolated enum SGRHandler {
 
             // A.11.5 — 256-color / Truecolor background (48;5;N or 48;2;R;G;B or 48:5:N or 48:2::R:G:B)
             case SGRCode.bgColorExtended:
-                if group.count > 1 {
-                    parseExtendedColorFromSubparams(group: group, isForeground: false, sgr: &sgr)
+                if groupLength > 1 {
+                    parseExtendedColorFromSubparams(params: params, group: i, isForeground: false, sgr: &sgr)
                 } else {
                     i = parseExtendedColor(params: params, from: i, isForeground: false, sgr: &sgr)
                 }
@@ -159,8 +159,8 @@ nonisolated enum SGRHandler {
 
             // Underline color (58) — extended color for underlines
             case SGRCode.underlineColorExtended:
-                if group.count > 1 {
-                    parseUnderlineColorFromSubparams(group: group, sgr: &sgr)
+                if groupLength > 1 {
+                    parseUnderlineColorFromSubparams(params: params, group: i, sgr: &sgr)
                 } else {
                     i = parseUnderlineColor(params: params, from: i, sgr: &sgr)
                 }
@@ -213,28 +213,28 @@ nonisolated enum SGRHandler {
     /// Parse extended color from semicolon-separated top-level params.
     /// Returns the index of the last consumed parameter group.
     private static func parseExtendedColor(
-        params: [[Int]],
+        params: CSIParams,
         from index: Int,
         isForeground: Bool,
         sgr: inout SGRState
     ) -> Int {
         guard index + 1 < params.count else { return index }
 
-        let colorType = params[index + 1].first ?? 0
+        let colorType = params[index + 1]
 
         switch colorType {
         case 5: // 256-color: 38;5;N or 48;5;N
             guard index + 2 < params.count else { return index + 1 }
-            let colorIndex = UInt8(clamping: params[index + 2].first ?? 0)
+            let colorIndex = UInt8(clamping: params[index + 2])
             if isForeground { sgr.fg = .indexed(colorIndex) }
             else { sgr.bg = .indexed(colorIndex) }
             return index + 2
 
         case 2: // Truecolor: 38;2;R;G;B or 48;2;R;G;B
             guard index + 4 < params.count else { return index + 1 }
-            let r = UInt8(clamping: params[index + 2].first ?? 0)
-            let g = UInt8(clamping: params[index + 3].first ?? 0)
-            let b = UInt8(clamping: params[index + 4].first ?? 0)
+            let r = UInt8(clamping: params[index + 2])
+            let g = UInt8(clamping: params[index + 3])
+            let b = UInt8(clamping: params[index + 4])
             if isForeground { sgr.fg = .rgb(r, g, b) }
             else { sgr.bg = .rgb(r, g, b) }
             return index + 4
@@ -249,35 +249,37 @@ nonisolated enum SGRHandler {
     /// Parse extended color from a colon-separated subparameter group.
     /// Handles: 38:5:N, 38:2:CS:R:G:B (CS = colorspace, usually 0 or omitted)
     private static func parseExtendedColorFromSubparams(
-        group: [Int],
+        params: CSIParams,
+        group: Int,
         isForeground: Bool,
         sgr: inout SGRState
     ) {
-        guard group.count >= 2 else { return }
-        let colorType = group[1]
+        let length = params.groupLength(group)
+        guard length >= 2 else { return }
+        let colorType = params[group, 1]
 
         switch colorType {
         case 5: // 256-color: 38:5:N
-            guard group.count >= 3 else { return }
-            let colorIndex = UInt8(clamping: group[2])
+            guard length >= 3 else { return }
+            let colorIndex = UInt8(clamping: params[group, 2])
             if isForeground { sgr.fg = .indexed(colorIndex) }
             else { sgr.bg = .indexed(colorIndex) }
 
         case 2: // Truecolor: 38:2:CS:R:G:B or 38:2::R:G:B
             // The colorspace ID is at index 2, R/G/B follow.
             // When colorspace is omitted (double-colon), index 2 will be 0.
-            if group.count >= 6 {
+            if length >= 6 {
                 // Full form with colorspace: 38:2:CS:R:G:B
-                let r = UInt8(clamping: group[3])
-                let g = UInt8(clamping: group[4])
-                let b = UInt8(clamping: group[5])
+                let r = UInt8(clamping: params[group, 3])
+                let g = UInt8(clamping: params[group, 4])
+                let b = UInt8(clamping: params[group, 5])
                 if isForeground { sgr.fg = .rgb(r, g, b) }
                 else { sgr.bg = .rgb(r, g, b) }
-            } else if group.count >= 5 {
+            } else if length >= 5 {
                 // Short form without colorspace: 38:2:R:G:B
-                let r = UInt8(clamping: group[2])
-                let g = UInt8(clamping: group[3])
-                let b = UInt8(clamping: group[4])
+                let r = UInt8(clamping: params[group, 2])
+                let g = UInt8(clamping: params[group, 3])
+                let b = UInt8(clamping: params[group, 4])
                 if isForeground { sgr.fg = .rgb(r, g, b) }
                 else { sgr.bg = .rgb(r, g, b) }
             }
@@ -291,26 +293,26 @@ nonisolated enum SGRHandler {
 
     /// Parse underline color from semicolon-separated top-level params.
     private static func parseUnderlineColor(
-        params: [[Int]],
+        params: CSIParams,
         from index: Int,
         sgr: inout SGRState
     ) -> Int {
         guard index + 1 < params.count else { return index }
 
-        let colorType = params[index + 1].first ?? 0
+        let colorType = params[index + 1]
 
         switch colorType {
         case 5: // 256-color: 58;5;N
             guard index + 2 < params.count else { return index + 1 }
-            let colorIndex = UInt8(clamping: params[index + 2].first ?? 0)
+            let colorIndex = UInt8(clamping: params[index + 2])
             sgr.underlineColor = .indexed(colorIndex)
             return index + 2
 
         case 2: // Truecolor: 58;2;R;G;B
             guard index + 4 < params.count else { return index + 1 }
-            let r = UInt8(clamping: params[index + 2].first ?? 0)
-            let g = UInt8(clamping: params[index + 3].first ?? 0)
-            let b = UInt8(clamping: params[index + 4].first ?? 0)
+            let r = UInt8(clamping: params[index + 2])
+            let g = UInt8(clamping: params[index + 3])
+            let b = UInt8(clamping: params[index + 4])
             sgr.underlineColor = .rgb(r, g, b)
             return index + 4
 
@@ -323,27 +325,29 @@ nonisolated enum SGRHandler {
 
     /// Parse underline color from a colon-separated subparameter group.
     private static func parseUnderlineColorFromSubparams(
-        group: [Int],
+        params: CSIParams,
+        group: Int,
         sgr: inout SGRState
     ) {
-        guard group.count >= 2 else { return }
-        let colorType = group[1]
+        let length = params.groupLength(group)
+        guard length >= 2 else { return }
+        let colorType = params[group, 1]
 
         switch colorType {
         case 5: // 256-color: 58:5:N
-            guard group.count >= 3 else { return }
-            sgr.underlineColor = .indexed(UInt8(clamping: group[2]))
+            guard length >= 3 else { return }
+            sgr.underlineColor = .indexed(UInt8(clamping: params[group, 2]))
 
         case 2: // Truecolor: 58:2:CS:R:G:B or 58:2::R:G:B
-            if group.count >= 6 {
-                let r = UInt8(clamping: group[3])
-                let g = UInt8(clamping: group[4])
-                let b = UInt8(clamping: group[5])
+            if length >= 6 {
+                let r = UInt8(clamping: params[group, 3])
+                let g = UInt8(clamping: params[group, 4])
+                let b = UInt8(clamping: params[group, 5])
                 sgr.underlineColor = .rgb(r, g, b)
-            } else if group.count >= 5 {
-                let r = UInt8(clamping: group[2])
-                let g = UInt8(clamping: group[3])
-                let b = UInt8(clamping: group[4])
+            } else if length >= 5 {
+                let r = UInt8(clamping: params[group, 2])
+                let g = UInt8(clamping: params[group, 3])
+                let b = UInt8(clamping: params[group, 4])
                 sgr.underlineColor = .rgb(r, g, b)
             }
 
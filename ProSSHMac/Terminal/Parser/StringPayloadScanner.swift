@@ -0,0 +1,52 @@
+// StringPayloadScanner.swift
+// ProSSHV2
+//
+// Scan-ahead for OSC and DCS string payloads. Base64 clipboard pushes
+// (OSC 52), inline images and sixel data are long runs of printable ASCII
+// between the introducer and the terminator. Walking them through the
+// state machine a byte at a time dominated large transfers.
+//
+// While the parser is in `.oscString` or `.dcsPassthrough`, TerminalEngine
+// asks `printableRunEnd` how far the current run of 0x20–0x7E extends. In
+// both states the transition table puts those bytes and stays put, so the
+// span can be appended to the payload in one copy. The run stops at the
+// first byte the table treats specially — BEL, ESC, CAN/SUB, C1 ST, any
+// other control or high byte — and the state machine takes over from there.
+
+import Foundation
+
+// MARK: - StringPayloadScanner
+
+nonisolated enum StringPayloadScanner {
+
+    private static let ones: UInt64 = 0x0101_0101_0101_0101
+    private static let spaces: UInt64 = 0x2020_2020_2020_2020
+    private static let deletes: UInt64 = 0x7F7F_7F7F_7F7F_7F7F
+    private static let highBits: UInt64 = 0x8080_8080_8080_8080
+
+    /// Index of the first byte at or after `start` outside 0x20–0x7E, or
+    /// `bytes.count` when the run reaches the end of the span. Checks eight
+    /// bytes per step and only looks at single bytes around the stop.
+    static func printableRunEnd(_ bytes: UnsafeRawBufferPointer, from start: Int) -> Int {
+        let count = bytes.count
+        var index = start
+
+        while index + 8 <= count {
+            let word = bytes.loadUnaligned(fromByteOffset: index, as: UInt64.self)
+            // Any byte < 0x20, == 0x7F or >= 0x80 breaks the run
+            // (classic "has less than" / "has zero byte" word tests).
+            let below = (word &- spaces) & ~word & highBits
+            let flipped = word ^ deletes
+            let delete = (flipped &- ones) & ~flipped & highBits
+            if (word & highBits) | below | delete != 0 { break }
+            index += 8
+        }
+
+        while index < count {
+            let byte = bytes[index]
+            guard byte >= 0x20 && byte <= 0x7E else { break }
+            index += 1
+        }
+        return index
+    }
+}
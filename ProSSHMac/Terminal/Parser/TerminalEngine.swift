@@ -8,6 +8,13 @@
 // The engine owns a TerminalGrid (plain class) and drives it synchronously —
 // no cross-actor overhead for parser→grid calls. External callers access grid
 // state through forwarding methods on this actor.
+//
+// Each engine runs on its own serial executor (`unownedExecutor`) on the
+// TerminalEngineScheduler pool instead of the shared cooperative pool, so
+// busy sessions parse in parallel without competing with SwiftUI and AI
+// streaming tasks for pool threads. The pool serves the focused pane first,
+// and a flooding engine yields every `quantumBytes` while others wait.
+// The publish path reads post-feed grid flags from `mailbox` without a hop.
 
 import Foundation
 import os.log
@@ -32,6 +39,24 @@ actor TerminalEngine {
     /// The terminal grid owned by this engine. Accessed synchronously within the actor.
     let grid: TerminalGrid
 
+    // MARK: - Executor
+
+    /// Executor this actor's jobs run on. One per session, all sharing the
+    /// TerminalEngineScheduler workers; its tier orders busy sessions.
+    nonisolated let executor: TerminalEngineExecutor
+
+    nonisolated var unownedExecutor: UnownedSerialExecutor {
+        executor.asUnownedSerialExecutor()
+    }
+
+    /// Scheduling priority, from the render tier of the session's panes.
+    nonisolated func setSchedulingTier(_ tier: SessionRenderTier) {
+        executor.tier = tier
+    }
+
+    /// Grid flags posted after each feed, readable without awaiting the actor.
+    nonisolated let mailbox = TerminalEngineMailbox()
+
     // MARK: - Debug Logging
 
     /// Enable to log parser transitions for debugging escape sequence issues.
@@ -51,12 +76,12 @@ actor TerminalEngine {
 
     // MARK: - Parameter Collection (A.8.3)
 
-    /// Collected numeric parameters for CSI/DCS sequences.
-    /// Each top-level parameter is an array of subparameters.
+    /// Collected numeric parameters for CSI/DCS sequences, stored inline
+    /// (see `CSIParams`) so collecting and dispatching never allocates.
     /// Semicolons separate top-level parameters; colons separate subparameters.
     /// Example: "4:3" → [[4, 3]], "38;2;255;0;0" → [[38],[2],[255],[0],[0]]
     /// Example: "38:2::255:0:0" → [[38,2,0,255,0,0]]
-    private var params: [[Int]] = []
+    private var params = CSIParams()
 
     /// The parameter currently being built (digits accumulated so far).
     private var currentParam: Int = 0
@@ -85,17 +110,31 @@ actor TerminalEngine {
     /// Collected DCS passthrough data.
     private var dcsData: [UInt8] = []
 
+    // MARK: - APC Collection
+
+    /// Collected APC data (kitty graphics commands).
+    private var apcData: [UInt8] = []
+
+    /// Caps on collected string payloads; bytes past the cap are dropped.
+    /// Inline image strings (OSC 1337 File=, sixel, APC) use `maxImageLength`.
+    private var maxOSCLength = ParserLimits.maxOSCLength
+    private var maxDCSLength = ParserLimits.maxDCSLength
+    private var maxImageLength = ParserLimits.maxImagePayloadLength
+
     /// Expected UTF-8 continuation bytes remaining while collecting OSC/DCS
     /// string payloads. Used to disambiguate C1 ST (0x9C) from UTF-8
     /// continuation bytes in strings like "✳" (E2 9C B3).
     private var stringUTF8Remaining: Int = 0
 
     /// Saved params at DCS hook time (for dispatch during unhook).
-    private var dcsParams: [[Int]] = []
+    private var dcsParams = CSIParams()
 
     /// Saved intermediates at DCS hook time.
     private var dcsIntermediates: [UInt8] = []
 
+    /// Final byte of the DCS introducer; 'q' is sixel.
+    private var dcsFinalByte: UInt8 = 0
+
     // MARK: - UTF-8 Multibyte Decoding (A.8.5)
 
     /// Buffer for accumulating UTF-8 multibyte sequences.
@@ -107,6 +146,10 @@ actor TerminalEngine {
     /// Expected total bytes for the current UTF-8 sequence.
     private var utf8Expected: Int = 0
 
+    /// Reusable scalar buffer for `UTF8TextDecoder` runs handed to
+    /// `TerminalGrid.printCodepoints`.
+    private var decodedScalars: [UInt32] = []
+
     // MARK: - Reentrancy Guard
 
     /// Queue of data waiting to be processed. Reentrant calls to feed()
@@ -115,23 +158,69 @@ actor TerminalEngine {
     /// Read head for `feedQueue`. Avoids `removeFirst()` in hot paths.
     private var feedQueueHead: Int = 0
 
-    /// True while processByte() is running. Guards against Swift actor
-    /// reentrancy: when feed() awaits a cross-actor grid call, the actor
-    /// can accept another feed() message. Without this guard the second
-    /// call would mutate parser state (state, params, intermediates, etc.)
-    /// between the await and the state assignment in processByte().
+    /// True while the feed loop is running. Guards against Swift actor
+    /// reentrancy: when feed() awaits a `ParserEffect` (a reply or an
+    /// InputModeState update), the actor can accept another feed() message.
+    /// Without this guard the second call would interleave its bytes with
+    /// the chunk in progress.
     private var isFeeding: Bool = false
 
+    /// Bytes left to parse before offering the worker to other sessions
+    /// (see TerminalEngineScheduler.quantumBytes).
+    private var quantumRemaining = TerminalEngineScheduler.quantumBytes
+
+    // MARK: - Background Resize
+
+    /// A resize being reflowed on a copy of the grid. Output keeps being
+    /// parsed into `grid` meanwhile and is logged so it can be replayed onto
+    /// the copy once the reflow lands.
+    private struct PendingResize {
+        let generation: Int
+        let columns: Int
+        let rows: Int
+        var replayLog: [Data] = []
+        var replayByteCount = 0
+        var result: TerminalGrid?
+        var waiters: [CheckedContinuation<Void, Never>] = []
+    }
+
+    /// Output logged past this point makes replay more expensive than the
+    /// reflow it avoided; the resize is finished synchronously instead.
+    private static let maxResizeReplayBytes = 8 * 1024 * 1024
+
+    /// When true, `resize` reflows off the actor (see `PendingResize`).
+    private var backgroundResizeEnabled = false
+    private var pendingResize: PendingResize?
+    /// Bumped per resize so a superseded background reflow is discarded.
+    private var resizeGeneration = 0
+    /// True while logged output is replayed onto a swapped-in grid. Replies
+    /// and prompt events already went out the first time.
+    private var isReplayingOutput = false
+
     // MARK: - Initialization
 
-    /// Create an engine that owns its own grid.
-    init(columns: Int = 80, rows: Int = 24, maxScrollbackLines: Int = 10000) {
-        self.grid = TerminalGrid(columns: columns, rows: rows, maxScrollbackLines: maxScrollbackLines)
+    /// Create an engine that owns its own grid. `indexesScrollback` builds
+    /// a trigram filter per scrollback page for full-history search.
+    init(
+        columns: Int = 80,
+        rows: Int = 24,
+        maxScrollbackLines: Int = 10000,
+        indexesScrollback: Bool = false,
+        scheduler: TerminalEngineScheduler = .shared
+    ) {
+        self.grid = TerminalGrid(
+            columns: columns,
+            rows: rows,
+            maxScrollbackLines: maxScrollbackLines,
+            indexesScrollback: indexesScrollback
+        )
+        self.executor = TerminalEngineExecutor(scheduler: scheduler)
     }
 
     /// Legacy init for backward compatibility (tests that already created a grid).
-    init(grid: TerminalGrid) {
+    init(grid: TerminalGrid, scheduler: TerminalEngineScheduler = .shared) {
         self.grid = grid
+        self.executor = TerminalEngineExecutor(scheduler: scheduler)
     }
 
     // MARK: - A.8.6 Feed Method
@@ -140,8 +229,8 @@ actor TerminalEngine {
     /// This is the main entry point — call this with each chunk of data received.
     ///
     /// Reentrancy-safe: if called while another feed() is in progress (possible
-    /// because `processByte` awaits cross-actor grid calls, which suspends this
-    /// actor and allows other messages through), the data is queued and processed
+    /// because the loop awaits `ParserEffect`s, which suspends this actor and
+    /// allows other messages through), the data is queued and processed
     /// in order after the current chunk completes. This prevents a concurrent
     /// `appendShellLine` or `applyPlaybackStep` from corrupting mid-sequence
     /// parser state.
@@ -154,62 +243,192 @@ actor TerminalEngine {
     func feed(_ data: Data) async -> Bool {
         feedQueue.append(data)
         guard !isFeeding else { return false }
+        await drainFeedQueue()
+        return true
+    }
+
+    /// Run the feed loop until the queue is empty, swapping in a finished
+    /// background resize between chunks.
+    private func drainFeedQueue() async {
         isFeeding = true
         defer {
             isFeeding = false
             // Queue is fully drained at this point; keep capacity for future bursts.
             feedQueue.removeAll(keepingCapacity: true)
             feedQueueHead = 0
+            quantumRemaining = TerminalEngineScheduler.quantumBytes
         }
 
-        while feedQueueHead < feedQueue.count {
-            let next = feedQueue[feedQueueHead]
-            feedQueueHead += 1
-            var index = 0
-            #if DEBUG
-            let signpostID = OSSignpostID(log: Self.perfSignpostLog)
+        repeat {
+            while feedQueueHead < feedQueue.count {
+                await swapInFinishedResize()
+                let next = feedQueue[feedQueueHead]
+                feedQueueHead += 1
+                logForResizeReplay(next)
+                await processChunk(next)
+
+                // Compact occasionally so long bursts don't retain a large head offset.
+                if feedQueueHead >= 64, feedQueueHead * 2 >= feedQueue.count {
+                    feedQueue.removeFirst(feedQueueHead)
+                    feedQueueHead = 0
+                }
+            }
+            // Replay can suspend and let more output queue up behind it.
+            await swapInFinishedResize()
+        } while feedQueueHead < feedQueue.count
+        grid.settleEchoPredictions()
+        postStatus()
+    }
+
+    /// Parse one chunk into the grid.
+    private func processChunk(_ next: Data) async {
+        var index = 0
+        #if DEBUG
+        let signpostID = OSSignpostID(log: Self.perfSignpostLog)
+        os_signpost(
+            .begin,
+            log: Self.perfSignpostLog,
+            name: "ParserChunk",
+            signpostID: signpostID,
+            "bytes=%d",
+            next.count
+        )
+        defer {
             os_signpost(
-                .begin,
+                .end,
                 log: Self.perfSignpostLog,
                 name: "ParserChunk",
-                signpostID: signpostID,
-                "bytes=%d",
-                next.count
+                signpostID: signpostID
             )
-            defer {
-                os_signpost(
-                    .end,
-                    log: Self.perfSignpostLog,
-                    name: "ParserChunk",
-                    signpostID: signpostID
-                )
+        }
+        #endif
+
+        var allocationScope = AllocationTracker.begin(.parse)
+        defer { allocationScope?.end(bytes: next.count) }
+        let traceStart = TraceRecorder.shared.begin()
+        defer { TraceRecorder.shared.end(.parserChunk, since: traceStart, value: Int64(next.count)) }
+
+        // Huge chunks get their text-run boundaries found in parallel first,
+        // and flooding text skips the grid for lines that scroll straight off.
+        var preScan = ParallelPreScan.scan(next)
+        grid.floodMode = next.count >= TerminalGrid.floodWatermark
+
+        // Start of the bytes not yet charged to `quantumRemaining`.
+        var quantumStart = 0
+        defer { quantumRemaining -= index - quantumStart }
+
+        while index < next.count {
+            if index - quantumStart >= quantumRemaining {
+                quantumStart = index
+                await yieldQuantum()
             }
-            #endif
+            let byte = next[index]
 
-            while index < next.count {
-                let byte = next[index]
-
-                if shouldFastPathGroundTextByte(byte) {
-                    let start = index
+            if shouldFastPathGroundTextByte(byte) {
+                let start = index
+                if let end = preScan?.textRunEnd(from: index) {
+                    index = end
+                } else {
                     index += 1
                     while index < next.count, shouldFastPathGroundTextByte(next[index]) {
                         index += 1
                     }
-                    grid.processGroundTextBytes(next, range: start..<index)
+                }
+                grid.processGroundTextBytes(next, range: start..<index)
+                continue
+            }
+
+            if shouldFastPathGroundUTF8Lead(byte) {
+                let end = printDecodedTextRun(next, from: index)
+                if end > index {
+                    index = end
                     continue
                 }
+            }
 
-                await processByte(byte)
-                index += 1
+            if byte == 0x1B, state == .ground, utf8Remaining == 0, !Self.debugLogging,
+               let end = dispatchSimpleCSI(next, at: index) {
+                index = end
+                continue
             }
 
-            // Compact occasionally so long bursts don't retain a large head offset.
-            if feedQueueHead >= 64, feedQueueHead * 2 >= feedQueue.count {
-                feedQueue.removeFirst(feedQueueHead)
-                feedQueueHead = 0
+            if byte >= 0x20, byte <= 0x7E, state == .oscString || state == .dcsPassthrough || state == .apcString {
+                index = collectStringPayload(next, from: index)
+                continue
             }
+
+            if let effect = processByte(byte) {
+                allocationScope?.suspend()
+                await perform(effect)
+                allocationScope?.resume()
+            }
+            index += 1
         }
-        return true
+    }
+
+    /// Start a new quantum, first letting waiting sessions run when there
+    /// are any. Called between tokens, where the parse can be resumed as
+    /// after any other suspension.
+    private func yieldQuantum() async {
+        quantumRemaining = TerminalEngineScheduler.quantumBytes
+        guard executor.shouldYield else { return }
+        await Task.yield()
+    }
+
+    /// Publish the grid flags the rendering side polls (see `TerminalEngineMailbox`).
+    private func postStatus() {
+        mailbox.post(TerminalEngineStatus(
+            synchronizedOutput: grid.synchronizedOutput,
+            usingAlternateBuffer: grid.usingAlternateBuffer,
+            hasSyncExitSnapshots: !grid.syncExitSnapshots.isEmpty,
+            scrollbackCount: grid.scrollbackCount
+        ))
+    }
+
+    /// Feed bytes whose storage is only valid for the duration of this call
+    /// (e.g. a `Data(bytesNoCopy:)` view into `ShellOutputRing`). Parsed in place
+    /// when this call drives the loop; deep-copied only if it has to be queued
+    /// behind an in-progress feed, since the caller reclaims the storage on return.
+    @discardableResult
+    func feed(borrowing data: Data) async -> Bool {
+        guard !isFeeding else {
+            feedQueue.append(data.withUnsafeBytes { Data($0) })
+            return false
+        }
+        return await feed(data)
+    }
+
+    /// Parser-reader entry point: feed a batch and, in the same actor turn,
+    /// collect the state the publish path needs (see `FeedResult`). Pending
+    /// sync-exit snapshots are consumed here.
+    func feedCollecting(_ data: Data) async -> FeedResult {
+        collectFeedResult(didProcess: await feed(data))
+    }
+
+    /// `feedCollecting` for borrowed storage; see `feed(borrowing:)`.
+    func feedCollecting(borrowing data: Data) async -> FeedResult {
+        collectFeedResult(didProcess: await feed(borrowing: data))
+    }
+
+    private func collectFeedResult(didProcess: Bool) -> FeedResult {
+        guard didProcess else {
+            return FeedResult(didProcess: false, inputModeSnapshot: grid.inputModeSnapshot())
+        }
+        let syncExitSnapshots = grid.syncExitSnapshots.isEmpty ? [] : consumeSyncExitSnapshots()
+        let synchronizedOutput = grid.synchronizedOutput
+        // Read before the live snapshot below, which clears dirty tracking.
+        let dirtyRows = grid.hasDirtyCells && grid.dirtyRowMin <= grid.dirtyRowMax
+            ? grid.dirtyRowMin...grid.dirtyRowMax
+            : nil
+        return FeedResult(
+            didProcess: true,
+            inputModeSnapshot: grid.inputModeSnapshot(),
+            syncExitSnapshots: syncExitSnapshots,
+            synchronizedOutput: synchronizedOutput,
+            usingAlternateBuffer: grid.usingAlternateBuffer,
+            liveSyncSnapshot: synchronizedOutput ? grid.liveSnapshot() : nil,
+            dirtyRows: dirtyRows
+        )
     }
 
     /// Fast-path condition for ground-state text bytes that can be
@@ -217,11 +436,111 @@ actor TerminalEngine {
     private func shouldFastPathGroundTextByte(_ byte: UInt8) -> Bool {
         state == .ground &&
         utf8Remaining == 0 &&
-        (
-            (byte >= 0x20 && byte <= 0x7E) || // printable ASCII
-            byte == 0x0A ||                   // LF
-            byte == 0x0D                      // CR
+        ParallelPreScan.isGroundTextByte(byte)
+    }
+
+    /// Fast-path condition for a multibyte UTF-8 lead byte in ground state.
+    /// Bytes below 0xC2 are continuation bytes, C1 controls or overlong leads
+    /// and always take the state machine.
+    private func shouldFastPathGroundUTF8Lead(_ byte: UInt8) -> Bool {
+        byte >= 0xC2 &&
+        state == .ground &&
+        utf8Remaining == 0 &&
+        !Self.debugLogging
+    }
+
+    /// Decode the printable text run starting at `start` and print it in one
+    /// grid call. Returns the index after the run, or `start` when the lead
+    /// byte does not begin a complete, valid sequence in this chunk.
+    private func printDecodedTextRun(_ data: Data, from start: Int) -> Int {
+        decodedScalars.removeAll(keepingCapacity: true)
+        let end = data.withUnsafeBytes { raw in
+            UTF8TextDecoder.decodePrintableRun(
+                raw.bindMemory(to: UInt8.self),
+                from: start,
+                into: &decodedScalars
+            )
+        }
+        if end > start {
+            decodedScalars.withUnsafeBufferPointer { grid.printCodepoints($0) }
+        }
+        return end
+    }
+
+    /// Recognize a whole simple CSI sequence at `start` (see `CSIFastPath`)
+    /// and dispatch it without stepping the state machine. Returns the index
+    /// after the sequence, or nil to let the full parser handle the bytes.
+    /// The recognized final bytes never produce a `ParserEffect`.
+    private func dispatchSimpleCSI(_ data: Data, at start: Int) -> Int? {
+        var fastParams = CSIParams()
+        guard let match = data.withUnsafeBytes({ raw in
+            CSIFastPath.scan(raw, at: start, into: &fastParams)
+        }) else { return nil }
+
+        stateBeforeEscape = .ground
+        _ = CSIHandler.dispatch(
+            byte: match.finalByte,
+            params: fastParams,
+            privateMarker: 0,
+            intermediates: [],
+            grid: grid
         )
+        return match.end
+    }
+
+    /// Append the printable run starting at `start` to the OSC, DCS or APC
+    /// payload in one copy (see `StringPayloadScanner`). The caller has
+    /// checked that `start` holds a printable byte, so at least one byte is
+    /// always consumed. Returns the index after the run.
+    private func collectStringPayload(_ data: Data, from start: Int) -> Int {
+        let end = data.withUnsafeBytes { raw in
+            let end = StringPayloadScanner.printableRunEnd(raw, from: start)
+            switch state {
+            case .oscString:
+                let room = oscPayloadLimit - oscString.count
+                if room > 0 {
+                    oscString.append(contentsOf: UnsafeRawBufferPointer(rebasing: raw[start..<min(end, start + room)]))
+                }
+            case .dcsPassthrough:
+                let room = dcsPayloadLimit - dcsData.count
+                if room > 0 {
+                    dcsData.append(contentsOf: UnsafeRawBufferPointer(rebasing: raw[start..<min(end, start + room)]))
+                }
+            default:
+                let room = maxImageLength - apcData.count
+                if room > 0 {
+                    apcData.append(contentsOf: UnsafeRawBufferPointer(rebasing: raw[start..<min(end, start + room)]))
+                }
+            }
+            return end
+        }
+        // A printable byte ends any partial UTF-8 sequence in the payload.
+        stringUTF8Remaining = 0
+        return end
+    }
+
+    /// Override the OSC, DCS and inline image payload caps (see `ParserLimits`).
+    func setStringPayloadLimits(osc: Int, dcs: Int, image: Int = ParserLimits.maxImagePayloadLength) {
+        maxOSCLength = max(osc, 0)
+        maxDCSLength = max(dcs, 0)
+        maxImageLength = max(image, 0)
+    }
+
+    /// Cap for the OSC string being collected: an iTerm2 image may grow
+    /// to the image cap, anything else stops at the OSC cap.
+    private var oscPayloadLimit: Int {
+        oscString.starts(with: InlineImageHandler.iTermFilePrefix) ? max(maxOSCLength, maxImageLength) : maxOSCLength
+    }
+
+    /// Cap for the DCS data being collected; sixel gets the image cap.
+    private var dcsPayloadLimit: Int {
+        dcsFinalByte == 0x71 ? max(maxDCSLength, maxImageLength) : maxDCSLength
+    }
+
+    /// Pixel size of one cell, reported by the renderer. Sizes images given
+    /// in pixels and answers CSI 14 t / 16 t.
+    func setCellPixelSize(width: Int, height: Int) {
+        grid.setInlineImageCellSize(InlineImageCellSize(width: width, height: height))
     }
 
     /// Feed a single byte array into the parser.
@@ -234,7 +553,9 @@ actor TerminalEngine {
     /// Process a single byte through the state machine.
     /// All anywhere transitions (CAN, SUB, ESC, C1 controls) are encoded
     /// directly in the flat lookup table — no separate branch cascade needed.
-    private func processByte(_ byte: UInt8) async {
+    /// Synchronous: returns the effect to await when the dispatched sequence
+    /// needs to suspend (replies, InputModeState updates, OSC/DCS dispatch).
+    private func processByte(_ byte: UInt8) -> ParserEffect? {
         // UTF-8 continuation bytes go to the UTF-8 decoder when active
         if utf8Remaining > 0 {
             if byte & 0xC0 == 0x80 {
@@ -243,7 +564,7 @@ actor TerminalEngine {
                 if utf8Remaining == 0 {
                     flushUTF8()
                 }
-                return
+                return nil
             } else {
                 // Invalid continuation — discard the incomplete sequence
                 resetUTF8()
@@ -260,8 +581,8 @@ actor TerminalEngine {
         // rather than a real C1 ST. Skip the table lookup if mid-sequence.
         if byte == 0x9C && stringUTF8Remaining > 0 {
             switch state {
-            case .oscString, .dcsPassthrough, .sosPmApcString:
-                return
+            case .oscString, .dcsPassthrough, .sosPmApcString, .apcString:
+                return nil
             default:
                 break
             }
@@ -269,8 +590,34 @@ actor TerminalEngine {
 
         // Single O(1) table lookup — includes all anywhere transitions
         let transition = stateTransition(state: state, byte: byte)
-        await executeAction(transition.action, byte: byte)
+        let effect = executeAction(transition.action, byte: byte)
         state = transition.nextState
+        return effect
+    }
+
+    /// Carry out the suspending part of a dispatch. Runs before the next
+    /// byte is parsed, so ordering matches the old fully-async path.
+    private func perform(_ effect: ParserEffect) async {
+        switch effect {
+        case .reply(let bytes):
+            guard !isReplayingOutput else { return }
+            await responseHandler?(bytes)
+        case .syncInputModes:
+            if let inputModeState {
+                let snap = grid.inputModeSnapshot()
+                await inputModeState.syncFromSnapshot(snap)
+            }
+        case .resetInputModes:
+            await inputModeState?.applyFullReset()
+        case .setApplicationKeypad(let enabled):
+            await inputModeState?.setApplicationKeypad(enabled)
+        case .dispatchOSC:
+            await handleOSCDispatch()
+        case .dispatchDCS:
+            await handleDCSDispatch()
+        case .dispatchAPC:
+            await handleAPCDispatch()
+        }
     }
 
     // MARK: - State Transition Table (Precomputed)
@@ -291,7 +638,7 @@ actor TerminalEngine {
     // MARK: - Action Execution
 
     /// Execute a parser action. This is where the parser drives the grid.
-    private func executeAction(_ action: ParserAction, byte: UInt8) async {
+    private func executeAction(_ action: ParserAction, byte: UInt8) -> ParserEffect? {
         switch action {
         case .none:
             break
@@ -312,20 +659,20 @@ actor TerminalEngine {
             handleParam(byte)
 
         case .escDispatch:
-            await handleEscDispatch(byte)
+            return handleEscDispatch(byte)
 
         case .csiDispatch:
-            await handleCSIDispatch(byte)
+            return handleCSIDispatch(byte)
 
         case .oscStart:
-            oscString.removeAll(keepingCapacity: true)
+            resetStringPayload(&oscString)
             stringUTF8Remaining = 0
             if Self.debugLogging {
                 Self.parserLog.debug("OSC START (state was \(String(describing: self.state)))")
             }
 
         case .oscPut:
-            if oscString.count < ParserLimits.maxOSCLength {
+            if oscString.count < oscPayloadLimit {
                 oscString.append(byte)
             }
             updateStringUTF8State(with: byte)
@@ -336,30 +683,46 @@ actor TerminalEngine {
                 let preview = String(bytes: self.oscString.prefix(80), encoding: .utf8) ?? "<binary>"
                 Self.parserLog.debug("OSC END — dispatching \(count) bytes: \(preview)")
             }
-            await handleOSCDispatch()
             stringUTF8Remaining = 0
+            return .dispatchOSC
 
         case .dcsHook:
-            dcsData.removeAll(keepingCapacity: true)
+            resetStringPayload(&dcsData)
             stringUTF8Remaining = 0
             // Save params/intermediates at hook time for DCS dispatch
             dcsParams = params
             dcsIntermediates = intermediates
+            dcsFinalByte = byte
 
         case .dcsPut:
-            if dcsData.count < ParserLimits.maxDCSLength {
+            if dcsData.count < dcsPayloadLimit {
                 dcsData.append(byte)
             }
             updateStringUTF8State(with: byte)
 
         case .dcsUnhook:
-            await handleDCSDispatch()
             stringUTF8Remaining = 0
+            return .dispatchDCS
+
+        case .apcStart:
+            resetStringPayload(&apcData)
+            stringUTF8Remaining = 0
+
+        case .apcPut:
+            if apcData.count < maxImageLength {
+                apcData.append(byte)
+            }
+            updateStringUTF8State(with: byte)
+
+        case .apcEnd:
+            stringUTF8Remaining = 0
+            return .dispatchAPC
 
         case .put:
             // Generic put for passthrough modes
             break
         }
+        return nil
     }
 
     // MARK: - Print Handler (with UTF-8 decoding — A.8.5)
@@ -373,17 +736,20 @@ actor TerminalEngine {
             grid.printCharacter(ch)
         } else if byte & 0xE0 == 0xC0 {
             // 2-byte UTF-8 sequence start
-            utf8Buffer = [byte]
+            utf8Buffer.removeAll(keepingCapacity: true)
+            utf8Buffer.append(byte)
             utf8Remaining = 1
             utf8Expected = 2
         } else if byte & 0xF0 == 0xE0 {
             // 3-byte UTF-8 sequence start
-            utf8Buffer = [byte]
+            utf8Buffer.removeAll(keepingCapacity: true)
+            utf8Buffer.append(byte)
             utf8Remaining = 2
             utf8Expected = 3
         } else if byte & 0xF8 == 0xF0 {
             // 4-byte UTF-8 sequence start
-            utf8Buffer = [byte]
+            utf8Buffer.removeAll(keepingCapacity: true)
+            utf8Buffer.append(byte)
             utf8Remaining = 3
             utf8Expected = 4
         } else {
@@ -400,9 +766,15 @@ actor TerminalEngine {
                 Self.parserLog.debug("PRINT UTF-8 '\(preview)' at (\(pos.row),\(pos.col)) state=\(String(describing: self.state))")
             }
         }
-        if let str = String(bytes: utf8Buffer, encoding: .utf8),
-           let ch = str.first {
-            grid.printCharacter(ch)
+        let decoded = utf8Buffer.withUnsafeBufferPointer {
+            UTF8TextDecoder.decodeScalar($0, at: 0)
+        }
+        if let decoded, decoded.length == utf8Buffer.count {
+            // Through the codepoint path so a combining mark split from its
+            // base by a chunk boundary still joins the previous cell.
+            withUnsafePointer(to: decoded.value) {
+                grid.printCodepoints(UnsafeBufferPointer(start: $0, count: 1))
+            }
         } else {
             // Invalid UTF-8 — print replacement character
             grid.printCharacter("\u{FFFD}")
@@ -447,15 +819,10 @@ actor TerminalEngine {
     private func finalizeSubparam() {
         if inSubparam {
             // Already in a subparam group — append to the current group
-            if var lastGroup = params.last {
-                lastGroup.append(hasCurrentParam ? currentParam : ParserLimits.defaultParam)
-                params[params.count - 1] = lastGroup
-            }
+            params.appendSubparam(hasCurrentParam ? currentParam : ParserLimits.defaultParam)
         } else {
             // First colon — finalize as a new top-level group, then mark as subparam mode
-            if params.count < ParserLimits.maxParams {
-                params.append([hasCurrentParam ? currentParam : ParserLimits.defaultParam])
-            }
+            params.appendParam(hasCurrentParam ? currentParam : ParserLimits.defaultParam)
             inSubparam = true
         }
         currentParam = 0
@@ -467,15 +834,10 @@ actor TerminalEngine {
         let value = hasCurrentParam ? currentParam : ParserLimits.defaultParam
         if inSubparam {
             // We're in a subparam group — append the value to the last group
-            if var lastGroup = params.last {
-                lastGroup.append(value)
-                params[params.count - 1] = lastGroup
-            }
+            params.appendSubparam(value)
         } else {
             // Normal top-level parameter
-            if params.count < ParserLimits.maxParams {
-                params.append([value])
-            }
+            params.appendParam(value)
         }
         currentParam = 0
         hasCurrentParam = false
@@ -484,7 +846,7 @@ actor TerminalEngine {
 
     /// Clear all collected parameters and intermediates.
     private func clearParams() {
-        params.removeAll(keepingCapacity: true)
+        params.removeAll()
         currentParam = 0
         hasCurrentParam = false
         inSubparam = false
@@ -554,33 +916,45 @@ actor TerminalEngine {
 
     /// Dispatch an ESC sequence via ESCHandler.
     /// Special case: ESC `\` (0x5C) is the 7-bit String Terminator (ST).
-    /// If we arrived here from an oscString or dcsPassthrough state,
+    /// If we arrived here from an oscString, dcsPassthrough or apcString state,
     /// dispatch the accumulated string data instead of forwarding to ESCHandler.
-    private func handleEscDispatch(_ byte: UInt8) async {
+    private func handleEscDispatch(_ byte: UInt8) -> ParserEffect? {
         if byte == 0x5C { // backslash — potential 7-bit ST
             switch stateBeforeEscape {
             case .oscString:
-                await handleOSCDispatch()
                 stringUTF8Remaining = 0
                 stateBeforeEscape = .ground
-                return
+                return .dispatchOSC
             case .dcsPassthrough:
-                await handleDCSDispatch()
                 stringUTF8Remaining = 0
                 stateBeforeEscape = .ground
-                return
+                return .dispatchDCS
+            case .apcString:
+                stringUTF8Remaining = 0
+                stateBeforeEscape = .ground
+                return .dispatchAPC
             default:
                 break
             }
         }
 
-        await ESCHandler.dispatch(
+        let effect = ESCHandler.dispatch(
             byte: byte,
             intermediates: intermediates,
-            grid: grid,
-            inputModeState: inputModeState
+            grid: grid
         )
         stateBeforeEscape = .ground
+        return effect
+    }
+
+    /// Empty a payload buffer for the next string, dropping storage left
+    /// over from an unusually large one.
+    private func resetStringPayload(_ payload: inout [UInt8]) {
+        if payload.capacity > ParserLimits.retainedStringCapacity {
+            payload = []
+        } else {
+            payload.removeAll(keepingCapacity: true)
+        }
     }
 
     /// Track UTF-8 lead/continuation bytes while collecting OSC/DCS strings.
@@ -610,7 +984,7 @@ actor TerminalEngine {
     // MARK: - CSI Dispatch → CSIHandler (A.10)
 
     /// Dispatch a CSI sequence. Finalizes parameters, then delegates to CSIHandler.
-    private func handleCSIDispatch(_ byte: UInt8) async {
+    private func handleCSIDispatch(_ byte: UInt8) -> ParserEffect? {
         // Finalize the last parameter being collected
         if hasCurrentParam || !params.isEmpty {
             finalizeCurrentParam()
@@ -620,17 +994,15 @@ actor TerminalEngine {
             let ch = Character(UnicodeScalar(byte))
             let pos = grid.cursorPosition()
             let marker = privateMarker > 0 ? String(Character(UnicodeScalar(privateMarker))) : ""
-            Self.parserLog.debug("CSI \(marker)\(self.params) \(ch) at (\(pos.row),\(pos.col))")
+            Self.parserLog.debug("CSI \(marker)\(self.params.groups) \(ch) at (\(pos.row),\(pos.col))")
         }
 
-        await CSIHandler.dispatch(
+        return CSIHandler.dispatch(
             byte: byte,
             params: params,
             privateMarker: privateMarker,
             intermediates: intermediates,
-            grid: grid,
-            responseHandler: responseHandler,
-            inputModeState: inputModeState
+            grid: grid
         )
     }
 
@@ -641,9 +1013,10 @@ actor TerminalEngine {
         await OSCHandler.dispatch(
             oscString: oscString,
             grid: grid,
-            responseHandler: responseHandler,
-            semanticPromptHandler: semanticPromptEventHandler
+            responseHandler: isReplayingOutput ? nil : responseHandler,
+            semanticPromptHandler: isReplayingOutput ? nil : semanticPromptEventHandler
         )
+        resetStringPayload(&oscString)
     }
 
     // MARK: - DCS Dispatch → DCSHandler (A.14)
@@ -654,9 +1027,24 @@ actor TerminalEngine {
             data: dcsData,
             params: dcsParams,
             intermediates: dcsIntermediates,
+            finalByte: dcsFinalByte,
+            grid: grid,
+            responseHandler: isReplayingOutput ? nil : responseHandler
+        )
+        resetStringPayload(&dcsData)
+    }
+
+    // MARK: - APC Dispatch → InlineImageHandler
+
+    /// Dispatch a collected APC string. Only kitty graphics (APC G) is
+    /// understood; anything else is dropped, as before.
+    private func handleAPCDispatch() async {
+        await InlineImageHandler.handleKittyCommand(
+            apcData,
             grid: grid,
-            responseHandler: responseHandler
+            responseHandler: isReplayingOutput ? nil : responseHandler
         )
+        resetStringPayload(&apcData)
     }
 
     // MARK: - Response Handler
@@ -683,25 +1071,211 @@ actor TerminalEngine {
         }
     }
 
+    // MARK: - Background Resize
+
+    /// Reflow on resize off the actor so streaming output is never held up
+    /// behind a large scrollback (see `resize(newColumns:newRows:)`).
+    func setBackgroundResizeEnabled(_ enabled: Bool) {
+        backgroundResizeEnabled = enabled
+        if !enabled {
+            finishPendingResizeSynchronously()
+        }
+    }
+
+    // MARK: - Compact Snapshots
+
+    /// Publish live snapshots as raw grid cells for GPU expansion (see
+    /// `GridSnapshot.compactCells`).
+    func setCompactSnapshotsEnabled(_ enabled: Bool) {
+        finishPendingResizeSynchronously()
+        grid.setCompactSnapshots(enabled)
+    }
+
+    /// Compact the grid while no pane shows the session (see
+    /// `TerminalGrid.hibernate()`). Output keeps parsing as usual.
+    func hibernate() {
+        finishPendingResizeSynchronously()
+        grid.hibernate()
+    }
+
+    /// Reflow a copy of the grid on a detached task while `grid` keeps taking
+    /// output, then swap the result in and replay that output onto it.
+    /// Returns once the new grid is live; the actor stays free meanwhile.
+    private func resizeInBackground(newColumns: Int, newRows: Int) async {
+        // A newer resize supersedes the one in flight; its callers wait on this one.
+        let waiters = pendingResize?.waiters ?? []
+        resizeGeneration += 1
+        let generation = resizeGeneration
+        pendingResize = PendingResize(generation: generation, columns: newColumns, rows: newRows, waiters: waiters)
+
+        let copy = TerminalGrid(copying: grid)
+        Task.detached(priority: .userInitiated) { [weak self] in
+            copy.resize(newColumns: newColumns, newRows: newRows)
+            await self?.finishBackgroundResize(copy, generation: generation)
+        }
+
+        await withCheckedContinuation { continuation in
+            if pendingResize?.generation == generation {
+                pendingResize?.waiters.append(continuation)
+            } else {
+                continuation.resume()
+            }
+        }
+    }
+
+    private func finishBackgroundResize(_ result: TerminalGrid, generation: Int) async {
+        guard pendingResize?.generation == generation else { return }
+        pendingResize?.result = result
+        // A running feed loop swaps it in at its next chunk boundary.
+        guard !isFeeding else { return }
+        await drainFeedQueue()
+    }
+
+    /// Keep a deep copy of each chunk parsed while a background resize is
+    /// in flight; borrowed storage is reclaimed once `feed` returns.
+    private func logForResizeReplay(_ chunk: Data) {
+        guard pendingResize != nil else { return }
+        pendingResize?.replayLog.append(chunk.withUnsafeBytes { Data($0) })
+        pendingResize?.replayByteCount += chunk.count
+        if let pending = pendingResize, pending.replayByteCount > Self.maxResizeReplayBytes {
+            finishPendingResizeSynchronously()
+        }
+    }
+
+    /// Swap a finished background resize into `grid` and replay the output
+    /// parsed since the copy was taken. Called only between chunks.
+    private func swapInFinishedResize() async {
+        guard let pending = pendingResize, let result = pending.result else { return }
+        pendingResize = nil
+
+        // Bells and sync frames already handed out must not be reported twice.
+        let unconsumedBells = grid.pendingBellCount
+        let unconsumedSyncExits = grid.syncExitSnapshots.count
+
+        grid.adoptState(from: result)
+        resetParserForReplay()
+        isReplayingOutput = true
+        for chunk in pending.replayLog {
+            await processChunk(chunk)
+        }
+        isReplayingOutput = false
+
+        grid.pendingBellCount = unconsumedBells
+        grid.syncExitSnapshots = Array(grid.syncExitSnapshots.suffix(unconsumedSyncExits))
+        grid.markAllDirty()
+        postStatus()
+        pending.waiters.forEach { $0.resume() }
+    }
+
+    /// Abandon an in-flight background resize and apply it to `grid`
+    /// directly; used before anything touches the grid outside the parser.
+    private func finishPendingResizeSynchronously() {
+        guard let pending = pendingResize else { return }
+        pendingResize = nil
+        grid.resize(newColumns: pending.columns, newRows: pending.rows)
+        postStatus()
+        pending.waiters.forEach { $0.resume() }
+    }
+
+    /// Background resizes start only in ground state, so replaying the log
+    /// from ground rebuilds whatever partial sequence the live parse is in.
+    private func resetParserForReplay() {
+        state = .ground
+        stateBeforeEscape = .ground
+        clearParams()
+        resetUTF8()
+        resetStringPayload(&oscString)
+        resetStringPayload(&dcsData)
+        resetStringPayload(&apcData)
+        stringUTF8Remaining = 0
+    }
+
     // MARK: - Grid Forwarding (for SessionManager)
 
     func snapshot() -> GridSnapshot { grid.snapshot() }
     func liveSnapshot() -> GridSnapshot { grid.liveSnapshot() }
     func snapshot(scrollOffset: Int) -> GridSnapshot { grid.snapshot(scrollOffset: scrollOffset) }
-    func resize(newColumns: Int, newRows: Int) { grid.resize(newColumns: newColumns, newRows: newRows) }
+    func scrollbackRingRows(positions: Range<Int>) -> ScrollbackRingRows {
+        grid.scrollbackRingRows(positions: positions)
+    }
+    func resize(newColumns: Int, newRows: Int) async {
+        guard backgroundResizeEnabled, !isFeeding, state == .ground, utf8Remaining == 0 else {
+            finishPendingResizeSynchronously()
+            grid.resize(newColumns: newColumns, newRows: newRows)
+            postStatus()
+            return
+        }
+        await resizeInBackground(newColumns: newColumns, newRows: newRows)
+    }
     func visibleText() -> [String] { grid.visibleText() }
-    func eraseInDisplay(mode: Int) { grid.eraseInDisplay(mode: mode) }
-    func moveCursorTo(row: Int, col: Int) { grid.moveCursorTo(row: row, col: col) }
-    func setLineFeedMode(_ enabled: Bool) { grid.setLineFeedMode(enabled) }
-    func setScrollRegion(top: Int, bottom: Int) { grid.setScrollRegion(top: top, bottom: bottom) }
-    func disableAlternateBuffer() { grid.disableAlternateBuffer() }
+    func visibleTextChanges(since version: UInt64) -> VisibleTextChanges { grid.visibleTextChanges(since: version) }
+    func historyTextExport() -> TerminalTextExport { grid.textExport() }
+    func keyframeSequence(scrollbackLines: Int) -> [UInt8] {
+        grid.keyframeSequence(scrollbackLines: scrollbackLines)
+    }
+    func promptScrollOffset(from scrollOffset: Int, direction: Int) -> Int? {
+        grid.promptScrollOffset(from: scrollOffset, direction: direction)
+    }
+    func lastCommandOutput(maxCharacters: Int) -> (text: String, scrollOffset: Int)? {
+        grid.lastCommandOutput(maxCharacters: maxCharacters)
+    }
+    func takeSemanticCommandOutput(maxCharacters: Int) -> String? {
+        grid.takeSemanticCommandOutput(maxCharacters: maxCharacters)
+    }
+    func foldCommandOutput(summary: CommandOutputFold.Summary, minimumLines: Int, newestOnly: Bool) -> Int? {
+        finishPendingResizeSynchronously()
+        return grid.foldCommandOutput(summary: summary, minimumLines: minimumLines, newestOnly: newestOnly)
+    }
+    func expandCommandOutput(_ id: Int) -> Bool {
+        finishPendingResizeSynchronously()
+        return grid.expandCommandOutput(id)
+    }
+    func expandAllCommandOutput() -> Int {
+        finishPendingResizeSynchronously()
+        return grid.expandAllCommandOutput()
+    }
+    var lastCommandOutputFoldID: Int? { grid.lastCommandOutputFoldID }
+    func visibleCommandOutputFolds() -> [CommandOutputFold] { grid.visibleCommandOutputFolds() }
+    /// Draws the expected echo of a keystroke ahead of the server (see
+    /// TerminalGrid+PredictiveEcho). Returns true when a publish would show
+    /// a change.
+    func predictEcho(of bytes: [UInt8]) -> Bool { grid.predictEcho(of: bytes) }
+    func eraseInDisplay(mode: Int) {
+        finishPendingResizeSynchronously()
+        grid.eraseInDisplay(mode: mode)
+    }
+    func moveCursorTo(row: Int, col: Int) {
+        finishPendingResizeSynchronously()
+        grid.moveCursorTo(row: row, col: col)
+    }
+    func setLineFeedMode(_ enabled: Bool) {
+        finishPendingResizeSynchronously()
+        grid.setLineFeedMode(enabled)
+    }
+    func setScrollRegion(top: Int, bottom: Int) {
+        finishPendingResizeSynchronously()
+        grid.setScrollRegion(top: top, bottom: bottom)
+    }
+    func disableAlternateBuffer() {
+        finishPendingResizeSynchronously()
+        grid.disableAlternateBuffer()
+        postStatus()
+    }
     func consumeBellCount() -> Int { grid.consumeBellCount() }
-    func consumeSyncExitSnapshots() -> [GridSnapshot] { grid.consumeSyncExitSnapshots() }
+    func consumeSyncExitSnapshots() -> [GridSnapshot] {
+        let snapshots = grid.consumeSyncExitSnapshots()
+        postStatus()
+        return snapshots
+    }
     func inputModeSnapshot() -> InputModeSnapshot { grid.inputModeSnapshot() }
+    func searchableScrollback() -> ScrollbackBuffer { grid.searchableScrollback() }
 
     var synchronizedOutput: Bool { grid.synchronizedOutput }
     var usingAlternateBuffer: Bool { grid.usingAlternateBuffer }
     var scrollbackCount: Int { grid.scrollbackCount }
+    var scrollbackMemoryBytes: Int { grid.scrollbackMemoryBytes }
+    var memoryFootprint: MemoryFootprint { grid.memoryFootprint }
+    func trimScrollback(toLines lines: Int) { grid.trimScrollback(toLines: lines) }
     var windowTitle: String { grid.windowTitle }
     var workingDirectory: String { grid.workingDirectory }
     var focusReporting: Bool { grid.focusReporting }
@@ -717,6 +1291,15 @@ actor TerminalEngine {
     var autoWrapMode: Bool { grid.autoWrapMode }
     var scrollTop: Int { grid.scrollTop }
     var scrollBottom: Int { grid.scrollBottom }
+    var isBackgroundResizePending: Bool { pendingResize != nil }
+}
+
+// MARK: - MemoryFootprintReporting
+
+extension TerminalEngine: MemoryFootprintReporting {
+    func memoryFootprint(for sessionID: UUID) -> MemoryFootprint {
+        memoryFootprint
+    }
 }
 
 // MARK: - Transition Type
@@ -0,0 +1,69 @@
+// TerminalEngineMailbox.swift
+// ProSSHV2
+//
+// Lock-free status hand-off from a TerminalEngine to the rendering side.
+//
+// After each feed the engine packs the grid flags the publish path needs
+// into one atomic word. SessionShellIOCoordinator and
+// TerminalRenderingCoordinator read it without awaiting the engine actor,
+// so deciding how to publish a parsed chunk costs no executor hops; only
+// the snapshot itself is still requested from the engine.
+
+import Foundation
+import Synchronization
+
+// MARK: - TerminalEngineStatus
+
+/// Grid state published after a feed. Packed into a UInt64:
+/// bit 0 synchronized output, bit 1 alternate buffer, bit 2 pending
+/// sync-exit snapshots, bits 32–63 scrollback line count.
+nonisolated struct TerminalEngineStatus: Equatable, Sendable {
+    var synchronizedOutput = false
+    var usingAlternateBuffer = false
+    var hasSyncExitSnapshots = false
+    var scrollbackCount = 0
+
+    init(
+        synchronizedOutput: Bool = false,
+        usingAlternateBuffer: Bool = false,
+        hasSyncExitSnapshots: Bool = false,
+        scrollbackCount: Int = 0
+    ) {
+        self.synchronizedOutput = synchronizedOutput
+        self.usingAlternateBuffer = usingAlternateBuffer
+        self.hasSyncExitSnapshots = hasSyncExitSnapshots
+        self.scrollbackCount = scrollbackCount
+    }
+
+    init(packed: UInt64) {
+        synchronizedOutput = packed & 0b001 != 0
+        usingAlternateBuffer = packed & 0b010 != 0
+        hasSyncExitSnapshots = packed & 0b100 != 0
+        scrollbackCount = Int(packed >> 32)
+    }
+
+    var packed: UInt64 {
+        var word = UInt64(UInt32(clamping: scrollbackCount)) << 32
+        if synchronizedOutput { word |= 0b001 }
+        if usingAlternateBuffer { word |= 0b010 }
+        if hasSyncExitSnapshots { word |= 0b100 }
+        return word
+    }
+}
+
+// MARK: - TerminalEngineMailbox
+
+/// Single-slot, last-writer-wins mailbox. The engine is the only writer.
+nonisolated final class TerminalEngineMailbox: Sendable {
+
+    private let word = Atomic<UInt64>(0)
+
+    /// Latest status posted by the engine.
+    var status: TerminalEngineStatus {
+        TerminalEngineStatus(packed: word.load(ordering: .acquiring))
+    }
+
+    func post(_ status: TerminalEngineStatus) {
+        word.store(status.packed, ordering: .releasing)
+    }
+}
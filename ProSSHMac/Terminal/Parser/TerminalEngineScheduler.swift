@@ -0,0 +1,239 @@
+// TerminalEngineScheduler.swift
+// ProSSHV2
+//
+// Runs every TerminalEngine on one small pool of worker threads, one per
+// performance core. Each engine used to get its own serial dispatch queue,
+// and GCD gave all of those queues the same share of the machine. A pane
+// flooding with `cat /dev/urandom | base64` then competed on equal terms
+// with the pane being typed in, and ten busy panes could take every core.
+//
+// Each engine has a TerminalEngineExecutor, a SerialExecutor that queues
+// the actor's jobs and hands itself to the pool when it has work. Workers
+// take the executor with the highest render tier (focused, visible, then
+// hidden), round-robin within a tier, run one job, and put the executor at
+// the back of its tier if more jobs are waiting. Every `fairnessInterval`
+// picks, the lowest waiting tier goes first, so hidden panes slow down but
+// are never starved.
+//
+// One actor job can still parse a very large batch. The engine therefore
+// counts what it parses. After `quantumBytes` it yields when other
+// executors are waiting (`TerminalEngineExecutor.shouldYield`), and its
+// remaining work goes to the back of its tier. The tier comes from
+// TerminalRenderingCoordinator.setRenderTier.
+
+import Foundation
+import Synchronization
+
+// MARK: - TerminalEngineRunQueue
+
+/// Executors waiting for a worker, one FIFO per tier. Pure bookkeeping;
+/// TerminalEngineScheduler guards it with its lock.
+nonisolated struct TerminalEngineRunQueue<Element> {
+
+    private var tiers: [[Element]]
+    private var heads: [Int]
+    private var picks = 0
+
+    /// Every this many picks the lowest waiting tier is served first.
+    let fairnessInterval: Int
+
+    init(fairnessInterval: Int = TerminalEngineScheduler.fairnessInterval) {
+        let tierCount = SessionRenderTier.focused.rawValue + 1
+        self.tiers = Array(repeating: [], count: tierCount)
+        self.heads = Array(repeating: 0, count: tierCount)
+        self.fairnessInterval = max(fairnessInterval, 1)
+    }
+
+    private(set) var count = 0
+
+    var isEmpty: Bool { count == 0 }
+
+    mutating func push(_ element: Element, tier: SessionRenderTier) {
+        tiers[tier.rawValue].append(element)
+        count += 1
+    }
+
+    /// The next element: the oldest in the highest waiting tier, or in the
+    /// lowest one on a fairness pick.
+    mutating func pop() -> Element? {
+        guard count > 0 else { return nil }
+        picks += 1
+        let waiting = tiers.indices.filter { heads[$0] < tiers[$0].count }
+        let tier = picks % fairnessInterval == 0 ? waiting.first! : waiting.last!
+        let element = tiers[tier][heads[tier]]
+        heads[tier] += 1
+        if heads[tier] == tiers[tier].count {
+            tiers[tier].removeAll(keepingCapacity: true)
+            heads[tier] = 0
+        }
+        count -= 1
+        return element
+    }
+}
+
+// MARK: - TerminalEngineScheduler
+
+nonisolated final class TerminalEngineScheduler: @unchecked Sendable {
+
+    static let shared = TerminalEngineScheduler()
+
+    /// Bytes an engine parses before it offers its worker to waiting
+    /// sessions: well under a millisecond of parsing, large enough that a
+    /// lone flood does not notice the check.
+    static let quantumBytes = 64 * 1024
+
+    /// See TerminalEngineRunQueue.
+    static let fairnessInterval = 8
+
+    let workerCount: Int
+
+    private let condition = NSCondition()
+    private var runQueue = TerminalEngineRunQueue<TerminalEngineExecutor>()
+    private var startedWorkers = 0
+    /// Executors in `runQueue`, readable without the lock.
+    private let waitingCount = Atomic<Int>(0)
+
+    /// Defaults to one worker per performance core (all cores where the
+    /// machine does not report performance levels), at least two so one
+    /// long job never holds up every session.
+    init(workerCount: Int = TerminalEngineScheduler.performanceCoreCount()) {
+        self.workerCount = max(workerCount, 1)
+    }
+
+    /// Physical performance cores, or the active processor count when the
+    /// machine has a single core type.
+    static func performanceCoreCount() -> Int {
+        var cores: Int32 = 0
+        var size = MemoryLayout<Int32>.size
+        if sysctlbyname("hw.perflevel0.physicalcpu", &cores, &size, nil, 0) == 0, cores > 0 {
+            return max(Int(cores), 2)
+        }
+        return max(ProcessInfo.processInfo.activeProcessorCount, 2)
+    }
+
+    /// Whether any executor is waiting for a worker.
+    var hasWaitingWork: Bool {
+        waitingCount.load(ordering: .relaxed) > 0
+    }
+
+    // MARK: - Executors
+
+    /// Queue `executor` for a worker. Called when it gets its first job.
+    fileprivate func schedule(_ executor: TerminalEngineExecutor, tier: SessionRenderTier) {
+        condition.lock()
+        runQueue.push(executor, tier: tier)
+        waitingCount.store(runQueue.count, ordering: .relaxed)
+        if startedWorkers < workerCount {
+            startedWorkers += 1
+            startWorker(startedWorkers)
+        }
+        condition.signal()
+        condition.unlock()
+    }
+
+    private func startWorker(_ number: Int) {
+        let thread = Thread { [self] in
+            while true {
+                condition.lock()
+                while runQueue.isEmpty {
+                    condition.wait()
+                }
+                let executor = runQueue.pop()!
+                waitingCount.store(runQueue.count, ordering: .relaxed)
+                condition.unlock()
+                executor.runNextJob()
+            }
+        }
+        thread.name = "com.prossh.terminal-engine.\(number)"
+        thread.qualityOfService = .userInitiated
+        thread.start()
+    }
+}
+
+// MARK: - TerminalEngineExecutor
+
+/// Serial executor for one TerminalEngine. At most one of its jobs runs at
+/// a time: the executor is either idle, in the scheduler's run queue or on
+/// a worker, never in two of those at once.
+nonisolated final class TerminalEngineExecutor: SerialExecutor, @unchecked Sendable {
+
+    let scheduler: TerminalEngineScheduler
+
+    private let lock = NSLock()
+    private var jobs: [UnownedJob] = []
+    private var jobsHead = 0
+    /// Queued in the scheduler or running on a worker.
+    private var isScheduled = false
+    private var runningThread: Thread?
+    private let tierValue = Atomic<Int>(SessionRenderTier.focused.rawValue)
+
+    init(scheduler: TerminalEngineScheduler = .shared) {
+        self.scheduler = scheduler
+    }
+
+    /// Render tier of the session; takes effect the next time the executor
+    /// is queued.
+    var tier: SessionRenderTier {
+        get { SessionRenderTier(rawValue: tierValue.load(ordering: .relaxed)) ?? .focused }
+        set { tierValue.store(newValue.rawValue, ordering: .relaxed) }
+    }
+
+    /// Other executors are waiting for a worker, so a long-running engine
+    /// should give its turn up.
+    var shouldYield: Bool {
+        scheduler.hasWaitingWork
+    }
+
+    func enqueue(_ job: consuming ExecutorJob) {
+        let job = UnownedJob(job)
+        lock.lock()
+        jobs.append(job)
+        let needsScheduling = !isScheduled
+        isScheduled = true
+        lock.unlock()
+        if needsScheduling {
+            scheduler.schedule(self, tier: tier)
+        }
+    }
+
+    func asUnownedSerialExecutor() -> UnownedSerialExecutor {
+        UnownedSerialExecutor(ordinary: self)
+    }
+
+    func checkIsolated() {
+        lock.lock()
+        let isCurrent = runningThread === Thread.current
+        lock.unlock()
+        precondition(isCurrent, "Not running on this TerminalEngine's executor")
+    }
+
+    /// Run one job on the calling worker, then queue the executor again if
+    /// more are waiting.
+    fileprivate func runNextJob() {
+        lock.lock()
+        let job = jobs[jobsHead]
+        jobsHead += 1
+        runningThread = Thread.current
+        lock.unlock()
+
+        job.runSynchronously(on: asUnownedSerialExecutor())
+
+        lock.lock()
+        runningThread = nil
+        if jobsHead == jobs.count {
+            jobs.removeAll(keepingCapacity: true)
+            jobsHead = 0
+            isScheduled = false
+        } else if jobsHead >= 64, jobsHead * 2 >= jobs.count {
+            // Compact occasionally so a busy engine's queue does not keep
+            // a large head offset.
+            jobs.removeFirst(jobsHead)
+            jobsHead = 0
+        }
+        let hasMore = isScheduled
+        lock.unlock()
+        if hasMore {
+            scheduler.schedule(self, tier: tier)
+        }
+    }
+}
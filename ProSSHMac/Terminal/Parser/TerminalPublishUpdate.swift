@@ -0,0 +1,162 @@
+// TerminalPublishUpdate.swift
+// ProSSHV2
+//
+// One publish's worth of engine state, gathered on the engine's executor.
+// TerminalRenderingCoordinator used to collect a publish piece by piece
+// from the main actor: scrollback count, buffer, snapshot, then visible
+// text, bells, input modes, title and working directory. That is up to
+// nine hops per publish per session, and the scroll-anchor arithmetic
+// and text diffing ran on the main thread between them. Now the
+// coordinator sends the little main-actor state a publish depends on in a
+// `TerminalPublishRequest`. The engine does the work and answers with one
+// `TerminalPublishUpdate` holding only what the UI applies.
+
+import Foundation
+
+// MARK: - TerminalPublishRequest
+
+nonisolated struct TerminalPublishRequest: Sendable {
+    /// The viewport's scroll offset as of the previous publish.
+    var scrollOffset: Int
+    var previousScrollbackCount: Int
+    /// Nil when the coordinator has not decided; then an offset viewport
+    /// keeps its anchor.
+    var preserveScrollAnchor: Bool?
+    /// False when the caller already holds the snapshot to publish.
+    var takesSnapshot = true
+    /// Nil to skip housekeeping for this publish.
+    var housekeeping: TerminalHousekeepingRequest?
+}
+
+nonisolated struct TerminalHousekeepingRequest: Sendable {
+    /// The shell buffer is due a refresh.
+    var wantsShellText: Bool
+    /// `TerminalHousekeeping.textVersion` of the lines the UI shows; nil
+    /// when it shows none, so the full text is sent.
+    var publishedTextVersion: UInt64?
+}
+
+// MARK: - TerminalPublishUpdate
+
+nonisolated struct TerminalPublishUpdate: Sendable {
+    var snapshot: GridSnapshot?
+    var scrollOffset: Int
+    var scrollbackCount: Int
+    var usingAlternateBuffer: Bool
+    /// The anchor decision to keep for the next publish; nil leaves it
+    /// undecided.
+    var preserveScrollAnchor: Bool?
+    var housekeeping: TerminalHousekeeping?
+}
+
+nonisolated struct TerminalHousekeeping: Sendable {
+    enum ShellText: Sendable {
+        /// Text is not due, or the alternate buffer is showing.
+        case notPublished
+        /// Nothing changed since the published lines.
+        case unchanged
+        case lines([String])
+    }
+
+    var shellText: ShellText
+    /// The grid's text version as of `shellText`; sent back as
+    /// `publishedTextVersion` once the lines are applied.
+    var textVersion: UInt64 = 0
+    var bellCount: Int
+    var inputModes: InputModeSnapshot
+    var windowTitle: String
+    var workingDirectory: String
+}
+
+// MARK: - TerminalEngine
+
+extension TerminalEngine {
+
+    /// Everything one publish needs, in a single hop.
+    func publishUpdate(_ request: TerminalPublishRequest) -> TerminalPublishUpdate {
+        let scrollbackCount = grid.scrollbackCount
+        let usingAlternateBuffer = grid.usingAlternateBuffer
+        let viewport = Self.resolveViewport(
+            request,
+            scrollbackCount: scrollbackCount,
+            usingAlternateBuffer: usingAlternateBuffer
+        )
+
+        var snapshot: GridSnapshot?
+        if request.takesSnapshot {
+            snapshot = viewport.scrollOffset > 0
+                ? grid.snapshot(scrollOffset: viewport.scrollOffset)
+                : grid.snapshot()
+        }
+
+        return TerminalPublishUpdate(
+            snapshot: snapshot,
+            scrollOffset: viewport.scrollOffset,
+            scrollbackCount: scrollbackCount,
+            usingAlternateBuffer: usingAlternateBuffer,
+            preserveScrollAnchor: viewport.preserveScrollAnchor,
+            housekeeping: request.housekeeping.map { housekeeping($0, usingAlternateBuffer: usingAlternateBuffer) }
+        )
+    }
+
+    /// Housekeeping alone, for the end of a coalesced publish run.
+    func housekeeping(_ request: TerminalHousekeepingRequest) -> TerminalHousekeeping {
+        housekeeping(request, usingAlternateBuffer: grid.usingAlternateBuffer)
+    }
+
+    private func housekeeping(
+        _ request: TerminalHousekeepingRequest,
+        usingAlternateBuffer: Bool
+    ) -> TerminalHousekeeping {
+        var shellText = TerminalHousekeeping.ShellText.notPublished
+        var textVersion: UInt64 = request.publishedTextVersion ?? 0
+        if !usingAlternateBuffer && request.wantsShellText {
+            // Only rows dirtied since the last read are re-extracted, and the
+            // lines are sent only when some row's text changed.
+            let changes = grid.visibleTextChanges(since: request.publishedTextVersion ?? 0)
+            textVersion = changes.version
+            if request.publishedTextVersion != nil, !changes.hasChanges {
+                shellText = .unchanged
+            } else {
+                shellText = .lines(changes.lines)
+            }
+        }
+        return TerminalHousekeeping(
+            shellText: shellText,
+            textVersion: textVersion,
+            bellCount: grid.consumeBellCount(),
+            inputModes: grid.inputModeSnapshot(),
+            windowTitle: grid.windowTitle,
+            workingDirectory: grid.workingDirectory
+        )
+    }
+
+    /// The viewport offset after new scrollback arrived. An offset viewport
+    /// that preserves its anchor moves with the appended lines. The
+    /// alternate buffer (TUI apps) always shows its live content, so any
+    /// residual offset from an earlier scroll is dropped on every publish.
+    nonisolated static func resolveViewport(
+        _ request: TerminalPublishRequest,
+        scrollbackCount: Int,
+        usingAlternateBuffer: Bool
+    ) -> (scrollOffset: Int, preserveScrollAnchor: Bool?) {
+        var offset = request.scrollOffset
+        var preserveAnchor = request.preserveScrollAnchor
+        if usingAlternateBuffer {
+            offset = 0
+            preserveAnchor = false
+        }
+        if !usingAlternateBuffer,
+           preserveAnchor ?? (offset > 0),
+           offset > 0,
+           scrollbackCount > request.previousScrollbackCount {
+            // Keep the same visible viewport while new lines append below.
+            offset += scrollbackCount - request.previousScrollbackCount
+        }
+        offset = max(0, min(offset, scrollbackCount))
+        if offset == 0 {
+            preserveAnchor = false
+        }
+        return (offset, preserveAnchor)
+    }
+}
@@ -0,0 +1,348 @@
+// TmuxControlParser.swift
+// ProSSHV2
+//
+// tmux control mode (`tmux -CC`). Instead of drawing its panes into one
+// screen, tmux announces itself with DCS 1000p and then speaks a line
+// protocol: `%output %<pane> <data>` carries each pane's own output with
+// control characters and backslashes escaped as `\ooo`, `%begin`/`%end`
+// (or `%error`) bracket command replies, and notifications such as
+// `%layout-change` describe windows and panes. `%exit` and ST end it.
+//
+// The parser sits in front of the session's TerminalEngine. Outside
+// control mode it only looks for the DCS 1000p introducer and hands
+// everything else back as ranges of the input, so the engine still parses
+// in place. Inside control mode it splits lines into notifications for
+// TmuxControlCoordinator, which feeds each pane's output to its own engine.
+
+import Foundation
+
+// MARK: - TmuxCommandReply
+
+/// Output of one command between `%begin` and `%end` or `%error`.
+nonisolated struct TmuxCommandReply: Equatable, Sendable {
+    let number: Int
+    /// Whether this control client sent the command (flags bit 0).
+    let fromClient: Bool
+    let succeeded: Bool
+    let lines: [String]
+}
+
+// MARK: - TmuxNotification
+
+/// A control mode line the parser understood. Unknown notifications are
+/// dropped; tmux adds new ones between releases.
+nonisolated enum TmuxNotification: Equatable, Sendable {
+    /// Output of pane `%pane`, unescaped.
+    case output(pane: Int, data: [UInt8])
+    case reply(TmuxCommandReply)
+    /// Window `@window` now has the panes in `layout` (see TmuxLayout).
+    case layoutChange(window: Int, layout: String)
+    case windowAdd(window: Int)
+    case windowClose(window: Int)
+    case windowRenamed(window: Int, name: String)
+    case windowPaneChanged(window: Int, pane: Int)
+    case sessionChanged(session: Int, name: String)
+    case sessionWindowChanged(session: Int, window: Int)
+    case exit(reason: String?)
+}
+
+// MARK: - TmuxControlParser
+
+/// Splits a shell output stream into terminal bytes and tmux control mode
+/// notifications. Keeps state between calls, so a line or the introducer
+/// may arrive split across reads.
+nonisolated struct TmuxControlParser {
+
+    /// A piece of parsed input, in stream order.
+    enum Segment: Equatable, Sendable {
+        /// Terminal output: this range of the bytes passed to `parse`.
+        case terminal(Range<Int>)
+        /// Terminal output held back from an earlier call, when what looked
+        /// like the start of the introducer turned out not to be one.
+        case terminalBytes([UInt8])
+        /// DCS 1000p: tmux switched this stream to control mode.
+        case controlModeStarted
+        case notification(TmuxNotification)
+        /// ST after control mode: terminal output follows.
+        case controlModeEnded
+    }
+
+    private enum State {
+        case terminal
+        case control
+        /// ESC seen at the start of a control mode line; ST ends the mode.
+        case controlEscape
+    }
+
+    /// ESC P 1 0 0 0 p
+    private static let introducer: [UInt8] = [0x1B, 0x50, 0x31, 0x30, 0x30, 0x30, 0x70]
+    /// Lines longer than this are cut; tmux `%output` lines stay well below.
+    static let maximumLineLength = 1 << 22
+
+    private var state = State.terminal
+    /// Bytes of the introducer matched at the end of the previous input.
+    private var introducerMatched = 0
+    private var line: [UInt8] = []
+    private var openReply: (number: Int, fromClient: Bool, lines: [String])?
+
+    init() {}
+
+    var isInControlMode: Bool {
+        state != .terminal
+    }
+
+    mutating func parse(_ bytes: [UInt8]) -> [Segment] {
+        bytes.withUnsafeBytes { parse($0) }
+    }
+
+    mutating func parse(_ bytes: UnsafeRawBufferPointer) -> [Segment] {
+        var segments: [Segment] = []
+        var index = 0
+        while index < bytes.count {
+            switch state {
+            case .terminal:
+                index = scanTerminal(bytes, from: index, into: &segments)
+            case .control, .controlEscape:
+                index = scanControl(bytes, from: index, into: &segments)
+            }
+        }
+        return segments
+    }
+
+    // MARK: - Terminal Output
+
+    /// Passes terminal bytes through up to the next introducer. Returns
+    /// where parsing continues.
+    private mutating func scanTerminal(
+        _ bytes: UnsafeRawBufferPointer,
+        from start: Int,
+        into segments: inout [Segment]
+    ) -> Int {
+        var index = start
+        if introducerMatched > 0 {
+            // Finish the match left open by the previous call.
+            while introducerMatched < Self.introducer.count, index < bytes.count,
+                  bytes[index] == Self.introducer[introducerMatched] {
+                introducerMatched += 1
+                index += 1
+            }
+            if introducerMatched == Self.introducer.count {
+                introducerMatched = 0
+                beginControlMode(into: &segments)
+                return index
+            }
+            if index == bytes.count { return index }
+            segments.append(.terminalBytes(Array(Self.introducer.prefix(introducerMatched))))
+            introducerMatched = 0
+        }
+
+        let runStart = index
+        while index < bytes.count {
+            guard bytes[index] == 0x1B else {
+                index += 1
+                continue
+            }
+            var matched = 1
+            while matched < Self.introducer.count, index + matched < bytes.count,
+                  bytes[index + matched] == Self.introducer[matched] {
+                matched += 1
+            }
+            if matched == Self.introducer.count {
+                if runStart < index { segments.append(.terminal(runStart..<index)) }
+                beginControlMode(into: &segments)
+                return index + matched
+            }
+            if index + matched == bytes.count {
+                // The input ends inside a possible introducer; hold it back.
+                if runStart < index { segments.append(.terminal(runStart..<index)) }
+                introducerMatched = matched
+                return bytes.count
+            }
+            index += 1
+        }
+        if runStart < index { segments.append(.terminal(runStart..<index)) }
+        return index
+    }
+
+    private mutating func beginControlMode(into segments: inout [Segment]) {
+        state = .control
+        line.removeAll(keepingCapacity: true)
+        openReply = nil
+        segments.append(.controlModeStarted)
+    }
+
+    // MARK: - Control Mode Lines
+
+    private mutating func scanControl(
+        _ bytes: UnsafeRawBufferPointer,
+        from start: Int,
+        into segments: inout [Segment]
+    ) -> Int {
+        var index = start
+        while index < bytes.count {
+            let byte = bytes[index]
+            index += 1
+            if state == .controlEscape {
+                if byte == 0x5C { // '\' completes ST
+                    state = .terminal
+                    segments.append(.controlModeEnded)
+                    return index
+                }
+                state = .control
+            }
+            if byte == 0x0A {
+                if line.last == 0x0D { line.removeLast() }
+                if let segment = finishLine() {
+                    segments.append(segment)
+                }
+                line.removeAll(keepingCapacity: true)
+            } else if byte == 0x1B, line.isEmpty {
+                state = .controlEscape
+            } else if line.count < Self.maximumLineLength {
+                line.append(byte)
+            }
+        }
+        return index
+    }
+
+    /// The segment for the completed `line`, if any.
+    private mutating func finishLine() -> Segment? {
+        if openReply != nil {
+            return continueReply()
+        }
+        if let output = Self.parseOutput(line) {
+            return .notification(output)
+        }
+        let text = String(decoding: line, as: UTF8.self)
+        let fields = text.split(separator: " ", omittingEmptySubsequences: false).map(String.init)
+        guard let keyword = fields.first, keyword.hasPrefix("%") else { return nil }
+
+        switch keyword {
+        case "%begin":
+            guard fields.count >= 3, let number = Int(fields[2]) else { return nil }
+            let flags = fields.count >= 4 ? Int(fields[3]) ?? 0 : 0
+            openReply = (number, flags & 1 != 0, [])
+            return nil
+        case "%layout-change":
+            guard fields.count >= 3, let window = Self.identifier(fields[1], sigil: "@") else { return nil }
+            return .notification(.layoutChange(window: window, layout: fields[2]))
+        case "%window-add":
+            guard fields.count >= 2, let window = Self.identifier(fields[1], sigil: "@") else { return nil }
+            return .notification(.windowAdd(window: window))
+        case "%window-close", "%unlinked-window-close":
+            guard fields.count >= 2, let window = Self.identifier(fields[1], sigil: "@") else { return nil }
+            return .notification(.windowClose(window: window))
+        case "%window-renamed":
+            guard fields.count >= 3, let window = Self.identifier(fields[1], sigil: "@") else { return nil }
+            return .notification(.windowRenamed(window: window, name: fields[2...].joined(separator: " ")))
+        case "%window-pane-changed":
+            guard fields.count >= 3,
+                  let window = Self.identifier(fields[1], sigil: "@"),
+                  let pane = Self.identifier(fields[2], sigil: "%") else { return nil }
+            return .notification(.windowPaneChanged(window: window, pane: pane))
+        case "%session-changed":
+            guard fields.count >= 3, let session = Self.identifier(fields[1], sigil: "$") else { return nil }
+            return .notification(.sessionChanged(session: session, name: fields[2...].joined(separator: " ")))
+        case "%session-window-changed":
+            guard fields.count >= 3,
+                  let session = Self.identifier(fields[1], sigil: "$"),
+                  let window = Self.identifier(fields[2], sigil: "@") else { return nil }
+            return .notification(.sessionWindowChanged(session: session, window: window))
+        case "%exit":
+            let reason = fields.count >= 2 ? fields[1...].joined(separator: " ") : nil
+            return .notification(.exit(reason: reason))
+        default:
+            return nil
+        }
+    }
+
+    /// Collects reply lines until the `%end` or `%error` that closes the
+    /// open `%begin`.
+    private mutating func continueReply() -> Segment? {
+        guard let reply = openReply else { return nil }
+        let text = String(decoding: line, as: UTF8.self)
+        let fields = text.split(separator: " ")
+        if fields.count >= 3, fields[0] == "%end" || fields[0] == "%error", Int(fields[2]) == reply.number {
+            openReply = nil
+            return .notification(.reply(TmuxCommandReply(
+                number: reply.number,
+                fromClient: reply.fromClient,
+                succeeded: fields[0] == "%end",
+                lines: reply.lines
+            )))
+        }
+        openReply?.lines.append(text)
+        return nil
+    }
+
+    // MARK: - Fields
+
+    private static let outputPrefix = Array("%output %".utf8)
+    private static let extendedOutputPrefix = Array("%extended-output %".utf8)
+
+    /// `%output %<pane> <data>` or `%extended-output %<pane> <age> ... : <data>`.
+    private static func parseOutput(_ line: [UInt8]) -> TmuxNotification? {
+        let isExtended: Bool
+        if line.starts(with: outputPrefix) {
+            isExtended = false
+        } else if line.starts(with: extendedOutputPrefix) {
+            isExtended = true
+        } else {
+            return nil
+        }
+        var index = isExtended ? extendedOutputPrefix.count : outputPrefix.count
+        var pane = 0
+        let digitsStart = index
+        while index < line.count, (0x30...0x39).contains(line[index]) {
+            pane = pane &* 10 &+ Int(line[index] - 0x30)
+            index += 1
+        }
+        guard index > digitsStart else { return nil }
+        if isExtended {
+            // Skip the age and any further fields up to " : ".
+            while index + 2 < line.count,
+                  !(line[index] == 0x20 && line[index + 1] == 0x3A && line[index + 2] == 0x20) {
+                index += 1
+            }
+            index += 2
+        }
+        guard index < line.count, line[index] == 0x20 else {
+            return .output(pane: pane, data: [])
+        }
+        return .output(pane: pane, data: unescape(line[(index + 1)...]))
+    }
+
+    /// Undoes tmux's `\ooo` escaping of control characters and backslashes.
+    static func unescape(_ escaped: ArraySlice<UInt8>) -> [UInt8] {
+        var data: [UInt8] = []
+        data.reserveCapacity(escaped.count)
+        var index = escaped.startIndex
+        while index < escaped.endIndex {
+            let byte = escaped[index]
+            if byte == 0x5C, index + 3 < escaped.endIndex,
+               let value = octalValue(escaped[(index + 1)...(index + 3)]) {
+                data.append(value)
+                index += 4
+                continue
+            }
+            data.append(byte)
+            index += 1
+        }
+        return data
+    }
+
+    private static func octalValue(_ digits: ArraySlice<UInt8>) -> UInt8? {
+        var value = 0
+        for digit in digits {
+            guard (0x30...0x37).contains(digit) else { return nil }
+            value = value * 8 + Int(digit - 0x30)
+        }
+        return value <= 0xFF ? UInt8(value) : nil
+    }
+
+    /// `@3`, `%12` or `$0` without its sigil.
+    static func identifier(_ field: String, sigil: Character) -> Int? {
+        guard field.first == sigil else { return nil }
+        return Int(field.dropFirst())
+    }
+}
@@ -0,0 +1,116 @@
+// UTF8TextDecoder.swift
+// ProSSHV2
+//
+// Bulk UTF-8 validate-and-decode for ground-state text.
+//
+// Box-drawing (htop/btop), Powerline prompts and CJK logs are runs of
+// multibyte sequences mixed with printable ASCII. Instead of feeding each
+// byte through the state machine and building a String per glyph, the
+// engine hands the whole run to `decodePrintableRun`, which emits Unicode
+// scalar values straight into a reusable buffer for
+// `TerminalGrid.printCodepoints`.
+//
+// Printable-ASCII stretches are classified 16 bytes per step with
+// `SIMD16<UInt8>` (NEON on Apple silicon). Multibyte sequences are decoded
+// with a strict table-3-7 check, so anything the slow path would replace
+// with U+FFFD (overlongs, surrogates, > U+10FFFF, truncated sequences)
+// ends the run and is left to the state machine.
+
+import Foundation
+
+// MARK: - UTF8TextDecoder
+
+nonisolated enum UTF8TextDecoder {
+
+    /// Decode one well-formed UTF-8 sequence starting at `index`.
+    /// Returns nil for invalid or incomplete sequences.
+    @inline(__always)
+    static func decodeScalar(
+        _ bytes: UnsafeBufferPointer<UInt8>,
+        at index: Int
+    ) -> (value: UInt32, length: Int)? {
+        let count = bytes.count
+        guard index < count else { return nil }
+        let b0 = bytes[index]
+
+        switch b0 {
+        case 0x00...0x7F:
+            return (UInt32(b0), 1)
+
+        case 0xC2...0xDF:
+            guard index + 1 < count else { return nil }
+            let b1 = bytes[index + 1]
+            guard b1 & 0xC0 == 0x80 else { return nil }
+            return (UInt32(b0 & 0x1F) << 6 | UInt32(b1 & 0x3F), 2)
+
+        case 0xE0...0xEF:
+            guard index + 2 < count else { return nil }
+            let b1 = bytes[index + 1]
+            let b2 = bytes[index + 2]
+            let lower: UInt8 = b0 == 0xE0 ? 0xA0 : 0x80
+            let upper: UInt8 = b0 == 0xED ? 0x9F : 0xBF
+            guard b1 >= lower, b1 <= upper, b2 & 0xC0 == 0x80 else { return nil }
+            return (UInt32(b0 & 0x0F) << 12 | UInt32(b1 & 0x3F) << 6 | UInt32(b2 & 0x3F), 3)
+
+        case 0xF0...0xF4:
+            guard index + 3 < count else { return nil }
+            let b1 = bytes[index + 1]
+            let b2 = bytes[index + 2]
+            let b3 = bytes[index + 3]
+            let lower: UInt8 = b0 == 0xF0 ? 0x90 : 0x80
+            let upper: UInt8 = b0 == 0xF4 ? 0x8F : 0xBF
+            guard b1 >= lower, b1 <= upper,
+                  b2 & 0xC0 == 0x80, b3 & 0xC0 == 0x80 else { return nil }
+            return (
+                UInt32(b0 & 0x07) << 18 | UInt32(b1 & 0x3F) << 12
+                    | UInt32(b2 & 0x3F) << 6 | UInt32(b3 & 0x3F),
+                4
+            )
+
+        default:
+            return nil
+        }
+    }
+
+    /// Decode the longest run of printable text starting at `start`:
+    /// printable ASCII (0x20–0x7E) and well-formed multibyte sequences.
+    /// Stops before any control byte, DEL, invalid or truncated sequence.
+    /// Appends scalar values to `scalars` and returns the end index.
+    static func decodePrintableRun(
+        _ bytes: UnsafeBufferPointer<UInt8>,
+        from start: Int,
+        into scalars: inout [UInt32]
+    ) -> Int {
+        guard let base = bytes.baseAddress else { return start }
+        let count = bytes.count
+        let space = SIMD16<UInt8>(repeating: 0x20)
+        let printableSpan = SIMD16<UInt8>(repeating: 0x7F - 0x20)
+        var index = start
+
+        while index < count {
+            // Vector step: 16 printable ASCII bytes at once.
+            if index + 16 <= count {
+                let block = UnsafeRawPointer(base + index).loadUnaligned(as: SIMD16<UInt8>.self)
+                if all((block &- space) .< printableSpan) {
+                    for lane in 0..<16 {
+                        scalars.append(UInt32(block[lane]))
+                    }
+                    index += 16
+                    continue
+                }
+            }
+
+            let byte = base[index]
+            if byte < 0x80 {
+                guard byte >= 0x20, byte != 0x7F else { break }
+                scalars.append(UInt32(byte))
+                index += 1
+                continue
+            }
+            guard let decoded = decodeScalar(bytes, at: index) else { break }
+            scalars.append(decoded.value)
+            index += decoded.length
+        }
+        return index
+    }
+}
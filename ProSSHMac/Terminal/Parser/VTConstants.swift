@@ -26,6 +26,8 @@ nonisolated enum ParserState: UInt8, Sendable {
     case dcsIgnore          = 11
     case oscString          = 12
     case sosPmApcString     = 13
+    /// APC collected for the kitty graphics protocol (ESC _ G ... ST).
+    case apcString          = 14
 }
 
 // MARK: - Parser Actions
@@ -47,6 +49,9 @@ nonisolated enum ParserAction: UInt8, Sendable {
     case dcsPut         = 12  // Pass byte to DCS handler
     case dcsUnhook      = 13  // End DCS handler
     case put            = 14  // Generic put for passthrough modes
+    case apcStart       = 15  // Begin collecting APC string
+    case apcPut         = 16  // Add byte to APC string
+    case apcEnd         = 17  // Dispatch APC string
 }
 
 // MARK: - C0 Control Characters
@@ -411,6 +416,7 @@ nonisolated enum OSCCommand {
     static let clipboard: Int             = 52
     static let resetCursorColor: Int      = 112
     static let semanticPrompt: Int        = 133
+    static let iTermProprietary: Int      = 1337
 }
 
 // MARK: - Terminal Defaults
@@ -421,6 +427,11 @@ nonisolated enum TerminalDefaults {
     static let rows: Int = 24
     static let tabInterval: Int = 8
     static let maxScrollbackLines: Int = 10_000
+    /// Upper bound on encoded scrollback pages per terminal, in bytes.
+    static let maxScrollbackBytes: Int = 256 * 1024 * 1024
+    /// Scrollback pages (256 lines each) kept in memory; older pages spill
+    /// to an encrypted file.
+    static let scrollbackResidentPages: Int = 64
     static let defaultCursorStyle: CursorStyle = .block
 
     /// When true, bold + standard color (0–7) automatically brightens
@@ -457,11 +468,11 @@ nonisolated enum TerminalDefaults {
 
 /// Standard device attributes response strings.
 nonisolated enum DeviceAttributes {
-    /// Primary DA response: VT220 with ANSI color.
-    /// CSI ? 6 2 ; 2 2 c  (VT220, ANSI color)
+    /// Primary DA response: VT220 with sixel graphics and ANSI color.
+    /// CSI ? 6 2 ; 4 ; 2 2 c  (VT220, sixel, ANSI color)
     static let primaryResponse: [UInt8] = [
-        0x1B, 0x5B, 0x3F, 0x36, 0x32, 0x3B, 0x32, 0x32, 0x63
-        // ESC  [     ?     6     2     ;     2     2     c
+        0x1B, 0x5B, 0x3F, 0x36, 0x32, 0x3B, 0x34, 0x3B, 0x32, 0x32, 0x63
+        // ESC  [     ?     6     2     ;     4     ;     2     2     c
     ]
 
     /// Secondary DA response: xterm version 279.
@@ -494,11 +505,20 @@ nonisolated enum ParserLimits {
     /// Maximum number of intermediate bytes collected.
     static let maxIntermediates: Int = 2
 
-    /// Maximum length of an OSC string.
-    static let maxOSCLength: Int = 4096
+    /// Default cap on a collected OSC string. Large enough for OSC 52
+    /// clipboard pushes; `TerminalEngine.setStringPayloadLimits` overrides it.
+    static let maxOSCLength: Int = 1 << 20
 
-    /// Maximum length of a DCS string.
-    static let maxDCSLength: Int = 4096
+    /// Default cap on collected DCS data.
+    static let maxDCSLength: Int = 1 << 20
+
+    /// Cap on an inline image payload: sixel DCS, OSC 1337 File= and kitty
+    /// APC. Replaces the OSC and DCS caps for those strings only.
+    static let maxImagePayloadLength: Int = 64 << 20
+
+    /// Payload buffers that grew beyond this are released after dispatch
+    /// rather than kept around for the next string.
+    static let retainedStringCapacity: Int = 64 * 1024
 
     /// Default parameter value when omitted (most CSI commands treat 0 as 1).
     static let defaultParam: Int = 0
@@ -30,7 +30,7 @@ nonisolated struct VTParserTables: Sendable {
     static let shared = VTParserTables()
 
     /// Number of parser states (rawValue 0..<stateCount).
-    private static let stateCount = 14
+    private static let stateCount = 15
 
     /// Flat packed transition table: stateCount * 256 entries.
     /// Each UInt16 packs action (high byte) | nextState (low byte).
@@ -42,7 +42,7 @@ nonisolated struct VTParserTables: Sendable {
         .ground, .escape, .escapeIntermediate,
         .csiEntry, .csiParam, .csiIntermediate, .csiIgnore,
         .dcsEntry, .dcsParam, .dcsIntermediate, .dcsPassthrough, .dcsIgnore,
-        .oscString, .sosPmApcString
+        .oscString, .sosPmApcString, .apcString
     ]
 
     // MARK: - Initialization (Auto-Generation)
@@ -65,7 +65,7 @@ nonisolated struct VTParserTables: Sendable {
             UInt16(action.rawValue) << 8 | UInt16(next.rawValue)
         }
 
-        // CAN (0x18), SUB (0x1A), ESC (0x1B) — apply to ALL 14 states
+        // CAN (0x18), SUB (0x1A), ESC (0x1B) — apply to ALL 15 states
         for state in VTParserTables.allStates {
             let base = Int(state.rawValue) * 256
             flat[base + 0x18] = pack(.none, .ground)    // CAN
@@ -91,12 +91,13 @@ nonisolated struct VTParserTables: Sendable {
             flat[base + 0x9C] = pack(.none, .ground)           // ST
             flat[base + 0x9D] = pack(.oscStart, .oscString)    // OSC
             flat[base + 0x9E] = pack(.none, .sosPmApcString)   // PM
-            flat[base + 0x9F] = pack(.none, .sosPmApcString)   // APC
+            flat[base + 0x9F] = pack(.apcStart, .apcString)    // APC
         }
 
         // String state ST (0x9C) — per-state termination action
         flat[Int(ParserState.oscString.rawValue) * 256 + 0x9C] = pack(.oscEnd, .ground)
         flat[Int(ParserState.dcsPassthrough.rawValue) * 256 + 0x9C] = pack(.dcsUnhook, .ground)
+        flat[Int(ParserState.apcString.rawValue) * 256 + 0x9C] = pack(.apcEnd, .ground)
         // sosPmApcString 0x9C already → .none, .ground (from generateSosPmApc)
 
         self.flatTable = flat
@@ -148,6 +149,8 @@ nonisolated struct VTParserTables: Sendable {
             generateOSCString(&table)
         case .sosPmApcString:
             generateSosPmApc(&table)
+        case .apcString:
+            generateAPCString(&table)
         }
 
         return table
@@ -214,8 +217,8 @@ nonisolated struct VTParserTables: Sendable {
         set(&table, byte: 0x5D, action: .oscStart, next: .oscString)
         // 0x5E = '^' → PM
         set(&table, byte: 0x5E, action: .none, next: .sosPmApcString)
-        // 0x5F = '_' → APC
-        set(&table, byte: 0x5F, action: .none, next: .sosPmApcString)
+        // 0x5F = '_' → APC (collected for kitty graphics)
+        set(&table, byte: 0x5F, action: .apcStart, next: .apcString)
         set(&table, range: 0x60...0x7E, action: .escDispatch, next: .ground)
 
         // DEL: ignored
@@ -393,4 +396,16 @@ nonisolated struct VTParserTables: Sendable {
         set(&table, byte: 0x9C, action: .none, next: .ground) // ST
         set(&table, range: 0x9D...0xFF, action: .none, next: .sosPmApcString)
     }
+
+    // MARK: - APC String State
+
+    private static func generateAPCString(_ table: inout [VTTransition]) {
+        // C0 controls are ignored; kitty payloads are printable ASCII
+        set(&table, range: 0x00...0x17, action: .none, next: .apcString)
+        set(&table, byte: 0x19, action: .none, next: .apcString)
+        set(&table, range: 0x1C...0x1F, action: .none, next: .apcString)
+        // Everything else is collected. The post-generation overlay in
+        // init() overwrites 0x9C (ST) with the termination entry.
+        set(&table, range: 0x20...0xFF, action: .apcPut, next: .apcString)
+    }
 }
@@ -0,0 +1,574 @@
+// ZModemCodec.swift
+// ProSSHV2
+//
+// ZMODEM framing for transfers run through a session's terminal (see
+// InBandTransferCoordinator): spotting `sz` and `rz` as they start, ZDLE
+// escaping, hex and binary headers, and CRC-checked data subpackets.
+// Decoding is incremental, so a frame may straddle output reads.
+
+import Foundation
+
+// MARK: - Constants
+
+nonisolated enum ZModem {
+    static let pad: UInt8 = 0x2A
+    /// ZDLE, the escape byte. It is also CAN: five in a row abort.
+    static let escape: UInt8 = 0x18
+    static let binary16: UInt8 = 0x41
+    static let hex: UInt8 = 0x42
+    static let binary32: UInt8 = 0x43
+
+    /// ZRINIT capabilities, in ZF0.
+    static let canFullDuplex: UInt8 = 0x01
+    static let canOverlapIO: UInt8 = 0x02
+    static let canCRC32: UInt8 = 0x20
+    static let escapesControls: UInt8 = 0x40
+
+    /// ZFILE ZF0: the file is binary, no newline conversion.
+    static let binaryConversion: UInt8 = 0x01
+
+    /// Cancels a session from either side: eight CANs, then backspaces
+    /// erasing them from a terminal that shows them.
+    static let abortSequence: [UInt8] = Array(repeating: 0x18, count: 8) + Array(repeating: 0x08, count: 8)
+    /// What the sender says after the receiver's ZFIN.
+    static let overAndOut: [UInt8] = Array("OO".utf8)
+
+    enum FrameType: UInt8, Sendable {
+        case rqinit = 0, rinit, sinit, ack, file, skip, nak, abort, fin, rpos
+        case data, eof, ferr, crc, challenge, compl, can, freecnt, command, stderr
+
+        /// Frames followed by data subpackets.
+        var carriesData: Bool {
+            self == .file || self == .data || self == .sinit || self == .command
+        }
+    }
+
+    /// How a data subpacket ends: whether more follow in the frame, and
+    /// whether the receiver answers with ZACK.
+    enum FrameEnd: UInt8, Sendable {
+        /// Last of the frame, no answer.
+        case crcE = 0x68
+        /// More follow, no answer.
+        case crcG = 0x69
+        /// More follow, answered with ZACK.
+        case crcQ = 0x6A
+        /// Last of the frame, answered with ZACK.
+        case crcW = 0x6B
+
+        var continuesFrame: Bool { self == .crcG || self == .crcQ }
+        var wantsAck: Bool { self == .crcQ || self == .crcW }
+    }
+}
+
+// MARK: - ZModemHeader
+
+nonisolated struct ZModemHeader: Equatable, Sendable {
+    var type: ZModem.FrameType
+    /// The four header bytes, P0 (ZF3) first. A file position for ZRPOS,
+    /// ZDATA, ZEOF and ZACK; ZF0 flags in the top byte otherwise.
+    var argument: UInt32
+
+    init(_ type: ZModem.FrameType, argument: UInt32 = 0) {
+        self.type = type
+        self.argument = argument
+    }
+
+    /// Positions are 32 bits on the wire and wrap past 4 GiB.
+    init(_ type: ZModem.FrameType, position: Int64) {
+        self.init(type, argument: UInt32(truncatingIfNeeded: position))
+    }
+
+    /// ZRINIT: receive buffer size in ZP0-ZP1 (0 for full streaming) and
+    /// capabilities in ZF0.
+    static func receiverInit(bufferSize: UInt16 = 0, capabilities: UInt8) -> ZModemHeader {
+        ZModemHeader(.rinit, argument: UInt32(capabilities) << 24 | UInt32(bufferSize))
+    }
+
+    var flags: UInt8 { UInt8(truncatingIfNeeded: argument >> 24) }
+    var bufferSize: Int { Int(argument & 0xFFFF) }
+
+    /// The 64-bit position nearest `reference` whose low 32 bits this
+    /// header carries.
+    func position(near reference: Int64) -> Int64 {
+        let delta = Int64(Int32(bitPattern: argument &- UInt32(truncatingIfNeeded: reference)))
+        return max(0, reference + delta)
+    }
+
+    fileprivate var bytes: [UInt8] {
+        [type.rawValue] + (0..<4).map { UInt8(truncatingIfNeeded: argument >> ($0 * 8)) }
+    }
+}
+
+// MARK: - CRC
+
+nonisolated enum ZModemCRC {
+    private static let table16: [UInt16] = (0..<256).map { index -> UInt16 in
+        var value = UInt16(index) << 8
+        for _ in 0..<8 {
+            value = value & 0x8000 != 0 ? (value << 1) ^ 0x1021 : value << 1
+        }
+        return value
+    }
+
+    private static let table32: [UInt32] = (0..<256).map { index -> UInt32 in
+        var value = UInt32(index)
+        for _ in 0..<8 {
+            value = value & 1 == 1 ? 0xEDB8_8320 ^ (value >> 1) : value >> 1
+        }
+        return value
+    }
+
+    /// CRC-16/XMODEM, as hex and ZBIN frames carry it.
+    static func crc16<Bytes: Sequence<UInt8>>(_ bytes: Bytes, running crc: UInt16 = 0) -> UInt16 {
+        var crc = crc
+        for byte in bytes {
+            crc = (crc << 8) ^ table16[Int((crc >> 8) ^ UInt16(byte))]
+        }
+        return crc
+    }
+
+    /// Running CRC-32 state; the value sent is its complement.
+    static func crc32<Bytes: Sequence<UInt8>>(_ bytes: Bytes, running crc: UInt32 = 0xFFFF_FFFF) -> UInt32 {
+        var crc = crc
+        for byte in bytes {
+            crc = table32[Int((crc ^ UInt32(byte)) & 0xFF)] ^ (crc >> 8)
+        }
+        return crc
+    }
+}
+
+// MARK: - ZModemEncoder
+
+nonisolated struct ZModemEncoder {
+    /// CRC-32 binary frames, once the receiver offers CANFC32.
+    var usesCRC32 = true
+    /// Escape every control character, if the receiver asks (ESCCTL).
+    var escapesControls = false
+    private var lastByte: UInt8 = 0
+
+    init() {}
+
+    /// Hex headers are what each side sends first and what the receiver
+    /// answers with: printable, so they survive any line discipline.
+    static func hexHeader(_ header: ZModemHeader) -> [UInt8] {
+        let bytes = header.bytes
+        let crc = ZModemCRC.crc16(bytes)
+        var out: [UInt8] = [ZModem.pad, ZModem.pad, ZModem.escape, ZModem.hex]
+        for byte in bytes + [UInt8(crc >> 8), UInt8(crc & 0xFF)] {
+            out.append(hexDigits[Int(byte >> 4)])
+            out.append(hexDigits[Int(byte & 0x0F)])
+        }
+        out += [0x0D, 0x8A]
+        if header.type != .ack && header.type != .fin {
+            out.append(0x11)
+        }
+        return out
+    }
+
+    private static let hexDigits = Array("0123456789abcdef".utf8)
+
+    mutating func binaryHeader(_ header: ZModemHeader, into out: inout [UInt8]) {
+        out += [ZModem.pad, ZModem.escape, usesCRC32 ? ZModem.binary32 : ZModem.binary16]
+        let bytes = header.bytes
+        for byte in bytes {
+            append(byte, to: &out)
+        }
+        appendCRC(of: bytes, to: &out)
+    }
+
+    mutating func subpacket<Bytes: Collection<UInt8>>(_ data: Bytes, end: ZModem.FrameEnd, into out: inout [UInt8]) {
+        out.reserveCapacity(out.count + data.count + data.count / 16 + 16)
+        for byte in data {
+            append(byte, to: &out)
+        }
+        out += [ZModem.escape, end.rawValue]
+        if usesCRC32 {
+            appendCRC32(ZModemCRC.crc32(CollectionOfOne(end.rawValue), running: ZModemCRC.crc32(data)), to: &out)
+        } else {
+            appendCRC16(ZModemCRC.crc16(CollectionOfOne(end.rawValue), running: ZModemCRC.crc16(data)), to: &out)
+        }
+        if end == .crcW {
+            out.append(0x11)
+        }
+    }
+
+    private mutating func appendCRC(of bytes: [UInt8], to out: inout [UInt8]) {
+        if usesCRC32 {
+            appendCRC32(ZModemCRC.crc32(bytes), to: &out)
+        } else {
+            appendCRC16(ZModemCRC.crc16(bytes), to: &out)
+        }
+    }
+
+    private mutating func appendCRC32(_ running: UInt32, to out: inout [UInt8]) {
+        let crc = ~running
+        for shift in stride(from: 0, to: 32, by: 8) {
+            append(UInt8(truncatingIfNeeded: crc >> shift), to: &out)
+        }
+    }
+
+    private mutating func appendCRC16(_ crc: UInt16, to out: inout [UInt8]) {
+        append(UInt8(crc >> 8), to: &out)
+        append(UInt8(crc & 0xFF), to: &out)
+    }
+
+    /// Escapes ZDLE, the flow control bytes (DLE, XON, XOFF, with or
+    /// without the high bit) and CR after `@`, which telnet-like hops eat.
+    private mutating func append(_ byte: UInt8, to out: inout [UInt8]) {
+        let escapes: Bool
+        switch byte {
+        case 0x18, 0x10, 0x11, 0x13, 0x90, 0x91, 0x93:
+            escapes = true
+        case 0x0D, 0x8D:
+            escapes = escapesControls || lastByte & 0x7F == 0x40
+        default:
+            escapes = escapesControls && byte & 0x60 == 0
+        }
+        if escapes {
+            out.append(ZModem.escape)
+            out.append(byte ^ 0x40)
+        } else {
+            out.append(byte)
+        }
+        lastByte = byte
+    }
+}
+
+// MARK: - ZModemDecoder
+
+nonisolated struct ZModemDecoder {
+    enum Event: Equatable, Sendable {
+        case header(ZModemHeader)
+        /// A data subpacket; its bytes are in `payload` until the next call.
+        case subpacket(ZModem.FrameEnd)
+        /// A header or subpacket failed its CRC or was malformed.
+        case corrupt
+        /// Five CANs in a row: the other side cancelled.
+        case aborted
+    }
+
+    /// lrzsz sends at most 8 KiB; anything far past that is not a subpacket.
+    static let maximumSubpacketLength = 64 * 1024
+
+    private(set) var payload: [UInt8] = []
+    /// Bytes read since the last event while looking for a header: how
+    /// long the stream has not been ZMODEM.
+    private(set) var bytesSinceFrame = 0
+
+    private enum State {
+        case seeking, padded, kind, hexHeader, binaryHeader, data, dataCRC
+    }
+
+    private enum Unescaped {
+        case byte(UInt8), end(ZModem.FrameEnd), invalid, none
+    }
+
+    private var state = State.seeking
+    private var escaping = false
+    /// Set by the last header; its subpackets use the same CRC.
+    private var usesCRC32 = false
+    /// Header bytes, or a subpacket's CRC bytes, read so far.
+    private var frame: [UInt8] = []
+    private var hexHigh: UInt8?
+    private var end = ZModem.FrameEnd.crcE
+    private var cancels = 0
+    private var clearsPayload = false
+
+    init() {}
+
+    /// The next event in `bytes` from `offset`, which it advances. Nil
+    /// once `bytes` is used up mid-frame; the frame continues next call.
+    mutating func next(in bytes: UnsafeRawBufferPointer, at offset: inout Int) -> Event? {
+        if clearsPayload {
+            payload.removeAll(keepingCapacity: true)
+            clearsPayload = false
+        }
+        while offset < bytes.count {
+            if state == .data, !escaping {
+                // Copy runs of plain data at once.
+                let start = offset
+                while offset < bytes.count, !Self.isSpecial(bytes[offset]) {
+                    offset += 1
+                }
+                if offset > start {
+                    cancels = 0
+                    payload.append(contentsOf: UnsafeRawBufferPointer(rebasing: bytes[start..<offset]))
+                    if payload.count > Self.maximumSubpacketLength {
+                        return fail()
+                    }
+                    continue
+                }
+            }
+            let byte = bytes[offset]
+            offset += 1
+            if byte == ZModem.escape {
+                cancels += 1
+                if cancels >= 5 {
+                    cancels = 0
+                    _ = fail()
+                    return .aborted
+                }
+            } else {
+                cancels = 0
+            }
+            if let event = consume(byte) {
+                return event
+            }
+        }
+        return nil
+    }
+
+    private static func isSpecial(_ byte: UInt8) -> Bool {
+        byte == ZModem.escape || byte & 0x7F == 0x11 || byte & 0x7F == 0x13
+    }
+
+    private mutating func consume(_ byte: UInt8) -> Event? {
+        switch state {
+        case .seeking:
+            bytesSinceFrame += 1
+            if byte == ZModem.pad {
+                state = .padded
+            }
+        case .padded:
+            bytesSinceFrame += 1
+            if byte == ZModem.escape {
+                state = .kind
+            } else if byte != ZModem.pad {
+                state = .seeking
+            }
+        case .kind:
+            frame.removeAll(keepingCapacity: true)
+            hexHigh = nil
+            escaping = false
+            switch byte {
+            case ZModem.hex:
+                state = .hexHeader
+            case ZModem.binary16:
+                usesCRC32 = false
+                state = .binaryHeader
+            case ZModem.binary32:
+                usesCRC32 = true
+                state = .binaryHeader
+            default:
+                state = .seeking
+            }
+        case .hexHeader:
+            guard let nibble = Self.hexValue(byte) else { return fail() }
+            if let high = hexHigh {
+                frame.append(high << 4 | nibble)
+                hexHigh = nil
+                if frame.count == 7 {
+                    usesCRC32 = false
+                    return finishHeader()
+                }
+            } else {
+                hexHigh = nibble
+            }
+        case .binaryHeader:
+            switch unescape(byte) {
+            case .byte(let value):
+                frame.append(value)
+                if frame.count == (usesCRC32 ? 9 : 7) {
+                    return finishHeader()
+                }
+            case .end, .invalid:
+                return fail()
+            case .none:
+                break
+            }
+        case .data:
+            switch unescape(byte) {
+            case .byte(let value):
+                payload.append(value)
+                if payload.count > Self.maximumSubpacketLength {
+                    return fail()
+                }
+            case .end(let end):
+                self.end = end
+                frame.removeAll(keepingCapacity: true)
+                state = .dataCRC
+            case .invalid:
+                return fail()
+            case .none:
+                break
+            }
+        case .dataCRC:
+            switch unescape(byte) {
+            case .byte(let value):
+                frame.append(value)
+                if frame.count == (usesCRC32 ? 4 : 2) {
+                    return finishSubpacket()
+                }
+            case .end, .invalid:
+                return fail()
+            case .none:
+                break
+            }
+        }
+        return nil
+    }
+
+    private mutating func unescape(_ byte: UInt8) -> Unescaped {
+        if escaping {
+            escaping = false
+            switch byte {
+            case 0x68...0x6B:
+                return .end(ZModem.FrameEnd(rawValue: byte)!)
+            case 0x6C:
+                return .byte(0x7F)
+            case 0x6D:
+                return .byte(0xFF)
+            default:
+                return byte & 0x60 == 0x40 ? .byte(byte ^ 0x40) : .invalid
+            }
+        }
+        switch byte {
+        case ZModem.escape:
+            escaping = true
+            return .none
+        case 0x11, 0x13, 0x91, 0x93:
+            // Flow control from somewhere on the path, never data.
+            return .none
+        default:
+            return .byte(byte)
+        }
+    }
+
+    private mutating func finishHeader() -> Event {
+        let body = frame[0..<5]
+        let valid: Bool
+        if usesCRC32 {
+            valid = ~ZModemCRC.crc32(body) == Self.littleEndian(frame[5..<9])
+        } else {
+            valid = ZModemCRC.crc16(body) == UInt16(frame[5]) << 8 | UInt16(frame[6])
+        }
+        guard valid, let type = ZModem.FrameType(rawValue: frame[0]) else { return fail() }
+        let header = ZModemHeader(type, argument: Self.littleEndian(frame[1..<5]))
+        bytesSinceFrame = 0
+        if type.carriesData {
+            payload.removeAll(keepingCapacity: true)
+            state = .data
+        } else {
+            state = .seeking
+        }
+        return .header(header)
+    }
+
+    private mutating func finishSubpacket() -> Event {
+        let valid: Bool
+        if usesCRC32 {
+            let crc = ZModemCRC.crc32(CollectionOfOne(end.rawValue), running: ZModemCRC.crc32(payload))
+            valid = ~crc == Self.littleEndian(frame[0..<4])
+        } else {
+            let crc = ZModemCRC.crc16(CollectionOfOne(end.rawValue), running: ZModemCRC.crc16(payload))
+            valid = crc == UInt16(frame[0]) << 8 | UInt16(frame[1])
+        }
+        guard valid else { return fail() }
+        state = end.continuesFrame ? .data : .seeking
+        bytesSinceFrame = 0
+        clearsPayload = true
+        return .subpacket(end)
+    }
+
+    /// Drops the frame and goes back to looking for a header. The CAN
+    /// count survives, so an abort that broke a frame still registers.
+    private mutating func fail() -> Event {
+        state = .seeking
+        escaping = false
+        bytesSinceFrame = 0
+        clearsPayload = true
+        return .corrupt
+    }
+
+    private static func hexValue(_ byte: UInt8) -> UInt8? {
+        switch byte {
+        case 0x30...0x39: byte - 0x30
+        case 0x61...0x66: byte - 0x61 + 10
+        case 0x41...0x46: byte - 0x41 + 10
+        default: nil
+        }
+    }
+
+    private static func littleEndian(_ bytes: ArraySlice<UInt8>) -> UInt32 {
+        bytes.reversed().reduce(0) { $0 << 8 | UInt32($1) }
+    }
+}
+
+// MARK: - ZModemStartDetector
+
+/// Spots `sz` or `rz` starting in terminal output by the hex header each
+/// sends first: ZRQINIT (`**\x18B00`) from `sz`, ZRINIT (`**\x18B01`)
+/// from `rz`. Only ZDLE bytes are looked at closely, and they are rare
+/// outside ZMODEM; a header split across reads is still found.
+nonisolated struct ZModemStartDetector {
+    enum Role: Equatable, Sendable {
+        /// `sz` is sending: ZRQINIT.
+        case receive
+        /// `rz` is waiting for files: ZRINIT.
+        case send
+    }
+
+    struct Match: Equatable {
+        let role: Role
+        /// Where the header starts in the scanned bytes; 0 when it began
+        /// in an earlier read.
+        let offset: Int
+        /// The header bytes from earlier reads, to decode first.
+        let carried: [UInt8]
+    }
+
+    /// `**`, ZDLE, `B0`, then `0` or `1`.
+    private static let patternLength = 6
+    private var carry: [UInt8] = []
+
+    init() {}
+
+    mutating func reset() {
+        carry.removeAll()
+    }
+
+    mutating func scan(_ bytes: UnsafeRawBufferPointer) -> Match? {
+        defer { keepTail(of: bytes) }
+        if !carry.isEmpty {
+            let window = carry + bytes.prefix(Self.patternLength - 1)
+            for start in 0..<carry.count where start + Self.patternLength <= window.count {
+                if let role = Self.role(at: start, in: window) {
+                    return Match(role: role, offset: 0, carried: Array(window[start..<carry.count]))
+                }
+            }
+        }
+        guard let base = bytes.baseAddress else { return nil }
+        var index = 0
+        while index < bytes.count,
+              let found = memchr(base + index, Int32(ZModem.escape), bytes.count - index) {
+            let position = base.distance(to: UnsafeRawPointer(found))
+            let start = position - 2
+            if start >= 0, start + Self.patternLength <= bytes.count,
+               let role = Self.role(at: start, in: bytes) {
+                return Match(role: role, offset: start, carried: [])
+            }
+            index = position + 1
+        }
+        return nil
+    }
+
+    private static func role<Bytes: RandomAccessCollection<UInt8>>(at start: Int, in bytes: Bytes) -> Role? where Bytes.Index == Int {
+        guard bytes[start] == ZModem.pad, bytes[start + 1] == ZModem.pad,
+              bytes[start + 2] == ZModem.escape, bytes[start + 3] == ZModem.hex,
+              bytes[start + 4] == 0x30 else { return nil }
+        switch bytes[start + 5] {
+        case 0x30: return .receive
+        case 0x31: return .send
+        default: return nil
+        }
+    }
+
+    private mutating func keepTail(of bytes: UnsafeRawBufferPointer) {
+        let keep = Self.patternLength - 1
+        if bytes.count >= keep {
+            carry = Array(bytes.suffix(keep))
+        } else {
+            carry = Array((carry + bytes).suffix(keep))
+        }
+    }
+}
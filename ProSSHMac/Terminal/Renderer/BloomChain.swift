@@ -0,0 +1,228 @@
+// BloomChain.swift
+// ProSSHV2
+//
+// Compute bloom on a dual-filter mip chain. The old path rendered a bright
+// pass and then horizontal and vertical 13-tap fragment blurs, all at half
+// resolution and on every frame. That meant 27 texture reads per half-res
+// pixel.
+//
+// `bloom_downsample` applies the bright pass while it reduces the scene to
+// half size. It then halves each level into the next, down to
+// `maxLevels`. `bloom_upsample` walks back up the chain. At each level it
+// tent-filters the smaller result and adds the same-sized down level. Each
+// tap is one bilinear fetch that averages 2x2 texels, so a pixel costs 5
+// reads going down and 9 coming up. Most of those pixels are at quarter
+// size or smaller, and the glow reaches much further than the fixed kernel
+// did.
+//
+// The down levels are transient and shared between panes of the same size
+// (RenderResourceStore). The up levels belong to this pane. Level 0 is
+// the halo that the post pass samples, and it is kept between frames:
+// when the scene texture did not change and the bloom inputs are the same,
+// `encode` returns the cached halo and dispatches nothing.
+
+import Metal
+
+// MARK: - BloomChainParams
+
+/// Mirrors `BloomChainParams` in TerminalShaders.metal.
+nonisolated struct BloomChainParams: Sendable {
+    /// 1 / size of the texture being filtered.
+    var sourceTexel: SIMD2<Float>
+    /// Bright-pass luminance cutoff; negative for a plain downsample.
+    var threshold: Float
+    /// Output scale; the bloom radius on the last upsample, otherwise 1.
+    var gain: Float
+}
+
+// MARK: - BloomChain
+
+final class BloomChain {
+
+    /// Everything besides the scene that the halo depends on.
+    struct Inputs: Equatable {
+        var width: Int
+        var height: Int
+        var threshold: Float
+        var gain: Float
+    }
+
+    /// Levels below the half-size one stop at 1/32 of the drawable.
+    nonisolated static let maxLevels = 5
+
+    private let device: MTLDevice
+    private let downsamplePipeline: MTLComputePipelineState
+    private let upsamplePipeline: MTLComputePipelineState
+
+    /// Upsample results for every level but the smallest; `upLevels[0]`
+    /// is the halo.
+    private var upLevels: [MTLTexture] = []
+
+    /// Inputs the halo in `upLevels[0]` was built from; nil when there is
+    /// no usable halo.
+    private(set) var cachedInputs: Inputs?
+
+    /// `downsamplePipeline` and `upsamplePipeline` are the `bloom_downsample`
+    /// and `bloom_upsample` kernels from TerminalPipelineCache.
+    init(
+        device: MTLDevice,
+        downsamplePipeline: MTLComputePipelineState,
+        upsamplePipeline: MTLComputePipelineState
+    ) {
+        self.device = device
+        self.downsamplePipeline = downsamplePipeline
+        self.upsamplePipeline = upsamplePipeline
+    }
+
+    // MARK: - Levels
+
+    /// Sizes of the chain whose first level is `width` x `height`. Each level
+    /// halves the previous one, stopping at 1x1 or `maxLevels`.
+    nonisolated static func levelSizes(width: Int, height: Int) -> [SIMD2<Int>] {
+        guard width > 0, height > 0 else { return [] }
+        var sizes = [SIMD2(width, height)]
+        while sizes.count < maxLevels {
+            let last = sizes[sizes.count - 1]
+            guard last.x > 1 || last.y > 1 else { break }
+            sizes.append(SIMD2(max(1, last.x / 2), max(1, last.y / 2)))
+        }
+        return sizes
+    }
+
+    /// Texture descriptor for one chain level. The kernels both sample and
+    /// write these textures, and rgba8Unorm is writable on every Mac GPU.
+    nonisolated static func levelDescriptor(_ size: SIMD2<Int>) -> MTLTextureDescriptor {
+        let descriptor = MTLTextureDescriptor.texture2DDescriptor(
+            pixelFormat: .rgba8Unorm,
+            width: size.x,
+            height: size.y,
+            mipmapped: false
+        )
+        descriptor.usage = [.shaderRead, .shaderWrite]
+        descriptor.storageMode = .private
+        return descriptor
+    }
+
+    // MARK: - Cache
+
+    /// Whether the cached halo was built from `inputs`.
+    func isCurrent(for inputs: Inputs) -> Bool {
+        cachedInputs == inputs && !upLevels.isEmpty
+    }
+
+    /// Drop the cached halo so the next `encode` rebuilds it.
+    func invalidate() {
+        cachedInputs = nil
+    }
+
+    /// Free the per-pane textures while bloom is disabled.
+    func releaseTextures() {
+        upLevels = []
+        cachedInputs = nil
+    }
+
+    // MARK: - Encoding
+
+    /// Encode the chain from `scene` through the shared `downLevels` (sized
+    /// by `levelSizes`) and return the halo. When `sceneChanged` is false
+    /// and `inputs` match the cached halo, nothing is encoded and the cached
+    /// halo is returned. Nil if the chain cannot run.
+    func encode(
+        commandBuffer: MTLCommandBuffer,
+        scene: MTLTexture,
+        downLevels: [MTLTexture],
+        inputs: Inputs,
+        sceneChanged: Bool
+    ) -> MTLTexture? {
+        if !sceneChanged, isCurrent(for: inputs) {
+            return upLevels[0]
+        }
+        cachedInputs = nil
+        guard downLevels.count >= 2,
+              ensureUpLevels(matching: downLevels),
+              let encoder = commandBuffer.makeComputeCommandEncoder() else {
+            return nil
+        }
+        #if DEBUG
+        encoder.label = "BloomChain"
+        #endif
+
+        // Down: scene to level 0 through the bright pass, then level to level.
+        encoder.setComputePipelineState(downsamplePipeline)
+        var source = scene
+        for (index, target) in downLevels.enumerated() {
+            var params = BloomChainParams(
+                sourceTexel: Self.texel(of: source),
+                threshold: index == 0 ? inputs.threshold : -1,
+                gain: 1
+            )
+            encoder.setTexture(source, index: 0)
+            encoder.setTexture(target, index: 1)
+            encoder.setBytes(&params, length: MemoryLayout<BloomChainParams>.stride, index: 0)
+            dispatch(encoder, pipeline: downsamplePipeline, over: target)
+            source = target
+        }
+
+        // Up: from the smallest level back to level 0, adding each down level.
+        encoder.setComputePipelineState(upsamplePipeline)
+        for index in stride(from: upLevels.count - 1, through: 0, by: -1) {
+            let target = upLevels[index]
+            var params = BloomChainParams(
+                sourceTexel: Self.texel(of: source),
+                threshold: -1,
+                gain: index == 0 ? inputs.gain : 1
+            )
+            encoder.setTexture(source, index: 0)
+            encoder.setTexture(downLevels[index], index: 1)
+            encoder.setTexture(target, index: 2)
+            encoder.setBytes(&params, length: MemoryLayout<BloomChainParams>.stride, index: 0)
+            dispatch(encoder, pipeline: upsamplePipeline, over: target)
+            source = target
+        }
+        encoder.endEncoding()
+
+        cachedInputs = inputs
+        return upLevels[0]
+    }
+
+    // MARK: - Internals
+
+    private static func texel(of texture: MTLTexture) -> SIMD2<Float> {
+        SIMD2(1 / Float(max(1, texture.width)), 1 / Float(max(1, texture.height)))
+    }
+
+    private func dispatch(_ encoder: MTLComputeCommandEncoder, pipeline: MTLComputePipelineState, over target: MTLTexture) {
+        let width = pipeline.threadExecutionWidth
+        let height = max(1, pipeline.maxTotalThreadsPerThreadgroup / width)
+        encoder.dispatchThreadgroups(
+            MTLSize(
+                width: (target.width + width - 1) / width,
+                height: (target.height + height - 1) / height,
+                depth: 1
+            ),
+            threadsPerThreadgroup: MTLSize(width: width, height: height, depth: 1)
+        )
+    }
+
+    /// Allocate `upLevels` to match every down level but the smallest.
+    private func ensureUpLevels(matching downLevels: [MTLTexture]) -> Bool {
+        let needed = downLevels.dropLast()
+        let matches = upLevels.count == needed.count
+            && zip(upLevels, needed).allSatisfy { $0.width == $1.width && $0.height == $1.height }
+        if matches { return true }
+
+        var levels: [MTLTexture] = []
+        for (index, level) in needed.enumerated() {
+            guard let texture = device.makeTexture(
+                descriptor: Self.levelDescriptor(SIMD2(level.width, level.height))
+            ) else {
+                upLevels = []
+                return false
+            }
+            texture.label = "BloomUpsample[\(index)]"
+            levels.append(texture)
+        }
+        upLevels = levels
+        return true
+    }
+}
@@ -2,10 +2,22 @@
 // ProSSHV2
 //
 // CPU-to-GPU cell buffer bridge for the Metal terminal renderer.
-// Converts GridSnapshot data into MTLBuffers for instanced draw calls.
-// Uses double-buffering so the GPU can read buffer A while the CPU
-// writes to buffer B, avoiding pipeline stalls. Supports partial
-// updates (dirty ranges) and wide character handling.
+// Copies GridSnapshot cells into MTLBuffers for instanced draw calls.
+// Uses a ring of buffers so the GPU can read one while the CPU writes
+// another, avoiding pipeline stalls. Partial updates (dirty ranges) replay
+// only the damage each buffer missed, so upload size follows what changed. Cells keep their codepoint in `glyphIndex`;
+// the vertex shader resolves it through GPUGlyphTable and handles
+// wide-character continuation cells, so there is no per-cell CPU pass.
+// Snapshots carrying compact `TerminalCell`s are uploaded as-is (20 bytes a
+// cell) for the renderer's expansion kernel; buffers are sized for
+// `CellInstance`s so either form fits.
+//
+// A snapshot that scrolled the whole screen (GridSnapshot.scroll) is not
+// copied again in compact form. Each buffer holds its rows rotated by a
+// row base; the scroll advances the base and only the rows the scroll
+// exposed or that were written since are copied. The expansion kernel
+// reads the rows through the base, so everything past it sees logical
+// order. `CellInstance`s carry their row, so they are copied as damaged.
 
 import Metal
 #if DEBUG
@@ -21,22 +33,10 @@ private let kMinBufferCapacity: Int = 256
 /// Stride of a single CellInstance in bytes, aligned for Metal.
 private let kCellStride: Int = MemoryLayout<CellInstance>.stride
 
-/// Sentinel glyph index meaning "no glyph".
-/// This must match the shader-side `GLYPH_INDEX_NONE` constant.
-private let kNoGlyphIndex: UInt32 = 0xFFFF_FFFF
 #if DEBUG
 private let kCellBufferSignpostLog = OSLog(subsystem: "com.prossh", category: "TerminalPerf")
 #endif
 
-// MARK: - GlyphResolver Protocol
-
-/// Protocol for resolving glyph atlas indices from cell data.
-/// Used as a generic constraint on `CellBuffer.update` to enable
-/// compiler specialization and inlining (eliminates closure overhead).
-protocol GlyphResolver {
-    func resolveGlyphIndex(for cell: CellInstance) -> UInt32
-}
-
 // MARK: - CellBuffer
 
 /// Manages a pair of double-buffered MTLBuffers for streaming cell instance
@@ -47,7 +47,7 @@ protocol GlyphResolver {
 /// (typically `@MainActor` or the Metal render loop).
 ///
 /// Usage:
-/// 1. Call `update(from:glyphLookup:)` each frame with the latest grid snapshot.
+/// 1. Call `update(from:)` each frame with the latest grid snapshot.
 /// 2. Call `swapBuffers()` after the update to promote the write buffer to read.
 /// 3. Pass `readBuffer` to the render encoder as the instance buffer.
 final class CellBuffer {
@@ -57,13 +57,32 @@ final class CellBuffer {
     /// The Metal device used to allocate buffers.
     private let device: MTLDevice
 
-    /// Double-buffered MTLBuffers. Index `writeIndex` is the CPU-writable
-    /// buffer; `readIndex` is the buffer the GPU reads from.
-    private var buffers: [MTLBuffer?] = [nil, nil]
+    /// Ring of MTLBuffers. Index `writeIndex` is the CPU-writable buffer;
+    /// `readIndex` is the one most recently written, which the GPU reads.
+    private var buffers: [MTLBuffer?]
+
+    /// Per buffer, the cell ranges written to other buffers since it was
+    /// last written, i.e. what it must replay to be current. Nil means the
+    /// whole buffer is stale.
+    private var missedDamage: [[Range<Int>]?]
+
+    /// Per buffer, the physical row holding logical row 0. Always 0 for
+    /// `CellInstance`s.
+    private var rowBases: [Int]
+
+    /// Per buffer, lines the screen scrolled since it was last written;
+    /// applied to its row base when it is written next.
+    private var missedScrollLines: [Int]
+
+    /// `GridSnapshot.sequence` of the most recent update.
+    private var lastSequence: UInt64 = 0
 
     /// Index into `buffers` that the CPU is currently writing to.
     private var writeIndex: Int = 0
 
+    /// Index into `buffers` that the GPU should read from.
+    private var readIndex: Int
+
     /// Current capacity of each buffer, measured in cells.
     private var capacity: Int = 0
 
@@ -74,12 +93,14 @@ final class CellBuffer {
     private(set) var columns: Int = 0
     private(set) var rows: Int = 0
 
-    // MARK: - Computed Properties
+    /// Cells copied by the most recent `update(from:)`, replay included.
+    private(set) var lastUploadedCellCount: Int = 0
 
-    /// Index into `buffers` that the GPU should read from.
-    private var readIndex: Int {
-        1 - writeIndex
-    }
+    /// Whether the buffers hold compact `TerminalCell`s rather than
+    /// `CellInstance`s (the form of the most recent snapshot).
+    private(set) var holdsCompactCells = false
+
+    // MARK: - Computed Properties
 
     /// The MTLBuffer the GPU should bind for instanced rendering.
     /// Returns `nil` if no data has been uploaded yet.
@@ -87,6 +108,11 @@ final class CellBuffer {
         buffers[readIndex]
     }
 
+    /// Physical row of logical row 0 in `readBuffer`.
+    var readRowBase: Int {
+        rowBases[readIndex]
+    }
+
     /// The MTLBuffer the CPU is currently writing to.
     private var writeBuffer: MTLBuffer? {
         buffers[writeIndex]
@@ -96,22 +122,34 @@ final class CellBuffer {
 
     /// Creates a new cell buffer backed by the specified Metal device.
     ///
-    /// No MTLBuffers are allocated until the first call to `update(from:glyphLookup:)`.
+    /// No MTLBuffers are allocated until the first call to `update(from:)`.
     ///
-    /// - Parameter device: The Metal device for buffer allocation.
-    init(device: MTLDevice) {
+    /// - Parameters:
+    ///   - device: The Metal device for buffer allocation.
+    ///   - bufferCount: Buffers in the ring. Must be at least the number of
+    ///     frames the renderer keeps in flight, so the buffer being written
+    ///     is never one the GPU is still reading.
+    init(device: MTLDevice, bufferCount: Int = 2) {
+        precondition(bufferCount >= 2, "CellBuffer needs at least two buffers")
         self.device = device
+        self.buffers = Array(repeating: nil, count: bufferCount)
+        self.missedDamage = Array(repeating: nil, count: bufferCount)
+        self.rowBases = Array(repeating: 0, count: bufferCount)
+        self.missedScrollLines = Array(repeating: 0, count: bufferCount)
+        self.readIndex = bufferCount - 1
     }
 
     // MARK: - Buffer Management
 
-    /// Swap read and write buffers. Call this after `update(from:glyphLookup:)`
-    /// completes so the GPU picks up the freshly written data on the next frame.
+    /// Promote the write buffer to read and advance to the next buffer in
+    /// the ring. Call this after `update(from:)` completes so the GPU picks
+    /// up the freshly written data on the next frame.
     func swapBuffers() {
-        writeIndex = 1 - writeIndex
+        readIndex = writeIndex
+        writeIndex = (writeIndex + 1) % buffers.count
     }
 
-    /// Ensures both buffers are allocated with at least `requiredCapacity` cells.
+    /// Ensures every buffer is allocated with at least `requiredCapacity` cells.
     /// If the current capacity is sufficient, this is a no-op. When reallocation
     /// occurs, existing buffer contents are **not** preserved (the caller is
     /// expected to perform a full update after a resize).
@@ -128,13 +166,15 @@ final class CellBuffer {
         let newCapacity = nextPowerOfTwo(aligned)
         let byteCount = newCapacity * kCellStride
 
-        for i in 0..<2 {
+        for i in buffers.indices {
             let buffer = device.makeBuffer(
                 length: byteCount,
                 options: .storageModeShared
             )
             buffer?.label = "CellBuffer[\(i)]"
             buffers[i] = buffer
+            missedDamage[i] = nil
+            missedScrollLines[i] = 0
         }
 
         capacity = newCapacity
@@ -145,19 +185,16 @@ final class CellBuffer {
 
     /// Updates the current write buffer with cell data from a grid snapshot.
     ///
-    /// For each cell in the snapshot, the resolver is called to look up the
-    /// glyph atlas index. Wide characters (wideChar attribute set) are handled
-    /// specially: the primary cell receives the resolved glyph index, and the
-    /// continuation cell receives `kNoGlyphIndex` with matching colors.
+    /// The write buffer was last current some frames ago. Rather than copying
+    /// the whole read buffer in as a baseline, it replays the damage it
+    /// missed plus this snapshot's damage, all taken from `snapshot` (which
+    /// is complete), so the bytes copied follow what changed. Dirty ranges
+    /// are copied verbatim; glyph resolution happens in the vertex shader.
+    /// A full-screen scroll since the previous update rotates the row bases
+    /// of compact buffers instead (see the file header).
     ///
-    /// Uses a generic `GlyphResolver` constraint instead of a closure so the
-    /// compiler can specialize and inline the glyph lookup (no weak-ref check,
-    /// no indirect call, no closure allocation).
-    ///
-    /// - Parameters:
-    ///   - snapshot: The immutable grid snapshot to upload.
-    ///   - resolver: Object that resolves glyph atlas indices for cells.
-    func update<R: GlyphResolver>(from snapshot: GridSnapshot, resolver: R) {
+    /// - Parameter snapshot: The immutable grid snapshot to upload.
+    func update(from snapshot: GridSnapshot) {
         #if DEBUG
         let signpostID = OSSignpostID(log: kCellBufferSignpostLog)
         os_signpost(.begin, log: kCellBufferSignpostLog, name: "CellBufferUpdate", signpostID: signpostID)
@@ -165,7 +202,12 @@ final class CellBuffer {
             os_signpost(.end, log: kCellBufferSignpostLog, name: "CellBufferUpdate", signpostID: signpostID)
         }
         #endif
+        let allocationScope = AllocationTracker.begin(.cellBufferUpdate)
+        defer { allocationScope?.end() }
 
+        lastUploadedCellCount = 0
+        let previousSequence = lastSequence
+        lastSequence = snapshot.sequence
         let newCellCount = snapshot.rows * snapshot.columns
         guard newCellCount > 0 else {
             cellCount = 0
@@ -174,117 +216,144 @@ final class CellBuffer {
             return
         }
 
-        // Detect dimension change — forces full update and reallocation.
+        // Detect dimension or cell form change — forces full update and reallocation.
+        let compact = snapshot.compactCells != nil
         let dimensionsChanged = snapshot.columns != columns || snapshot.rows != rows
+            || compact != holdsCompactCells
         let didReallocate = ensureCapacity(newCellCount)
         let forceFullUpdate = dimensionsChanged || didReallocate
 
         cellCount = newCellCount
         columns = snapshot.columns
         rows = snapshot.rows
+        holdsCompactCells = compact
 
         guard let buffer = writeBuffer else { return }
-        let dst = buffer.contents().bindMemory(to: CellInstance.self, capacity: capacity)
+        let dst = buffer.contents()
 
-        let updateRange: Range<Int>
+        let clamp = { (range: Range<Int>) -> Range<Int> in
+            let lower = max(0, min(range.lowerBound, newCellCount))
+            let upper = max(lower, min(range.upperBound, newCellCount))
+            return lower..<upper
+        }
+        let fullRange = [0..<newCellCount]
+        // The rows of a scroll continuing from the previous update; a
+        // repeated or out-of-order snapshot falls back to its damage.
+        var rotation: GridScrollDelta?
+        if compact, !forceFullUpdate, let scroll = snapshot.scroll,
+           previousSequence != 0, scroll.baseSequence == previousSequence,
+           scroll.delta.region == 0...(snapshot.rows - 1), scroll.delta.movesRows {
+            rotation = scroll.delta
+        }
+        var damage: [Range<Int>]
         if forceFullUpdate {
-            updateRange = 0..<newCellCount
+            damage = fullRange
+        } else if rotation != nil, let scroll = snapshot.scroll {
+            damage = scroll.rewrittenRanges.map(clamp).filter { !$0.isEmpty }
+        } else if let damagedRanges = snapshot.damagedRanges {
+            // Separate blocks of changed rows (e.g. a status line far from
+            // the cursor) are uploaded individually, not as one span.
+            damage = damagedRanges.map(clamp).filter { !$0.isEmpty }
         } else if let dirtyRange = snapshot.dirtyRange {
-            let lower = max(0, min(dirtyRange.lowerBound, newCellCount))
-            let upper = max(lower, min(dirtyRange.upperBound, newCellCount))
-            updateRange = lower..<upper
+            damage = [clamp(dirtyRange)].filter { !$0.isEmpty }
         } else {
             // Nil dirty range means "unknown/whole snapshot changed".
-            updateRange = 0..<newCellCount
+            damage = fullRange
+        }
+        if dimensionsChanged {
+            for index in missedDamage.indices { missedDamage[index] = nil }
         }
 
-        guard !updateRange.isEmpty else { return }
-
-        // Partial updates with double buffering require a current baseline.
-        // The write buffer can be one frame behind the read buffer; if we apply
-        // only a dirty range directly, stale cells from older frames remain and
-        // can cause old/new frame oscillation when buffers swap.
-        // Copy the current read buffer into the write buffer first so unchanged
-        // cells stay in sync, then apply the dirty delta on top.
-        var effectiveRange = updateRange
-        if !forceFullUpdate, updateRange.count < newCellCount {
-            if let read = readBuffer, read !== buffer {
-                let src = read.contents().bindMemory(to: CellInstance.self, capacity: capacity)
-                dst.update(from: src, count: newCellCount)
-            } else {
-                // No valid baseline; fall back to a full upload.
-                effectiveRange = 0..<newCellCount
+        // Missed damage is kept in the rows of the latest snapshot, so a
+        // rotation moves it along with the rows.
+        let rotationLines = rotation?.lines ?? 0
+        if let rotation {
+            for index in missedDamage.indices {
+                missedDamage[index] = missedDamage[index].map { rotation.moving($0, columns: columns) }
             }
         }
 
-        // Copy dirty slice first, then resolve glyphs in a second pass.
-        copyCells(from: snapshot, range: effectiveRange, to: dst)
-        resolveGlyphs(from: snapshot, range: effectiveRange, dst: dst, resolver: resolver)
+        // This buffer's replay plus the new damage, merged so overlapping
+        // rows are copied once.
+        let writeRanges: [Range<Int>]
+        if let missed = missedDamage[writeIndex] {
+            writeRanges = Self.coalesce(missed.map(clamp) + damage)
+            let lines = missedScrollLines[writeIndex] + rotationLines
+            rowBases[writeIndex] = ((rowBases[writeIndex] + lines) % rows + rows) % rows
+        } else {
+            writeRanges = fullRange
+            rowBases[writeIndex] = 0
+        }
+        missedScrollLines[writeIndex] = 0
+        for range in writeRanges where !range.isEmpty {
+            copyCells(from: snapshot, range: range, to: dst, rowBase: rowBases[writeIndex])
+            lastUploadedCellCount += range.count
+        }
+
+        // Every other buffer now misses this snapshot's damage and scroll.
+        // Coalescing keeps each list within one screenful of disjoint ranges.
+        missedDamage[writeIndex] = []
+        for index in missedDamage.indices where index != writeIndex {
+            guard let missed = missedDamage[index] else { continue }
+            missedScrollLines[index] += rotationLines
+            if !damage.isEmpty {
+                missedDamage[index] = Self.coalesce(missed + damage)
+            }
+        }
     }
 
-    /// Second pass over the dirty range: resolve glyph indices and handle
-    /// wide-character continuation cells. Reads from the snapshot's contiguous
-    /// buffer pointer to avoid bounds-checked subscript overhead.
-    private func resolveGlyphs<R: GlyphResolver>(
+    /// Sort and merge overlapping or adjacent ranges.
+    static func coalesce(_ ranges: [Range<Int>]) -> [Range<Int>] {
+        let sorted = ranges.filter { !$0.isEmpty }.sorted { $0.lowerBound < $1.lowerBound }
+        var merged: [Range<Int>] = []
+        merged.reserveCapacity(sorted.count)
+        for range in sorted {
+            if let last = merged.last, range.lowerBound <= last.upperBound {
+                merged[merged.count - 1] = last.lowerBound..<max(last.upperBound, range.upperBound)
+            } else {
+                merged.append(range)
+            }
+        }
+        return merged
+    }
+
+    /// Copy the logical cells `range` into a buffer whose logical row 0 is
+    /// physical row `rowBase`; a range crossing the wrap goes in two parts.
+    private func copyCells(
         from snapshot: GridSnapshot,
         range: Range<Int>,
-        dst: UnsafeMutablePointer<CellInstance>,
-        resolver: R
+        to dst: UnsafeMutableRawPointer,
+        rowBase: Int
     ) {
-        snapshot.cells.withUnsafeBufferPointer { src in
-            guard let srcBase = src.baseAddress else { return }
-            let wideCharBit = CellAttributes.wideChar.rawValue
-
-            // Track previous cell without Optional boxing.
-            var hasPrevious = range.lowerBound > 0
-            var previousCell = hasPrevious ? srcBase[range.lowerBound - 1] : CellInstance(
-                row: 0, col: 0, glyphIndex: 0, fgColor: 0, bgColor: 0,
-                underlineColor: 0, attributes: 0, flags: 0, underlineStyle: 0
-            )
-
-            for i in range {
-                let cell = srcBase[i]
-                let isContinuation: Bool
-                if hasPrevious {
-                    let previousIsWide = (previousCell.attributes & wideCharBit) != 0
-                    let currentIsWide = (cell.attributes & wideCharBit) != 0
-                    isContinuation = previousIsWide && previousCell.row == cell.row && !currentIsWide
-                } else {
-                    isContinuation = false
-                }
-
-                if isContinuation {
-                    // Continuation cell: no glyph, preserve colors from primary.
-                    dst[i].glyphIndex = kNoGlyphIndex
-                    if i > 0 {
-                        let primary = srcBase[i - 1]
-                        dst[i].fgColor = primary.fgColor
-                        dst[i].bgColor = primary.bgColor
-                    }
-                } else if cell.glyphIndex == 0 {
-                    // Empty/NUL cells should not sample atlas texel (0,0).
-                    dst[i].glyphIndex = kNoGlyphIndex
-                } else {
-                    dst[i].glyphIndex = resolver.resolveGlyphIndex(for: cell)
-                }
-
-                previousCell = cell
-                hasPrevious = true
+        let offset = rowBase * columns
+        let wrap = cellCount - offset
+        var parts = [(range.clamped(to: 0..<wrap), offset)]
+        if offset > 0 {
+            parts.append((range.clamped(to: wrap..<cellCount), -wrap))
+        }
+        for (part, shift) in parts where !part.isEmpty {
+            if let compactCells = snapshot.compactCells {
+                copy(compactCells, range: part, at: part.lowerBound + shift, to: dst)
+            } else {
+                copy(snapshot.cells, range: part, at: part.lowerBound + shift, to: dst)
             }
         }
     }
 
-    private func copyCells(
-        from snapshot: GridSnapshot,
+    private func copy<Cell>(
+        _ cells: ContiguousArray<Cell>,
         range: Range<Int>,
-        to dst: UnsafeMutablePointer<CellInstance>
+        at destination: Int,
+        to dst: UnsafeMutableRawPointer
     ) {
-        snapshot.cells.withUnsafeBufferPointer { src in
+        let clamped = range.clamped(to: 0..<cells.count)
+        guard !clamped.isEmpty else { return }
+        let destination = destination + (clamped.lowerBound - range.lowerBound)
+        cells.withUnsafeBufferPointer { src in
             guard let srcBase = src.baseAddress else { return }
-            dst.advanced(by: range.lowerBound).update(
-                from: srcBase.advanced(by: range.lowerBound),
-                count: range.count
-            )
+            dst.bindMemory(to: Cell.self, capacity: capacity)
+                .advanced(by: destination)
+                .update(from: srcBase.advanced(by: clamped.lowerBound), count: clamped.count)
         }
     }
 
@@ -292,8 +361,8 @@ final class CellBuffer {
 
     /// Resizes the cell buffer for new grid dimensions.
     ///
-    /// This forces reallocation of both MTLBuffers if the new cell count
-    /// exceeds the current capacity. The next call to `update(from:glyphLookup:)`
+    /// This forces reallocation of every MTLBuffer if the new cell count
+    /// exceeds the current capacity. The next call to `update(from:)`
     /// will perform a full (non-partial) upload because the dimensions changed.
     ///
     /// - Parameters:
@@ -303,7 +372,7 @@ final class CellBuffer {
         let newCellCount = newColumns * newRows
         guard newCellCount > 0 else { return }
         ensureCapacity(newCellCount)
-        // Do not update `columns` / `rows` here — let `update(from:glyphLookup:)`
+        // Do not update `columns` / `rows` here — let `update(from:)`
         // detect the dimension change and perform a full update.
     }
 
@@ -314,9 +383,14 @@ final class CellBuffer {
         capacity * kCellStride
     }
 
-    /// Returns `true` if both buffers are allocated and ready for use.
+    /// Bytes allocated for every buffer in the ring.
+    var allocatedByteCount: Int {
+        buffers.reduce(0) { $0 + ($1?.allocatedSize ?? 0) }
+    }
+
+    /// Returns `true` if every buffer is allocated and ready for use.
     var isReady: Bool {
-        buffers[0] != nil && buffers[1] != nil
+        buffers.allSatisfy { $0 != nil }
     }
 
     // MARK: - Private Helpers
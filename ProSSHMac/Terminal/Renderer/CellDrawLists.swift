@@ -0,0 +1,231 @@
+// CellDrawLists.swift
+// ProSSHV2
+//
+// Compacted draw lists for the cell pass. Most of a shell screen is blank
+// cells on the default background, and instancing every cell through the
+// full cell shader spends a vertex invocation, a glyph table probe and a
+// fragment shade on each of them for nothing. Each snapshot is split into:
+// - background runs: horizontal spans of cells sharing a background
+//   colour, each drawn as one flat quad;
+// - cell indices: the cells the full cell shader must still draw (glyphs,
+//   decorations, reverse video, selection), drawn over the runs.
+// The cursor and its glow move without a new snapshot, so the draw loop
+// redraws the cells around the cursor through the cell shader each frame.
+//
+// Both lists are row-major with per-row start offsets, so a partial redraw
+// of a row range draws one contiguous slice of each. Lists build from either
+// expanded `CellInstance`s or compact `TerminalCell`s (GPU cell expansion).
+
+import Metal
+
+// MARK: - BackgroundRun
+
+/// Mirrors `BackgroundRun` in TerminalShaders.metal.
+nonisolated struct BackgroundRun: Equatable, Sendable {
+    var row: UInt16
+    var col: UInt16
+    var count: UInt16
+    var reserved: UInt16 = 0
+    /// Packed RGBA; zero alpha (default background) is normalised to 0.
+    var bgColor: UInt32
+}
+
+// MARK: - DrawListCell
+
+/// The fields draw-list classification reads, shared by both cell forms.
+nonisolated protocol DrawListCell {
+    /// Codepoint, 0 for none.
+    var drawListGlyph: UInt32 { get }
+    /// Packed RGBA background.
+    var drawListBackground: UInt32 { get }
+    /// `CellAttributes` raw value.
+    var drawListAttributes: UInt16 { get }
+    var drawListUnderlineStyle: UInt8 { get }
+    var drawListIsSelected: Bool { get }
+}
+
+nonisolated extension CellInstance: DrawListCell {
+    var drawListGlyph: UInt32 { glyphIndex }
+    var drawListBackground: UInt32 { bgColor }
+    var drawListAttributes: UInt16 { attributes }
+    var drawListUnderlineStyle: UInt8 { underlineStyle }
+    var drawListIsSelected: Bool { flags & CellInstance.flagSelected != 0 }
+}
+
+nonisolated extension TerminalCell: DrawListCell {
+    var drawListGlyph: UInt32 { primaryCodepoint }
+    var drawListBackground: UInt32 { bgPackedRGBA }
+    var drawListAttributes: UInt16 { attributes.rawValue }
+    var drawListUnderlineStyle: UInt8 { underlineStyle.rawValue }
+    /// Compact cells are never selected; selection expands on the CPU.
+    var drawListIsSelected: Bool { false }
+}
+
+// MARK: - CellDrawLists
+
+nonisolated struct CellDrawLists: Sendable {
+
+    private(set) var backgroundRuns: [BackgroundRun] = []
+
+    /// Indices into the cell buffer, ascending.
+    private(set) var cellIndices: [UInt32] = []
+
+    /// `runRowStarts[row]` is the first run of `row`; one extra trailing entry.
+    private(set) var runRowStarts: [Int] = [0]
+
+    /// `cellRowStarts[row]` is the first cell index of `row`; one extra trailing entry.
+    private(set) var cellRowStarts: [Int] = [0]
+
+    init() {}
+
+    init<Cell: DrawListCell>(cells: ContiguousArray<Cell>, columns: Int, rows: Int) {
+        guard columns > 0 else { return }
+        let rowCount = min(rows, cells.count / columns)
+        backgroundRuns.reserveCapacity(rowCount * 2)
+        runRowStarts.reserveCapacity(rowCount + 1)
+        cellRowStarts.reserveCapacity(rowCount + 1)
+
+        cells.withUnsafeBufferPointer { cells in
+            for row in 0..<rowCount {
+                let rowBase = row * columns
+                var runStart = 0
+                var runColor: UInt32 = 0
+                for col in 0..<columns {
+                    let index = rowBase + col
+                    let cell = cells[index]
+                    let continuation = col > 0 && Self.isContinuation(cell, previous: cells[index - 1])
+                    let color = Self.backgroundColor(
+                        continuation ? cells[index - 1].drawListBackground : cell.drawListBackground
+                    )
+                    if col == 0 {
+                        runColor = color
+                    } else if color != runColor {
+                        appendRun(row: row, col: runStart, count: col - runStart, color: runColor)
+                        runStart = col
+                        runColor = color
+                    }
+                    if Self.needsCellShader(cell, isContinuation: continuation) {
+                        cellIndices.append(UInt32(index))
+                    }
+                }
+                appendRun(row: row, col: runStart, count: columns - runStart, color: runColor)
+                runRowStarts.append(backgroundRuns.count)
+                cellRowStarts.append(cellIndices.count)
+            }
+        }
+    }
+
+    var rowCount: Int { runRowStarts.count - 1 }
+
+    /// Slice of `backgroundRuns` covering `rows`.
+    func runs(inRows rows: Range<Int>) -> Range<Int> {
+        let rows = rows.clamped(to: 0..<rowCount)
+        return runRowStarts[rows.lowerBound]..<runRowStarts[rows.upperBound]
+    }
+
+    /// Slice of `cellIndices` covering `rows`.
+    func cells(inRows rows: Range<Int>) -> Range<Int> {
+        let rows = rows.clamped(to: 0..<rowCount)
+        return cellRowStarts[rows.lowerBound]..<cellRowStarts[rows.upperBound]
+    }
+
+    // MARK: - Classification
+
+    /// Right half of a wide character; mirrors the vertex shader's test.
+    @inline(__always)
+    static func isContinuation<Cell: DrawListCell>(_ cell: Cell, previous: Cell) -> Bool {
+        let wide = CellAttributes.wideChar.rawValue
+        return previous.drawListAttributes & wide != 0 && cell.drawListAttributes & wide == 0
+    }
+
+    /// Whether the cell draws anything beyond its background: a glyph, a
+    /// decoration, reverse video or the selection tint.
+    @inline(__always)
+    static func needsCellShader<Cell: DrawListCell>(_ cell: Cell, isContinuation: Bool) -> Bool {
+        if cell.drawListIsSelected { return true }
+        let attributes = CellAttributes(rawValue: cell.drawListAttributes)
+        if attributes.contains(.reverse) { return true }
+        // Hidden cells draw only their background, decorations included.
+        if attributes.contains(.hidden) { return false }
+        let glyph = cell.drawListGlyph
+        if !isContinuation, glyph != 0, glyph != 0x20 { return true }
+        return cell.drawListUnderlineStyle != 0
+            || !attributes.isDisjoint(with: [.underline, .doubleUnder, .strikethrough, .overline])
+    }
+
+    /// Zero-alpha colours all draw as the default background.
+    @inline(__always)
+    private static func backgroundColor(_ packed: UInt32) -> UInt32 {
+        packed & 0xFF == 0 ? 0 : packed
+    }
+
+    private mutating func appendRun(row: Int, col: Int, count: Int, color: UInt32) {
+        backgroundRuns.append(BackgroundRun(
+            row: UInt16(truncatingIfNeeded: row),
+            col: UInt16(truncatingIfNeeded: col),
+            count: UInt16(truncatingIfNeeded: count),
+            bgColor: color
+        ))
+    }
+}
+
+// MARK: - CellDrawListBuffer
+
+/// GPU copies of the draw lists, in a ring sized like `CellBuffer`'s so a
+/// frame still in flight never reads a slot being rewritten.
+final class CellDrawListBuffer {
+
+    private let device: MTLDevice
+    private var runBuffers: [MTLBuffer?]
+    private var indexBuffers: [MTLBuffer?]
+    private var slotLists: [CellDrawLists]
+    private var readIndex = 0
+
+    init(device: MTLDevice, bufferCount: Int = 2) {
+        precondition(bufferCount >= 2, "CellDrawListBuffer needs at least two buffers")
+        self.device = device
+        self.runBuffers = Array(repeating: nil, count: bufferCount)
+        self.indexBuffers = Array(repeating: nil, count: bufferCount)
+        self.slotLists = Array(repeating: CellDrawLists(), count: bufferCount)
+    }
+
+    /// Lists the GPU reads this frame.
+    var lists: CellDrawLists { slotLists[readIndex] }
+
+    /// Bytes allocated for the run and index buffers of every slot.
+    var allocatedByteCount: Int {
+        (runBuffers + indexBuffers).reduce(0) { $0 + ($1?.allocatedSize ?? 0) }
+    }
+
+    var runBuffer: MTLBuffer? { runBuffers[readIndex] }
+
+    var indexBuffer: MTLBuffer? { indexBuffers[readIndex] }
+
+    /// Upload `lists` into the next slot and make it the read slot.
+    func update(_ lists: CellDrawLists) {
+        let slot = (readIndex + 1) % slotLists.count
+        guard let runs = buffer(&runBuffers[slot], label: "CellBackgroundRuns", elements: lists.backgroundRuns),
+              let indices = buffer(&indexBuffers[slot], label: "CellDrawIndices", elements: lists.cellIndices) else {
+            return
+        }
+        lists.backgroundRuns.withUnsafeBytes { bytes in
+            if let base = bytes.baseAddress { runs.contents().copyMemory(from: base, byteCount: bytes.count) }
+        }
+        lists.cellIndices.withUnsafeBytes { bytes in
+            if let base = bytes.baseAddress { indices.contents().copyMemory(from: base, byteCount: bytes.count) }
+        }
+        slotLists[slot] = lists
+        readIndex = slot
+    }
+
+    /// `existing` if it fits `elements`, else a new buffer with headroom.
+    private func buffer<Element>(_ existing: inout MTLBuffer?, label: String, elements: [Element]) -> MTLBuffer? {
+        let needed = max(1, elements.count) * MemoryLayout<Element>.stride
+        if let existing, existing.length >= needed {
+            return existing
+        }
+        existing = device.makeBuffer(length: max(4_096, needed * 3 / 2), options: .storageModeShared)
+        existing?.label = label
+        return existing
+    }
+}
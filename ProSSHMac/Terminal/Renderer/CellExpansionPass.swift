@@ -0,0 +1,112 @@
+// CellExpansionPass.swift
+// ProSSHV2
+//
+// GPU cell expansion. In compact snapshot mode the grid publishes its
+// 20-byte `TerminalCell`s as stored and `CellBuffer` uploads them without
+// any per-cell CPU work. This compute pass turns them into the
+// `CellInstance`s the cell shader reads: grid position from the index,
+// grapheme sentinels to 0, the wide-continuation bit from `width`, and the
+// cursor flag. Source rows may be rotated by a row base (CellBuffer keeps
+// scrolled rows in place); the output is always in logical order.
+//
+// The output buffer is GPU-private and rewritten only when a new snapshot
+// is applied. Every frame encodes on the same queue, so Metal's hazard
+// tracking orders a rewrite after the previous frame's reads.
+
+import Metal
+
+// MARK: - CellExpansionParams
+
+/// Mirrors `CellExpansionParams` in TerminalShaders.metal.
+nonisolated struct CellExpansionParams: Sendable {
+    var cellCount: UInt32
+    var columns: UInt32
+    /// Linear index of the visible cursor cell; `noCursor` when hidden.
+    var cursorIndex: UInt32
+    /// Source row holding grid row 0.
+    var rowBase: UInt32 = 0
+
+    static let noCursor = UInt32.max
+}
+
+// MARK: - CellExpansionPass
+
+final class CellExpansionPass {
+
+    private let device: MTLDevice
+    private let pipelineState: MTLComputePipelineState
+
+    /// Expanded `CellInstance`s from the last `encode`; nil before the first.
+    private(set) var outputBuffer: MTLBuffer?
+
+    /// Capacity of `outputBuffer` in cells.
+    private var outputCapacity = 0
+
+    /// Bytes allocated for `outputBuffer`.
+    var allocatedByteCount: Int {
+        outputBuffer?.allocatedSize ?? 0
+    }
+
+    /// `pipelineState` is the `expand_terminal_cells` kernel from
+    /// TerminalPipelineCache.
+    init(device: MTLDevice, pipelineState: MTLComputePipelineState) {
+        self.device = device
+        self.pipelineState = pipelineState
+    }
+
+    /// Encode expansion of the `cellCount` compact cells in `source`, whose
+    /// grid row 0 is at source row `rowBase`, into `outputBuffer`. Returns
+    /// the output, or nil if nothing was encoded.
+    @discardableResult
+    func encode(
+        commandBuffer: MTLCommandBuffer,
+        source: MTLBuffer,
+        cellCount: Int,
+        columns: Int,
+        rowBase: Int = 0,
+        cursorIndex: Int?
+    ) -> MTLBuffer? {
+        guard cellCount > 0, columns > 0,
+              let output = ensureOutput(cellCount: cellCount),
+              let encoder = commandBuffer.makeComputeCommandEncoder() else {
+            return nil
+        }
+        #if DEBUG
+        encoder.label = "CellExpansion"
+        #endif
+        var params = CellExpansionParams(
+            cellCount: UInt32(cellCount),
+            columns: UInt32(columns),
+            cursorIndex: cursorIndex.map { UInt32($0) } ?? CellExpansionParams.noCursor,
+            rowBase: UInt32(max(0, rowBase))
+        )
+        encoder.setComputePipelineState(pipelineState)
+        encoder.setBuffer(source, offset: 0, index: 0)
+        encoder.setBuffer(output, offset: 0, index: 1)
+        encoder.setBytes(&params, length: MemoryLayout<CellExpansionParams>.stride, index: 2)
+
+        let width = pipelineState.threadExecutionWidth
+        encoder.dispatchThreadgroups(
+            MTLSize(width: (cellCount + width - 1) / width, height: 1, depth: 1),
+            threadsPerThreadgroup: MTLSize(width: width, height: 1, depth: 1)
+        )
+        encoder.endEncoding()
+        return output
+    }
+
+    /// `outputBuffer`, reallocated with headroom if it cannot hold `cellCount`.
+    private func ensureOutput(cellCount: Int) -> MTLBuffer? {
+        if let outputBuffer, outputCapacity >= cellCount {
+            return outputBuffer
+        }
+        let capacity = max(256, cellCount * 3 / 2)
+        let buffer = device.makeBuffer(
+            length: capacity * MemoryLayout<CellInstance>.stride,
+            options: .storageModePrivate
+        )
+        buffer?.label = "ExpandedCellInstances"
+        outputBuffer = buffer
+        outputCapacity = buffer == nil ? 0 : capacity
+        return buffer
+    }
+}
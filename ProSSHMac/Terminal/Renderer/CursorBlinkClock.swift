@@ -0,0 +1,123 @@
+// CursorBlinkClock.swift
+// ProSSHV2
+//
+// One app-wide wake for blinking cursors. Each renderer used to run its own
+// ~15 fps Task loop while its cursor blinked, and every tick redrew the
+// cursor rows. Thirty panes meant thirty timers and 450 frames a second of
+// nothing but cursor.
+//
+// The blink phase is now a pure function of shared media time
+// (`CACurrentMediaTime`), on for one half period and off for the next,
+// so every pane blinks together and the phase only changes at half-period
+// edges. The clock sleeps until the next edge and asks each subscribed
+// renderer for a cursor-only redraw. That is two wakes per cycle for the
+// whole app, and none once no cursor blinks.
+//
+// Renderers subscribe while their cursor is visible, blinking and their
+// pane may draw. Runs on the main actor (the project default).
+
+import Foundation
+import QuartzCore
+
+// MARK: - CursorBlinkClient
+
+/// A pane whose blinking cursor follows the clock. Implemented by
+/// MetalTerminalRenderer.
+protocol CursorBlinkClient: AnyObject {
+    /// The blink phase flipped; redraw the cursor.
+    func cursorBlinkTick()
+}
+
+// MARK: - CursorBlinkClock
+
+final class CursorBlinkClock {
+
+    static let shared = CursorBlinkClock()
+
+    /// Half period of the blink: visible for this long, then hidden for as long.
+    nonisolated static let halfPeriod: CFTimeInterval = 0.53
+
+    /// Delay past each edge before waking, so the frame drawn on wake
+    /// always samples the new phase.
+    nonisolated static let wakeSlack: CFTimeInterval = 0.002
+
+    private struct WeakClient {
+        weak var client: CursorBlinkClient?
+    }
+
+    private var clients: [ObjectIdentifier: WeakClient] = [:]
+
+    /// Sleeps to the next edge while any client is subscribed. Marked
+    /// `nonisolated(unsafe)` so deinit can cancel it.
+    nonisolated(unsafe) private var wakeTask: Task<Void, Never>?
+
+    /// Edges delivered since creation.
+    private(set) var tickCount = 0
+
+    deinit {
+        wakeTask?.cancel()
+    }
+
+    /// Number of subscribed clients still alive.
+    var liveClientCount: Int {
+        clients.values.filter { $0.client != nil }.count
+    }
+
+    /// Whether the clock is waiting for an edge.
+    var isRunning: Bool { wakeTask != nil }
+
+    // MARK: - Clients
+
+    /// Subscribe `client` to blink edges. Cheap when already subscribed,
+    /// since renderers re-evaluate on every snapshot.
+    func add(_ client: CursorBlinkClient) {
+        let id = ObjectIdentifier(client)
+        guard clients[id]?.client == nil else { return }
+        clients[id] = WeakClient(client: client)
+        startIfNeeded()
+    }
+
+    func remove(_ client: CursorBlinkClient) {
+        clients.removeValue(forKey: ObjectIdentifier(client))
+    }
+
+    // MARK: - Phase
+
+    /// Start of the half period containing `time`.
+    nonisolated static func edge(atOrBefore time: CFTimeInterval) -> CFTimeInterval {
+        (time / halfPeriod).rounded(.down) * halfPeriod
+    }
+
+    /// The first half-period edge strictly after `time`.
+    nonisolated static func nextEdge(after time: CFTimeInterval) -> CFTimeInterval {
+        edge(atOrBefore: time) + halfPeriod
+    }
+
+    // MARK: - Ticking
+
+    /// Deliver one edge to every live client, dropping released ones.
+    func tick() {
+        tickCount += 1
+        clients = clients.filter { $0.value.client != nil }
+        for entry in clients.values {
+            entry.client?.cursorBlinkTick()
+        }
+    }
+
+    private func startIfNeeded() {
+        guard wakeTask == nil else { return }
+        wakeTask = Task { [weak self] in
+            while !Task.isCancelled {
+                let now = CACurrentMediaTime()
+                let delay = Self.nextEdge(after: now) - now + Self.wakeSlack
+                try? await Task.sleep(for: .seconds(delay))
+                guard !Task.isCancelled, let self else { return }
+                self.tick()
+                if self.clients.isEmpty {
+                    break
+                }
+            }
+            self?.wakeTask = nil
+        }
+    }
+}
@@ -8,7 +8,7 @@
 import Foundation
 
 /// Animated cursor state used by the renderer each frame.
-struct CursorRenderFrame: Sendable {
+struct CursorRenderFrame: Sendable, Equatable {
     /// Animated cursor row in grid space (0-based, fractional during lerp).
     let row: Float
 
@@ -58,9 +58,6 @@ final class CursorRenderer {
 
     // MARK: - Tunables
 
-    /// Half period of the blink waveform (530ms default).
-    var blinkHalfPeriod: Float = 0.53
-
     /// Position interpolation factor per frame.
     var positionLerpFactor: Float = 0.35
 
@@ -83,8 +80,8 @@ final class CursorRenderer {
 
     // MARK: - Render State
 
-    private var renderRow: Float = 0
-    private var renderCol: Float = 0
+    private(set) var renderRow: Float = 0
+    private(set) var renderCol: Float = 0
     private var seeded = false
     private let snapEpsilon: Float = 0.001
 
@@ -118,9 +115,11 @@ final class CursorRenderer {
         if abs(renderRow - targetRow) < snapEpsilon { renderRow = targetRow }
         if abs(renderCol - targetCol) < snapEpsilon { renderCol = targetCol }
 
-        let t = Float(time)
-        let phase = computeBlinkPhase(time: t)
-        let glow = computeGlowIntensity(time: t, phase: phase)
+        let phase = computeBlinkPhase(time: time)
+        // While blinking, frames only come at blink edges, so the glow pulse
+        // is sampled there too rather than at whatever time a frame lands.
+        let pulseTime = blinkEnabled ? CursorBlinkClock.edge(atOrBefore: time) : time
+        let glow = computeGlowIntensity(time: Float(pulseTime.truncatingRemainder(dividingBy: 2)), phase: phase)
 
         return CursorRenderFrame(
             row: renderRow,
@@ -132,17 +131,17 @@ final class CursorRenderer {
     }
 
     /// Whether the cursor requires continuous frame updates (position interpolation only).
-    /// Cursor blink animation is driven by a separate timer in MetalTerminalRenderer.
+    /// Blink edges are delivered by CursorBlinkClock.
     func requiresContinuousFrames() -> Bool {
         abs(renderRow - targetRow) >= snapEpsilon || abs(renderCol - targetCol) >= snapEpsilon
     }
 
     // MARK: - Internals
 
-    private func computeBlinkPhase(time: Float) -> Float {
+    private func computeBlinkPhase(time: CFTimeInterval) -> Float {
         CursorEffects.blinkPhase(
             time: time,
-            halfPeriod: blinkHalfPeriod,
+            halfPeriod: CursorBlinkClock.halfPeriod,
             visible: cursorVisible,
             blinkEnabled: blinkEnabled
         )
@@ -0,0 +1,238 @@
+// FontFallbackCache.swift
+// ProSSHV2
+//
+// Which font draws a scalar when the terminal font might not, shared by
+// every renderer and rasterizer thread in the process. Resolving a fallback
+// means probing the primary font with CTFontGetGlyphsForCharacters and, on
+// a miss, a CTFontCreateForString cascade. That used to run for every new
+// glyph key in every renderer, and again after each font size change, so
+// Nerd Font icons, math or symbol-heavy prompts paid CoreText lookups while
+// rasterizing.
+//
+// Resolutions are keyed by the primary font's PostScript name (one per
+// family and variant), the scalar, and the resolver asking. Size is not in
+// the key: a size change reuses the resolution and only instantiates the
+// fallback at the new size, once per size. A font family change produces
+// new keys, so only changes to the installed fonts clear the cache.
+//
+// Resolutions are also written to Caches/ProSSHV2/FontFallback.json, a
+// short while after new ones are made. The next launch seeds the cache from
+// that file and skips the cascade. System fonts change with the OS, so the
+// file records the OS version and is ignored after an update. Private
+// system fonts (PostScript names starting with ".") cannot be recreated by
+// name. They are only cached in memory.
+
+import CoreText
+import Foundation
+import os.log
+
+// MARK: - FontFallbackCache
+
+nonisolated final class FontFallbackCache: @unchecked Sendable {
+
+    /// Who resolved a fallback. The rasterizer and FontManager walk
+    /// different chains, so their answers are kept apart.
+    enum Resolver: String, Codable, Sendable {
+        case raster
+        case fontManager
+    }
+
+    static let shared = FontFallbackCache(
+        storeURL: (FileManager.default.urls(for: .cachesDirectory, in: .userDomainMask).first
+            ?? FileManager.default.temporaryDirectory)
+            .appendingPathComponent("ProSSHV2", isDirectory: true)
+            .appendingPathComponent("FontFallback.json", isDirectory: false)
+    )
+
+    /// Delay between the first new resolution and the write that saves it.
+    static let saveDelay: TimeInterval = 5
+
+    private struct Key: Hashable {
+        let resolver: Resolver
+        let primary: String
+        let scalar: UInt32
+    }
+
+    private struct SizedFont: Hashable {
+        let name: String
+        let size: CGFloat
+    }
+
+    /// The persisted table: resolver, primary font, then scalar (decimal)
+    /// to fallback PostScript name, or "" for the primary itself.
+    private struct StoredTable: Codable {
+        var osVersion: String
+        var resolutions: [Resolver: [String: [String: String]]]
+    }
+
+    private static let logger = Logger(subsystem: "com.prossh", category: "FontFallback")
+
+    /// File the table is persisted to; nil keeps it in memory only.
+    let storeURL: URL?
+
+    private let lock = NSLock()
+    /// Fallback PostScript name per key; "" when the primary has the glyph.
+    private var resolutions: [Key: String] = [:]
+    /// Descriptors of fallbacks resolved in this process, to instantiate
+    /// private system fonts at other sizes.
+    private var descriptors: [String: CTFontDescriptor] = [:]
+    private var fonts: [SizedFont: CTFont] = [:]
+    private var loaded = false
+    private var saveScheduled = false
+    private var fontsObserver: NSObjectProtocol?
+
+    init(storeURL: URL?) {
+        self.storeURL = storeURL
+        fontsObserver = NotificationCenter.default.addObserver(
+            forName: Notification.Name(kCTFontManagerRegisteredFontsChangedNotification as String),
+            object: nil,
+            queue: nil
+        ) { [weak self] _ in
+            self?.removeAll()
+        }
+    }
+
+    deinit {
+        if let fontsObserver {
+            NotificationCenter.default.removeObserver(fontsObserver)
+        }
+    }
+
+    // MARK: - Lookup
+
+    /// The font for `scalar` with `primaryFont` as the terminal font. A miss
+    /// calls `resolve` once and remembers the answer.
+    func font(
+        for scalar: Unicode.Scalar,
+        primaryFont: CTFont,
+        resolver: Resolver,
+        resolve: () -> CTFont
+    ) -> CTFont {
+        let primaryName = CTFontCopyPostScriptName(primaryFont) as String
+        let key = Key(resolver: resolver, primary: primaryName, scalar: scalar.value)
+        let size = CTFontGetSize(primaryFont)
+
+        lock.lock()
+        loadIfNeeded()
+        if let name = resolutions[key] {
+            if name.isEmpty || name == primaryName {
+                lock.unlock()
+                return primaryFont
+            }
+            if let font = instantiate(name, size: size) {
+                lock.unlock()
+                return font
+            }
+            // A seeded font that is no longer installed: resolve again.
+            resolutions[key] = nil
+        }
+        lock.unlock()
+
+        let resolved = resolve()
+        let resolvedName = CTFontCopyPostScriptName(resolved) as String
+
+        lock.lock()
+        defer { lock.unlock() }
+        resolutions[key] = resolvedName == primaryName ? "" : resolvedName
+        if resolvedName != primaryName {
+            descriptors[resolvedName] = CTFontCopyFontDescriptor(resolved)
+            fonts[SizedFont(name: resolvedName, size: size)] = resolved
+        }
+        scheduleSave()
+        return resolved
+    }
+
+    /// Resolutions held, for diagnostics and tests.
+    var count: Int {
+        lock.lock()
+        defer { lock.unlock() }
+        return resolutions.count
+    }
+
+    /// Forget every resolution and the persisted table. Runs when fonts
+    /// are installed or removed.
+    func removeAll() {
+        lock.lock()
+        resolutions.removeAll()
+        descriptors.removeAll()
+        fonts.removeAll()
+        loaded = true
+        lock.unlock()
+        if let storeURL {
+            try? FileManager.default.removeItem(at: storeURL)
+        }
+    }
+
+    // MARK: - Private (lock held)
+
+    private func instantiate(_ name: String, size: CGFloat) -> CTFont? {
+        let sized = SizedFont(name: name, size: size)
+        if let font = fonts[sized] {
+            return font
+        }
+        let font: CTFont
+        if let descriptor = descriptors[name] {
+            font = CTFontCreateWithFontDescriptor(descriptor, size, nil)
+        } else {
+            guard !name.hasPrefix(".") else { return nil }
+            font = CTFontCreateWithName(name as CFString, size, nil)
+            // CTFontCreateWithName substitutes a default font for missing names.
+            guard CTFontCopyPostScriptName(font) as String == name else { return nil }
+        }
+        fonts[sized] = font
+        return font
+    }
+
+    private func loadIfNeeded() {
+        guard !loaded else { return }
+        loaded = true
+        guard let storeURL, let data = try? Data(contentsOf: storeURL) else { return }
+        guard let table = try? JSONDecoder().decode(StoredTable.self, from: data),
+              table.osVersion == Self.osVersion else {
+            try? FileManager.default.removeItem(at: storeURL)
+            return
+        }
+        for (resolver, primaries) in table.resolutions {
+            for (primary, scalars) in primaries {
+                for (scalar, name) in scalars {
+                    guard let value = UInt32(scalar) else { continue }
+                    resolutions[Key(resolver: resolver, primary: primary, scalar: value)] = name
+                }
+            }
+        }
+    }
+
+    private func scheduleSave() {
+        guard storeURL != nil, !saveScheduled else { return }
+        saveScheduled = true
+        DispatchQueue.global(qos: .utility).asyncAfter(deadline: .now() + Self.saveDelay) { [weak self] in
+            self?.save()
+        }
+    }
+
+    // MARK: - Persistence
+
+    /// Write the table now instead of after `saveDelay`.
+    func save() {
+        lock.lock()
+        saveScheduled = false
+        var table = StoredTable(osVersion: Self.osVersion, resolutions: [:])
+        for (key, name) in resolutions where !name.hasPrefix(".") {
+            table.resolutions[key.resolver, default: [:]][key.primary, default: [:]][String(key.scalar)] = name
+        }
+        lock.unlock()
+
+        guard let storeURL else { return }
+        do {
+            try FileManager.default.createDirectory(
+                at: storeURL.deletingLastPathComponent(),
+                withIntermediateDirectories: true
+            )
+            try JSONEncoder().encode(table).write(to: storeURL, options: .atomic)
+        } catch {
+            Self.logger.error("Font fallback table write failed: \(error.localizedDescription, privacy: .public)")
+        }
+    }
+
+    private static let osVersion = ProcessInfo.processInfo.operatingSystemVersionString
+}
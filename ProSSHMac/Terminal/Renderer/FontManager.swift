@@ -16,7 +16,8 @@ import Foundation
 /// Unique key for a rasterized glyph in the atlas.
 /// Combines a Unicode codepoint with its bold/italic style variant.
 nonisolated struct GlyphKey: Hashable, Sendable {
-    /// Unicode scalar value (U+0000 through U+10FFFF).
+    /// Unicode scalar value (U+0000 through U+10FFFF), or a shaped-run
+    /// tile above that range (see GlyphShapingCache).
     let codepoint: UInt32
 
     /// Whether the glyph should be rendered in bold weight.
@@ -281,7 +282,12 @@ actor FontManager {
     ///   the primary variant font if no fallback has a glyph either.
     func fontForCharacter(_ scalar: Unicode.Scalar, variant: FontVariant) -> CTFont {
         let primaryFont = font(for: variant)
+        return FontFallbackCache.shared.font(for: scalar, primaryFont: primaryFont, resolver: .fontManager) {
+            uncachedFontForCharacter(scalar, primaryFont: primaryFont)
+        }
+    }
 
+    private func uncachedFontForCharacter(_ scalar: Unicode.Scalar, primaryFont: CTFont) -> CTFont {
         // Emoji range detection — checked BEFORE the primary font because
         // monospace fonts (SF Mono, Menlo, etc.) often map emoji codepoints
         // to placeholder glyphs (rendered as "?") that pass fontContainsGlyph
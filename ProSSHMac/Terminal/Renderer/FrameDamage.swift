@@ -0,0 +1,98 @@
+// FrameDamage.swift
+// ProSSHV2
+//
+// Grid rows that changed since the last frame, so an idle terminal redraws
+// only what moved: the rows a snapshot damaged, plus the rows around the
+// cursor's old and new positions (block, bar and glow). Untouched rows keep
+// their pixels in the renderer's persistent scene texture.
+//
+// Anything the tracker cannot see — settings, fonts, resizes, selection
+// projection, glyph uploads — invalidates it and forces a full redraw.
+
+import Metal
+import CoreGraphics
+
+struct FrameDamage {
+
+    /// Rows the cursor glow reaches above and below the cursor cell; matches
+    /// GLOW_RADIUS in TerminalShaders.metal.
+    static let cursorBleedRows = 3
+
+    /// The next frame must redraw every row.
+    private(set) var isFull = true
+
+    /// Bounding range of damaged rows accumulated since the last `take`.
+    private(set) var rows: Range<Int>?
+
+    /// A cursor-only redraw was requested (blink tick).
+    private(set) var cursorPending = false
+
+    /// Cursor render row last drawn, so its old position is cleared.
+    private var lastCursorRow: Float?
+
+    /// Nothing waits to be drawn.
+    var isEmpty: Bool {
+        !isFull && rows == nil && !cursorPending
+    }
+
+    mutating func invalidate() {
+        isFull = true
+        rows = nil
+    }
+
+    mutating func add(rows newRows: Range<Int>) {
+        guard !isFull, !newRows.isEmpty else { return }
+        if let rows {
+            self.rows = min(rows.lowerBound, newRows.lowerBound)..<max(rows.upperBound, newRows.upperBound)
+        } else {
+            rows = newRows
+        }
+    }
+
+    /// Add cell-index damage ranges (row-major, `columns` per row).
+    mutating func add(cellRanges: [Range<Int>], columns: Int) {
+        guard columns > 0 else { return }
+        for range in cellRanges where !range.isEmpty {
+            add(rows: (range.lowerBound / columns)..<((range.upperBound + columns - 1) / columns))
+        }
+    }
+
+    mutating func markCursor() {
+        cursorPending = true
+    }
+
+    /// Add the rows around the cursor at `row` (fractional while it animates)
+    /// and around where it was last drawn.
+    mutating func add(cursorRow row: Float) {
+        for cursor in [lastCursorRow, row].compactMap({ $0 }) {
+            let top = Int(cursor.rounded(.down)) - Self.cursorBleedRows
+            let bottom = Int(cursor.rounded(.up)) + 1 + Self.cursorBleedRows
+            add(rows: max(0, top)..<max(0, bottom))
+        }
+        lastCursorRow = row
+    }
+
+    /// Rows to redraw this frame clamped to `rowCount`, or nil to redraw
+    /// everything. Resets the tracker for the next frame.
+    mutating func take(rowCount: Int) -> Range<Int>? {
+        defer {
+            isFull = false
+            rows = nil
+            cursorPending = false
+        }
+        if isFull { return nil }
+        guard let rows else { return 0..<0 }
+        return rows.clamped(to: 0..<max(0, rowCount))
+    }
+
+    /// Pixel scissor covering `rows`, across the full drawable width. Nil
+    /// when the rows fall outside the drawable.
+    static func scissorRect(rows: Range<Int>, cellHeight: CGFloat, drawableSize: CGSize) -> MTLScissorRect? {
+        let width = Int(drawableSize.width)
+        let height = Int(drawableSize.height)
+        let top = min(height, max(0, Int((CGFloat(rows.lowerBound) * cellHeight).rounded(.down))))
+        let bottom = min(height, max(0, Int((CGFloat(rows.upperBound) * cellHeight).rounded(.up))))
+        guard width > 0, bottom > top else { return nil }
+        return MTLScissorRect(x: 0, y: top, width: width, height: bottom - top)
+    }
+}
@@ -0,0 +1,253 @@
+// GPUGlyphTable.swift
+// ProSSHV2
+//
+// GPU-resident mirror of a GlyphCache: an open-addressing hash table in an
+// MTLBuffer that the vertex shader probes to turn a cell's codepoint and
+// bold/italic bits into a packed atlas position. Cell snapshots are copied
+// to the GPU as is; no per-cell CPU resolution pass runs.
+//
+// Layout: `capacity` slots of (key, value) UInt32 pairs, linear probing,
+// multiplicative hash. Keys are `codepoint << 2 | bold << 1 | italic`;
+// `emptyKey` ends a probe and `tombstoneKey` marks a removed slot. The
+// table is kept at most 3/4 full, counting tombstones, so probes always
+// terminate; past that it is rebuilt into a fresh buffer while frames in
+// flight keep sampling the old one.
+//
+// Alongside the table:
+// - a byte per slot that the shader sets when a cell hits it, so the CPU
+//   can keep GlyphCache's LRU order without looking glyphs up itself;
+// - per-frame miss logs the shader appends unresolved keys to, read back
+//   when the frame completes and fed to background rasterization.
+//
+// The constants here must match the GLYPH_TABLE_* and GLYPH_MISS_*
+// constants in TerminalShaders.metal.
+
+import Metal
+
+// MARK: - GPUGlyphTable
+
+final class GPUGlyphTable {
+
+    /// Matches `GlyphTableParams` in the shader (setVertexBytes at buffer 5).
+    struct Params {
+        var mask: UInt32
+        var shift: UInt32
+    }
+
+    static let emptyKey: UInt32 = 0xFFFF_FFFF
+    static let tombstoneKey: UInt32 = 0xFFFF_FFFE
+
+    /// Slot count; a power of two.
+    let capacity: Int
+
+    /// Table slots, bound at vertex buffer 2.
+    private(set) var buffer: MTLBuffer?
+
+    /// One byte per slot, set by the shader on a hit; vertex buffer 3.
+    private(set) var usageBuffer: MTLBuffer?
+
+    /// Live keys.
+    private(set) var count = 0
+
+    private var tombstones = 0
+    private let device: MTLDevice
+    private let shift: UInt32
+
+    var params: Params {
+        Params(mask: UInt32(capacity - 1), shift: shift)
+    }
+
+    /// - Parameter minimumCapacity: Live entries the table must hold; the
+    ///   slot count is the next power of two at least twice this.
+    init(device: MTLDevice, minimumCapacity: Int) {
+        var slots = 16
+        while slots < minimumCapacity * 2 { slots <<= 1 }
+        self.device = device
+        self.capacity = slots
+        self.shift = UInt32(32 - slots.trailingZeroBitCount)
+        allocateBuffers()
+    }
+
+    // MARK: - Keys
+
+    @inline(__always)
+    static func packKey(_ key: GlyphKey) -> UInt32 {
+        (key.codepoint << 2) | (key.bold ? 2 : 0) | (key.italic ? 1 : 0)
+    }
+
+    @inline(__always)
+    static func unpackKey(_ packed: UInt32) -> GlyphKey {
+        GlyphKey(codepoint: packed >> 2, bold: packed & 2 != 0, italic: packed & 1 != 0)
+    }
+
+    @inline(__always)
+    private func home(_ key: UInt32) -> Int {
+        Int((key &* 0x9E37_79B1) >> shift)
+    }
+
+    // MARK: - Mutation
+
+    /// Map `key` to a packed atlas position, replacing any existing value.
+    func insert(_ key: GlyphKey, value: UInt32) {
+        guard let slots = slotPointer() else { return }
+        let packed = Self.packKey(key)
+        let mask = capacity - 1
+        var index = home(packed)
+        var reusable: Int?
+        while true {
+            let slotKey = slots[index].x
+            if slotKey == packed {
+                slots[index].y = value
+                return
+            }
+            if slotKey == Self.tombstoneKey, reusable == nil {
+                reusable = index
+            } else if slotKey == Self.emptyKey {
+                break
+            }
+            index = (index + 1) & mask
+        }
+
+        if let reusable {
+            index = reusable
+            tombstones -= 1
+        }
+        // Value before key, so a concurrent probe never sees the key with a
+        // stale value.
+        slots[index].y = value
+        slots[index].x = packed
+        count += 1
+
+        if (count + tombstones) * 4 > capacity * 3 {
+            rebuild()
+        }
+    }
+
+    func remove(_ key: GlyphKey) {
+        guard let slots = slotPointer(), let index = find(Self.packKey(key), in: slots) else { return }
+        slots[index].x = Self.tombstoneKey
+        count -= 1
+        tombstones += 1
+    }
+
+    func removeAll() {
+        count = 0
+        tombstones = 0
+        allocateBuffers()
+    }
+
+    /// The packed atlas position for `key`, as the shader would resolve it.
+    func lookup(_ key: GlyphKey) -> UInt32? {
+        guard let slots = slotPointer(), let index = find(Self.packKey(key), in: slots) else { return nil }
+        return slots[index].y
+    }
+
+    // MARK: - Feedback
+
+    /// Keys of slots the shader marked as used since the last call, clearing
+    /// the marks. Drives GlyphCache's LRU order.
+    func drainUsedKeys() -> [GlyphKey] {
+        guard let slots = slotPointer(), let usage = usageBuffer else { return [] }
+        let words = usage.contents().bindMemory(to: UInt64.self, capacity: capacity / 8)
+        var keys: [GlyphKey] = []
+        for word in 0..<(capacity / 8) where words[word] != 0 {
+            var bits = words[word]
+            words[word] = 0
+            while bits != 0 {
+                let byte = bits.trailingZeroBitCount / 8
+                bits &= ~(UInt64(0xFF) << UInt64(byte * 8))
+                let slotKey = slots[word * 8 + byte].x
+                if slotKey != Self.emptyKey, slotKey != Self.tombstoneKey {
+                    keys.append(Self.unpackKey(slotKey))
+                }
+            }
+        }
+        return keys
+    }
+
+    // MARK: - Private
+
+    private func slotPointer() -> UnsafeMutablePointer<SIMD2<UInt32>>? {
+        buffer?.contents().bindMemory(to: SIMD2<UInt32>.self, capacity: capacity)
+    }
+
+    private func find(_ packed: UInt32, in slots: UnsafeMutablePointer<SIMD2<UInt32>>) -> Int? {
+        let mask = capacity - 1
+        var index = home(packed)
+        for _ in 0..<capacity {
+            let slotKey = slots[index].x
+            if slotKey == packed { return index }
+            if slotKey == Self.emptyKey { return nil }
+            index = (index + 1) & mask
+        }
+        return nil
+    }
+
+    /// Fresh, empty buffers. Frames in flight keep the old ones alive.
+    private func allocateBuffers() {
+        let table = device.makeBuffer(length: capacity * MemoryLayout<SIMD2<UInt32>>.stride, options: .storageModeShared)
+        table?.label = "GlyphTable"
+        if let table {
+            memset(table.contents(), 0xFF, table.length)
+        }
+        let usage = device.makeBuffer(length: capacity, options: .storageModeShared)
+        usage?.label = "GlyphTableUsage"
+        buffer = table
+        usageBuffer = usage
+    }
+
+    /// Drop tombstones by re-inserting every live entry into new buffers.
+    private func rebuild() {
+        guard let old = slotPointer() else { return }
+        let live = (0..<capacity).compactMap { index -> (UInt32, UInt32)? in
+            let slotKey = old[index].x
+            guard slotKey != Self.emptyKey, slotKey != Self.tombstoneKey else { return nil }
+            return (slotKey, old[index].y)
+        }
+        let oldBuffer = buffer
+        allocateBuffers()
+        count = 0
+        tombstones = 0
+        guard buffer != nil else {
+            buffer = oldBuffer
+            return
+        }
+        for (packed, value) in live {
+            insert(Self.unpackKey(packed), value: value)
+        }
+    }
+}
+
+// MARK: - GlyphMissLog
+
+/// The shader's per-frame list of glyph keys it could not resolve, one per
+/// in-flight frame. Read back in the command buffer's completion handler,
+/// before the frame's slot is reused.
+nonisolated final class GlyphMissLog: @unchecked Sendable {
+
+    /// Must match GLYPH_MISS_CAPACITY in the shader. Keys past this in one
+    /// frame are dropped; they miss again on the redraw after the first
+    /// batch is rasterized.
+    static let capacity = 1024
+
+    /// `[count: UInt32, pad x3, keys: UInt32 x capacity]`, vertex buffer 4.
+    let buffer: MTLBuffer
+
+    init?(device: MTLDevice) {
+        guard let buffer = device.makeBuffer(length: (4 + Self.capacity) * 4, options: .storageModeShared) else {
+            return nil
+        }
+        buffer.label = "GlyphMissLog"
+        memset(buffer.contents(), 0, buffer.length)
+        self.buffer = buffer
+    }
+
+    /// Distinct keys logged by the frame, resetting the log.
+    func drain() -> Set<UInt32> {
+        let words = buffer.contents().bindMemory(to: UInt32.self, capacity: 4 + Self.capacity)
+        let logged = min(Int(words[0]), Self.capacity)
+        words[0] = 0
+        guard logged > 0 else { return [] }
+        return Set(UnsafeBufferPointer(start: words + 4, count: logged))
+    }
+}
@@ -2,10 +2,16 @@
 // ProSSHV2
 //
 // Metal texture atlas for glyph storage.
-// Manages one or more MTLTexture pages (each 2048x2048, .bgra8Unorm)
-// with row-major glyph packing. The atlas is the backing store for
-// rasterized glyphs — the GlyphCache maps GlyphKeys to AtlasEntry
+// Monochrome text glyphs live on `.r8Unorm` coverage pages (one byte per
+// texel); colour emoji live on `.bgra8Unorm` colour pages. Each kind packs
+// row-major into its own 2048x2048 pages. The atlas is the backing store
+// for rasterized glyphs — the GlyphCache maps GlyphKeys to AtlasEntry
 // positions within these textures.
+//
+// Each page counts the glyphs it holds. When eviction leaves enough free
+// slots on earlier pages, SharedGlyphStorage compacts the pool while idle:
+// glyphs on its last page move into those slots (`relocate`) and the
+// emptied page is released, so pages do not accumulate over a long session.
 
 import Metal
 
@@ -17,6 +23,10 @@ private let kAtlasPageSize: Int = 2048
 /// Maximum number of atlas pages before the atlas is considered full.
 private let kMaxAtlasPages: Int = 16
 
+/// Page indices below this are coverage pages; the rest are colour pages.
+/// Must match `COLOR_PAGE_BASE` in `TerminalShaders.metal`.
+private let kColorPageBase: Int = 8
+
 // MARK: - AtlasPage
 
 /// Internal representation of a single atlas texture page.
@@ -28,21 +38,110 @@ private struct AtlasPage {
     let index: UInt8
 }
 
+// MARK: - AtlasPool
+
+/// Pages of one pixel format plus their packing cursor and free lists.
+private struct AtlasPool {
+
+    /// A recycled atlas region from an evicted glyph.
+    struct FreeSlot {
+        let page: UInt8
+        let x: UInt16
+        let y: UInt16
+        let width: UInt8
+    }
+
+    let pixelFormat: MTLPixelFormat
+    let bytesPerPixel: Int
+    /// Atlas-wide index of this pool's first page.
+    let firstPageIndex: Int
+    let maxPages: Int
+    let label: String
+
+    var pages: [AtlasPage] = []
+    /// Glyphs placed on each page and not yet reclaimed or moved.
+    var liveCounts: [Int] = []
+    var nextX: Int = 0
+    var nextY: Int = 0
+    var rowHeight: Int = 0
+
+    /// Free slots from evicted narrow (1-cell) glyphs.
+    var freeNarrowSlots: [FreeSlot] = []
+
+    /// Free slots from evicted wide (2-cell) glyphs.
+    var freeWideSlots: [FreeSlot] = []
+
+    func page(at index: Int) -> AtlasPage? {
+        let local = index - firstPageIndex
+        guard local >= 0, local < pages.count else { return nil }
+        return pages[local]
+    }
+
+    mutating func adjustLiveCount(page index: Int, by delta: Int) {
+        let local = index - firstPageIndex
+        guard local >= 0, local < liveCounts.count else { return }
+        liveCounts[local] = max(liveCounts[local] + delta, 0)
+    }
+
+    /// Pop a free slot of the given width class on a page before `page`.
+    mutating func popFreeSlot(wide: Bool, before page: UInt8) -> FreeSlot? {
+        if wide {
+            guard let index = freeWideSlots.lastIndex(where: { $0.page < page }) else { return nil }
+            return freeWideSlots.remove(at: index)
+        }
+        guard let index = freeNarrowSlots.lastIndex(where: { $0.page < page }) else { return nil }
+        return freeNarrowSlots.remove(at: index)
+    }
+
+    /// Drop every page (or all but the first) and reset packing.
+    mutating func reset(rowHeight: Int, keepingFirstPage: Bool) {
+        nextX = 0
+        nextY = 0
+        self.rowHeight = rowHeight
+        freeNarrowSlots.removeAll(keepingCapacity: true)
+        freeWideSlots.removeAll(keepingCapacity: true)
+        if !keepingFirstPage {
+            pages.removeAll()
+        } else if pages.count > 1 {
+            pages.removeSubrange(1...)
+        }
+        liveCounts = Array(repeating: 0, count: pages.count)
+    }
+}
+
 // MARK: - GlyphAtlas
 
 /// Manages a multi-page Metal texture atlas for glyph storage.
 ///
-/// Glyphs are packed in row-major order within each page. All pages use
-/// `.bgra8Unorm` pixel format so text glyphs and color emoji can coexist
-/// on the same page. The shader distinguishes between them at render time.
+/// Text glyphs are stored as single-channel coverage on `.r8Unorm` pages,
+/// a quarter of the memory and upload bandwidth of BGRA. Colour emoji keep
+/// `.bgra8Unorm` pages. Page indices `0..<colorPageBase` are coverage and
+/// the rest colour, so the page bits of the packed glyph index tell the
+/// shader which kind it is sampling.
 ///
 /// Usage:
 /// 1. Create the atlas with a Metal device and initial cell dimensions.
-/// 2. Call `allocate(width:height:pixelData:)` to place a rasterized glyph.
+/// 2. Call `allocate(width:height:pixelData:isColor:)` to place a rasterized glyph.
 /// 3. The returned `AtlasEntry` contains the UV coordinates for the shader.
 /// 4. On font change, call `rebuild(cellWidth:cellHeight:device:)` to reset.
 final class GlyphAtlas {
     static let maxPageCount = kMaxAtlasPages
+    static let defaultPageSize = kAtlasPageSize
+    static let colorPageBase = kColorPageBase
+
+    /// Layout of the bytes handed to `allocate`.
+    enum PixelLayout {
+        /// Rasterizer output: premultiplied BGRA, 4 bytes per pixel.
+        case bgra
+        /// One coverage byte per pixel, as stored by `GlyphDiskCache`.
+        /// Text glyphs only.
+        case coverage
+    }
+
+    /// Whether an atlas page index refers to a colour page.
+    static func isColorPage(_ page: UInt8) -> Bool {
+        Int(page) >= kColorPageBase
+    }
 
     // MARK: - Properties
 
@@ -55,37 +154,15 @@ final class GlyphAtlas {
     /// Height of a single glyph cell in pixels.
     private(set) var cellHeight: Int
 
-    /// All allocated atlas texture pages.
-    private var pages: [AtlasPage] = []
-
-    /// Current packing X position within the active page (pixels).
-    private var nextX: Int = 0
-
-    /// Current packing Y position within the active page (pixels).
-    private var nextY: Int = 0
+    /// Coverage pages for text glyphs.
+    private var coverage: AtlasPool
 
-    /// Height of the current packing row (equals cellHeight).
-    private var rowHeight: Int = 0
+    /// BGRA pages for colour emoji, allocated on first use.
+    private var color: AtlasPool
 
     /// Atlas page dimension (width = height = kAtlasPageSize).
     let pageSize: Int
 
-    // MARK: - Free Slot Recycling
-
-    /// A recycled atlas region from an evicted glyph.
-    private struct FreeSlot {
-        let page: UInt8
-        let x: UInt16
-        let y: UInt16
-        let width: UInt8
-    }
-
-    /// Free slots from evicted narrow (1-cell) glyphs.
-    private var freeNarrowSlots: [FreeSlot] = []
-
-    /// Free slots from evicted wide (2-cell) glyphs.
-    private var freeWideSlots: [FreeSlot] = []
-
     /// Number of allocations that reused a recycled slot.
     private(set) var recycledAllocations: Int = 0
 
@@ -103,21 +180,36 @@ final class GlyphAtlas {
         self.cellWidth = cellWidth
         self.cellHeight = cellHeight
         self.pageSize = pageSize
-        self.rowHeight = cellHeight
+        self.coverage = AtlasPool(
+            pixelFormat: .r8Unorm, bytesPerPixel: 1,
+            firstPageIndex: 0, maxPages: kColorPageBase,
+            label: "GlyphAtlas Coverage", rowHeight: cellHeight
+        )
+        self.color = AtlasPool(
+            pixelFormat: .bgra8Unorm, bytesPerPixel: 4,
+            firstPageIndex: kColorPageBase, maxPages: kMaxAtlasPages - kColorPageBase,
+            label: "GlyphAtlas Color", rowHeight: cellHeight
+        )
     }
 
     // MARK: - Page Management
 
     /// Returns the number of allocated atlas pages.
     var pageCount: Int {
-        pages.count
+        coverage.pages.count + color.pages.count
+    }
+
+    /// Number of allocated colour pages.
+    var colorPageCount: Int {
+        color.pages.count
     }
 
     /// Estimated memory usage (bytes) of allocated atlas textures.
     ///
-    /// Uses BGRA8 layout: 4 bytes per pixel.
+    /// Coverage pages are 1 byte per pixel, colour pages 4.
     var estimatedMemoryBytes: Int {
-        pageCount * pageSize * pageSize * 4
+        (coverage.pages.count * coverage.bytesPerPixel + color.pages.count * color.bytesPerPixel)
+            * pageSize * pageSize
     }
 
     /// Returns the texture for a given page index, or nil if out of range.
@@ -125,23 +217,22 @@ final class GlyphAtlas {
     /// - Parameter page: Zero-based page index.
     /// - Returns: The `MTLTexture` for that page, or nil.
     func texture(forPage page: Int) -> MTLTexture? {
-        if page == 0 {
-            return pages.first?.texture
+        if page < kColorPageBase {
+            return coverage.page(at: page)?.texture
         }
-        guard page >= 0, page < pages.count else { return nil }
-        return pages[page].texture
+        return color.page(at: page)?.texture
     }
 
-    /// Allocates a new atlas page texture.
+    /// Allocates a new page texture in `pool`.
     ///
     /// - Returns: The newly created `AtlasPage`, or nil if allocation fails
-    ///   or the maximum page count has been reached.
+    ///   or the pool's maximum page count has been reached.
     @discardableResult
-    private func allocatePage() -> AtlasPage? {
-        guard pages.count < kMaxAtlasPages else { return nil }
+    private func allocatePage(in pool: inout AtlasPool) -> AtlasPage? {
+        guard pool.pages.count < pool.maxPages else { return nil }
 
         let descriptor = MTLTextureDescriptor.texture2DDescriptor(
-            pixelFormat: .bgra8Unorm,
+            pixelFormat: pool.pixelFormat,
             width: pageSize,
             height: pageSize,
             mipmapped: false
@@ -153,32 +244,37 @@ final class GlyphAtlas {
             return nil
         }
 
-        texture.label = "GlyphAtlas Page \(pages.count)"
+        texture.label = "\(pool.label) Page \(pool.pages.count)"
 
-        let page = AtlasPage(texture: texture, index: UInt8(pages.count))
-        pages.append(page)
+        let page = AtlasPage(texture: texture, index: UInt8(pool.firstPageIndex + pool.pages.count))
+        pool.pages.append(page)
+        pool.liveCounts.append(0)
         return page
     }
 
     /// Total number of free slots available for recycling.
     var freeSlotCount: Int {
-        freeNarrowSlots.count + freeWideSlots.count
+        coverage.freeNarrowSlots.count + coverage.freeWideSlots.count
+            + color.freeNarrowSlots.count + color.freeWideSlots.count
     }
 
     /// Reclaims an evicted glyph's atlas region for future reuse.
     ///
     /// - Parameter entry: The `AtlasEntry` of the evicted glyph.
     func reclaimRegion(entry: AtlasEntry) {
-        let slot = FreeSlot(
+        let slot = AtlasPool.FreeSlot(
             page: entry.atlasPage,
             x: entry.x,
             y: entry.y,
             width: entry.width
         )
-        if entry.width > UInt8(clamping: cellWidth) {
-            freeWideSlots.append(slot)
+        let isWide = entry.width > UInt8(clamping: cellWidth)
+        if Self.isColorPage(entry.atlasPage) {
+            if isWide { color.freeWideSlots.append(slot) } else { color.freeNarrowSlots.append(slot) }
+            color.adjustLiveCount(page: Int(entry.atlasPage), by: -1)
         } else {
-            freeNarrowSlots.append(slot)
+            if isWide { coverage.freeWideSlots.append(slot) } else { coverage.freeNarrowSlots.append(slot) }
+            coverage.adjustLiveCount(page: Int(entry.atlasPage), by: -1)
         }
     }
 
@@ -187,48 +283,71 @@ final class GlyphAtlas {
     /// Allocates space in the atlas for a glyph, uploads pixel data, and
     /// returns an `AtlasEntry` describing its location.
     ///
-    /// The glyph is placed at the next available slot using row-major packing.
-    /// If the current page is full, a new page is allocated automatically.
-    /// Recycled slots from evicted glyphs are preferred when available.
+    /// Text glyphs go to a coverage page (only the alpha channel is
+    /// uploaded); colour glyphs go to a colour page. Within a pool the glyph
+    /// is placed at the next available slot using row-major packing, and a
+    /// new page is allocated when the current one is full. Recycled slots
+    /// from evicted glyphs are preferred when available.
     ///
     /// - Parameters:
     ///   - width: Width of the glyph bitmap in pixels.
     ///            For standard glyphs this is `cellWidth`; for wide glyphs, `2 * cellWidth`.
     ///   - height: Height of the glyph bitmap in pixels (typically `cellHeight`).
-    ///   - pixelData: Raw pixel data in BGRA8 format. Must contain exactly
-    ///                `width * height * 4` bytes.
+    ///   - pixelData: Raw pixel data in `layout`. BGRA8 must contain exactly
+    ///                `width * height * 4` bytes, coverage `width * height`.
     ///   - bearingX: Horizontal bearing offset for glyph positioning.
     ///   - bearingY: Vertical bearing offset (baseline) for glyph positioning.
+    ///   - isColor: Whether the glyph carries colour (emoji) rather than coverage.
+    ///   - layout: How `pixelData` is laid out; `.coverage` requires `!isColor`.
     /// - Returns: An `AtlasEntry` with the glyph's location, or nil if allocation fails.
     func allocate(
         width: Int,
         height: Int,
         pixelData: UnsafeRawPointer,
         bearingX: Int8 = 0,
-        bearingY: Int8 = 0
+        bearingY: Int8 = 0,
+        isColor: Bool = false,
+        layout: PixelLayout = .bgra
     ) -> AtlasEntry? {
         guard width > 0, height > 0 else { return nil }
         guard width <= pageSize, height <= pageSize else { return nil }
+        guard !(isColor && layout == .coverage) else { return nil }
 
+        if isColor {
+            return allocate(in: &color, width: width, height: height, pixelData: pixelData, layout: layout, bearingX: bearingX, bearingY: bearingY)
+        }
+        return allocate(in: &coverage, width: width, height: height, pixelData: pixelData, layout: layout, bearingX: bearingX, bearingY: bearingY)
+    }
+
+    private func allocate(
+        in pool: inout AtlasPool,
+        width: Int,
+        height: Int,
+        pixelData: UnsafeRawPointer,
+        layout: PixelLayout,
+        bearingX: Int8,
+        bearingY: Int8
+    ) -> AtlasEntry? {
         // Try to recycle a free slot from a previously evicted glyph.
-        let freeSlot: FreeSlot?
-        if width > cellWidth, let slot = freeWideSlots.popLast() {
+        let freeSlot: AtlasPool.FreeSlot?
+        if width > cellWidth, let slot = pool.freeWideSlots.popLast() {
             freeSlot = slot
-        } else if width <= cellWidth, let slot = freeNarrowSlots.popLast() {
+        } else if width <= cellWidth, let slot = pool.freeNarrowSlots.popLast() {
             freeSlot = slot
         } else {
             freeSlot = nil
         }
 
         if let slot = freeSlot {
-            let pageIndex = Int(slot.page)
-            guard pageIndex < pages.count else {
+            guard let page = pool.page(at: Int(slot.page)) else {
                 // Page was removed (e.g., after clear/rebuild) — fall through.
-                return allocateFresh(width: width, height: height, pixelData: pixelData, bearingX: bearingX, bearingY: bearingY)
+                return allocateFresh(in: &pool, width: width, height: height, pixelData: pixelData, layout: layout, bearingX: bearingX, bearingY: bearingY)
             }
 
-            uploadRegion(
-                page: pageIndex,
+            upload(
+                to: page.texture,
+                isColor: Int(slot.page) >= kColorPageBase,
+                layout: layout,
                 x: Int(slot.x),
                 y: Int(slot.y),
                 width: width,
@@ -237,6 +356,7 @@ final class GlyphAtlas {
             )
 
             recycledAllocations += 1
+            pool.adjustLiveCount(page: Int(slot.page), by: 1)
 
             return AtlasEntry(
                 atlasPage: slot.page,
@@ -248,46 +368,51 @@ final class GlyphAtlas {
             )
         }
 
-        return allocateFresh(width: width, height: height, pixelData: pixelData, bearingX: bearingX, bearingY: bearingY)
+        return allocateFresh(in: &pool, width: width, height: height, pixelData: pixelData, layout: layout, bearingX: bearingX, bearingY: bearingY)
     }
 
     /// Cursor-advance allocation path (original row-major packing).
     private func allocateFresh(
+        in pool: inout AtlasPool,
         width: Int,
         height: Int,
         pixelData: UnsafeRawPointer,
+        layout: PixelLayout,
         bearingX: Int8,
         bearingY: Int8
     ) -> AtlasEntry? {
         // Ensure we have at least one page.
-        if pages.isEmpty {
-            guard allocatePage() != nil else { return nil }
+        if pool.pages.isEmpty {
+            guard allocatePage(in: &pool) != nil else { return nil }
         }
 
         // Try to fit the glyph in the current row of the current page.
 
-        if nextX + width > pageSize {
+        if pool.nextX + width > pageSize {
             // Move to the next row and reset row height for the new row.
-            nextX = 0
-            nextY += rowHeight
-            rowHeight = cellHeight
+            pool.nextX = 0
+            pool.nextY += pool.rowHeight
+            pool.rowHeight = cellHeight
         }
 
-        if nextY + height > pageSize {
+        if pool.nextY + height > pageSize {
             // Current page is full — allocate a new page.
-            guard allocatePage() != nil else { return nil }
-            nextX = 0
-            nextY = 0
-            rowHeight = cellHeight
+            guard allocatePage(in: &pool) != nil else { return nil }
+            pool.nextX = 0
+            pool.nextY = 0
+            pool.rowHeight = cellHeight
         }
 
-        let currentPageIndex = pages.count - 1
-        let placedX = nextX
-        let placedY = nextY
+        let currentPageIndex = pool.firstPageIndex + pool.pages.count - 1
+        let placedX = pool.nextX
+        let placedY = pool.nextY
 
-        // Upload pixel data to the atlas texture.
-        uploadRegion(
-            page: currentPageIndex,
+        // Upload pixel data to the atlas texture. The pool is borrowed
+        // inout here, so the texture comes from it rather than a lookup.
+        upload(
+            to: pool.pages[pool.pages.count - 1].texture,
+            isColor: currentPageIndex >= kColorPageBase,
+            layout: layout,
             x: placedX,
             y: placedY,
             width: width,
@@ -296,11 +421,12 @@ final class GlyphAtlas {
         )
 
         // Advance the packing cursor.
-        nextX += width
+        pool.nextX += width
+        pool.liveCounts[pool.liveCounts.count - 1] += 1
 
         // Update row height to accommodate the tallest glyph in this row.
-        if height > rowHeight {
-            rowHeight = height
+        if height > pool.rowHeight {
+            pool.rowHeight = height
         }
 
         return AtlasEntry(
@@ -313,12 +439,170 @@ final class GlyphAtlas {
         )
     }
 
+    // MARK: - Compaction
+
+    /// Page/slot usage of one pool, or of the whole atlas.
+    struct Occupancy: Equatable {
+        /// Allocated pages.
+        var pages: Int = 0
+        /// Narrow glyph slots the allocated pages can hold.
+        var capacity: Int = 0
+        /// Glyphs currently placed.
+        var liveGlyphs: Int = 0
+        /// Recycled slots waiting for reuse.
+        var freeSlots: Int = 0
+
+        /// Fraction of `capacity` holding live glyphs (wide glyphs count once).
+        var utilization: Double {
+            capacity > 0 ? Double(liveGlyphs) / Double(capacity) : 0
+        }
+
+        static func + (lhs: Occupancy, rhs: Occupancy) -> Occupancy {
+            Occupancy(
+                pages: lhs.pages + rhs.pages,
+                capacity: lhs.capacity + rhs.capacity,
+                liveGlyphs: lhs.liveGlyphs + rhs.liveGlyphs,
+                freeSlots: lhs.freeSlots + rhs.freeSlots
+            )
+        }
+    }
+
+    /// Occupancy of the coverage pages.
+    var coverageOccupancy: Occupancy { occupancy(of: coverage) }
+
+    /// Occupancy of the colour pages.
+    var colorOccupancy: Occupancy { occupancy(of: color) }
+
+    /// Occupancy of the whole atlas.
+    var occupancy: Occupancy { coverageOccupancy + colorOccupancy }
+
+    private func occupancy(of pool: AtlasPool) -> Occupancy {
+        Occupancy(
+            pages: pool.pages.count,
+            capacity: pool.pages.count * glyphsPerPage,
+            liveGlyphs: pool.liveCounts.reduce(0, +),
+            freeSlots: pool.freeNarrowSlots.count + pool.freeWideSlots.count
+        )
+    }
+
+    /// The last page of a pool worth draining: one of at least two pages
+    /// whose live glyphs fit in the free slots on the pool's earlier pages.
+    /// Coverage is checked first. Nil when neither pool qualifies.
+    func compactionCandidatePage() -> UInt8? {
+        for pool in [coverage, color] where pool.pages.count >= 2 {
+            let last = UInt8(pool.firstPageIndex + pool.pages.count - 1)
+            let live = pool.liveCounts.last ?? 0
+            let free = pool.freeNarrowSlots.lazy.filter { $0.page < last }.count
+                + pool.freeWideSlots.lazy.filter { $0.page < last }.count
+            if live <= free {
+                return last
+            }
+        }
+        return nil
+    }
+
+    /// Move `entry`'s bitmap into a free slot on an earlier page of its
+    /// pool and return the new entry. Its old region becomes free. Nil when
+    /// no free slot of its width class exists on an earlier page.
+    func relocate(_ entry: AtlasEntry) -> AtlasEntry? {
+        if Self.isColorPage(entry.atlasPage) {
+            return relocate(entry, in: &color)
+        }
+        return relocate(entry, in: &coverage)
+    }
+
+    private func relocate(_ entry: AtlasEntry, in pool: inout AtlasPool) -> AtlasEntry? {
+        let width = Int(entry.width)
+        let height = cellHeight
+        guard let source = pool.page(at: Int(entry.atlasPage)),
+              let slot = pool.popFreeSlot(wide: width > cellWidth, before: entry.atlasPage) else {
+            return nil
+        }
+        guard let destination = pool.page(at: Int(slot.page)) else { return nil }
+
+        let bytesPerRow = width * pool.bytesPerPixel
+        if relocationScratch.count < bytesPerRow * height {
+            relocationScratch = [UInt8](repeating: 0, count: bytesPerRow * height)
+        }
+        relocationScratch.withUnsafeMutableBytes { bytes in
+            source.texture.getBytes(
+                bytes.baseAddress!,
+                bytesPerRow: bytesPerRow,
+                from: MTLRegion(
+                    origin: MTLOrigin(x: Int(entry.x), y: Int(entry.y), z: 0),
+                    size: MTLSize(width: width, height: height, depth: 1)
+                ),
+                mipmapLevel: 0
+            )
+            destination.texture.replace(
+                region: MTLRegion(
+                    origin: MTLOrigin(x: Int(slot.x), y: Int(slot.y), z: 0),
+                    size: MTLSize(width: width, height: height, depth: 1)
+                ),
+                mipmapLevel: 0,
+                withBytes: bytes.baseAddress!,
+                bytesPerRow: bytesPerRow
+            )
+        }
+        pool.adjustLiveCount(page: Int(slot.page), by: 1)
+
+        let moved = AtlasEntry(
+            atlasPage: slot.page,
+            x: slot.x,
+            y: slot.y,
+            width: entry.width,
+            bearingX: entry.bearingX,
+            bearingY: entry.bearingY
+        )
+        reclaimRegion(entry: entry)
+        return moved
+    }
+
+    /// Release the last page of `page`'s pool once nothing references it.
+    /// The pool's first coverage page is kept. The caller guarantees no
+    /// cached glyph still points at the page; its free slots are dropped
+    /// and the next fresh allocation opens a new page.
+    @discardableResult
+    func releaseLastPage(_ page: UInt8) -> Bool {
+        if Self.isColorPage(page) {
+            return releaseLastPage(page, in: &color, minimumPages: 0)
+        }
+        return releaseLastPage(page, in: &coverage, minimumPages: 1)
+    }
+
+    private func releaseLastPage(_ page: UInt8, in pool: inout AtlasPool, minimumPages: Int) -> Bool {
+        guard pool.pages.count > minimumPages,
+              Int(page) == pool.firstPageIndex + pool.pages.count - 1 else {
+            return false
+        }
+        pool.pages.removeLast()
+        pool.liveCounts.removeLast()
+        pool.freeNarrowSlots.removeAll { $0.page == page }
+        pool.freeWideSlots.removeAll { $0.page == page }
+        // The remaining last page was full when the released one opened.
+        pool.nextX = 0
+        pool.nextY = pool.pages.isEmpty ? 0 : pageSize
+        pool.rowHeight = cellHeight
+        releasedPageCount += 1
+        return true
+    }
+
+    /// Pages released by compaction since creation.
+    private(set) var releasedPageCount = 0
+
+    /// Reused buffer for moving a glyph between pages.
+    private var relocationScratch: [UInt8] = []
+
     // MARK: - Texture Upload
 
+    /// Reused buffer for extracting coverage from BGRA rasterizer output.
+    private var coverageScratch: [UInt8] = []
+
     /// Uploads raw pixel data to a specific region of an atlas page texture.
     ///
     /// Uses `MTLTexture.replace(region:mipmapLevel:withBytes:bytesPerRow:)` for
-    /// the upload. The data must be in BGRA8 format (4 bytes per pixel).
+    /// the upload. The data is in BGRA8 format (4 bytes per pixel); for a
+    /// coverage page only the alpha byte of each pixel is uploaded.
     ///
     /// - Parameters:
     ///   - page: Zero-based page index.
@@ -336,6 +620,19 @@ final class GlyphAtlas {
         data: UnsafeRawPointer
     ) {
         guard let texture = texture(forPage: page) else { return }
+        upload(to: texture, isColor: page >= kColorPageBase, layout: .bgra, x: x, y: y, width: width, height: height, data: data)
+    }
+
+    private func upload(
+        to texture: MTLTexture,
+        isColor: Bool,
+        layout: PixelLayout,
+        x: Int,
+        y: Int,
+        width: Int,
+        height: Int,
+        data: UnsafeRawPointer
+    ) {
         guard width > 0, height > 0 else { return }
 
         let region = MTLRegion(
@@ -343,15 +640,43 @@ final class GlyphAtlas {
             size: MTLSize(width: width, height: height, depth: 1)
         )
 
-        let bytesPerPixel = 4 // BGRA8
-        let bytesPerRow = width * bytesPerPixel
+        if isColor {
+            texture.replace(
+                region: region,
+                mipmapLevel: 0,
+                withBytes: data,
+                bytesPerRow: width * 4
+            )
+            return
+        }
 
-        texture.replace(
-            region: region,
-            mipmapLevel: 0,
-            withBytes: data,
-            bytesPerRow: bytesPerRow
-        )
+        if layout == .coverage {
+            texture.replace(
+                region: region,
+                mipmapLevel: 0,
+                withBytes: data,
+                bytesPerRow: width
+            )
+            return
+        }
+
+        // Premultiplied BGRA in memory order: alpha is byte 3 of each pixel.
+        let pixelCount = width * height
+        if coverageScratch.count < pixelCount {
+            coverageScratch = [UInt8](repeating: 0, count: pixelCount)
+        }
+        let source = data.assumingMemoryBound(to: UInt8.self)
+        coverageScratch.withUnsafeMutableBufferPointer { coverageBytes in
+            for index in 0..<pixelCount {
+                coverageBytes[index] = source[index * 4 + 3]
+            }
+            texture.replace(
+                region: region,
+                mipmapLevel: 0,
+                withBytes: coverageBytes.baseAddress!,
+                bytesPerRow: width
+            )
+        }
     }
 
     // MARK: - Atlas Queries
@@ -366,20 +691,20 @@ final class GlyphAtlas {
     }
 
     /// Returns the approximate number of remaining glyph slots on the
-    /// current page, assuming standard (non-wide) cell width.
+    /// current coverage page, assuming standard (non-wide) cell width.
     var remainingSlotsOnCurrentPage: Int {
         guard cellWidth > 0, cellHeight > 0 else { return 0 }
-        guard !pages.isEmpty else { return 0 }
+        guard !coverage.pages.isEmpty else { return 0 }
 
         let cols = pageSize / cellWidth
         let rows = pageSize / cellHeight
 
         // Slots used in fully packed rows above the current row.
-        let fullRowsAbove = nextY / cellHeight
+        let fullRowsAbove = coverage.nextY / cellHeight
         let slotsUsedInFullRows = fullRowsAbove * cols
 
         // Slots used in the current row.
-        let slotsUsedInCurrentRow = nextX / cellWidth
+        let slotsUsedInCurrentRow = coverage.nextX / cellWidth
 
         let totalSlots = cols * rows
         let usedSlots = slotsUsedInFullRows + slotsUsedInCurrentRow
@@ -393,22 +718,16 @@ final class GlyphAtlas {
     /// first page. Existing textures remain allocated but their contents are
     /// considered stale — the glyph cache must be invalidated separately.
     func clear() {
-        nextX = 0
-        nextY = 0
-        rowHeight = cellHeight
-        freeNarrowSlots.removeAll(keepingCapacity: true)
-        freeWideSlots.removeAll(keepingCapacity: true)
-        // Drop all pages except the first to reclaim memory.
-        if pages.count > 1 {
-            pages.removeSubrange(1...)
-        }
+        // Drop all pages except the first coverage page to reclaim memory.
+        coverage.reset(rowHeight: cellHeight, keepingFirstPage: true)
+        color.reset(rowHeight: cellHeight, keepingFirstPage: false)
     }
 
     /// Rebuilds the atlas for new cell dimensions (e.g., after a font change).
     ///
-    /// This deallocates all existing atlas pages, creates a fresh first page,
-    /// and resets the packing cursor. The caller must re-populate the atlas
-    /// by rasterizing all needed glyphs again.
+    /// This deallocates all existing atlas pages, creates a fresh first
+    /// coverage page, and resets the packing cursors. The caller must
+    /// re-populate the atlas by rasterizing all needed glyphs again.
     ///
     /// - Parameters:
     ///   - cellWidth: New glyph cell width in pixels.
@@ -416,18 +735,12 @@ final class GlyphAtlas {
     func rebuild(cellWidth: Int, cellHeight: Int) {
         self.cellWidth = cellWidth
         self.cellHeight = cellHeight
-        self.rowHeight = cellHeight
-
-        // Release all existing pages.
-        pages.removeAll()
 
-        // Reset packing cursor and free lists.
-        nextX = 0
-        nextY = 0
-        freeNarrowSlots.removeAll(keepingCapacity: true)
-        freeWideSlots.removeAll(keepingCapacity: true)
+        // Release all existing pages, reset packing cursors and free lists.
+        coverage.reset(rowHeight: cellHeight, keepingFirstPage: false)
+        color.reset(rowHeight: cellHeight, keepingFirstPage: false)
 
         // Allocate a fresh first page.
-        allocatePage()
+        allocatePage(in: &coverage)
     }
 }
@@ -0,0 +1,299 @@
+// GlyphAtlasStore.swift
+// ProSSHV2
+//
+// Process-wide sharing of glyph atlases. Renderers that draw the same font
+// at the same size and backing scale on the same MTLDevice sample from one
+// GlyphAtlas/GlyphCache pair instead of each rasterizing and storing its
+// own copy, so a new pane on an already-open font skips ASCII
+// pre-population entirely.
+//
+// Everything here runs on the main actor (the project default), as do the
+// renderers, which serializes insertion and eviction across panes.
+//
+// Storage also keeps its atlas compact over long sessions. An allocation
+// that finds the atlas full evicts the coldest glyph of the same kind and
+// retries, instead of failing. Once evictions have been quiet for
+// `compactionDelay`, glyphs on the last page of a pool are moved into slots
+// freed on earlier pages, a batch per step, and the emptied page is
+// released.
+//
+// The store also holds the storages handed out most recently, so a pane
+// that zooms back to a font size it just left finds that size's glyphs
+// still rasterized. Memory pressure lets them go.
+
+import Metal
+import CoreGraphics
+
+// MARK: - GlyphAtlasKey
+
+/// Everything that changes how a glyph rasterizes into the atlas.
+struct GlyphAtlasKey: Hashable {
+    let deviceID: UInt64
+    let fontName: String
+    let fontSize: CGFloat
+    let scale: CGFloat
+    let cellWidth: Int
+    let cellHeight: Int
+}
+
+// MARK: - GlyphEvictionObserver
+
+/// Notified when a shared cache evicts a glyph. Another pane may still have
+/// the evicted atlas slot in its cell buffer, so observers re-resolve.
+protocol GlyphEvictionObserver: AnyObject {
+    func sharedGlyphsEvicted()
+}
+
+// MARK: - SharedGlyphStorage
+
+/// One atlas, its glyph cache and the cache's GPU lookup table, alive as
+/// long as any renderer holds them.
+final class SharedGlyphStorage {
+
+    /// Occupancy and churn of one storage, for diagnostics.
+    struct Stats: Equatable {
+        var atlas: GlyphAtlas.Occupancy
+        var cachedGlyphs: Int
+        var pinnedGlyphs: Int
+        var evictions: Int
+        var relocatedGlyphs: Int
+        var releasedPages: Int
+    }
+
+    /// Quiet time after the last eviction before compaction starts.
+    static let compactionDelay: Duration = .seconds(5)
+
+    /// Glyphs moved per compaction step; steps are a frame apart.
+    static let compactionBatchSize = 256
+
+    private struct WeakObserver {
+        weak var observer: GlyphEvictionObserver?
+    }
+
+    let key: GlyphAtlasKey
+    let atlas: GlyphAtlas
+    let cache: GlyphCache
+    let table: GPUGlyphTable
+    /// Shaped runs whose tiles live in `atlas` (see GlyphShapingCache).
+    let shaping = GlyphShapingCache()
+
+    private var observers: [WeakObserver] = []
+
+    /// Glyphs moved by compaction since creation.
+    private(set) var relocatedGlyphCount = 0
+
+    private var lastEvictionTime = ContinuousClock.now
+
+    /// Pending or running compaction. Marked `nonisolated(unsafe)` so
+    /// deinit can cancel it.
+    nonisolated(unsafe) private var compactionTask: Task<Void, Never>?
+
+    init(key: GlyphAtlasKey, device: MTLDevice, cacheCapacity: Int, pageSize: Int = GlyphAtlas.defaultPageSize) {
+        self.key = key
+        self.atlas = GlyphAtlas(device: device, cellWidth: key.cellWidth, cellHeight: key.cellHeight, pageSize: pageSize)
+        self.cache = GlyphCache(maxCapacity: cacheCapacity)
+        self.table = GPUGlyphTable(device: device, minimumCapacity: cacheCapacity)
+        atlas.rebuild(cellWidth: key.cellWidth, cellHeight: key.cellHeight)
+        cache.table = table
+
+        // Recycle evicted regions, then let every sharer drop stale indices.
+        cache.onEvict = { [weak self] entry in
+            guard let self else { return }
+            self.atlas.reclaimRegion(entry: entry)
+            self.notifyEviction()
+            self.scheduleCompaction()
+        }
+    }
+
+    deinit {
+        compactionTask?.cancel()
+    }
+
+    var stats: Stats {
+        Stats(
+            atlas: atlas.occupancy,
+            cachedGlyphs: cache.count,
+            pinnedGlyphs: cache.pinnedCount,
+            evictions: cache.evictionCount,
+            relocatedGlyphs: relocatedGlyphCount,
+            releasedPages: atlas.releasedPageCount
+        )
+    }
+
+    // MARK: - Allocation
+
+    /// Place `rasterized` in the atlas. When the atlas is full, the coldest
+    /// unpinned glyph of the same kind (colour or coverage, narrow or wide)
+    /// is evicted and the allocation retried once.
+    func allocate(_ rasterized: RasterizedGlyph) -> AtlasEntry? {
+        if let entry = place(rasterized) {
+            return entry
+        }
+        let isColor = rasterized.isColor
+        let isWide = rasterized.width > atlas.cellWidth
+        let cellWidth = atlas.cellWidth
+        let evicted = cache.evictColdest { entry in
+            GlyphAtlas.isColorPage(entry.atlasPage) == isColor && (Int(entry.width) > cellWidth) == isWide
+        }
+        return evicted ? place(rasterized) : nil
+    }
+
+    private func place(_ rasterized: RasterizedGlyph) -> AtlasEntry? {
+        rasterized.pixelData.withUnsafeBufferPointer { ptr -> AtlasEntry? in
+            guard let baseAddress = ptr.baseAddress else { return nil }
+            return atlas.allocate(
+                width: rasterized.width,
+                height: rasterized.height,
+                pixelData: baseAddress,
+                bearingX: Int8(clamping: rasterized.bearingX),
+                bearingY: Int8(clamping: rasterized.bearingY),
+                isColor: rasterized.isColor
+            )
+        }
+    }
+
+    // MARK: - Compaction
+
+    /// Note an eviction. Compaction starts once `compactionDelay` passes
+    /// without another one.
+    func scheduleCompaction() {
+        lastEvictionTime = .now
+        guard compactionTask == nil else { return }
+        compactionTask = Task { [weak self] in
+            while !Task.isCancelled {
+                guard let self else { return }
+                let wait = self.lastEvictionTime + Self.compactionDelay - .now
+                if wait <= .zero { break }
+                try? await Task.sleep(for: wait)
+            }
+            while !Task.isCancelled, let self, self.compactStep(maxMoves: Self.compactionBatchSize) {
+                try? await Task.sleep(for: .milliseconds(16))
+            }
+            self?.compactionTask = nil
+        }
+    }
+
+    /// Compact until no page can be released.
+    func compactNow() {
+        compactionTask?.cancel()
+        compactionTask = nil
+        while compactStep(maxMoves: .max) {}
+    }
+
+    /// Move up to `maxMoves` glyphs off a releasable last page, releasing
+    /// it once empty. True while more work remains.
+    @discardableResult
+    func compactStep(maxMoves: Int) -> Bool {
+        guard let page = atlas.compactionCandidatePage() else { return false }
+        let resident = cache.entries(onPage: page)
+        for (glyphKey, entry) in resident.prefix(maxMoves) {
+            guard let relocated = atlas.relocate(entry) else { return false }
+            cache.relocate(glyphKey, to: relocated)
+            relocatedGlyphCount += 1
+        }
+        guard resident.count <= maxMoves else { return true }
+        guard atlas.releaseLastPage(page) else { return false }
+        notifyEviction()
+        return true
+    }
+
+    func addEvictionObserver(_ observer: GlyphEvictionObserver) {
+        observers.removeAll { $0.observer == nil || $0.observer === observer }
+        observers.append(WeakObserver(observer: observer))
+    }
+
+    func removeEvictionObserver(_ observer: GlyphEvictionObserver) {
+        observers.removeAll { $0.observer == nil || $0.observer === observer }
+    }
+
+    private func notifyEviction() {
+        for entry in observers {
+            entry.observer?.sharedGlyphsEvicted()
+        }
+    }
+}
+
+// MARK: - GlyphAtlasStore
+
+/// Hands out `SharedGlyphStorage` by key. Storage is held weakly, so it is
+/// freed with the last renderer using it and ARC does the reference count.
+/// The `residentLimit` most recently requested storages are also held
+/// strongly, so recent font sizes outlive the renderers that left them.
+final class GlyphAtlasStore {
+
+    static let shared = GlyphAtlasStore()
+
+    /// Glyph cache capacity for every shared storage.
+    static let cacheCapacity = 8192
+
+    /// Recently requested storages kept alive without a renderer.
+    static let defaultResidentLimit = 4
+
+    let residentLimit: Int
+
+    private struct WeakStorage {
+        weak var storage: SharedGlyphStorage?
+    }
+
+    private var storages: [GlyphAtlasKey: WeakStorage] = [:]
+
+    /// Most recently requested first.
+    private var resident: [SharedGlyphStorage] = []
+
+    init(residentLimit: Int = GlyphAtlasStore.defaultResidentLimit) {
+        self.residentLimit = max(0, residentLimit)
+    }
+
+    /// Number of storages still alive, in use or resident.
+    var liveStorageCount: Int {
+        storages.values.filter { $0.storage != nil }.count
+    }
+
+    /// Memory held by every live storage: atlas pages and glyph tables.
+    var memoryFootprint: MemoryFootprint {
+        var bytes = 0
+        for case let storage? in storages.values.map(\.storage) {
+            bytes += storage.atlas.estimatedMemoryBytes
+                + (storage.table.buffer?.allocatedSize ?? 0)
+                + (storage.table.usageBuffer?.allocatedSize ?? 0)
+        }
+        return MemoryFootprint(.glyphAtlas, bytes: bytes)
+    }
+
+    /// Compact every live storage now, releasing empty atlas pages.
+    func compactAll() {
+        for case let storage? in storages.values.map(\.storage) {
+            storage.compactNow()
+        }
+    }
+
+    /// Stop holding storages no renderer uses; they are freed with their
+    /// atlas pages. Runs under memory pressure.
+    func releaseResident() {
+        resident.removeAll()
+        storages = storages.filter { $0.value.storage != nil }
+    }
+
+    /// The storage for `key`, created empty if no renderer holds one and it
+    /// is not resident.
+    func storage(for key: GlyphAtlasKey, device: MTLDevice) -> SharedGlyphStorage {
+        if let existing = storages[key]?.storage {
+            markResident(existing)
+            return existing
+        }
+        storages = storages.filter { $0.value.storage != nil }
+        let storage = SharedGlyphStorage(key: key, device: device, cacheCapacity: Self.cacheCapacity)
+        storages[key] = WeakStorage(storage: storage)
+        markResident(storage)
+        return storage
+    }
+
+    private func markResident(_ storage: SharedGlyphStorage) {
+        guard residentLimit > 0 else { return }
+        resident.removeAll { $0 === storage }
+        resident.insert(storage, at: 0)
+        if resident.count > residentLimit {
+            resident.removeLast(resident.count - residentLimit)
+        }
+    }
+}
@@ -4,6 +4,14 @@
 // LRU glyph cache for the Metal terminal renderer.
 // Maps GlyphKey (codepoint + style) to AtlasEntry (texture atlas location)
 // using a flat-slot LRU list + dictionary for O(1) lookup and O(1) eviction.
+//
+// Eviction is frequency-aware. Each entry counts its uses, and the counts
+// halve once per `maxCapacity` insertions so old popularity fades. The
+// victim is the least-used of the few entries nearest the LRU tail, so a
+// burst of one-off glyphs (scrolling past a page of CJK) evicts other
+// one-off glyphs rather than the working set. Pinned entries (the
+// pre-populated ASCII and box-drawing set in every variant) sit outside
+// the LRU list and are never evicted.
 
 import Foundation
 
@@ -56,8 +64,15 @@ final class GlyphCache {
         var prev: Int
         var next: Int
         var inUse: Bool
+        /// Uses since insertion, halved at each aging pass.
+        var uses: UInt16 = 0
+        /// Never evicted and not linked into the LRU list.
+        var pinned: Bool = false
     }
 
+    /// Entries nearest the LRU tail compared when choosing a victim.
+    static let evictionScanLimit = 8
+
     // MARK: - Properties
 
     /// Maximum number of entries before LRU eviction kicks in.
@@ -73,11 +88,23 @@ final class GlyphCache {
     private var headIndex: Int
     /// Least recently used slot index.
     private var tailIndex: Int
+    /// Insertions since use counts were last halved.
+    private var insertionsSinceAging = 0
+
+    /// Number of pinned entries.
+    private(set) var pinnedCount = 0
+
+    /// Entries evicted to make room since creation.
+    private(set) var evictionCount = 0
 
     /// Called when an entry is evicted from the cache (LRU overflow).
     /// The atlas uses this to reclaim the evicted glyph's region.
     var onEvict: ((AtlasEntry) -> Void)?
 
+    /// GPU mirror the shader resolves glyphs from. Kept in step with every
+    /// insert, eviction, removal and clear.
+    var table: GPUGlyphTable?
+
     // MARK: - Initialization
 
     /// Create a glyph cache with the specified maximum capacity.
@@ -113,7 +140,12 @@ final class GlyphCache {
     /// - Returns: The cached `AtlasEntry`, or `nil` if not present.
     func lookup(_ key: GlyphKey) -> AtlasEntry? {
         guard let index = map[key], slots[index].inUse else { return nil }
-        moveToHead(index)
+        if !slots[index].pinned {
+            if slots[index].uses < .max {
+                slots[index].uses += 1
+            }
+            moveToHead(index)
+        }
         return slots[index].entry
     }
 
@@ -126,27 +158,34 @@ final class GlyphCache {
     /// - Parameters:
     ///   - key: The glyph key.
     ///   - entry: The atlas entry describing the glyph's texture location.
-    func insert(_ key: GlyphKey, entry: AtlasEntry) {
+    ///   - pinned: Keep the entry out of eviction for good.
+    func insert(_ key: GlyphKey, entry: AtlasEntry, pinned: Bool = false) {
         if let existingIndex = map[key], slots[existingIndex].inUse {
             // Update existing entry and promote to MRU
             slots[existingIndex].entry = entry
-            moveToHead(existingIndex)
+            if !slots[existingIndex].pinned {
+                moveToHead(existingIndex)
+            }
+            table?.insert(key, value: GlyphIndexPacking.pack(entry))
+            if pinned {
+                pin(key)
+            }
             return
         }
 
-        // Evict exactly one LRU entry when at capacity, then reuse the slot.
-        if map.count >= maxCapacity, tailIndex != Self.noIndex {
-            let lruIndex = tailIndex
-            let evictedEntry = slots[lruIndex].entry
-            map.removeValue(forKey: slots[lruIndex].key)
-            onEvict?(evictedEntry)
-            detach(lruIndex)
-
-            slots[lruIndex].key = key
-            slots[lruIndex].entry = entry
-            slots[lruIndex].inUse = true
-            addToHead(lruIndex)
-            map[key] = lruIndex
+        ageUseCountsIfNeeded()
+
+        // Evict exactly one entry when at capacity, then reuse the slot.
+        // With every entry pinned the cache grows past capacity instead.
+        if map.count >= maxCapacity, let victim = evictionCandidate(matching: nil) {
+            evict(victim)
+            slots[victim].key = key
+            slots[victim].entry = entry
+            slots[victim].inUse = true
+            slots[victim].uses = 0
+            link(victim, pinned: pinned)
+            map[key] = victim
+            table?.insert(key, value: GlyphIndexPacking.pack(entry))
             return
         }
 
@@ -158,6 +197,7 @@ final class GlyphCache {
             slots[index].prev = Self.noIndex
             slots[index].next = Self.noIndex
             slots[index].inUse = true
+            slots[index].uses = 0
         } else {
             index = slots.count
             slots.append(Slot(
@@ -169,8 +209,29 @@ final class GlyphCache {
             ))
         }
 
-        addToHead(index)
+        link(index, pinned: pinned)
         map[key] = index
+        table?.insert(key, value: GlyphIndexPacking.pack(entry))
+    }
+
+    /// Exempt `key` from eviction. No effect if it is not cached.
+    func pin(_ key: GlyphKey) {
+        guard let index = map[key], slots[index].inUse, !slots[index].pinned else { return }
+        detach(index)
+        slots[index].pinned = true
+        pinnedCount += 1
+    }
+
+    /// Evict the coldest unpinned entry whose atlas entry satisfies
+    /// `predicate`, so the atlas can reuse its slot. Used when an
+    /// allocation finds the atlas full. False if no entry qualifies.
+    @discardableResult
+    func evictColdest(where predicate: (AtlasEntry) -> Bool) -> Bool {
+        guard let victim = evictionCandidate(matching: predicate) else { return false }
+        evict(victim)
+        slots[victim].inUse = false
+        freeList.append(victim)
+        return true
     }
 
     /// Remove a specific entry from the cache.
@@ -181,7 +242,8 @@ final class GlyphCache {
     func remove(_ key: GlyphKey) -> AtlasEntry? {
         guard let index = map.removeValue(forKey: key), slots[index].inUse else { return nil }
         let entry = slots[index].entry
-        detach(index)
+        table?.remove(key)
+        unlink(index)
         slots[index].inUse = false
         freeList.append(index)
         return entry
@@ -191,13 +253,17 @@ final class GlyphCache {
     /// Typically called when the font changes and all cached glyphs become invalid.
     func clear() {
         map.removeAll(keepingCapacity: true)
+        table?.removeAll()
         headIndex = Self.noIndex
         tailIndex = Self.noIndex
         freeList.removeAll(keepingCapacity: true)
+        pinnedCount = 0
+        insertionsSinceAging = 0
 
         if !slots.isEmpty {
             for idx in slots.indices.reversed() {
                 slots[idx].inUse = false
+                slots[idx].pinned = false
                 slots[idx].prev = Self.noIndex
                 slots[idx].next = Self.noIndex
                 freeList.append(idx)
@@ -205,14 +271,38 @@ final class GlyphCache {
         }
     }
 
+    // MARK: - Relocation
+
+    /// Cached glyphs whose atlas entry is on `page`, for compaction.
+    func entries(onPage page: UInt8) -> [(key: GlyphKey, entry: AtlasEntry)] {
+        slots.compactMap { slot in
+            slot.inUse && slot.entry.atlasPage == page ? (slot.key, slot.entry) : nil
+        }
+    }
+
+    /// Point `key` at `entry` after its bitmap moved within the atlas.
+    /// Keeps its recency, use count and pin.
+    func relocate(_ key: GlyphKey, to entry: AtlasEntry) {
+        guard let index = map[key], slots[index].inUse else { return }
+        slots[index].entry = entry
+        table?.insert(key, value: GlyphIndexPacking.pack(entry))
+    }
+
     // MARK: - Pre-Population
 
+    /// The keys `prePopulateASCII` fills, in its order: printable ASCII and
+    /// then box drawing, in regular, bold and italic.
+    static let prePopulatedKeys: [GlyphKey] = [(false, false), (true, false), (false, true)].flatMap { style in
+        Array(0x20...0x7E).map { GlyphKey(codepoint: UInt32($0), bold: style.0, italic: style.1) }
+            + Array(0x2500...0x257F).map { GlyphKey(codepoint: UInt32($0), bold: style.0, italic: style.1) }
+    }
+
     /// Pre-populate the cache with printable ASCII glyphs (0x20 through 0x7E)
     /// across regular, bold, and italic variants.
     ///
     /// This ensures the most common terminal characters (95 codepoints x 3 styles
     /// = 285 entries) are immediately available without cache misses during
-    /// the first frame of rendering.
+    /// the first frame of rendering. Pre-populated entries are pinned.
     ///
     /// - Parameter rasterize: A closure that rasterizes a single glyph key and
     ///   returns its atlas entry, or `nil` if rasterization failed. The closure
@@ -236,7 +326,7 @@ final class GlyphCache {
                 guard map[key] == nil else { continue }
 
                 if let entry = rasterize(key) {
-                    insert(key, entry: entry)
+                    insert(key, entry: entry, pinned: true)
                 }
             }
 
@@ -246,7 +336,7 @@ final class GlyphCache {
                 let key = GlyphKey(codepoint: codepoint, bold: style.bold, italic: style.italic)
                 guard map[key] == nil else { continue }
                 if let entry = rasterize(key) {
-                    insert(key, entry: entry)
+                    insert(key, entry: entry, pinned: true)
                 }
             }
         }
@@ -275,7 +365,7 @@ final class GlyphCache {
                 guard map[key] == nil else { continue }
 
                 if let entry = await rasterize(key) {
-                    insert(key, entry: entry)
+                    insert(key, entry: entry, pinned: true)
                 }
             }
 
@@ -284,7 +374,7 @@ final class GlyphCache {
                 let key = GlyphKey(codepoint: codepoint, bold: style.bold, italic: style.italic)
                 guard map[key] == nil else { continue }
                 if let entry = await rasterize(key) {
-                    insert(key, entry: entry)
+                    insert(key, entry: entry, pinned: true)
                 }
             }
         }
@@ -326,6 +416,66 @@ final class GlyphCache {
 
     // MARK: - Private Helpers
 
+    /// The slot to evict: the least-used of the first `evictionScanLimit`
+    /// unpinned entries from the LRU tail that satisfy `predicate`, the
+    /// least recent winning ties.
+    private func evictionCandidate(matching predicate: ((AtlasEntry) -> Bool)?) -> Int? {
+        var best: Int?
+        var scanned = 0
+        var index = tailIndex
+        while index != Self.noIndex, scanned < Self.evictionScanLimit {
+            if predicate?(slots[index].entry) ?? true {
+                if best == nil || slots[index].uses < slots[best!].uses {
+                    best = index
+                }
+                scanned += 1
+            }
+            index = slots[index].prev
+        }
+        return best
+    }
+
+    /// Drop `index`'s mapping and hand its atlas region back. The slot is
+    /// left for the caller to reuse or free.
+    private func evict(_ index: Int) {
+        let evictedEntry = slots[index].entry
+        map.removeValue(forKey: slots[index].key)
+        table?.remove(slots[index].key)
+        detach(index)
+        evictionCount += 1
+        onEvict?(evictedEntry)
+    }
+
+    /// Halve every use count once per `maxCapacity` insertions.
+    private func ageUseCountsIfNeeded() {
+        insertionsSinceAging += 1
+        guard insertionsSinceAging >= maxCapacity else { return }
+        insertionsSinceAging = 0
+        for index in slots.indices where slots[index].inUse {
+            slots[index].uses >>= 1
+        }
+    }
+
+    /// Add a freshly filled slot to the LRU list, or pin it.
+    private func link(_ index: Int, pinned: Bool) {
+        slots[index].pinned = pinned
+        if pinned {
+            pinnedCount += 1
+        } else {
+            addToHead(index)
+        }
+    }
+
+    /// Take a slot out of the LRU list, or unpin it.
+    private func unlink(_ index: Int) {
+        if slots[index].pinned {
+            slots[index].pinned = false
+            pinnedCount -= 1
+        } else {
+            detach(index)
+        }
+    }
+
     /// Add a slot to the MRU position.
     private func addToHead(_ index: Int) {
         slots[index].prev = Self.noIndex
@@ -0,0 +1,221 @@
+// GlyphDiskCache.swift
+// ProSSHV2
+//
+// On-disk copy of the pre-populated glyph set (printable ASCII and box
+// drawing in regular, bold and italic). The first launch at a given font,
+// size, backing scale and cell size rasterizes those ~670 glyphs through
+// CoreText as before and writes the bitmaps here; later launches map the
+// file and upload straight to the atlas, skipping rasterization.
+//
+// Only the bitmaps are stored, not whole atlas pages: a pre-populated page
+// is mostly empty, and atlas slot placement depends on what else the
+// shared storage already holds. Text glyphs are stored as one coverage
+// byte per pixel, matching the atlas's R8 pages; colour glyphs as BGRA.
+//
+// Files live in Caches/ProSSHV2/GlyphCache. The name hashes everything
+// that affects rasterization plus `GlyphRasterizer.outputVersion`, so a
+// rasterizer change simply misses, and stale files are pruned by age.
+
+import CryptoKit
+import Foundation
+import os.log
+
+// MARK: - GlyphDiskCache
+
+struct GlyphDiskCache {
+
+    /// One stored glyph. Pixels are at `pixelOffset` in the mapped file.
+    struct Glyph: Equatable {
+        let key: GlyphKey
+        let width: Int
+        let height: Int
+        let bearingX: Int8
+        let bearingY: Int8
+        let isColor: Bool
+        let pixelOffset: Int
+
+        var pixelByteCount: Int { width * height * (isColor ? 4 : 1) }
+    }
+
+    /// A decoded file. `data` is memory-mapped when read from disk.
+    struct Contents {
+        let data: Data
+        let glyphs: [Glyph]
+
+        /// Call `body` with a pointer to `glyph`'s pixels inside `data`.
+        func withPixels<R>(of glyph: Glyph, _ body: (UnsafeRawPointer) -> R) -> R? {
+            data.withUnsafeBytes { raw -> R? in
+                guard let base = raw.baseAddress,
+                      glyph.pixelOffset + glyph.pixelByteCount <= raw.count else { return nil }
+                return body(base + glyph.pixelOffset)
+            }
+        }
+    }
+
+    static let `default` = GlyphDiskCache(
+        directory: (FileManager.default.urls(for: .cachesDirectory, in: .userDomainMask).first
+            ?? FileManager.default.temporaryDirectory)
+            .appendingPathComponent("ProSSHV2", isDirectory: true)
+            .appendingPathComponent("GlyphCache", isDirectory: true)
+    )
+
+    /// Files kept in the directory; older ones are removed on store.
+    nonisolated static let maxFileCount = 16
+
+    private static let magic: UInt32 = 0x4347_5350 // "PSGC"
+    private static let headerSize = 12
+    private static let recordSize = 12
+    private nonisolated static let logger = Logger(subsystem: "com.prossh", category: "GlyphDiskCache")
+
+    let directory: URL
+
+    // MARK: - Lookup
+
+    /// File for `key`. The device is left out: bitmaps do not depend on it.
+    func fileURL(for key: GlyphAtlasKey) -> URL {
+        let identity = [
+            "v\(GlyphRasterizer.outputVersion)",
+            key.fontName,
+            String(format: "%.3f", Double(key.fontSize)),
+            String(format: "%.3f", Double(key.scale)),
+            "\(key.cellWidth)x\(key.cellHeight)",
+        ].joined(separator: "|")
+        let digest = SHA256.hash(data: Data(identity.utf8))
+        let name = digest.prefix(12).map { String(format: "%02x", $0) }.joined()
+        return directory.appendingPathComponent("\(name).glyphs", isDirectory: false)
+    }
+
+    /// Map and decode the file for `key`. A file that fails to decode is
+    /// removed so the next store replaces it.
+    func load(_ key: GlyphAtlasKey) -> Contents? {
+        let url = fileURL(for: key)
+        guard let data = try? Data(contentsOf: url, options: .alwaysMapped) else { return nil }
+        guard let glyphs = Self.decode(data) else {
+            Self.logger.error("Discarding unreadable glyph cache \(url.lastPathComponent, privacy: .public)")
+            try? FileManager.default.removeItem(at: url)
+            return nil
+        }
+        return Contents(data: data, glyphs: glyphs)
+    }
+
+    // MARK: - Store
+
+    /// Encode `glyphs` and write them for `key` off the main thread.
+    func store(_ glyphs: [(key: GlyphKey, glyph: RasterizedGlyph)], for key: GlyphAtlasKey) {
+        guard !glyphs.isEmpty else { return }
+        let data = Self.encode(glyphs)
+        let url = fileURL(for: key)
+        let directory = directory
+        Task.detached(priority: .utility) {
+            Self.write(data, to: url, in: directory)
+        }
+    }
+
+    private nonisolated static func write(_ data: Data, to url: URL, in directory: URL) {
+        let fileManager = FileManager.default
+        do {
+            try fileManager.createDirectory(at: directory, withIntermediateDirectories: true)
+            try data.write(to: url, options: .atomic)
+        } catch {
+            logger.error("Glyph cache write failed: \(error.localizedDescription, privacy: .public)")
+            return
+        }
+
+        // Prune the oldest files beyond the limit.
+        let files = (try? fileManager.contentsOfDirectory(
+            at: directory,
+            includingPropertiesForKeys: [.contentModificationDateKey]
+        ))?.filter { $0.pathExtension == "glyphs" } ?? []
+        guard files.count > maxFileCount else { return }
+        let dated = files.map { file in
+            (file, (try? file.resourceValues(forKeys: [.contentModificationDateKey]))?.contentModificationDate ?? .distantPast)
+        }
+        for (file, _) in dated.sorted(by: { $0.1 < $1.1 }).prefix(files.count - maxFileCount) {
+            try? fileManager.removeItem(at: file)
+        }
+    }
+
+    // MARK: - Encoding
+
+    /// Layout (little-endian): magic, rasterizer version, glyph count, then
+    /// per glyph a 12-byte record — codepoint u32, flags u8 (bold, italic,
+    /// colour), bearingX i8, bearingY i8, pad, width u16, height u16 —
+    /// followed by its pixels.
+    static func encode(_ glyphs: [(key: GlyphKey, glyph: RasterizedGlyph)]) -> Data {
+        var bytes: [UInt8] = []
+        bytes.reserveCapacity(headerSize + glyphs.count * (recordSize + 256))
+        appendInteger(&bytes, magic)
+        appendInteger(&bytes, GlyphRasterizer.outputVersion)
+        appendInteger(&bytes, UInt32(glyphs.count))
+
+        for (key, glyph) in glyphs {
+            var flags: UInt8 = 0
+            if key.bold { flags |= 1 }
+            if key.italic { flags |= 2 }
+            if glyph.isColor { flags |= 4 }
+            appendInteger(&bytes, key.codepoint)
+            bytes.append(flags)
+            bytes.append(UInt8(bitPattern: Int8(clamping: glyph.bearingX)))
+            bytes.append(UInt8(bitPattern: Int8(clamping: glyph.bearingY)))
+            bytes.append(0)
+            appendInteger(&bytes, UInt16(clamping: glyph.width))
+            appendInteger(&bytes, UInt16(clamping: glyph.height))
+
+            if glyph.isColor {
+                bytes.append(contentsOf: glyph.pixelData)
+            } else {
+                // Premultiplied BGRA: alpha is byte 3 of each pixel.
+                var index = 3
+                while index < glyph.pixelData.count {
+                    bytes.append(glyph.pixelData[index])
+                    index += 4
+                }
+            }
+        }
+        return Data(bytes)
+    }
+
+    /// Glyph records in `data`, or nil if it is not a complete file written
+    /// by this rasterizer version.
+    static func decode(_ data: Data) -> [Glyph]? {
+        data.withUnsafeBytes { raw -> [Glyph]? in
+            guard raw.count >= headerSize else { return nil }
+            func integer<T: FixedWidthInteger>(_ offset: Int, as type: T.Type) -> T {
+                T(littleEndian: raw.loadUnaligned(fromByteOffset: offset, as: T.self))
+            }
+            guard integer(0, as: UInt32.self) == magic,
+                  integer(4, as: UInt32.self) == GlyphRasterizer.outputVersion else { return nil }
+
+            let count = Int(integer(8, as: UInt32.self))
+            var glyphs: [Glyph] = []
+            glyphs.reserveCapacity(count)
+            var offset = headerSize
+            for _ in 0..<count {
+                guard offset + recordSize <= raw.count else { return nil }
+                let flags = raw[offset + 4]
+                let glyph = Glyph(
+                    key: GlyphKey(
+                        codepoint: integer(offset, as: UInt32.self),
+                        bold: flags & 1 != 0,
+                        italic: flags & 2 != 0
+                    ),
+                    width: Int(integer(offset + 8, as: UInt16.self)),
+                    height: Int(integer(offset + 10, as: UInt16.self)),
+                    bearingX: Int8(bitPattern: raw[offset + 5]),
+                    bearingY: Int8(bitPattern: raw[offset + 6]),
+                    isColor: flags & 4 != 0,
+                    pixelOffset: offset + recordSize
+                )
+                offset = glyph.pixelOffset + glyph.pixelByteCount
+                guard offset <= raw.count else { return nil }
+                glyphs.append(glyph)
+            }
+            return offset == raw.count ? glyphs : nil
+        }
+    }
+
+    @inline(__always)
+    private static func appendInteger<T: FixedWidthInteger>(_ bytes: inout [UInt8], _ value: T) {
+        withUnsafeBytes(of: value.littleEndian) { bytes.append(contentsOf: $0) }
+    }
+}
@@ -0,0 +1,128 @@
+// GlyphRasterPool.swift
+// ProSSHV2
+//
+// Parallel background rasterization for glyph cache misses. A cold page of
+// CJK or emoji can miss hundreds of glyphs at once; instead of one task
+// working through them on a single core, the keys are sharded across
+// workers, each with its own GlyphRasterizer (scratch buffer and CGContext
+// are not thread-safe), and every worker hands back small batches as they
+// finish so the renderer can upload and redraw incrementally.
+//
+// Rasterizers are kept between runs and shared by all renderers; a
+// renderer that starts a run while another is in flight simply gets fresh
+// ones.
+
+import Foundation
+
+// MARK: - GlyphRasterPool
+
+nonisolated final class GlyphRasterPool: @unchecked Sendable {
+
+    typealias Batch = [(key: GlyphKey, glyph: RasterizedGlyph)]
+
+    static let shared = GlyphRasterPool()
+
+    /// Glyphs per streamed batch. Small enough that the first glyphs of a
+    /// cold page appear within a frame or two, large enough that the main
+    /// thread is not woken per glyph.
+    static let batchSize = 16
+
+    /// Upper bound on concurrent workers per run.
+    let workerCount: Int
+
+    private let lock = NSLock()
+    private var idle: [GlyphRasterizer] = []
+
+    /// Defaults to one worker per core beyond the one driving the UI,
+    /// capped so a large machine does not flood the cooperative pool.
+    init(workerCount: Int = min(max(ProcessInfo.processInfo.activeProcessorCount - 1, 1), 8)) {
+        self.workerCount = max(workerCount, 1)
+    }
+
+    // MARK: - Rasterization
+
+    /// Rasterize `keys` across up to `workerCount` workers. `onBatch` is
+    /// called from worker threads with each completed batch; glyphs that
+    /// render empty are left out. Returns when every worker has finished or
+    /// the calling task is cancelled.
+    func rasterize(
+        _ keys: [GlyphKey],
+        cellWidth: Int,
+        cellHeight: Int,
+        fontSet: RasterFontSet,
+        onBatch: @escaping @Sendable (Batch) -> Void
+    ) async {
+        let shards = Self.shard(keys, workerCount: workerCount, batchSize: Self.batchSize)
+        await withTaskGroup(of: Void.self) { group in
+            for shard in shards {
+                group.addTask {
+                    self.run(shard, cellWidth: cellWidth, cellHeight: cellHeight, fontSet: fontSet, onBatch: onBatch)
+                }
+            }
+        }
+    }
+
+    private func run(
+        _ keys: [GlyphKey],
+        cellWidth: Int,
+        cellHeight: Int,
+        fontSet: RasterFontSet,
+        onBatch: (Batch) -> Void
+    ) {
+        let rasterizer = checkOut()
+        defer { checkIn(rasterizer) }
+
+        var batch: Batch = []
+        batch.reserveCapacity(Self.batchSize)
+        var batchStart = TraceRecorder.shared.begin()
+        for key in keys {
+            if Task.isCancelled { return }
+            if let glyph = MetalTerminalRenderer.rasterizeGlyphForBackground(
+                key: key, cellWidth: cellWidth, cellHeight: cellHeight,
+                fontSet: fontSet,
+                rasterizer: rasterizer
+            ) {
+                batch.append((key, glyph))
+            }
+            if batch.count >= Self.batchSize {
+                TraceRecorder.shared.end(.glyphRasterBatch, since: batchStart, value: Int64(batch.count))
+                onBatch(batch)
+                batch.removeAll(keepingCapacity: true)
+                batchStart = TraceRecorder.shared.begin()
+            }
+        }
+        if !batch.isEmpty, !Task.isCancelled {
+            TraceRecorder.shared.end(.glyphRasterBatch, since: batchStart, value: Int64(batch.count))
+            onBatch(batch)
+        }
+    }
+
+    /// Split `keys` round-robin into at most `workerCount` shards, using no
+    /// more shards than there are batches' worth of keys.
+    static func shard(_ keys: [GlyphKey], workerCount: Int, batchSize: Int) -> [[GlyphKey]] {
+        guard !keys.isEmpty else { return [] }
+        let batches = (keys.count + batchSize - 1) / batchSize
+        let count = max(min(workerCount, batches), 1)
+        var shards = [[GlyphKey]](repeating: [], count: count)
+        for (index, key) in keys.enumerated() {
+            shards[index % count].append(key)
+        }
+        return shards
+    }
+
+    // MARK: - Rasterizers
+
+    private func checkOut() -> GlyphRasterizer {
+        lock.lock()
+        defer { lock.unlock() }
+        return idle.popLast() ?? GlyphRasterizer()
+    }
+
+    private func checkIn(_ rasterizer: GlyphRasterizer) {
+        lock.lock()
+        defer { lock.unlock() }
+        if idle.count < workerCount {
+            idle.append(rasterizer)
+        }
+    }
+}
@@ -23,7 +23,8 @@ import Foundation
 /// needed by GlyphAtlas to place the glyph into the texture atlas.
 struct RasterizedGlyph: Sendable {
     /// Raw pixel data in BGRA premultiplied alpha format (4 bytes per pixel).
-    /// Both text and color emoji use the same BGRA layout (`.bgra8Unorm` atlas).
+    /// Color emoji are uploaded as is; for text only the alpha channel goes
+    /// to the atlas's `.r8Unorm` coverage pages.
     let pixelData: [UInt8]
 
     /// Width of the rasterized bitmap in pixels.
@@ -71,6 +72,10 @@ struct RasterizedGlyph: Sendable {
 final class GlyphRasterizer: @unchecked Sendable {
     private nonisolated static let deviceRGBColorSpace = CGColorSpaceCreateDeviceRGB()
 
+    /// Bump whenever rasterized output changes (metrics, antialiasing,
+    /// padding) so glyph bitmaps cached on disk are not reused.
+    nonisolated static let outputVersion: UInt32 = 1
+
     // MARK: - Scratch Buffer State
 
     private nonisolated(unsafe) var scratchBuffer: UnsafeMutableRawPointer?
@@ -116,7 +121,8 @@ final class GlyphRasterizer: @unchecked Sendable {
         scratchBufferSize = bufferSize
 
         let colorSpace = Self.deviceRGBColorSpace
-        // Unified BGRA format for both text and color emoji — matches .bgra8Unorm atlas
+        // Unified BGRA format for both text and color emoji; the atlas keeps
+        // only alpha for text glyphs
         let bitmapInfo: UInt32 = CGBitmapInfo.byteOrder32Little.rawValue
             | CGImageAlphaInfo.premultipliedFirst.rawValue
 
@@ -571,6 +577,86 @@ final class GlyphRasterizer: @unchecked Sendable {
         }
     }
 
+    // MARK: - Shaped Run Rasterization
+
+    /// Rasterize a shaped line spanning `cellCount` cells and slice it into
+    /// one cell-sized tile per cell, left to right. The line is squeezed or
+    /// stretched horizontally when its advance does not match the span
+    /// (fallback fonts for complex scripts are rarely monospaced). Tiles
+    /// without coverage are nil.
+    nonisolated func rasterize(
+        shapedLine line: CTLine,
+        font: CTFont,
+        cellCount: Int,
+        cellWidth: Int,
+        cellHeight: Int
+    ) -> [RasterizedGlyph?] {
+        let rasterWidth = cellWidth * cellCount
+        guard cellCount > 0, cellWidth > 0, cellHeight > 0,
+              let context = ensureScratchBuffer(width: rasterWidth, height: cellHeight),
+              let buffer = scratchBuffer else {
+            return []
+        }
+
+        let fontAscent = CTFontGetAscent(font)
+        let fontDescent = CTFontGetDescent(font)
+        let fontHeight = fontAscent + fontDescent
+        let penY = fontHeight > 0
+            ? (CGFloat(cellHeight) - fontHeight) / 2.0 + fontDescent
+            : fontDescent
+
+        context.setAllowsAntialiasing(true)
+        context.setShouldAntialias(true)
+        context.setFillColor(CGColor(red: 1.0, green: 1.0, blue: 1.0, alpha: 1.0))
+        context.setShouldSmoothFonts(true)
+        context.setShouldSubpixelPositionFonts(true)
+        context.setShouldSubpixelQuantizeFonts(false)
+
+        let lineWidth = CGFloat(CTLineGetTypographicBounds(line, nil, nil, nil))
+        context.saveGState()
+        if lineWidth > 0, abs(lineWidth - CGFloat(rasterWidth)) > 0.5 {
+            context.scaleBy(x: CGFloat(rasterWidth) / lineWidth, y: 1)
+        }
+        context.textPosition = CGPoint(x: 0, y: penY)
+        CTLineDraw(line, context)
+        context.restoreGState()
+
+        let bytesPerPixel = 4
+        let sourceRowBytes = rasterWidth * bytesPerPixel
+        let tileRowBytes = cellWidth * bytesPerPixel
+        let source = buffer.assumingMemoryBound(to: UInt8.self)
+        var tiles: [RasterizedGlyph?] = []
+        tiles.reserveCapacity(cellCount)
+        for cell in 0..<cellCount {
+            var covered = false
+            let pixelData = [UInt8](unsafeUninitializedCapacity: tileRowBytes * cellHeight) { dest, initializedCount in
+                for y in 0..<cellHeight {
+                    let rowStart = source + y * sourceRowBytes + cell * tileRowBytes
+                    memcpy(dest.baseAddress! + y * tileRowBytes, rowStart, tileRowBytes)
+                    // Alpha is the last byte of each little-endian BGRA pixel.
+                    if !covered {
+                        var offset = 3
+                        while offset < tileRowBytes {
+                            if rowStart[offset] != 0 { covered = true; break }
+                            offset += bytesPerPixel
+                        }
+                    }
+                }
+                initializedCount = tileRowBytes * cellHeight
+            }
+            tiles.append(covered ? RasterizedGlyph(
+                pixelData: pixelData,
+                width: cellWidth,
+                height: cellHeight,
+                bearingX: 0,
+                bearingY: 0,
+                isColor: false,
+                isWide: false
+            ) : nil)
+        }
+        return tiles
+    }
+
     // MARK: - Grapheme Cluster Rasterization
 
     /// Rasterize a full grapheme cluster (which may contain multiple codepoints)
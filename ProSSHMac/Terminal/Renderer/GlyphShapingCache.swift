@@ -0,0 +1,282 @@
+// GlyphShapingCache.swift
+// ProSSHV2
+//
+// Optional run-level text shaping. The atlas holds one glyph per codepoint,
+// so programming ligatures (Fira Code, JetBrains Mono) and scripts that
+// need contextual forms (Arabic, Devanagari) drew as isolated characters.
+//
+// With shaping on, the renderer splits each changed row into runs of
+// printable single-width cells with the same bold/italic style. Each run
+// is shaped once through CTLine. If shaping leaves every glyph the same as
+// the per-codepoint path would draw, the run is cached as plain. If not,
+// the line is rasterized across the run's cells and sliced into
+// cell-sized tiles. Each tile gets a synthetic codepoint above U+10FFFF
+// and goes into the shared atlas like any other glyph. The renderer then
+// writes those codepoints into the snapshot's cells, so the vertex shader
+// resolves them through GPUGlyphTable unchanged.
+//
+// Runs are cached by (text, style); the font is implied because there is
+// one cache per SharedGlyphStorage. A run seen before costs one dictionary
+// lookup. Rows the snapshot did not damage keep their substitutions from
+// the previous pass.
+//
+// Toggle via: `defaults write com.prossh terminal.renderer.ligatures -bool true`
+
+import CoreText
+import Foundation
+
+// MARK: - ShapingCell
+
+/// The parts of a cell that decide how it shapes.
+nonisolated struct ShapingCell: Equatable, Sendable {
+    /// Style bits of shapeable cells: bold and italic.
+    static let boldStyle: UInt8 = 1 << 1
+    static let italicStyle: UInt8 = 1 << 0
+    /// Style of a cell that ends a run (blank, wide, emoji, box drawing...).
+    static let breakStyle: UInt8 = 0xFF
+
+    var codepoint: UInt32
+    var style: UInt8
+
+    static let runBreak = ShapingCell(codepoint: 0, style: breakStyle)
+}
+
+// MARK: - ShapingRunKey
+
+/// A run's text and style; the cache key.
+nonisolated struct ShapingRunKey: Hashable, Sendable {
+    let scalars: [UInt32]
+    let style: UInt8
+
+    var bold: Bool { style & ShapingCell.boldStyle != 0 }
+    var italic: Bool { style & ShapingCell.italicStyle != 0 }
+}
+
+// MARK: - GlyphShapingCache
+
+final class GlyphShapingCache {
+
+    /// What shaping a run produced.
+    enum Entry: Equatable {
+        /// Shaping changed nothing; the cells draw through the normal path.
+        case plain
+        /// One codepoint per cell, left to right: a synthetic tile
+        /// codepoint, or 0 where the shaped line left the cell empty.
+        case shaped([UInt32])
+    }
+
+    static let enabledDefaultsKey = "terminal.renderer.ligatures"
+
+    /// First synthetic codepoint, just past the Unicode range.
+    nonisolated static let firstSyntheticCodepoint: UInt32 = 0x11_0000
+    /// One past the last synthetic codepoint. `GPUGlyphTable.packKey`
+    /// shifts codepoints left by two, and the result must stay below the
+    /// table's tombstone and empty keys.
+    nonisolated static let syntheticCodepointLimit: UInt32 = 0x3FFF_FFF0
+
+    /// Longest run shaped as one line; longer runs are split.
+    nonisolated static let maxRunLength = 64
+
+    /// Cached runs before the cache starts over.
+    let maxEntries: Int
+
+    /// Bumped whenever cached runs are dropped. Renderers reshape every row
+    /// on their next snapshot, since their substitutions may name tiles the
+    /// cache can no longer restore.
+    private(set) var generation: UInt64 = 0
+
+    private(set) var hits = 0
+    private(set) var misses = 0
+
+    private var entries: [ShapingRunKey: Entry] = [:]
+    /// Run and cell each live synthetic codepoint was allocated for.
+    private var tileSources: [UInt32: (key: ShapingRunKey, cell: Int)] = [:]
+    private var nextCodepoint = GlyphShapingCache.firstSyntheticCodepoint
+
+    init(maxEntries: Int = 16_384) {
+        self.maxEntries = max(maxEntries, 1)
+    }
+
+    var count: Int { entries.count }
+
+    nonisolated static func isSynthetic(_ codepoint: UInt32) -> Bool {
+        codepoint >= firstSyntheticCodepoint && codepoint < syntheticCodepointLimit
+    }
+
+    // MARK: - Lookup
+
+    /// The cached result for `key`, counting a hit or a miss.
+    func lookup(_ key: ShapingRunKey) -> Entry? {
+        let entry = entries[key]
+        if entry == nil { misses += 1 } else { hits += 1 }
+        return entry
+    }
+
+    /// The run and cell index `codepoint` was allocated for, if it is
+    /// still cached. Used to re-rasterize an evicted tile.
+    func source(of codepoint: UInt32) -> (key: ShapingRunKey, cell: Int, entry: Entry)? {
+        guard let source = tileSources[codepoint], let entry = entries[source.key] else { return nil }
+        return (source.key, source.cell, entry)
+    }
+
+    // MARK: - Insertion
+
+    /// Record that shaping `key` changes nothing.
+    func storePlain(_ key: ShapingRunKey) {
+        makeRoom()
+        entries[key] = .plain
+    }
+
+    /// Allocate tile codepoints for a shaped run and cache them. `coverage`
+    /// has one element per cell; cells without coverage get 0.
+    func storeShaped(_ key: ShapingRunKey, coverage: [Bool]) -> [UInt32] {
+        makeRoom()
+        let tileCount = coverage.lazy.filter { $0 }.count
+        if UInt64(nextCodepoint) + UInt64(tileCount) > UInt64(Self.syntheticCodepointLimit) {
+            removeAll()
+        }
+        var codepoints: [UInt32] = []
+        codepoints.reserveCapacity(coverage.count)
+        for (cell, covered) in coverage.enumerated() {
+            guard covered else {
+                codepoints.append(0)
+                continue
+            }
+            let codepoint = nextCodepoint
+            nextCodepoint += 1
+            tileSources[codepoint] = (key, cell)
+            codepoints.append(codepoint)
+        }
+        entries[key] = .shaped(codepoints)
+        return codepoints
+    }
+
+    /// Drop every cached run. Tiles already in the atlas stay until the
+    /// glyph cache evicts them.
+    func removeAll() {
+        entries.removeAll()
+        tileSources.removeAll()
+        nextCodepoint = Self.firstSyntheticCodepoint
+        generation &+= 1
+    }
+
+    private func makeRoom() {
+        if entries.count >= maxEntries {
+            removeAll()
+        }
+    }
+
+    // MARK: - Run Segmentation
+
+    /// The shaping view of a cell, or `ShapingCell.runBreak` for cells the
+    /// per-codepoint path must keep drawing.
+    nonisolated static func shapingCell(codepoint: UInt32, attributes: UInt16) -> ShapingCell {
+        let breaking = CellAttributes.wideChar.rawValue | CellAttributes.wideContinuation.rawValue
+        guard attributes & breaking == 0, isShapeable(codepoint) else { return .runBreak }
+        var style: UInt8 = 0
+        if attributes & CellAttributes.bold.rawValue != 0 { style |= ShapingCell.boldStyle }
+        if attributes & CellAttributes.italic.rawValue != 0 { style |= ShapingCell.italicStyle }
+        return ShapingCell(codepoint: codepoint, style: style)
+    }
+
+    /// Whether `codepoint` may join a shaped run. Blanks, controls, box
+    /// drawing and block elements, emoji and private-use symbols (Powerline,
+    /// Nerd Font icons) keep their dedicated rasterization paths.
+    nonisolated static func isShapeable(_ codepoint: UInt32) -> Bool {
+        guard codepoint > 0x20, codepoint != 0x7F, codepoint < firstSyntheticCodepoint else { return false }
+        if codepoint >= 0x80 {
+            if (0x80...0xA0).contains(codepoint)
+                || (0x2500...0x259F).contains(codepoint)
+                || (0xE000...0xF8FF).contains(codepoint)
+                || codepoint >= 0xF0000
+                || UnicodeClassification.isEmojiCodepoint(codepoint) {
+                return false
+            }
+        }
+        return Unicode.Scalar(codepoint) != nil
+    }
+
+    /// Ranges of `cells` to shape: maximal stretches of shapeable cells with
+    /// one style, split at `maxRunLength`, at least two cells long.
+    nonisolated static func runs(in cells: [ShapingCell]) -> [Range<Int>] {
+        var runs: [Range<Int>] = []
+        var start = 0
+        while start < cells.count {
+            let style = cells[start].style
+            guard style != ShapingCell.breakStyle else {
+                start += 1
+                continue
+            }
+            var end = start + 1
+            while end < cells.count, end - start < maxRunLength, cells[end].style == style {
+                end += 1
+            }
+            if end - start >= 2 {
+                runs.append(start..<end)
+            }
+            start = end
+        }
+        return runs
+    }
+}
+
+// MARK: - GlyphShaper
+
+nonisolated enum GlyphShaper {
+
+    /// The CTLine for `scalars` in `font` when shaping draws something the
+    /// per-codepoint path would not: a ligature or contextual alternate, a
+    /// changed glyph count, or right-to-left text. Nil when the line is
+    /// glyph-for-glyph what the cells already draw.
+    static func shapedLine(for scalars: [UInt32], font: CTFont) -> CTLine? {
+        var text = String.UnicodeScalarView()
+        for value in scalars {
+            guard let scalar = Unicode.Scalar(value) else { return nil }
+            text.append(scalar)
+        }
+        let string = String(text)
+        let utf16 = Array(string.utf16)
+        let attributes: [NSAttributedString.Key: Any] = [
+            NSAttributedString.Key(kCTFontAttributeName as String): font,
+            NSAttributedString.Key(kCTForegroundColorFromContextAttributeName as String): true
+        ]
+        let line = CTLineCreateWithAttributedString(NSAttributedString(string: string, attributes: attributes))
+        guard let runs = CTLineGetGlyphRuns(line) as? [CTRun] else { return nil }
+
+        for run in runs {
+            if CTRunGetStatus(run).contains(.rightToLeft) {
+                return line
+            }
+            let range = CTRunGetStringRange(run)
+            let glyphCount = CTRunGetGlyphCount(run)
+            guard range.location >= 0, range.location + range.length <= utf16.count else { return line }
+
+            // CoreText substitutes fallback fonts per run (e.g. for Arabic).
+            let runAttributes = CTRunGetAttributes(run) as NSDictionary
+            let runFont: CTFont
+            if let value = runAttributes[kCTFontAttributeName as String] {
+                runFont = value as! CTFont
+            } else {
+                runFont = font
+            }
+
+            // Nominal glyphs: one per scalar; a surrogate pair's second slot is 0.
+            var nominal = [CGGlyph](repeating: 0, count: range.length)
+            let chars = Array(utf16[range.location..<(range.location + range.length)])
+            _ = CTFontGetGlyphsForCharacters(runFont, chars, &nominal, chars.count)
+            var expected: [CGGlyph] = []
+            expected.reserveCapacity(chars.count)
+            for (index, unit) in chars.enumerated() where !UTF16.isTrailSurrogate(unit) {
+                expected.append(nominal[index])
+            }
+
+            guard glyphCount == expected.count else { return line }
+            var glyphs = [CGGlyph](repeating: 0, count: glyphCount)
+            CTRunGetGlyphs(run, CFRange(location: 0, length: 0), &glyphs)
+            if glyphs != expected {
+                return line
+            }
+        }
+        return nil
+    }
+}
@@ -0,0 +1,150 @@
+// InlineImageTextureCache.swift
+// ProSSHV2
+//
+// GPU textures for inline images (see InlineImage.swift), shared by every
+// renderer in the process. Textures are keyed by device and by the content
+// of the payload, so an image printed again, or shown in a pane split from
+// the same session, is uploaded once. Textures are evicted least recently
+// drawn first once they pass `byteBudget`. The next frame that draws an
+// evicted image uploads it again from InlineImageStore.
+//
+// An image that is still decoding yields no texture. The cache then asks
+// the store to call back once it is decoded, and the renderer that asked
+// for it redraws. Images that failed to decode are remembered so they are
+// not looked up every frame.
+//
+// Like GlyphAtlasStore, everything here runs on the main actor.
+
+import Metal
+
+// MARK: - InlineImageTextureCache
+
+final class InlineImageTextureCache {
+
+    static let shared = InlineImageTextureCache()
+
+    /// Texture bytes across all devices above which the coldest are evicted.
+    static let byteBudget = 256 * 1024 * 1024
+
+    private struct Key: Hashable {
+        let deviceID: UInt64
+        let content: InlineImageStore.ContentKey
+    }
+
+    private struct Entry {
+        let texture: MTLTexture
+        let byteCount: Int
+        var lastUse: UInt64
+    }
+
+    private let store: InlineImageStore
+    private var textures: [Key: Entry] = [:]
+    /// Content of each image uploaded so far, so drawing it again skips
+    /// the store.
+    private var contentKeys: [InlineImageID: InlineImageStore.ContentKey] = [:]
+    private var decoding: Set<InlineImageID> = []
+    private var unavailable: Set<InlineImageID> = []
+    private var textureBytes = 0
+    private var useClock: UInt64 = 0
+
+    init(store: InlineImageStore = .shared) {
+        self.store = store
+    }
+
+    /// Bytes held in textures.
+    var byteCount: Int { textureBytes }
+
+    /// The texture for `id` on `device`, or nil while it decodes. In that
+    /// case `onReady` runs once it can be drawn.
+    func texture(
+        for id: InlineImageID,
+        device: MTLDevice,
+        onReady: @escaping @MainActor () -> Void
+    ) -> MTLTexture? {
+        if let content = contentKeys[id] {
+            let key = Key(deviceID: device.registryID, content: content)
+            if textures[key] != nil {
+                useClock += 1
+                textures[key]?.lastUse = useClock
+                return textures[key]?.texture
+            }
+        }
+        guard !unavailable.contains(id), !decoding.contains(id) else { return nil }
+
+        if let decoded = store.decoded(id) {
+            return upload(decoded, for: id, device: device)
+        }
+        decoding.insert(id)
+        store.whenDecoded(id) { [weak self] decoded in
+            Task { @MainActor in
+                guard let self else { return }
+                self.decoding.remove(id)
+                if decoded == nil {
+                    self.unavailable.insert(id)
+                } else {
+                    onReady()
+                }
+            }
+        }
+        return nil
+    }
+
+    /// Drop every texture; they upload again as images are drawn. Used
+    /// under memory pressure.
+    func removeAll() {
+        textures.removeAll()
+        contentKeys.removeAll()
+        textureBytes = 0
+    }
+
+    // MARK: - Private
+
+    private func upload(_ decoded: InlineImageStore.Decoded, for id: InlineImageID, device: MTLDevice) -> MTLTexture? {
+        let bitmap = decoded.bitmap
+        let key = Key(deviceID: device.registryID, content: decoded.key)
+        contentKeys[id] = decoded.key
+        if let existing = textures[key] {
+            return existing.texture
+        }
+        let descriptor = MTLTextureDescriptor.texture2DDescriptor(
+            pixelFormat: .bgra8Unorm,
+            width: bitmap.width,
+            height: bitmap.height,
+            mipmapped: false
+        )
+        descriptor.usage = .shaderRead
+        descriptor.storageMode = .shared
+        guard bitmap.width > 0, bitmap.height > 0,
+              let texture = device.makeTexture(descriptor: descriptor) else {
+            unavailable.insert(id)
+            return nil
+        }
+        texture.label = "InlineImageTexture"
+        bitmap.pixels.withUnsafeBytes { bytes in
+            guard let base = bytes.baseAddress else { return }
+            texture.replace(
+                region: MTLRegionMake2D(0, 0, bitmap.width, bitmap.height),
+                mipmapLevel: 0,
+                withBytes: base,
+                bytesPerRow: bitmap.bytesPerRow
+            )
+        }
+        useClock += 1
+        textures[key] = Entry(texture: texture, byteCount: bitmap.byteCount, lastUse: useClock)
+        textureBytes += bitmap.byteCount
+        evictOverBudget(keeping: key)
+        return texture
+    }
+
+    private func evictOverBudget(keeping kept: Key) {
+        guard textureBytes > Self.byteBudget else { return }
+        let oldestFirst = textures.sorted { $0.value.lastUse < $1.value.lastUse }
+        for (key, entry) in oldestFirst where textureBytes > Self.byteBudget && key != kept {
+            textures[key] = nil
+            textureBytes -= entry.byteCount
+        }
+        // Forget images whose content no longer has a texture anywhere.
+        let live = Set(textures.keys.map(\.content))
+        contentKeys = contentKeys.filter { live.contains($0.value) }
+    }
+}
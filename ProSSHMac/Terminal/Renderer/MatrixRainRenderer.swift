@@ -0,0 +1,223 @@
+// MatrixRainRenderer.swift
+// ProSSHV2
+//
+// GPU renderer for the idle Matrix screensaver. The SwiftUI Canvas version
+// re-resolved and drew one Text per visible trail cell on every frame. At
+// 5K with full density and 40-cell trails that kept a core busy while the
+// machine sat idle.
+//
+// Here a frame is one full-screen triangle and one uniform struct. The
+// fragment shader (`matrix_rain_fragment` in TerminalShaders.metal) finds
+// each pixel's cell and that column's stream: whether it has one, its
+// start offset and speed, all hashed from the column and a seed. It then
+// derives the stream's head row from the time uniform, as
+// `MatrixStream.headRow(at:)` does, and samples the cell's glyph. The
+// glyphs are rasterized once per character set and scale into a GlyphAtlas
+// coverage page, the same atlas the terminal renderer uses. The pipeline
+// comes from TerminalPipelineCache. CPU work per frame is setting the
+// uniforms, so the view can run at the display's full ProMotion rate.
+
+import AppKit
+import CoreText
+import Metal
+import MetalKit
+import QuartzCore
+
+// MARK: - MatrixRainUniforms
+
+/// Must match `MatrixRainUniforms` in TerminalShaders.metal.
+nonisolated struct MatrixRainUniforms {
+    var viewportSize: SIMD2<Float>
+    var cellSize: SIMD2<Float>
+    var time: Float
+    var speed: Float
+    var density: Float
+    var trailLength: UInt32
+    var glyphCount: UInt32
+    var seed: UInt32
+    var color: SIMD4<Float>
+}
+
+// MARK: - MatrixRainGlyphTable
+
+/// The character set's glyphs on one atlas coverage page, plus each glyph's
+/// texture rectangle (u0, v0, u1, v1) in character order.
+final class MatrixRainGlyphTable {
+    /// Rectangle for a glyph that did not rasterize; samples outside the
+    /// page, which reads as no coverage.
+    static let missingRect = SIMD4<Float>(repeating: -1)
+
+    let texture: MTLTexture
+    let rects: [SIMD4<Float>]
+    let rectBuffer: MTLBuffer
+    let scale: CGFloat
+
+    init?(
+        device: MTLDevice,
+        characters: [Character],
+        cellSize: CGSize,
+        scale: CGFloat,
+        fontSize: CGFloat = 14
+    ) {
+        let cellWidth = Int((cellSize.width * scale).rounded())
+        let cellHeight = Int((cellSize.height * scale).rounded())
+        guard cellWidth > 0, cellHeight > 0, !characters.isEmpty else { return nil }
+
+        let atlas = GlyphAtlas(device: device, cellWidth: cellWidth, cellHeight: cellHeight)
+        let rasterizer = GlyphRasterizer()
+        let font = NSFont.monospacedSystemFont(ofSize: fontSize * scale, weight: .medium) as CTFont
+        let pageSize = Float(atlas.pageSize)
+
+        var rects: [SIMD4<Float>] = []
+        rects.reserveCapacity(characters.count)
+        for character in characters {
+            guard let scalar = character.unicodeScalars.first else {
+                rects.append(Self.missingRect)
+                continue
+            }
+            let glyph = rasterizer.rasterize(codepoint: scalar, font: font, cellWidth: cellWidth, cellHeight: cellHeight)
+            let entry = glyph.pixelData.withUnsafeBytes { bytes in
+                bytes.baseAddress.flatMap {
+                    atlas.allocate(width: glyph.width, height: glyph.height, pixelData: $0)
+                }
+            }
+            // Everything the shader samples has to be on page 0.
+            guard let entry, entry.atlasPage == 0 else {
+                rects.append(Self.missingRect)
+                continue
+            }
+            rects.append(SIMD4<Float>(
+                Float(entry.x) / pageSize,
+                Float(entry.y) / pageSize,
+                Float(Int(entry.x) + glyph.width) / pageSize,
+                Float(Int(entry.y) + glyph.height) / pageSize
+            ))
+        }
+
+        guard let texture = atlas.texture(forPage: 0),
+              let rectBuffer = device.makeBuffer(
+                  bytes: rects,
+                  length: MemoryLayout<SIMD4<Float>>.stride * rects.count,
+                  options: .storageModeShared
+              ) else { return nil }
+        self.texture = texture
+        self.rects = rects
+        self.rectBuffer = rectBuffer
+        self.scale = scale
+    }
+}
+
+// MARK: - MatrixRainRenderer
+
+final class MatrixRainRenderer: NSObject, MTKViewDelegate {
+
+    static let cellSize = CGSize(width: MatrixStream.cellWidth, height: MatrixStream.cellHeight)
+
+    private let device: MTLDevice
+    private let commandQueue: MTLCommandQueue
+    private let pipeline: MTLRenderPipelineState
+    private var glyphTable: MatrixRainGlyphTable?
+    private(set) var config: MatrixScreensaverConfiguration
+    private let startTime = CACurrentMediaTime()
+    /// Picks which columns have streams and how they start, per showing.
+    private let seed = UInt32.random(in: .min ... .max)
+
+    /// Nil when there is no Metal device or the pipeline did not build;
+    /// the screensaver then draws with the Canvas.
+    init?(config: MatrixScreensaverConfiguration, device: MTLDevice? = MTLCreateSystemDefaultDevice()) {
+        guard let device,
+              let pipeline = try? TerminalPipelineCache.shared.pipelines(for: device).matrixRain,
+              let commandQueue = device.makeCommandQueue() else { return nil }
+        self.device = device
+        self.pipeline = pipeline
+        self.commandQueue = commandQueue
+        self.config = config
+        super.init()
+    }
+
+    func configureView(_ view: MTKView) {
+        view.device = device
+        view.colorPixelFormat = .bgra8Unorm
+        view.framebufferOnly = true
+        view.clearColor = MTLClearColor(red: 0, green: 0, blue: 0, alpha: 1)
+        view.enableSetNeedsDisplay = false
+        view.isPaused = false
+        view.preferredFramesPerSecond = view.window?.screen?.maximumFramesPerSecond
+            ?? NSScreen.main?.maximumFramesPerSecond
+            ?? 60
+        view.delegate = self
+    }
+
+    func update(config newConfig: MatrixScreensaverConfiguration) {
+        if newConfig.characterSet != config.characterSet {
+            glyphTable = nil
+        }
+        config = newConfig
+    }
+
+    // MARK: - MTKViewDelegate
+
+    func mtkView(_ view: MTKView, drawableSizeWillChange size: CGSize) {
+        if let screenFPS = view.window?.screen?.maximumFramesPerSecond,
+           view.preferredFramesPerSecond != screenFPS {
+            view.preferredFramesPerSecond = screenFPS
+        }
+    }
+
+    func draw(in view: MTKView) {
+        let drawableSize = view.drawableSize
+        guard drawableSize.width > 0, drawableSize.height > 0, view.bounds.width > 0,
+              let descriptor = view.currentRenderPassDescriptor,
+              let drawable = view.currentDrawable else { return }
+
+        let scale = drawableSize.width / view.bounds.width
+        if glyphTable?.scale != scale {
+            glyphTable = MatrixRainGlyphTable(
+                device: device,
+                characters: config.characterSet.characters,
+                cellSize: Self.cellSize,
+                scale: scale
+            )
+        }
+        guard let glyphTable,
+              let commandBuffer = commandQueue.makeCommandBuffer(),
+              let encoder = commandBuffer.makeRenderCommandEncoder(descriptor: descriptor) else { return }
+        encoder.label = "MatrixRainEncoder"
+
+        var uniforms = MatrixRainUniforms(
+            viewportSize: SIMD2(Float(drawableSize.width), Float(drawableSize.height)),
+            cellSize: SIMD2(Float(Self.cellSize.width * scale), Float(Self.cellSize.height * scale)),
+            time: Float(CACurrentMediaTime() - startTime),
+            speed: config.speed,
+            density: config.density,
+            trailLength: UInt32(max(1, config.trailLength)),
+            glyphCount: UInt32(glyphTable.rects.count),
+            seed: seed,
+            color: SIMD4(config.color.red, config.color.green, config.color.blue, 1)
+        )
+        encoder.setRenderPipelineState(pipeline)
+        encoder.setFragmentBytes(&uniforms, length: MemoryLayout<MatrixRainUniforms>.stride, index: 0)
+        encoder.setFragmentBuffer(glyphTable.rectBuffer, offset: 0, index: 1)
+        encoder.setFragmentTexture(glyphTable.texture, index: 0)
+        encoder.drawPrimitives(type: .triangle, vertexStart: 0, vertexCount: 3)
+        encoder.endEncoding()
+
+        commandBuffer.present(drawable)
+        commandBuffer.commit()
+    }
+}
+
+// MARK: - MatrixRainMetalView
+
+/// SwiftUI host for a MatrixRainRenderer.
+struct MatrixRainMetalView: NSViewRepresentable {
+    let renderer: MatrixRainRenderer
+
+    func makeNSView(context: Context) -> MTKView {
+        let view = MTKView(frame: .zero)
+        renderer.configureView(view)
+        return view
+    }
+
+    func updateNSView(_ nsView: MTKView, context: Context) {}
+}
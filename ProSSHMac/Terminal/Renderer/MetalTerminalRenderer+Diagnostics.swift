@@ -1,4 +1,6 @@
 // Extracted from MetalTerminalRenderer.swift
+import Metal
+import QuartzCore
 
 extension MetalTerminalRenderer {
 
@@ -24,8 +26,66 @@ extension MetalTerminalRenderer {
         glyphCache.count
     }
 
+    /// Returns atlas occupancy and eviction/compaction counters for the
+    /// shared glyph storage this renderer draws from.
+    var glyphStorageStats: SharedGlyphStorage.Stats {
+        glyphStorage.stats
+    }
+
+    /// Memory this pane holds on its own: the cell, expansion and draw-list
+    /// buffers, and the scene cache and phosphor history textures. Glyph
+    /// storage and same-sized effect targets are shared and reported by
+    /// `GlyphAtlasStore`.
+    var memoryFootprint: MemoryFootprint {
+        let textures = [sceneCacheTexture, previousFrameTexture]
+            .reduce(0) { $0 + ($1?.allocatedSize ?? 0) }
+        let bytes = cellBuffer.allocatedByteCount
+            + drawLists.allocatedByteCount
+            + (cellExpansion?.allocatedByteCount ?? 0)
+            + textures
+        return MemoryFootprint(.cellBuffers, bytes: bytes)
+    }
+
     /// Returns rolling renderer performance metrics.
     var performanceSnapshot: RendererPerformanceSnapshot {
         performanceMonitor.snapshot()
     }
+
+    // MARK: - Performance HUD
+
+    /// Show or hide the performance HUD from persisted settings.
+    func reloadPerformanceHUDSettings() {
+        let enabled = PerformanceHUDOverlay.loadEnabledFromDefaults() && performanceHUDPipeline != nil
+        guard enabled != (performanceHUD != nil) else { return }
+        performanceHUD = enabled ? PerformanceHUDOverlay(device: device) : nil
+        isDirty = true
+        requestFrame()
+    }
+
+    /// Whether the HUD text is stale, so an otherwise idle view still draws.
+    func isPerformanceHUDRefreshDue(at now: CFTimeInterval) -> Bool {
+        performanceHUD?.isRefreshDue(at: now) ?? false
+    }
+
+    /// Composite the HUD over the finished frame in `target`, refreshing its
+    /// text first when due. Returns the number of draw calls encoded.
+    func encodePerformanceHUDIfNeeded(commandBuffer: MTLCommandBuffer, target: MTLTexture, now: CFTimeInterval) -> Int {
+        guard let hud = performanceHUD, let pipeline = performanceHUDPipeline else { return 0 }
+        if hud.isRefreshDue(at: now) {
+            hud.refresh(
+                now: now,
+                stats: performanceHUDStatsProvider?(),
+                performance: performanceMonitor.snapshot(),
+                atlas: glyphAtlas.occupancy,
+                power: powerPolicy,
+                scale: screenScale
+            )
+            // Wake the view for the next refresh even when nothing else draws.
+            DispatchQueue.main.asyncAfter(deadline: .now() + PerformanceHUDOverlay.refreshInterval) { [weak self] in
+                guard let self, self.performanceHUD != nil else { return }
+                self.requestFrame()
+            }
+        }
+        return hud.encode(commandBuffer: commandBuffer, target: target, pipeline: pipeline, scale: screenScale)
+    }
 }
@@ -14,10 +14,18 @@ extension MetalTerminalRenderer {
     /// - Parameter view: The MTKView requesting a draw.
     func draw(in view: MTKView) {
         let frameNow = CACurrentMediaTime()
-        if pendingRenderSnapshot == nil, !isDirty, !requiresContinuousFrames() {
+        guard isRenderVisible else {
             view.isPaused = true
             return
         }
+        pullFeedSnapshot()
+        if pendingRenderSnapshot == nil, !isDirty, frameDamage.isEmpty, !requiresContinuousFrames(),
+           !isPerformanceHUDRefreshDue(at: frameNow) {
+            view.isPaused = true
+            return
+        }
+        let allocationScope = AllocationTracker.begin(.frame)
+        defer { allocationScope?.end() }
 
         if usesNativeRefreshRate {
             let targetFPS = max(60, currentScreenMaximumFPS())
@@ -27,6 +35,7 @@ extension MetalTerminalRenderer {
         }
 
         // Wait on in-flight semaphore before reusing cell buffers.
+        let waitStart = CACurrentMediaTime()
         _ = inflightSemaphore.wait(timeout: .distantFuture)
 
         // Get current drawable and render pass descriptor.
@@ -34,6 +43,7 @@ extension MetalTerminalRenderer {
             inflightSemaphore.signal()
             return
         }
+        performanceMonitor.recordDrawableWait(seconds: CACurrentMediaTime() - waitStart)
 
         guard let drawableRenderPassDescriptor = view.currentRenderPassDescriptor else {
             inflightSemaphore.signal()
@@ -50,7 +60,7 @@ extension MetalTerminalRenderer {
         #endif
 
         let drawableSize = view.drawableSize
-        let scannerActive = scannerConfiguration.isEnabled && isLocalSession
+        let scannerActive = scannerIsActive
         let usesPostProcessing = crtConfiguration.isEnabled
             || gradientConfiguration.isEnabled
             || solidBackgroundConfiguration.isEnabled
@@ -66,11 +76,26 @@ extension MetalTerminalRenderer {
 
         // Apply latest pending snapshot in a buffer-safe context.
         applyPendingSnapshotIfNeeded()
+        // A latency sample riding on that snapshot closes when this frame's
+        // command buffer completes.
+        let frameTrace = pendingLatencyTrace.map { trace -> PipelineTrace in
+            var uploaded = trace
+            uploaded.uploadedAt = CACurrentMediaTime()
+            return uploaded
+        }
+        pendingLatencyTrace = nil
         drainPendingGlyphKeysIfNeeded()
+        encodeCellExpansionIfNeeded(commandBuffer: commandBuffer)
+
+        // The in-flight semaphore guarantees this log's previous frame has
+        // completed and been drained.
+        let missLog = glyphMissLogs[glyphMissLogIndex]
+        glyphMissLogIndex = (glyphMissLogIndex + 1) % glyphMissLogs.count
 
         // Update uniforms for this frame via the TerminalUniformBuffer.
         let cursorFrame = cursorRenderer.frame(at: frameNow)
         let scrollFrame = smoothScrollEngine.frame(cellHeight: cellHeight * screenScale, time: frameNow)
+        let scrollRowBase = updateHistoryRingForFrame()
         let frameDelta = max(0, uniformBuffer.currentTime - previousUniformTime)
         let phosphorBlend = (postProcessingReady && hasCapturedPreviousFrame)
             ? CRTEffect.phosphorBlend(
@@ -85,12 +110,12 @@ extension MetalTerminalRenderer {
         uniformBuffer.update(
             cellSize: SIMD2<Float>(Float(cellWidth * screenScale), Float(cellHeight * screenScale)),
             viewportSize: SIMD2<Float>(Float(drawableSize.width), Float(drawableSize.height)),
-            atlasSize: SIMD2<Float>(Float(glyphAtlas.pageSize), Float(glyphAtlas.pageSize)),
+            atlasSize: SIMD2<Float>(Float(drawGlyphStorage.atlas.pageSize), Float(drawGlyphStorage.atlas.pageSize)),
             cursorRenderRow: cursorFrame.row,
             cursorRenderCol: cursorFrame.col,
             cursorStyle: cursorFrame.style,
             cursorVisible: cursorVisible,
-            cursorBlinkEnabled: cursorBlinkEnabled,
+            cursorBlinkEnabled: blinksCursor,
             cursorPhaseOverride: cursorFrame.phase,
             glowIntensity: cursorFrame.glowIntensity,
             selectionAlpha: selectionRenderer.selectionAlpha,
@@ -102,104 +127,212 @@ extension MetalTerminalRenderer {
             barrelDistortion: crtConfiguration.barrelDistortion,
             phosphorBlend: phosphorBlend,
             contentScale: Float(screenScale),
-            gradientConfig: gradientConfiguration,
+            gradientConfig: frameGradientConfiguration,
             solidBackgroundConfig: solidBackgroundConfiguration,
-            scannerConfig: scannerConfiguration,
+            scannerConfig: frameScannerConfiguration,
             bloomConfig: bloomConfiguration,
             isLocalSession: isLocalSession,
-            scrollOffsetPixels: scrollFrame.offsetPixels
+            scrollOffsetPixels: scrollFrame.offsetPixels,
+            scrollRowBase: scrollRowBase,
+            atlasCellSize: drawAtlasCellSize
         )
         previousUniformTime = uniformBuffer.currentTime
+        inlineImageScrollOffsetPixels = scrollFrame.offsetPixels
 
         let frameStart = frameNow
         let frameSignpostID = performanceMonitor.beginFrame()
         var drawCalls = 0
 
-        if postProcessingReady, let sceneTexture = postProcessTexture {
-            let sceneRenderPassDescriptor = makeSceneRenderPassDescriptor(
-                texture: sceneTexture,
-                clearColor: view.clearColor
-            )
+        // Whether the post-processing scene can differ from the last one;
+        // when it cannot, bloom reuses its cached halo and the post pass
+        // may reuse its whole output.
+        let sceneChanged = !frameDamage.isEmpty
+            || cursorFrame != lastSceneCursorFrame
+            || hasBlinkingCells
+            || scrollFrame.offsetPixels != 0
+
+        // Whether the text itself moved; the cursor alone does not
+        // refresh the thumbnail.
+        let contentChanged = !frameDamage.isEmpty || scrollFrame.offsetPixels != 0
+
+        // Rows changed since the last frame; nil means redraw everything.
+        frameDamage.add(cursorRow: cursorFrame.row)
+        let damagedRows = frameDamage.take(rowCount: cellBuffer.rows)
+
+        if postProcessingReady, let sceneTexture = postProcessTexture,
+           let postOutput = ensureSceneCacheTexture(matching: drawable.texture) {
+            // The post pass renders into the persistent frame texture, which
+            // is then copied to the drawable. When nothing the post pass reads
+            // has changed, the copy is all this frame costs.
+            sceneCacheIsCurrent = false
+            let reusesOutput = postOutputIsCurrent
+                && !sceneChanged
+                && !postProcessingDependsOnTime(scannerActive: scannerActive)
+                && !(phosphorBlend > 0.001 && lastPostSceneChanged)
+            postOutputIsCurrent = false
+
+            if !reusesOutput {
+                let sceneRenderPassDescriptor = makeSceneRenderPassDescriptor(
+                    texture: sceneTexture,
+                    clearColor: view.clearColor
+                )
+
+                guard let sceneEncoder = commandBuffer.makeRenderCommandEncoder(descriptor: sceneRenderPassDescriptor) else {
+                    inflightSemaphore.signal()
+                    return
+                }
+                sceneEncoder.label = "TerminalSceneEncoder"
+                drawCalls += encodeTerminalScenePass(sceneEncoder, drawableSize: drawableSize, missLog: missLog)
+                sceneEncoder.endEncoding()
+
+                lastSceneCursorFrame = cursorFrame
+
+                let bloomTexture = encodeBloom(
+                    commandBuffer: commandBuffer,
+                    sceneTexture: sceneTexture,
+                    sceneChanged: sceneChanged
+                )
+
+                let postRenderPassDescriptor = MTLRenderPassDescriptor()
+                postRenderPassDescriptor.colorAttachments[0].texture = postOutput
+                postRenderPassDescriptor.colorAttachments[0].loadAction = .dontCare
+                postRenderPassDescriptor.colorAttachments[0].storeAction = .store
+                guard let postEncoder = commandBuffer.makeRenderCommandEncoder(descriptor: postRenderPassDescriptor) else {
+                    inflightSemaphore.signal()
+                    return
+                }
+                postEncoder.label = "TerminalPostProcessEncoder"
+
+                let viewport = MTLViewport(
+                    originX: 0,
+                    originY: 0,
+                    width: Double(drawableSize.width),
+                    height: Double(drawableSize.height),
+                    znear: 0,
+                    zfar: 1
+                )
+                postEncoder.setViewport(viewport)
+
+                let scissorRect = MTLScissorRect(
+                    x: 0,
+                    y: 0,
+                    width: Int(drawableSize.width),
+                    height: Int(drawableSize.height)
+                )
+                postEncoder.setScissorRect(scissorRect)
+
+                postEncoder.setRenderPipelineState(postProcessPipelineState)
+                postEncoder.setFragmentBuffer(uniformBuffer.buffer, offset: 0, index: 1)
+                postEncoder.setFragmentTexture(sceneTexture, index: 0)
+                postEncoder.setFragmentTexture(previousFrameTexture ?? crtFallbackTexture, index: 1)
+                postEncoder.setFragmentTexture(bloomTexture ?? crtFallbackTexture, index: 2)
+                postEncoder.drawPrimitives(type: .triangle, vertexStart: 0, vertexCount: 3)
+                postEncoder.endEncoding()
+                drawCalls += 1
+
+                // Save scene output for phosphor history sampling on the next frame.
+                if let historyTexture = previousFrameTexture,
+                   let blitEncoder = commandBuffer.makeBlitCommandEncoder() {
+                    blitEncoder.label = "TerminalCRTFrameHistoryCopy"
+                    let copyWidth = min(sceneTexture.width, historyTexture.width)
+                    let copyHeight = min(sceneTexture.height, historyTexture.height)
+                    if copyWidth > 0, copyHeight > 0 {
+                        blitEncoder.copy(
+                            from: sceneTexture,
+                            sourceSlice: 0,
+                            sourceLevel: 0,
+                            sourceOrigin: MTLOrigin(x: 0, y: 0, z: 0),
+                            sourceSize: MTLSize(width: copyWidth, height: copyHeight, depth: 1),
+                            to: historyTexture,
+                            destinationSlice: 0,
+                            destinationLevel: 0,
+                            destinationOrigin: MTLOrigin(x: 0, y: 0, z: 0)
+                        )
+                        hasCapturedPreviousFrame = true
+                    }
+                    blitEncoder.endEncoding()
+                }
+                lastPostSceneChanged = sceneChanged
+            }
 
-            guard let sceneEncoder = commandBuffer.makeRenderCommandEncoder(descriptor: sceneRenderPassDescriptor) else {
+            guard let presentEncoder = commandBuffer.makeBlitCommandEncoder() else {
                 inflightSemaphore.signal()
                 return
             }
-            sceneEncoder.label = "TerminalSceneEncoder"
-            drawCalls += encodeTerminalScenePass(sceneEncoder, drawableSize: drawableSize)
-            sceneEncoder.endEncoding()
-
-            // Bloom bright-pass: extract luminant pixels → bloomBrightTexture (half-res)
-            encodeBrightPass(commandBuffer: commandBuffer, sceneTexture: sceneTexture)
-            // Bloom blur: H+V separable Gaussian → bloomBlurV (ready for Phase 4 composite)
-            encodeBlurPasses(commandBuffer: commandBuffer)
+            presentEncoder.label = "TerminalPostOutputPresent"
+            presentEncoder.copy(from: postOutput, to: drawable.texture)
+            presentEncoder.endEncoding()
+            postOutputIsCurrent = true
+        } else if !usesPostProcessing, let sceneCache = ensureSceneCacheTexture(matching: drawable.texture) {
+            lastSceneCursorFrame = nil
+            postOutputIsCurrent = false
+            // Redraw only the damaged rows into the persistent scene, then
+            // copy it to the drawable. Scrolling and blinking text move
+            // pixels outside the damage, so they redraw in full.
+            let partialRows = sceneCacheIsCurrent && scrollFrame.offsetPixels == 0 && !hasBlinkingCells
+                ? damagedRows
+                : nil
+            sceneCacheIsCurrent = false
+
+            if partialRows?.isEmpty != true {
+                let sceneRenderPassDescriptor = makeSceneRenderPassDescriptor(
+                    texture: sceneCache,
+                    clearColor: view.clearColor
+                )
+                if partialRows != nil {
+                    sceneRenderPassDescriptor.colorAttachments[0].loadAction = .load
+                }
+                guard let sceneEncoder = commandBuffer.makeRenderCommandEncoder(descriptor: sceneRenderPassDescriptor) else {
+                    inflightSemaphore.signal()
+                    return
+                }
+                sceneEncoder.label = "TerminalSceneCacheEncoder"
+                drawCalls += encodeTerminalScenePass(sceneEncoder, drawableSize: drawableSize, missLog: missLog, rows: partialRows)
+                sceneEncoder.endEncoding()
+            }
 
-            guard let postEncoder = commandBuffer.makeRenderCommandEncoder(descriptor: drawableRenderPassDescriptor) else {
+            guard let blitEncoder = commandBuffer.makeBlitCommandEncoder() else {
                 inflightSemaphore.signal()
                 return
             }
-            postEncoder.label = "TerminalPostProcessEncoder"
-
-            let viewport = MTLViewport(
-                originX: 0,
-                originY: 0,
-                width: Double(drawableSize.width),
-                height: Double(drawableSize.height),
-                znear: 0,
-                zfar: 1
-            )
-            postEncoder.setViewport(viewport)
-
-            let scissorRect = MTLScissorRect(
-                x: 0,
-                y: 0,
-                width: Int(drawableSize.width),
-                height: Int(drawableSize.height)
-            )
-            postEncoder.setScissorRect(scissorRect)
-
-            postEncoder.setRenderPipelineState(postProcessPipelineState)
-            postEncoder.setFragmentBuffer(uniformBuffer.buffer, offset: 0, index: 1)
-            postEncoder.setFragmentTexture(sceneTexture, index: 0)
-            postEncoder.setFragmentTexture(previousFrameTexture ?? crtFallbackTexture, index: 1)
-            let effectiveBloomTex = bloomConfiguration.isEnabled ? bloomBlurV : nil
-            postEncoder.setFragmentTexture(effectiveBloomTex ?? crtFallbackTexture, index: 2)
-            postEncoder.drawPrimitives(type: .triangle, vertexStart: 0, vertexCount: 3)
-            postEncoder.endEncoding()
-            drawCalls += 1
-
-            // Save scene output for phosphor history sampling on the next frame.
-            if let historyTexture = previousFrameTexture,
-               let blitEncoder = commandBuffer.makeBlitCommandEncoder() {
-                blitEncoder.label = "TerminalCRTFrameHistoryCopy"
-                let copyWidth = min(sceneTexture.width, historyTexture.width)
-                let copyHeight = min(sceneTexture.height, historyTexture.height)
-                if copyWidth > 0, copyHeight > 0 {
-                    blitEncoder.copy(
-                        from: sceneTexture,
-                        sourceSlice: 0,
-                        sourceLevel: 0,
-                        sourceOrigin: MTLOrigin(x: 0, y: 0, z: 0),
-                        sourceSize: MTLSize(width: copyWidth, height: copyHeight, depth: 1),
-                        to: historyTexture,
-                        destinationSlice: 0,
-                        destinationLevel: 0,
-                        destinationOrigin: MTLOrigin(x: 0, y: 0, z: 0)
-                    )
-                    hasCapturedPreviousFrame = true
-                }
-                blitEncoder.endEncoding()
-            }
+            blitEncoder.label = "TerminalSceneCachePresent"
+            blitEncoder.copy(from: sceneCache, to: drawable.texture)
+            blitEncoder.endEncoding()
+            sceneCacheIsCurrent = true
         } else {
+            sceneCacheIsCurrent = false
+            postOutputIsCurrent = false
+            lastSceneCursorFrame = nil
             guard let renderEncoder = commandBuffer.makeRenderCommandEncoder(descriptor: drawableRenderPassDescriptor) else {
                 inflightSemaphore.signal()
                 return
             }
             renderEncoder.label = "TerminalRenderEncoder"
-            drawCalls += encodeTerminalScenePass(renderEncoder, drawableSize: drawableSize)
+            drawCalls += encodeTerminalScenePass(renderEncoder, drawableSize: drawableSize, missLog: missLog)
             renderEncoder.endEncoding()
         }
 
+        drawCalls += encodePerformanceHUDIfNeeded(commandBuffer: commandBuffer, target: drawable.texture, now: frameNow)
+
+        // Keystroke-to-glyph latency for an echo applied in this frame.
+        if let keystroke = pendingInputTimestamp {
+            pendingInputTimestamp = nil
+            let monitor = performanceMonitor
+            drawable.addPresentedHandler { presented in
+                let presentedAt = presented.presentedTime > 0 ? presented.presentedTime : CACurrentMediaTime()
+                DispatchQueue.main.async {
+                    monitor.recordInputLatency(seconds: presentedAt - keystroke)
+                }
+            }
+        }
+
+        if TraceRecorder.shared.isEnabled {
+            drawable.addPresentedHandler { presented in
+                guard presented.presentedTime > 0 else { return }
+                TraceRecorder.shared.instant(.present, at: presented.presentedTime, threadID: TraceRecorder.gpuTrackID)
+            }
+        }
+
         // Present drawable.
         commandBuffer.present(drawable)
 
@@ -212,34 +345,60 @@ extension MetalTerminalRenderer {
             gpuFrameSeconds: nil,
             drawCalls: drawCalls
         )
+        HitchDetector.shared.frameFinished(
+            start: frameStart,
+            end: frameStart + cpuFrameDuration,
+            budget: 1.0 / Double(max(view.preferredFramesPerSecond, 1))
+        )
         #if DEBUG
         let _snap = performanceMonitor.snapshot()
         if _snap.totalFrames > 0, _snap.totalFrames % 300 == 0 {
             let hr = String(format: "%.1f", glyphCache.hitRate * 100)
+            let atlasUse = String(format: "%.0f", glyphAtlas.occupancy.utilization * 100)
             print("[Renderer] avg=\(String(format: "%.2f", _snap.averageCPUFrameMs))ms"
                 + " p95=\(String(format: "%.2f", _snap.p95CPUFrameMs))ms"
                 + " dropped60=\(_snap.dropped60HzFrames) dropped120=\(_snap.dropped120HzFrames)"
-                + " | GlyphCache hit=\(hr)%")
+                + (_snap.averageInputLatencyMs.map { " input=\(String(format: "%.1f", $0))ms" } ?? "")
+                + " | GlyphCache hit=\(hr)% atlas=\(atlasUse)% of \(glyphAtlas.occupancy.pages)p")
         }
         #endif
-        commandBuffer.addCompletedHandler { _ in
+        let monitor = performanceMonitor
+        commandBuffer.addCompletedHandler { [weak self] buffer in
+            // Read the miss log before its slot can be reused.
+            let misses = missLog.drain()
             semaphore.signal()
+            frameTrace?.complete()
+            let gpuSeconds = buffer.gpuEndTime - buffer.gpuStartTime
+            TraceRecorder.shared.record(.gpuFrame, start: buffer.gpuStartTime, end: buffer.gpuEndTime, threadID: TraceRecorder.gpuTrackID)
+            DispatchQueue.main.async { [weak self] in
+                monitor.recordGPUFrame(seconds: gpuSeconds)
+                self?.applyGlyphFeedback(misses: misses)
+            }
         }
 
         // Commit the command buffer.
         commandBuffer.commit()
+        TraceRecorder.shared.record(.frameEncode, start: frameStart, end: CACurrentMediaTime())
+
+        if contentChanged {
+            noteThumbnailContentChanged()
+        }
 
         isDirty = false
     }
 
-    /// Drain any glyph keys that missed the cache this frame by launching a single
-    /// background rasterization task. New misses during an in-flight task accumulate
-    /// in `pendingGlyphKeys` and are processed on the next pass (triggered by `isDirty = true`).
+    /// Drain any glyph keys that missed the cache this frame by launching a
+    /// background rasterization run on `GlyphRasterPool`, which shards the keys
+    /// across cores. Completed batches are uploaded as they arrive. New misses
+    /// during an in-flight run accumulate in `pendingGlyphKeys` and are
+    /// dispatched once it finishes.
     private func drainPendingGlyphKeysIfNeeded() {
         guard isFontStateReady, !pendingGlyphKeys.isEmpty, glyphRasterTask == nil else { return }
 
-        let keys = pendingGlyphKeys
+        // Keys can be reported again while an earlier run is still rasterizing them.
+        let keys = Array(pendingGlyphKeys.filter { !glyphCache.contains($0) })
         pendingGlyphKeys.removeAll()
+        guard !keys.isEmpty else { return }
         let generation = glyphRasterGeneration
 
         let scale = screenScale
@@ -252,56 +411,47 @@ extension MetalTerminalRenderer {
         guard let fontSet = cachedRasterFontSet else { return }
 
         glyphRasterTask = Task.detached(priority: .userInitiated) { [weak self] in
-            // Local rasterizer instance — scratch buffer reused across all keys in this batch.
-            let rasterizer = GlyphRasterizer()
-
-            var results: [(GlyphKey, RasterizedGlyph)] = []
-            for key in keys {
-                if Task.isCancelled { break }
-                if let rasterized = MetalTerminalRenderer.rasterizeGlyphForBackground(
-                    key: key, cellWidth: cw, cellHeight: ch,
-                    fontSet: fontSet,
-                    rasterizer: rasterizer
-                ) {
-                    results.append((key, rasterized))
+            await GlyphRasterPool.shared.rasterize(
+                keys, cellWidth: cw, cellHeight: ch, fontSet: fontSet
+            ) { batch in
+                DispatchQueue.main.async { [weak self] in
+                    self?.uploadBackgroundGlyphs(batch, generation: generation)
                 }
             }
             DispatchQueue.main.async { [weak self] in
                 guard let self else { return }
-                guard generation == self.glyphRasterGeneration else {
-                    self.glyphRasterTask = nil
-                    if !self.pendingGlyphKeys.isEmpty {
-                        self.requestFrame()
-                    }
-                    return
-                }
-                for (key, rasterized) in results {
-                    guard !self.glyphCache.contains(key) else { continue }
-                    let entry = rasterized.pixelData.withUnsafeBufferPointer { ptr -> AtlasEntry? in
-                        guard let base = ptr.baseAddress else { return nil }
-                        return self.glyphAtlas.allocate(
-                            width: rasterized.width, height: rasterized.height,
-                            pixelData: base,
-                            bearingX: Int8(clamping: rasterized.bearingX),
-                            bearingY: Int8(clamping: rasterized.bearingY)
-                        )
-                    }
-                    if let entry { self.glyphCache.insert(key, entry: entry) }
-                }
                 self.glyphRasterTask = nil
-                // Force re-render: re-apply current snapshot so noGlyphIndex cells are
-                // replaced now that their entries are in the cache.
-                self.pendingRenderSnapshot = self.latestSnapshot
-                self.forceFullUploadForPendingSnapshot = true
-                self.isDirty = true
-                self.requestFrame()
+                // Misses queued while this run was in flight.
+                if !self.pendingGlyphKeys.isEmpty {
+                    self.requestFrame()
+                }
+            }
+        }
+    }
+
+    /// Upload one batch from the raster pool and redraw so cells that drew
+    /// blank pick up their entries from the glyph table. Batches from before
+    /// a font change are dropped.
+    private func uploadBackgroundGlyphs(_ batch: GlyphRasterPool.Batch, generation: UInt64) {
+        guard generation == glyphRasterGeneration else { return }
+        var uploaded = false
+        for (key, rasterized) in batch {
+            guard !glyphCache.contains(key) else { continue }
+            if let entry = uploadGlyph(rasterized) {
+                glyphCache.insert(key, entry: entry)
+                uploaded = true
             }
         }
+        guard uploaded else { return }
+        isDirty = true
+        requestFrame()
     }
 
     func encodeTerminalScenePass(
         _ renderEncoder: MTLRenderCommandEncoder,
-        drawableSize: CGSize
+        drawableSize: CGSize,
+        missLog: GlyphMissLog,
+        rows: Range<Int>? = nil
     ) -> Int {
         let viewport = MTLViewport(
             originX: 0,
@@ -313,23 +463,108 @@ extension MetalTerminalRenderer {
         )
         renderEncoder.setViewport(viewport)
 
-        let scissorRect = MTLScissorRect(
-            x: 0,
-            y: 0,
-            width: Int(drawableSize.width),
-            height: Int(drawableSize.height)
-        )
-        renderEncoder.setScissorRect(scissorRect)
+        if historyRingIsDrawing, let ring = historyRing {
+            return encodeHistoryRingPass(renderEncoder, ring: ring, drawableSize: drawableSize, missLog: missLog)
+        }
 
-        renderEncoder.setRenderPipelineState(pipelineState)
+        // Partial redraws clip to the damaged rows and draw only their slice
+        // of the draw lists.
+        let lists = drawLists.lists
+        let listRows = rows ?? 0..<lists.rowCount
+        if let rows {
+            guard let damageRect = FrameDamage.scissorRect(
+                rows: rows,
+                cellHeight: cellHeight * screenScale,
+                drawableSize: drawableSize
+            ) else { return 0 }
+            renderEncoder.setScissorRect(damageRect)
+        } else {
+            let scissorRect = MTLScissorRect(
+                x: 0,
+                y: 0,
+                width: Int(drawableSize.width),
+                height: Int(drawableSize.height)
+            )
+            renderEncoder.setScissorRect(scissorRect)
+        }
+        guard let readBuffer = cellInstanceBuffer, lists.rowCount > 0 else { return 0 }
+        var drawCalls = 0
+
+        // Backgrounds first: one flat quad per run of equal colour.
+        let runRange = lists.runs(inRows: listRows)
+        if let runBuffer = drawLists.runBuffer, !runRange.isEmpty {
+            renderEncoder.setRenderPipelineState(backgroundPipelineState)
+            renderEncoder.setVertexBuffer(runBuffer, offset: 0, index: 0)
+            renderEncoder.setVertexBuffer(uniformBuffer.buffer, offset: 0, index: 1)
+            renderEncoder.drawPrimitives(
+                type: .triangle,
+                vertexStart: 0,
+                vertexCount: 6,
+                instanceCount: runRange.count,
+                baseInstance: runRange.lowerBound
+            )
+            drawCalls += 1
+        }
 
-        if let readBuffer = cellBuffer.readBuffer {
-            renderEncoder.setVertexBuffer(readBuffer, offset: 0, index: 0)
+        guard bindCellPassResources(renderEncoder, cells: readBuffer, missLog: missLog) else { return drawCalls }
+
+        // Cells with a glyph, decoration, reverse video or selection.
+        // `instance_id` includes the base instance, so the shader indexes
+        // the slice directly.
+        let cellRange = lists.cells(inRows: listRows)
+        if let indexBuffer = drawLists.indexBuffer, !cellRange.isEmpty {
+            renderEncoder.setVertexBuffer(indexBuffer, offset: 0, index: 6)
+            renderEncoder.drawPrimitives(
+                type: .triangle,
+                vertexStart: 0,
+                vertexCount: 6,
+                instanceCount: cellRange.count,
+                baseInstance: cellRange.lowerBound
+            )
+            drawCalls += 1
+        }
+
+        // The cursor and its glow shade cells the lists may have skipped.
+        var cursorCells = cursorCellIndices(rowCount: lists.rowCount, columns: cellBuffer.columns)
+        if !cursorCells.isEmpty {
+            renderEncoder.setVertexBytes(&cursorCells, length: cursorCells.count * MemoryLayout<UInt32>.stride, index: 6)
+            renderEncoder.drawPrimitives(
+                type: .triangle,
+                vertexStart: 0,
+                vertexCount: 6,
+                instanceCount: cursorCells.count
+            )
+            drawCalls += 1
         }
+        drawCalls += encodeInlineImages(renderEncoder, drawableSize: drawableSize)
+        return drawCalls
+    }
+
+    /// Bind the cell pipeline with `cells` as its instances, plus the
+    /// uniforms, glyph table and atlas pages. The caller binds the cell
+    /// indices (vertex buffer 6). False when the glyph table has no buffers.
+    func bindCellPassResources(
+        _ renderEncoder: MTLRenderCommandEncoder,
+        cells: MTLBuffer,
+        missLog: GlyphMissLog
+    ) -> Bool {
+        renderEncoder.setRenderPipelineState(pipelineState)
+        renderEncoder.setVertexBuffer(cells, offset: 0, index: 0)
         renderEncoder.setVertexBuffer(uniformBuffer.buffer, offset: 0, index: 1)
         renderEncoder.setFragmentBuffer(uniformBuffer.buffer, offset: 0, index: 1)
 
-        let atlasTextures = (0..<GlyphAtlas.maxPageCount).map { glyphAtlas.texture(forPage: $0) }
+        // Glyph resolution happens in the vertex shader, against the
+        // stand-in atlas while one draws.
+        let storage = drawGlyphStorage
+        let glyphTable = storage.table
+        guard let tableBuffer = glyphTable.buffer, let usageBuffer = glyphTable.usageBuffer else { return false }
+        renderEncoder.setVertexBuffer(tableBuffer, offset: 0, index: 2)
+        renderEncoder.setVertexBuffer(usageBuffer, offset: 0, index: 3)
+        renderEncoder.setVertexBuffer(missLog.buffer, offset: 0, index: 4)
+        var tableParams = glyphTable.params
+        renderEncoder.setVertexBytes(&tableParams, length: MemoryLayout<GPUGlyphTable.Params>.stride, index: 5)
+
+        let atlasTextures = (0..<GlyphAtlas.maxPageCount).map { storage.atlas.texture(forPage: $0) }
         renderEncoder.setFragmentTextures(
             atlasTextures,
             range: 0..<GlyphAtlas.maxPageCount
@@ -338,17 +573,95 @@ extension MetalTerminalRenderer {
             previousFrameTexture ?? crtFallbackTexture,
             index: GlyphAtlas.maxPageCount
         )
+        return true
+    }
 
-        let instanceCount = cellBuffer.cellCount
-        guard instanceCount > 0 else { return 0 }
+    /// Expand compact cells into instances ahead of every pass that reads
+    /// them. Runs once per applied snapshot; later frames reuse the output.
+    private func encodeCellExpansionIfNeeded(commandBuffer: MTLCommandBuffer) {
+        guard cellBuffer.holdsCompactCells, !cellExpansionIsCurrent,
+              let cellExpansion, let source = cellBuffer.readBuffer else { return }
+        let columns = cellBuffer.columns
+        let cursorIndex = cursorVisible && cursorRow < cellBuffer.rows && cursorCol < columns
+            ? cursorRow * columns + cursorCol
+            : nil
+        cellExpansionIsCurrent = cellExpansion.encode(
+            commandBuffer: commandBuffer,
+            source: source,
+            cellCount: cellBuffer.cellCount,
+            columns: columns,
+            rowBase: cellBuffer.readRowBase,
+            cursorIndex: cursorIndex
+        ) != nil
+    }
 
-        renderEncoder.drawPrimitives(
-            type: .triangle,
-            vertexStart: 0,
-            vertexCount: 6,
-            instanceCount: instanceCount
-        )
-        return 1
+    /// Cells within the cursor glow radius of the cursor's render position.
+    private func cursorCellIndices(rowCount: Int, columns: Int) -> [UInt32] {
+        guard cursorVisible, rowCount > 0, columns > 0 else { return [] }
+        let bleed = FrameDamage.cursorBleedRows
+        let row = cursorRenderer.renderRow
+        let col = cursorRenderer.renderCol
+        let rows = max(0, Int(row.rounded(.down)) - bleed)..<min(rowCount, Int(row.rounded(.up)) + 1 + bleed)
+        let cols = max(0, Int(col.rounded(.down)) - bleed)..<min(columns, Int(col.rounded(.up)) + 1 + bleed)
+        guard !rows.isEmpty, !cols.isEmpty else { return [] }
+        var indices: [UInt32] = []
+        indices.reserveCapacity(rows.count * cols.count)
+        for r in rows {
+            for c in cols {
+                indices.append(UInt32(r * columns + c))
+            }
+        }
+        return indices
+    }
+
+    // MARK: - Bloom Encoding
+
+    /// Encode bloom for `sceneTexture` and return the halo for the post
+    /// pass, or nil when bloom is off. Uses the compute chain when its
+    /// kernels exist, otherwise the bright pass and separable blur.
+    private func encodeBloom(
+        commandBuffer: MTLCommandBuffer,
+        sceneTexture: MTLTexture,
+        sceneChanged: Bool
+    ) -> MTLTexture? {
+        guard bloomConfiguration.isEnabled else { return nil }
+        let radius = effectiveBloomRadius()
+
+        if let bloomChain {
+            guard let downLevels = bloomChainTargets?.textures else { return nil }
+            let inputs = BloomChain.Inputs(
+                width: sceneTexture.width,
+                height: sceneTexture.height,
+                threshold: bloomConfiguration.threshold,
+                gain: radius
+            )
+            return bloomChain.encode(
+                commandBuffer: commandBuffer,
+                scene: sceneTexture,
+                downLevels: downLevels,
+                inputs: inputs,
+                sceneChanged: sceneChanged
+            )
+        }
+
+        // Bloom bright-pass: extract luminant pixels → bloomBrightTexture (half-res)
+        encodeBrightPass(commandBuffer: commandBuffer, sceneTexture: sceneTexture)
+        // Bloom blur: H+V separable Gaussian → bloomBlurV
+        encodeBlurPasses(commandBuffer: commandBuffer, radius: radius)
+        return bloomBlurV
+    }
+
+    /// Bloom radius for this frame: a subtle cosine pulse for aurora/wave
+    /// gradient modes.
+    private func effectiveBloomRadius() -> Float {
+        if bloomConfiguration.animateWithGradient && gradientIsAnimating
+            && (gradientConfiguration.animationMode == .aurora
+                || gradientConfiguration.animationMode == .wave) {
+            let elapsed = Float(uniformBuffer.currentTime)
+            return bloomConfiguration.radius
+                * (0.9 + 0.1 * cos(elapsed * max(0.01, gradientConfiguration.animationSpeed)))
+        }
+        return bloomConfiguration.radius
     }
 
     // MARK: - Bloom Bright-Pass Encoding
@@ -377,27 +690,13 @@ extension MetalTerminalRenderer {
 
     // MARK: - Bloom Blur Encoding (H + V Separable Gaussian)
 
-    private func encodeBlurPasses(commandBuffer: MTLCommandBuffer) {
+    private func encodeBlurPasses(commandBuffer: MTLCommandBuffer, radius effectiveRadius: Float) {
         guard bloomConfiguration.isEnabled,
               let pipeline = bloomBlurHPipeline,
               let brightTex = bloomBrightTexture,
               let blurHTex = bloomBlurH,
               let blurVTex = bloomBlurV else { return }
 
-        // Compute effective radius: subtle cosine pulse for aurora/wave gradient modes.
-        let gradientIsAnimating = gradientConfiguration.isEnabled
-            && gradientConfiguration.animationMode != .none
-        let effectiveRadius: Float
-        if bloomConfiguration.animateWithGradient && gradientIsAnimating
-            && (gradientConfiguration.animationMode == .aurora
-                || gradientConfiguration.animationMode == .wave) {
-            let elapsed = Float(uniformBuffer.currentTime)
-            effectiveRadius = bloomConfiguration.radius
-                * (0.9 + 0.1 * cos(elapsed * max(0.01, gradientConfiguration.animationSpeed)))
-        } else {
-            effectiveRadius = bloomConfiguration.radius
-        }
-
         struct BloomBlurParams {
             var texelWidth: Float
             var texelHeight: Float
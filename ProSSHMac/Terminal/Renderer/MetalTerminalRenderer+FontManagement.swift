@@ -37,18 +37,8 @@ extension MetalTerminalRenderer {
         let cw = Int(pixelW)
         let ch = Int(pixelH)
 
-        // Rebuild the atlas with the pixel-aligned cell dimensions.
-        glyphAtlas.rebuild(cellWidth: cw, cellHeight: ch)
-
-        // Clear the glyph cache — any entries cached before the atlas rebuild
-        // now point to stale positions in the old atlas layout.
-        glyphCache.clear()
-
-        // Pre-populate ASCII glyphs (0x20-0x7E) across regular, bold, italic.
-        glyphCache.prePopulateASCII { [weak self] key in
-            guard let self else { return nil }
-            return self.rasterizeAndUpload(key: key)
-        }
+        // Switch to the shared atlas for the pixel-aligned cell dimensions.
+        adoptGlyphStorage(cellWidth: cw, cellHeight: ch)
 
         isFontStateReady = true
 
@@ -67,7 +57,8 @@ extension MetalTerminalRenderer {
     // MARK: - Font Change
 
     /// Called when the font configuration changes.
-    /// Rebuilds the glyph atlas, clears the cache, and re-populates ASCII glyphs.
+    /// Switches to the shared glyph atlas for the new font, pre-populating
+    /// ASCII glyphs if no other pane has filled it yet.
     func handleFontChange() {
         fontChangeTask?.cancel()
         fontChangeTask = Task { [weak self] in
@@ -129,16 +120,7 @@ extension MetalTerminalRenderer {
 
         let cw = Int(pixelW)
         let ch = Int(pixelH)
-        self.glyphAtlas.rebuild(cellWidth: cw, cellHeight: ch)
-
-        // Clear the glyph cache (all entries are now invalid).
-        self.glyphCache.clear()
-
-        // Re-populate ASCII glyphs.
-        self.glyphCache.prePopulateASCII { [weak self] key in
-            guard let self else { return nil }
-            return self.rasterizeAndUpload(key: key)
-        }
+        self.adoptGlyphStorage(cellWidth: cw, cellHeight: ch)
 
         isFontStateReady = true
 
@@ -158,6 +140,83 @@ extension MetalTerminalRenderer {
         self.isDirty = true
     }
 
+    // MARK: - Shared Glyph Storage
+
+    /// Point the renderer at the shared atlas for the current font, size and
+    /// scale. Storage that another pane already filled, or that is still
+    /// resident from a recent size, is used as is; new storage gets ASCII
+    /// (0x20-0x7E) pre-populated across regular, bold and italic. When new
+    /// storage replaces a filled one, the old atlas draws as a stand-in and
+    /// rasterization moves to the background.
+    func adoptGlyphStorage(cellWidth cw: Int, cellHeight ch: Int) {
+        let key = GlyphAtlasKey(
+            deviceID: device.registryID,
+            fontName: rasterFontName,
+            fontSize: rasterFontSize,
+            scale: max(screenScale, 1.0),
+            cellWidth: cw,
+            cellHeight: ch
+        )
+        if key != glyphStorage.key {
+            // Background raster jobs in flight were sized for the old storage.
+            glyphRasterGeneration &+= 1
+            glyphPrepopulationTask?.cancel()
+            glyphPrepopulationTask = nil
+            needsGlyphPrepopulation = false
+            let previous = glyphStorage
+            previous.removeEvictionObserver(self)
+            glyphStorage = GlyphAtlasStore.shared.storage(for: key, device: device)
+            glyphStorage.addEvictionObserver(self)
+            beginGlyphStandIn(previous: previous)
+        }
+
+        if glyphCache.count == 0 {
+            prepopulateGlyphs(for: key, rasterizeNow: glyphStandIn == nil)
+        }
+    }
+
+    /// Fill a fresh storage with the pre-populated glyph set, from the disk
+    /// cache when a file for `key` exists, otherwise by rasterizing and then
+    /// writing the file for the next launch. Without `rasterizeNow` the
+    /// rasterizing waits for the stand-in to retire.
+    private func prepopulateGlyphs(for key: GlyphAtlasKey, rasterizeNow: Bool) {
+        let diskCache = GlyphDiskCache.default
+        if let contents = diskCache.load(key) {
+            for glyph in contents.glyphs {
+                let entry = contents.withPixels(of: glyph) { pixels in
+                    glyphAtlas.allocate(
+                        width: glyph.width,
+                        height: glyph.height,
+                        pixelData: pixels,
+                        bearingX: glyph.bearingX,
+                        bearingY: glyph.bearingY,
+                        isColor: glyph.isColor,
+                        layout: glyph.isColor ? .bgra : .coverage
+                    )
+                }
+                if let entry = entry ?? nil {
+                    glyphCache.insert(glyph.key, entry: entry, pinned: true)
+                }
+            }
+            return
+        }
+        guard rasterizeNow else {
+            needsGlyphPrepopulation = true
+            return
+        }
+
+        var rasterized: [(key: GlyphKey, glyph: RasterizedGlyph)] = []
+        glyphCache.prePopulateASCII { [weak self] glyphKey in
+            guard let self, let glyph = self.rasterizeGlyph(key: glyphKey) else { return nil }
+            rasterized.append((glyphKey, glyph))
+            return self.uploadGlyph(glyph)
+        }
+        // The placeholder key used before font metrics load is not worth keeping.
+        if !key.fontName.isEmpty {
+            diskCache.store(rasterized, for: key)
+        }
+    }
+
     // MARK: - Pixel Alignment Helpers
 
     /// Re-apply pixel alignment to cellWidth/cellHeight using the current
@@ -183,6 +242,7 @@ extension MetalTerminalRenderer {
         }
 
         guard cellWidth > 0, cellHeight > 0 else { return }
+        reportCellPixelSizeIfChanged()
 
         let newColumns = max(1, Int(logicalWidth / cellWidth))
         let newRows = max(1, Int(logicalHeight / cellHeight))
@@ -196,3 +256,17 @@ extension MetalTerminalRenderer {
         }
     }
 }
+
+// MARK: - GlyphEvictionObserver
+
+extension MetalTerminalRenderer: GlyphEvictionObserver {
+
+    /// A glyph left the shared cache, possibly one this pane still shows.
+    /// The shader resolves from the shared table every frame, so a redraw
+    /// is enough for those cells to miss and be re-rasterized.
+    func sharedGlyphsEvicted() {
+        guard latestSnapshot != nil else { return }
+        isDirty = true
+        requestFrame()
+    }
+}
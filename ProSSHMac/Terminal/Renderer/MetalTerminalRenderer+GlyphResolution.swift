@@ -37,7 +37,7 @@ enum GlyphIndexPacking {
     }
 }
 
-extension MetalTerminalRenderer: GlyphResolver {
+extension MetalTerminalRenderer {
 
     // MARK: - Glyph Resolution
 
@@ -47,6 +47,13 @@ extension MetalTerminalRenderer: GlyphResolver {
     /// - Parameter key: The glyph key (codepoint + style).
     /// - Returns: An AtlasEntry describing the glyph's location in the atlas, or nil.
     func rasterizeAndUpload(key: GlyphKey) -> AtlasEntry? {
+        guard let rasterized = rasterizeGlyph(key: key) else { return nil }
+        return uploadGlyph(rasterized)
+    }
+
+    /// Rasterize a glyph at the current cell size and backing scale without
+    /// touching the atlas. Nil for empty or unrenderable glyphs.
+    func rasterizeGlyph(key: GlyphKey) -> RasterizedGlyph? {
         // Scale cell dimensions for Retina-quality rasterization.
         let scale = screenScale
         let cw = Int(ceil(cellWidth * scale))
@@ -85,20 +92,13 @@ extension MetalTerminalRenderer: GlyphResolver {
         guard rasterized.width > 0, rasterized.height > 0, !rasterized.pixelData.isEmpty else {
             return nil
         }
+        return rasterized
+    }
 
-        // Upload to atlas.
-        let entry = rasterized.pixelData.withUnsafeBufferPointer { ptr -> AtlasEntry? in
-            guard let baseAddress = ptr.baseAddress else { return nil }
-            return glyphAtlas.allocate(
-                width: rasterized.width,
-                height: rasterized.height,
-                pixelData: baseAddress,
-                bearingX: Int8(clamping: rasterized.bearingX),
-                bearingY: Int8(clamping: rasterized.bearingY)
-            )
-        }
-
-        return entry
+    /// Upload a rasterized glyph to the atlas, evicting a cold glyph of
+    /// the same kind if the atlas is full.
+    func uploadGlyph(_ rasterized: RasterizedGlyph) -> AtlasEntry? {
+        glyphStorage.allocate(rasterized)
     }
 
     func rebuildRasterFontCacheIfNeeded(scale: CGFloat) {
@@ -164,9 +164,20 @@ extension MetalTerminalRenderer: GlyphResolver {
     ///   - scalar: The Unicode scalar to render.
     ///   - primaryFont: The primary terminal font (SF Mono variant).
     /// - Returns: The best CTFont for rendering this scalar.
+    /// The font that draws `scalar`, from FontFallbackCache when this
+    /// primary font has resolved it before.
     nonisolated static func resolveRenderFont(
         for scalar: Unicode.Scalar,
         primaryFont: CTFont
+    ) -> CTFont {
+        FontFallbackCache.shared.font(for: scalar, primaryFont: primaryFont, resolver: .raster) {
+            uncachedRenderFont(for: scalar, primaryFont: primaryFont)
+        }
+    }
+
+    nonisolated static func uncachedRenderFont(
+        for scalar: Unicode.Scalar,
+        primaryFont: CTFont
     ) -> CTFont {
         let scalarValue = scalar.value
 
@@ -256,29 +267,36 @@ extension MetalTerminalRenderer: GlyphResolver {
         return CTFontGetGlyphsForCharacters(font, utf16, &glyphs, utf16.count) && glyphs[0] != 0
     }
 
-    func resolveGlyphIndex(for cell: CellInstance) -> UInt32 {
-        let attributes = CellAttributes(rawValue: cell.attributes)
-        let bold = attributes.contains(.bold)
-        let italic = attributes.contains(.italic)
-
-        // The grid snapshot stores the Unicode codepoint in glyphIndex initially.
-        let codepoint = cell.glyphIndex
-        let key = GlyphKey(codepoint: codepoint, bold: bold, italic: italic)
-
-        // Look up in cache.
-        if let entry = glyphCache.trackedLookup(key) {
-            return packAtlasEntry(entry)
+    /// Apply what the shader reported for a completed frame. Glyphs it hit
+    /// are promoted in the LRU; keys it could not resolve are queued for
+    /// background rasterization. The frame already drew those cells blank.
+    func applyGlyphFeedback(misses: Set<UInt32>) {
+        if let glyphStandIn {
+            applyStandInFeedback(glyphStandIn, misses: misses)
+            return
+        }
+        for key in glyphStorage.table.drainUsedKeys() {
+            _ = glyphCache.trackedLookup(key)
         }
 
-        // Cache miss: enqueue for background rasterization; return blank sentinel for this frame.
-        pendingGlyphKeys.insert(key)
-        return Self.noGlyphIndex
-    }
-
-    /// Pack an AtlasEntry into a UInt32 for the shader.
-    /// Layout: [page:4][y:14][x:14].
-    func packAtlasEntry(_ entry: AtlasEntry) -> UInt32 {
-        GlyphIndexPacking.pack(entry)
+        var queued = false
+        var restored = false
+        for packed in misses {
+            let key = GPUGlyphTable.unpackKey(packed)
+            guard glyphCache.trackedLookup(key) == nil else { continue }
+            // Evicted shaped-run tiles have no scalar to rasterize; redraw
+            // their run instead.
+            if GlyphShapingCache.isSynthetic(key.codepoint) {
+                restored = restoreShapedGlyph(key) || restored
+                continue
+            }
+            queued = pendingGlyphKeys.insert(key).inserted || queued
+        }
+        // An in-flight run requests a frame for queued keys when it finishes.
+        if restored || (queued && glyphRasterTask == nil) {
+            isDirty = true
+            requestFrame()
+        }
     }
 
     /// Pure CPU glyph rasterization — safe to call from any thread.
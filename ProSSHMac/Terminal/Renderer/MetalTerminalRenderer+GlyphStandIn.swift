@@ -0,0 +1,153 @@
+// MetalTerminalRenderer+GlyphStandIn.swift
+// ProSSHV2
+//
+// Keeps text on screen through a font size change. After Cmd +/- the pane
+// moves to the atlas for the new size. If that atlas is cold, the pane keeps
+// drawing the previous size's atlas, scaled to the new cell size, until the
+// new one holds every glyph on screen.
+//
+// While the stand-in draws, GPU feedback comes from its glyph table. Keys it
+// resolved, and keys it missed, are the glyphs on screen. Any the new atlas
+// lacks are queued for the background raster pool first. ASCII and box
+// drawing pre-population waits until they are done, then runs in the
+// background as well. The stand-in is dropped once a frame finds nothing
+// left to rasterize, or after `glyphStandInTimeout`.
+//
+// Toggling back to a size used recently needs no stand-in:
+// GlyphAtlasStore keeps recent atlases resident.
+
+import Metal
+
+extension MetalTerminalRenderer {
+
+    /// Longest a stand-in draws, even if glyphs are still missing.
+    static let glyphStandInTimeout: Duration = .seconds(1)
+
+    /// The storage the cell pass samples this frame.
+    var drawGlyphStorage: SharedGlyphStorage {
+        glyphStandIn ?? glyphStorage
+    }
+
+    /// Pixel size of an atlas slot in `drawGlyphStorage`.
+    var drawAtlasCellSize: SIMD2<Float> {
+        let key = drawGlyphStorage.key
+        return SIMD2<Float>(Float(key.cellWidth), Float(key.cellHeight))
+    }
+
+    /// Draw `previous` in place of the cold `glyphStorage`. An active
+    /// stand-in is kept: it is warm, and `previous` may not be yet.
+    func beginGlyphStandIn(previous: SharedGlyphStorage) {
+        glyphStandInRequested.removeAll()
+        guard glyphCache.count == 0, latestSnapshot != nil else {
+            glyphStandIn = nil
+            return
+        }
+        if glyphStandIn == nil {
+            guard previous.cache.count > 0 else {
+                glyphStandIn = nil
+                return
+            }
+            glyphStandIn = previous
+        }
+        glyphStandInStart = .now
+    }
+
+    /// Feedback from a frame drawn with the stand-in. Queues the glyphs on
+    /// screen that `glyphStorage` lacks and retires the stand-in once none
+    /// remain.
+    func applyStandInFeedback(_ standIn: SharedGlyphStorage, misses: Set<UInt32>) {
+        var visible = Set(standIn.table.drainUsedKeys())
+        for key in visible {
+            _ = standIn.cache.trackedLookup(key)
+        }
+        for packed in misses {
+            let key = GPUGlyphTable.unpackKey(packed)
+            if GlyphShapingCache.isSynthetic(key.codepoint) {
+                _ = restoreShapedGlyph(key)
+            } else {
+                visible.insert(key)
+            }
+        }
+
+        let missing = visible.filter { !glyphCache.contains($0) && !glyphStandInRequested.contains($0) }
+        glyphStandInRequested.formUnion(missing)
+        pendingGlyphKeys.formUnion(missing)
+
+        let settled = missing.isEmpty && pendingGlyphKeys.isEmpty && glyphRasterTask == nil
+        if settled || ContinuousClock.now - glyphStandInStart >= Self.glyphStandInTimeout {
+            retireGlyphStandIn()
+        } else {
+            // Keep frames coming so feedback sees the uploads land.
+            isDirty = true
+            requestFrame()
+        }
+    }
+
+    /// Draw `glyphStorage` again and start any deferred pre-population.
+    func retireGlyphStandIn() {
+        glyphStandIn = nil
+        glyphStandInRequested.removeAll()
+        isDirty = true
+        requestFrame()
+        if needsGlyphPrepopulation {
+            needsGlyphPrepopulation = false
+            prepopulateGlyphsInBackground(for: glyphStorage.key)
+        }
+    }
+
+    // MARK: - Background Pre-Population
+
+    /// Rasterize the pre-populated glyph set on the raster pool, pin it as
+    /// it arrives and write the disk cache when the run completes. Glyphs
+    /// the pane already rasterized for the stand-in are pinned in place.
+    func prepopulateGlyphsInBackground(for key: GlyphAtlasKey) {
+        glyphPrepopulationTask?.cancel()
+        prepopulatedGlyphs.removeAll()
+        let generation = glyphRasterGeneration
+
+        let scale = screenScale
+        let cw = Int(ceil(cellWidth * scale))
+        let ch = Int(ceil(cellHeight * scale))
+        guard cw > 0, ch > 0 else { return }
+        rebuildRasterFontCacheIfNeeded(scale: scale)
+        guard let fontSet = cachedRasterFontSet else { return }
+
+        let keys = GlyphCache.prePopulatedKeys
+        glyphPrepopulationTask = Task.detached(priority: .utility) { [weak self] in
+            await GlyphRasterPool.shared.rasterize(
+                keys, cellWidth: cw, cellHeight: ch, fontSet: fontSet
+            ) { batch in
+                DispatchQueue.main.async { [weak self] in
+                    self?.uploadPrepopulatedGlyphs(batch, generation: generation)
+                }
+            }
+            guard !Task.isCancelled else { return }
+            DispatchQueue.main.async { [weak self] in
+                guard let self, generation == self.glyphRasterGeneration else { return }
+                self.glyphPrepopulationTask = nil
+                // The placeholder key used before font metrics load is not worth keeping.
+                if !key.fontName.isEmpty {
+                    GlyphDiskCache.default.store(self.prepopulatedGlyphs, for: key)
+                }
+                self.prepopulatedGlyphs.removeAll()
+            }
+        }
+    }
+
+    private func uploadPrepopulatedGlyphs(_ batch: GlyphRasterPool.Batch, generation: UInt64) {
+        guard generation == glyphRasterGeneration else { return }
+        prepopulatedGlyphs.append(contentsOf: batch)
+        var uploaded = false
+        for (key, rasterized) in batch {
+            if glyphCache.contains(key) {
+                glyphCache.pin(key)
+            } else if let entry = uploadGlyph(rasterized) {
+                glyphCache.insert(key, entry: entry, pinned: true)
+                uploaded = true
+            }
+        }
+        guard uploaded else { return }
+        isDirty = true
+        requestFrame()
+    }
+}
@@ -0,0 +1,228 @@
+// MetalTerminalRenderer+HistoryRing.swift
+// ProSSHV2
+//
+// Momentum scrolling through scrollback, drawn from the scrollback row ring
+// (ScrollbackRowRing).
+// - A scroll gesture starts filling the ring around the viewport.
+// - Frames switch to the ring once it holds the viewport and the
+//   coordinator has caught up with the scroll engine. From then on, row
+//   crossings move `scrollRowBase` and are not sent to the coordinator.
+//   Rows stream into the ring ahead of the viewport.
+// - When the scroll settles, or any snapshot arrives, the engine's row is
+//   handed to the coordinator in one step. Frames go back to the cell
+//   buffer once the snapshot at that offset is in.
+// Ring rows draw without ligature shaping or selection, and grapheme
+// clusters draw as their first scalar. The snapshot after the fling has
+// all three, and a selection keeps scrolling on the snapshot path.
+
+import Metal
+
+extension MetalTerminalRenderer {
+
+    /// Rows kept resident above and below the viewport.
+    static func historyRingMargin(gridRows: Int) -> Int {
+        max(2 * gridRows, 64)
+    }
+
+    /// Rows past the viewport edges that the scroll offset can bring into
+    /// view (it moves up to 1.5 rows either way).
+    private static let historyRingOverscan = 2
+
+    private var canUseHistoryRing: Bool {
+        scrollbackRingRowsProvider != nil
+            && scrollToRowHandler != nil
+            && smoothScrollConfiguration.isEnabled
+            && latestSnapshot?.usingAlternateBuffer == false
+            && !selectionRenderer.needsProjection()
+    }
+
+    /// Line position of the viewport's top row.
+    private func historyRingTop(_ ring: ScrollbackRowRing) -> Int {
+        ring.liveTop - smoothScrollEngine.targetScrollRow
+    }
+
+    /// The positions a frame can show.
+    private func historyRingDrawnPositions(_ ring: ScrollbackRowRing) -> Range<Int> {
+        let top = historyRingTop(ring)
+        return ((top - Self.historyRingOverscan)..<(top + ring.gridRows + Self.historyRingOverscan))
+            .clamped(to: ring.positions)
+    }
+
+    // MARK: - Scroll Lines
+
+    /// Integer row changes from the scroll engine.
+    func handleScrollLineChange(_ lines: Int) {
+        if historyRingIsDrawing {
+            if historyRingAwaitedOffset != nil {
+                // Already handed back; keep the coordinator following.
+                handBackHistoryRing()
+            }
+        } else {
+            onScrollLineChange?(lines)
+        }
+        fillHistoryRingIfNeeded()
+    }
+
+    /// Start a fresh ring for a new scroll gesture unless frames are still
+    /// drawing from the current one.
+    func prepareHistoryRing() {
+        if !historyRingIsDrawing {
+            discardHistoryRing()
+        }
+        fillHistoryRingIfNeeded()
+    }
+
+    // MARK: - Filling
+
+    /// Fetch the rows around the viewport that the ring lacks, creating the
+    /// ring first. One fetch runs at a time.
+    func fillHistoryRingIfNeeded() {
+        guard historyRingFetch == nil, canUseHistoryRing, let provider = scrollbackRingRowsProvider else { return }
+        guard let ring = historyRing else {
+            historyRingFetch = Task { @MainActor [weak self] in
+                let probe = await provider(0..<0)
+                guard let self, !Task.isCancelled else { return }
+                self.historyRingFetch = nil
+                guard let probe, probe.columns == self.gridColumns else { return }
+                let margin = Self.historyRingMargin(gridRows: self.gridRows)
+                self.historyRing = ScrollbackRowRing(
+                    device: self.device,
+                    columns: probe.columns,
+                    capacity: self.gridRows + 2 * (margin + Self.historyRingOverscan),
+                    gridRows: self.gridRows,
+                    firstPosition: probe.firstPosition,
+                    liveTop: probe.liveTop
+                )
+                self.fillHistoryRingIfNeeded()
+            }
+            return
+        }
+
+        let margin = Self.historyRingMargin(gridRows: ring.gridRows)
+        let top = historyRingTop(ring)
+        let window = ((top - margin)..<(top + ring.gridRows + margin)).clamped(to: ring.positions)
+        guard let missing = ring.missingPositions(in: window) else { return }
+        historyRingFetch = Task { @MainActor [weak self] in
+            let fetched = await provider(missing)
+            guard let self, !Task.isCancelled else { return }
+            self.historyRingFetch = nil
+            guard let fetched, self.historyRing === ring else { return }
+            guard fetched.liveTop == ring.liveTop || self.historyRingIsDrawing else {
+                // Output moved the screen since the ring was created.
+                self.discardHistoryRing()
+                return
+            }
+            ring.write(fetched)
+            guard !fetched.rows.isEmpty else { return }
+            if self.historyRingIsDrawing {
+                self.requestFrame()
+            }
+            self.fillHistoryRingIfNeeded()
+        }
+    }
+
+    // MARK: - Frames
+
+    /// Called each frame before the uniforms are written. Switches frames
+    /// to or from the ring and returns the frame's `scrollRowBase`.
+    func updateHistoryRingForFrame() -> UInt32 {
+        guard let ring = historyRing else { return 0 }
+        if ring.columns != gridColumns || ring.gridRows != gridRows
+            || latestSnapshot?.usingAlternateBuffer != false {
+            if historyRingIsDrawing, historyRingAwaitedOffset == nil {
+                handBackHistoryRing()
+            }
+            endHistoryRing()
+            return 0
+        }
+
+        if historyRingIsDrawing {
+            if historyRingAwaitedOffset == nil, !smoothScrollEngine.requiresContinuousFrames() {
+                handBackHistoryRing()
+            }
+        } else if canUseHistoryRing,
+                  smoothScrollEngine.requiresContinuousFrames(),
+                  scrollOffsetProvider?() == smoothScrollEngine.targetScrollRow,
+                  ring.missingPositions(in: historyRingDrawnPositions(ring)) == nil {
+            historyRingIsDrawing = true
+        }
+        guard historyRingIsDrawing else { return 0 }
+
+        fillHistoryRingIfNeeded()
+        // Ring frames redraw in full; the cell buffer's damage is not theirs.
+        frameDamage.invalidate()
+        return UInt32(UInt16(truncatingIfNeeded: historyRingTop(ring)))
+    }
+
+    /// Whether a coordinator sync to `row` may move the scroll engine while
+    /// frames draw from the ring. The snapshot at the awaited offset ends
+    /// ring drawing. Any other snapshot during a fling, such as new output,
+    /// hands the engine's row back first.
+    func acceptsHistoryRingJump(to row: Int) -> Bool {
+        guard let awaited = historyRingAwaitedOffset else {
+            if row == smoothScrollEngine.targetScrollRow {
+                return true
+            }
+            handBackHistoryRing()
+            return false
+        }
+        guard row == awaited else { return false }
+        endHistoryRing()
+        return true
+    }
+
+    /// Move the coordinator to the scroll engine's row.
+    private func handBackHistoryRing() {
+        let row = smoothScrollEngine.targetScrollRow
+        historyRingAwaitedOffset = row
+        scrollToRowHandler?(row)
+    }
+
+    /// Return frames to the cell buffer and drop the ring.
+    func endHistoryRing() {
+        historyRingIsDrawing = false
+        historyRingAwaitedOffset = nil
+        discardHistoryRing()
+        isDirty = true
+    }
+
+    private func discardHistoryRing() {
+        historyRingFetch?.cancel()
+        historyRingFetch = nil
+        historyRing = nil
+    }
+
+    // MARK: - Encoding
+
+    /// Draw the viewport's resident ring rows through the cell shader, one
+    /// instanced draw per contiguous run of slots. Every cell is drawn, so
+    /// the cell shader paints the backgrounds as well.
+    func encodeHistoryRingPass(
+        _ renderEncoder: MTLRenderCommandEncoder,
+        ring: ScrollbackRowRing,
+        drawableSize: CGSize,
+        missLog: GlyphMissLog
+    ) -> Int {
+        renderEncoder.setScissorRect(MTLScissorRect(
+            x: 0,
+            y: 0,
+            width: Int(drawableSize.width),
+            height: Int(drawableSize.height)
+        ))
+        let runs = ring.slotRuns(for: historyRingDrawnPositions(ring))
+        guard !runs.isEmpty, bindCellPassResources(renderEncoder, cells: ring.cellBuffer, missLog: missLog) else {
+            return 0
+        }
+        renderEncoder.setVertexBuffer(ring.indexBuffer, offset: 0, index: 6)
+        for run in runs {
+            renderEncoder.drawPrimitives(
+                type: .triangle,
+                vertexStart: 0,
+                vertexCount: 6,
+                instanceCount: run.count * ring.columns,
+                baseInstance: run.lowerBound * ring.columns
+            )
+        }
+        return runs.count
+    }
+}
@@ -0,0 +1,78 @@
+// MetalTerminalRenderer+InlineImages.swift
+// ProSSHV2
+//
+// Draws a snapshot's inline images (see InlineImage.swift) as textured
+// quads over their cells, after the cell pass. The grid blanks those cells,
+// so nothing shows through an opaque image. Textures come from
+// InlineImageTextureCache; an image still decoding is skipped and the
+// frame is redrawn once it is ready. Images are not drawn from the history
+// ring during a fling; they reappear with the snapshot that ends it.
+//
+// The renderer also reports its cell size in device pixels, which the
+// grid needs to turn an image's pixel size into cells.
+
+import Metal
+
+extension MetalTerminalRenderer {
+
+    /// Take the image quads of a newly applied snapshot. A change redraws
+    /// every row, since quads span rows the cell damage does not cover.
+    func updateInlineImages(from snapshot: GridSnapshot) {
+        guard snapshot.inlineImages != inlineImageQuads else { return }
+        inlineImageQuads = snapshot.inlineImages
+        frameDamage.invalidate()
+    }
+
+    /// Encode the image quads onto the scene pass. Returns the number of
+    /// draw calls encoded.
+    func encodeInlineImages(_ renderEncoder: MTLRenderCommandEncoder, drawableSize: CGSize) -> Int {
+        guard !inlineImageQuads.isEmpty, let pipeline = inlineImagePipeline,
+              drawableSize.width > 0, drawableSize.height > 0 else { return 0 }
+        let cellPixelWidth = Float(cellWidth * screenScale)
+        let cellPixelHeight = Float(cellHeight * screenScale)
+        let width = Float(drawableSize.width)
+        let height = Float(drawableSize.height)
+        var drawCalls = 0
+        renderEncoder.setRenderPipelineState(pipeline)
+        for quad in inlineImageQuads {
+            guard let texture = InlineImageTextureCache.shared.texture(
+                for: quad.imageID,
+                device: device,
+                onReady: { [weak self] in
+                    guard let self else { return }
+                    self.isDirty = true
+                    self.requestFrame()
+                }
+            ) else { continue }
+            let left = Float(quad.column) * cellPixelWidth
+            let top = Float(quad.row) * cellPixelHeight + inlineImageScrollOffsetPixels
+            let right = left + Float(quad.columns) * cellPixelWidth * quad.widthFraction
+            let bottom = top + Float(quad.rows) * cellPixelHeight * quad.heightFraction
+            guard bottom > 0, top < height else { continue }
+            var rect = SIMD4<Float>(
+                left / width * 2 - 1,
+                1 - top / height * 2,
+                right / width * 2 - 1,
+                1 - bottom / height * 2
+            )
+            renderEncoder.setVertexBytes(&rect, length: MemoryLayout<SIMD4<Float>>.stride, index: 0)
+            renderEncoder.setFragmentTexture(texture, index: 0)
+            renderEncoder.drawPrimitives(type: .triangleStrip, vertexStart: 0, vertexCount: 4)
+            drawCalls += 1
+        }
+        return drawCalls
+    }
+
+    /// Tell `onCellPixelSizeChange` the cell size in device pixels if it
+    /// differs from the last one reported.
+    func reportCellPixelSizeIfChanged() {
+        guard let onCellPixelSizeChange, cellWidth > 0, cellHeight > 0 else { return }
+        let size = InlineImageCellSize(
+            width: Int((cellWidth * screenScale).rounded()),
+            height: Int((cellHeight * screenScale).rounded())
+        )
+        guard size != reportedCellPixelSize else { return }
+        reportedCellPixelSize = size
+        onCellPixelSizeChange(size.width, size.height)
+    }
+}
@@ -90,35 +90,23 @@ extension MetalTerminalRenderer {
         isDirty = true
     }
 
-    /// Ensure half-resolution bloom intermediate textures exist and match drawable size.
+    /// Ensure bloom intermediate textures exist and match drawable size,
+    /// at half resolution or lower under the power policy.
+    /// The compute chain needs only its down levels; the fragment passes need
+    /// bright, blur H and blur V.
     func ensureBloomTextures(width: Int, height: Int) {
-        let bw = max(1, width / 2)
-        let bh = max(1, height / 2)
+        let bw = max(1, width / powerPolicy.bloomDownsample)
+        let bh = max(1, height / powerPolicy.bloomDownsample)
 
-        if bloomBrightTexture?.width != bw || bloomBrightTexture?.height != bh {
-            bloomBrightTexture = makeBloomHalfResTexture(width: bw, height: bh)
-        }
-        if bloomBlurH?.width != bw || bloomBlurH?.height != bh {
-            bloomBlurH = makeBloomHalfResTexture(width: bw, height: bh)
-        }
-        if bloomBlurV?.width != bw || bloomBlurV?.height != bh {
-            bloomBlurV = makeBloomHalfResTexture(width: bw, height: bh)
+        if bloomChain != nil {
+            if bloomChainTargets?.key.width != bw || bloomChainTargets?.key.height != bh {
+                bloomChainTargets = RenderResourceStore.shared.effectTargets(.bloomChain, width: bw, height: bh, device: device)
+            }
+        } else if bloomTargets?.key.width != bw || bloomTargets?.key.height != bh {
+            bloomTargets = RenderResourceStore.shared.effectTargets(.bloom, width: bw, height: bh, device: device)
         }
     }
 
-    private func makeBloomHalfResTexture(width: Int, height: Int) -> MTLTexture? {
-        let descriptor = MTLTextureDescriptor.texture2DDescriptor(
-            pixelFormat: .bgra8Unorm,
-            width: width,
-            height: height,
-            mipmapped: false
-        )
-        descriptor.usage = [.renderTarget, .shaderRead]
-        descriptor.storageMode = .private
-        descriptor.resourceOptions = .storageModePrivate
-        return device.makeTexture(descriptor: descriptor)
-    }
-
     /// Current gradient background configuration (read-only).
     var currentGradientConfiguration: GradientBackgroundConfiguration {
         gradientConfiguration
@@ -159,16 +147,16 @@ extension MetalTerminalRenderer {
             hasCapturedPreviousFrame = false
         }
 
-        if postProcessTexture?.width != width || postProcessTexture?.height != height {
-            postProcessTexture = makePostProcessTexture(width: width, height: height)
+        if sceneTargets?.key.width != width || sceneTargets?.key.height != height {
+            sceneTargets = RenderResourceStore.shared.effectTargets(.scene, width: width, height: height, device: device)
         }
 
         if bloomConfiguration.isEnabled {
             ensureBloomTextures(width: width, height: height)
         } else {
-            bloomBrightTexture = nil
-            bloomBlurH = nil
-            bloomBlurV = nil
+            bloomTargets = nil
+            bloomChainTargets = nil
+            bloomChain?.releaseTextures()
         }
     }
 
@@ -185,17 +173,34 @@ extension MetalTerminalRenderer {
         return device.makeTexture(descriptor: descriptor)
     }
 
-    func makePostProcessTexture(width: Int, height: Int) -> MTLTexture? {
-        let descriptor = MTLTextureDescriptor.texture2DDescriptor(
-            pixelFormat: .bgra8Unorm,
-            width: width,
-            height: height,
-            mipmapped: false
-        )
-        descriptor.usage = [.renderTarget, .shaderRead]
-        descriptor.storageMode = .private
-        descriptor.resourceOptions = .storageModePrivate
-        return device.makeTexture(descriptor: descriptor)
+    /// The persistent plain-path scene texture, recreated (and marked stale)
+    /// when the drawable size changes.
+    /// Whether the post pass output changes with time alone: the scanner
+    /// sweep, and animated gradients (which also pulse the bloom radius).
+    /// CRT scanlines, curvature and static gradients depend only on the
+    /// scene and settings.
+    func postProcessingDependsOnTime(scannerActive: Bool) -> Bool {
+        scannerActive
+            || gradientIsAnimating
+    }
+
+    func ensureSceneCacheTexture(matching target: MTLTexture) -> MTLTexture? {
+        if sceneCacheTexture?.width != target.width || sceneCacheTexture?.height != target.height {
+            let descriptor = MTLTextureDescriptor.texture2DDescriptor(
+                pixelFormat: target.pixelFormat,
+                width: target.width,
+                height: target.height,
+                mipmapped: false
+            )
+            descriptor.usage = [.renderTarget, .shaderRead]
+            descriptor.storageMode = .private
+            descriptor.resourceOptions = .storageModePrivate
+            sceneCacheTexture = device.makeTexture(descriptor: descriptor)
+            sceneCacheTexture?.label = "TerminalSceneCache"
+            sceneCacheIsCurrent = false
+            postOutputIsCurrent = false
+        }
+        return sceneCacheTexture
     }
 
     func makeSceneRenderPassDescriptor(
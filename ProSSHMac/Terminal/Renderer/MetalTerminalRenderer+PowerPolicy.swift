@@ -0,0 +1,59 @@
+// MetalTerminalRenderer+PowerPolicy.swift
+// ProSSHV2
+//
+// Applies RenderPowerPolicy. When the policy stops effects from animating,
+// the gradient is drawn in its static form and the scanner sweep is off.
+// The display link then stops between content changes. The frame cap
+// applies on top of the rate SessionRenderBudget picks for the pane.
+
+import Foundation
+
+extension MetalTerminalRenderer: RenderPowerClient {
+
+    func renderPowerPolicyDidChange(_ policy: RenderPowerPolicy) {
+        guard policy != powerPolicy else { return }
+        powerPolicy = policy
+        setPreferredFPS(requestedFPS)
+        updateCursorBlink()
+        bloomChain?.invalidate()
+        isDirty = true
+        requestFrame()
+    }
+
+    /// Whether the scanner sweep runs this frame.
+    var scannerIsActive: Bool {
+        scannerConfiguration.isEnabled && isLocalSession && powerPolicy.animatesEffects
+    }
+
+    /// Whether the gradient background moves with time this frame.
+    var gradientIsAnimating: Bool {
+        gradientConfiguration.isEnabled
+            && gradientConfiguration.animationMode != .none
+            && powerPolicy.animatesEffects
+    }
+
+    /// Whether a blinking cursor blinks under the current policy.
+    var blinksCursor: Bool {
+        cursorBlinkEnabled && powerPolicy.blinksCursor
+    }
+
+    /// The gradient settings the shader draws with: static while the
+    /// policy holds effects still.
+    var frameGradientConfiguration: GradientBackgroundConfiguration {
+        guard !powerPolicy.animatesEffects, gradientConfiguration.animationMode != .none else {
+            return gradientConfiguration
+        }
+        var configuration = gradientConfiguration
+        configuration.animationMode = .none
+        return configuration
+    }
+
+    /// The scanner settings the shader draws with: off while the policy
+    /// holds effects still.
+    var frameScannerConfiguration: ScannerEffectConfiguration {
+        guard !powerPolicy.animatesEffects, scannerConfiguration.isEnabled else { return scannerConfiguration }
+        var configuration = scannerConfiguration
+        configuration.isEnabled = false
+        return configuration
+    }
+}
@@ -65,6 +65,7 @@ extension MetalTerminalRenderer {
 
 enum TerminalSelectionTextExtractor {
     static func selectedText(from snapshot: GridSnapshot, selection: TerminalSelection) -> String? {
+        let snapshot = snapshot.expandingCompactCells()
         let cols = snapshot.columns
         let rows = snapshot.rows
         guard cols > 0, rows > 0 else { return nil }
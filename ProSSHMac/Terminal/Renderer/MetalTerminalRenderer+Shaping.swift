@@ -0,0 +1,210 @@
+// MetalTerminalRenderer+Shaping.swift
+// ProSSHV2
+//
+// Applies GlyphShapingCache to pending snapshots: shapes the rows a
+// snapshot damaged, uploads tiles for newly shaped runs, and writes the
+// tile codepoints into the cells before they reach the cell buffer.
+
+import CoreText
+import Metal
+
+extension MetalTerminalRenderer {
+
+    // MARK: - Run Shaping
+
+    /// `snapshot` with shaped-run tile codepoints substituted into its
+    /// cells. Rows in the snapshot's damage are reshaped; all rows are when
+    /// `reshapeAll` is set, the damage is unknown, or the geometry, screen
+    /// or shaping cache changed since the last pass.
+    func applyShaping(to snapshot: GridSnapshot, reshapeAll: Bool) -> GridSnapshot {
+        guard shapingEnabled, isFontStateReady, snapshot.columns > 0, snapshot.rows > 0 else {
+            shapedRowSubstitutions.removeAll()
+            return snapshot
+        }
+
+        let shaping = glyphStorage.shaping
+        let geometry = (columns: snapshot.columns, rows: snapshot.rows, alternate: snapshot.usingAlternateBuffer)
+        let fullPass = reshapeAll
+            || snapshot.dirtyRange == nil
+            || shapedRowsCache !== shaping
+            || shapedRowsGeneration != shaping.generation
+            || shapedRowsGeometry != geometry
+        // A cache reset during this pass leaves the generation changed, so
+        // the next snapshot reshapes everything again.
+        shapedRowsCache = shaping
+        shapedRowsGeneration = shaping.generation
+        shapedRowsGeometry = geometry
+
+        if fullPass {
+            shapedRowSubstitutions.removeAll(keepingCapacity: true)
+            for row in 0..<snapshot.rows {
+                shapeRow(row, of: snapshot, shaping: shaping)
+            }
+        } else {
+            let damage = snapshot.damagedRanges ?? snapshot.dirtyRange.map { [$0] } ?? []
+            var lastRow = -1
+            for range in damage where !range.isEmpty {
+                let first = max(range.lowerBound / snapshot.columns, lastRow + 1)
+                let last = min((range.upperBound - 1) / snapshot.columns, snapshot.rows - 1)
+                guard first <= last else { continue }
+                for row in first...last {
+                    shapeRow(row, of: snapshot, shaping: shaping)
+                }
+                lastRow = last
+            }
+        }
+
+        guard !shapedRowSubstitutions.isEmpty else { return snapshot }
+        return snapshot.substitutingGlyphs(shapedRowSubstitutions)
+    }
+
+    /// Recompute `shapedRowSubstitutions[row]`.
+    private func shapeRow(_ row: Int, of snapshot: GridSnapshot, shaping: GlyphShapingCache) {
+        let columns = snapshot.columns
+        let rowStart = row * columns
+        shapingRowScratch.removeAll(keepingCapacity: true)
+        if let compactCells = snapshot.compactCells {
+            for index in rowStart..<(rowStart + columns) {
+                let cell = compactCells[index]
+                guard cell.width == 1, cell.codepoint & GraphemeSideTable.sentinel == 0 else {
+                    shapingRowScratch.append(.runBreak)
+                    continue
+                }
+                shapingRowScratch.append(GlyphShapingCache.shapingCell(
+                    codepoint: cell.codepoint, attributes: cell.attributes.rawValue
+                ))
+            }
+        } else {
+            let overrides = snapshot.graphemeOverrides
+            for index in rowStart..<(rowStart + columns) {
+                let cell = snapshot.cells[index]
+                guard overrides?[index] == nil else {
+                    shapingRowScratch.append(.runBreak)
+                    continue
+                }
+                shapingRowScratch.append(GlyphShapingCache.shapingCell(
+                    codepoint: cell.glyphIndex, attributes: cell.attributes
+                ))
+            }
+        }
+
+        var substitutions: [(col: Int, codepoint: UInt32)] = []
+        for run in GlyphShapingCache.runs(in: shapingRowScratch) {
+            let key = ShapingRunKey(
+                scalars: shapingRowScratch[run].map(\.codepoint),
+                style: shapingRowScratch[run.lowerBound].style
+            )
+            guard case .shaped(let codepoints)? = shaping.lookup(key) ?? shapeRun(key, shaping: shaping) else {
+                continue
+            }
+            for (offset, codepoint) in codepoints.enumerated() {
+                substitutions.append((run.lowerBound + offset, codepoint))
+            }
+        }
+        shapedRowSubstitutions[row] = substitutions.isEmpty ? nil : substitutions
+    }
+
+    /// Shape a run that missed the cache, upload its tiles and cache the
+    /// result. Nil when the font state cannot rasterize yet.
+    private func shapeRun(_ key: ShapingRunKey, shaping: GlyphShapingCache) -> GlyphShapingCache.Entry? {
+        guard let metrics = shapingFont(for: key) else { return nil }
+        guard let line = GlyphShaper.shapedLine(for: key.scalars, font: metrics.font) else {
+            shaping.storePlain(key)
+            return .plain
+        }
+        let tiles = glyphRasterizer.rasterize(
+            shapedLine: line, font: metrics.font, cellCount: key.scalars.count,
+            cellWidth: metrics.cellWidth, cellHeight: metrics.cellHeight
+        )
+        guard tiles.count == key.scalars.count else { return nil }
+        let codepoints = shaping.storeShaped(key, coverage: tiles.map { $0 != nil })
+        uploadShapedTiles(tiles, codepoints: codepoints, key: key)
+        return .shaped(codepoints)
+    }
+
+    /// Re-rasterize the run behind an evicted tile `key` and upload its
+    /// missing tiles. False when the tile's run is no longer cached.
+    func restoreShapedGlyph(_ key: GlyphKey) -> Bool {
+        let shaping = glyphStorage.shaping
+        guard let source = shaping.source(of: key.codepoint),
+              case .shaped(let codepoints) = source.entry,
+              let metrics = shapingFont(for: source.key),
+              let line = GlyphShaper.shapedLine(for: source.key.scalars, font: metrics.font) else {
+            return false
+        }
+        let tiles = glyphRasterizer.rasterize(
+            shapedLine: line, font: metrics.font, cellCount: codepoints.count,
+            cellWidth: metrics.cellWidth, cellHeight: metrics.cellHeight
+        )
+        guard tiles.count == codepoints.count else { return false }
+        uploadShapedTiles(tiles, codepoints: codepoints, key: source.key)
+        return true
+    }
+
+    private func uploadShapedTiles(_ tiles: [RasterizedGlyph?], codepoints: [UInt32], key: ShapingRunKey) {
+        for (tile, codepoint) in zip(tiles, codepoints) where codepoint != 0 {
+            let glyphKey = GlyphKey(codepoint: codepoint, bold: key.bold, italic: key.italic)
+            guard let tile, !glyphCache.contains(glyphKey), let entry = uploadGlyph(tile) else { continue }
+            glyphCache.insert(glyphKey, entry: entry)
+        }
+    }
+
+    /// Font variant for `key`'s style and the backing-pixel cell size.
+    private func shapingFont(for key: ShapingRunKey) -> (font: CTFont, cellWidth: Int, cellHeight: Int)? {
+        let scale = screenScale
+        let cw = Int(ceil(cellWidth * scale))
+        let ch = Int(ceil(cellHeight * scale))
+        guard cw > 0, ch > 0 else { return nil }
+        rebuildRasterFontCacheIfNeeded(scale: scale)
+        guard let fontSet = cachedRasterFontSet else { return nil }
+        let font: CTFont
+        switch (key.bold, key.italic) {
+        case (true, true): font = fontSet.boldItalic
+        case (true, false): font = fontSet.bold
+        case (false, true): font = fontSet.italic
+        case (false, false): font = fontSet.regular
+        }
+        return (font, cw, ch)
+    }
+}
+
+// MARK: - Glyph Substitution
+
+nonisolated extension GridSnapshot {
+
+    /// This snapshot with the codepoints of the given cells replaced, per
+    /// row as (column, codepoint). Damage is unchanged.
+    func substitutingGlyphs(_ substitutions: [Int: [(col: Int, codepoint: UInt32)]]) -> GridSnapshot {
+        var cells = self.cells
+        var compactCells = self.compactCells
+        for (row, rowSubstitutions) in substitutions where row < rows {
+            let rowStart = row * columns
+            for substitution in rowSubstitutions where substitution.col < columns {
+                let index = rowStart + substitution.col
+                if compactCells != nil {
+                    compactCells![index].codepoint = substitution.codepoint
+                } else {
+                    cells[index].glyphIndex = substitution.codepoint
+                }
+            }
+        }
+        var snapshot = GridSnapshot(
+            cells: cells,
+            dirtyRange: dirtyRange,
+            cursorRow: cursorRow,
+            cursorCol: cursorCol,
+            cursorVisible: cursorVisible,
+            cursorStyle: cursorStyle,
+            columns: columns,
+            rows: rows,
+            usingAlternateBuffer: usingAlternateBuffer,
+            graphemeOverrides: graphemeOverrides,
+            compactCells: compactCells,
+            inlineImages: inlineImages
+        )
+        snapshot.damagedRanges = damagedRanges
+        snapshot.sequence = sequence
+        snapshot.scroll = scroll
+        return snapshot
+    }
+}
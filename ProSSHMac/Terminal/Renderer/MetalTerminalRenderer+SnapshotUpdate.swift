@@ -18,6 +18,33 @@ extension MetalTerminalRenderer {
     ///
     /// - Parameter snapshot: The grid snapshot to render.
     func updateSnapshot(_ snapshot: GridSnapshot) {
+        storeSnapshot(snapshot)
+        // The draw loop records this snapshot's damage when it applies it.
+        requestFrame()
+        updateCursorBlink()
+    }
+
+    /// Take the newest snapshot from `snapshotFeed`, if one arrived since
+    /// the last frame, and make it the pending snapshot. Called at the top
+    /// of the draw callback. Before the pull, the scroll engine is synced to
+    /// the coordinator's offset, as the nonce-driven path does.
+    func pullFeedSnapshot() {
+        guard let snapshot = snapshotFeed?.takeLatest() else { return }
+        if let keystroke = snapshotFeed?.takenInputTimestamp {
+            pendingInputTimestamp = min(pendingInputTimestamp ?? keystroke, keystroke)
+        }
+        if let trace = snapshotFeed?.takenTrace {
+            pendingLatencyTrace = PipelineTrace.earliest(pendingLatencyTrace, trace)
+        }
+        if !snapshot.usingAlternateBuffer, let scrollOffsetProvider {
+            scrollJumpTo(row: scrollOffsetProvider())
+        }
+        storeSnapshot(snapshot)
+        updateCursorBlink()
+    }
+
+    /// Record `snapshot` as the one the next frame applies.
+    private func storeSnapshot(_ snapshot: GridSnapshot) {
         // Alternate buffer (TUI apps) must never carry smooth-scroll state.
         // Reset on every alt-buffer snapshot — not just transitions — so that
         // residual renderOffset/velocity from any source (stale scroll events,
@@ -55,18 +82,20 @@ extension MetalTerminalRenderer {
             col: renderSnapshot.cursorCol,
             style: renderSnapshot.cursorStyle,
             visible: renderSnapshot.cursorVisible,
-            blinkEnabled: cursorBlinkEnabled
+            blinkEnabled: blinksCursor
         )
-        isDirty = true
-        requestFrame()
-        updateCursorBlinkLoop()
     }
 
     func applyPendingSnapshotIfNeeded() {
-        guard let snapshot = pendingRenderSnapshot else { return }
+        guard var snapshot = pendingRenderSnapshot else { return }
         pendingRenderSnapshot = nil
+        if cellExpansion == nil {
+            // No expansion kernel: compact cells are expanded here instead.
+            snapshot = snapshot.expandingCompactCells()
+        }
         let shouldForceFullUpload = forceFullUploadForPendingSnapshot
         forceFullUploadForPendingSnapshot = false
+        snapshot = applyShaping(to: snapshot, reshapeAll: shouldForceFullUpload)
         let uploadSnapshot: GridSnapshot
         if shouldForceFullUpload {
             uploadSnapshot = GridSnapshot(
@@ -79,13 +108,51 @@ extension MetalTerminalRenderer {
                 columns: snapshot.columns,
                 rows: snapshot.rows,
                 usingAlternateBuffer: snapshot.usingAlternateBuffer,
-                graphemeOverrides: snapshot.graphemeOverrides
+                graphemeOverrides: snapshot.graphemeOverrides,
+                compactCells: snapshot.compactCells,
+                inlineImages: snapshot.inlineImages
             )
         } else {
             uploadSnapshot = snapshot
         }
 
-        cellBuffer.update(from: uploadSnapshot, resolver: self)
+        recordDamage(for: uploadSnapshot)
+        updateInlineImages(from: uploadSnapshot)
+        cellBuffer.update(from: uploadSnapshot)
         cellBuffer.swapBuffers()
+        if let compactCells = snapshot.compactCells {
+            drawLists.update(CellDrawLists(cells: compactCells, columns: snapshot.columns, rows: snapshot.rows))
+            cellExpansionIsCurrent = false
+        } else {
+            drawLists.update(CellDrawLists(cells: snapshot.cells, columns: snapshot.columns, rows: snapshot.rows))
+        }
+    }
+
+    /// Feed the rows `snapshot` changes into `frameDamage`, and track blinking
+    /// cells within them. Call before the cell buffer takes the snapshot.
+    private func recordDamage(for snapshot: GridSnapshot) {
+        let blinkMask = CellAttributes.blink.rawValue
+        let cellCount = snapshot.cellCount
+        let damage: [Range<Int>]?
+        if snapshot.columns != cellBuffer.columns || snapshot.rows != cellBuffer.rows {
+            damage = nil
+        } else if let damagedRanges = snapshot.damagedRanges {
+            damage = damagedRanges
+        } else {
+            damage = snapshot.dirtyRange.map { [$0] }
+        }
+
+        guard let damage else {
+            frameDamage.invalidate()
+            hasBlinkingCells = snapshot.compactCells?.contains { $0.attributes.contains(.blink) }
+                ?? snapshot.cells.contains { $0.attributes & blinkMask != 0 }
+            return
+        }
+        frameDamage.add(cellRanges: damage, columns: snapshot.columns)
+        if !hasBlinkingCells {
+            hasBlinkingCells = damage.contains { range in
+                range.clamped(to: 0..<cellCount).contains { snapshot.cellAttributes(at: $0) & blinkMask != 0 }
+            }
+        }
     }
 }
@@ -0,0 +1,68 @@
+// MetalTerminalRenderer+Thumbnail.swift
+// ProSSHV2
+//
+// Captures the pane's thumbnail (see SessionThumbnailAtlas) from the
+// persistent scene texture after its content changes. A change inside
+// `thumbnailInterval` of the last capture schedules one deferred capture
+// instead; that capture encodes its own small command buffer and never
+// wakes the display link. The shared command queue runs it after the
+// frame that drew the scene, so it reads finished pixels.
+
+import CoreGraphics
+import Metal
+import QuartzCore
+
+extension MetalTerminalRenderer {
+
+    /// Shortest time between two captures of one pane.
+    static let thumbnailInterval: CFTimeInterval = 1.0
+
+    /// Called after a frame whose text changed.
+    func noteThumbnailContentChanged() {
+        guard onThumbnail != nil, thumbnailPipeline != nil else { return }
+        thumbnailIsStale = true
+        guard thumbnailCaptureTask == nil else { return }
+
+        let wait = lastThumbnailAt + Self.thumbnailInterval - CACurrentMediaTime()
+        guard wait > 0 else {
+            captureThumbnailIfStale()
+            return
+        }
+        thumbnailCaptureTask = Task { @MainActor [weak self] in
+            try? await Task.sleep(for: .seconds(wait))
+            guard !Task.isCancelled, let self else { return }
+            self.thumbnailCaptureTask = nil
+            self.captureThumbnailIfStale()
+        }
+    }
+
+    /// Encodes a capture of the last presented scene when it is newer than
+    /// the last thumbnail. Leaves it stale when there is nothing to read
+    /// yet or the atlas is full, so the next change retries.
+    func captureThumbnailIfStale() {
+        guard thumbnailIsStale,
+              let pipeline = thumbnailPipeline,
+              let source = sceneCacheTexture,
+              sceneCacheIsCurrent || postOutputIsCurrent,
+              let atlas = RenderResourceStore.shared.thumbnailAtlas(for: device),
+              let commandBuffer = commandQueue.makeCommandBuffer(),
+              let capture = atlas.encodeCapture(from: source, pipeline: pipeline, commandBuffer: commandBuffer) else {
+            return
+        }
+        commandBuffer.label = "SessionThumbnailCapture"
+        thumbnailIsStale = false
+        lastThumbnailAt = CACurrentMediaTime()
+
+        commandBuffer.addCompletedHandler { [weak self] buffer in
+            let image = buffer.status == .completed
+                ? SessionThumbnailAtlas.makeImage(from: capture.pixels)
+                : nil
+            DispatchQueue.main.async { [weak self] in
+                atlas.release(capture)
+                guard let image else { return }
+                self?.onThumbnail?(image)
+            }
+        }
+        commandBuffer.commit()
+    }
+}
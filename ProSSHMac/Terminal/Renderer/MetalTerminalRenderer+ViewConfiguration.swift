@@ -41,12 +41,7 @@ extension MetalTerminalRenderer {
             reapplyPixelAlignment()
             let cw = Int(round(cellWidth * screenScale))
             let ch = Int(round(cellHeight * screenScale))
-            glyphAtlas.rebuild(cellWidth: cw, cellHeight: ch)
-            glyphCache.clear()
-            glyphCache.prePopulateASCII { [weak self] key in
-                guard let self else { return nil }
-                return self.rasterizeAndUpload(key: key)
-            }
+            adoptGlyphStorage(cellWidth: cw, cellHeight: ch)
             if let latestSnapshot {
                 updateSnapshot(latestSnapshot)
             }
@@ -61,6 +56,7 @@ extension MetalTerminalRenderer {
 
         // cellWidth/cellHeight are pixel-aligned points from the renderer.
         if cellWidth > 0, cellHeight > 0, logicalWidth > 0, logicalHeight > 0 {
+            reportCellPixelSizeIfChanged()
             let newColumns = max(1, Int(logicalWidth / cellWidth))
             let newRows = max(1, Int(logicalHeight / cellHeight))
 
@@ -87,6 +83,8 @@ extension MetalTerminalRenderer {
         view.device = device
         view.delegate = self
         view.colorPixelFormat = .bgra8Unorm
+        // Partial redraws blit the persistent scene texture into the drawable.
+        view.framebufferOnly = false
         configuredMTKView = view
 
         // B.8.6: ProMotion support — use native display refresh (60 Hz or 120 Hz).
@@ -101,25 +99,27 @@ extension MetalTerminalRenderer {
         view.isPaused = true
         view.enableSetNeedsDisplay = true
         selectionRenderer.refreshSelectionColorFromSystemAccent()
+        RenderVisibilityScheduler.shared.register(self)
     }
 
     // MARK: - Frame Rate Control (2.2.9 / 2.2.10)
 
     /// Pause or unpause rendering. Use for panes that are not visible
     /// (e.g. hidden behind a maximized pane or off-screen in another tab).
+    /// An unpaused pane still draws only while RenderVisibilityScheduler
+    /// reports its window visible and the displays awake.
     func setPaused(_ paused: Bool) {
-        configuredMTKView?.isPaused = paused
-        if paused {
-            stopCursorBlinkLoop()
-        } else {
-            updateCursorBlinkLoop()
-        }
+        isHostVisible = !paused
+        updateRenderVisibility()
     }
 
     /// Set the preferred frames per second.
     /// Pass 0 to follow the current screen's native refresh rate.
-    func setPreferredFPS(_ fps: Int) {
+    /// The power policy may cap it lower.
+    func setPreferredFPS(_ requested: Int) {
+        requestedFPS = requested
         guard let view = configuredMTKView else { return }
+        let fps = powerPolicy.cappedFPS(requested)
         usesNativeRefreshRate = fps <= 0
         if usesNativeRefreshRate {
             view.preferredFramesPerSecond = max(60, currentScreenMaximumFPS())
@@ -139,35 +139,53 @@ extension MetalTerminalRenderer {
         return 60
     }
 
-    // MARK: - Cursor Blink Loop
-
-    /// Start a ~15fps blink animation loop if cursor is visible and blink enabled.
-    /// The loop sets isDirty and unpauses the view on each tick.
-    func startCursorBlinkLoopIfNeeded() {
-        guard cursorBlinkTask == nil else { return }
-        guard cursorVisible, cursorBlinkEnabled else { return }
-        cursorBlinkTask = Task { @MainActor [weak self] in
-            while !Task.isCancelled {
-                try? await Task.sleep(for: .milliseconds(67)) // ~15fps
-                guard !Task.isCancelled, let self else { break }
-                self.isDirty = true
-                self.requestFrame()
-            }
+    // MARK: - Cursor Blink
+
+    /// Subscribe to the shared blink clock while the cursor is visible,
+    /// blinking and the pane may draw; unsubscribe otherwise.
+    func updateCursorBlink() {
+        if cursorVisible && blinksCursor && isRenderVisible {
+            CursorBlinkClock.shared.add(self)
+        } else {
+            CursorBlinkClock.shared.remove(self)
         }
     }
+}
+
+// MARK: - Cursor Blink Clock
 
-    /// Stop the cursor blink loop.
-    func stopCursorBlinkLoop() {
-        cursorBlinkTask?.cancel()
-        cursorBlinkTask = nil
+extension MetalTerminalRenderer: CursorBlinkClient {
+
+    /// Redraw only the rows around the cursor for the new blink phase.
+    func cursorBlinkTick() {
+        frameDamage.markCursor()
+        requestFrame()
     }
+}
+
+// MARK: - Render Visibility
+
+extension MetalTerminalRenderer: RenderVisibilityClient {
 
-    /// Start or stop the blink loop based on current cursor state.
-    func updateCursorBlinkLoop() {
-        if cursorVisible && cursorBlinkEnabled {
-            startCursorBlinkLoopIfNeeded()
+    var renderWindow: NSWindow? {
+        configuredMTKView?.window
+    }
+
+    /// Stop drawing while hidden; on reveal, draw the latest snapshot.
+    func updateRenderVisibility() {
+        let wasVisible = isRenderVisible
+        isRenderVisible = RenderVisibilityScheduler.shared.shouldRender(
+            hostVisible: isHostVisible,
+            window: renderWindow
+        )
+        if isRenderVisible != wasVisible {
+            onRenderVisibilityChange?(isRenderVisible)
+        }
+        updateCursorBlink()
+        if isRenderVisible {
+            requestFrame()
         } else {
-            stopCursorBlinkLoop()
+            configuredMTKView?.isPaused = true
         }
     }
 }
@@ -60,17 +60,60 @@ final class MetalTerminalRenderer: NSObject, MTKViewDelegate {
     /// Compiled render pipeline state for the post-processing pass.
     let postProcessPipelineState: MTLRenderPipelineState
 
+    /// Flat-colour pipeline for background runs, drawn before the cell pass.
+    let backgroundPipelineState: MTLRenderPipelineState
+
     // MARK: - Renderer Components
 
+    /// Atlas and glyph cache, shared with every renderer drawing the same
+    /// font, size and scale on this device (see `GlyphAtlasStore`).
+    var glyphStorage: SharedGlyphStorage
+
     /// Glyph texture atlas for storing rasterized glyphs.
-    let glyphAtlas: GlyphAtlas
+    var glyphAtlas: GlyphAtlas { glyphStorage.atlas }
 
     /// LRU cache mapping GlyphKey to AtlasEntry.
-    let glyphCache: GlyphCache
+    var glyphCache: GlyphCache { glyphStorage.cache }
+
+    /// The previous font size's storage, drawn scaled while `glyphStorage`
+    /// rasterizes the glyphs on screen (see MetalTerminalRenderer+GlyphStandIn).
+    var glyphStandIn: SharedGlyphStorage?
+
+    /// When the stand-in started drawing.
+    var glyphStandInStart = ContinuousClock.now
+
+    /// Keys queued for `glyphStorage` while the stand-in draws.
+    var glyphStandInRequested: Set<GlyphKey> = []
+
+    /// Whether `glyphStorage` still needs its pre-populated glyph set,
+    /// deferred while a stand-in draws.
+    var needsGlyphPrepopulation = false
+
+    /// In-flight background pre-population; nil when idle.
+    var glyphPrepopulationTask: Task<Void, Never>?
+
+    /// Pre-populated glyphs rasterized so far, written to the disk cache
+    /// once the run completes.
+    var prepopulatedGlyphs: GlyphRasterPool.Batch = []
 
     /// GPU buffer for cell instance data (double-buffered).
     let cellBuffer: CellBuffer
 
+    /// Background runs and the cells the cell shader draws, per snapshot.
+    let drawLists: CellDrawListBuffer
+
+    /// Expands compact snapshot cells into `CellInstance`s on the GPU.
+    let cellExpansion: CellExpansionPass?
+
+    /// Whether `cellExpansion` holds the current cell buffer's expansion.
+    var cellExpansionIsCurrent = false
+
+    /// The instance buffer the cell pass reads: the expansion output when
+    /// the cell buffer holds compact cells, else the cell buffer itself.
+    var cellInstanceBuffer: MTLBuffer? {
+        cellBuffer.holdsCompactCells ? cellExpansion?.outputBuffer : cellBuffer.readBuffer
+    }
+
     /// GPU buffer for per-frame uniform data.
     let uniformBuffer: TerminalUniformBuffer
 
@@ -140,8 +183,21 @@ final class MetalTerminalRenderer: NSObject, MTKViewDelegate {
     /// Glyphs are rasterized at this multiple of point dimensions for crisp text.
     var screenScale: CGFloat = 1.0
 
-    /// Whether a new snapshot has been applied and the buffer is dirty.
-    var isDirty: Bool = true
+    /// Whether the next frame must be redrawn in full. Snapshot and cursor
+    /// changes go through `frameDamage` instead, so they redraw only the
+    /// rows they touch.
+    var isDirty: Bool = true {
+        didSet {
+            if isDirty { frameDamage.invalidate() }
+        }
+    }
+
+    /// Rows changed since the last frame, for partial redraws.
+    var frameDamage = FrameDamage()
+
+    /// Whether any cell carries the blink attribute, whose visibility is
+    /// time-based; partial redraws are off while it is set.
+    var hasBlinkingCells = false
 
     /// Most recently received snapshot for reapplying transient overlays.
     var latestSnapshot: GridSnapshot?
@@ -173,6 +229,23 @@ final class MetalTerminalRenderer: NSObject, MTKViewDelegate {
     /// rate rather than a fixed value.
     var usesNativeRefreshRate: Bool = false
 
+    /// Rate last passed to `setPreferredFPS`, before the power cap.
+    var requestedFPS = 0
+
+    /// Frame rate, effect and bloom limits for the current power source
+    /// and thermal state (see RenderPowerPolicy).
+    var powerPolicy: RenderPowerPolicy = .full
+
+    /// Whether the host shows this pane (see `setPaused`).
+    var isHostVisible = true
+
+    /// Whether this pane may draw: shown by its host, in a visible window,
+    /// with the displays awake. Frame requests are ignored while false.
+    var isRenderVisible = true
+
+    /// Called when `isRenderVisible` changes.
+    var onRenderVisibilityChange: ((Bool) -> Void)?
+
     // MARK: - Smooth Scroll
 
     /// CPU-side physics engine for smooth scrolling.
@@ -185,20 +258,115 @@ final class MetalTerminalRenderer: NSObject, MTKViewDelegate {
     /// Set by the view layer to bridge scrollback info from the session engine.
     var scrollbackBoundsProvider: (() -> Int)?
 
+    /// Optional closure providing the coordinator's scroll offset row, read
+    /// when a snapshot is pulled from `snapshotFeed`.
+    var scrollOffsetProvider: (() -> Int)?
+
+    /// Receives the integer row changes of a scroll, as deltas for the
+    /// coordinator, unless the scrollback row ring absorbs them.
+    var onScrollLineChange: ((Int) -> Void)?
+
+    // MARK: - Scrollback Row Ring
+
+    /// Fetches history rows at line positions for `historyRing`. With
+    /// `scrollToRowHandler`, enables drawing flings from the ring.
+    var scrollbackRingRowsProvider: ((Range<Int>) async -> ScrollbackRingRows?)?
+
+    /// Moves the coordinator to a scroll offset once a fling drawn from
+    /// the ring settles.
+    var scrollToRowHandler: ((Int) -> Void)?
+
+    /// History rows around the viewport, on the GPU (see
+    /// MetalTerminalRenderer+HistoryRing).
+    var historyRing: ScrollbackRowRing?
+    var historyRingFetch: Task<Void, Never>?
+    /// True while frames draw from `historyRing` instead of the cell buffer.
+    var historyRingIsDrawing = false
+    /// The scroll offset handed to `scrollToRowHandler`, until the snapshot
+    /// at that offset arrives.
+    var historyRingAwaitedOffset: Int?
+
+    // MARK: - Snapshot Feed
+
+    /// Display-link snapshot source (see GridSnapshotFeed). While set, the
+    /// draw callback pulls the newest snapshot itself and each publish only
+    /// wakes the view.
+    var snapshotFeed: GridSnapshotFeed? {
+        didSet {
+            oldValue?.onPublish = nil
+            oldValue?.memoryFootprintProvider = nil
+            snapshotFeed?.onPublish = { [weak self] in
+                self?.requestFrame()
+            }
+            snapshotFeed?.memoryFootprintProvider = { [weak self] in
+                self?.memoryFootprint ?? MemoryFootprint()
+            }
+            if snapshotFeed?.hasUnreadSnapshot == true {
+                requestFrame()
+            }
+        }
+    }
+
+    /// Keystroke time carried by a pulled snapshot that has not been
+    /// presented yet; the frame that shows it records the latency.
+    var pendingInputTimestamp: CFTimeInterval?
+
+    /// Latency sample carried by a pulled snapshot that has not been
+    /// uploaded yet (see PipelineLatencyTracer).
+    var pendingLatencyTrace: PipelineTrace?
+
+    // MARK: - Performance HUD
+
+    /// Pipeline compositing the performance HUD; nil when its shaders are
+    /// unavailable.
+    let performanceHUDPipeline: MTLRenderPipelineState?
+
+    /// The pane's performance HUD; nil while disabled.
+    var performanceHUD: PerformanceHUDOverlay?
+
+    /// Session-side totals for the HUD (see
+    /// `SessionManager.performanceHUDStats(for:)`).
+    var performanceHUDStatsProvider: (() -> PerformanceHUDSessionStats?)?
+
+    // MARK: - Inline Images
+
+    /// Pipeline drawing inline images; nil when its shaders are
+    /// unavailable, which leaves their cells blank.
+    let inlineImagePipeline: MTLRenderPipelineState?
+
+    /// Image quads of the last applied snapshot.
+    var inlineImageQuads: [InlineImageQuad] = []
+
+    /// Smooth-scroll offset of the frame being encoded, which image quads
+    /// follow as the cells do.
+    var inlineImageScrollOffsetPixels: Float = 0
+
+    /// Receives the cell size in device pixels when it changes.
+    var onCellPixelSizeChange: ((Int, Int) -> Void)? {
+        didSet {
+            reportedCellPixelSize = nil
+            reportCellPixelSizeIfChanged()
+        }
+    }
+
+    /// Last size passed to `onCellPixelSizeChange`.
+    var reportedCellPixelSize: InlineImageCellSize?
+
     // MARK: - Demand-Driven Rendering
 
     /// Whether any continuous animation requires the display link to stay active.
     func requiresContinuousFrames() -> Bool {
         if cursorRenderer.requiresContinuousFrames() { return true }
         if smoothScrollEngine.requiresContinuousFrames() { return true }
-        if scannerConfiguration.isEnabled && isLocalSession { return true }
-        if gradientConfiguration.isEnabled && gradientConfiguration.animationMode != .none { return true }
+        if scannerIsActive { return true }
+        if gradientIsAnimating { return true }
         return false
     }
 
     /// Request a redraw. Enables the display link for continuous animations,
     /// or triggers a single-frame `setNeedsDisplay` for one-shot updates.
     func requestFrame() {
+        guard isRenderVisible else { return }
         if requiresContinuousFrames() {
             configuredMTKView?.isPaused = false
         } else if let view = configuredMTKView {
@@ -224,6 +392,11 @@ final class MetalTerminalRenderer: NSObject, MTKViewDelegate {
         // coordinator's scroll offset can outrun the engine's bounds
         // during heavy output with preserveScrollAnchor, desynchronising
         // the two and preventing the user from scrolling back to live.
+        // While a fling draws from the scrollback row ring the coordinator
+        // lags the engine on purpose; see acceptsHistoryRingJump(to:).
+        if historyRingIsDrawing, !acceptsHistoryRingJump(to: row) {
+            return
+        }
         if let maxRow = scrollbackBoundsProvider?() {
             smoothScrollEngine.setBounds(maxRow: maxRow)
         }
@@ -233,6 +406,7 @@ final class MetalTerminalRenderer: NSObject, MTKViewDelegate {
     /// Called when a direct scroll gesture begins.
     func scrollGestureBegan() {
         smoothScrollEngine.beginGesture()
+        prepareHistoryRing()
         requestFrame()
     }
 
@@ -254,9 +428,12 @@ final class MetalTerminalRenderer: NSObject, MTKViewDelegate {
 
     // MARK: - In-Flight Buffering (B.8.7)
 
-    /// Semaphore with value 2 to match the double-buffered CellBuffer.
-    /// Ensures we never overwrite a cell buffer still in GPU use.
-    let inflightSemaphore = DispatchSemaphore(value: 2)
+    /// Frames the CPU may encode ahead of the GPU. The cell buffer ring and
+    /// glyph miss logs are sized to match.
+    static let maxFramesInFlight = 2
+
+    /// Ensures we never overwrite a cell buffer or miss log still in GPU use.
+    let inflightSemaphore = DispatchSemaphore(value: MetalTerminalRenderer.maxFramesInFlight)
 
     /// Latest render-ready snapshot waiting to be uploaded to the next safe
     /// writable cell buffer. Applied from the draw loop.
@@ -318,20 +495,56 @@ final class MetalTerminalRenderer: NSObject, MTKViewDelegate {
     /// Bloom pipeline: same object as bloomBlurHPipeline; direction controlled by uniform in Phase 3.
     var bloomBlurVPipeline: MTLRenderPipelineState?
 
+    /// Half-resolution bloom chain, shared with same-sized panes; nil while
+    /// bloom is disabled.
+    var bloomTargets: SharedEffectTargets?
+
     /// Intermediate texture: bright-pass extraction output (half resolution).
-    var bloomBrightTexture: MTLTexture?
+    var bloomBrightTexture: MTLTexture? { bloomTargets?.textures[0] }
 
     /// Intermediate texture: horizontal blur output (half resolution).
-    var bloomBlurH: MTLTexture?
+    var bloomBlurH: MTLTexture? { bloomTargets?.textures[1] }
 
     /// Intermediate texture: vertical blur output / final bloom halo (half resolution).
-    var bloomBlurV: MTLTexture?
+    var bloomBlurV: MTLTexture? { bloomTargets?.textures[2] }
+
+    /// Compute bloom with a per-pane cached halo; nil when its kernels are
+    /// unavailable, in which case the fragment passes above run instead.
+    let bloomChain: BloomChain?
+
+    /// Shared down levels for `bloomChain`; nil while bloom is disabled.
+    var bloomChainTargets: SharedEffectTargets?
+
+    /// Cursor state drawn into the last post-processing scene. The cursor
+    /// can move, blink or pulse without damaging rows, so the bloom cache
+    /// compares it separately.
+    var lastSceneCursorFrame: CursorRenderFrame?
 
     /// Previous frame color texture for phosphor afterglow sampling.
+    /// Per pane: it must survive between this pane's frames.
     var previousFrameTexture: MTLTexture?
 
+    /// Offscreen scene target, shared with same-sized panes.
+    var sceneTargets: SharedEffectTargets?
+
     /// Offscreen scene texture used as post-processing input.
-    var postProcessTexture: MTLTexture?
+    var postProcessTexture: MTLTexture? { sceneTargets?.textures[0] }
+
+    /// Persistent copy of the last presented frame, copied to the drawable.
+    /// On the plain (no post-processing) path damaged rows are redrawn into
+    /// it; with post-processing the post pass renders into it.
+    var sceneCacheTexture: MTLTexture?
+
+    /// Whether `sceneCacheTexture` holds the last plain-path scene.
+    var sceneCacheIsCurrent = false
+
+    /// Whether `sceneCacheTexture` holds the last post-processed frame.
+    var postOutputIsCurrent = false
+
+    /// Whether the last post-processed frame had a changed scene. Its
+    /// phosphor history then still differs from the scene, so the next
+    /// frame's afterglow differs too and cannot reuse the output.
+    var lastPostSceneChanged = true
 
     /// Black fallback texture used before a previous frame exists.
     var crtFallbackTexture: MTLTexture?
@@ -351,8 +564,54 @@ final class MetalTerminalRenderer: NSObject, MTKViewDelegate {
     /// In-flight background rasterization task; nil when idle.
     var glyphRasterTask: Task<Void, Never>?
 
-    /// In-flight cursor blink loop task; nil when blink is inactive or view is externally paused.
-    var cursorBlinkTask: Task<Void, Never>?
+    // MARK: - Run Shaping
+
+    /// Whether rows are shaped for ligatures and complex scripts
+    /// (see GlyphShapingCache). Read once per renderer.
+    var shapingEnabled = UserDefaults.standard.bool(forKey: GlyphShapingCache.enabledDefaultsKey)
+
+    /// Per row, the (column, codepoint) substitutions from the last pass
+    /// that shaped it. Applied to every snapshot, since undamaged rows
+    /// are not reshaped.
+    var shapedRowSubstitutions: [Int: [(col: Int, codepoint: UInt32)]] = [:]
+
+    /// Cache, generation and geometry `shapedRowSubstitutions` was built
+    /// against; any change reshapes every row.
+    weak var shapedRowsCache: GlyphShapingCache?
+    var shapedRowsGeneration: UInt64 = 0
+    var shapedRowsGeometry = (columns: 0, rows: 0, alternate: false)
+
+    /// Reused per-row buffer for run segmentation.
+    var shapingRowScratch: [ShapingCell] = []
+
+    /// Shader glyph miss logs, one per in-flight frame (see `inflightSemaphore`).
+    let glyphMissLogs: [GlyphMissLog]
+
+    /// Miss log the next frame writes to.
+    var glyphMissLogIndex = 0
+
+    // MARK: - Thumbnails
+
+    /// Pipeline downsampling the scene into the thumbnail atlas; nil
+    /// disables thumbnails.
+    let thumbnailPipeline: MTLComputePipelineState?
+
+    /// Receives a thumbnail of the pane's content after it changes, at most
+    /// once per `thumbnailInterval` (see SessionThumbnailAtlas).
+    var onThumbnail: ((CGImage) -> Void)? {
+        didSet { thumbnailIsStale = onThumbnail != nil }
+    }
+
+    /// Whether content presented since the last capture is not yet in a
+    /// thumbnail.
+    var thumbnailIsStale = false
+
+    /// When the last capture was encoded.
+    var lastThumbnailAt: CFTimeInterval = 0
+
+    /// Deferred capture for a change inside the interval; nil when none
+    /// is pending.
+    var thumbnailCaptureTask: Task<Void, Never>?
 
     // MARK: - Initialization (B.8.1, B.8.2)
 
@@ -360,7 +619,7 @@ final class MetalTerminalRenderer: NSObject, MTKViewDelegate {
     ///
     /// Sets up the complete render pipeline:
     /// - Creates command queue
-    /// - Loads shader library and creates pipeline state
+    /// - Takes shared pipeline states from TerminalPipelineCache
     /// - Initializes glyph atlas, cache, cell buffer, and uniform buffer
     /// - Pre-populates ASCII glyphs into the atlas
     ///
@@ -371,86 +630,32 @@ final class MetalTerminalRenderer: NSObject, MTKViewDelegate {
         self.device = device
         self.fontManager = fontManager
 
-        // B.8.1: Create command queue.
-        guard let queue = device.makeCommandQueue() else {
+        // B.8.1: Command queue, shared by every pane on this device.
+        guard let queue = RenderResourceStore.shared.commandQueue(for: device) else {
             fatalError("MetalTerminalRenderer: failed to create MTLCommandQueue")
         }
-        queue.label = "TerminalRenderQueue"
         self.commandQueue = queue
 
-        // B.8.2: Load shader library and create render pipeline state.
-        guard let library = device.makeDefaultLibrary() else {
-            fatalError("MetalTerminalRenderer: failed to load default Metal shader library")
-        }
-
-        guard let vertexFunction = library.makeFunction(name: "terminal_vertex") else {
-            fatalError("MetalTerminalRenderer: shader function 'terminal_vertex' not found")
-        }
-
-        guard let fragmentFunction = library.makeFunction(name: "terminal_fragment") else {
-            fatalError("MetalTerminalRenderer: shader function 'terminal_fragment' not found")
-        }
-        guard let postVertexFunction = library.makeFunction(name: "terminal_post_vertex") else {
-            fatalError("MetalTerminalRenderer: shader function 'terminal_post_vertex' not found")
-        }
-        guard let postFragmentFunction = library.makeFunction(name: "terminal_post_fragment") else {
-            fatalError("MetalTerminalRenderer: shader function 'terminal_post_fragment' not found")
-        }
-
-        let pipelineDescriptor = MTLRenderPipelineDescriptor()
-        pipelineDescriptor.label = "TerminalRenderPipeline"
-        pipelineDescriptor.vertexFunction = vertexFunction
-        pipelineDescriptor.fragmentFunction = fragmentFunction
-        pipelineDescriptor.colorAttachments[0].pixelFormat = .bgra8Unorm
-
-        // Enable alpha blending for glyph compositing over background.
-        pipelineDescriptor.colorAttachments[0].isBlendingEnabled = true
-        pipelineDescriptor.colorAttachments[0].rgbBlendOperation = .add
-        pipelineDescriptor.colorAttachments[0].alphaBlendOperation = .add
-        pipelineDescriptor.colorAttachments[0].sourceRGBBlendFactor = .sourceAlpha
-        pipelineDescriptor.colorAttachments[0].destinationRGBBlendFactor = .oneMinusSourceAlpha
-        pipelineDescriptor.colorAttachments[0].sourceAlphaBlendFactor = .one
-        pipelineDescriptor.colorAttachments[0].destinationAlphaBlendFactor = .oneMinusSourceAlpha
-
-        do {
-            self.pipelineState = try device.makeRenderPipelineState(descriptor: pipelineDescriptor)
-        } catch {
-            fatalError("MetalTerminalRenderer: failed to create pipeline state: \(error)")
-        }
-
-        let postPipelineDescriptor = MTLRenderPipelineDescriptor()
-        postPipelineDescriptor.label = "TerminalPostProcessPipeline"
-        postPipelineDescriptor.vertexFunction = postVertexFunction
-        postPipelineDescriptor.fragmentFunction = postFragmentFunction
-        postPipelineDescriptor.colorAttachments[0].pixelFormat = .bgra8Unorm
-
+        // B.8.2: Pipeline states, built once per device (see TerminalPipelineCache).
+        let pipelines: TerminalPipelines
         do {
-            self.postProcessPipelineState = try device.makeRenderPipelineState(descriptor: postPipelineDescriptor)
+            pipelines = try TerminalPipelineCache.shared.pipelines(for: device)
         } catch {
-            fatalError("MetalTerminalRenderer: failed to create post-process pipeline state: \(error)")
-        }
-
-        // Bloom pipelines (stub shaders in Phase 1; implemented in Phase 2–3).
-        if let brightVertex = library.makeFunction(name: "bloom_bright_vertex"),
-           let brightFragment = library.makeFunction(name: "bloom_bright_fragment") {
-            let brightDesc = MTLRenderPipelineDescriptor()
-            brightDesc.label = "BloomBrightPipeline"
-            brightDesc.vertexFunction = brightVertex
-            brightDesc.fragmentFunction = brightFragment
-            brightDesc.colorAttachments[0].pixelFormat = .bgra8Unorm
-            self.bloomBrightPipeline = try? device.makeRenderPipelineState(descriptor: brightDesc)
+            fatalError("MetalTerminalRenderer: failed to create pipeline states: \(error)")
         }
-
-        if let blurVertex = library.makeFunction(name: "bloom_blur_vertex"),
-           let blurFragment = library.makeFunction(name: "bloom_blur_fragment") {
-            let blurDesc = MTLRenderPipelineDescriptor()
-            blurDesc.label = "BloomBlurPipeline"
-            blurDesc.vertexFunction = blurVertex
-            blurDesc.fragmentFunction = blurFragment
-            blurDesc.colorAttachments[0].pixelFormat = .bgra8Unorm
-            let blurPipeline = try? device.makeRenderPipelineState(descriptor: blurDesc)
-            self.bloomBlurHPipeline = blurPipeline
-            self.bloomBlurVPipeline = blurPipeline  // same pipeline; direction via uniform in Phase 3
+        self.pipelineState = pipelines.scene
+        self.backgroundPipelineState = pipelines.background
+        self.postProcessPipelineState = pipelines.postProcess
+        self.performanceHUDPipeline = pipelines.performanceHUD
+        self.inlineImagePipeline = pipelines.inlineImage
+        self.thumbnailPipeline = pipelines.thumbnailDownsample
+        self.bloomBrightPipeline = pipelines.bloomBright
+        self.bloomBlurHPipeline = pipelines.bloomBlur
+        self.bloomBlurVPipeline = pipelines.bloomBlur  // same pipeline; direction via uniform in Phase 3
+        if let downsample = pipelines.bloomDownsample, let upsample = pipelines.bloomUpsample {
+            self.bloomChain = BloomChain(device: device, downsamplePipeline: downsample, upsamplePipeline: upsample)
+        } else {
+            self.bloomChain = nil
         }
 
         // Initialize cell dimensions synchronously from the font manager.
@@ -461,18 +666,24 @@ final class MetalTerminalRenderer: NSObject, MTKViewDelegate {
         self.cellWidth = initialCellWidth
         self.cellHeight = initialCellHeight
 
-        // Create glyph atlas with initial cell dimensions.
-        self.glyphAtlas = GlyphAtlas(
-            device: device,
-            cellWidth: Int(ceil(initialCellWidth)),
-            cellHeight: Int(ceil(initialCellHeight))
+        // Placeholder glyph storage until real font metrics arrive; nothing
+        // is rasterized into it before `isFontStateReady`.
+        self.glyphStorage = GlyphAtlasStore.shared.storage(
+            for: GlyphAtlasKey(
+                deviceID: device.registryID,
+                fontName: "",
+                fontSize: 0,
+                scale: 1,
+                cellWidth: Int(ceil(initialCellWidth)),
+                cellHeight: Int(ceil(initialCellHeight))
+            ),
+            device: device
         )
 
-        // Create glyph cache (larger capacity reduces churn for CJK/emoji-heavy output).
-        self.glyphCache = GlyphCache(maxCapacity: 8192)
-
         // Create cell buffer (lazy allocation on first update).
-        self.cellBuffer = CellBuffer(device: device)
+        self.cellBuffer = CellBuffer(device: device, bufferCount: Self.maxFramesInFlight)
+        self.drawLists = CellDrawListBuffer(device: device, bufferCount: Self.maxFramesInFlight)
+        self.cellExpansion = pipelines.cellExpansion.map { CellExpansionPass(device: device, pipelineState: $0) }
 
         // Create uniform buffer.
         guard let ub = TerminalUniformBuffer(device: device) else {
@@ -480,11 +691,19 @@ final class MetalTerminalRenderer: NSObject, MTKViewDelegate {
         }
         self.uniformBuffer = ub
 
+        let missLogs = (0..<Self.maxFramesInFlight).compactMap { _ in GlyphMissLog(device: device) }
+        guard missLogs.count == Self.maxFramesInFlight else {
+            fatalError("MetalTerminalRenderer: failed to allocate glyph miss logs")
+        }
+        self.glyphMissLogs = missLogs
+
         super.init()
 
-        // Wire eviction callback so the atlas can recycle freed regions.
-        glyphCache.onEvict = { [weak self] entry in
-            self?.glyphAtlas.reclaimRegion(entry: entry)
+        glyphStorage.addEvictionObserver(self)
+        powerPolicy = RenderPowerMonitor.shared.policy
+        RenderPowerMonitor.shared.add(self)
+        smoothScrollEngine.onScrollLineChange = { [weak self] lines in
+            self?.handleScrollLineChange(lines)
         }
 
         // Pre-populate ASCII glyphs asynchronously.
@@ -0,0 +1,254 @@
+// PerformanceHUDOverlay.swift
+// ProSSHV2
+//
+// Per-pane performance HUD, drawn inside the renderer's Metal pass so it
+// costs no SwiftUI work. Twice a second the overlay turns the pane's
+// pipeline counters and the renderer's own metrics into a few lines of
+// text. These are input and parse throughput, snapshot and deferral rates,
+// frame and GPU time, atlas occupancy, scrollback memory and the render
+// power tier (RenderPowerPolicy). It draws them with CoreText into a small
+// texture and composites that over the top-right corner of each frame.
+// Between refreshes a frame only adds one textured quad.
+//
+// Toggle via the pane's Display menu, or
+// `defaults write com.prossh terminal.renderer.performanceHUD.enabled -bool true`
+
+import AppKit
+import CoreText
+import Metal
+import QuartzCore
+
+// MARK: - Inputs
+
+/// Session-side totals the HUD reads on each refresh.
+nonisolated struct PerformanceHUDSessionStats: Sendable, Equatable {
+    /// Bytes received from the channel so far.
+    var receivedBytes: Int64 = 0
+    var pipeline = SessionPipelineCounters.Totals()
+    /// Estimated scrollback memory; nil until first measured.
+    var scrollbackBytes: Int?
+}
+
+/// Rates between two HUD refreshes.
+nonisolated struct PerformanceHUDRates: Sendable, Equatable {
+    var inputMBps: Double = 0
+    /// Parse throughput while busy: bytes fed per second spent in the engine.
+    var parseMBps: Double?
+    /// Fraction of wall time the parser spent feeding.
+    var parserBusy: Double = 0
+    var snapshotsPerSecond: Double = 0
+    var deferralsPerSecond: Double = 0
+
+    init() {}
+
+    init(from earlier: PerformanceHUDSessionStats, to later: PerformanceHUDSessionStats, seconds: Double) {
+        guard seconds > 0 else { return }
+        let megabyte = 1_048_576.0
+        let parsedBytes = Double(later.pipeline.parsedBytes &- earlier.pipeline.parsedBytes)
+        let parseSeconds = max(0, later.pipeline.parseSeconds - earlier.pipeline.parseSeconds)
+        inputMBps = Double(max(0, later.receivedBytes - earlier.receivedBytes)) / megabyte / seconds
+        parseMBps = parseSeconds > 0 ? parsedBytes / megabyte / parseSeconds : nil
+        parserBusy = min(1, parseSeconds / seconds)
+        snapshotsPerSecond = Double(later.pipeline.snapshotsPublished &- earlier.pipeline.snapshotsPublished) / seconds
+        deferralsPerSecond = Double(later.pipeline.publishDeferrals &- earlier.pipeline.publishDeferrals) / seconds
+    }
+}
+
+// MARK: - PerformanceHUDOverlay
+
+final class PerformanceHUDOverlay {
+
+    static let enabledDefaultsKey = "terminal.renderer.performanceHUD.enabled"
+
+    static func loadEnabledFromDefaults(_ defaults: UserDefaults = .standard) -> Bool {
+        defaults.bool(forKey: enabledDefaultsKey)
+    }
+
+    /// Seconds between text refreshes.
+    static let refreshInterval: CFTimeInterval = 0.5
+
+    private static let width: CGFloat = 236
+    private static let lineHeight: CGFloat = 14
+    private static let padding: CGFloat = 6
+    private static let margin: CGFloat = 8
+
+    private let device: MTLDevice
+    /// Two textures, alternated per refresh, so a refresh never rewrites the
+    /// one frames still in flight sample.
+    private var textures: [MTLTexture?] = [nil, nil]
+    private var textureIndex = 0
+    private var current: MTLTexture?
+
+    private var lastRefreshAt: CFTimeInterval = -.infinity
+    private var previousStats: (time: CFTimeInterval, stats: PerformanceHUDSessionStats)?
+
+    /// Text shown by the last refresh.
+    private(set) var lines: [String] = []
+
+    init(device: MTLDevice) {
+        self.device = device
+    }
+
+    /// Whether `refresh` would redraw the text at `now`.
+    func isRefreshDue(at now: CFTimeInterval) -> Bool {
+        now - lastRefreshAt >= Self.refreshInterval
+    }
+
+    /// Rebuild the text and texture from the latest inputs.
+    func refresh(
+        now: CFTimeInterval,
+        stats: PerformanceHUDSessionStats?,
+        performance: RendererPerformanceSnapshot,
+        atlas: GlyphAtlas.Occupancy,
+        power: RenderPowerPolicy? = nil,
+        scale: CGFloat
+    ) {
+        lastRefreshAt = now
+        var rates: PerformanceHUDRates?
+        if let stats {
+            if let previousStats {
+                rates = PerformanceHUDRates(from: previousStats.stats, to: stats, seconds: now - previousStats.time)
+            }
+            previousStats = (now, stats)
+        }
+        lines = Self.lines(stats: stats, rates: rates, performance: performance, atlas: atlas, power: power)
+        current = draw(lines, scale: max(scale, 1))
+    }
+
+    /// Composite the HUD over `target`, which already holds the frame.
+    /// Returns the number of draw calls encoded.
+    func encode(commandBuffer: MTLCommandBuffer, target: MTLTexture, pipeline: MTLRenderPipelineState, scale: CGFloat) -> Int {
+        guard let texture = current, target.width > 0, target.height > 0 else { return 0 }
+        let descriptor = MTLRenderPassDescriptor()
+        descriptor.colorAttachments[0].texture = target
+        descriptor.colorAttachments[0].loadAction = .load
+        descriptor.colorAttachments[0].storeAction = .store
+        guard let encoder = commandBuffer.makeRenderCommandEncoder(descriptor: descriptor) else { return 0 }
+        encoder.label = "PerformanceHUDEncoder"
+
+        // Top-right corner, in pixels, then NDC.
+        let margin = Float(Self.margin * max(scale, 1))
+        let targetWidth = Float(target.width)
+        let targetHeight = Float(target.height)
+        let right = targetWidth - margin
+        let left = max(0, right - Float(texture.width))
+        let top = margin
+        let bottom = min(targetHeight, top + Float(texture.height))
+        var rect = SIMD4<Float>(
+            left / targetWidth * 2 - 1,
+            1 - top / targetHeight * 2,
+            right / targetWidth * 2 - 1,
+            1 - bottom / targetHeight * 2
+        )
+
+        encoder.setRenderPipelineState(pipeline)
+        encoder.setVertexBytes(&rect, length: MemoryLayout<SIMD4<Float>>.stride, index: 0)
+        encoder.setFragmentTexture(texture, index: 0)
+        encoder.drawPrimitives(type: .triangleStrip, vertexStart: 0, vertexCount: 4)
+        encoder.endEncoding()
+        return 1
+    }
+
+    // MARK: - Text
+
+    /// The HUD lines. Session lines are left out for panes without stats;
+    /// rates need two refreshes.
+    static func lines(
+        stats: PerformanceHUDSessionStats?,
+        rates: PerformanceHUDRates?,
+        performance: RendererPerformanceSnapshot,
+        atlas: GlyphAtlas.Occupancy,
+        power: RenderPowerPolicy? = nil
+    ) -> [String] {
+        var lines: [String] = []
+        if stats != nil {
+            let rates = rates ?? PerformanceHUDRates()
+            lines.append(String(format: "in     %7.2f MB/s", rates.inputMBps))
+            lines.append(rates.parseMBps.map {
+                String(format: "parse  %7.1f MB/s  busy %3.0f%%", $0, rates.parserBusy * 100)
+            } ?? "parse        -  MB/s  busy   0%")
+            lines.append(String(format: "snap   %7.1f /s    defer %4.1f/s", rates.snapshotsPerSecond, rates.deferralsPerSecond))
+        }
+        lines.append(String(format: "frame  p95 %5.2f ms  avg %5.2f", performance.p95CPUFrameMs, performance.averageCPUFrameMs))
+        if let gpuAverage = performance.averageGPUFrameMs, let gpuP95 = performance.p95GPUFrameMs {
+            lines.append(String(format: "gpu    p95 %5.2f ms  avg %5.2f", gpuP95, gpuAverage))
+        } else {
+            lines.append("gpu    -")
+        }
+        lines.append(String(format: "atlas  %3.0f%% of %d page%@", atlas.utilization * 100, atlas.pages, atlas.pages == 1 ? "" : "s"))
+        if let stats {
+            lines.append(stats.scrollbackBytes.map {
+                String(format: "scroll %7.1f MB", Double($0) / 1_048_576)
+            } ?? "scroll -")
+        }
+        if let power {
+            lines.append(power.maxFPS > 0
+                ? "power  \(power.tier.label)  cap \(power.maxFPS) fps"
+                : "power  \(power.tier.label)")
+        }
+        return lines
+    }
+
+    // MARK: - Texture
+
+    private func draw(_ lines: [String], scale: CGFloat) -> MTLTexture? {
+        let width = Int((Self.width * scale).rounded(.up))
+        let height = Int(((CGFloat(lines.count) * Self.lineHeight + Self.padding * 2) * scale).rounded(.up))
+        guard width > 0, height > 0 else { return nil }
+
+        textureIndex = (textureIndex + 1) % textures.count
+        var texture = textures[textureIndex]
+        if texture?.width != width || texture?.height != height {
+            let descriptor = MTLTextureDescriptor.texture2DDescriptor(
+                pixelFormat: .bgra8Unorm,
+                width: width,
+                height: height,
+                mipmapped: false
+            )
+            descriptor.usage = .shaderRead
+            descriptor.storageMode = .shared
+            texture = device.makeTexture(descriptor: descriptor)
+            texture?.label = "PerformanceHUDTexture"
+            textures[textureIndex] = texture
+        }
+        guard let texture else { return nil }
+
+        let bytesPerRow = width * 4
+        guard let context = CGContext(
+            data: nil,
+            width: width,
+            height: height,
+            bitsPerComponent: 8,
+            bytesPerRow: bytesPerRow,
+            space: CGColorSpaceCreateDeviceRGB(),
+            bitmapInfo: CGImageAlphaInfo.premultipliedFirst.rawValue | CGBitmapInfo.byteOrder32Little.rawValue
+        ) else { return nil }
+
+        context.scaleBy(x: scale, y: scale)
+        let bounds = CGRect(x: 0, y: 0, width: CGFloat(width) / scale, height: CGFloat(height) / scale)
+        context.setFillColor(CGColor(red: 0, green: 0, blue: 0, alpha: 0.72))
+        context.addPath(CGPath(roundedRect: bounds, cornerWidth: 5, cornerHeight: 5, transform: nil))
+        context.fillPath()
+
+        let font = NSFont.monospacedSystemFont(ofSize: 10.5, weight: .medium)
+        let attributes: [NSAttributedString.Key: Any] = [
+            .font: font,
+            .foregroundColor: NSColor(calibratedRed: 0.75, green: 1.0, blue: 0.78, alpha: 1),
+        ]
+        for (index, line) in lines.enumerated() {
+            let ctLine = CTLineCreateWithAttributedString(NSAttributedString(string: line, attributes: attributes))
+            let baseline = bounds.height - Self.padding - CGFloat(index + 1) * Self.lineHeight + (Self.lineHeight - font.ascender + font.descender) / 2
+            context.textPosition = CGPoint(x: Self.padding + 2, y: baseline)
+            CTLineDraw(ctLine, context)
+        }
+
+        guard let data = context.data else { return nil }
+        texture.replace(
+            region: MTLRegionMake2D(0, 0, width, height),
+            mipmapLevel: 0,
+            withBytes: data,
+            bytesPerRow: bytesPerRow
+        )
+        return texture
+    }
+}
@@ -0,0 +1,192 @@
+// RenderPowerPolicy.swift
+// ProSSHV2
+//
+// How much the renderer may spend on frames, given the power source, Low
+// Power Mode and thermal pressure. The draw loop, bloom, gradient animation,
+// the scanner sweep and cursor blink used to run at full rate on battery
+// too, and a few panes with effects enabled cost noticeable battery life.
+//
+// The tiers, from most to least generous:
+// - full: on power adapter, no thermal pressure. Nothing is limited.
+// - battery: on battery. Frames are capped at 60 fps. Animated effects
+//   (gradient motion, the scanner sweep, the bloom pulse) hold still, so
+//   frames are drawn only when content changes. Bloom is built at quarter
+//   resolution.
+// - saver: Low Power Mode or `.serious` thermal state. As battery, but
+//   capped at 30 fps.
+// - minimal: `.critical` thermal state. As saver, with bloom at an eighth
+//   of the resolution and a steady cursor.
+//
+// SessionRenderBudget still sets each pane's rate by focus; the policy only
+// caps it. RenderPowerMonitor resolves the tier and tells the renderers.
+
+import Foundation
+import IOKit.ps
+import os.log
+
+// MARK: - RenderPowerTier
+
+nonisolated enum RenderPowerTier: Int, Sendable, Comparable, CaseIterable {
+    case minimal
+    case saver
+    case battery
+    case full
+
+    static func < (lhs: RenderPowerTier, rhs: RenderPowerTier) -> Bool {
+        lhs.rawValue < rhs.rawValue
+    }
+
+    /// Short name for the performance HUD.
+    var label: String {
+        switch self {
+        case .full: return "full"
+        case .battery: return "battery"
+        case .saver: return "saver"
+        case .minimal: return "minimal"
+        }
+    }
+}
+
+// MARK: - RenderPowerPolicy
+
+nonisolated struct RenderPowerPolicy: Sendable, Equatable {
+    let tier: RenderPowerTier
+
+    /// Frame rate ceiling; 0 leaves the pane's own rate alone.
+    var maxFPS: Int {
+        switch tier {
+        case .full: return 0
+        case .battery: return 60
+        case .saver, .minimal: return 30
+        }
+    }
+
+    /// Whether time-driven effects animate and keep the display link
+    /// running. When false they hold their look, and frames are drawn
+    /// only for content changes.
+    var animatesEffects: Bool { tier == .full }
+
+    /// Divisor from the drawable to the first bloom level.
+    var bloomDownsample: Int {
+        switch tier {
+        case .full: return 2
+        case .battery, .saver: return 4
+        case .minimal: return 8
+        }
+    }
+
+    /// Whether a blinking cursor blinks.
+    var blinksCursor: Bool { tier != .minimal }
+
+    static let full = RenderPowerPolicy(tier: .full)
+
+    /// The policy for the given conditions.
+    static func resolve(
+        isLowPowerModeEnabled: Bool,
+        isOnBattery: Bool,
+        thermalState: ProcessInfo.ThermalState
+    ) -> RenderPowerPolicy {
+        switch thermalState {
+        case .critical:
+            return RenderPowerPolicy(tier: .minimal)
+        case .serious:
+            return RenderPowerPolicy(tier: .saver)
+        default:
+            break
+        }
+        if isLowPowerModeEnabled {
+            return RenderPowerPolicy(tier: .saver)
+        }
+        return RenderPowerPolicy(tier: isOnBattery ? .battery : .full)
+    }
+
+    /// `fps` (0 for the display's native rate) under the ceiling.
+    func cappedFPS(_ fps: Int) -> Int {
+        guard maxFPS > 0 else { return fps }
+        return fps <= 0 ? maxFPS : min(fps, maxFPS)
+    }
+}
+
+// MARK: - RenderPowerClient
+
+/// A renderer that follows the power policy. Implemented by
+/// MetalTerminalRenderer.
+protocol RenderPowerClient: AnyObject {
+    func renderPowerPolicyDidChange(_ policy: RenderPowerPolicy)
+}
+
+// MARK: - RenderPowerMonitor
+
+/// Watches Low Power Mode, the power source and the thermal state, and
+/// tells its clients when the resolved policy changes. Runs on the main
+/// actor (the project default).
+final class RenderPowerMonitor {
+
+    static let shared = RenderPowerMonitor()
+
+    private struct WeakClient {
+        weak var client: RenderPowerClient?
+    }
+
+    private(set) var policy: RenderPowerPolicy = .full
+    private var clients: [ObjectIdentifier: WeakClient] = [:]
+    private var observers: [NSObjectProtocol] = []
+    private var powerSourceLoop: CFRunLoopSource?
+
+    private static let logger = Logger(subsystem: "com.prossh", category: "RenderPower")
+
+    private init() {
+        for name in [Notification.Name.NSProcessInfoPowerStateDidChange, ProcessInfo.thermalStateDidChangeNotification] {
+            observers.append(NotificationCenter.default.addObserver(forName: name, object: nil, queue: .main) { [weak self] _ in
+                MainActor.assumeIsolated {
+                    self?.refresh()
+                }
+            })
+        }
+        // Power source changes arrive on the main run loop.
+        if let source = IOPSNotificationCreateRunLoopSource({ _ in
+            MainActor.assumeIsolated {
+                RenderPowerMonitor.shared.refresh()
+            }
+        }, nil)?.takeRetainedValue() {
+            CFRunLoopAddSource(CFRunLoopGetMain(), source, .defaultMode)
+            powerSourceLoop = source
+        }
+        policy = Self.currentPolicy()
+    }
+
+    func add(_ client: RenderPowerClient) {
+        clients[ObjectIdentifier(client)] = WeakClient(client: client)
+    }
+
+    func remove(_ client: RenderPowerClient) {
+        clients.removeValue(forKey: ObjectIdentifier(client))
+    }
+
+    /// Re-read the conditions and notify clients if the policy changed.
+    func refresh() {
+        let updated = Self.currentPolicy()
+        guard updated != policy else { return }
+        Self.logger.info("render_power tier=\(updated.tier.label, privacy: .public)")
+        policy = updated
+        clients = clients.filter { $0.value.client != nil }
+        for entry in clients.values {
+            entry.client?.renderPowerPolicyDidChange(updated)
+        }
+    }
+
+    private static func currentPolicy() -> RenderPowerPolicy {
+        let info = ProcessInfo.processInfo
+        return RenderPowerPolicy.resolve(
+            isLowPowerModeEnabled: info.isLowPowerModeEnabled,
+            isOnBattery: isOnBattery(),
+            thermalState: info.thermalState
+        )
+    }
+
+    private static func isOnBattery() -> Bool {
+        guard let info = IOPSCopyPowerSourcesInfo()?.takeRetainedValue(),
+              let type = IOPSGetProvidingPowerSourceType(info)?.takeUnretainedValue() else { return false }
+        return (type as String) == kIOPMBatteryPowerKey
+    }
+}
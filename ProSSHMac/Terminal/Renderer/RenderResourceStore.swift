@@ -0,0 +1,141 @@
+// RenderResourceStore.swift
+// ProSSHV2
+//
+// GPU resources shared by every pane's renderer on a device: one command
+// queue, the thumbnail atlas, and the transient post-processing render
+// targets (the offscreen scene texture and the half-resolution bloom
+// textures). A 3x3 layout of
+// equal panes used to allocate nine queues and nine sets of full-size
+// effect targets; panes of the same drawable size now share one set.
+//
+// Sharing the targets is safe because every renderer encodes on the same
+// queue: command buffers execute in commit order and Metal's hazard
+// tracking orders one pane's writes after another's reads. Per-pane state
+// that must persist between frames (the phosphor history texture, the
+// cached bloom result) stays with each renderer.
+//
+// Runs on the main actor (the project default), as do the renderers.
+
+import Metal
+
+// MARK: - EffectTargetKey
+
+struct EffectTargetKey: Hashable {
+    enum Kind: Hashable {
+        /// Full-size offscreen scene texture for post-processing input.
+        case scene
+        /// Bloom bright pass, horizontal and vertical blur (half size).
+        case bloom
+        /// Compute bloom downsample chain, half size and smaller.
+        case bloomChain
+    }
+
+    let deviceID: UInt64
+    let kind: Kind
+    let width: Int
+    let height: Int
+}
+
+// MARK: - SharedEffectTargets
+
+/// A set of render targets, alive as long as any renderer holds it.
+final class SharedEffectTargets {
+    let key: EffectTargetKey
+
+    /// `.scene`: one texture. `.bloom`: bright, blur H, blur V.
+    /// `.bloomChain`: one texture per `BloomChain.levelSizes` level.
+    let textures: [MTLTexture]
+
+    init?(key: EffectTargetKey, device: MTLDevice) {
+        let sizes: [SIMD2<Int>]
+        switch key.kind {
+        case .scene:
+            sizes = [SIMD2(key.width, key.height)]
+        case .bloom:
+            sizes = Array(repeating: SIMD2(key.width, key.height), count: 3)
+        case .bloomChain:
+            sizes = BloomChain.levelSizes(width: key.width, height: key.height)
+        }
+        var textures: [MTLTexture] = []
+        for (index, size) in sizes.enumerated() {
+            let descriptor: MTLTextureDescriptor
+            if key.kind == .bloomChain {
+                descriptor = BloomChain.levelDescriptor(size)
+            } else {
+                descriptor = MTLTextureDescriptor.texture2DDescriptor(
+                    pixelFormat: .bgra8Unorm,
+                    width: size.x,
+                    height: size.y,
+                    mipmapped: false
+                )
+                descriptor.usage = [.renderTarget, .shaderRead]
+            }
+            descriptor.storageMode = .private
+            descriptor.resourceOptions = .storageModePrivate
+            guard let texture = device.makeTexture(descriptor: descriptor) else { return nil }
+            texture.label = key.kind == .scene ? "SharedSceneTarget" : "SharedBloomTarget[\(index)]"
+            textures.append(texture)
+        }
+        self.key = key
+        self.textures = textures
+    }
+}
+
+// MARK: - RenderResourceStore
+
+final class RenderResourceStore {
+
+    static let shared = RenderResourceStore()
+
+    private struct WeakTargets {
+        weak var targets: SharedEffectTargets?
+    }
+
+    private var queues: [UInt64: MTLCommandQueue] = [:]
+    private var targets: [EffectTargetKey: WeakTargets] = [:]
+    private var thumbnailAtlases: [UInt64: SessionThumbnailAtlas] = [:]
+
+    /// Number of target sets still alive.
+    var liveTargetCount: Int {
+        targets.values.filter { $0.targets != nil }.count
+    }
+
+    /// The command queue every renderer on `device` encodes on.
+    func commandQueue(for device: MTLDevice) -> MTLCommandQueue? {
+        if let queue = queues[device.registryID] {
+            return queue
+        }
+        guard let queue = device.makeCommandQueue() else { return nil }
+        queue.label = "TerminalRenderQueue"
+        queues[device.registryID] = queue
+        return queue
+    }
+
+    /// The atlas every renderer on `device` downsamples thumbnails into.
+    func thumbnailAtlas(for device: MTLDevice) -> SessionThumbnailAtlas? {
+        if let atlas = thumbnailAtlases[device.registryID] {
+            return atlas
+        }
+        guard let atlas = SessionThumbnailAtlas(device: device) else { return nil }
+        thumbnailAtlases[device.registryID] = atlas
+        return atlas
+    }
+
+    /// Targets of `kind` at `width` x `height`, created if no renderer holds
+    /// them. Nil if the textures cannot be allocated.
+    func effectTargets(
+        _ kind: EffectTargetKey.Kind,
+        width: Int,
+        height: Int,
+        device: MTLDevice
+    ) -> SharedEffectTargets? {
+        let key = EffectTargetKey(deviceID: device.registryID, kind: kind, width: width, height: height)
+        if let existing = targets[key]?.targets {
+            return existing
+        }
+        targets = targets.filter { $0.value.targets != nil }
+        guard let created = SharedEffectTargets(key: key, device: device) else { return nil }
+        targets[key] = WeakTargets(targets: created)
+        return created
+    }
+}
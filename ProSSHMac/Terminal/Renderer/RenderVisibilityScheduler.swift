@@ -0,0 +1,134 @@
+// RenderVisibilityScheduler.swift
+// ProSSHV2
+//
+// Decides which panes may draw. Before this, a renderer paused only through
+// `setPaused` (SwiftUI appear/disappear) or the draw loop's idle early
+// exit. Panes in minimized windows, in windows fully covered by other
+// apps, or on sleeping displays kept their cursor-blink loops running and
+// redrew on every snapshot publish.
+//
+// The scheduler observes window occlusion and display/session sleep. Each
+// renderer combines that with its host visibility (`setPaused`). A pane
+// that may not draw pauses its view, leaves the blink clock and ignores frame
+// requests. Snapshots keep arriving and only replace the renderer's
+// pending snapshot, so a revealed pane draws the current state on its
+// first frame.
+//
+// Runs on the main actor (the project default), as do the renderers.
+
+import AppKit
+
+// MARK: - RenderVisibilityClient
+
+/// A pane whose drawing follows the scheduler. Implemented by
+/// MetalTerminalRenderer.
+protocol RenderVisibilityClient: AnyObject {
+    /// Window the pane is presented in; nil while detached.
+    var renderWindow: NSWindow? { get }
+
+    /// Re-evaluate visibility after an occlusion or sleep change.
+    func updateRenderVisibility()
+}
+
+// MARK: - RenderVisibilityScheduler
+
+final class RenderVisibilityScheduler {
+
+    static let shared = RenderVisibilityScheduler()
+
+    private struct WeakClient {
+        weak var client: RenderVisibilityClient?
+    }
+
+    private var clients: [ObjectIdentifier: WeakClient] = [:]
+
+    /// Notification observer tokens. Marked `nonisolated(unsafe)` so deinit
+    /// can remove them without crossing the MainActor isolation boundary.
+    nonisolated(unsafe) private var observers: [(NotificationCenter, NSObjectProtocol)] = []
+
+    /// Displays are asleep or the login session is inactive.
+    private(set) var displaysAsleep = false
+
+    /// Number of registered clients still alive.
+    var liveClientCount: Int {
+        clients.values.filter { $0.client != nil }.count
+    }
+
+    init(
+        notificationCenter: NotificationCenter = .default,
+        workspaceNotificationCenter: NotificationCenter = NSWorkspace.shared.notificationCenter
+    ) {
+        observe(notificationCenter, NSWindow.didChangeOcclusionStateNotification) { scheduler, note in
+            scheduler.refresh(window: note.object as? NSWindow)
+        }
+        for name in [NSWorkspace.screensDidSleepNotification, NSWorkspace.sessionDidResignActiveNotification] {
+            observe(workspaceNotificationCenter, name) { scheduler, _ in
+                scheduler.setDisplaysAsleep(true)
+            }
+        }
+        for name in [NSWorkspace.screensDidWakeNotification, NSWorkspace.sessionDidBecomeActiveNotification] {
+            observe(workspaceNotificationCenter, name) { scheduler, _ in
+                scheduler.setDisplaysAsleep(false)
+            }
+        }
+    }
+
+    deinit {
+        for (center, observer) in observers {
+            center.removeObserver(observer)
+        }
+    }
+
+    // MARK: - Clients
+
+    func register(_ client: RenderVisibilityClient) {
+        clients = clients.filter { $0.value.client != nil }
+        clients[ObjectIdentifier(client)] = WeakClient(client: client)
+    }
+
+    func unregister(_ client: RenderVisibilityClient) {
+        clients.removeValue(forKey: ObjectIdentifier(client))
+    }
+
+    // MARK: - Visibility
+
+    /// Whether a pane whose host shows it (`hostVisible`) may draw in `window`.
+    /// A detached pane has no occlusion state and counts as visible.
+    func shouldRender(hostVisible: Bool, window: NSWindow?) -> Bool {
+        guard hostVisible, !displaysAsleep else { return false }
+        guard let window else { return true }
+        return window.occlusionState.contains(.visible)
+    }
+
+    // MARK: - Internals
+
+    private func observe(
+        _ center: NotificationCenter,
+        _ name: Notification.Name,
+        handler: @escaping @MainActor (RenderVisibilityScheduler, Notification) -> Void
+    ) {
+        let observer = center.addObserver(forName: name, object: nil, queue: .main) { [weak self] note in
+            MainActor.assumeIsolated {
+                guard let self else { return }
+                handler(self, note)
+            }
+        }
+        observers.append((center, observer))
+    }
+
+    private func setDisplaysAsleep(_ asleep: Bool) {
+        guard displaysAsleep != asleep else { return }
+        displaysAsleep = asleep
+        refresh(window: nil)
+    }
+
+    /// Re-evaluate the clients in `window`, or every client when nil.
+    private func refresh(window: NSWindow?) {
+        for entry in clients.values {
+            guard let client = entry.client else { continue }
+            if window == nil || client.renderWindow === window {
+                client.updateRenderVisibility()
+            }
+        }
+    }
+}
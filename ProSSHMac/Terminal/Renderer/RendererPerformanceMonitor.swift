@@ -11,10 +11,21 @@ struct RendererPerformanceSnapshot: Sendable {
     let totalFrames: Int
     let averageCPUFrameMs: Double
     let p95CPUFrameMs: Double
+    /// GPU time per frame from the command buffer's `gpuStartTime` and
+    /// `gpuEndTime`; nil until a frame completed.
     let averageGPUFrameMs: Double?
+    let p95GPUFrameMs: Double?
     let dropped120HzFrames: Int
     let dropped60HzFrames: Int
     let lastDrawCallCount: Int
+    /// Keystroke-to-present latency of echoed input, sampled in low-latency
+    /// input mode (see InputEchoTracker). Nil until an echo was presented.
+    let averageInputLatencyMs: Double?
+    let p95InputLatencyMs: Double?
+    /// Time a frame spent blocked before it could encode: waiting for an
+    /// in-flight slot and for the next drawable. Nil until a frame drew.
+    let averageDrawableWaitMs: Double?
+    let p95DrawableWaitMs: Double?
 }
 
 /// Fixed-size ring buffer for frame time samples.
@@ -58,6 +69,7 @@ private struct RingBuffer {
 final class RendererPerformanceMonitor: @unchecked Sendable {
 
     private let sampleWindow = 240
+    private let inputLatencySampleWindow = 64
     private let log = OSLog(subsystem: "nl.budgetsoft.ProSSHV2", category: "TerminalRenderer")
 
     // Lock protecting all mutable state below.
@@ -65,6 +77,8 @@ final class RendererPerformanceMonitor: @unchecked Sendable {
 
     private var cpuFrameSamples: RingBuffer
     private var gpuFrameSamples: RingBuffer
+    private var inputLatencySamples: RingBuffer
+    private var drawableWaitSamples: RingBuffer
 
     private var _totalFrames: Int = 0
     private var _dropped120HzFrames: Int = 0
@@ -74,6 +88,8 @@ final class RendererPerformanceMonitor: @unchecked Sendable {
     init() {
         cpuFrameSamples = RingBuffer(capacity: sampleWindow)
         gpuFrameSamples = RingBuffer(capacity: sampleWindow)
+        inputLatencySamples = RingBuffer(capacity: inputLatencySampleWindow)
+        drawableWaitSamples = RingBuffer(capacity: sampleWindow)
     }
 
     @discardableResult
@@ -128,10 +144,52 @@ final class RendererPerformanceMonitor: @unchecked Sendable {
         #endif
     }
 
+    /// Record a completed command buffer's GPU time, as measured by its
+    /// `gpuStartTime` and `gpuEndTime`.
+    func recordGPUFrame(seconds: CFTimeInterval) {
+        guard seconds > 0, seconds.isFinite else { return }
+        lock.lock()
+        gpuFrameSamples.append(seconds * 1000.0)
+        lock.unlock()
+    }
+
+    /// Record the time from a keystroke to the presentation of its echo.
+    func recordInputLatency(seconds: CFTimeInterval) {
+        guard seconds >= 0, seconds.isFinite else { return }
+        lock.lock()
+        inputLatencySamples.append(seconds * 1000.0)
+        lock.unlock()
+    }
+
+    /// Record how long a frame waited for an in-flight slot and a drawable.
+    func recordDrawableWait(seconds: CFTimeInterval) {
+        guard seconds >= 0, seconds.isFinite else { return }
+        lock.lock()
+        drawableWaitSamples.append(seconds * 1000.0)
+        lock.unlock()
+    }
+
+    /// Discard every sample and counter, so the next snapshot covers only
+    /// frames drawn from now on.
+    func reset() {
+        lock.lock()
+        cpuFrameSamples = RingBuffer(capacity: sampleWindow)
+        gpuFrameSamples = RingBuffer(capacity: sampleWindow)
+        inputLatencySamples = RingBuffer(capacity: inputLatencySampleWindow)
+        drawableWaitSamples = RingBuffer(capacity: sampleWindow)
+        _totalFrames = 0
+        _dropped120HzFrames = 0
+        _dropped60HzFrames = 0
+        _lastDrawCallCount = 0
+        lock.unlock()
+    }
+
     func snapshot() -> RendererPerformanceSnapshot {
         lock.lock()
         let cpuValues = cpuFrameSamples.toArray()
         let gpuValues = gpuFrameSamples.toArray()
+        let latencyValues = inputLatencySamples.toArray()
+        let waitValues = drawableWaitSamples.toArray()
         let totalFrames = _totalFrames
         let dropped120 = _dropped120HzFrames
         let dropped60 = _dropped60HzFrames
@@ -143,9 +201,14 @@ final class RendererPerformanceMonitor: @unchecked Sendable {
             averageCPUFrameMs: Self.average(cpuValues) ?? 0,
             p95CPUFrameMs: Self.percentile(cpuValues, p: 0.95) ?? 0,
             averageGPUFrameMs: Self.average(gpuValues),
+            p95GPUFrameMs: Self.percentile(gpuValues, p: 0.95),
             dropped120HzFrames: dropped120,
             dropped60HzFrames: dropped60,
-            lastDrawCallCount: drawCalls
+            lastDrawCallCount: drawCalls,
+            averageInputLatencyMs: Self.average(latencyValues),
+            p95InputLatencyMs: Self.percentile(latencyValues, p: 0.95),
+            averageDrawableWaitMs: Self.average(waitValues),
+            p95DrawableWaitMs: Self.percentile(waitValues, p: 0.95)
         )
     }
 
@@ -1,99 +1,417 @@
 // RendererStressHarness.swift
 // ProSSHV2
 //
-// Synthetic renderer flood harness for performance validation (B.12.4).
+// Synthetic renderer stress harness for performance validation (B.12.4).
+//
+// Each run submits snapshots with one damage pattern, one per drawn frame,
+// so the renderer's damage tracking, scene cache and post-processing reuse
+// see the same shape of change a real session produces. Patterns range from
+// a full-screen flood to a single status line, cursor-only moves, a one-line
+// scroll, 10% random cells and a CJK/emoji glyph-miss storm. `runSuite`
+// repeats every pattern with post-processing off and with each effect on.
+// Results include CPU frame time, GPU time from command buffer timestamps
+// and the time frames spent waiting for an in-flight slot and a drawable.
+//
+// Run on an idle session: live output reaching the same renderer competes
+// with the harness snapshots. Debug builds offer it from the terminal
+// context menu ("Run Renderer Stress Test").
 
 import Foundation
 import QuartzCore
 
+/// Which cells change between consecutive stress snapshots.
+enum RendererStressPattern: String, CaseIterable, Sendable {
+    /// Every cell changes every frame.
+    case fullScreenFlood
+    /// Only the bottom row changes, like a clock or status bar.
+    case statusLine
+    /// No cell changes; the cursor moves one column per frame.
+    case cursorOnly
+    /// The screen scrolls up one line and a new bottom line appears.
+    case scrollByOne
+    /// A random 10% of cells change.
+    case randomCells
+    /// Rows of CJK and emoji the glyph cache has not seen yet.
+    case glyphMissStorm
+}
+
+/// Post-processing enabled for a stress run.
+enum RendererStressEffect: String, CaseIterable, Sendable {
+    case none
+    case crt
+    case gradient
+    case solidBackground
+    case scanner
+    case bloom
+}
+
 /// Result of a synthetic renderer stress run.
 struct RendererStressResult: Sendable {
+    let pattern: RendererStressPattern
+    let effect: RendererStressEffect
     let framesSubmitted: Int
+    /// Frames the renderer drew during the run.
+    let framesRendered: Int
     let durationSeconds: Double
     let averageCPUFrameMs: Double
     let p95CPUFrameMs: Double
+    /// From `gpuStartTime` / `gpuEndTime`; nil when no frame completed.
+    let averageGPUFrameMs: Double?
+    let p95GPUFrameMs: Double?
+    /// In-flight slot plus drawable acquisition.
+    let averageDrawableWaitMs: Double?
+    let p95DrawableWaitMs: Double?
     let dropped120HzFrames: Int
     let dropped60HzFrames: Int
 }
 
-/// Generates high-churn terminal snapshots and submits them to the renderer.
+/// Generates terminal snapshots with realistic damage and submits them to the renderer.
 @MainActor
 enum RendererStressHarness {
 
+    /// Longest wait for the renderer to draw a submitted snapshot before
+    /// the next one is submitted anyway (the view may be paused or hidden).
+    private static let frameTimeoutSeconds = 0.25
+
+    /// Run one pattern with one effect. The renderer's effect settings and
+    /// last snapshot are restored afterwards. Defaults to the renderer's
+    /// current grid size.
     static func run(
         renderer: MetalTerminalRenderer,
-        columns: Int = 240,
-        rows: Int = 70,
+        pattern: RendererStressPattern = .fullScreenFlood,
+        effect: RendererStressEffect = .none,
+        columns: Int? = nil,
+        rows: Int? = nil,
         durationSeconds: Double = 5.0
     ) async -> RendererStressResult {
+        let restore = EffectState(renderer)
+        let original = renderer.latestSnapshot
+        defer {
+            restore.apply(to: renderer)
+            if let original { renderer.updateSnapshot(original) }
+        }
+        return await measure(
+            renderer: renderer,
+            pattern: pattern,
+            effect: effect,
+            columns: columns ?? original?.columns ?? 240,
+            rows: rows ?? original?.rows ?? 70,
+            durationSeconds: durationSeconds
+        )
+    }
+
+    /// Every pattern with post-processing off, then with each effect on.
+    static func runSuite(
+        renderer: MetalTerminalRenderer,
+        patterns: [RendererStressPattern] = RendererStressPattern.allCases,
+        effects: [RendererStressEffect] = RendererStressEffect.allCases,
+        durationSeconds: Double = 2.0
+    ) async -> [RendererStressResult] {
+        let restore = EffectState(renderer)
+        let original = renderer.latestSnapshot
+        defer {
+            restore.apply(to: renderer)
+            if let original { renderer.updateSnapshot(original) }
+        }
+
+        var results: [RendererStressResult] = []
+        for effect in effects {
+            for pattern in patterns {
+                results.append(await measure(
+                    renderer: renderer,
+                    pattern: pattern,
+                    effect: effect,
+                    columns: original?.columns ?? 240,
+                    rows: original?.rows ?? 70,
+                    durationSeconds: durationSeconds
+                ))
+            }
+        }
+        return results
+    }
+
+    /// A fixed-width table of `results`, one line per run.
+    static func report(_ results: [RendererStressResult]) -> String {
+        func ms(_ value: Double?) -> String {
+            value.map { String(format: "%7.2f", $0) } ?? "      -"
+        }
+        var lines = [
+            "effect           pattern          frames  cpu avg  cpu p95  gpu avg  gpu p95  wait avg wait p95  drop60"
+        ]
+        for result in results {
+            lines.append(
+                result.effect.rawValue.padding(toLength: 17, withPad: " ", startingAt: 0)
+                    + result.pattern.rawValue.padding(toLength: 17, withPad: " ", startingAt: 0)
+                    + String(format: "%6d", result.framesRendered)
+                    + "  " + ms(result.averageCPUFrameMs) + "  " + ms(result.p95CPUFrameMs)
+                    + "  " + ms(result.averageGPUFrameMs) + "  " + ms(result.p95GPUFrameMs)
+                    + "  " + ms(result.averageDrawableWaitMs) + "  " + ms(result.p95DrawableWaitMs)
+                    + String(format: "  %6d", result.dropped60HzFrames)
+            )
+        }
+        return lines.joined(separator: "\n")
+    }
+
+    // MARK: - Measurement
+
+    private static func measure(
+        renderer: MetalTerminalRenderer,
+        pattern: RendererStressPattern,
+        effect: RendererStressEffect,
+        columns: Int,
+        rows: Int,
+        durationSeconds: Double
+    ) async -> RendererStressResult {
+        apply(effect, to: renderer)
+        var generator = SnapshotGenerator(columns: columns, rows: rows)
+
+        // Settle on the base screen so the first measured frame is not a
+        // full upload caused by switching grids or effects.
+        renderer.updateSnapshot(generator.baseSnapshot())
+        await waitForFrame(renderer, after: renderer.performanceSnapshot.totalFrames)
+        renderer.performanceMonitor.reset()
+
         let start = CACurrentMediaTime()
         var frames = 0
-
         while CACurrentMediaTime() - start < durationSeconds {
-            renderer.updateSnapshot(makeFloodSnapshot(columns: columns, rows: rows, seed: frames))
+            let drawn = renderer.performanceSnapshot.totalFrames
+            renderer.updateSnapshot(generator.next(pattern, frame: frames))
             frames += 1
-            await Task.yield()
+            await waitForFrame(renderer, after: drawn)
         }
+        let duration = CACurrentMediaTime() - start
+
+        // GPU times arrive from completion handlers via the main queue.
+        try? await Task.sleep(for: .milliseconds(50))
 
         let stats = renderer.performanceSnapshot
         return RendererStressResult(
+            pattern: pattern,
+            effect: effect,
             framesSubmitted: frames,
-            durationSeconds: CACurrentMediaTime() - start,
+            framesRendered: stats.totalFrames,
+            durationSeconds: duration,
             averageCPUFrameMs: stats.averageCPUFrameMs,
             p95CPUFrameMs: stats.p95CPUFrameMs,
+            averageGPUFrameMs: stats.averageGPUFrameMs,
+            p95GPUFrameMs: stats.p95GPUFrameMs,
+            averageDrawableWaitMs: stats.averageDrawableWaitMs,
+            p95DrawableWaitMs: stats.p95DrawableWaitMs,
             dropped120HzFrames: stats.dropped120HzFrames,
             dropped60HzFrames: stats.dropped60HzFrames
         )
     }
 
-    private static func makeFloodSnapshot(columns: Int, rows: Int, seed: Int) -> GridSnapshot {
-        let count = max(1, columns * rows)
-        var cells = ContiguousArray<CellInstance>()
-        cells.reserveCapacity(count)
+    /// Wait until the renderer has drawn more than `frames` frames.
+    private static func waitForFrame(_ renderer: MetalTerminalRenderer, after frames: Int) async {
+        let deadline = CACurrentMediaTime() + frameTimeoutSeconds
+        while renderer.performanceSnapshot.totalFrames <= frames, CACurrentMediaTime() < deadline {
+            try? await Task.sleep(for: .milliseconds(1))
+        }
+    }
+
+    // MARK: - Effects
+
+    /// The effect settings a run changes, so they can be put back. The
+    /// harness never writes them to user defaults.
+    private struct EffectState {
+        let crt: CRTEffectConfiguration
+        let gradient: GradientBackgroundConfiguration
+        let solidBackground: SolidBackgroundConfiguration
+        let scanner: ScannerEffectConfiguration
+        let bloom: BloomEffectConfiguration
+        let isLocalSession: Bool
+
+        init(_ renderer: MetalTerminalRenderer) {
+            crt = renderer.crtConfiguration
+            gradient = renderer.gradientConfiguration
+            solidBackground = renderer.solidBackgroundConfiguration
+            scanner = renderer.scannerConfiguration
+            bloom = renderer.bloomConfiguration
+            isLocalSession = renderer.isLocalSession
+        }
 
-        var state = UInt64(truncatingIfNeeded: seed) &+ 0x9E3779B97F4A7C15
+        func apply(to renderer: MetalTerminalRenderer) {
+            renderer.crtConfiguration = crt
+            renderer.gradientConfiguration = gradient
+            renderer.solidBackgroundConfiguration = solidBackground
+            renderer.scannerConfiguration = scanner
+            renderer.bloomConfiguration = bloom
+            renderer.isLocalSession = isLocalSession
+            renderer.hasCapturedPreviousFrame = false
+            renderer.isDirty = true
+            renderer.requestFrame()
+        }
+    }
 
-        for index in 0..<count {
+    private static func apply(_ effect: RendererStressEffect, to renderer: MetalTerminalRenderer) {
+        renderer.crtConfiguration.isEnabled = effect == .crt
+        renderer.gradientConfiguration.isEnabled = effect == .gradient
+        renderer.solidBackgroundConfiguration.isEnabled = effect == .solidBackground
+        renderer.scannerConfiguration.isEnabled = effect == .scanner
+        renderer.bloomConfiguration.isEnabled = effect == .bloom
+        // The scanner only draws on local sessions.
+        if effect == .scanner {
+            renderer.isLocalSession = true
+        }
+        renderer.hasCapturedPreviousFrame = false
+        renderer.isDirty = true
+    }
+
+    // MARK: - Snapshots
+
+    /// Keeps the current screen and derives each pattern's next frame from it.
+    private struct SnapshotGenerator {
+        let columns: Int
+        let rows: Int
+        private var cells: ContiguousArray<CellInstance>
+        private var state: UInt64 = 0x9E3779B97F4A7C15
+        private var cursorRow = 0
+        private var cursorCol = 0
+        private var scrolledLines = 0
+        private var nextMissCodepoint: UInt32 = 0x4E00
+
+        init(columns: Int, rows: Int) {
+            self.columns = max(1, columns)
+            self.rows = max(1, rows)
+            cells = ContiguousArray()
+            cells.reserveCapacity(self.columns * self.rows)
+            for index in 0..<(self.columns * self.rows) {
+                cells.append(makeCell(index: index, codepoint: UInt32(0x21 + index % 94)))
+            }
+            cursorRow = self.rows - 1
+        }
+
+        private mutating func random() -> UInt64 {
             state = state &* 2862933555777941757 &+ 3037000493
+            return state
+        }
 
-            let row = index / columns
-            let col = index % columns
-            let ch = UInt32(0x20 + (state % 95))
-
-            let fgIndex = UInt8(truncatingIfNeeded: state >> 8)
-            let bgIndex = UInt8(truncatingIfNeeded: state >> 16)
-
-            var attributes: CellAttributes = []
-            if state & 1 == 0 { attributes.insert(.bold) }
-            if state & 2 == 0 { attributes.insert(.underline) }
-            if state & 4 == 0 { attributes.insert(.dim) }
-
-            cells.append(
-                CellInstance(
-                    row: UInt16(row),
-                    col: UInt16(col),
-                    glyphIndex: ch,
-                    fgColor: TerminalColor.indexed(fgIndex).packedRGBA(),
-                    bgColor: TerminalColor.indexed(bgIndex).packedRGBA(),
-                    underlineColor: 0,
-                    attributes: attributes.rawValue,
-                    flags: CellInstance.flagDirty,
-                    underlineStyle: 0
-                )
+        private func makeCell(index: Int, codepoint: UInt32, colorSeed: UInt64 = 0, attributes: CellAttributes = []) -> CellInstance {
+            CellInstance(
+                row: UInt16(index / columns),
+                col: UInt16(index % columns),
+                glyphIndex: codepoint,
+                fgColor: TerminalColor.indexed(UInt8(truncatingIfNeeded: colorSeed >> 8) | 0x08).packedRGBA(),
+                bgColor: colorSeed == 0 ? 0 : TerminalColor.indexed(UInt8(truncatingIfNeeded: colorSeed >> 16)).packedRGBA(),
+                underlineColor: 0,
+                attributes: attributes.rawValue,
+                flags: CellInstance.flagDirty,
+                underlineStyle: 0
             )
         }
 
-        return GridSnapshot(
-            cells: cells,
-            dirtyRange: 0..<count,
-            cursorRow: (seed / max(1, columns)) % max(1, rows),
-            cursorCol: seed % max(1, columns),
-            cursorVisible: true,
-            cursorStyle: .block,
-            columns: columns,
-            rows: rows,
-            usingAlternateBuffer: false,
-            graphemeOverrides: nil
-        )
+        private func snapshot(damage: [Range<Int>]?) -> GridSnapshot {
+            var snapshot = GridSnapshot(
+                cells: cells,
+                dirtyRange: damage.map { ranges in
+                    (ranges.map(\.lowerBound).min() ?? 0)..<(ranges.map(\.upperBound).max() ?? 0)
+                },
+                cursorRow: cursorRow,
+                cursorCol: cursorCol,
+                cursorVisible: true,
+                cursorStyle: .block,
+                columns: columns,
+                rows: rows,
+                usingAlternateBuffer: false,
+                graphemeOverrides: nil
+            )
+            snapshot.damagedRanges = damage
+            return snapshot
+        }
+
+        func baseSnapshot() -> GridSnapshot {
+            snapshot(damage: nil)
+        }
+
+        mutating func next(_ pattern: RendererStressPattern, frame: Int) -> GridSnapshot {
+            switch pattern {
+            case .fullScreenFlood:
+                for index in cells.indices {
+                    let value = random()
+                    var attributes: CellAttributes = []
+                    if value & 1 == 0 { attributes.insert(.bold) }
+                    if value & 2 == 0 { attributes.insert(.underline) }
+                    if value & 4 == 0 { attributes.insert(.dim) }
+                    cells[index] = makeCell(index: index, codepoint: UInt32(0x20 + value % 95), colorSeed: value, attributes: attributes)
+                }
+                cursorRow = (frame / columns) % rows
+                cursorCol = frame % columns
+                return snapshot(damage: [0..<cells.count])
+
+            case .statusLine:
+                let start = (rows - 1) * columns
+                let status = Array(String(format: " %02d:%02d:%02d.%03d  load %.2f  frame %d", frame / 3_600_000 % 24, frame / 60_000 % 60, frame / 1000 % 60, frame % 1000, Double(frame % 400) / 100, frame).unicodeScalars)
+                for col in 0..<columns {
+                    let codepoint = col < status.count ? status[col].value : 0x20
+                    cells[start + col] = makeCell(index: start + col, codepoint: codepoint, colorSeed: 0x0400, attributes: [.bold])
+                }
+                return snapshot(damage: [start..<(start + columns)])
+
+            case .cursorOnly:
+                cursorCol = frame % columns
+                cursorRow = (frame / columns) % rows
+                return snapshot(damage: [])
+
+            case .scrollByOne:
+                scrolledLines += 1
+                let visible = (rows - 1) * columns
+                for index in 0..<visible {
+                    let moved = cells[index + columns]
+                    cells[index] = makeCell(index: index, codepoint: moved.glyphIndex)
+                }
+                let text = Array("[\(scrolledLines)] build step \(scrolledLines % 97) compiled in \(scrolledLines % 13) ms".unicodeScalars)
+                for col in 0..<columns {
+                    cells[visible + col] = makeCell(index: visible + col, codepoint: col < text.count ? text[col].value : 0x20)
+                }
+                return snapshot(damage: [0..<cells.count])
+
+            case .randomCells:
+                let changes = max(1, cells.count / 10)
+                var changed: [Int] = []
+                changed.reserveCapacity(changes)
+                for _ in 0..<changes {
+                    let value = random()
+                    let index = Int(value % UInt64(cells.count))
+                    cells[index] = makeCell(index: index, codepoint: UInt32(0x21 + (value >> 12) % 94), colorSeed: value)
+                    changed.append(index)
+                }
+                return snapshot(damage: Self.coalesce(changed))
+
+            case .glyphMissStorm:
+                // Five rows of glyphs not drawn before: CJK ideographs, then
+                // emoji, each two cells wide.
+                let firstRow = (frame * 5) % max(1, rows - 4)
+                let start = firstRow * columns
+                let end = min(cells.count, start + 5 * columns)
+                var index = start
+                while index < end {
+                    if (index - start) % columns == columns - 1 {
+                        cells[index] = makeCell(index: index, codepoint: 0x20)
+                        index += 1
+                        continue
+                    }
+                    let codepoint = nextMissCodepoint
+                    nextMissCodepoint = codepoint == 0x9FFF ? 0x1F300 : (codepoint == 0x1F64F ? 0x4E00 : codepoint + 1)
+                    cells[index] = makeCell(index: index, codepoint: codepoint, attributes: [.wideChar])
+                    cells[index + 1] = makeCell(index: index + 1, codepoint: 0, attributes: [.wideContinuation])
+                    index += 2
+                }
+                return snapshot(damage: [start..<end])
+            }
+        }
+
+        /// Sorted, merged ranges covering `indices`.
+        private static func coalesce(_ indices: [Int]) -> [Range<Int>] {
+            var ranges: [Range<Int>] = []
+            for index in indices.sorted() {
+                if let last = ranges.last, last.upperBound >= index {
+                    ranges[ranges.count - 1] = last.lowerBound..<max(last.upperBound, index + 1)
+                } else {
+                    ranges.append(index..<(index + 1))
+                }
+            }
+            return ranges
+        }
     }
 }
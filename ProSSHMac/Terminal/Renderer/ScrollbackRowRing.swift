@@ -0,0 +1,132 @@
+// ScrollbackRowRing.swift
+// ProSSHV2
+//
+// History rows held on the GPU for smooth scrolling. Each time a momentum
+// scroll through scrollback crossed a row, the renderer used to need a new
+// viewport snapshot: the coordinator moved the scroll offset, the grid
+// encoded rows × columns cells, and the renderer uploaded all of them and
+// rebuilt its draw lists. While a fling is drawn from the ring, crossing a
+// row changes only the `scrollRowBase` uniform.
+//
+// The ring has one slot per row, and `capacity` slots of `columns` cells.
+// A row is identified by its line position (ScrollbackRingRows) and lives
+// in slot `position mod capacity`. Its cells carry the position, truncated
+// to 16 bits, in `row`, and the vertex shader places each cell at
+// `row - scrollRowBase`. Rows stream in at the edges of the window around
+// the viewport as it moves. Slots are drawn in place through an identity
+// index buffer, one draw per contiguous run of resident slots.
+
+import Metal
+
+final class ScrollbackRowRing {
+
+    let columns: Int
+    /// Slots (rows) in the ring.
+    let capacity: Int
+    let gridRows: Int
+    /// Oldest line and top live grid row when the ring was created; the
+    /// viewport at scroll offset `o` starts at `liveTop - o`.
+    let firstPosition: Int
+    let liveTop: Int
+
+    /// Every position the ring can hold rows for.
+    var positions: Range<Int> {
+        firstPosition..<(liveTop + gridRows)
+    }
+
+    let cellBuffer: MTLBuffer
+    /// `indexBuffer[i] == i`, so draws index the ring's cells directly.
+    let indexBuffer: MTLBuffer
+
+    /// The position each slot holds, or nil while it is empty.
+    private var slotPositions: [Int?]
+
+    init?(device: MTLDevice, columns: Int, capacity: Int, gridRows: Int, firstPosition: Int, liveTop: Int) {
+        guard columns > 0, capacity > 0 else { return nil }
+        let cellCount = columns * capacity
+        guard let cellBuffer = device.makeBuffer(
+                  length: cellCount * MemoryLayout<CellInstance>.stride,
+                  options: .storageModeShared
+              ),
+              let indexBuffer = device.makeBuffer(
+                  length: cellCount * MemoryLayout<UInt32>.stride,
+                  options: .storageModeShared
+              ) else { return nil }
+        let indices = indexBuffer.contents().bindMemory(to: UInt32.self, capacity: cellCount)
+        for index in 0..<cellCount {
+            indices[index] = UInt32(index)
+        }
+        #if DEBUG
+        cellBuffer.label = "ScrollbackRowRing Cells"
+        indexBuffer.label = "ScrollbackRowRing Indices"
+        #endif
+        self.columns = columns
+        self.capacity = capacity
+        self.gridRows = gridRows
+        self.firstPosition = firstPosition
+        self.liveTop = liveTop
+        self.cellBuffer = cellBuffer
+        self.indexBuffer = indexBuffer
+        self.slotPositions = Array(repeating: nil, count: capacity)
+    }
+
+    func slot(for position: Int) -> Int {
+        let slot = position % capacity
+        return slot < 0 ? slot + capacity : slot
+    }
+
+    func contains(_ position: Int) -> Bool {
+        slotPositions[slot(for: position)] == position
+    }
+
+    /// The smallest range holding every position of `window` that is not
+    /// resident, or nil when all are. `window` must fit in the ring.
+    func missingPositions(in window: Range<Int>) -> Range<Int>? {
+        guard let first = window.first(where: { !contains($0) }),
+              let last = window.last(where: { !contains($0) }) else { return nil }
+        return first..<(last + 1)
+    }
+
+    /// Store `rows` in their slots. Rows at another width are ignored.
+    func write(_ rows: ScrollbackRingRows) {
+        guard rows.columns == columns else { return }
+        let cells = cellBuffer.contents().bindMemory(to: CellInstance.self, capacity: columns * capacity)
+        for row in rows.rows where row.cells.count == columns {
+            let slot = slot(for: row.position)
+            row.cells.withUnsafeBufferPointer { source in
+                guard let base = source.baseAddress else { return }
+                (cells + slot * columns).update(from: base, count: columns)
+            }
+            slotPositions[slot] = row.position
+        }
+    }
+
+    /// Slot runs to draw for `positions`: resident rows only, each run
+    /// contiguous in the ring, in position order.
+    func slotRuns(for positions: Range<Int>) -> [Range<Int>] {
+        var runs: [Range<Int>] = []
+        var current: Range<Int>?
+        for position in positions {
+            guard contains(position) else {
+                if let run = current {
+                    runs.append(run)
+                    current = nil
+                }
+                continue
+            }
+            let slot = slot(for: position)
+            if let run = current, run.upperBound == slot {
+                current = run.lowerBound..<(slot + 1)
+            } else {
+                if let run = current {
+                    runs.append(run)
+                }
+                current = slot..<(slot + 1)
+            }
+        }
+        if let run = current {
+            runs.append(run)
+        }
+        return runs
+    }
+}
@@ -72,7 +72,11 @@ final class SelectionRenderer {
     ///
     /// When selection changes, this forces a full update to ensure stale
     /// selected bits are cleared correctly across the entire grid.
+    ///
+    /// Compact snapshots are expanded on the CPU while a selection is shown,
+    /// since selection bits live in `CellInstance.flags`.
     func applySelection(to snapshot: GridSnapshot) -> GridSnapshot {
+        let snapshot = selection == nil ? snapshot : snapshot.expandingCompactCells()
         guard var selection else {
             defer {
                 needsFullRefresh = false
@@ -105,7 +109,8 @@ final class SelectionRenderer {
                 columns: snapshot.columns,
                 rows: snapshot.rows,
                 usingAlternateBuffer: snapshot.usingAlternateBuffer,
-                graphemeOverrides: snapshot.graphemeOverrides
+                graphemeOverrides: snapshot.graphemeOverrides,
+                inlineImages: snapshot.inlineImages
             )
         }
 
@@ -159,7 +164,8 @@ final class SelectionRenderer {
             columns: snapshot.columns,
             rows: snapshot.rows,
             usingAlternateBuffer: snapshot.usingAlternateBuffer,
-            graphemeOverrides: snapshot.graphemeOverrides
+            graphemeOverrides: snapshot.graphemeOverrides,
+            inlineImages: snapshot.inlineImages
         )
     }
 
@@ -0,0 +1,164 @@
+// SessionThumbnailAtlas.swift
+// ProSSHV2
+//
+// Small live thumbnails of each session for tab hover previews and the
+// session overview. A renderer whose content changed downsamples its
+// persistent scene texture (the one the drawable is copied from) into a
+// slot of one shared atlas on the GPU, then copies that slot into a small
+// shared buffer in the same command buffer. When the buffer completes, the
+// 320x200 pixels become a CGImage that SessionThumbnailStore keeps by
+// session. Captures are rate-limited per renderer
+// (`MetalTerminalRenderer.thumbnailInterval`).
+//
+// Slots are only borrowed for the length of one capture, so sixteen of them
+// serve any number of panes. A capture that finds none free is retried on
+// the next interval. Only visible renderers draw, so background and
+// hibernated sessions never capture. Their last image stays in the store,
+// and an overview of fifty tabs is fifty small images with no Metal work.
+
+import CoreGraphics
+import Foundation
+import Metal
+
+// MARK: - ThumbnailParams
+
+/// Mirrors `ThumbnailParams` in TerminalShaders.metal.
+nonisolated struct ThumbnailParams: Sendable {
+    var origin: SIMD2<UInt32>
+    var size: SIMD2<UInt32>
+}
+
+// MARK: - SessionThumbnailAtlas
+
+final class SessionThumbnailAtlas {
+
+    nonisolated static let slotWidth = 320
+    nonisolated static let slotHeight = 200
+    private static let columns = 4
+    private static let rows = 4
+
+    /// Four bytes per pixel, as `thumbnail_downsample` writes rgba8Unorm.
+    nonisolated static let bytesPerRow = slotWidth * 4
+
+    let texture: MTLTexture
+    private var freeSlots: [Int]
+
+    init?(device: MTLDevice) {
+        // rgba8Unorm is shader-writable on every Mac GPU (see BloomChain).
+        let descriptor = MTLTextureDescriptor.texture2DDescriptor(
+            pixelFormat: .rgba8Unorm,
+            width: Self.slotWidth * Self.columns,
+            height: Self.slotHeight * Self.rows,
+            mipmapped: false
+        )
+        descriptor.usage = [.shaderWrite]
+        descriptor.storageMode = .private
+        guard let texture = device.makeTexture(descriptor: descriptor) else { return nil }
+        texture.label = "SessionThumbnailAtlas"
+        self.texture = texture
+        self.freeSlots = Array((0..<(Self.columns * Self.rows)).reversed())
+    }
+
+    // MARK: - Capture
+
+    /// A capture in flight: the slot it holds and the buffer its pixels
+    /// land in once the command buffer completes. Unchecked because the
+    /// buffer is only read after the GPU is done with it.
+    nonisolated struct Capture: @unchecked Sendable {
+        let slot: Int
+        let pixels: MTLBuffer
+    }
+
+    /// Encodes a downsample of `source` into a free slot and a copy of that
+    /// slot into a new shared buffer. Nil when no slot is free or the
+    /// encoders cannot be made; the caller then retries later. The slot is
+    /// held until `release(_:)`.
+    func encodeCapture(
+        from source: MTLTexture,
+        pipeline: MTLComputePipelineState,
+        commandBuffer: MTLCommandBuffer
+    ) -> Capture? {
+        guard let slot = freeSlots.last,
+              let pixels = texture.device.makeBuffer(
+                  length: Self.bytesPerRow * Self.slotHeight,
+                  options: .storageModeShared
+              ),
+              let computeEncoder = commandBuffer.makeComputeCommandEncoder() else {
+            return nil
+        }
+        freeSlots.removeLast()
+        let origin = Self.origin(ofSlot: slot)
+
+        computeEncoder.label = "SessionThumbnailDownsample"
+        computeEncoder.setComputePipelineState(pipeline)
+        computeEncoder.setTexture(source, index: 0)
+        computeEncoder.setTexture(texture, index: 1)
+        var params = ThumbnailParams(
+            origin: SIMD2(UInt32(origin.x), UInt32(origin.y)),
+            size: SIMD2(UInt32(Self.slotWidth), UInt32(Self.slotHeight))
+        )
+        computeEncoder.setBytes(&params, length: MemoryLayout<ThumbnailParams>.stride, index: 0)
+        let width = pipeline.threadExecutionWidth
+        let height = max(1, pipeline.maxTotalThreadsPerThreadgroup / width)
+        let threadgroup = MTLSize(width: width, height: height, depth: 1)
+        let groups = MTLSize(
+            width: (Self.slotWidth + width - 1) / width,
+            height: (Self.slotHeight + height - 1) / height,
+            depth: 1
+        )
+        computeEncoder.dispatchThreadgroups(groups, threadsPerThreadgroup: threadgroup)
+        computeEncoder.endEncoding()
+
+        guard let blitEncoder = commandBuffer.makeBlitCommandEncoder() else {
+            // The downsample is harmless on its own; only the slot needs
+            // handing back.
+            release(Capture(slot: slot, pixels: pixels))
+            return nil
+        }
+        blitEncoder.label = "SessionThumbnailReadback"
+        blitEncoder.copy(
+            from: texture,
+            sourceSlice: 0,
+            sourceLevel: 0,
+            sourceOrigin: MTLOrigin(x: origin.x, y: origin.y, z: 0),
+            sourceSize: MTLSize(width: Self.slotWidth, height: Self.slotHeight, depth: 1),
+            to: pixels,
+            destinationOffset: 0,
+            destinationBytesPerRow: Self.bytesPerRow,
+            destinationBytesPerImage: Self.bytesPerRow * Self.slotHeight
+        )
+        blitEncoder.endEncoding()
+        return Capture(slot: slot, pixels: pixels)
+    }
+
+    /// Hands a capture's slot back once its command buffer has completed.
+    func release(_ capture: Capture) {
+        freeSlots.append(capture.slot)
+    }
+
+    private static func origin(ofSlot slot: Int) -> (x: Int, y: Int) {
+        ((slot % columns) * slotWidth, (slot / columns) * slotHeight)
+    }
+
+    // MARK: - Images
+
+    /// The thumbnail in a completed capture's buffer. Safe off the main
+    /// thread: it only copies the bytes.
+    nonisolated static func makeImage(from pixels: MTLBuffer) -> CGImage? {
+        let data = Data(bytes: pixels.contents(), count: bytesPerRow * slotHeight)
+        guard let provider = CGDataProvider(data: data as CFData) else { return nil }
+        return CGImage(
+            width: slotWidth,
+            height: slotHeight,
+            bitsPerComponent: 8,
+            bitsPerPixel: 32,
+            bytesPerRow: bytesPerRow,
+            space: CGColorSpaceCreateDeviceRGB(),
+            bitmapInfo: CGBitmapInfo(rawValue: CGImageAlphaInfo.noneSkipLast.rawValue),
+            provider: provider,
+            decode: nil,
+            shouldInterpolate: true,
+            intent: .defaultIntent
+        )
+    }
+}
@@ -62,7 +62,7 @@ struct TerminalMetalView: NSViewRepresentable {
         container.shouldRouteWheelToViewport = shouldRouteWheelToViewport
         container.cellHeight = renderer.currentCellHeight
         container.renderer = renderer
-        renderer.smoothScrollEngine.onScrollLineChange = { [weak container] lines in
+        renderer.onScrollLineChange = { [weak container] lines in
             container?.onScroll?(lines)
         }
         container.setBackgroundOpacity(backgroundOpacity)
@@ -70,13 +70,15 @@ struct TerminalMetalView: NSViewRepresentable {
     }
 
     func updateNSView(_ nsView: TerminalMetalContainerView, context: Context) {
+        let traceStart = TraceRecorder.shared.begin()
+        defer { TraceRecorder.shared.end(.viewUpdate, since: traceStart) }
         context.coordinator.parent = self
         renderer.onGridSizeChange = onTerminalResize
         nsView.onScroll = onScroll
         nsView.shouldRouteWheelToViewport = shouldRouteWheelToViewport
         nsView.cellHeight = renderer.currentCellHeight
         nsView.renderer = renderer
-        renderer.smoothScrollEngine.onScrollLineChange = { [weak nsView] lines in
+        renderer.onScrollLineChange = { [weak nsView] lines in
             nsView?.onScroll?(lines)
         }
         nsView.setBackgroundOpacity(backgroundOpacity)
@@ -0,0 +1,320 @@
+// TerminalPipelineCache.swift
+// ProSSHV2
+//
+// Render and compute pipeline states shared by every renderer in the
+// process. Each MetalTerminalRenderer used to load the shader library and
+// compile six pipelines in its initializer, so every new pane or window
+// paid for shader compilation on the main thread. That could take hundreds
+// of milliseconds on the first launch after an OS or driver update.
+//
+// Pipelines are now built once per device. The compiled binaries are then
+// stored in an MTLBinaryArchive in Application Support/ProSSHV2/ShaderCache.
+// The app warms the cache on a background queue at launch, so a renderer
+// normally finds its pipelines ready. If one is created mid-warm-up it waits
+// for that build to finish rather than compiling a second time.
+//
+// The archive file name hashes the device and OS version. Metal binaries
+// depend on both, so an update simply misses. The pipelines are then
+// compiled from the library as before, and a fresh archive is written.
+
+import CryptoKit
+import Foundation
+import Metal
+import os.log
+
+// MARK: - TerminalPipelines
+
+/// Every pipeline state a renderer draws with. Pipeline states are
+/// immutable and safe to share across threads.
+nonisolated struct TerminalPipelines: @unchecked Sendable {
+    let scene: MTLRenderPipelineState
+    let background: MTLRenderPipelineState
+    let postProcess: MTLRenderPipelineState
+    let bloomBright: MTLRenderPipelineState?
+    let bloomBlur: MTLRenderPipelineState?
+    /// Compute bloom chain (BloomChain); the fragment bloom above is the
+    /// fallback when either kernel fails to build.
+    let bloomDownsample: MTLComputePipelineState?
+    let bloomUpsample: MTLComputePipelineState?
+    /// Nil if the kernel fails to build; compact snapshots then expand on the CPU.
+    let cellExpansion: MTLComputePipelineState?
+    /// Performance HUD quad (PerformanceHUDOverlay); nil disables the HUD.
+    let performanceHUD: MTLRenderPipelineState?
+    /// Idle screensaver (MatrixRainRenderer); nil falls back to the
+    /// SwiftUI Canvas.
+    let matrixRain: MTLRenderPipelineState?
+    /// Sixel, iTerm2 and kitty images (MetalTerminalRenderer+InlineImages);
+    /// nil leaves their cells blank.
+    let inlineImage: MTLRenderPipelineState?
+    /// Tab and overview thumbnails (SessionThumbnailAtlas); nil disables them.
+    let thumbnailDownsample: MTLComputePipelineState?
+}
+
+// MARK: - TerminalPipelineCache
+
+nonisolated final class TerminalPipelineCache: @unchecked Sendable {
+
+    enum BuildError: Error {
+        case libraryUnavailable
+        case functionMissing(String)
+    }
+
+    static let shared = TerminalPipelineCache(
+        archiveDirectory: FileManager.default.urls(for: .applicationSupportDirectory, in: .userDomainMask).first?
+            .appendingPathComponent("ProSSHV2", isDirectory: true)
+            .appendingPathComponent("ShaderCache", isDirectory: true)
+    )
+
+    private static let logger = Logger(subsystem: "com.prossh", category: "PipelineCache")
+
+    /// Directory for binary archives; nil disables persistence.
+    let archiveDirectory: URL?
+
+    /// Guards `pipelines`. Held for a whole build, so concurrent callers for
+    /// the same device wait for one compilation instead of racing.
+    private let lock = NSLock()
+    private var pipelines: [UInt64: TerminalPipelines] = [:]
+
+    init(archiveDirectory: URL?) {
+        self.archiveDirectory = archiveDirectory
+    }
+
+    // MARK: - Lookup
+
+    /// Pipelines for `device`, built (or loaded from the archive) on first use.
+    func pipelines(for device: MTLDevice) throws -> TerminalPipelines {
+        lock.lock()
+        defer { lock.unlock() }
+        if let cached = pipelines[device.registryID] {
+            return cached
+        }
+        let built = try build(for: device)
+        pipelines[device.registryID] = built
+        return built
+    }
+
+    /// Whether `device`'s pipelines are already built.
+    func isWarm(for device: MTLDevice) -> Bool {
+        lock.lock()
+        defer { lock.unlock() }
+        return pipelines[device.registryID] != nil
+    }
+
+    /// Build the default device's pipelines on a background queue.
+    func warmDefaultDevice() {
+        DispatchQueue.global(qos: .userInitiated).async {
+            guard let device = MTLCreateSystemDefaultDevice() else { return }
+            do {
+                _ = try self.pipelines(for: device)
+            } catch {
+                Self.logger.error("Pipeline warm-up failed: \(String(describing: error), privacy: .public)")
+            }
+        }
+    }
+
+    // MARK: - Archive
+
+    /// Archive file for `device` on this OS build.
+    func archiveURL(for device: MTLDevice) -> URL? {
+        guard let archiveDirectory else { return nil }
+        let identity = [
+            device.name,
+            ProcessInfo.processInfo.operatingSystemVersionString,
+        ].joined(separator: "|")
+        let digest = SHA256.hash(data: Data(identity.utf8))
+        let name = digest.prefix(12).map { String(format: "%02x", $0) }.joined()
+        return archiveDirectory.appendingPathComponent("\(name).binarchive", isDirectory: false)
+    }
+
+    /// The stored archive for `device`, or an empty one. `isStored` is false
+    /// when the pipelines still have to be added and serialized.
+    private func openArchive(for device: MTLDevice) -> (archive: MTLBinaryArchive?, isStored: Bool) {
+        let descriptor = MTLBinaryArchiveDescriptor()
+        if let url = archiveURL(for: device), FileManager.default.fileExists(atPath: url.path) {
+            descriptor.url = url
+            if let archive = try? device.makeBinaryArchive(descriptor: descriptor) {
+                return (archive, true)
+            }
+            Self.logger.error("Discarding unreadable pipeline archive \(url.lastPathComponent, privacy: .public)")
+            try? FileManager.default.removeItem(at: url)
+            descriptor.url = nil
+        }
+        return (try? device.makeBinaryArchive(descriptor: descriptor), false)
+    }
+
+    private func serialize(_ archive: MTLBinaryArchive, for device: MTLDevice) {
+        guard let archiveDirectory, let url = archiveURL(for: device) else { return }
+        do {
+            try FileManager.default.createDirectory(at: archiveDirectory, withIntermediateDirectories: true)
+            try archive.serialize(to: url)
+        } catch {
+            Self.logger.error("Pipeline archive write failed: \(error.localizedDescription, privacy: .public)")
+        }
+    }
+
+    // MARK: - Build
+
+    private func build(for device: MTLDevice) throws -> TerminalPipelines {
+        guard let library = device.makeDefaultLibrary() else {
+            throw BuildError.libraryUnavailable
+        }
+        func function(_ name: String) throws -> MTLFunction {
+            guard let function = library.makeFunction(name: name) else {
+                throw BuildError.functionMissing(name)
+            }
+            return function
+        }
+
+        let (archive, isStored) = openArchive(for: device)
+        var needsSerialize = false
+
+        func makeRender(_ descriptor: MTLRenderPipelineDescriptor) throws -> MTLRenderPipelineState {
+            if let archive {
+                descriptor.binaryArchives = [archive]
+                if !isStored {
+                    do {
+                        try archive.addRenderPipelineFunctions(descriptor: descriptor)
+                        needsSerialize = true
+                    } catch {
+                        Self.logger.error("Pipeline archive add failed: \(error.localizedDescription, privacy: .public)")
+                    }
+                }
+            }
+            return try device.makeRenderPipelineState(descriptor: descriptor)
+        }
+
+        // Cell pass, alpha-blended over the background runs.
+        let sceneDescriptor = MTLRenderPipelineDescriptor()
+        sceneDescriptor.label = "TerminalRenderPipeline"
+        sceneDescriptor.vertexFunction = try function("terminal_vertex")
+        sceneDescriptor.fragmentFunction = try function("terminal_fragment")
+        sceneDescriptor.colorAttachments[0].pixelFormat = .bgra8Unorm
+        sceneDescriptor.colorAttachments[0].isBlendingEnabled = true
+        sceneDescriptor.colorAttachments[0].rgbBlendOperation = .add
+        sceneDescriptor.colorAttachments[0].alphaBlendOperation = .add
+        sceneDescriptor.colorAttachments[0].sourceRGBBlendFactor = .sourceAlpha
+        sceneDescriptor.colorAttachments[0].destinationRGBBlendFactor = .oneMinusSourceAlpha
+        sceneDescriptor.colorAttachments[0].sourceAlphaBlendFactor = .one
+        sceneDescriptor.colorAttachments[0].destinationAlphaBlendFactor = .oneMinusSourceAlpha
+        let scene = try makeRender(sceneDescriptor)
+
+        let backgroundDescriptor = MTLRenderPipelineDescriptor()
+        backgroundDescriptor.label = "TerminalBackgroundPipeline"
+        backgroundDescriptor.vertexFunction = try function("terminal_background_vertex")
+        backgroundDescriptor.fragmentFunction = try function("terminal_background_fragment")
+        backgroundDescriptor.colorAttachments[0].pixelFormat = .bgra8Unorm
+        let background = try makeRender(backgroundDescriptor)
+
+        let postDescriptor = MTLRenderPipelineDescriptor()
+        postDescriptor.label = "TerminalPostProcessPipeline"
+        postDescriptor.vertexFunction = try function("terminal_post_vertex")
+        postDescriptor.fragmentFunction = try function("terminal_post_fragment")
+        postDescriptor.colorAttachments[0].pixelFormat = .bgra8Unorm
+        let postProcess = try makeRender(postDescriptor)
+
+        // Bloom is optional: a missing or failing pipeline disables the effect.
+        var bloomBright: MTLRenderPipelineState?
+        if let vertex = library.makeFunction(name: "bloom_bright_vertex"),
+           let fragment = library.makeFunction(name: "bloom_bright_fragment") {
+            let descriptor = MTLRenderPipelineDescriptor()
+            descriptor.label = "BloomBrightPipeline"
+            descriptor.vertexFunction = vertex
+            descriptor.fragmentFunction = fragment
+            descriptor.colorAttachments[0].pixelFormat = .bgra8Unorm
+            bloomBright = try? makeRender(descriptor)
+        }
+
+        var bloomBlur: MTLRenderPipelineState?
+        if let vertex = library.makeFunction(name: "bloom_blur_vertex"),
+           let fragment = library.makeFunction(name: "bloom_blur_fragment") {
+            let descriptor = MTLRenderPipelineDescriptor()
+            descriptor.label = "BloomBlurPipeline"
+            descriptor.vertexFunction = vertex
+            descriptor.fragmentFunction = fragment
+            descriptor.colorAttachments[0].pixelFormat = .bgra8Unorm
+            bloomBlur = try? makeRender(descriptor)
+        }
+
+        var performanceHUD: MTLRenderPipelineState?
+        if let vertex = library.makeFunction(name: "performance_hud_vertex"),
+           let fragment = library.makeFunction(name: "performance_hud_fragment") {
+            let descriptor = MTLRenderPipelineDescriptor()
+            descriptor.label = "PerformanceHUDPipeline"
+            descriptor.vertexFunction = vertex
+            descriptor.fragmentFunction = fragment
+            descriptor.colorAttachments[0].pixelFormat = .bgra8Unorm
+            descriptor.colorAttachments[0].isBlendingEnabled = true
+            descriptor.colorAttachments[0].sourceRGBBlendFactor = .one
+            descriptor.colorAttachments[0].destinationRGBBlendFactor = .oneMinusSourceAlpha
+            descriptor.colorAttachments[0].sourceAlphaBlendFactor = .one
+            descriptor.colorAttachments[0].destinationAlphaBlendFactor = .oneMinusSourceAlpha
+            performanceHUD = try? makeRender(descriptor)
+        }
+
+        var matrixRain: MTLRenderPipelineState?
+        if let vertex = library.makeFunction(name: "matrix_rain_vertex"),
+           let fragment = library.makeFunction(name: "matrix_rain_fragment") {
+            let descriptor = MTLRenderPipelineDescriptor()
+            descriptor.label = "MatrixRainPipeline"
+            descriptor.vertexFunction = vertex
+            descriptor.fragmentFunction = fragment
+            descriptor.colorAttachments[0].pixelFormat = .bgra8Unorm
+            matrixRain = try? makeRender(descriptor)
+        }
+
+        var inlineImage: MTLRenderPipelineState?
+        if let vertex = library.makeFunction(name: "inline_image_vertex"),
+           let fragment = library.makeFunction(name: "inline_image_fragment") {
+            let descriptor = MTLRenderPipelineDescriptor()
+            descriptor.label = "InlineImagePipeline"
+            descriptor.vertexFunction = vertex
+            descriptor.fragmentFunction = fragment
+            descriptor.colorAttachments[0].pixelFormat = .bgra8Unorm
+            descriptor.colorAttachments[0].isBlendingEnabled = true
+            descriptor.colorAttachments[0].sourceRGBBlendFactor = .one
+            descriptor.colorAttachments[0].destinationRGBBlendFactor = .oneMinusSourceAlpha
+            descriptor.colorAttachments[0].sourceAlphaBlendFactor = .one
+            descriptor.colorAttachments[0].destinationAlphaBlendFactor = .oneMinusSourceAlpha
+            inlineImage = try? makeRender(descriptor)
+        }
+
+        // Compute pipelines are optional too; each has a CPU or fragment fallback.
+        func makeCompute(_ name: String, label: String) -> MTLComputePipelineState? {
+            guard let kernel = library.makeFunction(name: name) else { return nil }
+            let descriptor = MTLComputePipelineDescriptor()
+            descriptor.label = label
+            descriptor.computeFunction = kernel
+            if let archive {
+                descriptor.binaryArchives = [archive]
+                if !isStored, (try? archive.addComputePipelineFunctions(descriptor: descriptor)) != nil {
+                    needsSerialize = true
+                }
+            }
+            return try? device.makeComputePipelineState(descriptor: descriptor, options: [], reflection: nil)
+        }
+
+        let cellExpansion = makeCompute("expand_terminal_cells", label: "CellExpansionPipeline")
+        let bloomDownsample = makeCompute("bloom_downsample", label: "BloomDownsamplePipeline")
+        let bloomUpsample = makeCompute("bloom_upsample", label: "BloomUpsamplePipeline")
+        let thumbnailDownsample = makeCompute("thumbnail_downsample", label: "ThumbnailDownsamplePipeline")
+
+        if let archive, needsSerialize {
+            serialize(archive, for: device)
+        }
+
+        return TerminalPipelines(
+            scene: scene,
+            background: background,
+            postProcess: postProcess,
+            bloomBright: bloomBright,
+            bloomBlur: bloomBlur,
+            bloomDownsample: bloomDownsample,
+            bloomUpsample: bloomUpsample,
+            cellExpansion: cellExpansion,
+            performanceHUD: performanceHUD,
+            matrixRain: matrixRain,
+            inlineImage: inlineImage,
+            thumbnailDownsample: thumbnailDownsample
+        )
+    }
+}
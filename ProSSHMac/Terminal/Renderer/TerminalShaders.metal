@@ -16,20 +16,25 @@ using namespace metal;
 /// Attribute bit positions — must match CellAttributes in TerminalCell.swift.
 constant uint ATTR_BOLD          = (1u << 0);
 constant uint ATTR_DIM           = (1u << 1);
-// constant uint ATTR_ITALIC     = (1u << 2);  // handled by glyph rasterizer
+constant uint ATTR_ITALIC        = (1u << 2);  // glyph table key only
 constant uint ATTR_UNDERLINE     = (1u << 3);
 constant uint ATTR_BLINK         = (1u << 4);
 constant uint ATTR_REVERSE       = (1u << 5);
 constant uint ATTR_HIDDEN        = (1u << 6);
 constant uint ATTR_STRIKETHROUGH = (1u << 7);
 constant uint ATTR_DOUBLE_UNDER  = (1u << 8);
-// constant uint ATTR_WIDE_CHAR  = (1u << 9);  // layout only
+constant uint ATTR_WIDE_CHAR     = (1u << 9);  // continuation detection
 // constant uint ATTR_WRAPPED    = (1u << 10); // layout only
 constant uint ATTR_OVERLINE      = (1u << 11);
+constant uint ATTR_WIDE_CONTINUATION = (1u << 12);  // set by cell expansion
 
 /// Flag bit positions — must match CellInstance flags in GridSnapshot.swift.
+constant uint8_t FLAG_CURSOR   = (1u << 1);
 constant uint8_t FLAG_SELECTED = (1u << 2);
 
+/// Codepoints with this bit index the grapheme side table (GraphemeSideTable.sentinel).
+constant uint GRAPHEME_SENTINEL = 0x80000000u;
+
 /// Cursor style values — must match CursorStyle in VTConstants.swift.
 constant uint CURSOR_BLOCK     = 0;
 constant uint CURSOR_UNDERLINE = 1;
@@ -41,6 +46,14 @@ constant uint GLYPH_COORD_MASK = 0x3FFFu;
 constant uint GLYPH_Y_SHIFT = 14u;
 constant uint GLYPH_PAGE_SHIFT = 28u;
 constant uint MAX_ATLAS_PAGES = 16u;
+// Pages below this are .r8Unorm coverage; the rest are .bgra8Unorm colour
+// emoji. Must match GlyphAtlas.colorPageBase.
+constant uint COLOR_PAGE_BASE = 8u;
+
+/// Glyph table sentinels and miss log size — must match GPUGlyphTable and
+/// GlyphMissLog in GPUGlyphTable.swift.
+constant uint GLYPH_TABLE_EMPTY = 0xFFFFFFFFu;
+constant uint GLYPH_MISS_CAPACITY = 1024u;
 
 /// Decoration geometry constants.
 constant float UNDERLINE_THICKNESS  = 1.0;
@@ -74,7 +87,7 @@ constant float GLOW_STRENGTH = 0.12;  // max glow alpha
 struct CellInstance {
     ushort  row;            // grid row
     ushort  col;            // grid column
-    uint    glyphIndex;     // atlas position: [page:4][y:14][x:14]
+    uint    glyphIndex;     // codepoint; resolved to [page:4][y:14][x:14] by resolveGlyph
     uint    fgColor;        // packed RGBA (R in high byte)
     uint    bgColor;        // packed RGBA (R in high byte)
     uint    underlineColor; // packed RGBA for underline (0 = use fgColor)
@@ -83,6 +96,58 @@ struct CellInstance {
     uint8_t underlineStyle; // 0=none, 1=single, 2=double, 3=curly, 4=dotted, 5=dashed
 };
 
+/// A grid cell as stored — mirrors TerminalCell in TerminalCell.swift
+/// (20 bytes). Uploaded as-is in compact snapshot mode.
+struct PackedTerminalCell {
+    uint    codepoint;      // 0 = blank; GRAPHEME_SENTINEL bit = side table index
+    uint    fgColor;
+    uint    bgColor;
+    uint    underlineColor;
+    ushort  attributes;
+    uint8_t underlineStyle;
+    uint8_t width;          // 0 = right half of a wide character
+};
+
+/// Mirrors CellExpansionParams in CellExpansionPass.swift.
+struct CellExpansionParams {
+    uint cellCount;
+    uint columns;
+    uint cursorIndex;       // 0xFFFFFFFF = no visible cursor
+    uint rowBase;           // source row holding grid row 0
+};
+
+/// Horizontal span of cells sharing a background colour — mirrors
+/// BackgroundRun in CellDrawLists.swift.
+struct BackgroundRun {
+    ushort row;
+    ushort col;
+    ushort count;
+    ushort reserved;
+    uint   bgColor;        // packed RGBA; 0 = default background
+};
+
+/// One glyph table slot: packed key (codepoint << 2 | bold << 1 | italic)
+/// and packed atlas position.
+struct GlyphTableSlot {
+    uint key;
+    uint value;
+};
+
+/// Table geometry — mirrors GPUGlyphTable.Params.
+struct GlyphTableParams {
+    uint mask;    // slot count - 1
+    uint shift;   // 32 - log2(slot count)
+};
+
+/// Keys the vertex shader could not resolve this frame.
+struct GlyphMissLog {
+    atomic_uint count;
+    uint _pad0;
+    uint _pad1;
+    uint _pad2;
+    uint keys[GLYPH_MISS_CAPACITY];
+};
+
 /// Per-frame uniforms set by the CPU.
 struct TerminalUniforms {
     float2 cellSize;       // pixel dimensions of one cell
@@ -163,9 +228,10 @@ struct TerminalUniforms {
 
     // -- Smooth Scroll --
     float   scrollOffsetPixels;      // sub-pixel vertical offset for smooth scrolling
-    float   _scrollPad0;
-    float   _scrollPad1;
-    float   _scrollPad2;
+    uint    scrollRowBase;           // 16-bit cell row at the viewport top (scrollback row ring)
+
+    // -- Glyph Atlas --
+    float2  atlasCellSize;           // atlas slot in pixels; differs from cellSize for a scaled stand-in
 };
 
 /// Vertex-to-fragment interpolants.
@@ -202,20 +268,95 @@ inline float gaussianFalloff(float dist, float sigma) {
     return exp(-(dist * dist) / (2.0 * sigma * sigma));
 }
 
+// ---------------------------------------------------------------------------
+// MARK: - Glyph Resolution
+// ---------------------------------------------------------------------------
+
+/// Look up a cell's codepoint and style in the glyph table. Hits mark their
+/// slot used (for the CPU-side LRU); misses are appended to the miss log.
+/// Only `report` invocations write, so each cell reports once, not per vertex.
+inline uint resolveGlyph(
+    uint codepoint,
+    uint attributes,
+    const device GlyphTableSlot *table,
+    device uchar *usage,
+    device GlyphMissLog *misses,
+    constant GlyphTableParams &params,
+    bool report
+) {
+    uint key = (codepoint << 2)
+        | (((attributes & ATTR_BOLD) != 0) ? 2u : 0u)
+        | (((attributes & ATTR_ITALIC) != 0) ? 1u : 0u);
+    uint index = (key * 0x9E3779B1u) >> params.shift;
+    // The CPU keeps the table at most 3/4 full, so an empty slot ends every probe.
+    for (uint probe = 0; probe <= params.mask; ++probe) {
+        uint slotKey = table[index].key;
+        if (slotKey == key) {
+            if (report) {
+                usage[index] = 1;
+            }
+            return table[index].value;
+        }
+        if (slotKey == GLYPH_TABLE_EMPTY) {
+            break;
+        }
+        index = (index + 1) & params.mask;
+    }
+    if (report) {
+        uint slot = atomic_fetch_add_explicit(&misses->count, 1u, memory_order_relaxed);
+        if (slot < GLYPH_MISS_CAPACITY) {
+            misses->keys[slot] = key;
+        }
+    }
+    return GLYPH_INDEX_NONE;
+}
+
 // ---------------------------------------------------------------------------
 // MARK: - Vertex Shader (B.5.3)
 // ---------------------------------------------------------------------------
 
 /// Instanced vertex shader: 6 vertices per instance form a quad for one cell.
 /// Positions the quad at (col, row) * cellSize and transforms to NDC.
+/// Instances index `cellIndices`, the compacted list of cells that draw
+/// more than their background (see CellDrawLists.swift).
 vertex VertexOut terminal_vertex(
     uint vid [[vertex_id]],
     uint iid [[instance_id]],
     constant CellInstance *cells [[buffer(0)]],
-    constant TerminalUniforms &uniforms [[buffer(1)]]
+    constant TerminalUniforms &uniforms [[buffer(1)]],
+    const device GlyphTableSlot *glyphTable [[buffer(2)]],
+    device uchar *glyphUsage [[buffer(3)]],
+    device GlyphMissLog *glyphMisses [[buffer(4)]],
+    constant GlyphTableParams &glyphParams [[buffer(5)]],
+    constant uint *cellIndices [[buffer(6)]]
 ) {
-    // Fetch the cell for this instance.
-    CellInstance cell = cells[iid];
+    // Fetch the cell for this instance. `glyphIndex` holds the codepoint.
+    uint cellIndex = cellIndices[iid];
+    CellInstance cell = cells[cellIndex];
+
+    // Right half of a wide character: no glyph, colours from the primary.
+    // Empty/NUL cells must not sample atlas texel (0,0).
+    uint glyphIndex;
+    bool isContinuation = false;
+    if (cellIndex > 0) {
+        CellInstance previous = cells[cellIndex - 1];
+        isContinuation = (uint(previous.attributes) & ATTR_WIDE_CHAR) != 0
+            && previous.row == cell.row
+            && (uint(cell.attributes) & ATTR_WIDE_CHAR) == 0;
+        if (isContinuation) {
+            cell.fgColor = previous.fgColor;
+            cell.bgColor = previous.bgColor;
+        }
+    }
+    if (isContinuation || cell.glyphIndex == 0) {
+        glyphIndex = GLYPH_INDEX_NONE;
+    } else {
+        glyphIndex = resolveGlyph(
+            cell.glyphIndex, uint(cell.attributes),
+            glyphTable, glyphUsage, glyphMisses, glyphParams,
+            vid == 0
+        );
+    }
 
     // Quad corners: two triangles forming a rectangle.
     //   v0--v1     Triangle 0: v0, v1, v2
@@ -235,8 +376,14 @@ vertex VertexOut terminal_vertex(
     // Bounds-check vid to prevent out-of-bounds access into corners array.
     float2 corner = corners[min(vid, 5u)];
 
-    // Cell origin in pixels (top-left corner of this cell).
-    float2 cellOrigin = float2(float(cell.col), float(cell.row)) * uniforms.cellSize;
+    // Cell origin in pixels (top-left corner of this cell). Rows are taken
+    // relative to scrollRowBase modulo 2^16, so scrollback row ring cells,
+    // which carry their line position, land at their viewport row.
+    int row = int((uint(cell.row) - uniforms.scrollRowBase) & 0xFFFFu);
+    if (row >= 0x8000) {
+        row -= 0x10000;
+    }
+    float2 cellOrigin = float2(float(cell.col), float(row)) * uniforms.cellSize;
 
     // Vertex position in pixels.
     float2 pixelPos = cellOrigin + corner * uniforms.cellSize;
@@ -256,14 +403,14 @@ vertex VertexOut terminal_vertex(
     // When glyphIndex is GLYPH_INDEX_NONE, output zero UV so the fragment
     // shader does not sample arbitrary atlas texels.
     float2 uv;
-    if (cell.glyphIndex == GLYPH_INDEX_NONE) {
+    if (glyphIndex == GLYPH_INDEX_NONE) {
         uv = float2(0.0, 0.0);
     } else {
-        float atlasX = float(cell.glyphIndex & GLYPH_COORD_MASK);
-        float atlasY = float((cell.glyphIndex >> GLYPH_Y_SHIFT) & GLYPH_COORD_MASK);
+        float atlasX = float(glyphIndex & GLYPH_COORD_MASK);
+        float atlasY = float((glyphIndex >> GLYPH_Y_SHIFT) & GLYPH_COORD_MASK);
 
         float2 uvOrigin = float2(atlasX, atlasY) / uniforms.atlasSize;
-        float2 uvSize   = uniforms.cellSize / uniforms.atlasSize;
+        float2 uvSize   = uniforms.atlasCellSize / uniforms.atlasSize;
         uv = uvOrigin + corner * uvSize;
     }
 
@@ -275,8 +422,8 @@ vertex VertexOut terminal_vertex(
     out.fgColor        = cell.fgColor;
     out.bgColor        = cell.bgColor;
     out.underlineColor = cell.underlineColor;
-    out.glyphIndex     = cell.glyphIndex;
-    out.atlasPage      = (cell.glyphIndex >> GLYPH_PAGE_SHIFT) & 0x0Fu;
+    out.glyphIndex     = glyphIndex;
+    out.atlasPage      = (glyphIndex >> GLYPH_PAGE_SHIFT) & 0x0Fu;
     out.attributes     = uint(cell.attributes);
     out.flags          = cell.flags;
     out.underlineStyle = cell.underlineStyle;
@@ -371,11 +518,26 @@ fragment float4 terminal_fragment(
         address::clamp_to_zero
     );
 
+    // A stand-in atlas drawn at another size is filtered rather than
+    // snapped to texels.
+    constexpr sampler scaledAtlasSampler(
+        mag_filter::linear,
+        min_filter::linear,
+        address::clamp_to_zero
+    );
+    bool atlasIsScaled = any(uniforms.atlasCellSize != uniforms.cellSize);
+
     float glyphAlpha = 0.0;
+    bool isColorGlyph = false;
+    float4 glyphSample = float4(0.0);
     if (in.glyphIndex != GLYPH_INDEX_NONE) {
         uint atlasPage = min(in.atlasPage, MAX_ATLAS_PAGES - 1u);
-        float4 glyphSample = atlasPages[atlasPage].sample(atlasSampler, in.uv);
-        glyphAlpha = glyphSample.a;
+        glyphSample = atlasIsScaled
+            ? atlasPages[atlasPage].sample(scaledAtlasSampler, in.uv)
+            : atlasPages[atlasPage].sample(atlasSampler, in.uv);
+        // Coverage pages are single-channel; colour pages are premultiplied BGRA.
+        isColorGlyph = atlasPage >= COLOR_PAGE_BASE;
+        glyphAlpha = isColorGlyph ? glyphSample.a : glyphSample.r;
     }
 
     // -------------------------------------------------------------------
@@ -385,6 +547,10 @@ fragment float4 terminal_fragment(
     if (isHidden || blinkHidden) {
         // Hidden or blink-off: show only background.
         color = bg;
+    } else if (isColorGlyph) {
+        // Colour emoji keep their own colours (premultiplied over bg).
+        color.rgb = glyphSample.rgb + bg.rgb * (1.0 - glyphAlpha);
+        color.a   = 1.0;
     } else {
         // Standard alpha blend: fg over bg weighted by glyph alpha.
         color.rgb = mix(bg.rgb, fg.rgb, glyphAlpha);
@@ -581,6 +747,89 @@ fragment float4 terminal_fragment(
     return color;
 }
 
+// ---------------------------------------------------------------------------
+// MARK: - Background Runs
+// ---------------------------------------------------------------------------
+
+struct BackgroundVertexOut {
+    float4 position [[position]];
+    uint   bgColor;
+};
+
+/// One flat quad per background run, drawn before the cell pass.
+vertex BackgroundVertexOut terminal_background_vertex(
+    uint vid [[vertex_id]],
+    uint iid [[instance_id]],
+    constant BackgroundRun *runs [[buffer(0)]],
+    constant TerminalUniforms &uniforms [[buffer(1)]]
+) {
+    BackgroundRun run = runs[iid];
+    float2 corners[6] = {
+        float2(0.0, 0.0), float2(1.0, 0.0), float2(0.0, 1.0),
+        float2(0.0, 1.0), float2(1.0, 0.0), float2(1.0, 1.0),
+    };
+    float2 corner = corners[min(vid, 5u)];
+
+    float2 origin = float2(float(run.col), float(run.row)) * uniforms.cellSize;
+    float2 size = float2(float(run.count), 1.0) * uniforms.cellSize;
+    float2 pixelPos = origin + corner * size;
+    pixelPos.y += uniforms.scrollOffsetPixels;
+
+    BackgroundVertexOut out;
+    out.position = float4(
+        (pixelPos.x / uniforms.viewportSize.x) *  2.0 - 1.0,
+        (pixelPos.y / uniforms.viewportSize.y) * -2.0 + 1.0,
+        0.0, 1.0
+    );
+    out.bgColor = run.bgColor;
+    return out;
+}
+
+/// Matches what terminal_fragment produces for a blank cell.
+fragment float4 terminal_background_fragment(BackgroundVertexOut in [[stage_in]]) {
+    float4 bg = unpackColor(in.bgColor);
+    if (bg.a < 0.001) {
+        bg = float4(0.0, 0.0, 0.0, 1.0);
+    }
+    return float4(bg.rgb, 1.0);
+}
+
+// ---------------------------------------------------------------------------
+// MARK: - Cell Expansion
+// ---------------------------------------------------------------------------
+
+/// Expand compact cells into CellInstances, one thread per cell. Matches
+/// CellInstance(expanding:row:col:isCursor:) in GridSnapshot.swift.
+kernel void expand_terminal_cells(
+    device const PackedTerminalCell *src [[buffer(0)]],
+    device CellInstance *dst [[buffer(1)]],
+    constant CellExpansionParams &params [[buffer(2)]],
+    uint gid [[thread_position_in_grid]]
+) {
+    if (gid >= params.cellCount) {
+        return;
+    }
+    PackedTerminalCell cell = src[gid];
+
+    // Source rows are rotated by rowBase; write each to its grid row.
+    uint rows = params.cellCount / params.columns;
+    uint row = (gid / params.columns + rows - params.rowBase) % rows;
+    uint col = gid % params.columns;
+    uint index = row * params.columns + col;
+
+    CellInstance out;
+    out.row = ushort(row);
+    out.col = ushort(col);
+    out.glyphIndex = (cell.codepoint & GRAPHEME_SENTINEL) != 0 ? 0u : cell.codepoint;
+    out.fgColor = cell.fgColor;
+    out.bgColor = cell.bgColor;
+    out.underlineColor = cell.underlineColor;
+    out.attributes = ushort(uint(cell.attributes) | (cell.width == 0 ? ATTR_WIDE_CONTINUATION : 0u));
+    out.flags = index == params.cursorIndex ? FLAG_CURSOR : uint8_t(0);
+    out.underlineStyle = cell.underlineStyle;
+    dst[index] = out;
+}
+
 // ---------------------------------------------------------------------------
 // MARK: - Gradient Background Utilities
 // ---------------------------------------------------------------------------
@@ -1039,3 +1288,260 @@ fragment float4 bloom_blur_fragment(
     }
     return float4(result * params.radius, 1.0);
 }
+
+// MARK: - Compute Bloom Chain
+
+/// Mirrors BloomChainParams in BloomChain.swift.
+struct BloomChainParams {
+    float2 sourceTexel;  // 1.0 / source texture size
+    float threshold;     // bright-pass cutoff; < 0 = plain downsample
+    float gain;          // output scale (bloom radius on the final upsample)
+};
+
+/// One bilinear tap, through the bright-pass knee when `threshold` >= 0.
+/// Same curve as bloom_bright_fragment.
+inline float3 bloomChainTap(texture2d<float> tex, sampler s, float2 uv, float threshold) {
+    float3 color = tex.sample(s, uv).rgb;
+    if (threshold < 0.0f) {
+        return color;
+    }
+    float lum = dot(color, float3(0.2126, 0.7152, 0.0722));
+    float bright = max(0.0f, lum - threshold) / max(0.001f, 1.0f - threshold);
+    return color * (bright * bright);
+}
+
+/// Dual-filter downsample: the centre plus four diagonal bilinear taps one
+/// source texel out, covering a 4x4 source footprint per output pixel.
+kernel void bloom_downsample(
+    texture2d<float> src [[texture(0)]],
+    texture2d<float, access::write> dst [[texture(1)]],
+    constant BloomChainParams &params [[buffer(0)]],
+    uint2 gid [[thread_position_in_grid]]
+) {
+    if (gid.x >= dst.get_width() || gid.y >= dst.get_height()) {
+        return;
+    }
+    constexpr sampler s(mag_filter::linear, min_filter::linear, address::clamp_to_edge);
+    float2 uv = (float2(gid) + 0.5) / float2(dst.get_width(), dst.get_height());
+    float2 o = params.sourceTexel;
+
+    float3 sum = bloomChainTap(src, s, uv, params.threshold) * 4.0;
+    sum += bloomChainTap(src, s, uv + float2(-o.x, -o.y), params.threshold);
+    sum += bloomChainTap(src, s, uv + float2( o.x, -o.y), params.threshold);
+    sum += bloomChainTap(src, s, uv + float2(-o.x,  o.y), params.threshold);
+    sum += bloomChainTap(src, s, uv + float2( o.x,  o.y), params.threshold);
+    dst.write(float4(sum / 8.0, 1.0), gid);
+}
+
+/// Dual-filter upsample: an 8-tap tent over the smaller level, averaged
+/// with the same-sized down level so every scale contributes to the halo.
+kernel void bloom_upsample(
+    texture2d<float> src [[texture(0)]],
+    texture2d<float, access::read> lateral [[texture(1)]],
+    texture2d<float, access::write> dst [[texture(2)]],
+    constant BloomChainParams &params [[buffer(0)]],
+    uint2 gid [[thread_position_in_grid]]
+) {
+    if (gid.x >= dst.get_width() || gid.y >= dst.get_height()) {
+        return;
+    }
+    constexpr sampler s(mag_filter::linear, min_filter::linear, address::clamp_to_edge);
+    float2 uv = (float2(gid) + 0.5) / float2(dst.get_width(), dst.get_height());
+    float2 o = params.sourceTexel * 0.5;
+
+    float3 sum = src.sample(s, uv + float2(-2.0 * o.x, 0.0)).rgb;
+    sum += src.sample(s, uv + float2( 2.0 * o.x, 0.0)).rgb;
+    sum += src.sample(s, uv + float2(0.0, -2.0 * o.y)).rgb;
+    sum += src.sample(s, uv + float2(0.0,  2.0 * o.y)).rgb;
+    sum += src.sample(s, uv + float2(-o.x, -o.y)).rgb * 2.0;
+    sum += src.sample(s, uv + float2( o.x, -o.y)).rgb * 2.0;
+    sum += src.sample(s, uv + float2(-o.x,  o.y)).rgb * 2.0;
+    sum += src.sample(s, uv + float2( o.x,  o.y)).rgb * 2.0;
+
+    float3 color = (sum / 12.0 + lateral.read(gid).rgb) * 0.5;
+    dst.write(float4(color * params.gain, 1.0), gid);
+}
+
+// ---------------------------------------------------------------------------
+// MARK: - Session Thumbnails
+// ---------------------------------------------------------------------------
+
+struct ThumbnailParams {
+    uint2 origin;  // top-left of the slot in the thumbnail atlas
+    uint2 size;    // slot size in pixels
+};
+
+/// Box-filters the presented frame into one slot of the shared thumbnail
+/// atlas (SessionThumbnailAtlas). Each output pixel averages a 4x4 grid of
+/// bilinear taps spread over its source footprint, so thin glyph strokes
+/// fade to grey instead of aliasing away.
+kernel void thumbnail_downsample(
+    texture2d<float> src [[texture(0)]],
+    texture2d<float, access::write> atlas [[texture(1)]],
+    constant ThumbnailParams &params [[buffer(0)]],
+    uint2 gid [[thread_position_in_grid]]
+) {
+    if (gid.x >= params.size.x || gid.y >= params.size.y) {
+        return;
+    }
+    constexpr sampler s(mag_filter::linear, min_filter::linear, address::clamp_to_edge);
+    float2 size = float2(params.size);
+    float2 uv = (float2(gid) + 0.5) / size;
+    float2 footprint = 1.0 / size;
+
+    float3 sum = float3(0.0);
+    for (uint y = 0; y < 4; y++) {
+        for (uint x = 0; x < 4; x++) {
+            float2 offset = (float2(x, y) + 0.5) / 4.0 - 0.5;
+            sum += src.sample(s, uv + offset * footprint).rgb;
+        }
+    }
+    atlas.write(float4(sum / 16.0, 1.0), params.origin + gid);
+}
+
+// ---------------------------------------------------------------------------
+// MARK: - Performance HUD
+// ---------------------------------------------------------------------------
+
+struct HUDVertexOut {
+    float4 position [[position]];
+    float2 uv;
+};
+
+/// Textured quad over `rect` (NDC left, top, right, bottom), drawn as a
+/// four-vertex triangle strip.
+vertex HUDVertexOut performance_hud_vertex(
+    uint vid [[vertex_id]],
+    constant float4 &rect [[buffer(0)]]
+) {
+    float2 corner = float2(float(vid & 1), float(vid >> 1));
+    HUDVertexOut out;
+    out.position = float4(mix(rect.x, rect.z, corner.x), mix(rect.y, rect.w, corner.y), 0.0, 1.0);
+    out.uv = corner;
+    return out;
+}
+
+/// The HUD texture is premultiplied, so it blends with one / one-minus-alpha.
+fragment float4 performance_hud_fragment(
+    HUDVertexOut in [[stage_in]],
+    texture2d<float> hud [[texture(0)]]
+) {
+    constexpr sampler s(filter::nearest, address::clamp_to_edge);
+    return hud.sample(s, in.uv);
+}
+
+// ---------------------------------------------------------------------------
+// MARK: - Inline Images
+// ---------------------------------------------------------------------------
+
+/// An image quad over `rect` (NDC left, top, right, bottom). Parts above or
+/// below the viewport are clipped by the rasterizer.
+vertex HUDVertexOut inline_image_vertex(
+    uint vid [[vertex_id]],
+    constant float4 &rect [[buffer(0)]]
+) {
+    float2 corner = float2(float(vid & 1), float(vid >> 1));
+    HUDVertexOut out;
+    out.position = float4(mix(rect.x, rect.z, corner.x), mix(rect.y, rect.w, corner.y), 0.0, 1.0);
+    out.uv = corner;
+    return out;
+}
+
+/// Images are decoded premultiplied and usually scaled, so sample linearly.
+fragment float4 inline_image_fragment(
+    HUDVertexOut in [[stage_in]],
+    texture2d<float> image [[texture(0)]]
+) {
+    constexpr sampler s(filter::linear, address::clamp_to_edge);
+    return image.sample(s, in.uv);
+}
+
+// ---------------------------------------------------------------------------
+// MARK: - Matrix Rain (idle screensaver)
+// ---------------------------------------------------------------------------
+
+/// Must match MatrixRainUniforms in MatrixRainRenderer.swift.
+struct MatrixRainUniforms {
+    float2 viewportSize;   // pixels
+    float2 cellSize;       // pixels
+    float  time;           // seconds since the screensaver started
+    float  speed;
+    float  density;        // fraction of columns with a stream
+    uint   trailLength;
+    uint   glyphCount;
+    uint   seed;
+    float4 color;
+};
+
+/// Integer avalanche hash (lowbias32). Must match MatrixRainColumn.hash.
+inline uint matrix_rain_hash(uint x) {
+    x ^= x >> 16;
+    x *= 0x7feb352du;
+    x ^= x >> 15;
+    x *= 0x846ca68bu;
+    x ^= x >> 16;
+    return x;
+}
+
+inline float matrix_rain_unit(uint x) {
+    return float(matrix_rain_hash(x)) / 4294967295.0;
+}
+
+struct MatrixRainVertexOut {
+    float4 position [[position]];
+};
+
+/// One triangle covering the viewport.
+vertex MatrixRainVertexOut matrix_rain_vertex(uint vid [[vertex_id]]) {
+    float2 corner = float2(float((vid << 1) & 2), float(vid & 2));
+    MatrixRainVertexOut out;
+    out.position = float4(corner * 2.0 - 1.0, 0.0, 1.0);
+    return out;
+}
+
+/// Each pixel works out its cell, that column's stream and the stream's
+/// head row from the time alone, the same way MatrixRainColumn does on the
+/// CPU, then samples the cell's glyph from the atlas coverage page.
+fragment float4 matrix_rain_fragment(
+    MatrixRainVertexOut in [[stage_in]],
+    constant MatrixRainUniforms &uniforms [[buffer(0)]],
+    constant float4 *glyphRects [[buffer(1)]],
+    texture2d<float> atlas [[texture(0)]]
+) {
+    const float4 black = float4(0.0, 0.0, 0.0, 1.0);
+    float2 cell = floor(in.position.xy / uniforms.cellSize);
+    int rows = int(uniforms.viewportSize.y / uniforms.cellSize.y);
+    int columns = int(uniforms.viewportSize.x / uniforms.cellSize.x);
+    int column = int(cell.x);
+    int row = int(cell.y);
+    if (rows <= 0 || column >= columns || row >= rows || uniforms.glyphCount == 0u) {
+        return black;
+    }
+
+    uint base = matrix_rain_hash(uint(column) * 0x9e3779b9u ^ uniforms.seed);
+    if (matrix_rain_unit(base) >= uniforms.density) {
+        return black;
+    }
+    float span = max(1.0, float(rows * 2));
+    float startOffset = -(matrix_rain_unit(base ^ 0xa5a5a5a5u) * span);
+    float fallSpeed = uniforms.speed * (0.5 + matrix_rain_unit(base ^ 0x5a5a5a5au)) * 12.0;
+    float cycle = float(rows) + float(uniforms.trailLength);
+    float wrapped = fmod(startOffset + uniforms.time * fallSpeed, cycle);
+    int head = int(wrapped < 0.0 ? wrapped + cycle : wrapped);
+
+    int offset = head - row;
+    if (offset < 0 || offset >= int(uniforms.trailLength)) {
+        return black;
+    }
+
+    uint tick = uint(uniforms.time * 3.0) & 0x7fffffffu;
+    uint glyph = (uint(column) * 31u + uint(row) * 17u + tick) % uniforms.glyphCount;
+    float4 rect = glyphRects[glyph];
+    float2 local = fract(in.position.xy / uniforms.cellSize);
+    constexpr sampler atlasSampler(filter::linear, address::clamp_to_zero);
+    float coverage = atlas.sample(atlasSampler, mix(rect.xy, rect.zw, local)).r;
+
+    float fade = offset == 0 ? 1.0 : max(0.05, 1.0 - float(offset) / float(uniforms.trailLength));
+    float3 tint = offset == 0 ? uniforms.color.rgb * 0.3 + 0.7 : uniforms.color.rgb * fade;
+    return float4(tint * fade * coverage, 1.0);
+}
@@ -56,8 +56,8 @@ struct TerminalUniformData {
     /// effects such as cursor blink and glow.
     var time: Float
 
-    /// Cursor blink phase, smoothly oscillating between 0.0 (fully hidden)
-    /// and 1.0 (fully visible).
+    /// Cursor visibility phase between 0.0 (fully hidden) and 1.0 (fully
+    /// visible). Blinking alternates between the two at half-period edges.
     var cursorPhase: Float
 
     /// Cursor row position in grid space (fractional for smooth animation).
@@ -248,10 +248,17 @@ struct TerminalUniformData {
     /// Applied in the vertex shader to shift all cell quads by a fractional amount.
     var scrollOffsetPixels: Float
 
-    /// Padding to maintain 16-byte struct alignment.
-    var _scrollPad0: Float
-    var _scrollPad1: Float
-    var _scrollPad2: Float
+    /// Cell row drawn at the top of the viewport, as 16 bits. Zero except
+    /// while drawing from the scrollback row ring, whose cells carry their
+    /// line position in `row` (see ScrollbackRowRing).
+    var scrollRowBase: UInt32
+
+    // -- Glyph Atlas --
+
+    /// Pixel size of one atlas slot. Differs from `cellSize` only while a
+    /// pane draws the previous font size's atlas, scaled, as a stand-in for
+    /// the new one.
+    var atlasCellSize: SIMD2<Float>
 }
 
 // MARK: - TerminalUniformBuffer
@@ -259,8 +266,8 @@ struct TerminalUniformData {
 /// Manages a Metal buffer containing `TerminalUniformData` for per-frame
 /// upload to the GPU.
 ///
-/// This class tracks animation time since first use and computes a smooth
-/// sinusoidal cursor blink phase. It is designed to be updated on the render
+/// This class tracks animation time since first use and computes the
+/// fallback cursor blink phase. It is designed to be updated on the render
 /// thread each frame -- it is **not** an actor or Sendable type.
 ///
 /// Usage:
@@ -286,8 +293,8 @@ final class TerminalUniformBuffer {
 
     /// Duration of one half-cycle of the cursor blink, in seconds.
     /// The full blink cycle (visible -> hidden -> visible) takes twice this value.
-    /// Default: 0.53 seconds (530 ms), producing a 1.06-second full cycle.
-    var blinkHalfPeriod: Float = 0.53
+    /// Default: `CursorBlinkClock.halfPeriod` (530 ms), producing a 1.06-second full cycle.
+    var blinkHalfPeriod: Float = Float(CursorBlinkClock.halfPeriod)
 
     /// Default opacity for the SGR dim (faint) attribute.
     /// Terminals typically render dim text at approximately 50% opacity.
@@ -343,6 +350,7 @@ final class TerminalUniformBuffer {
     ///   - barrelDistortion: Barrel distortion warp strength.
     ///   - phosphorBlend: Previous-frame phosphor blend multiplier.
     ///   - contentScale: Screen scale factor for Retina rendering (default 1.0).
+    ///   - atlasCellSize: Pixel size of an atlas slot, or nil when it is `cellSize`.
     func update(
         cellSize: SIMD2<Float>,
         viewportSize: SIMD2<Float>,
@@ -369,7 +377,9 @@ final class TerminalUniformBuffer {
         scannerConfig: ScannerEffectConfiguration? = nil,
         bloomConfig: BloomEffectConfiguration? = nil,
         isLocalSession: Bool = false,
-        scrollOffsetPixels: Float = 0.0
+        scrollOffsetPixels: Float = 0.0,
+        scrollRowBase: UInt32 = 0,
+        atlasCellSize: SIMD2<Float>? = nil
     ) {
         // B.7.2: Track animation time
         let now = CACurrentMediaTime()
@@ -390,7 +400,7 @@ final class TerminalUniformBuffer {
         } else if !cursorBlinkEnabled {
             phase = 1.0
         } else {
-            phase = computeBlinkPhase(time: elapsed)
+            phase = computeBlinkPhase(time: now)
         }
 
         // Resolve gradient configuration.
@@ -483,9 +493,8 @@ final class TerminalUniformBuffer {
             bloomIntensity: min(2, max(0, effectiveBloomIntensity)),
             bloomAnimateWithGradient: bc.animateWithGradient ? 1 : 0,
             scrollOffsetPixels: scrollOffsetPixels,
-            _scrollPad0: 0,
-            _scrollPad1: 0,
-            _scrollPad2: 0
+            scrollRowBase: scrollRowBase,
+            atlasCellSize: atlasCellSize ?? cellSize
         )
 
         // Copy into the Metal buffer
@@ -505,18 +514,20 @@ final class TerminalUniformBuffer {
 
     // MARK: - B.7.3 Cursor Blink Phase
 
-    /// Computes a smooth sinusoidal blink phase for the cursor.
+    /// Computes the blink phase for the cursor: 1.0 (visible) for the first
+    /// half period of each cycle, 0.0 (hidden) for the second.
     ///
-    /// The phase oscillates between 0.0 (fully hidden) and 1.0 (fully visible)
-    /// using a sine wave, producing a gentle fade rather than a hard on/off toggle.
+    /// The phase is taken from shared media time rather than this buffer's
+    /// elapsed time, so it matches every other pane and CursorBlinkClock.
     ///
-    /// Formula: `phase = (sin(time * pi / blinkHalfPeriod) + 1) / 2`
-    ///
-    /// - Parameter time: Elapsed time in seconds since animation start.
-    /// - Returns: Blink phase value in the range [0.0, 1.0].
-    private func computeBlinkPhase(time: Float) -> Float {
-        let angularFrequency = Float.pi / blinkHalfPeriod
-        let raw = sinf(time * angularFrequency)
-        return (raw + 1.0) / 2.0
+    /// - Parameter time: Media time (`CACurrentMediaTime`) in seconds.
+    /// - Returns: Blink phase, 0.0 or 1.0.
+    private func computeBlinkPhase(time: CFTimeInterval) -> Float {
+        CursorEffects.blinkPhase(
+            time: time,
+            halfPeriod: CFTimeInterval(blinkHalfPeriod),
+            visible: true,
+            blinkEnabled: true
+        )
     }
 }
@@ -1,4 +1,5 @@
 import SwiftUI
+import UniformTypeIdentifiers
 
 struct CertificatesView: View {
     @EnvironmentObject private var viewModel: CertificatesViewModel
@@ -9,6 +10,12 @@ struct CertificatesView: View {
     @State private var krlDraft = KRLGenerationDraft()
     @State private var importCertificateInput = ""
     @State private var generatedKRLBundle: GeneratedKRLBundle?
+    @State private var showingBaseKRLImporter = false
+    @State private var showingKRLExporter = false
+    @State private var batchDraft = BatchCertificateIssuanceDraft()
+    @State private var batchResult: BatchCertificateIssuanceResult?
+    @State private var showingBatchExportPicker = false
+    @State private var batchExportAsArchive = false
     @State private var operationMessage: String?
 
     var body: some View {
@@ -16,12 +23,23 @@ struct CertificatesView: View {
             createCASection
             signUserCertificateSection
             signHostCertificateSection
+            bulkIssueSection
             importCertificateSection
             generateKRLSection
             authoritiesSection
             issuedCertificatesSection
         }
         .navigationTitle("Certificates")
+        .fileExporter(
+            isPresented: $showingKRLExporter,
+            document: generatedKRLBundle.map { KRLFileDocument(data: $0.krlData) },
+            contentType: .data,
+            defaultFilename: generatedKRLBundle.map { "\($0.fileStem).krl" }
+        ) { result in
+            if case let .failure(error) = result {
+                operationMessage = "Saving KRL failed: \(error.localizedDescription)"
+            }
+        }
         .task {
             await viewModel.loadAuthoritiesIfNeeded()
             seedUserDraftDefaultsIfNeeded()
@@ -256,6 +274,96 @@ struct CertificatesView: View {
         }
     }
 
+    private var bulkIssueSection: some View {
+        Section("Bulk Issue Certificates") {
+            let authorities = batchDraft.role == .host ? hostSigningAuthorities : userSigningAuthorities
+            Picker("Certificate Type", selection: $batchDraft.role) {
+                Text("Host").tag(CertificateRole.host)
+                Text("User").tag(CertificateRole.user)
+            }
+
+            Picker("Signing CA", selection: $batchDraft.authorityID) {
+                Text("Select a CA").tag(UUID?.none)
+                ForEach(authorities) { authority in
+                    Text("\(authority.label) (\(authority.certificateType.rawValue))")
+                        .tag(Optional(authority.id))
+                }
+            }
+
+            DatePicker("Valid After", selection: $batchDraft.validAfter)
+            DatePicker("Valid Before", selection: $batchDraft.validBefore)
+
+            TextField("Inventory CSV (key_id,principals,public_key)", text: $batchDraft.inventoryCSV, axis: .vertical)
+                .lineLimit(4...10)
+                .font(.caption.monospaced())
+                .iosAutocapitalizationNever()
+                .autocorrectionDisabled()
+
+            Text("One certificate per line. Separate principals with ';'. Serials are assigned from the CA's next serial.")
+                .font(.footnote)
+                .foregroundStyle(.secondary)
+
+            Button {
+                Task {
+                    if let result = await viewModel.issueCertificates(from: batchDraft) {
+                        batchResult = result
+                        operationMessage = result.throughputSummary
+                    }
+                }
+            } label: {
+                if viewModel.isIssuingBatch {
+                    ProgressView()
+                } else {
+                    Text("Issue Certificates")
+                }
+            }
+            .disabled(viewModel.isIssuingBatch || batchDraft.authorityID == nil)
+
+            if let batchResult {
+                Text(batchResult.throughputSummary)
+                    .font(.caption)
+                    .foregroundStyle(.secondary)
+
+                ForEach(batchResult.failures.prefix(5), id: \.subjectIndex) { failure in
+                    Text("Row \(failure.subjectIndex + 1) (\(failure.keyID)): \(failure.message)")
+                        .font(.caption)
+                        .foregroundStyle(.red)
+                }
+                if batchResult.failures.count > 5 {
+                    Text("\(batchResult.failures.count - 5) more row(s) failed.")
+                        .font(.caption)
+                        .foregroundStyle(.secondary)
+                }
+
+                Button("Export to Folder...") {
+                    batchExportAsArchive = false
+                    showingBatchExportPicker = true
+                }
+                .buttonStyle(.borderless)
+
+                Button("Export as Zip Archive...") {
+                    batchExportAsArchive = true
+                    showingBatchExportPicker = true
+                }
+                .buttonStyle(.borderless)
+            }
+        }
+        .fileImporter(
+            isPresented: $showingBatchExportPicker,
+            allowedContentTypes: [.folder],
+            allowsMultipleSelection: false
+        ) { result in
+            guard case let .success(urls) = result, let folderURL = urls.first, let batchResult else { return }
+            if let exported = viewModel.exportIssuedCertificates(
+                batchResult,
+                to: folderURL,
+                asArchive: batchExportAsArchive
+            ) {
+                operationMessage = "Exported \(batchResult.issued.count) certificate(s) to \(exported.lastPathComponent)."
+            }
+        }
+    }
+
     private var importCertificateSection: some View {
         Section("Import Certificate") {
             TextField("OpenSSH certificate line", text: $importCertificateInput, axis: .vertical)
@@ -309,16 +417,42 @@ struct CertificatesView: View {
                 .iosAutocapitalizationNever()
                 .autocorrectionDisabled()
 
+            TextField("Compromised Key IDs (one per line)", text: $krlDraft.revokedKeyIDs, axis: .vertical)
+                .lineLimit(2...4)
+                .iosAutocapitalizationNever()
+                .autocorrectionDisabled()
+
             Toggle("Include Expired Certificates", isOn: $krlDraft.includeExpiredCertificates)
 
-            Text("Use serials for compromised certs. The generated bundle includes revoked keys plus an ssh-keygen command to build a .krl file.")
+            if let baseKRLName = krlDraft.baseKRLName {
+                HStack {
+                    Text("Appending to \(baseKRLName)")
+                        .font(.caption)
+                        .foregroundStyle(.secondary)
+                    Spacer()
+                    Button("Clear") {
+                        krlDraft.baseKRL = nil
+                        krlDraft.baseKRLName = nil
+                    }
+                    .buttonStyle(.borderless)
+                }
+            } else {
+                Button("Append to Existing KRL...") {
+                    showingBaseKRLImporter = true
+                }
+                .buttonStyle(.borderless)
+            }
+
+            Text("Use serials or key IDs for compromised certs. The generated bundle includes a binary .krl file, plus revoked keys and an ssh-keygen command to build one yourself.")
                 .font(.footnote)
                 .foregroundStyle(.secondary)
 
             Button {
                 if let generated = viewModel.generateKRL(from: krlDraft) {
                     generatedKRLBundle = generated
-                    operationMessage = "KRL bundle generated for \(generated.revokedCertificateCount) certificate(s)."
+                    operationMessage = generated.isIncremental
+                        ? "KRL version \(generated.krlVersion) appends \(generated.appendedCertificateCount) certificate(s)."
+                        : "KRL bundle generated for \(generated.revokedCertificateCount) certificate(s)."
                 }
             } label: {
                 if viewModel.isGeneratingKRL {
@@ -338,6 +472,11 @@ struct CertificatesView: View {
                     .font(.caption.monospaced())
                     .textSelection(.enabled)
 
+                Button("Save Binary KRL...") {
+                    showingKRLExporter = true
+                }
+                .buttonStyle(.borderless)
+
                 Button("Copy ssh-keygen Command") {
                     PlatformClipboard.writeString(generatedKRLBundle.openSSHCommand)
                     operationMessage = "ssh-keygen command copied."
@@ -357,6 +496,32 @@ struct CertificatesView: View {
                 .buttonStyle(.borderless)
             }
         }
+        .fileImporter(
+            isPresented: $showingBaseKRLImporter,
+            allowedContentTypes: [.data, .item],
+            allowsMultipleSelection: false
+        ) { result in
+            guard case let .success(urls) = result, let fileURL = urls.first else { return }
+            loadBaseKRL(from: fileURL)
+        }
+    }
+
+    private func loadBaseKRL(from url: URL) {
+        let hasAccess = url.startAccessingSecurityScopedResource()
+        defer {
+            if hasAccess {
+                url.stopAccessingSecurityScopedResource()
+            }
+        }
+
+        do {
+            let data = try Data(contentsOf: url)
+            _ = try OpenSSHKRL(parsing: data)
+            krlDraft.baseKRL = data
+            krlDraft.baseKRLName = url.lastPathComponent
+        } catch {
+            operationMessage = "KRL import failed: \(error.localizedDescription)"
+        }
     }
 
     private var authoritiesSection: some View {
@@ -505,3 +670,21 @@ struct CertificatesView: View {
         viewModel.authorities.filter { $0.certificateType != .user }
     }
 }
+
+private nonisolated struct KRLFileDocument: FileDocument {
+    static var readableContentTypes: [UTType] { [.data] }
+
+    var data: Data
+
+    init(data: Data) {
+        self.data = data
+    }
+
+    init(configuration: ReadConfiguration) throws {
+        data = configuration.file.regularFileContents ?? Data()
+    }
+
+    func fileWrapper(configuration: WriteConfiguration) throws -> FileWrapper {
+        FileWrapper(regularFileWithContents: data)
+    }
+}
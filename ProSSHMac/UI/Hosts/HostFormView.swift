@@ -81,6 +81,14 @@ struct HostFormView: View {
                     Text("Enable only for trusted legacy equipment. Modern algorithms remain preferred by default.")
                         .font(.footnote)
                         .foregroundStyle(.secondary)
+                    Picker("Compression", selection: $draft.compression) {
+                        ForEach(SSHCompressionMode.allCases) { mode in
+                            Text(mode.title).tag(mode)
+                        }
+                    }
+                    Text("Automatic compresses only when this host's last measured link speed was slow, e.g. over mobile tethering.")
+                        .font(.footnote)
+                        .foregroundStyle(.secondary)
                 }
 
                 Section("Jump Host") {
@@ -112,7 +120,7 @@ struct HostFormView: View {
                             VStack(alignment: .leading) {
                                 Text(rule.label)
                                     .font(.subheadline)
-                                Text("localhost:\(rule.localPort) \u{2192} \(rule.remoteHost):\(rule.remotePort)")
+                                Text(rule.routeDescription)
                                     .font(.caption)
                                     .foregroundStyle(.secondary)
                             }
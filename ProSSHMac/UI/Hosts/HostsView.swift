@@ -15,6 +15,7 @@ struct HostsView: View {
     @State private var passphrasePromptHost: Host?
     @State private var passphrasePromptValue = ""
     @State private var sshConfigImportPreview: SSHConfigImportService.ImportPreview? = nil
+    @State private var commandGroup: HostListGroup?
 
     private enum PresentedAlert: Identifiable {
         case hostVerification(PendingHostVerification)
@@ -59,6 +60,26 @@ struct HostsView: View {
                     Label("Import SSH Config From Clipboard", systemImage: "square.and.arrow.down")
                 }
 
+                Button {
+                    Task {
+                        guard let preview = await hostListViewModel.previewSSHConfigImport() else { return }
+                        if preview.results.isEmpty {
+                            operationMessage = "No valid SSH host entries found in ~/.ssh/config."
+                        } else {
+                            sshConfigImportPreview = preview
+                        }
+                    }
+                } label: {
+                    Label("Import ~/.ssh/config", systemImage: "doc.badge.arrow.up")
+                }
+                .disabled(hostListViewModel.sshConfigImportProgress != nil)
+
+                if let progress = hostListViewModel.sshConfigImportProgress {
+                    ProgressView(value: progress.fractionCompleted) {
+                        Text("Reading SSH config… \(progress.entries) blocks")
+                    }
+                }
+
                 Button {
                     PlatformClipboard.writeString(hostListViewModel.exportSSHConfig())
                     operationMessage = "SSH config copied to clipboard."
@@ -71,23 +92,46 @@ struct HostsView: View {
                 ProgressView("Loading hosts...")
             }
 
-            ForEach(groupedHosts, id: \.folder) { group in
-                Section(group.folder) {
-                    ForEach(group.hosts) { host in
-                        hostRow(host)
+            if !hostListViewModel.searchQuery.isEmpty, hostListViewModel.hostGroups.isEmpty {
+                Text("No hosts match “\(hostListViewModel.searchQuery)”.")
+                    .foregroundStyle(.secondary)
+            }
+
+            // Rows are built from IDs as List scrolls them in.
+            ForEach(hostListViewModel.hostGroups) { group in
+                Section {
+                    ForEach(group.hostIDs, id: \.self) { hostID in
+                        if let host = hostListViewModel.host(withID: hostID) {
+                            hostRow(host)
+                        }
                     }
                     .onDelete { offsets in
+                        let ids = offsets.map { group.hostIDs[$0] }
                         Task {
-                            await hostListViewModel.deleteHosts(with: offsets, in: group.hosts)
+                            await hostListViewModel.deleteHosts(ids: ids)
+                        }
+                    }
+                } header: {
+                    HStack {
+                        Text(group.folder)
+                        Spacer()
+                        Button {
+                            commandGroup = group
+                        } label: {
+                            Image(systemName: "play.rectangle")
                         }
+                        .buttonStyle(.borderless)
+                        .help("Run a command on every host in \(group.folder)")
                     }
                 }
             }
         }
         .navigationTitle("Hosts")
+        .searchable(text: $hostListViewModel.searchQuery, prompt: "Search hosts, tag:name, folder:name")
         .task {
             await hostListViewModel.loadHostsIfNeeded()
             await keyForgeViewModel.loadKeysIfNeeded()
+            sessionManager.prewarmCoordinator.prewarmRecent(hostListViewModel.hosts)
         }
         .sheet(isPresented: $showForm) {
             HostFormView(
@@ -121,6 +165,14 @@ struct HostsView: View {
                 onCancel: { sshConfigImportPreview = nil }
             )
         }
+        .sheet(item: $commandGroup) { group in
+            ParallelCommandView(
+                title: group.folder,
+                hosts: group.hostIDs.compactMap { hostListViewModel.host(withID: $0) },
+                resolveHost: { hostListViewModel.host(withID: $0) },
+                onDone: { commandGroup = nil }
+            )
+        }
         .sheet(item: $passwordPromptHost) { host in
             NavigationStack {
                 Form {
@@ -379,7 +431,7 @@ struct HostsView: View {
                     }
 
                     if let jumpHostID = host.jumpHost {
-                        if let jumpHost = hostListViewModel.hosts.first(where: { $0.id == jumpHostID }) {
+                        if let jumpHost = hostListViewModel.host(withID: jumpHostID) {
                             Label("via \(jumpHost.label)", systemImage: "arrow.triangle.branch")
                                 .font(.caption)
                                 .padding(.horizontal, 8)
@@ -432,6 +484,9 @@ struct HostsView: View {
             }
             .padding(.leading, 10)
         }
+        .onHover { isHovering in
+            sessionManager.prewarmCoordinator.hover(host, isHovering: isHovering)
+        }
         .listRowBackground(
             RoundedRectangle(cornerRadius: 8)
                 .fill(hostStateBackgroundColor(sessionState))
@@ -500,19 +555,6 @@ struct HostsView: View {
         }
     }
 
-    private var groupedHosts: [(folder: String, hosts: [Host])] {
-        let groups = Dictionary(grouping: hostListViewModel.hosts) { host in
-            let trimmed = host.folder?.trimmingCharacters(in: .whitespacesAndNewlines) ?? ""
-            return trimmed.isEmpty ? "Ungrouped" : trimmed
-        }
-
-        return groups
-            .map { (folder: $0.key, hosts: $0.value.sorted { $0.label.localizedCaseInsensitiveCompare($1.label) == .orderedAscending }) }
-            .sorted { lhs, rhs in
-                lhs.folder.localizedCaseInsensitiveCompare(rhs.folder) == .orderedAscending
-            }
-    }
-
     private var presentedAlertBinding: Binding<PresentedAlert?> {
         Binding(
             get: {
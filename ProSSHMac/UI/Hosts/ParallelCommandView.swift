@@ -0,0 +1,164 @@
+import SwiftUI
+
+/// Runs one command on a group of hosts over exec channels and shows a row
+/// per host (see ParallelCommandCoordinator).
+struct ParallelCommandView: View {
+    let title: String
+    let hosts: [Host]
+    let resolveHost: (UUID) -> Host?
+    let onDone: () -> Void
+
+    @EnvironmentObject private var sessionManager: SessionManager
+    @State private var command = ""
+    @State private var selectedHostID: UUID?
+
+    private var run: ParallelCommandRun? {
+        sessionManager.parallelCommandRun
+    }
+
+    private var isRunning: Bool {
+        run.map { !$0.isFinished } ?? false
+    }
+
+    var body: some View {
+        NavigationStack {
+            VStack(alignment: .leading, spacing: 12) {
+                HStack {
+                    TextField("Command", text: $command)
+                        .textFieldStyle(.roundedBorder)
+                        .font(.system(.body, design: .monospaced))
+                        .onSubmit(start)
+                    if isRunning {
+                        Button("Stop") {
+                            sessionManager.parallelCommandCoordinator.cancel()
+                        }
+                    } else {
+                        Button("Run on \(hosts.count) Host\(hosts.count == 1 ? "" : "s")", action: start)
+                            .disabled(command.trimmingCharacters(in: .whitespacesAndNewlines).isEmpty)
+                    }
+                }
+
+                if let run {
+                    Text(summary(of: run))
+                        .font(.caption)
+                        .foregroundStyle(.secondary)
+
+                    Table(run.results, selection: $selectedHostID) {
+                        TableColumn("Host") { row in
+                            VStack(alignment: .leading, spacing: 2) {
+                                Text(row.label)
+                                Text(row.address)
+                                    .font(.caption2)
+                                    .foregroundStyle(.secondary)
+                            }
+                        }
+                        TableColumn("Status") { row in
+                            statusLabel(row.status)
+                        }
+                        .width(min: 90, ideal: 110)
+                        TableColumn("Output") { row in
+                            Text(firstLine(of: row))
+                                .font(.system(.caption, design: .monospaced))
+                                .lineLimit(1)
+                                .foregroundStyle(row.stderr.isEmpty ? .primary : .secondary)
+                        }
+                        TableColumn("Time") { row in
+                            Text(row.duration.map(format) ?? "")
+                                .font(.caption)
+                                .monospacedDigit()
+                        }
+                        .width(min: 50, ideal: 60)
+                    }
+
+                    if let selectedHostID, let row = run.results.first(where: { $0.id == selectedHostID }) {
+                        output(of: row)
+                    }
+                }
+            }
+            .padding()
+            .frame(minWidth: 720, minHeight: 480)
+            .navigationTitle("Run Command on \(title)")
+            .toolbar {
+                ToolbarItem(placement: .cancellationAction) {
+                    Button("Done", action: onDone)
+                }
+            }
+        }
+    }
+
+    private func start() {
+        let trimmed = command.trimmingCharacters(in: .whitespacesAndNewlines)
+        guard !trimmed.isEmpty, !isRunning else { return }
+        selectedHostID = nil
+        sessionManager.parallelCommandCoordinator.run(trimmed, on: hosts, resolveHost: resolveHost)
+    }
+
+    private func summary(of run: ParallelCommandRun) -> String {
+        let failed = run.results.count - run.pendingCount - run.succeededCount
+        var parts = ["\(run.succeededCount) succeeded", "\(failed) failed"]
+        if run.pendingCount > 0 {
+            parts.append("\(run.pendingCount) pending")
+        }
+        return parts.joined(separator: " · ")
+    }
+
+    @ViewBuilder
+    private func statusLabel(_ status: ParallelCommandHostResult.Status) -> some View {
+        switch status {
+        case .queued:
+            Label("Queued", systemImage: "clock").foregroundStyle(.secondary)
+        case .connecting:
+            Label("Connecting", systemImage: "network").foregroundStyle(.secondary)
+        case .running:
+            Label("Running", systemImage: "play.circle").foregroundStyle(.blue)
+        case .exited(let code?) where code == 0:
+            Label("Exit 0", systemImage: "checkmark.circle.fill").foregroundStyle(.green)
+        case .exited(let code?):
+            Label("Exit \(code)", systemImage: "xmark.circle.fill").foregroundStyle(.red)
+        case .exited(nil):
+            Label("Ended", systemImage: "questionmark.circle").foregroundStyle(.orange)
+        case .timedOut:
+            Label("Timed Out", systemImage: "hourglass").foregroundStyle(.orange)
+        case .failed(let message):
+            Label("Failed", systemImage: "exclamationmark.triangle.fill")
+                .foregroundStyle(.red)
+                .help(message)
+        case .cancelled:
+            Label("Stopped", systemImage: "stop.circle").foregroundStyle(.secondary)
+        }
+    }
+
+    private func firstLine(of row: ParallelCommandHostResult) -> String {
+        if case .failed(let message) = row.status {
+            return message
+        }
+        let text = row.stdout.isEmpty ? row.stderr : row.stdout
+        return text.split(whereSeparator: \.isNewline).first.map(String.init) ?? ""
+    }
+
+    private func output(of row: ParallelCommandHostResult) -> some View {
+        ScrollView {
+            VStack(alignment: .leading, spacing: 6) {
+                if !row.stdout.isEmpty {
+                    Text(row.stdout)
+                }
+                if !row.stderr.isEmpty {
+                    Text(row.stderr).foregroundStyle(.red)
+                }
+                if row.truncated {
+                    Text("Output truncated.")
+                        .font(.caption)
+                        .foregroundStyle(.secondary)
+                }
+            }
+            .font(.system(.caption, design: .monospaced))
+            .textSelection(.enabled)
+            .frame(maxWidth: .infinity, alignment: .leading)
+        }
+        .frame(height: 140)
+    }
+
+    private func format(_ duration: Duration) -> String {
+        duration.formatted(.units(allowed: [.seconds, .milliseconds], width: .narrow, maximumUnitCount: 1))
+    }
+}
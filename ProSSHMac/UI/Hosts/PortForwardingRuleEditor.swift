@@ -2,6 +2,7 @@ import SwiftUI
 
 struct PortForwardingRuleEditor: View {
     @Environment(\.dismiss) private var dismiss
+    @State private var kind: PortForwardingKind = .local
     @State private var label: String = ""
     @State private var localPort: String = ""
     @State private var remoteHost: String = "localhost"
@@ -13,6 +14,15 @@ struct PortForwardingRuleEditor: View {
         guard let lp = UInt16(localPort), lp > 0 else {
             return "Local port must be between 1 and 65535."
         }
+        if kind == .dynamic {
+            return nil
+        }
+        if kind == .remote {
+            guard let rp = UInt16(remotePort), rp > 0 else {
+                return "Server port must be between 1 and 65535."
+            }
+            return nil
+        }
         if remoteHost.trimmingCharacters(in: .whitespacesAndNewlines).isEmpty {
             return "Remote host is required."
         }
@@ -26,14 +36,41 @@ struct PortForwardingRuleEditor: View {
         NavigationStack {
             Form {
                 Section("Forwarding Rule") {
+                    Picker("Type", selection: $kind) {
+                        ForEach(PortForwardingKind.allCases) { kind in
+                            Text(kind.title).tag(kind)
+                        }
+                    }
                     TextField("Label (optional)", text: $label)
                     TextField("Local Port", text: $localPort)
                         .iosKeyboardNumberPad()
-                    TextField("Remote Host", text: $remoteHost)
-                        .iosAutocapitalizationNever()
-                        .autocorrectionDisabled()
-                    TextField("Remote Port", text: $remotePort)
-                        .iosKeyboardNumberPad()
+                    if kind == .local {
+                        TextField("Remote Host", text: $remoteHost)
+                            .iosAutocapitalizationNever()
+                            .autocorrectionDisabled()
+                        TextField("Remote Port", text: $remotePort)
+                            .iosKeyboardNumberPad()
+                    } else if kind == .remote {
+                        TextField("Server Bind Address (optional)", text: $remoteHost)
+                            .iosAutocapitalizationNever()
+                            .autocorrectionDisabled()
+                        TextField("Server Port", text: $remotePort)
+                            .iosKeyboardNumberPad()
+                    }
+                }
+
+                if kind == .dynamic {
+                    Section {
+                        Text("Point a browser or tool at this port as a SOCKS5 proxy. Each connection is opened to the destination it asks for, through this SSH connection.")
+                            .font(.footnote)
+                            .foregroundStyle(.secondary)
+                    }
+                } else if kind == .remote {
+                    Section {
+                        Text("The server listens on the server port and sends each connection back through this SSH connection to the local port on this Mac.")
+                            .font(.footnote)
+                            .foregroundStyle(.secondary)
+                    }
                 }
 
                 if let error = validationError {
@@ -53,14 +90,29 @@ struct PortForwardingRuleEditor: View {
                 }
                 ToolbarItem(placement: .confirmationAction) {
                     Button("Add") {
-                        guard let lp = UInt16(localPort),
-                              let rp = UInt16(remotePort) else { return }
-                        let rule = PortForwardingRule(
-                            localPort: lp,
-                            remoteHost: remoteHost.trimmingCharacters(in: .whitespacesAndNewlines),
-                            remotePort: rp,
-                            label: label.trimmingCharacters(in: .whitespacesAndNewlines)
-                        )
+                        guard let lp = UInt16(localPort) else { return }
+                        let trimmedLabel = label.trimmingCharacters(in: .whitespacesAndNewlines)
+                        let rule: PortForwardingRule
+                        switch kind {
+                        case .local:
+                            guard let rp = UInt16(remotePort) else { return }
+                            rule = PortForwardingRule(
+                                localPort: lp,
+                                remoteHost: remoteHost.trimmingCharacters(in: .whitespacesAndNewlines),
+                                remotePort: rp,
+                                label: trimmedLabel
+                            )
+                        case .dynamic:
+                            rule = .dynamic(localPort: lp, label: trimmedLabel)
+                        case .remote:
+                            guard let rp = UInt16(remotePort) else { return }
+                            rule = .remote(
+                                bindAddress: remoteHost.trimmingCharacters(in: .whitespacesAndNewlines),
+                                remotePort: rp,
+                                localPort: lp,
+                                label: trimmedLabel
+                            )
+                        }
                         onSave(rule)
                         dismiss()
                     }
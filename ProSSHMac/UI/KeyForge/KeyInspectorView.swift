@@ -186,7 +186,59 @@ struct KeyInspectorView: View {
                                 copyIDHostPassword.trimmingCharacters(in: .whitespacesAndNewlines).isEmpty
                             )
 
-                            Text("Uses password auth to install key, sets ~/.ssh permissions, then verifies key-based login before success.")
+                            if let group = copyIDFolderHosts {
+                                Button {
+                                    Task {
+                                        let installed = await viewModel.copyPublicKeyToHosts(
+                                            keyID: keyID,
+                                            hosts: group.hosts,
+                                            hostPassword: copyIDHostPassword,
+                                            privateKeyPassphrase: copyIDPrivateKeyPassphrase
+                                        )
+                                        if !installed.isEmpty {
+                                            operationMessage = "Public key installed and verified on \(installed.count) of \(group.hosts.count) hosts in \(group.title)."
+                                        }
+                                    }
+                                } label: {
+                                    Text("Run on All \(group.hosts.count) Hosts in \(group.title)")
+                                }
+                                .disabled(
+                                    viewModel.isCopyingPublicKey ||
+                                    copyIDHostPassword.trimmingCharacters(in: .whitespacesAndNewlines).isEmpty
+                                )
+                            }
+
+                            let rotationHosts = hostListViewModel.hosts.filter { $0.keyReference == keyID }
+                            if !rotationHosts.isEmpty {
+                                Button {
+                                    Task {
+                                        let rotated = await viewModel.rotateKeys(
+                                            for: rotationHosts,
+                                            from: rotationDraft(for: key),
+                                            hostPassword: copyIDHostPassword
+                                        )
+                                        await hostListViewModel.assignKeys(rotated)
+                                        if !rotated.isEmpty {
+                                            operationMessage = "Rotated \(rotated.count) of \(rotationHosts.count) hosts to new keys."
+                                        }
+                                    }
+                                } label: {
+                                    Text("Rotate Key on \(rotationHosts.count) Host\(rotationHosts.count == 1 ? "" : "s") Using It")
+                                }
+                                .disabled(
+                                    viewModel.isGenerating ||
+                                    viewModel.isCopyingPublicKey ||
+                                    copyIDHostPassword.trimmingCharacters(in: .whitespacesAndNewlines).isEmpty
+                                )
+                            }
+
+                            if let progress = viewModel.batchProgress {
+                                ProgressView(value: progress.fractionCompleted) {
+                                    Text("\(progress.completed) of \(progress.total) hosts")
+                                }
+                            }
+
+                            Text("Uses password auth to install key, sets ~/.ssh permissions, then verifies key-based login before success. Rotation gives each host its own new key of the same type.")
                                 .font(.footnote)
                                 .foregroundStyle(.secondary)
                         }
@@ -282,6 +334,36 @@ struct KeyInspectorView: View {
     }
 
     @ViewBuilder
+    /// The selected host's folder, when it holds more than one host.
+    private var copyIDFolderHosts: (title: String, hosts: [Host])? {
+        guard let selectedCopyIDHostID,
+              let selected = hostListViewModel.host(withID: selectedCopyIDHostID) else {
+            return nil
+        }
+        let folder = selected.folder?.trimmingCharacters(in: .whitespacesAndNewlines) ?? ""
+        let hosts = hostListViewModel.hosts.filter {
+            ($0.folder?.trimmingCharacters(in: .whitespacesAndNewlines) ?? "") == folder
+        }
+        guard hosts.count > 1 else { return nil }
+        return (folder.isEmpty ? HostListGroup.ungroupedTitle : folder, hosts)
+    }
+
+    /// A new key like `key`, without a passphrase.
+    private func rotationDraft(for key: SSHKey) -> KeyGenerationDraft {
+        var draft = KeyGenerationDraft()
+        draft.label = key.label
+        draft.keyType = key.type
+        draft.format = key.format
+        draft.comment = key.comment ?? ""
+        if key.type == .rsa, let bits = key.bitLength, [2048, 3072, 4096].contains(bits) {
+            draft.rsaBits = bits
+        }
+        if key.type == .ecdsa {
+            draft.ecdsaCurve = key.bitLength == 521 ? .p521 : key.bitLength == 384 ? .p384 : .p256
+        }
+        return draft
+    }
+
     private func detailRow(_ title: String, value: String) -> some View {
         HStack(alignment: .firstTextBaseline) {
             Text(title)
@@ -1,5 +1,7 @@
+import AppKit
 import SwiftUI
 import CoreText
+import UniformTypeIdentifiers
 
 struct SettingsView: View {
     @Environment(\.horizontalSizeClass) private var horizontalSizeClass
@@ -7,6 +9,7 @@ struct SettingsView: View {
     @EnvironmentObject private var sessionManager: SessionManager
     @EnvironmentObject private var auditLogManager: AuditLogManager
     @EnvironmentObject private var aiProviderSettingsViewModel: AIProviderSettingsViewModel
+    @EnvironmentObject private var providerRegistry: LLMProviderRegistry
     @AppStorage("app.appearance") private var appAppearanceRawValue = AppAppearance.system.rawValue
     @AppStorage("terminal.effects.crtEnabled") private var terminalCRTEffectEnabled = false
     @AppStorage(BellEffectController.settingsKey) private var terminalBellFeedbackMode = BellFeedbackMode.none.rawValue
@@ -19,8 +22,10 @@ struct SettingsView: View {
     @AppStorage("ai.patchTool.enabled") private var patchToolEnabled: Bool = true
     @AppStorage("ai.patchTool.requireApproval") private var patchRequireApproval: Bool = true
     @AppStorage("ai.patchTool.allowDelete") private var patchAllowDelete: Bool = false
+    @AppStorage(TraceRecorder.enabledDefaultsKey) private var traceRecorderEnabled = true
     @State private var operationMessage: String?
     @State private var showingClearAuditConfirmation = false
+    @State private var showingKnownHostsImporter = false
 
     var body: some View {
         ScrollView {
@@ -43,7 +48,7 @@ struct SettingsView: View {
                 }
 
                 Section("Terminal") {
-                    Stepper("Scrollback: \(terminalScrollback) lines", value: $terminalScrollback, in: 1_000...50_000, step: 1_000)
+                    Stepper("Scrollback: \(terminalScrollback) lines", value: $terminalScrollback, in: 10_000...1_000_000, step: 10_000)
 
                     Picker("Terminal Font", selection: $terminalUIFontFamily) {
                         ForEach(availableTerminalFontChoices, id: \.self) { family in
@@ -422,6 +427,63 @@ struct SettingsView: View {
                     }
                 }
 
+                Section("Diagnostics") {
+                    Toggle("Record Performance Trace", isOn: $traceRecorderEnabled)
+                        .onChange(of: traceRecorderEnabled) { _, enabled in
+                            TraceRecorder.shared.setEnabled(enabled)
+                            if enabled {
+                                HitchDetector.shared.start()
+                            } else {
+                                HitchDetector.shared.stop()
+                            }
+                        }
+
+                    Text("Keeps the last moments of parser, rendering, SFTP and AI tool activity in memory. After a hitch, save a trace and open it in Perfetto (ui.perfetto.dev). Hitches are detected automatically; the hitch report ranks the stages that caused them.")
+                        .font(.footnote)
+                        .foregroundStyle(.secondary)
+
+                    Button("Save Last 30 Seconds of Trace", systemImage: "waveform.path.ecg") {
+                        do {
+                            let url = try TraceRecorder.shared.saveRecentTrace(lastSeconds: 30)
+                            NSWorkspace.shared.activateFileViewerSelecting([url])
+                            operationMessage = "Trace saved to \(url.path)."
+                        } catch {
+                            operationMessage = "Could not save trace: \(error.localizedDescription)"
+                        }
+                    }
+                    .disabled(!traceRecorderEnabled)
+
+                    Button("Copy Hitch Report", systemImage: "doc.on.clipboard") {
+                        PlatformClipboard.writeString(HitchDetector.shared.report)
+                        operationMessage = "Hitch report copied."
+                    }
+
+                    Button("Save Last Hitch Trace", systemImage: "exclamationmark.triangle") {
+                        do {
+                            if let url = try HitchDetector.shared.saveLatestTrace() {
+                                NSWorkspace.shared.activateFileViewerSelecting([url])
+                                operationMessage = "Hitch trace saved to \(url.path)."
+                            } else {
+                                operationMessage = "No hitches recorded yet."
+                            }
+                        } catch {
+                            operationMessage = "Could not save hitch trace: \(error.localizedDescription)"
+                        }
+                    }
+                    .disabled(!traceRecorderEnabled)
+
+                    ForEach(providerRegistry.sessionDiagnostics.filter { $0.timeToFirstTokenSamples > 0 }) { diagnostics in
+                        VStack(alignment: .leading, spacing: 2) {
+                            Text("\(diagnostics.providerID.displayName) time to first token")
+                                .font(.subheadline)
+                            Text(llmSessionSummary(diagnostics))
+                                .font(.caption)
+                                .foregroundStyle(.secondary)
+                        }
+                    }
+                }
+                .onAppear { providerRegistry.refreshSessionDiagnostics() }
+
                 Section("Known Hosts") {
                     Text("Trusted Entries: \(sessionManager.knownHosts.count)")
 
@@ -442,6 +504,10 @@ struct SettingsView: View {
                         }
                     }
 
+                    Button("Import OpenSSH known_hosts", systemImage: "square.and.arrow.down") {
+                        showingKnownHostsImporter = true
+                    }
+
                     if !sessionManager.knownHosts.isEmpty {
                         Button("Clear Known Hosts", role: .destructive) {
                             Task {
@@ -460,6 +526,16 @@ struct SettingsView: View {
             await sessionManager.refreshKnownHosts()
             await aiProviderSettingsViewModel.refresh()
         }
+        .fileImporter(
+            isPresented: $showingKnownHostsImporter,
+            allowedContentTypes: [.plainText, .text, .data, .item],
+            allowsMultipleSelection: false
+        ) { result in
+            guard case let .success(urls) = result, let fileURL = urls.first else { return }
+            Task {
+                operationMessage = await importKnownHosts(from: fileURL)
+            }
+        }
         .confirmationDialog(
             "Clear audit log?",
             isPresented: $showingClearAuditConfirmation,
@@ -521,6 +597,44 @@ struct SettingsView: View {
         )
     }
 
+    private func llmSessionSummary(_ diagnostics: LLMSessionDiagnostics) -> String {
+        var parts: [String] = []
+        if let last = diagnostics.lastTimeToFirstTokenMilliseconds {
+            parts.append("last \(last) ms")
+        }
+        if let median = diagnostics.medianTimeToFirstTokenMilliseconds {
+            parts.append("median \(median) ms over \(diagnostics.timeToFirstTokenSamples)")
+        }
+        if let proto = diagnostics.lastProtocol {
+            let reuse = diagnostics.lastConnectionReused == true ? "reused" : "new"
+            parts.append("\(proto), \(reuse) connection")
+        }
+        if let connect = diagnostics.lastConnectMilliseconds {
+            parts.append("connect \(connect) ms")
+        }
+        return parts.joined(separator: " • ")
+    }
+
+    private func importKnownHosts(from url: URL) async -> String {
+        let hasAccess = url.startAccessingSecurityScopedResource()
+        defer {
+            if hasAccess {
+                url.stopAccessingSecurityScopedResource()
+            }
+        }
+
+        do {
+            let data = try Data(contentsOf: url)
+            guard let contents = String(data: data, encoding: .utf8) else {
+                return "Selected file is not valid UTF-8 text."
+            }
+            let result = try await sessionManager.importOpenSSHKnownHosts(contents: contents)
+            return "Imported \(result.imported) known hosts (\(result.hashed) hashed, \(result.skipped) skipped)."
+        } catch {
+            return "Known hosts import failed: \(error.localizedDescription)"
+        }
+    }
+
     private var availableTerminalFontChoices: [String] {
         var fonts = TerminalFontCatalog.availableMonospaceFamilies()
         let current = terminalUIFontFamily.trimmingCharacters(in: .whitespacesAndNewlines)
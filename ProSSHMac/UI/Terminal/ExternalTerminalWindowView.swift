@@ -95,7 +95,7 @@ struct ExternalTerminalWindowView: View {
 
     @ViewBuilder
     private func terminalSurface(for session: Session) -> some View {
-        let snapshotNonce = sessionManager.gridSnapshotNonceBySessionID[session.id, default: 0]
+        let snapshotNonce = sessionManager.liveState(for: session.id).gridSnapshotNonce ?? 0
 
         if useMetalRenderer, MTLCreateSystemDefaultDevice() != nil {
             MetalTerminalSessionSurface(
@@ -130,7 +130,33 @@ struct ExternalTerminalWindowView: View {
                     sessionManager.cachedScrollbackCount(for: session.id)
                 },
                 scrollOffsetProvider: {
-                    sessionManager.scrollStateBySessionID[session.id]?.scrollOffset ?? 0
+                    sessionManager.liveState(for: session.id).scrollState?.scrollOffset ?? 0
+                },
+                scrollbackRingRowsProvider: { positions in
+                    await sessionManager.scrollbackRingRows(sessionID: session.id, positions: positions)
+                },
+                onScrollToRow: { row in
+                    sessionManager.scrollToRow(sessionID: session.id, row: row)
+                },
+                onRenderTierChange: { tier, surfaceID in
+                    sessionManager.setRenderTier(tier, for: session.id, surfaceID: surfaceID)
+                },
+                attachSnapshotFeed: { surfaceID in
+                    sessionManager.attachSnapshotFeed(for: session.id, surfaceID: surfaceID)
+                },
+                detachSnapshotFeed: { surfaceID in
+                    sessionManager.detachSnapshotFeed(for: session.id, surfaceID: surfaceID)
+                },
+                performanceHUDStatsProvider: {
+                    sessionManager.performanceHUDStats(for: session.id)
+                },
+                onCellPixelSizeChange: { width, height in
+                    Task {
+                        await sessionManager.setCellPixelSize(sessionID: session.id, width: width, height: height)
+                    }
+                },
+                onThumbnail: { image in
+                    sessionManager.thumbnailStore.update(image, for: session.id)
                 }
             )
             .id(session.id)
@@ -220,7 +246,7 @@ struct ExternalTerminalWindowView: View {
     // MARK: - Keyboard Input
 
     private func keyEncoderOptions(for sessionID: UUID) -> KeyEncoderOptions {
-        let modeSnapshot = sessionManager.inputModeSnapshotsBySessionID[sessionID] ?? .default
+        let modeSnapshot = sessionManager.liveState(for: sessionID).inputModeSnapshot ?? .default
         return KeyEncoderOptions(applicationCursorKeys: modeSnapshot.applicationCursorKeys)
     }
 
@@ -275,7 +301,7 @@ struct ExternalTerminalWindowView: View {
             _ = PlatformClipboard.writeString(selectedText)
             return true
         }
-        if let lastLine = sessionManager.shellBuffers[sessionID]?.last, !lastLine.isEmpty {
+        if let lastLine = sessionManager.liveState(for: sessionID).shellBuffer?.last, !lastLine.isEmpty {
             _ = PlatformClipboard.writeString(lastLine)
             return true
         }
@@ -283,13 +309,10 @@ struct ExternalTerminalWindowView: View {
     }
 
     private func pasteClipboardToSession(_ sessionID: UUID) {
-        let bracketedPaste = sessionManager.inputModeSnapshotsBySessionID[sessionID]?.bracketedPasteMode ?? false
-        let sequences = PasteHandler.readClipboardSequences(bracketedPasteEnabled: bracketedPaste)
-        for sequence in sequences {
-            Task {
-                await sessionManager.sendRawShellInput(sessionID: sessionID, input: sequence)
-            }
-        }
+        let bracketedPaste = sessionManager.liveState(for: sessionID).inputModeSnapshot?.bracketedPasteMode ?? false
+        // Streamed at bulk priority, so keystrokes typed during a large
+        // paste go out ahead of it.
+        sessionManager.pasteClipboard(sessionID: sessionID, bracketedPasteEnabled: bracketedPaste)
     }
 
     private func adjustTerminalFontSize(by delta: Double) {
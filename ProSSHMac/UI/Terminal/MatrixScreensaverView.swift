@@ -2,7 +2,8 @@
 // ProSSHV2
 //
 // Matrix-style falling character screensaver overlay.
-// Renders cascading green glyphs at 60fps using SwiftUI Canvas.
+// Drawn on the GPU by MatrixRainRenderer at the display's refresh rate;
+// the SwiftUI Canvas below is the fallback when Metal is unavailable.
 // Dismisses on any user interaction.
 
 import SwiftUI
@@ -15,8 +16,49 @@ struct MatrixScreensaverView: View {
     @State private var streams: [MatrixStream] = []
     @State private var isInitialized = false
     @State private var eventMonitor: Any?
+    @State private var renderer: MatrixRainRenderer?
+    @State private var didSetUpRenderer = false
 
     var body: some View {
+        Group {
+            if let renderer {
+                MatrixRainMetalView(renderer: renderer)
+            } else if didSetUpRenderer {
+                canvasRain
+            } else {
+                Color.black
+            }
+        }
+        .ignoresSafeArea()
+        .contentShape(Rectangle())
+        .onTapGesture { onDismiss() }
+        .onKeyPress { _ in
+            onDismiss()
+            return .handled
+        }
+        .focusable()
+        .focusEffectDisabled()
+        .onAppear {
+            setUpRendererIfNeeded()
+            installEventMonitor()
+        }
+        .onDisappear {
+            removeEventMonitor()
+        }
+        .onChange(of: config) { _, newConfig in
+            renderer?.update(config: newConfig)
+        }
+    }
+
+    private func setUpRendererIfNeeded() {
+        guard !didSetUpRenderer else { return }
+        didSetUpRenderer = true
+        renderer = MatrixRainRenderer(config: config)
+    }
+
+    // MARK: - Canvas Fallback
+
+    private var canvasRain: some View {
         GeometryReader { geo in
             let viewSize = geo.size
 
@@ -54,21 +96,6 @@ struct MatrixScreensaverView: View {
                 }
             }
         }
-        .ignoresSafeArea()
-        .contentShape(Rectangle())
-        .onTapGesture { onDismiss() }
-        .onKeyPress { _ in
-            onDismiss()
-            return .handled
-        }
-        .focusable()
-        .focusEffectDisabled()
-        .onAppear {
-            installEventMonitor()
-        }
-        .onDisappear {
-            removeEventMonitor()
-        }
     }
 
     // MARK: - Event Monitor
@@ -4,6 +4,7 @@
 // Metal-backed terminal rendering surface, extracted from TerminalView.
 
 import SwiftUI
+import AppKit
 import Metal
 @preconcurrency import Combine
 @preconcurrency import ObjectiveC
@@ -26,6 +27,27 @@ struct MetalTerminalSessionSurface: View {
     var scrollbackCountProvider: (() -> Int)?
     /// Provides current scroll offset row so smooth-scroll engine can stay in sync.
     var scrollOffsetProvider: (() -> Int)?
+    /// History rows by line position for the renderer's scrollback row ring.
+    var scrollbackRingRowsProvider: ((Range<Int>) async -> ScrollbackRingRows?)?
+    /// Moves the viewport to a scroll offset; the ring hands a settled
+    /// fling's row back through it.
+    var onScrollToRow: ((Int) -> Void)?
+    /// Receives this pane's render tier (focused, visible, hidden) and its
+    /// surface identifier as focus and visibility change.
+    var onRenderTierChange: ((SessionRenderTier, UUID) -> Void)?
+    /// Attaches a display-link snapshot feed for the given surface; the
+    /// renderer then pulls snapshots itself instead of waiting on
+    /// `snapshotNonce`.
+    var attachSnapshotFeed: ((UUID) -> GridSnapshotFeed)?
+    var detachSnapshotFeed: ((UUID) -> Void)?
+    /// Session totals shown by the performance HUD, when enabled.
+    var performanceHUDStatsProvider: (() -> PerformanceHUDSessionStats)?
+    /// Receives the cell size in device pixels whenever it changes, for
+    /// sizing inline images.
+    var onCellPixelSizeChange: ((Int, Int) -> Void)?
+    /// Receives the pane's thumbnail after its content changes (see
+    /// SessionThumbnailAtlas).
+    var onThumbnail: ((CGImage) -> Void)?
 
     @StateObject private var model = MetalTerminalSurfaceModel()
 
@@ -56,10 +78,23 @@ struct MetalTerminalSessionSurface: View {
                 .onAppear {
                     model.renderer?.isLocalSession = isLocalSession
                     model.renderer?.scrollbackBoundsProvider = scrollbackCountProvider
+                    model.renderer?.scrollOffsetProvider = scrollOffsetProvider
+                    model.renderer?.scrollbackRingRowsProvider = scrollbackRingRowsProvider
+                    model.renderer?.scrollToRowHandler = onScrollToRow
+                    if let performanceHUDStatsProvider {
+                        model.renderer?.performanceHUDStatsProvider = { performanceHUDStatsProvider() }
+                    }
+                    model.renderer?.reloadPerformanceHUDSettings()
+                    model.renderer?.onCellPixelSizeChange = onCellPixelSizeChange
+                    model.renderer?.onThumbnail = onThumbnail
                     if let scrollOffsetProvider {
                         model.renderer?.scrollJumpTo(row: scrollOffsetProvider())
                     }
+                    model.onRenderTierChange = onRenderTierChange
                     model.apply(snapshot: snapshotProvider())
+                    if let attachSnapshotFeed {
+                        model.renderer?.snapshotFeed = attachSnapshotFeed(model.surfaceID)
+                    }
                     model.setRendererPaused(false)
                     model.updateFPS(isFocused: isFocused)
                     selectionCoordinator?.register(sessionID: sessionID, model: model)
@@ -74,6 +109,10 @@ struct MetalTerminalSessionSurface: View {
                 }
                 .onDisappear {
                     model.setRendererPaused(true)
+                    if model.renderer?.snapshotFeed != nil {
+                        model.renderer?.snapshotFeed = nil
+                        detachSnapshotFeed?(model.surfaceID)
+                    }
                     selectionCoordinator?.unregister(sessionID: sessionID)
                 }
                 .onChange(of: snapshotNonce) { _, _ in
@@ -165,6 +204,10 @@ final class TerminalSelectionCoordinator: ObservableObject {
         model(for: sessionID)?.clearSelection()
     }
 
+    func runRendererStress(sessionID: UUID) {
+        model(for: sessionID)?.runRendererStress()
+    }
+
     private func model(for sessionID: UUID) -> MetalTerminalSurfaceModel? {
         guard let weakModel = models[sessionID],
               let model = weakModel.model else {
@@ -194,6 +237,17 @@ final class MetalTerminalSurfaceModel: ObservableObject {
     /// Marked `nonisolated(unsafe)` so deinit can access it without
     /// crossing the MainActor isolation boundary.
     nonisolated(unsafe) private var settingsObserver: NSObjectProtocol?
+    nonisolated(unsafe) private var thermalObserver: NSObjectProtocol?
+
+    /// Receives the pane's render tier and `surfaceID` whenever the tier changes.
+    var onRenderTierChange: ((SessionRenderTier, UUID) -> Void)? {
+        didSet { reportedTier = nil }
+    }
+    /// Distinguishes this pane from others showing the same session.
+    let surfaceID = UUID()
+    private var isFocused = true
+    private var reportedTier: SessionRenderTier?
+    private var rendererStressTask: Task<Void, Never>?
 
     private static let terminalUIFontSizeKey = "terminal.ui.fontSize"
     private static let terminalUIFontFamilyKey = "terminal.ui.fontFamily"
@@ -232,12 +286,28 @@ final class MetalTerminalSurfaceModel: ObservableObject {
                 self?.reloadRendererSettingsIfNeeded()
             }
         }
+        // Stretch frame rates under thermal pressure (see SessionRenderBudget).
+        thermalObserver = NotificationCenter.default.addObserver(
+            forName: ProcessInfo.thermalStateDidChangeNotification,
+            object: nil,
+            queue: .main
+        ) { [weak self] _ in
+            MainActor.assumeIsolated {
+                self?.applyRenderTier()
+            }
+        }
+        renderer?.onRenderVisibilityChange = { [weak self] _ in
+            self?.applyRenderTier()
+        }
     }
 
     deinit {
         if let observer = settingsObserver {
             NotificationCenter.default.removeObserver(observer)
         }
+        if let observer = thermalObserver {
+            NotificationCenter.default.removeObserver(observer)
+        }
     }
 
     func apply(snapshot: GridSnapshot?) {
@@ -247,10 +317,32 @@ final class MetalTerminalSurfaceModel: ObservableObject {
 
     func setRendererPaused(_ paused: Bool) {
         renderer?.setPaused(paused)
+        applyRenderTier()
     }
 
     func updateFPS(isFocused: Bool) {
-        renderer?.setPreferredFPS(isFocused ? 0 : 30)
+        self.isFocused = isFocused
+        applyRenderTier()
+    }
+
+    /// Tier from focus and renderer visibility (host, occlusion, sleep).
+    var renderTier: SessionRenderTier {
+        if renderer?.isRenderVisible == false {
+            return .hidden
+        }
+        return isFocused ? .focused : .visible
+    }
+
+    /// Set the renderer's frame rate for the current tier and report the
+    /// tier when it changed.
+    private func applyRenderTier() {
+        let tier = renderTier
+        renderer?.setPreferredFPS(
+            SessionRenderBudget.preferredFPS(tier: tier, thermalState: ProcessInfo.processInfo.thermalState)
+        )
+        guard tier != reportedTier else { return }
+        reportedTier = tier
+        onRenderTierChange?(tier, surfaceID)
     }
 
     func updateFontSize(_ size: CGFloat) {
@@ -323,6 +415,19 @@ final class MetalTerminalSurfaceModel: ObservableObject {
         renderer?.selectedText()
     }
 
+    /// Run `RendererStressHarness.runSuite` on this pane, then print the
+    /// report and copy it to the pasteboard.
+    func runRendererStress() {
+        guard let renderer, rendererStressTask == nil else { return }
+        rendererStressTask = Task { [weak self] in
+            let report = RendererStressHarness.report(await RendererStressHarness.runSuite(renderer: renderer))
+            print("==> Renderer stress\n\(report)")
+            NSPasteboard.general.clearContents()
+            NSPasteboard.general.setString(report, forType: .string)
+            self?.rendererStressTask = nil
+        }
+    }
+
     var hasSelection: Bool {
         renderer?.hasSelection ?? false
     }
@@ -371,6 +476,8 @@ final class MetalTerminalSurfaceModel: ObservableObject {
             cachedSmoothScrollConfiguration = smoothScrollConfiguration
             renderer.reloadSmoothScrollSettings()
         }
+
+        renderer.reloadPerformanceHUDSettings()
     }
 
     private static func loadTerminalUIFontSize(defaults: UserDefaults = .standard) -> CGFloat {
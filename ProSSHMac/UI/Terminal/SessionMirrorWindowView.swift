@@ -0,0 +1,158 @@
+import SwiftUI
+import Network
+
+/// Watches a session mirrored from another Mac (see SessionMirrorViewer):
+/// pick it from the sessions found nearby, or enter its address, then enter
+/// its access code. The terminal is shown read-only.
+struct SessionMirrorWindowView: View {
+    @StateObject private var viewer = SessionMirrorViewer()
+    @AppStorage(TransparencyManager.backgroundOpacityKey) private var terminalBackgroundOpacityPercent = TransparencyManager.defaultBackgroundOpacityPercent
+    @AppStorage("terminal.ui.fontSize") private var terminalUIFontSize = 12.0
+    @AppStorage("terminal.ui.fontFamily") private var terminalUIFontFamily = FontManager.platformDefaultFontFamily
+    @State private var selectedServiceID: String?
+    @State private var address = ""
+    @State private var accessCode = ""
+
+    var body: some View {
+        Group {
+            if case .watching(let name) = viewer.state {
+                watching(name)
+            } else {
+                connectForm
+            }
+        }
+        .frame(minWidth: 640, minHeight: 420)
+        .background(Color(nsColor: .windowBackgroundColor))
+        .onAppear {
+            viewer.startBrowsing()
+        }
+        .onDisappear {
+            viewer.stopWatching()
+            viewer.stopBrowsing()
+        }
+    }
+
+    // MARK: - Connecting
+
+    private var connectForm: some View {
+        Form {
+            Section("Mirrored Sessions Nearby") {
+                if viewer.services.isEmpty {
+                    Text("Looking for mirrored sessions…")
+                        .foregroundStyle(.secondary)
+                } else {
+                    Picker("Session", selection: $selectedServiceID) {
+                        Text("None").tag(String?.none)
+                        ForEach(viewer.services) { service in
+                            Text(service.name).tag(Optional(service.id))
+                        }
+                    }
+                    .pickerStyle(.radioGroup)
+                }
+                TextField("Or address (host:port)", text: $address)
+                    .textFieldStyle(.roundedBorder)
+            }
+
+            Section("Access Code") {
+                TextField("XXXXX-XXXXX", text: $accessCode)
+                    .textFieldStyle(.roundedBorder)
+                    .font(.system(.body, design: .monospaced))
+                    .onSubmit(watch)
+                Text("Shown on the sharing Mac under the tab's Mirror Read-Only menu.")
+                    .font(.caption)
+                    .foregroundStyle(.secondary)
+            }
+
+            if case .failed(let message) = viewer.state {
+                Text(message)
+                    .foregroundStyle(.red)
+            }
+
+            HStack {
+                Spacer()
+                if case .connecting = viewer.state {
+                    ProgressView()
+                        .controlSize(.small)
+                    Button("Cancel") {
+                        viewer.stopWatching()
+                    }
+                } else {
+                    Button("Watch", action: watch)
+                        .keyboardShortcut(.defaultAction)
+                        .disabled(target == nil || SessionMirrorConnection.normalizedAccessCode(accessCode).isEmpty)
+                }
+            }
+        }
+        .formStyle(.grouped)
+        .padding()
+    }
+
+    /// The typed address when there is one, else the picked service.
+    private var target: (endpoint: NWEndpoint, name: String)? {
+        let trimmed = address.trimmingCharacters(in: .whitespaces)
+        if !trimmed.isEmpty {
+            guard let separator = trimmed.lastIndex(of: ":"),
+                  let port = UInt16(trimmed[trimmed.index(after: separator)...]),
+                  let endpointPort = NWEndpoint.Port(rawValue: port) else { return nil }
+            let host = trimmed[..<separator].trimmingCharacters(in: CharacterSet(charactersIn: "[]"))
+            guard !host.isEmpty else { return nil }
+            return (.hostPort(host: NWEndpoint.Host(host), port: endpointPort), trimmed)
+        }
+        guard let service = viewer.services.first(where: { $0.id == selectedServiceID }) else { return nil }
+        return (service.endpoint, service.name)
+    }
+
+    private func watch() {
+        guard let target, !SessionMirrorConnection.normalizedAccessCode(accessCode).isEmpty else { return }
+        viewer.watch(target.endpoint, named: target.name, accessCode: accessCode)
+    }
+
+    // MARK: - Watching
+
+    private func watching(_ name: String) -> some View {
+        VStack(spacing: 0) {
+            HStack {
+                VStack(alignment: .leading, spacing: 2) {
+                    Text(name)
+                        .font(.headline)
+                    Label("Read-only mirror", systemImage: "eye")
+                        .font(.subheadline)
+                        .foregroundStyle(.secondary)
+                }
+                Spacer()
+                Button("Stop Watching") {
+                    viewer.stopWatching()
+                }
+            }
+            .padding(.horizontal, 12)
+            .padding(.top, 8)
+            .padding(.bottom, 4)
+
+            MetalTerminalSessionSurface(
+                sessionID: viewer.surfaceID,
+                snapshotProvider: { viewer.latestSnapshot },
+                snapshotNonce: 0,
+                fontSize: terminalUIFontSize,
+                fontFamily: terminalUIFontFamily,
+                backgroundOpacityPercent: terminalBackgroundOpacityPercent,
+                onTap: nil,
+                attachSnapshotFeed: { _ in viewer.feed },
+                detachSnapshotFeed: { _ in }
+            )
+            .id(viewer.surfaceID)
+            .padding(.horizontal, 8)
+            .padding(.bottom, 8)
+        }
+    }
+}
+
+/// File menu item opening the mirror viewer window.
+struct WatchMirroredSessionCommand: View {
+    @Environment(\.openWindow) private var openWindow
+
+    var body: some View {
+        Button("Watch Mirrored Session…") {
+            openWindow(id: ProSSHMacApp.sessionMirrorWindowID)
+        }
+    }
+}
@@ -0,0 +1,88 @@
+import SwiftUI
+
+/// A session's last thumbnail (see SessionThumbnailStore), or a placeholder
+/// until its pane has been drawn.
+struct SessionThumbnailView: View {
+    @ObservedObject var store: SessionThumbnailStore
+    let sessionID: UUID
+
+    var body: some View {
+        ZStack {
+            Color.black
+            if let image = store.images[sessionID] {
+                Image(decorative: image, scale: 1)
+                    .resizable()
+                    .interpolation(.medium)
+            } else {
+                Image(systemName: "terminal")
+                    .font(.title2)
+                    .foregroundStyle(.secondary)
+            }
+        }
+        .aspectRatio(
+            CGFloat(SessionThumbnailAtlas.slotWidth) / CGFloat(SessionThumbnailAtlas.slotHeight),
+            contentMode: .fit
+        )
+        .clipShape(RoundedRectangle(cornerRadius: 6))
+    }
+}
+
+/// Every open tab as a thumbnail; clicking one selects it. The tiles are
+/// stored images, so opening the overview renders nothing for tabs that
+/// are not on screen.
+struct SessionOverviewView: View {
+    @ObservedObject var tabManager: SessionTabManager
+    var onDismiss: () -> Void
+
+    @EnvironmentObject private var sessionManager: SessionManager
+
+    private let columns = [GridItem(.adaptive(minimum: 220, maximum: 300), spacing: 16)]
+
+    var body: some View {
+        VStack(spacing: 0) {
+            HStack {
+                Text("Sessions")
+                    .font(.headline)
+                Spacer()
+                Button("Done", action: onDismiss)
+                    .keyboardShortcut(.cancelAction)
+            }
+            .padding()
+
+            ScrollView {
+                LazyVGrid(columns: columns, spacing: 16) {
+                    ForEach(tabManager.tabs) { tab in
+                        tile(for: tab)
+                    }
+                }
+                .padding()
+            }
+        }
+        .frame(minWidth: 620, minHeight: 420)
+    }
+
+    private func tile(for tab: SessionTab) -> some View {
+        let isSelected = tabManager.selectedSessionID == tab.id
+        return Button {
+            tabManager.select(sessionID: tab.id)
+            onDismiss()
+        } label: {
+            VStack(alignment: .leading, spacing: 6) {
+                SessionThumbnailView(store: sessionManager.thumbnailStore, sessionID: tab.id)
+                    .overlay(
+                        RoundedRectangle(cornerRadius: 6)
+                            .stroke(isSelected ? Color.accentColor : Color.secondary.opacity(0.3), lineWidth: isSelected ? 2 : 1)
+                    )
+                HStack(spacing: 6) {
+                    Circle()
+                        .fill(tab.statusColor)
+                        .frame(width: 8, height: 8)
+                    Text(sessionManager.liveState(for: tab.id).windowTitle ?? tab.label)
+                        .font(.caption)
+                        .lineLimit(1)
+                }
+            }
+        }
+        .buttonStyle(.plain)
+    }
+}
@@ -44,6 +44,13 @@ struct TerminalAIAssistantPane: View {
             )
             .interactiveDismissDisabled(true)
         }
+        // Open the provider connection while the user reads or types.
+        .onAppear { providerRegistry.prewarmActiveProvider() }
+        .onChange(of: viewModel.draftPrompt.isEmpty) { wasEmpty, isEmpty in
+            if wasEmpty && !isEmpty {
+                providerRegistry.prewarmActiveProvider()
+            }
+        }
     }
 
     private var header: some View {
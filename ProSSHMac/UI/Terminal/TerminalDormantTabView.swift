@@ -0,0 +1,43 @@
+// TerminalDormantTabView.swift
+// ProSSHV2
+//
+// Stands in for the terminal of a tab restored from the workspace snapshot
+// until its host is connected: the saved rows as plain text, no engine or
+// Metal renderer. Appearing starts the connection.
+
+import SwiftUI
+
+struct TerminalDormantTabView: View {
+    let tab: WorkspaceSnapshot.Tab
+    let fontFamily: String
+    let fontSize: Double
+    var onActivate: () -> Void
+
+    var body: some View {
+        VStack(alignment: .leading, spacing: 0) {
+            ForEach(Array(tab.previewLines.enumerated()), id: \.offset) { _, line in
+                Text(verbatim: line)
+                    .font(.custom(fontFamily, size: fontSize))
+                    .lineLimit(1)
+            }
+            Spacer(minLength: 0)
+        }
+        .padding(8)
+        .frame(maxWidth: .infinity, maxHeight: .infinity, alignment: .topLeading)
+        .opacity(0.6)
+        .overlay(alignment: .top) {
+            HStack(spacing: 6) {
+                ProgressView()
+                    .controlSize(.small)
+                Text("Reconnecting to \(tab.hostLabel)…")
+                    .font(.caption)
+                    .foregroundStyle(.secondary)
+            }
+            .padding(.horizontal, 10)
+            .padding(.vertical, 6)
+            .background(.ultraThinMaterial, in: Capsule())
+            .padding(.top, 8)
+        }
+        .onAppear(perform: onActivate)
+    }
+}
@@ -18,6 +18,10 @@ struct TerminalFileBrowserSidebar: View {
     @State private var fileBrowserLoadRequestIDByPath: [String: UUID] = [:]
     @State private var isFileBrowserRootLoading = false
     @State private var fileBrowserError: String?
+    @State private var localDirectoryWatcher: TerminalLocalDirectoryWatcher?
+    @State private var fileBrowserRefreshingPaths: Set<String> = []
+    @State private var fileBrowserPendingRefreshPaths: Set<String> = []
+    @State private var remoteEditError: String?
 
     var body: some View {
         VStack(alignment: .leading, spacing: 10) {
@@ -67,7 +71,7 @@ struct TerminalFileBrowserSidebar: View {
                         Image(systemName: "square.and.arrow.down")
                     }
                     .buttonStyle(.bordered)
-                    .disabled(session.isLocal || selectedFileBrowserItem?.isDirectory != false)
+                    .disabled(session.isLocal || selectedFileBrowserItem == nil)
                 }
 
                 Text(fileBrowserCurrentPath)
@@ -75,6 +79,8 @@ struct TerminalFileBrowserSidebar: View {
                     .foregroundStyle(.secondary)
                     .lineLimit(1)
 
+                remoteEditsSection(for: session)
+
                 Divider()
 
                 if isFileBrowserRootLoading && fileBrowserRows.isEmpty {
@@ -112,7 +118,10 @@ struct TerminalFileBrowserSidebar: View {
             Divider()
         }
         .onAppear { syncSession() }
-        .onDisappear { transferManager.setActiveSession(nil) }
+        .onDisappear {
+            transferManager.setActiveSession(nil)
+            stopLocalDirectoryWatcher()
+        }
         .onChange(of: session?.id) { _, _ in syncSession() }
     }
 
@@ -175,11 +184,19 @@ struct TerminalFileBrowserSidebar: View {
                 Button(isExpanded ? "Collapse" : "Expand") {
                     toggleFileBrowserDirectory(entry, for: session)
                 }
+                if !session.isLocal {
+                    Button("Download Folder") {
+                        downloadFileBrowserFile(entry)
+                    }
+                }
             } else {
                 if !session.isLocal {
                     Button("Download") {
                         downloadFileBrowserFile(entry)
                     }
+                    Button("Open in Local Editor") {
+                        openInLocalEditor(entry.path, session: session)
+                    }
                 }
                 Button("Open in nano") {
                     openFileInTerminal(entry.path, editor: "nano")
@@ -200,6 +217,79 @@ struct TerminalFileBrowserSidebar: View {
         }
     }
 
+    /// Remote files of this session open in a local editor, with how their
+    /// last save went.
+    @ViewBuilder
+    private func remoteEditsSection(for session: Session) -> some View {
+        let edits = sessionManager.remoteEdits.filter { $0.sessionID == session.id }
+        if !edits.isEmpty || remoteEditError != nil {
+            VStack(alignment: .leading, spacing: 4) {
+                ForEach(edits) { edit in
+                    remoteEditRow(edit)
+                }
+                if let remoteEditError {
+                    Text(remoteEditError)
+                        .font(.caption)
+                        .foregroundStyle(.red)
+                }
+            }
+        }
+    }
+
+    private func remoteEditRow(_ edit: RemoteEdit) -> some View {
+        HStack(spacing: 6) {
+            Image(systemName: "pencil.and.outline")
+                .foregroundStyle(.secondary)
+            VStack(alignment: .leading, spacing: 1) {
+                Text((edit.remotePath as NSString).lastPathComponent)
+                    .font(.caption)
+                    .lineLimit(1)
+                Text(Self.remoteEditStatus(edit.status))
+                    .font(.caption2)
+                    .foregroundStyle(edit.status == .conflict ? .orange : .secondary)
+                    .lineLimit(2)
+            }
+            Spacer()
+            if edit.status == .conflict {
+                Button("Overwrite") {
+                    sessionManager.remoteEditCoordinator.overwrite(edit.id)
+                }
+                .controlSize(.small)
+            }
+            Button {
+                sessionManager.remoteEditCoordinator.close(edit.id)
+            } label: {
+                Image(systemName: "xmark.circle")
+            }
+            .buttonStyle(.borderless)
+            .help("Stop syncing this file")
+        }
+        .help(edit.remotePath)
+        .contextMenu {
+            Button("Open Again") {
+                PlatformURL.openInEditor(edit.localURL)
+            }
+        }
+    }
+
+    private static func remoteEditStatus(_ status: RemoteEdit.Status) -> String {
+        switch status {
+        case .downloading:
+            return "Downloading…"
+        case .watching:
+            return "Watching for saves"
+        case .syncing:
+            return "Uploading changes…"
+        case let .synced(bytesSent, at):
+            let size = ByteCountFormatter.string(fromByteCount: Int64(bytesSent), countStyle: .file)
+            return "Saved \(at.formatted(date: .omitted, time: .shortened)), \(size) sent"
+        case .conflict:
+            return "Changed on the server"
+        case .failed(let message):
+            return message
+        }
+    }
+
     private func syncSession() {
         guard let session = session, session.state == .connected else {
             transferManager.setActiveSession(nil)
@@ -213,6 +303,7 @@ struct TerminalFileBrowserSidebar: View {
             fileBrowserLoadRequestIDByPath = [:]
             isFileBrowserRootLoading = false
             fileBrowserError = nil
+            stopLocalDirectoryWatcher()
             return
         }
 
@@ -235,12 +326,16 @@ struct TerminalFileBrowserSidebar: View {
 
         if fileBrowserChildrenByPath[fileBrowserCurrentPath] == nil && !isFileBrowserRootLoading {
             loadFileBrowserRoot(for: session, path: fileBrowserCurrentPath)
+        } else if session.isLocal && localDirectoryWatcher == nil {
+            // Reappearing: resume watching and catch up on what changed while hidden.
+            startLocalDirectoryWatcher(rootPath: fileBrowserCurrentPath, sessionID: session.id)
+            refreshFileBrowserRoot(for: session)
         }
     }
 
     private func initialFileBrowserRootPath(for session: Session) -> String {
         if session.isLocal {
-            let workingDirectory = sessionManager.workingDirectoryBySessionID[session.id]?
+            let workingDirectory = sessionManager.liveState(for: session.id).workingDirectory?
                 .trimmingCharacters(in: .whitespacesAndNewlines)
             if let workingDirectory, !workingDirectory.isEmpty {
                 return normalizeFileBrowserPath(workingDirectory, isLocal: true)
@@ -252,7 +347,7 @@ struct TerminalFileBrowserSidebar: View {
 
     private func downloadSelectedFileFromSidebar() {
         guard let session = session, !session.isLocal,
-              let entry = selectedFileBrowserItem, !entry.isDirectory else { return }
+              let entry = selectedFileBrowserItem else { return }
         downloadFileBrowserFile(entry)
     }
 
@@ -269,6 +364,18 @@ struct TerminalFileBrowserSidebar: View {
         )
     }
 
+    private func openInLocalEditor(_ path: String, session: Session) {
+        remoteEditError = nil
+        Task {
+            do {
+                let url = try await sessionManager.remoteEditCoordinator.open(sessionID: session.id, remotePath: path)
+                PlatformURL.openInEditor(url)
+            } catch {
+                remoteEditError = "Could not open \((path as NSString).lastPathComponent): \(error.localizedDescription)"
+            }
+        }
+    }
+
     private func openFileInTerminal(_ path: String, editor: String) {
         guard let session = session, session.state == .connected else { return }
         let escapedPath = shellEscapeForTerminal(path)
@@ -291,6 +398,17 @@ struct TerminalFileBrowserSidebar: View {
     }
 
     private func refreshFileBrowserRoot(for session: Session) {
+        // Local listings are patched in place: re-read what is loaded and keep
+        // the expansion, instead of starting over.
+        if session.isLocal, fileBrowserChildrenByPath[fileBrowserCurrentPath] != nil, !isFileBrowserRootLoading {
+            for path in fileBrowserChildrenByPath.keys {
+                refreshLocalDirectory(path, sessionID: session.id)
+            }
+            return
+        }
+        if !session.isLocal {
+            sessionManager.invalidateRemoteDirectoryCache(sessionID: session.id)
+        }
         loadFileBrowserRoot(for: session, path: fileBrowserCurrentPath)
     }
 
@@ -304,6 +422,11 @@ struct TerminalFileBrowserSidebar: View {
         fileBrowserLoadRequestIDByPath = [:]
         fileBrowserError = nil
         selectedFileBrowserPath = nil
+        if session.isLocal {
+            startLocalDirectoryWatcher(rootPath: normalizedPath, sessionID: session.id)
+        } else {
+            stopLocalDirectoryWatcher()
+        }
         loadFileBrowserDirectory(path: normalizedPath, for: session, isRoot: true)
     }
 
@@ -315,10 +438,12 @@ struct TerminalFileBrowserSidebar: View {
         }
 
         fileBrowserExpandedPaths.insert(entry.path)
-        if fileBrowserChildrenByPath[entry.path] == nil {
+        // Remote listings are revalidated on every expand (usually one stat);
+        // local ones are kept current by the directory watcher.
+        if fileBrowserChildrenByPath[entry.path] == nil || !session.isLocal {
             loadFileBrowserDirectory(path: entry.path, for: session, isRoot: false)
         }
-        rebuildFileBrowserRows()
+        rebuildFileBrowserRows(under: entry.path)
     }
 
     private func collapseFileBrowserDirectory(_ path: String) {
@@ -326,7 +451,7 @@ struct TerminalFileBrowserSidebar: View {
             fileBrowserExpandedPaths,
             collapsing: path
         )
-        rebuildFileBrowserRows()
+        rebuildFileBrowserRows(under: path)
     }
 
     private func loadFileBrowserDirectory(path: String, for session: Session, isRoot: Bool) {
@@ -343,9 +468,35 @@ struct TerminalFileBrowserSidebar: View {
         fileBrowserError = nil
         fileBrowserLoadingPaths.insert(normalizedPath)
 
+        // A cached remote listing shows at once; the load below revalidates it
+        // and replaces it only when complete, so a changed directory does not
+        // flash back to its first page.
+        if !session.isLocal, fileBrowserChildrenByPath[normalizedPath] == nil,
+           let cached = sessionManager.cachedRemoteDirectory(sessionID: session.id, path: normalizedPath) {
+            fileBrowserChildrenByPath[normalizedPath] = cached.map(Self.fileBrowserEntry)
+            rebuildFileBrowserRows(under: normalizedPath)
+        }
+        let showsCachedListing = fileBrowserChildrenByPath[normalizedPath] != nil
+
         Task {
             do {
-                let entries = try await listFileBrowserEntries(for: session, path: normalizedPath)
+                // Large remote directories arrive in pages; show the first one
+                // right away, then refresh at most ten times a second.
+                var entries: [TerminalFileBrowserEntry] = []
+                var lastPublished: ContinuousClock.Instant?
+                for try await page in try await fileBrowserEntryPages(for: session, path: normalizedPath) {
+                    entries = TerminalFileBrowserTree.mergeListingPage(page, into: entries)
+                    if showsCachedListing {
+                        continue
+                    }
+                    if let lastPublished, lastPublished.duration(to: .now) < .milliseconds(100) {
+                        continue
+                    }
+                    guard publishFileBrowserPage(entries, path: normalizedPath, requestID: requestID, sessionID: session.id) else {
+                        break
+                    }
+                    lastPublished = .now
+                }
                 await MainActor.run {
                     guard fileBrowserLoadRequestIDByPath[normalizedPath] == requestID else {
                         if fileBrowserLoadRequestIDByPath[normalizedPath] == nil {
@@ -374,7 +525,10 @@ struct TerminalFileBrowserSidebar: View {
                     if let selectedPath = selectedFileBrowserPath, !fileBrowserContainsPath(selectedPath) {
                         selectedFileBrowserPath = nil
                     }
-                    rebuildFileBrowserRows()
+                    rebuildFileBrowserRows(under: normalizedPath)
+                    if !session.isLocal {
+                        sessionManager.prefetchRemoteSubdirectories(sessionID: session.id, of: normalizedPath)
+                    }
                 }
             } catch {
                 await MainActor.run {
@@ -411,22 +565,54 @@ struct TerminalFileBrowserSidebar: View {
         }
     }
 
-    private func listFileBrowserEntries(for session: Session, path: String) async throws -> [TerminalFileBrowserEntry] {
+    /// Shows a partial listing while the rest of the directory is still being
+    /// read. Returns false once the load is stale, so the caller stops reading.
+    private func publishFileBrowserPage(
+        _ entries: [TerminalFileBrowserEntry],
+        path: String,
+        requestID: UUID,
+        sessionID: UUID
+    ) -> Bool {
+        guard fileBrowserLoadRequestIDByPath[path] == requestID,
+              fileBrowserSessionID == sessionID else {
+            return false
+        }
+        fileBrowserChildrenByPath[path] = entries
+        rebuildFileBrowserRows(under: path)
+        return true
+    }
+
+    private func fileBrowserEntryPages(
+        for session: Session,
+        path: String
+    ) async throws -> AsyncThrowingStream<[TerminalFileBrowserEntry], Error> {
         if session.isLocal {
-            return try await Task.detached(priority: .userInitiated) {
-                try TerminalFileBrowserTree.listLocalEntries(path: path)
-            }.value
-        }
-
-        let remoteEntries = try await sessionManager.listRemoteDirectory(sessionID: session.id, path: path)
-        return remoteEntries.map {
-            TerminalFileBrowserEntry(
-                path: $0.path,
-                name: $0.name,
-                isDirectory: $0.isDirectory,
-                size: $0.size
-            )
+            return TerminalFileBrowserTree.localEntryPages(path: path)
         }
+
+        let pages = try await sessionManager.remoteDirectoryPages(sessionID: session.id, path: path)
+        return AsyncThrowingStream { continuation in
+            let task = Task {
+                do {
+                    for try await page in pages {
+                        continuation.yield(page.map(Self.fileBrowserEntry))
+                    }
+                    continuation.finish()
+                } catch {
+                    continuation.finish(throwing: error)
+                }
+            }
+            continuation.onTermination = { _ in task.cancel() }
+        }
+    }
+
+    private static func fileBrowserEntry(_ entry: SFTPDirectoryEntry) -> TerminalFileBrowserEntry {
+        TerminalFileBrowserEntry(
+            path: entry.path,
+            name: entry.name,
+            isDirectory: entry.isDirectory,
+            size: entry.size
+        )
     }
 
     private func rebuildFileBrowserRows() {
@@ -437,6 +623,126 @@ struct TerminalFileBrowserSidebar: View {
         )
     }
 
+    /// Regenerates only the rows below `path`; see `TerminalFileBrowserTree.updateRows`.
+    private func rebuildFileBrowserRows(under path: String) {
+        TerminalFileBrowserTree.updateRows(
+            &fileBrowserRows,
+            under: path,
+            rootPath: fileBrowserCurrentPath,
+            childrenByPath: fileBrowserChildrenByPath,
+            expandedPaths: fileBrowserExpandedPaths
+        )
+    }
+
+    // MARK: - Local Change Tracking
+
+    private func startLocalDirectoryWatcher(rootPath: String, sessionID: UUID) {
+        guard localDirectoryWatcher?.rootPath != rootPath else { return }
+        localDirectoryWatcher?.stop()
+        fileBrowserRefreshingPaths = []
+        fileBrowserPendingRefreshPaths = []
+        localDirectoryWatcher = TerminalLocalDirectoryWatcher(rootPath: rootPath) { changes in
+            Task { @MainActor in
+                applyLocalDirectoryChanges(changes, sessionID: sessionID)
+            }
+        }
+    }
+
+    private func stopLocalDirectoryWatcher() {
+        localDirectoryWatcher?.stop()
+        localDirectoryWatcher = nil
+        fileBrowserRefreshingPaths = []
+        fileBrowserPendingRefreshPaths = []
+    }
+
+    private func applyLocalDirectoryChanges(_ changes: [TerminalLocalDirectoryWatcher.Change], sessionID: UUID) {
+        guard fileBrowserSessionID == sessionID else { return }
+        var paths: Set<String> = []
+        for change in changes {
+            if change.rescanSubtree {
+                let prefix = change.directoryPath == "/" ? "/" : change.directoryPath + "/"
+                paths.formUnion(fileBrowserChildrenByPath.keys.filter {
+                    $0 == change.directoryPath || $0.hasPrefix(prefix)
+                })
+            } else if fileBrowserChildrenByPath[change.directoryPath] != nil {
+                // Only directories the browser has loaded matter; the rest are read on expand.
+                paths.insert(change.directoryPath)
+            }
+        }
+        for path in paths {
+            refreshLocalDirectory(path, sessionID: sessionID)
+        }
+    }
+
+    /// Re-reads one loaded local directory in the background and applies the
+    /// difference to the tree: removed subdirectories drop their cached
+    /// listings and expansion, and only that directory's rows are rebuilt.
+    private func refreshLocalDirectory(_ path: String, sessionID: UUID) {
+        // A load in progress will pick the change up; one refresh at a time per directory.
+        guard fileBrowserLoadRequestIDByPath[path] == nil else { return }
+        guard !fileBrowserRefreshingPaths.contains(path) else {
+            fileBrowserPendingRefreshPaths.insert(path)
+            return
+        }
+        fileBrowserRefreshingPaths.insert(path)
+
+        Task {
+            var entries: [TerminalFileBrowserEntry] = []
+            var failed = false
+            do {
+                for try await page in TerminalFileBrowserTree.localEntryPages(path: path) {
+                    entries = TerminalFileBrowserTree.mergeListingPage(page, into: entries)
+                }
+            } catch {
+                failed = true
+            }
+
+            fileBrowserRefreshingPaths.remove(path)
+            guard fileBrowserSessionID == sessionID,
+                  fileBrowserLoadRequestIDByPath[path] == nil,
+                  let previous = fileBrowserChildrenByPath[path] else {
+                return
+            }
+            if !failed {
+                applyLocalListing(entries, previous: previous, path: path)
+            } else if path == fileBrowserCurrentPath {
+                // The root itself went away or became unreadable. A vanished
+                // subdirectory is dropped by its parent's refresh instead.
+                fileBrowserError = "Local directory is no longer readable: \(path)"
+            }
+            if fileBrowserPendingRefreshPaths.remove(path) != nil {
+                refreshLocalDirectory(path, sessionID: sessionID)
+            }
+        }
+    }
+
+    private func applyLocalListing(
+        _ entries: [TerminalFileBrowserEntry],
+        previous: [TerminalFileBrowserEntry],
+        path: String
+    ) {
+        let diff = TerminalFileBrowserTree.listingDiff(from: previous, to: entries)
+        guard !diff.inserted.isEmpty || !diff.removed.isEmpty else { return }
+
+        for removed in diff.removed where removed.isDirectory {
+            // A directory whose size changed is in both lists; keep its subtree.
+            guard !diff.inserted.contains(where: { $0.path == removed.path && $0.isDirectory }) else { continue }
+            let prefix = removed.path + "/"
+            for cached in fileBrowserChildrenByPath.keys where cached == removed.path || cached.hasPrefix(prefix) {
+                fileBrowserChildrenByPath[cached] = nil
+            }
+            fileBrowserExpandedPaths = TerminalFileBrowserTree.collapseExpandedPaths(
+                fileBrowserExpandedPaths,
+                collapsing: removed.path
+            )
+        }
+        fileBrowserChildrenByPath[path] = entries
+        if let selectedPath = selectedFileBrowserPath, !fileBrowserContainsPath(selectedPath) {
+            selectedFileBrowserPath = nil
+        }
+        rebuildFileBrowserRows(under: path)
+    }
+
     private func fileBrowserContainsPath(_ path: String) -> Bool {
         TerminalFileBrowserTree.containsPath(
             path,
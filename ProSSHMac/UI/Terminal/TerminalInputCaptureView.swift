@@ -19,6 +19,9 @@ struct DirectTerminalInputCaptureView: NSViewRepresentable {
     var onCommandShortcut: ((HardwareKeyCommandAction) -> Void)?
     let onSendSequence: (UUID, String) -> Void
     var onSendBytes: ((UUID, [UInt8], String) -> Void)?
+    /// Takes a press for broadcast or group routing; returns false to send
+    /// it to `sessionID` through the callbacks above.
+    var onBroadcastInput: ((BroadcastKeyInput) -> Bool)?
 
     func makeNSView(context: Context) -> DirectTerminalInputNSView {
         let view = DirectTerminalInputNSView(frame: .zero)
@@ -30,11 +33,14 @@ struct DirectTerminalInputCaptureView: NSViewRepresentable {
         view.onCommandShortcut = onCommandShortcut
         view.onSendSequence = onSendSequence
         view.onSendBytes = onSendBytes
+        view.onBroadcastInput = onBroadcastInput
         view.armForKeyboardInputIfNeeded()
         return view
     }
 
     func updateNSView(_ nsView: DirectTerminalInputNSView, context: Context) {
+        let traceStart = TraceRecorder.shared.begin()
+        defer { TraceRecorder.shared.end(.viewUpdate, since: traceStart) }
         nsView.isEnabled = isEnabled
         nsView.sessionID = sessionID
         nsView.isLocalSession = isLocalSession
@@ -43,6 +49,7 @@ struct DirectTerminalInputCaptureView: NSViewRepresentable {
         nsView.onCommandShortcut = onCommandShortcut
         nsView.onSendSequence = onSendSequence
         nsView.onSendBytes = onSendBytes
+        nsView.onBroadcastInput = onBroadcastInput
         nsView.armForKeyboardInputIfNeeded()
     }
 }
@@ -79,6 +86,7 @@ final class DirectTerminalInputNSView: NSView {
     var onCommandShortcut: ((HardwareKeyCommandAction) -> Void)?
     var onSendSequence: ((UUID, String) -> Void)?
     var onSendBytes: ((UUID, [UInt8], String) -> Void)?
+    var onBroadcastInput: ((BroadcastKeyInput) -> Bool)?
     private var windowDidBecomeKeyObserver: NSObjectProtocol?
     private var appDidBecomeActiveObserver: NSObjectProtocol?
     private var localKeyEventMonitor: Any?
@@ -258,19 +266,40 @@ final class DirectTerminalInputNSView: NSView {
         if isLocalSession {
             guard let payload = localInputPayload(for: event) else { return false }
             guard shouldCaptureLocalEvent(event, payload: payload) else { return false }
+            if broadcast(event, payload: payload) {
+                return true
+            }
             guard let onSendBytes else { return false }
             onSendBytes(sessionID, payload.bytes, payload.eventType)
             return true
         }
 
-        guard let bytes = encodeEventBytes(event) else { return false }
-        guard let sequence = String(bytes: bytes, encoding: .utf8) else {
+        guard let payload = localInputPayload(for: event) else { return false }
+        guard let sequence = String(bytes: payload.bytes, encoding: .utf8) else {
             return false
         }
+        if broadcast(event, payload: payload) {
+            return true
+        }
         onSendSequence?(sessionID, sequence)
         return true
     }
 
+    /// Offers the press to broadcast routing with a way to re-encode it for
+    /// targets whose input modes differ from the focused session's.
+    private func broadcast(_ event: NSEvent, payload: LocalTerminalInputPayload) -> Bool {
+        guard let onBroadcastInput else { return false }
+        let input = BroadcastKeyInput(
+            options: keyEncoderOptions?() ?? .default,
+            bytes: payload.bytes,
+            eventType: payload.eventType,
+            encode: { options in
+                LocalTerminalSubsystem.encodeKeyEvent(event, options: options)?.bytes
+            }
+        )
+        return onBroadcastInput(input)
+    }
+
     private func localInputPayload(for event: NSEvent) -> LocalTerminalInputPayload? {
         let options = keyEncoderOptions?() ?? .default
         return LocalTerminalSubsystem.encodeKeyEvent(event, options: options)
@@ -301,11 +330,6 @@ final class DirectTerminalInputNSView: NSView {
         )
     }
 
-    private func encodeEventBytes(_ event: NSEvent) -> [UInt8]? {
-        let options = keyEncoderOptions?() ?? .default
-        return LocalTerminalSubsystem.encodeKeyEvent(event, options: options)?.bytes
-    }
-
     private var isTerminalFocused: Bool {
         guard let window else { return false }
         return window.firstResponder === self
@@ -24,6 +24,10 @@ struct TerminalKeyboardShortcutLayer: View {
     var onCopy:                 () -> Void
     var onPaste:                () -> Void
     var onSelectAll:            () -> Void
+    var onPreviousPrompt:       () -> Void
+    var onNextPrompt:           () -> Void
+    var onCopyLastOutput:       () -> Void
+    var onToggleOutputFold:     () -> Void
     var onToggleBroadcast:      () -> Void
     var onToggleMaximize:       () -> Void
 
@@ -77,6 +81,14 @@ struct TerminalKeyboardShortcutLayer: View {
                 .keyboardShortcut("v", modifiers: [.command])
             Button("Select All")               { onSelectAll() }
                 .keyboardShortcut("a", modifiers: [.command])
+            Button("Jump to Previous Prompt")  { onPreviousPrompt() }
+                .keyboardShortcut(.upArrow, modifiers: [.command])
+            Button("Jump to Next Prompt")      { onNextPrompt() }
+                .keyboardShortcut(.downArrow, modifiers: [.command])
+            Button("Copy Last Command Output") { onCopyLastOutput() }
+                .keyboardShortcut("o", modifiers: [.command, .shift])
+            Button("Fold/Expand Last Command Output") { onToggleOutputFold() }
+                .keyboardShortcut("o", modifiers: [.command, .option])
             Button("Toggle Broadcast Input")   { onToggleBroadcast() }
                 .keyboardShortcut("b", modifiers: [.command, .shift])
             Button("Toggle Maximize")          { onToggleMaximize() }
@@ -0,0 +1,36 @@
+// TerminalPasteProgressView.swift
+// ProSSHV2
+//
+// Progress and a cancel button for a large paste streaming into the
+// terminal. Shown only while the session's `pasteProgress` is set.
+
+import SwiftUI
+
+struct TerminalPasteProgressView: View {
+    let sessionID: UUID
+    @ObservedObject var sessionManager: SessionManager
+
+    var body: some View {
+        if let progress = sessionManager.liveState(for: sessionID).pasteProgress {
+            HStack(spacing: 8) {
+                ProgressView(value: progress.fraction)
+                    .frame(width: 140)
+                Text("Pasting \(Self.byteCount(progress.sentBytes)) of \(Self.byteCount(progress.totalBytes))")
+                    .font(.caption.monospacedDigit())
+                    .foregroundStyle(.secondary)
+                Button("Cancel") {
+                    sessionManager.cancelPaste(sessionID: sessionID)
+                }
+                .controlSize(.small)
+            }
+            .padding(.horizontal, 10)
+            .padding(.vertical, 6)
+            .background(.ultraThinMaterial, in: Capsule())
+            .padding(.bottom, 8)
+        }
+    }
+
+    private static func byteCount(_ bytes: Int) -> String {
+        ByteCountFormatter.string(fromByteCount: Int64(bytes), countStyle: .file)
+    }
+}
@@ -24,7 +24,7 @@ struct TerminalScrollbarView: View {
     @State private var isDragging: Bool = false
 
     private var scrollState: TerminalScrollState {
-        sessionManager.scrollStateBySessionID[sessionID] ?? TerminalScrollState()
+        sessionManager.liveState(for: sessionID).scrollState ?? TerminalScrollState()
     }
 
     private var totalRows: Int {
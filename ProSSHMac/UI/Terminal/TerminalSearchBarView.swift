@@ -6,6 +6,7 @@ struct TerminalSearchBarView: View {
     let focusFieldNonce: Int
     var onHide: () -> Void
     var onFocusChanged: (Bool) -> Void
+    var onExpandFolded: () -> Void = {}
 
     @FocusState private var isFieldFocused: Bool
     @AppStorage(TransparencyManager.backgroundOpacityKey)
@@ -56,7 +57,7 @@ struct TerminalSearchBarView: View {
                 }
                 .buttonStyle(.bordered)
                 .controlSize(.small)
-                .disabled(terminalSearch.matches.isEmpty)
+                .disabled(!terminalSearch.hasMatches)
 
                 Button {
                     terminalSearch.selectNextMatch()
@@ -65,7 +66,21 @@ struct TerminalSearchBarView: View {
                 }
                 .buttonStyle(.bordered)
                 .controlSize(.small)
-                .disabled(terminalSearch.matches.isEmpty)
+                .disabled(!terminalSearch.hasMatches)
+            }
+
+            if terminalSearch.foldedMatchCount > 0 {
+                HStack(spacing: 8) {
+                    Text("\(terminalSearch.foldedMatchCount) more in folded output")
+                        .font(.caption)
+                        .foregroundStyle(.secondary)
+
+                    Button("Expand") {
+                        onExpandFolded()
+                    }
+                    .buttonStyle(.bordered)
+                    .controlSize(.small)
+                }
             }
 
             if let validationError = terminalSearch.validationError {
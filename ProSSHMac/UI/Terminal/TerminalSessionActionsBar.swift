@@ -8,6 +8,7 @@ struct TerminalSessionActionsBar: View {
 
     @EnvironmentObject private var sessionManager: SessionManager
     @AppStorage("terminal.renderer.useMetal") private var useMetalRenderer = true
+    @AppStorage(PerformanceHUDOverlay.enabledDefaultsKey) private var showsPerformanceHUD = false
 
     var body: some View {
         let isRecording = sessionManager.isRecordingBySessionID[session.id, default: false]
@@ -61,17 +62,41 @@ struct TerminalSessionActionsBar: View {
                         await sessionManager.playLastRecording(sessionID: session.id, speed: 4.0)
                     }
                 }
+                Button("Play at Max Speed") {
+                    Task {
+                        await sessionManager.playLastRecording(sessionID: session.id, speed: SessionRecorder.maxPlaybackSpeed)
+                    }
+                }
                 Divider()
                 Button("Export .cast") {
                     Task {
                         await sessionManager.exportLastRecordingAsCast(sessionID: session.id)
                     }
                 }
+                Button("Export .cast.gz") {
+                    Task {
+                        await sessionManager.exportLastRecordingAsCast(sessionID: session.id, gzip: true)
+                    }
+                }
             } label: {
                 Label(isPlaybackRunning ? "Playing" : "Playback", systemImage: "play.circle")
             }
             .disabled(!hasRecording || isRecording || isPlaybackRunning)
 
+            if isPlaybackRunning, let progress = sessionManager.liveState(for: session.id).playbackProgress {
+                Slider(
+                    value: Binding(
+                        get: { progress.positionSeconds },
+                        set: { sessionManager.seekPlayback(sessionID: session.id, toSeconds: $0) }
+                    ),
+                    in: 0...max(progress.durationSeconds, 1)
+                )
+                .frame(width: 200)
+                Text(Self.playbackTime(progress.positionSeconds))
+                    .font(.caption.monospacedDigit())
+                    .foregroundStyle(.secondary)
+            }
+
             Menu {
                 Button(useMetalRenderer ? "Switch to Classic" : "Switch to Metal") {
                     useMetalRenderer.toggle()
@@ -81,6 +106,9 @@ struct TerminalSessionActionsBar: View {
                 if !isMetalRendererAvailable {
                     Text("Metal unavailable on this device")
                 }
+
+                Toggle("Performance HUD", isOn: $showsPerformanceHUD)
+                    .disabled(!useMetalRenderer)
             } label: {
                 Label("Display", systemImage: useMetalRenderer ? "display.2" : "display")
             }
@@ -118,6 +146,11 @@ struct TerminalSessionActionsBar: View {
         }
     }
 
+    private static func playbackTime(_ seconds: Double) -> String {
+        let total = Int(seconds)
+        return String(format: "%d:%02d:%02d", total / 3600, (total / 60) % 60, total % 60)
+    }
+
     private var isMetalRendererAvailable: Bool {
         MTLCreateSystemDefaultDevice() != nil
     }
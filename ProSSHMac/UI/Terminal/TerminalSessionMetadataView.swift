@@ -1,5 +1,6 @@
 // Extracted from TerminalView.swift
 import SwiftUI
+import AppKit
 
 struct TerminalSessionMetadataView: View {
     let session: Session
@@ -9,7 +10,7 @@ struct TerminalSessionMetadataView: View {
 
     var body: some View {
         if session.isLocal {
-            let cwd = sessionManager.workingDirectoryBySessionID[session.id] ?? "~"
+            let cwd = sessionManager.liveState(for: session.id).workingDirectory ?? "~"
             let displayCwd = cwd.replacingOccurrences(
                 of: ProcessInfo.processInfo.environment["HOME"] ?? "/nonexistent",
                 with: "~"
@@ -72,6 +73,18 @@ struct TerminalSessionMetadataView: View {
                 Label("\(listeningCount)/\(forwards.count) forwards active", systemImage: "arrow.right.arrow.left")
                     .font(.caption)
                     .foregroundStyle(.green)
+                    .contextMenu {
+                        Button("Copy Forwarding Diagnostics") {
+                            copyToPasteboard(portForwardingManager.diagnosticsReport(for: session.id))
+                        }
+                    }
+
+                VStack(alignment: .leading, spacing: 2) {
+                    ForEach(forwards) { forward in
+                        forwardRow(forward)
+                    }
+                }
+                .padding(.leading, 4)
             }
         }
 
@@ -86,6 +99,14 @@ struct TerminalSessionMetadataView: View {
             }
         }
 
+        if session.state == .connected {
+            SessionMemoryFootprintLabel(sessionID: session.id)
+        }
+
+        if session.state == .connected, !session.isLocal, sessionManager.hostMetricsEnabled {
+            SessionHostMetricsLabel(sessionID: session.id)
+        }
+
         if session.state == .connected, !session.isLocal {
             let lastActivity = sessionManager.lastActivityBySessionID[session.id]
             TimelineView(.periodic(from: .now, by: 30)) { _ in
@@ -106,6 +127,38 @@ struct TerminalSessionMetadataView: View {
         }
     }
 
+    @ViewBuilder
+    private func forwardRow(_ forward: ActivePortForward) -> some View {
+        let stats = forward.stats
+        VStack(alignment: .leading, spacing: 1) {
+            Text(forward.rule.routeDescription)
+                .font(.caption.monospaced())
+                .foregroundStyle(.secondary)
+            Text("\u{2191} \(Self.rate(stats.rateToRemote))  \u{2193} \(Self.rate(stats.rateToLocal))  \u{00B7}  \(forward.activeConnections) open")
+                .font(.caption2.monospacedDigit())
+                .foregroundStyle(.tertiary)
+            if let latency = stats.averageOpenLatency {
+                Text("open \(Self.milliseconds(latency))  \u{00B7}  window wait \(Self.milliseconds(stats.remoteWriteWait))  \u{00B7}  local wait \(Self.milliseconds(stats.localBackpressureWait))")
+                    .font(.caption2.monospacedDigit())
+                    .foregroundStyle(.tertiary)
+            }
+        }
+        .help("\(ByteCountFormatter.string(fromByteCount: stats.bytesToRemote, countStyle: .binary)) sent, \(ByteCountFormatter.string(fromByteCount: stats.bytesToLocal, countStyle: .binary)) received over \(stats.connectionsServed) connections")
+    }
+
+    private static func rate(_ bytesPerSecond: Double) -> String {
+        ByteCountFormatter.string(fromByteCount: Int64(bytesPerSecond), countStyle: .binary) + "/s"
+    }
+
+    private static func milliseconds(_ duration: Duration) -> String {
+        "\(Int(duration / .milliseconds(1))) ms"
+    }
+
+    private func copyToPasteboard(_ text: String) {
+        NSPasteboard.general.clearContents()
+        NSPasteboard.general.setString(text, forType: .string)
+    }
+
     @ViewBuilder
     private func metadataRow(label: String, value: String) -> some View {
         HStack(alignment: .top, spacing: 6) {
@@ -120,3 +173,71 @@ struct TerminalSessionMetadataView: View {
         }
     }
 }
+
+/// Estimated memory held for a session, refreshed every few seconds. The
+/// tooltip breaks it down by subsystem.
+private struct SessionMemoryFootprintLabel: View {
+    let sessionID: UUID
+    @EnvironmentObject private var sessionManager: SessionManager
+    @State private var footprint: MemoryFootprint?
+
+    var body: some View {
+        Group {
+            if let footprint {
+                Text("Memory: \(MemoryFootprint.format(footprint.totalBytes))")
+                    .font(.caption.monospacedDigit())
+                    .foregroundStyle(.secondary)
+                    .help(footprint.summary)
+                    .contextMenu {
+                        Button("Copy Memory Diagnostics") {
+                            Task {
+                                let report = await sessionManager.memoryDiagnosticsReport(for: sessionID)
+                                NSPasteboard.general.clearContents()
+                                NSPasteboard.general.setString(report, forType: .string)
+                            }
+                        }
+                    }
+            }
+        }
+        .task(id: sessionID) {
+            while !Task.isCancelled {
+                footprint = await sessionManager.memoryFootprint(for: sessionID)
+                try? await Task.sleep(for: .seconds(5))
+            }
+        }
+    }
+}
+
+/// The host's load, memory and disk from SessionMetricsCoordinator, which
+/// keeps its exec channel open while this label is shown. The tooltip adds
+/// the OS, CPU count and uptime.
+private struct SessionHostMetricsLabel: View {
+    let sessionID: UUID
+    @EnvironmentObject private var sessionManager: SessionManager
+
+    var body: some View {
+        let samplingID = sessionManager.metricsCoordinator.samplingSessionID(for: sessionID)
+        Group {
+            if let metrics = sessionManager.liveState(for: samplingID).hostMetrics {
+                Text(metrics.summary)
+                    .font(.caption.monospacedDigit())
+                    .foregroundStyle(.secondary)
+                    .lineLimit(1)
+                    .help(Self.details(metrics))
+            } else {
+                // Keeps a view in place so onAppear fires before the first sample.
+                Text("Host: sampling…")
+                    .font(.caption)
+                    .foregroundStyle(.tertiary)
+            }
+        }
+        .onAppear { sessionManager.metricsCoordinator.retain(sessionID: sessionID) }
+        .onDisappear { sessionManager.metricsCoordinator.release(sessionID: sessionID) }
+    }
+
+    private static func details(_ metrics: RemoteHostMetrics) -> String {
+        let uptime = Duration.seconds(Int(metrics.uptimeSeconds))
+            .formatted(.units(allowed: [.days, .hours, .minutes], width: .abbreviated))
+        return "\(metrics.operatingSystem)  \u{00B7}  \(metrics.processorCount) CPUs  \u{00B7}  up \(uptime)"
+    }
+}
@@ -14,6 +14,13 @@ struct TerminalSessionTabBar: View {
     @Environment(\.colorScheme) private var colorScheme
 
     @State private var hoveredTabID: UUID?
+    /// Non-selected tab whose thumbnail is shown after a short hover.
+    @State private var previewTabID: UUID?
+    @State private var previewTask: Task<Void, Never>?
+    @State private var isShowingOverview = false
+    /// Session whose mirror access code is shown.
+    @State private var mirrorCodeSessionID: UUID?
+    @State private var mirrorErrorMessage: String?
 
     var body: some View {
         ScrollViewReader { proxy in
@@ -45,11 +52,17 @@ struct TerminalSessionTabBar: View {
                                         .foregroundStyle(.teal)
                                         .font(.caption2)
                                 }
+                                if let share = sessionManager.mirrorShares[session.id] {
+                                    Image(systemName: share.viewerCount > 0 ? "eye.fill" : "eye")
+                                        .foregroundStyle(.purple)
+                                        .font(.caption2)
+                                        .help("Mirrored read-only to \(share.viewerCount) viewer\(share.viewerCount == 1 ? "" : "s")")
+                                }
                                 VStack(alignment: .leading, spacing: 1) {
-                                    Text(sessionManager.windowTitleBySessionID[session.id] ?? tab.label)
+                                    Text(sessionManager.liveState(for: session.id).windowTitle ?? tab.label)
                                         .font(isSelected ? .caption.weight(.medium) : .caption)
                                         .lineLimit(1)
-                                    if session.isLocal, let cwd = sessionManager.workingDirectoryBySessionID[session.id] {
+                                    if session.isLocal, let cwd = sessionManager.liveState(for: session.id).workingDirectory {
                                         let homePath = ProcessInfo.processInfo.environment["HOME"] ?? ""
                                         let displayCwd = cwd.replacingOccurrences(of: homePath, with: "~")
                                         Text(displayCwd)
@@ -80,6 +93,18 @@ struct TerminalSessionTabBar: View {
                         .id(session.id)
                         .onHover { hovering in
                             hoveredTabID = hovering ? session.id : nil
+                            updatePreview(for: session.id, hovering: hovering && !isSelected)
+                        }
+                        .popover(
+                            isPresented: Binding(
+                                get: { previewTabID == session.id },
+                                set: { if !$0, previewTabID == session.id { previewTabID = nil } }
+                            ),
+                            arrowEdge: .bottom
+                        ) {
+                            SessionThumbnailView(store: sessionManager.thumbnailStore, sessionID: session.id)
+                                .frame(width: 240)
+                                .padding(8)
                         }
                         .draggable(session.id.uuidString)
                         .dropDestination(for: String.self) { items, _ in
@@ -115,6 +140,31 @@ struct TerminalSessionTabBar: View {
                                 Label("Pop Out to Window", systemImage: "rectangle.portrait.and.arrow.right")
                             }
 
+                            if sessionManager.mirrorShares[session.id] != nil {
+                                Button {
+                                    mirrorCodeSessionID = session.id
+                                } label: {
+                                    Label("Show Mirror Access Code", systemImage: "eye")
+                                }
+
+                                Button {
+                                    sessionManager.mirrorCoordinator.stopSharing(sessionID: session.id)
+                                } label: {
+                                    Label("Stop Mirroring", systemImage: "eye.slash")
+                                }
+                            } else {
+                                Button {
+                                    do {
+                                        try sessionManager.mirrorCoordinator.startSharing(sessionID: session.id)
+                                        mirrorCodeSessionID = session.id
+                                    } catch {
+                                        mirrorErrorMessage = error.localizedDescription
+                                    }
+                                } label: {
+                                    Label("Mirror Read-Only…", systemImage: "eye")
+                                }
+                            }
+
                             Button {
                                 tabManager.togglePin(sessionID: session.id)
                             } label: {
@@ -163,9 +213,61 @@ struct TerminalSessionTabBar: View {
                         )
                 }
                 .buttonStyle(.plain)
+
+                Button {
+                    isShowingOverview = true
+                } label: {
+                    Image(systemName: "square.grid.2x2")
+                        .font(.caption.weight(.semibold))
+                        .padding(.horizontal, 10)
+                        .padding(.vertical, 7)
+                        .background(
+                            (colorScheme == .dark ? Color.white.opacity(0.1) : Color.secondary.opacity(0.12)),
+                            in: Capsule()
+                        )
+                }
+                .buttonStyle(.plain)
+                .help("Show All Sessions")
                 }
                 .padding(.horizontal, 16)
             }
+            .sheet(isPresented: $isShowingOverview) {
+                SessionOverviewView(tabManager: tabManager) {
+                    isShowingOverview = false
+                }
+                .environmentObject(sessionManager)
+            }
+            .alert(
+                "Mirroring Read-Only",
+                isPresented: Binding(
+                    get: { mirrorCodeSessionID.flatMap { sessionManager.mirrorShares[$0] } != nil },
+                    set: { if !$0 { mirrorCodeSessionID = nil } }
+                ),
+                presenting: mirrorCodeSessionID.flatMap { sessionManager.mirrorShares[$0] }
+            ) { share in
+                Button("Copy Code") {
+                    NSPasteboard.general.clearContents()
+                    NSPasteboard.general.setString(share.accessCode, forType: .string)
+                }
+                Button("Stop Mirroring", role: .destructive) {
+                    sessionManager.mirrorCoordinator.stopSharing(sessionID: share.sessionID)
+                }
+                Button("OK", role: .cancel) {}
+            } message: { share in
+                let port = share.port.map { " (port \($0))" } ?? ""
+                Text("Viewers on your network choose Watch Mirrored Session… and enter \(share.accessCode) to watch \"\(share.serviceName)\"\(port). They cannot type into the session.")
+            }
+            .alert(
+                "Could Not Mirror Session",
+                isPresented: Binding(
+                    get: { mirrorErrorMessage != nil },
+                    set: { if !$0 { mirrorErrorMessage = nil } }
+                )
+            ) {
+                Button("OK", role: .cancel) {}
+            } message: {
+                Text(mirrorErrorMessage ?? "")
+            }
             .onChange(of: tabManager.selectedSessionID) { _, newID in
                 if let newID {
                     withAnimation {
@@ -176,6 +278,21 @@ struct TerminalSessionTabBar: View {
         }
     }
 
+    /// Shows `sessionID`'s thumbnail once the pointer has rested on its tab.
+    private func updatePreview(for sessionID: UUID, hovering: Bool) {
+        previewTask?.cancel()
+        previewTask = nil
+        guard hovering else {
+            if previewTabID == sessionID { previewTabID = nil }
+            return
+        }
+        previewTask = Task { @MainActor in
+            try? await Task.sleep(for: .milliseconds(600))
+            guard !Task.isCancelled, hoveredTabID == sessionID else { return }
+            previewTabID = sessionID
+        }
+    }
+
     private func tabBackground(for session: Session) -> Color {
         if tabManager.selectedSessionID == session.id {
             return colorScheme == .dark ? Color.accentColor.opacity(0.34) : Color.accentColor.opacity(0.2)
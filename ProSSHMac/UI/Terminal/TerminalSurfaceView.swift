@@ -1,4 +1,5 @@
 // Extracted from TerminalView.swift
+import AppKit
 import SwiftUI
 import Metal
 import UniformTypeIdentifiers
@@ -40,7 +41,15 @@ struct TerminalSurfaceView: View {
 
     var body: some View {
         Group {
-            if isMacOSTerminalSafetyModeEnabled {
+            if let dormantTab = sessionManager.workspaceCoordinator.dormantTab(for: session.id) {
+                TerminalDormantTabView(
+                    tab: dormantTab,
+                    fontFamily: terminalUIFontFamily,
+                    fontSize: terminalUIFontSize
+                ) {
+                    Task { await sessionManager.workspaceCoordinator.activate(sessionID: session.id) }
+                }
+            } else if isMacOSTerminalSafetyModeEnabled {
                 safeTerminalBuffer(for: session)
             } else if supportsMetalTerminalSurface {
                 metalTerminalBuffer(for: session, isFocused: isFocused, paneID: paneID)
@@ -56,12 +65,6 @@ struct TerminalSurfaceView: View {
 
     // MARK: - Private helpers
 
-    private func sendControl(_ sequence: String, sessionID: UUID) {
-        Task {
-            await sessionManager.sendRawShellInput(sessionID: sessionID, input: sequence)
-        }
-    }
-
     private var bellFeedbackMode: BellFeedbackMode {
         BellFeedbackMode(rawValue: bellFeedbackModeRawValue) ?? .none
     }
@@ -77,7 +80,7 @@ struct TerminalSurfaceView: View {
     private var isMacOSTerminalSafetyModeEnabled: Bool { false }
 
     private func inputModeSnapshot(for sessionID: UUID) -> InputModeSnapshot {
-        sessionManager.inputModeSnapshotsBySessionID[sessionID] ?? .default
+        sessionManager.liveState(for: sessionID).inputModeSnapshot ?? .default
     }
 
     private var terminalSurfaceColor: Color {
@@ -130,7 +133,7 @@ struct TerminalSurfaceView: View {
     private func safeTerminalDisplayLines(for session: Session) -> [SafeTerminalRenderedLine] {
         // stubs: directInputBufferBySessionID / shouldUseSecureInput / shouldEnableDirectTerminalInput
         // live in TerminalView; this entire function is unreachable (isMacOSTerminalSafetyModeEnabled = false)
-        let lines = sessionManager.shellBuffers[session.id] ?? []
+        let lines = sessionManager.liveState(for: session.id).shellBuffer ?? []
 
         return lines.enumerated().map { index, line in
             let stableID = "\(index)-\(line.hashValue)"
@@ -142,7 +145,7 @@ struct TerminalSurfaceView: View {
 
     @ViewBuilder
     private func metalTerminalBuffer(for session: Session, isFocused: Bool = true, paneID: UUID? = nil) -> some View {
-        let snapshotNonce = sessionManager.gridSnapshotNonceBySessionID[session.id, default: 0]
+        let snapshotNonce = sessionManager.liveState(for: session.id).gridSnapshotNonce ?? 0
 
         MetalTerminalSessionSurface(
             sessionID: session.id,
@@ -177,7 +180,33 @@ struct TerminalSurfaceView: View {
                 sessionManager.cachedScrollbackCount(for: session.id)
             },
             scrollOffsetProvider: {
-                sessionManager.scrollStateBySessionID[session.id]?.scrollOffset ?? 0
+                sessionManager.liveState(for: session.id).scrollState?.scrollOffset ?? 0
+            },
+            scrollbackRingRowsProvider: { positions in
+                await sessionManager.scrollbackRingRows(sessionID: session.id, positions: positions)
+            },
+            onScrollToRow: { row in
+                sessionManager.scrollToRow(sessionID: session.id, row: row)
+            },
+            onRenderTierChange: { tier, surfaceID in
+                sessionManager.setRenderTier(tier, for: session.id, surfaceID: surfaceID)
+            },
+            attachSnapshotFeed: { surfaceID in
+                sessionManager.attachSnapshotFeed(for: session.id, surfaceID: surfaceID)
+            },
+            detachSnapshotFeed: { surfaceID in
+                sessionManager.detachSnapshotFeed(for: session.id, surfaceID: surfaceID)
+            },
+            performanceHUDStatsProvider: {
+                sessionManager.performanceHUDStats(for: session.id)
+            },
+            onCellPixelSizeChange: { width, height in
+                Task {
+                    await sessionManager.setCellPixelSize(sessionID: session.id, width: width, height: height)
+                }
+            },
+            onThumbnail: { image in
+                sessionManager.thumbnailStore.update(image, for: session.id)
             }
         )
         .id(session.id)
@@ -200,6 +229,12 @@ struct TerminalSurfaceView: View {
                 sessionManager: sessionManager
             )
         }
+        .overlay(alignment: .bottom) {
+            TerminalPasteProgressView(
+                sessionID: session.id,
+                sessionManager: sessionManager
+            )
+        }
         .overlay {
             mouseInputOverlay(for: session, contentPadding: 0)
         }
@@ -219,7 +254,7 @@ struct TerminalSurfaceView: View {
             }
             return true
         }
-        .onChange(of: sessionManager.bellEventNonceBySessionID[session.id, default: 0]) { _, _ in
+        .onChange(of: sessionManager.liveState(for: session.id).bellEventNonce ?? 0) { _, _ in
             bellEffect.trigger(mode: bellFeedbackMode)
         }
     }
@@ -254,6 +289,14 @@ struct TerminalSurfaceView: View {
             Label("Select All", systemImage: "selection.pin.in.out")
         }
 
+        Button {
+            Task {
+                await sessionManager.copyEntireHistory(sessionID: session.id)
+            }
+        } label: {
+            Label("Copy Entire History", systemImage: "doc.on.doc")
+        }
+
         if selectionCoordinator.hasSelection(sessionID: session.id) {
             Button {
                 selectionCoordinator.clearSelection(sessionID: session.id)
@@ -262,6 +305,22 @@ struct TerminalSurfaceView: View {
             }
         }
 
+        #if DEBUG
+        Button {
+            selectionCoordinator.runRendererStress(sessionID: session.id)
+        } label: {
+            Label("Run Renderer Stress Test", systemImage: "gauge.with.dots.needle.67percent")
+        }
+        if AllocationTracker.isEnabled {
+            Button {
+                NSPasteboard.general.clearContents()
+                NSPasteboard.general.setString(AllocationTracker.report, forType: .string)
+            } label: {
+                Label("Copy Allocation Report", systemImage: "memorychip")
+            }
+        }
+        #endif
+
         let currentPaneID = paneManager.allPanes.first(where: { $0.sessionID == session.id })?.id
             ?? paneManager.focusedPaneId
         let otherSessions = tabManager.tabs
@@ -297,7 +356,7 @@ struct TerminalSurfaceView: View {
 
     @ViewBuilder
     private func terminalBuffer(for session: Session) -> some View {
-        let lines = sessionManager.shellBuffers[session.id] ?? []
+        let lines = sessionManager.liveState(for: session.id).shellBuffer ?? []
         let scrollSpaceName = "terminal-scroll-\(session.id.uuidString)"
 
         ScrollViewReader { proxy in
@@ -439,7 +498,7 @@ struct TerminalSurfaceView: View {
             .overlay {
                 mouseInputOverlay(for: session)
             }
-            .onChange(of: sessionManager.bellEventNonceBySessionID[session.id, default: 0]) { _, _ in
+            .onChange(of: sessionManager.liveState(for: session.id).bellEventNonce ?? 0) { _, _ in
                 bellEffect.trigger(mode: bellFeedbackMode)
             }
         }
@@ -449,8 +508,11 @@ struct TerminalSurfaceView: View {
 
     @ViewBuilder
     private func terminalLineView(_ line: String, lineIndex: Int) -> some View {
-        let detectedLinks = linkDetector.detectLinks(in: line)
-        let attributed = attributedTerminalLine(line, lineIndex: lineIndex)
+        // Detected in the background as rows change; a row whose pass is
+        // still running shows no links for a moment.
+        let detectedLinks = sessionManager.liveState(for: session.id).detectedLinks?
+            .links(forRow: lineIndex, text: line) ?? []
+        let attributed = attributedTerminalLine(line, lineIndex: lineIndex, links: detectedLinks)
 
         let base = Text(attributed)
             .font(.system(size: terminalUIFontSize, weight: .regular, design: .monospaced))
@@ -501,8 +563,10 @@ struct TerminalSurfaceView: View {
             locationToCell: { location in
                 terminalCellCoordinates(from: location, contentPadding: contentPadding)
             },
-            onSendSequence: { sequence in
-                sendControl(sequence, sessionID: session.id)
+            onSendBytes: { bytes in
+                Task {
+                    await sessionManager.sendRawShellInputBytes(sessionID: session.id, bytes: bytes, eventType: "mouse")
+                }
             },
             shouldRouteWheelToViewport: { deltaY in
                 shouldRouteWheelToViewport(for: session.id, deltaY: deltaY)
@@ -518,8 +582,8 @@ struct TerminalSurfaceView: View {
 
     // MARK: - Attributed line / search highlighting
 
-    private func attributedTerminalLine(_ line: String, lineIndex: Int) -> AttributedString {
-        var attributed = linkDetector.attributedLine(line)
+    private func attributedTerminalLine(_ line: String, lineIndex: Int, links: [DetectedLink]) -> AttributedString {
+        var attributed = linkDetector.attributedLine(line, links: links)
         guard terminalSearch.isPresented else { return attributed }
 
         let lineMatches = terminalSearch.matches(forLineIndex: lineIndex)
@@ -68,6 +68,26 @@ struct TerminalView: View {
         } message: { session in
             Text("Disconnect and close the active session for \(session.hostLabel)?")
         }
+        .fileImporter(
+            isPresented: Binding(
+                get: { !sessionManager.inBandUploadRequests.isEmpty },
+                set: { presented in
+                    // Cancelling calls no completion; the `rz` waiting is
+                    // told once a completion had its turn.
+                    guard !presented, let sessionID = sessionManager.inBandUploadRequests.first else { return }
+                    Task { @MainActor in
+                        guard sessionManager.inBandUploadRequests.first == sessionID else { return }
+                        sessionManager.inBandTransferCoordinator.answerUploadRequest(sessionID: sessionID, files: [])
+                    }
+                }
+            ),
+            allowedContentTypes: [.data, .item],
+            allowsMultipleSelection: true
+        ) { result in
+            guard let sessionID = sessionManager.inBandUploadRequests.first else { return }
+            let files = (try? result.get()) ?? []
+            sessionManager.inBandTransferCoordinator.answerUploadRequest(sessionID: sessionID, files: files)
+        }
         .toolbar {
             if supportsMultitaskingControls {
                 ToolbarItem(placement: newWindowToolbarPlacement) {
@@ -161,6 +181,10 @@ struct TerminalView: View {
                     if let sessionID = sid { pasteClipboardToSession(sessionID) }
                 },
                 onSelectAll:           { selectAllInFocusedTerminal() },
+                onPreviousPrompt:      { jumpToPromptInFocusedTerminal(direction: -1) },
+                onNextPrompt:          { jumpToPromptInFocusedTerminal(direction: 1) },
+                onCopyLastOutput:      { copyLastOutputInFocusedTerminal() },
+                onToggleOutputFold:    { toggleLastOutputFoldInFocusedTerminal() },
                 onToggleBroadcast:     { paneManager.toggleBroadcast() },
                 onToggleMaximize:      { navigationCoordinator.toggleTerminalMaximize() }
             )
@@ -196,6 +220,7 @@ struct TerminalView: View {
                 useMetalRenderer = isMetalRendererAvailable
                 didApplyMetalDefaultV2 = true
             }
+            applySessionReplacements()
             tabManager.sync(with: sessionManager.sessions)
             synchronizeSelection()
             updateSearchLines()
@@ -204,6 +229,7 @@ struct TerminalView: View {
         }
         .onChange(of: sessionManager.sessions) { _, _ in
             Task { @MainActor in
+                applySessionReplacements()
                 tabManager.sync(with: sessionManager.sessions)
                 synchronizeSelection()
                 updateSearchLines()
@@ -215,6 +241,17 @@ struct TerminalView: View {
             resizeEffect.reset()
             updateSearchLines()
             restoreSidebarLayoutForSelection()
+            applyTmuxLayout()
+        }
+        .onChange(of: sessionManager.tmuxLayoutsBySessionID) { _, _ in
+            applyTmuxLayout()
+        }
+        .onChange(of: searchedShellLines) { _, _ in
+            updateSearchLines()
+        }
+        .onChange(of: terminalSearch.selectedHistoryMatch) { _, match in
+            guard let match, let sessionID = tabManager.selectedSessionID else { return }
+            sessionManager.scrollToRow(sessionID: sessionID, row: terminalSearch.scrollOffset(for: match))
         }
         .onChange(of: showFileBrowser) { _, _ in
             persistSidebarLayoutForSelection()
@@ -387,7 +424,8 @@ struct TerminalView: View {
                     terminalSearch: terminalSearch,
                     focusFieldNonce: searchFocusNonce,
                     onHide: { hideSearchBar() },
-                    onFocusChanged: { v in isSearchBarFocused = v }
+                    onFocusChanged: { v in isSearchBarFocused = v },
+                    onExpandFolded: { expandFoldedOutput(sessionID: session.id) }
                 )
             }
 
@@ -597,38 +635,27 @@ struct TerminalView: View {
                 handleHardwareCommandShortcut(action)
             },
             onSendSequence: { sessionID, sequence in
-                if paneManager.inputRoutingMode != .singleFocus {
-                    // Broadcast/group: send directly to all targets, bypass per-session safety buffer
-                    for targetID in paneManager.targetSessionIDs {
-                        sendControl(sequence, sessionID: targetID)
-                    }
-                } else {
-                    handleDirectTerminalInput(sequence, sessionID: sessionID)
-                }
+                handleDirectTerminalInput(sequence, sessionID: sessionID)
             },
             onSendBytes: { sessionID, bytes, eventType in
-                if paneManager.inputRoutingMode != .singleFocus {
-                    // Broadcast/group: fan out to all targets
-                    for targetID in paneManager.targetSessionIDs {
-                        Task {
-                            await sessionManager.sendRawShellInputBytes(
-                                sessionID: targetID,
-                                bytes: bytes,
-                                source: .hardwareKeyCapture,
-                                eventType: eventType
-                            )
-                        }
-                    }
-                } else {
-                    Task {
-                        await sessionManager.sendRawShellInputBytes(
-                            sessionID: sessionID,
-                            bytes: bytes,
-                            source: .hardwareKeyCapture,
-                            eventType: eventType
-                        )
-                    }
+                Task {
+                    await sessionManager.sendRawShellInputBytes(
+                        sessionID: sessionID,
+                        bytes: bytes,
+                        source: .hardwareKeyCapture,
+                        eventType: eventType
+                    )
                 }
+            },
+            onBroadcastInput: { input in
+                guard paneManager.inputRoutingMode != .singleFocus else { return false }
+                // Broadcast/group: one concurrent fan-out to all targets,
+                // bypassing the per-session safety buffer.
+                let targets = paneManager.targetSessionIDs
+                Task {
+                    await sessionManager.broadcastShellInput(input, to: targets)
+                }
+                return true
             }
         )
     }
@@ -750,7 +777,33 @@ struct TerminalView: View {
         tabManager.select(sessionID: tab.id)
     }
 
+    /// A reconnected session takes over the pane and tab of the session it
+    /// replaced, instead of the pane closing and a new tab opening.
+    private func applySessionReplacements() {
+        for (oldID, newID) in sessionManager.takeSessionReplacements() {
+            paneManager.replaceSession(oldID, with: newID)
+            tabManager.replaceSession(oldID, with: newID)
+        }
+    }
+
+    /// A tmux control mode window shows as its panes: while the selected
+    /// tab is the control mode session or one of its panes, the split tree
+    /// follows tmux's layout, keeping focus on the same pane.
+    private func applyTmuxLayout() {
+        guard let selectedID = tabManager.selectedSessionID,
+              let layout = sessionManager.tmuxLayout(showing: selectedID),
+              layout != paneManager.rootNode else { return }
+        let focusedPaneID = paneManager.focusedPaneId
+        paneManager.applyLayout(layout)
+        if layout.findPane(id: focusedPaneID) != nil {
+            paneManager.focusPane(focusedPaneID)
+        } else if let pane = layout.allPanes.first(where: { $0.sessionID == selectedID }) {
+            paneManager.focusPane(pane.id)
+        }
+    }
+
     private func syncPaneManagerSessions() {
+        guard !sessionManager.workspaceCoordinator.isRestorePending else { return }
         let activeIDs = Set(tabManager.tabs.map(\.id))
         paneManager.syncSessions(activeSessionIDs: activeIDs)
 
@@ -870,7 +923,7 @@ struct TerminalView: View {
             return true
         }
 
-        if let lastLine = sessionManager.shellBuffers[sessionID]?.last,
+        if let lastLine = sessionManager.liveState(for: sessionID).shellBuffer?.last,
            !lastLine.isEmpty {
             _ = PlatformClipboard.writeString(lastLine)
             return true
@@ -880,10 +933,9 @@ struct TerminalView: View {
 
     private func pasteClipboardToSession(_ sessionID: UUID) {
         let bracketedPaste = inputModeSnapshot(for: sessionID).bracketedPasteMode
-        let sequences = PasteHandler.readClipboardSequences(bracketedPasteEnabled: bracketedPaste)
-        for sequence in sequences {
-            sendControl(sequence, sessionID: sessionID)
-        }
+        // Streamed at bulk priority, so keystrokes typed during a large
+        // paste go out ahead of it.
+        sessionManager.pasteClipboard(sessionID: sessionID, bracketedPasteEnabled: bracketedPaste)
     }
 
     private func selectAllInFocusedTerminal() {
@@ -892,8 +944,33 @@ struct TerminalView: View {
         selectionCoordinator.selectAll(sessionID: sessionID)
     }
 
+    private func jumpToPromptInFocusedTerminal(direction: Int) {
+        let targetSessionID = paneManager.focusedSessionID ?? focusedSessionID ?? tabManager.selectedSessionID
+        guard let sessionID = targetSessionID else { return }
+        sessionManager.jumpToPrompt(sessionID: sessionID, direction: direction)
+    }
+
+    private func copyLastOutputInFocusedTerminal() {
+        let targetSessionID = paneManager.focusedSessionID ?? focusedSessionID ?? tabManager.selectedSessionID
+        guard let sessionID = targetSessionID else { return }
+        Task { await sessionManager.copyLastCommandOutput(sessionID: sessionID) }
+    }
+
+    private func toggleLastOutputFoldInFocusedTerminal() {
+        let targetSessionID = paneManager.focusedSessionID ?? focusedSessionID ?? tabManager.selectedSessionID
+        guard let sessionID = targetSessionID else { return }
+        Task { await sessionManager.toggleLastCommandOutputFold(sessionID: sessionID) }
+    }
+
+    private func expandFoldedOutput(sessionID: UUID) {
+        Task {
+            await sessionManager.expandFoldedCommandOutput(sessionID: sessionID)
+            terminalSearch.refreshFoldedMatches()
+        }
+    }
+
     private func inputModeSnapshot(for sessionID: UUID) -> InputModeSnapshot {
-        sessionManager.inputModeSnapshotsBySessionID[sessionID] ?? .default
+        sessionManager.liveState(for: sessionID).inputModeSnapshot ?? .default
     }
 
     private func hardwareKeyEncoderOptions() -> KeyEncoderOptions {
@@ -953,7 +1030,7 @@ struct TerminalView: View {
     }
 
     private func detectsPasswordPrompt(for session: Session) -> Bool {
-        let lines = sessionManager.shellBuffers[session.id] ?? []
+        let lines = sessionManager.liveState(for: session.id).shellBuffer ?? []
         guard let lastLine = lines.last?.trimmingCharacters(in: .whitespaces).lowercased(),
               !lastLine.isEmpty else { return false }
         let patterns = ["password:", "password for", "passphrase:", "passphrase for", "enter pin"]
@@ -982,9 +1059,12 @@ struct TerminalView: View {
             let targetSessionID = focusedSessionID ?? tabManager.selectedSessionID
             guard let sessionID = targetSessionID else { return }
             sendControl(sequence, sessionID: sessionID)
+        } else if targets.count == 1 {
+            sendControl(sequence, sessionID: targets[0])
         } else {
-            for sessionID in targets {
-                sendControl(sequence, sessionID: sessionID)
+            let input = BroadcastKeyInput(bytes: Array(sequence.utf8), eventType: "string_payload")
+            Task {
+                await sessionManager.broadcastShellInput(input, to: targets, source: .stringBridge)
             }
         }
     }
@@ -1005,12 +1085,27 @@ struct TerminalView: View {
         terminalSearch.dismiss()
     }
 
+    /// Screen lines of the selected session while the search bar is open,
+    /// so new output refreshes matches (and picks up new scrollback).
+    private var searchedShellLines: [String] {
+        guard terminalSearch.isPresented, let selectedSessionID = tabManager.selectedSessionID else { return [] }
+        return sessionManager.liveState(for: selectedSessionID).shellBuffer ?? []
+    }
+
     private func updateSearchLines() {
         guard let selectedSessionID = tabManager.selectedSessionID else {
+            terminalSearch.attachFoldedOutput(source: nil)
+            terminalSearch.attachHistory(sessionID: nil) { nil }
             terminalSearch.updateLines([])
             return
         }
-        terminalSearch.updateLines(sessionManager.shellBuffers[selectedSessionID] ?? [])
+        terminalSearch.attachFoldedOutput { [sessionManager] query in
+            await sessionManager.foldedOutputMatchCount(sessionID: selectedSessionID, query: query)
+        }
+        terminalSearch.attachHistory(sessionID: selectedSessionID) { [sessionManager] in
+            await sessionManager.searchableScrollback(sessionID: selectedSessionID)
+        }
+        terminalSearch.updateLines(sessionManager.liveState(for: selectedSessionID).shellBuffer ?? [])
     }
 
     private func synchronizeSelection() {
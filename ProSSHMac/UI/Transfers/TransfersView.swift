@@ -99,7 +99,7 @@ struct TransfersView: View {
         }
         .fileImporter(
             isPresented: $showFileImporter,
-            allowedContentTypes: [.data, .item],
+            allowedContentTypes: [.data, .item, .folder],
             allowsMultipleSelection: false
         ) { result in
             switch result {
@@ -154,6 +154,13 @@ struct TransfersView: View {
         }
         .buttonStyle(.plain)
         .contentShape(Rectangle())
+        .contextMenu {
+            if entry.isDirectory {
+                Button("Download Folder") {
+                    transferManager.enqueueDownload(entry: entry)
+                }
+            }
+        }
     }
 
     @ViewBuilder
@@ -178,7 +185,9 @@ struct TransfersView: View {
                 .foregroundStyle(.secondary)
                 .lineLimit(2)
 
-            if transfer.totalBytes > 0 {
+            if let live = transferManager.liveProgress(for: transfer.id) {
+                TransferLiveProgressView(progress: live)
+            } else if transfer.totalBytes > 0 {
                 ProgressView(value: Double(transfer.bytesTransferred), total: Double(transfer.totalBytes))
                 Text("\(byteCount(transfer.bytesTransferred)) / \(byteCount(transfer.totalBytes))")
                     .font(.caption2)
@@ -271,3 +280,51 @@ struct TransfersView: View {
         transfer.state == .completed || transfer.state == .failed || transfer.state == .cancelled
     }
 }
+
+/// The progress of a running transfer. It reads its own observable object,
+/// so sampling re-renders this line and nothing else in the list.
+private struct TransferLiveProgressView: View {
+    let progress: TransferLiveProgress
+
+    var body: some View {
+        if progress.totalBytes > 0 {
+            ProgressView(
+                value: Double(min(progress.bytesTransferred, progress.totalBytes)),
+                total: Double(progress.totalBytes)
+            )
+        } else {
+            ProgressView()
+                .progressViewStyle(.linear)
+        }
+        Text(summary)
+            .font(.caption2)
+            .foregroundStyle(.secondary)
+            .monospacedDigit()
+    }
+
+    private var summary: String {
+        var parts = [byteCount(progress.bytesTransferred)]
+        if progress.totalBytes > 0 {
+            parts[0] += " / " + byteCount(progress.totalBytes)
+        }
+        if let rate = progress.bytesPerSecond, rate > 0 {
+            parts.append(byteCount(Int64(rate)) + "/s")
+        }
+        if let remaining = progress.secondsRemaining {
+            parts.append(Self.remainingFormatter.string(from: remaining).map { "\($0) left" } ?? "")
+        }
+        return parts.filter { !$0.isEmpty }.joined(separator: " · ")
+    }
+
+    private func byteCount(_ value: Int64) -> String {
+        ByteCountFormatter.string(fromByteCount: value, countStyle: .file)
+    }
+
+    private static let remainingFormatter: DateComponentsFormatter = {
+        let formatter = DateComponentsFormatter()
+        formatter.allowedUnits = [.hour, .minute, .second]
+        formatter.unitsStyle = .abbreviated
+        formatter.maximumUnitCount = 2
+        return formatter
+    }()
+}
@@ -212,20 +212,15 @@ struct HostCertificateDraft: Equatable {
 struct KRLGenerationDraft: Equatable {
     var authorityID: UUID?
     var revokedSerials = ""
+    var revokedKeyIDs = ""
     var includeExpiredCertificates = true
+    /// Existing binary KRL to append to instead of writing a new one.
+    var baseKRL: Data?
+    var baseKRLName: String?
 
     func toRequest() throws -> KRLGenerationRequest {
-        let normalized = revokedSerials.trimmingCharacters(in: .whitespacesAndNewlines)
-        if normalized.isEmpty {
-            return KRLGenerationRequest(
-                authorityID: authorityID,
-                revokedSerials: [],
-                includeExpiredCertificates: includeExpiredCertificates
-            )
-        }
-
         var parsedSerials: [UInt64] = []
-        let tokens = normalized
+        let tokens = revokedSerials
             .split(whereSeparator: { $0 == "," || $0 == "\n" || $0 == "\r" || $0 == "\t" || $0 == " " })
             .map(String.init)
 
@@ -238,26 +233,99 @@ struct KRLGenerationDraft: Equatable {
             parsedSerials.append(serial)
         }
 
+        let parsedKeyIDs = revokedKeyIDs
+            .split(whereSeparator: { $0 == "\n" || $0 == "\r" })
+            .map { $0.trimmingCharacters(in: .whitespaces) }
+            .filter { !$0.isEmpty }
+
         return KRLGenerationRequest(
             authorityID: authorityID,
             revokedSerials: parsedSerials,
-            includeExpiredCertificates: includeExpiredCertificates
+            revokedKeyIDs: parsedKeyIDs,
+            includeExpiredCertificates: includeExpiredCertificates,
+            baseKRL: baseKRL
+        )
+    }
+}
+
+struct BatchCertificateIssuanceDraft: Equatable {
+    var authorityID: UUID?
+    var role: CertificateRole = .host
+    /// One `key_id,principals,public_key` row per certificate; principals
+    /// are separated by `;`.
+    var inventoryCSV = ""
+    var validAfter = Date()
+    var validBefore = Date().addingTimeInterval(30 * 86_400)
+
+    func toRequest() throws -> BatchCertificateIssuanceRequest {
+        guard let authorityID else {
+            throw CertificateAuthorityError.signingFailed(message: "Please select a certificate authority.")
+        }
+        if validBefore <= validAfter {
+            throw CertificateAuthorityError.signingFailed(message: "Certificate validity end must be after start.")
+        }
+        return BatchCertificateIssuanceRequest(
+            authorityID: authorityID,
+            role: role,
+            subjects: try Self.parseInventory(inventoryCSV),
+            validAfter: validAfter,
+            validBefore: validBefore
         )
     }
+
+    /// Parse inventory rows. Blank lines, `#` comments and a leading
+    /// `key_id,...` header are skipped. The public key is everything after
+    /// the second comma, so its comment may contain commas.
+    static func parseInventory(_ csv: String) throws -> [BatchCertificateSubject] {
+        var subjects: [BatchCertificateSubject] = []
+        for (offset, rawLine) in csv.split(separator: "\n", omittingEmptySubsequences: false).enumerated() {
+            let line = rawLine.trimmingCharacters(in: .whitespacesAndNewlines)
+            if line.isEmpty || line.hasPrefix("#") {
+                continue
+            }
+            let fields = line.split(separator: ",", maxSplits: 2, omittingEmptySubsequences: false)
+                .map { $0.trimmingCharacters(in: .whitespaces) }
+            if subjects.isEmpty, fields.first?.lowercased() == "key_id" {
+                continue
+            }
+            guard fields.count == 3, !fields[0].isEmpty, !fields[2].isEmpty else {
+                throw CertificateAuthorityError.signingFailed(
+                    message: "Inventory line \(offset + 1): expected key_id,principals,public_key."
+                )
+            }
+            subjects.append(BatchCertificateSubject(
+                keyID: fields[0],
+                principals: fields[1]
+                    .split(separator: ";")
+                    .map { $0.trimmingCharacters(in: .whitespaces) }
+                    .filter { !$0.isEmpty },
+                subjectPublicKeyAuthorized: fields[2]
+            ))
+        }
+        if subjects.isEmpty {
+            throw CertificateAuthorityError.signingFailed(message: "The inventory has no certificates to issue.")
+        }
+        return subjects
+    }
 }
 
 @MainActor
 final class CertificatesViewModel: ObservableObject {
     @Published private(set) var authorities: [CertificateAuthorityModel] = []
-    @Published private(set) var certificates: [SSHCertificate] = []
+    @Published private(set) var certificates: [SSHCertificate] = [] {
+        didSet { revocationIndex = nil }
+    }
     @Published var isLoading = false
     @Published var isGeneratingAuthority = false
     @Published var isSigningCertificate = false
     @Published var isImportingCertificate = false
     @Published var isGeneratingKRL = false
+    @Published var isIssuingBatch = false
     @Published var errorMessage: String?
 
     private let service: CertificateAuthorityService
+    /// Built on the first KRL generation after `certificates` changes.
+    private var revocationIndex: CertificateRevocationIndex?
     private var hasLoaded = false
 
     init(service: CertificateAuthorityService) {
@@ -382,6 +450,62 @@ final class CertificatesViewModel: ObservableObject {
         }
     }
 
+    func issueCertificates(from draft: BatchCertificateIssuanceDraft) async -> BatchCertificateIssuanceResult? {
+        let request: BatchCertificateIssuanceRequest
+        do {
+            request = try draft.toRequest()
+        } catch {
+            errorMessage = error.localizedDescription
+            return nil
+        }
+
+        isIssuingBatch = true
+        defer { isIssuingBatch = false }
+
+        do {
+            let result = try await service.issueCertificates(
+                request: request,
+                existingAuthorities: authorities,
+                existingCertificates: certificates
+            )
+            authorities = result.authorities
+            certificates = result.certificates
+            return result
+        } catch {
+            errorMessage = error.localizedDescription
+            return nil
+        }
+    }
+
+    func exportIssuedCertificates(
+        _ result: BatchCertificateIssuanceResult,
+        to directory: URL,
+        asArchive: Bool
+    ) -> URL? {
+        let hasAccess = directory.startAccessingSecurityScopedResource()
+        defer {
+            if hasAccess {
+                directory.stopAccessingSecurityScopedResource()
+            }
+        }
+
+        let authorityLabel = result.issued.first.flatMap { issued in
+            authorities.first { $0.publicKeyFingerprint == issued.signingCAFingerprint }?.label
+        } ?? "ca"
+        let timestamp = Int(Date().timeIntervalSince1970)
+        do {
+            return try service.exportIssuedCertificates(
+                result.issued,
+                to: directory,
+                name: "prossh-certs-\(service.sanitizeFileComponent(authorityLabel))-\(timestamp)",
+                asArchive: asArchive
+            )
+        } catch {
+            errorMessage = error.localizedDescription
+            return nil
+        }
+    }
+
     func generateKRL(from draft: KRLGenerationDraft) -> GeneratedKRLBundle? {
         let request: KRLGenerationRequest
         do {
@@ -395,10 +519,12 @@ final class CertificatesViewModel: ObservableObject {
         defer { isGeneratingKRL = false }
 
         do {
+            let index = revocationIndex ?? CertificateRevocationIndex(certificates: certificates)
+            revocationIndex = index
             return try service.generateKRL(
                 request: request,
                 authorities: authorities,
-                certificates: certificates
+                index: index
             )
         } catch {
             errorMessage = error.localizedDescription
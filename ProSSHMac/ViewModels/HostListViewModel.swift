@@ -75,28 +75,55 @@ struct PendingSavePassphrasePrompt: Identifiable, Equatable {
 
 @MainActor
 final class HostListViewModel: ObservableObject {
-    @Published private(set) var hosts: [Host] = []
+    @Published private(set) var hosts: [Host] = [] {
+        didSet { hostsDidChange() }
+    }
+    /// Filter for the Hosts list; see `HostListSearchIndex.matchingIDs(_:)`
+    /// for the syntax.
+    @Published var searchQuery: String = "" {
+        didSet {
+            if searchQuery != oldValue { refreshHostGroups() }
+        }
+    }
+    /// The hosts matching `searchQuery`, by folder. Computed in the
+    /// background, so it can trail `hosts` briefly.
+    @Published private(set) var hostGroups: [HostListGroup] = []
     @Published var isLoading: Bool = false
     @Published var errorMessage: String?
     @Published var pendingHostVerification: PendingHostVerification?
     @Published var pendingLegacyAdvisory: PendingLegacyAdvisory?
     @Published var pendingSavePasswordPrompt: PendingSavePasswordPrompt?
     @Published var pendingSavePassphrasePrompt: PendingSavePassphrasePrompt?
+    /// Set while an SSH config file is being read for import.
+    @Published private(set) var sshConfigImportProgress: SSHConfigParseProgress?
 
     private let hostStore: any HostStoreProtocol
     private let sessionManager: SessionManager
     private let auditLogManager: AuditLogManager?
     private let searchIndexer: (any HostSearchIndexing)?
+    private let hostListCache: HostListCache?
     private let biometricPasswordStore: (any BiometricPasswordStoring)?
     private let biometricPassphraseStore: (any BiometricPasswordStoring)?
     let totpStore: TOTPStore?
     private var hasLoaded = false
+    /// The store read that follows showing the cached list. Saves wait for
+    /// it, so an edit made to a stale cached list never overwrites the store.
+    private var storeLoad: Task<Void, Never>?
+    /// Set by a store load; the Spotlight reindex it implies waits for
+    /// `reindexForSearchIfNeeded()` so it stays off the launch path.
+    private var needsSearchReindex = false
+    private var searchIndex = HostListSearchIndex()
+    private var hostOrder: [UUID] = []
+    private var hostPositions: [UUID: Int] = [:]
+    private var hostGroupsTask: Task<Void, Never>?
+    private var hostGroupsGeneration = 0
 
     init(
         hostStore: any HostStoreProtocol,
         sessionManager: SessionManager,
         auditLogManager: AuditLogManager? = nil,
         searchIndexer: (any HostSearchIndexing)? = nil,
+        hostListCache: HostListCache? = nil,
         biometricPasswordStore: (any BiometricPasswordStoring)? = nil,
         biometricPassphraseStore: (any BiometricPasswordStoring)? = nil,
         totpStore: TOTPStore? = nil
@@ -105,6 +132,7 @@ final class HostListViewModel: ObservableObject {
         self.sessionManager = sessionManager
         self.auditLogManager = auditLogManager
         self.searchIndexer = searchIndexer
+        self.hostListCache = hostListCache
         self.biometricPasswordStore = biometricPasswordStore
         self.biometricPassphraseStore = biometricPassphraseStore
         self.totpStore = totpStore
@@ -112,6 +140,10 @@ final class HostListViewModel: ObservableObject {
 
     func loadHostsIfNeeded() async {
         guard !hasLoaded else { return }
+        if let storeLoad {
+            await storeLoad.value
+            return
+        }
         await loadHosts()
     }
 
@@ -119,10 +151,33 @@ final class HostListViewModel: ObservableObject {
         isLoading = true
         defer { isLoading = false }
 
+        // Show the cached, already sorted list while the store is read.
+        var cached: [Host]?
+        if !hasLoaded, hosts.isEmpty, let snapshot = await hostListCache?.load(), hosts.isEmpty {
+            hosts = snapshot
+            cached = snapshot
+            isLoading = false
+        }
+
+        let load = Task { await self.loadFromStore(replacing: cached) }
+        storeLoad = load
+        await load.value
+        if storeLoad == load {
+            storeLoad = nil
+        }
+    }
+
+    /// Read the store and replace the list unless it matches the cached one
+    /// shown meanwhile; edits to a matching list are kept.
+    private func loadFromStore(replacing cached: [Host]?) async {
         do {
-            hosts = try await hostStore.loadHosts().sorted(by: Self.sortHosts)
+            let loaded = try await hostStore.loadHosts().sorted(by: Self.sortHosts)
             hasLoaded = true
-            await reindexHostsForSearch()
+            if loaded != cached {
+                hosts = loaded
+                hostListCache?.save(loaded)
+            }
+            needsSearchReindex = true
         } catch {
             errorMessage = "Failed to load hosts: \(error.localizedDescription)"
         }
@@ -161,7 +216,10 @@ final class HostListViewModel: ObservableObject {
     }
 
     func deleteHosts(with offsets: IndexSet, in visibleHosts: [Host]) async {
-        let idsToDelete = offsets.map { visibleHosts[$0].id }
+        await deleteHosts(ids: offsets.map { visibleHosts[$0].id })
+    }
+
+    func deleteHosts(ids idsToDelete: [UUID]) async {
         for id in idsToDelete {
             if let host = hosts.first(where: { $0.id == id }) {
                 cleanupKeychainForHost(host)
@@ -171,6 +229,17 @@ final class HostListViewModel: ObservableObject {
         await persist()
     }
 
+    /// Switch hosts to public-key auth with the given key, after a rotation.
+    func assignKeys(_ keyIDsByHost: [UUID: UUID]) async {
+        guard !keyIDsByHost.isEmpty else { return }
+        for index in hosts.indices {
+            guard let keyID = keyIDsByHost[hosts[index].id] else { continue }
+            hosts[index].keyReference = keyID
+            hosts[index].authMethod = .publicKey
+        }
+        await persist()
+    }
+
     func deleteHost(id: UUID) async {
         if let host = hosts.first(where: { $0.id == id }) {
             cleanupKeychainForHost(host)
@@ -351,7 +420,7 @@ final class HostListViewModel: ObservableObject {
     }
 
     func host(withID id: UUID) -> Host? {
-        hosts.first(where: { $0.id == id })
+        hostPositions[id].map { hosts[$0] }
     }
 
     func host(matchingShortcutQuery query: String) -> Host? {
@@ -466,6 +535,32 @@ final class HostListViewModel: ObservableObject {
         )
     }
 
+    /// Read an SSH config file and its includes in the background.
+    func previewSSHConfigImport(
+        fileAt url: URL = SSHConfigImportService.defaultConfigURL
+    ) async -> SSHConfigImportService.ImportPreview? {
+        sshConfigImportProgress = SSHConfigParseProgress()
+        defer { sshConfigImportProgress = nil }
+
+        do {
+            return try await SSHConfigImportService().preview(
+                configFileAt: url,
+                existingHosts: hosts,
+                existingKeys: []
+            ) { progress in
+                Task { @MainActor [weak self] in
+                    guard let self, self.sshConfigImportProgress != nil else { return }
+                    self.sshConfigImportProgress = progress
+                }
+            }
+        } catch is CancellationError {
+            return nil
+        } catch {
+            errorMessage = "Failed to read SSH config: \(error.localizedDescription)"
+            return nil
+        }
+    }
+
     func importSSHConfig(_ selectedHosts: [Host]) async -> Int {
         guard !selectedHosts.isEmpty else { return 0 }
         hosts.append(contentsOf: selectedHosts)
@@ -492,18 +587,67 @@ final class HostListViewModel: ObservableObject {
     }
 
     private func persist() async {
+        if let storeLoad {
+            await storeLoad.value
+        }
         do {
             try await hostStore.saveHosts(hosts)
+            hostListCache?.save(hosts)
             await reindexHostsForSearch()
         } catch {
             errorMessage = "Failed to save hosts: \(error.localizedDescription)"
         }
     }
 
+    /// Reindex Spotlight after a store load, once.
+    func reindexForSearchIfNeeded() async {
+        guard needsSearchReindex else { return }
+        needsSearchReindex = false
+        await reindexHostsForSearch()
+    }
+
     private func reindexHostsForSearch() async {
+        needsSearchReindex = false
         await searchIndexer?.reindex(hosts: hosts)
     }
 
+    // MARK: - Search
+
+    /// Re-index hosts whose searchable fields changed and refilter if the
+    /// index or the order moved.
+    private func hostsDidChange() {
+        let order = hosts.map(\.id)
+        hostPositions = Dictionary(
+            order.enumerated().map { ($1, $0) },
+            uniquingKeysWith: { first, _ in first }
+        )
+        let changed = searchIndex.update(hosts.map { HostSearchDocument($0) })
+        guard changed > 0 || order != hostOrder else { return }
+        hostOrder = order
+        refreshHostGroups()
+    }
+
+    /// Filter on a background task. A newer query or host change cancels
+    /// the one in flight.
+    private func refreshHostGroups() {
+        hostGroupsTask?.cancel()
+        hostGroupsGeneration += 1
+        let generation = hostGroupsGeneration
+        let index = searchIndex
+        let order = hostOrder
+        let query = searchQuery
+        hostGroupsTask = Task.detached(priority: .userInitiated) { [weak self] in
+            guard let groups = try? index.groups(order: order, query: query) else { return }
+            await self?.applyHostGroups(groups, generation: generation)
+        }
+    }
+
+    private func applyHostGroups(_ groups: [HostListGroup], generation: Int) {
+        guard generation == hostGroupsGeneration else { return }
+        hostGroups = groups
+        hostGroupsTask = nil
+    }
+
     private static func sortHosts(lhs: Host, rhs: Host) -> Bool {
         let leftFolder = lhs.folder?.trimmingCharacters(in: .whitespacesAndNewlines) ?? ""
         let rightFolder = rhs.folder?.trimmingCharacters(in: .whitespacesAndNewlines) ?? ""
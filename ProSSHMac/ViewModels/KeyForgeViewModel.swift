@@ -90,6 +90,8 @@ final class KeyForgeViewModel: ObservableObject {
     @Published var isImporting = false
     @Published var isConverting = false
     @Published var isCopyingPublicKey = false
+    /// Set while a batch copy or rotation runs.
+    @Published private(set) var batchProgress: KeyForgeBatchProgress?
     @Published var errorMessage: String?
 
     private let keyStore: any KeyStoreProtocol
@@ -131,7 +133,7 @@ final class KeyForgeViewModel: ObservableObject {
         defer { isGenerating = false }
 
         do {
-            let generated = try keyForgeService.generateKey(request: draft.toRequest())
+            let generated = try await keyForgeService.generateKey(request: draft.toRequest())
             keys.insert(generated, at: 0)
             keys.sort(by: Self.sortKeys)
             try await keyStore.saveKeys(keys)
@@ -172,7 +174,7 @@ final class KeyForgeViewModel: ObservableObject {
         defer { isImporting = false }
 
         do {
-            let imported = try keyForgeService.importKey(
+            let imported = try await keyForgeService.importKey(
                 request: KeyImportRequest(
                     label: label.trimmingCharacters(in: .whitespacesAndNewlines).isEmpty ? nil : label,
                     keyText: normalizedText,
@@ -297,7 +299,7 @@ final class KeyForgeViewModel: ObservableObject {
         defer { isConverting = false }
 
         do {
-            let conversion = try keyForgeService.convertPrivateKey(
+            let conversion = try await keyForgeService.convertPrivateKey(
                 request: KeyConversionRequest(
                     privateKeyText: existing.privateKey,
                     targetFormat: targetFormat,
@@ -360,7 +362,7 @@ final class KeyForgeViewModel: ObservableObject {
         defer { isCopyingPublicKey = false }
 
         do {
-            try keyForgeService.copyPublicKeyToHost(
+            try await keyForgeService.copyPublicKeyToHost(
                 host: host,
                 storedKey: storedKey,
                 hostPassword: normalizedHostPassword,
@@ -373,6 +375,131 @@ final class KeyForgeViewModel: ObservableObject {
         }
     }
 
+    /// Install a key on several hosts in parallel. Returns the IDs of the
+    /// hosts it was installed and verified on; failures are summarised in
+    /// `errorMessage`.
+    func copyPublicKeyToHosts(
+        keyID: UUID,
+        hosts: [Host],
+        hostPassword: String,
+        privateKeyPassphrase: String?
+    ) async -> Set<UUID> {
+        guard let storedKey = keys.first(where: { $0.id == keyID }) else {
+            errorMessage = "Unable to find selected key."
+            return []
+        }
+        if storedKey.metadata.storageLocation == .secureEnclave {
+            errorMessage = "ssh-copy-id verification is not supported for Secure Enclave keys yet."
+            return []
+        }
+        let normalizedHostPassword = hostPassword.trimmingCharacters(in: .whitespacesAndNewlines)
+        if normalizedHostPassword.isEmpty {
+            errorMessage = "Host password is required for ssh-copy-id."
+            return []
+        }
+        let normalizedPrivateKeyPassphrase = privateKeyPassphrase?
+            .trimmingCharacters(in: .whitespacesAndNewlines)
+
+        isCopyingPublicKey = true
+        batchProgress = KeyForgeBatchProgress(total: hosts.count)
+        defer {
+            isCopyingPublicKey = false
+            batchProgress = nil
+        }
+
+        let results = await keyForgeService.copyPublicKey(
+            storedKey,
+            toHosts: hosts,
+            hostPassword: normalizedHostPassword,
+            privateKeyPassphrase: normalizedPrivateKeyPassphrase
+        ) { [weak self] progress in
+            self?.batchProgress = progress
+        }
+
+        var installed = Set<UUID>()
+        var failures: [(host: Host, error: Error)] = []
+        for (host, result) in zip(hosts, results) {
+            switch result {
+            case .success:
+                installed.insert(host.id)
+            case let .failure(error):
+                failures.append((host, error))
+            }
+        }
+        reportBatchFailures(failures, action: "ssh-copy-id")
+        return installed
+    }
+
+    /// Give each host a new key generated from `draft`, installed and
+    /// verified with ssh-copy-id. New keys are saved; returns the new key ID
+    /// for each host that was rotated.
+    func rotateKeys(
+        for hosts: [Host],
+        from draft: KeyGenerationDraft,
+        hostPassword: String
+    ) async -> [UUID: UUID] {
+        if let validationError = draft.validationError {
+            errorMessage = validationError
+            return [:]
+        }
+        if draft.storeInSecureEnclave {
+            errorMessage = "ssh-copy-id verification is not supported for Secure Enclave keys yet."
+            return [:]
+        }
+        let normalizedHostPassword = hostPassword.trimmingCharacters(in: .whitespacesAndNewlines)
+        if normalizedHostPassword.isEmpty {
+            errorMessage = "Host password is required for ssh-copy-id."
+            return [:]
+        }
+
+        isGenerating = true
+        batchProgress = KeyForgeBatchProgress(total: hosts.count)
+        defer {
+            isGenerating = false
+            batchProgress = nil
+        }
+
+        let results = await keyForgeService.rotateKeys(
+            for: hosts,
+            template: draft.toRequest(),
+            hostPassword: normalizedHostPassword
+        ) { [weak self] progress in
+            self?.batchProgress = progress
+        }
+
+        var rotated: [UUID: UUID] = [:]
+        var failures: [(host: Host, error: Error)] = []
+        for (host, result) in zip(hosts, results) {
+            switch result {
+            case let .success(key):
+                keys.append(key)
+                rotated[host.id] = key.id
+            case let .failure(error):
+                failures.append((host, error))
+            }
+        }
+        if !rotated.isEmpty {
+            keys.sort(by: Self.sortKeys)
+            do {
+                try await keyStore.saveKeys(keys)
+            } catch {
+                errorMessage = "Failed to save rotated keys: \(error.localizedDescription)"
+                return [:]
+            }
+        }
+        reportBatchFailures(failures, action: "Key rotation")
+        return rotated
+    }
+
+    private func reportBatchFailures(_ failures: [(host: Host, error: Error)], action: String) {
+        let failed = failures.filter { !($0.error is CancellationError) }
+        guard !failed.isEmpty else { return }
+        let listed = failed.prefix(5).map { "\($0.host.label): \($0.error.localizedDescription)" }
+        let more = failed.count > listed.count ? "\n…and \(failed.count - listed.count) more" : ""
+        errorMessage = "\(action) failed on \(failed.count) host\(failed.count == 1 ? "" : "s"):\n"
+            + listed.joined(separator: "\n") + more
+    }
+
     func updatePreferredCopyIDHost(keyID: UUID, hostID: UUID?) async {
         guard let index = keys.firstIndex(where: { $0.id == keyID }) else { return }
         keys[index].metadata.preferredCopyIDHostID = hostID
@@ -461,6 +461,255 @@ final class AIAgentServiceTests: XCTestCase {
         XCTAssertFalse(toolOutput.contains("local sessions only"))
     }
 
+    func testSearchFilesystemToolUsesExecChannelWhenAvailable() async throws {
+        let sessionProvider = MockAgentSessionProvider(isLocal: false)
+        sessionProvider.supportsOutOfBandExecution = true
+        sessionProvider.simulatedRemoteFilesystemLines = [
+            "f    /home/kevin/notes.md",
+        ]
+
+        let responses = MockOpenAIResponsesService()
+        responses.enqueueResponse(
+            makeFunctionCallResponse(
+                id: "resp_1",
+                callID: "call_fs",
+                toolName: "search_filesystem",
+                arguments: #"{"path":"/home/kevin","name_pattern":"notes","max_results":20}"#
+            )
+        )
+        responses.enqueueResponse(
+            makeTextResponse(id: "resp_2", text: "Found.")
+        )
+
+        let service = OpenAIAgentService(
+            responsesService: responses,
+            sessionProvider: sessionProvider
+        )
+
+        _ = try await service.generateReply(
+            sessionID: sessionProvider.sessionID,
+            prompt: "find notes"
+        )
+
+        XCTAssertEqual(sessionProvider.outOfBandCommands.count, 1)
+        XCTAssertFalse(sessionProvider.sentCommands.contains { $0.contains("__PROSSH_AI_TOOL_EXIT_") })
+        let toolOutput = responses.capturedRequests[1].toolOutputs.first?.output ?? ""
+        let normalizedOutput = toolOutput.replacingOccurrences(of: #"\/"#, with: "/")
+        XCTAssertTrue(toolOutput.contains(#""ok":true"#))
+        XCTAssertTrue(normalizedOutput.contains("/home/kevin/notes.md"))
+    }
+
+    func testRemoteReadFileChunkPagesFromCachedByteOffset() async throws {
+        let sessionProvider = MockAgentSessionProvider(isLocal: false)
+        sessionProvider.supportsOutOfBandExecution = true
+        sessionProvider.simulatedOutOfBandOutputQueue = [
+            "__PROSSH_RANGE__\nalpha\n  beta\n__PROSSH_RANGE__:2:13:1:0",
+            "__PROSSH_RANGE__\n\ngamma\n__PROSSH_RANGE__:2:8:0:0",
+        ]
+
+        let responses = MockOpenAIResponsesService()
+        responses.enqueueResponse(
+            makeFunctionCallResponse(
+                id: "resp_1",
+                callID: "call_read_1",
+                toolName: "read_file_chunk",
+                arguments: #"{"path":"/var/log/app.log","start_line":1,"line_count":2}"#
+            )
+        )
+        responses.enqueueResponse(
+            makeFunctionCallResponse(
+                id: "resp_2",
+                callID: "call_read_2",
+                toolName: "read_file_chunk",
+                arguments: #"{"path":"/var/log/app.log","start_line":3,"line_count":2}"#
+            )
+        )
+        responses.enqueueResponse(
+            makeTextResponse(id: "resp_3", text: "Read.")
+        )
+
+        let service = OpenAIAgentService(
+            responsesService: responses,
+            sessionProvider: sessionProvider
+        )
+
+        _ = try await service.generateReply(
+            sessionID: sessionProvider.sessionID,
+            prompt: "read the log"
+        )
+
+        XCTAssertEqual(sessionProvider.outOfBandCommands.count, 2)
+        XCTAssertFalse(sessionProvider.outOfBandCommands[0].contains("tail -c"))
+        XCTAssertTrue(sessionProvider.outOfBandCommands[1].contains("tail -c +13 "))
+        XCTAssertFalse(sessionProvider.sentCommands.contains { $0.contains("base64") })
+
+        let firstOutput = responses.capturedRequests[1].toolOutputs.first?.output ?? ""
+        XCTAssertTrue(firstOutput.contains(#""has_more":true"#))
+        XCTAssertTrue(firstOutput.contains(#""next_start_line":3"#))
+        XCTAssertTrue(firstOutput.contains("  beta"))
+        let secondOutput = responses.capturedRequests[2].toolOutputs.first?.output ?? ""
+        XCTAssertTrue(secondOutput.contains(#""lines_returned":2"#))
+        XCTAssertTrue(secondOutput.contains(#""has_more":false"#))
+        XCTAssertTrue(secondOutput.contains("gamma"))
+    }
+
+    func testReadOnlyToolCallsRunConcurrentlyAndKeepCallOrder() async throws {
+        let sessionProvider = MockAgentSessionProvider(isLocal: false)
+        sessionProvider.supportsOutOfBandExecution = true
+        sessionProvider.outOfBandDelay = .milliseconds(50)
+        sessionProvider.simulatedRemoteFilesystemLines = ["f    /srv/app/config.yml"]
+
+        let responses = MockOpenAIResponsesService()
+        responses.enqueueResponse(
+            makeFunctionCallsResponse(
+                id: "resp_1",
+                calls: [
+                    ("call_read_a", "read_file_chunk", #"{"path":"/srv/app/a.txt","start_line":1,"line_count":5}"#),
+                    ("call_read_b", "read_file_chunk", #"{"path":"/srv/app/b.txt","start_line":1,"line_count":5}"#),
+                    ("call_fs", "search_filesystem", #"{"path":"/srv/app","name_pattern":"config","max_results":20}"#),
+                ]
+            )
+        )
+        responses.enqueueResponse(
+            makeTextResponse(id: "resp_2", text: "Done.")
+        )
+
+        let service = OpenAIAgentService(
+            responsesService: responses,
+            sessionProvider: sessionProvider
+        )
+
+        _ = try await service.generateReply(
+            sessionID: sessionProvider.sessionID,
+            prompt: "inspect the app"
+        )
+
+        XCTAssertGreaterThan(sessionProvider.maxConcurrentOutOfBandCommands, 1)
+        let outputs = responses.capturedRequests[1].toolOutputs
+        XCTAssertEqual(outputs.map(\.callID), ["call_read_a", "call_read_b", "call_fs"])
+    }
+
+    func testMutatingToolCallWaitsForEarlierReads() async throws {
+        let sessionProvider = MockAgentSessionProvider(isLocal: false)
+        sessionProvider.supportsOutOfBandExecution = true
+        sessionProvider.outOfBandDelay = .milliseconds(20)
+        sessionProvider.simulatedOutOfBandOutputQueue = [
+            "__PROSSH_RANGE__\nhello\n__PROSSH_RANGE__:1:6:0:0",
+        ]
+
+        let responses = MockOpenAIResponsesService()
+        responses.enqueueResponse(
+            makeFunctionCallsResponse(
+                id: "resp_1",
+                calls: [
+                    ("call_read", "read_file_chunk", #"{"path":"/srv/app/a.txt","start_line":1,"line_count":5}"#),
+                    ("call_exec", "execute_command", #"{"command":"touch /srv/app/b.txt"}"#),
+                ]
+            )
+        )
+        responses.enqueueResponse(
+            makeTextResponse(id: "resp_2", text: "Done.")
+        )
+
+        let service = OpenAIAgentService(
+            responsesService: responses,
+            sessionProvider: sessionProvider
+        )
+
+        _ = try await service.generateReply(
+            sessionID: sessionProvider.sessionID,
+            prompt: "read then touch"
+        )
+
+        XCTAssertEqual(sessionProvider.eventLog, ["exec_begin", "exec_end", "shell"])
+        let outputs = responses.capturedRequests[1].toolOutputs
+        XCTAssertEqual(outputs.map(\.callID), ["call_read", "call_exec"])
+    }
+
+    func testReadOnlyToolCallStartsWhileResponseIsStreaming() async throws {
+        let sessionProvider = MockAgentSessionProvider(isLocal: false)
+        sessionProvider.supportsOutOfBandExecution = true
+        sessionProvider.outOfBandDelay = .milliseconds(10)
+        sessionProvider.simulatedRemoteFilesystemLines = ["f    /srv/app/config.yml"]
+
+        let arguments = #"{"path":"/srv/app","name_pattern":"config","max_results":20}"#
+        let responses = MockOpenAIResponsesService()
+        responses.enqueueStreamEvents([
+            .functionCallReady(.init(id: "call_fs", name: "search_filesystem", arguments: arguments)),
+        ])
+        responses.enqueueResponse(
+            makeFunctionCallResponse(id: "resp_1", callID: "call_fs", toolName: "search_filesystem", arguments: arguments)
+        )
+        responses.enqueueResponse(
+            makeTextResponse(id: "resp_2", text: "Found it.")
+        )
+        var eventsWhenStreamEnded: [String] = []
+        responses.streamTail = .milliseconds(100)
+        responses.onStreamEnd = { eventsWhenStreamEnded = sessionProvider.eventLog }
+
+        let service = OpenAIAgentService(
+            responsesService: responses,
+            sessionProvider: sessionProvider
+        )
+
+        _ = try await service.generateReply(
+            sessionID: sessionProvider.sessionID,
+            prompt: "find the config"
+        )
+
+        XCTAssertTrue(eventsWhenStreamEnded.contains("exec_begin"))
+        XCTAssertEqual(sessionProvider.outOfBandCommands.count, 1)
+        let outputs = responses.capturedRequests[1].toolOutputs
+        XCTAssertEqual(outputs.map(\.callID), ["call_fs"])
+        XCTAssertTrue(outputs[0].output.contains("config.yml"))
+    }
+
+    func testMutatingToolCallIsNotStartedWhileResponseIsStreaming() async throws {
+        let sessionProvider = MockAgentSessionProvider(isLocal: false)
+        sessionProvider.supportsOutOfBandExecution = true
+        sessionProvider.outOfBandDelay = .milliseconds(10)
+        sessionProvider.simulatedRemoteFilesystemLines = ["f    /srv/app/config.yml"]
+
+        let search = #"{"path":"/srv/app","name_pattern":"config","max_results":20}"#
+        let touch = #"{"command":"touch /srv/app/b.txt"}"#
+        let responses = MockOpenAIResponsesService()
+        responses.enqueueStreamEvents([
+            .functionCallReady(.init(id: "call_exec", name: "execute_command", arguments: touch)),
+            .functionCallReady(.init(id: "call_fs", name: "search_filesystem", arguments: search)),
+        ])
+        responses.enqueueResponse(
+            makeFunctionCallsResponse(
+                id: "resp_1",
+                calls: [
+                    ("call_exec", "execute_command", touch),
+                    ("call_fs", "search_filesystem", search),
+                ]
+            )
+        )
+        responses.enqueueResponse(
+            makeTextResponse(id: "resp_2", text: "Done.")
+        )
+        var eventsWhenStreamEnded: [String] = ["unset"]
+        responses.streamTail = .milliseconds(50)
+        responses.onStreamEnd = { eventsWhenStreamEnded = sessionProvider.eventLog }
+
+        let service = OpenAIAgentService(
+            responsesService: responses,
+            sessionProvider: sessionProvider
+        )
+
+        _ = try await service.generateReply(
+            sessionID: sessionProvider.sessionID,
+            prompt: "touch then search"
+        )
+
+        // Neither call ran during the stream: the search came after a
+        // mutating call, so it waits for it.
+        XCTAssertEqual(eventsWhenStreamEnded, [])
+        let outputs = responses.capturedRequests[1].toolOutputs
+        XCTAssertEqual(outputs.map(\.callID), ["call_exec", "call_fs"])
+    }
+
     func testSearchFileContentsToolRunsInRemoteSession() async throws {
         let sessionProvider = MockAgentSessionProvider(isLocal: false)
         sessionProvider.simulatedRemoteFileContentLines = [
@@ -603,6 +852,65 @@ final class AIAgentServiceTests: XCTestCase {
         XCTAssertFalse(sessionProvider.sentCommandsSuppressEcho.contains(false))
     }
 
+    func testReadAfterRemotePatchIsServedFromFileCache() async throws {
+        let sessionProvider = MockAgentSessionProvider(isLocal: false)
+        sessionProvider.supportsOutOfBandExecution = true
+        let original = "PermitRootLogin no\n"
+        let base64Original = Data(original.utf8).base64EncodedString()
+
+        sessionProvider.simulatedExecuteAndWaitResultsQueue = [
+            CommandExecutionResult(
+                output: "__PROSSH_STAT__:19:1700000000:42\n" + base64Original,
+                exitCode: 0,
+                timedOut: false,
+                blockID: nil
+            ),
+            CommandExecutionResult(output: "", exitCode: 0, timedOut: false, blockID: nil), // write
+        ]
+        sessionProvider.simulatedOutOfBandOutputQueue = [
+            "__PROSSH_STAT__:34:1700000100:42", // post-write stat
+            "__PROSSH_CACHE_HIT__",
+        ]
+
+        let responses = MockOpenAIResponsesService()
+        responses.enqueueResponse(
+            makeFunctionCallResponse(
+                id: "resp_1",
+                callID: "call_patch",
+                toolName: "apply_patch",
+                arguments: #"{"operation":"update","path":"/etc/ssh/sshd_config","diff":"-PermitRootLogin no\n+PermitRootLogin prohibit-password"}"#
+            )
+        )
+        responses.enqueueResponse(
+            makeFunctionCallResponse(
+                id: "resp_2",
+                callID: "call_verify",
+                toolName: "read_file_chunk",
+                arguments: #"{"path":"/etc/ssh/sshd_config","start_line":1,"line_count":20}"#
+            )
+        )
+        responses.enqueueResponse(
+            makeTextResponse(id: "resp_3", text: "Verified.")
+        )
+
+        let service = OpenAIAgentService(
+            responsesService: responses,
+            sessionProvider: sessionProvider
+        )
+
+        _ = try await service.generateReply(
+            sessionID: sessionProvider.sessionID,
+            prompt: "patch and verify sshd config"
+        )
+
+        XCTAssertEqual(sessionProvider.outOfBandCommands.count, 2)
+        XCTAssertTrue(sessionProvider.outOfBandCommands[1].contains("'34:1700000100:42'"))
+        let verifyOutput = responses.capturedRequests[2].toolOutputs.first?.output ?? ""
+        XCTAssertTrue(verifyOutput.contains(#""ok":true"#))
+        XCTAssertTrue(verifyOutput.contains("PermitRootLogin prohibit-password"))
+        XCTAssertTrue(verifyOutput.contains(#""lines_returned":1"#))
+    }
+
     func testGenerateReplyForwardsStreamingAssistantAndReasoningEvents() async throws {
         let sessionProvider = MockAgentSessionProvider()
         let responses = MockOpenAIResponsesService()
@@ -660,22 +968,29 @@ final class AIAgentServiceTests: XCTestCase {
         callID: String,
         toolName: String,
         arguments: String
+    ) -> OpenAIResponsesResponse {
+        makeFunctionCallsResponse(id: id, calls: [(callID, toolName, arguments)])
+    }
+
+    private func makeFunctionCallsResponse(
+        id: String,
+        calls: [(callID: String, toolName: String, arguments: String)]
     ) -> OpenAIResponsesResponse {
         OpenAIResponsesResponse(
             id: id,
             status: "completed",
             outputText: nil,
-            output: [
+            output: calls.map { call in
                 .init(
                     type: "function_call",
                     id: nil,
                     role: nil,
                     content: nil,
-                    name: toolName,
-                    callID: callID,
-                    arguments: arguments
-                ),
-            ]
+                    name: call.toolName,
+                    callID: call.callID,
+                    arguments: call.arguments
+                )
+            }
         )
     }
 }
@@ -698,6 +1013,15 @@ private final class MockAgentSessionProvider: AIAgentSessionProviding {
     var simulatedExecuteAndWaitExitCode: Int? = 0
     var simulatedExecuteAndWaitTimedOut: Bool = false
     var simulatedExecuteAndWaitResultsQueue: [CommandExecutionResult] = []
+    var supportsOutOfBandExecution = false
+    var outOfBandCommands: [String] = []
+    var simulatedOutOfBandOutputQueue: [String] = []
+    var outOfBandDelay: Duration?
+    private(set) var maxConcurrentOutOfBandCommands = 0
+    private var activeOutOfBandCommands = 0
+    /// `exec_begin`/`exec_end` around delayed out-of-band commands, `shell`
+    /// for shell input; lets tests check how calls were ordered.
+    private(set) var eventLog: [String] = []
 
     init(isLocal: Bool = true) {
         let session = Session(
@@ -747,6 +1071,7 @@ private final class MockAgentSessionProvider: AIAgentSessionProviding {
     }
 
     func sendShellInput(sessionID: UUID, input: String, suppressEcho: Bool) async {
+        eventLog.append("shell")
         sentCommands.append(input)
         sentCommandsSuppressEcho.append(suppressEcho)
         guard let marker = Self.extractRemoteToolMarker(from: input) else {
@@ -824,6 +1149,40 @@ private final class MockAgentSessionProvider: AIAgentSessionProviding {
         )
     }
 
+    func executeCommandOutOfBand(
+        sessionID: UUID,
+        command: String,
+        timeoutSeconds: TimeInterval
+    ) async -> CommandExecutionResult? {
+        guard supportsOutOfBandExecution else { return nil }
+        outOfBandCommands.append(command)
+        if let outOfBandDelay {
+            eventLog.append("exec_begin")
+            activeOutOfBandCommands += 1
+            maxConcurrentOutOfBandCommands = max(maxConcurrentOutOfBandCommands, activeOutOfBandCommands)
+            try? await Task.sleep(for: outOfBandDelay)
+            activeOutOfBandCommands -= 1
+            eventLog.append("exec_end")
+        }
+        if !simulatedOutOfBandOutputQueue.isEmpty {
+            return CommandExecutionResult(
+                output: simulatedOutOfBandOutputQueue.removeFirst(),
+                exitCode: 0,
+                timedOut: false,
+                blockID: nil
+            )
+        }
+        let lines = command.contains("__prossh_find_pattern")
+            ? simulatedRemoteFilesystemLines
+            : simulatedRemoteFileContentLines
+        return CommandExecutionResult(
+            output: lines.joined(separator: "\n"),
+            exitCode: 0,
+            timedOut: false,
+            blockID: nil
+        )
+    }
+
     private static func extractRemoteToolMarker(from command: String) -> String? {
         let pattern = #"__PROSSH_AI_TOOL_EXIT_[A-F0-9]+__"#
         guard let regex = try? NSRegularExpression(pattern: pattern) else {
@@ -848,6 +1207,10 @@ private final class MockOpenAIResponsesService: OpenAIResponsesServicing {
     private(set) var capturedRequests: [OpenAIResponsesRequest] = []
     private var events: [Event] = []
     private var streamEventsByCall: [[OpenAIResponsesStreamEvent]] = []
+    /// How long a streamed response keeps going after its events, and what
+    /// to run when it ends.
+    var streamTail: Duration?
+    var onStreamEnd: (() -> Void)?
 
     func enqueueResponse(_ response: OpenAIResponsesResponse) {
         events.append(.response(response))
@@ -879,6 +1242,10 @@ private final class MockOpenAIResponsesService: OpenAIResponsesServicing {
         for event in streamEvents {
             onEvent(event)
         }
+        if let streamTail {
+            try? await Task.sleep(for: streamTail)
+        }
+        onStreamEnd?()
         return try popNextResponseEvent()
     }
 
@@ -0,0 +1,180 @@
+// AllocationTrackerTests.swift
+// ProSSHV2
+//
+// Tests for the hot-path allocation counters: scopes count only their own
+// thread, nest into the scope around them, and the parser and cell upload
+// stay under their allocation ceilings.
+
+#if canImport(XCTest)
+import XCTest
+import Metal
+@testable import ProSSHMac
+
+final class AllocationTrackerTests: XCTestCase {
+
+    /// Ceilings, not targets: lower them as allocations are removed.
+    private static let parseAllocationsPerMBCeiling = 4_096.0
+    private static let unchangedUploadAllocationsCeiling = 8.0
+
+    private final class Box {
+        var value = 0
+    }
+
+    // MARK: - Helpers
+
+    override func setUpWithError() throws {
+        try super.setUpWithError()
+        guard AllocationTracker.enable() else {
+            throw XCTSkip("malloc_logger is held by another logger")
+        }
+        AllocationTracker.reset()
+    }
+
+    override func tearDown() {
+        AllocationTracker.disable()
+        AllocationTracker.reset()
+        super.tearDown()
+    }
+
+    private func allocateBoxes(_ count: Int) -> [Box] {
+        var boxes: [Box] = []
+        boxes.reserveCapacity(count)
+        for _ in 0..<count {
+            boxes.append(Box())
+        }
+        return boxes
+    }
+
+    // MARK: - Scopes
+
+    func testScopeCountsItsAllocations() {
+        let scope = AllocationTracker.begin(.snapshot)
+        let boxes = allocateBoxes(100)
+        scope?.end()
+
+        let counts = AllocationTracker.counts(for: .snapshot)
+        XCTAssertEqual(boxes.count, 100)
+        XCTAssertEqual(counts.calls, 1)
+        XCTAssertGreaterThanOrEqual(counts.allocations, 100)
+    }
+
+    func testAllocationsOutsideAScopeAreNotCounted() {
+        let scope = AllocationTracker.begin(.snapshot)
+        scope?.end()
+        let boxes = allocateBoxes(100)
+
+        XCTAssertEqual(boxes.count, 100)
+        XCTAssertEqual(AllocationTracker.counts(for: .snapshot).allocations, 0)
+    }
+
+    func testOtherThreadsAreNotCounted() {
+        let done = DispatchSemaphore(value: 0)
+        let scope = AllocationTracker.begin(.frame)
+        DispatchQueue.global().async {
+            _ = self.allocateBoxes(10_000)
+            done.signal()
+        }
+        done.wait()
+        scope?.end()
+
+        XCTAssertLessThan(AllocationTracker.counts(for: .frame).allocations, 10_000)
+    }
+
+    func testNestedScopeCountsTowardsTheEnclosingScope() {
+        let outer = AllocationTracker.begin(.frame)
+        let inner = AllocationTracker.begin(.cellBufferUpdate)
+        _ = allocateBoxes(50)
+        inner?.end()
+        outer?.end()
+
+        let inside = AllocationTracker.counts(for: .cellBufferUpdate).allocations
+        XCTAssertGreaterThanOrEqual(inside, 50)
+        XCTAssertGreaterThanOrEqual(AllocationTracker.counts(for: .frame).allocations, inside)
+    }
+
+    func testDisabledTrackerOpensNoScope() {
+        AllocationTracker.disable()
+        XCTAssertNil(AllocationTracker.begin(.parse))
+    }
+
+    func testParseScopesReportBytes() {
+        let scope = AllocationTracker.begin(.parse)
+        scope?.end(bytes: 2 * 1_048_576)
+
+        let counts = AllocationTracker.counts(for: .parse)
+        XCTAssertEqual(counts.bytes, 2 * 1_048_576)
+        XCTAssertEqual(counts.allocationsPerMB ?? -1, Double(counts.allocations) / 2, accuracy: 1e-9)
+    }
+
+    // MARK: - Hot Paths
+
+    func testParserStaysUnderItsCeiling() async {
+        let engine = TerminalEngine(columns: 80, rows: 24)
+        let payload = BenchmarkCorpus.base64Payload(targetBytes: 1_048_576, lineLength: 76)
+        let chunks = stride(from: 0, to: payload.count, by: 4096).map {
+            payload.subdata(in: $0..<min($0 + 4096, payload.count))
+        }
+        // Warm up: first-use growth of the grid and scrollback is not steady state.
+        for chunk in chunks.prefix(16) {
+            await engine.feed(chunk)
+        }
+        AllocationTracker.reset()
+
+        for chunk in chunks {
+            await engine.feed(chunk)
+        }
+        _ = await engine.snapshot()
+
+        let parse = AllocationTracker.counts(for: .parse)
+        XCTAssertEqual(parse.calls, UInt64(chunks.count))
+        XCTAssertEqual(parse.bytes, UInt64(payload.count))
+        XCTAssertLessThan(parse.allocationsPerMB ?? .infinity, Self.parseAllocationsPerMBCeiling)
+        XCTAssertEqual(AllocationTracker.counts(for: .snapshot).calls, 1)
+    }
+
+    func testUnchangedUploadStaysUnderItsCeiling() throws {
+        guard let device = MTLCreateSystemDefaultDevice() else {
+            throw XCTSkip("No Metal device available")
+        }
+        let columns = 80
+        let rows = 24
+        let cells = ContiguousArray((0..<(columns * rows)).map { index in
+            CellInstance(
+                row: UInt16(index / columns), col: UInt16(index % columns),
+                glyphIndex: UInt32(index),
+                fgColor: 0, bgColor: 0, underlineColor: 0,
+                attributes: 0, flags: 0, underlineStyle: 0
+            )
+        })
+        var snapshot = GridSnapshot(
+            cells: cells,
+            dirtyRange: nil,
+            cursorRow: 0,
+            cursorCol: 0,
+            cursorVisible: true,
+            cursorStyle: .block,
+            columns: columns,
+            rows: rows,
+            usingAlternateBuffer: false,
+            graphemeOverrides: nil
+        )
+        let buffer = CellBuffer(device: device, bufferCount: 3)
+        for _ in 0..<3 {
+            buffer.update(from: snapshot)
+            buffer.swapBuffers()
+        }
+
+        // Nothing damaged: the steady state of an idle pane redrawing.
+        snapshot.damagedRanges = []
+        AllocationTracker.reset()
+        for _ in 0..<60 {
+            buffer.update(from: snapshot)
+            buffer.swapBuffers()
+        }
+
+        let counts = AllocationTracker.counts(for: .cellBufferUpdate)
+        XCTAssertEqual(counts.calls, 60)
+        XCTAssertLessThanOrEqual(counts.allocationsPerCall, Self.unchangedUploadAllocationsCeiling)
+    }
+}
+#endif
@@ -303,6 +303,45 @@ final class UnifiedDiffApplyTests: XCTestCase {
         XCTAssertTrue(result.contains("line TWO"))
     }
 
+    func testRelocatedHunkBeyondFuzzWindowReportsDrift() throws {
+        var lines = (1...50_000).map { "let value\($0) = \($0)" }
+        lines[41_999] = "let target = 0"
+        let original = lines.joined(separator: "\n") + "\n"
+        let diff = """
+        @@ -120,3 +120,3 @@
+         let value41999 = 41999
+        -let target = 0
+        +let target = 1
+         let value42001 = 42001
+        """
+
+        let application = try patcher.applyReportingPlacements(diff: diff, to: original)
+
+        XCTAssertTrue(application.content.contains("let target = 1\n"))
+        XCTAssertEqual(application.placements, [HunkPlacement(hunkIndex: 0, expectedLine: 120, appliedLine: 41_999)])
+        XCTAssertEqual(application.placements.first?.drift, 41_879)
+    }
+
+    func testUnmatchedHunkReportsFirstDifferingLineWhereItAligns() {
+        let original = (1...200).map { "line \($0)" }.joined(separator: "\n") + "\n"
+        let diff = """
+        @@ -10,3 +10,3 @@
+         line 150
+        -line 151 changed upstream
+        +line 151 patched
+         line 152
+        """
+
+        XCTAssertThrowsError(try patcher.apply(diff: diff, to: original)) { error in
+            XCTAssertEqual(error as? DiffError, .contextMismatch(
+                hunkIndex: 0,
+                expectedLine: 151,
+                expected: "line 151 changed upstream",
+                actual: "line 151"
+            ))
+        }
+    }
+
     func testEmptyFileAddition() throws {
         let original = ""
         let diff = """
@@ -654,6 +693,24 @@ final class RemotePatchCommandBuilderTests: XCTestCase {
         XCTAssertTrue(command.contains("removeme.txt"))
     }
 
+    func testUploadTargetParsesAbsolutePathAndIgnoresEchoedCommand() {
+        let command = RemotePatchCommandBuilder.buildUploadPrepareCommand(path: "conf/app.yml")
+        let output = "\(command)\n__PROSSH_UPLOAD__:/srv/app/conf/app.yml\n"
+
+        XCTAssertEqual(RemotePatchCommandBuilder.parseUploadTarget(output), "/srv/app/conf/app.yml")
+        XCTAssertNil(RemotePatchCommandBuilder.parseUploadTarget("Permission denied: 'conf/app.yml'"))
+    }
+
+    func testTemporaryUploadIsHiddenSiblingOfTarget() {
+        let temporary = RemotePatchCommandBuilder.temporaryUploadPath(for: "/srv/app/conf/app.yml")
+
+        XCTAssertTrue(temporary.hasPrefix("/srv/app/conf/.app.yml.prossh-"))
+        let commit = RemotePatchCommandBuilder.buildUploadCommitCommand(
+            temporaryPath: temporary, path: "/srv/app/conf/app.yml"
+        )
+        XCTAssertTrue(commit.contains("mv -f '\(temporary)' '/srv/app/conf/app.yml'"))
+    }
+
     func testParseSuccessResult() {
         let op = PatchOperation(type: .delete, path: "file.txt", diff: nil)
         // rm produces no output on success; parseResult should still return success
@@ -721,6 +778,33 @@ final class RemotePatchCommandBuilderTests: XCTestCase {
         XCTAssertEqual(RemotePatchCommandBuilder.buildSudoPrimingCommand(), "sudo -v")
     }
 
+    func testCachedReadCommandPrintsHitTokenInsteadOfContentsWhenUnchanged() {
+        let command = RemotePatchCommandBuilder.buildCachedReadCommand(
+            path: "/etc/nginx.conf",
+            cachedFingerprint: "120:1700000000:42"
+        )
+        XCTAssertTrue(command.contains(RemotePatchCommandBuilder.statMarker))
+        XCTAssertTrue(command.contains("= '120:1700000000:42' ]"))
+        XCTAssertTrue(command.contains(RemotePatchCommandBuilder.cacheHitToken))
+        XCTAssertTrue(command.contains("else base64 '/etc/nginx.conf'; fi"))
+
+        let uncached = RemotePatchCommandBuilder.buildCachedReadCommand(path: "/etc/nginx.conf", cachedFingerprint: nil)
+        XCTAssertFalse(uncached.contains(RemotePatchCommandBuilder.cacheHitToken))
+        XCTAssertTrue(uncached.hasSuffix("base64 '/etc/nginx.conf'"))
+    }
+
+    func testParseStatFingerprintIgnoresEchoedCommand() {
+        let output = """
+        user@host:~$ __prossh_fp="$(stat ...)"; printf '__PROSSH_STAT__:%s\\n' "$__prossh_fp"
+        __PROSSH_STAT__:120:1700000000:42\r
+        __PROSSH_CACHE_HIT__
+        """
+        XCTAssertEqual(RemotePatchCommandBuilder.parseStatFingerprint(output), "120:1700000000:42")
+        XCTAssertTrue(RemotePatchCommandBuilder.outputIndicatesCacheHit(output))
+        XCTAssertNil(RemotePatchCommandBuilder.parseStatFingerprint("__PROSSH_STAT__:\nbase64: x: No such file"))
+        XCTAssertFalse(RemotePatchCommandBuilder.outputIndicatesCacheHit("printf '__PROSSH_CACHE_HIT__\\n'"))
+    }
+
     func testReadCommandEscapesSpaces() {
         let command = RemotePatchCommandBuilder.buildReadCommand(path: "/etc/my config/file.conf")
         // shellEscaped wraps in single quotes so spaces inside the path are safe
@@ -775,7 +859,7 @@ final class RemotePatchCommandBuilderTests: XCTestCase {
     }
 
     func testBase64ReadLineExtraction() {
-        // Simulates the base64 read → decode → line slicing that readRemoteFileChunk now uses.
+        // Simulates the base64 read → decode → line slicing that apply_patch uses for updates.
         let original = "line one\nline two\nline three\nline four\nline five\n"
         let b64 = Data(original.utf8).base64EncodedString()
         let contaminated = "user@host:~$ base64 'file.txt'\n" + b64 + "\nuser@host:~$ "
@@ -0,0 +1,100 @@
+// AsciinemaCastWriterTests.swift
+// ProSSHV2
+//
+// The byte-level cast writer must produce lines that JSON parsers read back
+// as the recorded text, carry UTF-8 split across chunks, and write a gzip
+// member that inflates to the plain cast.
+
+#if canImport(XCTest)
+import Compression
+import XCTest
+@testable import ProSSHMac
+
+final class AsciinemaCastWriterTests: XCTestCase {
+
+    // MARK: - Helpers
+
+    private func makeURL(_ name: String) -> URL {
+        FileManager.default.temporaryDirectory
+            .appendingPathComponent("prossh-cast-\(UUID().uuidString)", isDirectory: true)
+            .appendingPathComponent(name)
+    }
+
+    private func writeCast(gzip: Bool, events: [(UInt64, SessionRecordingStream, [UInt8])]) throws -> URL {
+        let url = makeURL(gzip ? "test.cast.gz" : "test.cast")
+        let writer = try AsciinemaCastWriter(
+            url: url,
+            columns: 100,
+            rows: 40,
+            startedAt: Date(timeIntervalSince1970: 1_700_000_000),
+            gzip: gzip
+        )
+        for (offset, stream, bytes) in events {
+            try writer.append(offsetNanoseconds: offset, stream: stream, payload: Data(bytes))
+        }
+        try writer.finish()
+        return url
+    }
+
+    private func eventLines(_ data: Data) throws -> [[Any]] {
+        try String(decoding: data, as: UTF8.self)
+            .split(separator: "\n")
+            .dropFirst()
+            .map { try XCTUnwrap(try JSONSerialization.jsonObject(with: Data($0.utf8)) as? [Any]) }
+    }
+
+    // MARK: - Tests
+
+    func testEscapesControlCharactersQuotesAndInvalidBytes() throws {
+        let payload = Array("say \"hi\"\\\r\n\t\u{1B}[0m é".utf8) + [0xFF]
+        let url = try writeCast(gzip: false, events: [(1_250_000_000, .output, payload), (2_000_000, .input, Array("q".utf8))])
+        let data = try Data(contentsOf: url)
+
+        let header = try XCTUnwrap(try JSONSerialization.jsonObject(
+            with: Data(String(decoding: data, as: UTF8.self).split(separator: "\n")[0].utf8)
+        ) as? [String: Any])
+        XCTAssertEqual(header["width"] as? Int, 100)
+        XCTAssertEqual(header["height"] as? Int, 40)
+
+        let events = try eventLines(data)
+        XCTAssertEqual(events.count, 2)
+        XCTAssertEqual(events[0][0] as? Double, 1.25)
+        XCTAssertEqual(events[0][1] as? String, "o")
+        XCTAssertEqual(events[0][2] as? String, String(decoding: payload, as: UTF8.self))
+        XCTAssertEqual(events[1][0] as? Double, 0.002)
+        XCTAssertEqual(events[1][1] as? String, "i")
+        XCTAssertTrue(String(decoding: data, as: UTF8.self).contains("[1.250000,\"o\","))
+    }
+
+    func testCarriesUTF8SplitAcrossChunks() throws {
+        let euro = Array("€".utf8)
+        let url = try writeCast(gzip: false, events: [
+            (1_000, .output, Array("a".utf8) + euro.prefix(2)),
+            (2_000, .output, Array(euro.suffix(1)) + Array("b".utf8)),
+            (3_000, .output, [0xE2])
+        ])
+        let events = try eventLines(try Data(contentsOf: url))
+        XCTAssertEqual(events.map { $0[2] as? String }, ["a", "€b", "\u{FFFD}"])
+    }
+
+    func testGzipInflatesToPlainCast() throws {
+        let events: [(UInt64, SessionRecordingStream, [UInt8])] = (0..<2_000).map {
+            (UInt64($0) * 1_000_000, .output, Array("line \($0) of output\r\n".utf8))
+        }
+        let plain = try Data(contentsOf: try writeCast(gzip: false, events: events))
+        let gzipped = try Data(contentsOf: try writeCast(gzip: true, events: events))
+
+        XCTAssertEqual(Array(gzipped.prefix(3)), [0x1F, 0x8B, 0x08])
+        let trailer = gzipped.suffix(4)
+        let size = trailer.withUnsafeBytes { $0.loadUnaligned(as: UInt32.self) }
+        XCTAssertEqual(Int(UInt32(littleEndian: size)), plain.count)
+
+        let deflated = [UInt8](gzipped.dropFirst(10).dropLast(8))
+        var inflated = [UInt8](repeating: 0, count: plain.count + 1)
+        let count = compression_decode_buffer(&inflated, inflated.count, deflated, deflated.count, nil, COMPRESSION_ZLIB)
+        XCTAssertEqual(Data(inflated.prefix(count)), plain)
+        XCTAssertLessThan(gzipped.count, plain.count / 2)
+    }
+}
+
+#endif
@@ -0,0 +1,128 @@
+// AuditLogStoreTests.swift
+// ProSSHV2
+//
+// Segmented audit log: entries survive reopening, reads return the newest
+// entries first, trimming drops whole old segments, and a torn record at
+// the end of the newest segment is cut off.
+
+#if canImport(XCTest)
+import CryptoKit
+import XCTest
+@testable import ProSSHMac
+
+final class AuditLogStoreTests: XCTestCase {
+
+    private var directory: URL!
+    private let key = SymmetricKey(size: .bits256)
+
+    override func setUpWithError() throws {
+        directory = FileManager.default.temporaryDirectory
+            .appendingPathComponent("AuditLogStoreTests-\(UUID().uuidString)", isDirectory: true)
+    }
+
+    override func tearDownWithError() throws {
+        try? FileManager.default.removeItem(at: directory)
+    }
+
+    // MARK: - Helpers
+
+    private func makeStore(maxEntries: Int = 5_000) -> FileAuditLogStore {
+        let key = key
+        return FileAuditLogStore(maxEntries: maxEntries, baseDirectory: directory) { _ in key }
+    }
+
+    private func makeEntry(_ action: String, at seconds: TimeInterval) -> AuditLogEntry {
+        AuditLogEntry(
+            id: UUID(),
+            timestamp: Date(timeIntervalSince1970: seconds),
+            category: .portForwarding,
+            action: action,
+            outcome: .info,
+            hostLabel: "web",
+            hostname: "web.example.com",
+            port: 22,
+            username: "admin",
+            sessionID: nil,
+            details: nil
+        )
+    }
+
+    private func segmentURLs() throws -> [URL] {
+        try FileManager.default.contentsOfDirectory(
+            at: directory.appendingPathComponent("AuditLog"),
+            includingPropertiesForKeys: nil
+        )
+        .filter { $0.pathExtension == "log" }
+        .sorted { $0.lastPathComponent < $1.lastPathComponent }
+    }
+
+    // MARK: - Tests
+
+    func testEntriesSurviveReopenNewestFirst() async throws {
+        let store = makeStore()
+        try await store.append(makeEntry("open", at: 100))
+        try await store.append(makeEntry("close", at: 200))
+
+        let entries = try await makeStore().loadEntries(limit: nil)
+        XCTAssertEqual(entries.map(\.action), ["close", "open"])
+    }
+
+    func testLimitReadsOnlyNewestEntries() async throws {
+        let store = makeStore()
+        for index in 0..<50 {
+            try await store.append(makeEntry("event \(index)", at: TimeInterval(index)))
+        }
+        let entries = try await store.loadEntries(limit: 3)
+        XCTAssertEqual(entries.map(\.action), ["event 49", "event 48", "event 47"])
+    }
+
+    func testTrimmingDropsWholeSegments() async throws {
+        // maxEntries 8 gives segments of 2 records.
+        let store = makeStore(maxEntries: 8)
+        for index in 0..<21 {
+            try await store.append(makeEntry("event \(index)", at: TimeInterval(index)))
+        }
+
+        let entries = try await store.loadEntries(limit: nil)
+        XCTAssertEqual(entries.count, 8)
+        XCTAssertEqual(entries.first?.action, "event 20")
+        XCTAssertEqual(entries.last?.action, "event 13")
+        XCTAssertLessThanOrEqual(try segmentURLs().count, 5)
+
+        let reopened = try await makeStore(maxEntries: 8).loadEntries(limit: nil)
+        XCTAssertEqual(reopened.map(\.action), entries.map(\.action))
+    }
+
+    func testTornTailIsCutOff() async throws {
+        let store = makeStore()
+        try await store.append(makeEntry("kept", at: 1))
+        try await store.append(makeEntry("torn", at: 2))
+
+        let url = try XCTUnwrap(try segmentURLs().last)
+        let handle = try FileHandle(forUpdating: url)
+        let length = try handle.seekToEnd()
+        try handle.truncate(atOffset: length - 3)
+        try handle.close()
+
+        let reopened = makeStore()
+        let recovered = try await reopened.loadEntries(limit: nil)
+        XCTAssertEqual(recovered.map(\.action), ["kept"])
+        try await reopened.append(makeEntry("after", at: 3))
+        let appended = try await makeStore().loadEntries(limit: nil)
+        XCTAssertEqual(appended.map(\.action), ["after", "kept"])
+    }
+
+    func testClearAllRemovesSegments() async throws {
+        let store = makeStore()
+        try await store.append(makeEntry("gone", at: 1))
+        try await store.clearAll()
+        XCTAssertTrue(try segmentURLs().isEmpty)
+        let cleared = try await makeStore().loadEntries(limit: nil)
+        XCTAssertTrue(cleared.isEmpty)
+        try await store.append(makeEntry("fresh", at: 2))
+        let fresh = try await makeStore().loadEntries(limit: nil)
+        XCTAssertEqual(fresh.map(\.action), ["fresh"])
+    }
+}
+
+#endif
@@ -0,0 +1,141 @@
+// BackgroundResizeTests.swift
+// ProSSHV2
+//
+// Background resize reflows a copy of the grid while output keeps arriving,
+// then swaps it in and replays that output. The result must match a
+// synchronous resize followed by the same output, without repeating replies.
+
+#if canImport(XCTest)
+import XCTest
+@testable import ProSSHMac
+
+final class BackgroundResizeTests: XCTestCase {
+
+    // MARK: - Helpers
+
+    private func history(lines: Int) -> [UInt8] {
+        var output = ""
+        for index in 0..<lines {
+            let body = index % 3 == 0 ? String(repeating: "w", count: 70) : "short"
+            output += "\(index) \(body)\r\n"
+        }
+        return Array(output.utf8)
+    }
+
+    private func screenText(_ grid: TerminalGrid) -> [String] {
+        (0..<grid.rows).map { row in
+            String((0..<grid.columns).compactMap { col -> Character? in
+                guard let cell = grid.cellAt(row: row, col: col), cell.codepoint != 0,
+                      let scalar = UnicodeScalar(cell.codepoint) else { return " " }
+                return Character(scalar)
+            })
+        }
+    }
+
+    /// Start a background resize and return once it is in flight (or has
+    /// already landed, in which case later output simply follows it).
+    private func startResize(_ engine: TerminalEngine, columns: Int, rows: Int) async -> Task<Void, Never> {
+        let task = Task { await engine.resize(newColumns: columns, newRows: rows) }
+        while !(await engine.isBackgroundResizePending), await engine.columns != columns {
+            await Task.yield()
+        }
+        return task
+    }
+
+    // MARK: - Tests
+
+    func testOutputDuringResizeMatchesSynchronousResize() async {
+        let reference = TerminalEngine(columns: 40, rows: 6, maxScrollbackLines: 100_000)
+        let engine = TerminalEngine(columns: 40, rows: 6, maxScrollbackLines: 100_000)
+        await engine.setBackgroundResizeEnabled(true)
+
+        let prefix = history(lines: 5_000)
+        let tail = Array("\u{1B}[1mtail \u{1B}[31mred\u{1B}[0m\r\nnext line".utf8)
+        await reference.feed(prefix)
+        await engine.feed(prefix)
+
+        await reference.resize(newColumns: 25, newRows: 8)
+        await reference.feed(tail)
+
+        let resize = await startResize(engine, columns: 25, rows: 8)
+        await engine.feed(tail)
+        await resize.value
+
+        let isPending = await engine.isBackgroundResizePending
+        XCTAssertFalse(isPending)
+        let expectedGrid = await reference.grid
+        let grid = await engine.grid
+        XCTAssertEqual(grid.columns, 25)
+        XCTAssertEqual(grid.rows, 8)
+        XCTAssertEqual(screenText(grid), screenText(expectedGrid))
+        XCTAssertEqual(grid.cursorPosition().row, expectedGrid.cursorPosition().row)
+        XCTAssertEqual(grid.cursorPosition().col, expectedGrid.cursorPosition().col)
+        XCTAssertEqual(grid.scrollbackCount, expectedGrid.scrollbackCount)
+        XCTAssertEqual(grid.currentAttributes, expectedGrid.currentAttributes)
+    }
+
+    func testRepliesAreNotRepeatedOnReplay() async {
+        let engine = TerminalEngine(columns: 40, rows: 6, maxScrollbackLines: 100_000)
+        await engine.setBackgroundResizeEnabled(true)
+        let replies = ReplyCounter()
+        await engine.setResponseHandler { @Sendable _ in
+            await replies.increment()
+        }
+        await engine.feed(history(lines: 5_000))
+
+        let resize = await startResize(engine, columns: 30, rows: 6)
+        await engine.feed(Array("\u{1B}[6n\u{07}".utf8))
+        await resize.value
+
+        let replyCount = await replies.count
+        XCTAssertEqual(replyCount, 1)
+        let bells = await engine.consumeBellCount()
+        XCTAssertEqual(bells, 1)
+    }
+
+    func testNewerResizeSupersedesOneInFlight() async {
+        let engine = TerminalEngine(columns: 40, rows: 6, maxScrollbackLines: 100_000)
+        await engine.setBackgroundResizeEnabled(true)
+        await engine.feed(history(lines: 5_000))
+
+        let first = Task { await engine.resize(newColumns: 30, newRows: 6) }
+        let second = Task { await engine.resize(newColumns: 50, newRows: 10) }
+        await first.value
+        await second.value
+
+        // Whichever call the actor ran last decides the final size.
+        let columns = await engine.columns
+        let rows = await engine.rows
+        XCTAssertTrue((columns, rows) == (30, 6) || (columns, rows) == (50, 10))
+        let isPending = await engine.isBackgroundResizePending
+        XCTAssertFalse(isPending)
+    }
+
+    func testGridMutationOutsideParserFinishesResizeFirst() async {
+        let engine = TerminalEngine(columns: 40, rows: 6, maxScrollbackLines: 100_000)
+        await engine.setBackgroundResizeEnabled(true)
+        await engine.feed(history(lines: 5_000))
+
+        let resize = await startResize(engine, columns: 30, rows: 6)
+        await engine.moveCursorTo(row: 2, col: 28)
+        await resize.value
+
+        let columns = await engine.columns
+        XCTAssertEqual(columns, 30)
+        let cursor = await engine.cursor
+        XCTAssertEqual(cursor.row, 2)
+        XCTAssertEqual(cursor.col, 28)
+    }
+}
+
+// MARK: - ReplyCounter
+
+private actor ReplyCounter {
+    private(set) var count = 0
+
+    func increment() {
+        count += 1
+    }
+}
+
+#endif
@@ -0,0 +1,39 @@
+// BenchmarkCorpusTests.swift
+// ProSSHV2
+//
+// Tests for the throughput benchmark's workload corpus.
+
+#if canImport(XCTest)
+import XCTest
+@testable import ProSSHMac
+
+final class BenchmarkCorpusTests: XCTestCase {
+
+    // MARK: - Tests
+
+    func testBuiltInWorkloadsAreDeterministicAndSized() {
+        for name in BenchmarkCorpus.builtInNames {
+            let first = BenchmarkCorpus.builtIn(name, columns: 80, rows: 24, targetBytes: 64 * 1024)
+            let second = BenchmarkCorpus.builtIn(name, columns: 80, rows: 24, targetBytes: 64 * 1024)
+            XCTAssertNotNil(first, name)
+            XCTAssertEqual(first?.payload, second?.payload, name)
+            XCTAssertGreaterThanOrEqual(first?.payload.count ?? 0, 64 * 1024, name)
+        }
+    }
+
+    func testUnknownWorkloadIsNil() {
+        XCTAssertNil(BenchmarkCorpus.builtIn("nope", columns: 80, rows: 24, targetBytes: 1024))
+    }
+
+    func testCastOutputKeepsOnlyOutputEvents() throws {
+        let cast = """
+        {"version": 2, "width": 80, "height": 24}
+        [0.1, "o", "hello "]
+        [0.2, "i", "typed"]
+        [0.3, "o", "\\u001b[1mworld\\u001b[0m"]
+        """
+        let output = try BenchmarkCorpus.castOutput(Data(cast.utf8))
+        XCTAssertEqual(String(decoding: output, as: UTF8.self), "hello \u{1B}[1mworld\u{1B}[0m")
+    }
+}
+#endif
@@ -0,0 +1,97 @@
+#if canImport(XCTest)
+import XCTest
+@testable import ProSSHMac
+
+final class BiometricAuthenticationGateTests: XCTestCase {
+
+    // MARK: - Helpers
+
+    private final class Prompts: @unchecked Sendable {
+        private let lock = NSLock()
+        private var count = 0
+        var failing = false
+
+        var total: Int {
+            lock.withLock { count }
+        }
+
+        func evaluator(delay: Duration = .milliseconds(50)) -> BiometricAuthenticationGate.Evaluator {
+            { _, _ in
+                let shouldFail = self.lock.withLock { () -> Bool in
+                    self.count += 1
+                    return self.failing
+                }
+                try await Task.sleep(for: delay)
+                if shouldFail {
+                    throw BiometricPasswordError.userCancelled
+                }
+            }
+        }
+    }
+
+    // MARK: - Coalescing
+
+    func testConcurrentReadsShareOnePrompt() async throws {
+        let prompts = Prompts()
+        let gate = BiometricAuthenticationGate(graceWindow: 30, evaluate: prompts.evaluator())
+
+        try await withThrowingTaskGroup(of: Void.self) { group in
+            for _ in 0..<30 {
+                group.addTask {
+                    _ = try await gate.approval(reason: "Connect")
+                }
+            }
+            try await group.waitForAll()
+        }
+
+        XCTAssertEqual(prompts.total, 1)
+    }
+
+    func testFailedPromptFailsEveryWaiterAndIsNotCached() async {
+        let prompts = Prompts()
+        prompts.failing = true
+        let gate = BiometricAuthenticationGate(graceWindow: 30, evaluate: prompts.evaluator())
+
+        let failures = await withTaskGroup(of: Bool.self) { group in
+            for _ in 0..<5 {
+                group.addTask {
+                    (try? await gate.approval(reason: "Connect")) == nil
+                }
+            }
+            var failed = 0
+            for await didFail in group where didFail {
+                failed += 1
+            }
+            return failed
+        }
+        XCTAssertEqual(failures, 5)
+        XCTAssertEqual(prompts.total, 1)
+
+        prompts.failing = false
+        _ = try? await gate.approval(reason: "Connect")
+        XCTAssertEqual(prompts.total, 2)
+    }
+
+    // MARK: - Grace Window
+
+    func testApprovalIsReusedWithinGraceWindow() async throws {
+        let prompts = Prompts()
+        let gate = BiometricAuthenticationGate(graceWindow: 30, evaluate: prompts.evaluator(delay: .zero))
+        _ = try await gate.approval(reason: "Connect")
+        _ = try await gate.approval(reason: "Connect")
+        XCTAssertEqual(prompts.total, 1)
+
+        gate.invalidate()
+        _ = try await gate.approval(reason: "Connect")
+        XCTAssertEqual(prompts.total, 2)
+    }
+
+    func testZeroGraceWindowPromptsForEachBurst() async throws {
+        let prompts = Prompts()
+        let gate = BiometricAuthenticationGate(graceWindow: 0, evaluate: prompts.evaluator(delay: .zero))
+        _ = try await gate.approval(reason: "Connect")
+        _ = try await gate.approval(reason: "Connect")
+        XCTAssertEqual(prompts.total, 2)
+    }
+}
+#endif
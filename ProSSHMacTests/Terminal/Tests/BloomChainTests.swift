@@ -0,0 +1,121 @@
+// BloomChainTests.swift
+// ProSSHV2
+//
+// Compute bloom chain: level sizing, the shared down levels, and reuse of
+// the cached halo while the scene and bloom inputs stay the same.
+
+#if canImport(XCTest)
+import XCTest
+import Metal
+@testable import ProSSHMac
+
+final class BloomChainTests: XCTestCase {
+
+    private func makeDevice() throws -> MTLDevice {
+        guard let device = MTLCreateSystemDefaultDevice() else {
+            throw XCTSkip("No Metal device available")
+        }
+        return device
+    }
+
+    private func makeChain(device: MTLDevice) throws -> BloomChain {
+        let pipelines = try TerminalPipelineCache(archiveDirectory: nil).pipelines(for: device)
+        return BloomChain(
+            device: device,
+            downsamplePipeline: try XCTUnwrap(pipelines.bloomDownsample),
+            upsamplePipeline: try XCTUnwrap(pipelines.bloomUpsample)
+        )
+    }
+
+    private func makeScene(device: MTLDevice, width: Int, height: Int) throws -> MTLTexture {
+        let descriptor = MTLTextureDescriptor.texture2DDescriptor(
+            pixelFormat: .bgra8Unorm,
+            width: width,
+            height: height,
+            mipmapped: false
+        )
+        descriptor.usage = [.renderTarget, .shaderRead]
+        descriptor.storageMode = .private
+        return try XCTUnwrap(device.makeTexture(descriptor: descriptor))
+    }
+
+    // MARK: - Levels
+
+    func testLevelsHalveUpToTheLimit() {
+        let sizes = BloomChain.levelSizes(width: 800, height: 500)
+        XCTAssertEqual(sizes, [SIMD2(800, 500), SIMD2(400, 250), SIMD2(200, 125), SIMD2(100, 62), SIMD2(50, 31)])
+        XCTAssertEqual(sizes.count, BloomChain.maxLevels)
+    }
+
+    func testLevelsStopAtOnePixel() {
+        XCTAssertEqual(BloomChain.levelSizes(width: 4, height: 1), [SIMD2(4, 1), SIMD2(2, 1), SIMD2(1, 1)])
+        XCTAssertEqual(BloomChain.levelSizes(width: 1, height: 1), [SIMD2(1, 1)])
+        XCTAssertTrue(BloomChain.levelSizes(width: 0, height: 10).isEmpty)
+    }
+
+    func testSharedTargetsHoldOneTexturePerLevel() throws {
+        let device = try makeDevice()
+        let store = RenderResourceStore()
+        let targets = try XCTUnwrap(store.effectTargets(.bloomChain, width: 320, height: 200, device: device))
+        XCTAssertEqual(targets.textures.map { SIMD2($0.width, $0.height) }, BloomChain.levelSizes(width: 320, height: 200))
+        XCTAssertTrue(targets.textures.allSatisfy { $0.usage.contains(.shaderWrite) })
+    }
+
+    // MARK: - Cache
+
+    func testStaticSceneReusesCachedHalo() throws {
+        let device = try makeDevice()
+        let chain = try makeChain(device: device)
+        let scene = try makeScene(device: device, width: 128, height: 64)
+        let downLevels = try XCTUnwrap(
+            RenderResourceStore().effectTargets(.bloomChain, width: 64, height: 32, device: device)
+        ).textures
+        let queue = try XCTUnwrap(device.makeCommandQueue())
+        let commandBuffer = try XCTUnwrap(queue.makeCommandBuffer())
+        let inputs = BloomChain.Inputs(width: 128, height: 64, threshold: 0.45, gain: 1.5)
+
+        XCTAssertFalse(chain.isCurrent(for: inputs))
+        let halo = try XCTUnwrap(chain.encode(
+            commandBuffer: commandBuffer, scene: scene, downLevels: downLevels, inputs: inputs, sceneChanged: true
+        ))
+        XCTAssertEqual(halo.width, 64)
+        XCTAssertTrue(chain.isCurrent(for: inputs))
+
+        let reused = chain.encode(
+            commandBuffer: commandBuffer, scene: scene, downLevels: downLevels, inputs: inputs, sceneChanged: false
+        )
+        XCTAssertTrue(reused === halo)
+
+        var pulsed = inputs
+        pulsed.gain = 1.4
+        XCTAssertFalse(chain.isCurrent(for: pulsed))
+        XCTAssertNotNil(chain.encode(
+            commandBuffer: commandBuffer, scene: scene, downLevels: downLevels, inputs: pulsed, sceneChanged: false
+        ))
+        XCTAssertTrue(chain.isCurrent(for: pulsed))
+
+        commandBuffer.commit()
+        commandBuffer.waitUntilCompleted()
+        XCTAssertEqual(commandBuffer.status, .completed)
+    }
+
+    func testReleasingTexturesDropsTheCache() throws {
+        let device = try makeDevice()
+        let chain = try makeChain(device: device)
+        let scene = try makeScene(device: device, width: 64, height: 64)
+        let downLevels = try XCTUnwrap(
+            RenderResourceStore().effectTargets(.bloomChain, width: 32, height: 32, device: device)
+        ).textures
+        let commandBuffer = try XCTUnwrap(device.makeCommandQueue()?.makeCommandBuffer())
+        let inputs = BloomChain.Inputs(width: 64, height: 64, threshold: 0.5, gain: 1)
+
+        _ = chain.encode(commandBuffer: commandBuffer, scene: scene, downLevels: downLevels, inputs: inputs, sceneChanged: true)
+        chain.releaseTextures()
+        XCTAssertFalse(chain.isCurrent(for: inputs))
+        XCTAssertNil(chain.encode(
+            commandBuffer: commandBuffer, scene: scene, downLevels: Array(downLevels.prefix(1)), inputs: inputs, sceneChanged: false
+        ))
+        commandBuffer.commit()
+    }
+}
+#endif
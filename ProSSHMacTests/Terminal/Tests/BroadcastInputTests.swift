@@ -0,0 +1,254 @@
+// BroadcastInputTests.swift
+// ProSSHV2
+//
+// Broadcast fan-out: one encode per distinct input mode, concurrent writes,
+// and per-target failures that leave the other targets unaffected.
+
+#if canImport(XCTest)
+import XCTest
+@testable import ProSSHMac
+
+@MainActor
+final class BroadcastInputTests: XCTestCase {
+
+    // MARK: - Helpers
+
+    private func makeManager() -> SessionManager {
+        SessionManager(
+            transport: MockSSHTransport(),
+            knownHostsStore: BroadcastTestKnownHostsStore()
+        )
+    }
+
+    private func connect(_ manager: SessionManager, channel: any SSHShellChannel) async throws -> UUID {
+        let session = try await manager.connect(to: makeHost())
+        manager.shellChannels[session.id] = channel
+        return session.id
+    }
+
+    private func makeHost() -> ProSSHMac.Host {
+        ProSSHMac.Host(
+            id: UUID(),
+            label: "Broadcast Test Host",
+            folder: nil,
+            hostname: "broadcast.test.local",
+            port: 22,
+            username: "ops",
+            authMethod: .password,
+            keyReference: nil,
+            certificateReference: nil,
+            passwordReference: nil,
+            jumpHost: nil,
+            algorithmPreferences: nil,
+            pinnedHostKeyAlgorithms: [],
+            agentForwardingEnabled: false,
+            legacyModeEnabled: false,
+            tags: [],
+            notes: nil,
+            lastConnected: nil,
+            createdAt: .now
+        )
+    }
+
+    private func arrowUp(encodeCount: @escaping () -> Void) -> BroadcastKeyInput {
+        let encoder = { (options: KeyEncoderOptions) -> [UInt8]? in
+            KeyEncoder(options: options).encode(KeyEvent(key: .arrow(.up)))
+        }
+        return BroadcastKeyInput(
+            options: .default,
+            bytes: encoder(.default) ?? [],
+            eventType: "arrow",
+            encode: { options in
+                encodeCount()
+                return encoder(options)
+            }
+        )
+    }
+
+    // MARK: - Tests
+
+    func testReEncodesOnlyForTargetsWithDifferentModes() async throws {
+        let manager = makeManager()
+        let normalA = RecordingShellChannel()
+        let normalB = RecordingShellChannel()
+        let cursorApp = RecordingShellChannel()
+        let idA = try await connect(manager, channel: normalA)
+        let idB = try await connect(manager, channel: normalB)
+        let idApp = try await connect(manager, channel: cursorApp)
+        var modes = InputModeSnapshot.default
+        modes.applicationCursorKeys = true
+        manager.liveState(for: idApp).inputModeSnapshot = modes
+
+        var encodeCount = 0
+        let failures = await manager.broadcastShellInput(
+            arrowUp { encodeCount += 1 },
+            to: [idA, idB, idApp]
+        )
+
+        XCTAssertEqual(failures, [])
+        XCTAssertEqual(encodeCount, 1, "Only the application-cursor target needs its own encoding")
+        let payloadA = await normalA.payloads
+        let payloadB = await normalB.payloads
+        let payloadApp = await cursorApp.payloads
+        XCTAssertEqual(payloadA, [[0x1B, 0x5B, 0x41]])
+        XCTAssertEqual(payloadB, [[0x1B, 0x5B, 0x41]])
+        XCTAssertEqual(payloadApp, [[0x1B, 0x4F, 0x41]])
+    }
+
+    func testSlowTargetDoesNotDelayTheOthers() async throws {
+        let manager = makeManager()
+        let slow = GatedShellChannel()
+        let fast = RecordingShellChannel()
+        let slowID = try await connect(manager, channel: slow)
+        let fastID = try await connect(manager, channel: fast)
+
+        let input = BroadcastKeyInput(bytes: Array("x".utf8), eventType: "character")
+        let broadcast = Task {
+            await manager.broadcastShellInput(input, to: [slowID, fastID])
+        }
+
+        let deadline = Date().addingTimeInterval(2)
+        while await fast.payloads.isEmpty, Date() < deadline {
+            await Task.yield()
+        }
+        let fastPayloads = await fast.payloads
+        XCTAssertEqual(fastPayloads, [Array("x".utf8)], "The fast target is written while the slow one is still blocked")
+        let slowPayloadsBeforeOpen = await slow.payloads
+        XCTAssertEqual(slowPayloadsBeforeOpen, [])
+
+        await slow.open()
+        let failures = await broadcast.value
+        XCTAssertEqual(failures, [])
+        let slowPayloads = await slow.payloads
+        XCTAssertEqual(slowPayloads, [Array("x".utf8)])
+    }
+
+    func testFailuresAreReportedPerTarget() async throws {
+        let manager = makeManager()
+        let healthy = RecordingShellChannel()
+        let healthyID = try await connect(manager, channel: healthy)
+        let brokenID = try await connect(manager, channel: FailingShellChannel())
+        let unknownID = UUID()
+
+        let input = BroadcastKeyInput(bytes: [0x03], eventType: "control")
+        let failures = await manager.broadcastShellInput(input, to: [brokenID, unknownID, healthyID])
+
+        XCTAssertEqual(Set(failures.map(\.sessionID)), [brokenID, unknownID])
+        XCTAssertEqual(failures.first { $0.sessionID == unknownID }?.reason, .disconnected)
+        guard case .sendFailed = failures.first(where: { $0.sessionID == brokenID })?.reason else {
+            return XCTFail("Expected a send failure for the broken channel")
+        }
+        let healthyPayloads = await healthy.payloads
+        XCTAssertEqual(healthyPayloads, [[0x03]])
+        XCTAssertEqual(manager.liveState(for: healthyID).traffic.sent, 1)
+    }
+}
+
+// MARK: - Test Doubles
+
+private actor RecordingShellChannel: SSHShellChannel {
+    nonisolated let rawOutput: AsyncStream<Data>
+    private let continuation: AsyncStream<Data>.Continuation
+    private(set) var payloads: [[UInt8]] = []
+
+    init() {
+        var captured: AsyncStream<Data>.Continuation?
+        self.rawOutput = AsyncStream<Data> { captured = $0 }
+        self.continuation = captured!
+    }
+
+    func send(_ input: String) async throws {
+        payloads.append(Array(input.utf8))
+    }
+
+    func send(bytes: [UInt8]) async throws {
+        payloads.append(bytes)
+    }
+
+    func resizePTY(columns: Int, rows: Int) async throws {}
+
+    func close() async {
+        continuation.finish()
+    }
+}
+
+/// Holds every write until `open()`.
+private actor GatedShellChannel: SSHShellChannel {
+    nonisolated let rawOutput: AsyncStream<Data>
+    private let continuation: AsyncStream<Data>.Continuation
+    private(set) var payloads: [[UInt8]] = []
+    private var isOpen = false
+    private var waiters: [CheckedContinuation<Void, Never>] = []
+
+    init() {
+        var captured: AsyncStream<Data>.Continuation?
+        self.rawOutput = AsyncStream<Data> { captured = $0 }
+        self.continuation = captured!
+    }
+
+    func open() {
+        isOpen = true
+        waiters.forEach { $0.resume() }
+        waiters.removeAll()
+    }
+
+    func send(_ input: String) async throws {
+        try await send(bytes: Array(input.utf8))
+    }
+
+    func send(bytes: [UInt8]) async throws {
+        if !isOpen {
+            await withCheckedContinuation { waiters.append($0) }
+        }
+        payloads.append(bytes)
+    }
+
+    func resizePTY(columns: Int, rows: Int) async throws {}
+
+    func close() async {
+        continuation.finish()
+    }
+}
+
+private actor FailingShellChannel: SSHShellChannel {
+    nonisolated let rawOutput: AsyncStream<Data>
+    private let continuation: AsyncStream<Data>.Continuation
+
+    init() {
+        var captured: AsyncStream<Data>.Continuation?
+        self.rawOutput = AsyncStream<Data> { captured = $0 }
+        self.continuation = captured!
+    }
+
+    func send(_ input: String) async throws {
+        throw SSHTransportError.sessionNotFound
+    }
+
+    func send(bytes: [UInt8]) async throws {
+        throw SSHTransportError.sessionNotFound
+    }
+
+    func resizePTY(columns: Int, rows: Int) async throws {}
+
+    func close() async {
+        continuation.finish()
+    }
+}
+
+private actor BroadcastTestKnownHostsStore: KnownHostsStoreProtocol {
+    func allEntries() async throws -> [KnownHostEntry] { [] }
+
+    func evaluate(
+        hostname: String,
+        port: UInt16,
+        hostKeyType: String,
+        presentedFingerprint: String
+    ) async throws -> KnownHostVerificationResult {
+        .trusted
+    }
+
+    func trust(challenge: KnownHostVerificationChallenge) async throws {}
+
+    func clearAll() async throws {}
+}
+#endif
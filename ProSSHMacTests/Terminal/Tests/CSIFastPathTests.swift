@@ -0,0 +1,81 @@
+// CSIFastPathTests.swift
+// ProSSHV2
+//
+// Whole-sequence CSI recognizer: accepted/rejected shapes and grid parity
+// with the byte-at-a-time state machine.
+
+#if canImport(XCTest)
+import XCTest
+@testable import ProSSHMac
+
+final class CSIFastPathTests: XCTestCase {
+
+    private func scan(_ text: String) -> (finalByte: UInt8, end: Int, groups: [[Int]])? {
+        let bytes = Array(text.utf8)
+        var params = CSIParams()
+        let match = bytes.withUnsafeBytes { CSIFastPath.scan($0, at: 0, into: &params) }
+        return match.map { ($0.finalByte, $0.end, params.groups) }
+    }
+
+    // MARK: - Recognition
+
+    func testRecognizesCommonSequencesWithStateMachineParams() {
+        XCTAssertEqual(scan("\u{1B}[m")?.groups, [])
+        XCTAssertEqual(scan("\u{1B}[0m")?.groups, [[0]])
+        XCTAssertEqual(scan("\u{1B}[1;31mX")?.groups, [[1], [31]])
+        XCTAssertEqual(scan("\u{1B}[1;31mX")?.end, 7)
+        XCTAssertEqual(scan("\u{1B}[38;5;208m")?.groups, [[38], [5], [208]])
+        XCTAssertEqual(scan("\u{1B}[;7H")?.groups, [[0], [7]])
+        XCTAssertEqual(scan("\u{1B}[K")?.finalByte, 0x4B)
+    }
+
+    func testDefersUnusualSequencesToFullParser() {
+        for text in [
+            "\u{1B}[?25h",          // private marker
+            "\u{1B}[38:2::1:2:3m",  // colon subparameters
+            "\u{1B}[2 q",           // intermediate
+            "\u{1B}[6n",            // reply-producing final
+            "\u{1B}[1;3",           // split across chunks
+            "\u{1B}[1\n;3m",        // embedded control
+            "\u{1B}]0;title\u{07}", // not CSI
+        ] {
+            XCTAssertNil(scan(text), text.debugDescription)
+        }
+    }
+}
+
+final class CSIFastPathParityTests: XCTestCase {
+
+    private let stream = "\u{1B}[2J\u{1B}[H\u{1B}[1;31mred\u{1B}[0m \u{1B}[38;5;208mamber\u{1B}[m"
+        + "\u{1B}[3;5Hx\u{1B}[K\u{1B}[2Dy\u{1B}[10Gz\u{1B}[4dw\u{1B}[;;;;;;;;;;;;;;;;;;1m!"
+
+    private func render(bytewise: Bool) async -> [String] {
+        let engine = TerminalEngine(columns: 40, rows: 8)
+        let bytes = Array(stream.utf8)
+        if bytewise {
+            for byte in bytes { await engine.feed([byte]) }
+        } else {
+            await engine.feed(bytes)
+        }
+        let grid = await engine.grid
+        var lines: [String] = []
+        for row in 0..<8 {
+            var line = ""
+            for col in 0..<40 {
+                guard let cell = await grid.cellAt(row: row, col: col) else { continue }
+                line += "\(cell.graphemeCluster)|\(cell.fgColor)|\(cell.attributes.rawValue);"
+            }
+            lines.append(line)
+        }
+        let cursor = await grid.cursorPosition()
+        lines.append("\(cursor.row),\(cursor.col)")
+        return lines
+    }
+
+    func testWholeChunkMatchesByteAtATimeParsing() async {
+        let fast = await render(bytewise: false)
+        let slow = await render(bytewise: true)
+        XCTAssertEqual(fast, slow)
+    }
+}
+#endif
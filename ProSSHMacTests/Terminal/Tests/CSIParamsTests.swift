@@ -0,0 +1,94 @@
+// CSIParamsTests.swift
+// ProSSHV2
+//
+// Inline CSI parameter storage and the synchronous dispatch path.
+
+#if canImport(XCTest)
+import XCTest
+@testable import ProSSHMac
+
+final class CSIParamsTests: XCTestCase {
+
+    // MARK: - Storage
+
+    func testGroupsKeepSubparametersTogether() {
+        var params = CSIParams()
+        params.appendParam(38)
+        params.appendSubparam(2)
+        params.appendSubparam(0)
+        params.appendSubparam(255)
+        params.appendSubparam(0)
+        params.appendSubparam(0)
+        params.appendParam(1)
+
+        XCTAssertEqual(params.count, 2)
+        XCTAssertEqual(params.valueCount, 7)
+        XCTAssertEqual(params.groupLength(0), 6)
+        XCTAssertEqual(params.groupLength(1), 1)
+        XCTAssertEqual(params[0, 3], 255)
+        XCTAssertEqual(params[1], 1)
+        XCTAssertEqual(params.groups, [[38, 2, 0, 255, 0, 0], [1]])
+    }
+
+    func testLimitsDropExcessParametersInsteadOfGrowing() {
+        var params = CSIParams()
+        for value in 0..<(ParserLimits.maxParams + 4) {
+            params.appendParam(value)
+        }
+        XCTAssertEqual(params.count, ParserLimits.maxParams)
+
+        for _ in 0..<CSIParams.capacity {
+            params.appendSubparam(7)
+        }
+        XCTAssertEqual(params.valueCount, CSIParams.capacity)
+
+        params.removeAll()
+        XCTAssertTrue(params.isEmpty)
+        XCTAssertEqual(params.valueCount, 0)
+    }
+
+    func testSubparameterWithoutGroupIsIgnored() {
+        var params = CSIParams()
+        params.appendSubparam(5)
+        XCTAssertTrue(params.isEmpty)
+    }
+}
+
+final class SynchronousDispatchTests: XCTestCase {
+
+    private var engine: TerminalEngine!
+    private var grid: TerminalGrid!
+    private var responses: [[UInt8]]!
+
+    override func setUp() async throws {
+        engine = TerminalEngine(columns: 80, rows: 24)
+        grid = await engine.grid
+        responses = []
+
+        await engine.setResponseHandler { @Sendable [weak self] bytes in
+            self?.responses.append(bytes)
+        }
+    }
+
+    // MARK: - SGR
+
+    func testColonAndSemicolonTruecolorInOneSequence() async {
+        await engine.feed(Array("\u{1B}[38:2::10:20:30;48;2;40;50;60;4:3mX".utf8))
+
+        let cell = await grid.cellAt(row: 0, col: 0)
+        XCTAssertEqual(cell?.fgColor, .rgb(10, 20, 30))
+        XCTAssertEqual(cell?.bgColor, .rgb(40, 50, 60))
+        XCTAssertEqual(cell?.underlineStyle, .curly)
+    }
+
+    // MARK: - Replies
+
+    func testReplyReflectsSequencesBeforeItInTheSameChunk() async {
+        await engine.feed(Array("\u{1B}[5;10H\u{1B}[1;31m\u{1B}[6nabc".utf8))
+
+        XCTAssertEqual(responses, [Array("\u{1B}[5;10R".utf8)])
+        let pos = await grid.cursorPosition()
+        XCTAssertEqual(pos.col, 12, "bytes after the reply are still parsed")
+    }
+}
+#endif
@@ -0,0 +1,107 @@
+// CellArenaTests.swift
+// ProSSHV2
+//
+// Flat screen-buffer storage: copy-on-write between copies, row copies,
+// overlapping in-row moves, and the grid operations built on them.
+
+#if canImport(XCTest)
+import XCTest
+@testable import ProSSHMac
+
+final class CellArenaTests: XCTestCase {
+
+    // MARK: - Helpers
+
+    private func cell(_ char: Character) -> TerminalCell {
+        TerminalCell(
+            codepoint: char.unicodeScalars.first!.value, fgPacked: 0, bgPacked: 0, ulPacked: 0,
+            attributes: [], underlineStyle: .none, width: 1
+        )
+    }
+
+    private func text(_ row: CellRow) -> String {
+        String(row.map { $0.codepoint == 0 ? " " : Character(UnicodeScalar($0.codepoint)!) })
+    }
+
+    private func rowText(_ grid: TerminalGrid, _ row: Int) -> String {
+        String((0..<grid.columns).map { col -> Character in
+            let codepoint = grid.cellAt(row: row, col: col)?.codepoint ?? 0
+            return codepoint == 0 ? " " : Character(UnicodeScalar(codepoint)!)
+        })
+    }
+
+    // MARK: - Storage
+
+    func testCopiesAreIndependentAfterWrite() {
+        var arena = CellArena(rows: 2, columns: 3)
+        arena.replaceRow(0, with: "abc".map(cell))
+        var copy = arena
+        copy[0, 1] = cell("X")
+
+        XCTAssertEqual(text(arena[0]), "abc")
+        XCTAssertEqual(text(copy[0]), "aXc")
+    }
+
+    func testReplaceRowPadsAndTrims() {
+        var arena = CellArena(rows: 2, columns: 4)
+        arena.replaceRow(0, with: "ab".map(cell))
+        arena.replaceRow(1, with: "abcdef".map(cell))
+
+        XCTAssertEqual(text(arena[0]), "ab  ")
+        XCTAssertEqual(text(arena[1]), "abcd")
+    }
+
+    func testCopyAndFillRow() {
+        var arena = CellArena(rows: 3, columns: 3)
+        arena.replaceRow(0, with: "abc".map(cell))
+        arena.copyRow(0, to: 2)
+        arena.fillRow(0, with: cell("-"))
+
+        XCTAssertEqual(text(arena[0]), "---")
+        XCTAssertEqual(text(arena[2]), "abc")
+    }
+
+    func testOverlappingMovesInRow() {
+        var arena = CellArena(rows: 1, columns: 6)
+        arena.replaceRow(0, with: "abcdef".map(cell))
+        arena.moveCells(inRow: 0, from: 0, to: 2, count: 4)
+        XCTAssertEqual(text(arena[0]), "ababcd")
+
+        arena.moveCells(inRow: 0, from: 2, to: 0, count: 4)
+        XCTAssertEqual(text(arena[0]), "abcdcd")
+    }
+
+    func testRowViewSurvivesArenaReassignment() {
+        var arena = CellArena(rows: 1, columns: 3)
+        arena.replaceRow(0, with: "abc".map(cell))
+        let row = arena[0]
+        arena = CellArena(rows: 1, columns: 3)
+
+        XCTAssertEqual(text(row), "abc")
+    }
+
+    // MARK: - Grid Operations
+
+    func testInsertAndDeleteCharacters() async {
+        let engine = TerminalEngine(columns: 8, rows: 2)
+        await engine.feed(Array("abcdefgh\r\u{1B}[3C\u{1B}[2@".utf8))
+        let grid = await engine.grid
+        XCTAssertEqual(rowText(grid, 0), "abc  def")
+
+        await engine.feed(Array("\u{1B}[3P".utf8))
+        XCTAssertEqual(rowText(grid, 0), "abcef   ")
+    }
+
+    func testInsertAndDeleteLinesInScrollRegion() async {
+        let engine = TerminalEngine(columns: 4, rows: 4)
+        await engine.feed(Array("aaaa\r\nbbbb\r\ncccc\r\ndddd".utf8))
+        await engine.feed(Array("\u{1B}[2;4r\u{1B}[2;1H\u{1B}[L".utf8))
+        let grid = await engine.grid
+        XCTAssertEqual((0..<4).map { rowText(grid, $0) }, ["aaaa", "    ", "bbbb", "cccc"])
+
+        await engine.feed(Array("\u{1B}[M".utf8))
+        XCTAssertEqual((0..<4).map { rowText(grid, $0) }, ["aaaa", "bbbb", "cccc", "    "])
+    }
+}
+
+#endif
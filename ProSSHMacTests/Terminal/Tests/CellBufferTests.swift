@@ -0,0 +1,220 @@
+// CellBufferTests.swift
+// ProSSHV2
+//
+// The cell buffer ring: every buffer matches the latest snapshot when it
+// becomes the read buffer, and partial updates copy only the damage the
+// write buffer missed instead of a full-screen baseline. Full-screen
+// scrolls of compact cells rotate row bases instead of copying.
+
+#if canImport(XCTest)
+import XCTest
+import Metal
+@testable import ProSSHMac
+
+final class CellBufferTests: XCTestCase {
+
+    private let columns = 10
+    private let rows = 4
+
+    private func makeDevice() throws -> MTLDevice {
+        guard let device = MTLCreateSystemDefaultDevice() else {
+            throw XCTSkip("No Metal device available")
+        }
+        return device
+    }
+
+    /// Cells whose glyph is `generation * 1000 + index`.
+    private func cells(generation: UInt32) -> ContiguousArray<CellInstance> {
+        ContiguousArray((0..<(columns * rows)).map { index in
+            CellInstance(
+                row: UInt16(index / columns), col: UInt16(index % columns),
+                glyphIndex: generation * 1000 + UInt32(index),
+                fgColor: 0, bgColor: 0, underlineColor: 0,
+                attributes: 0, flags: 0, underlineStyle: 0
+            )
+        })
+    }
+
+    private func snapshot(_ cells: ContiguousArray<CellInstance>, damage: [Range<Int>]?) -> GridSnapshot {
+        var snapshot = GridSnapshot(
+            cells: cells,
+            dirtyRange: damage.map { ranges in
+                (ranges.map(\.lowerBound).min() ?? 0)..<(ranges.map(\.upperBound).max() ?? 0)
+            },
+            cursorRow: 0,
+            cursorCol: 0,
+            cursorVisible: true,
+            cursorStyle: .block,
+            columns: columns,
+            rows: rows,
+            usingAlternateBuffer: false,
+            graphemeOverrides: nil
+        )
+        snapshot.damagedRanges = damage
+        return snapshot
+    }
+
+    private func readGlyphs(_ buffer: CellBuffer) throws -> [UInt32] {
+        let read = try XCTUnwrap(buffer.readBuffer)
+        let cells = read.contents().bindMemory(to: CellInstance.self, capacity: buffer.cellCount)
+        return (0..<buffer.cellCount).map { cells[$0].glyphIndex }
+    }
+
+    // MARK: - Replay
+
+    func testPartialUpdatesReplayMissedDamage() throws {
+        let buffer = CellBuffer(device: try makeDevice(), bufferCount: 3)
+        var current = cells(generation: 1)
+        buffer.update(from: snapshot(current, damage: nil))
+        buffer.swapBuffers()
+        XCTAssertEqual(try readGlyphs(buffer), current.map(\.glyphIndex))
+
+        // Fill the rest of the ring, then keep damaging different rows.
+        for step in 0..<8 {
+            let row = step % rows
+            let damaged = (row * columns)..<((row + 1) * columns)
+            let next = cells(generation: UInt32(step + 2))
+            for index in damaged { current[index] = next[index] }
+
+            buffer.update(from: snapshot(current, damage: [damaged]))
+            buffer.swapBuffers()
+            XCTAssertEqual(try readGlyphs(buffer), current.map(\.glyphIndex), "step \(step)")
+        }
+    }
+
+    func testSteadyStateCopiesOnlyDamage() throws {
+        let buffer = CellBuffer(device: try makeDevice(), bufferCount: 2)
+        var current = cells(generation: 1)
+        buffer.update(from: snapshot(current, damage: nil))
+        buffer.swapBuffers()
+        // Unchanged frame: the second buffer loads in full, nothing is missed.
+        buffer.update(from: snapshot(current, damage: []))
+        buffer.swapBuffers()
+
+        let row = 0..<columns
+        current[0].glyphIndex = 42
+        buffer.update(from: snapshot(current, damage: [row]))
+        buffer.swapBuffers()
+        XCTAssertEqual(buffer.lastUploadedCellCount, columns)
+
+        // The other buffer replays row 0 and applies row 2.
+        let rowTwo = (2 * columns)..<(3 * columns)
+        current[2 * columns].glyphIndex = 43
+        buffer.update(from: snapshot(current, damage: [rowTwo]))
+        buffer.swapBuffers()
+        XCTAssertEqual(buffer.lastUploadedCellCount, 2 * columns)
+        XCTAssertEqual(try readGlyphs(buffer), current.map(\.glyphIndex))
+    }
+
+    func testEmptyDamageStillCatchesUpWriteBuffer() throws {
+        let buffer = CellBuffer(device: try makeDevice(), bufferCount: 2)
+        var current = cells(generation: 1)
+        buffer.update(from: snapshot(current, damage: nil))
+        buffer.swapBuffers()
+        // Unchanged frame: the second buffer loads in full, nothing is missed.
+        buffer.update(from: snapshot(current, damage: []))
+        buffer.swapBuffers()
+
+        current[5].glyphIndex = 7
+        buffer.update(from: snapshot(current, damage: [5..<6]))
+        buffer.swapBuffers()
+        buffer.update(from: snapshot(current, damage: []))
+        buffer.swapBuffers()
+        XCTAssertEqual(try readGlyphs(buffer), current.map(\.glyphIndex))
+    }
+
+    // MARK: - Scroll Rotation
+
+    /// Compact rows whose codepoints are `lineNumber * 100 + col`.
+    private func compactCells(firstLine: Int) -> ContiguousArray<TerminalCell> {
+        ContiguousArray((0..<(columns * rows)).map { index in
+            var cell = TerminalCell.blank
+            cell.codepoint = UInt32((firstLine + index / columns) * 100 + index % columns)
+            return cell
+        })
+    }
+
+    private func compactSnapshot(
+        firstLine: Int,
+        sequence: UInt64,
+        scrolledLines: Int?
+    ) -> GridSnapshot {
+        var snapshot = GridSnapshot(
+            cells: [],
+            dirtyRange: 0..<(columns * rows),
+            cursorRow: 0,
+            cursorCol: 0,
+            cursorVisible: true,
+            cursorStyle: .block,
+            columns: columns,
+            rows: rows,
+            usingAlternateBuffer: false,
+            graphemeOverrides: nil,
+            compactCells: compactCells(firstLine: firstLine)
+        )
+        snapshot.damagedRanges = [0..<(columns * rows)]
+        snapshot.sequence = sequence
+        if let scrolledLines {
+            snapshot.scroll = GridSnapshotScroll(
+                baseSequence: sequence - 1,
+                delta: GridScrollDelta(region: 0...(rows - 1), lines: scrolledLines),
+                rewrittenRanges: [((rows - scrolledLines) * columns)..<(rows * columns)]
+            )
+        }
+        return snapshot
+    }
+
+    /// The read buffer's compact codepoints in grid order.
+    private func readCompactCodepoints(_ buffer: CellBuffer) throws -> [UInt32] {
+        let read = try XCTUnwrap(buffer.readBuffer)
+        let cells = read.contents().bindMemory(to: TerminalCell.self, capacity: buffer.cellCount)
+        return (0..<buffer.cellCount).map { index in
+            let physicalRow = (index / columns + buffer.readRowBase) % rows
+            return cells[physicalRow * columns + index % columns].codepoint
+        }
+    }
+
+    func testFullScreenScrollUploadsOnlyExposedRows() throws {
+        let buffer = CellBuffer(device: try makeDevice(), bufferCount: 3)
+        var sequence: UInt64 = 1
+        buffer.update(from: compactSnapshot(firstLine: 0, sequence: sequence, scrolledLines: nil))
+        buffer.swapBuffers()
+
+        for line in 1...9 {
+            sequence += 1
+            let snapshot = compactSnapshot(firstLine: line, sequence: sequence, scrolledLines: 1)
+            buffer.update(from: snapshot)
+            buffer.swapBuffers()
+            XCTAssertEqual(
+                try readCompactCodepoints(buffer),
+                snapshot.compactCells?.map(\.codepoint),
+                "line \(line)"
+            )
+            // Once every buffer has been written, each scroll costs a row
+            // per buffer behind, not the screen.
+            if line > 3 {
+                XCTAssertEqual(buffer.lastUploadedCellCount, 3 * columns, "line \(line)")
+            }
+        }
+    }
+
+    func testRepeatedSnapshotDoesNotRotateAgain() throws {
+        let buffer = CellBuffer(device: try makeDevice(), bufferCount: 2)
+        buffer.update(from: compactSnapshot(firstLine: 0, sequence: 1, scrolledLines: nil))
+        buffer.swapBuffers()
+        let scrolled = compactSnapshot(firstLine: 1, sequence: 2, scrolledLines: 1)
+        buffer.update(from: scrolled)
+        buffer.swapBuffers()
+        buffer.update(from: scrolled)
+        buffer.swapBuffers()
+        XCTAssertEqual(try readCompactCodepoints(buffer), scrolled.compactCells?.map(\.codepoint))
+    }
+
+    // MARK: - Ranges
+
+    func testCoalesceMergesOverlapsAndAdjacency() {
+        XCTAssertEqual(CellBuffer.coalesce([10..<20, 0..<5, 5..<8, 15..<30, 40..<40]), [0..<8, 10..<30])
+        XCTAssertEqual(CellBuffer.coalesce([]), [])
+    }
+}
+#endif
@@ -0,0 +1,83 @@
+// CellDrawListsTests.swift
+// ProSSHV2
+//
+// Cell pass culling: blank default-background cells cost only their share
+// of a background run, equal backgrounds merge into one run per span, and
+// only cells that draw more than a background reach the cell shader.
+
+#if canImport(XCTest)
+import XCTest
+@testable import ProSSHMac
+
+final class CellDrawListsTests: XCTestCase {
+
+    private let columns = 8
+    private let rows = 3
+
+    private func blankGrid() -> ContiguousArray<CellInstance> {
+        ContiguousArray((0..<(columns * rows)).map { index in
+            CellInstance(
+                row: UInt16(index / columns), col: UInt16(index % columns),
+                glyphIndex: 0,
+                fgColor: 0, bgColor: 0, underlineColor: 0,
+                attributes: 0, flags: 0, underlineStyle: 0
+            )
+        })
+    }
+
+    // MARK: - Runs
+
+    func testBlankGridIsOneRunPerRowAndNoCells() {
+        let lists = CellDrawLists(cells: blankGrid(), columns: columns, rows: rows)
+        XCTAssertEqual(lists.backgroundRuns.count, rows)
+        XCTAssertTrue(lists.backgroundRuns.allSatisfy { $0.col == 0 && $0.count == UInt16(columns) })
+        XCTAssertTrue(lists.cellIndices.isEmpty)
+    }
+
+    func testColouredSpansSplitRunsAndZeroAlphaMerges() {
+        var cells = blankGrid()
+        for col in 2..<5 { cells[col].bgColor = 0x3366_99FF }
+        // Different RGB but zero alpha: still the default background.
+        cells[6].bgColor = 0x1234_5600
+
+        let lists = CellDrawLists(cells: cells, columns: columns, rows: rows)
+        let firstRow = Array(lists.backgroundRuns[lists.runs(inRows: 0..<1)])
+        XCTAssertEqual(firstRow.map(\.col), [0, 2, 5])
+        XCTAssertEqual(firstRow.map(\.count), [2, 3, 3])
+        XCTAssertEqual(firstRow.map(\.bgColor), [0, 0x3366_99FF, 0])
+    }
+
+    // MARK: - Cells
+
+    func testOnlyCellsWithContentReachTheCellShader() {
+        var cells = blankGrid()
+        cells[1].glyphIndex = 0x41                                          // glyph
+        cells[2].glyphIndex = 0x20                                          // space: blank
+        cells[3].attributes = CellAttributes.underline.rawValue             // decoration
+        cells[9].attributes = CellAttributes.reverse.rawValue               // reverse video
+        cells[10].flags = CellInstance.flagSelected                         // selection
+        cells[11].glyphIndex = 0x42
+        cells[11].attributes = CellAttributes.hidden.rawValue               // hidden: blank
+        cells[17].underlineStyle = 3                                        // curly underline
+
+        let lists = CellDrawLists(cells: cells, columns: columns, rows: rows)
+        XCTAssertEqual(lists.cellIndices, [1, 3, 9, 10, 17])
+        XCTAssertEqual(lists.cells(inRows: 1..<2), 2..<4)
+        XCTAssertEqual(lists.cells(inRows: 1..<10), 2..<5)
+    }
+
+    func testWideContinuationTakesPrimaryBackground() {
+        var cells = blankGrid()
+        cells[4].glyphIndex = 0x4E2D
+        cells[4].attributes = CellAttributes.wideChar.rawValue
+        cells[4].bgColor = 0xAA00_00FF
+        cells[5].bgColor = 0
+
+        let lists = CellDrawLists(cells: cells, columns: columns, rows: rows)
+        let firstRow = Array(lists.backgroundRuns[lists.runs(inRows: 0..<1)])
+        XCTAssertEqual(firstRow.map(\.col), [0, 4, 6])
+        XCTAssertEqual(firstRow.map(\.count), [4, 2, 2])
+        XCTAssertEqual(lists.cellIndices, [4])
+    }
+}
+#endif
@@ -0,0 +1,164 @@
+// CertificateBatchIssuanceTests.swift
+// ProSSHV2
+//
+// Bulk certificate issuance: inventory CSV parsing, rows rejected before
+// signing, and directory export of issued certificates.
+
+#if canImport(XCTest)
+import XCTest
+@testable import ProSSHMac
+
+final class CertificateBatchIssuanceTests: XCTestCase {
+
+    private final class MemoryCertificateStore: CertificateStoreProtocol {
+        var saved: [[SSHCertificate]] = []
+        func loadCertificates() async throws -> [SSHCertificate] { saved.last ?? [] }
+        func saveCertificates(_ certificates: [SSHCertificate]) async throws { saved.append(certificates) }
+    }
+
+    private final class MemoryAuthorityStore: CertificateAuthorityStoreProtocol {
+        var saved: [[CertificateAuthorityModel]] = []
+        func loadAuthorities() async throws -> [CertificateAuthorityModel] { saved.last ?? [] }
+        func saveAuthorities(_ authorities: [CertificateAuthorityModel]) async throws { saved.append(authorities) }
+    }
+
+    private let certificateStore = MemoryCertificateStore()
+
+    private func makeService() -> CertificateAuthorityService {
+        CertificateAuthorityService(
+            authorityStore: MemoryAuthorityStore(),
+            certificateStore: certificateStore,
+            secureEnclaveKeyManager: SecureEnclaveKeyManager()
+        )
+    }
+
+    private let authority = CertificateAuthorityModel(
+        id: UUID(),
+        label: "Fleet CA",
+        keyType: .ecdsa,
+        publicKeyFingerprint: "SHA256:fleet",
+        publicKeyAuthorizedFormat: "ecdsa-sha2-nistp256 AAAAE2VjZHNhLXNoYTItbmlzdHAyNTYAAAAIbmlzdHAyNTYAAABBBA==",
+        secureEnclaveReference: "test.fleet-ca",
+        certificateType: .host,
+        defaultValidityDuration: 86_400,
+        nextSerialNumber: 10,
+        issuedCertificateCount: 0,
+        createdAt: .now,
+        notes: nil
+    )
+
+    // MARK: - Inventory
+
+    func testInventorySkipsHeaderCommentsAndKeepsCommasInKeyComments() throws {
+        let subjects = try BatchCertificateIssuanceDraft.parseInventory("""
+        key_id,principals,public_key
+        # rack 4
+        web-01,web-01.example.com;10.0.0.1,ssh-ed25519 AAAAC3Nza host, rack 4
+
+        db-01,,ssh-ed25519 AAAAC3Nzb
+        """)
+
+        XCTAssertEqual(subjects.map(\.keyID), ["web-01", "db-01"])
+        XCTAssertEqual(subjects[0].principals, ["web-01.example.com", "10.0.0.1"])
+        XCTAssertEqual(subjects[0].subjectPublicKeyAuthorized, "ssh-ed25519 AAAAC3Nza host, rack 4")
+        XCTAssertEqual(subjects[1].principals, [])
+    }
+
+    func testInventoryRejectsRowsWithoutAKey() {
+        XCTAssertThrowsError(try BatchCertificateIssuanceDraft.parseInventory("web-01,web-01.example.com")) { error in
+            XCTAssertTrue(error.localizedDescription.contains("line 1"))
+        }
+    }
+
+    // MARK: - Issuance
+
+    func testBatchWithNoEncodableRowsFailsBeforeSigningOrSaving() async {
+        let request = BatchCertificateIssuanceRequest(
+            authorityID: authority.id,
+            role: .host,
+            subjects: [
+                BatchCertificateSubject(keyID: "web-01", principals: [], subjectPublicKeyAuthorized: "not a key"),
+                BatchCertificateSubject(keyID: " ", principals: [], subjectPublicKeyAuthorized: "ssh-ed25519 AAAA")
+            ],
+            validAfter: .now,
+            validBefore: .now.addingTimeInterval(3_600)
+        )
+
+        do {
+            _ = try await makeService().issueCertificates(
+                request: request,
+                existingAuthorities: [authority],
+                existingCertificates: []
+            )
+            XCTFail("Expected the batch to fail")
+        } catch {
+            XCTAssertTrue(error.localizedDescription.contains("None of the 2 inventory rows"))
+        }
+        XCTAssertTrue(certificateStore.saved.isEmpty)
+    }
+
+    func testUserBatchIsRejectedByAHostOnlyCA() async {
+        let request = BatchCertificateIssuanceRequest(
+            authorityID: authority.id,
+            role: .user,
+            subjects: [BatchCertificateSubject(keyID: "alice", principals: ["alice"], subjectPublicKeyAuthorized: "x")],
+            validAfter: .now,
+            validBefore: .now.addingTimeInterval(3_600)
+        )
+
+        do {
+            _ = try await makeService().issueCertificates(
+                request: request,
+                existingAuthorities: [authority],
+                existingCertificates: []
+            )
+            XCTFail("Expected the batch to fail")
+        } catch {
+            XCTAssertEqual(error.localizedDescription, CertificateRole.user.unsupportedAuthorityMessage)
+        }
+    }
+
+    // MARK: - Export
+
+    func testExportWritesOneFilePerCertificateAndAManifest() throws {
+        let parent = FileManager.default.temporaryDirectory
+            .appendingPathComponent("prossh-batch-\(UUID().uuidString)", isDirectory: true)
+        defer { try? FileManager.default.removeItem(at: parent) }
+        let certificates = (1...3).map { serial in
+            SSHCertificate(
+                id: UUID(),
+                type: .host,
+                serialNumber: UInt64(serial),
+                keyId: "web-0\(serial)",
+                principals: ["web-0\(serial).example.com"],
+                validAfter: .now,
+                validBefore: .now.addingTimeInterval(3_600),
+                criticalOptions: [:],
+                extensions: [],
+                signingCAFingerprint: authority.publicKeyFingerprint,
+                signedKeyFingerprint: "SHA256:key\(serial)",
+                signatureAlgorithm: "ecdsa-sha2-nistp256",
+                associatedKeyId: nil,
+                rawCertificateData: Data(),
+                authorizedRepresentation: "ssh-ed25519-cert-v01@openssh.com AAAA\(serial) web-0\(serial)",
+                importedFrom: nil,
+                createdAt: .now
+            )
+        }
+
+        let directory = try makeService().exportIssuedCertificates(
+            certificates,
+            to: parent,
+            name: "fleet",
+            asArchive: false
+        )
+
+        let files = try FileManager.default.contentsOfDirectory(atPath: directory.path(percentEncoded: false)).sorted()
+        XCTAssertEqual(files, ["manifest.csv", "web-01-1-cert.pub", "web-02-2-cert.pub", "web-03-3-cert.pub"])
+        let certificate = try String(contentsOf: directory.appendingPathComponent("web-02-2-cert.pub"), encoding: .utf8)
+        XCTAssertEqual(certificate, "ssh-ed25519-cert-v01@openssh.com AAAA2 web-02\n")
+        let manifest = try String(contentsOf: directory.appendingPathComponent("manifest.csv"), encoding: .utf8)
+        XCTAssertEqual(manifest.split(separator: "\n").count, 4)
+    }
+}
+#endif
@@ -0,0 +1,150 @@
+// CodepointPrintTests.swift
+// ProSSHV2
+//
+// TerminalGrid.printCodepoints: table-driven widths, in-place wrap/scroll
+// and grapheme side-table fallback for combining marks and ZWJ sequences.
+
+#if canImport(XCTest)
+import XCTest
+@testable import ProSSHMac
+
+final class CharacterWidthTableTests: XCTestCase {
+
+    // MARK: - Cell Width
+
+    func testCellWidthClassifiesNarrowWideAndZeroWidth() {
+        XCTAssertEqual(CharacterWidth.cellWidth(0x41), 1)        // A
+        XCTAssertEqual(CharacterWidth.cellWidth(0x2500), 1)      // ─
+        XCTAssertEqual(CharacterWidth.cellWidth(0x4E16), 2)      // 世
+        XCTAssertEqual(CharacterWidth.cellWidth(0x1F680), 2)     // 🚀
+        XCTAssertEqual(CharacterWidth.cellWidth(0x0301), 0)      // combining acute
+        XCTAssertEqual(CharacterWidth.cellWidth(0xFE0F), 0)      // VS16
+        XCTAssertEqual(CharacterWidth.cellWidth(0x200D), 0)      // ZWJ
+        XCTAssertEqual(CharacterWidth.cellWidth(0x1F3FD), 0)     // skin tone
+    }
+
+    func testCellWidthTableAgreesWithIsWide() {
+        for value: UInt32 in stride(from: 0x1100, to: 0x10000, by: 7) {
+            guard let scalar = UnicodeScalar(value), CharacterWidth.cellWidth(value) != 0 else { continue }
+            XCTAssertEqual(CharacterWidth.cellWidth(value) == 2, CharacterWidth.isWide(scalar), "U+\(String(value, radix: 16))")
+        }
+    }
+
+    func testAmbiguousPolicyWidensOnlyAmbiguousNarrowCodepoints() {
+        let narrow = CharacterWidth.Table(configuration: .standard)
+        var configuration = CharacterWidth.Configuration.standard
+        configuration.ambiguousWidth = .wide
+        let wide = CharacterWidth.Table(configuration: configuration)
+
+        XCTAssertEqual(narrow.width(0x00B1), 1)   // ±
+        XCTAssertEqual(wide.width(0x00B1), 2)
+        XCTAssertEqual(wide.width(0x2500), 2)     // ─
+        XCTAssertEqual(wide.width(0x03B1), 2)     // α
+        XCTAssertEqual(wide.width(0xF0000), 2)    // plane 15 private use
+        XCTAssertEqual(wide.width(0x41), 1)
+        XCTAssertEqual(wide.width(0x0301), 0, "Combining marks stay zero-width")
+        XCTAssertEqual(wide.width(0x4E16), 2)
+    }
+
+    func testUnicodeVersionNarrowsNewerScalars() {
+        var configuration = CharacterWidth.Configuration.standard
+        configuration.unicodeVersion = (major: 8, minor: 0)
+        let table = CharacterWidth.Table(configuration: configuration)
+
+        XCTAssertEqual(table.width(0x1F600), 2)   // 😀, Unicode 6.1
+        XCTAssertEqual(table.width(0x1F97A), 1)   // 🥺, Unicode 11
+        XCTAssertEqual(table.width(0x4E16), 2)
+    }
+
+    func testTableSharesPagesAcrossBlocks() {
+        let table = CharacterWidth.Table()
+        XCTAssertLessThan(table.pageCount, (0x110000 >> 8) / 4)
+        XCTAssertEqual(table.width(0x10FFFF + 1), 1)
+        XCTAssertEqual(table.width(0x50000), 1)
+        XCTAssertEqual(table.width(0xE0100), 0)   // VS17
+    }
+}
+
+final class CodepointPrintRenderTest: IntegrationTestBase {
+
+    private func clusterAt(row: Int, col: Int) async -> String {
+        guard let cell = await grid.cellAt(row: row, col: col) else { return "" }
+        return await grid.resolveGrapheme(for: cell)
+    }
+
+    // MARK: - Graphemes
+
+    func testCombiningMarkJoinsPreviousCell() async {
+        await feed("e\u{301}x")
+
+        let cluster = await clusterAt(row: 0, col: 0)
+        XCTAssertEqual(cluster, "e\u{301}")
+        let next = await charAt(row: 0, col: 1)
+        XCTAssertEqual(next, "x")
+        let pos = await grid.cursorPosition()
+        XCTAssertEqual(pos.col, 2)
+    }
+
+    func testZWJSequenceOccupiesOneWideCell() async {
+        let family = "👨\u{200D}👩\u{200D}👧"
+        await feed(family + "|")
+
+        let cluster = await clusterAt(row: 0, col: 0)
+        XCTAssertEqual(cluster, family)
+        let attrs = await attrsAt(row: 0, col: 0)
+        XCTAssertTrue(attrs.contains(.wideChar))
+        let bar = await charAt(row: 0, col: 2)
+        XCTAssertEqual(bar, "|")
+    }
+
+    func testCombiningMarkSplitAcrossChunksStillJoins() async {
+        let bytes = Array("ё".decomposedStringWithCanonicalMapping.utf8)
+        await feedBytes(Array(bytes.prefix(bytes.count - 1)))
+        await feedBytes(Array(bytes.suffix(1)))
+
+        let cluster = await clusterAt(row: 0, col: 0)
+        XCTAssertEqual(cluster, "ё".decomposedStringWithCanonicalMapping)
+    }
+
+    func testZWJBetweenLettersDoesNotJoinTheNextLetter() async {
+        await feed("a\u{200D}b")
+
+        let cluster = await clusterAt(row: 0, col: 0)
+        XCTAssertEqual(cluster, "a\u{200D}")
+        let next = await charAt(row: 0, col: 1)
+        XCTAssertEqual(next, "b")
+    }
+
+    func testRepeatedClustersShareOneSideTableSlot() async {
+        let cluster = "e\u{301}"
+        await feed(String(repeating: cluster, count: 10))
+
+        let active = await grid.graphemeSideTable.activeCount
+        XCTAssertEqual(active, 1)
+        let last = await clusterAt(row: 0, col: 9)
+        XCTAssertEqual(last, cluster)
+
+        await feed("\u{1B}[1;1H\u{1B}[5X")
+        let remaining = await grid.graphemeSideTable.activeCount
+        XCTAssertEqual(remaining, 1, "Erasing some cells keeps the slot the rest still hold")
+        await feed("\u{1B}[2K")
+        let cleared = await grid.graphemeSideTable.activeCount
+        XCTAssertEqual(cleared, 0)
+    }
+
+    // MARK: - Wrap and Scroll
+
+    func testRunScrollsAtBottomMarginInsideOneCall() async {
+        let rows = await grid.rows
+        let columns = await grid.columns
+        await feed("\u{1B}[\(rows);1H" + String(repeating: "─", count: columns + 3))
+
+        let last = await rowText(row: rows - 1, endCol: 3)
+        XCTAssertEqual(last, "───")
+        let previous = await rowText(row: rows - 2, endCol: columns)
+        XCTAssertEqual(previous, String(repeating: "─", count: columns))
+        let wrapped = await attrsAt(row: rows - 2, col: columns - 1)
+        XCTAssertTrue(wrapped.contains(.wrapped))
+    }
+}
+#endif
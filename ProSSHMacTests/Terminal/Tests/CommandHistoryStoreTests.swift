@@ -0,0 +1,162 @@
+// CommandHistoryStoreTests.swift
+// ProSSHV2
+//
+// Persistent command history: reopening from the log and the checkpoint,
+// queries by host, time, exit code and text, outputs read back from disk,
+// and recovery from a torn log tail.
+
+#if canImport(XCTest)
+import CryptoKit
+import XCTest
+@testable import ProSSHMac
+
+final class CommandHistoryStoreTests: XCTestCase {
+
+    private var directory: URL!
+    private let key = SymmetricKey(size: .bits256)
+
+    override func setUpWithError() throws {
+        directory = FileManager.default.temporaryDirectory
+            .appendingPathComponent("CommandHistoryStoreTests-\(UUID().uuidString)", isDirectory: true)
+    }
+
+    override func tearDownWithError() throws {
+        try? FileManager.default.removeItem(at: directory)
+    }
+
+    // MARK: - Helpers
+
+    private func makeStore() -> CommandHistoryStore {
+        let key = key
+        return CommandHistoryStore(directory: directory) { _ in key }
+    }
+
+    private func makeBlock(
+        _ command: String,
+        output: String = "",
+        exitCode: Int? = 0,
+        at seconds: TimeInterval
+    ) -> CommandBlock {
+        CommandBlock(
+            id: UUID(),
+            sessionID: UUID(),
+            command: command,
+            output: output,
+            startedAt: Date(timeIntervalSince1970: seconds - 1),
+            completedAt: Date(timeIntervalSince1970: seconds),
+            exitCode: exitCode,
+            boundarySource: .osc133
+        )
+    }
+
+    // MARK: - Persistence
+
+    func testEntriesSurviveReopenFromLog() async throws {
+        let store = makeStore()
+        await store.append(makeBlock("ls -la", output: "total 0", at: 100), host: "local")
+        await store.append(makeBlock("uptime", at: 200), host: "admin@web:22")
+
+        let reopened = makeStore()
+        let count = await reopened.count
+        XCTAssertEqual(count, 2)
+        let entries = await reopened.entries(matching: CommandHistoryQuery())
+        XCTAssertEqual(entries.map(\.command), ["uptime", "ls -la"])
+    }
+
+    func testEntriesSurviveReopenFromCheckpoint() async throws {
+        let store = makeStore()
+        await store.append(makeBlock("first", at: 100), host: "local")
+        await store.checkpoint()
+        await store.append(makeBlock("second", at: 200), host: "local")
+
+        let reopened = makeStore()
+        let entries = await reopened.entries(matching: CommandHistoryQuery())
+        XCTAssertEqual(entries.map(\.command), ["second", "first"])
+    }
+
+    func testDuplicateBlockIsStoredOnce() async throws {
+        let store = makeStore()
+        let block = makeBlock("make", at: 100)
+        await store.append(block, host: "local")
+        await store.append(block, host: "local")
+
+        let count = await store.count
+        XCTAssertEqual(count, 1)
+    }
+
+    func testTornTailIsTruncated() async throws {
+        let store = makeStore()
+        await store.append(makeBlock("kept", at: 100), host: "local")
+
+        let logURL = directory.appendingPathComponent("history.log")
+        let handle = try FileHandle(forUpdating: logURL)
+        try handle.seekToEnd()
+        try handle.write(contentsOf: Data([0xFF, 0x00, 0x00, 0x00, 0x01, 0x02]))
+        try handle.close()
+
+        let reopened = makeStore()
+        await reopened.append(makeBlock("after", at: 200), host: "local")
+        let entries = await reopened.entries(matching: CommandHistoryQuery())
+        XCTAssertEqual(entries.map(\.command), ["after", "kept"])
+
+        let again = makeStore()
+        let count = await again.count
+        XCTAssertEqual(count, 2, "The new record was written over the torn bytes")
+    }
+
+    // MARK: - Queries
+
+    func testQueriesFilterByHostExitCodeAndTime() async throws {
+        let store = makeStore()
+        await store.append(makeBlock("deploy", exitCode: 0, at: 100), host: "admin@web:22")
+        await store.append(makeBlock("deploy", exitCode: 1, at: 200), host: "admin@web:22")
+        await store.append(makeBlock("deploy", exitCode: 2, at: 300), host: "root@db:22")
+
+        let web = await store.entries(matching: CommandHistoryQuery(host: "admin@web:22"))
+        XCTAssertEqual(web.map(\.exitCode), [1, 0])
+
+        let failed = await store.entries(matching: CommandHistoryQuery(failedOnly: true))
+        XCTAssertEqual(failed.map(\.exitCode), [2, 1])
+
+        let exitOne = await store.entries(matching: CommandHistoryQuery(exitCode: 1))
+        XCTAssertEqual(exitOne.map(\.host), ["admin@web:22"])
+
+        let window = await store.entries(matching: CommandHistoryQuery(
+            since: Date(timeIntervalSince1970: 150),
+            until: Date(timeIntervalSince1970: 300)
+        ))
+        XCTAssertEqual(window.map(\.exitCode), [2, 1])
+
+        let hosts = await store.hosts()
+        XCTAssertEqual(hosts, ["root@db:22", "admin@web:22"])
+    }
+
+    func testTextQueryMatchesCommandsCaseInsensitively() async throws {
+        let store = makeStore()
+        await store.append(makeBlock("git status", at: 100), host: "local")
+        await store.append(makeBlock("docker ps", at: 200), host: "local")
+        await store.append(makeBlock("GIT log", at: 300), host: "local")
+
+        let git = await store.entries(matching: CommandHistoryQuery(text: "git"))
+        XCTAssertEqual(git.map(\.command), ["GIT log", "git status"])
+
+        let short = await store.entries(matching: CommandHistoryQuery(text: "ps"))
+        XCTAssertEqual(short.map(\.command), ["docker ps"])
+
+        let limited = await store.entries(matching: CommandHistoryQuery(limit: 1))
+        XCTAssertEqual(limited.map(\.command), ["GIT log"])
+    }
+
+    func testOutputIsReadBackFromDisk() async throws {
+        let store = makeStore()
+        let block = makeBlock("cat motd", output: "Welcome", at: 100)
+        await store.append(block, host: "local")
+
+        let reopened = makeStore()
+        let output = await reopened.output(of: block.id)
+        XCTAssertEqual(output, "Welcome")
+        let missing = await reopened.output(of: UUID())
+        XCTAssertNil(missing)
+    }
+}
+#endif
@@ -0,0 +1,168 @@
+// CommandOutputFoldingTests.swift
+// ProSSHV2
+//
+// Command output folded out of scrollback into CommandOutputFoldStore: the
+// summary row, what is left in scrollback, navigation across a fold, copy
+// and export through the store, expansion, and the store's byte budget.
+
+#if canImport(XCTest)
+import XCTest
+@testable import ProSSHMac
+
+final class CommandOutputFoldingTests: XCTestCase {
+
+    private let summary = CommandOutputFold.Summary(command: "seq 50", exitCode: 0, duration: 1.25)
+
+    // MARK: - Folding
+
+    func testFoldLeavesOneSummaryRow() async {
+        let engine = await makeEngineWithFinishedCommand()
+        let before = await engine.scrollbackCount
+        XCTAssertEqual(before, 49)
+
+        let id = await engine.foldCommandOutput(summary: summary, minimumLines: 10, newestOnly: true)
+        XCTAssertNotNil(id)
+        let after = await engine.scrollbackCount
+        XCTAssertEqual(after, 2, "The prompt line and the summary row")
+
+        let folds = await engine.visibleCommandOutputFolds()
+        XCTAssertEqual(folds.map(\.id), [id].compactMap { $0 })
+        XCTAssertEqual(folds.first?.lineCount, 48)
+        let text = folds.first?.summaryText ?? ""
+        XCTAssertTrue(text.hasPrefix("\u{25B8} #\(id ?? 0) "))
+        XCTAssertTrue(text.contains("48 lines folded"))
+        XCTAssertTrue(text.contains("exit 0"))
+        XCTAssertTrue(text.contains("1.2s") || text.contains("1.3s"))
+        XCTAssertTrue(text.contains("seq 50"))
+    }
+
+    func testShortOutputIsNotFolded() async {
+        let engine = await makeEngineWithFinishedCommand()
+        let id = await engine.foldCommandOutput(summary: summary, minimumLines: 100, newestOnly: true)
+        XCTAssertNil(id)
+        let count = await engine.scrollbackCount
+        XCTAssertEqual(count, 49)
+    }
+
+    func testFoldedOutputIsNotFoldedAgain() async {
+        let engine = await makeEngineWithFinishedCommand()
+        _ = await engine.foldCommandOutput(summary: summary, minimumLines: 1, newestOnly: false)
+        let again = await engine.foldCommandOutput(summary: summary, minimumLines: 1, newestOnly: false)
+        XCTAssertNil(again)
+    }
+
+    func testPromptNavigationSurvivesTheFold() async {
+        let engine = await makeEngineWithFinishedCommand()
+        _ = await engine.foldCommandOutput(summary: summary, minimumLines: 10, newestOnly: true)
+
+        let offset = await engine.promptScrollOffset(from: 0, direction: -1)
+        XCTAssertEqual(offset, 2, "The first prompt is now two lines above the screen")
+        let foldID = await engine.lastCommandOutputFoldID
+        XCTAssertNotNil(foldID)
+    }
+
+    // MARK: - Copy and Export
+
+    func testLastOutputAndExportReadTheFoldedLines() async {
+        let engine = await makeEngineWithFinishedCommand()
+        _ = await engine.foldCommandOutput(summary: summary, minimumLines: 10, newestOnly: true)
+
+        let output = await engine.lastCommandOutput(maxCharacters: 10_000)
+        XCTAssertEqual(output?.text, (0..<50).map(String.init).joined(separator: "\n"))
+
+        let export = await engine.historyTextExport()
+        let text = String(decoding: export.utf8Data(), as: UTF8.self)
+        XCTAssertEqual(text, "$ seq 50\n" + (0..<50).map(String.init).joined(separator: "\n") + "\n$\n")
+    }
+
+    // MARK: - Expanding
+
+    func testExpandRestoresTheLines() async {
+        let engine = await makeEngineWithFinishedCommand()
+        let exportBefore = String(decoding: await engine.historyTextExport().utf8Data(), as: UTF8.self)
+        guard let id = await engine.foldCommandOutput(summary: summary, minimumLines: 10, newestOnly: true) else {
+            return XCTFail("Expected a fold")
+        }
+
+        let expanded = await engine.expandCommandOutput(id)
+        XCTAssertTrue(expanded)
+        let count = await engine.scrollbackCount
+        XCTAssertEqual(count, 49)
+        let folds = await engine.visibleCommandOutputFolds()
+        XCTAssertTrue(folds.isEmpty)
+        let exportAfter = String(decoding: await engine.historyTextExport().utf8Data(), as: UTF8.self)
+        XCTAssertEqual(exportAfter, exportBefore)
+
+        let offset = await engine.promptScrollOffset(from: 0, direction: -1)
+        XCTAssertEqual(offset, 49)
+        let output = await engine.lastCommandOutput(maxCharacters: 10_000)
+        XCTAssertEqual(output?.scrollOffset, 48)
+    }
+
+    func testExpandKeepsWhatDoesNotFitFolded() async {
+        let engine = await makeEngineWithFinishedCommand()
+        guard let id = await engine.foldCommandOutput(summary: summary, minimumLines: 10, newestOnly: true) else {
+            return XCTFail("Expected a fold")
+        }
+        // Refill scrollback so only part of the fold fits back.
+        for line in 0..<90 {
+            await feed(engine, "more \(line)\r\n")
+        }
+        let before = await engine.scrollbackCount
+        XCTAssertEqual(before, 92)
+
+        let expanded = await engine.expandCommandOutput(id)
+        XCTAssertTrue(expanded)
+        let after = await engine.scrollbackCount
+        XCTAssertEqual(after, 100, "Expansion fills scrollback without evicting history")
+        let folds = await engine.visibleCommandOutputFolds()
+        XCTAssertEqual(folds.count, 1)
+        XCTAssertEqual(folds.first?.lineCount, 48 - 8 + 1)
+        XCTAssertNotEqual(folds.first?.id, id)
+    }
+
+    // MARK: - Store
+
+    func testStoreDropsOldestFoldsOverBudget() {
+        var store = CommandOutputFoldStore(maxBytes: 1)
+        let lines = (0..<300).map { ScrollbackLine(cells: cells("row \($0)")) }
+        let first = store.insert(lines, columns: 20, summary: summary)
+        let second = store.insert(lines, columns: 20, summary: summary)
+        XCTAssertNil(store.folds[first.id])
+        XCTAssertNotNil(store.folds[second.id], "The newest fold is always kept")
+    }
+
+    func testSummaryRowIDIsParsed() {
+        var store = CommandOutputFoldStore()
+        let fold = store.insert([ScrollbackLine(cells: cells("x"))], columns: 20, summary: summary)
+        let row = ScrollbackLine(cells: CommandOutputFoldStore.summaryCells(for: fold, columns: 12))
+        XCTAssertEqual(row.count, 12, "Cut to the screen width")
+        XCTAssertEqual(CommandOutputFoldStore.foldID(summarizedBy: row), fold.id)
+        XCTAssertNil(CommandOutputFoldStore.foldID(summarizedBy: ScrollbackLine(cells: cells("\u{25B8} #x"))))
+        XCTAssertEqual(store.fold(summarizedBy: row)?.text, "x")
+    }
+
+    // MARK: - Helpers
+
+    private func feed(_ engine: TerminalEngine, _ text: String) async {
+        await engine.feed(Array(text.utf8))
+    }
+
+    /// A finished command with 50 output lines and a fresh prompt on a
+    /// three-row screen: the prompt on line 0, output on lines 1...50 and
+    /// the new prompt on line 51, so lines 1..<49 are in scrollback.
+    private func makeEngineWithFinishedCommand() async -> TerminalEngine {
+        let engine = TerminalEngine(columns: 40, rows: 3, maxScrollbackLines: 100)
+        await feed(engine, "\u{1B}]133;A\u{07}$ seq 50\r\n\u{1B}]133;C\u{07}")
+        for line in 0..<50 {
+            await feed(engine, "\(line)\r\n")
+        }
+        await feed(engine, "\u{1B}]133;D;0\u{07}\u{1B}]133;A\u{07}$ ")
+        return engine
+    }
+
+    private func cells(_ text: String) -> [TerminalCell] {
+        text.map { TerminalCell(graphemeCluster: String($0)) }
+    }
+}
+#endif
@@ -0,0 +1,134 @@
+// CompactSnapshotTests.swift
+// ProSSHV2
+//
+// Compact snapshots for GPU cell expansion: the grid publishes its cells as
+// stored, copying only changed rows, and expanding them reproduces what the
+// CPU encode would have produced. Each case drives a compact grid and an
+// expanding grid through the same edits.
+
+#if canImport(XCTest)
+import XCTest
+@testable import ProSSHMac
+
+final class CompactSnapshotTests: XCTestCase {
+
+    private var compact: TerminalGrid!
+    private var expanded: TerminalGrid!
+
+    override func setUp() async throws {
+        compact = TerminalGrid(columns: 20, rows: 6)
+        compact.setCompactSnapshots(true)
+        expanded = TerminalGrid(columns: 20, rows: 6)
+    }
+
+    // MARK: - Helpers
+
+    private func apply(_ edit: (TerminalGrid) -> Void) {
+        edit(compact)
+        edit(expanded)
+    }
+
+    private func write(_ text: String, row: Int, col: Int) -> (TerminalGrid) -> Void {
+        { grid in
+            grid.moveCursorTo(row: row, col: col)
+            for char in text {
+                grid.printCharacter(char)
+            }
+        }
+    }
+
+    /// The dirty flag is a CPU-encode detail the shaders never read.
+    private func assertFramesMatch(_ frames: Int = 3, file: StaticString = #filePath, line: UInt = #line) {
+        for _ in 0..<frames {
+            let snapshot = compact.snapshot()
+            let expected = expanded.snapshot()
+            XCTAssertTrue(snapshot.cells.isEmpty, file: file, line: line)
+            XCTAssertEqual(snapshot.cellCount, expected.cells.count, file: file, line: line)
+
+            let actual = snapshot.expandingCompactCells()
+            for index in 0..<min(actual.cells.count, expected.cells.count) {
+                let a = actual.cells[index]
+                let e = expected.cells[index]
+                guard a.row == e.row, a.col == e.col, a.glyphIndex == e.glyphIndex,
+                      a.fgColor == e.fgColor, a.bgColor == e.bgColor,
+                      a.underlineColor == e.underlineColor, a.attributes == e.attributes,
+                      a.flags == e.flags & ~CellInstance.flagDirty,
+                      a.underlineStyle == e.underlineStyle else {
+                    XCTFail("cell \(index) differs from the CPU encode", file: file, line: line)
+                    return
+                }
+            }
+            XCTAssertEqual(actual.graphemeOverrides, expected.graphemeOverrides, file: file, line: line)
+            XCTAssertEqual(snapshot.damagedRanges, expected.damagedRanges, file: file, line: line)
+        }
+    }
+
+    // MARK: - Layout
+
+    func testTerminalCellMatchesShaderLayout() {
+        XCTAssertEqual(MemoryLayout<TerminalCell>.size, 20)
+        XCTAssertEqual(MemoryLayout<TerminalCell>.stride, 20)
+        XCTAssertEqual(MemoryLayout<TerminalCell>.offset(of: \.bgPackedRGBA), 8)
+        XCTAssertEqual(MemoryLayout<TerminalCell>.offset(of: \.attributes), 16)
+        XCTAssertEqual(MemoryLayout<TerminalCell>.offset(of: \.underlineStyle), 18)
+        XCTAssertEqual(MemoryLayout<TerminalCell>.offset(of: \.width), 19)
+        XCTAssertEqual(MemoryLayout<CellExpansionParams>.stride, 16)
+
+        // The kernel reads the underline style byte as its raw value.
+        var cell = TerminalCell.blank
+        cell.underlineStyle = .dotted
+        let byte = withUnsafeBytes(of: &cell) { $0[18] }
+        XCTAssertEqual(byte, UnderlineStyle.dotted.rawValue)
+    }
+
+    // MARK: - Carry-Over
+
+    func testEditsAcrossFramesMatchCPUEncode() {
+        assertFramesMatch()
+        apply(write("hello", row: 1, col: 0))
+        assertFramesMatch()
+        apply(write("world", row: 4, col: 3))
+        assertFramesMatch(1)
+        apply { $0.moveCursorTo(row: 5, col: 7) }
+        assertFramesMatch()
+    }
+
+    func testWideAndGraphemeCellsMatchCPUEncode() {
+        apply(write("\u{4E2D}e\u{301}", row: 2, col: 0))
+        assertFramesMatch()
+        apply(write("plain", row: 2, col: 0))
+        assertFramesMatch()
+    }
+
+    func testScrollingAndResizeMatchCPUEncode() {
+        for line in 0..<8 {
+            apply(write("line \(line)", row: 5, col: 0))
+            apply { $0.lineFeed() }
+            assertFramesMatch(1)
+        }
+        apply { $0.resize(newColumns: 30, newRows: 8) }
+        assertFramesMatch()
+    }
+
+    // MARK: - Consumers
+
+    func testDrawListsMatchExpandedCells() throws {
+        apply(write("ls -la \u{4E2D}", row: 0, col: 0))
+        let snapshot = compact.snapshot()
+        let compactCells = try XCTUnwrap(snapshot.compactCells)
+        let fromCompact = CellDrawLists(cells: compactCells, columns: 20, rows: 6)
+        let fromExpanded = CellDrawLists(cells: snapshot.expandingCompactCells().cells, columns: 20, rows: 6)
+        XCTAssertEqual(fromCompact.backgroundRuns, fromExpanded.backgroundRuns)
+        XCTAssertEqual(fromCompact.cellIndices, fromExpanded.cellIndices)
+    }
+
+    func testSwitchingModesStartsFromAFullFrame() {
+        apply(write("abc", row: 0, col: 0))
+        _ = compact.snapshot()
+        compact.setCompactSnapshots(false)
+        let snapshot = compact.snapshot()
+        XCTAssertNil(snapshot.compactCells)
+        XCTAssertEqual(snapshot.cells[1].glyphIndex, UInt32(Character("b").asciiValue ?? 0))
+    }
+}
+#endif
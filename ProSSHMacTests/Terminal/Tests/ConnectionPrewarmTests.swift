@@ -0,0 +1,85 @@
+// ConnectionPrewarmTests.swift
+// ProSSHV2
+//
+// Connection pre-warming: which hosts authenticate ahead of the click,
+// which recent hosts are warmed, and which host edits keep a warm
+// connection from being adopted.
+
+#if canImport(XCTest)
+import XCTest
+@testable import ProSSHMac
+
+final class ConnectionPrewarmTests: XCTestCase {
+
+    // MARK: - Helpers
+
+    private func makeHost(
+        authMethod: AuthMethod = .publicKey,
+        passphraseReference: String? = nil,
+        lastConnected: Date? = nil
+    ) -> ProSSHMac.Host {
+        ProSSHMac.Host(
+            id: UUID(),
+            label: "build",
+            folder: nil,
+            hostname: "build.example.com",
+            port: 22,
+            username: "ops",
+            authMethod: authMethod,
+            keyReference: UUID(),
+            certificateReference: nil,
+            passwordReference: nil,
+            passphraseReference: passphraseReference,
+            jumpHost: nil,
+            algorithmPreferences: nil,
+            pinnedHostKeyAlgorithms: [],
+            legacyModeEnabled: false,
+            tags: [],
+            notes: nil,
+            lastConnected: lastConnected,
+            createdAt: .now
+        )
+    }
+
+    // MARK: - Eligibility
+
+    func testOnlyKeysWithoutPromptAuthenticateAhead() {
+        XCTAssertTrue(ConnectionPrewarmCoordinator.authenticatesAhead(makeHost(authMethod: .publicKey)))
+        XCTAssertTrue(ConnectionPrewarmCoordinator.authenticatesAhead(makeHost(authMethod: .certificate)))
+        XCTAssertFalse(ConnectionPrewarmCoordinator.authenticatesAhead(makeHost(authMethod: .password)))
+        XCTAssertFalse(ConnectionPrewarmCoordinator.authenticatesAhead(makeHost(authMethod: .keyboardInteractive)))
+        XCTAssertFalse(ConnectionPrewarmCoordinator.authenticatesAhead(makeHost(passphraseReference: "saved")))
+    }
+
+    func testRecentCandidatesAreNewestConnectedFirst() {
+        let old = makeHost(lastConnected: Date(timeIntervalSince1970: 100))
+        let never = makeHost()
+        let newest = makeHost(lastConnected: Date(timeIntervalSince1970: 300))
+        let middle = makeHost(lastConnected: Date(timeIntervalSince1970: 200))
+        let candidates = ConnectionPrewarmCoordinator.recentCandidates([old, never, newest, middle], limit: 2)
+        XCTAssertEqual(candidates.map(\.id), [newest.id, middle.id])
+    }
+
+    // MARK: - Adoption
+
+    func testAdoptionIgnoresLastConnectedButNotCredentials() {
+        let host = makeHost()
+        var reconnected = host
+        reconnected.lastConnected = .now
+        reconnected.label = "renamed"
+        XCTAssertTrue(host.opensSameConnection(as: reconnected))
+
+        var rekeyed = host
+        rekeyed.keyReference = UUID()
+        XCTAssertFalse(host.opensSameConnection(as: rekeyed))
+
+        var pinned = host
+        pinned.pinnedHostKeyAlgorithms = ["ssh-ed25519"]
+        XCTAssertFalse(host.opensSameConnection(as: pinned))
+
+        var legacy = host
+        legacy.legacyModeEnabled = true
+        XCTAssertFalse(host.opensSameConnection(as: legacy))
+    }
+}
+#endif
@@ -0,0 +1,84 @@
+// CursorBlinkClockTests.swift
+// ProSSHV2
+//
+// The shared cursor blink clock: the phase is a function of media time
+// alone, changes only at half-period edges, and one clock wakes every
+// subscribed pane and stops once none remain.
+
+#if canImport(XCTest)
+import XCTest
+@testable import ProSSHMac
+
+@MainActor
+final class CursorBlinkClockTests: XCTestCase {
+
+    private final class FakeClient: CursorBlinkClient {
+        var ticks = 0
+        func cursorBlinkTick() { ticks += 1 }
+    }
+
+    private func phase(_ time: CFTimeInterval) -> Float {
+        CursorEffects.blinkPhase(time: time, halfPeriod: CursorBlinkClock.halfPeriod, visible: true, blinkEnabled: true)
+    }
+
+    // MARK: - Phase
+
+    func testPhaseAlternatesAtHalfPeriodEdges() {
+        let half = CursorBlinkClock.halfPeriod
+        let cycleStart = 1_000 * 2 * half
+        XCTAssertEqual(phase(cycleStart), 1)
+        XCTAssertEqual(phase(cycleStart + half * 0.99), 1)
+        XCTAssertEqual(phase(cycleStart + half * 1.01), 0)
+        XCTAssertEqual(phase(cycleStart + half * 1.99), 0)
+        XCTAssertEqual(phase(cycleStart + half * 2.01), 1)
+    }
+
+    func testPhaseIgnoresTimeWhenNotBlinking() {
+        let hiddenTime = CursorBlinkClock.halfPeriod * 1.5
+        XCTAssertEqual(CursorEffects.blinkPhase(time: hiddenTime, halfPeriod: CursorBlinkClock.halfPeriod, visible: true, blinkEnabled: false), 1)
+        XCTAssertEqual(CursorEffects.blinkPhase(time: 0, halfPeriod: CursorBlinkClock.halfPeriod, visible: false, blinkEnabled: true), 0)
+    }
+
+    func testNextEdgeIsStrictlyLater() {
+        let half = CursorBlinkClock.halfPeriod
+        let time = 12_345.678
+        let next = CursorBlinkClock.nextEdge(after: time)
+        XCTAssertGreaterThan(next, time)
+        XCTAssertLessThanOrEqual(next - time, half)
+        XCTAssertNotEqual(phase(next - 0.001), phase(next + CursorBlinkClock.wakeSlack))
+    }
+
+    func testRenderersSampleTheSamePhase() {
+        // Two panes drawing at different moments inside one half period agree.
+        let edge = CursorBlinkClock.edge(atOrBefore: 5_000.2)
+        XCTAssertEqual(phase(edge + 0.01), phase(edge + CursorBlinkClock.halfPeriod - 0.01))
+    }
+
+    // MARK: - Clients
+
+    func testTickReachesLiveClientsAndDropsReleasedOnes() {
+        let clock = CursorBlinkClock()
+        let first = FakeClient()
+        var second: FakeClient? = FakeClient()
+        clock.add(first)
+        clock.add(first)
+        clock.add(second!)
+        XCTAssertTrue(clock.isRunning)
+        XCTAssertEqual(clock.liveClientCount, 2)
+
+        clock.tick()
+        XCTAssertEqual(first.ticks, 1, "Adding twice subscribes once")
+        XCTAssertEqual(second?.ticks, 1)
+
+        second = nil
+        clock.tick()
+        XCTAssertEqual(first.ticks, 2)
+        XCTAssertEqual(clock.liveClientCount, 1)
+
+        clock.remove(first)
+        clock.tick()
+        XCTAssertEqual(first.ticks, 2)
+        XCTAssertEqual(clock.liveClientCount, 0)
+    }
+}
+#endif
@@ -0,0 +1,123 @@
+// DeferredReflowTests.swift
+// ProSSHV2
+//
+// Resize rewraps only the screen and recent scrollback; older history is
+// rewrapped on demand and must end up identical to a full reflow.
+
+#if canImport(XCTest)
+import XCTest
+@testable import ProSSHMac
+
+final class DeferredReflowTests: XCTestCase {
+
+    // MARK: - Helpers
+
+    private func text(_ cells: [TerminalCell]) -> String {
+        var line = ScrollbackLine(cells: cells)
+        line.trimTrailingBlanks()
+        return (0..<line.count).map { line.grapheme(at: $0) }.joined()
+    }
+
+    private func scrollbackText(_ buffer: ScrollbackBuffer) -> [String] {
+        (0..<buffer.count).map { index in
+            let line = buffer[index]
+            return "\(line.isWrapped)|" + text(line.cells)
+        }
+    }
+
+    private func makeEngine(lines: Int) async -> TerminalEngine {
+        let engine = TerminalEngine(columns: 40, rows: 6, maxScrollbackLines: 100_000)
+        var output = ""
+        for index in 0..<lines {
+            // Every third line wraps at 40 columns.
+            let body = index % 3 == 0 ? String(repeating: "w", count: 70) : "short"
+            output += "\(index) \(body)\r\n"
+        }
+        await engine.feed(Array(output.utf8))
+        return engine
+    }
+
+    // MARK: - Tests
+
+    func testResizeDefersOldHistoryAndSettlesToFullReflow() async {
+        let engine = await makeEngine(lines: 3_000)
+        let grid = await engine.grid
+
+        let screen = (0..<grid.rows).map { row in
+            (0..<grid.columns).compactMap { grid.cellAt(row: row, col: $0) }
+        }
+        let cursor = grid.cursorPosition()
+        let expected = GridReflow.reflow(
+            screenRows: screen,
+            scrollback: grid.scrollbackBuffer,
+            cursorRow: cursor.row,
+            cursorCol: cursor.col,
+            oldColumns: 40,
+            newColumns: 25,
+            newRows: 6
+        )
+
+        await engine.resize(newColumns: 25, newRows: 6)
+
+        let deferred = grid.scrollbackBuffer.deferredReflowLineCount
+        XCTAssertGreaterThan(deferred, 0)
+        XCTAssertGreaterThanOrEqual(deferred, 3_000 - GridReflow.liveReflowMargin - 1_000)
+        XCTAssertEqual(grid.scrollbackBuffer.deferredReflow.first?.columns, 40)
+        XCTAssertEqual((0..<6).map { row in text((0..<25).compactMap { grid.cellAt(row: row, col: $0) }) },
+                       expected.screenRows.map(text))
+
+        grid.settleDeferredReflow()
+
+        XCTAssertEqual(grid.scrollbackBuffer.deferredReflowLineCount, 0)
+        var expectedScrollback = ScrollbackBuffer(maxLines: 100_000, spillFile: { nil })
+        for line in expected.scrollbackLines {
+            expectedScrollback.push(line)
+        }
+        XCTAssertEqual(scrollbackText(grid.scrollbackBuffer), scrollbackText(expectedScrollback))
+    }
+
+    func testScrollingIntoDeferredHistorySettlesIt() async {
+        let engine = await makeEngine(lines: 1_000)
+        let grid = await engine.grid
+
+        await engine.resize(newColumns: 30, newRows: 6)
+        await engine.resize(newColumns: 50, newRows: 6)
+        XCTAssertGreaterThan(grid.scrollbackBuffer.deferredReflow.count, 0)
+
+        _ = grid.snapshot(scrollOffset: 10)
+        XCTAssertGreaterThan(grid.scrollbackBuffer.deferredReflowLineCount, 0, "recent history needs no settling")
+
+        _ = grid.snapshot(scrollOffset: grid.scrollbackBuffer.count)
+        XCTAssertEqual(grid.scrollbackBuffer.deferredReflowLineCount, 0)
+        let first = grid.scrollbackBuffer[0]
+        XCTAssertTrue(text(first.cells).hasPrefix("0 www"))
+        XCTAssertLessThanOrEqual(first.count, 50)
+    }
+
+    func testSearchSettlesFirst() async {
+        let engine = await makeEngine(lines: 1_000)
+        let grid = await engine.grid
+        await engine.resize(newColumns: 20, newRows: 6)
+
+        let matches = grid.searchScrollback("0 short")
+        XCTAssertEqual(grid.scrollbackBuffer.deferredReflowLineCount, 0)
+        XCTAssertFalse(matches.isEmpty)
+        XCTAssertTrue(text(grid.scrollbackBuffer[matches[0]].cells).contains("0 short"))
+    }
+
+    func testEvictionShrinksDeferredPrefix() {
+        var buffer = ScrollbackBuffer(maxLines: 100, spillFile: { nil })
+        for index in 0..<100 {
+            buffer.push(ScrollbackLine(cells: [TerminalCell(graphemeCluster: "\(index % 10)")]))
+        }
+        buffer.deferReflow(throughLine: 60, columns: 80)
+        XCTAssertEqual(buffer.deferredReflowLineCount, 60)
+
+        for _ in 0..<25 {
+            buffer.push(ScrollbackLine(cells: []))
+        }
+        XCTAssertEqual(buffer.deferredReflowLineCount, 35)
+        XCTAssertEqual(buffer.deferredReflow, [DeferredReflowSegment(lineCount: 35, columns: 80)])
+    }
+}
+#endif
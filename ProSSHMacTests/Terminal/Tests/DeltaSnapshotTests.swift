@@ -0,0 +1,145 @@
+// DeltaSnapshotTests.swift
+// ProSSHV2
+//
+// Snapshots re-encode only rows that changed since their buffer was last
+// filled. Each case drives two grids through the same edits, one forced to
+// encode in full every frame, and expects identical output.
+
+#if canImport(XCTest)
+import XCTest
+@testable import ProSSHMac
+
+final class DeltaSnapshotTests: XCTestCase {
+
+    private var delta: TerminalGrid!
+    private var full: TerminalGrid!
+
+    override func setUp() async throws {
+        delta = TerminalGrid(columns: 20, rows: 6)
+        full = TerminalGrid(columns: 20, rows: 6)
+    }
+
+    // MARK: - Helpers
+
+    private func apply(_ edit: (TerminalGrid) -> Void) {
+        edit(delta)
+        edit(full)
+    }
+
+    private func assertFramesMatch(_ frames: Int = 3, file: StaticString = #filePath, line: UInt = #line) {
+        for _ in 0..<frames {
+            full.invalidateSnapshotBuffers()
+            let expected = full.snapshot()
+            let actual = delta.snapshot()
+            XCTAssertEqual(actual.cells.count, expected.cells.count, file: file, line: line)
+            for index in 0..<min(actual.cells.count, expected.cells.count) {
+                let a = actual.cells[index]
+                let e = expected.cells[index]
+                guard a.row == e.row, a.col == e.col, a.glyphIndex == e.glyphIndex,
+                      a.fgColor == e.fgColor, a.bgColor == e.bgColor,
+                      a.underlineColor == e.underlineColor, a.attributes == e.attributes,
+                      a.flags == e.flags, a.underlineStyle == e.underlineStyle else {
+                    XCTFail("cell \(index) differs from a full encode", file: file, line: line)
+                    return
+                }
+            }
+            XCTAssertEqual(actual.graphemeOverrides, expected.graphemeOverrides, file: file, line: line)
+            XCTAssertEqual(actual.damagedRanges, expected.damagedRanges, file: file, line: line)
+        }
+    }
+
+    private func write(_ text: String, row: Int, col: Int) -> (TerminalGrid) -> Void {
+        { grid in
+            grid.moveCursorTo(row: row, col: col)
+            for char in text {
+                grid.printCharacter(char)
+            }
+        }
+    }
+
+    // MARK: - Carry-Over
+
+    func testEditsAcrossFramesMatchFullEncode() {
+        assertFramesMatch()
+        apply(write("hello", row: 1, col: 0))
+        assertFramesMatch()
+        apply(write("world", row: 4, col: 3))
+        assertFramesMatch(1)
+        apply(write("again", row: 1, col: 10))
+        assertFramesMatch()
+    }
+
+    func testCursorMovesClearOldCursorCell() {
+        apply(write("abc", row: 0, col: 0))
+        assertFramesMatch()
+        apply { $0.moveCursorTo(row: 5, col: 7) }
+        assertFramesMatch(1)
+        apply { $0.moveCursorTo(row: 2, col: 1) }
+        assertFramesMatch()
+    }
+
+    func testScrollingMatchesFullEncode() {
+        for line in 0..<10 {
+            apply(write("line \(line)", row: 5, col: 0))
+            apply { $0.lineFeed() }
+            assertFramesMatch(1)
+        }
+        assertFramesMatch()
+    }
+
+    func testScrollRegionMovesMatchFullEncode() {
+        apply(write("status", row: 0, col: 0))
+        apply { $0.setScrollRegion(top: 1, bottom: 4) }
+        for line in 0..<6 {
+            apply(write("r\u{301}ow \(line)", row: 4, col: 0))
+            apply { $0.lineFeed() }
+            assertFramesMatch(1)
+        }
+        apply { $0.moveCursorTo(row: 1, col: 0) }
+        apply { $0.reverseIndex() }
+        assertFramesMatch(1)
+        apply { $0.scrollUp(lines: 2) }
+        apply { $0.scrollDown(lines: 1) }
+        assertFramesMatch()
+    }
+
+    func testScrollCarriesOnlyExposedRowsAsRewritten() {
+        _ = delta.snapshot()
+        delta.moveCursorTo(row: 5, col: 0)
+        delta.lineFeed()
+        let first = delta.snapshot()
+        XCTAssertEqual(first.scroll?.delta, GridScrollDelta(region: 0...5, lines: 1))
+        XCTAssertEqual(first.scroll?.rewrittenRanges, [100..<120])
+        XCTAssertEqual(first.damagedRanges, [0..<120])
+
+        for char in "abc" {
+            delta.printCharacter(char)
+        }
+        delta.lineFeed()
+        delta.lineFeed()
+        let second = delta.snapshot()
+        XCTAssertEqual(second.scroll?.baseSequence, first.sequence)
+        XCTAssertEqual(second.scroll?.delta, GridScrollDelta(region: 0...5, lines: 2))
+        // Row 5 written, then moved up to row 3; rows 4 and 5 exposed.
+        XCTAssertEqual(second.scroll?.rewrittenRanges, [60..<120])
+    }
+
+    func testGraphemeOverridesFollowRewrittenRows() {
+        apply(write("e\u{301}x", row: 2, col: 0))
+        assertFramesMatch()
+        apply(write("plain", row: 2, col: 0))
+        assertFramesMatch()
+        apply(write("\u{1F44D}\u{1F3FD}", row: 3, col: 0))
+        assertFramesMatch()
+    }
+
+    func testResizeFallsBackToFullEncode() {
+        apply(write("before", row: 0, col: 0))
+        assertFramesMatch()
+        apply { $0.resize(newColumns: 30, newRows: 8) }
+        assertFramesMatch()
+        apply(write("after", row: 7, col: 2))
+        assertFramesMatch()
+    }
+}
+#endif
@@ -0,0 +1,50 @@
+#if canImport(XCTest)
+import XCTest
+@testable import ProSSHMac
+
+final class DirectorySyncPlannerTests: XCTestCase {
+
+    // MARK: - Quick Check
+
+    func testSameSizeAndSecondIsUnchanged() {
+        let remote = Date(timeIntervalSince1970: 1_700_000_000)
+        let local = Date(timeIntervalSince1970: 1_700_000_000.75)
+        XCTAssertTrue(DirectorySyncPlanner.isUnchanged(
+            sourceSize: 42, sourceModified: remote, destinationSize: 42, destinationModified: local
+        ))
+    }
+
+    func testDifferentSizeOrMtimeIsChanged() {
+        let date = Date(timeIntervalSince1970: 1_700_000_000)
+        XCTAssertFalse(DirectorySyncPlanner.isUnchanged(
+            sourceSize: 42, sourceModified: date, destinationSize: 41, destinationModified: date
+        ))
+        XCTAssertFalse(DirectorySyncPlanner.isUnchanged(
+            sourceSize: 42, sourceModified: date, destinationSize: 42, destinationModified: date.addingTimeInterval(1)
+        ))
+    }
+
+    func testMissingDestinationOrTimesAreChanged() {
+        let date = Date(timeIntervalSince1970: 1_700_000_000)
+        XCTAssertFalse(DirectorySyncPlanner.isUnchanged(
+            sourceSize: 42, sourceModified: date, destinationSize: nil, destinationModified: nil
+        ))
+        XCTAssertFalse(DirectorySyncPlanner.isUnchanged(
+            sourceSize: 42, sourceModified: nil, destinationSize: 42, destinationModified: date
+        ))
+    }
+
+    // MARK: - Relative Paths
+
+    func testRelativePathUnderRoot() {
+        XCTAssertEqual(DirectorySyncPlanner.relativePath(of: "/srv/app/lib/a.txt", under: "/srv/app"), "lib/a.txt")
+        XCTAssertEqual(DirectorySyncPlanner.relativePath(of: "/etc/hosts", under: "/"), "etc/hosts")
+    }
+
+    func testRelativePathRejectsSiblingsAndRoot() {
+        XCTAssertNil(DirectorySyncPlanner.relativePath(of: "/srv/application/a.txt", under: "/srv/app"))
+        XCTAssertNil(DirectorySyncPlanner.relativePath(of: "/srv/app", under: "/srv/app"))
+    }
+}
+
+#endif // canImport(XCTest)
@@ -0,0 +1,66 @@
+// DirtyRowSetTests.swift
+// ProSSHV2
+//
+// Per-row damage tracking: separate blocks of changed rows reach the
+// snapshot as separate ranges instead of one span covering everything
+// between them.
+
+#if canImport(XCTest)
+import XCTest
+@testable import ProSSHMac
+
+final class DirtyRowSetTests: XCTestCase {
+
+    // MARK: - DirtyRowSet
+
+    func testRunsCoalesceAdjacentRows() {
+        var set = DirtyRowSet()
+        set.insert(1)
+        set.insert(2...4)
+        set.insert(70)
+        set.insert(200)
+
+        XCTAssertEqual(set.runs(below: 100), [1...4, 70...70])
+        XCTAssertEqual(set.lowerBound, 1)
+        XCTAssertEqual(set.upperBound, 200)
+        XCTAssertTrue(set.contains(3))
+        XCTAssertFalse(set.contains(5))
+    }
+
+    func testRemoveAllClearsEveryBit() {
+        var set = DirtyRowSet()
+        set.insert(0...130)
+        set.removeAll()
+
+        XCTAssertTrue(set.isEmpty)
+        XCTAssertFalse(set.contains(64))
+        XCTAssertEqual(set.runs(below: 200), [])
+    }
+
+    // MARK: - Snapshot Damage
+
+    func testSnapshotReportsSeparateDamagedRanges() async {
+        let grid = TerminalGrid(columns: 80, rows: 24)
+        _ = grid.snapshot()
+
+        grid.setCellAt(row: 1, col: 0, cell: .blank)
+        grid.setCellAt(row: 20, col: 5, cell: .blank)
+        let snapshot = grid.snapshot()
+
+        XCTAssertEqual(snapshot.damagedRanges, [80..<160, 1_600..<1_680])
+        XCTAssertEqual(snapshot.dirtyRange, 80..<1_680)
+        XCTAssertEqual(snapshot.cells[10 * 80].flags & CellInstance.flagDirty, 0)
+        XCTAssertNotEqual(snapshot.cells[20 * 80].flags & CellInstance.flagDirty, 0)
+    }
+
+    func testCleanSnapshotHasNoDamage() async {
+        let grid = TerminalGrid(columns: 80, rows: 24)
+        _ = grid.snapshot()
+        let snapshot = grid.snapshot()
+
+        XCTAssertNil(snapshot.damagedRanges)
+        XCTAssertNil(snapshot.dirtyRange)
+    }
+}
+
+#endif
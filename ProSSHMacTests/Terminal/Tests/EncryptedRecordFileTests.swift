@@ -0,0 +1,125 @@
+// EncryptedRecordFileTests.swift
+// ProSSHV2
+//
+// Record-level encrypted store behind PersistentStore: commits write only
+// changed records, the index restores order on reopen, bytes past the
+// index are cut off, and superseded records are compacted away.
+
+#if canImport(XCTest)
+import CryptoKit
+import XCTest
+@testable import ProSSHMac
+
+final class EncryptedRecordFileTests: XCTestCase {
+
+    private var directory: URL!
+    private let key = SymmetricKey(size: .bits256)
+
+    override func setUpWithError() throws {
+        directory = FileManager.default.temporaryDirectory
+            .appendingPathComponent("EncryptedRecordFileTests-\(UUID().uuidString)", isDirectory: true)
+    }
+
+    override func tearDownWithError() throws {
+        try? FileManager.default.removeItem(at: directory)
+    }
+
+    // MARK: - Helpers
+
+    private func makeFile() throws -> EncryptedRecordFile {
+        let key = key
+        let file = EncryptedRecordFile(directory: directory, name: "items") { _ in key }
+        try file.open()
+        return file
+    }
+
+    private func records(_ ids: [UUID], _ values: [String]) -> [(id: UUID, plaintext: Data)] {
+        zip(ids, values).map { (id: $0, plaintext: Data($1.utf8)) }
+    }
+
+    private func texts(_ file: EncryptedRecordFile) throws -> [String] {
+        try file.readAll().map { String(decoding: $0, as: UTF8.self) }
+    }
+
+    private func recordsFiles() throws -> [URL] {
+        try FileManager.default.contentsOfDirectory(at: directory, includingPropertiesForKeys: [.fileSizeKey])
+            .filter { $0.pathExtension == "records" }
+    }
+
+    // MARK: - Tests
+
+    func testCommitWritesOnlyChangedRecords() throws {
+        let ids = (0..<100).map { _ in UUID() }
+        var values = (0..<100).map { "host \($0)" }
+        let file = try makeFile()
+        XCTAssertFalse(file.exists)
+        XCTAssertEqual(try file.commit(records(ids, values)), 100)
+        XCTAssertEqual(try file.commit(records(ids, values)), 0)
+
+        values[42] = "host 42 (favourite)"
+        XCTAssertEqual(try file.commit(records(ids, values)), 1)
+
+        let reopened = try makeFile()
+        XCTAssertTrue(reopened.exists)
+        XCTAssertEqual(try texts(reopened), values)
+        XCTAssertEqual(try reopened.read(id: ids[42]).map { String(decoding: $0, as: UTF8.self) }, values[42])
+        XCTAssertNil(try reopened.read(id: UUID()))
+    }
+
+    func testReorderAndRemovalUpdateOnlyTheIndex() throws {
+        let ids = (0..<5).map { _ in UUID() }
+        let values = ["a", "b", "c", "d", "e"]
+        let file = try makeFile()
+        try file.commit(records(ids, values))
+
+        let reordered = [4, 0, 2].map { (id: ids[$0], plaintext: Data(values[$0].utf8)) }
+        XCTAssertEqual(try file.commit(reordered), 0)
+        XCTAssertEqual(try texts(try makeFile()), ["e", "a", "c"])
+    }
+
+    func testBytesPastIndexAreDiscarded() throws {
+        let id = UUID()
+        let file = try makeFile()
+        try file.commit([(id: id, plaintext: Data("kept".utf8))])
+
+        // A record appended without its index, as after a crash.
+        let url = try XCTUnwrap(try recordsFiles().first)
+        let handle = try FileHandle(forUpdating: url)
+        try handle.seekToEnd()
+        try handle.write(contentsOf: Data(repeating: 0xAB, count: 40))
+        try handle.close()
+
+        let reopened = try makeFile()
+        XCTAssertEqual(try texts(reopened), ["kept"])
+        try reopened.commit([(id: id, plaintext: Data("kept".utf8)), (id: UUID(), plaintext: Data("next".utf8))])
+        XCTAssertEqual(try texts(try makeFile()), ["kept", "next"])
+    }
+
+    func testCompactionKeepsLiveRecords() throws {
+        let ids = (0..<10).map { _ in UUID() }
+        let file = try makeFile()
+        for round in 0..<200 {
+            let values = (0..<10).map { "item \($0) round \(round) " + String(repeating: "x", count: 100) }
+            try file.commit(records(ids, values))
+        }
+        let files = try recordsFiles()
+        XCTAssertEqual(files.count, 1, "Older generations are removed after compaction")
+        let size = try XCTUnwrap(try files[0].resourceValues(forKeys: [.fileSizeKey]).fileSize)
+        XCTAssertLessThan(size, 4 * EncryptedRecordFile.compactionThreshold)
+
+        let expected = (0..<10).map { "item \($0) round 199 " + String(repeating: "x", count: 100) }
+        XCTAssertEqual(try texts(try makeFile()), expected)
+    }
+
+    func testRemoveAllStartsEmpty() throws {
+        let file = try makeFile()
+        try file.commit([(id: UUID(), plaintext: Data("gone".utf8))])
+        try file.removeAll()
+        XCTAssertTrue(try recordsFiles().isEmpty)
+        let reopened = try makeFile()
+        XCTAssertFalse(reopened.exists)
+        XCTAssertEqual(try texts(reopened), [])
+    }
+}
+
+#endif
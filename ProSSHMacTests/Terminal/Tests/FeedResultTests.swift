@@ -0,0 +1,77 @@
+// FeedResultTests.swift
+// ProSSHV2
+//
+// Post-feed state collected by TerminalEngine.feedCollecting and merging of
+// results from consecutive parser batches.
+
+#if canImport(XCTest)
+import XCTest
+@testable import ProSSHMac
+
+final class FeedResultTests: XCTestCase {
+
+    // MARK: - Collection
+
+    func testCollectsInputModesAndDirtyRows() async {
+        let engine = TerminalEngine(columns: 20, rows: 6)
+        _ = await engine.snapshot()
+
+        let result = await engine.feedCollecting(Data("\u{1B}[?1h\u{1B}[?2004h\u{1B}[3;1Hrow".utf8))
+
+        XCTAssertTrue(result.didProcess)
+        XCTAssertTrue(result.inputModeSnapshot.applicationCursorKeys)
+        XCTAssertTrue(result.inputModeSnapshot.bracketedPasteMode)
+        XCTAssertFalse(result.synchronizedOutput)
+        XCTAssertNil(result.liveSyncSnapshot)
+        XCTAssertEqual(result.dirtyRows, 2...2)
+    }
+
+    func testConsumesSyncExitSnapshotsAndCapturesLiveFrame() async {
+        let engine = TerminalEngine(columns: 20, rows: 4)
+
+        let result = await engine.feedCollecting(Data("\u{1B}[?1049habc\u{1B}[?2026h".utf8))
+
+        XCTAssertTrue(result.synchronizedOutput)
+        XCTAssertTrue(result.usingAlternateBuffer)
+        XCTAssertEqual(result.syncExitSnapshots.count, 1)
+        XCTAssertNotNil(result.liveSyncSnapshot)
+        XCTAssertFalse(engine.mailbox.status.hasSyncExitSnapshots)
+        let remaining = await engine.consumeSyncExitSnapshots()
+        XCTAssertTrue(remaining.isEmpty)
+    }
+
+    // MARK: - Merging
+
+    func testMergeKeepsLatestModesAndUnionsDirtyRows() async {
+        let engine = TerminalEngine(columns: 20, rows: 4)
+        var merged = await engine.feedCollecting(Data("\u{1B}[?2026hx".utf8))
+        let later = await engine.feedCollecting(Data("\u{1B}[4;1Hy\u{1B}[?2026l\u{1B}[?1h".utf8))
+        let firstRows = merged.dirtyRows
+
+        merged.merge(later)
+
+        XCTAssertFalse(merged.synchronizedOutput)
+        XCTAssertNil(merged.liveSyncSnapshot)
+        XCTAssertTrue(merged.inputModeSnapshot.applicationCursorKeys)
+        XCTAssertEqual(merged.dirtyRows?.lowerBound, firstRows?.lowerBound)
+        XCTAssertEqual(merged.dirtyRows?.upperBound, 3)
+    }
+
+    func testMergeIgnoresQueuedResults() {
+        var merged = FeedResult(
+            didProcess: true,
+            inputModeSnapshot: .default,
+            synchronizedOutput: true,
+            dirtyRows: 1...2
+        )
+        var queuedModes = InputModeSnapshot.default
+        queuedModes.applicationKeypad = true
+
+        merged.merge(FeedResult(didProcess: false, inputModeSnapshot: queuedModes))
+
+        XCTAssertTrue(merged.synchronizedOutput)
+        XCTAssertFalse(merged.inputModeSnapshot.applicationKeypad)
+        XCTAssertEqual(merged.dirtyRows, 1...2)
+    }
+}
+#endif
@@ -0,0 +1,112 @@
+// FileDeltaTests.swift
+// ProSSHV2
+//
+// Deltas for remote edits: the rolling checksum against a fresh one at
+// every offset, copies found after insertions and deletions, merged
+// operations, the fallbacks to a single literal, and the sh script that
+// assembles the new version on the host.
+
+#if canImport(XCTest)
+import XCTest
+@testable import ProSSHMac
+
+final class FileDeltaTests: XCTestCase {
+
+    private func text(lines count: Int) -> [UInt8] {
+        Array((0..<count).map { "line \($0): the quick brown fox jumps over the lazy dog\n" }.joined().utf8)
+    }
+
+    /// Builds the new version from `old` the way the host script does.
+    private func apply(_ operations: [FileDelta.Operation], old: [UInt8], new: [UInt8]) -> [UInt8] {
+        operations.flatMap { operation -> [UInt8] in
+            switch operation {
+            case let .copy(offset, length):
+                return Array(old[offset..<(offset + length)])
+            case .literal(let range):
+                return Array(new[range])
+            }
+        }
+    }
+
+    // MARK: - Rolling Checksum
+
+    func testRollingMatchesFreshChecksum() {
+        let bytes = text(lines: 4)
+        let size = 16
+        var rolling = RollingChecksum(bytes[0..<size])
+        for start in 1...(bytes.count - size) {
+            rolling.roll(out: bytes[start - 1], in: bytes[start + size - 1], blockSize: size)
+            XCTAssertEqual(rolling, RollingChecksum(bytes[start..<(start + size)]), "offset \(start)")
+        }
+    }
+
+    // MARK: - Operations
+
+    func testUnchangedFileIsOneCopy() {
+        let old = text(lines: 200)
+        let operations = FileDelta.operations(from: old, to: old, blockSize: 512)
+        XCTAssertEqual(operations.first, .copy(offset: 0, length: old.count / 512 * 512))
+        XCTAssertEqual(apply(operations, old: old, new: old), old)
+        XCTAssertEqual(FileDelta.literalByteCount(operations), old.count % 512)
+    }
+
+    func testInsertionNearTopCostsAboutABlock() {
+        let old = text(lines: 2000)
+        var new = old
+        new.insert(contentsOf: Array("# added by hand\n".utf8), at: 100)
+        let operations = FileDelta.operations(from: old, to: new, blockSize: 512)
+        XCTAssertEqual(apply(operations, old: old, new: new), new)
+        XCTAssertLessThan(FileDelta.literalByteCount(operations), 2 * 512)
+    }
+
+    func testDeletionAndEditInMiddle() {
+        let old = text(lines: 2000)
+        var new = old
+        new.removeSubrange(40_000..<41_000)
+        new.replaceSubrange(70_000..<70_010, with: Array("CHANGED".utf8))
+        let operations = FileDelta.operations(from: old, to: new, blockSize: 512)
+        XCTAssertEqual(apply(operations, old: old, new: new), new)
+        XCTAssertLessThan(FileDelta.literalByteCount(operations), 4 * 512)
+    }
+
+    func testSmallFilesAreOneLiteral() {
+        let new = Array("short\n".utf8)
+        XCTAssertEqual(FileDelta.operations(from: Array("old\n".utf8), to: new), [.literal(0..<new.count)])
+        XCTAssertEqual(FileDelta.operations(from: Array("old\n".utf8), to: []), [])
+    }
+
+    func testBlockSizeIsBounded() {
+        XCTAssertEqual(FileDelta.blockSize(forCount: 0), 512)
+        XCTAssertEqual(FileDelta.blockSize(forCount: 16 * 1024 * 1024), 4096)
+        XCTAssertEqual(FileDelta.blockSize(forCount: Int.max / 2), 64 * 1024)
+    }
+
+    // MARK: - Host Script
+
+    func testScriptAssemblesInOrderAndRenames() {
+        let paths = RemoteEditScript.Paths(target: "/etc/app/it's.conf")
+        XCTAssertEqual(paths.delta, "/etc/app/.it's.conf.prossh-delta")
+        XCTAssertEqual(paths.staging, "/etc/app/.it's.conf.prossh-edit")
+
+        let script = RemoteEditScript.apply(
+            [.copy(offset: 0, length: 1024), .literal(1024..<1040), .copy(offset: 2048, length: 512)],
+            paths: paths,
+            newSize: 1552
+        )
+        let lines = script.components(separatedBy: "\n")
+        XCTAssertTrue(lines.contains(#"tail -c +1 "$t" | head -c 1024"#))
+        XCTAssertTrue(lines.contains(#"tail -c +1 "$d" | head -c 16"#))
+        XCTAssertTrue(lines.contains(#"tail -c +2049 "$t" | head -c 512"#))
+        XCTAssertTrue(script.contains("-eq 1552 ]"))
+        XCTAssertTrue(script.contains(#"t='/etc/app/it'"'"'s.conf'"#))
+        XCTAssertEqual(lines.last(where: { $0.hasPrefix("mv") }), #"mv -f "$n" "$t""#)
+    }
+
+    func testPrepareChecksSizeUnlessForced() {
+        let paths = RemoteEditScript.Paths(target: "/srv/a.txt")
+        XCTAssertTrue(RemoteEditScript.prepare(paths: paths, baseSize: 10).contains("-eq 10 ] || exit \(RemoteEditScript.remoteChangedStatus)"))
+        XCTAssertFalse(RemoteEditScript.prepare(paths: paths, baseSize: nil).contains("wc -c"))
+        XCTAssertTrue(RemoteEditScript.prepare(paths: paths, baseSize: nil).hasSuffix(#"umask 077 && : > "$d""#))
+    }
+}
+#endif
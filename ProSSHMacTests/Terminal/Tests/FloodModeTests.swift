@@ -0,0 +1,110 @@
+// FloodModeTests.swift
+// ProSSHV2
+//
+// Off-grid text layout for output floods: screen, cursor and scrollback
+// must match the regular print path exactly.
+
+#if canImport(XCTest)
+import XCTest
+@testable import ProSSHMac
+
+final class FloodModeTests: XCTestCase {
+
+    // MARK: - Helpers
+
+    private struct GridState: Equatable {
+        var visible: [String]
+        var cursorRow: Int
+        var cursorCol: Int
+        var scrollback: [String]
+    }
+
+    private func render(_ bytes: [UInt8], chunkSize: Int) async -> GridState {
+        let engine = TerminalEngine(columns: 20, rows: 5, maxScrollbackLines: 100_000)
+        var offset = 0
+        while offset < bytes.count {
+            let end = min(bytes.count, offset + chunkSize)
+            await engine.feed(Array(bytes[offset..<end]))
+            offset = end
+        }
+
+        let grid = await engine.grid
+        let buffer = await grid.scrollbackBuffer
+        var scrollback: [String] = []
+        for index in 0..<buffer.count {
+            guard var line = buffer.line(at: index) else { continue }
+            line.trimTrailingBlanks()
+            let text = line.cells.map { "\($0.codepoint):\($0.bgPackedRGBA)" }.joined(separator: ",")
+            scrollback.append("\(line.isWrapped)|\(text)")
+        }
+        let cursor = await grid.cursorPosition()
+        return GridState(
+            visible: await engine.visibleText(),
+            cursorRow: cursor.row,
+            cursorCol: cursor.col,
+            scrollback: scrollback
+        )
+    }
+
+    private func assertFloodMatchesChunked(_ text: String, file: StaticString = #filePath, line: UInt = #line) async {
+        let bytes = Array(text.utf8)
+        XCTAssertGreaterThanOrEqual(bytes.count, TerminalGrid.floodWatermark, file: file, line: line)
+        let flood = await render(bytes, chunkSize: bytes.count)
+        let chunked = await render(bytes, chunkSize: 512)
+        XCTAssertEqual(flood, chunked, file: file, line: line)
+    }
+
+    // MARK: - Parity
+
+    func testPlainLinesMatchRegularPath() async {
+        var text = "prompt$ "
+        for index in 0..<7_000 {
+            text += "line \(index)\r\n"
+        }
+        text += "tail"
+        await assertFloodMatchesChunked(text)
+    }
+
+    func testWrapsOverwritesAndPendingWrapOverLineFeed() async {
+        var text = ""
+        for index in 0..<2_000 {
+            text += String(repeating: "w", count: 45) + "\r\n"   // wraps twice
+            text += "abcdef\rXY\r\n"                              // CR overwrite
+            text += String(repeating: "e", count: 20) + "\n"      // exact width, bare LF
+            text += "\(index)\n"
+        }
+        await assertFloodMatchesChunked(text)
+    }
+
+    func testColoredBackgroundKeepsBlankTail() async {
+        var text = "\u{1B}[44m"
+        for index in 0..<8_000 {
+            text += "bg \(index)\r\n"
+        }
+        await assertFloodMatchesChunked(text)
+    }
+
+    // MARK: - Eligibility
+
+    func testAlternateBufferIsNotEligible() async {
+        let engine = TerminalEngine(columns: 20, rows: 5)
+        await engine.feed(Array("\u{1B}[?1049h\u{1B}[5;1H".utf8))
+        let grid = await engine.grid
+        let bytes = Data(String(repeating: "x\r\n", count: 10).utf8)
+
+        grid.floodMode = true
+        XCTAssertNil(grid.floodTextStart(bytes, range: 0..<bytes.count))
+    }
+
+    func testFloodStartsAfterCursorReachesBottomRow() async {
+        let engine = TerminalEngine(columns: 20, rows: 5)
+        let grid = await engine.grid
+        let bytes = Data(String(repeating: "x\r\n", count: 10).utf8)
+
+        grid.floodMode = true
+        // Four line feeds take the cursor from row 0 to the bottom row.
+        XCTAssertEqual(grid.floodTextStart(bytes, range: 0..<bytes.count), 12)
+        XCTAssertNil(grid.floodTextStart(bytes, range: 0..<24))
+    }
+}
+#endif
@@ -0,0 +1,101 @@
+#if canImport(XCTest)
+import CoreText
+import XCTest
+@testable import ProSSHMac
+
+final class FontFallbackCacheTests: XCTestCase {
+
+    private var storeURL: URL!
+
+    override func setUp() {
+        super.setUp()
+        storeURL = FileManager.default.temporaryDirectory
+            .appendingPathComponent("FontFallbackCacheTests-\(UUID().uuidString).json")
+    }
+
+    override func tearDown() {
+        try? FileManager.default.removeItem(at: storeURL)
+        super.tearDown()
+    }
+
+    // MARK: - Lookup
+
+    func testResolvesOncePerPrimaryFontAndScalar() {
+        let cache = FontFallbackCache(storeURL: nil)
+        let primary = CTFontCreateWithName("Menlo-Regular" as CFString, 13, nil)
+        var calls = 0
+        for _ in 0..<3 {
+            _ = cache.font(for: "A", primaryFont: primary, resolver: .raster) {
+                calls += 1
+                return primary
+            }
+        }
+        XCTAssertEqual(calls, 1)
+        XCTAssertEqual(cache.count, 1)
+    }
+
+    func testSizeChangeReusesResolution() {
+        let cache = FontFallbackCache(storeURL: nil)
+        let fallback = CTFontCreateWithName("Courier" as CFString, 13, nil)
+        var calls = 0
+        let resolve: () -> CTFont = {
+            calls += 1
+            return fallback
+        }
+        _ = cache.font(
+            for: "\u{2603}",
+            primaryFont: CTFontCreateWithName("Menlo-Regular" as CFString, 13, nil),
+            resolver: .raster,
+            resolve: resolve
+        )
+        let larger = cache.font(
+            for: "\u{2603}",
+            primaryFont: CTFontCreateWithName("Menlo-Regular" as CFString, 20, nil),
+            resolver: .raster,
+            resolve: resolve
+        )
+        XCTAssertEqual(calls, 1)
+        XCTAssertEqual(CTFontCopyPostScriptName(larger) as String, CTFontCopyPostScriptName(fallback) as String)
+        XCTAssertEqual(CTFontGetSize(larger), 20)
+    }
+
+    func testResolversAreKeptApart() {
+        let cache = FontFallbackCache(storeURL: nil)
+        let primary = CTFontCreateWithName("Menlo-Regular" as CFString, 13, nil)
+        _ = cache.font(for: "A", primaryFont: primary, resolver: .raster) { primary }
+        _ = cache.font(for: "A", primaryFont: primary, resolver: .fontManager) { primary }
+        XCTAssertEqual(cache.count, 2)
+    }
+
+    // MARK: - Persistence
+
+    func testSavedTableSeedsNextCache() {
+        let primary = CTFontCreateWithName("Menlo-Regular" as CFString, 13, nil)
+        let fallback = CTFontCreateWithName("Courier" as CFString, 13, nil)
+        let first = FontFallbackCache(storeURL: storeURL)
+        _ = first.font(for: "\u{2603}", primaryFont: primary, resolver: .raster) { fallback }
+        first.save()
+
+        let second = FontFallbackCache(storeURL: storeURL)
+        var calls = 0
+        let font = second.font(for: "\u{2603}", primaryFont: primary, resolver: .raster) {
+            calls += 1
+            return primary
+        }
+        XCTAssertEqual(calls, 0)
+        XCTAssertEqual(CTFontCopyPostScriptName(font) as String, CTFontCopyPostScriptName(fallback) as String)
+    }
+
+    func testRemoveAllDeletesTable() {
+        let primary = CTFontCreateWithName("Menlo-Regular" as CFString, 13, nil)
+        let cache = FontFallbackCache(storeURL: storeURL)
+        _ = cache.font(for: "A", primaryFont: primary, resolver: .raster) { primary }
+        cache.save()
+        XCTAssertTrue(FileManager.default.fileExists(atPath: storeURL.path))
+
+        cache.removeAll()
+        XCTAssertEqual(cache.count, 0)
+        XCTAssertFalse(FileManager.default.fileExists(atPath: storeURL.path))
+    }
+}
+#endif
@@ -0,0 +1,82 @@
+// FrameDamageTests.swift
+// ProSSHV2
+//
+// Partial-redraw damage tracking: snapshot damage maps to grid rows, the
+// cursor's old and new rows are always included, and invalidation forces a
+// full redraw exactly once.
+
+#if canImport(XCTest)
+import XCTest
+@testable import ProSSHMac
+
+final class FrameDamageTests: XCTestCase {
+
+    /// A tracker past its initial full redraw.
+    private func primed() -> FrameDamage {
+        var damage = FrameDamage()
+        _ = damage.take(rowCount: 24)
+        return damage
+    }
+
+    // MARK: - Rows
+
+    func testStartsFullAndInvalidationForcesOneFullFrame() {
+        var damage = FrameDamage()
+        XCTAssertNil(damage.take(rowCount: 24))
+        XCTAssertEqual(damage.take(rowCount: 24), 0..<0)
+        XCTAssertTrue(damage.isEmpty)
+
+        damage.add(rows: 2..<3)
+        damage.invalidate()
+        XCTAssertFalse(damage.isEmpty)
+        XCTAssertNil(damage.take(rowCount: 24))
+    }
+
+    func testCellRangesMapToBoundingRows() {
+        var damage = primed()
+        damage.add(cellRanges: [85..<90, 400..<480], columns: 80)
+        XCTAssertEqual(damage.take(rowCount: 24), 1..<6)
+
+        damage.add(cellRanges: [1_900..<1_920], columns: 80)
+        XCTAssertEqual(damage.take(rowCount: 20), 20..<20)
+    }
+
+    // MARK: - Cursor
+
+    func testCursorRowsIncludeGlowAndPreviousPosition() {
+        var damage = primed()
+        damage.add(cursorRow: 10)
+        XCTAssertEqual(damage.take(rowCount: 24), 7..<14)
+
+        damage.add(cursorRow: 12.5)
+        XCTAssertEqual(damage.take(rowCount: 24), 7..<17)
+
+        damage.add(cursorRow: 1)
+        XCTAssertEqual(damage.take(rowCount: 24), 0..<17)
+    }
+
+    func testBlinkTickIsPendingUntilTaken() {
+        var damage = primed()
+        damage.markCursor()
+        XCTAssertFalse(damage.isEmpty)
+        damage.add(cursorRow: 0)
+        XCTAssertEqual(damage.take(rowCount: 24), 0..<4)
+        XCTAssertTrue(damage.isEmpty)
+    }
+
+    // MARK: - Scissor
+
+    func testScissorCoversRowsAndClampsToDrawable() throws {
+        let size = CGSize(width: 800, height: 100)
+        let rect = try XCTUnwrap(FrameDamage.scissorRect(rows: 2..<4, cellHeight: 17.5, drawableSize: size))
+        XCTAssertEqual(rect.x, 0)
+        XCTAssertEqual(rect.y, 35)
+        XCTAssertEqual(rect.width, 800)
+        XCTAssertEqual(rect.height, 35)
+
+        let clamped = try XCTUnwrap(FrameDamage.scissorRect(rows: 5..<9, cellHeight: 17.5, drawableSize: size))
+        XCTAssertEqual(clamped.y + clamped.height, 100)
+        XCTAssertNil(FrameDamage.scissorRect(rows: 6..<8, cellHeight: 17.5, drawableSize: size))
+    }
+}
+#endif
@@ -0,0 +1,126 @@
+// GPUGlyphTableTests.swift
+// ProSSHV2
+//
+// The GPU-resident glyph table: it mirrors GlyphCache through inserts,
+// evictions and clears, survives heavy churn without losing entries, and
+// reports shader hits and misses back to the CPU.
+
+#if canImport(XCTest)
+import XCTest
+import Metal
+@testable import ProSSHMac
+
+final class GPUGlyphTableTests: XCTestCase {
+
+    private func makeDevice() throws -> MTLDevice {
+        guard let device = MTLCreateSystemDefaultDevice() else {
+            throw XCTSkip("No Metal device available")
+        }
+        return device
+    }
+
+    private func key(_ codepoint: UInt32, bold: Bool = false, italic: Bool = false) -> GlyphKey {
+        GlyphKey(codepoint: codepoint, bold: bold, italic: italic)
+    }
+
+    private func entry(x: UInt16) -> AtlasEntry {
+        AtlasEntry(atlasPage: 1, x: x, y: 2, width: 8, bearingX: 0, bearingY: 0)
+    }
+
+    // MARK: - Keys
+
+    func testPackedKeyRoundTripsStyle() {
+        for glyphKey in [key(0x41), key(0x41, bold: true), key(0x10FFFF, italic: true), key(0x4E2D, bold: true, italic: true)] {
+            let packed = GPUGlyphTable.packKey(glyphKey)
+            XCTAssertEqual(GPUGlyphTable.unpackKey(packed), glyphKey)
+            XCTAssertNotEqual(packed, GPUGlyphTable.emptyKey)
+            XCTAssertNotEqual(packed, GPUGlyphTable.tombstoneKey)
+        }
+    }
+
+    // MARK: - Table
+
+    func testInsertRemoveAndChurn() throws {
+        let table = GPUGlyphTable(device: try makeDevice(), minimumCapacity: 64)
+        XCTAssertEqual(table.capacity, 128)
+
+        table.insert(key(0x41), value: 7)
+        table.insert(key(0x41, bold: true), value: 8)
+        XCTAssertEqual(table.lookup(key(0x41)), 7)
+        XCTAssertEqual(table.lookup(key(0x41, bold: true)), 8)
+        XCTAssertNil(table.lookup(key(0x41, italic: true)))
+
+        table.remove(key(0x41))
+        XCTAssertNil(table.lookup(key(0x41)))
+        XCTAssertEqual(table.lookup(key(0x41, bold: true)), 8)
+
+        // Far more insert/remove cycles than slots: tombstones must be
+        // reclaimed by rebuilds without dropping live entries.
+        for round: UInt32 in 0..<2_000 {
+            table.insert(key(0x1000 + round), value: round)
+            if round >= 40 {
+                table.remove(key(0x1000 + round - 40))
+            }
+        }
+        XCTAssertEqual(table.count, 41)
+        XCTAssertEqual(table.lookup(key(0x41, bold: true)), 8)
+        for round: UInt32 in 1_960..<2_000 {
+            XCTAssertEqual(table.lookup(key(0x1000 + round)), round)
+        }
+    }
+
+    func testUsedKeysAreDrainedOnce() throws {
+        let table = GPUGlyphTable(device: try makeDevice(), minimumCapacity: 16)
+        table.insert(key(0x42), value: 1)
+        let usage = try XCTUnwrap(table.usageBuffer).contents().bindMemory(to: UInt8.self, capacity: table.capacity)
+        let slots = try XCTUnwrap(table.buffer).contents().bindMemory(to: SIMD2<UInt32>.self, capacity: table.capacity)
+        let slot = try XCTUnwrap((0..<table.capacity).first { slots[$0].x == GPUGlyphTable.packKey(key(0x42)) })
+
+        usage[slot] = 1
+        XCTAssertEqual(table.drainUsedKeys(), [key(0x42)])
+        XCTAssertEqual(table.drainUsedKeys(), [])
+    }
+
+    // MARK: - Cache Mirror
+
+    func testCacheKeepsTableInStep() throws {
+        let table = GPUGlyphTable(device: try makeDevice(), minimumCapacity: 2)
+        let cache = GlyphCache(maxCapacity: 2)
+        cache.table = table
+
+        cache.insert(key(0x41), entry: entry(x: 10))
+        cache.insert(key(0x42), entry: entry(x: 20))
+        XCTAssertEqual(table.lookup(key(0x41)), GlyphIndexPacking.pack(entry(x: 10)))
+
+        // Evicts 0x41, the least recently used.
+        cache.insert(key(0x43), entry: entry(x: 30))
+        XCTAssertNil(table.lookup(key(0x41)))
+        XCTAssertEqual(table.lookup(key(0x43)), GlyphIndexPacking.pack(entry(x: 30)))
+
+        cache.remove(key(0x42))
+        XCTAssertNil(table.lookup(key(0x42)))
+
+        cache.clear()
+        XCTAssertEqual(table.count, 0)
+        XCTAssertNil(table.lookup(key(0x43)))
+    }
+
+    // MARK: - Miss Log
+
+    func testMissLogDeduplicatesAndResets() throws {
+        let log = try XCTUnwrap(GlyphMissLog(device: try makeDevice()))
+        let words = log.buffer.contents().bindMemory(to: UInt32.self, capacity: 4 + GlyphMissLog.capacity)
+        words[0] = 3
+        words[4] = 100
+        words[5] = 101
+        words[6] = 100
+
+        XCTAssertEqual(log.drain(), [100, 101])
+        XCTAssertEqual(log.drain(), [])
+
+        // An overflowing frame reports only what fit.
+        words[0] = UInt32(GlyphMissLog.capacity + 50)
+        XCTAssertLessThanOrEqual(log.drain().count, GlyphMissLog.capacity)
+    }
+}
+#endif
@@ -0,0 +1,160 @@
+// GlyphAtlasStoreTests.swift
+// ProSSHV2
+//
+// Shared glyph storage: renderers with the same font, size and scale get
+// one atlas, storage dies with its last holder once it is no longer among
+// the recently used, and evictions reach every sharer so none keeps
+// sampling a recycled slot. A full atlas evicts to make room, and
+// compaction releases emptied pages.
+
+#if canImport(XCTest)
+import XCTest
+import Metal
+@testable import ProSSHMac
+
+final class GlyphAtlasStoreTests: XCTestCase {
+
+    private final class EvictionCounter: GlyphEvictionObserver {
+        var count = 0
+        func sharedGlyphsEvicted() { count += 1 }
+    }
+
+    private func makeDevice() throws -> MTLDevice {
+        guard let device = MTLCreateSystemDefaultDevice() else {
+            throw XCTSkip("No Metal device available")
+        }
+        return device
+    }
+
+    private func key(_ device: MTLDevice, fontSize: CGFloat = 14, cellSize: Int = 17) -> GlyphAtlasKey {
+        GlyphAtlasKey(
+            deviceID: device.registryID,
+            fontName: "Menlo",
+            fontSize: fontSize,
+            scale: 2,
+            cellWidth: cellSize,
+            cellHeight: cellSize * 2
+        )
+    }
+
+    /// A blank narrow glyph for 4x8 cells.
+    private func glyph() -> RasterizedGlyph {
+        RasterizedGlyph(
+            pixelData: [UInt8](repeating: 0xFF, count: 4 * 8 * 4),
+            width: 4, height: 8, bearingX: 0, bearingY: 0, isColor: false, isWide: false
+        )
+    }
+
+    // MARK: - Sharing
+
+    func testSameKeySharesStorage() throws {
+        let device = try makeDevice()
+        let store = GlyphAtlasStore()
+        let first = store.storage(for: key(device), device: device)
+        let second = store.storage(for: key(device), device: device)
+        let other = store.storage(for: key(device, fontSize: 16), device: device)
+
+        XCTAssertTrue(first === second)
+        XCTAssertFalse(first === other)
+        XCTAssertEqual(first.atlas.pageCount, 1)
+    }
+
+    func testStorageIsFreedWithLastHolder() throws {
+        let device = try makeDevice()
+        let store = GlyphAtlasStore(residentLimit: 0)
+        weak var released: SharedGlyphStorage?
+        do {
+            let storage = store.storage(for: key(device), device: device)
+            released = storage
+            XCTAssertEqual(store.liveStorageCount, 1)
+        }
+        XCTAssertNil(released)
+        XCTAssertEqual(store.liveStorageCount, 0)
+    }
+
+    func testRecentStoragesStayResident() throws {
+        let device = try makeDevice()
+        let store = GlyphAtlasStore(residentLimit: 2)
+        weak var oldest: SharedGlyphStorage?
+        weak var recent: SharedGlyphStorage?
+        do {
+            oldest = store.storage(for: key(device, fontSize: 12), device: device)
+            recent = store.storage(for: key(device, fontSize: 14), device: device)
+            _ = store.storage(for: key(device, fontSize: 16), device: device)
+        }
+        XCTAssertNil(oldest)
+        XCTAssertNotNil(recent)
+        XCTAssertTrue(store.storage(for: key(device, fontSize: 14), device: device) === recent)
+        XCTAssertEqual(store.liveStorageCount, 2)
+
+        store.releaseResident()
+        XCTAssertNil(recent)
+        XCTAssertEqual(store.liveStorageCount, 0)
+    }
+
+    // MARK: - Eviction
+
+    func testEvictionNotifiesEverySharer() throws {
+        let device = try makeDevice()
+        let storage = SharedGlyphStorage(key: key(device), device: device, cacheCapacity: 1)
+        let first = EvictionCounter()
+        let second = EvictionCounter()
+        storage.addEvictionObserver(first)
+        storage.addEvictionObserver(second)
+
+        let entry = AtlasEntry(atlasPage: 0, x: 0, y: 0, width: 17, bearingX: 0, bearingY: 0)
+        storage.cache.insert(GlyphKey(codepoint: 0x41, bold: false, italic: false), entry: entry)
+        storage.cache.insert(GlyphKey(codepoint: 0x42, bold: false, italic: false), entry: entry)
+
+        XCTAssertEqual(first.count, 1)
+        XCTAssertEqual(second.count, 1)
+        XCTAssertEqual(storage.atlas.freeSlotCount, 1)
+
+        storage.removeEvictionObserver(second)
+        storage.cache.insert(GlyphKey(codepoint: 0x43, bold: false, italic: false), entry: entry)
+        XCTAssertEqual(first.count, 2)
+        XCTAssertEqual(second.count, 1)
+    }
+
+    func testFullAtlasEvictsColdestGlyph() throws {
+        let device = try makeDevice()
+        // 8x8 pages hold two 4x8 glyphs; eight coverage pages hold 16.
+        let storage = SharedGlyphStorage(key: key(device, cellSize: 4), device: device, cacheCapacity: 64, pageSize: 8)
+        for codepoint: UInt32 in 0x100..<0x110 {
+            let entry = try XCTUnwrap(storage.allocate(glyph()))
+            storage.cache.insert(GlyphKey(codepoint: codepoint, bold: false, italic: false), entry: entry)
+        }
+
+        XCTAssertNotNil(storage.allocate(glyph()))
+        XCTAssertEqual(storage.stats.evictions, 1)
+        XCTAssertNil(storage.cache.lookup(GlyphKey(codepoint: 0x100, bold: false, italic: false)))
+    }
+
+    // MARK: - Compaction
+
+    func testCompactionReleasesDrainedPage() throws {
+        let device = try makeDevice()
+        let storage = SharedGlyphStorage(key: key(device, cellSize: 4), device: device, cacheCapacity: 64, pageSize: 8)
+        let observer = EvictionCounter()
+        storage.addEvictionObserver(observer)
+        let keys = (0x100..<0x104).map { GlyphKey(codepoint: UInt32($0), bold: false, italic: false) }
+        for glyphKey in keys {
+            storage.cache.insert(glyphKey, entry: try XCTUnwrap(storage.allocate(glyph())))
+        }
+        XCTAssertEqual(storage.atlas.pageCount, 2)
+
+        for glyphKey in keys.prefix(2) {
+            storage.atlas.reclaimRegion(entry: try XCTUnwrap(storage.cache.remove(glyphKey)))
+        }
+        storage.compactNow()
+
+        let stats = storage.stats
+        XCTAssertEqual(stats.atlas.pages, 1)
+        XCTAssertEqual(stats.relocatedGlyphs, 2)
+        XCTAssertEqual(stats.releasedPages, 1)
+        XCTAssertEqual(storage.cache.lookup(keys[2])?.atlasPage, 0)
+        XCTAssertEqual(storage.cache.lookup(keys[3])?.atlasPage, 0)
+        XCTAssertEqual(observer.count, 1, "Sharers re-resolve glyphs after a page is released")
+    }
+}
+#endif
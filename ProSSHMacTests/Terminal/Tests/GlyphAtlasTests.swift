@@ -0,0 +1,128 @@
+// GlyphAtlasTests.swift
+// ProSSHV2
+//
+// Text glyphs land on single-channel coverage pages and colour emoji on
+// BGRA pages; the page index alone tells the shader which it samples.
+// Compaction moves glyphs off the last page and releases it.
+
+#if canImport(XCTest)
+import XCTest
+import Metal
+@testable import ProSSHMac
+
+final class GlyphAtlasTests: XCTestCase {
+
+    private func makeAtlas(pageSize: Int = GlyphAtlas.defaultPageSize) throws -> GlyphAtlas {
+        guard let device = MTLCreateSystemDefaultDevice() else {
+            throw XCTSkip("No Metal device available")
+        }
+        let atlas = GlyphAtlas(device: device, cellWidth: 4, cellHeight: 4, pageSize: pageSize)
+        atlas.rebuild(cellWidth: 4, cellHeight: 4)
+        return atlas
+    }
+
+    /// A 4x4 BGRA bitmap whose alpha byte is `alpha` and colour bytes differ.
+    private func bitmap(alpha: UInt8) -> [UInt8] {
+        (0..<16).flatMap { _ in [0x10, 0x20, 0x30, alpha] }
+    }
+
+    // MARK: - Placement
+
+    func testTextGlyphGoesToCoveragePage() throws {
+        let atlas = try makeAtlas()
+        let pixels = bitmap(alpha: 0xAB)
+        let entry = try XCTUnwrap(pixels.withUnsafeBytes {
+            atlas.allocate(width: 4, height: 4, pixelData: $0.baseAddress!)
+        })
+
+        XCTAssertFalse(GlyphAtlas.isColorPage(entry.atlasPage))
+        let texture = try XCTUnwrap(atlas.texture(forPage: Int(entry.atlasPage)))
+        XCTAssertEqual(texture.pixelFormat, .r8Unorm)
+
+        var readBack = [UInt8](repeating: 0, count: 16)
+        texture.getBytes(
+            &readBack,
+            bytesPerRow: 4,
+            from: MTLRegion(origin: MTLOrigin(x: Int(entry.x), y: Int(entry.y), z: 0), size: MTLSize(width: 4, height: 4, depth: 1)),
+            mipmapLevel: 0
+        )
+        XCTAssertEqual(readBack, [UInt8](repeating: 0xAB, count: 16))
+    }
+
+    func testColorGlyphGoesToColorPage() throws {
+        let atlas = try makeAtlas()
+        let pixels = bitmap(alpha: 0xFF)
+        let entry = try XCTUnwrap(pixels.withUnsafeBytes {
+            atlas.allocate(width: 4, height: 4, pixelData: $0.baseAddress!, isColor: true)
+        })
+
+        XCTAssertEqual(Int(entry.atlasPage), GlyphAtlas.colorPageBase)
+        XCTAssertEqual(atlas.texture(forPage: Int(entry.atlasPage))?.pixelFormat, .bgra8Unorm)
+        XCTAssertEqual(atlas.colorPageCount, 1)
+        XCTAssertEqual(atlas.estimatedMemoryBytes, atlas.pageSize * atlas.pageSize * 5)
+    }
+
+    func testReclaimedSlotsStayInTheirPool() throws {
+        let atlas = try makeAtlas()
+        let pixels = bitmap(alpha: 0xFF)
+        let color = try XCTUnwrap(pixels.withUnsafeBytes {
+            atlas.allocate(width: 4, height: 4, pixelData: $0.baseAddress!, isColor: true)
+        })
+        atlas.reclaimRegion(entry: color)
+
+        let text = try XCTUnwrap(pixels.withUnsafeBytes {
+            atlas.allocate(width: 4, height: 4, pixelData: $0.baseAddress!)
+        })
+        XCTAssertFalse(GlyphAtlas.isColorPage(text.atlasPage))
+        XCTAssertEqual(atlas.freeSlotCount, 1)
+        XCTAssertEqual(atlas.recycledAllocations, 0)
+    }
+
+    // MARK: - Compaction
+
+    func testLastPageIsDrainedAndReleased() throws {
+        // 8x8 pages hold four 4x4 glyphs; the fifth opens page 1.
+        let atlas = try makeAtlas(pageSize: 8)
+        var entries: [AtlasEntry] = []
+        for alpha: UInt8 in 1...5 {
+            let pixels = bitmap(alpha: alpha)
+            entries.append(try XCTUnwrap(pixels.withUnsafeBytes {
+                atlas.allocate(width: 4, height: 4, pixelData: $0.baseAddress!)
+            }))
+        }
+        XCTAssertEqual(atlas.pageCount, 2)
+        XCTAssertEqual(atlas.occupancy, GlyphAtlas.Occupancy(pages: 2, capacity: 8, liveGlyphs: 5, freeSlots: 0))
+        XCTAssertNil(atlas.compactionCandidatePage(), "Nowhere to move page 1's glyph yet")
+
+        atlas.reclaimRegion(entry: entries[1])
+        XCTAssertEqual(atlas.compactionCandidatePage(), 1)
+
+        let moved = try XCTUnwrap(atlas.relocate(entries[4]))
+        XCTAssertEqual(moved.atlasPage, 0)
+        XCTAssertEqual(moved.x, entries[1].x)
+        XCTAssertEqual(moved.y, entries[1].y)
+        let texture = try XCTUnwrap(atlas.texture(forPage: 0))
+        var readBack = [UInt8](repeating: 0, count: 16)
+        texture.getBytes(
+            &readBack,
+            bytesPerRow: 4,
+            from: MTLRegion(origin: MTLOrigin(x: Int(moved.x), y: Int(moved.y), z: 0), size: MTLSize(width: 4, height: 4, depth: 1)),
+            mipmapLevel: 0
+        )
+        XCTAssertEqual(readBack, [UInt8](repeating: 5, count: 16))
+
+        XCTAssertTrue(atlas.releaseLastPage(1))
+        XCTAssertEqual(atlas.pageCount, 1)
+        XCTAssertEqual(atlas.releasedPageCount, 1)
+        XCTAssertEqual(atlas.occupancy, GlyphAtlas.Occupancy(pages: 1, capacity: 4, liveGlyphs: 4, freeSlots: 0))
+        XCTAssertFalse(atlas.releaseLastPage(0), "The first coverage page is kept")
+
+        // The next allocation opens a fresh page rather than overwriting page 0.
+        let pixels = bitmap(alpha: 6)
+        let next = try XCTUnwrap(pixels.withUnsafeBytes {
+            atlas.allocate(width: 4, height: 4, pixelData: $0.baseAddress!)
+        })
+        XCTAssertEqual(next.atlasPage, 1)
+    }
+}
+#endif
@@ -0,0 +1,103 @@
+// GlyphCacheTests.swift
+// ProSSHV2
+//
+// Frequency-aware glyph cache eviction: pinned glyphs never leave, a
+// frequently used glyph outlives a burst of one-off glyphs, and targeted
+// eviction only picks entries of the requested kind.
+
+#if canImport(XCTest)
+import XCTest
+@testable import ProSSHMac
+
+@MainActor
+final class GlyphCacheTests: XCTestCase {
+
+    private func key(_ codepoint: UInt32) -> GlyphKey {
+        GlyphKey(codepoint: codepoint, bold: false, italic: false)
+    }
+
+    private func entry(page: UInt8 = 0, x: UInt16 = 0, width: UInt8 = 8) -> AtlasEntry {
+        AtlasEntry(atlasPage: page, x: x, y: 0, width: width, bearingX: 0, bearingY: 0)
+    }
+
+    // MARK: - Eviction
+
+    func testPinnedEntrySurvivesChurn() {
+        let cache = GlyphCache(maxCapacity: 4)
+        cache.insert(key(0x41), entry: entry(), pinned: true)
+        for codepoint: UInt32 in 0x1000..<0x1040 {
+            cache.insert(key(codepoint), entry: entry())
+        }
+        XCTAssertNotNil(cache.lookup(key(0x41)))
+        XCTAssertEqual(cache.pinnedCount, 1)
+        XCTAssertEqual(cache.count, 4)
+    }
+
+    func testFrequentEntryOutlivesBurst() {
+        let cache = GlyphCache(maxCapacity: 16)
+        cache.insert(key(0x41), entry: entry())
+        for _ in 0..<32 {
+            _ = cache.lookup(key(0x41))
+        }
+        // Enough one-off glyphs to push 0x41 to the LRU tail many times.
+        for codepoint: UInt32 in 0x4E00..<0x4E10 {
+            cache.insert(key(codepoint), entry: entry())
+        }
+        XCTAssertNotNil(cache.lookup(key(0x41)))
+        XCTAssertGreaterThan(cache.evictionCount, 0)
+    }
+
+    func testFullyPinnedCacheGrowsInsteadOfEvicting() {
+        let cache = GlyphCache(maxCapacity: 2)
+        for codepoint: UInt32 in 0x41..<0x44 {
+            cache.insert(key(codepoint), entry: entry(), pinned: true)
+        }
+        XCTAssertEqual(cache.count, 3)
+        XCTAssertEqual(cache.evictionCount, 0)
+    }
+
+    func testEvictColdestHonoursPredicate() {
+        let cache = GlyphCache(maxCapacity: 16)
+        var evicted: [AtlasEntry] = []
+        cache.onEvict = { evicted.append($0) }
+        cache.insert(key(0x41), entry: entry(page: 0))
+        cache.insert(key(0x42), entry: entry(page: 8))
+        cache.insert(key(0x43), entry: entry(page: 8), pinned: true)
+
+        XCTAssertTrue(cache.evictColdest { GlyphAtlas.isColorPage($0.atlasPage) })
+        XCTAssertEqual(evicted.map(\.atlasPage), [8])
+        XCTAssertNil(cache.lookup(key(0x42)))
+        XCTAssertFalse(cache.evictColdest { GlyphAtlas.isColorPage($0.atlasPage) }, "Pinned entries are never picked")
+        XCTAssertNotNil(cache.lookup(key(0x41)))
+    }
+
+    // MARK: - Relocation
+
+    func testRelocateKeepsEntryCachedAtItsNewPlace() {
+        let cache = GlyphCache(maxCapacity: 8)
+        cache.insert(key(0x41), entry: entry(page: 1), pinned: true)
+        cache.insert(key(0x42), entry: entry(page: 0))
+        XCTAssertEqual(cache.entries(onPage: 1).map(\.key), [key(0x41)])
+
+        cache.relocate(key(0x41), to: entry(page: 0, x: 8))
+        XCTAssertTrue(cache.entries(onPage: 1).isEmpty)
+        let moved = cache.lookup(key(0x41))
+        XCTAssertEqual(moved?.atlasPage, 0)
+        XCTAssertEqual(moved?.x, 8)
+        XCTAssertEqual(cache.pinnedCount, 1)
+    }
+
+    // MARK: - Pre-Population
+
+    func testPrePopulatedKeysMatchPrePopulateASCII() {
+        let cache = GlyphCache(maxCapacity: 1024)
+        var filled: [GlyphKey] = []
+        cache.prePopulateASCII { glyphKey in
+            filled.append(glyphKey)
+            return nil
+        }
+        XCTAssertEqual(filled, GlyphCache.prePopulatedKeys)
+        XCTAssertEqual(GlyphCache.prePopulatedKeys.count, 3 * (95 + 128))
+    }
+}
+#endif
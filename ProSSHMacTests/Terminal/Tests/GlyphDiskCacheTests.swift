@@ -0,0 +1,118 @@
+// GlyphDiskCacheTests.swift
+// ProSSHV2
+//
+// The on-disk pre-populated glyph set: bitmaps round-trip with text stored
+// as coverage, files are keyed by everything but the device, and truncated
+// or foreign files are rejected rather than uploaded.
+
+#if canImport(XCTest)
+import XCTest
+@testable import ProSSHMac
+
+final class GlyphDiskCacheTests: XCTestCase {
+
+    // MARK: - Helpers
+
+    private func makeCache() throws -> GlyphDiskCache {
+        let directory = FileManager.default.temporaryDirectory
+            .appendingPathComponent("GlyphDiskCacheTests-\(UUID().uuidString)", isDirectory: true)
+        try FileManager.default.createDirectory(at: directory, withIntermediateDirectories: true)
+        addTeardownBlock { try? FileManager.default.removeItem(at: directory) }
+        return GlyphDiskCache(directory: directory)
+    }
+
+    private func key(deviceID: UInt64 = 1, fontSize: CGFloat = 14) -> GlyphAtlasKey {
+        GlyphAtlasKey(
+            deviceID: deviceID,
+            fontName: "Menlo",
+            fontSize: fontSize,
+            scale: 2,
+            cellWidth: 17,
+            cellHeight: 34
+        )
+    }
+
+    private func textGlyph() -> RasterizedGlyph {
+        // 2x1 premultiplied BGRA, coverage 0x40 and 0xFF.
+        RasterizedGlyph(
+            pixelData: [0x40, 0x40, 0x40, 0x40, 0xFF, 0xFF, 0xFF, 0xFF],
+            width: 2,
+            height: 1,
+            bearingX: -1,
+            bearingY: 12,
+            isColor: false,
+            isWide: false
+        )
+    }
+
+    private func colorGlyph() -> RasterizedGlyph {
+        RasterizedGlyph(
+            pixelData: [1, 2, 3, 4],
+            width: 1,
+            height: 1,
+            bearingX: 0,
+            bearingY: 10,
+            isColor: true,
+            isWide: false
+        )
+    }
+
+    // MARK: - Encoding
+
+    func testRoundTripStoresTextAsCoverage() throws {
+        let bold = GlyphKey(codepoint: 0x41, bold: true, italic: false)
+        let emoji = GlyphKey(codepoint: 0x1F600, bold: false, italic: true)
+        let data = GlyphDiskCache.encode([(bold, textGlyph()), (emoji, colorGlyph())])
+
+        let glyphs = try XCTUnwrap(GlyphDiskCache.decode(data))
+        XCTAssertEqual(glyphs.count, 2)
+        XCTAssertEqual(glyphs[0].key, bold)
+        XCTAssertEqual(glyphs[0].bearingX, -1)
+        XCTAssertEqual(glyphs[0].bearingY, 12)
+        XCTAssertFalse(glyphs[0].isColor)
+        XCTAssertEqual(glyphs[1].key, emoji)
+        XCTAssertTrue(glyphs[1].isColor)
+
+        let contents = GlyphDiskCache.Contents(data: data, glyphs: glyphs)
+        let coverage = contents.withPixels(of: glyphs[0]) { Array(UnsafeRawBufferPointer(start: $0, count: 2)) }
+        let color = contents.withPixels(of: glyphs[1]) { Array(UnsafeRawBufferPointer(start: $0, count: 4)) }
+        XCTAssertEqual(coverage, [0x40, 0xFF])
+        XCTAssertEqual(color, [1, 2, 3, 4])
+    }
+
+    func testTruncatedOrForeignDataIsRejected() {
+        let key = GlyphKey(codepoint: 0x41, bold: false, italic: false)
+        let data = GlyphDiskCache.encode([(key, textGlyph())])
+
+        XCTAssertNil(GlyphDiskCache.decode(data.prefix(data.count - 1)))
+        XCTAssertNil(GlyphDiskCache.decode(data + Data([0])))
+
+        var otherVersion = data
+        otherVersion[4] &+= 1
+        XCTAssertNil(GlyphDiskCache.decode(otherVersion))
+    }
+
+    // MARK: - Files
+
+    func testFileIsKeyedByFontButNotDevice() throws {
+        let cache = try makeCache()
+        XCTAssertEqual(cache.fileURL(for: key(deviceID: 1)), cache.fileURL(for: key(deviceID: 2)))
+        XCTAssertNotEqual(cache.fileURL(for: key()), cache.fileURL(for: key(fontSize: 15)))
+    }
+
+    func testLoadMapsWrittenFileAndDropsCorruptOne() throws {
+        let cache = try makeCache()
+        let glyphKey = GlyphKey(codepoint: 0x2500, bold: false, italic: false)
+        let url = cache.fileURL(for: key())
+        try GlyphDiskCache.encode([(glyphKey, textGlyph())]).write(to: url)
+
+        let contents = try XCTUnwrap(cache.load(key()))
+        XCTAssertEqual(contents.glyphs.map(\.key), [glyphKey])
+        XCTAssertNil(cache.load(key(fontSize: 15)))
+
+        try Data([0, 1, 2]).write(to: url)
+        XCTAssertNil(cache.load(key()))
+        XCTAssertFalse(FileManager.default.fileExists(atPath: url.path))
+    }
+}
+#endif
@@ -0,0 +1,70 @@
+// GlyphRasterPoolTests.swift
+// ProSSHV2
+//
+// Parallel glyph rasterization: keys are sharded without loss or
+// duplication, and every renderable key comes back exactly once in
+// bounded batches.
+
+#if canImport(XCTest)
+import XCTest
+import CoreText
+@testable import ProSSHMac
+
+final class GlyphRasterPoolTests: XCTestCase {
+
+    private final class BatchLog: @unchecked Sendable {
+        private let lock = NSLock()
+        private(set) var batchSizes: [Int] = []
+        private(set) var keys: [GlyphKey] = []
+
+        func record(_ batch: GlyphRasterPool.Batch) {
+            lock.lock()
+            defer { lock.unlock() }
+            batchSizes.append(batch.count)
+            keys.append(contentsOf: batch.map(\.key))
+        }
+    }
+
+    private func keys(_ range: ClosedRange<UInt32>) -> [GlyphKey] {
+        range.map { GlyphKey(codepoint: $0, bold: false, italic: false) }
+    }
+
+    // MARK: - Sharding
+
+    func testShardingCoversEveryKeyOnce() {
+        let input = keys(0x41...0x41 + 99)
+        let shards = GlyphRasterPool.shard(input, workerCount: 4, batchSize: 16)
+
+        XCTAssertEqual(shards.count, 4)
+        XCTAssertEqual(Set(shards.flatMap { $0 }), Set(input))
+        XCTAssertEqual(shards.map(\.count).reduce(0, +), input.count)
+        XCTAssertLessThanOrEqual(shards.map(\.count).max()! - shards.map(\.count).min()!, 1)
+    }
+
+    func testSmallRunsUseFewerShards() {
+        XCTAssertEqual(GlyphRasterPool.shard(keys(0x41...0x45), workerCount: 8, batchSize: 16).count, 1)
+        XCTAssertEqual(GlyphRasterPool.shard(keys(0x41...0x41 + 20), workerCount: 8, batchSize: 16).count, 2)
+        XCTAssertTrue(GlyphRasterPool.shard([], workerCount: 8, batchSize: 16).isEmpty)
+    }
+
+    // MARK: - Rasterization
+
+    func testEveryKeyArrivesInBoundedBatches() async {
+        let font = CTFontCreateWithName("Menlo" as CFString, 24, nil)
+        let fontSet = RasterFontSet(regular: font, bold: font, italic: font, boldItalic: font)
+        let input = keys(0x21...0x7E)
+        let log = BatchLog()
+
+        await GlyphRasterPool(workerCount: 4).rasterize(
+            input, cellWidth: 15, cellHeight: 30, fontSet: fontSet
+        ) { batch in
+            log.record(batch)
+        }
+
+        XCTAssertEqual(log.keys.count, input.count)
+        XCTAssertEqual(Set(log.keys), Set(input))
+        XCTAssertTrue(log.batchSizes.allSatisfy { $0 <= GlyphRasterPool.batchSize })
+        XCTAssertGreaterThan(log.batchSizes.count, 1)
+    }
+}
+#endif
@@ -0,0 +1,142 @@
+// GlyphShapingCacheTests.swift
+// ProSSHV2
+//
+// Run-level shaping: row segmentation into same-style runs, cache hits and
+// synthetic tile codepoints, snapshot substitution, and CoreText detection
+// of runs whose shaping differs from per-codepoint drawing.
+
+#if canImport(XCTest)
+import XCTest
+import CoreText
+@testable import ProSSHMac
+
+final class GlyphShapingCacheTests: XCTestCase {
+
+    private func cells(_ text: String, style: UInt8 = 0) -> [ShapingCell] {
+        text.unicodeScalars.map { scalar in
+            GlyphShapingCache.shapingCell(
+                codepoint: scalar.value,
+                attributes: style & ShapingCell.boldStyle != 0 ? CellAttributes.bold.rawValue : 0
+            )
+        }
+    }
+
+    // MARK: - Segmentation
+
+    func testRunsSplitAtBlanksAndSkipSingleCells() {
+        XCTAssertEqual(GlyphShapingCache.runs(in: cells("a -> !== x")), [2..<4, 5..<8])
+    }
+
+    func testRunsSplitAtStyleChange() {
+        let row = cells("=>", style: 0) + cells("=>", style: ShapingCell.boldStyle)
+        XCTAssertEqual(GlyphShapingCache.runs(in: row), [0..<2, 2..<4])
+    }
+
+    func testRunsAreCappedAtMaxLength() {
+        let row = cells(String(repeating: "=", count: GlyphShapingCache.maxRunLength + 10))
+        XCTAssertEqual(GlyphShapingCache.runs(in: row), [0..<GlyphShapingCache.maxRunLength, GlyphShapingCache.maxRunLength..<(GlyphShapingCache.maxRunLength + 10)])
+    }
+
+    func testDedicatedPathCodepointsBreakRuns() {
+        XCTAssertFalse(GlyphShapingCache.isShapeable(0x20))
+        XCTAssertFalse(GlyphShapingCache.isShapeable(0x2500), "Box drawing keeps its own rasterization")
+        XCTAssertFalse(GlyphShapingCache.isShapeable(0xE0B0), "Powerline symbols are private use")
+        XCTAssertFalse(GlyphShapingCache.isShapeable(0x1F600), "Emoji draw through the color path")
+        XCTAssertFalse(GlyphShapingCache.isShapeable(GlyphShapingCache.firstSyntheticCodepoint))
+        XCTAssertTrue(GlyphShapingCache.isShapeable(0x0633), "Arabic letters shape")
+
+        let wide = GlyphShapingCache.shapingCell(codepoint: 0x4E2D, attributes: CellAttributes.wideChar.rawValue)
+        XCTAssertEqual(wide, .runBreak)
+    }
+
+    // MARK: - Cache
+
+    @MainActor
+    func testLookupHitsAfterStore() {
+        let cache = GlyphShapingCache()
+        let plain = ShapingRunKey(scalars: [0x61, 0x62], style: 0)
+        let shaped = ShapingRunKey(scalars: [0x2D, 0x3E], style: ShapingCell.boldStyle)
+
+        XCTAssertNil(cache.lookup(plain))
+        cache.storePlain(plain)
+        XCTAssertEqual(cache.lookup(plain), .plain)
+
+        let codepoints = cache.storeShaped(shaped, coverage: [true, false])
+        XCTAssertEqual(cache.lookup(shaped), .shaped(codepoints))
+        XCTAssertEqual(codepoints[1], 0, "Cells without coverage draw nothing")
+        XCTAssertTrue(GlyphShapingCache.isSynthetic(codepoints[0]))
+        XCTAssertEqual(cache.source(of: codepoints[0])?.key, shaped)
+        XCTAssertEqual(cache.hits, 2)
+        XCTAssertEqual(cache.misses, 1)
+    }
+
+    @MainActor
+    func testOverflowStartsOverAndBumpsGeneration() {
+        let cache = GlyphShapingCache(maxEntries: 2)
+        let first = cache.storeShaped(ShapingRunKey(scalars: [0x3D, 0x3D], style: 0), coverage: [true, true])
+        cache.storePlain(ShapingRunKey(scalars: [0x61, 0x62], style: 0))
+        XCTAssertEqual(cache.generation, 0)
+
+        cache.storePlain(ShapingRunKey(scalars: [0x63, 0x64], style: 0))
+        XCTAssertEqual(cache.generation, 1)
+        XCTAssertEqual(cache.count, 1)
+        XCTAssertNil(cache.source(of: first[0]))
+    }
+
+    @MainActor
+    func testSyntheticKeysStayClearOfTableSentinels() {
+        let last = GlyphKey(codepoint: GlyphShapingCache.syntheticCodepointLimit - 1, bold: true, italic: true)
+        XCTAssertLessThan(GPUGlyphTable.packKey(last), GPUGlyphTable.tombstoneKey)
+    }
+
+    // MARK: - Substitution
+
+    func testSubstitutionRewritesCodepointsAndKeepsDamage() {
+        var snapshot = GridSnapshot(
+            cells: ContiguousArray((0..<8).map { index in
+                CellInstance(
+                    row: UInt16(index / 4), col: UInt16(index % 4), glyphIndex: 0x3D, fgColor: 0, bgColor: 0,
+                    underlineColor: 0, attributes: 0, flags: 0, underlineStyle: 0
+                )
+            }),
+            dirtyRange: 4..<8,
+            cursorRow: 0,
+            cursorCol: 0,
+            cursorVisible: true,
+            cursorStyle: .block,
+            columns: 4,
+            rows: 2,
+            usingAlternateBuffer: false,
+            graphemeOverrides: nil
+        )
+        snapshot.damagedRanges = [4..<8]
+
+        let substituted = snapshot.substitutingGlyphs([1: [(col: 1, codepoint: 0x11_0000), (col: 2, codepoint: 0)]])
+        XCTAssertEqual(substituted.cells.map(\.glyphIndex), [0x3D, 0x3D, 0x3D, 0x3D, 0x3D, 0x11_0000, 0, 0x3D])
+        XCTAssertEqual(substituted.damagedRanges, [4..<8])
+        XCTAssertEqual(substituted.dirtyRange, 4..<8)
+    }
+
+    // MARK: - CoreText
+
+    func testPlainLatinRunNeedsNoShaping() {
+        let font = CTFontCreateWithName("Menlo" as CFString, 14, nil)
+        XCTAssertNil(GlyphShaper.shapedLine(for: Array("hello".unicodeScalars.map(\.value)), font: font))
+    }
+
+    func testArabicRunIsShaped() {
+        let font = CTFontCreateWithName("Menlo" as CFString, 14, nil)
+        let scalars = Array("سلام".unicodeScalars.map(\.value))
+        guard let line = GlyphShaper.shapedLine(for: scalars, font: font) else {
+            XCTFail("Joining forms and right-to-left order need shaping")
+            return
+        }
+        let tiles = GlyphRasterizer().rasterize(
+            shapedLine: line, font: font, cellCount: scalars.count, cellWidth: 16, cellHeight: 32
+        )
+        XCTAssertEqual(tiles.count, scalars.count)
+        XCTAssertTrue(tiles.contains { $0 != nil })
+        XCTAssertEqual(tiles.compactMap { $0 }.first?.pixelData.count, 16 * 32 * 4)
+    }
+}
+#endif
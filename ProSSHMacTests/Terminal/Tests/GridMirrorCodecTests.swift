@@ -0,0 +1,127 @@
+// GridMirrorCodecTests.swift
+// ProSSHV2
+//
+// The session mirroring wire format: a decoder fed the encoder's frames
+// holds the screen the grid shows, deltas carry only changed rows, scrolls
+// travel as moves, and bad frames are rejected without touching the screen.
+
+#if canImport(XCTest)
+import XCTest
+@testable import ProSSHMac
+
+final class GridMirrorCodecTests: XCTestCase {
+
+    // MARK: - Helpers
+
+    private func feed(_ engine: TerminalEngine, _ text: String) async -> GridSnapshot {
+        await engine.feed(Array(text.utf8))
+        return await engine.snapshot()
+    }
+
+    /// The decoded snapshot shows what `snapshot` shows.
+    private func assertMirrors(_ decoded: GridSnapshot, _ snapshot: GridSnapshot, file: StaticString = #filePath, line: UInt = #line) {
+        XCTAssertEqual(decoded.columns, snapshot.columns, file: file, line: line)
+        XCTAssertEqual(decoded.rows, snapshot.rows, file: file, line: line)
+        XCTAssertEqual(decoded.cursorRow, snapshot.cursorRow, file: file, line: line)
+        XCTAssertEqual(decoded.cursorCol, snapshot.cursorCol, file: file, line: line)
+        XCTAssertEqual(decoded.cursorVisible, snapshot.cursorVisible, file: file, line: line)
+        XCTAssertEqual(decoded.usingAlternateBuffer, snapshot.usingAlternateBuffer, file: file, line: line)
+        XCTAssertEqual(decoded.graphemeOverrides ?? [:], snapshot.graphemeOverrides ?? [:], file: file, line: line)
+        for index in 0..<snapshot.cellCount where decoded.mirrorCell(at: index) != snapshot.mirrorCell(at: index) {
+            return XCTFail("Cell \(index) differs", file: file, line: line)
+        }
+    }
+
+    // MARK: - Round Trip
+
+    func testDecoderFollowsTheGridThroughOutputScrollsAndScreens() async throws {
+        let engine = TerminalEngine(columns: 32, rows: 8)
+        var encoder = GridMirrorEncoder()
+        var decoder = GridMirrorDecoder()
+        let steps = [
+            "\u{1B}[1;32muser@host\u{1B}[0m:~$ ls\r\n",
+            (1...20).map { "line \($0) \u{1B}[4mcafé\u{1B}[0m 🚀\r\n" }.joined(),
+            "e\u{301}\u{1B}[3;10H\u{1B}[7mhere\u{1B}[0m\u{1B}[K",
+            "\u{1B}[?1049h\u{1B}[2J\u{1B}[Htop - up 3 days\u{1B}[5;1H%CPU 12.0",
+            "\u{1B}[?25l\u{1B}[5;6H99.9",
+            "\u{1B}[?1049l\u{1B}[?25hback\r\n",
+        ]
+        for step in steps {
+            let snapshot = await feed(engine, step)
+            guard let frame = encoder.encode(snapshot) else { continue }
+            assertMirrors(try decoder.apply(frame), snapshot)
+        }
+    }
+
+    func testJoiningViewerCatchesUpFromAKeyframe() async throws {
+        let engine = TerminalEngine(columns: 20, rows: 4)
+        var encoder = GridMirrorEncoder()
+        _ = encoder.encode(await feed(engine, "first\r\n"))
+        let snapshot = await feed(engine, "second")
+        _ = encoder.encode(snapshot)
+
+        var late = GridMirrorDecoder()
+        let keyframe = try XCTUnwrap(encoder.keyframe())
+        assertMirrors(try late.apply(keyframe), snapshot)
+    }
+
+    // MARK: - Deltas
+
+    func testDeltaCarriesOnlyTheChangedRow() async throws {
+        let engine = TerminalEngine(columns: 80, rows: 24)
+        var encoder = GridMirrorEncoder()
+        var decoder = GridMirrorDecoder()
+        let keyframe = try XCTUnwrap(encoder.encode(await feed(engine, "$ ")))
+        _ = try decoder.apply(keyframe)
+
+        let snapshot = await feed(engine, "x")
+        let delta = try XCTUnwrap(encoder.encode(snapshot))
+        XCTAssertLessThan(delta.count, keyframe.count / 4)
+        let decoded = try decoder.apply(delta)
+        assertMirrors(decoded, snapshot)
+        XCTAssertEqual(decoded.damagedRanges, [0..<80], "Only the row typed on is redrawn")
+
+        XCTAssertNil(encoder.encode(await engine.snapshot()), "Nothing changed, nothing is sent")
+    }
+
+    func testScrollTravelsAsAMove() async throws {
+        let engine = TerminalEngine(columns: 40, rows: 10)
+        var encoder = GridMirrorEncoder()
+        var decoder = GridMirrorDecoder()
+        let screenful = (1...10).map { "row \($0) with some text to move" }.joined(separator: "\r\n")
+        _ = try decoder.apply(try XCTUnwrap(encoder.encode(await feed(engine, screenful))))
+
+        let snapshot = await feed(engine, "\r\nnext")
+        XCTAssertNotNil(snapshot.scroll)
+        let delta = try XCTUnwrap(encoder.encode(snapshot))
+        XCTAssertLessThan(delta.count, 200, "Moved rows are not resent")
+        assertMirrors(try decoder.apply(delta), snapshot)
+    }
+
+    // MARK: - Errors
+
+    func testDeltaBeforeKeyframeIsRejected() async throws {
+        let engine = TerminalEngine(columns: 20, rows: 4)
+        var encoder = GridMirrorEncoder()
+        _ = encoder.encode(await feed(engine, "a"))
+        let delta = try XCTUnwrap(encoder.encode(await feed(engine, "b")))
+
+        var decoder = GridMirrorDecoder()
+        XCTAssertThrowsError(try decoder.apply(delta)) { error in
+            XCTAssertEqual(error as? GridMirrorCodecError, .missingKeyframe)
+        }
+    }
+
+    func testTruncatedFrameLeavesTheScreenUnchanged() async throws {
+        let engine = TerminalEngine(columns: 20, rows: 4)
+        var encoder = GridMirrorEncoder()
+        var decoder = GridMirrorDecoder()
+        let first = await feed(engine, "kept")
+        _ = try decoder.apply(try XCTUnwrap(encoder.encode(first)))
+        let delta = try XCTUnwrap(encoder.encode(await feed(engine, "\r\nlost")))
+
+        XCTAssertThrowsError(try decoder.apply(delta.prefix(delta.count - 3)))
+        assertMirrors(decoder.screen.snapshot(damagedRanges: nil), first)
+    }
+}
+#endif
@@ -0,0 +1,174 @@
+// GridSnapshotFeedTests.swift
+// ProSSHV2
+//
+// Triple-buffer hand-off of grid snapshots to a display-link consumer:
+// newest-wins takes, damage carried across skipped snapshots, and the
+// coordinator publishing to attached feeds instead of bumping the nonce.
+
+#if canImport(XCTest)
+import XCTest
+@testable import ProSSHMac
+
+final class GridSnapshotFeedTests: XCTestCase {
+
+    private func makeSnapshot(
+        cursorCol: Int = 0,
+        columns: Int = 10,
+        rows: Int = 4,
+        damage: [Range<Int>]?
+    ) -> GridSnapshot {
+        var snapshot = GridSnapshot(
+            cells: ContiguousArray(repeating: CellInstance(
+                row: 0, col: 0, glyphIndex: 0, fgColor: 0, bgColor: 0,
+                underlineColor: 0, attributes: 0, flags: 0, underlineStyle: 0
+            ), count: columns * rows),
+            dirtyRange: damage.map { ranges in
+                (ranges.map(\.lowerBound).min() ?? 0)..<(ranges.map(\.upperBound).max() ?? 0)
+            },
+            cursorRow: 0,
+            cursorCol: cursorCol,
+            cursorVisible: true,
+            cursorStyle: .block,
+            columns: columns,
+            rows: rows,
+            usingAlternateBuffer: false,
+            graphemeOverrides: nil
+        )
+        snapshot.damagedRanges = damage
+        return snapshot
+    }
+
+    // MARK: - Triple Buffer
+
+    func testTakeReturnsNilUntilWritten() {
+        let feed = GridSnapshotFeed()
+        XCTAssertFalse(feed.hasUnreadSnapshot)
+        XCTAssertNil(feed.takeLatest())
+
+        feed.write(makeSnapshot(cursorCol: 3, damage: [0..<10]))
+        XCTAssertTrue(feed.hasUnreadSnapshot)
+        XCTAssertEqual(feed.takeLatest()?.cursorCol, 3)
+        XCTAssertNil(feed.takeLatest())
+        XCTAssertEqual(feed.generation, 1)
+    }
+
+    func testTakeReturnsNewestOfSeveralWrites() {
+        let feed = GridSnapshotFeed()
+        for col in 1...5 {
+            feed.write(makeSnapshot(cursorCol: col, damage: [0..<10]))
+        }
+        XCTAssertEqual(feed.takeLatest()?.cursorCol, 5)
+        XCTAssertEqual(feed.generation, 5)
+
+        // Slots rotate correctly across many write/take rounds.
+        for col in 6...20 {
+            feed.write(makeSnapshot(cursorCol: col, damage: [0..<10]))
+            if col.isMultiple(of: 3) {
+                XCTAssertEqual(feed.takeLatest()?.cursorCol, col)
+            }
+        }
+        XCTAssertEqual(feed.takeLatest()?.cursorCol, 20)
+    }
+
+    // MARK: - Damage
+
+    func testSkippedSnapshotDamageIsCarriedForward() {
+        let feed = GridSnapshotFeed()
+        feed.write(makeSnapshot(damage: [0..<10]))
+        _ = feed.takeLatest()
+
+        feed.write(makeSnapshot(damage: [10..<20]))
+        feed.write(makeSnapshot(damage: [30..<40]))
+        let taken = feed.takeLatest()
+        XCTAssertEqual(taken?.damagedRanges, [10..<20, 30..<40])
+        XCTAssertEqual(taken?.dirtyRange, 10..<40)
+
+        // After a take, the next write carries only its own damage.
+        feed.write(makeSnapshot(damage: [20..<30]))
+        XCTAssertEqual(feed.takeLatest()?.damagedRanges, [20..<30])
+    }
+
+    func testFullUpdateIsNotNarrowedByMerge() {
+        let feed = GridSnapshotFeed()
+        feed.write(makeSnapshot(damage: nil))
+        feed.write(makeSnapshot(damage: [0..<10]))
+        XCTAssertNil(feed.takeLatest()?.dirtyRange)
+    }
+
+    func testGeometryChangeMergesToFullUpdate() {
+        let earlier = makeSnapshot(columns: 10, damage: [0..<10])
+        let later = makeSnapshot(columns: 12, damage: [0..<12])
+        XCTAssertNil(later.mergingDamage(of: earlier).dirtyRange)
+    }
+
+    func testSkippedScrollsCombineIntoOneMove() {
+        var earlier = makeSnapshot(damage: [0..<40])
+        earlier.sequence = 2
+        earlier.scroll = GridSnapshotScroll(
+            baseSequence: 1, delta: GridScrollDelta(region: 0...3, lines: 1), rewrittenRanges: [30..<40]
+        )
+        var later = makeSnapshot(damage: [0..<40])
+        later.sequence = 3
+        later.scroll = GridSnapshotScroll(
+            baseSequence: 2, delta: GridScrollDelta(region: 0...3, lines: 1), rewrittenRanges: [30..<40]
+        )
+        let merged = later.mergingDamage(of: earlier)
+        XCTAssertEqual(merged.sequence, 3)
+        XCTAssertEqual(merged.scroll?.baseSequence, 1)
+        XCTAssertEqual(merged.scroll?.delta, GridScrollDelta(region: 0...3, lines: 2))
+        XCTAssertEqual(merged.scroll?.rewrittenRanges, [20..<40])
+
+        var unscrolled = makeSnapshot(damage: [0..<10])
+        unscrolled.sequence = 2
+        XCTAssertNil(later.mergingDamage(of: unscrolled).scroll)
+    }
+
+    func testUnionCoalescesTouchingRanges() {
+        XCTAssertEqual(GridSnapshot.union([0..<10, 30..<40], [10..<20, 35..<50]), [0..<20, 30..<50])
+    }
+
+    func testInputTimestampSurvivesSkippedSnapshots() {
+        let feed = GridSnapshotFeed()
+        feed.write(makeSnapshot(damage: [0..<10]), inputTimestamp: 5)
+        feed.write(makeSnapshot(damage: [10..<20]))
+        _ = feed.takeLatest()
+        XCTAssertEqual(feed.takenInputTimestamp, 5)
+
+        feed.write(makeSnapshot(damage: [0..<10]))
+        _ = feed.takeLatest()
+        XCTAssertNil(feed.takenInputTimestamp)
+    }
+
+    // MARK: - Coordinator
+
+    @MainActor
+    func testAttachedFeedReceivesPublishInsteadOfNonce() async {
+        let manager = SessionManager(
+            transport: MockSSHTransport(),
+            knownHostsStore: InMemoryKnownHostsStore()
+        )
+        await manager.injectScreenshotSessions()
+        guard let session = manager.sessions.first else {
+            XCTFail("Expected at least one injected session")
+            return
+        }
+
+        let surfaceID = UUID()
+        let feed = manager.attachSnapshotFeed(for: session.id, surfaceID: surfaceID)
+        XCTAssertNotNil(feed.takeLatest(), "A new feed starts with the current snapshot")
+
+        var wakeCount = 0
+        feed.onPublish = { wakeCount += 1 }
+        let nonce = manager.gridSnapshotNonceBySessionID[session.id, default: -1]
+        await manager.resizeTerminal(sessionID: session.id, columns: 96, rows: 28)
+
+        XCTAssertEqual(feed.takeLatest()?.columns, 96)
+        XCTAssertGreaterThan(wakeCount, 0)
+        XCTAssertEqual(manager.gridSnapshotNonceBySessionID[session.id, default: -1], nonce)
+
+        manager.detachSnapshotFeed(for: session.id, surfaceID: surfaceID)
+        await manager.resizeTerminal(sessionID: session.id, columns: 100, rows: 30)
+        XCTAssertGreaterThan(manager.gridSnapshotNonceBySessionID[session.id, default: -1], nonce)
+    }
+}
+#endif
@@ -0,0 +1,107 @@
+// HitchDetectorTests.swift
+// ProSSHV2
+//
+// Tests for hitch attribution: the stage overlapping a hitch longest is
+// blamed, other threads' work is ignored except glyph rasterization, and
+// reports accumulate into a ranking.
+
+#if canImport(XCTest)
+import XCTest
+@testable import ProSSHMac
+
+final class HitchDetectorTests: XCTestCase {
+
+    // MARK: - Helpers
+
+    private let mainThread: UInt64 = 100
+
+    private func event(_ name: TraceEventName, _ start: Double, _ end: Double, thread: UInt64 = 100) -> TraceEvent {
+        TraceEvent(name: name, start: start, duration: end - start, threadID: thread, value: 0, label: nil)
+    }
+
+    private func makeDetector() -> (HitchDetector, TraceRecorder) {
+        let trace = TraceRecorder(capacity: 64)
+        trace.setEnabled(true)
+        return (HitchDetector(trace: trace, reportCapacity: 2), trace)
+    }
+
+    // MARK: - Tests
+
+    func testLongestOverlappingStageIsBlamed() {
+        let events = [
+            event(.publish, 10.00, 10.02),
+            event(.storeWrite, 10.02, 10.09),
+            event(.viewUpdate, 10.09, 10.10),
+        ]
+
+        let result = HitchDetector.attribute(events, start: 10, end: 10.1, threadID: mainThread)
+
+        XCTAssertEqual(result.stage, .storeWrite)
+        XCTAssertEqual(result.seconds, 0.07, accuracy: 1e-9)
+    }
+
+    func testOnlyTheOverlappingPartCounts() {
+        let events = [
+            event(.reflow, 9.0, 10.03),
+            event(.publish, 10.03, 10.08),
+        ]
+
+        let result = HitchDetector.attribute(events, start: 10, end: 10.1, threadID: mainThread)
+
+        XCTAssertEqual(result.stage, .snapshotPublish)
+    }
+
+    func testOtherThreadsAreIgnoredExceptGlyphRasterization() {
+        let events = [
+            event(.storeWrite, 10, 10.1, thread: 7),
+            event(.parserChunk, 10, 10.1, thread: 8),
+            event(.glyphRasterBatch, 10, 10.05, thread: 9),
+        ]
+
+        let result = HitchDetector.attribute(events, start: 10, end: 10.1, threadID: mainThread)
+
+        XCTAssertEqual(result.stage, .glyphRaster)
+    }
+
+    func testFrameEncodeAloneIsUnattributed() {
+        let events = [event(.frameEncode, 10, 10.1)]
+        let result = HitchDetector.attribute(events, start: 10, end: 10.1, threadID: mainThread)
+        XCTAssertEqual(result.stage, .unknown)
+        XCTAssertEqual(result.seconds, 0)
+    }
+
+    func testReportsAccumulateIntoARanking() {
+        let (detector, trace) = makeDetector()
+        trace.record(.reflow, start: 1.00, end: 1.20, threadID: mainThread)
+        trace.record(.storeWrite, start: 2.00, end: 2.05, threadID: mainThread)
+        trace.record(.storeWrite, start: 3.00, end: 3.05, threadID: mainThread)
+
+        detector.capture(.mainThreadStall, start: 1.0, end: 1.2, threadID: mainThread)
+        detector.capture(.frameOverBudget, start: 2.0, end: 2.05, threadID: mainThread)
+        detector.capture(.frameOverBudget, start: 3.0, end: 3.05, threadID: mainThread)
+
+        let ranking = detector.ranking
+        XCTAssertEqual(ranking.map(\.stage), [.reflow, .storeWrite])
+        XCTAssertEqual(ranking[1].count, 2)
+        XCTAssertEqual(ranking[1].totalSeconds, 0.1, accuracy: 1e-9)
+
+        // Only the newest reports keep their trace window.
+        let recent = detector.recentReports
+        XCTAssertEqual(recent.map(\.id), [3, 2])
+        XCTAssertTrue(recent[0].events.contains { $0.name == .storeWrite })
+        XCTAssertTrue(detector.report.contains("Reflow: 1"))
+    }
+
+    func testHitchIsRecordedInTheTrace() {
+        let (detector, trace) = makeDetector()
+        detector.capture(.frameOverBudget, start: 5.0, end: 5.03, threadID: mainThread)
+        XCTAssertTrue(trace.events(overlapping: 5, 5.03).contains { $0.name == .hitch })
+    }
+
+    func testFramesWithinBudgetAreIgnored() {
+        let (detector, _) = makeDetector()
+        detector.frameFinished(start: 1, end: 1.005, budget: 1.0 / 60)
+        XCTAssertTrue(detector.recentReports.isEmpty)
+    }
+}
+#endif
@@ -0,0 +1,101 @@
+// HostListCacheTests.swift
+// ProSSHV2
+//
+// Launch cache for the host list: a saved list reads back in the same
+// order, later saves replace it, and a missing, foreign or damaged file
+// loads as nil so the store is used instead.
+
+#if canImport(XCTest)
+import CryptoKit
+import XCTest
+@testable import ProSSHMac
+
+@MainActor
+final class HostListCacheTests: XCTestCase {
+
+    private var directory: URL!
+    private let key = SymmetricKey(size: .bits256)
+
+    override func setUpWithError() throws {
+        directory = FileManager.default.temporaryDirectory
+            .appendingPathComponent("HostListCacheTests-\(UUID().uuidString)", isDirectory: true)
+    }
+
+    override func tearDownWithError() throws {
+        try? FileManager.default.removeItem(at: directory)
+    }
+
+    // MARK: - Helpers
+
+    private var fileURL: URL {
+        directory.appendingPathComponent("hosts.list")
+    }
+
+    private func makeCache(key: SymmetricKey? = nil) -> HostListCache {
+        let key = key ?? self.key
+        return HostListCache(fileURL: fileURL) { _ in key }
+    }
+
+    private func makeHost(_ label: String) -> ProSSHMac.Host {
+        ProSSHMac.Host(
+            id: UUID(),
+            label: label,
+            folder: "Prod",
+            hostname: "\(label).example.com",
+            port: 22,
+            username: "admin",
+            authMethod: .password,
+            keyReference: nil,
+            certificateReference: nil,
+            passwordReference: nil,
+            jumpHost: nil,
+            algorithmPreferences: nil,
+            pinnedHostKeyAlgorithms: [],
+            legacyModeEnabled: false,
+            tags: ["web"],
+            notes: nil,
+            lastConnected: Date(timeIntervalSince1970: 1_700_000_000),
+            createdAt: Date(timeIntervalSince1970: 1_600_000_000)
+        )
+    }
+
+    // MARK: - Tests
+
+    func testSavedListReadsBackInOrder() async throws {
+        let hosts = ["zulu", "alpha", "mike"].map(makeHost)
+        makeCache().save(hosts)
+
+        let loaded = await makeCache().load()
+        XCTAssertEqual(loaded, hosts)
+    }
+
+    func testLaterSaveReplacesList() async throws {
+        let cache = makeCache()
+        cache.save([makeHost("old")])
+        let replacement = [makeHost("new")]
+        cache.save(replacement)
+
+        let loaded = await cache.load()
+        XCTAssertEqual(loaded, replacement)
+    }
+
+    func testMissingForeignOrDamagedFileLoadsNil() async throws {
+        let missing = await makeCache().load()
+        XCTAssertNil(missing)
+
+        let cache = makeCache()
+        cache.save([makeHost("web")])
+        let otherKey = await makeCache(key: SymmetricKey(size: .bits256)).load()
+        XCTAssertNil(otherKey)
+
+        // Wait for the write, then flip a ciphertext byte.
+        _ = await cache.load()
+        var file = try Data(contentsOf: fileURL)
+        file[file.count - 20] ^= 0xFF
+        try file.write(to: fileURL)
+        let damaged = await makeCache().load()
+        XCTAssertNil(damaged)
+    }
+}
+
+#endif
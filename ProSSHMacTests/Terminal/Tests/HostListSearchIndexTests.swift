@@ -0,0 +1,126 @@
+// HostListSearchIndexTests.swift
+// ProSSHV2
+//
+// Hosts list filter index: word-prefix matching, tag and folder facets,
+// incremental updates and folder grouping in display order.
+
+#if canImport(XCTest)
+import XCTest
+@testable import ProSSHMac
+
+final class HostListSearchIndexTests: XCTestCase {
+
+    // MARK: - Helpers
+
+    private func document(
+        _ label: String,
+        hostname: String = "example.com",
+        username: String = "root",
+        folder: String = "",
+        tags: [String] = []
+    ) -> HostSearchDocument {
+        HostSearchDocument(id: UUID(), label: label, hostname: hostname, username: username, folder: folder, tags: tags)
+    }
+
+    private func labels(_ index: HostListSearchIndex, _ documents: [HostSearchDocument], _ query: String) throws -> [String] {
+        let ids = try XCTUnwrap(try index.matchingIDs(query))
+        return documents.filter { ids.contains($0.id) }.map(\.label)
+    }
+
+    // MARK: - Tests
+
+    func testWordPrefixMatching() throws {
+        let documents = [
+            document("web-prod-01", hostname: "10.0.1.5"),
+            document("db-prod", hostname: "db.internal", username: "postgres"),
+            document("Staging Web", hostname: "stage.example.com"),
+        ]
+        let index = HostListSearchIndex(documents)
+
+        XCTAssertEqual(try labels(index, documents, "prod"), ["web-prod-01", "db-prod"])
+        XCTAssertEqual(try labels(index, documents, "WEB-PR"), ["web-prod-01"])
+        XCTAssertEqual(try labels(index, documents, "web"), ["web-prod-01", "Staging Web"])
+        XCTAssertEqual(try labels(index, documents, "10.0.1"), ["web-prod-01"])
+        XCTAssertEqual(try labels(index, documents, "postgres@db"), ["db-prod"])
+        XCTAssertEqual(try labels(index, documents, "web prod"), ["web-prod-01"])
+        XCTAssertEqual(try labels(index, documents, "eb"), [], "Matches start at word boundaries")
+        XCTAssertNil(try index.matchingIDs("   "))
+    }
+
+    func testLongTermsAreCheckedAgainstFields() throws {
+        let long = "very-long-generated-hostname-number-0001"
+        let documents = [document("a", hostname: long), document("b", hostname: "very-long-generated-hostname-number-0002")]
+        let index = HostListSearchIndex(documents)
+
+        XCTAssertEqual(try labels(index, documents, long), ["a"])
+        XCTAssertEqual(try labels(index, documents, "very-long-generated-host"), ["a", "b"])
+    }
+
+    func testTagAndFolderFacets() throws {
+        let documents = [
+            document("a", folder: "Production", tags: ["Linux", "web"]),
+            document("b", folder: "Production", tags: ["linux"]),
+            document("c", tags: ["web"]),
+        ]
+        let index = HostListSearchIndex(documents)
+
+        XCTAssertEqual(try labels(index, documents, "tag:linux"), ["a", "b"])
+        XCTAssertEqual(try labels(index, documents, "tag:web folder:production"), ["a"])
+        XCTAssertEqual(try labels(index, documents, "folder:ungrouped"), ["c"])
+        XCTAssertEqual(try labels(index, documents, "tag:windows"), [])
+        XCTAssertEqual(index.tagCounts["linux"], 2)
+        XCTAssertEqual(index.folderCounts["production"], 2)
+    }
+
+    func testUpdateReindexesOnlyChangedDocuments() throws {
+        var documents = (0..<50).map { document("host-\($0)") }
+        var index = HostListSearchIndex(documents)
+        XCTAssertEqual(index.update(documents), 0)
+
+        documents[7].label = "renamed"
+        let removed = documents.remove(at: 3)
+        documents.append(document("added"))
+        XCTAssertEqual(index.update(documents), 3)
+        XCTAssertEqual(index.count, 50)
+
+        XCTAssertEqual(try labels(index, documents, "renamed"), ["renamed"])
+        XCTAssertEqual(try labels(index, documents, "host-7"), [])
+        let matches = try XCTUnwrap(try index.matchingIDs("host-3"))
+        XCTAssertFalse(matches.contains(removed.id))
+        XCTAssertEqual(matches.count, 10, "host-30 through host-39")
+        XCTAssertEqual(try labels(index, documents, "added"), ["added"])
+    }
+
+    func testGroupsFollowOrderAndSortByFolder() throws {
+        let documents = [
+            document("b", folder: "Prod"),
+            document("a"),
+            document("c", folder: "Dev"),
+            document("d", folder: "Prod"),
+        ]
+        let index = HostListSearchIndex(documents)
+        let order = documents.map(\.id) + [UUID()]
+
+        let groups = try index.groups(order: order, query: "")
+        XCTAssertEqual(groups.map(\.folder), ["Dev", "Prod", HostListGroup.ungroupedTitle])
+        XCTAssertEqual(groups[1].hostIDs, [documents[0].id, documents[3].id])
+
+        let filtered = try index.groups(order: order, query: "folder:prod d")
+        XCTAssertEqual(filtered, [HostListGroup(folder: "Prod", hostIDs: [documents[3].id])])
+    }
+
+    func testLargeInventoryQuery() throws {
+        let documents = (0..<50_000).map {
+            document("node-\($0)", hostname: "10.\($0 / 65_536).\($0 / 256 % 256).\($0 % 256)", folder: "rack-\($0 % 40)")
+        }
+        let index = HostListSearchIndex(documents)
+        let order = documents.map(\.id)
+
+        let start = Date()
+        let groups = try index.groups(order: order, query: "node-4999")
+        XCTAssertLessThan(Date().timeIntervalSince(start), 1)
+        XCTAssertEqual(groups.flatMap(\.hostIDs).count, 11)
+    }
+}
+
+#endif
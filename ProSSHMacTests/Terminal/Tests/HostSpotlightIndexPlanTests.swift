@@ -0,0 +1,78 @@
+// HostSpotlightIndexPlanTests.swift
+// ProSSHV2
+//
+// Spotlight reindex planning: without earlier fingerprints the domain is
+// rebuilt; otherwise only added or changed hosts are submitted and removed
+// hosts are deleted by identifier.
+
+#if canImport(XCTest)
+import XCTest
+@testable import ProSSHMac
+
+@MainActor
+final class HostSpotlightIndexPlanTests: XCTestCase {
+
+    // MARK: - Helpers
+
+    private func makeHost(_ label: String) -> ProSSHMac.Host {
+        ProSSHMac.Host(
+            id: UUID(),
+            label: label,
+            folder: nil,
+            hostname: "\(label).example.com",
+            port: 22,
+            username: "admin",
+            authMethod: .password,
+            keyReference: nil,
+            certificateReference: nil,
+            passwordReference: nil,
+            jumpHost: nil,
+            algorithmPreferences: nil,
+            pinnedHostKeyAlgorithms: [],
+            legacyModeEnabled: false,
+            tags: [],
+            notes: nil,
+            lastConnected: nil,
+            createdAt: Date(timeIntervalSince1970: 1_600_000_000)
+        )
+    }
+
+    // MARK: - Tests
+
+    func testNoFingerprintsRebuildsEverything() {
+        let hosts = ["a", "b"].map(makeHost)
+        let plan = HostSpotlightIndexer.plan(hosts: hosts, indexed: nil)
+        XCTAssertTrue(plan.rebuildsDomain)
+        XCTAssertEqual(plan.hostIDsToIndex, hosts.map(\.id))
+        XCTAssertTrue(plan.hostIDsToDelete.isEmpty)
+        XCTAssertEqual(plan.fingerprints.count, 2)
+    }
+
+    func testOnlyChangedAddedAndRemovedHostsAreTouched() {
+        var hosts = ["a", "b", "c"].map(makeHost)
+        let indexed = HostSpotlightIndexer.plan(hosts: hosts, indexed: nil).fingerprints
+
+        let removed = hosts.removeLast()
+        hosts[1].lastConnected = Date(timeIntervalSince1970: 1_700_000_000)
+        let added = makeHost("d")
+        hosts.append(added)
+
+        let plan = HostSpotlightIndexer.plan(hosts: hosts, indexed: indexed)
+        XCTAssertFalse(plan.rebuildsDomain)
+        XCTAssertEqual(plan.hostIDsToIndex, [hosts[1].id, added.id])
+        XCTAssertEqual(plan.hostIDsToDelete, [removed.id])
+        XCTAssertEqual(Set(plan.fingerprints.keys), Set(hosts.map(\.id)))
+    }
+
+    func testUnsearchedFieldsDoNotChangeFingerprint() {
+        var host = makeHost("web")
+        let before = HostSpotlightIndexer.fingerprint(for: host)
+        host.notes = "rotated keys"
+        host.agentForwardingEnabled = true
+        XCTAssertEqual(HostSpotlightIndexer.fingerprint(for: host), before)
+        host.tags = ["prod"]
+        XCTAssertNotEqual(HostSpotlightIndexer.fingerprint(for: host), before)
+    }
+}
+
+#endif
@@ -0,0 +1,216 @@
+// InlineImageTests.swift
+// ProSSHV2
+//
+// Inline images: header sizing, sixel measuring and decoding, and the
+// placements the three protocols leave on the grid, including how they
+// scroll into scrollback, clear with the screen and answer kitty replies.
+
+#if canImport(XCTest)
+import XCTest
+@testable import ProSSHMac
+
+@MainActor
+final class InlineImageTests: XCTestCase {
+
+    private var engine: TerminalEngine!
+    private var responses: [[UInt8]]!
+
+    override func setUp() async throws {
+        engine = TerminalEngine(columns: 80, rows: 24)
+        responses = []
+        await engine.setResponseHandler { @Sendable [weak self] bytes in
+            await MainActor.run { self?.responses.append(bytes) }
+        }
+    }
+
+    // MARK: - Helpers
+
+    private func feed(_ string: String) async {
+        await engine.feed(Array(string.utf8))
+    }
+
+    /// The first 24 bytes of a PNG: signature and IHDR size.
+    private func pngHeader(width: UInt32, height: UInt32) -> [UInt8] {
+        var bytes: [UInt8] = [0x89, 0x50, 0x4E, 0x47, 0x0D, 0x0A, 0x1A, 0x0A, 0, 0, 0, 13]
+        bytes += Array("IHDR".utf8)
+        for value in [width, height] {
+            bytes += [UInt8(value >> 24), UInt8((value >> 16) & 0xFF), UInt8((value >> 8) & 0xFF), UInt8(value & 0xFF)]
+        }
+        return bytes
+    }
+
+    private func iTermImage(width: UInt32, height: UInt32) -> String {
+        let base64 = Data(pngHeader(width: width, height: height)).base64EncodedString()
+        return "\u{1B}]1337;File=inline=1:\(base64)\u{07}"
+    }
+
+    // MARK: - Headers
+
+    func testPNGHeaderSize() {
+        let size = InlineImageHeader.pixelSize(of: pngHeader(width: 640, height: 480))
+        XCTAssertEqual(size?.width, 640)
+        XCTAssertEqual(size?.height, 480)
+    }
+
+    func testGIFHeaderSize() {
+        let gif: [UInt8] = Array("GIF89a".utf8) + [0x20, 0x01, 0xC8, 0x00]
+        let size = InlineImageHeader.pixelSize(of: gif)
+        XCTAssertEqual(size?.width, 288)
+        XCTAssertEqual(size?.height, 200)
+    }
+
+    func testBase64HeaderSize() {
+        let base64 = Array(Data(pngHeader(width: 33, height: 17)).base64EncodedString().utf8)
+        let size = InlineImageHeader.pixelSize(ofBase64: base64)
+        XCTAssertEqual(size?.width, 33)
+        XCTAssertEqual(size?.height, 17)
+    }
+
+    // MARK: - Sixel
+
+    func testSixelMeasureUsesRasterAttributes() {
+        let size = SixelDecoder.measure(Array("\"1;1;12;6#0~~".utf8))
+        XCTAssertEqual(size?.width, 12)
+        XCTAssertEqual(size?.height, 6)
+    }
+
+    func testSixelMeasureScansExtentWithoutRasterAttributes() {
+        let size = SixelDecoder.measure(Array("#0~~~-!5~".utf8))
+        XCTAssertEqual(size?.width, 5)
+        XCTAssertEqual(size?.height, 12)
+    }
+
+    func testSixelDecodePaintsDefinedColour() throws {
+        let bitmap = try XCTUnwrap(SixelDecoder.decode(Array("#1;2;100;0;0#1~".utf8), transparentBackground: true))
+        XCTAssertEqual(bitmap.width, 1)
+        XCTAssertEqual(bitmap.height, 6)
+        // Premultiplied BGRA: pure red.
+        XCTAssertEqual(Array(bitmap.pixels.prefix(4)), [0, 0, 255, 255])
+    }
+
+    func testSixelTransparentBackgroundLeavesUnpaintedPixelsClear() throws {
+        // '@' paints only the top pixel of its column; '~' makes the band 6 tall.
+        let bitmap = try XCTUnwrap(SixelDecoder.decode(Array("#1;2;0;100;0#1@~".utf8), transparentBackground: true))
+        XCTAssertEqual(bitmap.width, 2)
+        let secondRow = bitmap.bytesPerRow
+        XCTAssertEqual(Array(bitmap.pixels[secondRow..<(secondRow + 4)]), [0, 0, 0, 0])
+        XCTAssertEqual(Array(bitmap.pixels.prefix(4)), [0, 255, 0, 255])
+    }
+
+    // MARK: - Placement
+
+    func testITermImageReservesCellsAndMovesCursor() async {
+        // 20 × 40 px at the fallback 10 × 20 cell: 2 × 2 cells.
+        await feed("ab\r\n" + iTermImage(width: 20, height: 40))
+        let cursor = await engine.cursor
+        XCTAssertEqual(cursor.row, 2)
+        XCTAssertEqual(cursor.col, 2)
+
+        let quads = await engine.snapshot().inlineImages
+        XCTAssertEqual(quads.count, 1)
+        XCTAssertEqual(quads.first?.row, 1)
+        XCTAssertEqual(quads.first?.column, 0)
+        XCTAssertEqual(quads.first?.columns, 2)
+        XCTAssertEqual(quads.first?.rows, 2)
+    }
+
+    func testITermImageKeepsAspectWithinCells() async {
+        // 15 px wide needs 2 cells but fills only three quarters of them.
+        await feed(iTermImage(width: 15, height: 20))
+        let quad = await engine.snapshot().inlineImages.first
+        XCTAssertEqual(quad?.columns, 2)
+        XCTAssertEqual(quad?.widthFraction ?? 0, 0.75, accuracy: 0.001)
+        XCTAssertEqual(quad?.heightFraction ?? 0, 1, accuracy: 0.001)
+    }
+
+    func testSixelPlacesImageAndMovesCursorBelow() async {
+        await feed("\u{1B}Pq\"1;1;10;40#0~\u{1B}\\")
+        let cursor = await engine.cursor
+        XCTAssertEqual(cursor.row, 2)
+        XCTAssertEqual(cursor.col, 0)
+        let quad = await engine.snapshot().inlineImages.first
+        XCTAssertEqual(quad?.columns, 1)
+        XCTAssertEqual(quad?.rows, 2)
+    }
+
+    func testImageScrollsIntoScrollback() async {
+        await feed(iTermImage(width: 20, height: 40))
+        await feed(String(repeating: "\r\n", count: 30))
+        let live = await engine.snapshot().inlineImages
+        XCTAssertTrue(live.isEmpty)
+
+        let scrollback = await engine.scrollbackCount
+        let scrolled = await engine.snapshot(scrollOffset: scrollback).inlineImages
+        XCTAssertEqual(scrolled.count, 1)
+        XCTAssertEqual(scrolled.first?.row, 0)
+    }
+
+    func testEraseDisplayRemovesImages() async {
+        await feed(iTermImage(width: 20, height: 40))
+        await feed("\u{1B}[2J")
+        let quads = await engine.snapshot().inlineImages
+        XCTAssertTrue(quads.isEmpty)
+    }
+
+    func testLeavingAlternateScreenDropsItsImages() async {
+        await feed("\u{1B}[?1049h" + iTermImage(width: 20, height: 40))
+        let alternate = await engine.snapshot().inlineImages
+        XCTAssertEqual(alternate.count, 1)
+        await feed("\u{1B}[?1049l")
+        let primary = await engine.snapshot().inlineImages
+        XCTAssertTrue(primary.isEmpty)
+    }
+
+    // MARK: - kitty
+
+    func testKittyChunkedTransmitAndDisplayReplies() async {
+        // 4 × 2 RGB pixels = 24 bytes = 32 base64 characters, in two chunks.
+        await feed("\u{1B}_Ga=T,f=24,s=4,v=2,i=7,m=1;AAAA\u{1B}\\")
+        XCTAssertTrue(responses.isEmpty)
+        await feed("\u{1B}_Gm=0;" + String(repeating: "A", count: 28) + "\u{1B}\\")
+
+        XCTAssertEqual(responses.last, Array("\u{1B}_Gi=7;OK\u{1B}\\".utf8))
+        let quads = await engine.snapshot().inlineImages
+        XCTAssertEqual(quads.count, 1)
+        XCTAssertEqual(quads.first?.columns, 1)
+        XCTAssertEqual(quads.first?.rows, 1)
+    }
+
+    func testKittyQueryRepliesWithoutPlacing() async {
+        await feed("\u{1B}_Gi=31,s=1,v=1,a=q,t=d,f=24;AAAA\u{1B}\\")
+        XCTAssertEqual(responses.last, Array("\u{1B}_Gi=31;OK\u{1B}\\".utf8))
+        let quads = await engine.snapshot().inlineImages
+        XCTAssertTrue(quads.isEmpty)
+    }
+
+    func testKittyPutOfUnknownImageReportsError() async {
+        await feed("\u{1B}_Ga=p,i=99\u{1B}\\")
+        let reply = String(decoding: responses.last ?? [], as: UTF8.self)
+        XCTAssertTrue(reply.hasPrefix("\u{1B}_Gi=99;ENOENT"))
+    }
+
+    func testKittyDeleteRemovesPlacements() async {
+        await feed("\u{1B}_Ga=T,f=24,s=1,v=1,i=3,q=2;AAAA\u{1B}\\")
+        await feed("\u{1B}_Ga=d,d=a\u{1B}\\")
+        let quads = await engine.snapshot().inlineImages
+        XCTAssertTrue(quads.isEmpty)
+        XCTAssertTrue(responses.isEmpty)
+    }
+
+    // MARK: - Cell Size Reports
+
+    func testCellPixelSizeReport() async {
+        await engine.setCellPixelSize(width: 9, height: 18)
+        await feed("\u{1B}[16t")
+        XCTAssertEqual(responses.last, Array("\u{1B}[6;18;9t".utf8))
+    }
+
+    func testCellSizeSetsImageCellCount() async {
+        await engine.setCellPixelSize(width: 5, height: 10)
+        await feed(iTermImage(width: 20, height: 40))
+        let quad = await engine.snapshot().inlineImages.first
+        XCTAssertEqual(quad?.columns, 4)
+        XCTAssertEqual(quad?.rows, 4)
+    }
+}
+#endif
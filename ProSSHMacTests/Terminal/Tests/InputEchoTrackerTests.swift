@@ -0,0 +1,58 @@
+// InputEchoTrackerTests.swift
+// ProSSHV2
+//
+// Low-latency input mode: which output counts as a keystroke echo, and
+// keystroke-to-present latency sampling in RendererPerformanceMonitor.
+
+#if canImport(XCTest)
+import XCTest
+@testable import ProSSHMac
+
+final class InputEchoTrackerTests: XCTestCase {
+
+    // MARK: - Echo Window
+
+    func testNoEchoExpectedWithoutKeystroke() {
+        let tracker = InputEchoTracker()
+        XCTAssertFalse(tracker.expectsEcho(byteCount: 1, now: 10))
+        XCTAssertNil(tracker.consumeKeystroke())
+    }
+
+    func testSmallOutputWithinWindowIsEcho() {
+        let tracker = InputEchoTracker()
+        tracker.noteKeystroke(at: 10)
+        XCTAssertTrue(tracker.expectsEcho(byteCount: 1, now: 10.010))
+        XCTAssertTrue(tracker.expectsEcho(byteCount: InputEchoTracker.maxEchoBytes, now: 10.010))
+    }
+
+    func testLargeOrLateOutputIsNotEcho() {
+        let tracker = InputEchoTracker()
+        tracker.noteKeystroke(at: 10)
+        XCTAssertFalse(tracker.expectsEcho(byteCount: InputEchoTracker.maxEchoBytes + 1, now: 10.010))
+        XCTAssertFalse(tracker.expectsEcho(byteCount: 1, now: 10 + InputEchoTracker.echoWindow + 0.001))
+    }
+
+    func testConsumeClearsKeystroke() {
+        let tracker = InputEchoTracker()
+        tracker.noteKeystroke(at: 10)
+        XCTAssertEqual(tracker.consumeKeystroke(), 10)
+        XCTAssertNil(tracker.consumeKeystroke())
+        XCTAssertFalse(tracker.expectsEcho(byteCount: 1, now: 10.001))
+    }
+
+    // MARK: - Latency Reporting
+
+    @MainActor
+    func testMonitorReportsInputLatency() {
+        let monitor = RendererPerformanceMonitor()
+        XCTAssertNil(monitor.snapshot().averageInputLatencyMs)
+
+        monitor.recordInputLatency(seconds: 0.010)
+        monitor.recordInputLatency(seconds: 0.020)
+        monitor.recordInputLatency(seconds: -1)
+        let snapshot = monitor.snapshot()
+        XCTAssertEqual(snapshot.averageInputLatencyMs ?? 0, 15, accuracy: 0.001)
+        XCTAssertEqual(snapshot.p95InputLatencyMs ?? 0, 20, accuracy: 0.001)
+    }
+}
+#endif
@@ -0,0 +1,87 @@
+#if canImport(XCTest)
+import XCTest
+@testable import ProSSHMac
+
+final class KeepaliveTimerWheelTests: XCTestCase {
+
+    // MARK: - Scheduling
+
+    func testAdvanceReturnsDueSessionsEarliestFirst() {
+        var wheel = KeepaliveTimerWheel(slotCount: 8)
+        let early = UUID()
+        let late = UUID()
+        let pending = UUID()
+        wheel.schedule(late, at: 5)
+        wheel.schedule(early, at: 3)
+        wheel.schedule(pending, at: 7)
+
+        XCTAssertEqual(wheel.advance(to: 5), [early, late])
+        XCTAssertEqual(wheel.count, 1)
+        XCTAssertEqual(wheel.deadline(for: pending), 7)
+    }
+
+    func testRescheduleReplacesDeadline() {
+        var wheel = KeepaliveTimerWheel(slotCount: 8)
+        let id = UUID()
+        wheel.schedule(id, at: 2)
+        wheel.schedule(id, at: 6)
+
+        XCTAssertTrue(wheel.advance(to: 4).isEmpty)
+        XCTAssertEqual(wheel.advance(to: 6), [id])
+        XCTAssertTrue(wheel.isEmpty)
+    }
+
+    func testPastDeadlineMovesToNextTick() {
+        var wheel = KeepaliveTimerWheel(slotCount: 8, startTick: 10)
+        let id = UUID()
+        wheel.schedule(id, at: 4)
+
+        XCTAssertEqual(wheel.deadline(for: id), 11)
+        XCTAssertEqual(wheel.advance(to: 11), [id])
+    }
+
+    func testRemoveDropsDeadline() {
+        var wheel = KeepaliveTimerWheel(slotCount: 8)
+        let id = UUID()
+        wheel.schedule(id, at: 3)
+        wheel.remove(id)
+
+        XCTAssertTrue(wheel.isEmpty)
+        XCTAssertNil(wheel.nextDeadline)
+        XCTAssertTrue(wheel.advance(to: 3).isEmpty)
+    }
+
+    // MARK: - Rotations
+
+    func testDeadlineBeyondOneRotationWaitsForItsTurn() {
+        var wheel = KeepaliveTimerWheel(slotCount: 4)
+        let id = UUID()
+        wheel.schedule(id, at: 9)
+
+        XCTAssertTrue(wheel.advance(to: 5).isEmpty)
+        XCTAssertEqual(wheel.nextDeadline, 9)
+        XCTAssertEqual(wheel.advance(to: 9), [id])
+    }
+
+    func testJumpLongerThanRotationCollectsEverythingDue() {
+        var wheel = KeepaliveTimerWheel(slotCount: 4)
+        let ids = (0..<6).map { _ in UUID() }
+        for (offset, id) in ids.enumerated() {
+            wheel.schedule(id, at: offset + 1)
+        }
+
+        XCTAssertEqual(wheel.advance(to: 100), ids)
+        XCTAssertTrue(wheel.isEmpty)
+    }
+
+    func testNextDeadlineIsEarliestPending() {
+        var wheel = KeepaliveTimerWheel(slotCount: 8)
+        wheel.schedule(UUID(), at: 30)
+        wheel.schedule(UUID(), at: 6)
+        wheel.schedule(UUID(), at: 14)
+
+        XCTAssertEqual(wheel.nextDeadline, 6)
+    }
+}
+
+#endif
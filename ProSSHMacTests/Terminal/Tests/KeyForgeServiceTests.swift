@@ -0,0 +1,91 @@
+// KeyForgeServiceTests.swift
+// ProSSHV2
+//
+// KeyForge work on its executor: async generation and import, batch
+// generation in request order with progress, and cancellation of items
+// that have not started.
+
+#if canImport(XCTest)
+import XCTest
+@testable import ProSSHMac
+
+@MainActor
+final class KeyForgeServiceTests: XCTestCase {
+
+    // MARK: - Helpers
+
+    private func request(_ label: String, type: KeyType = .ed25519) -> KeyGenerationRequest {
+        KeyGenerationRequest(
+            label: label,
+            keyType: type,
+            rsaBits: 2048,
+            ecdsaCurve: .p256,
+            storeInSecureEnclave: false,
+            format: .openssh,
+            passphrase: nil,
+            passphraseCipher: .chacha20Poly1305,
+            comment: label
+        )
+    }
+
+    // MARK: - Tests
+
+    func testGenerateThenImportRoundTrip() async throws {
+        let service = KeyForgeService()
+        let generated = try await service.generateKey(request: request("round-trip"))
+        XCTAssertTrue(generated.publicKey.hasPrefix("ssh-ed25519 "))
+        XCTAssertFalse(generated.privateKey.isEmpty)
+
+        let imported = try await service.importKey(request: KeyImportRequest(
+            label: nil,
+            keyText: generated.privateKey,
+            passphrase: nil,
+            source: "Test"
+        ))
+        XCTAssertEqual(imported.metadata.type, .ed25519)
+        XCTAssertEqual(imported.metadata.fingerprint, generated.metadata.fingerprint)
+        XCTAssertEqual(imported.metadata.label, "Imported Ed25519 Key")
+    }
+
+    func testBatchGenerationKeepsRequestOrderAndReportsProgress() async throws {
+        let service = KeyForgeService()
+        let labels = (0..<6).map { "batch-\($0)" }
+        var reports: [KeyForgeBatchProgress] = []
+
+        let results = await service.generateKeys(labels.map { request($0) }) { reports.append($0) }
+
+        let keys = try results.map { try $0.get() }
+        XCTAssertEqual(keys.map(\.metadata.label), labels)
+        XCTAssertEqual(Set(keys.map(\.metadata.fingerprint)).count, labels.count)
+        XCTAssertEqual(reports.map(\.completed), Array(1...labels.count))
+        XCTAssertEqual(reports.last?.succeeded, labels.count)
+        XCTAssertEqual(reports.last?.fractionCompleted, 1)
+    }
+
+    func testBatchReportsFailuresPerItem() async {
+        let service = KeyForgeService()
+        var invalid = request("bad-rsa", type: .rsa)
+        invalid.rsaBits = 12
+        let results = await service.generateKeys([request("good"), invalid])
+
+        XCTAssertNoThrow(try results[0].get())
+        XCTAssertThrowsError(try results[1].get())
+    }
+
+    func testCancelledBatchSkipsRemainingItems() async {
+        let service = KeyForgeService()
+        let requests = (0..<64).map { request("cancelled-\($0)") }
+        let task = Task { await service.generateKeys(requests) }
+        task.cancel()
+
+        let results = await task.value
+        XCTAssertEqual(results.count, requests.count)
+        let cancelled = results.filter {
+            if case let .failure(error) = $0 { return error is CancellationError }
+            return false
+        }
+        XCTAssertFalse(cancelled.isEmpty)
+    }
+}
+
+#endif
@@ -0,0 +1,188 @@
+// KnownHostsStoreTests.swift
+// ProSSHV2
+//
+// Indexed known-hosts store: trusted keys verify after reopening, a new or
+// different key asks for approval, OpenSSH known_hosts files (including
+// hashed names) import, a torn record is cut off and compaction keeps the
+// live entries.
+
+#if canImport(XCTest)
+import CryptoKit
+import XCTest
+@testable import ProSSHMac
+
+final class KnownHostsStoreTests: XCTestCase {
+
+    private var directory: URL!
+    private let key = SymmetricKey(size: .bits256)
+
+    override func setUpWithError() throws {
+        directory = FileManager.default.temporaryDirectory
+            .appendingPathComponent("KnownHostsStoreTests-\(UUID().uuidString)", isDirectory: true)
+    }
+
+    override func tearDownWithError() throws {
+        try? FileManager.default.removeItem(at: directory)
+    }
+
+    // MARK: - Helpers
+
+    private func makeStore() -> FileKnownHostsStore {
+        let key = key
+        return FileKnownHostsStore(baseDirectory: directory) { _ in key }
+    }
+
+    private var logURL: URL {
+        directory.appendingPathComponent("known_hosts.log")
+    }
+
+    private func challenge(
+        _ hostname: String,
+        port: UInt16 = 22,
+        type: String = "ssh-ed25519",
+        fingerprint: String
+    ) -> KnownHostVerificationChallenge {
+        KnownHostVerificationChallenge(
+            hostname: hostname,
+            port: port,
+            hostKeyType: type,
+            presentedFingerprint: fingerprint,
+            expectedFingerprint: nil
+        )
+    }
+
+    /// The expected fingerprint of a challenge, or "trusted".
+    private func verify(
+        _ store: FileKnownHostsStore,
+        _ hostname: String,
+        port: UInt16 = 22,
+        type: String = "ssh-ed25519",
+        fingerprint: String
+    ) async throws -> String? {
+        let result = try await store.evaluate(
+            hostname: hostname,
+            port: port,
+            hostKeyType: type,
+            presentedFingerprint: fingerprint
+        )
+        switch result {
+        case .trusted:
+            return "trusted"
+        case let .requiresUserApproval(challenge):
+            return challenge.expectedFingerprint
+        }
+    }
+
+    private func hashedName(_ name: String, salt: Data) -> String {
+        let code = HMAC<Insecure.SHA1>.authenticationCode(for: Data(name.utf8), using: SymmetricKey(data: salt))
+        return "|1|\(salt.base64EncodedString())|\(Data(code).base64EncodedString())"
+    }
+
+    // MARK: - Tests
+
+    func testTrustedKeyVerifiesAfterReopen() async throws {
+        try await makeStore().trust(challenge: challenge("Web.Example.com", fingerprint: "aa:bb"))
+
+        let store = makeStore()
+        let trusted = try await verify(store, "web.example.com", fingerprint: "aa:bb")
+        XCTAssertEqual(trusted, "trusted")
+        let changed = try await verify(store, "web.example.com", fingerprint: "cc:dd")
+        XCTAssertEqual(changed, "aa:bb")
+        let unknown = try await verify(store, "db.example.com", fingerprint: "aa:bb")
+        XCTAssertNil(unknown)
+        let otherPort = try await verify(store, "web.example.com", port: 2222, fingerprint: "aa:bb")
+        XCTAssertNil(otherPort)
+    }
+
+    func testNewKeyTypeIsTreatedAsChangedKey() async throws {
+        let store = makeStore()
+        try await store.trust(challenge: challenge("web", type: "ssh-rsa", fingerprint: "11:22"))
+
+        let otherType = try await verify(store, "web", type: "ssh-ed25519", fingerprint: "33:44")
+        XCTAssertEqual(otherType, "11:22")
+
+        try await store.trust(challenge: challenge("web", type: "ssh-ed25519", fingerprint: "33:44"))
+        let entries = try await makeStore().allEntries()
+        XCTAssertEqual(entries.map(\.hostKeyType), ["ssh-ed25519", "ssh-rsa"])
+        let fingerprint = try await store.fingerprint(hostname: "WEB", port: 22)
+        XCTAssertEqual(fingerprint, "33:44")
+    }
+
+    func testImportsOpenSSHKnownHostsIncludingHashedNames() async throws {
+        let blob = Data("ed25519 key blob".utf8).base64EncodedString()
+        let rsaBlob = Data("rsa key blob".utf8).base64EncodedString()
+        let salt = Data((0..<20).map { UInt8($0) })
+        let contents = """
+        # comment
+        web.example.com,10.0.0.5 ssh-ed25519 \(blob) admin@laptop
+        [db.example.com]:2222 ssh-rsa \(rsaBlob)
+        \(hashedName("hidden.example.com", salt: salt)) ssh-ed25519 \(blob)
+        @revoked old.example.com ssh-rsa \(rsaBlob)
+        *.example.com ssh-rsa \(rsaBlob)
+        """
+
+        let store = makeStore()
+        let result = try await store.importOpenSSHKnownHosts(contents)
+        XCTAssertEqual(result, KnownHostsImportResult(imported: 3, hashed: 1, skipped: 2))
+
+        let fingerprint = OpenSSHKnownHostsParser.fingerprint(ofKeyBlob: Data("ed25519 key blob".utf8))
+        XCTAssertEqual(fingerprint.split(separator: ":").count, 32)
+        let rsa = try await verify(
+            store, "db.example.com", port: 2222, type: "ssh-rsa",
+            fingerprint: OpenSSHKnownHostsParser.fingerprint(ofKeyBlob: Data("rsa key blob".utf8))
+        )
+        XCTAssertEqual(rsa, "trusted")
+        let hidden = try await verify(store, "hidden.example.com", fingerprint: fingerprint)
+        XCTAssertEqual(hidden, "trusted")
+
+        let reopened = try await makeStore().allEntries()
+        XCTAssertTrue(reopened.contains { $0.hostname == "hidden.example.com" && $0.fingerprint == fingerprint })
+
+        let again = try await makeStore().importOpenSSHKnownHosts(contents)
+        XCTAssertEqual(again.imported, 0)
+    }
+
+    func testTornTailIsCutOff() async throws {
+        let store = makeStore()
+        try await store.trust(challenge: challenge("kept", fingerprint: "01"))
+        try await store.trust(challenge: challenge("torn", fingerprint: "02"))
+
+        let handle = try FileHandle(forUpdating: logURL)
+        let length = try handle.seekToEnd()
+        try handle.truncate(atOffset: length - 3)
+        try handle.close()
+
+        let reopened = makeStore()
+        let recovered = try await reopened.allEntries()
+        XCTAssertEqual(recovered.map(\.hostname), ["kept"])
+        try await reopened.trust(challenge: challenge("after", fingerprint: "03"))
+        let appended = try await makeStore().allEntries()
+        XCTAssertEqual(appended.map(\.hostname), ["after", "kept"])
+    }
+
+    func testCompactionKeepsLiveEntries() async throws {
+        let store = makeStore()
+        let rounds = FileKnownHostsStore.compactionMinimumRecords * 3
+        for round in 0..<rounds {
+            try await store.trust(challenge: challenge("host-\(round % 4)", fingerprint: "round-\(round)"))
+        }
+        let size = try XCTUnwrap(try logURL.resourceValues(forKeys: [.fileSizeKey]).fileSize)
+        XCTAssertLessThan(size, FileKnownHostsStore.compactionMinimumRecords * 400)
+
+        let entries = try await makeStore().allEntries()
+        XCTAssertEqual(entries.count, 4)
+        let last = rounds - 1
+        XCTAssertEqual(entries.first { $0.hostname == "host-\(last % 4)" }?.fingerprint, "round-\(last)")
+    }
+
+    func testClearAllRemovesLog() async throws {
+        let store = makeStore()
+        try await store.trust(challenge: challenge("gone", fingerprint: "01"))
+        try await store.clearAll()
+        XCTAssertFalse(FileManager.default.fileExists(atPath: logURL.path))
+        let cleared = try await makeStore().allEntries()
+        XCTAssertTrue(cleared.isEmpty)
+    }
+}
+
+#endif
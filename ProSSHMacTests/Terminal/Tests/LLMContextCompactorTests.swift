@@ -0,0 +1,84 @@
+#if canImport(XCTest)
+import XCTest
+@testable import ProSSHMac
+
+@MainActor
+final class LLMContextCompactorTests: XCTestCase {
+
+    private let bulkyOutput = String(repeating: "drwxr-xr-x  2 root root 4096 etc\n", count: 120)
+
+    private func turn(_ index: Int, output: String) -> [ChatCompletionsWireMessage] {
+        [
+            ChatCompletionsWireMessage(role: "system", content: "You are a terminal copilot."),
+            ChatCompletionsWireMessage(role: "user", content: "question \(index)"),
+            ChatCompletionsWireMessage(
+                role: "assistant",
+                toolCalls: [.init(id: "call_\(index)", function: .init(name: "execute_and_wait", arguments: "{}"))]
+            ),
+            ChatCompletionsWireMessage(role: "tool", content: output, toolCallID: "call_\(index)"),
+            ChatCompletionsWireMessage(role: "assistant", content: "answer \(index)"),
+        ]
+    }
+
+    // MARK: - Budget
+
+    func testHistoryUnderBudgetIsReturnedUnchanged() {
+        let history = turn(1, output: bulkyOutput)
+        let compactor = LLMContextCompactor(maxHistoryTokens: 10_000)
+
+        let compaction = compactor.compact(history)
+
+        XCTAssertFalse(compaction.didChange)
+        XCTAssertEqual(compaction.messages.map(\.content), history.map(\.content))
+    }
+
+    func testOldToolOutputsAreElidedBeforeAnyTurnIsEvicted() {
+        let history = (1...4).flatMap { turn($0, output: bulkyOutput) }
+        let total = history.map(\.estimatedTokens).reduce(0, +)
+        let compactor = LLMContextCompactor(maxHistoryTokens: total - 1, preservedRecentMessages: 5)
+
+        let compaction = compactor.compact(history)
+
+        XCTAssertEqual(compaction.evictedMessages, 0)
+        XCTAssertGreaterThan(compaction.elidedToolOutputs, 0)
+        XCTAssertLessThanOrEqual(compaction.estimatedTokens, compactor.targetHistoryTokens)
+        XCTAssertTrue(compaction.messages[3].content?.hasPrefix("[Earlier tool output elided") ?? false)
+        XCTAssertEqual(compaction.messages.last?.content, "answer 4")
+        XCTAssertEqual(compaction.messages[18].content, bulkyOutput, "the newest turn's output is preserved")
+    }
+
+    func testEvictionDropsWholeTurnsFromTheFront() {
+        let history = (1...6).flatMap { turn($0, output: "short") }
+        let total = history.map(\.estimatedTokens).reduce(0, +)
+        let compactor = LLMContextCompactor(maxHistoryTokens: total / 2, preservedRecentMessages: 5)
+
+        let compaction = compactor.compact(history)
+
+        XCTAssertGreaterThan(compaction.evictedMessages, 0)
+        XCTAssertTrue(compaction.messages.first?.startsTurn ?? false)
+        XCTAssertNotEqual(compaction.messages.first?.role, "tool")
+        XCTAssertEqual(compaction.messages.suffix(5).map(\.content), history.suffix(5).map(\.content))
+    }
+
+    // MARK: - Anthropic
+
+    func testAnthropicToolResultBlocksAreElided() throws {
+        let message = AnthropicWireMessage(
+            role: "user",
+            content: .blocks([
+                AnthropicContentBlock(type: "tool_result", toolUseId: "toolu_1", content: bulkyOutput),
+                AnthropicContentBlock(type: "tool_result", toolUseId: "toolu_2", content: "ok"),
+            ])
+        )
+
+        let slim = try XCTUnwrap(message.elidingToolOutput())
+
+        guard case .blocks(let blocks) = slim.content else { return XCTFail("expected blocks") }
+        XCTAssertTrue(blocks[0].content?.hasPrefix("[Earlier tool output elided") ?? false)
+        XCTAssertEqual(blocks[1].content, "ok")
+        XCTAssertFalse(message.startsTurn)
+        XCTAssertNil(slim.elidingToolOutput())
+        XCTAssertLessThan(slim.estimatedTokens, message.estimatedTokens)
+    }
+}
+#endif
@@ -0,0 +1,75 @@
+// LLMPromptCacheTests.swift
+// ProSSHV2
+//
+// Prompt-prefix caching: byte-identical request encoding, usage parsing
+// for each wire format, and per-conversation usage totals.
+
+#if canImport(XCTest)
+import XCTest
+@testable import ProSSHMac
+
+final class LLMPromptCacheTests: XCTestCase {
+
+    // MARK: - Stable Encoding
+
+    func testToolSchemasEncodeIdenticallyWhateverTheDictionaryHistory() throws {
+        let keys = (0..<32).map { "field_\($0)" }
+        var forward: [String: LLMJSONValue] = [:]
+        for key in keys { forward[key] = .string(key) }
+        var backward: [String: LLMJSONValue] = ["scratch": .null]
+        for key in keys.reversed() { backward[key] = .string(key) }
+        backward.removeValue(forKey: "scratch")
+
+        let encoder = JSONEncoder.llmRequestBody()
+        let first = try encoder.encode(LLMJSONValue.object(forward))
+        let second = try encoder.encode(LLMJSONValue.object(backward))
+
+        XCTAssertEqual(first, second)
+        XCTAssertTrue(String(decoding: first, as: UTF8.self).hasPrefix(#"{"field_0":"field_0","field_1":"#))
+    }
+
+    // MARK: - Chat Completions Usage
+
+    func testStreamChunksWithNullUsageStayOnTheScanner() {
+        let chunk = ChatCompletionsStreamChunk.scan(Array(#"{"choices":[{"delta":{"content":"hi"}}],"usage":null}"#.utf8))
+        XCTAssertEqual(chunk?.choices.first?.delta.content, "hi")
+    }
+
+    func testFinalUsageChunkIsDecoded() throws {
+        let payload = #"{"choices":[],"usage":{"prompt_tokens":1200,"completion_tokens":40,"prompt_tokens_details":{"cached_tokens":1024}}}"#
+        XCTAssertNil(ChatCompletionsStreamChunk.scan(Array(payload.utf8)))
+
+        let chunk = try JSONDecoder().decode(ChatCompletionsStreamChunk.self, from: Data(payload.utf8))
+        XCTAssertEqual(
+            chunk.usage?.llmUsage,
+            LLMTokenUsage(inputTokens: 1_200, outputTokens: 40, cachedInputTokens: 1_024)
+        )
+    }
+
+    func testDeepSeekCacheHitTokensAreCountedAsCached() throws {
+        let payload = #"{"prompt_tokens":900,"completion_tokens":10,"prompt_cache_hit_tokens":768,"prompt_cache_miss_tokens":132}"#
+        let usage = try JSONDecoder().decode(ChatCompletionsWireUsage.self, from: Data(payload.utf8))
+        XCTAssertEqual(usage.llmUsage.cachedInputTokens, 768)
+    }
+
+    // MARK: - Conversation Totals
+
+    @MainActor
+    func testConversationUsageAccumulatesAndClears() throws {
+        let context = AIConversationContext()
+        let sessionID = UUID()
+        context.record(usage: LLMTokenUsage(inputTokens: 1_000, outputTokens: 50), for: sessionID)
+        let total = context.record(
+            usage: LLMTokenUsage(inputTokens: 1_100, outputTokens: 20, cachedInputTokens: 1_000),
+            for: sessionID
+        )
+
+        XCTAssertEqual(total.requests, 2)
+        XCTAssertEqual(total.inputTokens, 2_100)
+        XCTAssertEqual(try XCTUnwrap(total.cacheHitRatio), 1_000.0 / 2_100.0, accuracy: 0.0001)
+
+        context.clear(sessionID: sessionID)
+        XCTAssertNil(context.usage(for: sessionID))
+    }
+}
+#endif
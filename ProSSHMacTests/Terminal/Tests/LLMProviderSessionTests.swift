@@ -0,0 +1,81 @@
+// LLMProviderSessionTests.swift
+// ProSSHV2
+//
+// Dedicated LLM provider sessions: origin derivation, prewarm throttling,
+// time-to-first-token statistics, and registry wiring.
+
+#if canImport(XCTest)
+import XCTest
+@testable import ProSSHMac
+
+final class LLMProviderSessionTests: XCTestCase {
+
+    private func makeSession() -> LLMProviderSession {
+        LLMProviderSession(
+            providerID: .mistral,
+            endpoint: URL(string: "https://api.mistral.ai/v1/chat/completions")!
+        )
+    }
+
+    // MARK: - Configuration
+
+    func testOriginDropsThePathAndKeepsThePort() {
+        XCTAssertEqual(makeSession().origin.absoluteString, "https://api.mistral.ai/")
+        let local = LLMProviderSession(providerID: .ollama, endpoint: URL(string: "http://localhost:11434")!)
+        XCTAssertEqual(local.origin.absoluteString, "http://localhost:11434/")
+    }
+
+    func testConfigurationAvoidsCachesAndCookies() {
+        let configuration = LLMProviderSession.makeConfiguration()
+        XCTAssertNil(configuration.urlCache)
+        XCTAssertFalse(configuration.httpShouldSetCookies)
+        XCTAssertEqual(configuration.networkServiceType, .responsiveData)
+    }
+
+    // MARK: - Prewarm
+
+    func testPrewarmIsSkippedRightAfterARequest() {
+        let session = makeSession()
+        session.noteRequestStarted()
+        session.prewarm()
+        XCTAssertNil(session.diagnostics.lastPrewarmAt)
+    }
+
+    // MARK: - Time to First Token
+
+    func testTimeToFirstTokenKeepsTheLastAndMedianOfRecentSamples() {
+        let session = makeSession()
+        for milliseconds in [900, 100, 300] {
+            session.recordTimeToFirstToken(.milliseconds(milliseconds))
+        }
+        XCTAssertEqual(session.diagnostics.lastTimeToFirstTokenMilliseconds, 300)
+        XCTAssertEqual(session.diagnostics.medianTimeToFirstTokenMilliseconds, 300)
+
+        for _ in 0..<LLMProviderSession.sampleLimit {
+            session.recordTimeToFirstToken(.milliseconds(50))
+        }
+        XCTAssertEqual(session.diagnostics.timeToFirstTokenSamples, LLMProviderSession.sampleLimit)
+        XCTAssertEqual(session.diagnostics.medianTimeToFirstTokenMilliseconds, 50)
+    }
+
+    func testFirstTokenTimerFiresOnce() {
+        let timer = LLMFirstTokenTimer()
+        XCTAssertNotNil(timer.markFirstToken())
+        XCTAssertNil(timer.markFirstToken())
+    }
+
+    // MARK: - Registry
+
+    @MainActor
+    func testRegistryPicksUpProviderSessionsAndRecordsDiagnostics() {
+        let registry = LLMProviderRegistry()
+        registry.register(OllamaProvider())
+        XCTAssertNotNil(registry.session(for: .ollama))
+        XCTAssertNil(registry.session(for: .openai))
+
+        registry.recordTimeToFirstToken(.milliseconds(420), for: .ollama)
+        XCTAssertEqual(registry.sessionDiagnostics.map(\.providerID), [.ollama])
+        XCTAssertEqual(registry.sessionDiagnostics.first?.lastTimeToFirstTokenMilliseconds, 420)
+    }
+}
+#endif
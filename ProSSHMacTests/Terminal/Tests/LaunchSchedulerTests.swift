@@ -0,0 +1,92 @@
+// LaunchSchedulerTests.swift
+// ProSSHV2
+//
+// Launch tiers run in order, jobs within a tier overlap, and the host list
+// defers its Spotlight reindex until asked.
+
+#if canImport(XCTest)
+import XCTest
+@testable import ProSSHMac
+
+@MainActor
+final class LaunchSchedulerTests: XCTestCase {
+
+    // MARK: - Tiers
+
+    func testTiersRunInOrderWhateverTheSchedulingOrder() async {
+        let scheduler = LaunchScheduler()
+        var order: [String] = []
+        scheduler.schedule(.background, "index") { order.append("index") }
+        scheduler.schedule(.firstConnection, "keys") { order.append("keys") }
+        scheduler.schedule(.firstFrame, "hosts") {
+            try? await Task.sleep(for: .milliseconds(20))
+            order.append("hosts")
+        }
+
+        await scheduler.run()
+
+        XCTAssertEqual(order, ["hosts", "keys", "index"])
+        XCTAssertEqual(scheduler.completedTiers, [.firstFrame, .firstConnection, .background])
+    }
+
+    func testJobsWithinATierOverlap() async {
+        let scheduler = LaunchScheduler()
+        var events: [String] = []
+        scheduler.schedule(.background, "slow") {
+            events.append("slow start")
+            try? await Task.sleep(for: .milliseconds(50))
+            events.append("slow end")
+        }
+        scheduler.schedule(.background, "fast") {
+            events.append("fast")
+        }
+
+        await scheduler.run()
+
+        XCTAssertEqual(events.count, 3)
+        XCTAssertEqual(events.last, "slow end", "The fast job should not wait for the slow one")
+    }
+
+    func testJobsScheduledAfterRunAreIgnored() async {
+        let scheduler = LaunchScheduler()
+        await scheduler.run()
+        var ran = false
+        scheduler.schedule(.firstFrame, "late") { ran = true }
+        await scheduler.run()
+        XCTAssertFalse(ran)
+    }
+
+    // MARK: - Host List
+
+    func testStoreLoadDefersSpotlightReindex() async {
+        let indexer = RecordingSearchIndexer()
+        let viewModel = HostListViewModel(
+            hostStore: FixedHostStore(),
+            sessionManager: SessionManager(transport: MockSSHTransport(), knownHostsStore: InMemoryKnownHostsStore()),
+            searchIndexer: indexer
+        )
+
+        await viewModel.loadHostsIfNeeded()
+        XCTAssertEqual(indexer.reindexCount, 0)
+
+        await viewModel.reindexForSearchIfNeeded()
+        await viewModel.reindexForSearchIfNeeded()
+        XCTAssertEqual(indexer.reindexCount, 1)
+    }
+}
+
+@MainActor
+private final class FixedHostStore: HostStoreProtocol {
+    func loadHosts() async throws -> [Host] { [] }
+    func saveHosts(_ hosts: [Host]) async throws {}
+}
+
+@MainActor
+private final class RecordingSearchIndexer: HostSearchIndexing {
+    private(set) var reindexCount = 0
+
+    func reindex(hosts: [Host]) async {
+        reindexCount += 1
+    }
+}
+#endif
@@ -0,0 +1,66 @@
+// LinkDetectorTests.swift
+// ProSSHV2
+//
+// The single-pass link scanner: each kind's boundaries and validity rules,
+// overlaps between kinds, and ranges counted in UTF-16 after non-ASCII text.
+
+#if canImport(XCTest)
+import XCTest
+@testable import ProSSHMac
+
+final class LinkDetectorTests: XCTestCase {
+
+    private func links(_ line: String) -> [String] {
+        LinkDetector().detectLinks(in: line).map(\.text)
+    }
+
+    // MARK: - URLs
+
+    func testURLsKeepBalancedParensAndDropTrailingPunctuation() {
+        XCTAssertEqual(links("see https://en.wikipedia.org/wiki/Tmux_(software)."), ["https://en.wikipedia.org/wiki/Tmux_(software)"])
+        XCTAssertEqual(links("(docs at www.example.org/help)"), ["www.example.org/help"])
+        XCTAssertEqual(links("HTTPS://EXAMPLE.COM <- upper"), ["HTTPS://EXAMPLE.COM"])
+        XCTAssertEqual(links("xhttps://example.com"), [], "A URL starts at a word boundary")
+    }
+
+    func testURLWinsOverThePathInside() {
+        let detected = LinkDetector().detectLinks(in: "GET https://api.example.com/v1/items")
+        XCTAssertEqual(detected.map(\.kind), [.url])
+    }
+
+    // MARK: - Paths
+
+    func testPathsNeedTwoSegmentsAndDropTrailingSlash() {
+        XCTAssertEqual(links("ls /usr/local/bin/"), ["/usr/local/bin"])
+        XCTAssertEqual(links("cd /tmp"), [])
+        XCTAssertEqual(links("edit ~/.zshrc, then ./run.sh"), ["~/.zshrc", "./run.sh"])
+        XCTAssertEqual(links("../lib/x.swift:12"), ["./lib/x.swift"])
+        XCTAssertEqual(links("a/b/c"), [], "A path starts after a non-word character")
+    }
+
+    // MARK: - IPv4
+
+    func testIPv4OctetsAreValidated() {
+        XCTAssertEqual(links("ping 10.0.0.1 and 192.168.1.255"), ["10.0.0.1", "192.168.1.255"])
+        XCTAssertEqual(links("10.0.0.256"), [])
+        XCTAssertEqual(links("009.1.1.1"), [])
+        XCTAssertEqual(links("v1.2.3.4"), [])
+        XCTAssertEqual(links("1.2.3.4.5"), ["1.2.3.4"])
+    }
+
+    // MARK: - Ranges
+
+    func testRangesCountUTF16AfterNonASCII() {
+        let line = "🚀 déployé → https://example.com/ok"
+        let detected = LinkDetector().detectLinks(in: line)
+        XCTAssertEqual(detected.count, 1)
+        let range = Range(detected[0].range, in: line)
+        XCTAssertEqual(range.map { String(line[$0]) }, "https://example.com/ok")
+    }
+
+    func testNonASCIILetterIsAWordCharacter() {
+        XCTAssertEqual(links("é/usr/bin"), [])
+        XCTAssertEqual(links("ü10.0.0.1"), [])
+    }
+}
+#endif
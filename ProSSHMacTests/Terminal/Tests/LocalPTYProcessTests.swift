@@ -0,0 +1,104 @@
+// LocalPTYProcessTests.swift
+// ProSSHV2
+//
+// The local PTY's dispatch-driven reader and queued writer, and the zsh
+// startup warning filter that sits in front of the output ring.
+
+#if canImport(XCTest)
+import XCTest
+@testable import ProSSHMac
+
+@MainActor
+final class LocalPTYProcessTests: XCTestCase {
+
+    // MARK: - Helpers
+
+    /// Drains `ring` until `marker` appears or the ring finishes.
+    private func drain(_ ring: ShellOutputRing, until marker: String) async -> Data {
+        var output = Data()
+        let needle = Data(marker.utf8)
+        while await ring.waitForReadable() {
+            let region = ring.readableRegion
+            output.append(contentsOf: region)
+            ring.consume(region.count)
+            if output.range(of: needle) != nil { break }
+        }
+        return output
+    }
+
+    private func spawnShell() async throws -> LocalPTYProcess {
+        try await LocalPTYProcess.spawn(
+            columns: 80,
+            rows: 24,
+            shellPath: "/bin/sh",
+            environment: ["PATH": "/usr/bin:/bin", "TERM": "xterm-256color"],
+            workingDirectory: NSTemporaryDirectory()
+        )
+    }
+
+    // MARK: - Tests
+
+    func testFilterDropsWarningSplitAcrossChunks() {
+        var filter = ZshTTYPgrpWarningFilter()
+        let first = filter.filter(ArraySlice("banner\nzsh: can't se".utf8))
+        let second = filter.filter(ArraySlice("t tty pgrp: Operation not permitted\n$ ".utf8))
+
+        XCTAssertEqual(String(decoding: first + second + filter.flush(), as: UTF8.self), "banner\n$ ")
+        XCTAssertFalse(filter.isActive)
+    }
+
+    func testFilterStopsInspectingAfterStartupWindow() {
+        var filter = ZshTTYPgrpWarningFilter()
+        let startup = [UInt8](repeating: UInt8(ascii: "a"), count: ZshTTYPgrpWarningFilter.startupWindow)
+        XCTAssertEqual(filter.filter(startup[...]), startup)
+        XCTAssertFalse(filter.isActive)
+
+        let late = Array("zsh: can't set tty pgrp: x\n".utf8)
+        XCTAssertEqual(filter.filter(late[...]), late, "Output after the window passes through untouched")
+    }
+
+    func testFilterReleasesHeldPrefixOnFlush() {
+        var filter = ZshTTYPgrpWarningFilter()
+        let output = filter.filter(ArraySlice("ok zsh:".utf8))
+        XCTAssertEqual(String(decoding: output, as: UTF8.self), "ok ")
+        XCTAssertEqual(String(decoding: filter.flush(), as: UTF8.self), "zsh:")
+    }
+
+    func testBulkOutputArrivesInOrderThroughTheRing() async throws {
+        let process = try await spawnShell()
+        try await process.send(bytes: Array("stty -echo; seq 1 20000; echo READY''_DONE\n".utf8))
+
+        let output = await drain(process.outputRing, until: "READY_DONE")
+        await process.close()
+
+        let lines = String(decoding: output, as: UTF8.self)
+            .split(whereSeparator: \.isNewline)
+            .map { $0.trimmingCharacters(in: .whitespaces) }
+            .filter { Int($0) != nil }
+        XCTAssertEqual(lines.count, 20_000)
+        XCTAssertEqual(lines.first, "1")
+        XCTAssertEqual(lines.last, "20000")
+    }
+
+    func testLargeWriteIsQueuedAndFlushed() async throws {
+        let process = try await spawnShell()
+        try await process.send(bytes: Array("stty -echo; wc -c\n".utf8))
+        // Larger than the PTY's input buffer, so most of it waits for writability.
+        let payload = [UInt8](repeating: UInt8(ascii: "x"), count: 200_000)
+        for offset in stride(from: 0, to: payload.count, by: 1_000) {
+            var line = Array(payload[offset..<offset + 999])
+            line.append(UInt8(ascii: "\n"))
+            try await process.send(bytes: line, priority: .bulk)
+        }
+        // Bulk too, so the end-of-file is not sent ahead of the queued lines.
+        try await process.send(bytes: [0x04], priority: .bulk)
+
+        let output = await drain(process.outputRing, until: "200000")
+        let queued = await process.queuedBulkByteCount
+        await process.close()
+
+        XCTAssertTrue(String(decoding: output, as: UTF8.self).contains("200000"))
+        XCTAssertEqual(queued, 0)
+    }
+}
+#endif
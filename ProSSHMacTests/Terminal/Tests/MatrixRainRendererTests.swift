@@ -0,0 +1,49 @@
+// MatrixRainRendererTests.swift
+// ProSSHV2
+//
+// GPU screensaver: the Swift uniforms keep the Metal struct's layout, and
+// every character of a set gets a glyph on the atlas's first coverage page.
+
+#if canImport(XCTest)
+import XCTest
+import Metal
+@testable import ProSSHMac
+
+@MainActor
+final class MatrixRainRendererTests: XCTestCase {
+
+    // MARK: - Tests
+
+    func testUniformsMatchShaderLayout() {
+        XCTAssertEqual(MemoryLayout<MatrixRainUniforms>.stride, 64)
+        XCTAssertEqual(MemoryLayout<MatrixRainUniforms>.offset(of: \.time), 16)
+        XCTAssertEqual(MemoryLayout<MatrixRainUniforms>.offset(of: \.seed), 36)
+        XCTAssertEqual(MemoryLayout<MatrixRainUniforms>.offset(of: \.color), 48)
+    }
+
+    func testGlyphTableHasARectPerCharacter() throws {
+        guard let device = MTLCreateSystemDefaultDevice() else {
+            throw XCTSkip("No Metal device available")
+        }
+        let characters = MatrixCharacterSet.katakanaAndLatin.characters
+        let table = try XCTUnwrap(MatrixRainGlyphTable(
+            device: device,
+            characters: characters,
+            cellSize: MatrixRainRenderer.cellSize,
+            scale: 2
+        ))
+
+        XCTAssertEqual(table.rects.count, characters.count)
+        XCTAssertEqual(table.texture.pixelFormat, .r8Unorm)
+        for rect in table.rects where rect != MatrixRainGlyphTable.missingRect {
+            XCTAssertGreaterThanOrEqual(rect.x, 0)
+            XCTAssertGreaterThanOrEqual(rect.y, 0)
+            XCTAssertLessThanOrEqual(rect.z, 1)
+            XCTAssertLessThanOrEqual(rect.w, 1)
+            XCTAssertLessThan(rect.x, rect.z)
+            XCTAssertLessThan(rect.y, rect.w)
+        }
+        XCTAssertTrue(table.rects.contains { $0 != MatrixRainGlyphTable.missingRect })
+    }
+}
+#endif
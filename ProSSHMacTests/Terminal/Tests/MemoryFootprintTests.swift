@@ -0,0 +1,104 @@
+// MemoryFootprintTests.swift
+// ProSSHV2
+//
+// Tests for per-session memory accounting: footprint arithmetic and the
+// diagnostics summary, the estimates reported by the grid's storage, and
+// the scrollback trim used under memory pressure.
+
+#if canImport(XCTest)
+import XCTest
+@testable import ProSSHMac
+
+final class MemoryFootprintTests: XCTestCase {
+
+    // MARK: - Helpers
+
+    private func filledBuffer(lines: Int) -> ScrollbackBuffer {
+        var buffer = ScrollbackBuffer(maxLines: 1_000_000, spillFile: { nil })
+        for index in 0..<lines {
+            buffer.push(cells: "line \(index)".unicodeScalars.map { TerminalCell(graphemeCluster: String($0)) })
+        }
+        return buffer
+    }
+
+    private func text(_ line: ScrollbackLine?) -> String {
+        guard let line else { return "<nil>" }
+        return (0..<line.count).map { line.grapheme(at: $0) }.joined()
+    }
+
+    // MARK: - Tests
+
+    func testFootprintsAddBySubsystem() {
+        var footprint = MemoryFootprint(.grid, bytes: 100)
+        footprint += MemoryFootprint(.scrollback, bytes: 50)
+        let sum = footprint + MemoryFootprint(.grid, bytes: 25)
+
+        XCTAssertEqual(sum[.grid], 125)
+        XCTAssertEqual(sum[.scrollback], 50)
+        XCTAssertEqual(sum[.recorder], 0)
+        XCTAssertEqual(sum.totalBytes, 175)
+    }
+
+    func testNegativeBytesClampToZero() {
+        var footprint = MemoryFootprint(.recorder, bytes: 10)
+        footprint[.recorder] -= 20
+        XCTAssertEqual(footprint[.recorder], 0)
+        XCTAssertEqual(footprint.totalBytes, 0)
+    }
+
+    func testSummaryListsLargestFirstAndSkipsEmpty() {
+        var footprint = MemoryFootprint(.grid, bytes: 1024)
+        footprint[.scrollback] = 4096
+        footprint[.graphemes] = 0
+
+        let lines = footprint.summary.components(separatedBy: "\n")
+
+        XCTAssertEqual(lines.count, 3)
+        XCTAssertTrue(lines[0].hasPrefix("Scrollback: "))
+        XCTAssertTrue(lines[1].hasPrefix("Grid: "))
+        XCTAssertTrue(lines[2].hasPrefix("Total: "))
+    }
+
+    func testTrimKeepsTheNewestLines() {
+        var buffer = filledBuffer(lines: 5_000)
+        let firstLineID = buffer.firstLineID
+
+        buffer.trim(toLines: 1_200)
+
+        XCTAssertEqual(buffer.count, 1_200)
+        XCTAssertEqual(buffer.firstLineID, firstLineID + 3_800)
+        XCTAssertEqual(text(buffer.line(at: 0)), "line 3800")
+        XCTAssertEqual(text(buffer.line(at: 1_199)), "line 4999")
+    }
+
+    func testTrimShrinksTheEstimate() {
+        var buffer = filledBuffer(lines: 5_000)
+        let before = buffer.estimatedMemoryBytes
+
+        buffer.trim(toLines: 100)
+
+        XCTAssertLessThan(buffer.estimatedMemoryBytes, before)
+        buffer.trim(toLines: 0)
+        XCTAssertEqual(buffer.count, 0)
+    }
+
+    func testTrimAboveCountIsANoOp() {
+        var buffer = filledBuffer(lines: 10)
+        buffer.trim(toLines: 100)
+        XCTAssertEqual(buffer.count, 10)
+        XCTAssertEqual(text(buffer.line(at: 0)), "line 0")
+    }
+
+    func testGraphemeTableEstimateCountsClusters() {
+        var table = GraphemeSideTable()
+        let empty = table.estimatedByteCount
+        let family = "👨‍👩‍👧"
+        let codepoint = table.allocate(family)
+
+        let allocated = table.estimatedByteCount
+        XCTAssertGreaterThanOrEqual(allocated, empty + family.utf8.count)
+        table.release(codepoint)
+        XCTAssertLessThan(table.estimatedByteCount, allocated)
+    }
+}
+#endif
@@ -67,9 +67,9 @@ final class MockSSHTransportTests: XCTestCase {
         _ = try await transport.connect(sessionID: sessionID, to: host, jumpHostConfig: nil)
         await transport.disconnect(sessionID: sessionID)
 
-        // After disconnect, keepalive should return false (session gone)
-        let alive = await transport.sendKeepalive(sessionID: sessionID)
-        XCTAssertFalse(alive)
+        // After disconnect, keepalive should report the session gone
+        let result = await transport.sendKeepalive(sessionID: sessionID, deadPeerTimeout: 30)
+        XCTAssertEqual(result, .dead)
     }
 
     func testSessionNotFoundErrorIfNotConnected() async throws {
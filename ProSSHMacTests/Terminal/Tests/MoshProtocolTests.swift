@@ -0,0 +1,141 @@
+// MoshProtocolTests.swift
+// ProSSHV2
+//
+// The mosh wire format: AES-128-OCB against the RFC 7253 vectors, datagram
+// sealing, zlib framing, transport instructions and their fragments, and
+// the `MOSH CONNECT` line mosh-server prints at startup.
+
+#if canImport(XCTest)
+import XCTest
+@testable import ProSSHMac
+
+final class MoshProtocolTests: XCTestCase {
+
+    // MARK: - Helpers
+
+    private func bytes(hex: String) -> [UInt8] {
+        var result: [UInt8] = []
+        var index = hex.startIndex
+        while index < hex.endIndex {
+            let next = hex.index(index, offsetBy: 2)
+            result.append(UInt8(hex[index..<next], radix: 16)!)
+            index = next
+        }
+        return result
+    }
+
+    private func rfcCipher() throws -> AES128OCB {
+        try AES128OCB(key: Array(0..<16))
+    }
+
+    // MARK: - Tests
+
+    func testOCBMatchesRFC7253Vectors() throws {
+        let cipher = try rfcCipher()
+        let vectors: [(nonce: String, plaintext: String, sealed: String)] = [
+            ("BBAA99887766554433221100", "", "785407BFFFC8AD9EDCC5520AC9111EE6"),
+            ("BBAA99887766554433221103", "0001020304050607", "45DD69F8F5AAE72414054CD1F35D82760B2CD00D2F99BFA9"),
+            ("BBAA99887766554433221106", "000102030405060708090A0B0C0D0E0F",
+             "5CE88EC2E0692706A915C00AEB8B2396F40E1C743F52436BDF06D8FA1ECA343D"),
+            ("BBAA99887766554433221109", "000102030405060708090A0B0C0D0E0F1011121314151617",
+             "221BD0DE7FA6FE993ECCD769460A0AF2D6CDED0C395B1C3CE725F32494B9F914D85C0B1EB38357FF"),
+        ]
+        for vector in vectors {
+            let sealed = cipher.seal(bytes(hex: vector.plaintext), nonce: bytes(hex: vector.nonce))
+            XCTAssertEqual(sealed, bytes(hex: vector.sealed), vector.nonce)
+            XCTAssertEqual(try cipher.open(sealed[...], nonce: bytes(hex: vector.nonce)), bytes(hex: vector.plaintext))
+        }
+    }
+
+    func testOCBRejectsTamperedCiphertext() throws {
+        let cipher = try rfcCipher()
+        let nonce = bytes(hex: "BBAA99887766554433221103")
+        var sealed = cipher.seal(Array("keystrokes".utf8), nonce: nonce)
+        sealed[3] ^= 0x01
+        XCTAssertThrowsError(try cipher.open(sealed[...], nonce: nonce))
+    }
+
+    func testSessionOpensServerPacketsAndRejectsReflectedOnes() throws {
+        let key = "AAECAwQFBgcICQoLDA0ODw"
+        let session = try MoshCryptoSession(base64Key: key)
+        let cipher = try rfcCipher()
+
+        // Hand-sealed as the server would: direction bit set.
+        let sequence = MoshPacket.toClientBit | 7
+        let sequenceBytes = (0..<8).map { UInt8(truncatingIfNeeded: sequence >> (56 - 8 * $0)) }
+        let plaintext: [UInt8] = [0x01, 0x02, 0xFF, 0xFF] + Array("frag".utf8)
+        let datagram = sequenceBytes + cipher.seal(plaintext, nonce: [0, 0, 0, 0] + sequenceBytes)
+
+        let packet = try session.open(datagram)
+        XCTAssertEqual(packet.sequence, 7)
+        XCTAssertEqual(packet.timestamp, 0x0102)
+        XCTAssertEqual(packet.timestampReply, MoshPacket.noTimestamp)
+        XCTAssertEqual(packet.payload, Array("frag".utf8))
+
+        let ownPacket = session.seal(MoshPacket(sequence: 7, timestamp: 1, timestampReply: 2, payload: [9]))
+        XCTAssertThrowsError(try session.open(ownPacket), "A client packet echoed back is not accepted")
+        XCTAssertThrowsError(try MoshCryptoSession(base64Key: "short"))
+    }
+
+    func testZlibFramingMatchesZlib() throws {
+        XCTAssertEqual(try MoshZlib.decompress(bytes(hex: "789CCB48CDC9C90700062C0215")), Array("hello".utf8))
+        let payload = Array(String(repeating: "\u{1B}[1;1Hprompt$ ", count: 200).utf8)
+        XCTAssertEqual(try MoshZlib.decompress(MoshZlib.compress(payload)), payload)
+        XCTAssertEqual(MoshZlib.adler32(Array("hello".utf8)), 0x062C_0215)
+    }
+
+    func testInstructionRoundTripsThroughFragments() throws {
+        // Incompressible, so the instruction needs several fragments.
+        var state: UInt32 = 1
+        let diff = (0..<6_000).map { _ -> UInt8 in
+            state = state &* 1_664_525 &+ 1_013_904_223
+            return UInt8(truncatingIfNeeded: state >> 24)
+        }
+        let instruction = MoshTransportInstruction(oldNum: 3, newNum: 9, ackNum: 41, throwawayNum: 3, diff: diff)
+        let fragments = MoshFragment.fragments(of: instruction, id: 5)
+        XCTAssertGreaterThan(fragments.count, 1)
+        XCTAssertEqual(fragments.filter(\.isFinal).count, 1)
+
+        var assembly = MoshFragmentAssembly()
+        var decoded: MoshTransportInstruction?
+        for fragment in fragments.reversed() {
+            decoded = try assembly.add(MoshFragment(decoding: fragment.encoded()))
+        }
+        XCTAssertEqual(decoded, instruction)
+    }
+
+    func testHostDiffDecoding() throws {
+        var hostBytes = ProtobufWriter()
+        hostBytes.writeBytes(field: 4, Array("\u{1B}[2;5Hls".utf8))
+        var echoAck = ProtobufWriter()
+        echoAck.writeVarint(field: 8, 12)
+        var first = ProtobufWriter()
+        first.writeBytes(field: 2, hostBytes.bytes)
+        var second = ProtobufWriter()
+        second.writeBytes(field: 7, echoAck.bytes)
+        var message = ProtobufWriter()
+        message.writeBytes(field: 1, first.bytes)
+        message.writeBytes(field: 1, second.bytes)
+
+        XCTAssertEqual(try MoshHostEvent.decodeDiff(message.bytes), [
+            .hostBytes(Array("\u{1B}[2;5Hls".utf8)),
+            .echoAck(12),
+        ])
+    }
+
+    func testUserDiffEncoding() {
+        let diff = MoshUserEvent.encodedDiff([.resize(columns: 120, rows: 40), .keystroke([0x6C])])
+        XCTAssertEqual(diff, [
+            0x0A, 0x06, 0x1A, 0x04, 0x28, 0x78, 0x30, 0x28,
+            0x0A, 0x05, 0x12, 0x03, 0x22, 0x01, 0x6C,
+        ])
+    }
+
+    func testConnectLineParsing() throws {
+        let output = "\r\nMOSH CONNECT 60001 4NeCCgvZFe2RnPgrcU1PQw\r\n"
+        XCTAssertEqual(try MoshBootstrap.parseConnectLine(output), MoshBootstrap.Endpoint(port: 60001, key: "4NeCCgvZFe2RnPgrcU1PQw"))
+        XCTAssertThrowsError(try MoshBootstrap.parseConnectLine("mosh-server: command not found\n"))
+        XCTAssertThrowsError(try MoshBootstrap.parseConnectLine("MOSH CONNECT x key\n"))
+    }
+}
+#endif
@@ -89,5 +89,70 @@ final class MouseEncoderTests: XCTestCase {
 
         XCTAssertEqual(encoder.encode(event), "\u{1B}[<28;11;7M")
     }
+
+    @MainActor
+    func testBufferEncodingMatchesStringEncoding() {
+        let encoder = MouseEncoder(trackingMode: .anyEvent, encoding: .sgr)
+        var buffer: [UInt8] = Array("prefix".utf8)
+        let events = [
+            MouseEvent(kind: .move, button: .none, row: 0, column: 9),
+            MouseEvent(kind: .release, button: .left, row: 99, column: 1234),
+            MouseEvent(kind: .scrollDown, button: .none, row: 41, column: 200, modifiers: [.ctrl])
+        ]
+        for event in events {
+            buffer.removeAll(keepingCapacity: true)
+            XCTAssertTrue(encoder.encode(event, into: &buffer))
+            XCTAssertEqual(buffer, Array(encoder.encode(event)!.utf8))
+        }
+
+        buffer.removeAll()
+        let none = MouseEncoder(trackingMode: .none, encoding: .sgr)
+        XCTAssertFalse(none.encode(events[0], into: &buffer))
+        XCTAssertEqual(buffer, [], "Unreported events leave the buffer alone")
+    }
+
+    @MainActor
+    func testMotionCoalescesToLatestCell() {
+        var coalescer = MouseMotionCoalescer()
+
+        XCTAssertTrue(coalescer.submit(MouseEvent(kind: .move, button: .none, row: 1, column: 1)))
+        XCTAssertFalse(coalescer.submit(MouseEvent(kind: .move, button: .none, row: 1, column: 2)), "Already scheduled")
+        XCTAssertFalse(coalescer.submit(MouseEvent(kind: .move, button: .none, row: 1, column: 3)))
+
+        let latest = coalescer.take()
+        XCTAssertEqual(latest?.column, 3)
+        XCTAssertNil(coalescer.take())
+    }
+
+    @MainActor
+    func testMotionInReportedCellIsDropped() {
+        var coalescer = MouseMotionCoalescer()
+        let reported = MouseEvent(kind: .move, button: .none, row: 5, column: 5)
+        coalescer.noteReported(reported)
+
+        XCTAssertFalse(coalescer.submit(reported))
+        XCTAssertNil(coalescer.pending)
+
+        // Out and back before the frame: nothing new to report.
+        XCTAssertTrue(coalescer.submit(MouseEvent(kind: .move, button: .none, row: 5, column: 6)))
+        XCTAssertFalse(coalescer.submit(reported))
+        XCTAssertNil(coalescer.take())
+
+        // Same cell with a button held is new information.
+        XCTAssertTrue(coalescer.submit(MouseEvent(kind: .move, button: .left, row: 5, column: 5)))
+    }
+
+    @MainActor
+    func testPressAndReleaseUpdateReportedPosition() {
+        var coalescer = MouseMotionCoalescer()
+        coalescer.noteReported(MouseEvent(kind: .press, button: .left, row: 2, column: 2))
+        XCTAssertFalse(coalescer.submit(MouseEvent(kind: .move, button: .left, row: 2, column: 2)))
+
+        coalescer.noteReported(MouseEvent(kind: .release, button: .left, row: 2, column: 2))
+        XCTAssertFalse(
+            coalescer.submit(MouseEvent(kind: .move, button: .none, row: 2, column: 2)),
+            "After a release the app already has this cell with no button held"
+        )
+    }
 }
 #endif
@@ -477,6 +477,47 @@ final class OpenAIResponsesServiceTests: XCTestCase {
         XCTAssertTrue(streamEvents.contains(.reasoningSummaryTextDone("Checking config... done.")))
     }
 
+    @MainActor
+    func testCreateResponseStreamingAssemblesFunctionCallFromArgumentDeltas() async throws {
+        let provider = StaticAPIKeyProvider(key: "sk-test-123")
+        let eventLines = [
+            "event: response.output_item.added",
+            #"data: {"type":"response.output_item.added","response_id":"resp_tool","output_index":0,"item":{"type":"function_call","id":"fc_1","name":"read_file","call_id":"call_1","arguments":""}}"#,
+            "",
+            "event: response.function_call_arguments.delta",
+            #"data: {"type":"response.function_call_arguments.delta","item_id":"fc_1","output_index":0,"delta":"{\"path\":"}"#,
+            "",
+            "event: response.function_call_arguments.delta",
+            #"data: {"type":"response.function_call_arguments.delta","item_id":"fc_1","output_index":0,"delta":"\"/tmp/caf\u00e9\"}"}"#,
+            "",
+            "data: [DONE]",
+            "",
+        ]
+        let body = eventLines.joined(separator: "\n")
+        let session = Self.makeStubbedURLSession(
+            statusCode: 200,
+            headers: ["Content-Type": "text/event-stream"],
+            body: Data(body.utf8)
+        )
+
+        let service = OpenAIResponsesService(
+            apiKeyProvider: provider,
+            session: session,
+            endpointURL: URL(string: "https://example.com/v1/responses")!
+        )
+
+        let result = try await service.createResponseStreaming(
+            OpenAIResponsesRequest(messages: [.init(role: .user, text: "hello")]),
+            onEvent: { _ in }
+        )
+
+        XCTAssertEqual(result.id, "resp_tool")
+        XCTAssertEqual(result.output.count, 1)
+        XCTAssertEqual(result.output.first?.name, "read_file")
+        XCTAssertEqual(result.output.first?.callID, "call_1")
+        XCTAssertEqual(result.output.first?.arguments, #"{"path":"/tmp/café"}"#)
+    }
+
     private static func makeHTTPResponse(statusCode: Int) -> HTTPURLResponse {
         HTTPURLResponse(
             url: URL(string: "https://example.com/v1/responses")!,
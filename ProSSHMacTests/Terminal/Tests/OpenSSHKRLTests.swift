@@ -0,0 +1,127 @@
+// OpenSSHKRLTests.swift
+// ProSSHV2
+//
+// Binary KRL encoding: serial subsection choice (list, range, bitmap),
+// round trips through the reader, incremental appends, and serial/key ID
+// lookups in CertificateRevocationIndex.
+
+#if canImport(XCTest)
+import XCTest
+@testable import ProSSHMac
+
+final class OpenSSHKRLTests: XCTestCase {
+
+    private let caKey = Data("ca-key-blob".utf8)
+
+    private func roundTrip(_ krl: OpenSSHKRL) throws -> OpenSSHKRL {
+        try OpenSSHKRL(parsing: krl.serialized())
+    }
+
+    // MARK: - Serial Subsections
+
+    func testContiguousSerialsBecomeOneRange() {
+        let subsections = OpenSSHKRL.serialSubsections(Array(100...5_000))
+        XCTAssertEqual(subsections.map(\.type), [.serialRange])
+    }
+
+    func testSparseSerialsBecomeOneList() {
+        let subsections = OpenSSHKRL.serialSubsections([5, 1_000, 90_000, 7_000_000])
+        XCTAssertEqual(subsections.map(\.type), [.serialList])
+        XCTAssertEqual(subsections.first?.data.count, 32)
+    }
+
+    func testDenseSerialsWithGapsBecomeABitmap() {
+        let serials = (1...2_000).map(UInt64.init).filter { !$0.isMultiple(of: 3) }
+        let subsections = OpenSSHKRL.serialSubsections(serials)
+        XCTAssertEqual(subsections.map(\.type), [.serialBitmap])
+        XCTAssertLessThan(subsections[0].data.count, 300)
+    }
+
+    // MARK: - Round Trip
+
+    func testCertificateSectionRoundTrips() throws {
+        let serials: [UInt64] = [0, 3, 7, 8, 9] + Array(500...900) + (2_000...2_400).filter { $0.isMultiple(of: 2) }
+        let krl = OpenSSHKRL(
+            version: 4,
+            generatedDate: 1_700_000_000,
+            comment: "test",
+            sections: [OpenSSHKRL.certificateSection(caKey: caKey, serials: serials, keyIDs: ["alice", "bob"])]
+        )
+
+        let parsed = try roundTrip(krl)
+        XCTAssertEqual(parsed.version, 4)
+        XCTAssertEqual(parsed.generatedDate, 1_700_000_000)
+        XCTAssertEqual(parsed.comment, "test")
+        let revoked = try XCTUnwrap(parsed.revokedCertificates()[caKey])
+        XCTAssertEqual(revoked.keyIDs, ["alice", "bob"])
+        for serial in serials where serial != 0 {
+            XCTAssertTrue(revoked.containsSerial(serial), "serial \(serial)")
+        }
+        XCTAssertFalse(revoked.containsSerial(0), "Serial 0 is not revocable by serial")
+        XCTAssertFalse(revoked.containsSerial(4))
+        XCTAssertFalse(revoked.containsSerial(2_001))
+        XCTAssertFalse(revoked.containsSerial(901))
+    }
+
+    func testParsingRejectsOtherFiles() {
+        XCTAssertThrowsError(try OpenSSHKRL(parsing: Data("ssh-ed25519 AAAA".utf8)))
+    }
+
+    // MARK: - Incremental
+
+    func testAppendKeepsExistingSectionsAndDropsSignatures() throws {
+        let existing = OpenSSHKRL.certificateSection(caKey: caKey, serials: [1, 2], keyIDs: [])
+        let fingerprint = OpenSSHKRL.Section(type: OpenSSHKRL.SectionType.fingerprintSHA256.rawValue, data: Data(count: 36))
+        let signature = OpenSSHKRL.Section(type: OpenSSHKRL.SectionType.signature.rawValue, data: Data(count: 8))
+        var krl = try roundTrip(OpenSSHKRL(
+            version: 1,
+            generatedDate: 0,
+            comment: "",
+            sections: [existing, fingerprint, signature]
+        ))
+
+        let appended = OpenSSHKRL.certificateSection(caKey: caKey, serials: [10], keyIDs: [])
+        krl.appendCertificateSections([appended])
+
+        XCTAssertEqual(krl.sections, [existing, appended, fingerprint])
+        let revoked = try XCTUnwrap(roundTrip(krl).revokedCertificates()[caKey])
+        XCTAssertEqual(revoked.serialRanges, [1...2, 10...10])
+    }
+
+    // MARK: - Revocation Index
+
+    func testIndexScopesSerialAndKeyIDLookupsToTheCA() {
+        func certificate(serial: UInt64, keyID: String, ca: String) -> SSHCertificate {
+            SSHCertificate(
+                id: UUID(),
+                type: .user,
+                serialNumber: serial,
+                keyId: keyID,
+                principals: [],
+                validAfter: .distantPast,
+                validBefore: .distantFuture,
+                criticalOptions: [:],
+                extensions: [],
+                signingCAFingerprint: ca,
+                signedKeyFingerprint: "",
+                signatureAlgorithm: "",
+                associatedKeyId: nil,
+                rawCertificateData: Data(),
+                authorizedRepresentation: nil,
+                importedFrom: nil,
+                createdAt: .now
+            )
+        }
+        let index = CertificateRevocationIndex(certificates: [
+            certificate(serial: 7, keyID: "alice", ca: "SHA256:a"),
+            certificate(serial: 7, keyID: "bob", ca: "SHA256:b"),
+            certificate(serial: 8, keyID: "alice", ca: "SHA256:b")
+        ])
+
+        XCTAssertEqual(index.certificates(serial: 7, caFingerprint: nil).count, 2)
+        XCTAssertEqual(index.certificates(serial: 7, caFingerprint: "SHA256:b").map(\.keyId), ["bob"])
+        XCTAssertEqual(index.certificates(keyID: "alice", caFingerprint: "SHA256:b").map(\.serialNumber), [8])
+        XCTAssertTrue(index.certificates(serial: 9, caFingerprint: nil).isEmpty)
+    }
+}
+#endif
@@ -0,0 +1,53 @@
+// PackedPaletteTests.swift
+// ProSSHV2
+//
+// The packed palette table behind SGR colour resolution: it must agree
+// with TerminalColor.packedRGBA() by default and follow OSC 4/104 updates.
+
+#if canImport(XCTest)
+import XCTest
+@testable import ProSSHMac
+
+final class PackedPaletteTests: XCTestCase {
+
+    // MARK: - Table
+
+    func testDefaultTableMatchesTerminalColorPacking() {
+        let palette = PackedPalette()
+        for index in 0...255 {
+            let color = TerminalColor.indexed(UInt8(index))
+            XCTAssertEqual(palette.packed(color), color.packedRGBA(), "index \(index)")
+            XCTAssertEqual(
+                palette.packedBold(color),
+                color.packedRGBA(bold: true, boldIsBright: true),
+                "bold index \(index)"
+            )
+        }
+        XCTAssertEqual(palette.packed(.default), 0)
+        XCTAssertEqual(palette.packed(.rgb(1, 2, 3)), TerminalColor.rgb(1, 2, 3).packedRGBA())
+    }
+
+    func testSetAndResetEntry() {
+        var palette = PackedPalette()
+        palette.set(index: 4, r: 0x12, g: 0x34, b: 0x56)
+        XCTAssertEqual(palette[4], 0x1234_56FF)
+
+        palette.reset(index: 4)
+        XCTAssertEqual(palette[4], TerminalColor.indexed(4).packedRGBA())
+    }
+
+    // MARK: - Grid
+
+    func testPaletteOverrideAppliesToNewOutput() {
+        let grid = TerminalGrid(columns: 10, rows: 2)
+        grid.setPaletteColor(index: 1, r: 0xFF, g: 0x80, b: 0x00)
+        grid.setCurrentFgColor(.indexed(1))
+        grid.printCharacter("a")
+        XCTAssertEqual(grid.cellAt(row: 0, col: 0)?.fgPackedRGBA, 0xFF80_00FF)
+
+        grid.resetPaletteColor(index: 1)
+        grid.printCharacter("b")
+        XCTAssertEqual(grid.cellAt(row: 0, col: 1)?.fgPackedRGBA, TerminalColor.indexed(1).packedRGBA())
+    }
+}
+#endif
@@ -0,0 +1,120 @@
+// ParallelCommandTests.swift
+// ProSSHV2
+//
+// Commands run across hosts over exec channels: one row per host with its
+// output and exit status, failures confined to their host, no terminal
+// sessions left behind, and cancellation.
+
+#if canImport(XCTest)
+import XCTest
+@testable import ProSSHMac
+
+@MainActor
+final class ParallelCommandTests: XCTestCase {
+
+    // MARK: - Helpers
+
+    private func makeManager() -> SessionManager {
+        SessionManager(
+            transport: MockSSHTransport(),
+            knownHostsStore: ParallelCommandKnownHostsStore()
+        )
+    }
+
+    private func makeHost(_ hostname: String, username: String = "ops") -> ProSSHMac.Host {
+        ProSSHMac.Host(
+            id: UUID(),
+            label: hostname,
+            folder: "Fleet",
+            hostname: hostname,
+            port: 22,
+            username: username,
+            authMethod: .password,
+            keyReference: nil,
+            certificateReference: nil,
+            passwordReference: nil,
+            jumpHost: nil,
+            algorithmPreferences: nil,
+            pinnedHostKeyAlgorithms: [],
+            agentForwardingEnabled: false,
+            legacyModeEnabled: false,
+            tags: [],
+            notes: nil,
+            lastConnected: nil,
+            createdAt: .now
+        )
+    }
+
+    // MARK: - Tests
+
+    func testEveryHostGetsARowWithItsOutput() async {
+        let manager = makeManager()
+        let hosts = (1...5).map { makeHost("web\($0).test.local") }
+            + [makeHost("refuse.local"), makeHost("db.test.local", username: "invalid")]
+
+        manager.parallelCommandCoordinator.run("df -h /", on: hosts, resolveHost: { _ in nil }, maximumConcurrent: 3)
+        await manager.parallelCommandCoordinator.waitUntilFinished()
+
+        guard let run = manager.parallelCommandRun else {
+            return XCTFail("No run published")
+        }
+        XCTAssertTrue(run.isFinished)
+        XCTAssertEqual(run.results.map(\.id), hosts.map(\.id), "Rows keep the group's order")
+        XCTAssertEqual(run.succeededCount, 5)
+        XCTAssertEqual(run.pendingCount, 0)
+        XCTAssertEqual(run.results[0].stdout, "ops@web1.test.local: df -h /\n")
+        XCTAssertNotNil(run.results[0].duration)
+        for failed in run.results.suffix(2) {
+            guard case .failed = failed.status else {
+                return XCTFail("\(failed.label) should have failed, got \(failed.status)")
+            }
+        }
+        XCTAssertTrue(manager.sessions.isEmpty, "No terminal sessions are opened")
+        XCTAssertTrue(manager.engines.isEmpty)
+    }
+
+    func testNonZeroExitIsReportedWithStderr() async {
+        let manager = makeManager()
+        let host = makeHost("web1.test.local")
+
+        manager.parallelCommandCoordinator.run("exit 3", on: [host], resolveHost: { _ in nil })
+        await manager.parallelCommandCoordinator.waitUntilFinished()
+
+        let row = manager.parallelCommandRun?.results.first
+        XCTAssertEqual(row?.status, .exited(3))
+        XCTAssertEqual(row?.stderr, "ops@web1.test.local: exit 3\n")
+        XCTAssertEqual(manager.parallelCommandRun?.succeededCount, 0)
+    }
+
+    func testCancelMarksUnfinishedHostsStopped() async {
+        let manager = makeManager()
+        let hosts = (1...4).map { makeHost("web\($0).test.local") }
+
+        manager.parallelCommandCoordinator.run("uptime", on: hosts, resolveHost: { _ in nil }, maximumConcurrent: 2)
+        manager.parallelCommandCoordinator.cancel()
+
+        let run = manager.parallelCommandRun
+        XCTAssertEqual(run?.isFinished, true)
+        XCTAssertEqual(run?.results.map(\.status), Array(repeating: .cancelled, count: 4))
+    }
+}
+
+// MARK: - Test Doubles
+
+private actor ParallelCommandKnownHostsStore: KnownHostsStoreProtocol {
+    func allEntries() async throws -> [KnownHostEntry] { [] }
+
+    func evaluate(
+        hostname: String,
+        port: UInt16,
+        hostKeyType: String,
+        presentedFingerprint: String
+    ) async throws -> KnownHostVerificationResult {
+        .trusted
+    }
+
+    func trust(challenge: KnownHostVerificationChallenge) async throws {}
+
+    func clearAll() async throws {}
+}
+#endif
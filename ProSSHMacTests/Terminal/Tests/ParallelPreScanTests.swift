@@ -0,0 +1,92 @@
+// ParallelPreScanTests.swift
+// ProSSHV2
+//
+// Parallel text-run classification for large feed batches and grid parity
+// with the per-byte path.
+
+#if canImport(XCTest)
+import XCTest
+@testable import ProSSHMac
+
+final class ParallelPreScanTests: XCTestCase {
+
+    // MARK: - Cursor
+
+    func testCursorStopsAtNonTextBytesAndSegmentEnds() {
+        var cursor = PreScanCursor(segments: [
+            PreScanSegment(end: 10, nonTextOffsets: [3, 7]),
+            PreScanSegment(end: 20, nonTextOffsets: nil),
+            PreScanSegment(end: 30, nonTextOffsets: []),
+        ])
+
+        XCTAssertEqual(cursor.textRunEnd(from: 0), 3)
+        XCTAssertEqual(cursor.textRunEnd(from: 4), 7)
+        XCTAssertEqual(cursor.textRunEnd(from: 8), 10)
+        XCTAssertNil(cursor.textRunEnd(from: 12))
+        XCTAssertEqual(cursor.textRunEnd(from: 25), 30)
+    }
+
+    // MARK: - Scan
+
+    func testSmallBatchesAreNotScanned() {
+        XCTAssertNil(ParallelPreScan.scan(Data(repeating: 0x41, count: 1024)))
+    }
+
+    func testDenseSegmentIsLeftUnindexed() {
+        let bytes = [UInt8](repeating: 0x1B, count: 64)
+        let offsets = bytes.withUnsafeBytes { ParallelPreScan.nonTextOffsets($0, in: 0..<64) }
+        XCTAssertNil(offsets)
+    }
+
+    func testScanFindsNonTextBytesAcrossSegments() {
+        var bytes = [UInt8](repeating: 0x61, count: ParallelPreScan.minimumBatchSize * 2)
+        let marks = [5, 70_000, 200_000, bytes.count - 1]
+        for mark in marks { bytes[mark] = 0x09 }
+
+        guard var cursor = ParallelPreScan.scan(Data(bytes)) else {
+            XCTAssertEqual(ProcessInfo.processInfo.activeProcessorCount, 1)
+            return
+        }
+        var found: [Int] = []
+        var index = 0
+        while index < bytes.count, let end = cursor.textRunEnd(from: index) {
+            if end < bytes.count, bytes[end] == 0x09 { found.append(end) }
+            index = end + 1
+        }
+        XCTAssertEqual(found, marks)
+    }
+
+    // MARK: - Engine parity
+
+    func testLargeChunkMatchesSmallChunkParsing() async {
+        var text = ""
+        for line in 0..<8_000 {
+            // Mostly plain text, with the occasional escape, tab and UTF-8 run.
+            text += line % 25 == 0
+                ? "line \(line) \u{1B}[1;32mok\u{1B}[0m\ttab ünïcode\r\n"
+                : "line \(line) of plain output text\r\n"
+        }
+        let bytes = Array(text.utf8)
+        XCTAssertGreaterThan(bytes.count, ParallelPreScan.minimumBatchSize)
+
+        let whole = TerminalEngine(columns: 60, rows: 10)
+        await whole.feed(bytes)
+
+        let chunked = TerminalEngine(columns: 60, rows: 10)
+        var offset = 0
+        while offset < bytes.count {
+            let end = min(bytes.count, offset + 4096)
+            await chunked.feed(Array(bytes[offset..<end]))
+            offset = end
+        }
+
+        let wholeText = await whole.visibleText()
+        let chunkedText = await chunked.visibleText()
+        XCTAssertEqual(wholeText, chunkedText)
+        let wholeCursor = await whole.grid.cursorPosition()
+        let chunkedCursor = await chunked.grid.cursorPosition()
+        XCTAssertEqual(wholeCursor.row, chunkedCursor.row)
+        XCTAssertEqual(wholeCursor.col, chunkedCursor.col)
+    }
+}
+#endif
@@ -55,5 +55,59 @@ final class PasteHandlerTests: XCTestCase {
             PasteHandler.sequences(forClipboardText: "", bracketedPasteEnabled: true).isEmpty
         )
     }
+
+    // MARK: - PasteStream
+
+    private func drain(_ stream: inout PasteStream) -> [[UInt8]] {
+        var chunks: [[UInt8]] = []
+        while let chunk = stream.nextChunk() {
+            chunks.append(chunk)
+        }
+        return chunks
+    }
+
+    func testStreamMatchesEagerPayload() {
+        let text = String(repeating: "select *\r\nfrom t;\n", count: 500)
+        var stream = PasteStream(utf8: Data(text.utf8), bracketedPasteEnabled: true, chunkByteLimit: 64)
+
+        let streamed = drain(&stream).flatMap { $0 }
+
+        XCTAssertEqual(streamed, Array(PasteHandler.payload(for: text, bracketedPasteEnabled: true).utf8))
+        XCTAssertTrue(stream.isFinished)
+        XCTAssertEqual(stream.consumedBytes, stream.totalBytes)
+    }
+
+    func testStreamNormalizesCRLFSplitAcrossChunks() {
+        var stream = PasteStream(utf8: Data("abc\r\ndef".utf8), bracketedPasteEnabled: false, chunkByteLimit: 4)
+
+        let chunks = drain(&stream)
+
+        XCTAssertEqual(chunks.first, Array("abc\r".utf8))
+        XCTAssertEqual(chunks.flatMap { $0 }, Array("abc\rdef".utf8))
+    }
+
+    func testStreamChunksEndOnCharacterBoundaries() {
+        let text = String(repeating: "é漢🙂", count: 40)
+        var stream = PasteStream(utf8: Data(text.utf8), bracketedPasteEnabled: false, chunkByteLimit: 5)
+
+        let chunks = drain(&stream)
+
+        XCTAssertGreaterThan(chunks.count, 1)
+        for chunk in chunks {
+            XCTAssertNotNil(String(bytes: chunk, encoding: .utf8), "Chunk splits a character: \(chunk)")
+        }
+        XCTAssertEqual(String(decoding: chunks.flatMap { $0 }, as: UTF8.self), text)
+    }
+
+    func testCancelClosesAStartedBracketedPaste() {
+        var unstarted = PasteStream(utf8: Data("abcdef".utf8), bracketedPasteEnabled: true, chunkByteLimit: 4)
+        XCTAssertNil(unstarted.cancel())
+
+        var started = PasteStream(utf8: Data("abcdefgh".utf8), bracketedPasteEnabled: true, chunkByteLimit: 4)
+        XCTAssertEqual(started.nextChunk(), Array("\u{1B}[200~abcd".utf8))
+        XCTAssertEqual(started.cancel(), Array("\u{1B}[201~".utf8))
+        XCTAssertNil(started.nextChunk())
+        XCTAssertNil(started.cancel())
+    }
 }
 #endif
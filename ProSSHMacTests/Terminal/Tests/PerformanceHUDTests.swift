@@ -0,0 +1,116 @@
+// PerformanceHUDTests.swift
+// ProSSHV2
+//
+// Tests for the performance HUD's inputs: the session pipeline counters,
+// rates derived from two refreshes, and the text the overlay draws.
+
+#if canImport(XCTest)
+import XCTest
+@testable import ProSSHMac
+
+final class PerformanceHUDTests: XCTestCase {
+
+    // MARK: - Helpers
+
+    private func performance(gpuMs: Double? = nil) -> RendererPerformanceSnapshot {
+        RendererPerformanceSnapshot(
+            totalFrames: 10,
+            averageCPUFrameMs: 1.25,
+            p95CPUFrameMs: 2.5,
+            averageGPUFrameMs: gpuMs,
+            p95GPUFrameMs: gpuMs.map { $0 * 2 },
+            dropped120HzFrames: 0,
+            dropped60HzFrames: 0,
+            lastDrawCallCount: 3,
+            averageInputLatencyMs: nil,
+            p95InputLatencyMs: nil,
+            averageDrawableWaitMs: nil,
+            p95DrawableWaitMs: nil
+        )
+    }
+
+    private func stats(received: Int64, parsed: UInt64, parseSeconds: Double, snapshots: UInt64, deferrals: UInt64) -> PerformanceHUDSessionStats {
+        PerformanceHUDSessionStats(
+            receivedBytes: received,
+            pipeline: SessionPipelineCounters.Totals(
+                parsedBytes: parsed,
+                parseSeconds: parseSeconds,
+                snapshotsPublished: snapshots,
+                publishDeferrals: deferrals
+            ),
+            scrollbackBytes: nil
+        )
+    }
+
+    // MARK: - Tests
+
+    func testCountersAccumulate() {
+        let counters = SessionPipelineCounters()
+        counters.recordParse(byteCount: 4096, seconds: 0.001)
+        counters.recordParse(byteCount: 1024, seconds: 0.0005)
+        counters.recordSnapshotPublished()
+        counters.recordPublishDeferral()
+        counters.recordPublishDeferral()
+
+        let totals = counters.totals
+        XCTAssertEqual(totals.parsedBytes, 5120)
+        XCTAssertEqual(totals.parseSeconds, 0.0015, accuracy: 1e-6)
+        XCTAssertEqual(totals.snapshotsPublished, 1)
+        XCTAssertEqual(totals.publishDeferrals, 2)
+    }
+
+    func testRatesUseTheDifferenceBetweenRefreshes() {
+        let earlier = stats(received: 1_048_576, parsed: 1_048_576, parseSeconds: 0.1, snapshots: 10, deferrals: 2)
+        let later = stats(received: 3_145_728, parsed: 3_145_728, parseSeconds: 0.2, snapshots: 70, deferrals: 8)
+
+        let rates = PerformanceHUDRates(from: earlier, to: later, seconds: 0.5)
+
+        XCTAssertEqual(rates.inputMBps, 4, accuracy: 1e-9)
+        XCTAssertEqual(rates.parseMBps ?? 0, 20, accuracy: 1e-6)
+        XCTAssertEqual(rates.parserBusy, 0.2, accuracy: 1e-6)
+        XCTAssertEqual(rates.snapshotsPerSecond, 120, accuracy: 1e-9)
+        XCTAssertEqual(rates.deferralsPerSecond, 12, accuracy: 1e-9)
+    }
+
+    func testIdleParserHasNoParseRate() {
+        let idle = stats(received: 10, parsed: 10, parseSeconds: 0.1, snapshots: 1, deferrals: 0)
+        let rates = PerformanceHUDRates(from: idle, to: idle, seconds: 0.5)
+        XCTAssertNil(rates.parseMBps)
+        XCTAssertEqual(rates.inputMBps, 0)
+    }
+
+    func testLinesCoverEveryMetric() {
+        var session = stats(received: 0, parsed: 0, parseSeconds: 0, snapshots: 0, deferrals: 0)
+        session.scrollbackBytes = 3 * 1_048_576
+        let atlas = GlyphAtlas.Occupancy(pages: 2, capacity: 100, liveGlyphs: 25, freeSlots: 0)
+
+        let lines = PerformanceHUDOverlay.lines(stats: session, rates: nil, performance: performance(gpuMs: 0.5), atlas: atlas)
+
+        XCTAssertEqual(lines.count, 7)
+        XCTAssertTrue(lines[0].hasPrefix("in "))
+        XCTAssertTrue(lines[3].contains("p95  2.50 ms"))
+        XCTAssertTrue(lines[4].contains("p95  1.00 ms"))
+        XCTAssertTrue(lines[5].contains("25% of 2 pages"))
+        XCTAssertTrue(lines[6].contains("3.0 MB"))
+    }
+
+    func testLinesWithoutSessionStatsShowRendererOnly() {
+        let lines = PerformanceHUDOverlay.lines(stats: nil, rates: nil, performance: performance(), atlas: GlyphAtlas.Occupancy())
+
+        XCTAssertEqual(lines.count, 3)
+        XCTAssertEqual(lines[1], "gpu    -")
+    }
+
+    func testLinesShowPowerTierAndCap() {
+        let lines = PerformanceHUDOverlay.lines(
+            stats: nil,
+            rates: nil,
+            performance: performance(),
+            atlas: GlyphAtlas.Occupancy(),
+            power: RenderPowerPolicy(tier: .battery)
+        )
+
+        XCTAssertEqual(lines.last, "power  battery  cap 60 fps")
+    }
+}
+#endif
@@ -0,0 +1,438 @@
+// PerformanceRegressionTests.swift
+// ProSSHV2
+//
+// Release-build performance gates for the hot paths in docs/Optimization.md.
+// Each benchmark runs through XCTest `measure`, so Xcode reports its clock
+// and CPU metrics. The median of the measured iterations is also compared
+// with a baseline recorded for this machine class in
+// PerformanceBaselines.json, and the test fails when it is more than the
+// file's tolerance (10%) slower.
+//
+// Run with `./scripts/benchmark-regression.sh`, which builds Release and
+// runs the ProSSHMacBenchmarks scheme. Pass `--record` on a new machine
+// class, or after an intended change, to write its baselines. Debug builds
+// skip these tests; the main scheme does not run them.
+
+#if canImport(XCTest)
+import CoreText
+import Metal
+import XCTest
+@testable import ProSSHMac
+
+final class PerformanceRegressionTests: XCTestCase {
+
+    /// Measured iterations per benchmark. The first is a warm-up and is
+    /// left out of the median.
+    private static let iterationCount = 6
+
+    override func setUpWithError() throws {
+        try super.setUpWithError()
+        #if DEBUG
+        throw XCTSkip("Performance gates compare Release timings; run scripts/benchmark-regression.sh")
+        #endif
+    }
+
+    // MARK: - Helpers
+
+    /// Measure `prepare`'s returned work. `prepare` runs before each
+    /// iteration and is not timed.
+    private func benchmark(
+        _ name: String,
+        file: StaticString = #filePath,
+        line: UInt = #line,
+        prepare: () -> () -> Void
+    ) throws {
+        let options = XCTMeasureOptions()
+        options.iterationCount = Self.iterationCount
+        options.invocationOptions = [.manuallyStart, .manuallyStop]
+
+        var samples: [Double] = []
+        measure(metrics: [XCTClockMetric(), XCTCPUMetric()], options: options) {
+            let work = prepare()
+            let start = ContinuousClock.now
+            startMeasuring()
+            work()
+            stopMeasuring()
+            let elapsed = ContinuousClock.now - start
+            samples.append(Double(elapsed.components.seconds) + Double(elapsed.components.attoseconds) / 1e18)
+        }
+        try PerformanceBaselines.check(name, samples: Array(samples.dropFirst()), file: file, line: line)
+    }
+
+    /// Run `work` to completion from a synchronous measure block.
+    private func blocking(_ work: @escaping @Sendable () async -> Void) {
+        let done = DispatchSemaphore(value: 0)
+        Task.detached {
+            await work()
+            done.signal()
+        }
+        done.wait()
+    }
+
+    private func chunks(_ payload: Data, size: Int = 4096) -> [Data] {
+        stride(from: 0, to: payload.count, by: size).map {
+            payload.subdata(in: $0..<min($0 + size, payload.count))
+        }
+    }
+
+    /// Feed one corpus workload into a fresh engine per iteration.
+    private func benchmarkWorkload(_ workload: String, columns: Int = 80, rows: Int = 24, bytes: Int = 1 << 20, file: StaticString = #filePath, line: UInt = #line) throws {
+        let payload = try XCTUnwrap(BenchmarkCorpus.builtIn(workload, columns: columns, rows: rows, targetBytes: bytes)).payload
+        let parts = chunks(payload)
+        try benchmark("parser.\(workload)", file: file, line: line) {
+            let engine = TerminalEngine(columns: columns, rows: rows)
+            return { [self] in
+                blocking {
+                    for part in parts {
+                        _ = await engine.feed(part)
+                    }
+                }
+            }
+        }
+    }
+
+    /// A filled engine and the row rewrites that produce one-row damage.
+    private func filledEngine(columns: Int, rows: Int) -> (TerminalEngine, [Data]) {
+        let engine = TerminalEngine(columns: columns, rows: rows)
+        let fill = BenchmarkCorpus.builtIn("htop", columns: columns, rows: rows, targetBytes: 256 * 1024)?.payload ?? Data()
+        blocking { _ = await engine.feed(fill) }
+        let updates = (0..<120).map { frame in
+            let row = frame % rows + 1
+            let text = String(repeating: Character(UnicodeScalar(UInt8(65 + frame % 26))), count: columns / 2)
+            return Data("\u{1B}[\(row);1H\u{1B}[3\(frame % 8)m\(text)\u{1B}[0m".utf8)
+        }
+        return (engine, updates)
+    }
+
+    private func makeCells(_ text: String) -> [TerminalCell] {
+        text.unicodeScalars.map {
+            TerminalCell(codepoint: $0.value, fgPacked: 0, bgPacked: 0, ulPacked: 0, attributes: [], underlineStyle: .none, width: 1)
+        }
+    }
+
+    private func scrollback(lines: Int, columns: Int) -> ScrollbackBuffer {
+        var buffer = ScrollbackBuffer(maxLines: lines, spillFile: { nil })
+        for index in 0..<lines {
+            let text = "\(index) " + String(repeating: index % 7 == 0 ? "error " : "looks fine ", count: columns / 12)
+            buffer.push(cells: makeCells(String(text.prefix(columns))), isWrapped: index % 3 == 0)
+        }
+        return buffer
+    }
+
+    // MARK: - Parser and Grid
+
+    /// Grid bulk print and scroll, parser tables and the merged engine actor.
+    func testParserBase64Flood() throws {
+        try benchmarkWorkload("base64")
+    }
+
+    /// SGR and CSI dispatch under full-screen redraws.
+    func testParserHtopRedraws() throws {
+        try benchmarkWorkload("htop")
+    }
+
+    /// Truecolor SGR and the packed colour path.
+    func testParserTruecolor() throws {
+        try benchmarkWorkload("truecolor")
+    }
+
+    /// Wide characters and the cell data model's slow path.
+    func testParserCJKLog() throws {
+        try benchmarkWorkload("cjk-log")
+    }
+
+    /// DEC line drawing charset, tab stops and OSC title updates.
+    func testParserCharsetTabsAndOSC() throws {
+        var text = ""
+        for index in 0..<12_000 {
+            text += "\u{1B}]0;job \(index)\u{07}"
+            text += "\u{1B}(0lqqqqk\u{1B}(B\tname\t\(index)\tstate\tok\r\n"
+        }
+        let parts = chunks(Data(text.utf8))
+        try benchmark("parser.charsetTabsOSC") {
+            let engine = TerminalEngine(columns: 80, rows: 24)
+            return { [self] in
+                blocking {
+                    for part in parts {
+                        _ = await engine.feed(part)
+                    }
+                }
+            }
+        }
+    }
+
+    // MARK: - Snapshot
+
+    /// One-row updates followed by a snapshot. XCTest records one set of
+    /// metrics per test, so each grid size is its own test.
+    private func benchmarkSnapshots(columns: Int, rows: Int, file: StaticString = #filePath, line: UInt = #line) throws {
+        try benchmark("snapshot.rowUpdate.\(columns)x\(rows)", file: file, line: line) {
+            let (engine, updates) = filledEngine(columns: columns, rows: rows)
+            return { [self] in
+                blocking {
+                    for update in updates {
+                        _ = await engine.feed(update)
+                        _ = await engine.snapshot()
+                    }
+                }
+            }
+        }
+    }
+
+    func testSnapshotRowUpdates80x24() throws {
+        try benchmarkSnapshots(columns: 80, rows: 24)
+    }
+
+    func testSnapshotRowUpdates200x60() throws {
+        try benchmarkSnapshots(columns: 200, rows: 60)
+    }
+
+    func testSnapshotRowUpdates400x120() throws {
+        try benchmarkSnapshots(columns: 400, rows: 120)
+    }
+
+    // MARK: - Renderer
+
+    /// `CellBuffer.update` with one damaged row per frame at 200x60.
+    func testCellBufferPartialDamage() throws {
+        guard let device = MTLCreateSystemDefaultDevice() else {
+            throw XCTSkip("No Metal device available")
+        }
+        let (engine, updates) = filledEngine(columns: 200, rows: 60)
+        var snapshots: [GridSnapshot] = []
+        for update in updates {
+            nonisolated(unsafe) var snapshot: GridSnapshot?
+            blocking {
+                _ = await engine.feed(update)
+                snapshot = await engine.snapshot()
+            }
+            if let snapshot { snapshots.append(snapshot) }
+        }
+
+        try benchmark("cellBuffer.partialDamage.200x60") {
+            let buffer = CellBuffer(device: device, bufferCount: 3)
+            buffer.update(from: snapshots[0])
+            buffer.swapBuffers()
+            return {
+                for snapshot in snapshots.dropFirst() {
+                    buffer.update(from: snapshot)
+                    buffer.swapBuffers()
+                }
+            }
+        }
+    }
+
+    /// Selection projection over a full 200x60 snapshot.
+    func testSelectionProjection() throws {
+        let (engine, _) = filledEngine(columns: 200, rows: 60)
+        nonisolated(unsafe) var filled: GridSnapshot?
+        blocking { filled = await engine.snapshot() }
+        let snapshot = try XCTUnwrap(filled)
+
+        try benchmark("selection.apply.200x60") {
+            let renderer = SelectionRenderer()
+            return {
+                for row in 0..<120 {
+                    renderer.selection = TerminalSelection(
+                        start: SelectionPoint(row: row % 60, col: 3),
+                        end: SelectionPoint(row: min(row % 60 + 10, 59), col: 150),
+                        type: .character
+                    )
+                    _ = renderer.applySelection(to: snapshot)
+                }
+            }
+        }
+    }
+
+    /// Frame bookkeeping and percentile reads in the performance monitor.
+    func testPerformanceMonitorBookkeeping() throws {
+        try benchmark("renderer.performanceMonitor") {
+            let monitor = RendererPerformanceMonitor()
+            return {
+                for frame in 0..<20_000 {
+                    let id = monitor.beginFrame()
+                    monitor.endFrame(signpostID: id, cpuFrameSeconds: Double(frame % 17) / 1000, gpuFrameSeconds: nil, drawCalls: 3)
+                    if frame % 60 == 0 {
+                        _ = monitor.snapshot()
+                    }
+                }
+            }
+        }
+    }
+
+    // MARK: - Glyphs
+
+    /// A burst of distinct glyphs through a small cache: inserts, evictions
+    /// and lookups of the survivors.
+    func testGlyphCacheMissStorm() throws {
+        let entry = AtlasEntry(atlasPage: 0, x: 0, y: 0, width: 8, bearingX: 0, bearingY: 0)
+        try benchmark("glyphCache.missStorm") {
+            let cache = GlyphCache(maxCapacity: 1024)
+            return {
+                for codepoint: UInt32 in 0x4E00..<0x4E00 + 40_000 {
+                    let key = GlyphKey(codepoint: codepoint, bold: codepoint & 1 == 0, italic: false)
+                    if cache.lookup(key) == nil {
+                        cache.insert(key, entry: entry)
+                    }
+                    _ = cache.lookup(GlyphKey(codepoint: codepoint &- 512, bold: false, italic: false))
+                }
+            }
+        }
+    }
+
+    /// Rasterizing glyphs that miss every cache: CJK, box drawing and emoji.
+    func testGlyphRasterizerMisses() throws {
+        let font = CTFontCreateWithName("Menlo" as CFString, 28, nil)
+        let scalars = (0x4E00..<0x4F00).compactMap(UnicodeScalar.init)
+            + (0x2500..<0x2580).compactMap(UnicodeScalar.init)
+            + (0x1F600..<0x1F640).compactMap(UnicodeScalar.init)
+        try benchmark("glyphRasterizer.misses") {
+            let rasterizer = GlyphRasterizer()
+            return {
+                for scalar in scalars {
+                    _ = rasterizer.rasterize(codepoint: scalar, font: font, cellWidth: 16, cellHeight: 32)
+                }
+            }
+        }
+    }
+
+    // MARK: - Reflow
+
+    /// Full reflow of 10,000 scrollback lines from 120 to 80 columns.
+    func testReflowTenThousandLines() throws {
+        let history = scrollback(lines: 10_000, columns: 120)
+        let screen = (0..<24).map { makeCells(String(String(repeating: "screen \($0) ", count: 10).prefix(120))) }
+        try benchmark("reflow.10kLines") {
+            {
+                _ = GridReflow.reflow(
+                    screenRows: screen,
+                    scrollback: history,
+                    cursorRow: 23,
+                    cursorCol: 0,
+                    oldColumns: 120,
+                    newColumns: 80,
+                    newRows: 24
+                )
+            }
+        }
+    }
+
+    // MARK: - Scrollback
+
+    /// Pushing 100,000 lines, including trailing-blank trimming and paging.
+    func testScrollbackPush() throws {
+        let line = makeCells("drwxr-xr-x  12 user  staff   384 Oct 14 09:00 Library" + String(repeating: " ", count: 40))
+        try benchmark("scrollback.push100k") {
+            {
+                var buffer = ScrollbackBuffer(maxLines: 100_000, spillFile: { nil })
+                for _ in 0..<100_000 {
+                    buffer.push(cells: line)
+                }
+            }
+        }
+    }
+
+    /// Full-history search over 100,000 lines with a fresh engine, so
+    /// nothing is served incrementally.
+    private func benchmarkSearch(_ name: String, _ query: ScrollbackSearchQuery, file: StaticString = #filePath, line: UInt = #line) throws {
+        let history = scrollback(lines: 100_000, columns: 120)
+        try benchmark("scrollback.search.\(name)", file: file, line: line) {
+            let engine = ScrollbackSearchEngine()
+            return { [self] in
+                blocking {
+                    try? await engine.search(history, query: query) { _ in }
+                }
+            }
+        }
+    }
+
+    func testScrollbackSearchLiteral() throws {
+        try benchmarkSearch("literal", ScrollbackSearchQuery(text: "error", isRegex: false, isCaseSensitive: false))
+    }
+
+    func testScrollbackSearchRegex() throws {
+        try benchmarkSearch("regex", ScrollbackSearchQuery(text: "^[0-9]+7 ", isRegex: true, isCaseSensitive: false))
+    }
+}
+
+// MARK: - Baselines
+
+/// Median timings per machine class, stored next to this file.
+nonisolated private struct PerformanceBaselines: Codable {
+    /// Allowed slowdown over the baseline before a benchmark fails.
+    var tolerance = 0.10
+    /// Machine class -> benchmark name -> median seconds.
+    var machines: [String: [String: Double]] = [:]
+
+    static let fileURL = URL(fileURLWithPath: #filePath)
+        .deletingLastPathComponent()
+        .appendingPathComponent("PerformanceBaselines.json")
+
+    /// Set by `benchmark-regression.sh --record`.
+    static var isRecording: Bool {
+        ProcessInfo.processInfo.environment["PROSSH_RECORD_BASELINES"] == "1"
+    }
+
+    /// CPU model and performance-core count, e.g. "Apple M2 Pro 8P".
+    static let machineClass: String = {
+        func sysctlString(_ name: String) -> String? {
+            var size = 0
+            guard sysctlbyname(name, nil, &size, nil, 0) == 0, size > 0 else { return nil }
+            var buffer = [CChar](repeating: 0, count: size)
+            guard sysctlbyname(name, &buffer, &size, nil, 0) == 0 else { return nil }
+            return String(cString: buffer)
+        }
+        func sysctlInt(_ name: String) -> Int? {
+            var value: Int32 = 0
+            var size = MemoryLayout<Int32>.size
+            guard sysctlbyname(name, &value, &size, nil, 0) == 0 else { return nil }
+            return Int(value)
+        }
+        let brand = sysctlString("machdep.cpu.brand_string") ?? "Unknown CPU"
+        let cores = sysctlInt("hw.perflevel0.physicalcpu") ?? ProcessInfo.processInfo.activeProcessorCount
+        return "\(brand) \(cores)P"
+    }()
+
+    static func load() -> PerformanceBaselines {
+        guard let data = try? Data(contentsOf: fileURL),
+              let baselines = try? JSONDecoder().decode(PerformanceBaselines.self, from: data) else {
+            return PerformanceBaselines()
+        }
+        return baselines
+    }
+
+    func save() throws {
+        let encoder = JSONEncoder()
+        encoder.outputFormatting = [.prettyPrinted, .sortedKeys]
+        try encoder.encode(self).write(to: Self.fileURL, options: .atomic)
+    }
+
+    /// Record or compare the median of `samples` for `name`.
+    static func check(_ name: String, samples: [Double], file: StaticString, line: UInt) throws {
+        let sorted = samples.sorted()
+        guard !sorted.isEmpty else { return }
+        let median = sorted[sorted.count / 2]
+        var baselines = load()
+
+        if isRecording {
+            baselines.machines[machineClass, default: [:]][name] = median
+            try baselines.save()
+            print("recorded \(name) [\(machineClass)]: \(String(format: "%.4f", median)) s")
+            return
+        }
+
+        guard let baseline = baselines.machines[machineClass]?[name] else {
+            throw XCTSkip("No \(name) baseline for \"\(machineClass)\"; record one with scripts/benchmark-regression.sh --record")
+        }
+        let limit = baseline * (1 + baselines.tolerance)
+        XCTAssertLessThanOrEqual(
+            median,
+            limit,
+            String(format: "%@ regressed %.1f%%: median %.4f s against baseline %.4f s on %@",
+                   name, (median / baseline - 1) * 100, median, baseline, machineClass),
+            file: file,
+            line: line
+        )
+    }
+}
+#endif
@@ -15,8 +15,11 @@ final class PersistentStoreTests: XCTestCase {
             .urls(for: .applicationSupportDirectory, in: .userDomainMask)
             .first?
             .appendingPathComponent("ProSSHV2", isDirectory: true)
+        let files = base.flatMap { try? FileManager.default.contentsOfDirectory(at: $0, includingPropertiesForKeys: nil) } ?? []
         for name in testFilenames {
-            if let url = base?.appendingPathComponent(name) {
+            // The legacy JSON file and the record store's index and records.
+            let stem = (name as NSString).deletingPathExtension + "."
+            for url in files where url.lastPathComponent == name || url.lastPathComponent.hasPrefix(stem) {
                 try? FileManager.default.removeItem(at: url)
             }
         }
@@ -121,6 +124,50 @@ final class PersistentStoreTests: XCTestCase {
         XCTAssertEqual(loaded, [])
     }
 
+    func testLoadByIDReadsSingleItem() async throws {
+        let store = makeHostStore()
+        let hostA = makeTestHost(label: "Host A")
+        let hostB = makeTestHost(label: "Host B")
+        try await store.save([hostA, hostB])
+        let loaded = try await store.load(id: hostB.id)
+        XCTAssertEqual(loaded?.label, "Host B")
+        let missing = try await store.load(id: UUID())
+        XCTAssertNil(missing)
+    }
+
+    func testSaveKeepsOrderAndReopens() async throws {
+        let name = "test-hosts-\(UUID().uuidString).json"
+        testFilenames.append(name)
+        var hosts = (0..<20).map { makeTestHost(label: "Host \($0)") }
+        try await PersistentStore<ProSSHMac.Host>(filename: name).save(hosts)
+        hosts[7].lastConnected = Date(timeIntervalSince1970: 1_700_000_000)
+        hosts.swapAt(0, 19)
+        hosts.remove(at: 3)
+        try await PersistentStore<ProSSHMac.Host>(filename: name).save(hosts)
+
+        let loaded = try await PersistentStore<ProSSHMac.Host>(filename: name).load()
+        XCTAssertEqual(loaded, hosts)
+    }
+
+    func testImportsLegacyJSONArray() async throws {
+        let name = "test-hosts-\(UUID().uuidString).json"
+        testFilenames.append(name)
+        let legacyURL = try XCTUnwrap(FileManager.default
+            .urls(for: .applicationSupportDirectory, in: .userDomainMask).first)
+            .appendingPathComponent("ProSSHV2", isDirectory: true)
+            .appendingPathComponent(name)
+        let encoder = JSONEncoder()
+        encoder.dateEncodingStrategy = .iso8601
+        let host = makeTestHost(label: "Legacy")
+        try EncryptedStorage.saveJSON([host], to: legacyURL, fileManager: .default, encoder: encoder)
+
+        let loaded = try await PersistentStore<ProSSHMac.Host>(filename: name).load()
+        XCTAssertEqual(loaded, [host])
+        XCTAssertFalse(FileManager.default.fileExists(atPath: legacyURL.path(percentEncoded: false)))
+        let reloaded = try await PersistentStore<ProSSHMac.Host>(filename: name).load()
+        XCTAssertEqual(reloaded, [host])
+    }
+
     // MARK: - StoredSSHKey tests (validates generic T, protocol conformance)
 
     func testKeyStoreRoundTrip() async throws {
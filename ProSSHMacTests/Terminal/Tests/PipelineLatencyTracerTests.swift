@@ -0,0 +1,114 @@
+// PipelineLatencyTracerTests.swift
+// ProSSHV2
+//
+// Tests for read-to-GPU latency sampling: histogram percentiles, the
+// one-in-flight sampling rule, the ring's arrival stamp and trace merging
+// in GridSnapshotFeed.
+
+#if canImport(XCTest)
+import XCTest
+@testable import ProSSHMac
+
+final class PipelineLatencyTracerTests: XCTestCase {
+
+    // MARK: - Helpers
+
+    private func snapshot() -> GridSnapshot {
+        GridSnapshot(
+            cells: [],
+            dirtyRange: nil,
+            cursorRow: 0,
+            cursorCol: 0,
+            cursorVisible: true,
+            cursorStyle: .block,
+            columns: 0,
+            rows: 0,
+            usingAlternateBuffer: false,
+            graphemeOverrides: nil
+        )
+    }
+
+    // MARK: - Tests
+
+    func testHistogramPercentilesFallInTheRightBuckets() {
+        var histogram = LatencyHistogram()
+        for _ in 0..<90 { histogram.record(seconds: 0.002) }
+        for _ in 0..<10 { histogram.record(seconds: 0.050) }
+
+        XCTAssertEqual(histogram.sampleCount, 100)
+        XCTAssertEqual(histogram.percentile(0.50) ?? 0, 0.002, accuracy: 0.002 * 0.2)
+        XCTAssertEqual(histogram.percentile(0.99) ?? 0, 0.050, accuracy: 0.050 * 0.2)
+        XCTAssertNil(LatencyHistogram().percentile(0.5))
+    }
+
+    func testOnlyOneTraceIsInFlight() {
+        let tracer = PipelineLatencyTracer(sessionID: UUID())
+        let first = tracer.begin(readAt: 1.0, now: 1.0)
+        XCTAssertNotNil(first)
+        XCTAssertNil(tracer.begin(readAt: 1.2, now: 1.2))
+
+        first?.complete(at: 1.01)
+        XCTAssertNotNil(tracer.begin(readAt: 1.3, now: 1.3))
+    }
+
+    func testSamplesAreSpacedBySampleInterval() {
+        let tracer = PipelineLatencyTracer(sessionID: UUID())
+        tracer.begin(readAt: 1.0, now: 1.0)?.complete(at: 1.001)
+        XCTAssertNil(tracer.begin(readAt: 1.0 + PipelineLatencyTracer.sampleInterval / 2, now: 1.03))
+    }
+
+    func testStaleTraceIsAbandoned() {
+        let tracer = PipelineLatencyTracer(sessionID: UUID())
+        _ = tracer.begin(readAt: 1.0, now: 1.0)
+        let later = 1.0 + PipelineLatencyTracer.abandonInterval + 0.1
+        XCTAssertNotNil(tracer.begin(readAt: later, now: later))
+        XCTAssertEqual(tracer.report().abandonedSamples, 1)
+    }
+
+    func testCompletionRecordsEveryStageOnce() throws {
+        let tracer = PipelineLatencyTracer(sessionID: UUID())
+        var trace = try XCTUnwrap(tracer.begin(readAt: 10.000, now: 10.000))
+        trace.parsedAt = 10.001
+        trace.publishedAt = 10.003
+        trace.uploadedAt = 10.008
+        trace.complete(at: 10.010)
+        trace.complete(at: 10.020)
+
+        let report = tracer.report()
+        XCTAssertEqual(report.completedSamples, 1)
+        for stage in PipelineLatencyStage.allCases {
+            XCTAssertEqual(report.histograms[stage]?.sampleCount, 1, stage.label)
+        }
+        let total = try XCTUnwrap(report.percentiles(for: .total))
+        XCTAssertEqual(total.p50, 10, accuracy: 2)
+    }
+
+    func testRingStampsOnlyWhenSampling() async {
+        let ring = ShellOutputRing(capacity: 4096)
+        await ring.append(Array("abc".utf8))
+        XCTAssertNil(ring.takeSampledArrival(consuming: ring.readableCount))
+
+        ring.enableArrivalSampling()
+        await ring.append(Array("def".utf8))
+        XCTAssertNil(ring.takeSampledArrival(consuming: 3), "stamped bytes end past the span")
+        XCTAssertNotNil(ring.takeSampledArrival(consuming: 6))
+        XCTAssertNil(ring.takeSampledArrival(consuming: 6), "stamp is cleared once taken")
+    }
+
+    func testFeedKeepsOldestTraceAcrossSkippedSnapshots() throws {
+        let tracer = PipelineLatencyTracer(sessionID: UUID())
+        let older = try XCTUnwrap(tracer.begin(readAt: 1.0, now: 1.0))
+        let newer = PipelineTrace(tracer: tracer, sequence: 99, readAt: 2.0)
+        let feed = GridSnapshotFeed()
+
+        feed.write(snapshot(), trace: older)
+        feed.write(snapshot(), trace: newer)
+        XCTAssertNotNil(feed.takeLatest())
+        XCTAssertEqual(feed.takenTrace?.sequence, older.sequence)
+
+        feed.write(snapshot())
+        XCTAssertNotNil(feed.takeLatest())
+        XCTAssertNil(feed.takenTrace)
+    }
+}
+#endif
@@ -0,0 +1,68 @@
+#if canImport(XCTest)
+import XCTest
+@testable import ProSSHMac
+
+final class PortForwardStatsAccumulatorTests: XCTestCase {
+
+    private func connection(out: Int64, in received: Int64) -> ForwardConnectionStats {
+        ForwardConnectionStats(id: UUID(), bytesToRemote: out, bytesToLocal: received)
+    }
+
+    // MARK: - Totals
+
+    func testTotalsIncludeRetiredAndLiveConnections() {
+        var accumulator = PortForwardStatsAccumulator()
+        accumulator.retire(connection(out: 100, in: 1_000))
+
+        let stats = accumulator.sample(live: [connection(out: 50, in: 500)], at: .now)
+
+        XCTAssertEqual(stats.bytesToRemote, 150)
+        XCTAssertEqual(stats.bytesToLocal, 1_500)
+        XCTAssertEqual(stats.connectionsServed, 2)
+        XCTAssertEqual(stats.connections.count, 1)
+    }
+
+    func testOpenLatencyAverageAndLast() {
+        var accumulator = PortForwardStatsAccumulator()
+        accumulator.recordOpen(latency: .milliseconds(10))
+        accumulator.recordOpen(latency: .milliseconds(30))
+
+        let stats = accumulator.sample(live: [], at: .now)
+
+        XCTAssertEqual(stats.averageOpenLatency, .milliseconds(20))
+        XCTAssertEqual(stats.lastOpenLatency, .milliseconds(30))
+    }
+
+    // MARK: - Rates
+
+    func testRateIsDeltaOverSampleInterval() {
+        var accumulator = PortForwardStatsAccumulator()
+        let start = ContinuousClock.now
+        let live = connection(out: 0, in: 0)
+
+        let first = accumulator.sample(live: [live], at: start)
+        XCTAssertEqual(first.rateToLocal, 0)
+
+        var grown = live
+        grown.bytesToLocal = 2_000
+        grown.bytesToRemote = 500
+        let second = accumulator.sample(live: [grown], at: start + .seconds(2))
+
+        XCTAssertEqual(second.rateToLocal, 1_000, accuracy: 0.001)
+        XCTAssertEqual(second.rateToRemote, 250, accuracy: 0.001)
+    }
+
+    func testRetiringConnectionDoesNotProduceNegativeRate() {
+        var accumulator = PortForwardStatsAccumulator()
+        let start = ContinuousClock.now
+        let live = connection(out: 400, in: 400)
+
+        _ = accumulator.sample(live: [live], at: start)
+        accumulator.retire(live)
+        let stats = accumulator.sample(live: [], at: start + .seconds(1))
+
+        XCTAssertEqual(stats.rateToLocal, 0)
+        XCTAssertEqual(stats.bytesToLocal, 400)
+    }
+}
+#endif
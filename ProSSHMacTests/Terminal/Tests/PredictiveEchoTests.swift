@@ -0,0 +1,135 @@
+// PredictiveEchoTests.swift
+// ProSSHV2
+//
+// Predictive local echo: tentative cells drawn over the snapshot, confirmed
+// or dropped as the server's echo arrives, and shown only on slow links
+// that have proven they echo.
+
+#if canImport(XCTest)
+import XCTest
+@testable import ProSSHMac
+
+final class PredictiveEchoTests: XCTestCase {
+
+    // MARK: - Helpers
+
+    private func makeGrid(prompt: String = "$ ") -> TerminalGrid {
+        let grid = TerminalGrid(columns: 40, rows: 5)
+        echo(prompt, into: grid)
+        return grid
+    }
+
+    private func echo(_ text: String, into grid: TerminalGrid) {
+        let data = Data(text.utf8)
+        grid.processGroundTextBytes(data, range: 0..<data.count)
+    }
+
+    /// Types one confirmed key with a 200 ms echo, so the link counts as slow.
+    private func establishSlowEcho(on grid: TerminalGrid, at start: CFTimeInterval = 100) {
+        XCTAssertFalse(grid.predictEcho(of: Array("l".utf8), at: start), "Nothing is drawn before the link is measured")
+        echo("l", into: grid)
+        grid.settleEchoPredictions(at: start + 0.2)
+    }
+
+    private func cell(_ snapshot: GridSnapshot, row: Int, col: Int) -> CellInstance {
+        snapshot.cells[row * snapshot.columns + col]
+    }
+
+    // MARK: - Tests
+
+    func testPredictionsAreDrawnAfterSlowEchoIsConfirmed() {
+        let grid = makeGrid()
+        establishSlowEcho(on: grid)
+        XCTAssertEqual(grid.predictiveEcho.echoLatency ?? 0, 0.2, accuracy: 0.001)
+
+        XCTAssertTrue(grid.predictEcho(of: Array("s".utf8), at: 101))
+        let snapshot = grid.snapshot()
+
+        let predicted = cell(snapshot, row: 0, col: 3)
+        XCTAssertEqual(predicted.glyphIndex, UInt32(UInt8(ascii: "s")))
+        XCTAssertEqual(predicted.underlineStyle, UnderlineStyle.dotted.rawValue)
+        XCTAssertEqual(snapshot.cursorCol, 4, "The cursor is drawn past the prediction")
+        XCTAssertEqual(grid.cellAt(row: 0, col: 3)?.codepoint, 0, "The grid itself is untouched")
+    }
+
+    func testConfirmedEchoRetiresThePrediction() {
+        let grid = makeGrid()
+        establishSlowEcho(on: grid)
+        _ = grid.predictEcho(of: Array("s".utf8), at: 101)
+
+        echo("s", into: grid)
+        XCTAssertTrue(grid.settleEchoPredictions(at: 101.2))
+
+        XCTAssertTrue(grid.predictiveEcho.predictions.isEmpty)
+        let snapshot = grid.snapshot()
+        XCTAssertEqual(cell(snapshot, row: 0, col: 3).underlineStyle, UnderlineStyle.none.rawValue)
+        XCTAssertEqual(snapshot.cursorCol, 4)
+    }
+
+    func testMispredictionDropsGuessesUntilNextConfirmation() {
+        let grid = makeGrid()
+        establishSlowEcho(on: grid)
+        _ = grid.predictEcho(of: Array("ab".utf8), at: 101)
+
+        echo("x", into: grid)
+        XCTAssertTrue(grid.settleEchoPredictions(at: 101.2))
+        XCTAssertTrue(grid.predictiveEcho.predictions.isEmpty)
+        XCTAssertFalse(grid.predictiveEcho.isTrusted)
+
+        XCTAssertFalse(grid.predictEcho(of: Array("c".utf8), at: 102), "Held back after a misprediction")
+        echo("c", into: grid)
+        grid.settleEchoPredictions(at: 102.2)
+        XCTAssertTrue(grid.predictiveEcho.isTrusted)
+        XCTAssertTrue(grid.predictEcho(of: Array("d".utf8), at: 103))
+    }
+
+    func testUnechoedPredictionExpires() {
+        let grid = makeGrid()
+        establishSlowEcho(on: grid)
+        XCTAssertTrue(grid.predictEcho(of: Array("s".utf8), at: 101))
+
+        XCTAssertTrue(grid.predictEcho(of: Array("e".utf8), at: 101 + PredictiveEchoState.confirmationTimeout + 0.1))
+        XCTAssertFalse(grid.predictiveEcho.isTrusted)
+        XCTAssertTrue(grid.predictiveEcho.displayed.isEmpty)
+    }
+
+    func testFastLinkNeverDrawsPredictions() {
+        let grid = makeGrid()
+        _ = grid.predictEcho(of: Array("l".utf8), at: 100)
+        echo("l", into: grid)
+        grid.settleEchoPredictions(at: 100.002)
+
+        XCTAssertFalse(grid.predictEcho(of: Array("s".utf8), at: 101))
+        XCTAssertEqual(grid.predictiveEcho.predictions.count, 1, "Still tracked, to keep measuring")
+    }
+
+    func testNoPredictionOverExistingTextPasswordPromptOrAlternateBuffer() {
+        let editing = makeGrid(prompt: "$ echo")
+        establishSlowEcho(on: editing)
+        editing.moveCursorTo(row: 0, col: 2)
+        XCTAssertFalse(editing.predictEcho(of: Array("x".utf8), at: 101))
+        XCTAssertTrue(editing.predictiveEcho.predictions.isEmpty)
+
+        let password = makeGrid()
+        establishSlowEcho(on: password)
+        password.moveCursorTo(row: 1, col: 0)
+        echo("Password: ", into: password)
+        XCTAssertFalse(password.predictEcho(of: Array("h".utf8), at: 101))
+        XCTAssertTrue(password.predictiveEcho.predictions.isEmpty)
+
+        let fullScreen = makeGrid()
+        establishSlowEcho(on: fullScreen)
+        fullScreen.enableAlternateBuffer()
+        XCTAssertFalse(fullScreen.predictEcho(of: Array("j".utf8), at: 101))
+    }
+
+    func testBackspaceRetractsNewestPrediction() {
+        let grid = makeGrid()
+        establishSlowEcho(on: grid)
+        _ = grid.predictEcho(of: Array("ab".utf8), at: 101)
+
+        XCTAssertTrue(grid.predictEcho(of: [0x7F], at: 101.05))
+        XCTAssertEqual(grid.predictiveEcho.predictions.map(\.codepoint), [UInt32(UInt8(ascii: "a"))])
+    }
+}
+#endif
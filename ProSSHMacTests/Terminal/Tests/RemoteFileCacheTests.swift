@@ -0,0 +1,46 @@
+#if canImport(XCTest)
+import XCTest
+@testable import ProSSHMac
+
+final class RemoteFileCacheTests: XCTestCase {
+
+    private let sessionID = UUID()
+
+    // MARK: - Entries
+
+    func testStoreAndInvalidate() {
+        var cache = RemoteFileCache()
+        cache.store(sessionID: sessionID, path: "/etc/hosts", fingerprint: "10:1:2", content: "127.0.0.1\n")
+
+        XCTAssertEqual(cache.entry(sessionID: sessionID, path: "/etc/hosts")?.fingerprint, "10:1:2")
+        XCTAssertNil(cache.entry(sessionID: UUID(), path: "/etc/hosts"))
+
+        cache.invalidate(sessionID: sessionID, path: "/etc/hosts")
+        XCTAssertNil(cache.entry(sessionID: sessionID, path: "/etc/hosts"))
+    }
+
+    func testEmptyFingerprintAndOversizedFilesAreNotCached() {
+        var cache = RemoteFileCache(maxTotalBytes: 100, maxFileBytes: 8)
+        cache.store(sessionID: sessionID, path: "/a", fingerprint: "", content: "a")
+        cache.store(sessionID: sessionID, path: "/b", fingerprint: "1:1:1", content: "too large")
+
+        XCTAssertNil(cache.entry(sessionID: sessionID, path: "/a"))
+        XCTAssertNil(cache.entry(sessionID: sessionID, path: "/b"))
+    }
+
+    // MARK: - Eviction
+
+    func testLeastRecentlyUsedEntryIsEvictedFirst() {
+        var cache = RemoteFileCache(maxTotalBytes: 10, maxFileBytes: 10)
+        cache.store(sessionID: sessionID, path: "/a", fingerprint: "a", content: "aaaa")
+        cache.store(sessionID: sessionID, path: "/b", fingerprint: "b", content: "bbbb")
+        _ = cache.entry(sessionID: sessionID, path: "/a")
+
+        cache.store(sessionID: sessionID, path: "/c", fingerprint: "c", content: "cccc")
+
+        XCTAssertNotNil(cache.entry(sessionID: sessionID, path: "/a"))
+        XCTAssertNil(cache.entry(sessionID: sessionID, path: "/b"))
+        XCTAssertNotNil(cache.entry(sessionID: sessionID, path: "/c"))
+    }
+}
+#endif
@@ -0,0 +1,74 @@
+// RemoteHostMetricsTests.swift
+// ProSSHV2
+//
+// Host metrics sampler output: JSON lines split across reads, lines that
+// are not samples, the derived fractions and panel summary, and the exec
+// command the sampler runs under.
+
+#if canImport(XCTest)
+import XCTest
+@testable import ProSSHMac
+
+final class RemoteHostMetricsTests: XCTestCase {
+
+    private let line = #"{"t":1760400000,"os":"Linux 6.8.0","cpus":4,"load":[0.5,0.25,0.1],"mem_total":8589934592,"mem_available":2147483648,"disk_total":100000,"disk_used":40000,"uptime":93784.5}"#
+
+    // MARK: - Decoding
+
+    func testSampleSplitAcrossReads() {
+        var decoder = RemoteMetricsLineDecoder()
+        let bytes = Data((line + "\n").utf8)
+        XCTAssertEqual(decoder.decode(bytes.prefix(40)), [])
+        let samples = decoder.decode(bytes.dropFirst(40))
+        XCTAssertEqual(samples.count, 1)
+        XCTAssertEqual(samples.first?.operatingSystem, "Linux 6.8.0")
+        XCTAssertEqual(samples.first?.processorCount, 4)
+        XCTAssertEqual(samples.first?.load, [0.5, 0.25, 0.1])
+    }
+
+    func testLinesThatAreNotSamplesAreSkipped() {
+        var decoder = RemoteMetricsLineDecoder()
+        let samples = decoder.decode(Data("Welcome to host\n\(line)\nsh: vm_stat: not found\n\(line)\n".utf8))
+        XCTAssertEqual(samples.count, 2)
+    }
+
+    func testOverlongPartialLineIsDropped() {
+        var decoder = RemoteMetricsLineDecoder()
+        _ = decoder.decode(Data(repeating: 0x41, count: RemoteMetricsLineDecoder.maximumLineLength + 1))
+        XCTAssertEqual(decoder.decode(Data("\n\(line)\n".utf8)).count, 1)
+    }
+
+    // MARK: - Derived Values
+
+    func testFractionsAndSummary() throws {
+        var decoder = RemoteMetricsLineDecoder()
+        let sample = try XCTUnwrap(decoder.decode(Data((line + "\n").utf8)).first)
+        XCTAssertEqual(try XCTUnwrap(sample.memoryUsedFraction), 0.75, accuracy: 0.0001)
+        XCTAssertEqual(try XCTUnwrap(sample.diskUsedFraction), 0.4, accuracy: 0.0001)
+        XCTAssertTrue(sample.summary.hasPrefix("Load 0.50 0.25 0.10  |  Mem 75% of "))
+        XCTAssertTrue(sample.summary.hasSuffix("  |  Disk / 40%"))
+    }
+
+    func testUnreadableFieldsLeaveFractionsOut() {
+        let sample = RemoteHostMetrics(
+            timestamp: 0, operatingSystem: "", processorCount: 0, load: [],
+            memoryTotalBytes: 0, memoryAvailableBytes: 0, diskTotalBytes: 0, diskUsedBytes: 0, uptimeSeconds: 0
+        )
+        XCTAssertNil(sample.memoryUsedFraction)
+        XCTAssertNil(sample.diskUsedFraction)
+        XCTAssertEqual(sample.summary, "")
+    }
+
+    // MARK: - Command
+
+    func testCommandRunsScriptUnderShWithInterval() {
+        let command = RemoteMetricsSampler.command(interval: 7)
+        XCTAssertTrue(command.hasPrefix("sh -c '"))
+        XCTAssertTrue(command.hasSuffix("'"))
+        XCTAssertTrue(command.contains("sleep 7"))
+        // Single quotes in the script are closed, escaped and reopened.
+        XCTAssertTrue(command.contains(#"'"'"'"#))
+        XCTAssertTrue(RemoteMetricsSampler.script(interval: 0).contains("sleep 1"))
+    }
+}
+#endif
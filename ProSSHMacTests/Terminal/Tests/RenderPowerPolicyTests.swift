@@ -0,0 +1,63 @@
+// RenderPowerPolicyTests.swift
+// ProSSHV2
+//
+// Tests for RenderPowerPolicy: which tier each power and thermal condition
+// resolves to, and the limits each tier applies.
+
+#if canImport(XCTest)
+import XCTest
+@testable import ProSSHMac
+
+final class RenderPowerPolicyTests: XCTestCase {
+
+    // MARK: - Resolution
+
+    func testAdapterWithoutPressureIsFull() {
+        let policy = RenderPowerPolicy.resolve(isLowPowerModeEnabled: false, isOnBattery: false, thermalState: .nominal)
+        XCTAssertEqual(policy.tier, .full)
+        XCTAssertEqual(policy.maxFPS, 0)
+        XCTAssertTrue(policy.animatesEffects)
+        XCTAssertEqual(policy.bloomDownsample, 2)
+    }
+
+    func testBatteryCapsAndStopsAnimation() {
+        let policy = RenderPowerPolicy.resolve(isLowPowerModeEnabled: false, isOnBattery: true, thermalState: .fair)
+        XCTAssertEqual(policy.tier, .battery)
+        XCTAssertEqual(policy.maxFPS, 60)
+        XCTAssertFalse(policy.animatesEffects)
+        XCTAssertEqual(policy.bloomDownsample, 4)
+        XCTAssertTrue(policy.blinksCursor)
+    }
+
+    func testLowPowerModeIsSaverEvenOnAdapter() {
+        let policy = RenderPowerPolicy.resolve(isLowPowerModeEnabled: true, isOnBattery: false, thermalState: .nominal)
+        XCTAssertEqual(policy.tier, .saver)
+        XCTAssertEqual(policy.maxFPS, 30)
+    }
+
+    func testThermalStateOverridesPowerSource() {
+        XCTAssertEqual(
+            RenderPowerPolicy.resolve(isLowPowerModeEnabled: false, isOnBattery: false, thermalState: .serious).tier,
+            .saver
+        )
+        let critical = RenderPowerPolicy.resolve(isLowPowerModeEnabled: true, isOnBattery: true, thermalState: .critical)
+        XCTAssertEqual(critical.tier, .minimal)
+        XCTAssertEqual(critical.bloomDownsample, 8)
+        XCTAssertFalse(critical.blinksCursor)
+    }
+
+    // MARK: - Frame Cap
+
+    func testFullTierLeavesRequestedRateAlone() {
+        XCTAssertEqual(RenderPowerPolicy.full.cappedFPS(0), 0)
+        XCTAssertEqual(RenderPowerPolicy.full.cappedFPS(20), 20)
+    }
+
+    func testCapReplacesNativeRateAndLowersFasterRates() {
+        let saver = RenderPowerPolicy(tier: .saver)
+        XCTAssertEqual(saver.cappedFPS(0), 30)
+        XCTAssertEqual(saver.cappedFPS(60), 30)
+        XCTAssertEqual(saver.cappedFPS(15), 15)
+    }
+}
+#endif
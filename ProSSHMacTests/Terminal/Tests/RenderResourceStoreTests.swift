@@ -0,0 +1,59 @@
+// RenderResourceStoreTests.swift
+// ProSSHV2
+//
+// Shared pane resources: one command queue per device, effect targets
+// shared by panes of equal size and released with the last holder.
+
+#if canImport(XCTest)
+import XCTest
+import Metal
+@testable import ProSSHMac
+
+final class RenderResourceStoreTests: XCTestCase {
+
+    private func makeDevice() throws -> MTLDevice {
+        guard let device = MTLCreateSystemDefaultDevice() else {
+            throw XCTSkip("No Metal device available")
+        }
+        return device
+    }
+
+    // MARK: - Queue
+
+    func testCommandQueueIsSharedPerDevice() throws {
+        let device = try makeDevice()
+        let store = RenderResourceStore()
+        let first = try XCTUnwrap(store.commandQueue(for: device))
+        XCTAssertTrue(first === store.commandQueue(for: device))
+    }
+
+    // MARK: - Effect Targets
+
+    func testEqualSizedPanesShareTargets() throws {
+        let device = try makeDevice()
+        let store = RenderResourceStore()
+        let first = try XCTUnwrap(store.effectTargets(.scene, width: 640, height: 480, device: device))
+        let second = try XCTUnwrap(store.effectTargets(.scene, width: 640, height: 480, device: device))
+        let resized = try XCTUnwrap(store.effectTargets(.scene, width: 800, height: 480, device: device))
+        let bloom = try XCTUnwrap(store.effectTargets(.bloom, width: 640, height: 480, device: device))
+
+        XCTAssertTrue(first === second)
+        XCTAssertFalse(first === resized)
+        XCTAssertEqual(first.textures.count, 1)
+        XCTAssertEqual(bloom.textures.count, 3)
+        XCTAssertEqual(resized.textures[0].width, 800)
+        XCTAssertEqual(store.liveTargetCount, 3)
+    }
+
+    func testTargetsAreReleasedWithLastHolder() throws {
+        let device = try makeDevice()
+        let store = RenderResourceStore()
+        var held = store.effectTargets(.bloom, width: 320, height: 240, device: device)
+        XCTAssertNotNil(held)
+        XCTAssertEqual(store.liveTargetCount, 1)
+
+        held = nil
+        XCTAssertEqual(store.liveTargetCount, 0)
+    }
+}
+#endif
@@ -0,0 +1,100 @@
+// RenderVisibilitySchedulerTests.swift
+// ProSSHV2
+//
+// Pane visibility: host visibility, window occlusion and display sleep
+// decide whether a renderer may draw, and changes reach only the panes
+// they affect.
+
+#if canImport(XCTest)
+import XCTest
+import AppKit
+@testable import ProSSHMac
+
+final class RenderVisibilitySchedulerTests: XCTestCase {
+
+    private final class FakeClient: RenderVisibilityClient {
+        var renderWindow: NSWindow?
+        var onUpdate: (() -> Void)?
+
+        func updateRenderVisibility() {
+            onUpdate?()
+        }
+    }
+
+    private var center: NotificationCenter!
+    private var workspaceCenter: NotificationCenter!
+    private var scheduler: RenderVisibilityScheduler!
+
+    override func setUp() async throws {
+        center = NotificationCenter()
+        workspaceCenter = NotificationCenter()
+        scheduler = RenderVisibilityScheduler(
+            notificationCenter: center,
+            workspaceNotificationCenter: workspaceCenter
+        )
+    }
+
+    // MARK: - Decision
+
+    func testHiddenHostNeverRenders() {
+        XCTAssertFalse(scheduler.shouldRender(hostVisible: false, window: nil))
+        XCTAssertTrue(scheduler.shouldRender(hostVisible: true, window: nil))
+    }
+
+    // MARK: - Display Sleep
+
+    func testDisplaySleepStopsAndWakeResumesEveryPane() {
+        let client = FakeClient()
+        scheduler.register(client)
+
+        let slept = expectation(description: "sleep refresh")
+        client.onUpdate = { slept.fulfill() }
+        workspaceCenter.post(name: NSWorkspace.screensDidSleepNotification, object: nil)
+        wait(for: [slept], timeout: 1)
+        XCTAssertTrue(scheduler.displaysAsleep)
+        XCTAssertFalse(scheduler.shouldRender(hostVisible: true, window: nil))
+
+        let woke = expectation(description: "wake refresh")
+        client.onUpdate = { woke.fulfill() }
+        workspaceCenter.post(name: NSWorkspace.screensDidWakeNotification, object: nil)
+        wait(for: [woke], timeout: 1)
+        XCTAssertTrue(scheduler.shouldRender(hostVisible: true, window: nil))
+    }
+
+    // MARK: - Occlusion
+
+    func testOcclusionChangeRefreshesOnlyThatWindowsPanes() {
+        let window = NSWindow(
+            contentRect: NSRect(x: 0, y: 0, width: 200, height: 100),
+            styleMask: [.titled],
+            backing: .buffered,
+            defer: true
+        )
+        window.isReleasedWhenClosed = false
+        let inWindow = FakeClient()
+        inWindow.renderWindow = window
+        let elsewhere = FakeClient()
+        scheduler.register(inWindow)
+        scheduler.register(elsewhere)
+
+        let refreshed = expectation(description: "pane in window")
+        let untouched = expectation(description: "pane elsewhere")
+        untouched.isInverted = true
+        inWindow.onUpdate = { refreshed.fulfill() }
+        elsewhere.onUpdate = { untouched.fulfill() }
+        center.post(name: NSWindow.didChangeOcclusionStateNotification, object: window)
+        wait(for: [refreshed, untouched], timeout: 0.5)
+    }
+
+    // MARK: - Registration
+
+    func testClientsAreHeldWeakly() {
+        var client: FakeClient? = FakeClient()
+        scheduler.register(client!)
+        XCTAssertEqual(scheduler.liveClientCount, 1)
+
+        client = nil
+        XCTAssertEqual(scheduler.liveClientCount, 0)
+    }
+}
+#endif
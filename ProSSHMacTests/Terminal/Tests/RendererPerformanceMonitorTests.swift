@@ -0,0 +1,63 @@
+// RendererPerformanceMonitorTests.swift
+// ProSSHV2
+//
+// Rolling renderer metrics: GPU and drawable-wait samples, and the reset
+// the stress harness uses to isolate each run.
+
+#if canImport(XCTest)
+import XCTest
+@testable import ProSSHMac
+
+final class RendererPerformanceMonitorTests: XCTestCase {
+
+    // MARK: - Helpers
+
+    private func drawFrame(_ monitor: RendererPerformanceMonitor, cpuMs: Double) {
+        let id = monitor.beginFrame()
+        monitor.endFrame(signpostID: id, cpuFrameSeconds: cpuMs / 1000, gpuFrameSeconds: nil, drawCalls: 2)
+    }
+
+    // MARK: - Tests
+
+    func testDrawableWaitIsReportedInMilliseconds() {
+        let monitor = RendererPerformanceMonitor()
+        XCTAssertNil(monitor.snapshot().averageDrawableWaitMs)
+
+        monitor.recordDrawableWait(seconds: 0.001)
+        monitor.recordDrawableWait(seconds: 0.003)
+
+        let snapshot = monitor.snapshot()
+        XCTAssertEqual(snapshot.averageDrawableWaitMs ?? 0, 2, accuracy: 1e-9)
+        XCTAssertEqual(snapshot.p95DrawableWaitMs ?? 0, 3, accuracy: 1e-9)
+    }
+
+    func testInvalidSamplesAreIgnored() {
+        let monitor = RendererPerformanceMonitor()
+        monitor.recordDrawableWait(seconds: -1)
+        monitor.recordDrawableWait(seconds: .nan)
+        monitor.recordGPUFrame(seconds: 0)
+        XCTAssertNil(monitor.snapshot().averageDrawableWaitMs)
+        XCTAssertNil(monitor.snapshot().averageGPUFrameMs)
+    }
+
+    func testResetClearsSamplesAndCounters() {
+        let monitor = RendererPerformanceMonitor()
+        drawFrame(monitor, cpuMs: 20)
+        monitor.recordGPUFrame(seconds: 0.002)
+        monitor.recordDrawableWait(seconds: 0.001)
+
+        monitor.reset()
+
+        let snapshot = monitor.snapshot()
+        XCTAssertEqual(snapshot.totalFrames, 0)
+        XCTAssertEqual(snapshot.dropped60HzFrames, 0)
+        XCTAssertEqual(snapshot.averageCPUFrameMs, 0)
+        XCTAssertNil(snapshot.averageGPUFrameMs)
+        XCTAssertNil(snapshot.averageDrawableWaitMs)
+
+        drawFrame(monitor, cpuMs: 4)
+        XCTAssertEqual(monitor.snapshot().totalFrames, 1)
+        XCTAssertEqual(monitor.snapshot().averageCPUFrameMs, 4, accuracy: 1e-9)
+    }
+}
+#endif
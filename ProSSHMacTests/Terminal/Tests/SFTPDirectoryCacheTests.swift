@@ -0,0 +1,128 @@
+// SFTPDirectoryCacheTests.swift
+// ProSSHV2
+//
+// Freshness, mtime reconciliation of child listings, invalidation, prefetch
+// candidates and LRU eviction of the per-session remote listing cache.
+
+#if canImport(XCTest)
+import XCTest
+@testable import ProSSHMac
+
+@MainActor
+final class SFTPDirectoryCacheTests: XCTestCase {
+
+    private let epoch = Date(timeIntervalSince1970: 1_700_000_000)
+
+    private func directory(_ path: String, modifiedAt: Date?) -> SFTPDirectoryEntry {
+        SFTPDirectoryEntry(
+            path: path,
+            name: (path as NSString).lastPathComponent,
+            isDirectory: true,
+            size: 0,
+            permissions: 0o755,
+            modifiedAt: modifiedAt
+        )
+    }
+
+    private func file(_ path: String) -> SFTPDirectoryEntry {
+        SFTPDirectoryEntry(
+            path: path,
+            name: (path as NSString).lastPathComponent,
+            isDirectory: false,
+            size: 1,
+            permissions: 0o644,
+            modifiedAt: epoch
+        )
+    }
+
+    // MARK: - Freshness
+
+    func testListingIsFreshOnlyWithinTheInterval() {
+        var cache = SFTPDirectoryCache(freshnessInterval: 3)
+        cache.store([file("/srv/a")], for: "/srv/", directoryModifiedAt: epoch, now: epoch)
+
+        XCTAssertEqual(cache.listing(for: "/srv")?.entries.map(\.path), ["/srv/a"])
+        XCTAssertTrue(cache.isFresh("/srv", now: epoch.addingTimeInterval(2)))
+        XCTAssertFalse(cache.isFresh("/srv", now: epoch.addingTimeInterval(4)))
+
+        cache.revalidate("/srv", now: epoch.addingTimeInterval(4))
+        XCTAssertTrue(cache.isFresh("/srv", now: epoch.addingTimeInterval(5)))
+    }
+
+    // MARK: - Reconciliation
+
+    func testParentListingRevalidatesUnchangedChildrenAndDropsChangedOnes() {
+        var cache = SFTPDirectoryCache(freshnessInterval: 3)
+        let old = epoch
+        let changed = epoch.addingTimeInterval(60)
+        cache.store([file("/srv/src/main.c")], for: "/srv/src", directoryModifiedAt: old, now: old)
+        cache.store([file("/srv/docs/readme")], for: "/srv/docs", directoryModifiedAt: old, now: old)
+        cache.store([file("/srv/gone/x")], for: "/srv/gone", directoryModifiedAt: old, now: old)
+        cache.store([file("/srv/gone/deeper/y")], for: "/srv/gone/deeper", directoryModifiedAt: old, now: old)
+
+        let later = epoch.addingTimeInterval(120)
+        cache.store(
+            [directory("/srv/docs", modifiedAt: changed), directory("/srv/src", modifiedAt: old)],
+            for: "/srv",
+            directoryModifiedAt: later,
+            now: later
+        )
+
+        XCTAssertTrue(cache.isFresh("/srv/src", now: later))
+        XCTAssertNil(cache.listing(for: "/srv/docs"))
+        XCTAssertNil(cache.listing(for: "/srv/gone"))
+        XCTAssertNil(cache.listing(for: "/srv/gone/deeper"))
+        XCTAssertEqual(cache.knownModificationTime(of: "/srv/docs"), changed)
+    }
+
+    func testInvalidateSubtreeDropsDescendantsOnly() {
+        var cache = SFTPDirectoryCache()
+        cache.store([], for: "/a", directoryModifiedAt: nil)
+        cache.store([], for: "/a/b", directoryModifiedAt: nil)
+        cache.store([], for: "/ab", directoryModifiedAt: nil)
+
+        cache.invalidateSubtree("/a")
+
+        XCTAssertNil(cache.listing(for: "/a"))
+        XCTAssertNil(cache.listing(for: "/a/b"))
+        XCTAssertNotNil(cache.listing(for: "/ab"))
+    }
+
+    // MARK: - Prefetch
+
+    func testPrefetchCandidatesSkipHiddenAndCachedDirectories() {
+        var cache = SFTPDirectoryCache()
+        cache.store(
+            [
+                directory("/home/.cache", modifiedAt: epoch),
+                directory("/home/bin", modifiedAt: epoch),
+                directory("/home/projects", modifiedAt: epoch),
+                directory("/home/tmp", modifiedAt: epoch),
+                file("/home/notes.txt"),
+            ],
+            for: "/home",
+            directoryModifiedAt: epoch
+        )
+        cache.store([], for: "/home/bin", directoryModifiedAt: epoch)
+
+        XCTAssertEqual(cache.prefetchCandidates(in: "/home", limit: 1), ["/home/projects"])
+        XCTAssertEqual(cache.prefetchCandidates(in: "/home", limit: 4), ["/home/projects", "/home/tmp"])
+        XCTAssertEqual(cache.prefetchCandidates(in: "/missing", limit: 4), [])
+    }
+
+    // MARK: - Eviction
+
+    func testLeastRecentlyUsedListingIsEvictedBeyondCapacity() {
+        var cache = SFTPDirectoryCache(capacity: 2)
+        cache.store([], for: "/one", directoryModifiedAt: nil)
+        cache.store([], for: "/two", directoryModifiedAt: nil)
+        _ = cache.listing(for: "/one")
+        cache.store([], for: "/three", directoryModifiedAt: nil)
+
+        XCTAssertEqual(cache.count, 2)
+        XCTAssertNotNil(cache.listing(for: "/one"))
+        XCTAssertNil(cache.listing(for: "/two"))
+        XCTAssertNotNil(cache.listing(for: "/three"))
+    }
+}
+#endif
@@ -0,0 +1,75 @@
+#if canImport(XCTest)
+import XCTest
+@testable import ProSSHMac
+
+final class SFTPPartialDownloadTests: XCTestCase {
+
+    // MARK: - Range Planning
+
+    func testSplitsIntoContiguousRangesWithRemainderInLast() {
+        let partial = SFTPPartialDownload(remoteSize: 10, remoteModified: 0, rangeCount: 3)
+        XCTAssertEqual(partial.ranges.map(\.offset), [0, 3, 6])
+        XCTAssertEqual(partial.ranges.map(\.length), [3, 3, 4])
+        XCTAssertFalse(partial.isComplete)
+    }
+
+    func testRangeCountNeverExceedsSize() {
+        let partial = SFTPPartialDownload(remoteSize: 2, remoteModified: 0, rangeCount: 8)
+        XCTAssertEqual(partial.ranges.count, 2)
+    }
+
+    // MARK: - Manifest
+
+    func testManifestRoundTrips() {
+        var partial = SFTPPartialDownload(remoteSize: 1000, remoteModified: 1_700_000_000, rangeCount: 4)
+        partial.ranges[1].done = 120
+        partial.ranges[3].done = partial.ranges[3].length
+
+        let parsed = SFTPPartialDownload(manifest: partial.manifest)
+        XCTAssertEqual(parsed, partial)
+        XCTAssertEqual(parsed?.bytesDone, 120 + partial.ranges[3].length)
+    }
+
+    func testRejectsManifestWithGapOrBadProgress() {
+        XCTAssertNil(SFTPPartialDownload(manifest: "prossh-partial v1 10 0\n0 4 0\n5 5 0\n"))
+        XCTAssertNil(SFTPPartialDownload(manifest: "prossh-partial v1 10 0\n0 10 11\n"))
+        XCTAssertNil(SFTPPartialDownload(manifest: "prossh-partial v2 10 0\n0 10 0\n"))
+    }
+
+    // MARK: - Preparation
+
+    func testPrepareAdoptsShorterLocalFileAsPrefix() throws {
+        let localPath = NSTemporaryDirectory() + "partial-\(UUID().uuidString).bin"
+        defer {
+            try? FileManager.default.removeItem(atPath: localPath)
+            SFTPPartialDownload.remove(for: localPath)
+        }
+        FileManager.default.createFile(atPath: localPath, contents: Data(repeating: 7, count: 5))
+
+        let partial = try SFTPPartialDownload.prepare(localPath: localPath, remoteSize: 8, remoteModified: 1, rangeCount: 2)
+        XCTAssertEqual(partial.ranges.map(\.done), [4, 1])
+
+        let size = try FileManager.default.attributesOfItem(atPath: localPath)[.size] as? NSNumber
+        XCTAssertEqual(size?.int64Value, 8)
+    }
+
+    func testPrepareReusesMatchingManifestAndDropsStaleOne() throws {
+        let localPath = NSTemporaryDirectory() + "partial-\(UUID().uuidString).bin"
+        defer {
+            try? FileManager.default.removeItem(atPath: localPath)
+            SFTPPartialDownload.remove(for: localPath)
+        }
+
+        var first = try SFTPPartialDownload.prepare(localPath: localPath, remoteSize: 8, remoteModified: 1, rangeCount: 2)
+        first.ranges[0].done = 3
+        try first.save(for: localPath)
+
+        let resumed = try SFTPPartialDownload.prepare(localPath: localPath, remoteSize: 8, remoteModified: 1, rangeCount: 2)
+        XCTAssertEqual(resumed, first)
+
+        let restarted = try SFTPPartialDownload.prepare(localPath: localPath, remoteSize: 8, remoteModified: 2, rangeCount: 2)
+        XCTAssertEqual(restarted.bytesDone, 0)
+    }
+}
+
+#endif // canImport(XCTest)
@@ -0,0 +1,122 @@
+#if canImport(XCTest)
+import XCTest
+@testable import ProSSHMac
+
+final class SOCKS5NegotiatorTests: XCTestCase {
+
+    private let greeting = Data([0x05, 0x01, 0x00])
+    private let methodSelected = Data([0x05, 0x00])
+
+    // MARK: - Handshake
+
+    func testGreetingSelectsNoAuthentication() {
+        var negotiator = SOCKS5Negotiator()
+
+        let outcome = negotiator.receive(greeting)
+
+        XCTAssertEqual(outcome.response, methodSelected)
+        XCTAssertEqual(outcome.state, .pending)
+    }
+
+    func testGreetingWithoutNoAuthIsRejected() {
+        var negotiator = SOCKS5Negotiator()
+
+        let outcome = negotiator.receive(Data([0x05, 0x01, 0x02]))
+
+        XCTAssertEqual(outcome.response, Data([0x05, 0xFF]))
+        XCTAssertEqual(outcome.state, .failed)
+    }
+
+    func testNonSOCKS5ClientFails() {
+        var negotiator = SOCKS5Negotiator()
+
+        let outcome = negotiator.receive(Data([0x04, 0x01, 0x00, 0x50]))
+
+        XCTAssertTrue(outcome.response.isEmpty)
+        XCTAssertEqual(outcome.state, .failed)
+    }
+
+    // MARK: - CONNECT
+
+    func testDomainConnect() {
+        var negotiator = SOCKS5Negotiator()
+        _ = negotiator.receive(greeting)
+
+        let outcome = negotiator.receive(connectRequest(addressType: 0x03, address: [11] + Array("example.com".utf8), port: 443))
+
+        XCTAssertTrue(outcome.response.isEmpty)
+        XCTAssertEqual(outcome.state, .connect(.init(host: "example.com", port: 443), leftover: Data()))
+    }
+
+    func testIPv4Connect() {
+        var negotiator = SOCKS5Negotiator()
+        _ = negotiator.receive(greeting)
+
+        let outcome = negotiator.receive(connectRequest(addressType: 0x01, address: [10, 0, 0, 7], port: 5432))
+
+        XCTAssertEqual(outcome.state, .connect(.init(host: "10.0.0.7", port: 5432), leftover: Data()))
+    }
+
+    func testIPv6Connect() {
+        var negotiator = SOCKS5Negotiator()
+        _ = negotiator.receive(greeting)
+        let address: [UInt8] = [0x20, 0x01, 0x0d, 0xb8] + Array(repeating: 0, count: 11) + [0x01]
+
+        let outcome = negotiator.receive(connectRequest(addressType: 0x04, address: address, port: 80))
+
+        XCTAssertEqual(outcome.state, .connect(.init(host: "2001:db8:0:0:0:0:0:1", port: 80), leftover: Data()))
+    }
+
+    func testPipelinedGreetingRequestAndPayload() {
+        var negotiator = SOCKS5Negotiator()
+        let payload = Data("GET / HTTP/1.1\r\n".utf8)
+
+        let outcome = negotiator.receive(greeting + connectRequest(addressType: 0x01, address: [127, 0, 0, 1], port: 8080) + payload)
+
+        XCTAssertEqual(outcome.response, methodSelected)
+        XCTAssertEqual(outcome.state, .connect(.init(host: "127.0.0.1", port: 8080), leftover: payload))
+    }
+
+    func testRequestSplitAcrossReads() {
+        var negotiator = SOCKS5Negotiator()
+        _ = negotiator.receive(greeting)
+        let request = connectRequest(addressType: 0x03, address: [4] + Array("host".utf8), port: 22)
+
+        XCTAssertEqual(negotiator.receive(request.prefix(6)).state, .pending)
+        let outcome = negotiator.receive(request.dropFirst(6))
+
+        XCTAssertEqual(outcome.state, .connect(.init(host: "host", port: 22), leftover: Data()))
+    }
+
+    func testBindCommandIsNotSupported() {
+        var negotiator = SOCKS5Negotiator()
+        _ = negotiator.receive(greeting)
+
+        let outcome = negotiator.receive(Data([0x05, 0x02, 0x00, 0x01, 127, 0, 0, 1, 0, 80]))
+
+        XCTAssertEqual(outcome.response, SOCKS5Negotiator.reply(.commandNotSupported))
+        XCTAssertEqual(outcome.state, .failed)
+    }
+
+    func testUnknownAddressTypeIsNotSupported() {
+        var negotiator = SOCKS5Negotiator()
+        _ = negotiator.receive(greeting)
+
+        let outcome = negotiator.receive(Data([0x05, 0x01, 0x00, 0x09, 0, 0]))
+
+        XCTAssertEqual(outcome.response, SOCKS5Negotiator.reply(.addressTypeNotSupported))
+        XCTAssertEqual(outcome.state, .failed)
+    }
+
+    func testReplyLayout() {
+        XCTAssertEqual(SOCKS5Negotiator.reply(.succeeded), Data([0x05, 0x00, 0x00, 0x01, 0, 0, 0, 0, 0, 0]))
+    }
+
+    // MARK: - Helpers
+
+    private func connectRequest(addressType: UInt8, address: [UInt8], port: UInt16) -> Data {
+        Data([0x05, 0x01, 0x00, addressType] + address + [UInt8(port >> 8), UInt8(port & 0xFF)])
+    }
+}
+
+#endif
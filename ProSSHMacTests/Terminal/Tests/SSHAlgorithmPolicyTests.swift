@@ -0,0 +1,51 @@
+#if canImport(XCTest)
+import XCTest
+@testable import ProSSHMac
+
+final class SSHAlgorithmPolicyTests: XCTestCase {
+
+    private let modern = SSHAlgorithmPolicy.modern
+
+    // MARK: - Throughput Ordering
+
+    func testFastestAEADMovesToTheFront() {
+        let ordered = modern.orderedByThroughput([
+            "chacha20-poly1305@openssh.com": 800 << 20,
+            "aes256-gcm@openssh.com": 3000 << 20,
+            "aes128-ctr": 4000 << 20,
+            "hmac-sha2-256-etm@openssh.com": 1000 << 20,
+            "hmac-sha2-512": 500 << 20,
+        ])
+
+        // aes128-ctr is charged for its MAC pass: 1 / (1/4000 + 1/1000) ≈ 800 MB/s.
+        XCTAssertEqual(ordered.ciphers.first, "aes256-gcm@openssh.com")
+        XCTAssertEqual(ordered.macs, ["hmac-sha2-256-etm@openssh.com", "hmac-sha2-512"])
+    }
+
+    func testOrderingNeverChangesTheAlgorithmSet() {
+        let ordered = modern.orderedByThroughput([
+            "aes128-ctr": 9000 << 20,
+            "hmac-sha2-512": 2000 << 20,
+        ])
+
+        XCTAssertEqual(Set(ordered.ciphers), Set(modern.ciphers))
+        XCTAssertEqual(Set(ordered.macs), Set(modern.macs))
+        XCTAssertEqual(ordered.keyExchange, modern.keyExchange)
+        XCTAssertEqual(ordered.hostKeys, modern.hostKeys)
+    }
+
+    func testUnmeasuredAlgorithmsKeepTheirOrderAfterMeasuredOnes() {
+        let ordered = modern.orderedByThroughput(["aes128-ctr": 100])
+        XCTAssertEqual(ordered.ciphers, ["aes128-ctr", "chacha20-poly1305@openssh.com", "aes256-gcm@openssh.com"])
+
+        XCTAssertEqual(modern.orderedByThroughput([:]).ciphers, modern.ciphers)
+    }
+
+    func testAEADDetection() {
+        XCTAssertTrue(SSHAlgorithmPolicy.isAEAD("aes256-gcm@openssh.com"))
+        XCTAssertTrue(SSHAlgorithmPolicy.isAEAD("chacha20-poly1305@openssh.com"))
+        XCTAssertFalse(SSHAlgorithmPolicy.isAEAD("aes128-ctr"))
+    }
+}
+
+#endif // canImport(XCTest)
@@ -0,0 +1,46 @@
+// SSHBenchmarkReportTests.swift
+// ProSSHV2
+//
+// Tests for the SSH end-to-end benchmark report: the relative column and
+// the table it prints.
+
+#if canImport(XCTest)
+import XCTest
+@testable import ProSSHMac
+
+final class SSHBenchmarkReportTests: XCTestCase {
+
+    // MARK: - Tests
+
+    func testRelativeIsAboveOneWhenFaster() {
+        let rate = SSHBenchmarkReport.Row(metric: "transport base64", unit: .megabytesPerSecond, prossh: 60, openssh: 40)
+        let latency = SSHBenchmarkReport.Row(metric: "echo rtt median", unit: .milliseconds, prossh: 10, openssh: 20)
+
+        XCTAssertEqual(rate.relative ?? 0, 1.5, accuracy: 1e-9)
+        XCTAssertEqual(latency.relative ?? 0, 2, accuracy: 1e-9)
+    }
+
+    func testRelativeNeedsBothMeasurements() {
+        let row = SSHBenchmarkReport.Row(metric: "pipeline base64", unit: .megabytesPerSecond, prossh: 30, openssh: nil)
+        XCTAssertNil(row.relative)
+    }
+
+    func testLinesHaveHeaderAndOneRowPerMeasurement() {
+        var report = SSHBenchmarkReport()
+        report.rows = [
+            .init(metric: "sftp upload", unit: .megabytesPerSecond, prossh: 90, openssh: 100),
+            .init(metric: "echo rtt p95", unit: .milliseconds, prossh: 12.25, openssh: nil),
+        ]
+
+        let lines = report.lines
+
+        XCTAssertEqual(lines.count, 3)
+        XCTAssertTrue(lines[0].hasPrefix("metric"))
+        XCTAssertTrue(lines[1].contains("90.00 MB/s"))
+        XCTAssertTrue(lines[1].contains("100.00 MB/s"))
+        XCTAssertTrue(lines[1].hasSuffix("0.90x"))
+        XCTAssertTrue(lines[2].contains("12.25 ms"))
+        XCTAssertTrue(lines[2].hasSuffix("-"))
+    }
+}
+#endif
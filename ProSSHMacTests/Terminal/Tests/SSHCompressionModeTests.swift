@@ -0,0 +1,76 @@
+#if canImport(XCTest)
+import XCTest
+@testable import ProSSHMac
+
+final class SSHCompressionModeTests: XCTestCase {
+
+    // MARK: - Decision
+
+    func testExplicitModesIgnoreMeasurement() {
+        XCTAssertTrue(SSHCompressionMode.on.shouldCompress(measuredBytesPerSecond: nil, threshold: 1 << 20))
+        XCTAssertTrue(SSHCompressionMode.on.shouldCompress(measuredBytesPerSecond: 100 << 20, threshold: 1 << 20))
+        XCTAssertFalse(SSHCompressionMode.off.shouldCompress(measuredBytesPerSecond: 1024, threshold: 1 << 20))
+    }
+
+    func testAutoStaysOffUntilMeasured() {
+        XCTAssertFalse(SSHCompressionMode.auto.shouldCompress(measuredBytesPerSecond: nil, threshold: 1 << 20))
+        XCTAssertFalse(SSHCompressionMode.auto.shouldCompress(measuredBytesPerSecond: 0, threshold: 1 << 20))
+    }
+
+    func testAutoCompressesOnlyBelowThreshold() {
+        XCTAssertTrue(SSHCompressionMode.auto.shouldCompress(measuredBytesPerSecond: 400 << 10, threshold: 1 << 20))
+        XCTAssertFalse(SSHCompressionMode.auto.shouldCompress(measuredBytesPerSecond: 1 << 20, threshold: 1 << 20))
+        XCTAssertFalse(SSHCompressionMode.auto.shouldCompress(measuredBytesPerSecond: 50 << 20, threshold: 1 << 20))
+    }
+
+    func testAlgorithmListKeepsNoneAsFallback() {
+        XCTAssertEqual(SSHAlgorithmPolicy.compressionAlgorithms(enabled: false), "none")
+        let enabled = SSHAlgorithmPolicy.compressionAlgorithms(enabled: true).split(separator: ",")
+        XCTAssertEqual(enabled.first, "zlib@openssh.com")
+        XCTAssertEqual(enabled.last, "none")
+    }
+
+    // MARK: - Persistence
+
+    func testHostsSavedBeforeTheSettingDecodeAsAuto() throws {
+        let host = ProSSHMac.Host(
+            id: UUID(),
+            label: "edge",
+            folder: nil,
+            hostname: "edge.example.com",
+            port: 22,
+            username: "ops",
+            authMethod: .password,
+            keyReference: nil,
+            certificateReference: nil,
+            passwordReference: nil,
+            jumpHost: nil,
+            algorithmPreferences: nil,
+            pinnedHostKeyAlgorithms: [],
+            legacyModeEnabled: false,
+            compression: .on,
+            tags: [],
+            notes: nil,
+            lastConnected: nil,
+            createdAt: .now
+        )
+        let encoded = try JSONEncoder().encode(host)
+        XCTAssertEqual(try JSONDecoder().decode(ProSSHMac.Host.self, from: encoded).compression, .on)
+
+        var legacy = try XCTUnwrap(JSONSerialization.jsonObject(with: encoded) as? [String: Any])
+        legacy.removeValue(forKey: "compression")
+        let legacyData = try JSONSerialization.data(withJSONObject: legacy)
+        XCTAssertEqual(try JSONDecoder().decode(ProSSHMac.Host.self, from: legacyData).compression, .auto)
+    }
+
+    func testDraftRoundTripsCompression() {
+        var draft = HostDraft()
+        draft.label = "edge"
+        draft.hostname = "edge.example.com"
+        draft.username = "ops"
+        draft.compression = .off
+        XCTAssertEqual(HostDraft(from: draft.toHost()).compression, .off)
+    }
+}
+
+#endif // canImport(XCTest)
@@ -508,16 +508,53 @@ final class SSHConfigMapperTests: XCTestCase {
         XCTAssertEqual(rules[0].remotePort, 8080)
     }
 
-    func testRemoteForwardGeneratesNote() {
+    func testDynamicForwardParsed() {
+        let config = """
+        Host tunnel
+            HostName 10.0.0.1
+            DynamicForward 1080
+            DynamicForward 127.0.0.1:1081
+        """
+
+        let result = parser.parse(config)
+        let mapped = mapper.importAll(from: result)
+
+        let rules = mapped[0].host.portForwardingRules
+        XCTAssertEqual(rules.map(\.kind), [.dynamic, .dynamic])
+        XCTAssertEqual(rules.map(\.localPort), [1080, 1081])
+        XCTAssertFalse(mapped[0].notes.contains(where: { $0.contains("dynamicforward") }))
+    }
+
+    func testRemoteForwardParsed() {
         let config = """
         Host tunnel
             HostName 10.0.0.1
             RemoteForward 9090 localhost:80
+            RemoteForward 0.0.0.0:9091 127.0.0.1:8080
+        """
+
+        let result = parser.parse(config)
+        let mapped = mapper.importAll(from: result)
+
+        let rules = mapped[0].host.portForwardingRules
+        XCTAssertEqual(rules.map(\.kind), [.remote, .remote])
+        XCTAssertEqual(rules.map(\.remoteHost), ["", "0.0.0.0"])
+        XCTAssertEqual(rules.map(\.remotePort), [9090, 9091])
+        XCTAssertEqual(rules.map(\.localPort), [80, 8080])
+        XCTAssertFalse(mapped[0].notes.contains(where: { $0.contains("RemoteForward") }))
+    }
+
+    func testRemoteForwardToOtherHostGeneratesNote() {
+        let config = """
+        Host tunnel
+            HostName 10.0.0.1
+            RemoteForward 9090 intranet.example:80
         """
 
         let result = parser.parse(config)
         let mapped = mapper.importAll(from: result)
 
+        XCTAssertTrue(mapped[0].host.portForwardingRules.isEmpty)
         XCTAssertTrue(mapped[0].notes.contains(where: { $0.contains("RemoteForward") }))
     }
 
@@ -1179,3 +1216,222 @@ final class SSHConfigRoundTripTests: XCTestCase {
         XCTAssertEqual(roundTripped[1].algorithmPreferences?.ciphers, ["chacha20-poly1305@openssh.com"])
     }
 }
+
+// MARK: - File Parsing and Include Tests
+
+final class SSHConfigFileParserTests: XCTestCase {
+
+    private let parser = SSHConfigParser()
+    private var directory: URL!
+
+    override func setUpWithError() throws {
+        directory = FileManager.default.temporaryDirectory
+            .appendingPathComponent("SSHConfigFileParserTests-\(UUID().uuidString)", isDirectory: true)
+        try FileManager.default.createDirectory(at: directory, withIntermediateDirectories: true)
+    }
+
+    override func tearDownWithError() throws {
+        try? FileManager.default.removeItem(at: directory)
+    }
+
+    // MARK: - Helpers
+
+    @discardableResult
+    private func write(_ contents: String, to name: String) throws -> URL {
+        let url = directory.appendingPathComponent(name)
+        try FileManager.default.createDirectory(
+            at: url.deletingLastPathComponent(),
+            withIntermediateDirectories: true
+        )
+        try contents.write(to: url, atomically: true, encoding: .utf8)
+        return url
+    }
+
+    private var includes: SSHConfigParser.IncludeOptions {
+        SSHConfigParser.IncludeOptions(baseDirectory: directory, homeDirectory: directory)
+    }
+
+    // MARK: - Tests
+
+    func testFileParseMatchesStringParse() throws {
+        var config = "User shared\r\n"
+        for index in 0..<2_000 {
+            config += "Host node-\(index) # generated\n    HostName 10.0.\(index / 256).\(index % 256)\n    Port=\(2000 + index)\n"
+        }
+        let url = try write(config, to: "config")
+
+        let fromString = parser.parse(config)
+        let fromFile = try parser.parse(fileAt: url, includes: includes)
+
+        XCTAssertEqual(fromFile.entries.count, 2_001)
+        XCTAssertEqual(fromFile.entries.count, fromString.entries.count)
+        for (lhs, rhs) in zip(fromFile.entries, fromString.entries) {
+            XCTAssertEqual(lhs.patterns, rhs.patterns)
+            XCTAssertEqual(lhs.startLine, rhs.startLine)
+            XCTAssertEqual(lhs.directives.map(\.arguments), rhs.directives.map(\.arguments))
+        }
+        XCTAssertEqual(fromFile.entries[0].firstValue(for: "user"), "shared")
+        XCTAssertEqual(fromFile.entries[1_000].firstValue(for: "port"), "2999")
+    }
+
+    func testProgressReportsBytesRead() throws {
+        let config = String(repeating: "Host h\n    HostName example.com\n", count: 20_000)
+        let url = try write(config, to: "config")
+        let reports = LockedReports()
+
+        _ = try parser.parse(fileAt: url, includes: includes) { reports.append($0) }
+
+        let last = try XCTUnwrap(reports.values.last)
+        XCTAssertGreaterThan(reports.values.count, 1, "Large files report once per chunk")
+        XCTAssertEqual(last.bytesRead, Int64(config.utf8.count))
+        XCTAssertEqual(last.fractionCompleted, 1, accuracy: 0.0001)
+    }
+
+    func testIncludeExpandsGlobInSortedOrder() throws {
+        try write("Host beta\n    User b\n", to: "config.d/20-beta.conf")
+        try write("Host alpha\n    User a\n", to: "config.d/10-alpha.conf")
+        let url = try write("Include config.d/*.conf\nHost gamma\n    User c\n", to: "config")
+
+        let result = try parser.parse(fileAt: url, includes: includes)
+
+        XCTAssertEqual(result.entries.map(\.patterns), [["alpha"], ["beta"], ["gamma"]])
+        XCTAssertTrue(result.warnings.isEmpty)
+    }
+
+    func testIncludeResumesEnclosingBlock() throws {
+        try write("Host other\n    User o\n", to: "extra.conf")
+        let url = try write("""
+        Host web
+            User deploy
+            Include extra.conf
+            Port 2200
+        """, to: "config")
+
+        let result = try parser.parse(fileAt: url, includes: includes)
+
+        XCTAssertEqual(result.entries.map(\.patterns), [["web"], ["other"], ["web"]])
+        let index = SSHConfigHostIndex(result)
+        XCTAssertEqual(index.firstValue(for: "user", host: "web"), "deploy")
+        XCTAssertEqual(index.firstValue(for: "port", host: "web"), "2200")
+        XCTAssertNil(index.firstValue(for: "port", host: "other"))
+    }
+
+    func testIncludeCycleAndMissingFilesWarn() throws {
+        try write("Host loop\n    Include config\n", to: "loop.conf")
+        let url = try write("Include loop.conf\nInclude ~/missing/*.conf\n", to: "config")
+
+        let result = try parser.parse(fileAt: url, includes: includes)
+
+        XCTAssertEqual(result.entries.map(\.patterns), [["loop"]])
+        let reasons = result.warnings.map(\.reason)
+        XCTAssertTrue(reasons.contains { $0.hasPrefix("Include cycle skipped") })
+        XCTAssertTrue(reasons.contains { $0.hasPrefix("Include matched no files") })
+        XCTAssertEqual(result.warnings.first?.file, directory.appendingPathComponent("loop.conf").standardizedFileURL.path)
+    }
+
+    func testIncludeDepthLimit() throws {
+        try write("Include chain-2.conf\n", to: "chain-1.conf")
+        try write("Include chain-3.conf\n", to: "chain-2.conf")
+        try write("Include chain-4.conf\n", to: "chain-3.conf")
+        try write("Host bottom\n", to: "chain-4.conf")
+        let url = try write("Include chain-1.conf\n", to: "config")
+        var options = includes
+        options.maxDepth = 3
+
+        let result = try parser.parse(fileAt: url, includes: options)
+
+        XCTAssertTrue(result.entries.isEmpty)
+        XCTAssertTrue(result.warnings.contains { $0.reason.hasPrefix("Include nested too deeply") })
+    }
+
+    func testStringParseStillWarnsOnInclude() {
+        let result = parser.parse("Include ~/.ssh/config.d/*\nHost a\n")
+        XCTAssertEqual(result.warnings.count, 1)
+        XCTAssertEqual(result.entries.map(\.patterns), [["a"]])
+    }
+}
+
+/// Collects progress reports from the parser's `@Sendable` callback.
+private final class LockedReports: @unchecked Sendable {
+    private let lock = NSLock()
+    private var storage: [SSHConfigParseProgress] = []
+
+    var values: [SSHConfigParseProgress] {
+        lock.lock()
+        defer { lock.unlock() }
+        return storage
+    }
+
+    func append(_ progress: SSHConfigParseProgress) {
+        lock.lock()
+        storage.append(progress)
+        lock.unlock()
+    }
+}
+
+// MARK: - Host Index Tests
+
+final class SSHConfigHostIndexTests: XCTestCase {
+
+    private let parser = SSHConfigParser()
+    private let mapper = SSHConfigMapper()
+
+    func testLiteralAndPatternBlocksInFileOrder() {
+        let result = parser.parse("""
+        Host web-01
+            User first
+        Host *.prod web-*
+            User pattern
+            IdentityFile ~/.ssh/prod
+        Host web-01 db-01
+            Port 2201
+            IdentityFile ~/.ssh/web
+        Host * !web-01
+            ForwardAgent yes
+        """)
+        let index = SSHConfigHostIndex(result)
+
+        XCTAssertEqual(index.positions(matching: "WEB-01"), [0, 1, 2])
+        XCTAssertEqual(index.positions(matching: "db-01"), [2, 3])
+        XCTAssertEqual(index.positions(matching: "api.prod"), [1, 3])
+        XCTAssertEqual(index.firstValue(for: "user", host: "web-01"), "first")
+        XCTAssertEqual(index.allValues(for: "identityfile", host: "web-01"), ["~/.ssh/prod", "~/.ssh/web"])
+        XCTAssertNil(index.firstValue(for: "forwardagent", host: "web-01"))
+    }
+
+    func testWildcardMatching() {
+        XCTAssertTrue(SSHConfigHostIndex.matches(["*"], name: "anything"))
+        XCTAssertTrue(SSHConfigHostIndex.matches(["10.0.?.*"], name: "10.0.1.200"))
+        XCTAssertFalse(SSHConfigHostIndex.matches(["10.0.?.*"], name: "10.0.12.1"))
+        XCTAssertTrue(SSHConfigHostIndex.matches(["a*b*c"], name: "aXXbYYc"))
+        XCTAssertFalse(SSHConfigHostIndex.matches(["a*b*c"], name: "aXXbYY"))
+        XCTAssertFalse(SSHConfigHostIndex.matches(["!*.internal"], name: "db.internal"))
+        XCTAssertFalse(SSHConfigHostIndex.matches(["!bastion"], name: "web"), "A negation alone never matches")
+    }
+
+    func testMatchBlocksAreNotIndexed() {
+        let result = parser.parse("Match host web\n    User m\nHost web\n    User h\n")
+        XCTAssertEqual(SSHConfigHostIndex(result).firstValue(for: "user", host: "web"), "h")
+    }
+
+    func testMapperInheritsFromMatchingPatternBlocks() {
+        let config = """
+        Host web.prod
+            HostName 10.0.0.5
+        Host *.prod
+            User deploy
+            Port 2222
+        Host web.staging
+            HostName 10.1.0.5
+        Host *
+            User fallback
+        """
+        let hosts = mapper.importAll(from: parser.parse(config)).map(\.host)
+
+        XCTAssertEqual(hosts.map(\.label), ["web.prod", "web.staging"])
+        XCTAssertEqual(hosts[0].username, "deploy")
+        XCTAssertEqual(hosts[0].port, 2222)
+        XCTAssertEqual(hosts[1].username, "fallback")
+        XCTAssertEqual(hosts[1].port, 22)
+    }
+}
@@ -0,0 +1,62 @@
+#if canImport(XCTest)
+import XCTest
+@testable import ProSSHMac
+
+final class SSHConnectionShareKeyTests: XCTestCase {
+
+    // MARK: - Helpers
+
+    private func makeHost(hostname: String = "build.example.com", port: UInt16 = 22, username: String = "ops") -> ProSSHMac.Host {
+        ProSSHMac.Host(
+            id: UUID(),
+            label: hostname,
+            folder: nil,
+            hostname: hostname,
+            port: port,
+            username: username,
+            authMethod: .password,
+            keyReference: nil,
+            certificateReference: nil,
+            passwordReference: nil,
+            jumpHost: nil,
+            algorithmPreferences: nil,
+            pinnedHostKeyAlgorithms: [],
+            agentForwardingEnabled: false,
+            legacyModeEnabled: false,
+            tags: [],
+            notes: nil,
+            lastConnected: nil,
+            createdAt: .now
+        )
+    }
+
+    // MARK: - Matching
+
+    func testSameUserHostAndPortShareRegardlessOfProfile() {
+        let first = SSHConnectionShareKey(host: makeHost(hostname: "Build.Example.com"), jumpHostConfig: nil)
+        let second = SSHConnectionShareKey(host: makeHost(), jumpHostConfig: nil)
+        XCTAssertEqual(first, second)
+    }
+
+    func testDifferentUserOrPortDoNotShare() {
+        let base = SSHConnectionShareKey(host: makeHost(), jumpHostConfig: nil)
+        XCTAssertNotEqual(base, SSHConnectionShareKey(host: makeHost(username: "root"), jumpHostConfig: nil))
+        XCTAssertNotEqual(base, SSHConnectionShareKey(host: makeHost(port: 2222), jumpHostConfig: nil))
+    }
+
+    func testJumpRouteIsPartOfTheKey() {
+        let jump = JumpHostConfig(host: makeHost(hostname: "bastion.example.com"), expectedFingerprint: "SHA256:abc")
+        let direct = SSHConnectionShareKey(host: makeHost(), jumpHostConfig: nil)
+        let viaJump = SSHConnectionShareKey(host: makeHost(), jumpHostConfig: jump)
+        let viaOtherPin = SSHConnectionShareKey(
+            host: makeHost(),
+            jumpHostConfig: JumpHostConfig(host: jump.host, expectedFingerprint: "SHA256:def")
+        )
+
+        XCTAssertNotEqual(direct, viaJump)
+        XCTAssertNotEqual(viaJump, viaOtherPin)
+        XCTAssertEqual(viaJump, SSHConnectionShareKey(host: makeHost(), jumpHostConfig: jump))
+    }
+}
+
+#endif // canImport(XCTest)
@@ -0,0 +1,99 @@
+#if canImport(XCTest)
+import XCTest
+@testable import ProSSHMac
+
+final class SSHHandshakePoolTests: XCTestCase {
+
+    // MARK: - Helpers
+
+    private final class Peak: @unchecked Sendable {
+        private let lock = NSLock()
+        private var current = 0
+        private(set) var maximum = 0
+
+        func enter() {
+            lock.withLock {
+                current += 1
+                maximum = max(maximum, current)
+            }
+        }
+
+        func leave() {
+            lock.withLock { current -= 1 }
+        }
+    }
+
+    // MARK: - Limits
+
+    func testRunNeverExceedsLimit() async throws {
+        let pool = SSHHandshakePool(limit: 2)
+        let peak = Peak()
+
+        try await withThrowingTaskGroup(of: Int.self) { group in
+            for index in 0..<6 {
+                group.addTask {
+                    try await pool.run {
+                        peak.enter()
+                        Thread.sleep(forTimeInterval: 0.05)
+                        peak.leave()
+                        return index
+                    }
+                }
+            }
+            var results: [Int] = []
+            for try await value in group {
+                results.append(value)
+            }
+            XCTAssertEqual(results.sorted(), Array(0..<6))
+        }
+
+        XCTAssertEqual(peak.maximum, 2)
+        XCTAssertEqual(pool.activeCount, 0)
+    }
+
+    func testHandshakesOverlapUpToLimit() async throws {
+        let pool = SSHHandshakePool(limit: 4)
+        let start = Date()
+
+        try await withThrowingTaskGroup(of: Void.self) { group in
+            for _ in 0..<4 {
+                group.addTask {
+                    try await pool.run { Thread.sleep(forTimeInterval: 0.2) }
+                }
+            }
+            try await group.waitForAll()
+        }
+
+        // Four 200 ms handshakes take about one handshake, not four.
+        XCTAssertLessThan(Date().timeIntervalSince(start), 0.6)
+    }
+
+    func testReleaseHandsSlotToWaiter() async {
+        let pool = SSHHandshakePool(limit: 1)
+        await pool.acquire()
+
+        let waiter = Task {
+            await pool.acquire()
+            pool.release()
+        }
+        pool.release()
+        await waiter.value
+
+        XCTAssertEqual(pool.activeCount, 0)
+    }
+
+    func testFailuresReleaseTheirSlot() async {
+        struct Failure: Error {}
+        let pool = SSHHandshakePool(limit: 1)
+
+        do {
+            _ = try await pool.run { () throws -> Int in throw Failure() }
+            XCTFail("Expected the body's error")
+        } catch {
+            XCTAssertTrue(error is Failure)
+        }
+        XCTAssertEqual(pool.activeCount, 0)
+    }
+}
+
+#endif // canImport(XCTest)
@@ -0,0 +1,235 @@
+// ScrollbackPageTests.swift
+// ProSSHV2
+//
+// Page encoding and compression, spilling to the encrypted disk file, and
+// ScrollbackBuffer behaviour once its history spans many pages.
+
+#if canImport(XCTest)
+import CryptoKit
+import XCTest
+@testable import ProSSHMac
+
+final class ScrollbackPageTests: XCTestCase {
+
+    // MARK: - Helpers
+
+    private func makeLine(_ text: String, fg: UInt32 = 0, wrapped: Bool = false) -> ScrollbackLine {
+        let cells = text.unicodeScalars.map {
+            TerminalCell(
+                codepoint: $0.value,
+                fgPacked: fg,
+                bgPacked: 0,
+                ulPacked: 0,
+                attributes: [],
+                underlineStyle: .none,
+                width: 1
+            )
+        }
+        return ScrollbackLine(cells: cells, isWrapped: wrapped)
+    }
+
+    private func text(_ line: ScrollbackLine?) -> String {
+        guard let line else { return "<nil>" }
+        return (0..<line.count).map { line.grapheme(at: $0) }.joined()
+    }
+
+    private func makeSpillFile() -> ScrollbackSpillFile? {
+        try? ScrollbackSpillFile(
+            directory: FileManager.default.temporaryDirectory.appendingPathComponent("ScrollbackSpillTests"),
+            key: SymmetricKey(size: .bits256)
+        )
+    }
+
+    private func filledBuffer(lines: Int, maxLines: Int = 1_000_000) -> ScrollbackBuffer {
+        var buffer = ScrollbackBuffer(maxLines: maxLines, spillFile: { nil })
+        for index in 0..<lines {
+            buffer.push(cells: makeLine("line \(index)").cells)
+        }
+        return buffer
+    }
+
+    // MARK: - Page
+
+    func testPageRoundTripsStyleRunsWrapAndGraphemes() {
+        var styled = makeLine("plain")
+        styled.cells.append(contentsOf: makeLine("red", fg: 0xFF00_00FF).cells)
+        styled.cells[1].attributes = [.bold]
+        styled.cells[2].underlineStyle = .curly
+        styled.cells[2].underlinePackedRGBA = 0x00FF_00FF
+        var grapheme = makeLine("e", wrapped: true)
+        grapheme.graphemeOverrides = [0: "e\u{301}"]
+        let lines = [styled, grapheme, makeLine(""), makeLine("last")]
+
+        let page = ScrollbackPage(lines: lines[...])
+        let beforeCompression = page.decodeLines()
+        page.compress()
+        let afterCompression = page.decodeLines()
+
+        for decoded in [beforeCompression, afterCompression] {
+            XCTAssertEqual(decoded.map(text), ["plain" + "red", "e\u{301}", "", "last"])
+            XCTAssertEqual(decoded[0].cells.map(\.fgPackedRGBA), styled.cells.map(\.fgPackedRGBA))
+            XCTAssertEqual(decoded[0].cells.map(\.attributes.rawValue), styled.cells.map(\.attributes.rawValue))
+            XCTAssertEqual(decoded[0].cells[2].underlineStyle, .curly)
+            XCTAssertEqual(decoded[0].cells[2].underlinePackedRGBA, 0x00FF_00FF)
+            XCTAssertTrue(decoded[1].isWrapped)
+            XCTAssertFalse(decoded[0].isWrapped)
+        }
+    }
+
+    func testCompressionShrinksRepetitiveText() {
+        let lines = (0..<ScrollbackPage.lineCapacity).map { makeLine("build step \($0 % 8): ok") }
+        let page = ScrollbackPage(lines: lines[...])
+        let raw = page.byteCount
+
+        XCTAssertLessThan(page.compress(), 0)
+        XCTAssertTrue(page.isCompressed)
+        XCTAssertLessThan(page.byteCount, raw / 2)
+    }
+
+    func testSpilledPageReadsBackAndReleasesItsExtent() throws {
+        let file = try XCTUnwrap(makeSpillFile())
+        var lines = (0..<ScrollbackPage.lineCapacity).map { makeLine("secret \($0)") }
+        lines[7].isWrapped = true
+        var page: ScrollbackPage? = ScrollbackPage(lines: lines[...])
+        page?.compress()
+
+        XCTAssertLessThan(page?.spill(to: file) ?? 0, 0)
+        XCTAssertEqual(page?.byteCount, 0)
+        XCTAssertEqual(page?.isSpilled, true)
+        XCTAssertGreaterThan(file.liveByteCount, 0)
+
+        let decoded = page?.decodeLines() ?? []
+        XCTAssertEqual(decoded.map(text), lines.map(text))
+        XCTAssertTrue(decoded[7].isWrapped)
+
+        page = nil
+        XCTAssertEqual(file.liveByteCount, 0)
+    }
+
+    func testSpillFileRejectsTamperedExtent() throws {
+        let file = try XCTUnwrap(makeSpillFile())
+        let extent = try XCTUnwrap(file.write(Array("history".utf8)))
+
+        XCTAssertEqual(file.read(extent), Array("history".utf8))
+        let shifted = ScrollbackSpillFile.Extent(offset: extent.offset + 1, length: extent.length - 1)
+        XCTAssertNil(file.read(shifted))
+    }
+
+    // MARK: - Buffer
+
+    func testHistoryBeyondResidentWindowSpillsToDisk() throws {
+        let file = try XCTUnwrap(makeSpillFile())
+        var buffer = ScrollbackBuffer(maxLines: 1_000_000, residentPageLimit: 4, spillFile: { file })
+        for index in 0..<20_000 {
+            buffer.push(cells: makeLine("line \(index)").cells)
+        }
+
+        XCTAssertGreaterThan(file.liveByteCount, 0)
+        for index in [0, 300, 9_000, 17_000, 19_999] {
+            XCTAssertEqual(text(buffer.line(at: index)), "line \(index)")
+        }
+        XCTAssertEqual(buffer.search("line 42"), [42] + Array(420..<430) + Array(4_200..<4_300))
+
+        let inMemory = filledBuffer(lines: 20_000)
+        XCTAssertLessThan(buffer.pagedByteCount, inMemory.pagedByteCount)
+    }
+
+    func testRandomAccessAcrossPagesAndHotTail() {
+        let buffer = filledBuffer(lines: 10_000)
+
+        XCTAssertEqual(buffer.count, 10_000)
+        XCTAssertGreaterThan(buffer.pagedByteCount, 0)
+        for index in [0, 1, 255, 256, 4_321, 8_975, 8_976, 9_999] {
+            XCTAssertEqual(text(buffer.line(at: index)), "line \(index)")
+        }
+        XCTAssertEqual(text(buffer.first), "line 0")
+        XCTAssertEqual(text(buffer.last), "line 9999")
+        XCTAssertNil(buffer.line(at: 10_000))
+    }
+
+    func testMaxLinesEvictsOldestAcrossPages() {
+        let buffer = filledBuffer(lines: 5_000, maxLines: 3_000)
+
+        XCTAssertEqual(buffer.count, 3_000)
+        XCTAssertTrue(buffer.isFull)
+        XCTAssertEqual(text(buffer.first), "line 2000")
+        XCTAssertEqual(text(buffer.line(at: 1_500)), "line 3500")
+        XCTAssertEqual(text(buffer.last), "line 4999")
+    }
+
+    func testByteBudgetDropsWholePages() {
+        var buffer = ScrollbackBuffer(maxLines: 1_000_000, maxBytes: 64 * 1024, spillFile: { nil })
+        for index in 0..<20_000 {
+            buffer.push(cells: makeLine("line \(index) \(String(repeating: "x", count: index % 60))").cells)
+        }
+
+        XCTAssertLessThanOrEqual(buffer.pagedByteCount, 64 * 1024)
+        XCTAssertLessThan(buffer.count, 20_000)
+        XCTAssertEqual(text(buffer.last).prefix(10), "line 19999")
+        XCTAssertEqual(buffer.search("line 19999 ").count, 1)
+    }
+
+    func testPopLastWalksBackThroughPages() {
+        var buffer = filledBuffer(lines: 2_000, maxLines: 1_900)
+
+        for index in stride(from: 1_999, through: 100, by: -1) {
+            XCTAssertEqual(text(buffer.popLast()), "line \(index)")
+        }
+        XCTAssertTrue(buffer.isEmpty)
+        XCTAssertNil(buffer.popLast())
+
+        buffer.push(cells: makeLine("again").cells)
+        XCTAssertEqual(text(buffer.first), "again")
+    }
+
+    func testLastLinesAllLinesAndSearchSpanPages() {
+        var buffer = filledBuffer(lines: 3_000, maxLines: 2_900)
+
+        XCTAssertEqual(buffer.lastLines(3).map(text), ["line 2997", "line 2998", "line 2999"])
+        let all = buffer.allLines()
+        XCTAssertEqual(all.count, 2_900)
+        XCTAssertEqual(text(all.first), "line 100")
+        XCTAssertEqual(text(all.last), "line 2999")
+        XCTAssertEqual(buffer.search("LINE 150"), [50] + Array(1_400..<1_410))
+        XCTAssertEqual(buffer.search("LINE 150", caseSensitive: true), [])
+    }
+
+    func testCompactPagesTheHotTailAndKeepsEveryLine() {
+        var buffer = filledBuffer(lines: 3_000, maxLines: 2_950)
+        let before = buffer.estimatedMemoryBytes
+
+        let delta = buffer.compact()
+
+        XCTAssertLessThan(delta, 0)
+        XCTAssertEqual(buffer.estimatedMemoryBytes, before + delta)
+        XCTAssertEqual(buffer.count, 2_950)
+        for index in [0, 255, 1_000, 2_700, 2_949] {
+            XCTAssertEqual(text(buffer.line(at: index)), "line \(index + 50)")
+        }
+
+        buffer.push(cells: makeLine("after").cells)
+        XCTAssertEqual(text(buffer.last), "after")
+        XCTAssertEqual(text(buffer.popLast()), "after")
+        XCTAssertEqual(text(buffer.popLast()), "line 2999")
+    }
+
+    func testPushesAfterPagingRefillRecycledRows() {
+        var buffer = ScrollbackBuffer(maxLines: 1_000_000, spillFile: { nil })
+        let total = ScrollbackBuffer.hotLineLimit + 3 * ScrollbackPage.lineCapacity
+        for index in 0..<total {
+            var cells = makeLine("line \(index)", fg: UInt32(index % 3)).cells
+            if index.isMultiple(of: 2) {
+                cells[0].width = 2
+            }
+            buffer.push(cells: cells)
+        }
+
+        for index in [0, 1, 700, total - 257, total - 256, total - 2, total - 1] {
+            let line = buffer.line(at: index)
+            XCTAssertEqual(text(line), "line \(index)")
+            XCTAssertEqual(line?.row.width(at: 0), index.isMultiple(of: 2) ? 2 : 1)
+            XCTAssertEqual(line?.cells.first?.fgPackedRGBA, UInt32(index % 3))
+        }
+    }
+}
+#endif
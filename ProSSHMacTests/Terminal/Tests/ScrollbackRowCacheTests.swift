@@ -0,0 +1,104 @@
+// ScrollbackRowCacheTests.swift
+// ProSSHV2
+//
+// Scrolled-back snapshots reuse encoded scrollback rows. Output must match
+// an encode with an empty cache, including after lines are evicted, popped
+// back by a resize, or the history is cleared.
+
+#if canImport(XCTest)
+import XCTest
+@testable import ProSSHMac
+
+final class ScrollbackRowCacheTests: XCTestCase {
+
+    // MARK: - Helpers
+
+    private func makeGrid(lines: Int, maxScrollbackLines: Int = 1_000) -> TerminalGrid {
+        let grid = TerminalGrid(columns: 12, rows: 4, maxScrollbackLines: maxScrollbackLines)
+        for line in 0..<lines {
+            appendLine("row \(line)", to: grid)
+        }
+        return grid
+    }
+
+    private func appendLine(_ text: String, to grid: TerminalGrid) {
+        grid.moveCursorTo(row: grid.rows - 1, col: 0)
+        for char in text {
+            grid.printCharacter(char)
+        }
+        grid.lineFeed()
+    }
+
+    private func assertMatchesUncached(_ grid: TerminalGrid, offset: Int, file: StaticString = #filePath, line: UInt = #line) {
+        let cached = grid.snapshot(scrollOffset: offset)
+        grid.scrollbackRowCache.removeAll()
+        let fresh = grid.snapshot(scrollOffset: offset)
+        XCTAssertEqual(cached.cells.count, fresh.cells.count, file: file, line: line)
+        for index in 0..<min(cached.cells.count, fresh.cells.count) {
+            let a = cached.cells[index]
+            let e = fresh.cells[index]
+            guard a.row == e.row, a.col == e.col, a.glyphIndex == e.glyphIndex,
+                  a.fgColor == e.fgColor, a.bgColor == e.bgColor,
+                  a.attributes == e.attributes, a.flags == e.flags else {
+                XCTFail("cell \(index) differs from an uncached encode", file: file, line: line)
+                return
+            }
+        }
+        XCTAssertEqual(cached.graphemeOverrides, fresh.graphemeOverrides, file: file, line: line)
+    }
+
+    // MARK: - Reuse
+
+    func testScrollingOneRowEncodesOneLine() {
+        let grid = makeGrid(lines: 40)
+        _ = grid.snapshot(scrollOffset: 10)
+        let cachedAfterFirst = grid.scrollbackRowCache.count
+
+        _ = grid.snapshot(scrollOffset: 11)
+
+        XCTAssertEqual(cachedAfterFirst, 4)
+        XCTAssertEqual(grid.scrollbackRowCache.count, 5)
+        assertMatchesUncached(grid, offset: 11)
+    }
+
+    func testMixedScrollbackAndLiveRows() {
+        let grid = makeGrid(lines: 20)
+        for offset in [1, 2, 3, 2, 1] {
+            assertMatchesUncached(grid, offset: offset)
+        }
+    }
+
+    func testGraphemesAreRemappedToDisplayRow() {
+        let grid = makeGrid(lines: 5)
+        appendLine("e\u{301}\u{1F44D}\u{1F3FD}", to: grid)
+        appendLine("tail", to: grid)
+        _ = grid.snapshot(scrollOffset: 3)
+        assertMatchesUncached(grid, offset: 2)
+    }
+
+    // MARK: - Invalidation
+
+    func testEvictionKeepsLineIDsStable() {
+        let grid = makeGrid(lines: 30, maxScrollbackLines: 20)
+        _ = grid.snapshot(scrollOffset: 8)
+        for line in 0..<5 {
+            appendLine("new \(line)", to: grid)
+        }
+        assertMatchesUncached(grid, offset: 8)
+    }
+
+    func testResizeAndClearInvalidate() {
+        let grid = makeGrid(lines: 30)
+        _ = grid.snapshot(scrollOffset: 6)
+        grid.resize(newColumns: 8, newRows: 6)
+        assertMatchesUncached(grid, offset: 6)
+
+        grid.eraseInDisplay(mode: 3)
+        for line in 0..<12 {
+            appendLine("fresh \(line)", to: grid)
+        }
+        appendLine("x", to: grid)
+        assertMatchesUncached(grid, offset: 6)
+    }
+}
+#endif
@@ -0,0 +1,116 @@
+// ScrollbackRowRingTests.swift
+// ProSSHV2
+//
+// Ring rows match the scrolled-back snapshot cell for cell and carry their
+// line position in `row`; positions outside the history are skipped. The
+// ring maps positions to slots modulo its capacity and draws resident
+// slots in contiguous runs.
+
+#if canImport(XCTest)
+import XCTest
+import Metal
+@testable import ProSSHMac
+
+final class ScrollbackRowRingTests: XCTestCase {
+
+    // MARK: - Helpers
+
+    private func makeGrid(lines: Int) -> TerminalGrid {
+        let grid = TerminalGrid(columns: 12, rows: 4, maxScrollbackLines: 1_000)
+        for line in 0..<lines {
+            grid.moveCursorTo(row: grid.rows - 1, col: 0)
+            for char in "row \(line)" {
+                grid.printCharacter(char)
+            }
+            grid.lineFeed()
+        }
+        return grid
+    }
+
+    private func rows(_ positions: Range<Int>, columns: Int = 4) -> ScrollbackRingRows {
+        ScrollbackRingRows(
+            columns: columns,
+            firstPosition: 0,
+            liveTop: 100,
+            rows: positions.map { position in
+                ScrollbackRingRows.Row(
+                    position: position,
+                    cells: ContiguousArray((0..<columns).map { col in
+                        CellInstance(
+                            row: UInt16(truncatingIfNeeded: position),
+                            col: UInt16(col),
+                            glyphIndex: UInt32(0x41 + col),
+                            fgColor: 0,
+                            bgColor: 0,
+                            underlineColor: 0,
+                            attributes: 0,
+                            flags: 0,
+                            underlineStyle: 0
+                        )
+                    })
+                )
+            }
+        )
+    }
+
+    // MARK: - Grid Rows
+
+    func testRingRowsMatchScrolledBackSnapshot() {
+        let grid = makeGrid(lines: 40)
+        let offset = 10
+        let snapshot = grid.snapshot(scrollOffset: offset)
+        let probe = grid.scrollbackRingRows(positions: 0..<0)
+        XCTAssertEqual(probe.liveTop - probe.firstPosition, grid.scrollbackCount)
+
+        let top = probe.liveTop - offset
+        let ring = grid.scrollbackRingRows(positions: top..<(top + grid.rows))
+        XCTAssertEqual(ring.rows.map(\.position), Array(top..<(top + grid.rows)))
+        for (displayRow, row) in ring.rows.enumerated() {
+            XCTAssertEqual(row.cells.count, grid.columns)
+            for (col, cell) in row.cells.enumerated() {
+                let expected = snapshot.cells[displayRow * grid.columns + col]
+                XCTAssertEqual(cell.row, UInt16(truncatingIfNeeded: row.position))
+                XCTAssertEqual(cell.col, expected.col)
+                XCTAssertEqual(cell.glyphIndex, expected.glyphIndex)
+                XCTAssertEqual(cell.attributes, expected.attributes)
+            }
+        }
+    }
+
+    func testRingRowsSkipPositionsOutsideHistory() {
+        let grid = makeGrid(lines: 10)
+        let probe = grid.scrollbackRingRows(positions: 0..<0)
+        let end = probe.liveTop + grid.rows
+
+        let fetched = grid.scrollbackRingRows(positions: (probe.firstPosition - 5)..<(end + 5))
+
+        XCTAssertEqual(fetched.rows.first?.position, probe.firstPosition)
+        XCTAssertEqual(fetched.rows.last?.position, end - 1)
+        XCTAssertTrue(fetched.rows.allSatisfy { $0.cells.allSatisfy { $0.flags & CellInstance.flagCursor == 0 } })
+    }
+
+    // MARK: - Ring
+
+    func testSlotsWrapAndRunsSplitAtTheWrap() throws {
+        guard let device = MTLCreateSystemDefaultDevice() else {
+            throw XCTSkip("No Metal device available")
+        }
+        let ring = try XCTUnwrap(ScrollbackRowRing(
+            device: device, columns: 4, capacity: 8, gridRows: 2, firstPosition: 0, liveTop: 100
+        ))
+        ring.write(rows(6..<10))
+
+        XCTAssertEqual(ring.slot(for: 9), 1)
+        XCTAssertEqual(ring.missingPositions(in: 4..<10), 4..<6)
+        XCTAssertNil(ring.missingPositions(in: 6..<10))
+        XCTAssertEqual(ring.slotRuns(for: 4..<10), [6..<8, 0..<2])
+
+        ring.write(rows(14..<15))
+        XCTAssertFalse(ring.contains(6))
+        XCTAssertTrue(ring.contains(14))
+
+        ring.write(rows(20..<21, columns: 5))
+        XCTAssertFalse(ring.contains(20), "Rows at another width are ignored")
+    }
+}
+#endif
@@ -0,0 +1,211 @@
+// ScrollbackSearchTests.swift
+// ProSSHV2
+//
+// Full-history search: column mapping for literal and regex matches,
+// incremental passes over appended and evicted lines, refinement of a
+// growing query, and the TerminalSearch navigation across history.
+
+#if canImport(XCTest)
+import XCTest
+@testable import ProSSHMac
+
+final class ScrollbackSearchTests: XCTestCase {
+
+    // MARK: - Helpers
+
+    private func makeLine(_ text: String) -> [TerminalCell] {
+        var cells: [TerminalCell] = []
+        for scalar in text.unicodeScalars {
+            let wide = CharacterWidth.isWide(scalar)
+            cells.append(TerminalCell(
+                codepoint: scalar.value,
+                fgPacked: 0,
+                bgPacked: 0,
+                ulPacked: 0,
+                attributes: wide ? [.wideChar] : [],
+                underlineStyle: .none,
+                width: wide ? 2 : 1
+            ))
+            if wide {
+                cells.append(TerminalCell(
+                    codepoint: 0,
+                    fgPacked: 0,
+                    bgPacked: 0,
+                    ulPacked: 0,
+                    attributes: [.wideContinuation],
+                    underlineStyle: .none,
+                    width: 0
+                ))
+            }
+        }
+        return cells
+    }
+
+    private func makeBuffer(_ lines: [String], maxLines: Int = 1_000_000) -> ScrollbackBuffer {
+        var buffer = ScrollbackBuffer(maxLines: maxLines, spillFile: { nil })
+        for line in lines {
+            buffer.push(cells: makeLine(line))
+        }
+        return buffer
+    }
+
+    private func query(_ text: String, regex: Bool = false, caseSensitive: Bool = false) -> ScrollbackSearchQuery {
+        ScrollbackSearchQuery(text: text, isRegex: regex, isCaseSensitive: caseSensitive)
+    }
+
+    private final class Collector: @unchecked Sendable {
+        private let lock = NSLock()
+        private var storage: [ScrollbackSearchEngine.Update] = []
+
+        func append(_ update: ScrollbackSearchEngine.Update) {
+            lock.lock()
+            storage.append(update)
+            lock.unlock()
+        }
+
+        var updates: [ScrollbackSearchEngine.Update] {
+            lock.lock()
+            defer { lock.unlock() }
+            return storage
+        }
+    }
+
+    private func run(
+        _ engine: ScrollbackSearchEngine,
+        _ buffer: ScrollbackBuffer,
+        _ query: ScrollbackSearchQuery
+    ) async throws -> [ScrollbackSearchEngine.Update] {
+        let collector = Collector()
+        try await engine.search(buffer, query: query) { collector.append($0) }
+        return collector.updates
+    }
+
+    // MARK: - Matching
+
+    func testLiteralMatchesAreCaseInsensitiveByDefault() async throws {
+        let buffer = makeBuffer(["Error: disk", "no issue", "ERROR again error"])
+        let updates = try await run(ScrollbackSearchEngine(), buffer, query("error"))
+
+        let matches = updates.flatMap(\.matches)
+        XCTAssertEqual(matches.map(\.lineID), [0, 2, 2])
+        XCTAssertEqual(matches.map(\.column), [0, 0, 12])
+        XCTAssertEqual(matches.map(\.length), [5, 5, 5])
+        XCTAssertEqual(updates.first?.reset, true)
+        XCTAssertEqual(updates.last?.isComplete, true)
+
+        let sensitive = try await run(ScrollbackSearchEngine(), buffer, query("error", caseSensitive: true))
+        XCTAssertEqual(sensitive.flatMap(\.matches).map(\.column), [12])
+    }
+
+    func testMatchColumnsSkipWideContinuationCells() async throws {
+        let buffer = makeBuffer(["中文 build ok"])
+        let updates = try await run(ScrollbackSearchEngine(), buffer, query("文 b"))
+
+        let match = try XCTUnwrap(updates.flatMap(\.matches).first)
+        XCTAssertEqual(match.column, 2)
+        XCTAssertEqual(match.length, 4, "The wide character covers two cells")
+    }
+
+    func testRegexMatchesMapToCells() async throws {
+        let buffer = makeBuffer(["eth0 up wlan1 down"])
+        let updates = try await run(ScrollbackSearchEngine(), buffer, query("[a-z]+\\d", regex: true))
+
+        let matches = updates.flatMap(\.matches)
+        XCTAssertEqual(matches.map(\.column), [0, 8])
+        XCTAssertEqual(matches.map(\.length), [4, 5])
+    }
+
+    func testInvalidRegexThrows() async {
+        let engine = ScrollbackSearchEngine()
+        do {
+            _ = try await run(engine, makeBuffer(["x"]), query("[", regex: true))
+            XCTFail("An unbalanced bracket does not compile")
+        } catch {}
+    }
+
+    // MARK: - Incremental Search
+
+    func testRepeatSearchScansOnlyAppendedLines() async throws {
+        let engine = ScrollbackSearchEngine()
+        var buffer = makeBuffer((0..<3000).map { $0 % 1000 == 0 ? "marker \($0)" : "line \($0)" })
+
+        let first = try await run(engine, buffer, query("marker"))
+        XCTAssertEqual(first.flatMap(\.matches).map(\.lineID), [0, 1000, 2000])
+
+        buffer.push(cells: makeLine("marker late"))
+        let second = try await run(engine, buffer, query("marker"))
+        XCTAssertEqual(second.count, 1)
+        XCTAssertEqual(second[0].reset, false)
+        XCTAssertEqual(second[0].matches.map(\.lineID), [3000])
+        XCTAssertEqual(second[0].lineCount, 3001)
+    }
+
+    func testEvictedLinesAdvanceFirstLineID() async throws {
+        let engine = ScrollbackSearchEngine()
+        var buffer = makeBuffer((0..<2000).map { "marker \($0)" }, maxLines: 2000)
+        _ = try await run(engine, buffer, query("marker 1"))
+
+        for index in 0..<600 {
+            buffer.push(cells: makeLine("tail \(index)"))
+        }
+        let updates = try await run(engine, buffer, query("marker 1"))
+        let update = try XCTUnwrap(updates.last)
+        XCTAssertFalse(update.reset)
+        XCTAssertEqual(update.firstLineID, buffer.firstLineID)
+        XCTAssertGreaterThan(update.firstLineID, 0)
+        XCTAssertTrue(updates.flatMap(\.matches).isEmpty)
+    }
+
+    func testRewriteRestartsSearch() async throws {
+        let engine = ScrollbackSearchEngine()
+        var buffer = makeBuffer(["marker a", "marker b"])
+        _ = try await run(engine, buffer, query("marker"))
+
+        buffer.clear()
+        buffer.push(cells: makeLine("marker c"))
+        let updates = try await run(engine, buffer, query("marker"))
+        XCTAssertEqual(updates.first?.reset, true)
+        XCTAssertEqual(updates.flatMap(\.matches).count, 1)
+    }
+
+    func testRefinedQueryRechecksMatchedLines() async throws {
+        let engine = ScrollbackSearchEngine()
+        let buffer = makeBuffer(["err", "error", "no", "errors"])
+        _ = try await run(engine, buffer, query("err"))
+
+        let updates = try await run(engine, buffer, query("error"))
+        XCTAssertEqual(updates.first?.reset, true)
+        XCTAssertEqual(updates.flatMap(\.matches).map(\.lineID), [1, 3])
+        XCTAssertEqual(updates.last?.isComplete, true)
+    }
+
+    // MARK: - TerminalSearch
+
+    @MainActor
+    func testNavigationWalksHistoryThenScreen() async throws {
+        let search = TerminalSearch()
+        let buffer = makeBuffer(["build ok", "build failed"])
+        search.updateLines(["build again"])
+        search.attachHistory(sessionID: UUID()) { buffer }
+        search.query = "build"
+
+        for _ in 0..<100 where search.isSearchingHistory {
+            try await Task.sleep(for: .milliseconds(10))
+        }
+        XCTAssertFalse(search.isSearchingHistory)
+        XCTAssertEqual(search.historyMatches.count, 2)
+        XCTAssertEqual(search.resultSummary, "3/3")
+
+        search.selectNextMatch()
+        let first = try XCTUnwrap(search.selectedHistoryMatch)
+        XCTAssertEqual(first.lineID, 0)
+        XCTAssertNil(search.selectedMatch)
+        XCTAssertEqual(search.scrollOffset(for: first), 2)
+        XCTAssertEqual(search.resultSummary, "1/3")
+
+        search.selectPreviousMatch()
+        XCTAssertNil(search.selectedHistoryMatch)
+        XCTAssertNotNil(search.selectedMatch)
+    }
+}
+#endif
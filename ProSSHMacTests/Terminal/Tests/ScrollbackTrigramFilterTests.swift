@@ -0,0 +1,119 @@
+// ScrollbackTrigramFilterTests.swift
+// ProSSHV2
+//
+// Trigram filters on scrollback pages: required literals pulled from regex
+// patterns, page filtering, and indexed search returning the same matches
+// as a full scan.
+
+#if canImport(XCTest)
+import XCTest
+@testable import ProSSHMac
+
+final class ScrollbackTrigramFilterTests: XCTestCase {
+
+    // MARK: - Helpers
+
+    private func makeLine(_ text: String) -> [TerminalCell] {
+        text.unicodeScalars.map {
+            TerminalCell(
+                codepoint: $0.value,
+                fgPacked: 0,
+                bgPacked: 0,
+                ulPacked: 0,
+                attributes: [],
+                underlineStyle: .none,
+                width: 1
+            )
+        }
+    }
+
+    private func makeBuffer(lines: Int, indexed: Bool, text: (Int) -> String) -> ScrollbackBuffer {
+        var buffer = ScrollbackBuffer(maxLines: 1_000_000, indexesText: indexed, spillFile: { nil })
+        for index in 0..<lines {
+            buffer.push(cells: makeLine(text(index)))
+        }
+        return buffer
+    }
+
+    private func lineIDs(_ buffer: ScrollbackBuffer, _ query: ScrollbackSearchQuery) async throws -> [Int] {
+        let collected = LockedMatches()
+        try await ScrollbackSearchEngine().search(buffer, query: query) { update in
+            collected.append(update.matches)
+        }
+        return collected.matches.map(\.lineID)
+    }
+
+    private final class LockedMatches: @unchecked Sendable {
+        private let lock = NSLock()
+        private var storage: [ScrollbackSearchMatch] = []
+
+        func append(_ matches: [ScrollbackSearchMatch]) {
+            lock.lock()
+            storage.append(contentsOf: matches)
+            lock.unlock()
+        }
+
+        var matches: [ScrollbackSearchMatch] {
+            lock.lock()
+            defer { lock.unlock() }
+            return storage
+        }
+    }
+
+    // MARK: - Required Literals
+
+    func testRegexLiteralsSkipOptionalAtoms() {
+        XCTAssertEqual(ScrollbackTrigramFilter.requiredLiterals(inRegex: "error: \\d+ files?"), ["error: ", " file"])
+        XCTAssertEqual(ScrollbackTrigramFilter.requiredLiterals(inRegex: "conn[a-z]*ected\\.log"), ["conn", "ected.log"])
+        XCTAssertEqual(ScrollbackTrigramFilter.requiredLiterals(inRegex: "(?i)timeout"), ["timeout"])
+    }
+
+    func testRegexWithoutSafeLiteralsGivesNoKeys() {
+        XCTAssertEqual(ScrollbackTrigramFilter.requiredLiterals(inRegex: "warn|error"), [])
+        XCTAssertEqual(ScrollbackTrigramFilter.requiredLiterals(inRegex: "(?x) a b c d"), [])
+        let query = ScrollbackSearchQuery(text: "ab", isRegex: false, isCaseSensitive: false)
+        XCTAssertTrue(ScrollbackTrigramFilter.requiredKeys(for: query).isEmpty, "Too short to narrow")
+    }
+
+    // MARK: - Filtering
+
+    func testFilterMatchesFoldedTrigrams() {
+        let filter = ScrollbackTrigramFilter(lines: [ScrollbackLine(cells: makeLine("Disk FULL on /var"))])
+        let present = ScrollbackSearchQuery(text: "disk full", isRegex: false, isCaseSensitive: true)
+        XCTAssertTrue(filter.mayContainAll(ScrollbackTrigramFilter.requiredKeys(for: present)))
+
+        let absent = ScrollbackSearchQuery(text: "segfault", isRegex: false, isCaseSensitive: false)
+        XCTAssertFalse(filter.mayContainAll(ScrollbackTrigramFilter.requiredKeys(for: absent)))
+    }
+
+    func testIndexedPagesCountTheirFilter() {
+        let lines = (0..<ScrollbackPage.lineCapacity).map { ScrollbackLine(cells: makeLine("line \($0)")) }
+        let plain = ScrollbackPage(lines: lines[...])
+        let indexed = ScrollbackPage(lines: lines[...], indexed: true)
+        XCTAssertNil(plain.trigrams)
+        XCTAssertEqual(indexed.byteCount, plain.byteCount + ScrollbackTrigramFilter.bitCount / 8)
+    }
+
+    // MARK: - Search
+
+    func testIndexedSearchMatchesFullScan() async throws {
+        let text: (Int) -> String = { index in
+            index % 997 == 0 ? "request \(index) failed: timeout" : "request \(index) ok"
+        }
+        let plain = makeBuffer(lines: 20_000, indexed: false, text: text)
+        let indexed = makeBuffer(lines: 20_000, indexed: true, text: text)
+
+        for query in [
+            ScrollbackSearchQuery(text: "TIMEOUT", isRegex: false, isCaseSensitive: false),
+            ScrollbackSearchQuery(text: "failed: \\w+", isRegex: true, isCaseSensitive: true),
+            ScrollbackSearchQuery(text: "ok|fail", isRegex: true, isCaseSensitive: false)
+        ] {
+            let expected = try await lineIDs(plain, query)
+            let actual = try await lineIDs(indexed, query)
+            XCTAssertEqual(actual, expected, query.text)
+        }
+        let timeouts = try await lineIDs(indexed, ScrollbackSearchQuery(text: "timeout", isRegex: false, isCaseSensitive: false))
+        XCTAssertEqual(timeouts.count, (0..<20_000).filter { $0 % 997 == 0 }.count)
+    }
+}
+#endif
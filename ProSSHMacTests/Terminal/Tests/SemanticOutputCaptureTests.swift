@@ -0,0 +1,157 @@
+// SemanticOutputCaptureTests.swift
+// ProSSHV2
+//
+// Command output read from the lines between an OSC 133;C mark and the
+// cursor, prompt and output zones for navigation, and the dirty-row visible
+// text used by the heuristic fallback.
+
+#if canImport(XCTest)
+import XCTest
+@testable import ProSSHMac
+
+final class SemanticOutputCaptureTests: XCTestCase {
+
+    private func feed(_ engine: TerminalEngine, _ text: String) async {
+        await engine.feed(Array(text.utf8))
+    }
+
+    // MARK: - Output Capture
+
+    func testOutputSpansScrollbackAndScreen() async {
+        let engine = TerminalEngine(columns: 20, rows: 3, maxScrollbackLines: 100)
+        await feed(engine, "$ seq 5\r\n\u{1B}]133;C\u{07}")
+        await feed(engine, "1\r\n2\r\n3\r\n4\r\n5\r\n")
+
+        let output = await engine.takeSemanticCommandOutput(maxCharacters: 1_000)
+        XCTAssertEqual(output, "1\n2\n3\n4\n5")
+        let again = await engine.takeSemanticCommandOutput(maxCharacters: 1_000)
+        XCTAssertNil(again, "The mark is consumed")
+    }
+
+    func testOutputKeepsTheNewestLinesWithinLimit() async {
+        let engine = TerminalEngine(columns: 20, rows: 3, maxScrollbackLines: 100)
+        await feed(engine, "\u{1B}]133;C\u{07}")
+        for line in 0..<20 {
+            await feed(engine, "line \(line)\r\n")
+        }
+
+        let output = await engine.takeSemanticCommandOutput(maxCharacters: 16)
+        XCTAssertEqual(output, "line 18\nline 19")
+    }
+
+    func testResizeDropsTheMark() async {
+        let engine = TerminalEngine(columns: 20, rows: 3, maxScrollbackLines: 100)
+        await feed(engine, "\u{1B}]133;C\u{07}ok\r\n")
+        await engine.resize(newColumns: 30, newRows: 4)
+
+        let output = await engine.takeSemanticCommandOutput(maxCharacters: 1_000)
+        XCTAssertNil(output)
+    }
+
+    // MARK: - Zones
+
+    /// Two finished commands and a fresh prompt on a three-row screen:
+    /// prompts on lines 0, 6 and 8, the second command's output on line 7.
+    private func feedTwoCommands(_ engine: TerminalEngine) async {
+        await feed(engine, "\u{1B}]133;A\u{07}$ seq\r\n\u{1B}]133;C\u{07}")
+        for line in 0..<5 {
+            await feed(engine, "\(line)\r\n")
+        }
+        await feed(engine, "\u{1B}]133;D;0\u{07}\u{1B}]133;A\u{07}$ echo x\r\n\u{1B}]133;C\u{07}x\r\n")
+        await feed(engine, "\u{1B}]133;D;0\u{07}\u{1B}]133;A\u{07}$ ")
+    }
+
+    func testJumpBetweenPrompts() async {
+        let engine = TerminalEngine(columns: 20, rows: 3, maxScrollbackLines: 100)
+        await feedTwoCommands(engine)
+
+        let previous = await engine.promptScrollOffset(from: 0, direction: -1)
+        XCTAssertEqual(previous, 6, "Line 6 is already at the top, so the jump goes to line 0")
+        let beforeFirst = await engine.promptScrollOffset(from: 6, direction: -1)
+        XCTAssertNil(beforeFirst)
+        let next = await engine.promptScrollOffset(from: 6, direction: 1)
+        XCTAssertEqual(next, 0)
+        let pastBottom = await engine.promptScrollOffset(from: 0, direction: 1)
+        XCTAssertNil(pastBottom)
+    }
+
+    func testLastCommandOutput() async {
+        let engine = TerminalEngine(columns: 20, rows: 3, maxScrollbackLines: 100)
+        await feedTwoCommands(engine)
+
+        let output = await engine.lastCommandOutput(maxCharacters: 1_000)
+        XCTAssertEqual(output?.text, "x")
+        XCTAssertEqual(output?.scrollOffset, 0)
+    }
+
+    func testResizeDropsZones() async {
+        let engine = TerminalEngine(columns: 20, rows: 3, maxScrollbackLines: 100)
+        await feedTwoCommands(engine)
+        await engine.resize(newColumns: 30, newRows: 4)
+
+        let previous = await engine.promptScrollOffset(from: 0, direction: -1)
+        XCTAssertNil(previous)
+        let output = await engine.lastCommandOutput(maxCharacters: 1_000)
+        XCTAssertNil(output)
+    }
+
+    // MARK: - Visible Text Changes
+
+    func testVisibleTextChangesReportOnlyRowsChangedSinceVersion() async {
+        let engine = TerminalEngine(columns: 20, rows: 3, maxScrollbackLines: 100)
+        await feed(engine, "first\r\nsecond")
+
+        let initial = await engine.visibleTextChanges(since: 0)
+        XCTAssertEqual(initial.lines, ["first", "second", ""])
+        XCTAssertTrue(initial.isComplete)
+        let unchanged = await engine.visibleTextChanges(since: initial.version)
+        XCTAssertFalse(unchanged.hasChanges)
+        XCTAssertEqual(unchanged.version, initial.version)
+
+        await feed(engine, "\r\nthird")
+        let updated = await engine.visibleTextChanges(since: initial.version)
+        XCTAssertEqual(updated.lines, ["first", "second", "third"])
+        XCTAssertEqual(updated.changedRows, [2])
+        XCTAssertFalse(updated.isComplete)
+        let full = await engine.visibleText()
+        XCTAssertEqual(updated.lines, full)
+    }
+
+    func testVisibleTextConsumersTrackTheirOwnVersions() async {
+        let engine = TerminalEngine(columns: 20, rows: 3, maxScrollbackLines: 100)
+        await feed(engine, "one")
+        let early = await engine.visibleTextChanges(since: 0).version
+
+        await feed(engine, "\r\ntwo")
+        let middle = await engine.visibleTextChanges(since: early).version
+        await feed(engine, "\r\nthree")
+
+        let fromEarly = await engine.visibleTextChanges(since: early)
+        let fromMiddle = await engine.visibleTextChanges(since: middle)
+        XCTAssertEqual(fromEarly.changedRows, [1, 2])
+        XCTAssertEqual(fromMiddle.changedRows, [2])
+        XCTAssertEqual(fromEarly.version, fromMiddle.version)
+    }
+
+    func testRedrawingTheSameTextKeepsRowVersions() async {
+        let engine = TerminalEngine(columns: 20, rows: 3, maxScrollbackLines: 100)
+        await feed(engine, "same")
+        let version = await engine.visibleTextChanges(since: 0).version
+
+        await feed(engine, "\r\u{1B}[2Ksame")
+        let changes = await engine.visibleTextChanges(since: version)
+        XCTAssertFalse(changes.hasChanges)
+    }
+
+    func testResizeMakesTheNextChangesComplete() async {
+        let engine = TerminalEngine(columns: 20, rows: 3, maxScrollbackLines: 100)
+        await feed(engine, "line")
+        let version = await engine.visibleTextChanges(since: 0).version
+
+        await engine.resize(newColumns: 20, newRows: 4)
+        let changes = await engine.visibleTextChanges(since: version)
+        XCTAssertTrue(changes.isComplete)
+        XCTAssertEqual(changes.changedRows, [0, 1, 2, 3])
+    }
+}
+#endif
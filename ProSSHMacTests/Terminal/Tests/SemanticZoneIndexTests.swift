@@ -0,0 +1,110 @@
+// SemanticZoneIndexTests.swift
+// ProSSHV2
+//
+// OSC 133 prompt and output positions: recording, prompt redraws, lookups
+// before and after a line, eviction, and reset on a new rewrite epoch.
+
+#if canImport(XCTest)
+import XCTest
+@testable import ProSSHMac
+
+final class SemanticZoneIndexTests: XCTestCase {
+
+    private func makeIndex(prompts: [Int]) -> SemanticZoneIndex {
+        var index = SemanticZoneIndex()
+        for prompt in prompts {
+            index.notePrompt(line: prompt, epoch: 0)
+            index.noteOutputStart(line: prompt + 1, epoch: 0)
+            index.noteOutputEnd(line: prompt + 3, epoch: 0)
+        }
+        return index
+    }
+
+    // MARK: - Recording
+
+    func testPromptAndOutputAreRecorded() {
+        let index = makeIndex(prompts: [0, 10])
+        XCTAssertEqual(index.liveZones.map(\.promptLine), [0, 10])
+        XCTAssertEqual(index.liveZones.last?.outputStart, 11)
+        XCTAssertEqual(index.lastCompletedOutput, 11..<13)
+    }
+
+    func testLastCompletedOutputSkipsRunningCommand() {
+        var index = makeIndex(prompts: [0])
+        index.notePrompt(line: 5, epoch: 0)
+        index.noteOutputStart(line: 6, epoch: 0)
+        XCTAssertEqual(index.lastCompletedOutput, 1..<3)
+    }
+
+    func testRedrawnPromptReplacesLaterZones() {
+        var index = makeIndex(prompts: [0, 10, 20])
+        index.notePrompt(line: 10, epoch: 0)
+        XCTAssertEqual(index.liveZones.map(\.promptLine), [0, 10])
+        XCTAssertNil(index.liveZones.last?.outputStart)
+    }
+
+    func testOutputWithoutPromptStartsAZone() {
+        var index = SemanticZoneIndex()
+        index.noteOutputStart(line: 4, epoch: 0)
+        index.noteOutputEnd(line: 7, epoch: 0)
+        XCTAssertEqual(index.liveZones.map(\.promptLine), [4])
+        XCTAssertEqual(index.lastCompletedOutput, 4..<7)
+    }
+
+    func testNewEpochStartsOver() {
+        var index = makeIndex(prompts: [0, 10])
+        index.notePrompt(line: 3, epoch: 1)
+        XCTAssertEqual(index.epoch, 1)
+        XCTAssertEqual(index.liveZones.map(\.promptLine), [3])
+    }
+
+    // MARK: - Lookup
+
+    func testPreviousAndNextPrompt() {
+        let index = makeIndex(prompts: [0, 10, 20])
+        XCTAssertEqual(index.previousPrompt(before: 10), 0)
+        XCTAssertEqual(index.previousPrompt(before: 15), 10)
+        XCTAssertNil(index.previousPrompt(before: 0))
+        XCTAssertEqual(index.nextPrompt(after: 10), 20)
+        XCTAssertEqual(index.nextPrompt(after: 9), 10)
+        XCTAssertNil(index.nextPrompt(after: 20))
+    }
+
+    // MARK: - Eviction
+
+    func testDroppedLinesAreForgotten() {
+        var index = makeIndex(prompts: Array(stride(from: 0, to: 2_000, by: 10)))
+        index.dropLines(before: 1_500)
+        XCTAssertEqual(index.count, 50)
+        XCTAssertEqual(index.liveZones.first?.promptLine, 1_500)
+        XCTAssertNil(index.previousPrompt(before: 1_500))
+        XCTAssertEqual(index.previousPrompt(before: 1_505), 1_500)
+    }
+
+    // MARK: - Folding
+
+    func testReplacedLinesAreRenumbered() {
+        var index = makeIndex(prompts: [0, 10])
+        // The first output (lines 1..<3) folds to one summary line.
+        index.replaceLines(1..<3, withCount: 1, epoch: 4)
+        XCTAssertEqual(index.epoch, 4)
+        XCTAssertEqual(index.liveZones.map(\.promptLine), [0, 9])
+        XCTAssertEqual(index.liveZones.first?.outputStart, 1)
+        XCTAssertEqual(index.liveZones.first?.outputEnd, 2)
+        XCTAssertEqual(index.lastCompletedOutput, 10..<12)
+
+        index.replaceLines(1..<2, withCount: 2, epoch: 5)
+        XCTAssertEqual(index.liveZones.map(\.promptLine), [0, 10])
+        XCTAssertEqual(index.liveZones.first?.outputEnd, 3)
+    }
+
+    func testJustCompletedOutputStopsAtTheLastCommand() {
+        var index = makeIndex(prompts: [0])
+        index.notePrompt(line: 5, epoch: 0)
+        XCTAssertEqual(index.justCompletedOutput, 1..<3, "A bare prompt follows the command")
+        index.noteOutputStart(line: 6, epoch: 0)
+        XCTAssertNil(index.justCompletedOutput, "The newest command is still running")
+        XCTAssertEqual(index.lastCompletedOutput, 1..<3)
+    }
+}
+#endif
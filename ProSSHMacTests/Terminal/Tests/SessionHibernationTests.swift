@@ -0,0 +1,92 @@
+// SessionHibernationTests.swift
+// ProSSHV2
+//
+// When idle hidden sessions hibernate, what hibernation releases, and
+// waking on reveal with output that arrived meanwhile.
+
+#if canImport(XCTest)
+import XCTest
+@testable import ProSSHMac
+
+final class SessionHibernationTests: XCTestCase {
+
+    // MARK: - Policy
+
+    func testOnlyHiddenSessionsIdlePastTheIntervalHibernate() {
+        let policy = SessionHibernationPolicy(idleInterval: 600)
+        let lastActivity = Date(timeIntervalSince1970: 1_700_000_000)
+
+        XCTAssertFalse(policy.shouldHibernate(tier: .hidden, lastActivityAt: lastActivity, now: lastActivity.addingTimeInterval(599)))
+        XCTAssertTrue(policy.shouldHibernate(tier: .hidden, lastActivityAt: lastActivity, now: lastActivity.addingTimeInterval(600)))
+        XCTAssertFalse(policy.shouldHibernate(tier: .visible, lastActivityAt: lastActivity, now: lastActivity.addingTimeInterval(3_600)))
+    }
+
+    // MARK: - Coordinator
+
+    @MainActor
+    func testHiddenSessionHibernatesAndWakesWithOutputFromMeanwhile() async {
+        let manager = SessionManager(
+            transport: MockSSHTransport(),
+            knownHostsStore: InMemoryKnownHostsStore()
+        )
+        await manager.injectScreenshotSessions()
+        guard let session = manager.sessions.first,
+              let engine = manager.engines[session.id] else {
+            XCTFail("Expected an injected session with an engine")
+            return
+        }
+        let coordinator = manager.renderingCoordinator
+        let pane = UUID()
+        await coordinator.publishGridState(for: session.id, engine: engine)
+
+        manager.setRenderTier(.hidden, for: session.id, surfaceID: pane)
+        await coordinator.hibernateIdleSessions()
+        XCTAssertFalse(coordinator.hibernatedSessionIDs.contains(session.id), "Not idle long enough yet")
+
+        await coordinator.hibernateIdleSessions(now: .now.addingTimeInterval(SessionHibernationPolicy.defaultIdleInterval + 1))
+        XCTAssertTrue(coordinator.hibernatedSessionIDs.contains(session.id))
+        let footprint = await engine.memoryFootprint
+        XCTAssertEqual(footprint[.snapshots], 0)
+
+        // Output keeps parsing; only housekeeping is published.
+        let stored = manager.gridSnapshot(for: session.id)
+        let marker = "PROSSH_HIBERNATED_\(UUID().uuidString.prefix(8))"
+        _ = await engine.feed(Data("\r\n\(marker)\r\n".utf8))
+        await coordinator.publishGridState(for: session.id, engine: engine)
+        XCTAssertEqual(manager.gridSnapshot(for: session.id)?.cellStorageAddress, stored?.cellStorageAddress)
+        XCTAssertTrue(manager.shellBuffers[session.id, default: []].joined(separator: "\n").contains(marker))
+
+        manager.setRenderTier(.focused, for: session.id, surfaceID: pane)
+        XCTAssertFalse(coordinator.hibernatedSessionIDs.contains(session.id))
+        for _ in 0..<50 where manager.gridSnapshot(for: session.id)?.cellStorageAddress == stored?.cellStorageAddress {
+            try? await Task.sleep(for: .milliseconds(10))
+        }
+        let woken = manager.gridSnapshot(for: session.id)
+        XCTAssertNotEqual(woken?.cellStorageAddress, stored?.cellStorageAddress)
+        XCTAssertNil(woken?.dirtyRange, "The first snapshot after waking is a full one")
+    }
+
+    @MainActor
+    func testForcedHibernationSkipsVisibleSessions() async {
+        let manager = SessionManager(
+            transport: MockSSHTransport(),
+            knownHostsStore: InMemoryKnownHostsStore()
+        )
+        await manager.injectScreenshotSessions()
+        guard let session = manager.sessions.first else {
+            XCTFail("Expected at least one injected session")
+            return
+        }
+        let coordinator = manager.renderingCoordinator
+
+        manager.setRenderTier(.visible, for: session.id, surfaceID: UUID())
+        await coordinator.hibernateIdleSessions(force: true)
+        XCTAssertFalse(coordinator.hibernatedSessionIDs.contains(session.id))
+
+        manager.setRenderTier(.hidden, for: session.id, surfaceID: UUID())
+        XCTAssertEqual(coordinator.renderTier(for: session.id), .visible)
+        await coordinator.hibernateIdleSessions(force: true)
+        XCTAssertFalse(coordinator.hibernatedSessionIDs.contains(session.id))
+    }
+}
+#endif
@@ -12,59 +12,77 @@ final class SessionKeepaliveCoordinatorTests: XCTestCase {
         UserDefaults.standard.removeObject(forKey: intervalKey)
     }
 
-    // MARK: - Tests
+    // MARK: - Coordinator
 
-    func testStartIfNeededDoesNotStartTaskWhenKeepaliveDisabled() {
+    func testStartIfNeededDoesNotCreateSchedulerWhenKeepaliveDisabled() {
         UserDefaults.standard.set(false, forKey: enabledKey)
         let coordinator = SessionKeepaliveCoordinator()
 
-        coordinator.startIfNeeded()
+        coordinator.startIfNeeded(sessionID: UUID(), hostKey: "example.com:22")
 
-        XCTAssertNil(coordinator.keepaliveTask,
-                     "keepaliveTask should remain nil when keepalive is disabled")
+        XCTAssertNil(coordinator.scheduler,
+                     "scheduler should remain nil when keepalive is disabled")
     }
 
-    func testStartIfNeededStartsTaskWhenEnabled() {
+    func testStartIfNeededWithoutManagerDoesNotCreateScheduler() {
         UserDefaults.standard.set(true, forKey: enabledKey)
         let coordinator = SessionKeepaliveCoordinator()
 
-        coordinator.startIfNeeded()
+        coordinator.startIfNeeded(sessionID: UUID(), hostKey: "example.com:22")
 
-        XCTAssertNotNil(coordinator.keepaliveTask,
-                        "keepaliveTask should be non-nil when keepalive is enabled")
-        coordinator.keepaliveTask?.cancel()
-        coordinator.keepaliveTask = nil
+        XCTAssertNil(coordinator.scheduler,
+                     "scheduler needs the manager's transport to probe")
     }
 
-    func testStopIfIdleWithNilManagerCancelsTask() {
-        UserDefaults.standard.set(true, forKey: enabledKey)
-        let coordinator = SessionKeepaliveCoordinator()
-        coordinator.startIfNeeded()
-        XCTAssertNotNil(coordinator.keepaliveTask)
+    // MARK: - Scheduler
 
-        // manager is nil (not set) — stopIfIdle should cancel the task
-        coordinator.stopIfIdle()
+    func testTrackArmsSchedulerAndUntrackStopsIt() async {
+        let scheduler = makeScheduler(interval: 30)
+        let sessionID = UUID()
 
-        XCTAssertNil(coordinator.keepaliveTask,
-                     "keepaliveTask should be cancelled when manager is nil")
+        await scheduler.track(sessionID, hostKey: "example.com:22")
+        let tracked = await scheduler.trackedSessionIDs
+        let armed = await scheduler.isRunning
+        XCTAssertEqual(tracked, [sessionID])
+        XCTAssertTrue(armed)
+
+        await scheduler.untrack(sessionID)
+        let remaining = await scheduler.trackedSessionIDs
+        let stillArmed = await scheduler.isRunning
+        XCTAssertTrue(remaining.isEmpty)
+        XCTAssertFalse(stillArmed, "an empty wheel should not keep a sleeper")
     }
 
-    func testIntervalDefaultsTo30WhenNotSet() {
-        // keepaliveInterval is private — test indirectly by confirming the task starts
-        // (implying interval > 0, which triggers the guard in startIfNeeded).
-        // No UserDefaults interval key set → defaults to 30 seconds internally.
-        UserDefaults.standard.set(true, forKey: enabledKey)
-        UserDefaults.standard.removeObject(forKey: intervalKey)
-        let coordinator = SessionKeepaliveCoordinator()
+    func testIntervalUsesConfiguredValueWithoutObservations() async {
+        let scheduler = makeScheduler(interval: 45)
+
+        let interval = await scheduler.interval(forHost: "example.com:22")
+
+        XCTAssertEqual(interval, 45)
+    }
+
+    func testAdaptedIntervalHalvesObservedIdleTimeout() {
+        XCTAssertEqual(SessionKeepaliveScheduler.adaptedInterval(configured: 60, observedIdleTimeout: 50), 25)
+    }
+
+    func testAdaptedIntervalNeverExceedsConfiguredValue() {
+        XCTAssertEqual(SessionKeepaliveScheduler.adaptedInterval(configured: 30, observedIdleTimeout: 600), 30)
+    }
+
+    func testAdaptedIntervalRespectsMinimum() {
+        let minimum = SessionKeepaliveScheduler.minimumInterval
+        XCTAssertEqual(SessionKeepaliveScheduler.adaptedInterval(configured: 30, observedIdleTimeout: 4), minimum)
+        XCTAssertEqual(SessionKeepaliveScheduler.adaptedInterval(configured: 1, observedIdleTimeout: nil), minimum)
+    }
 
-        coordinator.startIfNeeded()
+    // MARK: - Helpers
 
-        // If interval were 0 or negative the keepalive logic would still create the task —
-        // the key assertion is that startIfNeeded does not throw or crash with no stored interval.
-        XCTAssertNotNil(coordinator.keepaliveTask,
-                        "Task should start even when no interval is stored (defaults to 30)")
-        coordinator.keepaliveTask?.cancel()
-        coordinator.keepaliveTask = nil
+    private func makeScheduler(interval: Int) -> SessionKeepaliveScheduler {
+        SessionKeepaliveScheduler(
+            configuredInterval: { interval },
+            probe: { _, _ in .probed },
+            onDeadPeer: { _ in }
+        )
     }
 }
 
@@ -0,0 +1,114 @@
+// SessionLiveStateTests.swift
+// ProSSHV2
+//
+// Tests for per-session observable state: a change to one session only
+// invalidates reads of that session, unchanged writes invalidate nothing,
+// and traffic reaches views at the sample rate.
+
+#if canImport(XCTest)
+import XCTest
+import Observation
+@testable import ProSSHMac
+
+@MainActor
+final class SessionLiveStateTests: XCTestCase {
+
+    // MARK: - Helpers
+
+    private func makeManager() -> SessionManager {
+        SessionManager(transport: MockSSHTransport(), knownHostsStore: InMemoryKnownHostsStore())
+    }
+
+    /// Whether `mutation` invalidates what `read` observed.
+    private func invalidates(_ read: () -> Void, by mutation: () -> Void) -> Bool {
+        var changed = false
+        withObservationTracking(read) { changed = true }
+        mutation()
+        return changed
+    }
+
+    // MARK: - Tests
+
+    func testChangesToOneSessionDoNotInvalidateAnother() {
+        let manager = makeManager()
+        let shown = UUID()
+        let busy = UUID()
+        manager.liveState(for: shown).gridSnapshotNonce = 0
+
+        let invalidated = invalidates({
+            _ = manager.liveState(for: shown).gridSnapshotNonce
+        }, by: {
+            manager.liveState(for: busy).gridSnapshotNonce = 5
+            manager.liveState(for: busy).shellBuffer = ["output"]
+        })
+
+        XCTAssertFalse(invalidated)
+    }
+
+    func testChangingTheReadPropertyInvalidates() {
+        let manager = makeManager()
+        let sessionID = UUID()
+
+        let invalidated = invalidates({
+            _ = manager.liveState(for: sessionID).gridSnapshotNonce
+        }, by: {
+            manager.gridSnapshotNonceBySessionID[sessionID, default: 0] += 1
+        })
+
+        XCTAssertTrue(invalidated)
+        XCTAssertEqual(manager.gridSnapshotNonceBySessionID[sessionID], 1)
+    }
+
+    func testUnchangedWritesDoNotInvalidate() {
+        let manager = makeManager()
+        let sessionID = UUID()
+        let live = manager.liveState(for: sessionID)
+        live.scrollState = TerminalScrollState(scrollOffset: 2, scrollbackCount: 10, visibleRows: 24)
+
+        let invalidated = invalidates({
+            _ = live.scrollState
+        }, by: {
+            live.update(\.scrollState, to: TerminalScrollState(scrollOffset: 2, scrollbackCount: 10, visibleRows: 24))
+            manager.scrollStateBySessionID = manager.scrollStateBySessionID
+        })
+
+        XCTAssertFalse(invalidated)
+    }
+
+    func testDictionarySetterClearsRemovedKeys() {
+        let manager = makeManager()
+        let first = UUID()
+        let second = UUID()
+        manager.windowTitleBySessionID = [first: "vim", second: "top"]
+
+        manager.windowTitleBySessionID.removeValue(forKey: first)
+
+        XCTAssertNil(manager.liveState(for: first).windowTitle)
+        XCTAssertEqual(manager.windowTitleBySessionID, [second: "top"])
+    }
+
+    func testTrafficIsExactButSampledForViews() async throws {
+        let manager = makeManager()
+        let sessionID = UUID()
+        let live = manager.liveState(for: sessionID)
+
+        let invalidated = invalidates({
+            _ = live.sampledTraffic
+        }, by: {
+            for _ in 0..<100 {
+                live.addReceivedBytes(1024)
+            }
+            live.addSentBytes(3)
+        })
+
+        XCTAssertFalse(invalidated)
+        XCTAssertEqual(manager.bytesReceivedBySessionID[sessionID], 102_400)
+        XCTAssertEqual(manager.totalTraffic(for: sessionID).received, 0)
+
+        try await Task.sleep(for: SessionLiveState.trafficSampleInterval * 3)
+
+        XCTAssertEqual(live.sampledTraffic, SessionTraffic(received: 102_400, sent: 3))
+        XCTAssertEqual(manager.totalTraffic(for: sessionID).sent, 3)
+    }
+}
+#endif
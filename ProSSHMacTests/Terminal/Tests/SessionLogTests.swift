@@ -0,0 +1,121 @@
+// SessionLogTests.swift
+// ProSSHV2
+//
+// Continuous session logs: queued output reaches an encrypted segment,
+// a full queue drops and says so, and logs are read back by time range
+// and by text.
+
+#if canImport(XCTest)
+import CryptoKit
+import XCTest
+@testable import ProSSHMac
+
+final class SessionLogTests: XCTestCase {
+
+    private static let key = SymmetricKey(size: .bits256)
+
+    // MARK: - Writing
+
+    func testQueuedOutputIsWrittenToAnEncryptedSegment() throws {
+        let archive = makeArchive(suffix: "write")
+        let origin = makeOrigin()
+        let sink = archive.open(origin)
+
+        sink.append(Data("$ uname\r\nDarwin\r\n".utf8))
+        sink.finish()
+        XCTAssertFalse(archive.drainAll())
+
+        let segments = archive.segments(sessionID: origin.sessionID)
+        XCTAssertEqual(segments.count, 1)
+        let raw = try Data(contentsOf: segments[0])
+        XCTAssertTrue(raw.starts(with: Data("PSSHREC2".utf8)))
+        XCTAssertNil(raw.range(of: Data("Darwin".utf8)), "Output is encrypted")
+
+        let reader = try SessionRecordingFileReader(url: segments[0], makeKey: { _ in Self.key })
+        XCTAssertEqual(reader.header.sessionID, origin.sessionID)
+        XCTAssertEqual(try reader.next()?.text, "$ uname\r\nDarwin\r\n")
+        XCTAssertNil(try reader.next())
+    }
+
+    func testFullQueueDropsOutputAndMarksTheGap() throws {
+        let archive = makeArchive(suffix: "drop")
+        let origin = makeOrigin()
+        let sink = archive.open(origin)
+
+        sink.append(Data(repeating: 0x41, count: SessionLogSink.capacityBytes))
+        sink.append(Data("lost".utf8))
+        XCTAssertEqual(sink.queuedByteCount, SessionLogSink.capacityBytes)
+        sink.finish()
+        archive.drainAll()
+
+        let reader = try SessionRecordingFileReader(
+            url: try XCTUnwrap(archive.segments(sessionID: origin.sessionID).first),
+            makeKey: { _ in Self.key }
+        )
+        XCTAssertEqual(try reader.next()?.text.contains("4 bytes of output missing"), true)
+        XCTAssertEqual(try reader.next()?.payload.count, SessionLogSink.capacityBytes)
+    }
+
+    func testAppendAfterFinishIsIgnored() {
+        let sink = SessionLogSink(origin: makeOrigin())
+        sink.finish()
+        sink.append(Data("late".utf8))
+        XCTAssertEqual(sink.queuedByteCount, 0)
+    }
+
+    // MARK: - Reading
+
+    func testTranscriptCoversTheRequestedTimeRange() throws {
+        let archive = makeArchive(suffix: "transcript")
+        let origin = makeOrigin()
+        let sink = archive.open(origin)
+        let start = Date()
+
+        sink.append(Data("make\r\n".utf8))
+        sink.append(Data("done\r\n".utf8))
+        sink.finish()
+        archive.drainAll()
+
+        let all = try archive.transcript(sessionID: origin.sessionID, from: start.addingTimeInterval(-1), to: Date().addingTimeInterval(1))
+        XCTAssertEqual(String(decoding: all, as: UTF8.self), "make\r\ndone\r\n")
+        XCTAssertTrue(try archive.transcript(sessionID: origin.sessionID, from: Date().addingTimeInterval(60), to: Date().addingTimeInterval(120)).isEmpty)
+    }
+
+    func testSearchFindsLinesWithoutEscapeSequences() {
+        let archive = makeArchive(suffix: "search")
+        let origin = makeOrigin()
+        let sink = archive.open(origin)
+
+        sink.append(Data("\u{1B}[1;31mError:\u{1B}[0m disk ".utf8))
+        sink.append(Data("full\r\nok\r\n".utf8))
+        sink.finish()
+        archive.drainAll()
+
+        let matches = archive.search("DISK FULL")
+        XCTAssertEqual(matches.map(\.line), ["Error: disk full"])
+        XCTAssertEqual(matches.first?.sessionID, origin.sessionID)
+        XCTAssertEqual(matches.first?.hostLabel, "prod")
+        XCTAssertTrue(archive.search("missing").isEmpty)
+    }
+
+    func testPlainTextDropsOSCAndControlCharacters() {
+        let bytes = Array("\u{1B}]0;title\u{07}a\u{08}b\tc\r".utf8)
+        XCTAssertEqual(SessionLogArchive.plainText(bytes), "ab\tc")
+    }
+
+    // MARK: - Helpers
+
+    private func makeArchive(suffix: String) -> SessionLogArchive {
+        let directory = FileManager.default.temporaryDirectory
+            .appendingPathComponent("SessionLogTests-\(suffix)-\(UUID().uuidString)", isDirectory: true)
+        addTeardownBlock {
+            try? FileManager.default.removeItem(at: directory)
+        }
+        return SessionLogArchive(directoryURL: directory, makeKey: { _ in Self.key })
+    }
+
+    private func makeOrigin() -> SessionLogSink.Origin {
+        SessionLogSink.Origin(sessionID: UUID(), hostLabel: "prod", username: "deploy", hostname: "prod.example.com", port: 22)
+    }
+}
+#endif
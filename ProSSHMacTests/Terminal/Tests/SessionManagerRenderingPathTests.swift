@@ -956,7 +956,7 @@ final class SessionManagerRenderingPathTests: XCTestCase {
     }
 }
 
-private actor InMemoryKnownHostsStore: KnownHostsStoreProtocol {
+actor InMemoryKnownHostsStore: KnownHostsStoreProtocol {
     func allEntries() async throws -> [KnownHostEntry] { [] }
 
     func evaluate(
@@ -74,6 +74,60 @@ final class SessionManagerSFTPSidebarTests: XCTestCase {
         }
     }
 
+    func testRemoteDirectoryPagesServeCachedListingWhileMtimeIsUnchanged() async throws {
+        let entries: [SFTPDirectoryEntry] = [
+            .init(path: "/srv/app", name: "app", isDirectory: true, size: 0, permissions: 0o755, modifiedAt: nil),
+        ]
+        let transport = SidebarSFTPTransportStub(listResponsesByPath: ["/srv": entries])
+        await transport.setDirectoryModifiedAt(Date(timeIntervalSince1970: 100), for: "/srv")
+        let manager = SessionManager(
+            transport: transport,
+            knownHostsStore: SidebarKnownHostsStore()
+        )
+        manager.sftpCoordinator.directoryCacheFreshness = 0
+
+        let session = try await manager.connect(to: makeHost())
+        defer {
+            Task { @MainActor in
+                await manager.disconnect(sessionID: session.id)
+            }
+        }
+
+        func listed() async throws -> [SFTPDirectoryEntry] {
+            var collected: [SFTPDirectoryEntry] = []
+            for try await page in try await manager.remoteDirectoryPages(sessionID: session.id, path: "/srv") {
+                collected.append(contentsOf: page)
+            }
+            return collected
+        }
+
+        XCTAssertEqual(try await listed(), entries)
+        XCTAssertEqual(try await listed(), entries)
+        var calls = await transport.capturedListCalls()
+        XCTAssertEqual(calls, ["/srv"])
+        XCTAssertEqual(manager.cachedRemoteDirectory(sessionID: session.id, path: "/srv"), entries)
+
+        await transport.setDirectoryModifiedAt(Date(timeIntervalSince1970: 200), for: "/srv")
+        XCTAssertEqual(try await listed(), entries)
+        calls = await transport.capturedListCalls()
+        XCTAssertEqual(calls, ["/srv", "/srv"])
+    }
+
+    func testDisconnectDropsTheDirectoryCache() async throws {
+        let transport = SidebarSFTPTransportStub(listResponsesByPath: ["/var": []])
+        let manager = SessionManager(
+            transport: transport,
+            knownHostsStore: SidebarKnownHostsStore()
+        )
+        let session = try await manager.connect(to: makeHost())
+
+        _ = try await manager.listRemoteDirectory(sessionID: session.id, path: "/var")
+        XCTAssertNotNil(manager.cachedRemoteDirectory(sessionID: session.id, path: "/var"))
+
+        await manager.disconnect(sessionID: session.id)
+        XCTAssertNil(manager.cachedRemoteDirectory(sessionID: session.id, path: "/var"))
+    }
+
     private func makeHost() -> ProSSHMac.Host {
         ProSSHMac.Host(
             id: UUID(),
@@ -122,6 +176,7 @@ private actor SidebarSFTPTransportStub: SSHTransporting {
     private var listResponsesByPath: [String: [SFTPDirectoryEntry]]
     private var listErrorsByPath: [String: SSHTransportError]
     private var listCalls: [String] = []
+    private var modificationTimesByPath: [String: Date] = [:]
 
     init(
         listResponsesByPath: [String: [SFTPDirectoryEntry]] = [:],
@@ -169,6 +224,13 @@ private actor SidebarSFTPTransportStub: SSHTransporting {
         return listResponsesByPath[path] ?? []
     }
 
+    func modificationTime(sessionID: UUID, path: String) async throws -> Date? {
+        guard authenticatedSessionIDs.contains(sessionID) else {
+            throw SSHTransportError.sessionNotFound
+        }
+        return modificationTimesByPath[path]
+    }
+
     func uploadFile(sessionID: UUID, localPath: String, remotePath: String) async throws -> SFTPTransferResult {
         guard authenticatedSessionIDs.contains(sessionID) else {
             throw SSHTransportError.sessionNotFound
@@ -190,8 +252,8 @@ private actor SidebarSFTPTransportStub: SSHTransporting {
         return SidebarSFTPForwardChannel()
     }
 
-    func sendKeepalive(sessionID: UUID) async -> Bool {
-        connectedSessionIDs.contains(sessionID)
+    func sendKeepalive(sessionID: UUID, deadPeerTimeout: Int) async -> SSHKeepaliveResult {
+        connectedSessionIDs.contains(sessionID) ? .probed : .dead
     }
 
     func disconnect(sessionID: UUID) async {
@@ -202,6 +264,10 @@ private actor SidebarSFTPTransportStub: SSHTransporting {
     func capturedListCalls() -> [String] {
         listCalls
     }
+
+    func setDirectoryModifiedAt(_ date: Date, for path: String) {
+        modificationTimesByPath[path] = date
+    }
 }
 
 private final class SidebarSFTPShellChannel: SSHShellChannel, @unchecked Sendable {
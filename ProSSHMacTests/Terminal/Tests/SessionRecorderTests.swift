@@ -1,14 +1,19 @@
 // SessionRecorderTests.swift
 // ProSSHV2
 //
-// E.3 — Unit coverage for encrypted capture, playback schedule, and .cast export.
+// E.3 — Unit coverage for encrypted capture, playback schedule, and .cast export,
+// and the streaming file format: batching, compression, torn tails, and
+// seeking through keyframes.
 
 #if canImport(XCTest)
+import CryptoKit
 import XCTest
 @testable import ProSSHMac
 
 final class SessionRecorderTests: XCTestCase {
 
+    private static let key = SymmetricKey(size: .bits256)
+
     @MainActor
     func testRecordingPersistsEncryptedPayloadWithTimestampedChunks() async throws {
         let directory = makeTempDirectory(suffix: "persist")
@@ -20,10 +25,11 @@ final class SessionRecorderTests: XCTestCase {
         try await Task.sleep(nanoseconds: 2_000_000)
         recorder.recordOutput(sessionID: session.id, text: "total 64\n")
 
-        let recordingURL = try recorder.stopRecording(sessionID: session.id)
+        let recordingURL = try await recorder.stopRecording(sessionID: session.id)
 
         let raw = try Data(contentsOf: recordingURL)
-        XCTAssertTrue(raw.starts(with: Data("PSSHENC1".utf8)))
+        XCTAssertTrue(raw.starts(with: Data("PSSHREC2".utf8)))
+        XCTAssertNil(raw.range(of: Data("total 64".utf8)), "Payloads are encrypted")
 
         let recording = try recorder.loadRecording(from: recordingURL)
         let chunks = recording.chunks
@@ -109,6 +115,204 @@ final class SessionRecorderTests: XCTestCase {
         XCTAssertEqual(event[2] as? String, "hello\n")
     }
 
+    // MARK: - Streaming Format
+
+    @MainActor
+    func testLargeRecordingRoundTripsAcrossBatches() async throws {
+        let directory = makeTempDirectory(suffix: "batches")
+        let key = Self.key
+        let recorder = SessionRecorder(recordingsDirectoryURL: directory) { _ in key }
+        let session = makeSession()
+
+        try recorder.startRecording(for: session)
+        let line = String(repeating: "build step output ", count: 8) + "\n"
+        for index in 0..<2_000 {
+            recorder.recordOutput(sessionID: session.id, text: "\(index) \(line)")
+            if index % 500 == 0 {
+                recorder.flushActiveRecordings()
+            }
+        }
+        let recordingURL = try await recorder.stopRecording(sessionID: session.id)
+
+        let recording = try recorder.loadRecording(from: recordingURL)
+        XCTAssertEqual(recording.chunks.count, 2_000)
+        XCTAssertEqual(recording.chunks.last?.text, "1999 \(line)")
+        XCTAssertEqual(recording.sessionID, session.id)
+        XCTAssertGreaterThanOrEqual(recording.endedAt, recording.startedAt)
+
+        let size = try XCTUnwrap(try FileManager.default.attributesOfItem(
+            atPath: recordingURL.path(percentEncoded: false)
+        )[.size] as? Int)
+        XCTAssertLessThan(size, 2_000 * line.utf8.count / 2, "Repetitive batches are stored as LZ4")
+    }
+
+    func testTornTailKeepsEarlierFrames() throws {
+        let directory = makeTempDirectory(suffix: "torn")
+        let url = directory.appendingPathComponent("torn.psshrec")
+        let key = Self.key
+        let header = SessionRecordingHeader(
+            id: UUID(),
+            sessionID: UUID(),
+            hostLabel: "host",
+            username: "user",
+            hostname: "example.com",
+            port: 22,
+            startedAt: Date(timeIntervalSince1970: 1_700_000_000)
+        )
+        let writer = try SessionRecordingFileWriter(url: url, header: header) { _ in key }
+        writer.append(offsetNanoseconds: 1_000_000_000, stream: .output, payload: Data("kept".utf8))
+        writer.flush()
+        writer.append(offsetNanoseconds: 2_000_000_000, stream: .output, payload: Data("also kept".utf8))
+        writer.close(endedAt: Date())
+
+        // Cut into the trailer, as if the app died while writing it.
+        let handle = try FileHandle(forUpdating: url)
+        let length = try handle.seekToEnd()
+        try handle.truncate(atOffset: length - 5)
+        try handle.close()
+
+        let recording = try SessionRecordingFileReader(url: url) { _ in key }.readAll()
+        XCTAssertEqual(recording.chunks.map(\.text), ["kept", "also kept"])
+        XCTAssertEqual(recording.endedAt, header.startedAt.addingTimeInterval(2), "Without a trailer the recording ends at its last chunk")
+    }
+
+    func testSeekLandsOnNearestKeyframe() throws {
+        let directory = makeTempDirectory(suffix: "seek")
+        let url = directory.appendingPathComponent("seek.psshrec")
+        let key = Self.key
+        let writer = try SessionRecordingFileWriter(url: url, header: makeHeader()) { _ in key }
+        writer.append(offsetNanoseconds: 1_000, stream: .output, payload: Data("one".utf8))
+        writer.appendKeyframe(offsetNanoseconds: 1_000, sequence: Array("K1".utf8))
+        writer.append(offsetNanoseconds: 2_000, stream: .output, payload: Data("two".utf8))
+        writer.appendKeyframe(offsetNanoseconds: 2_000, sequence: Array("K2".utf8))
+        writer.append(offsetNanoseconds: 3_000, stream: .output, payload: Data("three".utf8))
+        writer.close(endedAt: Date())
+
+        let reader = try SessionRecordingFileReader(url: url) { _ in key }
+        XCTAssertEqual(try reader.durationNanoseconds(), 3_000)
+
+        let keyframe = try XCTUnwrap(try reader.seek(toKeyframeAtOrBefore: 2_500))
+        XCTAssertEqual(keyframe.offsetNanoseconds, 2_000)
+        XCTAssertEqual(String(decoding: keyframe.sequence, as: UTF8.self), "K2")
+        XCTAssertEqual(try reader.next()?.text, "three")
+        XCTAssertNil(try reader.next())
+
+        XCTAssertNil(try reader.seek(toKeyframeAtOrBefore: 500))
+        XCTAssertEqual(try reader.next()?.text, "one", "Before the first keyframe, reading restarts at the beginning")
+        XCTAssertEqual(try reader.next()?.text, "two", "Keyframes are skipped when reading chunks")
+    }
+
+    @MainActor
+    func testPlaybackFromOffsetRestoresEarlierOutputFirst() async throws {
+        let directory = makeTempDirectory(suffix: "playfrom")
+        let key = Self.key
+        let recorder = SessionRecorder(recordingsDirectoryURL: directory) { _ in key }
+        let session = makeSession()
+
+        try recorder.startRecording(for: session)
+        recorder.recordOutput(sessionID: session.id, text: "first\r\n")
+        try await Task.sleep(nanoseconds: 20_000_000)
+        recorder.recordOutput(sessionID: session.id, text: "second\r\n")
+        let recordingURL = try await recorder.stopRecording(sessionID: session.id)
+        let chunks = try recorder.loadRecording(from: recordingURL).chunks
+        let start = chunks[0].offsetNanoseconds + (chunks[1].offsetNanoseconds - chunks[0].offsetNanoseconds) / 2
+
+        let collected = PlaybackCollector()
+        try await recorder.playLatestRecording(sessionID: session.id, speed: 100, from: start) { step in
+            await collected.append(step.text)
+        }
+        let texts = await collected.texts
+        XCTAssertEqual(texts, ["\u{1B}cfirst\r\n", "second\r\n"])
+    }
+
+    @MainActor
+    func testMaxSpeedPlaybackMergesChunksIntoOneStep() async throws {
+        let directory = makeTempDirectory(suffix: "maxspeed")
+        let key = Self.key
+        let recorder = SessionRecorder(recordingsDirectoryURL: directory) { _ in key }
+        let session = makeSession()
+
+        try recorder.startRecording(for: session)
+        for index in 0..<50 {
+            recorder.recordOutput(sessionID: session.id, text: "line \(index)\r\n")
+        }
+        recorder.recordInput(sessionID: session.id, text: "q")
+        try await recorder.stopRecording(sessionID: session.id)
+
+        let collected = PlaybackCollector()
+        try await recorder.playLatestRecording(sessionID: session.id, speed: SessionRecorder.maxPlaybackSpeed) { step in
+            await collected.append(step.text)
+        }
+        let texts = await collected.texts
+        XCTAssertEqual(texts, [(0..<50).map { "line \($0)\r\n" }.joined(), "q"])
+    }
+
+    @MainActor
+    func testHeadlessReplayRebuildsTerminal() async throws {
+        let directory = makeTempDirectory(suffix: "headless")
+        let key = Self.key
+        let recorder = SessionRecorder(recordingsDirectoryURL: directory) { _ in key }
+        let session = makeSession()
+
+        try recorder.startRecording(for: session, columns: 30, rows: 6)
+        recorder.recordOutput(sessionID: session.id, text: "hello\r\n")
+        recorder.recordInput(sessionID: session.id, text: "ignored")
+        recorder.recordOutput(sessionID: session.id, text: "\u{1B}[1mworld\u{1B}[0m")
+        try await recorder.stopRecording(sessionID: session.id)
+
+        let engine = try await recorder.replayLatestRecording(sessionID: session.id)
+        let grid = await engine.grid
+        XCTAssertEqual(grid.columns, 30)
+        XCTAssertEqual(grid.rows, 6)
+        XCTAssertEqual(Array(grid.visibleText().prefix(2)), ["hello", "world"])
+    }
+
+    @MainActor
+    func testLatestRecordingExportsStreamedCast() async throws {
+        let directory = makeTempDirectory(suffix: "streamcast")
+        let key = Self.key
+        let recorder = SessionRecorder(recordingsDirectoryURL: directory) { _ in key }
+        let session = makeSession()
+
+        try recorder.startRecording(for: session)
+        recorder.recordInput(sessionID: session.id, text: "uptime\n")
+        recorder.recordOutput(sessionID: session.id, text: "up 3 days\n")
+        try await recorder.stopRecording(sessionID: session.id)
+
+        let castURL = try await recorder.exportLatestRecordingAsCast(
+            sessionID: session.id,
+            destinationURL: directory.appendingPathComponent("latest.cast")
+        )
+        let lines = try String(contentsOf: castURL, encoding: .utf8)
+            .split(separator: "\n", omittingEmptySubsequences: true)
+        XCTAssertEqual(lines.count, 3)
+        let event = try XCTUnwrap(try JSONSerialization.jsonObject(with: Data(lines[2].utf8)) as? [Any])
+        XCTAssertEqual(event[1] as? String, "o")
+        XCTAssertEqual(event[2] as? String, "up 3 days\n")
+    }
+
+    // MARK: - Helpers
+
+    private actor PlaybackCollector {
+        private(set) var texts: [String] = []
+
+        func append(_ text: String) {
+            texts.append(text)
+        }
+    }
+
+    private func makeHeader() -> SessionRecordingHeader {
+        SessionRecordingHeader(
+            id: UUID(),
+            sessionID: UUID(),
+            hostLabel: "host",
+            username: "user",
+            hostname: "example.com",
+            port: 22,
+            startedAt: Date(timeIntervalSince1970: 1_700_000_000)
+        )
+    }
+
     @MainActor
     private func makeSession() -> Session {
         Session(
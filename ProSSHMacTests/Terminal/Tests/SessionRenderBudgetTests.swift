@@ -0,0 +1,69 @@
+// SessionRenderBudgetTests.swift
+// ProSSHV2
+//
+// Per-session publish budget: tier intervals, frame rates and thermal
+// scaling, and the coordinator's choice of tier across a session's panes.
+
+#if canImport(XCTest)
+import XCTest
+@testable import ProSSHMac
+
+final class SessionRenderBudgetTests: XCTestCase {
+
+    // MARK: - Intervals
+
+    func testTiersSetPublishIntervals() {
+        let base: Duration = .milliseconds(8)
+        XCTAssertEqual(SessionRenderBudget.publishInterval(base: base, tier: .focused, thermalState: .nominal), base)
+        XCTAssertEqual(SessionRenderBudget.publishInterval(base: base, tier: .visible, thermalState: .nominal), .milliseconds(33))
+        XCTAssertEqual(SessionRenderBudget.publishInterval(base: base, tier: .hidden, thermalState: .fair), .seconds(1))
+        // Debounce intervals longer than the tier floor are kept.
+        XCTAssertEqual(SessionRenderBudget.publishInterval(base: .milliseconds(40), tier: .visible, thermalState: .nominal), .milliseconds(40))
+    }
+
+    func testThermalPressureStretchesIntervals() {
+        let base: Duration = .milliseconds(8)
+        XCTAssertEqual(SessionRenderBudget.publishInterval(base: base, tier: .focused, thermalState: .serious), .milliseconds(16))
+        XCTAssertEqual(SessionRenderBudget.publishInterval(base: base, tier: .visible, thermalState: .critical), .milliseconds(132))
+    }
+
+    // MARK: - Frame Rates
+
+    func testFocusedPaneFollowsNativeRefreshUntilThrottled() {
+        XCTAssertEqual(SessionRenderBudget.preferredFPS(tier: .focused, thermalState: .nominal), 0)
+        XCTAssertEqual(SessionRenderBudget.preferredFPS(tier: .focused, thermalState: .serious), 60)
+        XCTAssertEqual(SessionRenderBudget.preferredFPS(tier: .focused, thermalState: .critical), 30)
+        XCTAssertEqual(SessionRenderBudget.preferredFPS(tier: .visible, thermalState: .nominal), 30)
+        XCTAssertEqual(SessionRenderBudget.preferredFPS(tier: .visible, thermalState: .critical), 15)
+    }
+
+    // MARK: - Coordinator
+
+    @MainActor
+    func testSessionTakesItsHighestPaneTier() async {
+        let manager = SessionManager(
+            transport: MockSSHTransport(),
+            knownHostsStore: InMemoryKnownHostsStore()
+        )
+        await manager.injectScreenshotSessions()
+        guard let session = manager.sessions.first else {
+            XCTFail("Expected at least one injected session")
+            return
+        }
+        let coordinator = manager.renderingCoordinator
+        XCTAssertEqual(coordinator.renderTier(for: session.id), .focused)
+
+        let mainPane = UUID()
+        let externalPane = UUID()
+        manager.setRenderTier(.hidden, for: session.id, surfaceID: mainPane)
+        XCTAssertEqual(coordinator.renderTier(for: session.id), .hidden)
+        manager.setRenderTier(.visible, for: session.id, surfaceID: externalPane)
+        XCTAssertEqual(coordinator.renderTier(for: session.id), .visible)
+
+        // Tiers for unknown sessions are ignored.
+        let unknown = UUID()
+        manager.setRenderTier(.hidden, for: unknown, surfaceID: mainPane)
+        XCTAssertEqual(coordinator.renderTier(for: unknown), .focused)
+    }
+}
+#endif
@@ -0,0 +1,95 @@
+// SessionResumeTests.swift
+// ProSSHV2
+//
+// Fast session resume: the saved keyframe survives compression, restoring
+// it rebuilds the dropped screen with a plain shell's modes, and the
+// multiplexer probe picks the session to reattach.
+
+#if canImport(XCTest)
+import XCTest
+@testable import ProSSHMac
+
+@MainActor
+final class SessionResumeTests: XCTestCase {
+
+    // MARK: - Helpers
+
+    private func rowText(_ grid: TerminalGrid, row: Int, count: Int) -> String {
+        var result = ""
+        for col in 0..<count {
+            let cell = grid.cellAt(row: row, col: col)
+            let ch = cell?.graphemeCluster ?? ""
+            result += ch.isEmpty ? " " : ch
+        }
+        return result
+    }
+
+    // MARK: - Tests
+
+    func testStateRoundTripsThroughCompression() {
+        let keyframe = Array(String(repeating: "\u{1B}[1;1Hprompt$ ls -la\r\n", count: 300).utf8)
+        let state = SessionResumeState(keyframe: keyframe, columns: 80, rows: 24, wasAlternateScreen: false)
+        XCTAssertTrue(state.isCompressed)
+        XCTAssertLessThan(state.storedKeyframe.count, keyframe.count)
+        XCTAssertEqual(state.keyframe, keyframe)
+
+        let tiny = SessionResumeState(keyframe: [0x41], columns: 80, rows: 24, wasAlternateScreen: false)
+        XCTAssertEqual(tiny.keyframe, [0x41])
+        XCTAssertEqual(SessionResumeState(keyframe: [], columns: 80, rows: 24, wasAlternateScreen: false).keyframe, [])
+    }
+
+    func testRestoreRebuildsScreenAndLeavesProgramModes() async {
+        let hostID = UUID()
+        let coordinator = SessionResumeCoordinator()
+
+        let dropped = TerminalEngine(columns: 40, rows: 10)
+        await dropped.feed(Array("user@host:~$ top\r\n".utf8))
+        await dropped.feed(Array("\u{1B}[?1049h\u{1B}[?1000h\u{1B}[?2004h\u{1B}[HPID USER".utf8))
+        await coordinator.capture(hostID: hostID, engine: dropped)
+
+        let fresh = TerminalEngine(columns: 80, rows: 24)
+        let restored = await coordinator.restore(hostID: hostID, into: fresh)
+        XCTAssertTrue(restored)
+
+        let grid = await fresh.grid
+        XCTAssertEqual(await fresh.columns, 40)
+        XCTAssertFalse(grid.usingAlternateBuffer, "The program that drew the alternate screen is gone")
+        XCTAssertFalse(grid.bracketedPasteMode)
+        XCTAssertEqual(rowText(grid, row: 0, count: 16), "user@host:~$ top")
+
+        // Kept for a retry until discarded.
+        XCTAssertNotNil(coordinator.statesByHostID[hostID])
+        coordinator.discard(hostID: hostID)
+        let again = await coordinator.restore(hostID: hostID, into: TerminalEngine(columns: 80, rows: 24))
+        XCTAssertFalse(again)
+    }
+
+    func testAttachCommandPrefersMostRecentDetachedTmuxSession() {
+        let output = """
+        1 1700000900 work
+        0 1700000100 old
+        0 1700000500 build's
+        --
+        There is a screen on:
+        \t1234.pts-0.host\t(Detached)
+        """
+        XCTAssertEqual(
+            SessionResumeCoordinator.attachCommand(forProbeOutput: output),
+            #"tmux attach-session -t 'build'\''s'"#
+        )
+    }
+
+    func testAttachCommandFallsBackToDetachedScreen() {
+        let output = """
+        1 1700000900 work
+        --
+        There are screens on:
+        \t4321.pts-1.host\t(Attached)
+        \t1234.pts-0.host\t(Detached)
+        2 Sockets in /run/screen/S-user.
+        """
+        XCTAssertEqual(SessionResumeCoordinator.attachCommand(forProbeOutput: output), "screen -r '1234.pts-0.host'")
+        XCTAssertNil(SessionResumeCoordinator.attachCommand(forProbeOutput: "--\nNo Sockets found in /run/screen/S-user.\n"))
+    }
+}
+#endif
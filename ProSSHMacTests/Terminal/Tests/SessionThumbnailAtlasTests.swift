@@ -0,0 +1,100 @@
+// SessionThumbnailAtlasTests.swift
+// ProSSHV2
+//
+// Thumbnail captures: the downsampled pixels come back as an image, and
+// atlas slots are borrowed per capture and handed back.
+
+#if canImport(XCTest)
+import XCTest
+import Metal
+@testable import ProSSHMac
+
+final class SessionThumbnailAtlasTests: XCTestCase {
+
+    private func makeDevice() throws -> MTLDevice {
+        guard let device = MTLCreateSystemDefaultDevice() else {
+            throw XCTSkip("No Metal device available")
+        }
+        return device
+    }
+
+    private func makePipeline(device: MTLDevice) throws -> MTLComputePipelineState {
+        guard let pipeline = try TerminalPipelineCache.shared.pipelines(for: device).thumbnailDownsample else {
+            throw XCTSkip("Thumbnail pipeline unavailable")
+        }
+        return pipeline
+    }
+
+    /// A bgra8Unorm texture filled with one color, like a scene cache.
+    private func makeSolidTexture(device: MTLDevice, blue: UInt8, green: UInt8, red: UInt8) throws -> MTLTexture {
+        let width = 800
+        let height = 500
+        let descriptor = MTLTextureDescriptor.texture2DDescriptor(
+            pixelFormat: .bgra8Unorm,
+            width: width,
+            height: height,
+            mipmapped: false
+        )
+        descriptor.usage = [.shaderRead]
+        let texture = try XCTUnwrap(device.makeTexture(descriptor: descriptor))
+        let pixels = [UInt8](repeating: 0, count: width * height * 4).enumerated().map { index, _ in
+            [blue, green, red, 255][index % 4]
+        }
+        texture.replace(
+            region: MTLRegionMake2D(0, 0, width, height),
+            mipmapLevel: 0,
+            withBytes: pixels,
+            bytesPerRow: width * 4
+        )
+        return texture
+    }
+
+    // MARK: - Capture
+
+    func testCaptureReadsBackDownsampledScene() throws {
+        let device = try makeDevice()
+        let pipeline = try makePipeline(device: device)
+        let atlas = try XCTUnwrap(SessionThumbnailAtlas(device: device))
+        let source = try makeSolidTexture(device: device, blue: 30, green: 120, red: 200)
+        let commandBuffer = try XCTUnwrap(device.makeCommandQueue()?.makeCommandBuffer())
+
+        let capture = try XCTUnwrap(atlas.encodeCapture(from: source, pipeline: pipeline, commandBuffer: commandBuffer))
+        commandBuffer.commit()
+        commandBuffer.waitUntilCompleted()
+        atlas.release(capture)
+
+        let bytes = capture.pixels.contents().assumingMemoryBound(to: UInt8.self)
+        XCTAssertEqual(Int(bytes[0]), 200, accuracy: 1)
+        XCTAssertEqual(Int(bytes[1]), 120, accuracy: 1)
+        XCTAssertEqual(Int(bytes[2]), 30, accuracy: 1)
+
+        let image = try XCTUnwrap(SessionThumbnailAtlas.makeImage(from: capture.pixels))
+        XCTAssertEqual(image.width, SessionThumbnailAtlas.slotWidth)
+        XCTAssertEqual(image.height, SessionThumbnailAtlas.slotHeight)
+    }
+
+    // MARK: - Slots
+
+    func testSlotsAreHeldUntilReleased() throws {
+        let device = try makeDevice()
+        let pipeline = try makePipeline(device: device)
+        let atlas = try XCTUnwrap(SessionThumbnailAtlas(device: device))
+        let source = try makeSolidTexture(device: device, blue: 0, green: 0, red: 0)
+        let commandBuffer = try XCTUnwrap(device.makeCommandQueue()?.makeCommandBuffer())
+
+        var captures: [SessionThumbnailAtlas.Capture] = []
+        while let capture = atlas.encodeCapture(from: source, pipeline: pipeline, commandBuffer: commandBuffer) {
+            captures.append(capture)
+        }
+        XCTAssertEqual(captures.count, 16)
+        XCTAssertEqual(Set(captures.map(\.slot)).count, 16)
+
+        atlas.release(captures[3])
+        let reused = try XCTUnwrap(atlas.encodeCapture(from: source, pipeline: pipeline, commandBuffer: commandBuffer))
+        XCTAssertEqual(reused.slot, captures[3].slot)
+
+        commandBuffer.commit()
+        commandBuffer.waitUntilCompleted()
+    }
+}
+#endif
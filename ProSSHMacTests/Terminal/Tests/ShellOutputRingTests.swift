@@ -0,0 +1,111 @@
+#if canImport(XCTest)
+import XCTest
+@testable import ProSSHMac
+
+final class ShellOutputRingTests: XCTestCase {
+
+    // MARK: - Helpers
+
+    private func drain(_ ring: ShellOutputRing) async -> [UInt8] {
+        var collected: [UInt8] = []
+        while await ring.waitForReadable() {
+            let region = ring.readableRegion
+            collected.append(contentsOf: region)
+            ring.consume(region.count)
+        }
+        return collected
+    }
+
+    // MARK: - Tests
+
+    func testCapacityRoundsUpToPowerOfTwo() {
+        XCTAssertEqual(ShellOutputRing(capacity: 5000).capacity, 8192)
+        XCTAssertEqual(ShellOutputRing(capacity: 1).capacity, 4096)
+    }
+
+    func testWriteThenReadRoundTrips() async {
+        let ring = ShellOutputRing(capacity: 4096)
+        await ring.append(Array("hello\r\n".utf8))
+        ring.finish()
+
+        let bytes = await drain(ring)
+        XCTAssertEqual(String(decoding: bytes, as: UTF8.self), "hello\r\n")
+    }
+
+    func testAppendDataAcrossWrapAroundKeepsOrder() async {
+        let ring = ShellOutputRing(capacity: 4096)
+        let payload = Data((0..<10_000).map { UInt8(truncatingIfNeeded: $0 * 7) })
+
+        let producer = Task.detached {
+            await ring.append(contentsOf: payload.subdata(in: 0..<3000))
+            await ring.append(contentsOf: payload.subdata(in: 3000..<payload.count))
+            ring.finish()
+        }
+
+        let received = await drain(ring)
+        await producer.value
+        XCTAssertEqual(Data(received), payload)
+    }
+
+    func testReadableRegionSplitsAtWrapAround() async {
+        let ring = ShellOutputRing(capacity: 4096)
+        await ring.append([UInt8](repeating: 0x41, count: 4000))
+        ring.consume(ring.readableRegion.count)
+
+        await ring.append([UInt8](repeating: 0x42, count: 200))
+        XCTAssertEqual(ring.readableCount, 200)
+        XCTAssertEqual(ring.readableRegion.count, 96)
+        ring.consume(96)
+        XCTAssertEqual(ring.readableRegion.count, 104)
+    }
+
+    func testProducerSuspendsWhenFullAndResumesOnConsume() async {
+        let ring = ShellOutputRing(capacity: 4096)
+        let payload = (0..<20_000).map { UInt8(truncatingIfNeeded: $0) }
+
+        let producer = Task.detached {
+            await ring.append(payload)
+            ring.finish()
+        }
+
+        let received = await drain(ring)
+        await producer.value
+        XCTAssertEqual(received, payload)
+    }
+
+    func testFinishReleasesParkedConsumer() async {
+        let ring = ShellOutputRing(capacity: 4096)
+        let consumer = Task.detached { await ring.waitForReadable() }
+
+        try? await Task.sleep(for: .milliseconds(10))
+        ring.finish()
+
+        let readable = await consumer.value
+        XCTAssertFalse(readable)
+    }
+
+    func testWriteAfterFinishIsRejected() async {
+        let ring = ShellOutputRing(capacity: 4096)
+        ring.finish()
+
+        let accepted = await ring.write { _ in 1 }
+        XCTAssertFalse(accepted)
+        XCTAssertEqual(ring.readableCount, 0)
+    }
+
+    func testBorrowedFeedParsesSpanInPlace() async {
+        let engine = TerminalEngine(columns: 20, rows: 4)
+        let bytes = Array("ring".utf8)
+        let storage = UnsafeMutableRawPointer.allocate(byteCount: bytes.count, alignment: 1)
+        defer { storage.deallocate() }
+        storage.copyMemory(from: bytes, byteCount: bytes.count)
+
+        let span = Data(bytesNoCopy: storage, count: bytes.count, deallocator: .none)
+        await engine.feed(borrowing: span)
+
+        let lines = await engine.visibleText()
+        XCTAssertTrue(lines.first?.hasPrefix("ring") ?? false)
+    }
+}
+
+#endif // canImport(XCTest)
@@ -0,0 +1,112 @@
+#if canImport(XCTest)
+import XCTest
+@testable import ProSSHMac
+
+final class StreamingJSONScannerTests: XCTestCase {
+
+    // MARK: - Scanner
+
+    func testScanReportsScalarsWithKeyPaths() {
+        let json = #"{"a":[1,{"b":"x\"yé😀"}],"c":true,"d":null}"#
+        var visits: [([StreamingJSONScanner.PathComponent], StreamingJSONScanner.Scalar)] = []
+
+        let isValid = StreamingJSONScanner.scan(Array(json.utf8)) { visits.append(($0, $1)) }
+
+        XCTAssertTrue(isValid)
+        XCTAssertEqual(visits.count, 4)
+        XCTAssertEqual(visits[0].0, [.key("a"), .index(0)])
+        XCTAssertEqual(visits[0].1, .number(1))
+        XCTAssertEqual(visits[1].0, [.key("a"), .index(1), .key("b")])
+        XCTAssertEqual(visits[1].1, .string("x\"yé😀"))
+        XCTAssertEqual(visits[2].1, .bool(true))
+        XCTAssertEqual(visits[3].0, [.key("d")])
+        XCTAssertEqual(visits[3].1, .null)
+    }
+
+    func testScanRejectsMalformedJSON() {
+        for json in [#"{"a":"#, #"{"a":1,}"#, #"{"a":1} x"#, #"{"a":tru}"#, ""] {
+            XCTAssertFalse(StreamingJSONScanner.scan(Array(json.utf8)) { _, _ in }, json)
+        }
+    }
+
+    func testClosureTrackerClosesOnlyAtTheOutermostBrace() {
+        var tracker = StreamingJSONScanner.ClosureTracker()
+        for fragment in [#"{"path":"/a}"#, #"\"b","opts":{"#, #""n":[1,2]}"#] {
+            tracker.feed(fragment)
+            XCTAssertFalse(tracker.isClosed)
+        }
+        tracker.feed("}")
+        XCTAssertTrue(tracker.isClosed)
+    }
+
+    // MARK: - SSE framing
+
+    func testSSEParserJoinsDataLinesUntilBlankLine() {
+        var parser = SSEEventParser()
+        var events: [SSEEventParser.Event] = []
+        for byte in Array("event: delta\r\ndata: {\"a\":\r\ndata:1}\r\n\r\n: keepalive\n{\"raw\":1}\ndata: [DONE]".utf8) {
+            if let event = parser.feed(byte) { events.append(event) }
+        }
+        if let event = parser.finish() { events.append(event) }
+
+        XCTAssertEqual(events.count, 2)
+        XCTAssertEqual(events[0].name, "delta")
+        XCTAssertEqual(String(decoding: events[0].data, as: UTF8.self), "{\"a\":\n1}")
+        XCTAssertNil(events[1].name)
+        XCTAssertTrue(events[1].isDone)
+        XCTAssertEqual(parser.nonSSELines, [#"{"raw":1}"#])
+    }
+
+    func testSSEParserCanDispatchEachDataLine() {
+        var parser = SSEEventParser(dispatchesEachDataLine: true)
+        var payloads: [String] = []
+        for byte in Array("data: {\"n\":1}\ndata: {\"n\":2}\n".utf8) {
+            if let event = parser.feed(byte) { payloads.append(String(decoding: event.data, as: UTF8.self)) }
+        }
+
+        XCTAssertEqual(payloads, [#"{"n":1}"#, #"{"n":2}"#])
+        XCTAssertNil(parser.finish())
+    }
+
+    // MARK: - Event fields
+
+    func testEventFieldsIgnoreNestedKeys() {
+        let json = #"{"type":"response.output_text.delta","item_id":"msg_1","output_index":2,"delta":"Hi","obfuscation":{"text":"nested"}}"#
+
+        let fields = StreamingEventFields.scan(Array(json.utf8))
+
+        XCTAssertEqual(fields?.type, "response.output_text.delta")
+        XCTAssertEqual(fields?.itemID, "msg_1")
+        XCTAssertEqual(fields?.outputIndex, 2)
+        XCTAssertEqual(fields?.delta, "Hi")
+        XCTAssertNil(fields?.text)
+    }
+
+    // MARK: - Chat Completions chunks
+
+    func testChatChunkScanReadsContentAndToolCallFragments() throws {
+        let json = #"{"id":"c1","choices":[{"index":0,"delta":{"reasoning_content":"think","tool_calls":[{"index":1,"id":"call_9","function":{"name":"ls","arguments":"{\"p\""}}]},"finish_reason":null}]}"#
+
+        let chunk = try XCTUnwrap(ChatCompletionsStreamChunk.scan(Array(json.utf8)))
+
+        XCTAssertEqual(chunk.choices.count, 1)
+        XCTAssertEqual(chunk.choices[0].delta.reasoning, "think")
+        XCTAssertNil(chunk.choices[0].delta.content)
+        let call = try XCTUnwrap(chunk.choices[0].delta.toolCalls?.first)
+        XCTAssertEqual(call.index, 1)
+        XCTAssertEqual(call.id, "call_9")
+        XCTAssertEqual(call.function?.name, "ls")
+        XCTAssertEqual(call.function?.arguments, #"{"p""#)
+    }
+
+    func testChatChunkScanDefersStructuredContentToDecoder() {
+        let json = #"{"choices":[{"delta":{"content":[{"type":"text","text":"hi"}]}}]}"#
+
+        XCTAssertNil(ChatCompletionsStreamChunk.scan(Array(json.utf8)))
+        XCTAssertEqual(
+            try? JSONDecoder().decode(ChatCompletionsStreamChunk.self, from: Data(json.utf8)).choices.first?.delta.content,
+            "hi"
+        )
+    }
+}
+#endif
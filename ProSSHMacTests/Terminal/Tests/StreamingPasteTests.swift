@@ -0,0 +1,247 @@
+// StreamingPasteTests.swift
+// ProSSHV2
+//
+// Streaming paste flow control: chunks wait for the channel's bulk queue to
+// drain, keystrokes go out meanwhile, a cancelled bracketed paste is
+// closed on the remote side, and Ctrl-C drops what is still queued.
+
+#if canImport(XCTest)
+import XCTest
+@testable import ProSSHMac
+
+@MainActor
+final class StreamingPasteTests: XCTestCase {
+
+    // MARK: - Helpers
+
+    private func makeConnectedSession(channel: QueueingShellChannel) async throws -> (SessionManager, UUID) {
+        let manager = SessionManager(
+            transport: MockSSHTransport(),
+            knownHostsStore: PasteTestKnownHostsStore()
+        )
+        let session = try await manager.connect(to: makeHost())
+        manager.shellChannels[session.id] = channel
+        return (manager, session.id)
+    }
+
+    private func makeHost() -> ProSSHMac.Host {
+        ProSSHMac.Host(
+            id: UUID(),
+            label: "Paste Test Host",
+            folder: nil,
+            hostname: "paste.test.local",
+            port: 22,
+            username: "ops",
+            authMethod: .password,
+            keyReference: nil,
+            certificateReference: nil,
+            passwordReference: nil,
+            jumpHost: nil,
+            algorithmPreferences: nil,
+            pinnedHostKeyAlgorithms: [],
+            agentForwardingEnabled: false,
+            legacyModeEnabled: false,
+            tags: [],
+            notes: nil,
+            lastConnected: nil,
+            createdAt: .now
+        )
+    }
+
+    private func waitUntil(_ condition: () async -> Bool) async {
+        let deadline = Date().addingTimeInterval(5)
+        while await !condition(), Date() < deadline {
+            try? await Task.sleep(for: .milliseconds(5))
+        }
+    }
+
+    // MARK: - Tests
+
+    func testPasteWaitsForQueueToDrainWhileKeystrokesGetThrough() async throws {
+        let channel = QueueingShellChannel()
+        let (manager, sessionID) = try await makeConnectedSession(channel: channel)
+        await channel.setQueuedBulkBytes(SessionShellIOCoordinator.pasteQueueHighWater + 1)
+
+        let text = String(repeating: "insert into t values (1);\n", count: 8_000)
+        let stream = PasteStream(utf8: Data(text.utf8), bracketedPasteEnabled: true)
+        manager.shellIOCoordinator.startPaste(stream, sessionID: sessionID)
+
+        try await Task.sleep(for: .milliseconds(50))
+        let bulkWhileFull = await channel.bulkBytes
+        XCTAssertEqual(bulkWhileFull, [], "Nothing is queued while the channel is backed up")
+
+        await manager.sendRawShellInputBytes(sessionID: sessionID, bytes: Array("q".utf8))
+        let interactive = await channel.interactiveBytes
+        XCTAssertEqual(interactive, Array("q".utf8))
+
+        await channel.setQueuedBulkBytes(0)
+        let expected = Array(PasteHandler.payload(for: text, bracketedPasteEnabled: true).utf8)
+        await waitUntil { await channel.bulkBytes.count >= expected.count }
+        let bulk = await channel.bulkBytes
+        XCTAssertEqual(bulk, expected)
+    }
+
+    func testCancelClosesBracketedPasteAndClearsProgress() async throws {
+        let channel = QueueingShellChannel()
+        let (manager, sessionID) = try await makeConnectedSession(channel: channel)
+        await channel.backUpAfterFirstBulkWrite()
+
+        let text = String(repeating: "x", count: 1_000_000)
+        let stream = PasteStream(utf8: Data(text.utf8), bracketedPasteEnabled: true)
+        manager.shellIOCoordinator.startPaste(stream, sessionID: sessionID)
+
+        await waitUntil { await !channel.bulkBytes.isEmpty }
+        XCTAssertNotNil(manager.liveState(for: sessionID).pasteProgress)
+
+        manager.cancelPaste(sessionID: sessionID)
+        XCTAssertNil(manager.liveState(for: sessionID).pasteProgress)
+
+        let terminator = Array("\u{1B}[201~".utf8)
+        await waitUntil { await channel.bulkBytes.suffix(terminator.count).elementsEqual(terminator) }
+        let bulk = await channel.bulkBytes
+        XCTAssertEqual(bulk.count, PasteStream.defaultChunkByteLimit + 6 + terminator.count)
+        XCTAssertEqual(Array(bulk.prefix(6)), Array("\u{1B}[200~".utf8))
+        XCTAssertTrue(bulk.suffix(terminator.count).elementsEqual(terminator))
+    }
+
+    func testInterruptDropsQueuedPasteAndFollowsTerminator() async throws {
+        let channel = QueueingShellChannel()
+        let (manager, sessionID) = try await makeConnectedSession(channel: channel)
+        await channel.backUpAfterFirstBulkWrite()
+
+        let text = String(repeating: "x", count: 1_000_000)
+        let stream = PasteStream(utf8: Data(text.utf8), bracketedPasteEnabled: true)
+        manager.shellIOCoordinator.startPaste(stream, sessionID: sessionID)
+        await waitUntil { await !channel.bulkBytes.isEmpty }
+
+        await manager.sendRawShellInputBytes(sessionID: sessionID, bytes: [0x03])
+
+        let expectedTail = Array("\u{1B}[201~".utf8) + [0x03]
+        await waitUntil { await channel.bulkBytes.suffix(expectedTail.count).elementsEqual(expectedTail) }
+        let bulk = await channel.bulkBytes
+        let discards = await channel.discards
+        let interactive = await channel.interactiveBytes
+        XCTAssertTrue(bulk.suffix(expectedTail.count).elementsEqual(expectedTail))
+        XCTAssertEqual(discards, 1)
+        XCTAssertEqual(interactive, [], "The interrupt follows the bracket instead of landing inside it")
+        XCTAssertNil(manager.liveState(for: sessionID).pasteProgress)
+    }
+
+    func testInterruptWithoutPasteDropsQueuedBulk() async throws {
+        let channel = QueueingShellChannel()
+        let (manager, sessionID) = try await makeConnectedSession(channel: channel)
+        await channel.setQueuedBulkBytes(64 * 1024)
+
+        await manager.sendRawShellInputBytes(sessionID: sessionID, bytes: Array("q".utf8))
+        let discardsAfterKey = await channel.discards
+        XCTAssertEqual(discardsAfterKey, 0)
+
+        await manager.sendRawShellInputBytes(sessionID: sessionID, bytes: [0x03])
+        let discards = await channel.discards
+        let interactive = await channel.interactiveBytes
+        XCTAssertEqual(discards, 1)
+        XCTAssertEqual(interactive, Array("q".utf8) + [0x03])
+    }
+
+    func testLongCommandGoesAtBulkPriority() async throws {
+        let channel = QueueingShellChannel()
+        let (manager, sessionID) = try await makeConnectedSession(channel: channel)
+
+        await manager.sendShellInput(sessionID: sessionID, input: "ls")
+        let heredoc = "cat > patch.diff <<'EOF'\n" + String(repeating: "+line\n", count: 2_000) + "EOF"
+        await manager.sendShellInput(sessionID: sessionID, input: heredoc)
+
+        let interactive = await channel.interactiveBytes
+        let bulk = await channel.bulkBytes
+        XCTAssertEqual(interactive, Array("ls\n".utf8))
+        XCTAssertEqual(bulk, Array((heredoc + "\n").utf8))
+    }
+
+    func testInterruptByteDetection() {
+        XCTAssertTrue(SessionShellIOCoordinator.containsInterrupt([0x03]))
+        XCTAssertTrue(SessionShellIOCoordinator.containsInterrupt([0x1C]))
+        XCTAssertTrue(SessionShellIOCoordinator.containsInterrupt(Array("ab".utf8) + [0x1A]))
+        XCTAssertFalse(SessionShellIOCoordinator.containsInterrupt(Array("\u{1B}[A".utf8)))
+    }
+}
+
+// MARK: - Test Doubles
+
+/// Records writes by priority and reports a settable bulk backlog.
+private actor QueueingShellChannel: SSHShellChannel {
+    nonisolated let rawOutput: AsyncStream<Data>
+    private let continuation: AsyncStream<Data>.Continuation
+    private(set) var bulkBytes: [UInt8] = []
+    private(set) var interactiveBytes: [UInt8] = []
+    private(set) var discards = 0
+    private var queuedBulkBytes = 0
+    private var backsUpAfterFirstBulkWrite = false
+
+    init() {
+        var captured: AsyncStream<Data>.Continuation?
+        self.rawOutput = AsyncStream<Data> { captured = $0 }
+        self.continuation = captured!
+    }
+
+    func setQueuedBulkBytes(_ count: Int) {
+        queuedBulkBytes = count
+    }
+
+    func backUpAfterFirstBulkWrite() {
+        backsUpAfterFirstBulkWrite = true
+    }
+
+    func send(_ input: String) async throws {
+        try await send(bytes: Array(input.utf8))
+    }
+
+    func send(bytes: [UInt8]) async throws {
+        try await send(bytes: bytes, priority: .interactive)
+    }
+
+    func send(bytes: [UInt8], priority: SSHShellWritePriority) async throws {
+        switch priority {
+        case .interactive:
+            interactiveBytes.append(contentsOf: bytes)
+        case .bulk:
+            bulkBytes.append(contentsOf: bytes)
+            if backsUpAfterFirstBulkWrite {
+                queuedBulkBytes = Int.max
+            }
+        }
+    }
+
+    func queuedBulkByteCount() -> Int {
+        queuedBulkBytes
+    }
+
+    func discardQueuedBulk() -> Int {
+        discards += 1
+        defer { queuedBulkBytes = 0 }
+        return queuedBulkBytes
+    }
+
+    func resizePTY(columns: Int, rows: Int) async throws {}
+
+    func close() async {
+        continuation.finish()
+    }
+}
+
+private actor PasteTestKnownHostsStore: KnownHostsStoreProtocol {
+    func allEntries() async throws -> [KnownHostEntry] { [] }
+
+    func evaluate(
+        hostname: String,
+        port: UInt16,
+        hostKeyType: String,
+        presentedFingerprint: String
+    ) async throws -> KnownHostVerificationResult {
+        .trusted
+    }
+
+    func trust(challenge: KnownHostVerificationChallenge) async throws {}
+
+    func clearAll() async throws {}
+}
+#endif
@@ -0,0 +1,71 @@
+// StringPayloadScannerTests.swift
+// ProSSHV2
+//
+// Word-at-a-time OSC/DCS payload scan-ahead and the engine's bulk payload
+// collection.
+
+#if canImport(XCTest)
+import XCTest
+@testable import ProSSHMac
+
+final class StringPayloadScannerTests: XCTestCase {
+
+    private func runEnd(_ bytes: [UInt8], from start: Int = 0) -> Int {
+        bytes.withUnsafeBytes { StringPayloadScanner.printableRunEnd($0, from: start) }
+    }
+
+    // MARK: - Scanner
+
+    func testStopsAtEveryNonPrintableByteAtEveryOffset() {
+        for stop: UInt8 in [0x00, 0x07, 0x18, 0x1B, 0x1F, 0x7F, 0x80, 0x9C, 0xC3, 0xFF] {
+            for offset in 0..<20 {
+                var bytes = [UInt8](repeating: 0x41, count: 24)
+                bytes[offset] = stop
+                XCTAssertEqual(runEnd(bytes), offset, "stop 0x\(String(stop, radix: 16)) at \(offset)")
+            }
+        }
+    }
+
+    func testRunReachesEndOfSpan() {
+        let bytes = Array("QUJDREVGR0hJSktMTU5PUA==~ ".utf8)
+        XCTAssertEqual(runEnd(bytes), bytes.count)
+        XCTAssertEqual(runEnd(bytes, from: 5), bytes.count)
+        XCTAssertEqual(runEnd([]), 0)
+    }
+
+    // MARK: - Engine
+
+    func testLongOSCTitleIsCollectedWhole() async {
+        let engine = TerminalEngine(columns: 80, rows: 24)
+        let title = String(repeating: "t", count: 50_000)
+
+        await engine.feed(Array("\u{1B}]0;\(title)\u{07}x".utf8))
+
+        let windowTitle = await engine.windowTitle
+        XCTAssertEqual(windowTitle, title)
+        let cell = await engine.grid.cellAt(row: 0, col: 0)
+        XCTAssertEqual(cell?.graphemeCluster, "x")
+    }
+
+    func testPayloadSplitAcrossChunksAndSevenBitST() async {
+        let engine = TerminalEngine(columns: 80, rows: 24)
+
+        await engine.feed(Array("\u{1B}]2;split ".utf8))
+        await engine.feed(Array("ti".utf8))
+        await engine.feed(Array("tle ü\u{1B}\\".utf8))
+
+        let windowTitle = await engine.windowTitle
+        XCTAssertEqual(windowTitle, "split title ü")
+    }
+
+    func testPayloadLimitTruncates() async {
+        let engine = TerminalEngine(columns: 80, rows: 24)
+        await engine.setStringPayloadLimits(osc: 6, dcs: 6)
+
+        await engine.feed(Array("\u{1B}]0;abcdefghij\u{07}".utf8))
+
+        let windowTitle = await engine.windowTitle
+        XCTAssertEqual(windowTitle, "abcd", "the cap counts the \"0;\" selector")
+    }
+}
+#endif
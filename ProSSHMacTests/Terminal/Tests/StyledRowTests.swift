@@ -0,0 +1,117 @@
+// StyledRowTests.swift
+// ProSSHV2
+//
+// Codepoint stream plus run-length style spans: conversion, trimming and
+// the scrollback paths that read it directly.
+
+#if canImport(XCTest)
+import XCTest
+@testable import ProSSHMac
+
+final class StyledRowTests: XCTestCase {
+
+    // MARK: - Helpers
+
+    private func cell(_ scalar: Unicode.Scalar, fg: UInt32 = 0, bg: UInt32 = 0, width: UInt8 = 1) -> TerminalCell {
+        TerminalCell(
+            codepoint: scalar.value,
+            fgPacked: fg,
+            bgPacked: bg,
+            ulPacked: 0,
+            attributes: [],
+            underlineStyle: .none,
+            width: width
+        )
+    }
+
+    private func cells(_ text: String, fg: UInt32 = 0, bg: UInt32 = 0) -> [TerminalCell] {
+        text.unicodeScalars.map { cell($0, fg: fg, bg: bg) }
+    }
+
+    // MARK: - Conversion
+
+    func testUniformLineIsOneSpanWithoutWidths() {
+        let row = StyledRow(cells: cells(String(repeating: "a", count: 200)))
+
+        XCTAssertEqual(row.count, 200)
+        XCTAssertEqual(row.spans.count, 1)
+        XCTAssertEqual(row.spans.first?.length, 200)
+        XCTAssertNil(row.widths)
+    }
+
+    func testRoundTripPreservesStylesAndWideCells() {
+        var source = cells("ab", fg: 0xFF00_00FF) + cells("cd", bg: 0x0000_FFFF)
+        source.append(cell("界", width: 2))
+        source.append(TerminalCell(codepoint: 0, fgPacked: 0, bgPacked: 0, ulPacked: 0,
+                                   attributes: [.wideContinuation], underlineStyle: .none, width: 0))
+        source[1].attributes = [.bold, .underline]
+        source[1].underlineStyle = .double
+
+        let row = StyledRow(cells: source)
+        let expanded = row.cells
+
+        XCTAssertEqual(row.spans.count, 5)
+        XCTAssertEqual(row.widths, [1, 1, 1, 1, 2, 0])
+        XCTAssertEqual(expanded.map(\.codepoint), source.map(\.codepoint))
+        XCTAssertEqual(expanded.map(\.fgPackedRGBA), source.map(\.fgPackedRGBA))
+        XCTAssertEqual(expanded.map(\.bgPackedRGBA), source.map(\.bgPackedRGBA))
+        XCTAssertEqual(expanded.map(\.attributes.rawValue), source.map(\.attributes.rawValue))
+        XCTAssertEqual(expanded.map(\.underlineStyle), source.map(\.underlineStyle))
+        XCTAssertEqual(expanded.map(\.width), source.map(\.width))
+    }
+
+    // MARK: - Trimming
+
+    func testTrimDropsBlankTailButKeepsColoredBlanks() {
+        var plain = ScrollbackLine(cells: cells("hi   "))
+        plain.trimTrailingBlanks()
+        XCTAssertEqual(plain.count, 2)
+        XCTAssertEqual(plain.row.spans.map(\.length), [2])
+
+        var colored = ScrollbackLine(cells: cells("hi") + cells("   ", bg: 0x0000_FFFF))
+        colored.trimTrailingBlanks()
+        XCTAssertEqual(colored.count, 5)
+
+        var blank = ScrollbackLine(cells: cells("    "), graphemeOverrides: [3: "e\u{301}"])
+        blank.trimTrailingBlanks()
+        XCTAssertEqual(blank.count, 0)
+        XCTAssertTrue(blank.row.spans.isEmpty)
+        XCTAssertNil(blank.graphemeOverrides)
+    }
+
+    func testTruncateSplitsSpanAndDropsWidths() {
+        var row = StyledRow(cells: cells("abc", fg: 1) + [cell("界", width: 2)] + cells("def", fg: 2))
+        row.truncate(to: 2)
+
+        XCTAssertEqual(row.count, 2)
+        XCTAssertEqual(row.spans.map(\.length), [2])
+        XCTAssertNil(row.widths)
+    }
+
+    // MARK: - Consumers
+
+    func testGraphemeAndSearchReadCodepointsDirectly() {
+        var buffer = ScrollbackBuffer(maxLines: 100, spillFile: { nil })
+        buffer.push(ScrollbackLine(cells: cells("Hello World", fg: 7)))
+        buffer.push(ScrollbackLine(cells: cells("e"), graphemeOverrides: [0: "e\u{301}"]))
+
+        XCTAssertEqual(buffer.search("world"), [0])
+        XCTAssertEqual(buffer.line(at: 1)?.grapheme(at: 0), "e\u{301}")
+    }
+
+    func testScrollbackSnapshotRendersSpans() async {
+        let engine = TerminalEngine(columns: 10, rows: 2)
+        await engine.feed(Array("\u{1B}[31mred\u{1B}[0m plain\r\nx\r\ny\r\n".utf8))
+
+        let grid = await engine.grid
+        let snapshot = grid.snapshot(scrollOffset: 2)
+        let redFg = TerminalColor.indexed(1).packedRGBA()
+
+        XCTAssertEqual(snapshot.cells[0].glyphIndex, UInt32(("r" as Unicode.Scalar).value))
+        XCTAssertEqual(snapshot.cells[0].fgColor, redFg)
+        XCTAssertEqual(snapshot.cells[4].glyphIndex, UInt32(("p" as Unicode.Scalar).value))
+        XCTAssertEqual(snapshot.cells[4].fgColor, 0)
+        XCTAssertEqual(snapshot.cells[9].glyphIndex, 0)
+    }
+}
+#endif
@@ -0,0 +1,54 @@
+// TerminalEngineMailboxTests.swift
+// ProSSHV2
+//
+// Per-engine serial executor and the lock-free post-feed status mailbox.
+
+#if canImport(XCTest)
+import XCTest
+@testable import ProSSHMac
+
+final class TerminalEngineMailboxTests: XCTestCase {
+
+    // MARK: - Packing
+
+    func testStatusRoundTripsThroughPackedWord() {
+        let status = TerminalEngineStatus(
+            synchronizedOutput: true,
+            usingAlternateBuffer: false,
+            hasSyncExitSnapshots: true,
+            scrollbackCount: 123_456
+        )
+        XCTAssertEqual(TerminalEngineStatus(packed: status.packed), status)
+    }
+
+    // MARK: - Engine
+
+    func testFeedPostsGridFlags() async {
+        let engine = TerminalEngine(columns: 20, rows: 4)
+
+        // Dirty output before the sync window starts queues a sync-exit snapshot.
+        await engine.feed(Array("\u{1B}[?1049habc\u{1B}[?2026h".utf8))
+        XCTAssertTrue(engine.mailbox.status.usingAlternateBuffer)
+        XCTAssertTrue(engine.mailbox.status.synchronizedOutput)
+        XCTAssertTrue(engine.mailbox.status.hasSyncExitSnapshots)
+
+        _ = await engine.consumeSyncExitSnapshots()
+        XCTAssertFalse(engine.mailbox.status.hasSyncExitSnapshots)
+
+        await engine.feed(Array("\u{1B}[?2026l".utf8))
+        XCTAssertFalse(engine.mailbox.status.synchronizedOutput)
+
+        await engine.disableAlternateBuffer()
+        XCTAssertFalse(engine.mailbox.status.usingAlternateBuffer)
+    }
+
+    func testScrollbackCountTracksFeeds() async {
+        let engine = TerminalEngine(columns: 20, rows: 4)
+        await engine.feed(Array(String(repeating: "line\r\n", count: 10).utf8))
+
+        let scrollback = await engine.scrollbackCount
+        XCTAssertEqual(engine.mailbox.status.scrollbackCount, scrollback)
+        XCTAssertGreaterThan(scrollback, 0)
+    }
+}
+#endif
@@ -0,0 +1,78 @@
+// TerminalEngineSchedulerTests.swift
+// ProSSHV2
+//
+// Engines on the bounded worker pool: tier order and fairness of the run
+// queue, and parsing that stays correct when sessions yield to each other
+// on a single worker.
+
+#if canImport(XCTest)
+import XCTest
+@testable import ProSSHMac
+
+final class TerminalEngineSchedulerTests: XCTestCase {
+
+    // MARK: - Run Queue
+
+    func testHigherTiersGoFirstInArrivalOrder() {
+        var queue = TerminalEngineRunQueue<String>(fairnessInterval: 100)
+        queue.push("hidden", tier: .hidden)
+        queue.push("visible", tier: .visible)
+        queue.push("focused 1", tier: .focused)
+        queue.push("focused 2", tier: .focused)
+
+        var order: [String] = []
+        while let next = queue.pop() {
+            order.append(next)
+        }
+        XCTAssertEqual(order, ["focused 1", "focused 2", "visible", "hidden"])
+        XCTAssertTrue(queue.isEmpty)
+    }
+
+    func testLowestTierIsServedEveryFairnessInterval() {
+        var queue = TerminalEngineRunQueue<String>(fairnessInterval: 3)
+        queue.push("hidden", tier: .hidden)
+        for _ in 0..<4 {
+            queue.push("focused", tier: .focused)
+        }
+
+        XCTAssertEqual(queue.pop(), "focused")
+        XCTAssertEqual(queue.pop(), "focused")
+        XCTAssertEqual(queue.pop(), "hidden", "The third pick goes to the lowest tier")
+        XCTAssertEqual(queue.pop(), "focused")
+        XCTAssertEqual(queue.count, 1)
+    }
+
+    // MARK: - Engines
+
+    func testEnginesSharingOneWorkerParseCorrectly() async {
+        let scheduler = TerminalEngineScheduler(workerCount: 1)
+        var text = ""
+        for line in 0..<20_000 {
+            text += line % 50 == 0
+                ? "line \(line) \u{1B}[1;31mred\u{1B}[0m ünïcode\r\n"
+                : "line \(line) of flooding output\r\n"
+        }
+        let flood = Array(text.utf8)
+        XCTAssertGreaterThan(flood.count, TerminalEngineScheduler.quantumBytes * 4)
+
+        let flooding = TerminalEngine(columns: 60, rows: 10, scheduler: scheduler)
+        flooding.setSchedulingTier(.hidden)
+        let interactive = TerminalEngine(columns: 60, rows: 10, scheduler: scheduler)
+
+        async let floodDone: Void = flooding.feed(flood)
+        for key in 0..<20 {
+            await interactive.feed(Array("key \(key)\r\n".utf8))
+        }
+        await floodDone
+
+        let reference = TerminalEngine(columns: 60, rows: 10)
+        await reference.feed(flood)
+        let floodText = await flooding.visibleText()
+        let referenceText = await reference.visibleText()
+        XCTAssertEqual(floodText, referenceText)
+
+        let interactiveText = await interactive.visibleText()
+        XCTAssertTrue(interactiveText.contains { $0.hasPrefix("key 19") })
+    }
+}
+#endif
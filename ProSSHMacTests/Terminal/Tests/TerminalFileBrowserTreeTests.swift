@@ -96,5 +96,93 @@ final class TerminalFileBrowserTreeTests: XCTestCase {
     func testListLocalEntriesThrowsForMissingDirectory() {
         XCTAssertThrowsError(try TerminalFileBrowserTree.listLocalEntries(path: "/tmp/does-not-exist-\(UUID().uuidString)"))
     }
+
+    func testMergeListingPageKeepsDirectoriesFirstAndNamesOrdered() {
+        func entry(_ name: String, directory: Bool = false) -> TerminalFileBrowserEntry {
+            TerminalFileBrowserEntry(path: "/root/\(name)", name: name, isDirectory: directory, size: 0)
+        }
+
+        var listing = TerminalFileBrowserTree.mergeListingPage([entry("b.txt"), entry("src", directory: true)], into: [])
+        listing = TerminalFileBrowserTree.mergeListingPage(
+            [entry("Lib", directory: true), entry("a.txt"), entry("C.txt")],
+            into: listing
+        )
+
+        XCTAssertEqual(listing.map(\.name), ["Lib", "src", "a.txt", "b.txt", "C.txt"])
+    }
+
+    func testUpdateRowsReplacesOnlyTheChangedSubtree() {
+        let folder = TerminalFileBrowserEntry(path: "/root/folder", name: "folder", isDirectory: true, size: 0)
+        let other = TerminalFileBrowserEntry(path: "/root/other", name: "other", isDirectory: true, size: 0)
+        let file = TerminalFileBrowserEntry(path: "/root/file.txt", name: "file.txt", isDirectory: false, size: 12)
+        let nested = TerminalFileBrowserEntry(path: "/root/folder/nested.txt", name: "nested.txt", isDirectory: false, size: 4)
+        let added = TerminalFileBrowserEntry(path: "/root/folder/added.txt", name: "added.txt", isDirectory: false, size: 1)
+        let otherChild = TerminalFileBrowserEntry(path: "/root/other/x", name: "x", isDirectory: false, size: 1)
+        var childrenByPath: [String: [TerminalFileBrowserEntry]] = [
+            "/root": [folder, other, file],
+            "/root/folder": [nested],
+            "/root/other": [otherChild]
+        ]
+        var expanded: Set<String> = ["/root/folder", "/root/other"]
+        var rows = TerminalFileBrowserTree.rebuildRows(rootPath: "/root", childrenByPath: childrenByPath, expandedPaths: expanded)
+
+        childrenByPath["/root/folder"] = [added, nested]
+        TerminalFileBrowserTree.updateRows(
+            &rows,
+            under: "/root/folder",
+            rootPath: "/root",
+            childrenByPath: childrenByPath,
+            expandedPaths: expanded
+        )
+        XCTAssertEqual(
+            rows,
+            TerminalFileBrowserTree.rebuildRows(rootPath: "/root", childrenByPath: childrenByPath, expandedPaths: expanded)
+        )
+
+        expanded.remove("/root/folder")
+        TerminalFileBrowserTree.updateRows(
+            &rows,
+            under: "/root/folder",
+            rootPath: "/root",
+            childrenByPath: childrenByPath,
+            expandedPaths: expanded
+        )
+        XCTAssertEqual(rows.map(\.entry.path), ["/root/folder", "/root/other", "/root/other/x", "/root/file.txt"])
+    }
+
+    func testListingDiffReportsInsertedAndRemovedEntries() {
+        let kept = TerminalFileBrowserEntry(path: "/root/kept", name: "kept", isDirectory: false, size: 1)
+        let grown = TerminalFileBrowserEntry(path: "/root/log", name: "log", isDirectory: false, size: 1)
+        let grownLater = TerminalFileBrowserEntry(path: "/root/log", name: "log", isDirectory: false, size: 2)
+        let gone = TerminalFileBrowserEntry(path: "/root/gone", name: "gone", isDirectory: true, size: 0)
+
+        let diff = TerminalFileBrowserTree.listingDiff(from: [gone, kept, grown], to: [kept, grownLater])
+        XCTAssertEqual(diff.inserted, [grownLater])
+        XCTAssertEqual(diff.removed, [gone, grown])
+    }
+
+    func testEnumerateLocalEntriesDeliversPagesAndStopsWhenAsked() throws {
+        let fileManager = FileManager.default
+        let root = fileManager.temporaryDirectory.appendingPathComponent(UUID().uuidString, isDirectory: true)
+        try fileManager.createDirectory(at: root, withIntermediateDirectories: true)
+        defer { try? fileManager.removeItem(at: root) }
+        for index in 0..<7 {
+            _ = fileManager.createFile(atPath: root.appendingPathComponent("f\(index)").path, contents: Data())
+        }
+
+        var pageSizes: [Int] = []
+        try TerminalFileBrowserTree.enumerateLocalEntries(path: root.path, pageSize: 3) { page in
+            pageSizes.append(page.count)
+            return true
+        }
+        XCTAssertEqual(pageSizes, [3, 3, 1])
+
+        var pages = 0
+        try TerminalFileBrowserTree.enumerateLocalEntries(path: root.path, pageSize: 3) { _ in
+            pages += 1
+            return false
+        }
+        XCTAssertEqual(pages, 1)
+    }
 }
 #endif
@@ -140,5 +140,207 @@ final class TerminalHistoryIndexTests: XCTestCase {
         let commands = [recent[0].command, recent[1].command]
         XCTAssertEqual(commands, ["three", "two"])
     }
+
+    // MARK: - Search Index
+
+    private func record(
+        _ index: TerminalHistoryIndex,
+        sessionID: UUID,
+        command: String,
+        output: String
+    ) async {
+        await index.recordCommandInput(sessionID: sessionID, command: command, at: .now, source: .userInput)
+        await index.recordOutputChunk(sessionID: sessionID, data: Data(output.utf8), at: .now)
+        _ = await index.recordSemanticEvent(sessionID: sessionID, event: .commandEnd(exitCode: 0), at: .now)
+    }
+
+    @MainActor
+    func testSearchRanksCommandMatchesAboveOutputMatches() async {
+        let index = TerminalHistoryIndex(maxBlocksPerSession: 20)
+        let sessionID = UUID()
+        await index.registerSession(sessionID: sessionID, username: "kevin", hostname: "box")
+
+        await record(index, sessionID: sessionID, command: "journalctl -u nginx", output: "nginx started")
+        await record(index, sessionID: sessionID, command: "nginx", output: "usage")
+        await record(index, sessionID: sessionID, command: "cat access.log", output: "GET / nginx/1.25")
+        await record(index, sessionID: sessionID, command: "systemctl status NGINX", output: "active")
+
+        let results = await index.searchCommands(sessionID: sessionID, query: "Nginx", limit: 10)
+        XCTAssertEqual(results.map(\.command), [
+            "nginx",
+            "systemctl status NGINX",
+            "journalctl -u nginx",
+            "cat access.log"
+        ])
+
+        let short = await index.searchCommands(sessionID: sessionID, query: "n", limit: 10)
+        XCTAssertEqual(short.count, 4, "Queries too short for trigrams scan every block")
+    }
+
+    @MainActor
+    func testMarkerLookupAndEviction() async {
+        let index = TerminalHistoryIndex(maxBlocksPerSession: 10)
+        let sessionID = UUID()
+        await index.registerSession(sessionID: sessionID, username: "kevin", hostname: "box")
+
+        let marker = "__PSW_0A1B2C3D4E__"
+        await record(
+            index,
+            sessionID: sessionID,
+            command: "{ uptime; __ps=$?; printf '\\n\(marker):%s\\n' \"$__ps\"; }",
+            output: "up 3 days\n\(marker):0"
+        )
+        let found = await index.commandBlock(sessionID: sessionID, marker: marker)
+        XCTAssertEqual(found?.output.contains(marker), true)
+
+        for step in 0..<(CommandHistorySearchIndex.compactionInterval + 10) {
+            await record(index, sessionID: sessionID, command: "echo \(step)", output: "\(step)")
+        }
+        let evicted = await index.commandBlock(sessionID: sessionID, marker: marker)
+        XCTAssertNil(evicted)
+        let uptime = await index.searchCommands(sessionID: sessionID, query: "uptime", limit: 10)
+        XCTAssertTrue(uptime.isEmpty)
+        let echoes = await index.searchCommands(sessionID: sessionID, query: "echo", limit: 20)
+        XCTAssertEqual(echoes.count, 10)
+    }
+
+    @MainActor
+    func testCapturedSemanticOutputReplacesScreenDiff() async {
+        let index = TerminalHistoryIndex(maxBlocksPerSession: 20)
+        let sessionID = UUID()
+        await index.registerSession(sessionID: sessionID, username: "kevin", hostname: "box")
+        await index.recordCommandInput(sessionID: sessionID, command: "make", at: .now, source: .userInput)
+        _ = await index.recordSemanticEvent(sessionID: sessionID, event: .commandStart, at: .now)
+
+        let block = await index.recordSemanticEvent(
+            sessionID: sessionID,
+            event: .commandEnd(exitCode: 2),
+            capturedOutput: "cc main.c\nerror: missing ;",
+            at: .now
+        )
+        XCTAssertEqual(block?.output, "cc main.c\nerror: missing ;")
+        XCTAssertEqual(block?.exitCode, 2)
+    }
+
+    @MainActor
+    func testRawOutputDropsNULsAndKeepsTheNewestBytes() async {
+        let index = TerminalHistoryIndex(maxBlocksPerSession: 20, maxOutputCharacters: 2_001)
+        let sessionID = UUID()
+        await index.registerSession(sessionID: sessionID, username: "kevin", hostname: "box")
+        await index.recordCommandInput(sessionID: sessionID, command: "yes", at: .now, source: .userInput)
+
+        await index.recordOutputChunk(sessionID: sessionID, data: Data("a\u{0}b\n".utf8))
+        let early = await index.activeCommandRawOutput(sessionID: sessionID)
+        XCTAssertEqual(early, "ab\n")
+
+        for _ in 0..<3_000 {
+            await index.recordOutputChunk(sessionID: sessionID, data: Data("é".utf8))
+        }
+        let live = await index.activeCommandRawOutput(sessionID: sessionID) ?? ""
+        XCTAssertEqual(live.count, 1_000)
+        XCTAssertTrue(live.allSatisfy { $0 == "é" }, "A split character is not decoded")
+    }
+
+    @MainActor
+    func testRawOutputIsSkippedOnceOutputComesFromLines() async {
+        let index = TerminalHistoryIndex(maxBlocksPerSession: 20)
+        let sessionID = UUID()
+        await index.registerSession(sessionID: sessionID, username: "kevin", hostname: "box")
+        await index.recordCommandInput(sessionID: sessionID, command: "ls", at: .now, source: .userInput)
+        _ = await index.recordSemanticEvent(
+            sessionID: sessionID,
+            event: .commandEnd(exitCode: 0),
+            capturedOutput: "README.md",
+            at: .now
+        )
+
+        await index.recordCommandInput(sessionID: sessionID, command: "pwd", at: .now, source: .userInput)
+        await index.recordOutputChunk(sessionID: sessionID, data: Data("/home/kevin\n".utf8))
+        let live = await index.activeCommandRawOutput(sessionID: sessionID)
+        XCTAssertEqual(live, "")
+    }
+
+    @MainActor
+    func testSearchAllCommandsMergesSessions() async {
+        let index = TerminalHistoryIndex(maxBlocksPerSession: 20)
+        let first = UUID()
+        let second = UUID()
+        await index.registerSession(sessionID: first, username: "kevin", hostname: "one")
+        await index.registerSession(sessionID: second, username: "kevin", hostname: "two")
+
+        await record(index, sessionID: first, command: "df -h", output: "/dev/disk1 90%")
+        await record(index, sessionID: second, command: "df -h /var", output: "/dev/sda1 40%")
+        await record(index, sessionID: second, command: "ls", output: "notes")
+
+        let results = await index.searchAllCommands(query: "df -h", limit: 10)
+        XCTAssertEqual(Set(results.map(\.sessionID)), [first, second])
+        XCTAssertEqual(results.first?.command, "df -h", "Exact command ranks first")
+    }
+
+    // MARK: - Embeddings
+
+    private func makeEmbeddingIndex(maxBlocksPerSession: Int = 20) -> TerminalHistoryIndex {
+        TerminalHistoryIndex(
+            maxBlocksPerSession: maxBlocksPerSession,
+            embedder: HistoryTextEmbedder(model: .hashedWords(dimension: 256))
+        )
+    }
+
+    @MainActor
+    func testRelevantCommandsRankRelatedBlocksAcrossSessions() async {
+        let index = makeEmbeddingIndex()
+        let first = UUID()
+        let second = UUID()
+        await record(index, sessionID: first, command: "git status", output: "nothing to commit")
+        await record(
+            index,
+            sessionID: second,
+            command: "kubectl rollout status deploy/web",
+            output: "error: deployment web exceeded its progress deadline"
+        )
+        await record(index, sessionID: first, command: "ls", output: "notes")
+
+        let results = await index.relevantCommands(query: "deploy error", limit: 3)
+        XCTAssertEqual(results.first?.command, "kubectl rollout status deploy/web")
+        XCTAssertFalse(results.contains { $0.command == "ls" })
+    }
+
+    @MainActor
+    func testRelevantCommandsIgnoreUnrelatedPrompts() async {
+        let index = makeEmbeddingIndex()
+        await record(index, sessionID: UUID(), command: "make test", output: "All tests passed")
+        let results = await index.relevantCommands(query: "banana smoothie recipe", limit: 3)
+        XCTAssertTrue(results.isEmpty)
+    }
+
+    @MainActor
+    func testRelevantCommandsSkipEvictedBlocks() async {
+        let index = makeEmbeddingIndex(maxBlocksPerSession: 10)
+        let sessionID = UUID()
+        await record(index, sessionID: sessionID, command: "deploy api", output: "error: image pull failed")
+        for step in 1...10 {
+            await record(index, sessionID: sessionID, command: "echo \(step)", output: "\(step)")
+        }
+        let results = await index.relevantCommands(query: "deploy error", limit: 3)
+        XCTAssertTrue(results.isEmpty)
+    }
+
+    func testEmbeddingTextSkipsToolCommandsAndKeepsOutputEnds() {
+        let tool = CommandBlock(
+            id: UUID(), sessionID: UUID(), command: "{ ls; printf '__PSW_ABCDEF0123__:%s' $?; }",
+            output: "", startedAt: .now, completedAt: .now, exitCode: 0, boundarySource: .userInput
+        )
+        XCTAssertNil(CommandHistoryEmbeddingIndex.embeddingText(for: tool))
+
+        let output = (1...50).map { "line \($0)" }.joined(separator: "\n")
+        let build = CommandBlock(
+            id: UUID(), sessionID: UUID(), command: "make", output: output,
+            startedAt: .now, completedAt: .now, exitCode: 2, boundarySource: .userInput
+        )
+        let text = CommandHistoryEmbeddingIndex.embeddingText(for: build) ?? ""
+        XCTAssertTrue(text.hasPrefix("make\nfailed with exit status 2\nline 1\n"))
+        XCTAssertTrue(text.hasSuffix("line 50"))
+        XCTAssertFalse(text.contains("line 20\n"))
+    }
 }
 #endif
@@ -0,0 +1,107 @@
+// TerminalKeyframeTests.swift
+// ProSSHV2
+//
+// A grid keyframe fed to a fresh terminal must rebuild the screen, the
+// history it carries, the cursor and the modes that playback depends on.
+
+#if canImport(XCTest)
+import XCTest
+@testable import ProSSHMac
+
+final class TerminalKeyframeTests: XCTestCase {
+
+    // MARK: - Helpers
+
+    private func scrollbackText(_ grid: TerminalGrid) -> [String] {
+        let buffer = grid.scrollbackBuffer
+        return (0..<buffer.count).map { index in
+            var line = buffer[index]
+            line.trimTrailingBlanks()
+            return "\(line.isWrapped)|" + (0..<line.count).map { line.grapheme(at: $0) }.joined()
+        }
+    }
+
+    private func screenStyles(_ grid: TerminalGrid) -> [String] {
+        (0..<grid.rows).map { row in
+            (0..<grid.columns).compactMap { grid.cellAt(row: row, col: $0) }
+                .map { "\($0.fgColor)/\($0.bgColor)/\($0.attributes.subtracting(.wrapped).rawValue)" }
+                .joined(separator: ",")
+        }
+    }
+
+    private func restored(from engine: TerminalEngine, scrollbackLines: Int = 1_000) async -> TerminalEngine {
+        let grid = await engine.grid
+        let copy = TerminalEngine(columns: grid.columns, rows: grid.rows, maxScrollbackLines: 1_000)
+        await copy.feed(await engine.keyframeSequence(scrollbackLines: scrollbackLines))
+        return copy
+    }
+
+    // MARK: - Tests
+
+    func testKeyframeRestoresScreenHistoryAndCursor() async {
+        let engine = TerminalEngine(columns: 20, rows: 5, maxScrollbackLines: 1_000)
+        var output = ""
+        for index in 0..<12 {
+            output += "line \(index)\r\n"
+        }
+        output += String(repeating: "w", count: 30) + "\r\n"
+        output += "\u{1B}[1;31mred\u{1B}[0m \u{1B}[38;2;1;2;3mrgb\u{1B}[0m \u{1B}[4;44munder\u{1B}[0m\r\n"
+        output += "\u{1B}]2;build host\u{07}$ ls"
+        await engine.feed(Array(output.utf8))
+
+        let copy = await restored(from: engine)
+        let original = await engine.grid
+        let result = await copy.grid
+
+        XCTAssertEqual(result.visibleText(), original.visibleText())
+        XCTAssertEqual(screenStyles(result), screenStyles(original))
+        XCTAssertEqual(scrollbackText(result), scrollbackText(original))
+        XCTAssertEqual(result.cursorPosition().row, original.cursorPosition().row)
+        XCTAssertEqual(result.cursorPosition().col, original.cursorPosition().col)
+        XCTAssertEqual(result.windowTitle, "build host")
+    }
+
+    func testKeyframeCarriesOnlyRequestedHistory() async {
+        let engine = TerminalEngine(columns: 20, rows: 4, maxScrollbackLines: 1_000)
+        await engine.feed(Array((0..<50).map { "row \($0)\r\n" }.joined().utf8))
+
+        let copy = await restored(from: engine, scrollbackLines: 10)
+        let original = await engine.grid
+        let result = await copy.grid
+
+        XCTAssertEqual(result.scrollbackCount, 10)
+        XCTAssertEqual(scrollbackText(result), Array(scrollbackText(original).suffix(10)))
+        XCTAssertEqual(result.visibleText(), original.visibleText())
+    }
+
+    func testKeyframeRestoresAlternateScreenAndModes() async {
+        let engine = TerminalEngine(columns: 20, rows: 5, maxScrollbackLines: 1_000)
+        await engine.feed(Array("shell prompt\r\n$ vim".utf8))
+        await engine.feed(Array("\u{1B}[?1049h\u{1B}[H~ file\u{1B}[3;1H~ end\u{1B}[2;4r\u{1B}[?1h\u{1B}[?2004h\u{1B}[?25l\u{1B}[5;6H".utf8))
+
+        let copy = await restored(from: engine)
+        let original = await engine.grid
+        let result = await copy.grid
+
+        XCTAssertTrue(result.usingAlternateBuffer)
+        XCTAssertEqual(result.visibleText(), original.visibleText())
+        XCTAssertEqual(result.scrollTop, 1)
+        XCTAssertEqual(result.scrollBottom, 3)
+        XCTAssertTrue(result.applicationCursorKeys)
+        XCTAssertTrue(result.bracketedPasteMode)
+        XCTAssertFalse(result.cursor.visible)
+        XCTAssertEqual(result.cursorPosition().row, original.cursorPosition().row)
+        XCTAssertEqual(result.cursorPosition().col, original.cursorPosition().col)
+
+        // Leaving the alternate screen brings back the primary one.
+        await engine.feed(Array("\u{1B}[?1049l".utf8))
+        await copy.feed(Array("\u{1B}[?1049l".utf8))
+        let originalPrimary = await engine.grid
+        let resultPrimary = await copy.grid
+        XCTAssertEqual(resultPrimary.visibleText(), originalPrimary.visibleText())
+        XCTAssertEqual(resultPrimary.cursorPosition().row, originalPrimary.cursorPosition().row)
+        XCTAssertEqual(resultPrimary.cursorPosition().col, originalPrimary.cursorPosition().col)
+    }
+}
+
+#endif
@@ -0,0 +1,39 @@
+// TerminalLinkRowsTests.swift
+// ProSSHV2
+//
+// Per-row link cache: only rows whose text changed are scanned again, and
+// links are only returned for the text they were found in.
+
+#if canImport(XCTest)
+import XCTest
+@testable import ProSSHMac
+
+final class TerminalLinkRowsTests: XCTestCase {
+
+    func testUpdateScansOnlyChangedRows() {
+        var rows = TerminalLinkRows()
+        let first = rows.update(lines: ["see https://example.com", "plain", ""])
+        XCTAssertEqual(first, 3)
+
+        let second = rows.update(lines: ["see https://example.com", "ping 10.0.0.1", ""])
+        XCTAssertEqual(second, 1)
+        XCTAssertEqual(rows.links(forRow: 1, text: "ping 10.0.0.1")?.map(\.kind), [.ipAddress])
+        XCTAssertEqual(rows.links(forRow: 0, text: "see https://example.com")?.map(\.text), ["https://example.com"])
+    }
+
+    func testLinksAreNilForDifferentText() {
+        var rows = TerminalLinkRows()
+        rows.update(lines: ["cat /etc/hosts"])
+        XCTAssertNil(rows.links(forRow: 0, text: "cat /etc/passwd"))
+        XCTAssertNil(rows.links(forRow: 1, text: ""))
+    }
+
+    func testShrinkingDropsTrailingRows() {
+        var rows = TerminalLinkRows()
+        rows.update(lines: ["a", "www.example.org"])
+        rows.update(lines: ["a"])
+        XCTAssertNil(rows.links(forRow: 1, text: "www.example.org"))
+        XCTAssertEqual(rows.links(forRow: 0, text: "a")?.count, 0)
+    }
+}
+#endif
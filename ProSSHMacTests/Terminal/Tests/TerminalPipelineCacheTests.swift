@@ -0,0 +1,84 @@
+// TerminalPipelineCacheTests.swift
+// ProSSHV2
+//
+// Shared pipeline states: built once per device and process, persisted to
+// a binary archive, and rebuilt from that archive by a fresh cache.
+
+#if canImport(XCTest)
+import XCTest
+import Metal
+@testable import ProSSHMac
+
+final class TerminalPipelineCacheTests: XCTestCase {
+
+    private var directory: URL!
+
+    override func setUp() async throws {
+        directory = FileManager.default.temporaryDirectory
+            .appendingPathComponent("TerminalPipelineCacheTests-\(UUID().uuidString)", isDirectory: true)
+    }
+
+    override func tearDown() async throws {
+        try? FileManager.default.removeItem(at: directory)
+    }
+
+    private func makeDevice() throws -> MTLDevice {
+        guard let device = MTLCreateSystemDefaultDevice() else {
+            throw XCTSkip("No Metal device available")
+        }
+        return device
+    }
+
+    // MARK: - Sharing
+
+    func testPipelinesAreBuiltOncePerDevice() throws {
+        let device = try makeDevice()
+        let cache = TerminalPipelineCache(archiveDirectory: directory)
+        XCTAssertFalse(cache.isWarm(for: device))
+
+        let first = try cache.pipelines(for: device)
+        let second = try cache.pipelines(for: device)
+        XCTAssertTrue(cache.isWarm(for: device))
+        XCTAssertTrue(first.scene === second.scene)
+        XCTAssertTrue(first.background === second.background)
+        XCTAssertNotNil(first.cellExpansion)
+        XCTAssertNotNil(first.bloomDownsample)
+        XCTAssertNotNil(first.bloomUpsample)
+    }
+
+    // MARK: - Archive
+
+    func testArchiveIsWrittenAndReused() throws {
+        let device = try makeDevice()
+        let url = try XCTUnwrap(TerminalPipelineCache(archiveDirectory: directory).archiveURL(for: device))
+
+        _ = try TerminalPipelineCache(archiveDirectory: directory).pipelines(for: device)
+        XCTAssertTrue(FileManager.default.fileExists(atPath: url.path))
+        let written = try FileManager.default.attributesOfItem(atPath: url.path)[.modificationDate] as? Date
+
+        // A new process (a fresh cache) loads the stored archive and leaves it alone.
+        let reloaded = try TerminalPipelineCache(archiveDirectory: directory).pipelines(for: device)
+        XCTAssertNotNil(reloaded.cellExpansion)
+        let reread = try FileManager.default.attributesOfItem(atPath: url.path)[.modificationDate] as? Date
+        XCTAssertEqual(written, reread)
+    }
+
+    func testUnreadableArchiveIsReplaced() throws {
+        let device = try makeDevice()
+        let url = try XCTUnwrap(TerminalPipelineCache(archiveDirectory: directory).archiveURL(for: device))
+        try FileManager.default.createDirectory(at: directory, withIntermediateDirectories: true)
+        try Data("not an archive".utf8).write(to: url)
+
+        _ = try TerminalPipelineCache(archiveDirectory: directory).pipelines(for: device)
+        let size = try FileManager.default.attributesOfItem(atPath: url.path)[.size] as? Int
+        XCTAssertGreaterThan(size ?? 0, 14)
+    }
+
+    func testNoDirectoryBuildsWithoutPersisting() throws {
+        let device = try makeDevice()
+        let cache = TerminalPipelineCache(archiveDirectory: nil)
+        XCTAssertNil(cache.archiveURL(for: device))
+        XCTAssertNoThrow(try cache.pipelines(for: device))
+    }
+}
+#endif
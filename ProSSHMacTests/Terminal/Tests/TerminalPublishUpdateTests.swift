@@ -0,0 +1,101 @@
+// TerminalPublishUpdateTests.swift
+// ProSSHV2
+//
+// Tests for the single-hop publish gather: viewport anchoring as
+// scrollback grows, and housekeeping that reads only what is due.
+
+#if canImport(XCTest)
+import XCTest
+@testable import ProSSHMac
+
+final class TerminalPublishUpdateTests: XCTestCase {
+
+    // MARK: - Helpers
+
+    private func request(offset: Int, previous: Int, preserve: Bool? = nil) -> TerminalPublishRequest {
+        TerminalPublishRequest(scrollOffset: offset, previousScrollbackCount: previous, preserveScrollAnchor: preserve)
+    }
+
+    // MARK: - Viewport
+
+    func testScrolledViewportFollowsAppendedScrollback() {
+        let viewport = TerminalEngine.resolveViewport(request(offset: 5, previous: 100), scrollbackCount: 110, usingAlternateBuffer: false)
+        XCTAssertEqual(viewport.scrollOffset, 15)
+        XCTAssertNil(viewport.preserveScrollAnchor)
+    }
+
+    func testViewportWithoutAnchorStaysPut() {
+        let viewport = TerminalEngine.resolveViewport(request(offset: 5, previous: 100, preserve: false), scrollbackCount: 110, usingAlternateBuffer: false)
+        XCTAssertEqual(viewport.scrollOffset, 5)
+    }
+
+    func testAlternateBufferDropsTheOffset() {
+        let viewport = TerminalEngine.resolveViewport(request(offset: 5, previous: 100, preserve: true), scrollbackCount: 110, usingAlternateBuffer: true)
+        XCTAssertEqual(viewport.scrollOffset, 0)
+        XCTAssertEqual(viewport.preserveScrollAnchor, false)
+    }
+
+    func testOffsetIsClampedToScrollback() {
+        let viewport = TerminalEngine.resolveViewport(request(offset: 50, previous: 10, preserve: false), scrollbackCount: 20, usingAlternateBuffer: false)
+        XCTAssertEqual(viewport.scrollOffset, 20)
+    }
+
+    // MARK: - Engine
+
+    func testUpdateCarriesSnapshotAndHousekeeping() async {
+        let engine = TerminalEngine(columns: 20, rows: 4)
+        _ = await engine.feed(Data("hello\u{07}\u{1B}]0;title\u{07}".utf8))
+
+        var publish = request(offset: 0, previous: 0)
+        publish.housekeeping = TerminalHousekeepingRequest(wantsShellText: true, publishedTextVersion: nil)
+        let update = await engine.publishUpdate(publish)
+
+        XCTAssertNotNil(update.snapshot)
+        XCTAssertEqual(update.housekeeping?.bellCount, 1)
+        XCTAssertEqual(update.housekeeping?.windowTitle, "title")
+        guard case let .lines(lines)? = update.housekeeping?.shellText else {
+            return XCTFail("Expected visible lines")
+        }
+        XCTAssertEqual(lines.first?.hasPrefix("hello"), true)
+    }
+
+    func testHousekeepingSkipsTextThatIsNotDue() async {
+        let engine = TerminalEngine(columns: 20, rows: 4)
+        _ = await engine.feed(Data("hello".utf8))
+
+        let housekeeping = await engine.housekeeping(TerminalHousekeepingRequest(wantsShellText: false, publishedTextVersion: 1))
+
+        guard case .notPublished = housekeeping.shellText else {
+            return XCTFail("Text was not due")
+        }
+    }
+
+    func testHousekeepingSkipsTextUnchangedSincePublishedVersion() async {
+        let engine = TerminalEngine(columns: 20, rows: 4)
+        _ = await engine.feed(Data("hello".utf8))
+        let first = await engine.housekeeping(TerminalHousekeepingRequest(wantsShellText: true, publishedTextVersion: nil))
+
+        let second = await engine.housekeeping(TerminalHousekeepingRequest(wantsShellText: true, publishedTextVersion: first.textVersion))
+        guard case .unchanged = second.shellText else {
+            return XCTFail("Nothing changed since the published version")
+        }
+
+        _ = await engine.feed(Data(" world".utf8))
+        let third = await engine.housekeeping(TerminalHousekeepingRequest(wantsShellText: true, publishedTextVersion: first.textVersion))
+        guard case let .lines(lines) = third.shellText else {
+            return XCTFail("Expected the changed lines")
+        }
+        XCTAssertEqual(lines.first, "hello world")
+        XCTAssertGreaterThan(third.textVersion, first.textVersion)
+    }
+
+    func testOverridePublishTakesNoSnapshot() async {
+        let engine = TerminalEngine(columns: 20, rows: 4)
+        var publish = request(offset: 0, previous: 0)
+        publish.takesSnapshot = false
+        let update = await engine.publishUpdate(publish)
+        XCTAssertNil(update.snapshot)
+        XCTAssertNil(update.housekeeping)
+    }
+}
+#endif
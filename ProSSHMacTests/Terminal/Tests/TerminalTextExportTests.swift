@@ -0,0 +1,47 @@
+// TerminalTextExportTests.swift
+// ProSSHV2
+//
+// Whole-history text export: scrollback then screen, wrapped rows joined,
+// trailing blanks trimmed, and output split into chunks.
+
+#if canImport(XCTest)
+import XCTest
+@testable import ProSSHMac
+
+final class TerminalTextExportTests: XCTestCase {
+
+    private func export(_ text: String, columns: Int = 10, rows: Int = 3) async -> TerminalTextExport {
+        let engine = TerminalEngine(columns: columns, rows: rows, maxScrollbackLines: 100_000)
+        await engine.feed(Array(text.utf8))
+        return await engine.historyTextExport()
+    }
+
+    func testExportCoversScrollbackAndScreen() async {
+        let exported = await export("one\r\ntwo  \r\nthree\r\nfour\r\nfive")
+        XCTAssertEqual(exported.rowCount, 5)
+        XCTAssertEqual(String(decoding: exported.utf8Data(), as: UTF8.self), "one\ntwo\nthree\nfour\nfive")
+    }
+
+    func testWrappedRowsJoinIntoOneLine() async {
+        let exported = await export("abcdefghijklmno\r\nnext")
+        XCTAssertEqual(String(decoding: exported.utf8Data(), as: UTF8.self), "abcdefghijklmno\nnext")
+    }
+
+    func testMultibyteTextAndChunking() async {
+        var text = ""
+        for index in 0..<12_000 {
+            text += "é \(index)\r\n"
+        }
+        let exported = await export(text, columns: 20, rows: 5)
+
+        var chunks: [Data] = []
+        exported.write { chunks.append($0) }
+        XCTAssertGreaterThan(chunks.count, 1)
+        let joined = String(decoding: chunks.reduce(Data(), +), as: UTF8.self)
+        let lines = joined.split(separator: "\n", omittingEmptySubsequences: false)
+        XCTAssertEqual(lines.count, 12_000)
+        XCTAssertEqual(lines.first, "é 0")
+        XCTAssertEqual(lines.last, "é 11999")
+    }
+}
+#endif
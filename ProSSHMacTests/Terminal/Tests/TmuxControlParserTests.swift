@@ -0,0 +1,165 @@
+// TmuxControlParserTests.swift
+// ProSSHV2
+//
+// tmux control mode: splitting a stream at DCS 1000p and ST, control mode
+// lines as notifications and command replies, `\ooo` unescaping, window
+// layouts as split trees, and the commands sent back.
+
+#if canImport(XCTest)
+import XCTest
+@testable import ProSSHMac
+
+final class TmuxControlParserTests: XCTestCase {
+
+    private let introducer = "\u{1B}P1000p"
+
+    private func bytes(_ text: String) -> [UInt8] {
+        Array(text.utf8)
+    }
+
+    // MARK: - Stream Splitting
+
+    func testPlainOutputIsOneTerminalRange() {
+        var parser = TmuxControlParser()
+        let input = bytes("ls -la\r\n\u{1B}[31mred\u{1B}[0m")
+        XCTAssertEqual(parser.parse(input), [.terminal(0..<input.count)])
+        XCTAssertFalse(parser.isInControlMode)
+    }
+
+    func testIntroducerStartsControlModeAndSTEndsIt() {
+        var parser = TmuxControlParser()
+        let input = bytes("$ tmux -CC\r\n" + introducer + "%exit\n\u{1B}\\$ ")
+        let segments = parser.parse(input)
+        XCTAssertEqual(segments, [
+            .terminal(0..<12),
+            .controlModeStarted,
+            .notification(.exit(reason: nil)),
+            .controlModeEnded,
+            .terminal((input.count - 2)..<input.count),
+        ])
+        XCTAssertFalse(parser.isInControlMode)
+    }
+
+    func testIntroducerSplitAcrossReads() {
+        var parser = TmuxControlParser()
+        XCTAssertEqual(parser.parse(bytes("ab\u{1B}P10")), [.terminal(0..<2)])
+        XCTAssertEqual(parser.parse(bytes("00p")), [.controlModeStarted])
+        XCTAssertTrue(parser.isInControlMode)
+    }
+
+    func testHeldBackBytesReturnWhenNotAnIntroducer() {
+        var parser = TmuxControlParser()
+        XCTAssertEqual(parser.parse(bytes("ab\u{1B}P")), [.terminal(0..<2)])
+        XCTAssertEqual(parser.parse(bytes("qsixel")), [
+            .terminalBytes([0x1B, 0x50]),
+            .terminal(0..<6),
+        ])
+        XCTAssertFalse(parser.isInControlMode)
+    }
+
+    // MARK: - Notifications
+
+    func testOutputIsUnescaped() {
+        var parser = TmuxControlParser()
+        _ = parser.parse(bytes(introducer))
+        let segments = parser.parse(bytes("%output %3 hi\\015\\012\\134x\r\n"))
+        XCTAssertEqual(segments, [.notification(.output(pane: 3, data: bytes("hi\r\n\\x")))])
+    }
+
+    func testOutputLineSplitAcrossReads() {
+        var parser = TmuxControlParser()
+        _ = parser.parse(bytes(introducer))
+        XCTAssertEqual(parser.parse(bytes("%output %1 ab")), [])
+        XCTAssertEqual(parser.parse(bytes("c\n")), [.notification(.output(pane: 1, data: bytes("abc")))])
+    }
+
+    func testExtendedOutputSkipsAge() {
+        var parser = TmuxControlParser()
+        _ = parser.parse(bytes(introducer))
+        XCTAssertEqual(
+            parser.parse(bytes("%extended-output %2 120 : done\n")),
+            [.notification(.output(pane: 2, data: bytes("done")))]
+        )
+    }
+
+    func testWindowAndSessionNotifications() {
+        var parser = TmuxControlParser()
+        _ = parser.parse(bytes(introducer))
+        let input = "%layout-change @1 b25f,80x24,0,0,1 b25f,80x24,0,0,1 *\n"
+            + "%window-add @2\n%window-close @2\n%window-renamed @1 build logs\n"
+            + "%window-pane-changed @1 %4\n%session-changed $0 main\n"
+            + "%session-window-changed $0 @1\n%pause %1\n"
+        XCTAssertEqual(parser.parse(bytes(input)), [
+            .notification(.layoutChange(window: 1, layout: "b25f,80x24,0,0,1")),
+            .notification(.windowAdd(window: 2)),
+            .notification(.windowClose(window: 2)),
+            .notification(.windowRenamed(window: 1, name: "build logs")),
+            .notification(.windowPaneChanged(window: 1, pane: 4)),
+            .notification(.sessionChanged(session: 0, name: "main")),
+            .notification(.sessionWindowChanged(session: 0, window: 1)),
+        ])
+    }
+
+    func testReplyCollectsLinesUntilEnd() {
+        var parser = TmuxControlParser()
+        _ = parser.parse(bytes(introducer))
+        let input = "%begin 1700000000 42 1\n@1 1 b25f,80x24,0,0,1\n%output %1 not a notification\n%end 1700000000 42 1\n"
+            + "%begin 1700000001 43 0\n%error 1700000001 43 0\n"
+        XCTAssertEqual(parser.parse(bytes(input)), [
+            .notification(.reply(TmuxCommandReply(
+                number: 42,
+                fromClient: true,
+                succeeded: true,
+                lines: ["@1 1 b25f,80x24,0,0,1", "%output %1 not a notification"]
+            ))),
+            .notification(.reply(TmuxCommandReply(number: 43, fromClient: false, succeeded: false, lines: []))),
+        ])
+    }
+
+    // MARK: - Layouts
+
+    func testSinglePaneLayout() {
+        XCTAssertEqual(TmuxLayout(parsing: "b25f,80x24,0,0,1"), .pane(id: 1, columns: 80, rows: 24))
+        XCTAssertEqual(TmuxLayout(parsing: "80x24,0,0,7"), .pane(id: 7, columns: 80, rows: 24))
+    }
+
+    func testNestedLayout() {
+        let layout = TmuxLayout(parsing: "bb62,159x48,0,0{79x48,0,0,1,79x48,80,0[79x24,80,0,2,79x23,80,25,3]}")
+        XCTAssertEqual(layout, .sideBySide(columns: 159, rows: 48, [
+            .pane(id: 1, columns: 79, rows: 48),
+            .stacked(columns: 79, rows: 48, [
+                .pane(id: 2, columns: 79, rows: 24),
+                .pane(id: 3, columns: 79, rows: 23),
+            ]),
+        ]))
+        XCTAssertEqual(layout?.panes.map(\.id), [1, 2, 3])
+    }
+
+    func testMalformedLayoutIsRejected() {
+        XCTAssertNil(TmuxLayout(parsing: "b25f,80x24,0,0{40x24,0,0,1"))
+        XCTAssertNil(TmuxLayout(parsing: "nonsense"))
+    }
+
+    func testLayoutMapsToSplits() {
+        let layout = TmuxLayout(parsing: "0000,120x40,0,0{30x40,0,0,1,30x40,31,0,2,58x40,62,0,3}")!
+        let node = layout.splitNode { TerminalPane(title: "%\($0)") }
+        XCTAssertEqual(node.allPanes.map(\.title), ["%1", "%2", "%3"])
+        guard case .split(let outer) = node, case .split(let inner) = outer.second else {
+            return XCTFail("Expected nested splits")
+        }
+        XCTAssertEqual(outer.direction, .vertical)
+        XCTAssertEqual(outer.ratio, 30.0 / 118.0, accuracy: 0.001)
+        XCTAssertEqual(inner.ratio, 30.0 / 88.0, accuracy: 0.001)
+    }
+
+    // MARK: - Commands
+
+    func testSendKeysIsHexAndChunked() {
+        XCTAssertEqual(TmuxCommand.sendKeys(bytes("a\r"), pane: 5), ["send-keys -t %5 -H 61 0d"])
+        let paste = [UInt8](repeating: 0x41, count: TmuxCommand.maximumKeysPerCommand + 1)
+        let commands = TmuxCommand.sendKeys(paste, pane: 1)
+        XCTAssertEqual(commands.count, 2)
+        XCTAssertEqual(commands[1], "send-keys -t %1 -H 41")
+    }
+}
+#endif
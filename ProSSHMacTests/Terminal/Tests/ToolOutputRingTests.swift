@@ -0,0 +1,105 @@
+#if canImport(XCTest)
+import XCTest
+@testable import ProSSHMac
+
+@MainActor
+final class ToolOutputRingTests: XCTestCase {
+
+    // MARK: - Ring
+
+    func testShortOutputIsKeptWhole() {
+        var ring = ToolOutputRing(headLimit: 16, tailLimit: 8)
+        ring.append(Array("one\ntwo\n".utf8))
+        XCTAssertFalse(ring.isTruncated)
+        XCTAssertEqual(ring.text, "one\ntwo\n")
+        XCTAssertEqual(ring.byteCount, 8)
+        XCTAssertEqual(ring.lineCount, 2)
+    }
+
+    func testLongOutputKeepsHeadAndTailLines() {
+        let lines = (1...100).map { "line \($0)" }
+        var ring = ToolOutputRing(headLimit: 20, tailLimit: 20)
+        for line in lines {
+            ring.append(Array((line + "\n").utf8))
+        }
+        XCTAssertTrue(ring.isTruncated)
+        XCTAssertEqual(ring.lineCount, 100)
+
+        let text = ring.text
+        XCTAssertTrue(text.hasPrefix("line 1\nline 2\n"))
+        XCTAssertTrue(text.hasSuffix("line 99\nline 100\n"))
+        XCTAssertTrue(text.contains("lines ("))
+        XCTAssertTrue(text.contains("bytes) omitted ...]"))
+    }
+
+    func testTailWrapsAcrossAppends() {
+        var ring = ToolOutputRing(headLimit: 0, tailLimit: 4)
+        for chunk in ["ab", "cd", "ef", "g"] {
+            ring.append(Array(chunk.utf8))
+        }
+        XCTAssertEqual(ring.byteCount, 7)
+        XCTAssertTrue(ring.text.hasSuffix("defg"))
+    }
+
+    func testSingleLineCutsAtCharacterBoundaries() {
+        var ring = ToolOutputRing(headLimit: 5, tailLimit: 5)
+        ring.append(Array(String(repeating: "é", count: 20).utf8))
+        let text = ring.text
+        XCTAssertFalse(text.contains("\u{FFFD}"))
+        XCTAssertTrue(text.hasPrefix("éé\n"))
+        XCTAssertTrue(text.hasSuffix("\néé"))
+    }
+
+    func testLineCountIncludesUnterminatedLastLine() {
+        let ring = ToolOutputRing(text: "a\nb")
+        XCTAssertEqual(ring.lineCount, 2)
+    }
+
+    // MARK: - execute_and_wait Fields
+
+    func testFilteredOutputTakesStatusFromMarker() {
+        let marker = AIToolHandler.remoteFilterStatusMarker
+        let result = CommandExecutionResult(
+            output: "error: one\nerror: two\n\(marker):2",
+            exitCode: 0,
+            timedOut: false,
+            blockID: nil
+        )
+        let fields = AIToolHandler.boundedCommandOutputFields(result, filtered: true)
+        XCTAssertEqual(fields["output"], .string("error: one\nerror: two"))
+        XCTAssertEqual(fields["exit_code"], .number(2))
+        XCTAssertEqual(fields["total_lines"], .number(2))
+    }
+
+    func testFilteredCommandPassesStatusMarker() {
+        let command = AIToolHandler.buildFilteredCommand("make", filter: "warning|error")
+        XCTAssertTrue(command.hasPrefix("{ { make; } 2>&1;"))
+        XCTAssertTrue(command.contains("__prossh_filter='warning|error' awk"))
+        XCTAssertTrue(command.contains(#"index($0, "\#(AIToolHandler.remoteFilterStatusMarker):") == 1"#))
+    }
+
+    // MARK: - Exec Capture
+
+    func testCaptureReturnsPartialOutputOnTimeout() async {
+        let (events, continuation) = AsyncThrowingStream<SSHExecEvent, Error>.makeStream()
+        continuation.yield(.stdout(Data("partial\n".utf8)))
+        let capture = await SessionAIToolCoordinator.capture(events, timeout: .milliseconds(50))
+        XCTAssertTrue(capture.timedOut)
+        XCTAssertEqual(capture.stdout.text, "partial\n")
+        continuation.finish()
+    }
+
+    func testCaptureCollectsStreamsAndExitCode() async {
+        let (events, continuation) = AsyncThrowingStream<SSHExecEvent, Error>.makeStream()
+        continuation.yield(.stdout(Data("out".utf8)))
+        continuation.yield(.stderr(Data("err".utf8)))
+        continuation.yield(.exit(3))
+        continuation.finish()
+        let capture = await SessionAIToolCoordinator.capture(events, timeout: .seconds(5))
+        XCTAssertFalse(capture.timedOut)
+        XCTAssertEqual(capture.stdout.text, "out")
+        XCTAssertEqual(capture.stderr.text, "err")
+        XCTAssertEqual(capture.exitCode, 3)
+    }
+}
+#endif
@@ -0,0 +1,87 @@
+// TraceRecorderTests.swift
+// ProSSHV2
+//
+// Tests for the trace flight recorder: the ring keeps the newest events,
+// the time window trims old ones, and the export is Chrome trace JSON.
+
+#if canImport(XCTest)
+import XCTest
+@testable import ProSSHMac
+
+final class TraceRecorderTests: XCTestCase {
+
+    // MARK: - Helpers
+
+    private func makeRecorder(capacity: Int = 8) -> TraceRecorder {
+        let recorder = TraceRecorder(capacity: capacity)
+        recorder.setEnabled(true)
+        return recorder
+    }
+
+    private func traceEvents(_ data: Data) throws -> [[String: Any]] {
+        let object = try XCTUnwrap(JSONSerialization.jsonObject(with: data) as? [String: Any])
+        return try XCTUnwrap(object["traceEvents"] as? [[String: Any]])
+    }
+
+    // MARK: - Tests
+
+    func testDisabledRecorderRecordsNothing() {
+        let recorder = TraceRecorder(capacity: 8)
+        XCTAssertNil(recorder.begin())
+        recorder.record(.parserChunk, start: 1, end: 2)
+        XCTAssertTrue(recorder.recentEvents(lastSeconds: 10, now: 2).isEmpty)
+    }
+
+    func testRingKeepsTheNewestEventsInOrder() {
+        let recorder = makeRecorder(capacity: 4)
+        for index in 1...6 {
+            recorder.record(.parserChunk, start: Double(index), end: Double(index) + 0.5, value: Int64(index))
+        }
+
+        let events = recorder.recentEvents(lastSeconds: 100, now: 7)
+
+        XCTAssertEqual(events.map(\.value), [3, 4, 5, 6])
+    }
+
+    func testWindowDropsEventsThatEndedEarlier() {
+        let recorder = makeRecorder()
+        recorder.record(.publish, start: 10, end: 11)
+        recorder.record(.publish, start: 40, end: 41)
+        recorder.record(.publish, start: 44, end: 45)
+
+        let events = recorder.recentEvents(lastSeconds: 30, now: 45)
+
+        XCTAssertEqual(events.map(\.start), [40, 44])
+    }
+
+    func testChromeTraceHasSpansInstantsAndThreadNames() throws {
+        let recorder = makeRecorder()
+        recorder.record(.glyphRasterBatch, start: 2, end: 2.004, threadID: 42, value: 16)
+        recorder.record(.aiTool, start: 2.5, end: 3, threadID: 42, label: "read_file")
+        recorder.instant(.present, at: 3.1, threadID: TraceRecorder.gpuTrackID)
+
+        let events = try traceEvents(try recorder.chromeTrace(lastSeconds: 30, now: 3.2))
+        let spans = events.filter { $0["ph"] as? String == "X" }
+        let instants = events.filter { $0["ph"] as? String == "i" }
+        let names = events.filter { $0["ph"] as? String == "M" }.compactMap { ($0["args"] as? [String: Any])?["name"] as? String }
+
+        XCTAssertEqual(spans.count, 2)
+        XCTAssertEqual(spans[0]["name"] as? String, "GlyphRasterBatch")
+        XCTAssertEqual(spans[0]["cat"] as? String, "glyphs")
+        XCTAssertEqual(spans[0]["ts"] as? Double ?? 0, 2_000_000, accuracy: 1e-3)
+        XCTAssertEqual(spans[0]["dur"] as? Double ?? 0, 4_000, accuracy: 1e-3)
+        XCTAssertEqual((spans[0]["args"] as? [String: Any])?["glyphs"] as? Int, 16)
+        XCTAssertEqual(spans[1]["name"] as? String, "AITool read_file")
+        XCTAssertEqual(instants.count, 1)
+        XCTAssertTrue(names.contains("GPU"))
+        XCTAssertTrue(names.contains("Thread 42"))
+    }
+
+    func testResetEmptiesTheRing() {
+        let recorder = makeRecorder()
+        recorder.record(.frameEncode, start: 1, end: 1.01)
+        recorder.reset()
+        XCTAssertTrue(recorder.recentEvents(lastSeconds: 10, now: 2).isEmpty)
+    }
+}
+#endif
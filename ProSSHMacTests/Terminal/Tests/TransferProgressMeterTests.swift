@@ -0,0 +1,91 @@
+// TransferProgressMeterTests.swift
+// ProSSHV2
+//
+// The lock-free progress meter written by SFTP callbacks, the windowed
+// rate / time-remaining estimate and the sampled live progress object.
+
+#if canImport(XCTest)
+import XCTest
+@testable import ProSSHMac
+
+@MainActor
+final class TransferProgressMeterTests: XCTestCase {
+
+    // MARK: - Meter
+
+    func testMeterKeepsLatestBytesAndIgnoresUnknownTotals() {
+        let meter = TransferProgressMeter(initialTotal: 1_000)
+        meter.record(bytesTransferred: 100, totalBytes: 0)
+        XCTAssertEqual(meter.bytesTransferred, 100)
+        XCTAssertEqual(meter.totalBytes, 1_000)
+
+        meter.record(bytesTransferred: 300, totalBytes: 2_000)
+        XCTAssertEqual(meter.bytesTransferred, 300)
+        XCTAssertEqual(meter.totalBytes, 2_000)
+    }
+
+    func testMeterAcceptsConcurrentCallbacks() async {
+        let meter = TransferProgressMeter()
+        await withTaskGroup(of: Void.self) { group in
+            for chunk in 1...1_000 {
+                group.addTask {
+                    meter.record(bytesTransferred: Int64(chunk) * 32_768, totalBytes: 32_768_000)
+                }
+            }
+        }
+        XCTAssertEqual(meter.totalBytes, 32_768_000)
+        XCTAssertGreaterThan(meter.bytesTransferred, 0)
+    }
+
+    // MARK: - Rate Window
+
+    func testRateIsTheByteDeltaOverTheWindow() throws {
+        var window = TransferRateWindow(span: 5)
+        XCTAssertNil(window.bytesPerSecond)
+
+        window.add(bytes: 0, at: 0)
+        window.add(bytes: 0, at: 0.05)
+        XCTAssertNil(window.bytesPerSecond)
+
+        for second in 1...10 {
+            window.add(bytes: Int64(second) * 1_000_000, at: TimeInterval(second))
+        }
+        let rate = try XCTUnwrap(window.bytesPerSecond)
+        XCTAssertEqual(rate, 1_000_000, accuracy: 1)
+        XCTAssertEqual(try XCTUnwrap(window.secondsRemaining(totalBytes: 15_000_000)), 5, accuracy: 0.001)
+    }
+
+    func testRateForgetsSamplesOutsideTheWindow() throws {
+        var window = TransferRateWindow(span: 2)
+        window.add(bytes: 0, at: 0)
+        window.add(bytes: 10_000_000, at: 1)
+        // Stalled since.
+        for second in 2...6 {
+            window.add(bytes: 10_000_000, at: TimeInterval(second))
+        }
+        XCTAssertEqual(try XCTUnwrap(window.bytesPerSecond), 0, accuracy: 0.001)
+        XCTAssertNil(window.secondsRemaining(totalBytes: 20_000_000))
+    }
+
+    func testRateRestartsWhenBytesGoBackwards() {
+        var window = TransferRateWindow(span: 5)
+        window.add(bytes: 5_000, at: 0)
+        window.add(bytes: 10_000, at: 1)
+        window.add(bytes: 0, at: 2)
+        XCTAssertNil(window.bytesPerSecond)
+    }
+
+    // MARK: - Live Progress
+
+    func testLiveProgressPublishesRateAndRemainingTime() {
+        let live = TransferLiveProgress(totalBytes: 4_000)
+        live.apply(bytesTransferred: 0, totalBytes: 4_000, at: 10)
+        XCTAssertNil(live.bytesPerSecond)
+
+        live.apply(bytesTransferred: 1_000, totalBytes: 4_000, at: 11)
+        XCTAssertEqual(live.bytesTransferred, 1_000)
+        XCTAssertEqual(live.bytesPerSecond, 1_000)
+        XCTAssertEqual(live.secondsRemaining, 3)
+    }
+}
+#endif
@@ -0,0 +1,82 @@
+#if canImport(XCTest)
+import XCTest
+@testable import ProSSHMac
+
+final class TransferSchedulerTests: XCTestCase {
+
+    // MARK: - Helpers
+
+    private let sessionA = UUID()
+    private let sessionB = UUID()
+
+    private func candidate(_ sessionID: UUID, bytes: Int64) -> TransferScheduler.Candidate {
+        TransferScheduler.Candidate(id: UUID(), sessionID: sessionID, totalBytes: bytes)
+    }
+
+    // MARK: - Limits
+
+    func testRespectsPerSessionLimit() {
+        var scheduler = TransferScheduler(maxConcurrentPerSession: 2, maxConcurrentTotal: 8)
+        let queued = (0..<5).map { _ in candidate(sessionA, bytes: 10) }
+
+        let started = scheduler.nextTransfers(queued: queued, runningBySession: [:])
+        XCTAssertEqual(started, Array(queued.prefix(2)))
+    }
+
+    func testRespectsGlobalLimitIncludingRunningTransfers() {
+        var scheduler = TransferScheduler(maxConcurrentPerSession: 4, maxConcurrentTotal: 3)
+        let queued = (0..<4).map { _ in candidate(sessionB, bytes: 10) }
+
+        let started = scheduler.nextTransfers(queued: queued, runningBySession: [sessionA: 2])
+        XCTAssertEqual(started.count, 1)
+    }
+
+    func testNothingStartsWhenSaturated() {
+        var scheduler = TransferScheduler(maxConcurrentPerSession: 1, maxConcurrentTotal: 2)
+        let queued = [candidate(sessionA, bytes: 10)]
+
+        XCTAssertTrue(scheduler.nextTransfers(queued: queued, runningBySession: [sessionA: 1]).isEmpty)
+    }
+
+    // MARK: - Fairness
+
+    func testInterleavesSessions() {
+        var scheduler = TransferScheduler(maxConcurrentPerSession: 4, maxConcurrentTotal: 4)
+        let aBatch = (0..<4).map { _ in candidate(sessionA, bytes: 10) }
+        let bBatch = (0..<4).map { _ in candidate(sessionB, bytes: 10) }
+
+        let started = scheduler.nextTransfers(queued: aBatch + bBatch, runningBySession: [:])
+        XCTAssertEqual(started.filter { $0.sessionID == sessionA }.count, 2)
+        XCTAssertEqual(started.filter { $0.sessionID == sessionB }.count, 2)
+    }
+
+    func testLeastBusySessionIsServedFirst() {
+        var scheduler = TransferScheduler(maxConcurrentPerSession: 4, maxConcurrentTotal: 8)
+        let queued = [candidate(sessionA, bytes: 10), candidate(sessionB, bytes: 10)]
+
+        let started = scheduler.nextTransfers(queued: queued, runningBySession: [sessionA: 3])
+        XCTAssertEqual(started.first?.sessionID, sessionB)
+    }
+
+    // MARK: - Small-File Priority
+
+    func testSmallFilesStartBeforeLargeFilesWithinSession() {
+        var scheduler = TransferScheduler(maxConcurrentPerSession: 1, maxConcurrentTotal: 1, smallFileThreshold: 1024)
+        let large = candidate(sessionA, bytes: 10_000_000)
+        let small = candidate(sessionA, bytes: 100)
+
+        let started = scheduler.nextTransfers(queued: [large, small], runningBySession: [:])
+        XCTAssertEqual(started, [small])
+    }
+
+    func testLargeFilesKeepFIFOOrder() {
+        var scheduler = TransferScheduler(maxConcurrentPerSession: 2, maxConcurrentTotal: 2, smallFileThreshold: 1024)
+        let first = candidate(sessionA, bytes: 5_000_000)
+        let second = candidate(sessionA, bytes: 2_000_000)
+
+        let started = scheduler.nextTransfers(queued: [first, second], runningBySession: [:])
+        XCTAssertEqual(started, [first, second])
+    }
+}
+
+#endif // canImport(XCTest)
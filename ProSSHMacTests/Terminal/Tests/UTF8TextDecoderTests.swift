@@ -0,0 +1,90 @@
+// UTF8TextDecoderTests.swift
+// ProSSHV2
+//
+// Bulk UTF-8 decode fast path: decoder validation and grid output parity
+// with the per-byte state machine path.
+
+#if canImport(XCTest)
+import XCTest
+@testable import ProSSHMac
+
+final class UTF8TextDecoderTests: XCTestCase {
+
+    private func decodeRun(_ bytes: [UInt8], from start: Int = 0) -> (scalars: [UInt32], end: Int) {
+        var scalars: [UInt32] = []
+        let end = bytes.withUnsafeBufferPointer {
+            UTF8TextDecoder.decodePrintableRun($0, from: start, into: &scalars)
+        }
+        return (scalars, end)
+    }
+
+    // MARK: - Runs
+
+    func testDecodesMixedMultibyteAndASCIIUntilControlByte() {
+        let text = "│ cpu ███ 世界 🚀 0123456789abcdef│"
+        let (scalars, end) = decodeRun(Array((text + "\r\n").utf8))
+
+        XCTAssertEqual(scalars, text.unicodeScalars.map(\.value))
+        XCTAssertEqual(end, text.utf8.count)
+    }
+
+    func testStopsBeforeInvalidAndTruncatedSequences() {
+        // Overlong "/" (C0 AF), surrogate (ED A0 80), truncated 3-byte lead.
+        for tail: [UInt8] in [[0xC0, 0xAF], [0xED, 0xA0, 0x80], [0xE2, 0x94]] {
+            let bytes = Array("─".utf8) + tail
+            let (scalars, end) = decodeRun(bytes)
+            XCTAssertEqual(scalars, [0x2500], "tail \(tail)")
+            XCTAssertEqual(end, 3, "tail \(tail)")
+        }
+    }
+
+    func testDecodeScalarRejectsOutOfRangeLeads() {
+        let bytes: [UInt8] = [0xF4, 0x90, 0x80, 0x80]
+        let decoded = bytes.withUnsafeBufferPointer { UTF8TextDecoder.decodeScalar($0, at: 0) }
+        XCTAssertNil(decoded, "U+110000 is outside Unicode")
+    }
+}
+
+final class UTF8FastPathRenderTest: IntegrationTestBase {
+
+    // MARK: - Grid parity
+
+    func testWideCharactersWrapAtRightMarginLikePerCharacterPath() async {
+        await feed(String(repeating: "a", count: 79) + "世界")
+
+        let wrapped = await charAt(row: 1, col: 0)
+        XCTAssertEqual(wrapped, "世", "wide char at the last column wraps first")
+        let second = await charAt(row: 1, col: 2)
+        XCTAssertEqual(second, "界")
+        let attrs = await attrsAt(row: 1, col: 0)
+        XCTAssertTrue(attrs.contains(.wideChar))
+    }
+
+    func testSequenceSplitAcrossChunksStillDecodes() async {
+        let bytes = Array("├──┤".utf8)
+        await feedBytes(Array(bytes[0..<4]))
+        await feedBytes(Array(bytes[4...]))
+
+        let text = await rowText(row: 0, endCol: 4)
+        XCTAssertEqual(text, "├──┤")
+    }
+
+    func testInvalidSequenceStillPrintsReplacementCharacter() async {
+        await feedBytes(Array("─".utf8) + [0xC0, 0xAF] + Array("│".utf8))
+
+        let first = await charAt(row: 0, col: 0)
+        let replacement = await charAt(row: 0, col: 1)
+        let last = await charAt(row: 0, col: 2)
+        XCTAssertEqual(first, "─")
+        XCTAssertEqual(replacement, "\u{FFFD}")
+        XCTAssertEqual(last, "│")
+    }
+
+    func testRepeatUsesLastDecodedCharacter() async {
+        await feed("─\u{1B}[3b")
+
+        let text = await rowText(row: 0, endCol: 4)
+        XCTAssertEqual(text, "────")
+    }
+}
+#endif
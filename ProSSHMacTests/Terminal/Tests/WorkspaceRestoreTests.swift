@@ -0,0 +1,167 @@
+// WorkspaceRestoreTests.swift
+// ProSSHV2
+//
+// Lazy workspace restore: the sealed snapshot reads back, saved tabs come
+// back as dormant sessions under their old IDs with no engine, other
+// connections leave them alone, and activating one connects its host with
+// the saved screen and hands its pane to the new session.
+
+#if canImport(XCTest)
+import CryptoKit
+import XCTest
+@testable import ProSSHMac
+
+@MainActor
+final class WorkspaceRestoreTests: XCTestCase {
+
+    private let enabledKey = "terminal.workspace.lazyRestore.enabled"
+    private var directory: URL!
+    private let key = SymmetricKey(size: .bits256)
+
+    override func setUpWithError() throws {
+        directory = FileManager.default.temporaryDirectory
+            .appendingPathComponent("WorkspaceRestoreTests-\(UUID().uuidString)", isDirectory: true)
+        UserDefaults.standard.set(true, forKey: enabledKey)
+    }
+
+    override func tearDownWithError() throws {
+        UserDefaults.standard.removeObject(forKey: enabledKey)
+        try? FileManager.default.removeItem(at: directory)
+    }
+
+    // MARK: - Helpers
+
+    private func makeStore() -> WorkspaceSnapshotStore {
+        let key = key
+        return WorkspaceSnapshotStore(fileURL: directory.appendingPathComponent("workspace.snapshot")) { _ in key }
+    }
+
+    private func makeManager(store: WorkspaceSnapshotStore, host: ProSSHMac.Host) -> SessionManager {
+        let manager = SessionManager(
+            transport: MockSSHTransport(),
+            knownHostsStore: WorkspaceTestKnownHostsStore(),
+            workspaceSnapshotStore: store
+        )
+        manager.workspaceCoordinator.resolveHost = { id in id == host.id ? host : nil }
+        return manager
+    }
+
+    private func makeTab(for host: ProSSHMac.Host, text: String) -> WorkspaceSnapshot.Tab {
+        WorkspaceSnapshot.Tab(
+            id: UUID(),
+            hostID: host.id,
+            hostLabel: host.label,
+            username: host.username,
+            hostname: host.hostname,
+            port: host.port,
+            previewLines: [text],
+            screen: SessionResumeState(keyframe: Array("\u{1B}[H\u{1B}[2J\(text)".utf8), columns: 80, rows: 24, wasAlternateScreen: false)
+        )
+    }
+
+    private func makeHost() -> ProSSHMac.Host {
+        ProSSHMac.Host(
+            id: UUID(),
+            label: "Workspace Test Host",
+            folder: nil,
+            hostname: "workspace.test.local",
+            port: 22,
+            username: "ops",
+            authMethod: .password,
+            keyReference: nil,
+            certificateReference: nil,
+            passwordReference: nil,
+            jumpHost: nil,
+            algorithmPreferences: nil,
+            pinnedHostKeyAlgorithms: [],
+            agentForwardingEnabled: false,
+            legacyModeEnabled: false,
+            tags: [],
+            notes: nil,
+            lastConnected: nil,
+            createdAt: .now
+        )
+    }
+
+    // MARK: - Tests
+
+    func testSnapshotRoundTripsThroughSealedFile() async {
+        let store = makeStore()
+        let tab = makeTab(for: makeHost(), text: "ops@web1:~$ uptime")
+        store.save(WorkspaceSnapshot(tabs: [tab]))
+
+        let loaded = await store.load()
+        XCTAssertEqual(loaded?.tabs.map(\.id), [tab.id])
+        XCTAssertEqual(loaded?.tabs.first?.previewLines, ["ops@web1:~$ uptime"])
+        XCTAssertEqual(loaded?.tabs.first?.screen.keyframe, tab.screen.keyframe)
+
+        let otherKey = SymmetricKey(size: .bits256)
+        let foreign = WorkspaceSnapshotStore(fileURL: directory.appendingPathComponent("workspace.snapshot")) { _ in otherKey }
+        let unreadable = await foreign.load()
+        XCTAssertNil(unreadable)
+    }
+
+    func testRestoredTabsAreDormantUntilActivated() async throws {
+        let host = makeHost()
+        let store = makeStore()
+        let first = makeTab(for: host, text: "saved-first-screen")
+        let second = makeTab(for: host, text: "saved-second-screen")
+        store.save(WorkspaceSnapshot(tabs: [first, second]))
+
+        let manager = makeManager(store: store, host: host)
+        await manager.workspaceCoordinator.restoreIfNeeded()
+
+        XCTAssertEqual(manager.sessions.map(\.id), [first.id, second.id])
+        XCTAssertTrue(manager.sessions.allSatisfy { $0.state == .disconnected })
+        XCTAssertTrue(manager.engines.isEmpty, "Dormant tabs have no engine")
+        XCTAssertFalse(manager.workspaceCoordinator.isRestorePending)
+
+        // A manual connection to the same host keeps both tabs.
+        _ = try await manager.connect(to: host)
+        XCTAssertTrue(manager.workspaceCoordinator.isDormant(first.id))
+        XCTAssertTrue(manager.workspaceCoordinator.isDormant(second.id))
+
+        await manager.workspaceCoordinator.activate(sessionID: first.id)
+
+        let replacements = manager.takeSessionReplacements()
+        let newID = try XCTUnwrap(replacements[first.id])
+        XCTAssertFalse(manager.sessions.contains { $0.id == first.id })
+        XCTAssertEqual(manager.sessions.first { $0.id == newID }?.state, .connected)
+        XCTAssertTrue(manager.workspaceCoordinator.isDormant(second.id), "Only the activated tab connects")
+
+        let engine = try XCTUnwrap(manager.engines[newID])
+        let text = await engine.visibleText().joined(separator: "\n")
+        XCTAssertTrue(text.contains("saved-first-screen"))
+    }
+
+    func testRestoreDoesNothingWhenDisabled() async {
+        UserDefaults.standard.set(false, forKey: enabledKey)
+        let host = makeHost()
+        let store = makeStore()
+        store.save(WorkspaceSnapshot(tabs: [makeTab(for: host, text: "saved")]))
+
+        let manager = makeManager(store: store, host: host)
+        await manager.workspaceCoordinator.restoreIfNeeded()
+
+        XCTAssertTrue(manager.sessions.isEmpty)
+        XCTAssertFalse(manager.workspaceCoordinator.isRestorePending)
+    }
+}
+
+private actor WorkspaceTestKnownHostsStore: KnownHostsStoreProtocol {
+    func allEntries() async throws -> [KnownHostEntry] { [] }
+
+    func evaluate(
+        hostname: String,
+        port: UInt16,
+        hostKeyType: String,
+        presentedFingerprint: String
+    ) async throws -> KnownHostVerificationResult {
+        .trusted
+    }
+
+    func trust(challenge: KnownHostVerificationChallenge) async throws {}
+
+    func clearAll() async throws {}
+}
+#endif
@@ -0,0 +1,312 @@
+// ZModemCodecTests.swift
+// ProSSHV2
+//
+// In-band ZMODEM transfers: headers and subpackets survive the encoder and
+// decoder whatever the bytes and however reads split them, `sz` and `rz`
+// are spotted as they start, an upload reaches a receiver intact even
+// after it asks for a resend, and the terminal gets its output back once
+// a session ends.
+
+#if canImport(XCTest)
+import XCTest
+@testable import ProSSHMac
+
+final class ZModemCodecTests: XCTestCase {
+
+    // MARK: - Helpers
+
+    private func decode(_ bytes: [UInt8], readSize: Int? = nil) -> [(ZModemDecoder.Event, [UInt8])] {
+        var decoder = ZModemDecoder()
+        var events: [(ZModemDecoder.Event, [UInt8])] = []
+        var start = 0
+        while start < bytes.count {
+            let end = min(bytes.count, start + (readSize ?? bytes.count))
+            Array(bytes[start..<end]).withUnsafeBytes { read in
+                var offset = 0
+                while let event = decoder.next(in: read, at: &offset) {
+                    events.append((event, decoder.payload))
+                }
+            }
+            start = end
+        }
+        return events
+    }
+
+    private func terminalRanges(of bytes: [UInt8], through demultiplexer: InBandTransferDemultiplexer) async -> [Range<Int>]? {
+        let region = UnsafeMutableRawBufferPointer.allocate(byteCount: bytes.count, alignment: 1)
+        defer { region.deallocate() }
+        region.copyBytes(from: bytes)
+        return await demultiplexer.terminalRanges(of: UnsafeRawBufferPointer(region))
+    }
+
+    private var allBytes: [UInt8] { (0..<1024).map { UInt8(truncatingIfNeeded: $0 * 37 + 11) } + (0...255).map { UInt8($0) } }
+
+    // MARK: - Framing
+
+    func testHeadersRoundTripInEveryEncoding() {
+        let header = ZModemHeader(.rpos, position: 0x1234_5678)
+        var encoder = ZModemEncoder()
+        var bin32: [UInt8] = []
+        encoder.binaryHeader(header, into: &bin32)
+        encoder.usesCRC32 = false
+        var bin16: [UInt8] = []
+        encoder.binaryHeader(header, into: &bin16)
+
+        for bytes in [ZModemEncoder.hexHeader(header), bin32, bin16] {
+            let events = decode(bytes)
+            XCTAssertEqual(events.map(\.0), [.header(header)])
+        }
+    }
+
+    func testSubpacketsCarryAnyBytesAcrossSplitReads() {
+        for usesCRC32 in [true, false] {
+            var encoder = ZModemEncoder()
+            encoder.usesCRC32 = usesCRC32
+            var bytes: [UInt8] = []
+            encoder.binaryHeader(ZModemHeader(.data, position: 0), into: &bytes)
+            encoder.subpacket(allBytes, end: .crcG, into: &bytes)
+            encoder.subpacket([1, 2, 3], end: .crcE, into: &bytes)
+
+            let encodedData = bytes.dropFirst(3)
+            XCTAssertFalse(encodedData.contains(0x11), "XON never goes out raw")
+            XCTAssertFalse(encodedData.contains(0x13), "XOFF never goes out raw")
+
+            for readSize in [nil, 1, 7] {
+                let events = decode(bytes, readSize: readSize)
+                XCTAssertEqual(events.map(\.0), [.header(ZModemHeader(.data, position: 0)), .subpacket(.crcG), .subpacket(.crcE)])
+                XCTAssertEqual(events[1].1, allBytes)
+                XCTAssertEqual(events[2].1, [1, 2, 3])
+            }
+        }
+    }
+
+    func testDamagedSubpacketIsReportedAndHeadersResume() {
+        var encoder = ZModemEncoder()
+        var bytes: [UInt8] = []
+        encoder.binaryHeader(ZModemHeader(.data, position: 0), into: &bytes)
+        encoder.subpacket(Array("hello world".utf8), end: .crcW, into: &bytes)
+        bytes[bytes.count / 2] ^= 0x01
+        bytes += ZModemEncoder.hexHeader(ZModemHeader(.eof, position: 11))
+
+        XCTAssertEqual(decode(bytes).map(\.0), [.header(ZModemHeader(.data, position: 0)), .corrupt, .header(ZModemHeader(.eof, position: 11))])
+    }
+
+    func testFiveCancelsAbort() {
+        var encoder = ZModemEncoder()
+        var bytes: [UInt8] = []
+        encoder.binaryHeader(ZModemHeader(.data, position: 0), into: &bytes)
+        bytes += Array("partial".utf8) + ZModem.abortSequence
+
+        XCTAssertEqual(decode(bytes).last?.0, .aborted)
+    }
+
+    func testPositionsWrapPastFourGiB() {
+        let beyond: Int64 = (1 << 32) + 4096
+        let header = ZModemHeader(.ack, position: beyond)
+        XCTAssertEqual(header.argument, 4096)
+        XCTAssertEqual(header.position(near: beyond - 100), beyond)
+        XCTAssertEqual(ZModemHeader(.rpos, position: 10).position(near: 16), 10)
+    }
+
+    // MARK: - Start Detection
+
+    func testDetectorFindsSzAndRzStarting() {
+        var detector = ZModemStartDetector()
+        let sz = Array("rz\r".utf8) + ZModemEncoder.hexHeader(ZModemHeader(.rqinit))
+        let match = sz.withUnsafeBytes { detector.scan($0) }
+        XCTAssertEqual(match, ZModemStartDetector.Match(role: .receive, offset: 3, carried: []))
+
+        detector.reset()
+        let rz = Array("rz waiting to receive.".utf8) + ZModemEncoder.hexHeader(.receiverInit(capabilities: ZModem.canCRC32))
+        XCTAssertEqual(rz.withUnsafeBytes { detector.scan($0) }?.role, .send)
+
+        detector.reset()
+        let text = Array("ls -la\r\n**\u{18}ordinary output\r\n".utf8)
+        XCTAssertNil(text.withUnsafeBytes { detector.scan($0) })
+    }
+
+    func testDetectorFindsAStartSplitAcrossReads() {
+        var detector = ZModemStartDetector()
+        let header = ZModemEncoder.hexHeader(ZModemHeader(.rqinit))
+        let first = Array("$ sz file\r".utf8) + header.prefix(3)
+        XCTAssertNil(first.withUnsafeBytes { detector.scan($0) })
+
+        let second = Array(header.dropFirst(3))
+        let match = second.withUnsafeBytes { detector.scan($0) }
+        XCTAssertEqual(match, ZModemStartDetector.Match(role: .receive, offset: 0, carried: Array(header.prefix(3))))
+    }
+
+    func testRemoteFileNamesStayInTheDownloadsFolder() {
+        XCTAssertEqual(InBandTransferDemultiplexer.localName("../../etc/passwd"), "passwd")
+        XCTAssertEqual(InBandTransferDemultiplexer.localName("logs/app.log"), "app.log")
+        XCTAssertEqual(InBandTransferDemultiplexer.localName(".."), "download")
+        XCTAssertEqual(InBandTransferDemultiplexer.localName(""), "download")
+    }
+
+    // MARK: - Upload
+
+    func testUploadReachesTheReceiverIntact() async throws {
+        try await assertUpload(resendFrom: nil)
+    }
+
+    func testUploadResendsFromTheReceiversPosition() async throws {
+        try await assertUpload(resendFrom: 40_000)
+    }
+
+    private func assertUpload(resendFrom: Int?, file: StaticString = #filePath, line: UInt = #line) async throws {
+        let contents = (0..<100_000).map { UInt8(truncatingIfNeeded: $0 * 7 + $0 >> 8) }
+        let url = FileManager.default.temporaryDirectory.appendingPathComponent("zmodem-\(UUID().uuidString).bin")
+        try Data(contents).write(to: url)
+        defer { try? FileManager.default.removeItem(at: url) }
+
+        let mailbox = ZModemReplyMailbox()
+        let receiver = FakeReceiverChannel(replies: mailbox, losesDataAt: resendFrom)
+        let (events, sink) = AsyncStream<InBandTransferEvent>.makeStream()
+        var sender = ZModemSender(
+            channel: receiver,
+            receiverInit: .receiverInit(capabilities: ZModem.canFullDuplex | ZModem.canCRC32),
+            replies: mailbox,
+            events: sink
+        )
+        let finished = await sender.send([url])
+        sink.finish()
+
+        XCTAssertTrue(finished, file: file, line: line)
+        let received = await receiver.received
+        let fileName = await receiver.fileName
+        let sawOverAndOut = await receiver.sawOverAndOut
+        XCTAssertEqual(received.count, contents.count, file: file, line: line)
+        XCTAssertTrue(received == contents, "Received bytes differ", file: file, line: line)
+        XCTAssertEqual(fileName, url.lastPathComponent, file: file, line: line)
+        XCTAssertTrue(sawOverAndOut, file: file, line: line)
+
+        var failures: [String?] = []
+        for await event in events {
+            if case .fileFinished(_, let bytes, let failure) = event {
+                XCTAssertEqual(bytes, Int64(contents.count), file: file, line: line)
+                failures.append(failure)
+            }
+        }
+        XCTAssertEqual(failures, [nil], file: file, line: line)
+    }
+
+    // MARK: - Demultiplexer
+
+    func testTerminalGetsOutputBackWhenTheSessionEnds() async {
+        let channel = RecordingChannel()
+        let demultiplexer = InBandTransferDemultiplexer(channel: channel)
+
+        let plain = Array("plain output\r\n".utf8)
+        let untouched = await terminalRanges(of: plain, through: demultiplexer)
+        XCTAssertNil(untouched)
+
+        let start = Array("rz\r".utf8) + ZModemEncoder.hexHeader(ZModemHeader(.rqinit))
+        let started = await terminalRanges(of: start, through: demultiplexer)
+        XCTAssertEqual(started, [0..<3], "Only the text before the header is terminal output")
+        let sent = await channel.sent
+        XCTAssertEqual(sent.first.map { decode($0).map(\.0) }, [.header(.receiverInit(capabilities: ZModem.canFullDuplex | ZModem.canOverlapIO | ZModem.canCRC32))])
+
+        let end = ZModemEncoder.hexHeader(ZModemHeader(.fin)) + Array("OO$ ".utf8)
+        let ended = await terminalRanges(of: end, through: demultiplexer)
+        XCTAssertEqual(ended, [(end.count - 2)..<end.count], "The prompt after OO is terminal output")
+        let replies = await channel.sent
+        XCTAssertEqual(replies.last.map { decode($0).map(\.0) }, [.header(ZModemHeader(.fin))])
+    }
+}
+
+// MARK: - Test Doubles
+
+private actor RecordingChannel: SSHShellChannel {
+    nonisolated let rawOutput = AsyncStream<Data> { _ in }
+    private(set) var sent: [[UInt8]] = []
+
+    func send(_ input: String) async throws {
+        sent.append(Array(input.utf8))
+    }
+
+    func send(bytes: [UInt8]) async throws {
+        sent.append(bytes)
+    }
+
+    func resizePTY(columns: Int, rows: Int) async throws {}
+
+    func close() async {}
+}
+
+/// Plays `rz`: decodes what the sender writes and posts the answers. With
+/// `losesDataAt`, it drops the data past that point once and asks for a
+/// resend from there.
+private actor FakeReceiverChannel: SSHShellChannel {
+    nonisolated let rawOutput = AsyncStream<Data> { _ in }
+    private let replies: ZModemReplyMailbox
+    private var losesDataAt: Int?
+    private var decoder = ZModemDecoder()
+    private var frame: ZModem.FrameType?
+    private var discarding = false
+    private(set) var received: [UInt8] = []
+    private(set) var fileName: String?
+    private(set) var sawOverAndOut = false
+
+    init(replies: ZModemReplyMailbox, losesDataAt: Int?) {
+        self.replies = replies
+        self.losesDataAt = losesDataAt
+    }
+
+    func send(_ input: String) async throws {
+        try await send(bytes: Array(input.utf8))
+    }
+
+    func send(bytes: [UInt8]) async throws {
+        if bytes == ZModem.overAndOut {
+            sawOverAndOut = true
+            return
+        }
+        bytes.withUnsafeBytes { buffer in
+            var offset = 0
+            while let event = decoder.next(in: buffer, at: &offset) {
+                handle(event)
+            }
+        }
+    }
+
+    private func handle(_ event: ZModemDecoder.Event) {
+        switch event {
+        case .header(let header):
+            frame = header.type
+            switch header.type {
+            case .data:
+                discarding = header.position(near: Int64(received.count)) != Int64(received.count)
+            case .eof:
+                replies.post(.header(.receiverInit(capabilities: ZModem.canCRC32)))
+            case .fin:
+                replies.post(.header(ZModemHeader(.fin)))
+            default:
+                break
+            }
+        case .subpacket(let end):
+            if frame == .file {
+                fileName = String(decoding: decoder.payload.prefix { $0 != 0 }, as: UTF8.self)
+                replies.post(.header(ZModemHeader(.rpos, position: 0)))
+                return
+            }
+            guard !discarding else { return }
+            if let lossPoint = losesDataAt, received.count + decoder.payload.count > lossPoint {
+                losesDataAt = nil
+                discarding = true
+                replies.post(.header(ZModemHeader(.rpos, position: Int64(received.count))))
+                return
+            }
+            received += decoder.payload
+            if end.wantsAck {
+                replies.post(.header(ZModemHeader(.ack, position: Int64(received.count))))
+            }
+        case .corrupt, .aborted:
+            replies.close()
+        }
+    }
+
+    func resizePTY(columns: Int, rows: Int) async throws {}
+
+    func close() async {}
+}
+#endif
@@ -0,0 +1,72 @@
+#!/bin/bash
+#
+# benchmark-regression.sh
+#
+# Builds ProSSHMac and its tests in Release and runs the performance
+# regression gates (PerformanceRegressionTests) through the
+# ProSSHMacBenchmarks scheme. Each benchmark fails when its median is more
+# than 10% slower than the baseline recorded for this machine class in
+# ProSSHMacTests/Terminal/Tests/PerformanceBaselines.json.
+#
+# Usage:
+#   ./scripts/benchmark-regression.sh [--record] [--only <testName>]
+#
+# Examples:
+#   ./scripts/benchmark-regression.sh
+#   ./scripts/benchmark-regression.sh --record
+#   ./scripts/benchmark-regression.sh --only testParserBase64Flood
+
+set -euo pipefail
+
+SCRIPT_DIR="$(cd "$(dirname "$0")" && pwd)"
+PROJECT_DIR="$(cd "$SCRIPT_DIR/.." && pwd)"
+SCHEME="ProSSHMacBenchmarks"
+RECORD=0
+ONLY=()
+
+while [[ $# -gt 0 ]]; do
+    case "$1" in
+        --record)
+            RECORD=1
+            shift
+            ;;
+        --only)
+            ONLY+=("-only-testing:ProSSHMacTests/PerformanceRegressionTests/$2")
+            shift 2
+            ;;
+        *)
+            echo "Unknown argument: $1"
+            exit 1
+            ;;
+    esac
+done
+
+echo "==> ProSSHMac Performance Regression Gates"
+echo ""
+
+if [[ "$RECORD" -eq 1 ]]; then
+    echo "    Recording baselines for this machine class"
+    # xcodebuild forwards TEST_RUNNER_-prefixed variables to the test process.
+    export TEST_RUNNER_PROSSH_RECORD_BASELINES=1
+fi
+
+# @testable import needs testability, which the Release configuration leaves
+# off for shipping builds; enable it for this build only.
+set +e
+xcodebuild \
+    -project "$PROJECT_DIR/ProSSHMac.xcodeproj" \
+    -scheme "$SCHEME" \
+    -configuration Release \
+    -destination 'platform=macOS' \
+    ENABLE_TESTABILITY=YES \
+    ${ONLY[@]+"${ONLY[@]}"} \
+    test \
+    2>&1 | grep -E "regressed|recorded|baseline|measured|error:|Test Suite|Test Case.*(passed|failed|skipped)|\*\* TEST"
+STATUS=${PIPESTATUS[0]}
+set -e
+
+if [[ "$RECORD" -eq 1 && "$STATUS" -eq 0 ]]; then
+    echo ""
+    echo "==> Baselines written to ProSSHMacTests/Terminal/Tests/PerformanceBaselines.json"
+fi
+exit "$STATUS"
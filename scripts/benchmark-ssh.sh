@@ -94,4 +94,6 @@ echo ""
 echo "NOTE: This is raw SSH transport throughput (no terminal emulation)."
 echo "      Compare against in-app benchmark to measure pipeline overhead:"
 echo "      ./scripts/benchmark-throughput.sh --pty-local"
+echo "      For the same host through ProSSHMac's own SSH stack, with an OpenSSH column:"
+echo "      ./scripts/benchmark-throughput.sh --ssh --benchmark-host $HOST"
 echo ""
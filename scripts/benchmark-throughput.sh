@@ -5,12 +5,15 @@
 # Builds ProSSHMac (Debug) and runs the in-app throughput benchmark mode.
 #
 # Usage:
-#   ./scripts/benchmark-throughput.sh [--no-build] [--pty-local] [benchmark args...]
+#   ./scripts/benchmark-throughput.sh [--no-build] [--pty-local | --corpus | --ssh] [benchmark args...]
 #
 # Examples:
 #   ./scripts/benchmark-throughput.sh
 #   ./scripts/benchmark-throughput.sh --benchmark-bytes 33554432 --benchmark-runs 5
 #   ./scripts/benchmark-throughput.sh --pty-local --no-build
+#   ./scripts/benchmark-throughput.sh --corpus --benchmark-sizes 80x24,240x70
+#   ./scripts/benchmark-throughput.sh --corpus --benchmark-corpus-dir ~/Recordings
+#   ./scripts/benchmark-throughput.sh --ssh --benchmark-host myserver --benchmark-workloads base64,htop
 
 set -euo pipefail
 
@@ -20,6 +23,8 @@ SCHEME="ProSSHMac"
 APP_NAME="ProSSHMac"
 NO_BUILD=0
 PTY_LOCAL=0
+CORPUS=0
+SSH=0
 EXTRA_ARGS=()
 
 while [[ $# -gt 0 ]]; do
@@ -32,6 +37,14 @@ while [[ $# -gt 0 ]]; do
             PTY_LOCAL=1
             shift
             ;;
+        --corpus)
+            CORPUS=1
+            shift
+            ;;
+        --ssh)
+            SSH=1
+            shift
+            ;;
         *)
             EXTRA_ARGS+=("$1")
             shift
@@ -74,6 +87,18 @@ if [[ "$PTY_LOCAL" -eq 1 ]]; then
     else
         "$APP_PATH/Contents/MacOS/$APP_NAME" --benchmark-pty-local
     fi
+elif [[ "$CORPUS" -eq 1 ]]; then
+    if [[ ${#EXTRA_ARGS[@]} -gt 0 ]]; then
+        "$APP_PATH/Contents/MacOS/$APP_NAME" --benchmark-corpus "${EXTRA_ARGS[@]}"
+    else
+        "$APP_PATH/Contents/MacOS/$APP_NAME" --benchmark-corpus
+    fi
+elif [[ "$SSH" -eq 1 ]]; then
+    if [[ ${#EXTRA_ARGS[@]} -gt 0 ]]; then
+        "$APP_PATH/Contents/MacOS/$APP_NAME" --benchmark-ssh "${EXTRA_ARGS[@]}"
+    else
+        "$APP_PATH/Contents/MacOS/$APP_NAME" --benchmark-ssh
+    fi
 else
     if [[ ${#EXTRA_ARGS[@]} -gt 0 ]]; then
         "$APP_PATH/Contents/MacOS/$APP_NAME" --benchmark-base64 "${EXTRA_ARGS[@]}"